@@ -0,0 +1,192 @@
+// SHURIUM - Active Chain Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Cost of the Chain height index on a large synthetic header chain with a
+// side branch forking off near the tip:
+//   settip/extend          SetTip one block at a time from genesis
+//   settip/reorg/<depth>   SetTip back and forth across a fork <depth> deep
+//   findfork/<depth>       FindFork of the side branch's tip
+//   contains               Contains() of random main-chain entries
+//   next                   Next() walking the chain from genesis to tip
+//   getancestor            GetAncestor() between random heights, through
+//                          the skip list
+//   getancestor/pprev      the same lookups walking pprev, for comparison
+// The chain's index size is reported after it is built.
+//
+// Output is JSON lines like the other suites.
+//
+// Usage: shurium_bench_chain [--filter=SUBSTRING] [--min-time=SECONDS]
+//                            [--headers=N]
+
+#include "shurium/chain/blockindex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace shurium;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+
+bool Selected(const std::string& name) {
+    return !g_filter || name.find(g_filter) != std::string::npos;
+}
+
+/// Run body (which performs opsPerCall operations) until g_minSeconds pass
+template<typename Body>
+void Run(const std::string& name, uint64_t opsPerCall, Body body) {
+    if (!Selected(name)) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t ops = 0;
+    double elapsed = 0;
+    do {
+        auto start = Clock::now();
+        body();
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        ops += opsPerCall;
+    } while (elapsed < g_minSeconds);
+
+    std::printf("{\"name\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.1f}\n",
+                name.c_str(), static_cast<unsigned long long>(ops), elapsed * 1e9 / ops);
+    std::fflush(stdout);
+}
+
+/// Append count entries on top of parent (nullptr: start a new chain)
+std::vector<BlockIndex*> Grow(BlockIndexArena& arena, BlockIndex* parent, int count) {
+    std::vector<BlockIndex*> entries;
+    entries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        BlockIndex* pindex = arena.Allocate();
+        pindex->pprev = parent;
+        pindex->nHeight = parent ? parent->nHeight + 1 : 0;
+        pindex->BuildSkip();
+        entries.push_back(pindex);
+        parent = pindex;
+    }
+    return entries;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    int headers = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else if (std::strncmp(argv[i], "--headers=", 10) == 0) {
+            headers = std::atoi(argv[i] + 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS] "
+                         "[--headers=N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (headers < 20000) {
+        std::fprintf(stderr, "--headers must be at least 20000\n");
+        return 1;
+    }
+
+    std::printf("{\"suite\":\"chain\",\"headers\":%d}\n", headers);
+
+    BlockIndexArena arena;
+    arena.Reserve(static_cast<size_t>(headers) + 20000);
+    std::vector<BlockIndex*> main = Grow(arena, nullptr, headers);
+    BlockIndex* mainTip = main.back();
+
+    Chain chain;
+    Run("settip/extend", headers, [&] {
+        chain.Clear();
+        for (BlockIndex* pindex : main) {
+            chain.SetTip(pindex);
+        }
+    });
+    chain.SetTip(mainTip);
+    std::printf("{\"name\":\"index\",\"height\":%d,\"bytes\":%zu}\n",
+                chain.Height(), chain.DynamicMemoryUsage());
+    std::fflush(stdout);
+
+    for (int depth : {10, 1000, 10000}) {
+        // A side branch one block longer than the main chain above the fork
+        BlockIndex* forkPoint = main[headers - 1 - depth];
+        BlockIndex* sideTip = Grow(arena, forkPoint, depth + 1).back();
+        std::string suffix = "/" + std::to_string(depth);
+
+        Run("settip/reorg" + suffix, 2, [&] {
+            chain.SetTip(sideTip);
+            chain.SetTip(mainTip);
+        });
+        if (chain.FindFork(sideTip) != forkPoint) {
+            std::fprintf(stderr, "FindFork returned the wrong block at depth %d\n", depth);
+            return 1;
+        }
+
+        volatile const BlockIndex* sink = nullptr;
+        Run("findfork" + suffix, 1000, [&] {
+            for (int i = 0; i < 1000; ++i) {
+                sink = chain.FindFork(sideTip);
+            }
+        });
+        (void)sink;
+    }
+
+    std::mt19937 rng(42);
+    std::vector<BlockIndex*> probes(1 << 16);
+    for (auto& probe : probes) {
+        probe = main[rng() % headers];
+    }
+    volatile size_t found = 0;
+    Run("contains", probes.size(), [&] {
+        size_t hits = 0;
+        for (const BlockIndex* probe : probes) {
+            hits += chain.Contains(probe);
+        }
+        found = found + hits;
+    });
+
+    Run("next", headers, [&] {
+        size_t steps = 0;
+        for (const BlockIndex* pindex = chain.Genesis(); pindex; pindex = chain.Next(pindex)) {
+            ++steps;
+        }
+        found = found + steps;
+    });
+
+    std::vector<std::pair<BlockIndex*, int>> lookups(200);
+    for (auto& [from, to] : lookups) {
+        int height = static_cast<int>(rng() % headers);
+        from = main[height];
+        to = static_cast<int>(rng() % (height + 1));
+    }
+    Run("getancestor", lookups.size(), [&] {
+        size_t heights = 0;
+        for (const auto& [from, to] : lookups) {
+            heights += from->GetAncestor(to)->nHeight;
+        }
+        found = found + heights;
+    });
+    Run("getancestor/pprev", lookups.size(), [&] {
+        size_t heights = 0;
+        for (const auto& [from, to] : lookups) {
+            const BlockIndex* pindex = from;
+            while (pindex->nHeight > to) {
+                pindex = pindex->pprev;
+            }
+            heights += pindex->nHeight;
+        }
+        found = found + heights;
+    });
+    return 0;
+}
@@ -0,0 +1,187 @@
+// SHURIUM - Coin Selection Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Runs BranchAndBound::Select over synthetic wallets of 100k UTXOs and
+// reports the time per selection together with the search statistics of
+// the result. The wallets are:
+//   similar  values within a few hundred satoshis of each other, with many
+//            exact duplicates (exchange and pool payout wallets)
+//   spread   values spread log-uniformly from 1k to 10M satoshis
+//   nomatch  the similar wallet with a target no selection hits within the
+//            cost of change, so every run spends its whole budget
+// Candidates are sorted once up front, as the wallet hands them over.
+//
+// Output is JSON lines like the other suites.
+//
+// Usage: shurium_bench_coinselection [--filter=SUBSTRING] [--min-time=SECONDS]
+//                                    [--iterations=N] [--time-budget-us=N]
+
+#include "shurium/wallet/coinselection.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace shurium;
+using namespace shurium::wallet;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+size_t g_maxIterations = BranchAndBound::MAX_ITERATIONS;
+int64_t g_timeBudgetUs = 0;
+
+/// UTXOs per wallet
+constexpr size_t UTXOS = 100000;
+
+/// Distinct targets per wallet, cycled through by the timed runs
+constexpr size_t TARGETS = 16;
+
+struct Wallet {
+    std::string name;
+    std::vector<OutputGroup> outputs;
+    std::vector<Amount> targets;
+};
+
+/// A P2WPKH output of the given value; the outpoint only has to be distinct
+OutputGroup MakeOutput(uint32_t n, Amount value) {
+    TxHash hash;
+    for (int i = 0; i < 4; ++i) {
+        hash[i] = static_cast<uint8_t>(n >> (8 * i));
+    }
+    Script script;
+    script.push_back(0x00);
+    script.push_back(0x14);
+    for (int i = 0; i < 20; ++i) {
+        script.push_back(0);
+    }
+    return OutputGroup(OutPoint(hash, 0), TxOut(value, script), 1, 6);
+}
+
+/// Targets that are sums of a few of the wallet's own outputs, so a
+/// changeless selection exists
+std::vector<Amount> ReachableTargets(const std::vector<OutputGroup>& outputs,
+                                     std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> pick(0, outputs.size() - 1);
+    std::uniform_int_distribution<int> count(2, 6);
+    std::vector<Amount> targets;
+    for (size_t t = 0; t < TARGETS; ++t) {
+        Amount target = 0;
+        for (int i = count(rng); i > 0; --i) {
+            target += outputs[pick(rng)].effectiveValue;
+        }
+        targets.push_back(target);
+    }
+    return targets;
+}
+
+std::vector<Wallet> BuildWallets() {
+    std::mt19937_64 rng(0x5eed);
+    std::vector<Wallet> wallets;
+
+    Wallet similar;
+    similar.name = "similar";
+    std::uniform_int_distribution<Amount> near(100000, 100300);
+    for (size_t i = 0; i < UTXOS; ++i) {
+        similar.outputs.push_back(MakeOutput(static_cast<uint32_t>(i), near(rng)));
+    }
+
+    Wallet spread;
+    spread.name = "spread";
+    std::uniform_real_distribution<double> exponent(3.0, 7.0);
+    for (size_t i = 0; i < UTXOS; ++i) {
+        Amount value = static_cast<Amount>(std::pow(10.0, exponent(rng)));
+        spread.outputs.push_back(MakeOutput(static_cast<uint32_t>(i), value));
+    }
+
+    for (Wallet* w : {&similar, &spread}) {
+        SortByValue(w->outputs, false);
+        w->targets = ReachableTargets(w->outputs, rng);
+    }
+
+    // Every value of the similar wallet lies in [99932, 100232] after the
+    // input fee; halfway between five and six of them is out of reach
+    Wallet nomatch;
+    nomatch.name = "nomatch";
+    nomatch.outputs = similar.outputs;
+    nomatch.targets.assign(TARGETS, 5 * 100232 + 40000);
+
+    wallets.push_back(std::move(similar));
+    wallets.push_back(std::move(spread));
+    wallets.push_back(std::move(nomatch));
+    return wallets;
+}
+
+/// Time selections over wallet for at least the minimum time and print a line
+void Run(const Wallet& wallet) {
+    std::string name = "bnb/" + wallet.name;
+    if (g_filter && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    SelectionParams params;
+    params.bnbMaxIterations = g_maxIterations;
+    params.bnbTimeBudgetUs = g_timeBudgetUs;
+
+    uint64_t runs = 0;
+    uint64_t successes = 0;
+    uint64_t exhausted = 0;
+    uint64_t iterations = 0;
+    int64_t searchUs = 0;
+    double elapsed = 0;
+    do {
+        params.targetValue = wallet.targets[runs % wallet.targets.size()];
+        auto start = Clock::now();
+        SelectionResult result = BranchAndBound::Select(wallet.outputs, params);
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        ++runs;
+        successes += result.success ? 1 : 0;
+        exhausted += result.searchExhausted ? 1 : 0;
+        iterations += result.iterations;
+        searchUs += result.searchTimeUs;
+    } while (elapsed < g_minSeconds);
+
+    double n = static_cast<double>(runs);
+    std::printf("{\"name\":\"%s\",\"utxos\":%zu,\"runs\":%llu,\"us_per_select\":%.1f,"
+                "\"search_us_per_select\":%.1f,\"iterations_per_select\":%.1f,"
+                "\"success_rate\":%.3f,\"exhausted_rate\":%.3f}\n",
+                name.c_str(), wallet.outputs.size(), static_cast<unsigned long long>(runs),
+                elapsed * 1e6 / n, searchUs / n, iterations / n, successes / n, exhausted / n);
+    std::fflush(stdout);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else if (std::strncmp(argv[i], "--iterations=", 13) == 0) {
+            g_maxIterations = std::strtoull(argv[i] + 13, nullptr, 10);
+        } else if (std::strncmp(argv[i], "--time-budget-us=", 17) == 0) {
+            g_timeBudgetUs = std::atoll(argv[i] + 17);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS] "
+                         "[--iterations=N] [--time-budget-us=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"coinselection\",\"max_iterations\":%zu,\"time_budget_us\":%lld}\n",
+                g_maxIterations, static_cast<long long>(g_timeBudgetUs));
+
+    for (const Wallet& wallet : BuildWallets()) {
+        Run(wallet);
+    }
+    return 0;
+}
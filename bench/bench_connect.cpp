@@ -0,0 +1,603 @@
+// SHURIUM - Block Connection Replay Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Generates a synthetic regtest chain and replays it against an on-disk
+// CoinsViewDB and BlockDB in a temporary directory, the way a node connects
+// blocks during initial block download. Each block goes through the header
+// index, consensus::CheckBlock, the block files and ChainState::ConnectBlock
+// (scripts on the script check queue, coins spent and created in the cache),
+// with its undo data written after. Every signature is real and verified
+// unless --assumevalid is given.
+//
+// ChainStateManager::ProcessNewBlock is not used for the replay: extending
+// the tip through it only advances the chain pointer, so none of the
+// validation work would be measured.
+//
+// Transactions spend the oldest unspent outputs first, so inputs come from
+// the database once the coins cache has been flushed. The mix per block:
+//   transfer  --inputs=K inputs to --outputs=M outputs, most paying to
+//             P2PKH and some to 2-of-3 multisig in P2SH
+//   claim     one input to P2PKH plus an 80-byte OP_RETURN, the footprint
+//             of a UBI claim carried in a transaction
+//   stake     one input to a CHECKLOCKTIMEVERIFY-locked P2SH output and
+//             P2PKH change, the shape of a stake lock and its later spend
+//
+// The funding block and the 100 blocks needed for it to mature are
+// connected before timing starts. Output is JSON lines like the other
+// suites: the parameters, then connect (blocks/s, txs/s, inputs/s and
+// per-block latency), flush (writing the coins cache and block files out)
+// and memory (peak RSS of the process, generation included).
+//
+// With --reorg, a branch carrying the same transactions under different
+// coinbases, one block longer, then replaces the measured blocks through
+// ChainStateManager::ActivateBestChain's batched Reorganize: reorganize
+// reports its blocks/s and load, apply and flush phase times.
+//
+// Usage: shurium_bench_connect [--blocks=N] [--txs=N] [--inputs=N] [--outputs=N]
+//                              [--dbcache=MB] [--par=N] [--assumevalid] [--reorg]
+
+#include "shurium/chain/chainstate.h"
+#include "shurium/chain/checkqueue.h"
+#include "shurium/consensus/params.h"
+#include "shurium/consensus/validation.h"
+#include "shurium/core/block.h"
+#include "shurium/core/random.h"
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/crypto/keys.h"
+#include "shurium/crypto/ripemd160.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/db/blockdb.h"
+#include "shurium/db/utxodb.h"
+#include "shurium/script/interpreter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace shurium;
+
+namespace {
+
+/// Blocks a coinbase output waits before it can be spent
+constexpr int MATURITY = 100;
+
+/// Distinct keys outputs pay to
+constexpr uint32_t NUM_KEYS = 256;
+
+constexpr Amount FUNDING_AMOUNT = 10 * COIN;
+constexpr Amount FEE = 1000;
+constexpr size_t CLAIM_PAYLOAD = 80;
+
+struct Config {
+    int blocks{200};
+    int txs{200};
+    int inputs{2};
+    int outputs{2};
+    int dbcacheMB{64};
+    int par{0};
+    bool assumeValid{false};
+    bool reorg{false};
+};
+
+enum class Lock { P2PKH, MULTISIG, STAKE };
+
+/// An output the generator can spend, and how to unlock it
+struct Spendable {
+    OutPoint outpoint;
+    Amount value;
+    Lock lock;
+    uint32_t key;
+    int height;
+};
+
+KeyPair DeriveKey(uint32_t i) {
+    uint8_t seed[9] = {'c', 'o', 'n', 'n', 'e', 'c', 't',
+                       static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+    Hash256 secret = SHA256Hash(seed, sizeof(seed));
+    return KeyPair(PrivateKey(secret.data()));
+}
+
+/// Builds the chain block by block, tracking what each output needs to be spent
+class ChainGenerator {
+public:
+    explicit ChainGenerator(const Config& config) : config_(config), rng_(20240101) {
+        for (uint32_t i = 0; i < NUM_KEYS; ++i) {
+            keys_.push_back(DeriveKey(i));
+            pubkeys_.push_back(keys_.back().GetPublicKey().ToVector());
+        }
+    }
+
+    /// Coinbase-only block; the first one funds every later transaction
+    Block MakeBlock(int height, size_t fundingOutputs = 0) {
+        std::vector<TransactionRef> txs;
+        MutableTransaction coinbase = Coinbase(height);
+        std::vector<Spendable> funding;
+        if (fundingOutputs > 0) {
+            coinbase.vout.clear();
+            for (size_t i = 0; i < fundingOutputs; ++i) {
+                AddOutput(coinbase, FUNDING_AMOUNT, Lock::P2PKH, height, funding);
+            }
+        }
+        TransactionRef coinbaseRef = MakeTransactionRef(std::move(coinbase));
+        for (Spendable& coin : funding) {
+            coin.outpoint = OutPoint(coinbaseRef->GetHash(), coin.outpoint.n);
+        }
+        pool_.insert(pool_.end(), funding.begin(), funding.end());
+        txs.push_back(std::move(coinbaseRef));
+        return Seal(height, std::move(txs));
+    }
+
+    /// Block of config.txs transactions spending earlier outputs
+    Block MakeSpendingBlock(int height) {
+        std::vector<TransactionRef> txs;
+        txs.push_back(MakeTransactionRef(Coinbase(height)));
+        std::vector<Spendable> created;
+        for (int i = 0; i < config_.txs && !pool_.empty(); ++i) {
+            uint64_t kind = rng_.RandRange(20);
+            if (kind < 2) {
+                txs.push_back(MakeClaim(height, created));
+            } else if (kind < 4) {
+                txs.push_back(MakeStake(height, created));
+            } else {
+                txs.push_back(MakeTransfer(height, created));
+            }
+        }
+        pool_.insert(pool_.end(), created.begin(), created.end());
+        return Seal(height, std::move(txs));
+    }
+
+    /// Copy of block on top of the last one made, under a different
+    /// coinbase, so a branch can carry the same transactions
+    Block MakeForkedBlock(const Block& block, int height) {
+        MutableTransaction coinbase(*block.vtx[0]);
+        coinbase.vin[0].scriptSig << static_cast<int64_t>(1);
+        std::vector<TransactionRef> txs = block.vtx;
+        txs[0] = MakeTransactionRef(std::move(coinbase));
+        return Seal(height, std::move(txs));
+    }
+
+    /// Build the next block on top of prev
+    void SetPrevious(const BlockHash& prev) { prevHash_ = prev; }
+
+    uint64_t GetInputs() const { return inputs_; }
+
+private:
+    uint32_t Next() {
+        nextKey_ = (nextKey_ + 1) % NUM_KEYS;
+        return nextKey_;
+    }
+
+    MutableTransaction Coinbase(int height) {
+        MutableTransaction coinbase;
+        coinbase.vin.push_back(TxIn(OutPoint()));
+        coinbase.vin[0].scriptSig << static_cast<int64_t>(height) << static_cast<int64_t>(0);
+        coinbase.vout.emplace_back(50 * COIN, LockingScript(Lock::P2PKH, Next(), 0));
+        return coinbase;
+    }
+
+    Script MultisigScript(uint32_t key) const {
+        Script redeem;
+        redeem << OP_2 << pubkeys_[key] << pubkeys_[(key + 1) % NUM_KEYS]
+               << pubkeys_[(key + 2) % NUM_KEYS] << OP_3 << OP_CHECKMULTISIG;
+        return redeem;
+    }
+
+    Script StakeScript(uint32_t key, int height) const {
+        Script redeem;
+        redeem << ScriptNum(height) << OP_CHECKLOCKTIMEVERIFY << OP_DROP << pubkeys_[key]
+               << OP_CHECKSIG;
+        return redeem;
+    }
+
+    /// Script a signature commits to (the redeem script for P2SH)
+    Script ScriptCode(const Spendable& coin) const {
+        switch (coin.lock) {
+            case Lock::P2PKH:    return LockingScript(Lock::P2PKH, coin.key, 0);
+            case Lock::MULTISIG: return MultisigScript(coin.key);
+            case Lock::STAKE:    return StakeScript(coin.key, coin.height);
+        }
+        return Script();
+    }
+
+    Script LockingScript(Lock lock, uint32_t key, int height) const {
+        Script redeem;
+        switch (lock) {
+            case Lock::P2PKH:
+                return Script::CreateP2PKH(keys_[key].GetPublicKey().GetHash160());
+            case Lock::MULTISIG:
+                redeem = MultisigScript(key);
+                break;
+            case Lock::STAKE:
+                redeem = StakeScript(key, height);
+                break;
+        }
+        return Script::CreateP2SH(Hash160FromData(redeem.data(), redeem.size()));
+    }
+
+    std::vector<Spendable> TakeInputs(size_t count) {
+        std::vector<Spendable> coins;
+        while (coins.size() < count && !pool_.empty()) {
+            coins.push_back(pool_.front());
+            pool_.pop_front();
+        }
+        inputs_ += coins.size();
+        return coins;
+    }
+
+    void AddOutput(MutableTransaction& mtx, Amount value, Lock lock, int height,
+                   std::vector<Spendable>& spendable) {
+        uint32_t key = Next();
+        mtx.vout.emplace_back(value, LockingScript(lock, key, height));
+        spendable.push_back({OutPoint(TxHash(), static_cast<uint32_t>(mtx.vout.size() - 1)),
+                             value, lock, key, height});
+    }
+
+    /// Sign every input; locktime and sequence let stake outputs be spent
+    TransactionRef Sign(MutableTransaction& mtx, const std::vector<Spendable>& coins,
+                        std::vector<Spendable>& created, size_t firstCreated) {
+        Transaction unsignedTx(mtx);
+        for (size_t i = 0; i < coins.size(); ++i) {
+            const Spendable& coin = coins[i];
+            Script scriptCode = ScriptCode(coin);
+            Hash256 sighash = SignatureHash(unsignedTx, static_cast<unsigned int>(i), scriptCode,
+                                            SIGHASH_ALL);
+            auto sign = [&](uint32_t key) {
+                std::vector<uint8_t> signature = keys_[key].Sign(sighash);
+                signature.push_back(SIGHASH_ALL);
+                return signature;
+            };
+            Script scriptSig;
+            switch (coin.lock) {
+                case Lock::P2PKH:
+                    scriptSig << sign(coin.key) << pubkeys_[coin.key];
+                    break;
+                case Lock::MULTISIG:
+                    scriptSig << OP_0 << sign(coin.key) << sign((coin.key + 2) % NUM_KEYS);
+                    break;
+                case Lock::STAKE:
+                    scriptSig << sign(coin.key);
+                    break;
+            }
+            if (coin.lock != Lock::P2PKH) {
+                scriptSig << std::vector<uint8_t>(scriptCode.begin(), scriptCode.end());
+            }
+            mtx.vin[i].scriptSig = std::move(scriptSig);
+        }
+        TransactionRef tx = MakeTransactionRef(std::move(mtx));
+        for (size_t i = firstCreated; i < created.size(); ++i) {
+            created[i].outpoint = OutPoint(tx->GetHash(), created[i].outpoint.n);
+        }
+        return tx;
+    }
+
+    MutableTransaction Spend(const std::vector<Spendable>& coins, int height) {
+        MutableTransaction mtx;
+        mtx.version = 2;
+        mtx.nLockTime = static_cast<uint32_t>(height - 1);
+        for (const Spendable& coin : coins) {
+            mtx.vin.emplace_back(coin.outpoint, Script(), TxIn::MAX_SEQUENCE_NONFINAL);
+        }
+        return mtx;
+    }
+
+    static Amount Total(const std::vector<Spendable>& coins) {
+        Amount total = 0;
+        for (const Spendable& coin : coins) {
+            total += coin.value;
+        }
+        return total > FEE ? total - FEE : total;
+    }
+
+    TransactionRef MakeTransfer(int height, std::vector<Spendable>& created) {
+        std::vector<Spendable> coins = TakeInputs(static_cast<size_t>(config_.inputs));
+        MutableTransaction mtx = Spend(coins, height);
+        Amount total = Total(coins);
+        size_t nOutputs = std::max<size_t>(1, std::min<size_t>(config_.outputs, total));
+        size_t first = created.size();
+        for (size_t i = 0; i < nOutputs; ++i) {
+            Amount value = total / nOutputs + (i == 0 ? total % nOutputs : 0);
+            AddOutput(mtx, value, rng_.RandRange(100) < 15 ? Lock::MULTISIG : Lock::P2PKH,
+                      height, created);
+        }
+        return Sign(mtx, coins, created, first);
+    }
+
+    TransactionRef MakeClaim(int height, std::vector<Spendable>& created) {
+        std::vector<Spendable> coins = TakeInputs(1);
+        MutableTransaction mtx = Spend(coins, height);
+        size_t first = created.size();
+        AddOutput(mtx, Total(coins), Lock::P2PKH, height, created);
+        std::vector<uint8_t> payload(CLAIM_PAYLOAD);
+        for (uint8_t& b : payload) {
+            b = static_cast<uint8_t>(rng_.Rand32());
+        }
+        mtx.vout.emplace_back(0, Script::CreateOpReturn(payload));
+        return Sign(mtx, coins, created, first);
+    }
+
+    TransactionRef MakeStake(int height, std::vector<Spendable>& created) {
+        std::vector<Spendable> coins = TakeInputs(1);
+        MutableTransaction mtx = Spend(coins, height);
+        Amount total = Total(coins);
+        size_t first = created.size();
+        AddOutput(mtx, total - total / 10, Lock::STAKE, height, created);
+        AddOutput(mtx, total / 10, Lock::P2PKH, height, created);
+        return Sign(mtx, coins, created, first);
+    }
+
+    Block Seal(int height, std::vector<TransactionRef> txs) {
+        Block block;
+        block.nVersion = 1;
+        block.hashPrevBlock = prevHash_;
+        block.nTime = 1700000000 + height * 30;
+        block.nBits = 0x207fffff;
+        block.vtx = std::move(txs);
+        block.hashMerkleRoot = block.ComputeMerkleRoot();
+        while (!consensus::CheckProofOfWork(block.GetHash(), block.nBits, params_)) {
+            ++block.nNonce;
+        }
+        prevHash_ = block.GetHash();
+        return block;
+    }
+
+    const Config& config_;
+    consensus::Params params_ = consensus::Params::RegTest();
+    FastRandomContext rng_;
+    std::vector<KeyPair> keys_;
+    std::vector<std::vector<uint8_t>> pubkeys_;
+    uint32_t nextKey_{0};
+    std::deque<Spendable> pool_;
+    BlockHash prevHash_;
+    uint64_t inputs_{0};
+};
+
+double Seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+double PeakRSSMegabytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;  // kilobytes on Linux
+}
+
+/// Index, check and store one block, recording where it went in the index
+BlockIndex* StoreBlock(ChainStateManager& manager, db::BlockDB& blockDB, const Block& block) {
+    BlockIndex* pindex = manager.ProcessBlockHeader(block.GetBlockHeader());
+    consensus::ValidationState state;
+    if (!pindex || !consensus::CheckBlock(block, state, manager.GetParams())) {
+        return nullptr;
+    }
+    db::DiskBlockPos blockPos;
+    if (!blockDB.WriteBlock(block, blockPos, pindex->nHeight).ok()) {
+        return nullptr;
+    }
+    pindex->nFile = blockPos.nFile;
+    pindex->nDataPos = blockPos.nPos;
+    pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_DATA;
+    pindex->nTx = static_cast<uint32_t>(block.vtx.size());
+    pindex->RaiseValidity(BlockStatus::VALID_TRANSACTIONS);
+    return pindex;
+}
+
+/// Store and connect one block on top of the active tip, then its undo data
+bool ConnectNext(ChainStateManager& manager, db::BlockDB& blockDB, const Block& block) {
+    BlockIndex* pindex = StoreBlock(manager, blockDB, block);
+    if (!pindex) {
+        return false;
+    }
+    BlockUndo undo;
+    if (manager.GetActiveChainState().ConnectBlock(block, pindex, undo) != ConnectResult::OK) {
+        return false;
+    }
+    db::DiskBlockPos undoPos;
+    if (!blockDB.WriteUndo(undo, undoPos).ok()) {
+        return false;
+    }
+    // Like Reorganize, only undo beside its block can be found again
+    if (undoPos.nFile == pindex->nFile) {
+        pindex->nUndoPos = undoPos.nPos;
+        pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_UNDO;
+    }
+    return true;
+}
+
+bool ParseInt(const char* arg, const char* name, int& value) {
+    size_t len = std::strlen(name);
+    if (std::strncmp(arg, name, len) != 0) {
+        return false;
+    }
+    value = std::atoi(arg + len);
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        if (ParseInt(argv[i], "--blocks=", config.blocks) ||
+            ParseInt(argv[i], "--txs=", config.txs) ||
+            ParseInt(argv[i], "--inputs=", config.inputs) ||
+            ParseInt(argv[i], "--outputs=", config.outputs) ||
+            ParseInt(argv[i], "--dbcache=", config.dbcacheMB) ||
+            ParseInt(argv[i], "--par=", config.par)) {
+            continue;
+        }
+        if (std::strcmp(argv[i], "--assumevalid") == 0) {
+            config.assumeValid = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--reorg") == 0) {
+            config.reorg = true;
+            continue;
+        }
+        std::fprintf(stderr, "usage: %s [--blocks=N] [--txs=N] [--inputs=N] [--outputs=N] "
+                     "[--dbcache=MB] [--par=N] [--assumevalid] [--reorg]\n", argv[0]);
+        return 1;
+    }
+    if (config.blocks < 1 || config.txs < 0 || config.inputs < 1 || config.outputs < 1) {
+        std::fprintf(stderr, "--blocks, --inputs and --outputs must be positive\n");
+        return 1;
+    }
+
+    std::printf("{\"suite\":\"connect\",\"blocks\":%d,\"txs_per_block\":%d,\"inputs_per_tx\":%d,"
+                "\"outputs_per_tx\":%d,\"dbcache_mb\":%d,\"script_threads\":%d,"
+                "\"assume_valid\":%s}\n",
+                config.blocks, config.txs, config.inputs, config.outputs, config.dbcacheMB,
+                ResolveScriptCheckThreads(config.par), config.assumeValid ? "true" : "false");
+    std::fflush(stdout);
+
+    // Generate everything up front so signing stays out of the timings.
+    // Genesis creates nothing; block 1 funds every later transaction.
+    using Clock = std::chrono::steady_clock;
+    auto generateStart = Clock::now();
+    ChainGenerator generator(config);
+    std::vector<Block> chain;
+    chain.push_back(generator.MakeBlock(0));
+    chain.push_back(generator.MakeBlock(1, static_cast<size_t>(config.txs) * config.inputs * 2));
+    for (int height = 2; height <= MATURITY + 1; ++height) {
+        chain.push_back(generator.MakeBlock(height));
+    }
+    const size_t firstMeasured = chain.size();
+    for (int i = 0; i < config.blocks; ++i) {
+        chain.push_back(generator.MakeSpendingBlock(static_cast<int>(firstMeasured) + i));
+    }
+    uint64_t txs = 0;
+    for (size_t i = firstMeasured; i < chain.size(); ++i) {
+        txs += chain[i].vtx.size() - 1;
+    }
+    std::vector<Block> branch;
+    if (config.reorg) {
+        generator.SetPrevious(chain[firstMeasured - 1].GetHash());
+        for (size_t i = firstMeasured; i < chain.size(); ++i) {
+            branch.push_back(generator.MakeForkedBlock(chain[i], static_cast<int>(i)));
+        }
+        branch.push_back(generator.MakeBlock(static_cast<int>(chain.size())));
+    }
+    std::printf("{\"name\":\"generate\",\"seconds\":%.3f,\"transactions\":%llu,\"inputs\":%llu}\n",
+                Seconds(Clock::now() - generateStart), static_cast<unsigned long long>(txs),
+                static_cast<unsigned long long>(generator.GetInputs()));
+    std::fflush(stdout);
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() /
+                                ("shurium_bench_connect_" + std::to_string(getpid()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    int status = 0;
+    {
+        consensus::Params params = consensus::Params::RegTest();
+        params.hashGenesisBlock = chain[0].GetHash();
+
+        db::BlockDB blockDB(dir);
+        db::CoinsViewDB coinsDB(dir / "chainstate", db::Options(), true);
+        ChainStateManager manager(params);
+        manager.SetScriptCheckThreads(ResolveScriptCheckThreads(config.par));
+        manager.SetBlockDB(&blockDB);
+        manager.SetAssumeValid(config.assumeValid ? chain.back().GetHash() : BlockHash());
+        manager.Initialize(&coinsDB);
+        ChainState& chainstate = manager.GetActiveChainState();
+        chainstate.SetCoinsCacheLimit(static_cast<size_t>(config.dbcacheMB) * 1024 * 1024);
+
+        // Headers first, as in initial block download; this also puts the
+        // assume-valid block in the index so the skip applies
+        std::vector<BlockHeader> headers;
+        for (const Block& block : chain) {
+            headers.push_back(block.GetBlockHeader());
+        }
+        consensus::ValidationState headerState;
+        if (manager.ProcessBlockHeaders(headers, headerState) != headers.size()) {
+            std::fprintf(stderr, "headers rejected: %s\n", headerState.GetRejectReason().c_str());
+            status = 1;
+        }
+
+        // Funding and maturity, then a clean cache so spends start from disk
+        for (size_t i = 1; i < firstMeasured && status == 0; ++i) {
+            if (!ConnectNext(manager, blockDB, chain[i])) {
+                std::fprintf(stderr, "setup block %zu rejected\n", i);
+                status = 1;
+            }
+        }
+        chainstate.FlushStateToDisk();
+
+        std::vector<double> latencies;
+        auto connectStart = Clock::now();
+        for (size_t i = firstMeasured; i < chain.size() && status == 0; ++i) {
+            auto blockStart = Clock::now();
+            if (!ConnectNext(manager, blockDB, chain[i])) {
+                std::fprintf(stderr, "block %zu rejected\n", i);
+                status = 1;
+                continue;
+            }
+            latencies.push_back(Seconds(Clock::now() - blockStart) * 1000);
+        }
+        double connectSeconds = Seconds(Clock::now() - connectStart);
+
+        if (status == 0) {
+            std::sort(latencies.begin(), latencies.end());
+            auto quantile = [&](double q) {
+                return latencies[std::min(latencies.size() - 1,
+                                          static_cast<size_t>(q * latencies.size()))];
+            };
+            std::printf("{\"name\":\"connect\",\"seconds\":%.3f,\"blocks_per_sec\":%.1f,"
+                        "\"txs_per_sec\":%.1f,\"inputs_per_sec\":%.1f,\"block_ms_p50\":%.2f,"
+                        "\"block_ms_p99\":%.2f,\"block_ms_max\":%.2f,\"coins_cache_mb\":%.1f}\n",
+                        connectSeconds, config.blocks / connectSeconds, txs / connectSeconds,
+                        generator.GetInputs() / connectSeconds, quantile(0.5), quantile(0.99),
+                        latencies.back(), chainstate.GetCoinsCacheUsage() / 1048576.0);
+
+            auto flushStart = Clock::now();
+            bool flushed = chainstate.FlushStateToDisk();
+            std::printf("{\"name\":\"flush\",\"seconds\":%.3f,\"ok\":%s}\n",
+                        Seconds(Clock::now() - flushStart), flushed ? "true" : "false");
+            std::fflush(stdout);
+        }
+
+        if (status == 0 && config.reorg) {
+            for (const Block& block : branch) {
+                if (!StoreBlock(manager, blockDB, block)) {
+                    std::fprintf(stderr, "branch block rejected\n");
+                    status = 1;
+                    break;
+                }
+            }
+        }
+        if (status == 0 && config.reorg) {
+            auto reorgStart = Clock::now();
+            bool ok = manager.ActivateBestChain() &&
+                      manager.GetActiveTip()->GetBlockHash() == branch.back().GetHash();
+            double reorgSeconds = Seconds(Clock::now() - reorgStart);
+            if (!ok) {
+                std::fprintf(stderr, "reorganization failed\n");
+                status = 1;
+            } else {
+                ReorgStats stats = manager.GetReorgMetrics().last;
+                std::printf("{\"name\":\"reorganize\",\"seconds\":%.3f,\"disconnected\":%d,"
+                            "\"connected\":%d,\"blocks_per_sec\":%.1f,\"load_ms\":%.2f,"
+                            "\"apply_ms\":%.2f,\"flush_ms\":%.2f}\n",
+                            reorgSeconds, stats.nDisconnected, stats.nConnected,
+                            (stats.nDisconnected + stats.nConnected) / reorgSeconds,
+                            stats.loadMicros / 1000.0, stats.applyMicros / 1000.0,
+                            stats.flushMicros / 1000.0);
+            }
+        }
+        if (status == 0) {
+            std::printf("{\"name\":\"memory\",\"peak_rss_mb\":%.1f}\n", PeakRSSMegabytes());
+            std::fflush(stdout);
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return status;
+}
@@ -0,0 +1,321 @@
+// SHURIUM - Crypto Benchmark Suite
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Times the primitives consensus and the wallet spend their time in, once
+// per implementation this CPU supports where the dispatch offers a choice.
+// Output is JSON lines so runs can be diffed across releases: a header
+// object naming the auto-detected implementations, then one object per
+// benchmark with ops/s, ns/op and, on x86, TSC cycles/op (reference cycles
+// at the nominal clock, which is what regression tracking wants).
+// outpoint-map-lookup times coin map lookups with the salted SipHash-1-3
+// OutPointHasher against the unsalted XOR hash it replaced.
+//
+// Usage: shurium_bench_crypto [--filter=SUBSTRING] [--min-time=SECONDS]
+
+#include "shurium/chain/coins.h"
+#include "shurium/crypto/aes.h"
+#include "shurium/crypto/field.h"
+#include "shurium/crypto/hmac.h"
+#include "shurium/crypto/poseidon.h"
+#include "shurium/crypto/ripemd160.h"
+#include "shurium/crypto/secp256k1.h"
+#include "shurium/crypto/sha256.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SHURIUM_BENCH_TSC 1
+#endif
+
+using namespace shurium;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+
+/// Keeps the compiler from discarding results
+volatile Byte g_sink = 0;
+
+uint64_t ReadCycles() {
+#ifdef SHURIUM_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Run fn repeatedly for at least the minimum time and print one result
+ * line. bytes is the input size of one call (0 if not a throughput
+ * benchmark) and items the operations one call performs.
+ */
+template <typename Fn>
+void Run(const std::string& name, const char* impl, size_t bytes, Fn&& fn, size_t items = 1) {
+    if (g_filter && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    // Warm caches and lazily initialised tables before timing
+    fn();
+
+    uint64_t calls = 0;
+    double elapsed = 0;
+    auto start = Clock::now();
+    uint64_t startCycles = ReadCycles();
+    do {
+        for (int i = 0; i < 8; ++i) {
+            fn();
+        }
+        calls += 8;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < g_minSeconds);
+    uint64_t cycles = ReadCycles() - startCycles;
+
+    double ops = static_cast<double>(calls * items);
+    std::printf("{\"name\":\"%s\",\"impl\":\"%s\",\"ops_per_sec\":%.1f,\"ns_per_op\":%.2f",
+                name.c_str(), impl, ops / elapsed, elapsed * 1e9 / ops);
+#ifdef SHURIUM_BENCH_TSC
+    std::printf(",\"cycles_per_op\":%.1f", cycles / ops);
+#else
+    (void)cycles;
+    std::printf(",\"cycles_per_op\":null");
+#endif
+    if (bytes) {
+        std::printf(",\"mb_per_sec\":%.1f", ops / elapsed * bytes / items / 1e6);
+    }
+    std::printf("}\n");
+    std::fflush(stdout);
+}
+
+std::vector<Byte> Pattern(size_t len, unsigned seed) {
+    std::vector<Byte> data(len);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<Byte>(i * 131 + seed);
+    }
+    return data;
+}
+
+void BenchHashes() {
+    auto buf = Pattern(4096, 1);
+    SHA256Implementation detected = SHA256AutoDetect();
+    for (SHA256Implementation impl : GetAvailableSHA256Implementations()) {
+        SetSHA256Implementation(impl);
+        const char* name = SHA256ImplementationName(impl);
+        for (size_t len : {size_t(64), size_t(4096)}) {
+            Run("sha256/" + std::to_string(len) + "B", name, len, [&]() {
+                buf[0] = g_sink;
+                g_sink = g_sink ^ SHA256Hash(buf.data(), len)[0];
+            });
+        }
+        Run("dsha256/80B", name, 80, [&]() {
+            buf[0] = g_sink;
+            g_sink = g_sink ^ DoubleSHA256(buf.data(), 80)[0];
+        });
+        Run("hmac-sha256/64B", name, 64, [&]() {
+            Byte mac[HMAC_SHA256::OUTPUT_SIZE];
+            HMAC_SHA256 hmac(buf.data() + 64, 32);
+            hmac.Write(buf.data(), 64).Finalize(mac);
+            g_sink = g_sink ^ mac[0];
+        });
+    }
+    SetSHA256Implementation(detected);
+
+    // One call hashes a Merkle level of 1024 nodes
+    std::vector<Byte> level = Pattern(64 * 1024, 2);
+    size_t detectedD64 = GetSHA256D64Ways();
+    for (size_t ways : GetAvailableSHA256D64Ways()) {
+        SetSHA256D64Ways(ways);
+        std::string impl = std::to_string(ways) + "way";
+        Run("dsha256-64/batch", impl.c_str(), level.size(), [&]() {
+            DoubleSHA256_64(level.data(), level.data(), 1024);
+        }, 1024);
+    }
+    SetSHA256D64Ways(detectedD64);
+
+    Run("ripemd160/64B", "scalar", 64, [&]() {
+        buf[0] = g_sink;
+        g_sink = g_sink ^ RIPEMD160Hash(buf.data(), 64)[0];
+    });
+    Run("hmac-sha512/64B", "scalar", 64, [&]() {
+        Byte mac[HMAC_SHA512::OUTPUT_SIZE];
+        HMAC_SHA512 hmac(buf.data() + 64, 32);
+        hmac.Write(buf.data(), 64).Finalize(mac);
+        g_sink = g_sink ^ mac[0];
+    });
+
+    // One call hashes 1024 compressed public keys
+    std::vector<Byte> keys = Pattern(33 * 1024, 3);
+    std::vector<Byte> keyHashes(20 * 1024);
+    size_t detectedH160 = GetHash160Ways();
+    for (size_t ways : GetAvailableHash160Ways()) {
+        SetHash160Ways(ways);
+        std::string impl = std::to_string(ways) + "way";
+        Run("hash160-33/batch", impl.c_str(), keys.size(), [&]() {
+            Hash160_33(keyHashes.data(), keys.data(), 1024);
+            g_sink = g_sink ^ keyHashes[0];
+        }, 1024);
+    }
+    SetHash160Ways(detectedH160);
+}
+
+void BenchAES() {
+    auto key = Pattern(32, 4);
+    auto data = Pattern(4096, 5);
+    AESImplementation detected = AESAutoDetect();
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        SetAESImplementation(impl);
+        const char* name = AESImplementationName(impl);
+        AESContext ctx(key.data(), key.size());
+        Run("aes256-encrypt/16B", name, 16, [&]() {
+            ctx.EncryptBlock(data.data(), data.data());
+        });
+        Run("aes256-ctr/4096B", name, data.size(), [&]() {
+            Byte counter[aes::BLOCK_SIZE] = {};
+            ctx.CTR(counter, data.data(), data.data(), data.size() / aes::BLOCK_SIZE);
+        });
+        Run("aes256-cbc-decrypt/4096B", name, data.size(), [&]() {
+            Byte iv[aes::BLOCK_SIZE] = {};
+            ctx.DecryptCBC(iv, data.data(), data.data(), data.size() / aes::BLOCK_SIZE);
+        });
+    }
+    SetAESImplementation(detected);
+}
+
+void BenchSecp256k1() {
+    auto privKey = Pattern(32, 6);
+    auto hash = Pattern(32, 7);
+    secp256k1::Scalar scalar(privKey.data());
+
+    Run("secp256k1-base-mul", "native", 0, [&]() {
+        auto point = secp256k1::ScalarBaseMultiply(scalar);
+        g_sink = g_sink ^ static_cast<Byte>(point.has_value());
+    });
+
+    uint8_t pubkey[33];
+    secp256k1::ComputePublicKey(privKey.data(), pubkey, true);
+    uint8_t sig[72];
+    size_t sigLen = sizeof(sig);
+    secp256k1::ECDSASign(hash.data(), privKey.data(), sig, &sigLen);
+
+    Run("ecdsa-sign", "native", 0, [&]() {
+        uint8_t out[72];
+        size_t outLen = sizeof(out);
+        secp256k1::ECDSASign(hash.data(), privKey.data(), out, &outLen);
+        g_sink = g_sink ^ out[4];
+    });
+    Run("ecdsa-verify", "native", 0, [&]() {
+        g_sink = g_sink ^ secp256k1::ECDSAVerify(hash.data(), sig, sigLen, pubkey, sizeof(pubkey));
+    });
+    secp256k1::ParsedPublicKey parsed;
+    secp256k1::ParsePublicKey(parsed, pubkey, sizeof(pubkey));
+    Run("ecdsa-verify-parsed", "native", 0, [&]() {
+        g_sink = g_sink ^ secp256k1::ECDSAVerify(hash.data(), sig, sigLen, parsed);
+    });
+
+    uint8_t schnorrSig[64];
+    secp256k1::SchnorrSign(hash.data(), privKey.data(), schnorrSig);
+    Run("schnorr-verify", "native", 0, [&]() {
+        g_sink = g_sink ^ secp256k1::SchnorrVerify(hash.data(), schnorrSig, pubkey + 1);
+    });
+
+    secp256k1::FieldElement fe(hash.data());
+    Run("secp256k1-field-inverse", "native", 0, [&]() {
+        fe = fe.Inverse();
+    });
+}
+
+void BenchPoseidon() {
+    FieldElement left(uint64_t{12345});
+    FieldElement right(uint64_t{67890});
+    Run("poseidon-hash2", "native", 0, [&]() {
+        left = Poseidon::Hash2(left, right);
+    });
+    Run("bn254-field-inverse", "native", 0, [&]() {
+        right = right.Inverse();
+    });
+}
+
+/// The unsalted XOR hash outpoint maps used before SipHash-1-3
+struct LegacyOutPointHasher {
+    size_t operator()(const OutPoint& outpoint) const {
+        size_t seed = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            seed ^= static_cast<size_t>(outpoint.hash[i]) << (i * 8);
+        }
+        seed ^= std::hash<uint32_t>{}(outpoint.n);
+        return seed;
+    }
+};
+
+void BenchOutPointLookup() {
+    constexpr int N = 200000;
+    std::vector<OutPoint> keys;
+    keys.reserve(N);
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < N; ++i) {
+        TxHash hash;
+        for (size_t j = 0; j < hash.size(); j += 8) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            std::memcpy(hash.data() + j, &x, 8);
+        }
+        keys.emplace_back(hash, static_cast<uint32_t>(i & 3));
+    }
+
+    auto bench = [&](const char* impl, auto map) {
+        for (int i = 0; i < N; ++i) {
+            map.emplace(keys[i], i);
+        }
+        Run("outpoint-map-lookup", impl, 0, [&]() {
+            size_t found = 0;
+            for (const auto& key : keys) {
+                found += map.count(key);
+            }
+            g_sink = g_sink ^ static_cast<Byte>(found);
+        }, keys.size());
+    };
+    bench("legacy-xor", std::unordered_map<OutPoint, int, LegacyOutPointHasher>());
+    bench("siphash13", std::unordered_map<OutPoint, int, OutPointHasher>());
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"crypto\",\"sha256\":\"%s\",\"sha256_d64_ways\":%zu,"
+                "\"hash160_ways\":%zu,\"aes\":\"%s\",\"tsc\":%s}\n",
+                SHA256ImplementationName(SHA256AutoDetect()), GetSHA256D64Ways(),
+                GetHash160Ways(), AESImplementationName(AESAutoDetect()),
+#ifdef SHURIUM_BENCH_TSC
+                "true"
+#else
+                "false"
+#endif
+    );
+
+    BenchHashes();
+    BenchAES();
+    BenchSecp256k1();
+    BenchPoseidon();
+    BenchOutPointLookup();
+    return 0;
+}
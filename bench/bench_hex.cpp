@@ -0,0 +1,106 @@
+// SHURIUM - Hex Encoding Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Throughput of hex encoding and decoding with each implementation the CPU
+// supports, at the sizes RPC handles:
+//   encode/<impl>/<size>   EncodeHex into a preallocated buffer
+//   decode/<impl>/<size>   DecodeHex (with validation) of the same bytes
+//   hexstr/<impl>/<size>   BytesToHex, allocating the result string
+// Sizes are a hash (32 bytes), a transaction (400) and a full block (1MB).
+//
+// Output is JSON lines like the other suites.
+//
+// Usage: shurium_bench_hex [--filter=SUBSTRING] [--min-time=SECONDS]
+
+#include "shurium/core/hex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace shurium;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+
+/// Bytes processed per timed batch, whatever the item size
+constexpr size_t BATCH_BYTES = 4 * 1024 * 1024;
+
+template<typename Body>
+void Run(const std::string& name, size_t size, Body body) {
+    if (g_filter && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    size_t perBatch = BATCH_BYTES / size + 1;
+    uint64_t bytes = 0;
+    double elapsed = 0;
+    do {
+        auto start = Clock::now();
+        for (size_t i = 0; i < perBatch; ++i) {
+            body();
+        }
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        bytes += perBatch * size;
+    } while (elapsed < g_minSeconds);
+
+    std::printf("{\"name\":\"%s\",\"bytes\":%llu,\"mb_per_second\":%.1f}\n",
+                name.c_str(), static_cast<unsigned long long>(bytes),
+                bytes / elapsed / 1e6);
+    std::fflush(stdout);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"hex\"}\n");
+
+    const HexImplementation detected = GetHexImplementation();
+    volatile size_t sink = 0;
+    for (size_t size : {size_t{32}, size_t{400}, size_t{1000000}}) {
+        std::vector<HexByte> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<HexByte>(i * 167 + 13);
+        }
+        std::string hex(2 * size, '\0');
+        std::vector<HexByte> decoded(size);
+
+        for (HexImplementation impl : GetAvailableHexImplementations()) {
+            SetHexImplementation(impl);
+            std::string suffix = std::string("/") + HexImplementationName(impl) + "/" +
+                                 std::to_string(size);
+            Run("encode" + suffix, size, [&] { EncodeHex(data.data(), size, &hex[0]); });
+            Run("decode" + suffix, size, [&] {
+                if (!DecodeHex(hex.data(), size, decoded.data())) {
+                    std::abort();
+                }
+            });
+            Run("hexstr" + suffix, size, [&] { sink = sink + BytesToHex(data).size(); });
+            if (decoded != data) {
+                std::fprintf(stderr, "%s round trip mismatch\n", HexImplementationName(impl));
+                return 1;
+            }
+        }
+    }
+    SetHexImplementation(detected);
+    return 0;
+}
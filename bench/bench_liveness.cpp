@@ -0,0 +1,133 @@
+// SHURIUM - Validator Liveness Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Records one block for each of 10k validators per simulated block and
+// reads back the miss count the downtime check uses, comparing:
+//   vector   the previous std::vector<bool> window, which erases its
+//            front element once full
+//   window   LivenessWindow, a circular bitset with a running count
+// Every validator starts with a full MISSED_BLOCKS_WINDOW window, as on a
+// long-running chain, and misses about 1 block in 50.
+//
+// Output is JSON lines like the other suites.
+//
+// Usage: shurium_bench_liveness [--filter=SUBSTRING] [--min-time=SECONDS]
+//                               [--validators=N]
+
+#include "shurium/staking/staking.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace shurium;
+using namespace shurium::staking;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+size_t g_validators = 10000;
+
+/// The window as Validator kept it before LivenessWindow
+struct VectorWindow {
+    std::vector<bool> bits;
+    int missed{0};
+
+    void Record(bool miss) {
+        if (bits.size() >= static_cast<size_t>(MISSED_BLOCKS_WINDOW)) {
+            if (bits.front()) {
+                --missed;
+            }
+            bits.erase(bits.begin());
+        }
+        bits.push_back(miss);
+        missed += miss ? 1 : 0;
+    }
+    size_t MissedCount() const { return static_cast<size_t>(missed); }
+};
+
+/// Pseudo-random miss pattern, shared by both variants
+std::vector<bool> MissPattern(size_t n) {
+    std::mt19937_64 rng(0x5eed);
+    std::bernoulli_distribution miss(0.02);
+    std::vector<bool> pattern(n);
+    for (size_t i = 0; i < n; ++i) {
+        pattern[i] = miss(rng);
+    }
+    return pattern;
+}
+
+template<typename Window>
+void Run(const char* variant) {
+    std::string name = std::string("liveness/") + variant;
+    if (g_filter && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    const std::vector<bool> pattern = MissPattern(4093);
+    size_t cursor = 0;
+    auto next = [&]() {
+        bool miss = pattern[cursor];
+        cursor = (cursor + 1) % pattern.size();
+        return miss;
+    };
+
+    std::vector<Window> windows(g_validators);
+    for (auto& window : windows) {
+        for (int i = 0; i < MISSED_BLOCKS_WINDOW; ++i) {
+            window.Record(next());
+        }
+    }
+
+    uint64_t blocks = 0;
+    uint64_t overThreshold = 0;
+    double elapsed = 0;
+    do {
+        auto start = Clock::now();
+        for (auto& window : windows) {
+            window.Record(next());
+            overThreshold += window.MissedCount() >= static_cast<size_t>(MAX_MISSED_BLOCKS);
+        }
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        ++blocks;
+    } while (elapsed < g_minSeconds);
+
+    double updates = static_cast<double>(blocks) * windows.size();
+    std::printf("{\"name\":\"%s\",\"validators\":%zu,\"window\":%d,\"blocks\":%llu,"
+                "\"us_per_block\":%.1f,\"ns_per_validator\":%.1f,\"over_threshold\":%llu}\n",
+                name.c_str(), windows.size(), MISSED_BLOCKS_WINDOW,
+                static_cast<unsigned long long>(blocks), elapsed * 1e6 / blocks,
+                elapsed * 1e9 / updates, static_cast<unsigned long long>(overThreshold));
+    std::fflush(stdout);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else if (std::strncmp(argv[i], "--validators=", 13) == 0) {
+            g_validators = std::strtoull(argv[i] + 13, nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS] "
+                         "[--validators=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"liveness\",\"validators\":%zu}\n", g_validators);
+
+    Run<VectorWindow>("vector");
+    Run<LivenessWindow>("window");
+    return 0;
+}
@@ -0,0 +1,115 @@
+// SHURIUM - Disabled Log Statement Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Times LOG_DEBUG statements in a tight loop while the logger runs at INFO,
+// as the debug lines in the message handlers do on a default node:
+//   disabled        LOG_DEBUG with a string and two integers streamed in
+//   category        the same at DEBUG level with only another category on
+//   filter_string   the previous check, which built a std::string for the
+//                   category before comparing levels
+// Nothing is written; a sink counts entries so any that get through show.
+//
+// Output is JSON lines like the other suites.
+//
+// Usage: shurium_bench_logging [--filter=SUBSTRING] [--min-time=SECONDS]
+
+#include "shurium/util/logging.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace shurium;
+using namespace shurium::util;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+
+constexpr uint64_t BATCH = 1 << 20;
+
+/// Level check that takes the category as std::string, as WillLog did
+__attribute__((noinline)) bool FilterByString(LogLevel level, const std::string& category) {
+    return Logger::Instance().WillLog(level, category);
+}
+
+template<typename Body>
+void Run(const char* variant, Body body) {
+    std::string name = std::string("logging/") + variant;
+    if (g_filter && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t statements = 0;
+    double elapsed = 0;
+    do {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < BATCH; ++i) {
+            body(i);
+        }
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        statements += BATCH;
+    } while (elapsed < g_minSeconds);
+
+    std::printf("{\"name\":\"%s\",\"statements\":%llu,\"ns_per_statement\":%.2f}\n",
+                name.c_str(), static_cast<unsigned long long>(statements),
+                elapsed * 1e9 / statements);
+    std::fflush(stdout);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    auto& logger = Logger::Instance();
+    logger.ClearSinks();
+    uint64_t written = 0;
+    logger.AddSink(std::make_shared<CallbackSink>([&](const LogEntry&) { ++written; },
+                                                  LogLevel::Trace));
+    logger.EnableAllCategories();
+    logger.SetLevel(LogLevel::Info);
+
+    std::printf("{\"suite\":\"logging\"}\n");
+
+    Run("disabled", [](uint64_t i) {
+        LOG_DEBUG(LogCategory::NET) << "received message from peer=" << i << " size=" << i * 3;
+    });
+    Run("filter_string", [](uint64_t i) {
+        if (FilterByString(LogLevel::Debug, LogCategory::NET)) {
+            LogStream(LogLevel::Debug, LogCategory::NET, __FILE__, __LINE__, __func__)
+                << "received message from peer=" << i << " size=" << i * 3;
+        }
+    });
+
+    logger.SetLevel(LogLevel::Debug);
+    logger.DisableAllCategories();
+    logger.EnableCategory(LogCategory::MEMPOOL);
+    Run("category", [](uint64_t i) {
+        LOG_DEBUG(LogCategory::NET) << "received message from peer=" << i << " size=" << i * 3;
+    });
+
+    logger.ClearSinks();
+    if (written != 0) {
+        std::fprintf(stderr, "%llu disabled statements were written\n",
+                     static_cast<unsigned long long>(written));
+        return 1;
+    }
+    return 0;
+}
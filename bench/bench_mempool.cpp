@@ -0,0 +1,420 @@
+// SHURIUM - Mempool Stress Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Pushes synthetic transactions through the mempool the way relay does,
+// with reader threads calling Exists and GetInfo throughout, as RPC and
+// the inventory handlers do on a busy node:
+//   accept    --txs transactions through AddTx; one in five extends an
+//             ancestor chain up to --chain long, the rest spend confirmed
+//             outputs. Reports accept/s, per-call latency and the reader
+//             throughput, then memory per entry.
+//   replace   one in ten of them replaced through AddTx (RBF), chain
+//             roots included so whole descendant sets go, then conflicts
+//             of a block removed with RemoveConflicts
+//   block     the pool emptied with RemoveForBlock, --block transactions
+//             at a time in the order they arrived
+//   trim      a quarter as many transactions into a mempool capped at
+//             --maxmempool MB, so TrimToSize evicts on almost every add
+//
+// Transactions are generated before each call is timed; scripts are not
+// checked by the mempool so none are signed.
+//
+// Output is JSON lines like the other suites.
+//
+// Usage: shurium_bench_mempool [--filter=SUBSTRING] [--txs=N] [--chain=N]
+//                              [--readers=N] [--block=N] [--maxmempool=MB]
+
+#include "shurium/core/random.h"
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/mempool/mempool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace shurium;
+
+namespace {
+
+const char* g_filter = nullptr;
+size_t g_txs = 1000000;
+size_t g_chain = 25;
+int g_readers = 2;
+size_t g_block = 2000;
+size_t g_maxMempoolMB = 20;
+
+/// Mempool height the transactions are accepted at
+constexpr uint32_t HEIGHT = 100000;
+
+/// Every replacement outbids whatever it conflicts with
+constexpr Amount REPLACEMENT_FEE = COIN;
+
+using Clock = std::chrono::steady_clock;
+
+bool Enabled(const char* phase) {
+    return !g_filter || std::string("mempool/").append(phase).find(g_filter) != std::string::npos;
+}
+
+double Micros(Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+/// Latencies of one phase, in microseconds
+struct Latencies {
+    std::vector<double> samples;
+
+    void Reserve(size_t n) { samples.reserve(n); }
+    void Add(Clock::duration d) { samples.push_back(Micros(d)); }
+
+    double Total() const {
+        double total = 0;
+        for (double s : samples) {
+            total += s;
+        }
+        return total;
+    }
+
+    double Quantile(double q) {
+        if (samples.empty()) {
+            return 0;
+        }
+        size_t i = std::min(samples.size() - 1, static_cast<size_t>(q * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + i, samples.end());
+        return samples[i];
+    }
+};
+
+/// Resident set size of the process now
+size_t CurrentRSS() {
+    long pages = 0;
+    long resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    std::fclose(f);
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/// Builds transactions shaped like ordinary payments
+class TxFactory {
+public:
+    TxFactory() : rng_(0x6d656d706f6f6cULL) {}
+
+    /// A confirmed output nothing else spends
+    OutPoint FreshOutPoint() {
+        TxHash hash;
+        uint64_t n = ++confirmed_;
+        std::memcpy(hash.data(), &n, sizeof(n));
+        hash[31] = 0xc0;
+        return OutPoint(hash, 0);
+    }
+
+    /// One input, payment and change; signals replaceability
+    TransactionRef Spend(const OutPoint& prevout) {
+        MutableTransaction mtx;
+        mtx.version = 2;
+        mtx.vin.emplace_back(prevout, Script(), TxIn::MAX_SEQUENCE_NONFINAL - 1);
+        mtx.vin[0].scriptSig << std::vector<uint8_t>(72, 0x30) << std::vector<uint8_t>(33, 0x02);
+        for (int i = 0; i < 2; ++i) {
+            Hash160 dest;
+            uint64_t r = rng_.Rand64();
+            std::memcpy(dest.data(), &r, sizeof(r));
+            mtx.vout.emplace_back(static_cast<Amount>(1000 + rng_.RandRange(COIN)),
+                                  Script::CreateP2PKH(dest));
+        }
+        return MakeTransactionRef(std::move(mtx));
+    }
+
+    /// Fee between 1 and 20 sat/byte
+    Amount Fee(const TransactionRef& tx) {
+        return static_cast<Amount>(tx->GetTotalSize() * (1 + rng_.RandRange(20)));
+    }
+
+    FastRandomContext& Rng() { return rng_; }
+
+private:
+    FastRandomContext rng_;
+    uint64_t confirmed_{0};
+};
+
+/// Stream of transactions: mostly independent, one in five on a chain
+class Workload {
+public:
+    explicit Workload(TxFactory& factory) : factory_(factory) {}
+
+    TransactionRef Next() {
+        ++count_;
+        if (count_ % 5 == 0) {
+            OutPoint prevout = chainLength_ > 0 && chainLength_ < g_chain
+                                   ? OutPoint(chainTip_, 0)
+                                   : factory_.FreshOutPoint();
+            chainLength_ = chainLength_ < g_chain ? chainLength_ + 1 : 1;
+            TransactionRef tx = factory_.Spend(prevout);
+            chainTip_ = tx->GetHash();
+            return tx;
+        }
+        return factory_.Spend(factory_.FreshOutPoint());
+    }
+
+private:
+    TxFactory& factory_;
+    uint64_t count_{0};
+    size_t chainLength_{0};
+    TxHash chainTip_;
+};
+
+/// Threads looking up random txids accepted so far
+class Readers {
+public:
+    Readers(const Mempool& pool, const std::vector<TxHash>& txids,
+            const std::atomic<size_t>& published)
+        : pool_(pool), txids_(txids), published_(published) {}
+
+    void Start() {
+        for (int i = 0; i < g_readers; ++i) {
+            threads_.emplace_back([this, i]() {
+                FastRandomContext rng(static_cast<uint64_t>(i) + 1);
+                uint64_t ops = 0;
+                while (!stop_.load(std::memory_order_relaxed)) {
+                    size_t n = published_.load(std::memory_order_acquire);
+                    if (n == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    const TxHash& txid = txids_[rng.RandRange(n)];
+                    if (pool_.Exists(txid)) {
+                        pool_.GetInfo(txid);
+                    }
+                    ops += 2;
+                }
+                ops_.fetch_add(ops);
+            });
+        }
+    }
+
+    /// Stop the threads; returns lookups done
+    uint64_t Stop() {
+        stop_.store(true);
+        for (auto& t : threads_) {
+            t.join();
+        }
+        threads_.clear();
+        return ops_.load();
+    }
+
+private:
+    const Mempool& pool_;
+    const std::vector<TxHash>& txids_;
+    const std::atomic<size_t>& published_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> ops_{0};
+};
+
+void Report(const char* phase, size_t calls, size_t done, double seconds, Latencies& latencies,
+            const std::string& extra = "") {
+    std::printf("{\"name\":\"mempool/%s\",\"calls\":%zu,\"done\":%zu,\"seconds\":%.3f,"
+                "\"per_sec\":%.1f,\"p50_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f%s}\n",
+                phase, calls, done, seconds, seconds > 0 ? calls / seconds : 0.0,
+                latencies.Quantile(0.5), latencies.Quantile(0.99), latencies.Quantile(1.0),
+                extra.c_str());
+    std::fflush(stdout);
+}
+
+MempoolLimits UnboundedLimits() {
+    MempoolLimits limits;
+    limits.maxSize = std::numeric_limits<size_t>::max();
+    limits.maxAncestorCount = std::max<uint64_t>(limits.maxAncestorCount, g_chain);
+    limits.maxDescendantCount = std::max<uint64_t>(limits.maxDescendantCount, g_chain);
+    limits.maxClusterCount = std::max<uint64_t>(limits.maxClusterCount, g_chain);
+    return limits;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--txs=", 6) == 0) {
+            g_txs = std::strtoull(argv[i] + 6, nullptr, 10);
+        } else if (std::strncmp(argv[i], "--chain=", 8) == 0) {
+            g_chain = std::max<size_t>(1, std::strtoull(argv[i] + 8, nullptr, 10));
+        } else if (std::strncmp(argv[i], "--readers=", 10) == 0) {
+            g_readers = std::atoi(argv[i] + 10);
+        } else if (std::strncmp(argv[i], "--block=", 8) == 0) {
+            g_block = std::max<size_t>(1, std::strtoull(argv[i] + 8, nullptr, 10));
+        } else if (std::strncmp(argv[i], "--maxmempool=", 13) == 0) {
+            g_maxMempoolMB = std::max<size_t>(1, std::strtoull(argv[i] + 13, nullptr, 10));
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--txs=N] [--chain=N] "
+                         "[--readers=N] [--block=N] [--maxmempool=MB]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"mempool\",\"txs\":%zu,\"chain\":%zu,\"readers\":%d,\"block\":%zu,"
+                "\"maxmempool_mb\":%zu}\n",
+                g_txs, g_chain, g_readers, g_block, g_maxMempoolMB);
+    std::fflush(stdout);
+
+    TxFactory factory;
+    std::string err;
+
+    // The accepted transactions, in arrival order; readers sample them
+    std::vector<TxHash> txids(g_txs);
+    std::atomic<size_t> published{0};
+    std::vector<TransactionRef> arrived;
+    arrived.reserve(g_txs);
+
+    Mempool pool(UnboundedLimits());
+    size_t rssBefore = CurrentRSS();
+
+    if (Enabled("accept") || Enabled("replace") || Enabled("block")) {
+        Workload workload(factory);
+        Readers readers(pool, txids, published);
+        readers.Start();
+        Latencies latencies;
+        latencies.Reserve(g_txs);
+        size_t accepted = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < g_txs; ++i) {
+            TransactionRef tx = workload.Next();
+            Amount fee = factory.Fee(tx);
+            auto callStart = Clock::now();
+            bool ok = pool.AddTx(tx, fee, HEIGHT, false, err);
+            latencies.Add(Clock::now() - callStart);
+            if (ok) {
+                txids[accepted++] = tx->GetHash();
+                published.store(accepted, std::memory_order_release);
+                arrived.push_back(std::move(tx));
+            }
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        uint64_t lookups = readers.Stop();
+
+        if (Enabled("accept")) {
+            char extra[128];
+            std::snprintf(extra, sizeof(extra), ",\"add_us_total\":%.0f,\"reader_ops_per_sec\":%.1f",
+                          latencies.Total(), seconds > 0 ? lookups / seconds : 0.0);
+            Report("accept", g_txs, accepted, seconds, latencies, extra);
+
+            size_t entries = pool.Size();
+            size_t rssAfter = CurrentRSS();
+            std::printf("{\"name\":\"mempool/memory\",\"entries\":%zu,\"dynamic_mb\":%.1f,"
+                        "\"dynamic_bytes_per_entry\":%.1f,\"rss_bytes_per_entry\":%.1f}\n",
+                        entries, pool.DynamicMemoryUsage() / 1048576.0,
+                        entries ? static_cast<double>(pool.DynamicMemoryUsage()) / entries : 0.0,
+                        entries ? static_cast<double>(rssAfter - std::min(rssAfter, rssBefore)) /
+                                      entries : 0.0);
+            std::fflush(stdout);
+        }
+    }
+
+    if (Enabled("replace") && !arrived.empty()) {
+        // Every tenth arrival, chain members included, gets outbid
+        Latencies latencies;
+        size_t calls = 0;
+        size_t replaced = 0;
+        size_t sizeBefore = pool.Size();
+        auto start = Clock::now();
+        for (size_t i = 0; i < arrived.size(); i += 10) {
+            if (!pool.Exists(arrived[i]->GetHash())) {
+                continue;
+            }
+            TransactionRef replacement = factory.Spend(arrived[i]->vin[0].prevout);
+            auto callStart = Clock::now();
+            replaced += pool.AddTx(replacement, REPLACEMENT_FEE, HEIGHT, false, err);
+            latencies.Add(Clock::now() - callStart);
+            ++calls;
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        char extra[96];
+        std::snprintf(extra, sizeof(extra), ",\"evicted\":%zu", sizeBefore + replaced - pool.Size());
+        Report("replace", calls, replaced, seconds, latencies, extra);
+
+        // A block confirming other spends of every tenth arrival's input
+        Latencies conflictLatencies;
+        calls = 0;
+        sizeBefore = pool.Size();
+        start = Clock::now();
+        for (size_t i = 5; i < arrived.size(); i += 10) {
+            TransactionRef confirmed = factory.Spend(arrived[i]->vin[0].prevout);
+            auto callStart = Clock::now();
+            pool.RemoveConflicts(*confirmed);
+            conflictLatencies.Add(Clock::now() - callStart);
+            ++calls;
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        Report("remove_conflicts", calls, sizeBefore - pool.Size(), seconds, conflictLatencies);
+    }
+
+    if (Enabled("block") && !arrived.empty()) {
+        Latencies latencies;
+        size_t blocks = 0;
+        size_t sizeBefore = pool.Size();
+        auto start = Clock::now();
+        for (size_t next = 0; next < arrived.size(); ++blocks) {
+            std::vector<TransactionRef> block;
+            while (next < arrived.size() && block.size() < g_block) {
+                block.push_back(arrived[next++]);
+            }
+            auto callStart = Clock::now();
+            pool.RemoveForBlock(block, HEIGHT + 1 + static_cast<uint32_t>(blocks));
+            latencies.Add(Clock::now() - callStart);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        char extra[96];
+        std::snprintf(extra, sizeof(extra), ",\"txs_per_sec\":%.1f",
+                      latencies.Total() > 0 ? (sizeBefore - pool.Size()) / (latencies.Total() / 1e6)
+                                            : 0.0);
+        Report("block", blocks, sizeBefore - pool.Size(), seconds, latencies, extra);
+    }
+    pool.Clear();
+    arrived.clear();
+    arrived.shrink_to_fit();
+
+    if (Enabled("trim")) {
+        MempoolLimits limits = UnboundedLimits();
+        limits.maxSize = g_maxMempoolMB * 1024 * 1024;
+        Mempool capped(limits);
+        size_t evicted = 0;
+        capped.SetNotifyRemoved([&evicted](const TransactionRef&, MempoolRemovalReason reason) {
+            evicted += reason == MempoolRemovalReason::SIZELIMIT;
+        });
+        Workload workload(factory);
+        size_t calls = std::max<size_t>(1, g_txs / 4);
+        Latencies latencies;
+        latencies.Reserve(calls);
+        size_t accepted = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < calls; ++i) {
+            TransactionRef tx = workload.Next();
+            Amount fee = factory.Fee(tx);
+            auto callStart = Clock::now();
+            accepted += capped.AddTx(tx, fee, HEIGHT, false, err);
+            latencies.Add(Clock::now() - callStart);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        char extra[128];
+        std::snprintf(extra, sizeof(extra), ",\"evicted\":%zu,\"entries\":%zu,\"dynamic_mb\":%.1f",
+                      evicted, capped.Size(), capped.DynamicMemoryUsage() / 1048576.0);
+        Report("trim", calls, accepted, seconds, latencies, extra);
+    }
+    return 0;
+}
@@ -0,0 +1,593 @@
+// SHURIUM - Loopback P2P Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Runs --nodes in-process nodes connected over loopback TCP through real
+// ConnectionManager, EventLoop, MessageProcessor and BlockSynchronizer
+// instances, wired the way StartNetwork wires a node. Each node has its own
+// chain state, block files in a temporary directory and mempool; all start
+// from the same genesis block and the same set of spendable coins. Node i
+// opens --peers outbound connections to the nodes after it in a ring.
+//
+// Three scenarios run in turn:
+//   tx_flood  --txs signed transactions, each accepted at one node (round
+//             robin) and relayed; done when every node has every one
+//   blocks    --blocks blocks built from those transactions, each connected
+//             at one node and relayed; the next one starts when every node
+//             has the last
+//   ibd       a fresh node connects to node 0 and downloads the chain;
+//             latency is from connecting to having each block
+//
+// Output is JSON lines like the other suites. For each scenario: messages
+// handled per second (all nodes), bytes sent, bytes copied between network
+// buffers per byte sent, arrival latency percentiles (the time from a
+// transaction or block entering its first node to entering each other one)
+// and process CPU time per peer connection end. A scenario that does not
+// finish within --timeout seconds fails the run, so it doubles as a
+// regression test.
+//
+// Usage: shurium_bench_p2p [--nodes=N] [--peers=N] [--txs=N] [--blocks=N]
+//                          [--workers=N] [--interval=MS] [--timeout=S]
+//                          [--no-reconciliation]
+
+#include "shurium/chain/chainstate.h"
+#include "shurium/chain/coins.h"
+#include "shurium/consensus/params.h"
+#include "shurium/consensus/validation.h"
+#include "shurium/core/block.h"
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/crypto/keys.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/crypto/siphash.h"
+#include "shurium/db/blockdb.h"
+#include "shurium/mempool/mempool.h"
+#include "shurium/network/connection.h"
+#include "shurium/network/message_processor.h"
+#include "shurium/network/sync.h"
+#include "shurium/script/interpreter.h"
+#include "shurium/util/logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace shurium;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Distinct keys the funding coins pay to
+constexpr uint32_t NUM_KEYS = 16;
+
+constexpr Amount FUNDING_AMOUNT = 10 * COIN;
+constexpr Amount FEE = 10000;
+
+struct Config {
+    int nodes{4};
+    int peers{2};
+    int txs{2000};
+    int blocks{20};
+    int workers{1};
+    int intervalMs{20};
+    int timeoutSec{120};
+    bool reconciliation{true};
+};
+
+KeyPair DeriveKey(uint32_t i) {
+    uint8_t seed[4] = {'p', '2', 'p', static_cast<uint8_t>(i)};
+    Hash256 secret = SHA256Hash(seed, sizeof(seed));
+    return KeyPair(PrivateKey(secret.data()));
+}
+
+/// The coins every node starts with, and transactions spending them
+class Funding {
+public:
+    explicit Funding(int count) {
+        for (uint32_t i = 0; i < NUM_KEYS; ++i) {
+            keys_.push_back(DeriveKey(i));
+            pubkeys_.push_back(keys_.back().GetPublicKey().ToVector());
+        }
+        for (int i = 0; i < count; ++i) {
+            uint8_t seed[8] = {'f', 'u', 'n', 'd', static_cast<uint8_t>(i >> 24),
+                               static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8),
+                               static_cast<uint8_t>(i)};
+            outpoints_.emplace_back(TxHash(SHA256Hash(seed, sizeof(seed))), 0);
+        }
+    }
+
+    /// Put the coins in a node's view
+    void Fund(CoinsViewMemory& coins) const {
+        for (size_t i = 0; i < outpoints_.size(); ++i) {
+            coins.AddCoin(outpoints_[i], Coin(TxOut(FUNDING_AMOUNT, LockingScript(Key(i))), 1,
+                                              false));
+        }
+    }
+
+    /// One input, one P2PKH output, signed
+    TransactionRef Spend(size_t i) const {
+        MutableTransaction mtx;
+        mtx.version = 2;
+        mtx.vin.emplace_back(outpoints_[i]);
+        mtx.vout.emplace_back(FUNDING_AMOUNT - FEE, LockingScript(Key(i + 1)));
+        Hash256 sighash = SignatureHash(Transaction(mtx), 0, LockingScript(Key(i)), SIGHASH_ALL);
+        std::vector<uint8_t> signature = keys_[Key(i)].Sign(sighash);
+        signature.push_back(SIGHASH_ALL);
+        mtx.vin[0].scriptSig << signature << pubkeys_[Key(i)];
+        return MakeTransactionRef(std::move(mtx));
+    }
+
+private:
+    static uint32_t Key(size_t i) { return static_cast<uint32_t>(i % NUM_KEYS); }
+
+    Script LockingScript(uint32_t key) const {
+        return Script::CreateP2PKH(keys_[key].GetPublicKey().GetHash160());
+    }
+
+    std::vector<KeyPair> keys_;
+    std::vector<std::vector<uint8_t>> pubkeys_;
+    std::vector<OutPoint> outpoints_;
+};
+
+Block Seal(const BlockHash& prev, int height, std::vector<TransactionRef> txs,
+           const consensus::Params& params) {
+    MutableTransaction coinbase;
+    coinbase.vin.push_back(TxIn(OutPoint()));
+    coinbase.vin[0].scriptSig << static_cast<int64_t>(height) << static_cast<int64_t>(0);
+    coinbase.vout.emplace_back(50 * COIN, Script() << OP_TRUE);
+    txs.insert(txs.begin(), MakeTransactionRef(std::move(coinbase)));
+
+    Block block;
+    block.nVersion = 1;
+    block.hashPrevBlock = prev;
+    block.nTime = 1700000000 + height * 30;
+    block.nBits = 0x207fffff;
+    block.vtx = std::move(txs);
+    block.hashMerkleRoot = block.ComputeMerkleRoot();
+    while (!consensus::CheckProofOfWork(block.GetHash(), block.nBits, params)) {
+        ++block.nNonce;
+    }
+    return block;
+}
+
+/// When each item entered its first node, and how long the others took
+class Arrivals {
+public:
+    void Start(const Hash256& hash, int origin) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_[hash] = {Clock::now(), origin};
+    }
+
+    void Arrive(const Hash256& hash, int node) {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = started_.find(hash);
+        if (it == started_.end() || it->second.origin == node) {
+            return;
+        }
+        latencies_.push_back(std::chrono::duration<double, std::milli>(now - it->second.time)
+                                 .count());
+    }
+
+    size_t Count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return latencies_.size();
+    }
+
+    /// Sorted latencies, cleared for the next scenario
+    std::vector<double> Take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<double> result = std::move(latencies_);
+        latencies_.clear();
+        started_.clear();
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    struct Origin {
+        Clock::time_point time;
+        int origin;
+    };
+    mutable std::mutex mutex_;
+    std::unordered_map<Hash256, Origin, SaltedHash256Hasher> started_;
+    std::vector<double> latencies_;
+};
+
+/// One node: chain state, mempool and the network stack around them
+struct Node {
+    int index{0};
+    std::filesystem::path dir;
+    CoinsViewMemory coins;
+    std::unique_ptr<db::BlockDB> blockDB;
+    std::unique_ptr<ChainStateManager> chainman;
+    std::unique_ptr<Mempool> mempool;
+    std::unique_ptr<ConnectionManager> connman;
+    std::unique_ptr<BlockSynchronizer> syncman;
+    std::unique_ptr<MessageProcessor> msgproc;
+
+    ~Node() {
+        if (msgproc) msgproc->Stop();
+        if (syncman) syncman->Stop();
+        if (connman) connman->Stop();
+    }
+
+    int Height() const { return chainman->GetActiveHeight(); }
+
+    size_t EstablishedPeers() const {
+        size_t count = 0;
+        for (const auto& peer : connman->GetAllPeers()) {
+            count += peer && peer->IsEstablished();
+        }
+        return count;
+    }
+
+    /// A block made here: connect it and relay it, as a miner would
+    bool SubmitBlock(const Block& block) {
+        if (!chainman->ProcessNewBlock(block)) {
+            return false;
+        }
+        BlockIndex* tip = chainman->GetActiveTip();
+        mempool->RemoveForBlock(block.vtx, static_cast<uint32_t>(tip->nHeight));
+        msgproc->BlockConnected(block);
+        syncman->SetChainHeight(tip->nHeight);
+        msgproc->SetChainHeight(tip->nHeight);
+        msgproc->RelayBlock(block);
+        return true;
+    }
+};
+
+/// Build a node on its own directory and start its network stack
+std::unique_ptr<Node> StartNode(int index, const std::filesystem::path& root,
+                                const consensus::Params& params, const Block& genesis,
+                                const Funding& funding, const Config& config,
+                                Arrivals& txArrivals, Arrivals& blockArrivals) {
+    auto node = std::make_unique<Node>();
+    Node& n = *node;
+    n.index = index;
+    n.dir = root / ("node" + std::to_string(index));
+    std::filesystem::create_directories(n.dir);
+
+    funding.Fund(n.coins);
+    n.blockDB = std::make_unique<db::BlockDB>(n.dir);
+    n.chainman = std::make_unique<ChainStateManager>(params);
+    n.chainman->SetBlockDB(n.blockDB.get());
+    n.chainman->Initialize(&n.coins);
+    if (!n.chainman->ProcessNewBlock(genesis)) {
+        return nullptr;
+    }
+    n.chainman->RegisterBlockConnected([&blockArrivals, index](const Block& block,
+                                                               const BlockIndex*) {
+        blockArrivals.Arrive(block.GetHash(), index);
+    });
+    n.mempool = std::make_unique<Mempool>();
+    n.mempool->SetNotifyAdded([&txArrivals, index](const TransactionRef& tx) {
+        txArrivals.Arrive(tx->GetHash(), index);
+    });
+
+    ConnectionManagerOptions connOptions;
+    connOptions.listenPort = 0;
+    n.connman = std::make_unique<ConnectionManager>(connOptions);
+    n.syncman = std::make_unique<BlockSynchronizer>();
+
+    MessageProcessorOptions msgOptions;
+    msgOptions.processingIntervalMs = config.intervalMs;
+    msgOptions.workerThreads = config.workers;
+    msgOptions.txReconciliation = config.reconciliation;
+    n.msgproc = std::make_unique<MessageProcessor>(msgOptions);
+    n.msgproc->Initialize(n.connman.get(), n.syncman.get());
+    n.msgproc->SetMempool(n.mempool.get());
+    n.msgproc->SetChainManager(n.chainman.get());
+    n.msgproc->SetCoinsView(&n.chainman->GetActiveChainState().GetCoins());
+    n.msgproc->SetBlockDB(n.blockDB.get());
+    n.msgproc->SetChainHeight(n.Height());
+
+    // As StartNetwork
+    n.syncman->SetRequestCallback([&n](Peer::Id peerId, const std::string& command,
+                                       const std::vector<uint8_t>& payload) {
+        if (auto peer = n.connman->GetPeer(peerId)) {
+            peer->QueueSend(CreateMessage(NetworkMagic::MAINNET, command, payload));
+        }
+    });
+    n.syncman->SetBlockCallback([&n](const Block& block, Peer::Id fromPeer) -> bool {
+        bool accepted = n.chainman->ProcessNewBlock(block);
+        BlockIndex* tip = n.chainman->GetActiveTip();
+        if (accepted && tip && tip->GetBlockHash() == block.GetHash()) {
+            n.mempool->RemoveForBlock(block.vtx, static_cast<uint32_t>(tip->nHeight));
+            n.msgproc->BlockConnected(block);
+        }
+        if (accepted) {
+            if (tip) {
+                n.syncman->SetChainHeight(tip->nHeight);
+                n.msgproc->SetChainHeight(tip->nHeight);
+            }
+            n.msgproc->RelayBlock(block, fromPeer);
+        }
+        return accepted;
+    });
+    n.syncman->SetHeaderCallback([&n](const std::vector<BlockHeader>& headers,
+                                      const std::vector<BlockHash>& hashes,
+                                      Peer::Id) -> HeadersOutcome {
+        HeadersOutcome outcome;
+        consensus::ValidationState state;
+        outcome.accepted = n.chainman->ProcessBlockHeaders(headers, state, &hashes);
+        for (size_t i = 0; i < outcome.accepted; ++i) {
+            BlockIndex* pindex = n.chainman->LookupBlockIndex(hashes[i]);
+            if (pindex && !pindex->HaveData()) {
+                outcome.missingBlocks.push_back(hashes[i]);
+            }
+        }
+        if (BlockIndex* best = n.chainman->GetBestHeader()) {
+            outcome.bestHeaderHeight = best->nHeight;
+        }
+        return outcome;
+    });
+    n.connman->SetDisconnectedCallback([&n](Peer::Id id, DisconnectReason) {
+        n.syncman->OnPeerDisconnected(id);
+        n.msgproc->PeerDisconnected(id);
+    });
+
+    if (!n.connman->Start() || n.connman->GetListenPort() == 0 || !n.msgproc->Start()) {
+        return nullptr;
+    }
+    n.syncman->Start();
+    return node;
+}
+
+bool Connect(Node& from, const Node& to) {
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    return from.connman->ConnectTo(NetService(NetAddress(loopback), to.connman->GetListenPort())) >= 0;
+}
+
+/// Poll until done() or the deadline
+bool WaitFor(const std::function<bool()>& done, const Clock::time_point& deadline) {
+    while (!done()) {
+        if (Clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+double CpuSeconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+           usage.ru_stime.tv_usec / 1e6;
+}
+
+/// Counters across all nodes, taken before and after a scenario
+struct Snapshot {
+    Clock::time_point time;
+    double cpu{0};
+    uint64_t messages{0};
+    uint64_t bytesSent{0};
+    uint64_t bytesCopied{0};
+    size_t peers{0};
+
+    static Snapshot Take(const std::vector<std::unique_ptr<Node>>& nodes) {
+        Snapshot snap;
+        snap.time = Clock::now();
+        snap.cpu = CpuSeconds();
+        snap.bytesCopied = GetNetworkBytesCopied();
+        for (const auto& node : nodes) {
+            snap.messages += node->msgproc->GetStats().messagesProcessed;
+            snap.bytesSent += node->connman->GetTotalBytesSent();
+            snap.peers += node->connman->GetPeerCount();
+        }
+        return snap;
+    }
+};
+
+void Report(const char* name, bool ok, size_t items, const Snapshot& before,
+            const Snapshot& after, std::vector<double> latencies) {
+    double seconds = std::chrono::duration<double>(after.time - before.time).count();
+    uint64_t sent = after.bytesSent - before.bytesSent;
+    uint64_t messages = after.messages - before.messages;
+    auto quantile = [&](double q) {
+        if (latencies.empty()) return 0.0;
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(q * latencies.size()))];
+    };
+    double cpu = after.cpu - before.cpu;
+    size_t peers = std::max<size_t>(1, after.peers);
+    std::printf("{\"name\":\"%s\",\"ok\":%s,\"items\":%zu,\"seconds\":%.3f,"
+                "\"messages_per_sec\":%.1f,\"bytes_sent\":%llu,\"copied_per_byte_sent\":%.3f,"
+                "\"latency_ms_p50\":%.2f,\"latency_ms_p90\":%.2f,\"latency_ms_p99\":%.2f,"
+                "\"latency_ms_max\":%.2f,\"cpu_ms_per_peer\":%.2f,"
+                "\"cpu_pct_per_peer\":%.2f}\n",
+                name, ok ? "true" : "false", items, seconds,
+                seconds > 0 ? messages / seconds : 0.0, static_cast<unsigned long long>(sent),
+                sent > 0 ? static_cast<double>(after.bytesCopied - before.bytesCopied) / sent : 0.0,
+                quantile(0.5), quantile(0.9), quantile(0.99),
+                latencies.empty() ? 0.0 : latencies.back(), cpu * 1000 / peers,
+                seconds > 0 ? cpu * 100 / seconds / peers : 0.0);
+    std::fflush(stdout);
+}
+
+bool ParseInt(const char* arg, const char* name, int& value) {
+    size_t len = std::strlen(name);
+    if (std::strncmp(arg, name, len) != 0) {
+        return false;
+    }
+    value = std::atoi(arg + len);
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        if (ParseInt(argv[i], "--nodes=", config.nodes) ||
+            ParseInt(argv[i], "--peers=", config.peers) ||
+            ParseInt(argv[i], "--txs=", config.txs) ||
+            ParseInt(argv[i], "--blocks=", config.blocks) ||
+            ParseInt(argv[i], "--workers=", config.workers) ||
+            ParseInt(argv[i], "--interval=", config.intervalMs) ||
+            ParseInt(argv[i], "--timeout=", config.timeoutSec)) {
+            continue;
+        }
+        if (std::strcmp(argv[i], "--no-reconciliation") == 0) {
+            config.reconciliation = false;
+            continue;
+        }
+        std::fprintf(stderr, "usage: %s [--nodes=N] [--peers=N] [--txs=N] [--blocks=N] "
+                     "[--workers=N] [--interval=MS] [--timeout=S] [--no-reconciliation]\n",
+                     argv[0]);
+        return 1;
+    }
+    if (config.nodes < 2 || config.peers < 1 || config.peers >= config.nodes ||
+        config.txs < 0 || config.blocks < 1 || config.intervalMs < 1) {
+        std::fprintf(stderr, "need --nodes >= 2, 1 <= --peers < --nodes, --blocks >= 1 "
+                     "and --interval >= 1\n");
+        return 1;
+    }
+    util::Logger::Instance().SetLevel(util::LogLevel::Error);
+
+    std::printf("{\"suite\":\"p2p\",\"nodes\":%d,\"peers\":%d,\"txs\":%d,\"blocks\":%d,"
+                "\"workers\":%d,\"interval_ms\":%d,\"reconciliation\":%s}\n",
+                config.nodes, config.peers, config.txs, config.blocks, config.workers,
+                config.intervalMs, config.reconciliation ? "true" : "false");
+    std::fflush(stdout);
+
+    consensus::Params params = consensus::Params::RegTest();
+    Block genesis = Seal(BlockHash(), 0, {}, params);
+    params.hashGenesisBlock = genesis.GetHash();
+    Funding funding(config.txs);
+    std::vector<TransactionRef> txs;
+    for (int i = 0; i < config.txs; ++i) {
+        txs.push_back(funding.Spend(static_cast<size_t>(i)));
+    }
+
+    std::filesystem::path root = std::filesystem::temp_directory_path() /
+                                 ("shurium_bench_p2p_" + std::to_string(getpid()));
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+    auto timeout = std::chrono::seconds(config.timeoutSec);
+    int status = 0;
+    {
+        Arrivals txArrivals;
+        Arrivals blockArrivals;
+        std::vector<std::unique_ptr<Node>> nodes;
+        for (int i = 0; i < config.nodes && status == 0; ++i) {
+            nodes.push_back(StartNode(i, root, params, genesis, funding, config, txArrivals,
+                                      blockArrivals));
+            if (!nodes.back()) {
+                std::fprintf(stderr, "node %d failed to start\n", i);
+                nodes.pop_back();
+                status = 1;
+            }
+        }
+        for (int i = 0; i < config.nodes && status == 0; ++i) {
+            for (int k = 1; k <= config.peers; ++k) {
+                if (!Connect(*nodes[i], *nodes[(i + k) % config.nodes])) {
+                    std::fprintf(stderr, "node %d could not connect\n", i);
+                    status = 1;
+                }
+            }
+        }
+        size_t perNode = static_cast<size_t>(config.peers) * 2;
+        if (status == 0 && !WaitFor([&]() {
+                for (const auto& node : nodes) {
+                    if (node->EstablishedPeers() < perNode) return false;
+                }
+                return true;
+            }, Clock::now() + timeout)) {
+            std::fprintf(stderr, "handshakes did not complete\n");
+            status = 1;
+        }
+
+        // Transactions enter round robin and must reach every other node
+        if (status == 0) {
+            Snapshot before = Snapshot::Take(nodes);
+            for (size_t i = 0; i < txs.size(); ++i) {
+                Node& origin = *nodes[i % nodes.size()];
+                txArrivals.Start(txs[i]->GetHash(), origin.index);
+                MempoolAcceptResult result = AcceptToMempool(
+                    txs[i], *origin.mempool, origin.chainman->GetActiveChainState().GetCoins(),
+                    origin.Height());
+                if (!result.IsValid()) {
+                    std::fprintf(stderr, "tx %zu rejected: %s\n", i, result.rejectReason.c_str());
+                    status = 1;
+                    break;
+                }
+                origin.msgproc->RelayTransaction(txs[i]->GetHash());
+            }
+            size_t expected = txs.size() * (nodes.size() - 1);
+            bool ok = status == 0 && WaitFor([&]() { return txArrivals.Count() >= expected; },
+                                             Clock::now() + timeout);
+            Report("tx_flood", ok, txs.size(), before, Snapshot::Take(nodes), txArrivals.Take());
+            status = ok ? 0 : 1;
+        }
+
+        // Blocks of the flooded transactions, from a different node each time
+        std::vector<Block> chain;
+        if (status == 0) {
+            Snapshot before = Snapshot::Take(nodes);
+            size_t perBlock = (txs.size() + config.blocks - 1) / config.blocks;
+            BlockHash prev = genesis.GetHash();
+            bool ok = true;
+            for (int b = 0; b < config.blocks && ok; ++b) {
+                size_t first = std::min(txs.size(), b * perBlock);
+                size_t last = std::min(txs.size(), first + perBlock);
+                chain.push_back(Seal(prev, b + 1, {txs.begin() + first, txs.begin() + last},
+                                     params));
+                prev = chain.back().GetHash();
+                size_t expected = static_cast<size_t>(b + 1) * (nodes.size() - 1);
+                Node& origin = *nodes[b % nodes.size()];
+                blockArrivals.Start(prev, origin.index);
+                ok = origin.SubmitBlock(chain.back()) &&
+                     WaitFor([&]() { return blockArrivals.Count() >= expected; },
+                             Clock::now() + timeout);
+            }
+            Report("blocks", ok, chain.size(), before, Snapshot::Take(nodes),
+                   blockArrivals.Take());
+            status = ok ? 0 : 1;
+        }
+
+        // A new node catching up from node 0
+        if (status == 0) {
+            Snapshot before = Snapshot::Take(nodes);
+            for (const Block& block : chain) {
+                blockArrivals.Start(block.GetHash(), nodes[0]->index);
+            }
+            nodes.push_back(StartNode(config.nodes, root, params, genesis, funding, config,
+                                      txArrivals, blockArrivals));
+            bool ok = nodes.back() != nullptr;
+            if (!ok) {
+                nodes.pop_back();
+            }
+            ok = ok && Connect(*nodes.back(), *nodes[0]) &&
+                 WaitFor([&]() { return blockArrivals.Count() >= chain.size(); },
+                         Clock::now() + timeout);
+            Report("ibd", ok, chain.size(), before, Snapshot::Take(nodes), blockArrivals.Take());
+            status = ok ? 0 : 1;
+        }
+
+        // Stop everything before any node goes away
+        for (const auto& node : nodes) {
+            node->msgproc->Stop();
+        }
+        for (const auto& node : nodes) {
+            node->connman->Stop();
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    return status;
+}
@@ -0,0 +1,371 @@
+// SHURIUM - Script Verification Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Replays a corpus of signed spends of the script shapes blocks are made
+// of through VerifyScript and reports ns/input: P2PKH, P2PK, 2-of-3
+// multisig in P2SH, and P2SH timelocks with CHECKLOCKTIMEVERIFY and
+// CHECKSEQUENCEVERIFY. Every input of a corpus has its own key. "warm" runs
+// keep the parsed keys in the public key cache between passes, as for keys
+// seen again in mempool and block; "cold" runs clear it before each pass,
+// as for keys seen for the first time.
+//
+// Output is JSON lines like the other suites. In builds with
+// SHURIUM_SCRIPT_PROFILE, --profile adds one line per executed opcode with
+// counts and cycles over the whole run (the same data the getscriptprofile
+// RPC reports for a running node).
+//
+// Usage: shurium_bench_script [--filter=SUBSTRING] [--min-time=SECONDS] [--profile]
+
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/crypto/keys.h"
+#include "shurium/crypto/ripemd160.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/script/interpreter.h"
+#include "shurium/script/profile.h"
+#include "shurium/script/pubkeycache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SHURIUM_BENCH_TSC 1
+#endif
+
+using namespace shurium;
+
+namespace {
+
+double g_minSeconds = 0.5;
+const char* g_filter = nullptr;
+
+/// Inputs per corpus; each has its own key
+constexpr size_t INPUTS = 200;
+
+constexpr Amount INPUT_AMOUNT = 50000;
+constexpr int64_t LOCK_HEIGHT = 500000;
+constexpr int64_t RELATIVE_LOCK = 10;
+
+uint64_t ReadCycles() {
+#ifdef SHURIUM_BENCH_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/// Key number i of the corpus, derived rather than random so runs repeat
+KeyPair DeriveKey(uint32_t i) {
+    uint8_t seed[8] = {'s', 'c', 'r', 'i', 'p', 't',
+                       static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+    Hash256 secret = SHA256Hash(seed, sizeof(seed));
+    return KeyPair(PrivateKey(secret.data()));
+}
+
+/// One transaction whose inputs each spend a scriptPubKey of one shape
+struct Corpus {
+    std::string name;
+    std::unique_ptr<Transaction> tx;
+    std::vector<Script> scriptPubKeys;
+    std::unique_ptr<PrecomputedTransactionData> txdata;
+};
+
+/**
+ * Locking side of input i: the scriptPubKey it spends, and the script its
+ * signatures commit to (the redeem script for P2SH).
+ */
+struct Lock {
+    Script scriptPubKey;
+    Script scriptCode;
+};
+
+using Signatures = std::vector<std::vector<uint8_t>>;
+
+/**
+ * Build a corpus. lock gives the scripts of an input and adds the keys
+ * that sign it to signers; unlock makes the scriptSig from their
+ * signatures over scriptCode.
+ */
+Corpus MakeCorpus(const std::string& name, uint32_t nLockTime, uint32_t nSequence,
+                  const std::function<Lock(std::vector<KeyPair>& signers)>& lock,
+                  const std::function<Script(const Signatures&, const std::vector<KeyPair>&,
+                                             const Lock&)>& unlock) {
+    MutableTransaction mtx;
+    mtx.version = 2;
+    mtx.nLockTime = nLockTime;
+    for (size_t i = 0; i < INPUTS; ++i) {
+        TxHash prev;
+        prev[0] = static_cast<uint8_t>(i);
+        prev[1] = static_cast<uint8_t>(i >> 8);
+        mtx.vin.emplace_back(OutPoint(prev, 0), Script(), nSequence);
+    }
+    mtx.vout.emplace_back(Amount(INPUTS * INPUT_AMOUNT / 2), Script::CreateP2PKH(Hash160()));
+
+    // Legacy signature hashes leave out every scriptSig, so signing the
+    // unsigned transaction signs the final one
+    Transaction unsignedTx(mtx);
+    PrecomputedTransactionData unsignedData(unsignedTx);
+    std::vector<Lock> locks;
+    for (size_t i = 0; i < INPUTS; ++i) {
+        // MINIMALDATA also holds pushed hashes, keys and signatures to
+        // minimal number encoding, so now and then a key's spend is not
+        // standard; such keys are skipped, as a wallet would have to
+        while (true) {
+            std::vector<KeyPair> signers;
+            Lock l = lock(signers);
+            Hash256 sighash = SignatureHash(unsignedTx, static_cast<unsigned int>(i),
+                                            l.scriptCode, SIGHASH_ALL);
+            Signatures signatures;
+            for (const KeyPair& key : signers) {
+                std::vector<uint8_t> signature = key.Sign(sighash);
+                signature.push_back(SIGHASH_ALL);
+                signatures.push_back(std::move(signature));
+            }
+            Script scriptSig = unlock(signatures, signers, l);
+            TransactionSignatureChecker checker(&unsignedTx, static_cast<unsigned int>(i),
+                                                INPUT_AMOUNT, unsignedData);
+            if (VerifyScript(scriptSig, l.scriptPubKey, ScriptFlags::STANDARD_VERIFY_FLAGS,
+                             checker)) {
+                mtx.vin[i].scriptSig = std::move(scriptSig);
+                locks.push_back(std::move(l));
+                break;
+            }
+        }
+    }
+
+    Corpus corpus;
+    corpus.name = name;
+    corpus.tx = std::make_unique<Transaction>(mtx);
+    corpus.txdata = std::make_unique<PrecomputedTransactionData>(*corpus.tx);
+    for (const Lock& l : locks) {
+        corpus.scriptPubKeys.push_back(l.scriptPubKey);
+    }
+    return corpus;
+}
+
+Script PushAll(const Signatures& pushes) {
+    Script script;
+    for (const auto& push : pushes) {
+        script << push;
+    }
+    return script;
+}
+
+Lock PayToScriptHash(const Script& redeemScript) {
+    return {Script::CreateP2SH(Hash160FromData(redeemScript.data(), redeemScript.size())),
+            redeemScript};
+}
+
+Script WithRedeemScript(Script scriptSig, const Lock& l) {
+    scriptSig << std::vector<uint8_t>(l.scriptCode.begin(), l.scriptCode.end());
+    return scriptSig;
+}
+
+std::vector<Corpus> BuildCorpora() {
+    std::vector<Corpus> corpora;
+    uint32_t nextKey = 0;
+    auto key = [&]() { return DeriveKey(nextKey++); };
+    auto pubkey = [](const KeyPair& k) { return k.GetPublicKey().ToVector(); };
+
+    corpora.push_back(MakeCorpus("p2pkh", 0, TxIn::SEQUENCE_FINAL,
+        [&](std::vector<KeyPair>& signers) {
+            signers.push_back(key());
+            Script spk = Script::CreateP2PKH(signers[0].GetPublicKey().GetHash160());
+            return Lock{spk, spk};
+        },
+        [&](const Signatures& sigs, const std::vector<KeyPair>& signers, const Lock&) {
+            return PushAll({sigs[0], pubkey(signers[0])});
+        }));
+
+    corpora.push_back(MakeCorpus("p2pk", 0, TxIn::SEQUENCE_FINAL,
+        [&](std::vector<KeyPair>& signers) {
+            signers.push_back(key());
+            Script spk;
+            spk << pubkey(signers[0]) << OP_CHECKSIG;
+            return Lock{spk, spk};
+        },
+        [](const Signatures& sigs, const std::vector<KeyPair>&, const Lock&) {
+            return PushAll({sigs[0]});
+        }));
+
+    corpora.push_back(MakeCorpus("p2sh-multisig-2of3", 0, TxIn::SEQUENCE_FINAL,
+        [&](std::vector<KeyPair>& signers) {
+            KeyPair keys[3] = {key(), key(), key()};
+            Script redeem;
+            redeem << OP_2 << pubkey(keys[0]) << pubkey(keys[1]) << pubkey(keys[2])
+                   << OP_3 << OP_CHECKMULTISIG;
+            signers.push_back(keys[0]);
+            signers.push_back(keys[2]);
+            return PayToScriptHash(redeem);
+        },
+        [](const Signatures& sigs, const std::vector<KeyPair>&, const Lock& l) {
+            Script scriptSig;
+            scriptSig << OP_0 << sigs[0] << sigs[1];
+            return WithRedeemScript(scriptSig, l);
+        }));
+
+    corpora.push_back(MakeCorpus("p2sh-cltv", static_cast<uint32_t>(LOCK_HEIGHT + 1000),
+                                 TxIn::MAX_SEQUENCE_NONFINAL,
+        [&](std::vector<KeyPair>& signers) {
+            signers.push_back(key());
+            Script redeem;
+            redeem << ScriptNum(LOCK_HEIGHT) << OP_CHECKLOCKTIMEVERIFY << OP_DROP
+                   << pubkey(signers[0]) << OP_CHECKSIG;
+            return PayToScriptHash(redeem);
+        },
+        [](const Signatures& sigs, const std::vector<KeyPair>&, const Lock& l) {
+            return WithRedeemScript(PushAll({sigs[0]}), l);
+        }));
+
+    corpora.push_back(MakeCorpus("p2sh-csv", 0, static_cast<uint32_t>(RELATIVE_LOCK),
+        [&](std::vector<KeyPair>& signers) {
+            signers.push_back(key());
+            Script redeem;
+            redeem << ScriptNum(RELATIVE_LOCK) << OP_CHECKSEQUENCEVERIFY << OP_DROP
+                   << OP_DUP << OP_HASH160 << signers[0].GetPublicKey().GetHash160()
+                   << OP_EQUALVERIFY << OP_CHECKSIG;
+            return PayToScriptHash(redeem);
+        },
+        [&](const Signatures& sigs, const std::vector<KeyPair>& signers, const Lock& l) {
+            return WithRedeemScript(PushAll({sigs[0], pubkey(signers[0])}), l);
+        }));
+
+    return corpora;
+}
+
+/// Verify every input of corpus once, false on the first failure
+bool VerifyAll(const Corpus& corpus, ScriptError* error) {
+    const Transaction& tx = *corpus.tx;
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        TransactionSignatureChecker checker(&tx, static_cast<unsigned int>(i), INPUT_AMOUNT,
+                                            *corpus.txdata);
+        if (!VerifyScript(tx.GetDecodedScriptSig(i), corpus.scriptPubKeys[i],
+                          ScriptFlags::STANDARD_VERIFY_FLAGS, checker, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Time passes over corpus for at least the minimum time and print a line
+void Run(const Corpus& corpus, bool cold) {
+    std::string name = "verify/" + corpus.name + (cold ? "/cold" : "/warm");
+    if (g_filter && name.find(g_filter) == std::string::npos) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+    ScriptError error;
+
+    // Warm caches (and, for warm runs, the public key cache) before timing
+    VerifyAll(corpus, &error);
+
+    uint64_t passes = 0;
+    uint64_t cycles = 0;
+    double elapsed = 0;
+    do {
+        if (cold) {
+            GetPubKeyCache().Clear();
+        }
+        auto start = Clock::now();
+        uint64_t startCycles = ReadCycles();
+        VerifyAll(corpus, &error);
+        cycles += ReadCycles() - startCycles;
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        ++passes;
+    } while (elapsed < g_minSeconds);
+
+    double inputs = static_cast<double>(passes * corpus.tx->vin.size());
+    std::printf("{\"name\":\"%s\",\"inputs_per_sec\":%.1f,\"ns_per_input\":%.1f",
+                name.c_str(), inputs / elapsed, elapsed * 1e9 / inputs);
+#ifdef SHURIUM_BENCH_TSC
+    std::printf(",\"cycles_per_input\":%.1f", cycles / inputs);
+#else
+    (void)cycles;
+    std::printf(",\"cycles_per_input\":null");
+#endif
+    std::printf("}\n");
+    std::fflush(stdout);
+}
+
+void PrintProfile() {
+    ScriptProfile profile = GetScriptProfile();
+    for (size_t op = 0; op < profile.opcodes.size(); ++op) {
+        const ScriptProfileEntry& entry = profile.opcodes[op];
+        if (entry.executions == 0) {
+            continue;
+        }
+        std::printf("{\"opcode\":\"%s\",\"executions\":%llu,\"cycles\":%llu,"
+                    "\"cycles_per_execution\":%.1f}\n",
+                    ScriptProfileOpName(static_cast<uint8_t>(op)).c_str(),
+                    static_cast<unsigned long long>(entry.executions),
+                    static_cast<unsigned long long>(entry.cycles),
+                    static_cast<double>(entry.cycles) / entry.executions);
+    }
+    static const char* const kinds[] = {"interpreted", "p2pk", "p2pkh", "p2sh"};
+    for (size_t kind = 0; kind < profile.templates.size(); ++kind) {
+        const ScriptProfileEntry& entry = profile.templates[kind];
+        std::printf("{\"verification\":\"%s\",\"executions\":%llu,\"cycles\":%llu}\n",
+                    kinds[kind], static_cast<unsigned long long>(entry.executions),
+                    static_cast<unsigned long long>(entry.cycles));
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bool profile = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            g_filter = argv[i] + 9;
+        } else if (std::strncmp(argv[i], "--min-time=", 11) == 0) {
+            g_minSeconds = std::atof(argv[i] + 11);
+        } else if (std::strcmp(argv[i], "--profile") == 0) {
+            profile = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS] [--profile]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"script\",\"inputs_per_corpus\":%zu,\"script_profile\":%s,\"tsc\":%s}\n",
+                INPUTS, ScriptProfilingEnabled() ? "true" : "false",
+#ifdef SHURIUM_BENCH_TSC
+                "true"
+#else
+                "false"
+#endif
+    );
+
+    std::vector<Corpus> corpora = BuildCorpora();
+    for (const Corpus& corpus : corpora) {
+        ScriptError error = ScriptError::OK;
+        if (!VerifyAll(corpus, &error)) {
+            std::fprintf(stderr, "corpus %s does not verify: %s\n", corpus.name.c_str(),
+                         ScriptErrorString(error).c_str());
+            return 1;
+        }
+    }
+
+    ResetScriptProfile();
+    for (const Corpus& corpus : corpora) {
+        Run(corpus, false);
+        Run(corpus, true);
+    }
+    if (profile) {
+        if (!ScriptProfilingEnabled()) {
+            std::fprintf(stderr, "--profile needs a build with -DSHURIUM_SCRIPT_PROFILE=ON\n");
+            return 1;
+        }
+        PrintProfile();
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+// SHURIUM - secp256k1 Field Benchmark
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Reports the cost of the native field and scalar primitives that every EC
+// operation is built from: 5x52 multiplication and squaring (int128 or the
+// BMI2/ADX assembly, whichever this build selected), safegcd inversion next
+// to the Fermat exponentiation it replaced, and the public FieldElement
+// wrappers. With OpenSSL, the BIGNUM operations FieldElement ran on before
+// are listed for comparison. Output is one line per operation, in ns/op.
+
+#include "shurium/crypto/secp256k1.h"
+#include "crypto/secp256k1_field.h"
+#include "crypto/secp256k1_scalar.h"
+
+#include <chrono>
+#include <cstdio>
+
+#ifdef SHURIUM_USE_OPENSSL
+#include <openssl/bn.h>
+#endif
+
+using namespace shurium::secp256k1;
+using namespace shurium::secp256k1::field;
+
+namespace {
+
+constexpr double MIN_SECONDS = 0.5;
+
+/// Run fn repeatedly for at least MIN_SECONDS; returns nanoseconds per call
+template <typename Fn>
+double Measure(Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    uint64_t calls = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        for (int i = 0; i < 256; ++i) {
+            fn();
+        }
+        calls += 256;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < MIN_SECONDS);
+    return elapsed * 1e9 / calls;
+}
+
+/// a^(p-2) by the addition chain FeInv used before safegcd
+Fe FeInvFermat(const Fe& a) {
+    Fe x2 = FeMul(FeSqr(a), a);
+    Fe x3 = FeMul(FeSqr(x2), a);
+    Fe x6 = FeMul(FeSqrN(x3, 3), x3);
+    Fe x9 = FeMul(FeSqrN(x6, 3), x3);
+    Fe x11 = FeMul(FeSqrN(x9, 2), x2);
+    Fe x22 = FeMul(FeSqrN(x11, 11), x11);
+    Fe x44 = FeMul(FeSqrN(x22, 22), x22);
+    Fe x88 = FeMul(FeSqrN(x44, 44), x44);
+    Fe x176 = FeMul(FeSqrN(x88, 88), x88);
+    Fe x220 = FeMul(FeSqrN(x176, 44), x44);
+    Fe x223 = FeMul(FeSqrN(x220, 3), x3);
+    Fe t = FeMul(FeSqrN(x223, 23), x22);
+    t = FeMul(FeSqrN(t, 5), a);
+    t = FeMul(FeSqrN(t, 3), x2);
+    return FeMul(FeSqrN(t, 2), a);
+}
+
+void Report(const char* name, double ns) {
+    std::printf("%-24s %12.1f\n", name, ns);
+}
+
+} // namespace
+
+int main() {
+#ifdef SHURIUM_SECP256K1_FIELD_ASM
+    std::printf("# field: 5x52, BMI2/ADX assembly\n");
+#else
+    std::printf("# field: 5x52, int128\n");
+#endif
+    std::printf("%-24s %12s\n", "operation", "ns/op");
+
+    Fe a = FeFromLimbs64(0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL,
+                         0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL);
+    Fe b = FeFromLimbs64(0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL,
+                         0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL);
+
+    // Each result feeds the next call, so latency is what gets measured
+    Report("fe_mul", Measure([&]() { a = FeMul(a, b); }));
+    Report("fe_sqr", Measure([&]() { a = FeSqr(a); }));
+    Report("fe_add", Measure([&]() { a = FeAdd(a, b); }));
+    Report("fe_inv (safegcd)", Measure([&]() { a = FeAdd(FeInv(a), b); }));
+    Report("fe_inv (fermat)", Measure([&]() { a = FeAdd(FeInvFermat(a), b); }));
+
+    scalar::Sc k = {{0x2ABB739ABD2280EEULL, 0x3FD25E8CD0364141ULL, 1, 2}};
+    scalar::Sc one = {{1, 0, 0, 0}};
+    Report("sc_inv (safegcd)", Measure([&]() { k = scalar::ScAdd(scalar::ScInv(k), one); }));
+
+    uint8_t bytes[32];
+    FeToBytes(bytes, a);
+    FieldElement x(bytes);
+    FeToBytes(bytes, b);
+    FieldElement y(bytes);
+    Report("FieldElement::operator*", Measure([&]() { x = x * y; }));
+    Report("FieldElement::Inverse", Measure([&]() { x = x.Inverse() + y; }));
+
+#ifdef SHURIUM_USE_OPENSSL
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
+    BIGNUM* bx = BN_bin2bn(x.data(), 32, nullptr);
+    BIGNUM* by = BN_bin2bn(y.data(), 32, nullptr);
+    BIGNUM* r = BN_new();
+    Report("BN_mod_mul", Measure([&]() { BN_mod_mul(bx, bx, by, p, ctx); }));
+    Report("BN_mod_inverse", Measure([&]() {
+        BN_mod_inverse(r, bx, p, ctx);
+        BN_mod_add(bx, r, by, p, ctx);
+    }));
+    BN_free(r);
+    BN_free(by);
+    BN_free(bx);
+    BN_free(p);
+    BN_CTX_free(ctx);
+#endif
+
+    // Keeps the compiler from discarding the results
+    uint8_t kBytes[32];
+    FeToBytes(bytes, a);
+    scalar::ScToBytes(kBytes, k);
+    return (bytes[0] ^ kBytes[0]) == 0x42 && x.IsZero() ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+// SHURIUM - Background Block Filter Indexer
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the background thread that keeps the optional compact
+// block filter index (-blockfilterindex) in step with the active chain.
+
+#ifndef SHURIUM_CHAIN_BLOCKFILTERINDEXER_H
+#define SHURIUM_CHAIN_BLOCKFILTERINDEXER_H
+
+#include "shurium/chain/blockindex.h"
+#include "shurium/core/block.h"
+#include "shurium/core/blockfilter.h"
+#include "shurium/db/blockdb.h"
+#include "shurium/db/blockfilterdb.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace shurium {
+
+class ChainStateManager;
+namespace util { class ThreadPool; }
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Blocks read and filtered per batch while catching up
+static constexpr size_t DEFAULT_BLOCKFILTER_BATCH_BLOCKS = 256;
+
+/// Seconds between progress log lines while catching up
+static constexpr int BLOCKFILTER_PROGRESS_INTERVAL = 30;
+
+// ============================================================================
+// BlockFilterIndexer - Builds and maintains the block filter index
+// ============================================================================
+
+/// Tuning for BlockFilterIndexer
+struct BlockFilterIndexerOptions {
+    /// Threads reading blocks and building filters (0 = one per core)
+    int nThreads{0};
+
+    /// Blocks per catch-up batch; each batch is one database write
+    size_t batchBlocks{DEFAULT_BLOCKFILTER_BATCH_BLOCKS};
+};
+
+/**
+ * Keeps a db::BlockFilterIndex in step with the active chain.
+ *
+ * Works like TxIndexer: a thread resumes from the stored locator and walks
+ * the active chain in batches. A block's filter needs the scripts of the
+ * outputs it spends, so each block is read together with its undo data.
+ * Filters are built on a thread pool; their headers, each committing to
+ * the one before, are then chained in order and the batch is written with
+ * its last block as the new locator.
+ *
+ * Undo data has to come off disk in any case, so block-connected
+ * notifications only wake the thread rather than index on the caller's
+ * thread. Filters of blocks reorganized away stay in the database, keyed
+ * by hash; rewinding only moves the locator back.
+ */
+class BlockFilterIndexer {
+public:
+    BlockFilterIndexer(ChainStateManager& chainman, db::BlockDB& blockDB,
+                       db::BlockFilterIndex& filterIndex,
+                       const BlockFilterIndexerOptions& options = BlockFilterIndexerOptions());
+    ~BlockFilterIndexer();
+
+    BlockFilterIndexer(const BlockFilterIndexer&) = delete;
+    BlockFilterIndexer& operator=(const BlockFilterIndexer&) = delete;
+
+    /**
+     * Resume from the stored locator and start the sync thread.
+     * @return False if the index is disabled or already started
+     */
+    bool Start();
+
+    /// Stop the sync thread and stop following the chain
+    void Stop();
+
+    /// Whether the index has caught up with the active chain
+    bool IsSynced() const { return m_synced; }
+
+    /// Whether indexing stopped because block data could not be read
+    bool HasFailed() const { return m_failed; }
+
+    /// Last indexed block (null before the first block)
+    const BlockIndex* GetBestBlock() const;
+
+    /// Height of the last indexed block (-1 before the first block)
+    int GetBestHeight() const;
+
+    /**
+     * Wait until the index is synced.
+     * @return False on timeout, or if the indexer stopped or failed
+     */
+    bool WaitForSync(std::chrono::milliseconds timeout);
+
+    /**
+     * The filter of a block, if it has been indexed.
+     */
+    std::optional<BlockFilter> GetFilter(const BlockIndex* pindex) const;
+
+    /**
+     * Build a block's filter from the block and undo files.
+     * @return Nullopt if block or undo data cannot be read
+     */
+    static std::optional<BlockFilter> BuildFilter(const db::BlockDB& blockDB,
+                                                  const BlockIndex* pindex,
+                                                  BlockFilterType type);
+
+private:
+    ChainStateManager& m_chainman;
+    db::BlockDB& m_blockDB;
+    db::BlockFilterIndex& m_filterIndex;
+    BlockFilterIndexerOptions m_options;
+
+    /// Last indexed block and its filter header; guarded by m_mutex
+    const BlockIndex* m_best{nullptr};
+    Hash256 m_bestHeader;
+
+    /// Set by notifications the sync thread must handle; guarded by m_mutex
+    bool m_wakeup{false};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_synced{false};
+    std::atomic<bool> m_failed{false};
+    std::atomic<bool> m_stop{false};
+
+    std::unique_ptr<util::ThreadPool> m_pool;
+    std::thread m_thread;
+    int m_callbackId{-1};
+
+    /// Sync thread: catch up with the active chain, then wait for work
+    void ThreadSync();
+
+    /**
+     * Index the next batch of blocks after m_best.
+     * @return Number of blocks indexed (0 at the tip or on failure)
+     */
+    size_t SyncBatch();
+
+    /// Move the index back to pfork (sync thread only)
+    bool Rewind(const BlockIndex* pfork);
+
+    /// Block-connected notification from the chainstate
+    void BlockConnected(const Block& block, const BlockIndex* pindex);
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CHAIN_BLOCKFILTERINDEXER_H
@@ -11,11 +11,14 @@
 #include "shurium/core/types.h"
 #include "shurium/core/block.h"
 #include "shurium/core/serialize.h"
+#include "shurium/crypto/siphash.h"
 #include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <iterator>
+#include <unordered_map>
 
 namespace shurium {
 
@@ -70,6 +73,21 @@ inline uint32_t GetValidityLevel(BlockStatus status) {
     return static_cast<uint32_t>(status & BlockStatus::VALID_MASK);
 }
 
+// ============================================================================
+// BlockIndexHeader - Header fields kept outside the traversal data
+// ============================================================================
+
+/**
+ * Header fields of a block index entry that chain selection and ancestor
+ * walks never read. They live in a side table so the hot part of each
+ * BlockIndex fits in one cache line.
+ */
+struct BlockIndexHeader {
+    int32_t nVersion{0};
+    uint32_t nNonce{0};
+    Hash256 hashMerkleRoot;
+};
+
 // ============================================================================
 // BlockIndex - Index entry for a block in the chain
 // ============================================================================
@@ -80,21 +98,41 @@ inline uint32_t GetValidityLevel(BlockStatus status) {
  * This structure contains metadata about a block and its position in the
  * blockchain. The actual block data is stored separately; this just
  * contains the index information needed for chain selection and validation.
+ *
+ * Fields read by traversal and chain selection come first and fill the
+ * first 64 bytes. Entries owned by a BlockMap point into its side table for
+ * the cold header fields; standalone entries allocate their own on first
+ * write.
  */
 class BlockIndex {
 public:
-    /// Pointer to the hash of this block (owned by BlockMap)
-    const BlockHash* phashBlock{nullptr};
-    
     /// Pointer to previous block's index, or nullptr for genesis
     BlockIndex* pprev{nullptr};
     
     /// Skip pointer for efficient ancestor lookup
     BlockIndex* pskip{nullptr};
     
+    /// Pointer to the hash of this block (owned by BlockMap)
+    const BlockHash* phashBlock{nullptr};
+    
+    /// Total chain work up to and including this block
+    uint64_t nChainWork{0};
+    
     /// Height of this block (genesis = 0)
     int32_t nHeight{0};
     
+    /// Validation status
+    BlockStatus nStatus{BlockStatus::UNKNOWN};
+    
+    /// Block timestamp
+    uint32_t nTime{0};
+    
+    /// Difficulty target in compact form
+    uint32_t nBits{0};
+    
+    /// Maximum timestamp in the chain up to this block
+    uint32_t nTimeMax{0};
+    
     /// File number where block data is stored
     int32_t nFile{0};
     
@@ -104,31 +142,14 @@ public:
     /// Byte offset in the undo file
     uint32_t nUndoPos{0};
     
-    /// Total chain work up to and including this block
-    /// Using a simple uint64_t for now (may need arith_uint256 for production)
-    uint64_t nChainWork{0};
-    
     /// Number of transactions in this block (0 if unknown)
     uint32_t nTx{0};
     
-    /// Total transactions in chain up to this block
-    uint64_t nChainTx{0};
-    
-    /// Validation status
-    BlockStatus nStatus{BlockStatus::UNKNOWN};
-    
-    // Block header fields (cached for quick access)
-    int32_t nVersion{0};
-    Hash256 hashMerkleRoot;
-    uint32_t nTime{0};
-    uint32_t nBits{0};
-    uint32_t nNonce{0};
-    
     /// Sequential ID for ordering blocks received at same height
     int32_t nSequenceId{0};
     
-    /// Maximum timestamp in the chain up to this block
-    uint32_t nTimeMax{0};
+    /// Total transactions in chain up to this block
+    uint64_t nChainTx{0};
     
     // ========================================================================
     // Constructors
@@ -137,20 +158,37 @@ public:
     BlockIndex() = default;
     
     /// Construct from a block header
-    explicit BlockIndex(const BlockHeader& header)
-        : nVersion(header.nVersion),
-          hashMerkleRoot(header.hashMerkleRoot),
-          nTime(header.nTime),
-          nBits(header.nBits),
-          nNonce(header.nNonce) {}
+    explicit BlockIndex(const BlockHeader& header) { SetHeader(header); }
+    
+    ~BlockIndex() {
+        if (m_ownsHeader) delete m_header;
+    }
     
     // Prevent copies to avoid dangling pointers
     BlockIndex(const BlockIndex&) = delete;
     BlockIndex& operator=(const BlockIndex&) = delete;
     
     // Allow moves
-    BlockIndex(BlockIndex&&) = default;
-    BlockIndex& operator=(BlockIndex&&) = default;
+    BlockIndex(BlockIndex&& other) noexcept;
+    BlockIndex& operator=(BlockIndex&& other) noexcept;
+    
+    // ========================================================================
+    // Header Fields
+    // ========================================================================
+    
+    /// Copy the header fields (everything but hashPrevBlock)
+    void SetHeader(const BlockHeader& header);
+    
+    /// Use side-table storage for the cold header fields (BlockMap only)
+    void AttachHeader(BlockIndexHeader* header) {
+        if (m_ownsHeader) delete m_header;
+        m_header = header;
+        m_ownsHeader = false;
+    }
+    
+    int32_t GetVersion() const { return m_header ? m_header->nVersion : 0; }
+    uint32_t GetNonce() const { return m_header ? m_header->nNonce : 0; }
+    Hash256 GetMerkleRoot() const { return m_header ? m_header->hashMerkleRoot : Hash256(); }
     
     // ========================================================================
     // Accessors
@@ -165,12 +203,12 @@ public:
     /// Reconstruct the block header
     BlockHeader GetBlockHeader() const {
         BlockHeader header;
-        header.nVersion = nVersion;
+        header.nVersion = GetVersion();
         header.hashPrevBlock = pprev ? pprev->GetBlockHash() : BlockHash();
-        header.hashMerkleRoot = hashMerkleRoot;
+        header.hashMerkleRoot = GetMerkleRoot();
         header.nTime = nTime;
         header.nBits = nBits;
-        header.nNonce = nNonce;
+        header.nNonce = GetNonce();
         return header;
     }
     
@@ -252,6 +290,16 @@ public:
     
     /// Convert to string for debugging
     std::string ToString() const;
+    
+private:
+    /// Cold header fields (side table or owned allocation)
+    BlockIndexHeader* m_header{nullptr};
+    
+    /// Whether m_header was allocated by this entry
+    bool m_ownsHeader{false};
+    
+    /// Header storage for writes, allocating it for standalone entries
+    BlockIndexHeader& MutableHeader();
 };
 
 // ============================================================================
@@ -263,10 +311,36 @@ public:
  * 
  * This represents the active chain from genesis to the current tip.
  * Provides efficient access by height and various chain queries.
+ * 
+ * The height index is kept in fixed-size chunks allocated as the chain
+ * grows and freed as it shrinks, so a chain of tens of millions of headers
+ * never reallocates and copies the whole index, nor carries a vector's
+ * spare capacity; at most one chunk is partly used.
  */
 class Chain {
+public:
+    /// Heights per chunk of the index (512 KiB of pointers)
+    static constexpr int CHUNK_SHIFT = 16;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    
 private:
-    std::vector<BlockIndex*> vChain;
+    static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+    
+    /// Blocks FindFork walks back before binary searching for the fork
+    static constexpr int FIND_FORK_WALK = 32;
+    
+    std::vector<std::unique_ptr<BlockIndex*[]>> m_chunks;
+    int m_size{0};
+    
+    BlockIndex* At(int height) const {
+        return m_chunks[height >> CHUNK_SHIFT][height & CHUNK_MASK];
+    }
+    BlockIndex*& At(int height) {
+        return m_chunks[height >> CHUNK_SHIFT][height & CHUNK_MASK];
+    }
+    
+    /// Grow or shrink to size entries, new ones null
+    void Resize(int size);
     
 public:
     Chain() = default;
@@ -281,32 +355,38 @@ public:
     
     /// Get the genesis block index
     BlockIndex* Genesis() const {
-        return vChain.empty() ? nullptr : vChain[0];
+        return m_size == 0 ? nullptr : At(0);
     }
     
     /// Get the tip (most recent block) index
     BlockIndex* Tip() const {
-        return vChain.empty() ? nullptr : vChain.back();
+        return m_size == 0 ? nullptr : At(m_size - 1);
     }
     
     /// Get block at a specific height
     BlockIndex* operator[](int height) const {
-        if (height < 0 || height >= static_cast<int>(vChain.size())) {
+        if (height < 0 || height >= m_size) {
             return nullptr;
         }
-        return vChain[height];
+        return At(height);
     }
     
     /// Get the chain height (-1 if empty)
     int Height() const {
-        return static_cast<int>(vChain.size()) - 1;
+        return m_size - 1;
     }
     
     /// Check if chain is empty
-    bool empty() const { return vChain.empty(); }
+    bool empty() const { return m_size == 0; }
     
     /// Get the number of blocks in the chain
-    size_t size() const { return vChain.size(); }
+    size_t size() const { return static_cast<size_t>(m_size); }
+    
+    /// Bytes held by the height index
+    size_t DynamicMemoryUsage() const {
+        return m_chunks.size() * CHUNK_SIZE * sizeof(BlockIndex*) +
+               m_chunks.capacity() * sizeof(m_chunks[0]);
+    }
     
     // ========================================================================
     // Queries
@@ -314,19 +394,18 @@ public:
     
     /// Check if a block is in this chain
     bool Contains(const BlockIndex* pindex) const {
-        if (!pindex || pindex->nHeight < 0 || 
-            pindex->nHeight >= static_cast<int>(vChain.size())) {
+        if (!pindex || pindex->nHeight < 0 || pindex->nHeight >= m_size) {
             return false;
         }
-        return vChain[pindex->nHeight] == pindex;
+        return At(pindex->nHeight) == pindex;
     }
     
     /// Get the next block after pindex in this chain
     BlockIndex* Next(const BlockIndex* pindex) const {
         if (!Contains(pindex)) return nullptr;
         int nextHeight = pindex->nHeight + 1;
-        if (nextHeight >= static_cast<int>(vChain.size())) return nullptr;
-        return vChain[nextHeight];
+        if (nextHeight >= m_size) return nullptr;
+        return At(nextHeight);
     }
     
     /// Find the last common ancestor with another block
@@ -339,42 +418,150 @@ public:
     // Modification
     // ========================================================================
     
-    /// Set the chain tip to a specific block (rebuilds chain)
+    /// Set the chain tip to a specific block. Only the heights above the
+    /// fork with the current chain are written or dropped.
     void SetTip(BlockIndex* pindex);
     
     /// Clear the chain
-    void Clear() { vChain.clear(); }
+    void Clear() {
+        m_chunks.clear();
+        m_size = 0;
+    }
     
     // ========================================================================
     // Iteration
     // ========================================================================
     
-    using iterator = std::vector<BlockIndex*>::iterator;
-    using const_iterator = std::vector<BlockIndex*>::const_iterator;
-    
-    iterator begin() { return vChain.begin(); }
-    iterator end() { return vChain.end(); }
-    const_iterator begin() const { return vChain.begin(); }
-    const_iterator end() const { return vChain.end(); }
+    /// Iterates the chain's entries from genesis to tip
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = BlockIndex*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = BlockIndex* const*;
+        using reference = BlockIndex*;
+        
+        const_iterator(const Chain* chain, int height) : m_chain(chain), m_height(height) {}
+        
+        BlockIndex* operator*() const { return m_chain->At(m_height); }
+        const_iterator& operator++() { ++m_height; return *this; }
+        const_iterator operator++(int) { const_iterator it = *this; ++m_height; return it; }
+        bool operator==(const const_iterator& other) const { return m_height == other.m_height; }
+        bool operator!=(const const_iterator& other) const { return m_height != other.m_height; }
+        
+    private:
+        const Chain* m_chain;
+        int m_height;
+    };
+    using iterator = const_iterator;
+    
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_size); }
 };
 
 // ============================================================================
 // BlockMap - Hash map of all known blocks
 // ============================================================================
 
-/// Hash function for BlockHash
-struct BlockHashHasher {
-    size_t operator()(const BlockHash& hash) const {
-        size_t seed = 0;
-        for (size_t i = 0; i < 8; ++i) {
-            seed ^= static_cast<size_t>(hash[i]) << (i * 8);
-        }
-        return seed;
-    }
+/// Salted hash function for BlockHash
+using BlockHashHasher = SaltedHash256Hasher;
+
+/**
+ * Chunked storage for block index entries.
+ *
+ * Entries are handed out consecutively from fixed-size chunks and never
+ * move or get freed individually, so they stay valid for the arena's
+ * lifetime. Allocating in height order (as the startup load does) keeps
+ * parents and children next to each other in memory. Each chunk has a
+ * parallel array of BlockIndexHeader records for the cold fields.
+ */
+class BlockIndexArena {
+public:
+    /// Entries per chunk
+    static constexpr size_t CHUNK_SIZE = 4096;
+    
+    BlockIndexArena() = default;
+    BlockIndexArena(const BlockIndexArena&) = delete;
+    BlockIndexArena& operator=(const BlockIndexArena&) = delete;
+    
+    /// Return a fresh entry with its header storage attached
+    BlockIndex* Allocate();
+    
+    /// Allocate chunks up front for n entries in total
+    void Reserve(size_t n);
+    
+    /// Free every entry
+    void Clear();
+    
+    /// Entries allocated
+    size_t size() const { return m_size; }
+    
+    /// Bytes held by the chunks
+    size_t GetMemoryUsage() const;
+    
+private:
+    struct Chunk {
+        std::unique_ptr<BlockIndex[]> entries;
+        std::unique_ptr<BlockIndexHeader[]> headers;
+    };
+    
+    std::vector<Chunk> m_chunks;
+    size_t m_size{0};
 };
 
-/// Map from block hash to block index
-using BlockMap = std::unordered_map<BlockHash, std::unique_ptr<BlockIndex>, BlockHashHasher>;
+/**
+ * Map from block hash to block index.
+ *
+ * Lookups go through a hash map of pointers; the entries themselves are
+ * owned by an arena. Iteration yields (hash, BlockIndex*) pairs.
+ */
+class BlockMap {
+public:
+    using Map = std::unordered_map<BlockHash, BlockIndex*, BlockHashHasher>;
+    using iterator = Map::iterator;
+    using const_iterator = Map::const_iterator;
+    
+    BlockMap() = default;
+    BlockMap(const BlockMap&) = delete;
+    BlockMap& operator=(const BlockMap&) = delete;
+    
+    /**
+     * Add an empty entry for hash, or find the existing one.
+     * @return The entry and whether it was created
+     */
+    std::pair<BlockIndex*, bool> Insert(const BlockHash& hash);
+    
+    /// Find an entry (nullptr if unknown)
+    BlockIndex* Lookup(const BlockHash& hash) const {
+        auto it = m_map.find(hash);
+        return it != m_map.end() ? it->second : nullptr;
+    }
+    
+    iterator find(const BlockHash& hash) { return m_map.find(hash); }
+    const_iterator find(const BlockHash& hash) const { return m_map.find(hash); }
+    size_t count(const BlockHash& hash) const { return m_map.count(hash); }
+    
+    iterator begin() { return m_map.begin(); }
+    iterator end() { return m_map.end(); }
+    const_iterator begin() const { return m_map.begin(); }
+    const_iterator end() const { return m_map.end(); }
+    
+    size_t size() const { return m_map.size(); }
+    bool empty() const { return m_map.empty(); }
+    
+    /// Prepare for n entries in total
+    void Reserve(size_t n);
+    
+    /// Remove every entry
+    void clear();
+    
+    /// Approximate bytes used by the entries and the hash map
+    size_t GetMemoryUsage() const;
+    
+private:
+    Map m_map;
+    BlockIndexArena m_arena;
+};
 
 // ============================================================================
 // Utility Functions
@@ -386,9 +573,12 @@ const BlockIndex* LastCommonAncestor(const BlockIndex* pa, const BlockIndex* pb)
 /// Calculate the work for a given nBits value
 uint64_t GetBlockProof(uint32_t nBits);
 
-/// Get block locator for a block index
+/// Get block locator for a block index (always ends at genesis)
 BlockLocator GetLocator(const BlockIndex* pindex);
 
+/// Height the skip pointer of a block at this height points to
+int GetSkipHeight(int height);
+
 } // namespace shurium
 
 #endif // SHURIUM_CHAIN_BLOCKINDEX_H
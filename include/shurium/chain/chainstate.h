@@ -9,17 +9,48 @@
 #define SHURIUM_CHAIN_CHAINSTATE_H
 
 #include "shurium/chain/coins.h"
+#include "shurium/core/compressor.h"
 #include "shurium/chain/blockindex.h"
+#include "shurium/chain/checkqueue.h"
+#include "shurium/consensus/checkpoints.h"
 #include "shurium/consensus/params.h"
+#include <algorithm>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include <functional>
+#include <future>
+#include <map>
 
 namespace shurium {
 
 // Forward declarations
-namespace db { class BlockDB; }
+namespace db { class BlockDB; struct DiskBlockPos; }
+namespace util { class ThreadPool; }
+namespace consensus { class ValidationState; }
+
+/// Default number of threads reading a block's inputs ahead of connection
+static constexpr int DEFAULT_COINS_PREFETCH_THREADS = 4;
+
+/// Default number of threads running context-free block checks ahead of connection
+static constexpr int DEFAULT_BLOCK_CHECK_THREADS = 2;
+
+/// Blocks ProcessNewBlocks() checks ahead of the one being connected
+static constexpr size_t DEFAULT_BLOCK_CHECK_AHEAD = 16;
+
+/// Cache usage, in percent of the limit, that starts a background flush
+static constexpr int COINS_CACHE_FLUSH_PERCENT = 90;
+
+/// Share of the limit, in percent, kept warm after a flush under pressure
+static constexpr int COINS_CACHE_RETAIN_PERCENT = 50;
+
+/// Smallest limit a growing mempool can squeeze the coins cache down to
+static constexpr size_t MIN_COINS_CACHE_BYTES = 32 * 1024 * 1024;
+
+/// Seconds without a new block before the cache is written out while idle
+static constexpr int DEFAULT_COINS_IDLE_FLUSH_SECONDS = 60;
 
 // ============================================================================
 // BlockUndo - Undo information for disconnecting a block
@@ -85,6 +116,56 @@ void Unserialize(Stream& s, BlockUndo& blockundo) {
     }
 }
 
+/**
+ * Compact undo encoding, as written to the rev?????.dat files.
+ *
+ * The highest coin height in the block is stored once; each spent coin then
+ * stores its distance below that height (with the coinbase flag in the low
+ * bit), a compressed amount and a template-compressed script, all as
+ * VarInts. The legacy layout is the plain Serialize(BlockUndo) above.
+ */
+template<typename Stream>
+void SerializeCompressedUndo(Stream& s, const BlockUndo& blockundo) {
+    uint32_t nBaseHeight = 0;
+    for (const auto& txundo : blockundo.vtxundo) {
+        for (const auto& coin : txundo.vprevout) {
+            nBaseHeight = std::max(nBaseHeight, coin.nHeight);
+        }
+    }
+    WriteVarInt(s, nBaseHeight);
+    WriteCompactSize(s, blockundo.vtxundo.size());
+    for (const auto& txundo : blockundo.vtxundo) {
+        WriteCompactSize(s, txundo.vprevout.size());
+        for (const auto& coin : txundo.vprevout) {
+            uint64_t code = (static_cast<uint64_t>(nBaseHeight - coin.nHeight) << 1) |
+                            (coin.fCoinBase ? 1 : 0);
+            WriteVarInt(s, code);
+            SerializeCompressedTxOut(s, coin.out);
+        }
+    }
+}
+
+template<typename Stream>
+void UnserializeCompressedUndo(Stream& s, BlockUndo& blockundo) {
+    uint64_t nBaseHeight = ReadVarInt(s);
+    if (nBaseHeight > std::numeric_limits<uint32_t>::max()) {
+        throw std::ios_base::failure("UnserializeCompressedUndo(): height out of range");
+    }
+    blockundo.vtxundo.resize(ReadCompactSize(s));
+    for (auto& txundo : blockundo.vtxundo) {
+        txundo.vprevout.resize(ReadCompactSize(s));
+        for (auto& coin : txundo.vprevout) {
+            uint64_t code = ReadVarInt(s);
+            if ((code >> 1) > nBaseHeight) {
+                throw std::ios_base::failure("UnserializeCompressedUndo(): height out of range");
+            }
+            coin.nHeight = static_cast<uint32_t>(nBaseHeight - (code >> 1));
+            coin.fCoinBase = code & 1;
+            UnserializeCompressedTxOut(s, coin.out);
+        }
+    }
+}
+
 // ============================================================================
 // ConnectResult - Result of connecting a block
 // ============================================================================
@@ -106,6 +187,109 @@ inline bool IsSuccess(ConnectResult result) {
     return result == ConnectResult::OK;
 }
 
+// ============================================================================
+// Script Verification Flags
+// ============================================================================
+
+/**
+ * Get the script verification flags for a block at the given height.
+ *
+ * Soft forks that tighten script rules are enabled here at their activation
+ * heights. No such deployments are scheduled yet, so every height currently
+ * uses the mandatory flags.
+ */
+ScriptFlags GetBlockScriptFlags(int nHeight, const consensus::Params& params);
+
+// ============================================================================
+// Reorganization Statistics
+// ============================================================================
+
+/// Phase timings of one batched reorganization
+struct ReorgStats {
+    /// Blocks taken off the old chain
+    int nDisconnected{0};
+    
+    /// Blocks connected on the new chain
+    int nConnected{0};
+    
+    /// Height of the last common block (-1 if none)
+    int forkHeight{-1};
+    
+    /// Reading blocks and undo data
+    int64_t loadMicros{0};
+    
+    /// Disconnecting and connecting in the scratch view
+    int64_t applyMicros{0};
+    
+    /// Writing undo data and merging the view into the coins cache
+    int64_t flushMicros{0};
+    
+    int64_t TotalMicros() const { return loadMicros + applyMicros + flushMicros; }
+};
+
+/// Blocks that changed sides in one batched reorganization
+struct ReorgBlocks {
+    /// Blocks taken off the old chain, old tip first
+    std::vector<std::pair<Block, const BlockIndex*>> disconnected;
+    
+    /// Blocks connected on the new chain, fork side first
+    std::vector<std::pair<Block, const BlockIndex*>> connected;
+};
+
+/// Reorganization history of a chainstate manager
+struct ReorgMetrics {
+    /// Successful batched reorganizations
+    uint64_t nReorgs{0};
+    
+    /// Batched reorganizations that failed and left the chain unchanged
+    uint64_t nFailed{0};
+    
+    /// Sum and maximum of their durations
+    int64_t totalMicros{0};
+    int64_t maxMicros{0};
+    
+    /// The most recent successful one
+    ReorgStats last;
+};
+
+// ============================================================================
+// Coins Cache Flush Policy
+// ============================================================================
+
+/// Why the flush scheduler last started (or waited for) a UTXO write
+enum class FlushDecision {
+    NONE,        // No flush started yet
+    BACKGROUND,  // Usage crossed COINS_CACHE_FLUSH_PERCENT of the limit
+    FORCED,      // Usage passed the limit while a write ran; waited for it
+    IDLE,        // No block for a while; everything written opportunistically
+};
+
+/// Name of a flush decision for logs and RPC
+const char* FlushDecisionName(FlushDecision decision);
+
+/// Coins cache sizing and flush scheduler decisions
+struct CoinsCacheStats {
+    /// Limit set by the node (0 = no policy)
+    size_t nConfiguredLimit{0};
+    
+    /// Limit in force after giving the mempool its share
+    size_t nLimit{0};
+    
+    /// Current cache and mempool usage
+    size_t nUsage{0};
+    size_t nMempoolUsage{0};
+    
+    /// Flushes started by each decision
+    uint64_t nBackgroundFlushes{0};
+    uint64_t nForcedFlushes{0};
+    uint64_t nIdleFlushes{0};
+    
+    /// Clean entries released after flushes, oldest first
+    uint64_t nEvicted{0};
+    
+    FlushDecision lastDecision{FlushDecision::NONE};
+};
+
 // ============================================================================
 // ChainState - Manages the state of a single blockchain
 // ============================================================================
@@ -142,11 +326,54 @@ private:
     /// Whether this chainstate has been initialized
     std::atomic<bool> m_initialized{false};
     
+    /// Parallel script verification queue (not owned; null = verify inline)
+    CheckQueue* m_scriptCheckQueue{nullptr};
+    
+    /// Block store synced before the coins are written (not owned)
+    db::BlockDB* m_blockdb{nullptr};
+    
+    /// Block whose ancestors' scripts are assumed valid (null = verify all)
+    BlockHash m_assumeValid;
+    
+    /// Cache limit before the mempool's share is taken off (0 = never flush)
+    size_t m_coinsCacheLimit{0};
+    
+    /// Mempool bytes the coins cache makes room for
+    std::atomic<size_t> m_mempoolUsage{0};
+    
+    /// Cache bytes to keep warm once the running write completes (0 = none)
+    size_t m_flushRetainBytes{0};
+    
+    /// Blocks applied since the last flush began, and when the last one was
+    uint64_t m_nBlocksSinceFlush{0};
+    std::chrono::steady_clock::time_point m_lastBlockTime{std::chrono::steady_clock::now()};
+    
+    /// Flush scheduler counters
+    CoinsCacheStats m_cacheStats;
+    
+    /// Result of the background UTXO write (declared after m_coins so it is
+    /// destroyed, and therefore joined, first)
+    std::future<bool> m_flushResult;
+    
     // Internal helpers
-    bool ConnectBlock(const Block& block, BlockIndex* pindex, 
-                      CoinsViewCache& view, BlockUndo& blockundo);
-    bool DisconnectBlock(const Block& block, const BlockIndex* pindex,
+    bool IsAssumedValid(const BlockIndex* pindex) const;
+    bool StartBackgroundFlush();
+    bool FlushBlockFiles();
+    bool FinishBackgroundFlush(bool wait);
+    size_t GetEffectiveCacheLimit() const;
+    void StartPolicyFlush(FlushDecision decision, size_t retainBytes);
+    void ScheduleFlush();
+    bool CheckBlockScripts(const Block& block, const CoinsViewCache& view,
+                           ScriptFlags flags);
+    
+    /// The one block connection engine: checks scripts on the script check
+    /// queue, then spends and creates coins in view and fills blockundo.
+    /// ConnectBlock() applies it to the cache, Reorganize() to a scratch view.
+    ConnectResult ConnectBlock(const Block& block, BlockIndex* pindex,
+                               CoinsViewCache& view, BlockUndo& blockundo);
+    void DisconnectBlock(const Block& block, const BlockIndex* pindex,
                          CoinsViewCache& view, const BlockUndo& blockundo);
+    BlockIndex* FindMostWorkBlockLocked() const;
     
 public:
     /**
@@ -176,6 +403,26 @@ public:
     /// Check if initialized
     bool IsInitialized() const { return m_initialized; }
     
+    /// Set the queue used to verify block scripts in parallel
+    void SetScriptCheckQueue(CheckQueue* queue) { m_scriptCheckQueue = queue; }
+    
+    /// Set the block store whose files are synced before each coins flush
+    void SetBlockDB(db::BlockDB* blockdb) { m_blockdb = blockdb; }
+    
+    /**
+     * Set the assume-valid block.
+     * 
+     * Blocks that are ancestors of it (or the block itself) still get full
+     * UTXO accounting, but their scripts are not verified. If the block is
+     * not in the header index, every script is verified.
+     * 
+     * @param hash Assume-valid block hash (null = verify all scripts)
+     */
+    void SetAssumeValid(const BlockHash& hash) { m_assumeValid = hash; }
+    
+    /// Get the assume-valid block hash
+    const BlockHash& GetAssumeValid() const { return m_assumeValid; }
+    
     // ========================================================================
     // Chain Access
     // ========================================================================
@@ -202,6 +449,15 @@ public:
         return m_chain.Contains(pindex);
     }
     
+    /**
+     * Next block for something that follows the active chain from pindex.
+     * 
+     * The genesis block if pindex is null, the successor of pindex if it is
+     * on the chain, or the first block after the fork point if pindex was
+     * reorganized away. Null once pindex is the tip.
+     */
+    BlockIndex* FindNextBlock(const BlockIndex* pindex) const;
+    
     // ========================================================================
     // UTXO Access
     // ========================================================================
@@ -222,6 +478,26 @@ public:
         return m_coins->GetCoin(outpoint);
     }
     
+    /// Get the backing UTXO storage
+    CoinsView* GetCoinsDB() const { return m_coinsDB; }
+    
+    /**
+     * Remove outpoints whose coins are already cached.
+     * 
+     * @return Cache generation to pass to WarmCoins()
+     */
+    uint64_t FilterCachedCoins(std::vector<OutPoint>& outpoints) const;
+    
+    /**
+     * Insert coins read from the backing storage outside the lock.
+     * The coins are dropped if the cache was flushed or reset after
+     * generation was taken, since they may no longer match the storage.
+     * 
+     * @return Number of coins inserted
+     */
+    size_t WarmCoins(std::vector<std::pair<OutPoint, Coin>>&& coins,
+                     uint64_t generation);
+    
     // ========================================================================
     // Block Operations
     // ========================================================================
@@ -254,6 +530,35 @@ public:
      */
     bool ActivateBestChain(BlockIndex* pindexMostWork = nullptr);
     
+    /// The valid block with the most chain work (null if none)
+    BlockIndex* FindMostWorkBlock() const;
+    
+    /**
+     * Whether reaching pindexNew takes blocks off the active chain, and all
+     * of them have the undo data Reorganize() needs.
+     */
+    bool CanReorganizeTo(const BlockIndex* pindexNew) const;
+    
+    /**
+     * Move the tip to pindexNew in one batch.
+     * 
+     * The fork point comes from Chain::FindFork(). Blocks and undo data on
+     * both sides of it are read from blockdb in parallel on pool (inline if
+     * null). All disconnects and connects are then applied to a single
+     * scratch CoinsViewCache layered on the coins cache, which is merged
+     * only once the new tip has connected, so a failure anywhere leaves the
+     * chain and the UTXO set untouched. Undo data for the newly connected
+     * blocks is written out.
+     * 
+     * @param stats Output: phase timings (optional)
+     * @param blocks Output: the blocks that were disconnected and connected,
+     *               filled only on success (optional)
+     * @return True if pindexNew is now the tip
+     */
+    bool Reorganize(BlockIndex* pindexNew, db::BlockDB& blockdb,
+                    util::ThreadPool* pool = nullptr, ReorgStats* stats = nullptr,
+                    ReorgBlocks* blocks = nullptr);
+    
     // ========================================================================
     // Validation
     // ========================================================================
@@ -282,13 +587,78 @@ public:
         return coin.IsMature(currentHeight);
     }
     
+    /**
+     * Make the base block of a just-loaded UTXO snapshot the tip.
+     * 
+     * The coins cache is dropped so lookups go to the loaded database.
+     * Blocks below the base are not validated by this.
+     */
+    bool ActivateSnapshotBase(BlockIndex* pbase);
+    
     // ========================================================================
     // Flush & Persistence
     // ========================================================================
     
-    /// Flush UTXO cache to backing storage
+    /// Flush UTXO cache to backing storage, waiting for the write
     bool FlushStateToDisk();
     
+    /**
+     * Flush the UTXO cache without stalling validation.
+     * 
+     * The dirty entries are frozen and written to the backing storage on a
+     * background thread while blocks keep connecting against the cache.
+     * Does nothing if the previous background flush is still running.
+     * 
+     * @return false if the previous background flush failed
+     */
+    bool FlushStateToDiskAsync();
+    
+    /// Wait for a background flush to finish; returns whether it succeeded
+    bool WaitForFlush();
+    
+    /**
+     * Get the rolling hash of the UTXO set at the tip.
+     * 
+     * Combines the hash stored with the coins database and the changes
+     * still in the cache, so no pass over the set is needed. Waits for a
+     * background flush first. Null if the coins database keeps no hash.
+     */
+    Hash256 GetRollingUTXOSetHash();
+    
+    /// Check whether a background flush is in progress
+    bool IsFlushing() const {
+        std::lock_guard<std::mutex> lock(m_cs);
+        return m_flushResult.valid();
+    }
+    
+    /**
+     * Set the coins cache limit in bytes (0 = never flush on size).
+     * 
+     * The mempool's current usage is taken off the limit, down to
+     * MIN_COINS_CACHE_BYTES. After each block a background write starts at
+     * COINS_CACHE_FLUSH_PERCENT of it; past the limit the next block waits
+     * for that write. Once written, the newest entries up to
+     * COINS_CACHE_RETAIN_PERCENT of the limit stay cached and older ones go.
+     */
+    void SetCoinsCacheLimit(size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_cs);
+        m_coinsCacheLimit = bytes;
+    }
+    
+    /// Tell the flush scheduler how much memory the mempool uses
+    void SetMempoolUsage(size_t bytes) { m_mempoolUsage.store(bytes, std::memory_order_relaxed); }
+    
+    /**
+     * Write the cache out in the background if blocks were connected since
+     * the last flush but none for idleFor, keeping the entries cached.
+     * 
+     * @return true if a write was started
+     */
+    bool FlushIfIdle(std::chrono::seconds idleFor);
+    
+    /// Cache sizing and flush scheduler decisions so far
+    CoinsCacheStats GetCoinsCacheStats() const;
+    
     /// Get memory usage statistics
     size_t GetCoinsCacheSize() const { return m_coins->GetCacheSize(); }
     size_t GetCoinsCacheUsage() const { return m_coins->GetCacheUsage(); }
@@ -298,6 +668,12 @@ public:
 // ChainStateManager - Manages multiple chain states (for AssumeUTXO)
 // ============================================================================
 
+/// Called with a block that was accepted and became the active tip
+using BlockConnectedCallback = std::function<void(const Block&, const BlockIndex*)>;
+
+/// Called with a block that a reorganization took off the active chain
+using BlockDisconnectedCallback = std::function<void(const Block&, const BlockIndex*)>;
+
 /**
  * Manages one or more ChainState objects.
  * 
@@ -321,13 +697,50 @@ private:
     /// Block database for storing blocks (optional, not owned)
     db::BlockDB* m_blockdb{nullptr};
     
+    /// Script verification workers shared by all chainstates
+    std::unique_ptr<CheckQueue> m_scriptCheckQueue;
+    
+    /// Workers reading block inputs ahead of connection (null = disabled)
+    std::unique_ptr<util::ThreadPool> m_prefetchPool;
+    
+    /// Workers running CheckBlock() ahead of connection (null = inline)
+    std::unique_ptr<util::ThreadPool> m_blockCheckPool;
+    
+    /// Assume-valid block handed to chainstates (null = verify all scripts)
+    BlockHash m_assumeValid;
+    
+    /// Checkpoints headers are held to (empty = none)
+    consensus::CheckpointManager m_checkpoints;
+    
     /// Mutex for thread-safe access
     mutable std::mutex m_cs;
     
+    /// Batched reorganization history (guarded by m_cs)
+    ReorgMetrics m_reorgMetrics;
+    
+    /// Block-connected listeners by id; the mutex is held while they run
+    std::map<int, BlockConnectedCallback> m_blockConnectedCallbacks;
+    std::map<int, BlockDisconnectedCallback> m_blockDisconnectedCallbacks;
+    int m_nextCallbackId{0};
+    mutable std::mutex m_callbacksMutex;
+    
+    /// Last block announced to the block-connected listeners (guarded by
+    /// m_callbacksMutex), so a tip a reorganization announced is not
+    /// announced again by AcceptBlock()
+    const BlockIndex* m_lastAnnounced{nullptr};
+    
+    /**
+     * Add a block to the index and try to connect it.
+     * @param dbp Where the block is already stored (null = write it out)
+     * @param fCheckedBlock CheckBlock() already passed for this block
+     */
+    bool AcceptBlock(const Block& block, bool fForceProcessing,
+                     const db::DiskBlockPos* dbp, bool fCheckedBlock);
+    
 public:
     ChainStateManager();
     explicit ChainStateManager(const consensus::Params& params);
-    ~ChainStateManager() = default;
+    ~ChainStateManager();
     
     // ========================================================================
     // Initialization
@@ -337,11 +750,53 @@ public:
     bool Initialize(CoinsView* coinsDB);
     
     /// Set the block database for storing blocks
-    void SetBlockDB(db::BlockDB* blockdb) { m_blockdb = blockdb; }
+    void SetBlockDB(db::BlockDB* blockdb);
     
     /// Get the block database
     db::BlockDB* GetBlockDB() const { return m_blockdb; }
     
+    /**
+     * Configure parallel script verification.
+     * 
+     * @param nThreads Total script verification threads; 1 or less
+     *                 verifies serially on the validation thread
+     */
+    void SetScriptCheckThreads(int nThreads);
+    
+    /// Get the number of script verification threads (1 = serial)
+    int GetScriptCheckThreads() const;
+    
+    /// Script verification workers (null when verifying inline)
+    CheckQueue* GetScriptCheckQueue() const { return m_scriptCheckQueue.get(); }
+    
+    /**
+     * Configure coin prefetching.
+     * 
+     * @param nThreads Threads reading block inputs from the UTXO database
+     *                 before connection; 0 disables prefetching
+     */
+    void SetPrefetchThreads(int nThreads);
+    
+    /// Get the number of prefetch threads (0 = disabled)
+    int GetPrefetchThreads() const;
+    
+    /**
+     * Configure the block check stage of ProcessNewBlocks().
+     * 
+     * @param nThreads Threads running context-free block checks while
+     *                 earlier blocks connect; 0 checks inline
+     */
+    void SetBlockCheckThreads(int nThreads);
+    
+    /// Get the number of block check threads (0 = inline)
+    int GetBlockCheckThreads() const;
+    
+    /// Set the assume-valid block (null = verify all scripts)
+    void SetAssumeValid(const BlockHash& hash);
+    
+    /// Get the assume-valid block hash
+    const BlockHash& GetAssumeValid() const { return m_assumeValid; }
+    
     // ========================================================================
     // Block Index
     // ========================================================================
@@ -408,17 +863,136 @@ public:
      */
     BlockIndex* ProcessBlockHeader(const BlockHeader& header);
     
+    /**
+     * Process the headers of a headers message, in chain order. They are
+     * hashed several at a time and checked as one batch, proof of work on
+     * the block check threads, before any is added to the index.
+     * 
+     * @param hashes Their hashes if already computed, else null
+     * @param state Why the first rejected header was rejected
+     * @return Number of leading headers accepted
+     */
+    size_t ProcessBlockHeaders(const std::vector<BlockHeader>& headers,
+                               consensus::ValidationState& state,
+                               const std::vector<BlockHash>* hashes = nullptr);
+    
+    /// Hold headers to the checkpoints of a network ("main", "test", ...)
+    void LoadCheckpoints(const std::string& networkId) { m_checkpoints.LoadCheckpoints(networkId); }
+    
+    /// Checkpoints headers are held to
+    const consensus::CheckpointManager& GetCheckpoints() const { return m_checkpoints; }
+    
     /**
      * Process a new block.
      * Validates and potentially connects to the active chain.
      */
     bool ProcessNewBlock(const Block& block, bool fForceProcessing = false);
     
+    /**
+     * Process a run of new blocks, in order.
+     * 
+     * Validation is pipelined: context-free checks (size, merkle root,
+     * transaction sanity) for up to DEFAULT_BLOCK_CHECK_AHEAD blocks run on
+     * the block check threads while the calling thread stores and connects
+     * the earlier ones. Results are consumed in order, so the outcome is the
+     * same as calling ProcessNewBlock() on each block in turn.
+     * 
+     * @return Number of blocks accepted before the first rejected one
+     */
+    size_t ProcessNewBlocks(const std::vector<Block>& blocks);
+    
+    /**
+     * Process a block read back from the block files (-reindex).
+     * 
+     * Same as ProcessNewBlock(), except that the block is not written out
+     * again: the index records the position it was read from.
+     * 
+     * @param pos Position of the block's record in the block files
+     * @param fCheckedBlock The caller already ran consensus::CheckBlock()
+     */
+    bool ProcessStoredBlock(const Block& block, const db::DiskBlockPos& pos,
+                            bool fCheckedBlock = false);
+    
+    /**
+     * Warm the UTXO cache with the coins a block spends.
+     * 
+     * Outputs created within the block and coins already cached are
+     * skipped; the rest are read from the UTXO database in parallel on the
+     * prefetch threads, so connecting the block afterwards does not wait on
+     * one database read per input. Does nothing if prefetching is disabled.
+     * 
+     * @return Number of coins added to the cache
+     */
+    size_t PrefetchBlockInputs(const Block& block);
+    
+    /**
+     * Delete old block files if the block database is over its prune target.
+     * 
+     * Blocks stored in the deleted files lose HAVE_DATA and HAVE_UNDO in the
+     * index. Runs after every accepted block when pruning is enabled.
+     * 
+     * @return Number of block files deleted
+     */
+    int PruneBlockFiles();
+    
+    /**
+     * Lowest height from which the active chain has block data.
+     * 0 if nothing has been pruned, -1 without a chain.
+     */
+    int GetPruneHeight() const;
+    
+    // ========================================================================
+    // Notifications
+    // ========================================================================
+    
+    /**
+     * Register a listener for blocks that are accepted and become the tip.
+     * 
+     * Listeners run on the thread that accepted the block. A batched
+     * reorganization announces each block it connects, in order, after the
+     * blocks it disconnected were announced to the block-disconnected
+     * listeners. Blocks that join the active chain in some other way are
+     * not announced; listeners that need every block should also walk the
+     * chain with ChainState::FindNextBlock().
+     * 
+     * @return Id to pass to UnregisterBlockConnected()
+     */
+    int RegisterBlockConnected(BlockConnectedCallback callback);
+    
+    /// Remove a listener; waits for it to return if it is running
+    void UnregisterBlockConnected(int id);
+    
+    /**
+     * Register a listener for blocks a batched reorganization takes off the
+     * active chain, old tip first. Listeners run once the reorganization has
+     * succeeded, on the thread that performed it.
+     * 
+     * @return Id to pass to UnregisterBlockDisconnected()
+     */
+    int RegisterBlockDisconnected(BlockDisconnectedCallback callback);
+    
+    /// Remove a listener; waits for it to return if it is running
+    void UnregisterBlockDisconnected(int id);
+    
     /**
      * Activate the best chain.
      */
-    bool ActivateBestChain() {
-        return m_activeChainState && m_activeChainState->ActivateBestChain();
+    /**
+     * Activate the best chain. A switch to another branch whose blocks have
+     * undo data on disk goes through Reorganize().
+     */
+    bool ActivateBestChain();
+    
+    /**
+     * Reorganize the active chainstate to pindexNew in one batch, reading
+     * blocks on the prefetch threads, and record the timings.
+     */
+    bool Reorganize(BlockIndex* pindexNew);
+    
+    /// Batched reorganization history
+    ReorgMetrics GetReorgMetrics() const {
+        std::lock_guard<std::mutex> lock(m_cs);
+        return m_reorgMetrics;
     }
 };
 
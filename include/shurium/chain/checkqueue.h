@@ -0,0 +1,189 @@
+// SHURIUM - Parallel Script Verification Queue
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the check queue used by block validation to verify
+// transaction input scripts on a pool of worker threads.
+
+#ifndef SHURIUM_CHAIN_CHECKQUEUE_H
+#define SHURIUM_CHAIN_CHECKQUEUE_H
+
+#include "shurium/chain/coins.h"
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/script/interpreter.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace shurium {
+
+namespace util { class ThreadPool; }
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Default value for -par (0 = one thread per core)
+static constexpr int DEFAULT_SCRIPTCHECK_THREADS = 0;
+
+/// Maximum number of script verification threads
+static constexpr int MAX_SCRIPTCHECK_THREADS = 64;
+
+/// Number of checks handed to a worker at a time
+static constexpr size_t DEFAULT_SCRIPTCHECK_BATCH_SIZE = 128;
+
+/**
+ * Resolve a -par value into a thread count.
+ *
+ * @param requested 0 = one per core, negative = leave that many cores free,
+ *                  positive = use exactly that many threads
+ * @return Thread count clamped to [1, MAX_SCRIPTCHECK_THREADS]
+ */
+int ResolveScriptCheckThreads(int requested);
+
+// ============================================================================
+// ScriptCheck - Verification job for a single transaction input
+// ============================================================================
+
+/**
+ * Verifies the scriptSig of one input against the output it spends.
+ *
+ * The spent output's script and amount are copied so the check does not
+ * reference the UTXO cache, which may be modified while checks are running.
+ * The transaction itself must outlive the check.
+ */
+class ScriptCheck {
+private:
+    Script m_scriptPubKey;
+    Amount m_amount{0};
+    const Transaction* m_tx{nullptr};
+    const PrecomputedTransactionData* m_txdata{nullptr};
+    unsigned int m_nIn{0};
+    ScriptFlags m_flags{ScriptFlags::VERIFY_NONE};
+    SignatureCache* m_sigCache{nullptr};
+    bool m_storeSigs{false};
+    ScriptError m_error{ScriptError::UNKNOWN};
+
+public:
+    ScriptCheck() = default;
+
+    /**
+     * @param txdata Signature hash data precomputed for tx, shared by the
+     *               checks of all its inputs (optional; must outlive the check)
+     * @param sigCache Signatures found here are not re-verified (optional;
+     *                 block validation only reads from it)
+     * @param storeSigs Add newly verified signatures to sigCache (mempool
+     *                  acceptance does, so blocks can skip them later)
+     */
+    ScriptCheck(const Coin& coin, const Transaction& tx, unsigned int nIn,
+                ScriptFlags flags, const PrecomputedTransactionData* txdata = nullptr,
+                SignatureCache* sigCache = nullptr, bool storeSigs = false);
+
+    /// Run the check; returns true if the input script verifies
+    bool operator()();
+
+    /// Error from the last run
+    ScriptError GetError() const { return m_error; }
+
+    const Transaction* GetTransaction() const { return m_tx; }
+    unsigned int GetInputIndex() const { return m_nIn; }
+};
+
+// ============================================================================
+// CheckQueue - Worker pool for script checks
+// ============================================================================
+
+/**
+ * A pool of script verification workers shared by all block validations.
+ *
+ * Checks are submitted through a CheckQueueControl, which scopes a single
+ * block. Only one control may be active on a queue at a time.
+ */
+class CheckQueue {
+private:
+    std::unique_ptr<util::ThreadPool> m_pool;
+    size_t m_batchSize;
+
+    /// Held by the active CheckQueueControl
+    std::mutex m_controlMutex;
+
+    friend class CheckQueueControl;
+
+public:
+    /**
+     * Create a queue with the given number of worker threads.
+     *
+     * @param nWorkers Number of worker threads (must be at least 1)
+     * @param batchSize Number of checks per worker task
+     */
+    explicit CheckQueue(size_t nWorkers,
+                        size_t batchSize = DEFAULT_SCRIPTCHECK_BATCH_SIZE);
+    ~CheckQueue();
+
+    CheckQueue(const CheckQueue&) = delete;
+    CheckQueue& operator=(const CheckQueue&) = delete;
+
+    /// Number of worker threads
+    size_t GetWorkerCount() const;
+
+    /// Checks per worker task
+    size_t GetBatchSize() const { return m_batchSize; }
+};
+
+// ============================================================================
+// CheckQueueControl - Scoped verification of one block's checks
+// ============================================================================
+
+/**
+ * Collects the script checks for one block and waits for their result.
+ *
+ * Checks start running on the queue's workers as soon as a full batch has
+ * been added. The first failing check cancels all checks that have not yet
+ * started. With a null queue, checks run inline on the calling thread.
+ *
+ * Destroying a control without calling Wait() cancels outstanding checks
+ * and blocks until running ones have finished.
+ */
+class CheckQueueControl {
+private:
+    struct State;
+
+    CheckQueue* m_queue;
+    std::unique_lock<std::mutex> m_lock;
+    std::shared_ptr<State> m_state;
+    std::vector<ScriptCheck> m_pending;
+    bool m_done{false};
+
+    /// Hand the pending checks to a worker (or run them inline)
+    void Dispatch();
+
+public:
+    explicit CheckQueueControl(CheckQueue* queue);
+    ~CheckQueueControl();
+
+    CheckQueueControl(const CheckQueueControl&) = delete;
+    CheckQueueControl& operator=(const CheckQueueControl&) = delete;
+
+    /// Queue checks for verification
+    void Add(std::vector<ScriptCheck>&& checks);
+
+    /**
+     * Wait for all queued checks to finish.
+     * @return true if every check passed
+     */
+    bool Wait();
+
+    /// Stop checks that have not started yet; Wait() will return false
+    void Cancel();
+
+    /// Error of the first failing check (ScriptError::OK if none failed)
+    ScriptError GetError() const;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CHAIN_CHECKQUEUE_H
@@ -11,10 +11,14 @@
 #include "shurium/core/types.h"
 #include "shurium/core/transaction.h"
 #include "shurium/core/serialize.h"
+#include "shurium/crypto/muhash.h"
+#include "shurium/crypto/siphash.h"
+#include "shurium/util/poolresource.h"
 #include <cstdint>
 #include <unordered_map>
 #include <optional>
 #include <memory>
+#include <mutex>
 #include <functional>
 
 namespace shurium {
@@ -79,9 +83,9 @@ public:
         return currentHeight >= nHeight + COINBASE_MATURITY;
     }
     
-    /// Estimate dynamic memory usage
+    /// Heap memory held by this coin's script
     size_t DynamicMemoryUsage() const {
-        return out.scriptPubKey.size();
+        return out.scriptPubKey.capacity();
     }
     
     /// Comparison
@@ -117,18 +121,24 @@ void Unserialize(Stream& s, Coin& coin) {
 // OutPointHasher - Hash function for OutPoint keys
 // ============================================================================
 
-/// Hash function for OutPoint to use in unordered_map
-struct OutPointHasher {
+/**
+ * Salted hash function for OutPoint keys.
+ * 
+ * Outpoints come from the network, so an unkeyed hash would let an attacker
+ * fill a single bucket. SipHash-1-3 over the 36-byte outpoint with the
+ * per-process salt makes bucket placement unpredictable.
+ */
+class OutPointHasher {
+public:
+    OutPointHasher() : m_key(GetHashTableSalt()) {}
+    
     size_t operator()(const OutPoint& outpoint) const {
-        // Combine hash of the txid with the output index
-        size_t seed = 0;
-        // Simple hash combining
-        for (size_t i = 0; i < 8; ++i) {
-            seed ^= static_cast<size_t>(outpoint.hash[i]) << (i * 8);
-        }
-        seed ^= std::hash<uint32_t>{}(outpoint.n);
-        return seed;
+        return static_cast<size_t>(
+            SipHash13Uint256Extra(m_key.k0, m_key.k1, outpoint.hash, outpoint.n));
     }
+    
+private:
+    SipHashKey m_key;
 };
 
 // ============================================================================
@@ -160,6 +170,7 @@ inline bool HasFlag(CoinsCacheFlags flags, CoinsCacheFlags flag) {
 struct CoinsCacheEntry {
     Coin coin;
     CoinsCacheFlags flags;
+    uint32_t epoch{0};  // Cache epoch of the last use (fits the padding)
     
     CoinsCacheEntry() : flags(CoinsCacheFlags::NONE) {}
     explicit CoinsCacheEntry(Coin&& c) : coin(std::move(c)), flags(CoinsCacheFlags::NONE) {}
@@ -173,8 +184,30 @@ struct CoinsCacheEntry {
     void ClearFlags() { flags = CoinsCacheFlags::NONE; }
 };
 
+/// Largest block the CoinsMap pool serves: one map node plus bookkeeping
+static constexpr size_t COINS_MAP_POOL_BLOCK_SIZE =
+    sizeof(std::pair<const OutPoint, CoinsCacheEntry>) + sizeof(void*) * 4;
+
+/// Pool allocator for CoinsMap nodes (bucket arrays fall through to the heap)
+using CoinsMapAllocator = util::PoolAllocator<std::pair<const OutPoint, CoinsCacheEntry>,
+                                              COINS_MAP_POOL_BLOCK_SIZE,
+                                              alignof(void*)>;
+
 /// Type alias for the coins cache map
-using CoinsMap = std::unordered_map<OutPoint, CoinsCacheEntry, OutPointHasher>;
+using CoinsMap = std::unordered_map<OutPoint, CoinsCacheEntry, OutPointHasher,
+                                    std::equal_to<OutPoint>, CoinsMapAllocator>;
+
+/// Bytes allocated by a coins map's pool and bucket array (excluding scripts)
+inline size_t CoinsMapMemoryUsage(const CoinsMap& map) {
+    return map.get_allocator().Resource()->MemoryUsage();
+}
+
+/// Thread role that connects blocks, whose NUMA node the coins cache prefers
+static constexpr const char* COINS_CACHE_THREAD_ROLE = "msgheavy";
+
+/// An empty coins map whose pool sits on the NUMA node of the threads that
+/// connect blocks, when they are pinned to one
+CoinsMap MakeCoinsMap();
 
 // ============================================================================
 // CoinsView - Abstract interface for UTXO database views
@@ -202,6 +235,32 @@ public:
     
     /// Get estimated size of the UTXO set
     virtual size_t EstimateSize() const { return 0; }
+    
+    /**
+     * Apply the dirty entries of a cache and record the new best block.
+     * The map is only read, so it may be shared with concurrent readers.
+     * hashDelta holds the coins the cache added and spent, for views that
+     * maintain a rolling UTXO set hash.
+     * 
+     * @return true if the changes were applied (false if unsupported)
+     */
+    virtual bool BatchWrite(const CoinsMap& mapCoins, const BlockHash& hashBlock,
+                            const MuHash3072& hashDelta) {
+        (void)mapCoins;
+        (void)hashBlock;
+        (void)hashDelta;
+        return false;
+    }
+    
+    /**
+     * Get the rolling hash of the coins in this view (see AddCoinToHash).
+     * 
+     * @return false if the view does not maintain one
+     */
+    virtual bool GetUTXOHashState(MuHash3072& state) const {
+        (void)state;
+        return false;
+    }
 };
 
 // ============================================================================
@@ -235,6 +294,15 @@ public:
         return base ? base->EstimateSize() : 0;
     }
     
+    bool BatchWrite(const CoinsMap& mapCoins, const BlockHash& hashBlock,
+                    const MuHash3072& hashDelta) override {
+        return base && base->BatchWrite(mapCoins, hashBlock, hashDelta);
+    }
+    
+    bool GetUTXOHashState(MuHash3072& state) const override {
+        return base && base->GetUTXOHashState(state);
+    }
+    
     void SetBackend(CoinsView* viewIn) { base = viewIn; }
     CoinsView* GetBackend() const { return base; }
 };
@@ -251,14 +319,32 @@ public:
  * flushed to the backing view.
  */
 class CoinsViewCache : public CoinsViewBacked {
+public:
+    /// Dirty entries frozen for writing to the backing view
+    struct FlushSnapshot {
+        CoinsMap coins;
+        BlockHash bestBlock;
+        size_t coinsUsage{0};  // Script bytes held by the snapshot's coins
+        MuHash3072 hashDelta;  // Coins added and spent by these changes
+    };
+    
 private:
     mutable CoinsMap cacheCoins;
     mutable BlockHash hashBlock;
-    mutable size_t cachedCoinsUsage{0};
+    mutable size_t cachedCoinsUsage{0};  // Script bytes held by cached coins
+    uint64_t flushGeneration{0};         // Bumped when a flush begins or ends, and by Reset()
+    uint32_t currentEpoch{0};            // Bumped by every new best block
+    MuHash3072 hashDelta;                // Coins added and spent since the last flush
+    
+    /// Snapshot being written by an in-flight flush (null = none)
+    std::shared_ptr<const FlushSnapshot> flushing;
     
     /// Fetch a coin into the cache if not already present
     CoinsMap::iterator FetchCoin(const OutPoint& outpoint) const;
     
+    /// Find an outpoint in the in-flight snapshot (null if absent)
+    const CoinsCacheEntry* FindFlushing(const OutPoint& outpoint) const;
+    
 public:
     explicit CoinsViewCache(CoinsView* baseIn);
     
@@ -272,6 +358,19 @@ public:
     BlockHash GetBestBlock() const override;
     size_t EstimateSize() const override;
     
+    /// Merge the dirty entries of a child cache into this one
+    bool BatchWrite(const CoinsMap& mapCoins, const BlockHash& hashBlock,
+                    const MuHash3072& hashDelta) override;
+    
+    /**
+     * Get the rolling UTXO set hash: the parent's, with the changes of any
+     * in-flight flush and of this cache applied.
+     * 
+     * While a flush is being written the parent may or may not include it
+     * yet, so finish the flush (EndFlush) before calling this.
+     */
+    bool GetUTXOHashState(MuHash3072& state) const override;
+    
     /// Get a reference to a coin in the cache (more efficient than GetCoin)
     const Coin& AccessCoin(const OutPoint& outpoint) const;
     
@@ -281,25 +380,84 @@ public:
     /// Spend a coin (mark it as spent)
     bool SpendCoin(const OutPoint& outpoint, Coin* moveTo = nullptr);
     
-    /// Set the best block hash
+    /// Set the best block hash (starts a new epoch)
     void SetBestBlock(const BlockHash& block);
     
-    /// Check if a coin is in the cache (not checking parent)
+    /// Epoch stamped on entries used now; entries from older epochs go first
+    uint32_t GetEpoch() const { return currentEpoch; }
+    
+    /// Check if a coin is in the cache or an in-flight flush (not checking parent)
     bool HaveCoinInCache(const OutPoint& outpoint) const;
     
-    /// Get the cached dynamic memory usage
-    size_t GetCacheSize() const { return cacheCoins.size(); }
-    size_t GetCacheUsage() const { return cachedCoinsUsage; }
+    /**
+     * Insert a coin read ahead of time from the backing view.
+     * Does nothing if the outpoint already has a cache entry, so a newer
+     * (possibly spent) entry is never overwritten.
+     * 
+     * @return true if the coin was inserted
+     */
+    bool WarmCoin(const OutPoint& outpoint, Coin&& coin);
+    
+    /// Changes whenever a flush begins or ends, or the cache is reset
+    uint64_t GetFlushGeneration() const { return flushGeneration; }
+    
+    /// Get the number of cached entries (including an in-flight flush)
+    size_t GetCacheSize() const {
+        return cacheCoins.size() + (flushing ? flushing->coins.size() : 0);
+    }
+    
+    /// Get the memory used by the cache: map allocations plus coin scripts
+    size_t GetCacheUsage() const;
     
-    /// Flush changes to the backing view
+    /// Write all changes to the backing view and wait for the write
     bool Flush();
     
-    /// Clear the cache without flushing
+    /**
+     * Begin a flush that can be written without holding up the cache.
+     * 
+     * Dirty entries move into a frozen snapshot which the caller writes
+     * with base->BatchWrite(), possibly on another thread, and completes
+     * with EndFlush(). Meanwhile the cache keeps working as a fresh overlay
+     * and lookups that miss it fall through to the snapshot before the
+     * backing view, so the half-written state underneath is never seen.
+     * 
+     * @return The snapshot to write, or null if a flush is already in flight
+     */
+    std::shared_ptr<const FlushSnapshot> BeginFlush();
+    
+    /**
+     * Finish the in-flight flush.
+     * 
+     * @param written Whether the snapshot reached the backing view; if not,
+     *                its entries are merged back as dirty so nothing is lost
+     * @param fRetain Keep the written unspent coins as clean entries instead
+     *                of dropping them, so the cache stays warm; Trim() then
+     *                releases the oldest
+     */
+    void EndFlush(bool written, bool fRetain = false);
+    
+    /**
+     * Drop clean entries, least recently used epochs first, until the cache
+     * fits in targetUsage bytes. Dirty entries always stay. The map is
+     * rebuilt so its pool memory goes back to the system. Does nothing while
+     * a flush is in flight.
+     * 
+     * @return Number of entries dropped
+     */
+    size_t Trim(size_t targetUsage);
+    
+    /// Whether a flush has begun and not yet ended
+    bool IsFlushing() const { return flushing != nullptr; }
+    
+    /// Clear the cache (and any in-flight snapshot) without flushing
     void Reset();
     
     /// Calculate the hash of all UTXOs for verification
     Hash256 GetUTXOSetHash() const;
     
+    /// Digest of the rolling UTXO set hash (null if the parent keeps none)
+    Hash256 GetRollingUTXOSetHash() const;
+    
     /// Batch-add all outputs from a transaction
     void AddTransaction(const Transaction& tx, uint32_t height);
     
@@ -320,8 +478,10 @@ public:
  */
 class CoinsViewMemory : public CoinsView {
 private:
+    mutable std::mutex cs;  // Allows a background flush alongside reads
     CoinsMap coins;
     BlockHash bestBlock;
+    MuHash3072 muhash;
     
 public:
     CoinsViewMemory() = default;
@@ -338,9 +498,26 @@ public:
     void Clear();
     
     /// Receive a batch write from a cache
-    void BatchWrite(CoinsMap& mapCoins, const BlockHash& block);
+    bool BatchWrite(const CoinsMap& mapCoins, const BlockHash& block,
+                    const MuHash3072& hashDelta) override;
+    
+    bool GetUTXOHashState(MuHash3072& state) const override;
 };
 
+// ============================================================================
+// Rolling UTXO Set Hash
+// ============================================================================
+
+/**
+ * Add a coin to a rolling UTXO set hash.
+ * The element is the serialized outpoint followed by the serialized coin,
+ * the same record a UTXO snapshot stores.
+ */
+void AddCoinToHash(MuHash3072& hash, const OutPoint& outpoint, const Coin& coin);
+
+/// Remove a coin from a rolling UTXO set hash
+void RemoveCoinFromHash(MuHash3072& hash, const OutPoint& outpoint, const Coin& coin);
+
 // ============================================================================
 // UTXO Statistics
 // ============================================================================
@@ -355,6 +532,7 @@ struct UTXOStats {
     Amount nTotalAmount{0};        // Total value of all UTXOs
     Hash256 hashSerialized;        // Hash of the entire UTXO set
     uint64_t nDiskSize{0};         // Size on disk
+    BlockHash hashBlock;           // Best block of the scanned set (if known)
     
     void Reset() {
         nTransactions = 0;
@@ -363,6 +541,7 @@ struct UTXOStats {
         nTotalAmount = 0;
         hashSerialized.SetNull();
         nDiskSize = 0;
+        hashBlock.SetNull();
     }
 };
 
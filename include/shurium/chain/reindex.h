@@ -0,0 +1,218 @@
+// SHURIUM - Block File Reindexing
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the -reindex pipeline, which rebuilds the block index
+// and chainstate from the blocks already stored in blk?????.dat files.
+
+#ifndef SHURIUM_CHAIN_REINDEX_H
+#define SHURIUM_CHAIN_REINDEX_H
+
+#include "shurium/chain/blockindex.h"
+#include "shurium/core/block.h"
+#include "shurium/db/blockdb.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shurium {
+
+class ChainStateManager;
+namespace util { class ThreadPool; }
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Bytes read from a block file per read call
+static constexpr size_t DEFAULT_REINDEX_READ_BUFFER = 16 * 1024 * 1024;
+
+/// Blocks read but not yet handed to the chainstate, across all stages
+static constexpr size_t DEFAULT_REINDEX_MAX_IN_FLIGHT = 1024;
+
+/// Seconds between progress log lines
+static constexpr int REINDEX_PROGRESS_INTERVAL = 10;
+
+// ============================================================================
+// Reindex Options and Statistics
+// ============================================================================
+
+/// Tuning for BlockReindexer
+struct ReindexOptions {
+    /// Size of each sequential read (also how far ahead the kernel is asked to prefetch)
+    size_t readBufferSize{DEFAULT_REINDEX_READ_BUFFER};
+
+    /// Threads deserializing and checking blocks (0 = one per core)
+    int nCheckThreads{0};
+
+    /// Bound on blocks between the reader and the chainstate
+    size_t maxInFlight{DEFAULT_REINDEX_MAX_IN_FLIGHT};
+};
+
+/**
+ * Snapshot of a reindex in progress.
+ *
+ * The depths describe where blocks currently are: waiting for or inside a
+ * check worker, checked but waiting for an earlier block to be fed, or held
+ * back until their parent has been connected.
+ */
+struct ReindexStats {
+    /// Block files found, and bytes in them
+    int nFiles{0};
+    uint64_t nTotalBytes{0};
+
+    /// File being read
+    int nCurrentFile{0};
+
+    /// Bytes read so far
+    uint64_t nBytesRead{0};
+
+    /// Block records found / checked / handed to the chainstate
+    uint64_t nBlocksRead{0};
+    uint64_t nBlocksChecked{0};
+    uint64_t nBlocksProcessed{0};
+
+    /// Records that failed to deserialize or CheckBlock()
+    uint64_t nBlocksInvalid{0};
+
+    /// Blocks whose parent never showed up
+    uint64_t nBlocksOrphaned{0};
+
+    /// Stage depths
+    size_t nCheckQueueDepth{0};
+    size_t nFeedQueueDepth{0};
+    size_t nOutOfOrderDepth{0};
+
+    /// Wall time since the reindex started
+    double elapsedSeconds{0};
+
+    /// Fraction of the block file bytes read (0..1)
+    double Progress() const {
+        return nTotalBytes ? static_cast<double>(nBytesRead) / nTotalBytes : 1.0;
+    }
+
+    /// Blocks handed to the chainstate per second
+    double BlocksPerSecond() const {
+        return elapsedSeconds > 0 ? nBlocksProcessed / elapsedSeconds : 0.0;
+    }
+
+    /// Block file bytes read per second, in MiB
+    double MiBPerSecond() const {
+        return elapsedSeconds > 0 ? nBytesRead / elapsedSeconds / (1024.0 * 1024.0) : 0.0;
+    }
+
+    std::string ToString() const;
+};
+
+// ============================================================================
+// BlockReindexer - Replays block files into the chainstate
+// ============================================================================
+
+/**
+ * Three-stage pipeline that rebuilds the chainstate from the block files.
+ *
+ * 1. A reader thread walks the files front to back with large sequential
+ *    reads, prefetching the next buffer while it splits the current one into
+ *    block records.
+ * 2. A pool of check threads deserializes each record and runs the
+ *    context-free consensus::CheckBlock() (header, merkle root,
+ *    transactions).
+ * 3. The calling thread takes checked blocks back in file order and hands
+ *    them to ChainStateManager::ProcessStoredBlock(). Blocks whose parent is
+ *    not in the index yet are remembered by position and fed (re-read from
+ *    the block files) once the parent has been processed.
+ *
+ * The number of blocks between stage 1 and stage 3 is bounded by
+ * ReindexOptions::maxInFlight, so memory use does not depend on how far the
+ * reader gets ahead. Blocks are not written again; the block file metadata
+ * is rebuilt from the files with BlockDB::RescanBlockFiles() first.
+ */
+class BlockReindexer {
+public:
+    BlockReindexer(ChainStateManager& chainman, db::BlockDB& blockDB,
+                   const ReindexOptions& options = ReindexOptions());
+    ~BlockReindexer();
+
+    BlockReindexer(const BlockReindexer&) = delete;
+    BlockReindexer& operator=(const BlockReindexer&) = delete;
+
+    /**
+     * Replay all block files. Blocks until done or interrupted.
+     * @return False if interrupted or a block file could not be read
+     */
+    bool Run();
+
+    /// Stop Run() early (callable from any thread)
+    void Interrupt();
+
+    /// Current statistics (callable from any thread)
+    ReindexStats GetStats() const;
+
+private:
+    /// A block record on its way through the pipeline
+    struct PendingBlock {
+        db::DiskBlockPos pos;
+        std::vector<uint8_t> data;
+        std::optional<Block> block;
+        BlockHash hash;
+    };
+
+    ChainStateManager& m_chainman;
+    db::BlockDB& m_blockDB;
+    ReindexOptions m_options;
+
+    /// Checked (or rejected) blocks by read sequence number, plus counters
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cvFed;
+    std::condition_variable m_cvChecked;
+    std::map<uint64_t, std::shared_ptr<PendingBlock>> m_checked;
+    uint64_t m_nSubmitted{0};
+    uint64_t m_nFed{0};
+    bool m_readerDone{false};
+    bool m_readFailed{false};
+    std::atomic<bool> m_interrupt{false};
+
+    /// Positions of blocks waiting for their parent, by parent hash (feeder only)
+    std::unordered_map<BlockHash, std::vector<db::DiskBlockPos>, BlockHashHasher> m_outOfOrder;
+
+    /// Statistics (counters updated by the owning stage)
+    std::atomic<int> m_nFiles{0};
+    std::atomic<uint64_t> m_nTotalBytes{0};
+    std::atomic<int> m_nCurrentFile{0};
+    std::atomic<uint64_t> m_nBytesRead{0};
+    std::atomic<uint64_t> m_nBlocksChecked{0};
+    std::atomic<uint64_t> m_nBlocksProcessed{0};
+    std::atomic<uint64_t> m_nBlocksInvalid{0};
+    std::atomic<uint64_t> m_nBlocksOrphaned{0};
+    std::atomic<size_t> m_nOutOfOrder{0};
+    std::chrono::steady_clock::time_point m_start;
+
+    /// Stage 1: split the block files into records and submit them
+    void ReadBlockFiles(util::ThreadPool& pool);
+
+    /// Stage 2: deserialize and check one record
+    void CheckRecord(PendingBlock& pending);
+
+    /// Stage 3: hand a checked block to the chainstate, then its waiting children
+    void FeedBlock(PendingBlock& pending);
+
+    /// Feed blocks that were waiting for the given parent
+    void FeedChildren(const BlockHash& parent);
+
+    /// Process one block whose parent is known
+    void ProcessBlock(const Block& block, const BlockHash& hash,
+                      const db::DiskBlockPos& pos, bool fChecked);
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CHAIN_REINDEX_H
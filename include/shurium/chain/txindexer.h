@@ -0,0 +1,150 @@
+// SHURIUM - Background Transaction Indexer
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the background thread that keeps the optional
+// transaction index (-txindex) in step with the active chain.
+
+#ifndef SHURIUM_CHAIN_TXINDEXER_H
+#define SHURIUM_CHAIN_TXINDEXER_H
+
+#include "shurium/chain/blockindex.h"
+#include "shurium/core/block.h"
+#include "shurium/core/transaction.h"
+#include "shurium/db/blockdb.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace shurium {
+
+class ChainStateManager;
+namespace util { class ThreadPool; }
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Blocks read and indexed per batch while catching up
+static constexpr size_t DEFAULT_TXINDEX_BATCH_BLOCKS = 256;
+
+/// Seconds between progress log lines while catching up
+static constexpr int TXINDEX_PROGRESS_INTERVAL = 30;
+
+// ============================================================================
+// TxIndexer - Builds and maintains the transaction index
+// ============================================================================
+
+/// Tuning for TxIndexer
+struct TxIndexerOptions {
+    /// Threads reading blocks and computing entries (0 = one per core)
+    int nThreads{0};
+
+    /// Blocks per catch-up batch; each batch is one database write
+    size_t batchBlocks{DEFAULT_TXINDEX_BATCH_BLOCKS};
+};
+
+/**
+ * Keeps a db::TxIndex in step with the active chain.
+ *
+ * The index stores the locator of the last block it covers. On Start() a
+ * thread resumes from there (or from genesis for a new index) and walks the
+ * active chain in batches: the blocks of a batch are read from the block
+ * files and turned into index entries on a thread pool, then written with
+ * the batch's last block as the new locator in a single database write.
+ * Blocks on a branch that was reorganized away are unindexed first.
+ *
+ * Once the thread reaches the tip the indexer is synced and indexes each
+ * new tip directly from ChainStateManager's block-connected notification.
+ * If a notified block does not extend the indexed block, the thread takes
+ * over again until it is back at the tip.
+ */
+class TxIndexer {
+public:
+    TxIndexer(ChainStateManager& chainman, db::BlockDB& blockDB, db::TxIndex& txIndex,
+              const TxIndexerOptions& options = TxIndexerOptions());
+    ~TxIndexer();
+
+    TxIndexer(const TxIndexer&) = delete;
+    TxIndexer& operator=(const TxIndexer&) = delete;
+
+    /**
+     * Resume from the stored locator and start the sync thread.
+     * @return False if the index is disabled or already started
+     */
+    bool Start();
+
+    /// Stop the sync thread and stop following the chain
+    void Stop();
+
+    /// Whether the index has caught up with the active chain
+    bool IsSynced() const { return m_synced; }
+
+    /// Whether indexing stopped because block data could not be read
+    bool HasFailed() const { return m_failed; }
+
+    /// Last indexed block (null before the first block)
+    const BlockIndex* GetBestBlock() const;
+
+    /// Height of the last indexed block (-1 before the first block)
+    int GetBestHeight() const;
+
+    /**
+     * Wait until the index is synced.
+     * @return False on timeout, or if the indexer stopped or failed
+     */
+    bool WaitForSync(std::chrono::milliseconds timeout);
+
+    /**
+     * Look up a confirmed transaction.
+     * @param tx Output: the transaction
+     * @param hashBlock Output: hash of the block containing it
+     * @return False if the transaction is not indexed (yet)
+     */
+    bool FindTx(const TxHash& txid, TransactionRef& tx, BlockHash& hashBlock) const;
+
+private:
+    ChainStateManager& m_chainman;
+    db::BlockDB& m_blockDB;
+    db::TxIndex& m_txIndex;
+    TxIndexerOptions m_options;
+
+    /// Last indexed block; guarded by m_mutex
+    const BlockIndex* m_best{nullptr};
+
+    /// Set by notifications the sync thread must handle; guarded by m_mutex
+    bool m_wakeup{false};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_synced{false};
+    std::atomic<bool> m_failed{false};
+    std::atomic<bool> m_stop{false};
+
+    std::unique_ptr<util::ThreadPool> m_pool;
+    std::thread m_thread;
+    int m_callbackId{-1};
+
+    /// Sync thread: catch up with the active chain, then wait for work
+    void ThreadSync();
+
+    /**
+     * Index the next batch of blocks after m_best.
+     * @return Number of blocks indexed (0 at the tip or on failure)
+     */
+    size_t SyncBatch();
+
+    /// Unindex blocks from m_best back to pfork (sync thread only)
+    bool Rewind(const BlockIndex* pfork);
+
+    /// Block-connected notification from the chainstate
+    void BlockConnected(const Block& block, const BlockIndex* pindex);
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CHAIN_TXINDEXER_H
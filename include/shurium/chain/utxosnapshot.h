@@ -0,0 +1,137 @@
+// SHURIUM - UTXO Snapshots
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Export and import of the UTXO set as a single streaming file, so a new
+// node can start from a snapshot trusted in consensus::Params::assumeUtxo
+// instead of replaying the whole block history first.
+
+#ifndef SHURIUM_CHAIN_UTXOSNAPSHOT_H
+#define SHURIUM_CHAIN_UTXOSNAPSHOT_H
+
+#include "shurium/core/types.h"
+#include "shurium/consensus/params.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace shurium {
+
+namespace db { class CoinsViewDB; class DatabaseSnapshot; }
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Snapshot file format version
+static constexpr uint16_t UTXO_SNAPSHOT_VERSION = 1;
+
+/// Coins per checksummed chunk
+static constexpr uint32_t UTXO_SNAPSHOT_CHUNK_COINS = 4096;
+
+/// Largest chunk payload accepted when reading (guards against bad lengths)
+static constexpr uint32_t MAX_UTXO_SNAPSHOT_CHUNK_BYTES = 64 * 1024 * 1024;
+
+// ============================================================================
+// Snapshot Metadata
+// ============================================================================
+
+/**
+ * Description of a UTXO snapshot file.
+ *
+ * File layout (integers little-endian):
+ * - header: magic "sutxo", version (u16), network ID (string),
+ *   base block hash, base height (i32)
+ * - chunks: coin count (u32), payload size (u32), payload, checksum (u32).
+ *   The payload is the serialized (outpoint, coin) records in database key
+ *   order and the checksum is the first four bytes of its SHA256d. A chunk
+ *   with a coin count of zero ends the list.
+ * - footer: total coin count (u64), UTXO set hash
+ *
+ * The UTXO set hash is SHA256 over all payloads in order, which is exactly
+ * db::CalculateUTXOSetHash() of the database the snapshot was taken from.
+ */
+struct UTXOSnapshotMetadata {
+    std::string network;
+    BlockHash baseBlockHash;
+    int32_t baseHeight{-1};
+    uint64_t nCoins{0};
+    Hash256 utxoSetHash;
+};
+
+/// Outcome of a snapshot operation
+struct UTXOSnapshotResult {
+    bool success{false};
+    std::string error;
+    UTXOSnapshotMetadata metadata;
+    uint64_t nChunks{0};
+
+    static UTXOSnapshotResult Error(const std::string& msg) {
+        UTXOSnapshotResult result;
+        result.error = msg;
+        return result;
+    }
+};
+
+// ============================================================================
+// Snapshot Operations
+// ============================================================================
+
+/**
+ * Write every coin in a database snapshot to a snapshot file.
+ *
+ * The snapshot's best block becomes the snapshot base. The file is written
+ * under a temporary name and renamed into place once complete. Blocks may
+ * keep connecting while the dump runs; it reads the view as of the
+ * database snapshot only.
+ *
+ * @param coinsDB UTXO database (flush the coins cache first)
+ * @param snapshot View of coinsDB to dump
+ * @param baseHeight Height of the snapshot's best block
+ * @param network Network ID recorded in the header
+ * @param path Destination file (must not exist)
+ */
+UTXOSnapshotResult DumpUTXOSnapshot(const db::CoinsViewDB& coinsDB,
+                                    const db::DatabaseSnapshot& snapshot, int baseHeight,
+                                    const std::string& network,
+                                    const std::filesystem::path& path);
+
+/**
+ * Dump the database as it is now. baseHeight must be the height of its
+ * current best block; the dump is abandoned if the database has already
+ * moved on when its snapshot is taken.
+ */
+UTXOSnapshotResult DumpUTXOSnapshot(const db::CoinsViewDB& coinsDB, int baseHeight,
+                                    const std::string& network,
+                                    const std::filesystem::path& path);
+
+/**
+ * Read a snapshot's header (network, base block and height) only.
+ * Nothing beyond the header is checked.
+ */
+UTXOSnapshotResult ReadUTXOSnapshotHeader(const std::filesystem::path& path);
+
+/**
+ * Check a snapshot file without loading it.
+ *
+ * Every chunk checksum and the UTXO set hash are verified, and the snapshot
+ * must match an entry in params.assumeUtxo for its base block.
+ */
+UTXOSnapshotResult VerifyUTXOSnapshot(const std::filesystem::path& path,
+                                      const consensus::Params& params);
+
+/**
+ * Verify a snapshot and write its coins into an empty UTXO database.
+ *
+ * Coins are written chunk by chunk, and the best block is set to the
+ * snapshot base only after the last chunk, so a database with a null best
+ * block was never completely loaded. Coins already written are removed
+ * again if loading fails part-way.
+ */
+UTXOSnapshotResult LoadUTXOSnapshot(const std::filesystem::path& path,
+                                    const consensus::Params& params,
+                                    db::CoinsViewDB& coinsDB);
+
+} // namespace shurium
+
+#endif // SHURIUM_CHAIN_UTXOSNAPSHOT_H
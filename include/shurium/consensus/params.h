@@ -12,6 +12,7 @@
 #include "shurium/core/types.h"
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace shurium {
 namespace consensus {
@@ -20,6 +21,21 @@ namespace consensus {
 // Consensus Parameters
 // ============================================================================
 
+/// A UTXO set snapshot trusted for fast bootstrap (loadtxoutset)
+struct AssumeUtxoData {
+    /// Height of the snapshot's base block
+    int nHeight{0};
+    
+    /// Block the snapshot was taken at
+    BlockHash blockHash;
+    
+    /// Commitment to the snapshot's contents (db::CalculateUTXOSetHash)
+    Hash256 utxoSetHash;
+    
+    /// Number of coins in the snapshot
+    uint64_t nCoins{0};
+};
+
 /// Parameters that influence chain consensus
 struct Params {
     // ========================================================================
@@ -135,6 +151,27 @@ struct Params {
     /// Whether PoUW is optional (for gradual rollout)
     bool fPoUWOptional;
     
+    // ========================================================================
+    // Initial Sync Parameters
+    // ========================================================================
+    
+    /// Default -assumevalid block; scripts of its ancestors are not verified
+    /// (null = verify all scripts)
+    BlockHash defaultAssumeValid;
+    
+    /// UTXO snapshots that may be loaded in place of validating history
+    std::vector<AssumeUtxoData> assumeUtxo;
+    
+    /// Find the trusted snapshot taken at a block (null if none)
+    const AssumeUtxoData* AssumeUtxoForBlock(const BlockHash& hash) const {
+        for (const auto& data : assumeUtxo) {
+            if (data.blockHash == hash) {
+                return &data;
+            }
+        }
+        return nullptr;
+    }
+    
     // ========================================================================
     // Helper Methods
     // ========================================================================
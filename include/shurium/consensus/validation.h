@@ -12,10 +12,16 @@
 #include "shurium/core/transaction.h"
 #include "shurium/consensus/params.h"
 #include <string>
+#include <vector>
 
 namespace shurium {
+
+namespace util { class ThreadPool; }
+
 namespace consensus {
 
+class CheckpointManager;
+
 // ============================================================================
 // Validation State
 // ============================================================================
@@ -81,6 +87,27 @@ public:
 /// @return True if valid
 bool CheckBlockHeader(const Block& block, ValidationState& state, const Params& params);
 
+/// Headers per proof-of-work task when a headers batch is checked in parallel
+static constexpr size_t HEADER_CHECK_CHUNK = 250;
+
+/**
+ * Check a run of headers, each building on the one before, as they come in
+ * a headers message. Covers what CheckBlockHeader does for each, that they
+ * link up, and the checkpoints at the heights they span, looked up in one
+ * pass. Proof of work is checked in chunks on pool when one is given.
+ *
+ * @param headers The headers, in chain order
+ * @param hashes Their hashes (GetBlockHeaderHashes)
+ * @param firstHeight Height of headers[0]
+ * @param checkpoints Checkpoints to hold the headers to (null = none)
+ * @param state Why the first failing header failed
+ * @return Number of leading headers that pass
+ */
+size_t CheckHeaderBatch(const std::vector<BlockHeader>& headers,
+                        const std::vector<BlockHash>& hashes, int32_t firstHeight,
+                        const Params& params, const CheckpointManager* checkpoints,
+                        ValidationState& state, util::ThreadPool* pool = nullptr);
+
 /// Check block for validity (no context needed)
 /// This checks:
 /// - Block has transactions
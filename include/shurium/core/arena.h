@@ -0,0 +1,117 @@
+// SHURIUM - Arena Allocation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A bump allocator for objects that are created together and freed
+// together, such as the transactions of a block being deserialized.
+// Memory comes from a few large chunks; individual frees are no-ops and
+// everything is released when the arena is destroyed.
+
+#ifndef SHURIUM_CORE_ARENA_H
+#define SHURIUM_CORE_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Arena
+// ============================================================================
+
+/**
+ * Monotonic allocation region.
+ *
+ * Allocations are carved from the current chunk; when it runs out a new
+ * one twice the size is added. Not thread-safe: fill it from one thread,
+ * after which objects in it may be shared freely.
+ */
+class Arena {
+public:
+    /// Smallest chunk the arena allocates
+    static constexpr size_t MIN_CHUNK_SIZE = 4096;
+
+    /// Largest chunk added when the arena grows on its own
+    static constexpr size_t MAX_CHUNK_SIZE = 4 * 1024 * 1024;
+
+    /// An arena whose first chunk holds initialSize bytes
+    explicit Arena(size_t initialSize = MIN_CHUNK_SIZE);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /// Memory for size bytes at the given alignment (a power of two)
+    void* Allocate(size_t size, size_t align) {
+        uintptr_t aligned = (cursor_ + align - 1) & ~static_cast<uintptr_t>(align - 1);
+        if (aligned + size > end_ || cursor_ == 0) {
+            return AllocateSlow(size, align);
+        }
+        cursor_ = aligned + size;
+        used_ += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    /// Bytes handed out
+    size_t GetUsedBytes() const { return used_; }
+
+    /// Bytes held in chunks
+    size_t GetReservedBytes() const { return reserved_; }
+
+    /// Chunks allocated
+    size_t GetChunkCount() const { return chunks_.size(); }
+
+private:
+    void* AllocateSlow(size_t size, size_t align);
+
+    std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+    uintptr_t cursor_{0};
+    uintptr_t end_{0};
+    size_t nextChunkSize_;
+    size_t used_{0};
+    size_t reserved_{0};
+};
+
+// ============================================================================
+// ArenaAllocator
+// ============================================================================
+
+/**
+ * Standard allocator drawing from a shared Arena.
+ *
+ * Each copy holds a reference to the arena, so memory handed out stays
+ * valid as long as anything allocated from it (a shared_ptr control block
+ * from std::allocate_shared, say) is alive.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) : arena_(std::move(arena)) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.GetArena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) {}
+
+    const std::shared_ptr<Arena>& GetArena() const { return arena_; }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena_ == other.GetArena(); }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena_ != other.GetArena(); }
+
+private:
+    std::shared_ptr<Arena> arena_;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CORE_ARENA_H
@@ -11,10 +11,12 @@
 #include "shurium/core/types.h"
 #include "shurium/core/transaction.h"
 #include "shurium/core/serialize.h"
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 
 namespace shurium {
 
@@ -67,6 +69,9 @@ public:
     /// Compute the block hash (double SHA256 of serialized header)
     BlockHash GetHash() const;
 
+    /// Write the 80-byte serialized header to out
+    void SerializeTo(uint8_t* out) const;
+
     /// Get block timestamp as Unix time
     int64_t GetBlockTime() const {
         return static_cast<int64_t>(nTime);
@@ -97,6 +102,13 @@ void Unserialize(Stream& s, BlockHeader& header) {
     Unserialize(s, header.nNonce);
 }
 
+/// Serialized size of a block header
+static constexpr size_t BLOCK_HEADER_SIZE = 80;
+
+/// Hashes of a run of headers, computed several at a time; the same as
+/// calling GetHash() on each
+std::vector<BlockHash> GetBlockHeaderHashes(const std::vector<BlockHeader>& headers);
+
 // ============================================================================
 // Block - Complete block with header and transactions
 // ============================================================================
@@ -113,6 +125,20 @@ public:
         SetNull();
     }
 
+    // Copies start without the cached hash
+    Block(const Block& other) : BlockHeader(other), vtx(other.vtx) {}
+    Block(Block&& other) noexcept : BlockHeader(other), vtx(std::move(other.vtx)) {}
+    Block& operator=(const Block& other) {
+        BlockHeader::operator=(other);
+        vtx = other.vtx;
+        return *this;
+    }
+    Block& operator=(Block&& other) noexcept {
+        BlockHeader::operator=(other);
+        vtx = std::move(other.vtx);
+        return *this;
+    }
+
     /// Construct from a header (copies header, leaves transactions empty)
     explicit Block(const BlockHeader& header) {
         SetNull();
@@ -143,6 +169,11 @@ public:
         return header;
     }
 
+    /// The block hash, computed once and reused while the header fields
+    /// stay the same (they are public, so each call checks the header
+    /// against the one the hash was computed from)
+    BlockHash GetHash() const;
+
     /// Compute the merkle root from the transactions
     Hash256 ComputeMerkleRoot() const;
 
@@ -151,6 +182,12 @@ public:
 
     /// Convert to human-readable string
     std::string ToString() const;
+
+private:
+    mutable std::mutex m_hashMutex;
+    mutable bool m_hashCached{false};
+    mutable uint8_t m_hashedHeader[BLOCK_HEADER_SIZE];
+    mutable BlockHash m_hash;
 };
 
 /// Serialization for Block
@@ -186,6 +223,35 @@ void Unserialize(Stream& s, Block& block) {
     }
 }
 
+/**
+ * Deserialize a block with its transactions allocated together in one
+ * arena, sized from the transaction count, instead of one heap allocation
+ * each. Meant for blocks being received or read back from disk in bulk.
+ *
+ * The transactions are ordinary TransactionRefs; one that outlives the
+ * block (returned to the mempool by a reorg, say) keeps the arena alive.
+ * Their inputs, outputs and scripts are still separate allocations.
+ */
+template<typename Stream>
+void UnserializeWithArena(Stream& s, Block& block) {
+    Unserialize(s, static_cast<BlockHeader&>(block));
+    
+    uint64_t txCount = ReadCompactSize(s);
+    // Every transaction takes at least 10 bytes, so sizing by the data
+    // actually present bounds what a bad count can reserve
+    uint64_t sizeHint = std::min<uint64_t>(txCount, s.size() / 10);
+    auto arena = std::make_shared<Arena>(static_cast<size_t>(sizeHint) *
+                                         ARENA_BYTES_PER_TRANSACTION);
+    
+    block.vtx.clear();
+    block.vtx.reserve(sizeHint);
+    for (uint64_t i = 0; i < txCount; ++i) {
+        MutableTransaction mtx;
+        Unserialize(s, mtx);
+        block.vtx.push_back(MakeTransactionRef(std::move(mtx), arena));
+    }
+}
+
 // ============================================================================
 // BlockLocator - For finding common ancestors in chain synchronization
 // ============================================================================
@@ -0,0 +1,166 @@
+// SHURIUM - Compact Block Filters
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines Golomb-coded set filters over the scripts a block pays
+// and spends (BIP158 style), which let light clients and wallet rescans
+// skip blocks that cannot concern them.
+
+#ifndef SHURIUM_CORE_BLOCKFILTER_H
+#define SHURIUM_CORE_BLOCKFILTER_H
+
+#include "shurium/core/block.h"
+#include "shurium/core/script.h"
+#include "shurium/core/types.h"
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Golomb-Rice parameter of the basic filter (bits of each remainder)
+static constexpr uint8_t BASIC_FILTER_P = 19;
+
+/// Inverse false-positive rate of the basic filter
+static constexpr uint32_t BASIC_FILTER_M = 784931;
+
+// ============================================================================
+// GCSFilter - Golomb-coded set
+// ============================================================================
+
+/// SipHash key and coding parameters of a GCSFilter
+struct GCSFilterParams {
+    uint64_t k0{0};
+    uint64_t k1{0};
+    uint8_t P{BASIC_FILTER_P};
+    uint32_t M{BASIC_FILTER_M};
+};
+
+/**
+ * A set of byte strings stored as a sorted list of hashes, delta-coded with
+ * Golomb-Rice coding.
+ *
+ * Each element is hashed with SipHash-2-4 under the filter key and mapped
+ * onto [0, N * M). A query for an element not in the set matches with
+ * probability about 1/M. Elements cannot be listed back out, and matching
+ * decodes the whole filter, so a batch of queries should go through
+ * MatchAny() rather than repeated Match() calls.
+ */
+class GCSFilter {
+public:
+    using Element = std::vector<uint8_t>;
+    using ElementSet = std::set<Element>;
+    using Params = GCSFilterParams;
+
+    /// Empty filter
+    explicit GCSFilter(const Params& params = Params());
+
+    /// Filter over a set of elements
+    GCSFilter(const Params& params, const ElementSet& elements);
+
+    /**
+     * Filter from its encoding (element count, then the Golomb-Rice stream).
+     * Throws std::ios_base::failure if the encoding is malformed.
+     */
+    GCSFilter(const Params& params, std::vector<uint8_t> encoded);
+
+    const Params& GetParams() const { return m_params; }
+    uint32_t GetN() const { return m_N; }
+    const std::vector<uint8_t>& GetEncoded() const { return m_encoded; }
+
+    /// Whether the element may be in the set (false positives at 1/M)
+    bool Match(const Element& element) const;
+
+    /// Whether any of the elements may be in the set, in one decoding pass
+    bool MatchAny(const ElementSet& elements) const;
+
+private:
+    Params m_params;
+    uint32_t m_N{0};
+    uint64_t m_F{0};
+    std::vector<uint8_t> m_encoded;
+
+    /// Map an element onto [0, F)
+    uint64_t HashToRange(const Element& element) const;
+
+    /// Sorted ranges of the queried elements
+    std::vector<uint64_t> BuildHashedSet(const ElementSet& elements) const;
+
+    /// Walk the stream against sorted query hashes
+    bool MatchInternal(const std::vector<uint64_t>& queries) const;
+};
+
+// ============================================================================
+// BlockFilter
+// ============================================================================
+
+/// Filter types, as numbered on the wire
+enum class BlockFilterType : uint8_t {
+    BASIC = 0,
+    INVALID = 255,
+};
+
+/// Name of a filter type ("basic"), for options and RPC
+const std::string& BlockFilterTypeName(BlockFilterType type);
+
+/// Filter type from its name
+std::optional<BlockFilterType> BlockFilterTypeFromName(const std::string& name);
+
+/**
+ * The filter of one block. The basic filter holds every output script the
+ * block creates, except empty and OP_RETURN ones, and the script of every
+ * output it spends. A wallet looking for its own scripts therefore finds
+ * both the blocks paying it and the blocks spending from it.
+ *
+ * The filter key is the first 16 bytes of the block hash, so a peer cannot
+ * pick elements that collide in every block.
+ */
+class BlockFilter {
+public:
+    BlockFilter() = default;
+
+    /**
+     * Build a block's filter.
+     * @param spentScripts Scripts of the outputs the block spends, taken
+     *                     from its undo data
+     */
+    BlockFilter(BlockFilterType type, const Block& block,
+                const std::vector<Script>& spentScripts);
+
+    /// Filter from its encoding; throws std::ios_base::failure if malformed
+    BlockFilter(BlockFilterType type, const BlockHash& blockHash,
+                std::vector<uint8_t> encoded);
+
+    BlockFilterType GetType() const { return m_type; }
+    const BlockHash& GetBlockHash() const { return m_blockHash; }
+    const GCSFilter& GetFilter() const { return m_filter; }
+    const std::vector<uint8_t>& GetEncodedFilter() const { return m_filter.GetEncoded(); }
+
+    /// Double SHA256 of the encoded filter
+    Hash256 GetHash() const;
+
+    /// Header committing to this filter and every earlier one
+    Hash256 ComputeHeader(const Hash256& prevHeader) const;
+
+    /// Elements of a block's basic filter
+    static GCSFilter::ElementSet BasicFilterElements(const Block& block,
+                                                     const std::vector<Script>& spentScripts);
+
+private:
+    BlockFilterType m_type{BlockFilterType::INVALID};
+    BlockHash m_blockHash;
+    GCSFilter m_filter;
+
+    /// Parameters for a type keyed on m_blockHash; false for unknown types
+    bool BuildParams(GCSFilter::Params& params) const;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CORE_BLOCKFILTER_H
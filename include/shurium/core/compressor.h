@@ -0,0 +1,132 @@
+// SHURIUM - Output Compression Header
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the compact encodings for amounts and scriptPubKeys
+// used by on-disk formats such as the block undo files.
+
+#ifndef SHURIUM_CORE_COMPRESSOR_H
+#define SHURIUM_CORE_COMPRESSOR_H
+
+#include "shurium/core/types.h"
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/core/serialize.h"
+#include <cstdint>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Amount Compression
+// ============================================================================
+
+/**
+ * Map an amount to a smaller integer for VarInt storage.
+ *
+ * Trailing decimal zeros are factored out, so round amounts such as block
+ * rewards or 0.01 SHR payments take one or two bytes instead of eight.
+ * DecompressAmount(CompressAmount(n)) == n for every n up to MAX_MONEY.
+ */
+uint64_t CompressAmount(uint64_t n);
+
+/// Inverse of CompressAmount()
+uint64_t DecompressAmount(uint64_t x);
+
+// ============================================================================
+// Script Compression
+// ============================================================================
+
+/**
+ * Compressed script layout: a VarInt type code followed by its payload.
+ *
+ *   0      P2PKH, followed by the 20-byte key hash
+ *   1      P2SH, followed by the 20-byte script hash
+ *   2, 3   P2PK with a compressed key, followed by its x coordinate
+ *          (the type is 2 plus the parity of y)
+ *   4, 5   P2PK with an uncompressed key, followed by its x coordinate
+ *          (the type is 4 plus the parity of y); y is recomputed on read
+ *   n >= 6 any other script, followed by its n - 6 raw bytes
+ */
+static constexpr unsigned int NUM_SPECIAL_SCRIPTS = 6;
+
+/// Script compression type codes
+static constexpr unsigned int SCRIPT_TYPE_P2PKH = 0;
+static constexpr unsigned int SCRIPT_TYPE_P2SH = 1;
+static constexpr unsigned int SCRIPT_TYPE_P2PK_COMPRESSED = 2;
+static constexpr unsigned int SCRIPT_TYPE_P2PK_UNCOMPRESSED = 4;
+
+/// Size of the payload that follows a special type code
+unsigned int GetSpecialScriptSize(unsigned int nType);
+
+/**
+ * Compress a script that matches one of the special templates.
+ * @param out Receives the type code followed by the payload
+ * @return False if the script is not a special template
+ */
+bool CompressScript(const Script& script, std::vector<uint8_t>& out);
+
+/**
+ * Rebuild a special-template script.
+ * @param in Payload of GetSpecialScriptSize(nType) bytes
+ * @return False for unknown type codes, or an x coordinate off the curve
+ */
+bool DecompressScript(Script& script, unsigned int nType, const std::vector<uint8_t>& in);
+
+template<typename Stream>
+void SerializeCompressedScript(Stream& s, const Script& script) {
+    std::vector<uint8_t> compressed;
+    if (CompressScript(script, compressed)) {
+        s.Write(compressed.data(), compressed.size());
+        return;
+    }
+    WriteVarInt(s, script.size() + NUM_SPECIAL_SCRIPTS);
+    if (!script.empty()) {
+        s.Write(script.data(), script.size());
+    }
+}
+
+template<typename Stream>
+void UnserializeCompressedScript(Stream& s, Script& script) {
+    uint64_t nSize = ReadVarInt(s);
+    if (nSize < NUM_SPECIAL_SCRIPTS) {
+        unsigned int nType = static_cast<unsigned int>(nSize);
+        std::vector<uint8_t> payload(GetSpecialScriptSize(nType));
+        if (!payload.empty()) {
+            s.Read(payload.data(), payload.size());
+        }
+        if (!DecompressScript(script, nType, payload)) {
+            throw std::ios_base::failure("UnserializeCompressedScript(): unknown script type");
+        }
+        return;
+    }
+    nSize -= NUM_SPECIAL_SCRIPTS;
+    if (nSize > MAX_SIZE) {
+        throw std::ios_base::failure("UnserializeCompressedScript(): script too large");
+    }
+    script.resize(nSize);
+    if (nSize > 0) {
+        s.Read(script.data(), nSize);
+    }
+}
+
+// ============================================================================
+// TxOut Compression
+// ============================================================================
+
+/// Serialize an output as compressed amount plus compressed script
+template<typename Stream>
+void SerializeCompressedTxOut(Stream& s, const TxOut& out) {
+    WriteVarInt(s, CompressAmount(static_cast<uint64_t>(out.nValue)));
+    SerializeCompressedScript(s, out.scriptPubKey);
+}
+
+template<typename Stream>
+void UnserializeCompressedTxOut(Stream& s, TxOut& out) {
+    out.nValue = static_cast<Amount>(DecompressAmount(ReadVarInt(s)));
+    UnserializeCompressedScript(s, out.scriptPubKey);
+}
+
+} // namespace shurium
+
+#endif // SHURIUM_CORE_COMPRESSOR_H
@@ -17,6 +17,13 @@ namespace shurium {
 // Use uint8_t directly to avoid circular dependency with types.h
 using HexByte = uint8_t;
 
+/// Write the lowercase hex of data (2 * len characters) to out
+void EncodeHex(const HexByte* data, size_t len, char* out);
+
+/// Decode 2 * len hex characters (either case) into len bytes at out;
+/// false if any character is not a hex digit (out is then unspecified)
+bool DecodeHex(const char* hex, size_t len, HexByte* out);
+
 /// Convert bytes to hex string
 std::string BytesToHex(const HexByte* data, size_t len);
 std::string BytesToHex(const std::vector<HexByte>& data);
@@ -32,6 +39,30 @@ std::vector<HexByte> HexToBytes(const std::string& hex);
 /// Check if string is valid hex
 bool IsValidHex(const std::string& str);
 
+// ============================================================================
+// Implementations
+// ============================================================================
+
+/// Implementations of EncodeHex and DecodeHex
+enum class HexImplementation {
+    SCALAR,     ///< Portable C++ (always available)
+    SSSE3,      ///< x86 SSSE3, 16 bytes at a time
+    AVX2,       ///< x86 AVX2, 32 bytes at a time
+    NEON,       ///< ARM NEON, 16 bytes at a time
+};
+
+/// Human-readable name of an implementation
+const char* HexImplementationName(HexImplementation impl);
+
+/// The implementation in use (the fastest the CPU supports, by default)
+HexImplementation GetHexImplementation();
+
+/// Implementations built in that the CPU supports
+std::vector<HexImplementation> GetAvailableHexImplementations();
+
+/// Switch implementation (tests and benchmarks); false if unavailable
+bool SetHexImplementation(HexImplementation impl);
+
 /// Reverse bytes (for display purposes)
 std::vector<HexByte> ReverseBytes(const HexByte* data, size_t len);
 
@@ -44,6 +44,18 @@ Hash256 ComputeMerkleRoot(std::vector<Hash256> leaves, bool* mutated = nullptr);
 /// inclusion without knowing all other leaves.
 std::vector<Hash256> ComputeMerklePath(const std::vector<Hash256>& leaves, uint32_t position);
 
+/// Compute the root a leaf and its Merkle path lead to.
+///
+/// @param leaf The leaf hash
+/// @param position The leaf's position
+/// @param proof The Merkle path (from ComputeMerklePath)
+/// @return The root, in O(log n) hashes
+///
+/// A block template keeps the path of its coinbase, so changing the
+/// coinbase updates the root without rehashing every transaction.
+Hash256 ComputeMerkleRootFromPath(const Hash256& leaf, uint32_t position,
+                                  const std::vector<Hash256>& proof);
+
 /// Verify a Merkle proof.
 ///
 /// @param leaf The leaf hash to verify
@@ -2,8 +2,11 @@
 // Copyright (c) 2024 SHURIUM Developers
 // MIT License
 //
-// This file provides cryptographically secure random number generation
-// using OS entropy sources.
+// This file provides cryptographically secure random number generation.
+// Output comes from a per-thread ChaCha20 stream seeded (and periodically
+// reseeded) from the OS entropy source, so most requests cost no syscall.
+// FastRandomContext is a much cheaper generator for uses that only need
+// unpredictable-enough numbers, such as shuffles and bucket choices.
 
 #ifndef SHURIUM_CORE_RANDOM_H
 #define SHURIUM_CORE_RANDOM_H
@@ -12,18 +15,33 @@
 #include <cstdint>
 #include <cstddef>
 #include <algorithm>
+#include <chrono>
 #include <iterator>
+#include <limits>
 
 namespace shurium {
 
+/// Output a thread's generator produces before reseeding from the OS
+static constexpr uint64_t RNG_RESEED_BYTES = 1 << 20;
+
+/// Longest a thread's generator goes without reseeding from the OS
+static constexpr std::chrono::seconds RNG_RESEED_INTERVAL{300};
+
 // ============================================================================
 // Core Random Functions
 // ============================================================================
 
 /// Fill buffer with cryptographically secure random bytes
-/// Uses OS entropy source (getrandom on Linux, arc4random on macOS/BSD)
+/// Drawn from the calling thread's ChaCha20 generator, which is seeded from
+/// the OS (getrandom on Linux, arc4random on macOS/BSD), rekeyed after every
+/// refill, reseeded every RNG_RESEED_BYTES or RNG_RESEED_INTERVAL, and
+/// reseeded in the child after fork()
 void GetRandBytes(uint8_t* buf, size_t len);
 
+/// Fill buffer directly from the OS entropy source, for long-lived secrets
+/// such as wallet seeds where the syscall does not matter
+void GetStrongRandBytes(uint8_t* buf, size_t len);
+
 /// Fill buffer with random bytes (Span version)
 inline void GetRandBytes(Span<uint8_t> buf) {
     GetRandBytes(buf.data(), buf.size());
@@ -68,12 +86,73 @@ void Shuffle(RandomIt first, RandomIt last) {
     }
 }
 
+// ============================================================================
+// FastRandomContext
+// ============================================================================
+
+/**
+ * Fast non-cryptographic generator (xoshiro256++).
+ *
+ * Seeded from GetRandBytes, so its output is not guessable from outside,
+ * but the state can be recovered from enough output: use it for shuffles,
+ * sampling and bucket choices, never for keys, nonces or salts. Satisfies
+ * UniformRandomBitGenerator, so it works with std::shuffle and the
+ * standard distributions. Not thread-safe; keep one per thread or object.
+ */
+class FastRandomContext {
+public:
+    using result_type = uint64_t;
+
+    /// Seeded from the secure generator
+    FastRandomContext();
+
+    /// Deterministically seeded, for tests and reproducible simulations
+    explicit FastRandomContext(uint64_t seed);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() { return Rand64(); }
+
+    uint64_t Rand64() {
+        uint64_t result = Rotl(s_[0] + s_[3], 23) + s_[0];
+        uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = Rotl(s_[3], 45);
+        return result;
+    }
+
+    uint32_t Rand32() { return static_cast<uint32_t>(Rand64() >> 32); }
+
+    /// Uniform integer in [0, range); 0 when range is 0
+    uint64_t RandRange(uint64_t range);
+
+    bool RandBool() { return (Rand64() >> 63) != 0; }
+
+    /// Uniform double in [0, 1)
+    double RandDouble() { return static_cast<double>(Rand64() >> 11) * 0x1.0p-53; }
+
+private:
+    static uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    void Seed(uint64_t seed);
+
+    uint64_t s_[4];
+};
+
 // ============================================================================
 // Internal Entropy Functions (Platform-Specific)
 // ============================================================================
 
 namespace detail {
 
+/// One 64-byte ChaCha20 block (the original 64-bit counter and nonce layout)
+void ChaCha20Block(const uint32_t key[8], uint64_t counter, uint64_t nonce, uint8_t out[64]);
+
 /// Get entropy from OS - implementation is platform-specific
 /// Returns true on success, false on failure
 bool GetOSEntropy(uint8_t* buf, size_t len);
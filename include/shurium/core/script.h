@@ -194,10 +194,13 @@ public:
 class ScriptNum {
 public:
     static constexpr size_t DEFAULT_MAX_NUM_SIZE = 4;
+    
+    /// Longest encoding of an int64_t: eight magnitude bytes and a sign byte
+    static constexpr size_t MAX_SERIALIZED_SIZE = 9;
 
     explicit ScriptNum(int64_t n) : value_(n) {}
     
-    explicit ScriptNum(const std::vector<uint8_t>& bytes, 
+    explicit ScriptNum(Span<const uint8_t> bytes, 
                        bool requireMinimal = true,
                        size_t maxNumSize = DEFAULT_MAX_NUM_SIZE);
 
@@ -223,9 +226,12 @@ public:
     
     /// Serialize a value to bytes
     static std::vector<uint8_t> Serialize(int64_t value);
+    
+    /// Serialize into out (MAX_SERIALIZED_SIZE bytes), returning the length
+    static size_t Serialize(int64_t value, uint8_t* out);
 
 private:
-    static int64_t SetBytes(const std::vector<uint8_t>& bytes);
+    static int64_t SetBytes(Span<const uint8_t> bytes);
     int64_t value_;
 };
 
@@ -269,6 +275,9 @@ public:
     bool GetOp(const_iterator& pc, Opcode& opcodeRet, std::vector<uint8_t>& dataRet) const;
     bool GetOp(const_iterator& pc, Opcode& opcodeRet) const;
     
+    /// Same, with dataRet viewing the pushed bytes inside this script
+    bool GetOp(const_iterator& pc, Opcode& opcodeRet, Span<const uint8_t>& dataRet) const;
+    
     // ========================================================================
     // Script Pattern Detection
     // ========================================================================
@@ -347,6 +356,70 @@ private:
     Script& PushInt64(int64_t n);
 };
 
+/**
+ * Decode the operation at pc in serialized script bytes ending at end,
+ * advancing pc past it. dataRet views the pushed bytes, if any.
+ * @return false if the script is truncated at pc
+ */
+bool GetScriptOp(const uint8_t*& pc, const uint8_t* end, Opcode& opcodeRet,
+                 Span<const uint8_t>& dataRet);
+
+// ============================================================================
+// Decoded Script
+// ============================================================================
+
+/// One operation of a decoded script, located by byte offsets
+struct ScriptOp {
+    Opcode opcode;
+    uint32_t dataOffset;  ///< Start of the pushed bytes, if any
+    uint32_t dataSize;    ///< Number of pushed bytes
+    uint32_t end;         ///< Offset just past the operation
+};
+
+/**
+ * A script tokenized once into its operations, so that sigop counting,
+ * the push-only and valid-op checks and execution do not each re-parse
+ * the bytes.
+ *
+ * The decoded form views the script it was built from, which must outlive
+ * it and not change.
+ */
+class DecodedScript {
+public:
+    DecodedScript() = default;
+    explicit DecodedScript(const Script& script);
+
+    /// The serialized script the operations point into
+    Span<const uint8_t> bytes() const { return Span<const uint8_t>(data_, size_); }
+    size_t size() const { return size_; }
+
+    /// Operations up to the end of the script or the truncated one
+    const std::vector<ScriptOp>& ops() const { return ops_; }
+
+    /// True if the script ends in the middle of an operation
+    bool IsTruncated() const { return truncated_; }
+
+    /// The bytes pushed by op
+    Span<const uint8_t> Data(const ScriptOp& op) const {
+        return Span<const uint8_t>(data_ + op.dataOffset, op.dataSize);
+    }
+
+    /// Same as Script::IsPushOnly
+    bool IsPushOnly() const;
+
+    /// Same as Script::HasValidOps
+    bool HasValidOps() const;
+
+    /// Same as Script::GetSigOpCount
+    unsigned int GetSigOpCount(bool accurate = false) const;
+
+private:
+    const uint8_t* data_{nullptr};
+    size_t size_{0};
+    std::vector<ScriptOp> ops_;
+    bool truncated_{false};
+};
+
 // ============================================================================
 // Serialization
 // ============================================================================
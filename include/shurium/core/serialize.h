@@ -37,6 +37,14 @@ static constexpr unsigned int MAX_VECTOR_ALLOCATE = 5000000;
 // Endianness Helpers (Always Little-Endian for serialization)
 // ============================================================================
 
+// glibc's <endian.h> defines these names as macros; use our own versions.
+#undef htole16
+#undef htole32
+#undef htole64
+#undef le16toh
+#undef le32toh
+#undef le64toh
+
 namespace detail {
 
 inline uint16_t htole16(uint16_t host) {
@@ -209,6 +217,62 @@ public:
     DataStream& operator>>(T& obj);
 };
 
+// ============================================================================
+// SpanReader - Deserialize from borrowed memory without copying it
+// ============================================================================
+
+class SpanReader {
+public:
+    using value_type = uint8_t;
+    using size_type = std::size_t;
+
+private:
+    const uint8_t* data_;
+    size_type size_;
+
+public:
+    /// Read from [data, data + len); the memory must outlive the reader
+    SpanReader(const uint8_t* data, size_type len) : data_(data), size_(len) {}
+    
+    /// Read a byte buffer in place (not a temporary: it must outlive the reader)
+    explicit SpanReader(const std::vector<uint8_t>& data)
+        : data_(data.data()), size_(data.size()) {}
+    explicit SpanReader(std::vector<uint8_t>&&) = delete;
+    
+    /// Returns unread bytes remaining
+    size_type size() const noexcept { return size_; }
+    
+    bool empty() const noexcept { return size_ == 0; }
+    
+    /// Get pointer to unread data
+    const uint8_t* data() const noexcept { return data_; }
+    
+    void Read(uint8_t* dst, size_type len) {
+        if (len > size_) {
+            throw std::ios_base::failure("SpanReader::Read(): end of data");
+        }
+        std::memcpy(dst, data_, len);
+        data_ += len;
+        size_ -= len;
+    }
+    
+    void Read(char* dst, size_type len) {
+        Read(reinterpret_cast<uint8_t*>(dst), len);
+    }
+    
+    /// Skip n bytes
+    void Ignore(size_type n) {
+        if (n > size_) {
+            throw std::ios_base::failure("SpanReader::Ignore(): end of data");
+        }
+        data_ += n;
+        size_ -= n;
+    }
+    
+    template<typename T>
+    SpanReader& operator>>(T& obj);
+};
+
 // ============================================================================
 // Low-Level Serialization Functions
 // ============================================================================
@@ -322,6 +386,51 @@ uint64_t ReadCompactSize(Stream& s, bool range_check = true) {
     return size;
 }
 
+// ============================================================================
+// VarInt Encoding
+// ============================================================================
+// Variable-length integers for internal storage formats (not the wire):
+// 7 bits per byte, most significant group first, high bit set on all but
+// the last byte. One is subtracted per continuation byte so every value has
+// exactly one encoding (0..127 -> 1 byte, 128..16511 -> 2 bytes, ...).
+
+template<typename Stream>
+void WriteVarInt(Stream& s, uint64_t n) {
+    uint8_t tmp[(sizeof(n) * 8 + 6) / 7];
+    int len = 0;
+    while (true) {
+        tmp[len] = static_cast<uint8_t>(n & 0x7F) | (len ? 0x80 : 0x00);
+        if (n <= 0x7F) {
+            break;
+        }
+        n = (n >> 7) - 1;
+        ++len;
+    }
+    do {
+        ser_writedata8(s, tmp[len]);
+    } while (len--);
+}
+
+template<typename Stream>
+uint64_t ReadVarInt(Stream& s) {
+    uint64_t n = 0;
+    while (true) {
+        uint8_t byte = ser_readdata8(s);
+        if (n > (std::numeric_limits<uint64_t>::max() >> 7)) {
+            throw std::ios_base::failure("ReadVarInt(): size too large");
+        }
+        n = (n << 7) | (byte & 0x7F);
+        if (byte & 0x80) {
+            if (n == std::numeric_limits<uint64_t>::max()) {
+                throw std::ios_base::failure("ReadVarInt(): size too large");
+            }
+            ++n;
+        } else {
+            return n;
+        }
+    }
+}
+
 // ============================================================================
 // Serialize/Unserialize for Basic Types
 // ============================================================================
@@ -550,6 +659,12 @@ DataStream& DataStream::operator>>(T& obj) {
     return *this;
 }
 
+template<typename T>
+SpanReader& SpanReader::operator>>(T& obj) {
+    Unserialize(*this, obj);
+    return *this;
+}
+
 } // namespace shurium
 
 #endif // SHURIUM_CORE_SERIALIZE_H
@@ -8,9 +8,11 @@
 #ifndef SHURIUM_CORE_TRANSACTION_H
 #define SHURIUM_CORE_TRANSACTION_H
 
+#include "shurium/core/arena.h"
 #include "shurium/core/types.h"
 #include "shurium/core/script.h"
 #include "shurium/core/serialize.h"
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <string>
@@ -274,6 +276,37 @@ void Unserialize(Stream& s, MutableTransaction& tx) {
     Unserialize(s, tx.nLockTime);
 }
 
+// ============================================================================
+// TransactionScriptCache - Decoded scripts of a transaction
+// ============================================================================
+
+/**
+ * Decoded scriptSigs and scriptPubKeys of one transaction, built together
+ * the first time any of them is needed. Threads checking inputs in
+ * parallel may race to build it; one result wins and the rest are freed.
+ *
+ * The decoded scripts point into the transaction's own inputs and outputs,
+ * so a copy of the cache starts out empty.
+ */
+class TransactionScriptCache {
+public:
+    struct Entries {
+        std::vector<DecodedScript> scriptSigs;
+        std::vector<DecodedScript> scriptPubKeys;
+    };
+
+    TransactionScriptCache() = default;
+    TransactionScriptCache(const TransactionScriptCache&) {}
+    TransactionScriptCache& operator=(const TransactionScriptCache&) = delete;
+    ~TransactionScriptCache() { delete entries_.load(std::memory_order_relaxed); }
+
+    /// The decoded scripts of vin and vout, which must not change
+    const Entries& Get(const std::vector<TxIn>& vin, const std::vector<TxOut>& vout) const;
+
+private:
+    mutable std::atomic<const Entries*> entries_{nullptr};
+};
+
 // ============================================================================
 // Transaction - Immutable Transaction
 // ============================================================================
@@ -298,9 +331,16 @@ private:
     /// Cached transaction hash (computed once)
     const TxHash hash;
 
+    /// Cached serialized size (there is no witness data, so this is also
+    /// the stripped size)
+    const uint32_t totalSize;
+
     /// Compute the transaction hash
     TxHash ComputeHash() const;
 
+    /// Decoded input and output scripts (computed on first use)
+    TransactionScriptCache scripts;
+
 public:
     /// Construct from a MutableTransaction
     explicit Transaction(const MutableTransaction& tx);
@@ -317,8 +357,18 @@ public:
     /// Get the total output value
     Amount GetValueOut() const;
 
-    /// Get the total serialized size
-    size_t GetTotalSize() const;
+    /// Get the total serialized size (cached)
+    size_t GetTotalSize() const { return totalSize; }
+
+    /// Decoded scriptSig of input nIn
+    const DecodedScript& GetDecodedScriptSig(size_t nIn) const {
+        return scripts.Get(vin, vout).scriptSigs[nIn];
+    }
+
+    /// Decoded scriptPubKey of output nOut
+    const DecodedScript& GetDecodedScriptPubKey(size_t nOut) const {
+        return scripts.Get(vin, vout).scriptPubKeys[nOut];
+    }
 
     /// Check if this is a coinbase transaction
     /// A coinbase has exactly one input with a null prevout
@@ -364,6 +414,18 @@ inline TransactionRef MakeTransactionRef(Tx&& txIn) {
     return std::make_shared<const Transaction>(std::forward<Tx>(txIn));
 }
 
+/// Bytes of arena a transaction made by the overload below takes: the
+/// Transaction and its shared_ptr control block
+static constexpr size_t ARENA_BYTES_PER_TRANSACTION = sizeof(Transaction) + 64;
+
+/// Helper to create a TransactionRef in an arena. The reference behaves like
+/// any other; the arena is freed once every transaction in it is.
+template<typename Tx>
+inline TransactionRef MakeTransactionRef(Tx&& txIn, const std::shared_ptr<Arena>& arena) {
+    return std::allocate_shared<const Transaction>(ArenaAllocator<Transaction>(arena),
+                                                   std::forward<Tx>(txIn));
+}
+
 } // namespace shurium
 
 #endif // SHURIUM_CORE_TRANSACTION_H
@@ -3,7 +3,8 @@
 // MIT License
 //
 // AES-128/192/256 implementation with CBC and CTR modes.
-// Uses OpenSSL when available, with pure C++ fallback.
+// Uses AES-NI or ARMv8 AES instructions when the CPU has them, falling back
+// to OpenSSL or pure C++ otherwise.
 
 #ifndef SHURIUM_CRYPTO_AES_H
 #define SHURIUM_CRYPTO_AES_H
@@ -13,6 +14,7 @@
 #include <array>
 #include <vector>
 #include <stdexcept>
+#include <memory>
 #include "shurium/core/types.h"
 
 namespace shurium {
@@ -54,6 +56,37 @@ enum class AESMode {
     ECB     ///< Electronic Codebook (not recommended, no IV)
 };
 
+// ============================================================================
+// Block Cipher Implementations
+// ============================================================================
+
+/// Implementations of the AES block functions
+enum class AESImplementation {
+    SCALAR,     ///< Portable C++ (always available)
+    AESNI,      ///< x86 AES-NI
+    ARMV8,      ///< ARMv8 cryptography extensions
+};
+
+/// Human-readable name of an implementation
+const char* AESImplementationName(AESImplementation impl);
+
+/**
+ * Select the fastest implementation the CPU supports, checked against the
+ * FIPS-197 vectors before use; falls back to the scalar one. Runs on first
+ * use of AES, so calling it at startup only serves to report the choice.
+ * @return The implementation in use
+ */
+AESImplementation AESAutoDetect();
+
+/// The implementation currently in use
+AESImplementation GetAESImplementation();
+
+/// Implementations the CPU supports that passed the self-test
+std::vector<AESImplementation> GetAvailableAESImplementations();
+
+/// Switch implementation (tests and benchmarks); false if unavailable
+bool SetAESImplementation(AESImplementation impl);
+
 // ============================================================================
 // AES Context - Low-level encryption/decryption
 // ============================================================================
@@ -106,6 +139,29 @@ public:
     void DecryptBlock(const Byte input[aes::BLOCK_SIZE], 
                       Byte output[aes::BLOCK_SIZE]) const;
     
+    /// Encrypt consecutive blocks independently (ECB)
+    /// @param input blocks * 16 bytes of plaintext
+    /// @param output blocks * 16 bytes of ciphertext (can be same as input)
+    void EncryptBlocks(const Byte* input, Byte* output, size_t blocks) const;
+    
+    /// Decrypt consecutive blocks independently (ECB)
+    void DecryptBlocks(const Byte* input, Byte* output, size_t blocks) const;
+    
+    /// CBC-encrypt whole blocks, without padding
+    /// @param iv Chaining value; left as the last ciphertext block, so
+    ///           calls can continue one stream
+    void EncryptCBC(Byte iv[aes::BLOCK_SIZE], const Byte* input, Byte* output,
+                    size_t blocks) const;
+    
+    /// CBC-decrypt whole blocks, without unpadding (output can be same as input)
+    void DecryptCBC(Byte iv[aes::BLOCK_SIZE], const Byte* input, Byte* output,
+                    size_t blocks) const;
+    
+    /// XOR whole blocks with the CTR keystream
+    /// @param counter 128-bit big-endian counter block, advanced by blocks
+    void CTR(Byte counter[aes::BLOCK_SIZE], const Byte* input, Byte* output,
+             size_t blocks) const;
+    
     /// Get the key size being used
     AESKeySize GetKeySize() const { return keySize_; }
     
@@ -113,9 +169,10 @@ public:
     int GetRounds() const { return rounds_; }
 
 private:
-    /// Key schedule (expanded key)
-    std::vector<uint32_t> encKey_;
-    std::vector<uint32_t> decKey_;
+    /// Round keys in cipher byte order; the decryption ones in reverse
+    /// order with InvMixColumns applied (the equivalent inverse cipher)
+    std::array<Byte, 16 * 15> encRoundKeys_{};
+    std::array<Byte, 16 * 15> decRoundKeys_{};
     
     /// Key size enum
     AESKeySize keySize_;
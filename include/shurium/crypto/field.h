@@ -153,14 +153,15 @@ public:
     
     /// S-box for Poseidon: x^5
     FieldElement PoseidonSbox() const;
+    
+    /// Sum of a[i] * b[i]. Products are added at full width and reduced
+    /// once per four of them rather than once each.
+    static FieldElement SumOfProducts(const FieldElement* a, const FieldElement* b, size_t n);
 
 private:
-    /// Montgomery multiplication
+    /// Montgomery multiplication (CIOS, operands below MODULUS)
     static Uint256 MontMul(const Uint256& a, const Uint256& b);
     
-    /// Montgomery reduction
-    static Uint256 MontReduce(const Uint256& lo, const Uint256& hi);
-    
     /// Modular addition
     static Uint256 ModAdd(const Uint256& a, const Uint256& b);
     
@@ -7,6 +7,7 @@
 #include <shurium/core/types.h>
 #include <shurium/crypto/sha256.h>
 #include <shurium/crypto/ripemd160.h>
+#include <shurium/crypto/secure.h>
 
 #include <array>
 #include <cstdint>
@@ -173,6 +174,53 @@ private:
     uint8_t size_{0};
 };
 
+// ============================================================================
+// SchnorrBatchVerifier
+// ============================================================================
+
+/**
+ * Collects BIP340 signatures and verifies them together.
+ * 
+ * Verify() checks the whole batch with one multi-scalar multiplication
+ * (secp256k1::SchnorrVerifyBatch), which shares the doublings and the
+ * generator work across signatures. If the batch fails it can fall back
+ * to PublicKey::VerifySchnorr on each entry to report which ones are bad.
+ */
+class SchnorrBatchVerifier {
+public:
+    /**
+     * Queue a signature. Invalid keys are queued too and fail the batch,
+     * so indices always match the order of Add() calls.
+     * @return false if pubkey is not a valid public key
+     */
+    bool Add(const PublicKey& pubkey, const Hash256& hash,
+             const std::array<uint8_t, 64>& signature);
+    
+    /// Number of queued signatures
+    size_t Size() const { return entries_.size(); }
+    
+    bool Empty() const { return entries_.empty(); }
+    
+    void Clear() { entries_.clear(); }
+    
+    /**
+     * Verify every queued signature.
+     * @param invalid If given and the batch fails, receives the indices of
+     *                the failing signatures, found by checking each one
+     * @return true if all signatures are valid
+     */
+    bool Verify(std::vector<size_t>* invalid = nullptr) const;
+
+private:
+    struct Entry {
+        Hash256 hash;
+        std::array<uint8_t, 64> signature;
+        std::array<uint8_t, 32> xonly;
+        bool validKey;
+    };
+    std::vector<Entry> entries_;
+};
+
 // ============================================================================
 // PrivateKey
 // ============================================================================
@@ -189,7 +237,7 @@ public:
     static constexpr size_t SIZE = secp256k1::PRIVATE_KEY_SIZE;
     
     /// Default constructor - invalid key
-    PrivateKey() : valid_(false), compressed_(true) { data_.fill(0); }
+    PrivateKey() : valid_(false), compressed_(true) {}
     
     /// Construct from raw 32 bytes
     explicit PrivateKey(const uint8_t* data, bool compressed = true);
@@ -282,7 +330,8 @@ public:
     void Clear();
     
 private:
-    std::array<uint8_t, SIZE> data_;
+    /// Key bytes, in a locked SecurePool slot
+    SecureBytes<SIZE> data_;
     bool valid_{false};
     bool compressed_{true};
     
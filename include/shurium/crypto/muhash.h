@@ -0,0 +1,152 @@
+// SHURIUM - MuHash Rolling Set Hash
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// MuHash3072: a hash of a set that can be updated one element at a time.
+// Each element is mapped to a number modulo the prime 2^3072 - 1103717 and
+// the set hash is the product of those numbers, so adding and removing
+// elements are a multiplication and a division, in any order. Used for the
+// UTXO set commitment, which would otherwise need a pass over every coin.
+
+#ifndef SHURIUM_CRYPTO_MUHASH_H
+#define SHURIUM_CRYPTO_MUHASH_H
+
+#include "shurium/core/types.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace shurium {
+
+// ============================================================================
+// Num3072
+// ============================================================================
+
+/**
+ * Number modulo the prime 2^3072 - 1103717.
+ * Stored as 48 little-endian 64-bit limbs, always fully reduced.
+ */
+class Num3072 {
+public:
+    /// Serialized size in bytes
+    static constexpr size_t BYTE_SIZE = 384;
+
+    /// Number of 64-bit limbs
+    static constexpr size_t LIMBS = 48;
+
+    /// The prime is 2^3072 - MAX_PRIME_DIFF
+    static constexpr uint64_t MAX_PRIME_DIFF = 1103717;
+
+    /// Construct the number one
+    Num3072() { SetToOne(); }
+
+    /// Construct from little-endian bytes (reduced modulo the prime)
+    explicit Num3072(const Byte (&data)[BYTE_SIZE]);
+
+    void SetToOne();
+
+    /// this = this * a (mod p)
+    void Multiply(const Num3072& a);
+
+    /// this = this / a (mod p)
+    void Divide(const Num3072& a);
+
+    /// Multiplicative inverse (mod p); the inverse of zero is zero
+    Num3072 GetInverse() const;
+
+    /// Write as little-endian bytes
+    void ToBytes(Byte (&out)[BYTE_SIZE]) const;
+
+    bool operator==(const Num3072& other) const;
+    bool operator!=(const Num3072& other) const { return !(*this == other); }
+
+private:
+    uint64_t limbs[LIMBS];
+
+    /// Whether the value is at least the prime
+    bool IsOverflow() const;
+
+    /// Subtract the prime once
+    void FullReduce();
+};
+
+// ============================================================================
+// MuHash3072
+// ============================================================================
+
+/**
+ * Rolling hash of a multiset of byte strings.
+ *
+ * Elements are expanded to a Num3072 with SHA256 (the digest of the element,
+ * then twelve counter-mode blocks of it). Insertions multiply the numerator
+ * and removals the denominator, so no inversion happens until Finalize().
+ * Two accumulators can be combined with *= and /=, which is how a cache's
+ * changes are applied to the stored set hash.
+ *
+ * Note the expansion differs from Bitcoin Core's (which uses ChaCha20), so
+ * the digests are not interchangeable.
+ */
+class MuHash3072 {
+public:
+    /// Serialized size (numerator and denominator)
+    static constexpr size_t SERIALIZED_SIZE = 2 * Num3072::BYTE_SIZE;
+
+    /// Hash of the empty set
+    MuHash3072() = default;
+
+    /// Add an element
+    MuHash3072& Insert(const Byte* data, size_t len);
+
+    /// Remove an element (it need not have been inserted into this object)
+    MuHash3072& Remove(const Byte* data, size_t len);
+
+    /// Union with another set
+    MuHash3072& operator*=(const MuHash3072& other);
+
+    /// Remove another set's elements
+    MuHash3072& operator/=(const MuHash3072& other);
+
+    /// 32-byte digest of the set (one modular inversion)
+    Hash256 Finalize() const;
+
+    /// Whether no element has been inserted or removed since construction
+    bool IsEmpty() const;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        Byte bytes[Num3072::BYTE_SIZE];
+        m_numerator.ToBytes(bytes);
+        s.Write(bytes, sizeof(bytes));
+        m_denominator.ToBytes(bytes);
+        s.Write(bytes, sizeof(bytes));
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        Byte bytes[Num3072::BYTE_SIZE];
+        s.Read(bytes, sizeof(bytes));
+        m_numerator = Num3072(bytes);
+        s.Read(bytes, sizeof(bytes));
+        m_denominator = Num3072(bytes);
+    }
+
+private:
+    Num3072 m_numerator;
+    Num3072 m_denominator;
+
+    /// Map an element to a number
+    static Num3072 ToNum3072(const Byte* data, size_t len);
+};
+
+template<typename Stream>
+void Serialize(Stream& s, const MuHash3072& muhash) {
+    muhash.Serialize(s);
+}
+
+template<typename Stream>
+void Unserialize(Stream& s, MuHash3072& muhash) {
+    muhash.Unserialize(s);
+}
+
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_MUHASH_H
@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <vector>
 #include <array>
+#include <utility>
 #include "shurium/crypto/field.h"
 #include "shurium/core/types.h"
 
@@ -21,6 +22,9 @@ namespace shurium {
 // Poseidon Configuration
 // ============================================================================
 
+/// Round constants and linear layers derived from a configuration
+struct PoseidonConstants;
+
 /// Poseidon hash configuration parameters
 struct PoseidonConfig {
     /// State width (t)
@@ -40,6 +44,11 @@ struct PoseidonConfig {
     
     /// Total rounds
     size_t totalRounds() const { return fullRounds + partialRounds; }
+    
+    /// Precomputed constants for this configuration. They are derived on
+    /// first use and shared by every hasher with the same width and rounds
+    /// for the life of the process.
+    const PoseidonConstants& Constants() const;
 };
 
 // ============================================================================
@@ -101,6 +110,11 @@ public:
     /// Hash two field elements (2-to-1 compression, commonly used in Merkle trees)
     static FieldElement Hash2(const FieldElement& left, const FieldElement& right);
     
+    /// Hash2 of each (left, right) pair, in order. Several permutations run
+    /// interleaved, which is faster than calling Hash2 in a loop.
+    static std::vector<FieldElement> HashMany(
+        Span<const std::pair<FieldElement, FieldElement>> pairs);
+    
     /// Hash raw bytes to a field element
     static FieldElement HashBytes(const Byte* data, size_t len);
     
@@ -120,29 +134,29 @@ private:
     /// Whether squeeze mode has started
     bool squeezing_;
     
-    /// Round constants (one per state element per round)
-    std::vector<std::vector<FieldElement>> roundConstants_;
+    /// Shared constants for config_
+    const PoseidonConstants* constants_;
     
-    /// MDS matrix (width x width)
-    std::vector<std::vector<FieldElement>> mdsMatrix_;
-    
-    /// Initialize constants for the given configuration
-    void InitConstants();
+    /// Scratch row for the matrix multiplications
+    std::vector<FieldElement> scratch_;
     
     /// Apply the Poseidon permutation to the state
     void Permute();
     
-    /// Apply full round (S-box on all elements)
-    void FullRound(size_t roundIdx);
+    /// Apply full round (S-box on all elements), mixing with the given matrix
+    void FullRound(const FieldElement* roundConstants, const FieldElement* matrix);
     
-    /// Apply partial round (S-box on first element only)
+    /// Apply partial round (S-box on first element only) with the dense MDS matrix
     void PartialRound(size_t roundIdx);
     
-    /// Add round constants to state
-    void AddRoundConstants(size_t roundIdx);
+    /// Apply partial round number partialIdx with its sparse matrix
+    void SparsePartialRound(size_t partialIdx);
+    
+    /// Add one round's constants to state
+    void AddRoundConstants(const FieldElement* roundConstants);
     
-    /// Apply MDS matrix multiplication
-    void MixColumns();
+    /// Multiply the state by a width x width row-major matrix
+    void MixColumns(const FieldElement* matrix);
     
     /// Apply S-box (x^5) to a single element
     static FieldElement Sbox(const FieldElement& x);
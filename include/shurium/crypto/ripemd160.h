@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 #include "shurium/core/types.h"
 
 namespace shurium {
@@ -81,6 +82,28 @@ inline Hash160 Hash160FromData(const std::vector<Byte>& data) {
     return Hash160FromData(data.data(), data.size());
 }
 
+// ============================================================================
+// Multi-Key Hash160
+// ============================================================================
+
+/**
+ * Hash160 of `count` consecutive 33-byte compressed public keys into
+ * consecutive 20-byte digests: out[20*i] = Hash160FromData(in[33*i], 33).
+ * Both hashes of a compressed key are single fixed-padding blocks, so
+ * independent keys are hashed several at once with SSE4.1 (4), AVX2 (8)
+ * or AVX-512 (16) when the CPU has them. out must not overlap in.
+ */
+void Hash160_33(Byte* out, const Byte* in, size_t count);
+
+/// Widest kernel Hash160_33 uses (1, 4, 8 or 16 keys)
+size_t GetHash160Ways();
+
+/// Kernel widths the CPU supports that passed the self-test, widest first
+std::vector<size_t> GetAvailableHash160Ways();
+
+/// Cap the kernel width (tests and benchmarks); false if unavailable
+bool SetHash160Ways(size_t ways);
+
 } // namespace shurium
 
 #endif // SHURIUM_CRYPTO_RIPEMD160_H
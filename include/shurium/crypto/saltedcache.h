@@ -0,0 +1,197 @@
+// SHURIUM - Salted Verification Cache
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// The fixed-size, set-associative table behind the signature, script
+// execution and proof caches. Each of those only decides what goes into an
+// entry; storing, finding and counting entries is shared here.
+
+#ifndef SHURIUM_CRYPTO_SALTEDCACHE_H
+#define SHURIUM_CRYPTO_SALTEDCACHE_H
+
+#include "shurium/core/random.h"
+#include "shurium/core/types.h"
+#include "shurium/crypto/sha256.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// SaltedCache
+// ============================================================================
+
+/**
+ * Set-associative cache of salted Hash256 entries.
+ *
+ * A cache derives from this and computes its entries by copying
+ * SaltedHasher(), which is primed with a random per-process salt, so peers
+ * cannot construct colliding entries. The table has a fixed number of sets
+ * chosen at construction; each set holds a few ways and inserts overwrite
+ * the oldest way. Sets are guarded by LockStripes striped reader/writer
+ * locks, so concurrent lookups rarely contend.
+ */
+template <size_t LockStripes>
+class SaltedCache {
+public:
+    /// Number of entries per set
+    static constexpr size_t WAYS = 4;
+
+    /// Number of lock stripes
+    static constexpr size_t LOCK_STRIPES = LockStripes;
+
+    /// Cache statistics
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t inserts{0};
+        size_t entries{0};     // Occupied slots
+        size_t capacity{0};    // Total slots
+        size_t memoryUsage{0}; // Bytes allocated for the table
+
+        double HitRate() const {
+            uint64_t lookups = hits + misses;
+            return lookups ? static_cast<double>(hits) / lookups : 0.0;
+        }
+    };
+
+    /**
+     * Create a cache using at most maxBytes for the table.
+     * The slot count is rounded down to a power of two.
+     */
+    explicit SaltedCache(size_t maxBytes) {
+        // Round the set count down to a power of two so lookups can mask
+        size_t maxSets = std::max<size_t>(maxBytes / sizeof(Set), 1);
+        size_t nSets = 1;
+        while (nSets * 2 <= maxSets) {
+            nSets *= 2;
+        }
+        m_sets.resize(nSets);
+        m_setMask = nSets - 1;
+
+        uint8_t salt[SHA256::BLOCK_SIZE];
+        GetRandBytes(salt, sizeof(salt));
+        m_saltedHasher.Write(salt, sizeof(salt));
+    }
+
+    SaltedCache(const SaltedCache&) = delete;
+    SaltedCache& operator=(const SaltedCache&) = delete;
+
+    /// Check whether an entry is present (counts a hit or miss)
+    bool Contains(const Hash256& entry) const {
+        size_t index = SetIndex(entry);
+        bool found;
+        {
+            std::shared_lock<std::shared_mutex> lock(m_locks[index % LOCK_STRIPES]);
+            const auto& ways = m_sets[index].ways;
+            found = std::find(ways.begin(), ways.end(), entry) != ways.end();
+        }
+
+        (found ? m_hits : m_misses).fetch_add(1, std::memory_order_relaxed);
+        return found;
+    }
+
+    /// Record an entry as verified
+    void Insert(const Hash256& entry) {
+        size_t index = SetIndex(entry);
+        std::unique_lock<std::shared_mutex> lock(m_locks[index % LOCK_STRIPES]);
+
+        Set& set = m_sets[index];
+        if (std::find(set.ways.begin(), set.ways.end(), entry) != set.ways.end()) {
+            return;
+        }
+
+        if (set.ways[set.next].IsNull()) {
+            m_entries.fetch_add(1, std::memory_order_relaxed);
+        }
+        set.ways[set.next] = entry;
+        set.next = static_cast<uint8_t>((set.next + 1) % WAYS);
+        m_inserts.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Remove all entries and reset statistics
+    void Clear() {
+        ClearEntries();
+        m_hits.store(0);
+        m_misses.store(0);
+        m_inserts.store(0);
+    }
+
+    /// Get hit/miss counters and occupancy
+    Stats GetStats() const {
+        Stats stats;
+        stats.hits = m_hits.load(std::memory_order_relaxed);
+        stats.misses = m_misses.load(std::memory_order_relaxed);
+        stats.inserts = m_inserts.load(std::memory_order_relaxed);
+        stats.entries = m_entries.load(std::memory_order_relaxed);
+        stats.capacity = m_sets.size() * WAYS;
+        stats.memoryUsage = m_sets.size() * sizeof(Set);
+        return stats;
+    }
+
+protected:
+    ~SaltedCache() = default;
+
+    /// Hasher primed with the salt (one full SHA256 block)
+    const SHA256& SaltedHasher() const { return m_saltedHasher; }
+
+    /// Hash a field after its 8-byte little-endian length, so bytes cannot
+    /// move between variable-length fields without changing the entry
+    static void WriteWithLength(SHA256& hasher, Span<const uint8_t> data) {
+        uint8_t len[8];
+        uint64_t size = data.size();
+        for (int i = 0; i < 8; ++i) {
+            len[i] = static_cast<uint8_t>((size >> (i * 8)) & 0xFF);
+        }
+        hasher.Write(len, sizeof(len));
+        hasher.Write(data.data(), data.size());
+    }
+
+    /// Drop all entries, keeping the statistics
+    void ClearEntries() {
+        for (size_t stripe = 0; stripe < LOCK_STRIPES; ++stripe) {
+            std::unique_lock<std::shared_mutex> lock(m_locks[stripe]);
+            for (size_t i = stripe; i < m_sets.size(); i += LOCK_STRIPES) {
+                m_sets[i] = Set{};
+            }
+        }
+        m_entries.store(0);
+    }
+
+private:
+    struct Set {
+        std::array<Hash256, WAYS> ways;
+        uint8_t next{0};  // Way to overwrite on the next insert
+    };
+
+    std::vector<Set> m_sets;
+    size_t m_setMask{0};
+
+    SHA256 m_saltedHasher;
+
+    mutable std::array<std::shared_mutex, LOCK_STRIPES> m_locks;
+
+    mutable std::atomic<uint64_t> m_hits{0};
+    mutable std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_inserts{0};
+    std::atomic<size_t> m_entries{0};
+
+    size_t SetIndex(const Hash256& entry) const {
+        // The entry is already a salted hash, so any 8 bytes are uniform
+        uint64_t bits;
+        std::memcpy(&bits, entry.data(), sizeof(bits));
+        return static_cast<size_t>(bits) & m_setMask;
+    }
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SALTEDCACHE_H
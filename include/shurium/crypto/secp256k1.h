@@ -13,6 +13,7 @@
 #include <array>
 #include <vector>
 #include <optional>
+#include <memory>
 #include "shurium/core/types.h"
 
 namespace shurium {
@@ -116,7 +117,8 @@ private:
 
 /**
  * A field element (mod field prime p).
- * Used for point coordinates.
+ * Used for point coordinates. Arithmetic runs in constant time on the
+ * native 5x52-limb field code, independent of the OpenSSL backend.
  */
 class FieldElement {
 public:
@@ -151,7 +153,7 @@ public:
     /// Square root (mod p) - returns nullopt if not a quadratic residue
     std::optional<FieldElement> Sqrt() const;
     
-    /// Modular inverse
+    /// Modular inverse (constant-time safegcd); zero maps to zero
     FieldElement Inverse() const;
     
     /// Square
@@ -279,12 +281,23 @@ private:
 /**
  * Scalar multiplication: scalar * G (generator).
  * This is the key operation for deriving public keys.
+ * Runs in constant time from a table of multiples of G built on first use.
  * 
  * @param scalar 32-byte scalar (private key)
  * @return Public point, or nullopt if scalar is invalid
  */
 std::optional<Point> ScalarBaseMultiply(const Scalar& scalar);
 
+/**
+ * Serialized public key for a private key, without building a Point.
+ * 
+ * @param privateKey 32-byte private key
+ * @param pubkey Output: 33 bytes if compressed, else 65 bytes
+ * @param compressed Serialization form
+ * @return false if the private key is invalid
+ */
+bool ComputePublicKey(const uint8_t* privateKey, uint8_t* pubkey, bool compressed);
+
 /**
  * Scalar multiplication: scalar * point.
  * 
@@ -296,8 +309,9 @@ Point ScalarMultiply(const Scalar& scalar, const Point& point);
 
 /**
  * Double scalar multiplication: a*G + b*P.
- * More efficient than separate multiplications.
- * Used for signature verification.
+ * Used for signature verification: the GLV endomorphism halves both
+ * scalars, which then share one wNAF doubling chain. Variable time, so
+ * only for public scalars.
  * 
  * @param a First scalar
  * @param b Second scalar
@@ -351,6 +365,26 @@ bool PrivateKeyTweakAdd(const uint8_t* key, const uint8_t* tweak, uint8_t* resul
 bool PublicKeyTweakAdd(const uint8_t* pubkey, size_t pubkeyLen,
                        const uint8_t* tweak, uint8_t* result);
 
+/**
+ * Tweak one public key by many tweaks: results[k] = P + tweaks[k]*G.
+ * 
+ * Gives the same keys as calling PublicKeyTweakAdd per tweak, but all the
+ * sums share a single field inversion. For deriving runs of child keys
+ * from one parent.
+ * 
+ * @param pubkey Public key (33 or 65 bytes)
+ * @param pubkeyLen Length of public key
+ * @param tweaks count consecutive 32-byte tweaks
+ * @param count Number of tweaks
+ * @param results Output: count keys, each the size of the input
+ * @param valid Output: valid[k] is false if tweaks[k] is zero or not below
+ *              the curve order, or the sum is the point at infinity
+ * @return false if pubkey is not a valid point
+ */
+bool PublicKeyTweakAddBatch(const uint8_t* pubkey, size_t pubkeyLen,
+                            const uint8_t* tweaks, size_t count,
+                            uint8_t* results, bool* valid);
+
 /**
  * Negate a private key.
  * result = -key mod n
@@ -393,6 +427,9 @@ bool ECDSASign(const uint8_t* hash, const uint8_t* privateKey,
 /**
  * Verify an ECDSA signature.
  * 
+ * Accepts exactly the strict DER encodings OpenSSL's ECDSA_verify does,
+ * including high-S signatures, but runs the native GLV/wNAF code.
+ * 
  * @param hash 32-byte message hash
  * @param signature DER-encoded signature
  * @param sigLen Signature length
@@ -404,6 +441,27 @@ bool ECDSAVerify(const uint8_t* hash,
                  const uint8_t* signature, size_t sigLen,
                  const uint8_t* publicKey, size_t pubkeyLen);
 
+/**
+ * A public key already parsed (and, if compressed, decompressed): the
+ * affine coordinates as 32-byte big-endian values. Decompression costs a
+ * field square root, so callers that see the same key many times can parse
+ * it once and verify against this.
+ */
+struct ParsedPublicKey {
+    std::array<uint8_t, 64> xy{};  ///< x || y
+};
+
+/**
+ * Parse a 33- or 65-byte SEC1 public key, as ECDSAVerify does.
+ * @return false unless the encoding is well formed and the point is on the curve
+ */
+bool ParsePublicKey(ParsedPublicKey& out, const uint8_t* publicKey, size_t pubkeyLen);
+
+/// Verify an ECDSA signature against a key from ParsePublicKey
+bool ECDSAVerify(const uint8_t* hash,
+                 const uint8_t* signature, size_t sigLen,
+                 const ParsedPublicKey& publicKey);
+
 /**
  * Sign with compact/recoverable signature format.
  * 
@@ -452,6 +510,28 @@ bool SchnorrSign(const uint8_t* hash, const uint8_t* privateKey,
 bool SchnorrVerify(const uint8_t* hash, const uint8_t signature[64],
                    const uint8_t publicKey[32]);
 
+/// Signatures checked per multi-scalar multiplication by SchnorrVerifyBatch
+constexpr size_t SCHNORR_BATCH_CHUNK = 128;
+
+/**
+ * Verify BIP340 Schnorr signatures together.
+ * 
+ * Checks (sum a_i*s_i)*G = sum a_i*R_i + sum (a_i*e_i)*P_i with a single
+ * multi-scalar multiplication per SCHNORR_BATCH_CHUNK signatures. The
+ * 128-bit weights a_i are derived from a hash of the whole chunk, so they
+ * are fixed only after every signature is, and a batch containing an
+ * invalid signature passes with probability below 2^-128. A failed batch
+ * does not say which signature is bad; check them with SchnorrVerify.
+ * 
+ * @param hashes count 32-byte message hashes
+ * @param signatures count 64-byte signatures
+ * @param publicKeys count 32-byte x-only public keys
+ * @param count Number of signatures
+ * @return true if every signature is valid (and for an empty batch)
+ */
+bool SchnorrVerifyBatch(const uint8_t* const* hashes, const uint8_t* const* signatures,
+                        const uint8_t* const* publicKeys, size_t count);
+
 } // namespace secp256k1
 } // namespace shurium
 
@@ -0,0 +1,159 @@
+// SHURIUM - Secure Memory Pool
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Fixed-size slots for key material. The slots are cut from a few large
+// arenas. Each arena is page-locked once when it is mapped, is fenced by
+// inaccessible guard pages and is left out of core dumps. Keys therefore
+// cost no mlock call each and do not hit RLIMIT_MEMLOCK page by page. A
+// slot is zeroed as it is freed.
+
+#ifndef SHURIUM_CRYPTO_SECURE_H
+#define SHURIUM_CRYPTO_SECURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Secure Pool
+// ============================================================================
+
+/**
+ * Process-wide allocator of SLOT_SIZE-byte slots in locked memory.
+ *
+ * Arenas are added as the slots run out and are kept for the life of the
+ * process. If an arena cannot be locked, for example because of
+ * RLIMIT_MEMLOCK, it is still used; Stats counts such arenas.
+ */
+class SecurePool {
+public:
+    /// Bytes per slot
+    static constexpr size_t SLOT_SIZE = 64;
+
+    /// Slots per arena (256 KiB)
+    static constexpr size_t ARENA_SLOTS = 4096;
+
+    struct Stats {
+        size_t arenas{0};
+        size_t unlockedArenas{0};  ///< Arenas the OS refused to lock
+        size_t slotsTotal{0};
+        size_t slotsInUse{0};
+    };
+
+    /// The process-wide pool
+    static SecurePool& Get();
+
+    /// SLOT_SIZE zero bytes, for reading a slot that was never allocated
+    static const uint8_t* ZeroSlot();
+
+    /// A zeroed slot; throws std::bad_alloc if no arena can be mapped
+    void* Allocate();
+
+    /// Zero a slot and return it to the pool
+    void Free(void* slot);
+
+    Stats GetStats() const;
+
+    SecurePool(const SecurePool&) = delete;
+    SecurePool& operator=(const SecurePool&) = delete;
+
+private:
+    SecurePool() = default;
+
+    struct Arena;
+
+    /// Map, fence and lock one more arena (mutex_ held)
+    void AddArenaLocked();
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Arena>> arenas_;
+    std::vector<void*> freeSlots_;
+    size_t unlockedArenas_{0};
+};
+
+// ============================================================================
+// Secure Bytes
+// ============================================================================
+
+/**
+ * N bytes of key material held in a SecurePool slot.
+ *
+ * The slot is taken when the bytes are first written. Until then they
+ * read as zero, so default-constructed keys cost nothing. Moves hand the
+ * slot over. Copies take a slot of their own.
+ */
+template<size_t N>
+class SecureBytes {
+    static_assert(N <= SecurePool::SLOT_SIZE, "SecureBytes larger than a pool slot");
+
+public:
+    SecureBytes() = default;
+    ~SecureBytes() { Release(); }
+
+    SecureBytes(const SecureBytes& other) {
+        if (other.slot_) {
+            std::memcpy(Writable(), other.slot_, N);
+        }
+    }
+
+    SecureBytes& operator=(const SecureBytes& other) {
+        if (this != &other) {
+            if (other.slot_) {
+                std::memcpy(Writable(), other.slot_, N);
+            } else {
+                Release();
+            }
+        }
+        return *this;
+    }
+
+    SecureBytes(SecureBytes&& other) noexcept : slot_(other.slot_) {
+        other.slot_ = nullptr;
+    }
+
+    SecureBytes& operator=(SecureBytes&& other) noexcept {
+        if (this != &other) {
+            Release();
+            slot_ = other.slot_;
+            other.slot_ = nullptr;
+        }
+        return *this;
+    }
+
+    /// The bytes, for reading
+    const uint8_t* data() const { return slot_ ? slot_ : SecurePool::ZeroSlot(); }
+
+    /// The bytes, for writing; takes a slot on first use
+    uint8_t* Writable() {
+        if (!slot_) {
+            slot_ = static_cast<uint8_t*>(SecurePool::Get().Allocate());
+        }
+        return slot_;
+    }
+
+    /// Zero the bytes and give the slot back
+    void Release() {
+        if (slot_) {
+            SecurePool::Get().Free(slot_);
+            slot_ = nullptr;
+        }
+    }
+
+    static constexpr size_t size() { return N; }
+    uint8_t operator[](size_t i) const { return data()[i]; }
+    const uint8_t* begin() const { return data(); }
+    const uint8_t* end() const { return data() + N; }
+
+private:
+    uint8_t* slot_{nullptr};
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SECURE_H
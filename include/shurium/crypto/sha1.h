@@ -0,0 +1,60 @@
+// SHURIUM - SHA-1 Hash Function
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// SHA-1 implementation. SHA-1 is broken for collision resistance and must
+// not be used for anything that needs it; it exists only because protocols
+// such as the WebSocket handshake (RFC 6455) require it.
+
+#ifndef SHURIUM_CRYPTO_SHA1_H
+#define SHURIUM_CRYPTO_SHA1_H
+
+#include <cstdint>
+#include <cstddef>
+#include "shurium/core/types.h"
+
+namespace shurium {
+
+/// SHA-1 hasher class with the same incremental interface as SHA256
+class SHA1 {
+public:
+    /// Output size in bytes
+    static constexpr size_t OUTPUT_SIZE = 20;
+    
+    /// Block size in bytes
+    static constexpr size_t BLOCK_SIZE = 64;
+    
+    /// Default constructor - initializes to empty state
+    SHA1();
+    
+    /// Write data to the hasher
+    /// @param data Pointer to input data
+    /// @param len Length of input data
+    /// @return Reference to this hasher (for chaining)
+    SHA1& Write(const Byte* data, size_t len);
+    
+    /// Finalize the hash and write to output
+    /// @param hash Pointer to output buffer (must be at least OUTPUT_SIZE bytes)
+    void Finalize(Byte hash[OUTPUT_SIZE]);
+    
+    /// Reset hasher to initial state
+    /// @return Reference to this hasher (for chaining)
+    SHA1& Reset();
+
+private:
+    /// Internal state (5 x 32-bit words)
+    uint32_t state_[5];
+    
+    /// Buffer for partial block
+    Byte buffer_[BLOCK_SIZE];
+    
+    /// Total bytes processed
+    uint64_t bytes_;
+    
+    /// Transform a single 64-byte block
+    void Transform(const Byte block[BLOCK_SIZE]);
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SHA1_H
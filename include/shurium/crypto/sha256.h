@@ -9,6 +9,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <vector>
 #include "shurium/core/types.h"
 
 namespace shurium {
@@ -50,10 +51,93 @@ private:
     /// Total bytes processed
     uint64_t bytes_;
     
-    /// Transform a single 64-byte block
-    void Transform(const Byte block[BLOCK_SIZE]);
+    /// Transform nBlocks consecutive 64-byte blocks
+    void Transform(const Byte* blocks, size_t nBlocks);
 };
 
+// ============================================================================
+// Transform Implementations
+// ============================================================================
+
+/// Implementations of the SHA-256 compression function
+enum class SHA256Implementation {
+    SCALAR,     ///< Portable C++ (always available)
+    SHANI,      ///< x86 SHA extensions
+    ARMV8,      ///< ARMv8 cryptography extensions
+};
+
+/// Human-readable name of an implementation
+const char* SHA256ImplementationName(SHA256Implementation impl);
+
+/**
+ * Select the fastest transform the CPU supports, checked against a known
+ * vector before use; falls back to the scalar one. Runs on first use of
+ * SHA256, so calling it at startup only serves to report the choice.
+ * @return The implementation in use
+ */
+SHA256Implementation SHA256AutoDetect();
+
+/// The implementation currently in use
+SHA256Implementation GetSHA256Implementation();
+
+/// Implementations the CPU supports that passed the self-test
+std::vector<SHA256Implementation> GetAvailableSHA256Implementations();
+
+/// Switch implementation (tests and benchmarks); false if unavailable
+bool SetSHA256Implementation(SHA256Implementation impl);
+
+// ============================================================================
+// Multi-Message Double SHA256
+// ============================================================================
+
+/**
+ * Double SHA256 of `blocks` consecutive 64-byte messages into consecutive
+ * 32-byte digests: out[32*i] = DoubleSHA256(in[64*i], 64). Independent
+ * messages are hashed several at once with SSE4.1 (4), AVX2 (8) or
+ * AVX-512 (16) when the CPU has them. out may equal in, as when hashing
+ * one Merkle tree level into the next.
+ */
+void DoubleSHA256_64(Byte* out, const Byte* in, size_t blocks);
+
+/// Widest kernel DoubleSHA256_64 uses (1, 4, 8 or 16 messages)
+size_t GetSHA256D64Ways();
+
+/// Kernel widths the CPU supports that passed the self-test, widest first
+std::vector<size_t> GetAvailableSHA256D64Ways();
+
+/// Cap the kernel width (tests and benchmarks); false if unavailable
+bool SetSHA256D64Ways(size_t ways);
+
+// ============================================================================
+// Block Header Nonce Search
+// ============================================================================
+
+/// SHA-256 state after the first 64 bytes of an 80-byte block header
+struct SHA256Midstate {
+    uint32_t state[8];
+};
+
+/// Compress the first 64 bytes of a serialized header into its midstate
+SHA256Midstate SHA256HeaderMidstate(const Byte* header);
+
+/**
+ * Double SHA256 of `count` 80-byte headers that differ only in the nonce,
+ * into consecutive 32-byte digests: digest i is that of the header with
+ * nonce firstNonce + i (wrapping). mid is the midstate of the first 64
+ * bytes and tail the 12 bytes that follow (end of the Merkle root, time,
+ * bits), so each header costs one compression of its last block plus the
+ * second hash, run several nonces at a time like DoubleSHA256_64.
+ */
+void DoubleSHA256_80_Nonces(Byte* out, const SHA256Midstate& mid, const Byte* tail,
+                            uint32_t firstNonce, size_t count);
+
+/**
+ * Double SHA256 of `count` consecutive 80-byte headers into consecutive
+ * 32-byte digests, several at once on the same kernels. For the headers
+ * of a headers message, which share nothing.
+ */
+void DoubleSHA256_80(Byte* out, const Byte* in, size_t count);
+
 // ============================================================================
 // Convenience Functions
 // ============================================================================
@@ -81,6 +165,25 @@ inline Hash256 DoubleSHA256(const std::vector<Byte>& data) {
     return DoubleSHA256(data.data(), data.size());
 }
 
+/// Serialization sink feeding a SHA256 hasher directly, so an object is
+/// hashed without first being serialized into a buffer
+struct HashWriter {
+    SHA256 hasher;
+    
+    void Write(const uint8_t* data, size_t len) { hasher.Write(data, len); }
+    void Write(const char* data, size_t len) {
+        hasher.Write(reinterpret_cast<const Byte*>(data), len);
+    }
+    
+    /// Double SHA256 of everything written
+    Hash256 GetHash() {
+        Hash256 result;
+        hasher.Finalize(result.data());
+        SHA256().Write(result.data(), result.size()).Finalize(result.data());
+        return result;
+    }
+};
+
 } // namespace shurium
 
 #endif // SHURIUM_CRYPTO_SHA256_H
@@ -0,0 +1,67 @@
+// SHURIUM - SipHash Keyed Hash Function
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// SipHash implementation for hash tables keyed on attacker-controlled data.
+// In-memory maps keyed on txids, outpoints and block hashes use a per-process
+// random key so peers cannot craft entries that collide in the same bucket.
+
+#ifndef SHURIUM_CRYPTO_SIPHASH_H
+#define SHURIUM_CRYPTO_SIPHASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include "shurium/core/types.h"
+
+namespace shurium {
+
+// ============================================================================
+// SipHash Functions
+// ============================================================================
+
+/// SipHash-2-4 of an arbitrary message (the reference variant)
+uint64_t SipHash24(uint64_t k0, uint64_t k1, const Byte* data, size_t len);
+
+/// SipHash-1-3 of an arbitrary message (the faster hash table variant)
+uint64_t SipHash13(uint64_t k0, uint64_t k1, const Byte* data, size_t len);
+
+/// SipHash-1-3 specialised for a 32-byte hash
+uint64_t SipHash13Uint256(uint64_t k0, uint64_t k1, const Hash256& hash);
+
+/// SipHash-1-3 specialised for a 32-byte hash followed by a 4-byte
+/// little-endian value (the 36-byte serialisation of an outpoint)
+uint64_t SipHash13Uint256Extra(uint64_t k0, uint64_t k1,
+                               const Hash256& hash, uint32_t extra);
+
+// ============================================================================
+// Hash Table Salt
+// ============================================================================
+
+/// SipHash key
+struct SipHashKey {
+    uint64_t k0{0};
+    uint64_t k1{0};
+};
+
+/// Random key generated once per process for in-memory hash tables
+const SipHashKey& GetHashTableSalt();
+
+/**
+ * Salted hasher for maps keyed on any 256-bit hash (block hashes, txids).
+ * The key is copied at construction so lookups never touch shared state.
+ */
+class SaltedHash256Hasher {
+public:
+    SaltedHash256Hasher() : m_key(GetHashTableSalt()) {}
+
+    size_t operator()(const Hash256& hash) const {
+        return static_cast<size_t>(SipHash13Uint256(m_key.k0, m_key.k1, hash));
+    }
+
+private:
+    SipHashKey m_key;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SIPHASH_H
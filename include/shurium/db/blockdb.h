@@ -12,15 +12,59 @@
 #include "shurium/core/block.h"
 #include "shurium/chain/blockindex.h"
 #include "shurium/chain/chainstate.h"  // For BlockUndo
+#include "shurium/util/fs.h"
+#include "shurium/util/iouring.h"
+#include <atomic>
 #include <memory>
 #include <optional>
+#include <set>
 #include <filesystem>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
 
 namespace shurium {
 namespace db {
 
+// ============================================================================
+// Block Record Format
+// ============================================================================
+
+/// Magic that starts every block record in a blk?????.dat file
+static constexpr uint32_t BLOCK_RECORD_MAGIC = 0xD9B4BEF9;
+
+/// Bytes before a record's payload: magic (4) and payload size (4)
+static constexpr uint32_t BLOCK_RECORD_HEADER_SIZE = 8;
+
+/// Largest block record accepted when reading
+static constexpr uint32_t MAX_BLOCK_RECORD_SIZE = 32 * 1024 * 1024;
+
+/// First byte of a versioned undo record. A legacy record starts with the
+/// CompactSize transaction count, which can never begin with 0xFF.
+static constexpr uint8_t UNDO_VERSION_MARKER = 0xFF;
+
+/// Undo record version written by WriteUndo()
+static constexpr uint8_t UNDO_VERSION_COMPRESSED = 1;
+
+/// Block files grow on disk in preallocated chunks of this size
+static constexpr uint64_t BLOCKFILE_CHUNK_SIZE = 16 * 1024 * 1024;
+
+/// Undo files grow on disk in preallocated chunks of this size
+static constexpr uint64_t UNDOFILE_CHUNK_SIZE = 1024 * 1024;
+
+/// Appended bytes a block or undo file holds in memory before writing them out
+static constexpr size_t FILE_WRITE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+// ============================================================================
+// Pruning
+// ============================================================================
+
+/// Blocks below the tip that are never pruned (reorg depth, NETWORK_LIMITED)
+static constexpr int MIN_BLOCKS_TO_KEEP = 288;
+
+/// Smallest -prune target accepted, in MiB
+static constexpr uint64_t MIN_PRUNE_TARGET_MB = 550;
+
 // ============================================================================
 // Block File Info - Metadata about block storage files
 // ============================================================================
@@ -194,6 +238,31 @@ void Unserialize(Stream& s, BlockIndexDB& entry) {
     Unserialize(s, entry.nChainWork);
 }
 
+// ============================================================================
+// Block Index Load Statistics
+// ============================================================================
+
+/// Key-space shards per load thread, so uneven shards even out
+static constexpr int BLOCK_INDEX_LOAD_SHARDS_PER_THREAD = 4;
+
+/// Per-phase timings of a block index load
+struct BlockIndexLoadStats {
+    /// Entries read from the database
+    size_t nEntries{0};
+    
+    /// Threads used for the scan
+    int nThreads{0};
+    
+    /// Sharded scan and deserialization
+    int64_t readMicros{0};
+    
+    /// Ordering entries by height
+    int64_t sortMicros{0};
+    
+    /// Insertion, parent linking and chain work
+    int64_t linkMicros{0};
+};
+
 // ============================================================================
 // Block Database - Main block storage interface
 // ============================================================================
@@ -203,6 +272,17 @@ void Unserialize(Stream& s, BlockIndexDB& entry) {
  * 
  * Block data is stored in flat files (blk?????.dat), while the index
  * and metadata are stored in the key-value database.
+ * 
+ * Only the last block file is appended to. Earlier files never change, so
+ * they are read through shared memory mappings: concurrent readers take a
+ * shared lock just to find the mapping and deserialize straight from the
+ * mapped pages. Reads from the last file go through its FILE* handle.
+ *
+ * Appends to the last block and undo files collect in a write-behind
+ * buffer and reach the OS in large writes; they are forced to disk only by
+ * Flush() / FlushFiles(), which the chain state calls before each UTXO
+ * flush. Files grow in preallocated chunks and a finished file is trimmed
+ * back to its data.
  */
 class BlockDB {
 private:
@@ -212,26 +292,51 @@ private:
     /// Data directory for block files
     std::filesystem::path dataDir_;
     
-    /// Current block file number
-    int32_t nLastBlockFile_{0};
+    /// Current block file number (the one being appended to)
+    std::atomic<int32_t> nLastBlockFile_{0};
     
     /// Information about each block file
     std::vector<BlockFileInfo> blockFileInfo_;
     
     /// Maximum size of a block file (default 128MB)
     static constexpr uint64_t MAX_BLOCKFILE_SIZE = 128 * 1024 * 1024;
+    uint64_t maxBlockFileSize_{MAX_BLOCKFILE_SIZE};
+    
+    /// Disk usage target for block and undo files (0 = no pruning)
+    uint64_t pruneTarget_{0};
+    
+    /// Whether any block file has ever been pruned (persisted)
+    bool havePruned_{false};
+    
+    /// io_uring for block and undo file I/O (SHURIUM_IO_URING builds on
+    /// kernels that have it), shared under ringMutex_. Declared before the
+    /// append files so it outlives their final flush.
+    std::unique_ptr<util::IoRing> ring_;
+    mutable std::mutex ringMutex_;
     
-    /// File handle cache
-    mutable std::map<int, FILE*> fileCache_;
+    /// Block and undo files being appended to, keyed by file number
+    class AppendFile;
+    std::map<int, std::unique_ptr<AppendFile>> blockFiles_;
+    std::map<int, std::unique_ptr<AppendFile>> undoFiles_;
     mutable std::mutex fileMutex_;
     
+    /// Mappings of finished block files, created on first read
+    mutable std::map<int, std::shared_ptr<const util::fs::MappedFile>> mappedFiles_;
+    mutable std::shared_mutex mappedFilesMutex_;
+    mutable std::atomic<uint64_t> nMappedReads_{0};
+    
     // Helper functions
-    std::filesystem::path GetBlockFilePath(int nFile) const;
-    std::filesystem::path GetUndoFilePath(int nFile) const;
-    FILE* OpenBlockFile(int nFile, bool fReadOnly) const;
-    FILE* OpenUndoFile(int nFile, bool fReadOnly) const;
+    /// The open append file for nFile, opening it with data ending at
+    /// nEnd if needed (caller holds fileMutex_)
+    AppendFile* GetAppendFile(std::map<int, std::unique_ptr<AppendFile>>& files,
+                              const std::filesystem::path& path, int nFile, uint64_t nEnd);
+    /// Write out, sync, trim and close the block and undo files of nFile
+    void CloseBlockFile(int nFile);
     void CloseAllFiles();
     
+    /// Mapping of a finished block file (null for the last file or on failure)
+    std::shared_ptr<const util::fs::MappedFile> GetMappedBlockFile(int nFile) const;
+    
     // Allocate space in a block file
     bool AllocateBlockFile(uint32_t nAddSize, DiskBlockPos& pos);
     bool AllocateUndoFile(uint32_t nAddSize, DiskBlockPos& pos);
@@ -253,6 +358,11 @@ public:
     /// Check if database is open
     bool IsOpen() const { return db_ != nullptr; }
     
+    /// Structured statistics of the block index database
+    DatabaseStats GetDatabaseStats() const {
+        return db_ ? db_->GetDatabaseStats() : DatabaseStats();
+    }
+    
     // ========================================================================
     // Block Data Operations
     // ========================================================================
@@ -261,9 +371,15 @@ public:
      * Write a block to disk.
      * @param block Block to write
      * @param pos Output: position where block was written
+     * @param nHeight Height of the block (recorded in the file info)
      * @return Status of the operation
      */
-    Status WriteBlock(const Block& block, DiskBlockPos& pos);
+    Status WriteBlock(const Block& block, DiskBlockPos& pos, int nHeight = 0);
+    
+    /**
+     * Record a block that is already stored (-reindex) in its file's info.
+     */
+    void AddKnownBlock(const DiskBlockPos& pos, int nHeight, uint64_t nTime);
     
     /**
      * Read a block from disk.
@@ -274,7 +390,15 @@ public:
     Status ReadBlock(const DiskBlockPos& pos, Block& block) const;
     
     /**
-     * Write undo data for a block.
+     * Read a block's serialized bytes without deserializing them.
+     * @param pos Position of the block
+     * @param data Output: the block as written by WriteBlock
+     * @return Status of the operation
+     */
+    Status ReadRawBlock(const DiskBlockPos& pos, std::vector<uint8_t>& data) const;
+    
+    /**
+     * Write undo data for a block, in the compressed format.
      * @param undo Undo data
      * @param pos Output: position where undo was written
      * @return Status of the operation
@@ -282,7 +406,7 @@ public:
     Status WriteUndo(const BlockUndo& undo, DiskBlockPos& pos);
     
     /**
-     * Read undo data for a block.
+     * Read undo data for a block (compressed or legacy format).
      * @param pos Position of the undo data
      * @param undo Output: the undo data
      * @return Status of the operation
@@ -316,10 +440,19 @@ public:
     
     /**
      * Load all block index entries into the given map.
+     *
+     * The key space is split by the first hash byte into shards that are
+     * scanned and deserialized in parallel from one database snapshot. The
+     * entries are then bucketed by height and inserted parents-first, which
+     * links each one and computes its chain work in a single pass.
+     *
      * @param blockIndex Map to populate
+     * @param nThreads Threads for the scan (1 = scan on the calling thread)
+     * @param stats Output: phase timings (optional)
      * @return Number of entries loaded, or -1 on error
      */
-    int LoadBlockIndexMap(BlockMap& blockIndex);
+    int LoadBlockIndexMap(BlockMap& blockIndex, int nThreads = 1,
+                          BlockIndexLoadStats* stats = nullptr);
     
     /**
      * Write the best chain tip hash.
@@ -365,6 +498,86 @@ public:
      */
     uint64_t GetBlockDiskUsage() const;
     
+    /**
+     * Get the path of a block file.
+     */
+    std::filesystem::path GetBlockFilePath(int nFile) const;
+    
+    /**
+     * Get the path of an undo file.
+     */
+    std::filesystem::path GetUndoFilePath(int nFile) const;
+    
+    /**
+     * Re-derive block file sizes from the files on disk (for -reindex).
+     * 
+     * Files are taken to be blk00000.dat upwards until the first one that is
+     * missing; the last of them becomes the file appended to. Sizes come
+     * from the files themselves, so new blocks never overwrite old ones even
+     * if the recorded metadata was lost. Undo sizes are kept; block counts
+     * and heights start over and are filled in by AddKnownBlock().
+     * 
+     * @return Number of block files found
+     */
+    int RescanBlockFiles();
+    
+    // ========================================================================
+    // Pruning
+    // ========================================================================
+    
+    /**
+     * Set the disk usage target for block and undo files (0 disables pruning).
+     */
+    void SetPruneTarget(uint64_t bytes) { pruneTarget_ = bytes; }
+    
+    /// Get the prune target in bytes (0 = not pruning)
+    uint64_t GetPruneTarget() const { return pruneTarget_; }
+    
+    /// Check if pruning is enabled
+    bool IsPruneMode() const { return pruneTarget_ > 0; }
+    
+    /// Check if any block file has been pruned
+    bool HavePruned() const { return havePruned_; }
+    
+    /**
+     * Bytes used by block and undo files, as recorded in the file info.
+     */
+    uint64_t CalculateCurrentUsage() const;
+    
+    /**
+     * Choose block files to delete to get under the prune target.
+     * 
+     * Files are taken oldest first. A file qualifies only if every block in
+     * it is more than MIN_BLOCKS_TO_KEEP below the tip, and the file being
+     * appended to is never chosen.
+     * 
+     * @param nTipHeight Height of the active chain tip
+     * @return File numbers to prune (empty if under the target)
+     */
+    std::set<int> FindFilesToPrune(int nTipHeight) const;
+    
+    /**
+     * Delete blk/rev file pairs and clear their file info.
+     * Callers must first stop referring to blocks in them.
+     */
+    void UnlinkPrunedFiles(const std::set<int>& files);
+    
+    /**
+     * Set the size at which a new block file is started (tests use small
+     * files to exercise reading from finished ones).
+     */
+    void SetMaxBlockFileSize(uint64_t bytes) { maxBlockFileSize_ = bytes; }
+    
+    /**
+     * Get the number of blocks read through a memory mapping.
+     */
+    uint64_t GetMappedReadCount() const { return nMappedReads_; }
+    
+    /**
+     * Whether block and undo file I/O goes through io_uring.
+     */
+    bool UsesIoRing() const { return ring_ != nullptr; }
+    
     // ========================================================================
     // Batch Operations
     // ========================================================================
@@ -384,7 +597,12 @@ public:
     // ========================================================================
     
     /**
-     * Flush pending writes to disk.
+     * Write out and fsync buffered block and undo data.
+     */
+    Status FlushFiles();
+    
+    /**
+     * Flush pending writes to disk: block and undo files, then the index.
      */
     Status Flush();
     
@@ -458,6 +676,11 @@ public:
     /// Enable/disable the index
     void SetEnabled(bool enabled) { enabled_ = enabled; }
     
+    /// Structured statistics of the index database
+    DatabaseStats GetDatabaseStats() const {
+        return db_ ? db_->GetDatabaseStats() : DatabaseStats();
+    }
+    
     /**
      * Index a transaction.
      */
@@ -478,6 +701,21 @@ public:
      */
     Status IndexBlock(const Block& block, const DiskBlockPos& blockPos);
     
+    /**
+     * Compute the index entries for a block's transactions.
+     * Offsets are from the start of the block record. Touches no state, so
+     * entries for different blocks can be computed in parallel.
+     */
+    static std::vector<std::pair<TxHash, TxIndexEntry>>
+    GetBlockEntries(const Block& block, const DiskBlockPos& blockPos);
+    
+    /**
+     * Write entries and the new best-block locator in one batch, so the
+     * locator never points past what is indexed.
+     */
+    Status WriteEntries(const std::vector<std::pair<TxHash, TxIndexEntry>>& entries,
+                        const BlockLocator& locator);
+    
     /**
      * Remove all transactions in a block from the index.
      */
@@ -492,6 +730,11 @@ public:
      * Set best indexed block hash.
      */
     Status SetBestBlock(const BlockHash& hash);
+    
+    /**
+     * Get the locator of the best indexed block, written by WriteEntries().
+     */
+    std::optional<BlockLocator> GetBestLocator() const;
 };
 
 } // namespace db
@@ -0,0 +1,125 @@
+// SHURIUM - Block Filter Index Database
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the optional index of compact block filters and their
+// headers (-blockfilterindex), kept in a database of its own.
+
+#ifndef SHURIUM_DB_BLOCKFILTERDB_H
+#define SHURIUM_DB_BLOCKFILTERDB_H
+
+#include "shurium/db/database.h"
+#include "shurium/core/block.h"
+#include "shurium/core/blockfilter.h"
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace shurium {
+namespace db {
+
+// ============================================================================
+// Block Filter Index Entry
+// ============================================================================
+
+/**
+ * A block's filter as stored: the encoded filter with its hash and header,
+ * so getcfheaders and getcfcheckpt never decode or rehash a filter.
+ */
+struct BlockFilterEntry {
+    std::vector<uint8_t> encoded;
+    Hash256 filterHash;
+    Hash256 header;
+
+    BlockFilterEntry() = default;
+    BlockFilterEntry(const BlockFilter& filter, const Hash256& prevHeader)
+        : encoded(filter.GetEncodedFilter()), filterHash(filter.GetHash()),
+          header(filter.ComputeHeader(prevHeader)) {}
+};
+
+/// Serialization for BlockFilterEntry
+template<typename Stream>
+void Serialize(Stream& s, const BlockFilterEntry& entry) {
+    Serialize(s, entry.encoded);
+    Serialize(s, entry.filterHash);
+    Serialize(s, entry.header);
+}
+
+template<typename Stream>
+void Unserialize(Stream& s, BlockFilterEntry& entry) {
+    Unserialize(s, entry.encoded);
+    Unserialize(s, entry.filterHash);
+    Unserialize(s, entry.header);
+}
+
+// ============================================================================
+// Block Filter Index - Optional compact filter index
+// ============================================================================
+
+/**
+ * Filters of one type, keyed by block hash.
+ *
+ * Entries are keyed by hash rather than height, so blocks on a branch that
+ * was reorganized away keep theirs; only the locator says which chain the
+ * index has followed.
+ */
+class BlockFilterIndex {
+private:
+    std::unique_ptr<Database> db_;
+    BlockFilterType filterType_;
+    bool enabled_{false};
+
+public:
+    /**
+     * Open or create the index under dataDir/indexes/blockfilter/<type>.
+     */
+    BlockFilterIndex(BlockFilterType filterType, const std::filesystem::path& dataDir,
+                     const Options& options = Options());
+
+    ~BlockFilterIndex() = default;
+
+    /// Check if index is enabled
+    bool IsEnabled() const { return enabled_; }
+
+    /// Type of the filters held
+    BlockFilterType GetFilterType() const { return filterType_; }
+
+    /// Structured statistics of the index database
+    DatabaseStats GetDatabaseStats() const {
+        return db_ ? db_->GetDatabaseStats() : DatabaseStats();
+    }
+
+    /**
+     * Look up a block's stored entry.
+     */
+    std::optional<BlockFilterEntry> GetEntry(const BlockHash& hash) const;
+
+    /**
+     * Look up and decode a block's filter.
+     */
+    std::optional<BlockFilter> GetFilter(const BlockHash& hash) const;
+
+    /**
+     * Look up a block's filter header.
+     */
+    std::optional<Hash256> GetFilterHeader(const BlockHash& hash) const;
+
+    /**
+     * Write entries and the new best-block locator in one batch, so the
+     * locator never points past what is indexed.
+     */
+    Status WriteEntries(const std::vector<std::pair<BlockHash, BlockFilterEntry>>& entries,
+                        const BlockLocator& locator);
+
+    /**
+     * Get the locator of the best indexed block, written by WriteEntries().
+     */
+    std::optional<BlockLocator> GetBestLocator() const;
+};
+
+} // namespace db
+} // namespace shurium
+
+#endif // SHURIUM_DB_BLOCKFILTERDB_H
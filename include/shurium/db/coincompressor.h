@@ -0,0 +1,69 @@
+// SHURIUM - Compressed Coin Encoding
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// On-disk form of the coins in CoinsViewDB. Each value is written as:
+//   VARINT(height * 2 + coinbase)
+//   the output, as SerializeCompressedTxOut (see core/compressor.h)
+// Standard scripts shrink to a type code plus a hash or an x coordinate.
+// This form is only for storage: the UTXO set hash and snapshots keep
+// using Serialize(Stream&, const Coin&).
+
+#ifndef SHURIUM_DB_COINCOMPRESSOR_H
+#define SHURIUM_DB_COINCOMPRESSOR_H
+
+#include "shurium/chain/coins.h"
+#include "shurium/core/compressor.h"
+#include "shurium/core/serialize.h"
+
+#include <cstdint>
+#include <ios>
+#include <string>
+
+namespace shurium {
+namespace db {
+
+// ============================================================================
+// Format Versions
+// ============================================================================
+
+/// Coin values written with Serialize(Stream&, const Coin&)
+constexpr uint32_t COIN_FORMAT_LEGACY = 0;
+
+/// Coin values written with SerializeCompressedCoin
+constexpr uint32_t COIN_FORMAT_COMPRESSED = 1;
+
+/// Format CoinsViewDB writes
+constexpr uint32_t COIN_FORMAT_CURRENT = COIN_FORMAT_COMPRESSED;
+
+// ============================================================================
+// Coins
+// ============================================================================
+
+template<typename Stream>
+void SerializeCompressedCoin(Stream& s, const Coin& coin) {
+    WriteVarInt(s, (static_cast<uint64_t>(coin.nHeight) << 1) | (coin.fCoinBase ? 1 : 0));
+    SerializeCompressedTxOut(s, coin.out);
+}
+
+template<typename Stream>
+void UnserializeCompressedCoin(Stream& s, Coin& coin) {
+    uint64_t code = ReadVarInt(s);
+    if (code > ((static_cast<uint64_t>(UINT32_MAX) << 1) | 1)) {
+        throw std::ios_base::failure("UnserializeCompressedCoin(): height out of range");
+    }
+    coin.nHeight = static_cast<uint32_t>(code >> 1);
+    coin.fCoinBase = (code & 1) != 0;
+    UnserializeCompressedTxOut(s, coin.out);
+}
+
+/// A coin's database value in the given format
+std::string EncodeCoin(const Coin& coin, uint32_t format = COIN_FORMAT_CURRENT);
+
+/// Parse a coin's database value in the given format
+bool DecodeCoin(const std::string& value, Coin& coin, uint32_t format = COIN_FORMAT_CURRENT);
+
+} // namespace db
+} // namespace shurium
+
+#endif // SHURIUM_DB_COINCOMPRESSOR_H
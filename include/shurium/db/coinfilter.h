@@ -0,0 +1,109 @@
+// SHURIUM - UTXO Key Filter
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file defines the in-memory bloom filter over the outpoints in the
+// UTXO database, which answers definite misses without a disk read.
+
+#ifndef SHURIUM_DB_COINFILTER_H
+#define SHURIUM_DB_COINFILTER_H
+
+#include "shurium/core/transaction.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace shurium {
+namespace db {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Default memory budget of the coin filter in MiB (0 disables it)
+static constexpr int DEFAULT_COIN_FILTER_MB = 32;
+
+/// Hash probes per key
+static constexpr int COIN_FILTER_HASHES = 6;
+
+// ============================================================================
+// CoinFilter - Bloom filter over UTXO outpoints
+// ============================================================================
+
+/**
+ * Bloom filter holding every outpoint ever written to the UTXO database.
+ *
+ * MightContain() returning false means the coin is certainly not in the
+ * database. Spent coins cannot be removed from a bloom filter, so their bits
+ * stay set and the false-positive rate creeps up as the chain grows; it is
+ * rebuilt from the database on every start.
+ *
+ * Bits are set with relaxed atomic ORs, so writers (the UTXO flush) and
+ * readers (validation, mempool) never block each other. A writer must Add()
+ * keys before the database write that makes them visible.
+ */
+class CoinFilter {
+public:
+    /// Filter using memoryBytes of bit array (rounded down to 64-bit words)
+    explicit CoinFilter(size_t memoryBytes);
+
+    CoinFilter(const CoinFilter&) = delete;
+    CoinFilter& operator=(const CoinFilter&) = delete;
+
+    /// Record an outpoint
+    void Add(const OutPoint& outpoint);
+
+    /// False if the outpoint was never added
+    bool MightContain(const OutPoint& outpoint) const;
+
+    /// Record the outcome of a lookup that passed the filter
+    void RecordLookup(bool found) const;
+
+    /// Record a lookup the filter answered
+    void RecordFiltered() const { m_nFiltered.fetch_add(1, std::memory_order_relaxed); }
+
+    /// Size of the bit array in bytes
+    size_t GetMemoryUsage() const { return m_nWords * sizeof(uint64_t); }
+
+    /// Keys added since construction
+    uint64_t GetInsertCount() const { return m_nInserts.load(std::memory_order_relaxed); }
+
+    /// Lookups answered as definite misses
+    uint64_t GetFilteredCount() const { return m_nFiltered.load(std::memory_order_relaxed); }
+
+    /// Lookups that passed the filter but missed in the database
+    uint64_t GetFalsePositiveCount() const {
+        return m_nFalsePositives.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * False-positive rate expected from the current fill: the fraction of
+     * set bits raised to the number of probes. Counts every bit, so call it
+     * for reporting only.
+     */
+    double EstimateFalsePositiveRate() const;
+
+    /// False positives among the negative lookups seen so far
+    double GetObservedFalsePositiveRate() const;
+
+private:
+    size_t m_nWords;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_bits;
+
+    std::atomic<uint64_t> m_nInserts{0};
+    mutable std::atomic<uint64_t> m_nFiltered{0};
+    mutable std::atomic<uint64_t> m_nFalsePositives{0};
+
+    /// Random per-filter key for the probe hashes
+    uint64_t m_k0;
+    uint64_t m_k1;
+
+    /// The two base hashes combined into the probe sequence
+    void Hash(const OutPoint& outpoint, uint64_t& h1, uint64_t& h2) const;
+};
+
+} // namespace db
+} // namespace shurium
+
+#endif // SHURIUM_DB_COINFILTER_H
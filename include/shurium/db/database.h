@@ -10,6 +10,8 @@
 
 #include "shurium/core/types.h"
 #include "shurium/core/serialize.h"
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -165,6 +167,8 @@ struct Options {
     int bloom_filter_bits = 10;
 };
 
+class DatabaseSnapshot;
+
 /**
  * Options for read operations.
  */
@@ -176,7 +180,7 @@ struct ReadOptions {
     bool fill_cache = true;
     
     /// Read from a specific snapshot (nullptr for current)
-    const void* snapshot = nullptr;
+    const DatabaseSnapshot* snapshot = nullptr;
 };
 
 /**
@@ -187,6 +191,53 @@ struct WriteOptions {
     bool sync = false;
 };
 
+// ============================================================================
+// Column Families - Independently tuned keyspaces
+// ============================================================================
+
+/**
+ * The node's keyspaces. Each family lives in its own database instance, so
+ * compacting hot coin keys never rewrites cold block-index data, and each
+ * gets cache, bloom filter and compression settings suited to how it is
+ * read.
+ */
+enum class ColumnFamily {
+    BLOCK_INDEX,    ///< Block index, file info and flags: small, read at startup
+    COINS,          ///< UTXO set: large, random point reads
+    TX_INDEX,       ///< Transaction index: large, point reads by txid
+};
+
+/// Name of a column family, for logging
+const char* GetColumnFamilyName(ColumnFamily family);
+
+/**
+ * Options tuned for a column family.
+ * @param cacheBytes The family's share of the database cache; half goes
+ *                   to the block cache and a quarter to the write buffer
+ * @param base Options whose remaining fields are kept
+ */
+Options GetColumnFamilyOptions(ColumnFamily family, size_t cacheBytes,
+                               const Options& base = Options());
+
+/// Database cache budget split between the column families
+struct ColumnFamilyCacheSizes {
+    size_t blockIndex{0};
+    size_t coins{0};
+    size_t txIndex{0};
+};
+
+/// Block index cache is capped; it holds little and is mostly read once
+static constexpr size_t MAX_BLOCK_INDEX_CACHE = 2 * 1024 * 1024;
+
+/// Transaction index cache is capped at this fraction of the total
+static constexpr size_t TX_INDEX_CACHE_FRACTION = 8;
+
+/**
+ * Split a database cache budget. The block index and (if enabled) the
+ * transaction index get bounded shares; the coins get the rest.
+ */
+ColumnFamilyCacheSizes SplitDatabaseCache(size_t totalBytes, bool txIndex);
+
 // ============================================================================
 // WriteBatch - Atomic batch of write operations
 // ============================================================================
@@ -239,6 +290,67 @@ public:
     }
 };
 
+// ============================================================================
+// ArenaWriteBatch - Write batch serialized in the backend's format
+// ============================================================================
+
+/**
+ * Atomic batch that serializes each operation straight into one contiguous
+ * buffer laid out as the backend's own batch record (LevelDB's WriteBatch
+ * format: a 12-byte header, then tag, length-prefixed key and, for puts,
+ * length-prefixed value). Database::Write hands the buffer to the backend
+ * as is, so a large flush copies its payload once instead of three times.
+ *
+ * Iterate() decodes the buffer in place; its slices point into the arena
+ * and stay valid until the batch is modified.
+ */
+class ArenaWriteBatch {
+public:
+    /// Backend representation; defined in database.cpp
+    struct Arena;
+    
+    ArenaWriteBatch();
+    ~ArenaWriteBatch();
+    
+    ArenaWriteBatch(ArenaWriteBatch&&) noexcept;
+    ArenaWriteBatch& operator=(ArenaWriteBatch&&) noexcept;
+    ArenaWriteBatch(const ArenaWriteBatch&) = delete;
+    ArenaWriteBatch& operator=(const ArenaWriteBatch&) = delete;
+    
+    /// Put a key-value pair
+    void Put(const Slice& key, const Slice& value);
+    
+    /// Delete a key
+    void Delete(const Slice& key);
+    
+    /// Clear all operations
+    void Clear();
+    
+    /// Get number of operations
+    size_t Count() const { return count_; }
+    
+    /// Check if empty
+    bool Empty() const { return count_ == 0; }
+    
+    /// Exact size of the serialized batch in bytes, header included
+    size_t ApproximateSize() const;
+    
+    /**
+     * Visit operations in insertion order without copying. The value is
+     * null for deletes.
+     * @return Corruption if the buffer cannot be decoded
+     */
+    Status Iterate(const std::function<void(const Slice& key, const Slice* value)>& func) const;
+    
+    /// Backend access for Database implementations
+    Arena& GetArena() { return *arena_; }
+    const Arena& GetArena() const { return *arena_; }
+    
+private:
+    std::unique_ptr<Arena> arena_;
+    size_t count_{0};
+};
+
 // ============================================================================
 // Iterator - Database iterator interface
 // ============================================================================
@@ -278,6 +390,109 @@ public:
     virtual Status status() const = 0;
 };
 
+// ============================================================================
+// DatabaseSnapshot - Consistent point-in-time view
+// ============================================================================
+
+/**
+ * RAII handle on a point-in-time view of a database. Reads through its
+ * ReadOptions see the database as it was when the snapshot was taken, while
+ * writes carry on; the view is released when the handle is destroyed. The
+ * handle must not outlive the database that created it.
+ */
+class DatabaseSnapshot {
+public:
+    virtual ~DatabaseSnapshot() = default;
+    
+    /// Options reading this view; scans do not displace the block cache
+    ReadOptions GetReadOptions() const {
+        ReadOptions options;
+        options.snapshot = this;
+        options.fill_cache = false;
+        return options;
+    }
+};
+
+// ============================================================================
+// Database Statistics
+// ============================================================================
+
+/// Latency buckets; bucket i counts operations under 2^i microseconds
+static constexpr size_t DB_LATENCY_BUCKETS = 24;
+
+/// A write taking at least this long counts as a write stall
+static constexpr uint64_t DB_WRITE_STALL_MICROS = 100 * 1000;
+
+/**
+ * Lock-free power-of-two latency histogram.
+ */
+class LatencyHistogram {
+public:
+    /// Point-in-time copy of a histogram
+    struct Snapshot {
+        uint64_t count{0};
+        uint64_t sumMicros{0};
+        uint64_t maxMicros{0};
+        std::array<uint64_t, DB_LATENCY_BUCKETS> buckets{};
+        
+        /// Mean latency in microseconds
+        double MeanMicros() const {
+            return count == 0 ? 0.0 : static_cast<double>(sumMicros) / count;
+        }
+        
+        /// Upper bound of the bucket holding the given fraction (0..1)
+        uint64_t PercentileMicros(double fraction) const;
+    };
+    
+    /// Record one operation
+    void Record(uint64_t micros);
+    
+    /// Copy the current counts
+    Snapshot GetSnapshot() const;
+    
+    /// Clear all counts
+    void Reset();
+    
+private:
+    std::array<std::atomic<uint64_t>, DB_LATENCY_BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumMicros_{0};
+    std::atomic<uint64_t> maxMicros_{0};
+};
+
+/**
+ * Structured metrics for one database. Operation counters are kept by the
+ * instrumented wrapper OpenDatabase returns; engine counters are filled by
+ * the backend and stay zero where it has none.
+ */
+struct DatabaseStats {
+    uint64_t gets{0};
+    uint64_t getHits{0};
+    uint64_t puts{0};
+    uint64_t deletes{0};
+    uint64_t batches{0};
+    uint64_t bytesRead{0};
+    uint64_t bytesWritten{0};
+    uint64_t writeStalls{0};
+    LatencyHistogram::Snapshot getLatency;
+    LatencyHistogram::Snapshot writeLatency;
+    
+    /// Engine: total compaction time and traffic over all levels
+    double compactionSeconds{0};
+    uint64_t compactionBytesRead{0};
+    uint64_t compactionBytesWritten{0};
+    
+    /// Engine: memtables and table readers, and block cache fill
+    uint64_t memoryUsage{0};
+    uint64_t blockCacheUsage{0};
+    uint64_t blockCacheCapacity{0};
+    
+    /// Fraction of gets that found their key
+    double GetHitRate() const {
+        return gets == 0 ? 0.0 : static_cast<double>(getHits) / gets;
+    }
+};
+
 // ============================================================================
 // Database - Abstract database interface
 // ============================================================================
@@ -321,6 +536,18 @@ public:
         return Write(WriteOptions(), batch);
     }
     
+    /**
+     * Apply an arena batch atomically. Backends that understand the arena
+     * format take it without copying; the default replays it through a
+     * WriteBatch.
+     */
+    virtual Status Write(const WriteOptions& options, ArenaWriteBatch* batch);
+    
+    /// Convenience arena write with default options
+    Status Write(ArenaWriteBatch* batch) {
+        return Write(WriteOptions(), batch);
+    }
+    
     /// Create an iterator
     virtual std::unique_ptr<Iterator> NewIterator(const ReadOptions& options) = 0;
     
@@ -329,6 +556,12 @@ public:
         return NewIterator(ReadOptions());
     }
     
+    /**
+     * Take a consistent snapshot of the current contents.
+     * @return Null if the backend does not support snapshots
+     */
+    virtual std::unique_ptr<DatabaseSnapshot> NewSnapshot() { return nullptr; }
+    
     /// Check if a key exists
     virtual bool Exists(const Slice& key) {
         std::string value;
@@ -347,6 +580,16 @@ public:
     
     /// Get database statistics
     virtual std::string GetStats() const { return ""; }
+    
+    /// Get structured statistics
+    virtual DatabaseStats GetDatabaseStats() const {
+        DatabaseStats stats;
+        GetEngineStats(stats);
+        return stats;
+    }
+    
+    /// Fill in the engine counters of stats
+    virtual void GetEngineStats(DatabaseStats& stats) const {}
 };
 
 // ============================================================================
@@ -398,7 +641,7 @@ std::string SerializeToString(const T& obj) {
 template<typename T>
 bool DeserializeFromString(const std::string& data, T& obj) {
     try {
-        DataStream ss(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+        SpanReader ss(reinterpret_cast<const uint8_t*>(data.data()), data.size());
         Unserialize(ss, obj);
         return true;
     } catch (...) {
@@ -420,9 +663,14 @@ namespace prefix {
     // UTXO set
     constexpr char COIN = 'C';            // outpoint -> coin
     constexpr char COINS_TIP = 'c';       // -> best block hash for coins
+    constexpr char COINS_MUHASH = 'm';    // -> rolling hash of the coins
     
     // Transaction index
     constexpr char TX_INDEX = 't';        // txid -> block location
+    constexpr char INDEX_LOCATOR = 'L';   // -> locator of an index's best block
+    
+    // Block filter index
+    constexpr char BLOCK_FILTER = 'g';    // block hash -> filter and header
     
     // Chain state
     constexpr char BEST_CHAIN = 'H';      // -> hash of best chain tip
@@ -434,6 +682,25 @@ namespace prefix {
     
     // Spent index (optional)  
     constexpr char SPENT = 's';           // outpoint -> spending tx info
+    
+    // Nullifier set
+    constexpr char NULLIFIER = 'N';       // epoch, nullifier hash -> (empty)
+    constexpr char NULLIFIER_EPOCH = 'n'; // -> current nullifier epoch
+    
+    // Identity tree
+    constexpr char IDENTITY_NODE = 'I';   // level, index -> node hash
+    constexpr char IDENTITY_ROOT = 'i';   // leaf count -> root at that size
+    constexpr char IDENTITY_TREE_SIZE = 'j'; // -> leaf count
+    
+    // Identity registry
+    constexpr char IDENTITY_RECORD = 'r'; // commitment hash -> identity record
+    
+    // Staking state
+    constexpr char STAKING_VALIDATOR = 'V';  // validator id -> validator record
+    constexpr char STAKING_DELEGATION = 'D'; // delegation id -> delegation record
+    constexpr char STAKING_REWARD = 'W';     // validator id -> reward per share
+    constexpr char STAKING_UNDO = 'U';       // height -> prior values of changed records
+    constexpr char STAKING_TIP = 'T';        // -> height of the last connected block
 }
 
 /**
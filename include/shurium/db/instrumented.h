@@ -0,0 +1,71 @@
+// SHURIUM - Instrumented Database
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// This file provides a Database wrapper that keeps operation counters and
+// latency histograms for any backend.
+
+#ifndef SHURIUM_DB_INSTRUMENTED_H
+#define SHURIUM_DB_INSTRUMENTED_H
+
+#include "shurium/db/database.h"
+#include <atomic>
+#include <memory>
+
+namespace shurium {
+namespace db {
+
+// ============================================================================
+// InstrumentedDatabase
+// ============================================================================
+
+/**
+ * Forwards every call to the wrapped backend and records counts, bytes and
+ * latencies. Counters are relaxed atomics, so concurrent readers and
+ * writers are not serialized by the bookkeeping.
+ */
+class InstrumentedDatabase : public Database {
+public:
+    explicit InstrumentedDatabase(std::unique_ptr<Database> inner);
+
+    Status Get(const ReadOptions& options, const Slice& key, std::string* value) override;
+    Status Put(const WriteOptions& options, const Slice& key, const Slice& value) override;
+    Status Delete(const WriteOptions& options, const Slice& key) override;
+    Status Write(const WriteOptions& options, WriteBatch* batch) override;
+    Status Write(const WriteOptions& options, ArenaWriteBatch* batch) override;
+    std::unique_ptr<Iterator> NewIterator(const ReadOptions& options) override;
+
+    std::unique_ptr<DatabaseSnapshot> NewSnapshot() override { return inner_->NewSnapshot(); }
+    void Compact() override { inner_->Compact(); }
+    Status Sync() override { return inner_->Sync(); }
+    uint64_t GetDiskUsage() const override { return inner_->GetDiskUsage(); }
+    std::string GetStats() const override { return inner_->GetStats(); }
+
+    DatabaseStats GetDatabaseStats() const override;
+    void GetEngineStats(DatabaseStats& stats) const override { inner_->GetEngineStats(stats); }
+
+    /// The wrapped backend
+    Database* GetInner() const { return inner_.get(); }
+
+private:
+    std::unique_ptr<Database> inner_;
+
+    std::atomic<uint64_t> gets_{0};
+    std::atomic<uint64_t> getHits_{0};
+    std::atomic<uint64_t> puts_{0};
+    std::atomic<uint64_t> deletes_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> bytesRead_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<uint64_t> writeStalls_{0};
+    LatencyHistogram getLatency_;
+    LatencyHistogram writeLatency_;
+
+    /// Record a write's latency, counting it as a stall if slow
+    void RecordWrite(uint64_t micros);
+};
+
+} // namespace db
+} // namespace shurium
+
+#endif // SHURIUM_DB_INSTRUMENTED_H
@@ -65,6 +65,25 @@ public:
     }
 };
 
+// ============================================================================
+// LevelDB Snapshot
+// ============================================================================
+
+class LevelDBSnapshot : public DatabaseSnapshot {
+private:
+    leveldb::DB* db_;
+    const leveldb::Snapshot* snapshot_;
+    
+public:
+    explicit LevelDBSnapshot(leveldb::DB* db) : db_(db), snapshot_(db->GetSnapshot()) {}
+    ~LevelDBSnapshot() override { db_->ReleaseSnapshot(snapshot_); }
+    
+    LevelDBSnapshot(const LevelDBSnapshot&) = delete;
+    LevelDBSnapshot& operator=(const LevelDBSnapshot&) = delete;
+    
+    const leveldb::Snapshot* Get() const { return snapshot_; }
+};
+
 // ============================================================================
 // LevelDB Database Implementation
 // ============================================================================
@@ -77,6 +96,7 @@ private:
     leveldb::ReadOptions default_read_options_;
     leveldb::WriteOptions default_write_options_;
     std::filesystem::path path_;
+    size_t block_cache_capacity_{0};
     
     static leveldb::Status ConvertStatus(const Status& s) {
         // Not needed - we convert the other direction
@@ -97,7 +117,9 @@ private:
         leveldb::ReadOptions lo;
         lo.verify_checksums = opts.verify_checksums;
         lo.fill_cache = opts.fill_cache;
-        lo.snapshot = static_cast<const leveldb::Snapshot*>(opts.snapshot);
+        if (opts.snapshot) {
+            lo.snapshot = static_cast<const LevelDBSnapshot*>(opts.snapshot)->Get();
+        }
         return lo;
     }
     
@@ -110,8 +132,10 @@ private:
 public:
     LevelDBDatabase(leveldb::DB* db, leveldb::Cache* cache, 
                     const leveldb::FilterPolicy* filter,
-                    const std::filesystem::path& path)
-        : db_(db), cache_(cache), filter_policy_(filter), path_(path) {}
+                    const std::filesystem::path& path,
+                    size_t block_cache_capacity = 0)
+        : db_(db), cache_(cache), filter_policy_(filter), path_(path),
+          block_cache_capacity_(block_cache_capacity) {}
     
     ~LevelDBDatabase() override {
         // Close in correct order
@@ -152,11 +176,18 @@ public:
         return ConvertStatus(db_->Write(lo, &lb));
     }
     
+    /// Hands the arena's leveldb::WriteBatch to LevelDB directly
+    Status Write(const WriteOptions& options, ArenaWriteBatch* batch) override;
+    
     std::unique_ptr<Iterator> NewIterator(const ReadOptions& options) override {
         leveldb::ReadOptions lo = MakeReadOptions(options);
         return std::make_unique<LevelDBIterator>(db_->NewIterator(lo));
     }
     
+    std::unique_ptr<DatabaseSnapshot> NewSnapshot() override {
+        return std::make_unique<LevelDBSnapshot>(db_.get());
+    }
+    
     void Compact() override {
         db_->CompactRange(nullptr, nullptr);
     }
@@ -180,6 +211,9 @@ public:
         db_->GetProperty("leveldb.stats", &stats);
         return stats;
     }
+    
+    /// Compaction totals from "leveldb.stats", memory and block cache usage
+    void GetEngineStats(DatabaseStats& stats) const override;
 };
 
 #endif // SHURIUM_USE_LEVELDB
@@ -188,6 +222,19 @@ public:
 // In-Memory Database (Fallback when LevelDB not available)
 // ============================================================================
 
+/**
+ * Snapshot of a MemoryDatabase: a private copy of its contents.
+ */
+class MemorySnapshot : public DatabaseSnapshot {
+private:
+    std::map<std::string, std::string> data_;
+    
+public:
+    explicit MemorySnapshot(std::map<std::string, std::string> data) : data_(std::move(data)) {}
+    
+    const std::map<std::string, std::string>& GetData() const { return data_; }
+};
+
 /**
  * Simple in-memory database for testing or when LevelDB is not available.
  */
@@ -200,6 +247,16 @@ public:
     MemoryDatabase() = default;
     
     Status Get(const ReadOptions& options, const Slice& key, std::string* value) override {
+        if (options.snapshot) {
+            const auto& data = static_cast<const MemorySnapshot*>(options.snapshot)->GetData();
+            auto it = data.find(key.ToString());
+            if (it == data.end()) {
+                return Status::NotFound();
+            }
+            *value = it->second;
+            return Status::Ok();
+        }
+        
         std::lock_guard<std::mutex> lock(mutex_);
         auto it = data_.find(key.ToString());
         if (it == data_.end()) {
@@ -233,8 +290,31 @@ public:
         return Status::Ok();
     }
     
+    Status Write(const WriteOptions& options, ArenaWriteBatch* batch) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return batch->Iterate([this](const Slice& key, const Slice* value) {
+            if (value) {
+                data_[key.ToString()] = value->ToString();
+            } else {
+                data_.erase(key.ToString());
+            }
+        });
+    }
+    
     std::unique_ptr<Iterator> NewIterator(const ReadOptions& options) override;
     
+    std::unique_ptr<DatabaseSnapshot> NewSnapshot() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::make_unique<MemorySnapshot>(data_);
+    }
+    
+    void GetEngineStats(DatabaseStats& stats) const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [key, value] : data_) {
+            stats.memoryUsage += key.size() + value.size();
+        }
+    }
+    
     size_t Size() const {
         std::lock_guard<std::mutex> lock(mutex_);
         return data_.size();
@@ -314,6 +394,10 @@ public:
 };
 
 inline std::unique_ptr<Iterator> MemoryDatabase::NewIterator(const ReadOptions& options) {
+    if (options.snapshot) {
+        return std::make_unique<MemoryIterator>(
+            static_cast<const MemorySnapshot*>(options.snapshot)->GetData());
+    }
     return std::make_unique<MemoryIterator>(data_);
 }
 
@@ -9,8 +9,11 @@
 #define SHURIUM_DB_UTXODB_H
 
 #include "shurium/db/database.h"
+#include "shurium/db/coinfilter.h"
+#include "shurium/db/coincompressor.h"
 #include "shurium/chain/coins.h"
 #include <memory>
+#include <mutex>
 #include <filesystem>
 #include <atomic>
 
@@ -36,16 +39,33 @@ private:
     /// Path to the database
     std::filesystem::path dbPath_;
     
-    /// Best block hash (cached)
+    /// Best block hash (cached; guarded so a background flush can update it)
+    mutable std::mutex bestBlockMutex_;
     mutable BlockHash cachedBestBlock_;
     mutable bool cachedBestBlockValid_{false};
     
+    /// Rolling hash of the stored coins (guarded by bestBlockMutex_)
+    MuHash3072 muhash_;
+    
+    /// Filter over stored outpoints for definite misses (null if disabled)
+    std::unique_ptr<CoinFilter> coinFilter_;
+    
     /// Statistics
     mutable std::atomic<uint64_t> nReads_{0};
     mutable std::atomic<uint64_t> nWrites_{0};
     mutable std::atomic<uint64_t> nReadBytes_{0};
     mutable std::atomic<uint64_t> nWriteBytes_{0};
     
+    /// Rewrite coins stored in an older format (see coincompressor.h) in
+    /// the current one, in batches that survive an interruption
+    void UpgradeCoinFormat();
+    
+    /// Read the stored rolling hash, computing it once if the database has none
+    void LoadUTXOHash();
+    
+    /// Write a single-coin change and the updated rolling hash together
+    Status WriteCoinChange(const OutPoint& outpoint, const Coin* coin);
+    
 public:
     /**
      * Open or create the UTXO database.
@@ -57,6 +77,11 @@ public:
                 const Options& options = Options(),
                 bool wipe = false);
     
+    /**
+     * Use an already open database, upgrading its coin format as on open.
+     */
+    explicit CoinsViewDB(std::unique_ptr<Database> database);
+    
     ~CoinsViewDB() override = default;
     
     // Prevent copies
@@ -80,22 +105,31 @@ public:
      * Write a batch of coin changes to the database.
      * This is the primary method for updating the UTXO set.
      * 
+     * Only dirty entries are written; the map itself is left untouched so
+     * a cache can keep reading it while the write is in progress. The
+     * rolling UTXO set hash is updated in the same batch.
+     * 
      * @param mapCoins Map of outpoints to coin cache entries
      * @param hashBlock The block hash this state corresponds to
+     * @param hashDelta Coins added and spent by the changes
      * @return true if successful
      */
-    bool BatchWrite(CoinsMap& mapCoins, const BlockHash& hashBlock);
+    bool BatchWrite(const CoinsMap& mapCoins, const BlockHash& hashBlock,
+                    const MuHash3072& hashDelta) override;
     
     /**
-     * Add a single coin to the database.
+     * Add a single coin to the database (updating the rolling hash).
      */
     Status AddCoin(const OutPoint& outpoint, const Coin& coin);
     
     /**
-     * Remove a coin from the database.
+     * Remove a coin from the database (updating the rolling hash).
      */
     Status RemoveCoin(const OutPoint& outpoint);
     
+    /// Get the rolling hash of the stored coins
+    bool GetUTXOHashState(MuHash3072& state) const override;
+    
     /**
      * Set the best block hash.
      */
@@ -105,20 +139,36 @@ public:
     // Iteration
     // ========================================================================
     
+    /**
+     * Take a consistent view of the coins for a long scan. Blocks keep
+     * connecting and flushing while it is held; reads through it (the
+     * overloads below) see the set as of one best block.
+     * @return Null if the database is closed or cannot snapshot
+     */
+    std::unique_ptr<DatabaseSnapshot> NewSnapshot() const;
+    
+    /// Best block of a snapshot's view
+    BlockHash GetBestBlock(const DatabaseSnapshot& snapshot) const;
+    
+    /// Rolling hash of a snapshot's view
+    bool GetUTXOHashState(MuHash3072& state, const DatabaseSnapshot& snapshot) const;
+    
     /**
      * Create an iterator over all coins.
+     * @param snapshot View to iterate, or null for the live database
      */
-    std::unique_ptr<Iterator> NewIterator() const;
+    std::unique_ptr<Iterator> NewIterator(const DatabaseSnapshot* snapshot = nullptr) const;
     
     /**
      * Iterate over all coins with a callback.
      * @param func Callback function (outpoint, coin) -> bool (continue?)
+     * @param snapshot View to iterate, or null for the live database
      * @return Number of coins iterated
      */
     template<typename Func>
-    size_t ForEachCoin(Func&& func) const {
+    size_t ForEachCoin(Func&& func, const DatabaseSnapshot* snapshot = nullptr) const {
         size_t count = 0;
-        auto iter = NewIterator();
+        auto iter = NewIterator(snapshot);
         std::string prefix(1, prefix::COIN);
         iter->Seek(Slice(prefix));
         
@@ -130,11 +180,13 @@ public:
             
             OutPoint outpoint;
             if (!DeserializeFromString(key.ToString().substr(1), outpoint)) {
+                iter->Next();
                 continue;
             }
             
             Coin coin;
-            if (!DeserializeFromString(iter->value().ToString(), coin)) {
+            if (!DecodeCoin(iter->value().ToString(), coin)) {
+                iter->Next();
                 continue;
             }
             
@@ -153,6 +205,19 @@ public:
     // Statistics and Maintenance
     // ========================================================================
     
+    /**
+     * Build the outpoint filter from every stored coin and start answering
+     * definite misses from it. Call before the view is shared: the scan
+     * runs on the caller's thread and the filter is not synchronized with
+     * concurrent writes until it is installed.
+     * @param memoryBytes Size of the filter's bit array
+     * @return Number of coins added
+     */
+    size_t EnableCoinFilter(size_t memoryBytes);
+    
+    /// The outpoint filter, or null if disabled
+    const CoinFilter* GetCoinFilter() const { return coinFilter_.get(); }
+    
     /**
      * Get read statistics.
      */
@@ -190,6 +255,13 @@ public:
      */
     std::string GetStats() const { return db_ ? db_->GetStats() : ""; }
     
+    /**
+     * Get structured database statistics.
+     */
+    DatabaseStats GetDatabaseStats() const {
+        return db_ ? db_->GetDatabaseStats() : DatabaseStats();
+    }
+    
     /**
      * Check if database is open.
      */
@@ -202,7 +274,7 @@ public:
 
 /**
  * Calculate a hash of the entire UTXO set for verification.
- * This iterates over all coins and computes a cumulative hash.
+ * This iterates over a snapshot of all coins and computes a cumulative hash.
  * 
  * @param coinsView The coins view to hash
  * @return Hash of the UTXO set
@@ -211,8 +283,10 @@ Hash256 CalculateUTXOSetHash(const CoinsViewDB& coinsView);
 
 /**
  * Get comprehensive UTXO statistics.
+ * @param snapshot View to scan; if null, a snapshot is taken for the scan
  */
-UTXOStats GetUTXOStats(const CoinsViewDB& coinsView);
+UTXOStats GetUTXOStats(const CoinsViewDB& coinsView,
+                       const DatabaseSnapshot* snapshot = nullptr);
 
 } // namespace db
 } // namespace shurium
@@ -22,16 +22,20 @@
 #define SHURIUM_ECONOMICS_FUNDS_H
 
 #include <shurium/core/types.h>
+#include <shurium/core/block.h>
 #include <shurium/core/script.h>
 #include <shurium/core/transaction.h>
+#include <shurium/chain/coins.h>
 #include <shurium/crypto/keys.h>
 #include <shurium/crypto/sha256.h>
 
 #include <array>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace shurium {
@@ -221,7 +225,7 @@ public:
     // Balance Tracking
     // ========================================================================
     
-    /// Get current balance for a fund (requires UTXO database access)
+    /// Get current balance for a fund (sum of its tracked unspent UTXOs)
     Amount GetFundBalance(FundType type) const;
     
     /// Get total value received by a fund since genesis
@@ -230,6 +234,12 @@ public:
     /// Get total value spent from a fund
     Amount GetTotalSpent(FundType type) const;
     
+    /// Get number of tracked receives and spends for a fund
+    size_t GetTransactionCount(FundType type) const;
+    
+    /// Get height of the last tracked receive or spend for a fund
+    int64_t GetLastActivityHeight(FundType type) const;
+    
     // ========================================================================
     // Transaction Building
     // ========================================================================
@@ -260,18 +270,36 @@ public:
     // UTXO Tracking (for balance calculations)
     // ========================================================================
     
-    /// Track a new UTXO received by a fund
+    /// Track a new UTXO received by a fund (ignored if already tracked)
     void TrackFundUTXO(FundType type, const OutPoint& outpoint, Amount value, int64_t height);
     
     /// Mark a fund UTXO as spent
     void MarkFundUTXOSpent(FundType type, const OutPoint& outpoint, int64_t height);
     
-    /// Clear all tracked UTXOs (for chain reorg)
+    /// Undo TrackFundUTXO() for a receive whose block was disconnected
+    void UntrackFundUTXO(FundType type, const OutPoint& outpoint);
+    
+    /// Undo MarkFundUTXOSpent() for a spend whose block was disconnected
+    void UnmarkFundUTXOSpent(FundType type, const OutPoint& outpoint);
+    
+    /// Clear all tracked UTXOs
     void ClearTrackedUTXOs();
     
-    /// Get all unspent UTXOs for a fund
+    /// Get all unspent UTXOs for a fund, largest first
     std::vector<std::pair<OutPoint, Amount>> GetFundUTXOs(FundType type) const;
     
+    /// Get number of unspent UTXOs tracked for a fund
+    size_t GetFundUTXOCount(FundType type) const;
+    
+    /**
+     * Apply a block that joined the active chain: outputs paying a fund's
+     * P2SH address are tracked, inputs spending tracked UTXOs mark them spent.
+     */
+    void ConnectBlock(const Block& block, int64_t height);
+    
+    /// Exactly undo ConnectBlock() for a block leaving the active chain
+    void DisconnectBlock(const Block& block, int64_t height);
+    
 private:
     std::vector<FundConfig> m_funds;
     std::map<Hash160, FundType> m_addressToFund;
@@ -280,15 +308,24 @@ private:
     struct FundUTXO {
         Amount value;
         int64_t height;
-        bool spent;
     };
-    std::map<FundType, std::map<OutPoint, FundUTXO>> m_fundUTXOs;
+    using FundUTXOMap = std::unordered_map<OutPoint, FundUTXO, OutPointHasher>;
+    
+    /// Per-fund index: UTXOs partitioned by spent state, with running totals
+    /// so balance queries do not walk the UTXOs
+    struct FundIndex {
+        FundUTXOMap unspent;
+        FundUTXOMap spent;
+        Amount balance{0};
+        Amount totalReceived{0};
+        Amount totalSpent{0};
+        int64_t lastActivityHeight{0};
+        size_t transactionCount{0};
+    };
+    std::unordered_map<FundType, FundIndex> m_fundIndex;
     
-    // Historical tracking
-    std::map<FundType, Amount> m_totalReceived;
-    std::map<FundType, Amount> m_totalSpent;
-    std::map<FundType, int64_t> m_lastActivityHeight;
-    std::map<FundType, size_t> m_transactionCount;
+    /// Guards m_fundIndex; blocks are applied from the validation thread
+    mutable std::mutex m_utxoMutex;
     
     // Pending key rotations
     std::map<FundType, std::array<FundKeyInfo, FUND_MULTISIG_TOTAL>> m_pendingKeyRotations;
@@ -301,6 +338,17 @@ private:
     
     /// Parse address string to Hash160
     static std::optional<Hash160> ParseAddress(const std::string& address);
+    
+    /// Fund paid by a script, if it is P2SH to a fund address
+    std::optional<FundType> GetFundTypeForScript(const Script& script) const;
+    
+    /// Index entry for a fund, or null if nothing was tracked (m_utxoMutex held)
+    const FundIndex* FindIndexLocked(FundType type) const;
+    
+    void TrackFundUTXOLocked(FundType type, const OutPoint& outpoint, Amount value, int64_t height);
+    void MarkFundUTXOSpentLocked(FundType type, const OutPoint& outpoint, int64_t height);
+    void UntrackFundUTXOLocked(FundType type, const OutPoint& outpoint);
+    void UnmarkFundUTXOSpentLocked(FundType type, const OutPoint& outpoint);
 };
 
 // ============================================================================
@@ -193,9 +193,15 @@ struct PriceSubmission {
     /// Create signature message
     std::vector<Byte> GetSignatureMessage() const;
     
-    /// Verify signature
+    /**
+     * Verify the signature over GetHash(). A 64-byte signature is BIP340
+     * Schnorr, anything else DER-encoded ECDSA.
+     */
     bool VerifySignature(const PublicKey& pubkey) const;
     
+    /// Whether the signature is a 64-byte Schnorr one (batch verifiable)
+    bool HasSchnorrSignature() const { return signature.size() == 64; }
+    
     /// Serialize
     std::vector<Byte> Serialize() const;
     
@@ -220,7 +226,9 @@ struct PriceCommitment {
     /// Oracle that committed
     OracleId oracleId;
     
-    /// Hash of (price || salt)
+    /// Double SHA256 of the 64-byte preimage price (LE) || salt || the
+    /// first 24 bytes of oracleId, so a commitment cannot be replayed
+    /// under another oracle's id
     Hash256 commitment;
     
     /// Block height of commitment
@@ -259,6 +267,13 @@ struct PriceCommitment {
     static std::optional<PriceCommitment> Deserialize(const Byte* data, size_t len);
 };
 
+/// A reveal of an earlier commitment, as queued for batch processing
+struct PriceReveal {
+    OracleId oracleId;
+    PriceMillicents price{0};
+    Hash256 salt;
+};
+
 // ============================================================================
 // Oracle Registry
 // ============================================================================
@@ -446,6 +461,24 @@ public:
      */
     bool ProcessReveal(const OracleId& oracleId, PriceMillicents price, const Hash256& salt);
     
+    /**
+     * Process a batch of submissions. Schnorr signatures are checked
+     * together with one SchnorrBatchVerifier pass, falling back to
+     * per-signature checks only to find the bad ones if the batch fails.
+     * 
+     * @return Per-submission acceptance, in input order
+     */
+    std::vector<bool> ProcessSubmissions(const std::vector<PriceSubmission>& submissions);
+    
+    /**
+     * Process a batch of reveals, as arrive together at a reveal deadline.
+     * All commitments are recomputed in one multi-buffer DoubleSHA256_64
+     * call. A second reveal for the same oracle in the batch is rejected.
+     * 
+     * @return Per-reveal validity, in input order
+     */
+    std::vector<bool> ProcessReveals(const std::vector<PriceReveal>& reveals);
+    
     // ========================================================================
     // Aggregation
     // ========================================================================
@@ -502,6 +535,9 @@ private:
     /// Submissions for current round
     std::vector<PriceSubmission> currentSubmissions_;
     
+    /// Median of the current round's submitted prices, kept as they arrive
+    RollingMedian roundMedian_;
+    
     /// Pending commitments (oracle -> commitment)
     std::map<OracleId, PriceCommitment> pendingCommitments_;
     
@@ -513,14 +549,23 @@ private:
     
     mutable std::mutex mutex_;
     
+    /// Add an accepted submission to the round (mutex_ held)
+    void AddSubmissionLocked(const PriceSubmission& submission);
+    
+    /// Mark a verified reveal and add its price to the round (mutex_ held)
+    void AcceptRevealLocked(PriceCommitment& commitment, PriceMillicents price,
+                            const Hash256& salt);
+    
     /// Calculate weighted median
     PriceMillicents CalculateWeightedMedian(
         const std::vector<std::pair<PriceMillicents, double>>& weightedPrices
     ) const;
     
-    /// Detect and remove outliers
+    /// Detect and remove outliers: submissions more than maxDeviationBps
+    /// from the median of all of them
     std::vector<PriceSubmission> RemoveOutliers(
-        const std::vector<PriceSubmission>& submissions
+        const std::vector<PriceSubmission>& submissions,
+        PriceMillicents median
     ) const;
     
     /// Calculate spread
@@ -544,7 +589,19 @@ public:
     /// Initialize with external registry
     void Initialize(std::shared_ptr<OracleRegistry> registry);
     
-    /// Process a block (triggers aggregation if needed)
+    /// Queue a submission for the next ProcessBlock
+    void QueueSubmission(const PriceSubmission& submission);
+    
+    /// Queue a reveal for the next ProcessBlock
+    void QueueReveal(const PriceReveal& reveal);
+    
+    /// Number of submissions and reveals waiting for the next block
+    size_t GetQueuedCount() const;
+    
+    /**
+     * Process a block: verify everything queued since the last block as
+     * one batch, then aggregate once.
+     */
     void ProcessBlock(int height);
     
     /// Get current price
@@ -570,6 +627,11 @@ private:
     std::shared_ptr<OracleRegistry> registry_;
     std::unique_ptr<PriceAggregator> aggregator_;
     std::vector<PriceCallback> callbacks_;
+    
+    /// Submissions and reveals received since the last block
+    std::vector<PriceSubmission> queuedSubmissions_;
+    std::vector<PriceReveal> queuedReveals_;
+    
     mutable std::mutex mutex_;
 };
 
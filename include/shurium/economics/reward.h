@@ -135,9 +135,20 @@ public:
     
     /// Get blocks until next halving
     int GetBlocksUntilHalving(int currentHeight) const;
+    
+    /// Per-halving reward schedule, computed once at construction.
+    /// Entry i is the distribution for halving epoch i; the last entry
+    /// applies to every later epoch (the minimum reward floor).
+    const std::vector<RewardDistribution>& GetRewardSchedule() const {
+        return schedule_;
+    }
+    
+    /// Index into GetRewardSchedule() for a height (-1 if height < 0)
+    int GetScheduleIndex(int height) const;
 
 private:
     const consensus::Params& params_;
+    std::vector<RewardDistribution> schedule_;
 };
 
 // ============================================================================
@@ -228,6 +239,15 @@ public:
     /// Create builder with calculator
     explicit CoinbaseBuilder(const RewardCalculator& calculator);
     
+    /// Create builder with fixed fund addresses. One output template is
+    /// prebuilt per halving epoch, so building a coinbase only fills in the
+    /// miner script and verifying one is a structural compare.
+    CoinbaseBuilder(const RewardCalculator& calculator,
+                    const Hash160& ubiPoolAddress,
+                    const Hash160& contributionsAddress,
+                    const Hash160& ecosystemAddress,
+                    const Hash160& stabilityAddress);
+    
     /// Build coinbase outputs for a block
     /// @param height Block height
     /// @param minerAddress Address for work reward (miner's share)
@@ -247,14 +267,33 @@ public:
         const Hash160& stabilityAddress
     ) const;
     
-    /// Verify coinbase outputs match expected distribution
+    /// Build coinbase outputs using the fund addresses given at construction
+    /// @return Empty if the builder has no fund addresses
+    std::vector<std::pair<std::vector<Byte>, Amount>> BuildCoinbase(
+        int height,
+        const Hash160& minerAddress
+    ) const;
+    
+    /// Verify coinbase outputs match expected distribution.
+    /// With fund addresses, outputs must match the epoch template exactly
+    /// (count, order, amounts and fund scripts); otherwise only the total
+    /// is checked.
     bool VerifyCoinbase(
         int height,
         const std::vector<std::pair<std::vector<Byte>, Amount>>& outputs
     ) const;
+    
+    /// Whether fund-address templates were prebuilt
+    bool HasTemplates() const { return !templates_.empty(); }
 
 private:
+    using Outputs = std::vector<std::pair<std::vector<Byte>, Amount>>;
+    
     const RewardCalculator& calculator_;
+    
+    /// Outputs per schedule entry; the miner script (first output) is left
+    /// empty and filled in per block.
+    std::vector<Outputs> templates_;
 };
 
 // ============================================================================
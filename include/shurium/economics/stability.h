@@ -24,6 +24,7 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -216,6 +217,11 @@ private:
 
 /**
  * Time-weighted average price (TWAP).
+ * 
+ * Each observation is weighted by the time until the next one; the
+ * newest is weighted by the time since it was seen. The weighted sum and
+ * total time of the closed intervals are kept as observations enter and
+ * leave the window, so Calculate() is constant time.
  */
 class TimeWeightedAveragePrice {
 public:
@@ -229,14 +235,65 @@ public:
     PriceMillicents Calculate() const;
     
     /// Get number of observations in window
-    size_t ObservationCount() const { return observations_.size(); }
+    size_t ObservationCount() const { return samples_.size(); }
     
     /// Clear old observations
     void Prune();
 
 private:
+    /// The part of an observation the average needs
+    struct Sample {
+        PriceMillicents price;
+        PriceTimestamp timestamp;
+    };
+    
     std::chrono::seconds window_;
-    std::deque<PriceObservation> observations_;
+    std::deque<Sample> samples_;
+    
+    /// Sum of price * seconds, and of seconds, over the intervals between
+    /// consecutive samples (intervals that run backwards count as empty)
+    int64_t weightedSum_{0};
+    int64_t durationSum_{0};
+    
+    /// Seconds from a sample to the next, or 0 if the clock went backwards
+    static int64_t IntervalSeconds(const Sample& from, const Sample& to);
+};
+
+/**
+ * Median of a changing multiset of prices.
+ * 
+ * The values are split in two halves around the median: the lower half
+ * holds floor(n/2) values and the upper half the rest, so the median is
+ * the smallest value of the upper half. Adding or removing a value costs
+ * O(log n) and reading the median O(1). The halves are ordered multisets
+ * rather than binary heaps so that any value, not just the extremes, can
+ * be removed when it leaves the window.
+ */
+class RollingMedian {
+public:
+    /// Add a value
+    void Add(PriceMillicents value);
+    
+    /// Remove one copy of a value
+    /// @return false if the value is not present
+    bool Remove(PriceMillicents value);
+    
+    /// Value at index n/2 of the sorted values (the upper median), or
+    /// nullopt when empty
+    std::optional<PriceMillicents> Median() const;
+    
+    /// Number of values
+    size_t Size() const { return lower_.size() + upper_.size(); }
+    
+    /// Remove all values
+    void Clear();
+
+private:
+    std::multiset<PriceMillicents> lower_;
+    std::multiset<PriceMillicents> upper_;
+    
+    /// Move values between halves until lower_ holds floor(n/2)
+    void Rebalance();
 };
 
 // ============================================================================
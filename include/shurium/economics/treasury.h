@@ -455,7 +455,7 @@ public:
     /// Get proposal by ID
     const TreasuryProposal* GetProposal(const ProposalId& id) const;
     
-    /// Get all proposals
+    /// Get all proposals (with a status, read from the per-status index)
     std::vector<const TreasuryProposal*> GetProposals(
         std::optional<ProposalStatus> status = std::nullopt
     ) const;
@@ -561,13 +561,24 @@ public:
         std::string ToString() const;
     };
     
+    /**
+     * Report on the treasury at a height. The report is built from the
+     * per-status proposal index and kept until a treasury event (funds,
+     * proposal or status change, spending, new period) invalidates it, so
+     * repeated polls at the same height return the cached copy, timestamp
+     * included.
+     */
     Report GenerateReport(int height) const;
     
     // ========================================================================
     // Serialization
     // ========================================================================
     
+    /// Full state: balances, proposals, votes, budget and multi-sig
+    /// configuration (callbacks are not included)
     std::vector<Byte> Serialize() const;
+    
+    /// Restore state (also reads the older balances-only format)
     bool Deserialize(const Byte* data, size_t len);
 
 private:
@@ -583,6 +594,18 @@ private:
     /// Votes by proposal
     std::map<ProposalId, std::vector<TreasuryVote>> votes_;
     
+    /// Proposal ids by status, kept in step by SetProposalStatus()
+    std::map<ProposalStatus, std::set<ProposalId>> proposalsByStatus_;
+    
+    /// Voters by proposal, for duplicate checks without scanning votes_
+    std::map<ProposalId, std::set<PublicKey>> voters_;
+    
+    /// Funds added since the current budget period started
+    Amount periodReceived_{0};
+    
+    /// Last generated report; reset by every treasury event
+    mutable std::optional<Report> cachedReport_;
+    
     /// Current budget
     TreasuryBudget currentBudget_;
     
@@ -601,6 +624,18 @@ private:
     /// Update proposal status based on voting results
     void UpdateProposalStatus(TreasuryProposal& proposal, int currentHeight);
     
+    /// Change a proposal's status and move it in the status index
+    void SetProposalStatus(TreasuryProposal& proposal, ProposalStatus status);
+    
+    /// Rebuild the status and voter indexes from proposals_ and votes_
+    void RebuildIndexes();
+    
+    /// ExecuteSpending() with mutex_ held
+    bool ExecuteSpendingLocked(const ProposalId& proposalId);
+    
+    /// Read a version 0x01 record (balances only)
+    bool DeserializeBalances(const Byte* data, size_t len);
+    
     /// Execute approved proposals
     void ExecuteApprovedProposals(int currentHeight);
     
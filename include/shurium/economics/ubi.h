@@ -32,6 +32,8 @@
 #include <vector>
 
 namespace shurium {
+namespace db { class Database; }
+namespace util { class ThreadPool; }
 namespace economics {
 
 // Forward declarations
@@ -55,6 +57,12 @@ constexpr int UBI_CLAIM_WINDOW = 2880; // ~24 hours
 /// Grace period for late claims (additional epochs)
 constexpr int UBI_GRACE_EPOCHS = 7; // ~1 week
 
+/// Epochs kept in memory behind the latest one. Every pool stops taking
+/// claims inside this window, so older pools and their nullifiers are
+/// pruned and only the all-time counters remember them.
+constexpr uint32_t UBI_HOT_EPOCHS =
+    UBI_CLAIM_WINDOW / EPOCH_BLOCKS + UBI_GRACE_EPOCHS + 2;
+
 // ============================================================================
 // UBI Claim Status
 // ============================================================================
@@ -152,7 +160,9 @@ struct UBIClaim {
 /**
  * UBI pool for a single epoch.
  * 
- * Tracks the accumulated UBI funds and claim status for one epoch.
+ * Tracks the accumulated UBI funds and claim counters for one epoch. The
+ * pool is fixed-size; the nullifiers that claimed it are kept by the
+ * distributor's NullifierSet.
  */
 struct EpochUBIPool {
     /// Epoch identifier
@@ -173,9 +183,6 @@ struct EpochUBIPool {
     /// Number of successful claims
     uint32_t claimCount{0};
     
-    /// Set of used nullifiers (to prevent double-claiming)
-    std::set<identity::Nullifier> usedNullifiers;
-    
     /// Whether pool is finalized (epoch complete)
     bool isFinalized{false};
     
@@ -188,11 +195,8 @@ struct EpochUBIPool {
     /// Calculate per-person amount
     void Finalize(uint32_t identityCount);
     
-    /// Check if nullifier is already used
-    bool IsNullifierUsed(const identity::Nullifier& nullifier) const;
-    
     /// Record a claim
-    void RecordClaim(const identity::Nullifier& nullifier, Amount amount);
+    void RecordClaim(Amount amount);
     
     /// Get unclaimed amount
     Amount UnclaimedAmount() const;
@@ -215,12 +219,24 @@ struct EpochUBIPool {
  * Main class for UBI distribution.
  * 
  * Manages epoch pools, processes claims, and tracks distribution statistics.
+ * Only the pools of the last UBI_HOT_EPOCHS epochs are kept; used
+ * nullifiers live in an identity::NullifierSet keyed by claim epoch, pruned
+ * along with the pools, so memory stays flat as epochs go by.
  */
 class UBIDistributor {
 public:
+    /// Called with each pool as it is finalized
+    using EpochFinalizedCallback = std::function<void(const EpochUBIPool& pool)>;
+    
     /// Create distributor with reward calculator
     explicit UBIDistributor(const RewardCalculator& calculator);
     
+    /// Create distributor keeping used nullifiers in nullifierDb. The
+    /// database may be shared with other data, but not with another
+    /// NullifierSet.
+    UBIDistributor(const RewardCalculator& calculator,
+                   std::unique_ptr<db::Database> nullifierDb);
+    
     ~UBIDistributor();
     
     // ========================================================================
@@ -237,6 +253,10 @@ public:
     /// @param identityCount Number of eligible identities
     void FinalizeEpoch(EpochId epoch, uint32_t identityCount);
     
+    /// Set the callback run by FinalizeEpoch (with the distributor locked,
+    /// so it must not call back into it)
+    void SetEpochFinalizedCallback(EpochFinalizedCallback callback);
+    
     /// Get pool for an epoch
     const EpochUBIPool* GetPool(EpochId epoch) const;
     
@@ -278,6 +298,32 @@ public:
         int currentHeight
     ) const;
     
+    /**
+     * Process a batch of UBI claims.
+     * 
+     * Each claim gets the status ProcessClaim() would give it if the batch
+     * were processed one claim at a time, in order. Claims sharing a
+     * nullifier are grouped up front so that normally one proof per
+     * nullifier is checked. Proofs are checked without holding the lock,
+     * in parallel over the thread pool when one is given, and the accepted
+     * claims are then recorded in order.
+     * 
+     * @param claims Claims to process; each gets its status and amount
+     * @param identityTreeRoot Current identity tree root
+     * @param currentHeight Current block height
+     * @param pool Thread pool for the proof checks (nullptr: check inline)
+     * @return Status of each claim, in order
+     */
+    std::vector<ClaimStatus> ProcessClaims(
+        std::vector<UBIClaim>& claims,
+        const Hash256& identityTreeRoot,
+        int currentHeight,
+        util::ThreadPool* pool = nullptr
+    );
+    
+    /// Check if a nullifier has already claimed an epoch
+    bool IsNullifierUsed(EpochId epoch, const identity::Nullifier& nullifier) const;
+    
     /// Check if epoch is claimable
     bool IsEpochClaimable(EpochId epoch, int currentHeight) const;
     
@@ -294,9 +340,12 @@ public:
     /// Get total claims processed all-time
     uint64_t GetTotalClaims() const { return totalClaims_; }
     
-    /// Get average claim rate across epochs
+    /// Get average claim rate across finalized epochs, pruned ones included
     double GetAverageClaimRate() const;
     
+    /// Number of epoch pools held in memory
+    size_t GetPoolCount() const;
+    
     /// Get distribution statistics for an epoch
     struct EpochStats {
         EpochId epoch;
@@ -325,9 +374,23 @@ private:
     /// Current epoch
     EpochId currentEpoch_{0};
     
-    /// Pool for each epoch
+    /// Latest epoch seen; pools more than UBI_HOT_EPOCHS behind are pruned
+    EpochId latestEpoch_{0};
+    
+    /// Pool for each epoch in the hot window
     std::map<EpochId, EpochUBIPool> pools_;
     
+    /// Nullifiers that claimed the hot epochs, keyed by claim epoch
+    std::unique_ptr<identity::NullifierSet> usedNullifiers_;
+    
+    /// Whether usedNullifiers_ is backed by a caller's database, so
+    /// Serialize() leaves it out
+    bool persistentNullifiers_{false};
+    
+    /// Claim rates of the finalized pools pruned so far
+    double archivedClaimRateSum_{0.0};
+    uint64_t archivedPoolCount_{0};
+    
     /// Total distributed all-time
     Amount totalDistributed_{0};
     
@@ -337,10 +400,26 @@ private:
     /// Mutex for thread safety
     mutable std::mutex mutex_;
     
+    /// Told of each finalized pool
+    EpochFinalizedCallback epochFinalizedCallback_;
+    
     /// Get or create pool for epoch
     EpochUBIPool& GetOrCreatePool(EpochId epoch);
     
-    /// Clean up old pools
+    /// Pool and nullifier checks of ProcessClaim (caller holds mutex_)
+    /// @return Valid if the claim may go on to proof verification
+    ClaimStatus CheckClaimAgainstPool(const UBIClaim& claim, int currentHeight) const;
+    
+    /// Record a checked claim in its pool and the nullifier set (caller
+    /// holds mutex_)
+    /// @return Valid, or why the nullifier could not be stored
+    ClaimStatus RecordClaimLocked(UBIClaim& claim);
+    
+    /// Move to a later epoch, pruning what falls out of the hot window
+    /// (caller holds mutex_)
+    void AdvanceLatestEpoch(EpochId epoch);
+    
+    /// Drop pools and nullifiers older than the hot window
     void PruneOldPools(EpochId currentEpoch);
 };
 
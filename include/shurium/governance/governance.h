@@ -18,6 +18,8 @@
 #include <shurium/core/types.h>
 #include <shurium/crypto/keys.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -238,6 +240,10 @@ enum class GovernableParameter {
     MaxParameterCount
 };
 
+/// Number of governable parameters
+static constexpr size_t GOVERNABLE_PARAMETER_COUNT =
+    static_cast<size_t>(GovernableParameter::MaxParameterCount);
+
 /// Convert parameter to string
 const char* GovernableParameterToString(GovernableParameter param);
 
@@ -620,6 +626,13 @@ private:
 
 /**
  * Manages vote delegations.
+ *
+ * The power delegated to each delegate is kept as a running sum over the
+ * delegations valid at the registry's height (the last ExpireDelegations
+ * height), split by scope. Adding, removing or expiring a delegation, a
+ * delegation becoming valid, or a delegator's power changing adjusts one
+ * sum, so effective voting power is a lookup rather than a walk over the
+ * delegate's delegators.
  */
 class DelegationRegistry {
 public:
@@ -638,7 +651,16 @@ public:
     /// Get all delegators to a delegate
     std::vector<VoterId> GetDelegators(const VoterId& delegate) const;
     
-    /// Get effective voting power including delegations
+    /// Record a delegator's own voting power (ignored for voters who do not
+    /// delegate; call again after AddDelegation)
+    void UpdateDelegatorPower(const VoterId& delegator, uint64_t power);
+    
+    /// Re-read every delegator's power from tracker
+    void RefreshDelegatorPowers(const VotingPowerTracker& tracker);
+    
+    /// Get effective voting power including delegations. The voter's own
+    /// power comes from tracker, delegated power from the powers recorded
+    /// with UpdateDelegatorPower.
     uint64_t GetEffectiveVotingPower(
         const VoterId& voter,
         const VotingPowerTracker& tracker,
@@ -651,7 +673,8 @@ public:
     /// Get delegation chain depth
     int GetDelegationDepth(const VoterId& voter) const;
     
-    /// Expire old delegations at given height
+    /// Expire old delegations at given height, and count delegations that
+    /// have become valid by it
     void ExpireDelegations(int height);
     
     /// Get number of active delegations
@@ -667,9 +690,42 @@ public:
     bool Deserialize(const Byte* data, size_t len);
     
 private:
+    /// Power delegated to one delegate
+    struct DelegatedPower {
+        uint64_t unscoped{0};
+        std::map<ProposalType, uint64_t> scoped;
+    };
+    
+    /// Add (or with remove, take back) a delegation in its delegate's sum
+    void CountDelegation(const Delegation& delegation, bool remove);
+    
+    /// Add a stored delegation to the lookup, height and power indexes
+    void IndexDelegation(const Delegation& delegation);
+    
+    /// Remove a stored delegation from the indexes
+    void UnindexDelegation(const Delegation& delegation);
+    
+    /// Recompute the indexes from delegations_ at height_
+    void RebuildIndexes();
+    
     mutable std::mutex mutex_;
     std::map<VoterId, Delegation> delegations_;  // delegator -> delegation
     std::map<VoterId, std::set<VoterId>> reverseLookup_;  // delegate -> delegators
+    
+    // Height the sums are valid at
+    int height_{0};
+    
+    // Delegator -> own voting power
+    std::map<VoterId, uint64_t> delegatorPower_;
+    
+    // Delegate -> power of its delegations valid at height_
+    std::map<VoterId, DelegatedPower> delegatedPower_;
+    
+    // Creation height -> delegator, for delegations not yet valid
+    std::multimap<int, VoterId> pendingDelegations_;
+    
+    // Expiration height -> delegator
+    std::multimap<int, VoterId> expiringDelegations_;
 };
 
 // ============================================================================
@@ -678,6 +734,11 @@ private:
 
 /**
  * Stores current governable parameter values.
+ *
+ * Integer values are mirrored in a flat array indexed by parameter, so
+ * GetParameterInt is a lock-free load, and every change bumps an epoch.
+ * Code that reads a parameter often can hold a CachedParameter, which
+ * re-reads the value only when the epoch has moved.
  */
 class ParameterRegistry {
 public:
@@ -690,9 +751,12 @@ public:
     /// Get parameter value
     ParameterValue GetParameter(GovernableParameter param) const;
     
-    /// Get parameter as int64
+    /// Get parameter as int64 (0 for string parameters). Lock-free.
     int64_t GetParameterInt(GovernableParameter param) const;
     
+    /// Counter bumped by every change to the parameters
+    uint64_t GetEpoch() const { return epoch_.load(std::memory_order_acquire); }
+    
     /// Get parameter as string
     std::string GetParameterString(GovernableParameter param) const;
     
@@ -715,8 +779,42 @@ public:
     bool Deserialize(const Byte* data, size_t len);
     
 private:
+    /// Refresh the integer mirror from parameters_ and bump the epoch
+    /// (caller holds mutex_)
+    void PublishValues();
+    
     mutable std::mutex mutex_;
     std::map<GovernableParameter, ParameterValue> parameters_;
+    
+    // Integer values by parameter index, and the change counter
+    std::array<std::atomic<int64_t>, GOVERNABLE_PARAMETER_COUNT> intValues_{};
+    std::atomic<uint64_t> epoch_{0};
+};
+
+/**
+ * One parameter's integer value, re-read from the registry only after it
+ * changes. Not thread-safe: give each reader its own.
+ */
+class CachedParameter {
+public:
+    CachedParameter(const ParameterRegistry& registry, GovernableParameter param)
+        : registry_(&registry), param_(param) {}
+    
+    /// Current value
+    int64_t Get() {
+        uint64_t epoch = registry_->GetEpoch();
+        if (epoch != epoch_) {
+            value_ = registry_->GetParameterInt(param_);
+            epoch_ = epoch;
+        }
+        return value_;
+    }
+    
+private:
+    const ParameterRegistry* registry_;
+    GovernableParameter param_;
+    int64_t value_{0};
+    uint64_t epoch_{UINT64_MAX};  // Never a real epoch, so the first Get reads
 };
 
 // ============================================================================
@@ -779,6 +877,12 @@ public:
     /// Reset veto counts (at period boundary)
     void ResetVetoCounts();
     
+    /// Serialize
+    std::vector<Byte> Serialize() const;
+    
+    /// Deserialize
+    bool Deserialize(const Byte* data, size_t len);
+    
 private:
     mutable std::mutex mutex_;
     std::map<VoterId, Guardian> guardians_;
@@ -923,6 +1027,16 @@ private:
     /// End voting period for a proposal
     void EndVoting(GovernanceProposalId& id, int height);
     
+    /// Advance a proposal through every status change due at height
+    void AdvanceProposal(GovernanceProposal& proposal, int height);
+    
+    /// Queue the proposal's next status change, and keep openProposals_
+    /// in step with its status
+    void ScheduleTransition(const GovernanceProposal& proposal);
+    
+    /// Rebuild openProposals_ and transitions_ from proposals_
+    void RebuildProposalIndexes();
+    
     /// Execute an approved proposal
     bool ExecuteProposal(GovernanceProposal& proposal);
     
@@ -963,6 +1077,14 @@ private:
     std::map<GovernanceProposalId, GovernanceProposal> proposals_;
     std::map<GovernanceProposalId, std::map<VoterId, Vote>> votes_;
     
+    // Pending or Active proposals
+    std::set<GovernanceProposalId> openProposals_;
+    
+    // Height at which each proposal's status can next change (voting
+    // start, voting end or execution). Entries for proposals cancelled or
+    // vetoed in the meantime are skipped when they come due.
+    std::multimap<int, GovernanceProposalId> transitions_;
+    
     // Voter public key registry (voter ID -> public key)
     std::map<VoterId, PublicKey> voterKeys_;
     
@@ -0,0 +1,151 @@
+// SHURIUM - Governance State Snapshots
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Saving the governance engine (with its parameter and guardian registries)
+// and the treasury to disk every so many blocks, so a restarted node loads
+// the latest snapshot and only processes the blocks after it.
+
+#ifndef SHURIUM_GOVERNANCE_SNAPSHOT_H
+#define SHURIUM_GOVERNANCE_SNAPSHOT_H
+
+#include <shurium/core/types.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace shurium {
+
+namespace economics { class Treasury; }
+
+namespace governance {
+
+class GovernanceEngine;
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Snapshot file format version
+static constexpr uint16_t GOVERNANCE_SNAPSHOT_VERSION = 1;
+
+/// Name of the snapshot file in the data directory
+static constexpr const char* GOVERNANCE_SNAPSHOT_FILENAME = "governance.dat";
+
+/// Blocks between snapshots of a running node
+static constexpr int DEFAULT_GOVERNANCE_SNAPSHOT_INTERVAL = 100;
+
+/// Largest state section accepted when reading (guards against bad lengths)
+static constexpr uint64_t MAX_GOVERNANCE_SNAPSHOT_SECTION_BYTES = 256 * 1024 * 1024;
+
+// ============================================================================
+// Snapshot
+// ============================================================================
+
+/**
+ * Serialized governance and treasury state as of a block.
+ *
+ * File layout (integers little-endian): magic "sgov", version (u16),
+ * height (i32), then the engine state and the treasury state, each a
+ * compact size followed by the bytes (an empty treasury section means the
+ * node ran without a treasury).
+ */
+struct GovernanceSnapshot {
+    /// Height of the last block processed into the state
+    int height{-1};
+
+    /// GovernanceEngine::Serialize
+    std::vector<Byte> engineState;
+
+    /// Treasury::Serialize (empty if none)
+    std::vector<Byte> treasuryState;
+
+    /// Serialize the current state. Cheap enough for the block thread; the
+    /// file write is what goes to the background.
+    static GovernanceSnapshot Capture(int height, const GovernanceEngine& engine,
+                                      const economics::Treasury* treasury = nullptr);
+
+    /// Load the state into engine (and treasury, if both are present)
+    bool Restore(GovernanceEngine& engine, economics::Treasury* treasury = nullptr) const;
+};
+
+/// Outcome of writing or reading a snapshot file
+struct GovernanceSnapshotResult {
+    bool success{false};
+    std::string error;
+
+    /// Height of the snapshot written or read
+    int height{-1};
+
+    static GovernanceSnapshotResult Error(const std::string& msg) {
+        GovernanceSnapshotResult result;
+        result.error = msg;
+        return result;
+    }
+};
+
+/**
+ * Write a snapshot file.
+ *
+ * The file is written under a temporary name and renamed over the old one
+ * once complete, so a crash part-way leaves the previous snapshot intact.
+ */
+GovernanceSnapshotResult WriteGovernanceSnapshot(const GovernanceSnapshot& snapshot,
+                                                 const std::filesystem::path& path);
+
+/// Read a snapshot file
+GovernanceSnapshotResult ReadGovernanceSnapshot(const std::filesystem::path& path,
+                                                GovernanceSnapshot& snapshot);
+
+// ============================================================================
+// Background Writer
+// ============================================================================
+
+/**
+ * Writes snapshots on its own thread.
+ *
+ * Submit() hands over a captured snapshot and returns at once. If the
+ * thread is still busy with an earlier one, only the newest waiting
+ * snapshot is kept.
+ */
+class GovernanceSnapshotWriter {
+public:
+    explicit GovernanceSnapshotWriter(std::filesystem::path path);
+
+    /// Stops the thread (writing any waiting snapshot first)
+    ~GovernanceSnapshotWriter();
+
+    GovernanceSnapshotWriter(const GovernanceSnapshotWriter&) = delete;
+    GovernanceSnapshotWriter& operator=(const GovernanceSnapshotWriter&) = delete;
+
+    /// Queue a snapshot for writing
+    void Submit(GovernanceSnapshot snapshot);
+
+    /// Write any waiting snapshot and stop the thread
+    void Stop();
+
+    /// Height of the last snapshot written (-1 if none)
+    int GetLastWrittenHeight() const;
+
+private:
+    void Run();
+
+    std::filesystem::path path_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::optional<GovernanceSnapshot> pending_;
+    int lastWrittenHeight_{-1};
+    bool stop_{false};
+};
+
+} // namespace governance
+} // namespace shurium
+
+#endif // SHURIUM_GOVERNANCE_SNAPSHOT_H
@@ -23,6 +23,7 @@
 #include <vector>
 
 namespace shurium {
+namespace util { class ThreadPool; }
 namespace identity {
 
 // ============================================================================
@@ -272,8 +273,10 @@ public:
     /// Default constructor - empty tree
     VectorCommitment();
     
-    /// Construct from a vector of elements
-    explicit VectorCommitment(const std::vector<FieldElement>& elements);
+    /// Construct from a vector of elements. With a running pool, large
+    /// levels of the tree are hashed in parallel.
+    explicit VectorCommitment(const std::vector<FieldElement>& elements,
+                              util::ThreadPool* pool = nullptr);
     
     /// Construct from existing root
     explicit VectorCommitment(const FieldElement& root, uint64_t size);
@@ -282,8 +285,10 @@ public:
     /// @return Index of the added element
     uint64_t Add(const FieldElement& element);
     
-    /// Add multiple elements
-    void AddBatch(const std::vector<FieldElement>& elements);
+    /// Add multiple elements, rebuilding the tree once (in parallel with a
+    /// running pool). The result is the same as calling Add for each.
+    void AddBatch(const std::vector<FieldElement>& elements,
+                  util::ThreadPool* pool = nullptr);
     
     /// Get the root hash (commitment)
     FieldElement GetRoot() const { return root_; }
@@ -333,7 +338,14 @@ private:
     std::vector<std::vector<FieldElement>> levels_;
     
     /// Rebuild tree from leaves
-    void RebuildTree();
+    void RebuildTree(util::ThreadPool* pool = nullptr);
+    
+    /// Recompute the nodes above one leaf after it changed
+    void UpdatePath(uint64_t index);
+    
+    /// Parent hashes of one level, via Poseidon::HashMany
+    static std::vector<FieldElement> HashLevel(const std::vector<FieldElement>& level,
+                                               util::ThreadPool* pool);
     
     /// Get default (empty) leaf value
     static FieldElement DefaultLeaf();
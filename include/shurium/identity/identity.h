@@ -15,23 +15,31 @@
 #include <shurium/core/types.h>
 #include <shurium/crypto/field.h>
 #include <shurium/crypto/keys.h>
+#include <shurium/crypto/siphash.h>
 #include <shurium/identity/commitment.h>
+#include <shurium/identity/merkletree.h>
 #include <shurium/identity/nullifier.h>
 #include <shurium/identity/zkproof.h>
 
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace shurium {
+namespace db { class Database; }
 namespace identity {
 
+/// Default number of identity records kept in memory by IdentityManager
+static constexpr size_t DEFAULT_IDENTITY_RECORD_CACHE = 4096;
+
 // ============================================================================
 // Identity Status
 // ============================================================================
@@ -304,6 +312,10 @@ public:
         /// Require registration proof?
         bool requireRegistrationProof = false;
         
+        /// Full identity records kept in memory (the rest are read back
+        /// from the record database when asked for)
+        size_t recordCacheSize = DEFAULT_IDENTITY_RECORD_CACHE;
+        
         Config() = default;
     };
     
@@ -315,6 +327,13 @@ public:
         uint64_t revokedIdentities;
         uint64_t claimsThisEpoch;
         EpochId currentEpoch;
+        
+        /// Bytes held by the identity indexes and the record cache
+        size_t memoryUsage;
+        
+        /// Record lookups served from the cache, and from the database
+        uint64_t recordCacheHits;
+        uint64_t recordCacheMisses;
     };
     
     /// Default constructor
@@ -323,6 +342,10 @@ public:
     /// Constructor with config
     explicit IdentityManager(const Config& config);
     
+    /// Constructor keeping identity records in recordDb. The database may
+    /// be shared with other data; only the identity record prefix is used.
+    IdentityManager(const Config& config, std::unique_ptr<db::Database> recordDb);
+    
     /// Destructor
     ~IdentityManager();
     
@@ -373,6 +396,9 @@ public:
     /// Get the identity tree root
     FieldElement GetIdentityRoot() const;
     
+    /// Check a root is the current one or among the recent ones kept
+    bool IsKnownIdentityRoot(const FieldElement& root) const;
+    
     /// Generate membership proof for an identity
     std::optional<VectorCommitment::MerkleProof> 
     GetMembershipProof(const IdentityCommitment& commitment) const;
@@ -426,13 +452,53 @@ private:
     EpochId currentEpoch_{0};
     
     /// Identity tree (Merkle tree of commitments)
-    VectorCommitment identityTree_;
+    IncrementalMerkleTree identityTree_;
+    
+    /// Salted hasher for commitment hash keys
+    class CommitmentHasher {
+    public:
+        CommitmentHasher() : key_(GetHashTableSalt()) {}
+        size_t operator()(const CommitmentHash& hash) const {
+            return static_cast<size_t>(SipHash13(key_.k0, key_.k1, hash.data(), hash.size()));
+        }
+    private:
+        SipHashKey key_;
+    };
     
-    /// Map from commitment hash to identity record
-    std::map<CommitmentHash, IdentityRecord> identities_;
+    /// The fields of an identity record that change after registration or
+    /// are read on every block, kept in memory for every identity. The rest
+    /// of the record lives in recordDb_.
+    struct IdentityEntry {
+        uint64_t treeIndex;
+        uint32_t registrationHeight;
+        uint32_t lastUpdateHeight;
+        uint32_t expirationHeight;
+        uint8_t status;             // IdentityStatus
+        uint8_t verificationLevel;  // VerificationLevel
+    };
     
-    /// Map from identity ID to commitment hash
-    std::map<Hash256, CommitmentHash> idToCommitment_;
+    /// Entries in registration order, which is tree order; an identity's
+    /// position here is its slot
+    std::vector<IdentityEntry> entries_;
+    
+    /// Commitment hash of each slot
+    std::vector<CommitmentHash> commitments_;
+    
+    /// Commitment hash -> slot
+    std::unordered_map<CommitmentHash, size_t, CommitmentHasher> commitmentSlots_;
+    
+    /// Identity ID -> slot
+    std::unordered_map<Hash256, size_t, SaltedHash256Hasher> idSlots_;
+    
+    /// Full records as registered, keyed by commitment hash
+    std::unique_ptr<db::Database> recordDb_;
+    
+    /// Recently read records by slot, most recent first
+    mutable std::list<std::pair<size_t, IdentityRecord>> recordCache_;
+    mutable std::unordered_map<size_t, std::list<std::pair<size_t, IdentityRecord>>::iterator>
+        recordCacheIndex_;
+    mutable uint64_t recordCacheHits_{0};
+    mutable uint64_t recordCacheMisses_{0};
     
     /// Used nullifiers
     NullifierSet nullifierSet_;
@@ -444,10 +510,19 @@ private:
     mutable std::mutex mutex_;
     
     /// Add identity to tree
-    uint64_t AddToTree(const IdentityCommitment& commitment);
+    /// @return Tree index, or nullopt if the tree is full or cannot be written
+    std::optional<uint64_t> AddToTree(const IdentityCommitment& commitment);
     
     /// Validate registration request
     bool ValidateRegistration(const RegistrationRequest& request) const;
+    
+    /// Record in a slot: registration fields from the cache or the
+    /// database, the rest from its entry
+    /// @param remember Keep the record in the cache if it was not there
+    std::optional<IdentityRecord> LoadRecord(size_t slot, bool remember = true) const;
+    
+    /// Bytes held by the indexes and the record cache (caller holds mutex_)
+    size_t MemoryUsageLocked() const;
 };
 
 // ============================================================================
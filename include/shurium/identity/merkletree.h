@@ -0,0 +1,119 @@
+// SHURIUM - Incremental Merkle Tree
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Append-only Poseidon Merkle tree of fixed depth for the identity registry.
+// Appending a leaf hashes only its path to the root, and every node is kept
+// in a database, so the tree is never rebuilt.
+
+#ifndef SHURIUM_IDENTITY_MERKLETREE_H
+#define SHURIUM_IDENTITY_MERKLETREE_H
+
+#include <shurium/crypto/field.h>
+#include <shurium/identity/commitment.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace shurium {
+namespace db { class Database; }
+namespace identity {
+
+/// Depth of the identity tree: room for 2^32 identities
+static constexpr uint32_t IDENTITY_TREE_DEPTH = 32;
+
+/// Recent roots remembered for proof freshness checks
+static constexpr size_t IDENTITY_ROOT_HISTORY = 128;
+
+/**
+ * Append-only Merkle tree of fixed depth over Poseidon::Hash2.
+ *
+ * Unused leaves are zero, and the root of an empty subtree of each height
+ * is computed once. The frontier - the last left child on each level -
+ * lets Append() hash its path in Depth() steps without reading back. Every
+ * node written is stored, keyed by level and index, so Prove() reads one
+ * sibling per level. Proofs have the VectorCommitment::MerkleProof layout
+ * and check with VectorCommitment::VerifyProof().
+ *
+ * The last rootHistory roots are kept in a ring buffer, so a proof made
+ * against a root that later appends replaced stays acceptable for a while.
+ *
+ * Not thread-safe; the owner serializes access.
+ */
+class IncrementalMerkleTree {
+public:
+    /// Empty tree kept in an in-memory database
+    /// @throws std::invalid_argument unless 1 <= depth <= 63
+    explicit IncrementalMerkleTree(uint32_t depth = IDENTITY_TREE_DEPTH,
+                                   size_t rootHistory = IDENTITY_ROOT_HISTORY);
+
+    /// Tree stored in db, resuming from what it holds. The database may be
+    /// shared with other data; only the identity tree prefixes are touched.
+    IncrementalMerkleTree(std::unique_ptr<db::Database> db,
+                          uint32_t depth = IDENTITY_TREE_DEPTH,
+                          size_t rootHistory = IDENTITY_ROOT_HISTORY);
+
+    ~IncrementalMerkleTree();
+
+    IncrementalMerkleTree(const IncrementalMerkleTree&) = delete;
+    IncrementalMerkleTree& operator=(const IncrementalMerkleTree&) = delete;
+
+    /// Append a leaf, writing its path and the new root in one batch
+    /// @return Index of the leaf, or nullopt if the tree is full or the
+    ///         write failed (the tree is then unchanged)
+    std::optional<uint64_t> Append(const FieldElement& leaf);
+
+    /// Current root
+    const FieldElement& GetRoot() const { return root_; }
+
+    /// Number of leaves appended
+    uint64_t Size() const { return size_; }
+
+    /// Tree depth
+    uint32_t Depth() const { return depth_; }
+
+    /// Membership proof for a leaf
+    /// @return nullopt if index is out of range or a node cannot be read
+    std::optional<VectorCommitment::MerkleProof> Prove(uint64_t index) const;
+
+    /// Verify a proof against the current root
+    bool Verify(const FieldElement& leaf, const VectorCommitment::MerkleProof& proof) const {
+        return VectorCommitment::VerifyProof(root_, leaf, proof);
+    }
+
+    /// True for the current root and the roots before the last
+    /// rootHistory - 1 appends
+    bool IsKnownRoot(const FieldElement& root) const;
+
+    /// Root of an empty tree of this depth
+    FieldElement EmptyRoot() const { return zeros_[depth_]; }
+
+private:
+    uint32_t depth_;
+    uint64_t size_{0};
+    FieldElement root_;
+
+    /// Root of an empty subtree of each height, zeros_[0] being a leaf
+    std::vector<FieldElement> zeros_;
+
+    /// Last left child on each level, the sibling the next right child needs
+    std::vector<FieldElement> frontier_;
+
+    /// Recent roots; the root after n appends sits in slot n % size
+    std::vector<FieldElement> rootHistory_;
+
+    std::unique_ptr<db::Database> db_;
+
+    /// Read size, frontier and root history back from the database
+    void Load();
+
+    /// Stored node, if written
+    std::optional<FieldElement> ReadNode(uint32_t level, uint64_t index) const;
+};
+
+} // namespace identity
+} // namespace shurium
+
+#endif // SHURIUM_IDENTITY_MERKLETREE_H
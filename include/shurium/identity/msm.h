@@ -0,0 +1,45 @@
+// SHURIUM - Multi-Scalar Multiplication
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Sums of scalar * generator products, as Pedersen commitments, range proofs
+// and sigma proofs take them. Generators here are BN254 field elements, so
+// one product is a single field multiplication; the cost of a sum lies in
+// the modular reductions, which the engine batches, and in its length,
+// which it can spread over a thread pool.
+
+#ifndef SHURIUM_IDENTITY_MSM_H
+#define SHURIUM_IDENTITY_MSM_H
+
+#include <shurium/crypto/field.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace shurium {
+namespace util { class ThreadPool; }
+namespace identity {
+
+/// Terms below which a sum is not worth splitting across a pool
+static constexpr size_t MSM_MIN_TERMS_PER_TASK = 4096;
+
+/// sum of scalars[i] * points[i] for i < n
+FieldElement MultiScalarMul(const FieldElement* scalars, const FieldElement* points, size_t n);
+
+/**
+ * sum of scalars[i] * points[i] over the shorter of the two vectors. With a
+ * running pool, a sum of at least twice MSM_MIN_TERMS_PER_TASK terms is
+ * split into chunks summed in parallel.
+ */
+FieldElement MultiScalarMul(const std::vector<FieldElement>& scalars,
+                            const std::vector<FieldElement>& points,
+                            util::ThreadPool* pool = nullptr);
+
+/// a * P + b * Q with one reduction, the shape of a Pedersen commitment
+FieldElement MultiScalarMul(const FieldElement& a, const FieldElement& P,
+                            const FieldElement& b, const FieldElement& Q);
+
+} // namespace identity
+} // namespace shurium
+
+#endif // SHURIUM_IDENTITY_MSM_H
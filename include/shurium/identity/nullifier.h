@@ -28,6 +28,7 @@
 #include <vector>
 
 namespace shurium {
+namespace db { class Database; class WriteBatch; }
 namespace identity {
 
 // ============================================================================
@@ -142,11 +143,27 @@ private:
 // Nullifier Set (Database for tracking used nullifiers)
 // ============================================================================
 
+/// Bloom filter bits per nullifier an epoch's filter is sized for
+static constexpr uint64_t NULLIFIER_FILTER_BITS_PER_KEY = 16;
+
+/// Hash probes per nullifier (about 0.05% false positives when full)
+static constexpr int NULLIFIER_FILTER_HASHES = 8;
+
+/// Nullifiers the smallest epoch filter is sized for
+static constexpr uint64_t NULLIFIER_FILTER_MIN_KEYS = 1024;
+
 /**
  * A set of used nullifiers for double-spend prevention.
  * 
  * This tracks all nullifiers that have been used, organized by epoch.
  * Old epochs can be pruned to save space.
+ * 
+ * Nullifiers live in a db::Database keyed by big-endian epoch then hash, so
+ * each epoch is one contiguous key range and pruning drops whole ranges.
+ * In memory the set keeps only a count and a bloom filter per epoch; the
+ * filter answers most Contains() misses without a database read and is
+ * resized from the database as its epoch grows. A set built without a
+ * database keeps its entries in an in-memory one.
  */
 class NullifierSet {
 public:
@@ -155,7 +172,8 @@ public:
         Success,        ///< Nullifier was added successfully
         AlreadyExists,  ///< Nullifier already in set (double-spend attempt)
         InvalidEpoch,   ///< Epoch too old or too far in future
-        SetFull         ///< Set has reached capacity
+        SetFull,        ///< Set has reached capacity
+        StorageError    ///< The database write failed
     };
     
     /// Configuration for nullifier set
@@ -181,6 +199,11 @@ public:
     /// Constructor with config
     explicit NullifierSet(const Config& config);
     
+    /// Set stored in db, loading the epochs and current epoch it holds. The
+    /// database may be shared with other data; only the nullifier prefixes
+    /// are touched.
+    NullifierSet(const Config& config, std::unique_ptr<db::Database> db);
+    
     /// Destructor
     ~NullifierSet();
     
@@ -229,6 +252,9 @@ public:
     /// Clear all nullifiers
     void Clear();
     
+    /// Rebuild the counts and filters from the database
+    void Reload();
+    
     /// Serialize the entire set
     std::vector<Byte> Serialize() const;
     
@@ -243,14 +269,41 @@ private:
     Config config_;
     EpochId currentEpoch_{0};
     
-    /// Nullifiers organized by epoch
-    std::map<EpochId, std::set<NullifierHash>> epochNullifiers_;
+    /// In-memory summary of one stored epoch
+    struct EpochState {
+        uint64_t count{0};
+        /// Bloom filter over the epoch's hashes, sized for filterKeys of them
+        std::vector<uint64_t> filter;
+        uint64_t filterKeys{0};
+    };
+    
+    /// Epochs holding nullifiers
+    std::map<EpochId, EpochState> epochs_;
+    
+    /// Backing store
+    std::unique_ptr<db::Database> db_;
     
     /// Mutex for thread safety
     mutable std::unique_ptr<std::mutex> mutex_;
     
     /// Validate epoch is acceptable
     bool IsValidEpoch(EpochId epoch) const;
+    
+    /// Contains() with the mutex held
+    bool ContainsLocked(const NullifierHash& hash, EpochId epoch) const;
+    
+    /// Check nullifiers and stage them into batch, updating counts and filters
+    bool StageBatch(const std::vector<Nullifier>& nullifiers, db::WriteBatch& batch);
+    
+    /// Make room in an epoch's filter for keys nullifiers, rebuilding it from
+    /// the database at twice that size when it is too small
+    void ReserveFilter(EpochId epoch, EpochState& state, uint64_t keys);
+    
+    /// Stage deletes for the epochs before end and forget them
+    uint64_t DropEpochs(std::map<EpochId, EpochState>::iterator end, db::WriteBatch& batch);
+    
+    /// Reload() with the mutex held
+    void ReloadLocked();
 };
 
 // ============================================================================
@@ -0,0 +1,52 @@
+// SHURIUM - Identity Proof Verification Cache
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A salted, fixed-size cache of identity and UBI claim proofs that have
+// already been verified. A proof is checked when it is first received;
+// when the same proof comes back inside a block, ProofVerifier finds it
+// here and skips the verification.
+
+#ifndef SHURIUM_IDENTITY_PROOFCACHE_H
+#define SHURIUM_IDENTITY_PROOFCACHE_H
+
+#include <shurium/core/types.h>
+#include <shurium/crypto/saltedcache.h>
+
+#include <cstddef>
+
+namespace shurium {
+namespace identity {
+
+/// Default proof cache size (4 MB)
+static constexpr size_t DEFAULT_MAX_PROOF_CACHE_BYTES = 4 * 1024 * 1024;
+
+/**
+ * Cache of verified (proof, public inputs, verification key) triples.
+ *
+ * Entries are the salted SHA256 of the length-prefixed triple, so peers
+ * cannot construct colliding entries and re-registering a key under the
+ * same circuit id misses the old entries.
+ */
+class ProofCache : public SaltedCache<16> {
+public:
+    /**
+     * Create a cache using at most maxBytes for the table.
+     * The slot count is rounded down to a power of two.
+     */
+    explicit ProofCache(size_t maxBytes = DEFAULT_MAX_PROOF_CACHE_BYTES)
+        : SaltedCache(maxBytes) {}
+
+    /// Compute the salted cache entry for a proof check
+    Hash256 ComputeEntry(Span<const Byte> proof,
+                         Span<const Byte> publicInputs,
+                         Span<const Byte> verificationKey) const;
+};
+
+/// Get the process-wide proof cache shared by relay and block validation
+ProofCache& GetProofCache();
+
+} // namespace identity
+} // namespace shurium
+
+#endif // SHURIUM_IDENTITY_PROOFCACHE_H
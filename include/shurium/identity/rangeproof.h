@@ -105,10 +105,15 @@ struct RangeProof {
  * Pre-computed generators for range proofs.
  * 
  * These are computed deterministically from nothing-up-my-sleeve seeds.
+ * The sets for every bit count up to MAX_RANGE_BITS are derived together on
+ * first use and are immutable afterwards, so any number of threads may
+ * share them without locking. The n-bit set holds the first n of the
+ * MAX_RANGE_BITS vector generators.
  */
 class RangeProofGenerators {
 public:
     /// Get generators for a specific bit count
+    /// @throws std::out_of_range if numBits exceeds MAX_RANGE_BITS
     static const RangeProofGenerators& Get(size_t numBits = DEFAULT_RANGE_BITS);
     
     /// Generator g (for values)
@@ -129,6 +134,9 @@ public:
 private:
     RangeProofGenerators(size_t numBits);
     
+    /// The first numBits vector generators of full
+    RangeProofGenerators(const RangeProofGenerators& full, size_t numBits);
+    
     size_t numBits_;
     FieldElement g_;
     FieldElement h_;
@@ -185,13 +193,20 @@ public:
         const RangeProof& proof,
         const FieldElement& commitment);
     
-    /// Batch verify multiple range proofs (more efficient)
+    /// Verify several proofs with one random linear combination of their
+    /// verification equations, ending in a single multi-scalar product over
+    /// the shared generators; the challenges of the whole batch are inverted
+    /// together. A set containing an invalid proof passes with probability
+    /// about 1/p.
     /// @param proofs Vector of proofs
     /// @param commitments Vector of corresponding commitments
+    /// @param invalid If given and the check fails, receives the indices of
+    ///                the failing proofs, found by bisecting the batch
     /// @return true if all proofs are valid
     static bool BatchVerify(
         const std::vector<RangeProof>& proofs,
-        const std::vector<FieldElement>& commitments);
+        const std::vector<FieldElement>& commitments,
+        std::vector<size_t>* invalid = nullptr);
 };
 
 // ============================================================================
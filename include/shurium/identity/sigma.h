@@ -88,6 +88,16 @@ public:
         const std::vector<Byte>& context = {});
 };
 
+/**
+ * A Schnorr proof together with the statement it proves.
+ */
+struct SchnorrStatement {
+    SchnorrProof proof;
+    FieldElement generator;
+    FieldElement publicKey;
+    std::vector<Byte> context;
+};
+
 /**
  * Schnorr verifier for discrete log proofs.
  */
@@ -105,6 +115,17 @@ public:
         const FieldElement& publicKey,
         const std::vector<Byte>& context = {});
     
+    /// Verify several proofs with one random linear combination of their
+    /// equations: sum w_i*(s_i*g_i - R_i - c_i*P_i) = 0. A set containing an
+    /// invalid proof passes with probability about 1/p.
+    /// @param statements The proofs and what they prove
+    /// @param invalid If given and the check fails, receives the indices of
+    ///                the failing proofs, found by verifying each one
+    /// @return true if every proof is valid
+    static bool BatchVerify(
+        const std::vector<SchnorrStatement>& statements,
+        std::vector<size_t>* invalid = nullptr);
+    
     /// Compute the Fiat-Shamir challenge
     static FieldElement ComputeChallenge(
         const FieldElement& publicKey,
@@ -26,8 +26,14 @@
 #include <vector>
 
 namespace shurium {
+namespace util { class ThreadPool; }
 namespace identity {
 
+class ProofCache;
+
+/// Proofs below which a batch is not worth splitting across a pool
+static constexpr size_t PROOF_BATCH_MIN_PER_TASK = 8;
+
 // ============================================================================
 // Proof Types
 // ============================================================================
@@ -148,6 +154,23 @@ struct VerificationKey {
     bool IsValid() const;
 };
 
+/**
+ * A verification key with what every verification derives from it worked
+ * out once, at registration: the serialized form proof cache entries are
+ * bound to. ProofVerifier hands these out by circuit id and shares them
+ * between concurrent verifications.
+ */
+struct PreparedVerificationKey {
+    explicit PreparedVerificationKey(VerificationKey vk)
+        : key(std::move(vk)), keyBytes(key.ToBytes()) {}
+    
+    /// The key as registered
+    const VerificationKey key;
+    
+    /// key.ToBytes()
+    const std::vector<Byte> keyBytes;
+};
+
 // ============================================================================
 // Public Inputs
 // ============================================================================
@@ -350,7 +373,8 @@ public:
     /// Destructor
     ~ProofVerifier();
     
-    /// Register a verification key
+    /// Register a verification key, preparing it; replaces any key under
+    /// the same id (verifications holding the old one finish with it)
     void RegisterKey(const std::string& circuitId, const VerificationKey& key);
     
     /// Check if a key is registered
@@ -359,12 +383,31 @@ public:
     /// Get a registered key
     std::optional<VerificationKey> GetKey(const std::string& circuitId) const;
     
+    /// Get a registered key in prepared form, or nullptr
+    std::shared_ptr<const PreparedVerificationKey> GetPreparedKey(const std::string& circuitId) const;
+    
     /// Verify a proof
     /// @param proof The proof to verify
     /// @param circuitId Which circuit this proof is for
     /// @return true if proof is valid
     bool Verify(const ZKProof& proof, const std::string& circuitId) const;
     
+    /**
+     * Verify many proofs for one circuit.
+     * 
+     * The key is looked up once. With a running pool, a batch of at least
+     * twice PROOF_BATCH_MIN_PER_TASK proofs is split into chunks verified
+     * in parallel; each proof still goes through the proof cache.
+     * 
+     * @param proofs Proofs to verify
+     * @param circuitId Which circuit the proofs are for
+     * @param pool Thread pool (nullptr: verify inline)
+     * @return Whether each proof is valid, in order
+     */
+    std::vector<bool> VerifyBatch(const std::vector<const ZKProof*>& proofs,
+                                  const std::string& circuitId,
+                                  util::ThreadPool* pool = nullptr) const;
+    
     /// Verify a Groth16 proof directly
     bool VerifyGroth16(const Groth16Proof& proof,
                        const PublicInputs& inputs,
@@ -374,12 +417,27 @@ public:
     bool VerifyIdentityProof(const IdentityProof& proof,
                              const FieldElement& identityRoot) const;
     
+    /// Cache of proofs already verified, consulted before verifying and
+    /// filled on success; the process-wide GetProofCache() by default
+    /// @param cache Cache to use, or nullptr to verify every time
+    void SetCache(ProofCache* cache);
+    
+    /// Cache in use, or nullptr
+    ProofCache* GetCache() const;
+    
     /// Get singleton instance (for convenience)
     static ProofVerifier& Instance();
 
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
+    
+    /// Verify against a prepared key, through the cache
+    bool VerifyPrepared(const ZKProof& proof, const PreparedVerificationKey& prepared) const;
+    
+    /// VerifyIdentityProof without the cache
+    bool VerifyIdentityProofUncached(const IdentityProof& proof,
+                                     const FieldElement& identityRoot) const;
 };
 
 // ============================================================================
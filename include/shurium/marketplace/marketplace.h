@@ -14,6 +14,7 @@
 #include <shurium/marketplace/verifier.h>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
@@ -130,6 +131,17 @@ struct MarketplaceConfig {
     /// Max concurrent verifications
     size_t maxConcurrentVerifications{4};
     
+    /// Max solutions waiting for a verification worker
+    size_t maxQueuedVerifications{1000};
+    
+    /// Per problem type caps on concurrent verifications, so slow types
+    /// cannot take every worker
+    std::map<ProblemType, size_t> verificationTypeLimits{{ProblemType::ML_TRAINING, 2}};
+    
+    /// Problems whose estimated verification time exceeds this are refused
+    /// (ms, 0 = no limit)
+    uint64_t maxVerificationCost{60000};
+    
     /// Enable automatic problem expiry
     bool autoExpireProblems{true};
     
@@ -274,13 +286,24 @@ public:
     // Verification
     // ========================================================================
     
-    /// Manually trigger verification of a solution
+    /// Queue a solution for verification. Structural checks run here;
+    /// the full verification runs on the verifier's workers.
     bool TriggerVerification(Solution::Id solutionId);
     
     /// Get verification status
     std::optional<VerificationDetails> GetVerificationResult(
         Solution::Id solutionId) const;
     
+    /// Estimated verification time of a problem (ms), calibrated by the
+    /// times measured so far
+    uint64_t EstimateVerificationTime(const Problem& problem) const;
+    
+    /// Load measured verification times saved by an earlier run
+    bool LoadVerificationCosts(const std::string& path);
+    
+    /// Save measured verification times for the next run
+    bool SaveVerificationCosts(const std::string& path) const;
+    
     // ========================================================================
     // Mining Interface
     // ========================================================================
@@ -290,9 +313,13 @@ public:
         size_t maxCount = 10,
         Amount minReward = 0) const;
     
-    /// Get the highest reward problem
+    /// Get the best problem (highest reward per estimated compute)
     const Problem* GetHighestRewardProblem() const;
     
+    /// Pick a problem for a miner and record it: the miner's current
+    /// problem if any, else the best one nobody is working on
+    const Problem* AssignProblem(const std::string& miner);
+    
     /// Allocate a problem to a miner (prevents duplicate work)
     bool AllocateProblem(Problem::Id id, const std::string& miner);
     
@@ -381,7 +408,10 @@ public:
     /// Create a mining helper
     explicit MiningHelper(Marketplace& marketplace);
     
-    /// Get next problem to work on
+    /// Set the miner problems are assigned to
+    void SetMiner(const std::string& miner) { currentMiner_ = miner; }
+    
+    /// Get next problem to work on (assigned to the miner, if set)
     const Problem* GetNextProblem();
     
     /// Submit a solution
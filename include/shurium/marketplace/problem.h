@@ -13,8 +13,10 @@
 #include <shurium/core/serialize.h>
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -452,6 +454,85 @@ private:
     uint64_t nextId_{1};
 };
 
+// ============================================================================
+// Problem Queue
+// ============================================================================
+
+/**
+ * Open problems in the order they are handed to miners, with a deadline
+ * index and a record of which miner works on what.
+ * 
+ * Order: reward per second of estimated compute (highest first), then
+ * earliest deadline, then easiest difficulty. Selection, insertion,
+ * removal and assignment are O(log n). Not thread-safe; the owner locks.
+ */
+class ProblemQueue {
+public:
+    /// Add a problem, or re-rank it if already queued (keeps assignments)
+    void Insert(const Problem& problem);
+    
+    /// Remove a problem and its assignments
+    bool Erase(Problem::Id id);
+    
+    /// Check if a problem is queued
+    bool Contains(Problem::Id id) const { return keys_.count(id) != 0; }
+    
+    /// Number of queued problems
+    size_t Size() const { return keys_.size(); }
+    
+    /// Remove everything
+    void Clear();
+    
+    /// Best problems with at least minReward whose deadline has not
+    /// passed at time now, best first
+    std::vector<Problem::Id> Top(size_t maxCount, Amount minReward, int64_t now) const;
+    
+    /**
+     * Pick a problem for a miner and record the assignment: the miner's
+     * current problem if it has one, else the best problem nobody works
+     * on, else the best problem.
+     * @return INVALID_ID if nothing is queued
+     */
+    Problem::Id Assign(const std::string& miner, int64_t now);
+    
+    /// Record that a miner works on a problem (replacing its previous one)
+    bool Assign(Problem::Id id, const std::string& miner);
+    
+    /// Drop a miner's assignment to a problem
+    void Release(Problem::Id id, const std::string& miner);
+    
+    /// Number of miners working on a problem
+    size_t GetAssigneeCount(Problem::Id id) const;
+    
+    /// Remove problems whose deadline has passed at time, earliest first
+    std::vector<Problem::Id> PopExpired(int64_t time);
+
+private:
+    struct Key {
+        Amount reward;
+        uint64_t computeSeconds;
+        int64_t deadline;
+        uint64_t target;
+        Problem::Id id;
+        
+        bool operator<(const Key& other) const;
+        bool ExpiredAt(int64_t time) const { return deadline > 0 && time > deadline; }
+    };
+    
+    /// First key in set (best first) passing the filters
+    static const Key* FirstOpen(const std::set<Key>& keys, Amount minReward, int64_t now);
+    
+    std::map<Problem::Id, Key> keys_;
+    
+    /// Problems without / with miners working on them
+    std::set<Key> unassigned_;
+    std::set<Key> assigned_;
+    
+    std::set<std::pair<int64_t, Problem::Id>> deadlines_;
+    std::map<Problem::Id, std::set<std::string>> assignees_;
+    std::map<std::string, Problem::Id> minerProblems_;
+};
+
 // ============================================================================
 // Problem Pool
 // ============================================================================
@@ -502,12 +583,22 @@ public:
         size_t maxCount = 10,
         Amount minReward = 0) const;
     
-    /// Get highest reward problem
+    /// Get the best problem (highest reward per estimated compute)
     const Problem* GetHighestRewardProblem() const;
     
     /// Get problems by type
     std::vector<const Problem*> GetProblemsByType(ProblemType type) const;
     
+    /// Pick a problem for a miner, preferring ones nobody works on
+    /// (see ProblemQueue::Assign)
+    const Problem* AssignProblem(const std::string& miner);
+    
+    /// Drop a miner's assignment
+    void ReleaseProblem(Problem::Id id, const std::string& miner);
+    
+    /// Change a problem's reward (re-ranks it)
+    bool UpdateReward(Problem::Id id, Amount reward);
+    
     // ========================================================================
     // Maintenance
     // ========================================================================
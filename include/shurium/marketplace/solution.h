@@ -396,26 +396,42 @@ private:
 
 /**
  * Cache for recent solutions.
+ * 
+ * Solutions are spread over shards by ID, each with its own lock, so
+ * lookups on different solutions don't contend. Each shard holds an equal
+ * part of the entry and memory budgets and evicts in least recently used
+ * order, taking solutions that are settled (accepted, rejected or expired)
+ * before ones still waiting for verification.
+ * 
+ * Lookups hand out shared pointers, which stay valid after the solution
+ * is evicted.
  */
 class SolutionCache {
 public:
     /// Maximum cache size
     static constexpr size_t MAX_CACHE_SIZE = 1000;
     
+    /// Default memory budget (bytes)
+    static constexpr size_t DEFAULT_MAX_CACHE_BYTES = 64 * 1024 * 1024;
+    
+    /// Most shards used (fewer for small caches)
+    static constexpr size_t MAX_SHARDS = 16;
+    
     /// Create a solution cache
-    explicit SolutionCache(size_t maxSize = MAX_CACHE_SIZE);
+    explicit SolutionCache(size_t maxSize = MAX_CACHE_SIZE,
+                           size_t maxBytes = DEFAULT_MAX_CACHE_BYTES);
     
     /// Destructor
     ~SolutionCache();
     
-    /// Add a solution to the cache
+    /// Add a solution to the cache (replacing any with the same ID)
     void Add(Solution solution);
     
     /// Get a solution by ID
-    const Solution* Get(Solution::Id id) const;
+    std::shared_ptr<const Solution> Get(Solution::Id id) const;
     
     /// Get a solution by hash
-    const Solution* GetByHash(const Hash256& hash) const;
+    std::shared_ptr<const Solution> GetByHash(const Hash256& hash) const;
     
     /// Check if solution exists
     bool Has(Solution::Id id) const;
@@ -424,13 +440,16 @@ public:
     void Remove(Solution::Id id);
     
     /// Get solutions for a problem
-    std::vector<const Solution*> GetForProblem(Problem::Id problemId) const;
+    std::vector<std::shared_ptr<const Solution>> GetForProblem(Problem::Id problemId) const;
     
     /// Clear the cache
     void Clear();
     
     /// Get cache size
     size_t Size() const;
+    
+    /// Get estimated memory held by cached solutions (bytes)
+    size_t MemoryUsage() const;
 
 private:
     class Impl;
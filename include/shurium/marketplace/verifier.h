@@ -13,7 +13,10 @@
 #include <shurium/marketplace/solution.h>
 
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -94,6 +97,12 @@ struct VerificationDetails {
 // Verifier Interface
 // ============================================================================
 
+/// A problem and one solution to it, for batch verification
+struct VerificationItem {
+    const Problem* problem{nullptr};
+    const Solution* solution{nullptr};
+};
+
 /**
  * Interface for problem-specific verifiers.
  * 
@@ -119,6 +128,16 @@ public:
     /// Get estimated verification time (milliseconds)
     virtual uint64_t EstimateVerificationTime(
         const Problem& problem) const = 0;
+    
+    /// Verify several solutions, possibly to different problems of this
+    /// verifier's type; results are in item order. The default calls
+    /// Verify for each.
+    virtual std::vector<VerificationDetails> VerifyMany(
+        const std::vector<VerificationItem>& items);
+    
+    /// Most solutions worth passing to one VerifyMany call; 1 (the
+    /// default) means batching gains nothing over separate workers
+    virtual size_t GetBatchSize() const { return 1; }
 };
 
 // ============================================================================
@@ -127,6 +146,12 @@ public:
 
 /**
  * Verifier for hash-based proof of work problems.
+ *
+ * The problem's input data starts with the 32-byte target, and a result is
+ * judged by its result hash. A problem with {"work": "header"} in its
+ * parameters takes 80-byte candidate headers instead, judged like a block
+ * header by their double SHA-256; VerifyMany hashes the headers of a batch
+ * several at once on the multi-way SHA-256 kernels.
  */
 class HashPowVerifier : public IVerifier {
 public:
@@ -145,6 +170,17 @@ public:
     
     uint64_t EstimateVerificationTime(
         const Problem& problem) const override;
+    
+    std::vector<VerificationDetails> VerifyMany(
+        const std::vector<VerificationItem>& items) override;
+    
+    size_t GetBatchSize() const override { return MAX_BATCH; }
+    
+    /// Size of a candidate header result ({"work": "header"} problems)
+    static constexpr size_t HEADER_SIZE = 80;
+    
+    /// Solutions the verification queue hands over at once
+    static constexpr size_t MAX_BATCH = 256;
 
 private:
     class Impl;
@@ -162,6 +198,13 @@ private:
  * 1. Model weights are valid
  * 2. Training improved the model
  * 3. Validation accuracy meets threshold
+ *
+ * When the problem's verification data is a labelled evaluation set
+ * (samples, features, classes as u32, the float32 features row-major, then
+ * a u32 label per sample), the submitted weights are evaluated on it as a
+ * linear classifier: classes x features float32 weights, then one float32
+ * bias per class. The evaluation runs across a thread pool, and can be
+ * limited to a random sample of the set.
  */
 class MLTrainingVerifier : public IVerifier {
 public:
@@ -186,12 +229,23 @@ public:
     
     /// Set maximum verification time
     void SetMaxVerificationTime(uint64_t ms) { maxVerificationTime_ = ms; }
+    
+    /// Evaluate only this many randomly chosen samples (0 = the whole set).
+    /// The threshold is then relaxed by a Hoeffding margin, so an honest
+    /// model fails with probability below 1e-6 but one slightly below the
+    /// threshold may pass.
+    void SetEvaluationSampleSize(size_t samples) { evaluationSamples_ = samples; }
+    
+    /// Set evaluation worker threads (0 = one per core)
+    void SetEvaluationThreads(size_t threads) { evaluationThreads_ = threads; }
 
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
     uint32_t minAccuracy_{800000};  // 80% default
     uint64_t maxVerificationTime_{60000};  // 60s default
+    size_t evaluationSamples_{0};
+    size_t evaluationThreads_{0};
 };
 
 // ============================================================================
@@ -201,8 +255,11 @@ private:
 /**
  * Verifier for linear algebra problems.
  * 
- * Verifies matrix operations by checking results against
- * known properties and spot-checking computations.
+ * Verifies matrix products, linear solves and LU/Cholesky factorizations
+ * with randomized (Freivalds) checks: both sides are multiplied by random
+ * vectors, so checking costs O(n^2) per vector rather than the O(n^3) of
+ * the computation itself. The operation comes from the "operation" problem
+ * parameter ("multiply" when absent, "solve", "lu" or "cholesky").
  */
 class LinearAlgebraVerifier : public IVerifier {
 public:
@@ -221,10 +278,15 @@ public:
     
     uint64_t EstimateVerificationTime(
         const Problem& problem) const override;
+    
+    /// Set the largest accepted probability that a wrong result passes
+    /// the randomized check (each random vector gives a factor of 2^-16)
+    void SetSoundnessError(double error) { soundnessError_ = error; }
 
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
+    double soundnessError_{1e-18};  // Four random vectors
 };
 
 /**
@@ -290,6 +352,80 @@ private:
     std::unique_ptr<Impl> impl_;
 };
 
+// ============================================================================
+// Verification Cost Model
+// ============================================================================
+
+/// Cost model file format version
+static constexpr uint16_t VERIFICATION_COST_MODEL_VERSION = 1;
+
+/// Name of the cost model file in the data directory
+static constexpr const char* VERIFICATION_COST_MODEL_FILENAME = "verifiercost.dat";
+
+/**
+ * Measured verification times, used in place of the verifiers' static
+ * estimates once enough have been seen.
+ *
+ * Samples are grouped per problem type and per input size bucket (sizes
+ * that round to the same power of two). Each bucket keeps an exponentially
+ * decayed least-squares fit of time against input size, so recent
+ * measurements count most and sizes between samples are interpolated.
+ *
+ * File layout (integers little-endian): magic "svcm", version (u16), then a
+ * compact size count of buckets, each the problem type (u8), the size
+ * bucket (u8) and the decayed sums (weight, Σsize, Σtime, Σsize², Σsize·time)
+ * as IEEE doubles.
+ */
+class VerificationCostModel {
+public:
+    /// Weight kept by older samples each time one is added to a bucket
+    static constexpr double DECAY = 0.95;
+
+    /// Weight a bucket needs before its estimate replaces the static one
+    static constexpr double MIN_WEIGHT = 3.0;
+
+    /// Record a measured verification
+    void Record(ProblemType type, size_t inputSize, uint64_t micros);
+
+    /// Estimated verification time (ms, rounded), or nullopt while the
+    /// bucket has too few samples
+    std::optional<uint64_t> Estimate(ProblemType type, size_t inputSize) const;
+
+    /// Number of buckets with samples
+    size_t Size() const;
+
+    /// Drop every sample
+    void Clear();
+
+    /// Serialize the model
+    std::vector<Byte> Serialize() const;
+
+    /// Replace the model with serialized data (unchanged on failure)
+    bool Deserialize(const Byte* data, size_t len);
+
+    /// Write the model to a file (via a temporary file, so a crash leaves
+    /// the previous one intact)
+    bool Save(const std::string& path) const;
+
+    /// Read the model from a file
+    bool Load(const std::string& path);
+
+private:
+    struct Fit {
+        double weight{0};
+        double sumX{0};
+        double sumY{0};
+        double sumXX{0};
+        double sumXY{0};
+    };
+
+    /// (type, bucket) packed as type << 8 | bucket
+    static uint16_t Key(ProblemType type, size_t inputSize);
+
+    mutable std::mutex mutex_;
+    std::map<uint16_t, Fit> fits_;
+};
+
 // ============================================================================
 // Solution Verifier (Main Interface)
 // ============================================================================
@@ -327,30 +463,83 @@ public:
         const Problem& problem,
         const Solution& solution);
     
+    /// Verify several solutions synchronously; the items are grouped by
+    /// problem type and each group goes to its verifier's VerifyMany.
+    /// Results are in item order.
+    std::vector<VerificationDetails> VerifyMany(
+        const std::vector<VerificationItem>& items);
+    
     // ========================================================================
     // Asynchronous Verification
     // ========================================================================
     
+    /**
+     * Queue a solution for verification on the worker pool.
+     *
+     * QuickValidate runs first, in the caller's thread; solutions that fail
+     * it are never queued. Queued solutions are verified in order of problem
+     * reward (highest first), then EstimateVerificationTime (cheapest
+     * first), subject to the per-type concurrency caps. A worker takes up
+     * to its verifier's GetBatchSize of the best queued solutions of one
+     * type and verifies them with one VerifyMany call. When the queue is
+     * full the lowest-priority entry is dropped to make room, or the new
+     * solution if it ranks lowest.
+     *
+     * The callback (if any) runs exactly once with the same result as the
+     * future: in the caller's thread if the solution was not queued,
+     * otherwise on a worker thread.
+     */
+    std::future<VerificationDetails> SubmitAsync(
+        const Problem& problem,
+        Solution solution,
+        VerificationCallback callback = nullptr);
+    
     /// Submit solution for asynchronous verification
-    /// @return true if submitted successfully
+    /// @return true if the solution was queued
     bool SubmitForVerification(
         const Problem& problem,
         Solution solution,
         VerificationCallback callback);
     
-    /// Get pending verification count
+    /// Get count of queued verifications not yet started
     size_t GetPendingCount() const;
     
-    /// Cancel pending verification
+    /// Get count of verifications running on workers
+    size_t GetRunningCount() const;
+    
+    /// Cancel a queued verification (its result is an ERROR)
     bool CancelVerification(Solution::Id solutionId);
     
+    /// Cancel everything queued and wait for running verifications.
+    /// Later submissions are not queued.
+    void Shutdown();
+    
+    // ========================================================================
+    // Cost Estimation
+    // ========================================================================
+    
+    /// Estimated verification time (ms): measured by the cost model where it
+    /// has enough samples, else the type verifier's static estimate
+    uint64_t EstimateVerificationTime(const Problem& problem) const;
+    
+    /// Measured verification times (fed by every VALID or INVALID result)
+    VerificationCostModel& GetCostModel();
+    const VerificationCostModel& GetCostModel() const;
+    
     // ========================================================================
     // Configuration
     // ========================================================================
     
-    /// Set maximum concurrent verifications
+    /// Set maximum concurrent verifications (the worker pool is sized from
+    /// this on the first asynchronous submission)
     void SetMaxConcurrent(size_t max) { maxConcurrent_ = max; }
     
+    /// Set maximum queued verifications
+    void SetMaxQueued(size_t max) { maxQueued_ = max; }
+    
+    /// Cap concurrent verifications of one problem type (0 removes the cap)
+    void SetTypeConcurrency(ProblemType type, size_t max);
+    
     /// Set verification timeout (milliseconds)
     void SetTimeout(uint64_t ms) { timeout_ = ms; }
     
@@ -374,9 +563,26 @@ public:
     uint64_t GetAverageVerificationTime() const;
 
 private:
+    /// SubmitAsync, reporting whether the solution was queued
+    std::future<VerificationDetails> Enqueue(
+        const Problem& problem,
+        Solution solution,
+        VerificationCallback callback,
+        bool& queued);
+    
+    /// Start queued verifications while workers and type caps allow
+    void Dispatch();
+    
+    /// Update statistics and the cost model with results of one problem
+    /// type verified together in elapsedMicros
+    void Record(const std::vector<VerificationItem>& items,
+                const std::vector<VerificationDetails>& results,
+                uint64_t elapsedMicros);
+    
     class Impl;
     std::unique_ptr<Impl> impl_;
     size_t maxConcurrent_{4};
+    size_t maxQueued_{1000};
     uint64_t timeout_{120000};  // 2 minutes
     bool strictMode_{false};
 };
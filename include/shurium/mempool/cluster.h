@@ -0,0 +1,69 @@
+// SHURIUM - Mempool Cluster Linearization
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A cluster is a set of unconfirmed transactions connected by spends. To
+// mine or evict a cluster it is put in a linearization - an order in which
+// every parent comes before its children - and that order is split into
+// chunks, runs of transactions that are best taken together. Chunk
+// feerates never increase along a linearization.
+
+#ifndef SHURIUM_MEMPOOL_CLUSTER_H
+#define SHURIUM_MEMPOOL_CLUSTER_H
+
+#include "shurium/core/types.h"
+#include <cstdint>
+#include <vector>
+
+namespace shurium {
+
+/// One transaction of a cluster, as seen by linearization
+struct ClusterTx {
+    Amount fee{0};
+    uint64_t size{0};
+    
+    /// Positions of this transaction's parents in the cluster; every parent
+    /// precedes its children
+    std::vector<uint32_t> parents;
+};
+
+/// A run of consecutive transactions in a linearization
+struct ClusterChunk {
+    Amount fee{0};
+    uint64_t size{0};
+    uint32_t count{0};
+};
+
+/// 128-bit products for exact feerate comparison (a GCC/Clang extension)
+__extension__ typedef __int128 FeeSizeProduct;
+
+/// Exact fee/size comparison: true if feeA/sizeA > feeB/sizeB
+inline bool HigherFeerate(Amount feeA, uint64_t sizeA, Amount feeB, uint64_t sizeB) {
+    return static_cast<FeeSizeProduct>(feeA) * sizeB > static_cast<FeeSizeProduct>(feeB) * sizeA;
+}
+
+inline bool HigherFeerate(const ClusterChunk& a, const ClusterChunk& b) {
+    return HigherFeerate(a.fee, a.size, b.fee, b.size);
+}
+
+/**
+ * Linearize a cluster by repeatedly taking the remaining transaction whose
+ * not-yet-taken ancestors have the highest combined feerate, together with
+ * those ancestors. This is optimal for chains and for parents bumped by
+ * their children (CPFP), though not for every cluster shape.
+ *
+ * @param txs The cluster, listed in any topological order
+ * @return Positions into txs, in linearization order
+ */
+std::vector<uint32_t> LinearizeCluster(const std::vector<ClusterTx>& txs);
+
+/**
+ * Split a linearization into chunks: each transaction joins the chunk
+ * before it while it would raise that chunk's feerate.
+ */
+std::vector<ClusterChunk> ChunkLinearization(const std::vector<ClusterTx>& txs,
+                                             const std::vector<uint32_t>& order);
+
+} // namespace shurium
+
+#endif // SHURIUM_MEMPOOL_CLUSTER_H
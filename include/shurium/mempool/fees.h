@@ -0,0 +1,165 @@
+// SHURIUM - Fee Estimation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Estimates the feerate a transaction needs to be mined within a number of
+// blocks, from how long recent mempool transactions took to confirm.
+
+#ifndef SHURIUM_MEMPOOL_FEES_H
+#define SHURIUM_MEMPOOL_FEES_H
+
+#include "shurium/mempool/mempool.h"
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Largest confirmation target, in blocks
+static constexpr unsigned int MAX_CONFIRM_TARGET = 48;
+
+/// Weight every statistic keeps per block (half-life of about 350 blocks)
+static constexpr double FEE_ESTIMATE_DECAY = 0.998;
+
+/// Share of transactions that must confirm in time for a feerate to pass
+static constexpr double FEE_ESTIMATE_SUCCESS = 0.85;
+
+/// Transactions per block a range of buckets needs before it is judged
+static constexpr double FEE_ESTIMATE_SUFFICIENT_TXS = 0.1;
+
+/// Bucket range in base units per 1000 virtual bytes, and the ratio between
+/// the bounds of neighbouring buckets
+static constexpr Amount MIN_BUCKET_FEERATE = 1000;
+static constexpr Amount MAX_BUCKET_FEERATE = 10000000;
+static constexpr double FEE_BUCKET_SPACING = 1.05;
+
+/// Estimator file format version
+static constexpr uint16_t FEE_ESTIMATES_VERSION = 1;
+
+/// Name of the estimator file in the data directory
+static constexpr const char* FEE_ESTIMATES_FILENAME = "fee_estimates.dat";
+
+// ============================================================================
+// Fee Estimator
+// ============================================================================
+
+/// Answer of a fee estimate query
+struct FeeEstimate {
+    FeeRate feeRate;
+
+    /// Target the estimate is for (0 = not enough data)
+    unsigned int target{0};
+
+    bool IsValid() const { return target != 0; }
+};
+
+/**
+ * Feerate estimator over exponentially spaced feerate buckets.
+ *
+ * Each mempool transaction is put in the bucket of its feerate when it
+ * arrives. When a block confirms it, the blocks it waited are recorded for
+ * its bucket; a transaction that leaves the mempool unmined counts as
+ * having failed every target it outlived, and one still waiting counts
+ * against the targets it has already missed. All counts decay by
+ * FEE_ESTIMATE_DECAY per block, so recent blocks weigh most.
+ *
+ * An estimate for a target walks the buckets from the highest feerate down,
+ * merging buckets until they hold enough transactions, and returns the
+ * average feerate of the lowest range in which at least
+ * FEE_ESTIMATE_SUCCESS of the transactions confirmed within the target.
+ *
+ * Thread-safe; the mempool reports to it under its own lock.
+ */
+class FeeEstimator {
+public:
+    FeeEstimator();
+
+    /// A transaction entered the mempool while the tip was at height
+    void ProcessTransaction(const TxHash& txid, FeeRate feeRate, uint32_t height);
+
+    /// A transaction left the mempool without being mined
+    void RemoveTransaction(const TxHash& txid);
+
+    /// A block at height was connected; confirmed lists its transactions
+    /// that were in the mempool
+    void ProcessBlock(uint32_t height, const std::vector<TxHash>& confirmed);
+
+    /// Estimate for exactly this target (1 to MAX_CONFIRM_TARGET)
+    FeeEstimate EstimateFee(unsigned int target) const;
+
+    /// Estimate for the smallest target at or above this one that has enough
+    /// data. Targets beyond MAX_CONFIRM_TARGET are treated as the maximum.
+    FeeEstimate EstimateSmartFee(unsigned int target) const;
+
+    /// Height of the last block processed
+    uint32_t GetBestHeight() const;
+
+    /// Number of mempool transactions being followed
+    size_t GetTrackedCount() const;
+
+    /// Number of feerate buckets
+    size_t GetBucketCount() const { return bucketBounds.size(); }
+
+    /**
+     * Write the statistics to a file (under a temporary name, then renamed).
+     * Transactions being followed are not saved.
+     */
+    bool Save(const std::filesystem::path& path) const;
+
+    /// Replace the statistics with those saved in a file
+    bool Load(const std::filesystem::path& path);
+
+private:
+    /// A mempool transaction being followed
+    struct TrackedTx {
+        uint32_t height;
+        uint32_t bucket;
+        Amount feePerK;
+    };
+
+    /// Marks a waiting slot that holds no height
+    static constexpr uint32_t NO_HEIGHT = UINT32_MAX;
+
+    mutable std::mutex mutex;
+
+    /// Lower feerate bound of each bucket
+    std::vector<double> bucketBounds;
+
+    /// Decayed confirmations per bucket, and the sum of their feerates
+    std::vector<double> txCount;
+    std::vector<double> feeRateSum;
+
+    /// Decayed confirmations within, and exits from the mempool after, at
+    /// least a target's blocks; [target - 1][bucket]
+    std::vector<std::vector<double>> confirmedWithin;
+    std::vector<std::vector<double>> failedAfter;
+
+    /// Transactions waiting, by entry height modulo MAX_CONFIRM_TARGET for
+    /// the recent ones, and the height each slot holds; [slot][bucket]
+    std::vector<std::vector<uint32_t>> waitingByHeight;
+    std::vector<uint32_t> waitingHeights;
+    std::vector<uint32_t> waitingOld;
+
+    /// Transactions that have waited at least a target's blocks, as of the
+    /// last block; [target - 1][bucket]
+    std::vector<std::vector<uint32_t>> waitingAtLeast;
+
+    std::unordered_map<TxHash, TrackedTx, SaltedHash256Hasher> tracked;
+    uint32_t bestHeight{0};
+
+    size_t BucketIndex(FeeRate feeRate) const;
+    void Untrack(const TrackedTx& tx);
+    void MoveSlotToOld(size_t slot);
+    void UpdateWaiting();
+    FeeEstimate EstimateLocked(unsigned int target) const;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_MEMPOOL_FEES_H
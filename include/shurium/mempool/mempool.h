@@ -11,10 +11,16 @@
 #include "shurium/core/types.h"
 #include "shurium/core/transaction.h"
 #include "shurium/chain/coins.h"
+#include "shurium/crypto/siphash.h"
+#include "shurium/mempool/cluster.h"
+#include "shurium/util/poolresource.h"
+#include <atomic>
 #include <cstdint>
 #include <chrono>
 #include <map>
+#include <memory>
 #include <set>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -26,6 +32,9 @@ namespace shurium {
 
 // Forward declarations
 class Mempool;
+struct MempoolCluster;
+class CheckQueue;
+class FeeEstimator;
 
 // ============================================================================
 // Fee Rate - Fee per virtual byte
@@ -99,35 +108,55 @@ private:
     /// The transaction
     TransactionRef tx;
     
-    /// Fee paid by this transaction
+    /// Fee paid, fee after prioritisation, and the modified fees of the
+    /// entry with its ancestors and with its descendants (for CPFP)
     Amount nFee;
+    mutable Amount nModifiedFee;
+    mutable Amount nModFeesWithAncestors;
+    mutable Amount nModFeesWithDescendants;
     
-    /// Transaction size (virtual bytes)
-    size_t nTxSize;
+    /// Fee rate (cached)
+    FeeRate feeRate;
     
     /// Time when transaction entered mempool
     int64_t nTime;
     
+    /// Last graph walk that reached this entry (see Mempool::visitEpoch)
+    mutable uint64_t visitEpoch{0};
+    
+    /// Cluster this entry belongs to, owned by Mempool::clusters
+    mutable MempoolCluster* cluster{nullptr};
+    
+    // In-mempool transactions this one spends from and that spend from it,
+    // each listed once. Entries are owned by Mempool::mapTx, whose nodes do
+    // not move, so the links stay valid until the entry is removed.
+    mutable std::vector<const MempoolEntry*> parents;
+    mutable std::vector<const MempoolEntry*> children;
+    
+    // Sizes and counts fit 32 bits: the ancestor and cluster limits keep
+    // them far below 4 GB
+    
+    /// Transaction size (virtual bytes)
+    uint32_t nTxSize;
+    
+    /// Heap memory held by the transaction (see DynamicMemoryUsage)
+    uint32_t nTxUsage;
+    
     /// Chain height when entering mempool
     uint32_t entryHeight;
     
-    /// Whether this transaction spends a coinbase
-    bool spendsCoinbase;
+    mutable uint32_t nCountWithAncestors;
+    mutable uint32_t nSizeWithAncestors;
+    mutable uint32_t nCountWithDescendants;
+    mutable uint32_t nSizeWithDescendants;
     
-    /// Modified fee (for fee bumping)
-    mutable Amount nModifiedFee;
+    /// Position in the cluster while it is being linearized
+    mutable uint32_t clusterPosition{0};
     
-    /// Fee rate (cached)
-    FeeRate feeRate;
-    
-    // Ancestor/descendant tracking for CPFP (Child Pays For Parent)
-    mutable uint64_t nCountWithAncestors;
-    mutable uint64_t nSizeWithAncestors;
-    mutable Amount nModFeesWithAncestors;
+    /// Whether this transaction spends a coinbase
+    bool spendsCoinbase;
     
-    mutable uint64_t nCountWithDescendants;
-    mutable uint64_t nSizeWithDescendants;
-    mutable Amount nModFeesWithDescendants;
+    friend class Mempool;
     
 public:
     /// Construct a mempool entry
@@ -162,12 +191,23 @@ public:
     uint64_t GetSizeWithDescendants() const { return nSizeWithDescendants; }
     Amount GetModFeesWithDescendants() const { return nModFeesWithDescendants; }
     
+    // Links to in-mempool parents and children
+    const std::vector<const MempoolEntry*>& GetParents() const { return parents; }
+    const std::vector<const MempoolEntry*>& GetChildren() const { return children; }
+    
+    /// Cluster this entry belongs to
+    const MempoolCluster* GetCluster() const { return cluster; }
+    
     // Modifiers (for mempool management)
     void UpdateModifiedFee(Amount fee) const { nModifiedFee = fee; }
     void UpdateAncestorState(int64_t countDelta, int64_t sizeDelta, Amount feeDelta) const;
     void UpdateDescendantState(int64_t countDelta, int64_t sizeDelta, Amount feeDelta) const;
     
-    /// Get memory usage estimate
+    /**
+     * Heap memory the entry holds outside its map node: the shared
+     * transaction with its inputs, outputs and scripts, and the link
+     * vectors. Counts malloc's rounding and headers.
+     */
     size_t DynamicMemoryUsage() const;
 };
 
@@ -213,6 +253,41 @@ struct CompareMempoolEntryByEntryTime {
     }
 };
 
+// ============================================================================
+// Mempool Cluster - Connected transactions, linearized
+// ============================================================================
+
+/**
+ * A connected set of mempool transactions: anything spending from or spent
+ * by a member is a member. The members are kept in linearization order and
+ * grouped into chunks of non-increasing feerate, so the best chunk is mined
+ * first and the last chunk is the cluster's first to be evicted.
+ */
+struct MempoolCluster {
+    uint64_t id{0};
+    
+    /// Members in linearization order
+    std::vector<const MempoolEntry*> txs;
+    
+    /// Chunks of txs, in order
+    std::vector<ClusterChunk> chunks;
+    
+    /// Members were removed and the cluster awaits relinearization
+    bool dirty{false};
+    
+    /// The lowest-feerate chunk
+    const ClusterChunk& WorstChunk() const { return chunks.back(); }
+};
+
+/// Order clusters by their worst chunk, lowest feerate first (for eviction)
+struct CompareClusterByWorstChunk {
+    bool operator()(const MempoolCluster* a, const MempoolCluster* b) const {
+        if (HigherFeerate(b->WorstChunk(), a->WorstChunk())) return true;
+        if (HigherFeerate(a->WorstChunk(), b->WorstChunk())) return false;
+        return a->id < b->id;
+    }
+};
+
 // ============================================================================
 // Mempool Removal Reason
 // ============================================================================
@@ -237,7 +312,7 @@ std::string RemovalReasonToString(MempoolRemovalReason reason);
  * Mempool size and policy limits.
  */
 struct MempoolLimits {
-    /// Maximum mempool size in bytes
+    /// Maximum mempool memory use in bytes (see Mempool::DynamicMemoryUsage)
     size_t maxSize = 300 * 1000 * 1000;  // 300 MB default
     
     /// Maximum transaction age in seconds
@@ -255,6 +330,9 @@ struct MempoolLimits {
     /// Maximum descendant size (bytes)
     uint64_t maxDescendantSize = 101000;
     
+    /// Maximum transactions in one cluster, which bounds linearization cost
+    uint64_t maxClusterCount = 100;
+    
     /// Minimum fee rate to enter mempool
     FeeRate minFeeRate{1000};  // 1 sat/vB default
     
@@ -276,6 +354,50 @@ struct TxMempoolInfo {
     Amount fee;
     size_t vsize;
     FeeRate feeRate;
+    Amount feeDelta{0};  ///< Modified fee minus fee
+};
+
+/**
+ * A chunk of a cluster's linearization, for mining.
+ * Its transactions are in an order that can be included in a block.
+ */
+struct TxMempoolChunk {
+    std::vector<TxMempoolInfo> txs;
+    Amount fee{0};
+    size_t size{0};
+    FeeRate feeRate;
+    
+    /// Cluster the chunk belongs to; a cluster's chunks must be taken in order
+    uint64_t cluster{0};
+};
+
+/**
+ * A validated transaction for Mempool::AddPackage.
+ */
+struct MempoolPackageEntry {
+    TransactionRef tx;
+    Amount fee{0};
+    bool spendsCoinbase{false};
+    
+    /// Feerate held against the mempool minimum: the transaction's own, or
+    /// with the package descendants that pay for it
+    FeeRate feeRate;
+    
+    /// Entry time (0 = now)
+    int64_t time{0};
+};
+
+/**
+ * An immutable copy of the mempool's transaction list.
+ * Holders keep reading it while the mempool changes underneath.
+ */
+struct MempoolSnapshot {
+    /// Mempool change count the snapshot reflects
+    uint64_t sequence{0};
+    
+    std::vector<TxMempoolInfo> txs;
+    size_t totalSize{0};
+    Amount totalFees{0};
 };
 
 // ============================================================================
@@ -287,21 +409,25 @@ struct TxMempoolInfo {
  * 
  * Stores valid unconfirmed transactions that may be included in future blocks.
  * Provides efficient lookup by txid and prioritization for mining.
+ * 
+ * Queries share a reader lock and changes take it exclusively. The counters
+ * behind Size, GetTotalSize and GetTotalFees are read without locking, and
+ * GetSnapshot serves listings from a cached copy.
  */
 class Mempool {
 public:
-    struct TxHasher {
-        size_t operator()(const TxHash& hash) const {
-            size_t seed = 0;
-            for (size_t i = 0; i < 8; ++i) {
-                seed ^= static_cast<size_t>(hash[i]) << (i * 8);
-            }
-            return seed;
-        }
-    };
+    /// Salted txid hasher (see SaltedHash256Hasher)
+    using TxHasher = SaltedHash256Hasher;
+    
+    /// Pool allocator for the nodes of one mempool index (bucket arrays
+    /// fall through to the heap)
+    template <typename Value>
+    using IndexAllocator = util::PoolAllocator<Value, sizeof(Value) + sizeof(void*) * 4,
+                                               alignof(void*)>;
     
     /// Type for mempool entries indexed by txid
-    using TxMap = std::unordered_map<TxHash, MempoolEntry, TxHasher>;
+    using TxMap = std::unordered_map<TxHash, MempoolEntry, TxHasher, std::equal_to<TxHash>,
+                                     IndexAllocator<std::pair<const TxHash, MempoolEntry>>>;
     using txiter = TxMap::iterator;
     using const_txiter = TxMap::const_iterator;
     
@@ -310,43 +436,107 @@ private:
     TxMap mapTx;
     
     /// Index by outpoint (for conflict detection)
-    std::unordered_map<OutPoint, TxHash, OutPointHasher> mapNextTx;
+    std::unordered_map<OutPoint, TxHash, OutPointHasher, std::equal_to<OutPoint>,
+                       IndexAllocator<std::pair<const OutPoint, TxHash>>> mapNextTx;
+    
+    /// Connected clusters of transactions, by id
+    std::map<uint64_t, MempoolCluster, std::less<uint64_t>,
+             IndexAllocator<std::pair<const uint64_t, MempoolCluster>>> clusters;
+    
+    /// Clusters ordered by worst chunk feerate (for eviction)
+    std::set<const MempoolCluster*, CompareClusterByWorstChunk,
+             IndexAllocator<const MempoolCluster*>> clustersByWorstChunk;
     
-    /// Set of transactions ordered by ancestor fee rate (for eviction)
-    std::set<std::reference_wrapper<const MempoolEntry>, CompareMempoolEntryByAncestorFee> mapAncestorFee;
+    /// Entries ordered by entry time (for expiry)
+    std::set<std::pair<int64_t, const MempoolEntry*>, std::less<std::pair<int64_t, const MempoolEntry*>>,
+             IndexAllocator<std::pair<int64_t, const MempoolEntry*>>> entriesByTime;
+    
+    /// Clusters that lost members since they were last linearized
+    std::vector<MempoolCluster*> dirtyClusters;
     
     /// Limits
     MempoolLimits limits;
     
+    /// Number of transactions
+    std::atomic<size_t> txCount{0};
+    
     /// Total size of all transactions
-    size_t totalTxSize{0};
+    std::atomic<size_t> totalTxSize{0};
+    
+    /// Sum of the entries' DynamicMemoryUsage
+    size_t cachedInnerUsage{0};
     
     /// Total fees
-    Amount totalFees{0};
+    std::atomic<Amount> totalFees{0};
     
-    /// Sequence number for ordering (reserved for future use)
-    [[maybe_unused]] uint64_t nSequence{0};
+    /// Bumped on every change to the transaction set
+    std::atomic<uint64_t> nChangeSequence{0};
     
-    /// Mutex for thread safety
-    mutable std::mutex cs;
+    /// Latest snapshot, read and replaced with the shared_ptr atomics
+    mutable std::shared_ptr<const MempoolSnapshot> snapshot;
+    
+    /// Sequence number for cluster ids
+    uint64_t nSequence{0};
+    
+    /// Reader/writer lock for thread safety
+    mutable std::shared_mutex cs;
     
     /// Notification callback for transaction removal
     std::function<void(const TransactionRef&, MempoolRemovalReason)> notifyRemoved;
     
+    /// Notification callback for transaction arrival
+    std::function<void(const TransactionRef&)> notifyAdded;
+    
+    /// Fee estimator told of arrivals, removals and confirmations (not owned)
+    FeeEstimator* feeEstimator{nullptr};
+    
+    /// Bumped by every graph walk; an entry whose visitEpoch matches has
+    /// been reached by the current walk
+    mutable uint64_t visitEpoch{0};
+    
+    /// Scratch space of graph walks, kept so walks reuse its capacity
+    mutable std::vector<const MempoolEntry*> visitStack;
+    
+    /// Transactions collected for a removal or replacement
+    mutable std::vector<const MempoolEntry*> stagedEntries;
+    
     // Internal helpers
-    void UpdateAncestorsOf(txiter it, bool add);
-    void UpdateDescendantsOf(txiter it, bool add);
+    bool AddTxLocked(const TransactionRef& tx, Amount fee, uint32_t height,
+                     bool spendsCoinbase, FeeRate feeRate, int64_t time,
+                     std::string& errString);
+    void TrackFeeLocked(const TxHash& txid);
     void RemoveUnchecked(txiter it, MempoolRemovalReason reason);
+    void RemoveStaged(std::vector<const MempoolEntry*>& staged, MempoolRemovalReason reason);
     bool CheckAncestorLimits(const MempoolEntry& entry, std::string& errString) const;
-    bool CheckDescendantLimits(txiter ancestor, std::string& errString) const;
+    bool CollectReplacements(const Transaction& tx, Amount fee, std::string& errString) const;
     void TrimToSize(size_t targetSize);
     void ExpireOld(int64_t currentTime);
+    size_t DynamicMemoryUsageLocked() const;
+    
+    /// Create an empty cluster
+    MempoolCluster& NewCluster();
+    
+    /// Put a new entry in a cluster with its parents' clusters
+    void AddToCluster(const MempoolEntry& entry);
+    
+    /// Order a cluster's members and recompute its chunks; the cluster must
+    /// be out of clustersByWorstChunk, and is put back
+    void RelinearizeCluster(MempoolCluster& cluster);
+    
+    /// Split dirty clusters into their connected parts and relinearize them
+    void UpdateDirtyClusters();
+    
+    /// Every cluster's chunks, highest feerate first (cs held)
+    std::vector<TxMempoolChunk> ChunksByFeerate() const;
     
-    /// Get ancestors of a transaction
-    std::set<TxHash> GetAncestors(const TxHash& txid) const;
+    /// Call fn once for every entry reachable from roots by following
+    /// parent links (ancestors) or child links (descendants), roots included
+    template <bool Ancestors, typename Fn>
+    void ForEachLinked(const std::vector<const MempoolEntry*>& roots, Fn&& fn) const;
     
-    /// Get descendants of a transaction
-    std::set<TxHash> GetDescendants(const TxHash& txid) const;
+    /// Replace the entries in staged by themselves plus all their
+    /// descendants, each listed once
+    void StageWithDescendants(std::vector<const MempoolEntry*>& staged) const;
     
 public:
     Mempool();
@@ -363,22 +553,34 @@ public:
     
     /// Set limits
     void SetLimits(const MempoolLimits& limitsIn) {
-        std::lock_guard<std::mutex> lock(cs);
+        std::unique_lock<std::shared_mutex> lock(cs);
         limits = limitsIn;
     }
     
     /// Get limits
     MempoolLimits GetLimits() const {
-        std::lock_guard<std::mutex> lock(cs);
+        std::shared_lock<std::shared_mutex> lock(cs);
         return limits;
     }
     
     /// Set removal notification callback
     void SetNotifyRemoved(std::function<void(const TransactionRef&, MempoolRemovalReason)> callback) {
-        std::lock_guard<std::mutex> lock(cs);
+        std::unique_lock<std::shared_mutex> lock(cs);
         notifyRemoved = std::move(callback);
     }
     
+    /// Set arrival notification callback (called with the pool locked)
+    void SetNotifyAdded(std::function<void(const TransactionRef&)> callback) {
+        std::unique_lock<std::shared_mutex> lock(cs);
+        notifyAdded = std::move(callback);
+    }
+    
+    /// Set the fee estimator to report to (nullptr to stop reporting)
+    void SetFeeEstimator(FeeEstimator* estimator) {
+        std::unique_lock<std::shared_mutex> lock(cs);
+        feeEstimator = estimator;
+    }
+    
     // ========================================================================
     // Adding Transactions
     // ========================================================================
@@ -396,6 +598,18 @@ public:
     bool AddTx(const TransactionRef& tx, Amount fee, uint32_t height,
                bool spendsCoinbase, std::string& errString);
     
+    /**
+     * Add validated transactions under a single lock, parents before
+     * children. A transaction spending one that was not added is refused,
+     * and the size limit is enforced once, after the whole package.
+     * 
+     * @param package Transactions in dependency order
+     * @param height Current chain height
+     * @return One error per transaction, empty where it was added
+     */
+    std::vector<std::string> AddPackage(const std::vector<MempoolPackageEntry>& package,
+                                        uint32_t height);
+    
     /**
      * Check if a transaction can be added (without actually adding).
      */
@@ -416,9 +630,10 @@ public:
     void RemoveConflicts(const Transaction& tx);
     
     /**
-     * Remove transactions confirmed in a block.
+     * Remove transactions confirmed in the block at height, and report the
+     * ones that were in the mempool to the fee estimator.
      */
-    void RemoveForBlock(const std::vector<TransactionRef>& vtx);
+    void RemoveForBlock(const std::vector<TransactionRef>& vtx, uint32_t height);
     
     /**
      * Clear all transactions.
@@ -465,26 +680,34 @@ public:
     
     /// Number of transactions in mempool
     size_t Size() const {
-        std::lock_guard<std::mutex> lock(cs);
-        return mapTx.size();
+        return txCount.load(std::memory_order_relaxed);
     }
     
     /// Total size of transactions in bytes
     size_t GetTotalSize() const {
-        std::lock_guard<std::mutex> lock(cs);
-        return totalTxSize;
+        return totalTxSize.load(std::memory_order_relaxed);
     }
     
+    /**
+     * Memory the mempool uses: the entries' heap data plus a node and its
+     * allocator rounding per entry in every index, and the bucket arrays.
+     * This is what MempoolLimits::maxSize caps.
+     */
+    size_t DynamicMemoryUsage() const;
+    
     /// Total fees in mempool
     Amount GetTotalFees() const {
-        std::lock_guard<std::mutex> lock(cs);
-        return totalFees;
+        return totalFees.load(std::memory_order_relaxed);
+    }
+    
+    /// Count bumped by every change to the transaction set
+    uint64_t GetChangeSequence() const {
+        return nChangeSequence.load();
     }
     
     /// Check if mempool is empty
     bool IsEmpty() const {
-        std::lock_guard<std::mutex> lock(cs);
-        return mapTx.empty();
+        return Size() == 0;
     }
     
     /// Get minimum fee rate to enter mempool
@@ -504,11 +727,24 @@ public:
     std::vector<TransactionRef> GetTransactionsForBlock(
         size_t maxSize, FeeRate minFeeRate) const;
     
+    /**
+     * Get every cluster's chunks, highest feerate first.
+     * Taking chunks in this order always includes parents before children.
+     */
+    std::vector<TxMempoolChunk> GetChunksForMining() const;
+    
     /**
      * Get info about all transactions (for RPC).
      */
     std::vector<TxMempoolInfo> GetAllTxInfo() const;
     
+    /**
+     * Get an immutable snapshot of all transactions.
+     * While the mempool is unchanged this returns the cached snapshot
+     * without locking; after a change the next caller rebuilds it.
+     */
+    std::shared_ptr<const MempoolSnapshot> GetSnapshot() const;
+    
     // ========================================================================
     // Maintenance
     // ========================================================================
@@ -602,6 +838,22 @@ struct MempoolAcceptResult {
     bool IsValid() const { return result == ResultType::VALID; }
 };
 
+/// Maximum number of transactions validated as one package
+static constexpr size_t MAX_PACKAGE_COUNT = 25;
+
+/**
+ * Result of AcceptPackage.
+ */
+struct PackageAcceptResult {
+    /// One result per transaction, in the order they were passed
+    std::vector<MempoolAcceptResult> results;
+    
+    /// Number of transactions accepted
+    size_t accepted{0};
+    
+    bool AllValid() const { return accepted == results.size(); }
+};
+
 /**
  * Accept a transaction into the mempool.
  * 
@@ -626,6 +878,34 @@ MempoolAcceptResult AcceptToMempool(
     int32_t chainHeight,
     bool bypassLimits = false);
 
+/**
+ * Accept several transactions into the mempool together.
+ * 
+ * Runs the AcceptToMempool checks on every transaction. The package may
+ * contain parents and children in any order and is validated parents
+ * first; a child is rejected along with a rejected parent. Each input's
+ * coin is looked up once, all scripts are verified in one batch on the
+ * check queue, and the accepted transactions enter the mempool under a
+ * single lock.
+ * 
+ * A transaction below the minimum fee rate is still accepted when it and
+ * its descendants in the package together meet it (child pays for parent).
+ * 
+ * @param package Up to MAX_PACKAGE_COUNT transactions
+ * @param checkQueue Workers for script verification (null = inline)
+ * @param entryTimes Entry time of each transaction, when reloading saved
+ *                   transactions (empty = now)
+ * @return Per-transaction results
+ */
+PackageAcceptResult AcceptPackage(
+    const std::vector<TransactionRef>& package,
+    Mempool& mempool,
+    CoinsView& coins,
+    int32_t chainHeight,
+    CheckQueue* checkQueue = nullptr,
+    bool bypassLimits = false,
+    const std::vector<int64_t>& entryTimes = {});
+
 } // namespace shurium
 
 #endif // SHURIUM_MEMPOOL_MEMPOOL_H
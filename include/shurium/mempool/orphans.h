@@ -0,0 +1,140 @@
+// SHURIUM - Orphan Transaction Pool
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Holds relayed transactions whose parents have not arrived yet, so they
+// can be accepted as soon as the parents are, instead of being fetched
+// again from every peer that announces them.
+
+#ifndef SHURIUM_MEMPOOL_ORPHANS_H
+#define SHURIUM_MEMPOOL_ORPHANS_H
+
+#include "shurium/chain/coins.h"
+#include "shurium/core/transaction.h"
+#include "shurium/crypto/siphash.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Most orphans kept at once
+static constexpr size_t DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
+
+/// Most orphans kept from any one peer
+static constexpr size_t DEFAULT_MAX_ORPHANS_PER_PEER = 25;
+
+/// Largest orphan kept, in bytes; with the count limits this bounds the
+/// pool's memory to about 10 MB
+static constexpr size_t MAX_ORPHAN_TX_SIZE = 100000;
+
+/// Seconds an orphan is kept before it expires
+static constexpr int64_t ORPHAN_EXPIRE_TIME = 20 * 60;
+
+// ============================================================================
+// Orphan Pool
+// ============================================================================
+
+/**
+ * Transactions that spend outputs of transactions we do not have.
+ *
+ * Orphans are indexed by txid and by every outpoint they spend, so the
+ * children waiting on a transaction are found from its outputs. When the
+ * pool is full a random orphan is evicted, which a peer flooding it cannot
+ * steer; a peer over its own limit loses its oldest orphan instead.
+ *
+ * Thread-safe.
+ */
+class OrphanPool {
+public:
+    using PeerId = int64_t;
+
+    /// An orphan and the peer it came from
+    struct Orphan {
+        TransactionRef tx;
+        PeerId fromPeer;
+    };
+
+    explicit OrphanPool(size_t maxOrphans = DEFAULT_MAX_ORPHAN_TRANSACTIONS,
+                        size_t maxPerPeer = DEFAULT_MAX_ORPHANS_PER_PEER);
+
+    /**
+     * Keep a transaction until its parents arrive. Expires old orphans and
+     * evicts others to stay within the limits.
+     *
+     * @return false if it is already kept or too large
+     */
+    bool AddTx(const TransactionRef& tx, PeerId fromPeer, int64_t now);
+
+    /// True if an orphan with this txid is kept
+    bool HaveTx(const TxHash& txid) const;
+
+    /// Drop one orphan (true if it was kept)
+    bool EraseTx(const TxHash& txid);
+
+    /// Drop every orphan from a peer; returns how many
+    size_t EraseForPeer(PeerId peer);
+
+    /// Drop the orphans a block confirmed or double-spent; returns how many
+    size_t EraseForBlock(const std::vector<TransactionRef>& vtx);
+
+    /// Drop orphans older than ORPHAN_EXPIRE_TIME; returns how many
+    size_t EraseExpired(int64_t now);
+
+    /**
+     * Take out the orphans that spend an output of this transaction, in the
+     * order they arrived, for another attempt at acceptance.
+     */
+    std::vector<Orphan> TakeChildren(const Transaction& parent);
+
+    /// Number of orphans kept
+    size_t Size() const;
+
+    /// Number of orphans kept from a peer
+    size_t CountForPeer(PeerId peer) const;
+
+private:
+    struct Entry {
+        TransactionRef tx;
+        PeerId fromPeer;
+        int64_t expireTime;
+        uint64_t sequence;
+
+        /// Position in randomOrder
+        size_t listPos;
+    };
+
+    using EntryMap = std::unordered_map<TxHash, Entry, SaltedHash256Hasher>;
+
+    mutable std::mutex mutex;
+    const size_t maxOrphans;
+    const size_t maxPerPeer;
+
+    EntryMap orphans;
+
+    /// Spent outpoint to the orphans spending it
+    std::unordered_map<OutPoint, std::set<TxHash>, OutPointHasher> byPrevout;
+
+    /// Each peer's orphans, oldest first (by arrival sequence)
+    std::map<PeerId, std::map<uint64_t, TxHash>> byPeer;
+
+    /// Every orphan's txid once, for picking one at random in O(1)
+    std::vector<TxHash> randomOrder;
+
+    uint64_t nextSequence{0};
+
+    void EraseLocked(EntryMap::iterator it);
+    size_t EraseExpiredLocked(int64_t now);
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_MEMPOOL_ORPHANS_H
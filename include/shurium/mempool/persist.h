@@ -0,0 +1,101 @@
+// SHURIUM - Mempool Persistence
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Saving the mempool to disk and loading it back, so a restarted node
+// keeps the transactions it had instead of waiting for peers to resend them.
+
+#ifndef SHURIUM_MEMPOOL_PERSIST_H
+#define SHURIUM_MEMPOOL_PERSIST_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace shurium {
+
+class CheckQueue;
+class CoinsView;
+class Mempool;
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Mempool file format version
+static constexpr uint16_t MEMPOOL_DUMP_VERSION = 1;
+
+/// Name of the mempool file in the data directory
+static constexpr const char* MEMPOOL_DUMP_FILENAME = "mempool.dat";
+
+/// Largest record accepted when reading (guards against bad lengths)
+static constexpr uint32_t MAX_MEMPOOL_DUMP_RECORD_BYTES = 4 * 1024 * 1024;
+
+/// Seconds between periodic mempool saves of a running node
+static constexpr int64_t DEFAULT_MEMPOOL_DUMP_INTERVAL = 15 * 60;
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+/**
+ * Outcome of saving or loading the mempool.
+ *
+ * File layout (integers little-endian):
+ * - header: magic "smpl", version (u16), record count (u64)
+ * - records: size (u32), then the serialized transaction, entry time (i64)
+ *   and fee delta (i64)
+ *
+ * Records are in mining order, so every transaction follows the in-mempool
+ * transactions it spends and the best paying ones come first.
+ */
+struct MempoolPersistResult {
+    bool success{false};
+    std::string error;
+    
+    /// Records written, or read
+    uint64_t count{0};
+    
+    /// Loading: accepted, already present, older than the age limit, and
+    /// rejected (mined, conflicted or invalid since they were saved)
+    uint64_t accepted{0};
+    uint64_t alreadyPresent{0};
+    uint64_t expired{0};
+    uint64_t failed{0};
+    
+    static MempoolPersistResult Error(const std::string& msg) {
+        MempoolPersistResult result;
+        result.error = msg;
+        return result;
+    }
+};
+
+/**
+ * Write every mempool transaction to a file.
+ *
+ * The file is written under a temporary name and renamed over the old one
+ * once complete, so a crash part-way leaves the previous file intact.
+ */
+MempoolPersistResult DumpMempool(const Mempool& mempool, const std::filesystem::path& path);
+
+/**
+ * Load a saved mempool.
+ *
+ * Transactions go through AcceptPackage in batches of MAX_PACKAGE_COUNT
+ * and keep their original entry time; those past the mempool's age limit
+ * are skipped. Fee deltas are read but not applied, as the mempool has no
+ * prioritisation to apply them to. Loading stops early, with an error,
+ * once interrupt is set.
+ *
+ * @param chainHeight Active chain height
+ * @param checkQueue Workers for script verification (null = inline)
+ */
+MempoolPersistResult LoadMempool(const std::filesystem::path& path, Mempool& mempool,
+                                 CoinsView& coins, int32_t chainHeight,
+                                 CheckQueue* checkQueue = nullptr,
+                                 const std::atomic<bool>* interrupt = nullptr);
+
+} // namespace shurium
+
+#endif // SHURIUM_MEMPOOL_PERSIST_H
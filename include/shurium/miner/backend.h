@@ -0,0 +1,100 @@
+// SHURIUM - Mining Backends
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// The nonce search behind the miner. A backend is handed the midstate of a
+// header's first 64 bytes, its 12-byte tail and the target, and reports the
+// nonces that solve it; the miner does everything else (templates, extra
+// nonce, submission). The CPU backend is always built; the OpenCL one is
+// built with -DSHURIUM_OPENCL_MINING=ON.
+
+#ifndef SHURIUM_MINER_BACKEND_H
+#define SHURIUM_MINER_BACKEND_H
+
+#include "shurium/core/types.h"
+#include "shurium/crypto/sha256.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace miner {
+
+// ============================================================================
+// Backend Interface
+// ============================================================================
+
+/**
+ * A nonce search device. Each mining thread drives its own instance, so
+ * implementations need not be thread-safe.
+ */
+class MiningBackend {
+public:
+    virtual ~MiningBackend() = default;
+
+    /// Name the backend is selected by
+    virtual const char* GetName() const = 0;
+
+    /// Nonces worth handing over per Search call. The miner looks for a new
+    /// tip and stop requests between calls, so this should take well under
+    /// a second.
+    virtual uint32_t GetBatchSize() const = 0;
+
+    /**
+     * Hash the headers with nonces firstNonce .. firstNonce + count - 1
+     * and append to candidates those that may meet target. The miner
+     * checks every candidate again, so a backend may report false
+     * positives (a GPU kernel comparing only the top word, say).
+     * @return false if the device failed
+     */
+    virtual bool Search(const SHA256Midstate& mid, const Byte* tail, const Hash256& target,
+                        uint32_t firstNonce, uint32_t count,
+                        std::vector<uint32_t>& candidates) = 0;
+};
+
+// ============================================================================
+// CPU Backend
+// ============================================================================
+
+/**
+ * Hashes on the calling thread with DoubleSHA256_80_Nonces, which runs 4,
+ * 8 or 16 nonces at a time with SSE4.1, AVX2 or AVX-512.
+ */
+class CPUMiningBackend : public MiningBackend {
+public:
+    const char* GetName() const override { return "cpu"; }
+    uint32_t GetBatchSize() const override { return 4096; }
+    bool Search(const SHA256Midstate& mid, const Byte* tail, const Hash256& target,
+                uint32_t firstNonce, uint32_t count,
+                std::vector<uint32_t>& candidates) override;
+};
+
+// ============================================================================
+// Backend Selection
+// ============================================================================
+
+/// Default backend name
+static constexpr const char* DEFAULT_MINING_BACKEND = "cpu";
+
+/// Names of the backends this build has
+std::vector<std::string> GetMiningBackendNames();
+
+/**
+ * Create a backend by name.
+ * @param error Set to the reason when nullptr is returned (unknown name,
+ *              no usable device)
+ */
+std::unique_ptr<MiningBackend> CreateMiningBackend(const std::string& name, std::string& error);
+
+#ifdef SHURIUM_OPENCL_MINING
+/// Open the first OpenCL GPU (any OpenCL device if there is none) and
+/// build the search kernel for it
+std::unique_ptr<MiningBackend> CreateOpenCLMiningBackend(std::string& error);
+#endif
+
+} // namespace miner
+} // namespace shurium
+
+#endif // SHURIUM_MINER_BACKEND_H
@@ -40,6 +40,10 @@ struct BlockTemplate {
     };
     std::vector<TxInfo> txInfo;
     
+    /// Merkle path of the coinbase (position 0), so the root can be
+    /// updated in O(log n) hashes when the coinbase changes
+    std::vector<Hash256> coinbaseMerkleBranch;
+    
     /// Total fees collected
     Amount totalFees{0};
     
@@ -147,8 +151,8 @@ private:
     /// Calculate the coinbase value (subsidy + fees)
     Amount CalculateCoinbaseValue() const;
     
-    /// Check if we can add more transactions
-    bool CanAddTransaction(const Transaction& tx, Amount fee) const;
+    /// Check if the transaction fits the block's weight and sigop limits
+    bool CanAddTransaction(const Transaction& tx) const;
     
     /// Add a transaction to the block
     void AddTransaction(const TransactionRef& tx, Amount fee, size_t sigops);
@@ -9,14 +9,17 @@
 #ifndef SHURIUM_MINER_MINER_H
 #define SHURIUM_MINER_MINER_H
 
+#include "shurium/miner/backend.h"
 #include "shurium/miner/blockassembler.h"
 #include "shurium/chain/chainstate.h"
 #include "shurium/mempool/mempool.h"
 #include "shurium/consensus/params.h"
 #include "shurium/core/types.h"
+#include "shurium/db/database.h"
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -48,6 +51,17 @@ struct MiningStats {
     /// Blocks accepted by chain
     std::atomic<uint32_t> blocksAccepted{0};
     
+    /// Templates mined on, and those given up because the tip moved
+    std::atomic<uint64_t> templatesBuilt{0};
+    std::atomic<uint64_t> templatesStale{0};
+    
+    /// Time to assemble a template
+    db::LatencyHistogram templateBuildLatency;
+    
+    /// Time from finding a block to handing it to the relay (validation
+    /// included)
+    db::LatencyHistogram blockRelayLatency;
+    
     /// Start time of mining
     int64_t startTime{0};
     
@@ -80,6 +94,9 @@ struct MinerOptions {
     
     /// Enable extra nonce in coinbase for more nonce space
     bool useExtraNonce{true};
+    
+    /// Nonce search backend (see GetMiningBackendNames())
+    std::string backend{DEFAULT_MINING_BACKEND};
 };
 
 // ============================================================================
@@ -87,11 +104,11 @@ struct MinerOptions {
 // ============================================================================
 
 /**
- * CPU miner for SHURIUM.
+ * Miner for SHURIUM.
  * 
  * Manages mining threads that:
  * 1. Get block templates from BlockAssembler
- * 2. Search for valid nonces
+ * 2. Search for valid nonces with their MiningBackend
  * 3. Submit valid blocks via ChainStateManager
  */
 class Miner {
@@ -125,7 +142,8 @@ public:
     
     /**
      * Start mining with the configured number of threads.
-     * @return true if mining started successfully
+     * @return true if mining started successfully (false also if the
+     *         backend cannot be created)
      */
     bool Start();
     
@@ -154,6 +172,11 @@ public:
      */
     void SetBlockFoundCallback(BlockFoundCallback callback);
     
+    /**
+     * Name of the configured nonce search backend.
+     */
+    const std::string& GetBackendName() const { return options_.backend; }
+    
     // ========================================================================
     // Statistics
     // ========================================================================
@@ -173,6 +196,20 @@ public:
      */
     double GetHashRate() const { return stats_.GetHashRate(); }
     
+    /**
+     * Hash rate of each mining thread since mining started.
+     */
+    std::vector<double> GetThreadHashRates() const;
+    
+    /**
+     * Blocks this miner had accepted that are no longer in the active
+     * chain, among the last MAX_TRACKED_MINED_BLOCKS.
+     */
+    uint32_t GetOrphanedBlockCount() const;
+    
+    /// Accepted blocks remembered for GetOrphanedBlockCount()
+    static constexpr size_t MAX_TRACKED_MINED_BLOCKS = 100;
+    
     /**
      * Check if hash meets target (hash <= target).
      * Made public for use by CheckProofOfWork.
@@ -184,7 +221,7 @@ private:
     void MiningThread(int threadId);
     
     /// Try to mine a single block template
-    bool TryMineBlock(BlockTemplate& tmpl, int threadId);
+    bool TryMineBlock(BlockTemplate& tmpl, int threadId, MiningBackend& backend);
     
     /// Submit a valid block
     bool SubmitBlock(Block& block);
@@ -203,6 +240,9 @@ private:
     std::atomic<bool> shouldStop_{false};
     std::vector<std::thread> threads_;
     
+    /// One backend per thread, created by Start()
+    std::vector<std::unique_ptr<MiningBackend>> backends_;
+    
     // Synchronization
     mutable std::mutex mutex_;
     std::condition_variable cv_;
@@ -213,6 +253,12 @@ private:
     // Statistics
     MiningStats stats_;
     
+    /// Hashes per thread; sized before the threads start
+    std::deque<std::atomic<uint64_t>> threadHashes_;
+    
+    /// Most recent accepted blocks, oldest first
+    std::deque<BlockHash> minedBlocks_;
+    
     // Callbacks
     BlockFoundCallback blockFoundCallback_;
 };
@@ -0,0 +1,113 @@
+// SHURIUM - Block Template Cache
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Keeps the current candidate block for getblocktemplate, so repeated
+// calls do not walk the mempool, and lets pool software long-poll for a
+// template worth switching to (BIP22 longpollid).
+
+#ifndef SHURIUM_MINER_TEMPLATECACHE_H
+#define SHURIUM_MINER_TEMPLATECACHE_H
+
+#include "shurium/miner/blockassembler.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace shurium {
+namespace miner {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Seconds a template outlives a mempool change before it is rebuilt
+static constexpr int64_t TEMPLATE_REFRESH_INTERVAL = 5;
+
+/// Longest a long poll waits before returning the current template, in seconds
+static constexpr int64_t LONGPOLL_TIMEOUT = 60;
+
+/// Fee gain that ends a long poll: the larger of this and 1% of the fees
+/// of the template being polled on
+static constexpr Amount LONGPOLL_MIN_FEE_GAIN = 1000;
+static constexpr Amount LONGPOLL_FEE_GAIN_DIVISOR = 100;
+
+// ============================================================================
+// Block Template Cache
+// ============================================================================
+
+/**
+ * The block template served to external miners.
+ *
+ * A template is built once and handed out shared until it goes stale: at
+ * once when the tip moves, and once the mempool has changed and the
+ * template is TEMPLATE_REFRESH_INTERVAL old, so a busy mempool costs one
+ * assembly per interval rather than one per request. Serving a fresh
+ * template only compares the tip and the mempool's change count.
+ *
+ * Thread-safe.
+ */
+class BlockTemplateCache {
+public:
+    /// params is copied; coinbaseScript pays the templates' coinbase
+    BlockTemplateCache(ChainState& chainState, Mempool& mempool,
+                       const consensus::Params& params, const Script& coinbaseScript,
+                       const BlockAssemblerOptions& options = {});
+    ~BlockTemplateCache();
+
+    BlockTemplateCache(const BlockTemplateCache&) = delete;
+    BlockTemplateCache& operator=(const BlockTemplateCache&) = delete;
+
+    /// The current template, rebuilt first if it is stale
+    std::shared_ptr<const BlockTemplate> Get();
+
+    /// Long poll id of a template: its previous block and its fees
+    static std::string GetLongPollId(const BlockTemplate& tmpl);
+
+    /**
+     * Wait until the tip is no longer the one longPollId names, or until a
+     * template pays enough more in fees than the one it names, then return
+     * the current template. Gives up after timeoutSeconds (or on Interrupt)
+     * and returns the current template anyway.
+     */
+    std::shared_ptr<const BlockTemplate> WaitForChange(const std::string& longPollId,
+                                                       int64_t timeoutSeconds = LONGPOLL_TIMEOUT);
+
+    /// Have waiting long polls check again now (on a new tip)
+    void Notify();
+
+    /// Make waiting long polls return
+    void Interrupt();
+
+    /// Number of templates assembled so far
+    uint64_t GetBuildCount() const;
+
+private:
+    ChainState& chainState;
+    Mempool& mempool;
+    const consensus::Params params;
+    const Script coinbaseScript;
+    const BlockAssemblerOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+
+    std::shared_ptr<const BlockTemplate> current;
+
+    /// Mempool change count the current template was built at, and when
+    uint64_t builtSequence{0};
+    int64_t builtTime{0};
+
+    uint64_t buildCount{0};
+    bool interrupted{false};
+
+    std::shared_ptr<const BlockTemplate> GetLocked();
+    bool IsStaleLocked(int64_t now);
+};
+
+} // namespace miner
+} // namespace shurium
+
+#endif // SHURIUM_MINER_TEMPLATECACHE_H
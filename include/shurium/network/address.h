@@ -11,6 +11,7 @@
 #include <string>
 #include <variant>
 #include <vector>
+#include <optional>
 
 namespace shurium {
 
@@ -105,6 +106,12 @@ public:
     /// Get reachability score (higher = more reachable)
     int GetReachability() const;
     
+    /// Bytes naming the block of addresses one operator can cheaply hold
+    /// many of: the /16 of IPv4 (mapped IPv6 included), the /32 of IPv6,
+    /// the first four bytes of Tor and I2P keys. Unroutable addresses all
+    /// share one group.
+    std::vector<uint8_t> GetNetGroup() const;
+    
     /// Comparison operators
     bool operator==(const NetAddress& other) const;
     bool operator!=(const NetAddress& other) const { return !(*this == other); }
@@ -236,6 +243,9 @@ enum class ServiceFlags : uint64_t {
     
     /// SHURIUM-specific: Can process UBI claims
     UBI = (1 << 18),
+    
+    /// SHURIUM-specific: Relays transactions by set reconciliation
+    TX_RECONCILIATION = (1 << 19),
 };
 
 /// Combine service flags
@@ -10,14 +10,18 @@
 
 #include <shurium/network/address.h>
 #include <shurium/core/types.h>
+#include <shurium/core/random.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <deque>
 #include <functional>
 #include <map>
 #include <mutex>
-#include <random>
+#include <optional>
 #include <set>
 #include <string>
 #include <thread>
@@ -29,6 +33,13 @@ namespace shurium {
 // Address Info
 // ============================================================================
 
+/// Bytes an address is looked up by: its network, its address bytes (zero
+/// padded to the longest, Tor v3 and I2P) and its port
+using AddressKey = std::array<uint8_t, 1 + 32 + 2>;
+
+/// The lookup key of an address, built without formatting it
+AddressKey GetAddressKey(const NetService& service);
+
 /// Extended address information for tracking
 struct AddressInfo {
     /// The network address
@@ -59,10 +70,7 @@ struct AddressInfo {
     int nRandomPos{-1};
     
     /// Get the address key for lookups
-    std::string GetKey() const {
-        // PeerAddress inherits from NetService which inherits from NetAddress
-        return static_cast<const NetAddress&>(addr).ToString() + ":" + std::to_string(addr.GetPort());
-    }
+    AddressKey GetKey() const { return GetAddressKey(addr); }
     
     /// Check if address is considered "terrible" (many failed attempts)
     bool IsTerrible(int64_t now) const {
@@ -123,6 +131,30 @@ const std::vector<DNSSeed> TESTNET_SEEDS = {
 /// Default DNS seeds for regtest (none - manual connections only)
 const std::vector<DNSSeed> REGTEST_SEEDS = {};
 
+// ============================================================================
+// Peers File
+// ============================================================================
+
+/// Format written by Save. Version 1 (variable-length entries) still loads.
+static constexpr uint32_t PEERS_FILE_VERSION = 2;
+
+/// Bytes per address record in a version 2 file
+static constexpr size_t PEERS_RECORD_SIZE = 128;
+
+/// Seconds between background saves of the address table
+static constexpr int64_t DEFAULT_PEERS_SAVE_INTERVAL = 15 * 60;
+
+// ============================================================================
+// Seed Resolution
+// ============================================================================
+
+/// Milliseconds a seed lookup may take before it is given up on
+static constexpr int64_t DEFAULT_SEED_QUERY_TIMEOUT_MS = 5000;
+
+/// Seconds a seed's answer is reused instead of asking again. The system
+/// resolver does not report record TTLs, so this stands in for them.
+static constexpr int64_t DEFAULT_SEED_CACHE_TTL = 30 * 60;
+
 // ============================================================================
 // Address Manager
 // ============================================================================
@@ -158,9 +190,21 @@ public:
     /// Load addresses from persistent storage
     bool Load(const std::string& path);
     
-    /// Save addresses to persistent storage
+    /**
+     * Save addresses to persistent storage. The table is copied out as
+     * fixed-size records under the lock; checksumming and writing happen
+     * outside it, to a temporary file that is renamed over path.
+     */
     bool Save(const std::string& path) const;
     
+    /// Save to path every interval seconds, from a background thread, if
+    /// anything changed since the last save. Stop() ends it.
+    void StartPeriodicSave(const std::string& path,
+                           int64_t intervalSeconds = DEFAULT_PEERS_SAVE_INTERVAL);
+    
+    /// Whether the table changed since it was last loaded or saved
+    bool HasUnsavedChanges() const { return changes_.load() != savedChanges_.load(); }
+    
     // ========================================================================
     // Address Management
     // ========================================================================
@@ -175,7 +219,8 @@ public:
     bool Add(const PeerAddress& addr, const NetService& source, int64_t penalty = 0);
     
     /**
-     * Add multiple addresses.
+     * Add multiple addresses, such as an addr message's, taking the lock
+     * once for all of them.
      * @param addrs Addresses to add
      * @param source Who told us about these addresses
      * @param penalty Time penalty
@@ -241,11 +286,24 @@ public:
     void ResolveSeeds(ResolveCallback callback = nullptr);
     
     /**
-     * Resolve DNS seeds synchronously.
+     * Resolve DNS seeds synchronously. All seeds are looked up at once,
+     * and each one's addresses are added to the pool as soon as it
+     * answers. Seeds that have not answered within the query timeout are
+     * given up on; answers still fresh in the cache are used without a
+     * lookup.
      * @return Vector of resolved addresses
      */
     std::vector<NetService> ResolveSeedsSync();
     
+    /// Time allowed for each seed lookup
+    void SetSeedTimeout(std::chrono::milliseconds timeout) { seedTimeout_ = timeout; }
+    
+    /// Seconds seed answers are cached for (0 = no caching)
+    void SetSeedCacheTTL(int64_t seconds) { seedCacheTtl_ = seconds; }
+    
+    /// A seed's cached answer, if still fresh
+    std::optional<std::vector<NetService>> GetCachedSeed(const std::string& host) const;
+    
     // ========================================================================
     // Statistics
     // ========================================================================
@@ -270,29 +328,63 @@ private:
     AddressInfo MakeInfo(const PeerAddress& addr, const NetService& source, int64_t penalty);
     
     /// Find address info by key
-    AddressInfo* Find(const std::string& key);
-    const AddressInfo* Find(const std::string& key) const;
+    AddressInfo* Find(const AddressKey& key);
+    const AddressInfo* Find(const AddressKey& key) const;
     
-    /// DNS resolution helper
-    std::vector<NetService> ResolveHost(const std::string& host) const;
+    /// Add one valid address under its key (mutex_ held)
+    bool AddLocked(const PeerAddress& addr, const AddressKey& key, const NetService& source,
+                   int64_t penalty);
+    
+    /// DNS resolution helper; blocks for as long as the resolver does
+    static std::vector<NetService> ResolveHost(const std::string& host, uint16_t defaultPort);
+    
+    /// Take in a seed's answer: cache it and add it to the pool
+    void AddSeedResults(const std::string& host, const std::vector<NetService>& addresses);
+    
+    /// Version 1 entries, after the header (mutex_ held)
+    bool LoadLegacyEntries(DataStream& stream);
+    
+    /// Version 2 records starting at offset (mutex_ held)
+    bool LoadRecords(const std::vector<Byte>& data, size_t offset);
+    
+    /// Background save thread body
+    void SaveLoop(std::string path, int64_t intervalSeconds);
     
     // Configuration
     std::string networkId_;
     std::vector<DNSSeed> seeds_;
     uint16_t defaultPort_{8333};
+    std::chrono::milliseconds seedTimeout_{DEFAULT_SEED_QUERY_TIMEOUT_MS};
+    int64_t seedCacheTtl_{DEFAULT_SEED_CACHE_TTL};
     
     // Address storage
     mutable std::mutex mutex_;
-    std::map<std::string, AddressInfo> mapInfo_;
-    std::vector<std::string> vNew_;   // Addresses never tried
-    std::vector<std::string> vTried_; // Successfully connected addresses
+    std::map<AddressKey, AddressInfo> mapInfo_;
+    std::vector<AddressKey> vNew_;   // Addresses never tried
+    std::vector<AddressKey> vTried_; // Successfully connected addresses
+    
+    // Random number generator (bucket and sample choices; guarded by mutex_)
+    mutable FastRandomContext rng_;
     
-    // Random number generator
-    mutable std::mt19937 rng_;
+    // Seed answers and when they expire
+    struct SeedCacheEntry {
+        std::vector<NetService> addresses;
+        int64_t expires{0};
+    };
+    std::map<std::string, SeedCacheEntry> seedCache_;
     
     // DNS resolution thread
     std::thread resolveThread_;
     std::atomic<bool> running_{false};
+    
+    // Persistence
+    std::atomic<uint64_t> changes_{0};               // Bumped by every update
+    mutable std::atomic<uint64_t> savedChanges_{0};  // changes_ when last saved
+    mutable std::mutex fileMutex_;                   // One writer of the file
+    std::thread saveThread_;
+    std::mutex saveMutex_;
+    std::condition_variable saveCv_;
+    bool saveStop_{false};
 };
 
 // ============================================================================
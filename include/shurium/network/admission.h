@@ -0,0 +1,169 @@
+// SHURIUM - Inbound Connection Admission
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Cheap decisions about inbound connections, made before a peer is built
+// for one: a connect rate per netgroup, a bounded table of connections
+// still in their handshake with a deadline each, and, once the inbound
+// slots are full, which established peer makes room for a newcomer. The
+// eviction rankings are updated as peers' metrics change, so choosing a
+// peer costs O(log n) instead of a sort of every peer under flood.
+
+#ifndef SHURIUM_NETWORK_ADMISSION_H
+#define SHURIUM_NETWORK_ADMISSION_H
+
+#include <shurium/network/address.h>
+#include <shurium/network/peer.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Options
+// ============================================================================
+
+struct AdmissionOptions {
+    /// Inbound connects a netgroup gets per minute, and how many it can
+    /// save up. Loopback connections are not limited.
+    uint32_t groupConnectsPerMinute{12};
+    uint32_t groupConnectBurst{6};
+
+    /// Inbound connections that may be in their handshake at once
+    size_t maxPending{16};
+
+    /// Time an inbound connection gets to complete its handshake (ms)
+    int handshakeTimeoutMs{5000};
+
+    /// Peers kept from eviction: one from each of this many netgroups, and
+    /// the best by ping, by recent transactions, by recent blocks and by
+    /// time connected
+    size_t protectByGroup{4};
+    size_t protectByPing{8};
+    size_t protectByTx{4};
+    size_t protectByBlock{4};
+    size_t protectByUptime{8};
+};
+
+/// What eviction ranks an established inbound peer by
+struct EvictionMetrics {
+    /// Last measured round trip, 0 if none yet
+    int64_t pingMicros{0};
+
+    /// Last time the peer gave us a block or transaction we took, 0 if never
+    int64_t lastBlockTime{0};
+    int64_t lastTxTime{0};
+};
+
+// ============================================================================
+// InboundAdmission
+// ============================================================================
+
+/**
+ * Admission state for one listener's inbound peers. Thread-safe.
+ *
+ * A peer enters pending (in its handshake) and becomes an eviction
+ * candidate with its first Update after the handshake. Netgroups are
+ * tracked by a keyed hash, so their order, which decides the peers
+ * protected for diversity, cannot be predicted by other nodes.
+ */
+class InboundAdmission {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit InboundAdmission(const AdmissionOptions& opts = AdmissionOptions{});
+
+    /// Spend one of the address's netgroup connects; false if it has none
+    /// left, or if so many netgroups are connecting that no more can be
+    /// tracked
+    bool AllowConnect(const NetAddress& addr, Clock::time_point now);
+
+    /// Whether another connection may start its handshake
+    bool HasPendingSlot() const;
+
+    /// Track a new inbound peer through its handshake
+    void AddPending(Peer::Id id, const NetAddress& addr, int64_t connectedTime,
+                    Clock::time_point now);
+
+    /// Rank a peer whose handshake completed by new metrics
+    void Update(Peer::Id id, const EvictionMetrics& metrics);
+
+    /// Forget a peer
+    void Remove(Peer::Id id);
+
+    /// Pending peers whose handshake deadline has passed; they are
+    /// forgotten, and the caller disconnects them
+    std::vector<Peer::Id> TakeExpired(Clock::time_point now);
+
+    /**
+     * Established peer to evict for a new inbound connection: the most
+     * recently connected unprotected peer of the largest netgroup.
+     * @return -1 if every peer is protected
+     */
+    Peer::Id SelectForEviction() const;
+
+    size_t GetPendingCount() const;
+    size_t GetCandidateCount() const;
+
+    /// Netgroups connecting faster than allowed are tracked up to this
+    static constexpr size_t MAX_RATE_GROUPS = 4096;
+
+private:
+    /// Rankings ordered best first: the front peers are protected
+    using Ranking = std::set<std::pair<int64_t, Peer::Id>>;
+
+    struct Entry {
+        uint64_t group{0};
+        int64_t connectedTime{0};
+        bool pending{true};
+        Clock::time_point deadline;
+        EvictionMetrics metrics;
+    };
+
+    /// Connect allowance of one netgroup
+    struct RateBucket {
+        double tokens{0};
+        Clock::time_point updated;
+    };
+
+    uint64_t GroupKey(const NetAddress& addr) const;
+
+    /// Refill a bucket to now, returning its tokens
+    double Refill(RateBucket& bucket, Clock::time_point now) const;
+
+    /// Add or take out a candidate's places in the rankings (mutex_ held)
+    void RankLocked(Peer::Id id, const Entry& entry);
+    void UnrankLocked(Peer::Id id, const Entry& entry);
+
+    AdmissionOptions options_;
+    uint64_t k0_;
+    uint64_t k1_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Peer::Id, Entry> entries_;
+    std::set<std::pair<Clock::time_point, Peer::Id>> deadlines_;
+    size_t pending_{0};
+
+    Ranking byPing_;    // Fastest first; unmeasured peers are not ranked
+    Ranking byBlock_;   // Most recent first (negated times)
+    Ranking byTx_;      // Most recent first (negated times)
+    Ranking byUptime_;  // Longest connected first
+
+    /// Candidates by netgroup key, each group's longest connected first
+    std::map<uint64_t, Ranking> groups_;
+    std::set<std::pair<size_t, uint64_t>> groupsBySize_;
+
+    std::unordered_map<uint64_t, RateBucket> rates_;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_NETWORK_ADMISSION_H
@@ -0,0 +1,293 @@
+// SHURIUM - Compact Blocks
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// BIP152-style compact block relay. A compact block carries the header, a
+// 6-byte short id per transaction and the few transactions the sender
+// expects us to lack (always the coinbase). The receiver rebuilds the block
+// from its mempool and asks for whatever is left with getblocktxn.
+
+#ifndef SHURIUM_NETWORK_COMPACT_BLOCK_H
+#define SHURIUM_NETWORK_COMPACT_BLOCK_H
+
+#include <shurium/core/block.h>
+#include <shurium/core/serialize.h>
+#include <shurium/core/transaction.h>
+#include <shurium/core/types.h>
+
+#include <cstdint>
+#include <ios>
+#include <vector>
+
+namespace shurium {
+
+class Mempool;
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Compact block protocol version we speak (sendcmpct)
+static constexpr uint64_t COMPACT_BLOCK_VERSION = 1;
+
+/// Bytes of a short transaction id on the wire
+static constexpr size_t SHORT_TXID_BYTES = 6;
+
+/// Transactions a compact block may list: indexes are 16-bit on the wire
+static constexpr size_t MAX_COMPACT_BLOCK_TXS = 65535;
+
+// ============================================================================
+// Wire Helpers
+// ============================================================================
+
+namespace detail {
+
+/// Read a transaction into a shared reference
+template<typename Stream>
+TransactionRef UnserializeTransactionRef(Stream& s) {
+    MutableTransaction mtx;
+    Unserialize(s, mtx);
+    return MakeTransactionRef(std::move(mtx));
+}
+
+/// Write ascending indexes as the gap after the previous one, as
+/// getblocktxn carries them (prefilled indexes are coded the same way)
+template<typename Stream>
+void SerializeDifferential(Stream& s, const std::vector<uint16_t>& indexes) {
+    WriteCompactSize(s, indexes.size());
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        WriteCompactSize(s, i == 0 ? indexes[0] : indexes[i] - indexes[i - 1] - 1);
+    }
+}
+
+/// Read differentially encoded indexes; they must climb and stay
+/// 16-bit
+template<typename Stream>
+std::vector<uint16_t> UnserializeDifferential(Stream& s) {
+    uint64_t count = ReadCompactSize(s);
+    if (count > MAX_COMPACT_BLOCK_TXS) {
+        throw std::ios_base::failure("too many compact block indexes");
+    }
+    std::vector<uint16_t> indexes;
+    indexes.reserve(static_cast<size_t>(count));
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        next += ReadCompactSize(s);
+        if (next > MAX_COMPACT_BLOCK_TXS - 1) {
+            throw std::ios_base::failure("compact block index out of range");
+        }
+        indexes.push_back(static_cast<uint16_t>(next));
+        ++next;
+    }
+    return indexes;
+}
+
+} // namespace detail
+
+// ============================================================================
+// Compact Block
+// ============================================================================
+
+/// A transaction sent whole inside a compact block, with its block index
+struct PrefilledTransaction {
+    uint16_t index{0};
+    TransactionRef tx;
+};
+
+/**
+ * Compact block (cmpctblock message).
+ *
+ * Short ids are the low 48 bits of SipHash-2-4 of the txid, keyed with the
+ * first 16 bytes of SHA256(header || nonce). The sender picks the nonce at
+ * random so that collisions cannot be ground across the network.
+ */
+class CompactBlock {
+public:
+    BlockHeader header;
+    uint64_t nonce{0};
+    std::vector<uint64_t> shortIds;
+    std::vector<PrefilledTransaction> prefilled;
+
+    CompactBlock() = default;
+
+    /// Encode a block, prefilling only its coinbase
+    CompactBlock(const Block& block, uint64_t nonce);
+
+    /// Short id of a transaction under this block's key
+    uint64_t GetShortId(const TxHash& txid) const;
+
+    /// Number of transactions in the block
+    size_t GetTxCount() const { return shortIds.size() + prefilled.size(); }
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, header);
+        ::shurium::Serialize(s, nonce);
+        WriteCompactSize(s, shortIds.size());
+        for (uint64_t id : shortIds) {
+            for (size_t i = 0; i < SHORT_TXID_BYTES; ++i) {
+                ::shurium::Serialize(s, static_cast<uint8_t>(id >> (8 * i)));
+            }
+        }
+        // Indexes and transactions interleave on the wire
+        WriteCompactSize(s, prefilled.size());
+        for (size_t i = 0; i < prefilled.size(); ++i) {
+            uint16_t index = prefilled[i].index;
+            WriteCompactSize(s, i == 0 ? index : index - prefilled[i - 1].index - 1);
+            ::shurium::Serialize(s, *prefilled[i].tx);
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, header);
+        ::shurium::Unserialize(s, nonce);
+        uint64_t idCount = ReadCompactSize(s);
+        if (idCount > MAX_COMPACT_BLOCK_TXS) {
+            throw std::ios_base::failure("too many short ids");
+        }
+        shortIds.clear();
+        shortIds.reserve(static_cast<size_t>(idCount));
+        for (uint64_t n = 0; n < idCount; ++n) {
+            uint64_t id = 0;
+            for (size_t i = 0; i < SHORT_TXID_BYTES; ++i) {
+                uint8_t byte;
+                ::shurium::Unserialize(s, byte);
+                id |= static_cast<uint64_t>(byte) << (8 * i);
+            }
+            shortIds.push_back(id);
+        }
+        uint64_t prefilledCount = ReadCompactSize(s);
+        if (idCount + prefilledCount > MAX_COMPACT_BLOCK_TXS) {
+            throw std::ios_base::failure("too many compact block transactions");
+        }
+        prefilled.clear();
+        prefilled.reserve(static_cast<size_t>(prefilledCount));
+        uint64_t next = 0;
+        for (uint64_t n = 0; n < prefilledCount; ++n) {
+            next += ReadCompactSize(s);
+            if (next > MAX_COMPACT_BLOCK_TXS - 1) {
+                throw std::ios_base::failure("prefilled index out of range");
+            }
+            PrefilledTransaction p;
+            p.index = static_cast<uint16_t>(next++);
+            p.tx = detail::UnserializeTransactionRef(s);
+            prefilled.push_back(std::move(p));
+        }
+        FillKey();
+    }
+
+private:
+    /// Derive the SipHash key from header and nonce
+    void FillKey();
+
+    uint64_t k0_{0};
+    uint64_t k1_{0};
+};
+
+// ============================================================================
+// Missing Transactions
+// ============================================================================
+
+/// Request for the transactions a compact block left us without
+class BlockTxnRequest {
+public:
+    BlockHash blockHash;
+    std::vector<uint16_t> indexes;   ///< Ascending block indexes
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, blockHash);
+        detail::SerializeDifferential(s, indexes);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, blockHash);
+        indexes = detail::UnserializeDifferential(s);
+    }
+};
+
+/// The transactions asked for by a BlockTxnRequest, in its order
+class BlockTxn {
+public:
+    BlockHash blockHash;
+    std::vector<TransactionRef> txs;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, blockHash);
+        WriteCompactSize(s, txs.size());
+        for (const auto& tx : txs) {
+            ::shurium::Serialize(s, *tx);
+        }
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, blockHash);
+        uint64_t count = ReadCompactSize(s);
+        if (count > MAX_COMPACT_BLOCK_TXS) {
+            throw std::ios_base::failure("too many block transactions");
+        }
+        txs.clear();
+        txs.reserve(static_cast<size_t>(count));
+        for (uint64_t i = 0; i < count; ++i) {
+            txs.push_back(detail::UnserializeTransactionRef(s));
+        }
+    }
+};
+
+// ============================================================================
+// Reconstruction
+// ============================================================================
+
+/// Outcome of rebuilding a block from its compact form
+enum class CompactReadStatus {
+    OK,        ///< Block laid out, or completed
+    INVALID,   ///< Malformed: the sender misbehaved
+    FAILED     ///< Short id collision or wrong merkle root: fetch the full block
+};
+
+/**
+ * A block being rebuilt from a compact block: the prefilled transactions,
+ * those found in the mempool, and holes for the rest.
+ */
+class PartiallyDownloadedBlock {
+public:
+    /**
+     * Lay out the block and fill it from the prefilled transactions, the
+     * mempool (may be null) and extra candidates such as orphans.
+     */
+    CompactReadStatus Init(const CompactBlock& cmpct, const Mempool* mempool,
+                           const std::vector<TransactionRef>& extraTxs = {});
+
+    /// Block indexes still missing, ascending
+    std::vector<uint16_t> GetMissingIndexes() const;
+
+    /// Whether the transaction at index is known
+    bool IsTxAvailable(size_t index) const {
+        return index < txs_.size() && txs_[index] != nullptr;
+    }
+
+    /// Transactions taken from the mempool or extra candidates
+    size_t GetMempoolCount() const { return mempoolCount_; }
+
+    /// Header of the block being rebuilt
+    const BlockHeader& GetHeader() const { return header_; }
+
+    /**
+     * Complete the block with the missing transactions, in the order of
+     * GetMissingIndexes, and check its merkle root.
+     */
+    CompactReadStatus FillBlock(Block& block, const std::vector<TransactionRef>& missing) const;
+
+private:
+    BlockHeader header_;
+    std::vector<TransactionRef> txs_;
+    size_t mempoolCount_{0};
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_NETWORK_COMPACT_BLOCK_H
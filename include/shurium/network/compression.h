@@ -0,0 +1,110 @@
+// SHURIUM - Message Compression
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Optional per-connection compression of message payloads. Each side says
+// in a sendcompr message, between version and verack, which algorithms it
+// can decode; from then on the other side may compress what it sends,
+// message by message, following its own policy. A compressed message
+// carries the compression flag in the last byte of its command and its
+// payload is the uncompressed size (4 bytes) followed by an LZ4 block.
+
+#ifndef SHURIUM_NETWORK_COMPRESSION_H
+#define SHURIUM_NETWORK_COMPRESSION_H
+
+#include <shurium/core/serialize.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Algorithms a sendcompr can announce, as bits
+enum class CompressionAlgorithm : uint32_t {
+    NONE = 0,
+    LZ4 = (1U << 0),
+};
+
+/// Default smallest payload worth compressing
+static constexpr size_t DEFAULT_COMPRESSION_THRESHOLD = 1024;
+
+// ============================================================================
+// Messages
+// ============================================================================
+
+/// Algorithms the sender can decode
+class SendComprMessage {
+public:
+    uint32_t algorithms{static_cast<uint32_t>(CompressionAlgorithm::LZ4)};
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, algorithms);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, algorithms);
+    }
+};
+
+// ============================================================================
+// Policy
+// ============================================================================
+
+/**
+ * What we compress for a peer that can decode it: payloads of at least
+ * threshold bytes, of the listed commands only. Small control messages
+ * and already dense ones (transactions, sketches) are not worth the CPU.
+ */
+struct CompressionPolicy {
+    size_t threshold{DEFAULT_COMPRESSION_THRESHOLD};
+    std::set<std::string> commands;
+
+    /// Blocks, headers, compact block parts, addresses and PoUW problems
+    /// and solutions
+    static CompressionPolicy Default();
+
+    bool ShouldCompress(const std::string& command, size_t payloadSize) const {
+        return payloadSize >= threshold && commands.count(command) > 0;
+    }
+};
+
+// ============================================================================
+// LZ4
+// ============================================================================
+
+/// Compress to an LZ4 block (the format of LZ4_compress_default)
+std::vector<uint8_t> LZ4Compress(const uint8_t* data, size_t size);
+
+/**
+ * Decompress an LZ4 block known to expand to exactly rawSize bytes.
+ * Every length and offset is bounds checked, so hostile input fails
+ * instead of reading or writing out of place.
+ */
+std::optional<std::vector<uint8_t>> LZ4Decompress(const uint8_t* data, size_t size,
+                                                  size_t rawSize);
+
+// ============================================================================
+// Payload Framing
+// ============================================================================
+
+/// Compressed payload: uncompressed size, then the LZ4 block. nullopt if
+/// compressing would not make it smaller.
+std::optional<std::vector<uint8_t>> CompressPayload(const std::vector<uint8_t>& payload);
+
+/// Original payload, or nullopt if malformed or larger than maxSize
+std::optional<std::vector<uint8_t>> DecompressPayload(const std::vector<uint8_t>& payload,
+                                                      size_t maxSize);
+
+} // namespace shurium
+
+#endif // SHURIUM_NETWORK_COMPRESSION_H
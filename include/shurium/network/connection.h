@@ -9,6 +9,7 @@
 #define SHURIUM_NETWORK_CONNECTION_H
 
 #include <shurium/network/address.h>
+#include <shurium/network/admission.h>
 #include <shurium/network/peer.h>
 
 #include <atomic>
@@ -33,6 +34,10 @@ class Connection;
 class ConnectionManager;
 class EventLoop;
 
+namespace util {
+class IoRing;
+}
+
 // ============================================================================
 // Socket Handle
 // ============================================================================
@@ -70,6 +75,93 @@ enum class ConnEvent {
     ERROR           ///< Error occurred
 };
 
+// ============================================================================
+// Send Shaping
+// ============================================================================
+
+/**
+ * Token bucket limiting a byte rate. Tokens accrue at the rate up to the
+ * burst; sending spends them. Urgent traffic may spend past zero, and the
+ * debt then holds back everything else until it is paid off.
+ *
+ * Thread-safe, so one bucket can be shared by every connection.
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    /// rate in bytes per second, 0 for no limit; burst is the most that
+    /// can be saved up (0 = one second's worth)
+    explicit TokenBucket(uint64_t rate = 0, uint64_t burst = 0);
+    
+    /// Change the limit; saved tokens are kept up to the new burst
+    void SetRate(uint64_t rate, uint64_t burst = 0);
+    
+    /// Whether there is a limit at all
+    bool IsLimited() const { return rate_.load() > 0; }
+    
+    /// Bytes per second
+    uint64_t GetRate() const { return rate_.load(); }
+    
+    /// Bytes that may be sent now (SIZE_MAX without a limit)
+    size_t Available(Clock::time_point now);
+    
+    /// Spend tokens for bytes sent
+    void Consume(size_t bytes, Clock::time_point now);
+    
+private:
+    /// Accrue tokens up to now (mutex_ held)
+    void Refill(Clock::time_point now);
+    
+    std::atomic<uint64_t> rate_;
+    uint64_t burst_;
+    std::mutex mutex_;
+    double tokens_;
+    Clock::time_point last_;
+    bool started_{false};
+};
+
+/**
+ * Daily cap on bytes sent (-maxuploadtarget). Bytes are counted in 24 hour
+ * cycles; once a cycle's target is used up, historical blocks are no
+ * longer served until the next cycle begins. Thread-safe.
+ */
+class UploadTarget {
+public:
+    /// Length of a counting cycle
+    static constexpr int64_t CYCLE_SECONDS = 24 * 60 * 60;
+    
+    /// maxBytes per cycle, 0 for no target
+    explicit UploadTarget(uint64_t maxBytes = 0) : target_(maxBytes) {}
+    
+    /// Bytes allowed per cycle
+    uint64_t GetTarget() const { return target_; }
+    
+    /// Count bytes sent at time now (seconds)
+    void RecordSent(uint64_t bytes, int64_t now);
+    
+    /// Whether the cycle's target is used up
+    bool IsReached(int64_t now) const;
+    
+    /// Bytes sent in the current cycle
+    uint64_t GetBytesSent(int64_t now) const;
+    
+    /// Bytes left in the current cycle (UINT64_MAX without a target)
+    uint64_t GetBytesLeft(int64_t now) const;
+    
+    /// Seconds until the current cycle ends
+    int64_t GetTimeLeftInCycle(int64_t now) const;
+    
+private:
+    /// Start a new cycle if the current one is over (mutex_ held)
+    void Roll(int64_t now) const;
+    
+    uint64_t target_;
+    mutable std::mutex mutex_;
+    mutable int64_t cycleStart_{0};
+    mutable uint64_t sent_{0};
+};
+
 // ============================================================================
 // Connection Options
 // ============================================================================
@@ -104,6 +196,16 @@ struct ConnectionOptions {
     
     /// Send buffer size (SO_SNDBUF, 0 = system default)
     int sendBufSize{0};
+    
+    /// Bytes per second sent to this peer, 0 = unlimited. New-block relay
+    /// (SendPriority::HIGH) is never held back.
+    uint64_t maxSendRate{0};
+    
+    /// Limit shared with other connections (null = none)
+    std::shared_ptr<TokenBucket> sharedSendLimit;
+    
+    /// Daily upload target the bytes sent count towards (null = none)
+    std::shared_ptr<UploadTarget> uploadTarget;
 };
 
 // ============================================================================
@@ -121,6 +223,7 @@ public:
     using EventCallback = std::function<void(Connection&, ConnEvent)>;
     using DataCallback = std::function<void(Connection&, const uint8_t*, size_t)>;
     using ErrorCallback = std::function<void(Connection&, int errorCode, const std::string& msg)>;
+    using WriteRequestCallback = std::function<void(Connection&)>;
     
     // ========================================================================
     // Construction/Destruction
@@ -190,6 +293,15 @@ public:
         return Send(data.data(), data.size());
     }
     
+    /// Queue a shared buffer whole, without copying it (the write buffer
+    /// limit applies only to copied data)
+    void Send(SendBuffer buffer);
+    
+    /// Move everything the peer has queued onto this connection, buffers
+    /// and all
+    /// @return Number of bytes moved
+    size_t SendFrom(Peer& peer);
+    
     /// Read available data from receive buffer
     /// @param buffer Output buffer
     /// @param maxLen Maximum bytes to read
@@ -199,6 +311,11 @@ public:
     /// Read all available data
     std::vector<uint8_t> RecvAll();
     
+    /// Hand all available data to the peer's message framing, which writes
+    /// it straight into the payloads it belongs to
+    /// @return Number of bytes handed over
+    size_t RecvInto(Peer& peer);
+    
     /// Get number of bytes in send buffer
     size_t GetSendBufferSize() const;
     
@@ -208,6 +325,13 @@ public:
     /// Check if there's data to send
     bool HasPendingData() const { return GetSendBufferSize() > 0; }
     
+    /// Whether the last write stopped for want of tokens, with data left;
+    /// the event loop retries such connections every iteration
+    bool IsSendThrottled() const { return sendThrottled_.load(); }
+    
+    /// Apply the rate limits and upload target of opts
+    void SetSendShaping(const ConnectionOptions& opts);
+    
     // ========================================================================
     // Callbacks
     // ========================================================================
@@ -244,14 +368,25 @@ public:
     /// Handle socket readable event
     void OnReadable();
     
-    /// Handle socket writable event
-    void OnWritable();
+    /// Handle the outcome of a read the event loop made for this
+    /// connection: bytes read into data, 0 at end of stream, or -errno
+    void OnReadResult(const uint8_t* data, int64_t result);
+    
+    /// Handle socket writable event. Large buffers go out zero-copy
+    /// through ring if it is given and supports that.
+    void OnWritable(util::IoRing* ring = nullptr);
     
     /// Handle socket error
     void OnError(int errorCode);
     
     /// Handle connect completion
     void OnConnectComplete(bool success);
+    
+    /// Set callback run (under the send lock) when data is queued on an
+    /// empty send queue. Edge-triggered event loops hear about a socket
+    /// only when its writability changes, so they use this to learn that
+    /// there is something to write.
+    void SetWriteRequestCallback(WriteRequestCallback cb);
 
 private:
     Connection(const NetService& addr, const ConnectionOptions& opts);
@@ -263,6 +398,13 @@ private:
     /// Set connection state
     void SetState(ConnState newState);
     
+    /// Run the write request callback if the queue just stopped being
+    /// empty (sendMutex_ held)
+    void NotifyQueued(bool wasEmpty);
+    
+    /// Buffer received bytes and pass them to the data callback
+    void DeliverReceived(const uint8_t* data, size_t len);
+    
     // Socket and addressing
     SocketHandle socket_{INVALID_SOCKET_HANDLE};
     NetService remoteAddr_;
@@ -273,8 +415,10 @@ private:
     
     // Buffers
     mutable std::mutex sendMutex_;
-    std::vector<uint8_t> sendBuffer_;
-    size_t sendOffset_{0};  // Offset of first unsent byte
+    SendQueue sendQueue_;
+    WriteRequestCallback writeRequestCallback_;
+    TokenBucket sendLimit_;
+    std::atomic<bool> sendThrottled_{false};
     
     mutable std::mutex recvMutex_;
     std::vector<uint8_t> recvBuffer_;
@@ -301,6 +445,7 @@ private:
 class Listener {
 public:
     using AcceptCallback = std::function<void(std::unique_ptr<Connection>)>;
+    using FilterCallback = std::function<bool(const NetService&)>;
     
     /// Create listener on specified address and port
     static std::unique_ptr<Listener> Create(const NetAddress& bindAddr, uint16_t port);
@@ -329,6 +474,11 @@ public:
     /// Set callback for accepted connections
     void SetAcceptCallback(AcceptCallback cb) { acceptCallback_ = std::move(cb); }
     
+    /// Set callback deciding from the remote address alone whether to keep
+    /// an accepted socket; refused sockets are closed before a Connection
+    /// is built for them
+    void SetFilterCallback(FilterCallback cb) { filterCallback_ = std::move(cb); }
+    
     /// Handle incoming connection (called by EventLoop)
     void OnAccept();
 
@@ -340,22 +490,46 @@ private:
     uint16_t port_;
     std::atomic<bool> listening_{false};
     AcceptCallback acceptCallback_;
+    FilterCallback filterCallback_;
 };
 
 // ============================================================================
 // Event Loop
 // ============================================================================
 
+/// Readiness mechanism behind an EventLoop
+enum class EventBackend {
+    POLL,    ///< poll(), rebuilding the descriptor set every iteration
+    EPOLL,   ///< Linux epoll, edge-triggered
+    KQUEUE   ///< BSD/macOS kqueue, edge-triggered (EV_CLEAR)
+};
+
+/// Get backend name ("poll", "epoll", "kqueue")
+const char* EventBackendName(EventBackend backend);
+
+/// Best backend this platform has: epoll on Linux, kqueue on the BSDs and
+/// macOS, poll elsewhere
+EventBackend DefaultEventBackend();
+
 /**
  * Event loop for managing async I/O on multiple connections.
  * 
- * Uses platform-specific mechanisms (epoll/kqueue/select) internally.
+ * With epoll and kqueue every socket is registered once, for both
+ * directions and edge-triggered, so an idle wakeup costs nothing per
+ * connection. Connections therefore read and write until the socket would
+ * block, and a write queued on an idle connection reaches the loop through
+ * the connection's write request callback. poll() is kept as the fallback.
+ * Connections must be removed before they are destroyed.
  */
 class EventLoop {
 public:
-    EventLoop();
+    /// Use the given backend, or poll if this platform lacks it
+    explicit EventLoop(EventBackend backend = DefaultEventBackend());
     ~EventLoop();
     
+    /// Backend in use
+    EventBackend GetBackend() const;
+    
     /// Start the event loop in a background thread
     void Start();
     
@@ -388,6 +562,35 @@ private:
     void ProcessEvents(int timeoutMs);
     void ProcessPostedCallbacks();
     
+    /// Handle readiness reported for one socket
+    void DispatchEvent(SocketHandle sock, bool readable, bool writable, bool failed);
+    
+    /// A connected socket epoll reported, and whether it is writable too
+    struct ReadyConnection {
+        SocketHandle sock;
+        Connection* conn;
+        bool writable;
+    };
+    
+    /// Read every ready connection with one submission to the ring, then
+    /// write those that are writable too
+    void ReadReady(const std::vector<ReadyConnection>& ready);
+    
+    /// Write out connections whose idle send queue gained data
+    void FlushRequestedWrites();
+    
+    /// Queue a connection for FlushRequestedWrites
+    void RequestWrite(Connection* conn);
+    
+    /// Write out a connection, remembering it if rate limits stopped it
+    void Write(Connection* conn);
+    
+    /// Write out connections a rate limit stopped earlier
+    void RetryThrottledWrites();
+    
+    /// Interrupt a wait in ProcessEvents
+    void WakeUp();
+    
     std::atomic<bool> running_{false};
     std::thread eventThread_;
     
@@ -444,6 +647,19 @@ struct ConnectionManagerOptions {
     
     /// Whether to accept inbound connections
     bool acceptInbound{true};
+    
+    /// Bytes per second sent to each peer, 0 = unlimited
+    uint64_t maxSendRatePerPeer{0};
+    
+    /// Bytes per second sent to all peers together, 0 = unlimited
+    uint64_t maxSendRateTotal{0};
+    
+    /// Bytes sent per day before historical blocks stop being served,
+    /// 0 = no target
+    uint64_t maxUploadTarget{0};
+    
+    /// Inbound connect rates, handshake slots and eviction protection
+    AdmissionOptions admission;
 };
 
 // ============================================================================
@@ -477,6 +693,10 @@ public:
     /// Check if running
     bool IsRunning() const { return running_.load(); }
     
+    /// Port inbound connections are accepted on (0 if not listening); the
+    /// one picked by the system when listenPort is 0
+    uint16_t GetListenPort() const;
+    
     // ========================================================================
     // Connection Management
     // ========================================================================
@@ -556,8 +776,25 @@ public:
     /// Get total bytes received across all peers
     uint64_t GetTotalBytesRecv() const;
     
+    /// Daily upload target shared by the connections
+    const UploadTarget& GetUploadTarget() const { return *uploadTarget_; }
+    
+    /// Whether the upload target is used up for today
+    bool IsUploadTargetReached() const;
+    
+    /// Disconnect inbound peers that overran their handshake deadline
+    void DisconnectSlowHandshakes();
+    
+    /// Inbound connections still in their handshake
+    size_t GetPendingInboundCount() const { return admission_.GetPendingCount(); }
+    
 private:
+    /// Decide on an accepted socket before anything is allocated for it,
+    /// evicting an inbound peer if the slots are full
+    bool AdmitInbound(const NetService& addr);
     void AcceptConnection(std::unique_ptr<Connection> conn);
+    /// Move bytes between a connection and its peer as they come and go
+    void AttachPeer(Peer::Id id, Connection& conn, Peer& peer);
     void HandlePeerDisconnect(Peer::Id id, DisconnectReason reason);
     Peer::Id AllocatePeerId();
     bool CanAcceptConnection(bool inbound) const;
@@ -575,6 +812,13 @@ private:
     std::unordered_map<Peer::Id, std::unique_ptr<Connection>> connections_;
     std::atomic<Peer::Id> nextPeerId_{1};
     
+    // Inbound admission and eviction
+    InboundAdmission admission_;
+    
+    // Send shaping shared by every connection
+    ConnectionOptions connOptions_;
+    std::shared_ptr<UploadTarget> uploadTarget_;
+    
     // Ban list
     mutable std::mutex banMutex_;
     std::map<NetAddress, int64_t> banList_;  // Address -> ban expiry time
@@ -0,0 +1,121 @@
+// SHURIUM - Inventory Filters
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Fixed-memory tracking of which inventory a peer already knows. A rolling
+// bloom filter remembers at least the last N transactions in constant space
+// (older ones age out a generation at a time); blocks and the other rare
+// item types go in a short exact set instead, so a false positive can never
+// stop a block announcement.
+
+#ifndef SHURIUM_NETWORK_INVENTORY_FILTER_H
+#define SHURIUM_NETWORK_INVENTORY_FILTER_H
+
+#include <shurium/core/types.h>
+#include <shurium/network/protocol.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Transactions a peer's inventory filter is guaranteed to remember
+static constexpr size_t PEER_INVENTORY_FILTER_ITEMS = 10000;
+
+/// False positive rate of a peer's inventory filter
+static constexpr double PEER_INVENTORY_FILTER_FP_RATE = 0.000001;
+
+/// Non-transaction items a peer's inventory filter remembers exactly
+static constexpr size_t PEER_INVENTORY_RECENT_ITEMS = 256;
+
+// ============================================================================
+// RollingBloomFilter
+// ============================================================================
+
+/**
+ * Bloom filter that forgets old entries instead of filling up.
+ *
+ * Entries are inserted in generations of half the capacity, and each bit
+ * position records the generation that last set it (two bits per
+ * position). Starting a fourth generation clears the oldest, so the filter
+ * always holds the last `items` insertions and at most 1.5 times that. The
+ * false positive rate holds at any fill level.
+ *
+ * Hashes are SipHash under a random key per filter, so peers cannot craft
+ * items that collide in someone else's filter. The bit array is allocated on
+ * the first insert. Not thread-safe.
+ */
+class RollingBloomFilter {
+public:
+    RollingBloomFilter(size_t items, double fpRate);
+
+    /// Add a 256-bit hash (with an optional 32-bit discriminator)
+    void Insert(const Hash256& hash, uint32_t extra = 0);
+
+    /// Whether the hash may have been inserted among the recent entries
+    bool Contains(const Hash256& hash, uint32_t extra = 0) const;
+
+    /// Forget every entry (keeps the allocation)
+    void Reset();
+
+    /// Number of hash functions
+    size_t GetHashFunctions() const { return hashFuncs_; }
+
+    /// Bytes held by the bit array once allocated
+    size_t GetMemoryUsage() const { return words_ * sizeof(uint64_t); }
+
+private:
+    /// The two seeds of double hashing
+    void Hashes(const Hash256& hash, uint32_t extra, uint64_t& h1, uint64_t& h2) const;
+
+    /// Word pair and bit of the i-th hash
+    void Position(uint64_t h1, uint64_t h2, size_t i, size_t& pair, int& bit) const;
+
+    size_t entriesPerGeneration_;
+    size_t hashFuncs_;
+    size_t words_;                       // Two per 64 positions
+    uint64_t k0_;
+    uint64_t k1_;
+    size_t entriesThisGeneration_{0};
+    uint32_t generation_{1};             // 1..3
+    std::vector<uint64_t> data_;
+};
+
+// ============================================================================
+// InventoryFilter
+// ============================================================================
+
+/**
+ * Inventory items known to one side of a peer connection.
+ *
+ * Transactions go in a rolling bloom filter; blocks and the other item
+ * types go in a bounded exact set, where forgetting an old entry only means
+ * announcing it again.
+ */
+class InventoryFilter {
+public:
+    InventoryFilter(size_t items = PEER_INVENTORY_FILTER_ITEMS,
+                    double fpRate = PEER_INVENTORY_FILTER_FP_RATE,
+                    size_t recentItems = PEER_INVENTORY_RECENT_ITEMS);
+
+    void Insert(const Inv& inv);
+    bool Contains(const Inv& inv) const;
+    void Reset();
+
+private:
+    RollingBloomFilter transactions_;
+    size_t recentCapacity_;
+    std::set<Inv> recent_;
+    std::deque<Inv> recentOrder_;        // Oldest first
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_NETWORK_INVENTORY_FILTER_H
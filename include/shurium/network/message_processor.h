@@ -8,18 +8,26 @@
 #ifndef SHURIUM_NETWORK_MESSAGE_PROCESSOR_H
 #define SHURIUM_NETWORK_MESSAGE_PROCESSOR_H
 
+#include <shurium/network/compact_block.h>
+#include <shurium/network/compression.h>
+#include <shurium/network/txreconciliation.h>
 #include <shurium/network/connection.h>
 #include <shurium/network/peer.h>
 #include <shurium/network/protocol.h>
 #include <shurium/network/sync.h>
 #include <shurium/core/serialize.h>
 #include <shurium/core/block.h>
+#include <shurium/mempool/orphans.h>
+#include <shurium/util/threadpool.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
 #include <vector>
 
@@ -34,6 +42,7 @@ struct NodeContext;
 
 namespace db {
 class BlockDB;
+class BlockFilterIndex;
 }
 
 // ============================================================================
@@ -52,8 +61,17 @@ struct MessageStats {
     uint64_t blockMessages{0};
     uint64_t txMessages{0};
     uint64_t addrMessages{0};
+    uint64_t addrRateLimited{0};         ///< Addresses dropped over a peer's allowance
+    uint64_t addrRelayed{0};             ///< Addresses trickled on to other peers
     uint64_t unknownMessages{0};
     uint64_t invalidMessages{0};
+    uint64_t heavyMessages{0};           ///< Heavy messages handled on their lane
+    uint64_t compactBlocks{0};           ///< cmpctblock received
+    uint64_t compactBlocksFromMempool{0};///< Rebuilt with no round trip
+    uint64_t blockTxnRequests{0};        ///< getblocktxn sent
+    uint64_t compactFallbacks{0};        ///< Full block fetched instead
+    uint64_t reconciliations{0};         ///< Sketches decoded
+    uint64_t reconciliationFailures{0};  ///< Sets flooded after a failed decode
 };
 
 // ============================================================================
@@ -64,6 +82,72 @@ struct MessageStats {
 // Message Processor Options
 // ============================================================================
 
+/// Block messages kept after serving, for the next peers to ask for them
+static constexpr size_t MAX_SERVED_BLOCK_MESSAGES = 8;
+
+/// Peers asked to push new blocks to us as compact blocks
+static constexpr size_t MAX_HIGH_BANDWIDTH_PEERS = 3;
+
+/// Deepest block served as a compact block; older ones go whole
+static constexpr int MAX_CMPCTBLOCK_DEPTH = 5;
+
+/// Deepest block getblocktxn is answered for; older ones go whole
+static constexpr int MAX_BLOCKTXN_DEPTH = 10;
+
+/// Blocks older than this (seconds) are historical: sent at bulk priority,
+/// and no longer served once the upload target is reached
+static constexpr int64_t HISTORICAL_BLOCK_AGE = 7 * 24 * 60 * 60;
+
+/// Compact blocks waiting for their missing transactions
+static constexpr size_t MAX_PENDING_COMPACT_BLOCKS = 16;
+
+/// Addresses a peer's allowance grows by each second; it saves up to one
+/// full addr message
+static constexpr double ADDR_RATE_PER_SECOND = 0.1;
+
+/// Addr messages this small are relayed on; larger ones answer a getaddr
+static constexpr size_t MAX_ADDR_RELAY_MESSAGE = 10;
+
+/// Peers each relayed address is passed to
+static constexpr size_t ADDR_RELAY_FANOUT = 2;
+
+/// Addresses last seen longer ago than this (seconds) are not relayed
+static constexpr int64_t ADDR_RELAY_MAX_AGE = 10 * 60;
+
+/**
+ * A peer's allowance of addresses: a token bucket filled at
+ * ADDR_RATE_PER_SECOND up to MAX_ADDR_TO_SEND. It starts with one token;
+ * a getaddr we send grants a full message's worth for the answer.
+ */
+class AddrTokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    explicit AddrTokenBucket(Clock::time_point now = Clock::now()) : updated_(now) {}
+    
+    /// Spend a token for each of up to count addresses
+    /// @return How many of them the allowance covers
+    size_t Take(size_t count, Clock::time_point now) {
+        double seconds = std::chrono::duration<double>(now - updated_).count();
+        if (seconds > 0) {
+            tokens_ = std::min<double>(MAX_ADDR_TO_SEND, tokens_ + seconds * ADDR_RATE_PER_SECOND);
+            updated_ = now;
+        }
+        size_t allowed = std::min(count, static_cast<size_t>(tokens_));
+        tokens_ -= static_cast<double>(allowed);
+        return allowed;
+    }
+    
+    /// Let tokens more addresses through, past the cap
+    void Grant(double tokens) { tokens_ += tokens; }
+    
+    double GetTokens() const { return tokens_; }
+
+private:
+    double tokens_{1.0};
+    Clock::time_point updated_;
+};
+
 struct MessageProcessorOptions {
     /// Interval between message processing cycles (milliseconds)
     int processingIntervalMs{100};
@@ -77,8 +161,40 @@ struct MessageProcessorOptions {
     /// Maximum messages to process per peer per cycle
     int maxMessagesPerPeer{100};
     
+    /// Mean wait before addresses queued for a peer are sent (milliseconds).
+    /// Each wait is drawn at random, so the order peers hear of an address
+    /// does not give away where it came from.
+    int addrTrickleMs{30000};
+    
+    /// Workers for ordinary messages. A peer always lands on the same one,
+    /// so its messages keep their order. 0 handles every message on the
+    /// processing thread.
+    int workerThreads{4};
+    
+    /// Messages a peer may have waiting on the heavy lane (its heavy ones
+    /// and those queued behind them); its later messages wait behind the limit
+    int maxHeavyPerPeer{16};
+    
     /// Enable transaction relay
     bool relayTransactions{true};
+    
+    /// Relay and accept compact blocks, rebuilt from the mempool
+    bool compactBlocks{true};
+    
+    /// Relay transactions to peers that speak it by set reconciliation,
+    /// flooding only a few of them
+    bool txReconciliation{true};
+    
+    /// Offer to decode compressed messages, and compress to peers that
+    /// offer the same
+    bool compression{true};
+    
+    /// Which messages we compress to such peers
+    CompressionPolicy compressionPolicy{CompressionPolicy::Default()};
+    
+    /// Services advertised in our version message (pruned nodes use
+    /// NETWORK_LIMITED instead of NETWORK)
+    ServiceFlags localServices{ServiceFlags::NETWORK};
 };
 
 // ============================================================================
@@ -96,6 +212,14 @@ struct MessageProcessorOptions {
  * - Handles transaction relay via mempool
  * - Manages ping/pong keepalive
  * 
+ * With workerThreads set, peers are sharded across a util::ThreadPool by
+ * id and each shard runs one pass at a time, so a peer's messages are
+ * handled in order. Blocks and getdata for blocks go to a single heavy
+ * lane of their own, in arrival order, so a slow block does not hold up
+ * other peers' pings and transactions. A peer's messages that arrive
+ * while one of its heavy messages is waiting follow it onto the heavy
+ * lane, so no peer's messages are reordered.
+ * 
  * Thread safety: All public methods are thread-safe.
  */
 class MessageProcessor {
@@ -162,6 +286,13 @@ public:
      */
     void SetBlockDB(db::BlockDB* blockdb);
     
+    /**
+     * Set optional block filter index for serving getcfilters and
+     * getcfheaders. Setting one advertises COMPACT_FILTERS, so it must be
+     * set before Start().
+     */
+    void SetBlockFilterIndex(db::BlockFilterIndex* filterIndex);
+    
     /**
      * Set our local address for version messages.
      */
@@ -191,10 +322,16 @@ public:
      */
     bool IsRunning() const { return running_.load(); }
     
+    /**
+     * Get the services advertised in our version message.
+     */
+    ServiceFlags GetLocalServices() const { return ourServices_; }
+    
     /**
      * Process messages for all peers (single iteration).
      * Called automatically by the background thread, but can also
-     * be called manually for testing or single-threaded use.
+     * be called manually for testing or single-threaded use. While the
+     * workers run, this only hands them their peers.
      */
     void ProcessMessages();
     
@@ -233,6 +370,12 @@ public:
      */
     void RelayBlock(const BlockHash& blockHash, Peer::Id excludePeer = 0);
     
+    /**
+     * Relay a block we hold in full: peers that asked for high-bandwidth
+     * compact blocks get a cmpctblock right away, the rest an announcement.
+     */
+    void RelayBlock(const Block& block, Peer::Id excludePeer = 0);
+    
     /**
      * Queue a transaction for relay (batched).
      * More efficient than calling RelayTransaction for each tx.
@@ -245,6 +388,22 @@ public:
      */
     void FlushRelayQueue();
     
+    // ========================================================================
+    // Orphan Transactions
+    // ========================================================================
+    
+    /**
+     * A block became the tip: drop the orphans it confirmed or conflicted,
+     * and queue the ones it supplied parents for.
+     */
+    void BlockConnected(const Block& block);
+    
+    /// A peer went away: drop the orphans it sent
+    void PeerDisconnected(Peer::Id peerId);
+    
+    /// Number of orphan transactions held
+    size_t GetOrphanCount() const { return orphans_.Size(); }
+    
     // ========================================================================
     // Node Context Integration
     // ========================================================================
@@ -264,18 +423,47 @@ public:
     
     /// Reset statistics
     void ResetStats();
+    
+    /// Block synchronizer, for per-peer download figures (may be null)
+    BlockSynchronizer* GetBlockSynchronizer() const { return sync_; }
+    
+    /// Per-peer transaction reconciliation state
+    const TxReconciliationTracker& GetTxReconciliation() const { return reconciliation_; }
 
 private:
     // ========================================================================
     // Message Processing (Internal)
     // ========================================================================
     
-    /// Process messages for a single peer
+    /// Process messages for a single peer; heavy ones go to the heavy lane
+    /// when it runs
     void ProcessPeerMessages(std::shared_ptr<Peer> peer);
     
-    /// Dispatch a single message to its handler
+    /// Dispatch one message and account for it
+    /// @return false if the peer is to be dropped
+    bool HandleMessage(Peer& peer, const std::string& command, std::vector<uint8_t>&& payload);
+    
+    /// Blocks, and getdata asking for blocks
+    static bool IsHeavyMessage(const std::string& command, const std::vector<uint8_t>& payload);
+    
+    /// Give each idle worker shard a pass over the peers it owns
+    void ScheduleMessages();
+    
+    /// Process messages for one shard's peers (worker thread)
+    void ProcessShard(size_t shard, const std::vector<std::shared_ptr<Peer>>& peers);
+    
+    /// Queue a message on the heavy lane, starting it if it is idle; heavy is
+    /// false for a light message that only follows its peer's heavy ones
+    void QueueHeavyMessage(std::shared_ptr<Peer> peer, std::string command,
+                           std::vector<uint8_t> payload, bool heavy);
+    
+    /// Handle heavy messages until none are left (heavy lane thread)
+    void ProcessHeavyMessages();
+    
+    /// Dispatch a single message to its handler; the payload becomes the
+    /// handler's DataStream without a copy
     bool DispatchMessage(Peer& peer, const std::string& command, 
-                         const std::vector<uint8_t>& payload);
+                         std::vector<uint8_t>&& payload);
     
     // ========================================================================
     // Message Handlers
@@ -305,9 +493,16 @@ private:
     /// Handle block message
     bool HandleBlock(Peer& peer, DataStream& payload);
     
-    /// Handle tx message
+    /// Handle tx message: queues the transaction for the next batch
     bool HandleTx(Peer& peer, DataStream& payload);
     
+    /**
+     * Validate the queued transactions as packages and relay the accepted
+     * ones. Those missing inputs wait in the orphan pool, and the orphans
+     * an accepted transaction was missing join the next batch.
+     */
+    void AcceptPendingTxs();
+    
     /// Handle getheaders message
     bool HandleGetHeaders(Peer& peer, DataStream& payload);
     
@@ -329,6 +524,85 @@ private:
     /// Handle notfound message
     bool HandleNotFound(Peer& peer, DataStream& payload);
     
+    // ========================================================================
+    // Compact Blocks
+    // ========================================================================
+    
+    /// Handle sendcmpct message
+    bool HandleSendCmpct(Peer& peer, DataStream& payload);
+    
+    /// Handle cmpctblock message: rebuild from the mempool, then ask for
+    /// what is missing
+    bool HandleCmpctBlock(Peer& peer, DataStream& payload);
+    
+    /// Handle getblocktxn message
+    bool HandleGetBlockTxn(Peer& peer, DataStream& payload);
+    
+    /// Handle blocktxn message: complete a pending compact block
+    bool HandleBlockTxn(Peer& peer, DataStream& payload);
+    
+    /// Whether new blocks from this peer should be asked for as compact
+    /// blocks (it speaks them and we are at the tip)
+    bool ShouldRequestCompact(const Peer& peer) const;
+    
+    /// A peer was first to give us a new block: ask it to push the next
+    /// ones, dropping the longest-serving of the others past the limit
+    void MaybeSetHighBandwidth(Peer& peer);
+    
+    /// Send a block as a cmpctblock
+    void SendCompactBlock(Peer& peer, const Block& block);
+    
+    /// Give up on a compact block and fetch it whole
+    void RequestFullBlock(Peer& peer, const BlockHash& hash);
+    
+    /// Hand a received or rebuilt block to the synchronizer
+    void DeliverBlock(Peer& peer, const Block& block);
+    
+    /// Handle sendcompr message: compress to the peer from now on
+    bool HandleSendCompr(Peer& peer, DataStream& payload);
+    
+    // ========================================================================
+    // Compact Block Filters
+    // ========================================================================
+    
+    /// Handle getcfilters message: one cfilter per block in the range
+    bool HandleGetCFilters(Peer& peer, DataStream& payload);
+    
+    /// Handle getcfheaders message
+    bool HandleGetCFHeaders(Peer& peer, DataStream& payload);
+    
+    /**
+     * Check a filter request and find the block it stops at. A request for
+     * a type we do not index, an unknown stop block or more than maxCount
+     * blocks is misbehaviour.
+     * @return The stop block, or null if the request is not to be answered
+     */
+    const BlockIndex* PrepareBlockFilterRequest(Peer& peer, uint8_t filterType,
+                                                uint32_t startHeight, const Hash256& stopHash,
+                                                uint32_t maxCount);
+    
+    // ========================================================================
+    // Transaction Reconciliation
+    // ========================================================================
+    
+    /// Handle sendtxrcncl message: register the peer for reconciliation
+    bool HandleSendTxRcncl(Peer& peer, DataStream& payload);
+    
+    /// Handle reqrecon message: answer with a sketch of our set
+    bool HandleReqRecon(Peer& peer, DataStream& payload);
+    
+    /// Handle sketch message: decode the difference and settle it
+    bool HandleSketch(Peer& peer, DataStream& payload);
+    
+    /// Handle reconcildiff message: announce what the initiator lacks
+    bool HandleReconcilDiff(Peer& peer, DataStream& payload);
+    
+    /// Start a reconciliation with the next peer we initiate with
+    void RequestReconciliation();
+    
+    /// Inv the transactions the peer does not already know of
+    void AnnounceTransactions(Peer& peer, const std::vector<TxHash>& txids);
+    
     // ========================================================================
     // Periodic Tasks
     // ========================================================================
@@ -342,6 +616,12 @@ private:
     /// Announce pending inventory
     void SendAnnouncements();
     
+    /// Queue addresses a peer sent us for the peers picked to hear of each
+    void RelayAddresses(Peer::Id from, const std::vector<PeerAddress>& addresses);
+    
+    /// Send the peers whose trickle timer came due the addresses queued for them
+    void SendAddrRelay();
+    
     // ========================================================================
     // Helper Methods
     // ========================================================================
@@ -364,6 +644,16 @@ private:
     /// Send getdata message to peer  
     void SendGetData(Peer& peer, const std::vector<Inv>& inv);
     
+    /// Read a stored block from disk
+    bool ReadBlock(const BlockIndex& index, Block& block);
+    
+    /// The block message for a stored block, read from disk unless it was
+    /// served recently
+    std::optional<OutboundMessage> GetBlockMessage(const BlockHash& hash, const BlockIndex& index);
+    
+    /// Whether a block is old enough to count as historical
+    bool IsHistoricalBlock(const BlockIndex& index) const;
+    
     // ========================================================================
     // Background Thread
     // ========================================================================
@@ -378,6 +668,23 @@ private:
     std::atomic<bool> running_{false};
     std::thread processingThread_;
     
+    // Message workers: one pass per shard at a time
+    std::unique_ptr<util::ThreadPool> workers_;
+    std::deque<std::atomic<bool>> shardBusy_;
+    
+    // Heavy lane, drained by one task at a time in arrival order
+    struct HeavyMessage {
+        std::shared_ptr<Peer> peer;
+        std::string command;
+        std::vector<uint8_t> payload;
+        bool heavy{false};
+    };
+    std::unique_ptr<util::ThreadPool> heavyWorker_;
+    std::mutex heavyMutex_;
+    std::deque<HeavyMessage> heavyQueue_;
+    std::map<Peer::Id, int> heavyBacklog_;
+    bool heavyScheduled_{false};
+    
     // Component references (not owned)
     ConnectionManager* connman_{nullptr};
     BlockSynchronizer* sync_{nullptr};
@@ -386,6 +693,7 @@ private:
     CoinsView* coins_{nullptr};
     AddressManager* addrman_{nullptr};
     db::BlockDB* blockdb_{nullptr};
+    db::BlockFilterIndex* filterIndex_{nullptr};
     
     // Chain height for tx validation
     std::atomic<int32_t> chainHeight_{0};
@@ -394,7 +702,7 @@ private:
     NetService localAddress_;
     
     // Our service flags
-    ServiceFlags ourServices_{ServiceFlags::NETWORK};
+    ServiceFlags ourServices_;
     
     // Callbacks
     HandshakeCallback handshakeCallback_;
@@ -413,6 +721,50 @@ private:
     mutable std::mutex relayMutex_;
     std::vector<TxHash> pendingTxRelay_;
     std::vector<BlockHash> pendingBlockRelay_;
+    
+    // Transactions received this round, with the peer that sent each
+    std::mutex pendingTxMutex_;
+    std::vector<std::pair<TransactionRef, Peer::Id>> pendingTxs_;
+    
+    // Transactions waiting for their parents
+    OrphanPool orphans_;
+    
+    // Compact block state
+    struct CompactPeerState {
+        bool supported{false};       ///< Sent us sendcmpct
+        bool highBandwidth{false};   ///< Wants new blocks pushed
+    };
+    struct PendingCompactBlock {
+        Peer::Id peer;
+        PartiallyDownloadedBlock block;
+    };
+    mutable std::mutex compactMutex_;
+    std::map<Peer::Id, CompactPeerState> compactPeers_;
+    std::deque<Peer::Id> highBandwidthPeers_;   ///< Ours, longest-serving first
+    std::map<BlockHash, PendingCompactBlock> pendingCompact_;
+    
+    // Address relay: each peer's allowance and the addresses waiting for
+    // it. A peer with addresses waiting has a timer in the wheel, keyed by
+    // its id, in milliseconds since addrEpoch_.
+    struct AddrRelayState {
+        AddrTokenBucket allowance;
+        std::vector<PeerAddress> queued;
+    };
+    std::mutex addrMutex_;
+    std::map<Peer::Id, AddrRelayState> addrRelay_;
+    util::TimerWheel addrTimers_;
+    const std::chrono::steady_clock::time_point addrEpoch_{std::chrono::steady_clock::now()};
+    const uint64_t addrSalt0_;   ///< Keys the choice of peers to relay to
+    const uint64_t addrSalt1_;
+    
+    // Transaction reconciliation
+    TxReconciliationTracker reconciliation_;
+    size_t reconCursor_{0};   ///< Round robin over the peers we initiate with
+    
+    // Recently served block messages, newest last; peers syncing the same
+    // blocks share one copy of each
+    std::mutex servedBlocksMutex_;
+    std::deque<std::pair<BlockHash, OutboundMessage>> servedBlocks_;
 };
 
 // ============================================================================
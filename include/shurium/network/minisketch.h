@@ -0,0 +1,62 @@
+// SHURIUM - Set Sketches
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// PinSketch over GF(2^32), in the manner of minisketch. A sketch of
+// capacity c holds the odd power sums x, x^3, ..., x^(2c-1) of its
+// elements; adding an element twice removes it, so merging two sketches
+// (XOR) leaves a sketch of their symmetric difference. It decodes as long
+// as that difference has at most c elements.
+
+#ifndef SHURIUM_NETWORK_MINISKETCH_H
+#define SHURIUM_NETWORK_MINISKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace shurium {
+
+/// Bytes per sketch element on the wire
+static constexpr size_t MINISKETCH_ELEMENT_BYTES = 4;
+
+class Minisketch {
+public:
+    /// An empty sketch able to decode up to capacity differences
+    explicit Minisketch(size_t capacity = 0);
+
+    /// Number of differences the sketch can decode
+    size_t GetCapacity() const { return sums_.size(); }
+
+    /// Toggle an element; 0 cannot be represented and is ignored
+    void Add(uint32_t element);
+
+    /// Combine with a sketch of the same capacity, leaving the symmetric
+    /// difference of their sets
+    bool Merge(const Minisketch& other);
+
+    /// Capacity x 4 bytes, little endian
+    std::vector<uint8_t> Serialize() const;
+
+    /// Read a serialized sketch; its capacity is the byte count / 4
+    static std::optional<Minisketch> Deserialize(const std::vector<uint8_t>& data);
+
+    /**
+     * Recover the elements, if there are at most maxElements of them
+     * (and at most the capacity). Fails when the set is too big to be
+     * recovered from this sketch.
+     */
+    std::optional<std::vector<uint32_t>> Decode(size_t maxElements) const;
+
+    /// Same, up to the capacity
+    std::optional<std::vector<uint32_t>> Decode() const { return Decode(GetCapacity()); }
+
+private:
+    /// Odd power sums s1, s3, ..., s(2c-1)
+    std::vector<uint32_t> sums_;
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_NETWORK_MINISKETCH_H
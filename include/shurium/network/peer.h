@@ -4,20 +4,118 @@
 #pragma once
 
 #include <shurium/network/address.h>
+#include <shurium/network/compression.h>
+#include <shurium/network/inventory_filter.h>
 #include <shurium/network/protocol.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <set>
+#include <optional>
 #include <string>
 #include <unordered_set>
 
 namespace shurium {
 
+// ============================================================================
+// Send Queue
+// ============================================================================
+
+/// Send classes, most urgent first
+enum class SendPriority : uint8_t {
+    HIGH = 0,     ///< New-block relay; not held back by rate limits
+    NORMAL = 1,   ///< Everything else
+    BULK = 2,     ///< Historical blocks served to syncing peers
+};
+
+/// Number of SendPriority classes
+static constexpr size_t SEND_PRIORITY_COUNT = 3;
+
+/// Count bytes copied from one network buffer into another: socket reads
+/// into a connection, a connection into a peer's framing, flattened sends.
+/// Paths that hand buffers on without copying don't count.
+void RecordNetworkCopy(size_t bytes);
+
+/// Bytes counted by RecordNetworkCopy, all peers together
+uint64_t GetNetworkBytesCopied();
+
+/**
+ * Outgoing bytes as a queue of SendBuffers. Buffers are queued and written
+ * where they are, so a partial write only moves an offset and a buffer
+ * shared with other queues is never copied. Not thread-safe; the owner
+ * locks.
+ *
+ * Each priority class is a queue of its own. The most urgent class with
+ * data is sent first, but a message once begun is finished before another
+ * class gets a byte, so messages never interleave on the wire.
+ */
+class SendQueue {
+public:
+    /// A run of unsent bytes
+    struct Segment {
+        const uint8_t* data;
+        size_t size;
+
+        /// The buffer the run lies in, for senders that must keep it alive
+        /// past the send (zero-copy)
+        const SendBuffer* buffer{nullptr};
+    };
+    
+    /// Queue a buffer (empty ones are skipped). A message whose header and
+    /// payload are separate buffers is pushed with endsMessage false for
+    /// all but its last buffer.
+    void Push(SendBuffer buffer, SendPriority priority = SendPriority::NORMAL,
+              bool endsMessage = true);
+    
+    /// Queue everything in other, class by class, leaving it empty
+    void Append(SendQueue&& other);
+    
+    /// Unsent bytes
+    size_t Size() const { return bytes_; }
+    bool Empty() const { return bytes_ == 0; }
+    
+    /// Unsent bytes of one class
+    size_t Size(SendPriority priority) const;
+    
+    /// Buffers still (partly) unsent
+    size_t BufferCount() const;
+    
+    /// Class the next bytes come from: the one with a message under way,
+    /// else the most urgent with data
+    SendPriority Current() const;
+    
+    /// Fill out with the first unsent runs of the current class, for a
+    /// gather write. They stay valid until consumed, whatever is queued
+    /// behind them.
+    /// @return Number of segments filled
+    size_t Peek(Segment* out, size_t maxSegments) const;
+    
+    /// Drop the first n unsent bytes of the current class (n no more than
+    /// Peek() handed out)
+    void Consume(size_t n);
+    
+    /// Copy out and drop up to maxBytes
+    std::vector<uint8_t> Pop(size_t maxBytes);
+    
+private:
+    struct Lane {
+        std::deque<SendBuffer> buffers;
+        size_t frontOffset{0};          // Bytes of the front buffer already sent
+        std::deque<size_t> messages;    // Unsent bytes of each message
+        bool messageOpen{false};        // Last push did not end its message
+        size_t frontMessageSent{0};     // Bytes of the front message already sent
+        size_t bytes{0};
+    };
+    
+    std::array<Lane, SEND_PRIORITY_COUNT> lanes_;
+    size_t bytes_{0};
+    int midMessage_{-1};    // Lane with a message partly sent, or -1
+};
+
 // ============================================================================
 // Connection Types
 // ============================================================================
@@ -91,6 +189,17 @@ struct PeerStats {
     
     /// Misbehavior score (for DoS protection)
     int32_t misbehaviorScore{0};
+    
+    /// Last time the peer gave us a block or transaction we took
+    int64_t lastBlockTime{0};
+    int64_t lastTxTime{0};
+    
+    /// Whether we compress messages to the peer
+    bool fCompressing{false};
+    
+    /// Payload bytes compression kept off the wire, both ways
+    uint64_t compressionSavedSent{0};
+    uint64_t compressionSavedRecv{0};
 };
 
 // ============================================================================
@@ -116,6 +225,12 @@ public:
     using StateHandler = std::function<void(Peer&, PeerState oldState, 
                                             PeerState newState)>;
     
+    /// Callback for data newly queued to send
+    using SendReadyHandler = std::function<void(Peer&)>;
+    
+    /// Callback for a change in what inbound eviction ranks the peer by
+    using ActivityHandler = std::function<void(Peer&)>;
+    
     // ========================================================================
     // Construction
     // ========================================================================
@@ -270,10 +385,23 @@ public:
     /// Record message received  
     void RecordMessageReceived();
     
+    /// Record a block or transaction from the peer that we took
+    void RecordBlockRelayed();
+    void RecordTxRelayed();
+    
+    /// Called, outside the peer's locks, when the handshake completes, a
+    /// pong is measured, or a block or transaction is recorded. Replacing
+    /// the handler waits out a call in progress.
+    void SetActivityHandler(ActivityHandler handler);
+    
     // ========================================================================
     // Inventory Tracking
     // ========================================================================
     
+    // Both directions are remembered in fixed memory (see InventoryFilter):
+    // a transaction may rarely test as known when it is not, and items
+    // seen long ago are eventually forgotten.
+    
     /// Check if we've announced an inventory item to this peer
     bool HasAnnounced(const Inv& inv) const;
     
@@ -319,6 +447,13 @@ public:
     
     /// Queue data for sending
     void QueueSend(const std::vector<uint8_t>& data);
+    void QueueSend(std::vector<uint8_t>&& data);
+    
+    /// Queue a shared buffer for sending, without copying it
+    void QueueSend(SendBuffer buffer);
+    
+    /// Queue a message's header and shared payload, in a send class
+    void QueueSend(const OutboundMessage& msg, SendPriority priority = SendPriority::NORMAL);
     
     /// Queue a message for sending
     template<typename T>
@@ -327,19 +462,50 @@ public:
     /// Queue a message with no payload
     void QueueMessage(const std::string& command);
     
-    /// Get data from send buffer (for socket write)
+    /// Called, outside the send lock, whenever something is queued, so the
+    /// connection can take it. Replacing the handler waits out a call in
+    /// progress, after which the old one is never called again.
+    void SetSendReadyHandler(SendReadyHandler handler);
+    
+    /// The peer can decode compressed messages: compress what we send it
+    /// from now on, as the policy says
+    void EnableCompression(CompressionPolicy policy);
+    
+    /// Whether we compress messages to this peer
+    bool IsCompressing() const;
+    
+    /// We told the peer we decode compressed messages, so accept them
+    /// (before this a compressed message is a protocol error)
+    void AcceptCompressed() { acceptCompressed_.store(true); }
+    
+    /// Get data from send buffer (copied out)
     std::vector<uint8_t> GetSendData(size_t maxBytes);
     
+    /// Take everything queued, buffers and all, for a socket write
+    SendQueue TakeSendQueue();
+    
     /// Check if there's data to send
     bool HasDataToSend() const;
     
-    /// Add received data to buffer
-    void AddReceivedData(const std::vector<uint8_t>& data);
+    /// Bytes waiting to be sent
+    size_t GetSendQueueSize() const;
     
-    /// Try to extract a complete message from receive buffer
-    /// @return pair of (command, payload) or nullopt if incomplete
+    /// Frame received bytes into messages as they arrive. Headers are
+    /// parsed in place and payload bytes are written once, into the vector
+    /// GetNextMessage() hands out; a bad header or checksum disconnects.
+    /// Compressed payloads are expanded here, so handlers never see them.
+    void AddReceivedData(const uint8_t* data, size_t len);
+    void AddReceivedData(const std::vector<uint8_t>& data) {
+        AddReceivedData(data.data(), data.size());
+    }
+    
+    /// Take the next complete message
+    /// @return pair of (command, payload) or nullopt if none is complete
     std::optional<std::pair<std::string, std::vector<uint8_t>>> GetNextMessage();
     
+    /// Complete messages waiting for GetNextMessage()
+    size_t GetReceivedMessageCount() const;
+    
 private:
     // Private constructor - use factory methods
     Peer(Id id, const NetService& addr, ConnectionType type);
@@ -351,6 +517,12 @@ private:
     /// Change state and notify handler
     void SetState(PeerState newState);
     
+    /// Tell the send-ready handler, if any, that data was queued
+    void NotifySendReady();
+    
+    /// Tell the activity handler, if any, that eviction metrics changed
+    void NotifyActivity();
+    
     // ========================================================================
     // Member Variables
     // ========================================================================
@@ -379,16 +551,27 @@ private:
     
     // Inventory tracking
     mutable std::mutex invMutex_;
-    std::set<Inv> announcedToUs_;     // Items peer told us about
-    std::set<Inv> announcedByUs_;     // Items we told peer about
+    InventoryFilter announcedToUs_;   // Items peer told us about
+    InventoryFilter announcedByUs_;   // Items we told peer about
     std::deque<Inv> announcementQueue_; // Items queued for announcement
     
     // Send/receive buffers
     mutable std::mutex sendMutex_;
-    std::deque<uint8_t> sendBuffer_;
+    SendQueue sendQueue_;
+    std::optional<CompressionPolicy> sendCompression_;
+    std::atomic<bool> acceptCompressed_{false};
+    std::mutex sendReadyMutex_;
+    SendReadyHandler sendReadyHandler_;
+    std::mutex activityMutex_;
+    ActivityHandler activityHandler_;
     
     mutable std::mutex recvMutex_;
-    std::deque<uint8_t> recvBuffer_;
+    std::array<uint8_t, MESSAGE_HEADER_SIZE> recvHeaderBytes_{};
+    size_t recvHeaderSize_{0};           // Header bytes of the next message so far
+    std::optional<MessageHeader> recvHeader_;  // Set while its payload arrives
+    std::vector<uint8_t> recvPayload_;
+    std::deque<std::pair<std::string, std::vector<uint8_t>>> recvMessages_;
+    bool recvFailed_{false};
     
     // Network magic for this peer (set during handshake)
     std::array<uint8_t, 4> networkMagic_{NetworkMagic::MAINNET};
@@ -409,8 +592,7 @@ void Peer::QueueMessage(const std::string& command, const T& payload) {
     // for types without it - caller must use appropriate types
     payload.Serialize(stream);
     std::vector<uint8_t> payloadBytes(stream.begin(), stream.end());
-    auto msg = CreateMessage(networkMagic_, command, payloadBytes);
-    QueueSend(msg);
+    QueueSend(CreateOutboundMessage(networkMagic_, command, std::move(payloadBytes)));
 }
 
 } // namespace shurium
@@ -10,6 +10,9 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -40,12 +43,22 @@ constexpr size_t MAX_INV_SZ = 50000;
 /// Maximum headers per message
 constexpr size_t MAX_HEADERS_RESULTS = 2000;
 
+/// Maximum filters answered to one getcfilters
+constexpr uint32_t MAX_GETCFILTERS_SIZE = 1000;
+
+/// Maximum filter hashes answered to one getcfheaders
+constexpr uint32_t MAX_GETCFHEADERS_SIZE = 2000;
+
 /// Maximum addresses in an addr message
 constexpr size_t MAX_ADDR_TO_SEND = 1000;
 
 /// Message type field size (null-padded)
 constexpr size_t MESSAGE_TYPE_SIZE = 12;
 
+/// Set in the last byte of a message's command when its payload is
+/// compressed; commands are ASCII, so the bit is otherwise clear
+constexpr uint8_t MESSAGE_COMPRESSED_FLAG = 0x80;
+
 /// Message header size
 constexpr size_t MESSAGE_HEADER_SIZE = 4 + 12 + 4 + 4;  // magic + type + size + checksum
 
@@ -95,6 +108,27 @@ namespace NetMsgType {
     constexpr const char* GETHEADERS = "getheaders";
     constexpr const char* HEADERS = "headers";
     
+    // Compact blocks
+    constexpr const char* SENDCMPCT = "sendcmpct";
+    constexpr const char* CMPCTBLOCK = "cmpctblock";
+    constexpr const char* GETBLOCKTXN = "getblocktxn";
+    constexpr const char* BLOCKTXN = "blocktxn";
+    
+    // Compact block filters (BIP157)
+    constexpr const char* GETCFILTERS = "getcfilters";
+    constexpr const char* CFILTER = "cfilter";
+    constexpr const char* GETCFHEADERS = "getcfheaders";
+    constexpr const char* CFHEADERS = "cfheaders";
+    
+    // Transaction reconciliation
+    constexpr const char* SENDTXRCNCL = "sendtxrcncl";
+    constexpr const char* REQRECON = "reqrecon";
+    constexpr const char* SKETCH = "sketch";
+    constexpr const char* RECONCILDIFF = "reconcildiff";
+    
+    // Payload compression
+    constexpr const char* SENDCOMPR = "sendcompr";
+    
     // Transactions
     constexpr const char* TX = "tx";
     constexpr const char* MEMPOOL = "mempool";
@@ -125,6 +159,7 @@ enum class InvType : uint32_t {
     MSG_TX = 1,           ///< Transaction
     MSG_BLOCK = 2,        ///< Block
     MSG_FILTERED_BLOCK = 3, ///< Merkle block (for SPV)
+    MSG_CMPCT_BLOCK = 4,  ///< Compact block (getdata only)
     
     // SHURIUM-specific
     MSG_POUW_SOLUTION = 16,   ///< PoUW solution
@@ -226,7 +261,19 @@ public:
     
     /// Get command name as string (up to null terminator)
     std::string GetCommand() const {
-        return std::string(command.data(), strnlen(command.data(), MESSAGE_TYPE_SIZE));
+        std::array<char, MESSAGE_TYPE_SIZE> name = command;
+        name.back() = static_cast<char>(static_cast<uint8_t>(name.back()) & ~MESSAGE_COMPRESSED_FLAG);
+        return std::string(name.data(), strnlen(name.data(), MESSAGE_TYPE_SIZE));
+    }
+    
+    /// Whether the payload is compressed (flag in the command's last byte)
+    bool IsCompressed() const {
+        return (static_cast<uint8_t>(command.back()) & MESSAGE_COMPRESSED_FLAG) != 0;
+    }
+    
+    /// Mark the payload compressed; call after SetCommand
+    void SetCompressed() {
+        command.back() = static_cast<char>(static_cast<uint8_t>(command.back()) | MESSAGE_COMPRESSED_FLAG);
     }
     
     /// Check if header is valid (size limits)
@@ -384,6 +431,38 @@ public:
     }
 };
 
+// ============================================================================
+// Send Compact Message
+// ============================================================================
+
+/**
+ * Send compact message - announces compact block support. With
+ * highBandwidth set, the sender wants new blocks pushed as cmpctblock
+ * before it has asked for them.
+ */
+class SendCmpctMessage {
+public:
+    bool highBandwidth{false};
+    uint64_t version{1};
+    
+    SendCmpctMessage() = default;
+    SendCmpctMessage(bool hb, uint64_t v) : highBandwidth(hb), version(v) {}
+    
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, highBandwidth);
+        ::shurium::Serialize(s, version);
+    }
+    
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        uint8_t hb;
+        ::shurium::Unserialize(s, hb);
+        highBandwidth = hb != 0;
+        ::shurium::Unserialize(s, version);
+    }
+};
+
 // ============================================================================
 // Reject Message (deprecated but useful for debugging)
 // ============================================================================
@@ -463,6 +542,89 @@ public:
 
 using GetHeadersMessage = GetBlocksMessage;
 
+// ============================================================================
+// Compact Block Filter Messages
+// ============================================================================
+
+/**
+ * GetCFilters message - request the filters of the blocks from startHeight
+ * up to stopHash on stopHash's chain. getcfheaders asks for the same range.
+ */
+class GetCFiltersMessage {
+public:
+    uint8_t filterType{0};
+    uint32_t startHeight{0};
+    Hash256 stopHash;
+    
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, filterType);
+        ::shurium::Serialize(s, startHeight);
+        ::shurium::Serialize(s, stopHash);
+    }
+    
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, filterType);
+        ::shurium::Unserialize(s, startHeight);
+        ::shurium::Unserialize(s, stopHash);
+    }
+};
+
+using GetCFHeadersMessage = GetCFiltersMessage;
+
+/**
+ * CFilter message - one block's filter, answering getcfilters.
+ */
+class CFilterMessage {
+public:
+    uint8_t filterType{0};
+    Hash256 blockHash;
+    std::vector<uint8_t> filter;
+    
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, filterType);
+        ::shurium::Serialize(s, blockHash);
+        ::shurium::Serialize(s, filter);
+    }
+    
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, filterType);
+        ::shurium::Unserialize(s, blockHash);
+        ::shurium::Unserialize(s, filter);
+    }
+};
+
+/**
+ * CFHeaders message - the filter header before a range and the filter
+ * hashes in it, from which the client chains the range's headers.
+ */
+class CFHeadersMessage {
+public:
+    uint8_t filterType{0};
+    Hash256 stopHash;
+    Hash256 prevHeader;
+    std::vector<Hash256> filterHashes;
+    
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, filterType);
+        ::shurium::Serialize(s, stopHash);
+        ::shurium::Serialize(s, prevHeader);
+        ::shurium::Serialize(s, filterHashes);
+    }
+    
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, filterType);
+        ::shurium::Unserialize(s, stopHash);
+        ::shurium::Unserialize(s, prevHeader);
+        ::shurium::Unserialize(s, filterHashes);
+    }
+};
+
 // ============================================================================
 // Addr Message
 // ============================================================================
@@ -508,6 +670,43 @@ std::vector<uint8_t> CreateMessage(const std::array<uint8_t, 4>& magic,
                                     const std::string& command,
                                     const std::vector<uint8_t>& payload);
 
+/// Serialize just the header of a message with this payload
+std::vector<uint8_t> CreateMessageHeader(const std::array<uint8_t, 4>& magic,
+                                         const std::string& command,
+                                         const std::vector<uint8_t>& payload);
+
+/// Immutable outgoing bytes, shared by every send queue holding them
+using SendBuffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+/**
+ * A message kept as its header and payload, so that one serialized payload
+ * (a block) can be queued to many peers without being copied or hashed
+ * again for each of them.
+ */
+struct OutboundMessage {
+    SendBuffer header;
+    SendBuffer payload;
+    std::string command;
+    
+    /// Compressed form, made by the first peer that asks for it and shared
+    /// from then on
+    struct Compressed {
+        std::once_flag once;
+        SendBuffer header;    ///< Null if compressing did not pay
+        SendBuffer payload;
+    };
+    std::shared_ptr<Compressed> compressed;
+};
+
+/// Build the header for a payload, taking ownership of the payload
+OutboundMessage CreateOutboundMessage(const std::array<uint8_t, 4>& magic,
+                                      const std::string& command,
+                                      std::vector<uint8_t> payload);
+
+/// The compressed header and payload of a message (same magic), compressing
+/// on first use; nullopt if compression would not make the payload smaller
+std::optional<OutboundMessage> GetCompressedMessage(const OutboundMessage& msg);
+
 /// Parse message header from bytes
 std::optional<MessageHeader> ParseMessageHeader(const std::vector<uint8_t>& data);
 
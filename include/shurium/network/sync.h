@@ -19,6 +19,7 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -49,6 +50,27 @@ enum class SyncState {
 /// Convert sync state to string
 const char* SyncStateToString(SyncState state);
 
+// ============================================================================
+// Download Window
+// ============================================================================
+
+/// Blocks past the first missing one that may be requested; the window
+/// moves on as its first block arrives
+static constexpr size_t BLOCK_DOWNLOAD_WINDOW = 1024;
+
+/// How long the block holding back a full window may sit with one peer
+/// before it is also asked of the fastest peer with room
+static constexpr int BLOCK_STALLING_TIMEOUT_MS = 2000;
+
+/// In-flight limit of a peer we have not measured yet
+static constexpr size_t INITIAL_BLOCKS_IN_FLIGHT = 4;
+
+/// In-flight limit never goes below this, however slow the peer
+static constexpr size_t MIN_BLOCKS_IN_FLIGHT = 2;
+
+/// Weight of each new sample in the smoothed rate and block size
+static constexpr double DOWNLOAD_RATE_SMOOTHING = 0.2;
+
 // ============================================================================
 // Download Statistics
 // ============================================================================
@@ -132,6 +154,46 @@ struct PeerSyncState {
     
     /// Blocks we've requested from this peer
     std::set<Hash256> requestedBlocks;
+    
+    /// Blocks this peer answered notfound for; not asked again until it
+    /// announces them
+    std::set<Hash256> notFoundBlocks;
+    
+    /// Blocks received from this peer, and their bytes
+    uint64_t blocksDownloaded{0};
+    uint64_t bytesDownloaded{0};
+    
+    /// Smoothed download rate (bytes per second), 0 until measured
+    double bytesPerSec{0.0};
+    
+    /// Smoothed size of the blocks this peer sends
+    double avgBlockBytes{0.0};
+    
+    /// Round trip time (milliseconds): the ping latency once known,
+    /// until then the quickest block response
+    double rttMs{0.0};
+    bool rttFromPing{false};
+    
+    /// Blocks this peer may have in flight, sized to cover its
+    /// bandwidth x RTT
+    size_t inFlightLimit{INITIAL_BLOCKS_IN_FLIGHT};
+    
+    /// Window blocks this peer held back until a faster one was asked
+    uint64_t stalls{0};
+    
+    /// Time the last block from this peer arrived
+    std::chrono::steady_clock::time_point lastBlockReceived;
+};
+
+/// Download figures for one peer, as reported by getpeerinfo
+struct PeerDownloadStats {
+    size_t blocksInFlight{0};
+    size_t inFlightLimit{0};
+    uint64_t blocksDownloaded{0};
+    uint64_t bytesDownloaded{0};
+    double bytesPerSec{0.0};
+    double rttMs{0.0};
+    uint64_t stalls{0};
 };
 
 // ============================================================================
@@ -145,6 +207,26 @@ struct BlockRequest {
     std::chrono::steady_clock::time_point requestTime;
     int32_t height{0};
     bool received{false};
+    
+    /// Peer first asked, when the block was taken from it as a staller;
+    /// whichever of the two delivers first completes the request
+    Peer::Id stalledPeer{-1};
+};
+
+// ============================================================================
+// Headers Outcome
+// ============================================================================
+
+/// What the chain made of a headers message
+struct HeadersOutcome {
+    /// Leading headers that passed validation
+    size_t accepted{0};
+    
+    /// Height of the best header afterwards (-1 if unknown)
+    int32_t bestHeaderHeight{-1};
+    
+    /// Accepted headers whose blocks we lack, in chain order
+    std::vector<Hash256> missingBlocks;
 };
 
 // ============================================================================
@@ -158,16 +240,30 @@ struct BlockRequest {
  * 1. Download headers to find the best chain
  * 2. Download blocks in parallel from multiple peers
  * 3. Verify and connect blocks to the chain
+ *
+ * Header download runs ahead of block download: a full headers message is
+ * answered with the next getheaders straight away, and the blocks of the
+ * headers accepted join the download order behind those already queued.
+ *
+ * Blocks are fetched within a moving window over the download order, so
+ * that they arrive close to the order they are connected in. Peers are
+ * served fastest first, each up to an in-flight limit adapted from its
+ * measured rate and RTT. When the window is full and its first block sits
+ * with a slow peer, that block is asked of the fastest peer with room too.
  */
 class BlockSynchronizer {
 public:
-    /// Callback for new headers
-    using HeaderCallback = std::function<bool(const std::vector<BlockHeader>& headers, 
-                                               Peer::Id fromPeer)>;
+    /// Callback validating new headers; hashes are those of the headers
+    using HeaderCallback = std::function<HeadersOutcome(const std::vector<BlockHeader>& headers,
+                                                        const std::vector<BlockHash>& hashes,
+                                                        Peer::Id fromPeer)>;
     
     /// Callback for new blocks
     using BlockCallback = std::function<bool(const Block& block, Peer::Id fromPeer)>;
     
+    /// Callback run on a received block before it is handed to BlockCallback
+    using BlockPrefetchCallback = std::function<void(const Block& block)>;
+    
     /// Callback for requesting data from peers
     using RequestCallback = std::function<void(Peer::Id peerId, 
                                                 const std::string& command,
@@ -178,7 +274,8 @@ public:
     
     explicit BlockSynchronizer(size_t maxBlocksInFlight = 1024,
                                size_t maxBlocksPerPeer = 16,
-                               int blockTimeoutSec = 60);
+                               int blockTimeoutSec = 60,
+                               size_t downloadWindow = BLOCK_DOWNLOAD_WINDOW);
     ~BlockSynchronizer();
     
     // ========================================================================
@@ -217,11 +314,23 @@ public:
     /// Get sync state for a peer
     const PeerSyncState* GetPeerState(Peer::Id id) const;
     
+    /// Record a peer's ping round trip, used to size its in-flight limit
+    void UpdatePeerLatency(Peer::Id id, int64_t pingMs);
+    
+    /// Download figures for a peer, if it is known
+    std::optional<PeerDownloadStats> GetPeerDownloadStats(Peer::Id id) const;
+    
     // ========================================================================
     // Message Processing
     // ========================================================================
     
-    /// Process received headers message
+    /**
+     * Process received headers message: hash the headers as a batch, have
+     * the chain validate them, queue the blocks it lacks, and ask the same
+     * peer for more if the message was full.
+     *
+     * @return false if a header was rejected
+     */
     bool ProcessHeaders(Peer::Id fromPeer, const std::vector<BlockHeader>& headers);
     
     /// Process received block message
@@ -250,6 +359,9 @@ public:
     /// Force resync from a specific height
     void ResyncFrom(int32_t height);
     
+    /// How long the window's first block may sit with one peer
+    void SetStallingTimeout(std::chrono::milliseconds timeout) { stallingTimeout_ = timeout; }
+    
     // ========================================================================
     // Statistics
     // ========================================================================
@@ -273,6 +385,9 @@ public:
     /// Set block received callback
     void SetBlockCallback(BlockCallback cb) { blockCallback_ = std::move(cb); }
     
+    /// Set callback that warms caches for a block about to be processed
+    void SetBlockPrefetchCallback(BlockPrefetchCallback cb) { prefetchCallback_ = std::move(cb); }
+    
     /// Set request callback
     void SetRequestCallback(RequestCallback cb) { requestCallback_ = std::move(cb); }
     
@@ -308,6 +423,9 @@ private:
     /// Schedule block downloads
     void ScheduleBlockDownloads();
     
+    /// Send getdata for blocks already recorded as requested
+    void SendBlockRequest(Peer::Id peerId, const std::vector<Hash256>& hashes);
+    
     /// Check for stalled peers
     void CheckStalls();
     
@@ -320,10 +438,44 @@ private:
     /// Cleanup completed/stale requests
     void CleanupRequests();
     
+    // The helpers below expect peersMutex_ and requestsMutex_ held, taken
+    // in that order
+    
+    /// Add a block to the end of the download order
+    void EnqueueBlock(const Hash256& hash);
+    
+    /// Put a block taken back from a peer into the queue by its place in
+    /// the download order
+    void RequeueBlock(const Hash256& hash);
+    
+    /// Whether a queued block lies inside the download window
+    bool InWindow(const Hash256& hash) const;
+    
+    /// Drop received blocks off the front of the window
+    void AdvanceWindow();
+    
+    /// Record a block request to a peer
+    void MarkRequested(PeerSyncState& state, Peer::Id peerId, const Hash256& hash,
+                       std::chrono::steady_clock::time_point now);
+    
+    /// Take a block back from a peer: the other peer asked keeps it,
+    /// otherwise it goes back to the front of the queue
+    void ReleaseRequest(Peer::Id peerId, PeerSyncState* state, const Hash256& hash);
+    
+    /// Fold a delivered block into the peer's rate, RTT and limit
+    void RecordDelivery(PeerSyncState& state, size_t bytes,
+                        std::chrono::steady_clock::time_point requestTime,
+                        std::chrono::steady_clock::time_point now);
+    
+    /// In-flight limit covering the peer's bandwidth x RTT
+    size_t ComputeInFlightLimit(const PeerSyncState& state) const;
+    
     // Configuration
     size_t maxBlocksInFlight_{1024};
     size_t maxBlocksPerPeer_{16};
     int blockTimeoutSec_{60};
+    size_t downloadWindow_{BLOCK_DOWNLOAD_WINDOW};
+    std::chrono::milliseconds stallingTimeout_{BLOCK_STALLING_TIMEOUT_MS};
     
     // Sync state
     std::atomic<SyncState> state_{SyncState::NOT_SYNCING};
@@ -346,12 +498,16 @@ private:
     mutable std::mutex requestsMutex_;
     std::map<Hash256, BlockRequest> pendingRequests_;
     std::deque<Hash256> downloadQueue_;  // Blocks to download
+    std::deque<Hash256> window_;         // Download order, until received
+    std::map<Hash256, uint64_t> windowPos_; // Position of each in window_
+    uint64_t windowBase_{0};             // Position of window_.front()
     std::set<Hash256> downloadedBlocks_; // Successfully downloaded
     std::set<Hash256> verifiedBlocks_;   // Verified by consensus
     
     // Callbacks
     HeaderCallback headerCallback_;
     BlockCallback blockCallback_;
+    BlockPrefetchCallback prefetchCallback_;
     RequestCallback requestCallback_;
     StateCallback stateCallback_;
 };
@@ -0,0 +1,304 @@
+// SHURIUM - Transaction Reconciliation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Erlay-style (BIP330) transaction relay. Instead of an inv per transaction
+// per peer, each peer gets a reconciliation set of the transactions we
+// would have announced to it. Now and then the side that made the
+// connection asks for a sketch of the other side's set, merges it with a
+// sketch of its own and learns the difference in one round trip. Only a
+// few peers still get every transaction flooded to them, so that
+// transactions cross the network quickly.
+
+#ifndef SHURIUM_NETWORK_TXRECONCILIATION_H
+#define SHURIUM_NETWORK_TXRECONCILIATION_H
+
+#include <shurium/core/serialize.h>
+#include <shurium/core/types.h>
+#include <shurium/network/minisketch.h>
+#include <shurium/network/peer.h>
+
+#include <cstdint>
+#include <ios>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Reconciliation protocol version we speak (sendtxrcncl)
+static constexpr uint32_t TXRECONCILIATION_VERSION = 1;
+
+/// Expected share of the smaller set that the other side lacks, before
+/// anything has been measured
+static constexpr double RECON_DEFAULT_Q = 0.25;
+
+/// q travels as q x Q_PRECISION in 16 bits, so q stays within [0, 2]
+static constexpr uint16_t RECON_Q_PRECISION = (2 << 14) - 1;
+
+/// Largest sketch built; decoding one stays within tens of milliseconds.
+/// Bigger differences fall back to announcing the whole set
+static constexpr size_t MAX_SKETCH_CAPACITY = 128;
+
+/// Transactions a peer's set holds before new ones are flooded to it
+static constexpr size_t MAX_RECON_SET_SIZE = 3000;
+
+/// Outbound reconciling peers each transaction is still flooded to
+static constexpr size_t OUTBOUND_FANOUT_DESTINATIONS = 1;
+
+/// Share of inbound reconciling peers each transaction is flooded to
+static constexpr double INBOUND_FANOUT_RATIO = 0.1;
+
+/// Milliseconds between reconciliations we start, across all peers
+static constexpr int RECON_REQUEST_INTERVAL_MS = 2000;
+
+// ============================================================================
+// Messages
+// ============================================================================
+
+/// Announces reconciliation support and our half of the short id salt;
+/// sent between version and verack
+class SendTxRcnclMessage {
+public:
+    uint32_t version{TXRECONCILIATION_VERSION};
+    uint64_t salt{0};
+
+    SendTxRcnclMessage() = default;
+    SendTxRcnclMessage(uint32_t v, uint64_t s) : version(v), salt(s) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, version);
+        ::shurium::Serialize(s, salt);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, version);
+        ::shurium::Unserialize(s, salt);
+    }
+};
+
+/// Initiator asks for a sketch: the size of its set and its q estimate
+class ReqReconMessage {
+public:
+    uint16_t setSize{0};
+    uint16_t q{0};
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, setSize);
+        ::shurium::Serialize(s, q);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        ::shurium::Unserialize(s, setSize);
+        ::shurium::Unserialize(s, q);
+    }
+};
+
+/// Responder's sketch of its set
+class SketchMessage {
+public:
+    std::vector<uint8_t> sketch;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, sketch);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        uint64_t size = ReadCompactSize(s);
+        if (size > MAX_SKETCH_CAPACITY * MINISKETCH_ELEMENT_BYTES) {
+            throw std::ios_base::failure("sketch too large");
+        }
+        sketch.resize(static_cast<size_t>(size));
+        for (auto& byte : sketch) {
+            ::shurium::Unserialize(s, byte);
+        }
+    }
+};
+
+/// Initiator's verdict: on success, the short ids it wants announced
+class ReconcilDiffMessage {
+public:
+    bool success{false};
+    std::vector<uint32_t> askShortIds;
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ::shurium::Serialize(s, success);
+        ::shurium::Serialize(s, askShortIds);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        uint8_t flag;
+        ::shurium::Unserialize(s, flag);
+        success = flag != 0;
+        uint64_t count = ReadCompactSize(s);
+        if (count > MAX_SKETCH_CAPACITY) {
+            throw std::ios_base::failure("too many reconciliation short ids");
+        }
+        askShortIds.resize(static_cast<size_t>(count));
+        for (auto& id : askShortIds) {
+            ::shurium::Unserialize(s, id);
+        }
+    }
+};
+
+// ============================================================================
+// Tracker
+// ============================================================================
+
+/// Outcome of registering a peer's sendtxrcncl
+enum class ReconRegisterResult {
+    SUCCESS,
+    NOT_FOUND,            ///< We did not offer reconciliation to this peer
+    ALREADY_REGISTERED,
+    PROTOCOL_VIOLATION    ///< Unsupported version
+};
+
+/// What the initiator does once a sketch has been decoded (or not)
+struct ReconciliationOutcome {
+    ReconcilDiffMessage diff;            ///< Reply to the responder
+    std::vector<TxHash> announce;        ///< Transactions to inv to it
+};
+
+/// Counters for getnetworkinfo-style reporting
+struct ReconciliationStats {
+    uint64_t succeeded{0};
+    uint64_t failed{0};
+    uint64_t differences{0};   ///< Transactions the sketches turned up
+};
+
+/**
+ * Per-peer reconciliation state: who initiates, the salted short id key,
+ * each peer's set, and the snapshot a responder keeps until the diff.
+ *
+ * Thread-safe.
+ */
+class TxReconciliationTracker {
+public:
+    TxReconciliationTracker();
+
+    /// Pick our salt for a peer we are offering reconciliation to
+    uint64_t PreRegisterPeer(Peer::Id id);
+
+    /// Complete registration from the peer's sendtxrcncl. The side that
+    /// opened the connection initiates.
+    ReconRegisterResult RegisterPeer(Peer::Id id, bool isPeerInbound,
+                                     uint32_t peerVersion, uint64_t peerSalt);
+
+    /// Drop all state for a peer
+    void ForgetPeer(Peer::Id id);
+
+    /// Whether a peer completed registration
+    bool IsPeerRegistered(Peer::Id id) const;
+
+    /// Whether we start reconciliations with this peer
+    bool IsInitiator(Peer::Id id) const;
+
+    /**
+     * Hold a transaction for the next reconciliation with a peer.
+     *
+     * @return false if the peer is not registered or its set is full;
+     *         announce by inv instead
+     */
+    bool AddToSet(Peer::Id id, const TxHash& txid);
+
+    /// The peer has the transaction already (it announced it to us)
+    void TryRemoveFromSet(Peer::Id id, const TxHash& txid);
+
+    /// Transactions waiting in a peer's set
+    size_t GetSetSize(Peer::Id id) const;
+
+    /**
+     * Of the registered peers, those a transaction is still flooded to:
+     * OUTBOUND_FANOUT_DESTINATIONS outbound ones and INBOUND_FANOUT_RATIO
+     * of the inbound ones, picked per transaction by a salted hash so
+     * that every peer is a flood peer for some transactions.
+     */
+    std::set<Peer::Id> GetFanoutTargets(const TxHash& txid,
+                                        const std::vector<Peer::Id>& outbound,
+                                        const std::vector<Peer::Id>& inbound) const;
+
+    // ========================================================================
+    // Initiator
+    // ========================================================================
+
+    /// The reqrecon to send a peer, if we initiate with it and no
+    /// reconciliation is under way
+    std::optional<ReqReconMessage> InitiateReconciliation(Peer::Id id);
+
+    /**
+     * Merge the responder's sketch with ours and work out what each side
+     * lacks. Empties our set for the peer. nullopt if the sketch came
+     * unasked.
+     */
+    std::optional<ReconciliationOutcome> HandleSketch(Peer::Id id, const SketchMessage& msg);
+
+    // ========================================================================
+    // Responder
+    // ========================================================================
+
+    /// Sketch our set for a peer that initiates with us; the set moves to
+    /// a snapshot until the diff. nullopt if the request is out of turn.
+    std::optional<SketchMessage> HandleReqRecon(Peer::Id id, const ReqReconMessage& msg);
+
+    /**
+     * Transactions of the snapshot to announce after the initiator's
+     * verdict: those asked for, or all of them when decoding failed.
+     * nullopt if no snapshot was waiting.
+     */
+    std::optional<std::vector<TxHash>> HandleReconcilDiff(Peer::Id id,
+                                                          const ReconcilDiffMessage& msg);
+
+    /// Short id of a transaction for a peer
+    uint32_t ComputeShortId(Peer::Id id, const TxHash& txid) const;
+
+    ReconciliationStats GetStats() const;
+
+private:
+    struct PeerState {
+        uint64_t localSalt{0};
+        bool registered{false};
+        bool weInitiate{false};
+        uint64_t k0{0};
+        uint64_t k1{0};
+
+        /// Transactions to reconcile next time
+        std::set<TxHash> localSet;
+
+        /// Initiator: reqrecon sent, sketch awaited
+        bool awaitingSketch{false};
+        size_t remoteSetSize{0};   ///< Responder: size the initiator reported
+        double q{RECON_DEFAULT_Q};
+
+        /// Responder: set as sketched, until the diff arrives
+        std::optional<std::set<TxHash>> snapshot;
+    };
+
+    uint32_t ShortIdLocked(const PeerState& state, const TxHash& txid) const;
+
+    mutable std::mutex mutex_;
+    std::map<Peer::Id, PeerState> peers_;
+    uint64_t fanoutK0_{0};   ///< Key for picking flood peers
+    uint64_t fanoutK1_{0};
+    ReconciliationStats stats_;
+};
+
+/// Sketch capacity for two sets of these sizes and a q estimate
+size_t EstimateSketchCapacity(size_t localSize, size_t remoteSize, double q);
+
+} // namespace shurium
+
+#endif // SHURIUM_NETWORK_TXRECONCILIATION_H
@@ -10,6 +10,7 @@
 
 #include "shurium/consensus/params.h"
 #include "shurium/chain/chainstate.h"
+#include "shurium/mempool/fees.h"
 #include "shurium/mempool/mempool.h"
 #include "shurium/db/blockdb.h"
 #include "shurium/db/utxodb.h"
@@ -17,11 +18,14 @@
 #include "shurium/network/sync.h"
 #include "shurium/network/message_processor.h"
 #include "shurium/network/addrman.h"
+#include "shurium/util/startup.h"
 
 #include <memory>
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <thread>
 
 namespace shurium {
 
@@ -32,13 +36,45 @@ class BlockSynchronizer;
 class MessageProcessor;
 class AddressManager;
 class Mempool;
+class TxIndexer;
+class BlockFilterIndexer;
 
 namespace db {
 class BlockDB;
 class CoinsViewDB;
 class TxIndex;
+class BlockFilterIndex;
 }
 
+// ============================================================================
+// Shutdown
+// ============================================================================
+
+/// Longest shutdown waits on saving peers, mempool and fee estimates
+static constexpr std::chrono::seconds SHUTDOWN_SAVE_DEADLINE{15};
+
+// ============================================================================
+// Database Cache Sizing
+// ============================================================================
+
+/// Physical memory, in percent, that an automatic -dbcache takes
+static constexpr int DBCACHE_RAM_PERCENT = 50;
+
+/// Memory in MB left to the rest of the node before that share is taken
+static constexpr int DBCACHE_RAM_RESERVE_MB = 2048;
+
+/// Smallest automatic -dbcache in MB
+static constexpr int MIN_AUTO_DBCACHE_MB = 450;
+
+/// Physical memory of this machine in bytes (0 if unknown)
+uint64_t GetTotalSystemMemory();
+
+/**
+ * -dbcache in MB for a machine with totalMemory bytes of RAM: half of
+ * what is left after the reserve, but never below MIN_AUTO_DBCACHE_MB.
+ */
+int GetAutoDbCacheMB(uint64_t totalMemory);
+
 // ============================================================================
 // Node Initialization Options
 // ============================================================================
@@ -54,12 +90,18 @@ struct NodeInitOptions {
     /// Network type (main, testnet, regtest)
     std::string network{"main"};
     
-    /// Database cache size in MB
-    int dbCacheMB{450};
+    /// Database cache size in MB (0 = size from physical memory)
+    int dbCacheMB{0};
+    
+    /// Memory for the UTXO outpoint filter in MB (0 = disabled)
+    int coinFilterMB{db::DEFAULT_COIN_FILTER_MB};
     
     /// Enable transaction index
     bool txIndex{false};
     
+    /// Enable the basic compact block filter index, served to peers
+    bool blockFilterIndex{false};
+    
     /// Reindex blockchain
     bool reindex{false};
     
@@ -72,6 +114,9 @@ struct NodeInitOptions {
     std::string bindAddress{"0.0.0.0"};
     uint16_t port{8333};
     int maxConnections{125};
+    uint64_t maxUploadTarget{0};       ///< Bytes per day, 0 = no target
+    uint64_t maxSendRatePerPeer{0};    ///< Bytes per second, 0 = unlimited
+    uint64_t maxSendRateTotal{0};      ///< Bytes per second, 0 = unlimited
     std::vector<std::string> addNodes;
     std::vector<std::string> connectNodes;
     bool dnsSeed{true};
@@ -82,12 +127,25 @@ struct NodeInitOptions {
     int miningThreads{1};
     std::string miningAddress;
     
+    /// Script verification threads (-par): 0 = one per core,
+    /// negative = leave that many cores free, 1 = verify serially
+    int scriptCheckThreads{DEFAULT_SCRIPTCHECK_THREADS};
+    
+    /// Thread placement (-threadaffinity): "role=cpulist" pins, and
+    /// autoThreadPlacement places the roles not listed by NUMA node
+    std::vector<std::string> threadAffinity;
+    bool autoThreadPlacement{true};
+    
     /// Whether to check blocks on startup
     bool checkBlocks{true};
     int checkLevel{3};
     
-    /// AssumeValid block hash (skip signature validation for blocks before this)
+    /// AssumeValid block hash (skip script validation for its ancestors);
+    /// empty = network default, "0" = verify all scripts
     std::string assumeValidBlock;
+    
+    /// Save the mempool to mempool.dat and load it again on startup
+    bool persistMempool{true};
 };
 
 // ============================================================================
@@ -126,6 +184,9 @@ struct NodeContext {
     /// Transaction index (optional, may be nullptr)
     std::unique_ptr<db::TxIndex> txIndex;
     
+    /// Basic block filter index (optional, may be nullptr)
+    std::unique_ptr<db::BlockFilterIndex> blockFilterIndex;
+    
     // ========================================================================
     // Chain State
     // ========================================================================
@@ -133,6 +194,12 @@ struct NodeContext {
     /// Chain state manager (owns active chain and UTXO cache)
     std::unique_ptr<ChainStateManager> chainman;
     
+    /// Background builder for txIndex (declared after chainman so it stops first)
+    std::unique_ptr<TxIndexer> txIndexer;
+    
+    /// Background builder for blockFilterIndex (declared after chainman so it stops first)
+    std::unique_ptr<BlockFilterIndexer> blockFilterIndexer;
+    
     // ========================================================================
     // Memory Pool
     // ========================================================================
@@ -140,6 +207,23 @@ struct NodeContext {
     /// Transaction memory pool
     std::unique_ptr<Mempool> mempool;
     
+    /// Fee estimator fed by the mempool, saved to fee_estimates.dat
+    std::unique_ptr<FeeEstimator> feeEstimator;
+    
+    /// Whether the mempool is saved at shutdown and periodically
+    bool persistMempool{false};
+    
+    /// Background load of the saved mempool, and its stop flag
+    std::thread mempoolLoader;
+    std::atomic<bool> mempoolLoadInterrupt{false};
+    
+    /// Set once the saved mempool is loaded; saving before then would drop
+    /// the transactions not loaded yet
+    std::atomic<bool> mempoolLoaded{false};
+    
+    /// Time of the last periodic mempool save
+    std::chrono::steady_clock::time_point lastMempoolDump;
+    
     // ========================================================================
     // Network
     // ========================================================================
@@ -169,6 +253,9 @@ struct NodeContext {
     /// Whether we're in reindex mode
     bool reindex{false};
     
+    /// Phase timings of this start and whether the node can serve
+    util::StartupProfile startup;
+    
     // ========================================================================
     // Paths
     // ========================================================================
@@ -209,7 +296,7 @@ struct NodeContext {
         return chainman ? chainman->GetActiveHeight() : -1;
     }
     
-    /// Check if node is ready for operations
+    /// Check if node is initialized (see startup for readiness to serve)
     bool IsReady() const {
         return initialized.load() && chainman != nullptr;
     }
@@ -258,12 +345,12 @@ bool StartSync(NodeContext& node);
 /**
  * Shutdown the node, stopping all subsystems.
  * 
- * This function:
- * 1. Stops P2P network
- * 2. Stops mining/staking
- * 3. Flushes mempool
- * 4. Flushes chain state to disk
- * 5. Closes databases
+ * Runs as stages of a util::ShutdownCoordinator, logging a timing breakdown:
+ * 1. Stops intake: network, indexers and the mempool loader, in parallel
+ * 2. Saves peers, mempool and fee estimates in parallel, giving up after
+ *    SHUTDOWN_SAVE_DEADLINE
+ * 3. Flushes chain state to disk (synchronously, no deadline)
+ * 4. Closes databases
  * 
  * @param node The node context to shutdown
  */
@@ -272,11 +359,23 @@ void ShutdownNode(NodeContext& node);
 /**
  * Flush node state to disk without shutting down.
  * 
+ * The UTXO cache is written on a background thread so block validation
+ * is not held up; shutdown performs a final blocking flush.
+ * 
  * @param node The node context
  * @return true if flush succeeded
  */
 bool FlushNodeState(NodeContext& node);
 
+/**
+ * Periodic upkeep, called about once a second: tells the coins cache how
+ * much memory the mempool takes, and writes the cache out in the
+ * background once no block has arrived for DEFAULT_COINS_IDLE_FLUSH_SECONDS.
+ * 
+ * @param node The node context
+ */
+void MaintainNodeState(NodeContext& node);
+
 // ============================================================================
 // Block Index Loading
 // ============================================================================
@@ -289,6 +388,17 @@ bool FlushNodeState(NodeContext& node);
  */
 int LoadBlockIndex(NodeContext& node);
 
+/**
+ * Rebuild the block index by replaying the block files (-reindex).
+ * 
+ * The stored index is ignored; every block in blk?????.dat is read back,
+ * checked and handed to the chain state manager in file order.
+ * 
+ * @param node The node context
+ * @return Number of blocks processed, or -1 on error
+ */
+int ReindexBlockFiles(NodeContext& node);
+
 /**
  * Verify block index integrity.
  * 
@@ -17,6 +17,7 @@
 #include <shurium/rpc/server.h>
 
 #include <chrono>
+#include <functional>
 #include <future>
 #include <memory>
 #include <optional>
@@ -127,9 +128,30 @@ public:
         return Call(method, JSONValue(params));
     }
     
-    /// Send batch request
+    /// Send batch request; responses come back in request order
     std::vector<RPCResponse> BatchCall(const std::vector<RPCRequest>& requests);
     
+    /// Fills in the next batch; false when there are no more
+    using BatchSource = std::function<bool(std::vector<RPCRequest>&)>;
+    
+    /// Takes a batch's responses, in request order
+    using BatchSink = std::function<void(const std::vector<RPCRequest>&,
+                                         std::vector<RPCResponse>&&)>;
+    
+    /**
+     * Send batches from source over one kept-alive connection, writing up
+     * to maxInFlight of them ahead of their answers (HTTP pipelining), and
+     * hand each batch's responses to sink in the order the batches were
+     * taken. Batches still unanswered when the server closes the connection
+     * are sent again on a new one; one that gets no answer twice running
+     * fails.
+     *
+     * @return false if the server could not be reached; the batches in
+     *         flight then get NETWORK_ERROR responses
+     */
+    bool PipelineBatches(const BatchSource& source, const BatchSink& sink,
+                         size_t maxInFlight);
+    
     // === Asynchronous Calls ===
     
     /// Async call
@@ -168,6 +190,9 @@ public:
     
     /// Get average response time (milliseconds)
     double GetAverageResponseTime() const;
+    
+    /// Get connections opened; calls per connection shows keep-alive reuse
+    uint64_t GetConnectionsOpened() const { return connectionsOpened_; }
 
 private:
     // === Internal Methods ===
@@ -175,6 +200,17 @@ private:
     /// Send raw request and receive response
     std::string SendRequest(const std::string& json);
     
+    /// Write all of data to the socket
+    bool SendAll(const std::string& data);
+    
+    /// Read the next response off the connection; nullopt if it closed
+    /// before any of it arrived
+    std::optional<std::string> ReadResponse();
+    
+    /// Responses to a batch, matched to the requests by id
+    std::vector<RPCResponse> ParseBatchResponse(const std::string& raw,
+                                                const std::vector<RPCRequest>& requests);
+    
     /// Build HTTP request
     std::string BuildHTTPRequest(const std::string& body);
     
@@ -203,6 +239,12 @@ private:
     int socket_{-1};
     std::mutex socketMutex_;
     
+    /// Responses read on the current connection (kept alive between calls)
+    size_t requestsOnConnection_{0};
+    
+    /// Received bytes not yet taken as a response (pipelined answers)
+    std::string recvBuffer_;
+    
     std::string lastError_;
     int lastErrorCode_{0};
     
@@ -210,6 +252,7 @@ private:
     std::atomic<uint64_t> totalCalls_{0};
     std::atomic<uint64_t> totalErrors_{0};
     std::atomic<int64_t> totalResponseTime_{0};
+    std::atomic<uint64_t> connectionsOpened_{0};
 };
 
 // ============================================================================
@@ -19,6 +19,7 @@
 #include <shurium/rpc/server.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -27,15 +28,19 @@ namespace shurium {
     class ChainState;
     class ChainStateManager;
     class Mempool;
+    class FeeEstimator;
     class MessageProcessor;
-    namespace db { class BlockDB; }
+    class TxIndexer;
+    class BlockFilterIndexer;
+    namespace db { class BlockDB; class CoinsViewDB; class TxIndex; }
     namespace wallet { class Wallet; }
     namespace identity { class IdentityManager; }
     namespace economics { class UBIDistributor; }
     namespace staking { class StakingEngine; }
     namespace governance { class GovernanceEngine; }
     namespace network { class NetworkManager; }
-    namespace miner { class Miner; }
+    namespace miner { class Miner; class BlockTemplateCache; }
+    namespace util { class StartupProfile; }
 }
 
 namespace shurium {
@@ -109,6 +114,24 @@ public:
     /// Set miner reference (for mining control)
     void SetMiner(miner::Miner* miner);
     
+    /// Set transaction indexer reference (for confirmed transaction lookup)
+    void SetTxIndexer(TxIndexer* txIndexer);
+    
+    /// Set fee estimator reference (for confirmation-based fee estimates)
+    void SetFeeEstimator(FeeEstimator* feeEstimator);
+    
+    /// Set UTXO database reference (for database statistics)
+    void SetCoinsDB(db::CoinsViewDB* coinsdb);
+    
+    /// Set transaction index database reference (for database statistics)
+    void SetTxIndex(db::TxIndex* txindex);
+    
+    /// Set block filter indexer reference (lets wallet rescans skip blocks)
+    void SetBlockFilterIndexer(BlockFilterIndexer* filterIndexer);
+    
+    /// Set the node's startup profile (for getnodereadiness)
+    void SetStartupProfile(const util::StartupProfile* profile);
+    
     // === Command Registration ===
     
     /// Register all commands with the server
@@ -135,6 +158,22 @@ public:
     db::BlockDB* GetBlockDB() const { return blockdb_.get(); }
     const std::string& GetDataDir() const { return dataDir_; }
     miner::Miner* GetMiner() const { return miner_; }
+    TxIndexer* GetTxIndexer() const { return txIndexer_; }
+    FeeEstimator* GetFeeEstimator() const { return feeEstimator_; }
+    db::CoinsViewDB* GetCoinsDB() const { return coinsdb_; }
+    db::TxIndex* GetTxIndex() const { return txindex_; }
+    BlockFilterIndexer* GetBlockFilterIndexer() const { return filterIndexer_; }
+    const util::StartupProfile* GetStartupProfile() const { return startupProfile_; }
+    
+    /// Server the commands were registered with (null before RegisterCommands)
+    RPCServer* GetRPCServer() const { return server_; }
+    
+    /// Template cache behind getblocktemplate, created on first use (null
+    /// without a chain state and mempool)
+    miner::BlockTemplateCache* GetBlockTemplateCache();
+    
+    /// Wake getblocktemplate long polls to look at a new tip
+    void NotifyBlockTip();
 
 private:
     // === Command Registration Helpers ===
@@ -164,6 +203,15 @@ private:
     MessageProcessor* msgproc_{nullptr};  // Not owned - raw pointer for optional ref
     std::string dataDir_;  // Data directory for wallet file paths
     miner::Miner* miner_{nullptr};  // Not owned - raw pointer for mining control
+    TxIndexer* txIndexer_{nullptr};  // Not owned - null without -txindex
+    FeeEstimator* feeEstimator_{nullptr};  // Not owned
+    db::CoinsViewDB* coinsdb_{nullptr};  // Not owned
+    db::TxIndex* txindex_{nullptr};  // Not owned - null without -txindex
+    BlockFilterIndexer* filterIndexer_{nullptr};  // Not owned - null without -blockfilterindex
+    const util::StartupProfile* startupProfile_{nullptr};  // Not owned
+    std::unique_ptr<miner::BlockTemplateCache> templateCache_;
+    std::mutex templateCacheMutex_;
+    RPCServer* server_{nullptr};  // Not owned
 };
 
 // ============================================================================
@@ -210,6 +258,14 @@ RPCResponse cmd_getmempoolinfo(const RPCRequest& req, const RPCContext& ctx,
 RPCResponse cmd_getrawmempool(const RPCRequest& req, const RPCContext& ctx,
                               RPCCommandTable* table);
 
+/// Save the mempool to a file
+RPCResponse cmd_savemempool(const RPCRequest& req, const RPCContext& ctx,
+                            RPCCommandTable* table);
+
+/// Load a saved mempool file
+RPCResponse cmd_loadmempool(const RPCRequest& req, const RPCContext& ctx,
+                            RPCCommandTable* table);
+
 /// Get transaction
 RPCResponse cmd_gettransaction(const RPCRequest& req, const RPCContext& ctx,
                                RPCCommandTable* table);
@@ -226,6 +282,26 @@ RPCResponse cmd_decoderawtransaction(const RPCRequest& req, const RPCContext& ct
 RPCResponse cmd_sendrawtransaction(const RPCRequest& req, const RPCContext& ctx,
                                    RPCCommandTable* table);
 
+/// Dump the UTXO set to a snapshot file
+RPCResponse cmd_dumptxoutset(const RPCRequest& req, const RPCContext& ctx,
+                             RPCCommandTable* table);
+
+/// Load a trusted UTXO snapshot file
+RPCResponse cmd_loadtxoutset(const RPCRequest& req, const RPCContext& ctx,
+                             RPCCommandTable* table);
+
+/// Get the rolling UTXO set hash
+RPCResponse cmd_gettxoutsetinfo(const RPCRequest& req, const RPCContext& ctx,
+                                RPCCommandTable* table);
+
+/// Get the status of the optional indexes
+RPCResponse cmd_getindexinfo(const RPCRequest& req, const RPCContext& ctx,
+                             RPCCommandTable* table);
+
+/// Get per-database engine metrics
+RPCResponse cmd_getdbstats(const RPCRequest& req, const RPCContext& ctx,
+                           RPCCommandTable* table);
+
 // ============================================================================
 // Network Commands
 // ============================================================================
@@ -326,6 +402,14 @@ RPCResponse cmd_dumpprivkey(const RPCRequest& req, const RPCContext& ctx,
 RPCResponse cmd_importprivkey(const RPCRequest& req, const RPCContext& ctx,
                               RPCCommandTable* table);
 
+/// Rescan the active chain for wallet transactions
+RPCResponse cmd_rescanblockchain(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table);
+
+/// Stop the wallet rescan in flight
+RPCResponse cmd_abortrescan(const RPCRequest& req, const RPCContext& ctx,
+                            RPCCommandTable* table);
+
 /// Lock wallet
 RPCResponse cmd_walletlock(const RPCRequest& req, const RPCContext& ctx,
                            RPCCommandTable* table);
@@ -550,10 +634,26 @@ RPCResponse cmd_stop(const RPCRequest& req, const RPCContext& ctx,
 RPCResponse cmd_uptime(const RPCRequest& req, const RPCContext& ctx,
                        RPCCommandTable* table);
 
+/// Startup phase timings and whether the node can serve
+RPCResponse cmd_getnodereadiness(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table);
+
+/// RPC server statistics, including the response cache
+RPCResponse cmd_getrpcinfo(const RPCRequest& req, const RPCContext& ctx,
+                           RPCCommandTable* table);
+
 /// Get memory info
 RPCResponse cmd_getmemoryinfo(const RPCRequest& req, const RPCContext& ctx,
                               RPCCommandTable* table);
 
+/// Per-opcode script execution profile (SHURIUM_SCRIPT_PROFILE builds)
+RPCResponse cmd_getscriptprofile(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table);
+
+/// Hot-path trace spans as Chrome trace JSON (SHURIUM_TRACING builds)
+RPCResponse cmd_dumptrace(const RPCRequest& req, const RPCContext& ctx,
+                          RPCCommandTable* table);
+
 /// Log level
 RPCResponse cmd_logging(const RPCRequest& req, const RPCContext& ctx,
                         RPCCommandTable* table);
@@ -574,6 +674,11 @@ RPCResponse cmd_createmultisig(const RPCRequest& req, const RPCContext& ctx,
 RPCResponse cmd_estimatefee(const RPCRequest& req, const RPCContext& ctx,
                             RPCCommandTable* table);
 
+/// Estimate fee from how fast recent transactions confirmed
+/// Returns: {feerate, blocks} or {errors, blocks} without enough data
+RPCResponse cmd_estimatesmartfee(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table);
+
 // ============================================================================
 // Fund Management Commands
 // ============================================================================
@@ -623,7 +728,7 @@ std::string ParseAddress(const std::string& str);
 /// Validate address format
 bool ValidateAddress(const std::string& address);
 
-/// Parse hex string
+/// Parse hex string; empty if it has odd length or a non-hex character
 std::vector<Byte> ParseHex(const std::string& hex);
 
 /// Format bytes as hex
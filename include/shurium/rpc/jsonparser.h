@@ -0,0 +1,123 @@
+// SHURIUM - Arena-Backed JSON Parser
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// In-situ JSON parser for RPC requests.
+//
+// JSONValue allocates a node per value and a std::map per object, which
+// dominates the cost of large batches such as thousands of hex-encoded
+// sendrawtransaction calls. JSONDocument instead parses into a flat DOM:
+// nodes live in a per-document arena, children of a container are stored
+// contiguously, and strings are views into the request text. Only strings
+// containing escapes are decoded, into the arena. String scanning uses SSE2
+// where the target has it.
+
+#ifndef SHURIUM_RPC_JSONPARSER_H
+#define SHURIUM_RPC_JSONPARSER_H
+
+#include <shurium/rpc/server.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shurium {
+namespace rpc {
+
+/// Deepest container nesting a JSONDocument accepts
+constexpr size_t MAX_JSON_DEPTH = 512;
+
+/**
+ * One value of a parsed JSONDocument.
+ *
+ * Views point into the parsed text or the document's arena, so a node is
+ * only valid while both are alive.
+ */
+struct JSONNode {
+    JSONValue::Type type{JSONValue::Type::Null};
+    bool boolValue{false};
+    int64_t intValue{0};
+    double doubleValue{0.0};
+
+    /// Decoded string value
+    std::string_view text;
+
+    /// Member name, for children of an object
+    std::string_view key;
+
+    /// Children of an array or object, stored contiguously
+    const JSONNode* children{nullptr};
+    size_t size{0};
+
+    bool IsNull() const { return type == JSONValue::Type::Null; }
+    bool IsString() const { return type == JSONValue::Type::String; }
+    bool IsArray() const { return type == JSONValue::Type::Array; }
+    bool IsObject() const { return type == JSONValue::Type::Object; }
+
+    const JSONNode* begin() const { return children; }
+    const JSONNode* end() const { return children + size; }
+
+    /// Object member by name; the last one wins, as with JSONValue
+    const JSONNode* Find(std::string_view name) const;
+
+    /// Copy this value into an owning JSONValue
+    JSONValue ToValue() const;
+};
+
+/**
+ * A parsed JSON text.
+ *
+ * The text passed to Parse() must outlive the document. A document can be
+ * reused; parsing again releases the previous tree.
+ */
+class JSONDocument {
+public:
+    JSONDocument();
+    ~JSONDocument();
+
+    JSONDocument(const JSONDocument&) = delete;
+    JSONDocument& operator=(const JSONDocument&) = delete;
+
+    /// Parse text; returns false if it is not a single valid JSON value
+    bool Parse(std::string_view text);
+
+    /// Root value of the last successful parse
+    const JSONNode& Root() const { return root_; }
+
+    /// Bytes held by the arena
+    size_t ArenaSize() const;
+
+private:
+    class Parser;
+
+    /// Uninitialized storage for n objects of T that lives until the next Parse
+    template <typename T>
+    T* Allocate(size_t n) {
+        return static_cast<T*>(AllocateBytes(n * sizeof(T), alignof(T)));
+    }
+    void* AllocateBytes(size_t size, size_t align);
+    void ResetArena();
+
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t capacity{0};
+    };
+    std::vector<Block> blocks_;
+    size_t blockUsed_{0};
+
+    /// Children of the containers currently being parsed
+    std::vector<JSONNode> scratch_;
+
+    /// Decoding space for strings with escapes
+    std::string unescaped_;
+
+    JSONNode root_;
+};
+
+} // namespace rpc
+} // namespace shurium
+
+#endif // SHURIUM_RPC_JSONPARSER_H
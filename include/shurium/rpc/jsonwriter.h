@@ -0,0 +1,120 @@
+// SHURIUM - Streaming JSON Writer
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Incremental JSON serializer for large RPC responses.
+//
+// Handlers that produce big results (full blocks, verbose mempool listings)
+// emit values straight into a JSONWriter instead of building a JSONValue
+// tree. The writer keeps a small buffer and hands it to a sink whenever it
+// grows past the flush threshold, so peak memory is bounded by the threshold
+// rather than by the size of the response.
+
+#ifndef SHURIUM_RPC_JSONWRITER_H
+#define SHURIUM_RPC_JSONWRITER_H
+
+#include <shurium/rpc/server.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shurium {
+namespace rpc {
+
+/// Default number of buffered bytes before the writer calls its sink
+constexpr size_t DEFAULT_JSON_FLUSH_SIZE = 64 * 1024;
+
+/**
+ * Writes compact JSON incrementally.
+ *
+ * Output is byte-for-byte what JSONValue::ToJSON() produces for the same
+ * values. Commas are inserted automatically; callers only open and close
+ * containers, name object members with Key() and write values. Without a
+ * sink everything accumulates in memory and can be retrieved with Take().
+ */
+class JSONWriter {
+public:
+    /// Receives serialized bytes; called from whichever thread writes
+    using Sink = std::function<void(const char* data, size_t size)>;
+
+    /// Buffer the whole document in memory
+    JSONWriter();
+
+    /// Pass output to sink each time flushThreshold bytes are buffered
+    explicit JSONWriter(Sink sink, size_t flushThreshold = DEFAULT_JSON_FLUSH_SIZE);
+
+    JSONWriter(const JSONWriter&) = delete;
+    JSONWriter& operator=(const JSONWriter&) = delete;
+
+    // Containers
+    JSONWriter& BeginObject();
+    JSONWriter& EndObject();
+    JSONWriter& BeginArray();
+    JSONWriter& EndArray();
+
+    /// Name the next member of the enclosing object
+    JSONWriter& Key(std::string_view key);
+
+    // Scalars
+    JSONWriter& Null();
+    JSONWriter& Bool(bool value);
+    JSONWriter& Int(int64_t value);
+    JSONWriter& Double(double value);
+    JSONWriter& String(std::string_view value);
+
+    /// A string of the lowercase hex of data, encoded straight into the
+    /// buffer (flushing as it goes) rather than built as a std::string
+    JSONWriter& HexString(const uint8_t* data, size_t len);
+
+    /// Serialize an already-built value in place
+    JSONWriter& Value(const JSONValue& value);
+
+    /// Shorthand for Key(key).Value(value)
+    JSONWriter& Member(std::string_view key, const JSONValue& value) {
+        return Key(key).Value(value);
+    }
+
+    /// Hand everything buffered so far to the sink (no-op without one)
+    void Flush();
+
+    /// Take the buffered output, leaving the writer's buffer empty
+    std::string Take();
+
+    /// Bytes currently buffered
+    size_t BufferedSize() const { return buffer_.size(); }
+
+    /// Total bytes produced, including those already flushed
+    size_t BytesWritten() const { return flushed_ + buffer_.size(); }
+
+    /// Append value to out as a quoted JSON string, escaped like ToJSON()
+    static void AppendEscaped(std::string& out, std::string_view value);
+
+private:
+    /// Emit the comma that separates this value from the previous one
+    void BeginValue();
+
+    /// Flush if the buffer has grown past the threshold
+    void MaybeFlush() {
+        if (sink_ && buffer_.size() >= flushThreshold_) Flush();
+    }
+
+    std::string buffer_;
+    Sink sink_;
+    size_t flushThreshold_{DEFAULT_JSON_FLUSH_SIZE};
+    size_t flushed_{0};
+
+    /// One entry per open container: true until its first element is written
+    std::vector<bool> firstInScope_;
+
+    /// A key was just written; the next value follows its colon
+    bool afterKey_{false};
+};
+
+} // namespace rpc
+} // namespace shurium
+
+#endif // SHURIUM_RPC_JSONWRITER_H
@@ -0,0 +1,65 @@
+// SHURIUM - Metrics and Readiness Endpoints
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Operational endpoints on the RPC port:
+//
+//   GET /metrics   util::MetricsRegistry in the Prometheus text format
+//   GET /ready     200 once the node can serve, 503 with the reasons before
+//
+// Both are unauthenticated. Metrics are off unless enabled; the samples are
+// operational counters and latencies, not wallet data. The readiness probe
+// only reports startup progress, so it is always served.
+
+#ifndef SHURIUM_RPC_METRICS_H
+#define SHURIUM_RPC_METRICS_H
+
+#include <shurium/rpc/server.h>
+
+namespace shurium {
+namespace util {
+class MetricsRegistry;
+class StartupProfile;
+}
+namespace rpc {
+
+/// Path of the metrics endpoint
+static constexpr const char* METRICS_PATH = "/metrics";
+
+/// Content type of a Prometheus text-format scrape
+static constexpr const char* METRICS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+/// Serve registry on server under METRICS_PATH
+void RegisterMetricsHandler(RPCServer& server, util::MetricsRegistry& registry);
+
+/// Stop serving the metrics endpoint
+void UnregisterMetricsHandler(RPCServer& server);
+
+/// Answer one metrics request (what the registered handler runs)
+void HandleMetricsRequest(const HTTPRequest& request, const util::MetricsRegistry& registry,
+                          HTTPReply& reply);
+
+/// Path of the readiness probe
+static constexpr const char* READINESS_PATH = "/ready";
+
+/**
+ * Readiness of the node as getnodereadiness returns it: "ready", the
+ * "blockers" keeping it from serving, "startup_ms" and a "phases" array
+ * of {name, state, ms}.
+ */
+JSONValue GetReadinessReport(const util::StartupProfile& profile);
+
+/// Serve profile's readiness on server under READINESS_PATH
+void RegisterReadinessHandler(RPCServer& server, const util::StartupProfile& profile);
+
+/// Stop serving the readiness probe
+void UnregisterReadinessHandler(RPCServer& server);
+
+/// Answer one readiness request (what the registered handler runs)
+void HandleReadinessRequest(const HTTPRequest& request, const util::StartupProfile& profile,
+                            HTTPReply& reply);
+
+} // namespace rpc
+} // namespace shurium
+
+#endif // SHURIUM_RPC_METRICS_H
@@ -0,0 +1,199 @@
+// SHURIUM - Push Notifications
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Pushes new blocks, transactions and UBI/governance events to subscribers
+// over WebSocket (RFC 6455), so wallets, explorers and indexers learn of
+// them as they happen instead of polling getbestblockhash and
+// getrawmempool.
+
+#ifndef SHURIUM_RPC_NOTIFY_H
+#define SHURIUM_RPC_NOTIFY_H
+
+#include "shurium/core/block.h"
+#include "shurium/core/transaction.h"
+#include "shurium/network/connection.h"
+#include "shurium/rpc/server.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace shurium {
+
+class BlockIndex;
+class ChainStateManager;
+
+namespace rpc {
+
+class JSONWriter;
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Default notification listen port
+static constexpr uint16_t DEFAULT_NOTIFY_PORT = 28332;
+
+/// Unsent bytes a subscriber may have queued before messages to it are
+/// dropped
+static constexpr size_t DEFAULT_NOTIFY_MAX_QUEUE = 8 * 1024 * 1024;
+
+/// Default limit on concurrent subscribers
+static constexpr size_t DEFAULT_NOTIFY_MAX_SUBSCRIBERS = 64;
+
+/// Largest frame a subscriber may send (only control frames are expected)
+static constexpr size_t MAX_NOTIFY_CLIENT_FRAME = 4 * 1024;
+
+/// Notification topics
+enum class NotifyTopic : uint8_t {
+    HASHBLOCK,      ///< Hash and height of each connected block
+    RAWBLOCK,       ///< Each connected block, serialized
+    HASHTX,         ///< Txid of each transaction entering the mempool
+    RAWTX,          ///< Each transaction entering the mempool, serialized
+    UBI,            ///< UBI epoch finalizations
+    GOVERNANCE,     ///< Parameter changes and protocol upgrades
+};
+
+/// Number of NotifyTopic values
+static constexpr size_t NOTIFY_TOPIC_COUNT = 6;
+
+/// Topic name as used in subscriptions and messages
+const char* NotifyTopicName(NotifyTopic topic);
+
+/// Topic with the given name
+std::optional<NotifyTopic> ParseNotifyTopic(const std::string& name);
+
+/**
+ * Value of the Sec-WebSocket-Accept header answering a handshake with the
+ * given Sec-WebSocket-Key.
+ */
+std::string WebSocketAcceptKey(const std::string& key);
+
+/// An unmasked server-to-client WebSocket frame
+std::vector<uint8_t> MakeWebSocketFrame(uint8_t opcode, const uint8_t* payload, size_t size);
+
+// ============================================================================
+// Notification Publisher
+// ============================================================================
+
+/**
+ * WebSocket notification server.
+ *
+ * A subscriber connects to ws://host:port/?topics=hashblock,rawtx (no
+ * topics means all of them) and receives one text frame per event:
+ *
+ *     {"data":...,"sequence":n,"topic":"hashblock"}
+ *
+ * where sequence counts the messages of that topic. Connections are served
+ * on one event loop thread. Publishing is safe from any thread and never
+ * waits on a subscriber: each message is encoded once into a shared buffer
+ * that is queued on every interested connection, and a subscriber whose
+ * unsent backlog would pass Options::maxQueueBytes misses the message
+ * instead. Missed messages are counted, and show up to the subscriber as
+ * a gap in the sequence.
+ */
+class NotificationPublisher {
+public:
+    struct Options {
+        uint16_t port{DEFAULT_NOTIFY_PORT};
+        std::string bindAddress{"127.0.0.1"};
+        size_t maxQueueBytes{DEFAULT_NOTIFY_MAX_QUEUE};
+        size_t maxSubscribers{DEFAULT_NOTIFY_MAX_SUBSCRIBERS};
+    };
+
+    struct TopicStats {
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    explicit NotificationPublisher(const Options& options);
+    ~NotificationPublisher();
+
+    NotificationPublisher(const NotificationPublisher&) = delete;
+    NotificationPublisher& operator=(const NotificationPublisher&) = delete;
+
+    /// Start listening; false if the address cannot be bound
+    bool Start();
+
+    /// Disconnect every subscriber and stop
+    void Stop();
+
+    bool IsRunning() const { return running_.load(); }
+
+    /// Port being listened on (the one chosen if Options::port was 0)
+    uint16_t GetPort() const;
+
+    /// Publish every block the chain connects until Stop()
+    void AttachChain(ChainStateManager& chainman);
+
+    /// Publish hashblock and rawblock for a connected block
+    void PublishBlock(const Block& block, const BlockIndex* index);
+
+    /// Publish hashtx and rawtx for a transaction
+    void PublishTransaction(const Transaction& tx);
+
+    /// Publish an event on a topic
+    void PublishEvent(NotifyTopic topic, const JSONValue& data);
+
+    /// True if some subscriber wants the topic, so callers can skip
+    /// building events nobody receives
+    bool HasSubscribers(NotifyTopic topic) const {
+        return subscribers_[static_cast<size_t>(topic)].load() > 0;
+    }
+
+    /// Number of subscribed connections
+    size_t GetSubscriberCount() const { return sessionCount_.load(); }
+
+    const TopicStats& GetStats(NotifyTopic topic) const {
+        return stats_[static_cast<size_t>(topic)];
+    }
+
+private:
+    struct Session;
+
+    const Options options_;
+    ChainStateManager* chainman_{nullptr};
+    int blockConnectedId_{-1};
+
+    std::unique_ptr<EventLoop> eventLoop_;
+    std::unique_ptr<Listener> listener_;
+    std::atomic<bool> running_{false};
+
+    // Event loop thread only
+    std::map<Connection*, std::unique_ptr<Session>> sessions_;
+
+    std::array<std::atomic<size_t>, NOTIFY_TOPIC_COUNT> subscribers_{};
+    std::array<std::atomic<uint64_t>, NOTIFY_TOPIC_COUNT> sequence_{};
+    std::array<TopicStats, NOTIFY_TOPIC_COUNT> stats_;
+    std::atomic<size_t> sessionCount_{0};
+
+    /// Orders sequence numbers with the messages posted to the event loop,
+    /// and keeps Stop() from pulling the loop out from under a publisher
+    std::mutex publishMutex_;
+
+    /// Encode a message whose data member writeData emits, and queue it
+    void Publish(NotifyTopic topic, const std::function<void(JSONWriter&)>& writeData);
+    void Deliver(NotifyTopic topic, SendBuffer frame);
+
+    void OnAccept(std::unique_ptr<Connection> conn);
+    void OnData(Session& session);
+    bool HandleHandshake(Session& session);
+    bool HandleFrames(Session& session);
+    void SendFrame(Session& session, uint8_t opcode, const uint8_t* payload, size_t size);
+    void Disconnect(Session& session);
+    void RemoveClosedSessions();
+    void SetSubscribed(Session& session, bool subscribed);
+};
+
+} // namespace rpc
+} // namespace shurium
+
+#endif // SHURIUM_RPC_NOTIFY_H
@@ -0,0 +1,59 @@
+// SHURIUM - REST Interface
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Unauthenticated, read-only HTTP endpoints for public chain data, served
+// on the RPC port. Block and header bodies are the stored bytes, so
+// explorers and indexers fetching whole blocks skip JSON and hex entirely:
+//
+//   GET /rest/block/<hash>.<bin|hex|json>
+//   GET /rest/headers/<count>/<hash>.<bin|hex|json>
+//   GET /rest/getutxos[/checkmempool]/<txid>-<n>[/<txid>-<n>...].<bin|hex|json>
+//
+// The json variants are meant for debugging; .json for a block is what
+// getblock returns at verbosity 2.
+
+#ifndef SHURIUM_RPC_REST_H
+#define SHURIUM_RPC_REST_H
+
+#include <shurium/rpc/server.h>
+
+#include <cstddef>
+
+namespace shurium {
+namespace rpc {
+
+class RPCCommandTable;
+
+/// Path prefix of every REST endpoint
+static constexpr const char* REST_PATH_PREFIX = "/rest/";
+
+/// Most headers one /rest/headers request returns
+static constexpr size_t MAX_REST_HEADERS = 2000;
+
+/// Most outpoints one /rest/getutxos request may ask about
+static constexpr size_t MAX_REST_GETUTXOS = 15;
+
+/// Response format of a REST request, chosen by its extension
+enum class RESTFormat {
+    BINARY,
+    HEX,
+    JSON,
+};
+
+/**
+ * Serve the REST endpoints on server, reading from the chain state, block
+ * database and mempool of table.
+ */
+void RegisterRESTHandlers(RPCServer& server, RPCCommandTable& table);
+
+/// Stop serving the REST endpoints
+void UnregisterRESTHandlers(RPCServer& server);
+
+/// Answer one REST request (what the registered handler runs)
+void HandleRESTRequest(const HTTPRequest& request, RPCCommandTable& table, HTTPReply& reply);
+
+} // namespace rpc
+} // namespace shurium
+
+#endif // SHURIUM_RPC_REST_H
@@ -6,6 +6,8 @@
 //
 // Features:
 // - HTTP and Unix socket transports
+// - HTTP/1.1 persistent connections, pipelining and chunked responses
+// - Event-driven connection handling; workers see only complete requests
 // - Authentication support
 // - Rate limiting
 // - SSL/TLS support (optional)
@@ -20,6 +22,7 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
@@ -33,12 +36,19 @@
 #include <vector>
 
 namespace shurium {
+
+class Connection;
+class EventLoop;
+class Listener;
+
 namespace rpc {
 
 // Forward declarations
 class RPCServer;
 class RPCRequest;
 class RPCResponse;
+class JSONWriter;
+struct JSONNode;
 
 // ============================================================================
 // JSON Value - Simple JSON representation
@@ -224,6 +234,9 @@ public:
     
     /// Parse batch of requests
     static std::vector<RPCRequest> ParseBatch(const std::string& json);
+    
+    /// Build from an already-parsed request object
+    static std::optional<RPCRequest> FromNode(const JSONNode& node);
 
 private:
     std::string method_;
@@ -237,12 +250,24 @@ private:
 
 /**
  * Represents a JSON-RPC 2.0 response.
+ *
+ * A success response either carries its result as a JSONValue or, for large
+ * results, a writer function that emits the result into a JSONWriter when
+ * the response is serialized. Streamed results are never held in memory as
+ * a tree unless GetResult() is called.
  */
 class RPCResponse {
 public:
+    /// Emits a result value into a writer
+    using ResultWriter = std::function<void(JSONWriter&)>;
+    
     /// Create success response
     static RPCResponse Success(const JSONValue& result, const JSONValue& id);
     
+    /// Create success response whose result is written on serialization.
+    /// The writer must own everything it reads and may run more than once.
+    static RPCResponse Streamed(ResultWriter writer, const JSONValue& id);
+    
     /// Create error response
     static RPCResponse Error(int code, const std::string& message,
                             const JSONValue& id, const JSONValue& data = JSONValue());
@@ -250,8 +275,11 @@ public:
     /// Check if response is an error
     bool IsError() const { return isError_; }
     
-    /// Get result (for success responses)
-    const JSONValue& GetResult() const { return result_; }
+    /// Get result (for success responses); builds streamed results on demand
+    const JSONValue& GetResult() const;
+    
+    /// Whether the result is produced by a writer function
+    bool IsStreamed() const { return static_cast<bool>(resultWriter_); }
     
     /// Get error code
     int GetErrorCode() const { return errorCode_; }
@@ -268,12 +296,20 @@ public:
     /// Serialize to JSON
     std::string ToJSON() const;
     
+    /// Serialize into a writer
+    void WriteJSON(JSONWriter& out) const;
+    
     /// Serialize batch responses
     static std::string BatchToJSON(const std::vector<RPCResponse>& responses);
+    
+    /// Serialize batch responses into a writer
+    static void WriteBatchJSON(const std::vector<RPCResponse>& responses, JSONWriter& out);
 
 private:
     bool isError_{false};
-    JSONValue result_;
+    mutable JSONValue result_;
+    ResultWriter resultWriter_;
+    mutable bool resultBuilt_{false};
     int errorCode_{0};
     std::string errorMessage_;
     JSONValue errorData_;
@@ -304,6 +340,21 @@ struct RPCContext {
 /// RPC method handler function type
 using RPCHandler = std::function<RPCResponse(const RPCRequest&, const RPCContext&)>;
 
+/**
+ * When the server may answer a method from its response cache.
+ *
+ * An entry is reused while it is younger than ttl and generation() still
+ * returns the value it had when the entry was stored. A write in the same
+ * category also drops the category's entries.
+ */
+struct RPCCachePolicy {
+    /// Longest an answer is reused; zero disables caching
+    std::chrono::milliseconds ttl{0};
+    
+    /// Version of the state the answer depends on (tip, mempool, ...)
+    std::function<uint64_t()> generation;
+};
+
 /**
  * RPC method registration info.
  */
@@ -316,6 +367,12 @@ struct RPCMethod {
     bool requiresWallet{false};
     std::vector<std::string> argNames;
     std::vector<std::string> argDescriptions;
+    
+    /// Changes no state, so calls in a batch may run concurrently
+    bool readOnly{false};
+    
+    /// Response caching; off unless a ttl is set
+    RPCCachePolicy cache{};
 };
 
 // ============================================================================
@@ -365,19 +422,86 @@ struct RPCServerConfig {
     /// Max requests per minute per client
     size_t maxRequestsPerMinute{600};
     
-    /// Thread pool size
+    /// Worker threads executing requests
     size_t threadPoolSize{4};
     
     /// Max request body size (bytes)
     size_t maxRequestSize{10 * 1024 * 1024};  // 10 MB
+    
+    /// Seconds an idle persistent connection is kept open
+    int keepAliveTimeout{30};
+    
+    /// Requests served on one connection before it is closed (0 = no limit)
+    size_t maxRequestsPerConnection{0};
+    
+    /// Responses to HTTP/1.1 clients larger than this go out chunked
+    size_t chunkedResponseThreshold{1024 * 1024};
+    
+    /// Most answers kept in the response cache (0 disables it)
+    size_t responseCacheSize{1024};
+};
+
+// ============================================================================
+// HTTP Framing
+// ============================================================================
+
+/// One HTTP request taken off a connection
+struct HTTPRequest {
+    std::string method;
+    std::string target;
+    int versionMinor{1};                          ///< x of HTTP/1.x
+    std::map<std::string, std::string> headers;   ///< Names in lower case
+    std::string body;
+    bool keepAlive{true};                         ///< Connection stays open after it
+};
+
+/// Outcome of framing a request from received bytes
+enum class HTTPFrameResult {
+    COMPLETE,
+    INCOMPLETE,     ///< Need more bytes
+    BAD_REQUEST,
+    TOO_LARGE       ///< Headers or body over the limit
+};
+
+/**
+ * Frame the first request in buffer. Requests follow each other on a
+ * persistent connection, so the body is exactly Content-Length bytes
+ * (none without one); consumed is set to the bytes the request took, and
+ * whatever follows is the next, pipelined request.
+ */
+HTTPFrameResult FrameHTTPRequest(const std::string& buffer, size_t maxBodySize,
+                                 HTTPRequest& request, size_t& consumed);
+
+/// Answer to a plain HTTP request served outside JSON-RPC
+struct HTTPReply {
+    int status{200};
+    std::string contentType{"application/json"};
+    std::vector<uint8_t> body;
+    
+    /// Set a text body
+    void SetBody(int statusCode, const std::string& type, const std::string& text) {
+        status = statusCode;
+        contentType = type;
+        body.assign(text.begin(), text.end());
+    }
 };
 
+/// Answers GET requests under a path prefix (on a worker thread)
+using HTTPHandler = std::function<void(const HTTPRequest& request, HTTPReply& reply)>;
+
 // ============================================================================
 // RPC Server
 // ============================================================================
 
 /**
  * JSON-RPC 2.0 server.
+ *
+ * One thread runs an EventLoop over the listening socket and every client
+ * connection, reading into per-connection buffers. Only a complete request
+ * is handed to the worker pool, so a slow or idle client costs a buffer,
+ * not a worker. A connection has at most one request with the workers at
+ * a time; its pipelined requests wait in its buffer, in order. When the
+ * pool's queue is full the request waits too, instead of being refused.
  */
 class RPCServer {
 public:
@@ -431,6 +555,16 @@ public:
     /// Get methods by category
     std::vector<RPCMethod> GetMethodsByCategory(const std::string& category) const;
     
+    // === HTTP Handlers ===
+    
+    /// Serve GET requests whose target starts with prefix through handler
+    /// instead of JSON-RPC. They are not authenticated, so handlers must
+    /// only expose public, read-only data.
+    void RegisterHTTPHandler(const std::string& prefix, HTTPHandler handler);
+    
+    /// Stop serving a prefix
+    void UnregisterHTTPHandler(const std::string& prefix);
+    
     // === Request Handling ===
     
     /// Process a single request (for testing or internal use)
@@ -439,6 +573,11 @@ public:
     /// Process raw JSON request
     std::string HandleRawRequest(const std::string& json, const RPCContext& context);
     
+    /// Process raw JSON request, writing the response into out. Nothing is
+    /// written when the request is a notification.
+    void HandleRawRequest(const std::string& json, const RPCContext& context,
+                          JSONWriter& out);
+    
     // === Statistics ===
     
     /// Get total requests handled
@@ -450,30 +589,85 @@ public:
     /// Get active connections
     size_t GetActiveConnections() const { return activeConnections_.load(); }
     
+    /// Get connections accepted since start
+    uint64_t GetTotalConnections() const { return totalConnections_.load(); }
+    
     /// Get uptime in seconds
     int64_t GetUptime() const;
+    
+    /// Calls answered from the response cache
+    uint64_t GetCacheHits() const { return cacheHits_.load(); }
+    
+    /// Calls to cacheable methods that had to run
+    uint64_t GetCacheMisses() const { return cacheMisses_.load(); }
+    
+    /// Fraction of cacheable calls answered from the cache
+    double GetCacheHitRate() const;
+    
+    /// Answers currently cached
+    size_t GetCacheSize() const;
+    
+    /// Drop every cached answer
+    void ClearResponseCache();
 
 private:
     // === Internal Methods ===
     
-    /// HTTP server thread
+    /// Per-connection state, owned by the event loop thread
+    struct HTTPSession;
+    
+    /// Event loop thread: I/O, dispatch and timeouts
     void HTTPServerThread();
     
-    /// Handle HTTP connection
-    void HandleConnection(int clientSocket);
+    /// Take on an accepted connection (event loop thread)
+    void AcceptConnection(std::unique_ptr<Connection> conn);
+    
+    /// Hand the session's next complete request to a worker, answer a
+    /// malformed one, or leave it to wait for more bytes (event loop thread)
+    void DispatchRequest(const std::shared_ptr<HTTPSession>& session);
+    
+    /// A worker queued its response (event loop thread)
+    void OnResponseQueued(const std::shared_ptr<HTTPSession>& session, bool keepAlive);
+    
+    /// Close finished, idle and stalled connections (event loop thread)
+    void SweepSessions();
+    
+    /// Drop a session and give its buffer back to the pool
+    void CloseSession(Connection* conn);
+    
+    /// Answer one request (worker); keepAlive is cleared if the
+    /// connection must close after it
+    void ServeHTTPRequest(Connection& conn, const HTTPRequest& request,
+                          const RPCContext& baseContext, bool& keepAlive);
+    
+    /// Handler registered for a request target, or null
+    HTTPHandler FindHTTPHandler(const std::string& target) const;
     
-    /// Parse HTTP request
-    bool ParseHTTPRequest(const std::string& raw, std::string& body, 
-                         std::map<std::string, std::string>& headers);
+    /// Answer a request through an HTTP handler (worker)
+    void ServeHTTPHandler(Connection& conn, const HTTPRequest& request, const HTTPHandler& handler,
+                          const RPCContext& context, bool keepAlive);
+    
+    /// Queue a response, chunked if large and the client speaks HTTP/1.1
+    void SendHTTPResponse(Connection& conn, int statusCode, const std::string& body,
+                          bool keepAlive, bool allowChunked,
+                          const std::string& contentType = "application/json");
     
     /// Build HTTP response
     std::string BuildHTTPResponse(int statusCode, const std::string& body,
-                                 const std::string& contentType = "application/json");
+                                 const std::string& contentType = "application/json",
+                                 bool keepAlive = false);
     
     /// Authenticate request
     bool Authenticate(const std::map<std::string, std::string>& headers,
                      std::string& username);
     
+    /// Run batch entries [begin, end), all read-only, concurrently on the
+    /// worker pool; the calling thread takes part, so this never waits on
+    /// a queued task
+    void RunReadOnlyBatch(const std::vector<std::optional<RPCRequest>>& requests,
+                          std::vector<RPCResponse>& responses, size_t begin, size_t end,
+                          const RPCContext& context);
+    
     /// Check rate limit
     bool CheckRateLimit(const std::string& clientAddress);
     
@@ -487,14 +681,25 @@ private:
     std::map<std::string, RPCMethod> methods_;
     mutable std::mutex methodsMutex_;
     
+    // Plain HTTP handlers by path prefix
+    std::vector<std::pair<std::string, HTTPHandler>> httpHandlers_;
+    mutable std::mutex httpHandlersMutex_;
+    
     // Server threads
     std::thread httpThread_;
-    int serverSocket_{-1};
+    std::unique_ptr<EventLoop> eventLoop_;
+    std::unique_ptr<Listener> listener_;
+    
+    // Event loop thread only
+    std::unordered_map<Connection*, std::shared_ptr<HTTPSession>> sessions_;
+    std::deque<std::shared_ptr<HTTPSession>> waitingForWorker_;
+    std::vector<std::string> bufferPool_;
     
     // Statistics
     std::atomic<uint64_t> totalRequests_{0};
     std::atomic<uint64_t> totalErrors_{0};
     std::atomic<size_t> activeConnections_{0};
+    std::atomic<uint64_t> totalConnections_{0};
     std::chrono::steady_clock::time_point startTime_;
     
     // Rate limiting
@@ -505,8 +710,20 @@ private:
     std::unordered_map<std::string, RateLimitEntry> rateLimits_;
     std::mutex rateLimitMutex_;
     
-    // Thread pool for handling connections
+    // Thread pool executing complete requests
     std::unique_ptr<util::ThreadPool> threadPool_;
+    
+    // Response cache, keyed on method and serialized params
+    struct CachedResponse {
+        JSONValue result;
+        std::string category;
+        uint64_t generation{0};
+        std::chrono::steady_clock::time_point expires;
+    };
+    std::unordered_map<std::string, CachedResponse> responseCache_;
+    mutable std::mutex cacheMutex_;
+    std::atomic<uint64_t> cacheHits_{0};
+    std::atomic<uint64_t> cacheMisses_{0};
 };
 
 // ============================================================================
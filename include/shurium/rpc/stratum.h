@@ -0,0 +1,228 @@
+// SHURIUM - Stratum Mining Server
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Serves the node's block templates to mining hardware over Stratum v1
+// (line-delimited JSON-RPC over TCP), so miners can work on the node
+// directly instead of through separate pool software.
+
+#ifndef SHURIUM_RPC_STRATUM_H
+#define SHURIUM_RPC_STRATUM_H
+
+#include "shurium/miner/templatecache.h"
+#include "shurium/network/connection.h"
+#include "shurium/rpc/server.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace shurium {
+
+class ChainStateManager;
+class MessageProcessor;
+
+namespace rpc {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Default Stratum listen port
+static constexpr uint16_t DEFAULT_STRATUM_PORT = 3333;
+
+/// Extranonce bytes chosen by the server, one value per connection
+static constexpr size_t STRATUM_EXTRANONCE1_SIZE = 4;
+
+/// Extranonce bytes each miner rolls inside its own extranonce1
+static constexpr size_t STRATUM_EXTRANONCE2_SIZE = 4;
+
+/// Share difficulty given to new connections
+static constexpr double DEFAULT_STRATUM_DIFFICULTY = 1.0;
+
+/// Seconds between jobs while the tip stays the same, so miners pick up
+/// new transactions without being interrupted for every one
+static constexpr int64_t STRATUM_JOB_INTERVAL = 30;
+
+/// Jobs kept for late shares; a new tip drops them all
+static constexpr size_t MAX_STRATUM_JOBS = 8;
+
+/// Longest request line a client may send
+static constexpr size_t MAX_STRATUM_LINE = 16 * 1024;
+
+/// Stratum error codes
+enum class StratumError : int {
+    OTHER = 20,
+    JOB_NOT_FOUND = 21,
+    DUPLICATE_SHARE = 22,
+    LOW_DIFFICULTY = 23,
+    UNAUTHORIZED = 24,
+    NOT_SUBSCRIBED = 25,
+};
+
+// ============================================================================
+// Jobs
+// ============================================================================
+
+/**
+ * A block template cut up for Stratum. The coinbase is serialized with an
+ * 8-byte extranonce push at the end of its scriptSig; coinb1 and coinb2 are
+ * the bytes on either side of it, so a miner rebuilds the coinbase as
+ * coinb1 + extranonce1 + extranonce2 + coinb2 and walks the template's
+ * coinbaseMerkleBranch up to the header's merkle root.
+ */
+struct StratumJob {
+    std::string id;
+    std::shared_ptr<const miner::BlockTemplate> tmpl;
+    std::vector<uint8_t> coinb1;
+    std::vector<uint8_t> coinb2;
+
+    /// Work on older jobs is worthless (the tip moved)
+    bool cleanJobs{false};
+
+    /// Shares seen for this job, to refuse resubmissions
+    std::set<std::string> shares;
+
+    /// The job as mining.notify parameters
+    JSONValue ToNotifyParams() const;
+};
+
+/**
+ * Cut a template into a job.
+ * @return false if the coinbase does not end its scriptSig with the
+ *         extranonce push the block assembler reserves
+ */
+bool MakeStratumJob(const std::string& id, std::shared_ptr<const miner::BlockTemplate> tmpl,
+                    StratumJob& job);
+
+/// Share target of a Stratum difficulty (difficulty 1 is nBits 0x1d00ffff)
+Hash256 StratumDifficultyToTarget(double difficulty);
+
+// ============================================================================
+// Stratum Server
+// ============================================================================
+
+/**
+ * Stratum v1 server.
+ *
+ * Connections are served on one event loop thread. Each connection gets its
+ * own extranonce1, so no two miners search the same space, and shares are
+ * checked against the job they name with the header midstate kernel. A
+ * share that also meets the block target is assembled into a block and
+ * submitted to the chain. A second thread builds jobs from the template
+ * cache: a new tip is pushed to every miner at once (with clean_jobs set),
+ * other template changes at most every STRATUM_JOB_INTERVAL.
+ */
+class StratumServer {
+public:
+    using BlockFoundCallback = std::function<void(const Block& block, bool accepted)>;
+
+    struct Options {
+        uint16_t port{DEFAULT_STRATUM_PORT};
+        double difficulty{DEFAULT_STRATUM_DIFFICULTY};
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> sharesAccepted{0};
+        std::atomic<uint64_t> sharesRejected{0};
+        std::atomic<uint64_t> blocksFound{0};
+        std::atomic<uint64_t> jobsSent{0};
+    };
+
+    /// payoutScript is paid the coinbase of every block found
+    StratumServer(ChainStateManager& chainman, Mempool& mempool,
+                  const consensus::Params& params, const Script& payoutScript,
+                  const Options& options);
+    ~StratumServer();
+
+    StratumServer(const StratumServer&) = delete;
+    StratumServer& operator=(const StratumServer&) = delete;
+
+    /// Start listening; false if the port cannot be bound
+    bool Start();
+
+    /// Disconnect every miner and stop
+    void Stop();
+
+    bool IsRunning() const { return running_.load(); }
+
+    /// Port being listened on (the one chosen if Options::port was 0)
+    uint16_t GetPort() const;
+
+    /// Relay found blocks to peers through this processor
+    void SetMessageProcessor(MessageProcessor* msgproc) { msgproc_ = msgproc; }
+
+    /// Called after each found block is submitted
+    void SetBlockFoundCallback(BlockFoundCallback callback);
+
+    /// Push a fresh job now (the tip moved)
+    void NotifyNewTip();
+
+    /// Number of connected miners
+    size_t GetClientCount() const { return clientCount_.load(); }
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct Session;
+
+    ChainStateManager& chainman_;
+    const Options options_;
+    const Hash256 shareTarget_;
+    miner::BlockTemplateCache templates_;
+    MessageProcessor* msgproc_{nullptr};
+
+    std::unique_ptr<EventLoop> eventLoop_;
+    std::unique_ptr<Listener> listener_;
+    std::atomic<bool> running_{false};
+    int blockConnectedId_{-1};
+
+    // Job thread
+    std::thread jobThread_;
+    std::mutex jobMutex_;
+    std::condition_variable jobCv_;
+    bool tipChanged_{false};
+    bool stopping_{false};
+
+    // Event loop thread only
+    std::map<Connection*, std::unique_ptr<Session>> sessions_;
+    std::deque<std::shared_ptr<StratumJob>> jobs_;
+    uint32_t nextExtraNonce1_{0};
+
+    std::mutex callbackMutex_;
+    BlockFoundCallback blockFoundCallback_;
+
+    std::atomic<size_t> clientCount_{0};
+    Stats stats_;
+
+    void JobThread();
+    void AddJob(std::shared_ptr<StratumJob> job);
+
+    void OnAccept(std::unique_ptr<Connection> conn);
+    void OnData(Session& session);
+    void Disconnect(Session& session);
+    void RemoveClosedSessions();
+    void Send(Session& session, const JSONValue& message);
+    void SendJob(Session& session, const StratumJob& job);
+
+    void HandleLine(Session& session, const std::string& line);
+    JSONValue HandleSubscribe(Session& session);
+    bool HandleSubmit(Session& session, const JSONValue& params, StratumError& error,
+                      std::string& message);
+    StratumJob* FindJob(const std::string& id);
+    void SubmitBlock(const StratumJob& job, const std::vector<uint8_t>& coinbase,
+                     const BlockHeader& header);
+};
+
+} // namespace rpc
+} // namespace shurium
+
+#endif // SHURIUM_RPC_STRATUM_H
@@ -11,12 +11,16 @@
 #include "shurium/core/script.h"
 #include "shurium/core/transaction.h"
 #include "shurium/crypto/keys.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/script/scriptstack.h"
 #include <cstdint>
 #include <vector>
 #include <string>
 
 namespace shurium {
 
+class SignatureCache;
+
 // ============================================================================
 // Script Verification Flags
 // ============================================================================
@@ -55,6 +59,10 @@ enum class ScriptFlags : uint32_t {
     /// Public keys in scripts must be compressed
     VERIFY_COMPRESSED_PUBKEY = (1U << 9),
     
+    /// Sign with the linear-time signature hash (SigVersion::LINEAR) instead
+    /// of reserializing the transaction per input (softfork, not yet active)
+    VERIFY_LINEAR_SIGHASH = (1U << 10),
+    
     /// Standard verification flags (used for mempool acceptance)
     STANDARD_VERIFY_FLAGS = VERIFY_P2SH | VERIFY_STRICTENC | VERIFY_MINIMALDATA |
                             VERIFY_DISCOURAGE_UPGRADABLE_NOPS | VERIFY_CHECKLOCKTIMEVERIFY |
@@ -88,6 +96,64 @@ enum SigHashType : uint8_t {
     SIGHASH_ANYONECANPAY = 0x80,
 };
 
+/// Signature hash algorithm a CHECKSIG commits with
+enum class SigVersion {
+    /// Hash of the transaction copy with the other scripts emptied; the cost
+    /// of each input grows with the size of the whole transaction
+    BASE = 0,
+    
+    /// Hash of the input itself plus shared digests of all prevouts,
+    /// sequences and outputs, so each input costs the same
+    LINEAR = 1,
+};
+
+/// Signature hash version selected by the verification flags
+inline SigVersion GetSigVersion(ScriptFlags flags) {
+    return HasFlag(flags, ScriptFlags::VERIFY_LINEAR_SIGHASH) ? SigVersion::LINEAR
+                                                              : SigVersion::BASE;
+}
+
+// ============================================================================
+// Precomputed Transaction Data
+// ============================================================================
+
+/**
+ * Signature hash state shared by the checks of all inputs of a transaction.
+ *
+ * Built once per transaction and then read concurrently by every input's
+ * checker. For SigVersion::LINEAR it holds the prevout, sequence and output
+ * digests, so each input hashes a fixed-size preimage. For SigVersion::BASE
+ * under SIGHASH_ALL it holds the hasher state after each input of the
+ * emptied transaction and the serialized rest, so the copy, the script
+ * clearing and the reserialization are done once instead of per input.
+ * The legacy hash still covers the whole transaction for every input.
+ */
+struct PrecomputedTransactionData {
+    /// Double SHA256 of all outpoints, all sequences and all outputs
+    Hash256 hashPrevouts;
+    Hash256 hashSequence;
+    Hash256 hashOutputs;
+    
+    /// Hasher after version, input count and inputs [0, i) with empty scripts
+    std::vector<SHA256> legacyPrefix;
+    
+    /// Inputs with empty scripts back to back, and where input i starts
+    std::vector<uint8_t> legacyInputs;
+    std::vector<uint32_t> legacyInputOffsets;
+    
+    /// Output count, outputs and lock time as serialized
+    std::vector<uint8_t> legacyOutputs;
+    
+    /// Whether Init has run
+    bool ready{false};
+    
+    PrecomputedTransactionData() = default;
+    explicit PrecomputedTransactionData(const Transaction& tx) { Init(tx); }
+    
+    /// Compute everything for tx
+    void Init(const Transaction& tx);
+};
+
 // ============================================================================
 // Script Error Codes
 // ============================================================================
@@ -173,12 +239,14 @@ public:
      * Verify an ECDSA signature.
      * @param signature DER-encoded signature (with sighash byte)
      * @param pubkey Public key
-     * @param scriptCode Script being executed (for signature hash)
+     * @param scriptCode Serialized script being executed (for signature hash)
+     * @param sigversion Signature hash algorithm
      * @return true if signature is valid
      */
-    virtual bool CheckSig(const std::vector<uint8_t>& signature,
-                          const std::vector<uint8_t>& pubkey,
-                          const Script& scriptCode) const = 0;
+    virtual bool CheckSig(Span<const uint8_t> signature,
+                          Span<const uint8_t> pubkey,
+                          Span<const uint8_t> scriptCode,
+                          SigVersion sigversion) const = 0;
     
     /**
      * Verify OP_CHECKLOCKTIMEVERIFY constraint.
@@ -201,9 +269,10 @@ public:
  */
 class DummySignatureChecker : public BaseSignatureChecker {
 public:
-    bool CheckSig(const std::vector<uint8_t>& signature,
-                  const std::vector<uint8_t>& pubkey,
-                  const Script& scriptCode) const override { return false; }
+    bool CheckSig(Span<const uint8_t> signature,
+                  Span<const uint8_t> pubkey,
+                  Span<const uint8_t> scriptCode,
+                  SigVersion sigversion) const override { return false; }
     
     bool CheckLockTime(int64_t nLockTime) const override { return false; }
     bool CheckSequence(int64_t nSequence) const override { return false; }
@@ -219,12 +288,26 @@ public:
      * @param tx Transaction being verified
      * @param nIn Input index being verified
      * @param amount Value of the input being spent
+     * @param sigCache Cache of already-verified signatures (optional)
+     * @param storeInCache Record successful verifications in sigCache
+     */
+    TransactionSignatureChecker(const Transaction* tx, unsigned int nIn, Amount amount,
+                                SignatureCache* sigCache = nullptr,
+                                bool storeInCache = false);
+    
+    /**
+     * Create a signature checker that hashes from data precomputed for tx,
+     * which must outlive the checker.
      */
-    TransactionSignatureChecker(const Transaction* tx, unsigned int nIn, Amount amount);
+    TransactionSignatureChecker(const Transaction* tx, unsigned int nIn, Amount amount,
+                                const PrecomputedTransactionData& txdata,
+                                SignatureCache* sigCache = nullptr,
+                                bool storeInCache = false);
     
-    bool CheckSig(const std::vector<uint8_t>& signature,
-                  const std::vector<uint8_t>& pubkey,
-                  const Script& scriptCode) const override;
+    bool CheckSig(Span<const uint8_t> signature,
+                  Span<const uint8_t> pubkey,
+                  Span<const uint8_t> scriptCode,
+                  SigVersion sigversion) const override;
     
     bool CheckLockTime(int64_t nLockTime) const override;
     bool CheckSequence(int64_t nSequence) const override;
@@ -233,9 +316,13 @@ private:
     const Transaction* txTo_;
     unsigned int nIn_;
     Amount amount_;
+    const PrecomputedTransactionData* txdata_{nullptr};
+    SignatureCache* sigCache_;
+    bool storeInCache_;
     
     /// Compute signature hash for the input
-    Hash256 ComputeSignatureHash(const Script& scriptCode, uint8_t nHashType) const;
+    Hash256 ComputeSignatureHash(Span<const uint8_t> scriptCode, uint8_t nHashType,
+                                 SigVersion sigversion) const;
 };
 
 // ============================================================================
@@ -258,6 +345,25 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                 const BaseSignatureChecker& checker,
                 ScriptError* error = nullptr);
 
+/**
+ * Evaluate a script on an arena-backed stack. Values pushed by the script
+ * and the altstack come from the arena of stack.
+ */
+bool EvalScript(ScriptStack& stack,
+                const Script& script,
+                ScriptFlags flags,
+                const BaseSignatureChecker& checker,
+                ScriptError* error = nullptr);
+
+/**
+ * Evaluate a script decoded beforehand, as the overload above.
+ */
+bool EvalScript(ScriptStack& stack,
+                const DecodedScript& script,
+                ScriptFlags flags,
+                const BaseSignatureChecker& checker,
+                ScriptError* error = nullptr);
+
 /**
  * Verify that a scriptSig + scriptPubKey pair is valid.
  * 
@@ -277,6 +383,55 @@ bool VerifyScript(const Script& scriptSig,
                   const BaseSignatureChecker& checker,
                   ScriptError* error = nullptr);
 
+/**
+ * VerifyScript with a scriptSig decoded beforehand, such as the one a
+ * Transaction caches for each input.
+ */
+bool VerifyScript(const DecodedScript& scriptSig,
+                  const Script& scriptPubKey,
+                  ScriptFlags flags,
+                  const BaseSignatureChecker& checker,
+                  ScriptError* error = nullptr);
+
+/**
+ * VerifyScript with every script pair run through the opcode loop.
+ * 
+ * VerifyScript checks standard pairs without it and gives the same result
+ * and error; this is the reference those fast paths are tested against.
+ */
+bool VerifyScriptGeneric(const Script& scriptSig,
+                         const Script& scriptPubKey,
+                         ScriptFlags flags,
+                         const BaseSignatureChecker& checker,
+                         ScriptError* error = nullptr);
+bool VerifyScriptGeneric(const DecodedScript& scriptSig,
+                         const Script& scriptPubKey,
+                         ScriptFlags flags,
+                         const BaseSignatureChecker& checker,
+                         ScriptError* error = nullptr);
+
+// ============================================================================
+// Standard Script Templates
+// ============================================================================
+
+/// Standard scriptPubKey shapes VerifyScript checks without the opcode loop
+enum class ScriptTemplate {
+    NONSTANDARD,
+    P2PK,     ///< <pubkey> OP_CHECKSIG
+    P2PKH,    ///< OP_DUP OP_HASH160 <key hash> OP_EQUALVERIFY OP_CHECKSIG
+    P2SH,     ///< OP_HASH160 <script hash> OP_EQUAL
+};
+
+/**
+ * Recognize a standard scriptPubKey.
+ * 
+ * @param scriptPubKey Locking script
+ * @param solution Output: the public key or hash paid to, viewed in scriptPubKey
+ * @return The template, or NONSTANDARD
+ */
+ScriptTemplate MatchScriptTemplate(const Script& scriptPubKey,
+                                   Span<const uint8_t>* solution = nullptr);
+
 // ============================================================================
 // Signature Hash Calculation
 // ============================================================================
@@ -286,14 +441,20 @@ bool VerifyScript(const Script& scriptSig,
  * 
  * @param tx Transaction containing the input
  * @param nIn Input index
- * @param scriptCode Script being signed
+ * @param scriptCode Serialized script being signed
  * @param nHashType Signature hash type
+ * @param amount Value of the output being spent (committed to by LINEAR only)
+ * @param sigversion Signature hash algorithm
+ * @param txdata Data precomputed for tx, or null to compute what is needed
  * @return 256-bit signature hash
  */
 Hash256 SignatureHash(const Transaction& tx,
                       unsigned int nIn,
-                      const Script& scriptCode,
-                      uint8_t nHashType);
+                      Span<const uint8_t> scriptCode,
+                      uint8_t nHashType,
+                      Amount amount = 0,
+                      SigVersion sigversion = SigVersion::BASE,
+                      const PrecomputedTransactionData* txdata = nullptr);
 
 // ============================================================================
 // Helper Functions
@@ -302,27 +463,27 @@ Hash256 SignatureHash(const Transaction& tx,
 /**
  * Check if a signature is valid DER encoding.
  */
-bool IsValidDERSignature(const std::vector<uint8_t>& sig);
+bool IsValidDERSignature(Span<const uint8_t> sig);
 
 /**
  * Check if a signature has low S value (for malleability protection).
  */
-bool IsLowDERSignature(const std::vector<uint8_t>& sig, ScriptError* error = nullptr);
+bool IsLowDERSignature(Span<const uint8_t> sig, ScriptError* error = nullptr);
 
 /**
  * Check if a public key is valid.
  */
-bool IsValidPubKey(const std::vector<uint8_t>& pubkey);
+bool IsValidPubKey(Span<const uint8_t> pubkey);
 
 /**
  * Check if a public key is compressed.
  */
-bool IsCompressedPubKey(const std::vector<uint8_t>& pubkey);
+bool IsCompressedPubKey(Span<const uint8_t> pubkey);
 
 /**
  * Cast stack value to bool.
  */
-bool CastToBool(const std::vector<uint8_t>& vch);
+bool CastToBool(Span<const uint8_t> vch);
 
 /**
  * Count signature operations in a scriptSig + scriptPubKey pair.
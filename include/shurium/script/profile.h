@@ -0,0 +1,95 @@
+// SHURIUM - Script Execution Profile
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Per-opcode execution counts and cycles, for finding where script
+// validation spends its time. Recording is compiled in only when the build
+// defines SHURIUM_SCRIPT_PROFILE (cmake -DSHURIUM_SCRIPT_PROFILE=ON); in
+// other builds the counters stay at zero and cost nothing.
+
+#ifndef SHURIUM_SCRIPT_PROFILE_H
+#define SHURIUM_SCRIPT_PROFILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace shurium {
+
+// ============================================================================
+// Profile Counters
+// ============================================================================
+
+/// Counters for one opcode or one kind of template verification
+struct ScriptProfileEntry {
+    uint64_t executions{0};
+
+    /// TSC cycles on x86, nanoseconds elsewhere
+    uint64_t cycles{0};
+};
+
+/// Totals over every thread that ran scripts since the last reset
+struct ScriptProfile {
+    /// Indexed by opcode value; data pushes count under their push opcode
+    std::array<ScriptProfileEntry, 256> opcodes;
+
+    /// Indexed by ScriptTemplate. Each covers a whole VerifyScript call
+    /// decided on its fast path, including any redeem script it ran;
+    /// NONSTANDARD counts the pairs left to the opcode loop
+    std::array<ScriptProfileEntry, 4> templates;
+};
+
+/// True if this build records profile counters
+bool ScriptProfilingEnabled();
+
+/// Snapshot of the counters
+ScriptProfile GetScriptProfile();
+
+/// Zero the counters
+void ResetScriptProfile();
+
+/// Unit of ScriptProfileEntry::cycles, "tsc" or "ns"
+const char* ScriptProfileClock();
+
+/// Label of a profile opcode slot: GetOpName, or PUSH_<n> for the direct
+/// pushes of n bytes that have no name of their own
+std::string ScriptProfileOpName(uint8_t opcode);
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+namespace detail {
+
+uint64_t ProfileClock();
+void RecordOpcode(uint8_t opcode, uint64_t cycles);
+void RecordTemplate(size_t kind, uint64_t cycles);
+
+} // namespace detail
+
+/// Times one opcode from decoding to the end of its execution
+class OpcodeProfileScope {
+public:
+    explicit OpcodeProfileScope(uint8_t opcode)
+        : opcode_(opcode), start_(detail::ProfileClock()) {}
+    ~OpcodeProfileScope() { detail::RecordOpcode(opcode_, detail::ProfileClock() - start_); }
+
+    OpcodeProfileScope(const OpcodeProfileScope&) = delete;
+    OpcodeProfileScope& operator=(const OpcodeProfileScope&) = delete;
+
+private:
+    uint8_t opcode_;
+    uint64_t start_;
+};
+
+} // namespace shurium
+
+#ifdef SHURIUM_SCRIPT_PROFILE
+#define SHURIUM_PROFILE_OPCODE(opcode) \
+    ::shurium::OpcodeProfileScope shuriumOpcodeProfile_(static_cast<uint8_t>(opcode))
+#else
+#define SHURIUM_PROFILE_OPCODE(opcode) ((void)0)
+#endif
+
+#endif // SHURIUM_SCRIPT_PROFILE_H
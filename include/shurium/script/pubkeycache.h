@@ -0,0 +1,119 @@
+// SHURIUM - Parsed Public Key Cache
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A bounded LRU cache of decompressed public keys. Every CHECKSIG on a
+// compressed key would otherwise take a field square root to recover y;
+// keys that sign over and over (pools, exchanges, the UBI and treasury
+// funds) pay it once per eviction instead.
+
+#ifndef SHURIUM_SCRIPT_PUBKEYCACHE_H
+#define SHURIUM_SCRIPT_PUBKEYCACHE_H
+
+#include "shurium/core/types.h"
+#include "shurium/crypto/secp256k1.h"
+#include "shurium/crypto/siphash.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace shurium {
+
+/// Default number of cached keys (about 12 MB)
+static constexpr size_t DEFAULT_MAX_PUBKEY_CACHE_ENTRIES = 64 * 1024;
+
+// ============================================================================
+// PubKeyCache
+// ============================================================================
+
+/**
+ * LRU cache from 33-byte compressed encodings to parsed curve points.
+ *
+ * Keys are spread over independently locked shards by a salted SipHash of
+ * the encoding, so peers cannot aim every key at one shard, and validation
+ * threads rarely wait on each other. Each shard evicts its least recently
+ * used key once it holds its share of the capacity. Only keys that parse
+ * are cached; uncompressed keys need no square root and bypass the cache.
+ */
+class PubKeyCache {
+public:
+    /// Number of independently locked shards
+    static constexpr size_t SHARDS = 32;
+
+    /// Size of the encodings the cache holds
+    static constexpr size_t KEY_SIZE = 33;
+
+    /// Cache statistics
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t inserts{0};
+        uint64_t evictions{0};
+        size_t entries{0};     // Cached keys
+        size_t capacity{0};    // Maximum cached keys
+
+        /// Fraction of lookups that hit, 0 before any lookup
+        double HitRate() const {
+            uint64_t lookups = hits + misses;
+            return lookups ? static_cast<double>(hits) / lookups : 0.0;
+        }
+    };
+
+    /// Create a cache holding at most maxEntries keys (at least one per shard)
+    explicit PubKeyCache(size_t maxEntries = DEFAULT_MAX_PUBKEY_CACHE_ENTRIES);
+
+    PubKeyCache(const PubKeyCache&) = delete;
+    PubKeyCache& operator=(const PubKeyCache&) = delete;
+
+    /**
+     * Parse a public key, from the cache if it is a compressed key seen
+     * recently.
+     * @return false if the key does not parse (see secp256k1::ParsePublicKey)
+     */
+    bool Parse(const uint8_t* pubkey, size_t len, secp256k1::ParsedPublicKey& out);
+
+    /// Remove all entries and reset statistics
+    void Clear();
+
+    /// Get hit/miss counters and occupancy
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        std::array<uint8_t, KEY_SIZE> key;
+        secp256k1::ParsedPublicKey point;
+        uint64_t hash;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;  // Most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    };
+
+    std::array<Shard, SHARDS> m_shards;
+    size_t m_shardCapacity;
+    SipHashKey m_salt;
+
+    mutable std::atomic<uint64_t> m_hits{0};
+    mutable std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_inserts{0};
+    std::atomic<uint64_t> m_evictions{0};
+    std::atomic<size_t> m_entries{0};
+
+    bool Lookup(Shard& shard, uint64_t hash, const uint8_t* pubkey,
+                secp256k1::ParsedPublicKey& out);
+    void Insert(Shard& shard, uint64_t hash, const uint8_t* pubkey,
+                const secp256k1::ParsedPublicKey& point);
+};
+
+/// Get the process-wide public key cache shared by all validation threads
+PubKeyCache& GetPubKeyCache();
+
+} // namespace shurium
+
+#endif // SHURIUM_SCRIPT_PUBKEYCACHE_H
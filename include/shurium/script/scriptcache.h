@@ -0,0 +1,83 @@
+// SHURIUM - Script Execution Cache
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A salted, fixed-size cache of transactions whose input scripts are known
+// to be valid under a given set of script flags. A block made up of
+// transactions already accepted to the mempool skips the interpreter
+// entirely for them.
+
+#ifndef SHURIUM_SCRIPT_SCRIPTCACHE_H
+#define SHURIUM_SCRIPT_SCRIPTCACHE_H
+
+#include "shurium/core/types.h"
+#include "shurium/crypto/saltedcache.h"
+#include "shurium/script/interpreter.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+
+namespace shurium {
+
+/// Default script execution cache size (8 MB)
+static constexpr size_t DEFAULT_MAX_SCRIPT_CACHE_BYTES = 8 * 1024 * 1024;
+
+// ============================================================================
+// ScriptExecutionCache
+// ============================================================================
+
+/**
+ * Cache of (txid, script flags) pairs whose scripts verified.
+ *
+ * Entries are the salted SHA256 of the txid and flags. The txid commits to
+ * every prevout, so a hit means the very same spends were verified. The
+ * cache tracks the flag set block validation is currently using; when that
+ * set changes (for example at a soft fork activation height) every entry is
+ * dropped, since none can hit again.
+ */
+class ScriptExecutionCache : public SaltedCache<16> {
+public:
+    /// Cache statistics
+    struct Stats : SaltedCache::Stats {
+        uint64_t invalidations{0}; // Times the flag set changed
+    };
+
+    /**
+     * Create a cache using at most maxBytes for the table.
+     * The slot count is rounded down to a power of two.
+     */
+    explicit ScriptExecutionCache(size_t maxBytes = DEFAULT_MAX_SCRIPT_CACHE_BYTES)
+        : SaltedCache(maxBytes) {}
+
+    /// Compute the salted cache entry for a transaction and flag set
+    Hash256 ComputeEntry(const TxHash& txid, ScriptFlags flags) const;
+
+    /**
+     * Set the flags block validation is using.
+     * If they differ from the current ones the cache is cleared.
+     */
+    void SetActiveFlags(ScriptFlags flags);
+
+    /// Flags block validation is currently using
+    ScriptFlags GetActiveFlags() const;
+
+    /// Remove all entries and reset statistics
+    void Clear();
+
+    /// Get hit/miss counters and occupancy
+    Stats GetStats() const;
+
+private:
+    mutable std::shared_mutex m_flagsMutex;
+    ScriptFlags m_activeFlags{ScriptFlags::MANDATORY_VERIFY_FLAGS};
+
+    std::atomic<uint64_t> m_invalidations{0};
+};
+
+/// Get the process-wide script execution cache
+ScriptExecutionCache& GetScriptExecutionCache();
+
+} // namespace shurium
+
+#endif // SHURIUM_SCRIPT_SCRIPTCACHE_H
@@ -0,0 +1,186 @@
+// SHURIUM - Script Evaluation Stack
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// The stack the interpreter evaluates on. Elements of up to
+// StackElement::INLINE_SIZE bytes, which covers every signature and public
+// key, are stored in the element itself. Longer elements and the slot arrays
+// of the stacks come from a ScriptArena that lives for one verification, so
+// a standard spend is evaluated without touching the heap.
+
+#ifndef SHURIUM_SCRIPT_SCRIPTSTACK_H
+#define SHURIUM_SCRIPT_SCRIPTSTACK_H
+
+#include "shurium/core/types.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// Script Arena
+// ============================================================================
+
+/**
+ * Bump allocator for the stacks of one script verification.
+ *
+ * Memory is handed out from a buffer inside the arena and then from heap
+ * chunks once that is used up, and is only released when the arena is
+ * destroyed. The script limits bound what one verification can take.
+ */
+class ScriptArena {
+public:
+    /// Bytes available before the first heap chunk
+    static constexpr size_t INITIAL_SIZE = 4096;
+
+    /// Minimum size of each heap chunk
+    static constexpr size_t CHUNK_SIZE = 16384;
+
+    ScriptArena() = default;
+
+    ScriptArena(const ScriptArena&) = delete;
+    ScriptArena& operator=(const ScriptArena&) = delete;
+
+    /// Allocate len bytes aligned for any type
+    void* Allocate(size_t len);
+
+    /// Bytes taken from the heap so far
+    size_t HeapBytes() const { return heapBytes_; }
+
+private:
+    alignas(std::max_align_t) uint8_t initial_[INITIAL_SIZE];
+    uint8_t* next_{initial_};
+    size_t left_{INITIAL_SIZE};
+    size_t heapBytes_{0};
+    std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+};
+
+// ============================================================================
+// Stack Element
+// ============================================================================
+
+/**
+ * One stack value: up to INLINE_SIZE bytes stored inline, longer values
+ * referenced in the arena of the stack that holds it.
+ *
+ * Values are never modified once pushed, so copying an element copies the
+ * reference and elements can be moved around a stack as plain bytes.
+ */
+class StackElement {
+public:
+    /// Longest value stored inline: a DER signature with its hash type
+    /// byte is at most 73 bytes and an uncompressed public key 65
+    static constexpr size_t INLINE_SIZE = 75;
+
+    StackElement() : size_(0) {}
+
+    const uint8_t* data() const { return size_ <= INLINE_SIZE ? inline_ : external_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    const uint8_t* begin() const { return data(); }
+    const uint8_t* end() const { return data() + size_; }
+    uint8_t operator[](size_t i) const { return data()[i]; }
+
+    /// View of the value, valid while the arena lives
+    Span<const uint8_t> span() const { return Span<const uint8_t>(data(), size_); }
+    operator Span<const uint8_t>() const { return span(); }
+
+    std::vector<uint8_t> ToVector() const { return std::vector<uint8_t>(begin(), end()); }
+
+    bool operator==(const StackElement& other) const {
+        return size_ == other.size_ && std::memcmp(data(), other.data(), size_) == 0;
+    }
+    bool operator!=(const StackElement& other) const { return !(*this == other); }
+
+private:
+    friend class ScriptStack;
+
+    union {
+        uint8_t inline_[INLINE_SIZE];
+        const uint8_t* external_;
+    };
+    uint32_t size_;
+};
+
+// ============================================================================
+// Script Stack
+// ============================================================================
+
+/**
+ * Vector-like stack of StackElements allocated from a ScriptArena.
+ *
+ * Copies share the arena of the stack they were copied from, which must
+ * outlive all of them.
+ */
+class ScriptStack {
+public:
+    explicit ScriptStack(ScriptArena& arena) : arena_(&arena) {}
+
+    ScriptStack(const ScriptStack& other);
+    ScriptStack& operator=(const ScriptStack& other);
+
+    ScriptArena& arena() const { return *arena_; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    StackElement& operator[](size_t i) { return data_[i]; }
+    const StackElement& operator[](size_t i) const { return data_[i]; }
+
+    StackElement* begin() { return data_; }
+    StackElement* end() { return data_ + size_; }
+    const StackElement* begin() const { return data_; }
+    const StackElement* end() const { return data_ + size_; }
+
+    StackElement& back() { return data_[size_ - 1]; }
+    const StackElement& back() const { return data_[size_ - 1]; }
+
+    /**
+     * Element i counted from the top, i being negative: -1 is the top.
+     * @throws std::out_of_range if the stack is not that deep
+     */
+    StackElement& top(int i);
+
+    /// Push a copy of an element of this stack or one sharing its arena
+    void push_back(const StackElement& element);
+
+    /// Push a copy of bytes
+    void push_back(Span<const uint8_t> bytes);
+
+    /**
+     * Remove the top element.
+     * @throws std::runtime_error if the stack is empty
+     */
+    void pop_back();
+
+    /// Remove the elements at [first, last)
+    void erase(size_t first, size_t last);
+
+    /// Insert a copy of element before position pos
+    void insert(size_t pos, const StackElement& element);
+
+    void clear() { size_ = 0; }
+
+    /// Replace the contents with copies of values
+    void Assign(const std::vector<std::vector<uint8_t>>& values);
+
+    /// Copy the contents out
+    std::vector<std::vector<uint8_t>> ToVectors() const;
+
+private:
+    /// Make room for n elements
+    void Reserve(size_t n);
+
+    ScriptArena* arena_;
+    StackElement* data_{nullptr};
+    size_t size_{0};
+    size_t capacity_{0};
+};
+
+} // namespace shurium
+
+#endif // SHURIUM_SCRIPT_SCRIPTSTACK_H
@@ -0,0 +1,54 @@
+// SHURIUM - Signature Verification Cache
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A salted, fixed-size cache of signatures that have already been verified.
+// Transactions are verified once on mempool admission; block validation
+// then finds their signatures here and skips the elliptic curve work.
+
+#ifndef SHURIUM_SCRIPT_SIGCACHE_H
+#define SHURIUM_SCRIPT_SIGCACHE_H
+
+#include "shurium/core/types.h"
+#include "shurium/crypto/saltedcache.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace shurium {
+
+/// Default signature cache size (32 MB)
+static constexpr size_t DEFAULT_MAX_SIG_CACHE_BYTES = 32 * 1024 * 1024;
+
+// ============================================================================
+// SignatureCache
+// ============================================================================
+
+/**
+ * Cache of verified (sighash, pubkey, signature) triples.
+ *
+ * Entries are the salted SHA256 of the triple, pubkey and signature
+ * length-prefixed, so peers cannot construct colliding entries by moving
+ * bytes between the fields. Lookups come from every script check thread,
+ * so the table is split over many lock stripes.
+ */
+class SignatureCache : public SaltedCache<64> {
+public:
+    /**
+     * Create a cache using at most maxBytes for the table.
+     * The slot count is rounded down to a power of two.
+     */
+    explicit SignatureCache(size_t maxBytes = DEFAULT_MAX_SIG_CACHE_BYTES)
+        : SaltedCache(maxBytes) {}
+
+    /// Compute the salted cache entry for a signature check
+    Hash256 ComputeEntry(const Hash256& sighash,
+                         Span<const uint8_t> pubkey,
+                         Span<const uint8_t> signature) const;
+};
+
+/// Get the process-wide signature cache shared by mempool and block validation
+SignatureCache& GetSignatureCache();
+
+} // namespace shurium
+
+#endif // SHURIUM_SCRIPT_SIGCACHE_H
@@ -96,6 +96,11 @@ using ValidatorId = Hash160;
 /// Unique delegation identifier
 using DelegationId = Hash256;
 
+/// Cumulative reward per delegation share, in units of
+/// 1/REWARD_PER_SHARE_SCALE (128 bits, a GCC/Clang extension)
+__extension__ typedef unsigned __int128 RewardPerShare;
+constexpr uint64_t REWARD_PER_SHARE_SCALE = 1000000000000000000ULL;
+
 /// Validator status
 enum class ValidatorStatus {
     /// Registered but not yet active
@@ -153,6 +158,53 @@ enum class DelegationStatus {
 /// Convert status to string
 const char* DelegationStatusToString(DelegationStatus status);
 
+// ============================================================================
+// Liveness Window
+// ============================================================================
+
+/**
+ * Whether a validator missed each of its last N blocks, as a circular
+ * bitset with a running count of misses.
+ *
+ * Recording a block overwrites the oldest bit once the window is full, so
+ * every operation except iteration is O(1). The bits live in one array of
+ * N/64 words, allocated on the first record.
+ */
+class LivenessWindow {
+public:
+    explicit LivenessWindow(size_t capacity = MISSED_BLOCKS_WINDOW);
+    
+    /// Record the next block, evicting the oldest if the window is full
+    void Record(bool missed);
+    
+    /// Whether the i-th oldest recorded block was missed
+    bool Get(size_t i) const;
+    
+    /// Number of blocks recorded (at most Capacity())
+    size_t Size() const { return size_; }
+    
+    /// Window length
+    size_t Capacity() const { return capacity_; }
+    
+    /// Number of missed blocks in the window
+    size_t MissedCount() const { return missed_; }
+    
+    bool Empty() const { return size_ == 0; }
+    
+    /// Forget all recorded blocks
+    void Clear();
+    
+    bool operator==(const LivenessWindow& other) const;
+    bool operator!=(const LivenessWindow& other) const { return !(*this == other); }
+    
+private:
+    std::vector<uint64_t> words_;
+    size_t capacity_;
+    size_t head_{0};     // Bit index of the oldest block
+    size_t size_{0};
+    size_t missed_{0};
+};
+
 // ============================================================================
 // Validator
 // ============================================================================
@@ -212,8 +264,8 @@ struct Validator {
     /// Number of blocks missed in current window
     int missedBlocksCounter{0};
     
-    /// Bitmap of missed blocks (sliding window)
-    std::vector<bool> missedBlocksBitmap;
+    /// Missed blocks over the last MISSED_BLOCKS_WINDOW blocks
+    LivenessWindow missedBlocksBitmap;
     
     /// Number of times slashed
     int slashCount{0};
@@ -303,6 +355,9 @@ struct Delegation {
     /// Shares in the validator's pool (for reward calculation)
     uint64_t shares{0};
     
+    /// Validator's reward per share when pendingRewards was last settled
+    RewardPerShare rewardCheckpoint{0};
+    
     /// Check if unbonding is complete
     bool IsUnbondingComplete(int currentHeight) const;
     
@@ -396,6 +451,73 @@ struct SlashEvent {
     std::string ToString() const;
 };
 
+// ============================================================================
+// Staking Changes
+// ============================================================================
+
+/**
+ * Staking records written since changes were last taken, with their values
+ * (nullopt for a record that no longer exists).
+ *
+ * The in-memory components hand these out once per block for StakingStore
+ * to persist, and take them back when loading or undoing blocks.
+ */
+struct StakingChanges {
+    std::map<ValidatorId, std::optional<Validator>> validators;
+    std::map<DelegationId, std::optional<Delegation>> delegations;
+    std::map<ValidatorId, RewardPerShare> rewardPerShare;
+    
+    bool empty() const {
+        return validators.empty() && delegations.empty() && rewardPerShare.empty();
+    }
+    size_t size() const {
+        return validators.size() + delegations.size() + rewardPerShare.size();
+    }
+};
+
+// ============================================================================
+// Proposer Schedule
+// ============================================================================
+
+/**
+ * Stakes of the active validators in ValidatorId order, with a Fenwick tree
+ * of prefix sums over them.
+ *
+ * Proposer selection maps a stake offset to the validator whose cumulative
+ * stake range contains it. The tree answers that in O(log n), and a stake
+ * change is a point update instead of a rebuild.
+ */
+class ProposerSchedule {
+public:
+    /// Replace the schedule with the given validators and stakes
+    void Rebuild(std::vector<std::pair<ValidatorId, Amount>> validators);
+    
+    /// Change one validator's stake (returns false if not scheduled)
+    bool UpdateStake(const ValidatorId& id, Amount stake);
+    
+    /// Get the validator whose cumulative stake range contains position
+    /// (position must be below GetTotalStake())
+    ValidatorId Select(Amount position) const;
+    
+    /// Sum of all scheduled stakes
+    Amount GetTotalStake() const { return totalStake_; }
+    
+    /// Number of scheduled validators
+    size_t Size() const { return ids_.size(); }
+    
+    /// Check if the schedule is empty
+    bool Empty() const { return ids_.empty(); }
+    
+    /// Get the first validator in schedule order
+    const ValidatorId& Front() const { return ids_.front(); }
+    
+private:
+    std::vector<ValidatorId> ids_;  // Sorted
+    std::vector<Amount> stakes_;
+    std::vector<Amount> tree_;      // 1-based Fenwick tree over stakes_
+    Amount totalStake_{0};
+};
+
 // ============================================================================
 // Validator Set
 // ============================================================================
@@ -469,6 +591,9 @@ public:
     /// Record missed block
     void RecordBlockMissed(const ValidatorId& id);
     
+    /// Get the number of blocks a validator missed in the current window
+    std::optional<int> GetMissedBlocksCount(const ValidatorId& id) const;
+    
     /// Get next block proposer (round-robin weighted by stake)
     ValidatorId GetNextProposer(int height) const;
     
@@ -480,6 +605,15 @@ public:
     /// Process pending unbondings
     void ProcessUnbondings(int height);
     
+    // === Persistence ===
+    
+    /// Move the validators changed since the last call into changes
+    void TakeChanges(StakingChanges& changes);
+    
+    /// Overwrite validators with stored values (loading or undoing blocks);
+    /// these are not reported as changes
+    void ApplyChanges(const StakingChanges& changes, int height);
+    
     // === Serialization ===
     
     std::vector<Byte> Serialize() const;
@@ -489,6 +623,12 @@ private:
     /// Update active set based on stake ranking
     void UpdateActiveSet();
     
+    /// Rebuild the proposer schedule if the active set changed
+    void RefreshProposerSchedule() const;
+    
+    /// Change a validator's status, recording it if it differs
+    void SetStatus(const ValidatorId& id, ValidatorStatus status);
+    
     /// Verify validator signature
     bool VerifyValidatorSignature(const ValidatorId& id, 
                                    const Hash256& hash,
@@ -497,8 +637,16 @@ private:
     mutable std::mutex mutex_;
     std::map<ValidatorId, Validator> validators_;
     std::set<ValidatorId> activeSet_;
-    std::vector<UnbondingEntry> unbondingQueue_;
+    std::multimap<int, UnbondingEntry> unbondingQueue_;  // By completion height
     int currentHeight_{0};
+    
+    /// Active-set stakes for proposer selection, rebuilt lazily after the
+    /// active set changes
+    mutable ProposerSchedule proposers_;
+    mutable bool proposersDirty_{true};
+    
+    /// Validators written since the last TakeChanges()
+    std::set<ValidatorId> changed_;
 };
 
 // ============================================================================
@@ -564,10 +712,12 @@ public:
     /// Claim pending rewards
     Amount ClaimRewards(const DelegationId& delegationId, const std::vector<Byte>& signature);
     
-    /// Get pending rewards for a delegation
+    /// Get pending rewards for a delegation (computed on demand)
     Amount GetPendingRewards(const DelegationId& delegationId) const;
     
-    /// Distribute rewards to a validator's delegators
+    /// Distribute rewards to a validator's delegators. This only advances
+    /// the validator's reward-per-share accumulator; each delegation's share
+    /// is settled when it changes, is claimed or is queried.
     void DistributeRewards(const ValidatorId& validatorId, Amount totalReward);
     
     // === Slashing ===
@@ -580,12 +730,40 @@ public:
     /// Process block (update heights, process unbondings)
     void ProcessBlock(int height);
     
+    /// Get a validator's cumulative reward per share
+    RewardPerShare GetRewardPerShare(const ValidatorId& validatorId) const;
+    
+    // === Persistence ===
+    
+    /// Move the delegations and reward accumulators changed since the last
+    /// call into changes
+    void TakeChanges(StakingChanges& changes);
+    
+    /// Overwrite delegations and reward accumulators with stored values
+    /// (loading or undoing blocks); these are not reported as changes
+    void ApplyChanges(const StakingChanges& changes, int height);
+    
     // === Serialization ===
     
     std::vector<Byte> Serialize() const;
     bool Deserialize(const Byte* data, size_t len);
     
 private:
+    /// Rewards accrued by a delegation since it was last settled
+    Amount UnsettledRewards(const Delegation& delegation) const;
+    
+    /// Move accrued rewards into pendingRewards (call before shares change)
+    void SettleRewards(Delegation& delegation);
+    
+    /// Copy of a delegation with accrued rewards included
+    Delegation WithAccruedRewards(const Delegation& delegation) const;
+    
+    /// Add a delegation to the delegator, validator and maturity indices
+    void IndexDelegation(const Delegation& delegation);
+    
+    /// Remove a delegation from the indices
+    void UnindexDelegation(const Delegation& delegation);
+    
     /// Calculate shares for a delegation amount
     uint64_t CalculateShares(const ValidatorId& validatorId, Amount amount) const;
     
@@ -603,8 +781,14 @@ private:
     std::map<Hash160, std::set<DelegationId>> delegatorIndex_;
     std::map<ValidatorId, std::set<DelegationId>> validatorIndex_;
     std::map<ValidatorId, uint64_t> totalShares_;  // Total shares per validator
-    std::vector<UnbondingEntry> unbondingQueue_;
+    std::map<ValidatorId, RewardPerShare> rewardPerShare_;  // Per validator
+    std::multimap<int, UnbondingEntry> unbondingQueue_;     // By completion height
+    std::multimap<int, DelegationId> maturingDelegations_;  // Unbonding, by completion height
     int currentHeight_{0};
+    
+    /// Records written since the last TakeChanges()
+    std::set<DelegationId> changedDelegations_;
+    std::set<ValidatorId> changedRewards_;
 };
 
 // ============================================================================
@@ -801,6 +985,15 @@ public:
     /// Get current block height
     int GetCurrentHeight() const { return currentHeight_; }
     
+    // === Persistence ===
+    
+    /// Collect the records changed since the last call (once per block)
+    StakingChanges TakeChanges();
+    
+    /// Overwrite records with stored values and set the height, after
+    /// loading from or undoing blocks in a StakingStore
+    void ApplyChanges(const StakingChanges& changes, int height);
+    
     // === Convenience Methods ===
     
     /// Register validator (convenience wrapper)
@@ -0,0 +1,75 @@
+// SHURIUM - Staking State Store
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Persists validators, delegations and reward accumulators one block at a
+// time. Each connected block writes only the records it changed, together
+// with undo data holding their previous values, so a restart loads the
+// stored records instead of replaying history and disconnecting a block
+// costs only the changes it made.
+
+#ifndef SHURIUM_STAKING_STAKINGDB_H
+#define SHURIUM_STAKING_STAKINGDB_H
+
+#include <shurium/staking/staking.h>
+
+#include <memory>
+#include <mutex>
+
+namespace shurium {
+namespace db { class Database; }
+namespace staking {
+
+/**
+ * Database-backed staking records with per-block undo data.
+ *
+ * Usage per block: ConnectBlock(height, engine.TakeChanges()). On startup,
+ * Load() the records and ApplyChanges() them with GetTipHeight(). To undo
+ * the tip, DisconnectBlock() and ApplyChanges() what it restored with the
+ * new tip height.
+ */
+class StakingStore {
+public:
+    /// Create a store backed by an in-memory database
+    StakingStore();
+
+    /// Create a store over a database (reads the stored tip)
+    explicit StakingStore(std::unique_ptr<db::Database> db);
+
+    ~StakingStore();
+
+    StakingStore(const StakingStore&) = delete;
+    StakingStore& operator=(const StakingStore&) = delete;
+
+    /// Height of the last connected block (-1 if none)
+    int GetTipHeight() const;
+
+    /**
+     * Write the records a block changed and its undo data in one batch.
+     * height must follow the current tip (any height for an empty store).
+     */
+    bool ConnectBlock(int height, const StakingChanges& changes);
+
+    /**
+     * Undo the tip block. restored receives the previous values of the
+     * records it changed (nullopt for records it created).
+     */
+    bool DisconnectBlock(StakingChanges& restored);
+
+    /// Read every stored record
+    bool Load(StakingChanges& state) const;
+
+    /// Drop undo data for blocks at or below height (they can no longer
+    /// be disconnected)
+    bool PruneUndo(int height);
+
+private:
+    std::unique_ptr<db::Database> db_;
+    int tipHeight_{-1};
+    mutable std::mutex mutex_;
+};
+
+} // namespace staking
+} // namespace shurium
+
+#endif // SHURIUM_STAKING_STAKINGDB_H
@@ -0,0 +1,156 @@
+// SHURIUM - Thread Placement
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// CPU and NUMA placement of the node's long-lived threads by role. Each
+// role ("scriptcheck", "msgproc", "rpc", "miner", "eventloop", ...) may be
+// given a set of cores; its threads pin themselves to that set when they
+// start, and memory the role works on can prefer the NUMA node those cores
+// sit on. The CPU time every role's threads use is kept for the metrics.
+//
+// Pinning and NUMA binding are Linux only; elsewhere, or when the kernel
+// refuses, threads keep floating and memory keeps the default policy.
+
+#ifndef SHURIUM_UTIL_AFFINITY_H
+#define SHURIUM_UTIL_AFFINITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace util {
+
+// ============================================================================
+// Topology
+// ============================================================================
+
+/// One NUMA node and the CPUs on it
+struct NumaNode {
+    int id{0};
+    std::vector<int> cpus;
+};
+
+/**
+ * Parse a kernel CPU list ("0-3,8,10-11").
+ * @return The CPUs in ascending order, or empty if the list is malformed
+ */
+std::vector<int> ParseCpuList(const std::string& list);
+
+/// The machine's NUMA nodes from sysfs; one node holding every CPU where
+/// sysfs does not say
+std::vector<NumaNode> GetNumaTopology();
+
+/**
+ * Prefer the given NUMA node for the pages of [ptr, ptr + len) that are
+ * not yet touched. Only the whole pages inside the range are bound.
+ * @return false if the range holds no whole page or the kernel refused
+ */
+bool BindToNumaNode(void* ptr, size_t len, int node);
+
+// ============================================================================
+// ThreadPlacement
+// ============================================================================
+
+/// CPU time and placement of one role's threads
+struct ThreadRoleStats {
+    std::string role;
+    size_t threads{0};          // Running now
+    std::vector<int> cores;     // Empty = not pinned
+    double cpuSeconds{0};       // Running and exited threads together
+};
+
+/**
+ * The process's thread roles: the cores each is pinned to and the CPU
+ * time each has used. Thread-safe.
+ *
+ * Cores are read when a thread starts its role, so configure placement
+ * before starting the subsystems.
+ */
+class ThreadPlacement {
+public:
+    /// The process-wide placement
+    static ThreadPlacement& Instance();
+
+    ThreadPlacement();
+    ThreadPlacement(const ThreadPlacement&) = delete;
+    ThreadPlacement& operator=(const ThreadPlacement&) = delete;
+
+    /// Pin a role's threads to cpus; empty lets them float
+    void SetCores(const std::string& role, std::vector<int> cpus);
+    std::vector<int> GetCores(const std::string& role) const;
+
+    /**
+     * Apply one "role=cpulist" setting, as given to -threadaffinity.
+     * @return false, with error set, if it does not parse
+     */
+    bool Configure(const std::string& spec, std::string& error);
+
+    /**
+     * Place the roles nobody configured. On a machine with one NUMA node
+     * the scheduler already does well and nothing changes. With several,
+     * validation, message handling, RPC and the event loop share the first
+     * node, where the coins cache lives, and the miners take the last so
+     * hashing does not compete with block validation.
+     */
+    void ApplyDefaults();
+    void ApplyDefaults(const std::vector<NumaNode>& topology);
+
+    /// NUMA node a role's cores are on, or -1 if the role is not pinned,
+    /// spans nodes or the machine has only one
+    int PreferredNode(const std::string& role) const;
+
+    /// Every role that has run a thread or been given cores
+    std::vector<ThreadRoleStats> GetStats() const;
+
+    /// Forget every role's cores (not its CPU time)
+    void ClearCores();
+
+private:
+    friend class ScopedThreadRole;
+
+    struct LiveThread {
+        uint64_t handle{0};     // pthread_t
+        int64_t startNs{0};     // The thread's CPU time when it joined
+    };
+
+    struct Role {
+        std::vector<int> cores;
+        bool configured{false};  // Set by hand, so defaults leave it
+        std::vector<LiveThread> live;
+        int64_t exitedNs{0};
+    };
+
+    /// Pin the calling thread per its role and start counting its time
+    void Enter(const std::string& role);
+    void Leave(const std::string& role);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Role> roles_;
+    std::vector<NumaNode> topology_;
+};
+
+/**
+ * The calling thread works in a role for the life of this object: it is
+ * pinned to the role's cores, if any, and its CPU time is counted for the
+ * role. Construct it first thing in the thread's body.
+ */
+class ScopedThreadRole {
+public:
+    explicit ScopedThreadRole(std::string role);
+    ~ScopedThreadRole();
+
+    ScopedThreadRole(const ScopedThreadRole&) = delete;
+    ScopedThreadRole& operator=(const ScopedThreadRole&) = delete;
+
+private:
+    std::string role_;
+};
+
+} // namespace util
+} // namespace shurium
+
+#endif // SHURIUM_UTIL_AFFINITY_H
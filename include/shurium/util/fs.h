@@ -12,6 +12,7 @@
 #define SHURIUM_UTIL_FS_H
 
 #include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
 #include <functional>
@@ -264,6 +265,13 @@ Path ReadSymlink(const Path& path);
 /// Resize file
 bool ResizeFile(const Path& path, uint64_t newSize);
 
+/// Flush an open file's stdio buffer and force its data to disk
+bool FileCommit(std::FILE* file);
+
+/// Reserve disk space for [offset, offset + length) of an open file
+/// (fallocate where available, else written zeros); best effort
+void AllocateFileRange(std::FILE* file, uint64_t offset, uint64_t length);
+
 // ============================================================================
 // Path Queries
 // ============================================================================
@@ -495,6 +503,102 @@ private:
     bool locked_{false};
 };
 
+// ============================================================================
+// Memory-Mapped Files
+// ============================================================================
+
+/**
+ * Read-only memory mapping of a whole file (RAII).
+ * 
+ * The mapping stays valid while the object lives, even if the file is
+ * closed, and can be read from any number of threads. Bytes appended to
+ * the file after mapping are not visible; map only files that no longer
+ * grow. Not supported on Windows (Open returns false).
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const Path& path) { Open(path); }
+    ~MappedFile();
+    
+    // Non-copyable but movable
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    
+    /// Map a file; fails for missing or empty files
+    bool Open(const Path& path);
+    
+    /// Unmap
+    void Close();
+    
+    /// Check if mapped
+    bool IsOpen() const { return data_ != nullptr; }
+    
+    /// Mapped bytes
+    const uint8_t* Data() const { return data_; }
+    
+    /// Mapped length in bytes
+    size_t Size() const { return size_; }
+
+private:
+    const uint8_t* data_{nullptr};
+    size_t size_{0};
+};
+
+// ============================================================================
+// Sequential Reads
+// ============================================================================
+
+/**
+ * Read-only file handle for one front-to-back pass (RAII).
+ *
+ * The kernel is told the access is sequential (posix_fadvise, or F_RDAHEAD
+ * where that is what the platform offers), so it reads ahead aggressively
+ * and drops pages behind the reader. Read() does no buffering of its own;
+ * callers pass large buffers and may ask for the next range to be prefetched
+ * with WillNeed() while they work on the current one.
+ */
+class SequentialFile {
+public:
+    SequentialFile() = default;
+    explicit SequentialFile(const Path& path) { Open(path); }
+    ~SequentialFile();
+
+    // Non-copyable but movable
+    SequentialFile(const SequentialFile&) = delete;
+    SequentialFile& operator=(const SequentialFile&) = delete;
+    SequentialFile(SequentialFile&& other) noexcept;
+    SequentialFile& operator=(SequentialFile&& other) noexcept;
+
+    /// Open a file for reading from the start
+    bool Open(const Path& path);
+
+    /// Close the file
+    void Close();
+
+    /// Check if open
+    bool IsOpen() const { return file_ != nullptr; }
+
+    /// File size when opened
+    uint64_t Size() const { return size_; }
+
+    /// Current read offset
+    uint64_t Tell() const { return offset_; }
+
+    /// Read up to len bytes; returns the count read (0 at end of file or on error)
+    size_t Read(uint8_t* buf, size_t len);
+
+    /// Hint that [offset, offset + len) will be read soon (no-op if unsupported)
+    void WillNeed(uint64_t offset, uint64_t len);
+
+private:
+    std::FILE* file_{nullptr};
+    uint64_t size_{0};
+    uint64_t offset_{0};
+};
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
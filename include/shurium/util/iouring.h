@@ -0,0 +1,165 @@
+// SHURIUM - io_uring Submission Ring
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A small io_uring wrapper over the raw system calls, for the hot I/O
+// paths that are bound by system call count rather than bandwidth: block
+// file reads and appends, batched socket reads into registered buffers,
+// and zero-copy sends of large payloads.
+//
+// The ring is compiled in only when the build defines SHURIUM_IO_URING
+// (cmake -DSHURIUM_IO_URING=ON, Linux). Create() returns null in other
+// builds and on kernels that lack io_uring or the operations used here,
+// and every caller keeps its plain system call path for that case.
+
+#ifndef SHURIUM_UTIL_IOURING_H
+#define SHURIUM_UTIL_IOURING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+struct msghdr;
+
+namespace shurium {
+namespace util {
+
+/// Submission queue entries per ring unless asked otherwise
+static constexpr unsigned IO_RING_DEFAULT_ENTRIES = 256;
+
+/// True if this build has the io_uring backend
+bool IoUringEnabled();
+
+/**
+ * One io_uring instance.
+ *
+ * Operations are queued, then submitted together with one system call;
+ * their completions are read from the shared ring without one. The ring is
+ * not thread safe: its owner serializes every call.
+ */
+class IoRing {
+public:
+    /// Operations Supports() can be asked about
+    enum class Op {
+        READ,
+        READ_FIXED,
+        WRITE,
+        SENDMSG,
+        SEND_ZC
+    };
+
+    /// One finished operation
+    struct Completion {
+        uint64_t userData{0};
+
+        /// Bytes transferred, or -errno
+        int32_t result{0};
+    };
+
+    /// A ring with the given queue depth, or null if io_uring is
+    /// unavailable (older kernel, seccomp, other platform or build)
+    static std::unique_ptr<IoRing> Create(unsigned entries = IO_RING_DEFAULT_ENTRIES);
+
+    ~IoRing();
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    /// Whether the kernel implements an operation
+    bool Supports(Op op) const;
+
+    /**
+     * Register count buffers of size bytes each, laid out back to back
+     * from base, for QueueReadFixed. Pinning them may fail under
+     * RLIMIT_MEMLOCK; plain reads still work then.
+     */
+    bool RegisterBuffers(uint8_t* base, size_t size, unsigned count);
+
+    /// Whether RegisterBuffers succeeded
+    bool HasRegisteredBuffers() const { return registeredBuffers_ > 0; }
+
+    // ========================================================================
+    // Batched Operations
+    // ========================================================================
+
+    // Each returns false if the submission queue stays full after
+    // submitting what it holds. Offsets of -1 mean the current position,
+    // as sockets need; such reads fail with -EAGAIN rather than wait for
+    // data. The top bit of userData is reserved for the ring.
+
+    bool QueueRead(int fd, void* buf, uint32_t len, uint64_t offset, uint64_t userData);
+    bool QueueReadFixed(int fd, void* buf, uint32_t len, uint64_t offset, uint16_t bufIndex,
+                        uint64_t userData);
+    bool QueueWrite(int fd, const void* buf, uint32_t len, uint64_t offset, uint64_t userData);
+    bool QueueSendMsg(int fd, const struct msghdr* msg, int flags, uint64_t userData);
+
+    /**
+     * Submit what is queued and wait until at least minComplete operations
+     * have completed.
+     * @return Operations submitted, or -errno
+     */
+    int Submit(unsigned minComplete = 0);
+
+    /// Next completion of a queued operation, without a system call
+    bool PopCompletion(Completion& out);
+
+    // ========================================================================
+    // Single Operations
+    // ========================================================================
+
+    /// pread/pwrite through the ring: the whole range, or -errno
+    int64_t ReadAt(int fd, void* buf, size_t len, uint64_t offset);
+    int64_t WriteAt(int fd, const void* buf, size_t len, uint64_t offset);
+
+    /**
+     * Zero-copy send of one buffer. The kernel transmits straight from buf,
+     * so pin (whatever owns buf) is held until the kernel reports it done
+     * with the pages, which may be long after this returns.
+     * @return Bytes sent, or -errno (-EAGAIN if the socket is full)
+     */
+    int32_t SendZeroCopy(int fd, const void* buf, uint32_t len, int flags,
+                         std::shared_ptr<const void> pin);
+
+    /// Zero-copy sends whose buffers the kernel still holds
+    size_t PinnedSends() const { return pins_.size(); }
+
+private:
+    IoRing() = default;
+
+    struct Rings;
+
+    /// Next free submission entry (zeroed), submitting what is queued if
+    /// the queue is full; null if it stays full
+    void* NextEntry();
+
+    /// Publish the entry NextEntry handed out
+    void CommitEntry();
+
+    /// Submit queued operations and wait for the completion with the given
+    /// user data, setting aside any other
+    int32_t RunSingle(uint64_t userData);
+
+    /// Read one completion off the ring, handling zero-copy notifications
+    /// itself
+    bool ReapOne(Completion& out);
+
+    int fd_{-1};
+    std::unique_ptr<Rings> rings_;
+    unsigned unsubmitted_{0};
+    unsigned registeredBuffers_{0};
+    uint64_t supportedOps_{0};
+    uint64_t nextSingle_{0};
+
+    /// Completions of queued operations read while waiting for a single one
+    std::deque<Completion> setAside_;
+
+    /// Buffers of zero-copy sends, by user data, until their notification
+    std::unordered_map<uint64_t, std::shared_ptr<const void>> pins_;
+};
+
+} // namespace util
+} // namespace shurium
+
+#endif // SHURIUM_UTIL_IOURING_H
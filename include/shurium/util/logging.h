@@ -7,6 +7,7 @@
 // - Log categories for filtering
 // - Console and file output
 // - Thread-safe logging
+// - Optional asynchronous mode (sinks written from a background thread)
 // - Printf-style and stream-style interfaces
 
 #ifndef SHURIUM_UTIL_LOGGING_H
@@ -15,12 +16,14 @@
 #include <atomic>
 #include <chrono>
 #include <cstdarg>
+#include <cstdint>
 #include <fstream>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -68,6 +71,22 @@ namespace LogCategory {
     constexpr const char* DB = "db";
     constexpr const char* LOCK = "lock";
     constexpr const char* BENCH = "bench";
+    
+    /// Bit of a predefined category in the logger's category mask (0 for
+    /// any other name). Folds to a constant for the names above.
+    constexpr uint64_t Bit(std::string_view category) {
+        constexpr const char* names[] = {DEFAULT, NET, MEMPOOL, VALIDATION, WALLET, RPC,
+                                         CONSENSUS, MINING, IDENTITY, UBI, DB, LOCK, BENCH};
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+            if (category == names[i]) {
+                return uint64_t{1} << i;
+            }
+        }
+        return 0;
+    }
+    
+    /// Mask bit meaning every category is enabled
+    constexpr uint64_t ALL = uint64_t{1} << 63;
 }
 
 // ============================================================================
@@ -245,6 +264,18 @@ private:
 // Logger
 // ============================================================================
 
+/// What a full asynchronous queue does with a new entry
+enum class LogOverflow {
+    Drop,   // Discard the entry (counted in DroppedCount)
+    Block   // Wait for the writer thread to make room
+};
+
+/// Asynchronous logging configuration
+struct AsyncLogConfig {
+    size_t capacity{8192};   // Queued entries (rounded up to a power of two)
+    size_t batchSize{256};   // Entries written per sink lock
+};
+
 /// Main logger class
 class Logger {
 public:
@@ -282,7 +313,14 @@ public:
     void DisableCategory(const std::string& category);
     
     /// Check if category is enabled
-    bool IsCategoryEnabled(const std::string& category) const;
+    bool IsCategoryEnabled(std::string_view category) const {
+        uint64_t mask = categoryMask_.load(std::memory_order_relaxed);
+        if (mask & LogCategory::ALL) {
+            return true;
+        }
+        uint64_t bit = LogCategory::Bit(category);
+        return bit != 0 ? (mask & bit) != 0 : IsOtherCategoryEnabled(category);
+    }
     
     /// Enable all categories
     void EnableAllCategories();
@@ -301,11 +339,51 @@ public:
               const char* file, int line, const char* function,
               const char* format, ...);
     
-    /// Check if a message would be logged
-    bool WillLog(LogLevel level, const std::string& category) const;
+    /**
+     * Check if a message would be logged.
+     *
+     * Inline and lock-free (a relaxed load of the level, then of the
+     * category mask) so that disabled statements cost a compare and a
+     * branch; only names outside LogCategory take the category lock.
+     */
+    bool WillLog(LogLevel level, std::string_view category) const {
+        if (level < level_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return IsCategoryEnabled(category);
+    }
     
-    /// Flush all sinks
+    /// Flush all sinks (in async mode, after writing everything queued)
     void Flush();
+    
+    // ========================================================================
+    // Asynchronous Mode
+    // ========================================================================
+    
+    /**
+     * Write to the sinks from a background thread.
+     *
+     * Log() then only moves the entry into a bounded multi-producer ring
+     * buffer; the writer thread takes entries in batches and writes each
+     * batch under one sink lock. When the buffer is full, the entry's level
+     * decides between dropping it and waiting (see SetOverflowPolicy).
+     * Fatal entries are flushed before Log() returns.
+     */
+    void StartAsync(const AsyncLogConfig& config = AsyncLogConfig{});
+    
+    /// Write everything queued, stop the writer thread and go back to
+    /// writing from the calling thread
+    void StopAsync();
+    
+    /// Check if the writer thread is running
+    bool IsAsync() const { return asyncActive_.load(); }
+    
+    /// Set what a full queue does with entries of a level (default: drop
+    /// Trace and Debug, block on everything else)
+    void SetOverflowPolicy(LogLevel level, LogOverflow policy);
+    
+    /// Entries dropped by a full queue since the logger was created
+    uint64_t DroppedCount() const { return droppedCount_.load(); }
 
 private:
     Logger();
@@ -315,13 +393,31 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
+    /// Ring buffer and writer thread (defined with the logger)
+    class AsyncQueue;
+    
+    /// Write an entry to every sink
+    void WriteToSinks(const LogEntry& entry);
+    
+    /// Look up a category that has no mask bit
+    bool IsOtherCategoryEnabled(std::string_view category) const;
+    
     std::vector<std::shared_ptr<ILogSink>> sinks_;
     mutable std::mutex sinksMutex_;
     
+    std::unique_ptr<AsyncQueue> asyncQueue_;
+    std::mutex asyncMutex_;                     // Guards start and stop
+    std::atomic<bool> asyncActive_{false};
+    std::atomic<size_t> asyncProducers_{0};     // Threads inside the queue
+    std::atomic<uint64_t> droppedCount_{0};
+    std::atomic<LogOverflow> overflowPolicy_[static_cast<size_t>(LogLevel::Off) + 1]{
+        LogOverflow::Drop, LogOverflow::Drop, LogOverflow::Block, LogOverflow::Block,
+        LogOverflow::Block, LogOverflow::Block, LogOverflow::Block};
+    
     std::atomic<LogLevel> level_{LogLevel::Info};
-    std::unordered_set<std::string> enabledCategories_;
+    std::atomic<uint64_t> categoryMask_{LogCategory::ALL};
+    std::unordered_set<std::string> enabledCategories_;   // Names without a bit
     mutable std::mutex categoriesMutex_;
-    bool allCategoriesEnabled_{true};
     
     std::atomic<bool> initialized_{false};
 };
@@ -377,13 +473,33 @@ private:
 /// Get logger instance
 #define SHURIUM_LOGGER ::shurium::util::Logger::Instance()
 
-/// Check if logging is enabled
+/// Whether TRACE statements are compiled in (default: not in NDEBUG builds)
+#ifndef SHURIUM_LOG_TRACE_ENABLED
+#ifdef NDEBUG
+#define SHURIUM_LOG_TRACE_ENABLED 0
+#else
+#define SHURIUM_LOG_TRACE_ENABLED 1
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SHURIUM_LOG_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define SHURIUM_LOG_UNLIKELY(x) (x)
+#endif
+
+/// Check if logging is enabled. Levels compiled out fold to false, so
+/// neither the check nor the arguments are evaluated.
 #define SHURIUM_LOG_ENABLED(level, category) \
-    SHURIUM_LOGGER.WillLog(::shurium::util::LogLevel::level, category)
+    ((SHURIUM_LOG_TRACE_ENABLED || \
+      ::shurium::util::LogLevel::level != ::shurium::util::LogLevel::Trace) && \
+     SHURIUM_LOGGER.WillLog(::shurium::util::LogLevel::level, category))
 
-/// Log with level and category
+/// Log with level and category. The stream (and everything streamed into
+/// it) is only constructed once the statement is known to be enabled; the
+/// empty branch keeps a following else bound to the caller's if.
 #define SHURIUM_LOG(level, category) \
-    if (SHURIUM_LOG_ENABLED(level, category)) \
+    if (SHURIUM_LOG_UNLIKELY(!SHURIUM_LOG_ENABLED(level, category))) {} else \
         ::shurium::util::LogStream(::shurium::util::LogLevel::level, category, \
                                   __FILE__, __LINE__, __func__)
 
@@ -410,7 +526,7 @@ private:
 /// Printf-style logging
 #define SHURIUM_LOGF(level, category, ...) \
     do { \
-        if (SHURIUM_LOG_ENABLED(level, category)) { \
+        if (SHURIUM_LOG_UNLIKELY(SHURIUM_LOG_ENABLED(level, category))) { \
             SHURIUM_LOGGER.LogF(::shurium::util::LogLevel::level, category, \
                               __FILE__, __LINE__, __func__, __VA_ARGS__); \
         } \
@@ -0,0 +1,247 @@
+// SHURIUM - Metrics
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Counters, gauges and latency histograms that subsystems register by name
+// in one registry, read together on a scrape and rendered in the Prometheus
+// text format:
+// - Counters and histograms are sharded by thread, so updating them from
+//   many threads is a relaxed atomic add on a line no other core writes
+// - Histograms use log-linear (HDR-style) buckets: 8 per power of two, so
+//   any recorded value is known to within 12.5%
+// - Collectors turn existing statistics structs into samples on each scrape
+
+#ifndef SHURIUM_UTIL_METRICS_H
+#define SHURIUM_UTIL_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace shurium {
+namespace util {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Shards per counter and histogram (threads map onto them round-robin)
+static constexpr size_t METRIC_SHARDS = 8;
+
+/// Sub-buckets per power of two, as a bit count
+static constexpr size_t HISTOGRAM_SUB_BUCKET_BITS = 3;
+
+/// Largest power of two a histogram tells apart; larger values share the
+/// top bucket
+static constexpr size_t HISTOGRAM_MAX_BITS = 36;
+
+/// Buckets per histogram
+static constexpr size_t HISTOGRAM_BUCKETS =
+    (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1) << HISTOGRAM_SUB_BUCKET_BITS;
+
+/// Shard of the calling thread
+size_t MetricShard();
+
+// ============================================================================
+// Counter
+// ============================================================================
+
+/// Monotonic count
+class Counter {
+public:
+    void Inc(uint64_t n = 1) {
+        shards_[MetricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /// Sum over the shards
+    uint64_t Value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+// ============================================================================
+// Gauge
+// ============================================================================
+
+/// Value that goes up and down (queue depth, connections, ...)
+class Gauge {
+public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void Add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// ============================================================================
+// Histogram
+// ============================================================================
+
+/**
+ * Log-linear histogram of non-negative values (latencies in microseconds).
+ *
+ * Values below 8 get a bucket each; above that every power of two is split
+ * into 8 equal buckets.
+ */
+class Histogram {
+public:
+    /// Point-in-time sum of the shards
+    struct Snapshot {
+        uint64_t count{0};
+        uint64_t sum{0};
+        std::array<uint64_t, HISTOGRAM_BUCKETS> buckets{};
+
+        /// Upper bound of the bucket holding the given fraction (0..1) of
+        /// the values; 0 if empty
+        uint64_t ValueAt(double fraction) const;
+    };
+
+    /// Bucket a value falls in
+    static size_t BucketOf(uint64_t value);
+
+    /// Largest value in a bucket
+    static uint64_t BucketUpperBound(size_t bucket);
+
+    void Record(uint64_t value) {
+        Shard& shard = shards_[MetricShard()];
+        shard.buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    Snapshot GetSnapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> sum{0};
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+    };
+    std::array<Shard, METRIC_SHARDS> shards_;
+};
+
+/// Records the microseconds from construction to destruction
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLatency() {
+        histogram_.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start_).count()));
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// ============================================================================
+// Exposition
+// ============================================================================
+
+/**
+ * Builds a Prometheus text-format scrape.
+ *
+ * Names may carry labels ("name{peer=\"in\"}"); HELP and TYPE are written
+ * once per family as long as a family's samples are written together.
+ */
+class MetricsWriter {
+public:
+    void WriteCounter(const std::string& name, const std::string& help, double value);
+    void WriteGauge(const std::string& name, const std::string& help, double value);
+
+    /// A histogram as a summary: 0.5, 0.9, 0.99 and 0.999 quantiles since
+    /// start, with _sum and _count
+    void WriteSummary(const std::string& name, const std::string& help,
+                      const Histogram::Snapshot& snapshot);
+
+    const std::string& GetText() const { return text_; }
+
+private:
+    void WriteHeader(const std::string& family, const std::string& help, const char* type);
+    void WriteSample(const std::string& name, const std::string& suffix,
+                     const std::string& extraLabel, double value);
+
+    std::string text_;
+    std::string lastFamily_;
+};
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+/// Writes the samples of a subsystem's statistics on each scrape
+using MetricsCollector = std::function<void(MetricsWriter& writer)>;
+
+/**
+ * Named metrics of the process.
+ *
+ * Get* returns the metric registered under a name, creating it on first
+ * use; the reference stays valid for the life of the registry, so hot
+ * paths look it up once and keep it.
+ */
+class MetricsRegistry {
+public:
+    /// The process-wide registry
+    static MetricsRegistry& Instance();
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    Counter& GetCounter(const std::string& name, const std::string& help);
+    Gauge& GetGauge(const std::string& name, const std::string& help);
+    Histogram& GetHistogram(const std::string& name, const std::string& help);
+
+    /// Add or replace the collector registered under key
+    void RegisterCollector(const std::string& key, MetricsCollector collector);
+
+    /// Remove a collector. Once this returns it is not running and will
+    /// not run again, so what it reads may be destroyed.
+    void UnregisterCollector(const std::string& key);
+
+    /// Every metric, then every collector's samples, in the text format
+    std::string Render() const;
+
+private:
+    template<typename Metric>
+    struct Entry {
+        std::string help;
+        std::unique_ptr<Metric> metric;
+    };
+
+    /// Family then labels, so each family's series are adjacent
+    using Key = std::pair<std::string, std::string>;
+
+    template<typename Metric>
+    Metric& Get(std::map<Key, Entry<Metric>>& metrics, const std::string& name,
+                const std::string& help);
+
+    mutable std::mutex mutex_;                  // Guards the maps of metrics
+    mutable std::mutex collectMutex_;           // Held while collectors run
+    std::map<Key, Entry<Counter>> counters_;
+    std::map<Key, Entry<Gauge>> gauges_;
+    std::map<Key, Entry<Histogram>> histograms_;
+    std::map<std::string, MetricsCollector> collectors_;
+};
+
+} // namespace util
+} // namespace shurium
+
+#endif // SHURIUM_UTIL_METRICS_H
@@ -0,0 +1,240 @@
+// SHURIUM - Pool Memory Resource
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// A slab allocator for node-based containers. Small allocations are carved
+// out of large chunks and recycled through per-size free lists, so a map
+// with millions of nodes costs a handful of big allocations instead of one
+// heap allocation per node, and its memory use can be measured exactly.
+
+#ifndef SHURIUM_UTIL_POOLRESOURCE_H
+#define SHURIUM_UTIL_POOLRESOURCE_H
+
+#include "shurium/util/affinity.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace shurium {
+namespace util {
+
+// ============================================================================
+// PoolResource
+// ============================================================================
+
+/**
+ * Memory resource serving fixed-size blocks from large chunks.
+ *
+ * Requests up to MAX_BLOCK_SIZE_BYTES with an alignment no stricter than
+ * ALIGN_BYTES are rounded up to a multiple of ALIGN_BYTES and served from a
+ * free list for that size, or carved from the current chunk. Freed blocks
+ * go back on their free list; chunks are only released when the resource is
+ * destroyed. Larger or over-aligned requests go to operator new.
+ *
+ * Chunks may be asked to come from one NUMA node, so a container used by
+ * threads pinned there is not read across the interconnect.
+ *
+ * Not thread-safe; each container should own its own resource.
+ */
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+class PoolResource {
+    static_assert(ALIGN_BYTES > 0 && (ALIGN_BYTES & (ALIGN_BYTES - 1)) == 0,
+                  "ALIGN_BYTES must be a power of two");
+    static_assert(ALIGN_BYTES >= alignof(void*),
+                  "ALIGN_BYTES must fit a free list pointer");
+
+public:
+    /// Default chunk size (256 KiB)
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE_BYTES = 256 * 1024;
+
+    /// numaNode: node to place chunks on, -1 for the default policy
+    explicit PoolResource(std::size_t chunkSizeBytes = DEFAULT_CHUNK_SIZE_BYTES,
+                          int numaNode = -1)
+        : m_chunkSizeBytes(RoundUp(std::max(chunkSizeBytes, MAX_BLOCK_SIZE_BYTES))),
+          m_numaNode(numaNode) {}
+
+    ~PoolResource() {
+        for (void* chunk : m_chunks) {
+            ::operator delete(chunk, std::align_val_t{ALIGN_BYTES});
+        }
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    /// Allocate bytes with the given alignment
+    void* Allocate(std::size_t bytes, std::size_t alignment) {
+        if (!IsPooled(bytes, alignment)) {
+            m_oversizeBytes += bytes;
+            return ::operator new(bytes, std::align_val_t{alignment});
+        }
+
+        const std::size_t index = FreeListIndex(bytes);
+        if (ListNode* node = m_freeLists[index]) {
+            m_freeLists[index] = node->next;
+            return node;
+        }
+
+        const std::size_t blockBytes = index * ALIGN_BYTES;
+        if (static_cast<std::size_t>(m_chunkEnd - m_chunkPos) < blockBytes) {
+            AllocateChunk();
+        }
+        void* block = m_chunkPos;
+        m_chunkPos += blockBytes;
+        return block;
+    }
+
+    /// Return memory obtained from Allocate with the same size and alignment
+    void Deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept {
+        if (!IsPooled(bytes, alignment)) {
+            m_oversizeBytes -= bytes;
+            ::operator delete(p, std::align_val_t{alignment});
+            return;
+        }
+
+        const std::size_t index = FreeListIndex(bytes);
+        m_freeLists[index] = new (p) ListNode{m_freeLists[index]};
+    }
+
+    /// Number of chunks allocated so far
+    std::size_t NumAllocatedChunks() const { return m_chunks.size(); }
+
+    /// Size of each chunk in bytes
+    std::size_t ChunkSizeBytes() const { return m_chunkSizeBytes; }
+
+    /// NUMA node chunks are placed on, -1 if none
+    int PreferredNumaNode() const { return m_numaNode; }
+
+    /// Bytes currently held from the system (chunks plus oversize blocks)
+    std::size_t MemoryUsage() const {
+        return m_chunks.size() * m_chunkSizeBytes +
+               m_chunks.capacity() * sizeof(void*) +
+               m_oversizeBytes;
+    }
+
+private:
+    struct ListNode {
+        ListNode* next;
+    };
+
+    static constexpr std::size_t NUM_FREE_LISTS =
+        (MAX_BLOCK_SIZE_BYTES + ALIGN_BYTES - 1) / ALIGN_BYTES + 1;
+
+    static constexpr std::size_t RoundUp(std::size_t bytes) {
+        return (bytes + ALIGN_BYTES - 1) & ~(ALIGN_BYTES - 1);
+    }
+
+    static constexpr bool IsPooled(std::size_t bytes, std::size_t alignment) {
+        return bytes <= MAX_BLOCK_SIZE_BYTES && alignment <= ALIGN_BYTES;
+    }
+
+    static constexpr std::size_t FreeListIndex(std::size_t bytes) {
+        return RoundUp(std::max<std::size_t>(bytes, 1)) / ALIGN_BYTES;
+    }
+
+    void AllocateChunk() {
+        // Put the unused tail of the current chunk onto its free list
+        const std::size_t remaining = static_cast<std::size_t>(m_chunkEnd - m_chunkPos);
+        if (remaining > 0) {
+            const std::size_t index = remaining / ALIGN_BYTES;
+            m_freeLists[index] = new (m_chunkPos) ListNode{m_freeLists[index]};
+        }
+
+        void* chunk = ::operator new(m_chunkSizeBytes, std::align_val_t{ALIGN_BYTES});
+        if (m_numaNode >= 0) {
+            // Before first touch, so the pages fault in on the node
+            BindToNumaNode(chunk, m_chunkSizeBytes, m_numaNode);
+        }
+        m_chunks.push_back(chunk);
+        m_chunkPos = static_cast<std::byte*>(chunk);
+        m_chunkEnd = m_chunkPos + m_chunkSizeBytes;
+    }
+
+    const std::size_t m_chunkSizeBytes;
+    const int m_numaNode;
+    std::array<ListNode*, NUM_FREE_LISTS> m_freeLists{};
+    std::vector<void*> m_chunks;
+    std::byte* m_chunkPos{nullptr};
+    std::byte* m_chunkEnd{nullptr};
+    std::size_t m_oversizeBytes{0};
+};
+
+// ============================================================================
+// PoolAllocator
+// ============================================================================
+
+/**
+ * Standard allocator drawing from a shared PoolResource.
+ *
+ * A default-constructed allocator creates a fresh resource; copies (and
+ * rebinds) share it, so a container and all its internal allocations use
+ * one pool. Copying a container gives the copy its own pool.
+ */
+template <typename T, std::size_t MAX_BLOCK_SIZE_BYTES,
+          std::size_t ALIGN_BYTES = alignof(std::max_align_t)>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using ResourceType = PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>;
+    };
+
+    PoolAllocator() : m_resource(std::make_shared<ResourceType>()) {}
+
+    explicit PoolAllocator(std::shared_ptr<ResourceType> resource)
+        : m_resource(std::move(resource)) {}
+
+    // Moves copy so a moved-from container keeps a usable pool
+    PoolAllocator(const PoolAllocator&) = default;
+    PoolAllocator& operator=(const PoolAllocator&) = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) noexcept
+        : m_resource(other.Resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(m_resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        m_resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    /// A copied container gets a pool of its own
+    PoolAllocator select_on_container_copy_construction() const {
+        return PoolAllocator();
+    }
+
+    const std::shared_ptr<ResourceType>& Resource() const { return m_resource; }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) const {
+        return m_resource == other.Resource();
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) const {
+        return !(*this == other);
+    }
+
+private:
+    std::shared_ptr<ResourceType> m_resource;
+};
+
+} // namespace util
+} // namespace shurium
+
+#endif // SHURIUM_UTIL_POOLRESOURCE_H
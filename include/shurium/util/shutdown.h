@@ -0,0 +1,89 @@
+// SHURIUM - Shutdown Coordinator
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Orders teardown into stages. Steps within a stage are independent and run
+// in parallel, and a stage may carry a deadline after which still-running
+// steps are left behind; critical stages (flushing consensus state) run
+// their steps one after another on the caller's thread with no deadline.
+
+#ifndef SHURIUM_UTIL_SHUTDOWN_H
+#define SHURIUM_UTIL_SHUTDOWN_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace util {
+
+/**
+ * Staged, timed teardown.
+ *
+ * Build the stages in order with AddStage() and AddStep(), then Run(). A
+ * step that misses its stage's deadline keeps running detached, so it must
+ * own everything it touches (move the subsystem into the step) and be safe
+ * to cut short by process exit, like a save through a temporary file and
+ * rename. Anything that must complete belongs in a critical stage.
+ */
+class ShutdownCoordinator {
+public:
+    /// Deadline of a stage that waits for every step
+    static constexpr std::chrono::milliseconds NO_DEADLINE{0};
+
+    /// How a step ended
+    enum class Outcome { DONE, FAILED, TIMED_OUT };
+
+    struct StepTiming {
+        std::string name;
+        std::chrono::microseconds elapsed{0};
+        Outcome outcome{Outcome::DONE};
+    };
+
+    struct StageTiming {
+        std::string name;
+        bool critical{false};
+        std::chrono::microseconds elapsed{0};
+        std::vector<StepTiming> steps;
+    };
+
+    /// Start a stage whose steps run in parallel, up to deadline
+    /// (NO_DEADLINE waits for all of them)
+    ShutdownCoordinator& AddStage(const std::string& name,
+                                  std::chrono::milliseconds deadline = NO_DEADLINE);
+
+    /// Start a stage whose steps run in order on the calling thread
+    ShutdownCoordinator& AddCriticalStage(const std::string& name);
+
+    /// Add a step to the stage added last; exceptions count as failure
+    ShutdownCoordinator& AddStep(const std::string& name, std::function<void()> step);
+
+    /// Run every stage in order and log the timing breakdown
+    void Run();
+
+    /// Timings of the last Run()
+    const std::vector<StageTiming>& GetTimings() const { return timings_; }
+
+    /// One line per stage, e.g. "network 120ms [connman 118ms, rpc 4ms]"
+    std::string FormatTimings() const;
+
+private:
+    struct Stage {
+        std::string name;
+        bool critical{false};
+        std::chrono::milliseconds deadline{NO_DEADLINE};
+        std::vector<std::pair<std::string, std::function<void()>>> steps;
+    };
+
+    StageTiming RunCritical(Stage& stage);
+    StageTiming RunParallel(Stage& stage);
+
+    std::vector<Stage> stages_;
+    std::vector<StageTiming> timings_;
+};
+
+} // namespace util
+} // namespace shurium
+
+#endif // SHURIUM_UTIL_SHUTDOWN_H
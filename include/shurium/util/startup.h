@@ -0,0 +1,156 @@
+// SHURIUM - Startup Profile
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Records how long each initialization phase of the daemon takes and
+// whether the node is ready to serve. The phases are timed where they run
+// (node/context.cpp, shuriumd.cpp); readiness is what orchestrators poll,
+// through getnodereadiness or GET /ready, before routing traffic.
+
+#ifndef SHURIUM_UTIL_STARTUP_H
+#define SHURIUM_UTIL_STARTUP_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace util {
+
+/// Initialization phases, in the order the daemon runs them
+enum class StartupPhase {
+    CONFIG,         ///< Command line, config file, data directory, logging
+    DATABASES,      ///< Block, UTXO and index databases opened
+    CHAINSTATE,     ///< Chain state manager set up and best chain activated
+    BLOCK_INDEX,    ///< Block index loaded (or rebuilt) and verified
+    MEMPOOL,        ///< Mempool created and the saved one reloaded
+    WALLET,         ///< Wallet loaded or created
+    NETWORK,        ///< P2P network and block sync started
+};
+
+/// Number of StartupPhase values
+static constexpr size_t NUM_STARTUP_PHASES = 7;
+
+/// Name of a phase as reported, e.g. "block_index"
+const char* StartupPhaseName(StartupPhase phase);
+
+/**
+ * Phase timings and readiness of one node start.
+ *
+ * Thread-safe: the mempool phase ends on its loader thread while RPC reads
+ * the report. A phase may be entered more than once (chain state setup is
+ * split around the block index load); its times add up.
+ *
+ * The node is ready once the daemon called MarkStarted(), no phase is still
+ * pending or running, and MarkStopping() has not been called. A failed phase
+ * does not hold readiness back: the fatal ones end the process, the rest
+ * (an unreadable saved mempool) leave a node that serves fine.
+ */
+class StartupProfile {
+public:
+    enum class State { PENDING, RUNNING, DONE, SKIPPED, FAILED };
+
+    struct PhaseTiming {
+        StartupPhase phase;
+        State state{State::PENDING};
+        std::chrono::microseconds elapsed{0};
+    };
+
+    StartupProfile();
+
+    /// Enter a phase
+    void Begin(StartupPhase phase);
+
+    /// Leave a phase, adding the time since Begin()
+    void End(StartupPhase phase, bool success = true);
+
+    /// Record a phase timed before this profile existed; the startup time
+    /// then counts from when that phase began
+    void Record(StartupPhase phase, std::chrono::microseconds elapsed);
+
+    /// Mark a phase that does not apply (wallet disabled)
+    void Skip(StartupPhase phase);
+
+    /// Every startup step has run; logs the report
+    void MarkStarted();
+
+    /// Shutdown has begun; the node stops being ready (signal-safe)
+    void MarkStopping() { stopping_.store(true, std::memory_order_relaxed); }
+
+    /// Whether the node can serve
+    bool IsReady() const;
+
+    /// Why the node is not ready, e.g. "mempool running" (empty when ready)
+    std::vector<std::string> GetBlockers() const;
+
+    /// Every phase in order
+    std::vector<PhaseTiming> GetPhases() const;
+
+    /// Time from construction to MarkStarted(), or so far if not started
+    std::chrono::microseconds GetStartupTime() const;
+
+    /// One line, e.g. "config 2ms, databases 140ms, ..., network 3ms"
+    std::string FormatReport() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        State state{State::PENDING};
+        std::chrono::microseconds elapsed{0};
+        Clock::time_point begin;
+    };
+
+    mutable std::mutex mutex_;
+    Clock::time_point created_;
+    Clock::time_point started_;
+    std::array<Entry, NUM_STARTUP_PHASES> phases_;
+    bool startedFlag_{false};
+    std::atomic<bool> stopping_{false};
+};
+
+/// Human-readable state name ("pending", "running", "done", ...)
+const char* StartupStateName(StartupProfile::State state);
+
+/**
+ * Times one phase for the scope it lives in. The phase is marked failed
+ * unless Done() is called, so early error returns need no extra code.
+ */
+class StartupPhaseTimer {
+public:
+    StartupPhaseTimer(StartupProfile& profile, StartupPhase phase)
+        : profile_(profile), phase_(phase) {
+        profile_.Begin(phase_);
+    }
+
+    ~StartupPhaseTimer() {
+        if (!done_) {
+            profile_.End(phase_, false);
+        }
+    }
+
+    StartupPhaseTimer(const StartupPhaseTimer&) = delete;
+    StartupPhaseTimer& operator=(const StartupPhaseTimer&) = delete;
+
+    /// The phase succeeded
+    void Done() {
+        if (!done_) {
+            done_ = true;
+            profile_.End(phase_, true);
+        }
+    }
+
+private:
+    StartupProfile& profile_;
+    StartupPhase phase_;
+    bool done_{false};
+};
+
+} // namespace util
+} // namespace shurium
+
+#endif // SHURIUM_UTIL_STARTUP_H
@@ -3,26 +3,32 @@
 // MIT License
 //
 // Provides a flexible thread pool for async task execution:
-// - Work-stealing queue
+// - Work stealing: per-worker deques plus a shared injection queue
 // - Futures for result retrieval
 // - Task priorities
 // - Graceful shutdown
+// - Delayed and periodic tasks on a hierarchical timer wheel
 
 #ifndef SHURIUM_UTIL_THREADPOOL_H
 #define SHURIUM_UTIL_THREADPOOL_H
 
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <new>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace shurium {
@@ -40,12 +46,87 @@ enum class TaskPriority {
     Critical = 3
 };
 
+// ============================================================================
+// Task Storage
+// ============================================================================
+
+namespace detail {
+
+/**
+ * A queued task: the callable is stored inline when it fits (no
+ * std::function), and nodes are recycled through a per-thread free list, so
+ * a task submitted from a worker usually costs no allocation at all.
+ */
+class TaskNode {
+public:
+    /// Callables up to this size are stored in the node itself
+    static constexpr size_t INLINE_SIZE = 64;
+    
+    template<typename F>
+    static TaskNode* Create(F&& f, TaskPriority priority);
+    
+    /// Run the callable (once)
+    void Run() { invoke_(callable_); }
+    
+    /// Destroy the callable and recycle the node
+    static void Destroy(TaskNode* node);
+    
+    TaskPriority Priority() const { return priority_; }
+
+private:
+    TaskNode() = default;
+    
+    void (*invoke_)(void*){nullptr};
+    void (*drop_)(void*){nullptr};
+    void* callable_{nullptr};
+    TaskPriority priority_{TaskPriority::Normal};
+    alignas(std::max_align_t) unsigned char storage_[INLINE_SIZE];
+};
+
+/// Node memory from the calling thread's free list
+void* AllocateTaskNode();
+
+/// Return node memory to the calling thread's free list
+void FreeTaskNode(void* memory) noexcept;
+
+template<typename F>
+TaskNode* TaskNode::Create(F&& f, TaskPriority priority) {
+    using Fn = std::decay_t<F>;
+    void* memory = AllocateTaskNode();
+    TaskNode* node = new (memory) TaskNode;
+    node->priority_ = priority;
+    try {
+        if constexpr (sizeof(Fn) <= INLINE_SIZE &&
+                      alignof(Fn) <= alignof(std::max_align_t)) {
+            node->callable_ = new (node->storage_) Fn(std::forward<F>(f));
+            node->drop_ = [](void* p) { static_cast<Fn*>(p)->~Fn(); };
+        } else {
+            node->callable_ = new Fn(std::forward<F>(f));
+            node->drop_ = [](void* p) { delete static_cast<Fn*>(p); };
+        }
+    } catch (...) {
+        node->~TaskNode();
+        FreeTaskNode(memory);
+        throw;
+    }
+    node->invoke_ = [](void* p) { (*static_cast<Fn*>(p))(); };
+    return node;
+}
+
+} // namespace detail
+
 // ============================================================================
 // Thread Pool
 // ============================================================================
 
 /**
- * A thread pool for executing tasks asynchronously.
+ * A work-stealing thread pool for executing tasks asynchronously.
+ * 
+ * Each worker owns a Chase-Lev deque. Normal priority tasks submitted from
+ * a worker go onto its own deque (popped LIFO by the owner, stolen FIFO by
+ * idle workers); everything else goes through a shared injection queue with
+ * one lane per priority. Workers look for work in the order: Critical and
+ * High lanes, own deque, Normal lane, other workers' deques, Low lane.
  * 
  * Features:
  * - Configurable number of worker threads
@@ -59,7 +140,7 @@ public:
     struct Config {
         size_t numThreads{0};       // 0 = hardware concurrency
         size_t maxQueueSize{10000}; // Maximum pending tasks
-        std::string name{"pool"};   // Pool name for logging
+        std::string name{"pool"};   // Pool name for logging and thread placement
         bool startImmediately{true};// Start workers on construction
     };
     
@@ -133,27 +214,12 @@ public:
         
         using ReturnType = typename std::invoke_result<F, Args...>::type;
         
-        auto task = std::make_shared<std::packaged_task<ReturnType()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-        
-        std::future<ReturnType> result = task->get_future();
+        std::packaged_task<ReturnType()> task(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        std::future<ReturnType> result = task.get_future();
         
-        {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            
-            if (!running_.load()) {
-                throw std::runtime_error("ThreadPool not running");
-            }
-            
-            if (tasks_.size() >= config_.maxQueueSize) {
-                throw std::runtime_error("ThreadPool queue full");
-            }
-            
-            tasks_.emplace(priority, [task]() { (*task)(); });
-        }
-        
-        condition_.notify_one();
+        Enqueue(detail::TaskNode::Create(
+            [task = std::move(task)]() mutable { task(); }, priority), true);
         return result;
     }
     
@@ -172,23 +238,8 @@ public:
      */
     template<typename F, typename... Args>
     void ExecuteWithPriority(TaskPriority priority, F&& f, Args&&... args) {
-        auto func = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        
-        {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            
-            if (!running_.load()) {
-                throw std::runtime_error("ThreadPool not running");
-            }
-            
-            if (tasks_.size() >= config_.maxQueueSize) {
-                throw std::runtime_error("ThreadPool queue full");
-            }
-            
-            tasks_.emplace(priority, std::move(func));
-        }
-        
-        condition_.notify_one();
+        Enqueue(detail::TaskNode::Create(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...), priority), true);
     }
     
     /**
@@ -206,51 +257,55 @@ public:
      */
     template<typename F, typename... Args>
     bool TrySubmitWithPriority(TaskPriority priority, F&& f, Args&&... args) {
-        auto func = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        
-        {
-            std::unique_lock<std::mutex> lock(queueMutex_);
-            
-            if (!running_.load() || tasks_.size() >= config_.maxQueueSize) {
-                return false;
-            }
-            
-            tasks_.emplace(priority, std::move(func));
-        }
-        
-        condition_.notify_one();
-        return true;
+        return Enqueue(detail::TaskNode::Create(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...), priority), false);
     }
 
 private:
-    /// Task with priority
-    struct PrioritizedTask {
-        TaskPriority priority;
-        std::function<void()> task;
-        
-        PrioritizedTask(TaskPriority p, std::function<void()> t)
-            : priority(p), task(std::move(t)) {}
-        
-        /// Comparison for priority queue (higher priority first)
-        bool operator<(const PrioritizedTask& other) const {
-            return priority < other.priority;
-        }
-    };
+    /// A worker's deque (defined with the pool)
+    class Worker;
+    
+    /// Number of priority lanes in the injection queue
+    static constexpr size_t PRIORITY_LANES = 4;
+    
+    /**
+     * Queue a task, or destroy it and fail if the pool is stopped or full
+     * (throwing std::runtime_error when shouldThrow is set).
+     */
+    bool Enqueue(detail::TaskNode* node, bool shouldThrow);
+    
+    /// Next task for worker index, in priority order (nullptr if none)
+    detail::TaskNode* FindTask(size_t index);
+    
+    /// Pop from one injection lane
+    detail::TaskNode* TakeInjected(TaskPriority priority);
+    
+    /// Wake a sleeping worker if there is one
+    void NotifyWorker();
     
     Config config_;
     std::vector<std::thread> workers_;
-    std::priority_queue<PrioritizedTask> tasks_;
+    std::vector<std::unique_ptr<Worker>> queues_;
+    
+    /// Injection queue for tasks submitted from outside the workers
+    mutable std::mutex injectMutex_;
+    std::deque<detail::TaskNode*> injected_[PRIORITY_LANES];
+    std::atomic<size_t> injectedCount_[PRIORITY_LANES]{};
     
+    /// Sleeping workers wait here
     mutable std::mutex queueMutex_;
     std::condition_variable condition_;
     std::condition_variable waitCondition_;
+    std::atomic<size_t> idleWorkers_{0};
+    std::atomic<size_t> waiters_{0};
     
     std::atomic<bool> running_{false};
     std::atomic<bool> stopping_{false};
+    std::atomic<size_t> pendingTasks_{0};
     std::atomic<size_t> activeTasks_{0};
     
     /// Worker thread function
-    void WorkerLoop();
+    void WorkerLoop(size_t index);
 };
 
 // ============================================================================
@@ -270,6 +325,37 @@ void ShutdownGlobalThreadPool();
 // Parallel Algorithms
 // ============================================================================
 
+namespace detail {
+
+/**
+ * Run body(lo, hi) over [begin, end) in chunks of grain indices. The
+ * calling thread claims chunks alongside up to one task per pool worker,
+ * and returns once every index is done (rethrowing the first exception).
+ * Since the caller works too, this is safe to call from a pool worker.
+ */
+void ParallelChunks(size_t begin, size_t end, size_t grain,
+                    const std::function<void(size_t, size_t)>& body,
+                    ThreadPool& pool);
+
+} // namespace detail
+
+/**
+ * Execute a function in parallel over an index range.
+ * 
+ * Indices are handed out in chunks of grain (0 = about eight chunks per
+ * worker), so per-index work can be small.
+ */
+template<typename Func>
+void ParallelForIndex(size_t begin, size_t end, Func func,
+                       ThreadPool& pool = GetGlobalThreadPool(),
+                       size_t grain = 0) {
+    detail::ParallelChunks(begin, end, grain, [&func](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            func(i);
+        }
+    }, pool);
+}
+
 /**
  * Execute a function in parallel over a range.
  * 
@@ -283,31 +369,16 @@ void ShutdownGlobalThreadPool();
 template<typename Iterator, typename Func>
 void ParallelFor(Iterator begin, Iterator end, Func func,
                   ThreadPool& pool = GetGlobalThreadPool()) {
-    std::vector<std::future<void>> futures;
-    
-    for (auto it = begin; it != end; ++it) {
-        futures.push_back(pool.Submit([&func, it]() { func(*it); }));
-    }
-    
-    for (auto& f : futures) {
-        f.get();
-    }
-}
-
-/**
- * Execute a function in parallel over an index range.
- */
-template<typename Func>
-void ParallelForIndex(size_t begin, size_t end, Func func,
-                       ThreadPool& pool = GetGlobalThreadPool()) {
-    std::vector<std::future<void>> futures;
-    
-    for (size_t i = begin; i < end; ++i) {
-        futures.push_back(pool.Submit([&func, i]() { func(i); }));
-    }
-    
-    for (auto& f : futures) {
-        f.get();
+    using Category = typename std::iterator_traits<Iterator>::iterator_category;
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag, Category>) {
+        ParallelForIndex(0, static_cast<size_t>(end - begin),
+                         [&](size_t i) { func(begin[i]); }, pool);
+    } else {
+        std::vector<Iterator> items;
+        for (auto it = begin; it != end; ++it) {
+            items.push_back(it);
+        }
+        ParallelForIndex(0, items.size(), [&](size_t i) { func(*items[i]); }, pool);
     }
 }
 
@@ -318,16 +389,14 @@ template<typename InputIterator, typename OutputIterator, typename Func>
 void ParallelMap(InputIterator inBegin, InputIterator inEnd,
                   OutputIterator outBegin, Func func,
                   ThreadPool& pool = GetGlobalThreadPool()) {
-    std::vector<std::future<void>> futures;
-    
+    std::vector<std::pair<InputIterator, OutputIterator>> items;
     auto out = outBegin;
     for (auto in = inBegin; in != inEnd; ++in, ++out) {
-        futures.push_back(pool.Submit([&func, in, out]() { *out = func(*in); }));
-    }
-    
-    for (auto& f : futures) {
-        f.get();
+        items.emplace_back(in, out);
     }
+    ParallelForIndex(0, items.size(), [&](size_t i) {
+        *items[i].second = func(*items[i].first);
+    }, pool);
 }
 
 // ============================================================================
@@ -466,8 +535,93 @@ size_t WaitAny(std::vector<std::future<T>>& futures) {
 // Scheduled Tasks
 // ============================================================================
 
+/**
+ * Hierarchical timer wheel.
+ *
+ * Four levels of 64 slots; level n covers 64^(n+1) ticks, so with
+ * millisecond ticks the wheel spans about 4.6 hours (later timers wait in
+ * the top level and are placed again as it turns). Each slot is an
+ * intrusive list and each level keeps a bitmap of its non-empty slots, so
+ * Add and Cancel are O(1), a timer is moved at most once per level on its
+ * way down, and the next tick with work is found with a few bit scans.
+ *
+ * Not thread-safe; Scheduler guards it with its mutex.
+ */
+class TimerWheel {
+public:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    
+    /// A timer that came due
+    struct Expired {
+        uint64_t id;
+        std::shared_ptr<std::function<void()>> task;
+    };
+    
+    TimerWheel() = default;
+    ~TimerWheel();
+    
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    
+    /**
+     * Add a timer due at tick expiry (ticks already passed fire on the next
+     * Advance). A non-zero period re-arms the timer period ticks after the
+     * tick it fired at. Returns false if id is already in use.
+     */
+    bool Add(uint64_t id, uint64_t expiry, uint64_t period, std::function<void()> task);
+    
+    /// Remove a timer; false if there is none with this id
+    bool Cancel(uint64_t id);
+    
+    /// Remove every timer
+    void Clear();
+    
+    /// Number of timers
+    size_t Size() const { return timers_.size(); }
+    
+    /// First tick not yet processed
+    uint64_t CurrentTick() const { return currentTick_; }
+    
+    /// Process every tick up to and including now, appending the timers
+    /// that came due (in tick order)
+    void Advance(uint64_t now, std::vector<Expired>& expired);
+    
+    /// Earliest tick at which Advance has work: a timer due or a slot to
+    /// move down a level (UINT64_MAX if empty)
+    uint64_t NextTick() const;
+
+private:
+    struct Timer {
+        uint64_t id;
+        uint64_t expiry;
+        uint64_t period;
+        std::shared_ptr<std::function<void()>> task;
+        Timer* prev{nullptr};
+        Timer* next{nullptr};
+        uint8_t level{0};
+        uint8_t slot{0};
+    };
+    
+    void Link(Timer* timer);
+    void Unlink(Timer* timer);
+    
+    /// Move the timers of a slot down; returns the slot index
+    size_t Cascade(size_t level);
+    
+    uint64_t currentTick_{0};
+    Timer* slots_[LEVELS][SLOTS]{};
+    uint64_t occupied_[LEVELS]{};
+    std::unordered_map<uint64_t, std::unique_ptr<Timer>> timers_;
+};
+
 /**
  * Scheduler for delayed and periodic tasks.
+ *
+ * Timers live in a TimerWheel with millisecond ticks. The scheduler thread
+ * sleeps until the wheel's next tick with work, then hands every timer that
+ * came due to the thread pool after releasing the lock.
  */
 class Scheduler {
 public:
@@ -534,31 +688,27 @@ public:
     size_t TaskCount() const;
 
 private:
-    struct ScheduledTask {
-        uint64_t id;
-        std::chrono::steady_clock::time_point nextRun;
-        std::chrono::milliseconds period;
-        std::function<void()> task;
-        bool cancelled{false};
-        
-        bool operator>(const ScheduledTask& other) const {
-            return nextRun > other.nextRun;
-        }
-    };
-    
     ThreadPool* pool_;
     bool ownPool_{false};
     std::thread schedulerThread_;
     
     mutable std::mutex mutex_;
     std::condition_variable condition_;
-    std::priority_queue<ScheduledTask, std::vector<ScheduledTask>,
-                        std::greater<ScheduledTask>> tasks_;
+    TimerWheel wheel_;
+    
+    /// Tick 0 of the wheel
+    std::chrono::steady_clock::time_point epoch_{std::chrono::steady_clock::now()};
+    
+    /// Tick the scheduler thread sleeps until (UINT64_MAX if idle)
+    uint64_t wakeTick_{UINT64_MAX};
     
     std::atomic<bool> running_{false};
     std::atomic<uint64_t> nextId_{1};
     
-    /// Add task to queue
+    /// First tick at or after time
+    uint64_t TickAt(std::chrono::steady_clock::time_point time) const;
+    
+    /// Add task to the wheel
     uint64_t ScheduleTask(std::chrono::steady_clock::time_point time,
                            std::chrono::milliseconds period,
                            std::function<void()> func);
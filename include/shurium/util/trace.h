@@ -0,0 +1,94 @@
+// SHURIUM - Trace Spans
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Timed spans around hot paths (block connection, mempool acceptance, RPC
+// dispatch, ...), for seeing where one slow block or call spent its time
+// where the metrics only show distributions. Each thread records into a
+// ring buffer of its own; dumptrace renders them as Chrome trace JSON
+// (chrome://tracing, Perfetto). Where <sys/sdt.h> is available every span
+// also fires the USDT probe shurium:span for eBPF tools.
+//
+// Spans are compiled in only when the build defines SHURIUM_TRACING
+// (cmake -DSHURIUM_TRACING=ON); in other builds SHURIUM_TRACE_SPAN is
+// empty and the buffers are never allocated.
+
+#ifndef SHURIUM_UTIL_TRACE_H
+#define SHURIUM_UTIL_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace shurium {
+namespace util {
+
+// ============================================================================
+// Events
+// ============================================================================
+
+/// Spans kept per thread; older ones are overwritten
+static constexpr size_t TRACE_BUFFER_EVENTS = 8192;
+
+/// One finished span
+struct TraceEvent {
+    /// Static string naming the span
+    const char* name{nullptr};
+
+    /// Nanoseconds since the process started tracing
+    uint64_t startNs{0};
+    uint64_t durationNs{0};
+};
+
+/// Spans recorded by one thread, oldest first
+struct ThreadTrace {
+    /// Small number identifying the thread in the dump
+    uint32_t threadId{0};
+    std::vector<TraceEvent> events;
+};
+
+/// True if this build compiles spans in
+bool TracingEnabled();
+
+/// Snapshot of every thread's buffer, threads that have exited included
+/// until their buffer is reused
+std::vector<ThreadTrace> GetTrace();
+
+/// Drop the recorded spans
+void ClearTrace();
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+namespace detail {
+
+uint64_t TraceClock();
+void RecordSpan(const char* name, uint64_t startNs, uint64_t durationNs);
+
+} // namespace detail
+
+/// Records the time from construction to destruction under a static name
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) : name_(name), start_(detail::TraceClock()) {}
+    ~TraceSpan() { detail::RecordSpan(name_, start_, detail::TraceClock() - start_); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+} // namespace util
+} // namespace shurium
+
+#ifdef SHURIUM_TRACING
+#define SHURIUM_TRACE_SPAN(name) ::shurium::util::TraceSpan shuriumTraceSpan_(name)
+#else
+#define SHURIUM_TRACE_SPAN(name) ((void)0)
+#endif
+
+#endif // SHURIUM_UTIL_TRACE_H
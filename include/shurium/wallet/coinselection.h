@@ -99,9 +99,19 @@ struct SelectionResult {
     /// Algorithm used
     std::string algorithm;
     
+    /// Search nodes visited (Branch and Bound only)
+    size_t iterations;
+    
+    /// Was the whole search space explored within budget? (Branch and Bound only)
+    bool searchExhausted;
+    
+    /// Time spent searching in microseconds (Branch and Bound only)
+    int64_t searchTimeUs;
+    
     /// Constructor
     SelectionResult() : totalValue(0), totalEffectiveValue(0), inputFee(0),
-                        change(0), success(false) {}
+                        change(0), success(false), iterations(0),
+                        searchExhausted(false), searchTimeUs(0) {}
     
     /// Get number of selected outputs
     size_t Size() const { return selected.size(); }
@@ -155,13 +165,20 @@ struct SelectionParams {
     /// Prefer confirmed outputs?
     bool preferConfirmed;
     
+    /// Branch and Bound node budget
+    size_t bnbMaxIterations;
+    
+    /// Branch and Bound time budget in microseconds (0 = no limit)
+    int64_t bnbTimeBudgetUs;
+    
     /// Constructor with defaults
     SelectionParams()
         : targetValue(0), feeRate(1), fixedFee(0)
         , outputSize(34), outputCount(1), minChange(546)
         , maxChange(1000000), changeOutputSize(32)
         , minConfirmations(0), maxInputs(500)
-        , includeUnconfirmed(true), preferConfirmed(true) {}
+        , includeUnconfirmed(true), preferConfirmed(true)
+        , bnbMaxIterations(100000), bnbTimeBudgetUs(0) {}
     
     /// Get cost of change output
     Amount GetChangeCost() const {
@@ -184,12 +201,21 @@ struct SelectionParams {
  * Attempts to find an exact match (no change) within a tolerance.
  * This is optimal for avoiding change outputs and thus improving privacy.
  * 
+ * The search is a depth-first walk over the effective values sorted
+ * descending, kept in flat arrays sized once up front. A suffix sum of the
+ * values cuts every branch that can no longer reach the target, and a
+ * branch that leaves out an output skips the equal values after it, which
+ * would only repeat the same sums. Of the selections within the cost of
+ * change, the one with the least excess wins; the walk stops early on an
+ * exact match, and otherwise when the node or time budget of the
+ * parameters runs out, keeping the best selection found so far.
+ * 
  * Based on: "An Efficient Algorithm for Finding Multiple Solutions to
  * Bounded Knapsack Problems"
  */
 class BranchAndBound {
 public:
-    /// Maximum iterations to try
+    /// Default node budget (SelectionParams::bnbMaxIterations)
     static constexpr size_t MAX_ITERATIONS = 100000;
     
     /// Select coins using branch and bound
@@ -198,16 +224,6 @@ public:
     /// @return Selection result
     static SelectionResult Select(std::vector<OutputGroup> outputs,
                                    const SelectionParams& params);
-
-private:
-    /// Recursive search
-    static bool Search(const std::vector<OutputGroup>& outputs,
-                       Amount target,
-                       Amount costOfChange,
-                       std::vector<bool>& selection,
-                       Amount currentValue,
-                       size_t depth,
-                       size_t& iterations);
 };
 
 /**
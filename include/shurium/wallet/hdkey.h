@@ -13,10 +13,12 @@
 #define SHURIUM_WALLET_HDKEY_H
 
 #include <shurium/core/types.h>
+#include <shurium/crypto/hmac.h>
 #include <shurium/crypto/keys.h>
 
 #include <array>
 #include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <optional>
@@ -179,6 +181,15 @@ public:
     /// @param index Child index (use | HARDENED_FLAG for hardened)
     std::optional<ExtendedKey> DeriveChild(uint32_t index) const;
     
+    /// Derive the children first, first + 1, ..., first + count - 1
+    ///
+    /// Each entry equals DeriveChild(first + i), nullopt included, but the
+    /// parent public key and fingerprint are computed once for the range, and
+    /// for a public parent all the child points share one field inversion.
+    /// The range is cut short at index 0xFFFFFFFF.
+    std::vector<std::optional<ExtendedKey>> DeriveChildren(uint32_t first,
+                                                           uint32_t count) const;
+    
     /// Derive key at path
     std::optional<ExtendedKey> DerivePath(const DerivationPath& path) const;
     
@@ -225,8 +236,9 @@ public:
     static std::optional<ExtendedKey> FromBytes(const Byte* data, size_t len);
 
 private:
-    /// Key data (private: 32 bytes, public: 33 bytes compressed)
-    std::array<Byte, 33> keyData_;
+    /// Key data (private: 32 bytes, public: 33 bytes compressed), in a
+    /// locked SecurePool slot
+    SecureBytes<33> keyData_;
     
     /// Chain code for derivation
     std::array<Byte, CHAIN_CODE_SIZE> chainCode_;
@@ -246,6 +258,10 @@ private:
     /// Is this key valid?
     bool isValid_{false};
     
+    /// HMAC-SHA512 keyed by the chain code, for deriving children; set
+    /// whenever the key is valid
+    std::optional<HMAC_SHA512_Midstate> chainHmac_;
+    
     /// Derive private child key
     std::optional<ExtendedKey> DerivePrivateChild(uint32_t index) const;
     
@@ -379,6 +395,43 @@ public:
     /// Derive specific key
     std::optional<KeyInfo> DeriveKey(uint32_t account, uint32_t change, uint32_t index);
     
+    /// Derive keys first, first + 1, ..., first + count - 1 of one chain
+    ///
+    /// Equivalent to DeriveKey for each index, skipping indices that do not
+    /// yield a key, but the chain key is derived once and the key hashes are
+    /// computed together with Hash160_33.
+    std::vector<KeyInfo> DeriveKeys(uint32_t account, uint32_t change,
+                                    uint32_t first, uint32_t count);
+    
+    /// Extended key of one chain (m/44'/coin'/account'/change)
+    std::optional<ExtendedKey> GetChainKey(uint32_t account, uint32_t change) const;
+    
+    /// DeriveKeys from a chain key, without touching any manager; lets
+    /// callers derive outside the lock that guards the manager
+    static std::vector<KeyInfo> DeriveChildKeys(const ExtendedKey& chainKey,
+                                                uint32_t account, uint32_t change,
+                                                uint32_t first, uint32_t count);
+    
+    // === Keypool ===
+    //
+    // Keys derived ahead of the next index of a chain. DeriveNextReceiving
+    // and DeriveNextChange hand them out in order instead of deriving, and
+    // they are in the key cache from the start, so payments to them are
+    // recognized before they are handed out.
+    
+    /// Add derived keys to the pool of their chain; keys that do not
+    /// continue the pool are left out
+    void AddPoolKeys(const std::vector<KeyInfo>& keys);
+    
+    /// Keys in the pool of one chain
+    size_t GetPoolSize(uint32_t account, uint32_t change) const;
+    
+    /// Index after the last pooled key of one chain (the next index when empty)
+    uint32_t GetPoolEnd(uint32_t account, uint32_t change) const;
+    
+    /// Pooled keys of every chain, each chain in index order
+    std::vector<KeyInfo> GetPoolKeys() const;
+    
     /// Get key at path
     std::optional<KeyInfo> GetKeyAtPath(const DerivationPath& path);
     
@@ -417,6 +470,9 @@ public:
     /// Get next unused change index
     uint32_t GetNextChangeIndex(uint32_t account = 0) const;
     
+    /// Get next unused index of either chain
+    uint32_t GetNextIndex(uint32_t account, uint32_t change) const;
+    
     /// Get all indices (for persistence)
     const std::map<std::pair<uint32_t, uint32_t>, uint32_t>& GetAllIndices() const {
         return nextIndices_;
@@ -429,6 +485,7 @@ public:
     /// Set a specific index
     void SetNextIndex(uint32_t account, uint32_t change, uint32_t index) {
         nextIndices_[{account, change}] = index;
+        TrimPool(account, change);
     }
 
 private:
@@ -441,8 +498,14 @@ private:
     /// Next indices per account/change
     std::map<std::pair<uint32_t, uint32_t>, uint32_t> nextIndices_;
     
-    /// Derive and cache a key
+    /// Keypool per account/change; the front key is at the next index
+    std::map<std::pair<uint32_t, uint32_t>, std::deque<KeyInfo>> pool_;
+    
+    /// Derive and cache a key, or take it from the pool
     KeyInfo DeriveAndCache(uint32_t account, uint32_t change, uint32_t index);
+    
+    /// Drop pooled keys the next index has passed
+    void TrimPool(uint32_t account, uint32_t change);
 };
 
 // ============================================================================
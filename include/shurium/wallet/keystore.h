@@ -14,21 +14,29 @@
 
 #include <shurium/core/types.h>
 #include <shurium/crypto/keys.h>
+#include <shurium/crypto/secure.h>
 #include <shurium/wallet/hdkey.h>
 #include <shurium/identity/identity.h>
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <set>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace shurium {
+namespace util { class ThreadPool; }
+
 namespace wallet {
 
 // ============================================================================
@@ -52,6 +60,15 @@ constexpr uint32_t ARGON2_TIME_COST = 3;
 constexpr uint32_t ARGON2_MEMORY_COST = 65536;  // 64 MB
 constexpr uint32_t ARGON2_PARALLELISM = 4;
 
+/// Keys kept derived ahead on each chain by default, where a keypool is used
+constexpr uint32_t DEFAULT_KEYPOOL_SIZE = 1000;
+
+/// Keys derived per keypool refill step
+constexpr uint32_t KEYPOOL_BATCH_SIZE = 256;
+
+/// Decrypted keys kept by a store unlocked with KeyUnlockMode::Lazy
+constexpr size_t DEFAULT_UNLOCKED_KEY_CACHE = 4096;
+
 // ============================================================================
 // Encrypted Data Structures
 // ============================================================================
@@ -195,54 +212,52 @@ public:
 
 /**
  * RAII container for sensitive data that:
- * - Locks memory to prevent swapping
- * - Securely zeros memory on destruction
+ * - Lives in a locked SecurePool slot, so it is never swapped out
+ * - Is securely zeroed when destroyed
  */
 template<typename T, size_t N>
 class SecureArray {
+    static_assert(sizeof(T) * N <= SecurePool::SLOT_SIZE, "SecureArray larger than a pool slot");
+    static_assert(std::is_trivially_copyable_v<T>, "SecureArray holds raw bytes");
+
 public:
-    SecureArray() {
-        CryptoEngine::LockMemory(data_.data(), sizeof(data_));
-        data_.fill(0);
-    }
+    SecureArray() : data_(static_cast<T*>(SecurePool::Get().Allocate())) {}
     
     ~SecureArray() {
-        CryptoEngine::SecureZero(data_.data(), sizeof(data_));
-        CryptoEngine::UnlockMemory(data_.data(), sizeof(data_));
+        SecurePool::Get().Free(data_);
     }
     
     // Non-copyable
     SecureArray(const SecureArray&) = delete;
     SecureArray& operator=(const SecureArray&) = delete;
     
-    // Move only
-    SecureArray(SecureArray&& other) noexcept : data_(std::move(other.data_)) {
-        other.data_.fill(0);
+    // Move only; the source is left zeroed
+    SecureArray(SecureArray&& other) : SecureArray() {
+        std::swap(data_, other.data_);
     }
     
     SecureArray& operator=(SecureArray&& other) noexcept {
         if (this != &other) {
-            CryptoEngine::SecureZero(data_.data(), sizeof(data_));
-            data_ = std::move(other.data_);
-            other.data_.fill(0);
+            std::swap(data_, other.data_);
+            CryptoEngine::SecureZero(other.data_, sizeof(T) * N);
         }
         return *this;
     }
     
-    T* data() { return data_.data(); }
-    const T* data() const { return data_.data(); }
+    T* data() { return data_; }
+    const T* data() const { return data_; }
     constexpr size_t size() const { return N; }
     
     T& operator[](size_t i) { return data_[i]; }
     const T& operator[](size_t i) const { return data_[i]; }
     
-    auto begin() { return data_.begin(); }
-    auto end() { return data_.end(); }
-    auto begin() const { return data_.begin(); }
-    auto end() const { return data_.end(); }
+    T* begin() { return data_; }
+    T* end() { return data_ + N; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + N; }
 
 private:
-    std::array<T, N> data_;
+    T* data_;
 };
 
 // ============================================================================
@@ -320,6 +335,16 @@ public:
 // In-Memory Key Store
 // ============================================================================
 
+/// How Unlock() makes the individual encrypted keys available
+enum class KeyUnlockMode {
+    /// Decrypt every key in Unlock(), on the calling thread
+    Eager,
+    /// Decrypt each key on first use, keeping the most recently used ones
+    Lazy,
+    /// Decrypt every key in Unlock(), across thread pool workers
+    EagerParallel
+};
+
 /**
  * In-memory key storage with optional encryption.
  * 
@@ -334,6 +359,9 @@ public:
     /// Create with password (encrypted from start)
     explicit MemoryKeyStore(const std::string& password);
     
+    /// Stops the keypool refill thread
+    ~MemoryKeyStore() override;
+    
     /// Setup encryption for unencrypted store
     bool SetupEncryption(const std::string& password);
     
@@ -356,6 +384,20 @@ public:
     std::optional<std::vector<Byte>> Sign(const Hash160& keyHash,
                                            const Hash256& hash) const override;
     
+    /**
+     * Choose how the next Unlock() decrypts the individual keys. Lazy
+     * keeps at most cacheSize keys decrypted; EagerParallel runs on pool
+     * (nullptr = the global pool). Every mode decrypts with the key
+     * derived in Unlock(), and the HD seed is always decrypted there.
+     */
+    void SetUnlockMode(KeyUnlockMode mode,
+                       size_t cacheSize = DEFAULT_UNLOCKED_KEY_CACHE,
+                       util::ThreadPool* pool = nullptr);
+    KeyUnlockMode GetUnlockMode() const;
+    
+    /// Individual keys currently held decrypted in memory
+    size_t DecryptedKeyCount() const;
+    
     // HD wallet support
     
     /// Set master seed (will encrypt)
@@ -368,16 +410,59 @@ public:
     /// Check if HD wallet is initialized
     bool HasMasterSeed() const { return encryptedSeed_.IsValid(); }
     
-    /// Get HD key manager (unlocked only)
+    /// Get HD key manager (unlocked only). The keypool refill thread
+    /// updates it under the store's lock; use FindHDKey() for lookups
+    /// while a refill may be running.
     HDKeyManager* GetHDKeyManager();
     const HDKeyManager* GetHDKeyManager() const;
     
+    /// Derivation info of an HD key, pooled keys included
+    std::optional<HDKeyManager::KeyInfo> FindHDKey(const Hash160& keyHash) const;
+    
     /// Derive next receiving key
     std::optional<PublicKey> DeriveNextReceiving(uint32_t account = 0);
     
     /// Derive next change key
     std::optional<PublicKey> DeriveNextChange(uint32_t account = 0);
     
+    /// Next HD key index per (account, change); known while locked too
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> GetHDKeyIndices() const;
+    
+    /**
+     * Raise next HD key indices to at least the given ones, deriving the
+     * keys in between when unlocked. For indices persisted outside the
+     * store file, such as the wallet log.
+     */
+    void AdvanceHDKeyIndices(const std::map<std::pair<uint32_t, uint32_t>, uint32_t>& indices);
+    
+    // Keypool
+    //
+    // Receive and change keys of the default account derived ahead of use,
+    // so DeriveNextReceiving and DeriveNextChange hand out a ready key. The
+    // pooled keys count as ours (HaveKey, GetKeyHashes) from the moment they
+    // are derived, which also gives the wallet its gap-limit lookahead. A
+    // refill thread derives in batches, outside the store lock and from the
+    // public chain keys only, whenever a pool falls to half its size. The
+    // pooled public keys are saved with the store, encrypted like the seed,
+    // so a reload or unlock does not derive them again.
+    
+    /// Keys to keep in each pool (0 = derive on demand)
+    void SetKeyPoolSize(uint32_t size);
+    uint32_t GetKeyPoolSize() const;
+    
+    /// Keys ready in the receive (change = 0) or change (change = 1) pool
+    size_t GetKeyPoolAvailable(uint32_t change) const;
+    
+    /// Fill both pools on the calling thread
+    /// @return Number of keys added
+    size_t TopUpKeyPool();
+    
+    /// Start the refill thread, which fills both pools right away
+    void StartKeyPoolRefill();
+    
+    /// Stop the refill thread
+    void StopKeyPoolRefill();
+    
     // Identity support
     
     /// Store identity secrets
@@ -400,6 +485,15 @@ public:
     /// Get watch-only count
     size_t WatchOnlyCount() const;
     
+    /**
+     * Counter bumped, after the change, whenever the set of keys HaveKey()
+     * answers for may have changed: keys added or derived, the store
+     * loaded, locked or unlocked. Lets callers cache the key set and
+     * revalidate with one atomic load. Keys derived straight through
+     * GetHDKeyManager() are not counted.
+     */
+    uint64_t GetKeyGeneration() const { return keyGeneration_.load(std::memory_order_acquire); }
+    
     /// Set testnet mode (must be called before SetMasterSeed)
     void SetTestnet(bool testnet);
     
@@ -437,6 +531,21 @@ protected:
     bool unlocked_{false};
     std::unique_ptr<SecureArray<Byte, AES_KEY_SIZE>> masterKey_;
     std::map<Hash160, PrivateKey> unlockedKeys_;
+    
+    /// Unlock strategy, see SetUnlockMode()
+    KeyUnlockMode unlockMode_{KeyUnlockMode::Eager};
+    size_t keyCacheSize_{DEFAULT_UNLOCKED_KEY_CACHE};
+    util::ThreadPool* unlockPool_{nullptr};
+    
+    /// EagerParallel: keys decrypted by Unlock(); slot i holds the key of
+    /// arenaHashes_[i], which is sorted
+    std::vector<PrivateKey> keyArena_;
+    std::vector<Hash160> arenaHashes_;
+    
+    /// Lazy: keys decrypted on use, most recently used first
+    using KeyCacheList = std::list<std::pair<Hash160, PrivateKey>>;
+    mutable KeyCacheList keyCache_;
+    mutable std::map<Hash160, KeyCacheList::iterator> keyCacheIndex_;
     std::unique_ptr<HDKeyManager> hdKeyManager_;
     std::optional<identity::IdentitySecrets> unlockedIdentity_;
     
@@ -445,6 +554,55 @@ protected:
     
     /// Flag indicating deferred HD init is needed (after SetTestnet call)
     bool needsDeferredHDInit_{false};
+    
+    /// See GetKeyGeneration()
+    std::atomic<uint64_t> keyGeneration_{0};
+    
+    /// Bump keyGeneration_; call once the key set has changed
+    void KeysChanged() { keyGeneration_.fetch_add(1, std::memory_order_release); }
+    
+    /// Keypool target per chain (0 = none)
+    uint32_t keypoolSize_{0};
+    
+    /// Pooled public keys as last sealed or loaded; the nonce is all zero
+    /// when the store is not encrypted and the keys are in the clear
+    std::array<Byte, AES_NONCE_SIZE> keypoolNonce_{};
+    std::vector<Byte> keypoolCiphertext_;
+    
+    /// Bumped whenever hdKeyManager_ is replaced or dropped, so a refill
+    /// derived from an older manager is thrown away
+    uint64_t hdEpoch_{0};
+    
+    /// Refill thread state; guarded by mutex_
+    std::thread refillThread_;
+    std::condition_variable refillCv_;
+    bool refillStop_{false};
+    bool refillWanted_{false};
+    
+    /// Wake the refill thread (mutex_ held)
+    void WakeKeyPoolRefill();
+    
+    /// Wake the refill thread if a pool is at or below half (mutex_ held)
+    void CheckKeyPool();
+    
+    /// Replace keypoolCiphertext_ with the current pools (mutex_ held)
+    void SealKeyPool();
+    
+    /// Load the sealed pools into hdKeyManager_ (mutex_ held)
+    void RestoreKeyPool();
+    
+    /// Refill thread body
+    void KeyPoolRefillThread();
+    
+    /// Drop every decrypted individual key (mutex_ held)
+    void ClearDecryptedKeys();
+    
+    /// Key of an unlocked encrypted store from the arena or the cache,
+    /// else decrypted now (mutex_ held)
+    std::optional<PrivateKey> FindEncryptedKeyLocked(const Hash160& keyHash) const;
+    
+    /// Put a decrypted key at the front of the Lazy cache (mutex_ held)
+    void CacheKeyLocked(const Hash160& keyHash, const PrivateKey& key) const;
 
 private:
     /// Encrypt a private key
@@ -482,7 +640,7 @@ public:
     static constexpr uint32_t FILE_MAGIC = 0x4E584B53;  // "NXKS"
     
     /// Current file version
-    static constexpr uint32_t FILE_VERSION = 3;
+    static constexpr uint32_t FILE_VERSION = 4;
     
     /// Create new file keystore
     FileKeyStore();
@@ -15,10 +15,12 @@
 #include <shurium/core/types.h>
 #include <shurium/core/transaction.h>
 #include <shurium/core/block.h>
+#include <shurium/core/blockfilter.h>
 #include <shurium/chain/coins.h>
 #include <shurium/wallet/keystore.h>
 #include <shurium/wallet/coinselection.h>
 #include <shurium/wallet/hdkey.h>
+#include <shurium/wallet/walletlog.h>
 #include <shurium/identity/identity.h>
 
 #include <atomic>
@@ -28,13 +30,16 @@
 #include <mutex>
 #include <optional>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace shurium {
 
 // Forward declaration for UBIClaim
 namespace economics { struct UBIClaim; }
+namespace util { class ThreadPool; }
 
 namespace wallet {
 
@@ -50,6 +55,9 @@ class WalletOutput;
 // Wallet Output (UTXO)
 // ============================================================================
 
+/// Confirmations before a coinbase output counts towards the balance
+static constexpr int32_t WALLET_COINBASE_MATURITY = 100;
+
 /// Status of a wallet output
 enum class OutputStatus {
     Available,      // Unspent and confirmed
@@ -92,6 +100,9 @@ public:
     /// Label/memo
     std::string label;
     
+    /// Owned by a watch-only key; set by the wallet when it tallies the output
+    bool watchOnly{false};
+    
     /// Constructor
     WalletOutput() = default;
     WalletOutput(const OutPoint& op, const TxOut& out, int32_t h = -1)
@@ -101,13 +112,13 @@ public:
     Amount GetValue() const { return txout.nValue; }
     
     /// Check if spendable (available and mature)
-    bool IsSpendable(int32_t currentHeight, int32_t maturity = 100) const;
+    bool IsSpendable(int32_t currentHeight, int32_t maturity = WALLET_COINBASE_MATURITY) const;
     
     /// Get depth (confirmations)
     int32_t GetDepth(int32_t currentHeight) const;
     
     /// Check if mature (for coinbase outputs)
-    bool IsMature(int32_t currentHeight, int32_t maturity = 100) const;
+    bool IsMature(int32_t currentHeight, int32_t maturity = WALLET_COINBASE_MATURITY) const;
     
     /// Convert to OutputGroup for coin selection
     OutputGroup ToOutputGroup(FeeRate feeRate, int32_t currentHeight) const;
@@ -301,6 +312,24 @@ public:
     /// Build and sign
     BuildTxResult BuildAndSign();
     
+    /**
+     * Build and sign one transaction per payout, for payout runs of many
+     * transactions. Every payout uses this builder's settings; the
+     * builder's own recipients are ignored.
+     * 
+     * Coins come from one snapshot of the wallet, and each transaction
+     * selects from what the ones before it left, so no coin is spent twice
+     * within the batch; change of earlier transactions is not spent.
+     * Selection runs in payout order on the caller's thread. Signing runs
+     * on pool (inline without one), with the signature hash data of each
+     * transaction computed once for all its inputs. A payout that cannot be
+     * funded fails on its own and leaves its coins to the ones after it.
+     * 
+     * @return One result per payout, in order
+     */
+    std::vector<BuildTxResult> BuildBatch(const std::vector<std::vector<Recipient>>& payouts,
+                                          util::ThreadPool* pool = nullptr);
+    
     /// Get estimated fee for current recipients
     Amount EstimateFee() const;
     
@@ -324,6 +353,10 @@ private:
     /// Get available outputs
     std::vector<OutputGroup> GetAvailableOutputs() const;
     
+    /// Build an unsigned transaction paying recipients from available
+    BuildTxResult BuildFor(const std::vector<Recipient>& recipients,
+                           const std::vector<OutputGroup>& available);
+    
     /// Create change output
     TxOut CreateChangeOutput(Amount amount);
 };
@@ -389,6 +422,134 @@ struct WalletBalance {
     Amount GetSpendable() const { return confirmed + unconfirmed - locked; }
 };
 
+/**
+ * Read-only copy of the wallet's transactions and outputs for listing RPCs.
+ * Built on first read after a change and shared by every reader until the
+ * next one; while a block is being applied, readers get the last one built
+ * instead of waiting for it.
+ */
+struct WalletSnapshot {
+    /// Change count of the wallet state it was built from
+    uint64_t version{0};
+
+    int32_t chainHeight{0};
+    WalletBalance balance;
+
+    /// Newest first
+    std::vector<WalletTransaction> transactions;
+
+    /// By outpoint
+    std::vector<WalletOutput> outputs;
+};
+
+// ============================================================================
+// Rescan
+// ============================================================================
+
+/// Blocks read ahead of the one being applied during a rescan
+static constexpr size_t RESCAN_READAHEAD = 64;
+
+/**
+ * Serialized block at a height of the active chain. Returns false past the
+ * tip or when the block cannot be read, which ends the rescan there.
+ */
+using RescanBlockSource = std::function<bool(int32_t height, std::vector<uint8_t>& raw)>;
+
+/**
+ * Compact filter of the block at a height, or nullopt when there is none
+ * (not indexed yet, or past the tip); the block is then read in full.
+ */
+using RescanFilterSource = std::function<std::optional<BlockFilter>(int32_t height)>;
+
+/// Outcome of a rescan
+struct RescanResult {
+    /// First height scanned
+    int32_t startHeight{0};
+    
+    /// Last height scanned (startHeight - 1 if none was)
+    int32_t stopHeight{-1};
+    
+    /// Blocks read and matched
+    size_t blocksScanned{0};
+    
+    /// Blocks whose filter ruled them out, so they were never read
+    size_t blocksSkipped{0};
+    
+    /// Transactions found relevant to the wallet
+    size_t transactionsFound{0};
+    
+    /// Stopped early by AbortRescan()
+    bool aborted{false};
+    
+    /// Why the rescan failed, empty on success
+    std::string error;
+};
+
+/// Progress of the rescan in flight
+struct RescanProgress {
+    bool scanning{false};
+    int32_t startHeight{0};
+    int32_t stopHeight{0};
+    int32_t currentHeight{0};
+    
+    /// Fraction of the range applied, 0 to 1
+    double GetFraction() const;
+};
+
+// ============================================================================
+// Key Hash Index
+// ============================================================================
+
+/// Bloom filter bits per indexed key hash
+static constexpr size_t KEY_INDEX_BLOOM_BITS_PER_KEY = 16;
+
+/// Bloom probes per key hash (about 1 false positive in 400 at full load)
+static constexpr int KEY_INDEX_BLOOM_HASHES = 4;
+
+/**
+ * Hash set of key hashes behind a bloom prefilter, answering "is this one
+ * of ours" for every output of a block.
+ *
+ * Almost every probe is a miss, and the bloom filter (2 bytes per key)
+ * stays in cache where the hash set of a large watch-only wallet does not.
+ * Key hashes are hash output, so probe positions come straight from their
+ * bytes. The filter is resized, and rebuilt from the set, as keys are
+ * added. Not thread-safe.
+ */
+class KeyHashIndex {
+public:
+    struct Hasher {
+        size_t operator()(const Hash160& hash) const noexcept;
+    };
+    using Set = std::unordered_set<Hash160, Hasher>;
+    
+    /// Remove every key and reserve room for expected ones
+    void Reset(size_t expected = 0);
+    
+    /// Add a key hash
+    void Insert(const Hash160& keyHash);
+    
+    /// Whether the key hash was added
+    bool Contains(const Hash160& keyHash) const;
+    
+    size_t Size() const { return keys_.size(); }
+    Set::const_iterator begin() const { return keys_.begin(); }
+    Set::const_iterator end() const { return keys_.end(); }
+    
+private:
+    Set keys_;
+    std::vector<uint64_t> bloom_;
+    uint64_t bloomMask_{0};
+    
+    /// Size the filter for at least capacity keys and refill it from keys_
+    void RebuildBloom(size_t capacity);
+    
+    void AddToBloom(const Hash160& keyHash);
+    
+    /// The two base hashes combined into the probe sequence
+    static void BloomHashes(const Hash160& keyHash, uint64_t& h1, uint64_t& h2);
+};
+
 // ============================================================================
 // Main Wallet Class
 // ============================================================================
@@ -425,9 +586,14 @@ public:
         /// Auto-lock timeout (seconds, 0 = disabled)
         uint32_t autoLockTimeout;
         
+        /// Keys kept pre-derived per chain (0 = derive on demand);
+        /// never fewer than the gap limit when enabled
+        uint32_t keypoolSize;
+        
         /// Default constructor
         Config() : name("default"), gapLimit(20), defaultFeeRate(1), 
-                   minChange(546), testnet(false), autoLockTimeout(300) {}
+                   minChange(546), testnet(false), autoLockTimeout(300),
+                   keypoolSize(0) {}
     };
     
     /// Create empty wallet
@@ -513,7 +679,13 @@ public:
     /// Get HD key manager (requires unlock)
     HDKeyManager* GetHDKeyManager();
     
-    /// Check if we have a key for script
+    /// Derivation info of one of our HD keys
+    std::optional<HDKeyManager::KeyInfo> FindHDKey(const Hash160& keyHash) const;
+    
+    /// Pre-derived keys ready to hand out on the receive or change chain
+    size_t GetKeyPoolAvailable(bool internal) const;
+    
+    /// Check if we have a key for script (probes the key hash index)
     bool IsMine(const Script& script) const;
     
     /// Check if we have a key for output
@@ -549,20 +721,30 @@ public:
     
     // === Balance ===
     
-    /// Get wallet balance
+    /**
+     * Get wallet balance, from running totals rather than a walk of the
+     * outputs. Published after each block, so it does not wait for one
+     * being applied: it then answers as of the block before.
+     */
     WalletBalance GetBalance() const;
     
-    /// Get balance at specific height
+    /// Get balance of outputs confirmed at or below height (plus unconfirmed)
     WalletBalance GetBalanceAtHeight(int32_t height) const;
     
     // === UTXOs ===
     
-    /// Get all wallet outputs
+    /// Get all wallet outputs, from the current snapshot
     std::vector<WalletOutput> GetOutputs() const;
     
-    /// Get spendable outputs
+    /// Get spendable outputs, largest first
     std::vector<WalletOutput> GetSpendableOutputs() const;
     
+    /// Get spendable outputs paying one key hash, largest first
+    std::vector<WalletOutput> GetSpendableOutputs(const Hash160& keyHash) const;
+    
+    /// Spendable outputs as coin selection candidates, largest first
+    std::vector<OutputGroup> GetCoinCandidates(FeeRate feeRate) const;
+    
     /// Get unconfirmed outputs
     std::vector<WalletOutput> GetUnconfirmedOutputs() const;
     
@@ -597,13 +779,25 @@ public:
     /// Sign with specific signing provider
     bool SignTransaction(MutableTransaction& tx, const IKeyStore& keystore);
     
+    /**
+     * Sign many transactions. Keys are looked up once per key hash, then
+     * each transaction is signed on pool (inline without one) with its
+     * signature hash data precomputed.
+     * @return Per transaction, whether it was signed as SignTransaction would
+     */
+    std::vector<bool> SignTransactions(std::vector<MutableTransaction>& txs,
+                                       util::ThreadPool* pool = nullptr);
+    
     /// Broadcast transaction (requires external connection)
     /// Returns txid on success
     std::optional<TxHash> BroadcastTransaction(const Transaction& tx);
     
-    /// Get wallet transactions
+    /// Get wallet transactions, newest first, from the current snapshot
     std::vector<WalletTransaction> GetTransactions() const;
     
+    /// Transactions, outputs and balance as of the last change; see WalletSnapshot
+    std::shared_ptr<const WalletSnapshot> GetSnapshot() const;
+    
     /// Get transaction by hash
     std::optional<WalletTransaction> GetTransaction(const TxHash& hash) const;
     
@@ -627,9 +821,34 @@ public:
     /// Get current chain height
     int32_t GetChainHeight() const;
     
-    /// Rescan from height
+    /// Forget everything the wallet learned from blocks above height
     void RescanFrom(int32_t height);
     
+    /**
+     * Rebuild the wallet's view of blocks startHeight..stopHeight from the
+     * chain. Blocks are read ahead of the one being applied, and decoded and
+     * matched against the wallet's key hashes on pool (inline without one);
+     * only blocks paying the wallet, or spending from it, touch its state,
+     * and they are applied in height order. stopHeight < 0 scans to the end
+     * of the source. One rescan runs at a time.
+     * 
+     * With filters, a block is read only if its filter matches one of the
+     * wallet's scripts. Filters hold the scripts a block spends as well as
+     * those it pays, so spends from the wallet are not missed.
+     */
+    RescanResult Rescan(const RescanBlockSource& source, int32_t startHeight,
+                        int32_t stopHeight = -1, util::ThreadPool* pool = nullptr,
+                        const RescanFilterSource& filters = nullptr);
+    
+    /// Ask the rescan in flight to stop; false when none is running
+    bool AbortRescan();
+    
+    /// Check if a rescan is running
+    bool IsScanning() const { return scanning_.load(); }
+    
+    /// Progress of the rescan in flight
+    RescanProgress GetRescanProgress() const;
+    
     // === UBI Claims ===
     
     /// Check if identity is registered
@@ -689,27 +908,88 @@ private:
     /// File path
     std::string path_;
     
+    // Locking: mutex_ guards outputs and transactions, which a block
+    // updates together, and everything else not listed here. The address
+    // book, the log and the published views have their own locks, taken
+    // after mutex_ when both are held. The keystore locks itself and is
+    // only replaced by Initialize().
+    
     /// Thread safety
     mutable std::recursive_mutex mutex_;
     
     /// Key storage
     std::unique_ptr<FileKeyStore> keystore_;
     
-    /// Wallet outputs (UTXOs)
+    /// Record log of the wallet data, open while path_ is set; appended to
+    /// under logMutex_, replaced under both locks
+    std::unique_ptr<WalletLog> log_;
+    mutable std::mutex logMutex_;
+    
+    /// Own and watch-only key hashes, and the keystore generation they
+    /// reflect; refreshed on use by RefreshKeyIndex()
+    mutable KeyHashIndex keyIndex_;
+    mutable std::optional<uint64_t> keyIndexGeneration_;
+    
+    /// Wallet outputs (UTXOs); every change goes through TallyOutput()
     std::map<OutPoint, WalletOutput> outputs_;
     
+    /// Unspent coinbase value, split by key kind
+    struct CoinbaseTally {
+        Amount own{0};
+        Amount watchOnly{0};
+    };
+    
+    /// Running balance of unspent outputs other than unlocked coinbase ones
+    WalletBalance balance_;
+    
+    /// Unspent, unlocked coinbase value in total and by height (-1 if
+    /// unconfirmed); which of it is immature depends on the chain height
+    CoinbaseTally coinbaseTotal_;
+    std::map<int32_t, CoinbaseTally> coinbaseByHeight_;
+    
+    /// Unspent value by height (-1 if unconfirmed), for GetBalanceAtHeight()
+    std::map<int32_t, Amount> unspentByHeight_;
+    
+    /// Outputs neither spent, Locked nor Frozen, largest first, pointing into
+    /// outputs_; maturity and LockOutput() are checked when they are read
+    using SpendableIndex = std::map<std::pair<Amount, OutPoint>, const WalletOutput*,
+                                    std::greater<std::pair<Amount, OutPoint>>>;
+    SpendableIndex spendable_;
+    
+    /// The same per owning key hash
+    std::map<Hash160, SpendableIndex> spendableByKey_;
+    
     /// Wallet transactions
     std::map<TxHash, WalletTransaction> transactions_;
     
     /// Locked outputs
     std::set<OutPoint> lockedOutputs_;
     
-    /// Address book
+    /// Address book, under its own reader/writer lock
     std::map<std::string, AddressBookEntry> addressBook_;
+    mutable std::shared_mutex addressBookMutex_;
     
     /// Current chain height
     std::atomic<int32_t> chainHeight_{0};
     
+    /// Count of changes to outputs, transactions and the chain height;
+    /// a published view of an older count is stale
+    std::atomic<uint64_t> version_{0};
+    
+    /// Views published for readers that must not wait on mutex_, under
+    /// viewMutex_: the balance at balanceVersion_ and the last snapshot
+    mutable std::mutex viewMutex_;
+    mutable std::optional<WalletBalance> balanceView_;
+    mutable uint64_t balanceVersion_{0};
+    mutable std::shared_ptr<const WalletSnapshot> snapshot_;
+    
+    /// Rescan state, read by GetRescanProgress() while one runs
+    std::atomic<bool> scanning_{false};
+    std::atomic<bool> abortRescan_{false};
+    std::atomic<int32_t> rescanStart_{0};
+    std::atomic<int32_t> rescanStop_{0};
+    std::atomic<int32_t> rescanHeight_{0};
+    
     /// Event callbacks
     std::vector<WalletCallback> callbacks_;
     
@@ -719,18 +999,43 @@ private:
     /// Emit event
     void EmitEvent(WalletEvent event, const std::string& data = "");
     
+    /// Rebuild keyIndex_ if the keystore's keys changed since it was built
+    void RefreshKeyIndex() const;
+    
+    /// Start the keystore's keypool refill if the config asks for one
+    void StartKeyPool();
+    
+    /// Add a key the wallet just derived without rebuilding keyIndex_
+    void NoteDerivedKey(const Hash160& keyHash, uint64_t generationBefore);
+    
     /// Process transaction for wallet relevance
     void ProcessWalletTransaction(const TransactionRef& tx, int32_t height);
     
+    /// Apply one rescanned block; paying lists the transactions paying us.
+    /// Returns how many transactions were relevant.
+    size_t ApplyScannedBlock(const Block& block, int32_t height,
+                             const std::vector<size_t>& paying);
+    
     /// Add output to wallet
     void AddOutput(const OutPoint& outpoint, const TxOut& txout, int32_t height);
     
     /// Mark output as spent
     void SpendOutput(const OutPoint& outpoint, const TxHash& spendingTx);
     
-    /// Update balance cache
+    /// Add an output to the running balance and spendable index, or take it
+    /// back out. Pass the entry in outputs_, and call with add=false before
+    /// changing or erasing it.
+    void TallyOutput(const WalletOutput& output, bool add);
+    
+    /// Rebuild the running balance from outputs_, re-reading watch-only keys
     void UpdateBalance();
     
+    /// Balance from the running totals at the current height
+    WalletBalance ComputeBalance() const;
+    
+    /// Compute the balance and publish it for GetBalance()
+    WalletBalance PublishBalance() const;
+    
     /// Calculate fee for transaction
     Amount CalculateFee(const MutableTransaction& tx) const;
     
@@ -739,6 +1044,41 @@ private:
     
     /// Deserialize wallet data
     bool DeserializeWalletData(const std::vector<Byte>& data);
+    
+    // Wallet log: every change to outputs_, transactions_, lockedOutputs_,
+    // addressBook_, the chain height or an HD index is appended as one
+    // record while a path is set; Save() only syncs it. Logging a
+    // transaction or the height also bumps version_, as TallyOutput() does
+    // for outputs.
+    
+    /// Replay the data file at the keystore path, starting a log from a
+    /// snapshot file if it predates the log
+    bool OpenLog(const std::string& path);
+    
+    /// Write every live record, for a new or compacted log; needs mutex_
+    /// and addressBookMutex_
+    void WriteSnapshot(const WalletLog::RecordSink& sink) const;
+    
+    /// Apply one replayed record
+    void ApplyLogRecord(WalletRecord type, const std::vector<Byte>& payload);
+    
+    void LogRecord(WalletRecord type, const DataStream& payload);
+    void LogOutput(const WalletOutput& output);
+    void LogOutputErased(const OutPoint& outpoint);
+    void LogTransaction(const TxHash& hash, const WalletTransaction& wtx);
+    void LogTransactionErased(const TxHash& hash);
+    void LogLockedOutput(const OutPoint& outpoint, bool locked);
+    void LogAddressEntry(const AddressBookEntry& entry);
+    void LogChainHeight();
+    void LogHDIndex(uint32_t account, uint32_t change);
+    
+    /// Write out logged records, compacting the log if it has outgrown its
+    /// live data; sync forces an fsync. Needs mutex_.
+    bool CommitLog(bool sync = false);
+    
+    /// Write out logged records without compacting, for callers that do not
+    /// hold mutex_
+    bool FlushLog();
 };
 
 // ============================================================================
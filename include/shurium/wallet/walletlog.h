@@ -0,0 +1,153 @@
+// SHURIUM - Wallet Record Log
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Append-only, checksummed record log that holds a wallet's outputs,
+// transactions, address book and chain state. Each change to the wallet is
+// appended as one record instead of rewriting the whole data file; the log
+// is compacted into a fresh snapshot once it has grown past its live data.
+
+#ifndef SHURIUM_WALLET_WALLETLOG_H
+#define SHURIUM_WALLET_WALLETLOG_H
+
+#include <shurium/core/types.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace wallet {
+
+// ============================================================================
+// Constants
+// ============================================================================
+
+/// Log file format version
+static constexpr uint32_t WALLET_LOG_VERSION = 1;
+
+/// Largest record a log may hold; a longer length marks a torn write
+static constexpr uint32_t MAX_WALLET_LOG_RECORD = 64 * 1024 * 1024;
+
+/// Buffered record bytes written out without waiting for Flush()
+static constexpr size_t WALLET_LOG_BUFFER_BYTES = 64 * 1024;
+
+/// Unsynced bytes after which Flush() syncs even when not asked to
+static constexpr size_t WALLET_LOG_SYNC_BYTES = 1024 * 1024;
+
+/// Growth below which a log is never compacted
+static constexpr uint64_t WALLET_LOG_MIN_COMPACT_BYTES = 1024 * 1024;
+
+/// Kinds of record; later records of the same key replace earlier ones
+enum class WalletRecord : uint8_t {
+    META = 1,           ///< Wallet config
+    HEIGHT = 2,         ///< Chain height
+    OUTPUT = 3,         ///< Wallet output, by outpoint
+    OUTPUT_ERASE = 4,   ///< Outpoint no longer held
+    TX = 5,             ///< Wallet transaction, by hash
+    TX_ERASE = 6,       ///< Transaction hash no longer held
+    LOCK = 7,           ///< Outpoint locked against spending
+    UNLOCK = 8,         ///< Outpoint unlocked
+    ADDRESS = 9,        ///< Address book entry, by address
+    HD_INDEX = 10,      ///< Next HD key index of one chain
+};
+
+// ============================================================================
+// WalletLog
+// ============================================================================
+
+/**
+ * A file of records, each a 4-byte payload length, a type byte, the payload
+ * and a 4-byte SipHash checksum of type and payload, after an 8-byte header.
+ *
+ * Appends are buffered and written out by Flush(); fsync is batched, so a
+ * crash loses at most the records since the last sync. A torn or corrupt
+ * tail is dropped when the log is opened: everything before it replays.
+ *
+ * Compaction writes the live records to a temporary file, syncs it and
+ * renames it over the log, so the log is always either the old or the new
+ * file. Not thread-safe; the wallet serializes access.
+ */
+class WalletLog {
+public:
+    /// Called with each record on replay
+    using Replay = std::function<void(WalletRecord type, const std::vector<Byte>& payload)>;
+
+    /// Takes one record of a snapshot
+    using RecordSink = std::function<void(WalletRecord type, const std::vector<Byte>& payload)>;
+
+    /// Writes every live record into the given sink
+    using Snapshot = std::function<void(const RecordSink& sink)>;
+
+    WalletLog() = default;
+    ~WalletLog();
+
+    WalletLog(const WalletLog&) = delete;
+    WalletLog& operator=(const WalletLog&) = delete;
+
+    /// Whether the file starts with a log header
+    static bool IsLogFile(const std::string& path);
+
+    /**
+     * Replay an existing log and open it for appending. A torn tail is
+     * truncated away.
+     * @return false if the file is missing, not a log or cannot be written
+     */
+    bool Open(const std::string& path, const Replay& replay);
+
+    /**
+     * Replace the file at path with a snapshot and open it for appending.
+     * Also how a log is compacted.
+     */
+    bool Rewrite(const std::string& path, const Snapshot& snapshot);
+
+    /// Buffer one record
+    void Append(WalletRecord type, const std::vector<Byte>& payload);
+
+    /**
+     * Write buffered records to the file.
+     * @param sync Also fsync, as it does anyway past WALLET_LOG_SYNC_BYTES
+     */
+    bool Flush(bool sync);
+
+    /// Flush, sync and close
+    void Close();
+
+    /// Whether records written since the last snapshot outweigh it
+    bool NeedsCompaction() const;
+
+    bool IsOpen() const { return file_ != nullptr; }
+    const std::string& GetPath() const { return path_; }
+
+    /// Bytes in the file, buffered records included
+    uint64_t GetSize() const { return fileSize_ + buffer_.size(); }
+
+    /// Records replayed by Open() or written by Rewrite(), plus appends
+    uint64_t GetRecordCount() const { return records_; }
+
+private:
+    std::string path_;
+    std::FILE* file_{nullptr};
+    std::vector<Byte> buffer_;
+    uint64_t fileSize_{0};
+    uint64_t snapshotSize_{0};
+    uint64_t unsynced_{0};
+    uint64_t records_{0};
+
+    /// Encode one record onto out
+    static void EncodeRecord(std::vector<Byte>& out, WalletRecord type,
+                             const std::vector<Byte>& payload);
+
+    /// Open path for appending at the given size
+    bool OpenForAppend(const std::string& path, uint64_t size);
+
+    /// fsync the open file
+    bool Sync();
+};
+
+} // namespace wallet
+} // namespace shurium
+
+#endif // SHURIUM_WALLET_WALLETLOG_H
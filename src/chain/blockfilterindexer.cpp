@@ -0,0 +1,295 @@
+// SHURIUM - Background Block Filter Indexer Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/chain/blockfilterindexer.h"
+#include "shurium/chain/chainstate.h"
+#include "shurium/util/logging.h"
+#include "shurium/util/threadpool.h"
+#include <algorithm>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace shurium {
+
+// ============================================================================
+// BlockFilterIndexer
+// ============================================================================
+
+BlockFilterIndexer::BlockFilterIndexer(ChainStateManager& chainman, db::BlockDB& blockDB,
+                                       db::BlockFilterIndex& filterIndex,
+                                       const BlockFilterIndexerOptions& options)
+    : m_chainman(chainman), m_blockDB(blockDB), m_filterIndex(filterIndex), m_options(options) {
+    m_options.batchBlocks = std::max<size_t>(m_options.batchBlocks, 1);
+}
+
+BlockFilterIndexer::~BlockFilterIndexer() {
+    Stop();
+}
+
+bool BlockFilterIndexer::Start() {
+    if (!m_filterIndex.IsEnabled() || m_thread.joinable()) {
+        return false;
+    }
+
+    // Resume from the newest locator entry whose filter header we still have
+    const BlockIndex* pbest = nullptr;
+    Hash256 bestHeader;
+    if (auto locator = m_filterIndex.GetBestLocator()) {
+        for (const BlockHash& hash : locator->vHave) {
+            auto header = m_filterIndex.GetFilterHeader(hash);
+            if (header && (pbest = m_chainman.LookupBlockIndex(hash))) {
+                bestHeader = *header;
+                break;
+            }
+        }
+        if (!pbest && !locator->IsNull()) {
+            LOG_WARN(util::LogCategory::DEFAULT)
+                << "blockfilterindex: stored best block is unknown, rebuilding from genesis";
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_best = pbest;
+        m_bestHeader = bestHeader;
+        m_synced = false;
+        m_failed = false;
+        m_stop = false;
+    }
+
+    int nThreads = m_options.nThreads;
+    if (nThreads <= 0) {
+        nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    util::ThreadPool::Config config;
+    config.numThreads = static_cast<size_t>(nThreads);
+    config.maxQueueSize = m_options.batchBlocks;
+    config.name = "blockfilter";
+    m_pool = std::make_unique<util::ThreadPool>(config);
+
+    m_callbackId = m_chainman.RegisterBlockConnected(
+        [this](const Block& block, const BlockIndex* pindex) { BlockConnected(block, pindex); });
+
+    LOG_INFO(util::LogCategory::DEFAULT) << "blockfilterindex: syncing "
+                                         << BlockFilterTypeName(m_filterIndex.GetFilterType())
+                                         << " filters from height "
+                                         << (pbest ? pbest->nHeight + 1 : 0) << " with "
+                                         << nThreads << " thread(s)";
+    m_thread = std::thread([this]() { ThreadSync(); });
+    return true;
+}
+
+void BlockFilterIndexer::Stop() {
+    // Unregister first: it waits for a running notification to finish
+    if (m_callbackId >= 0) {
+        m_chainman.UnregisterBlockConnected(m_callbackId);
+        m_callbackId = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_pool.reset();
+}
+
+const BlockIndex* BlockFilterIndexer::GetBestBlock() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_best;
+}
+
+int BlockFilterIndexer::GetBestHeight() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_best ? m_best->nHeight : -1;
+}
+
+bool BlockFilterIndexer::WaitForSync(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait_for(lock, timeout, [this]() { return m_synced || m_stop || m_failed; });
+    return m_synced;
+}
+
+std::optional<BlockFilter> BlockFilterIndexer::GetFilter(const BlockIndex* pindex) const {
+    if (!pindex) {
+        return std::nullopt;
+    }
+    return m_filterIndex.GetFilter(pindex->GetBlockHash());
+}
+
+std::optional<BlockFilter> BlockFilterIndexer::BuildFilter(const db::BlockDB& blockDB,
+                                                           const BlockIndex* pindex,
+                                                           BlockFilterType type) {
+    Block block;
+    if (!pindex->HaveData() ||
+        !blockDB.ReadBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), block).ok() ||
+        block.GetHash() != pindex->GetBlockHash()) {
+        return std::nullopt;
+    }
+
+    // Only a coinbase-only block can do without undo data
+    std::vector<Script> spentScripts;
+    if (block.vtx.size() > 1) {
+        BlockUndo undo;
+        if (!pindex->HaveUndo() ||
+            !blockDB.ReadUndo(db::DiskBlockPos(pindex->nFile, pindex->nUndoPos), undo).ok() ||
+            undo.vtxundo.size() + 1 != block.vtx.size()) {
+            return std::nullopt;
+        }
+        for (const TxUndo& txundo : undo.vtxundo) {
+            for (const Coin& coin : txundo.vprevout) {
+                spentScripts.push_back(coin.out.scriptPubKey);
+            }
+        }
+    }
+    return BlockFilter(type, block, spentScripts);
+}
+
+void BlockFilterIndexer::ThreadSync() {
+    auto lastLog = std::chrono::steady_clock::now();
+    while (!m_stop) {
+        size_t nIndexed = SyncBatch();
+        if (m_failed) {
+            break;
+        }
+        if (nIndexed > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (!m_synced && now - lastLog >= std::chrono::seconds(BLOCKFILTER_PROGRESS_INTERVAL)) {
+                lastLog = now;
+                LOG_INFO(util::LogCategory::DEFAULT) << "blockfilterindex: indexed up to height "
+                                                     << GetBestHeight();
+            }
+            continue;
+        }
+
+        // At the tip: wait for the next block
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_wakeup) {
+            m_wakeup = false;
+            continue;
+        }
+        if (!m_synced) {
+            m_synced = true;
+            LOG_INFO(util::LogCategory::DEFAULT) << "blockfilterindex: synced at height "
+                                                 << (m_best ? m_best->nHeight : -1);
+            m_cv.notify_all();
+        }
+        m_cv.wait(lock, [this]() { return m_stop || m_wakeup; });
+        m_wakeup = false;
+    }
+    m_cv.notify_all();
+}
+
+size_t BlockFilterIndexer::SyncBatch() {
+    const ChainState& chainstate = m_chainman.GetActiveChainState();
+    const BlockIndex* pbest = GetBestBlock();
+
+    BlockIndex* pnext = chainstate.FindNextBlock(pbest);
+    if (!pnext) {
+        return 0;
+    }
+    if (pnext->pprev != pbest) {
+        if (!Rewind(pnext->pprev)) {
+            return 0;
+        }
+    }
+
+    std::vector<const BlockIndex*> batch{pnext};
+    while (batch.size() < m_options.batchBlocks && !m_stop) {
+        BlockIndex* p = chainstate.FindNextBlock(batch.back());
+        if (!p || p->pprev != batch.back()) {
+            break;
+        }
+        batch.push_back(p);
+    }
+
+    // Read the blocks and build their filters in parallel
+    const BlockFilterType type = m_filterIndex.GetFilterType();
+    std::vector<std::future<std::optional<BlockFilter>>> results;
+    results.reserve(batch.size());
+    for (const BlockIndex* pindex : batch) {
+        if (!pindex->HaveData()) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "blockfilterindex: no block data at height "
+                                                  << pindex->nHeight << " (pruned?), stopping";
+            m_failed = true;
+            return 0;
+        }
+        results.push_back(m_pool->Submit([this, pindex, type]() {
+            return BuildFilter(m_blockDB, pindex, type);
+        }));
+    }
+
+    // Headers chain in order
+    Hash256 header;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        header = m_bestHeader;
+    }
+    std::vector<std::pair<BlockHash, db::BlockFilterEntry>> entries;
+    entries.reserve(batch.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::optional<BlockFilter> filter = results[i].get();
+        if (!filter) {
+            LOG_ERROR(util::LogCategory::DEFAULT)
+                << "blockfilterindex: failed to read block or undo data at height "
+                << batch[i]->nHeight << ", stopping";
+            m_failed = true;
+            return 0;
+        }
+        db::BlockFilterEntry entry(*filter, header);
+        header = entry.header;
+        entries.emplace_back(batch[i]->GetBlockHash(), std::move(entry));
+    }
+
+    db::Status status = m_filterIndex.WriteEntries(entries, GetLocator(batch.back()));
+    if (!status.ok()) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "blockfilterindex: write failed: "
+                                              << status.ToString();
+        m_failed = true;
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_best = batch.back();
+    m_bestHeader = header;
+    return batch.size();
+}
+
+bool BlockFilterIndexer::Rewind(const BlockIndex* pfork) {
+    Hash256 header;
+    if (pfork) {
+        auto stored = m_filterIndex.GetFilterHeader(pfork->GetBlockHash());
+        if (!stored) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "blockfilterindex: no filter header at fork "
+                                                  << "height " << pfork->nHeight << ", stopping";
+            m_failed = true;
+            return false;
+        }
+        header = *stored;
+    }
+
+    db::Status status = m_filterIndex.WriteEntries({}, GetLocator(pfork));
+    if (!status.ok()) {
+        m_failed = true;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_best = pfork;
+    m_bestHeader = header;
+    return true;
+}
+
+void BlockFilterIndexer::BlockConnected(const Block& /*block*/, const BlockIndex* /*pindex*/) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop || m_failed) {
+        return;
+    }
+    m_wakeup = true;
+    m_cv.notify_all();
+}
+
+} // namespace shurium
@@ -3,8 +3,10 @@
 // MIT License
 
 #include "shurium/chain/blockindex.h"
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <utility>
 
 namespace shurium {
 
@@ -12,32 +14,85 @@ namespace shurium {
 // BlockIndex Implementation
 // ============================================================================
 
-void BlockIndex::BuildSkip() {
-    if (!pprev) {
-        pskip = nullptr;
-        return;
+BlockIndex::BlockIndex(BlockIndex&& other) noexcept
+    : pprev(other.pprev), pskip(other.pskip), phashBlock(other.phashBlock),
+      nChainWork(other.nChainWork), nHeight(other.nHeight), nStatus(other.nStatus),
+      nTime(other.nTime), nBits(other.nBits), nTimeMax(other.nTimeMax),
+      nFile(other.nFile), nDataPos(other.nDataPos), nUndoPos(other.nUndoPos),
+      nTx(other.nTx), nSequenceId(other.nSequenceId), nChainTx(other.nChainTx),
+      m_header(other.m_header), m_ownsHeader(other.m_ownsHeader) {
+    other.m_header = nullptr;
+    other.m_ownsHeader = false;
+}
+
+BlockIndex& BlockIndex::operator=(BlockIndex&& other) noexcept {
+    if (this != &other) {
+        if (m_ownsHeader) delete m_header;
+        pprev = other.pprev;
+        pskip = other.pskip;
+        phashBlock = other.phashBlock;
+        nChainWork = other.nChainWork;
+        nHeight = other.nHeight;
+        nStatus = other.nStatus;
+        nTime = other.nTime;
+        nBits = other.nBits;
+        nTimeMax = other.nTimeMax;
+        nFile = other.nFile;
+        nDataPos = other.nDataPos;
+        nUndoPos = other.nUndoPos;
+        nTx = other.nTx;
+        nSequenceId = other.nSequenceId;
+        nChainTx = other.nChainTx;
+        m_header = std::exchange(other.m_header, nullptr);
+        m_ownsHeader = std::exchange(other.m_ownsHeader, false);
     }
-    
-    // Skip pointer optimization for ancestor lookup
-    // pskip points to an ancestor that is a power of 2 blocks back
-    // This allows O(log n) ancestor lookups
-    
-    // Calculate the skip height
-    // Using the same algorithm as Bitcoin: skip to the highest
-    // ancestor whose height has more trailing zeros than this height
-    int skipHeight = nHeight & (nHeight - 1);  // Turn off lowest set bit
-    
-    if (skipHeight == 0) {
-        // Power of 2 height - skip to genesis or halfway point
-        pskip = pprev->GetAncestor(nHeight / 2);
-    } else {
-        // Non-power of 2 - find appropriate skip target
-        pskip = pprev->GetAncestor(skipHeight);
+    return *this;
+}
+
+BlockIndexHeader& BlockIndex::MutableHeader() {
+    if (!m_header) {
+        m_header = new BlockIndexHeader();
+        m_ownsHeader = true;
     }
-    
-    if (!pskip) {
-        pskip = pprev;  // Fallback to previous
+    return *m_header;
+}
+
+void BlockIndex::SetHeader(const BlockHeader& header) {
+    BlockIndexHeader& cold = MutableHeader();
+    cold.nVersion = header.nVersion;
+    cold.nNonce = header.nNonce;
+    cold.hashMerkleRoot = header.hashMerkleRoot;
+    nTime = header.nTime;
+    nBits = header.nBits;
+}
+
+// ============================================================================
+// Skip List
+// ============================================================================
+
+namespace {
+
+/// Clear the lowest set bit
+int InvertLowestOne(int n) {
+    return n & (n - 1);
+}
+
+} // namespace
+
+int GetSkipHeight(int height) {
+    if (height < 2) {
+        return 0;
     }
+    
+    // Odd heights clear one extra bit so consecutive entries do not share a
+    // target; any skip height below the block's own gives a correct index,
+    // this choice keeps the walk from any height to any lower one O(log n)
+    return (height & 1) ? InvertLowestOne(InvertLowestOne(height - 1)) + 1
+                        : InvertLowestOne(height);
+}
+
+void BlockIndex::BuildSkip() {
+    pskip = pprev ? pprev->GetAncestor(GetSkipHeight(nHeight)) : nullptr;
 }
 
 BlockIndex* BlockIndex::GetAncestor(int height) {
@@ -46,22 +101,26 @@ BlockIndex* BlockIndex::GetAncestor(int height) {
     }
     
     BlockIndex* pindex = this;
-    
-    // Use skip pointers for efficient traversal
-    while (pindex && pindex->nHeight != height) {
-        if (pindex->pskip && pindex->pskip->nHeight >= height) {
-            // Can use skip pointer
+    int heightWalk = nHeight;
+    while (heightWalk > height) {
+        int heightSkip = GetSkipHeight(heightWalk);
+        int heightSkipPrev = GetSkipHeight(heightWalk - 1);
+        if (pindex->pskip &&
+            (heightSkip == height ||
+             (heightSkip > height && !(heightSkipPrev < heightSkip - 2 &&
+                                       heightSkipPrev >= height)))) {
+            // Take the skip unless the previous block's skip gets closer
             pindex = pindex->pskip;
+            heightWalk = heightSkip;
         } else if (pindex->pprev) {
-            // Walk back one step
             pindex = pindex->pprev;
+            heightWalk--;
         } else {
-            // No more ancestors
-            break;
+            return nullptr;
         }
     }
     
-    return (pindex && pindex->nHeight == height) ? pindex : nullptr;
+    return pindex;
 }
 
 const BlockIndex* BlockIndex::GetAncestor(int height) const {
@@ -77,7 +136,7 @@ std::string BlockIndex::ToString() const {
         ss << "null";
     }
     ss << ", height=" << nHeight
-       << ", version=" << nVersion
+       << ", version=" << GetVersion()
        << ", time=" << nTime
        << ", bits=" << std::hex << nBits << std::dec
        << ", nTx=" << nTx
@@ -90,17 +149,34 @@ std::string BlockIndex::ToString() const {
 // Chain Implementation
 // ============================================================================
 
+void Chain::Resize(int size) {
+    size_t chunks = (static_cast<size_t>(size) + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+    if (chunks < m_chunks.size()) {
+        m_chunks.resize(chunks);
+    }
+    while (m_chunks.size() < chunks) {
+        m_chunks.push_back(std::make_unique<BlockIndex*[]>(CHUNK_SIZE));
+    }
+    
+    // Entries past the old tip may hold stale pointers from an earlier,
+    // longer chain in a kept chunk
+    for (int height = m_size; height < size; ++height) {
+        At(height) = nullptr;
+    }
+    m_size = size;
+}
+
 void Chain::SetTip(BlockIndex* pindex) {
     if (!pindex) {
-        vChain.clear();
+        Clear();
         return;
     }
     
-    // Build the chain from genesis to pindex
-    vChain.resize(pindex->nHeight + 1);
+    // Rewrite entries back to the fork with the old chain, not to genesis
+    Resize(pindex->nHeight + 1);
     
-    while (pindex) {
-        vChain[pindex->nHeight] = pindex;
+    while (pindex && At(pindex->nHeight) != pindex) {
+        At(pindex->nHeight) = pindex;
         pindex = pindex->pprev;
     }
 }
@@ -108,12 +184,48 @@ void Chain::SetTip(BlockIndex* pindex) {
 const BlockIndex* Chain::FindFork(const BlockIndex* pindex) const {
     if (!pindex) return nullptr;
     
-    // Walk back until we find a block in our chain
-    while (pindex && !Contains(pindex)) {
+    // Skip straight to our height, then walk back to the fork point
+    if (pindex->nHeight > Height()) {
+        pindex = pindex->GetAncestor(Height());
+    }
+    
+    // Most forks are a few blocks deep; without skip pointers, walk all
+    // the way
+    for (int steps = 0; pindex && !Contains(pindex); ++steps) {
+        if (steps >= FIND_FORK_WALK && pindex->pskip) {
+            break;
+        }
         pindex = pindex->pprev;
     }
+    if (!pindex || Contains(pindex)) {
+        return pindex;
+    }
     
-    return pindex;
+    // pindex's ancestors are in the chain up to the fork and not above it.
+    // Gallop down in doubling steps to a block in the chain, then binary
+    // search between it and the lowest block known to be off the chain,
+    // each lookup a skip-list walk down from the latter.
+    int lo = 0;  // In the chain
+    for (int step = FIND_FORK_WALK; ; step *= 2) {
+        const BlockIndex* probe = pindex->GetAncestor(std::max(pindex->nHeight - step, 0));
+        if (Contains(probe)) {
+            lo = probe->nHeight;
+            break;
+        }
+        if (probe->nHeight == 0) {
+            return nullptr;
+        }
+        pindex = probe;
+    }
+    while (pindex->nHeight - lo > 1) {
+        const BlockIndex* mid = pindex->GetAncestor(lo + (pindex->nHeight - lo) / 2);
+        if (Contains(mid)) {
+            lo = mid->nHeight;
+        } else {
+            pindex = mid;
+        }
+    }
+    return pindex->pprev;
 }
 
 BlockIndex* Chain::FindEarliestAtLeast(int64_t nTime, int height) const {
@@ -125,7 +237,7 @@ BlockIndex* Chain::FindEarliestAtLeast(int64_t nTime, int height) const {
     
     while (lo < hi) {
         int mid = (lo + hi) / 2;
-        BlockIndex* pindex = vChain[mid];
+        BlockIndex* pindex = At(mid);
         if (pindex->GetBlockTime() < nTime) {
             lo = mid + 1;
         } else {
@@ -134,7 +246,7 @@ BlockIndex* Chain::FindEarliestAtLeast(int64_t nTime, int height) const {
     }
     
     if (lo <= Height()) {
-        BlockIndex* pindex = vChain[lo];
+        BlockIndex* pindex = At(lo);
         if (pindex->GetBlockTime() >= nTime && pindex->nHeight >= height) {
             return pindex;
         }
@@ -143,6 +255,71 @@ BlockIndex* Chain::FindEarliestAtLeast(int64_t nTime, int height) const {
     return nullptr;
 }
 
+// ============================================================================
+// BlockIndexArena Implementation
+// ============================================================================
+
+BlockIndex* BlockIndexArena::Allocate() {
+    size_t slot = m_size % CHUNK_SIZE;
+    if (m_size == m_chunks.size() * CHUNK_SIZE) {
+        Reserve(m_size + 1);
+    }
+    Chunk& chunk = m_chunks[m_size / CHUNK_SIZE];
+    ++m_size;
+    
+    BlockIndex* pindex = &chunk.entries[slot];
+    pindex->AttachHeader(&chunk.headers[slot]);
+    return pindex;
+}
+
+void BlockIndexArena::Reserve(size_t n) {
+    while (m_chunks.size() * CHUNK_SIZE < n) {
+        Chunk chunk;
+        chunk.entries.reset(new BlockIndex[CHUNK_SIZE]);
+        chunk.headers.reset(new BlockIndexHeader[CHUNK_SIZE]);
+        m_chunks.push_back(std::move(chunk));
+    }
+}
+
+void BlockIndexArena::Clear() {
+    m_chunks.clear();
+    m_size = 0;
+}
+
+size_t BlockIndexArena::GetMemoryUsage() const {
+    return m_chunks.size() * CHUNK_SIZE * (sizeof(BlockIndex) + sizeof(BlockIndexHeader));
+}
+
+// ============================================================================
+// BlockMap Implementation
+// ============================================================================
+
+std::pair<BlockIndex*, bool> BlockMap::Insert(const BlockHash& hash) {
+    auto [it, inserted] = m_map.emplace(hash, nullptr);
+    if (inserted) {
+        it->second = m_arena.Allocate();
+        it->second->phashBlock = &it->first;
+    }
+    return {it->second, inserted};
+}
+
+void BlockMap::Reserve(size_t n) {
+    m_map.reserve(n);
+    m_arena.Reserve(n);
+}
+
+void BlockMap::clear() {
+    m_map.clear();
+    m_arena.Clear();
+}
+
+size_t BlockMap::GetMemoryUsage() const {
+    // Node: key, value and next pointer; plus one bucket pointer each
+    size_t nodeBytes = sizeof(BlockHash) + sizeof(BlockIndex*) + sizeof(void*);
+    return m_arena.GetMemoryUsage() + m_map.size() * nodeBytes +
+           m_map.bucket_count() * sizeof(void*);
+}
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
@@ -150,13 +327,13 @@ BlockIndex* Chain::FindEarliestAtLeast(int64_t nTime, int height) const {
 const BlockIndex* LastCommonAncestor(const BlockIndex* pa, const BlockIndex* pb) {
     if (!pa || !pb) return nullptr;
     
-    // Walk back to the same height
-    while (pa->nHeight > pb->nHeight) {
-        pa = pa->pprev;
-    }
-    while (pb->nHeight > pa->nHeight) {
-        pb = pb->pprev;
+    // Jump to the same height
+    if (pa->nHeight > pb->nHeight) {
+        pa = pa->GetAncestor(pb->nHeight);
+    } else if (pb->nHeight > pa->nHeight) {
+        pb = pb->GetAncestor(pa->nHeight);
     }
+    if (!pa || !pb) return nullptr;
     
     // Walk back together until we find common ancestor
     while (pa != pb && pa && pb) {
@@ -214,14 +391,16 @@ BlockLocator GetLocator(const BlockIndex* pindex) {
         return locator;
     }
     
+    locator.vHave.reserve(32);
     int step = 1;
     while (pindex) {
         locator.vHave.push_back(pindex->GetBlockHash());
-        
-        // Exponentially larger steps as we go back
-        for (int i = 0; pindex && i < step; ++i) {
-            pindex = pindex->pprev;
+        if (pindex->nHeight == 0) {
+            break;
         }
+        
+        // Exponentially larger steps as we go back, always ending at genesis
+        pindex = pindex->GetAncestor(std::max(pindex->nHeight - step, 0));
         if (locator.vHave.size() > 10) {
             step *= 2;
         }
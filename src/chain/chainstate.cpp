@@ -5,62 +5,44 @@
 #include "shurium/chain/chainstate.h"
 #include "shurium/consensus/validation.h"
 #include "shurium/script/interpreter.h"
+#include "shurium/script/scriptcache.h"
+#include "shurium/script/sigcache.h"
 #include "shurium/db/blockdb.h"
 #include "shurium/util/logging.h"
+#include "shurium/util/metrics.h"
+#include "shurium/util/trace.h"
+#include "shurium/util/threadpool.h"
 #include <cassert>
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <unordered_set>
 
 namespace shurium {
 
 // ============================================================================
-// Script Verification Helper
+// Script Verification Flags
 // ============================================================================
 
-/**
- * Verify all input scripts for a transaction.
- * 
- * @param tx The transaction to verify
- * @param coinsView The UTXO set to look up previous outputs
- * @param flags Script verification flags
- * @return true if all scripts verify successfully
- */
-static bool VerifyTransactionScripts(const Transaction& tx,
-                                      const CoinsViewCache& coinsView,
-                                      ScriptFlags flags) {
-    // Coinbase transactions have no inputs to verify
-    if (tx.IsCoinBase()) {
-        return true;
-    }
-    
-    // Verify each input
-    for (size_t i = 0; i < tx.vin.size(); ++i) {
-        const TxIn& txin = tx.vin[i];
-        
-        // Get the previous output being spent
-        const Coin& coin = coinsView.AccessCoin(txin.prevout);
-        if (coin.IsSpent()) {
-            return false;  // Should have been caught earlier
-        }
-        
-        // Get the amount for signature checking
-        Amount amount = coin.GetAmount();
-        
-        // Create signature checker for this input
-        TransactionSignatureChecker checker(&tx, static_cast<unsigned int>(i), amount);
-        
-        // Verify the script
-        ScriptError error;
-        if (!VerifyScript(txin.scriptSig, 
-                          coin.GetScriptPubKey(), 
-                          flags, 
-                          checker, 
-                          &error)) {
-            // Script verification failed
-            return false;
-        }
+ScriptFlags GetBlockScriptFlags(int nHeight, const consensus::Params& params) {
+    (void)nHeight;
+    (void)params;
+    return ScriptFlags::MANDATORY_VERIFY_FLAGS;
+}
+
+// ============================================================================
+// Coins Cache Flush Policy
+// ============================================================================
+
+const char* FlushDecisionName(FlushDecision decision) {
+    switch (decision) {
+        case FlushDecision::NONE:       return "none";
+        case FlushDecision::BACKGROUND: return "background";
+        case FlushDecision::FORCED:     return "forced";
+        case FlushDecision::IDLE:       return "idle";
     }
-    
-    return true;
+    return "unknown";
 }
 
 // ============================================================================
@@ -97,12 +79,99 @@ bool ChainState::Initialize() {
     }
     
     // Set the chain to this tip
-    m_chain.SetTip(it->second.get());
+    m_chain.SetTip(it->second);
     
     m_initialized = true;
     return true;
 }
 
+bool ChainState::IsAssumedValid(const BlockIndex* pindex) const {
+    if (m_assumeValid.IsNull() || !pindex) {
+        return false;
+    }
+    
+    // Fall back to full verification unless the assume-valid block is in
+    // our header index and has not been found invalid
+    auto it = m_blockIndex.find(m_assumeValid);
+    if (it == m_blockIndex.end()) {
+        return false;
+    }
+    const BlockIndex* pindexAssumed = it->second;
+    if (HasStatus(pindexAssumed->nStatus, BlockStatus::FAILED_MASK)) {
+        return false;
+    }
+    
+    // Only blocks on the chain leading to the assume-valid block qualify
+    if (pindex->nHeight > pindexAssumed->nHeight) {
+        return false;
+    }
+    return pindexAssumed->GetAncestor(pindex->nHeight) == pindex;
+}
+
+bool ChainState::CheckBlockScripts(const Block& block, const CoinsViewCache& view,
+                                   ScriptFlags flags) {
+    SHURIUM_TRACE_SPAN("ChainState::CheckBlockScripts");
+    // Fan the input checks out over the script check workers. Each
+    // transaction's checks are queued as soon as they are collected, so
+    // workers verify while we are still walking the block.
+    CheckQueueControl control(m_scriptCheckQueue);
+    SignatureCache& sigCache = GetSignatureCache();
+    ScriptExecutionCache& scriptCache = GetScriptExecutionCache();
+    scriptCache.SetActiveFlags(flags);
+    
+    // Transactions verified here are remembered once the whole block passes
+    std::vector<Hash256> uncachedEntries;
+    
+    // Sighash data shared by each transaction's checks; reserved up front so
+    // the checks' pointers stay valid until Wait returns
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(block.vtx.size());
+    
+    for (const auto& ptx : block.vtx) {
+        const Transaction& tx = *ptx;
+        
+        // Coinbase transactions have no inputs to verify
+        if (tx.IsCoinBase()) {
+            continue;
+        }
+        
+        // Skip transactions already verified under these flags (typically
+        // on mempool admission)
+        Hash256 entry = scriptCache.ComputeEntry(tx.GetHash(), flags);
+        if (scriptCache.Contains(entry)) {
+            continue;
+        }
+        uncachedEntries.push_back(entry);
+        
+        const PrecomputedTransactionData& precomputed = txdata.emplace_back(tx);
+        std::vector<ScriptCheck> checks;
+        checks.reserve(tx.vin.size());
+        
+        for (size_t i = 0; i < tx.vin.size(); ++i) {
+            const Coin& coin = view.AccessCoin(tx.vin[i].prevout);
+            if (coin.IsSpent()) {
+                return false;  // Should have been caught earlier
+            }
+            checks.emplace_back(coin, tx, static_cast<unsigned int>(i), flags, &precomputed,
+                                &sigCache);
+        }
+        
+        control.Add(std::move(checks));
+    }
+    
+    if (!control.Wait()) {
+        LOG_DEBUG(util::LogCategory::DEFAULT) << "Script verification failed: "
+                                               << ScriptErrorString(control.GetError());
+        return false;
+    }
+    
+    for (const auto& entry : uncachedEntries) {
+        scriptCache.Insert(entry);
+    }
+    
+    return true;
+}
+
 ConnectResult ChainState::ConnectBlock(const Block& block, BlockIndex* pindex,
                                         BlockUndo& blockundo) {
     std::lock_guard<std::mutex> lock(m_cs);
@@ -112,21 +181,38 @@ ConnectResult ChainState::ConnectBlock(const Block& block, BlockIndex* pindex,
         return ConnectResult::FAILED;
     }
     
+    ConnectResult result = ConnectBlock(block, pindex, *m_coins, blockundo);
+    if (!IsSuccess(result)) {
+        return result;
+    }
+    
+    // Update the chain
+    m_chain.SetTip(pindex);
+    
+    // Update block index status
+    pindex->RaiseValidity(BlockStatus::VALID_SCRIPTS);
+    pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_DATA;
+    
+    ScheduleFlush();
+    return ConnectResult::OK;
+}
+
+ConnectResult ChainState::ConnectBlock(const Block& block, BlockIndex* pindex,
+                                        CoinsViewCache& view, BlockUndo& blockundo) {
+    // Caller holds m_cs. Every path that connects a block comes through here.
+    static util::Histogram& latency = util::MetricsRegistry::Instance().GetHistogram(
+        "shurium_validation_connect_block_microseconds", "Time to validate and connect a block");
+    util::ScopedLatency timer(latency);
+    SHURIUM_TRACE_SPAN("ChainState::ConnectBlock");
+    
     // Determine script verification flags based on block height
-    // Use mandatory flags for block validation (less strict than mempool)
-    ScriptFlags scriptFlags = ScriptFlags::MANDATORY_VERIFY_FLAGS;
+    ScriptFlags scriptFlags = GetBlockScriptFlags(pindex->nHeight, m_params);
     
     // First pass: Verify all transaction scripts BEFORE spending coins
-    // This ensures we have access to the original outputs for signature verification
-    for (size_t i = 0; i < block.vtx.size(); ++i) {
-        const Transaction& tx = *block.vtx[i];
-        
-        if (!tx.IsCoinBase()) {
-            // Verify all input scripts for this transaction
-            if (!VerifyTransactionScripts(tx, *m_coins, scriptFlags)) {
-                return ConnectResult::CONSENSUS_ERROR;
-            }
-        }
+    // This ensures we have access to the original outputs for signature
+    // verification, and that the view is untouched if any script fails
+    if (!IsAssumedValid(pindex) && !CheckBlockScripts(block, view, scriptFlags)) {
+        return ConnectResult::CONSENSUS_ERROR;
     }
     
     // Second pass: Update UTXO set
@@ -146,92 +232,33 @@ ConnectResult ChainState::ConnectBlock(const Block& block, BlockIndex* pindex,
                 const OutPoint& prevout = tx.vin[j].prevout;
                 
                 // Get the coin being spent
-                const Coin& coin = m_coins->AccessCoin(prevout);
+                const Coin& coin = view.AccessCoin(prevout);
                 if (coin.IsSpent()) {
                     return ConnectResult::MISSING_INPUTS;
                 }
                 
                 // Check coinbase maturity
-                if (coin.IsCoinBase()) {
-                    if (!coin.IsMature(pindex->nHeight)) {
-                        return ConnectResult::PREMATURE_SPEND;
-                    }
+                if (coin.IsCoinBase() && !coin.IsMature(pindex->nHeight)) {
+                    return ConnectResult::PREMATURE_SPEND;
                 }
                 
                 // Save for undo
                 txundo.vprevout[j] = coin;
                 
                 // Spend the coin
-                if (!m_coins->SpendCoin(prevout)) {
+                if (!view.SpendCoin(prevout)) {
                     return ConnectResult::DOUBLE_SPEND;
                 }
             }
         }
         
         // Add outputs
-        m_coins->AddTransaction(tx, pindex->nHeight);
-    }
-    
-    // Update best block
-    m_coins->SetBestBlock(pindex->GetBlockHash());
-    
-    // Update the chain
-    m_chain.SetTip(pindex);
-    
-    // Update block index status
-    pindex->RaiseValidity(BlockStatus::VALID_SCRIPTS);
-    pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_DATA;
-    
-    return ConnectResult::OK;
-}
-
-bool ChainState::ConnectBlock(const Block& block, BlockIndex* pindex,
-                              CoinsViewCache& view, BlockUndo& blockundo) {
-    // Internal helper - called with lock held
-    
-    // Determine script verification flags
-    ScriptFlags scriptFlags = ScriptFlags::MANDATORY_VERIFY_FLAGS;
-    
-    // First pass: Verify all transaction scripts
-    for (size_t i = 0; i < block.vtx.size(); ++i) {
-        const Transaction& tx = *block.vtx[i];
-        
-        if (!tx.IsCoinBase()) {
-            if (!VerifyTransactionScripts(tx, view, scriptFlags)) {
-                return false;
-            }
-        }
-    }
-    
-    // Second pass: Update UTXO set
-    blockundo.vtxundo.resize(block.vtx.size() - 1);
-    
-    for (size_t i = 0; i < block.vtx.size(); ++i) {
-        const Transaction& tx = *block.vtx[i];
-        
-        if (!tx.IsCoinBase()) {
-            TxUndo& txundo = blockundo.vtxundo[i - 1];
-            txundo.vprevout.resize(tx.vin.size());
-            
-            for (size_t j = 0; j < tx.vin.size(); ++j) {
-                const OutPoint& prevout = tx.vin[j].prevout;
-                const Coin& coin = view.AccessCoin(prevout);
-                
-                if (coin.IsSpent()) return false;
-                if (coin.IsCoinBase() && !coin.IsMature(pindex->nHeight)) {
-                    return false;
-                }
-                
-                txundo.vprevout[j] = coin;
-                if (!view.SpendCoin(prevout)) return false;
-            }
-        }
-        
         view.AddTransaction(tx, pindex->nHeight);
     }
     
+    // Update best block
     view.SetBestBlock(pindex->GetBlockHash());
-    return true;
+    return ConnectResult::OK;
 }
 
 ConnectResult ChainState::DisconnectTip(const Block& block, const BlockUndo& blockundo) {
@@ -247,54 +274,36 @@ ConnectResult ChainState::DisconnectTip(const Block& block, const BlockUndo& blo
         return ConnectResult::FAILED;
     }
     
-    // Process transactions in reverse order
-    for (int i = static_cast<int>(block.vtx.size()) - 1; i >= 0; --i) {
-        const Transaction& tx = *block.vtx[i];
-        TxHash txhash = tx.GetHash();
-        
-        // Remove outputs
-        for (size_t j = 0; j < tx.vout.size(); ++j) {
-            if (!tx.vout[j].IsNull()) {
-                m_coins->SpendCoin(OutPoint(txhash, static_cast<uint32_t>(j)));
-            }
-        }
-        
-        // Restore inputs (except for coinbase)
-        if (!tx.IsCoinBase()) {
-            const TxUndo& txundo = blockundo.vtxundo[i - 1];
-            for (size_t j = 0; j < tx.vin.size(); ++j) {
-                m_coins->AddCoin(tx.vin[j].prevout, 
-                                 Coin(txundo.vprevout[j]), 
-                                 true);
-            }
-        }
-    }
+    DisconnectBlock(block, pindex, *m_coins, blockundo);
     
-    // Update best block to previous
+    // Move the tip back to the parent
     if (pindex->pprev) {
-        m_coins->SetBestBlock(pindex->pprev->GetBlockHash());
         m_chain.SetTip(pindex->pprev);
     } else {
-        m_coins->SetBestBlock(BlockHash());
         m_chain.Clear();
     }
     
+    ScheduleFlush();
     return ConnectResult::OK;
 }
 
-bool ChainState::DisconnectBlock(const Block& block, const BlockIndex* pindex,
-                                  CoinsViewCache& view, const BlockUndo& blockundo) {
-    // Internal helper
+void ChainState::DisconnectBlock(const Block& block, const BlockIndex* pindex,
+                                 CoinsViewCache& view, const BlockUndo& blockundo) {
+    // Caller holds m_cs
+    
+    // Process transactions in reverse order
     for (int i = static_cast<int>(block.vtx.size()) - 1; i >= 0; --i) {
         const Transaction& tx = *block.vtx[i];
         TxHash txhash = tx.GetHash();
         
+        // Remove outputs
         for (size_t j = 0; j < tx.vout.size(); ++j) {
             if (!tx.vout[j].IsNull()) {
                 view.SpendCoin(OutPoint(txhash, static_cast<uint32_t>(j)));
             }
         }
         
+        // Restore inputs (except for coinbase)
         if (!tx.IsCoinBase()) {
             const TxUndo& txundo = blockundo.vtxundo[i - 1];
             for (size_t j = 0; j < tx.vin.size(); ++j) {
@@ -303,7 +312,8 @@ bool ChainState::DisconnectBlock(const Block& block, const BlockIndex* pindex,
         }
     }
     
-    return true;
+    // Update best block to previous
+    view.SetBestBlock(pindex->pprev ? pindex->pprev->GetBlockHash() : BlockHash());
 }
 
 bool ChainState::ActivateBestChain(BlockIndex* pindexMostWork) {
@@ -311,15 +321,7 @@ bool ChainState::ActivateBestChain(BlockIndex* pindexMostWork) {
     
     // If no target specified, find the best chain
     if (!pindexMostWork) {
-        // Find the block with most work
-        uint64_t bestWork = 0;
-        for (const auto& [hash, pindex] : m_blockIndex) {
-            if (pindex->nChainWork > bestWork && 
-                pindex->IsValid(BlockStatus::VALID_TRANSACTIONS)) {
-                bestWork = pindex->nChainWork;
-                pindexMostWork = pindex.get();
-            }
-        }
+        pindexMostWork = FindMostWorkBlockLocked();
     }
     
     if (!pindexMostWork) return true;  // Nothing to do
@@ -355,9 +357,428 @@ bool ChainState::ActivateBestChain(BlockIndex* pindexMostWork) {
     return true;
 }
 
+BlockIndex* ChainState::FindMostWorkBlockLocked() const {
+    BlockIndex* pindexMostWork = nullptr;
+    uint64_t bestWork = 0;
+    for (const auto& [hash, pindex] : m_blockIndex) {
+        if (pindex->nChainWork > bestWork && 
+            pindex->IsValid(BlockStatus::VALID_TRANSACTIONS)) {
+            bestWork = pindex->nChainWork;
+            pindexMostWork = pindex;
+        }
+    }
+    return pindexMostWork;
+}
+
+BlockIndex* ChainState::FindMostWorkBlock() const {
+    std::lock_guard<std::mutex> lock(m_cs);
+    return FindMostWorkBlockLocked();
+}
+
+bool ChainState::CanReorganizeTo(const BlockIndex* pindexNew) const {
+    std::lock_guard<std::mutex> lock(m_cs);
+    const BlockIndex* ptip = m_chain.Tip();
+    if (!pindexNew || !ptip) {
+        return false;
+    }
+    const BlockIndex* pfork = m_chain.FindFork(pindexNew);
+    if (!pfork || pfork == ptip) {
+        return false;  // Nothing to disconnect
+    }
+    for (const BlockIndex* pindex = ptip; pindex != pfork; pindex = pindex->pprev) {
+        if (!pindex->HaveData() || !pindex->HaveUndo()) {
+            return false;
+        }
+    }
+    for (const BlockIndex* pindex = pindexNew; pindex != pfork; pindex = pindex->pprev) {
+        if (!pindex->HaveData() || pindex->IsFailed()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChainState::Reorganize(BlockIndex* pindexNew, db::BlockDB& blockdb,
+                            util::ThreadPool* pool, ReorgStats* stats, ReorgBlocks* blocks) {
+    std::lock_guard<std::mutex> lock(m_cs);
+    
+    ReorgStats localStats;
+    ReorgStats& reorg = stats ? *stats : localStats;
+    reorg = ReorgStats();
+    if (!pindexNew) {
+        return false;
+    }
+    
+    const BlockIndex* pfork = m_chain.FindFork(pindexNew);
+    if (!pfork && m_chain.Tip()) {
+        return false;  // No common ancestor
+    }
+    reorg.forkHeight = pfork ? pfork->nHeight : -1;
+    
+    std::vector<BlockIndex*> toDisconnect;
+    for (BlockIndex* pindex = m_chain.Tip(); pindex && pindex != pfork; pindex = pindex->pprev) {
+        toDisconnect.push_back(pindex);
+    }
+    std::vector<BlockIndex*> toConnect;
+    for (BlockIndex* pindex = pindexNew; pindex && pindex != pfork; pindex = pindex->pprev) {
+        toConnect.push_back(pindex);
+    }
+    std::reverse(toConnect.begin(), toConnect.end());
+    
+    // Load phase: every block, plus undo data for the ones going away
+    auto phaseStart = std::chrono::steady_clock::now();
+    struct LoadedBlock {
+        Block block;
+        BlockUndo undo;
+    };
+    std::vector<LoadedBlock> disconnectData(toDisconnect.size());
+    std::vector<LoadedBlock> connectData(toConnect.size());
+    auto load = [&blockdb](const BlockIndex* pindex, LoadedBlock& out, bool fUndo) {
+        if (!pindex->HaveData() || (fUndo && !pindex->HaveUndo())) {
+            return false;
+        }
+        if (!blockdb.ReadBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), out.block).ok() ||
+            out.block.GetHash() != pindex->GetBlockHash() || out.block.vtx.empty()) {
+            return false;
+        }
+        if (!fUndo) {
+            return true;
+        }
+        return blockdb.ReadUndo(db::DiskBlockPos(pindex->nFile, pindex->nUndoPos), out.undo).ok() &&
+               out.undo.vtxundo.size() + 1 == out.block.vtx.size();
+    };
+    
+    bool fLoaded = true;
+    if (pool) {
+        std::vector<std::future<bool>> results;
+        results.reserve(toDisconnect.size() + toConnect.size());
+        for (size_t i = 0; i < toDisconnect.size(); ++i) {
+            results.push_back(pool->Submit([&, i]() {
+                return load(toDisconnect[i], disconnectData[i], true);
+            }));
+        }
+        for (size_t i = 0; i < toConnect.size(); ++i) {
+            results.push_back(pool->Submit([&, i]() {
+                return load(toConnect[i], connectData[i], false);
+            }));
+        }
+        for (auto& result : results) {
+            fLoaded = result.get() && fLoaded;
+        }
+    } else {
+        for (size_t i = 0; i < toDisconnect.size() && fLoaded; ++i) {
+            fLoaded = load(toDisconnect[i], disconnectData[i], true);
+        }
+        for (size_t i = 0; i < toConnect.size() && fLoaded; ++i) {
+            fLoaded = load(toConnect[i], connectData[i], false);
+        }
+    }
+    reorg.loadMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - phaseStart).count();
+    if (!fLoaded) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "Reorganize: missing block or undo data";
+        return false;
+    }
+    
+    // Apply phase: one scratch layer for the whole switch
+    phaseStart = std::chrono::steady_clock::now();
+    FinishBackgroundFlush(true);
+    CoinsViewCache view(m_coins.get());
+    for (size_t i = 0; i < toDisconnect.size(); ++i) {
+        DisconnectBlock(disconnectData[i].block, toDisconnect[i], view, disconnectData[i].undo);
+    }
+    for (size_t i = 0; i < toConnect.size(); ++i) {
+        BlockIndex* pindex = toConnect[i];
+        if (!IsSuccess(ConnectBlock(connectData[i].block, pindex, view, connectData[i].undo))) {
+            pindex->nStatus = pindex->nStatus | BlockStatus::FAILED_VALID;
+            for (size_t j = i + 1; j < toConnect.size(); ++j) {
+                toConnect[j]->nStatus = toConnect[j]->nStatus | BlockStatus::FAILED_CHILD;
+            }
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Reorganize: block " 
+                                                   << pindex->GetBlockHash().ToHex()
+                                                   << " at height " << pindex->nHeight
+                                                   << " failed to connect";
+            return false;
+        }
+    }
+    reorg.applyMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - phaseStart).count();
+    
+    // Commit phase: undo data for the new blocks, then the coins, then the tip
+    phaseStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < toConnect.size(); ++i) {
+        BlockIndex* pindex = toConnect[i];
+        db::DiskBlockPos pos;
+        // The index keeps one file number, so undo must land beside the block
+        if (blockdb.WriteUndo(connectData[i].undo, pos).ok() && pos.nFile == pindex->nFile) {
+            pindex->nUndoPos = pos.nPos;
+            pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_UNDO;
+        }
+        pindex->RaiseValidity(BlockStatus::VALID_SCRIPTS);
+    }
+    if (!view.Flush()) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "Reorganize: failed to merge the coins view";
+        return false;
+    }
+    m_chain.SetTip(pindexNew);
+    ScheduleFlush();
+    reorg.flushMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - phaseStart).count();
+    
+    reorg.nDisconnected = static_cast<int>(toDisconnect.size());
+    reorg.nConnected = static_cast<int>(toConnect.size());
+    
+    if (blocks) {
+        blocks->disconnected.clear();
+        blocks->connected.clear();
+        for (size_t i = 0; i < toDisconnect.size(); ++i) {
+            blocks->disconnected.emplace_back(std::move(disconnectData[i].block), toDisconnect[i]);
+        }
+        for (size_t i = 0; i < toConnect.size(); ++i) {
+            blocks->connected.emplace_back(std::move(connectData[i].block), toConnect[i]);
+        }
+    }
+    return true;
+}
+
+BlockIndex* ChainState::FindNextBlock(const BlockIndex* pindex) const {
+    std::lock_guard<std::mutex> lock(m_cs);
+    if (!pindex) {
+        return m_chain.Genesis();
+    }
+    if (m_chain.Contains(pindex)) {
+        return m_chain.Next(pindex);
+    }
+    const BlockIndex* pfork = m_chain.FindFork(pindex);
+    return pfork ? m_chain.Next(pfork) : m_chain.Genesis();
+}
+
+bool ChainState::ActivateSnapshotBase(BlockIndex* pbase) {
+    if (!pbase) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_cs);
+    FinishBackgroundFlush(true);
+    if (m_coins->GetBestBlock() != pbase->GetBlockHash()) {
+        m_coins->Reset();
+    }
+    if (m_coins->GetBestBlock() != pbase->GetBlockHash()) {
+        return false;
+    }
+    
+    m_chain.SetTip(pbase);
+    LOG_INFO(util::LogCategory::DEFAULT) << "Chain tip set to snapshot base "
+                                         << pbase->GetBlockHash().ToHex()
+                                         << " at height " << pbase->nHeight;
+    return true;
+}
+
 bool ChainState::FlushStateToDisk() {
+    SHURIUM_TRACE_SPAN("ChainState::FlushStateToDisk");
     std::lock_guard<std::mutex> lock(m_cs);
-    return m_coins->Flush();
+    bool previousOk = FinishBackgroundFlush(true);
+    return FlushBlockFiles() && m_coins->Flush() && previousOk;
+}
+
+bool ChainState::FlushBlockFiles() {
+    // Blocks and undo data reach disk before the coins that depend on them
+    if (!m_blockdb) {
+        return true;
+    }
+    db::Status status = m_blockdb->FlushFiles();
+    if (!status.ok()) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to flush block files: "
+                                               << status.ToString();
+        return false;
+    }
+    return true;
+}
+
+bool ChainState::FlushStateToDiskAsync() {
+    std::lock_guard<std::mutex> lock(m_cs);
+    if (!FinishBackgroundFlush(false)) {
+        return false;
+    }
+    if (m_flushResult.valid()) {
+        return true;  // Previous write still running
+    }
+    m_flushRetainBytes = GetEffectiveCacheLimit();
+    return StartBackgroundFlush();
+}
+
+bool ChainState::WaitForFlush() {
+    std::lock_guard<std::mutex> lock(m_cs);
+    return FinishBackgroundFlush(true);
+}
+
+Hash256 ChainState::GetRollingUTXOSetHash() {
+    std::lock_guard<std::mutex> lock(m_cs);
+    FinishBackgroundFlush(true);
+    return m_coins->GetRollingUTXOSetHash();
+}
+
+bool ChainState::StartBackgroundFlush() {
+    // Caller holds m_cs and has no write in flight
+    if (!FlushBlockFiles()) {
+        return false;
+    }
+    if (!m_coinsDB) {
+        return m_coins->Flush();
+    }
+    
+    auto snapshot = m_coins->BeginFlush();
+    if (!snapshot) {
+        return false;
+    }
+    m_nBlocksSinceFlush = 0;
+    
+    LOG_DEBUG(util::LogCategory::DEFAULT) << "Writing " << snapshot->coins.size()
+                                           << " UTXO changes in the background";
+    
+    // The snapshot is immutable and the cache reads it only, so the writer
+    // needs no lock; it touches nothing but the snapshot and the database
+    CoinsView* coinsDB = m_coinsDB;
+    m_flushResult = std::async(std::launch::async, [coinsDB, snapshot]() {
+        return coinsDB->BatchWrite(snapshot->coins, snapshot->bestBlock, snapshot->hashDelta);
+    });
+    return true;
+}
+
+size_t ChainState::GetEffectiveCacheLimit() const {
+    // Caller holds m_cs. The mempool grows into the cache's share, never
+    // below the floor.
+    if (m_coinsCacheLimit == 0) {
+        return 0;
+    }
+    size_t floor = std::min(m_coinsCacheLimit, MIN_COINS_CACHE_BYTES);
+    size_t mempool = m_mempoolUsage.load(std::memory_order_relaxed);
+    return mempool >= m_coinsCacheLimit - floor ? floor : m_coinsCacheLimit - mempool;
+}
+
+void ChainState::StartPolicyFlush(FlushDecision decision, size_t retainBytes) {
+    // Caller holds m_cs and has no write in flight
+    m_flushRetainBytes = retainBytes;
+    if (!StartBackgroundFlush()) {
+        return;
+    }
+    switch (decision) {
+        case FlushDecision::BACKGROUND: ++m_cacheStats.nBackgroundFlushes; break;
+        case FlushDecision::FORCED:     ++m_cacheStats.nForcedFlushes; break;
+        case FlushDecision::IDLE:       ++m_cacheStats.nIdleFlushes; break;
+        case FlushDecision::NONE:       break;
+    }
+    m_cacheStats.lastDecision = decision;
+}
+
+void ChainState::ScheduleFlush() {
+    // Caller holds m_cs; called after every block applied to the cache
+    ++m_nBlocksSinceFlush;
+    m_lastBlockTime = std::chrono::steady_clock::now();
+    
+    // Release a finished background write
+    FinishBackgroundFlush(false);
+    size_t limit = GetEffectiveCacheLimit();
+    if (limit == 0) {
+        return;
+    }
+    
+    FlushDecision decision = FlushDecision::BACKGROUND;
+    size_t usage = m_coins->GetCacheUsage();
+    if (usage > limit && m_flushResult.valid()) {
+        // Writes fall behind: wait rather than grow past the limit
+        FinishBackgroundFlush(true);
+        usage = m_coins->GetCacheUsage();
+        decision = FlushDecision::FORCED;
+    }
+    if (!m_flushResult.valid() && usage > limit / 100 * COINS_CACHE_FLUSH_PERCENT) {
+        StartPolicyFlush(decision, limit / 100 * COINS_CACHE_RETAIN_PERCENT);
+    }
+}
+
+bool ChainState::FlushIfIdle(std::chrono::seconds idleFor) {
+    std::lock_guard<std::mutex> lock(m_cs);
+    FinishBackgroundFlush(false);
+    if (m_flushResult.valid() || m_nBlocksSinceFlush == 0 ||
+        std::chrono::steady_clock::now() - m_lastBlockTime < idleFor) {
+        return false;
+    }
+    
+    // Nothing to validate: write everything, but keep the cache warm
+    size_t limit = GetEffectiveCacheLimit();
+    StartPolicyFlush(FlushDecision::IDLE, limit > 0 ? limit : std::numeric_limits<size_t>::max());
+    return m_flushResult.valid();
+}
+
+CoinsCacheStats ChainState::GetCoinsCacheStats() const {
+    std::lock_guard<std::mutex> lock(m_cs);
+    CoinsCacheStats stats = m_cacheStats;
+    stats.nConfiguredLimit = m_coinsCacheLimit;
+    stats.nLimit = GetEffectiveCacheLimit();
+    stats.nUsage = m_coins->GetCacheUsage();
+    stats.nMempoolUsage = m_mempoolUsage.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool ChainState::FinishBackgroundFlush(bool wait) {
+    // Caller holds m_cs
+    if (!m_flushResult.valid()) {
+        return true;
+    }
+    if (!wait && m_flushResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return true;
+    }
+    
+    bool written = false;
+    try {
+        written = m_flushResult.get();
+    } catch (const std::exception& e) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "Background UTXO flush threw: " << e.what();
+    }
+    
+    // Keep the newest entries warm and let the oldest go
+    size_t retainBytes = m_flushRetainBytes;
+    m_flushRetainBytes = 0;
+    m_coins->EndFlush(written, retainBytes > 0);
+    if (!written) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "Background UTXO flush failed; "
+                                               << "changes kept in the cache";
+    } else if (retainBytes > 0) {
+        size_t nEvicted = m_coins->Trim(retainBytes);
+        m_cacheStats.nEvicted += nEvicted;
+        LOG_DEBUG(util::LogCategory::DEFAULT) << "UTXO flush done; released " << nEvicted
+                                               << " cold entries, " << m_coins->GetCacheSize()
+                                               << " cached";
+    }
+    return written;
+}
+
+uint64_t ChainState::FilterCachedCoins(std::vector<OutPoint>& outpoints) const {
+    std::lock_guard<std::mutex> lock(m_cs);
+    outpoints.erase(std::remove_if(outpoints.begin(), outpoints.end(),
+                                   [this](const OutPoint& outpoint) {
+                                       return m_coins->HaveCoinInCache(outpoint);
+                                   }),
+                    outpoints.end());
+    return m_coins->GetFlushGeneration();
+}
+
+size_t ChainState::WarmCoins(std::vector<std::pair<OutPoint, Coin>>&& coins,
+                             uint64_t generation) {
+    std::lock_guard<std::mutex> lock(m_cs);
+    
+    // A flush in between may have written newer state than we read
+    if (m_coins->GetFlushGeneration() != generation) {
+        return 0;
+    }
+    
+    size_t nWarmed = 0;
+    for (auto& [outpoint, coin] : coins) {
+        if (m_coins->WarmCoin(outpoint, std::move(coin))) {
+            ++nWarmed;
+        }
+    }
+    return nWarmed;
 }
 
 // ============================================================================
@@ -365,26 +786,102 @@ bool ChainState::FlushStateToDisk() {
 // ============================================================================
 
 ChainStateManager::ChainStateManager()
-    : m_params(consensus::Params::Main()) {}
+    : m_params(consensus::Params::Main())
+    , m_assumeValid(m_params.defaultAssumeValid) {}
 
 ChainStateManager::ChainStateManager(const consensus::Params& params)
-    : m_params(params) {}
+    : m_params(params)
+    , m_assumeValid(m_params.defaultAssumeValid) {}
+
+ChainStateManager::~ChainStateManager() = default;
 
 bool ChainStateManager::Initialize(CoinsView* coinsDB) {
     m_activeChainState = std::make_unique<ChainState>(
         m_blockIndex, m_params, coinsDB);
+    m_activeChainState->SetScriptCheckQueue(m_scriptCheckQueue.get());
+    m_activeChainState->SetAssumeValid(m_assumeValid);
+    m_activeChainState->SetBlockDB(m_blockdb);
     
     return m_activeChainState->Initialize();
 }
 
+void ChainStateManager::SetBlockDB(db::BlockDB* blockdb) {
+    m_blockdb = blockdb;
+    if (m_activeChainState) {
+        m_activeChainState->SetBlockDB(blockdb);
+    }
+}
+
+void ChainStateManager::SetScriptCheckThreads(int nThreads) {
+    // Detach the old queue before destroying it
+    if (m_activeChainState) {
+        m_activeChainState->SetScriptCheckQueue(nullptr);
+    }
+    
+    // A single thread gains nothing from a queue; verify inline instead
+    if (nThreads > 1) {
+        m_scriptCheckQueue = std::make_unique<CheckQueue>(
+            static_cast<size_t>(std::min(nThreads, MAX_SCRIPTCHECK_THREADS)));
+    } else {
+        m_scriptCheckQueue.reset();
+    }
+    
+    if (m_activeChainState) {
+        m_activeChainState->SetScriptCheckQueue(m_scriptCheckQueue.get());
+    }
+}
+
+int ChainStateManager::GetScriptCheckThreads() const {
+    return m_scriptCheckQueue
+        ? static_cast<int>(m_scriptCheckQueue->GetWorkerCount())
+        : 1;
+}
+
+void ChainStateManager::SetPrefetchThreads(int nThreads) {
+    if (nThreads > 0) {
+        util::ThreadPool::Config config;
+        config.numThreads = static_cast<size_t>(nThreads);
+        config.name = "coinprefetch";
+        m_prefetchPool = std::make_unique<util::ThreadPool>(config);
+    } else {
+        m_prefetchPool.reset();
+    }
+}
+
+int ChainStateManager::GetPrefetchThreads() const {
+    return m_prefetchPool ? static_cast<int>(m_prefetchPool->ThreadCount()) : 0;
+}
+
+void ChainStateManager::SetBlockCheckThreads(int nThreads) {
+    if (nThreads > 0) {
+        util::ThreadPool::Config config;
+        config.numThreads = static_cast<size_t>(nThreads);
+        config.name = "blockcheck";
+        m_blockCheckPool = std::make_unique<util::ThreadPool>(config);
+    } else {
+        m_blockCheckPool.reset();
+    }
+}
+
+int ChainStateManager::GetBlockCheckThreads() const {
+    return m_blockCheckPool ? static_cast<int>(m_blockCheckPool->ThreadCount()) : 0;
+}
+
+void ChainStateManager::SetAssumeValid(const BlockHash& hash) {
+    m_assumeValid = hash;
+    if (m_activeChainState) {
+        m_activeChainState->SetAssumeValid(hash);
+    }
+}
+
 BlockIndex* ChainStateManager::LookupBlockIndex(const BlockHash& hash) {
     auto it = m_blockIndex.find(hash);
-    return (it != m_blockIndex.end()) ? it->second.get() : nullptr;
+    return (it != m_blockIndex.end()) ? it->second : nullptr;
 }
 
 const BlockIndex* ChainStateManager::LookupBlockIndex(const BlockHash& hash) const {
     auto it = m_blockIndex.find(hash);
-    return (it != m_blockIndex.end()) ? it->second.get() : nullptr;
+    return (it != m_blockIndex.end()) ? it->second : nullptr;
 }
 
 BlockIndex* ChainStateManager::AddBlockIndex(const BlockHash& hash, 
@@ -392,19 +889,18 @@ BlockIndex* ChainStateManager::AddBlockIndex(const BlockHash& hash,
     // Check if already exists
     auto it = m_blockIndex.find(hash);
     if (it != m_blockIndex.end()) {
-        return it->second.get();
+        return it->second;
     }
     
-    // Create new index entry
-    auto pindex = std::make_unique<BlockIndex>(header);
-    BlockIndex* pindexNew = pindex.get();
+    // Create new index entry (the map sets the block hash pointer)
+    BlockIndex* pindexNew = m_blockIndex.Insert(hash).first;
+    pindexNew->SetHeader(header);
     
     // Set up parent pointer
     if (!header.hashPrevBlock.IsNull()) {
-        auto pit = m_blockIndex.find(BlockHash(header.hashPrevBlock));
-        if (pit != m_blockIndex.end()) {
-            pindexNew->pprev = pit->second.get();
-            pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
+        if (BlockIndex* pprev = m_blockIndex.Lookup(BlockHash(header.hashPrevBlock))) {
+            pindexNew->pprev = pprev;
+            pindexNew->nHeight = pprev->nHeight + 1;
         }
     }
     
@@ -416,16 +912,10 @@ BlockIndex* ChainStateManager::AddBlockIndex(const BlockHash& hash,
     pindexNew->nTimeMax = pindexNew->pprev ? 
         std::max(pindexNew->pprev->nTimeMax, header.nTime) : header.nTime;
     
-    // Insert into map
-    auto [insertIt, inserted] = m_blockIndex.emplace(hash, std::move(pindex));
-    
-    // Set the hash pointer
-    insertIt->second->phashBlock = &insertIt->first;
-    
     // Build skip pointer
-    insertIt->second->BuildSkip();
+    pindexNew->BuildSkip();
     
-    return insertIt->second.get();
+    return pindexNew;
 }
 
 BlockIndex* ChainStateManager::ProcessBlockHeader(const BlockHeader& header) {
@@ -464,7 +954,99 @@ BlockIndex* ChainStateManager::ProcessBlockHeader(const BlockHeader& header) {
     return pindex;
 }
 
+size_t ChainStateManager::ProcessBlockHeaders(const std::vector<BlockHeader>& headers,
+                                              consensus::ValidationState& state,
+                                              const std::vector<BlockHash>* hashes) {
+    if (headers.empty()) {
+        return 0;
+    }
+    
+    std::vector<BlockHash> computed;
+    if (!hashes) {
+        computed = GetBlockHeaderHashes(headers);
+        hashes = &computed;
+    }
+    
+    // The first header fixes the heights of the rest
+    int32_t firstHeight = 0;
+    if (!headers[0].hashPrevBlock.IsNull()) {
+        BlockIndex* pprev = LookupBlockIndex(BlockHash(headers[0].hashPrevBlock));
+        if (!pprev) {
+            state.Invalid("prev-blk-not-found", "headers do not connect to the index");
+            return 0;
+        }
+        firstHeight = pprev->nHeight + 1;
+    }
+    
+    size_t nValid = consensus::CheckHeaderBatch(headers, *hashes, firstHeight, m_params,
+                                                &m_checkpoints, state,
+                                                m_blockCheckPool.get());
+    
+    for (size_t i = 0; i < nValid; ++i) {
+        BlockIndex* pindex = AddBlockIndex((*hashes)[i], headers[i]);
+        if (!m_bestHeader || pindex->nChainWork > m_bestHeader->nChainWork) {
+            m_bestHeader = pindex;
+        }
+    }
+    return nValid;
+}
+
 bool ChainStateManager::ProcessNewBlock(const Block& block, bool fForceProcessing) {
+    SHURIUM_TRACE_SPAN("ChainStateManager::ProcessNewBlock");
+    return AcceptBlock(block, fForceProcessing, nullptr, false);
+}
+
+size_t ChainStateManager::ProcessNewBlocks(const std::vector<Block>& blocks) {
+    if (!m_blockCheckPool) {
+        size_t nAccepted = 0;
+        while (nAccepted < blocks.size() && ProcessNewBlock(blocks[nAccepted])) {
+            ++nAccepted;
+        }
+        return nAccepted;
+    }
+    
+    // Check stage: CheckBlock() runs on the pool, up to a window ahead
+    std::deque<std::future<bool>> checks;
+    size_t nSubmitted = 0;
+    auto fill = [&]() {
+        while (nSubmitted < blocks.size() && checks.size() < DEFAULT_BLOCK_CHECK_AHEAD) {
+            const Block* pblock = &blocks[nSubmitted++];
+            checks.push_back(m_blockCheckPool->Submit([this, pblock]() {
+                consensus::ValidationState state;
+                return consensus::CheckBlock(*pblock, state, m_params);
+            }));
+        }
+    };
+    
+    // Connect stage: consume the results in order on this thread
+    size_t nAccepted = 0;
+    fill();
+    while (!checks.empty()) {
+        bool fChecked = checks.front().get();
+        checks.pop_front();
+        
+        // A failed check is redone inline so the block is marked and logged
+        if (!AcceptBlock(blocks[nAccepted], false, nullptr, fChecked)) {
+            break;
+        }
+        ++nAccepted;
+        fill();
+    }
+    
+    // The checks still queued reference the blocks
+    for (auto& check : checks) {
+        check.wait();
+    }
+    return nAccepted;
+}
+
+bool ChainStateManager::ProcessStoredBlock(const Block& block, const db::DiskBlockPos& pos,
+                                           bool fCheckedBlock) {
+    return AcceptBlock(block, false, &pos, fCheckedBlock);
+}
+
+bool ChainStateManager::AcceptBlock(const Block& block, bool fForceProcessing,
+                                    const db::DiskBlockPos* dbp, bool fCheckedBlock) {
     // Process the header first
     BlockIndex* pindex = ProcessBlockHeader(block.GetBlockHeader());
     if (!pindex) {
@@ -479,7 +1061,7 @@ bool ChainStateManager::ProcessNewBlock(const Block& block, bool fForceProcessin
     
     // Validate the full block
     consensus::ValidationState state;
-    if (!consensus::CheckBlock(block, state, m_params)) {
+    if (!fCheckedBlock && !consensus::CheckBlock(block, state, m_params)) {
         pindex->nStatus = pindex->nStatus | BlockStatus::FAILED_VALID;
         LOG_ERROR(util::LogCategory::DEFAULT) << "ProcessNewBlock: CheckBlock failed - " 
                                                << state.GetRejectReason() << ": " << state.GetDebugMessage();
@@ -487,9 +1069,17 @@ bool ChainStateManager::ProcessNewBlock(const Block& block, bool fForceProcessin
     }
     
     // Store block to disk if we have a block database
-    if (m_blockdb) {
+    if (dbp) {
+        // Already on disk (reindex): just record where
+        pindex->nFile = dbp->nFile;
+        pindex->nDataPos = dbp->nPos;
+        pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_DATA;
+        if (m_blockdb) {
+            m_blockdb->AddKnownBlock(*dbp, pindex->nHeight, block.nTime);
+        }
+    } else if (m_blockdb) {
         db::DiskBlockPos pos;
-        db::Status dbStatus = m_blockdb->WriteBlock(block, pos);
+        db::Status dbStatus = m_blockdb->WriteBlock(block, pos, pindex->nHeight);
         if (!dbStatus.ok()) {
             LOG_ERROR(util::LogCategory::DEFAULT) << "ProcessNewBlock: Failed to store block - " 
                                                    << dbStatus.ToString();
@@ -510,7 +1100,226 @@ bool ChainStateManager::ProcessNewBlock(const Block& block, bool fForceProcessin
     pindex->nTx = static_cast<uint32_t>(block.vtx.size());
     
     // Try to activate best chain (this may connect this block)
-    return ActivateBestChain();
+    if (!ActivateBestChain()) {
+        return false;
+    }
+    
+    if (m_blockdb && m_blockdb->IsPruneMode()) {
+        PruneBlockFiles();
+    }
+    
+    if (GetActiveTip() == pindex) {
+        std::lock_guard<std::mutex> lock(m_callbacksMutex);
+        if (m_lastAnnounced != pindex) {
+            m_lastAnnounced = pindex;
+            for (const auto& [id, callback] : m_blockConnectedCallbacks) {
+                callback(block, pindex);
+            }
+        }
+    }
+    return true;
+}
+
+bool ChainStateManager::ActivateBestChain() {
+    if (!m_activeChainState) {
+        return false;
+    }
+    
+    if (m_blockdb) {
+        BlockIndex* pbest = m_activeChainState->FindMostWorkBlock();
+        if (pbest && m_activeChainState->CanReorganizeTo(pbest)) {
+            return Reorganize(pbest);
+        }
+    }
+    return m_activeChainState->ActivateBestChain();
+}
+
+bool ChainStateManager::Reorganize(BlockIndex* pindexNew) {
+    if (!m_activeChainState || !m_blockdb) {
+        return false;
+    }
+    
+    ReorgStats stats;
+    ReorgBlocks blocks;
+    bool fNotify;
+    {
+        std::lock_guard<std::mutex> lock(m_callbacksMutex);
+        fNotify = !m_blockConnectedCallbacks.empty() || !m_blockDisconnectedCallbacks.empty();
+    }
+    bool ok = m_activeChainState->Reorganize(pindexNew, *m_blockdb, m_prefetchPool.get(), &stats,
+                                             fNotify ? &blocks : nullptr);
+    
+    if (ok && fNotify) {
+        std::lock_guard<std::mutex> lock(m_callbacksMutex);
+        for (const auto& [block, pindex] : blocks.disconnected) {
+            for (const auto& [id, callback] : m_blockDisconnectedCallbacks) {
+                callback(block, pindex);
+            }
+        }
+        for (const auto& [block, pindex] : blocks.connected) {
+            for (const auto& [id, callback] : m_blockConnectedCallbacks) {
+                callback(block, pindex);
+            }
+            m_lastAnnounced = pindex;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(m_cs);
+    if (!ok) {
+        ++m_reorgMetrics.nFailed;
+        return false;
+    }
+    ++m_reorgMetrics.nReorgs;
+    m_reorgMetrics.totalMicros += stats.TotalMicros();
+    m_reorgMetrics.maxMicros = std::max(m_reorgMetrics.maxMicros, stats.TotalMicros());
+    m_reorgMetrics.last = stats;
+    
+    LOG_INFO(util::LogCategory::DEFAULT) << "Reorganized from fork at height " << stats.forkHeight
+                                         << ": " << stats.nDisconnected << " disconnected, "
+                                         << stats.nConnected << " connected in "
+                                         << stats.TotalMicros() / 1000 << "ms (load "
+                                         << stats.loadMicros / 1000 << "ms, apply "
+                                         << stats.applyMicros / 1000 << "ms, flush "
+                                         << stats.flushMicros / 1000 << "ms)";
+    return true;
+}
+
+int ChainStateManager::RegisterBlockConnected(BlockConnectedCallback callback) {
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    int id = m_nextCallbackId++;
+    m_blockConnectedCallbacks.emplace(id, std::move(callback));
+    return id;
+}
+
+void ChainStateManager::UnregisterBlockConnected(int id) {
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    m_blockConnectedCallbacks.erase(id);
+}
+
+int ChainStateManager::RegisterBlockDisconnected(BlockDisconnectedCallback callback) {
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    int id = m_nextCallbackId++;
+    m_blockDisconnectedCallbacks.emplace(id, std::move(callback));
+    return id;
+}
+
+void ChainStateManager::UnregisterBlockDisconnected(int id) {
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    m_blockDisconnectedCallbacks.erase(id);
+}
+
+int ChainStateManager::PruneBlockFiles() {
+    if (!m_blockdb || !m_blockdb->IsPruneMode()) {
+        return 0;
+    }
+    
+    std::set<int> files = m_blockdb->FindFilesToPrune(GetActiveHeight());
+    if (files.empty()) {
+        return 0;
+    }
+    
+    // Forget the data before the files go, so nothing tries to read it
+    int nBlocks = 0;
+    for (auto& [hash, pindex] : m_blockIndex) {
+        if (HasStatus(pindex->nStatus, BlockStatus::HAVE_MASK) && files.count(pindex->nFile)) {
+            pindex->nStatus = pindex->nStatus & ~BlockStatus::HAVE_MASK;
+            pindex->nFile = 0;
+            pindex->nDataPos = 0;
+            pindex->nUndoPos = 0;
+            ++nBlocks;
+        }
+    }
+    
+    m_blockdb->UnlinkPrunedFiles(files);
+    
+    LOG_INFO(util::LogCategory::DEFAULT) << "Pruned " << files.size() << " block file(s) ("
+                                         << nBlocks << " blocks), usage now "
+                                         << m_blockdb->CalculateCurrentUsage() / (1024 * 1024)
+                                         << " MiB";
+    return static_cast<int>(files.size());
+}
+
+int ChainStateManager::GetPruneHeight() const {
+    const BlockIndex* pindex = GetActiveTip();
+    if (!pindex) {
+        return -1;
+    }
+    while (pindex->pprev && HasStatus(pindex->pprev->nStatus, BlockStatus::HAVE_DATA)) {
+        pindex = pindex->pprev;
+    }
+    return pindex->nHeight;
+}
+
+size_t ChainStateManager::PrefetchBlockInputs(const Block& block) {
+    if (!m_prefetchPool || !m_activeChainState) {
+        return 0;
+    }
+    
+    CoinsView* coinsDB = m_activeChainState->GetCoinsDB();
+    if (!coinsDB) {
+        return 0;
+    }
+    
+    // Spends of outputs created earlier in the block are not in the database
+    std::unordered_set<TxHash, SaltedHash256Hasher> blockTxids;
+    blockTxids.reserve(block.vtx.size());
+    for (const auto& ptx : block.vtx) {
+        blockTxids.insert(ptx->GetHash());
+    }
+    
+    std::vector<OutPoint> outpoints;
+    for (const auto& ptx : block.vtx) {
+        if (ptx->IsCoinBase()) {
+            continue;
+        }
+        for (const auto& txin : ptx->vin) {
+            if (blockTxids.count(txin.prevout.hash) == 0) {
+                outpoints.push_back(txin.prevout);
+            }
+        }
+    }
+    
+    uint64_t generation = m_activeChainState->FilterCachedCoins(outpoints);
+    if (outpoints.empty()) {
+        return 0;
+    }
+    
+    // Give each worker a contiguous slice to read
+    const size_t nShards = std::min(outpoints.size(), m_prefetchPool->ThreadCount());
+    const size_t shardSize = (outpoints.size() + nShards - 1) / nShards;
+    std::vector<std::vector<std::pair<OutPoint, Coin>>> results(nShards);
+    {
+        util::TaskGroup group(*m_prefetchPool);
+        for (size_t shard = 0; shard < nShards; ++shard) {
+            group.Add([&, shard]() {
+                const size_t begin = shard * shardSize;
+                const size_t end = std::min(begin + shardSize, outpoints.size());
+                for (size_t i = begin; i < end; ++i) {
+                    if (auto coin = coinsDB->GetCoin(outpoints[i])) {
+                        results[shard].emplace_back(outpoints[i], std::move(*coin));
+                    }
+                }
+            });
+        }
+        try {
+            group.Wait();
+        } catch (const std::exception& e) {
+            // Best effort: connection reads whatever is still missing
+            LOG_WARN(util::LogCategory::DEFAULT) << "Coin prefetch failed: " << e.what();
+            return 0;
+        }
+    }
+    
+    std::vector<std::pair<OutPoint, Coin>> coins;
+    coins.reserve(outpoints.size());
+    for (auto& shardCoins : results) {
+        std::move(shardCoins.begin(), shardCoins.end(), std::back_inserter(coins));
+    }
+    
+    size_t nWarmed = m_activeChainState->WarmCoins(std::move(coins), generation);
+    LOG_DEBUG(util::LogCategory::DEFAULT) << "Prefetched " << nWarmed << " of "
+                                           << outpoints.size() << " block inputs";
+    return nWarmed;
 }
 
 } // namespace shurium
@@ -0,0 +1,205 @@
+// SHURIUM - Parallel Script Verification Queue Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/chain/checkqueue.h"
+#include "shurium/util/threadpool.h"
+#include <algorithm>
+#include <thread>
+
+namespace shurium {
+
+int ResolveScriptCheckThreads(int requested) {
+    int nThreads = requested;
+    if (nThreads <= 0) {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        if (cores <= 0) {
+            cores = 1;
+        }
+        nThreads += cores;
+    }
+    return std::clamp(nThreads, 1, MAX_SCRIPTCHECK_THREADS);
+}
+
+// ============================================================================
+// ScriptCheck Implementation
+// ============================================================================
+
+ScriptCheck::ScriptCheck(const Coin& coin, const Transaction& tx,
+                         unsigned int nIn, ScriptFlags flags,
+                         const PrecomputedTransactionData* txdata,
+                         SignatureCache* sigCache, bool storeSigs)
+    : m_scriptPubKey(coin.GetScriptPubKey())
+    , m_amount(coin.GetAmount())
+    , m_tx(&tx)
+    , m_txdata(txdata)
+    , m_nIn(nIn)
+    , m_flags(flags)
+    , m_sigCache(sigCache)
+    , m_storeSigs(storeSigs) {}
+
+bool ScriptCheck::operator()() {
+    if (!m_tx || m_nIn >= m_tx->vin.size()) {
+        m_error = ScriptError::UNKNOWN;
+        return false;
+    }
+
+    m_error = ScriptError::OK;
+    if (m_txdata) {
+        TransactionSignatureChecker checker(m_tx, m_nIn, m_amount, *m_txdata, m_sigCache, m_storeSigs);
+        return VerifyScript(m_tx->GetDecodedScriptSig(m_nIn), m_scriptPubKey,
+                            m_flags, checker, &m_error);
+    }
+    TransactionSignatureChecker checker(m_tx, m_nIn, m_amount, m_sigCache, m_storeSigs);
+    return VerifyScript(m_tx->GetDecodedScriptSig(m_nIn), m_scriptPubKey,
+                        m_flags, checker, &m_error);
+}
+
+// ============================================================================
+// CheckQueue Implementation
+// ============================================================================
+
+CheckQueue::CheckQueue(size_t nWorkers, size_t batchSize)
+    : m_batchSize(std::max<size_t>(batchSize, 1)) {
+    util::ThreadPool::Config config;
+    config.numThreads = std::max<size_t>(nWorkers, 1);
+    config.name = "scriptcheck";
+    m_pool = std::make_unique<util::ThreadPool>(config);
+}
+
+CheckQueue::~CheckQueue() = default;
+
+size_t CheckQueue::GetWorkerCount() const {
+    return m_pool ? m_pool->ThreadCount() : 0;
+}
+
+// ============================================================================
+// CheckQueueControl Implementation
+// ============================================================================
+
+/// Shared between the control and the worker tasks it has submitted
+struct CheckQueueControl::State {
+    std::atomic<bool> failed{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t outstanding{0};
+    ScriptError error{ScriptError::OK};
+
+    /// Run a batch of checks, stopping early once any check has failed
+    void Run(std::vector<ScriptCheck>& checks) {
+        for (auto& check : checks) {
+            if (failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+            if (!check()) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failed.exchange(true)) {
+                    error = check.GetError();
+                }
+                return;
+            }
+        }
+    }
+};
+
+CheckQueueControl::CheckQueueControl(CheckQueue* queue)
+    : m_queue(queue)
+    , m_state(std::make_shared<State>()) {
+    if (m_queue) {
+        m_lock = std::unique_lock<std::mutex>(m_queue->m_controlMutex);
+        m_pending.reserve(m_queue->GetBatchSize());
+    }
+}
+
+CheckQueueControl::~CheckQueueControl() {
+    if (!m_done) {
+        Cancel();
+        Wait();
+    }
+}
+
+void CheckQueueControl::Add(std::vector<ScriptCheck>&& checks) {
+    if (checks.empty()) {
+        return;
+    }
+
+    // Inline mode: verify immediately so a failure stops further work
+    if (!m_queue) {
+        m_state->Run(checks);
+        return;
+    }
+
+    const size_t batchSize = m_queue->GetBatchSize();
+    for (auto& check : checks) {
+        m_pending.push_back(std::move(check));
+        if (m_pending.size() >= batchSize) {
+            Dispatch();
+        }
+    }
+}
+
+void CheckQueueControl::Dispatch() {
+    if (m_pending.empty()) {
+        return;
+    }
+
+    auto batch = std::make_shared<std::vector<ScriptCheck>>(std::move(m_pending));
+    m_pending.clear();
+    m_pending.reserve(m_queue->GetBatchSize());
+
+    if (m_state->failed.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        ++m_state->outstanding;
+    }
+
+    std::shared_ptr<State> state = m_state;
+    bool submitted = m_queue->m_pool->TrySubmit([state, batch]() {
+        state->Run(*batch);
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            --state->outstanding;
+        }
+        state->cv.notify_all();
+    });
+
+    if (!submitted) {
+        // Pool saturated or stopping: verify on this thread instead
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            --m_state->outstanding;
+        }
+        m_state->Run(*batch);
+    }
+}
+
+bool CheckQueueControl::Wait() {
+    if (m_queue) {
+        Dispatch();
+
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        m_state->cv.wait(lock, [this] { return m_state->outstanding == 0; });
+    }
+
+    m_done = true;
+    if (m_lock.owns_lock()) {
+        m_lock.unlock();
+    }
+
+    return !m_state->failed.load();
+}
+
+void CheckQueueControl::Cancel() {
+    m_state->failed.store(true);
+    m_pending.clear();
+}
+
+ScriptError CheckQueueControl::GetError() const {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->error;
+}
+
+} // namespace shurium
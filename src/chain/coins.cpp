@@ -6,6 +6,9 @@
 #include "shurium/crypto/sha256.h"
 #include <algorithm>
 #include <cassert>
+#include <limits>
+#include <map>
+#include <stdexcept>
 
 namespace shurium {
 
@@ -16,12 +19,26 @@ namespace shurium {
 /// Static empty coin for returning references to non-existent coins
 static const Coin coinEmpty;
 
+// ============================================================================
+// Coins Map
+// ============================================================================
+
+CoinsMap MakeCoinsMap() {
+    int node = util::ThreadPlacement::Instance().PreferredNode(COINS_CACHE_THREAD_ROLE);
+    if (node < 0) {
+        return CoinsMap();
+    }
+    auto resource = std::make_shared<CoinsMapAllocator::ResourceType>(
+        CoinsMapAllocator::ResourceType::DEFAULT_CHUNK_SIZE_BYTES, node);
+    return CoinsMap(0, OutPointHasher(), std::equal_to<OutPoint>(), CoinsMapAllocator(resource));
+}
+
 // ============================================================================
 // CoinsViewCache Implementation
 // ============================================================================
 
 CoinsViewCache::CoinsViewCache(CoinsView* baseIn) 
-    : CoinsViewBacked(baseIn) {
+    : CoinsViewBacked(baseIn), cacheCoins(MakeCoinsMap()) {
     if (baseIn) {
         hashBlock = baseIn->GetBestBlock();
     }
@@ -30,11 +47,21 @@ CoinsViewCache::CoinsViewCache(CoinsView* baseIn)
 CoinsMap::iterator CoinsViewCache::FetchCoin(const OutPoint& outpoint) const {
     auto it = cacheCoins.find(outpoint);
     if (it != cacheCoins.end()) {
+        it->second.epoch = currentEpoch;
         return it;
     }
     
-    // Not in cache, try to fetch from parent
-    auto coinOpt = base ? base->GetCoin(outpoint) : std::nullopt;
+    // An in-flight flush holds changes the parent may not have yet
+    std::optional<Coin> coinOpt;
+    if (const CoinsCacheEntry* entry = FindFlushing(outpoint)) {
+        if (entry->coin.IsSpent()) {
+            return cacheCoins.end();
+        }
+        coinOpt = entry->coin;
+    } else if (base) {
+        // Not in cache, try to fetch from parent
+        coinOpt = base->GetCoin(outpoint);
+    }
     if (!coinOpt) {
         return cacheCoins.end();
     }
@@ -45,6 +72,7 @@ CoinsMap::iterator CoinsViewCache::FetchCoin(const OutPoint& outpoint) const {
         CoinsCacheEntry(std::move(*coinOpt))
     );
     
+    insertIt->second.epoch = currentEpoch;
     if (inserted && !insertIt->second.coin.IsSpent()) {
         cachedCoinsUsage += insertIt->second.coin.DynamicMemoryUsage();
     }
@@ -67,7 +95,33 @@ bool CoinsViewCache::HaveCoin(const OutPoint& outpoint) const {
 
 bool CoinsViewCache::HaveCoinInCache(const OutPoint& outpoint) const {
     auto it = cacheCoins.find(outpoint);
-    return it != cacheCoins.end() && !it->second.coin.IsSpent();
+    if (it != cacheCoins.end()) {
+        return !it->second.coin.IsSpent();
+    }
+    const CoinsCacheEntry* entry = FindFlushing(outpoint);
+    return entry && !entry->coin.IsSpent();
+}
+
+const CoinsCacheEntry* CoinsViewCache::FindFlushing(const OutPoint& outpoint) const {
+    if (!flushing) {
+        return nullptr;
+    }
+    auto it = flushing->coins.find(outpoint);
+    return it != flushing->coins.end() ? &it->second : nullptr;
+}
+
+bool CoinsViewCache::WarmCoin(const OutPoint& outpoint, Coin&& coin) {
+    // The parent may still hold a stale version of anything being flushed
+    if (coin.IsSpent() || FindFlushing(outpoint)) {
+        return false;
+    }
+    
+    auto [it, inserted] = cacheCoins.emplace(outpoint, CoinsCacheEntry(std::move(coin)));
+    if (inserted) {
+        it->second.epoch = currentEpoch;
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+    return inserted;
 }
 
 BlockHash CoinsViewCache::GetBestBlock() const {
@@ -79,12 +133,89 @@ BlockHash CoinsViewCache::GetBestBlock() const {
 
 void CoinsViewCache::SetBestBlock(const BlockHash& block) {
     hashBlock = block;
+    ++currentEpoch;
 }
 
 size_t CoinsViewCache::EstimateSize() const {
     return cacheCoins.size();
 }
 
+size_t CoinsViewCache::GetCacheUsage() const {
+    size_t usage = CoinsMapMemoryUsage(cacheCoins) + cachedCoinsUsage;
+    if (flushing) {
+        usage += CoinsMapMemoryUsage(flushing->coins) + flushing->coinsUsage;
+    }
+    return usage;
+}
+
+bool CoinsViewCache::GetUTXOHashState(MuHash3072& state) const {
+    if (!base || !base->GetUTXOHashState(state)) {
+        return false;
+    }
+    if (flushing) {
+        state *= flushing->hashDelta;
+    }
+    state *= hashDelta;
+    return true;
+}
+
+Hash256 CoinsViewCache::GetRollingUTXOSetHash() const {
+    MuHash3072 state;
+    if (!GetUTXOHashState(state)) {
+        return Hash256();
+    }
+    return state.Finalize();
+}
+
+bool CoinsViewCache::BatchWrite(const CoinsMap& mapCoins, const BlockHash& hashBlockIn,
+                                const MuHash3072& hashDeltaIn) {
+    for (const auto& [outpoint, entry] : mapCoins) {
+        if (!entry.IsDirty()) {
+            continue;
+        }
+        
+        auto it = cacheCoins.find(outpoint);
+        if (it == cacheCoins.end()) {
+            // Created and spent in the child without ever reaching us
+            if (entry.IsFresh() && entry.coin.IsSpent()) {
+                continue;
+            }
+            
+            auto [newIt, inserted] = cacheCoins.emplace(outpoint, CoinsCacheEntry(entry.coin));
+            newIt->second.epoch = currentEpoch;
+            newIt->second.SetDirty();
+            if (entry.IsFresh()) {
+                newIt->second.SetFresh();
+            }
+            if (!newIt->second.coin.IsSpent()) {
+                cachedCoinsUsage += newIt->second.coin.DynamicMemoryUsage();
+            }
+            continue;
+        }
+        
+        if (entry.IsFresh() && !it->second.coin.IsSpent()) {
+            throw std::logic_error("FRESH flag set on a coin that exists in the parent cache");
+        }
+        
+        cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+        if (it->second.IsFresh() && entry.coin.IsSpent()) {
+            // Our parent never saw this coin, so the spend needs no write
+            cacheCoins.erase(it);
+        } else {
+            it->second.coin = entry.coin;
+            it->second.epoch = currentEpoch;
+            it->second.SetDirty();
+            cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+        }
+    }
+    
+    if (!hashBlockIn.IsNull()) {
+        SetBestBlock(hashBlockIn);
+    }
+    hashDelta *= hashDeltaIn;
+    return true;
+}
+
 const Coin& CoinsViewCache::AccessCoin(const OutPoint& outpoint) const {
     auto it = FetchCoin(outpoint);
     if (it == cacheCoins.end()) {
@@ -107,15 +238,22 @@ void CoinsViewCache::AddCoin(const OutPoint& outpoint, Coin&& coin, bool possibl
             // Should not happen - overwriting an existing unspent coin
             throw std::logic_error("Overwriting existing unspent coin");
         }
+        if (!it->second.coin.IsSpent()) {
+            RemoveCoinFromHash(hashDelta, outpoint, it->second.coin);
+        }
         
         // If the existing entry is fresh, the new one is also fresh
         fresh = it->second.IsFresh();
     } else {
-        // New entry - it's fresh if we're adding a new coin
-        fresh = true;
+        // New entry - it's fresh unless an in-flight flush is about to
+        // write an unspent coin at this outpoint to the parent
+        const CoinsCacheEntry* flushingEntry = FindFlushing(outpoint);
+        fresh = !flushingEntry || flushingEntry->coin.IsSpent();
     }
     
+    AddCoinToHash(hashDelta, outpoint, coin);
     it->second.coin = std::move(coin);
+    it->second.epoch = currentEpoch;
     it->second.SetDirty();
     if (fresh) {
         it->second.SetFresh();
@@ -131,6 +269,7 @@ bool CoinsViewCache::SpendCoin(const OutPoint& outpoint, Coin* moveTo) {
     }
     
     cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+    RemoveCoinFromHash(hashDelta, outpoint, it->second.coin);
     
     if (moveTo) {
         *moveTo = std::move(it->second.coin);
@@ -149,30 +288,147 @@ bool CoinsViewCache::SpendCoin(const OutPoint& outpoint, Coin* moveTo) {
 }
 
 bool CoinsViewCache::Flush() {
-    // For now, we just clear the cache
-    // In production, this would write to the backing storage
-    bool success = true;
+    auto snapshot = BeginFlush();
+    if (!snapshot) {
+        return false;
+    }
+    
+    bool written = base && base->BatchWrite(snapshot->coins, snapshot->bestBlock,
+                                            snapshot->hashDelta);
+    EndFlush(written);
+    return written;
+}
+
+std::shared_ptr<const CoinsViewCache::FlushSnapshot> CoinsViewCache::BeginFlush() {
+    if (flushing) {
+        return nullptr;
+    }
+    
+    auto snapshot = std::make_shared<FlushSnapshot>();
+    snapshot->bestBlock = GetBestBlock();
+    snapshot->hashDelta = hashDelta;
+    hashDelta = MuHash3072();
     
-    // Clear all non-dirty entries and reset dirty flags
+    // Clean entries match the parent and stay behind in the overlay
     for (auto it = cacheCoins.begin(); it != cacheCoins.end(); ) {
-        if (it->second.IsDirty()) {
-            // In production: write to backing store
-            it->second.ClearFlags();
-            if (it->second.coin.IsSpent()) {
-                // Remove spent entries
-                it = cacheCoins.erase(it);
+        if (!it->second.IsDirty()) {
+            ++it;
+            continue;
+        }
+        
+        if (!(it->second.IsFresh() && it->second.coin.IsSpent())) {
+            size_t usage = it->second.coin.DynamicMemoryUsage();
+            cachedCoinsUsage -= usage;
+            snapshot->coinsUsage += usage;
+            snapshot->coins.emplace(it->first, std::move(it->second));
+        }
+        it = cacheCoins.erase(it);
+    }
+    
+    flushing = snapshot;
+    ++flushGeneration;
+    return snapshot;
+}
+
+void CoinsViewCache::EndFlush(bool written, bool fRetain) {
+    if (!flushing) {
+        return;
+    }
+    
+    std::shared_ptr<const FlushSnapshot> snapshot = std::move(flushing);
+    flushing.reset();
+    ++flushGeneration;
+    
+    if (written) {
+        if (!fRetain) {
+            return;
+        }
+        
+        // The parent now matches these coins, so they come back clean;
+        // anything the overlay touched since is newer and wins
+        for (const auto& [outpoint, entry] : snapshot->coins) {
+            if (entry.coin.IsSpent()) {
                 continue;
             }
+            auto [it, inserted] = cacheCoins.try_emplace(outpoint, entry.coin);
+            if (inserted) {
+                it->second.epoch = entry.epoch;
+                cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+            }
         }
-        ++it;
+        return;
     }
     
-    return success;
+    // The parent never saw these changes; put them back as dirty
+    hashDelta *= snapshot->hashDelta;
+    for (const auto& [outpoint, entry] : snapshot->coins) {
+        auto [it, inserted] = cacheCoins.try_emplace(outpoint, entry);
+        if (inserted) {
+            cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+        } else {
+            // The overlay entry is newer, but it can no longer be FRESH
+            it->second.ClearFlags();
+            it->second.SetDirty();
+        }
+    }
+}
+
+size_t CoinsViewCache::Trim(size_t targetUsage) {
+    if (flushing || GetCacheUsage() <= targetUsage) {
+        return 0;
+    }
+    
+    // Estimated bytes of the clean entries last used in each epoch
+    auto entryBytes = [](const CoinsCacheEntry& entry) {
+        return COINS_MAP_POOL_BLOCK_SIZE + entry.coin.DynamicMemoryUsage();
+    };
+    std::map<uint32_t, size_t> cleanBytes;
+    size_t keptBytes = 0;
+    for (const auto& [outpoint, entry] : cacheCoins) {
+        if (entry.IsDirty()) {
+            keptBytes += entryBytes(entry);
+        } else {
+            cleanBytes[entry.epoch] += entryBytes(entry);
+        }
+    }
+    
+    // Keep whole epochs, newest first, while they fit
+    uint32_t cutoff = std::numeric_limits<uint32_t>::max();
+    bool fKeepNone = true;
+    for (auto it = cleanBytes.rbegin(); it != cleanBytes.rend(); ++it) {
+        if (keptBytes + it->second > targetUsage) {
+            break;
+        }
+        keptBytes += it->second;
+        cutoff = it->first;
+        fKeepNone = false;
+    }
+    
+    CoinsMap kept = MakeCoinsMap();
+    size_t keptCoinsUsage = 0;
+    size_t nDropped = 0;
+    for (auto& [outpoint, entry] : cacheCoins) {
+        if (!entry.IsDirty() && (fKeepNone || entry.epoch < cutoff)) {
+            ++nDropped;
+            continue;
+        }
+        keptCoinsUsage += entry.coin.DynamicMemoryUsage();
+        kept.emplace(outpoint, std::move(entry));
+    }
+    
+    // Moving in the new map releases the old pool's chunks
+    cacheCoins = std::move(kept);
+    cachedCoinsUsage = keptCoinsUsage;
+    return nDropped;
 }
 
 void CoinsViewCache::Reset() {
-    cacheCoins.clear();
+    // Swap in a fresh map so the old pool's chunks go back to the system
+    cacheCoins = MakeCoinsMap();
     cachedCoinsUsage = 0;
+    hashDelta = MuHash3072();
+    flushing.reset();
+    ++flushGeneration;
     if (base) {
         hashBlock = base->GetBestBlock();
     } else {
@@ -259,6 +515,7 @@ Amount CoinsViewCache::GetValueIn(const Transaction& tx) const {
 // ============================================================================
 
 std::optional<Coin> CoinsViewMemory::GetCoin(const OutPoint& outpoint) const {
+    std::lock_guard<std::mutex> lock(cs);
     auto it = coins.find(outpoint);
     if (it == coins.end() || it->second.coin.IsSpent()) {
         return std::nullopt;
@@ -267,44 +524,102 @@ std::optional<Coin> CoinsViewMemory::GetCoin(const OutPoint& outpoint) const {
 }
 
 bool CoinsViewMemory::HaveCoin(const OutPoint& outpoint) const {
+    std::lock_guard<std::mutex> lock(cs);
     auto it = coins.find(outpoint);
     return it != coins.end() && !it->second.coin.IsSpent();
 }
 
 BlockHash CoinsViewMemory::GetBestBlock() const {
+    std::lock_guard<std::mutex> lock(cs);
     return bestBlock;
 }
 
 size_t CoinsViewMemory::EstimateSize() const {
+    std::lock_guard<std::mutex> lock(cs);
     return coins.size();
 }
 
 void CoinsViewMemory::AddCoin(const OutPoint& outpoint, const Coin& coin) {
-    coins[outpoint] = CoinsCacheEntry(coin);
+    std::lock_guard<std::mutex> lock(cs);
+    auto [it, inserted] = coins.try_emplace(outpoint);
+    if (!inserted) {
+        RemoveCoinFromHash(muhash, outpoint, it->second.coin);
+    }
+    AddCoinToHash(muhash, outpoint, coin);
+    it->second = CoinsCacheEntry(coin);
 }
 
 void CoinsViewMemory::RemoveCoin(const OutPoint& outpoint) {
-    coins.erase(outpoint);
+    std::lock_guard<std::mutex> lock(cs);
+    auto it = coins.find(outpoint);
+    if (it != coins.end()) {
+        RemoveCoinFromHash(muhash, outpoint, it->second.coin);
+        coins.erase(it);
+    }
 }
 
 void CoinsViewMemory::SetBestBlock(const BlockHash& block) {
+    std::lock_guard<std::mutex> lock(cs);
     bestBlock = block;
 }
 
 void CoinsViewMemory::Clear() {
+    std::lock_guard<std::mutex> lock(cs);
     coins.clear();
     bestBlock.SetNull();
+    muhash = MuHash3072();
 }
 
-void CoinsViewMemory::BatchWrite(CoinsMap& mapCoins, const BlockHash& block) {
-    for (auto& [outpoint, entry] : mapCoins) {
+bool CoinsViewMemory::BatchWrite(const CoinsMap& mapCoins, const BlockHash& block,
+                                 const MuHash3072& hashDelta) {
+    std::lock_guard<std::mutex> lock(cs);
+    for (const auto& [outpoint, entry] : mapCoins) {
+        if (!entry.IsDirty()) {
+            continue;
+        }
         if (entry.coin.IsSpent()) {
             coins.erase(outpoint);
         } else {
-            coins[outpoint] = std::move(entry);
+            coins[outpoint] = CoinsCacheEntry(entry.coin);
         }
     }
-    bestBlock = block;
+    if (!block.IsNull()) {
+        bestBlock = block;
+    }
+    muhash *= hashDelta;
+    return true;
+}
+
+bool CoinsViewMemory::GetUTXOHashState(MuHash3072& state) const {
+    std::lock_guard<std::mutex> lock(cs);
+    state = muhash;
+    return true;
+}
+
+// ============================================================================
+// Rolling UTXO Set Hash
+// ============================================================================
+
+namespace {
+
+/// Serialize the hash element for a coin
+DataStream CoinHashElement(const OutPoint& outpoint, const Coin& coin) {
+    DataStream ss;
+    Serialize(ss, outpoint);
+    Serialize(ss, coin);
+    return ss;
+}
+
+} // namespace
+
+void AddCoinToHash(MuHash3072& hash, const OutPoint& outpoint, const Coin& coin) {
+    DataStream ss = CoinHashElement(outpoint, coin);
+    hash.Insert(ss.data(), ss.size());
+}
+
+void RemoveCoinFromHash(MuHash3072& hash, const OutPoint& outpoint, const Coin& coin) {
+    DataStream ss = CoinHashElement(outpoint, coin);
+    hash.Remove(ss.data(), ss.size());
 }
 
 // ============================================================================
@@ -0,0 +1,395 @@
+// SHURIUM - Block File Reindexing Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/chain/reindex.h"
+#include "shurium/chain/chainstate.h"
+#include "shurium/consensus/validation.h"
+#include "shurium/core/serialize.h"
+#include "shurium/util/fs.h"
+#include "shurium/util/logging.h"
+#include "shurium/util/threadpool.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace shurium {
+
+// ============================================================================
+// ReindexStats
+// ============================================================================
+
+std::string ReindexStats::ToString() const {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1)
+       << "file " << nCurrentFile + 1 << "/" << nFiles
+       << ", " << Progress() * 100.0 << "% read"
+       << ", " << nBlocksProcessed << " blocks"
+       << " (" << BlocksPerSecond() << " blk/s, " << MiBPerSecond() << " MiB/s)"
+       << ", queues check=" << nCheckQueueDepth
+       << " feed=" << nFeedQueueDepth
+       << " waiting=" << nOutOfOrderDepth;
+    if (nBlocksInvalid > 0) {
+        ss << ", invalid=" << nBlocksInvalid;
+    }
+    return ss.str();
+}
+
+// ============================================================================
+// BlockReindexer
+// ============================================================================
+
+BlockReindexer::BlockReindexer(ChainStateManager& chainman, db::BlockDB& blockDB,
+                               const ReindexOptions& options)
+    : m_chainman(chainman)
+    , m_blockDB(blockDB)
+    , m_options(options)
+    , m_start(std::chrono::steady_clock::now()) {
+    m_options.readBufferSize = std::max<size_t>(m_options.readBufferSize,
+                                                db::BLOCK_RECORD_HEADER_SIZE);
+    m_options.maxInFlight = std::max<size_t>(m_options.maxInFlight, 1);
+}
+
+BlockReindexer::~BlockReindexer() = default;
+
+void BlockReindexer::Interrupt() {
+    m_interrupt = true;
+    m_cvFed.notify_all();
+    m_cvChecked.notify_all();
+}
+
+ReindexStats BlockReindexer::GetStats() const {
+    ReindexStats stats;
+    stats.nFiles = m_nFiles;
+    stats.nTotalBytes = m_nTotalBytes;
+    stats.nCurrentFile = m_nCurrentFile;
+    stats.nBytesRead = m_nBytesRead;
+    stats.nBlocksChecked = m_nBlocksChecked;
+    stats.nBlocksProcessed = m_nBlocksProcessed;
+    stats.nBlocksInvalid = m_nBlocksInvalid;
+    stats.nBlocksOrphaned = m_nBlocksOrphaned;
+    stats.nOutOfOrderDepth = m_nOutOfOrder;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.nBlocksRead = m_nSubmitted;
+    stats.nFeedQueueDepth = m_checked.size();
+    stats.nCheckQueueDepth = static_cast<size_t>(m_nSubmitted - m_nFed) - m_checked.size();
+    stats.elapsedSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - m_start).count();
+    return stats;
+}
+
+bool BlockReindexer::Run() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    // Sizes come from the files, not from metadata that may be gone
+    const int nFiles = m_blockDB.RescanBlockFiles();
+    uint64_t nTotalBytes = 0;
+    for (int i = 0; i < nFiles; ++i) {
+        nTotalBytes += m_blockDB.GetBlockFileInfo()[i].nSize;
+    }
+    m_nFiles = nFiles;
+    m_nTotalBytes = nTotalBytes;
+
+    int nThreads = m_options.nCheckThreads;
+    if (nThreads <= 0) {
+        nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    LOG_INFO(util::LogCategory::DEFAULT) << "Reindexing " << nFiles << " block file(s), "
+                                         << nTotalBytes / (1024 * 1024) << " MiB, with "
+                                         << nThreads << " check thread(s)";
+
+    util::ThreadPool::Config config;
+    config.numThreads = static_cast<size_t>(nThreads);
+    config.maxQueueSize = m_options.maxInFlight;
+    config.name = "reindex";
+    util::ThreadPool pool(config);
+
+    std::thread reader([this, &pool]() { ReadBlockFiles(pool); });
+
+    // Stage 3: feed checked blocks in the order they were read
+    auto lastLog = std::chrono::steady_clock::now();
+    uint64_t nextSeq = 0;
+    while (true) {
+        std::shared_ptr<PendingBlock> pending;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvChecked.wait_for(lock, std::chrono::seconds(1), [&]() {
+                return m_interrupt || m_checked.count(nextSeq) ||
+                       (m_readerDone && nextSeq == m_nSubmitted);
+            });
+            if (m_interrupt) {
+                break;
+            }
+
+            auto it = m_checked.find(nextSeq);
+            if (it != m_checked.end()) {
+                pending = std::move(it->second);
+                m_checked.erase(it);
+                ++nextSeq;
+                ++m_nFed;
+            } else if (m_readerDone && nextSeq == m_nSubmitted) {
+                break;
+            }
+        }
+
+        if (pending) {
+            m_cvFed.notify_one();
+            FeedBlock(*pending);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastLog >= std::chrono::seconds(REINDEX_PROGRESS_INTERVAL)) {
+            lastLog = now;
+            LOG_INFO(util::LogCategory::DEFAULT) << "Reindex: " << GetStats().ToString();
+        }
+    }
+
+    reader.join();
+    pool.Wait();
+
+    // Whatever is still waiting never had its parent in the block files
+    size_t nOrphaned = 0;
+    for (const auto& [parent, positions] : m_outOfOrder) {
+        nOrphaned += positions.size();
+    }
+    m_outOfOrder.clear();
+    m_nOutOfOrder = 0;
+    m_nBlocksOrphaned += nOrphaned;
+    if (nOrphaned > 0) {
+        LOG_WARN(util::LogCategory::DEFAULT) << "Reindex: " << nOrphaned
+                                             << " block(s) without a parent were skipped";
+    }
+
+    ReindexStats stats = GetStats();
+    if (m_interrupt) {
+        LOG_INFO(util::LogCategory::DEFAULT) << "Reindex interrupted: " << stats.ToString();
+        return false;
+    }
+
+    LOG_INFO(util::LogCategory::DEFAULT) << "Reindex finished: " << stats.ToString();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_readFailed;
+}
+
+// ============================================================================
+// Stage 1: Sequential Reads
+// ============================================================================
+
+void BlockReindexer::ReadBlockFiles(util::ThreadPool& pool) {
+    auto submit = [this, &pool](std::shared_ptr<PendingBlock> pending) {
+        uint64_t seq;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cvFed.wait(lock, [&]() {
+                return m_interrupt || m_nSubmitted - m_nFed < m_options.maxInFlight;
+            });
+            if (m_interrupt) {
+                return false;
+            }
+            seq = m_nSubmitted++;
+        }
+        pool.Execute([this, seq, pending]() {
+            CheckRecord(*pending);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_checked.emplace(seq, pending);
+            }
+            m_cvChecked.notify_one();
+        });
+        return true;
+    };
+
+    std::vector<uint8_t> buffer(m_options.readBufferSize);
+
+    for (int nFile = 0; nFile < m_nFiles && !m_interrupt; ++nFile) {
+        m_nCurrentFile = nFile;
+
+        util::fs::SequentialFile file(m_blockDB.GetBlockFilePath(nFile).string());
+        if (!file.IsOpen()) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Reindex: cannot open block file " << nFile;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_readFailed = true;
+            break;
+        }
+        file.WillNeed(0, buffer.size());
+
+        // buffer[0, len) holds the file bytes starting at bufferOffset
+        uint64_t bufferOffset = 0;
+        size_t len = 0;
+        size_t cursor = 0;
+        bool eof = false;
+
+        while (!m_interrupt) {
+            // Split off every complete record in the buffer
+            size_t needed = db::BLOCK_RECORD_HEADER_SIZE;
+            while (len - cursor >= db::BLOCK_RECORD_HEADER_SIZE) {
+                uint32_t nMagic = 0;
+                uint32_t nSize = 0;
+                std::memcpy(&nMagic, buffer.data() + cursor, 4);
+                std::memcpy(&nSize, buffer.data() + cursor + 4, 4);
+                if (nMagic != db::BLOCK_RECORD_MAGIC || nSize == 0 ||
+                    nSize > db::MAX_BLOCK_RECORD_SIZE) {
+                    // Not a record start (torn write or padding): resync
+                    ++cursor;
+                    continue;
+                }
+
+                const size_t recordSize = db::BLOCK_RECORD_HEADER_SIZE + nSize;
+                if (len - cursor < recordSize) {
+                    needed = recordSize;
+                    break;
+                }
+
+                auto pending = std::make_shared<PendingBlock>();
+                pending->pos = db::DiskBlockPos(nFile, static_cast<uint32_t>(bufferOffset + cursor));
+                const uint8_t* payload = buffer.data() + cursor + db::BLOCK_RECORD_HEADER_SIZE;
+                pending->data.assign(payload, payload + nSize);
+                cursor += recordSize;
+
+                if (!submit(std::move(pending))) {
+                    return;
+                }
+            }
+
+            if (eof) {
+                break;
+            }
+
+            // Keep the partial record and refill behind it
+            std::memmove(buffer.data(), buffer.data() + cursor, len - cursor);
+            bufferOffset += cursor;
+            len -= cursor;
+            cursor = 0;
+            if (buffer.size() < needed) {
+                buffer.resize(needed);
+            }
+
+            size_t n = file.Read(buffer.data() + len, buffer.size() - len);
+            m_nBytesRead += n;
+            len += n;
+            eof = (n == 0);
+
+            // Let the kernel fetch the next buffer while this one is split
+            file.WillNeed(file.Tell(), buffer.size());
+        }
+
+        if (len > cursor && !m_interrupt) {
+            LOG_DEBUG(util::LogCategory::DEFAULT) << "Reindex: ignoring " << len - cursor
+                                                  << " trailing byte(s) in block file " << nFile;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readerDone = true;
+    }
+    m_cvChecked.notify_all();
+}
+
+// ============================================================================
+// Stage 2: Deserialize and Check
+// ============================================================================
+
+void BlockReindexer::CheckRecord(PendingBlock& pending) {
+    Block block;
+    try {
+        SpanReader ss(pending.data.data(), pending.data.size());
+        UnserializeWithArena(ss, block);
+    } catch (const std::exception& e) {
+        LOG_DEBUG(util::LogCategory::DEFAULT) << "Reindex: undecodable block at "
+                                              << pending.pos.ToString() << ": " << e.what();
+        ++m_nBlocksInvalid;
+        std::vector<uint8_t>().swap(pending.data);
+        return;
+    }
+    std::vector<uint8_t>().swap(pending.data);
+
+    consensus::ValidationState state;
+    if (!consensus::CheckBlock(block, state, m_chainman.GetParams())) {
+        LOG_DEBUG(util::LogCategory::DEFAULT) << "Reindex: invalid block at "
+                                              << pending.pos.ToString() << ": "
+                                              << state.GetRejectReason();
+        ++m_nBlocksInvalid;
+        return;
+    }
+
+    pending.hash = block.GetHash();
+    pending.block = std::move(block);
+    ++m_nBlocksChecked;
+}
+
+// ============================================================================
+// Stage 3: In-Order Feed
+// ============================================================================
+
+void BlockReindexer::FeedBlock(PendingBlock& pending) {
+    if (!pending.block) {
+        return;  // Rejected by the check stage
+    }
+    const Block& block = *pending.block;
+
+    if (block.hashPrevBlock.IsNull()) {
+        if (pending.hash != m_chainman.GetParams().hashGenesisBlock) {
+            LOG_DEBUG(util::LogCategory::DEFAULT) << "Reindex: skipping foreign genesis block "
+                                                  << pending.hash.ToHex();
+            ++m_nBlocksInvalid;
+            return;
+        }
+    } else if (!m_chainman.LookupBlockIndex(block.hashPrevBlock)) {
+        // Parent is later in the files; the block is re-read once it's in
+        m_outOfOrder[block.hashPrevBlock].push_back(pending.pos);
+        ++m_nOutOfOrder;
+        return;
+    }
+
+    ProcessBlock(block, pending.hash, pending.pos, true);
+    pending.block.reset();
+    FeedChildren(pending.hash);
+}
+
+void BlockReindexer::FeedChildren(const BlockHash& parent) {
+    std::vector<BlockHash> parents{parent};
+    while (!parents.empty() && !m_interrupt) {
+        auto it = m_outOfOrder.find(parents.back());
+        parents.pop_back();
+        if (it == m_outOfOrder.end()) {
+            continue;
+        }
+
+        std::vector<db::DiskBlockPos> positions = std::move(it->second);
+        m_outOfOrder.erase(it);
+        m_nOutOfOrder -= positions.size();
+
+        for (const auto& pos : positions) {
+            Block child;
+            db::Status s = m_blockDB.ReadBlock(pos, child);
+            if (!s.ok()) {
+                LOG_ERROR(util::LogCategory::DEFAULT) << "Reindex: failed to re-read block at "
+                                                      << pos.ToString() << ": " << s.ToString();
+                ++m_nBlocksInvalid;
+                continue;
+            }
+            BlockHash hash = child.GetHash();
+            ProcessBlock(child, hash, pos, true);
+            parents.push_back(hash);
+        }
+    }
+}
+
+void BlockReindexer::ProcessBlock(const Block& block, const BlockHash& hash,
+                                  const db::DiskBlockPos& pos, bool fChecked) {
+    if (!m_chainman.ProcessStoredBlock(block, pos, fChecked)) {
+        LOG_DEBUG(util::LogCategory::DEFAULT) << "Reindex: block " << hash.ToHex()
+                                              << " at " << pos.ToString() << " not accepted";
+    }
+    ++m_nBlocksProcessed;
+}
+
+} // namespace shurium
@@ -0,0 +1,286 @@
+// SHURIUM - Background Transaction Indexer Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/chain/txindexer.h"
+#include "shurium/chain/chainstate.h"
+#include "shurium/util/logging.h"
+#include "shurium/util/threadpool.h"
+#include <algorithm>
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace shurium {
+
+using TxEntries = std::vector<std::pair<TxHash, db::TxIndexEntry>>;
+
+// ============================================================================
+// TxIndexer
+// ============================================================================
+
+TxIndexer::TxIndexer(ChainStateManager& chainman, db::BlockDB& blockDB, db::TxIndex& txIndex,
+                     const TxIndexerOptions& options)
+    : m_chainman(chainman), m_blockDB(blockDB), m_txIndex(txIndex), m_options(options) {
+    m_options.batchBlocks = std::max<size_t>(m_options.batchBlocks, 1);
+}
+
+TxIndexer::~TxIndexer() {
+    Stop();
+}
+
+bool TxIndexer::Start() {
+    if (!m_txIndex.IsEnabled() || m_thread.joinable()) {
+        return false;
+    }
+
+    // Resume from the newest locator entry we still know about
+    const BlockIndex* pbest = nullptr;
+    if (auto locator = m_txIndex.GetBestLocator()) {
+        for (const BlockHash& hash : locator->vHave) {
+            if ((pbest = m_chainman.LookupBlockIndex(hash))) {
+                break;
+            }
+        }
+        if (!pbest && !locator->IsNull()) {
+            LOG_WARN(util::LogCategory::DEFAULT)
+                << "txindex: stored best block is unknown, rebuilding from genesis";
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_best = pbest;
+        m_synced = false;
+        m_failed = false;
+        m_stop = false;
+    }
+
+    int nThreads = m_options.nThreads;
+    if (nThreads <= 0) {
+        nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    util::ThreadPool::Config config;
+    config.numThreads = static_cast<size_t>(nThreads);
+    config.maxQueueSize = m_options.batchBlocks;
+    config.name = "txindex";
+    m_pool = std::make_unique<util::ThreadPool>(config);
+
+    m_callbackId = m_chainman.RegisterBlockConnected(
+        [this](const Block& block, const BlockIndex* pindex) { BlockConnected(block, pindex); });
+
+    LOG_INFO(util::LogCategory::DEFAULT) << "txindex: syncing from height "
+                                         << (pbest ? pbest->nHeight + 1 : 0) << " with "
+                                         << nThreads << " thread(s)";
+    m_thread = std::thread([this]() { ThreadSync(); });
+    return true;
+}
+
+void TxIndexer::Stop() {
+    // Unregister first: it waits for a running notification to finish
+    if (m_callbackId >= 0) {
+        m_chainman.UnregisterBlockConnected(m_callbackId);
+        m_callbackId = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_pool.reset();
+}
+
+const BlockIndex* TxIndexer::GetBestBlock() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_best;
+}
+
+int TxIndexer::GetBestHeight() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_best ? m_best->nHeight : -1;
+}
+
+bool TxIndexer::WaitForSync(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait_for(lock, timeout, [this]() { return m_synced || m_stop || m_failed; });
+    return m_synced;
+}
+
+bool TxIndexer::FindTx(const TxHash& txid, TransactionRef& tx, BlockHash& hashBlock) const {
+    auto entry = m_txIndex.GetTx(txid);
+    if (!entry) {
+        return false;
+    }
+
+    Block block;
+    if (!m_blockDB.ReadBlock(entry->blockPos, block).ok()) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "txindex: cannot read block for " << txid.ToHex();
+        return false;
+    }
+    for (const auto& blockTx : block.vtx) {
+        if (blockTx->GetHash() == txid) {
+            tx = blockTx;
+            hashBlock = block.GetHash();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TxIndexer::ThreadSync() {
+    auto lastLog = std::chrono::steady_clock::now();
+    while (!m_stop) {
+        size_t nIndexed = SyncBatch();
+        if (m_failed) {
+            break;
+        }
+        if (nIndexed > 0) {
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastLog >= std::chrono::seconds(TXINDEX_PROGRESS_INTERVAL)) {
+                lastLog = now;
+                LOG_INFO(util::LogCategory::DEFAULT) << "txindex: indexed up to height "
+                                                     << GetBestHeight();
+            }
+            continue;
+        }
+
+        // At the tip: notifications take over until one does not fit
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_wakeup) {
+            m_wakeup = false;
+            continue;
+        }
+        if (!m_synced) {
+            m_synced = true;
+            LOG_INFO(util::LogCategory::DEFAULT) << "txindex: synced at height "
+                                                 << (m_best ? m_best->nHeight : -1);
+            m_cv.notify_all();
+        }
+        m_cv.wait(lock, [this]() { return m_stop || m_wakeup; });
+        m_wakeup = false;
+    }
+    m_cv.notify_all();
+}
+
+size_t TxIndexer::SyncBatch() {
+    const ChainState& chainstate = m_chainman.GetActiveChainState();
+    const BlockIndex* pbest = GetBestBlock();
+
+    BlockIndex* pnext = chainstate.FindNextBlock(pbest);
+    if (!pnext) {
+        return 0;
+    }
+    if (pnext->pprev != pbest) {
+        if (!Rewind(pnext->pprev)) {
+            return 0;
+        }
+    }
+
+    std::vector<const BlockIndex*> batch{pnext};
+    while (batch.size() < m_options.batchBlocks && !m_stop) {
+        BlockIndex* p = chainstate.FindNextBlock(batch.back());
+        if (!p || p->pprev != batch.back()) {
+            break;
+        }
+        batch.push_back(p);
+    }
+
+    // Read the blocks and compute their entries in parallel
+    std::vector<std::future<std::optional<TxEntries>>> results;
+    results.reserve(batch.size());
+    for (const BlockIndex* pindex : batch) {
+        if (!pindex->HaveData()) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "txindex: no block data at height "
+                                                  << pindex->nHeight << " (pruned?), stopping";
+            m_failed = true;
+            return 0;
+        }
+        results.push_back(m_pool->Submit([this, pindex]() -> std::optional<TxEntries> {
+            db::DiskBlockPos pos(pindex->nFile, pindex->nDataPos);
+            Block block;
+            if (!m_blockDB.ReadBlock(pos, block).ok() ||
+                block.GetHash() != pindex->GetBlockHash()) {
+                return std::nullopt;
+            }
+            return db::TxIndex::GetBlockEntries(block, pos);
+        }));
+    }
+
+    TxEntries entries;
+    for (size_t i = 0; i < results.size(); ++i) {
+        std::optional<TxEntries> blockEntries = results[i].get();
+        if (!blockEntries) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "txindex: failed to read block at height "
+                                                  << batch[i]->nHeight << ", stopping";
+            m_failed = true;
+            return 0;
+        }
+        entries.insert(entries.end(), std::make_move_iterator(blockEntries->begin()),
+                       std::make_move_iterator(blockEntries->end()));
+    }
+
+    db::Status status = m_txIndex.WriteEntries(entries, GetLocator(batch.back()));
+    if (!status.ok()) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "txindex: write failed: " << status.ToString();
+        m_failed = true;
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_best = batch.back();
+    return batch.size();
+}
+
+bool TxIndexer::Rewind(const BlockIndex* pfork) {
+    const BlockIndex* pindex = GetBestBlock();
+    for (; pindex && pindex != pfork; pindex = pindex->pprev) {
+        Block block;
+        if (!pindex->HaveData() ||
+            !m_blockDB.ReadBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), block).ok() ||
+            !m_txIndex.UnindexBlock(block).ok()) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "txindex: cannot unindex block at height "
+                                                  << pindex->nHeight << ", stopping";
+            m_failed = true;
+            return false;
+        }
+    }
+
+    db::Status status = m_txIndex.WriteEntries({}, GetLocator(pfork));
+    if (!status.ok()) {
+        m_failed = true;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_best = pfork;
+    return true;
+}
+
+void TxIndexer::BlockConnected(const Block& block, const BlockIndex* pindex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop || m_failed) {
+        return;
+    }
+
+    if (m_synced && pindex->pprev == m_best) {
+        db::DiskBlockPos pos(pindex->nFile, pindex->nDataPos);
+        db::Status status = m_txIndex.WriteEntries(db::TxIndex::GetBlockEntries(block, pos),
+                                                   GetLocator(pindex));
+        if (status.ok()) {
+            m_best = pindex;
+            return;
+        }
+        LOG_WARN(util::LogCategory::DEFAULT) << "txindex: write failed, resyncing: "
+                                             << status.ToString();
+    }
+
+    // Not an extension of the index (reorg, or still catching up)
+    m_synced = false;
+    m_wakeup = true;
+    m_cv.notify_all();
+}
+
+} // namespace shurium
@@ -0,0 +1,483 @@
+// SHURIUM - UTXO Snapshots Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/chain/utxosnapshot.h"
+#include "shurium/chain/coins.h"
+#include "shurium/core/serialize.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/db/utxodb.h"
+#include "shurium/util/logging.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace shurium {
+
+namespace {
+
+/// File magic
+constexpr uint8_t SNAPSHOT_MAGIC[5] = {'s', 'u', 't', 'x', 'o'};
+
+/// First four bytes of SHA256d(payload), little-endian
+uint32_t ChunkChecksum(const uint8_t* data, size_t len) {
+    Hash256 hash = DoubleSHA256(data, len);
+    return static_cast<uint32_t>(hash[0]) |
+           (static_cast<uint32_t>(hash[1]) << 8) |
+           (static_cast<uint32_t>(hash[2]) << 16) |
+           (static_cast<uint32_t>(hash[3]) << 24);
+}
+
+bool WriteStream(std::ofstream& file, const DataStream& ss) {
+    file.write(reinterpret_cast<const char*>(ss.data()),
+               static_cast<std::streamsize>(ss.size()));
+    return file.good();
+}
+
+/// Read exactly len bytes from the file into a stream
+bool ReadStream(std::ifstream& file, size_t len, DataStream& ss) {
+    std::vector<uint8_t> buffer(len);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(len));
+    if (static_cast<size_t>(file.gcount()) != len) {
+        return false;
+    }
+    ss = DataStream(std::move(buffer));
+    return true;
+}
+
+// ============================================================================
+// SnapshotWriter - Streams coins into chunks
+// ============================================================================
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::ofstream& file) : m_file(file) {}
+
+    bool WriteHeader(const UTXOSnapshotMetadata& metadata) {
+        DataStream ss;
+        ss.Write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        Serialize(ss, UTXO_SNAPSHOT_VERSION);
+        Serialize(ss, metadata.network);
+        Serialize(ss, static_cast<const Hash256&>(metadata.baseBlockHash));
+        Serialize(ss, metadata.baseHeight);
+        return WriteStream(m_file, ss);
+    }
+
+    bool Add(const OutPoint& outpoint, const Coin& coin) {
+        Serialize(m_payload, outpoint);
+        Serialize(m_payload, coin);
+        ++m_chunkCoins;
+        ++m_nCoins;
+        return m_chunkCoins < UTXO_SNAPSHOT_CHUNK_COINS || WriteChunk();
+    }
+
+    /// Write the last chunk, the terminator and the footer
+    bool Finish() {
+        if (m_chunkCoins > 0 && !WriteChunk()) {
+            return false;
+        }
+        DataStream ss;
+        Serialize(ss, uint32_t(0));
+        Serialize(ss, uint32_t(0));
+        Serialize(ss, ChunkChecksum(nullptr, 0));
+        Serialize(ss, m_nCoins);
+
+        m_hasher.Finalize(m_hash.data());
+        Serialize(ss, m_hash);
+        return WriteStream(m_file, ss);
+    }
+
+    uint64_t GetCoinCount() const { return m_nCoins; }
+    uint64_t GetChunkCount() const { return m_nChunks; }
+    const Hash256& GetHash() const { return m_hash; }
+
+private:
+    bool WriteChunk() {
+        m_hasher.Write(m_payload.data(), m_payload.size());
+
+        DataStream ss;
+        Serialize(ss, m_chunkCoins);
+        Serialize(ss, static_cast<uint32_t>(m_payload.size()));
+        ss.Write(m_payload.data(), m_payload.size());
+        Serialize(ss, ChunkChecksum(m_payload.data(), m_payload.size()));
+
+        m_payload.clear();
+        m_chunkCoins = 0;
+        ++m_nChunks;
+        return WriteStream(m_file, ss);
+    }
+
+    std::ofstream& m_file;
+    DataStream m_payload;
+    uint32_t m_chunkCoins{0};
+    uint64_t m_nCoins{0};
+    uint64_t m_nChunks{0};
+    SHA256 m_hasher;
+    Hash256 m_hash;
+};
+
+// ============================================================================
+// SnapshotReader - Reads and checks chunks
+// ============================================================================
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(const std::filesystem::path& path)
+        : m_file(path, std::ios::binary) {}
+
+    bool IsOpen() const { return m_file.is_open(); }
+    const std::string& GetError() const { return m_error; }
+
+    bool ReadHeader(UTXOSnapshotMetadata& metadata) {
+        try {
+            uint8_t magic[sizeof(SNAPSHOT_MAGIC)];
+            m_file.read(reinterpret_cast<char*>(magic), sizeof(magic));
+            if (m_file.gcount() != sizeof(magic) ||
+                std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+                return Fail("Not a UTXO snapshot file");
+            }
+
+            DataStream ss;
+            if (!ReadStream(m_file, 2, ss)) {
+                return Fail("Truncated snapshot header");
+            }
+            uint16_t version;
+            Unserialize(ss, version);
+            if (version != UTXO_SNAPSHOT_VERSION) {
+                return Fail("Unsupported snapshot version " + std::to_string(version));
+            }
+
+            // Network ID: compact size prefix, then the characters
+            if (!ReadStream(m_file, 1, ss)) {
+                return Fail("Truncated snapshot header");
+            }
+            uint8_t len;
+            Unserialize(ss, len);
+            if (len >= 0xfd) {
+                return Fail("Invalid network ID in snapshot header");
+            }
+            std::vector<uint8_t> network(len);
+            m_file.read(reinterpret_cast<char*>(network.data()), len);
+            if (m_file.gcount() != len) {
+                return Fail("Truncated snapshot header");
+            }
+            metadata.network.assign(network.begin(), network.end());
+
+            if (!ReadStream(m_file, 32 + 4, ss)) {
+                return Fail("Truncated snapshot header");
+            }
+            Hash256 baseHash;
+            Unserialize(ss, baseHash);
+            metadata.baseBlockHash = BlockHash(baseHash);
+            Unserialize(ss, metadata.baseHeight);
+        } catch (const std::exception& e) {
+            return Fail(std::string("Malformed snapshot header: ") + e.what());
+        }
+        return true;
+    }
+
+    /**
+     * Read the next chunk into payload, checking its checksum.
+     * @param[out] nCoins Coins in the chunk (0 = end of chunks)
+     */
+    bool ReadChunk(DataStream& payload, uint32_t& nCoins) {
+        DataStream ss;
+        if (!ReadStream(m_file, 8, ss)) {
+            return Fail("Truncated snapshot chunk");
+        }
+        uint32_t payloadSize;
+        Unserialize(ss, nCoins);
+        Unserialize(ss, payloadSize);
+        if (payloadSize > MAX_UTXO_SNAPSHOT_CHUNK_BYTES) {
+            return Fail("Snapshot chunk too large");
+        }
+
+        if (!ReadStream(m_file, payloadSize, payload)) {
+            return Fail("Truncated snapshot chunk");
+        }
+        if (!ReadStream(m_file, 4, ss)) {
+            return Fail("Truncated snapshot chunk");
+        }
+        uint32_t checksum;
+        Unserialize(ss, checksum);
+        if (checksum != ChunkChecksum(payload.data(), payload.size())) {
+            return Fail("Snapshot chunk " + std::to_string(m_nChunks) + " checksum mismatch");
+        }
+
+        if (nCoins > 0) {
+            m_hasher.Write(payload.data(), payload.size());
+            ++m_nChunks;
+        }
+        return true;
+    }
+
+    /// Read the footer and compare it with what the chunks contained
+    bool ReadFooter(UTXOSnapshotMetadata& metadata, uint64_t nCoinsRead) {
+        DataStream ss;
+        if (!ReadStream(m_file, 8 + 32, ss)) {
+            return Fail("Truncated snapshot footer");
+        }
+        Unserialize(ss, metadata.nCoins);
+        Unserialize(ss, metadata.utxoSetHash);
+
+        if (metadata.nCoins != nCoinsRead) {
+            return Fail("Snapshot coin count mismatch");
+        }
+        Hash256 hash;
+        m_hasher.Finalize(hash.data());
+        if (hash != metadata.utxoSetHash) {
+            return Fail("Snapshot contents do not match its UTXO set hash");
+        }
+        if (m_file.peek() != std::char_traits<char>::eof()) {
+            return Fail("Trailing data after snapshot footer");
+        }
+        return true;
+    }
+
+    uint64_t GetChunkCount() const { return m_nChunks; }
+
+private:
+    bool Fail(const std::string& error) {
+        m_error = error;
+        return false;
+    }
+
+    std::ifstream m_file;
+    std::string m_error;
+    SHA256 m_hasher;
+    uint64_t m_nChunks{0};
+};
+
+/// Decode the (outpoint, coin) records of a chunk payload
+bool DecodeChunk(DataStream& payload, uint32_t nCoins, CoinsMap& coins) {
+    try {
+        for (uint32_t i = 0; i < nCoins; ++i) {
+            OutPoint outpoint;
+            Coin coin;
+            Unserialize(payload, outpoint);
+            Unserialize(payload, coin);
+            if (coin.IsSpent()) {
+                return false;
+            }
+            CoinsCacheEntry entry(std::move(coin));
+            entry.SetDirty();
+            if (!coins.emplace(outpoint, std::move(entry)).second) {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return payload.empty();
+}
+
+/// Check the snapshot against the trusted entry for its base block
+bool CheckAssumeUtxo(const UTXOSnapshotMetadata& metadata,
+                     const consensus::Params& params, std::string& error) {
+    if (metadata.network != params.strNetworkID) {
+        error = "Snapshot is for network '" + metadata.network + "'";
+        return false;
+    }
+    const consensus::AssumeUtxoData* trusted = params.AssumeUtxoForBlock(metadata.baseBlockHash);
+    if (!trusted) {
+        error = "No trusted UTXO snapshot for block " + metadata.baseBlockHash.ToHex();
+        return false;
+    }
+    if (trusted->nHeight != metadata.baseHeight || trusted->nCoins != metadata.nCoins ||
+        trusted->utxoSetHash != metadata.utxoSetHash) {
+        error = "Snapshot does not match the trusted UTXO set for block " +
+                metadata.baseBlockHash.ToHex();
+        return false;
+    }
+    return true;
+}
+
+/// Read a whole snapshot, verifying it, handing each chunk to onChunk
+template <typename Func>
+UTXOSnapshotResult ReadSnapshot(const std::filesystem::path& path,
+                                const consensus::Params& params, Func&& onChunk) {
+    SnapshotReader reader(path);
+    if (!reader.IsOpen()) {
+        return UTXOSnapshotResult::Error("Cannot open " + path.string());
+    }
+
+    UTXOSnapshotResult result;
+    if (!reader.ReadHeader(result.metadata)) {
+        return UTXOSnapshotResult::Error(reader.GetError());
+    }
+
+    uint64_t nCoinsRead = 0;
+    while (true) {
+        DataStream payload;
+        uint32_t nCoins = 0;
+        if (!reader.ReadChunk(payload, nCoins)) {
+            return UTXOSnapshotResult::Error(reader.GetError());
+        }
+        if (nCoins == 0) {
+            break;
+        }
+
+        CoinsMap coins;
+        if (!DecodeChunk(payload, nCoins, coins)) {
+            return UTXOSnapshotResult::Error("Malformed coins in snapshot chunk " +
+                                             std::to_string(reader.GetChunkCount() - 1));
+        }
+        nCoinsRead += nCoins;
+        if (!onChunk(coins)) {
+            return UTXOSnapshotResult::Error("Failed to write snapshot coins to the database");
+        }
+    }
+
+    if (!reader.ReadFooter(result.metadata, nCoinsRead)) {
+        return UTXOSnapshotResult::Error(reader.GetError());
+    }
+    if (!CheckAssumeUtxo(result.metadata, params, result.error)) {
+        return UTXOSnapshotResult::Error(result.error);
+    }
+
+    result.nChunks = reader.GetChunkCount();
+    result.success = true;
+    return result;
+}
+
+} // namespace
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+UTXOSnapshotResult DumpUTXOSnapshot(const db::CoinsViewDB& coinsDB,
+                                    const db::DatabaseSnapshot& snapshot, int baseHeight,
+                                    const std::string& network,
+                                    const std::filesystem::path& path) {
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        return UTXOSnapshotResult::Error(path.string() + " already exists");
+    }
+
+    UTXOSnapshotResult result;
+    result.metadata.network = network;
+    result.metadata.baseBlockHash = coinsDB.GetBestBlock(snapshot);
+    result.metadata.baseHeight = baseHeight;
+    if (result.metadata.baseBlockHash.IsNull()) {
+        return UTXOSnapshotResult::Error("UTXO database has no best block");
+    }
+
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".incomplete";
+    bool ok = false;
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return UTXOSnapshotResult::Error("Cannot create " + tmpPath.string());
+        }
+
+        SnapshotWriter writer(file);
+        ok = writer.WriteHeader(result.metadata);
+        if (ok) {
+            coinsDB.ForEachCoin([&](const OutPoint& outpoint, const Coin& coin) {
+                ok = writer.Add(outpoint, coin);
+                return ok;
+            }, &snapshot);
+        }
+        ok = ok && writer.Finish();
+
+        result.metadata.nCoins = writer.GetCoinCount();
+        result.metadata.utxoSetHash = writer.GetHash();
+        result.nChunks = writer.GetChunkCount();
+    }
+
+    if (!ok) {
+        std::filesystem::remove(tmpPath, ec);
+        return UTXOSnapshotResult::Error("Failed writing " + tmpPath.string());
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return UTXOSnapshotResult::Error("Cannot rename snapshot to " + path.string());
+    }
+
+    LOG_INFO(util::LogCategory::DEFAULT) << "Wrote UTXO snapshot with " << result.metadata.nCoins
+                                         << " coins at height " << baseHeight << " to " << path.string();
+    result.success = true;
+    return result;
+}
+
+UTXOSnapshotResult DumpUTXOSnapshot(const db::CoinsViewDB& coinsDB, int baseHeight,
+                                    const std::string& network,
+                                    const std::filesystem::path& path) {
+    BlockHash expected = coinsDB.GetBestBlock();
+    auto snapshot = coinsDB.NewSnapshot();
+    if (!snapshot) {
+        return UTXOSnapshotResult::Error("UTXO database cannot take a snapshot");
+    }
+    if (coinsDB.GetBestBlock(*snapshot) != expected) {
+        return UTXOSnapshotResult::Error("UTXO database changed during the dump; try again");
+    }
+    return DumpUTXOSnapshot(coinsDB, *snapshot, baseHeight, network, path);
+}
+
+UTXOSnapshotResult ReadUTXOSnapshotHeader(const std::filesystem::path& path) {
+    SnapshotReader reader(path);
+    if (!reader.IsOpen()) {
+        return UTXOSnapshotResult::Error("Cannot open " + path.string());
+    }
+
+    UTXOSnapshotResult result;
+    if (!reader.ReadHeader(result.metadata)) {
+        return UTXOSnapshotResult::Error(reader.GetError());
+    }
+    result.success = true;
+    return result;
+}
+
+UTXOSnapshotResult VerifyUTXOSnapshot(const std::filesystem::path& path,
+                                      const consensus::Params& params) {
+    return ReadSnapshot(path, params, [](const CoinsMap&) { return true; });
+}
+
+UTXOSnapshotResult LoadUTXOSnapshot(const std::filesystem::path& path,
+                                    const consensus::Params& params,
+                                    db::CoinsViewDB& coinsDB) {
+    if (!coinsDB.GetBestBlock().IsNull() ||
+        coinsDB.ForEachCoin([](const OutPoint&, const Coin&) { return false; }) != 0) {
+        return UTXOSnapshotResult::Error("UTXO database is not empty");
+    }
+
+    // Check the whole file first so a bad snapshot never touches the database
+    UTXOSnapshotResult verified = VerifyUTXOSnapshot(path, params);
+    if (!verified.success) {
+        return verified;
+    }
+
+    UTXOSnapshotResult result = ReadSnapshot(path, params, [&](const CoinsMap& coins) {
+        MuHash3072 hashDelta;
+        for (const auto& [outpoint, entry] : coins) {
+            AddCoinToHash(hashDelta, outpoint, entry.coin);
+        }
+        return coinsDB.BatchWrite(coins, BlockHash(), hashDelta);
+    });
+    if (result.success && !coinsDB.SetBestBlock(result.metadata.baseBlockHash).ok()) {
+        result = UTXOSnapshotResult::Error("Failed to set the UTXO database best block");
+    }
+
+    if (!result.success) {
+        // Leave the database empty rather than holding half a snapshot
+        std::vector<OutPoint> loaded;
+        coinsDB.ForEachCoin([&](const OutPoint& outpoint, const Coin&) {
+            loaded.push_back(outpoint);
+            return true;
+        });
+        for (const auto& outpoint : loaded) {
+            coinsDB.RemoveCoin(outpoint);
+        }
+        return result;
+    }
+
+    LOG_INFO(util::LogCategory::DEFAULT) << "Loaded UTXO snapshot with " << result.metadata.nCoins
+                                         << " coins at height " << result.metadata.baseHeight;
+    return result;
+}
+
+} // namespace shurium
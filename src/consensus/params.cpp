@@ -143,6 +143,10 @@ Params Params::Main() {
     params.nPoUWActivationHeight = 10000;
     params.fPoUWOptional = false;  // PoUW required on mainnet after activation
     
+    // Initial sync: no assumed-valid block until the chain has history
+    params.defaultAssumeValid = BlockHash();
+    params.assumeUtxo.clear();  // No trusted UTXO snapshots yet
+    
     // Create genesis block with mined nonce
     // Genesis hash: 0000090f1d7ccd5f0b91be5a92cfa9e075c6af443594f33f7c2238c3626f3172
     Block genesis = CreateGenesisBlock(
@@ -177,6 +181,10 @@ Params Params::TestNet() {
     params.nPoUWActivationHeight = 100;  // Much earlier activation for testing
     params.fPoUWOptional = true;  // Optional on testnet for easier development
     
+    // Initial sync: no assumed-valid block until the chain has history
+    params.defaultAssumeValid = BlockHash();
+    params.assumeUtxo.clear();  // No trusted UTXO snapshots yet
+    
     // Create testnet genesis block with mined nonce
     // Genesis hash: 000001b2150a56cc228d9b60fedaace333bb67b4ef168ef1e01e29b6ce61ae75
     Block genesis = CreateGenesisBlock(
@@ -222,6 +230,10 @@ Params Params::RegTest() {
     params.nPoUWActivationHeight = 0;  // Active from genesis
     params.fPoUWOptional = true;  // Always optional on regtest for testing
     
+    // Initial sync: always verify every script on regtest
+    params.defaultAssumeValid = BlockHash();
+    params.assumeUtxo.clear();  // No trusted UTXO snapshots yet
+    
     // Create regtest genesis with mined nonce
     // Genesis hash: 277a4081985b8800293bf3cda91202c6b761a8b8de4f5fcc018d6cf14f60737c
     Block genesis = CreateGenesisBlock(
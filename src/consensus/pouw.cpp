@@ -248,10 +248,11 @@ uint32_t GetNextWorkRequired(const BlockIndex* pindexLast, const BlockHeader* pb
         
         // Otherwise, return the last non-special-min-difficulty block's nBits
         // Walk back through the chain to find a block that wasn't min difficulty
+        const uint32_t nProofOfWorkLimit = BigToCompact(params.powLimit);
         const BlockIndex* pindex = pindexLast;
         while (pindex->pprev != nullptr && 
                pindex->nHeight % difficultyAdjustmentInterval != 0 &&
-               pindex->nBits == BigToCompact(params.powLimit)) {
+               pindex->nBits == nProofOfWorkLimit) {
             pindex = pindex->pprev;
         }
         return pindex->nBits;
@@ -264,15 +265,8 @@ uint32_t GetNextWorkRequired(const BlockIndex* pindexLast, const BlockHeader* pb
     
     // Find the first block of this retarget period
     // We need to go back DifficultyAdjustmentInterval blocks
-    int heightFirst = nextHeight - static_cast<int>(difficultyAdjustmentInterval);
-    if (heightFirst < 0) {
-        heightFirst = 0;
-    }
-    
-    const BlockIndex* pindexFirst = pindexLast;
-    for (int i = 0; pindexFirst && i < static_cast<int>(difficultyAdjustmentInterval) - 1; ++i) {
-        pindexFirst = pindexFirst->pprev;
-    }
+    int heightFirst = pindexLast->nHeight - (static_cast<int>(difficultyAdjustmentInterval) - 1);
+    const BlockIndex* pindexFirst = pindexLast->GetAncestor(heightFirst);
     
     if (pindexFirst == nullptr) {
         // Not enough blocks yet, keep current difficulty
@@ -3,7 +3,11 @@
 // MIT License
 
 #include "shurium/consensus/validation.h"
+#include "shurium/consensus/checkpoints.h"
 #include "shurium/core/merkle.h"
+#include "shurium/util/threadpool.h"
+#include <algorithm>
+#include <future>
 #include <set>
 #include <sstream>
 
@@ -56,6 +60,80 @@ bool CheckBlockHeader(const Block& block, ValidationState& state, const Params&
     return true;
 }
 
+size_t CheckHeaderBatch(const std::vector<BlockHeader>& headers,
+                        const std::vector<BlockHash>& hashes, int32_t firstHeight,
+                        const Params& params, const CheckpointManager* checkpoints,
+                        ValidationState& state, util::ThreadPool* pool) {
+    // Cheap checks first, in order: the headers are given up to the
+    // first that fails
+    size_t valid = headers.size();
+    for (size_t i = 0; i < headers.size(); ++i) {
+        const BlockHeader& header = headers[i];
+        if (i > 0 && header.hashPrevBlock != hashes[i - 1]) {
+            state.Invalid("bad-prevblk", "headers do not link up");
+            valid = i;
+            break;
+        }
+        if (header.nVersion < 1) {
+            state.Invalid("bad-version", "block version too low");
+            valid = i;
+            break;
+        }
+        if (header.nBits == 0) {
+            state.Invalid("bad-diffbits", "difficulty bits not set");
+            valid = i;
+            break;
+        }
+    }
+    
+    // Checkpoints in the heights covered, in one walk of the map
+    if (checkpoints && valid > 0) {
+        const auto& points = checkpoints->GetCheckpoints();
+        int32_t lastHeight = firstHeight + static_cast<int32_t>(valid) - 1;
+        for (auto it = points.lower_bound(firstHeight);
+             it != points.end() && it->first <= lastHeight; ++it) {
+            if (hashes[static_cast<size_t>(it->first - firstHeight)] != it->second.hash) {
+                valid = static_cast<size_t>(it->first - firstHeight);
+                state.Invalid("checkpoint-mismatch", "header does not match checkpoint");
+                break;
+            }
+        }
+    }
+    
+    // Proof of work: the first failure in each chunk, the lowest wins
+    auto checkChunk = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!CheckProofOfWork(hashes[i], headers[i].nBits, params)) {
+                return i;
+            }
+        }
+        return end;
+    };
+    size_t powValid = valid;
+    if (pool && valid > HEADER_CHECK_CHUNK) {
+        std::vector<std::future<size_t>> chunks;
+        for (size_t begin = 0; begin < valid; begin += HEADER_CHECK_CHUNK) {
+            size_t end = std::min(begin + HEADER_CHECK_CHUNK, valid);
+            chunks.push_back(pool->Submit(checkChunk, begin, end));
+        }
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            size_t end = std::min((c + 1) * HEADER_CHECK_CHUNK, valid);
+            size_t failed = chunks[c].get();
+            if (failed < end && failed < powValid) {
+                powValid = failed;
+            }
+        }
+    } else {
+        powValid = checkChunk(0, valid);
+    }
+    if (powValid < valid) {
+        valid = powValid;
+        state.Invalid("high-hash", "proof of work failed");
+    }
+    
+    return valid;
+}
+
 // ============================================================================
 // Block Validation
 // ============================================================================
@@ -214,12 +292,13 @@ bool CheckBlockTime(const Block& block, int64_t nPrevBlockTime, int64_t nAdjuste
 unsigned int GetTransactionSigOpCount(const Transaction& tx) {
     unsigned int nSigOps = 0;
     
-    for (const auto& txin : tx.vin) {
-        nSigOps += txin.scriptSig.GetSigOpCount(false);
+    // The decoded scripts are cached on tx and reused by script verification
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        nSigOps += tx.GetDecodedScriptSig(i).GetSigOpCount(false);
     }
     
-    for (const auto& txout : tx.vout) {
-        nSigOps += txout.scriptPubKey.GetSigOpCount(false);
+    for (size_t i = 0; i < tx.vout.size(); ++i) {
+        nSigOps += tx.GetDecodedScriptPubKey(i).GetSigOpCount(false);
     }
     
     return nSigOps;
@@ -0,0 +1,29 @@
+// SHURIUM - Arena Allocation Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/core/arena.h"
+
+#include <algorithm>
+
+namespace shurium {
+
+Arena::Arena(size_t initialSize)
+    : nextChunkSize_(std::max(initialSize, MIN_CHUNK_SIZE)) {}
+
+void* Arena::AllocateSlow(size_t size, size_t align) {
+    // A chunk that fits the request even at worst-case alignment
+    size_t chunkSize = std::max(nextChunkSize_, size + align);
+    chunks_.emplace_back(new uint8_t[chunkSize]);
+    reserved_ += chunkSize;
+    nextChunkSize_ = std::min(std::max(nextChunkSize_ * 2, MIN_CHUNK_SIZE), MAX_CHUNK_SIZE);
+
+    cursor_ = reinterpret_cast<uintptr_t>(chunks_.back().get());
+    end_ = cursor_ + chunkSize;
+    uintptr_t aligned = (cursor_ + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    cursor_ = aligned + size;
+    used_ += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+} // namespace shurium
@@ -15,15 +15,50 @@ namespace shurium {
 // BlockHeader Implementation
 // ============================================================================
 
+namespace {
+
+/// Serialization sink over a fixed buffer
+struct FixedWriter {
+    uint8_t* out;
+    
+    void Write(const uint8_t* data, size_t len) {
+        std::memcpy(out, data, len);
+        out += len;
+    }
+    void Write(const char* data, size_t len) {
+        Write(reinterpret_cast<const uint8_t*>(data), len);
+    }
+};
+
+} // anonymous namespace
+
+void BlockHeader::SerializeTo(uint8_t* out) const {
+    FixedWriter writer{out};
+    Serialize(writer, *this);
+}
+
 BlockHash BlockHeader::GetHash() const {
-    // Serialize the header
-    DataStream ss;
-    Serialize(ss, *this);
+    uint8_t bytes[BLOCK_HEADER_SIZE];
+    SerializeTo(bytes);
     
     // Double SHA256 (Bitcoin-compatible block hashing)
-    Hash256 hash = DoubleSHA256(ss.data(), ss.TotalSize());
+    return BlockHash(DoubleSHA256(bytes, sizeof(bytes)));
+}
+
+std::vector<BlockHash> GetBlockHeaderHashes(const std::vector<BlockHeader>& headers) {
+    // Serialized back to back, one per kernel lane
+    DataStream ss;
+    for (const auto& header : headers) {
+        Serialize(ss, header);
+    }
     
-    return BlockHash(hash);
+    std::vector<BlockHash> hashes(headers.size());
+    std::vector<Byte> digests(32 * headers.size());
+    DoubleSHA256_80(digests.data(), ss.data(), headers.size());
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        std::memcpy(hashes[i].data(), digests.data() + 32 * i, 32);
+    }
+    return hashes;
 }
 
 std::string BlockHeader::ToString() const {
@@ -61,8 +96,31 @@ Hash256 Block::ComputeMerkleRoot() const {
     return shurium::ComputeMerkleRoot(std::move(txHashes));
 }
 
+BlockHash Block::GetHash() const {
+    uint8_t bytes[BLOCK_HEADER_SIZE];
+    SerializeTo(bytes);
+    {
+        std::lock_guard<std::mutex> lock(m_hashMutex);
+        if (m_hashCached && std::memcmp(bytes, m_hashedHeader, sizeof(bytes)) == 0) {
+            return m_hash;
+        }
+    }
+    
+    BlockHash hash(DoubleSHA256(bytes, sizeof(bytes)));
+    std::lock_guard<std::mutex> lock(m_hashMutex);
+    std::memcpy(m_hashedHeader, bytes, sizeof(bytes));
+    m_hash = hash;
+    m_hashCached = true;
+    return hash;
+}
+
 size_t Block::GetTotalSize() const {
-    return GetSerializeSize(*this);
+    // From the transactions' cached sizes rather than a walk of every script
+    size_t size = BLOCK_HEADER_SIZE + GetCompactSizeSize(vtx.size());
+    for (const auto& tx : vtx) {
+        size += tx->GetTotalSize();
+    }
+    return size;
 }
 
 std::string Block::ToString() const {
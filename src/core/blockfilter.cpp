@@ -0,0 +1,307 @@
+// SHURIUM - Compact Block Filters Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/core/blockfilter.h"
+#include "shurium/core/serialize.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/crypto/siphash.h"
+#include <algorithm>
+#include <cstring>
+#include <ios>
+#include <limits>
+#include <stdexcept>
+
+namespace shurium {
+
+namespace {
+
+// ============================================================================
+// Golomb-Rice bit streams
+// ============================================================================
+
+/// Appends bits to a byte vector, most significant bit first
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void Write(uint64_t value, int nBits) {
+        while (nBits > 0) {
+            int nTake = std::min(nBits, 8 - m_offset);
+            uint8_t chunk = static_cast<uint8_t>(
+                (value >> (nBits - nTake)) & ((1u << nTake) - 1));
+            m_byte |= static_cast<uint8_t>(chunk << (8 - m_offset - nTake));
+            m_offset += nTake;
+            nBits -= nTake;
+            if (m_offset == 8) {
+                Flush();
+            }
+        }
+    }
+
+    /// Write out a partial last byte, zero-padded
+    void Flush() {
+        if (m_offset == 0) {
+            return;
+        }
+        m_out.push_back(m_byte);
+        m_byte = 0;
+        m_offset = 0;
+    }
+
+private:
+    std::vector<uint8_t>& m_out;
+    uint8_t m_byte{0};
+    int m_offset{0};
+};
+
+/// Reads bits from a byte range, most significant bit first
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    uint64_t Read(int nBits) {
+        uint64_t value = 0;
+        while (nBits > 0) {
+            if (m_offset == 8) {
+                if (m_pos == m_size) {
+                    throw std::ios_base::failure("GCSFilter: stream ends early");
+                }
+                m_byte = m_data[m_pos++];
+                m_offset = 0;
+            }
+            int nTake = std::min(nBits, 8 - m_offset);
+            uint64_t chunk = (m_byte >> (8 - m_offset - nTake)) & ((1u << nTake) - 1);
+            value = (value << nTake) | chunk;
+            m_offset += nTake;
+            nBits -= nTake;
+        }
+        return value;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos{0};
+    uint8_t m_byte{0};
+    int m_offset{8};
+};
+
+void GolombRiceEncode(BitWriter& writer, uint8_t P, uint64_t delta) {
+    // Quotient in unary, then P bits of remainder
+    for (uint64_t q = delta >> P; q > 0; q -= std::min<uint64_t>(q, 64)) {
+        int nBits = static_cast<int>(std::min<uint64_t>(q, 64));
+        writer.Write(~uint64_t{0}, nBits);
+    }
+    writer.Write(0, 1);
+    writer.Write(delta, P);
+}
+
+uint64_t GolombRiceDecode(BitReader& reader, uint8_t P) {
+    uint64_t q = 0;
+    while (reader.Read(1) == 1) {
+        ++q;
+    }
+    return (q << P) + reader.Read(P);
+}
+
+/// Little-endian 64-bit word of the filter key
+uint64_t ReadKeyWord(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/// Map a 64-bit hash uniformly onto [0, F)
+uint64_t MapIntoRange(uint64_t x, uint64_t n) {
+    __extension__ typedef unsigned __int128 uint128_t;
+    return static_cast<uint64_t>((static_cast<uint128_t>(x) * n) >> 64);
+}
+
+} // namespace
+
+// ============================================================================
+// GCSFilter
+// ============================================================================
+
+GCSFilter::GCSFilter(const Params& params) : m_params(params) {
+    m_encoded.push_back(0);  // CompactSize(0)
+}
+
+GCSFilter::GCSFilter(const Params& params, const ElementSet& elements) : m_params(params) {
+    m_N = static_cast<uint32_t>(elements.size());
+    m_F = static_cast<uint64_t>(m_N) * m_params.M;
+
+    DataStream ss;
+    WriteCompactSize(ss, m_N);
+    m_encoded.assign(ss.data(), ss.data() + ss.size());
+
+    std::vector<uint64_t> hashed = BuildHashedSet(elements);
+    BitWriter writer(m_encoded);
+    uint64_t last = 0;
+    for (uint64_t value : hashed) {
+        GolombRiceEncode(writer, m_params.P, value - last);
+        last = value;
+    }
+    writer.Flush();
+}
+
+GCSFilter::GCSFilter(const Params& params, std::vector<uint8_t> encoded)
+    : m_params(params), m_encoded(std::move(encoded)) {
+    SpanReader reader(m_encoded.data(), m_encoded.size());
+    uint64_t n = ReadCompactSize(reader);
+    if (n > std::numeric_limits<uint32_t>::max()) {
+        throw std::ios_base::failure("GCSFilter: N too large");
+    }
+    m_N = static_cast<uint32_t>(n);
+    m_F = static_cast<uint64_t>(m_N) * m_params.M;
+
+    // Decode once so a bad filter is rejected here rather than on a query
+    BitReader bits(reader.data(), reader.size());
+    for (uint32_t i = 0; i < m_N; ++i) {
+        GolombRiceDecode(bits, m_params.P);
+    }
+}
+
+uint64_t GCSFilter::HashToRange(const Element& element) const {
+    uint64_t hash = SipHash24(m_params.k0, m_params.k1, element.data(), element.size());
+    return MapIntoRange(hash, m_F);
+}
+
+std::vector<uint64_t> GCSFilter::BuildHashedSet(const ElementSet& elements) const {
+    std::vector<uint64_t> hashed;
+    hashed.reserve(elements.size());
+    for (const Element& element : elements) {
+        hashed.push_back(HashToRange(element));
+    }
+    std::sort(hashed.begin(), hashed.end());
+    return hashed;
+}
+
+bool GCSFilter::MatchInternal(const std::vector<uint64_t>& queries) const {
+    SpanReader reader(m_encoded.data(), m_encoded.size());
+    ReadCompactSize(reader);
+    BitReader bits(reader.data(), reader.size());
+
+    uint64_t value = 0;
+    size_t next = 0;
+    for (uint32_t i = 0; i < m_N && next < queries.size(); ++i) {
+        value += GolombRiceDecode(bits, m_params.P);
+        while (next < queries.size() && queries[next] < value) {
+            ++next;
+        }
+        if (next < queries.size() && queries[next] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GCSFilter::Match(const Element& element) const {
+    if (m_N == 0) {
+        return false;
+    }
+    return MatchInternal({HashToRange(element)});
+}
+
+bool GCSFilter::MatchAny(const ElementSet& elements) const {
+    if (m_N == 0 || elements.empty()) {
+        return false;
+    }
+    return MatchInternal(BuildHashedSet(elements));
+}
+
+// ============================================================================
+// Filter Types
+// ============================================================================
+
+namespace {
+
+const std::string BASIC_FILTER_NAME = "basic";
+const std::string UNKNOWN_FILTER_NAME;
+
+} // namespace
+
+const std::string& BlockFilterTypeName(BlockFilterType type) {
+    return type == BlockFilterType::BASIC ? BASIC_FILTER_NAME : UNKNOWN_FILTER_NAME;
+}
+
+std::optional<BlockFilterType> BlockFilterTypeFromName(const std::string& name) {
+    if (name == BASIC_FILTER_NAME) {
+        return BlockFilterType::BASIC;
+    }
+    return std::nullopt;
+}
+
+// ============================================================================
+// BlockFilter
+// ============================================================================
+
+BlockFilter::BlockFilter(BlockFilterType type, const Block& block,
+                         const std::vector<Script>& spentScripts)
+    : m_type(type), m_blockHash(block.GetHash()) {
+    GCSFilter::Params params;
+    if (!BuildParams(params)) {
+        throw std::invalid_argument("BlockFilter: unknown filter type");
+    }
+    m_filter = GCSFilter(params, BasicFilterElements(block, spentScripts));
+}
+
+BlockFilter::BlockFilter(BlockFilterType type, const BlockHash& blockHash,
+                         std::vector<uint8_t> encoded)
+    : m_type(type), m_blockHash(blockHash) {
+    GCSFilter::Params params;
+    if (!BuildParams(params)) {
+        throw std::invalid_argument("BlockFilter: unknown filter type");
+    }
+    m_filter = GCSFilter(params, std::move(encoded));
+}
+
+bool BlockFilter::BuildParams(GCSFilter::Params& params) const {
+    if (m_type != BlockFilterType::BASIC) {
+        return false;
+    }
+    params.k0 = ReadKeyWord(m_blockHash.data());
+    params.k1 = ReadKeyWord(m_blockHash.data() + 8);
+    params.P = BASIC_FILTER_P;
+    params.M = BASIC_FILTER_M;
+    return true;
+}
+
+Hash256 BlockFilter::GetHash() const {
+    return DoubleSHA256(m_filter.GetEncoded());
+}
+
+Hash256 BlockFilter::ComputeHeader(const Hash256& prevHeader) const {
+    Hash256 filterHash = GetHash();
+    uint8_t combined[64];
+    std::memcpy(combined, filterHash.data(), 32);
+    std::memcpy(combined + 32, prevHeader.data(), 32);
+    Hash256 header;
+    DoubleSHA256_64(header.data(), combined, 1);
+    return header;
+}
+
+GCSFilter::ElementSet BlockFilter::BasicFilterElements(const Block& block,
+                                                       const std::vector<Script>& spentScripts) {
+    GCSFilter::ElementSet elements;
+    for (const auto& tx : block.vtx) {
+        for (const auto& output : tx->vout) {
+            const Script& script = output.scriptPubKey;
+            if (script.empty() || script[0] == OP_RETURN) {
+                continue;
+            }
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+    for (const Script& script : spentScripts) {
+        if (!script.empty()) {
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+    return elements;
+}
+
+} // namespace shurium
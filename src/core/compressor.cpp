@@ -0,0 +1,185 @@
+// SHURIUM - Output Compression Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/core/compressor.h"
+#include "shurium/crypto/secp256k1.h"
+#include <algorithm>
+#include <cstring>
+
+namespace shurium {
+
+// ============================================================================
+// Amount Compression
+// ============================================================================
+
+namespace {
+
+/// Largest amount packed by exponent and last digit. The packing needs up to
+/// nine times the amount's range, which would overflow near MAX_MONEY, so
+/// larger amounts are stored unpacked above every packed value.
+constexpr uint64_t MAX_PACKED_AMOUNT = 1000000000000000000ULL;
+constexpr uint64_t UNPACKED_AMOUNT_BASE = 9 * MAX_PACKED_AMOUNT + 90;
+
+} // namespace
+
+uint64_t CompressAmount(uint64_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    if (n > MAX_PACKED_AMOUNT) {
+        return UNPACKED_AMOUNT_BASE + (n - MAX_PACKED_AMOUNT);
+    }
+    int e = 0;
+    while ((n % 10) == 0 && e < 9) {
+        n /= 10;
+        ++e;
+    }
+    if (e < 9) {
+        int d = static_cast<int>(n % 10);
+        n /= 10;
+        return 1 + (n * 9 + d - 1) * 10 + e;
+    }
+    return 1 + (n - 1) * 10 + 9;
+}
+
+uint64_t DecompressAmount(uint64_t x) {
+    if (x == 0) {
+        return 0;
+    }
+    if (x > UNPACKED_AMOUNT_BASE) {
+        return x - UNPACKED_AMOUNT_BASE + MAX_PACKED_AMOUNT;
+    }
+    --x;
+    int e = static_cast<int>(x % 10);
+    x /= 10;
+    uint64_t n = 0;
+    if (e < 9) {
+        int d = static_cast<int>(x % 9) + 1;
+        x /= 9;
+        n = x * 10 + d;
+    } else {
+        n = x + 1;
+    }
+    while (e > 0) {
+        n *= 10;
+        --e;
+    }
+    return n;
+}
+
+// ============================================================================
+// Script Compression
+// ============================================================================
+
+namespace {
+
+/// <33-byte compressed key> OP_CHECKSIG
+bool IsCompressedPayToPubKey(const Script& script) {
+    return script.size() == 35 && script[0] == 33 &&
+           (script[1] == 0x02 || script[1] == 0x03) && script[34] == OP_CHECKSIG;
+}
+
+/// <65-byte uncompressed key> OP_CHECKSIG, for keys whose y coordinate
+/// can be recomputed from x and its parity
+bool IsUncompressedPayToPubKey(const Script& script) {
+    if (script.size() != 67 || script[0] != 65 || script[1] != 0x04 ||
+        script[66] != OP_CHECKSIG) {
+        return false;
+    }
+    auto point = secp256k1::Point::FromUncompressed(script.data() + 1);
+    return point && point->IsOnCurve() &&
+           std::memcmp(point->ToUncompressed().data(), script.data() + 1, 65) == 0;
+}
+
+} // namespace
+
+unsigned int GetSpecialScriptSize(unsigned int nType) {
+    if (nType == SCRIPT_TYPE_P2PKH || nType == SCRIPT_TYPE_P2SH) {
+        return 20;
+    }
+    if (nType >= SCRIPT_TYPE_P2PK_COMPRESSED && nType < NUM_SPECIAL_SCRIPTS) {
+        return 32;
+    }
+    return 0;
+}
+
+bool CompressScript(const Script& script, std::vector<uint8_t>& out) {
+    if (script.IsPayToPublicKeyHash()) {
+        out.resize(21);
+        out[0] = SCRIPT_TYPE_P2PKH;
+        std::copy(script.begin() + 3, script.begin() + 23, out.begin() + 1);
+        return true;
+    }
+    if (script.IsPayToScriptHash()) {
+        out.resize(21);
+        out[0] = SCRIPT_TYPE_P2SH;
+        std::copy(script.begin() + 2, script.begin() + 22, out.begin() + 1);
+        return true;
+    }
+    if (IsCompressedPayToPubKey(script)) {
+        out.resize(33);
+        out[0] = static_cast<uint8_t>(SCRIPT_TYPE_P2PK_COMPRESSED + (script[1] & 1));
+        std::copy(script.begin() + 2, script.begin() + 34, out.begin() + 1);
+        return true;
+    }
+    if (IsUncompressedPayToPubKey(script)) {
+        out.resize(33);
+        out[0] = static_cast<uint8_t>(SCRIPT_TYPE_P2PK_UNCOMPRESSED + (script[65] & 1));
+        std::copy(script.begin() + 2, script.begin() + 34, out.begin() + 1);
+        return true;
+    }
+    return false;
+}
+
+bool DecompressScript(Script& script, unsigned int nType, const std::vector<uint8_t>& in) {
+    if (in.size() != GetSpecialScriptSize(nType)) {
+        return false;
+    }
+    switch (nType) {
+        case SCRIPT_TYPE_P2PKH:
+            script.resize(25);
+            script[0] = OP_DUP;
+            script[1] = OP_HASH160;
+            script[2] = 20;
+            std::copy(in.begin(), in.end(), script.begin() + 3);
+            script[23] = OP_EQUALVERIFY;
+            script[24] = OP_CHECKSIG;
+            return true;
+        case SCRIPT_TYPE_P2SH:
+            script.resize(23);
+            script[0] = OP_HASH160;
+            script[1] = 20;
+            std::copy(in.begin(), in.end(), script.begin() + 2);
+            script[22] = OP_EQUAL;
+            return true;
+        case SCRIPT_TYPE_P2PK_COMPRESSED:
+        case SCRIPT_TYPE_P2PK_COMPRESSED + 1:
+            script.resize(35);
+            script[0] = 33;
+            script[1] = static_cast<uint8_t>(0x02 + (nType - SCRIPT_TYPE_P2PK_COMPRESSED));
+            std::copy(in.begin(), in.end(), script.begin() + 2);
+            script[34] = OP_CHECKSIG;
+            return true;
+        case SCRIPT_TYPE_P2PK_UNCOMPRESSED:
+        case SCRIPT_TYPE_P2PK_UNCOMPRESSED + 1: {
+            uint8_t compressed[33];
+            compressed[0] = static_cast<uint8_t>(0x02 + (nType - SCRIPT_TYPE_P2PK_UNCOMPRESSED));
+            std::copy(in.begin(), in.end(), compressed + 1);
+            auto point = secp256k1::Point::FromCompressed(compressed);
+            if (!point || point->IsInfinity()) {
+                return false;
+            }
+            auto full = point->ToUncompressed();
+            script.resize(67);
+            script[0] = 65;
+            std::copy(full.begin(), full.end(), script.begin() + 1);
+            script[66] = OP_CHECKSIG;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+} // namespace shurium
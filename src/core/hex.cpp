@@ -3,29 +3,162 @@
 // MIT License
 
 #include "shurium/core/hex.h"
+#include "hex_impl.h"
+
+#include <atomic>
+
+#if defined(SHURIUM_HEX_SSSE3) || defined(SHURIUM_HEX_AVX2)
+#include <cpuid.h>
+#endif
 
 namespace shurium {
 
 namespace {
     constexpr char HEX_CHARS[] = "0123456789abcdef";
     
+    /// Nibble value of each character, -1 for non-hex characters
+    struct NibbleTable {
+        int8_t value[256];
+        
+        constexpr NibbleTable() : value() {
+            for (int c = 0; c < 256; ++c) {
+                value[c] = -1;
+            }
+            for (int c = '0'; c <= '9'; ++c) {
+                value[c] = static_cast<int8_t>(c - '0');
+            }
+            for (int c = 'a'; c <= 'f'; ++c) {
+                value[c] = static_cast<int8_t>(c - 'a' + 10);
+                value[c - 'a' + 'A'] = static_cast<int8_t>(c - 'a' + 10);
+            }
+        }
+    };
+    constexpr NibbleTable NIBBLES;
+    
     inline int HexCharToNibble(char c) {
-        if (c >= '0' && c <= '9') return c - '0';
-        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
-        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
-        return -1;
+        return NIBBLES.value[static_cast<uint8_t>(c)];
     }
-}
-
-std::string BytesToHex(const HexByte* data, size_t len) {
-    std::string result;
-    result.reserve(len * 2);
     
-    for (size_t i = 0; i < len; ++i) {
-        result.push_back(HEX_CHARS[data[i] >> 4]);
-        result.push_back(HEX_CHARS[data[i] & 0x0F]);
+    size_t EncodeScalar(const uint8_t*, size_t, char*) { return 0; }
+    size_t DecodeScalar(const char*, size_t, uint8_t*) { return 0; }
+    
+#if defined(SHURIUM_HEX_SSSE3) || defined(SHURIUM_HEX_AVX2)
+    bool CPUHasSSSE3() {
+        unsigned int eax, ebx, ecx, edx;
+        return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3) != 0;
     }
     
+    bool CPUHasAVX2() {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_OSXSAVE) == 0 ||
+            __get_cpuid_max(0, nullptr) < 7) {
+            return false;
+        }
+        // The OS must preserve the YMM registers
+        uint32_t lo, hi;
+        __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        if ((lo & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        return (ebx & bit_AVX2) != 0;
+    }
+#endif
+    
+    struct Kernels {
+        HexImplementation impl;
+        HexEncodeFn encode;     // Null if not built in or not supported
+        HexDecodeFn decode;
+    };
+    
+    Kernels GetSupportedKernels(HexImplementation impl) {
+        switch (impl) {
+            case HexImplementation::SCALAR:
+                return {impl, EncodeScalar, DecodeScalar};
+            case HexImplementation::SSSE3:
+#if defined(SHURIUM_HEX_SSSE3)
+                if (CPUHasSSSE3()) {
+                    return {impl, hex_ssse3::Encode, hex_ssse3::Decode};
+                }
+#endif
+                break;
+            case HexImplementation::AVX2:
+#if defined(SHURIUM_HEX_AVX2)
+                if (CPUHasAVX2()) {
+                    return {impl, hex_avx2::Encode, hex_avx2::Decode};
+                }
+#endif
+                break;
+            case HexImplementation::NEON:
+#if defined(SHURIUM_HEX_NEON)
+                return {impl, hex_neon::Encode, hex_neon::Decode};
+#else
+                break;
+#endif
+        }
+        return {impl, nullptr, nullptr};
+    }
+    
+    /// Fastest first
+    constexpr HexImplementation PREFERENCE[] = {
+        HexImplementation::AVX2, HexImplementation::SSSE3,
+        HexImplementation::NEON, HexImplementation::SCALAR};
+    
+    /// Kernels of every implementation, indexed by HexImplementation
+    const Kernels* KernelTable() {
+        static const Kernels table[] = {
+            GetSupportedKernels(HexImplementation::SCALAR),
+            GetSupportedKernels(HexImplementation::SSSE3),
+            GetSupportedKernels(HexImplementation::AVX2),
+            GetSupportedKernels(HexImplementation::NEON)};
+        return table;
+    }
+    
+    /// Kernels in use; null until first use, then set by SetHexImplementation
+    std::atomic<const Kernels*> g_kernels{nullptr};
+    
+    const Kernels& ActiveKernels() {
+        const Kernels* kernels = g_kernels.load(std::memory_order_acquire);
+        if (kernels) {
+            return *kernels;
+        }
+        const Kernels* best = nullptr;
+        for (HexImplementation impl : PREFERENCE) {
+            best = &KernelTable()[static_cast<size_t>(impl)];
+            if (best->encode) {
+                break;
+            }
+        }
+        const Kernels* expected = nullptr;
+        g_kernels.compare_exchange_strong(expected, best, std::memory_order_acq_rel);
+        return *g_kernels.load(std::memory_order_acquire);
+    }
+}
+
+void EncodeHex(const HexByte* data, size_t len, char* out) {
+    size_t i = ActiveKernels().encode(data, len, out);
+    for (; i < len; ++i) {
+        out[2 * i] = HEX_CHARS[data[i] >> 4];
+        out[2 * i + 1] = HEX_CHARS[data[i] & 0x0F];
+    }
+}
+
+bool DecodeHex(const char* hex, size_t len, HexByte* out) {
+    size_t i = ActiveKernels().decode(hex, len, out);
+    for (; i < len; ++i) {
+        int high = HexCharToNibble(hex[2 * i]);
+        int low = HexCharToNibble(hex[2 * i + 1]);
+        if ((high | low) < 0) {
+            return false;
+        }
+        out[i] = static_cast<HexByte>((high << 4) | low);
+    }
+    return true;
+}
+
+std::string BytesToHex(const HexByte* data, size_t len) {
+    std::string result(len * 2, '\0');
+    EncodeHex(data, len, result.data());
     return result;
 }
 
@@ -38,18 +171,9 @@ std::vector<HexByte> HexToBytes(const std::string& hex) {
         throw std::invalid_argument("Hex string must have even length");
     }
     
-    std::vector<HexByte> result;
-    result.reserve(hex.length() / 2);
-    
-    for (size_t i = 0; i < hex.length(); i += 2) {
-        int high = HexCharToNibble(hex[i]);
-        int low = HexCharToNibble(hex[i + 1]);
-        
-        if (high < 0 || low < 0) {
-            throw std::invalid_argument("Invalid hex character");
-        }
-        
-        result.push_back(static_cast<HexByte>((high << 4) | low));
+    std::vector<HexByte> result(hex.length() / 2);
+    if (!DecodeHex(hex.data(), result.size(), result.data())) {
+        throw std::invalid_argument("Invalid hex character");
     }
     
     return result;
@@ -69,6 +193,39 @@ bool IsValidHex(const std::string& str) {
     return true;
 }
 
+const char* HexImplementationName(HexImplementation impl) {
+    switch (impl) {
+        case HexImplementation::SCALAR: return "scalar";
+        case HexImplementation::SSSE3: return "ssse3";
+        case HexImplementation::AVX2: return "avx2";
+        case HexImplementation::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+HexImplementation GetHexImplementation() {
+    return ActiveKernels().impl;
+}
+
+std::vector<HexImplementation> GetAvailableHexImplementations() {
+    std::vector<HexImplementation> result;
+    for (HexImplementation impl : PREFERENCE) {
+        if (KernelTable()[static_cast<size_t>(impl)].encode) {
+            result.push_back(impl);
+        }
+    }
+    return result;
+}
+
+bool SetHexImplementation(HexImplementation impl) {
+    const Kernels* kernels = &KernelTable()[static_cast<size_t>(impl)];
+    if (!kernels->encode) {
+        return false;
+    }
+    g_kernels.store(kernels, std::memory_order_release);
+    return true;
+}
+
 std::vector<HexByte> ReverseBytes(const HexByte* data, size_t len) {
     std::vector<HexByte> result(len);
     for (size_t i = 0; i < len; ++i) {
@@ -0,0 +1,75 @@
+// SHURIUM - Hex Encoding Using AVX2
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -mavx2 and only called after CPUID and XGETBV report
+// support. The SSSE3 method on 32 bytes per step; AVX2 shuffles, unpacks
+// and packs work within 128-bit lanes, so results are put back in order
+// with cross-lane permutes.
+
+#include "hex_impl.h"
+#include <immintrin.h>
+
+namespace shurium {
+namespace hex_avx2 {
+
+size_t Encode(const uint8_t* in, size_t len, char* out) {
+    const __m256i table = _mm256_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    size_t done = 0;
+    for (; done + 32 <= len; done += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done));
+        __m256i hi = _mm256_shuffle_epi8(table,
+                                         _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble));
+        __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, lowNibble));
+        // Per lane: first and second halves of that lane's 16 bytes
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * done),
+                            _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * done + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return done;
+}
+
+namespace {
+
+inline __m256i Nibbles(__m256i c, __m256i& valid) {
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)),
+                                    _mm256_set1_epi8('a'));
+    __m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    valid = _mm256_or_si256(isDigit, isAlpha);
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digit),
+                           _mm256_and_si256(isAlpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+} // anonymous namespace
+
+size_t Decode(const char* in, size_t len, uint8_t* out) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    size_t done = 0;
+    for (; done + 32 <= len; done += 32) {
+        __m256i valid0, valid1;
+        __m256i n0 = Nibbles(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * done)), valid0);
+        __m256i n1 = Nibbles(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + 2 * done + 32)), valid1);
+        if (_mm256_movemask_epi8(_mm256_and_si256(valid0, valid1)) != -1) {
+            break;
+        }
+        __m256i packed = _mm256_packus_epi16(_mm256_maddubs_epi16(n0, weights),
+                                             _mm256_maddubs_epi16(n1, weights));
+        // Lanes came out as n0.low, n1.low, n0.high, n1.high
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done),
+                            _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return done;
+}
+
+} // namespace hex_avx2
+} // namespace shurium
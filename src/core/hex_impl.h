@@ -0,0 +1,43 @@
+// SHURIUM - Vectorized Hex Kernels
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Each kernel lives in its own file built with the ISA flags it needs and
+// is only called after the CPU is known to support them. Kernels handle
+// whole blocks and return how far they got; hex.cpp finishes the tail.
+
+#ifndef SHURIUM_CORE_HEX_IMPL_H
+#define SHURIUM_CORE_HEX_IMPL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shurium {
+
+/// Encode the leading whole blocks of in to out (two chars per byte);
+/// returns the number of input bytes encoded
+using HexEncodeFn = size_t (*)(const uint8_t* in, size_t len, char* out);
+
+/// Decode the leading whole blocks of 2 * len chars into out; returns the
+/// number of bytes decoded, stopping before the first block with a
+/// non-hex character
+using HexDecodeFn = size_t (*)(const char* in, size_t len, uint8_t* out);
+
+namespace hex_ssse3 {
+size_t Encode(const uint8_t* in, size_t len, char* out);
+size_t Decode(const char* in, size_t len, uint8_t* out);
+} // namespace hex_ssse3
+
+namespace hex_avx2 {
+size_t Encode(const uint8_t* in, size_t len, char* out);
+size_t Decode(const char* in, size_t len, uint8_t* out);
+} // namespace hex_avx2
+
+namespace hex_neon {
+size_t Encode(const uint8_t* in, size_t len, char* out);
+size_t Decode(const char* in, size_t len, uint8_t* out);
+} // namespace hex_neon
+
+} // namespace shurium
+
+#endif // SHURIUM_CORE_HEX_IMPL_H
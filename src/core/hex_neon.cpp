@@ -0,0 +1,59 @@
+// SHURIUM - Hex Encoding Using NEON
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Built on AArch64, where NEON is always present. 16 bytes per step:
+// TBL looks up the characters and ST2/LD2 interleave and split the
+// high and low nibble characters.
+
+#include "hex_impl.h"
+#include <arm_neon.h>
+
+namespace shurium {
+namespace hex_neon {
+
+size_t Encode(const uint8_t* in, size_t len, char* out) {
+    static const uint8_t CHARS[16] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                                      '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    const uint8x16_t table = vld1q_u8(CHARS);
+    size_t done = 0;
+    for (; done + 16 <= len; done += 16) {
+        uint8x16_t v = vld1q_u8(in + done);
+        uint8x16x2_t chars;
+        chars.val[0] = vqtbl1q_u8(table, vshrq_n_u8(v, 4));
+        chars.val[1] = vqtbl1q_u8(table, vandq_u8(v, vdupq_n_u8(0x0F)));
+        vst2q_u8(reinterpret_cast<uint8_t*>(out + 2 * done), chars);
+    }
+    return done;
+}
+
+namespace {
+
+inline uint8x16_t Nibbles(uint8x16_t c, uint8x16_t& valid) {
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t alpha = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isAlpha = vcleq_u8(alpha, vdupq_n_u8(5));
+    valid = vorrq_u8(isDigit, isAlpha);
+    return vbslq_u8(isDigit, digit, vaddq_u8(alpha, vdupq_n_u8(10)));
+}
+
+} // anonymous namespace
+
+size_t Decode(const char* in, size_t len, uint8_t* out) {
+    size_t done = 0;
+    for (; done + 16 <= len; done += 16) {
+        uint8x16x2_t chars = vld2q_u8(reinterpret_cast<const uint8_t*>(in + 2 * done));
+        uint8x16_t valid0, valid1;
+        uint8x16_t hi = Nibbles(chars.val[0], valid0);
+        uint8x16_t lo = Nibbles(chars.val[1], valid1);
+        if (vminvq_u8(vandq_u8(valid0, valid1)) != 0xFF) {
+            break;
+        }
+        vst1q_u8(out + done, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    return done;
+}
+
+} // namespace hex_neon
+} // namespace shurium
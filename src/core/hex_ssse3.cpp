@@ -0,0 +1,70 @@
+// SHURIUM - Hex Encoding Using SSSE3
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -mssse3 and only called after CPUID reports support.
+// 16 bytes per step: nibbles become characters through a PSHUFB table
+// lookup; characters are range-checked and turned back into nibbles with
+// unsigned min comparisons, then paired up with PMADDUBSW.
+
+#include "hex_impl.h"
+#include <immintrin.h>
+
+namespace shurium {
+namespace hex_ssse3 {
+
+size_t Encode(const uint8_t* in, size_t len, char* out) {
+    const __m128i table = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                        '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m128i lowNibble = _mm_set1_epi8(0x0F);
+    size_t done = 0;
+    for (; done + 16 <= len; done += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), lowNibble));
+        __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(v, lowNibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * done),
+                         _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * done + 16),
+                         _mm_unpackhi_epi8(hi, lo));
+    }
+    return done;
+}
+
+namespace {
+
+/// Nibble values of 16 characters; valid is all ones where a character
+/// is a hex digit
+inline __m128i Nibbles(__m128i c, __m128i& valid) {
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    valid = _mm_or_si128(isDigit, isAlpha);
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isAlpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+} // anonymous namespace
+
+size_t Decode(const char* in, size_t len, uint8_t* out) {
+    // High nibble times 16 plus low nibble, per pair of characters
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    size_t done = 0;
+    for (; done + 16 <= len; done += 16) {
+        __m128i valid0, valid1;
+        __m128i n0 = Nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * done)),
+                             valid0);
+        __m128i n1 = Nibbles(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * done + 16)), valid1);
+        if (_mm_movemask_epi8(_mm_and_si128(valid0, valid1)) != 0xFFFF) {
+            break;
+        }
+        __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(n0, weights),
+                                         _mm_maddubs_epi16(n1, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done), bytes);
+    }
+    return done;
+}
+
+} // namespace hex_ssse3
+} // namespace shurium
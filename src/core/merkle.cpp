@@ -12,13 +12,29 @@ namespace shurium {
 // Helper Functions
 // ============================================================================
 
+// Levels are hashed in place as one run of 64-byte messages
+static_assert(sizeof(Hash256) == 32, "Merkle levels must be contiguous 32-byte hashes");
+
 Hash256 HashPair(const Hash256& left, const Hash256& right) {
     uint8_t combined[64];
     std::memcpy(combined, left.data(), 32);
     std::memcpy(combined + 32, right.data(), 32);
-    return DoubleSHA256(combined, 64);
+    Hash256 result;
+    DoubleSHA256_64(result.data(), combined, 1);
+    return result;
+}
+
+namespace {
+
+/// Replace an even-sized level with the next level up
+void HashLevel(std::vector<Hash256>& hashes) {
+    size_t newSize = hashes.size() / 2;
+    DoubleSHA256_64(hashes[0].data(), hashes[0].data(), newSize);
+    hashes.resize(newSize);
 }
 
+} // anonymous namespace
+
 // ============================================================================
 // Merkle Root Computation
 // ============================================================================
@@ -55,11 +71,7 @@ Hash256 ComputeMerkleRoot(std::vector<Hash256> hashes, bool* mutated) {
         }
         
         // Compute next level
-        size_t newSize = hashes.size() / 2;
-        for (size_t i = 0; i < newSize; ++i) {
-            hashes[i] = HashPair(hashes[i * 2], hashes[i * 2 + 1]);
-        }
-        hashes.resize(newSize);
+        HashLevel(hashes);
     }
     
     if (mutated) *mutated = mutation;
@@ -100,11 +112,7 @@ std::vector<Hash256> ComputeMerklePath(const std::vector<Hash256>& leaves, uint3
         }
         
         // Compute next level
-        size_t newSize = hashes.size() / 2;
-        for (size_t i = 0; i < newSize; ++i) {
-            hashes[i] = HashPair(hashes[i * 2], hashes[i * 2 + 1]);
-        }
-        hashes.resize(newSize);
+        HashLevel(hashes);
         
         // Update position for next level
         pos /= 2;
@@ -113,8 +121,8 @@ std::vector<Hash256> ComputeMerklePath(const std::vector<Hash256>& leaves, uint3
     return proof;
 }
 
-bool VerifyMerkleProof(const Hash256& leaf, uint32_t position,
-                       const Hash256& root, const std::vector<Hash256>& proof) {
+Hash256 ComputeMerkleRootFromPath(const Hash256& leaf, uint32_t position,
+                                  const std::vector<Hash256>& proof) {
     Hash256 current = leaf;
     uint32_t pos = position;
     
@@ -130,7 +138,12 @@ bool VerifyMerkleProof(const Hash256& leaf, uint32_t position,
         pos /= 2;
     }
     
-    return current == root;
+    return current;
+}
+
+bool VerifyMerkleProof(const Hash256& leaf, uint32_t position,
+                       const Hash256& root, const std::vector<Hash256>& proof) {
+    return ComputeMerkleRootFromPath(leaf, position, proof) == root;
 }
 
 } // namespace shurium
@@ -3,9 +3,15 @@
 // MIT License
 
 #include "shurium/core/random.h"
+#include <atomic>
 #include <cstring>
+#include <mutex>
 #include <stdexcept>
 
+#if !defined(_WIN32)
+    #include <pthread.h>
+#endif
+
 // Platform-specific includes
 #if defined(__linux__)
     #include <sys/random.h>
@@ -51,25 +57,185 @@ bool GetOSEntropy(uint8_t* buf, size_t len) {
 #endif
 }
 
+namespace {
+
+inline uint32_t Rotl32(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+inline void QuarterRound(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+    a += b; d = Rotl32(d ^ a, 16);
+    c += d; b = Rotl32(b ^ c, 12);
+    a += b; d = Rotl32(d ^ a, 8);
+    c += d; b = Rotl32(b ^ c, 7);
+}
+
+inline void WriteLE32(uint8_t* out, uint32_t v) {
+    out[0] = static_cast<uint8_t>(v);
+    out[1] = static_cast<uint8_t>(v >> 8);
+    out[2] = static_cast<uint8_t>(v >> 16);
+    out[3] = static_cast<uint8_t>(v >> 24);
+}
+
+} // anonymous namespace
+
+void ChaCha20Block(const uint32_t key[8], uint64_t counter, uint64_t nonce, uint8_t out[64]) {
+    uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,  // "expand 32-byte k"
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+        static_cast<uint32_t>(nonce), static_cast<uint32_t>(nonce >> 32)};
+    uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    for (int i = 0; i < 10; ++i) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) {
+        WriteLE32(out + 4 * i, x[i] + input[i]);
+    }
+}
+
 void InitializeRNG() {
-    // For now, we rely solely on OS entropy which is self-seeding
-    // In a production system, we might add additional entropy sources:
-    // - Hardware RNG (RDRAND/RDSEED)
-    // - High-precision timestamps
-    // - Stack pointer
-    // - etc.
+    // Seeds the calling thread's generator, so a failing entropy source
+    // shows at startup rather than at the first random request
+    uint8_t dummy;
+    GetRandBytes(&dummy, 1);
 }
 
 } // namespace detail
 
+// ============================================================================
+// Per-Thread Generator
+// ============================================================================
+
+namespace {
+
+/// Bumped in the child after fork(), so threads there know to reseed
+std::atomic<uint64_t> g_forkGeneration{0};
+
+#if !defined(_WIN32)
+void OnForkChild() {
+    g_forkGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+/// Volatile writes, so wiping state that is about to die is not elided
+void Wipe(void* p, size_t len) {
+    volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+    while (len--) {
+        *v++ = 0;
+    }
+}
+
+/**
+ * ChaCha20 keystream with fast key erasure: each refill produces
+ * BUFFER_BLOCKS blocks, the first 32 bytes of which replace the key, and
+ * bytes are wiped from the buffer as they are handed out. Compromising the
+ * state therefore reveals nothing about output already returned.
+ */
+class ThreadRNG {
+public:
+    ThreadRNG() {
+#if !defined(_WIN32)
+        static std::once_flag atfork;
+        std::call_once(atfork, [] { pthread_atfork(nullptr, nullptr, OnForkChild); });
+#endif
+        Reseed();
+    }
+
+    ~ThreadRNG() {
+        Wipe(key_, sizeof(key_));
+        Wipe(buffer_, sizeof(buffer_));
+    }
+
+    ThreadRNG(const ThreadRNG&) = delete;
+    ThreadRNG& operator=(const ThreadRNG&) = delete;
+
+    void Fill(uint8_t* out, size_t len) {
+        if (forkGeneration_ != g_forkGeneration.load(std::memory_order_relaxed)) {
+            // The parent holds the same state: throw away what is buffered
+            Wipe(buffer_, sizeof(buffer_));
+            pos_ = sizeof(buffer_);
+            Reseed();
+        }
+        while (len > 0) {
+            if (pos_ == sizeof(buffer_)) {
+                Refill();
+            }
+            size_t n = std::min(len, sizeof(buffer_) - pos_);
+            std::memcpy(out, buffer_ + pos_, n);
+            Wipe(buffer_ + pos_, n);
+            pos_ += n;
+            out += n;
+            len -= n;
+        }
+    }
+
+private:
+    static constexpr size_t BUFFER_BLOCKS = 4;
+
+    void Reseed() {
+        uint32_t fresh[8];
+        if (!detail::GetOSEntropy(reinterpret_cast<uint8_t*>(fresh), sizeof(fresh))) {
+            throw std::runtime_error("Failed to get random bytes from OS");
+        }
+        // Mixed into, not replacing, the key: either being secret suffices
+        for (int i = 0; i < 8; ++i) {
+            key_[i] ^= fresh[i];
+        }
+        Wipe(fresh, sizeof(fresh));
+        sinceSeed_ = 0;
+        seededAt_ = std::chrono::steady_clock::now();
+        forkGeneration_ = g_forkGeneration.load(std::memory_order_relaxed);
+    }
+
+    void Refill() {
+        if (sinceSeed_ >= RNG_RESEED_BYTES ||
+            std::chrono::steady_clock::now() - seededAt_ >= RNG_RESEED_INTERVAL) {
+            Reseed();
+        }
+        for (size_t i = 0; i < BUFFER_BLOCKS; ++i) {
+            detail::ChaCha20Block(key_, i, 0, buffer_ + 64 * i);
+        }
+        std::memcpy(key_, buffer_, sizeof(key_));
+        Wipe(buffer_, sizeof(key_));
+        pos_ = sizeof(key_);
+        sinceSeed_ += sizeof(buffer_) - sizeof(key_);
+    }
+
+    uint32_t key_[8] = {};
+    uint8_t buffer_[BUFFER_BLOCKS * 64];
+    size_t pos_{sizeof(buffer_)};
+    uint64_t sinceSeed_{0};
+    std::chrono::steady_clock::time_point seededAt_;
+    uint64_t forkGeneration_{0};
+};
+
+ThreadRNG& GetThreadRNG() {
+    thread_local ThreadRNG rng;
+    return rng;
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // Core Random Functions
 // ============================================================================
 
 void GetRandBytes(uint8_t* buf, size_t len) {
+    if (len == 0) return;
+    GetThreadRNG().Fill(buf, len);
+}
+
+void GetStrongRandBytes(uint8_t* buf, size_t len) {
     if (!detail::GetOSEntropy(buf, len)) {
-        // In a production system, we might fall back to a software PRNG
-        // that was seeded earlier. For now, we throw an exception.
         throw std::runtime_error("Failed to get random bytes from OS");
     }
 }
@@ -118,4 +284,45 @@ Hash160 GetRandHash160() {
     return hash;
 }
 
+// ============================================================================
+// FastRandomContext
+// ============================================================================
+
+FastRandomContext::FastRandomContext() {
+    GetRandBytes(reinterpret_cast<uint8_t*>(s_), sizeof(s_));
+    if ((s_[0] | s_[1] | s_[2] | s_[3]) == 0) {
+        s_[0] = 1;  // The all-zero state is a fixed point
+    }
+}
+
+FastRandomContext::FastRandomContext(uint64_t seed) {
+    Seed(seed);
+}
+
+void FastRandomContext::Seed(uint64_t seed) {
+    // SplitMix64 spreads the seed over the whole state
+    for (auto& word : s_) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+uint64_t FastRandomContext::RandRange(uint64_t range) {
+    if (range == 0) return 0;
+    __extension__ typedef unsigned __int128 uint128;
+    // Lemire's multiply-shift, rejecting the few low products that would bias
+    uint128 m = static_cast<uint128>(Rand64()) * range;
+    uint64_t low = static_cast<uint64_t>(m);
+    if (low < range) {
+        uint64_t threshold = (0 - range) % range;
+        while (low < threshold) {
+            m = static_cast<uint128>(Rand64()) * range;
+            low = static_cast<uint64_t>(m);
+        }
+    }
+    return static_cast<uint64_t>(m >> 64);
+}
+
 } // namespace shurium
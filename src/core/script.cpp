@@ -154,13 +154,13 @@ std::string GetOpName(Opcode opcode) {
 // ScriptNum Implementation
 // ============================================================================
 
-ScriptNum::ScriptNum(const std::vector<uint8_t>& bytes, bool requireMinimal, size_t maxNumSize) {
+ScriptNum::ScriptNum(Span<const uint8_t> bytes, bool requireMinimal, size_t maxNumSize) {
     if (bytes.size() > maxNumSize) {
         throw ScriptNumError("script number overflow");
     }
     if (requireMinimal && !bytes.empty()) {
         // Check minimal encoding
-        if ((bytes.back() & 0x7f) == 0) {
+        if ((bytes[bytes.size() - 1] & 0x7f) == 0) {
             if (bytes.size() <= 1 || (bytes[bytes.size() - 2] & 0x80) == 0) {
                 throw ScriptNumError("non-minimally encoded script number");
             }
@@ -184,30 +184,35 @@ std::vector<uint8_t> ScriptNum::GetBytes() const {
 }
 
 std::vector<uint8_t> ScriptNum::Serialize(int64_t value) {
+    uint8_t buf[MAX_SERIALIZED_SIZE];
+    return std::vector<uint8_t>(buf, buf + Serialize(value, buf));
+}
+
+size_t ScriptNum::Serialize(int64_t value, uint8_t* out) {
     if (value == 0) {
-        return {};
+        return 0;
     }
     
-    std::vector<uint8_t> result;
+    size_t len = 0;
     const bool neg = value < 0;
     uint64_t absvalue = neg ? ~static_cast<uint64_t>(value) + 1 : static_cast<uint64_t>(value);
     
     while (absvalue) {
-        result.push_back(absvalue & 0xff);
+        out[len++] = absvalue & 0xff;
         absvalue >>= 8;
     }
     
     // If MSB >= 0x80, add sign byte
-    if (result.back() & 0x80) {
-        result.push_back(neg ? 0x80 : 0x00);
+    if (out[len - 1] & 0x80) {
+        out[len++] = neg ? 0x80 : 0x00;
     } else if (neg) {
-        result.back() |= 0x80;
+        out[len - 1] |= 0x80;
     }
     
-    return result;
+    return len;
 }
 
-int64_t ScriptNum::SetBytes(const std::vector<uint8_t>& bytes) {
+int64_t ScriptNum::SetBytes(Span<const uint8_t> bytes) {
     if (bytes.empty()) {
         return 0;
     }
@@ -218,7 +223,7 @@ int64_t ScriptNum::SetBytes(const std::vector<uint8_t>& bytes) {
     }
     
     // Check sign bit
-    if (bytes.back() & 0x80) {
+    if (bytes[bytes.size() - 1] & 0x80) {
         return -(static_cast<int64_t>(result & ~(0x80ULL << (8 * (bytes.size() - 1)))));
     }
     
@@ -229,6 +234,24 @@ int64_t ScriptNum::SetBytes(const std::vector<uint8_t>& bytes) {
 // Script Implementation
 // ============================================================================
 
+namespace {
+
+/// Sigops counted for opcode, given the opcode before it
+unsigned int SigOpsOf(Opcode opcode, Opcode lastOpcode, bool accurate) {
+    if (opcode == OP_CHECKSIG || opcode == OP_CHECKSIGVERIFY) {
+        return 1;
+    }
+    if (opcode == OP_CHECKMULTISIG || opcode == OP_CHECKMULTISIGVERIFY) {
+        if (accurate && lastOpcode >= OP_1 && lastOpcode <= OP_16) {
+            return Script::DecodeOP_N(lastOpcode);
+        }
+        return MAX_PUBKEYS_PER_MULTISIG;
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
 void Script::AppendDataSize(uint32_t size) {
     if (size < OP_PUSHDATA1) {
         push_back(static_cast<uint8_t>(size));
@@ -291,10 +314,11 @@ Script& Script::operator<<(const Hash256& hash) {
     return *this;
 }
 
-bool Script::GetOp(const_iterator& pc, Opcode& opcodeRet, std::vector<uint8_t>& dataRet) const {
-    dataRet.clear();
+bool GetScriptOp(const uint8_t*& pc, const uint8_t* end, Opcode& opcodeRet,
+                 Span<const uint8_t>& dataRet) {
+    dataRet = Span<const uint8_t>();
     
-    if (pc >= end()) {
+    if (pc >= end) {
         return false;
     }
     
@@ -308,31 +332,45 @@ bool Script::GetOp(const_iterator& pc, Opcode& opcodeRet, std::vector<uint8_t>&
         if (opcode < OP_PUSHDATA1) {
             nSize = opcode;
         } else if (opcode == OP_PUSHDATA1) {
-            if (pc >= end()) return false;
+            if (pc >= end) return false;
             nSize = *pc++;
         } else if (opcode == OP_PUSHDATA2) {
-            if (pc + 2 > end()) return false;
+            if (end - pc < 2) return false;
             nSize = pc[0] | (pc[1] << 8);
             pc += 2;
         } else if (opcode == OP_PUSHDATA4) {
-            if (pc + 4 > end()) return false;
-            nSize = pc[0] | (pc[1] << 8) | (pc[2] << 16) | (pc[3] << 24);
+            if (end - pc < 4) return false;
+            nSize = pc[0] | (pc[1] << 8) | (pc[2] << 16) | (static_cast<uint32_t>(pc[3]) << 24);
             pc += 4;
         }
         
-        if (pc + nSize > end()) {
+        if (static_cast<size_t>(end - pc) < nSize) {
             return false;
         }
         
-        dataRet.assign(pc, pc + nSize);
+        dataRet = Span<const uint8_t>(pc, nSize);
         pc += nSize;
     }
     
     return true;
 }
 
+bool Script::GetOp(const_iterator& pc, Opcode& opcodeRet, Span<const uint8_t>& dataRet) const {
+    const uint8_t* p = data() + (pc - begin());
+    bool ok = GetScriptOp(p, data() + size(), opcodeRet, dataRet);
+    pc = begin() + (p - data());
+    return ok;
+}
+
+bool Script::GetOp(const_iterator& pc, Opcode& opcodeRet, std::vector<uint8_t>& dataRet) const {
+    Span<const uint8_t> data;
+    bool ok = GetOp(pc, opcodeRet, data);
+    dataRet.assign(data.begin(), data.end());
+    return ok;
+}
+
 bool Script::GetOp(const_iterator& pc, Opcode& opcodeRet) const {
-    std::vector<uint8_t> data;
+    Span<const uint8_t> data;
     return GetOp(pc, opcodeRet, data);
 }
 
@@ -418,16 +456,7 @@ unsigned int Script::GetSigOpCount(bool accurate) const {
             break;
         }
         
-        if (opcode == OP_CHECKSIG || opcode == OP_CHECKSIGVERIFY) {
-            n++;
-        } else if (opcode == OP_CHECKMULTISIG || opcode == OP_CHECKMULTISIGVERIFY) {
-            if (accurate && lastOpcode >= OP_1 && lastOpcode <= OP_16) {
-                n += DecodeOP_N(lastOpcode);
-            } else {
-                n += MAX_PUBKEYS_PER_MULTISIG;
-            }
-        }
-        
+        n += SigOpsOf(opcode, lastOpcode, accurate);
         lastOpcode = opcode;
     }
     
@@ -500,4 +529,63 @@ std::string Script::ToString() const {
     return oss.str();
 }
 
+// ============================================================================
+// DecodedScript Implementation
+// ============================================================================
+
+DecodedScript::DecodedScript(const Script& script)
+    : data_(script.data()), size_(script.size()) {
+    const uint8_t* begin = script.data();
+    const uint8_t* pc = begin;
+    const uint8_t* end = begin + script.size();
+    while (pc < end) {
+        Opcode opcode;
+        Span<const uint8_t> data;
+        if (!GetScriptOp(pc, end, opcode, data)) {
+            truncated_ = true;
+            break;
+        }
+        ScriptOp op;
+        op.opcode = opcode;
+        op.dataOffset = data.empty() ? 0 : static_cast<uint32_t>(data.data() - begin);
+        op.dataSize = static_cast<uint32_t>(data.size());
+        op.end = static_cast<uint32_t>(pc - begin);
+        ops_.push_back(op);
+    }
+}
+
+bool DecodedScript::IsPushOnly() const {
+    if (truncated_) {
+        return false;
+    }
+    for (const ScriptOp& op : ops_) {
+        if (op.opcode > OP_16) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DecodedScript::HasValidOps() const {
+    if (truncated_) {
+        return false;
+    }
+    for (const ScriptOp& op : ops_) {
+        if (op.opcode > OP_NOP10 && op.opcode != OP_INVALIDOPCODE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned int DecodedScript::GetSigOpCount(bool accurate) const {
+    unsigned int n = 0;
+    Opcode lastOpcode = OP_INVALIDOPCODE;
+    for (const ScriptOp& op : ops_) {
+        n += SigOpsOf(op.opcode, lastOpcode, accurate);
+        lastOpcode = op.opcode;
+    }
+    return n;
+}
+
 } // namespace shurium
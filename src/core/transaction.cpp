@@ -87,14 +87,11 @@ MutableTransaction::MutableTransaction(const Transaction& tx)
     : vin(tx.vin), vout(tx.vout), version(tx.version), nLockTime(tx.nLockTime) {}
 
 TxHash MutableTransaction::GetHash() const {
-    // Serialize the transaction
-    DataStream ss;
+    // Double SHA256 (like Bitcoin) of the serialization, streamed into the
+    // hasher rather than built up in a growing buffer
+    HashWriter ss;
     Serialize(ss, *this);
-    
-    // Double SHA256 (like Bitcoin)
-    Hash256 hash = DoubleSHA256(ss.data(), ss.TotalSize());
-    
-    return TxHash(hash);
+    return TxHash(ss.GetHash());
 }
 
 Amount MutableTransaction::GetValueOut() const {
@@ -115,6 +112,35 @@ size_t MutableTransaction::GetTotalSize() const {
     return GetSerializeSize(*this);
 }
 
+// ============================================================================
+// TransactionScriptCache Implementation
+// ============================================================================
+
+const TransactionScriptCache::Entries& TransactionScriptCache::Get(
+    const std::vector<TxIn>& vin, const std::vector<TxOut>& vout) const {
+    const Entries* entries = entries_.load(std::memory_order_acquire);
+    if (entries) {
+        return *entries;
+    }
+    
+    auto built = std::make_unique<Entries>();
+    built->scriptSigs.reserve(vin.size());
+    for (const auto& txin : vin) {
+        built->scriptSigs.emplace_back(txin.scriptSig);
+    }
+    built->scriptPubKeys.reserve(vout.size());
+    for (const auto& txout : vout) {
+        built->scriptPubKeys.emplace_back(txout.scriptPubKey);
+    }
+    
+    // Publish ours unless another thread got there first
+    if (entries_.compare_exchange_strong(entries, built.get(), std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+        return *built.release();
+    }
+    return *entries;
+}
+
 // ============================================================================
 // Transaction Implementation
 // ============================================================================
@@ -124,24 +150,21 @@ Transaction::Transaction(const MutableTransaction& tx)
       vout(tx.vout),
       version(tx.version),
       nLockTime(tx.nLockTime),
-      hash(ComputeHash()) {}
+      hash(ComputeHash()),
+      totalSize(static_cast<uint32_t>(GetSerializeSize(*this))) {}
 
 Transaction::Transaction(MutableTransaction&& tx)
     : vin(std::move(tx.vin)),
       vout(std::move(tx.vout)),
       version(tx.version),
       nLockTime(tx.nLockTime),
-      hash(ComputeHash()) {}
+      hash(ComputeHash()),
+      totalSize(static_cast<uint32_t>(GetSerializeSize(*this))) {}
 
 TxHash Transaction::ComputeHash() const {
-    // Serialize the transaction
-    DataStream ss;
+    HashWriter ss;
     Serialize(ss, *this);
-    
-    // Double SHA256 (like Bitcoin)
-    Hash256 hash = DoubleSHA256(ss.data(), ss.TotalSize());
-    
-    return TxHash(hash);
+    return TxHash(ss.GetHash());
 }
 
 Amount Transaction::GetValueOut() const {
@@ -158,10 +181,6 @@ Amount Transaction::GetValueOut() const {
     return total;
 }
 
-size_t Transaction::GetTotalSize() const {
-    return GetSerializeSize(*this);
-}
-
 std::string Transaction::ToString() const {
     std::ostringstream ss;
     ss << "Transaction(\n";
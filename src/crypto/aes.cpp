@@ -2,14 +2,27 @@
 // Copyright (c) 2024 SHURIUM Developers
 // MIT License
 //
-// AES-128/192/256 with CBC and CTR modes.
-// Uses OpenSSL when available, pure C++ fallback otherwise.
+// AES-128/192/256 with CBC and CTR modes. The block kernels are chosen at
+// runtime: AES-NI or the ARMv8 cryptography extensions when the CPU has
+// them, table-based C++ otherwise (with OpenSSL's EVP taking over the
+// streaming modes in that case, when available).
 
 #include "shurium/crypto/aes.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <random>
 #include <stdexcept>
 
+#if defined(SHURIUM_AES_NI)
+#include <cpuid.h>
+#endif
+
+#if defined(SHURIUM_AES_ARMV8) && !defined(__APPLE__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
 #ifdef SHURIUM_USE_OPENSSL
 #include <openssl/evp.h>
 #include <openssl/rand.h>
@@ -68,14 +81,12 @@ static const uint8_t RCON[11] = {
     0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
 };
 
-// GF(2^8) multiplication
+// GF(2^8) multiplication, with no branch or table lookup on either operand
 inline uint8_t GfMul(uint8_t a, uint8_t b) {
     uint8_t result = 0;
-    while (b) {
-        if (b & 1) result ^= a;
-        bool hiBit = (a & 0x80) != 0;
-        a <<= 1;
-        if (hiBit) a ^= 0x1b;  // x^8 + x^4 + x^3 + x + 1
+    for (int i = 0; i < 8; ++i) {
+        result ^= a & static_cast<uint8_t>(-(b & 1));
+        a = static_cast<uint8_t>((a << 1) ^ (0x1b & -(a >> 7)));  // x^8 + x^4 + x^3 + x + 1
         b >>= 1;
     }
     return result;
@@ -87,122 +98,46 @@ inline void SecureClear(void* ptr, size_t len) {
     while (len--) *p++ = 0;
 }
 
-} // anonymous namespace
-
-// ============================================================================
-// AESContext Implementation
-// ============================================================================
-
-AESContext::AESContext(const Byte* key, size_t keyLen) {
-    if (keyLen != 16 && keyLen != 24 && keyLen != 32) {
-        throw std::invalid_argument("AES key must be 16, 24, or 32 bytes");
-    }
-    
-    switch (keyLen) {
-        case 16: keySize_ = AESKeySize::AES_128; rounds_ = 10; break;
-        case 24: keySize_ = AESKeySize::AES_192; rounds_ = 12; break;
-        case 32: keySize_ = AESKeySize::AES_256; rounds_ = 14; break;
-        default: throw std::invalid_argument("Invalid key length");
-    }
-    
-    ExpandKey(key, keyLen);
+inline uint32_t ReadBE32(const Byte* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
 }
 
-AESContext::~AESContext() {
-    if (!encKey_.empty()) {
-        SecureClear(encKey_.data(), encKey_.size() * sizeof(uint32_t));
-    }
-    if (!decKey_.empty()) {
-        SecureClear(decKey_.data(), decKey_.size() * sizeof(uint32_t));
-    }
+inline void WriteBE32(Byte* p, uint32_t v) {
+    p[0] = static_cast<Byte>(v >> 24);
+    p[1] = static_cast<Byte>(v >> 16);
+    p[2] = static_cast<Byte>(v >> 8);
+    p[3] = static_cast<Byte>(v);
 }
 
-AESContext::AESContext(AESContext&& other) noexcept
-    : encKey_(std::move(other.encKey_))
-    , decKey_(std::move(other.decKey_))
-    , keySize_(other.keySize_)
-    , rounds_(other.rounds_) {
+/// Word i of a byte round-key schedule, first byte most significant
+inline uint32_t RoundKeyWord(const Byte* rk, int i) {
+    return ReadBE32(rk + 4 * i);
 }
 
-AESContext& AESContext::operator=(AESContext&& other) noexcept {
-    if (this != &other) {
-        if (!encKey_.empty()) {
-            SecureClear(encKey_.data(), encKey_.size() * sizeof(uint32_t));
-        }
-        if (!decKey_.empty()) {
-            SecureClear(decKey_.data(), decKey_.size() * sizeof(uint32_t));
-        }
-        encKey_ = std::move(other.encKey_);
-        decKey_ = std::move(other.decKey_);
-        keySize_ = other.keySize_;
-        rounds_ = other.rounds_;
+/// Add one to a 128-bit big-endian counter
+inline void IncrementCounter(Byte counter[aes::BLOCK_SIZE]) {
+    for (int i = aes::BLOCK_SIZE - 1; i >= 0; --i) {
+        if (++counter[i] != 0) break;
     }
-    return *this;
 }
 
-void AESContext::ExpandKey(const Byte* key, size_t keyLen) {
-    int Nk = static_cast<int>(keyLen / 4);  // Key length in 32-bit words
-    int Nr = rounds_;
-    int Nb = 4;  // Block size in words (always 4 for AES)
-    
-    encKey_.resize(Nb * (Nr + 1));
-    
-    // Copy key to first Nk words
-    for (int i = 0; i < Nk; ++i) {
-        encKey_[i] = (static_cast<uint32_t>(key[4*i]) << 24) |
-                     (static_cast<uint32_t>(key[4*i+1]) << 16) |
-                     (static_cast<uint32_t>(key[4*i+2]) << 8) |
-                     static_cast<uint32_t>(key[4*i+3]);
-    }
-    
-    // Expand key
-    for (int i = Nk; i < Nb * (Nr + 1); ++i) {
-        uint32_t temp = encKey_[i - 1];
-        if (i % Nk == 0) {
-            // RotWord + SubWord + Rcon
-            temp = ((static_cast<uint32_t>(SBOX[(temp >> 16) & 0xff]) << 24) |
-                    (static_cast<uint32_t>(SBOX[(temp >> 8) & 0xff]) << 16) |
-                    (static_cast<uint32_t>(SBOX[temp & 0xff]) << 8) |
-                    static_cast<uint32_t>(SBOX[(temp >> 24) & 0xff])) ^
-                   (static_cast<uint32_t>(RCON[i / Nk]) << 24);
-        } else if (Nk > 6 && i % Nk == 4) {
-            // SubWord only for AES-256
-            temp = (static_cast<uint32_t>(SBOX[(temp >> 24) & 0xff]) << 24) |
-                   (static_cast<uint32_t>(SBOX[(temp >> 16) & 0xff]) << 16) |
-                   (static_cast<uint32_t>(SBOX[(temp >> 8) & 0xff]) << 8) |
-                   static_cast<uint32_t>(SBOX[temp & 0xff]);
-        }
-        encKey_[i] = encKey_[i - Nk] ^ temp;
-    }
-    
-    // Generate decryption key schedule (inverse)
-    decKey_.resize(encKey_.size());
-    for (int i = 0; i <= Nr; ++i) {
-        for (int j = 0; j < Nb; ++j) {
-            decKey_[i * Nb + j] = encKey_[(Nr - i) * Nb + j];
-        }
-    }
-    
-    // Apply InvMixColumns to all round keys except first and last
-    for (int i = 1; i < Nr; ++i) {
-        for (int j = 0; j < Nb; ++j) {
-            uint32_t w = decKey_[i * Nb + j];
-            uint8_t b0 = (w >> 24) & 0xff;
-            uint8_t b1 = (w >> 16) & 0xff;
-            uint8_t b2 = (w >> 8) & 0xff;
-            uint8_t b3 = w & 0xff;
-            
-            decKey_[i * Nb + j] = 
-                (static_cast<uint32_t>(GfMul(0x0e, b0) ^ GfMul(0x0b, b1) ^ GfMul(0x0d, b2) ^ GfMul(0x09, b3)) << 24) |
-                (static_cast<uint32_t>(GfMul(0x09, b0) ^ GfMul(0x0e, b1) ^ GfMul(0x0b, b2) ^ GfMul(0x0d, b3)) << 16) |
-                (static_cast<uint32_t>(GfMul(0x0d, b0) ^ GfMul(0x09, b1) ^ GfMul(0x0e, b2) ^ GfMul(0x0b, b3)) << 8) |
-                static_cast<uint32_t>(GfMul(0x0b, b0) ^ GfMul(0x0d, b1) ^ GfMul(0x09, b2) ^ GfMul(0x0e, b3));
-        }
-    }
+// ============================================================================
+// Portable Kernels
+// ============================================================================
+
+// The table lookups index memory by secret state, so this path is not
+// constant-time; it is only used where no AES instructions exist.
+
+uint32_t SubWordScalar(uint32_t w) {
+    return (static_cast<uint32_t>(SBOX[(w >> 24) & 0xff]) << 24) |
+           (static_cast<uint32_t>(SBOX[(w >> 16) & 0xff]) << 16) |
+           (static_cast<uint32_t>(SBOX[(w >> 8) & 0xff]) << 8) |
+           static_cast<uint32_t>(SBOX[w & 0xff]);
 }
 
-void AESContext::EncryptBlock(const Byte input[aes::BLOCK_SIZE], 
-                               Byte output[aes::BLOCK_SIZE]) const {
+void EncryptBlockScalar(const Byte* rk, int rounds, const Byte input[aes::BLOCK_SIZE],
+                        Byte output[aes::BLOCK_SIZE]) {
     uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
     
     // Load input and add initial round key
@@ -215,10 +150,10 @@ void AESContext::EncryptBlock(const Byte input[aes::BLOCK_SIZE],
     s3 = (static_cast<uint32_t>(input[12]) << 24) | (static_cast<uint32_t>(input[13]) << 16) |
          (static_cast<uint32_t>(input[14]) << 8) | static_cast<uint32_t>(input[15]);
     
-    s0 ^= encKey_[0]; s1 ^= encKey_[1]; s2 ^= encKey_[2]; s3 ^= encKey_[3];
+    s0 ^= RoundKeyWord(rk, 0); s1 ^= RoundKeyWord(rk, 1); s2 ^= RoundKeyWord(rk, 2); s3 ^= RoundKeyWord(rk, 3);
     
     // Main rounds
-    for (int round = 1; round < rounds_; ++round) {
+    for (int round = 1; round < rounds; ++round) {
         // SubBytes + ShiftRows + MixColumns combined
         t0 = (static_cast<uint32_t>(GfMul(2, SBOX[(s0 >> 24) & 0xff]) ^ GfMul(3, SBOX[(s1 >> 16) & 0xff]) ^ SBOX[(s2 >> 8) & 0xff] ^ SBOX[s3 & 0xff]) << 24) |
              (static_cast<uint32_t>(SBOX[(s0 >> 24) & 0xff] ^ GfMul(2, SBOX[(s1 >> 16) & 0xff]) ^ GfMul(3, SBOX[(s2 >> 8) & 0xff]) ^ SBOX[s3 & 0xff]) << 16) |
@@ -240,10 +175,10 @@ void AESContext::EncryptBlock(const Byte input[aes::BLOCK_SIZE],
              (static_cast<uint32_t>(SBOX[(s3 >> 24) & 0xff] ^ SBOX[(s0 >> 16) & 0xff] ^ GfMul(2, SBOX[(s1 >> 8) & 0xff]) ^ GfMul(3, SBOX[s2 & 0xff])) << 8) |
              static_cast<uint32_t>(GfMul(3, SBOX[(s3 >> 24) & 0xff]) ^ SBOX[(s0 >> 16) & 0xff] ^ SBOX[(s1 >> 8) & 0xff] ^ GfMul(2, SBOX[s2 & 0xff]));
         
-        s0 = t0 ^ encKey_[round * 4];
-        s1 = t1 ^ encKey_[round * 4 + 1];
-        s2 = t2 ^ encKey_[round * 4 + 2];
-        s3 = t3 ^ encKey_[round * 4 + 3];
+        s0 = t0 ^ RoundKeyWord(rk, round * 4);
+        s1 = t1 ^ RoundKeyWord(rk, round * 4 + 1);
+        s2 = t2 ^ RoundKeyWord(rk, round * 4 + 2);
+        s3 = t3 ^ RoundKeyWord(rk, round * 4 + 3);
     }
     
     // Final round (no MixColumns)
@@ -264,10 +199,10 @@ void AESContext::EncryptBlock(const Byte input[aes::BLOCK_SIZE],
          (static_cast<uint32_t>(SBOX[(s1 >> 8) & 0xff]) << 8) |
          static_cast<uint32_t>(SBOX[s2 & 0xff]);
     
-    s0 = t0 ^ encKey_[rounds_ * 4];
-    s1 = t1 ^ encKey_[rounds_ * 4 + 1];
-    s2 = t2 ^ encKey_[rounds_ * 4 + 2];
-    s3 = t3 ^ encKey_[rounds_ * 4 + 3];
+    s0 = t0 ^ RoundKeyWord(rk, rounds * 4);
+    s1 = t1 ^ RoundKeyWord(rk, rounds * 4 + 1);
+    s2 = t2 ^ RoundKeyWord(rk, rounds * 4 + 2);
+    s3 = t3 ^ RoundKeyWord(rk, rounds * 4 + 3);
     
     // Store output
     output[0] = (s0 >> 24) & 0xff; output[1] = (s0 >> 16) & 0xff;
@@ -280,8 +215,8 @@ void AESContext::EncryptBlock(const Byte input[aes::BLOCK_SIZE],
     output[14] = (s3 >> 8) & 0xff; output[15] = s3 & 0xff;
 }
 
-void AESContext::DecryptBlock(const Byte input[aes::BLOCK_SIZE],
-                               Byte output[aes::BLOCK_SIZE]) const {
+void DecryptBlockScalar(const Byte* rk, int rounds, const Byte input[aes::BLOCK_SIZE],
+                        Byte output[aes::BLOCK_SIZE]) {
     uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
     
     // Load input and add initial round key
@@ -294,10 +229,10 @@ void AESContext::DecryptBlock(const Byte input[aes::BLOCK_SIZE],
     s3 = (static_cast<uint32_t>(input[12]) << 24) | (static_cast<uint32_t>(input[13]) << 16) |
          (static_cast<uint32_t>(input[14]) << 8) | static_cast<uint32_t>(input[15]);
     
-    s0 ^= decKey_[0]; s1 ^= decKey_[1]; s2 ^= decKey_[2]; s3 ^= decKey_[3];
+    s0 ^= RoundKeyWord(rk, 0); s1 ^= RoundKeyWord(rk, 1); s2 ^= RoundKeyWord(rk, 2); s3 ^= RoundKeyWord(rk, 3);
     
     // Main rounds (inverse operations)
-    for (int round = 1; round < rounds_; ++round) {
+    for (int round = 1; round < rounds; ++round) {
         // InvSubBytes + InvShiftRows + InvMixColumns
         t0 = (static_cast<uint32_t>(GfMul(0x0e, INV_SBOX[(s0 >> 24) & 0xff]) ^ GfMul(0x0b, INV_SBOX[(s3 >> 16) & 0xff]) ^ GfMul(0x0d, INV_SBOX[(s2 >> 8) & 0xff]) ^ GfMul(0x09, INV_SBOX[s1 & 0xff])) << 24) |
              (static_cast<uint32_t>(GfMul(0x09, INV_SBOX[(s0 >> 24) & 0xff]) ^ GfMul(0x0e, INV_SBOX[(s3 >> 16) & 0xff]) ^ GfMul(0x0b, INV_SBOX[(s2 >> 8) & 0xff]) ^ GfMul(0x0d, INV_SBOX[s1 & 0xff])) << 16) |
@@ -319,10 +254,10 @@ void AESContext::DecryptBlock(const Byte input[aes::BLOCK_SIZE],
              (static_cast<uint32_t>(GfMul(0x0d, INV_SBOX[(s3 >> 24) & 0xff]) ^ GfMul(0x09, INV_SBOX[(s2 >> 16) & 0xff]) ^ GfMul(0x0e, INV_SBOX[(s1 >> 8) & 0xff]) ^ GfMul(0x0b, INV_SBOX[s0 & 0xff])) << 8) |
              static_cast<uint32_t>(GfMul(0x0b, INV_SBOX[(s3 >> 24) & 0xff]) ^ GfMul(0x0d, INV_SBOX[(s2 >> 16) & 0xff]) ^ GfMul(0x09, INV_SBOX[(s1 >> 8) & 0xff]) ^ GfMul(0x0e, INV_SBOX[s0 & 0xff]));
         
-        s0 = t0 ^ decKey_[round * 4];
-        s1 = t1 ^ decKey_[round * 4 + 1];
-        s2 = t2 ^ decKey_[round * 4 + 2];
-        s3 = t3 ^ decKey_[round * 4 + 3];
+        s0 = t0 ^ RoundKeyWord(rk, round * 4);
+        s1 = t1 ^ RoundKeyWord(rk, round * 4 + 1);
+        s2 = t2 ^ RoundKeyWord(rk, round * 4 + 2);
+        s3 = t3 ^ RoundKeyWord(rk, round * 4 + 3);
     }
     
     // Final round (no InvMixColumns)
@@ -343,10 +278,10 @@ void AESContext::DecryptBlock(const Byte input[aes::BLOCK_SIZE],
          (static_cast<uint32_t>(INV_SBOX[(s1 >> 8) & 0xff]) << 8) |
          static_cast<uint32_t>(INV_SBOX[s0 & 0xff]);
     
-    s0 = t0 ^ decKey_[rounds_ * 4];
-    s1 = t1 ^ decKey_[rounds_ * 4 + 1];
-    s2 = t2 ^ decKey_[rounds_ * 4 + 2];
-    s3 = t3 ^ decKey_[rounds_ * 4 + 3];
+    s0 = t0 ^ RoundKeyWord(rk, rounds * 4);
+    s1 = t1 ^ RoundKeyWord(rk, rounds * 4 + 1);
+    s2 = t2 ^ RoundKeyWord(rk, rounds * 4 + 2);
+    s3 = t3 ^ RoundKeyWord(rk, rounds * 4 + 3);
     
     // Store output
     output[0] = (s0 >> 24) & 0xff; output[1] = (s0 >> 16) & 0xff;
@@ -359,25 +294,525 @@ void AESContext::DecryptBlock(const Byte input[aes::BLOCK_SIZE],
     output[14] = (s3 >> 8) & 0xff; output[15] = s3 & 0xff;
 }
 
+void EncryptScalar(const Byte* rk, int rounds, const Byte* in, Byte* out, size_t blocks) {
+    for (; blocks > 0; --blocks, in += aes::BLOCK_SIZE, out += aes::BLOCK_SIZE) {
+        EncryptBlockScalar(rk, rounds, in, out);
+    }
+}
+
+void DecryptScalar(const Byte* rk, int rounds, const Byte* in, Byte* out, size_t blocks) {
+    for (; blocks > 0; --blocks, in += aes::BLOCK_SIZE, out += aes::BLOCK_SIZE) {
+        DecryptBlockScalar(rk, rounds, in, out);
+    }
+}
+
+void EncryptCBCScalar(const Byte* rk, int rounds, Byte* iv, const Byte* in, Byte* out,
+                      size_t blocks) {
+    for (; blocks > 0; --blocks, in += aes::BLOCK_SIZE, out += aes::BLOCK_SIZE) {
+        Byte block[aes::BLOCK_SIZE];
+        for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
+            block[j] = in[j] ^ iv[j];
+        }
+        EncryptBlockScalar(rk, rounds, block, iv);
+        std::memcpy(out, iv, aes::BLOCK_SIZE);
+    }
+}
+
+void DecryptCBCScalar(const Byte* rk, int rounds, Byte* iv, const Byte* in, Byte* out,
+                      size_t blocks) {
+    for (; blocks > 0; --blocks, in += aes::BLOCK_SIZE, out += aes::BLOCK_SIZE) {
+        // Keep the ciphertext before writing, in case in == out
+        Byte cipher[aes::BLOCK_SIZE], plain[aes::BLOCK_SIZE];
+        std::memcpy(cipher, in, aes::BLOCK_SIZE);
+        DecryptBlockScalar(rk, rounds, cipher, plain);
+        for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
+            out[j] = plain[j] ^ iv[j];
+        }
+        std::memcpy(iv, cipher, aes::BLOCK_SIZE);
+        SecureClear(plain, sizeof(plain));
+    }
+}
+
+void CTRScalar(const Byte* rk, int rounds, Byte* counter, const Byte* in, Byte* out,
+               size_t blocks) {
+    Byte keystream[aes::BLOCK_SIZE];
+    for (; blocks > 0; --blocks, in += aes::BLOCK_SIZE, out += aes::BLOCK_SIZE) {
+        EncryptBlockScalar(rk, rounds, counter, keystream);
+        IncrementCounter(counter);
+        for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
+            out[j] = in[j] ^ keystream[j];
+        }
+    }
+    SecureClear(keystream, sizeof(keystream));
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Kernel Dispatch
+// ============================================================================
+
+#if defined(SHURIUM_AES_NI)
+namespace aes_ni {
+uint32_t SubWord(uint32_t w);
+void Encrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks);
+void Decrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks);
+void EncryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks);
+void DecryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks);
+void CTR(const Byte* roundKeys, int rounds, Byte* counter, const Byte* in, Byte* out,
+         size_t blocks);
+}
+#endif
+
+#if defined(SHURIUM_AES_ARMV8)
+namespace aes_armv8 {
+uint32_t SubWord(uint32_t w);
+void Encrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks);
+void Decrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks);
+void EncryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks);
+void DecryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks);
+void CTR(const Byte* roundKeys, int rounds, Byte* counter, const Byte* in, Byte* out,
+         size_t blocks);
+}
+#endif
+
+namespace {
+
+using SubWordFn = uint32_t (*)(uint32_t w);
+using BlocksFn = void (*)(const Byte* roundKeys, int rounds, const Byte* in, Byte* out,
+                          size_t blocks);
+using ChainFn = void (*)(const Byte* roundKeys, int rounds, Byte* chain, const Byte* in,
+                         Byte* out, size_t blocks);
+
+/// One backend's primitives; round keys are always in cipher byte order
+struct Kernels {
+    SubWordFn subWord;
+    BlocksFn encrypt;
+    BlocksFn decrypt;
+    ChainFn encryptCBC;
+    ChainFn decryptCBC;
+    ChainFn ctr;
+};
+
+constexpr Kernels SCALAR_KERNELS = {
+    SubWordScalar, EncryptScalar, DecryptScalar, EncryptCBCScalar, DecryptCBCScalar, CTRScalar
+};
+
+#if defined(SHURIUM_AES_NI)
+constexpr Kernels AESNI_KERNELS = {
+    aes_ni::SubWord, aes_ni::Encrypt, aes_ni::Decrypt,
+    aes_ni::EncryptCBC, aes_ni::DecryptCBC, aes_ni::CTR
+};
+
+bool CPUHasAESNI() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    // The counter setup uses an SSSE3 shuffle
+    return (ecx & bit_AES) != 0 && (ecx & bit_SSSE3) != 0 && (ecx & bit_SSE4_1) != 0;
+}
+#endif
+
+#if defined(SHURIUM_AES_ARMV8)
+constexpr Kernels ARMV8_KERNELS = {
+    aes_armv8::SubWord, aes_armv8::Encrypt, aes_armv8::Decrypt,
+    aes_armv8::EncryptCBC, aes_armv8::DecryptCBC, aes_armv8::CTR
+};
+
+bool CPUHasARMv8AES() {
+#if defined(__APPLE__)
+    // Every Apple ARM64 core has the cryptography extensions
+    return true;
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#endif
+}
+#endif
+
+/// The kernels for impl, or null if not built in or not supported by the CPU
+const Kernels* GetSupportedKernels(AESImplementation impl) {
+    switch (impl) {
+        case AESImplementation::SCALAR:
+            return &SCALAR_KERNELS;
+        case AESImplementation::AESNI:
+#if defined(SHURIUM_AES_NI)
+            if (CPUHasAESNI()) {
+                return &AESNI_KERNELS;
+            }
+#endif
+            return nullptr;
+        case AESImplementation::ARMV8:
+#if defined(SHURIUM_AES_ARMV8)
+            if (CPUHasARMv8AES()) {
+                return &ARMV8_KERNELS;
+            }
+#endif
+            return nullptr;
+    }
+    return nullptr;
+}
+
+/// Expand key into byte round keys with the given SubWord
+void ExpandRoundKeys(SubWordFn subWord, const Byte* key, size_t keyLen, int rounds,
+                     Byte* encRoundKeys, Byte* decRoundKeys) {
+    const int Nk = static_cast<int>(keyLen / 4);  // Key length in 32-bit words
+    const int Nb = 4;  // Block size in words (always 4 for AES)
+    const int total = Nb * (rounds + 1);
+    uint32_t w[4 * 15];
+
+    for (int i = 0; i < Nk; ++i) {
+        w[i] = ReadBE32(key + 4 * i);
+    }
+    for (int i = Nk; i < total; ++i) {
+        uint32_t temp = w[i - 1];
+        if (i % Nk == 0) {
+            // RotWord + SubWord + Rcon
+            temp = subWord((temp << 8) | (temp >> 24)) ^
+                   (static_cast<uint32_t>(RCON[i / Nk]) << 24);
+        } else if (Nk > 6 && i % Nk == 4) {
+            // SubWord only for AES-256
+            temp = subWord(temp);
+        }
+        w[i] = w[i - Nk] ^ temp;
+    }
+    for (int i = 0; i < total; ++i) {
+        WriteBE32(encRoundKeys + 4 * i, w[i]);
+    }
+
+    // Equivalent inverse cipher: round keys in reverse order, with
+    // InvMixColumns applied to all but the first and last
+    for (int i = 0; i <= rounds; ++i) {
+        for (int j = 0; j < Nb; ++j) {
+            uint32_t word = w[(rounds - i) * Nb + j];
+            if (i > 0 && i < rounds) {
+                uint8_t b0 = (word >> 24) & 0xff;
+                uint8_t b1 = (word >> 16) & 0xff;
+                uint8_t b2 = (word >> 8) & 0xff;
+                uint8_t b3 = word & 0xff;
+                word = (static_cast<uint32_t>(GfMul(0x0e, b0) ^ GfMul(0x0b, b1) ^ GfMul(0x0d, b2) ^ GfMul(0x09, b3)) << 24) |
+                       (static_cast<uint32_t>(GfMul(0x09, b0) ^ GfMul(0x0e, b1) ^ GfMul(0x0b, b2) ^ GfMul(0x0d, b3)) << 16) |
+                       (static_cast<uint32_t>(GfMul(0x0d, b0) ^ GfMul(0x09, b1) ^ GfMul(0x0e, b2) ^ GfMul(0x0b, b3)) << 8) |
+                       static_cast<uint32_t>(GfMul(0x0b, b0) ^ GfMul(0x0d, b1) ^ GfMul(0x09, b2) ^ GfMul(0x0e, b3));
+            }
+            WriteBE32(decRoundKeys + 4 * (i * Nb + j), word);
+        }
+    }
+    SecureClear(w, sizeof(w));
+}
+
+/**
+ * Check kernels against the FIPS-197 AES-128 and AES-256 vectors, then
+ * against the scalar ones over enough blocks to cover the multi-lane paths,
+ * CBC chaining and a CTR counter carry, so a miscompiled or faulty hardware
+ * path is never selected.
+ */
+bool SelfTest(const Kernels& k) {
+    static constexpr Byte PLAIN[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+    };
+    static constexpr Byte CIPHER_128[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+        0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+    };
+    static constexpr Byte CIPHER_256[16] = {
+        0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+        0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+    };
+    Byte key[32];
+    for (int i = 0; i < 32; ++i) {
+        key[i] = static_cast<Byte>(i);
+    }
+    Byte enc[16 * 15], dec[16 * 15];
+    Byte out[16];
+    ExpandRoundKeys(k.subWord, key, 16, 10, enc, dec);
+    k.encrypt(enc, 10, PLAIN, out, 1);
+    if (std::memcmp(out, CIPHER_128, 16) != 0) return false;
+    k.decrypt(dec, 10, CIPHER_128, out, 1);
+    if (std::memcmp(out, PLAIN, 16) != 0) return false;
+    ExpandRoundKeys(k.subWord, key, 32, 14, enc, dec);
+    k.encrypt(enc, 14, PLAIN, out, 1);
+    if (std::memcmp(out, CIPHER_256, 16) != 0) return false;
+    k.decrypt(dec, 14, CIPHER_256, out, 1);
+    if (std::memcmp(out, PLAIN, 16) != 0) return false;
+
+    // AES-192 schedule and the bulk paths against scalar
+    constexpr size_t BLOCKS = 11;
+    Byte data[16 * BLOCKS], got[16 * BLOCKS], want[16 * BLOCKS];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = static_cast<Byte>(i * 7 + 3);
+    }
+    Byte refEnc[16 * 15], refDec[16 * 15];
+    ExpandRoundKeys(k.subWord, key, 24, 12, enc, dec);
+    ExpandRoundKeys(SubWordScalar, key, 24, 12, refEnc, refDec);
+    if (std::memcmp(enc, refEnc, 16 * 13) != 0 || std::memcmp(dec, refDec, 16 * 13) != 0) {
+        return false;
+    }
+    k.encrypt(enc, 12, data, got, BLOCKS);
+    EncryptScalar(enc, 12, data, want, BLOCKS);
+    if (std::memcmp(got, want, sizeof(got)) != 0) return false;
+    k.decrypt(dec, 12, data, got, BLOCKS);
+    DecryptScalar(dec, 12, data, want, BLOCKS);
+    if (std::memcmp(got, want, sizeof(got)) != 0) return false;
+
+    Byte ivGot[16], ivWant[16];
+    std::memcpy(ivGot, PLAIN, 16);
+    std::memcpy(ivWant, PLAIN, 16);
+    k.encryptCBC(enc, 12, ivGot, data, got, BLOCKS);
+    EncryptCBCScalar(enc, 12, ivWant, data, want, BLOCKS);
+    if (std::memcmp(got, want, sizeof(got)) != 0 || std::memcmp(ivGot, ivWant, 16) != 0) {
+        return false;
+    }
+    k.decryptCBC(dec, 12, ivGot, data, got, BLOCKS);
+    DecryptCBCScalar(dec, 12, ivWant, data, want, BLOCKS);
+    if (std::memcmp(got, want, sizeof(got)) != 0 || std::memcmp(ivGot, ivWant, 16) != 0) {
+        return false;
+    }
+
+    // Low half two short of wrapping, so the carry lands mid-batch
+    std::memset(ivGot, 0, 16);
+    std::memset(ivGot + 8, 0xff, 8);
+    ivGot[15] = 0xfd;
+    std::memcpy(ivWant, ivGot, 16);
+    k.ctr(enc, 12, ivGot, data, got, BLOCKS);
+    CTRScalar(enc, 12, ivWant, data, want, BLOCKS);
+    return std::memcmp(got, want, sizeof(got)) == 0 && std::memcmp(ivGot, ivWant, 16) == 0;
+}
+
+/// Usable kernels for impl: supported by the CPU and self-tested
+const Kernels* GetVerifiedKernels(AESImplementation impl) {
+    const Kernels* kernels = GetSupportedKernels(impl);
+    return kernels && SelfTest(*kernels) ? kernels : nullptr;
+}
+
+/// Fastest first
+constexpr AESImplementation PREFERENCE[] = {
+    AESImplementation::AESNI,
+    AESImplementation::ARMV8,
+    AESImplementation::SCALAR,
+};
+
+struct Dispatch {
+    std::atomic<const Kernels*> kernels;
+    std::atomic<AESImplementation> impl;
+
+    Dispatch() : kernels(&SCALAR_KERNELS), impl(AESImplementation::SCALAR) {
+        for (AESImplementation candidate : PREFERENCE) {
+            if (const Kernels* k = GetVerifiedKernels(candidate)) {
+                kernels.store(k, std::memory_order_relaxed);
+                impl.store(candidate, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+};
+
+/// Selected on first use
+Dispatch& GetDispatch() {
+    static Dispatch dispatch;
+    return dispatch;
+}
+
+const Kernels& ActiveKernels() {
+    return *GetDispatch().kernels.load(std::memory_order_relaxed);
+}
+
+} // anonymous namespace
+
+const char* AESImplementationName(AESImplementation impl) {
+    switch (impl) {
+        case AESImplementation::SCALAR: return "scalar";
+        case AESImplementation::AESNI: return "aesni";
+        case AESImplementation::ARMV8: return "armv8";
+    }
+    return "unknown";
+}
+
+AESImplementation AESAutoDetect() {
+    return GetDispatch().impl.load(std::memory_order_relaxed);
+}
+
+AESImplementation GetAESImplementation() {
+    return GetDispatch().impl.load(std::memory_order_relaxed);
+}
+
+std::vector<AESImplementation> GetAvailableAESImplementations() {
+    std::vector<AESImplementation> result;
+    for (AESImplementation impl : PREFERENCE) {
+        if (GetVerifiedKernels(impl)) {
+            result.push_back(impl);
+        }
+    }
+    return result;
+}
+
+bool SetAESImplementation(AESImplementation impl) {
+    const Kernels* kernels = GetVerifiedKernels(impl);
+    if (!kernels) {
+        return false;
+    }
+    Dispatch& dispatch = GetDispatch();
+    dispatch.kernels.store(kernels, std::memory_order_relaxed);
+    dispatch.impl.store(impl, std::memory_order_relaxed);
+    return true;
+}
+
+// ============================================================================
+// AESContext Implementation
+// ============================================================================
+
+AESContext::AESContext(const Byte* key, size_t keyLen) {
+    if (keyLen != 16 && keyLen != 24 && keyLen != 32) {
+        throw std::invalid_argument("AES key must be 16, 24, or 32 bytes");
+    }
+    
+    switch (keyLen) {
+        case 16: keySize_ = AESKeySize::AES_128; rounds_ = 10; break;
+        case 24: keySize_ = AESKeySize::AES_192; rounds_ = 12; break;
+        case 32: keySize_ = AESKeySize::AES_256; rounds_ = 14; break;
+        default: throw std::invalid_argument("Invalid key length");
+    }
+    
+    ExpandKey(key, keyLen);
+}
+
+AESContext::~AESContext() {
+    SecureClear(encRoundKeys_.data(), encRoundKeys_.size());
+    SecureClear(decRoundKeys_.data(), decRoundKeys_.size());
+}
+
+AESContext::AESContext(AESContext&& other) noexcept
+    : encRoundKeys_(other.encRoundKeys_)
+    , decRoundKeys_(other.decRoundKeys_)
+    , keySize_(other.keySize_)
+    , rounds_(other.rounds_) {
+    SecureClear(other.encRoundKeys_.data(), other.encRoundKeys_.size());
+    SecureClear(other.decRoundKeys_.data(), other.decRoundKeys_.size());
+}
+
+AESContext& AESContext::operator=(AESContext&& other) noexcept {
+    if (this != &other) {
+        encRoundKeys_ = other.encRoundKeys_;
+        decRoundKeys_ = other.decRoundKeys_;
+        keySize_ = other.keySize_;
+        rounds_ = other.rounds_;
+        SecureClear(other.encRoundKeys_.data(), other.encRoundKeys_.size());
+        SecureClear(other.decRoundKeys_.data(), other.decRoundKeys_.size());
+    }
+    return *this;
+}
+
+void AESContext::ExpandKey(const Byte* key, size_t keyLen) {
+    // With AES instructions, SubWord goes through them too, so the schedule
+    // has no secret-indexed table lookups either
+    ExpandRoundKeys(ActiveKernels().subWord, key, keyLen, rounds_,
+                    encRoundKeys_.data(), decRoundKeys_.data());
+}
+
+void AESContext::EncryptBlock(const Byte input[aes::BLOCK_SIZE], 
+                               Byte output[aes::BLOCK_SIZE]) const {
+    ActiveKernels().encrypt(encRoundKeys_.data(), rounds_, input, output, 1);
+}
+
+void AESContext::DecryptBlock(const Byte input[aes::BLOCK_SIZE],
+                               Byte output[aes::BLOCK_SIZE]) const {
+    ActiveKernels().decrypt(decRoundKeys_.data(), rounds_, input, output, 1);
+}
+
+void AESContext::EncryptBlocks(const Byte* input, Byte* output, size_t blocks) const {
+    ActiveKernels().encrypt(encRoundKeys_.data(), rounds_, input, output, blocks);
+}
+
+void AESContext::DecryptBlocks(const Byte* input, Byte* output, size_t blocks) const {
+    ActiveKernels().decrypt(decRoundKeys_.data(), rounds_, input, output, blocks);
+}
+
+void AESContext::EncryptCBC(Byte iv[aes::BLOCK_SIZE], const Byte* input, Byte* output,
+                            size_t blocks) const {
+    ActiveKernels().encryptCBC(encRoundKeys_.data(), rounds_, iv, input, output, blocks);
+}
+
+void AESContext::DecryptCBC(Byte iv[aes::BLOCK_SIZE], const Byte* input, Byte* output,
+                            size_t blocks) const {
+    ActiveKernels().decryptCBC(decRoundKeys_.data(), rounds_, iv, input, output, blocks);
+}
+
+void AESContext::CTR(Byte counter[aes::BLOCK_SIZE], const Byte* input, Byte* output,
+                     size_t blocks) const {
+    ActiveKernels().ctr(encRoundKeys_.data(), rounds_, counter, input, output, blocks);
+}
+
 // ============================================================================
 // AESEncryptor Implementation
 // ============================================================================
 
+namespace {
+
+/// OpenSSL brings its own AES-NI code, but no faster than the kernels
+/// here; it is only worth using in place of the table-based fallback
+#ifdef SHURIUM_USE_OPENSSL
+bool PreferOpenSSL() {
+    return GetAESImplementation() == AESImplementation::SCALAR;
+}
+
+const EVP_CIPHER* SelectEVPCipher(size_t keyLen, AESMode mode) {
+    switch (keyLen) {
+        case 16: return (mode == AESMode::CTR) ? EVP_aes_128_ctr() : EVP_aes_128_cbc();
+        case 24: return (mode == AESMode::CTR) ? EVP_aes_192_ctr() : EVP_aes_192_cbc();
+        case 32: return (mode == AESMode::CTR) ? EVP_aes_256_ctr() : EVP_aes_256_cbc();
+    }
+    return nullptr;
+}
+#endif
+
+/**
+ * CTR over a stream: whole blocks go straight through the kernel, and a
+ * partial block at the end leaves the rest of its keystream for the next
+ * call. keystreamLeft counts the unused bytes at the end of keystream.
+ */
+void CTRStream(const AESContext& ctx, Byte counter[aes::BLOCK_SIZE],
+               Byte keystream[aes::BLOCK_SIZE], size_t& keystreamLeft,
+               const Byte* input, size_t inputLen, Byte* output) {
+    size_t i = 0;
+    for (; i < inputLen && keystreamLeft > 0; ++i) {
+        output[i] = input[i] ^ keystream[aes::BLOCK_SIZE - keystreamLeft--];
+    }
+    size_t blocks = (inputLen - i) / aes::BLOCK_SIZE;
+    ctx.CTR(counter, input + i, output + i, blocks);
+    i += blocks * aes::BLOCK_SIZE;
+    if (i < inputLen) {
+        static constexpr Byte ZERO[aes::BLOCK_SIZE] = {};
+        ctx.CTR(counter, ZERO, keystream, 1);
+        keystreamLeft = aes::BLOCK_SIZE;
+        for (; i < inputLen; ++i) {
+            output[i] = input[i] ^ keystream[aes::BLOCK_SIZE - keystreamLeft--];
+        }
+    }
+}
+
+} // anonymous namespace
+
 struct AESEncryptor::Impl {
     AESContext ctx;
     AESMode mode;
+    /// CBC chaining value, or the next CTR counter block
     Byte iv[aes::IV_SIZE];
+    /// Pending CBC plaintext, or the current CTR keystream block
     Byte buffer[aes::BLOCK_SIZE];
     size_t bufferLen{0};
-    uint64_t counter{0};
     
 #ifdef SHURIUM_USE_OPENSSL
     EVP_CIPHER_CTX* evpCtx{nullptr};
-    bool useOpenSSL{true};
+    bool useOpenSSL{false};
 #endif
     
     Impl(const Byte* key, size_t keyLen, AESMode m, const Byte* initIv)
-        : ctx(key, keyLen), mode(m), bufferLen(0), counter(0) {
+        : ctx(key, keyLen), mode(m), bufferLen(0) {
         if (initIv) {
             std::memcpy(iv, initIv, aes::IV_SIZE);
         } else {
@@ -387,25 +822,15 @@ struct AESEncryptor::Impl {
         }
         
 #ifdef SHURIUM_USE_OPENSSL
-        evpCtx = EVP_CIPHER_CTX_new();
-        if (evpCtx) {
-            const EVP_CIPHER* cipher = nullptr;
-            switch (keyLen) {
-                case 16: cipher = (m == AESMode::CTR) ? EVP_aes_128_ctr() : EVP_aes_128_cbc(); break;
-                case 24: cipher = (m == AESMode::CTR) ? EVP_aes_192_ctr() : EVP_aes_192_cbc(); break;
-                case 32: cipher = (m == AESMode::CTR) ? EVP_aes_256_ctr() : EVP_aes_256_cbc(); break;
-            }
-            if (cipher && EVP_EncryptInit_ex(evpCtx, cipher, nullptr, key, iv) == 1) {
-                if (m == AESMode::CBC) {
-                    EVP_CIPHER_CTX_set_padding(evpCtx, 0);  // We handle padding ourselves
-                }
-            } else {
+        if (PreferOpenSSL()) {
+            evpCtx = EVP_CIPHER_CTX_new();
+            const EVP_CIPHER* cipher = SelectEVPCipher(keyLen, m);
+            if (evpCtx && cipher && EVP_EncryptInit_ex(evpCtx, cipher, nullptr, key, iv) == 1) {
+                useOpenSSL = true;
+            } else if (evpCtx) {
                 EVP_CIPHER_CTX_free(evpCtx);
                 evpCtx = nullptr;
-                useOpenSSL = false;
             }
-        } else {
-            useOpenSSL = false;
         }
 #endif
     }
@@ -429,85 +854,55 @@ AESEncryptor::AESEncryptor(const Byte* key, size_t keyLen,
 AESEncryptor::~AESEncryptor() = default;
 
 size_t AESEncryptor::Update(const Byte* input, size_t inputLen, Byte* output) {
-    size_t outputLen = 0;
-    
 #ifdef SHURIUM_USE_OPENSSL
-    if (impl_->useOpenSSL && impl_->evpCtx) {
+    if (impl_->useOpenSSL) {
         int len = 0;
-        if (EVP_EncryptUpdate(impl_->evpCtx, output, &len, input, static_cast<int>(inputLen)) == 1) {
-            return static_cast<size_t>(len);
+        if (EVP_EncryptUpdate(impl_->evpCtx, output, &len, input, static_cast<int>(inputLen)) != 1) {
+            throw std::runtime_error("AES encryption failed");
         }
-        // Fall through to software implementation on failure
+        return static_cast<size_t>(len);
     }
 #endif
     
     if (impl_->mode == AESMode::CTR) {
-        // CTR mode - stream cipher
-        Byte keystream[aes::BLOCK_SIZE];
-        Byte counterBlock[aes::BLOCK_SIZE];
-        
-        for (size_t i = 0; i < inputLen; ++i) {
-            if (impl_->bufferLen == 0) {
-                // Generate new keystream block
-                std::memcpy(counterBlock, impl_->iv, 8);
-                for (int j = 0; j < 8; ++j) {
-                    counterBlock[15 - j] = (impl_->counter >> (j * 8)) & 0xff;
-                }
-                impl_->ctx.EncryptBlock(counterBlock, keystream);
-                impl_->counter++;
-            }
-            output[i] = input[i] ^ keystream[impl_->bufferLen];
-            impl_->bufferLen = (impl_->bufferLen + 1) % aes::BLOCK_SIZE;
-            outputLen++;
-        }
-    } else {
-        // CBC mode
-        size_t i = 0;
-        
-        // Process any buffered data first
-        while (impl_->bufferLen > 0 && impl_->bufferLen < aes::BLOCK_SIZE && i < inputLen) {
-            impl_->buffer[impl_->bufferLen++] = input[i++];
-        }
-        
-        if (impl_->bufferLen == aes::BLOCK_SIZE) {
-            // XOR with IV and encrypt
-            for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
-                impl_->buffer[j] ^= impl_->iv[j];
-            }
-            impl_->ctx.EncryptBlock(impl_->buffer, output);
-            std::memcpy(impl_->iv, output, aes::BLOCK_SIZE);
-            output += aes::BLOCK_SIZE;
-            outputLen += aes::BLOCK_SIZE;
-            impl_->bufferLen = 0;
-        }
-        
-        // Process full blocks
-        while (i + aes::BLOCK_SIZE <= inputLen) {
-            Byte block[aes::BLOCK_SIZE];
-            for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
-                block[j] = input[i + j] ^ impl_->iv[j];
-            }
-            impl_->ctx.EncryptBlock(block, output);
-            std::memcpy(impl_->iv, output, aes::BLOCK_SIZE);
-            output += aes::BLOCK_SIZE;
-            outputLen += aes::BLOCK_SIZE;
-            i += aes::BLOCK_SIZE;
-        }
-        
-        // Buffer remaining bytes
-        while (i < inputLen) {
-            impl_->buffer[impl_->bufferLen++] = input[i++];
+        CTRStream(impl_->ctx, impl_->iv, impl_->buffer, impl_->bufferLen,
+                  input, inputLen, output);
+        return inputLen;
+    }
+    
+    // CBC mode: complete any buffered block first
+    size_t outputLen = 0;
+    size_t i = 0;
+    if (impl_->bufferLen > 0) {
+        i = std::min(aes::BLOCK_SIZE - impl_->bufferLen, inputLen);
+        std::memcpy(impl_->buffer + impl_->bufferLen, input, i);
+        impl_->bufferLen += i;
+        if (impl_->bufferLen < aes::BLOCK_SIZE) {
+            return 0;
         }
+        impl_->ctx.EncryptCBC(impl_->iv, impl_->buffer, output, 1);
+        outputLen = aes::BLOCK_SIZE;
+        impl_->bufferLen = 0;
     }
     
+    // Full blocks in one call, then buffer the remainder
+    size_t blocks = (inputLen - i) / aes::BLOCK_SIZE;
+    impl_->ctx.EncryptCBC(impl_->iv, input + i, output + outputLen, blocks);
+    outputLen += blocks * aes::BLOCK_SIZE;
+    i += blocks * aes::BLOCK_SIZE;
+    impl_->bufferLen = inputLen - i;
+    std::memcpy(impl_->buffer, input + i, impl_->bufferLen);
+    
     return outputLen;
 }
 
 size_t AESEncryptor::Finalize(Byte* output) {
 #ifdef SHURIUM_USE_OPENSSL
-    if (impl_->useOpenSSL && impl_->evpCtx) {
+    if (impl_->useOpenSSL) {
         int len = 0;
-        EVP_EncryptFinal_ex(impl_->evpCtx, output, &len);
+        if (EVP_EncryptFinal_ex(impl_->evpCtx, output, &len) != 1) {
+            throw std::runtime_error("AES encryption failed");
+        }
         return static_cast<size_t>(len);
     }
 #endif
@@ -522,10 +917,7 @@ size_t AESEncryptor::Finalize(Byte* output) {
         impl_->buffer[i] = static_cast<Byte>(padLen);
     }
     
-    for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
-        impl_->buffer[j] ^= impl_->iv[j];
-    }
-    impl_->ctx.EncryptBlock(impl_->buffer, output);
+    impl_->ctx.EncryptCBC(impl_->iv, impl_->buffer, output, 1);
     impl_->bufferLen = 0;
     
     return aes::BLOCK_SIZE;
@@ -555,42 +947,33 @@ std::vector<Byte> AESEncryptor::Encrypt(const std::vector<Byte>& plaintext,
 struct AESDecryptor::Impl {
     AESContext ctx;
     AESMode mode;
+    /// CBC chaining value, or the next CTR counter block
     Byte iv[aes::IV_SIZE];
+    /// Pending CBC ciphertext, or the current CTR keystream block. In CBC
+    /// a full block stays here until more input shows it is not the last
+    /// one, which Finalize has to unpad.
     Byte buffer[aes::BLOCK_SIZE];
-    Byte lastBlock[aes::BLOCK_SIZE];
     size_t bufferLen{0};
-    uint64_t counter{0};
-    bool hasLastBlock{false};
     
 #ifdef SHURIUM_USE_OPENSSL
     EVP_CIPHER_CTX* evpCtx{nullptr};
-    bool useOpenSSL{true};
+    bool useOpenSSL{false};
 #endif
     
     Impl(const Byte* key, size_t keyLen, AESMode m, const Byte* initIv)
-        : ctx(key, keyLen), mode(m), bufferLen(0), counter(0), hasLastBlock(false) {
+        : ctx(key, keyLen), mode(m), bufferLen(0) {
         std::memcpy(iv, initIv, aes::IV_SIZE);
         
 #ifdef SHURIUM_USE_OPENSSL
-        evpCtx = EVP_CIPHER_CTX_new();
-        if (evpCtx) {
-            const EVP_CIPHER* cipher = nullptr;
-            switch (keyLen) {
-                case 16: cipher = (m == AESMode::CTR) ? EVP_aes_128_ctr() : EVP_aes_128_cbc(); break;
-                case 24: cipher = (m == AESMode::CTR) ? EVP_aes_192_ctr() : EVP_aes_192_cbc(); break;
-                case 32: cipher = (m == AESMode::CTR) ? EVP_aes_256_ctr() : EVP_aes_256_cbc(); break;
-            }
-            if (cipher && EVP_DecryptInit_ex(evpCtx, cipher, nullptr, key, initIv) == 1) {
-                if (m == AESMode::CBC) {
-                    EVP_CIPHER_CTX_set_padding(evpCtx, 0);
-                }
-            } else {
+        if (PreferOpenSSL()) {
+            evpCtx = EVP_CIPHER_CTX_new();
+            const EVP_CIPHER* cipher = SelectEVPCipher(keyLen, m);
+            if (evpCtx && cipher && EVP_DecryptInit_ex(evpCtx, cipher, nullptr, key, initIv) == 1) {
+                useOpenSSL = true;
+            } else if (evpCtx) {
                 EVP_CIPHER_CTX_free(evpCtx);
                 evpCtx = nullptr;
-                useOpenSSL = false;
             }
-        } else {
-            useOpenSSL = false;
         }
 #endif
     }
@@ -602,7 +985,6 @@ struct AESDecryptor::Impl {
         }
 #endif
         SecureClear(buffer, sizeof(buffer));
-        SecureClear(lastBlock, sizeof(lastBlock));
         SecureClear(iv, sizeof(iv));
     }
 };
@@ -615,97 +997,55 @@ AESDecryptor::AESDecryptor(const Byte* key, size_t keyLen,
 AESDecryptor::~AESDecryptor() = default;
 
 size_t AESDecryptor::Update(const Byte* input, size_t inputLen, Byte* output) {
-    size_t outputLen = 0;
-    
 #ifdef SHURIUM_USE_OPENSSL
-    if (impl_->useOpenSSL && impl_->evpCtx) {
+    if (impl_->useOpenSSL) {
         int len = 0;
-        if (EVP_DecryptUpdate(impl_->evpCtx, output, &len, input, static_cast<int>(inputLen)) == 1) {
-            return static_cast<size_t>(len);
+        if (EVP_DecryptUpdate(impl_->evpCtx, output, &len, input, static_cast<int>(inputLen)) != 1) {
+            throw std::runtime_error("AES decryption failed");
         }
+        return static_cast<size_t>(len);
     }
 #endif
     
     if (impl_->mode == AESMode::CTR) {
         // CTR mode - same as encryption
-        Byte keystream[aes::BLOCK_SIZE];
-        Byte counterBlock[aes::BLOCK_SIZE];
-        
-        for (size_t i = 0; i < inputLen; ++i) {
-            if (impl_->bufferLen == 0) {
-                std::memcpy(counterBlock, impl_->iv, 8);
-                for (int j = 0; j < 8; ++j) {
-                    counterBlock[15 - j] = (impl_->counter >> (j * 8)) & 0xff;
-                }
-                impl_->ctx.EncryptBlock(counterBlock, keystream);
-                impl_->counter++;
-            }
-            output[i] = input[i] ^ keystream[impl_->bufferLen];
-            impl_->bufferLen = (impl_->bufferLen + 1) % aes::BLOCK_SIZE;
-            outputLen++;
-        }
-    } else {
-        // CBC mode
-        size_t i = 0;
-        
-        // Output any previous last block (we delay by one block for padding)
-        if (impl_->hasLastBlock) {
-            std::memcpy(output, impl_->lastBlock, aes::BLOCK_SIZE);
-            output += aes::BLOCK_SIZE;
-            outputLen += aes::BLOCK_SIZE;
-            impl_->hasLastBlock = false;
-        }
-        
-        // Buffer incoming data
-        while (impl_->bufferLen > 0 && impl_->bufferLen < aes::BLOCK_SIZE && i < inputLen) {
-            impl_->buffer[impl_->bufferLen++] = input[i++];
-        }
-        
-        if (impl_->bufferLen == aes::BLOCK_SIZE) {
-            Byte decrypted[aes::BLOCK_SIZE];
-            impl_->ctx.DecryptBlock(impl_->buffer, decrypted);
-            for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
-                decrypted[j] ^= impl_->iv[j];
-            }
-            std::memcpy(impl_->iv, impl_->buffer, aes::BLOCK_SIZE);
-            std::memcpy(impl_->lastBlock, decrypted, aes::BLOCK_SIZE);
-            impl_->hasLastBlock = true;
-            impl_->bufferLen = 0;
-        }
-        
-        // Process full blocks
-        while (i + aes::BLOCK_SIZE <= inputLen) {
-            if (impl_->hasLastBlock) {
-                std::memcpy(output, impl_->lastBlock, aes::BLOCK_SIZE);
-                output += aes::BLOCK_SIZE;
-                outputLen += aes::BLOCK_SIZE;
-            }
-            
-            Byte decrypted[aes::BLOCK_SIZE];
-            impl_->ctx.DecryptBlock(input + i, decrypted);
-            for (size_t j = 0; j < aes::BLOCK_SIZE; ++j) {
-                decrypted[j] ^= impl_->iv[j];
-            }
-            std::memcpy(impl_->iv, input + i, aes::BLOCK_SIZE);
-            std::memcpy(impl_->lastBlock, decrypted, aes::BLOCK_SIZE);
-            impl_->hasLastBlock = true;
-            i += aes::BLOCK_SIZE;
-        }
-        
-        // Buffer remaining
-        while (i < inputLen) {
-            impl_->buffer[impl_->bufferLen++] = input[i++];
-        }
+        CTRStream(impl_->ctx, impl_->iv, impl_->buffer, impl_->bufferLen,
+                  input, inputLen, output);
+        return inputLen;
+    }
+    
+    // CBC mode: top up the buffered block, and decrypt it once there is
+    // input after it
+    size_t outputLen = 0;
+    size_t i = std::min(aes::BLOCK_SIZE - impl_->bufferLen, inputLen);
+    std::memcpy(impl_->buffer + impl_->bufferLen, input, i);
+    impl_->bufferLen += i;
+    if (impl_->bufferLen < aes::BLOCK_SIZE || i == inputLen) {
+        return 0;
     }
+    impl_->ctx.DecryptCBC(impl_->iv, impl_->buffer, output, 1);
+    outputLen = aes::BLOCK_SIZE;
+    
+    // Full blocks in one call, holding back the final one
+    size_t remaining = inputLen - i;
+    size_t blocks = (remaining - 1) / aes::BLOCK_SIZE;
+    impl_->ctx.DecryptCBC(impl_->iv, input + i, output + outputLen, blocks);
+    outputLen += blocks * aes::BLOCK_SIZE;
+    i += blocks * aes::BLOCK_SIZE;
+    impl_->bufferLen = inputLen - i;
+    std::memcpy(impl_->buffer, input + i, impl_->bufferLen);
     
     return outputLen;
 }
 
 size_t AESDecryptor::Finalize(Byte* output) {
 #ifdef SHURIUM_USE_OPENSSL
-    if (impl_->useOpenSSL && impl_->evpCtx) {
+    if (impl_->useOpenSSL) {
         int len = 0;
-        EVP_DecryptFinal_ex(impl_->evpCtx, output, &len);
+        if (EVP_DecryptFinal_ex(impl_->evpCtx, output, &len) != 1) {
+            throw std::runtime_error(impl_->mode == AESMode::CTR ? "AES decryption failed"
+                                                                 : "Invalid PKCS7 padding");
+        }
         return static_cast<size_t>(len);
     }
 #endif
@@ -715,24 +1055,30 @@ size_t AESDecryptor::Finalize(Byte* output) {
     }
     
     // CBC mode - remove PKCS7 padding from last block
-    if (!impl_->hasLastBlock) {
+    if (impl_->bufferLen == 0) {
         throw std::runtime_error("No data to finalize");
     }
-    
-    Byte padLen = impl_->lastBlock[aes::BLOCK_SIZE - 1];
-    if (padLen == 0 || padLen > aes::BLOCK_SIZE) {
-        throw std::runtime_error("Invalid PKCS7 padding");
+    if (impl_->bufferLen != aes::BLOCK_SIZE) {
+        throw std::runtime_error("Ciphertext is not a multiple of the block size");
     }
     
-    for (size_t i = aes::BLOCK_SIZE - padLen; i < aes::BLOCK_SIZE; ++i) {
-        if (impl_->lastBlock[i] != padLen) {
-            throw std::runtime_error("Invalid PKCS7 padding");
-        }
+    Byte lastBlock[aes::BLOCK_SIZE];
+    impl_->ctx.DecryptCBC(impl_->iv, impl_->buffer, lastBlock, 1);
+    impl_->bufferLen = 0;
+    
+    Byte padLen = lastBlock[aes::BLOCK_SIZE - 1];
+    bool valid = padLen != 0 && padLen <= aes::BLOCK_SIZE;
+    for (size_t i = aes::BLOCK_SIZE - (valid ? padLen : 0); i < aes::BLOCK_SIZE; ++i) {
+        valid = valid && lastBlock[i] == padLen;
+    }
+    if (!valid) {
+        SecureClear(lastBlock, sizeof(lastBlock));
+        throw std::runtime_error("Invalid PKCS7 padding");
     }
     
     size_t dataLen = aes::BLOCK_SIZE - padLen;
-    std::memcpy(output, impl_->lastBlock, dataLen);
-    impl_->hasLastBlock = false;
+    std::memcpy(output, lastBlock, dataLen);
+    SecureClear(lastBlock, sizeof(lastBlock));
     
     return dataLen;
 }
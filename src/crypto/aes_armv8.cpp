@@ -0,0 +1,180 @@
+// SHURIUM - AES Using ARMv8 Cryptography Extensions
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -march=armv8-a+crypto and only called after the kernel
+// reports HWCAP_AES. aese/aesd add the round key before (Inv)ShiftRows and
+// (Inv)SubBytes, so the round key of each step goes in one instruction
+// earlier than with AES-NI and the last one is a plain XOR. As in the x86
+// backend, the modes without a chain between blocks keep eight blocks in
+// flight.
+
+#include "shurium/core/types.h"
+#include <cstddef>
+#include <cstdint>
+#include <arm_neon.h>
+
+namespace shurium {
+namespace aes_armv8 {
+
+namespace {
+
+constexpr size_t LANES = 8;
+
+inline void LoadKeys(uint8x16_t* k, const Byte* roundKeys, int rounds) {
+    for (int r = 0; r <= rounds; ++r) {
+        k[r] = vld1q_u8(roundKeys + 16 * r);
+    }
+}
+
+inline uint8x16_t EncryptOne(uint8x16_t b, const uint8x16_t* k, int rounds) {
+    for (int r = 0; r < rounds - 1; ++r) {
+        b = vaesmcq_u8(vaeseq_u8(b, k[r]));
+    }
+    return veorq_u8(vaeseq_u8(b, k[rounds - 1]), k[rounds]);
+}
+
+inline uint8x16_t DecryptOne(uint8x16_t b, const uint8x16_t* k, int rounds) {
+    for (int r = 0; r < rounds - 1; ++r) {
+        b = vaesimcq_u8(vaesdq_u8(b, k[r]));
+    }
+    return veorq_u8(vaesdq_u8(b, k[rounds - 1]), k[rounds]);
+}
+
+inline void EncryptLanes(uint8x16_t* b, const uint8x16_t* k, int rounds) {
+    for (int r = 0; r < rounds - 1; ++r) {
+        for (size_t j = 0; j < LANES; ++j) b[j] = vaesmcq_u8(vaeseq_u8(b[j], k[r]));
+    }
+    for (size_t j = 0; j < LANES; ++j) {
+        b[j] = veorq_u8(vaeseq_u8(b[j], k[rounds - 1]), k[rounds]);
+    }
+}
+
+inline void DecryptLanes(uint8x16_t* b, const uint8x16_t* k, int rounds) {
+    for (int r = 0; r < rounds - 1; ++r) {
+        for (size_t j = 0; j < LANES; ++j) b[j] = vaesimcq_u8(vaesdq_u8(b[j], k[r]));
+    }
+    for (size_t j = 0; j < LANES; ++j) {
+        b[j] = veorq_u8(vaesdq_u8(b[j], k[rounds - 1]), k[rounds]);
+    }
+}
+
+inline uint64_t ReadBE64(const Byte* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline void WriteBE64(Byte* p, uint64_t v) {
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<Byte>(v);
+        v >>= 8;
+    }
+}
+
+/// The counter block for the 128-bit big-endian value hi:lo
+inline uint8x16_t CounterBlock(uint64_t hi, uint64_t lo) {
+    return vcombine_u8(vrev64_u8(vcreate_u8(hi)), vrev64_u8(vcreate_u8(lo)));
+}
+
+} // namespace
+
+uint32_t SubWord(uint32_t w) {
+    // With all four columns equal, ShiftRows is the identity, so aese under
+    // a zero key is SubBytes alone
+    uint8x16_t s = vreinterpretq_u8_u32(vdupq_n_u32(w));
+    s = vaeseq_u8(s, vdupq_n_u8(0));
+    return vgetq_lane_u32(vreinterpretq_u32_u8(s), 0);
+}
+
+void Encrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks) {
+    uint8x16_t k[15];
+    LoadKeys(k, roundKeys, rounds);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        uint8x16_t b[LANES];
+        for (size_t j = 0; j < LANES; ++j) b[j] = vld1q_u8(in + 16 * j);
+        EncryptLanes(b, k, rounds);
+        for (size_t j = 0; j < LANES; ++j) vst1q_u8(out + 16 * j, b[j]);
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        vst1q_u8(out, EncryptOne(vld1q_u8(in), k, rounds));
+    }
+}
+
+void Decrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks) {
+    uint8x16_t k[15];
+    LoadKeys(k, roundKeys, rounds);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        uint8x16_t b[LANES];
+        for (size_t j = 0; j < LANES; ++j) b[j] = vld1q_u8(in + 16 * j);
+        DecryptLanes(b, k, rounds);
+        for (size_t j = 0; j < LANES; ++j) vst1q_u8(out + 16 * j, b[j]);
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        vst1q_u8(out, DecryptOne(vld1q_u8(in), k, rounds));
+    }
+}
+
+void EncryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks) {
+    uint8x16_t k[15];
+    LoadKeys(k, roundKeys, rounds);
+    uint8x16_t chain = vld1q_u8(iv);
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        chain = EncryptOne(veorq_u8(vld1q_u8(in), chain), k, rounds);
+        vst1q_u8(out, chain);
+    }
+    vst1q_u8(iv, chain);
+}
+
+void DecryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks) {
+    uint8x16_t k[15];
+    LoadKeys(k, roundKeys, rounds);
+    uint8x16_t chain = vld1q_u8(iv);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        // Every ciphertext block is read before any output is written, so
+        // in may equal out
+        uint8x16_t c[LANES], b[LANES];
+        for (size_t j = 0; j < LANES; ++j) b[j] = c[j] = vld1q_u8(in + 16 * j);
+        DecryptLanes(b, k, rounds);
+        vst1q_u8(out, veorq_u8(b[0], chain));
+        for (size_t j = 1; j < LANES; ++j) vst1q_u8(out + 16 * j, veorq_u8(b[j], c[j - 1]));
+        chain = c[LANES - 1];
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        uint8x16_t c = vld1q_u8(in);
+        vst1q_u8(out, veorq_u8(DecryptOne(c, k, rounds), chain));
+        chain = c;
+    }
+    vst1q_u8(iv, chain);
+}
+
+void CTR(const Byte* roundKeys, int rounds, Byte* counter, const Byte* in, Byte* out,
+         size_t blocks) {
+    uint8x16_t k[15];
+    LoadKeys(k, roundKeys, rounds);
+    uint64_t hi = ReadBE64(counter);
+    uint64_t lo = ReadBE64(counter + 8);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        uint8x16_t b[LANES];
+        for (size_t j = 0; j < LANES; ++j) {
+            b[j] = CounterBlock(hi, lo);
+            hi += (++lo == 0);
+        }
+        EncryptLanes(b, k, rounds);
+        for (size_t j = 0; j < LANES; ++j) {
+            vst1q_u8(out + 16 * j, veorq_u8(b[j], vld1q_u8(in + 16 * j)));
+        }
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        uint8x16_t b = EncryptOne(CounterBlock(hi, lo), k, rounds);
+        hi += (++lo == 0);
+        vst1q_u8(out, veorq_u8(b, vld1q_u8(in)));
+    }
+    WriteBE64(counter, hi);
+    WriteBE64(counter + 8, lo);
+}
+
+} // namespace aes_armv8
+} // namespace shurium
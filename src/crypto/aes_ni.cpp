@@ -0,0 +1,192 @@
+// SHURIUM - AES Using x86 AES-NI
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -msse4.1 -maes and only called after CPUID reports support.
+// Round keys are in cipher byte order, the decryption schedule already in
+// equivalent-inverse form, so aesdec takes it as is. Modes without a chain
+// between blocks (ECB, CBC decryption, CTR) keep eight blocks in flight:
+// aesenc has a latency of several cycles but issues every cycle, so one
+// block at a time leaves the unit mostly idle.
+
+#include "shurium/core/types.h"
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+namespace shurium {
+namespace aes_ni {
+
+namespace {
+
+constexpr size_t LANES = 8;
+
+inline __m128i Load(const Byte* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline void Store(Byte* p, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+/// Round keys 0..rounds into registers
+inline void LoadKeys(__m128i* k, const Byte* roundKeys, int rounds) {
+    for (int r = 0; r <= rounds; ++r) {
+        k[r] = Load(roundKeys + 16 * r);
+    }
+}
+
+inline __m128i EncryptOne(__m128i b, const __m128i* k, int rounds) {
+    b = _mm_xor_si128(b, k[0]);
+    for (int r = 1; r < rounds; ++r) {
+        b = _mm_aesenc_si128(b, k[r]);
+    }
+    return _mm_aesenclast_si128(b, k[rounds]);
+}
+
+inline __m128i DecryptOne(__m128i b, const __m128i* k, int rounds) {
+    b = _mm_xor_si128(b, k[0]);
+    for (int r = 1; r < rounds; ++r) {
+        b = _mm_aesdec_si128(b, k[r]);
+    }
+    return _mm_aesdeclast_si128(b, k[rounds]);
+}
+
+inline void EncryptLanes(__m128i* b, const __m128i* k, int rounds) {
+    for (size_t j = 0; j < LANES; ++j) b[j] = _mm_xor_si128(b[j], k[0]);
+    for (int r = 1; r < rounds; ++r) {
+        for (size_t j = 0; j < LANES; ++j) b[j] = _mm_aesenc_si128(b[j], k[r]);
+    }
+    for (size_t j = 0; j < LANES; ++j) b[j] = _mm_aesenclast_si128(b[j], k[rounds]);
+}
+
+inline void DecryptLanes(__m128i* b, const __m128i* k, int rounds) {
+    for (size_t j = 0; j < LANES; ++j) b[j] = _mm_xor_si128(b[j], k[0]);
+    for (int r = 1; r < rounds; ++r) {
+        for (size_t j = 0; j < LANES; ++j) b[j] = _mm_aesdec_si128(b[j], k[r]);
+    }
+    for (size_t j = 0; j < LANES; ++j) b[j] = _mm_aesdeclast_si128(b[j], k[rounds]);
+}
+
+inline uint64_t ReadBE64(const Byte* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline void WriteBE64(Byte* p, uint64_t v) {
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<Byte>(v);
+        v >>= 8;
+    }
+}
+
+/// The counter block for the 128-bit big-endian value hi:lo
+inline __m128i CounterBlock(uint64_t hi, uint64_t lo) {
+    const __m128i bswap64 = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                                         0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm_shuffle_epi8(_mm_set_epi64x(static_cast<long long>(lo),
+                                           static_cast<long long>(hi)), bswap64);
+}
+
+} // namespace
+
+uint32_t SubWord(uint32_t w) {
+    // With all four columns equal, ShiftRows is the identity, so a last
+    // round under a zero key is SubBytes alone
+    __m128i s = _mm_set1_epi32(static_cast<int>(w));
+    s = _mm_aesenclast_si128(s, _mm_setzero_si128());
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(s));
+}
+
+void Encrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks) {
+    __m128i k[15];
+    LoadKeys(k, roundKeys, rounds);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        __m128i b[LANES];
+        for (size_t j = 0; j < LANES; ++j) b[j] = Load(in + 16 * j);
+        EncryptLanes(b, k, rounds);
+        for (size_t j = 0; j < LANES; ++j) Store(out + 16 * j, b[j]);
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        Store(out, EncryptOne(Load(in), k, rounds));
+    }
+}
+
+void Decrypt(const Byte* roundKeys, int rounds, const Byte* in, Byte* out, size_t blocks) {
+    __m128i k[15];
+    LoadKeys(k, roundKeys, rounds);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        __m128i b[LANES];
+        for (size_t j = 0; j < LANES; ++j) b[j] = Load(in + 16 * j);
+        DecryptLanes(b, k, rounds);
+        for (size_t j = 0; j < LANES; ++j) Store(out + 16 * j, b[j]);
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        Store(out, DecryptOne(Load(in), k, rounds));
+    }
+}
+
+void EncryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks) {
+    __m128i k[15];
+    LoadKeys(k, roundKeys, rounds);
+    __m128i chain = Load(iv);
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        chain = EncryptOne(_mm_xor_si128(Load(in), chain), k, rounds);
+        Store(out, chain);
+    }
+    Store(iv, chain);
+}
+
+void DecryptCBC(const Byte* roundKeys, int rounds, Byte* iv, const Byte* in, Byte* out,
+                size_t blocks) {
+    __m128i k[15];
+    LoadKeys(k, roundKeys, rounds);
+    __m128i chain = Load(iv);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        // Every ciphertext block is read before any output is written, so
+        // in may equal out
+        __m128i c[LANES], b[LANES];
+        for (size_t j = 0; j < LANES; ++j) b[j] = c[j] = Load(in + 16 * j);
+        DecryptLanes(b, k, rounds);
+        Store(out, _mm_xor_si128(b[0], chain));
+        for (size_t j = 1; j < LANES; ++j) Store(out + 16 * j, _mm_xor_si128(b[j], c[j - 1]));
+        chain = c[LANES - 1];
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        __m128i c = Load(in);
+        Store(out, _mm_xor_si128(DecryptOne(c, k, rounds), chain));
+        chain = c;
+    }
+    Store(iv, chain);
+}
+
+void CTR(const Byte* roundKeys, int rounds, Byte* counter, const Byte* in, Byte* out,
+         size_t blocks) {
+    __m128i k[15];
+    LoadKeys(k, roundKeys, rounds);
+    uint64_t hi = ReadBE64(counter);
+    uint64_t lo = ReadBE64(counter + 8);
+    for (; blocks >= LANES; blocks -= LANES, in += 16 * LANES, out += 16 * LANES) {
+        __m128i b[LANES];
+        for (size_t j = 0; j < LANES; ++j) {
+            b[j] = CounterBlock(hi, lo);
+            hi += (++lo == 0);
+        }
+        EncryptLanes(b, k, rounds);
+        for (size_t j = 0; j < LANES; ++j) {
+            Store(out + 16 * j, _mm_xor_si128(b[j], Load(in + 16 * j)));
+        }
+    }
+    for (; blocks > 0; --blocks, in += 16, out += 16) {
+        __m128i b = EncryptOne(CounterBlock(hi, lo), k, rounds);
+        hi += (++lo == 0);
+        Store(out, _mm_xor_si128(b, Load(in)));
+    }
+    WriteBE64(counter, hi);
+    WriteBE64(counter + 8, lo);
+}
+
+} // namespace aes_ni
+} // namespace shurium
@@ -5,6 +5,7 @@
 // Implements Montgomery arithmetic over the BN254 scalar field
 
 #include "shurium/crypto/field.h"
+#include <algorithm>
 #include <cstring>
 #include <stdexcept>
 
@@ -45,6 +46,70 @@ const Uint256 FieldElement::R2{
 // INV = 0xc2e1f593efffffff
 const uint64_t FieldElement::INV = 0xc2e1f593efffffffULL;
 
+namespace {
+
+using uint128_t = __uint128_t;
+
+/// Subtract MODULUS from the 257-bit value (carry, a) when it is at least
+/// MODULUS, selecting the result with masks rather than a branch
+Uint256 ConditionalSubtractModulus(const Uint256& a, uint64_t carry) {
+    Uint256 diff;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t d = static_cast<uint128_t>(a.limbs[i]) - FieldElement::MODULUS.limbs[i] - borrow;
+        diff.limbs[i] = static_cast<uint64_t>(d);
+        borrow = static_cast<uint64_t>(d >> 64) & 1;
+    }
+    // Keep a when the subtraction borrowed past the carry-in
+    uint64_t keep = 0 - (borrow & (carry ^ 1));
+    Uint256 result;
+    for (int i = 0; i < 4; ++i) {
+        result.limbs[i] = (a.limbs[i] & keep) | (diff.limbs[i] & ~keep);
+    }
+    return result;
+}
+
+/// Add the 512-bit product a * b into t
+void MulAddWide(uint64_t t[8], const Uint256& a, const Uint256& b) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; ++j) {
+            uint128_t x = static_cast<uint128_t>(a.limbs[i]) * b.limbs[j] + t[i + j] + carry;
+            t[i + j] = static_cast<uint64_t>(x);
+            carry = static_cast<uint64_t>(x >> 64);
+        }
+        for (int k = i + 4; carry != 0 && k < 8; ++k) {
+            uint128_t x = static_cast<uint128_t>(t[k]) + carry;
+            t[k] = static_cast<uint64_t>(x);
+            carry = static_cast<uint64_t>(x >> 64);
+        }
+    }
+}
+
+/// Montgomery reduction of a 512-bit t below p * 2^256: t * R^(-1) mod p
+Uint256 ReduceWide(uint64_t t[8]) {
+    const uint64_t* p = FieldElement::MODULUS.limbs.data();
+    for (int i = 0; i < 4; ++i) {
+        // m makes word i of t + m * p * 2^(64i) vanish
+        uint64_t m = t[i] * FieldElement::INV;
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; ++j) {
+            uint128_t x = static_cast<uint128_t>(m) * p[j] + t[i + j] + carry;
+            t[i + j] = static_cast<uint64_t>(x);
+            carry = static_cast<uint64_t>(x >> 64);
+        }
+        for (int k = i + 4; carry != 0 && k < 8; ++k) {
+            uint128_t x = static_cast<uint128_t>(t[k]) + carry;
+            t[k] = static_cast<uint64_t>(x);
+            carry = static_cast<uint64_t>(x >> 64);
+        }
+    }
+    // t < 2p * 2^256 < 2^512, so the upper half is below 2p
+    return ConditionalSubtractModulus(Uint256(t[4], t[5], t[6], t[7]), 0);
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // Uint256 Implementation
 // ============================================================================
@@ -265,8 +330,14 @@ Uint256 Uint256::operator>>(int shift) const {
 FieldElement::FieldElement() : value() {}
 
 FieldElement::FieldElement(const Uint256& val) {
-    // Convert to Montgomery form: value = val * R mod p
-    value = MontMul(val, R2);
+    // Convert to Montgomery form: value = val * R mod p. MontMul expects
+    // operands below p, and 2^256 < 6p, so five conditional subtractions
+    // fully reduce any 256-bit input.
+    Uint256 reduced = val;
+    for (int i = 0; i < 5; ++i) {
+        reduced = ConditionalSubtractModulus(reduced, 0);
+    }
+    value = MontMul(reduced, R2);
 }
 
 FieldElement::FieldElement(uint64_t val) {
@@ -290,7 +361,6 @@ Uint256 FieldElement::ToUint256() const {
     // Convert from Montgomery form to standard representation
     // Montgomery form: value = a * R mod p
     // To get a: multiply by R^(-1) which is done by MontMul(value, 1)
-    // Or equivalently, MontReduce(value, 0)
     Uint256 one(1, 0, 0, 0);
     return MontMul(value, one);
 }
@@ -322,82 +392,69 @@ bool FieldElement::operator!=(const FieldElement& other) const {
 }
 
 Uint256 FieldElement::ModAdd(const Uint256& a, const Uint256& b) {
-    bool carry;
-    Uint256 sum = Uint256::Add(a, b, carry);
-    
-    // If carry or sum >= MODULUS, subtract MODULUS
-    if (carry || sum >= MODULUS) {
-        bool borrow;
-        sum = Uint256::Sub(sum, MODULUS, borrow);
+    Uint256 sum;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t s = static_cast<uint128_t>(a.limbs[i]) + b.limbs[i] + carry;
+        sum.limbs[i] = static_cast<uint64_t>(s);
+        carry = static_cast<uint64_t>(s >> 64);
     }
-    
-    return sum;
+    return ConditionalSubtractModulus(sum, carry);
 }
 
 Uint256 FieldElement::ModSub(const Uint256& a, const Uint256& b) {
-    bool borrow;
-    Uint256 diff = Uint256::Sub(a, b, borrow);
-    
-    // If borrow, add MODULUS
-    if (borrow) {
-        bool carry;
-        diff = Uint256::Add(diff, MODULUS, carry);
+    Uint256 diff;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t d = static_cast<uint128_t>(a.limbs[i]) - b.limbs[i] - borrow;
+        diff.limbs[i] = static_cast<uint64_t>(d);
+        borrow = static_cast<uint64_t>(d >> 64) & 1;
     }
     
+    // Add MODULUS back, masked to zero when nothing borrowed
+    uint64_t mask = 0 - borrow;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t s = static_cast<uint128_t>(diff.limbs[i]) + (MODULUS.limbs[i] & mask) + carry;
+        diff.limbs[i] = static_cast<uint64_t>(s);
+        carry = static_cast<uint64_t>(s >> 64);
+    }
     return diff;
 }
 
 Uint256 FieldElement::MontMul(const Uint256& a, const Uint256& b) {
-    // Montgomery multiplication: (a * b * R^(-1)) mod p
-    Uint256 hi;
-    Uint256 lo = Uint256::Mul(a, b, hi);
-    return MontReduce(lo, hi);
-}
-
-Uint256 FieldElement::MontReduce(const Uint256& lo, const Uint256& hi) {
-    // Montgomery reduction using the CIOS method
-    Uint256 result = lo;
-    Uint256 high = hi;
+    // Montgomery multiplication (a * b * R^(-1)) mod p, with the reduction
+    // interleaved into the product one word of b at a time (CIOS). The top
+    // word of p is below 2^62, so for a, b < p the running sum t stays below
+    // 2p < 2^256 and the extra carry words of generic CIOS are never needed.
+    const uint64_t* p = MODULUS.limbs.data();
+    uint64_t t[4] = {0, 0, 0, 0};
     
     for (int i = 0; i < 4; ++i) {
-        // m = (result[0] * INV) mod 2^64
-        uint64_t m = result.limbs[0] * INV;
+        uint64_t bi = b.limbs[i];
         
-        // result += m * MODULUS (shifted by i limbs conceptually)
-        __uint128_t carry = 0;
-        for (int j = 0; j < 4; ++j) {
-            __uint128_t prod = static_cast<__uint128_t>(m) * MODULUS.limbs[j];
-            __uint128_t sum = static_cast<__uint128_t>(result.limbs[j]) + prod + carry;
-            result.limbs[j] = static_cast<uint64_t>(sum);
-            carry = sum >> 64;
-        }
+        // t += a * b[i], low word first
+        uint128_t x = static_cast<uint128_t>(a.limbs[0]) * bi + t[0];
+        uint64_t carryMul = static_cast<uint64_t>(x >> 64);
+        uint64_t t0 = static_cast<uint64_t>(x);
         
-        // Add carry to high part
-        for (int j = 0; j < 4 && carry; ++j) {
-            __uint128_t sum = static_cast<__uint128_t>(high.limbs[j]) + carry;
-            high.limbs[j] = static_cast<uint64_t>(sum);
-            carry = sum >> 64;
-        }
-        
-        // Shift result right by 64 bits
-        result.limbs[0] = result.limbs[1];
-        result.limbs[1] = result.limbs[2];
-        result.limbs[2] = result.limbs[3];
-        result.limbs[3] = high.limbs[0];
+        // m makes the low word of t + m * p vanish
+        uint64_t m = t0 * INV;
+        uint128_t y = static_cast<uint128_t>(m) * p[0] + t0;
+        uint64_t carryRed = static_cast<uint64_t>(y >> 64);
         
-        high.limbs[0] = high.limbs[1];
-        high.limbs[1] = high.limbs[2];
-        high.limbs[2] = high.limbs[3];
-        high.limbs[3] = 0;
-    }
-    
-    // Final reduction if needed
-    if (result >= MODULUS) {
-        bool borrow;
-        result = Uint256::Sub(result, MODULUS, borrow);
+        // Remaining words, shifting t down by one word as the reduction goes
+        for (int j = 1; j < 4; ++j) {
+            x = static_cast<uint128_t>(a.limbs[j]) * bi + t[j] + carryMul;
+            carryMul = static_cast<uint64_t>(x >> 64);
+            y = static_cast<uint128_t>(m) * p[j] + static_cast<uint64_t>(x) + carryRed;
+            carryRed = static_cast<uint64_t>(y >> 64);
+            t[j - 1] = static_cast<uint64_t>(y);
+        }
+        t[3] = carryMul + carryRed;
     }
     
-    return result;
+    return ConditionalSubtractModulus(Uint256(t[0], t[1], t[2], t[3]), 0);
 }
 
 FieldElement FieldElement::operator+(const FieldElement& other) const {
@@ -489,6 +546,23 @@ FieldElement FieldElement::Inverse() const {
     return Pow(pMinus2);
 }
 
+FieldElement FieldElement::SumOfProducts(const FieldElement* a, const FieldElement* b, size_t n) {
+    // Each product is below p^2, and 4p < 2^256, so four of them stay below
+    // p * 2^256 as one reduction requires
+    constexpr size_t PRODUCTS_PER_REDUCTION = 4;
+    
+    FieldElement sum;
+    for (size_t begin = 0; begin < n; begin += PRODUCTS_PER_REDUCTION) {
+        uint64_t t[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        size_t end = std::min(n, begin + PRODUCTS_PER_REDUCTION);
+        for (size_t i = begin; i < end; ++i) {
+            MulAddWide(t, a[i].value, b[i].value);
+        }
+        sum.value = ModAdd(sum.value, ReduceWide(t));
+    }
+    return sum;
+}
+
 FieldElement FieldElement::PoseidonSbox() const {
     // S-box: x^5
     FieldElement x2 = Square();
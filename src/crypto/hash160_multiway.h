@@ -0,0 +1,165 @@
+// SHURIUM - Multi-Way Hash160 Kernel
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header, included only by the ISA-specific translation units.
+// Hashes V::LANES independent 33-byte compressed public keys at once, one
+// key per vector lane, with the same lane operations as the multi-way
+// SHA-256 kernel. RIPEMD-160 rotates left and reads little-endian words;
+// both are expressed with Rotr, And and Or, so V needs nothing more.
+//
+// A 33-byte key is one SHA-256 block and its 32-byte digest one RIPEMD-160
+// block, so the padding of both is fixed and the digest words go straight
+// from the SHA-256 state into the RIPEMD-160 schedule.
+
+#ifndef SHURIUM_CRYPTO_HASH160_MULTIWAY_H
+#define SHURIUM_CRYPTO_HASH160_MULTIWAY_H
+
+#include "sha256_multiway.h"
+#include <cstring>
+#include <utility>
+
+namespace shurium {
+namespace hash160_multiway {
+
+/// Message word, rotation and line constants of each RIPEMD-160 step
+constexpr int LEFT_WORD[80] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+    3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+    1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+    4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+
+constexpr int RIGHT_WORD[80] = {
+    5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+    6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+    15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+    8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+    12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+
+constexpr int LEFT_ROTATE[80] = {
+    11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+    7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+    11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+    11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+    9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+
+constexpr int RIGHT_ROTATE[80] = {
+    8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+    9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+    9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+    15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+    8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+
+constexpr uint32_t LEFT_K[5] = {0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E};
+constexpr uint32_t RIGHT_K[5] = {0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000};
+
+constexpr uint32_t RIPEMD160_INIT[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+/// Bytes per key and per digest
+constexpr size_t KEY_SIZE = 33;
+constexpr size_t DIGEST_SIZE = 20;
+
+template <typename V>
+struct Kernel {
+    using T = typename V::T;
+    using SHA = sha256_multiway::Kernel<V>;
+
+    template <int N> static inline T Rotl(T x) { return V::template Rotr<32 - N>(x); }
+    static inline T Not(T x) { return V::Xor(x, V::Set(0xFFFFFFFF)); }
+
+    /// Reverse the bytes of every word
+    static inline T ByteSwap(T x) {
+        return V::Or(V::And(V::template Rotr<8>(x), V::Set(0xFF00FF00)),
+                     V::And(V::template Rotr<24>(x), V::Set(0x00FF00FF)));
+    }
+
+    /// RIPEMD-160 non-linear function of round R (0..4)
+    template <int R>
+    static inline T F(T x, T y, T z) {
+        if constexpr (R == 0) return V::Xor(V::Xor(x, y), z);
+        if constexpr (R == 1) return V::Or(V::And(x, y), V::And(Not(x), z));
+        if constexpr (R == 2) return V::Xor(V::Or(x, Not(y)), z);
+        if constexpr (R == 3) return V::Or(V::And(x, z), V::And(y, Not(z)));
+        if constexpr (R == 4) return V::Xor(x, V::Or(y, Not(z)));
+    }
+
+    /// Step J of one line; the working variables rotate by one slot a step
+    template <int J, int R, int ROT>
+    static inline void Step(T v[5], T x, uint32_t k) {
+        T& a = v[(5 - J % 5) % 5];
+        T b = v[(6 - J % 5) % 5];
+        T& c = v[(7 - J % 5) % 5];
+        T d = v[(8 - J % 5) % 5];
+        T e = v[(9 - J % 5) % 5];
+        T t = V::Add(V::Add(a, F<R>(b, c, d)), V::Add(x, V::Set(k)));
+        a = V::Add(Rotl<ROT>(t), e);
+        c = Rotl<10>(c);
+    }
+
+    template <int... J>
+    static inline void Steps(T l[5], T r[5], const T x[16], std::integer_sequence<int, J...>) {
+        ((Step<J, J / 16, LEFT_ROTATE[J]>(l, x[LEFT_WORD[J]], LEFT_K[J / 16]),
+          Step<J, 4 - J / 16, RIGHT_ROTATE[J]>(r, x[RIGHT_WORD[J]], RIGHT_K[J / 16])), ...);
+    }
+
+    /// out[20*l..] = Hash160(in[33*l..33*l+33]) for each lane l
+    static void Hash160_33(Byte* out, const Byte* in) {
+        // SHA-256 of each key, padded to one block in a lane-strided buffer
+        Byte block[64 * V::LANES] = {};
+        for (size_t l = 0; l < V::LANES; ++l) {
+            Byte* p = block + 64 * l;
+            std::memcpy(p, in + KEY_SIZE * l, KEY_SIZE);
+            p[KEY_SIZE] = 0x80;
+            p[62] = 0x01;  // 264 bits
+            p[63] = 0x08;
+        }
+        T w[16];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = V::LoadBE(block + 4 * i, 64);
+        }
+        T s[8];
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Set(sha256_multiway::INIT[i]);
+        }
+        SHA::Compress(s, w);
+
+        // RIPEMD-160 of the digest: its bytes read as little-endian words
+        T x[16];
+        for (int i = 0; i < 8; ++i) {
+            x[i] = ByteSwap(V::Add(s[i], V::Set(sha256_multiway::INIT[i])));
+        }
+        x[8] = V::Set(0x80);
+        for (int i = 9; i < 16; ++i) {
+            x[i] = V::Set(0);
+        }
+        x[14] = V::Set(256);
+
+        T l[5], r[5];
+        for (int i = 0; i < 5; ++i) {
+            l[i] = r[i] = V::Set(RIPEMD160_INIT[i]);
+        }
+        Steps(l, r, x, std::make_integer_sequence<int, 80>());
+
+        // After 80 steps the slots are back where they started
+        T h[5];
+        for (int i = 0; i < 5; ++i) {
+            h[i] = V::Add(V::Add(V::Set(RIPEMD160_INIT[(i + 1) % 5]), l[(i + 2) % 5]),
+                          r[(i + 3) % 5]);
+        }
+        for (int i = 0; i < 5; ++i) {
+            V::StoreBE(out + 4 * i, DIGEST_SIZE, ByteSwap(h[i]));
+        }
+    }
+};
+
+} // namespace hash160_multiway
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_HASH160_MULTIWAY_H
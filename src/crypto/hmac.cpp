@@ -37,6 +37,19 @@ public:
     
     SHA512Internal() { Reset(); }
     
+    /// Resume from a chaining value reached after `bytes` bytes (a block multiple)
+    SHA512Internal(const uint64_t state[8], uint64_t bytes) : bytes_(bytes), bufferLen_(0) {
+        std::memcpy(state_, state, sizeof(state_));
+    }
+    
+    ~SHA512Internal() {
+        SecureClear(state_, sizeof(state_));
+        SecureClear(buffer_, sizeof(buffer_));
+    }
+    
+    /// Chaining value; only meaningful on a block boundary
+    const uint64_t* State() const { return state_; }
+    
     SHA512Internal& Write(const Byte* data, size_t len) {
         while (len > 0) {
             size_t space = BLOCK_SIZE - bufferLen_;
@@ -418,6 +431,63 @@ HMAC_SHA512& HMAC_SHA512::Reset() {
     return *this;
 }
 
+// ============================================================================
+// HMAC_SHA512_Midstate Implementation
+// ============================================================================
+
+HMAC_SHA512_Midstate::HMAC_SHA512_Midstate(const Byte* key, size_t keyLen) {
+    Byte keyBlock[hmac::SHA512_BLOCK_SIZE] = {0};
+    if (keyLen > hmac::SHA512_BLOCK_SIZE) {
+        SHA512Internal keyHasher;
+        keyHasher.Write(key, keyLen);
+        keyHasher.Finalize(keyBlock);
+    } else if (keyLen > 0) {
+        std::memcpy(keyBlock, key, keyLen);
+    }
+    
+    Byte pad[hmac::SHA512_BLOCK_SIZE];
+    for (size_t i = 0; i < hmac::SHA512_BLOCK_SIZE; ++i) {
+        pad[i] = keyBlock[i] ^ 0x36;
+    }
+    SHA512Internal inner;
+    inner.Write(pad, sizeof(pad));
+    std::memcpy(inner_.data(), inner.State(), sizeof(inner_));
+    
+    for (size_t i = 0; i < hmac::SHA512_BLOCK_SIZE; ++i) {
+        pad[i] = keyBlock[i] ^ 0x5c;
+    }
+    SHA512Internal outer;
+    outer.Write(pad, sizeof(pad));
+    std::memcpy(outer_.data(), outer.State(), sizeof(outer_));
+    
+    SecureClear(pad, sizeof(pad));
+    SecureClear(keyBlock, sizeof(keyBlock));
+}
+
+HMAC_SHA512_Midstate::~HMAC_SHA512_Midstate() {
+    SecureClear(inner_.data(), sizeof(inner_));
+    SecureClear(outer_.data(), sizeof(outer_));
+}
+
+void HMAC_SHA512_Midstate::Compute(const Byte* data, size_t len, Byte mac[OUTPUT_SIZE]) const {
+    Byte innerResult[SHA512Internal::OUTPUT_SIZE];
+    SHA512Internal inner(inner_.data(), hmac::SHA512_BLOCK_SIZE);
+    inner.Write(data, len);
+    inner.Finalize(innerResult);
+    
+    SHA512Internal outer(outer_.data(), hmac::SHA512_BLOCK_SIZE);
+    outer.Write(innerResult, sizeof(innerResult));
+    outer.Finalize(mac);
+    
+    SecureClear(innerResult, sizeof(innerResult));
+}
+
+Hash512 HMAC_SHA512_Midstate::Compute(const Byte* data, size_t len) const {
+    Hash512 result;
+    Compute(data, len, result.data());
+    return result;
+}
+
 // ============================================================================
 // Convenience Functions
 // ============================================================================
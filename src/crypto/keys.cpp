@@ -97,16 +97,7 @@ static void ModNegate(uint8_t* result, const uint8_t* a) {
 // ============================================================================
 
 Hash160 ComputeHash160(const uint8_t* data, size_t len) {
-    // SHA256 first
-    Hash256 sha256_hash = SHA256Hash(data, len);
-    
-    // Then RIPEMD160
-    Hash160 result;
-    RIPEMD160 ripemd;
-    ripemd.Write(sha256_hash.data(), sha256_hash.size());
-    ripemd.Finalize(result.data());
-    
-    return result;
+    return Hash160FromData(data, len);
 }
 
 // ============================================================================
@@ -232,52 +223,8 @@ bool PublicKey::Verify(const Hash256& hash, const std::vector<uint8_t>& signatur
         return false;
     }
     
-#ifdef SHURIUM_USE_OPENSSL
-    // Create EC_KEY for secp256k1
-    EC_KEY* eckey = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!eckey) {
-        return false;
-    }
-    
-    const EC_GROUP* group = EC_KEY_get0_group(eckey);
-    EC_POINT* pub_point = EC_POINT_new(group);
-    if (!pub_point) {
-        EC_KEY_free(eckey);
-        return false;
-    }
-    
-    // Import public key point
-    if (!EC_POINT_oct2point(group, pub_point, data_.data(), size_, nullptr)) {
-        EC_POINT_free(pub_point);
-        EC_KEY_free(eckey);
-        return false;
-    }
-    
-    if (!EC_KEY_set_public_key(eckey, pub_point)) {
-        EC_POINT_free(pub_point);
-        EC_KEY_free(eckey);
-        return false;
-    }
-    
-    EC_POINT_free(pub_point);
-    
-    // Verify signature
-    int result = ECDSA_verify(0, hash.data(), 32, 
-                               signature.data(), static_cast<int>(signature.size()), 
-                               eckey);
-    
-    EC_KEY_free(eckey);
-    
-    return result == 1;
-#else
-    // CRITICAL: ECDSA verification requires OpenSSL
-    // A cryptocurrency cannot function securely without proper cryptographic verification.
-    // If you reach this code path, OpenSSL was not linked during compilation.
-    // Rebuild with: cmake -DSHURIUM_USE_OPENSSL=ON ..
-    (void)hash;
-    (void)signature;
-    throw std::runtime_error("ECDSA verification requires OpenSSL. Rebuild with SHURIUM_USE_OPENSSL=ON");
-#endif
+    return secp256k1::ECDSAVerify(hash.data(), signature.data(), signature.size(),
+                                  data_.data(), size_);
 }
 
 bool PublicKey::VerifySchnorr(const Hash256& hash, const std::array<uint8_t, 64>& signature) const {
@@ -312,6 +259,50 @@ std::array<uint8_t, 32> PublicKey::GetXOnly() const {
     return result;
 }
 
+// ============================================================================
+// SchnorrBatchVerifier
+// ============================================================================
+
+bool SchnorrBatchVerifier::Add(const PublicKey& pubkey, const Hash256& hash,
+                               const std::array<uint8_t, 64>& signature) {
+    Entry entry;
+    entry.hash = hash;
+    entry.signature = signature;
+    entry.xonly = pubkey.GetXOnly();
+    entry.validKey = pubkey.IsValid();
+    entries_.push_back(entry);
+    return entry.validKey;
+}
+
+bool SchnorrBatchVerifier::Verify(std::vector<size_t>* invalid) const {
+    bool ok = std::all_of(entries_.begin(), entries_.end(),
+                          [](const Entry& e) { return e.validKey; });
+    if (ok) {
+        std::vector<const uint8_t*> hashes, signatures, pubkeys;
+        hashes.reserve(entries_.size());
+        signatures.reserve(entries_.size());
+        pubkeys.reserve(entries_.size());
+        for (const Entry& e : entries_) {
+            hashes.push_back(e.hash.data());
+            signatures.push_back(e.signature.data());
+            pubkeys.push_back(e.xonly.data());
+        }
+        ok = secp256k1::SchnorrVerifyBatch(hashes.data(), signatures.data(), pubkeys.data(),
+                                           entries_.size());
+    }
+    if (!ok && invalid) {
+        invalid->clear();
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            const Entry& e = entries_[i];
+            if (!e.validKey ||
+                !secp256k1::SchnorrVerify(e.hash.data(), e.signature.data(), e.xonly.data())) {
+                invalid->push_back(i);
+            }
+        }
+    }
+    return ok;
+}
+
 std::optional<PublicKey> PublicKey::RecoverCompact(const Hash256& hash,
                                                     const std::vector<uint8_t>& signature) {
     if (signature.size() != secp256k1::COMPACT_SIGNATURE_SIZE) {
@@ -424,9 +415,8 @@ std::optional<PublicKey> PublicKey::FromHex(const std::string& hex) {
 
 PrivateKey::PrivateKey(const uint8_t* data, bool compressed)
     : compressed_(compressed) {
-    data_.fill(0);
     if (data) {
-        std::memcpy(data_.data(), data, SIZE);
+        std::memcpy(data_.Writable(), data, SIZE);
         valid_ = Validate();
     } else {
         valid_ = false;
@@ -438,14 +428,13 @@ PrivateKey::~PrivateKey() {
 }
 
 PrivateKey::PrivateKey(PrivateKey&& other) noexcept
-    : data_(other.data_), valid_(other.valid_), compressed_(other.compressed_) {
+    : data_(std::move(other.data_)), valid_(other.valid_), compressed_(other.compressed_) {
     other.Clear();
 }
 
 PrivateKey& PrivateKey::operator=(PrivateKey&& other) noexcept {
     if (this != &other) {
-        Clear();
-        data_ = other.data_;
+        data_ = std::move(other.data_);
         valid_ = other.valid_;
         compressed_ = other.compressed_;
         other.Clear();
@@ -472,7 +461,7 @@ PrivateKey PrivateKey::Generate(bool compressed) {
     
     // Generate random bytes until we get a valid key
     for (int attempts = 0; attempts < 100; ++attempts) {
-        GetRandBytes(key.data_.data(), SIZE);
+        GetStrongRandBytes(key.data_.Writable(), SIZE);
         if (key.Validate()) {
             key.valid_ = true;
             return key;
@@ -492,68 +481,12 @@ PublicKey PrivateKey::GetPublicKey() const {
         return PublicKey();
     }
     
-#ifdef SHURIUM_USE_OPENSSL
-    // Create EC_KEY for secp256k1
-    EC_KEY* eckey = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!eckey) {
+    // pubkey = privateKey * G
+    uint8_t pub_bytes[PublicKey::MAX_SIZE];
+    if (!secp256k1::ComputePublicKey(data_.data(), pub_bytes, compressed_)) {
         return PublicKey();
     }
-    
-    // Set the private key
-    BIGNUM* priv_bn = BN_bin2bn(data_.data(), 32, nullptr);
-    if (!priv_bn) {
-        EC_KEY_free(eckey);
-        return PublicKey();
-    }
-    
-    if (!EC_KEY_set_private_key(eckey, priv_bn)) {
-        BN_free(priv_bn);
-        EC_KEY_free(eckey);
-        return PublicKey();
-    }
-    
-    // Compute public key: pubkey = privateKey * G
-    const EC_GROUP* group = EC_KEY_get0_group(eckey);
-    EC_POINT* pub_point = EC_POINT_new(group);
-    if (!pub_point) {
-        BN_free(priv_bn);
-        EC_KEY_free(eckey);
-        return PublicKey();
-    }
-    
-    if (!EC_POINT_mul(group, pub_point, priv_bn, nullptr, nullptr, nullptr)) {
-        EC_POINT_free(pub_point);
-        BN_free(priv_bn);
-        EC_KEY_free(eckey);
-        return PublicKey();
-    }
-    
-    BN_free(priv_bn);
-    
-    // Convert to bytes
-    point_conversion_form_t form = compressed_ ? POINT_CONVERSION_COMPRESSED : POINT_CONVERSION_UNCOMPRESSED;
-    size_t pub_len = EC_POINT_point2oct(group, pub_point, form, nullptr, 0, nullptr);
-    
-    if (pub_len == 0 || pub_len > PublicKey::MAX_SIZE) {
-        EC_POINT_free(pub_point);
-        EC_KEY_free(eckey);
-        return PublicKey();
-    }
-    
-    std::vector<uint8_t> pub_bytes(pub_len);
-    EC_POINT_point2oct(group, pub_point, form, pub_bytes.data(), pub_len, nullptr);
-    
-    EC_POINT_free(pub_point);
-    EC_KEY_free(eckey);
-    
-    return PublicKey(pub_bytes.data(), pub_bytes.size());
-#else
-    // CRITICAL: Public key derivation requires OpenSSL
-    // A cryptocurrency cannot function without proper key derivation.
-    // Rebuild with: cmake -DSHURIUM_USE_OPENSSL=ON ..
-    (void)compressed_;  // Suppress unused variable warning
-    throw std::runtime_error("Public key derivation requires OpenSSL. Rebuild with SHURIUM_USE_OPENSSL=ON");
-#endif
+    return PublicKey(pub_bytes, compressed_ ? PublicKey::COMPRESSED_SIZE : PublicKey::MAX_SIZE);
 }
 
 std::vector<uint8_t> PrivateKey::Sign(const Hash256& hash) const {
@@ -668,7 +601,7 @@ PrivateKey PrivateKey::Negate() const {
     }
     
     PrivateKey result;
-    ModNegate(result.data_.data(), data_.data());
+    ModNegate(result.data_.Writable(), data_.data());
     result.compressed_ = compressed_;
     result.valid_ = result.Validate();
     return result;
@@ -680,7 +613,7 @@ std::optional<PrivateKey> PrivateKey::TweakAdd(const Hash256& tweak) const {
     }
     
     PrivateKey result;
-    ModAdd(result.data_.data(), data_.data(), tweak.data());
+    ModAdd(result.data_.Writable(), data_.data(), tweak.data());
     result.compressed_ = compressed_;
     
     if (!result.Validate()) {
@@ -771,8 +704,8 @@ std::optional<PrivateKey> PrivateKey::FromHex(const std::string& hex) {
 }
 
 void PrivateKey::Clear() {
-    // Secure clear - write zeros then random data then zeros again
-    std::memset(data_.data(), 0, SIZE);
+    // The pool zeroes the slot as it takes it back
+    data_.Release();
     valid_ = false;
 }
 
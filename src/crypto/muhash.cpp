@@ -0,0 +1,215 @@
+// SHURIUM - MuHash Rolling Set Hash Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/crypto/muhash.h"
+#include "shurium/crypto/sha256.h"
+#include <cstring>
+
+namespace shurium {
+
+namespace {
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+constexpr uint64_t LIMB_MAX = ~uint64_t{0};
+
+/// Limbs of the inversion exponent p - 2 (all ones above the lowest limb)
+constexpr uint64_t INVERSE_EXPONENT_LOW = LIMB_MAX - Num3072::MAX_PRIME_DIFF - 1;
+
+/// Bits per window when exponentiating
+constexpr int WINDOW_BITS = 4;
+
+} // namespace
+
+// ============================================================================
+// Num3072
+// ============================================================================
+
+Num3072::Num3072(const Byte (&data)[BYTE_SIZE]) {
+    for (size_t i = 0; i < LIMBS; ++i) {
+        uint64_t limb = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            limb |= static_cast<uint64_t>(data[i * 8 + j]) << (8 * j);
+        }
+        limbs[i] = limb;
+    }
+    if (IsOverflow()) {
+        FullReduce();
+    }
+}
+
+void Num3072::SetToOne() {
+    limbs[0] = 1;
+    for (size_t i = 1; i < LIMBS; ++i) {
+        limbs[i] = 0;
+    }
+}
+
+bool Num3072::IsOverflow() const {
+    if (limbs[0] <= LIMB_MAX - MAX_PRIME_DIFF) {
+        return false;
+    }
+    for (size_t i = 1; i < LIMBS; ++i) {
+        if (limbs[i] != LIMB_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Num3072::FullReduce() {
+    // x - p = x + MAX_PRIME_DIFF - 2^3072, and the 2^3072 falls off the top
+    uint64_t carry = MAX_PRIME_DIFF;
+    for (size_t i = 0; i < LIMBS && carry; ++i) {
+        uint128_t cur = static_cast<uint128_t>(limbs[i]) + carry;
+        limbs[i] = static_cast<uint64_t>(cur);
+        carry = static_cast<uint64_t>(cur >> 64);
+    }
+}
+
+void Num3072::Multiply(const Num3072& a) {
+    uint64_t product[2 * LIMBS] = {};
+    for (size_t i = 0; i < LIMBS; ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < LIMBS; ++j) {
+            uint128_t cur = static_cast<uint128_t>(limbs[i]) * a.limbs[j] +
+                            product[i + j] + carry;
+            product[i + j] = static_cast<uint64_t>(cur);
+            carry = static_cast<uint64_t>(cur >> 64);
+        }
+        product[i + LIMBS] = carry;
+    }
+
+    // 2^3072 = MAX_PRIME_DIFF (mod p): fold the high half into the low half
+    uint64_t carry = 0;
+    for (size_t i = 0; i < LIMBS; ++i) {
+        uint128_t cur = static_cast<uint128_t>(product[i + LIMBS]) * MAX_PRIME_DIFF +
+                        product[i] + carry;
+        limbs[i] = static_cast<uint64_t>(cur);
+        carry = static_cast<uint64_t>(cur >> 64);
+    }
+
+    // The leftover carry is small; fold it until nothing spills past the top
+    while (carry) {
+        uint128_t add = static_cast<uint128_t>(carry) * MAX_PRIME_DIFF;
+        for (size_t i = 0; i < LIMBS && add; ++i) {
+            uint128_t cur = static_cast<uint128_t>(limbs[i]) + static_cast<uint64_t>(add);
+            limbs[i] = static_cast<uint64_t>(cur);
+            add = (add >> 64) + (cur >> 64);
+        }
+        carry = static_cast<uint64_t>(add);
+    }
+
+    if (IsOverflow()) {
+        FullReduce();
+    }
+}
+
+Num3072 Num3072::GetInverse() const {
+    // Fermat: a^(p-2) = a^-1 (mod p), with a fixed window over the exponent
+    Num3072 table[1 << WINDOW_BITS];
+    table[1] = *this;
+    for (size_t w = 2; w < (1u << WINDOW_BITS); ++w) {
+        table[w] = table[w - 1];
+        table[w].Multiply(*this);
+    }
+
+    Num3072 result;
+    for (size_t i = LIMBS; i-- > 0;) {
+        const uint64_t exponent = (i == 0) ? INVERSE_EXPONENT_LOW : LIMB_MAX;
+        for (int shift = 64 - WINDOW_BITS; shift >= 0; shift -= WINDOW_BITS) {
+            for (int s = 0; s < WINDOW_BITS; ++s) {
+                result.Multiply(result);
+            }
+            const size_t window = (exponent >> shift) & ((1u << WINDOW_BITS) - 1);
+            if (window) {
+                result.Multiply(table[window]);
+            }
+        }
+    }
+    return result;
+}
+
+void Num3072::Divide(const Num3072& a) {
+    Multiply(a.GetInverse());
+}
+
+void Num3072::ToBytes(Byte (&out)[BYTE_SIZE]) const {
+    for (size_t i = 0; i < LIMBS; ++i) {
+        for (size_t j = 0; j < 8; ++j) {
+            out[i * 8 + j] = static_cast<Byte>(limbs[i] >> (8 * j));
+        }
+    }
+}
+
+bool Num3072::operator==(const Num3072& other) const {
+    return std::memcmp(limbs, other.limbs, sizeof(limbs)) == 0;
+}
+
+// ============================================================================
+// MuHash3072
+// ============================================================================
+
+Num3072 MuHash3072::ToNum3072(const Byte* data, size_t len) {
+    Byte seed[SHA256::OUTPUT_SIZE];
+    SHA256().Write(data, len).Finalize(seed);
+
+    // Expand the digest to 384 bytes: SHA256(seed || counter)
+    Byte expanded[Num3072::BYTE_SIZE];
+    static_assert(Num3072::BYTE_SIZE % SHA256::OUTPUT_SIZE == 0, "whole blocks");
+    for (uint32_t i = 0; i < Num3072::BYTE_SIZE / SHA256::OUTPUT_SIZE; ++i) {
+        Byte counter[4] = {
+            static_cast<Byte>(i),
+            static_cast<Byte>(i >> 8),
+            static_cast<Byte>(i >> 16),
+            static_cast<Byte>(i >> 24),
+        };
+        SHA256()
+            .Write(seed, sizeof(seed))
+            .Write(counter, sizeof(counter))
+            .Finalize(expanded + i * SHA256::OUTPUT_SIZE);
+    }
+    return Num3072(expanded);
+}
+
+MuHash3072& MuHash3072::Insert(const Byte* data, size_t len) {
+    m_numerator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(const Byte* data, size_t len) {
+    m_denominator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& other) {
+    m_numerator.Multiply(other.m_numerator);
+    m_denominator.Multiply(other.m_denominator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator/=(const MuHash3072& other) {
+    m_numerator.Multiply(other.m_denominator);
+    m_denominator.Multiply(other.m_numerator);
+    return *this;
+}
+
+Hash256 MuHash3072::Finalize() const {
+    Num3072 value = m_numerator;
+    value.Divide(m_denominator);
+
+    Byte bytes[Num3072::BYTE_SIZE];
+    value.ToBytes(bytes);
+
+    Hash256 out;
+    SHA256().Write(bytes, sizeof(bytes)).Finalize(out.data());
+    return out;
+}
+
+bool MuHash3072::IsEmpty() const {
+    const Num3072 one;
+    return m_numerator == one && m_denominator == one;
+}
+
+} // namespace shurium
@@ -6,7 +6,11 @@
 
 #include "shurium/crypto/poseidon.h"
 #include "shurium/crypto/sha256.h"
+#include <algorithm>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace shurium {
 
@@ -74,10 +78,10 @@ std::vector<FieldElement> GenerateRoundConstants(size_t width, size_t totalRound
     return constants;
 }
 
-/// Generate MDS matrix deterministically
+/// Generate MDS matrix deterministically (row-major, width x width)
 /// Uses a Cauchy matrix construction for guaranteed MDS property
-std::vector<std::vector<FieldElement>> GenerateMDSMatrix(size_t width) {
-    std::vector<std::vector<FieldElement>> mds(width, std::vector<FieldElement>(width));
+std::vector<FieldElement> GenerateMDSMatrix(size_t width) {
+    std::vector<FieldElement> mds(width * width);
     
     // Cauchy matrix: M[i][j] = 1 / (x_i + y_j)
     // where x_i = i, y_j = width + j
@@ -87,46 +91,225 @@ std::vector<std::vector<FieldElement>> GenerateMDSMatrix(size_t width) {
         for (size_t j = 0; j < width; ++j) {
             // x_i + y_j = i + (width + j)
             FieldElement sum = FieldElement(static_cast<uint64_t>(i + width + j));
-            mds[i][j] = sum.Inverse();
+            mds[i * width + j] = sum.Inverse();
         }
     }
     
     return mds;
 }
 
+/// Invert an n x n row-major matrix in place by Gauss-Jordan elimination.
+/// Returns false if it is singular.
+bool InvertMatrix(std::vector<FieldElement>& m, size_t n) {
+    std::vector<FieldElement> inv(n * n, FieldElement::Zero());
+    for (size_t i = 0; i < n; ++i) {
+        inv[i * n + i] = FieldElement::One();
+    }
+    
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        while (pivot < n && m[pivot * n + col].IsZero()) {
+            ++pivot;
+        }
+        if (pivot == n) {
+            return false;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            std::swap(m[col * n + k], m[pivot * n + k]);
+            std::swap(inv[col * n + k], inv[pivot * n + k]);
+        }
+        
+        FieldElement scale = m[col * n + col].Inverse();
+        for (size_t k = 0; k < n; ++k) {
+            m[col * n + k] *= scale;
+            inv[col * n + k] *= scale;
+        }
+        for (size_t row = 0; row < n; ++row) {
+            if (row == col || m[row * n + col].IsZero()) continue;
+            FieldElement factor = m[row * n + col];
+            for (size_t k = 0; k < n; ++k) {
+                m[row * n + k] -= factor * m[col * n + k];
+                inv[row * n + k] -= factor * inv[col * n + k];
+            }
+        }
+    }
+    
+    m = std::move(inv);
+    return true;
+}
+
 } // anonymous namespace
 
 // ============================================================================
-// Poseidon Implementation
+// Precomputed Constants
 // ============================================================================
 
-Poseidon::Poseidon() : Poseidon(PoseidonParams::CONFIG_STANDARD) {}
+/// Everything a permutation reads besides the state. The partial rounds can
+/// run on an equivalent, cheaper form (Poseidon paper, appendix B):
+///
+///  - Only state[0] passes through the S-box in a partial round, so the
+///    constants added to the other words commute with it and are pushed
+///    forward through the MDS matrix into the next round. Each partial round
+///    is left adding a single constant to state[0], and what remains after
+///    the last one is folded into the first full round that follows.
+///
+///  - Working back from the last partial round, each round's matrix A is
+///    split as A = S * diag(1, D), where D is A without its first row and
+///    column and S is identity except for its first row and column. The
+///    diag(1, D) factor commutes with that round's S-box and constant, so it
+///    moves into the previous round's matrix; the last full round before the
+///    partial rounds absorbs the final one. Each partial round then costs
+///    2 * width - 1 multiplications instead of width^2.
+struct PoseidonConstants {
+    /// Round constants, width per round, in round order
+    std::vector<FieldElement> roundConstants;
+    
+    /// MDS matrix (width x width, row-major)
+    std::vector<FieldElement> mds;
+    
+    /// Whether the partial rounds use the sparse form below
+    bool sparse = false;
+    
+    /// Matrix for the last full round before the partial rounds
+    std::vector<FieldElement> preSparseMds;
+    
+    /// Constant each partial round adds to state[0]
+    std::vector<FieldElement> partialConstants;
+    
+    /// Per partial round, 2 * width - 1 entries: the first row of S, then
+    /// its first column below the diagonal
+    std::vector<FieldElement> sparseMatrices;
+    
+    /// Constants of the first full round after the partial rounds
+    std::vector<FieldElement> postPartialConstants;
+};
 
-Poseidon::Poseidon(const PoseidonConfig& config)
-    : config_(config)
-    , state_(config.width, FieldElement::Zero())
-    , absorbPos_(0)
-    , squeezing_(false) {
-    InitConstants();
-}
+namespace {
 
-void Poseidon::InitConstants() {
-    // Generate round constants
-    auto flatConstants = GenerateRoundConstants(config_.width, config_.totalRounds());
+/// Derive the sparse partial-round form; leaves c.sparse false when the
+/// configuration has no full round to absorb the leftover matrix, or when
+/// some D is singular
+void ComputeSparseRounds(const PoseidonConfig& config, PoseidonConstants& c) {
+    const size_t width = config.width;
+    const size_t halfFullRounds = config.fullRounds / 2;
+    const size_t partialRounds = config.partialRounds;
+    if (width < 2 || halfFullRounds == 0 || partialRounds == 0) {
+        return;
+    }
+    const std::vector<FieldElement>& mds = c.mds;
+    
+    // Move constants off state[1..] into the following round
+    std::vector<FieldElement> partialConstants(partialRounds);
+    std::vector<FieldElement> carry(width, FieldElement::Zero());
+    std::vector<FieldElement> moved(width, FieldElement::Zero());
+    for (size_t r = 0; r < partialRounds; ++r) {
+        const FieldElement* rc = &c.roundConstants[(halfFullRounds + r) * width];
+        partialConstants[r] = rc[0] + carry[0];
+        for (size_t i = 1; i < width; ++i) {
+            moved[i] = rc[i] + carry[i];
+        }
+        for (size_t i = 0; i < width; ++i) {
+            carry[i] = FieldElement::Zero();
+            for (size_t j = 1; j < width; ++j) {
+                carry[i] += mds[i * width + j] * moved[j];
+            }
+        }
+    }
+    std::vector<FieldElement> postPartial(width);
+    const FieldElement* rcPost = &c.roundConstants[(halfFullRounds + partialRounds) * width];
+    for (size_t i = 0; i < width; ++i) {
+        postPartial[i] = rcPost[i] + carry[i];
+    }
     
-    roundConstants_.resize(config_.totalRounds());
-    size_t idx = 0;
-    for (size_t r = 0; r < config_.totalRounds(); ++r) {
-        roundConstants_[r].resize(config_.width);
-        for (size_t i = 0; i < config_.width; ++i) {
-            roundConstants_[r][i] = flatConstants[idx++];
+    // Factor the matrices from the last partial round backwards
+    const size_t n = width - 1;
+    const size_t stride = 2 * width - 1;
+    std::vector<FieldElement> sparse(partialRounds * stride);
+    std::vector<FieldElement> a = mds;
+    std::vector<FieldElement> d(n * n);
+    for (size_t r = partialRounds; r-- > 0;) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                d[i * n + j] = a[(i + 1) * width + j + 1];
+            }
+        }
+        std::vector<FieldElement> dInv = d;
+        if (!InvertMatrix(dInv, n)) {
+            return;
+        }
+        
+        // S = [a00, b^T * D^-1; a[1..][0], I]
+        FieldElement* s = &sparse[r * stride];
+        s[0] = a[0];
+        for (size_t j = 0; j < n; ++j) {
+            FieldElement sum = FieldElement::Zero();
+            for (size_t i = 0; i < n; ++i) {
+                sum += a[i + 1] * dInv[i * n + j];
+            }
+            s[1 + j] = sum;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            s[width + i] = a[(i + 1) * width];
+        }
+        
+        // The previous round mixes with diag(1, D) * MDS
+        for (size_t k = 0; k < width; ++k) {
+            a[k] = mds[k];
+        }
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t k = 0; k < width; ++k) {
+                FieldElement sum = FieldElement::Zero();
+                for (size_t l = 0; l < n; ++l) {
+                    sum += d[i * n + l] * mds[(l + 1) * width + k];
+                }
+                a[(i + 1) * width + k] = sum;
+            }
         }
     }
     
-    // Generate MDS matrix
-    mdsMatrix_ = GenerateMDSMatrix(config_.width);
+    c.preSparseMds = std::move(a);
+    c.partialConstants = std::move(partialConstants);
+    c.sparseMatrices = std::move(sparse);
+    c.postPartialConstants = std::move(postPartial);
+    c.sparse = true;
+}
+
+std::unique_ptr<const PoseidonConstants> BuildConstants(const PoseidonConfig& config) {
+    auto c = std::make_unique<PoseidonConstants>();
+    c->roundConstants = GenerateRoundConstants(config.width, config.totalRounds());
+    c->mds = GenerateMDSMatrix(config.width);
+    ComputeSparseRounds(config, *c);
+    return c;
+}
+
+} // anonymous namespace
+
+const PoseidonConstants& PoseidonConfig::Constants() const {
+    static std::mutex mutex;
+    static std::map<std::array<size_t, 3>, std::unique_ptr<const PoseidonConstants>> cache;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[{width, fullRounds, partialRounds}];
+    if (!entry) {
+        entry = BuildConstants(*this);
+    }
+    return *entry;
 }
 
+// ============================================================================
+// Poseidon Implementation
+// ============================================================================
+
+Poseidon::Poseidon() : Poseidon(PoseidonParams::CONFIG_STANDARD) {}
+
+Poseidon::Poseidon(const PoseidonConfig& config)
+    : config_(config)
+    , state_(config.width, FieldElement::Zero())
+    , absorbPos_(0)
+    , squeezing_(false)
+    , constants_(&config.Constants())
+    , scratch_(config.width) {}
+
 Poseidon& Poseidon::Reset() {
     state_.assign(config_.width, FieldElement::Zero());
     absorbPos_ = 0;
@@ -138,27 +321,28 @@ FieldElement Poseidon::Sbox(const FieldElement& x) {
     return x.PoseidonSbox();  // x^5
 }
 
-void Poseidon::AddRoundConstants(size_t roundIdx) {
+void Poseidon::AddRoundConstants(const FieldElement* roundConstants) {
     for (size_t i = 0; i < config_.width; ++i) {
-        state_[i] += roundConstants_[roundIdx][i];
+        state_[i] += roundConstants[i];
     }
 }
 
-void Poseidon::MixColumns() {
-    std::vector<FieldElement> newState(config_.width, FieldElement::Zero());
-    
-    for (size_t i = 0; i < config_.width; ++i) {
-        for (size_t j = 0; j < config_.width; ++j) {
-            newState[i] += mdsMatrix_[i][j] * state_[j];
+void Poseidon::MixColumns(const FieldElement* matrix) {
+    const size_t width = config_.width;
+    for (size_t i = 0; i < width; ++i) {
+        const FieldElement* row = matrix + i * width;
+        FieldElement sum = row[0] * state_[0];
+        for (size_t j = 1; j < width; ++j) {
+            sum += row[j] * state_[j];
         }
+        scratch_[i] = sum;
     }
-    
-    state_ = std::move(newState);
+    state_.swap(scratch_);
 }
 
-void Poseidon::FullRound(size_t roundIdx) {
+void Poseidon::FullRound(const FieldElement* roundConstants, const FieldElement* matrix) {
     // Add round constants
-    AddRoundConstants(roundIdx);
+    AddRoundConstants(roundConstants);
     
     // Apply S-box to ALL state elements
     for (size_t i = 0; i < config_.width; ++i) {
@@ -166,37 +350,71 @@ void Poseidon::FullRound(size_t roundIdx) {
     }
     
     // Mix columns (MDS matrix multiplication)
-    MixColumns();
+    MixColumns(matrix);
 }
 
 void Poseidon::PartialRound(size_t roundIdx) {
     // Add round constants
-    AddRoundConstants(roundIdx);
+    AddRoundConstants(&constants_->roundConstants[roundIdx * config_.width]);
     
     // Apply S-box to FIRST element only
     state_[0] = Sbox(state_[0]);
     
     // Mix columns (MDS matrix multiplication)
-    MixColumns();
+    MixColumns(constants_->mds.data());
+}
+
+void Poseidon::SparsePartialRound(size_t partialIdx) {
+    const size_t width = config_.width;
+    const FieldElement* s = &constants_->sparseMatrices[partialIdx * (2 * width - 1)];
+    
+    FieldElement x0 = Sbox(state_[0] + constants_->partialConstants[partialIdx]);
+    
+    // state = S * state, with S identity outside its first row and column
+    FieldElement first = s[0] * x0;
+    for (size_t i = 1; i < width; ++i) {
+        first += s[i] * state_[i];
+    }
+    for (size_t i = 1; i < width; ++i) {
+        state_[i] += s[width + i - 1] * x0;
+    }
+    state_[0] = first;
 }
 
 void Poseidon::Permute() {
+    const PoseidonConstants& c = *constants_;
+    const size_t width = config_.width;
+    const size_t halfFullRounds = config_.fullRounds / 2;
+    const FieldElement* mds = c.mds.data();
     size_t roundIdx = 0;
-    size_t halfFullRounds = config_.fullRounds / 2;
     
-    // First half of full rounds
+    // First half of full rounds; with sparse partial rounds the last one
+    // also applies the factor they leave over
     for (size_t i = 0; i < halfFullRounds; ++i) {
-        FullRound(roundIdx++);
+        const bool lastBeforePartial = c.sparse && i + 1 == halfFullRounds;
+        FullRound(&c.roundConstants[roundIdx * width],
+                  lastBeforePartial ? c.preSparseMds.data() : mds);
+        ++roundIdx;
     }
     
     // Partial rounds
     for (size_t i = 0; i < config_.partialRounds; ++i) {
-        PartialRound(roundIdx++);
+        if (c.sparse) {
+            SparsePartialRound(i);
+        } else {
+            PartialRound(roundIdx);
+        }
+        ++roundIdx;
     }
     
-    // Second half of full rounds
+    // Second half of full rounds; the first picks up the constants moved
+    // out of the sparse partial rounds
     for (size_t i = 0; i < halfFullRounds; ++i) {
-        FullRound(roundIdx++);
+        const bool firstAfterPartial = c.sparse && i == 0;
+        FullRound(firstAfterPartial ? c.postPartialConstants.data()
+                                    : &c.roundConstants[roundIdx * width],
+                  mds);
+        ++roundIdx;
     }
 }
 
@@ -301,6 +519,127 @@ FieldElement Poseidon::Hash2(const FieldElement& left, const FieldElement& right
     return hasher.Squeeze();
 }
 
+namespace {
+
+/// Permutations HashMany runs in lockstep. Each step of a round is applied
+/// to every lane before the next, so one lane's multiplications fill the
+/// latency of another's dependency chain.
+constexpr size_t HASH_MANY_LANES = 4;
+
+/// Permute `lanes` states of config.width words each, stored one after
+/// another, with the sparse partial rounds; scratch holds as many words
+void PermuteLanes(const PoseidonConfig& config, const PoseidonConstants& c,
+                  FieldElement* states, FieldElement* scratch, size_t lanes) {
+    const size_t width = config.width;
+    const size_t halfFullRounds = config.fullRounds / 2;
+    
+    auto fullRound = [&](const FieldElement* rc, const FieldElement* matrix) {
+        for (size_t l = 0; l < lanes; ++l) {
+            FieldElement* s = states + l * width;
+            for (size_t i = 0; i < width; ++i) {
+                s[i] = (s[i] + rc[i]).PoseidonSbox();
+            }
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            const FieldElement* s = states + l * width;
+            FieldElement* out = scratch + l * width;
+            for (size_t i = 0; i < width; ++i) {
+                const FieldElement* row = matrix + i * width;
+                FieldElement sum = row[0] * s[0];
+                for (size_t j = 1; j < width; ++j) {
+                    sum += row[j] * s[j];
+                }
+                out[i] = sum;
+            }
+        }
+        std::copy(scratch, scratch + lanes * width, states);
+    };
+    
+    size_t roundIdx = 0;
+    for (size_t i = 0; i < halfFullRounds; ++i) {
+        fullRound(&c.roundConstants[roundIdx * width],
+                  i + 1 == halfFullRounds ? c.preSparseMds.data() : c.mds.data());
+        ++roundIdx;
+    }
+    
+    for (size_t r = 0; r < config.partialRounds; ++r) {
+        const FieldElement* sparse = &c.sparseMatrices[r * (2 * width - 1)];
+        const FieldElement& k = c.partialConstants[r];
+        FieldElement x[HASH_MANY_LANES];
+        FieldElement x2[HASH_MANY_LANES];
+        for (size_t l = 0; l < lanes; ++l) {
+            x[l] = states[l * width] + k;
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            x2[l] = x[l].Square();
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            x2[l] = x2[l].Square();
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            states[l * width] = x2[l] * x[l];
+        }
+        for (size_t l = 0; l < lanes; ++l) {
+            FieldElement* s = states + l * width;
+            FieldElement x0 = s[0];
+            FieldElement first = sparse[0] * x0;
+            for (size_t i = 1; i < width; ++i) {
+                first += sparse[i] * s[i];
+            }
+            for (size_t i = 1; i < width; ++i) {
+                s[i] += sparse[width + i - 1] * x0;
+            }
+            s[0] = first;
+        }
+        ++roundIdx;
+    }
+    
+    for (size_t i = 0; i < halfFullRounds; ++i) {
+        fullRound(i == 0 ? c.postPartialConstants.data() : &c.roundConstants[roundIdx * width],
+                  c.mds.data());
+        ++roundIdx;
+    }
+}
+
+} // anonymous namespace
+
+std::vector<FieldElement> Poseidon::HashMany(
+    Span<const std::pair<FieldElement, FieldElement>> pairs) {
+    const PoseidonConfig& config = PoseidonParams::CONFIG_2_1;
+    const PoseidonConstants& c = config.Constants();
+    std::vector<FieldElement> results(pairs.size());
+    
+    if (!c.sparse) {
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            results[i] = Hash2(pairs[i].first, pairs[i].second);
+        }
+        return results;
+    }
+    
+    // Hash2 absorbs left and right into the rate words of a zero state,
+    // permutes once and squeezes word 0
+    const size_t width = config.width;
+    std::vector<FieldElement> states(HASH_MANY_LANES * width);
+    std::vector<FieldElement> scratch(HASH_MANY_LANES * width);
+    for (size_t base = 0; base < pairs.size(); base += HASH_MANY_LANES) {
+        size_t lanes = std::min(HASH_MANY_LANES, pairs.size() - base);
+        for (size_t l = 0; l < lanes; ++l) {
+            FieldElement* s = &states[l * width];
+            s[0] = pairs[base + l].first;
+            s[1] = pairs[base + l].second;
+            for (size_t i = 2; i < width; ++i) {
+                s[i] = FieldElement::Zero();
+            }
+        }
+        PermuteLanes(config, c, states.data(), scratch.data(), lanes);
+        for (size_t l = 0; l < lanes; ++l) {
+            results[base + l] = states[l * width];
+        }
+    }
+    
+    return results;
+}
+
 FieldElement Poseidon::HashBytes(const Byte* data, size_t len) {
     Poseidon hasher;
     hasher.AbsorbBytes(data, len);
@@ -6,6 +6,8 @@
 
 #include "shurium/crypto/ripemd160.h"
 #include "shurium/crypto/sha256.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 
 namespace shurium {
@@ -100,35 +102,15 @@ inline void WriteLE64(Byte* ptr, uint64_t val) {
     ptr[7] = static_cast<Byte>(val >> 56);
 }
 
-} // anonymous namespace
-
-// ============================================================================
-// RIPEMD160 Implementation
-// ============================================================================
-
-RIPEMD160::RIPEMD160() {
-    Reset();
-}
-
-RIPEMD160& RIPEMD160::Reset() {
-    std::memcpy(state_, RIPEMD160_INIT, sizeof(state_));
-    bytes_ = 0;
-    return *this;
-}
-
-void RIPEMD160::Transform(const Byte block[BLOCK_SIZE]) {
-    uint32_t a1 = state_[0], b1 = state_[1], c1 = state_[2], d1 = state_[3], e1 = state_[4];
+/// Compress one block given as sixteen little-endian words
+inline void Compress(uint32_t* state, const uint32_t* w) {
+    uint32_t a1 = state[0], b1 = state[1], c1 = state[2], d1 = state[3], e1 = state[4];
     uint32_t a2 = a1, b2 = b1, c2 = c1, d2 = d1, e2 = e1;
     
-    // Read message words
-    uint32_t w0  = ReadLE32(block + 0),  w1  = ReadLE32(block + 4);
-    uint32_t w2  = ReadLE32(block + 8),  w3  = ReadLE32(block + 12);
-    uint32_t w4  = ReadLE32(block + 16), w5  = ReadLE32(block + 20);
-    uint32_t w6  = ReadLE32(block + 24), w7  = ReadLE32(block + 28);
-    uint32_t w8  = ReadLE32(block + 32), w9  = ReadLE32(block + 36);
-    uint32_t w10 = ReadLE32(block + 40), w11 = ReadLE32(block + 44);
-    uint32_t w12 = ReadLE32(block + 48), w13 = ReadLE32(block + 52);
-    uint32_t w14 = ReadLE32(block + 56), w15 = ReadLE32(block + 60);
+    const uint32_t w0  = w[0],  w1  = w[1],  w2  = w[2],  w3  = w[3];
+    const uint32_t w4  = w[4],  w5  = w[5],  w6  = w[6],  w7  = w[7];
+    const uint32_t w8  = w[8],  w9  = w[9],  w10 = w[10], w11 = w[11];
+    const uint32_t w12 = w[12], w13 = w[13], w14 = w[14], w15 = w[15];
     
     // Round 1 - both paths
     R11(a1, b1, c1, d1, e1, w0, 11);  R12(a2, b2, c2, d2, e2, w5, 8);
@@ -221,12 +203,52 @@ void RIPEMD160::Transform(const Byte block[BLOCK_SIZE]) {
     R51(b1, c1, d1, e1, a1, w13, 6);  R52(b2, c2, d2, e2, a2, w11, 11);
     
     // Final addition
-    uint32_t t = state_[0];
-    state_[0] = state_[1] + c1 + d2;
-    state_[1] = state_[2] + d1 + e2;
-    state_[2] = state_[3] + e1 + a2;
-    state_[3] = state_[4] + a1 + b2;
-    state_[4] = t + b1 + c2;
+    uint32_t t = state[0];
+    state[0] = state[1] + c1 + d2;
+    state[1] = state[2] + d1 + e2;
+    state[2] = state[3] + e1 + a2;
+    state[3] = state[4] + a1 + b2;
+    state[4] = t + b1 + c2;
+}
+
+/// RIPEMD-160 of a 32-byte digest: one block whose padding is fixed
+void RIPEMD160_32(Byte* out, const Byte* digest) {
+    uint32_t w[16] = {};
+    for (int i = 0; i < 8; ++i) {
+        w[i] = ReadLE32(digest + 4 * i);
+    }
+    w[8] = 0x80;
+    w[14] = 256;
+    uint32_t state[5];
+    std::memcpy(state, RIPEMD160_INIT, sizeof(state));
+    Compress(state, w);
+    for (int i = 0; i < 5; ++i) {
+        WriteLE32(out + 4 * i, state[i]);
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// RIPEMD160 Implementation
+// ============================================================================
+
+RIPEMD160::RIPEMD160() {
+    Reset();
+}
+
+RIPEMD160& RIPEMD160::Reset() {
+    std::memcpy(state_, RIPEMD160_INIT, sizeof(state_));
+    bytes_ = 0;
+    return *this;
+}
+
+void RIPEMD160::Transform(const Byte block[BLOCK_SIZE]) {
+    uint32_t w[16];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ReadLE32(block + 4 * i);
+    }
+    Compress(state_, w);
 }
 
 RIPEMD160& RIPEMD160::Write(const Byte* data, size_t len) {
@@ -290,19 +312,180 @@ Hash160 RIPEMD160Hash(const Byte* data, size_t len) {
 Hash160 Hash160FromData(const Byte* data, size_t len) {
     // Hash160 = RIPEMD160(SHA256(data))
     std::array<Byte, SHA256::OUTPUT_SIZE> sha256Hash;
-    std::array<Byte, RIPEMD160::OUTPUT_SIZE> ripemd160Hash;
-    
-    // First compute SHA256
     SHA256 sha256;
     sha256.Write(data, len);
     sha256.Finalize(sha256Hash.data());
     
-    // Then RIPEMD160 of the SHA256 result
-    RIPEMD160 ripemd160;
-    ripemd160.Write(sha256Hash.data(), sha256Hash.size());
-    ripemd160.Finalize(ripemd160Hash.data());
-    
-    return Hash160(ripemd160Hash);
+    Hash160 result;
+    RIPEMD160_32(result.data(), sha256Hash.data());
+    return result;
+}
+
+// ============================================================================
+// Multi-Key Hash160
+// ============================================================================
+
+#if defined(SHURIUM_SHA256_SSE41)
+namespace sha256_sse41 {
+void Hash160_33_4way(Byte* out, const Byte* in);
+}
+#endif
+
+#if defined(SHURIUM_SHA256_AVX2)
+namespace sha256_avx2 {
+void Hash160_33_8way(Byte* out, const Byte* in);
+}
+#endif
+
+#if defined(SHURIUM_SHA256_AVX512)
+namespace sha256_avx512 {
+void Hash160_33_16way(Byte* out, const Byte* in);
+}
+#endif
+
+namespace {
+
+/// Hashes as many keys as the kernel has lanes
+using Hash160Fn = void (*)(Byte* out, const Byte* in);
+
+constexpr size_t KEY_SIZE = 33;
+
+/// One key through the dispatched SHA-256 transform
+void Hash160_33_1way(Byte* out, const Byte* in) {
+    Byte digest[SHA256::OUTPUT_SIZE];
+    SHA256().Write(in, KEY_SIZE).Finalize(digest);
+    RIPEMD160_32(out, digest);
+}
+
+/// Multi-key kernel of the given width, or null if not built in or not supported
+Hash160Fn GetSupportedHash160(size_t ways) {
+    // The kernels share translation units, compiler flags and CPU
+    // requirements with the multi-message SHA-256 kernels of their width
+    std::vector<size_t> supported = GetAvailableSHA256D64Ways();
+    if (std::find(supported.begin(), supported.end(), ways) == supported.end()) {
+        return nullptr;
+    }
+    switch (ways) {
+#if defined(SHURIUM_SHA256_SSE41)
+        case 4: return sha256_sse41::Hash160_33_4way;
+#endif
+#if defined(SHURIUM_SHA256_AVX2)
+        case 8: return sha256_avx2::Hash160_33_8way;
+#endif
+#if defined(SHURIUM_SHA256_AVX512)
+        case 16: return sha256_avx512::Hash160_33_16way;
+#endif
+        default: return nullptr;
+    }
+}
+
+/// A kernel is used only if it matches the single-key path on every lane
+bool SelfTestHash160(Hash160Fn kernel, size_t ways) {
+    Byte in[KEY_SIZE * 16];
+    for (size_t i = 0; i < sizeof(in); ++i) {
+        in[i] = static_cast<Byte>(i * 29 + 3);
+    }
+    Byte out[RIPEMD160::OUTPUT_SIZE * 16];
+    Byte expected[RIPEMD160::OUTPUT_SIZE * 16];
+    kernel(out, in);
+    for (size_t i = 0; i < ways; ++i) {
+        Hash160_33_1way(expected + i * RIPEMD160::OUTPUT_SIZE, in + i * KEY_SIZE);
+    }
+    return std::memcmp(out, expected, RIPEMD160::OUTPUT_SIZE * ways) == 0;
+}
+
+Hash160Fn GetVerifiedHash160(size_t ways) {
+    Hash160Fn kernel = GetSupportedHash160(ways);
+    return kernel && SelfTestHash160(kernel, ways) ? kernel : nullptr;
+}
+
+/// Kernel widths, widest first; 1 is the single-key path
+constexpr size_t HASH160_WAYS[] = {16, 8, 4, 1};
+
+struct Hash160Dispatch {
+    Hash160Fn x16 = nullptr;
+    Hash160Fn x8 = nullptr;
+    Hash160Fn x4 = nullptr;
+    std::atomic<size_t> ways{1};
+
+    Hash160Dispatch() {
+        x16 = GetVerifiedHash160(16);
+        x8 = GetVerifiedHash160(8);
+        x4 = GetVerifiedHash160(4);
+        for (size_t candidate : HASH160_WAYS) {
+            if (IsAvailable(candidate)) {
+                ways.store(candidate, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    bool IsAvailable(size_t candidate) const {
+        switch (candidate) {
+            case 1: return true;
+            case 4: return x4 != nullptr;
+            case 8: return x8 != nullptr;
+            case 16: return x16 != nullptr;
+            default: return false;
+        }
+    }
+};
+
+Hash160Dispatch& GetHash160Dispatch() {
+    static Hash160Dispatch dispatch;
+    return dispatch;
+}
+
+} // anonymous namespace
+
+void Hash160_33(Byte* out, const Byte* in, size_t count) {
+    Hash160Dispatch& dispatch = GetHash160Dispatch();
+    size_t ways = dispatch.ways.load(std::memory_order_relaxed);
+    constexpr size_t OUT = RIPEMD160::OUTPUT_SIZE;
+
+    // Widest kernel first; the narrower ones take what is left
+    if (ways >= 16 && dispatch.x16) {
+        for (; count >= 16; count -= 16, in += KEY_SIZE * 16, out += OUT * 16) {
+            dispatch.x16(out, in);
+        }
+    }
+    if (ways >= 8 && dispatch.x8) {
+        for (; count >= 8; count -= 8, in += KEY_SIZE * 8, out += OUT * 8) {
+            dispatch.x8(out, in);
+        }
+    }
+    if (ways >= 4 && dispatch.x4) {
+        for (; count >= 4; count -= 4, in += KEY_SIZE * 4, out += OUT * 4) {
+            dispatch.x4(out, in);
+        }
+    }
+    for (; count > 0; --count, in += KEY_SIZE, out += OUT) {
+        Hash160_33_1way(out, in);
+    }
+}
+
+size_t GetHash160Ways() {
+    return GetHash160Dispatch().ways.load(std::memory_order_relaxed);
+}
+
+std::vector<size_t> GetAvailableHash160Ways() {
+    Hash160Dispatch& dispatch = GetHash160Dispatch();
+    std::vector<size_t> result;
+    for (size_t ways : HASH160_WAYS) {
+        if (dispatch.IsAvailable(ways)) {
+            result.push_back(ways);
+        }
+    }
+    return result;
+}
+
+bool SetHash160Ways(size_t ways) {
+    Hash160Dispatch& dispatch = GetHash160Dispatch();
+    if (!dispatch.IsAvailable(ways)) {
+        return false;
+    }
+    dispatch.ways.store(ways, std::memory_order_relaxed);
+    return true;
 }
 
 } // namespace shurium
@@ -4,8 +4,12 @@
 
 #include "shurium/crypto/secp256k1.h"
 #include "shurium/crypto/sha256.h"
+#include "shurium/core/random.h"
+#include "secp256k1_ecmult.h"
+#include "secp256k1_ecmult_gen.h"
+#include <algorithm>
 #include <cstring>
-#include <random>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -82,6 +86,41 @@ bool IsZero32(const uint8_t* a) {
     return true;
 }
 
+/// One DER INTEGER at in[pos], left-padded into out; advances pos
+bool ParseDERInteger(const uint8_t* in, size_t len, size_t& pos, uint8_t out[32]) {
+    if (pos + 2 > len || in[pos] != 0x02) return false;
+    size_t intLen = in[pos + 1];
+    pos += 2;
+    if (intLen == 0 || intLen >= 0x80 || pos + intLen > len) return false;
+    const uint8_t* p = in + pos;
+    // Non-negative and minimally encoded
+    if (p[0] & 0x80) return false;
+    if (intLen > 1 && p[0] == 0 && !(p[1] & 0x80)) return false;
+    if (p[0] == 0 && intLen > 1) {
+        ++p;
+        --intLen;
+    }
+    if (intLen > 32) return false;
+    std::memset(out, 0, 32);
+    std::memcpy(out + 32 - intLen, p, intLen);
+    pos += (p - (in + pos)) + intLen;
+    return true;
+}
+
+/**
+ * r and s of a strict DER signature: exactly the encodings OpenSSL's
+ * ECDSA_verify accepts (it re-encodes the parsed signature and compares),
+ * so switching verification backends does not change which signatures
+ * are valid.
+ */
+bool ParseStrictDER(const uint8_t* sig, size_t sigLen, uint8_t r[32], uint8_t s[32]) {
+    if (sigLen < 8 || sig[0] != 0x30 || sig[1] >= 0x80 || sig[1] != sigLen - 2) return false;
+    size_t pos = 2;
+    return ParseDERInteger(sig, sigLen, pos, r) &&
+           ParseDERInteger(sig, sigLen, pos, s) &&
+           pos == sigLen;
+}
+
 } // anonymous namespace
 
 // ============================================================================
@@ -249,13 +288,7 @@ Scalar Scalar::Inverse() const {
 Scalar Scalar::Random() {
     Scalar result;
     do {
-        if (RAND_bytes(result.data_.data(), SIZE) != 1) {
-            std::random_device rd;
-            std::mt19937_64 gen(rd());
-            for (auto& b : result.data_) {
-                b = static_cast<uint8_t>(gen() & 0xff);
-            }
-        }
+        GetRandBytes(result.data_.data(), SIZE);
     } while (!result.IsValid());
     return result;
 }
@@ -496,12 +529,8 @@ Scalar Scalar::Inverse() const {
 
 Scalar Scalar::Random() {
     Scalar result;
-    std::random_device rd;
-    std::mt19937_64 gen(rd());
     do {
-        for (auto& b : result.data_) {
-            b = static_cast<uint8_t>(gen() & 0xff);
-        }
+        GetRandBytes(result.data_.data(), SIZE);
     } while (!result.IsValid());
     return result;
 }
@@ -553,256 +582,55 @@ bool FieldElement::operator==(const FieldElement& other) const {
     return Compare32(data_.data(), other.data_.data()) == 0;
 }
 
-// Field arithmetic - similar to Scalar but mod p instead of n
-#ifdef SHURIUM_USE_OPENSSL
-
-FieldElement FieldElement::operator+(const FieldElement& other) const {
-    FieldElement result;
-    BIGNUM* a = BN_bin2bn(data_.data(), SIZE, nullptr);
-    BIGNUM* b = BN_bin2bn(other.data_.data(), SIZE, nullptr);
-    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
-    BIGNUM* r = BN_new();
-    BN_CTX* ctx = BN_CTX_new();
-    
-    if (a && b && p && r && ctx) {
-        BN_mod_add(r, a, b, p, ctx);
-        int len = BN_num_bytes(r);
-        if (len <= 32) {
-            BN_bn2bin(r, result.data_.data() + (32 - len));
-        }
-    }
-    
-    BN_free(a); BN_free(b); BN_free(p); BN_free(r); BN_CTX_free(ctx);
-    return result;
-}
-
-FieldElement FieldElement::operator-(const FieldElement& other) const {
-    FieldElement result;
-    BIGNUM* a = BN_bin2bn(data_.data(), SIZE, nullptr);
-    BIGNUM* b = BN_bin2bn(other.data_.data(), SIZE, nullptr);
-    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
-    BIGNUM* r = BN_new();
-    BN_CTX* ctx = BN_CTX_new();
-    
-    if (a && b && p && r && ctx) {
-        BN_mod_sub(r, a, b, p, ctx);
-        int len = BN_num_bytes(r);
-        if (len <= 32) {
-            BN_bn2bin(r, result.data_.data() + (32 - len));
-        }
-    }
-    
-    BN_free(a); BN_free(b); BN_free(p); BN_free(r); BN_CTX_free(ctx);
-    return result;
-}
-
-FieldElement FieldElement::operator*(const FieldElement& other) const {
-    FieldElement result;
-    BIGNUM* a = BN_bin2bn(data_.data(), SIZE, nullptr);
-    BIGNUM* b = BN_bin2bn(other.data_.data(), SIZE, nullptr);
-    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
-    BIGNUM* r = BN_new();
-    BN_CTX* ctx = BN_CTX_new();
-    
-    if (a && b && p && r && ctx) {
-        BN_mod_mul(r, a, b, p, ctx);
-        int len = BN_num_bytes(r);
-        if (len <= 32) {
-            BN_bn2bin(r, result.data_.data() + (32 - len));
-        }
-    }
-    
-    BN_free(a); BN_free(b); BN_free(p); BN_free(r); BN_CTX_free(ctx);
-    return result;
-}
-
-FieldElement FieldElement::operator-() const {
-    if (IsZero()) return *this;
-    FieldElement result;
-    BIGNUM* a = BN_bin2bn(data_.data(), SIZE, nullptr);
-    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
-    BIGNUM* r = BN_new();
-    BN_CTX* ctx = BN_CTX_new();
-    
-    if (a && p && r && ctx) {
-        BN_mod_sub(r, p, a, p, ctx);
-        int len = BN_num_bytes(r);
-        if (len <= 32) {
-            BN_bn2bin(r, result.data_.data() + (32 - len));
-        }
-    }
-    
-    BN_free(a); BN_free(p); BN_free(r); BN_CTX_free(ctx);
-    return result;
-}
-
-FieldElement FieldElement::Inverse() const {
-    FieldElement result;
-    BIGNUM* a = BN_bin2bn(data_.data(), SIZE, nullptr);
-    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
-    BIGNUM* r = BN_new();
-    BN_CTX* ctx = BN_CTX_new();
-    
-    if (a && p && r && ctx) {
-        BN_mod_inverse(r, a, p, ctx);
-        int len = BN_num_bytes(r);
-        if (len <= 32) {
-            BN_bn2bin(r, result.data_.data() + (32 - len));
-        }
-    }
-    
-    BN_free(a); BN_free(p); BN_free(r); BN_CTX_free(ctx);
-    return result;
-}
+// Field arithmetic runs on the native 5x52 representation for both backends
+namespace {
 
-FieldElement FieldElement::Square() const {
-    return *this * *this;
+field::Fe LoadFe(const FieldElement& a) {
+    field::Fe r;
+    field::FeFromBytes(r, a.data());
+    return r;
 }
 
-std::optional<FieldElement> FieldElement::Sqrt() const {
-    // For secp256k1, p = 3 mod 4, so sqrt(a) = a^((p+1)/4) if it exists
-    FieldElement result;
-    BIGNUM* a = BN_bin2bn(data_.data(), SIZE, nullptr);
-    BIGNUM* p = BN_bin2bn(FIELD_PRIME.data(), 32, nullptr);
-    BIGNUM* exp = BN_new();
-    BIGNUM* r = BN_new();
-    BN_CTX* ctx = BN_CTX_new();
-    
-    bool valid = false;
-    if (a && p && exp && r && ctx) {
-        // exp = (p + 1) / 4
-        BN_add_word(p, 1);
-        BN_rshift(exp, p, 2);
-        BN_sub_word(p, 1);  // restore p
-        
-        BN_mod_exp(r, a, exp, p, ctx);
-        
-        // Verify: r^2 mod p == a
-        BIGNUM* check = BN_new();
-        BN_mod_sqr(check, r, p, ctx);
-        if (BN_cmp(check, a) == 0) {
-            valid = true;
-            int len = BN_num_bytes(r);
-            if (len <= 32) {
-                BN_bn2bin(r, result.data_.data() + (32 - len));
-            }
-        }
-        BN_free(check);
-    }
-    
-    BN_free(a); BN_free(p); BN_free(exp); BN_free(r); BN_CTX_free(ctx);
-    
-    if (valid) return result;
-    return std::nullopt;
+FieldElement StoreFe(const field::Fe& a) {
+    std::array<uint8_t, 32> out;
+    field::FeToBytes(out.data(), a);
+    return FieldElement(out);
 }
 
-#else
-// ============================================================================
-// FieldElement Fallback - Pure C++ implementation
-// ============================================================================
+} // namespace
 
 FieldElement FieldElement::operator+(const FieldElement& other) const {
-    FieldElement result;
-    uint16_t carry = 0;
-    for (int i = 31; i >= 0; --i) {
-        uint16_t sum = static_cast<uint16_t>(data_[i]) + other.data_[i] + carry;
-        result.data_[i] = sum & 0xff;
-        carry = sum >> 8;
-    }
-    // Reduce mod p if needed
-    if (carry || Compare32(result.data_.data(), FIELD_PRIME.data()) >= 0) {
-        uint16_t borrow = 0;
-        for (int i = 31; i >= 0; --i) {
-            int16_t diff = static_cast<int16_t>(result.data_[i]) - FIELD_PRIME[i] - borrow;
-            if (diff < 0) { diff += 256; borrow = 1; } else { borrow = 0; }
-            result.data_[i] = diff & 0xff;
-        }
-    }
-    return result;
+    return StoreFe(field::FeAdd(LoadFe(*this), LoadFe(other)));
 }
 
 FieldElement FieldElement::operator-(const FieldElement& other) const {
-    return *this + (-other);
+    return StoreFe(field::FeSub(LoadFe(*this), LoadFe(other)));
 }
 
 FieldElement FieldElement::operator*(const FieldElement& other) const {
-    FieldElement result;
-    Uint512 prod = Uint512::FromProduct(data_.data(), other.data_.data());
-    ReduceMod(prod, FIELD_PRIME.data(), result.data_.data());
-    return result;
+    return StoreFe(field::FeMul(LoadFe(*this), LoadFe(other)));
 }
 
 FieldElement FieldElement::operator-() const {
-    if (IsZero()) return *this;
-    FieldElement result;
-    uint16_t borrow = 0;
-    for (int i = 31; i >= 0; --i) {
-        int16_t diff = static_cast<int16_t>(FIELD_PRIME[i]) - data_[i] - borrow;
-        if (diff < 0) { diff += 256; borrow = 1; } else { borrow = 0; }
-        result.data_[i] = diff & 0xff;
-    }
-    return result;
+    return StoreFe(field::FeNeg(LoadFe(*this)));
 }
 
 FieldElement FieldElement::Inverse() const {
-    if (IsZero()) return FieldElement();
-    FieldElement result;
-    ModInverse(data_.data(), FIELD_PRIME.data(), result.data_.data());
-    return result;
+    return StoreFe(field::FeInv(LoadFe(*this)));
 }
 
 FieldElement FieldElement::Square() const {
-    return *this * *this;
+    return StoreFe(field::FeSqr(LoadFe(*this)));
 }
 
 std::optional<FieldElement> FieldElement::Sqrt() const {
-    // For secp256k1, p ≡ 3 (mod 4), so sqrt(a) = a^((p+1)/4) if it exists
-    // (p+1)/4 = 0x3fffffffffffffffffffffffffffffffffffffffffffffffffffffffbfffff0c
-    
-    // Compute a^((p+1)/4) using square-and-multiply
-    // First, compute (p+1)/4
-    uint8_t exp[32];
-    std::memcpy(exp, FIELD_PRIME.data(), 32);
-    
-    // Add 1 to p (it won't overflow since p < 2^256 - 1)
-    int carry = 1;
-    for (int i = 31; i >= 0 && carry; --i) {
-        int sum = static_cast<int>(exp[i]) + carry;
-        exp[i] = sum & 0xff;
-        carry = sum >> 8;
-    }
-    
-    // Divide by 4 (right shift by 2)
-    for (int i = 0; i < 32; ++i) {
-        uint8_t next = (i < 31) ? exp[i + 1] : 0;
-        exp[i] = (exp[i] >> 2) | ((next & 3) << 6);
-    }
-    
-    // Compute a^exp mod p
-    FieldElement result;
-    result.data_[31] = 1;  // Start with 1
-    
-    FieldElement base = *this;
-    
-    // Square and multiply (from LSB to MSB)
-    for (int i = 31; i >= 0; --i) {
-        for (int bit = 0; bit < 8; ++bit) {
-            if (exp[i] & (1 << bit)) {
-                result = result * base;
-            }
-            base = base.Square();
-        }
-    }
-    
-    // Verify: result^2 should equal *this
-    FieldElement check = result.Square();
-    if (check == *this) {
-        return result;
+    // For secp256k1, p = 3 mod 4, so sqrt(a) = a^((p+1)/4) if it exists
+    field::Fe r;
+    if (!field::FeSqrt(r, LoadFe(*this))) {
+        return std::nullopt;
     }
-    
-    return std::nullopt;
+    return StoreFe(r);
 }
-#endif
 
 // ============================================================================
 // Point Implementation
@@ -1226,19 +1054,24 @@ Point Point::Infinity() {
 
 std::optional<Point> ScalarBaseMultiply(const Scalar& scalar) {
     if (!scalar.IsValid()) return std::nullopt;
-    Point result;
-#ifdef SHURIUM_USE_OPENSSL
-    if (result.impl_->group && result.impl_->point) {
-        BIGNUM* k = BN_bin2bn(scalar.data(), 32, nullptr);
-        if (k) {
-            EC_POINT_mul(result.impl_->group, result.impl_->point, k, nullptr, nullptr, result.impl_->ctx);
-            BN_free(k);
-        }
+    uint8_t x[32], y[32];
+    if (!EcmultGen(scalar.data(), x, y)) return std::nullopt;
+    return Point(FieldElement(x), FieldElement(y));
+}
+
+bool ComputePublicKey(const uint8_t* privateKey, uint8_t* pubkey, bool compressed) {
+    if (!IsValidPrivateKey(privateKey)) return false;
+    uint8_t x[32], y[32];
+    if (!EcmultGen(privateKey, x, y)) return false;
+    if (compressed) {
+        pubkey[0] = (y[31] & 1) ? 0x03 : 0x02;
+        std::memcpy(pubkey + 1, x, 32);
+    } else {
+        pubkey[0] = 0x04;
+        std::memcpy(pubkey + 1, x, 32);
+        std::memcpy(pubkey + 33, y, 32);
     }
-#else
-    result = Point::Generator() * scalar;
-#endif
-    return result;
+    return true;
 }
 
 Point ScalarMultiply(const Scalar& scalar, const Point& point) {
@@ -1246,24 +1079,24 @@ Point ScalarMultiply(const Scalar& scalar, const Point& point) {
 }
 
 Point DoubleScalarMultiply(const Scalar& a, const Scalar& b, const Point& P) {
-    Point result;
-#ifdef SHURIUM_USE_OPENSSL
-    if (result.impl_->group && result.impl_->point && P.impl_->point) {
-        BIGNUM* ba = BN_bin2bn(a.data(), 32, nullptr);
-        BIGNUM* bb = BN_bin2bn(b.data(), 32, nullptr);
-        if (ba && bb) {
-            EC_POINT_mul(result.impl_->group, result.impl_->point, ba, P.impl_->point, bb, result.impl_->ctx);
-        }
-        BN_free(ba);
-        BN_free(bb);
-    }
-#else
-    auto aG = ScalarBaseMultiply(a);
-    if (aG) {
-        result = *aG + (P * b);
+    scalar::Sc sa, sb;
+    scalar::ScFromBytes(sa, a.data());
+    scalar::ScFromBytes(sb, b.data());
+    if (P.IsInfinity() || scalar::ScIsZero(sb)) {
+        auto aG = ScalarBaseMultiply(a);
+        return aG ? *aG : Point();
     }
-#endif
-    return result;
+
+    AffinePoint p;
+    field::FeFromBytes(p.x, P.GetX().data());
+    field::FeFromBytes(p.y, P.GetY().data());
+    AffinePoint r;
+    if (!EcmultDouble(r, sa, p, sb)) return Point();
+
+    uint8_t x[32], y[32];
+    field::FeToBytes(x, r.x);
+    field::FeToBytes(y, r.y);
+    return Point(FieldElement(x), FieldElement(y));
 }
 
 bool IsValidPrivateKey(const uint8_t* key) {
@@ -1315,6 +1148,41 @@ bool PublicKeyTweakAdd(const uint8_t* pubkey, size_t pubkeyLen,
     return true;
 }
 
+bool PublicKeyTweakAddBatch(const uint8_t* pubkey, size_t pubkeyLen,
+                            const uint8_t* tweaks, size_t count,
+                            uint8_t* results, bool* valid) {
+    // Same encodings as Point::FromBytes, so no hybrid keys
+    if (pubkeyLen != 33 && !(pubkeyLen == 65 && pubkey[0] == 0x04)) return false;
+    AffinePoint P;
+    if (!ParsePoint(P, pubkey, pubkeyLen)) return false;
+    if (count == 0) return true;
+    
+    uint8_t px[32], py[32];
+    field::FeToBytes(px, P.x);
+    field::FeToBytes(py, P.y);
+    std::vector<uint8_t> xs(32 * count), ys(32 * count);
+    std::unique_ptr<bool[]> finite(new bool[count]);
+    EcmultGenAddBatch(px, py, tweaks, count, xs.data(), ys.data(), finite.get());
+    
+    for (size_t k = 0; k < count; ++k) {
+        uint8_t* out = results + pubkeyLen * k;
+        const uint8_t* x = xs.data() + 32 * k;
+        const uint8_t* y = ys.data() + 32 * k;
+        valid[k] = finite[k] && IsValidPrivateKey(tweaks + 32 * k);
+        if (!valid[k]) {
+            std::memset(out, 0, pubkeyLen);
+        } else if (pubkeyLen == 33) {
+            out[0] = (y[31] & 1) ? 0x03 : 0x02;
+            std::memcpy(out + 1, x, 32);
+        } else {
+            out[0] = 0x04;
+            std::memcpy(out + 1, x, 32);
+            std::memcpy(out + 33, y, 32);
+        }
+    }
+    return true;
+}
+
 void PrivateKeyNegate(const uint8_t* key, uint8_t* result) {
     Scalar k(key);
     Scalar neg = -k;
@@ -1499,99 +1367,59 @@ bool ECDSASign(const uint8_t* hash, const uint8_t* privateKey,
 #endif
 }
 
+namespace {
+
+bool ECDSAVerifyPoint(const uint8_t* hash, const uint8_t* signature, size_t sigLen,
+                      const AffinePoint& P) {
+    uint8_t rBytes[32], sBytes[32];
+    if (!ParseStrictDER(signature, sigLen, rBytes, sBytes)) return false;
+
+    scalar::Sc r, s, z;
+    if (scalar::ScFromBytes(r, rBytes) || scalar::ScIsZero(r)) return false;
+    if (scalar::ScFromBytes(s, sBytes) || scalar::ScIsZero(s)) return false;
+    scalar::ScFromBytes(z, hash);
+
+    // R = u1*G + u2*P with u1 = z/s, u2 = r/s; valid iff R.x mod n == r
+    scalar::Sc sInv = scalar::ScInv(s);
+    AffinePoint R;
+    if (!EcmultDouble(R, scalar::ScMul(z, sInv), P, scalar::ScMul(r, sInv))) return false;
+
+    uint8_t xBytes[32];
+    field::FeToBytes(xBytes, R.x);
+    scalar::Sc xr;
+    scalar::ScFromBytes(xr, xBytes);
+    return scalar::ScEqual(xr, r);
+}
+
+} // anonymous namespace
+
 bool ECDSAVerify(const uint8_t* hash,
                  const uint8_t* signature, size_t sigLen,
                  const uint8_t* publicKey, size_t pubkeyLen) {
-#ifdef SHURIUM_USE_OPENSSL
-    EC_KEY* key = EC_KEY_new_by_curve_name(NID_secp256k1);
-    if (!key) return false;
-    
-    EC_POINT* pub = EC_POINT_new(EC_KEY_get0_group(key));
-    if (!pub) { EC_KEY_free(key); return false; }
-    
-    if (EC_POINT_oct2point(EC_KEY_get0_group(key), pub, publicKey, pubkeyLen, nullptr) != 1) {
-        EC_POINT_free(pub); EC_KEY_free(key); return false;
-    }
-    
-    if (EC_KEY_set_public_key(key, pub) != 1) {
-        EC_POINT_free(pub); EC_KEY_free(key); return false;
-    }
-    
-    const uint8_t* sigPtr = signature;
-    ECDSA_SIG* sig = d2i_ECDSA_SIG(nullptr, &sigPtr, static_cast<long>(sigLen));
-    if (!sig) {
-        EC_POINT_free(pub); EC_KEY_free(key); return false;
-    }
-    
-    int result = ECDSA_do_verify(hash, 32, sig, key);
-    
-    ECDSA_SIG_free(sig);
-    EC_POINT_free(pub);
-    EC_KEY_free(key);
-    return result == 1;
-#else
-    // Pure C++ ECDSA verification
-    // Verify: (u1*G + u2*P).x == r where u1 = z*s^-1, u2 = r*s^-1
-    
-    // Parse DER signature to get r and s
-    if (sigLen < 8 || signature[0] != 0x30) return false;
-    
-    size_t pos = 2;  // Skip 30 <len>
-    if (signature[pos] != 0x02) return false;
-    pos++;
-    
-    uint8_t rLen = signature[pos++];
-    if (rLen > 33 || pos + rLen > sigLen) return false;
-    
-    uint8_t rBytes[32] = {0};
-    if (rLen <= 32) {
-        std::memcpy(rBytes + (32 - rLen), signature + pos, rLen);
-    } else {
-        // Skip leading zero padding
-        std::memcpy(rBytes, signature + pos + (rLen - 32), 32);
-    }
-    pos += rLen;
-    
-    if (signature[pos] != 0x02) return false;
-    pos++;
-    
-    uint8_t sLen = signature[pos++];
-    if (sLen > 33 || pos + sLen > sigLen) return false;
-    
-    uint8_t sBytes[32] = {0};
-    if (sLen <= 32) {
-        std::memcpy(sBytes + (32 - sLen), signature + pos, sLen);
-    } else {
-        std::memcpy(sBytes, signature + pos + (sLen - 32), 32);
+    AffinePoint P;
+    if (!ParsePoint(P, publicKey, pubkeyLen)) return false;
+    return ECDSAVerifyPoint(hash, signature, sigLen, P);
+}
+
+bool ParsePublicKey(ParsedPublicKey& out, const uint8_t* publicKey, size_t pubkeyLen) {
+    AffinePoint P;
+    if (!ParsePoint(P, publicKey, pubkeyLen)) return false;
+    field::FeToBytes(out.xy.data(), P.x);
+    field::FeToBytes(out.xy.data() + 32, P.y);
+    return true;
+}
+
+bool ECDSAVerify(const uint8_t* hash,
+                 const uint8_t* signature, size_t sigLen,
+                 const ParsedPublicKey& publicKey) {
+    // ParsePublicKey only writes coordinates below p; the range checks are
+    // for structs filled in some other way
+    AffinePoint P;
+    if (!field::FeFromBytes(P.x, publicKey.xy.data()) ||
+        !field::FeFromBytes(P.y, publicKey.xy.data() + 32)) {
+        return false;
     }
-    
-    Scalar r(rBytes);
-    Scalar s(sBytes);
-    Scalar z(hash);
-    
-    if (!r.IsValid() || !s.IsValid()) return false;
-    
-    // Parse public key
-    auto P = Point::FromBytes(publicKey, pubkeyLen);
-    if (!P || P->IsInfinity()) return false;
-    
-    // u1 = z * s^-1 mod n
-    // u2 = r * s^-1 mod n
-    Scalar sInv = s.Inverse();
-    Scalar u1 = z * sInv;
-    Scalar u2 = r * sInv;
-    
-    // R = u1*G + u2*P
-    Point R = DoubleScalarMultiply(u1, u2, *P);
-    
-    if (R.IsInfinity()) return false;
-    
-    // Verify R.x mod n == r
-    auto Rx = R.GetX();
-    Scalar rCalc(Rx.data());
-    
-    return rCalc == r;
-#endif
+    return ECDSAVerifyPoint(hash, signature, sigLen, P);
 }
 
 bool ECDSASignCompact(const uint8_t* hash, const uint8_t* privateKey,
@@ -1995,114 +1823,109 @@ bool SchnorrSign(const uint8_t* hash, const uint8_t* privateKey,
 
 bool SchnorrVerify(const uint8_t* hash, const uint8_t signature[64],
                    const uint8_t publicKey[32]) {
-#ifdef SHURIUM_USE_OPENSSL
     // BIP340 Schnorr verification
     // https://github.com/bitcoin/bips/blob/master/bip-0340.mediawiki
-    
-    // Step 1: Verify signature components are valid
-    // r = signature[0:32] (x-coordinate of R)
-    // s = signature[32:64] (scalar)
-    
-    // Check r < p (field prime)
-    if (Compare32(signature, FIELD_PRIME.data()) >= 0) {
-        return false;
-    }
-    
-    Scalar s(signature + 32);
-    
-    // Check s < n (curve order)
-    if (!s.IsValid() && !s.IsZero()) {
-        return false;
-    }
-    // s = 0 is technically valid but unusual
-    
-    // Step 2: Lift x-only public key to full point
-    // BIP340 specifies P has even y coordinate
-    uint8_t compressed[33];
-    compressed[0] = 0x02;  // Try even y first
-    std::memcpy(compressed + 1, publicKey, 32);
-    
-    auto P = Point::FromCompressed(compressed);
-    if (!P || P->IsInfinity()) {
-        // If even y doesn't work, the public key is invalid
-        // (BIP340 keys always have even y)
-        return false;
-    }
-    
-    // Step 3: Compute challenge e = tagged_hash("BIP0340/challenge", r || P.x || m)
-    uint8_t challengeInput[96];
-    std::memcpy(challengeInput, signature, 32);      // r (R.x from signature)
-    std::memcpy(challengeInput + 32, publicKey, 32); // P.x
-    std::memcpy(challengeInput + 64, hash, 32);      // message hash
-    Hash256 eHash = TaggedHash("BIP0340/challenge", challengeInput, 96);
-    Scalar e(eHash.data());
-    
-    // Step 4: Compute R' = s*G - e*P
-    Scalar negE = -e;
-    Point Rprime = DoubleScalarMultiply(s, negE, *P);
-    
-    // Step 5: Verify R'
-    // R' must not be infinity
-    if (Rprime.IsInfinity()) {
-        return false;
-    }
-    
-    // R'.y must be even (BIP340 requirement)
-    if (Rprime.GetY().IsOdd()) {
-        return false;
-    }
-    
-    // R'.x must equal r (first 32 bytes of signature)
-    auto RprimeX = Rprime.GetX();
-    return std::memcmp(RprimeX.data(), signature, 32) == 0;
-#else
-    // Pure C++ BIP340 Schnorr verification
-    
-    // Check r < p
-    if (Compare32(signature, FIELD_PRIME.data()) >= 0) {
+
+    // r = signature[0:32] must be a field element, s = signature[32:64] below n
+    field::Fe r;
+    if (!field::FeFromBytes(r, signature)) {
         return false;
     }
-    
-    Scalar s(signature + 32);
-    if (!s.IsValid() && !s.IsZero()) {
+    scalar::Sc s;
+    if (scalar::ScFromBytes(s, signature + 32)) {
         return false;
     }
-    
+
     // Lift x-only public key (BIP340 keys have even y)
-    uint8_t compressed[33];
-    compressed[0] = 0x02;
-    std::memcpy(compressed + 1, publicKey, 32);
-    
-    auto P = Point::FromCompressed(compressed);
-    if (!P || P->IsInfinity()) {
+    field::Fe px;
+    AffinePoint P;
+    if (!field::FeFromBytes(px, publicKey) || !LiftX(P, px)) {
         return false;
     }
-    
+
     // Challenge e = tagged_hash("BIP0340/challenge", r || P.x || m)
     uint8_t challengeInput[96];
     std::memcpy(challengeInput, signature, 32);
     std::memcpy(challengeInput + 32, publicKey, 32);
     std::memcpy(challengeInput + 64, hash, 32);
     Hash256 eHash = TaggedHash("BIP0340/challenge", challengeInput, 96);
-    Scalar e(eHash.data());
-    
-    // R' = s*G - e*P
-    Scalar negE = -e;
-    Point Rprime = DoubleScalarMultiply(s, negE, *P);
-    
-    if (Rprime.IsInfinity()) {
+    scalar::Sc e;
+    scalar::ScFromBytes(e, eHash.data());
+
+    // R' = s*G - e*P must be finite, with even y and x equal to r
+    AffinePoint Rprime;
+    if (!EcmultDouble(Rprime, s, P, scalar::ScNeg(e))) {
         return false;
     }
-    
-    // R'.y must be even
-    if (Rprime.GetY().IsOdd()) {
-        return false;
+    return !field::FeIsOdd(Rprime.y) && field::FeEqual(Rprime.x, r);
+}
+
+namespace {
+
+/// One chunk of SchnorrVerifyBatch
+bool SchnorrVerifyChunk(const uint8_t* const* hashes, const uint8_t* const* signatures,
+                        const uint8_t* const* publicKeys, size_t count) {
+    // Weights are seeded by everything being verified
+    std::vector<uint8_t> transcript;
+    transcript.reserve(count * 128);
+    for (size_t i = 0; i < count; ++i) {
+        transcript.insert(transcript.end(), hashes[i], hashes[i] + 32);
+        transcript.insert(transcript.end(), signatures[i], signatures[i] + 64);
+        transcript.insert(transcript.end(), publicKeys[i], publicKeys[i] + 32);
+    }
+    Hash256 seed = TaggedHash("SHURIUM/schnorr-batch", transcript.data(), transcript.size());
+
+    // Points R_i, P_i with scalars -a_i, -a_i*e_i; G gets sum a_i*s_i
+    std::vector<AffinePoint> points(2 * count);
+    std::vector<scalar::Sc> scalars(2 * count);
+    scalar::Sc g = scalar::SC_ZERO;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* sig = signatures[i];
+        field::Fe rx, px;
+        scalar::Sc s;
+        if (!field::FeFromBytes(rx, sig) || !LiftX(points[2 * i], rx)) return false;
+        if (scalar::ScFromBytes(s, sig + 32)) return false;
+        if (!field::FeFromBytes(px, publicKeys[i]) || !LiftX(points[2 * i + 1], px)) return false;
+
+        uint8_t challengeInput[96];
+        std::memcpy(challengeInput, sig, 32);
+        std::memcpy(challengeInput + 32, publicKeys[i], 32);
+        std::memcpy(challengeInput + 64, hashes[i], 32);
+        Hash256 eHash = TaggedHash("BIP0340/challenge", challengeInput, 96);
+        scalar::Sc e;
+        scalar::ScFromBytes(e, eHash.data());
+
+        // a_0 = 1; the rest are the low 128 bits of H(seed || i)
+        scalar::Sc a = {{1, 0, 0, 0}};
+        if (i > 0) {
+            uint8_t weightInput[40];
+            std::memcpy(weightInput, seed.data(), 32);
+            for (int j = 0; j < 8; ++j) {
+                weightInput[32 + j] = static_cast<uint8_t>(static_cast<uint64_t>(i) >> (8 * j));
+            }
+            Hash256 w = SHA256Hash(weightInput, sizeof(weightInput));
+            std::memcpy(&a.n[0], w.data(), 8);
+            std::memcpy(&a.n[1], w.data() + 8, 8);
+        }
+
+        g = scalar::ScAdd(g, scalar::ScMul(a, s));
+        scalars[2 * i] = scalar::ScNeg(a);
+        scalars[2 * i + 1] = scalar::ScNeg(scalar::ScMul(a, e));
     }
-    
-    // R'.x must equal r
-    auto RprimeX = Rprime.GetX();
-    return std::memcmp(RprimeX.data(), signature, 32) == 0;
-#endif
+    return EcmultMultiIsInfinity(g, points.data(), scalars.data(), points.size());
+}
+
+} // anonymous namespace
+
+bool SchnorrVerifyBatch(const uint8_t* const* hashes, const uint8_t* const* signatures,
+                        const uint8_t* const* publicKeys, size_t count) {
+    for (size_t start = 0; start < count; start += SCHNORR_BATCH_CHUNK) {
+        size_t n = std::min(SCHNORR_BATCH_CHUNK, count - start);
+        if (!SchnorrVerifyChunk(hashes + start, signatures + start, publicKeys + start, n)) {
+            return false;
+        }
+    }
+    return true;
 }
 
 } // namespace secp256k1
@@ -0,0 +1,422 @@
+// SHURIUM - secp256k1 Variable-Base Multiplication
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Points being accumulated are in Jacobian coordinates (X:Y:Z), x = X/Z^2,
+// y = Y/Z^3, with the a = 0 doubling and addition formulas from the
+// Explicit-Formulas Database. Table entries are affine, so the main loop
+// only uses mixed Jacobian + affine additions.
+
+#include "secp256k1_ecmult.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace shurium {
+namespace secp256k1 {
+
+using namespace field;
+using namespace scalar;
+
+namespace {
+
+/// wNAF window for the multiples of G and lambda(G): 2^(w-2) odd multiples each
+constexpr int WINDOW_G = 8;
+constexpr int TABLE_SIZE_G = 1 << (WINDOW_G - 2);
+
+/// wNAF window for the per-call multiples of P
+constexpr int WINDOW_P = 5;
+constexpr int TABLE_SIZE_P = 1 << (WINDOW_P - 2);
+
+/// Digits in the wNAF of a GLV half-scalar (|k| < 2^128, plus one carry)
+constexpr int WNAF_BITS = 130;
+
+/// beta: cube root of unity mod p with lambda * (x, y) = (beta * x, y)
+constexpr Fe BETA = FeFromLimbs64(0xC1396C28719501EEULL, 0x9CF0497512F58995ULL,
+                                  0x6E64479EAC3434E9ULL, 0x7AE96A2B657C0710ULL);
+
+struct JacobianPoint {
+    Fe x, y, z;
+    bool infinity;
+};
+
+constexpr JacobianPoint INFINITY_POINT = {FE_ZERO, FE_ONE, FE_ZERO, true};
+
+JacobianPoint ToJacobian(const AffinePoint& p) {
+    return {p.x, p.y, FE_ONE, false};
+}
+
+/// dbl-2009-l; secp256k1 has no point of order two, so Y != 0
+JacobianPoint Double(const JacobianPoint& p) {
+    if (p.infinity) return p;
+    Fe a = FeSqr(p.x);
+    Fe b = FeSqr(p.y);
+    Fe c = FeSqr(b);
+    Fe d = FeSub(FeSub(FeSqr(FeAdd(p.x, b)), a), c);
+    d = FeAdd(d, d);
+    Fe e = FeMulInt(a, 3);
+    Fe f = FeSqr(e);
+    JacobianPoint r;
+    r.x = FeSub(f, FeAdd(d, d));
+    r.y = FeSub(FeMul(e, FeSub(d, r.x)), FeMulInt(c, 8));
+    Fe yz = FeMul(p.y, p.z);
+    r.z = FeAdd(yz, yz);
+    r.infinity = false;
+    return r;
+}
+
+/// p + q for affine q
+JacobianPoint AddAffine(const JacobianPoint& p, const AffinePoint& q) {
+    if (p.infinity) return ToJacobian(q);
+    Fe z12 = FeSqr(p.z);
+    Fe u2 = FeMul(q.x, z12);
+    Fe s2 = FeMul(FeMul(q.y, z12), p.z);
+    Fe h = FeSub(u2, p.x);
+    Fe i = FeSub(s2, p.y);
+    if (FeIsZero(h)) {
+        return FeIsZero(i) ? Double(p) : INFINITY_POINT;
+    }
+    Fe h2 = FeSqr(h);
+    Fe h3 = FeMul(h2, h);
+    Fe t = FeMul(p.x, h2);
+    JacobianPoint r;
+    r.z = FeMul(p.z, h);
+    r.x = FeSub(FeSub(FeSqr(i), h3), FeAdd(t, t));
+    r.y = FeSub(FeMul(i, FeSub(t, r.x)), FeMul(h3, p.y));
+    r.infinity = false;
+    return r;
+}
+
+/// p + q for Jacobian q (table construction only)
+JacobianPoint Add(const JacobianPoint& p, const JacobianPoint& q) {
+    if (p.infinity) return q;
+    if (q.infinity) return p;
+    Fe z12 = FeSqr(p.z);
+    Fe z22 = FeSqr(q.z);
+    Fe u1 = FeMul(p.x, z22);
+    Fe u2 = FeMul(q.x, z12);
+    Fe s1 = FeMul(FeMul(p.y, z22), q.z);
+    Fe s2 = FeMul(FeMul(q.y, z12), p.z);
+    Fe h = FeSub(u2, u1);
+    Fe i = FeSub(s2, s1);
+    if (FeIsZero(h)) {
+        return FeIsZero(i) ? Double(p) : INFINITY_POINT;
+    }
+    Fe h2 = FeSqr(h);
+    Fe h3 = FeMul(h2, h);
+    Fe t = FeMul(u1, h2);
+    JacobianPoint r;
+    r.z = FeMul(FeMul(p.z, q.z), h);
+    r.x = FeSub(FeSub(FeSqr(i), h3), FeAdd(t, t));
+    r.y = FeSub(FeMul(i, FeSub(t, r.x)), FeMul(h3, s1));
+    r.infinity = false;
+    return r;
+}
+
+/// Affine form of count finite points, sharing one field inversion
+void BatchToAffine(AffinePoint* out, const JacobianPoint* in, size_t count) {
+    // Every verification converts a TABLE_SIZE_P table, so tables of
+    // that size stay off the heap
+    Fe small[TABLE_SIZE_G];
+    std::unique_ptr<Fe[]> large;
+    Fe* prefix = small;
+    if (count > static_cast<size_t>(TABLE_SIZE_G)) {
+        large = std::make_unique<Fe[]>(count);
+        prefix = large.get();
+    }
+    Fe acc = FE_ONE;
+    for (size_t k = 0; k < count; ++k) {
+        prefix[k] = acc;
+        acc = FeMul(acc, in[k].z);
+    }
+    Fe inv = FeInv(acc);
+    for (size_t k = count; k-- > 0;) {
+        Fe zInv = FeMul(inv, prefix[k]);
+        inv = FeMul(inv, in[k].z);
+        Fe zInv2 = FeSqr(zInv);
+        out[k].x = FeMul(in[k].x, zInv2);
+        out[k].y = FeMul(in[k].y, FeMul(zInv2, zInv));
+    }
+}
+
+/// P, 3P, 5P, ..., (2 * count - 1) P in Jacobian coordinates
+void OddMultiples(JacobianPoint* out, const AffinePoint& p, size_t count) {
+    JacobianPoint twice = Double(ToJacobian(p));
+    out[0] = ToJacobian(p);
+    for (size_t k = 1; k < count; ++k) {
+        out[k] = Add(out[k - 1], twice);
+    }
+}
+
+/// lambda(P) = (beta * x, y) for every entry
+void ApplyLambda(AffinePoint* out, const AffinePoint* in, size_t count) {
+    for (size_t k = 0; k < count; ++k) {
+        out[k].x = FeMul(in[k].x, BETA);
+        out[k].y = in[k].y;
+    }
+}
+
+struct GeneratorTables {
+    AffinePoint g[TABLE_SIZE_G];
+    AffinePoint lambdaG[TABLE_SIZE_G];
+
+    GeneratorTables() {
+        static constexpr uint8_t GX[32] = {
+            0x79, 0xBE, 0x66, 0x7E, 0xF9, 0xDC, 0xBB, 0xAC, 0x55, 0xA0, 0x62, 0x95,
+            0xCE, 0x87, 0x0B, 0x07, 0x02, 0x9B, 0xFC, 0xDB, 0x2D, 0xCE, 0x28, 0xD9,
+            0x59, 0xF2, 0x81, 0x5B, 0x16, 0xF8, 0x17, 0x98
+        };
+        static constexpr uint8_t GY[32] = {
+            0x48, 0x3A, 0xDA, 0x77, 0x26, 0xA3, 0xC4, 0x65, 0x5D, 0xA4, 0xFB, 0xFC,
+            0x0E, 0x11, 0x08, 0xA8, 0xFD, 0x17, 0xB4, 0x48, 0xA6, 0x85, 0x54, 0x19,
+            0x9C, 0x47, 0xD0, 0x8F, 0xFB, 0x10, 0xD4, 0xB8
+        };
+        AffinePoint base;
+        FeFromBytes(base.x, GX);
+        FeFromBytes(base.y, GY);
+
+        JacobianPoint multiples[TABLE_SIZE_G];
+        OddMultiples(multiples, base, TABLE_SIZE_G);
+        BatchToAffine(g, multiples, TABLE_SIZE_G);
+        ApplyLambda(lambdaG, g, TABLE_SIZE_G);
+    }
+};
+
+const GeneratorTables& GetGeneratorTables() {
+    static const std::unique_ptr<GeneratorTables> tables = std::make_unique<GeneratorTables>();
+    return *tables;
+}
+
+/// count bits of k starting at bit pos
+uint32_t GetBits(const Sc& k, int pos, int count) {
+    int limb = pos / 64;
+    int shift = pos % 64;
+    if (limb >= 4) return 0;
+    uint64_t v = k.n[limb] >> shift;
+    if (shift + count > 64 && limb + 1 < 4) {
+        v |= k.n[limb + 1] << (64 - shift);
+    }
+    return static_cast<uint32_t>(v) & ((1u << count) - 1);
+}
+
+/**
+ * Width-w NAF of a non-negative k below 2^128: odd digits in
+ * (-2^(w-1), 2^(w-1)) with at least w-1 zeros between nonzero digits.
+ * Digits are multiplied by sign. Returns the index past the last nonzero
+ * digit.
+ */
+int ComputeWnaf(int wnaf[WNAF_BITS], const Sc& k, int w, int sign) {
+    std::memset(wnaf, 0, WNAF_BITS * sizeof(int));
+    int last = 0;
+    uint32_t carry = 0;
+    int bit = 0;
+    while (bit < WNAF_BITS) {
+        if (GetBits(k, bit, 1) == carry) {
+            ++bit;
+            continue;
+        }
+        int now = w < WNAF_BITS - bit ? w : WNAF_BITS - bit;
+        int word = static_cast<int>(GetBits(k, bit, now) + carry);
+        carry = (word >> (w - 1)) & 1;
+        word -= static_cast<int>(carry << w);
+        wnaf[bit] = sign * word;
+        last = bit + 1;
+        bit += now;
+    }
+    return last;
+}
+
+/// The half-scalar magnitude and sign of a GLV component
+int SplitSign(Sc& magnitude, const Sc& k) {
+    if (ScIsHigh(k)) {
+        magnitude = ScNeg(k);
+        return -1;
+    }
+    magnitude = k;
+    return 1;
+}
+
+/// Add the table entry for a nonzero wNAF digit
+void AddDigit(JacobianPoint& r, const AffinePoint* table, int digit) {
+    if (digit > 0) {
+        r = AddAffine(r, table[(digit - 1) / 2]);
+    } else {
+        AffinePoint neg = table[(-digit - 1) / 2];
+        neg.y = FeNeg(neg.y);
+        r = AddAffine(r, neg);
+    }
+}
+
+/// One wNAF-recoded scalar and the odd multiples it indexes
+struct WnafTerm {
+    const AffinePoint* table;
+    int len;
+    int wnaf[WNAF_BITS];
+};
+
+/// Recode k against table, or against table and lambdaTable after a GLV split
+void AddTerms(std::vector<WnafTerm>& terms, const Sc& k, int w, const AffinePoint* table,
+              const AffinePoint* lambdaTable) {
+    auto push = [&](const Sc& part, const AffinePoint* t) {
+        Sc m;
+        int sign = SplitSign(m, part);
+        WnafTerm term;
+        term.table = t;
+        term.len = ComputeWnaf(term.wnaf, m, w, sign);
+        if (term.len > 0) terms.push_back(term);
+    };
+    if (!lambdaTable) {
+        push(k, table);
+        return;
+    }
+    Sc k1, k2;
+    ScSplitLambda(k1, k2, k);
+    push(k1, table);
+    push(k2, lambdaTable);
+}
+
+/// Magnitude of k (as k or n - k) is below 2^128, so it needs no GLV split
+bool IsHalfLength(const Sc& k) {
+    Sc m;
+    SplitSign(m, k);
+    return m.n[2] == 0 && m.n[3] == 0;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Points
+// ============================================================================
+
+bool ParsePoint(AffinePoint& r, const uint8_t* in, size_t len) {
+    if (len == 33 && (in[0] == 0x02 || in[0] == 0x03)) {
+        Fe x;
+        if (!FeFromBytes(x, in + 1) || !LiftX(r, x)) return false;
+        if ((in[0] == 0x03) != FeIsOdd(r.y)) {
+            r.y = FeNeg(r.y);
+        }
+        return true;
+    }
+    if (len == 65 && (in[0] == 0x04 || in[0] == 0x06 || in[0] == 0x07)) {
+        if (!FeFromBytes(r.x, in + 1) || !FeFromBytes(r.y, in + 33)) return false;
+        if (in[0] != 0x04 && (in[0] == 0x07) != FeIsOdd(r.y)) return false;
+        Fe rhs = FeAdd(FeMul(FeSqr(r.x), r.x), FeFromInt(7));
+        return FeEqual(FeSqr(r.y), rhs);
+    }
+    return false;
+}
+
+bool LiftX(AffinePoint& r, const Fe& x) {
+    Fe rhs = FeAdd(FeMul(FeSqr(x), x), FeFromInt(7));
+    if (!FeSqrt(r.y, rhs)) return false;
+    r.x = x;
+    if (FeIsOdd(r.y)) {
+        r.y = FeNeg(r.y);
+    }
+    return true;
+}
+
+// ============================================================================
+// Strauss-Shamir with GLV
+// ============================================================================
+
+bool EcmultDouble(AffinePoint& r, const Sc& a, const AffinePoint& p, const Sc& b) {
+    const GeneratorTables& gTables = GetGeneratorTables();
+
+    // a = a1 + a2 * lambda, b = b1 + b2 * lambda
+    Sc a1, a2, b1, b2;
+    ScSplitLambda(a1, a2, a);
+    ScSplitLambda(b1, b2, b);
+
+    int wnafA1[WNAF_BITS], wnafA2[WNAF_BITS], wnafB1[WNAF_BITS], wnafB2[WNAF_BITS];
+    Sc m;
+    int sgn = SplitSign(m, a1);
+    int lenA1 = ComputeWnaf(wnafA1, m, WINDOW_G, sgn);
+    sgn = SplitSign(m, a2);
+    int lenA2 = ComputeWnaf(wnafA2, m, WINDOW_G, sgn);
+    sgn = SplitSign(m, b1);
+    int lenB1 = ComputeWnaf(wnafB1, m, WINDOW_P, sgn);
+    sgn = SplitSign(m, b2);
+    int lenB2 = ComputeWnaf(wnafB2, m, WINDOW_P, sgn);
+
+    AffinePoint pTable[TABLE_SIZE_P];
+    AffinePoint lambdaPTable[TABLE_SIZE_P];
+    bool haveP = lenB1 > 0 || lenB2 > 0;
+    if (haveP) {
+        JacobianPoint multiples[TABLE_SIZE_P];
+        OddMultiples(multiples, p, TABLE_SIZE_P);
+        BatchToAffine(pTable, multiples, TABLE_SIZE_P);
+        ApplyLambda(lambdaPTable, pTable, TABLE_SIZE_P);
+    }
+
+    int len = lenA1;
+    if (lenA2 > len) len = lenA2;
+    if (lenB1 > len) len = lenB1;
+    if (lenB2 > len) len = lenB2;
+
+    JacobianPoint acc = INFINITY_POINT;
+    for (int i = len - 1; i >= 0; --i) {
+        acc = Double(acc);
+        if (wnafA1[i]) AddDigit(acc, gTables.g, wnafA1[i]);
+        if (wnafA2[i]) AddDigit(acc, gTables.lambdaG, wnafA2[i]);
+        if (wnafB1[i]) AddDigit(acc, pTable, wnafB1[i]);
+        if (wnafB2[i]) AddDigit(acc, lambdaPTable, wnafB2[i]);
+    }
+
+    if (acc.infinity) return false;
+    Fe zInv = FeInv(acc.z);
+    Fe zInv2 = FeSqr(zInv);
+    r.x = FeMul(acc.x, zInv2);
+    r.y = FeMul(acc.y, FeMul(zInv2, zInv));
+    return true;
+}
+
+bool EcmultMultiIsInfinity(const Sc& g, const AffinePoint* points, const Sc* scalars,
+                           size_t count) {
+    const GeneratorTables& gTables = GetGeneratorTables();
+
+    // Odd multiples of every point with a nonzero scalar, one batched inversion
+    std::vector<size_t> used;
+    for (size_t i = 0; i < count; ++i) {
+        if (!ScIsZero(scalars[i])) used.push_back(i);
+    }
+    std::vector<JacobianPoint> multiples(used.size() * TABLE_SIZE_P);
+    for (size_t k = 0; k < used.size(); ++k) {
+        OddMultiples(&multiples[k * TABLE_SIZE_P], points[used[k]], TABLE_SIZE_P);
+    }
+    std::vector<AffinePoint> tables(multiples.size());
+    std::vector<AffinePoint> lambdaTables(multiples.size());
+    if (!multiples.empty()) {
+        BatchToAffine(tables.data(), multiples.data(), multiples.size());
+    }
+
+    std::vector<WnafTerm> terms;
+    terms.reserve(2 + 2 * used.size());
+    AddTerms(terms, g, WINDOW_G, gTables.g, gTables.lambdaG);
+    for (size_t k = 0; k < used.size(); ++k) {
+        const Sc& scalar = scalars[used[k]];
+        AffinePoint* table = &tables[k * TABLE_SIZE_P];
+        AffinePoint* lambdaTable = nullptr;
+        if (!IsHalfLength(scalar)) {
+            lambdaTable = &lambdaTables[k * TABLE_SIZE_P];
+            ApplyLambda(lambdaTable, table, TABLE_SIZE_P);
+        }
+        AddTerms(terms, scalar, WINDOW_P, table, lambdaTable);
+    }
+
+    int len = 0;
+    for (const WnafTerm& term : terms) {
+        if (term.len > len) len = term.len;
+    }
+    JacobianPoint acc = INFINITY_POINT;
+    for (int i = len - 1; i >= 0; --i) {
+        acc = Double(acc);
+        for (const WnafTerm& term : terms) {
+            if (term.wnaf[i]) AddDigit(acc, term.table, term.wnaf[i]);
+        }
+    }
+    return acc.infinity;
+}
+
+} // namespace secp256k1
+} // namespace shurium
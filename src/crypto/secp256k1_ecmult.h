@@ -0,0 +1,63 @@
+// SHURIUM - secp256k1 Variable-Base Multiplication
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header: point parsing and a*G + b*P for signature verification.
+// Everything here is variable time and must only see public data.
+
+#ifndef SHURIUM_CRYPTO_SECP256K1_ECMULT_H
+#define SHURIUM_CRYPTO_SECP256K1_ECMULT_H
+
+#include "secp256k1_field.h"
+#include "secp256k1_scalar.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace shurium {
+namespace secp256k1 {
+
+/// A finite curve point in affine coordinates
+struct AffinePoint {
+    field::Fe x, y;
+};
+
+/**
+ * Parse a SEC1 public key: compressed (02/03), uncompressed (04) or
+ * hybrid (06/07, whose prefix must match the parity of y).
+ * @return false unless the encoding is well formed and the point is on the curve
+ */
+bool ParsePoint(AffinePoint& r, const uint8_t* in, size_t len);
+
+/// The point with x coordinate x and even y (BIP340); false if there is none
+bool LiftX(AffinePoint& r, const field::Fe& x);
+
+/**
+ * r = a*G + b*P.
+ *
+ * Both scalars are split with the GLV endomorphism into four half-length
+ * scalars and recoded to wNAF, and the four products are accumulated with
+ * one shared chain of ~128 Jacobian doublings (Strauss-Shamir). The odd
+ * multiples of G and lambda(G) come from a static table built on first use;
+ * those of P are computed per call and brought to affine form with a single
+ * batched inversion, so every addition in the main loop is a mixed addition.
+ *
+ * @return false if the result is the point at infinity
+ */
+bool EcmultDouble(AffinePoint& r, const scalar::Sc& a, const AffinePoint& p,
+                  const scalar::Sc& b);
+
+/**
+ * True if g*G + sum(scalars[i] * points[i]) is the point at infinity.
+ *
+ * The multi-scalar form of EcmultDouble: every term shares one doubling
+ * chain and the odd multiples of all points share one batched inversion.
+ * Scalars already below 2^128 in magnitude (such as random batch weights)
+ * skip the GLV split and use a single wNAF.
+ */
+bool EcmultMultiIsInfinity(const scalar::Sc& g, const AffinePoint* points,
+                           const scalar::Sc* scalars, size_t count);
+
+} // namespace secp256k1
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SECP256K1_ECMULT_H
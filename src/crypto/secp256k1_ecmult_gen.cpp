@@ -0,0 +1,227 @@
+// SHURIUM - secp256k1 Fixed-Base Multiplication
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Points are in projective coordinates (X:Y:Z), x = X/Z, y = Y/Z, with the
+// complete addition formula of Renes, Costello and Batina ("Complete
+// addition formulas for prime order elliptic curves", 2015, algorithm 7),
+// which is valid for doubling and for the identity (0:1:0) alike.
+
+#include "secp256k1_ecmult_gen.h"
+#include "secp256k1_field.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace shurium {
+namespace secp256k1 {
+
+using namespace field;
+
+namespace {
+
+/// Window width in bits and the resulting table shape
+constexpr int WINDOW_BITS = 4;
+constexpr int WINDOW_SIZE = 1 << WINDOW_BITS;
+constexpr int WINDOWS = 256 / WINDOW_BITS;
+
+/// 3 * b for y^2 = x^3 + 7
+constexpr uint32_t CURVE_B3 = 21;
+
+struct ProjectivePoint {
+    Fe x, y, z;
+};
+
+constexpr ProjectivePoint IDENTITY = {FE_ZERO, FE_ONE, FE_ZERO};
+
+ProjectivePoint Add(const ProjectivePoint& p, const ProjectivePoint& q) {
+    Fe t0 = FeMul(p.x, q.x);
+    Fe t1 = FeMul(p.y, q.y);
+    Fe t2 = FeMul(p.z, q.z);
+    Fe t3 = FeMul(FeAdd(p.x, p.y), FeAdd(q.x, q.y));
+    Fe t4 = FeAdd(t0, t1);
+    t3 = FeSub(t3, t4);
+    t4 = FeMul(FeAdd(p.y, p.z), FeAdd(q.y, q.z));
+    Fe x3 = FeAdd(t1, t2);
+    t4 = FeSub(t4, x3);
+    x3 = FeMul(FeAdd(p.x, p.z), FeAdd(q.x, q.z));
+    Fe y3 = FeAdd(t0, t2);
+    y3 = FeSub(x3, y3);
+    x3 = FeAdd(t0, t0);
+    t0 = FeAdd(x3, t0);
+    t2 = FeMulInt(t2, CURVE_B3);
+    Fe z3 = FeAdd(t1, t2);
+    t1 = FeSub(t1, t2);
+    y3 = FeMulInt(y3, CURVE_B3);
+    x3 = FeMul(t4, y3);
+    t2 = FeMul(t3, t1);
+    x3 = FeSub(t2, x3);
+    y3 = FeMul(y3, t0);
+    t1 = FeMul(t1, z3);
+    y3 = FeAdd(t1, y3);
+    t0 = FeMul(t0, t3);
+    z3 = FeMul(z3, t4);
+    z3 = FeAdd(z3, t0);
+    return {x3, y3, z3};
+}
+
+/// j * 16^i * G, normalized to Z = 1 except for the identity at j = 0
+struct GeneratorTable {
+    ProjectivePoint entries[WINDOWS][WINDOW_SIZE];
+
+    GeneratorTable() {
+        // Generator coordinates
+        static constexpr uint8_t GX[32] = {
+            0x79, 0xBE, 0x66, 0x7E, 0xF9, 0xDC, 0xBB, 0xAC, 0x55, 0xA0, 0x62, 0x95,
+            0xCE, 0x87, 0x0B, 0x07, 0x02, 0x9B, 0xFC, 0xDB, 0x2D, 0xCE, 0x28, 0xD9,
+            0x59, 0xF2, 0x81, 0x5B, 0x16, 0xF8, 0x17, 0x98
+        };
+        static constexpr uint8_t GY[32] = {
+            0x48, 0x3A, 0xDA, 0x77, 0x26, 0xA3, 0xC4, 0x65, 0x5D, 0xA4, 0xFB, 0xFC,
+            0x0E, 0x11, 0x08, 0xA8, 0xFD, 0x17, 0xB4, 0x48, 0xA6, 0x85, 0x54, 0x19,
+            0x9C, 0x47, 0xD0, 0x8F, 0xFB, 0x10, 0xD4, 0xB8
+        };
+        ProjectivePoint base;
+        FeFromBytes(base.x, GX);
+        FeFromBytes(base.y, GY);
+        base.z = FE_ONE;
+
+        for (int i = 0; i < WINDOWS; ++i) {
+            entries[i][0] = IDENTITY;
+            entries[i][1] = base;
+            for (int j = 2; j < WINDOW_SIZE; ++j) {
+                entries[i][j] = Add(entries[i][j - 1], base);
+            }
+            // 16^(i+1) * G = 15 * 16^i * G + 16^i * G
+            base = Add(entries[i][WINDOW_SIZE - 1], base);
+        }
+        Normalize();
+    }
+
+    /// Scale every non-identity entry to Z = 1 with one shared inversion
+    void Normalize() {
+        constexpr int COUNT = WINDOWS * (WINDOW_SIZE - 1);
+        auto prefix = std::make_unique<Fe[]>(COUNT);
+        Fe acc = FE_ONE;
+        for (int k = 0; k < COUNT; ++k) {
+            acc = FeMul(acc, Entry(k).z);
+            prefix[k] = acc;
+        }
+        Fe inv = FeInv(acc);
+        for (int k = COUNT - 1; k >= 0; --k) {
+            ProjectivePoint& p = Entry(k);
+            Fe zInv = k > 0 ? FeMul(inv, prefix[k - 1]) : inv;
+            inv = FeMul(inv, p.z);
+            p.x = FeMul(p.x, zInv);
+            p.y = FeMul(p.y, zInv);
+            p.z = FE_ONE;
+        }
+    }
+
+    /// The k-th non-identity entry
+    ProjectivePoint& Entry(int k) {
+        return entries[k / (WINDOW_SIZE - 1)][1 + k % (WINDOW_SIZE - 1)];
+    }
+
+    /// entries[window][digit], reading every entry of the window
+    ProjectivePoint Lookup(int window, uint32_t digit) const {
+        ProjectivePoint r = IDENTITY;
+        for (uint32_t j = 0; j < WINDOW_SIZE; ++j) {
+            uint64_t match = static_cast<uint64_t>(((j ^ digit) - 1) >> 31) & 1;
+            FeCMov(r.x, entries[window][j].x, match);
+            FeCMov(r.y, entries[window][j].y, match);
+            FeCMov(r.z, entries[window][j].z, match);
+        }
+        return r;
+    }
+};
+
+const GeneratorTable& GetGeneratorTable() {
+    static const std::unique_ptr<GeneratorTable> table = std::make_unique<GeneratorTable>();
+    return *table;
+}
+
+void SecureWipe(void* ptr, size_t len) {
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(ptr);
+    while (len--) *p++ = 0;
+}
+
+} // anonymous namespace
+
+bool EcmultGen(const uint8_t scalar[32], uint8_t x[32], uint8_t y[32]) {
+    const GeneratorTable& table = GetGeneratorTable();
+
+    ProjectivePoint r = IDENTITY;
+    for (int i = 0; i < WINDOWS; ++i) {
+        uint32_t digit = (scalar[31 - i / 2] >> (4 * (i & 1))) & 0x0f;
+        ProjectivePoint entry = table.Lookup(i, digit);
+        r = Add(r, entry);
+        SecureWipe(&entry, sizeof(entry));
+    }
+
+    bool ok = !FeIsZero(r.z);
+    Fe zInv = FeInv(r.z);
+    Fe ax = FeMul(r.x, zInv);
+    Fe ay = FeMul(r.y, zInv);
+    FeToBytes(x, ax);
+    FeToBytes(y, ay);
+
+    SecureWipe(&r, sizeof(r));
+    SecureWipe(&ax, sizeof(ax));
+    SecureWipe(&ay, sizeof(ay));
+    return ok;
+}
+
+void EcmultGenAddBatch(const uint8_t px[32], const uint8_t py[32], const uint8_t* scalars,
+                       size_t count, uint8_t* xs, uint8_t* ys, bool* finite) {
+    if (count == 0) return;
+    const GeneratorTable& table = GetGeneratorTable();
+
+    ProjectivePoint p;
+    FeFromBytes(p.x, px);
+    FeFromBytes(p.y, py);
+    p.z = FE_ONE;
+
+    std::vector<ProjectivePoint> sums(count);
+    std::vector<Fe> prefix(count);
+    Fe acc = FE_ONE;
+    for (size_t k = 0; k < count; ++k) {
+        const uint8_t* scalar = scalars + 32 * k;
+        ProjectivePoint r = p;
+        for (int i = 0; i < WINDOWS; ++i) {
+            uint32_t digit = (scalar[31 - i / 2] >> (4 * (i & 1))) & 0x0f;
+            ProjectivePoint entry = table.Lookup(i, digit);
+            r = Add(r, entry);
+            SecureWipe(&entry, sizeof(entry));
+        }
+        // A zero Z would zero the whole product; stand in 1 for it
+        finite[k] = !FeIsZero(r.z);
+        FeCMov(r.z, FE_ONE, finite[k] ? 0 : 1);
+        sums[k] = r;
+        acc = FeMul(acc, r.z);
+        prefix[k] = acc;
+    }
+
+    Fe inv = FeInv(acc);
+    for (size_t k = count; k-- > 0;) {
+        ProjectivePoint& r = sums[k];
+        Fe zInv = k > 0 ? FeMul(inv, prefix[k - 1]) : inv;
+        inv = FeMul(inv, r.z);
+        if (finite[k]) {
+            FeToBytes(xs + 32 * k, FeMul(r.x, zInv));
+            FeToBytes(ys + 32 * k, FeMul(r.y, zInv));
+        } else {
+            std::memset(xs + 32 * k, 0, 32);
+            std::memset(ys + 32 * k, 0, 32);
+        }
+        SecureWipe(&zInv, sizeof(zInv));
+    }
+
+    SecureWipe(sums.data(), sums.size() * sizeof(ProjectivePoint));
+    SecureWipe(prefix.data(), prefix.size() * sizeof(Fe));
+    SecureWipe(&acc, sizeof(acc));
+    SecureWipe(&inv, sizeof(inv));
+}
+
+} // namespace secp256k1
+} // namespace shurium
@@ -0,0 +1,53 @@
+// SHURIUM - secp256k1 Fixed-Base Multiplication
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header: k*G from a precomputed table of multiples of G.
+
+#ifndef SHURIUM_CRYPTO_SECP256K1_ECMULT_GEN_H
+#define SHURIUM_CRYPTO_SECP256K1_ECMULT_GEN_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace shurium {
+namespace secp256k1 {
+
+/**
+ * Affine coordinates of scalar*G in constant time.
+ *
+ * The scalar is split into 64 four-bit windows and G's table holds
+ * j * 16^i * G for every window i and digit j, so the product is 64 point
+ * additions with no doublings. Each table read scans all 16 entries of its
+ * window, and the complete addition formulas have no special cases, so
+ * neither memory access nor control flow depends on the scalar. The table
+ * (96 KiB) is built on first use.
+ *
+ * @param scalar 32-byte big-endian scalar in [1, n-1]
+ * @param x Output: 32-byte big-endian x coordinate
+ * @param y Output: 32-byte big-endian y coordinate
+ * @return false if the product is the point at infinity (scalar 0 or n)
+ */
+bool EcmultGen(const uint8_t scalar[32], uint8_t x[32], uint8_t y[32]);
+
+/**
+ * Affine coordinates of P + scalars[k]*G for count scalars at once.
+ *
+ * Each sum is accumulated as in EcmultGen, starting from P instead of the
+ * identity, and all of them are brought to affine form with a single
+ * batched inversion (Montgomery's trick) instead of one per point. Any
+ * scalar is accepted; a sum that lands on the point at infinity gets
+ * finite[k] = false and zero coordinates, and does not disturb the others.
+ *
+ * @param px, py 32-byte big-endian affine coordinates of P (on the curve)
+ * @param scalars count consecutive 32-byte big-endian scalars
+ * @param xs, ys Output: count consecutive 32-byte coordinates
+ * @param finite Output: count flags
+ */
+void EcmultGenAddBatch(const uint8_t px[32], const uint8_t py[32], const uint8_t* scalars,
+                       size_t count, uint8_t* xs, uint8_t* ys, bool* finite);
+
+} // namespace secp256k1
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SECP256K1_ECMULT_GEN_H
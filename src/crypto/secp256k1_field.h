@@ -0,0 +1,494 @@
+// SHURIUM - secp256k1 Native Field Arithmetic
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header for the native secp256k1 code paths. Elements of GF(p),
+// p = 2^256 - 0x1000003D1, are five little-endian 52-bit limbs. Reduction is
+// lazy: every operation returns a *weakly normalized* element (limbs 0-3
+// below 2^52 and limb 4 below 2^49, so at most a little above 2^256 and not
+// necessarily below p), and only comparisons, parity and serialization
+// reduce fully. The 12 spare bits per limb let products accumulate in
+// 128-bit column sums without intermediate carries.
+//
+// Multiplication and squaring use unsigned __int128, or BMI2/ADX assembly
+// when built with SHURIUM_SECP256K1_ASM; inversion uses constant-time
+// safegcd (secp256k1_modinv.h).
+// Every operation runs in time independent of the values, so the same code
+// serves secret scalars and public data.
+
+#ifndef SHURIUM_CRYPTO_SECP256K1_FIELD_H
+#define SHURIUM_CRYPTO_SECP256K1_FIELD_H
+
+#include "secp256k1_modinv.h"
+#include <cstddef>
+#include <cstdint>
+
+#if defined(SHURIUM_SECP256K1_ASM) && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define SHURIUM_SECP256K1_FIELD_ASM 1
+#endif
+
+namespace shurium {
+namespace secp256k1 {
+namespace field {
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+/// 2^256 mod p
+constexpr uint64_t REDUCE_C = 0x1000003D1ULL;
+
+/// 2^260 mod p, the weight of a carry out of limb 4
+constexpr uint64_t REDUCE_R = REDUCE_C << 4;
+
+constexpr uint64_t LIMB_MASK = 0xFFFFFFFFFFFFFULL;
+constexpr uint64_t TOP_MASK = 0x0FFFFFFFFFFFFULL;
+
+struct Fe {
+    uint64_t n[5];
+};
+
+/// An element from four little-endian 64-bit words (for constants)
+constexpr Fe FeFromLimbs64(uint64_t w0, uint64_t w1, uint64_t w2, uint64_t w3) {
+    return Fe{{w0 & LIMB_MASK, ((w0 >> 52) | (w1 << 12)) & LIMB_MASK,
+               ((w1 >> 40) | (w2 << 24)) & LIMB_MASK, ((w2 >> 28) | (w3 << 36)) & LIMB_MASK,
+               w3 >> 16}};
+}
+
+constexpr Fe FE_ZERO = {{0, 0, 0, 0, 0}};
+constexpr Fe FE_ONE = {{1, 0, 0, 0, 0}};
+
+inline Fe FeFromInt(uint64_t v) {
+    return FeFromLimbs64(v, 0, 0, 0);
+}
+
+/// Fold the bits above 2^256 back in and propagate carries once
+inline Fe FeNormalizeWeak(const Fe& a) {
+    uint64_t t0 = a.n[0], t1 = a.n[1], t2 = a.n[2], t3 = a.n[3], t4 = a.n[4];
+    uint64_t x = t4 >> 48;
+    t4 &= TOP_MASK;
+    t0 += x * REDUCE_C;
+    t1 += t0 >> 52; t0 &= LIMB_MASK;
+    t2 += t1 >> 52; t1 &= LIMB_MASK;
+    t3 += t2 >> 52; t2 &= LIMB_MASK;
+    t4 += t3 >> 52; t3 &= LIMB_MASK;
+    return Fe{{t0, t1, t2, t3, t4}};
+}
+
+/// The unique representative below p
+inline Fe FeNormalize(const Fe& a) {
+    Fe t = FeNormalizeWeak(a);
+    // At most one more subtraction of p: needed if the value reached 2^256
+    // or lies in [p, 2^256)
+    uint64_t m = t.n[1] & t.n[2] & t.n[3];
+    uint64_t x = (t.n[4] >> 48) |
+                 static_cast<uint64_t>((t.n[4] == TOP_MASK) & (m == LIMB_MASK) &
+                                       (t.n[0] >= 0xFFFFEFFFFFC2FULL));
+    uint64_t t0 = t.n[0] + x * REDUCE_C;
+    uint64_t t1 = t.n[1] + (t0 >> 52); t0 &= LIMB_MASK;
+    uint64_t t2 = t.n[2] + (t1 >> 52); t1 &= LIMB_MASK;
+    uint64_t t3 = t.n[3] + (t2 >> 52); t2 &= LIMB_MASK;
+    uint64_t t4 = t.n[4] + (t3 >> 52); t3 &= LIMB_MASK;
+    t4 &= TOP_MASK;
+    return Fe{{t0, t1, t2, t3, t4}};
+}
+
+/// Parse 32 big-endian bytes; false if the value is not below p
+inline bool FeFromBytes(Fe& r, const uint8_t* in) {
+    uint64_t w[4];
+    for (int i = 0; i < 4; ++i) {
+        uint64_t limb = 0;
+        for (int j = 0; j < 8; ++j) {
+            limb = (limb << 8) | in[(3 - i) * 8 + j];
+        }
+        w[i] = limb;
+    }
+    r = FeFromLimbs64(w[0], w[1], w[2], w[3]);
+    // Not below p iff adding 2^256 - p carries out
+    uint128_t c = static_cast<uint128_t>(w[0]) + REDUCE_C;
+    c >>= 64;
+    c += w[1];
+    c >>= 64;
+    c += w[2];
+    c >>= 64;
+    c += w[3];
+    return (c >> 64) == 0;
+}
+
+inline void FeToBytes(uint8_t* out, const Fe& a) {
+    Fe t = FeNormalize(a);
+    uint64_t w[4] = {t.n[0] | (t.n[1] << 52), (t.n[1] >> 12) | (t.n[2] << 40),
+                     (t.n[2] >> 24) | (t.n[3] << 28), (t.n[3] >> 36) | (t.n[4] << 16)};
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            out[(3 - i) * 8 + j] = static_cast<uint8_t>(w[i] >> (56 - 8 * j));
+        }
+    }
+}
+
+inline Fe FeAdd(const Fe& a, const Fe& b) {
+    return FeNormalizeWeak(Fe{{a.n[0] + b.n[0], a.n[1] + b.n[1], a.n[2] + b.n[2],
+                               a.n[3] + b.n[3], a.n[4] + b.n[4]}});
+}
+
+inline Fe FeSub(const Fe& a, const Fe& b) {
+    // a + 4p - b: every limb of 4p exceeds the matching limb of a weakly
+    // normalized b, so no limb borrows
+    return FeNormalizeWeak(Fe{{a.n[0] + 0x3FFFFBFFFFF0BCULL - b.n[0],
+                               a.n[1] + 0x3FFFFFFFFFFFFCULL - b.n[1],
+                               a.n[2] + 0x3FFFFFFFFFFFFCULL - b.n[2],
+                               a.n[3] + 0x3FFFFFFFFFFFFCULL - b.n[3],
+                               a.n[4] + 0x3FFFFFFFFFFFCULL - b.n[4]}});
+}
+
+inline Fe FeNeg(const Fe& a) {
+    return FeSub(FE_ZERO, a);
+}
+
+// Multiplication and squaring follow the column schedule of libsecp256k1's
+// field_5x52_int128: with c accumulating the low columns and d the high
+// ones, d's 52-bit pieces fold into c as multiples of R = 2^260 mod p, and
+// the four bits above 2^256 are folded in before limb 0 is retired, so the
+// result comes out weakly normalized without a second carry pass. Inputs
+// must have limbs below 2^53, which every weakly normalized element has.
+
+#ifdef SHURIUM_SECP256K1_FIELD_ASM
+
+// The assembly runs the same schedule, keeping c and d on independent
+// carry chains where both accumulate: ADCX propagates through CF and ADOX
+// through OF, and MULX leaves both untouched, so the products of the two
+// columns interleave freely. The input bounds guarantee no 128-bit
+// accumulation overflows, so each chain's flag is clear again after every
+// high-word add. t3 and t4 are parked in the output limbs 3 and 4.
+
+#define SHURIUM_FE_MULX(x, y, lo, hi) \
+    "movq " #x ", %%rdx\n\t" "mulxq " #y ", %[" #lo "], %[" #hi "]\n\t"
+#define SHURIUM_FE_D(x, y) \
+    SHURIUM_FE_MULX(x, y, lo, hi) "adcxq %[lo], %[dlo]\n\t" "adcxq %[hi], %[dhi]\n\t"
+#define SHURIUM_FE_C(x, y) \
+    SHURIUM_FE_MULX(x, y, lo2, hi2) "adoxq %[lo2], %[clo]\n\t" "adoxq %[hi2], %[chi]\n\t"
+#define SHURIUM_FE_CLEAR_FLAGS "xorl %k[lo], %k[lo]\n\t"
+#define SHURIUM_FE_MASK52(reg) "andq %[m], " reg "\n\t"
+#define SHURIUM_FE_SHR52(lo, hi) \
+    "shrdq $52, %[" #hi "], %[" #lo "]\n\t" "shrq $52, %[" #hi "]\n\t"
+// acc += rdx * k for a 64-bit constant k
+#define SHURIUM_FE_ADD_MUL_CONST(k, lo, hi) \
+    "movabsq $" #k ", %[lo]\n\t" "mulxq %[lo], %[lo], %[hi]\n\t" \
+    "addq %[lo], %[" #lo "]\n\t" "adcq %[hi], %[" #hi "]\n\t"
+// Retire the low 52 bits of c as output limb `off` and shift c down
+#define SHURIUM_FE_RETIRE_C(off) \
+    "movq %[clo], %[lo]\n\t" SHURIUM_FE_MASK52("%[lo]") "movq %[lo], " #off "(%[r])\n\t" \
+    SHURIUM_FE_SHR52(clo, chi)
+
+// Everything after the first column products is shared by mul and sqr
+#define SHURIUM_FE_FOLD_T3 \
+    "movq %[clo], %%rdx\n\t" SHURIUM_FE_ADD_MUL_CONST(0x1000003D10, dlo, dhi) \
+    "movq %[dlo], %[lo]\n\t" SHURIUM_FE_MASK52("%[lo]") "movq %[lo], 24(%[r])\n\t" \
+    SHURIUM_FE_SHR52(dlo, dhi)
+#define SHURIUM_FE_FOLD_T4 \
+    "movq %[chi], %%rdx\n\t" SHURIUM_FE_ADD_MUL_CONST(0x1000003D10000, dlo, dhi) \
+    "movq %[dlo], %[lo]\n\t" SHURIUM_FE_MASK52("%[lo]") \
+    "movq %[lo], %[hi2]\n\t" "shrq $48, %[hi2]\n\t" \
+    "shlq $16, %[lo]\n\t" "shrq $16, %[lo]\n\t" "movq %[lo], 32(%[r])\n\t" \
+    SHURIUM_FE_SHR52(dlo, dhi)
+#define SHURIUM_FE_FOLD_U0 \
+    "movq %[dlo], %%rdx\n\t" SHURIUM_FE_MASK52("%%rdx") \
+    "shlq $4, %%rdx\n\t" "orq %[hi2], %%rdx\n\t" SHURIUM_FE_SHR52(dlo, dhi) \
+    SHURIUM_FE_ADD_MUL_CONST(0x1000003D1, clo, chi) SHURIUM_FE_RETIRE_C(0)
+#define SHURIUM_FE_FOLD_R1 \
+    "movq %[dlo], %%rdx\n\t" SHURIUM_FE_MASK52("%%rdx") SHURIUM_FE_SHR52(dlo, dhi) \
+    SHURIUM_FE_ADD_MUL_CONST(0x1000003D10, clo, chi) SHURIUM_FE_RETIRE_C(8)
+#define SHURIUM_FE_FINISH \
+    "movq %[dlo], %%rdx\n\t" SHURIUM_FE_ADD_MUL_CONST(0x1000003D10, clo, chi) \
+    SHURIUM_FE_RETIRE_C(16) \
+    "movq %[dhi], %%rdx\n\t" SHURIUM_FE_ADD_MUL_CONST(0x1000003D10000, clo, chi) \
+    "addq 24(%[r]), %[clo]\n\t" "adcq $0, %[chi]\n\t" SHURIUM_FE_RETIRE_C(24) \
+    "addq %[clo], 32(%[r])\n\t"
+
+inline Fe FeMul(const Fe& a, const Fe& b) {
+    Fe r;
+    uint64_t clo, chi, dlo, dhi, lo, hi, lo2, hi2, rdx;
+    __asm__ __volatile__(
+        // d = p3, c = p8
+        SHURIUM_FE_MULX(24(%[b]), 0(%[a]), dlo, dhi)
+        SHURIUM_FE_MULX(32(%[b]), 32(%[a]), clo, chi)
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(16(%[b]), 8(%[a])) SHURIUM_FE_D(8(%[b]), 16(%[a]))
+        SHURIUM_FE_D(0(%[b]), 24(%[a]))
+        SHURIUM_FE_FOLD_T3
+        // d += p4
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[b]), 0(%[a])) SHURIUM_FE_D(24(%[b]), 8(%[a]))
+        SHURIUM_FE_D(16(%[b]), 16(%[a])) SHURIUM_FE_D(8(%[b]), 24(%[a]))
+        SHURIUM_FE_D(0(%[b]), 32(%[a]))
+        SHURIUM_FE_FOLD_T4
+        // c = p0, d += p5
+        SHURIUM_FE_MULX(0(%[b]), 0(%[a]), clo, chi)
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[b]), 8(%[a])) SHURIUM_FE_D(24(%[b]), 16(%[a]))
+        SHURIUM_FE_D(16(%[b]), 24(%[a])) SHURIUM_FE_D(8(%[b]), 32(%[a]))
+        SHURIUM_FE_FOLD_U0
+        // c += p1, d += p6
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[b]), 16(%[a])) SHURIUM_FE_C(8(%[b]), 0(%[a]))
+        SHURIUM_FE_D(24(%[b]), 24(%[a])) SHURIUM_FE_C(0(%[b]), 8(%[a]))
+        SHURIUM_FE_D(16(%[b]), 32(%[a]))
+        SHURIUM_FE_FOLD_R1
+        // c += p2, d += p7
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[b]), 24(%[a])) SHURIUM_FE_C(16(%[b]), 0(%[a]))
+        SHURIUM_FE_D(24(%[b]), 32(%[a])) SHURIUM_FE_C(8(%[b]), 8(%[a]))
+        SHURIUM_FE_C(0(%[b]), 16(%[a]))
+        SHURIUM_FE_FINISH
+        : [clo] "=&r"(clo), [chi] "=&r"(chi), [dlo] "=&r"(dlo), [dhi] "=&r"(dhi),
+          [lo] "=&r"(lo), [hi] "=&r"(hi), [lo2] "=&r"(lo2), [hi2] "=&r"(hi2), "=&d"(rdx)
+        : [a] "r"(a.n), [b] "r"(b.n), [r] "r"(r.n), [m] "r"(LIMB_MASK)
+        : "cc", "memory");
+    return r;
+}
+
+inline Fe FeSqr(const Fe& a) {
+    // Cross terms use doubled limbs: d[i] = 2 * a[i]
+    const uint64_t d[5] = {a.n[0] * 2, a.n[1] * 2, a.n[2] * 2, a.n[3] * 2, a.n[4] * 2};
+    Fe r;
+    uint64_t clo, chi, dlo, dhi, lo, hi, lo2, hi2, rdx;
+    __asm__ __volatile__(
+        // d = p3 = 2a0a3 + 2a1a2, c = p8 = a4^2
+        SHURIUM_FE_MULX(24(%[a]), 0(%[d]), dlo, dhi)
+        SHURIUM_FE_MULX(32(%[a]), 32(%[a]), clo, chi)
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(16(%[a]), 8(%[d]))
+        SHURIUM_FE_FOLD_T3
+        // d += p4 = 2a0a4 + 2a1a3 + a2^2
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[a]), 0(%[d])) SHURIUM_FE_D(24(%[a]), 8(%[d]))
+        SHURIUM_FE_D(16(%[a]), 16(%[a]))
+        SHURIUM_FE_FOLD_T4
+        // c = p0 = a0^2, d += p5 = 2a1a4 + 2a2a3
+        SHURIUM_FE_MULX(0(%[a]), 0(%[a]), clo, chi)
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[a]), 8(%[d])) SHURIUM_FE_D(24(%[a]), 16(%[d]))
+        SHURIUM_FE_FOLD_U0
+        // c += p1 = 2a0a1, d += p6 = 2a2a4 + a3^2
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[a]), 16(%[d])) SHURIUM_FE_C(8(%[a]), 0(%[d]))
+        SHURIUM_FE_D(24(%[a]), 24(%[a]))
+        SHURIUM_FE_FOLD_R1
+        // c += p2 = 2a0a2 + a1^2, d += p7 = 2a3a4
+        SHURIUM_FE_CLEAR_FLAGS
+        SHURIUM_FE_D(32(%[a]), 24(%[d])) SHURIUM_FE_C(16(%[a]), 0(%[d]))
+        SHURIUM_FE_C(8(%[a]), 8(%[a]))
+        SHURIUM_FE_FINISH
+        : [clo] "=&r"(clo), [chi] "=&r"(chi), [dlo] "=&r"(dlo), [dhi] "=&r"(dhi),
+          [lo] "=&r"(lo), [hi] "=&r"(hi), [lo2] "=&r"(lo2), [hi2] "=&r"(hi2), "=&d"(rdx)
+        : [a] "r"(a.n), [d] "r"(d), [r] "r"(r.n), [m] "r"(LIMB_MASK)
+        : "cc", "memory");
+    return r;
+}
+
+#undef SHURIUM_FE_MULX
+#undef SHURIUM_FE_D
+#undef SHURIUM_FE_C
+#undef SHURIUM_FE_CLEAR_FLAGS
+#undef SHURIUM_FE_MASK52
+#undef SHURIUM_FE_SHR52
+#undef SHURIUM_FE_ADD_MUL_CONST
+#undef SHURIUM_FE_RETIRE_C
+#undef SHURIUM_FE_FOLD_T3
+#undef SHURIUM_FE_FOLD_T4
+#undef SHURIUM_FE_FOLD_U0
+#undef SHURIUM_FE_FOLD_R1
+#undef SHURIUM_FE_FINISH
+
+#else
+
+inline Fe FeMul(const Fe& a, const Fe& b) {
+    const uint64_t a0 = a.n[0], a1 = a.n[1], a2 = a.n[2], a3 = a.n[3], a4 = a.n[4];
+    const uint64_t b0 = b.n[0], b1 = b.n[1], b2 = b.n[2], b3 = b.n[3], b4 = b.n[4];
+    Fe r;
+    uint128_t c, d;
+
+    // d = p3; c = p8, whose low word folds into d at weight 2^208 * R
+    d = static_cast<uint128_t>(a0) * b3 + static_cast<uint128_t>(a1) * b2 +
+        static_cast<uint128_t>(a2) * b1 + static_cast<uint128_t>(a3) * b0;
+    c = static_cast<uint128_t>(a4) * b4;
+    d += static_cast<uint128_t>(REDUCE_R) * static_cast<uint64_t>(c);
+    c >>= 64;
+    uint64_t t3 = static_cast<uint64_t>(d) & LIMB_MASK;
+    d >>= 52;
+
+    // d += p4 and the high word of p8; bits above 2^256 become tx
+    d += static_cast<uint128_t>(a0) * b4 + static_cast<uint128_t>(a1) * b3 +
+         static_cast<uint128_t>(a2) * b2 + static_cast<uint128_t>(a3) * b1 +
+         static_cast<uint128_t>(a4) * b0;
+    d += static_cast<uint128_t>(REDUCE_R << 12) * static_cast<uint64_t>(c);
+    uint64_t t4 = static_cast<uint64_t>(d) & LIMB_MASK;
+    d >>= 52;
+    uint64_t tx = t4 >> 48;
+    t4 &= TOP_MASK;
+
+    // c = p0, d += p5; p5's low piece and tx land on limb 0 via 2^256 mod p
+    c = static_cast<uint128_t>(a0) * b0;
+    d += static_cast<uint128_t>(a1) * b4 + static_cast<uint128_t>(a2) * b3 +
+         static_cast<uint128_t>(a3) * b2 + static_cast<uint128_t>(a4) * b1;
+    uint64_t u0 = static_cast<uint64_t>(d) & LIMB_MASK;
+    d >>= 52;
+    u0 = (u0 << 4) | tx;
+    c += static_cast<uint128_t>(u0) * REDUCE_C;
+    r.n[0] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+
+    // c += p1, d += p6
+    c += static_cast<uint128_t>(a0) * b1 + static_cast<uint128_t>(a1) * b0;
+    d += static_cast<uint128_t>(a2) * b4 + static_cast<uint128_t>(a3) * b3 +
+         static_cast<uint128_t>(a4) * b2;
+    c += static_cast<uint128_t>(static_cast<uint64_t>(d) & LIMB_MASK) * REDUCE_R;
+    d >>= 52;
+    r.n[1] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+
+    // c += p2, d += p7, then the rest of d and the parked t3, t4
+    c += static_cast<uint128_t>(a0) * b2 + static_cast<uint128_t>(a1) * b1 +
+         static_cast<uint128_t>(a2) * b0;
+    d += static_cast<uint128_t>(a3) * b4 + static_cast<uint128_t>(a4) * b3;
+    c += static_cast<uint128_t>(REDUCE_R) * static_cast<uint64_t>(d);
+    d >>= 64;
+    r.n[2] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+    c += static_cast<uint128_t>(REDUCE_R << 12) * static_cast<uint64_t>(d) + t3;
+    r.n[3] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+    r.n[4] = static_cast<uint64_t>(c) + t4;
+    return r;
+}
+
+inline Fe FeSqr(const Fe& a) {
+    const uint64_t a0 = a.n[0], a1 = a.n[1], a2 = a.n[2], a3 = a.n[3], a4 = a.n[4];
+    const uint64_t d0 = a0 * 2, d1 = a1 * 2, d2 = a2 * 2, d4 = a4 * 2;
+    Fe r;
+    uint128_t c, d;
+
+    d = static_cast<uint128_t>(d0) * a3 + static_cast<uint128_t>(d1) * a2;
+    c = static_cast<uint128_t>(a4) * a4;
+    d += static_cast<uint128_t>(REDUCE_R) * static_cast<uint64_t>(c);
+    c >>= 64;
+    uint64_t t3 = static_cast<uint64_t>(d) & LIMB_MASK;
+    d >>= 52;
+
+    d += static_cast<uint128_t>(a0) * d4 + static_cast<uint128_t>(d1) * a3 +
+         static_cast<uint128_t>(a2) * a2;
+    d += static_cast<uint128_t>(REDUCE_R << 12) * static_cast<uint64_t>(c);
+    uint64_t t4 = static_cast<uint64_t>(d) & LIMB_MASK;
+    d >>= 52;
+    uint64_t tx = t4 >> 48;
+    t4 &= TOP_MASK;
+
+    c = static_cast<uint128_t>(a0) * a0;
+    d += static_cast<uint128_t>(a1) * d4 + static_cast<uint128_t>(d2) * a3;
+    uint64_t u0 = static_cast<uint64_t>(d) & LIMB_MASK;
+    d >>= 52;
+    u0 = (u0 << 4) | tx;
+    c += static_cast<uint128_t>(u0) * REDUCE_C;
+    r.n[0] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+
+    c += static_cast<uint128_t>(d0) * a1;
+    d += static_cast<uint128_t>(a2) * d4 + static_cast<uint128_t>(a3) * a3;
+    c += static_cast<uint128_t>(static_cast<uint64_t>(d) & LIMB_MASK) * REDUCE_R;
+    d >>= 52;
+    r.n[1] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+
+    c += static_cast<uint128_t>(d0) * a2 + static_cast<uint128_t>(a1) * a1;
+    d += static_cast<uint128_t>(a3) * d4;
+    c += static_cast<uint128_t>(REDUCE_R) * static_cast<uint64_t>(d);
+    d >>= 64;
+    r.n[2] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+    c += static_cast<uint128_t>(REDUCE_R << 12) * static_cast<uint64_t>(d) + t3;
+    r.n[3] = static_cast<uint64_t>(c) & LIMB_MASK;
+    c >>= 52;
+    r.n[4] = static_cast<uint64_t>(c) + t4;
+    return r;
+}
+
+#endif // SHURIUM_SECP256K1_FIELD_ASM
+
+/// Multiply by a small constant (at most 32)
+inline Fe FeMulInt(const Fe& a, uint32_t k) {
+    return FeNormalizeWeak(Fe{{a.n[0] * k, a.n[1] * k, a.n[2] * k, a.n[3] * k, a.n[4] * k}});
+}
+
+inline Fe FeSqrN(Fe a, int n) {
+    for (int i = 0; i < n; ++i) {
+        a = FeSqr(a);
+    }
+    return a;
+}
+
+/// a^-1 by constant-time safegcd; 0 maps to 0
+inline Fe FeInv(const Fe& a) {
+    Fe t = FeNormalize(a);
+    modinv::Signed62 s;
+    s.v[0] = static_cast<int64_t>((t.n[0] | (t.n[1] << 52)) & (UINT64_MAX >> 2));
+    s.v[1] = static_cast<int64_t>(((t.n[1] >> 10) | (t.n[2] << 42)) & (UINT64_MAX >> 2));
+    s.v[2] = static_cast<int64_t>(((t.n[2] >> 20) | (t.n[3] << 32)) & (UINT64_MAX >> 2));
+    s.v[3] = static_cast<int64_t>(((t.n[3] >> 30) | (t.n[4] << 22)) & (UINT64_MAX >> 2));
+    s.v[4] = static_cast<int64_t>(t.n[4] >> 40);
+    modinv::ModInv(s, modinv::FIELD_MODINFO);
+    const uint64_t v0 = static_cast<uint64_t>(s.v[0]), v1 = static_cast<uint64_t>(s.v[1]),
+                   v2 = static_cast<uint64_t>(s.v[2]), v3 = static_cast<uint64_t>(s.v[3]),
+                   v4 = static_cast<uint64_t>(s.v[4]);
+    return Fe{{v0 & LIMB_MASK, ((v0 >> 52) | (v1 << 10)) & LIMB_MASK,
+               ((v1 >> 42) | (v2 << 20)) & LIMB_MASK, ((v2 >> 32) | (v3 << 30)) & LIMB_MASK,
+               (v3 >> 22) | (v4 << 40)}};
+}
+
+inline bool FeIsZero(const Fe& a) {
+    Fe t = FeNormalize(a);
+    return (t.n[0] | t.n[1] | t.n[2] | t.n[3] | t.n[4]) == 0;
+}
+
+inline bool FeEqual(const Fe& a, const Fe& b) {
+    return FeIsZero(FeSub(a, b));
+}
+
+inline bool FeIsOdd(const Fe& a) {
+    return (FeNormalize(a).n[0] & 1) != 0;
+}
+
+/**
+ * Square root as a^((p+1)/4), valid because p = 3 mod 4. Returns false, with
+ * r set to the root of -a, when a is not a square.
+ */
+inline bool FeSqrt(Fe& r, const Fe& a) {
+    Fe x2 = FeMul(FeSqr(a), a);
+    Fe x3 = FeMul(FeSqr(x2), a);
+    Fe x6 = FeMul(FeSqrN(x3, 3), x3);
+    Fe x9 = FeMul(FeSqrN(x6, 3), x3);
+    Fe x11 = FeMul(FeSqrN(x9, 2), x2);
+    Fe x22 = FeMul(FeSqrN(x11, 11), x11);
+    Fe x44 = FeMul(FeSqrN(x22, 22), x22);
+    Fe x88 = FeMul(FeSqrN(x44, 44), x44);
+    Fe x176 = FeMul(FeSqrN(x88, 88), x88);
+    Fe x220 = FeMul(FeSqrN(x176, 44), x44);
+    Fe x223 = FeMul(FeSqrN(x220, 3), x3);
+
+    Fe t = FeMul(FeSqrN(x223, 23), x22);
+    t = FeMul(FeSqrN(t, 6), x2);
+    r = FeSqrN(t, 2);
+    return FeEqual(FeSqr(r), a);
+}
+
+/// r = flag ? a : r, without branching on flag
+inline void FeCMov(Fe& r, const Fe& a, uint64_t flag) {
+    uint64_t mask = 0 - (flag & 1);
+    for (int i = 0; i < 5; ++i) {
+        r.n[i] ^= mask & (r.n[i] ^ a.n[i]);
+    }
+}
+
+} // namespace field
+} // namespace secp256k1
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SECP256K1_FIELD_H
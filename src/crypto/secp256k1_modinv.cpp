@@ -0,0 +1,172 @@
+// SHURIUM - secp256k1 Modular Inversion
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "secp256k1_modinv.h"
+
+namespace shurium {
+namespace secp256k1 {
+namespace modinv {
+
+namespace {
+
+__extension__ typedef __int128 int128_t;
+
+constexpr uint64_t M62 = UINT64_MAX >> 2;
+
+/// A 2x2 transition matrix scaled by 2^62: [u v; q r]
+struct Trans2x2 {
+    int64_t u, v, q, r;
+};
+
+/**
+ * 59 branch-free divsteps on the low 64 bits of f and g. zeta is
+ * -(delta + 1/2) in the notation of the paper; the returned matrix maps
+ * [f, g] to 2^62 times the values after the 59 steps.
+ */
+int64_t Divsteps59(int64_t zeta, uint64_t f0, uint64_t g0, Trans2x2& t) {
+    // Start from the identity scaled by 2^3, so 59 doublings give 2^62
+    uint64_t u = 8, v = 0, q = 0, r = 8;
+    uint64_t f = f0, g = g0;
+    for (int i = 3; i < 62; ++i) {
+        // mask1: zeta < 0; mask2: g odd
+        uint64_t mask1 = static_cast<uint64_t>(zeta >> 63);
+        uint64_t mask2 = 0 - (g & 1);
+        // Conditionally negated copies of f, u, v
+        uint64_t x = (f ^ mask1) - mask1;
+        uint64_t y = (u ^ mask1) - mask1;
+        uint64_t z = (v ^ mask1) - mask1;
+        // If g is odd, add them to g, q, r
+        g += x & mask2;
+        q += y & mask2;
+        r += z & mask2;
+        // If both hold, swap: zeta becomes -zeta - 2, and f, u, v pick up g, q, r
+        mask1 &= mask2;
+        zeta = (zeta ^ static_cast<int64_t>(mask1)) - 1;
+        f += g & mask1;
+        u += q & mask1;
+        v += r & mask1;
+        g >>= 1;
+        u <<= 1;
+        v <<= 1;
+    }
+    t.u = static_cast<int64_t>(u);
+    t.v = static_cast<int64_t>(v);
+    t.q = static_cast<int64_t>(q);
+    t.r = static_cast<int64_t>(r);
+    return zeta;
+}
+
+/**
+ * [d, e] = t * [d, e] / 2^62 (mod modulus), adding multiples of the modulus
+ * to make the division exact. Inputs and outputs lie in (-2*modulus, modulus).
+ */
+void UpdateDE(Signed62& d, Signed62& e, const Trans2x2& t, const ModInfo& info) {
+    const int64_t u = t.u, v = t.v, q = t.q, r = t.r;
+    const int64_t* m = info.modulus.v;
+    // Start md, me at the modulus multiples that make negative d, e positive
+    int64_t sd = d.v[4] >> 63;
+    int64_t se = e.v[4] >> 63;
+    int64_t md = (u & sd) + (v & se);
+    int64_t me = (q & sd) + (r & se);
+    int128_t cd = static_cast<int128_t>(u) * d.v[0] + static_cast<int128_t>(v) * e.v[0];
+    int128_t ce = static_cast<int128_t>(q) * d.v[0] + static_cast<int128_t>(r) * e.v[0];
+    // Adjust md, me so the bottom 62 bits of t*[d,e] + modulus*[md,me] vanish
+    md -= static_cast<int64_t>((info.modulusInv62 * static_cast<uint64_t>(cd) +
+                                static_cast<uint64_t>(md)) & M62);
+    me -= static_cast<int64_t>((info.modulusInv62 * static_cast<uint64_t>(ce) +
+                                static_cast<uint64_t>(me)) & M62);
+    cd += static_cast<int128_t>(m[0]) * md;
+    ce += static_cast<int128_t>(m[0]) * me;
+    cd >>= 62;
+    ce >>= 62;
+    for (int i = 1; i < 5; ++i) {
+        cd += static_cast<int128_t>(u) * d.v[i] + static_cast<int128_t>(v) * e.v[i];
+        ce += static_cast<int128_t>(q) * d.v[i] + static_cast<int128_t>(r) * e.v[i];
+        cd += static_cast<int128_t>(m[i]) * md;
+        ce += static_cast<int128_t>(m[i]) * me;
+        d.v[i - 1] = static_cast<int64_t>(static_cast<uint64_t>(cd) & M62);
+        e.v[i - 1] = static_cast<int64_t>(static_cast<uint64_t>(ce) & M62);
+        cd >>= 62;
+        ce >>= 62;
+    }
+    d.v[4] = static_cast<int64_t>(cd);
+    e.v[4] = static_cast<int64_t>(ce);
+}
+
+/// [f, g] = t * [f, g] / 2^62, which is exact by construction of t
+void UpdateFG(Signed62& f, Signed62& g, const Trans2x2& t) {
+    const int64_t u = t.u, v = t.v, q = t.q, r = t.r;
+    int128_t cf = static_cast<int128_t>(u) * f.v[0] + static_cast<int128_t>(v) * g.v[0];
+    int128_t cg = static_cast<int128_t>(q) * f.v[0] + static_cast<int128_t>(r) * g.v[0];
+    cf >>= 62;
+    cg >>= 62;
+    for (int i = 1; i < 5; ++i) {
+        cf += static_cast<int128_t>(u) * f.v[i] + static_cast<int128_t>(v) * g.v[i];
+        cg += static_cast<int128_t>(q) * f.v[i] + static_cast<int128_t>(r) * g.v[i];
+        f.v[i - 1] = static_cast<int64_t>(static_cast<uint64_t>(cf) & M62);
+        g.v[i - 1] = static_cast<int64_t>(static_cast<uint64_t>(cg) & M62);
+        cf >>= 62;
+        cg >>= 62;
+    }
+    f.v[4] = static_cast<int64_t>(cf);
+    g.v[4] = static_cast<int64_t>(cg);
+}
+
+/// Bring r from (-2*modulus, modulus) into [0, modulus), negated first if sign < 0
+void Normalize(Signed62& r, int64_t sign, const ModInfo& info) {
+    const int64_t* m = info.modulus.v;
+    int64_t x[5] = {r.v[0], r.v[1], r.v[2], r.v[3], r.v[4]};
+
+    int64_t condAdd = x[4] >> 63;
+    for (int i = 0; i < 5; ++i) {
+        x[i] += m[i] & condAdd;
+    }
+    int64_t condNegate = sign >> 63;
+    for (int i = 0; i < 5; ++i) {
+        x[i] = (x[i] ^ condNegate) - condNegate;
+    }
+    for (int i = 0; i < 4; ++i) {
+        x[i + 1] += x[i] >> 62;
+        x[i] &= static_cast<int64_t>(M62);
+    }
+
+    // Now in (-modulus, modulus); add it once more if still negative
+    condAdd = x[4] >> 63;
+    for (int i = 0; i < 5; ++i) {
+        x[i] += m[i] & condAdd;
+    }
+    for (int i = 0; i < 4; ++i) {
+        x[i + 1] += x[i] >> 62;
+        x[i] &= static_cast<int64_t>(M62);
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        r.v[i] = x[i];
+    }
+}
+
+} // namespace
+
+void ModInv(Signed62& x, const ModInfo& info) {
+    Signed62 d = {{0, 0, 0, 0, 0}};
+    Signed62 e = {{1, 0, 0, 0, 0}};
+    Signed62 f = info.modulus;
+    Signed62 g = x;
+    int64_t zeta = -1;
+
+    for (int i = 0; i < 10; ++i) {
+        Trans2x2 t;
+        zeta = Divsteps59(zeta, static_cast<uint64_t>(f.v[0]), static_cast<uint64_t>(g.v[0]), t);
+        UpdateDE(d, e, t, info);
+        UpdateFG(f, g, t);
+    }
+
+    // g is now 0 and f is +/-1 (the gcd), so d is +/- the inverse
+    Normalize(d, f.v[4], info);
+    x = d;
+}
+
+} // namespace modinv
+} // namespace secp256k1
+} // namespace shurium
@@ -0,0 +1,48 @@
+// SHURIUM - secp256k1 Modular Inversion
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header: constant-time inversion modulo p or n with the
+// Bernstein-Yang "safegcd" algorithm (https://gcd.cr.yp.to), in the
+// 62-bit-batch formulation of libsecp256k1's modinv64. Values are five
+// signed 62-bit limbs, v[0] + v[1]*2^62 + ... + v[4]*2^248.
+
+#ifndef SHURIUM_CRYPTO_SECP256K1_MODINV_H
+#define SHURIUM_CRYPTO_SECP256K1_MODINV_H
+
+#include <cstdint>
+
+namespace shurium {
+namespace secp256k1 {
+namespace modinv {
+
+struct Signed62 {
+    int64_t v[5];
+};
+
+/// An odd modulus together with its inverse mod 2^62
+struct ModInfo {
+    Signed62 modulus;
+    uint64_t modulusInv62;
+};
+
+/// p = 2^256 - 0x1000003D1
+constexpr ModInfo FIELD_MODINFO = {{{-0x1000003D1LL, 0, 0, 0, 256}}, 0x27C7F6E22DDACACFULL};
+
+/// n, the group order
+constexpr ModInfo SCALAR_MODINFO = {
+    {{0x3FD25E8CD0364141LL, 0x2ABB739ABD2280EELL, -0x15LL, 0, 256}}, 0x34F20099AA774EC1ULL};
+
+/**
+ * x = x^-1 mod modulus, for 0 <= x < modulus; 0 maps to 0.
+ *
+ * Runs a fixed 590 divsteps in ten batches of 59, which bounds the work for
+ * any 256-bit input, so the running time does not depend on x.
+ */
+void ModInv(Signed62& x, const ModInfo& info);
+
+} // namespace modinv
+} // namespace secp256k1
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SECP256K1_MODINV_H
@@ -0,0 +1,234 @@
+// SHURIUM - secp256k1 Native Scalar Arithmetic
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header for the native secp256k1 code paths. Integers modulo the
+// group order n = 2^256 - 0x14551231950B75FC4402DA1732FC9BEBF are four
+// little-endian 64-bit limbs kept fully reduced, as in secp256k1_field.h.
+
+#ifndef SHURIUM_CRYPTO_SECP256K1_SCALAR_H
+#define SHURIUM_CRYPTO_SECP256K1_SCALAR_H
+
+#include "secp256k1_field.h"
+#include <cstdint>
+
+namespace shurium {
+namespace secp256k1 {
+namespace scalar {
+
+using field::uint128_t;
+
+struct Sc {
+    uint64_t n[4];
+};
+
+constexpr Sc SC_ZERO = {{0, 0, 0, 0}};
+
+/// 2^256 - n (129 bits)
+constexpr uint64_t N_C[3] = {0x402DA1732FC9BEBFULL, 0x4551231950B75FC4ULL, 1};
+
+/// The group order n
+constexpr Sc N = {{0xBFD25E8CD0364141ULL, 0xBAAEDCE6AF48A03BULL,
+                   0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL}};
+
+/// n / 2, the largest "low" scalar
+constexpr Sc N_HALF = {{0xDFE92F46681B20A0ULL, 0x5D576E7357A4501DULL,
+                        0xFFFFFFFFFFFFFFFFULL, 0x7FFFFFFFFFFFFFFFULL}};
+
+/// Bring a value below 2^256 + n into [0, n) given its carry-out bit
+inline Sc ScReduceOnce(const uint64_t v[4], uint64_t carry) {
+    Sc t;
+    uint128_t c = 0;
+    for (int i = 0; i < 4; ++i) {
+        c += static_cast<uint128_t>(v[i]) + (i < 3 ? N_C[i] : 0);
+        t.n[i] = static_cast<uint64_t>(c);
+        c >>= 64;
+    }
+    uint64_t mask = 0 - ((carry | static_cast<uint64_t>(c)) & 1);
+    Sc r;
+    for (int i = 0; i < 4; ++i) {
+        r.n[i] = (t.n[i] & mask) | (v[i] & ~mask);
+    }
+    return r;
+}
+
+/// Parse 32 big-endian bytes reduced mod n; returns true if the input was not below n
+inline bool ScFromBytes(Sc& r, const uint8_t* in) {
+    uint64_t v[4];
+    for (int i = 0; i < 4; ++i) {
+        uint64_t limb = 0;
+        for (int j = 0; j < 8; ++j) {
+            limb = (limb << 8) | in[(3 - i) * 8 + j];
+        }
+        v[i] = limb;
+    }
+    r = ScReduceOnce(v, 0);
+    return ((r.n[0] ^ v[0]) | (r.n[1] ^ v[1]) | (r.n[2] ^ v[2]) | (r.n[3] ^ v[3])) != 0;
+}
+
+inline void ScToBytes(uint8_t* out, const Sc& a) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            out[(3 - i) * 8 + j] = static_cast<uint8_t>(a.n[i] >> (56 - 8 * j));
+        }
+    }
+}
+
+inline bool ScIsZero(const Sc& a) {
+    return (a.n[0] | a.n[1] | a.n[2] | a.n[3]) == 0;
+}
+
+inline bool ScEqual(const Sc& a, const Sc& b) {
+    return ((a.n[0] ^ b.n[0]) | (a.n[1] ^ b.n[1]) | (a.n[2] ^ b.n[2]) | (a.n[3] ^ b.n[3])) == 0;
+}
+
+/// True if a > n / 2
+inline bool ScIsHigh(const Sc& a) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t d = static_cast<uint128_t>(N_HALF.n[i]) - a.n[i] - borrow;
+        borrow = static_cast<uint64_t>(d >> 64) & 1;
+    }
+    return borrow != 0;
+}
+
+inline Sc ScAdd(const Sc& a, const Sc& b) {
+    uint64_t v[4];
+    uint128_t c = 0;
+    for (int i = 0; i < 4; ++i) {
+        c += static_cast<uint128_t>(a.n[i]) + b.n[i];
+        v[i] = static_cast<uint64_t>(c);
+        c >>= 64;
+    }
+    return ScReduceOnce(v, static_cast<uint64_t>(c));
+}
+
+inline Sc ScNeg(const Sc& a) {
+    // n - a, masked to 0 for a = 0
+    uint64_t nonzero = 0 - static_cast<uint64_t>(!ScIsZero(a));
+    Sc r;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t d = static_cast<uint128_t>(N.n[i]) - a.n[i] - borrow;
+        r.n[i] = static_cast<uint64_t>(d) & nonzero;
+        borrow = static_cast<uint64_t>(d >> 64) & 1;
+    }
+    return r;
+}
+
+/// 512-bit product of two 256-bit values
+inline void ScMul512(uint64_t t[8], const Sc& a, const Sc& b) {
+    for (int i = 0; i < 8; ++i) t[i] = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128_t c = 0;
+        for (int j = 0; j < 4; ++j) {
+            c += static_cast<uint128_t>(a.n[i]) * b.n[j] + t[i + j];
+            t[i + j] = static_cast<uint64_t>(c);
+            c >>= 64;
+        }
+        t[i + 4] = static_cast<uint64_t>(c);
+    }
+}
+
+/// Reduce a 512-bit value mod n
+inline Sc ScReduce512(const uint64_t t[8]) {
+    // Fold hi * 2^256 = hi * N_C three times: 512 -> 386 -> 260 -> 257 bits
+    uint64_t r[8] = {t[0], t[1], t[2], t[3], 0, 0, 0, 0};
+    uint64_t hi[4] = {t[4], t[5], t[6], t[7]};
+    int nHi = 4;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < nHi; ++i) {
+            uint128_t c = 0;
+            for (int j = 0; j < 3; ++j) {
+                c += static_cast<uint128_t>(hi[i]) * N_C[j] + r[i + j];
+                r[i + j] = static_cast<uint64_t>(c);
+                c >>= 64;
+            }
+            for (int k = i + 3; k < 8; ++k) {
+                c += r[k];
+                r[k] = static_cast<uint64_t>(c);
+                c >>= 64;
+            }
+        }
+        nHi = round == 0 ? 3 : 1;
+        for (int i = 0; i < 4; ++i) {
+            hi[i] = i < nHi ? r[4 + i] : 0;
+            r[4 + i] = 0;
+        }
+    }
+    return ScReduceOnce(r, hi[0]);
+}
+
+inline Sc ScMul(const Sc& a, const Sc& b) {
+    uint64_t t[8];
+    ScMul512(t, a, b);
+    return ScReduce512(t);
+}
+
+inline Sc ScSqr(const Sc& a) {
+    return ScMul(a, a);
+}
+
+/// a^-1 by constant-time safegcd; 0 maps to 0
+inline Sc ScInv(const Sc& a) {
+    constexpr uint64_t M62 = UINT64_MAX >> 2;
+    const uint64_t a0 = a.n[0], a1 = a.n[1], a2 = a.n[2], a3 = a.n[3];
+    modinv::Signed62 s = {{static_cast<int64_t>(a0 & M62),
+                           static_cast<int64_t>(((a0 >> 62) | (a1 << 2)) & M62),
+                           static_cast<int64_t>(((a1 >> 60) | (a2 << 4)) & M62),
+                           static_cast<int64_t>(((a2 >> 58) | (a3 << 6)) & M62),
+                           static_cast<int64_t>(a3 >> 56)}};
+    modinv::ModInv(s, modinv::SCALAR_MODINFO);
+    const uint64_t v0 = static_cast<uint64_t>(s.v[0]), v1 = static_cast<uint64_t>(s.v[1]),
+                   v2 = static_cast<uint64_t>(s.v[2]), v3 = static_cast<uint64_t>(s.v[3]),
+                   v4 = static_cast<uint64_t>(s.v[4]);
+    return Sc{{v0 | (v1 << 62), (v1 >> 2) | (v2 << 60), (v2 >> 4) | (v3 << 58),
+               (v3 >> 6) | (v4 << 56)}};
+}
+
+// ============================================================================
+// GLV Decomposition
+// ============================================================================
+
+/**
+ * Split k into k1 + k2 * lambda (mod n) with |k1|, |k2| < 2^128, where
+ * lambda is the cube root of unity acting as (x, y) -> (beta * x, y).
+ * Uses the rounded lattice projection from libsecp256k1's
+ * scalar_split_lambda; k1 and k2 are returned mod n, so a component above
+ * n / 2 stands for its negation.
+ */
+inline void ScSplitLambda(Sc& k1, Sc& k2, const Sc& k) {
+    constexpr Sc MINUS_LAMBDA = {{0xE0CFC810B51283CFULL, 0xA880B9FC8EC739C2ULL,
+                                  0x5AD9E3FD77ED9BA4ULL, 0xAC9C52B33FA3CF1FULL}};
+    constexpr Sc MINUS_B1 = {{0x6F547FA90ABFE4C3ULL, 0xE4437ED6010E8828ULL, 0, 0}};
+    constexpr Sc MINUS_B2 = {{0xD765CDA83DB1562CULL, 0x8A280AC50774346DULL,
+                              0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL}};
+    constexpr Sc G1 = {{0xE893209A45DBB031ULL, 0x3DAA8A1471E8CA7FULL,
+                        0xE86C90E49284EB15ULL, 0x3086D221A7D46BCDULL}};
+    constexpr Sc G2 = {{0x1571B4AE8AC47F71ULL, 0x221208AC9DF506C6ULL,
+                        0x6F547FA90ABFE4C4ULL, 0xE4437ED6010E8828ULL}};
+
+    // c = round(k * g / 2^384)
+    auto mulShift384 = [](const Sc& a, const Sc& g) {
+        uint64_t t[8];
+        ScMul512(t, a, g);
+        uint128_t c = static_cast<uint128_t>(t[6]) + (t[5] >> 63);
+        Sc r;
+        r.n[0] = static_cast<uint64_t>(c);
+        c = (c >> 64) + t[7];
+        r.n[1] = static_cast<uint64_t>(c);
+        r.n[2] = static_cast<uint64_t>(c >> 64);
+        r.n[3] = 0;
+        return r;
+    };
+    Sc c1 = ScMul(mulShift384(k, G1), MINUS_B1);
+    Sc c2 = ScMul(mulShift384(k, G2), MINUS_B2);
+    k2 = ScAdd(c1, c2);
+    k1 = ScAdd(ScMul(k2, MINUS_LAMBDA), k);
+}
+
+} // namespace scalar
+} // namespace secp256k1
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SECP256K1_SCALAR_H
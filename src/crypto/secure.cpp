@@ -0,0 +1,164 @@
+// SHURIUM - Secure Memory Pool Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/crypto/secure.h"
+
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace shurium {
+
+namespace {
+
+constexpr size_t ARENA_BYTES = SecurePool::SLOT_SIZE * SecurePool::ARENA_SLOTS;
+
+alignas(SecurePool::SLOT_SIZE) const uint8_t ZERO_SLOT[SecurePool::SLOT_SIZE] = {};
+
+/// memset that the compiler may not drop as a dead store
+void Cleanse(void* ptr, size_t len) {
+    volatile uint8_t* p = static_cast<volatile uint8_t*>(ptr);
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+size_t PageSize() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Arena
+// ============================================================================
+
+/// One mapping: a guard page, ARENA_BYTES of slots, a guard page
+struct SecurePool::Arena {
+    uint8_t* mapping{nullptr};
+    size_t mappingSize{0};
+    uint8_t* slots{nullptr};
+    bool locked{false};
+
+    ~Arena() {
+        if (!mapping) {
+            return;
+        }
+#ifdef _WIN32
+        if (locked) {
+            VirtualUnlock(slots, ARENA_BYTES);
+        }
+        VirtualFree(mapping, 0, MEM_RELEASE);
+#else
+        if (locked) {
+            munlock(slots, ARENA_BYTES);
+        }
+        munmap(mapping, mappingSize);
+#endif
+    }
+};
+
+// ============================================================================
+// SecurePool
+// ============================================================================
+
+SecurePool& SecurePool::Get() {
+    // Never destroyed: keys in static storage may be freed during exit
+    static SecurePool* pool = new SecurePool;
+    return *pool;
+}
+
+const uint8_t* SecurePool::ZeroSlot() {
+    return ZERO_SLOT;
+}
+
+void* SecurePool::Allocate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (freeSlots_.empty()) {
+        AddArenaLocked();
+    }
+    void* slot = freeSlots_.back();
+    freeSlots_.pop_back();
+    return slot;
+}
+
+void SecurePool::Free(void* slot) {
+    if (!slot) {
+        return;
+    }
+    Cleanse(slot, SLOT_SIZE);
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeSlots_.push_back(slot);
+}
+
+SecurePool::Stats SecurePool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.arenas = arenas_.size();
+    stats.unlockedArenas = unlockedArenas_;
+    stats.slotsTotal = arenas_.size() * ARENA_SLOTS;
+    stats.slotsInUse = stats.slotsTotal - freeSlots_.size();
+    return stats;
+}
+
+void SecurePool::AddArenaLocked() {
+    const size_t page = PageSize();
+    auto arena = std::make_unique<Arena>();
+    arena->mappingSize = ARENA_BYTES + 2 * page;
+
+#ifdef _WIN32
+    void* mapping = VirtualAlloc(nullptr, arena->mappingSize, MEM_RESERVE | MEM_COMMIT,
+                                 PAGE_NOACCESS);
+    if (!mapping) {
+        throw std::bad_alloc();
+    }
+    arena->mapping = static_cast<uint8_t*>(mapping);
+    arena->slots = arena->mapping + page;
+    DWORD oldProtect;
+    if (!VirtualProtect(arena->slots, ARENA_BYTES, PAGE_READWRITE, &oldProtect)) {
+        throw std::bad_alloc();
+    }
+    arena->locked = VirtualLock(arena->slots, ARENA_BYTES) != 0;
+#else
+    // Map everything inaccessible, then open up the slots between the guards
+    void* mapping = mmap(nullptr, arena->mappingSize, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    arena->mapping = static_cast<uint8_t*>(mapping);
+    arena->slots = arena->mapping + page;
+    if (mprotect(arena->slots, ARENA_BYTES, PROT_READ | PROT_WRITE) != 0) {
+        throw std::bad_alloc();
+    }
+#ifdef MADV_DONTDUMP
+    madvise(arena->slots, ARENA_BYTES, MADV_DONTDUMP);
+#endif
+    arena->locked = mlock(arena->slots, ARENA_BYTES) == 0;
+#endif
+
+    if (!arena->locked) {
+        ++unlockedArenas_;
+    }
+
+    // Fresh mappings are zero filled; hand out low addresses first
+    freeSlots_.reserve(freeSlots_.size() + ARENA_SLOTS);
+    for (size_t i = ARENA_SLOTS; i-- > 0;) {
+        freeSlots_.push_back(arena->slots + i * SLOT_SIZE);
+    }
+    arenas_.push_back(std::move(arena));
+}
+
+} // namespace shurium
@@ -0,0 +1,142 @@
+// SHURIUM - SHA-1 Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// SHA-1 implementation (FIPS 180-4)
+
+#include "shurium/crypto/sha1.h"
+#include <cstring>
+
+namespace shurium {
+
+namespace {
+
+/// Initial hash values
+constexpr uint32_t SHA1_INIT[5] = {
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+// Left rotate
+inline uint32_t ROL(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+/// Read big-endian 32-bit value
+inline uint32_t ReadBE32(const Byte* ptr) {
+    return (static_cast<uint32_t>(ptr[0]) << 24) |
+           (static_cast<uint32_t>(ptr[1]) << 16) |
+           (static_cast<uint32_t>(ptr[2]) << 8) |
+           static_cast<uint32_t>(ptr[3]);
+}
+
+/// Write big-endian 32-bit value
+inline void WriteBE32(Byte* ptr, uint32_t val) {
+    ptr[0] = static_cast<Byte>(val >> 24);
+    ptr[1] = static_cast<Byte>(val >> 16);
+    ptr[2] = static_cast<Byte>(val >> 8);
+    ptr[3] = static_cast<Byte>(val);
+}
+
+/// Write big-endian 64-bit value
+inline void WriteBE64(Byte* ptr, uint64_t val) {
+    WriteBE32(ptr, static_cast<uint32_t>(val >> 32));
+    WriteBE32(ptr + 4, static_cast<uint32_t>(val));
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// SHA1 Implementation
+// ============================================================================
+
+SHA1::SHA1() {
+    Reset();
+}
+
+SHA1& SHA1::Reset() {
+    std::memcpy(state_, SHA1_INIT, sizeof(state_));
+    bytes_ = 0;
+    return *this;
+}
+
+void SHA1::Transform(const Byte block[BLOCK_SIZE]) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = ReadBE32(block + 4 * i);
+    }
+    for (int i = 16; i < 80; ++i) {
+        w[i] = ROL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3], e = state_[4];
+    for (int i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = ROL(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = ROL(b, 30);
+        b = a;
+        a = t;
+    }
+    
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+}
+
+SHA1& SHA1::Write(const Byte* data, size_t len) {
+    if (data == nullptr || len == 0) {
+        return *this;
+    }
+    
+    const Byte* end = data + len;
+    size_t bufPos = bytes_ % BLOCK_SIZE;
+    
+    if (bufPos && bufPos + len >= BLOCK_SIZE) {
+        // Fill and process buffer
+        std::memcpy(buffer_ + bufPos, data, BLOCK_SIZE - bufPos);
+        bytes_ += BLOCK_SIZE - bufPos;
+        data += BLOCK_SIZE - bufPos;
+        Transform(buffer_);
+        bufPos = 0;
+    }
+    
+    while (end - data >= static_cast<ptrdiff_t>(BLOCK_SIZE)) {
+        Transform(data);
+        bytes_ += BLOCK_SIZE;
+        data += BLOCK_SIZE;
+    }
+    
+    if (end > data) {
+        std::memcpy(buffer_ + bufPos, data, end - data);
+        bytes_ += end - data;
+    }
+    
+    return *this;
+}
+
+void SHA1::Finalize(Byte hash[OUTPUT_SIZE]) {
+    static const Byte pad[64] = {0x80};
+    Byte sizedesc[8];
+    WriteBE64(sizedesc, bytes_ << 3);
+    Write(pad, 1 + ((119 - (bytes_ % 64)) % 64));
+    Write(sizedesc, 8);
+    for (int i = 0; i < 5; ++i) {
+        WriteBE32(hash + 4 * i, state_[i]);
+    }
+}
+
+} // namespace shurium
@@ -6,8 +6,20 @@
 // Reference: https://csrc.nist.gov/publications/detail/fips/180/4/final
 
 #include "shurium/crypto/sha256.h"
+#include <atomic>
 #include <cstring>
 
+#if defined(SHURIUM_SHA256_SHANI) || defined(SHURIUM_SHA256_SSE41) || \
+    defined(SHURIUM_SHA256_AVX2) || defined(SHURIUM_SHA256_AVX512)
+#define SHURIUM_SHA256_X86 1
+#include <cpuid.h>
+#endif
+
+#if defined(SHURIUM_SHA256_ARMV8) && !defined(__APPLE__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
 namespace shurium {
 
 // ============================================================================
@@ -97,6 +109,14 @@ inline void WriteBE32(Byte* ptr, uint32_t val) {
     ptr[3] = static_cast<Byte>(val);
 }
 
+/// Write a 32-bit little-endian word to byte array
+inline void WriteLE32(Byte* ptr, uint32_t val) {
+    ptr[0] = static_cast<Byte>(val);
+    ptr[1] = static_cast<Byte>(val >> 8);
+    ptr[2] = static_cast<Byte>(val >> 16);
+    ptr[3] = static_cast<Byte>(val >> 24);
+}
+
 /// Write a 64-bit big-endian word to byte array
 inline void WriteBE64(Byte* ptr, uint64_t val) {
     ptr[0] = static_cast<Byte>(val >> 56);
@@ -109,8 +129,685 @@ inline void WriteBE64(Byte* ptr, uint64_t val) {
     ptr[7] = static_cast<Byte>(val);
 }
 
+/// Portable compression function
+void TransformScalar(uint32_t* state, const Byte* chunk, size_t blocks) {
+    while (blocks--) {
+        // Message schedule array
+        uint32_t W[64];
+        
+        // Prepare the message schedule
+        for (int i = 0; i < 16; ++i) {
+            W[i] = ReadBE32(chunk + i * 4);
+        }
+        for (int i = 16; i < 64; ++i) {
+            W[i] = sigma1(W[i-2]) + W[i-7] + sigma0(W[i-15]) + W[i-16];
+        }
+        
+        // Working variables
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+        
+        // Main loop (64 rounds)
+        for (int i = 0; i < 64; ++i) {
+            uint32_t T1 = h + Sigma1(e) + Ch(e, f, g) + K[i] + W[i];
+            uint32_t T2 = Sigma0(a) + Maj(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + T1;
+            d = c;
+            c = b;
+            b = a;
+            a = T1 + T2;
+        }
+        
+        // Update state
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        
+        chunk += 64;
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Transform Dispatch
+// ============================================================================
+
+#if defined(SHURIUM_SHA256_SHANI)
+namespace sha256_shani {
+void Transform(uint32_t* state, const Byte* chunk, size_t blocks);
+}
+#endif
+
+#if defined(SHURIUM_SHA256_ARMV8)
+namespace sha256_armv8 {
+void Transform(uint32_t* state, const Byte* chunk, size_t blocks);
+}
+#endif
+
+#if defined(SHURIUM_SHA256_SSE41)
+namespace sha256_sse41 {
+void DoubleSHA256_64_4way(Byte* out, const Byte* in);
+void DoubleSHA256_80_4way(Byte* out, const uint32_t* mid, const Byte* tail,
+                          const Byte* nonces);
+void DoubleSHA256_Headers_4way(Byte* out, const Byte* in);
+}
+#endif
+
+#if defined(SHURIUM_SHA256_AVX2)
+namespace sha256_avx2 {
+void DoubleSHA256_64_8way(Byte* out, const Byte* in);
+void DoubleSHA256_80_8way(Byte* out, const uint32_t* mid, const Byte* tail,
+                          const Byte* nonces);
+void DoubleSHA256_Headers_8way(Byte* out, const Byte* in);
+}
+#endif
+
+#if defined(SHURIUM_SHA256_AVX512)
+namespace sha256_avx512 {
+void DoubleSHA256_64_16way(Byte* out, const Byte* in);
+void DoubleSHA256_80_16way(Byte* out, const uint32_t* mid, const Byte* tail,
+                          const Byte* nonces);
+void DoubleSHA256_Headers_16way(Byte* out, const Byte* in);
+}
+#endif
+
+namespace {
+
+using TransformFn = void (*)(uint32_t* state, const Byte* chunk, size_t blocks);
+
+/// Double-SHA256 of a fixed number of 64-byte messages
+using D64Fn = void (*)(Byte* out, const Byte* in);
+
+/// Double-SHA256 of a fixed number of 80-byte headers differing in the nonce
+using D80Fn = void (*)(Byte* out, const uint32_t* mid, const Byte* tail, const Byte* nonces);
+
+/// Double-SHA256 of a fixed number of unrelated 80-byte headers
+using DHdrFn = void (*)(Byte* out, const Byte* in);
+
+#if defined(SHURIUM_SHA256_X86)
+struct X86Features {
+    bool sse41 = false;
+    bool shani = false;
+    bool avx2 = false;
+    bool avx512 = false;
+};
+
+/// Register state the OS saves on context switch (XCR0)
+uint64_t ReadXCR0() {
+    uint32_t lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+X86Features DetectX86Features() {
+    X86Features features;
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return features;
+    }
+    // SHA-NI also uses SSSE3 shuffles and SSE4.1 blends
+    bool ssse3 = (ecx & bit_SSSE3) != 0;
+    features.sse41 = (ecx & bit_SSE4_1) != 0;
+    bool osxsave = (ecx & bit_OSXSAVE) != 0;
+    if (__get_cpuid_max(0, nullptr) < 7) {
+        return features;
+    }
+    unsigned int ebx7;
+    __cpuid_count(7, 0, eax, ebx7, ecx, edx);
+    features.shani = ssse3 && features.sse41 && (ebx7 & bit_SHA) != 0;
+
+    // Wide registers are only usable if the OS preserves them
+    uint64_t xcr0 = osxsave ? ReadXCR0() : 0;
+    bool ymm = (xcr0 & 0x6) == 0x6;
+    bool zmm = (xcr0 & 0xe6) == 0xe6;
+    features.avx2 = ymm && (ebx7 & bit_AVX2) != 0;
+    features.avx512 = zmm && (ebx7 & bit_AVX512F) != 0;
+    return features;
+}
+
+const X86Features& GetX86Features() {
+    static const X86Features features = DetectX86Features();
+    return features;
+}
+#endif
+
+#if defined(SHURIUM_SHA256_ARMV8)
+bool CPUHasARMv8SHA2() {
+#if defined(__APPLE__)
+    // Every Apple ARM64 core has the cryptography extensions
+    return true;
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#endif
+}
+#endif
+
+/// The transform for impl, or null if not built in or not supported by the CPU
+TransformFn GetSupportedTransform(SHA256Implementation impl) {
+    switch (impl) {
+        case SHA256Implementation::SCALAR:
+            return TransformScalar;
+        case SHA256Implementation::SHANI:
+#if defined(SHURIUM_SHA256_SHANI)
+            if (GetX86Features().shani) {
+                return sha256_shani::Transform;
+            }
+#endif
+            return nullptr;
+        case SHA256Implementation::ARMV8:
+#if defined(SHURIUM_SHA256_ARMV8)
+            if (CPUHasARMv8SHA2()) {
+                return sha256_armv8::Transform;
+            }
+#endif
+            return nullptr;
+    }
+    return nullptr;
+}
+
+/**
+ * Check a transform against the FIPS 180-4 "abc" digest and against the
+ * scalar transform over several blocks, so a miscompiled or faulty
+ * hardware path is never selected.
+ */
+bool SelfTest(TransformFn transform) {
+    Byte abc[64] = {'a', 'b', 'c', 0x80};
+    abc[63] = 24;
+    static constexpr uint32_t ABC_DIGEST[8] = {
+        0xba7816bf, 0x8f01cfea, 0x414140de, 0x5dae2223,
+        0xb00361a3, 0x96177a9c, 0xb410ff61, 0xf20015ad
+    };
+    uint32_t state[8];
+    std::memcpy(state, SHA256_INIT, sizeof(state));
+    transform(state, abc, 1);
+    if (std::memcmp(state, ABC_DIGEST, sizeof(state)) != 0) {
+        return false;
+    }
+
+    Byte data[64 * 5];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = static_cast<Byte>(i * 7 + 3);
+    }
+    uint32_t expected[8];
+    std::memcpy(state, SHA256_INIT, sizeof(state));
+    std::memcpy(expected, SHA256_INIT, sizeof(expected));
+    transform(state, data, 5);
+    TransformScalar(expected, data, 5);
+    return std::memcmp(state, expected, sizeof(state)) == 0;
+}
+
+/// Usable transform for impl: supported by the CPU and self-tested
+TransformFn GetVerifiedTransform(SHA256Implementation impl) {
+    TransformFn transform = GetSupportedTransform(impl);
+    return transform && SelfTest(transform) ? transform : nullptr;
+}
+
+/// Fastest first
+constexpr SHA256Implementation PREFERENCE[] = {
+    SHA256Implementation::SHANI,
+    SHA256Implementation::ARMV8,
+    SHA256Implementation::SCALAR,
+};
+
+/// Padding block following a 64-byte message (length 512 bits)
+constexpr Byte PADDING_64[64] = {
+    0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0x00
+};
+
+/// Padding completing a block after a 32-byte message (length 256 bits)
+constexpr Byte PADDING_32[32] = {
+    0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00
+};
+
+/// Second hash of a 32-byte digest held as a state
+void HashDigest1way(TransformFn transform, Byte* out, uint32_t state[8]) {
+    Byte block[64];
+    for (int i = 0; i < 8; ++i) {
+        WriteBE32(block + i * 4, state[i]);
+    }
+    std::memcpy(block + 32, PADDING_32, sizeof(PADDING_32));
+    std::memcpy(state, SHA256_INIT, 32);
+    transform(state, block, 1);
+    for (int i = 0; i < 8; ++i) {
+        WriteBE32(out + i * 4, state[i]);
+    }
+}
+
+/// One message through the single-block transform, skipping the buffering
+void DoubleSHA256_64_1way(TransformFn transform, Byte* out, const Byte* in) {
+    uint32_t state[8];
+    std::memcpy(state, SHA256_INIT, sizeof(state));
+    transform(state, in, 1);
+    transform(state, PADDING_64, 1);
+    HashDigest1way(transform, out, state);
+}
+
+/// One 80-byte header from its midstate: the tail block, then the second hash
+void DoubleSHA256_80_1way(TransformFn transform, Byte* out, const uint32_t* mid,
+                          const Byte* tail, const Byte* nonce) {
+    Byte block[64] = {};
+    std::memcpy(block, tail, 12);
+    std::memcpy(block + 12, nonce, 4);
+    block[16] = 0x80;
+    block[62] = 0x02;
+    block[63] = 0x80;
+
+    uint32_t state[8];
+    std::memcpy(state, mid, sizeof(state));
+    transform(state, block, 1);
+    HashDigest1way(transform, out, state);
+}
+
+/// One unrelated 80-byte header: both blocks of the first hash, then the second
+void DoubleSHA256_Header_1way(TransformFn transform, Byte* out, const Byte* in) {
+    Byte block[64] = {};
+    std::memcpy(block, in + 64, 16);
+    block[16] = 0x80;
+    block[62] = 0x02;
+    block[63] = 0x80;
+
+    uint32_t state[8];
+    std::memcpy(state, SHA256_INIT, sizeof(state));
+    transform(state, in, 1);
+    transform(state, block, 1);
+    HashDigest1way(transform, out, state);
+}
+
+/// Multi-message kernel of the given width, or null if not built in or not supported
+D64Fn GetSupportedD64(size_t ways) {
+#if defined(SHURIUM_SHA256_X86)
+    const X86Features& features = GetX86Features();
+#endif
+    switch (ways) {
+#if defined(SHURIUM_SHA256_SSE41)
+        case 4:
+            return features.sse41 ? sha256_sse41::DoubleSHA256_64_4way : nullptr;
+#endif
+#if defined(SHURIUM_SHA256_AVX2)
+        case 8:
+            return features.avx2 ? sha256_avx2::DoubleSHA256_64_8way : nullptr;
+#endif
+#if defined(SHURIUM_SHA256_AVX512)
+        case 16:
+            return features.avx512 ? sha256_avx512::DoubleSHA256_64_16way : nullptr;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+/// A kernel is used only if it matches the scalar path on every lane
+bool SelfTestD64(D64Fn kernel, size_t ways) {
+    Byte in[64 * 16];
+    for (size_t i = 0; i < sizeof(in); ++i) {
+        in[i] = static_cast<Byte>(i * 13 + 5);
+    }
+    Byte out[32 * 16];
+    Byte expected[32 * 16];
+    kernel(out, in);
+    for (size_t i = 0; i < ways; ++i) {
+        DoubleSHA256_64_1way(TransformScalar, expected + i * 32, in + i * 64);
+    }
+    return std::memcmp(out, expected, 32 * ways) == 0;
+}
+
+D64Fn GetVerifiedD64(size_t ways) {
+    D64Fn kernel = GetSupportedD64(ways);
+    return kernel && SelfTestD64(kernel, ways) ? kernel : nullptr;
+}
+
+/// Header kernel of the given width, or null if not built in or not supported
+D80Fn GetSupportedD80(size_t ways) {
+#if defined(SHURIUM_SHA256_X86)
+    const X86Features& features = GetX86Features();
+#endif
+    switch (ways) {
+#if defined(SHURIUM_SHA256_SSE41)
+        case 4:
+            return features.sse41 ? sha256_sse41::DoubleSHA256_80_4way : nullptr;
+#endif
+#if defined(SHURIUM_SHA256_AVX2)
+        case 8:
+            return features.avx2 ? sha256_avx2::DoubleSHA256_80_8way : nullptr;
+#endif
+#if defined(SHURIUM_SHA256_AVX512)
+        case 16:
+            return features.avx512 ? sha256_avx512::DoubleSHA256_80_16way : nullptr;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+/// A header kernel is used only if it matches the scalar path on every lane
+bool SelfTestD80(D80Fn kernel, size_t ways) {
+    uint32_t mid[8];
+    for (int i = 0; i < 8; ++i) {
+        mid[i] = 0x01234567u * static_cast<uint32_t>(i + 1);
+    }
+    Byte tail[12];
+    for (size_t i = 0; i < sizeof(tail); ++i) {
+        tail[i] = static_cast<Byte>(i * 11 + 7);
+    }
+    Byte nonces[4 * 16];
+    for (size_t i = 0; i < sizeof(nonces); ++i) {
+        nonces[i] = static_cast<Byte>(i * 29 + 1);
+    }
+    Byte out[32 * 16];
+    Byte expected[32 * 16];
+    kernel(out, mid, tail, nonces);
+    for (size_t i = 0; i < ways; ++i) {
+        DoubleSHA256_80_1way(TransformScalar, expected + i * 32, mid, tail, nonces + i * 4);
+    }
+    return std::memcmp(out, expected, 32 * ways) == 0;
+}
+
+D80Fn GetVerifiedD80(size_t ways) {
+    D80Fn kernel = GetSupportedD80(ways);
+    return kernel && SelfTestD80(kernel, ways) ? kernel : nullptr;
+}
+
+/// Unrelated-header kernel of the given width, or null if not built in or not supported
+DHdrFn GetSupportedDHdr(size_t ways) {
+#if defined(SHURIUM_SHA256_X86)
+    const X86Features& features = GetX86Features();
+#endif
+    switch (ways) {
+#if defined(SHURIUM_SHA256_SSE41)
+        case 4:
+            return features.sse41 ? sha256_sse41::DoubleSHA256_Headers_4way : nullptr;
+#endif
+#if defined(SHURIUM_SHA256_AVX2)
+        case 8:
+            return features.avx2 ? sha256_avx2::DoubleSHA256_Headers_8way : nullptr;
+#endif
+#if defined(SHURIUM_SHA256_AVX512)
+        case 16:
+            return features.avx512 ? sha256_avx512::DoubleSHA256_Headers_16way : nullptr;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+/// Checked against the scalar path on every lane, like the others
+bool SelfTestDHdr(DHdrFn kernel, size_t ways) {
+    Byte in[80 * 16];
+    for (size_t i = 0; i < sizeof(in); ++i) {
+        in[i] = static_cast<Byte>(i * 31 + 9);
+    }
+    Byte out[32 * 16];
+    Byte expected[32 * 16];
+    kernel(out, in);
+    for (size_t i = 0; i < ways; ++i) {
+        DoubleSHA256_Header_1way(TransformScalar, expected + i * 32, in + i * 80);
+    }
+    return std::memcmp(out, expected, 32 * ways) == 0;
+}
+
+DHdrFn GetVerifiedDHdr(size_t ways) {
+    DHdrFn kernel = GetSupportedDHdr(ways);
+    return kernel && SelfTestDHdr(kernel, ways) ? kernel : nullptr;
+}
+
+/// Kernel widths, widest first; 1 is the single-block transform
+constexpr size_t D64_WAYS[] = {16, 8, 4, 1};
+
+struct Dispatch {
+    std::atomic<TransformFn> transform;
+    std::atomic<SHA256Implementation> impl;
+
+    /// Verified kernels by width (null if unavailable) and the widest to use
+    D64Fn d64x16 = nullptr;
+    D64Fn d64x8 = nullptr;
+    D64Fn d64x4 = nullptr;
+    std::atomic<size_t> d64Ways{1};
+
+    /// Header kernels, used up to the same width
+    D80Fn d80x16 = nullptr;
+    D80Fn d80x8 = nullptr;
+    D80Fn d80x4 = nullptr;
+
+    /// Unrelated-header kernels, likewise
+    DHdrFn dhdrx16 = nullptr;
+    DHdrFn dhdrx8 = nullptr;
+    DHdrFn dhdrx4 = nullptr;
+
+    Dispatch() : transform(TransformScalar), impl(SHA256Implementation::SCALAR) {
+        for (SHA256Implementation candidate : PREFERENCE) {
+            if (TransformFn fn = GetVerifiedTransform(candidate)) {
+                transform.store(fn, std::memory_order_relaxed);
+                impl.store(candidate, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        d64x16 = GetVerifiedD64(16);
+        d64x8 = GetVerifiedD64(8);
+        d64x4 = GetVerifiedD64(4);
+        d80x16 = GetVerifiedD80(16);
+        d80x8 = GetVerifiedD80(8);
+        d80x4 = GetVerifiedD80(4);
+        dhdrx16 = GetVerifiedDHdr(16);
+        dhdrx8 = GetVerifiedDHdr(8);
+        dhdrx4 = GetVerifiedDHdr(4);
+        bool shani = impl.load(std::memory_order_relaxed) == SHA256Implementation::SHANI;
+        for (size_t ways : D64_WAYS) {
+            if (IsD64Available(ways) && !(ways == 4 && shani)) {
+                d64Ways.store(ways, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    bool IsD64Available(size_t ways) const {
+        switch (ways) {
+            case 1: return true;
+            case 4: return d64x4 != nullptr;
+            case 8: return d64x8 != nullptr;
+            case 16: return d64x16 != nullptr;
+            default: return false;
+        }
+    }
+};
+
+/// Selected on first use, which also covers hashing during static init
+Dispatch& GetDispatch() {
+    static Dispatch dispatch;
+    return dispatch;
+}
+
 } // anonymous namespace
 
+const char* SHA256ImplementationName(SHA256Implementation impl) {
+    switch (impl) {
+        case SHA256Implementation::SCALAR: return "scalar";
+        case SHA256Implementation::SHANI: return "shani";
+        case SHA256Implementation::ARMV8: return "armv8";
+    }
+    return "unknown";
+}
+
+SHA256Implementation SHA256AutoDetect() {
+    return GetDispatch().impl.load(std::memory_order_relaxed);
+}
+
+SHA256Implementation GetSHA256Implementation() {
+    return GetDispatch().impl.load(std::memory_order_relaxed);
+}
+
+std::vector<SHA256Implementation> GetAvailableSHA256Implementations() {
+    std::vector<SHA256Implementation> result;
+    for (SHA256Implementation impl : PREFERENCE) {
+        if (GetVerifiedTransform(impl)) {
+            result.push_back(impl);
+        }
+    }
+    return result;
+}
+
+bool SetSHA256Implementation(SHA256Implementation impl) {
+    TransformFn transform = GetVerifiedTransform(impl);
+    if (!transform) {
+        return false;
+    }
+    Dispatch& dispatch = GetDispatch();
+    dispatch.transform.store(transform, std::memory_order_relaxed);
+    dispatch.impl.store(impl, std::memory_order_relaxed);
+    return true;
+}
+
+void DoubleSHA256_64(Byte* out, const Byte* in, size_t blocks) {
+    Dispatch& dispatch = GetDispatch();
+    size_t ways = dispatch.d64Ways.load(std::memory_order_relaxed);
+
+    // Widest kernel first; the narrower ones take what is left
+    if (ways >= 16 && dispatch.d64x16) {
+        for (; blocks >= 16; blocks -= 16, in += 64 * 16, out += 32 * 16) {
+            dispatch.d64x16(out, in);
+        }
+    }
+    if (ways >= 8 && dispatch.d64x8) {
+        for (; blocks >= 8; blocks -= 8, in += 64 * 8, out += 32 * 8) {
+            dispatch.d64x8(out, in);
+        }
+    }
+    // One SHA-NI core outruns the four SSE4.1 lanes, so on SHA-NI that
+    // kernel only runs when explicitly selected
+    bool shani = dispatch.impl.load(std::memory_order_relaxed) == SHA256Implementation::SHANI;
+    if (dispatch.d64x4 && (ways == 4 || (ways > 4 && !shani))) {
+        for (; blocks >= 4; blocks -= 4, in += 64 * 4, out += 32 * 4) {
+            dispatch.d64x4(out, in);
+        }
+    }
+    TransformFn transform = dispatch.transform.load(std::memory_order_relaxed);
+    for (; blocks > 0; --blocks, in += 64, out += 32) {
+        DoubleSHA256_64_1way(transform, out, in);
+    }
+}
+
+SHA256Midstate SHA256HeaderMidstate(const Byte* header) {
+    SHA256Midstate mid;
+    std::memcpy(mid.state, SHA256_INIT, sizeof(mid.state));
+    GetDispatch().transform.load(std::memory_order_relaxed)(mid.state, header, 1);
+    return mid;
+}
+
+void DoubleSHA256_80_Nonces(Byte* out, const SHA256Midstate& mid, const Byte* tail,
+                            uint32_t firstNonce, size_t count) {
+    Dispatch& dispatch = GetDispatch();
+    size_t ways = dispatch.d64Ways.load(std::memory_order_relaxed);
+
+    // The nonces as serialized, little-endian, one per lane
+    Byte nonces[4 * 16];
+    auto fill = [&](size_t lanes) {
+        for (size_t i = 0; i < lanes; ++i) {
+            WriteLE32(nonces + 4 * i, firstNonce + static_cast<uint32_t>(i));
+        }
+    };
+    auto advance = [&](size_t lanes) {
+        firstNonce += static_cast<uint32_t>(lanes);
+        count -= lanes;
+        out += 32 * lanes;
+    };
+
+    // Same kernel choice as DoubleSHA256_64
+    if (ways >= 16 && dispatch.d80x16) {
+        for (; count >= 16; advance(16)) {
+            fill(16);
+            dispatch.d80x16(out, mid.state, tail, nonces);
+        }
+    }
+    if (ways >= 8 && dispatch.d80x8) {
+        for (; count >= 8; advance(8)) {
+            fill(8);
+            dispatch.d80x8(out, mid.state, tail, nonces);
+        }
+    }
+    bool shani = dispatch.impl.load(std::memory_order_relaxed) == SHA256Implementation::SHANI;
+    if (dispatch.d80x4 && (ways == 4 || (ways > 4 && !shani))) {
+        for (; count >= 4; advance(4)) {
+            fill(4);
+            dispatch.d80x4(out, mid.state, tail, nonces);
+        }
+    }
+    TransformFn transform = dispatch.transform.load(std::memory_order_relaxed);
+    for (; count > 0; advance(1)) {
+        fill(1);
+        DoubleSHA256_80_1way(transform, out, mid.state, tail, nonces);
+    }
+}
+
+void DoubleSHA256_80(Byte* out, const Byte* in, size_t count) {
+    Dispatch& dispatch = GetDispatch();
+    size_t ways = dispatch.d64Ways.load(std::memory_order_relaxed);
+
+    // Same kernel choice as DoubleSHA256_64
+    if (ways >= 16 && dispatch.dhdrx16) {
+        for (; count >= 16; count -= 16, in += 80 * 16, out += 32 * 16) {
+            dispatch.dhdrx16(out, in);
+        }
+    }
+    if (ways >= 8 && dispatch.dhdrx8) {
+        for (; count >= 8; count -= 8, in += 80 * 8, out += 32 * 8) {
+            dispatch.dhdrx8(out, in);
+        }
+    }
+    bool shani = dispatch.impl.load(std::memory_order_relaxed) == SHA256Implementation::SHANI;
+    if (dispatch.dhdrx4 && (ways == 4 || (ways > 4 && !shani))) {
+        for (; count >= 4; count -= 4, in += 80 * 4, out += 32 * 4) {
+            dispatch.dhdrx4(out, in);
+        }
+    }
+    TransformFn transform = dispatch.transform.load(std::memory_order_relaxed);
+    for (; count > 0; --count, in += 80, out += 32) {
+        DoubleSHA256_Header_1way(transform, out, in);
+    }
+}
+
+size_t GetSHA256D64Ways() {
+    return GetDispatch().d64Ways.load(std::memory_order_relaxed);
+}
+
+std::vector<size_t> GetAvailableSHA256D64Ways() {
+    const Dispatch& dispatch = GetDispatch();
+    std::vector<size_t> result;
+    for (size_t ways : D64_WAYS) {
+        if (dispatch.IsD64Available(ways)) {
+            result.push_back(ways);
+        }
+    }
+    return result;
+}
+
+bool SetSHA256D64Ways(size_t ways) {
+    Dispatch& dispatch = GetDispatch();
+    if (!dispatch.IsD64Available(ways)) {
+        return false;
+    }
+    dispatch.d64Ways.store(ways, std::memory_order_relaxed);
+    return true;
+}
+
 // ============================================================================
 // SHA256 Implementation
 // ============================================================================
@@ -126,51 +823,8 @@ SHA256& SHA256::Reset() {
     return *this;
 }
 
-void SHA256::Transform(const Byte block[BLOCK_SIZE]) {
-    // Message schedule array
-    uint32_t W[64];
-    
-    // Prepare the message schedule
-    for (int i = 0; i < 16; ++i) {
-        W[i] = ReadBE32(block + i * 4);
-    }
-    for (int i = 16; i < 64; ++i) {
-        W[i] = sigma1(W[i-2]) + W[i-7] + sigma0(W[i-15]) + W[i-16];
-    }
-    
-    // Working variables
-    uint32_t a = state_[0];
-    uint32_t b = state_[1];
-    uint32_t c = state_[2];
-    uint32_t d = state_[3];
-    uint32_t e = state_[4];
-    uint32_t f = state_[5];
-    uint32_t g = state_[6];
-    uint32_t h = state_[7];
-    
-    // Main loop (64 rounds)
-    for (int i = 0; i < 64; ++i) {
-        uint32_t T1 = h + Sigma1(e) + Ch(e, f, g) + K[i] + W[i];
-        uint32_t T2 = Sigma0(a) + Maj(a, b, c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + T1;
-        d = c;
-        c = b;
-        b = a;
-        a = T1 + T2;
-    }
-    
-    // Update state
-    state_[0] += a;
-    state_[1] += b;
-    state_[2] += c;
-    state_[3] += d;
-    state_[4] += e;
-    state_[5] += f;
-    state_[6] += g;
-    state_[7] += h;
+void SHA256::Transform(const Byte* blocks, size_t nBlocks) {
+    GetDispatch().transform.load(std::memory_order_relaxed)(state_, blocks, nBlocks);
 }
 
 SHA256& SHA256::Write(const Byte* data, size_t len) {
@@ -190,16 +844,17 @@ SHA256& SHA256::Write(const Byte* data, size_t len) {
             return *this;
         }
         std::memcpy(buffer_ + bufPos, data, needed);
-        Transform(buffer_);
+        Transform(buffer_, 1);
         data += needed;
         len -= needed;
     }
     
-    // Process complete blocks
-    while (len >= BLOCK_SIZE) {
-        Transform(data);
-        data += BLOCK_SIZE;
-        len -= BLOCK_SIZE;
+    // Process complete blocks in one call
+    if (len >= BLOCK_SIZE) {
+        size_t nBlocks = len / BLOCK_SIZE;
+        Transform(data, nBlocks);
+        data += nBlocks * BLOCK_SIZE;
+        len -= nBlocks * BLOCK_SIZE;
     }
     
     // Store remaining bytes in buffer
@@ -224,7 +879,7 @@ void SHA256::Finalize(Byte hash[OUTPUT_SIZE]) {
     // If not enough room for length, pad to block boundary and process
     if (bufPos > 56) {
         std::memset(pad + bufPos, 0, BLOCK_SIZE - bufPos);
-        Transform(pad);
+        Transform(pad, 1);
         bufPos = 0;
         std::memset(pad, 0, 56);
     } else {
@@ -234,7 +889,7 @@ void SHA256::Finalize(Byte hash[OUTPUT_SIZE]) {
     // Append length in bits (big-endian, 64-bit)
     uint64_t bits = bytes_ * 8;
     WriteBE64(pad + 56, bits);
-    Transform(pad);
+    Transform(pad, 1);
     
     // Output hash (big-endian)
     for (int i = 0; i < 8; ++i) {
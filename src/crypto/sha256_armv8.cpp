@@ -0,0 +1,94 @@
+// SHURIUM - SHA256 Transform Using ARMv8 Cryptography Extensions
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -march=armv8-a+crypto and only called after the kernel
+// reports HWCAP_SHA2. Each sha256h/sha256h2 pair performs four rounds on
+// the ABCD/EFGH halves of the state.
+
+#include "shurium/core/types.h"
+#include <cstddef>
+#include <cstdint>
+#include <arm_neon.h>
+
+namespace shurium {
+
+namespace {
+
+alignas(16) constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32x4_t Load(const Byte* in) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in)));
+}
+
+/// Rounds 4*quad .. 4*quad+3 with message words m
+inline void QuadRound(uint32x4_t& abcd, uint32x4_t& efgh, uint32x4_t m, int quad) {
+    const uint32x4_t msg = vaddq_u32(m, vld1q_u32(K + 4 * quad));
+    const uint32x4_t abcdPrev = abcd;
+    abcd = vsha256hq_u32(abcd, efgh, msg);
+    efgh = vsha256h2q_u32(efgh, abcdPrev, msg);
+}
+
+/// Next four schedule words from the previous sixteen
+inline uint32x4_t Schedule(uint32x4_t m0, uint32x4_t m1, uint32x4_t m2, uint32x4_t m3) {
+    return vsha256su1q_u32(vsha256su0q_u32(m0, m1), m2, m3);
+}
+
+} // anonymous namespace
+
+namespace sha256_armv8 {
+
+void Transform(uint32_t* state, const Byte* chunk, size_t blocks) {
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32x4_t efgh = vld1q_u32(state + 4);
+
+    while (blocks--) {
+        const uint32x4_t saved0 = abcd;
+        const uint32x4_t saved1 = efgh;
+
+        uint32x4_t m0 = Load(chunk);
+        uint32x4_t m1 = Load(chunk + 16);
+        uint32x4_t m2 = Load(chunk + 32);
+        uint32x4_t m3 = Load(chunk + 48);
+
+        for (int quad = 0; quad < 16; quad += 4) {
+            QuadRound(abcd, efgh, m0, quad);
+            QuadRound(abcd, efgh, m1, quad + 1);
+            QuadRound(abcd, efgh, m2, quad + 2);
+            QuadRound(abcd, efgh, m3, quad + 3);
+            if (quad < 12) {
+                m0 = Schedule(m0, m1, m2, m3);
+                m1 = Schedule(m1, m2, m3, m0);
+                m2 = Schedule(m2, m3, m0, m1);
+                m3 = Schedule(m3, m0, m1, m2);
+            }
+        }
+
+        abcd = vaddq_u32(abcd, saved0);
+        efgh = vaddq_u32(efgh, saved1);
+        chunk += 64;
+    }
+
+    vst1q_u32(state, abcd);
+    vst1q_u32(state + 4, efgh);
+}
+
+} // namespace sha256_armv8
+} // namespace shurium
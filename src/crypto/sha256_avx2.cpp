@@ -0,0 +1,75 @@
+// SHURIUM - 8-Way Double-SHA256 and Hash160 Using AVX2
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -mavx2 and only called after CPUID and XGETBV report
+// support.
+
+#include "hash160_multiway.h"
+#include "sha256_multiway.h"
+#include <immintrin.h>
+
+namespace shurium {
+
+namespace {
+
+using sha256_multiway::ReadBE32;
+using sha256_multiway::WriteBE32;
+
+struct AVX2 {
+    using T = __m256i;
+    static constexpr size_t LANES = 8;
+
+    static inline T Add(T x, T y) { return _mm256_add_epi32(x, y); }
+    static inline T And(T x, T y) { return _mm256_and_si256(x, y); }
+    static inline T Or(T x, T y) { return _mm256_or_si256(x, y); }
+    static inline T Xor(T x, T y) { return _mm256_xor_si256(x, y); }
+    template <int N> static inline T Shr(T x) { return _mm256_srli_epi32(x, N); }
+    template <int N> static inline T Rotr(T x) {
+        return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+    }
+    static inline T Set(uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+
+    static inline T LoadBE(const Byte* p, size_t stride) {
+        return _mm256_setr_epi32(static_cast<int>(ReadBE32(p)),
+                                 static_cast<int>(ReadBE32(p + stride)),
+                                 static_cast<int>(ReadBE32(p + 2 * stride)),
+                                 static_cast<int>(ReadBE32(p + 3 * stride)),
+                                 static_cast<int>(ReadBE32(p + 4 * stride)),
+                                 static_cast<int>(ReadBE32(p + 5 * stride)),
+                                 static_cast<int>(ReadBE32(p + 6 * stride)),
+                                 static_cast<int>(ReadBE32(p + 7 * stride)));
+    }
+
+    static inline void StoreBE(Byte* p, size_t stride, T x) {
+        alignas(32) uint32_t lanes[LANES];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), x);
+        for (size_t i = 0; i < LANES; ++i) {
+            WriteBE32(p + i * stride, lanes[i]);
+        }
+    }
+};
+
+} // anonymous namespace
+
+namespace sha256_avx2 {
+
+void DoubleSHA256_64_8way(Byte* out, const Byte* in) {
+    sha256_multiway::Kernel<AVX2>::DoubleSHA256_64(out, in);
+}
+
+void DoubleSHA256_80_8way(Byte* out, const uint32_t* mid, const Byte* tail,
+                          const Byte* nonces) {
+    sha256_multiway::Kernel<AVX2>::DoubleSHA256_80(out, mid, tail, nonces);
+}
+
+void DoubleSHA256_Headers_8way(Byte* out, const Byte* in) {
+    sha256_multiway::Kernel<AVX2>::DoubleSHA256_80(out, in);
+}
+
+void Hash160_33_8way(Byte* out, const Byte* in) {
+    hash160_multiway::Kernel<AVX2>::Hash160_33(out, in);
+}
+
+} // namespace sha256_avx2
+} // namespace shurium
@@ -0,0 +1,84 @@
+// SHURIUM - 16-Way Double-SHA256 and Hash160 Using AVX-512
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -mavx512f and only called after CPUID and XGETBV report
+// support. Uses the native 32-bit rotate.
+
+// GCC 12 reports the undefined upper half that _mm512_srli_epi32 and
+// _mm512_ror_epi32 start from as uninitialized, hundreds of times once
+// the kernels are inlined. The values are fully defined; silence that
+// noise here so it does not bury real warnings elsewhere.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include "hash160_multiway.h"
+#include "sha256_multiway.h"
+#include <immintrin.h>
+
+namespace shurium {
+
+namespace {
+
+using sha256_multiway::ReadBE32;
+using sha256_multiway::WriteBE32;
+
+struct AVX512 {
+    using T = __m512i;
+    static constexpr size_t LANES = 16;
+
+    static inline T Add(T x, T y) { return _mm512_add_epi32(x, y); }
+    static inline T And(T x, T y) { return _mm512_and_si512(x, y); }
+    static inline T Or(T x, T y) { return _mm512_or_si512(x, y); }
+    static inline T Xor(T x, T y) { return _mm512_xor_si512(x, y); }
+    template <int N> static inline T Shr(T x) { return _mm512_srli_epi32(x, N); }
+    template <int N> static inline T Rotr(T x) { return _mm512_ror_epi32(x, N); }
+    static inline T Set(uint32_t x) { return _mm512_set1_epi32(static_cast<int>(x)); }
+
+    static inline T LoadBE(const Byte* p, size_t stride) {
+        alignas(64) uint32_t lanes[LANES];
+        for (size_t i = 0; i < LANES; ++i) {
+            lanes[i] = ReadBE32(p + i * stride);
+        }
+        return _mm512_load_si512(lanes);
+    }
+
+    static inline void StoreBE(Byte* p, size_t stride, T x) {
+        alignas(64) uint32_t lanes[LANES];
+        _mm512_store_si512(lanes, x);
+        for (size_t i = 0; i < LANES; ++i) {
+            WriteBE32(p + i * stride, lanes[i]);
+        }
+    }
+};
+
+} // anonymous namespace
+
+namespace sha256_avx512 {
+
+void DoubleSHA256_64_16way(Byte* out, const Byte* in) {
+    sha256_multiway::Kernel<AVX512>::DoubleSHA256_64(out, in);
+}
+
+void DoubleSHA256_80_16way(Byte* out, const uint32_t* mid, const Byte* tail,
+                          const Byte* nonces) {
+    sha256_multiway::Kernel<AVX512>::DoubleSHA256_80(out, mid, tail, nonces);
+}
+
+void DoubleSHA256_Headers_16way(Byte* out, const Byte* in) {
+    sha256_multiway::Kernel<AVX512>::DoubleSHA256_80(out, in);
+}
+
+void Hash160_33_16way(Byte* out, const Byte* in) {
+    hash160_multiway::Kernel<AVX512>::Hash160_33(out, in);
+}
+
+} // namespace sha256_avx512
+} // namespace shurium
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
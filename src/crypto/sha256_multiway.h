@@ -0,0 +1,262 @@
+// SHURIUM - Multi-Way Double-SHA256 Kernel
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Internal header, included only by the ISA-specific translation units.
+// Hashes V::LANES independent 64-byte messages at once, one message per
+// vector lane. V supplies the vector type T, LANES, the handful of 32-bit
+// lane operations SHA-256 needs (Add, And, Or, Xor, Rotr<n>, Shr<n>, Set)
+// and strided big-endian LoadBE/StoreBE; everything else is shared.
+//
+// The message is a full block, so the padding block of the first hash and
+// the padding of the second are fixed. The schedule of the former is
+// constant and folded into the round constants at compile time.
+
+#ifndef SHURIUM_CRYPTO_SHA256_MULTIWAY_H
+#define SHURIUM_CRYPTO_SHA256_MULTIWAY_H
+
+#include "shurium/core/types.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace shurium {
+namespace sha256_multiway {
+
+constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t INIT[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+constexpr uint32_t RotrConst(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+/// K[i] + W[i] for the padding block that follows a 64-byte message
+constexpr std::array<uint32_t, 64> PaddingRoundConstants() {
+    std::array<uint32_t, 64> w{};
+    w[0] = 0x80000000;
+    w[15] = 512;
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = RotrConst(w[i - 15], 7) ^ RotrConst(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = RotrConst(w[i - 2], 17) ^ RotrConst(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = s1 + w[i - 7] + s0 + w[i - 16];
+    }
+    for (int i = 0; i < 64; ++i) {
+        w[i] += K[i];
+    }
+    return w;
+}
+
+constexpr std::array<uint32_t, 64> PADDING_KW = PaddingRoundConstants();
+
+/// Byte order helpers for the lane loads and stores
+inline uint32_t ReadBE32(const Byte* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+inline void WriteBE32(Byte* p, uint32_t v) {
+    p[0] = static_cast<Byte>(v >> 24);
+    p[1] = static_cast<Byte>(v >> 16);
+    p[2] = static_cast<Byte>(v >> 8);
+    p[3] = static_cast<Byte>(v);
+}
+
+template <typename V>
+struct Kernel {
+    using T = typename V::T;
+
+    static inline T Ch(T x, T y, T z) { return V::Xor(z, V::And(x, V::Xor(y, z))); }
+    static inline T Maj(T x, T y, T z) { return V::Or(V::And(x, y), V::And(z, V::Or(x, y))); }
+    static inline T Sigma0(T x) {
+        return V::Xor(V::Xor(V::template Rotr<2>(x), V::template Rotr<13>(x)),
+                      V::template Rotr<22>(x));
+    }
+    static inline T Sigma1(T x) {
+        return V::Xor(V::Xor(V::template Rotr<6>(x), V::template Rotr<11>(x)),
+                      V::template Rotr<25>(x));
+    }
+    static inline T sigma0(T x) {
+        return V::Xor(V::Xor(V::template Rotr<7>(x), V::template Rotr<18>(x)),
+                      V::template Shr<3>(x));
+    }
+    static inline T sigma1(T x) {
+        return V::Xor(V::Xor(V::template Rotr<17>(x), V::template Rotr<19>(x)),
+                      V::template Shr<10>(x));
+    }
+
+    /// One round; kw is the round constant plus the message word
+    static inline void Round(T a, T b, T c, T& d, T e, T f, T g, T& h, T kw) {
+        T t1 = V::Add(V::Add(h, Sigma1(e)), V::Add(Ch(e, f, g), kw));
+        T t2 = V::Add(Sigma0(a), Maj(a, b, c));
+        d = V::Add(d, t1);
+        h = V::Add(t1, t2);
+    }
+
+    /// Eight rounds starting at i, rotating the working variables
+    template <typename KW>
+    static inline void Rounds8(T s[8], int i, KW&& kw) {
+        Round(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], kw(i));
+        Round(s[7], s[0], s[1], s[2], s[3], s[4], s[5], s[6], kw(i + 1));
+        Round(s[6], s[7], s[0], s[1], s[2], s[3], s[4], s[5], kw(i + 2));
+        Round(s[5], s[6], s[7], s[0], s[1], s[2], s[3], s[4], kw(i + 3));
+        Round(s[4], s[5], s[6], s[7], s[0], s[1], s[2], s[3], kw(i + 4));
+        Round(s[3], s[4], s[5], s[6], s[7], s[0], s[1], s[2], kw(i + 5));
+        Round(s[2], s[3], s[4], s[5], s[6], s[7], s[0], s[1], kw(i + 6));
+        Round(s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[0], kw(i + 7));
+    }
+
+    /// Compress a block whose sixteen words are in w (clobbered)
+    static inline void Compress(T s[8], T w[16]) {
+        for (int i = 0; i < 64; i += 8) {
+            Rounds8(s, i, [&](int j) {
+                if (j >= 16) {
+                    w[j & 15] = V::Add(V::Add(sigma1(w[(j - 2) & 15]), w[(j - 7) & 15]),
+                                       V::Add(sigma0(w[(j - 15) & 15]), w[j & 15]));
+                }
+                return V::Add(w[j & 15], V::Set(K[j]));
+            });
+        }
+    }
+
+    /// out[32*l..] = DoubleSHA256(in[64*l..64*l+64]) for each lane l; out may alias in
+    static void DoubleSHA256_64(Byte* out, const Byte* in) {
+        T w[16];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = V::LoadBE(in + 4 * i, 64);
+        }
+
+        // First hash: the message block, then the constant padding block
+        T s[8];
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Set(INIT[i]);
+        }
+        Compress(s, w);
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Add(s[i], V::Set(INIT[i]));
+        }
+        T mid[8];
+        for (int i = 0; i < 8; ++i) {
+            mid[i] = s[i];
+        }
+        for (int i = 0; i < 64; i += 8) {
+            Rounds8(s, i, [](int j) { return V::Set(PADDING_KW[j]); });
+        }
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Add(s[i], mid[i]);
+        }
+        HashDigest(out, s);
+    }
+
+    /**
+     * out[32*l..] = DoubleSHA256 of an 80-byte message for each lane l. The
+     * messages share their first 76 bytes: mid is the state after the first
+     * 64, tail holds the next 12, and lane l ends in the 4 bytes at
+     * nonces + 4*l. This is a block header with only the nonce varying.
+     */
+    static void DoubleSHA256_80(Byte* out, const uint32_t mid[8], const Byte* tail,
+                                const Byte* nonces) {
+        T w[16];
+        for (int i = 0; i < 3; ++i) {
+            w[i] = V::Set(ReadBE32(tail + 4 * i));
+        }
+        w[3] = V::LoadBE(nonces, 4);
+        w[4] = V::Set(0x80000000);
+        for (int i = 5; i < 15; ++i) {
+            w[i] = V::Set(0);
+        }
+        w[15] = V::Set(640);
+
+        T s[8];
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Set(mid[i]);
+        }
+        Compress(s, w);
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Add(s[i], V::Set(mid[i]));
+        }
+        HashDigest(out, s);
+    }
+
+    /// out[32*l..] = DoubleSHA256(in[80*l..80*l+80]) for each lane l: block
+    /// headers with nothing in common, as in a headers message
+    static void DoubleSHA256_80(Byte* out, const Byte* in) {
+        T w[16];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = V::LoadBE(in + 4 * i, 80);
+        }
+
+        T s[8];
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Set(INIT[i]);
+        }
+        Compress(s, w);
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Add(s[i], V::Set(INIT[i]));
+        }
+
+        // The last 16 bytes and the padding of an 80-byte message
+        T mid[8];
+        for (int i = 0; i < 8; ++i) {
+            mid[i] = s[i];
+        }
+        for (int i = 0; i < 4; ++i) {
+            w[i] = V::LoadBE(in + 64 + 4 * i, 80);
+        }
+        w[4] = V::Set(0x80000000);
+        for (int i = 5; i < 15; ++i) {
+            w[i] = V::Set(0);
+        }
+        w[15] = V::Set(640);
+        Compress(s, w);
+        for (int i = 0; i < 8; ++i) {
+            s[i] = V::Add(s[i], mid[i]);
+        }
+        HashDigest(out, s);
+    }
+
+private:
+    /// Second hash: each lane's 32-byte digest in s padded to one block
+    static inline void HashDigest(Byte* out, T s[8]) {
+        T w[16];
+        for (int i = 0; i < 8; ++i) {
+            w[i] = s[i];
+            s[i] = V::Set(INIT[i]);
+        }
+        w[8] = V::Set(0x80000000);
+        for (int i = 9; i < 15; ++i) {
+            w[i] = V::Set(0);
+        }
+        w[15] = V::Set(256);
+        Compress(s, w);
+
+        for (int i = 0; i < 8; ++i) {
+            V::StoreBE(out + 4 * i, 32, V::Add(s[i], V::Set(INIT[i])));
+        }
+    }
+};
+
+} // namespace sha256_multiway
+} // namespace shurium
+
+#endif // SHURIUM_CRYPTO_SHA256_MULTIWAY_H
@@ -0,0 +1,70 @@
+// SHURIUM - 4-Way Double-SHA256 and Hash160 Using SSE4.1
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Compiled with -msse4.1 and only called after CPUID reports support.
+
+#include "hash160_multiway.h"
+#include "sha256_multiway.h"
+#include <immintrin.h>
+
+namespace shurium {
+
+namespace {
+
+using sha256_multiway::ReadBE32;
+using sha256_multiway::WriteBE32;
+
+struct SSE41 {
+    using T = __m128i;
+    static constexpr size_t LANES = 4;
+
+    static inline T Add(T x, T y) { return _mm_add_epi32(x, y); }
+    static inline T And(T x, T y) { return _mm_and_si128(x, y); }
+    static inline T Or(T x, T y) { return _mm_or_si128(x, y); }
+    static inline T Xor(T x, T y) { return _mm_xor_si128(x, y); }
+    template <int N> static inline T Shr(T x) { return _mm_srli_epi32(x, N); }
+    template <int N> static inline T Rotr(T x) {
+        return _mm_or_si128(_mm_srli_epi32(x, N), _mm_slli_epi32(x, 32 - N));
+    }
+    static inline T Set(uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); }
+
+    static inline T LoadBE(const Byte* p, size_t stride) {
+        return _mm_setr_epi32(static_cast<int>(ReadBE32(p)),
+                              static_cast<int>(ReadBE32(p + stride)),
+                              static_cast<int>(ReadBE32(p + 2 * stride)),
+                              static_cast<int>(ReadBE32(p + 3 * stride)));
+    }
+
+    static inline void StoreBE(Byte* p, size_t stride, T x) {
+        alignas(16) uint32_t lanes[LANES];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), x);
+        for (size_t i = 0; i < LANES; ++i) {
+            WriteBE32(p + i * stride, lanes[i]);
+        }
+    }
+};
+
+} // anonymous namespace
+
+namespace sha256_sse41 {
+
+void DoubleSHA256_64_4way(Byte* out, const Byte* in) {
+    sha256_multiway::Kernel<SSE41>::DoubleSHA256_64(out, in);
+}
+
+void DoubleSHA256_80_4way(Byte* out, const uint32_t* mid, const Byte* tail,
+                          const Byte* nonces) {
+    sha256_multiway::Kernel<SSE41>::DoubleSHA256_80(out, mid, tail, nonces);
+}
+
+void DoubleSHA256_Headers_4way(Byte* out, const Byte* in) {
+    sha256_multiway::Kernel<SSE41>::DoubleSHA256_80(out, in);
+}
+
+void Hash160_33_4way(Byte* out, const Byte* in) {
+    hash160_multiway::Kernel<SSE41>::Hash160_33(out, in);
+}
+
+} // namespace sha256_sse41
+} // namespace shurium
@@ -0,0 +1,127 @@
+// SHURIUM - SipHash Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/crypto/siphash.h"
+#include "shurium/core/random.h"
+
+namespace shurium {
+
+namespace {
+
+inline uint64_t RotL(uint64_t x, int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+inline uint64_t ReadLE64(const Byte* p) {
+    return static_cast<uint64_t>(p[0]) |
+           (static_cast<uint64_t>(p[1]) << 8) |
+           (static_cast<uint64_t>(p[2]) << 16) |
+           (static_cast<uint64_t>(p[3]) << 24) |
+           (static_cast<uint64_t>(p[4]) << 32) |
+           (static_cast<uint64_t>(p[5]) << 40) |
+           (static_cast<uint64_t>(p[6]) << 48) |
+           (static_cast<uint64_t>(p[7]) << 56);
+}
+
+/// SipHash state for C compression and D finalization rounds
+template <int C, int D>
+class SipState {
+public:
+    SipState(uint64_t k0, uint64_t k1)
+        : v0(0x736f6d6570736575ULL ^ k0)
+        , v1(0x646f72616e646f6dULL ^ k1)
+        , v2(0x6c7967656e657261ULL ^ k0)
+        , v3(0x7465646279746573ULL ^ k1) {}
+
+    void Compress(uint64_t m) {
+        v3 ^= m;
+        for (int i = 0; i < C; ++i) {
+            Round();
+        }
+        v0 ^= m;
+    }
+
+    uint64_t Finalize() {
+        v2 ^= 0xFF;
+        for (int i = 0; i < D; ++i) {
+            Round();
+        }
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+private:
+    uint64_t v0, v1, v2, v3;
+
+    void Round() {
+        v0 += v1; v1 = RotL(v1, 13); v1 ^= v0; v0 = RotL(v0, 32);
+        v2 += v3; v3 = RotL(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = RotL(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = RotL(v1, 17); v1 ^= v2; v2 = RotL(v2, 32);
+    }
+};
+
+template <int C, int D>
+uint64_t SipHashGeneric(uint64_t k0, uint64_t k1, const Byte* data, size_t len) {
+    SipState<C, D> state(k0, k1);
+
+    const size_t fullWords = len / 8;
+    for (size_t i = 0; i < fullWords; ++i) {
+        state.Compress(ReadLE64(data + i * 8));
+    }
+
+    // Last word: remaining bytes plus the message length in the top byte
+    uint64_t last = static_cast<uint64_t>(len & 0xFF) << 56;
+    const Byte* tail = data + fullWords * 8;
+    for (size_t i = 0; i < (len & 7); ++i) {
+        last |= static_cast<uint64_t>(tail[i]) << (8 * i);
+    }
+    state.Compress(last);
+
+    return state.Finalize();
+}
+
+} // namespace
+
+uint64_t SipHash24(uint64_t k0, uint64_t k1, const Byte* data, size_t len) {
+    return SipHashGeneric<2, 4>(k0, k1, data, len);
+}
+
+uint64_t SipHash13(uint64_t k0, uint64_t k1, const Byte* data, size_t len) {
+    return SipHashGeneric<1, 3>(k0, k1, data, len);
+}
+
+uint64_t SipHash13Uint256(uint64_t k0, uint64_t k1, const Hash256& hash) {
+    SipState<1, 3> state(k0, k1);
+    const Byte* p = hash.data();
+    state.Compress(ReadLE64(p));
+    state.Compress(ReadLE64(p + 8));
+    state.Compress(ReadLE64(p + 16));
+    state.Compress(ReadLE64(p + 24));
+    state.Compress(static_cast<uint64_t>(32) << 56);
+    return state.Finalize();
+}
+
+uint64_t SipHash13Uint256Extra(uint64_t k0, uint64_t k1,
+                               const Hash256& hash, uint32_t extra) {
+    SipState<1, 3> state(k0, k1);
+    const Byte* p = hash.data();
+    state.Compress(ReadLE64(p));
+    state.Compress(ReadLE64(p + 8));
+    state.Compress(ReadLE64(p + 16));
+    state.Compress(ReadLE64(p + 24));
+    state.Compress((static_cast<uint64_t>(36) << 56) | extra);
+    return state.Finalize();
+}
+
+const SipHashKey& GetHashTableSalt() {
+    static const SipHashKey key = [] {
+        SipHashKey k;
+        k.k0 = GetRandUint64();
+        k.k1 = GetRandUint64();
+        return k;
+    }();
+    return key;
+}
+
+} // namespace shurium
@@ -3,8 +3,13 @@
 // MIT License
 
 #include "shurium/db/blockdb.h"
+#include "shurium/util/threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <sstream>
 #include <cstdio>
+#include <cstring>
 #include <iomanip>
 
 namespace shurium {
@@ -40,12 +45,7 @@ std::string DiskBlockPos::ToString() const {
 // ============================================================================
 
 BlockIndexDB::BlockIndexDB(const BlockIndex& index) {
-    header.nVersion = index.nVersion;
-    header.hashPrevBlock = index.pprev ? index.pprev->GetBlockHash() : BlockHash();
-    header.hashMerkleRoot = index.hashMerkleRoot;
-    header.nTime = index.nTime;
-    header.nBits = index.nBits;
-    header.nNonce = index.nNonce;
+    header = index.GetBlockHeader();
     
     nHeight = index.nHeight;
     nStatus = static_cast<uint32_t>(index.nStatus);
@@ -60,12 +60,8 @@ BlockIndexDB::BlockIndexDB(const BlockIndex& index) {
 }
 
 void BlockIndexDB::ToBlockIndex(BlockIndex& index) const {
-    index.nVersion = header.nVersion;
     // Note: pprev needs to be set by caller after loading all entries
-    index.hashMerkleRoot = header.hashMerkleRoot;
-    index.nTime = header.nTime;
-    index.nBits = header.nBits;
-    index.nNonce = header.nNonce;
+    index.SetHeader(header);
     
     index.nHeight = nHeight;
     index.nStatus = static_cast<BlockStatus>(nStatus);
@@ -98,6 +94,7 @@ BlockDB::BlockDB(const std::filesystem::path& dataDir, const Options& options)
         throw std::runtime_error("Failed to open block database: " + status.ToString());
     }
     db_ = std::move(database);
+    ring_ = util::IoRing::Create();
     
     // Create blocks directory if needed
     std::filesystem::create_directories(dataDir_ / "blocks", ec);
@@ -116,6 +113,11 @@ BlockDB::BlockDB(const std::filesystem::path& dataDir, const Options& options)
             blockFileInfo_[i] = info;
         }
     }
+    
+    // A node that ever pruned stays pruned, even with -prune off now
+    std::string value;
+    havePruned_ = db_->Get(ReadOptions(), Slice(MakeKey(prefix::FLAG, Slice("prunedblockfiles"))),
+                           &value).ok() && value == "1";
 }
 
 BlockDB::~BlockDB() {
@@ -138,53 +140,208 @@ std::filesystem::path BlockDB::GetUndoFilePath(int nFile) const {
     return dataDir_ / "blocks" / ss.str();
 }
 
-FILE* BlockDB::OpenBlockFile(int nFile, bool fReadOnly) const {
-    std::lock_guard<std::mutex> lock(fileMutex_);
+// ============================================================================
+// Append Files
+// ============================================================================
+
+namespace {
+
+/// Positioned reads and writes of a block or undo file: through the ring
+/// when the database has one, else seek and read or write
+struct FileIO {
+    util::IoRing* ring{nullptr};
+    std::mutex* ringMutex{nullptr};
+    
+    bool Read(std::FILE* file, uint64_t nPos, void* out, size_t len) const {
+        if (ring) {
+            std::lock_guard<std::mutex> lock(*ringMutex);
+            return ring->ReadAt(fileno(file), out, len, nPos) == static_cast<int64_t>(len);
+        }
+        return std::fseek(file, static_cast<long>(nPos), SEEK_SET) == 0 &&
+               std::fread(out, 1, len, file) == len;
+    }
     
-    // Check cache first
-    auto it = fileCache_.find(nFile);
-    if (it != fileCache_.end() && it->second != nullptr) {
-        // Flush and return cached file (even for reads - ensures data is written)
-        std::fflush(it->second);
-        return it->second;
+    bool Write(std::FILE* file, uint64_t nPos, const void* data, size_t len) const {
+        if (ring) {
+            std::lock_guard<std::mutex> lock(*ringMutex);
+            return ring->WriteAt(fileno(file), data, len, nPos) == static_cast<int64_t>(len);
+        }
+        return std::fseek(file, static_cast<long>(nPos), SEEK_SET) == 0 &&
+               std::fwrite(data, 1, len, file) == len;
+    }
+};
+
+} // namespace
+
+/**
+ * The block or undo file being appended to.
+ *
+ * Appends collect in memory and are written out in one call once
+ * FILE_WRITE_BUFFER_SIZE accumulates or on Flush(); only Flush(true)
+ * fsyncs. Reads of the unwritten tail are served from the buffer. The
+ * stream is unbuffered since this class does the buffering.
+ */
+class BlockDB::AppendFile {
+public:
+    AppendFile(std::FILE* file, uint64_t nEnd, uint64_t nAllocated, FileIO io)
+        : file_(file), io_(io), written_(nEnd), allocated_(std::max(nAllocated, nEnd)) {}
+    
+    ~AppendFile() {
+        Flush(false);
+        std::fclose(file_);
+    }
+    
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+    
+    static std::unique_ptr<AppendFile> Open(const std::filesystem::path& path, uint64_t nEnd,
+                                            FileIO io) {
+        std::FILE* file = std::fopen(path.c_str(), "rb+");
+        if (!file) {
+            file = std::fopen(path.c_str(), "wb+");
+        }
+        if (!file) {
+            return nullptr;
+        }
+        std::setvbuf(file, nullptr, _IONBF, 0);
+        std::error_code ec;
+        uint64_t nAllocated = std::filesystem::file_size(path, ec);
+        return std::make_unique<AppendFile>(file, nEnd, ec ? 0 : nAllocated, io);
     }
     
-    std::filesystem::path path = GetBlockFilePath(nFile);
-    const char* mode = fReadOnly ? "rb" : "rb+";
+    /// Offset just past the data appended so far
+    uint64_t End() const { return written_ + pending_.size(); }
+    
+    /// Preallocate whole chunks so the file covers [0, nEnd)
+    void Reserve(uint64_t nEnd, uint64_t nChunkSize) {
+        if (nEnd <= allocated_) {
+            return;
+        }
+        uint64_t nTarget = (nEnd + nChunkSize - 1) / nChunkSize * nChunkSize;
+        util::fs::AllocateFileRange(file_, allocated_, nTarget - allocated_);
+        allocated_ = nTarget;
+    }
     
-    FILE* file = std::fopen(path.c_str(), mode);
-    if (!file && !fReadOnly) {
-        // Try creating the file
-        file = std::fopen(path.c_str(), "wb+");
+    bool Append(uint64_t nPos, const void* data, size_t len) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        if (nPos != End()) {
+            // Not at the end (a rewrite after a failed write): write through
+            if (!Flush(false) || !WriteAt(nPos, bytes, len)) {
+                return false;
+            }
+            written_ = std::max<uint64_t>(written_, nPos + len);
+            return true;
+        }
+        pending_.insert(pending_.end(), bytes, bytes + len);
+        return pending_.size() < FILE_WRITE_BUFFER_SIZE || Flush(false);
     }
     
-    if (file && !fReadOnly) {
-        fileCache_[nFile] = file;
+    bool Read(uint64_t nPos, void* out, size_t len) {
+        if (nPos >= written_) {
+            if (nPos - written_ + len > pending_.size()) {
+                return false;
+            }
+            std::memcpy(out, pending_.data() + (nPos - written_), len);
+            return true;
+        }
+        if (nPos + len > written_ && !Flush(false)) {
+            return false;
+        }
+        return io_.Read(file_, nPos, out, len);
     }
     
-    return file;
+    /// Write the buffer out, and with fSync force the file to disk
+    bool Flush(bool fSync) {
+        if (!pending_.empty()) {
+            if (!WriteAt(written_, pending_.data(), pending_.size())) {
+                return false;
+            }
+            written_ += pending_.size();
+            pending_.clear();
+        }
+        return !fSync || util::fs::FileCommit(file_);
+    }
+    
+private:
+    bool WriteAt(uint64_t nPos, const uint8_t* data, size_t len) {
+        return io_.Write(file_, nPos, data, len);
+    }
+    
+    std::FILE* file_;
+    FileIO io_;
+    uint64_t written_;              // File bytes holding appended data
+    uint64_t allocated_;            // Size of the file on disk
+    std::vector<uint8_t> pending_;  // Appended after written_
+};
+
+BlockDB::AppendFile* BlockDB::GetAppendFile(std::map<int, std::unique_ptr<AppendFile>>& files,
+                                            const std::filesystem::path& path, int nFile,
+                                            uint64_t nEnd) {
+    auto it = files.find(nFile);
+    if (it != files.end()) {
+        return it->second.get();
+    }
+    auto file = AppendFile::Open(path, nEnd, FileIO{ring_.get(), &ringMutex_});
+    if (!file) {
+        return nullptr;
+    }
+    return files.emplace(nFile, std::move(file)).first->second.get();
+}
+
+void BlockDB::CloseBlockFile(int nFile) {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    auto finish = [nFile](std::map<int, std::unique_ptr<AppendFile>>& files,
+                          const std::filesystem::path& path) {
+        auto it = files.find(nFile);
+        if (it == files.end()) {
+            return;
+        }
+        uint64_t nEnd = it->second->End();
+        it->second->Flush(true);
+        files.erase(it);
+        // Give back the preallocated tail
+        util::fs::ResizeFile(util::fs::Path(path.string()), nEnd);
+    };
+    finish(blockFiles_, GetBlockFilePath(nFile));
+    finish(undoFiles_, GetUndoFilePath(nFile));
 }
 
-FILE* BlockDB::OpenUndoFile(int nFile, bool fReadOnly) const {
-    std::filesystem::path path = GetUndoFilePath(nFile);
-    const char* mode = fReadOnly ? "rb" : "rb+";
+std::shared_ptr<const util::fs::MappedFile> BlockDB::GetMappedBlockFile(int nFile) const {
+    // The last file still grows, and its tail may sit in the write buffer
+    if (nFile < 0 || nFile >= nLastBlockFile_.load()) {
+        return nullptr;
+    }
     
-    FILE* file = std::fopen(path.c_str(), mode);
-    if (!file && !fReadOnly) {
-        file = std::fopen(path.c_str(), "wb+");
+    {
+        std::shared_lock<std::shared_mutex> lock(mappedFilesMutex_);
+        auto it = mappedFiles_.find(nFile);
+        if (it != mappedFiles_.end()) {
+            return it->second;
+        }
     }
     
-    return file;
+    std::unique_lock<std::shared_mutex> lock(mappedFilesMutex_);
+    auto it = mappedFiles_.find(nFile);
+    if (it != mappedFiles_.end()) {
+        return it->second;
+    }
+    
+    auto mapped = std::make_shared<util::fs::MappedFile>(GetBlockFilePath(nFile).string());
+    if (!mapped->IsOpen()) {
+        return nullptr;
+    }
+    mappedFiles_.emplace(nFile, mapped);
+    return mapped;
 }
 
 void BlockDB::CloseAllFiles() {
     std::lock_guard<std::mutex> lock(fileMutex_);
-    for (auto& [nFile, file] : fileCache_) {
-        if (file) {
-            std::fclose(file);
+    for (auto* files : {&blockFiles_, &undoFiles_}) {
+        for (auto& [nFile, file] : *files) {
+            file->Flush(true);
         }
+        files->clear();
     }
-    fileCache_.clear();
 }
 
 // ============================================================================
@@ -196,8 +353,10 @@ bool BlockDB::AllocateBlockFile(uint32_t nAddSize, DiskBlockPos& pos) {
     if (nLastBlockFile_ >= 0 && 
         static_cast<int>(blockFileInfo_.size()) > nLastBlockFile_) {
         uint64_t currentSize = blockFileInfo_[nLastBlockFile_].nSize;
-        if (currentSize + nAddSize > MAX_BLOCKFILE_SIZE) {
-            // Need new file
+        if (currentSize > 0 && currentSize + nAddSize > maxBlockFileSize_) {
+            // Need new file; the finished one is written out in full before
+            // readers may map it
+            CloseBlockFile(nLastBlockFile_);
             ++nLastBlockFile_;
             if (static_cast<int>(blockFileInfo_.size()) <= nLastBlockFile_) {
                 blockFileInfo_.resize(nLastBlockFile_ + 1);
@@ -212,6 +371,14 @@ bool BlockDB::AllocateBlockFile(uint32_t nAddSize, DiskBlockPos& pos) {
     
     pos.nFile = nLastBlockFile_;
     pos.nPos = blockFileInfo_[nLastBlockFile_].nSize;
+    
+    // Grow the file a chunk at a time rather than a block at a time
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    AppendFile* file = GetAppendFile(blockFiles_, GetBlockFilePath(pos.nFile), pos.nFile, pos.nPos);
+    if (!file) {
+        return false;
+    }
+    file->Reserve(uint64_t{pos.nPos} + nAddSize, BLOCKFILE_CHUNK_SIZE);
     blockFileInfo_[nLastBlockFile_].nSize += nAddSize;
     
     return true;
@@ -225,6 +392,13 @@ bool BlockDB::AllocateUndoFile(uint32_t nAddSize, DiskBlockPos& pos) {
     
     pos.nFile = nLastBlockFile_;
     pos.nPos = blockFileInfo_[nLastBlockFile_].nUndoSize;
+    
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    AppendFile* file = GetAppendFile(undoFiles_, GetUndoFilePath(pos.nFile), pos.nFile, pos.nPos);
+    if (!file) {
+        return false;
+    }
+    file->Reserve(uint64_t{pos.nPos} + nAddSize, UNDOFILE_CHUNK_SIZE);
     blockFileInfo_[nLastBlockFile_].nUndoSize += nAddSize;
     
     return true;
@@ -234,7 +408,7 @@ bool BlockDB::AllocateUndoFile(uint32_t nAddSize, DiskBlockPos& pos) {
 // Block Data Operations
 // ============================================================================
 
-Status BlockDB::WriteBlock(const Block& block, DiskBlockPos& pos) {
+Status BlockDB::WriteBlock(const Block& block, DiskBlockPos& pos, int nHeight) {
     // Serialize the block
     DataStream ss;
     Serialize(ss, block);
@@ -244,139 +418,208 @@ Status BlockDB::WriteBlock(const Block& block, DiskBlockPos& pos) {
         return Status::IOError("Failed to allocate block file space");
     }
     
-    // Open file
-    FILE* file = OpenBlockFile(pos.nFile, false);
-    if (!file) {
-        return Status::IOError("Failed to open block file");
-    }
-    
-    // Seek to position
-    if (std::fseek(file, pos.nPos, SEEK_SET) != 0) {
-        return Status::IOError("Failed to seek in block file");
-    }
-    
-    // Write magic and size prefix (network message format)
-    uint32_t nMagic = 0xD9B4BEF9;  // Mainnet magic (could be configurable)
+    // Magic and size prefix (network message format), then the block
+    uint8_t header[BLOCK_RECORD_HEADER_SIZE];
+    uint32_t nMagic = BLOCK_RECORD_MAGIC;
     uint32_t nSize = ss.size();
+    std::memcpy(header, &nMagic, 4);
+    std::memcpy(header + 4, &nSize, 4);
     
-    if (std::fwrite(&nMagic, 1, 4, file) != 4 ||
-        std::fwrite(&nSize, 1, 4, file) != 4 ||
-        std::fwrite(ss.data(), 1, ss.size(), file) != ss.size()) {
-        return Status::IOError("Failed to write block to file");
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        auto it = blockFiles_.find(pos.nFile);
+        if (it == blockFiles_.end() ||
+            !it->second->Append(pos.nPos, header, sizeof(header)) ||
+            !it->second->Append(pos.nPos + sizeof(header), ss.data(), ss.size())) {
+            return Status::IOError("Failed to write block to file");
+        }
     }
     
     // Update file info
-    int height = 0;  // Would be set by caller
-    uint64_t time = block.nTime;
-    blockFileInfo_[pos.nFile].AddBlock(height, time);
+    blockFileInfo_[pos.nFile].AddBlock(nHeight, block.nTime);
     WriteBlockFileInfo(pos.nFile, blockFileInfo_[pos.nFile]);
     
     return Status::Ok();
 }
 
-Status BlockDB::ReadBlock(const DiskBlockPos& pos, Block& block) const {
-    if (pos.IsNull()) {
-        return Status::InvalidArgument("Invalid block position");
-    }
-    
-    // Try to use cached file first (don't close it)
-    FILE* file = nullptr;
-    bool fromCache = false;
-    {
-        std::lock_guard<std::mutex> lock(fileMutex_);
-        auto it = fileCache_.find(pos.nFile);
-        if (it != fileCache_.end() && it->second != nullptr) {
-            std::fflush(it->second);
-            file = it->second;
-            fromCache = true;
-        }
-    }
-    
-    // If not in cache, open a new file
-    if (!file) {
-        std::filesystem::path path = GetBlockFilePath(pos.nFile);
-        file = std::fopen(path.c_str(), "rb");
-        if (!file) {
-            return Status::IOError("Failed to open block file");
-        }
+void BlockDB::AddKnownBlock(const DiskBlockPos& pos, int nHeight, uint64_t nTime) {
+    if (pos.nFile < 0 || pos.nFile >= static_cast<int>(blockFileInfo_.size())) {
+        return;
     }
+    blockFileInfo_[pos.nFile].AddBlock(nHeight, nTime);
+    WriteBlockFileInfo(pos.nFile, blockFileInfo_[pos.nFile]);
+}
+
+namespace {
+
+/// Reader over a whole file: read(pos, out, len) for ReadBlockRecord
+struct FileReader {
+    std::FILE* file;
+    FileIO io;
     
-    // Seek to position
-    if (std::fseek(file, pos.nPos, SEEK_SET) != 0) {
-        if (!fromCache) std::fclose(file);
-        return Status::IOError("Failed to seek in block file");
+    bool operator()(uint64_t nPos, void* out, size_t len) const {
+        return io.Read(file, nPos, out, len);
     }
-    
+};
+
+/// Read the magic/size-prefixed block record at nPos
+template<typename Reader>
+Status ReadBlockRecord(Reader&& read, uint32_t nPos, std::vector<uint8_t>& data) {
     // Read magic and size
-    uint32_t nMagic = 0;
-    uint32_t nSize = 0;
-    
-    if (std::fread(&nMagic, 1, 4, file) != 4 ||
-        std::fread(&nSize, 1, 4, file) != 4) {
-        if (!fromCache) std::fclose(file);
+    uint8_t header[BLOCK_RECORD_HEADER_SIZE];
+    if (!read(nPos, header, sizeof(header))) {
         return Status::IOError("Failed to read block header");
     }
+    uint32_t nSize = 0;
+    std::memcpy(&nSize, header + 4, 4);
     
     // Validate size
-    if (nSize == 0 || nSize > 32 * 1024 * 1024) {  // Max 32MB
-        if (!fromCache) std::fclose(file);
+    if (nSize == 0 || nSize > MAX_BLOCK_RECORD_SIZE) {
         return Status::Corruption("Invalid block size");
     }
     
-    // Read block data
-    std::vector<uint8_t> data(nSize);
-    if (std::fread(data.data(), 1, nSize, file) != nSize) {
-        if (!fromCache) std::fclose(file);
+    data.resize(nSize);
+    if (!read(uint64_t{nPos} + sizeof(header), data.data(), nSize)) {
         return Status::IOError("Failed to read block data");
     }
-    
-    // Only close if we opened a new file (not from cache)
-    if (!fromCache) {
-        std::fclose(file);
+    return Status::Ok();
+}
+
+/// Read the size-prefixed undo record at nPos
+template<typename Reader>
+Status ReadUndoRecord(Reader&& read, uint32_t nPos, std::vector<uint8_t>& data) {
+    uint32_t nSize = 0;
+    if (!read(nPos, &nSize, 4)) {
+        return Status::IOError("Failed to read undo header");
     }
-    
-    // Deserialize
+    if (nSize == 0 || nSize > MAX_BLOCK_RECORD_SIZE) {
+        return Status::Corruption("Invalid undo size");
+    }
+    data.resize(nSize);
+    if (!read(uint64_t{nPos} + 4, data.data(), nSize)) {
+        return Status::IOError("Failed to read undo data");
+    }
+    return Status::Ok();
+}
+
+template<typename Stream>
+Status DeserializeBlock(Stream& ss, Block& block) {
     try {
-        DataStream ss(std::move(data));
-        Unserialize(ss, block);
+        UnserializeWithArena(ss, block);
     } catch (const std::exception& e) {
         return Status::Corruption(std::string("Failed to deserialize block: ") + e.what());
     }
-    
     return Status::Ok();
 }
 
+} // namespace
+
+Status BlockDB::ReadBlock(const DiskBlockPos& pos, Block& block) const {
+    if (pos.IsNull()) {
+        return Status::InvalidArgument("Invalid block position");
+    }
+    
+    // Finished files: deserialize from the mapping without copying
+    if (auto mapped = GetMappedBlockFile(pos.nFile)) {
+        const uint64_t offset = pos.nPos;
+        if (offset + 8 > mapped->Size()) {
+            return Status::IOError("Failed to read block header");
+        }
+        uint32_t nSize = 0;
+        std::memcpy(&nSize, mapped->Data() + offset + 4, 4);
+        if (nSize == 0 || nSize > MAX_BLOCK_RECORD_SIZE) {
+            return Status::Corruption("Invalid block size");
+        }
+        if (offset + 8 + nSize > mapped->Size()) {
+            return Status::IOError("Failed to read block data");
+        }
+        
+        ++nMappedReads_;
+        SpanReader ss(mapped->Data() + offset + 8, nSize);
+        return DeserializeBlock(ss, block);
+    }
+    
+    std::vector<uint8_t> data;
+    Status s = ReadRawBlock(pos, data);
+    if (!s.ok()) {
+        return s;
+    }
+    DataStream ss(std::move(data));
+    return DeserializeBlock(ss, block);
+}
+
+Status BlockDB::ReadRawBlock(const DiskBlockPos& pos, std::vector<uint8_t>& data) const {
+    if (pos.IsNull()) {
+        return Status::InvalidArgument("Invalid block position");
+    }
+    
+    // Finished files: one copy out of the mapping
+    if (auto mapped = GetMappedBlockFile(pos.nFile)) {
+        const uint64_t offset = pos.nPos;
+        if (offset + 8 > mapped->Size()) {
+            return Status::IOError("Failed to read block header");
+        }
+        uint32_t nSize = 0;
+        std::memcpy(&nSize, mapped->Data() + offset + 4, 4);
+        if (nSize == 0 || nSize > MAX_BLOCK_RECORD_SIZE) {
+            return Status::Corruption("Invalid block size");
+        }
+        if (offset + 8 + nSize > mapped->Size()) {
+            return Status::IOError("Failed to read block data");
+        }
+        
+        ++nMappedReads_;
+        const uint8_t* begin = mapped->Data() + offset + 8;
+        data.assign(begin, begin + nSize);
+        return Status::Ok();
+    }
+    
+    // The file being appended to: its tail may only be in the write
+    // buffer, which the writer shares, so read under the lock
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        auto it = blockFiles_.find(pos.nFile);
+        if (it != blockFiles_.end()) {
+            AppendFile* file = it->second.get();
+            return ReadBlockRecord([file](uint64_t nPos, void* out, size_t len) {
+                return file->Read(nPos, out, len);
+            }, pos.nPos, data);
+        }
+    }
+    
+    std::filesystem::path path = GetBlockFilePath(pos.nFile);
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return Status::IOError("Failed to open block file");
+    }
+    Status s = ReadBlockRecord(FileReader{file, FileIO{ring_.get(), &ringMutex_}}, pos.nPos, data);
+    std::fclose(file);
+    return s;
+}
+
 Status BlockDB::WriteUndo(const BlockUndo& undo, DiskBlockPos& pos) {
     // Serialize
     DataStream ss;
-    Serialize(ss, undo);
+    Serialize(ss, UNDO_VERSION_MARKER);
+    Serialize(ss, UNDO_VERSION_COMPRESSED);
+    SerializeCompressedUndo(ss, undo);
     
     // Allocate space
     if (!AllocateUndoFile(ss.size() + 4, pos)) {
         return Status::IOError("Failed to allocate undo file space");
     }
     
-    // Open file
-    FILE* file = OpenUndoFile(pos.nFile, false);
-    if (!file) {
-        return Status::IOError("Failed to open undo file");
-    }
-    
-    // Seek and write
-    if (std::fseek(file, pos.nPos, SEEK_SET) != 0) {
-        std::fclose(file);
-        return Status::IOError("Failed to seek in undo file");
-    }
-    
     uint32_t nSize = ss.size();
-    if (std::fwrite(&nSize, 1, 4, file) != 4 ||
-        std::fwrite(ss.data(), 1, ss.size(), file) != ss.size()) {
-        std::fclose(file);
-        return Status::IOError("Failed to write undo data");
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        auto it = undoFiles_.find(pos.nFile);
+        if (it == undoFiles_.end() ||
+            !it->second->Append(pos.nPos, &nSize, 4) ||
+            !it->second->Append(pos.nPos + 4, ss.data(), ss.size())) {
+            return Status::IOError("Failed to write undo data");
+        }
     }
     
-    std::fclose(file);
-    
     // Update file info
     WriteBlockFileInfo(pos.nFile, blockFileInfo_[pos.nFile]);
     
@@ -388,38 +631,49 @@ Status BlockDB::ReadUndo(const DiskBlockPos& pos, BlockUndo& undo) const {
         return Status::InvalidArgument("Invalid undo position");
     }
     
-    FILE* file = OpenUndoFile(pos.nFile, true);
-    if (!file) {
-        return Status::IOError("Failed to open undo file");
-    }
-    
-    if (std::fseek(file, pos.nPos, SEEK_SET) != 0) {
-        std::fclose(file);
-        return Status::IOError("Failed to seek in undo file");
-    }
-    
-    uint32_t nSize = 0;
-    if (std::fread(&nSize, 1, 4, file) != 4) {
-        std::fclose(file);
-        return Status::IOError("Failed to read undo header");
-    }
-    
-    if (nSize == 0 || nSize > 32 * 1024 * 1024) {
-        std::fclose(file);
-        return Status::Corruption("Invalid undo size");
+    std::vector<uint8_t> data;
+    bool fromAppendFile = false;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        auto it = undoFiles_.find(pos.nFile);
+        if (it != undoFiles_.end()) {
+            AppendFile* file = it->second.get();
+            Status s = ReadUndoRecord([file](uint64_t nPos, void* out, size_t len) {
+                return file->Read(nPos, out, len);
+            }, pos.nPos, data);
+            if (!s.ok()) {
+                return s;
+            }
+            fromAppendFile = true;
+        }
     }
     
-    std::vector<uint8_t> data(nSize);
-    if (std::fread(data.data(), 1, nSize, file) != nSize) {
+    if (!fromAppendFile) {
+        FILE* file = std::fopen(GetUndoFilePath(pos.nFile).c_str(), "rb");
+        if (!file) {
+            return Status::IOError("Failed to open undo file");
+        }
+        Status s = ReadUndoRecord(FileReader{file, FileIO{ring_.get(), &ringMutex_}}, pos.nPos,
+                                  data);
         std::fclose(file);
-        return Status::IOError("Failed to read undo data");
+        if (!s.ok()) {
+            return s;
+        }
     }
     
-    std::fclose(file);
-    
     try {
         DataStream ss(std::move(data));
-        Unserialize(ss, undo);
+        if (ss.data()[0] != UNDO_VERSION_MARKER) {
+            Unserialize(ss, undo);
+        } else {
+            uint8_t marker = 0, version = 0;
+            Unserialize(ss, marker);
+            Unserialize(ss, version);
+            if (version != UNDO_VERSION_COMPRESSED) {
+                return Status::Corruption("Unknown undo version " + std::to_string(version));
+            }
+            UnserializeCompressedUndo(ss, undo);
+        }
     } catch (const std::exception& e) {
         return Status::Corruption(std::string("Failed to deserialize undo: ") + e.what());
     }
@@ -457,63 +711,153 @@ bool BlockDB::HaveBlockIndex(const BlockHash& hash) const {
     return db_->Exists(Slice(key));
 }
 
-int BlockDB::LoadBlockIndexMap(BlockMap& blockIndex) {
-    int count = 0;
-    
-    // First pass: Load all block index entries and track parent hashes
-    std::map<BlockHash, BlockHash> parentHashes;  // block hash -> prev block hash
-    
-    auto iter = db_->NewIterator();
-    std::string prefix(1, prefix::BLOCK_INDEX);
-    iter->Seek(Slice(prefix));
-    
-    while (iter->Valid()) {
+namespace {
+
+using BlockIndexRecord = std::pair<BlockHash, BlockIndexDB>;
+
+int64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+/// Read the block index records whose first hash byte is in [lo, hi)
+bool ScanBlockIndexShard(Database& db, const ReadOptions& options, int lo, int hi,
+                         std::vector<BlockIndexRecord>& records) {
+    auto iter = db.NewIterator(options);
+    std::string start(1, prefix::BLOCK_INDEX);
+    start.push_back(static_cast<char>(lo));
+    iter->Seek(Slice(start));
+    
+    for (; iter->Valid(); iter->Next()) {
         Slice key = iter->key();
-        if (key.size() < 1 || key[0] != prefix::BLOCK_INDEX) {
+        if (key.size() < 2 || key[0] != prefix::BLOCK_INDEX ||
+            static_cast<uint8_t>(key[1]) >= hi) {
             break;
         }
         
         // Extract hash from key
         if (key.size() != 1 + 32) {  // prefix + hash size
-            iter->Next();
             continue;
         }
         
-        BlockHash hash;
-        std::memcpy(hash.data(), key.data() + 1, 32);
-        
-        // Deserialize entry
-        BlockIndexDB entry;
-        if (!DeserializeFromString(iter->value().ToString(), entry)) {
-            iter->Next();
+        BlockIndexRecord record;
+        std::memcpy(record.first.data(), key.data() + 1, 32);
+        if (!DeserializeFromString(iter->value().ToString(), record.second)) {
             continue;
         }
+        records.push_back(std::move(record));
+    }
+    return iter->status().ok();
+}
+
+} // namespace
+
+int BlockDB::LoadBlockIndexMap(BlockMap& blockIndex, int nThreads, BlockIndexLoadStats* stats) {
+    BlockIndexLoadStats localStats;
+    BlockIndexLoadStats& load = stats ? *stats : localStats;
+    load = BlockIndexLoadStats();
+    load.nThreads = std::max(nThreads, 1);
+    
+    // First phase: scan the key space in shards, all from the same snapshot
+    auto phaseStart = std::chrono::steady_clock::now();
+    auto snapshot = db_->NewSnapshot();
+    ReadOptions options = snapshot->GetReadOptions();
+    
+    int nShards = load.nThreads == 1 ? 1 :
+        std::min(load.nThreads * BLOCK_INDEX_LOAD_SHARDS_PER_THREAD, 256);
+    std::vector<std::vector<BlockIndexRecord>> shards(nShards);
+    auto scan = [&](int i) {
+        return ScanBlockIndexShard(*db_, options, 256 * i / nShards, 256 * (i + 1) / nShards,
+                                   shards[i]);
+    };
+    
+    bool ok = true;
+    if (nShards == 1) {
+        ok = scan(0);
+    } else {
+        util::ThreadPool::Config config;
+        config.numThreads = static_cast<size_t>(load.nThreads);
+        config.name = "loadblkidx";
+        util::ThreadPool pool(config);
         
-        // Store the parent hash for later linking
-        if (!entry.header.hashPrevBlock.IsNull()) {
-            parentHashes[hash] = entry.header.hashPrevBlock;
+        std::vector<std::future<bool>> results;
+        results.reserve(nShards);
+        for (int i = 0; i < nShards; ++i) {
+            results.push_back(pool.Submit(scan, i));
         }
-        
-        // Create BlockIndex and add to map
-        auto pindex = std::make_unique<BlockIndex>();
-        entry.ToBlockIndex(*pindex);
-        auto result = blockIndex.emplace(hash, std::move(pindex));
-        result.first->second->phashBlock = &result.first->first;
-        
-        ++count;
-        iter->Next();
+        for (auto& result : results) {
+            ok = result.get() && ok;
+        }
+    }
+    if (!ok) {
+        return -1;
+    }
+    for (const auto& shard : shards) {
+        load.nEntries += shard.size();
+    }
+    load.readMicros = MicrosSince(phaseStart);
+    
+    // Second phase: order by height. Heights in a connected index are dense,
+    // so a counting sort puts every parent before its children in linear
+    // time; anything else falls back to a comparison sort.
+    phaseStart = std::chrono::steady_clock::now();
+    std::vector<const BlockIndexRecord*> ordered;
+    ordered.reserve(load.nEntries);
+    int32_t maxHeight = -1;
+    for (const auto& shard : shards) {
+        for (const auto& record : shard) {
+            ordered.push_back(&record);
+            maxHeight = std::max(maxHeight, record.second.nHeight);
+        }
+    }
+    auto height = [](const BlockIndexRecord* record) {
+        return std::max(record->second.nHeight, 0);
+    };
+    if (maxHeight < static_cast<int64_t>(load.nEntries)) {
+        std::vector<size_t> offsets(static_cast<size_t>(maxHeight) + 2, 0);
+        for (const BlockIndexRecord* record : ordered) {
+            ++offsets[height(record) + 1];
+        }
+        for (size_t h = 1; h < offsets.size(); ++h) {
+            offsets[h] += offsets[h - 1];
+        }
+        std::vector<const BlockIndexRecord*> sorted(ordered.size());
+        for (const BlockIndexRecord* record : ordered) {
+            sorted[offsets[height(record)]++] = record;
+        }
+        ordered.swap(sorted);
+    } else {
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [&](const auto* a, const auto* b) { return height(a) < height(b); });
     }
+    load.sortMicros = MicrosSince(phaseStart);
     
-    // Second pass: Wire up parent pointers
-    for (auto& [hash, indexPtr] : blockIndex) {
-        auto it = parentHashes.find(hash);
-        if (it != parentHashes.end()) {
-            auto parentIt = blockIndex.find(it->second);
-            if (parentIt != blockIndex.end()) {
-                indexPtr->pprev = parentIt->second.get();
-            }
+    // Third phase: create the entries and wire up parent pointers. Parents
+    // are already in the map, and allocating in height order lays the arena
+    // out along the chain.
+    phaseStart = std::chrono::steady_clock::now();
+    blockIndex.Reserve(blockIndex.size() + load.nEntries);
+    
+    int count = 0;
+    for (const BlockIndexRecord* record : ordered) {
+        const auto& [hash, entry] = *record;
+        auto [pindex, inserted] = blockIndex.Insert(hash);
+        if (!inserted) {
+            continue;
+        }
+        entry.ToBlockIndex(*pindex);
+        
+        if (!entry.header.hashPrevBlock.IsNull()) {
+            pindex->pprev = blockIndex.Lookup(entry.header.hashPrevBlock);
         }
+        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) +
+                             GetBlockProof(pindex->nBits);
+        pindex->nTimeMax = pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime)
+                                         : pindex->nTime;
+        pindex->BuildSkip();
+        ++count;
     }
+    load.linkMicros = MicrosSince(phaseStart);
     
     return count;
 }
@@ -604,6 +948,100 @@ uint64_t BlockDB::GetBlockDiskUsage() const {
     return total;
 }
 
+int BlockDB::RescanBlockFiles() {
+    CloseAllFiles();
+    {
+        std::unique_lock<std::shared_mutex> lock(mappedFilesMutex_);
+        mappedFiles_.clear();
+    }
+    
+    int nFiles = 0;
+    std::error_code ec;
+    while (std::filesystem::is_regular_file(GetBlockFilePath(nFiles), ec)) {
+        ++nFiles;
+    }
+    
+    blockFileInfo_.resize(std::max(nFiles, 1));
+    for (int i = 0; i < nFiles; ++i) {
+        BlockFileInfo info;
+        uint64_t size = std::filesystem::file_size(GetBlockFilePath(i), ec);
+        info.nSize = ec ? 0 : static_cast<uint32_t>(size);
+        info.nUndoSize = blockFileInfo_[i].nUndoSize;
+        blockFileInfo_[i] = info;
+        WriteBlockFileInfo(i, blockFileInfo_[i]);
+    }
+    
+    nLastBlockFile_ = std::max(nFiles - 1, 0);
+    WriteLastBlockFile(nLastBlockFile_);
+    return nFiles;
+}
+
+// ============================================================================
+// Pruning
+// ============================================================================
+
+uint64_t BlockDB::CalculateCurrentUsage() const {
+    uint64_t total = 0;
+    for (const auto& info : blockFileInfo_) {
+        total += info.nSize + info.nUndoSize;
+    }
+    return total;
+}
+
+std::set<int> BlockDB::FindFilesToPrune(int nTipHeight) const {
+    std::set<int> files;
+    if (!IsPruneMode() || nTipHeight < 0) {
+        return files;
+    }
+    
+    uint64_t usage = CalculateCurrentUsage();
+    if (usage <= pruneTarget_) {
+        return files;
+    }
+    
+    const int nLastPrunable = nTipHeight - MIN_BLOCKS_TO_KEEP;
+    for (int i = 0; i < nLastBlockFile_ && usage > pruneTarget_; ++i) {
+        const BlockFileInfo& info = blockFileInfo_[i];
+        if (info.nSize == 0 && info.nUndoSize == 0) {
+            continue;  // Already pruned
+        }
+        if (info.nHeightLast > nLastPrunable) {
+            continue;
+        }
+        files.insert(i);
+        usage -= info.nSize + info.nUndoSize;
+    }
+    return files;
+}
+
+void BlockDB::UnlinkPrunedFiles(const std::set<int>& files) {
+    if (files.empty()) {
+        return;
+    }
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(mappedFilesMutex_);
+        for (int nFile : files) {
+            mappedFiles_.erase(nFile);
+        }
+    }
+    
+    std::error_code ec;
+    for (int nFile : files) {
+        CloseBlockFile(nFile);
+        std::filesystem::remove(GetBlockFilePath(nFile), ec);
+        std::filesystem::remove(GetUndoFilePath(nFile), ec);
+        blockFileInfo_[nFile] = BlockFileInfo();
+        WriteBlockFileInfo(nFile, blockFileInfo_[nFile]);
+    }
+    
+    if (!havePruned_) {
+        havePruned_ = true;
+        db_->Put(WriteOptions(), Slice(MakeKey(prefix::FLAG, Slice("prunedblockfiles"))),
+                 Slice("1"));
+    }
+}
+
 // ============================================================================
 // Batch Operations
 // ============================================================================
@@ -618,17 +1056,23 @@ Status BlockDB::WriteBatch(db::WriteBatch* batch, bool sync) {
     return db_->Write(opts, batch);
 }
 
-Status BlockDB::Flush() {
-    // Flush file handles
-    {
-        std::lock_guard<std::mutex> lock(fileMutex_);
-        for (auto& [nFile, file] : fileCache_) {
-            if (file) {
-                std::fflush(file);
+Status BlockDB::FlushFiles() {
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    for (auto* files : {&blockFiles_, &undoFiles_}) {
+        for (auto& [nFile, file] : *files) {
+            if (!file->Flush(true)) {
+                return Status::IOError("Failed to flush block file " + std::to_string(nFile));
             }
         }
     }
-    
+    return Status::Ok();
+}
+
+Status BlockDB::Flush() {
+    Status s = FlushFiles();
+    if (!s.ok()) {
+        return s;
+    }
     return db_->Sync();
 }
 
@@ -702,19 +1146,46 @@ Status TxIndex::IndexBlock(const Block& block, const DiskBlockPos& blockPos) {
     }
     
     WriteBatch batch;
-    uint32_t offset = 8;  // Skip magic and size prefix
+    for (const auto& [txid, entry] : GetBlockEntries(block, blockPos)) {
+        std::string key = MakeKey(prefix::TX_INDEX, txid);
+        std::string value = SerializeToString(entry);
+        batch.Put(Slice(key), Slice(value));
+    }
     
+    return db_->Write(WriteOptions(), &batch);
+}
+
+std::vector<std::pair<TxHash, TxIndexEntry>>
+TxIndex::GetBlockEntries(const Block& block, const DiskBlockPos& blockPos) {
+    std::vector<std::pair<TxHash, TxIndexEntry>> entries;
+    entries.reserve(block.vtx.size());
+    
+    // Skip the record header, the block header and the transaction count
+    uint32_t offset = BLOCK_RECORD_HEADER_SIZE +
+                      static_cast<uint32_t>(BLOCK_HEADER_SIZE) +
+                      static_cast<uint32_t>(GetCompactSizeSize(block.vtx.size()));
     for (const auto& tx : block.vtx) {
-        TxIndexEntry entry(blockPos, offset);
-        std::string key = MakeKey(prefix::TX_INDEX, tx->GetHash());
+        entries.emplace_back(tx->GetHash(), TxIndexEntry(blockPos, offset));
+        offset += static_cast<uint32_t>(tx->GetTotalSize());
+    }
+    return entries;
+}
+
+Status TxIndex::WriteEntries(const std::vector<std::pair<TxHash, TxIndexEntry>>& entries,
+                             const BlockLocator& locator) {
+    if (!enabled_ || !db_) {
+        return Status::NotSupported("TxIndex not enabled");
+    }
+    
+    WriteBatch batch;
+    for (const auto& [txid, entry] : entries) {
+        std::string key = MakeKey(prefix::TX_INDEX, txid);
         std::string value = SerializeToString(entry);
         batch.Put(Slice(key), Slice(value));
-        
-        // Estimate transaction size for offset
-        DataStream ss;
-        Serialize(ss, *tx);
-        offset += ss.size();
     }
+    std::string locatorKey = MakeKey(prefix::INDEX_LOCATOR);
+    std::string locatorValue = SerializeToString(locator);
+    batch.Put(Slice(locatorKey), Slice(locatorValue));
     
     return db_->Write(WriteOptions(), &batch);
 }
@@ -753,6 +1224,25 @@ std::optional<BlockHash> TxIndex::GetBestBlock() const {
     return hash;
 }
 
+std::optional<BlockLocator> TxIndex::GetBestLocator() const {
+    if (!db_) {
+        return std::nullopt;
+    }
+    
+    std::string key = MakeKey(prefix::INDEX_LOCATOR);
+    std::string value;
+    if (!db_->Get(ReadOptions(), Slice(key), &value).ok()) {
+        return std::nullopt;
+    }
+    
+    BlockLocator locator;
+    if (!DeserializeFromString(value, locator)) {
+        return std::nullopt;
+    }
+    
+    return locator;
+}
+
 Status TxIndex::SetBestBlock(const BlockHash& hash) {
     if (!db_) {
         return Status::NotSupported("TxIndex not enabled");
@@ -0,0 +1,111 @@
+// SHURIUM - Block Filter Index Database Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/db/blockfilterdb.h"
+
+namespace shurium {
+namespace db {
+
+// ============================================================================
+// BlockFilterIndex Implementation
+// ============================================================================
+
+BlockFilterIndex::BlockFilterIndex(BlockFilterType filterType,
+                                   const std::filesystem::path& dataDir,
+                                   const Options& options)
+    : filterType_(filterType) {
+    std::filesystem::path dbPath =
+        dataDir / "indexes" / "blockfilter" / BlockFilterTypeName(filterType);
+
+    std::error_code ec;
+    std::filesystem::create_directories(dbPath, ec);
+
+    auto [status, database] = OpenDatabase(dbPath, options);
+    if (status.ok()) {
+        db_ = std::move(database);
+        enabled_ = true;
+    }
+}
+
+std::optional<BlockFilterEntry> BlockFilterIndex::GetEntry(const BlockHash& hash) const {
+    if (!enabled_ || !db_) {
+        return std::nullopt;
+    }
+
+    std::string key = MakeKey(prefix::BLOCK_FILTER, hash);
+    std::string value;
+    if (!db_->Get(ReadOptions(), Slice(key), &value).ok()) {
+        return std::nullopt;
+    }
+
+    BlockFilterEntry entry;
+    if (!DeserializeFromString(value, entry)) {
+        return std::nullopt;
+    }
+
+    return entry;
+}
+
+std::optional<BlockFilter> BlockFilterIndex::GetFilter(const BlockHash& hash) const {
+    auto entry = GetEntry(hash);
+    if (!entry) {
+        return std::nullopt;
+    }
+
+    try {
+        return BlockFilter(filterType_, hash, std::move(entry->encoded));
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+std::optional<Hash256> BlockFilterIndex::GetFilterHeader(const BlockHash& hash) const {
+    auto entry = GetEntry(hash);
+    if (!entry) {
+        return std::nullopt;
+    }
+    return entry->header;
+}
+
+Status BlockFilterIndex::WriteEntries(
+    const std::vector<std::pair<BlockHash, BlockFilterEntry>>& entries,
+    const BlockLocator& locator) {
+    if (!enabled_ || !db_) {
+        return Status::NotSupported("BlockFilterIndex not enabled");
+    }
+
+    WriteBatch batch;
+    for (const auto& [hash, entry] : entries) {
+        std::string key = MakeKey(prefix::BLOCK_FILTER, hash);
+        std::string value = SerializeToString(entry);
+        batch.Put(Slice(key), Slice(value));
+    }
+    std::string locatorKey = MakeKey(prefix::INDEX_LOCATOR);
+    std::string locatorValue = SerializeToString(locator);
+    batch.Put(Slice(locatorKey), Slice(locatorValue));
+
+    return db_->Write(WriteOptions(), &batch);
+}
+
+std::optional<BlockLocator> BlockFilterIndex::GetBestLocator() const {
+    if (!db_) {
+        return std::nullopt;
+    }
+
+    std::string key = MakeKey(prefix::INDEX_LOCATOR);
+    std::string value;
+    if (!db_->Get(ReadOptions(), Slice(key), &value).ok()) {
+        return std::nullopt;
+    }
+
+    BlockLocator locator;
+    if (!DeserializeFromString(value, locator)) {
+        return std::nullopt;
+    }
+
+    return locator;
+}
+
+} // namespace db
+} // namespace shurium
@@ -0,0 +1,34 @@
+// SHURIUM - Compressed Coin Encoding Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/db/coincompressor.h"
+#include "shurium/db/database.h"
+
+namespace shurium {
+namespace db {
+
+std::string EncodeCoin(const Coin& coin, uint32_t format) {
+    if (format == COIN_FORMAT_LEGACY) {
+        return SerializeToString(coin);
+    }
+    DataStream ss;
+    SerializeCompressedCoin(ss, coin);
+    return std::string(reinterpret_cast<const char*>(ss.data()), ss.size());
+}
+
+bool DecodeCoin(const std::string& value, Coin& coin, uint32_t format) {
+    if (format == COIN_FORMAT_LEGACY) {
+        return DeserializeFromString(value, coin);
+    }
+    try {
+        SpanReader ss(reinterpret_cast<const uint8_t*>(value.data()), value.size());
+        UnserializeCompressedCoin(ss, coin);
+        return ss.empty();
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace db
+} // namespace shurium
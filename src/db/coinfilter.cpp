@@ -0,0 +1,81 @@
+// SHURIUM - UTXO Key Filter Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/db/coinfilter.h"
+#include "shurium/core/random.h"
+#include "shurium/crypto/siphash.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+namespace shurium {
+namespace db {
+
+// ============================================================================
+// CoinFilter
+// ============================================================================
+
+CoinFilter::CoinFilter(size_t memoryBytes)
+    : m_nWords(std::max<size_t>(memoryBytes / sizeof(uint64_t), 1)),
+      m_bits(new std::atomic<uint64_t>[m_nWords]),
+      m_k0(GetRandUint64()),
+      m_k1(GetRandUint64()) {
+    for (size_t i = 0; i < m_nWords; ++i) {
+        m_bits[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void CoinFilter::Hash(const OutPoint& outpoint, uint64_t& h1, uint64_t& h2) const {
+    h1 = SipHash13Uint256Extra(m_k0, m_k1, outpoint.hash, outpoint.n);
+    // An odd step visits distinct bits even when the bit count is a power of two
+    h2 = SipHash13Uint256Extra(m_k1, m_k0, outpoint.hash, outpoint.n) | 1;
+}
+
+void CoinFilter::Add(const OutPoint& outpoint) {
+    uint64_t h1, h2;
+    Hash(outpoint, h1, h2);
+    const uint64_t nBits = static_cast<uint64_t>(m_nWords) * 64;
+    for (int i = 0; i < COIN_FILTER_HASHES; ++i) {
+        uint64_t bit = (h1 + static_cast<uint64_t>(i) * h2) % nBits;
+        m_bits[bit / 64].fetch_or(uint64_t(1) << (bit % 64), std::memory_order_relaxed);
+    }
+    m_nInserts.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CoinFilter::MightContain(const OutPoint& outpoint) const {
+    uint64_t h1, h2;
+    Hash(outpoint, h1, h2);
+    const uint64_t nBits = static_cast<uint64_t>(m_nWords) * 64;
+    for (int i = 0; i < COIN_FILTER_HASHES; ++i) {
+        uint64_t bit = (h1 + static_cast<uint64_t>(i) * h2) % nBits;
+        if (!(m_bits[bit / 64].load(std::memory_order_relaxed) & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CoinFilter::RecordLookup(bool found) const {
+    if (!found) {
+        m_nFalsePositives.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+double CoinFilter::EstimateFalsePositiveRate() const {
+    uint64_t nSet = 0;
+    for (size_t i = 0; i < m_nWords; ++i) {
+        nSet += std::bitset<64>(m_bits[i].load(std::memory_order_relaxed)).count();
+    }
+    double fill = static_cast<double>(nSet) / (static_cast<double>(m_nWords) * 64);
+    return std::pow(fill, COIN_FILTER_HASHES);
+}
+
+double CoinFilter::GetObservedFalsePositiveRate() const {
+    uint64_t falsePositives = GetFalsePositiveCount();
+    uint64_t negatives = falsePositives + GetFilteredCount();
+    return negatives == 0 ? 0.0 : static_cast<double>(falsePositives) / negatives;
+}
+
+} // namespace db
+} // namespace shurium
@@ -3,12 +3,355 @@
 // MIT License
 
 #include "shurium/db/database.h"
+#include "shurium/db/instrumented.h"
 #include "shurium/db/leveldb.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <sstream>
 
 namespace shurium {
 namespace db {
 
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+void LatencyHistogram::Record(uint64_t micros) {
+    size_t bucket = 0;
+    while (bucket + 1 < DB_LATENCY_BUCKETS && (uint64_t(1) << bucket) <= micros) {
+        ++bucket;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumMicros_.fetch_add(micros, std::memory_order_relaxed);
+    
+    uint64_t prevMax = maxMicros_.load(std::memory_order_relaxed);
+    while (micros > prevMax &&
+           !maxMicros_.compare_exchange_weak(prevMax, micros, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const {
+    Snapshot snapshot;
+    for (size_t i = 0; i < DB_LATENCY_BUCKETS; ++i) {
+        snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count = count_.load(std::memory_order_relaxed);
+    snapshot.sumMicros = sumMicros_.load(std::memory_order_relaxed);
+    snapshot.maxMicros = maxMicros_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sumMicros_.store(0, std::memory_order_relaxed);
+    maxMicros_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::PercentileMicros(double fraction) const {
+    uint64_t total = 0;
+    for (uint64_t n : buckets) {
+        total += n;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    
+    uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < DB_LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen > target || seen == total) {
+            return std::min(uint64_t(1) << i, std::max<uint64_t>(maxMicros, 1));
+        }
+    }
+    return maxMicros;
+}
+
+// ============================================================================
+// Column Families
+// ============================================================================
+
+const char* GetColumnFamilyName(ColumnFamily family) {
+    switch (family) {
+        case ColumnFamily::BLOCK_INDEX: return "blockindex";
+        case ColumnFamily::COINS:       return "coins";
+        case ColumnFamily::TX_INDEX:    return "txindex";
+    }
+    return "unknown";
+}
+
+Options GetColumnFamilyOptions(ColumnFamily family, size_t cacheBytes, const Options& base) {
+    Options options = base;
+    options.block_cache_size = cacheBytes / 2;
+    options.write_buffer_size = std::max<size_t>(cacheBytes / 4, 1024 * 1024);
+    
+    switch (family) {
+        case ColumnFamily::BLOCK_INDEX:
+            // Cold and compressible; lookups mostly hit keys that exist
+            options.compression = true;
+            options.bloom_filter_bits = 0;
+            break;
+        case ColumnFamily::COINS:
+            // Short serialized coins gain little from compression, and
+            // misses (spent or unknown outpoints) are common
+            options.compression = false;
+            options.bloom_filter_bits = 10;
+            break;
+        case ColumnFamily::TX_INDEX:
+            options.compression = true;
+            options.bloom_filter_bits = 10;
+            break;
+    }
+    return options;
+}
+
+ColumnFamilyCacheSizes SplitDatabaseCache(size_t totalBytes, bool txIndex) {
+    ColumnFamilyCacheSizes sizes;
+    sizes.blockIndex = std::min(totalBytes / 8, MAX_BLOCK_INDEX_CACHE);
+    totalBytes -= sizes.blockIndex;
+    if (txIndex) {
+        sizes.txIndex = totalBytes / TX_INDEX_CACHE_FRACTION;
+        totalBytes -= sizes.txIndex;
+    }
+    sizes.coins = totalBytes;
+    return sizes;
+}
+
+// ============================================================================
+// ArenaWriteBatch
+// ============================================================================
+
+#ifdef SHURIUM_USE_LEVELDB
+
+// leveldb::WriteBatch is itself a contiguous buffer in the record format
+struct ArenaWriteBatch::Arena {
+    leveldb::WriteBatch batch;
+};
+
+#else
+
+// The same record format, kept in our own buffer
+struct ArenaWriteBatch::Arena {
+    std::string rep;
+};
+
+namespace {
+
+/// Sequence number (8 bytes) followed by the record count (4 bytes)
+constexpr size_t ARENA_HEADER_SIZE = 12;
+
+constexpr char ARENA_TYPE_DELETION = 0x0;
+constexpr char ARENA_TYPE_VALUE = 0x1;
+
+void PutVarint32(std::string& dst, uint32_t v) {
+    while (v >= 0x80) {
+        dst.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    dst.push_back(static_cast<char>(v));
+}
+
+void PutLengthPrefixed(std::string& dst, const Slice& s) {
+    PutVarint32(dst, static_cast<uint32_t>(s.size()));
+    dst.append(s.data(), s.size());
+}
+
+bool GetLengthPrefixed(const char*& p, const char* end, Slice& out) {
+    uint32_t len = 0;
+    for (int shift = 0; shift <= 28; shift += 7) {
+        if (p == end) {
+            return false;
+        }
+        uint32_t byte = static_cast<uint8_t>(*p++);
+        len |= (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            if (static_cast<size_t>(end - p) < len) {
+                return false;
+            }
+            out = Slice(p, len);
+            p += len;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SetArenaCount(std::string& rep, uint32_t count) {
+    for (int i = 0; i < 4; ++i) {
+        rep[8 + i] = static_cast<char>((count >> (8 * i)) & 0xFF);
+    }
+}
+
+} // namespace
+
+#endif // SHURIUM_USE_LEVELDB
+
+ArenaWriteBatch::ArenaWriteBatch() : arena_(std::make_unique<Arena>()) {
+    Clear();
+}
+
+ArenaWriteBatch::~ArenaWriteBatch() = default;
+ArenaWriteBatch::ArenaWriteBatch(ArenaWriteBatch&&) noexcept = default;
+ArenaWriteBatch& ArenaWriteBatch::operator=(ArenaWriteBatch&&) noexcept = default;
+
+void ArenaWriteBatch::Put(const Slice& key, const Slice& value) {
+#ifdef SHURIUM_USE_LEVELDB
+    arena_->batch.Put(leveldb::Slice(key.data(), key.size()),
+                      leveldb::Slice(value.data(), value.size()));
+#else
+    std::string& rep = arena_->rep;
+    rep.push_back(ARENA_TYPE_VALUE);
+    PutLengthPrefixed(rep, key);
+    PutLengthPrefixed(rep, value);
+    SetArenaCount(rep, static_cast<uint32_t>(count_ + 1));
+#endif
+    ++count_;
+}
+
+void ArenaWriteBatch::Delete(const Slice& key) {
+#ifdef SHURIUM_USE_LEVELDB
+    arena_->batch.Delete(leveldb::Slice(key.data(), key.size()));
+#else
+    std::string& rep = arena_->rep;
+    rep.push_back(ARENA_TYPE_DELETION);
+    PutLengthPrefixed(rep, key);
+    SetArenaCount(rep, static_cast<uint32_t>(count_ + 1));
+#endif
+    ++count_;
+}
+
+void ArenaWriteBatch::Clear() {
+#ifdef SHURIUM_USE_LEVELDB
+    arena_->batch.Clear();
+#else
+    arena_->rep.assign(ARENA_HEADER_SIZE, '\0');
+#endif
+    count_ = 0;
+}
+
+size_t ArenaWriteBatch::ApproximateSize() const {
+#ifdef SHURIUM_USE_LEVELDB
+    return arena_->batch.ApproximateSize();
+#else
+    return arena_->rep.size();
+#endif
+}
+
+Status ArenaWriteBatch::Iterate(
+    const std::function<void(const Slice& key, const Slice* value)>& func) const {
+#ifdef SHURIUM_USE_LEVELDB
+    struct Handler : public leveldb::WriteBatch::Handler {
+        const std::function<void(const Slice&, const Slice*)>& func;
+        explicit Handler(const std::function<void(const Slice&, const Slice*)>& f) : func(f) {}
+        void Put(const leveldb::Slice& key, const leveldb::Slice& value) override {
+            Slice v(value.data(), value.size());
+            func(Slice(key.data(), key.size()), &v);
+        }
+        void Delete(const leveldb::Slice& key) override {
+            func(Slice(key.data(), key.size()), nullptr);
+        }
+    } handler(func);
+    leveldb::Status s = arena_->batch.Iterate(&handler);
+    return s.ok() ? Status::Ok() : Status::Corruption(s.ToString());
+#else
+    const std::string& rep = arena_->rep;
+    if (rep.size() < ARENA_HEADER_SIZE) {
+        return Status::Corruption("arena batch too small");
+    }
+    const char* p = rep.data() + ARENA_HEADER_SIZE;
+    const char* end = rep.data() + rep.size();
+    size_t found = 0;
+    while (p != end) {
+        char tag = *p++;
+        Slice key, value;
+        if (!GetLengthPrefixed(p, end, key)) {
+            return Status::Corruption("bad arena batch key");
+        }
+        if (tag == ARENA_TYPE_VALUE) {
+            if (!GetLengthPrefixed(p, end, value)) {
+                return Status::Corruption("bad arena batch value");
+            }
+            func(key, &value);
+        } else if (tag == ARENA_TYPE_DELETION) {
+            func(key, nullptr);
+        } else {
+            return Status::Corruption("unknown arena batch tag");
+        }
+        ++found;
+    }
+    if (found != count_) {
+        return Status::Corruption("arena batch has wrong count");
+    }
+    return Status::Ok();
+#endif
+}
+
+// ============================================================================
+// Database
+// ============================================================================
+
+Status Database::Write(const WriteOptions& options, ArenaWriteBatch* batch) {
+    WriteBatch copy;
+    Status s = batch->Iterate([&copy](const Slice& key, const Slice* value) {
+        if (value) {
+            copy.Put(key, *value);
+        } else {
+            copy.Delete(key);
+        }
+    });
+    if (!s.ok()) {
+        return s;
+    }
+    return Write(options, &copy);
+}
+
+#ifdef SHURIUM_USE_LEVELDB
+
+Status LevelDBDatabase::Write(const WriteOptions& options, ArenaWriteBatch* batch) {
+    leveldb::WriteOptions lo = MakeWriteOptions(options);
+    return ConvertStatus(db_->Write(lo, &batch->GetArena().batch));
+}
+
+void LevelDBDatabase::GetEngineStats(DatabaseStats& stats) const {
+    // "leveldb.stats" is a per-level table:
+    // Level Files Size(MB) Time(sec) Read(MB) Write(MB)
+    std::string table;
+    if (db_->GetProperty("leveldb.stats", &table)) {
+        std::istringstream lines(table);
+        std::string line;
+        double readMB = 0, writeMB = 0;
+        while (std::getline(lines, line)) {
+            int level = 0, files = 0;
+            double size = 0, seconds = 0, read = 0, written = 0;
+            if (std::sscanf(line.c_str(), " %d %d %lf %lf %lf %lf", &level, &files, &size,
+                            &seconds, &read, &written) == 6) {
+                stats.compactionSeconds += seconds;
+                readMB += read;
+                writeMB += written;
+            }
+        }
+        stats.compactionBytesRead = static_cast<uint64_t>(readMB * 1048576.0);
+        stats.compactionBytesWritten = static_cast<uint64_t>(writeMB * 1048576.0);
+    }
+    
+    std::string memory;
+    if (db_->GetProperty("leveldb.approximate-memory-usage", &memory)) {
+        stats.memoryUsage = std::strtoull(memory.c_str(), nullptr, 10);
+    }
+    if (cache_) {
+        stats.blockCacheUsage = cache_->TotalCharge();
+    }
+    stats.blockCacheCapacity = block_cache_capacity_;
+}
+
+#endif // SHURIUM_USE_LEVELDB
+
 // ============================================================================
 // Database Factory Functions
 // ============================================================================
@@ -64,8 +407,9 @@ std::pair<Status, std::unique_ptr<Database>> OpenDatabase(
         return {Status::IOError(s.ToString()), nullptr};
     }
     
-    return {Status::Ok(), 
-            std::make_unique<LevelDBDatabase>(db, cache, filter, path)};
+    return {Status::Ok(),
+            std::make_unique<InstrumentedDatabase>(std::make_unique<LevelDBDatabase>(
+                db, cache, filter, path, options.block_cache_size))};
             
 #else
     // Fallback to in-memory database
@@ -75,7 +419,8 @@ std::pair<Status, std::unique_ptr<Database>> OpenDatabase(
         std::filesystem::create_directories(path, ec);
     }
     
-    return {Status::Ok(), std::make_unique<MemoryDatabase>()};
+    return {Status::Ok(),
+            std::make_unique<InstrumentedDatabase>(std::make_unique<MemoryDatabase>())};
 #endif
 }
 
@@ -0,0 +1,142 @@
+// SHURIUM - Instrumented Database Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/db/instrumented.h"
+#include <chrono>
+
+namespace shurium {
+namespace db {
+
+namespace {
+
+uint64_t MicrosSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+/// Counts the bytes of every entry an iterator lands on
+class CountingIterator : public Iterator {
+public:
+    CountingIterator(std::unique_ptr<Iterator> inner, std::atomic<uint64_t>& bytesRead)
+        : inner_(std::move(inner)), bytesRead_(bytesRead) {}
+
+    bool Valid() const override { return inner_->Valid(); }
+
+    void SeekToFirst() override { inner_->SeekToFirst(); Count(); }
+    void SeekToLast() override { inner_->SeekToLast(); Count(); }
+    void Seek(const Slice& target) override { inner_->Seek(target); Count(); }
+    void Next() override { inner_->Next(); Count(); }
+    void Prev() override { inner_->Prev(); Count(); }
+
+    Slice key() const override { return inner_->key(); }
+    Slice value() const override { return inner_->value(); }
+    Status status() const override { return inner_->status(); }
+
+private:
+    std::unique_ptr<Iterator> inner_;
+    std::atomic<uint64_t>& bytesRead_;
+
+    void Count() {
+        if (inner_->Valid()) {
+            bytesRead_.fetch_add(inner_->key().size() + inner_->value().size(),
+                                 std::memory_order_relaxed);
+        }
+    }
+};
+
+} // namespace
+
+// ============================================================================
+// InstrumentedDatabase
+// ============================================================================
+
+InstrumentedDatabase::InstrumentedDatabase(std::unique_ptr<Database> inner)
+    : inner_(std::move(inner)) {}
+
+Status InstrumentedDatabase::Get(const ReadOptions& options, const Slice& key,
+                                 std::string* value) {
+    auto start = std::chrono::steady_clock::now();
+    Status s = inner_->Get(options, key, value);
+    getLatency_.Record(MicrosSince(start));
+
+    gets_.fetch_add(1, std::memory_order_relaxed);
+    if (s.ok()) {
+        getHits_.fetch_add(1, std::memory_order_relaxed);
+        bytesRead_.fetch_add(key.size() + value->size(), std::memory_order_relaxed);
+    }
+    return s;
+}
+
+Status InstrumentedDatabase::Put(const WriteOptions& options, const Slice& key,
+                                 const Slice& value) {
+    auto start = std::chrono::steady_clock::now();
+    Status s = inner_->Put(options, key, value);
+    RecordWrite(MicrosSince(start));
+
+    puts_.fetch_add(1, std::memory_order_relaxed);
+    bytesWritten_.fetch_add(key.size() + value.size(), std::memory_order_relaxed);
+    return s;
+}
+
+Status InstrumentedDatabase::Delete(const WriteOptions& options, const Slice& key) {
+    auto start = std::chrono::steady_clock::now();
+    Status s = inner_->Delete(options, key);
+    RecordWrite(MicrosSince(start));
+
+    deletes_.fetch_add(1, std::memory_order_relaxed);
+    bytesWritten_.fetch_add(key.size(), std::memory_order_relaxed);
+    return s;
+}
+
+Status InstrumentedDatabase::Write(const WriteOptions& options, WriteBatch* batch) {
+    size_t bytes = batch->ApproximateSize();
+    auto start = std::chrono::steady_clock::now();
+    Status s = inner_->Write(options, batch);
+    RecordWrite(MicrosSince(start));
+
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+    return s;
+}
+
+Status InstrumentedDatabase::Write(const WriteOptions& options, ArenaWriteBatch* batch) {
+    size_t bytes = batch->ApproximateSize();
+    auto start = std::chrono::steady_clock::now();
+    Status s = inner_->Write(options, batch);
+    RecordWrite(MicrosSince(start));
+
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    bytesWritten_.fetch_add(bytes, std::memory_order_relaxed);
+    return s;
+}
+
+std::unique_ptr<Iterator> InstrumentedDatabase::NewIterator(const ReadOptions& options) {
+    return std::make_unique<CountingIterator>(inner_->NewIterator(options), bytesRead_);
+}
+
+DatabaseStats InstrumentedDatabase::GetDatabaseStats() const {
+    DatabaseStats stats;
+    stats.gets = gets_.load(std::memory_order_relaxed);
+    stats.getHits = getHits_.load(std::memory_order_relaxed);
+    stats.puts = puts_.load(std::memory_order_relaxed);
+    stats.deletes = deletes_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.bytesRead = bytesRead_.load(std::memory_order_relaxed);
+    stats.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    stats.writeStalls = writeStalls_.load(std::memory_order_relaxed);
+    stats.getLatency = getLatency_.GetSnapshot();
+    stats.writeLatency = writeLatency_.GetSnapshot();
+    inner_->GetEngineStats(stats);
+    return stats;
+}
+
+void InstrumentedDatabase::RecordWrite(uint64_t micros) {
+    writeLatency_.Record(micros);
+    if (micros >= DB_WRITE_STALL_MICROS) {
+        writeStalls_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace db
+} // namespace shurium
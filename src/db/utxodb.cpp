@@ -4,7 +4,11 @@
 
 #include "shurium/db/utxodb.h"
 #include "shurium/crypto/sha256.h"
+#include "shurium/util/logging.h"
 #include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace shurium {
 namespace db {
@@ -34,6 +38,125 @@ CoinsViewDB::CoinsViewDB(const std::filesystem::path& dbPath,
         throw std::runtime_error("Failed to open UTXO database: " + status.ToString());
     }
     db_ = std::move(database);
+    UpgradeCoinFormat();
+    LoadUTXOHash();
+}
+
+CoinsViewDB::CoinsViewDB(std::unique_ptr<Database> database)
+    : db_(std::move(database))
+{
+    UpgradeCoinFormat();
+    LoadUTXOHash();
+}
+
+namespace {
+
+/// Coins rewritten per batch while upgrading the format
+constexpr size_t UPGRADE_BATCH_COINS = 10000;
+
+std::string CoinFormatKey() {
+    return MakeKey(prefix::FLAG, Slice("coinformat"));
+}
+
+/// Key of the last coin upgraded, while an upgrade is under way
+std::string CoinFormatUpgradeKey() {
+    return MakeKey(prefix::FLAG, Slice("coinformatupgrade"));
+}
+
+} // anonymous namespace
+
+void CoinsViewDB::UpgradeCoinFormat() {
+    std::string value;
+    if (db_->Get(ReadOptions(), Slice(CoinFormatKey()), &value).ok()) {
+        uint32_t format = COIN_FORMAT_LEGACY;
+        if (!DeserializeFromString(value, format)) {
+            throw std::runtime_error("Unreadable coin format in UTXO database");
+        }
+        if (format > COIN_FORMAT_CURRENT) {
+            throw std::runtime_error("UTXO database uses coin format " + std::to_string(format) +
+                                     ", written by a newer version");
+        }
+        if (format == COIN_FORMAT_CURRENT) {
+            return;
+        }
+    }
+    
+    // No format recorded: legacy coins, unless there are none. An upgrade
+    // cut short resumes after the last coin it rewrote; coins up to there
+    // are already in the new format.
+    const std::string coinPrefix(1, prefix::COIN);
+    std::string resumeKey;
+    bool resuming = db_->Get(ReadOptions(), Slice(CoinFormatUpgradeKey()), &resumeKey).ok();
+    size_t upgraded = 0;
+    
+    while (true) {
+        std::vector<std::pair<std::string, std::string>> coins;
+        {
+            auto iter = db_->NewIterator(ReadOptions());
+            iter->Seek(Slice(resuming ? resumeKey : coinPrefix));
+            if (resuming && iter->Valid() && iter->key().ToString() == resumeKey) {
+                iter->Next();
+            }
+            for (; iter->Valid() && coins.size() < UPGRADE_BATCH_COINS; iter->Next()) {
+                Slice key = iter->key();
+                if (key.size() < 1 || key[0] != prefix::COIN) {
+                    break;
+                }
+                coins.emplace_back(key.ToString(), iter->value().ToString());
+            }
+        }
+        
+        WriteBatch batch;
+        for (const auto& [key, legacy] : coins) {
+            Coin coin;
+            if (!DecodeCoin(legacy, coin, COIN_FORMAT_LEGACY)) {
+                throw std::runtime_error("Unreadable coin in UTXO database during format upgrade");
+            }
+            std::string compressed = EncodeCoin(coin);
+            batch.Put(Slice(key), Slice(compressed));
+        }
+        if (coins.size() < UPGRADE_BATCH_COINS) {
+            batch.Put(Slice(CoinFormatKey()), Slice(SerializeToString(COIN_FORMAT_CURRENT)));
+            batch.Delete(Slice(CoinFormatUpgradeKey()));
+        } else {
+            resumeKey = coins.back().first;
+            resuming = true;
+            batch.Put(Slice(CoinFormatUpgradeKey()), Slice(resumeKey));
+        }
+        
+        Status s = db_->Write(WriteOptions(), &batch);
+        if (!s.ok()) {
+            throw std::runtime_error("Failed to upgrade UTXO database: " + s.ToString());
+        }
+        upgraded += coins.size();
+        if (coins.size() < UPGRADE_BATCH_COINS) {
+            break;
+        }
+    }
+    
+    if (upgraded > 0) {
+        LOG_INFO(util::LogCategory::DB) << "Upgraded " << upgraded << " coins to the compressed UTXO format";
+    }
+}
+
+void CoinsViewDB::LoadUTXOHash() {
+    std::string value;
+    Status s = db_->Get(ReadOptions(), Slice(MakeKey(prefix::COINS_MUHASH)), &value);
+    if (s.ok() && DeserializeFromString(value, muhash_)) {
+        return;
+    }
+    
+    // Written before the rolling hash was kept: hash every coin once
+    MuHash3072 hash;
+    size_t nCoins = ForEachCoin([&hash](const OutPoint& outpoint, const Coin& coin) {
+        AddCoinToHash(hash, outpoint, coin);
+        return true;
+    });
+    muhash_ = hash;
+    if (nCoins > 0) {
+        std::string hashValue = SerializeToString(muhash_);
+        db_->Put(WriteOptions(), Slice(MakeKey(prefix::COINS_MUHASH)), Slice(hashValue));
+    }
 }
 
 std::optional<Coin> CoinsViewDB::GetCoin(const OutPoint& outpoint) const {
@@ -41,11 +164,19 @@ std::optional<Coin> CoinsViewDB::GetCoin(const OutPoint& outpoint) const {
         return std::nullopt;
     }
     
+    if (coinFilter_ && !coinFilter_->MightContain(outpoint)) {
+        coinFilter_->RecordFiltered();
+        return std::nullopt;
+    }
+    
     ++nReads_;
     
     std::string key = MakeKey(prefix::COIN, outpoint);
     std::string value;
     Status s = db_->Get(ReadOptions(), Slice(key), &value);
+    if (coinFilter_) {
+        coinFilter_->RecordLookup(s.ok());
+    }
     
     if (!s.ok()) {
         return std::nullopt;
@@ -54,7 +185,7 @@ std::optional<Coin> CoinsViewDB::GetCoin(const OutPoint& outpoint) const {
     nReadBytes_ += value.size();
     
     Coin coin;
-    if (!DeserializeFromString(value, coin)) {
+    if (!DecodeCoin(value, coin)) {
         return std::nullopt;
     }
     
@@ -66,11 +197,21 @@ bool CoinsViewDB::HaveCoin(const OutPoint& outpoint) const {
         return false;
     }
     
+    if (coinFilter_ && !coinFilter_->MightContain(outpoint)) {
+        coinFilter_->RecordFiltered();
+        return false;
+    }
+    
     std::string key = MakeKey(prefix::COIN, outpoint);
-    return db_->Exists(Slice(key));
+    bool found = db_->Exists(Slice(key));
+    if (coinFilter_) {
+        coinFilter_->RecordLookup(found);
+    }
+    return found;
 }
 
 BlockHash CoinsViewDB::GetBestBlock() const {
+    std::lock_guard<std::mutex> lock(bestBlockMutex_);
     if (cachedBestBlockValid_) {
         return cachedBestBlock_;
     }
@@ -109,19 +250,24 @@ size_t CoinsViewDB::EstimateSize() const {
     return diskUsage / 50;
 }
 
-bool CoinsViewDB::BatchWrite(CoinsMap& mapCoins, const BlockHash& hashBlock) {
+bool CoinsViewDB::GetUTXOHashState(MuHash3072& state) const {
+    std::lock_guard<std::mutex> lock(bestBlockMutex_);
+    state = muhash_;
+    return true;
+}
+
+bool CoinsViewDB::BatchWrite(const CoinsMap& mapCoins, const BlockHash& hashBlock,
+                             const MuHash3072& hashDelta) {
     if (!db_) {
         return false;
     }
     
-    db::WriteBatch batch;
+    // Coins are serialized straight into the batch's backend buffer
+    db::ArenaWriteBatch batch;
     size_t writeBytes = 0;
     size_t writeCount = 0;
     
-    for (auto it = mapCoins.begin(); it != mapCoins.end(); ) {
-        const OutPoint& outpoint = it->first;
-        CoinsCacheEntry& entry = it->second;
-        
+    for (const auto& [outpoint, entry] : mapCoins) {
         if (entry.IsDirty()) {
             std::string key = MakeKey(prefix::COIN, outpoint);
             
@@ -129,16 +275,16 @@ bool CoinsViewDB::BatchWrite(CoinsMap& mapCoins, const BlockHash& hashBlock) {
                 // Delete spent coin
                 batch.Delete(Slice(key));
             } else {
-                // Write unspent coin
-                std::string value = SerializeToString(entry.coin);
+                // Write unspent coin; the filter learns it before readers can
+                if (coinFilter_) {
+                    coinFilter_->Add(outpoint);
+                }
+                std::string value = EncodeCoin(entry.coin);
                 batch.Put(Slice(key), Slice(value));
                 writeBytes += value.size();
             }
             ++writeCount;
         }
-        
-        // Erase from cache after processing
-        it = mapCoins.erase(it);
     }
     
     // Update best block
@@ -147,10 +293,21 @@ bool CoinsViewDB::BatchWrite(CoinsMap& mapCoins, const BlockHash& hashBlock) {
         std::string value = SerializeToString(hashBlock);
         batch.Put(Slice(key), Slice(value));
         
+        std::lock_guard<std::mutex> lock(bestBlockMutex_);
         cachedBestBlock_ = hashBlock;
         cachedBestBlockValid_ = true;
     }
     
+    // Keep the rolling hash in step with the coins
+    MuHash3072 newHash;
+    bool hashChanged = !hashDelta.IsEmpty();
+    if (hashChanged) {
+        GetUTXOHashState(newHash);
+        newHash *= hashDelta;
+        std::string hashValue = SerializeToString(newHash);
+        batch.Put(Slice(MakeKey(prefix::COINS_MUHASH)), Slice(hashValue));
+    }
+    
     // Write batch
     WriteOptions opts;
     opts.sync = true;  // Sync for safety
@@ -159,33 +316,57 @@ bool CoinsViewDB::BatchWrite(CoinsMap& mapCoins, const BlockHash& hashBlock) {
     if (s.ok()) {
         nWrites_ += writeCount;
         nWriteBytes_ += writeBytes;
+        if (hashChanged) {
+            std::lock_guard<std::mutex> lock(bestBlockMutex_);
+            muhash_ = newHash;
+        }
     }
     
     return s.ok();
 }
 
 Status CoinsViewDB::AddCoin(const OutPoint& outpoint, const Coin& coin) {
-    if (!db_) {
-        return Status::NotSupported("Database not open");
-    }
-    
-    std::string key = MakeKey(prefix::COIN, outpoint);
-    std::string value = SerializeToString(coin);
-    
-    ++nWrites_;
-    nWriteBytes_ += value.size();
-    
-    return db_->Put(WriteOptions(), Slice(key), Slice(value));
+    return WriteCoinChange(outpoint, &coin);
 }
 
 Status CoinsViewDB::RemoveCoin(const OutPoint& outpoint) {
+    return WriteCoinChange(outpoint, nullptr);
+}
+
+Status CoinsViewDB::WriteCoinChange(const OutPoint& outpoint, const Coin* coin) {
     if (!db_) {
         return Status::NotSupported("Database not open");
     }
     
+    MuHash3072 newHash;
+    GetUTXOHashState(newHash);
+    if (auto oldCoin = GetCoin(outpoint)) {
+        RemoveCoinFromHash(newHash, outpoint, *oldCoin);
+    }
+    
+    db::WriteBatch batch;
     std::string key = MakeKey(prefix::COIN, outpoint);
+    if (coin) {
+        if (coinFilter_) {
+            coinFilter_->Add(outpoint);
+        }
+        std::string value = EncodeCoin(*coin);
+        batch.Put(Slice(key), Slice(value));
+        nWriteBytes_ += value.size();
+        AddCoinToHash(newHash, outpoint, *coin);
+    } else {
+        batch.Delete(Slice(key));
+    }
+    std::string hashValue = SerializeToString(newHash);
+    batch.Put(Slice(MakeKey(prefix::COINS_MUHASH)), Slice(hashValue));
     ++nWrites_;
-    return db_->Delete(WriteOptions(), Slice(key));
+    
+    Status s = db_->Write(WriteOptions(), &batch);
+    if (s.ok()) {
+        std::lock_guard<std::mutex> lock(bestBlockMutex_);
+        muhash_ = newHash;
+    }
+    return s;
 }
 
 Status CoinsViewDB::SetBestBlock(const BlockHash& hash) {
@@ -201,6 +382,7 @@ Status CoinsViewDB::SetBestBlock(const BlockHash& hash) {
     Status s = db_->Put(opts, Slice(key), Slice(value));
     
     if (s.ok()) {
+        std::lock_guard<std::mutex> lock(bestBlockMutex_);
         cachedBestBlock_ = hash;
         cachedBestBlockValid_ = true;
     }
@@ -208,11 +390,50 @@ Status CoinsViewDB::SetBestBlock(const BlockHash& hash) {
     return s;
 }
 
-std::unique_ptr<Iterator> CoinsViewDB::NewIterator() const {
+std::unique_ptr<Iterator> CoinsViewDB::NewIterator(const DatabaseSnapshot* snapshot) const {
     if (!db_) {
         return nullptr;
     }
-    return db_->NewIterator();
+    return snapshot ? db_->NewIterator(snapshot->GetReadOptions()) : db_->NewIterator();
+}
+
+size_t CoinsViewDB::EnableCoinFilter(size_t memoryBytes) {
+    if (!db_) {
+        return 0;
+    }
+    auto filter = std::make_unique<CoinFilter>(memoryBytes);
+    size_t nCoins = ForEachCoin([&filter](const OutPoint& outpoint, const Coin&) {
+        filter->Add(outpoint);
+        return true;
+    });
+    coinFilter_ = std::move(filter);
+    return nCoins;
+}
+
+std::unique_ptr<DatabaseSnapshot> CoinsViewDB::NewSnapshot() const {
+    return db_ ? db_->NewSnapshot() : nullptr;
+}
+
+BlockHash CoinsViewDB::GetBestBlock(const DatabaseSnapshot& snapshot) const {
+    std::string value;
+    BlockHash hash;
+    if (!db_ || !db_->Get(snapshot.GetReadOptions(), Slice(MakeKey(prefix::COINS_TIP)),
+                          &value).ok() ||
+        !DeserializeFromString(value, hash)) {
+        return BlockHash();
+    }
+    return hash;
+}
+
+bool CoinsViewDB::GetUTXOHashState(MuHash3072& state, const DatabaseSnapshot& snapshot) const {
+    std::string value;
+    if (!db_ || !db_->Get(snapshot.GetReadOptions(), Slice(MakeKey(prefix::COINS_MUHASH)),
+                          &value).ok()) {
+        // Nothing written yet: the hash of the empty set
+        state = MuHash3072();
+        return db_ != nullptr;
+    }
+    return DeserializeFromString(value, state);
 }
 
 // ============================================================================
@@ -222,6 +443,7 @@ std::unique_ptr<Iterator> CoinsViewDB::NewIterator() const {
 Hash256 CalculateUTXOSetHash(const CoinsViewDB& coinsView) {
     SHA256 hasher;
     
+    auto snapshot = coinsView.NewSnapshot();
     coinsView.ForEachCoin([&hasher](const OutPoint& outpoint, const Coin& coin) {
         // Hash the outpoint
         DataStream ss;
@@ -234,17 +456,27 @@ Hash256 CalculateUTXOSetHash(const CoinsViewDB& coinsView) {
         hasher.Write(ss.data(), ss.size());
         
         return true;  // Continue iteration
-    });
+    }, snapshot.get());
     
     Hash256 result;
     hasher.Finalize(result.data());
     return result;
 }
 
-UTXOStats GetUTXOStats(const CoinsViewDB& coinsView) {
+UTXOStats GetUTXOStats(const CoinsViewDB& coinsView, const DatabaseSnapshot* snapshot) {
     UTXOStats stats;
     stats.Reset();
     
+    // Scan one consistent view even if blocks connect meanwhile
+    std::unique_ptr<DatabaseSnapshot> ownSnapshot;
+    if (!snapshot) {
+        ownSnapshot = coinsView.NewSnapshot();
+        snapshot = ownSnapshot.get();
+    }
+    if (snapshot) {
+        stats.hashBlock = coinsView.GetBestBlock(*snapshot);
+    }
+    
     SHA256 hasher;
     
     std::map<TxHash, uint32_t> txCount;  // Count outputs per transaction
@@ -266,7 +498,7 @@ UTXOStats GetUTXOStats(const CoinsViewDB& coinsView) {
         hasher.Write(ss.data(), ss.size());
         
         return true;
-    });
+    }, snapshot);
     
     stats.nTransactions = txCount.size();
     stats.nDiskSize = coinsView.GetDiskUsage();
@@ -447,29 +447,39 @@ bool FundManager::HasPendingKeyRotation(FundType type) const {
     return it != m_pendingKeyRotations.end();
 }
 
+const FundManager::FundIndex* FundManager::FindIndexLocked(FundType type) const {
+    auto it = m_fundIndex.find(type);
+    return it != m_fundIndex.end() ? &it->second : nullptr;
+}
+
 Amount FundManager::GetFundBalance(FundType type) const {
-    auto it = m_fundUTXOs.find(type);
-    if (it == m_fundUTXOs.end()) {
-        return 0;
-    }
-    
-    Amount balance = 0;
-    for (const auto& [outpoint, utxo] : it->second) {
-        if (!utxo.spent) {
-            balance += utxo.value;
-        }
-    }
-    return balance;
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    const FundIndex* index = FindIndexLocked(type);
+    return index ? index->balance : 0;
 }
 
 Amount FundManager::GetTotalReceived(FundType type) const {
-    auto it = m_totalReceived.find(type);
-    return it != m_totalReceived.end() ? it->second : 0;
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    const FundIndex* index = FindIndexLocked(type);
+    return index ? index->totalReceived : 0;
 }
 
 Amount FundManager::GetTotalSpent(FundType type) const {
-    auto it = m_totalSpent.find(type);
-    return it != m_totalSpent.end() ? it->second : 0;
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    const FundIndex* index = FindIndexLocked(type);
+    return index ? index->totalSpent : 0;
+}
+
+size_t FundManager::GetTransactionCount(FundType type) const {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    const FundIndex* index = FindIndexLocked(type);
+    return index ? index->transactionCount : 0;
+}
+
+int64_t FundManager::GetLastActivityHeight(FundType type) const {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    const FundIndex* index = FindIndexLocked(type);
+    return index ? index->lastActivityHeight : 0;
 }
 
 // ============================================================================
@@ -477,59 +487,198 @@ Amount FundManager::GetTotalSpent(FundType type) const {
 // ============================================================================
 
 void FundManager::TrackFundUTXO(FundType type, const OutPoint& outpoint, Amount value, int64_t height) {
-    FundUTXO utxo;
-    utxo.value = value;
-    utxo.height = height;
-    utxo.spent = false;
-    
-    m_fundUTXOs[type][outpoint] = utxo;
-    m_totalReceived[type] += value;
-    m_lastActivityHeight[type] = height;
-    m_transactionCount[type]++;
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    TrackFundUTXOLocked(type, outpoint, value, height);
 }
 
 void FundManager::MarkFundUTXOSpent(FundType type, const OutPoint& outpoint, int64_t height) {
-    auto typeIt = m_fundUTXOs.find(type);
-    if (typeIt == m_fundUTXOs.end()) {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    MarkFundUTXOSpentLocked(type, outpoint, height);
+}
+
+void FundManager::UntrackFundUTXO(FundType type, const OutPoint& outpoint) {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    UntrackFundUTXOLocked(type, outpoint);
+}
+
+void FundManager::UnmarkFundUTXOSpent(FundType type, const OutPoint& outpoint) {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    UnmarkFundUTXOSpentLocked(type, outpoint);
+}
+
+void FundManager::TrackFundUTXOLocked(FundType type, const OutPoint& outpoint, Amount value,
+                                      int64_t height) {
+    FundIndex& index = m_fundIndex[type];
+    if (index.unspent.count(outpoint) || index.spent.count(outpoint)) {
+        return;
+    }
+    
+    index.unspent.emplace(outpoint, FundUTXO{value, height});
+    index.balance += value;
+    index.totalReceived += value;
+    index.lastActivityHeight = height;
+    index.transactionCount++;
+}
+
+void FundManager::MarkFundUTXOSpentLocked(FundType type, const OutPoint& outpoint, int64_t height) {
+    auto indexIt = m_fundIndex.find(type);
+    if (indexIt == m_fundIndex.end()) {
+        return;
+    }
+    
+    FundIndex& index = indexIt->second;
+    auto utxoIt = index.unspent.find(outpoint);
+    if (utxoIt == index.unspent.end()) {
+        return;
+    }
+    
+    Amount value = utxoIt->second.value;
+    index.spent.emplace(outpoint, utxoIt->second);
+    index.unspent.erase(utxoIt);
+    index.balance -= value;
+    index.totalSpent += value;
+    index.lastActivityHeight = height;
+    index.transactionCount++;
+}
+
+void FundManager::UntrackFundUTXOLocked(FundType type, const OutPoint& outpoint) {
+    auto indexIt = m_fundIndex.find(type);
+    if (indexIt == m_fundIndex.end()) {
+        return;
+    }
+    
+    FundIndex& index = indexIt->second;
+    auto utxoIt = index.unspent.find(outpoint);
+    if (utxoIt == index.unspent.end()) {
+        return;  // Spends are undone first; a spent entry stays until then
+    }
+    
+    index.balance -= utxoIt->second.value;
+    index.totalReceived -= utxoIt->second.value;
+    index.transactionCount--;
+    index.unspent.erase(utxoIt);
+}
+
+void FundManager::UnmarkFundUTXOSpentLocked(FundType type, const OutPoint& outpoint) {
+    auto indexIt = m_fundIndex.find(type);
+    if (indexIt == m_fundIndex.end()) {
         return;
     }
     
-    auto utxoIt = typeIt->second.find(outpoint);
-    if (utxoIt != typeIt->second.end() && !utxoIt->second.spent) {
-        utxoIt->second.spent = true;
-        m_totalSpent[type] += utxoIt->second.value;
-        m_lastActivityHeight[type] = height;
-        m_transactionCount[type]++;
+    FundIndex& index = indexIt->second;
+    auto utxoIt = index.spent.find(outpoint);
+    if (utxoIt == index.spent.end()) {
+        return;
     }
+    
+    index.balance += utxoIt->second.value;
+    index.totalSpent -= utxoIt->second.value;
+    index.transactionCount--;
+    index.unspent.emplace(outpoint, utxoIt->second);
+    index.spent.erase(utxoIt);
 }
 
 void FundManager::ClearTrackedUTXOs() {
-    m_fundUTXOs.clear();
-    m_totalReceived.clear();
-    m_totalSpent.clear();
-    m_lastActivityHeight.clear();
-    m_transactionCount.clear();
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    m_fundIndex.clear();
 }
 
 std::vector<std::pair<OutPoint, Amount>> FundManager::GetFundUTXOs(FundType type) const {
     std::vector<std::pair<OutPoint, Amount>> result;
     
-    auto it = m_fundUTXOs.find(type);
-    if (it != m_fundUTXOs.end()) {
-        for (const auto& [outpoint, utxo] : it->second) {
-            if (!utxo.spent) {
+    {
+        std::lock_guard<std::mutex> lock(m_utxoMutex);
+        if (const FundIndex* index = FindIndexLocked(type)) {
+            result.reserve(index->unspent.size());
+            for (const auto& [outpoint, utxo] : index->unspent) {
                 result.emplace_back(outpoint, utxo.value);
             }
         }
     }
     
-    // Sort by value descending for optimal coin selection
-    std::sort(result.begin(), result.end(),
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+    // Sort by value descending for optimal coin selection; ties by outpoint
+    // so selection does not depend on hash table order
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
     
     return result;
 }
 
+size_t FundManager::GetFundUTXOCount(FundType type) const {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    const FundIndex* index = FindIndexLocked(type);
+    return index ? index->unspent.size() : 0;
+}
+
+std::optional<FundType> FundManager::GetFundTypeForScript(const Script& script) const {
+    if (!script.IsPayToScriptHash()) {
+        return std::nullopt;
+    }
+    // OP_HASH160 <20 bytes> OP_EQUAL
+    Hash160 hash;
+    std::copy(script.begin() + 2, script.begin() + 22, hash.begin());
+    return GetFundTypeForAddress(hash);
+}
+
+void FundManager::ConnectBlock(const Block& block, int64_t height) {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    for (const auto& ptx : block.vtx) {
+        const Transaction& tx = *ptx;
+        if (!tx.IsCoinBase() && !m_fundIndex.empty()) {
+            for (const auto& txin : tx.vin) {
+                for (auto& [type, index] : m_fundIndex) {
+                    if (index.unspent.count(txin.prevout)) {
+                        MarkFundUTXOSpentLocked(type, txin.prevout, height);
+                        break;
+                    }
+                }
+            }
+        }
+        
+        const TxHash& txid = tx.GetHash();
+        for (size_t i = 0; i < tx.vout.size(); ++i) {
+            if (auto type = GetFundTypeForScript(tx.vout[i].scriptPubKey)) {
+                TrackFundUTXOLocked(*type, OutPoint(txid, static_cast<uint32_t>(i)),
+                                    tx.vout[i].nValue, height);
+            }
+        }
+    }
+}
+
+void FundManager::DisconnectBlock(const Block& block, int64_t height) {
+    std::lock_guard<std::mutex> lock(m_utxoMutex);
+    for (auto it = block.vtx.rbegin(); it != block.vtx.rend(); ++it) {
+        const Transaction& tx = **it;
+        
+        const TxHash& txid = tx.GetHash();
+        for (size_t i = 0; i < tx.vout.size(); ++i) {
+            if (auto type = GetFundTypeForScript(tx.vout[i].scriptPubKey)) {
+                UntrackFundUTXOLocked(*type, OutPoint(txid, static_cast<uint32_t>(i)));
+            }
+        }
+        
+        if (!tx.IsCoinBase()) {
+            for (const auto& txin : tx.vin) {
+                for (auto& [type, index] : m_fundIndex) {
+                    if (index.spent.count(txin.prevout)) {
+                        UnmarkFundUTXOSpentLocked(type, txin.prevout);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    
+    // Activity from the disconnected block is gone; the exact earlier
+    // height is not kept, so fall back to the block below it
+    for (auto& [type, index] : m_fundIndex) {
+        if (index.lastActivityHeight >= height) {
+            index.lastActivityHeight = height - 1;
+        }
+    }
+}
+
 std::optional<FundManager::UnsignedFundTx> FundManager::CreateFundSpendingTx(
     FundType type,
     const std::vector<std::pair<Script, Amount>>& outputs,
@@ -666,10 +815,8 @@ std::vector<FundStats> GetAllFundStats() {
         s.totalReceived = manager.GetTotalReceived(config.type);
         s.totalSpent = manager.GetTotalSpent(config.type);
         
-        // Get transaction count and last activity from fund manager's internal state
-        // These are tracked via the UTXO tracking methods
-        s.transactionCount = 0;  // Will be populated by TrackFundUTXO calls
-        s.lastActivityHeight = 0;
+        s.transactionCount = manager.GetTransactionCount(config.type);
+        s.lastActivityHeight = manager.GetLastActivityHeight(config.type);
         
         stats.push_back(s);
     }
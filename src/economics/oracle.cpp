@@ -3,9 +3,11 @@
 // MIT License
 
 #include <shurium/economics/oracle.h>
+#include <shurium/crypto/keys.h>
 #include <shurium/crypto/sha256.h>
 
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <numeric>
 #include <random>
@@ -106,14 +108,17 @@ std::vector<Byte> PriceSubmission::GetSignatureMessage() const {
 }
 
 bool PriceSubmission::VerifySignature(const PublicKey& pubkey) const {
-    if (signature.empty()) {
+    if (signature.empty() || !pubkey.IsValid()) {
         return false;
     }
     
-    // In a real implementation, this would verify the ECDSA signature
-    // For now, return true if signature exists
-    auto message = GetSignatureMessage();
-    return pubkey.IsValid() && !signature.empty();
+    Hash256 hash = GetHash();
+    if (HasSchnorrSignature()) {
+        std::array<uint8_t, 64> sig;
+        std::copy(signature.begin(), signature.end(), sig.begin());
+        return pubkey.VerifySchnorr(hash, sig);
+    }
+    return pubkey.Verify(hash, signature);
 }
 
 std::vector<Byte> PriceSubmission::Serialize() const {
@@ -217,6 +222,24 @@ std::string PriceSubmission::ToString() const {
 // PriceCommitment
 // ============================================================================
 
+namespace {
+
+/// A commitment preimage is exactly one DoubleSHA256_64 message, so a
+/// batch of reveals is checked in a single multi-buffer call
+constexpr size_t COMMITMENT_PREIMAGE_SIZE = 64;
+
+/// price (LE) || salt || first 24 bytes of the oracle id
+void WriteCommitmentPreimage(Byte* out, const OracleId& oracle,
+                             PriceMillicents price, const Hash256& salt) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<Byte>((price >> (i * 8)) & 0xFF);
+    }
+    std::copy(salt.begin(), salt.end(), out + 8);
+    std::copy(oracle.begin(), oracle.begin() + 24, out + 40);
+}
+
+} // anonymous namespace
+
 PriceCommitment PriceCommitment::Create(
     const OracleId& oracle,
     PriceMillicents price,
@@ -236,29 +259,21 @@ PriceCommitment PriceCommitment::Create(
     }
     pc.salt = Hash256(saltBytes.data(), 32);
     
-    // Create commitment: H(price || salt)
-    std::vector<Byte> preimage;
-    preimage.reserve(40);
-    for (int i = 0; i < 8; ++i) {
-        preimage.push_back(static_cast<Byte>((price >> (i * 8)) & 0xFF));
-    }
-    preimage.insert(preimage.end(), pc.salt.begin(), pc.salt.end());
-    
-    pc.commitment = SHA256Hash(preimage.data(), preimage.size());
+    // Create commitment: H(price || salt || oracle)
+    Byte preimage[COMMITMENT_PREIMAGE_SIZE];
+    WriteCommitmentPreimage(preimage, oracle, price, pc.salt);
+    DoubleSHA256_64(pc.commitment.data(), preimage, 1);
     
     return pc;
 }
 
 bool PriceCommitment::VerifyReveal(PriceMillicents price, const Hash256& revealSalt) const {
     // Recreate commitment and compare
-    std::vector<Byte> preimage;
-    preimage.reserve(40);
-    for (int i = 0; i < 8; ++i) {
-        preimage.push_back(static_cast<Byte>((price >> (i * 8)) & 0xFF));
-    }
-    preimage.insert(preimage.end(), revealSalt.begin(), revealSalt.end());
+    Byte preimage[COMMITMENT_PREIMAGE_SIZE];
+    WriteCommitmentPreimage(preimage, oracleId, price, revealSalt);
     
-    Hash256 expectedCommitment = SHA256Hash(preimage.data(), preimage.size());
+    Hash256 expectedCommitment;
+    DoubleSHA256_64(expectedCommitment.data(), preimage, 1);
     return commitment == expectedCommitment;
 }
 
@@ -817,8 +832,7 @@ bool PriceAggregator::ProcessSubmission(const PriceSubmission& submission) {
         return false;
     }
     
-    // Add to current submissions
-    currentSubmissions_.push_back(submission);
+    AddSubmissionLocked(submission);
     return true;
 }
 
@@ -842,7 +856,7 @@ bool PriceAggregator::ProcessReveal(
     std::lock_guard<std::mutex> lock(mutex_);
     
     auto it = pendingCommitments_.find(oracleId);
-    if (it == pendingCommitments_.end()) {
+    if (it == pendingCommitments_.end() || it->second.revealed) {
         return false;
     }
     
@@ -851,33 +865,137 @@ bool PriceAggregator::ProcessReveal(
         return false;
     }
     
-    // Mark as revealed and create submission
-    it->second.revealed = true;
-    it->second.revealedPrice = price;
-    it->second.salt = salt;
+    AcceptRevealLocked(it->second, price, salt);
+    return true;
+}
+
+std::vector<bool> PriceAggregator::ProcessSubmissions(
+    const std::vector<PriceSubmission>& submissions
+) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    std::vector<bool> accepted(submissions.size(), false);
+    
+    // Schnorr signatures go into one batch; ECDSA ones are checked singly
+    SchnorrBatchVerifier batch;
+    std::vector<size_t> batched;  // batch entry -> submission index
+    
+    for (size_t i = 0; i < submissions.size(); ++i) {
+        const PriceSubmission& sub = submissions[i];
+        const OracleInfo* oracle = registry_.GetOracle(sub.oracleId);
+        if (!oracle || oracle->status != OracleStatus::Active) {
+            continue;
+        }
+        
+        if (sub.HasSchnorrSignature()) {
+            std::array<uint8_t, 64> sig;
+            std::copy(sub.signature.begin(), sub.signature.end(), sig.begin());
+            batch.Add(oracle->publicKey, sub.GetHash(), sig);
+            batched.push_back(i);
+        } else {
+            accepted[i] = sub.VerifySignature(oracle->publicKey);
+        }
+    }
+    
+    if (!batch.Empty()) {
+        std::vector<size_t> invalid;
+        batch.Verify(&invalid);
+        for (size_t index : batched) {
+            accepted[index] = true;
+        }
+        for (size_t entry : invalid) {
+            accepted[batched[entry]] = false;
+        }
+    }
+    
+    for (size_t i = 0; i < submissions.size(); ++i) {
+        if (accepted[i]) {
+            AddSubmissionLocked(submissions[i]);
+        }
+    }
+    return accepted;
+}
+
+std::vector<bool> PriceAggregator::ProcessReveals(const std::vector<PriceReveal>& reveals) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    std::vector<bool> valid(reveals.size(), false);
+    
+    // Reveals that have an open commitment, first one per oracle only
+    std::vector<size_t> pending;
+    std::vector<PriceCommitment*> commitments;
+    std::set<OracleId> seen;
+    for (size_t i = 0; i < reveals.size(); ++i) {
+        auto it = pendingCommitments_.find(reveals[i].oracleId);
+        if (it == pendingCommitments_.end() || it->second.revealed ||
+            !seen.insert(reveals[i].oracleId).second) {
+            continue;
+        }
+        pending.push_back(i);
+        commitments.push_back(&it->second);
+    }
+    
+    if (pending.empty()) {
+        return valid;
+    }
+    
+    // Recompute every commitment in one pass, digests written in place
+    std::vector<Byte> buffer(pending.size() * COMMITMENT_PREIMAGE_SIZE);
+    for (size_t k = 0; k < pending.size(); ++k) {
+        const PriceReveal& reveal = reveals[pending[k]];
+        WriteCommitmentPreimage(buffer.data() + k * COMMITMENT_PREIMAGE_SIZE,
+                                reveal.oracleId, reveal.price, reveal.salt);
+    }
+    DoubleSHA256_64(buffer.data(), buffer.data(), pending.size());
+    
+    for (size_t k = 0; k < pending.size(); ++k) {
+        PriceCommitment& commitment = *commitments[k];
+        const Byte* digest = buffer.data() + k * 32;
+        if (!std::equal(commitment.commitment.begin(), commitment.commitment.end(), digest)) {
+            continue;
+        }
+        const PriceReveal& reveal = reveals[pending[k]];
+        AcceptRevealLocked(commitment, reveal.price, reveal.salt);
+        valid[pending[k]] = true;
+    }
+    return valid;
+}
+
+void PriceAggregator::AddSubmissionLocked(const PriceSubmission& submission) {
+    currentSubmissions_.push_back(submission);
+    roundMedian_.Add(submission.price);
+}
+
+void PriceAggregator::AcceptRevealLocked(
+    PriceCommitment& commitment,
+    PriceMillicents price,
+    const Hash256& salt
+) {
+    commitment.revealed = true;
+    commitment.revealedPrice = price;
+    commitment.salt = salt;
     
     PriceSubmission sub;
-    sub.oracleId = oracleId;
+    sub.oracleId = commitment.oracleId;
     sub.price = price;
-    sub.blockHeight = it->second.commitHeight;
+    sub.blockHeight = commitment.commitHeight;
     sub.timestamp = std::chrono::system_clock::now();
     sub.confidence = 100;
     
-    currentSubmissions_.push_back(sub);
-    
-    return true;
+    AddSubmissionLocked(sub);
 }
 
 std::optional<AggregatedPrice> PriceAggregator::Aggregate(int currentHeight) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     // Check minimum sources
-    if (currentSubmissions_.size() < config_.minSources) {
+    auto median = roundMedian_.Median();
+    if (currentSubmissions_.size() < config_.minSources || !median) {
         return std::nullopt;
     }
     
     // Remove outliers
-    auto filteredSubmissions = RemoveOutliers(currentSubmissions_);
+    auto filteredSubmissions = RemoveOutliers(currentSubmissions_, *median);
     
     if (filteredSubmissions.size() < config_.minSources) {
         return std::nullopt;
@@ -961,12 +1079,14 @@ void PriceAggregator::StartNewRound(int height) {
     std::lock_guard<std::mutex> lock(mutex_);
     currentRoundHeight_ = height;
     currentSubmissions_.clear();
+    roundMedian_.Clear();
     pendingCommitments_.clear();
 }
 
 void PriceAggregator::FinalizeRound() {
     std::lock_guard<std::mutex> lock(mutex_);
     currentSubmissions_.clear();
+    roundMedian_.Clear();
 }
 
 void PriceAggregator::Prune(int keepRounds) {
@@ -1015,20 +1135,13 @@ PriceMillicents PriceAggregator::CalculateWeightedMedian(
 }
 
 std::vector<PriceSubmission> PriceAggregator::RemoveOutliers(
-    const std::vector<PriceSubmission>& submissions
+    const std::vector<PriceSubmission>& submissions,
+    PriceMillicents median
 ) const {
     if (submissions.size() < 3) {
         return submissions;
     }
     
-    // Calculate median
-    std::vector<PriceMillicents> prices;
-    for (const auto& sub : submissions) {
-        prices.push_back(sub.price);
-    }
-    std::sort(prices.begin(), prices.end());
-    PriceMillicents median = prices[prices.size() / 2];
-    
     // Filter outliers
     std::vector<PriceSubmission> filtered;
     for (const auto& sub : submissions) {
@@ -1076,6 +1189,21 @@ void OraclePriceFeed::Initialize(std::shared_ptr<OracleRegistry> registry) {
     aggregator_ = std::make_unique<PriceAggregator>(*registry_);
 }
 
+void OraclePriceFeed::QueueSubmission(const PriceSubmission& submission) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queuedSubmissions_.push_back(submission);
+}
+
+void OraclePriceFeed::QueueReveal(const PriceReveal& reveal) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queuedReveals_.push_back(reveal);
+}
+
+size_t OraclePriceFeed::GetQueuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queuedSubmissions_.size() + queuedReveals_.size();
+}
+
 void OraclePriceFeed::ProcessBlock(int height) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -1083,6 +1211,16 @@ void OraclePriceFeed::ProcessBlock(int height) {
         return;
     }
     
+    // Verify everything that arrived since the last block as one batch
+    if (!queuedSubmissions_.empty()) {
+        aggregator_->ProcessSubmissions(queuedSubmissions_);
+        queuedSubmissions_.clear();
+    }
+    if (!queuedReveals_.empty()) {
+        aggregator_->ProcessReveals(queuedReveals_);
+        queuedReveals_.clear();
+    }
+    
     // Update oracle timeouts
     registry_->UpdateTimeouts();
     
@@ -13,6 +13,44 @@
 namespace shurium {
 namespace economics {
 
+namespace {
+
+/// Split a subsidy into its components, remainder to the work reward
+RewardDistribution SplitReward(Amount total) {
+    RewardDistribution dist;
+    dist.total = total;
+    
+    dist.workReward = CalculatePercentage(total, RewardPercentage::WORK_REWARD);
+    dist.ubiPool = CalculatePercentage(total, RewardPercentage::UBI_POOL);
+    dist.contributions = CalculatePercentage(total, RewardPercentage::CONTRIBUTIONS);
+    dist.ecosystem = CalculatePercentage(total, RewardPercentage::ECOSYSTEM);
+    dist.stability = CalculatePercentage(total, RewardPercentage::STABILITY);
+    
+    // Handle rounding - add any remainder to work reward
+    Amount sum = dist.workReward + dist.ubiPool + dist.contributions + 
+                 dist.ecosystem + dist.stability;
+    if (sum < total) {
+        dist.workReward += (total - sum);
+    }
+    
+    return dist;
+}
+
+/// P2PKH script: OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG
+std::vector<Byte> MakeP2PKH(const Hash160& addr) {
+    std::vector<Byte> script;
+    script.reserve(25);
+    script.push_back(0x76); // OP_DUP
+    script.push_back(0xa9); // OP_HASH160
+    script.push_back(0x14); // Push 20 bytes
+    script.insert(script.end(), addr.begin(), addr.end());
+    script.push_back(0x88); // OP_EQUALVERIFY
+    script.push_back(0xac); // OP_CHECKSIG
+    return script;
+}
+
+} // namespace
+
 // ============================================================================
 // RewardDistribution
 // ============================================================================
@@ -36,47 +74,37 @@ std::string RewardDistribution::ToString() const {
 
 RewardCalculator::RewardCalculator(const consensus::Params& params)
     : params_(params) {
+    // The subsidy only changes at halvings, so the whole schedule is a
+    // handful of entries. Stop once the minimum reward floor is hit; after
+    // ~64 halvings the shift would reach 0, which is also the floor.
+    for (int halvings = 0; halvings < 64; ++halvings) {
+        Amount subsidy = std::max(INITIAL_BLOCK_REWARD >> halvings, MINIMUM_BLOCK_REWARD);
+        schedule_.push_back(SplitReward(subsidy));
+        if (subsidy == MINIMUM_BLOCK_REWARD) {
+            break;
+        }
+    }
+    if (schedule_.back().total != MINIMUM_BLOCK_REWARD) {
+        schedule_.push_back(SplitReward(MINIMUM_BLOCK_REWARD));
+    }
 }
 
-Amount RewardCalculator::GetBlockSubsidy(int height) const {
+int RewardCalculator::GetScheduleIndex(int height) const {
     if (height < 0) {
-        return 0;
-    }
-    
-    // Calculate number of halvings
-    int halvings = height / HALVING_INTERVAL;
-    
-    // After ~64 halvings, subsidy would be 0, but we have a minimum
-    if (halvings >= 64) {
-        return MINIMUM_BLOCK_REWARD;
+        return -1;
     }
-    
-    // Calculate subsidy with halving
-    Amount subsidy = INITIAL_BLOCK_REWARD >> halvings;
-    
-    // Enforce minimum reward
-    return std::max(subsidy, MINIMUM_BLOCK_REWARD);
+    int last = static_cast<int>(schedule_.size()) - 1;
+    return std::min(height / HALVING_INTERVAL, last);
+}
+
+Amount RewardCalculator::GetBlockSubsidy(int height) const {
+    int index = GetScheduleIndex(height);
+    return index < 0 ? 0 : schedule_[index].total;
 }
 
 RewardDistribution RewardCalculator::GetRewardDistribution(int height) const {
-    RewardDistribution dist;
-    dist.total = GetBlockSubsidy(height);
-    
-    // Calculate each component
-    dist.workReward = CalculatePercentage(dist.total, RewardPercentage::WORK_REWARD);
-    dist.ubiPool = CalculatePercentage(dist.total, RewardPercentage::UBI_POOL);
-    dist.contributions = CalculatePercentage(dist.total, RewardPercentage::CONTRIBUTIONS);
-    dist.ecosystem = CalculatePercentage(dist.total, RewardPercentage::ECOSYSTEM);
-    dist.stability = CalculatePercentage(dist.total, RewardPercentage::STABILITY);
-    
-    // Handle rounding - add any remainder to work reward
-    Amount sum = dist.workReward + dist.ubiPool + dist.contributions + 
-                 dist.ecosystem + dist.stability;
-    if (sum < dist.total) {
-        dist.workReward += (dist.total - sum);
-    }
-    
-    return dist;
+    int index = GetScheduleIndex(height);
+    return index < 0 ? RewardDistribution{} : schedule_[index];
 }
 
 Amount RewardCalculator::GetWorkReward(int height) const {
@@ -200,6 +228,37 @@ CoinbaseBuilder::CoinbaseBuilder(const RewardCalculator& calculator)
     : calculator_(calculator) {
 }
 
+CoinbaseBuilder::CoinbaseBuilder(const RewardCalculator& calculator,
+                                 const Hash160& ubiPoolAddress,
+                                 const Hash160& contributionsAddress,
+                                 const Hash160& ecosystemAddress,
+                                 const Hash160& stabilityAddress)
+    : calculator_(calculator) {
+    const auto& schedule = calculator_.GetRewardSchedule();
+    templates_.reserve(schedule.size());
+    
+    // Same layout as the six-address BuildCoinbase, with the miner output
+    // first and its script left empty
+    for (const auto& dist : schedule) {
+        Outputs outputs;
+        outputs.reserve(5);
+        outputs.emplace_back(std::vector<Byte>{}, dist.workReward);
+        if (dist.ubiPool > 0) {
+            outputs.emplace_back(MakeP2PKH(ubiPoolAddress), dist.ubiPool);
+        }
+        if (dist.contributions > 0) {
+            outputs.emplace_back(MakeP2PKH(contributionsAddress), dist.contributions);
+        }
+        if (dist.ecosystem > 0) {
+            outputs.emplace_back(MakeP2PKH(ecosystemAddress), dist.ecosystem);
+        }
+        if (dist.stability > 0) {
+            outputs.emplace_back(MakeP2PKH(stabilityAddress), dist.stability);
+        }
+        templates_.push_back(std::move(outputs));
+    }
+}
+
 std::vector<std::pair<std::vector<Byte>, Amount>> CoinbaseBuilder::BuildCoinbase(
     int height,
     const Hash160& minerAddress,
@@ -212,45 +271,46 @@ std::vector<std::pair<std::vector<Byte>, Amount>> CoinbaseBuilder::BuildCoinbase
     
     RewardDistribution dist = calculator_.GetRewardDistribution(height);
     
-    // Helper to create P2PKH script: OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG
-    auto makeP2PKH = [](const Hash160& addr) -> std::vector<Byte> {
-        std::vector<Byte> script;
-        script.reserve(25);
-        script.push_back(0x76); // OP_DUP
-        script.push_back(0xa9); // OP_HASH160
-        script.push_back(0x14); // Push 20 bytes
-        script.insert(script.end(), addr.begin(), addr.end());
-        script.push_back(0x88); // OP_EQUALVERIFY
-        script.push_back(0xac); // OP_CHECKSIG
-        return script;
-    };
-    
     // Work reward to miner
     if (dist.workReward > 0) {
-        outputs.emplace_back(makeP2PKH(minerAddress), dist.workReward);
+        outputs.emplace_back(MakeP2PKH(minerAddress), dist.workReward);
     }
     
     // UBI pool (uses same address for collection)
     if (dist.ubiPool > 0) {
-        outputs.emplace_back(makeP2PKH(ubiPoolAddress), dist.ubiPool);
+        outputs.emplace_back(MakeP2PKH(ubiPoolAddress), dist.ubiPool);
     }
     
     // Contributions reward - goes to the PoUW solution provider
     // This incentivizes providing useful computational work
     if (dist.contributions > 0) {
-        outputs.emplace_back(makeP2PKH(contributionsAddress), dist.contributions);
+        outputs.emplace_back(MakeP2PKH(contributionsAddress), dist.contributions);
     }
     
     // Ecosystem development
     if (dist.ecosystem > 0) {
-        outputs.emplace_back(makeP2PKH(ecosystemAddress), dist.ecosystem);
+        outputs.emplace_back(MakeP2PKH(ecosystemAddress), dist.ecosystem);
     }
     
     // Stability reserve
     if (dist.stability > 0) {
-        outputs.emplace_back(makeP2PKH(stabilityAddress), dist.stability);
+        outputs.emplace_back(MakeP2PKH(stabilityAddress), dist.stability);
+    }
+    
+    return outputs;
+}
+
+std::vector<std::pair<std::vector<Byte>, Amount>> CoinbaseBuilder::BuildCoinbase(
+    int height,
+    const Hash160& minerAddress
+) const {
+    int index = calculator_.GetScheduleIndex(height);
+    if (templates_.empty() || index < 0) {
+        return {};
     }
     
+    Outputs outputs = templates_[index];
+    outputs.front().first = MakeP2PKH(minerAddress);
     return outputs;
 }
 
@@ -258,6 +318,20 @@ bool CoinbaseBuilder::VerifyCoinbase(
     int height,
     const std::vector<std::pair<std::vector<Byte>, Amount>>& outputs
 ) const {
+    int index = calculator_.GetScheduleIndex(height);
+    if (!templates_.empty() && index >= 0) {
+        const Outputs& tmpl = templates_[index];
+        if (outputs.size() != tmpl.size()) {
+            return false;
+        }
+        // Miner output: any non-empty script, exact amount
+        if (outputs.front().first.empty() ||
+            outputs.front().second != tmpl.front().second) {
+            return false;
+        }
+        return std::equal(outputs.begin() + 1, outputs.end(), tmpl.begin() + 1);
+    }
+    
     RewardDistribution expected = calculator_.GetRewardDistribution(height);
     
     // Calculate total output amount
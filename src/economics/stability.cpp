@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
+#include <iterator>
 #include <numeric>
 #include <sstream>
 
@@ -121,54 +122,117 @@ TimeWeightedAveragePrice::TimeWeightedAveragePrice(std::chrono::seconds window)
     : window_(window) {
 }
 
+int64_t TimeWeightedAveragePrice::IntervalSeconds(const Sample& from, const Sample& to) {
+    auto duration = std::chrono::duration_cast<std::chrono::seconds>(
+        to.timestamp - from.timestamp
+    ).count();
+    return duration > 0 ? duration : 0;
+}
+
 void TimeWeightedAveragePrice::AddObservation(const PriceObservation& obs) {
-    observations_.push_back(obs);
+    Sample sample{obs.price, obs.timestamp};
+    if (!samples_.empty()) {
+        int64_t duration = IntervalSeconds(samples_.back(), sample);
+        weightedSum_ += samples_.back().price * duration;
+        durationSum_ += duration;
+    }
+    samples_.push_back(sample);
     Prune();
 }
 
 PriceMillicents TimeWeightedAveragePrice::Calculate() const {
-    if (observations_.empty()) {
+    if (samples_.empty()) {
         return 0;
     }
     
-    if (observations_.size() == 1) {
-        return observations_.front().price;
+    if (samples_.size() == 1) {
+        return samples_.front().price;
     }
     
-    // Calculate time-weighted average
-    int64_t totalWeightedPrice = 0;
-    int64_t totalDuration = 0;
-    
-    for (size_t i = 0; i < observations_.size() - 1; ++i) {
-        auto duration = std::chrono::duration_cast<std::chrono::seconds>(
-            observations_[i + 1].timestamp - observations_[i].timestamp
-        ).count();
-        
-        if (duration > 0) {
-            totalWeightedPrice += observations_[i].price * duration;
-            totalDuration += duration;
-        }
-    }
+    int64_t totalWeightedPrice = weightedSum_;
+    int64_t totalDuration = durationSum_;
     
     // Add the last observation with remaining time
     auto now = std::chrono::system_clock::now();
     auto lastDuration = std::chrono::duration_cast<std::chrono::seconds>(
-        now - observations_.back().timestamp
+        now - samples_.back().timestamp
     ).count();
     
     if (lastDuration > 0 && lastDuration < window_.count()) {
-        totalWeightedPrice += observations_.back().price * lastDuration;
+        totalWeightedPrice += samples_.back().price * lastDuration;
         totalDuration += lastDuration;
     }
     
-    return totalDuration > 0 ? totalWeightedPrice / totalDuration : observations_.back().price;
+    return totalDuration > 0 ? totalWeightedPrice / totalDuration : samples_.back().price;
 }
 
 void TimeWeightedAveragePrice::Prune() {
     auto cutoff = std::chrono::system_clock::now() - window_;
     
-    while (!observations_.empty() && observations_.front().timestamp < cutoff) {
-        observations_.pop_front();
+    while (!samples_.empty() && samples_.front().timestamp < cutoff) {
+        if (samples_.size() > 1) {
+            int64_t duration = IntervalSeconds(samples_[0], samples_[1]);
+            weightedSum_ -= samples_[0].price * duration;
+            durationSum_ -= duration;
+        }
+        samples_.pop_front();
+    }
+    if (samples_.size() < 2) {
+        weightedSum_ = 0;
+        durationSum_ = 0;
+    }
+}
+
+// ============================================================================
+// RollingMedian
+// ============================================================================
+
+void RollingMedian::Add(PriceMillicents value) {
+    if (!upper_.empty() && value < *upper_.begin()) {
+        lower_.insert(value);
+    } else {
+        upper_.insert(value);
+    }
+    Rebalance();
+}
+
+bool RollingMedian::Remove(PriceMillicents value) {
+    auto it = upper_.find(value);
+    if (it != upper_.end()) {
+        upper_.erase(it);
+    } else {
+        it = lower_.find(value);
+        if (it == lower_.end()) {
+            return false;
+        }
+        lower_.erase(it);
+    }
+    Rebalance();
+    return true;
+}
+
+std::optional<PriceMillicents> RollingMedian::Median() const {
+    if (upper_.empty()) {
+        return std::nullopt;
+    }
+    return *upper_.begin();
+}
+
+void RollingMedian::Clear() {
+    lower_.clear();
+    upper_.clear();
+}
+
+void RollingMedian::Rebalance() {
+    size_t wantLower = Size() / 2;
+    while (lower_.size() > wantLower) {
+        auto last = std::prev(lower_.end());
+        upper_.insert(*last);
+        lower_.erase(last);
+    }
+    while (lower_.size() < wantLower) {
+        lower_.insert(*upper_.begin());
+        upper_.erase(upper_.begin());
     }
 }
 
@@ -10,6 +10,7 @@
 #include <chrono>
 #include <cstring>
 #include <iomanip>
+#include <ios>
 #include <sstream>
 
 namespace shurium {
@@ -570,6 +571,8 @@ void Treasury::AddFunds(Amount amount, TreasuryCategory category) {
     
     balance_ += amount;
     categoryBalances_[category] += amount;
+    periodReceived_ += amount;
+    cachedReport_.reset();
 }
 
 Amount Treasury::GetCategoryBalance(TreasuryCategory category) const {
@@ -601,7 +604,10 @@ bool Treasury::CanSpend(Amount amount, TreasuryCategory category) const {
 
 bool Treasury::ExecuteSpending(const ProposalId& proposalId) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
+    return ExecuteSpendingLocked(proposalId);
+}
+
+bool Treasury::ExecuteSpendingLocked(const ProposalId& proposalId) {
     auto it = proposals_.find(proposalId);
     if (it == proposals_.end()) {
         return false;
@@ -614,7 +620,7 @@ bool Treasury::ExecuteSpending(const ProposalId& proposalId) {
     }
     
     if (proposal.requestedAmount > balance_) {
-        proposal.status = ProposalStatus::Failed;
+        SetProposalStatus(proposal, ProposalStatus::Failed);
         return false;
     }
     
@@ -632,7 +638,7 @@ bool Treasury::ExecuteSpending(const ProposalId& proposalId) {
     // Record in budget
     currentBudget_.RecordSpending(proposal.category, proposal.requestedAmount);
     
-    proposal.status = ProposalStatus::Executed;
+    SetProposalStatus(proposal, ProposalStatus::Executed);
     return true;
 }
 
@@ -663,7 +669,6 @@ std::optional<ProposalId> Treasury::SubmitProposal(
     // Set proposal fields
     proposal.id = proposal.CalculateHash();
     proposal.deposit = deposit;
-    proposal.status = ProposalStatus::Voting;
     proposal.submitHeight = currentHeight;
     proposal.votingStartHeight = currentHeight;
     proposal.votingEndHeight = currentHeight + PROPOSAL_VOTING_PERIOD;
@@ -685,7 +690,15 @@ std::optional<ProposalId> Treasury::SubmitProposal(
         proposal.totalVotingPower = MIN_PROPOSAL_AMOUNT;
     }
     
+    // A resubmission replaces the stored proposal, so leave its old status
+    auto existing = proposals_.find(proposal.id);
+    if (existing != proposals_.end()) {
+        proposalsByStatus_[existing->second.status].erase(proposal.id);
+    }
+    proposal.status = ProposalStatus::Voting;
+    proposalsByStatus_[proposal.status].insert(proposal.id);
     proposals_[proposal.id] = proposal;
+    cachedReport_.reset();
     
     return proposal.id;
 }
@@ -707,11 +720,9 @@ bool Treasury::SubmitVote(const TreasuryVote& vote, int currentHeight) {
     }
     
     // Check not already voted
-    auto& proposalVotes = votes_[vote.proposalId];
-    for (const auto& v : proposalVotes) {
-        if (v.voter == vote.voter) {
-            return false; // Already voted
-        }
+    auto& proposalVoters = voters_[vote.proposalId];
+    if (proposalVoters.count(vote.voter)) {
+        return false; // Already voted
     }
     
     // Verify signature
@@ -720,7 +731,8 @@ bool Treasury::SubmitVote(const TreasuryVote& vote, int currentHeight) {
     }
     
     // Record vote
-    proposalVotes.push_back(vote);
+    votes_[vote.proposalId].push_back(vote);
+    proposalVoters.insert(vote.voter);
     
     // Update proposal vote counts
     if (vote.inFavor) {
@@ -748,10 +760,20 @@ std::vector<const TreasuryProposal*> Treasury::GetProposals(
     std::lock_guard<std::mutex> lock(mutex_);
     
     std::vector<const TreasuryProposal*> result;
-    for (const auto& [id, proposal] : proposals_) {
-        if (!status || proposal.status == *status) {
+    if (!status) {
+        result.reserve(proposals_.size());
+        for (const auto& [id, proposal] : proposals_) {
             result.push_back(&proposal);
         }
+        return result;
+    }
+    
+    auto indexIt = proposalsByStatus_.find(*status);
+    if (indexIt != proposalsByStatus_.end()) {
+        result.reserve(indexIt->second.size());
+        for (const ProposalId& id : indexIt->second) {
+            result.push_back(&proposals_.at(id));
+        }
     }
     return result;
 }
@@ -760,7 +782,12 @@ std::vector<const TreasuryProposal*> Treasury::GetActiveProposals(int currentHei
     std::lock_guard<std::mutex> lock(mutex_);
     
     std::vector<const TreasuryProposal*> result;
-    for (const auto& [id, proposal] : proposals_) {
+    auto indexIt = proposalsByStatus_.find(ProposalStatus::Voting);
+    if (indexIt == proposalsByStatus_.end()) {
+        return result;
+    }
+    for (const ProposalId& id : indexIt->second) {
+        const TreasuryProposal& proposal = proposals_.at(id);
         if (proposal.IsVotingActive(currentHeight)) {
             result.push_back(&proposal);
         }
@@ -787,7 +814,7 @@ bool Treasury::CancelProposal(const ProposalId& id, const PublicKey& proposer) {
         return false;
     }
     
-    proposal.status = ProposalStatus::Cancelled;
+    SetProposalStatus(proposal, ProposalStatus::Cancelled);
     return true;
 }
 
@@ -804,17 +831,8 @@ std::vector<TreasuryVote> Treasury::GetVotes(const ProposalId& proposalId) const
 bool Treasury::HasVoted(const ProposalId& proposalId, const PublicKey& voter) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = votes_.find(proposalId);
-    if (it == votes_.end()) {
-        return false;
-    }
-    
-    for (const auto& vote : it->second) {
-        if (vote.voter == voter) {
-            return true;
-        }
-    }
-    return false;
+    auto it = voters_.find(proposalId);
+    return it != voters_.end() && it->second.count(voter) > 0;
 }
 
 uint64_t Treasury::GetVotingPower(const PublicKey& key) const {
@@ -835,9 +853,14 @@ void Treasury::SetTotalVotingPowerCalculator(TotalVotingPowerCalculator calculat
 void Treasury::ProcessBlock(int height) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    // Update proposal statuses
-    for (auto& [id, proposal] : proposals_) {
-        UpdateProposalStatus(proposal, height);
+    // Update proposal statuses; only proposals still voting can change,
+    // and the index is copied because updates move them out of it
+    auto voting = proposalsByStatus_.find(ProposalStatus::Voting);
+    if (voting != proposalsByStatus_.end()) {
+        std::vector<ProposalId> ids(voting->second.begin(), voting->second.end());
+        for (const ProposalId& id : ids) {
+            UpdateProposalStatus(proposals_.at(id), height);
+        }
     }
     
     // Execute approved proposals
@@ -853,6 +876,8 @@ void Treasury::ProcessBlock(int height) {
 void Treasury::StartNewPeriod(int height) {
     std::lock_guard<std::mutex> lock(mutex_);
     currentBudget_.Initialize(balance_, height, TREASURY_REPORT_INTERVAL);
+    periodReceived_ = 0;
+    cachedReport_.reset();
 }
 
 void Treasury::SetMultiSigConfig(const MultiSigConfig& config) {
@@ -924,6 +949,7 @@ bool Treasury::EmergencyWithdraw(
     
     // Execute withdrawal
     balance_ -= amount;
+    cachedReport_.reset();
     
     return true;
 }
@@ -931,26 +957,38 @@ bool Treasury::EmergencyWithdraw(
 Treasury::Report Treasury::GenerateReport(int height) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
+    if (cachedReport_ && cachedReport_->height == height) {
+        return *cachedReport_;
+    }
+    
     Report report;
     report.timestamp = std::chrono::system_clock::now();
     report.height = height;
     report.totalBalance = balance_;
     report.categoryBalances = categoryBalances_;
     
-    // Count proposals
-    for (const auto& [id, proposal] : proposals_) {
-        if (proposal.IsVotingActive(height)) {
-            report.activeProposals++;
+    // Count proposals from the status index
+    auto voting = proposalsByStatus_.find(ProposalStatus::Voting);
+    if (voting != proposalsByStatus_.end()) {
+        for (const ProposalId& id : voting->second) {
+            if (proposals_.at(id).IsVotingActive(height)) {
+                report.activeProposals++;
+            }
         }
-        if (proposal.status == ProposalStatus::Executed &&
-            proposal.executionHeight >= currentBudget_.periodStart) {
-            report.executedProposals++;
+    }
+    auto executed = proposalsByStatus_.find(ProposalStatus::Executed);
+    if (executed != proposalsByStatus_.end()) {
+        for (const ProposalId& id : executed->second) {
+            if (proposals_.at(id).executionHeight >= currentBudget_.periodStart) {
+                report.executedProposals++;
+            }
         }
     }
     
-    report.periodReceived = 0; // Would need tracking
+    report.periodReceived = periodReceived_;
     report.periodSpent = currentBudget_.TotalSpent();
     
+    cachedReport_ = report;
     return report;
 }
 
@@ -966,47 +1004,248 @@ std::string Treasury::Report::ToString() const {
     return ss.str();
 }
 
+namespace {
+
+// Full treasury state (version 0x02). Proposals are written field by field
+// because TreasuryProposal::Serialize leaves out what a restore needs
+// (proposer, deposit, execution height, milestones).
+
+void WritePublicKey(DataStream& ss, const PublicKey& key) {
+    Serialize(ss, key.ToVector());
+}
+
+PublicKey ReadPublicKey(SpanReader& ss) {
+    std::vector<Byte> bytes;
+    Unserialize(ss, bytes);
+    return bytes.empty() ? PublicKey() : PublicKey(bytes.data(), bytes.size());
+}
+
+void WriteProposalState(DataStream& ss, const TreasuryProposal& proposal) {
+    Serialize(ss, proposal.id);
+    Serialize(ss, proposal.title);
+    Serialize(ss, proposal.description);
+    ser_writedata8(ss, static_cast<uint8_t>(proposal.category));
+    Serialize(ss, static_cast<int64_t>(proposal.requestedAmount));
+    Serialize(ss, proposal.recipient);
+    WritePublicKey(ss, proposal.proposer);
+    Serialize(ss, static_cast<int64_t>(proposal.deposit));
+    ser_writedata8(ss, static_cast<uint8_t>(proposal.status));
+    Serialize(ss, static_cast<int32_t>(proposal.submitHeight));
+    Serialize(ss, static_cast<int32_t>(proposal.votingStartHeight));
+    Serialize(ss, static_cast<int32_t>(proposal.votingEndHeight));
+    Serialize(ss, static_cast<int32_t>(proposal.executionHeight));
+    Serialize(ss, proposal.votesFor);
+    Serialize(ss, proposal.votesAgainst);
+    Serialize(ss, proposal.totalVotingPower);
+    Serialize(ss, proposal.url);
+    WriteCompactSize(ss, proposal.milestones.size());
+    for (const auto& milestone : proposal.milestones) {
+        Serialize(ss, milestone.description);
+        Serialize(ss, static_cast<int64_t>(milestone.amount));
+        Serialize(ss, static_cast<int32_t>(milestone.releaseHeight));
+        Serialize(ss, milestone.released);
+    }
+}
+
+TreasuryProposal ReadProposalState(SpanReader& ss) {
+    TreasuryProposal proposal;
+    int64_t amount = 0;
+    int32_t height = 0;
+    Unserialize(ss, proposal.id);
+    Unserialize(ss, proposal.title);
+    Unserialize(ss, proposal.description);
+    proposal.category = static_cast<TreasuryCategory>(ser_readdata8(ss));
+    Unserialize(ss, amount);
+    proposal.requestedAmount = amount;
+    Unserialize(ss, proposal.recipient);
+    proposal.proposer = ReadPublicKey(ss);
+    Unserialize(ss, amount);
+    proposal.deposit = amount;
+    proposal.status = static_cast<ProposalStatus>(ser_readdata8(ss));
+    Unserialize(ss, height);
+    proposal.submitHeight = height;
+    Unserialize(ss, height);
+    proposal.votingStartHeight = height;
+    Unserialize(ss, height);
+    proposal.votingEndHeight = height;
+    Unserialize(ss, height);
+    proposal.executionHeight = height;
+    Unserialize(ss, proposal.votesFor);
+    Unserialize(ss, proposal.votesAgainst);
+    Unserialize(ss, proposal.totalVotingPower);
+    Unserialize(ss, proposal.url);
+    uint64_t milestoneCount = ReadCompactSize(ss);
+    for (uint64_t i = 0; i < milestoneCount; ++i) {
+        TreasuryProposal::Milestone milestone;
+        Unserialize(ss, milestone.description);
+        Unserialize(ss, amount);
+        milestone.amount = amount;
+        Unserialize(ss, height);
+        milestone.releaseHeight = height;
+        Unserialize(ss, milestone.released);
+        proposal.milestones.push_back(std::move(milestone));
+    }
+    return proposal;
+}
+
+} // anonymous namespace
+
 std::vector<Byte> Treasury::Serialize() const {
     std::lock_guard<std::mutex> lock(mutex_);
+    DataStream ss;
     
-    std::vector<Byte> data;
-    
-    // Version byte for future compatibility
-    data.push_back(0x01);
+    // Version byte (0x01 held balances only)
+    ser_writedata8(ss, 0x02);
     
-    // Serialize balance (8 bytes, little-endian)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back(static_cast<Byte>((balance_ >> (i * 8)) & 0xFF));
+    // Balances
+    shurium::Serialize(ss, static_cast<int64_t>(balance_));
+    WriteCompactSize(ss, categoryBalances_.size());
+    for (const auto& [category, amount] : categoryBalances_) {
+        ser_writedata8(ss, static_cast<uint8_t>(category));
+        shurium::Serialize(ss, static_cast<int64_t>(amount));
     }
     
-    // Serialize category balances
-    uint32_t numCategories = static_cast<uint32_t>(categoryBalances_.size());
-    for (int i = 0; i < 4; ++i) {
-        data.push_back(static_cast<Byte>((numCategories >> (i * 8)) & 0xFF));
+    // Proposals
+    WriteCompactSize(ss, proposals_.size());
+    for (const auto& [id, proposal] : proposals_) {
+        WriteProposalState(ss, proposal);
     }
     
-    for (const auto& [category, amount] : categoryBalances_) {
-        // Category as uint8_t
-        data.push_back(static_cast<Byte>(category));
-        // Amount as 8 bytes
-        for (int i = 0; i < 8; ++i) {
-            data.push_back(static_cast<Byte>((amount >> (i * 8)) & 0xFF));
+    // Votes
+    WriteCompactSize(ss, votes_.size());
+    for (const auto& [proposalId, votes] : votes_) {
+        shurium::Serialize(ss, proposalId);
+        WriteCompactSize(ss, votes.size());
+        for (const auto& vote : votes) {
+            shurium::Serialize(ss, vote.Serialize());
         }
     }
     
-    // Serialize proposal count (for state tracking, actual proposals stored separately)
-    uint32_t numProposals = static_cast<uint32_t>(proposals_.size());
-    for (int i = 0; i < 4; ++i) {
-        data.push_back(static_cast<Byte>((numProposals >> (i * 8)) & 0xFF));
+    // Budget
+    shurium::Serialize(ss, static_cast<int32_t>(currentBudget_.periodStart));
+    shurium::Serialize(ss, static_cast<int32_t>(currentBudget_.periodEnd));
+    shurium::Serialize(ss, static_cast<int64_t>(currentBudget_.totalBalance));
+    WriteCompactSize(ss, currentBudget_.categories.size());
+    for (const auto& [category, budget] : currentBudget_.categories) {
+        ser_writedata8(ss, static_cast<uint8_t>(category));
+        shurium::Serialize(ss, static_cast<int64_t>(budget.allocated));
+        shurium::Serialize(ss, static_cast<int64_t>(budget.spent));
     }
     
-    // Note: Full proposal serialization would include all proposal data
-    // For production, each proposal would be serialized with its full state
+    // Multi-sig configuration (written here rather than with
+    // MultiSigConfig::Serialize, which expects totalSigners keys)
+    shurium::Serialize(ss, static_cast<int32_t>(multiSigConfig_.standardThreshold));
+    shurium::Serialize(ss, static_cast<int32_t>(multiSigConfig_.largeThreshold));
+    shurium::Serialize(ss, static_cast<int32_t>(multiSigConfig_.emergencyThreshold));
+    shurium::Serialize(ss, static_cast<int32_t>(multiSigConfig_.totalSigners));
+    WriteCompactSize(ss, multiSigConfig_.signers.size());
+    for (const auto& signer : multiSigConfig_.signers) {
+        WritePublicKey(ss, signer);
+    }
     
-    return data;
+    return std::vector<Byte>(ss.begin(), ss.end());
 }
 
 bool Treasury::Deserialize(const Byte* data, size_t len) {
+    if (!data || len == 0) {
+        return false;
+    }
+    if (data[0] == 0x01) {
+        return DeserializeBalances(data, len);
+    }
+    if (data[0] != 0x02) {
+        return false;  // Unsupported version
+    }
+    
+    Amount balance = 0;
+    std::map<TreasuryCategory, Amount> categoryBalances;
+    std::map<ProposalId, TreasuryProposal> proposals;
+    std::map<ProposalId, std::vector<TreasuryVote>> votes;
+    TreasuryBudget budget;
+    MultiSigConfig multiSig;
+    try {
+        SpanReader ss(data + 1, len - 1);
+        int64_t amount = 0;
+        int32_t number = 0;
+        
+        Unserialize(ss, amount);
+        balance = amount;
+        uint64_t count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            auto category = static_cast<TreasuryCategory>(ser_readdata8(ss));
+            Unserialize(ss, amount);
+            categoryBalances[category] = amount;
+        }
+        
+        count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            TreasuryProposal proposal = ReadProposalState(ss);
+            proposals[proposal.id] = std::move(proposal);
+        }
+        
+        count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            ProposalId proposalId;
+            Unserialize(ss, proposalId);
+            uint64_t voteCount = ReadCompactSize(ss);
+            auto& proposalVotes = votes[proposalId];
+            for (uint64_t j = 0; j < voteCount; ++j) {
+                std::vector<Byte> bytes;
+                Unserialize(ss, bytes);
+                auto vote = TreasuryVote::Deserialize(bytes.data(), bytes.size());
+                if (!vote) {
+                    return false;
+                }
+                proposalVotes.push_back(std::move(*vote));
+            }
+        }
+        
+        Unserialize(ss, number);
+        budget.periodStart = number;
+        Unserialize(ss, number);
+        budget.periodEnd = number;
+        Unserialize(ss, amount);
+        budget.totalBalance = amount;
+        count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            CategoryBudget category;
+            category.category = static_cast<TreasuryCategory>(ser_readdata8(ss));
+            Unserialize(ss, amount);
+            category.allocated = amount;
+            Unserialize(ss, amount);
+            category.spent = amount;
+            budget.categories[category.category] = category;
+        }
+        
+        Unserialize(ss, number);
+        multiSig.standardThreshold = number;
+        Unserialize(ss, number);
+        multiSig.largeThreshold = number;
+        Unserialize(ss, number);
+        multiSig.emergencyThreshold = number;
+        Unserialize(ss, number);
+        multiSig.totalSigners = number;
+        count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            multiSig.signers.push_back(ReadPublicKey(ss));
+        }
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    balance_ = balance;
+    categoryBalances_ = std::move(categoryBalances);
+    proposals_ = std::move(proposals);
+    votes_ = std::move(votes);
+    currentBudget_ = std::move(budget);
+    multiSigConfig_ = std::move(multiSig);
+    periodReceived_ = 0;
+    RebuildIndexes();
+    return true;
+}
+
+bool Treasury::DeserializeBalances(const Byte* data, size_t len) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (!data || len < 13) {  // Minimum: version(1) + balance(8) + numCategories(4)
@@ -1047,6 +1286,7 @@ bool Treasury::Deserialize(const Byte* data, size_t len) {
         }
         categoryBalances_[category] = amount;
     }
+    cachedReport_.reset();
     
     // Deserialize proposal count
     if (offset + 4 > len) {
@@ -1069,30 +1309,62 @@ void Treasury::UpdateProposalStatus(TreasuryProposal& proposal, int currentHeigh
         if (currentHeight > proposal.votingEndHeight) {
             // Voting ended
             if (proposal.IsPassed()) {
-                proposal.status = ProposalStatus::Approved;
+                SetProposalStatus(proposal, ProposalStatus::Approved);
             } else if (!proposal.HasQuorum()) {
-                proposal.status = ProposalStatus::Expired;
+                SetProposalStatus(proposal, ProposalStatus::Expired);
             } else {
-                proposal.status = ProposalStatus::Rejected;
+                SetProposalStatus(proposal, ProposalStatus::Rejected);
             }
         }
     }
 }
 
+void Treasury::SetProposalStatus(TreasuryProposal& proposal, ProposalStatus status) {
+    if (proposal.status == status) {
+        return;
+    }
+    proposalsByStatus_[proposal.status].erase(proposal.id);
+    proposalsByStatus_[status].insert(proposal.id);
+    proposal.status = status;
+    cachedReport_.reset();
+}
+
+void Treasury::RebuildIndexes() {
+    proposalsByStatus_.clear();
+    for (const auto& [id, proposal] : proposals_) {
+        proposalsByStatus_[proposal.status].insert(id);
+    }
+    voters_.clear();
+    for (const auto& [id, proposalVotes] : votes_) {
+        auto& proposalVoters = voters_[id];
+        for (const auto& vote : proposalVotes) {
+            proposalVoters.insert(vote.voter);
+        }
+    }
+    cachedReport_.reset();
+}
+
 void Treasury::ExecuteApprovedProposals(int currentHeight) {
-    for (auto& [id, proposal] : proposals_) {
-        if (proposal.IsReadyForExecution(currentHeight)) {
-            ExecuteSpending(id);
+    // Called with mutex_ held; executing moves proposals out of the index
+    auto approved = proposalsByStatus_.find(ProposalStatus::Approved);
+    if (approved == proposalsByStatus_.end()) {
+        return;
+    }
+    std::vector<ProposalId> ids(approved->second.begin(), approved->second.end());
+    for (const ProposalId& id : ids) {
+        if (proposals_.at(id).IsReadyForExecution(currentHeight)) {
+            ExecuteSpendingLocked(id);
         }
     }
 }
 
 void Treasury::ProcessMilestones(int currentHeight) {
-    for (auto& [id, proposal] : proposals_) {
-        if (proposal.status != ProposalStatus::Executed) {
-            continue;
-        }
-        
+    auto executed = proposalsByStatus_.find(ProposalStatus::Executed);
+    if (executed == proposalsByStatus_.end()) {
+        return;
+    }
+    for (const ProposalId& id : executed->second) {
+        TreasuryProposal& proposal = proposals_.at(id);
         for (auto& milestone : proposal.milestones) {
             if (!milestone.released && currentHeight >= milestone.releaseHeight) {
                 // Release milestone funds
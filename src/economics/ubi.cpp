@@ -5,6 +5,7 @@
 #include <shurium/economics/ubi.h>
 #include <shurium/crypto/sha256.h>
 #include <shurium/crypto/field.h>
+#include <shurium/db/database.h>
 
 #include <algorithm>
 #include <chrono>
@@ -249,12 +250,7 @@ void EpochUBIPool::Finalize(uint32_t identityCount) {
     isFinalized = true;
 }
 
-bool EpochUBIPool::IsNullifierUsed(const identity::Nullifier& nullifier) const {
-    return usedNullifiers.find(nullifier) != usedNullifiers.end();
-}
-
-void EpochUBIPool::RecordClaim(const identity::Nullifier& nullifier, Amount amount) {
-    usedNullifiers.insert(nullifier);
+void EpochUBIPool::RecordClaim(Amount amount) {
     amountClaimed += amount;
     claimCount++;
 }
@@ -295,8 +291,33 @@ std::string EpochUBIPool::ToString() const {
 // UBIDistributor
 // ============================================================================
 
+namespace {
+
+// A pool must be pruned only once its claim deadline has passed
+static_assert(static_cast<int>(UBI_HOT_EPOCHS) * EPOCH_BLOCKS >
+              UBI_CLAIM_WINDOW + (UBI_GRACE_EPOCHS + 1) * EPOCH_BLOCKS,
+              "UBI hot window shorter than the claim period");
+
+identity::NullifierSet::Config UsedNullifierConfig() {
+    identity::NullifierSet::Config config;
+    config.maxEpochHistory = UBI_HOT_EPOCHS;
+    return config;
+}
+
+} // anonymous namespace
+
 UBIDistributor::UBIDistributor(const RewardCalculator& calculator)
-    : calculator_(calculator) {
+    : calculator_(calculator),
+      usedNullifiers_(std::make_unique<identity::NullifierSet>(UsedNullifierConfig())) {
+}
+
+UBIDistributor::UBIDistributor(const RewardCalculator& calculator,
+                               std::unique_ptr<db::Database> nullifierDb)
+    : calculator_(calculator),
+      usedNullifiers_(std::make_unique<identity::NullifierSet>(UsedNullifierConfig(),
+                                                               std::move(nullifierDb))),
+      persistentNullifiers_(true) {
+    latestEpoch_ = usedNullifiers_->GetCurrentEpoch();
 }
 
 UBIDistributor::~UBIDistributor() = default;
@@ -323,6 +344,9 @@ void UBIDistributor::AddBlockReward(int height, Amount amount) {
     }
     
     currentEpoch_ = epoch;
+    if (epoch > latestEpoch_) {
+        AdvanceLatestEpoch(epoch);
+    }
     
     EpochUBIPool& pool = GetOrCreatePool(epoch);
     pool.totalPool += amount;
@@ -340,6 +364,15 @@ void UBIDistributor::FinalizeEpoch(EpochId epoch, uint32_t identityCount) {
     pool.endHeight = EpochEndHeight(epoch);
     pool.claimDeadline = pool.endHeight + UBI_CLAIM_WINDOW + (UBI_GRACE_EPOCHS * EPOCH_BLOCKS);
     pool.Finalize(identityCount);
+    
+    if (epochFinalizedCallback_) {
+        epochFinalizedCallback_(pool);
+    }
+}
+
+void UBIDistributor::SetEpochFinalizedCallback(EpochFinalizedCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    epochFinalizedCallback_ = std::move(callback);
 }
 
 const EpochUBIPool* UBIDistributor::GetPool(EpochId epoch) const {
@@ -360,108 +393,250 @@ Amount UBIDistributor::GetAmountPerPerson(EpochId epoch) const {
     return pool->amountPerPerson;
 }
 
-ClaimStatus UBIDistributor::ProcessClaim(
-    UBIClaim& claim,
-    const Hash256& identityTreeRoot,
-    int currentHeight
-) {
-    std::lock_guard<std::mutex> lock(mutex_);
+namespace {
+
+/// Checks of a UBI claim's proof short of verifying it: structure, type
+/// and public inputs
+bool CheckClaimInputs(const UBIClaim& claim, const FieldElement& expectedRoot) {
+    // First, check structural validity
+    if (!claim.proof.IsValid()) {
+        return false;
+    }
     
-    claim.submitHeight = currentHeight;
+    // Verify the proof type is UBI claim
+    if (claim.proof.GetType() != identity::ProofType::UBIClaim) {
+        return false;
+    }
+    
+    // Verify the proof's public inputs include the correct identity tree root
+    // Public inputs for UBI claim proof should be:
+    // [0] = identity tree root
+    // [1] = nullifier hash  
+    // [2] = epoch
+    const auto& publicInputs = claim.proof.GetPublicInputs();
+    if (publicInputs.Count() < 3) {
+        return false;
+    }
+    
+    // Verify the root in public inputs matches expected identity tree root
+    if (publicInputs.values[0] != expectedRoot) {
+        return false;
+    }
+    
+    // Verify the epoch in public inputs matches claim epoch
+    FieldElement expectedEpoch(static_cast<uint64_t>(claim.epoch));
+    if (publicInputs.values[2] != expectedEpoch) {
+        return false;
+    }
     
+    return true;
+}
+
+/// All proof checks of a UBI claim. Reads nothing from the distributor,
+/// so claims can be checked concurrently.
+bool CheckClaimProof(const UBIClaim& claim, const FieldElement& expectedRoot) {
+    // Verify the ZK proof itself using the UBI claim circuit
+    return CheckClaimInputs(claim, expectedRoot) &&
+           identity::ProofVerifier::Instance().Verify(claim.proof, "ubi_claim");
+}
+
+/// CheckClaimProof over claims[indices[k]] for each k, the proofs verified
+/// as one batch
+std::vector<char> CheckClaimProofs(const std::vector<UBIClaim>& claims,
+                                   const std::vector<size_t>& indices,
+                                   const FieldElement& expectedRoot,
+                                   util::ThreadPool* pool) {
+    std::vector<char> ok(indices.size(), 0);
+    std::vector<size_t> positions;
+    std::vector<const identity::ZKProof*> proofs;
+    for (size_t k = 0; k < indices.size(); ++k) {
+        const UBIClaim& claim = claims[indices[k]];
+        if (CheckClaimInputs(claim, expectedRoot)) {
+            positions.push_back(k);
+            proofs.push_back(&claim.proof);
+        }
+    }
+    
+    std::vector<bool> valid =
+        identity::ProofVerifier::Instance().VerifyBatch(proofs, "ubi_claim", pool);
+    for (size_t j = 0; j < positions.size(); ++j) {
+        ok[positions[j]] = valid[j];
+    }
+    return ok;
+}
+
+} // anonymous namespace
+
+ClaimStatus UBIDistributor::CheckClaimAgainstPool(const UBIClaim& claim, int currentHeight) const {
     // Check if epoch pool exists
     auto it = pools_.find(claim.epoch);
     if (it == pools_.end()) {
-        claim.status = ClaimStatus::EpochNotComplete;
-        return claim.status;
+        return ClaimStatus::EpochNotComplete;
     }
     
-    EpochUBIPool& pool = it->second;
+    const EpochUBIPool& pool = it->second;
     
     // Check if epoch is finalized
     if (!pool.isFinalized) {
-        claim.status = ClaimStatus::EpochNotComplete;
-        return claim.status;
+        return ClaimStatus::EpochNotComplete;
     }
     
     // Check if still accepting claims
     if (!pool.AcceptingClaims(currentHeight)) {
-        claim.status = ClaimStatus::EpochExpired;
-        return claim.status;
+        return ClaimStatus::EpochExpired;
     }
     
     // Check pool has funds
     if (pool.amountPerPerson == 0) {
-        claim.status = ClaimStatus::PoolEmpty;
-        return claim.status;
+        return ClaimStatus::PoolEmpty;
     }
     
     // Check for double-claim
-    if (pool.IsNullifierUsed(claim.nullifier)) {
-        claim.status = ClaimStatus::DoubleClaim;
-        return claim.status;
+    if (usedNullifiers_->Contains(claim.nullifier.GetHash(), claim.epoch)) {
+        return ClaimStatus::DoubleClaim;
     }
     
-    // Verify the ZK proof using the ProofVerifier
-    // The proof must demonstrate knowledge of identity secrets and membership
-    // in the identity tree with root `identityTreeRoot`
-    identity::ProofVerifier& verifier = identity::ProofVerifier::Instance();
-    
-    // First, check structural validity
-    if (!claim.proof.IsValid()) {
-        claim.status = ClaimStatus::InvalidProof;
-        return claim.status;
-    }
+    return ClaimStatus::Valid;
+}
+
+ClaimStatus UBIDistributor::RecordClaimLocked(UBIClaim& claim) {
+    // Stored under the claim's epoch, whatever epoch the nullifier carries
+    identity::Nullifier key(claim.nullifier.GetHash(), claim.epoch);
+    switch (usedNullifiers_->Add(key)) {
+        case identity::NullifierSet::AddResult::Success:
+            break;
+        case identity::NullifierSet::AddResult::AlreadyExists:
+            return ClaimStatus::DoubleClaim;
+        case identity::NullifierSet::AddResult::InvalidEpoch:
+            return ClaimStatus::EpochExpired;
+        default:
+            // Not stored, so not paid; the claim can be submitted again
+            return ClaimStatus::Pending;
+    }
+    
+    EpochUBIPool& pool = pools_.at(claim.epoch);
+    claim.amount = pool.amountPerPerson;
+    pool.RecordClaim(claim.amount);
+    totalDistributed_ += claim.amount;
+    totalClaims_++;
+    return ClaimStatus::Valid;
+}
+
+ClaimStatus UBIDistributor::ProcessClaim(
+    UBIClaim& claim,
+    const Hash256& identityTreeRoot,
+    int currentHeight
+) {
+    std::lock_guard<std::mutex> lock(mutex_);
     
-    // Verify the proof type is UBI claim
-    if (claim.proof.GetType() != identity::ProofType::UBIClaim) {
-        claim.status = ClaimStatus::InvalidProof;
-        return claim.status;
-    }
+    claim.submitHeight = currentHeight;
     
-    // Verify the proof's public inputs include the correct identity tree root
-    // Public inputs for UBI claim proof should be:
-    // [0] = identity tree root
-    // [1] = nullifier hash  
-    // [2] = epoch
-    const auto& publicInputs = claim.proof.GetPublicInputs();
-    if (publicInputs.Count() < 3) {
-        claim.status = ClaimStatus::InvalidProof;
+    claim.status = CheckClaimAgainstPool(claim, currentHeight);
+    if (claim.status != ClaimStatus::Valid) {
         return claim.status;
     }
     
-    // Convert identity tree root (Hash256) to FieldElement for comparison
+    // The proof must demonstrate knowledge of identity secrets and membership
+    // in the identity tree with root `identityTreeRoot`
     FieldElement expectedRoot = FieldElement::FromBytes(identityTreeRoot.data(), identityTreeRoot.size());
-    
-    // Verify the root in public inputs matches expected identity tree root
-    if (publicInputs.values[0] != expectedRoot) {
+    if (!CheckClaimProof(claim, expectedRoot)) {
         claim.status = ClaimStatus::InvalidProof;
         return claim.status;
     }
     
-    // Verify the epoch in public inputs matches claim epoch
-    FieldElement expectedEpoch(static_cast<uint64_t>(claim.epoch));
-    if (publicInputs.values[2] != expectedEpoch) {
-        claim.status = ClaimStatus::InvalidProof;
-        return claim.status;
+    // Claim is valid!
+    claim.status = RecordClaimLocked(claim);
+    return claim.status;
+}
+
+std::vector<ClaimStatus> UBIDistributor::ProcessClaims(
+    std::vector<UBIClaim>& claims,
+    const Hash256& identityTreeRoot,
+    int currentHeight,
+    util::ThreadPool* pool
+) {
+    // Claims that pass the pool checks, grouped by nullifier in batch order
+    std::vector<std::vector<size_t>> groups;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<identity::Nullifier, size_t> groupOf;
+        for (size_t i = 0; i < claims.size(); ++i) {
+            UBIClaim& claim = claims[i];
+            claim.submitHeight = currentHeight;
+            claim.status = CheckClaimAgainstPool(claim, currentHeight);
+            if (claim.status != ClaimStatus::Valid) {
+                continue;
+            }
+            claim.status = ClaimStatus::Pending;
+            auto inserted = groupOf.emplace(claim.nullifier, groups.size());
+            if (inserted.second) {
+                groups.emplace_back();
+            }
+            groups[inserted.first->second].push_back(i);
+        }
     }
     
-    // Verify the ZK proof itself using the UBI claim circuit
-    if (!verifier.Verify(claim.proof, "ubi_claim")) {
-        claim.status = ClaimStatus::InvalidProof;
-        return claim.status;
+    // Check the first claim of each group. One that fails is InvalidProof
+    // and the next claim with its nullifier is checked in the following
+    // round, as it would be if the claims came one at a time.
+    FieldElement expectedRoot = FieldElement::FromBytes(identityTreeRoot.data(), identityTreeRoot.size());
+    std::vector<size_t> cursor(groups.size(), 0);
+    std::vector<size_t> open(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+        open[g] = g;
+    }
+    std::vector<std::pair<size_t, size_t>> accepted;  // (claim, group)
+    while (!open.empty()) {
+        std::vector<size_t> round;
+        round.reserve(open.size());
+        for (size_t g : open) {
+            round.push_back(groups[g][cursor[g]]);
+        }
+        std::vector<char> ok = CheckClaimProofs(claims, round, expectedRoot, pool);
+        
+        std::vector<size_t> stillOpen;
+        for (size_t k = 0; k < open.size(); ++k) {
+            size_t g = open[k];
+            if (ok[k]) {
+                accepted.emplace_back(round[k], g);
+                continue;
+            }
+            claims[round[k]].status = ClaimStatus::InvalidProof;
+            if (++cursor[g] < groups[g].size()) {
+                stillOpen.push_back(g);
+            }
+        }
+        open.swap(stillOpen);
+    }
+    std::sort(accepted.begin(), accepted.end());
+    
+    // Record in batch order. The pool may have changed while the lock was
+    // released, so each claim is checked against it again.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [index, g] : accepted) {
+            UBIClaim& claim = claims[index];
+            claim.status = CheckClaimAgainstPool(claim, currentHeight);
+            if (claim.status == ClaimStatus::Valid) {
+                claim.status = RecordClaimLocked(claim);
+            }
+            
+            // Later claims with this nullifier meet the recorded claim, or
+            // whatever stopped it
+            ClaimStatus later = claim.status == ClaimStatus::Valid
+                              ? ClaimStatus::DoubleClaim : claim.status;
+            for (size_t c = cursor[g] + 1; c < groups[g].size(); ++c) {
+                claims[groups[g][c]].status = later;
+            }
+        }
     }
     
-    // Claim is valid!
-    claim.amount = pool.amountPerPerson;
-    claim.status = ClaimStatus::Valid;
-    
-    // Record the claim
-    pool.RecordClaim(claim.nullifier, claim.amount);
-    totalDistributed_ += claim.amount;
-    totalClaims_++;
-    
-    return claim.status;
+    std::vector<ClaimStatus> statuses;
+    statuses.reserve(claims.size());
+    for (const UBIClaim& claim : claims) {
+        statuses.push_back(claim.status);
+    }
+    return statuses;
 }
 
 bool UBIDistributor::VerifyClaim(
@@ -490,46 +665,19 @@ bool UBIDistributor::VerifyClaim(
     }
     
     // Check for double-claim
-    if (pool.IsNullifierUsed(claim.nullifier)) {
+    if (usedNullifiers_->Contains(claim.nullifier.GetHash(), claim.epoch)) {
         return false;
     }
     
     // Verify the ZK proof against the identity tree root
     // This performs the same verification as ProcessClaim but read-only
-    
-    // Check structural validity
-    if (!claim.proof.IsValid()) {
-        return false;
-    }
-    
-    // Verify the proof type is UBI claim
-    if (claim.proof.GetType() != identity::ProofType::UBIClaim) {
-        return false;
-    }
-    
-    // Verify the proof's public inputs
-    const auto& publicInputs = claim.proof.GetPublicInputs();
-    if (publicInputs.Count() < 3) {
-        return false;
-    }
-    
-    // Convert identity tree root to FieldElement for comparison
     FieldElement expectedRoot = FieldElement::FromBytes(identityTreeRoot.data(), identityTreeRoot.size());
-    
-    // Verify the root in public inputs matches expected identity tree root
-    if (publicInputs.values[0] != expectedRoot) {
-        return false;
-    }
-    
-    // Verify the epoch in public inputs matches claim epoch
-    FieldElement expectedEpoch(static_cast<uint64_t>(claim.epoch));
-    if (publicInputs.values[2] != expectedEpoch) {
-        return false;
-    }
-    
-    // Verify the ZK proof itself using the UBI claim circuit
-    identity::ProofVerifier& verifier = identity::ProofVerifier::Instance();
-    return verifier.Verify(claim.proof, "ubi_claim");
+    return CheckClaimProof(claim, expectedRoot);
+}
+
+bool UBIDistributor::IsNullifierUsed(EpochId epoch, const identity::Nullifier& nullifier) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return usedNullifiers_->Contains(nullifier.GetHash(), epoch);
 }
 
 bool UBIDistributor::IsEpochClaimable(EpochId epoch, int currentHeight) const {
@@ -551,12 +699,8 @@ int UBIDistributor::GetClaimDeadline(EpochId epoch) const {
 double UBIDistributor::GetAverageClaimRate() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (pools_.empty()) {
-        return 0.0;
-    }
-    
-    double totalRate = 0.0;
-    int count = 0;
+    double totalRate = archivedClaimRateSum_;
+    uint64_t count = archivedPoolCount_;
     
     for (const auto& [epoch, pool] : pools_) {
         if (pool.isFinalized) {
@@ -568,6 +712,11 @@ double UBIDistributor::GetAverageClaimRate() const {
     return count > 0 ? totalRate / count : 0.0;
 }
 
+size_t UBIDistributor::GetPoolCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pools_.size();
+}
+
 UBIDistributor::EpochStats UBIDistributor::GetEpochStats(EpochId epoch) const {
     EpochStats stats;
     stats.epoch = epoch;
@@ -585,91 +734,69 @@ UBIDistributor::EpochStats UBIDistributor::GetEpochStats(EpochId epoch) const {
     return stats;
 }
 
+namespace {
+
+/// Append v as sizeof(T) little-endian bytes
+template <typename T>
+void AppendLE(std::vector<Byte>& data, T v) {
+    uint64_t u = static_cast<uint64_t>(v);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        data.push_back(static_cast<Byte>((u >> (i * 8)) & 0xFF));
+    }
+}
+
+/// Read sizeof(T) little-endian bytes at data + offset and advance offset
+template <typename T>
+T ReadLE(const Byte* data, size_t& offset) {
+    uint64_t u = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        u |= static_cast<uint64_t>(data[offset++]) << (i * 8);
+    }
+    return static_cast<T>(u);
+}
+
+/// Serialized size of a pool's fixed fields
+constexpr size_t POOL_RECORD_SIZE = 49;
+
+} // anonymous namespace
+
 std::vector<Byte> UBIDistributor::Serialize() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
     std::vector<Byte> data;
+    data.reserve(13 + pools_.size() * POOL_RECORD_SIZE + 32);
     
-    // Version byte
-    data.push_back(0x01);
+    // Version byte. Version 1 listed each pool's nullifiers after it.
+    data.push_back(0x02);
     
-    // Current epoch (8 bytes)
-    uint64_t epoch64 = currentEpoch_;
-    for (int i = 0; i < 8; ++i) {
-        data.push_back(static_cast<Byte>((epoch64 >> (i * 8)) & 0xFF));
-    }
+    AppendLE<uint64_t>(data, currentEpoch_);
+    AppendLE<uint32_t>(data, static_cast<uint32_t>(pools_.size()));
     
-    // Number of pools (4 bytes)
-    uint32_t poolCount = static_cast<uint32_t>(pools_.size());
-    for (int i = 0; i < 4; ++i) {
-        data.push_back(static_cast<Byte>((poolCount >> (i * 8)) & 0xFF));
-    }
-    
-    // Serialize each pool
     for (const auto& [epochId, pool] : pools_) {
-        // Epoch ID (8 bytes)
-        uint64_t e = epochId;
-        for (int i = 0; i < 8; ++i) {
-            data.push_back(static_cast<Byte>((e >> (i * 8)) & 0xFF));
-        }
-        
-        // Total pool (8 bytes)
-        int64_t tp = pool.totalPool;
-        for (int i = 0; i < 8; ++i) {
-            data.push_back(static_cast<Byte>((tp >> (i * 8)) & 0xFF));
-        }
-        
-        // Eligible count (4 bytes)
-        uint32_t ec = pool.eligibleCount;
-        for (int i = 0; i < 4; ++i) {
-            data.push_back(static_cast<Byte>((ec >> (i * 8)) & 0xFF));
-        }
-        
-        // Amount per person (8 bytes)
-        int64_t app = pool.amountPerPerson;
-        for (int i = 0; i < 8; ++i) {
-            data.push_back(static_cast<Byte>((app >> (i * 8)) & 0xFF));
-        }
-        
-        // Amount claimed (8 bytes)
-        int64_t ac = pool.amountClaimed;
-        for (int i = 0; i < 8; ++i) {
-            data.push_back(static_cast<Byte>((ac >> (i * 8)) & 0xFF));
-        }
-        
-        // Claim count (4 bytes)
-        uint32_t cc = pool.claimCount;
-        for (int i = 0; i < 4; ++i) {
-            data.push_back(static_cast<Byte>((cc >> (i * 8)) & 0xFF));
-        }
-        
-        // Flags: isFinalized (1 byte)
+        AppendLE<uint64_t>(data, epochId);
+        AppendLE<int64_t>(data, pool.totalPool);
+        AppendLE<uint32_t>(data, pool.eligibleCount);
+        AppendLE<int64_t>(data, pool.amountPerPerson);
+        AppendLE<int64_t>(data, pool.amountClaimed);
+        AppendLE<uint32_t>(data, pool.claimCount);
         data.push_back(pool.isFinalized ? 0x01 : 0x00);
-        
-        // End height (4 bytes)
-        int32_t eh = pool.endHeight;
-        for (int i = 0; i < 4; ++i) {
-            data.push_back(static_cast<Byte>((eh >> (i * 8)) & 0xFF));
-        }
-        
-        // Claim deadline (4 bytes)
-        int32_t cd = pool.claimDeadline;
-        for (int i = 0; i < 4; ++i) {
-            data.push_back(static_cast<Byte>((cd >> (i * 8)) & 0xFF));
-        }
-        
-        // Number of used nullifiers (4 bytes)
-        uint32_t nullifierCount = static_cast<uint32_t>(pool.usedNullifiers.size());
-        for (int i = 0; i < 4; ++i) {
-            data.push_back(static_cast<Byte>((nullifierCount >> (i * 8)) & 0xFF));
-        }
-        
-        // Serialize each nullifier (32 bytes each)
-        for (const auto& nullifier : pool.usedNullifiers) {
-            const Byte* nullifierData = nullifier.data();
-            data.insert(data.end(), nullifierData, nullifierData + identity::Nullifier::SIZE);
-        }
+        AppendLE<int32_t>(data, pool.endHeight);
+        AppendLE<int32_t>(data, pool.claimDeadline);
+    }
+    
+    // Pruned pools, for the average claim rate
+    uint64_t rateBits;
+    std::memcpy(&rateBits, &archivedClaimRateSum_, sizeof(rateBits));
+    AppendLE<uint64_t>(data, rateBits);
+    AppendLE<uint64_t>(data, archivedPoolCount_);
+    
+    // Used nullifiers, unless they are already in the caller's database
+    std::vector<Byte> nullifiers;
+    if (!persistentNullifiers_) {
+        nullifiers = usedNullifiers_->Serialize();
     }
+    AppendLE<uint32_t>(data, static_cast<uint32_t>(nullifiers.size()));
+    data.insert(data.end(), nullifiers.begin(), nullifiers.end());
     
     return data;
 }
@@ -685,126 +812,107 @@ bool UBIDistributor::Deserialize(const Byte* data, size_t len) {
     
     // Version byte
     uint8_t version = data[offset++];
-    if (version != 0x01) {
+    if (version != 0x01 && version != 0x02) {
         return false;  // Unsupported version
     }
     
-    // Current epoch (8 bytes)
-    currentEpoch_ = 0;
-    for (int i = 0; i < 8; ++i) {
-        currentEpoch_ |= static_cast<EpochId>(data[offset++]) << (i * 8);
-    }
-    
-    // Number of pools (4 bytes)
-    uint32_t poolCount = 0;
-    for (int i = 0; i < 4; ++i) {
-        poolCount |= static_cast<uint32_t>(data[offset++]) << (i * 8);
-    }
+    EpochId currentEpoch = ReadLE<uint64_t>(data, offset);
+    uint32_t poolCount = ReadLE<uint32_t>(data, offset);
     
     // Sanity check
     if (poolCount > 10000) {
         return false;  // Too many pools
     }
     
-    // Clear existing pools
-    pools_.clear();
+    std::map<EpochId, EpochUBIPool> pools;
+    std::vector<identity::Nullifier> v1Nullifiers;
     
-    // Deserialize each pool
     for (uint32_t p = 0; p < poolCount; ++p) {
-        if (offset + 53 > len) {  // Minimum pool size without nullifiers
+        if (offset + POOL_RECORD_SIZE > len) {
             return false;
         }
         
         EpochUBIPool pool;
-        
-        // Epoch ID (8 bytes)
-        EpochId epochId = 0;
-        for (int i = 0; i < 8; ++i) {
-            epochId |= static_cast<EpochId>(data[offset++]) << (i * 8);
-        }
-        pool.epoch = epochId;
-        
-        // Total pool (8 bytes)
-        int64_t tp = 0;
-        for (int i = 0; i < 8; ++i) {
-            tp |= static_cast<int64_t>(data[offset++]) << (i * 8);
-        }
-        pool.totalPool = tp;
-        
-        // Eligible count (4 bytes)
-        uint32_t ec = 0;
-        for (int i = 0; i < 4; ++i) {
-            ec |= static_cast<uint32_t>(data[offset++]) << (i * 8);
-        }
-        pool.eligibleCount = ec;
-        
-        // Amount per person (8 bytes)
-        int64_t app = 0;
-        for (int i = 0; i < 8; ++i) {
-            app |= static_cast<int64_t>(data[offset++]) << (i * 8);
-        }
-        pool.amountPerPerson = app;
-        
-        // Amount claimed (8 bytes)
-        int64_t ac = 0;
-        for (int i = 0; i < 8; ++i) {
-            ac |= static_cast<int64_t>(data[offset++]) << (i * 8);
-        }
-        pool.amountClaimed = ac;
-        
-        // Claim count (4 bytes)
-        uint32_t cc = 0;
-        for (int i = 0; i < 4; ++i) {
-            cc |= static_cast<uint32_t>(data[offset++]) << (i * 8);
-        }
-        pool.claimCount = cc;
-        
-        // Flags: isFinalized (1 byte)
+        pool.epoch = ReadLE<uint64_t>(data, offset);
+        pool.totalPool = ReadLE<int64_t>(data, offset);
+        pool.eligibleCount = ReadLE<uint32_t>(data, offset);
+        pool.amountPerPerson = ReadLE<int64_t>(data, offset);
+        pool.amountClaimed = ReadLE<int64_t>(data, offset);
+        pool.claimCount = ReadLE<uint32_t>(data, offset);
         pool.isFinalized = (data[offset++] != 0);
+        pool.endHeight = ReadLE<int32_t>(data, offset);
+        pool.claimDeadline = ReadLE<int32_t>(data, offset);
         
-        // End height (4 bytes)
-        int32_t eh = 0;
-        for (int i = 0; i < 4; ++i) {
-            eh |= static_cast<int32_t>(data[offset++]) << (i * 8);
-        }
-        pool.endHeight = eh;
-        
-        // Claim deadline (4 bytes)
-        int32_t cd = 0;
-        for (int i = 0; i < 4; ++i) {
-            cd |= static_cast<int32_t>(data[offset++]) << (i * 8);
-        }
-        pool.claimDeadline = cd;
-        
-        // Number of used nullifiers (4 bytes)
-        uint32_t nullifierCount = 0;
-        for (int i = 0; i < 4; ++i) {
-            nullifierCount |= static_cast<uint32_t>(data[offset++]) << (i * 8);
+        if (version == 0x01) {
+            if (offset + 4 > len) {
+                return false;
+            }
+            uint32_t nullifierCount = ReadLE<uint32_t>(data, offset);
+            
+            // Sanity check
+            if (nullifierCount > 1000000) {
+                return false;  // Too many nullifiers
+            }
+            if (offset + static_cast<size_t>(nullifierCount) * identity::Nullifier::SIZE > len) {
+                return false;
+            }
+            
+            for (uint32_t n = 0; n < nullifierCount; ++n) {
+                identity::NullifierHash hash;
+                std::memcpy(hash.data(), data + offset, identity::Nullifier::SIZE);
+                offset += identity::Nullifier::SIZE;
+                v1Nullifiers.emplace_back(hash, pool.epoch);
+            }
         }
         
-        // Sanity check
-        if (nullifierCount > 1000000) {
-            return false;  // Too many nullifiers
+        pools[pool.epoch] = pool;
+    }
+    
+    double archivedRateSum = 0.0;
+    uint64_t archivedCount = 0;
+    std::unique_ptr<identity::NullifierSet> nullifiers;
+    if (version == 0x02) {
+        if (offset + 20 > len) {
+            return false;
         }
+        uint64_t rateBits = ReadLE<uint64_t>(data, offset);
+        std::memcpy(&archivedRateSum, &rateBits, sizeof(rateBits));
+        archivedCount = ReadLE<uint64_t>(data, offset);
         
-        // Check we have enough data for nullifiers
-        if (offset + nullifierCount * identity::Nullifier::SIZE > len) {
+        uint32_t nullifierSize = ReadLE<uint32_t>(data, offset);
+        if (offset + nullifierSize > len) {
             return false;
         }
-        
-        // Deserialize each nullifier (32 bytes each)
-        for (uint32_t n = 0; n < nullifierCount; ++n) {
-            identity::NullifierHash hash;
-            std::memcpy(hash.data(), data + offset, identity::Nullifier::SIZE);
-            offset += identity::Nullifier::SIZE;
-            
-            identity::Nullifier nullifier(hash, epochId);
-            pool.usedNullifiers.insert(nullifier);
+        if (nullifierSize > 0 && !persistentNullifiers_) {
+            nullifiers = identity::NullifierSet::Deserialize(data + offset, nullifierSize,
+                                                             UsedNullifierConfig());
+            if (!nullifiers) {
+                return false;
+            }
         }
-        
-        pools_[epochId] = std::move(pool);
     }
     
+    currentEpoch_ = currentEpoch;
+    pools_ = std::move(pools);
+    archivedClaimRateSum_ = archivedRateSum;
+    archivedPoolCount_ = archivedCount;
+    
+    latestEpoch_ = currentEpoch_;
+    if (!pools_.empty()) {
+        latestEpoch_ = std::max(latestEpoch_, pools_.rbegin()->first);
+    }
+    
+    if (nullifiers) {
+        usedNullifiers_ = std::move(nullifiers);
+    } else if (!persistentNullifiers_) {
+        usedNullifiers_->Clear();
+    }
+    usedNullifiers_->SetCurrentEpoch(latestEpoch_);
+    for (const auto& nullifier : v1Nullifiers) {
+        usedNullifiers_->Add(nullifier);
+    }
+    PruneOldPools(latestEpoch_);
+    
     return true;
 }
 
@@ -820,19 +928,27 @@ EpochUBIPool& UBIDistributor::GetOrCreatePool(EpochId epoch) {
     return it->second;
 }
 
+void UBIDistributor::AdvanceLatestEpoch(EpochId epoch) {
+    latestEpoch_ = epoch;
+    usedNullifiers_->SetCurrentEpoch(epoch);
+    PruneOldPools(epoch);
+}
+
 void UBIDistributor::PruneOldPools(EpochId currentEpoch) {
-    // Keep pools for the grace period + some buffer
-    EpochId cutoff = currentEpoch > (UBI_GRACE_EPOCHS + 10) 
-                   ? currentEpoch - UBI_GRACE_EPOCHS - 10 
-                   : 0;
-    
-    for (auto it = pools_.begin(); it != pools_.end(); ) {
-        if (it->first < cutoff) {
-            it = pools_.erase(it);
-        } else {
-            ++it;
+    // Every pool stops taking claims inside the hot window
+    if (currentEpoch <= UBI_HOT_EPOCHS) {
+        return;
+    }
+    EpochId cutoff = currentEpoch - UBI_HOT_EPOCHS;
+    
+    for (auto it = pools_.begin(); it != pools_.end() && it->first < cutoff; ) {
+        if (it->second.isFinalized) {
+            archivedClaimRateSum_ += it->second.ClaimRate();
+            archivedPoolCount_++;
         }
+        it = pools_.erase(it);
     }
+    usedNullifiers_->PruneOlderThan(cutoff);
 }
 
 // ============================================================================
@@ -914,12 +1030,7 @@ bool UBIClaimGenerator::CanClaim(
     identity::Nullifier nullifier = secrets.DeriveNullifier(epoch);
     
     // Check if this nullifier has already been used
-    const EpochUBIPool* pool = distributor.GetPool(epoch);
-    if (!pool) {
-        return false;
-    }
-    
-    return !pool->IsNullifierUsed(nullifier);
+    return !distributor.IsNullifierUsed(epoch, nullifier);
 }
 
 // ============================================================================
@@ -7,6 +7,7 @@
 
 #include "shurium/core/block.h"
 #include "shurium/consensus/params.h"
+#include "shurium/crypto/sha256.h"
 #include <iostream>
 #include <iomanip>
 #include <chrono>
@@ -52,14 +53,29 @@ void MineGenesisBlock(const char* networkName, uint32_t nTime, uint32_t nBits,
     // Print merkle root (stays constant during mining)
     PrintHash("Merkle Root", genesis.hashMerkleRoot);
     
-    // Mine by incrementing nonce
-    for (uint32_t nonce = 0; ; ++nonce) {
-        genesis.nNonce = nonce;
-        BlockHash hash = genesis.GetHash();
-        ++hashesComputed;
+    // Only the nonce changes, so the first 64 header bytes are compressed once
+    DataStream header;
+    Serialize(header, static_cast<const BlockHeader&>(genesis));
+    const SHA256Midstate midstate = SHA256HeaderMidstate(header.data());
+    const Byte* tail = header.data() + 64;
+    
+    // Mine by incrementing nonce, a batch at a time
+    constexpr uint32_t BATCH = 16;
+    Byte hashes[32 * BATCH];
+    for (uint64_t first = 0; first <= 0xFFFFFFFF; first += BATCH) {
+        DoubleSHA256_80_Nonces(hashes, midstate, tail, static_cast<uint32_t>(first), BATCH);
         
-        // Check if hash meets difficulty
-        if (HashMeetsDifficulty(hash, target)) {
+        for (uint32_t i = 0; i < BATCH; ++i) {
+            uint32_t nonce = static_cast<uint32_t>(first) + i;
+            BlockHash hash(Hash256(hashes + 32 * i, 32));
+            ++hashesComputed;
+            
+            // Check if hash meets difficulty
+            if (!HashMeetsDifficulty(hash, target)) {
+                continue;
+            }
+            
+            genesis.nNonce = nonce;
             auto endTime = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
                 endTime - startTime).count();
@@ -88,6 +104,7 @@ void MineGenesisBlock(const char* networkName, uint32_t nTime, uint32_t nBits,
         }
         
         // Progress report every million hashes
+        uint32_t nonce = static_cast<uint32_t>(first) + BATCH - 1;
         if (nonce - lastProgressNonce >= 1000000) {
             auto currentTime = std::chrono::steady_clock::now();
             auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
@@ -101,14 +118,11 @@ void MineGenesisBlock(const char* networkName, uint32_t nTime, uint32_t nBits,
             
             lastProgressNonce = nonce;
         }
-        
-        // Handle nonce overflow (shouldn't happen with reasonable difficulty)
-        if (nonce == 0xFFFFFFFF) {
-            std::cout << "ERROR: Nonce space exhausted without finding valid hash!" << std::endl;
-            std::cout << "Consider using lower difficulty or different timestamp." << std::endl;
-            return;
-        }
     }
+    
+    // Nonce overflow (shouldn't happen with reasonable difficulty)
+    std::cout << "ERROR: Nonce space exhausted without finding valid hash!" << std::endl;
+    std::cout << "Consider using lower difficulty or different timestamp." << std::endl;
 }
 
 int main(int argc, char* argv[]) {
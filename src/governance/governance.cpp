@@ -614,7 +614,7 @@ std::optional<GovernanceProposal> GovernanceProposal::Deserialize(const Byte* da
     }
     
     try {
-        DataStream ss(data, len);
+        SpanReader ss(data, len);
         GovernanceProposal proposal;
         
         // Deserialize proposal ID (32 bytes)
@@ -870,7 +870,7 @@ bool VotingPowerTracker::Deserialize(const Byte* data, size_t len) {
     if (!data || len == 0) return false;
     
     try {
-        DataStream ss(data, len);
+        SpanReader ss(data, len);
         
         // Version
         uint32_t version = ser_readdata32(ss);
@@ -903,9 +903,79 @@ bool VotingPowerTracker::Deserialize(const Byte* data, size_t len) {
 // DelegationRegistry Implementation
 // ============================================================================
 
+namespace {
+
+/// Erase voter's entry queued under height
+void EraseQueued(std::multimap<int, VoterId>& queue, int height, const VoterId& voter) {
+    auto [begin, end] = queue.equal_range(height);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second == voter) {
+            queue.erase(it);
+            return;
+        }
+    }
+}
+
+} // anonymous namespace
+
 DelegationRegistry::DelegationRegistry() = default;
 DelegationRegistry::~DelegationRegistry() = default;
 
+void DelegationRegistry::CountDelegation(const Delegation& delegation, bool remove) {
+    auto powerIt = delegatorPower_.find(delegation.delegator);
+    uint64_t power = powerIt != delegatorPower_.end() ? powerIt->second : 0;
+    if (power == 0) {
+        return;
+    }
+    
+    auto& sums = delegatedPower_[delegation.delegate];
+    uint64_t& sum = delegation.scope ? sums.scoped[*delegation.scope] : sums.unscoped;
+    sum = remove ? sum - power : sum + power;
+    
+    if (sum == 0 && delegation.scope) {
+        sums.scoped.erase(*delegation.scope);
+    }
+    if (sums.unscoped == 0 && sums.scoped.empty()) {
+        delegatedPower_.erase(delegation.delegate);
+    }
+}
+
+void DelegationRegistry::IndexDelegation(const Delegation& delegation) {
+    reverseLookup_[delegation.delegate].insert(delegation.delegator);
+    if (delegation.expirationHeight > 0) {
+        expiringDelegations_.emplace(delegation.expirationHeight, delegation.delegator);
+    }
+    if (delegation.creationHeight > height_) {
+        pendingDelegations_.emplace(delegation.creationHeight, delegation.delegator);
+    }
+    if (delegation.IsValidAt(height_)) {
+        CountDelegation(delegation, false);
+    }
+}
+
+void DelegationRegistry::UnindexDelegation(const Delegation& delegation) {
+    if (delegation.IsValidAt(height_)) {
+        CountDelegation(delegation, true);
+    }
+    if (delegation.creationHeight > height_) {
+        EraseQueued(pendingDelegations_, delegation.creationHeight, delegation.delegator);
+    }
+    if (delegation.expirationHeight > 0) {
+        EraseQueued(expiringDelegations_, delegation.expirationHeight, delegation.delegator);
+    }
+    reverseLookup_[delegation.delegate].erase(delegation.delegator);
+}
+
+void DelegationRegistry::RebuildIndexes() {
+    reverseLookup_.clear();
+    delegatedPower_.clear();
+    pendingDelegations_.clear();
+    expiringDelegations_.clear();
+    for (const auto& [delegator, delegation] : delegations_) {
+        IndexDelegation(delegation);
+    }
+}
+
 bool DelegationRegistry::AddDelegation(const Delegation& delegation) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -919,15 +989,14 @@ bool DelegationRegistry::AddDelegation(const Delegation& delegation) {
         return false;
     }
     
-    // Remove existing delegation if any
+    // Remove existing delegation if any (the delegator's power carries over)
     auto existingIt = delegations_.find(delegation.delegator);
     if (existingIt != delegations_.end()) {
-        auto& oldDelegate = existingIt->second.delegate;
-        reverseLookup_[oldDelegate].erase(delegation.delegator);
+        UnindexDelegation(existingIt->second);
     }
     
     delegations_[delegation.delegator] = delegation;
-    reverseLookup_[delegation.delegate].insert(delegation.delegator);
+    IndexDelegation(delegation);
     
     return true;
 }
@@ -940,8 +1009,8 @@ bool DelegationRegistry::RemoveDelegation(const VoterId& delegator) {
         return false;
     }
     
-    auto& delegate = it->second.delegate;
-    reverseLookup_[delegate].erase(delegator);
+    UnindexDelegation(it->second);
+    delegatorPower_.erase(delegator);
     delegations_.erase(it);
     
     return true;
@@ -968,6 +1037,34 @@ std::vector<VoterId> DelegationRegistry::GetDelegators(const VoterId& delegate)
     return std::vector<VoterId>(it->second.begin(), it->second.end());
 }
 
+void DelegationRegistry::UpdateDelegatorPower(const VoterId& delegator, uint64_t power) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = delegations_.find(delegator);
+    if (it == delegations_.end()) {
+        return;
+    }
+    
+    bool counted = it->second.IsValidAt(height_);
+    if (counted) {
+        CountDelegation(it->second, true);
+    }
+    delegatorPower_[delegator] = power;
+    if (counted) {
+        CountDelegation(it->second, false);
+    }
+}
+
+void DelegationRegistry::RefreshDelegatorPowers(const VotingPowerTracker& tracker) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    delegatorPower_.clear();
+    for (const auto& [delegator, delegation] : delegations_) {
+        delegatorPower_[delegator] = tracker.GetVotingPower(delegator);
+    }
+    RebuildIndexes();
+}
+
 uint64_t DelegationRegistry::GetEffectiveVotingPower(
     const VoterId& voter,
     const VotingPowerTracker& tracker,
@@ -978,6 +1075,19 @@ uint64_t DelegationRegistry::GetEffectiveVotingPower(
     
     uint64_t power = tracker.GetVotingPower(voter);
     
+    // Delegated power at the registry's height is kept summed
+    if (currentHeight == height_) {
+        auto sumIt = delegatedPower_.find(voter);
+        if (sumIt != delegatedPower_.end()) {
+            power += sumIt->second.unscoped;
+            auto scopedIt = sumIt->second.scoped.find(proposalType);
+            if (scopedIt != sumIt->second.scoped.end()) {
+                power += scopedIt->second;
+            }
+        }
+        return power;
+    }
+    
     // Add delegated power
     auto it = reverseLookup_.find(voter);
     if (it != reverseLookup_.end()) {
@@ -988,7 +1098,10 @@ uint64_t DelegationRegistry::GetEffectiveVotingPower(
                 if (delegation.IsValidAt(currentHeight)) {
                     // Check scope
                     if (!delegation.scope || *delegation.scope == proposalType) {
-                        power += tracker.GetVotingPower(delegator);
+                        auto powerIt = delegatorPower_.find(delegator);
+                        if (powerIt != delegatorPower_.end()) {
+                            power += powerIt->second;
+                        }
                     }
                 }
             }
@@ -1039,19 +1152,28 @@ int DelegationRegistry::GetDelegationDepth(const VoterId& voter) const {
 void DelegationRegistry::ExpireDelegations(int height) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    std::vector<VoterId> toRemove;
-    for (auto& [delegator, delegation] : delegations_) {
-        if (delegation.expirationHeight > 0 && height >= delegation.expirationHeight) {
-            delegation.isActive = false;
-            toRemove.push_back(delegator);
-        }
+    // Going back a height can un-count delegations; recount from scratch
+    if (height < height_) {
+        height_ = height;
+        RebuildIndexes();
     }
     
-    for (const auto& delegator : toRemove) {
+    while (!expiringDelegations_.empty() &&
+           expiringDelegations_.begin()->first <= height) {
+        VoterId delegator = expiringDelegations_.begin()->second;
         auto it = delegations_.find(delegator);
-        if (it != delegations_.end()) {
-            reverseLookup_[it->second.delegate].erase(delegator);
-            delegations_.erase(it);
+        UnindexDelegation(it->second);
+        delegatorPower_.erase(delegator);
+        delegations_.erase(it);
+    }
+    
+    height_ = height;
+    while (!pendingDelegations_.empty() &&
+           pendingDelegations_.begin()->first <= height) {
+        const Delegation& delegation = delegations_.at(pendingDelegations_.begin()->second);
+        pendingDelegations_.erase(pendingDelegations_.begin());
+        if (delegation.IsValidAt(height_)) {
+            CountDelegation(delegation, false);
         }
     }
 }
@@ -1065,6 +1187,10 @@ void DelegationRegistry::Clear() {
     std::lock_guard<std::mutex> lock(mutex_);
     delegations_.clear();
     reverseLookup_.clear();
+    delegatorPower_.clear();
+    delegatedPower_.clear();
+    pendingDelegations_.clear();
+    expiringDelegations_.clear();
 }
 
 std::vector<Byte> DelegationRegistry::Serialize() const {
@@ -1105,7 +1231,7 @@ bool DelegationRegistry::Deserialize(const Byte* data, size_t len) {
     if (!data || len == 0) return false;
     
     try {
-        DataStream ss(data, len);
+        SpanReader ss(data, len);
         
         // Version
         uint32_t version = ser_readdata32(ss);
@@ -1116,7 +1242,7 @@ bool DelegationRegistry::Deserialize(const Byte* data, size_t len) {
         
         std::lock_guard<std::mutex> lock(mutex_);
         delegations_.clear();
-        reverseLookup_.clear();
+        delegatorPower_.clear();
         
         // Read each delegation
         for (uint64_t i = 0; i < count; ++i) {
@@ -1141,9 +1267,11 @@ bool DelegationRegistry::Deserialize(const Byte* data, size_t len) {
             delegation.isActive = ser_readdata8(ss) != 0;
             
             delegations_[delegation.delegator] = delegation;
-            reverseLookup_[delegation.delegate].insert(delegation.delegator);
         }
         
+        // Delegated power stays zero until the powers are refreshed
+        RebuildIndexes();
+        
         return true;
     } catch (...) {
         return false;
@@ -1168,6 +1296,19 @@ void ParameterRegistry::InitializeDefaults() {
         auto param = static_cast<GovernableParameter>(i);
         parameters_[param] = GetParameterDefault(param);
     }
+    PublishValues();
+}
+
+void ParameterRegistry::PublishValues() {
+    for (size_t i = 0; i < GOVERNABLE_PARAMETER_COUNT; ++i) {
+        auto param = static_cast<GovernableParameter>(i);
+        auto it = parameters_.find(param);
+        ParameterValue value = it != parameters_.end() ? it->second : GetParameterDefault(param);
+        intValues_[i].store(std::holds_alternative<int64_t>(value) ? std::get<int64_t>(value) : 0,
+                            std::memory_order_relaxed);
+    }
+    // Release: a reader that sees the new epoch sees the values above
+    epoch_.fetch_add(1, std::memory_order_release);
 }
 
 ParameterValue ParameterRegistry::GetParameter(GovernableParameter param) const {
@@ -1181,11 +1322,11 @@ ParameterValue ParameterRegistry::GetParameter(GovernableParameter param) const
 }
 
 int64_t ParameterRegistry::GetParameterInt(GovernableParameter param) const {
-    auto value = GetParameter(param);
-    if (std::holds_alternative<int64_t>(value)) {
-        return std::get<int64_t>(value);
+    auto index = static_cast<size_t>(param);
+    if (index >= GOVERNABLE_PARAMETER_COUNT) {
+        return 0;
     }
-    return 0;
+    return intValues_[index].load(std::memory_order_acquire);
 }
 
 std::string ParameterRegistry::GetParameterString(GovernableParameter param) const {
@@ -1203,6 +1344,7 @@ bool ParameterRegistry::SetParameter(GovernableParameter param, const ParameterV
     
     std::lock_guard<std::mutex> lock(mutex_);
     parameters_[param] = value;
+    PublishValues();
     return true;
 }
 
@@ -1265,7 +1407,7 @@ bool ParameterRegistry::Deserialize(const Byte* data, size_t len) {
     if (!data || len == 0) return false;
     
     try {
-        DataStream ss(data, len);
+        SpanReader ss(data, len);
         
         // Version
         uint32_t version = ser_readdata32(ss);
@@ -1297,9 +1439,12 @@ bool ParameterRegistry::Deserialize(const Byte* data, size_t len) {
                 parameters_[param] = strVal;
             }
         }
+        PublishValues();
         
         return true;
     } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PublishValues();
         return false;
     }
 }
@@ -1395,11 +1540,112 @@ void GuardianRegistry::ResetVetoCounts() {
     proposalVetoes_.clear();
 }
 
+std::vector<Byte> GuardianRegistry::Serialize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DataStream ss;
+    
+    // Version
+    ser_writedata32(ss, 1);
+    
+    // Guardians
+    WriteCompactSize(ss, guardians_.size());
+    for (const auto& [id, guardian] : guardians_) {
+        ss.Write(guardian.id.data(), guardian.id.size());
+        auto keyData = guardian.publicKey.ToVector();
+        WriteCompactSize(ss, keyData.size());
+        ss.Write(keyData.data(), keyData.size());
+        ser_writedata32(ss, static_cast<uint32_t>(guardian.appointmentHeight));
+        ser_writedata8(ss, guardian.isActive ? 1 : 0);
+        ser_writedata32(ss, static_cast<uint32_t>(guardian.vetosUsed));
+    }
+    
+    // Vetoes recorded this period
+    WriteCompactSize(ss, proposalVetoes_.size());
+    for (const auto& [proposalId, guardianIds] : proposalVetoes_) {
+        ss.Write(proposalId.data(), proposalId.size());
+        WriteCompactSize(ss, guardianIds.size());
+        for (const auto& guardianId : guardianIds) {
+            ss.Write(guardianId.data(), guardianId.size());
+        }
+    }
+    
+    return std::vector<Byte>(ss.begin(), ss.end());
+}
+
+bool GuardianRegistry::Deserialize(const Byte* data, size_t len) {
+    if (!data || len == 0) return false;
+    
+    try {
+        SpanReader ss(data, len);
+        
+        // Version
+        uint32_t version = ser_readdata32(ss);
+        if (version != 1) return false;
+        
+        std::map<VoterId, Guardian> guardians;
+        uint64_t guardianCount = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < guardianCount; ++i) {
+            Guardian guardian;
+            ss.Read(guardian.id.data(), guardian.id.size());
+            uint64_t keyLen = ReadCompactSize(ss);
+            std::vector<Byte> keyData(keyLen);
+            ss.Read(keyData.data(), keyLen);
+            if (keyLen > 0) {
+                guardian.publicKey = PublicKey(keyData.data(), keyData.size());
+            }
+            guardian.appointmentHeight = static_cast<int>(ser_readdata32(ss));
+            guardian.isActive = ser_readdata8(ss) != 0;
+            guardian.vetosUsed = static_cast<int>(ser_readdata32(ss));
+            guardians[guardian.id] = guardian;
+        }
+        
+        std::map<GovernanceProposalId, std::set<VoterId>> proposalVetoes;
+        uint64_t vetoSetCount = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < vetoSetCount; ++i) {
+            GovernanceProposalId proposalId;
+            ss.Read(proposalId.data(), proposalId.size());
+            uint64_t vetoCount = ReadCompactSize(ss);
+            auto& guardianIds = proposalVetoes[proposalId];
+            for (uint64_t j = 0; j < vetoCount; ++j) {
+                VoterId guardianId;
+                ss.Read(guardianId.data(), guardianId.size());
+                guardianIds.insert(guardianId);
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        guardians_ = std::move(guardians);
+        proposalVetoes_ = std::move(proposalVetoes);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 
 // ============================================================================
 // GovernanceEngine Implementation
 // ============================================================================
 
+namespace {
+
+/// Add (or with remove, take back) a vote's power in the proposal's tally
+void TallyVote(GovernanceProposal& proposal, VoteChoice choice, uint64_t power, bool remove) {
+    uint64_t* tally = nullptr;
+    switch (choice) {
+        case VoteChoice::Yes:        tally = &proposal.votesYes; break;
+        case VoteChoice::No:         tally = &proposal.votesNo; break;
+        case VoteChoice::Abstain:    tally = &proposal.votesAbstain; break;
+        case VoteChoice::NoWithVeto: tally = &proposal.votesNoWithVeto; break;
+    }
+    if (!tally) {
+        return;
+    }
+    *tally = remove ? *tally - power : *tally + power;
+}
+
+} // anonymous namespace
+
 GovernanceEngine::GovernanceEngine()
     : params_(std::make_shared<ParameterRegistry>()) {}
 
@@ -1426,10 +1672,8 @@ std::optional<GovernanceProposalId> GovernanceEngine::SubmitProposal(
     
     // Check proposer's active proposal count
     int activeCount = 0;
-    for (const auto& [id, p] : proposals_) {
-        if (p.proposer == proposal.proposer &&
-            (p.status == GovernanceStatus::Pending || 
-             p.status == GovernanceStatus::Active)) {
+    for (const auto& id : openProposals_) {
+        if (proposals_.at(id).proposer == proposal.proposer) {
             activeCount++;
         }
     }
@@ -1447,6 +1691,7 @@ std::optional<GovernanceProposalId> GovernanceEngine::SubmitProposal(
     newProposal.votingEndHeight = newProposal.votingStartHeight + newProposal.GetVotingPeriod();
     
     proposals_[newProposal.id] = newProposal;
+    ScheduleTransition(newProposal);
     
     return newProposal.id;
 }
@@ -1487,15 +1732,7 @@ std::vector<GovernanceProposal> GovernanceEngine::GetProposalsByProposer(const P
 
 size_t GovernanceEngine::GetActiveProposalCount() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    size_t count = 0;
-    for (const auto& [id, proposal] : proposals_) {
-        if (proposal.status == GovernanceStatus::Active ||
-            proposal.status == GovernanceStatus::Pending) {
-            count++;
-        }
-    }
-    return count;
+    return openProposals_.size();
 }
 
 size_t GovernanceEngine::GetTotalProposalCount() const {
@@ -1524,6 +1761,7 @@ bool GovernanceEngine::CancelProposal(const GovernanceProposalId& id, const std:
     }
     
     proposal.status = GovernanceStatus::Cancelled;
+    openProposals_.erase(id);
     return true;
 }
 
@@ -1573,20 +1811,7 @@ bool GovernanceEngine::CastVote(const Vote& vote) {
     votes_[vote.proposalId][vote.voter] = vote;
     
     // Update proposal vote counts
-    switch (vote.choice) {
-        case VoteChoice::Yes:
-            proposal.votesYes += vote.votingPower;
-            break;
-        case VoteChoice::No:
-            proposal.votesNo += vote.votingPower;
-            break;
-        case VoteChoice::Abstain:
-            proposal.votesAbstain += vote.votingPower;
-            break;
-        case VoteChoice::NoWithVeto:
-            proposal.votesNoWithVeto += vote.votingPower;
-            break;
-    }
+    TallyVote(proposal, vote.choice, vote.votingPower, false);
     
     // Update total voting power snapshot to include new voters
     // This is needed because voters register their power at vote time
@@ -1624,37 +1849,9 @@ bool GovernanceEngine::ChangeVote(const Vote& newVote) {
         return false;
     }
     
-    // Remove old vote from counts
-    switch (oldVote.choice) {
-        case VoteChoice::Yes:
-            proposal.votesYes -= oldVote.votingPower;
-            break;
-        case VoteChoice::No:
-            proposal.votesNo -= oldVote.votingPower;
-            break;
-        case VoteChoice::Abstain:
-            proposal.votesAbstain -= oldVote.votingPower;
-            break;
-        case VoteChoice::NoWithVeto:
-            proposal.votesNoWithVeto -= oldVote.votingPower;
-            break;
-    }
-    
-    // Add new vote
-    switch (newVote.choice) {
-        case VoteChoice::Yes:
-            proposal.votesYes += newVote.votingPower;
-            break;
-        case VoteChoice::No:
-            proposal.votesNo += newVote.votingPower;
-            break;
-        case VoteChoice::Abstain:
-            proposal.votesAbstain += newVote.votingPower;
-            break;
-        case VoteChoice::NoWithVeto:
-            proposal.votesNoWithVeto += newVote.votingPower;
-            break;
-    }
+    // Move the voter's power from the old choice to the new one
+    TallyVote(proposal, oldVote.choice, oldVote.votingPower, true);
+    TallyVote(proposal, newVote.choice, newVote.votingPower, false);
     
     proposalVotes[newVote.voter] = newVote;
     return true;
@@ -1705,7 +1902,14 @@ bool GovernanceEngine::Delegate(const Delegation& delegation, const std::vector<
     if (!VerifyDelegationSignature(delegation, signature)) {
         return false;
     }
-    return delegations_.AddDelegation(delegation);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!delegations_.AddDelegation(delegation)) {
+        return false;
+    }
+    delegations_.UpdateDelegatorPower(delegation.delegator,
+                                      votingPower_.GetVotingPower(delegation.delegator));
+    return true;
 }
 
 bool GovernanceEngine::RevokeDelegation(const VoterId& delegator, const std::vector<Byte>& signature) {
@@ -1747,7 +1951,9 @@ void GovernanceEngine::RegisterVoterKey(const PublicKey& publicKey) {
 }
 
 void GovernanceEngine::UpdateVotingPower(const VoterId& voter, uint64_t power) {
+    std::lock_guard<std::mutex> lock(mutex_);
     votingPower_.UpdateVotingPower(voter, power);
+    delegations_.UpdateDelegatorPower(voter, power);
 }
 
 uint64_t GovernanceEngine::GetVotingPower(const VoterId& voter) const {
@@ -1784,6 +1990,7 @@ bool GovernanceEngine::VetoProposal(const GovernanceProposalId& proposalId,
     // Check if proposal is now vetoed
     if (guardians_.IsVetoed(proposalId)) {
         it->second.status = GovernanceStatus::Vetoed;
+        openProposals_.erase(proposalId);
     }
     
     return true;
@@ -1797,26 +2004,21 @@ void GovernanceEngine::ProcessBlock(int height) {
     // Expire old delegations
     delegations_.ExpireDelegations(height);
     
-    // Process proposals
-    for (auto& [id, proposal] : proposals_) {
-        // Start voting
-        if (proposal.status == GovernanceStatus::Pending && 
-            height >= proposal.votingStartHeight) {
-            proposal.status = GovernanceStatus::Active;
-            SnapshotVotingPower(proposal);
-        }
-        
-        // End voting
-        if (proposal.status == GovernanceStatus::Active &&
-            height >= proposal.votingEndHeight) {
-            EndVoting(const_cast<GovernanceProposalId&>(id), height);
-        }
-        
-        // Execute approved proposals
-        if (proposal.status == GovernanceStatus::Approved &&
-            proposal.IsReadyForExecution(height)) {
-            ExecuteProposal(proposal);
+    // Only proposals with a transition due can change status; take them
+    // in ID order so same-height executions apply deterministically
+    std::set<GovernanceProposalId> due;
+    while (!transitions_.empty() && transitions_.begin()->first <= height) {
+        due.insert(transitions_.begin()->second);
+        transitions_.erase(transitions_.begin());
+    }
+    
+    for (const auto& id : due) {
+        auto it = proposals_.find(id);
+        if (it == proposals_.end()) {
+            continue;
         }
+        AdvanceProposal(it->second, height);
+        ScheduleTransition(it->second);
     }
 }
 
@@ -1832,8 +2034,8 @@ std::vector<Byte> GovernanceEngine::Serialize() const {
     std::lock_guard<std::mutex> lock(mutex_);
     DataStream ss;
     
-    // Version
-    ser_writedata32(ss, 1);
+    // Version (1 had no voter keys or guardians)
+    ser_writedata32(ss, 2);
     
     // Current height
     ser_writedata32(ss, static_cast<uint32_t>(currentHeight_));
@@ -1897,6 +2099,19 @@ std::vector<Byte> GovernanceEngine::Serialize() const {
         }
     }
     
+    // Voter public keys (needed to verify later votes)
+    WriteCompactSize(ss, voterKeys_.size());
+    for (const auto& [voterId, publicKey] : voterKeys_) {
+        auto keyData = publicKey.ToVector();
+        WriteCompactSize(ss, keyData.size());
+        ss.Write(keyData.data(), keyData.size());
+    }
+    
+    // Guardian registry
+    auto guardianData = guardians_.Serialize();
+    WriteCompactSize(ss, guardianData.size());
+    ss.Write(guardianData.data(), guardianData.size());
+    
     return std::vector<Byte>(ss.begin(), ss.end());
 }
 
@@ -1904,11 +2119,11 @@ bool GovernanceEngine::Deserialize(const Byte* data, size_t len) {
     if (!data || len == 0) return false;
     
     try {
-        DataStream ss(data, len);
+        SpanReader ss(data, len);
         
         // Version
         uint32_t version = ser_readdata32(ss);
-        if (version != 1) return false;
+        if (version != 1 && version != 2) return false;
         
         std::lock_guard<std::mutex> lock(mutex_);
         
@@ -1930,6 +2145,8 @@ bool GovernanceEngine::Deserialize(const Byte* data, size_t len) {
         if (!delegations_.Deserialize(delegationData.data(), delegationData.size())) {
             return false;
         }
+        delegations_.RefreshDelegatorPowers(votingPower_);
+        delegations_.ExpireDelegations(currentHeight_);
         
         // Deserialize parameter registry
         uint64_t paramLen = ReadCompactSize(ss);
@@ -1954,6 +2171,7 @@ bool GovernanceEngine::Deserialize(const Byte* data, size_t len) {
             
             proposals_[proposal->id] = *proposal;
         }
+        RebuildProposalIndexes();
         
         // Number of vote sets
         uint64_t voteSetCount = ReadCompactSize(ss);
@@ -1999,12 +2217,83 @@ bool GovernanceEngine::Deserialize(const Byte* data, size_t len) {
             }
         }
         
+        if (version >= 2) {
+            // Voter public keys
+            uint64_t keyCount = ReadCompactSize(ss);
+            voterKeys_.clear();
+            for (uint64_t i = 0; i < keyCount; ++i) {
+                uint64_t keyLen = ReadCompactSize(ss);
+                std::vector<Byte> keyData(keyLen);
+                ss.Read(keyData.data(), keyLen);
+                PublicKey publicKey(keyData.data(), keyData.size());
+                if (!publicKey.IsValid()) return false;
+                voterKeys_[publicKey.GetID()] = publicKey;
+            }
+            
+            // Guardian registry
+            uint64_t guardianLen = ReadCompactSize(ss);
+            std::vector<Byte> guardianData(guardianLen);
+            ss.Read(guardianData.data(), guardianLen);
+            if (!guardians_.Deserialize(guardianData.data(), guardianData.size())) {
+                return false;
+            }
+        }
+        
         return true;
     } catch (...) {
         return false;
     }
 }
 
+void GovernanceEngine::AdvanceProposal(GovernanceProposal& proposal, int height) {
+    // Start voting
+    if (proposal.status == GovernanceStatus::Pending && 
+        height >= proposal.votingStartHeight) {
+        proposal.status = GovernanceStatus::Active;
+        SnapshotVotingPower(proposal);
+    }
+    
+    // End voting
+    if (proposal.status == GovernanceStatus::Active &&
+        height >= proposal.votingEndHeight) {
+        EndVoting(proposal.id, height);
+    }
+    
+    // Execute approved proposals
+    if (proposal.status == GovernanceStatus::Approved &&
+        proposal.IsReadyForExecution(height)) {
+        ExecuteProposal(proposal);
+    }
+}
+
+void GovernanceEngine::ScheduleTransition(const GovernanceProposal& proposal) {
+    switch (proposal.status) {
+        case GovernanceStatus::Pending:
+            openProposals_.insert(proposal.id);
+            transitions_.emplace(proposal.votingStartHeight, proposal.id);
+            break;
+        case GovernanceStatus::Active:
+            openProposals_.insert(proposal.id);
+            transitions_.emplace(proposal.votingEndHeight, proposal.id);
+            break;
+        case GovernanceStatus::Approved:
+            openProposals_.erase(proposal.id);
+            transitions_.emplace(proposal.executionHeight, proposal.id);
+            break;
+        default:
+            openProposals_.erase(proposal.id);
+            break;
+    }
+}
+
+void GovernanceEngine::RebuildProposalIndexes() {
+    openProposals_.clear();
+    transitions_.clear();
+    for (const auto& [id, proposal] : proposals_) {
+        ScheduleTransition(proposal);
+    }
+}
+
 void GovernanceEngine::StartVoting(GovernanceProposalId& id, int height) {
     auto it = proposals_.find(id);
     if (it == proposals_.end()) return;
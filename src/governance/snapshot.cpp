@@ -0,0 +1,216 @@
+// SHURIUM - Governance State Snapshots Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/governance/snapshot.h>
+#include <shurium/governance/governance.h>
+#include <shurium/economics/treasury.h>
+#include <shurium/core/serialize.h>
+#include <shurium/util/logging.h>
+
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <iterator>
+
+namespace shurium {
+namespace governance {
+
+namespace {
+
+/// File magic
+constexpr uint8_t SNAPSHOT_MAGIC[4] = {'s', 'g', 'o', 'v'};
+
+bool ReadSection(DataStream& ss, std::vector<Byte>& section) {
+    uint64_t size = ReadCompactSize(ss);
+    if (size > MAX_GOVERNANCE_SNAPSHOT_SECTION_BYTES || size > ss.size()) {
+        return false;
+    }
+    section.resize(size);
+    ss.Read(section.data(), size);
+    return true;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// GovernanceSnapshot
+// ============================================================================
+
+GovernanceSnapshot GovernanceSnapshot::Capture(int height, const GovernanceEngine& engine,
+                                               const economics::Treasury* treasury) {
+    GovernanceSnapshot snapshot;
+    snapshot.height = height;
+    snapshot.engineState = engine.Serialize();
+    if (treasury) {
+        snapshot.treasuryState = treasury->Serialize();
+    }
+    return snapshot;
+}
+
+bool GovernanceSnapshot::Restore(GovernanceEngine& engine, economics::Treasury* treasury) const {
+    if (!engine.Deserialize(engineState.data(), engineState.size())) {
+        return false;
+    }
+    if (treasury && !treasuryState.empty() &&
+        !treasury->Deserialize(treasuryState.data(), treasuryState.size())) {
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Files
+// ============================================================================
+
+GovernanceSnapshotResult WriteGovernanceSnapshot(const GovernanceSnapshot& snapshot,
+                                                 const std::filesystem::path& path) {
+    DataStream ss;
+    ss.Write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    Serialize(ss, GOVERNANCE_SNAPSHOT_VERSION);
+    Serialize(ss, static_cast<int32_t>(snapshot.height));
+    Serialize(ss, snapshot.engineState);
+    Serialize(ss, snapshot.treasuryState);
+
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".new";
+    std::error_code ec;
+    bool ok = false;
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return GovernanceSnapshotResult::Error("Cannot create " + tmpPath.string());
+        }
+        file.write(reinterpret_cast<const char*>(ss.data()),
+                   static_cast<std::streamsize>(ss.size()));
+        file.flush();
+        ok = file.good();
+    }
+
+    if (!ok) {
+        std::filesystem::remove(tmpPath, ec);
+        return GovernanceSnapshotResult::Error("Failed writing " + tmpPath.string());
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return GovernanceSnapshotResult::Error("Cannot rename governance snapshot to " +
+                                               path.string());
+    }
+
+    GovernanceSnapshotResult result;
+    result.success = true;
+    result.height = snapshot.height;
+    return result;
+}
+
+GovernanceSnapshotResult ReadGovernanceSnapshot(const std::filesystem::path& path,
+                                                GovernanceSnapshot& snapshot) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return GovernanceSnapshotResult::Error("Cannot open " + path.string());
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+
+    if (bytes.size() < sizeof(SNAPSHOT_MAGIC) ||
+        std::memcmp(bytes.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        return GovernanceSnapshotResult::Error(path.string() + " is not a governance snapshot");
+    }
+
+    DataStream ss(std::move(bytes));
+    GovernanceSnapshot read;
+    try {
+        uint8_t magic[sizeof(SNAPSHOT_MAGIC)];
+        ss.Read(magic, sizeof(magic));
+        uint16_t version = 0;
+        Unserialize(ss, version);
+        if (version != GOVERNANCE_SNAPSHOT_VERSION) {
+            return GovernanceSnapshotResult::Error("Unsupported governance snapshot version " +
+                                                   std::to_string(version));
+        }
+        int32_t height = 0;
+        Unserialize(ss, height);
+        read.height = height;
+        if (!ReadSection(ss, read.engineState) || !ReadSection(ss, read.treasuryState)) {
+            return GovernanceSnapshotResult::Error("Bad section in " + path.string());
+        }
+    } catch (const std::ios_base::failure&) {
+        return GovernanceSnapshotResult::Error("Truncated governance snapshot " + path.string());
+    }
+
+    snapshot = std::move(read);
+    GovernanceSnapshotResult result;
+    result.success = true;
+    result.height = snapshot.height;
+    return result;
+}
+
+// ============================================================================
+// GovernanceSnapshotWriter
+// ============================================================================
+
+GovernanceSnapshotWriter::GovernanceSnapshotWriter(std::filesystem::path path)
+    : path_(std::move(path)) {
+    thread_ = std::thread(&GovernanceSnapshotWriter::Run, this);
+}
+
+GovernanceSnapshotWriter::~GovernanceSnapshotWriter() {
+    Stop();
+}
+
+void GovernanceSnapshotWriter::Submit(GovernanceSnapshot snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+            return;
+        }
+        pending_ = std::move(snapshot);
+    }
+    cv_.notify_one();
+}
+
+void GovernanceSnapshotWriter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+int GovernanceSnapshotWriter::GetLastWrittenHeight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastWrittenHeight_;
+}
+
+void GovernanceSnapshotWriter::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stop_ || pending_.has_value(); });
+        if (!pending_) {
+            return;  // Stopped with nothing left to write
+        }
+
+        GovernanceSnapshot snapshot = std::move(*pending_);
+        pending_.reset();
+        lock.unlock();
+        GovernanceSnapshotResult result = WriteGovernanceSnapshot(snapshot, path_);
+        if (result.success) {
+            LOG_DEBUG(util::LogCategory::DEFAULT) << "Wrote governance snapshot at height "
+                                                  << result.height << " to " << path_.string();
+        } else {
+            LOG_WARN(util::LogCategory::DEFAULT) << result.error;
+        }
+        lock.lock();
+        if (result.success) {
+            lastWrittenHeight_ = result.height;
+        }
+    }
+}
+
+} // namespace governance
+} // namespace shurium
@@ -5,9 +5,11 @@
 #include <shurium/identity/commitment.h>
 #include <shurium/core/hex.h>
 #include <shurium/core/random.h>
+#include <shurium/util/threadpool.h>
 
 #include <algorithm>
 #include <cstring>
+#include <future>
 #include <stdexcept>
 
 namespace shurium {
@@ -310,7 +312,8 @@ VectorCommitment::VectorCommitment()
     : root_(FieldElement::Zero()), size_(0), depth_(0) {
 }
 
-VectorCommitment::VectorCommitment(const std::vector<FieldElement>& elements)
+VectorCommitment::VectorCommitment(const std::vector<FieldElement>& elements,
+                                   util::ThreadPool* pool)
     : size_(0), depth_(0) {
     
     if (elements.empty()) {
@@ -335,7 +338,7 @@ VectorCommitment::VectorCommitment(const std::vector<FieldElement>& elements)
         leaves_.push_back(DefaultLeaf());
     }
     
-    RebuildTree();
+    RebuildTree(pool);
 }
 
 VectorCommitment::VectorCommitment(const FieldElement& root, uint64_t size)
@@ -357,6 +360,7 @@ uint64_t VectorCommitment::Add(const FieldElement& element) {
     
     // Expand tree if needed
     uint64_t capacity = leaves_.size();
+    bool grew = false;
     
     if (capacity == 0 || size_ >= capacity) {
         // Need to grow
@@ -369,22 +373,48 @@ uint64_t VectorCommitment::Add(const FieldElement& element) {
         while (leaves_.size() < newCapacity) {
             leaves_.push_back(DefaultLeaf());
         }
+        grew = true;
     }
     
     // Add element
     leaves_[index] = element;
     size_++;
     
-    // Rebuild tree
-    RebuildTree();
+    // A new level means a full rebuild; otherwise only this leaf's path changed
+    if (grew) {
+        RebuildTree();
+    } else {
+        UpdatePath(index);
+    }
     
     return index;
 }
 
-void VectorCommitment::AddBatch(const std::vector<FieldElement>& elements) {
-    for (const auto& elem : elements) {
-        Add(elem);
+void VectorCommitment::AddBatch(const std::vector<FieldElement>& elements,
+                                util::ThreadPool* pool) {
+    if (elements.empty()) {
+        return;
+    }
+    if (leaves_.size() < size_) {
+        // Root-only tree: there are no leaves to extend
+        for (const auto& elem : elements) {
+            Add(elem);
+        }
+        return;
+    }
+    
+    // Grow to the capacity and depth the individual Adds would reach
+    uint64_t newSize = size_ + elements.size();
+    uint64_t capacity = leaves_.empty() ? 1 : leaves_.size();
+    while (capacity < newSize) {
+        capacity *= 2;
+        depth_++;
     }
+    leaves_.resize(capacity, DefaultLeaf());
+    std::copy(elements.begin(), elements.end(), leaves_.begin() + size_);
+    size_ = newSize;
+    
+    RebuildTree(pool);
 }
 
 std::optional<VectorCommitment::MerkleProof> VectorCommitment::Prove(uint64_t index) const {
@@ -462,7 +492,7 @@ std::optional<FieldElement> VectorCommitment::GetElement(uint64_t index) const {
     return leaves_[index];
 }
 
-void VectorCommitment::RebuildTree() {
+void VectorCommitment::RebuildTree(util::ThreadPool* pool) {
     if (leaves_.empty()) {
         root_ = FieldElement::Zero();
         return;
@@ -474,24 +504,75 @@ void VectorCommitment::RebuildTree() {
     std::vector<FieldElement>* currentLevel = &leaves_;
     
     while (currentLevel->size() > 1) {
-        std::vector<FieldElement> nextLevel;
-        nextLevel.reserve((currentLevel->size() + 1) / 2);
-        
-        for (size_t i = 0; i < currentLevel->size(); i += 2) {
-            FieldElement left = (*currentLevel)[i];
-            FieldElement right = (i + 1 < currentLevel->size()) 
-                ? (*currentLevel)[i + 1] 
-                : DefaultLeaf();
-            nextLevel.push_back(HashPair(left, right));
-        }
-        
-        levels_.push_back(std::move(nextLevel));
+        levels_.push_back(HashLevel(*currentLevel, pool));
         currentLevel = &levels_.back();
     }
     
     root_ = levels_.empty() ? leaves_[0] : levels_.back()[0];
 }
 
+void VectorCommitment::UpdatePath(uint64_t index) {
+    const std::vector<FieldElement>* below = &leaves_;
+    uint64_t idx = index;
+    
+    for (auto& level : levels_) {
+        uint64_t left = idx & ~uint64_t(1);
+        FieldElement right = (left + 1 < below->size()) ? (*below)[left + 1] : DefaultLeaf();
+        idx /= 2;
+        level[idx] = HashPair((*below)[left], right);
+        below = &level;
+    }
+    
+    root_ = levels_.empty() ? leaves_[0] : levels_.back()[0];
+}
+
+std::vector<FieldElement> VectorCommitment::HashLevel(const std::vector<FieldElement>& level,
+                                                      util::ThreadPool* pool) {
+    // Below this many parents a level is not worth handing to the pool
+    constexpr size_t MIN_PAIRS_PER_TASK = 256;
+    
+    const size_t numPairs = (level.size() + 1) / 2;
+    std::vector<FieldElement> parents(numPairs);
+    
+    auto hashRange = [&level, &parents](size_t begin, size_t end) {
+        std::vector<std::pair<FieldElement, FieldElement>> pairs;
+        pairs.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            pairs.emplace_back(level[2 * i],
+                               2 * i + 1 < level.size() ? level[2 * i + 1] : DefaultLeaf());
+        }
+        std::vector<FieldElement> hashes = Poseidon::HashMany(pairs);
+        std::copy(hashes.begin(), hashes.end(), parents.begin() + begin);
+    };
+    
+    if (pool == nullptr || !pool->IsRunning() || pool->ThreadCount() < 2 ||
+        numPairs < 2 * MIN_PAIRS_PER_TASK) {
+        hashRange(0, numPairs);
+        return parents;
+    }
+    
+    // A few tasks per worker keeps them busy without flooding the queue
+    size_t tasks = pool->ThreadCount() * 4;
+    size_t chunk = std::max(MIN_PAIRS_PER_TASK, (numPairs + tasks - 1) / tasks);
+    std::vector<std::future<void>> futures;
+    size_t begin = 0;
+    for (; begin < numPairs; begin += chunk) {
+        try {
+            futures.push_back(pool->Submit(hashRange, begin, std::min(begin + chunk, numPairs)));
+        } catch (const std::runtime_error&) {
+            break;  // Pool stopped or its queue is full: hash the rest here
+        }
+    }
+    if (begin < numPairs) {
+        hashRange(begin, numPairs);
+    }
+    for (auto& f : futures) {
+        f.get();
+    }
+    
+    return parents;
+}
+
 FieldElement VectorCommitment::DefaultLeaf() {
     // Use hash of empty bytes as default leaf
     return FieldElement::Zero();
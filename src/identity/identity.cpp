@@ -6,6 +6,8 @@
 #include <shurium/core/hex.h>
 #include <shurium/core/random.h>
 #include <shurium/crypto/sha256.h>
+#include <shurium/db/database.h>
+#include <shurium/db/leveldb.h>
 #include <shurium/wallet/keystore.h>
 
 #include <algorithm>
@@ -650,14 +652,31 @@ std::optional<UBIClaim> UBIClaim::FromBytes(const Byte* data, size_t len) {
 // IdentityManager
 // ============================================================================
 
+namespace {
+
+std::string RecordKey(const CommitmentHash& hash) {
+    std::string key(1, db::prefix::IDENTITY_RECORD);
+    key.append(reinterpret_cast<const char*>(hash.data()), hash.size());
+    return key;
+}
+
+} // anonymous namespace
+
 IdentityManager::IdentityManager() 
-    : config_(),
-      verifier_(std::make_unique<ProofVerifier>()) {
+    : IdentityManager(Config()) {
 }
 
 IdentityManager::IdentityManager(const Config& config)
+    : IdentityManager(config, std::make_unique<db::MemoryDatabase>()) {
+}
+
+IdentityManager::IdentityManager(const Config& config, std::unique_ptr<db::Database> recordDb)
     : config_(config),
+      recordDb_(std::move(recordDb)),
       verifier_(std::make_unique<ProofVerifier>()) {
+    if (!recordDb_) {
+        recordDb_ = std::make_unique<db::MemoryDatabase>();
+    }
 }
 
 IdentityManager::~IdentityManager() = default;
@@ -671,8 +690,12 @@ bool IdentityManager::Initialize(const Byte* data, size_t len) {
     
     // Would deserialize full state here
     // For now, just reset
-    identities_.clear();
-    idToCommitment_.clear();
+    entries_.clear();
+    commitments_.clear();
+    commitmentSlots_.clear();
+    idSlots_.clear();
+    recordCache_.clear();
+    recordCacheIndex_.clear();
     
     return true;
 }
@@ -689,11 +712,11 @@ void IdentityManager::SetBlockContext(uint32_t height, int64_t timestamp) {
     }
     
     // Activate pending identities that have passed the activation delay
-    for (auto& [hash, record] : identities_) {
-        if (record.status == IdentityStatus::Pending) {
-            if (height >= record.registrationHeight + config_.activationDelay) {
-                record.status = IdentityStatus::Active;
-                record.lastUpdateHeight = height;
+    for (auto& entry : entries_) {
+        if (entry.status == static_cast<uint8_t>(IdentityStatus::Pending)) {
+            if (height >= entry.registrationHeight + config_.activationDelay) {
+                entry.status = static_cast<uint8_t>(IdentityStatus::Active);
+                entry.lastUpdateHeight = height;
             }
         }
     }
@@ -726,7 +749,7 @@ std::optional<IdentityRecord> IdentityManager::RegisterIdentity(
     }
     
     // Check capacity
-    if (config_.maxIdentities > 0 && identities_.size() >= config_.maxIdentities) {
+    if (config_.maxIdentities > 0 && entries_.size() >= config_.maxIdentities) {
         return std::nullopt;
     }
     
@@ -734,9 +757,6 @@ std::optional<IdentityRecord> IdentityManager::RegisterIdentity(
     IdentityRecord record = IdentityRecord::Create(
         request.commitment, currentHeight_, currentTime_);
     
-    // Add to identity tree
-    record.treeIndex = AddToTree(request.commitment);
-    
     // Set activation delay
     if (config_.activationDelay > 0) {
         record.status = IdentityStatus::Pending;
@@ -749,15 +769,45 @@ std::optional<IdentityRecord> IdentityManager::RegisterIdentity(
         record.expirationHeight = currentHeight_ + config_.identityLifetime;
     }
     
-    // Store
-    identities_[request.commitment.GetHash()] = record;
-    idToCommitment_[record.id] = request.commitment.GetHash();
+    // The record as registered goes to the database, the fields that
+    // change stay in memory. It is written before the leaf, which cannot
+    // be taken back.
+    const CommitmentHash& hash = request.commitment.GetHash();
+    record.treeIndex = identityTree_.Size();
+    auto recordBytes = record.ToBytes();
+    if (!recordDb_->Put(RecordKey(hash),
+                        db::Slice(reinterpret_cast<const char*>(recordBytes.data()),
+                                  recordBytes.size())).ok()) {
+        return std::nullopt;
+    }
+    
+    // Add to identity tree
+    auto treeIndex = AddToTree(request.commitment);
+    if (!treeIndex) {
+        recordDb_->Delete(RecordKey(hash));
+        return std::nullopt;
+    }
+    record.treeIndex = *treeIndex;
+    
+    IdentityEntry entry;
+    entry.treeIndex = record.treeIndex;
+    entry.registrationHeight = record.registrationHeight;
+    entry.lastUpdateHeight = record.lastUpdateHeight;
+    entry.expirationHeight = record.expirationHeight;
+    entry.status = static_cast<uint8_t>(record.status);
+    entry.verificationLevel = static_cast<uint8_t>(record.verificationLevel);
+    
+    size_t slot = entries_.size();
+    entries_.push_back(entry);
+    commitments_.push_back(hash);
+    commitmentSlots_.emplace(hash, slot);
+    idSlots_.emplace(record.id, slot);
     
     return record;
 }
 
 bool IdentityManager::IsCommitmentRegistered(const IdentityCommitment& commitment) const {
-    return identities_.find(commitment.GetHash()) != identities_.end();
+    return commitmentSlots_.find(commitment.GetHash()) != commitmentSlots_.end();
 }
 
 std::optional<IdentityRecord> IdentityManager::GetIdentity(
@@ -765,54 +815,48 @@ std::optional<IdentityRecord> IdentityManager::GetIdentity(
     
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = identities_.find(commitment.GetHash());
-    if (it == identities_.end()) {
+    auto it = commitmentSlots_.find(commitment.GetHash());
+    if (it == commitmentSlots_.end()) {
         return std::nullopt;
     }
-    return it->second;
+    return LoadRecord(it->second);
 }
 
 std::optional<IdentityRecord> IdentityManager::GetIdentityById(const Hash256& id) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto idIt = idToCommitment_.find(id);
-    if (idIt == idToCommitment_.end()) {
+    auto it = idSlots_.find(id);
+    if (it == idSlots_.end()) {
         return std::nullopt;
     }
-    
-    auto it = identities_.find(idIt->second);
-    if (it == identities_.end()) {
-        return std::nullopt;
-    }
-    return it->second;
+    return LoadRecord(it->second);
 }
 
 std::optional<IdentityRecord> IdentityManager::GetIdentityByIndex(uint64_t index) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    for (const auto& [_, record] : identities_) {
-        if (record.treeIndex == index) {
-            return record;
-        }
+    // Each registration appends one leaf, so slots follow tree indices
+    if (entries_.empty() || index < entries_.front().treeIndex) {
+        return std::nullopt;
     }
-    return std::nullopt;
+    uint64_t slot = index - entries_.front().treeIndex;
+    if (slot >= entries_.size() || entries_[slot].treeIndex != index) {
+        return std::nullopt;
+    }
+    return LoadRecord(static_cast<size_t>(slot));
 }
 
 bool IdentityManager::UpdateIdentityStatus(const Hash256& id, IdentityStatus newStatus) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto idIt = idToCommitment_.find(id);
-    if (idIt == idToCommitment_.end()) {
-        return false;
-    }
-    
-    auto it = identities_.find(idIt->second);
-    if (it == identities_.end()) {
+    auto it = idSlots_.find(id);
+    if (it == idSlots_.end()) {
         return false;
     }
     
-    it->second.status = newStatus;
-    it->second.lastUpdateHeight = currentHeight_;
+    IdentityEntry& entry = entries_[it->second];
+    entry.status = static_cast<uint8_t>(newStatus);
+    entry.lastUpdateHeight = currentHeight_;
     return true;
 }
 
@@ -821,10 +865,13 @@ std::vector<IdentityRecord> IdentityManager::GetIdentitiesByStatus(
     
     std::lock_guard<std::mutex> lock(mutex_);
     
+    // A scan over every identity would flush the cache, so it reads past it
     std::vector<IdentityRecord> result;
-    for (const auto& [_, record] : identities_) {
-        if (record.status == status) {
-            result.push_back(record);
+    for (size_t slot = 0; slot < entries_.size(); ++slot) {
+        if (entries_[slot].status == static_cast<uint8_t>(status)) {
+            if (auto record = LoadRecord(slot, false)) {
+                result.push_back(std::move(*record));
+            }
         }
     }
     return result;
@@ -835,17 +882,22 @@ FieldElement IdentityManager::GetIdentityRoot() const {
     return identityTree_.GetRoot();
 }
 
+bool IdentityManager::IsKnownIdentityRoot(const FieldElement& root) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return identityTree_.IsKnownRoot(root);
+}
+
 std::optional<VectorCommitment::MerkleProof> IdentityManager::GetMembershipProof(
     const IdentityCommitment& commitment) const {
     
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = identities_.find(commitment.GetHash());
-    if (it == identities_.end()) {
+    auto it = commitmentSlots_.find(commitment.GetHash());
+    if (it == commitmentSlots_.end()) {
         return std::nullopt;
     }
     
-    return identityTree_.Prove(it->second.treeIndex);
+    return identityTree_.Prove(entries_[it->second].treeIndex);
 }
 
 bool IdentityManager::VerifyMembershipProof(const IdentityCommitment& commitment,
@@ -857,8 +909,13 @@ bool IdentityManager::VerifyMembershipProof(const IdentityCommitment& commitment
 bool IdentityManager::ProcessUBIClaim(const UBIClaim& claim) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    // Verify the claim
+    // Verify the claim. It may be proven against a recent root rather
+    // than the current one, so registrations since do not invalidate it.
     FieldElement root = identityTree_.GetRoot();
+    const auto& inputs = claim.proof.GetZKProof().GetPublicInputs();
+    if (inputs.Count() > 0 && identityTree_.IsKnownRoot(inputs.values[0])) {
+        root = inputs.values[0];
+    }
     if (!claim.Verify(root, nullifierSet_)) {
         return false;
     }
@@ -886,13 +943,13 @@ IdentityManager::Stats IdentityManager::GetStats() const {
     std::lock_guard<std::mutex> lock(mutex_);
     
     Stats stats;
-    stats.totalIdentities = identities_.size();
+    stats.totalIdentities = entries_.size();
     stats.activeIdentities = 0;
     stats.pendingIdentities = 0;
     stats.revokedIdentities = 0;
     
-    for (const auto& [_, record] : identities_) {
-        switch (record.status) {
+    for (const auto& entry : entries_) {
+        switch (static_cast<IdentityStatus>(entry.status)) {
             case IdentityStatus::Active:
                 stats.activeIdentities++;
                 break;
@@ -909,13 +966,16 @@ IdentityManager::Stats IdentityManager::GetStats() const {
     
     stats.claimsThisEpoch = nullifierSet_.CountForEpoch(currentEpoch_);
     stats.currentEpoch = currentEpoch_;
+    stats.memoryUsage = MemoryUsageLocked();
+    stats.recordCacheHits = recordCacheHits_;
+    stats.recordCacheMisses = recordCacheMisses_;
     
     return stats;
 }
 
 uint64_t IdentityManager::GetIdentityCount() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return identities_.size();
+    return entries_.size();
 }
 
 std::vector<Byte> IdentityManager::Serialize() const {
@@ -935,14 +995,18 @@ std::vector<Byte> IdentityManager::Serialize() const {
     }
     
     // Identity count
-    uint64_t count = identities_.size();
+    uint64_t count = entries_.size();
     for (int i = 0; i < 8; ++i) {
         result.push_back(static_cast<Byte>((count >> (i * 8)) & 0xFF));
     }
     
-    // Identities
-    for (const auto& [_, record] : identities_) {
-        auto recordBytes = record.ToBytes();
+    // Identities, in tree order
+    for (size_t slot = 0; slot < entries_.size(); ++slot) {
+        auto record = LoadRecord(slot, false);
+        if (!record) {
+            continue;
+        }
+        auto recordBytes = record->ToBytes();
         uint32_t len = static_cast<uint32_t>(recordBytes.size());
         for (int i = 0; i < 4; ++i) {
             result.push_back(static_cast<Byte>((len >> (i * 8)) & 0xFF));
@@ -971,7 +1035,7 @@ Hash256 IdentityManager::GetStateHash() const {
     hasher.Write(rootBytes.data(), rootBytes.size());
     
     // Hash identity count
-    uint64_t count = identities_.size();
+    uint64_t count = entries_.size();
     Byte countBytes[8];
     for (int i = 0; i < 8; ++i) {
         countBytes[i] = static_cast<Byte>((count >> (i * 8)) & 0xFF);
@@ -990,8 +1054,63 @@ Hash256 IdentityManager::GetStateHash() const {
     return result;
 }
 
-uint64_t IdentityManager::AddToTree(const IdentityCommitment& commitment) {
-    return identityTree_.Add(commitment.ToFieldElement());
+std::optional<uint64_t> IdentityManager::AddToTree(const IdentityCommitment& commitment) {
+    return identityTree_.Append(commitment.ToFieldElement());
+}
+
+std::optional<IdentityRecord> IdentityManager::LoadRecord(size_t slot, bool remember) const {
+    std::optional<IdentityRecord> record;
+    auto cached = recordCacheIndex_.find(slot);
+    if (cached != recordCacheIndex_.end()) {
+        ++recordCacheHits_;
+        recordCache_.splice(recordCache_.begin(), recordCache_, cached->second);
+        record = cached->second->second;
+    } else {
+        ++recordCacheMisses_;
+        std::string value;
+        if (!recordDb_->Get(RecordKey(commitments_[slot]), &value).ok()) {
+            return std::nullopt;
+        }
+        record = IdentityRecord::FromBytes(reinterpret_cast<const Byte*>(value.data()),
+                                           value.size());
+        if (!record) {
+            return std::nullopt;
+        }
+        if (remember && config_.recordCacheSize > 0) {
+            recordCache_.emplace_front(slot, *record);
+            recordCacheIndex_[slot] = recordCache_.begin();
+            if (recordCache_.size() > config_.recordCacheSize) {
+                recordCacheIndex_.erase(recordCache_.back().first);
+                recordCache_.pop_back();
+            }
+        }
+    }
+    
+    const IdentityEntry& entry = entries_[slot];
+    record->treeIndex = entry.treeIndex;
+    record->registrationHeight = entry.registrationHeight;
+    record->lastUpdateHeight = entry.lastUpdateHeight;
+    record->expirationHeight = entry.expirationHeight;
+    record->status = static_cast<IdentityStatus>(entry.status);
+    record->verificationLevel = static_cast<VerificationLevel>(entry.verificationLevel);
+    return record;
+}
+
+size_t IdentityManager::MemoryUsageLocked() const {
+    // Hash map nodes: key, value and next pointer; plus one bucket pointer
+    // each. List nodes: value and two links.
+    size_t commitmentNode = sizeof(CommitmentHash) + sizeof(size_t) + sizeof(void*);
+    size_t idNode = sizeof(Hash256) + sizeof(size_t) + sizeof(void*);
+    size_t cacheNode = sizeof(std::pair<size_t, IdentityRecord>) + 2 * sizeof(void*);
+    size_t cacheIndexNode = 2 * sizeof(size_t) + sizeof(void*);
+    return entries_.capacity() * sizeof(IdentityEntry) +
+           commitments_.capacity() * sizeof(CommitmentHash) +
+           commitmentSlots_.size() * commitmentNode +
+           commitmentSlots_.bucket_count() * sizeof(void*) +
+           idSlots_.size() * idNode + idSlots_.bucket_count() * sizeof(void*) +
+           recordCache_.size() * cacheNode +
+           recordCacheIndex_.size() * cacheIndexNode +
+           recordCacheIndex_.bucket_count() * sizeof(void*);
 }
 
 bool IdentityManager::ValidateRegistration(const RegistrationRequest& request) const {
@@ -0,0 +1,192 @@
+// SHURIUM - Incremental Merkle Tree Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/identity/merkletree.h>
+#include <shurium/crypto/poseidon.h>
+#include <shurium/db/database.h>
+#include <shurium/db/leveldb.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace shurium {
+namespace identity {
+
+namespace {
+
+void AppendBigEndian(std::string& key, uint64_t value) {
+    for (int i = 7; i >= 0; --i) {
+        key.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+/// 'I', level, then index big-endian
+std::string NodeKey(uint32_t level, uint64_t index) {
+    std::string key(1, db::prefix::IDENTITY_NODE);
+    key.push_back(static_cast<char>(level));
+    AppendBigEndian(key, index);
+    return key;
+}
+
+/// 'i', then the number of appends the root followed, big-endian
+std::string RootKey(uint64_t size) {
+    std::string key(1, db::prefix::IDENTITY_ROOT);
+    AppendBigEndian(key, size);
+    return key;
+}
+
+db::Slice FieldSlice(const std::array<Byte, 32>& bytes) {
+    return db::Slice(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+std::optional<FieldElement> ReadField(db::Database& database, const std::string& key) {
+    std::string value;
+    if (!database.Get(key, &value).ok() || value.size() != 32) {
+        return std::nullopt;
+    }
+    return FieldElement::FromBytes(reinterpret_cast<const Byte*>(value.data()), value.size());
+}
+
+} // anonymous namespace
+
+IncrementalMerkleTree::IncrementalMerkleTree(uint32_t depth, size_t rootHistory)
+    : IncrementalMerkleTree(std::make_unique<db::MemoryDatabase>(), depth, rootHistory) {}
+
+IncrementalMerkleTree::IncrementalMerkleTree(std::unique_ptr<db::Database> db,
+                                             uint32_t depth, size_t rootHistory)
+    : depth_(depth), db_(std::move(db)) {
+    if (depth_ == 0 || depth_ > 63) {
+        throw std::invalid_argument("Merkle tree depth must be between 1 and 63");
+    }
+    if (!db_) {
+        db_ = std::make_unique<db::MemoryDatabase>();
+    }
+
+    zeros_.resize(depth_ + 1);
+    zeros_[0] = FieldElement::Zero();
+    for (uint32_t level = 0; level < depth_; ++level) {
+        zeros_[level + 1] = Poseidon::Hash2(zeros_[level], zeros_[level]);
+    }
+    frontier_.resize(depth_);
+    rootHistory_.resize(std::max<size_t>(rootHistory, 1));
+
+    Load();
+}
+
+IncrementalMerkleTree::~IncrementalMerkleTree() = default;
+
+void IncrementalMerkleTree::Load() {
+    size_ = 0;
+    std::string value;
+    if (db_->Get(db::MakeKey(db::prefix::IDENTITY_TREE_SIZE), &value).ok() && value.size() == 8) {
+        for (int i = 0; i < 8; ++i) {
+            size_ |= static_cast<uint64_t>(static_cast<uint8_t>(value[i])) << (i * 8);
+        }
+    }
+
+    // A right child still to come needs its left sibling, already stored
+    for (uint32_t level = 0; level < depth_; ++level) {
+        uint64_t next = size_ >> level;
+        if (next & 1) {
+            frontier_[level] = ReadNode(level, next - 1).value_or(zeros_[level]);
+        }
+    }
+
+    uint64_t oldest = size_ + 1 > rootHistory_.size() ? size_ + 1 - rootHistory_.size() : 0;
+    for (uint64_t n = oldest; n <= size_; ++n) {
+        rootHistory_[n % rootHistory_.size()] =
+            ReadField(*db_, RootKey(n)).value_or(n == 0 ? zeros_[depth_] : FieldElement::Zero());
+    }
+    root_ = rootHistory_[size_ % rootHistory_.size()];
+}
+
+std::optional<uint64_t> IncrementalMerkleTree::Append(const FieldElement& leaf) {
+    uint64_t index = size_;
+    if ((index >> depth_) != 0) {
+        return std::nullopt;  // Full
+    }
+
+    db::WriteBatch batch;
+    std::vector<FieldElement> frontier = frontier_;
+    FieldElement node = leaf;
+    uint64_t idx = index;
+    for (uint32_t level = 0; level < depth_; ++level) {
+        batch.Put(NodeKey(level, idx), FieldSlice(node.ToBytes()));
+        if (idx & 1) {
+            node = Poseidon::Hash2(frontier[level], node);
+        } else {
+            frontier[level] = node;
+            node = Poseidon::Hash2(node, zeros_[level]);
+        }
+        idx >>= 1;
+    }
+
+    uint64_t newSize = index + 1;
+    batch.Put(RootKey(newSize), FieldSlice(node.ToBytes()));
+    if (newSize >= rootHistory_.size()) {
+        batch.Delete(RootKey(newSize - rootHistory_.size()));
+    }
+    std::string sizeValue;
+    for (int i = 0; i < 8; ++i) {
+        sizeValue.push_back(static_cast<char>((newSize >> (i * 8)) & 0xFF));
+    }
+    batch.Put(db::MakeKey(db::prefix::IDENTITY_TREE_SIZE), sizeValue);
+    if (!db_->Write(&batch).ok()) {
+        return std::nullopt;
+    }
+
+    frontier_ = std::move(frontier);
+    size_ = newSize;
+    root_ = node;
+    rootHistory_[size_ % rootHistory_.size()] = root_;
+    return index;
+}
+
+std::optional<VectorCommitment::MerkleProof> IncrementalMerkleTree::Prove(uint64_t index) const {
+    if (index >= size_) {
+        return std::nullopt;
+    }
+
+    VectorCommitment::MerkleProof proof;
+    proof.index = index;
+    proof.siblings.reserve(depth_);
+    proof.pathBits.reserve(depth_);
+
+    for (uint32_t level = 0; level < depth_; ++level) {
+        uint64_t idx = index >> level;
+        uint64_t sibling = idx ^ 1;
+        proof.pathBits.push_back(idx & 1);
+
+        // Siblings past the last written node are empty subtrees
+        if (sibling > ((size_ - 1) >> level)) {
+            proof.siblings.push_back(zeros_[level]);
+            continue;
+        }
+        auto node = ReadNode(level, sibling);
+        if (!node) {
+            return std::nullopt;
+        }
+        proof.siblings.push_back(*node);
+    }
+
+    return proof;
+}
+
+bool IncrementalMerkleTree::IsKnownRoot(const FieldElement& root) const {
+    uint64_t remembered = std::min<uint64_t>(size_ + 1, rootHistory_.size());
+    for (uint64_t i = 0; i < remembered; ++i) {
+        if (rootHistory_[(size_ - i) % rootHistory_.size()] == root) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<FieldElement> IncrementalMerkleTree::ReadNode(uint32_t level, uint64_t index) const {
+    return ReadField(*db_, NodeKey(level, index));
+}
+
+} // namespace identity
+} // namespace shurium
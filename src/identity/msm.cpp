@@ -0,0 +1,59 @@
+// SHURIUM - Multi-Scalar Multiplication Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/identity/msm.h>
+#include <shurium/util/threadpool.h>
+
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+namespace shurium {
+namespace identity {
+
+FieldElement MultiScalarMul(const FieldElement* scalars, const FieldElement* points, size_t n) {
+    return FieldElement::SumOfProducts(scalars, points, n);
+}
+
+FieldElement MultiScalarMul(const std::vector<FieldElement>& scalars,
+                            const std::vector<FieldElement>& points,
+                            util::ThreadPool* pool) {
+    const size_t n = std::min(scalars.size(), points.size());
+    auto sumRange = [&scalars, &points](size_t begin, size_t end) {
+        return FieldElement::SumOfProducts(scalars.data() + begin, points.data() + begin,
+                                           end - begin);
+    };
+
+    if (pool == nullptr || !pool->IsRunning() || pool->ThreadCount() < 2 ||
+        n < 2 * MSM_MIN_TERMS_PER_TASK) {
+        return sumRange(0, n);
+    }
+
+    size_t tasks = pool->ThreadCount();
+    size_t chunk = std::max(MSM_MIN_TERMS_PER_TASK, (n + tasks - 1) / tasks);
+    std::vector<std::future<FieldElement>> futures;
+    size_t begin = 0;
+    for (; begin < n; begin += chunk) {
+        try {
+            futures.push_back(pool->Submit(sumRange, begin, std::min(begin + chunk, n)));
+        } catch (const std::runtime_error&) {
+            break;  // Pool stopped or its queue is full: sum the rest here
+        }
+    }
+    FieldElement sum = begin < n ? sumRange(begin, n) : FieldElement::Zero();
+    for (auto& f : futures) {
+        sum += f.get();
+    }
+    return sum;
+}
+
+FieldElement MultiScalarMul(const FieldElement& a, const FieldElement& P,
+                            const FieldElement& b, const FieldElement& Q) {
+    const FieldElement scalars[2] = {a, b};
+    const FieldElement points[2] = {P, Q};
+    return FieldElement::SumOfProducts(scalars, points, 2);
+}
+
+} // namespace identity
+} // namespace shurium
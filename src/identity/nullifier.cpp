@@ -5,6 +5,8 @@
 #include <shurium/identity/nullifier.h>
 #include <shurium/core/hex.h>
 #include <shurium/core/random.h>
+#include <shurium/db/database.h>
+#include <shurium/db/leveldb.h>
 
 #include <algorithm>
 #include <cstring>
@@ -100,16 +102,97 @@ bool Nullifier::operator<(const Nullifier& other) const {
 // NullifierSet
 // ============================================================================
 
-NullifierSet::NullifierSet() : config_(), mutex_(std::make_unique<std::mutex>()) {}
+namespace {
+
+/// Key prefix of one epoch's nullifiers: 'N' then the epoch big-endian, so
+/// epochs sort in order
+std::string EpochKey(EpochId epoch) {
+    std::string key(1, db::prefix::NULLIFIER);
+    for (int i = 7; i >= 0; --i) {
+        key.push_back(static_cast<char>((epoch >> (i * 8)) & 0xFF));
+    }
+    return key;
+}
+
+std::string NullifierKey(EpochId epoch, const NullifierHash& hash) {
+    std::string key = EpochKey(epoch);
+    key.append(reinterpret_cast<const char*>(hash.data()), hash.size());
+    return key;
+}
+
+constexpr size_t NULLIFIER_KEY_SIZE = 1 + 8 + 32;
+
+/// Split a stored key into its epoch and hash
+bool ParseNullifierKey(const db::Slice& key, EpochId& epoch, NullifierHash& hash) {
+    if (key.size() != NULLIFIER_KEY_SIZE || key[0] != db::prefix::NULLIFIER) {
+        return false;
+    }
+    epoch = 0;
+    for (size_t i = 1; i <= 8; ++i) {
+        epoch = (epoch << 8) | static_cast<uint8_t>(key[i]);
+    }
+    std::memcpy(hash.data(), key.data() + 9, hash.size());
+    return true;
+}
+
+/// Filter bit of probe i. Nullifiers are Poseidon outputs, so their own
+/// bytes serve as the two base hashes.
+size_t FilterBit(const NullifierHash& hash, int i, size_t bits) {
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    std::memcpy(&h1, hash.data(), sizeof(h1));
+    std::memcpy(&h2, hash.data() + 8, sizeof(h2));
+    return static_cast<size_t>((h1 + static_cast<uint64_t>(i) * (h2 | 1)) % bits);
+}
+
+void FilterAdd(std::vector<uint64_t>& filter, const NullifierHash& hash) {
+    size_t bits = filter.size() * 64;
+    for (int i = 0; i < NULLIFIER_FILTER_HASHES; ++i) {
+        size_t bit = FilterBit(hash, i, bits);
+        filter[bit / 64] |= uint64_t{1} << (bit % 64);
+    }
+}
+
+bool FilterMightContain(const std::vector<uint64_t>& filter, const NullifierHash& hash) {
+    size_t bits = filter.size() * 64;
+    for (int i = 0; i < NULLIFIER_FILTER_HASHES; ++i) {
+        size_t bit = FilterBit(hash, i, bits);
+        if ((filter[bit / 64] & (uint64_t{1} << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+NullifierSet::NullifierSet()
+    : config_(), db_(std::make_unique<db::MemoryDatabase>()),
+      mutex_(std::make_unique<std::mutex>()) {}
 
 NullifierSet::NullifierSet(const Config& config) 
-    : config_(config), mutex_(std::make_unique<std::mutex>()) {}
+    : config_(config), db_(std::make_unique<db::MemoryDatabase>()),
+      mutex_(std::make_unique<std::mutex>()) {}
+
+NullifierSet::NullifierSet(const Config& config, std::unique_ptr<db::Database> db)
+    : config_(config), db_(std::move(db)), mutex_(std::make_unique<std::mutex>()) {
+    if (!db_) {
+        db_ = std::make_unique<db::MemoryDatabase>();
+    }
+    ReloadLocked();
+}
 
 NullifierSet::~NullifierSet() = default;
 
 void NullifierSet::SetCurrentEpoch(EpochId epoch) {
     std::lock_guard<std::mutex> lock(*mutex_);
     currentEpoch_ = epoch;
+    
+    std::string value;
+    for (int i = 0; i < 8; ++i) {
+        value.push_back(static_cast<char>((epoch >> (i * 8)) & 0xFF));
+    }
+    db_->Put(db::MakeKey(db::prefix::NULLIFIER_EPOCH), value);
 }
 
 bool NullifierSet::Contains(const Nullifier& nullifier) const {
@@ -118,13 +201,15 @@ bool NullifierSet::Contains(const Nullifier& nullifier) const {
 
 bool NullifierSet::Contains(const NullifierHash& hash, EpochId epoch) const {
     std::lock_guard<std::mutex> lock(*mutex_);
-    
-    auto epochIt = epochNullifiers_.find(epoch);
-    if (epochIt == epochNullifiers_.end()) {
+    return ContainsLocked(hash, epoch);
+}
+
+bool NullifierSet::ContainsLocked(const NullifierHash& hash, EpochId epoch) const {
+    auto epochIt = epochs_.find(epoch);
+    if (epochIt == epochs_.end() || !FilterMightContain(epochIt->second.filter, hash)) {
         return false;
     }
-    
-    return epochIt->second.find(hash) != epochIt->second.end();
+    return db_->Exists(NullifierKey(epoch, hash));
 }
 
 NullifierSet::AddResult NullifierSet::Add(const Nullifier& nullifier) {
@@ -139,27 +224,44 @@ NullifierSet::AddResult NullifierSet::Add(const Nullifier& nullifier) {
     
     // Check capacity
     if (config_.maxPerEpoch > 0) {
-        auto epochIt = epochNullifiers_.find(epoch);
-        if (epochIt != epochNullifiers_.end() && 
-            epochIt->second.size() >= config_.maxPerEpoch) {
+        auto epochIt = epochs_.find(epoch);
+        if (epochIt != epochs_.end() && 
+            epochIt->second.count >= config_.maxPerEpoch) {
             return AddResult::SetFull;
         }
     }
     
-    // Try to add
-    auto& epochSet = epochNullifiers_[epoch];
-    auto result = epochSet.insert(nullifier.GetHash());
-    
-    if (!result.second) {
+    if (ContainsLocked(nullifier.GetHash(), epoch)) {
         return AddResult::AlreadyExists;
     }
     
+    if (!db_->Put(NullifierKey(epoch, nullifier.GetHash()), db::Slice()).ok()) {
+        return AddResult::StorageError;
+    }
+    
+    auto& state = epochs_[epoch];
+    ReserveFilter(epoch, state, state.count + 1);
+    FilterAdd(state.filter, nullifier.GetHash());
+    ++state.count;
+    
     return AddResult::Success;
 }
 
 bool NullifierSet::AddBatch(const std::vector<Nullifier>& nullifiers) {
     std::lock_guard<std::mutex> lock(*mutex_);
     
+    db::WriteBatch batch;
+    if (!StageBatch(nullifiers, batch)) {
+        return false;
+    }
+    if (!db_->Write(&batch).ok()) {
+        ReloadLocked();
+        return false;
+    }
+    return true;
+}
+
+bool NullifierSet::StageBatch(const std::vector<Nullifier>& nullifiers, db::WriteBatch& batch) {
     // First check all are valid and unique
     std::map<EpochId, std::set<NullifierHash>> toAdd;
     
@@ -171,28 +273,23 @@ bool NullifierSet::AddBatch(const std::vector<Nullifier>& nullifiers) {
         }
         
         // Check not already in set
-        auto epochIt = epochNullifiers_.find(epoch);
-        if (epochIt != epochNullifiers_.end()) {
-            if (epochIt->second.find(nullifier.GetHash()) != epochIt->second.end()) {
-                return false;  // Duplicate
-            }
+        if (ContainsLocked(nullifier.GetHash(), epoch)) {
+            return false;  // Duplicate
         }
         
         // Check not in batch already
-        if (toAdd[epoch].find(nullifier.GetHash()) != toAdd[epoch].end()) {
+        if (!toAdd[epoch].insert(nullifier.GetHash()).second) {
             return false;  // Duplicate in batch
         }
-        
-        toAdd[epoch].insert(nullifier.GetHash());
     }
     
     // Check capacity constraints
     if (config_.maxPerEpoch > 0) {
         for (const auto& [epoch, hashes] : toAdd) {
-            size_t existingCount = 0;
-            auto epochIt = epochNullifiers_.find(epoch);
-            if (epochIt != epochNullifiers_.end()) {
-                existingCount = epochIt->second.size();
+            uint64_t existingCount = 0;
+            auto epochIt = epochs_.find(epoch);
+            if (epochIt != epochs_.end()) {
+                existingCount = epochIt->second.count;
             }
             
             if (existingCount + hashes.size() > config_.maxPerEpoch) {
@@ -201,44 +298,80 @@ bool NullifierSet::AddBatch(const std::vector<Nullifier>& nullifiers) {
         }
     }
     
-    // All valid, add them
+    // All valid, stage them
     for (const auto& [epoch, hashes] : toAdd) {
+        auto& state = epochs_[epoch];
+        ReserveFilter(epoch, state, state.count + hashes.size());
         for (const auto& hash : hashes) {
-            epochNullifiers_[epoch].insert(hash);
+            batch.Put(NullifierKey(epoch, hash), db::Slice());
+            FilterAdd(state.filter, hash);
         }
+        state.count += hashes.size();
     }
     
     return true;
 }
 
+void NullifierSet::ReserveFilter(EpochId epoch, EpochState& state, uint64_t keys) {
+    if (keys <= state.filterKeys) {
+        return;
+    }
+    
+    state.filterKeys = std::max(NULLIFIER_FILTER_MIN_KEYS, keys * 2);
+    state.filter.assign(state.filterKeys * NULLIFIER_FILTER_BITS_PER_KEY / 64, 0);
+    if (state.count == 0) {
+        return;
+    }
+    
+    // Bloom filters cannot grow in place: re-add the epoch's stored hashes
+    std::string prefix = EpochKey(epoch);
+    auto it = db_->NewIterator();
+    for (it->Seek(prefix); it->Valid(); it->Next()) {
+        EpochId keyEpoch;
+        NullifierHash hash;
+        if (!ParseNullifierKey(it->key(), keyEpoch, hash) || keyEpoch != epoch) {
+            break;
+        }
+        FilterAdd(state.filter, hash);
+    }
+}
+
 bool NullifierSet::Remove(const Nullifier& nullifier) {
     std::lock_guard<std::mutex> lock(*mutex_);
     
-    auto epochIt = epochNullifiers_.find(nullifier.GetEpoch());
-    if (epochIt == epochNullifiers_.end()) {
+    EpochId epoch = nullifier.GetEpoch();
+    if (!ContainsLocked(nullifier.GetHash(), epoch)) {
+        return false;
+    }
+    if (!db_->Delete(NullifierKey(epoch, nullifier.GetHash())).ok()) {
         return false;
     }
     
-    return epochIt->second.erase(nullifier.GetHash()) > 0;
+    // The hash's filter bits stay set; they may be shared with others
+    auto epochIt = epochs_.find(epoch);
+    if (--epochIt->second.count == 0) {
+        epochs_.erase(epochIt);
+    }
+    return true;
 }
 
 uint64_t NullifierSet::CountForEpoch(EpochId epoch) const {
     std::lock_guard<std::mutex> lock(*mutex_);
     
-    auto epochIt = epochNullifiers_.find(epoch);
-    if (epochIt == epochNullifiers_.end()) {
+    auto epochIt = epochs_.find(epoch);
+    if (epochIt == epochs_.end()) {
         return 0;
     }
     
-    return epochIt->second.size();
+    return epochIt->second.count;
 }
 
 uint64_t NullifierSet::TotalCount() const {
     std::lock_guard<std::mutex> lock(*mutex_);
     
     uint64_t total = 0;
-    for (const auto& [epoch, nullifiers] : epochNullifiers_) {
-        total += nullifiers.size();
+    for (const auto& [epoch, state] : epochs_) {
+        total += state.count;
     }
     return total;
 }
@@ -247,9 +380,9 @@ std::vector<EpochId> NullifierSet::GetEpochs() const {
     std::lock_guard<std::mutex> lock(*mutex_);
     
     std::vector<EpochId> epochs;
-    epochs.reserve(epochNullifiers_.size());
+    epochs.reserve(epochs_.size());
     
-    for (const auto& [epoch, _] : epochNullifiers_) {
+    for (const auto& [epoch, _] : epochs_) {
         epochs.push_back(epoch);
     }
     
@@ -266,24 +399,79 @@ uint64_t NullifierSet::Prune(uint32_t keepEpochs) {
 uint64_t NullifierSet::PruneOlderThan(EpochId epoch) {
     std::lock_guard<std::mutex> lock(*mutex_);
     
-    uint64_t pruned = 0;
-    
-    auto it = epochNullifiers_.begin();
-    while (it != epochNullifiers_.end()) {
-        if (it->first < epoch) {
-            pruned += it->second.size();
-            it = epochNullifiers_.erase(it);
-        } else {
-            ++it;
-        }
+    db::WriteBatch batch;
+    uint64_t pruned = DropEpochs(epochs_.lower_bound(epoch), batch);
+    if (!db_->Write(&batch).ok()) {
+        ReloadLocked();
+        return 0;
     }
-    
     return pruned;
 }
 
+uint64_t NullifierSet::DropEpochs(std::map<EpochId, EpochState>::iterator end,
+                                  db::WriteBatch& batch) {
+    // The database has no range delete, so walk each epoch's key range
+    uint64_t dropped = 0;
+    auto it = db_->NewIterator();
+    auto epochIt = epochs_.begin();
+    while (epochIt != end) {
+        std::string prefix = EpochKey(epochIt->first);
+        for (it->Seek(prefix); it->Valid(); it->Next()) {
+            db::Slice key = it->key();
+            if (key.size() < prefix.size() ||
+                std::memcmp(key.data(), prefix.data(), prefix.size()) != 0) {
+                break;
+            }
+            batch.Delete(key);
+        }
+        dropped += epochIt->second.count;
+        epochIt = epochs_.erase(epochIt);
+    }
+    return dropped;
+}
+
 void NullifierSet::Clear() {
     std::lock_guard<std::mutex> lock(*mutex_);
-    epochNullifiers_.clear();
+    
+    db::WriteBatch batch;
+    DropEpochs(epochs_.end(), batch);
+    if (!db_->Write(&batch).ok()) {
+        ReloadLocked();
+    }
+}
+
+void NullifierSet::Reload() {
+    std::lock_guard<std::mutex> lock(*mutex_);
+    ReloadLocked();
+}
+
+void NullifierSet::ReloadLocked() {
+    epochs_.clear();
+    
+    std::string value;
+    if (db_->Get(db::MakeKey(db::prefix::NULLIFIER_EPOCH), &value).ok() && value.size() == 8) {
+        currentEpoch_ = 0;
+        for (int i = 0; i < 8; ++i) {
+            currentEpoch_ |= static_cast<EpochId>(static_cast<uint8_t>(value[i])) << (i * 8);
+        }
+    }
+    
+    // Count first, then size each filter for its epoch in one scan of it
+    auto it = db_->NewIterator();
+    for (it->Seek(db::MakeKey(db::prefix::NULLIFIER)); it->Valid(); it->Next()) {
+        EpochId epoch;
+        NullifierHash hash;
+        if (!ParseNullifierKey(it->key(), epoch, hash)) {
+            if (it->key().size() == 0 || it->key()[0] != db::prefix::NULLIFIER) {
+                break;
+            }
+            continue;
+        }
+        ++epochs_[epoch].count;
+    }
+    for (auto& [epoch, state] : epochs_) {
+        ReserveFilter(epoch, state, state.count);
+    }
 }
 
 std::vector<Byte> NullifierSet::Serialize() const {
@@ -297,26 +485,32 @@ std::vector<Byte> NullifierSet::Serialize() const {
     }
     
     // Number of epochs (4 bytes)
-    uint32_t numEpochs = static_cast<uint32_t>(epochNullifiers_.size());
+    uint32_t numEpochs = static_cast<uint32_t>(epochs_.size());
     for (int i = 0; i < 4; ++i) {
         result.push_back(static_cast<Byte>((numEpochs >> (i * 8)) & 0xFF));
     }
     
     // Each epoch
-    for (const auto& [epoch, nullifiers] : epochNullifiers_) {
+    auto it = db_->NewIterator();
+    for (const auto& [epoch, state] : epochs_) {
         // Epoch ID (8 bytes)
         for (int i = 0; i < 8; ++i) {
             result.push_back(static_cast<Byte>((epoch >> (i * 8)) & 0xFF));
         }
         
         // Number of nullifiers (4 bytes)
-        uint32_t count = static_cast<uint32_t>(nullifiers.size());
+        uint32_t count = static_cast<uint32_t>(state.count);
         for (int i = 0; i < 4; ++i) {
             result.push_back(static_cast<Byte>((count >> (i * 8)) & 0xFF));
         }
         
         // Nullifier hashes
-        for (const auto& hash : nullifiers) {
+        for (it->Seek(EpochKey(epoch)); it->Valid(); it->Next()) {
+            EpochId keyEpoch;
+            NullifierHash hash;
+            if (!ParseNullifierKey(it->key(), keyEpoch, hash) || keyEpoch != epoch) {
+                break;
+            }
             result.insert(result.end(), hash.begin(), hash.end());
         }
     }
@@ -331,12 +525,15 @@ std::unique_ptr<NullifierSet> NullifierSet::Deserialize(const Byte* data, size_t
     }
     
     auto set = std::make_unique<NullifierSet>(config);
+    db::WriteBatch batch;
     
     // Current epoch
     set->currentEpoch_ = 0;
     for (int i = 0; i < 8; ++i) {
         set->currentEpoch_ |= static_cast<EpochId>(data[i]) << (i * 8);
     }
+    batch.Put(db::MakeKey(db::prefix::NULLIFIER_EPOCH),
+              db::Slice(reinterpret_cast<const char*>(data), 8));
     data += 8;
     len -= 8;
     
@@ -371,7 +568,7 @@ std::unique_ptr<NullifierSet> NullifierSet::Deserialize(const Byte* data, size_t
         len -= 4;
         
         // Validate length
-        if (len < count * 32) {
+        if (len < static_cast<size_t>(count) * 32) {
             return nullptr;
         }
         
@@ -379,12 +576,16 @@ std::unique_ptr<NullifierSet> NullifierSet::Deserialize(const Byte* data, size_t
         for (uint32_t n = 0; n < count; ++n) {
             NullifierHash hash;
             std::copy(data, data + 32, hash.begin());
-            set->epochNullifiers_[epoch].insert(hash);
+            batch.Put(NullifierKey(epoch, hash), db::Slice());
             data += 32;
             len -= 32;
         }
     }
     
+    if (!set->db_->Write(&batch).ok()) {
+        return nullptr;
+    }
+    set->Reload();
     return set;
 }
 
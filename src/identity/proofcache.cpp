@@ -0,0 +1,30 @@
+// SHURIUM - Identity Proof Verification Cache Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/identity/proofcache.h>
+
+namespace shurium {
+namespace identity {
+
+Hash256 ProofCache::ComputeEntry(Span<const Byte> proof,
+                                 Span<const Byte> publicInputs,
+                                 Span<const Byte> verificationKey) const {
+    // Length prefixes keep the three fields from sliding into each other
+    SHA256 hasher = SaltedHasher();
+    WriteWithLength(hasher, proof);
+    WriteWithLength(hasher, publicInputs);
+    WriteWithLength(hasher, verificationKey);
+
+    Hash256 entry;
+    hasher.Finalize(entry.data());
+    return entry;
+}
+
+ProofCache& GetProofCache() {
+    static ProofCache cache;
+    return cache;
+}
+
+} // namespace identity
+} // namespace shurium
@@ -3,12 +3,14 @@
 // MIT License
 
 #include <shurium/identity/rangeproof.h>
+#include <shurium/identity/msm.h>
 #include <shurium/crypto/poseidon.h>
 #include <shurium/core/random.h>
 
 #include <algorithm>
 #include <cmath>
-#include <map>
+#include <memory>
+#include <stdexcept>
 
 namespace shurium {
 namespace identity {
@@ -19,13 +21,12 @@ namespace identity {
 
 FieldElement PedersenCommit(uint64_t value, const FieldElement& randomness) {
     const auto& gens = RangeProofGenerators::Get();
-    FieldElement v(value);
-    return (v * gens.G()) + (randomness * gens.H());
+    return MultiScalarMul(FieldElement(value), gens.G(), randomness, gens.H());
 }
 
 FieldElement PedersenCommit(const FieldElement& value, const FieldElement& randomness) {
     const auto& gens = RangeProofGenerators::Get();
-    return (value * gens.G()) + (randomness * gens.H());
+    return MultiScalarMul(value, gens.G(), randomness, gens.H());
 }
 
 FieldElement GenerateBlinding() {
@@ -40,11 +41,7 @@ FieldElement InnerProduct(const std::vector<FieldElement>& a,
         return FieldElement::Zero();
     }
     
-    FieldElement result = FieldElement::Zero();
-    for (size_t i = 0; i < a.size(); ++i) {
-        result = result + (a[i] * b[i]);
-    }
-    return result;
+    return MultiScalarMul(a.data(), b.data(), a.size());
 }
 
 std::vector<FieldElement> HadamardProduct(const std::vector<FieldElement>& a,
@@ -65,10 +62,6 @@ std::vector<FieldElement> HadamardProduct(const std::vector<FieldElement>& a,
 // RangeProofGenerators
 // ============================================================================
 
-namespace {
-    std::map<size_t, std::unique_ptr<RangeProofGenerators>> generatorCache;
-}
-
 RangeProofGenerators::RangeProofGenerators(size_t numBits) : numBits_(numBits) {
     // Generate g and h from nothing-up-my-sleeve strings
     g_ = DeriveGenerator("SHURIUM_RANGEPROOF_G");
@@ -85,15 +78,28 @@ RangeProofGenerators::RangeProofGenerators(size_t numBits) : numBits_(numBits) {
     }
 }
 
+RangeProofGenerators::RangeProofGenerators(const RangeProofGenerators& full, size_t numBits)
+    : numBits_(numBits), g_(full.g_), h_(full.h_),
+      gi_(full.gi_.begin(), full.gi_.begin() + numBits),
+      hi_(full.hi_.begin(), full.hi_.begin() + numBits), u_(full.u_) {}
+
 const RangeProofGenerators& RangeProofGenerators::Get(size_t numBits) {
-    auto it = generatorCache.find(numBits);
-    if (it == generatorCache.end()) {
-        auto gens = std::unique_ptr<RangeProofGenerators>(new RangeProofGenerators(numBits));
-        auto* ptr = gens.get();
-        generatorCache[numBits] = std::move(gens);
-        return *ptr;
-    }
-    return *it->second;
+    // Every bit count's set is built by the first caller while any others
+    // wait, then never changes
+    static const auto table = [] {
+        std::vector<std::unique_ptr<const RangeProofGenerators>> sets;
+        auto full = std::unique_ptr<RangeProofGenerators>(new RangeProofGenerators(MAX_RANGE_BITS));
+        for (size_t n = 0; n < MAX_RANGE_BITS; ++n) {
+            sets.emplace_back(new RangeProofGenerators(*full, n));
+        }
+        sets.push_back(std::move(full));
+        return sets;
+    }();
+    
+    if (numBits > MAX_RANGE_BITS) {
+        throw std::out_of_range("Range proof bit count exceeds MAX_RANGE_BITS");
+    }
+    return *table[numBits];
 }
 
 // ============================================================================
@@ -231,6 +237,10 @@ std::optional<RangeProof> RangeProofProver::Prove(
     const FieldElement& commitment,
     size_t numBits) {
     
+    if (numBits > MAX_RANGE_BITS) {
+        return std::nullopt;
+    }
+    
     const auto& gens = RangeProofGenerators::Get(numBits);
     
     RangeProof proof;
@@ -260,16 +270,10 @@ std::optional<RangeProof> RangeProofProver::Prove(
     FieldElement rho = GenerateBlinding();
     
     // Compute A = h^alpha * G_i^aL_i * H_i^aR_i
-    proof.A = alpha * gens.H();
-    for (size_t i = 0; i < numBits; ++i) {
-        proof.A = proof.A + (aL[i] * gens.Gi()[i]) + (aR[i] * gens.Hi()[i]);
-    }
+    proof.A = alpha * gens.H() + MultiScalarMul(aL, gens.Gi()) + MultiScalarMul(aR, gens.Hi());
     
     // Compute S = h^rho * G_i^sL_i * H_i^sR_i
-    proof.S = rho * gens.H();
-    for (size_t i = 0; i < numBits; ++i) {
-        proof.S = proof.S + (sL[i] * gens.Gi()[i]) + (sR[i] * gens.Hi()[i]);
-    }
+    proof.S = rho * gens.H() + MultiScalarMul(sL, gens.Gi()) + MultiScalarMul(sR, gens.Hi());
     
     // Challenge y (using Fiat-Shamir)
     Poseidon hasher;
@@ -408,16 +412,12 @@ std::optional<RangeProof> RangeProofProver::Prove(
         FieldElement c_R = InnerProduct(a_hi, b_lo);
         
         // Compute L = g_hi^a_lo * h_lo^b_hi * u^c_L
-        FieldElement L_val = c_L * gens.U();
-        for (size_t i = 0; i < n; ++i) {
-            L_val = L_val + (a_lo[i] * g_hi[i]) + (b_hi[i] * h_lo[i]);
-        }
+        FieldElement L_val = c_L * gens.U() + MultiScalarMul(a_lo, g_hi) +
+                             MultiScalarMul(b_hi, h_lo);
         
         // Compute R = g_lo^a_hi * h_hi^b_lo * u^c_R
-        FieldElement R_val = c_R * gens.U();
-        for (size_t i = 0; i < n; ++i) {
-            R_val = R_val + (a_hi[i] * g_lo[i]) + (b_lo[i] * h_hi[i]);
-        }
+        FieldElement R_val = c_R * gens.U() + MultiScalarMul(a_hi, g_lo) +
+                             MultiScalarMul(b_lo, h_hi);
         
         proof.L.push_back(L_val);
         proof.R.push_back(R_val);
@@ -462,46 +462,96 @@ std::optional<RangeProof> RangeProofProver::Prove(
 // RangeProofVerifier
 // ============================================================================
 
-bool RangeProofVerifier::Verify(
-    const RangeProof& proof,
-    const FieldElement& commitment) {
-    
+namespace {
+
+/// Fiat-Shamir challenges of a range proof, as the verifier recomputes them
+struct RangeProofChallenges {
+    FieldElement y;
+    FieldElement z;
+    FieldElement x;
+    
+    /// Inner product argument challenge per round
+    std::vector<FieldElement> u;
+};
+
+/// Number of inner product rounds for numBits (log2, rounded down)
+size_t InnerProductRounds(size_t numBits) {
+    size_t rounds = 0;
+    for (size_t n = numBits; n > 1; n /= 2) {
+        ++rounds;
+    }
+    return rounds;
+}
+
+/// The challenges y, z and x; false if the proof is malformed
+bool ComputeOuterChallenges(const RangeProof& proof, const FieldElement& commitment,
+                            RangeProofChallenges& out) {
     if (!proof.IsWellFormed()) {
         return false;
     }
     
-    const auto& gens = RangeProofGenerators::Get(proof.numBits);
-    size_t numBits = proof.numBits;
-    
     // Check that L and R have the correct size (log2(numBits))
-    size_t expectedRounds = 0;
-    size_t n = numBits;
-    while (n > 1) {
-        n /= 2;
-        expectedRounds++;
-    }
+    size_t expectedRounds = InnerProductRounds(proof.numBits);
     if (proof.L.size() != expectedRounds || proof.R.size() != expectedRounds) {
         return false;
     }
     
-    // Recompute challenges
     Poseidon hasher;
     hasher.Absorb(commitment);
     hasher.Absorb(proof.A);
     hasher.Absorb(proof.S);
-    FieldElement y = hasher.Squeeze();
+    out.y = hasher.Squeeze();
     
     hasher.Reset();
     hasher.Absorb(proof.A);
     hasher.Absorb(proof.S);
-    hasher.Absorb(y);
-    FieldElement z = hasher.Squeeze();
+    hasher.Absorb(out.y);
+    out.z = hasher.Squeeze();
     
     hasher.Reset();
     hasher.Absorb(proof.T1);
     hasher.Absorb(proof.T2);
-    hasher.Absorb(z);
-    FieldElement x = hasher.Squeeze();
+    hasher.Absorb(out.z);
+    out.x = hasher.Squeeze();
+    return true;
+}
+
+/// The inner product challenges u_i, chained from w through L_i and R_i
+void ComputeInnerChallenges(const RangeProof& proof, RangeProofChallenges& out) {
+    Poseidon hasher;
+    hasher.Absorb(proof.t_hat);
+    hasher.Absorb(proof.tau_x);
+    hasher.Absorb(proof.mu);
+    FieldElement w = hasher.Squeeze();
+    
+    out.u.resize(proof.L.size());
+    for (size_t i = 0; i < proof.L.size(); ++i) {
+        hasher.Reset();
+        hasher.Absorb(proof.L[i]);
+        hasher.Absorb(proof.R[i]);
+        hasher.Absorb(w);
+        out.u[i] = hasher.Squeeze();
+        w = out.u[i];
+    }
+}
+
+} // anonymous namespace
+
+bool RangeProofVerifier::Verify(
+    const RangeProof& proof,
+    const FieldElement& commitment) {
+    
+    RangeProofChallenges challenges;
+    if (!ComputeOuterChallenges(proof, commitment, challenges)) {
+        return false;
+    }
+    
+    const auto& gens = RangeProofGenerators::Get(proof.numBits);
+    size_t numBits = proof.numBits;
+    size_t expectedRounds = proof.L.size();
+    const FieldElement& y = challenges.y;
+    const FieldElement& z = challenges.z;
+    const FieldElement& x = challenges.x;
     
     // Compute delta(y, z) = (z - z^2) * <1, y^n> - z^3 * <1, 2^n>
     std::vector<FieldElement> yn(numBits);
@@ -537,26 +587,12 @@ bool RangeProofVerifier::Verify(
     // Verify Inner Product Argument
     // ========================================================================
     
-    // Recompute challenge w for inner product argument
-    hasher.Reset();
-    hasher.Absorb(proof.t_hat);
-    hasher.Absorb(proof.tau_x);
-    hasher.Absorb(proof.mu);
-    FieldElement w = hasher.Squeeze();
-    
     // Compute all challenges u_i from L and R
-    std::vector<FieldElement> u_challenges(expectedRounds);
+    ComputeInnerChallenges(proof, challenges);
+    const std::vector<FieldElement>& u_challenges = challenges.u;
     std::vector<FieldElement> u_inv(expectedRounds);
-    
-    FieldElement w_curr = w;
     for (size_t i = 0; i < expectedRounds; ++i) {
-        hasher.Reset();
-        hasher.Absorb(proof.L[i]);
-        hasher.Absorb(proof.R[i]);
-        hasher.Absorb(w_curr);
-        u_challenges[i] = hasher.Squeeze();
         u_inv[i] = u_challenges[i].Inverse();
-        w_curr = u_challenges[i];
     }
     
     // Compute scalars s_i for reconstructing the final g and h
@@ -589,17 +625,14 @@ bool RangeProofVerifier::Verify(
     // ========================================================================
     
     // Compute g' = sum(s[i] * G[i]) (single generator from compressed G vector)
-    FieldElement g_prime = FieldElement::Zero();
-    for (size_t i = 0; i < numBits; ++i) {
-        g_prime = g_prime + (s[i] * gens.Gi()[i]);
-    }
+    FieldElement g_prime = MultiScalarMul(s, gens.Gi());
     
     // Compute h' = sum(s[i]^(-1) * y^(-i) * H[i]) (single generator from compressed H vector)
-    FieldElement h_prime = FieldElement::Zero();
+    std::vector<FieldElement> h_prime_scalars(numBits);
     for (size_t i = 0; i < numBits; ++i) {
-        FieldElement s_inv = s[i].Inverse();
-        h_prime = h_prime + (s_inv * y_inv_pow[i] * gens.Hi()[i]);
+        h_prime_scalars[i] = s[i].Inverse() * y_inv_pow[i];
     }
+    FieldElement h_prime = MultiScalarMul(h_prime_scalars, gens.Hi());
     
     // The expected P from the inner product argument final values
     // P_inner = a * g' + b * h' + (a * b) * U
@@ -613,48 +646,241 @@ bool RangeProofVerifier::Verify(
     FieldElement P_orig = proof.A + (x * proof.S);
     
     // Subtract z from G generators
+    FieldElement sum_gi = FieldElement::Zero();
     for (size_t i = 0; i < numBits; ++i) {
-        P_orig = P_orig - (z * gens.Gi()[i]);
+        sum_gi += gens.Gi()[i];
     }
+    P_orig = P_orig - (z * sum_gi);
     
     // Add (z*y^i + z^2*2^i) scaled by y^(-i) to H generators
+    std::vector<FieldElement> h_scalars(numBits);
     for (size_t i = 0; i < numBits; ++i) {
-        FieldElement h_scalar = z * yn[i] + z.Square() * twon[i];
-        P_orig = P_orig + (h_scalar * y_inv_pow[i] * gens.Hi()[i]);
+        h_scalars[i] = (z * yn[i] + z.Square() * twon[i]) * y_inv_pow[i];
     }
+    P_orig = P_orig + MultiScalarMul(h_scalars, gens.Hi());
     
     // Subtract mu*H and add t_hat*U
     P_orig = P_orig - (proof.mu * gens.H());
     P_orig = P_orig + (proof.t_hat * gens.U());
     
     // Add L and R contributions
+    std::vector<FieldElement> u_sq(expectedRounds);
+    std::vector<FieldElement> u_inv_sq(expectedRounds);
     for (size_t i = 0; i < expectedRounds; ++i) {
-        FieldElement u_sq = u_challenges[i].Square();
-        FieldElement u_inv_sq = u_inv[i].Square();
-        P_orig = P_orig + (u_sq * proof.L[i]) + (u_inv_sq * proof.R[i]);
+        u_sq[i] = u_challenges[i].Square();
+        u_inv_sq[i] = u_inv[i].Square();
     }
+    P_orig = P_orig + MultiScalarMul(u_sq, proof.L) + MultiScalarMul(u_inv_sq, proof.R);
     
     // Final verification: P_inner should equal P_orig
     return P_inner == P_orig;
 }
 
+namespace {
+
+/// A well-formed proof of a batch with its challenges and their inverses
+struct PreparedRangeProof {
+    size_t index{0};
+    const RangeProof* proof{nullptr};
+    const FieldElement* commitment{nullptr};
+    RangeProofChallenges challenges;
+    FieldElement yInv;
+    std::vector<FieldElement> uInv;
+};
+
+/// Invert every nonzero element with a single field inversion (Montgomery's
+/// trick); zeros stay zero, as Inverse() leaves them
+void BatchInvert(std::vector<FieldElement>& values) {
+    std::vector<FieldElement> prefix(values.size());
+    FieldElement product = FieldElement::One();
+    for (size_t i = 0; i < values.size(); ++i) {
+        prefix[i] = product;
+        if (!values[i].IsZero()) {
+            product *= values[i];
+        }
+    }
+    FieldElement inverse = product.Inverse();
+    for (size_t i = values.size(); i-- > 0; ) {
+        if (values[i].IsZero()) {
+            continue;
+        }
+        FieldElement next = inverse * values[i];
+        values[i] = inverse * prefix[i];
+        inverse = next;
+    }
+}
+
+FieldElement RandomWeight() {
+    std::array<Byte, 32> randBytes;
+    GetRandBytes(randBytes.data(), randBytes.size());
+    return FieldElement::FromBytes(randBytes.data(), 32);
+}
+
+/**
+ * Check the proofs in [begin, end) at once. Each proof's two verification
+ * equations (the t_hat check and the inner product check) are moved to one
+ * side, weighted by fresh random scalars and summed; the terms over the
+ * shared generators G, H, U, G_i and H_i are gathered into one coefficient
+ * each, so the whole batch ends in a single multi-scalar product. A batch
+ * holding an invalid proof passes with probability about 1/p.
+ */
+bool CheckAggregated(const std::vector<PreparedRangeProof>& prepared,
+                     size_t begin, size_t end) {
+    size_t maxBits = 0;
+    for (size_t k = begin; k < end; ++k) {
+        maxBits = std::max<size_t>(maxBits, prepared[k].proof->numBits);
+    }
+    // G_i and H_i do not depend on the bit count, so the widest set serves all
+    const auto& gens = RangeProofGenerators::Get(maxBits);
+    
+    FieldElement gCoef, hCoef, uCoef;
+    std::vector<FieldElement> giCoef(maxBits);
+    std::vector<FieldElement> hiCoef(maxBits);
+    FieldElement total;  // Terms over each proof's own values
+    const FieldElement two(2);
+    
+    for (size_t k = begin; k < end; ++k) {
+        const PreparedRangeProof& p = prepared[k];
+        const RangeProof& proof = *p.proof;
+        const FieldElement& y = p.challenges.y;
+        const FieldElement& z = p.challenges.z;
+        const FieldElement& x = p.challenges.x;
+        const std::vector<FieldElement>& u = p.challenges.u;
+        size_t numBits = proof.numBits;
+        size_t rounds = u.size();
+        FieldElement zz = z.Square();
+        FieldElement xx = x.Square();
+        
+        FieldElement c1 = RandomWeight();  // t_hat equation
+        FieldElement c2 = RandomWeight();  // inner product equation
+        
+        // g^t_hat * h^tau_x - V^(z^2) * g^delta * T1^x * T2^(x^2)
+        total -= c1 * (zz * *p.commitment + x * proof.T1 + xx * proof.T2);
+        hCoef += c1 * proof.tau_x + c2 * proof.mu;
+        
+        // P_inner - P_orig, as in Verify()
+        FieldElement pointTerms = proof.A + x * proof.S;
+        std::vector<FieldElement> uSq(rounds);
+        std::vector<FieldElement> uInvSq(rounds);
+        for (size_t j = 0; j < rounds; ++j) {
+            uSq[j] = u[j].Square();
+            uInvSq[j] = p.uInv[j].Square();
+        }
+        pointTerms += MultiScalarMul(uSq, proof.L) + MultiScalarMul(uInvSq, proof.R);
+        total -= c2 * pointTerms;
+        uCoef += c2 * (proof.a * proof.b - proof.t_hat);
+        
+        FieldElement c2a = c2 * proof.a;
+        FieldElement c2b = c2 * proof.b;
+        FieldElement c2z = c2 * z;
+        FieldElement c2zz = c2 * zz;
+        FieldElement sumYn, sum2n;
+        FieldElement yPow = FieldElement::One();
+        FieldElement yInvPow = FieldElement::One();
+        FieldElement twoPow = FieldElement::One();
+        for (size_t i = 0; i < numBits; ++i) {
+            // s_i and its inverse, the product of the opposite choices
+            FieldElement si = FieldElement::One();
+            FieldElement siInv = FieldElement::One();
+            for (size_t j = 0; j < rounds; ++j) {
+                if ((i >> (rounds - 1 - j)) & 1) {
+                    si *= u[j];
+                    siInv *= p.uInv[j];
+                } else {
+                    si *= p.uInv[j];
+                    siInv *= u[j];
+                }
+            }
+            giCoef[i] += c2a * si + c2z;
+            hiCoef[i] += (c2b * siInv - c2zz * twoPow) * yInvPow - c2z;
+            
+            sumYn += yPow;
+            sum2n += twoPow;
+            yPow *= y;
+            yInvPow *= p.yInv;
+            twoPow *= two;
+        }
+        
+        FieldElement delta = (z - zz) * sumYn - zz * z * sum2n;
+        gCoef += c1 * (proof.t_hat - delta);
+    }
+    
+    total += gCoef * gens.G() + hCoef * gens.H() + uCoef * gens.U();
+    total += MultiScalarMul(giCoef, gens.Gi()) + MultiScalarMul(hiCoef, gens.Hi());
+    return total.IsZero();
+}
+
+/// Narrow a failing range of a batch down to its invalid proofs by halving it
+void BisectInvalid(const std::vector<PreparedRangeProof>& prepared, size_t begin,
+                   size_t end, std::vector<size_t>& invalid) {
+    if (end - begin == 1) {
+        invalid.push_back(prepared[begin].index);
+        return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    if (!CheckAggregated(prepared, begin, mid)) {
+        BisectInvalid(prepared, begin, mid, invalid);
+    }
+    if (!CheckAggregated(prepared, mid, end)) {
+        BisectInvalid(prepared, mid, end, invalid);
+    }
+}
+
+} // anonymous namespace
+
 bool RangeProofVerifier::BatchVerify(
     const std::vector<RangeProof>& proofs,
-    const std::vector<FieldElement>& commitments) {
+    const std::vector<FieldElement>& commitments,
+    std::vector<size_t>* invalid) {
     
     if (proofs.size() != commitments.size()) {
         return false;
     }
+    if (invalid) {
+        invalid->clear();
+    }
     
-    // For simplicity, verify each proof individually
-    // In production, batch verification would be more efficient
+    // Recompute every proof's challenges; malformed proofs fail on their own
+    std::vector<PreparedRangeProof> prepared;
+    std::vector<size_t> malformed;
+    prepared.reserve(proofs.size());
     for (size_t i = 0; i < proofs.size(); ++i) {
-        if (!Verify(proofs[i], commitments[i])) {
-            return false;
+        PreparedRangeProof p;
+        p.index = i;
+        p.proof = &proofs[i];
+        p.commitment = &commitments[i];
+        if (!ComputeOuterChallenges(proofs[i], commitments[i], p.challenges)) {
+            malformed.push_back(i);
+            continue;
         }
+        ComputeInnerChallenges(proofs[i], p.challenges);
+        prepared.push_back(std::move(p));
     }
     
-    return true;
+    // One inversion for every y and u_i of the batch
+    std::vector<FieldElement> inverses;
+    for (const auto& p : prepared) {
+        inverses.push_back(p.challenges.y);
+        inverses.insert(inverses.end(), p.challenges.u.begin(), p.challenges.u.end());
+    }
+    BatchInvert(inverses);
+    size_t next = 0;
+    for (auto& p : prepared) {
+        p.yInv = inverses[next++];
+        p.uInv.assign(inverses.begin() + next, inverses.begin() + next + p.challenges.u.size());
+        next += p.challenges.u.size();
+    }
+    
+    bool aggregateOk = prepared.empty() || CheckAggregated(prepared, 0, prepared.size());
+    bool ok = aggregateOk && malformed.empty();
+    if (!ok && invalid) {
+        if (!aggregateOk) {
+            BisectInvalid(prepared, 0, prepared.size(), *invalid);
+        }
+        invalid->insert(invalid->end(), malformed.begin(), malformed.end());
+        std::sort(invalid->begin(), invalid->end());
+    }
+    return ok;
 }
 
 // ============================================================================
@@ -3,6 +3,7 @@
 // MIT License
 
 #include <shurium/identity/sigma.h>
+#include <shurium/identity/msm.h>
 #include <shurium/crypto/poseidon.h>
 #include <shurium/core/random.h>
 #include <shurium/core/hex.h>
@@ -153,6 +154,55 @@ bool SchnorrVerifier::Verify(
     return lhs == rhs;
 }
 
+bool SchnorrVerifier::BatchVerify(
+    const std::vector<SchnorrStatement>& statements,
+    std::vector<size_t>* invalid) {
+    
+    bool ok = true;
+    FieldElement sharedGenerator;
+    FieldElement sharedResponse;  // sum of w_i*s_i over proofs using sharedGenerator
+    FieldElement lhs;
+    FieldElement rhs;
+    
+    for (size_t i = 0; i < statements.size() && ok; ++i) {
+        const SchnorrStatement& st = statements[i];
+        if (!st.proof.IsWellFormed()) {
+            ok = false;
+            break;
+        }
+        FieldElement c = ComputeChallenge(st.publicKey, st.proof.commitment, st.context);
+        
+        std::array<Byte, 32> randBytes;
+        GetRandBytes(randBytes.data(), randBytes.size());
+        FieldElement w = FieldElement::FromBytes(randBytes.data(), 32);
+        
+        // Proofs over the first generator share its multiplication
+        if (i == 0) {
+            sharedGenerator = st.generator;
+        }
+        if (st.generator == sharedGenerator) {
+            sharedResponse += w * st.proof.response;
+        } else {
+            lhs += w * (st.proof.response * st.generator);
+        }
+        rhs += w * (st.proof.commitment + (c * st.publicKey));
+    }
+    
+    if (ok) {
+        ok = (lhs + sharedResponse * sharedGenerator) == rhs;
+    }
+    if (!ok && invalid) {
+        invalid->clear();
+        for (size_t i = 0; i < statements.size(); ++i) {
+            const SchnorrStatement& st = statements[i];
+            if (!Verify(st.proof, st.generator, st.publicKey, st.context)) {
+                invalid->push_back(i);
+            }
+        }
+    }
+    return ok;
+}
+
 FieldElement SchnorrVerifier::ComputeChallenge(
     const FieldElement& publicKey,
     const FieldElement& commitment,
@@ -227,7 +277,7 @@ PedersenOpeningProof PedersenOpeningProver::Prove(
     FieldElement s_r = FieldElement::FromBytes(randBytes2.data(), 32);
     
     // Compute commitment A = g^s_v * h^s_r
-    FieldElement A = (s_v * generatorG) + (s_r * generatorH);
+    FieldElement A = MultiScalarMul(s_v, generatorG, s_r, generatorH);
     
     // Compute challenge
     Poseidon hasher;
@@ -275,7 +325,7 @@ bool PedersenOpeningVerifier::Verify(
     FieldElement c = hasher.Squeeze();
     
     // Verify: g^z_v * h^z_r = A * C^c
-    FieldElement lhs = (proof.responseValue * generatorG) + (proof.responseRandomness * generatorH);
+    FieldElement lhs = MultiScalarMul(proof.responseValue, generatorG, proof.responseRandomness, generatorH);
     FieldElement rhs = proof.commitment + (c * commitment);
     
     return lhs == rhs;
@@ -354,8 +404,8 @@ EqualityProof EqualityProver::Prove(
     // Compute two commitments with shared s_v
     // A1 = g^s_v * h1^s_r1
     // A2 = g^s_v * h2^s_r2
-    FieldElement A1 = (s_v * generatorG) + (s_r1 * generatorH1);
-    FieldElement A2 = (s_v * generatorG) + (s_r2 * generatorH2);
+    FieldElement A1 = MultiScalarMul(s_v, generatorG, s_r1, generatorH1);
+    FieldElement A2 = MultiScalarMul(s_v, generatorG, s_r2, generatorH2);
     
     // Compute challenge
     Poseidon hasher;
@@ -414,10 +464,10 @@ bool EqualityVerifier::Verify(
     // Verify both equations:
     // g^z_v * h1^z_r1 = A1 * C1^c
     // g^z_v * h2^z_r2 = A2 * C2^c
-    FieldElement lhs1 = (proof.responseValue * generatorG) + (proof.responseRandom1 * generatorH1);
+    FieldElement lhs1 = MultiScalarMul(proof.responseValue, generatorG, proof.responseRandom1, generatorH1);
     FieldElement rhs1 = proof.commitment1 + (c * commitment1);
     
-    FieldElement lhs2 = (proof.responseValue * generatorG) + (proof.responseRandom2 * generatorH2);
+    FieldElement lhs2 = MultiScalarMul(proof.responseValue, generatorG, proof.responseRandom2, generatorH2);
     FieldElement rhs2 = proof.commitment2 + (c * commitment2);
     
     return (lhs1 == rhs1) && (lhs2 == rhs2);
@@ -4,14 +4,19 @@
 
 #include <shurium/identity/zkproof.h>
 #include <shurium/identity/commitment.h>
+#include <shurium/identity/proofcache.h>
 #include <shurium/core/hex.h>
 #include <shurium/core/random.h>
 #include <shurium/crypto/sha256.h>
 #include <shurium/crypto/poseidon.h>
+#include <shurium/util/threadpool.h>
 
 #include <algorithm>
 #include <cstring>
+#include <future>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
 
 namespace shurium {
@@ -649,7 +654,10 @@ std::optional<IdentityProof> IdentityProof::FromBytes(const Byte* data, size_t l
 
 class ProofVerifier::Impl {
 public:
-    std::map<std::string, VerificationKey> keys;
+    /// Guards keys; prepared keys themselves are immutable and shared
+    mutable std::shared_mutex mutex;
+    std::map<std::string, std::shared_ptr<const PreparedVerificationKey>> keys;
+    ProofCache* cache = &GetProofCache();
 };
 
 ProofVerifier::ProofVerifier() : impl_(std::make_unique<Impl>()) {}
@@ -657,29 +665,97 @@ ProofVerifier::ProofVerifier() : impl_(std::make_unique<Impl>()) {}
 ProofVerifier::~ProofVerifier() = default;
 
 void ProofVerifier::RegisterKey(const std::string& circuitId, const VerificationKey& key) {
-    impl_->keys[circuitId] = key;
+    auto prepared = std::make_shared<const PreparedVerificationKey>(key);
+    std::unique_lock<std::shared_mutex> lock(impl_->mutex);
+    impl_->keys[circuitId] = std::move(prepared);
 }
 
 bool ProofVerifier::HasKey(const std::string& circuitId) const {
-    return impl_->keys.find(circuitId) != impl_->keys.end();
+    return GetPreparedKey(circuitId) != nullptr;
 }
 
 std::optional<VerificationKey> ProofVerifier::GetKey(const std::string& circuitId) const {
+    auto prepared = GetPreparedKey(circuitId);
+    if (!prepared) {
+        return std::nullopt;
+    }
+    return prepared->key;
+}
+
+std::shared_ptr<const PreparedVerificationKey>
+ProofVerifier::GetPreparedKey(const std::string& circuitId) const {
+    std::shared_lock<std::shared_mutex> lock(impl_->mutex);
     auto it = impl_->keys.find(circuitId);
     if (it == impl_->keys.end()) {
-        return std::nullopt;
+        return nullptr;
     }
     return it->second;
 }
 
+void ProofVerifier::SetCache(ProofCache* cache) {
+    impl_->cache = cache;
+}
+
+ProofCache* ProofVerifier::GetCache() const {
+    return impl_->cache;
+}
+
 bool ProofVerifier::Verify(const ZKProof& proof, const std::string& circuitId) const {
-    auto key = GetKey(circuitId);
-    if (!key) {
+    auto prepared = GetPreparedKey(circuitId);
+    if (!prepared) {
         return false;
     }
+    return VerifyPrepared(proof, *prepared);
+}
+
+std::vector<bool> ProofVerifier::VerifyBatch(const std::vector<const ZKProof*>& proofs,
+                                             const std::string& circuitId,
+                                             util::ThreadPool* pool) const {
+    const size_t n = proofs.size();
+    auto prepared = GetPreparedKey(circuitId);
+    if (!prepared) {
+        return std::vector<bool>(n, false);
+    }
+    
+    std::vector<char> valid(n, 0);
+    auto verifyRange = [this, &proofs, &prepared, &valid](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            valid[i] = proofs[i] && VerifyPrepared(*proofs[i], *prepared);
+        }
+    };
+    
+    if (pool == nullptr || !pool->IsRunning() || pool->ThreadCount() < 2 ||
+        n < 2 * PROOF_BATCH_MIN_PER_TASK) {
+        verifyRange(0, n);
+    } else {
+        size_t tasks = pool->ThreadCount();
+        size_t chunk = std::max(PROOF_BATCH_MIN_PER_TASK, (n + tasks - 1) / tasks);
+        std::vector<std::future<void>> futures;
+        size_t begin = 0;
+        for (; begin < n; begin += chunk) {
+            try {
+                futures.push_back(pool->Submit(verifyRange, begin, std::min(begin + chunk, n)));
+            } catch (const std::runtime_error&) {
+                break;  // Pool stopped or its queue is full: verify the rest here
+            }
+        }
+        if (begin < n) {
+            verifyRange(begin, n);
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    }
+    
+    return std::vector<bool>(valid.begin(), valid.end());
+}
+
+bool ProofVerifier::VerifyPrepared(const ZKProof& proof,
+                                   const PreparedVerificationKey& prepared) const {
+    const VerificationKey& key = prepared.key;
     
     // Check public input count
-    if (proof.GetPublicInputs().Count() != key->numPublicInputs) {
+    if (proof.GetPublicInputs().Count() != key.numPublicInputs) {
         return false;
     }
     
@@ -694,7 +770,24 @@ bool ProofVerifier::Verify(const ZKProof& proof, const std::string& circuitId) c
         if (!g16proof) {
             return false;
         }
-        return VerifyGroth16(*g16proof, proof.GetPublicInputs(), *key);
+        
+        // A proof seen on relay is found here when its block connects
+        ProofCache* cache = impl_->cache;
+        Hash256 entry;
+        if (cache) {
+            entry = cache->ComputeEntry(proof.ToBytes(), proof.GetPublicInputs().ToBytes(),
+                                        prepared.keyBytes);
+            if (cache->Contains(entry)) {
+                return true;
+            }
+        }
+        if (!VerifyGroth16(*g16proof, proof.GetPublicInputs(), key)) {
+            return false;
+        }
+        if (cache) {
+            cache->Insert(entry);
+        }
+        return true;
     }
     
     // Other proof systems not yet implemented
@@ -800,6 +893,26 @@ bool ProofVerifier::VerifyGroth16(const Groth16Proof& proof,
 
 bool ProofVerifier::VerifyIdentityProof(const IdentityProof& proof,
                                         const FieldElement& identityRoot) const {
+    ProofCache* cache = impl_->cache;
+    if (!cache) {
+        return VerifyIdentityProofUncached(proof, identityRoot);
+    }
+    
+    // The root stands in for the public inputs: the proof carries the rest
+    static const std::vector<Byte> identityKeyId = {'i', 'd', 'e', 'n', 't', 'i', 't', 'y'};
+    Hash256 entry = cache->ComputeEntry(proof.ToBytes(), identityRoot.ToBytes(), identityKeyId);
+    if (cache->Contains(entry)) {
+        return true;
+    }
+    if (!VerifyIdentityProofUncached(proof, identityRoot)) {
+        return false;
+    }
+    cache->Insert(entry);
+    return true;
+}
+
+bool ProofVerifier::VerifyIdentityProofUncached(const IdentityProof& proof,
+                                                const FieldElement& identityRoot) const {
     // Get the ZK proof from the identity proof
     const auto& zkProof = proof.GetZKProof();
     
@@ -71,17 +71,18 @@ public:
     std::map<ProblemHash, Problem::Id> problemHashIndex_;
     uint64_t nextProblemId_{1};
     
+    // Unsolved problems in mining order, with miner assignments
+    // (guarded by problemsMutex_)
+    ProblemQueue openProblems_;
+    
     // Solution storage
     mutable std::mutex solutionsMutex_;
     std::map<Solution::Id, Solution> solutions_;
     std::map<Hash256, Solution::Id> solutionHashIndex_;
     std::map<Problem::Id, std::vector<Solution::Id>> problemSolutions_;
+    std::map<Solution::Id, VerificationDetails> verificationResults_;
     uint64_t nextSolutionId_{1};
     
-    // Allocations (problem -> set of miners working on it)
-    mutable std::mutex allocationsMutex_;
-    std::map<Problem::Id, std::set<std::string>> allocations_;
-    
     // Verifier
     SolutionVerifier verifier_;
     
@@ -114,10 +115,19 @@ Marketplace& Marketplace::Instance() {
 Marketplace::Marketplace(MarketplaceConfig config)
     : config_(config)
     , impl_(std::make_unique<Impl>(config)) {
+    impl_->verifier_.SetMaxConcurrent(config_.maxConcurrentVerifications);
+    impl_->verifier_.SetMaxQueued(config_.maxQueuedVerifications);
+    impl_->verifier_.SetTimeout(config_.verificationTimeout);
+    for (const auto& [type, limit] : config_.verificationTypeLimits) {
+        impl_->verifier_.SetTypeConcurrency(type, limit);
+    }
 }
 
 Marketplace::~Marketplace() {
     Stop();
+    // Results report back through OnVerificationComplete, so the workers
+    // must finish while the rest of the marketplace is still alive
+    impl_->verifier_.Shutdown();
 }
 
 void Marketplace::Start() {
@@ -161,6 +171,12 @@ Problem::Id Marketplace::SubmitProblem(Problem problem) {
         return Problem::INVALID_ID;
     }
     
+    // Don't take on work that would tie up a verifier for too long
+    if (config_.maxVerificationCost != 0 &&
+        impl_->verifier_.EstimateVerificationTime(problem) > config_.maxVerificationCost) {
+        return Problem::INVALID_ID;
+    }
+    
     std::lock_guard<std::mutex> lock(impl_->problemsMutex_);
     
     // Check pool size
@@ -176,6 +192,7 @@ Problem::Id Marketplace::SubmitProblem(Problem problem) {
     // Store problem
     impl_->problemHashIndex_[problem.GetHash()] = id;
     impl_->problems_.emplace(id, problem);
+    impl_->openProblems_.Insert(problem);
     impl_->totalProblems_++;
     
     // Notify listeners
@@ -317,6 +334,7 @@ bool Marketplace::CancelProblem(Problem::Id id, const std::string& requester) {
     }
     
     impl_->problemHashIndex_.erase(it->second.GetHash());
+    impl_->openProblems_.Erase(id);
     impl_->problems_.erase(it);
     
     return true;
@@ -483,11 +501,12 @@ bool Marketplace::TriggerVerification(Solution::Id solutionId) {
         return false;
     }
     
-    // Verify synchronously for now (async would use SubmitForVerification)
-    VerificationDetails result = impl_->verifier_.Verify(*problem, solution);
-    
-    // Handle result
-    OnVerificationComplete(solutionId, result);
+    // Solutions failing the structural checks are rejected right here;
+    // the rest complete on a verifier worker
+    impl_->verifier_.SubmitAsync(*problem, std::move(solution),
+        [this](Solution::Id id, const VerificationDetails& result) {
+            OnVerificationComplete(id, result);
+        });
     
     return true;
 }
@@ -502,7 +521,12 @@ std::optional<VerificationDetails> Marketplace::GetVerificationResult(
         return std::nullopt;
     }
     
-    // For now, return a basic result based on status
+    auto result = impl_->verificationResults_.find(solutionId);
+    if (result != impl_->verificationResults_.end()) {
+        return result->second;
+    }
+    
+    // Fall back to a basic result based on status
     VerificationDetails details;
     switch (it->second.GetStatus()) {
         case SolutionStatus::ACCEPTED:
@@ -521,6 +545,18 @@ std::optional<VerificationDetails> Marketplace::GetVerificationResult(
     return details;
 }
 
+uint64_t Marketplace::EstimateVerificationTime(const Problem& problem) const {
+    return impl_->verifier_.EstimateVerificationTime(problem);
+}
+
+bool Marketplace::LoadVerificationCosts(const std::string& path) {
+    return impl_->verifier_.GetCostModel().Load(path);
+}
+
+bool Marketplace::SaveVerificationCosts(const std::string& path) const {
+    return impl_->verifier_.GetCostModel().Save(path);
+}
+
 void Marketplace::OnVerificationComplete(
     Solution::Id solutionId,
     const VerificationDetails& result) {
@@ -545,6 +581,7 @@ void Marketplace::OnVerificationComplete(
         }
         
         it->second.SetVerificationTime(GetTime());
+        impl_->verificationResults_[solutionId] = result;
         solution = it->second;
     }
     
@@ -596,6 +633,7 @@ void Marketplace::DistributeReward(
         if (it != impl_->problems_.end()) {
             it->second.SetSolved(true);
             it->second.SetSolver(solution.GetSolver());
+            impl_->openProblems_.Erase(problem.GetId());
             impl_->totalSolved_++;
         }
     }
@@ -627,28 +665,10 @@ std::vector<const Problem*> Marketplace::GetMiningProblems(
     
     std::lock_guard<std::mutex> lock(impl_->problemsMutex_);
     
-    // Collect eligible problems sorted by reward
-    std::vector<std::pair<Amount, const Problem*>> eligible;
-    
-    for (const auto& [id, problem] : impl_->problems_) {
-        if (!problem.IsSolved() && !problem.IsExpired() && 
-            problem.GetReward() >= minReward) {
-            eligible.emplace_back(problem.GetReward(), &problem);
-        }
-    }
-    
-    // Sort by reward (highest first)
-    std::sort(eligible.begin(), eligible.end(),
-              [](const auto& a, const auto& b) { return a.first > b.first; });
-    
-    // Return top problems
     std::vector<const Problem*> result;
-    result.reserve(std::min(maxCount, eligible.size()));
-    
-    for (size_t i = 0; i < std::min(maxCount, eligible.size()); ++i) {
-        result.push_back(eligible[i].second);
+    for (Problem::Id id : impl_->openProblems_.Top(maxCount, minReward, GetTime())) {
+        result.push_back(&impl_->problems_.at(id));
     }
-    
     return result;
 }
 
@@ -657,19 +677,24 @@ const Problem* Marketplace::GetHighestRewardProblem() const {
     return problems.empty() ? nullptr : problems[0];
 }
 
+const Problem* Marketplace::AssignProblem(const std::string& miner) {
+    std::lock_guard<std::mutex> lock(impl_->problemsMutex_);
+    
+    Problem::Id id = impl_->openProblems_.Assign(miner, GetTime());
+    if (id == Problem::INVALID_ID) {
+        return nullptr;
+    }
+    return &impl_->problems_.at(id);
+}
+
 bool Marketplace::AllocateProblem(Problem::Id id, const std::string& miner) {
-    std::lock_guard<std::mutex> lock(impl_->allocationsMutex_);
-    impl_->allocations_[id].insert(miner);
-    return true;
+    std::lock_guard<std::mutex> lock(impl_->problemsMutex_);
+    return impl_->openProblems_.Assign(id, miner);
 }
 
 void Marketplace::ReleaseProblem(Problem::Id id, const std::string& miner) {
-    std::lock_guard<std::mutex> lock(impl_->allocationsMutex_);
-    
-    auto it = impl_->allocations_.find(id);
-    if (it != impl_->allocations_.end()) {
-        it->second.erase(miner);
-    }
+    std::lock_guard<std::mutex> lock(impl_->problemsMutex_);
+    impl_->openProblems_.Release(id, miner);
 }
 
 // ============================================================================
@@ -800,16 +825,7 @@ MarketplaceStats Marketplace::GetStats() const {
 size_t Marketplace::ProcessExpiredProblems() {
     std::lock_guard<std::mutex> lock(impl_->problemsMutex_);
     
-    int64_t now = GetTime();
-    size_t removed = 0;
-    
-    std::vector<Problem::Id> expired;
-    
-    for (auto& [id, problem] : impl_->problems_) {
-        if (!problem.IsSolved() && problem.IsExpiredAt(now)) {
-            expired.push_back(id);
-        }
-    }
+    std::vector<Problem::Id> expired = impl_->openProblems_.PopExpired(GetTime());
     
     for (Problem::Id id : expired) {
         auto it = impl_->problems_.find(id);
@@ -817,7 +833,6 @@ size_t Marketplace::ProcessExpiredProblems() {
             impl_->problemHashIndex_.erase(it->second.GetHash());
             impl_->problems_.erase(it);
             impl_->totalExpired_++;
-            removed++;
             
             // Notify listeners
             std::lock_guard<std::mutex> listenerLock(impl_->listenersMutex_);
@@ -827,7 +842,7 @@ size_t Marketplace::ProcessExpiredProblems() {
         }
     }
     
-    return removed;
+    return expired.size();
 }
 
 void Marketplace::Cleanup() {
@@ -854,6 +869,9 @@ MiningHelper::MiningHelper(Marketplace& marketplace)
 }
 
 const Problem* MiningHelper::GetNextProblem() {
+    if (!currentMiner_.empty()) {
+        return marketplace_.AssignProblem(currentMiner_);
+    }
     return marketplace_.GetHighestRewardProblem();
 }
 
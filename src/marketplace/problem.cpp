@@ -9,7 +9,9 @@
 #include <algorithm>
 #include <map>
 #include <mutex>
+#include <set>
 #include <sstream>
+#include <cmath>
 
 namespace shurium {
 namespace marketplace {
@@ -281,6 +283,178 @@ Problem ProblemFactory::CreateCustomProblem(
     return problem;
 }
 
+// ============================================================================
+// ProblemQueue Implementation
+// ============================================================================
+
+bool ProblemQueue::Key::operator<(const Key& other) const {
+    // reward / computeSeconds, compared by cross-multiplying
+    __extension__ typedef __int128 int128;
+    int128 lhs = static_cast<int128>(reward) * other.computeSeconds;
+    int128 rhs = static_cast<int128>(other.reward) * computeSeconds;
+    if (lhs != rhs) return lhs > rhs;
+    
+    // No deadline sorts last
+    int64_t lhsDeadline = deadline > 0 ? deadline : INT64_MAX;
+    int64_t rhsDeadline = other.deadline > 0 ? other.deadline : INT64_MAX;
+    if (lhsDeadline != rhsDeadline) return lhsDeadline < rhsDeadline;
+    
+    // Higher target is easier
+    if (target != other.target) return target > other.target;
+    return id < other.id;
+}
+
+void ProblemQueue::Insert(const Problem& problem) {
+    Key key;
+    key.reward = problem.GetReward();
+    key.computeSeconds = std::max<uint32_t>(problem.GetDifficulty().estimatedTime, 1);
+    key.deadline = problem.GetDeadline();
+    key.target = problem.GetDifficulty().target;
+    key.id = problem.GetId();
+    
+    bool assigned = assignees_.count(key.id) != 0;
+    auto existing = keys_.find(key.id);
+    if (existing != keys_.end()) {
+        (assigned ? assigned_ : unassigned_).erase(existing->second);
+        deadlines_.erase({existing->second.deadline, key.id});
+    }
+    
+    keys_[key.id] = key;
+    (assigned ? assigned_ : unassigned_).insert(key);
+    if (key.deadline > 0) {
+        deadlines_.emplace(key.deadline, key.id);
+    }
+}
+
+bool ProblemQueue::Erase(Problem::Id id) {
+    auto it = keys_.find(id);
+    if (it == keys_.end()) {
+        return false;
+    }
+    
+    unassigned_.erase(it->second);
+    assigned_.erase(it->second);
+    deadlines_.erase({it->second.deadline, id});
+    
+    auto miners = assignees_.find(id);
+    if (miners != assignees_.end()) {
+        for (const std::string& miner : miners->second) {
+            minerProblems_.erase(miner);
+        }
+        assignees_.erase(miners);
+    }
+    keys_.erase(it);
+    return true;
+}
+
+void ProblemQueue::Clear() {
+    keys_.clear();
+    unassigned_.clear();
+    assigned_.clear();
+    deadlines_.clear();
+    assignees_.clear();
+    minerProblems_.clear();
+}
+
+const ProblemQueue::Key* ProblemQueue::FirstOpen(const std::set<Key>& keys,
+                                                 Amount minReward, int64_t now) {
+    for (const Key& key : keys) {
+        if (key.reward >= minReward && !key.ExpiredAt(now)) {
+            return &key;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<Problem::Id> ProblemQueue::Top(size_t maxCount, Amount minReward,
+                                           int64_t now) const {
+    // Merge the two sets, best first
+    std::vector<Problem::Id> result;
+    auto a = unassigned_.begin();
+    auto b = assigned_.begin();
+    while (result.size() < maxCount && (a != unassigned_.end() || b != assigned_.end())) {
+        const Key& key = (b == assigned_.end() || (a != unassigned_.end() && *a < *b))
+            ? *a++ : *b++;
+        if (key.reward >= minReward && !key.ExpiredAt(now)) {
+            result.push_back(key.id);
+        }
+    }
+    return result;
+}
+
+Problem::Id ProblemQueue::Assign(const std::string& miner, int64_t now) {
+    auto current = minerProblems_.find(miner);
+    if (current != minerProblems_.end() && !keys_.at(current->second).ExpiredAt(now)) {
+        return current->second;
+    }
+    
+    const Key* key = FirstOpen(unassigned_, 0, now);
+    if (!key) {
+        key = FirstOpen(assigned_, 0, now);
+    }
+    if (!key) {
+        return Problem::INVALID_ID;
+    }
+    
+    Problem::Id id = key->id;
+    Assign(id, miner);
+    return id;
+}
+
+bool ProblemQueue::Assign(Problem::Id id, const std::string& miner) {
+    auto keyIt = keys_.find(id);
+    if (keyIt == keys_.end()) {
+        return false;
+    }
+    
+    auto current = minerProblems_.find(miner);
+    if (current != minerProblems_.end()) {
+        if (current->second == id) {
+            return true;
+        }
+        Release(current->second, miner);
+    }
+    
+    auto& miners = assignees_[id];
+    if (miners.empty()) {
+        unassigned_.erase(keyIt->second);
+        assigned_.insert(keyIt->second);
+    }
+    miners.insert(miner);
+    minerProblems_[miner] = id;
+    return true;
+}
+
+void ProblemQueue::Release(Problem::Id id, const std::string& miner) {
+    auto miners = assignees_.find(id);
+    if (miners == assignees_.end() || miners->second.erase(miner) == 0) {
+        return;
+    }
+    minerProblems_.erase(miner);
+    
+    if (miners->second.empty()) {
+        assignees_.erase(miners);
+        const Key& key = keys_.at(id);
+        assigned_.erase(key);
+        unassigned_.insert(key);
+    }
+}
+
+size_t ProblemQueue::GetAssigneeCount(Problem::Id id) const {
+    auto it = assignees_.find(id);
+    return it == assignees_.end() ? 0 : it->second.size();
+}
+
+std::vector<Problem::Id> ProblemQueue::PopExpired(int64_t time) {
+    std::vector<Problem::Id> expired;
+    while (!deadlines_.empty() && time > deadlines_.begin()->first) {
+        Problem::Id id = deadlines_.begin()->second;
+        expired.push_back(id);
+        Erase(id);
+    }
+    return expired;
+}
+
 // ============================================================================
 // ProblemPool Implementation
 // ============================================================================
@@ -290,6 +464,12 @@ public:
     mutable std::mutex mutex_;
     std::map<Problem::Id, Problem> problems_;
     std::map<ProblemHash, Problem::Id> hashIndex_;
+    
+    /// Unsolved problems, for selection and expiry
+    ProblemQueue open_;
+    
+    /// Solved problems by deadline (they leave the pool on expiry too)
+    std::set<std::pair<int64_t, Problem::Id>> solvedDeadlines_;
     Amount totalRewards_{0};
 };
 
@@ -315,6 +495,11 @@ bool ProblemPool::AddProblem(Problem problem) {
     
     impl_->totalRewards_ += problem.GetReward();
     impl_->hashIndex_[problem.GetHash()] = id;
+    if (problem.IsSolved()) {
+        impl_->solvedDeadlines_.emplace(problem.GetDeadline(), id);
+    } else {
+        impl_->open_.Insert(problem);
+    }
     impl_->problems_.emplace(id, std::move(problem));
     
     return true;
@@ -330,6 +515,8 @@ bool ProblemPool::RemoveProblem(Problem::Id id) {
     
     impl_->totalRewards_ -= it->second.GetReward();
     impl_->hashIndex_.erase(it->second.GetHash());
+    impl_->open_.Erase(id);
+    impl_->solvedDeadlines_.erase({it->second.GetDeadline(), id});
     impl_->problems_.erase(it);
     
     return true;
@@ -372,26 +559,9 @@ std::vector<const Problem*> ProblemPool::GetProblemsForMining(
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     
     std::vector<const Problem*> result;
-    result.reserve(std::min(maxCount, impl_->problems_.size()));
-    
-    // Collect eligible problems
-    std::vector<std::pair<Amount, const Problem*>> eligible;
-    for (const auto& [id, problem] : impl_->problems_) {
-        if (!problem.IsSolved() && !problem.IsExpired() && 
-            problem.GetReward() >= minReward) {
-            eligible.emplace_back(problem.GetReward(), &problem);
-        }
+    for (Problem::Id id : impl_->open_.Top(maxCount, minReward, GetTime())) {
+        result.push_back(&impl_->problems_.at(id));
     }
-    
-    // Sort by reward (highest first)
-    std::sort(eligible.begin(), eligible.end(),
-              [](const auto& a, const auto& b) { return a.first > b.first; });
-    
-    // Return top problems
-    for (size_t i = 0; i < std::min(maxCount, eligible.size()); ++i) {
-        result.push_back(eligible[i].second);
-    }
-    
     return result;
 }
 
@@ -400,6 +570,37 @@ const Problem* ProblemPool::GetHighestRewardProblem() const {
     return problems.empty() ? nullptr : problems[0];
 }
 
+const Problem* ProblemPool::AssignProblem(const std::string& miner) {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    
+    Problem::Id id = impl_->open_.Assign(miner, GetTime());
+    if (id == Problem::INVALID_ID) {
+        return nullptr;
+    }
+    return &impl_->problems_.at(id);
+}
+
+void ProblemPool::ReleaseProblem(Problem::Id id, const std::string& miner) {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    impl_->open_.Release(id, miner);
+}
+
+bool ProblemPool::UpdateReward(Problem::Id id, Amount reward) {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    
+    auto it = impl_->problems_.find(id);
+    if (it == impl_->problems_.end()) {
+        return false;
+    }
+    
+    impl_->totalRewards_ += reward - it->second.GetReward();
+    it->second.SetReward(reward);
+    if (impl_->open_.Contains(id)) {
+        impl_->open_.Insert(it->second);
+    }
+    return true;
+}
+
 std::vector<const Problem*> ProblemPool::GetProblemsByType(ProblemType type) const {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     
@@ -417,30 +618,32 @@ size_t ProblemPool::RemoveExpired() {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     
     int64_t now = GetTime();
-    size_t removed = 0;
-    
-    auto it = impl_->problems_.begin();
-    while (it != impl_->problems_.end()) {
-        if (it->second.IsExpiredAt(now)) {
-            impl_->totalRewards_ -= it->second.GetReward();
-            impl_->hashIndex_.erase(it->second.GetHash());
-            it = impl_->problems_.erase(it);
-            ++removed;
-        } else {
-            ++it;
-        }
+    std::vector<Problem::Id> expired = impl_->open_.PopExpired(now);
+    auto& solved = impl_->solvedDeadlines_;
+    for (auto it = solved.lower_bound({1, 0}); it != solved.end() && now > it->first;) {
+        expired.push_back(it->second);
+        it = solved.erase(it);
+    }
+    
+    for (Problem::Id id : expired) {
+        auto it = impl_->problems_.find(id);
+        impl_->totalRewards_ -= it->second.GetReward();
+        impl_->hashIndex_.erase(it->second.GetHash());
+        impl_->problems_.erase(it);
     }
     
-    return removed;
+    return expired.size();
 }
 
 void ProblemPool::MarkSolved(Problem::Id id, const std::string& solver) {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     
     auto it = impl_->problems_.find(id);
-    if (it != impl_->problems_.end()) {
+    if (it != impl_->problems_.end() && !it->second.IsSolved()) {
         it->second.SetSolved(true);
         it->second.SetSolver(solver);
+        impl_->open_.Erase(id);
+        impl_->solvedDeadlines_.emplace(it->second.GetDeadline(), id);
     }
 }
 
@@ -448,6 +651,8 @@ void ProblemPool::Clear() {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     impl_->problems_.clear();
     impl_->hashIndex_.clear();
+    impl_->open_.Clear();
+    impl_->solvedDeadlines_.clear();
     impl_->totalRewards_ = 0;
 }
 
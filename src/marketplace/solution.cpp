@@ -4,12 +4,15 @@
 
 #include <shurium/marketplace/solution.h>
 #include <shurium/crypto/sha256.h>
+#include <shurium/crypto/siphash.h>
 #include <shurium/util/time.h>
 
 #include <algorithm>
+#include <list>
 #include <map>
 #include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 namespace shurium {
 namespace marketplace {
@@ -194,125 +197,231 @@ Solution SolutionBuilder::BuildWithHash() {
 // SolutionCache Implementation
 // ============================================================================
 
+namespace {
+
+/// Heap and inline bytes held by a cached solution
+size_t EstimateMemory(const Solution& solution) {
+    const SolutionData& data = solution.GetData();
+    return sizeof(Solution) + data.GetResult().size() + data.GetProof().size() +
+           data.GetIntermediates().size() * sizeof(Hash256) + solution.GetSolver().size();
+}
+
+bool IsSettled(const Solution& solution) {
+    switch (solution.GetStatus()) {
+        case SolutionStatus::ACCEPTED:
+        case SolutionStatus::REJECTED:
+        case SolutionStatus::EXPIRED:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // anonymous namespace
+
 class SolutionCache::Impl {
 public:
-    explicit Impl(size_t maxSize) : maxSize_(maxSize) {}
+    struct Entry {
+        std::shared_ptr<const Solution> solution;
+        std::list<Solution::Id>::iterator lruPos;
+        size_t bytes{0};
+    };
+    
+    /// One lock's worth of the cache. Indexes cover this shard's entries.
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Solution::Id, Entry> solutions;
+        std::unordered_map<Hash256, Solution::Id, SaltedHash256Hasher> hashIndex;
+        std::unordered_map<Problem::Id, std::vector<Solution::Id>> problemIndex;
+        
+        /// Most recently used first
+        mutable std::list<Solution::Id> lru;
+        size_t bytes{0};
+        
+        void Erase(std::unordered_map<Solution::Id, Entry>::iterator it) {
+            const Solution& solution = *it->second.solution;
+            auto hashIt = hashIndex.find(solution.GetHash());
+            if (hashIt != hashIndex.end() && hashIt->second == it->first) {
+                hashIndex.erase(hashIt);
+            }
+            auto problemIt = problemIndex.find(solution.GetProblemId());
+            if (problemIt != problemIndex.end()) {
+                auto& ids = problemIt->second;
+                ids.erase(std::remove(ids.begin(), ids.end(), it->first), ids.end());
+                if (ids.empty()) {
+                    problemIndex.erase(problemIt);
+                }
+            }
+            bytes -= it->second.bytes;
+            lru.erase(it->second.lruPos);
+            solutions.erase(it);
+        }
+        
+        /// Evict until within the budgets: the oldest settled solution
+        /// among the least recently used few, else the oldest of all. The
+        /// newest entry stays even if it alone is over the byte budget.
+        void Evict(size_t maxEntries, size_t maxBytes) {
+            constexpr size_t SCAN_LIMIT = 64;
+            while (solutions.size() > 1 &&
+                   (solutions.size() > maxEntries || bytes > maxBytes)) {
+                auto victim = lru.end();
+                size_t scanned = 0;
+                for (auto pos = lru.rbegin(); pos != lru.rend() && scanned < SCAN_LIMIT;
+                     ++pos, ++scanned) {
+                    if (IsSettled(*solutions.at(*pos).solution)) {
+                        victim = std::prev(pos.base());
+                        break;
+                    }
+                }
+                if (victim == lru.end()) {
+                    victim = std::prev(lru.end());
+                }
+                Erase(solutions.find(*victim));
+            }
+        }
+    };
+    
+    Impl(size_t maxSize, size_t maxBytes)
+        : shards_(std::clamp<size_t>(maxSize / 64, 1, MAX_SHARDS)) {
+        // Spread the budgets, rounding up so the shards together hold at
+        // least the requested number of entries
+        maxEntriesPerShard_ = std::max<size_t>(1, (maxSize + shards_.size() - 1) / shards_.size());
+        maxBytesPerShard_ = maxBytes / shards_.size();
+    }
+    
+    Shard& ShardFor(Solution::Id id) const {
+        // Mix so that sequential IDs spread over the shards
+        uint64_t mixed = static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ULL;
+        return shards_[(mixed >> 32) % shards_.size()];
+    }
     
-    mutable std::mutex mutex_;
-    size_t maxSize_;
-    std::map<Solution::Id, Solution> solutions_;
-    std::map<Hash256, Solution::Id> hashIndex_;
-    std::map<Problem::Id, std::vector<Solution::Id>> problemIndex_;
+    /// Mark an entry as just used
+    static void Touch(const Shard& shard, const Entry& entry) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry.lruPos);
+    }
+    
+    mutable std::vector<Shard> shards_;
+    size_t maxEntriesPerShard_;
+    size_t maxBytesPerShard_;
 };
 
-SolutionCache::SolutionCache(size_t maxSize)
-    : impl_(std::make_unique<Impl>(maxSize)) {
+SolutionCache::SolutionCache(size_t maxSize, size_t maxBytes)
+    : impl_(std::make_unique<Impl>(maxSize, maxBytes)) {
 }
 
 SolutionCache::~SolutionCache() = default;
 
 void SolutionCache::Add(Solution solution) {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    Solution::Id id = solution.GetId();
+    Impl::Shard& shard = impl_->ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    // Remove oldest if at capacity
-    while (impl_->solutions_.size() >= impl_->maxSize_ && !impl_->solutions_.empty()) {
-        auto oldest = impl_->solutions_.begin();
-        impl_->hashIndex_.erase(oldest->second.GetHash());
-        
-        // Remove from problem index
-        auto& vec = impl_->problemIndex_[oldest->second.GetProblemId()];
-        vec.erase(std::remove(vec.begin(), vec.end(), oldest->first), vec.end());
-        
-        impl_->solutions_.erase(oldest);
+    auto existing = shard.solutions.find(id);
+    if (existing != shard.solutions.end()) {
+        shard.Erase(existing);
     }
     
-    Solution::Id id = solution.GetId();
-    Problem::Id problemId = solution.GetProblemId();
-    Hash256 hash = solution.GetHash();
+    Impl::Entry entry;
+    entry.bytes = EstimateMemory(solution);
+    entry.solution = std::make_shared<const Solution>(std::move(solution));
+    shard.lru.push_front(id);
+    entry.lruPos = shard.lru.begin();
+    shard.bytes += entry.bytes;
+    
+    shard.hashIndex[entry.solution->GetHash()] = id;
+    shard.problemIndex[entry.solution->GetProblemId()].push_back(id);
+    shard.solutions.emplace(id, std::move(entry));
     
-    impl_->hashIndex_[hash] = id;
-    impl_->problemIndex_[problemId].push_back(id);
-    impl_->solutions_.emplace(id, std::move(solution));
+    shard.Evict(impl_->maxEntriesPerShard_, impl_->maxBytesPerShard_);
 }
 
-const Solution* SolutionCache::Get(Solution::Id id) const {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
+std::shared_ptr<const Solution> SolutionCache::Get(Solution::Id id) const {
+    const Impl::Shard& shard = impl_->ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    auto it = impl_->solutions_.find(id);
-    if (it == impl_->solutions_.end()) {
+    auto it = shard.solutions.find(id);
+    if (it == shard.solutions.end()) {
         return nullptr;
     }
-    return &it->second;
+    Impl::Touch(shard, it->second);
+    return it->second.solution;
 }
 
-const Solution* SolutionCache::GetByHash(const Hash256& hash) const {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
-    
-    auto hashIt = impl_->hashIndex_.find(hash);
-    if (hashIt == impl_->hashIndex_.end()) {
-        return nullptr;
-    }
-    
-    auto it = impl_->solutions_.find(hashIt->second);
-    if (it == impl_->solutions_.end()) {
-        return nullptr;
+std::shared_ptr<const Solution> SolutionCache::GetByHash(const Hash256& hash) const {
+    // The hash says nothing about which shard holds it
+    for (const Impl::Shard& shard : impl_->shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto hashIt = shard.hashIndex.find(hash);
+        if (hashIt == shard.hashIndex.end()) {
+            continue;
+        }
+        const Impl::Entry& entry = shard.solutions.at(hashIt->second);
+        Impl::Touch(shard, entry);
+        return entry.solution;
     }
-    return &it->second;
+    return nullptr;
 }
 
 bool SolutionCache::Has(Solution::Id id) const {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
-    return impl_->solutions_.find(id) != impl_->solutions_.end();
+    const Impl::Shard& shard = impl_->ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.solutions.count(id) != 0;
 }
 
 void SolutionCache::Remove(Solution::Id id) {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    Impl::Shard& shard = impl_->ShardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
     
-    auto it = impl_->solutions_.find(id);
-    if (it == impl_->solutions_.end()) {
-        return;
+    auto it = shard.solutions.find(id);
+    if (it != shard.solutions.end()) {
+        shard.Erase(it);
     }
-    
-    impl_->hashIndex_.erase(it->second.GetHash());
-    
-    // Remove from problem index
-    auto& vec = impl_->problemIndex_[it->second.GetProblemId()];
-    vec.erase(std::remove(vec.begin(), vec.end(), id), vec.end());
-    
-    impl_->solutions_.erase(it);
 }
 
-std::vector<const Solution*> SolutionCache::GetForProblem(Problem::Id problemId) const {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
-    
-    std::vector<const Solution*> result;
-    
-    auto it = impl_->problemIndex_.find(problemId);
-    if (it == impl_->problemIndex_.end()) {
-        return result;
-    }
+std::vector<std::shared_ptr<const Solution>> SolutionCache::GetForProblem(
+    Problem::Id problemId) const {
     
-    result.reserve(it->second.size());
-    for (Solution::Id id : it->second) {
-        auto solIt = impl_->solutions_.find(id);
-        if (solIt != impl_->solutions_.end()) {
-            result.push_back(&solIt->second);
+    std::vector<std::shared_ptr<const Solution>> result;
+    for (const Impl::Shard& shard : impl_->shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.problemIndex.find(problemId);
+        if (it == shard.problemIndex.end()) {
+            continue;
+        }
+        for (Solution::Id id : it->second) {
+            result.push_back(shard.solutions.at(id).solution);
         }
     }
-    
     return result;
 }
 
 void SolutionCache::Clear() {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
-    impl_->solutions_.clear();
-    impl_->hashIndex_.clear();
-    impl_->problemIndex_.clear();
+    for (Impl::Shard& shard : impl_->shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.solutions.clear();
+        shard.hashIndex.clear();
+        shard.problemIndex.clear();
+        shard.lru.clear();
+        shard.bytes = 0;
+    }
 }
 
 size_t SolutionCache::Size() const {
-    std::lock_guard<std::mutex> lock(impl_->mutex_);
-    return impl_->solutions_.size();
+    size_t size = 0;
+    for (const Impl::Shard& shard : impl_->shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.solutions.size();
+    }
+    return size;
+}
+
+size_t SolutionCache::MemoryUsage() const {
+    size_t bytes = 0;
+    for (const Impl::Shard& shard : impl_->shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        bytes += shard.bytes;
+    }
+    return bytes;
 }
 
 } // namespace marketplace
@@ -3,15 +3,23 @@
 // MIT License
 
 #include <shurium/marketplace/verifier.h>
+#include <shurium/core/random.h>
+#include <shurium/core/serialize.h>
 #include <shurium/crypto/sha256.h>
+#include <shurium/util/threadpool.h>
 #include <shurium/util/time.h>
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cctype>
 #include <cmath>
 #include <cstring>
 #include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <iterator>
 #include <map>
 #include <mutex>
 #include <queue>
@@ -65,10 +73,40 @@ std::string VerificationDetails::ToString() const {
     return oss.str();
 }
 
+// ============================================================================
+// Verifier Interface
+// ============================================================================
+
+std::vector<VerificationDetails> IVerifier::VerifyMany(
+    const std::vector<VerificationItem>& items) {
+    std::vector<VerificationDetails> results;
+    results.reserve(items.size());
+    for (const auto& item : items) {
+        results.push_back(Verify(*item.problem, *item.solution));
+    }
+    return results;
+}
+
 // ============================================================================
 // HashPowVerifier Implementation
 // ============================================================================
 
+namespace {
+
+/// Whether a HASH_POW problem's results are candidate headers
+/// ({"work": "header"} in its parameters); by default the work is the
+/// result hash
+bool IsHeaderWork(const std::string& parameters) {
+    size_t key = parameters.find("\"work\"");
+    if (key == std::string::npos) return false;
+    size_t open = parameters.find('"', parameters.find(':', key));
+    size_t close = open == std::string::npos ? open : parameters.find('"', open + 1);
+    if (close == std::string::npos) return false;
+    return parameters.compare(open + 1, close - open - 1, "header") == 0;
+}
+
+} // anonymous namespace
+
 class HashPowVerifier::Impl {
 public:
     // No state needed for hash verification
@@ -81,71 +119,122 @@ HashPowVerifier::~HashPowVerifier() = default;
 VerificationDetails HashPowVerifier::Verify(
     const Problem& problem,
     const Solution& solution) {
+    return VerifyMany({VerificationItem{&problem, &solution}}).front();
+}
+
+std::vector<VerificationDetails> HashPowVerifier::VerifyMany(
+    const std::vector<VerificationItem>& items) {
     
-    VerificationDetails details;
     auto startTime = std::chrono::steady_clock::now();
-    
-    // Quick validation first
-    if (!QuickValidate(problem, solution)) {
-        details.result = VerificationResult::MALFORMED;
-        details.errorMessage = "Quick validation failed";
-        return details;
-    }
-    
-    // Get target from problem
-    const auto& inputData = problem.GetSpec().GetInputData();
-    if (inputData.size() < 32) {
-        details.result = VerificationResult::MALFORMED;
-        details.errorMessage = "Problem input data too small";
-        return details;
+    std::vector<VerificationDetails> results(items.size());
+    std::vector<bool> wellFormed(items.size(), false);
+    std::vector<bool> headerWork(items.size(), false);
+    
+    // Candidate headers, packed for the multi-way kernel
+    std::vector<Byte> headers;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Problem& problem = *items[i].problem;
+        const Solution& solution = *items[i].solution;
+        VerificationDetails& details = results[i];
+        
+        // Quick validation first
+        if (!QuickValidate(problem, solution)) {
+            details.result = VerificationResult::MALFORMED;
+            details.errorMessage = "Quick validation failed";
+            continue;
+        }
+        
+        // The target comes from the problem
+        if (problem.GetSpec().GetInputData().size() < 32) {
+            details.result = VerificationResult::MALFORMED;
+            details.errorMessage = "Problem input data too small";
+            continue;
+        }
+        
+        const auto& result = solution.GetData().GetResult();
+        if (IsHeaderWork(problem.GetSpec().GetParameters())) {
+            if (result.size() != HEADER_SIZE) {
+                details.result = VerificationResult::MALFORMED;
+                details.errorMessage = "Result is not a candidate header";
+                continue;
+            }
+            headers.insert(headers.end(), result.begin(), result.end());
+            headerWork[i] = true;
+        }
+        wellFormed[i] = true;
     }
     
-    Hash256 target;
-    std::copy(inputData.begin(), inputData.begin() + 32, target.begin());
-    
-    // Get solution result hash
-    const Hash256& resultHash = solution.GetData().GetResultHash();
-    
-    // Check if result hash is below target
-    details.AddCheck("hash_below_target", resultHash < target);
-    
-    // Verify the nonce produces the claimed hash
-    const auto& result = solution.GetData().GetResult();
-    Hash256 computedHash;
-    SHA256 hasher;
-    hasher.Write(result.data(), result.size());
-    hasher.Finalize(computedHash.data());
-    
-    details.AddCheck("hash_valid", computedHash == resultHash);
-    
-    // Calculate score (inverse of hash value - lower hash = higher score)
-    uint64_t hashValue = 0;
-    std::memcpy(&hashValue, resultHash.data(), sizeof(hashValue));
-    uint64_t targetValue = 0;
-    std::memcpy(&targetValue, target.data(), sizeof(targetValue));
-    
-    if (targetValue > 0) {
-        details.score = static_cast<uint32_t>(
-            (static_cast<double>(targetValue - hashValue) / targetValue) * 1000000);
-    }
+    std::vector<Byte> headerHashes(headers.size() / HEADER_SIZE * 32);
+    DoubleSHA256_80(headerHashes.data(), headers.data(), headers.size() / HEADER_SIZE);
     
-    // Check all checks passed
-    bool allPassed = true;
-    for (const auto& check : details.checks) {
-        if (!check.second) {
-            allPassed = false;
-            break;
+    size_t nextHeader = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (!wellFormed[i]) {
+            continue;
         }
+        const Solution& solution = *items[i].solution;
+        VerificationDetails& details = results[i];
+        
+        const auto& inputData = items[i].problem->GetSpec().GetInputData();
+        Hash256 target;
+        std::copy(inputData.begin(), inputData.begin() + 32, target.begin());
+        
+        // The work is the header's hash for a candidate header, else the
+        // result hash
+        const auto& result = solution.GetData().GetResult();
+        const Hash256& resultHash = solution.GetData().GetResultHash();
+        Hash256 workHash = resultHash;
+        if (headerWork[i]) {
+            const Byte* hash = headerHashes.data() + 32 * nextHeader++;
+            std::copy(hash, hash + 32, workHash.begin());
+        }
+        
+        // Check if the work hash is below target
+        details.AddCheck("hash_below_target", workHash < target);
+        
+        // Verify the result produces the claimed hash. A header's work is
+        // hashed from the result itself, so only the result hash needs it.
+        if (!headerWork[i]) {
+            Hash256 computedHash;
+            SHA256 hasher;
+            hasher.Write(result.data(), result.size());
+            hasher.Finalize(computedHash.data());
+            
+            details.AddCheck("hash_valid", computedHash == resultHash);
+        }
+        
+        // Calculate score (inverse of hash value - lower hash = higher score)
+        uint64_t hashValue = 0;
+        std::memcpy(&hashValue, workHash.data(), sizeof(hashValue));
+        uint64_t targetValue = 0;
+        std::memcpy(&targetValue, target.data(), sizeof(targetValue));
+        
+        if (targetValue > 0) {
+            details.score = static_cast<uint32_t>(
+                (static_cast<double>(targetValue - hashValue) / targetValue) * 1000000);
+        }
+        
+        // Check all checks passed
+        bool allPassed = true;
+        for (const auto& check : details.checks) {
+            if (!check.second) {
+                allPassed = false;
+                break;
+            }
+        }
+        
+        details.result = allPassed ? VerificationResult::VALID : VerificationResult::INVALID;
+        details.meetsRequirements = allPassed;
     }
     
-    details.result = allPassed ? VerificationResult::VALID : VerificationResult::INVALID;
-    details.meetsRequirements = allPassed;
-    
     auto endTime = std::chrono::steady_clock::now();
-    details.verificationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    uint64_t elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         endTime - startTime).count();
+    for (auto& details : results) {
+        details.verificationTimeMs = elapsedMs;
+    }
     
-    return details;
+    return results;
 }
 
 bool HashPowVerifier::QuickValidate(
@@ -180,6 +269,103 @@ uint64_t HashPowVerifier::EstimateVerificationTime(
 // MLTrainingVerifier Implementation
 // ============================================================================
 
+namespace {
+
+/// Next value of a splitmix64 stream
+uint64_t SplitMix64(uint64_t& state) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Labelled evaluation set for ML_TRAINING problems, carried as the
+ * problem's verification data: samples, features and classes (u32 each),
+ * then samples x features float32 values row-major, then one u32 label per
+ * sample. The data must be exactly that size to be read as one.
+ */
+struct EvaluationSet {
+    size_t samples{0};
+    size_t features{0};
+    size_t classes{0};
+    std::vector<float> values;
+    std::vector<uint32_t> labels;
+};
+
+bool ReadEvaluationSet(const std::vector<uint8_t>& data, EvaluationSet& set) {
+    if (data.size() < 12) return false;
+    uint32_t header[3];
+    std::memcpy(header, data.data(), sizeof(header));
+    uint64_t samples = header[0], features = header[1], classes = header[2];
+    if (samples == 0 || features == 0 || classes < 2) return false;
+    uint64_t expected = 12 + samples * features * 4 + samples * 4;
+    if (data.size() != expected) return false;
+    
+    set.samples = samples;
+    set.features = features;
+    set.classes = classes;
+    set.values.resize(samples * features);
+    std::memcpy(set.values.data(), data.data() + 12, set.values.size() * 4);
+    set.labels.resize(samples);
+    std::memcpy(set.labels.data(), data.data() + 12 + set.values.size() * 4,
+                set.labels.size() * 4);
+    return true;
+}
+
+/**
+ * Dot product in eight independent lanes summed in a fixed order. The lane
+ * loop vectorizes (SSE/AVX/NEON, whatever the build targets) without
+ * reassociating anything, so every node computes the same bits.
+ */
+float Dot(const float* a, const float* b, size_t n) {
+    constexpr size_t LANES = 8;
+    float lanes[LANES] = {};
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            lanes[lane] += a[i + lane] * b[i + lane];
+        }
+    }
+    float tail = 0.0f;
+    for (; i < n; ++i) {
+        tail += a[i] * b[i];
+    }
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+           ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + tail;
+}
+
+/**
+ * Correct predictions of a linear classifier over the given samples.
+ * weights holds one row of features weights per class, then one bias per
+ * class; the prediction is the first class with the highest score.
+ */
+size_t CountCorrect(const EvaluationSet& set, const float* weights,
+                    const uint32_t* indices, size_t count) {
+    const float* bias = weights + set.classes * set.features;
+    size_t correct = 0;
+    for (size_t n = 0; n < count; ++n) {
+        size_t sample = indices[n];
+        const float* x = set.values.data() + sample * set.features;
+        size_t best = 0;
+        float bestScore = 0.0f;
+        for (size_t c = 0; c < set.classes; ++c) {
+            float score = Dot(weights + c * set.features, x, set.features) + bias[c];
+            if (c == 0 || score > bestScore) {
+                best = c;
+                bestScore = score;
+            }
+        }
+        if (best == set.labels[sample]) {
+            ++correct;
+        }
+    }
+    return correct;
+}
+
+} // anonymous namespace
+
 class MLTrainingVerifier::Impl {
 public:
     // Verify model weight format - weights should be valid floating point values
@@ -245,6 +431,75 @@ public:
         return matchingBytes >= 1;  // At least 1 byte should match
     }
     
+    /// Samples per evaluation task on the pool
+    static constexpr size_t EVALUATION_CHUNK = 512;
+    
+    /// Chance that an honest model fails a sampled evaluation
+    static constexpr double SAMPLING_FAILURE = 1e-6;
+    
+    /**
+     * Accuracy (0-1000000) of the submitted weights as a linear classifier
+     * on the evaluation set, or nullopt if their size doesn't fit it.
+     *
+     * With sampleSize below the set size a random subset is evaluated and
+     * margin receives the Hoeffding allowance (same scale) for it, so an
+     * honest model's sampled accuracy plus the margin reaches its true
+     * accuracy except with probability SAMPLING_FAILURE.
+     */
+    std::optional<uint32_t> EvaluateAccuracy(const std::vector<uint8_t>& result,
+                                             const EvaluationSet& set,
+                                             size_t sampleSize, size_t threads,
+                                             uint32_t& margin) {
+        margin = 0;
+        if (result.size() != set.classes * (set.features + 1) * 4) {
+            return std::nullopt;
+        }
+        std::vector<float> weights(result.size() / 4);
+        std::memcpy(weights.data(), result.data(), result.size());
+        
+        std::vector<uint32_t> indices(set.samples);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+        size_t count = indices.size();
+        if (sampleSize != 0 && sampleSize < count) {
+            // Partial Fisher-Yates: the first sampleSize entries are a
+            // uniform sample without replacement
+            uint64_t state = GetRandUint64();
+            for (size_t i = 0; i < sampleSize; ++i) {
+                size_t j = i + SplitMix64(state) % (count - i);
+                std::swap(indices[i], indices[j]);
+            }
+            count = sampleSize;
+            margin = static_cast<uint32_t>(1000000.0 *
+                std::sqrt(std::log(1.0 / SAMPLING_FAILURE) / (2.0 * count)));
+        }
+        
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        size_t chunks = std::min(threads, (count + EVALUATION_CHUNK - 1) / EVALUATION_CHUNK);
+        size_t correct = 0;
+        if (chunks <= 1) {
+            correct = CountCorrect(set, weights.data(), indices.data(), count);
+        } else {
+            std::shared_ptr<util::ThreadPool> pool = Pool(threads);
+            size_t perChunk = (count + chunks - 1) / chunks;
+            std::vector<std::future<size_t>> parts;
+            for (size_t begin = 0; begin < count; begin += perChunk) {
+                size_t n = std::min(perChunk, count - begin);
+                parts.push_back(pool->Submit([&set, &weights, &indices, begin, n] {
+                    return CountCorrect(set, weights.data(), indices.data() + begin, n);
+                }));
+            }
+            for (auto& part : parts) {
+                correct += part.get();
+            }
+        }
+        
+        return static_cast<uint32_t>(correct * 1000000 / count);
+    }
+    
     // Compute validation accuracy by running inference on verification data
     // Returns accuracy scaled to 0-1000000
     uint32_t ComputeValidationAccuracy(const std::vector<uint8_t>& weights,
@@ -290,6 +545,25 @@ public:
             return std::min(expectedAccuracy, 950000u);  // Cap at 95%
         }
     }
+
+private:
+    /// Evaluation pool, created on first use and resized when the thread
+    /// setting changes
+    std::shared_ptr<util::ThreadPool> Pool(size_t threads) {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        if (!pool_ || poolThreads_ != threads) {
+            util::ThreadPool::Config config;
+            config.numThreads = threads;
+            config.name = "mleval";
+            pool_ = std::make_shared<util::ThreadPool>(config);
+            poolThreads_ = threads;
+        }
+        return pool_;
+    }
+    
+    std::mutex poolMutex_;
+    std::shared_ptr<util::ThreadPool> pool_;
+    size_t poolThreads_{0};
 };
 
 MLTrainingVerifier::MLTrainingVerifier() : impl_(std::make_unique<Impl>()) {}
@@ -341,10 +615,22 @@ VerificationDetails MLTrainingVerifier::Verify(
     bool intermediatesValid = impl_->VerifyIntermediateChain(intermediates, solutionData.GetResultHash());
     details.AddCheck("intermediate_chain_valid", intermediatesValid);
     
-    // Check 7: Compute and verify accuracy
+    // Check 7: Compute and verify accuracy. With a labelled evaluation set
+    // the weights are run over it; otherwise only plausibility is checked.
     uint32_t reportedAccuracy = solutionData.GetAccuracy();
-    uint32_t verifiedAccuracy = impl_->ComputeValidationAccuracy(result, verificationData, reportedAccuracy);
-    bool accuracyMeetsThreshold = verifiedAccuracy >= minAccuracy_;
+    uint32_t verifiedAccuracy = 0;
+    uint32_t margin = 0;
+    EvaluationSet evaluationSet;
+    if (ReadEvaluationSet(verificationData, evaluationSet)) {
+        auto measured = impl_->EvaluateAccuracy(result, evaluationSet, evaluationSamples_,
+                                                evaluationThreads_, margin);
+        details.AddCheck("weights_fit_evaluation_set", measured.has_value());
+        verifiedAccuracy = measured.value_or(0);
+    } else {
+        verifiedAccuracy = impl_->ComputeValidationAccuracy(result, verificationData, reportedAccuracy);
+    }
+    bool accuracyMeetsThreshold =
+        static_cast<uint64_t>(verifiedAccuracy) + margin >= minAccuracy_;
     details.AddCheck("accuracy_threshold", accuracyMeetsThreshold);
     
     // Use verified accuracy for score
@@ -406,11 +692,177 @@ uint64_t MLTrainingVerifier::EstimateVerificationTime(
 // LinearAlgebraVerifier Implementation
 // ============================================================================
 
+namespace {
+
+/// Dense row-major matrix, widened to double for checking
+struct DenseMatrix {
+    size_t rows{0};
+    size_t cols{0};
+    std::vector<double> values;
+};
+
+/// Read a rows x cols matrix of float (elementSize 4) or double values
+bool ReadMatrix(const std::vector<uint8_t>& bytes, size_t offset, size_t elementSize,
+                size_t rows, size_t cols, DenseMatrix& matrix) {
+    size_t count = rows * cols;
+    if (offset > bytes.size() || (bytes.size() - offset) / elementSize < count) {
+        return false;
+    }
+    matrix.rows = rows;
+    matrix.cols = cols;
+    matrix.values.resize(count);
+    const uint8_t* data = bytes.data() + offset;
+    for (size_t i = 0; i < count; ++i) {
+        if (elementSize == 4) {
+            float value;
+            std::memcpy(&value, data + i * 4, 4);
+            matrix.values[i] = value;
+        } else {
+            std::memcpy(&matrix.values[i], data + i * 8, 8);
+        }
+        if (!std::isfinite(matrix.values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Y = op(M) * V for a block of `width` vectors, where op is M or its
+ * transpose and, with Absolute, every entry of M is replaced by its
+ * magnitude. V and Y hold one row of `width` lanes per matrix row/column,
+ * so the inner loop runs over contiguous lanes and vectorizes.
+ */
+template<bool Transpose, bool Absolute>
+void MultiplyBlock(const DenseMatrix& m, const std::vector<double>& v, size_t width,
+                   std::vector<double>& y) {
+    size_t outRows = Transpose ? m.cols : m.rows;
+    y.assign(outRows * width, 0.0);
+    for (size_t i = 0; i < m.rows; ++i) {
+        const double* row = m.values.data() + i * m.cols;
+        if (Transpose) {
+            // Row i of M scatters into every output row
+            const double* in = v.data() + i * width;
+            for (size_t j = 0; j < m.cols; ++j) {
+                double a = Absolute ? std::abs(row[j]) : row[j];
+                double* out = y.data() + j * width;
+                for (size_t lane = 0; lane < width; ++lane) {
+                    out[lane] += a * in[lane];
+                }
+            }
+        } else {
+            double* out = y.data() + i * width;
+            for (size_t k = 0; k < m.cols; ++k) {
+                double a = Absolute ? std::abs(row[k]) : row[k];
+                const double* in = v.data() + k * width;
+                for (size_t lane = 0; lane < width; ++lane) {
+                    out[lane] += a * in[lane];
+                }
+            }
+        }
+    }
+}
+
+std::vector<double> Magnitudes(const std::vector<double>& values) {
+    std::vector<double> result(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        result[i] = std::abs(values[i]);
+    }
+    return result;
+}
+
+/**
+ * Freivalds check of left(right) = target, with right optionally
+ * transposed: multiply both sides by a block of random vectors and compare,
+ * O(n^2) per vector instead of the O(n^3) product.
+ *
+ * Each vector has entries drawn from 2^16 integers, so a wrong product
+ * survives one vector with probability at most 2^-16. Rounding is allowed
+ * for with the standard bound, scaled by the unit roundoff of the precision
+ * the solver worked in.
+ */
+bool RandomizedProductCheck(const DenseMatrix& left, const DenseMatrix& right,
+                            bool transposeRight, const DenseMatrix& target,
+                            size_t vectors, double unitRoundoff) {
+    size_t inner = left.cols;
+    size_t outCols = transposeRight ? right.rows : right.cols;
+    if ((transposeRight ? right.cols : right.rows) != inner ||
+        target.rows != left.rows || target.cols != outCols) {
+        return false;
+    }
+    
+    // Random +-[1, 2^15] entries from one OS-seeded splitmix64 stream
+    std::vector<double> r(outCols * vectors);
+    uint64_t state = GetRandUint64();
+    for (double& entry : r) {
+        uint64_t z = SplitMix64(state);
+        double magnitude = static_cast<double>((z & 0x7FFF) + 1);
+        entry = (z & 0x8000) ? -magnitude : magnitude;
+    }
+    std::vector<double> absR = Magnitudes(r);
+    
+    std::vector<double> rightR, leftRightR, targetR;
+    std::vector<double> boundRight, boundLeft, boundTarget;
+    if (transposeRight) {
+        MultiplyBlock<true, false>(right, r, vectors, rightR);
+        MultiplyBlock<true, true>(right, absR, vectors, boundRight);
+    } else {
+        MultiplyBlock<false, false>(right, r, vectors, rightR);
+        MultiplyBlock<false, true>(right, absR, vectors, boundRight);
+    }
+    MultiplyBlock<false, false>(left, rightR, vectors, leftRightR);
+    MultiplyBlock<false, true>(left, boundRight, vectors, boundLeft);
+    MultiplyBlock<false, false>(target, r, vectors, targetR);
+    MultiplyBlock<false, true>(target, absR, vectors, boundTarget);
+    
+    double gamma = 4.0 * static_cast<double>(inner + 2) * unitRoundoff;
+    for (size_t i = 0; i < targetR.size(); ++i) {
+        double tolerance = gamma * (boundLeft[i] + boundTarget[i]);
+        if (!(std::abs(leftRightR[i] - targetR[i]) <= tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
 class LinearAlgebraVerifier::Impl {
 public:
+    /// Operations with a randomized check
+    enum class Operation {
+        MULTIPLY,   ///< C = A * B
+        SOLVE,      ///< A * X = B for X
+        LU,         ///< A = L * U, packed (unit lower L below the diagonal)
+        CHOLESKY,   ///< A = L * L^T, L lower triangular
+        UNKNOWN
+    };
+    
+    // Read the operation from the problem parameters ({"operation": "..."},
+    // as written by ProblemFactory). Missing means multiplication.
+    Operation ParseOperation(const std::string& parameters) const {
+        size_t key = parameters.find("\"operation\"");
+        if (key == std::string::npos) return Operation::MULTIPLY;
+        size_t open = parameters.find('"', parameters.find(':', key));
+        size_t close = open == std::string::npos ? open : parameters.find('"', open + 1);
+        if (close == std::string::npos) return Operation::UNKNOWN;
+        
+        std::string name = parameters.substr(open + 1, close - open - 1);
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (name.empty() || name == "multiply" || name == "matmul" || name == "gemm") {
+            return Operation::MULTIPLY;
+        }
+        if (name == "solve") return Operation::SOLVE;
+        if (name == "lu") return Operation::LU;
+        if (name == "cholesky") return Operation::CHOLESKY;
+        return Operation::UNKNOWN;
+    }
+    
     // Parse matrix dimensions from input data
-    // Format: first 16 bytes are 4 uint32_t values (rowsA, colsA, rowsB, colsB)
-    bool ParseMatrixDimensions(const std::vector<uint8_t>& input,
+    // Format: first 16 bytes are 4 uint32_t values (rowsA, colsA, rowsB, colsB);
+    // decompositions have no B and give (n, n, 0, 0)
+    bool ParseMatrixDimensions(const std::vector<uint8_t>& input, Operation op,
                                 uint32_t& rowsA, uint32_t& colsA,
                                 uint32_t& rowsB, uint32_t& colsB) const {
         if (input.size() < 16) return false;
@@ -421,110 +873,96 @@ public:
         std::memcpy(&colsB, input.data() + 12, 4);
         
         // Sanity checks
-        if (rowsA == 0 || colsA == 0 || rowsB == 0 || colsB == 0) return false;
+        if (rowsA == 0 || colsA == 0) return false;
         if (rowsA > 100000 || colsA > 100000 || rowsB > 100000 || colsB > 100000) return false;
         
-        return true;
+        switch (op) {
+            case Operation::MULTIPLY:
+                return rowsB != 0 && colsB != 0;
+            case Operation::SOLVE:
+                return rowsA == colsA && rowsB == rowsA && colsB != 0;
+            case Operation::LU:
+            case Operation::CHOLESKY:
+                return rowsA == colsA && rowsB == 0 && colsB == 0;
+            default:
+                return false;
+        }
     }
     
-    // Verify matrix multiplication result dimensions
-    // For C = A * B: rowsC = rowsA, colsC = colsB, and colsA must equal rowsB
-    bool VerifyMatrixDimensions(uint32_t rowsA, uint32_t colsA,
+    // Verify result dimensions: C is rowsA x colsB for multiplication (and
+    // colsA must equal rowsB), X is n x colsB for a solve, the factor is
+    // n x n for a decomposition. Elements are 8 bytes (double precision)
+    // or 4 bytes (single precision).
+    bool VerifyMatrixDimensions(Operation op, uint32_t rowsA, uint32_t colsA,
                                  uint32_t rowsB, uint32_t colsB,
                                  size_t resultSize) const {
-        // For multiplication: colsA must equal rowsB
-        if (colsA != rowsB) return false;
+        if (op == Operation::MULTIPLY && colsA != rowsB) return false;
         
-        // Result matrix C has dimensions rowsA x colsB
-        // Each element is 8 bytes (double precision) or 4 bytes (single precision)
-        size_t expectedSize8 = static_cast<size_t>(rowsA) * colsB * 8;
-        size_t expectedSize4 = static_cast<size_t>(rowsA) * colsB * 4;
+        size_t resultCols = (op == Operation::LU || op == Operation::CHOLESKY) ? colsA : colsB;
+        size_t expectedSize8 = static_cast<size_t>(rowsA) * resultCols * 8;
+        size_t expectedSize4 = static_cast<size_t>(rowsA) * resultCols * 4;
         
         return resultSize == expectedSize8 || resultSize == expectedSize4;
     }
     
-    // Spot-check matrix values - verify a few random elements
-    // by recomputing them from input matrices
-    bool SpotCheckMatrixValues(const std::vector<uint8_t>& input,
-                                const std::vector<uint8_t>& result,
-                                uint32_t rowsA, uint32_t colsA,
-                                uint32_t rowsB, uint32_t colsB,
-                                const Hash256& resultHash) const {
-        // Determine element size (4 for float, 8 for double)
-        size_t expectedElements = static_cast<size_t>(rowsA) * colsB;
-        size_t elementSize = result.size() / expectedElements;
+    // Randomized check of the result against the input matrices, with
+    // enough random vectors for the soundness error
+    bool RandomizedCheck(Operation op, const std::vector<uint8_t>& input,
+                         const std::vector<uint8_t>& result,
+                         uint32_t rowsA, uint32_t colsA,
+                         uint32_t rowsB, uint32_t colsB,
+                         double soundnessError) const {
+        size_t resultCols = (op == Operation::LU || op == Operation::CHOLESKY) ? colsA : colsB;
+        size_t elementSize = result.size() / (static_cast<size_t>(rowsA) * resultCols);
         if (elementSize != 4 && elementSize != 8) return false;
+        double unitRoundoff = elementSize == 4 ? std::ldexp(1.0, -24) : std::ldexp(1.0, -53);
+        
+        double bits = soundnessError > 0 ? -std::log2(soundnessError) : 64.0;
+        size_t vectors = static_cast<size_t>(std::ceil(std::max(bits, 1.0) / 16.0));
         
-        // Use result hash to deterministically select elements to verify
-        uint32_t checkIdx1 = (resultHash[0] | (resultHash[1] << 8)) % expectedElements;
-        uint32_t checkIdx2 = (resultHash[2] | (resultHash[3] << 8)) % expectedElements;
-        uint32_t checkIdx3 = (resultHash[4] | (resultHash[5] << 8)) % expectedElements;
-        
-        // For each check index, compute the expected value
-        // C[i][j] = sum(A[i][k] * B[k][j]) for k in 0..colsA-1
-        size_t matrixAOffset = 16;  // After dimension header
-        size_t matrixASize = static_cast<size_t>(rowsA) * colsA * elementSize;
-        size_t matrixBOffset = matrixAOffset + matrixASize;
-        
-        // Check if input has enough data
-        size_t matrixBSize = static_cast<size_t>(rowsB) * colsB * elementSize;
-        if (input.size() < matrixBOffset + matrixBSize) {
-            // Input doesn't contain full matrices - can't spot check
+        DenseMatrix a, b, r;
+        size_t offsetB = 16 + static_cast<size_t>(rowsA) * colsA * elementSize;
+        if (!ReadMatrix(input, 16, elementSize, rowsA, colsA, a) ||
+            (rowsB != 0 && !ReadMatrix(input, offsetB, elementSize, rowsB, colsB, b))) {
+            // Input doesn't contain full matrices - can't check
             // Allow this for problems that use compressed/sparse formats
             return true;
         }
+        if (!ReadMatrix(result, 0, elementSize, rowsA, resultCols, r)) {
+            return false;
+        }
         
-        // Verify at least one element
-        uint32_t i = checkIdx1 / colsB;
-        uint32_t j = checkIdx1 % colsB;
-        
-        if (elementSize == 4) {
-            // Float precision
-            float expected = 0.0f;
-            for (uint32_t k = 0; k < colsA; ++k) {
-                size_t aIdx = matrixAOffset + (i * colsA + k) * 4;
-                size_t bIdx = matrixBOffset + (k * colsB + j) * 4;
-                
-                float aVal, bVal;
-                std::memcpy(&aVal, input.data() + aIdx, 4);
-                std::memcpy(&bVal, input.data() + bIdx, 4);
-                expected += aVal * bVal;
-            }
-            
-            float actual;
-            std::memcpy(&actual, result.data() + checkIdx1 * 4, 4);
-            
-            // Allow small floating point error
-            float diff = std::abs(expected - actual);
-            float tolerance = std::max(std::abs(expected) * 1e-5f, 1e-6f);
-            if (diff > tolerance) {
-                return false;
+        switch (op) {
+            case Operation::MULTIPLY:
+                return RandomizedProductCheck(a, b, false, r, vectors, unitRoundoff);
+            case Operation::SOLVE:
+                return RandomizedProductCheck(a, r, false, b, vectors, unitRoundoff);
+            case Operation::LU: {
+                // Unpack: L takes the strict lower part with a unit diagonal
+                DenseMatrix lower = r, upper = r;
+                for (size_t i = 0; i < r.rows; ++i) {
+                    for (size_t j = 0; j < r.cols; ++j) {
+                        double& l = lower.values[i * r.cols + j];
+                        double& u = upper.values[i * r.cols + j];
+                        if (j > i) l = 0.0;
+                        else if (j == i) l = 1.0;
+                        if (j < i) u = 0.0;
+                    }
+                }
+                return RandomizedProductCheck(lower, upper, false, a, vectors, unitRoundoff);
             }
-        } else {
-            // Double precision
-            double expected = 0.0;
-            for (uint32_t k = 0; k < colsA; ++k) {
-                size_t aIdx = matrixAOffset + (i * colsA + k) * 8;
-                size_t bIdx = matrixBOffset + (k * colsB + j) * 8;
-                
-                double aVal, bVal;
-                std::memcpy(&aVal, input.data() + aIdx, 8);
-                std::memcpy(&bVal, input.data() + bIdx, 8);
-                expected += aVal * bVal;
+            case Operation::CHOLESKY: {
+                DenseMatrix lower = r;
+                for (size_t i = 0; i < r.rows; ++i) {
+                    for (size_t j = i + 1; j < r.cols; ++j) {
+                        lower.values[i * r.cols + j] = 0.0;
+                    }
+                }
+                return RandomizedProductCheck(lower, lower, true, a, vectors, unitRoundoff);
             }
-            
-            double actual;
-            std::memcpy(&actual, result.data() + checkIdx1 * 8, 8);
-            
-            // Allow small floating point error
-            double diff = std::abs(expected - actual);
-            double tolerance = std::max(std::abs(expected) * 1e-10, 1e-12);
-            if (diff > tolerance) {
+            default:
                 return false;
-            }
         }
-        
-        return true;
     }
     
     // Verify result hash matches actual result
@@ -561,23 +999,26 @@ VerificationDetails LinearAlgebraVerifier::Verify(
     details.AddCheck("valid_structure", solution.IsValid());
     
     // Check 2: Parse matrix dimensions from input
-    uint32_t rowsA, colsA, rowsB, colsB;
-    bool dimensionsParsed = impl_->ParseMatrixDimensions(input, rowsA, colsA, rowsB, colsB);
+    Impl::Operation op = impl_->ParseOperation(problem.GetSpec().GetParameters());
+    uint32_t rowsA = 0, colsA = 0, rowsB = 0, colsB = 0;
+    bool dimensionsParsed = op != Impl::Operation::UNKNOWN &&
+        impl_->ParseMatrixDimensions(input, op, rowsA, colsA, rowsB, colsB);
     details.AddCheck("dimensions_parseable", dimensionsParsed);
     
     if (dimensionsParsed) {
-        // Check 3: Result has correct dimensions for matrix multiplication
-        bool dimensionsValid = impl_->VerifyMatrixDimensions(rowsA, colsA, rowsB, colsB, result.size());
+        // Check 3: Result has correct dimensions for the operation
+        bool dimensionsValid = impl_->VerifyMatrixDimensions(
+            op, rowsA, colsA, rowsB, colsB, result.size());
         details.AddCheck("result_dimensions_valid", dimensionsValid);
         
         // Check 4: Verify result hash
         bool hashValid = impl_->VerifyResultHash(result, solutionData.GetResultHash());
         details.AddCheck("result_hash_valid", hashValid);
         
-        // Check 5: Spot-check matrix computation (verify random elements)
-        bool spotCheckPassed = impl_->SpotCheckMatrixValues(
-            input, result, rowsA, colsA, rowsB, colsB, solutionData.GetResultHash());
-        details.AddCheck("spot_check_passed", spotCheckPassed);
+        // Check 5: Randomized (Freivalds) check of the whole result
+        bool spotCheckPassed = dimensionsValid && impl_->RandomizedCheck(
+            op, input, result, rowsA, colsA, rowsB, colsB, soundnessError_);
+        details.AddCheck("randomized_check_passed", spotCheckPassed);
         
         // Check 6: Intermediate values provided (for verifiable computation)
         const auto& intermediates = solutionData.GetIntermediates();
@@ -712,7 +1153,7 @@ VerificationDetails GenericVerifier::Verify(
     std::memcpy(&hashValue, resultHash.data(), sizeof(hashValue));
     details.score = static_cast<uint32_t>(
         std::min(static_cast<uint64_t>(1000000), 
-                 1000000ULL - (hashValue % 1000000)));
+                 static_cast<uint64_t>(1000000ULL - (hashValue % 1000000))));
     
     // Check all checks passed
     bool allPassed = true;
@@ -823,57 +1264,322 @@ std::vector<ProblemType> VerifierRegistry::GetRegisteredTypes() const {
     return types;
 }
 
+// ============================================================================
+// VerificationCostModel Implementation
+// ============================================================================
+
+namespace {
+
+/// File magic
+constexpr uint8_t COST_MODEL_MAGIC[4] = {'s', 'v', 'c', 'm'};
+
+void WriteDouble(DataStream& ss, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    ser_writedata64(ss, bits);
+}
+
+double ReadDouble(SpanReader& ss) {
+    uint64_t bits = ser_readdata64(ss);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // anonymous namespace
+
+uint16_t VerificationCostModel::Key(ProblemType type, size_t inputSize) {
+    uint16_t bucket = 0;
+    while (inputSize != 0) {
+        ++bucket;
+        inputSize >>= 1;
+    }
+    return static_cast<uint16_t>((static_cast<uint32_t>(type) & 0xFF) << 8 | bucket);
+}
+
+void VerificationCostModel::Record(ProblemType type, size_t inputSize, uint64_t micros) {
+    double x = static_cast<double>(inputSize);
+    double y = static_cast<double>(micros);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    Fit& fit = fits_[Key(type, inputSize)];
+    fit.weight = fit.weight * DECAY + 1.0;
+    fit.sumX = fit.sumX * DECAY + x;
+    fit.sumY = fit.sumY * DECAY + y;
+    fit.sumXX = fit.sumXX * DECAY + x * x;
+    fit.sumXY = fit.sumXY * DECAY + x * y;
+}
+
+std::optional<uint64_t> VerificationCostModel::Estimate(ProblemType type,
+                                                        size_t inputSize) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = fits_.find(Key(type, inputSize));
+    if (it == fits_.end() || it->second.weight < MIN_WEIGHT) {
+        return std::nullopt;
+    }
+    
+    const Fit& fit = it->second;
+    double meanX = fit.sumX / fit.weight;
+    double meanY = fit.sumY / fit.weight;
+    double varX = fit.sumXX / fit.weight - meanX * meanX;
+    double micros = meanY;
+    // Fall back to the mean when every sample had (nearly) the same size
+    if (varX > 1e-6 * meanX * meanX && varX > 0) {
+        double slope = (fit.sumXY / fit.weight - meanX * meanY) / varX;
+        micros = meanY + slope * (static_cast<double>(inputSize) - meanX);
+    }
+    if (!(micros > 0)) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::llround(micros / 1000.0));
+}
+
+size_t VerificationCostModel::Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fits_.size();
+}
+
+void VerificationCostModel::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fits_.clear();
+}
+
+std::vector<Byte> VerificationCostModel::Serialize() const {
+    DataStream ss;
+    ss.Write(COST_MODEL_MAGIC, sizeof(COST_MODEL_MAGIC));
+    ser_writedata16(ss, VERIFICATION_COST_MODEL_VERSION);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteCompactSize(ss, fits_.size());
+    for (const auto& [key, fit] : fits_) {
+        ser_writedata8(ss, static_cast<uint8_t>(key >> 8));
+        ser_writedata8(ss, static_cast<uint8_t>(key & 0xFF));
+        WriteDouble(ss, fit.weight);
+        WriteDouble(ss, fit.sumX);
+        WriteDouble(ss, fit.sumY);
+        WriteDouble(ss, fit.sumXX);
+        WriteDouble(ss, fit.sumXY);
+    }
+    return ss.Data();
+}
+
+bool VerificationCostModel::Deserialize(const Byte* data, size_t len) {
+    if (len < sizeof(COST_MODEL_MAGIC) ||
+        std::memcmp(data, COST_MODEL_MAGIC, sizeof(COST_MODEL_MAGIC)) != 0) {
+        return false;
+    }
+    
+    SpanReader ss(data + sizeof(COST_MODEL_MAGIC), len - sizeof(COST_MODEL_MAGIC));
+    std::map<uint16_t, Fit> fits;
+    try {
+        if (ser_readdata16(ss) != VERIFICATION_COST_MODEL_VERSION) {
+            return false;
+        }
+        uint64_t count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint16_t key = static_cast<uint16_t>(ser_readdata8(ss)) << 8;
+            key |= ser_readdata8(ss);
+            Fit fit;
+            fit.weight = ReadDouble(ss);
+            fit.sumX = ReadDouble(ss);
+            fit.sumY = ReadDouble(ss);
+            fit.sumXX = ReadDouble(ss);
+            fit.sumXY = ReadDouble(ss);
+            if (!std::isfinite(fit.weight) || !(fit.weight > 0) ||
+                !std::isfinite(fit.sumX) || !std::isfinite(fit.sumY) ||
+                !std::isfinite(fit.sumXX) || !std::isfinite(fit.sumXY)) {
+                return false;
+            }
+            fits[key] = fit;
+        }
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    fits_ = std::move(fits);
+    return true;
+}
+
+bool VerificationCostModel::Save(const std::string& path) const {
+    std::vector<Byte> bytes = Serialize();
+    std::string tmpPath = path + ".new";
+    std::error_code ec;
+    bool ok = false;
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(bytes.data()),
+                   static_cast<std::streamsize>(bytes.size()));
+        file.flush();
+        ok = file.good();
+    }
+    if (!ok) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool VerificationCostModel::Load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<Byte> bytes((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    return Deserialize(bytes.data(), bytes.size());
+}
+
 // ============================================================================
 // SolutionVerifier Implementation
 // ============================================================================
 
 class SolutionVerifier::Impl {
 public:
+    /// A queued verification
+    struct Job {
+        Problem problem;
+        Solution solution;
+        VerificationCallback callback;
+        std::promise<VerificationDetails> promise;
+        
+        void Complete(const VerificationDetails& details) {
+            promise.set_value(details);
+            if (callback) {
+                callback(solution.GetId(), details);
+            }
+        }
+    };
+    
+    /// Queue order: higher reward first, then cheaper verification, then
+    /// first come first served
+    struct QueueKey {
+        Amount reward;
+        uint64_t estimatedMs;
+        uint64_t sequence;
+        
+        bool operator<(const QueueKey& other) const {
+            if (reward != other.reward) return reward > other.reward;
+            if (estimatedMs != other.estimatedMs) return estimatedMs < other.estimatedMs;
+            return sequence < other.sequence;
+        }
+    };
+    
+    static VerificationDetails Failure(VerificationResult result, const std::string& message) {
+        VerificationDetails details;
+        details.result = result;
+        details.errorMessage = message;
+        return details;
+    }
+    
     std::atomic<uint64_t> totalVerifications_{0};
     std::atomic<uint64_t> successfulCount_{0};
     std::atomic<uint64_t> failedCount_{0};
     std::atomic<uint64_t> totalVerificationTime_{0};
     
     mutable std::mutex mutex_;
-    std::queue<std::tuple<Problem, Solution, SolutionVerifier::VerificationCallback>> pendingQueue_;
-    std::map<Solution::Id, VerificationDetails> results_;
+    std::map<QueueKey, Job> queue_;
+    uint64_t nextSequence_{0};
+    std::map<ProblemType, size_t> typeLimits_;
+    std::map<ProblemType, size_t> running_;
+    size_t runningTotal_{0};
+    bool shutdown_{false};
+    std::unique_ptr<util::ThreadPool> pool_;
+    
+    VerificationCostModel costModel_;
 };
 
 SolutionVerifier::SolutionVerifier() : impl_(std::make_unique<Impl>()) {}
 
-SolutionVerifier::~SolutionVerifier() = default;
+SolutionVerifier::~SolutionVerifier() {
+    Shutdown();
+}
 
 VerificationDetails SolutionVerifier::Verify(
     const Problem& problem,
     const Solution& solution) {
+    return VerifyMany({VerificationItem{&problem, &solution}}).front();
+}
+
+std::vector<VerificationDetails> SolutionVerifier::VerifyMany(
+    const std::vector<VerificationItem>& items) {
     
-    VerificationDetails details;
-    
-    // Get appropriate verifier
-    IVerifier* verifier = VerifierRegistry::Instance().GetVerifier(problem.GetType());
-    if (!verifier) {
-        details.result = VerificationResult::TYPE_MISMATCH;
-        details.errorMessage = "No verifier for problem type: " + 
-            std::string(ProblemTypeToString(problem.GetType()));
-        return details;
+    std::vector<VerificationDetails> results(items.size());
+    std::map<ProblemType, std::vector<size_t>> groups;
+    for (size_t i = 0; i < items.size(); ++i) {
+        groups[items[i].problem->GetType()].push_back(i);
     }
     
-    // Verify
-    auto startTime = std::chrono::steady_clock::now();
-    details = verifier->Verify(problem, solution);
-    auto endTime = std::chrono::steady_clock::now();
-    
-    // Update statistics
-    impl_->totalVerifications_++;
-    impl_->totalVerificationTime_ += details.verificationTimeMs;
-    
-    if (details.result == VerificationResult::VALID) {
-        impl_->successfulCount_++;
-    } else {
-        impl_->failedCount_++;
+    for (const auto& [type, indices] : groups) {
+        // Get appropriate verifier
+        IVerifier* verifier = VerifierRegistry::Instance().GetVerifier(type);
+        if (!verifier) {
+            for (size_t index : indices) {
+                results[index] = Impl::Failure(VerificationResult::TYPE_MISMATCH,
+                    "No verifier for problem type: " + std::string(ProblemTypeToString(type)));
+            }
+            continue;
+        }
+        
+        std::vector<VerificationItem> group;
+        group.reserve(indices.size());
+        for (size_t index : indices) {
+            group.push_back(items[index]);
+        }
+        
+        // Verify
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<VerificationDetails> verified = verifier->VerifyMany(group);
+        auto endTime = std::chrono::steady_clock::now();
+        
+        Record(group, verified,
+            std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            results[indices[i]] = std::move(verified[i]);
+        }
     }
     
-    return details;
+    return results;
+}
+
+void SolutionVerifier::Record(
+    const std::vector<VerificationItem>& items,
+    const std::vector<VerificationDetails>& results,
+    uint64_t elapsedMicros) {
+    
+    // A batch's time is shared evenly by its solutions
+    uint64_t micros = elapsedMicros / std::max<size_t>(items.size(), 1);
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Problem& problem = *items[i].problem;
+        const VerificationDetails& details = results[i];
+        
+        // Early rejections (malformed, mismatched) say nothing about the
+        // cost of a full verification
+        if (details.result == VerificationResult::VALID ||
+            details.result == VerificationResult::INVALID) {
+            impl_->costModel_.Record(problem.GetType(),
+                                     problem.GetSpec().GetInputData().size(), micros);
+        }
+        
+        // Update statistics
+        impl_->totalVerifications_++;
+        impl_->totalVerificationTime_ += details.verificationTimeMs;
+        
+        if (details.result == VerificationResult::VALID) {
+            impl_->successfulCount_++;
+        } else {
+            impl_->failedCount_++;
+        }
+    }
 }
 
 bool SolutionVerifier::QuickValidate(
@@ -888,30 +1594,224 @@ bool SolutionVerifier::QuickValidate(
     return verifier->QuickValidate(problem, solution);
 }
 
+std::future<VerificationDetails> SolutionVerifier::SubmitAsync(
+    const Problem& problem,
+    Solution solution,
+    VerificationCallback callback) {
+    
+    bool queued;
+    return Enqueue(problem, std::move(solution), std::move(callback), queued);
+}
+
+std::future<VerificationDetails> SolutionVerifier::Enqueue(
+    const Problem& problem,
+    Solution solution,
+    VerificationCallback callback,
+    bool& queued) {
+    
+    queued = false;
+    Impl::Job job{problem, std::move(solution), std::move(callback), {}};
+    std::future<VerificationDetails> result = job.promise.get_future();
+    
+    IVerifier* verifier = VerifierRegistry::Instance().GetVerifier(problem.GetType());
+    if (!verifier) {
+        job.Complete(Impl::Failure(VerificationResult::TYPE_MISMATCH,
+            "No verifier for problem type: " +
+            std::string(ProblemTypeToString(problem.GetType()))));
+        return result;
+    }
+    
+    // Structural checks are cheap; don't spend a queue slot on failures
+    if (!verifier->QuickValidate(job.problem, job.solution)) {
+        job.Complete(Impl::Failure(VerificationResult::MALFORMED, "Quick validation failed"));
+        return result;
+    }
+    
+    Impl::QueueKey key{problem.GetReward(), EstimateVerificationTime(problem), 0};
+    std::optional<Impl::Job> dropped;
+    std::string reason;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        
+        if (impl_->shutdown_) {
+            dropped = std::move(job);
+            reason = "Verifier shut down";
+        } else {
+            key.sequence = impl_->nextSequence_++;
+            impl_->queue_.emplace(key, std::move(job));
+            queued = true;
+            if (impl_->queue_.size() > std::max<size_t>(maxQueued_, 1)) {
+                auto last = std::prev(impl_->queue_.end());
+                queued = last->first.sequence != key.sequence;
+                dropped = std::move(last->second);
+                impl_->queue_.erase(last);
+                reason = "Verification queue full";
+            }
+        }
+    }
+    
+    if (dropped) {
+        dropped->Complete(Impl::Failure(VerificationResult::ERROR, reason));
+    }
+    
+    Dispatch();
+    return result;
+}
+
 bool SolutionVerifier::SubmitForVerification(
     const Problem& problem,
     Solution solution,
     VerificationCallback callback) {
     
+    bool queued;
+    Enqueue(problem, std::move(solution), std::move(callback), queued);
+    return queued;
+}
+
+void SolutionVerifier::Dispatch() {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
     
-    if (impl_->pendingQueue_.size() >= maxConcurrent_) {
-        return false;
+    size_t maxConcurrent = std::max<size_t>(maxConcurrent_, 1);
+    while (!impl_->shutdown_ && impl_->runningTotal_ < maxConcurrent) {
+        // Best queued job whose type is below its cap
+        auto it = std::find_if(impl_->queue_.begin(), impl_->queue_.end(),
+            [this](const auto& entry) {
+                ProblemType type = entry.second.problem.GetType();
+                auto limit = impl_->typeLimits_.find(type);
+                return limit == impl_->typeLimits_.end() ||
+                       impl_->running_[type] < limit->second;
+            });
+        if (it == impl_->queue_.end()) {
+            break;
+        }
+        
+        // The best queued solutions of its type go with it, as many as its
+        // verifier takes at once
+        ProblemType type = it->second.problem.GetType();
+        IVerifier* verifier = VerifierRegistry::Instance().GetVerifier(type);
+        size_t batchSize = verifier ? std::max<size_t>(verifier->GetBatchSize(), 1) : 1;
+        auto batch = std::make_shared<std::vector<Impl::Job>>();
+        while (it != impl_->queue_.end() && batch->size() < batchSize) {
+            if (it->second.problem.GetType() == type) {
+                batch->push_back(std::move(it->second));
+                it = impl_->queue_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        ++impl_->running_[type];
+        ++impl_->runningTotal_;
+        
+        if (!impl_->pool_) {
+            util::ThreadPool::Config config;
+            config.numThreads = maxConcurrent;
+            config.name = "verify";
+            impl_->pool_ = std::make_unique<util::ThreadPool>(config);
+        }
+        
+        impl_->pool_->Execute([this, batch, type] {
+            std::vector<VerificationItem> items;
+            items.reserve(batch->size());
+            for (const auto& job : *batch) {
+                items.push_back(VerificationItem{&job.problem, &job.solution});
+            }
+            
+            std::vector<VerificationDetails> results;
+            try {
+                results = VerifyMany(items);
+            } catch (const std::exception& e) {
+                results.assign(batch->size(),
+                               Impl::Failure(VerificationResult::ERROR, e.what()));
+            }
+            for (size_t i = 0; i < batch->size(); ++i) {
+                (*batch)[i].Complete(results[i]);
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(impl_->mutex_);
+                --impl_->running_[type];
+                --impl_->runningTotal_;
+            }
+            Dispatch();
+        });
     }
-    
-    impl_->pendingQueue_.emplace(problem, std::move(solution), std::move(callback));
-    return true;
 }
 
 size_t SolutionVerifier::GetPendingCount() const {
     std::lock_guard<std::mutex> lock(impl_->mutex_);
-    return impl_->pendingQueue_.size();
+    return impl_->queue_.size();
+}
+
+size_t SolutionVerifier::GetRunningCount() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    return impl_->runningTotal_;
 }
 
 bool SolutionVerifier::CancelVerification(Solution::Id solutionId) {
-    // For simplicity, we don't support cancellation in this implementation
-    (void)solutionId;
-    return false;
+    std::optional<Impl::Job> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        auto it = std::find_if(impl_->queue_.begin(), impl_->queue_.end(),
+            [solutionId](const auto& entry) {
+                return entry.second.solution.GetId() == solutionId;
+            });
+        if (it == impl_->queue_.end()) {
+            return false;  // Unknown, or already running
+        }
+        cancelled = std::move(it->second);
+        impl_->queue_.erase(it);
+    }
+    
+    cancelled->Complete(Impl::Failure(VerificationResult::ERROR, "Verification cancelled"));
+    return true;
+}
+
+void SolutionVerifier::Shutdown() {
+    std::map<Impl::QueueKey, Impl::Job> cancelled;
+    std::unique_ptr<util::ThreadPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        impl_->shutdown_ = true;
+        cancelled.swap(impl_->queue_);
+        pool = std::move(impl_->pool_);
+    }
+    
+    for (auto& [key, job] : cancelled) {
+        job.Complete(Impl::Failure(VerificationResult::ERROR, "Verifier shut down"));
+    }
+    
+    // Destroying the pool runs what was already started
+    pool.reset();
+}
+
+uint64_t SolutionVerifier::EstimateVerificationTime(const Problem& problem) const {
+    auto measured = impl_->costModel_.Estimate(problem.GetType(),
+                                               problem.GetSpec().GetInputData().size());
+    if (measured) {
+        return *measured;
+    }
+    IVerifier* verifier = VerifierRegistry::Instance().GetVerifier(problem.GetType());
+    return verifier ? verifier->EstimateVerificationTime(problem) : 0;
+}
+
+VerificationCostModel& SolutionVerifier::GetCostModel() {
+    return impl_->costModel_;
+}
+
+const VerificationCostModel& SolutionVerifier::GetCostModel() const {
+    return impl_->costModel_;
+}
+
+void SolutionVerifier::SetTypeConcurrency(ProblemType type, size_t max) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        if (max == 0) {
+            impl_->typeLimits_.erase(type);
+        } else {
+            impl_->typeLimits_[type] = max;
+        }
+    }
+    Dispatch();
 }
 
 uint64_t SolutionVerifier::GetTotalVerifications() const {
@@ -0,0 +1,95 @@
+// SHURIUM - Mempool Cluster Linearization Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/mempool/cluster.h"
+
+namespace shurium {
+
+std::vector<uint32_t> LinearizeCluster(const std::vector<ClusterTx>& txs) {
+    const size_t n = txs.size();
+    const size_t words = (n + 63) / 64;
+    
+    // Ancestor set of each transaction, itself included, as a bitset row
+    std::vector<uint64_t> ancestors(n * words, 0);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t* row = &ancestors[i * words];
+        row[i / 64] |= uint64_t(1) << (i % 64);
+        for (uint32_t parent : txs[i].parents) {
+            const uint64_t* parentRow = &ancestors[size_t(parent) * words];
+            for (size_t w = 0; w < words; ++w) {
+                row[w] |= parentRow[w];
+            }
+        }
+    }
+    
+    std::vector<uint64_t> remaining(words, 0);
+    for (size_t i = 0; i < n; ++i) {
+        remaining[i / 64] |= uint64_t(1) << (i % 64);
+    }
+    
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    while (order.size() < n) {
+        // Find the remaining ancestor set with the best feerate; ties go to
+        // the smaller set so that it is not held back by extra transactions
+        size_t best = n;
+        Amount bestFee = 0;
+        uint64_t bestSize = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!(remaining[i / 64] >> (i % 64) & 1)) {
+                continue;
+            }
+            Amount fee = 0;
+            uint64_t size = 0;
+            const uint64_t* row = &ancestors[i * words];
+            for (size_t w = 0; w < words; ++w) {
+                uint64_t bits = row[w] & remaining[w];
+                while (bits) {
+                    size_t j = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+                    fee += txs[j].fee;
+                    size += txs[j].size;
+                    bits &= bits - 1;
+                }
+            }
+            if (best == n || HigherFeerate(fee, size, bestFee, bestSize) ||
+                (!HigherFeerate(bestFee, bestSize, fee, size) && size < bestSize)) {
+                best = i;
+                bestFee = fee;
+                bestSize = size;
+            }
+        }
+        
+        // Take the set in position order, which is topological
+        const uint64_t* row = &ancestors[best * words];
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t bits = row[w] & remaining[w];
+            remaining[w] &= ~bits;
+            while (bits) {
+                order.push_back(static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(bits))));
+                bits &= bits - 1;
+            }
+        }
+    }
+    
+    return order;
+}
+
+std::vector<ClusterChunk> ChunkLinearization(const std::vector<ClusterTx>& txs,
+                                             const std::vector<uint32_t>& order) {
+    std::vector<ClusterChunk> chunks;
+    chunks.reserve(order.size());
+    for (uint32_t pos : order) {
+        chunks.push_back({txs[pos].fee, txs[pos].size, 1});
+        while (chunks.size() >= 2 && HigherFeerate(chunks.back(), chunks[chunks.size() - 2])) {
+            ClusterChunk merged = chunks.back();
+            chunks.pop_back();
+            chunks.back().fee += merged.fee;
+            chunks.back().size += merged.size;
+            chunks.back().count += merged.count;
+        }
+    }
+    return chunks;
+}
+
+} // namespace shurium
@@ -0,0 +1,351 @@
+// SHURIUM - Fee Estimation Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/mempool/fees.h"
+#include "shurium/core/serialize.h"
+#include "shurium/util/logging.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace shurium {
+
+namespace {
+
+/// File magic
+constexpr uint8_t FEE_ESTIMATES_MAGIC[4] = {'s', 'f', 'e', 'e'};
+
+void SerializeDoubles(DataStream& ss, const std::vector<double>& values) {
+    for (double value : values) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Serialize(ss, bits);
+    }
+}
+
+void UnserializeDoubles(DataStream& ss, std::vector<double>& values) {
+    for (double& value : values) {
+        uint64_t bits = 0;
+        Unserialize(ss, bits);
+        std::memcpy(&value, &bits, sizeof(value));
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+FeeEstimator::FeeEstimator() {
+    for (double bound = MIN_BUCKET_FEERATE; bound <= MAX_BUCKET_FEERATE;
+         bound *= FEE_BUCKET_SPACING) {
+        bucketBounds.push_back(bound);
+    }
+
+    const size_t buckets = bucketBounds.size();
+    txCount.assign(buckets, 0.0);
+    feeRateSum.assign(buckets, 0.0);
+    confirmedWithin.assign(MAX_CONFIRM_TARGET, std::vector<double>(buckets, 0.0));
+    failedAfter.assign(MAX_CONFIRM_TARGET, std::vector<double>(buckets, 0.0));
+    waitingByHeight.assign(MAX_CONFIRM_TARGET, std::vector<uint32_t>(buckets, 0));
+    waitingHeights.assign(MAX_CONFIRM_TARGET, NO_HEIGHT);
+    waitingOld.assign(buckets, 0);
+    waitingAtLeast.assign(MAX_CONFIRM_TARGET, std::vector<uint32_t>(buckets, 0));
+}
+
+size_t FeeEstimator::BucketIndex(FeeRate feeRate) const {
+    // Feerates below the first bound share the lowest bucket
+    double rate = static_cast<double>(feeRate.GetFeePerK());
+    auto it = std::upper_bound(bucketBounds.begin(), bucketBounds.end(), rate);
+    return it == bucketBounds.begin() ? 0 : static_cast<size_t>(it - bucketBounds.begin()) - 1;
+}
+
+// ============================================================================
+// Mempool Events
+// ============================================================================
+
+void FeeEstimator::MoveSlotToOld(size_t slot) {
+    for (size_t b = 0; b < waitingOld.size(); ++b) {
+        waitingOld[b] += waitingByHeight[slot][b];
+        waitingByHeight[slot][b] = 0;
+    }
+    waitingHeights[slot] = NO_HEIGHT;
+}
+
+void FeeEstimator::ProcessTransaction(const TxHash& txid, FeeRate feeRate, uint32_t height) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    TrackedTx tx{height, static_cast<uint32_t>(BucketIndex(feeRate)), feeRate.GetFeePerK()};
+    if (!tracked.emplace(txid, tx).second) {
+        return;
+    }
+
+    // A slot still holding an older height has aged out; a slot already
+    // holding a newer one means this transaction is old itself
+    size_t slot = height % MAX_CONFIRM_TARGET;
+    if (waitingHeights[slot] != NO_HEIGHT && waitingHeights[slot] > height) {
+        ++waitingOld[tx.bucket];
+        return;
+    }
+    if (waitingHeights[slot] != height) {
+        MoveSlotToOld(slot);
+        waitingHeights[slot] = height;
+    }
+    ++waitingByHeight[slot][tx.bucket];
+}
+
+void FeeEstimator::Untrack(const TrackedTx& tx) {
+    size_t slot = tx.height % MAX_CONFIRM_TARGET;
+    if (waitingHeights[slot] == tx.height) {
+        --waitingByHeight[slot][tx.bucket];
+    } else {
+        --waitingOld[tx.bucket];
+    }
+}
+
+void FeeEstimator::RemoveTransaction(const TxHash& txid) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = tracked.find(txid);
+    if (it == tracked.end()) {
+        return;
+    }
+
+    // It missed every target it waited out
+    const TrackedTx& tx = it->second;
+    uint32_t waited = bestHeight > tx.height ? bestHeight - tx.height : 0;
+    for (unsigned int t = 1; t <= std::min<uint32_t>(waited, MAX_CONFIRM_TARGET); ++t) {
+        failedAfter[t - 1][tx.bucket] += 1.0;
+    }
+    Untrack(tx);
+    tracked.erase(it);
+}
+
+void FeeEstimator::ProcessBlock(uint32_t height, const std::vector<TxHash>& confirmed) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // A block seen again, as after a reorganisation, only ends tracking
+    bool fresh = height > bestHeight;
+    if (fresh) {
+        for (auto& value : txCount) value *= FEE_ESTIMATE_DECAY;
+        for (auto& value : feeRateSum) value *= FEE_ESTIMATE_DECAY;
+        for (size_t t = 0; t < MAX_CONFIRM_TARGET; ++t) {
+            for (auto& value : confirmedWithin[t]) value *= FEE_ESTIMATE_DECAY;
+            for (auto& value : failedAfter[t]) value *= FEE_ESTIMATE_DECAY;
+        }
+    }
+
+    for (const TxHash& txid : confirmed) {
+        auto it = tracked.find(txid);
+        if (it == tracked.end()) continue;
+
+        const TrackedTx& tx = it->second;
+        if (fresh) {
+            uint32_t blocks = height > tx.height ? height - tx.height : 1;
+            for (unsigned int t = blocks; t <= MAX_CONFIRM_TARGET; ++t) {
+                confirmedWithin[t - 1][tx.bucket] += 1.0;
+            }
+            txCount[tx.bucket] += 1.0;
+            feeRateSum[tx.bucket] += static_cast<double>(tx.feePerK);
+        }
+        Untrack(tx);
+        tracked.erase(it);
+    }
+
+    if (fresh) {
+        bestHeight = height;
+        UpdateWaiting();
+    }
+}
+
+void FeeEstimator::UpdateWaiting() {
+    // Slots that reached the largest target join the old transactions
+    std::vector<std::vector<uint32_t>> byAge(MAX_CONFIRM_TARGET,
+                                             std::vector<uint32_t>(waitingOld.size(), 0));
+    for (size_t slot = 0; slot < MAX_CONFIRM_TARGET; ++slot) {
+        if (waitingHeights[slot] == NO_HEIGHT) continue;
+        uint32_t age = bestHeight > waitingHeights[slot] ? bestHeight - waitingHeights[slot] : 0;
+        if (age >= MAX_CONFIRM_TARGET) {
+            MoveSlotToOld(slot);
+        } else {
+            for (size_t b = 0; b < waitingOld.size(); ++b) {
+                byAge[age][b] += waitingByHeight[slot][b];
+            }
+        }
+    }
+
+    // Waiting at least t blocks: age t and above
+    for (size_t b = 0; b < waitingOld.size(); ++b) {
+        uint32_t sum = waitingOld[b];
+        for (size_t t = MAX_CONFIRM_TARGET; t >= 1; --t) {
+            if (t < MAX_CONFIRM_TARGET) {
+                sum += byAge[t][b];
+            }
+            waitingAtLeast[t - 1][b] = sum;
+        }
+    }
+}
+
+// ============================================================================
+// Estimates
+// ============================================================================
+
+FeeEstimate FeeEstimator::EstimateLocked(unsigned int target) const {
+    const std::vector<double>& confirmed = confirmedWithin[target - 1];
+    const std::vector<double>& failed = failedAfter[target - 1];
+    const std::vector<uint32_t>& waiting = waitingAtLeast[target - 1];
+
+    // At a steady rate of r per block a decayed count settles at r / (1 - decay)
+    const double sufficient = FEE_ESTIMATE_SUFFICIENT_TXS / (1.0 - FEE_ESTIMATE_DECAY);
+
+    double rangeConfirmed = 0, rangeTotal = 0, rangeMissed = 0, rangeFees = 0;
+    double passFees = 0, passTotal = 0;
+    for (size_t b = bucketBounds.size(); b-- > 0;) {
+        rangeConfirmed += confirmed[b];
+        rangeTotal += txCount[b];
+        rangeMissed += failed[b] + waiting[b];
+        rangeFees += feeRateSum[b];
+        if (rangeTotal < sufficient) {
+            continue;
+        }
+
+        if (rangeConfirmed / (rangeTotal + rangeMissed) < FEE_ESTIMATE_SUCCESS) {
+            break;
+        }
+        passFees = rangeFees;
+        passTotal = rangeTotal;
+        rangeConfirmed = rangeTotal = rangeMissed = rangeFees = 0;
+    }
+
+    FeeEstimate estimate;
+    if (passTotal > 0) {
+        estimate.feeRate = FeeRate(static_cast<Amount>(passFees / passTotal));
+        estimate.target = target;
+    }
+    return estimate;
+}
+
+FeeEstimate FeeEstimator::EstimateFee(unsigned int target) const {
+    if (target < 1 || target > MAX_CONFIRM_TARGET) {
+        return FeeEstimate();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    return EstimateLocked(target);
+}
+
+FeeEstimate FeeEstimator::EstimateSmartFee(unsigned int target) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (unsigned int t = std::clamp(target, 1u, MAX_CONFIRM_TARGET); t <= MAX_CONFIRM_TARGET; ++t) {
+        FeeEstimate estimate = EstimateLocked(t);
+        if (estimate.IsValid()) {
+            return estimate;
+        }
+    }
+    return FeeEstimate();
+}
+
+uint32_t FeeEstimator::GetBestHeight() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bestHeight;
+}
+
+size_t FeeEstimator::GetTrackedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tracked.size();
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+bool FeeEstimator::Save(const std::filesystem::path& path) const {
+    DataStream ss;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ss.Write(FEE_ESTIMATES_MAGIC, sizeof(FEE_ESTIMATES_MAGIC));
+        Serialize(ss, FEE_ESTIMATES_VERSION);
+        Serialize(ss, bestHeight);
+        Serialize(ss, static_cast<uint32_t>(bucketBounds.size()));
+        Serialize(ss, static_cast<uint32_t>(MAX_CONFIRM_TARGET));
+        SerializeDoubles(ss, txCount);
+        SerializeDoubles(ss, feeRateSum);
+        for (size_t t = 0; t < MAX_CONFIRM_TARGET; ++t) {
+            SerializeDoubles(ss, confirmedWithin[t]);
+            SerializeDoubles(ss, failedAfter[t]);
+        }
+    }
+
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".new";
+    std::error_code ec;
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(ss.data()), static_cast<std::streamsize>(ss.size()));
+        if (!file.good()) {
+            LOG_WARN(util::LogCategory::MEMPOOL) << "Failed to write fee estimates: " << tmpPath.string();
+            file.close();
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool FeeEstimator::Load(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    DataStream ss(std::move(data));
+
+    try {
+        uint8_t magic[sizeof(FEE_ESTIMATES_MAGIC)];
+        ss.Read(magic, sizeof(magic));
+        uint16_t version = 0;
+        uint32_t height = 0, buckets = 0, targets = 0;
+        Unserialize(ss, version);
+        Unserialize(ss, height);
+        Unserialize(ss, buckets);
+        Unserialize(ss, targets);
+
+        // Statistics over other buckets or targets do not carry over
+        if (std::memcmp(magic, FEE_ESTIMATES_MAGIC, sizeof(magic)) != 0 ||
+            version != FEE_ESTIMATES_VERSION || buckets != bucketBounds.size() ||
+            targets != MAX_CONFIRM_TARGET) {
+            LOG_WARN(util::LogCategory::MEMPOOL) << "Ignoring incompatible fee estimates file "
+                                                 << path.string();
+            return false;
+        }
+
+        std::vector<double> newCount(buckets), newFees(buckets);
+        std::vector<std::vector<double>> newConfirmed(targets, std::vector<double>(buckets));
+        std::vector<std::vector<double>> newFailed(targets, std::vector<double>(buckets));
+        UnserializeDoubles(ss, newCount);
+        UnserializeDoubles(ss, newFees);
+        for (size_t t = 0; t < targets; ++t) {
+            UnserializeDoubles(ss, newConfirmed[t]);
+            UnserializeDoubles(ss, newFailed[t]);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        bestHeight = std::max(bestHeight, height);
+        txCount = std::move(newCount);
+        feeRateSum = std::move(newFees);
+        confirmedWithin = std::move(newConfirmed);
+        failedAfter = std::move(newFailed);
+    } catch (const std::exception&) {
+        LOG_WARN(util::LogCategory::MEMPOOL) << "Corrupt fee estimates file " << path.string();
+        return false;
+    }
+    return true;
+}
+
+} // namespace shurium
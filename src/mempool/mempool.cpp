@@ -3,14 +3,20 @@
 // MIT License
 
 #include "shurium/mempool/mempool.h"
+#include "shurium/mempool/fees.h"
+#include "shurium/chain/checkqueue.h"
 #include "shurium/consensus/validation.h"
 #include "shurium/consensus/params.h"
 #include "shurium/script/interpreter.h"
+#include "shurium/script/scriptcache.h"
+#include "shurium/script/sigcache.h"
+#include "shurium/util/trace.h"
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <cassert>
 #include <queue>
+#include <unordered_map>
 
 namespace shurium {
 
@@ -26,6 +32,59 @@ std::string FeeRate::ToString() const {
     return ss.str();
 }
 
+namespace {
+
+/// Bytes malloc takes for a block of n: a header, rounded to 16 bytes
+size_t MallocUsage(size_t n) {
+    return n == 0 ? 0 : ((n + 31) >> 4) << 4;
+}
+
+template <typename T>
+size_t VectorUsage(const std::vector<T>& v) {
+    return MallocUsage(v.capacity() * sizeof(T));
+}
+
+/// Heap memory of a transaction made by MakeTransactionRef
+size_t TransactionUsage(const Transaction& tx) {
+    // The shared control block sits in front of the transaction
+    size_t usage = MallocUsage(sizeof(Transaction) + 2 * sizeof(void*));
+    usage += VectorUsage(tx.vin) + VectorUsage(tx.vout);
+    for (const auto& txin : tx.vin) {
+        usage += VectorUsage(txin.scriptSig);
+    }
+    for (const auto& txout : tx.vout) {
+        usage += VectorUsage(txout.scriptPubKey);
+    }
+    return usage;
+}
+
+/// Bytes a pooled node of a hash map holding Value takes
+template <typename Value>
+constexpr size_t HashNodeUsage() {
+    // Next pointer and cached hash, rounded to the pool's alignment
+    return (sizeof(Value) + 2 * sizeof(void*) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
+/// Bytes a pooled node of a tree holding Value takes
+template <typename Value>
+constexpr size_t TreeNodeUsage() {
+    // Colour and three links
+    return (sizeof(Value) + 4 * sizeof(void*) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
+template <typename Map>
+size_t HashMapUsage(const Map& map) {
+    return map.size() * HashNodeUsage<typename Map::value_type>() +
+           MallocUsage(map.bucket_count() * sizeof(void*));
+}
+
+template <typename Tree>
+size_t TreeUsage(const Tree& tree) {
+    return tree.size() * TreeNodeUsage<typename Tree::value_type>();
+}
+
+} // anonymous namespace
+
 // ============================================================================
 // MempoolEntry Implementation
 // ============================================================================
@@ -34,41 +93,39 @@ MempoolEntry::MempoolEntry(const TransactionRef& txIn, Amount feeIn, int64_t tim
                            uint32_t heightIn, bool spendsCoinbaseIn)
     : tx(txIn)
     , nFee(feeIn)
-    , nTxSize(txIn->GetTotalSize())
+    , nModifiedFee(feeIn)
+    , nModFeesWithAncestors(feeIn)
+    , nModFeesWithDescendants(feeIn)
+    , feeRate(feeIn, txIn->GetTotalSize())
     , nTime(timeIn)
+    , nTxSize(static_cast<uint32_t>(txIn->GetTotalSize()))
+    , nTxUsage(static_cast<uint32_t>(TransactionUsage(*txIn)))
     , entryHeight(heightIn)
-    , spendsCoinbase(spendsCoinbaseIn)
-    , nModifiedFee(feeIn)
-    , feeRate(feeIn, nTxSize)
     , nCountWithAncestors(1)
     , nSizeWithAncestors(nTxSize)
-    , nModFeesWithAncestors(feeIn)
     , nCountWithDescendants(1)
     , nSizeWithDescendants(nTxSize)
-    , nModFeesWithDescendants(feeIn) {
+    , spendsCoinbase(spendsCoinbaseIn) {
 }
 
 void MempoolEntry::UpdateAncestorState(int64_t countDelta, int64_t sizeDelta, Amount feeDelta) const {
-    nCountWithAncestors = static_cast<uint64_t>(
+    nCountWithAncestors = static_cast<uint32_t>(
         std::max<int64_t>(1, static_cast<int64_t>(nCountWithAncestors) + countDelta));
-    nSizeWithAncestors = static_cast<uint64_t>(
-        std::max<int64_t>(static_cast<int64_t>(nTxSize), static_cast<int64_t>(nSizeWithAncestors) + sizeDelta));
+    nSizeWithAncestors = static_cast<uint32_t>(
+        std::max<int64_t>(nTxSize, static_cast<int64_t>(nSizeWithAncestors) + sizeDelta));
     nModFeesWithAncestors = std::max<Amount>(nModifiedFee, nModFeesWithAncestors + feeDelta);
 }
 
 void MempoolEntry::UpdateDescendantState(int64_t countDelta, int64_t sizeDelta, Amount feeDelta) const {
-    nCountWithDescendants = static_cast<uint64_t>(
+    nCountWithDescendants = static_cast<uint32_t>(
         std::max<int64_t>(1, static_cast<int64_t>(nCountWithDescendants) + countDelta));
-    nSizeWithDescendants = static_cast<uint64_t>(
-        std::max<int64_t>(static_cast<int64_t>(nTxSize), static_cast<int64_t>(nSizeWithDescendants) + sizeDelta));
+    nSizeWithDescendants = static_cast<uint32_t>(
+        std::max<int64_t>(nTxSize, static_cast<int64_t>(nSizeWithDescendants) + sizeDelta));
     nModFeesWithDescendants = std::max<Amount>(nModifiedFee, nModFeesWithDescendants + feeDelta);
 }
 
 size_t MempoolEntry::DynamicMemoryUsage() const {
-    size_t usage = sizeof(MempoolEntry);
-    // Add transaction size
-    usage += tx->GetTotalSize();
-    return usage;
+    return nTxUsage + VectorUsage(parents) + VectorUsage(children);
 }
 
 // ============================================================================
@@ -96,10 +153,117 @@ Mempool::Mempool() : limits() {}
 
 Mempool::Mempool(const MempoolLimits& limitsIn) : limits(limitsIn) {}
 
+// ============================================================================
+// Graph Walks
+// ============================================================================
+
+template <bool Ancestors, typename Fn>
+void Mempool::ForEachLinked(const std::vector<const MempoolEntry*>& roots, Fn&& fn) const {
+    // Walks do not nest: fn must not start another one
+    uint64_t epoch = ++visitEpoch;
+    visitStack.clear();
+    for (const MempoolEntry* root : roots) {
+        if (root->visitEpoch != epoch) {
+            root->visitEpoch = epoch;
+            visitStack.push_back(root);
+        }
+    }
+    
+    while (!visitStack.empty()) {
+        const MempoolEntry* entry = visitStack.back();
+        visitStack.pop_back();
+        for (const MempoolEntry* next : Ancestors ? entry->parents : entry->children) {
+            if (next->visitEpoch != epoch) {
+                next->visitEpoch = epoch;
+                visitStack.push_back(next);
+            }
+        }
+        fn(*entry);
+    }
+}
+
+void Mempool::StageWithDescendants(std::vector<const MempoolEntry*>& staged) const {
+    uint64_t epoch = ++visitEpoch;
+    visitStack.clear();
+    for (const MempoolEntry* root : staged) {
+        if (root->visitEpoch != epoch) {
+            root->visitEpoch = epoch;
+            visitStack.push_back(root);
+        }
+    }
+    
+    staged.clear();
+    while (!visitStack.empty()) {
+        const MempoolEntry* entry = visitStack.back();
+        visitStack.pop_back();
+        staged.push_back(entry);
+        for (const MempoolEntry* child : entry->children) {
+            if (child->visitEpoch != epoch) {
+                child->visitEpoch = epoch;
+                visitStack.push_back(child);
+            }
+        }
+    }
+}
+
 bool Mempool::AddTx(const TransactionRef& tx, Amount fee, uint32_t height,
                     bool spendsCoinbase, std::string& errString) {
-    std::lock_guard<std::mutex> lock(cs);
+    SHURIUM_TRACE_SPAN("Mempool::AddTx");
+    std::unique_lock<std::shared_mutex> lock(cs);
     
+    if (!AddTxLocked(tx, fee, height, spendsCoinbase, FeeRate(fee, tx->GetTotalSize()),
+                     GetTime(), errString)) {
+        return false;
+    }
+    TrackFeeLocked(tx->GetHash());
+    
+    // Enforce size limit
+    if (DynamicMemoryUsageLocked() > limits.maxSize) {
+        TrimToSize(limits.maxSize);
+    }
+    
+    return true;
+}
+
+std::vector<std::string> Mempool::AddPackage(const std::vector<MempoolPackageEntry>& package,
+                                             uint32_t height) {
+    std::unique_lock<std::shared_mutex> lock(cs);
+    
+    std::vector<std::string> errors(package.size());
+    std::unordered_set<TxHash, TxHasher> refused;
+    for (size_t i = 0; i < package.size(); ++i) {
+        const MempoolPackageEntry& entry = package[i];
+        bool parentRefused = std::any_of(entry.tx->vin.begin(), entry.tx->vin.end(),
+            [&](const TxIn& txin) { return refused.count(TxHash(txin.prevout.hash)) > 0; });
+        if (parentRefused) {
+            errors[i] = "missing-inputs";
+        } else if (AddTxLocked(entry.tx, entry.fee, height, entry.spendsCoinbase, entry.feeRate,
+                               entry.time ? entry.time : GetTime(), errors[i])) {
+            // Reloaded transactions did not arrive at this height
+            if (entry.time == 0) {
+                TrackFeeLocked(entry.tx->GetHash());
+            }
+            continue;
+        }
+        refused.insert(entry.tx->GetHash());
+    }
+    
+    // Enforce size limit once the package's children have joined their parents
+    if (DynamicMemoryUsageLocked() > limits.maxSize) {
+        TrimToSize(limits.maxSize);
+        for (size_t i = 0; i < package.size(); ++i) {
+            if (errors[i].empty() && mapTx.find(package[i].tx->GetHash()) == mapTx.end()) {
+                errors[i] = "mempool full";
+            }
+        }
+    }
+    
+    return errors;
+}
+
+bool Mempool::AddTxLocked(const TransactionRef& tx, Amount fee, uint32_t height,
+                          bool spendsCoinbase, FeeRate feeRate, int64_t time,
+                          std::string& errString) {
     TxHash txid = tx->GetHash();
     
     // Check if already in mempool
@@ -109,101 +273,46 @@ bool Mempool::AddTx(const TransactionRef& tx, Amount fee, uint32_t height,
     }
     
     // Check minimum fee rate
-    FeeRate txFeeRate(fee, tx->GetTotalSize());
-    if (txFeeRate < limits.minFeeRate) {
+    if (feeRate < limits.minFeeRate) {
         errString = "mempool min fee not met";
         return false;
     }
     
     // Check for conflicts and handle RBF (Replace-by-Fee) per BIP 125
-    std::set<TxHash> conflictingTxs;
-    std::set<TxHash> allConflicting;  // Including descendants
-    Amount conflictingFees = 0;
+    if (!CollectReplacements(*tx, fee, errString)) {
+        return false;
+    }
     
+    // All RBF rules passed - remove conflicting transactions
+    RemoveStaged(stagedEntries, MempoolRemovalReason::REPLACED);
+    
+    // Create entry and link it to the mempool transactions it spends
+    MempoolEntry entry(tx, fee, time, height, spendsCoinbase);
     for (const auto& txin : tx->vin) {
-        auto it = mapNextTx.find(txin.prevout);
-        if (it != mapNextTx.end()) {
-            conflictingTxs.insert(it->second);
+        auto parentIt = mapTx.find(TxHash(txin.prevout.hash));
+        if (parentIt != mapTx.end() &&
+            std::find(entry.parents.begin(), entry.parents.end(), &parentIt->second) == entry.parents.end()) {
+            entry.parents.push_back(&parentIt->second);
         }
     }
     
-    if (!conflictingTxs.empty()) {
-        // BIP 125 Rule 1: All conflicting transactions must signal replaceability
-        // A transaction signals RBF if any input has nSequence < (0xffffffff - 1)
-        for (const TxHash& conflictTxid : conflictingTxs) {
-            auto conflictIt = mapTx.find(conflictTxid);
-            if (conflictIt == mapTx.end()) {
-                continue;
-            }
-            
-            const Transaction& conflictTx = conflictIt->second.GetTx();
-            bool signalsRBF = false;
-            for (const auto& conflictIn : conflictTx.vin) {
-                // Signal RBF if nSequence < MAX_SEQUENCE_NONFINAL (0xfffffffe)
-                if (conflictIn.nSequence < TxIn::MAX_SEQUENCE_NONFINAL) {
-                    signalsRBF = true;
-                    break;
-                }
-            }
-            
-            if (!signalsRBF) {
-                errString = "txn-mempool-conflict";
-                return false;
-            }
-            
-            // Collect this transaction and all its descendants
-            allConflicting.insert(conflictTxid);
-            std::set<TxHash> descendants = GetDescendants(conflictTxid);
-            allConflicting.insert(descendants.begin(), descendants.end());
-        }
-        
-        // BIP 125 Rule 2: Replacement must not add new unconfirmed inputs
-        // (not strictly enforced here - would require checking if new inputs
-        // spend outputs that weren't already spent by conflicting set)
-        
-        // Calculate total fees and size of conflicting transactions
-        for (const TxHash& hash : allConflicting) {
-            auto it = mapTx.find(hash);
-            if (it != mapTx.end()) {
-                conflictingFees += it->second.GetFee();
-            }
-        }
-        
-        // BIP 125 Rule 3: Replacement must pay higher absolute fee
-        if (fee <= conflictingFees) {
-            errString = "insufficient fee for RBF replacement";
-            return false;
-        }
-        
-        // BIP 125 Rule 4: Fee increase must pay for new bandwidth
-        // The additional fee must at least cover the incremental relay fee
-        // for the new transaction's size
-        Amount requiredAdditionalFee = limits.incrementalRelayFee.GetFee(tx->GetTotalSize());
-        if (fee < conflictingFees + requiredAdditionalFee) {
-            errString = "insufficient fee for RBF, must pay incremental relay fee";
-            return false;
-        }
-        
-        // BIP 125 Rule 5: Number of original transactions evicted must be <= 100
-        if (allConflicting.size() > 100) {
-            errString = "too many potential replacements";
-            return false;
-        }
-        
-        // All RBF rules passed - remove conflicting transactions
-        for (const TxHash& hash : allConflicting) {
-            auto removeIt = mapTx.find(hash);
-            if (removeIt != mapTx.end()) {
-                RemoveUnchecked(removeIt, MempoolRemovalReason::REPLACED);
-            }
-        }
+    // Check ancestor limits, and the descendant limits of each ancestor
+    if (!CheckAncestorLimits(entry, errString)) {
+        return false;
     }
     
-    // Create entry
-    MempoolEntry entry(tx, fee, GetTime(), height, spendsCoinbase);
-    
-    // Check ancestor limits
-    if (!CheckAncestorLimits(entry, errString)) {
+    // Check the size of the cluster the entry would join
+    uint64_t clusterCount = 1;
+    for (size_t i = 0; i < entry.parents.size(); ++i) {
+        const MempoolCluster* parentCluster = entry.parents[i]->cluster;
+        bool counted = std::any_of(entry.parents.begin(), entry.parents.begin() + i,
+            [parentCluster](const MempoolEntry* other) { return other->cluster == parentCluster; });
+        if (!counted) {
+            clusterCount += parentCluster->txs.size();
+        }
+    }
+    if (clusterCount > limits.maxClusterCount) {
+        errString = "too many transactions in cluster";
         return false;
     }
     
@@ -213,46 +322,51 @@ bool Mempool::AddTx(const TransactionRef& tx, Amount fee, uint32_t height,
         errString = "failed to insert into mempool";
         return false;
     }
+    entriesByTime.emplace(it->second.GetTime(), &it->second);
+    const MempoolEntry& added = it->second;
     
     // Add to mapNextTx
     for (const auto& txin : tx->vin) {
         mapNextTx[txin.prevout] = txid;
     }
     
-    // Add to fee-sorted index
-    mapAncestorFee.insert(std::cref(it->second));
+    // Fold ancestors into this entry's state and this entry into theirs
+    int64_t ancestorCount = 0;
+    int64_t ancestorSize = 0;
+    Amount ancestorFees = 0;
+    int64_t txSize = static_cast<int64_t>(added.GetTxSize());
+    ForEachLinked<true>(added.parents, [&](const MempoolEntry& ancestor) {
+        ++ancestorCount;
+        ancestorSize += static_cast<int64_t>(ancestor.GetTxSize());
+        ancestorFees += ancestor.GetModifiedFee();
+        ancestor.UpdateDescendantState(1, txSize, added.GetModifiedFee());
+    });
+    added.UpdateAncestorState(ancestorCount, ancestorSize, ancestorFees);
+    for (const MempoolEntry* parent : added.parents) {
+        cachedInnerUsage -= VectorUsage(parent->children);
+        parent->children.push_back(&added);
+        cachedInnerUsage += VectorUsage(parent->children);
+    }
+    cachedInnerUsage += added.DynamicMemoryUsage();
+    
+    // Join the parents' clusters and relinearize
+    AddToCluster(added);
     
     // Update totals
-    totalTxSize += it->second.GetTxSize();
+    totalTxSize += added.GetTxSize();
     totalFees += fee;
+    ++txCount;
+    ++nChangeSequence;
     
-    // Update ancestors of this transaction
-    UpdateAncestorsOf(it, true);
-    
-    // Check descendant limits for ancestors and update their descendant stats
-    for (const auto& txin : tx->vin) {
-        auto spenderIt = mapTx.find(TxHash(txin.prevout.hash));
-        if (spenderIt != mapTx.end()) {
-            // This input spends a mempool tx - update its descendants
-            if (!CheckDescendantLimits(spenderIt, errString)) {
-                // Rollback
-                RemoveUnchecked(it, MempoolRemovalReason::UNKNOWN);
-                return false;
-            }
-            UpdateDescendantsOf(spenderIt, true);
-        }
-    }
-    
-    // Enforce size limit
-    if (totalTxSize > limits.maxSize) {
-        TrimToSize(limits.maxSize);
+    if (notifyAdded) {
+        notifyAdded(tx);
     }
     
     return true;
 }
 
 bool Mempool::CheckTx(const TransactionRef& tx, Amount fee, std::string& errString) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::unique_lock<std::shared_mutex> lock(cs);
     
     TxHash txid = tx->GetHash();
     
@@ -268,132 +382,47 @@ bool Mempool::CheckTx(const TransactionRef& tx, Amount fee, std::string& errStri
     }
     
     // Check for conflicts - if any exist, verify RBF is possible
-    std::set<TxHash> conflictingTxs;
-    for (const auto& txin : tx->vin) {
-        auto it = mapNextTx.find(txin.prevout);
-        if (it != mapNextTx.end()) {
-            conflictingTxs.insert(it->second);
-        }
-    }
-    
-    if (!conflictingTxs.empty()) {
-        // Check if all conflicting transactions signal RBF
-        Amount conflictingFees = 0;
-        std::set<TxHash> allConflicting;
-        
-        for (const TxHash& conflictTxid : conflictingTxs) {
-            auto conflictIt = mapTx.find(conflictTxid);
-            if (conflictIt == mapTx.end()) {
-                continue;
-            }
-            
-            const Transaction& conflictTx = conflictIt->second.GetTx();
-            bool signalsRBF = false;
-            for (const auto& conflictIn : conflictTx.vin) {
-                if (conflictIn.nSequence < TxIn::MAX_SEQUENCE_NONFINAL) {
-                    signalsRBF = true;
-                    break;
-                }
-            }
-            
-            if (!signalsRBF) {
-                errString = "txn-mempool-conflict";
-                return false;
-            }
-            
-            allConflicting.insert(conflictTxid);
-            std::set<TxHash> descendants = GetDescendants(conflictTxid);
-            allConflicting.insert(descendants.begin(), descendants.end());
-        }
-        
-        // Calculate conflicting fees
-        for (const TxHash& hash : allConflicting) {
-            auto it = mapTx.find(hash);
-            if (it != mapTx.end()) {
-                conflictingFees += it->second.GetFee();
-            }
-        }
-        
-        // Check fee requirements for RBF
-        if (fee <= conflictingFees) {
-            errString = "insufficient fee for RBF replacement";
-            return false;
-        }
-        
-        Amount requiredAdditionalFee = limits.incrementalRelayFee.GetFee(tx->GetTotalSize());
-        if (fee < conflictingFees + requiredAdditionalFee) {
-            errString = "insufficient fee for RBF, must pay incremental relay fee";
-            return false;
-        }
-        
-        if (allConflicting.size() > 100) {
-            errString = "too many potential replacements";
-            return false;
-        }
-    }
-    
-    return true;
+    return CollectReplacements(*tx, fee, errString);
 }
 
 void Mempool::RemoveTxAndDescendants(const TxHash& txid, MempoolRemovalReason reason) {
-    std::lock_guard<std::mutex> lock(cs);
+    std::unique_lock<std::shared_mutex> lock(cs);
     
     auto it = mapTx.find(txid);
     if (it == mapTx.end()) return;
     
-    // Get all descendants
-    std::set<TxHash> descendants = GetDescendants(txid);
-    descendants.insert(txid);
-    
-    // Remove in reverse topological order (descendants first)
-    std::vector<txiter> toRemove;
-    for (const auto& hash : descendants) {
-        auto descIt = mapTx.find(hash);
-        if (descIt != mapTx.end()) {
-            toRemove.push_back(descIt);
-        }
-    }
-    
-    // Sort by descendant count (most descendants first)
-    std::sort(toRemove.begin(), toRemove.end(),
-        [](const txiter& a, const txiter& b) {
-            return a->second.GetCountWithDescendants() > b->second.GetCountWithDescendants();
-        });
-    
-    for (auto& removeIt : toRemove) {
-        RemoveUnchecked(removeIt, reason);
-    }
+    stagedEntries.clear();
+    stagedEntries.push_back(&it->second);
+    StageWithDescendants(stagedEntries);
+    RemoveStaged(stagedEntries, reason);
 }
 
 void Mempool::RemoveConflicts(const Transaction& tx) {
-    std::lock_guard<std::mutex> lock(cs);
+    std::unique_lock<std::shared_mutex> lock(cs);
     
+    // Remove the conflicting transactions and their descendants
+    stagedEntries.clear();
     for (const auto& txin : tx.vin) {
         auto it = mapNextTx.find(txin.prevout);
         if (it != mapNextTx.end()) {
             auto txIt = mapTx.find(it->second);
             if (txIt != mapTx.end()) {
-                // Remove the conflicting tx and its descendants
-                std::set<TxHash> toRemove = GetDescendants(it->second);
-                toRemove.insert(it->second);
-                
-                for (const auto& hash : toRemove) {
-                    auto removeIt = mapTx.find(hash);
-                    if (removeIt != mapTx.end()) {
-                        RemoveUnchecked(removeIt, MempoolRemovalReason::CONFLICT);
-                    }
-                }
+                stagedEntries.push_back(&txIt->second);
             }
         }
     }
+    StageWithDescendants(stagedEntries);
+    RemoveStaged(stagedEntries, MempoolRemovalReason::CONFLICT);
 }
 
-void Mempool::RemoveForBlock(const std::vector<TransactionRef>& vtx) {
-    std::lock_guard<std::mutex> lock(cs);
+void Mempool::RemoveForBlock(const std::vector<TransactionRef>& vtx, uint32_t height) {
+    std::unique_lock<std::shared_mutex> lock(cs);
     
+    std::vector<TxHash> confirmed;
     for (const auto& tx : vtx) {
         auto it = mapTx.find(tx->GetHash());
         if (it != mapTx.end()) {
+            confirmed.push_back(it->first);
             RemoveUnchecked(it, MempoolRemovalReason::BLOCK);
         }
         
@@ -408,25 +437,36 @@ void Mempool::RemoveForBlock(const std::vector<TransactionRef>& vtx) {
             }
         }
     }
+    UpdateDirtyClusters();
+    
+    if (feeEstimator) {
+        feeEstimator->ProcessBlock(height, confirmed);
+    }
 }
 
 void Mempool::Clear() {
-    std::lock_guard<std::mutex> lock(cs);
+    std::unique_lock<std::shared_mutex> lock(cs);
     
     mapTx.clear();
     mapNextTx.clear();
-    mapAncestorFee.clear();
+    entriesByTime.clear();
+    clusters.clear();
+    clustersByWorstChunk.clear();
+    dirtyClusters.clear();
     totalTxSize = 0;
+    cachedInnerUsage = 0;
     totalFees = 0;
+    txCount = 0;
+    ++nChangeSequence;
 }
 
 bool Mempool::Exists(const TxHash& txid) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     return mapTx.find(txid) != mapTx.end();
 }
 
 TransactionRef Mempool::Get(const TxHash& txid) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     auto it = mapTx.find(txid);
     if (it != mapTx.end()) {
         return it->second.GetSharedTx();
@@ -435,7 +475,7 @@ TransactionRef Mempool::Get(const TxHash& txid) const {
 }
 
 std::optional<TxMempoolInfo> Mempool::GetInfo(const TxHash& txid) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     auto it = mapTx.find(txid);
     if (it == mapTx.end()) {
         return std::nullopt;
@@ -447,11 +487,12 @@ std::optional<TxMempoolInfo> Mempool::GetInfo(const TxHash& txid) const {
     info.fee = it->second.GetFee();
     info.vsize = it->second.GetTxSize();
     info.feeRate = it->second.GetFeeRate();
+    info.feeDelta = it->second.GetModifiedFee() - it->second.GetFee();
     return info;
 }
 
 TransactionRef Mempool::GetSpender(const OutPoint& outpoint) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     auto it = mapNextTx.find(outpoint);
     if (it != mapNextTx.end()) {
         auto txIt = mapTx.find(it->second);
@@ -463,12 +504,12 @@ TransactionRef Mempool::GetSpender(const OutPoint& outpoint) const {
 }
 
 bool Mempool::IsSpent(const OutPoint& outpoint) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     return mapNextTx.find(outpoint) != mapNextTx.end();
 }
 
 bool Mempool::HasConflicts(const Transaction& tx) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     for (const auto& txin : tx.vin) {
         if (mapNextTx.find(txin.prevout) != mapNextTx.end()) {
             return true;
@@ -478,16 +519,17 @@ bool Mempool::HasConflicts(const Transaction& tx) const {
 }
 
 FeeRate Mempool::GetMinFee() const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     
     // If mempool is below half full, use configured minimum
-    if (totalTxSize < limits.maxSize / 2) {
+    if (DynamicMemoryUsageLocked() < limits.maxSize / 2) {
         return limits.minFeeRate;
     }
     
-    // Otherwise, use the lowest fee in mempool as minimum
-    if (!mapAncestorFee.empty()) {
-        return mapAncestorFee.begin()->get().GetAncestorFeeRate();
+    // Otherwise, use the lowest chunk feerate in mempool as minimum
+    if (!clustersByWorstChunk.empty()) {
+        const ClusterChunk& worst = (*clustersByWorstChunk.begin())->WorstChunk();
+        return FeeRate(worst.fee, worst.size);
     }
     
     return limits.minFeeRate;
@@ -496,91 +538,138 @@ FeeRate Mempool::GetMinFee() const {
 std::vector<TransactionRef> Mempool::GetTransactionsForBlock(
     size_t maxSize, FeeRate minFeeRate) const {
     
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     
     std::vector<TransactionRef> result;
     size_t currentSize = 0;
     
-    // Collect all entries and sort by descendant score
-    std::vector<std::reference_wrapper<const MempoolEntry>> sorted;
-    sorted.reserve(mapTx.size());
-    for (const auto& [txid, entry] : mapTx) {
-        if (entry.GetModifiedFeeRate() >= minFeeRate) {
-            sorted.push_back(std::cref(entry));
-        }
-    }
-    
-    std::sort(sorted.begin(), sorted.end(), CompareMempoolEntryByDescendantScore());
+    // Clusters with a chunk left out, whose later chunks may depend on it
+    std::unordered_set<uint64_t> skipped;
     
-    // Track which transactions we've added (for parent checking)
-    std::unordered_set<TxHash, TxHasher> added;
-    
-    // Add transactions in priority order
-    for (const auto& entryRef : sorted) {
-        const MempoolEntry& entry = entryRef.get();
+    for (const TxMempoolChunk& chunk : ChunksByFeerate()) {
+        // Chunks come best first, so the rest are below the minimum too
+        if (chunk.feeRate < minFeeRate) {
+            break;
+        }
         
-        // Check size limit
-        if (currentSize + entry.GetTxSize() > maxSize) {
+        if (skipped.count(chunk.cluster) || currentSize + chunk.size > maxSize) {
+            skipped.insert(chunk.cluster);
             continue;
         }
         
-        // Check that all parents are either confirmed or already added
-        bool parentsOk = true;
-        for (const auto& txin : entry.GetTx().vin) {
-            // Check if this input spends a mempool tx
-            auto parentIt = mapTx.find(TxHash(txin.prevout.hash));
-            if (parentIt != mapTx.end()) {
-                // Parent is in mempool - must be in our result
-                if (added.find(parentIt->first) == added.end()) {
-                    parentsOk = false;
-                    break;
-                }
-            }
+        for (const TxMempoolInfo& info : chunk.txs) {
+            result.push_back(info.tx);
         }
+        currentSize += chunk.size;
+    }
+    
+    return result;
+}
+
+std::vector<TxMempoolChunk> Mempool::GetChunksForMining() const {
+    std::shared_lock<std::shared_mutex> lock(cs);
+    return ChunksByFeerate();
+}
+
+std::vector<TxMempoolChunk> Mempool::ChunksByFeerate() const {
+    // Each cluster's chunks are already best first; merge the clusters by
+    // their next chunk
+    struct Cursor {
+        const MempoolCluster* cluster;
+        size_t chunk;
+        size_t firstTx;
+    };
+    auto worse = [](const Cursor& a, const Cursor& b) {
+        const ClusterChunk& chunkA = a.cluster->chunks[a.chunk];
+        const ClusterChunk& chunkB = b.cluster->chunks[b.chunk];
+        if (HigherFeerate(chunkB, chunkA)) return true;
+        if (HigherFeerate(chunkA, chunkB)) return false;
+        return a.cluster->id > b.cluster->id;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(worse)> heads(worse);
+    for (const auto& [id, cluster] : clusters) {
+        heads.push({&cluster, 0, 0});
+    }
+    
+    std::vector<TxMempoolChunk> result;
+    while (!heads.empty()) {
+        Cursor cursor = heads.top();
+        heads.pop();
         
-        if (!parentsOk) continue;
+        const ClusterChunk& chunk = cursor.cluster->chunks[cursor.chunk];
+        TxMempoolChunk out;
+        out.fee = chunk.fee;
+        out.size = static_cast<size_t>(chunk.size);
+        out.feeRate = FeeRate(chunk.fee, out.size);
+        out.cluster = cursor.cluster->id;
+        out.txs.reserve(chunk.count);
+        for (size_t i = cursor.firstTx; i < cursor.firstTx + chunk.count; ++i) {
+            const MempoolEntry& entry = *cursor.cluster->txs[i];
+            out.txs.push_back({entry.GetSharedTx(), entry.GetTime(), entry.GetFee(),
+                               entry.GetTxSize(), entry.GetFeeRate(),
+                               entry.GetModifiedFee() - entry.GetFee()});
+        }
+        result.push_back(std::move(out));
         
-        result.push_back(entry.GetSharedTx());
-        added.insert(entry.GetTxHash());
-        currentSize += entry.GetTxSize();
+        if (cursor.chunk + 1 < cursor.cluster->chunks.size()) {
+            heads.push({cursor.cluster, cursor.chunk + 1, cursor.firstTx + chunk.count});
+        }
     }
     
     return result;
 }
 
 std::vector<TxMempoolInfo> Mempool::GetAllTxInfo() const {
-    std::lock_guard<std::mutex> lock(cs);
-    
-    std::vector<TxMempoolInfo> result;
-    result.reserve(mapTx.size());
-    
-    for (const auto& [txid, entry] : mapTx) {
-        TxMempoolInfo info;
-        info.tx = entry.GetSharedTx();
-        info.time = entry.GetTime();
-        info.fee = entry.GetFee();
-        info.vsize = entry.GetTxSize();
-        info.feeRate = entry.GetFeeRate();
-        result.push_back(std::move(info));
+    return GetSnapshot()->txs;
+}
+
+std::shared_ptr<const MempoolSnapshot> Mempool::GetSnapshot() const {
+    std::shared_ptr<const MempoolSnapshot> current = std::atomic_load(&snapshot);
+    if (current && current->sequence == nChangeSequence.load()) {
+        return current;
+    }
+    
+    auto fresh = std::make_shared<MempoolSnapshot>();
+    {
+        std::shared_lock<std::shared_mutex> lock(cs);
+        fresh->sequence = nChangeSequence.load();
+        fresh->totalSize = totalTxSize.load();
+        fresh->totalFees = totalFees.load();
+        fresh->txs.reserve(mapTx.size());
+        for (const auto& [txid, entry] : mapTx) {
+            TxMempoolInfo info;
+            info.tx = entry.GetSharedTx();
+            info.time = entry.GetTime();
+            info.fee = entry.GetFee();
+            info.vsize = entry.GetTxSize();
+            info.feeRate = entry.GetFeeRate();
+            info.feeDelta = entry.GetModifiedFee() - entry.GetFee();
+            fresh->txs.push_back(std::move(info));
+        }
     }
     
-    return result;
+    // Racing rebuilders store equivalent copies; keep the newest
+    current = std::atomic_load(&snapshot);
+    if (!current || current->sequence < fresh->sequence) {
+        std::atomic_store(&snapshot, std::shared_ptr<const MempoolSnapshot>(fresh));
+    }
+    return fresh;
 }
 
 void Mempool::LimitSize(int64_t currentTime) {
-    std::lock_guard<std::mutex> lock(cs);
+    std::unique_lock<std::shared_mutex> lock(cs);
     
     // First expire old transactions
     ExpireOld(currentTime);
     
     // Then trim to size limit
-    if (totalTxSize > limits.maxSize) {
+    if (DynamicMemoryUsageLocked() > limits.maxSize) {
         TrimToSize(limits.maxSize);
     }
 }
 
 bool Mempool::CheckConsistency() const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::unique_lock<std::shared_mutex> lock(cs);
     
     // Check mapNextTx consistency
     for (const auto& [txid, entry] : mapTx) {
@@ -594,18 +683,112 @@ bool Mempool::CheckConsistency() const {
     
     // Check size consistency
     size_t computedSize = 0;
+    size_t computedUsage = 0;
     for (const auto& [txid, entry] : mapTx) {
         computedSize += entry.GetTxSize();
+        computedUsage += entry.DynamicMemoryUsage();
     }
-    if (computedSize != totalTxSize) {
+    if (computedSize != totalTxSize || computedUsage != cachedInnerUsage ||
+        mapTx.size() != txCount) {
         return false;
     }
     
+    // Check clusters: every member is in one, once, in a topological order
+    // whose chunks agree with the members
+    size_t clusteredCount = 0;
+    for (const auto& [id, cluster] : clusters) {
+        if (cluster.txs.empty() || cluster.dirty || clustersByWorstChunk.count(&cluster) == 0) {
+            return false;
+        }
+        for (size_t i = 0; i < cluster.txs.size(); ++i) {
+            const MempoolEntry* member = cluster.txs[i];
+            if (member->cluster != &cluster) {
+                return false;
+            }
+            for (const MempoolEntry* parent : member->parents) {
+                auto end = cluster.txs.begin() + i;
+                if (std::find(cluster.txs.begin(), end, parent) == end) {
+                    return false;
+                }
+            }
+        }
+        size_t chunkedCount = 0;
+        for (size_t i = 0; i < cluster.chunks.size(); ++i) {
+            if (i > 0 && HigherFeerate(cluster.chunks[i], cluster.chunks[i - 1])) {
+                return false;
+            }
+            chunkedCount += cluster.chunks[i].count;
+        }
+        if (chunkedCount != cluster.txs.size()) {
+            return false;
+        }
+        clusteredCount += cluster.txs.size();
+    }
+    if (clusteredCount != mapTx.size() || clustersByWorstChunk.size() != clusters.size() ||
+        !dirtyClusters.empty() || entriesByTime.size() != mapTx.size()) {
+        return false;
+    }
+    
+    // Check parent/child links and the ancestor/descendant stats they imply
+    for (const auto& [txid, entry] : mapTx) {
+        size_t parentCount = 0;
+        for (const auto& txin : entry.GetTx().vin) {
+            auto parentIt = mapTx.find(TxHash(txin.prevout.hash));
+            if (parentIt == mapTx.end()) {
+                continue;
+            }
+            const auto& parents = entry.parents;
+            if (std::find(parents.begin(), parents.end(), &parentIt->second) == parents.end()) {
+                return false;
+            }
+            const auto& siblings = parentIt->second.children;
+            if (std::find(siblings.begin(), siblings.end(), &entry) == siblings.end()) {
+                return false;
+            }
+            ++parentCount;
+        }
+        if (entry.parents.size() > parentCount) {
+            return false;
+        }
+        for (const MempoolEntry* child : entry.children) {
+            const auto& coparents = child->parents;
+            if (std::find(coparents.begin(), coparents.end(), &entry) == coparents.end()) {
+                return false;
+            }
+        }
+        
+        uint64_t count = 1;
+        uint64_t size = entry.GetTxSize();
+        Amount fees = entry.GetModifiedFee();
+        ForEachLinked<true>(entry.parents, [&](const MempoolEntry& ancestor) {
+            ++count;
+            size += ancestor.GetTxSize();
+            fees += ancestor.GetModifiedFee();
+        });
+        if (count != entry.GetCountWithAncestors() || size != entry.GetSizeWithAncestors() ||
+            fees != entry.GetModFeesWithAncestors()) {
+            return false;
+        }
+        
+        count = 1;
+        size = entry.GetTxSize();
+        fees = entry.GetModifiedFee();
+        ForEachLinked<false>(entry.children, [&](const MempoolEntry& descendant) {
+            ++count;
+            size += descendant.GetTxSize();
+            fees += descendant.GetModifiedFee();
+        });
+        if (count != entry.GetCountWithDescendants() || size != entry.GetSizeWithDescendants() ||
+            fees != entry.GetModFeesWithDescendants()) {
+            return false;
+        }
+    }
+    
     return true;
 }
 
 std::optional<Coin> Mempool::GetCoin(const OutPoint& outpoint) const {
-    std::lock_guard<std::mutex> lock(cs);
+    std::shared_lock<std::shared_mutex> lock(cs);
     
     // Find the transaction that created this output
     auto txIt = mapTx.find(TxHash(outpoint.hash));
@@ -630,143 +813,321 @@ std::optional<Coin> Mempool::GetCoin(const OutPoint& outpoint) const {
 // Internal Helpers
 // ============================================================================
 
+void Mempool::TrackFeeLocked(const TxHash& txid) {
+    if (!feeEstimator) {
+        return;
+    }
+    // A child's confirmation time depends on its parents, not its own feerate
+    auto it = mapTx.find(txid);
+    if (it == mapTx.end() || !it->second.GetParents().empty()) {
+        return;
+    }
+    const MempoolEntry& entry = it->second;
+    feeEstimator->ProcessTransaction(txid, FeeRate(entry.GetFee(), entry.GetTxSize()),
+                                     entry.GetHeight());
+}
+
 void Mempool::RemoveUnchecked(txiter it, MempoolRemovalReason reason) {
+    const MempoolEntry& entry = it->second;
+    
     // Notify callback
     if (notifyRemoved) {
-        notifyRemoved(it->second.GetSharedTx(), reason);
+        notifyRemoved(entry.GetSharedTx(), reason);
     }
+    if (feeEstimator && reason != MempoolRemovalReason::BLOCK) {
+        feeEstimator->RemoveTransaction(it->first);
+    }
+    
+    int64_t txSize = static_cast<int64_t>(entry.GetTxSize());
+    Amount modFee = entry.GetModifiedFee();
     
     // Update ancestors' descendant stats
-    UpdateAncestorsOf(it, false);
+    ForEachLinked<true>(entry.parents, [&](const MempoolEntry& ancestor) {
+        ancestor.UpdateDescendantState(-1, -txSize, -modFee);
+    });
     
-    // Remove from mapAncestorFee
-    mapAncestorFee.erase(std::cref(it->second));
+    // Update descendants' ancestor stats
+    ForEachLinked<false>(entry.children, [&](const MempoolEntry& descendant) {
+        descendant.UpdateAncestorState(-1, -txSize, -modFee);
+    });
+    
+    // Unlink from parents and children
+    for (const MempoolEntry* parent : entry.parents) {
+        auto& siblings = parent->children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), &entry));
+    }
+    for (const MempoolEntry* child : entry.children) {
+        auto& coparents = child->parents;
+        coparents.erase(std::find(coparents.begin(), coparents.end(), &entry));
+    }
+    
+    // Leave the cluster, to be relinearized by UpdateDirtyClusters
+    MempoolCluster* cluster = entry.cluster;
+    if (!cluster->dirty) {
+        clustersByWorstChunk.erase(cluster);
+        cluster->dirty = true;
+        dirtyClusters.push_back(cluster);
+    }
+    cluster->txs.erase(std::find(cluster->txs.begin(), cluster->txs.end(), &entry));
     
     // Remove from mapNextTx
-    for (const auto& txin : it->second.GetTx().vin) {
+    for (const auto& txin : entry.GetTx().vin) {
         mapNextTx.erase(txin.prevout);
     }
+    entriesByTime.erase({entry.GetTime(), &entry});
     
-    // Update totals
-    totalTxSize -= it->second.GetTxSize();
-    totalFees -= it->second.GetFee();
+    // Update totals; unlinking shrank no vector's capacity
+    cachedInnerUsage -= entry.DynamicMemoryUsage();
+    totalTxSize -= entry.GetTxSize();
+    totalFees -= entry.GetFee();
+    --txCount;
+    ++nChangeSequence;
     
     // Remove from main map
     mapTx.erase(it);
 }
 
-void Mempool::UpdateAncestorsOf(txiter it, bool add) {
-    // Get parents (transactions whose outputs this tx spends)
-    std::set<TxHash> parents;
-    for (const auto& txin : it->second.GetTx().vin) {
-        TxHash parentHash(txin.prevout.hash);
-        if (mapTx.find(parentHash) != mapTx.end()) {
-            parents.insert(parentHash);
-        }
-    }
-    
-    // Update this entry's ancestor stats
-    int64_t countDelta = add ? 1 : -1;
-    size_t totalParentSize = 0;
-    Amount totalParentFees = 0;
+void Mempool::RemoveStaged(std::vector<const MempoolEntry*>& staged, MempoolRemovalReason reason) {
+    // An entry counts more ancestors than any of its ancestors, so this
+    // removes every descendant before the entries it spends from
+    std::sort(staged.begin(), staged.end(),
+        [](const MempoolEntry* a, const MempoolEntry* b) {
+            return a->GetCountWithAncestors() > b->GetCountWithAncestors();
+        });
     
-    for (const auto& parentHash : parents) {
-        auto parentIt = mapTx.find(parentHash);
-        if (parentIt != mapTx.end()) {
-            totalParentSize += parentIt->second.GetSizeWithAncestors();
-            totalParentFees += parentIt->second.GetModFeesWithAncestors();
+    for (const MempoolEntry* entry : staged) {
+        RemoveUnchecked(mapTx.find(entry->GetTxHash()), reason);
+    }
+    staged.clear();
+    UpdateDirtyClusters();
+}
+
+MempoolCluster& Mempool::NewCluster() {
+    uint64_t id = ++nSequence;
+    MempoolCluster& cluster = clusters[id];
+    cluster.id = id;
+    return cluster;
+}
+
+void Mempool::AddToCluster(const MempoolEntry& entry) {
+    // Merge the parents' clusters into the first one. They share no spends,
+    // so their members in turn, then the entry, stay in a topological order
+    MempoolCluster* target = nullptr;
+    for (const MempoolEntry* parent : entry.parents) {
+        MempoolCluster* parentCluster = parent->cluster;
+        if (parentCluster == target) {
+            continue;
+        }
+        clustersByWorstChunk.erase(parentCluster);
+        if (!target) {
+            target = parentCluster;
+            continue;
         }
+        for (const MempoolEntry* member : parentCluster->txs) {
+            member->cluster = target;
+            target->txs.push_back(member);
+        }
+        clusters.erase(parentCluster->id);
     }
     
-    if (add) {
-        it->second.UpdateAncestorState(
-            static_cast<int64_t>(parents.size()),
-            static_cast<int64_t>(totalParentSize),
-            totalParentFees - it->second.GetModifiedFee() * static_cast<int64_t>(parents.size())
-        );
+    if (!target) {
+        target = &NewCluster();
     }
+    entry.cluster = target;
+    target->txs.push_back(&entry);
+    RelinearizeCluster(*target);
 }
 
-void Mempool::UpdateDescendantsOf(txiter it, bool add) {
-    // This would update descendant stats for all descendants
-    // Simplified implementation - would need full graph traversal for production
-    int64_t countDelta = add ? 1 : -1;
-    int64_t sizeDelta = add ? static_cast<int64_t>(it->second.GetTxSize()) 
-                            : -static_cast<int64_t>(it->second.GetTxSize());
-    Amount feeDelta = add ? it->second.GetModifiedFee() : -it->second.GetModifiedFee();
+void Mempool::RelinearizeCluster(MempoolCluster& cluster) {
+    for (size_t i = 0; i < cluster.txs.size(); ++i) {
+        cluster.txs[i]->clusterPosition = static_cast<uint32_t>(i);
+    }
+    
+    std::vector<ClusterTx> txs(cluster.txs.size());
+    for (size_t i = 0; i < cluster.txs.size(); ++i) {
+        const MempoolEntry& member = *cluster.txs[i];
+        txs[i].fee = member.GetModifiedFee();
+        txs[i].size = member.GetTxSize();
+        txs[i].parents.reserve(member.parents.size());
+        for (const MempoolEntry* parent : member.parents) {
+            txs[i].parents.push_back(parent->clusterPosition);
+        }
+    }
     
-    it->second.UpdateDescendantState(countDelta, sizeDelta, feeDelta);
+    std::vector<uint32_t> order = shurium::LinearizeCluster(txs);
+    std::vector<const MempoolEntry*> linearized;
+    linearized.reserve(order.size());
+    for (uint32_t pos : order) {
+        linearized.push_back(cluster.txs[pos]);
+    }
+    cluster.txs.swap(linearized);
+    cluster.chunks = ChunkLinearization(txs, order);
+    cluster.dirty = false;
+    clustersByWorstChunk.insert(&cluster);
 }
 
-bool Mempool::CheckAncestorLimits(const MempoolEntry& entry, std::string& errString) const {
-    // Count ancestors
-    std::set<TxHash> ancestors;
-    std::queue<TxHash> toProcess;
-    
-    for (const auto& txin : entry.GetTx().vin) {
-        TxHash parentHash(txin.prevout.hash);
-        if (mapTx.find(parentHash) != mapTx.end()) {
-            toProcess.push(parentHash);
+void Mempool::UpdateDirtyClusters() {
+    for (MempoolCluster* cluster : dirtyClusters) {
+        std::vector<const MempoolEntry*> members;
+        members.swap(cluster->txs);
+        if (members.empty()) {
+            clusters.erase(cluster->id);
+            continue;
+        }
+        
+        // Removals may have split the cluster; give each connected part a
+        // cluster of its own, the first part keeping this one
+        uint64_t epoch = ++visitEpoch;
+        std::vector<MempoolCluster*> parts;
+        for (const MempoolEntry* member : members) {
+            if (member->visitEpoch == epoch) {
+                continue;
+            }
+            MempoolCluster* part = parts.empty() ? cluster : &NewCluster();
+            parts.push_back(part);
+            
+            member->visitEpoch = epoch;
+            visitStack.clear();
+            visitStack.push_back(member);
+            while (!visitStack.empty()) {
+                const MempoolEntry* current = visitStack.back();
+                visitStack.pop_back();
+                current->cluster = part;
+                for (const auto* links : {&current->parents, &current->children}) {
+                    for (const MempoolEntry* next : *links) {
+                        if (next->visitEpoch != epoch) {
+                            next->visitEpoch = epoch;
+                            visitStack.push_back(next);
+                        }
+                    }
+                }
+            }
+        }
+        
+        // The old order restricted to each part is still topological
+        for (const MempoolEntry* member : members) {
+            member->cluster->txs.push_back(member);
+        }
+        for (MempoolCluster* part : parts) {
+            RelinearizeCluster(*part);
         }
     }
+    dirtyClusters.clear();
+}
+
+bool Mempool::CollectReplacements(const Transaction& tx, Amount fee, std::string& errString) const {
+    stagedEntries.clear();
     
-    while (!toProcess.empty()) {
-        TxHash current = toProcess.front();
-        toProcess.pop();
-        
-        if (ancestors.count(current)) continue;
-        ancestors.insert(current);
+    for (const auto& txin : tx.vin) {
+        auto it = mapNextTx.find(txin.prevout);
+        if (it == mapNextTx.end()) {
+            continue;
+        }
+        auto conflictIt = mapTx.find(it->second);
+        if (conflictIt == mapTx.end()) {
+            continue;
+        }
         
-        auto it = mapTx.find(current);
-        if (it != mapTx.end()) {
-            for (const auto& txin : it->second.GetTx().vin) {
-                TxHash parentHash(txin.prevout.hash);
-                if (mapTx.find(parentHash) != mapTx.end()) {
-                    toProcess.push(parentHash);
-                }
+        // BIP 125 Rule 1: All conflicting transactions must signal replaceability
+        // A transaction signals RBF if any input has nSequence < (0xffffffff - 1)
+        const Transaction& conflictTx = conflictIt->second.GetTx();
+        bool signalsRBF = false;
+        for (const auto& conflictIn : conflictTx.vin) {
+            // Signal RBF if nSequence < MAX_SEQUENCE_NONFINAL (0xfffffffe)
+            if (conflictIn.nSequence < TxIn::MAX_SEQUENCE_NONFINAL) {
+                signalsRBF = true;
+                break;
             }
         }
+        
+        if (!signalsRBF) {
+            stagedEntries.clear();
+            errString = "txn-mempool-conflict";
+            return false;
+        }
+        
+        stagedEntries.push_back(&conflictIt->second);
     }
     
-    if (ancestors.size() + 1 > limits.maxAncestorCount) {
-        errString = "too many unconfirmed ancestors";
+    if (stagedEntries.empty()) {
+        return true;
+    }
+    
+    // Collect the conflicting transactions and all their descendants
+    StageWithDescendants(stagedEntries);
+    
+    // BIP 125 Rule 2: Replacement must not add new unconfirmed inputs
+    // (not strictly enforced here - would require checking if new inputs
+    // spend outputs that weren't already spent by conflicting set)
+    
+    // Calculate total fees of conflicting transactions
+    Amount conflictingFees = 0;
+    for (const MempoolEntry* entry : stagedEntries) {
+        conflictingFees += entry->GetFee();
+    }
+    
+    // BIP 125 Rule 3: Replacement must pay higher absolute fee
+    if (fee <= conflictingFees) {
+        stagedEntries.clear();
+        errString = "insufficient fee for RBF replacement";
         return false;
     }
     
-    size_t ancestorSize = entry.GetTxSize();
-    for (const auto& hash : ancestors) {
-        auto it = mapTx.find(hash);
-        if (it != mapTx.end()) {
-            ancestorSize += it->second.GetTxSize();
-        }
+    // BIP 125 Rule 4: Fee increase must pay for new bandwidth
+    // The additional fee must at least cover the incremental relay fee
+    // for the new transaction's size
+    Amount requiredAdditionalFee = limits.incrementalRelayFee.GetFee(tx.GetTotalSize());
+    if (fee < conflictingFees + requiredAdditionalFee) {
+        stagedEntries.clear();
+        errString = "insufficient fee for RBF, must pay incremental relay fee";
+        return false;
     }
     
-    if (ancestorSize > limits.maxAncestorSize) {
-        errString = "exceeds ancestor size limit";
+    // BIP 125 Rule 5: Number of original transactions evicted must be <= 100
+    if (stagedEntries.size() > 100) {
+        stagedEntries.clear();
+        errString = "too many potential replacements";
         return false;
     }
     
     return true;
 }
 
-bool Mempool::CheckDescendantLimits(txiter ancestor, std::string& errString) const {
-    // Get all descendants
-    std::set<TxHash> descendants = GetDescendants(ancestor->first);
+bool Mempool::CheckAncestorLimits(const MempoolEntry& entry, std::string& errString) const {
+    // One walk sums the ancestors and checks what the entry adds to each
+    // ancestor's descendants
+    uint64_t ancestorCount = 0;
+    uint64_t ancestorSize = entry.GetTxSize();
+    bool tooManyDescendants = false;
+    bool descendantsTooLarge = false;
+    
+    ForEachLinked<true>(entry.parents, [&](const MempoolEntry& ancestor) {
+        ++ancestorCount;
+        ancestorSize += ancestor.GetTxSize();
+        if (ancestor.GetCountWithDescendants() + 1 > limits.maxDescendantCount) {
+            tooManyDescendants = true;
+        }
+        if (ancestor.GetSizeWithDescendants() + entry.GetTxSize() > limits.maxDescendantSize) {
+            descendantsTooLarge = true;
+        }
+    });
     
-    if (descendants.size() + 1 > limits.maxDescendantCount) {
-        errString = "too many descendants";
+    if (ancestorCount + 1 > limits.maxAncestorCount) {
+        errString = "too many unconfirmed ancestors";
         return false;
     }
     
-    size_t descendantSize = ancestor->second.GetTxSize();
-    for (const auto& hash : descendants) {
-        auto it = mapTx.find(hash);
-        if (it != mapTx.end()) {
-            descendantSize += it->second.GetTxSize();
-        }
+    if (ancestorSize > limits.maxAncestorSize) {
+        errString = "exceeds ancestor size limit";
+        return false;
     }
     
-    if (descendantSize > limits.maxDescendantSize) {
+    if (tooManyDescendants) {
+        errString = "too many descendants";
+        return false;
+    }
+    
+    if (descendantsTooLarge) {
         errString = "exceeds descendant size limit";
         return false;
     }
@@ -774,117 +1135,40 @@ bool Mempool::CheckDescendantLimits(txiter ancestor, std::string& errString) con
     return true;
 }
 
-std::set<TxHash> Mempool::GetAncestors(const TxHash& txid) const {
-    std::set<TxHash> result;
-    
-    auto it = mapTx.find(txid);
-    if (it == mapTx.end()) return result;
-    
-    std::queue<TxHash> toProcess;
-    for (const auto& txin : it->second.GetTx().vin) {
-        TxHash parentHash(txin.prevout.hash);
-        if (mapTx.find(parentHash) != mapTx.end()) {
-            toProcess.push(parentHash);
-        }
-    }
-    
-    while (!toProcess.empty()) {
-        TxHash current = toProcess.front();
-        toProcess.pop();
-        
-        if (result.count(current)) continue;
-        result.insert(current);
-        
-        auto parentIt = mapTx.find(current);
-        if (parentIt != mapTx.end()) {
-            for (const auto& txin : parentIt->second.GetTx().vin) {
-                TxHash grandparentHash(txin.prevout.hash);
-                if (mapTx.find(grandparentHash) != mapTx.end()) {
-                    toProcess.push(grandparentHash);
-                }
-            }
-        }
-    }
-    
-    return result;
+size_t Mempool::DynamicMemoryUsage() const {
+    std::shared_lock<std::shared_mutex> lock(cs);
+    return DynamicMemoryUsageLocked();
 }
 
-std::set<TxHash> Mempool::GetDescendants(const TxHash& txid) const {
-    std::set<TxHash> result;
-    
-    auto it = mapTx.find(txid);
-    if (it == mapTx.end()) return result;
-    
-    // Find all outputs of this transaction
-    std::queue<TxHash> toProcess;
-    
-    const Transaction& tx = it->second.GetTx();
-    for (size_t i = 0; i < tx.vout.size(); ++i) {
-        OutPoint outpoint(it->first, static_cast<uint32_t>(i));
-        auto nextIt = mapNextTx.find(outpoint);
-        if (nextIt != mapNextTx.end()) {
-            toProcess.push(nextIt->second);
-        }
-    }
-    
-    while (!toProcess.empty()) {
-        TxHash current = toProcess.front();
-        toProcess.pop();
-        
-        if (result.count(current)) continue;
-        result.insert(current);
-        
-        auto childIt = mapTx.find(current);
-        if (childIt != mapTx.end()) {
-            const Transaction& childTx = childIt->second.GetTx();
-            for (size_t i = 0; i < childTx.vout.size(); ++i) {
-                OutPoint outpoint(current, static_cast<uint32_t>(i));
-                auto nextIt = mapNextTx.find(outpoint);
-                if (nextIt != mapNextTx.end()) {
-                    toProcess.push(nextIt->second);
-                }
-            }
-        }
-    }
-    
-    return result;
+size_t Mempool::DynamicMemoryUsageLocked() const {
+    // Cluster member and chunk lists hold at most one slot per entry each
+    size_t clusterLists = mapTx.size() * (sizeof(const MempoolEntry*) + sizeof(ClusterChunk));
+    return cachedInnerUsage + clusterLists +
+           HashMapUsage(mapTx) + HashMapUsage(mapNextTx) +
+           TreeUsage(clusters) + TreeUsage(clustersByWorstChunk) + TreeUsage(entriesByTime);
 }
 
 void Mempool::TrimToSize(size_t targetSize) {
-    // Remove lowest fee-rate transactions until under target
-    while (totalTxSize > targetSize && !mapAncestorFee.empty()) {
-        // Get lowest fee-rate entry
-        auto it = mapAncestorFee.begin();
-        TxHash txid = it->get().GetTxHash();
-        
-        // Remove it and its descendants
-        std::set<TxHash> toRemove = GetDescendants(txid);
-        toRemove.insert(txid);
-        
-        for (const auto& hash : toRemove) {
-            auto removeIt = mapTx.find(hash);
-            if (removeIt != mapTx.end()) {
-                RemoveUnchecked(removeIt, MempoolRemovalReason::SIZELIMIT);
-            }
-        }
+    // Remove lowest-feerate chunks until under target. A cluster's worst
+    // chunk ends its linearization, so nothing left behind spends from it
+    while (DynamicMemoryUsageLocked() > targetSize && !clustersByWorstChunk.empty()) {
+        const MempoolCluster* cluster = *clustersByWorstChunk.begin();
+        stagedEntries.assign(cluster->txs.end() - cluster->WorstChunk().count, cluster->txs.end());
+        RemoveStaged(stagedEntries, MempoolRemovalReason::SIZELIMIT);
     }
 }
 
 void Mempool::ExpireOld(int64_t currentTime) {
-    std::vector<TxHash> expired;
-    
-    for (const auto& [txid, entry] : mapTx) {
-        if (currentTime - entry.GetTime() > limits.maxAge) {
-            expired.push_back(txid);
-        }
+    // Oldest first; a spender goes with the transaction it depends on
+    stagedEntries.clear();
+    for (auto it = entriesByTime.begin();
+         it != entriesByTime.end() && currentTime - it->first > limits.maxAge; ++it) {
+        stagedEntries.push_back(it->second);
     }
+    if (stagedEntries.empty()) return;
     
-    for (const auto& txid : expired) {
-        auto it = mapTx.find(txid);
-        if (it != mapTx.end()) {
-            RemoveUnchecked(it, MempoolRemovalReason::EXPIRY);
-        }
-    }
+    StageWithDescendants(stagedEntries);
+    RemoveStaged(stagedEntries, MempoolRemovalReason::EXPIRY);
 }
 
 // ============================================================================
@@ -928,117 +1212,325 @@ MempoolAcceptResult AcceptToMempool(
     int32_t chainHeight,
     bool bypassLimits) {
     
-    const Transaction& txRef = *tx;
-    TxHash txid = txRef.GetHash();
+    return AcceptPackage({tx}, mempool, coins, chainHeight, nullptr, bypassLimits).results[0];
+}
+
+PackageAcceptResult AcceptPackage(
+    const std::vector<TransactionRef>& package,
+    Mempool& mempool,
+    CoinsView& coins,
+    int32_t chainHeight,
+    CheckQueue* checkQueue,
+    bool bypassLimits,
+    const std::vector<int64_t>& entryTimes) {
     
-    // 1. Check if already in mempool
-    if (mempool.Exists(txid)) {
-        return MempoolAcceptResult::Invalid("txn-already-in-mempool");
-    }
+    const size_t n = package.size();
+    PackageAcceptResult out;
+    out.results.resize(n);
     
-    // 2. Basic transaction validation (context-free)
-    consensus::ValidationState state;
-    if (!consensus::CheckTransaction(txRef, state)) {
-        return MempoolAcceptResult::Invalid(state.GetRejectReason());
+    if (n > MAX_PACKAGE_COUNT) {
+        for (auto& result : out.results) {
+            result = MempoolAcceptResult::MempoolPolicy("package-too-many-transactions");
+        }
+        return out;
+    }
+    
+    // A rejected transaction takes its package descendants with it, except
+    // one that is already in the mempool, which its children spend as usual
+    std::vector<bool> rejected(n, false);
+    std::vector<bool> inMempool(n, false);
+    auto reject = [&](size_t i, MempoolAcceptResult result) {
+        out.results[i] = std::move(result);
+        rejected[i] = true;
+    };
+    
+    // 1. Index the package and link each transaction to its package parents
+    std::unordered_map<TxHash, size_t, Mempool::TxHasher> byHash;
+    for (size_t i = 0; i < n; ++i) {
+        if (!byHash.emplace(package[i]->GetHash(), i).second) {
+            reject(i, MempoolAcceptResult::Invalid("package-contains-duplicates"));
+        }
     }
     
-    // 3. Coinbase transactions cannot be in mempool
-    if (txRef.IsCoinBase()) {
-        return MempoolAcceptResult::Invalid("coinbase");
+    std::vector<std::vector<size_t>> parents(n);
+    std::vector<std::vector<size_t>> children(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (const auto& txin : package[i]->vin) {
+            auto it = byHash.find(TxHash(txin.prevout.hash));
+            if (it == byHash.end() || it->second == i ||
+                std::find(parents[i].begin(), parents[i].end(), it->second) != parents[i].end()) {
+                continue;
+            }
+            parents[i].push_back(it->second);
+            children[it->second].push_back(i);
+        }
     }
     
-    // 4. Create a view that includes mempool for unconfirmed chain validation
-    MempoolCoinsView mempoolView(&coins, mempool);
-    
-    // 5. Check all inputs exist
-    Amount inputValue = 0;
-    bool spendsCoinbase = false;
+    auto parentRejected = [&](size_t i) {
+        return std::any_of(parents[i].begin(), parents[i].end(),
+            [&](size_t parent) { return rejected[parent] && !inMempool[parent]; });
+    };
+    
+    // 2. Validate parents before children
+    std::vector<size_t> order;
+    std::vector<bool> placed(n, false);
+    order.reserve(n);
+    while (order.size() < n) {
+        for (size_t i = 0; i < n; ++i) {
+            if (!placed[i] && std::all_of(parents[i].begin(), parents[i].end(),
+                                          [&](size_t parent) { return placed[parent]; })) {
+                placed[i] = true;
+                order.push_back(i);
+            }
+        }
+    }
     
-    for (const auto& txin : txRef.vin) {
-        auto coin = mempoolView.GetCoin(txin.prevout);
-        if (!coin) {
-            return MempoolAcceptResult::Invalid("missing-inputs");
+    // 3. Context-free checks
+    for (size_t i : order) {
+        if (rejected[i]) continue;
+        const Transaction& tx = *package[i];
+        
+        // Check if already in mempool
+        if (mempool.Exists(tx.GetHash())) {
+            reject(i, MempoolAcceptResult::Invalid("txn-already-in-mempool"));
+            inMempool[i] = true;
+            continue;
         }
         
-        // Check coinbase maturity (100 blocks)
-        if (coin->IsCoinBase()) {
-            spendsCoinbase = true;
-            int32_t coinHeight = static_cast<int32_t>(coin->nHeight);
-            // Mempool coins have MEMPOOL_HEIGHT
-            if (coinHeight != static_cast<int32_t>(Mempool::MEMPOOL_HEIGHT)) {
-                int32_t nSpendDepth = chainHeight - coinHeight;
-                if (nSpendDepth < 100) {  // COINBASE_MATURITY
-                    return MempoolAcceptResult::Invalid("bad-txns-premature-spend-of-coinbase");
-                }
-            }
+        // Basic transaction validation
+        consensus::ValidationState state;
+        if (!consensus::CheckTransaction(tx, state)) {
+            reject(i, MempoolAcceptResult::Invalid(state.GetRejectReason()));
+            continue;
         }
         
-        inputValue += coin->GetAmount();
-    }
-    
-    // 6. Calculate output value and fee
-    Amount outputValue = 0;
-    for (const auto& txout : txRef.vout) {
-        outputValue += txout.nValue;
-    }
-    
-    if (inputValue < outputValue) {
-        return MempoolAcceptResult::Invalid("bad-txns-in-belowout");
+        // Coinbase transactions cannot be in mempool
+        if (tx.IsCoinBase()) {
+            reject(i, MempoolAcceptResult::Invalid("coinbase"));
+        }
     }
     
-    Amount fee = inputValue - outputValue;
-    
-    // 7. Check minimum fee rate (unless bypassing limits)
-    if (!bypassLimits) {
-        size_t txSize = txRef.GetTotalSize();
-        FeeRate txFeeRate(fee, txSize);
-        FeeRate minFee = mempool.GetMinFee();
+    // 4. Look up each input's coin once, from the package, the mempool or
+    // the UTXO set, and compute fees
+    MempoolCoinsView mempoolView(&coins, mempool);
+    std::vector<std::vector<Coin>> inputCoins(n);
+    std::vector<Amount> fees(n, 0);
+    std::vector<bool> spendsCoinbase(n, false);
+    std::unordered_set<OutPoint, OutPointHasher> packageSpends;
+    
+    auto checkInputs = [&](size_t i) -> bool {
+        const Transaction& tx = *package[i];
+        Amount inputValue = 0;
+        inputCoins[i].reserve(tx.vin.size());
         
-        if (txFeeRate < minFee) {
-            std::ostringstream ss;
-            ss << "min relay fee not met, " << txFeeRate.ToString() 
-               << " < " << minFee.ToString();
-            return MempoolAcceptResult::MempoolPolicy(ss.str());
+        for (const auto& txin : tx.vin) {
+            if (!packageSpends.insert(txin.prevout).second) {
+                reject(i, MempoolAcceptResult::Invalid("bad-txns-spends-conflicting-tx"));
+                return false;
+            }
+            
+            std::optional<Coin> coin;
+            auto parentIt = byHash.find(TxHash(txin.prevout.hash));
+            if (parentIt != byHash.end() && parentIt->second != i && !inMempool[parentIt->second]) {
+                const Transaction& parent = *package[parentIt->second];
+                if (txin.prevout.n < parent.vout.size()) {
+                    coin = Coin(parent.vout[txin.prevout.n], Mempool::MEMPOOL_HEIGHT, false);
+                }
+            } else {
+                coin = mempoolView.GetCoin(txin.prevout);
+            }
+            if (!coin) {
+                reject(i, MempoolAcceptResult::Invalid("missing-inputs"));
+                return false;
+            }
+            
+            // Check coinbase maturity (100 blocks)
+            if (coin->IsCoinBase()) {
+                spendsCoinbase[i] = true;
+                int32_t coinHeight = static_cast<int32_t>(coin->nHeight);
+                // Mempool coins have MEMPOOL_HEIGHT
+                if (coinHeight != static_cast<int32_t>(Mempool::MEMPOOL_HEIGHT)) {
+                    int32_t nSpendDepth = chainHeight - coinHeight;
+                    if (nSpendDepth < 100) {  // COINBASE_MATURITY
+                        reject(i, MempoolAcceptResult::Invalid("bad-txns-premature-spend-of-coinbase"));
+                        return false;
+                    }
+                }
+            }
+            
+            inputValue += coin->GetAmount();
+            inputCoins[i].push_back(std::move(*coin));
         }
-    }
+        
+        // Calculate output value and fee
+        Amount outputValue = 0;
+        for (const auto& txout : tx.vout) {
+            outputValue += txout.nValue;
+        }
+        
+        if (inputValue < outputValue) {
+            reject(i, MempoolAcceptResult::Invalid("bad-txns-in-belowout"));
+            return false;
+        }
+        
+        fees[i] = inputValue - outputValue;
+        return true;
+    };
+    
+    for (size_t i : order) {
+        if (rejected[i]) continue;
+        if (parentRejected(i)) {
+            reject(i, MempoolAcceptResult::Invalid("missing-inputs"));
+            continue;
+        }
+        checkInputs(i);
+    }
+    
+    // 5. Check minimum fee rate. A transaction is judged together with the
+    // package descendants it makes valid; rerun until no more are rejected,
+    // since a rejection lowers its ancestors' package feerate
+    FeeRate minFee = mempool.GetMinFee();
+    std::vector<FeeRate> feeRates(n);
+    auto applyFeeFloor = [&]() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i : order) {
+                if (rejected[i]) continue;
+                if (parentRejected(i)) {
+                    reject(i, MempoolAcceptResult::Invalid("missing-inputs"));
+                    changed = true;
+                    continue;
+                }
+                
+                Amount fee = 0;
+                size_t size = 0;
+                std::vector<bool> seen(n, false);
+                std::vector<size_t> stack{i};
+                seen[i] = true;
+                while (!stack.empty()) {
+                    size_t j = stack.back();
+                    stack.pop_back();
+                    fee += fees[j];
+                    size += package[j]->GetTotalSize();
+                    for (size_t child : children[j]) {
+                        if (!seen[child] && !rejected[child]) {
+                            seen[child] = true;
+                            stack.push_back(child);
+                        }
+                    }
+                }
+                
+                // A child with parents in the package needs them to pay too,
+                // so it cannot count for more than its own feerate
+                FeeRate ownRate(fees[i], package[i]->GetTotalSize());
+                FeeRate packageRate(fee, size);
+                feeRates[i] = std::max(ownRate, packageRate);
+                if (!bypassLimits && feeRates[i] < minFee) {
+                    std::ostringstream ss;
+                    ss << "min relay fee not met, " << feeRates[i].ToString()
+                       << " < " << minFee.ToString();
+                    reject(i, MempoolAcceptResult::MempoolPolicy(ss.str()));
+                    changed = true;
+                }
+            }
+        }
+    };
+    applyFeeFloor();
     
-    // 8. Verify scripts
+    // 6. Verify scripts of the whole package in one batch
     // Use standard script verification flags
     ScriptFlags flags = ScriptFlags::VERIFY_P2SH | 
                         ScriptFlags::VERIFY_STRICTENC |
                         ScriptFlags::VERIFY_LOW_S;
+    SignatureCache& sigCache = GetSignatureCache();
+    
+    // Hashing state shared by each transaction's checks; reserved up front
+    // so the checks' pointers stay valid
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(n);
+    std::vector<const PrecomputedTransactionData*> txdataOf(n, nullptr);
+    
+    // Verified signatures are remembered so block validation can skip them
+    auto makeCheck = [&](size_t i, size_t k) {
+        return ScriptCheck(inputCoins[i][k], *package[i], static_cast<unsigned int>(k), flags,
+                           txdataOf[i], &sigCache, true);
+    };
+    
+    bool scriptsOk;
+    {
+        CheckQueueControl control(checkQueue);
+        for (size_t i : order) {
+            if (rejected[i]) continue;
+            txdataOf[i] = &txdata.emplace_back(*package[i]);
+            std::vector<ScriptCheck> checks;
+            checks.reserve(inputCoins[i].size());
+            for (size_t k = 0; k < inputCoins[i].size(); ++k) {
+                checks.push_back(makeCheck(i, k));
+            }
+            control.Add(std::move(checks));
+        }
+        scriptsOk = control.Wait();
+    }
     
-    for (size_t i = 0; i < txRef.vin.size(); ++i) {
-        const auto& txin = txRef.vin[i];
-        auto coin = mempoolView.GetCoin(txin.prevout);
-        if (!coin) {
-            // Should not happen - we checked above
-            return MempoolAcceptResult::Invalid("missing-inputs");
+    if (!scriptsOk) {
+        // The batch stops at its first failure; find every failing
+        // transaction. Inputs that passed are in the signature cache now.
+        for (size_t i : order) {
+            if (rejected[i]) continue;
+            if (parentRejected(i)) {
+                reject(i, MempoolAcceptResult::Invalid("missing-inputs"));
+                continue;
+            }
+            for (size_t k = 0; k < inputCoins[i].size(); ++k) {
+                ScriptCheck check = makeCheck(i, k);
+                if (!check()) {
+                    std::string errMsg = "mandatory-script-verify-flag-failed (";
+                    errMsg += ScriptErrorString(check.GetError());
+                    errMsg += ")";
+                    reject(i, MempoolAcceptResult::Invalid(errMsg));
+                    break;
+                }
+            }
         }
         
-        // Create signature checker for this input
-        TransactionSignatureChecker checker(&txRef, static_cast<unsigned int>(i), coin->GetAmount());
-        
-        ScriptError error;
-        if (!VerifyScript(txin.scriptSig, coin->GetScriptPubKey(), flags, checker, &error)) {
-            std::string errMsg = "mandatory-script-verify-flag-failed (";
-            errMsg += ScriptErrorString(error);
-            errMsg += ")";
-            return MempoolAcceptResult::Invalid(errMsg);
+        // A rejected child no longer pays for its parents
+        applyFeeFloor();
+    }
+    
+    // Every block flag is also enforced above, so the scripts are valid under
+    // the flags block validation uses and a block including these transactions
+    // need not run them again
+    ScriptExecutionCache& scriptCache = GetScriptExecutionCache();
+    ScriptFlags blockFlags = scriptCache.GetActiveFlags();
+    bool cacheable = (flags & blockFlags) == blockFlags;
+    
+    // 7. Add to mempool, under a single lock
+    // RBF handling is done in AddTx according to BIP 125 rules
+    std::vector<MempoolPackageEntry> entries;
+    std::vector<size_t> entryIndex;
+    for (size_t i : order) {
+        if (rejected[i]) continue;
+        if (cacheable) {
+            scriptCache.Insert(scriptCache.ComputeEntry(package[i]->GetHash(), blockFlags));
+        }
+        entries.push_back({package[i], fees[i], spendsCoinbase[i], feeRates[i],
+                           i < entryTimes.size() ? entryTimes[i] : 0});
+        entryIndex.push_back(i);
+    }
+    
+    std::vector<std::string> errors = mempool.AddPackage(entries, static_cast<uint32_t>(chainHeight));
+    for (size_t j = 0; j < entries.size(); ++j) {
+        size_t i = entryIndex[j];
+        if (errors[j].empty()) {
+            out.results[i] = MempoolAcceptResult::Success(package[i]->GetHash(), fees[i]);
+            ++out.accepted;
+        } else {
+            out.results[i] = MempoolAcceptResult::MempoolPolicy(errors[j]);
         }
     }
     
-    // 9. RBF handling is done in AddTx - no pre-check needed here
-    // The mempool's AddTx will handle conflicts according to BIP 125 RBF rules
-    
-    // 10. Add to mempool
-    std::string errString;
-    if (!mempool.AddTx(tx, fee, static_cast<uint32_t>(chainHeight), spendsCoinbase, errString)) {
-        return MempoolAcceptResult::MempoolPolicy(errString);
-    }
-    
-    // Success!
-    return MempoolAcceptResult::Success(txid, fee);
+    return out;
 }
 
 } // namespace shurium
@@ -0,0 +1,189 @@
+// SHURIUM - Orphan Transaction Pool Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/mempool/orphans.h"
+#include "shurium/core/random.h"
+#include <algorithm>
+
+namespace shurium {
+
+OrphanPool::OrphanPool(size_t maxOrphansIn, size_t maxPerPeerIn)
+    : maxOrphans(std::max<size_t>(1, maxOrphansIn))
+    , maxPerPeer(std::max<size_t>(1, maxPerPeerIn)) {
+}
+
+// ============================================================================
+// Adding and Removing
+// ============================================================================
+
+bool OrphanPool::AddTx(const TransactionRef& tx, PeerId fromPeer, int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // A large orphan could be used to fill memory cheaply
+    const TxHash& txid = tx->GetHash();
+    if (tx->GetTotalSize() > MAX_ORPHAN_TX_SIZE || orphans.count(txid) > 0) {
+        return false;
+    }
+
+    // The pool is small, so a full scan for expired orphans is cheap
+    EraseExpiredLocked(now);
+
+    // Make room: the sender's oldest orphan first, then anyone's at random
+    auto peerIt = byPeer.find(fromPeer);
+    if (peerIt != byPeer.end() && peerIt->second.size() >= maxPerPeer) {
+        EraseLocked(orphans.find(peerIt->second.begin()->second));
+    }
+    while (orphans.size() >= maxOrphans) {
+        const TxHash& victim = randomOrder[GetRandInt(randomOrder.size())];
+        EraseLocked(orphans.find(victim));
+    }
+
+    uint64_t sequence = nextSequence++;
+    orphans.emplace(txid, Entry{tx, fromPeer, now + ORPHAN_EXPIRE_TIME, sequence,
+                                randomOrder.size()});
+    randomOrder.push_back(txid);
+    for (const auto& txin : tx->vin) {
+        byPrevout[txin.prevout].insert(txid);
+    }
+    byPeer[fromPeer].emplace(sequence, txid);
+    return true;
+}
+
+void OrphanPool::EraseLocked(EntryMap::iterator it) {
+    const Entry& entry = it->second;
+    for (const auto& txin : entry.tx->vin) {
+        auto prevIt = byPrevout.find(txin.prevout);
+        if (prevIt == byPrevout.end()) continue;
+        prevIt->second.erase(it->first);
+        if (prevIt->second.empty()) {
+            byPrevout.erase(prevIt);
+        }
+    }
+
+    auto peerIt = byPeer.find(entry.fromPeer);
+    peerIt->second.erase(entry.sequence);
+    if (peerIt->second.empty()) {
+        byPeer.erase(peerIt);
+    }
+
+    // Move the last txid into the freed slot
+    size_t pos = entry.listPos;
+    if (pos + 1 != randomOrder.size()) {
+        randomOrder[pos] = randomOrder.back();
+        orphans.find(randomOrder[pos])->second.listPos = pos;
+    }
+    randomOrder.pop_back();
+
+    orphans.erase(it);
+}
+
+bool OrphanPool::EraseTx(const TxHash& txid) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = orphans.find(txid);
+    if (it == orphans.end()) {
+        return false;
+    }
+    EraseLocked(it);
+    return true;
+}
+
+size_t OrphanPool::EraseForPeer(PeerId peer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto peerIt = byPeer.find(peer);
+    if (peerIt == byPeer.end()) {
+        return 0;
+    }
+    std::vector<TxHash> txids;
+    for (const auto& [sequence, txid] : peerIt->second) {
+        txids.push_back(txid);
+    }
+    for (const TxHash& txid : txids) {
+        EraseLocked(orphans.find(txid));
+    }
+    return txids.size();
+}
+
+size_t OrphanPool::EraseForBlock(const std::vector<TransactionRef>& vtx) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // An orphan spending an input the block spent is mined or conflicted
+    std::set<TxHash> erase;
+    for (const auto& tx : vtx) {
+        for (const auto& txin : tx->vin) {
+            auto prevIt = byPrevout.find(txin.prevout);
+            if (prevIt != byPrevout.end()) {
+                erase.insert(prevIt->second.begin(), prevIt->second.end());
+            }
+        }
+    }
+    for (const TxHash& txid : erase) {
+        EraseLocked(orphans.find(txid));
+    }
+    return erase.size();
+}
+
+size_t OrphanPool::EraseExpiredLocked(int64_t now) {
+    std::vector<TxHash> expired;
+    for (const auto& [txid, entry] : orphans) {
+        if (entry.expireTime <= now) {
+            expired.push_back(txid);
+        }
+    }
+    for (const TxHash& txid : expired) {
+        EraseLocked(orphans.find(txid));
+    }
+    return expired.size();
+}
+
+size_t OrphanPool::EraseExpired(int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return EraseExpiredLocked(now);
+}
+
+// ============================================================================
+// Resolution
+// ============================================================================
+
+std::vector<OrphanPool::Orphan> OrphanPool::TakeChildren(const Transaction& parent) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<std::pair<uint64_t, TxHash>> children;
+    const TxHash& parentHash = parent.GetHash();
+    for (uint32_t n = 0; n < parent.vout.size(); ++n) {
+        auto prevIt = byPrevout.find(OutPoint(parentHash, n));
+        if (prevIt == byPrevout.end()) continue;
+        for (const TxHash& txid : prevIt->second) {
+            children.emplace_back(orphans.find(txid)->second.sequence, txid);
+        }
+    }
+    std::sort(children.begin(), children.end());
+    children.erase(std::unique(children.begin(), children.end()), children.end());
+
+    std::vector<Orphan> result;
+    result.reserve(children.size());
+    for (const auto& [sequence, txid] : children) {
+        auto it = orphans.find(txid);
+        result.push_back({it->second.tx, it->second.fromPeer});
+        EraseLocked(it);
+    }
+    return result;
+}
+
+size_t OrphanPool::Size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return orphans.size();
+}
+
+size_t OrphanPool::CountForPeer(PeerId peer) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto peerIt = byPeer.find(peer);
+    return peerIt == byPeer.end() ? 0 : peerIt->second.size();
+}
+
+bool OrphanPool::HaveTx(const TxHash& txid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return orphans.count(txid) > 0;
+}
+
+} // namespace shurium
@@ -0,0 +1,228 @@
+// SHURIUM - Mempool Persistence Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/mempool/persist.h"
+#include "shurium/mempool/mempool.h"
+#include "shurium/core/serialize.h"
+#include "shurium/util/logging.h"
+#include "shurium/util/time.h"
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace shurium {
+
+namespace {
+
+/// File magic
+constexpr uint8_t MEMPOOL_MAGIC[4] = {'s', 'm', 'p', 'l'};
+
+/// Bytes buffered before a write
+constexpr size_t WRITE_BUFFER_BYTES = 1024 * 1024;
+
+bool WriteStream(std::ofstream& file, DataStream& ss) {
+    file.write(reinterpret_cast<const char*>(ss.data()),
+               static_cast<std::streamsize>(ss.size()));
+    ss.clear();
+    return file.good();
+}
+
+/// Read exactly len bytes from the file into a stream
+bool ReadStream(std::ifstream& file, size_t len, DataStream& ss) {
+    std::vector<uint8_t> buffer(len);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(len));
+    if (static_cast<size_t>(file.gcount()) != len) {
+        return false;
+    }
+    ss = DataStream(std::move(buffer));
+    return true;
+}
+
+bool WriteRecords(std::ofstream& file, const std::vector<TxMempoolChunk>& chunks, uint64_t count) {
+    DataStream buffer;
+    buffer.Write(MEMPOOL_MAGIC, sizeof(MEMPOOL_MAGIC));
+    Serialize(buffer, MEMPOOL_DUMP_VERSION);
+    Serialize(buffer, count);
+    
+    DataStream record;
+    for (const auto& chunk : chunks) {
+        for (const auto& info : chunk.txs) {
+            record.clear();
+            Serialize(record, *info.tx);
+            Serialize(record, info.time);
+            Serialize(record, info.feeDelta);
+            
+            Serialize(buffer, static_cast<uint32_t>(record.size()));
+            buffer.Write(record.data(), record.size());
+            if (buffer.size() >= WRITE_BUFFER_BYTES && !WriteStream(file, buffer)) {
+                return false;
+            }
+        }
+    }
+    return WriteStream(file, buffer);
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Dump
+// ============================================================================
+
+MempoolPersistResult DumpMempool(const Mempool& mempool, const std::filesystem::path& path) {
+    // Chunk order puts parents first, so loading never sees a child early
+    std::vector<TxMempoolChunk> chunks = mempool.GetChunksForMining();
+    
+    MempoolPersistResult result;
+    for (const auto& chunk : chunks) {
+        result.count += chunk.txs.size();
+    }
+    
+    // Saves from the node and from RPC would share the temporary file
+    static std::mutex dumpMutex;
+    std::lock_guard<std::mutex> lock(dumpMutex);
+    
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".new";
+    std::error_code ec;
+    bool ok = false;
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return MempoolPersistResult::Error("Cannot create " + tmpPath.string());
+        }
+        ok = WriteRecords(file, chunks, result.count);
+        file.flush();
+        ok = ok && file.good();
+    }
+    
+    if (!ok) {
+        std::filesystem::remove(tmpPath, ec);
+        return MempoolPersistResult::Error("Failed writing " + tmpPath.string());
+    }
+    
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return MempoolPersistResult::Error("Cannot rename mempool file to " + path.string());
+    }
+    
+    LOG_INFO(util::LogCategory::MEMPOOL) << "Wrote " << result.count
+                                         << " mempool transactions to " << path.string();
+    result.success = true;
+    return result;
+}
+
+// ============================================================================
+// Load
+// ============================================================================
+
+MempoolPersistResult LoadMempool(const std::filesystem::path& path, Mempool& mempool,
+                                 CoinsView& coins, int32_t chainHeight,
+                                 CheckQueue* checkQueue,
+                                 const std::atomic<bool>* interrupt) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return MempoolPersistResult::Error("Cannot open " + path.string());
+    }
+    
+    uint64_t count = 0;
+    {
+        DataStream header;
+        if (!ReadStream(file, sizeof(MEMPOOL_MAGIC) + sizeof(uint16_t) + sizeof(uint64_t), header) ||
+            std::memcmp(header.data(), MEMPOOL_MAGIC, sizeof(MEMPOOL_MAGIC)) != 0) {
+            return MempoolPersistResult::Error(path.string() + " is not a mempool file");
+        }
+        uint8_t magic[sizeof(MEMPOOL_MAGIC)];
+        header.Read(magic, sizeof(magic));
+        uint16_t version = 0;
+        Unserialize(header, version);
+        if (version != MEMPOOL_DUMP_VERSION) {
+            return MempoolPersistResult::Error("Unsupported mempool file version " +
+                                               std::to_string(version));
+        }
+        Unserialize(header, count);
+    }
+    
+    MempoolPersistResult result;
+    const int64_t now = GetTime();
+    const int64_t maxAge = mempool.GetLimits().maxAge;
+    
+    std::vector<TransactionRef> batch;
+    std::vector<int64_t> entryTimes;
+    auto acceptBatch = [&]() {
+        if (batch.empty()) return;
+        PackageAcceptResult accepted = AcceptPackage(batch, mempool, coins, chainHeight,
+                                                     checkQueue, false, entryTimes);
+        for (const auto& txResult : accepted.results) {
+            if (txResult.IsValid()) {
+                ++result.accepted;
+            } else if (txResult.rejectReason == "txn-already-in-mempool") {
+                ++result.alreadyPresent;
+            } else {
+                ++result.failed;
+            }
+        }
+        batch.clear();
+        entryTimes.clear();
+    };
+    
+    for (uint64_t i = 0; i < count; ++i) {
+        if (interrupt && interrupt->load()) {
+            acceptBatch();
+            result.error = "Interrupted after " + std::to_string(result.count) + " transactions";
+            return result;
+        }
+        
+        DataStream record;
+        uint32_t size = 0;
+        DataStream sizeStream;
+        if (!ReadStream(file, sizeof(size), sizeStream)) {
+            acceptBatch();
+            result.error = "Truncated mempool file at record " + std::to_string(i);
+            return result;
+        }
+        Unserialize(sizeStream, size);
+        if (size > MAX_MEMPOOL_DUMP_RECORD_BYTES || !ReadStream(file, size, record)) {
+            acceptBatch();
+            result.error = "Bad mempool file record " + std::to_string(i);
+            return result;
+        }
+        
+        MutableTransaction mtx;
+        int64_t time = 0;
+        int64_t feeDelta = 0;
+        try {
+            Unserialize(record, mtx);
+            Unserialize(record, time);
+            Unserialize(record, feeDelta);
+        } catch (const std::exception&) {
+            acceptBatch();
+            result.error = "Malformed mempool file record " + std::to_string(i);
+            return result;
+        }
+        ++result.count;
+        
+        if (now - time > maxAge) {
+            ++result.expired;
+            continue;
+        }
+        
+        batch.push_back(MakeTransactionRef(std::move(mtx)));
+        entryTimes.push_back(time);
+        if (batch.size() == MAX_PACKAGE_COUNT) {
+            acceptBatch();
+        }
+    }
+    acceptBatch();
+    
+    LOG_INFO(util::LogCategory::MEMPOOL) << "Loaded " << result.accepted << " of " << result.count
+                                         << " saved mempool transactions (" << result.expired
+                                         << " expired, " << result.failed << " rejected, "
+                                         << result.alreadyPresent << " already present)";
+    result.success = true;
+    return result;
+}
+
+} // namespace shurium
@@ -0,0 +1,67 @@
+// SHURIUM - Mining Backends Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/miner/backend.h"
+#include "shurium/miner/miner.h"
+
+#include <algorithm>
+
+namespace shurium {
+namespace miner {
+
+namespace {
+
+/// Nonces hashed per call, the widest multi-way kernel
+constexpr uint32_t NONCE_BATCH = 16;
+
+} // anonymous namespace
+
+// ============================================================================
+// CPU Backend
+// ============================================================================
+
+bool CPUMiningBackend::Search(const SHA256Midstate& mid, const Byte* tail,
+                              const Hash256& target, uint32_t firstNonce, uint32_t count,
+                              std::vector<uint32_t>& candidates) {
+    Byte hashes[32 * NONCE_BATCH];
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t n = std::min(NONCE_BATCH, count - done);
+        DoubleSHA256_80_Nonces(hashes, mid, tail, firstNonce + done, n);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (Miner::MeetsTarget(Hash256(hashes + 32 * i, 32), target)) {
+                candidates.push_back(firstNonce + done + i);
+            }
+        }
+        done += n;
+    }
+    return true;
+}
+
+// ============================================================================
+// Backend Selection
+// ============================================================================
+
+std::vector<std::string> GetMiningBackendNames() {
+    std::vector<std::string> names{"cpu"};
+#ifdef SHURIUM_OPENCL_MINING
+    names.push_back("opencl");
+#endif
+    return names;
+}
+
+std::unique_ptr<MiningBackend> CreateMiningBackend(const std::string& name, std::string& error) {
+    if (name == "cpu") {
+        return std::make_unique<CPUMiningBackend>();
+    }
+#ifdef SHURIUM_OPENCL_MINING
+    if (name == "opencl") {
+        return CreateOpenCLMiningBackend(error);
+    }
+#endif
+    error = "unknown mining backend '" + name + "'";
+    return nullptr;
+}
+
+} // namespace miner
+} // namespace shurium
@@ -0,0 +1,285 @@
+// SHURIUM - OpenCL Mining Backend
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Reference GPU backend: one work item per nonce, each finishing the first
+// hash from the midstate and running the second. Built only with
+// -DSHURIUM_OPENCL_MINING=ON.
+
+#include "shurium/miner/backend.h"
+
+#define CL_TARGET_OPENCL_VERSION 120
+#ifdef __APPLE__
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace miner {
+
+namespace {
+
+/// Nonces per kernel launch; a few milliseconds on a current GPU
+constexpr uint32_t OPENCL_BATCH = 1u << 22;
+
+/// Candidates one launch can report; further ones are dropped
+constexpr cl_uint OPENCL_MAX_CANDIDATES = 64;
+
+/**
+ * The message words of the header's last block are the tail's three words,
+ * the nonce and SHA-256 padding for 80 bytes; the second hash pads the
+ * 32-byte digest. A hash's top 32 bits as a little-endian number are its
+ * last word byte-swapped, and only those are compared to the target here.
+ */
+const char* OPENCL_SEARCH_KERNEL = R"CL(
+#define ROTR(x, n) rotate((x), (uint)(32 - (n)))
+#define BSWAP(x) (rotate((x) & 0x00ff00ffU, 24U) | rotate((x) & 0xff00ff00U, 8U))
+
+__constant uint K[64] = {
+    0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU, 0x59f111f1U, 0x923f82a4U, 0xab1c5ed5U,
+    0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU, 0x9bdc06a7U, 0xc19bf174U,
+    0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU, 0x2de92c6fU, 0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU,
+    0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U, 0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U,
+    0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU, 0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U,
+    0xa2bfe8a1U, 0xa81a664bU, 0xc24b8b70U, 0xc76c51a3U, 0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U,
+    0x19a4c116U, 0x1e376c08U, 0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+    0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U, 0x90befffaU, 0xa4506cebU, 0xbef9a3f7U, 0xc67178f2U
+};
+
+static void sha256_compress(uint* s, const uint* in) {
+    uint w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = in[i];
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint a = s[0], b = s[1], c = s[2], d = s[3];
+    uint e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int i = 0; i < 64; ++i) {
+        uint t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + (g ^ (e & (f ^ g))) + K[i] + w[i];
+        uint t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) | (c & (a | b)));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+}
+
+__kernel void shurium_search(__constant uint* mid, uint tail0, uint tail1, uint tail2,
+                             uint firstNonce, uint targetTop,
+                             __global uint* out, uint maxOut) {
+    uint nonce = firstNonce + (uint)get_global_id(0);
+
+    uint w[16];
+    w[0] = tail0; w[1] = tail1; w[2] = tail2; w[3] = BSWAP(nonce);
+    w[4] = 0x80000000U;
+    for (int i = 5; i < 15; ++i) {
+        w[i] = 0;
+    }
+    w[15] = 640;
+
+    uint s[8];
+    for (int i = 0; i < 8; ++i) {
+        s[i] = mid[i];
+    }
+    sha256_compress(s, w);
+
+    for (int i = 0; i < 8; ++i) {
+        w[i] = s[i];
+    }
+    w[8] = 0x80000000U;
+    for (int i = 9; i < 15; ++i) {
+        w[i] = 0;
+    }
+    w[15] = 256;
+
+    uint h[8] = {0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU,
+                 0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U};
+    sha256_compress(h, w);
+
+    if (BSWAP(h[7]) <= targetTop) {
+        uint slot = atomic_inc(&out[0]);
+        if (slot < maxOut) {
+            out[1 + slot] = nonce;
+        }
+    }
+}
+)CL";
+
+uint32_t ReadBE32(const Byte* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+std::string CLError(const char* what, cl_int err) {
+    return std::string(what) + " failed (OpenCL error " + std::to_string(err) + ")";
+}
+
+// ============================================================================
+// OpenCL Backend
+// ============================================================================
+
+class OpenCLMiningBackend : public MiningBackend {
+public:
+    ~OpenCLMiningBackend() override {
+        if (outBuffer_) clReleaseMemObject(outBuffer_);
+        if (midBuffer_) clReleaseMemObject(midBuffer_);
+        if (kernel_) clReleaseKernel(kernel_);
+        if (program_) clReleaseProgram(program_);
+        if (queue_) clReleaseCommandQueue(queue_);
+        if (context_) clReleaseContext(context_);
+    }
+
+    const char* GetName() const override { return "opencl"; }
+    uint32_t GetBatchSize() const override { return OPENCL_BATCH; }
+
+    bool Init(std::string& error) {
+        cl_uint platformCount = 0;
+        if (clGetPlatformIDs(0, nullptr, &platformCount) != CL_SUCCESS || platformCount == 0) {
+            error = "no OpenCL platform found";
+            return false;
+        }
+        std::vector<cl_platform_id> platforms(platformCount);
+        clGetPlatformIDs(platformCount, platforms.data(), nullptr);
+
+        // Prefer a GPU on any platform, then whatever device there is
+        cl_device_id device = nullptr;
+        for (cl_device_type type : {cl_device_type(CL_DEVICE_TYPE_GPU),
+                                    cl_device_type(CL_DEVICE_TYPE_ALL)}) {
+            for (cl_platform_id platform : platforms) {
+                if (clGetDeviceIDs(platform, type, 1, &device, nullptr) == CL_SUCCESS) {
+                    break;
+                }
+                device = nullptr;
+            }
+            if (device) {
+                break;
+            }
+        }
+        if (!device) {
+            error = "no OpenCL device found";
+            return false;
+        }
+
+        cl_int err = CL_SUCCESS;
+        context_ = clCreateContext(nullptr, 1, &device, nullptr, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            error = CLError("clCreateContext", err);
+            return false;
+        }
+        queue_ = clCreateCommandQueue(context_, device, 0, &err);
+        if (err != CL_SUCCESS) {
+            error = CLError("clCreateCommandQueue", err);
+            return false;
+        }
+
+        program_ = clCreateProgramWithSource(context_, 1, &OPENCL_SEARCH_KERNEL, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            error = CLError("clCreateProgramWithSource", err);
+            return false;
+        }
+        err = clBuildProgram(program_, 1, &device, "", nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            size_t logSize = 0;
+            clGetProgramBuildInfo(program_, device, CL_PROGRAM_BUILD_LOG, 0, nullptr, &logSize);
+            std::string log(logSize, '\0');
+            clGetProgramBuildInfo(program_, device, CL_PROGRAM_BUILD_LOG, logSize, &log[0], nullptr);
+            error = CLError("clBuildProgram", err) + ": " + log;
+            return false;
+        }
+        kernel_ = clCreateKernel(program_, "shurium_search", &err);
+        if (err != CL_SUCCESS) {
+            error = CLError("clCreateKernel", err);
+            return false;
+        }
+
+        midBuffer_ = clCreateBuffer(context_, CL_MEM_READ_ONLY, sizeof(SHA256Midstate::state),
+                                    nullptr, &err);
+        if (err != CL_SUCCESS) {
+            error = CLError("clCreateBuffer", err);
+            return false;
+        }
+        outBuffer_ = clCreateBuffer(context_, CL_MEM_READ_WRITE,
+                                    sizeof(cl_uint) * (1 + OPENCL_MAX_CANDIDATES), nullptr, &err);
+        if (err != CL_SUCCESS) {
+            error = CLError("clCreateBuffer", err);
+            return false;
+        }
+        return true;
+    }
+
+    bool Search(const SHA256Midstate& mid, const Byte* tail, const Hash256& target,
+                uint32_t firstNonce, uint32_t count,
+                std::vector<uint32_t>& candidates) override {
+        if (count == 0) {
+            return true;
+        }
+
+        cl_uint args[5] = {ReadBE32(tail), ReadBE32(tail + 4), ReadBE32(tail + 8), firstNonce,
+                           (static_cast<cl_uint>(target[31]) << 24) |
+                           (static_cast<cl_uint>(target[30]) << 16) |
+                           (static_cast<cl_uint>(target[29]) << 8) |
+                           static_cast<cl_uint>(target[28])};
+        cl_uint zero = 0;
+        cl_uint maxOut = OPENCL_MAX_CANDIDATES;
+
+        cl_int err = clEnqueueWriteBuffer(queue_, midBuffer_, CL_TRUE, 0, sizeof(mid.state),
+                                          mid.state, 0, nullptr, nullptr);
+        err |= clEnqueueWriteBuffer(queue_, outBuffer_, CL_TRUE, 0, sizeof(zero), &zero,
+                                    0, nullptr, nullptr);
+        err |= clSetKernelArg(kernel_, 0, sizeof(cl_mem), &midBuffer_);
+        for (cl_uint i = 0; i < 5; ++i) {
+            err |= clSetKernelArg(kernel_, 1 + i, sizeof(cl_uint), &args[i]);
+        }
+        err |= clSetKernelArg(kernel_, 6, sizeof(cl_mem), &outBuffer_);
+        err |= clSetKernelArg(kernel_, 7, sizeof(cl_uint), &maxOut);
+        if (err != CL_SUCCESS) {
+            return false;
+        }
+
+        size_t globalSize = count;
+        if (clEnqueueNDRangeKernel(queue_, kernel_, 1, nullptr, &globalSize, nullptr,
+                                   0, nullptr, nullptr) != CL_SUCCESS) {
+            return false;
+        }
+
+        std::vector<cl_uint> out(1 + OPENCL_MAX_CANDIDATES);
+        if (clEnqueueReadBuffer(queue_, outBuffer_, CL_TRUE, 0, sizeof(cl_uint) * out.size(),
+                                out.data(), 0, nullptr, nullptr) != CL_SUCCESS) {
+            return false;
+        }
+        cl_uint found = std::min(out[0], OPENCL_MAX_CANDIDATES);
+        candidates.insert(candidates.end(), out.begin() + 1, out.begin() + 1 + found);
+        return true;
+    }
+
+private:
+    cl_context context_{nullptr};
+    cl_command_queue queue_{nullptr};
+    cl_program program_{nullptr};
+    cl_kernel kernel_{nullptr};
+    cl_mem midBuffer_{nullptr};
+    cl_mem outBuffer_{nullptr};
+};
+
+} // anonymous namespace
+
+std::unique_ptr<MiningBackend> CreateOpenCLMiningBackend(std::string& error) {
+    auto backend = std::make_unique<OpenCLMiningBackend>();
+    if (!backend->Init(error)) {
+        return nullptr;
+    }
+    return backend;
+}
+
+} // namespace miner
+} // namespace shurium
@@ -5,12 +5,14 @@
 #include "shurium/miner/blockassembler.h"
 #include "shurium/consensus/params.h"
 #include "shurium/chain/blockindex.h"
+#include "shurium/core/merkle.h"
 #include "shurium/core/serialize.h"
 #include "shurium/script/interpreter.h"
 #include "shurium/economics/funds.h"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <unordered_set>
 
 namespace shurium {
 namespace miner {
@@ -97,41 +99,48 @@ BlockTemplate BlockAssembler::CreateNewBlock(const Hash160& coinbaseDest) {
 }
 
 void BlockAssembler::AddTransactionsFromMempool() {
-    // Get transactions sorted by fee rate
-    std::vector<TxMempoolInfo> mempoolTxs = m_mempool.GetAllTxInfo();
-    
-    // Sort by fee rate (highest first)
-    std::sort(mempoolTxs.begin(), mempoolTxs.end(),
-              [](const TxMempoolInfo& a, const TxMempoolInfo& b) {
-                  // Compare fee rates (fee / vsize)
-                  return (a.fee * b.vsize) > (b.fee * a.vsize);
-              });
-    
-    // Add transactions greedily by fee rate
-    for (const auto& txInfo : mempoolTxs) {
-        if (!txInfo.tx) continue;
-        
-        // Count sigops accurately for each output script
-        // This counts OP_CHECKSIG, OP_CHECKSIGVERIFY, and multisig operations
-        size_t sigops = 0;
-        for (const auto& txout : txInfo.tx->vout) {
-            sigops += txout.scriptPubKey.GetSigOpCount(false);  // Non-accurate count for raw script
-        }
-        // For P2SH, accurate counting requires the input scripts to be evaluated
-        // We use a conservative estimate: max 15 sigops per P2SH input (standard multisig limit)
-        for (const auto& txin : txInfo.tx->vin) {
-            // Check if this is spending a P2SH output (scriptSig contains data pushes)
-            // Use accurate counting if we have the scriptSig
-            sigops += txin.scriptSig.GetSigOpCount(true);
+    // Get chunks of the mempool's cluster linearizations, best feerate first
+    std::vector<TxMempoolChunk> chunks = m_mempool.GetChunksForMining();
+    
+    // Clusters with a transaction left out; their later chunks may spend it
+    std::unordered_set<uint64_t> skippedClusters;
+    
+    // Add chunks greedily by feerate. Children that pay for their parents
+    // share a chunk with them, so the fee floor applies to the chunk
+    for (const auto& chunk : chunks) {
+        if (chunk.feeRate < m_options.minFeeRate) {
+            break;
         }
-        
-        // Check if we can add this transaction
-        if (!CanAddTransaction(*txInfo.tx, txInfo.fee)) {
+        if (skippedClusters.count(chunk.cluster)) {
             continue;
         }
         
-        // Add to block
-        AddTransaction(txInfo.tx, txInfo.fee, sigops);
+        for (const auto& txInfo : chunk.txs) {
+            if (!txInfo.tx) continue;
+            
+            // Check if we can add this transaction
+            if (!CanAddTransaction(*txInfo.tx)) {
+                skippedClusters.insert(chunk.cluster);
+                break;
+            }
+            
+            // Count sigops accurately for each output script
+            // This counts OP_CHECKSIG, OP_CHECKSIGVERIFY, and multisig operations
+            size_t sigops = 0;
+            for (size_t i = 0; i < txInfo.tx->vout.size(); ++i) {
+                sigops += txInfo.tx->GetDecodedScriptPubKey(i).GetSigOpCount(false);  // Non-accurate count for raw script
+            }
+            // For P2SH, accurate counting requires the input scripts to be evaluated
+            // We use a conservative estimate: max 15 sigops per P2SH input (standard multisig limit)
+            for (size_t i = 0; i < txInfo.tx->vin.size(); ++i) {
+                // Check if this is spending a P2SH output (scriptSig contains data pushes)
+                // Use accurate counting if we have the scriptSig
+                sigops += txInfo.tx->GetDecodedScriptSig(i).GetSigOpCount(true);
+            }
+            
+            // Add to block
+            AddTransaction(txInfo.tx, txInfo.fee, sigops);
+        }
     }
 }
 
@@ -232,7 +241,7 @@ Amount BlockAssembler::CalculateCoinbaseValue() const {
     return subsidy + m_template->totalFees;
 }
 
-bool BlockAssembler::CanAddTransaction(const Transaction& tx, Amount fee) const {
+bool BlockAssembler::CanAddTransaction(const Transaction& tx) const {
     // Calculate transaction weight (using virtual size for SegWit compatibility)
     // For non-witness transactions: weight = size * 4
     // For witness transactions: weight = base_size * 3 + total_size
@@ -245,11 +254,11 @@ bool BlockAssembler::CanAddTransaction(const Transaction& tx, Amount fee) const
     
     // Count sigops accurately
     size_t sigops = 0;
-    for (const auto& txout : tx.vout) {
-        sigops += txout.scriptPubKey.GetSigOpCount(false);
+    for (size_t i = 0; i < tx.vout.size(); ++i) {
+        sigops += tx.GetDecodedScriptPubKey(i).GetSigOpCount(false);
     }
-    for (const auto& txin : tx.vin) {
-        sigops += txin.scriptSig.GetSigOpCount(true);
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        sigops += tx.GetDecodedScriptSig(i).GetSigOpCount(true);
     }
     
     // Check sigops limit
@@ -257,11 +266,6 @@ bool BlockAssembler::CanAddTransaction(const Transaction& tx, Amount fee) const
         return false;
     }
     
-    // Check minimum fee rate
-    if (fee < m_options.minFeeRate.GetFee(tx.GetTotalSize())) {
-        return false;
-    }
-    
     return true;
 }
 
@@ -280,8 +284,21 @@ void BlockAssembler::AddTransaction(const TransactionRef& tx, Amount fee, size_t
 }
 
 void BlockAssembler::FinalizeBlock() {
-    // Compute merkle root
-    m_template->block.hashMerkleRoot = m_template->block.ComputeMerkleRoot();
+    // Keep the coinbase's branch and derive the root from it
+    Block& block = m_template->block;
+    std::vector<Hash256> leaves;
+    leaves.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        leaves.push_back(Hash256(tx->GetHash().data(), 32));
+    }
+    if (leaves.empty()) {
+        m_template->coinbaseMerkleBranch.clear();
+        block.hashMerkleRoot = Hash256();
+        return;
+    }
+    m_template->coinbaseMerkleBranch = ComputeMerklePath(leaves, 0);
+    block.hashMerkleRoot = ComputeMerkleRootFromPath(leaves[0], 0,
+                                                     m_template->coinbaseMerkleBranch);
 }
 
 // ============================================================================
@@ -4,12 +4,15 @@
 
 #include "shurium/miner/miner.h"
 #include "shurium/chain/chainstate.h"
+#include "shurium/core/merkle.h"
 #include "shurium/network/message_processor.h"
 #include "shurium/crypto/sha256.h"
+#include "shurium/util/affinity.h"
 #include "shurium/util/logging.h"
 #include "shurium/util/time.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <thread>
 
@@ -31,6 +34,10 @@ void MiningStats::Reset() {
     hashesComputed = 0;
     blocksFound = 0;
     blocksAccepted = 0;
+    templatesBuilt = 0;
+    templatesStale = 0;
+    templateBuildLatency.Reset();
+    blockRelayLatency.Reset();
     startTime = GetTime();
 }
 
@@ -69,11 +76,31 @@ bool Miner::Start() {
         return false;
     }
     
-    LOG_INFO(util::LogCategory::DEFAULT) << "Starting miner with " << numThreads << " thread(s)";
+    backends_.clear();
+    for (int i = 0; i < numThreads; ++i) {
+        std::string error;
+        std::unique_ptr<MiningBackend> backend = CreateMiningBackend(options_.backend, error);
+        if (!backend) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Cannot start mining: " << error;
+            backends_.clear();
+            return false;
+        }
+        backends_.push_back(std::move(backend));
+    }
+    
+    LOG_INFO(util::LogCategory::DEFAULT) << "Starting miner with " << numThreads << " thread(s) on the "
+        << options_.backend << " backend";
     
     shouldStop_.store(false);
     running_.store(true);
-    stats_.Reset();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.Reset();
+        threadHashes_.clear();
+        for (int i = 0; i < numThreads; ++i) {
+            threadHashes_.emplace_back(0);
+        }
+    }
     
     // Launch mining threads
     threads_.reserve(numThreads);
@@ -101,6 +128,7 @@ void Miner::Stop() {
         }
     }
     threads_.clear();
+    backends_.clear();
     
     running_.store(false);
     
@@ -110,6 +138,30 @@ void Miner::Stop() {
         << static_cast<uint64_t>(stats_.GetHashRate()) << " H/s average";
 }
 
+std::vector<double> Miner::GetThreadHashRates() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<double> rates;
+    rates.reserve(threadHashes_.size());
+    int64_t elapsed = stats_.startTime == 0 ? 0 : GetTime() - stats_.startTime;
+    for (const auto& hashes : threadHashes_) {
+        rates.push_back(elapsed > 0 ? static_cast<double>(hashes.load()) / elapsed : 0.0);
+    }
+    return rates;
+}
+
+uint32_t Miner::GetOrphanedBlockCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Chain& chain = chainman_.GetActiveChain();
+    uint32_t orphaned = 0;
+    for (const BlockHash& hash : minedBlocks_) {
+        const BlockIndex* pindex = chainman_.LookupBlockIndex(hash);
+        if (!pindex || !chain.Contains(pindex)) {
+            ++orphaned;
+        }
+    }
+    return orphaned;
+}
+
 void Miner::SetCoinbaseAddress(const Hash160& address) {
     std::lock_guard<std::mutex> lock(mutex_);
     options_.coinbaseAddress = address;
@@ -121,6 +173,7 @@ void Miner::SetBlockFoundCallback(BlockFoundCallback callback) {
 }
 
 void Miner::MiningThread(int threadId) {
+    util::ScopedThreadRole role("miner");
     LOG_DEBUG(util::LogCategory::DEFAULT) << "Mining thread " << threadId << " started";
     
     // Get initial chain state
@@ -143,8 +196,12 @@ void Miner::MiningThread(int threadId) {
             }
             
             // Create block template
+            auto buildStart = std::chrono::steady_clock::now();
             BlockAssembler assembler(chainState, mempool_, params_);
             BlockTemplate tmpl = assembler.CreateNewBlock(coinbaseAddr);
+            stats_.templateBuildLatency.Record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - buildStart).count()));
             
             if (!tmpl.isValid) {
                 LOG_DEBUG(util::LogCategory::DEFAULT) << "Thread " << threadId 
@@ -154,7 +211,8 @@ void Miner::MiningThread(int threadId) {
             }
             
             // Try to mine this template
-            if (TryMineBlock(tmpl, threadId)) {
+            stats_.templatesBuilt++;
+            if (TryMineBlock(tmpl, threadId, *backends_[threadId])) {
                 // Block found! Already submitted in TryMineBlock
             }
             
@@ -168,7 +226,7 @@ void Miner::MiningThread(int threadId) {
     LOG_DEBUG(util::LogCategory::DEFAULT) << "Mining thread " << threadId << " stopped";
 }
 
-bool Miner::TryMineBlock(BlockTemplate& tmpl, int threadId) {
+bool Miner::TryMineBlock(BlockTemplate& tmpl, int threadId, MiningBackend& backend) {
     Block& block = tmpl.block;
     
     // Record template height for logging
@@ -208,8 +266,15 @@ bool Miner::TryMineBlock(BlockTemplate& tmpl, int threadId) {
                     // Create new transaction ref with modified coinbase
                     block.vtx[0] = MakeTransactionRef(std::move(mutableCoinbase));
                     
-                    // Recompute merkle root since coinbase changed
-                    block.hashMerkleRoot = block.ComputeMerkleRoot();
+                    // Only the coinbase leaf changed: walk its cached branch
+                    // up to the root instead of rehashing every transaction
+                    if (tmpl.coinbaseMerkleBranch.empty() && block.vtx.size() > 1) {
+                        block.hashMerkleRoot = block.ComputeMerkleRoot();
+                    } else {
+                        block.hashMerkleRoot = ComputeMerkleRootFromPath(
+                            Hash256(block.vtx[0]->GetHash().data(), 32), 0,
+                            tmpl.coinbaseMerkleBranch);
+                    }
                 }
             }
         }
@@ -218,25 +283,48 @@ bool Miner::TryMineBlock(BlockTemplate& tmpl, int threadId) {
     // Start time for template refresh
     int64_t startTime = GetTime();
     
-    // Mining loop
+    // Everything but the nonce is fixed from here, so the first 64 header
+    // bytes are compressed once and each nonce only costs its tail block
+    DataStream header;
+    Serialize(header, static_cast<const BlockHeader&>(block));
+    const SHA256Midstate midstate = SHA256HeaderMidstate(header.data());
+    const Byte* tail = header.data() + 64;
+    std::vector<uint32_t> candidates;
+    
+    // Mining loop; a device batch is never cut short by the template limit
+    const uint32_t batch = std::max<uint32_t>(1, backend.GetBatchSize());
     uint32_t nonce = 0;
-    uint32_t maxNonces = options_.maxNoncesPerTemplate;
+    uint32_t maxNonces = std::max(options_.maxNoncesPerTemplate, batch);
     
     while (!shouldStop_.load() && nonce < maxNonces) {
-        // Update nonce
-        block.nNonce = nonce;
-        
-        // Hash the block header
-        Hash256 hash = block.GetHash();
+        // Hand a batch of nonces to the backend
+        uint32_t count = std::min(batch, maxNonces - nonce);
+        candidates.clear();
+        if (!backend.Search(midstate, tail, tmpl.target, nonce, count, candidates)) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Thread " << threadId 
+                << ": " << backend.GetName() << " backend failed, stopping";
+            shouldStop_.store(true);
+            return false;
+        }
         
-        // Check if we meet the target
-        if (MeetsTarget(hash, tmpl.target)) {
+        for (uint32_t candidate : candidates) {
+            // Backends may report false positives
+            Byte digest[32];
+            DoubleSHA256_80_Nonces(digest, midstate, tail, candidate, 1);
+            Hash256 hash(digest, 32);
+            if (!MeetsTarget(hash, tmpl.target)) {
+                continue;
+            }
+            
             // Found a valid block!
+            block.nNonce = candidate;
             LOG_INFO(util::LogCategory::DEFAULT) << "Thread " << threadId 
                 << " found block at height " << height 
                 << " with hash " << hash.ToHex().substr(0, 16) << "...";
             
             stats_.blocksFound++;
+            stats_.hashesComputed += count;
+            threadHashes_[threadId] += count;
             
             // Submit the block
             bool accepted = SubmitBlock(block);
@@ -254,23 +342,26 @@ bool Miner::TryMineBlock(BlockTemplate& tmpl, int threadId) {
             return accepted;
         }
         
-        ++nonce;
-        stats_.hashesComputed++;
+        uint32_t previous = nonce;
+        nonce += count;
+        stats_.hashesComputed += count;
+        threadHashes_[threadId] += count;
         
         // Log progress periodically (every ~1M hashes)
-        if ((nonce & 0xFFFFF) == 0) {
+        if ((previous >> 20) != (nonce >> 20)) {
             LOG_DEBUG(util::LogCategory::DEFAULT) << "Thread " << threadId 
                 << ": " << nonce << " hashes at height " << height
                 << " (" << static_cast<uint64_t>(stats_.GetHashRate()) << " H/s total)";
         }
         
         // Check if we should refresh the template (new tip, timeout)
-        if ((nonce & 0xFFFF) == 0) {
+        if ((previous >> 16) != (nonce >> 16)) {
             // Check for new tip
             BlockIndex* currentTip = chainman_.GetActiveTip();
             if (currentTip && currentTip->GetBlockHash() != block.hashPrevBlock) {
                 LOG_DEBUG(util::LogCategory::DEFAULT) << "Thread " << threadId 
                     << ": chain tip changed, getting new template";
+                stats_.templatesStale++;
                 return false;  // Get new template
             }
             
@@ -289,6 +380,7 @@ bool Miner::TryMineBlock(BlockTemplate& tmpl, int threadId) {
 }
 
 bool Miner::SubmitBlock(Block& block) {
+    auto foundTime = std::chrono::steady_clock::now();
     LOG_INFO(util::LogCategory::DEFAULT) << "Submitting block " << block.GetHash().ToHex().substr(0, 16) << "...";
     
     // Process the new block
@@ -300,7 +392,17 @@ bool Miner::SubmitBlock(Block& block) {
         
         // Relay to network
         if (msgproc_) {
-            msgproc_->RelayBlock(block.GetHash());
+            msgproc_->RelayBlock(block);
+        }
+        stats_.blockRelayLatency.Record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - foundTime).count()));
+        
+        // Remember it, to notice later if a reorg leaves it behind
+        std::lock_guard<std::mutex> lock(mutex_);
+        minedBlocks_.push_back(block.GetHash());
+        if (minedBlocks_.size() > MAX_TRACKED_MINED_BLOCKS) {
+            minedBlocks_.pop_front();
         }
     } else {
         LOG_WARN(util::LogCategory::DEFAULT) << "Block rejected by chain";
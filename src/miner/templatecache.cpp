@@ -0,0 +1,123 @@
+// SHURIUM - Block Template Cache Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/miner/templatecache.h"
+#include "shurium/util/time.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+namespace shurium {
+namespace miner {
+
+BlockTemplateCache::BlockTemplateCache(ChainState& chainStateIn, Mempool& mempoolIn,
+                                       const consensus::Params& paramsIn,
+                                       const Script& coinbaseScriptIn,
+                                       const BlockAssemblerOptions& optionsIn)
+    : chainState(chainStateIn)
+    , mempool(mempoolIn)
+    , params(paramsIn)
+    , coinbaseScript(coinbaseScriptIn)
+    , options(optionsIn) {
+}
+
+BlockTemplateCache::~BlockTemplateCache() {
+    Interrupt();
+}
+
+// ============================================================================
+// Serving Templates
+// ============================================================================
+
+bool BlockTemplateCache::IsStaleLocked(int64_t now) {
+    if (!current) {
+        return true;
+    }
+    BlockIndex* tip = chainState.GetTip();
+    BlockHash tipHash = tip ? tip->GetBlockHash() : BlockHash();
+    if (tipHash != current->block.hashPrevBlock) {
+        return true;
+    }
+    return mempool.GetChangeSequence() != builtSequence &&
+           now - builtTime >= TEMPLATE_REFRESH_INTERVAL;
+}
+
+std::shared_ptr<const BlockTemplate> BlockTemplateCache::GetLocked() {
+    int64_t now = util::GetTime();
+    if (!IsStaleLocked(now)) {
+        return current;
+    }
+
+    // Read the count first, so changes made during assembly go stale later
+    uint64_t sequence = mempool.GetChangeSequence();
+    BlockAssembler assembler(chainState, mempool, params, options);
+    auto tmpl = std::make_shared<const BlockTemplate>(assembler.CreateNewBlock(coinbaseScript));
+    ++buildCount;
+    if (!tmpl->isValid) {
+        return tmpl;
+    }
+    current = tmpl;
+    builtSequence = sequence;
+    builtTime = now;
+    return current;
+}
+
+std::shared_ptr<const BlockTemplate> BlockTemplateCache::Get() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return GetLocked();
+}
+
+uint64_t BlockTemplateCache::GetBuildCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return buildCount;
+}
+
+// ============================================================================
+// Long Polling
+// ============================================================================
+
+std::string BlockTemplateCache::GetLongPollId(const BlockTemplate& tmpl) {
+    return tmpl.block.hashPrevBlock.ToHex() + std::to_string(tmpl.totalFees);
+}
+
+std::shared_ptr<const BlockTemplate> BlockTemplateCache::WaitForChange(
+    const std::string& longPollId, int64_t timeoutSeconds) {
+    // An id we did not hand out names no tip, so it is answered at once
+    constexpr size_t TIP_HEX_LENGTH = 64;
+    std::string polledTip = longPollId.substr(0, TIP_HEX_LENGTH);
+    Amount polledFees = longPollId.size() > TIP_HEX_LENGTH
+        ? std::strtoll(longPollId.c_str() + TIP_HEX_LENGTH, nullptr, 10) : 0;
+    Amount wantedFees = polledFees + std::max(LONGPOLL_MIN_FEE_GAIN,
+                                              polledFees / LONGPOLL_FEE_GAIN_DIVISOR);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    int64_t deadline = util::GetTime() + timeoutSeconds;
+    while (true) {
+        std::shared_ptr<const BlockTemplate> tmpl = GetLocked();
+        if (interrupted || !tmpl->isValid ||
+            tmpl->block.hashPrevBlock.ToHex() != polledTip ||
+            tmpl->totalFees >= wantedFees || util::GetTime() >= deadline) {
+            return tmpl;
+        }
+
+        // Tips are announced through Notify; the mempool is looked at again
+        // each second and rebuilt into a template as IsStaleLocked allows
+        changed.wait_for(lock, std::chrono::seconds(1));
+    }
+}
+
+void BlockTemplateCache::Notify() {
+    changed.notify_all();
+}
+
+void BlockTemplateCache::Interrupt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        interrupted = true;
+    }
+    changed.notify_all();
+}
+
+} // namespace miner
+} // namespace shurium
@@ -314,6 +314,23 @@ int NetAddress::GetReachability() const {
     }
 }
 
+std::vector<uint8_t> NetAddress::GetNetGroup() const {
+    if (!IsRoutable()) {
+        return {static_cast<uint8_t>(Network::UNROUTABLE)};
+    }
+    if (auto ipv4 = GetMappedIPv4()) {
+        return {static_cast<uint8_t>(Network::IPV4), (*ipv4)[0], (*ipv4)[1]};
+    }
+    
+    size_t prefix = 4;
+    if (network_ == Network::IPV4) {
+        prefix = 2;
+    }
+    std::vector<uint8_t> group{static_cast<uint8_t>(network_)};
+    group.insert(group.end(), addr_.begin(), addr_.begin() + std::min(prefix, addr_.size()));
+    return group;
+}
+
 bool NetAddress::operator==(const NetAddress& other) const {
     return network_ == other.network_ && addr_ == other.addr_;
 }
@@ -5,10 +5,13 @@
 #include <shurium/network/addrman.h>
 #include <shurium/util/logging.h>
 #include <shurium/core/serialize.h>
+#include <shurium/crypto/sha256.h>
 
 #include <algorithm>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <memory>
 #include <random>
 
 // Include system headers for DNS resolution
@@ -25,13 +28,130 @@
 
 namespace shurium {
 
+namespace {
+
+// ============================================================================
+// Peers File Records
+// ============================================================================
+
+/// "NXPR" (SHURIUM PeeRs)
+constexpr uint32_t PEERS_FILE_MAGIC = 0x4E585052;
+
+/// Most entries a peers file may hold
+constexpr uint32_t MAX_PEERS_FILE_ENTRIES = 100000;
+
+/// Longest address a record holds (Tor v3, I2P)
+constexpr size_t RECORD_ADDR_BYTES = 32;
+
+/*
+ * Record layout, little endian, PEERS_RECORD_SIZE bytes:
+ *
+ *     0  address: network, length, 32 bytes, port
+ *    36  services (8), last seen (8)
+ *    52  source: network, length, 32 bytes, port
+ *    88  nTime, nLastSuccess, nLastTry (8 each)
+ *   112  nAttempts, nRefCount (4 each)
+ *   120  flags (1), then zero padding
+ */
+constexpr size_t SERVICE_BYTES = 2 + RECORD_ADDR_BYTES + 2;
+
+template<typename T>
+void WriteLE(Byte* out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out[i] = static_cast<Byte>(value >> (8 * i));
+    }
+}
+
+template<typename T>
+T ReadLE(const Byte* in) {
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<T>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+void WriteService(Byte* out, const NetService& service) {
+    const auto& bytes = service.GetBytes();
+    size_t len = std::min(bytes.size(), RECORD_ADDR_BYTES);
+    out[0] = static_cast<Byte>(service.GetNetwork());
+    out[1] = static_cast<Byte>(len);
+    std::memcpy(out + 2, bytes.data(), len);
+    WriteLE<uint16_t>(out + 2 + RECORD_ADDR_BYTES, service.GetPort());
+}
+
+bool ReadService(const Byte* in, NetService& service) {
+    uint8_t network = in[0];
+    size_t len = in[1];
+    if (network >= static_cast<uint8_t>(Network::MAX) || len > RECORD_ADDR_BYTES) {
+        return false;
+    }
+    std::vector<uint8_t> bytes(in + 2, in + 2 + len);
+    service = NetService(NetAddress(bytes, static_cast<Network>(network)),
+                         ReadLE<uint16_t>(in + 2 + RECORD_ADDR_BYTES));
+    return true;
+}
+
+void EncodeRecord(const AddressInfo& info, Byte* out) {
+    WriteService(out, info.addr);
+    WriteLE<uint64_t>(out + 36, static_cast<uint64_t>(info.addr.GetServices()));
+    WriteLE<uint64_t>(out + 44, static_cast<uint64_t>(info.addr.GetTime()));
+    WriteService(out + 52, info.source);
+    WriteLE<uint64_t>(out + 88, static_cast<uint64_t>(info.nTime));
+    WriteLE<uint64_t>(out + 96, static_cast<uint64_t>(info.nLastSuccess));
+    WriteLE<uint64_t>(out + 104, static_cast<uint64_t>(info.nLastTry));
+    WriteLE<uint32_t>(out + 112, static_cast<uint32_t>(info.nAttempts));
+    WriteLE<uint32_t>(out + 116, static_cast<uint32_t>(info.nRefCount));
+    out[120] = info.fInTried ? 0x01 : 0x00;
+}
+
+bool DecodeRecord(const Byte* in, AddressInfo& info) {
+    NetService addr;
+    if (!ReadService(in, addr) || !ReadService(in + 52, info.source)) {
+        return false;
+    }
+    info.addr = PeerAddress(addr, static_cast<int64_t>(ReadLE<uint64_t>(in + 44)),
+                            static_cast<ServiceFlags>(ReadLE<uint64_t>(in + 36)));
+    info.nTime = static_cast<int64_t>(ReadLE<uint64_t>(in + 88));
+    info.nLastSuccess = static_cast<int64_t>(ReadLE<uint64_t>(in + 96));
+    info.nLastTry = static_cast<int64_t>(ReadLE<uint64_t>(in + 104));
+    info.nAttempts = static_cast<int32_t>(ReadLE<uint32_t>(in + 112));
+    info.nRefCount = static_cast<int32_t>(ReadLE<uint32_t>(in + 116));
+    info.fInTried = (in[120] & 0x01) != 0;
+    return true;
+}
+
+static_assert(SERVICE_BYTES == 36, "record layout");
+static_assert(121 <= PEERS_RECORD_SIZE, "record layout");
+
+// ============================================================================
+// Seed Lookups
+// ============================================================================
+
+/// One seed's lookup, filled in by the thread doing it
+struct SeedLookup {
+    std::string host;
+    std::vector<NetService> addresses;
+    bool done{false};
+};
+
+/// Lookups started together. Shared with their threads, which may
+/// outlive the resolution that started them.
+struct SeedLookupBatch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<SeedLookup> lookups;
+    size_t pending{0};
+};
+
+} // anonymous namespace
+
 // ============================================================================
 // AddressManager Implementation
 // ============================================================================
 
 AddressManager::AddressManager(const std::string& networkId)
-    : networkId_(networkId)
-    , rng_(std::random_device{}()) {
+    : networkId_(networkId) {
     
     // Set default seeds based on network
     if (networkId == "main") {
@@ -60,18 +180,32 @@ void AddressManager::Stop() {
     if (resolveThread_.joinable()) {
         resolveThread_.join();
     }
+    
+    {
+        std::lock_guard<std::mutex> lock(saveMutex_);
+        saveStop_ = true;
+    }
+    saveCv_.notify_all();
+    if (saveThread_.joinable()) {
+        saveThread_.join();
+    }
 }
 
 bool AddressManager::Load(const std::string& path) {
-    std::ifstream file(path, std::ios::binary);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
     if (!file) {
         LOG_DEBUG(util::LogCategory::NET) << "No peers file found at " << path;
         return true;  // Not an error - file may not exist yet
     }
     
-    // Read file contents
-    std::vector<Byte> data((std::istreambuf_iterator<char>(file)),
-                            std::istreambuf_iterator<char>());
+    // One read for the whole file
+    std::vector<Byte> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        LOG_WARN(util::LogCategory::NET) << "Failed to read peers file: " << path;
+        return false;
+    }
     
     if (data.size() < 16) {
         LOG_WARN(util::LogCategory::NET) << "Peers file too small: " << data.size() << " bytes";
@@ -85,7 +219,7 @@ bool AddressManager::Load(const std::string& path) {
         // Magic: "NXPR" (SHURIUM PeeRs)
         uint32_t magic;
         Unserialize(stream, magic);
-        if (magic != 0x4E585052) {
+        if (magic != PEERS_FILE_MAGIC) {
             LOG_WARN(util::LogCategory::NET) << "Invalid peers file magic";
             return false;
         }
@@ -93,7 +227,7 @@ bool AddressManager::Load(const std::string& path) {
         // Version
         uint32_t version;
         Unserialize(stream, version);
-        if (version > 1) {
+        if (version == 0 || version > PEERS_FILE_VERSION) {
             LOG_WARN(util::LogCategory::NET) << "Unsupported peers file version: " << version;
             return false;
         }
@@ -117,48 +251,18 @@ bool AddressManager::Load(const std::string& path) {
         vNew_.clear();
         vTried_.clear();
         
-        uint32_t count;
-        Unserialize(stream, count);
-        
-        // Sanity check
-        if (count > 100000) {
-            LOG_WARN(util::LogCategory::NET) << "Peers file has too many entries: " << count;
+        bool ok = version == 1 ? LoadLegacyEntries(stream)
+                               : LoadRecords(data, data.size() - stream.size());
+        if (!ok) {
+            mapInfo_.clear();
+            vNew_.clear();
+            vTried_.clear();
             return false;
         }
+        savedChanges_ = ++changes_;
         
-        for (uint32_t i = 0; i < count; ++i) {
-            AddressInfo info;
-            
-            // Read PeerAddress (using member Unserialize method)
-            info.addr.Unserialize(stream);
-            
-            // Read source NetService (using member Unserialize method)
-            info.source.Unserialize(stream);
-            
-            // Read metadata
-            Unserialize(stream, info.nTime);
-            Unserialize(stream, info.nLastSuccess);
-            Unserialize(stream, info.nLastTry);
-            Unserialize(stream, info.nAttempts);
-            Unserialize(stream, info.nRefCount);
-            
-            uint8_t flags;
-            Unserialize(stream, flags);
-            info.fInTried = (flags & 0x01) != 0;
-            
-            // Generate key and store
-            std::string key = info.GetKey();
-            mapInfo_[key] = std::move(info);
-            
-            // Add to appropriate bucket
-            if (mapInfo_[key].fInTried) {
-                vTried_.push_back(key);
-            } else {
-                vNew_.push_back(key);
-            }
-        }
-        
-        LOG_INFO(util::LogCategory::NET) << "Loaded " << count << " peer addresses from " << path
+        LOG_INFO(util::LogCategory::NET) << "Loaded " << mapInfo_.size()
+                                         << " peer addresses from " << path
                                          << " (" << vTried_.size() << " tried, " 
                                          << vNew_.size() << " new)";
         return true;
@@ -169,64 +273,188 @@ bool AddressManager::Load(const std::string& path) {
     }
 }
 
-bool AddressManager::Save(const std::string& path) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    DataStream stream;
+bool AddressManager::LoadLegacyEntries(DataStream& stream) {
+    uint32_t count;
+    Unserialize(stream, count);
     
-    // === Write header ===
-    // Magic: "NXPR" (SHURIUM PeeRs)
-    uint32_t magic = 0x4E585052;
-    Serialize(stream, magic);
-    
-    // Version
-    uint32_t version = 1;
-    Serialize(stream, version);
+    // Sanity check
+    if (count > MAX_PEERS_FILE_ENTRIES) {
+        LOG_WARN(util::LogCategory::NET) << "Peers file has too many entries: " << count;
+        return false;
+    }
     
-    // Network ID
-    Serialize(stream, networkId_);
+    for (uint32_t i = 0; i < count; ++i) {
+        AddressInfo info;
+        
+        // Read PeerAddress (using member Unserialize method)
+        info.addr.Unserialize(stream);
+        
+        // Read source NetService (using member Unserialize method)
+        info.source.Unserialize(stream);
+        
+        // Read metadata
+        Unserialize(stream, info.nTime);
+        Unserialize(stream, info.nLastSuccess);
+        Unserialize(stream, info.nLastTry);
+        Unserialize(stream, info.nAttempts);
+        Unserialize(stream, info.nRefCount);
+        
+        uint8_t flags;
+        Unserialize(stream, flags);
+        info.fInTried = (flags & 0x01) != 0;
+        
+        // Generate key and store
+        AddressKey key = info.GetKey();
+        mapInfo_[key] = std::move(info);
+        
+        // Add to appropriate bucket
+        if (mapInfo_[key].fInTried) {
+            vTried_.push_back(key);
+        } else {
+            vNew_.push_back(key);
+        }
+    }
+    return true;
+}
+
+bool AddressManager::LoadRecords(const std::vector<Byte>& data, size_t offset) {
+    // count and record size, the records, then the checksum of all before it
+    if (data.size() < offset + 8 + Hash256::SIZE) {
+        LOG_WARN(util::LogCategory::NET) << "Peers file truncated";
+        return false;
+    }
+    size_t checksumPos = data.size() - Hash256::SIZE;
+    Hash256 checksum = DoubleSHA256(data.data(), checksumPos);
+    if (std::memcmp(checksum.data(), data.data() + checksumPos, Hash256::SIZE) != 0) {
+        LOG_WARN(util::LogCategory::NET) << "Peers file checksum mismatch";
+        return false;
+    }
     
-    // === Write address entries ===
-    uint32_t count = static_cast<uint32_t>(mapInfo_.size());
-    Serialize(stream, count);
+    const Byte* p = data.data() + offset;
+    uint32_t count = ReadLE<uint32_t>(p);
+    uint32_t recordSize = ReadLE<uint32_t>(p + 4);
+    p += 8;
+    if (count > MAX_PEERS_FILE_ENTRIES || recordSize < PEERS_RECORD_SIZE ||
+        static_cast<uint64_t>(count) * recordSize != checksumPos - offset - 8) {
+        LOG_WARN(util::LogCategory::NET) << "Peers file has a bad record table";
+        return false;
+    }
     
-    for (const auto& [key, info] : mapInfo_) {
-        // Write PeerAddress (using member Serialize method)
-        info.addr.Serialize(stream);
+    // Records are in key order, so every insert lands at the end
+    vNew_.reserve(count);
+    for (uint32_t i = 0; i < count; ++i, p += recordSize) {
+        AddressInfo info;
+        if (!DecodeRecord(p, info)) {
+            continue;
+        }
+        AddressKey key = info.GetKey();
+        bool tried = info.fInTried;
+        auto before = mapInfo_.size();
+        mapInfo_.emplace_hint(mapInfo_.end(), key, std::move(info));
+        if (mapInfo_.size() == before) {
+            continue;
+        }
+        (tried ? vTried_ : vNew_).push_back(std::move(key));
+    }
+    return true;
+}
+
+bool AddressManager::Save(const std::string& path) const {
+    DataStream stream;
+    uint64_t changes;
+    uint32_t count;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        changes = changes_.load();
+        
+        // === Write header ===
+        // Magic: "NXPR" (SHURIUM PeeRs)
+        Serialize(stream, PEERS_FILE_MAGIC);
+        Serialize(stream, PEERS_FILE_VERSION);
         
-        // Write source NetService (using member Serialize method)
-        info.source.Serialize(stream);
+        // Network ID
+        Serialize(stream, networkId_);
         
-        // Write metadata
-        Serialize(stream, info.nTime);
-        Serialize(stream, info.nLastSuccess);
-        Serialize(stream, info.nLastTry);
-        Serialize(stream, info.nAttempts);
-        Serialize(stream, info.nRefCount);
+        // === Write address records ===
+        count = static_cast<uint32_t>(mapInfo_.size());
+        Serialize(stream, count);
+        Serialize(stream, static_cast<uint32_t>(PEERS_RECORD_SIZE));
         
-        // Flags
-        uint8_t flags = 0;
-        if (info.fInTried) flags |= 0x01;
-        Serialize(stream, flags);
+        std::vector<Byte> records(mapInfo_.size() * PEERS_RECORD_SIZE, 0);
+        Byte* out = records.data();
+        for (const auto& [key, info] : mapInfo_) {
+            EncodeRecord(info, out);
+            out += PEERS_RECORD_SIZE;
+        }
+        stream.Write(records.data(), records.size());
     }
     
+    // Checksum of everything written so far
+    Hash256 checksum = DoubleSHA256(stream.data(), stream.size());
+    stream.Write(checksum.data(), Hash256::SIZE);
+    
     // === Write to file ===
-    std::ofstream file(path, std::ios::binary);
-    if (!file) {
-        LOG_WARN(util::LogCategory::NET) << "Failed to open peers file for writing: " << path;
-        return false;
+    // Periodic and shutdown saves would share the temporary file
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    std::filesystem::path finalPath(path);
+    std::filesystem::path tmpPath = finalPath;
+    tmpPath += ".new";
+    std::error_code ec;
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG_WARN(util::LogCategory::NET) << "Failed to open peers file for writing: "
+                                             << tmpPath.string();
+            return false;
+        }
+        
+        file.write(reinterpret_cast<const char*>(stream.data()),
+                   static_cast<std::streamsize>(stream.size()));
+        file.flush();
+        if (!file.good()) {
+            LOG_WARN(util::LogCategory::NET) << "Failed to write peers file: " << tmpPath.string();
+            file.close();
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
     }
     
-    file.write(reinterpret_cast<const char*>(stream.data()), stream.size());
-    if (!file.good()) {
-        LOG_WARN(util::LogCategory::NET) << "Failed to write peers file: " << path;
+    std::filesystem::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        LOG_WARN(util::LogCategory::NET) << "Failed to rename peers file to " << path;
+        std::filesystem::remove(tmpPath, ec);
         return false;
     }
+    savedChanges_ = changes;
     
     LOG_INFO(util::LogCategory::NET) << "Saved " << count << " peer addresses to " << path;
     return true;
 }
 
+void AddressManager::StartPeriodicSave(const std::string& path, int64_t intervalSeconds) {
+    if (saveThread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(saveMutex_);
+        saveStop_ = false;
+    }
+    saveThread_ = std::thread(&AddressManager::SaveLoop, this, path, intervalSeconds);
+}
+
+void AddressManager::SaveLoop(std::string path, int64_t intervalSeconds) {
+    std::unique_lock<std::mutex> lock(saveMutex_);
+    while (!saveCv_.wait_for(lock, std::chrono::seconds(intervalSeconds),
+                             [this] { return saveStop_; })) {
+        if (!HasUnsavedChanges()) {
+            continue;
+        }
+        lock.unlock();
+        Save(path);
+        lock.lock();
+    }
+}
+
 // ============================================================================
 // Address Management
 // ============================================================================
@@ -235,54 +463,69 @@ bool AddressManager::Add(const PeerAddress& addr, const NetService& source, int6
     if (!IsValidForStorage(addr)) {
         return false;
     }
+    AddressKey key = GetAddressKey(addr);
     
     std::lock_guard<std::mutex> lock(mutex_);
+    return AddLocked(addr, key, source, penalty);
+}
+
+size_t AddressManager::Add(const std::vector<PeerAddress>& addrs, const NetService& source,
+                           int64_t penalty) {
+    // Validate and key them before taking the lock, then insert in one go
+    std::vector<std::pair<AddressKey, const PeerAddress*>> keyed;
+    keyed.reserve(addrs.size());
+    for (const auto& addr : addrs) {
+        if (IsValidForStorage(addr)) {
+            keyed.emplace_back(GetAddressKey(addr), &addr);
+        }
+    }
+    if (keyed.empty()) {
+        return 0;
+    }
     
-    // PeerAddress inherits from NetService which inherits from NetAddress
-    // Use NetAddress::ToString() for the address and GetPort() for the port
-    std::string key = static_cast<const NetAddress&>(addr).ToString() + ":" + std::to_string(addr.GetPort());
-    
-    auto it = mapInfo_.find(key);
-    if (it != mapInfo_.end()) {
+    size_t added = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, addr] : keyed) {
+        if (AddLocked(*addr, key, source, penalty)) {
+            ++added;
+        }
+    }
+    return added;
+}
+
+bool AddressManager::AddLocked(const PeerAddress& addr, const AddressKey& key,
+                               const NetService& source, int64_t penalty) {
+    auto it = mapInfo_.lower_bound(key);
+    if (it != mapInfo_.end() && it->first == key) {
         // Address already known - update reference count
         it->second.nRefCount++;
+        ++changes_;
         return false;
     }
     
     // Add new address
-    AddressInfo info = MakeInfo(addr, source, penalty);
-    mapInfo_[key] = std::move(info);
+    mapInfo_.emplace_hint(it, key, MakeInfo(addr, source, penalty));
     vNew_.push_back(key);
+    ++changes_;
     
     return true;
 }
 
-size_t AddressManager::Add(const std::vector<PeerAddress>& addrs, const NetService& source,
-                           int64_t penalty) {
-    size_t added = 0;
-    for (const auto& addr : addrs) {
-        if (Add(addr, source, penalty)) {
-            ++added;
-        }
-    }
-    return added;
-}
-
 void AddressManager::Attempt(const NetService& addr) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    std::string key = addr.ToString();
-    auto it = mapInfo_.find(key);
+    auto it = mapInfo_.find(GetAddressKey(addr));
     if (it != mapInfo_.end()) {
         it->second.nLastTry = GetAdjustedTime();
         it->second.nAttempts++;
+        ++changes_;
     }
 }
 
 void AddressManager::Good(const NetService& addr) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    std::string key = addr.ToString();
+    AddressKey key = GetAddressKey(addr);
     auto it = mapInfo_.find(key);
     if (it == mapInfo_.end()) {
         return;
@@ -292,6 +535,7 @@ void AddressManager::Good(const NetService& addr) {
     it->second.nLastSuccess = now;
     it->second.nLastTry = now;
     it->second.nAttempts = 0;
+    ++changes_;
     
     // Move from new to tried if not already there
     if (!it->second.fInTried) {
@@ -309,10 +553,10 @@ void AddressManager::Good(const NetService& addr) {
 void AddressManager::Connected(const NetService& addr) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    std::string key = addr.ToString();
-    auto it = mapInfo_.find(key);
+    auto it = mapInfo_.find(GetAddressKey(addr));
     if (it != mapInfo_.end()) {
         it->second.nTime = GetAdjustedTime();
+        ++changes_;
     }
 }
 
@@ -326,10 +570,10 @@ std::optional<PeerAddress> AddressManager::Select(bool newOnly) {
     int64_t now = GetAdjustedTime();
     
     // Build list of candidates
-    std::vector<std::pair<double, std::string>> candidates;
+    std::vector<std::pair<double, AddressKey>> candidates;
     
     const auto& pool = newOnly ? vNew_ : (vTried_.empty() ? vNew_ : 
-                       (rng_() % 2 == 0 ? vTried_ : vNew_));
+                       (rng_.RandBool() ? vTried_ : vNew_));
     
     for (const auto& key : pool) {
         auto it = mapInfo_.find(key);
@@ -380,16 +624,12 @@ std::vector<PeerAddress> AddressManager::SelectMany(size_t count, bool newOnly)
     std::vector<PeerAddress> result;
     result.reserve(count);
     
-    std::set<std::string> selected;
+    std::set<AddressKey> selected;
     
     for (size_t i = 0; i < count * 2 && result.size() < count; ++i) {
         auto addr = Select(newOnly);
-        if (addr) {
-            std::string key = static_cast<const NetAddress&>(*addr).ToString() + ":" + std::to_string(addr->GetPort());
-            if (selected.find(key) == selected.end()) {
-                result.push_back(*addr);
-                selected.insert(key);
-            }
+        if (addr && selected.insert(GetAddressKey(*addr)).second) {
+            result.push_back(*addr);
         }
     }
     
@@ -403,7 +643,7 @@ std::vector<PeerAddress> AddressManager::GetAddr(size_t count) const {
     int64_t now = GetAdjustedTime();
     
     // Collect all non-terrible addresses
-    std::vector<std::string> candidates;
+    std::vector<AddressKey> candidates;
     for (const auto& [key, info] : mapInfo_) {
         if (!info.IsTerrible(now)) {
             candidates.push_back(key);
@@ -411,8 +651,7 @@ std::vector<PeerAddress> AddressManager::GetAddr(size_t count) const {
     }
     
     // Shuffle and take up to count
-    std::shuffle(candidates.begin(), candidates.end(), 
-                 std::mt19937(std::random_device{}()));
+    std::shuffle(candidates.begin(), candidates.end(), rng_);
     
     for (size_t i = 0; i < std::min(count, candidates.size()); ++i) {
         auto it = mapInfo_.find(candidates[i]);
@@ -440,6 +679,9 @@ void AddressManager::ResolveSeeds(ResolveCallback callback) {
         return;
     }
     
+    if (resolveThread_.joinable()) {
+        resolveThread_.join();
+    }
     resolveThread_ = std::thread([this, callback]() {
         auto addresses = ResolveSeedsSync();
         if (callback) {
@@ -450,31 +692,110 @@ void AddressManager::ResolveSeeds(ResolveCallback callback) {
 
 std::vector<NetService> AddressManager::ResolveSeedsSync() {
     std::vector<NetService> result;
+    if (!running_) {
+        return result;
+    }
     
+    // Fresh cached answers need no lookup
+    auto batch = std::make_shared<SeedLookupBatch>();
     for (const auto& seed : seeds_) {
-        if (!running_) break;
-        
-        LOG_INFO(util::LogCategory::NET) << "Resolving DNS seed: " << seed.host;
-        
-        auto addresses = ResolveHost(seed.host);
-        for (const auto& addr : addresses) {
-            result.push_back(addr);
-            
-            // Also add to our address pool
-            // PeerAddress constructor: PeerAddress(NetService, time, services)
-            PeerAddress peerAddr(addr, GetAdjustedTime(), ServiceFlags::NETWORK);
+        if (auto cached = GetCachedSeed(seed.host)) {
+            LOG_DEBUG(util::LogCategory::NET) << "Using cached answer of DNS seed " << seed.host;
+            AddSeedResults(seed.host, *cached);
+            result.insert(result.end(), cached->begin(), cached->end());
+        } else {
+            SeedLookup lookup;
+            lookup.host = seed.host;
+            batch->lookups.push_back(std::move(lookup));
+        }
+    }
+    if (batch->lookups.empty()) {
+        return result;
+    }
+    
+    // One thread per lookup. A lookup that overruns the timeout is left
+    // to finish on its own; it only touches the shared batch.
+    batch->pending = batch->lookups.size();
+    for (size_t i = 0; i < batch->lookups.size(); ++i) {
+        LOG_INFO(util::LogCategory::NET) << "Resolving DNS seed: " << batch->lookups[i].host;
+        std::thread([batch, i, host = batch->lookups[i].host, port = defaultPort_]() {
+            auto addresses = ResolveHost(host, port);
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->lookups[i].addresses = std::move(addresses);
+            batch->lookups[i].done = true;
+            --batch->pending;
+            batch->cv.notify_all();
+        }).detach();
+    }
+    
+    // Take each answer as it arrives, until all are in or time is up
+    auto deadline = std::chrono::steady_clock::now() + seedTimeout_;
+    std::vector<bool> taken(batch->lookups.size(), false);
+    size_t remaining = batch->lookups.size();
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    while (remaining > 0 && running_) {
+        for (size_t i = 0; i < batch->lookups.size(); ++i) {
+            if (taken[i] || !batch->lookups[i].done) continue;
+            taken[i] = true;
+            --remaining;
+            std::string host = batch->lookups[i].host;
+            std::vector<NetService> addresses = std::move(batch->lookups[i].addresses);
             
-            Add(peerAddr, NetService(), 0);
+            lock.unlock();
+            AddSeedResults(host, addresses);
+            result.insert(result.end(), addresses.begin(), addresses.end());
+            LOG_INFO(util::LogCategory::NET) << "Resolved " << addresses.size() 
+                                             << " addresses from " << host;
+            lock.lock();
         }
         
-        LOG_INFO(util::LogCategory::NET) << "Resolved " << addresses.size() 
-                                         << " addresses from " << seed.host;
+        auto now = std::chrono::steady_clock::now();
+        if (remaining == 0 || now >= deadline) break;
+        
+        // Short waits so that Stop() is noticed
+        size_t pending = batch->pending;
+        batch->cv.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(100)),
+                             [&] { return batch->pending != pending; });
     }
     
+    for (size_t i = 0; i < batch->lookups.size(); ++i) {
+        if (!taken[i]) {
+            LOG_WARN(util::LogCategory::NET) << "DNS seed " << batch->lookups[i].host
+                                             << " did not answer in time";
+        }
+    }
     return result;
 }
 
-std::vector<NetService> AddressManager::ResolveHost(const std::string& host) const {
+std::optional<std::vector<NetService>> AddressManager::GetCachedSeed(
+    const std::string& host) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = seedCache_.find(host);
+    if (it == seedCache_.end() || it->second.expires <= GetAdjustedTime()) {
+        return std::nullopt;
+    }
+    return it->second.addresses;
+}
+
+void AddressManager::AddSeedResults(const std::string& host,
+                                    const std::vector<NetService>& addresses) {
+    // Failures are not cached, so the next attempt asks again
+    if (seedCacheTtl_ > 0 && !addresses.empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seedCache_[host] = SeedCacheEntry{addresses, GetAdjustedTime() + seedCacheTtl_};
+    }
+    
+    std::vector<PeerAddress> peerAddrs;
+    peerAddrs.reserve(addresses.size());
+    int64_t now = GetAdjustedTime();
+    for (const auto& addr : addresses) {
+        peerAddrs.emplace_back(addr, now, ServiceFlags::NETWORK);
+    }
+    Add(peerAddrs, NetService(), 0);
+}
+
+std::vector<NetService> AddressManager::ResolveHost(const std::string& host,
+                                                    uint16_t defaultPort) {
     std::vector<NetService> result;
     
     struct addrinfo hints{};
@@ -484,7 +805,7 @@ std::vector<NetService> AddressManager::ResolveHost(const std::string& host) con
     hints.ai_socktype = SOCK_STREAM;  // TCP
     hints.ai_flags = AI_ADDRCONFIG;   // Only return addresses we can use
     
-    std::string portStr = std::to_string(defaultPort_);
+    std::string portStr = std::to_string(defaultPort);
     
     int status = getaddrinfo(host.c_str(), portStr.c_str(), &hints, &res);
     if (status != 0) {
@@ -494,7 +815,7 @@ std::vector<NetService> AddressManager::ResolveHost(const std::string& host) con
     }
     
     for (struct addrinfo* p = res; p != nullptr; p = p->ai_next) {
-        uint16_t port = defaultPort_;
+        uint16_t port = defaultPort;
         
         if (p->ai_family == AF_INET) {
             // IPv4
@@ -504,7 +825,7 @@ std::vector<NetService> AddressManager::ResolveHost(const std::string& host) con
             std::memcpy(ipv4Arr.data(), ipBytes, 4);
             NetAddress addr(ipv4Arr);
             port = ntohs(ipv4->sin_port);
-            if (port == 0) port = defaultPort_;
+            if (port == 0) port = defaultPort;
             result.emplace_back(addr, port);
         } else if (p->ai_family == AF_INET6) {
             // IPv6
@@ -514,7 +835,7 @@ std::vector<NetService> AddressManager::ResolveHost(const std::string& host) con
             std::memcpy(ipv6Arr.data(), ipBytes, 16);
             NetAddress addr(ipv6Arr);
             port = ntohs(ipv6->sin6_port);
-            if (port == 0) port = defaultPort_;
+            if (port == 0) port = defaultPort;
             result.emplace_back(addr, port);
         }
     }
@@ -547,6 +868,7 @@ void AddressManager::Clear() {
     mapInfo_.clear();
     vNew_.clear();
     vTried_.clear();
+    ++changes_;
 }
 
 // ============================================================================
@@ -567,12 +889,12 @@ AddressInfo AddressManager::MakeInfo(const PeerAddress& addr, const NetService&
     return info;
 }
 
-AddressInfo* AddressManager::Find(const std::string& key) {
+AddressInfo* AddressManager::Find(const AddressKey& key) {
     auto it = mapInfo_.find(key);
     return it != mapInfo_.end() ? &it->second : nullptr;
 }
 
-const AddressInfo* AddressManager::Find(const std::string& key) const {
+const AddressInfo* AddressManager::Find(const AddressKey& key) const {
     auto it = mapInfo_.find(key);
     return it != mapInfo_.end() ? &it->second : nullptr;
 }
@@ -581,6 +903,16 @@ const AddressInfo* AddressManager::Find(const std::string& key) const {
 // Utility Functions
 // ============================================================================
 
+AddressKey GetAddressKey(const NetService& service) {
+    AddressKey key{};
+    const auto& bytes = service.GetBytes();
+    key[0] = static_cast<uint8_t>(service.GetNetwork());
+    std::memcpy(key.data() + 1, bytes.data(), std::min(bytes.size(), RECORD_ADDR_BYTES));
+    key[1 + RECORD_ADDR_BYTES] = static_cast<uint8_t>(service.GetPort() >> 8);
+    key[2 + RECORD_ADDR_BYTES] = static_cast<uint8_t>(service.GetPort());
+    return key;
+}
+
 bool IsRoutable(const NetAddress& addr) {
     // Check for local/private addresses
     auto bytes = addr.GetBytes();
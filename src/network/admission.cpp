@@ -0,0 +1,224 @@
+// SHURIUM - Inbound Connection Admission Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/network/admission.h>
+#include <shurium/core/random.h>
+#include <shurium/crypto/siphash.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace shurium {
+
+InboundAdmission::InboundAdmission(const AdmissionOptions& opts)
+    : options_(opts), k0_(GetRandUint64()), k1_(GetRandUint64()) {
+}
+
+uint64_t InboundAdmission::GroupKey(const NetAddress& addr) const {
+    std::vector<uint8_t> group = addr.GetNetGroup();
+    return SipHash13(k0_, k1_, group.data(), group.size());
+}
+
+double InboundAdmission::Refill(RateBucket& bucket, Clock::time_point now) const {
+    double minutes = std::chrono::duration<double, std::ratio<60>>(now - bucket.updated).count();
+    if (minutes > 0) {
+        bucket.tokens = std::min<double>(options_.groupConnectBurst,
+                                         bucket.tokens + minutes * options_.groupConnectsPerMinute);
+        bucket.updated = now;
+    }
+    return bucket.tokens;
+}
+
+// ============================================================================
+// Connect Rate
+// ============================================================================
+
+bool InboundAdmission::AllowConnect(const NetAddress& addr, Clock::time_point now) {
+    if (addr.IsLocal()) {
+        return true;
+    }
+    uint64_t key = GroupKey(addr);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rates_.find(key);
+    if (it == rates_.end()) {
+        if (rates_.size() >= MAX_RATE_GROUPS) {
+            // Full buckets say no more than a new one would
+            for (auto rate = rates_.begin(); rate != rates_.end();) {
+                if (Refill(rate->second, now) >= options_.groupConnectBurst) {
+                    rate = rates_.erase(rate);
+                } else {
+                    ++rate;
+                }
+            }
+            if (rates_.size() >= MAX_RATE_GROUPS) {
+                return false;
+            }
+        }
+        it = rates_.emplace(key, RateBucket{static_cast<double>(options_.groupConnectBurst), now})
+                 .first;
+    }
+
+    if (Refill(it->second, now) < 1.0) {
+        return false;
+    }
+    it->second.tokens -= 1.0;
+    return true;
+}
+
+// ============================================================================
+// Pending Handshakes
+// ============================================================================
+
+bool InboundAdmission::HasPendingSlot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_ < options_.maxPending;
+}
+
+void InboundAdmission::AddPending(Peer::Id id, const NetAddress& addr, int64_t connectedTime,
+                                  Clock::time_point now) {
+    Entry entry;
+    entry.group = GroupKey(addr);
+    entry.connectedTime = connectedTime;
+    entry.deadline = now + std::chrono::milliseconds(options_.handshakeTimeoutMs);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!entries_.emplace(id, entry).second) {
+        return;
+    }
+    deadlines_.emplace(entry.deadline, id);
+    ++pending_;
+}
+
+std::vector<Peer::Id> InboundAdmission::TakeExpired(Clock::time_point now) {
+    std::vector<Peer::Id> expired;
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+        Peer::Id id = deadlines_.begin()->second;
+        deadlines_.erase(deadlines_.begin());
+        entries_.erase(id);
+        --pending_;
+        expired.push_back(id);
+    }
+    return expired;
+}
+
+// ============================================================================
+// Eviction Rankings
+// ============================================================================
+
+void InboundAdmission::RankLocked(Peer::Id id, const Entry& entry) {
+    if (entry.metrics.pingMicros > 0) {
+        byPing_.emplace(entry.metrics.pingMicros, id);
+    }
+    if (entry.metrics.lastBlockTime > 0) {
+        byBlock_.emplace(-entry.metrics.lastBlockTime, id);
+    }
+    if (entry.metrics.lastTxTime > 0) {
+        byTx_.emplace(-entry.metrics.lastTxTime, id);
+    }
+    byUptime_.emplace(entry.connectedTime, id);
+
+    Ranking& group = groups_[entry.group];
+    groupsBySize_.erase({group.size(), entry.group});
+    group.emplace(entry.connectedTime, id);
+    groupsBySize_.emplace(group.size(), entry.group);
+}
+
+void InboundAdmission::UnrankLocked(Peer::Id id, const Entry& entry) {
+    byPing_.erase({entry.metrics.pingMicros, id});
+    byBlock_.erase({-entry.metrics.lastBlockTime, id});
+    byTx_.erase({-entry.metrics.lastTxTime, id});
+    byUptime_.erase({entry.connectedTime, id});
+
+    auto it = groups_.find(entry.group);
+    if (it == groups_.end()) {
+        return;
+    }
+    groupsBySize_.erase({it->second.size(), entry.group});
+    it->second.erase({entry.connectedTime, id});
+    if (it->second.empty()) {
+        groups_.erase(it);
+    } else {
+        groupsBySize_.emplace(it->second.size(), entry.group);
+    }
+}
+
+void InboundAdmission::Update(Peer::Id id, const EvictionMetrics& metrics) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(id);
+    if (it == entries_.end()) {
+        return;
+    }
+    Entry& entry = it->second;
+    if (entry.pending) {
+        entry.pending = false;
+        deadlines_.erase({entry.deadline, id});
+        --pending_;
+    } else {
+        UnrankLocked(id, entry);
+    }
+    entry.metrics = metrics;
+    RankLocked(id, entry);
+}
+
+void InboundAdmission::Remove(Peer::Id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(id);
+    if (it == entries_.end()) {
+        return;
+    }
+    if (it->second.pending) {
+        deadlines_.erase({it->second.deadline, id});
+        --pending_;
+    } else {
+        UnrankLocked(id, it->second);
+    }
+    entries_.erase(it);
+}
+
+Peer::Id InboundAdmission::SelectForEviction() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // At most the sum of the protect counts: each ranking is read only at
+    // its front
+    std::unordered_set<Peer::Id> protect;
+    auto protectFront = [&protect](const Ranking& ranking, size_t count) {
+        for (auto it = ranking.begin(); it != ranking.end() && count > 0; ++it, --count) {
+            protect.insert(it->second);
+        }
+    };
+    size_t groups = options_.protectByGroup;
+    for (auto it = groups_.begin(); it != groups_.end() && groups > 0; ++it, --groups) {
+        protect.insert(it->second.begin()->second);
+    }
+    protectFront(byPing_, options_.protectByPing);
+    protectFront(byTx_, options_.protectByTx);
+    protectFront(byBlock_, options_.protectByBlock);
+    protectFront(byUptime_, options_.protectByUptime);
+
+    // Largest netgroup first, its newest peer first. Only protected peers
+    // are skipped, so this too stops after a bounded number of steps.
+    for (auto size = groupsBySize_.rbegin(); size != groupsBySize_.rend(); ++size) {
+        const Ranking& group = groups_.at(size->second);
+        for (auto member = group.rbegin(); member != group.rend(); ++member) {
+            if (protect.count(member->second) == 0) {
+                return member->second;
+            }
+        }
+    }
+    return -1;
+}
+
+size_t InboundAdmission::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+size_t InboundAdmission::GetCandidateCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size() - pending_;
+}
+
+} // namespace shurium
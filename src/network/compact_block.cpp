@@ -0,0 +1,175 @@
+// SHURIUM - Compact Blocks Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/network/compact_block.h>
+#include <shurium/crypto/sha256.h>
+#include <shurium/crypto/siphash.h>
+#include <shurium/mempool/mempool.h>
+
+#include <unordered_map>
+
+namespace shurium {
+
+namespace {
+
+/// Short ids keep the low 48 bits
+constexpr uint64_t SHORT_TXID_MASK = 0xffffffffffffULL;
+
+uint64_t ReadLE64(const Byte* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// CompactBlock
+// ============================================================================
+
+CompactBlock::CompactBlock(const Block& block, uint64_t nonceIn)
+    : header(block.GetBlockHeader()), nonce(nonceIn) {
+    FillKey();
+    if (block.vtx.empty()) {
+        return;
+    }
+    
+    // The coinbase is never in anyone's mempool
+    prefilled.push_back(PrefilledTransaction{0, block.vtx[0]});
+    shortIds.reserve(block.vtx.size() - 1);
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        shortIds.push_back(GetShortId(block.vtx[i]->GetHash()));
+    }
+}
+
+void CompactBlock::FillKey() {
+    DataStream stream;
+    ::shurium::Serialize(stream, header);
+    ::shurium::Serialize(stream, nonce);
+    std::vector<Byte> data(stream.begin(), stream.end());
+    Hash256 key = SHA256Hash(data);
+    k0_ = ReadLE64(key.data());
+    k1_ = ReadLE64(key.data() + 8);
+}
+
+uint64_t CompactBlock::GetShortId(const TxHash& txid) const {
+    return SipHash24(k0_, k1_, txid.data(), txid.size()) & SHORT_TXID_MASK;
+}
+
+// ============================================================================
+// PartiallyDownloadedBlock
+// ============================================================================
+
+CompactReadStatus PartiallyDownloadedBlock::Init(const CompactBlock& cmpct,
+                                                 const Mempool* mempool,
+                                                 const std::vector<TransactionRef>& extraTxs) {
+    if (cmpct.header.IsNull() || (cmpct.shortIds.empty() && cmpct.prefilled.empty())) {
+        return CompactReadStatus::INVALID;
+    }
+    if (cmpct.GetTxCount() > MAX_COMPACT_BLOCK_TXS) {
+        return CompactReadStatus::INVALID;
+    }
+    
+    header_ = cmpct.header;
+    txs_.assign(cmpct.GetTxCount(), nullptr);
+    mempoolCount_ = 0;
+    
+    // Prefilled transactions take their slots; the short ids fill the
+    // remaining ones in order
+    for (const auto& p : cmpct.prefilled) {
+        if (p.index >= txs_.size() || !p.tx) {
+            return CompactReadStatus::INVALID;
+        }
+        txs_[p.index] = p.tx;
+    }
+    
+    std::unordered_map<uint64_t, size_t> slots;
+    slots.reserve(cmpct.shortIds.size());
+    size_t next = 0;
+    for (uint64_t id : cmpct.shortIds) {
+        while (txs_[next]) {
+            ++next;
+        }
+        // Two transactions of one block sharing an id: we cannot tell
+        // which is which
+        if (!slots.emplace(id, next++).second) {
+            return CompactReadStatus::FAILED;
+        }
+    }
+    
+    // A slot two candidates map to is left for getblocktxn
+    std::vector<bool> ambiguous(txs_.size(), false);
+    auto offer = [&](const TransactionRef& tx) {
+        auto it = slots.find(cmpct.GetShortId(tx->GetHash()));
+        if (it == slots.end() || ambiguous[it->second]) {
+            return;
+        }
+        TransactionRef& slot = txs_[it->second];
+        if (!slot) {
+            slot = tx;
+            ++mempoolCount_;
+        } else if (slot->GetHash() != tx->GetHash()) {
+            slot = nullptr;
+            ambiguous[it->second] = true;
+            --mempoolCount_;
+        }
+    };
+    
+    if (mempool) {
+        auto snapshot = mempool->GetSnapshot();
+        for (const auto& info : snapshot->txs) {
+            offer(info.tx);
+        }
+    }
+    for (const auto& tx : extraTxs) {
+        if (tx) {
+            offer(tx);
+        }
+    }
+    
+    return CompactReadStatus::OK;
+}
+
+std::vector<uint16_t> PartiallyDownloadedBlock::GetMissingIndexes() const {
+    std::vector<uint16_t> missing;
+    for (size_t i = 0; i < txs_.size(); ++i) {
+        if (!txs_[i]) {
+            missing.push_back(static_cast<uint16_t>(i));
+        }
+    }
+    return missing;
+}
+
+CompactReadStatus PartiallyDownloadedBlock::FillBlock(
+    Block& block, const std::vector<TransactionRef>& missing) const {
+    if (header_.IsNull()) {
+        return CompactReadStatus::INVALID;
+    }
+    
+    block = Block(header_);
+    block.vtx.reserve(txs_.size());
+    size_t used = 0;
+    for (const auto& tx : txs_) {
+        if (tx) {
+            block.vtx.push_back(tx);
+        } else if (used < missing.size() && missing[used]) {
+            block.vtx.push_back(missing[used++]);
+        } else {
+            return CompactReadStatus::INVALID;
+        }
+    }
+    if (used != missing.size()) {
+        return CompactReadStatus::INVALID;
+    }
+    
+    // A wrong mempool match (a 48-bit collision) shows up here
+    if (block.ComputeMerkleRoot() != header_.hashMerkleRoot) {
+        return CompactReadStatus::FAILED;
+    }
+    return CompactReadStatus::OK;
+}
+
+} // namespace shurium
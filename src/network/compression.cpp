@@ -0,0 +1,256 @@
+// SHURIUM - Message Compression Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/network/compression.h>
+#include <shurium/network/protocol.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace shurium {
+
+namespace {
+
+// ============================================================================
+// LZ4 Block Format
+// ============================================================================
+
+/// Shortest match a sequence can encode
+constexpr size_t MIN_MATCH = 4;
+
+/// The last match must start this far before the end of the input...
+constexpr size_t MFLIMIT = 12;
+
+/// ...and the last this many bytes are always literals
+constexpr size_t LAST_LITERALS = 5;
+
+/// Matches reach back at most this far (the offset is 16 bits)
+constexpr size_t MAX_DISTANCE = 65535;
+
+constexpr int HASH_LOG = 12;
+
+inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t HashSequence(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+/// Length above 15 in the token spills into bytes of 255 and a remainder
+void WriteLength(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength,
+                   size_t offset, size_t matchLength) {
+    uint8_t token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+    size_t matchCode = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+    if (matchLength > 0) {
+        token |= static_cast<uint8_t>(std::min<size_t>(matchCode, 15));
+    }
+    out.push_back(token);
+    if (literalLength >= 15) {
+        WriteLength(out, literalLength - 15);
+    }
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength == 0) {
+        return;
+    }
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15) {
+        WriteLength(out, matchCode - 15);
+    }
+}
+
+/// Read a spilled length; false if the input runs out
+bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in == end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Policy
+// ============================================================================
+
+CompressionPolicy CompressionPolicy::Default() {
+    CompressionPolicy policy;
+    policy.commands = {
+        NetMsgType::BLOCK,
+        NetMsgType::HEADERS,
+        NetMsgType::CMPCTBLOCK,
+        NetMsgType::BLOCKTXN,
+        NetMsgType::ADDR,
+        NetMsgType::ADDRV2,
+        NetMsgType::POUWPROB,
+        NetMsgType::POUWSOL,
+    };
+    return policy;
+}
+
+// ============================================================================
+// LZ4
+// ============================================================================
+
+std::vector<uint8_t> LZ4Compress(const uint8_t* data, size_t size) {
+    std::vector<uint8_t> out;
+    out.reserve(size + size / 255 + 16);
+
+    const uint8_t* anchor = data;
+    if (size >= MFLIMIT + 1) {
+        // Positions (+1, so 0 means empty) of the last sequence with each hash
+        std::vector<uint32_t> table(size_t(1) << HASH_LOG, 0);
+        const uint8_t* const matchLimit = data + size - MFLIMIT;
+        const uint8_t* const copyLimit = data + size - LAST_LITERALS;
+
+        const uint8_t* ip = data;
+        while (ip < matchLimit) {
+            uint32_t sequence = Read32(ip);
+            uint32_t& slot = table[HashSequence(sequence)];
+            const uint8_t* candidate = slot ? data + (slot - 1) : nullptr;
+            slot = static_cast<uint32_t>(ip - data) + 1;
+
+            if (!candidate || static_cast<size_t>(ip - candidate) > MAX_DISTANCE ||
+                Read32(candidate) != sequence) {
+                ++ip;
+                continue;
+            }
+
+            // Extend backwards over literals and forwards up to the limit
+            while (ip > anchor && candidate > data && ip[-1] == candidate[-1]) {
+                --ip;
+                --candidate;
+            }
+            const uint8_t* matchEnd = ip + MIN_MATCH;
+            const uint8_t* from = candidate + MIN_MATCH;
+            while (matchEnd < copyLimit && *matchEnd == *from) {
+                ++matchEnd;
+                ++from;
+            }
+
+            WriteSequence(out, anchor, static_cast<size_t>(ip - anchor),
+                          static_cast<size_t>(ip - candidate),
+                          static_cast<size_t>(matchEnd - ip));
+            ip = matchEnd;
+            anchor = ip;
+            if (ip < matchLimit) {
+                table[HashSequence(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - data) + 1;
+            }
+        }
+    }
+
+    // Everything left goes out as literals
+    WriteSequence(out, anchor, static_cast<size_t>(data + size - anchor), 0, 0);
+    return out;
+}
+
+std::optional<std::vector<uint8_t>> LZ4Decompress(const uint8_t* data, size_t size,
+                                                  size_t rawSize) {
+    // rawSize is the peer's word; one input byte expands to at most 255
+    std::vector<uint8_t> out;
+    out.reserve(std::min(rawSize, 255 * size));
+
+    const uint8_t* in = data;
+    const uint8_t* const end = data + size;
+    while (in < end) {
+        uint8_t token = *in++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !ReadLength(in, end, literalLength)) {
+            return std::nullopt;
+        }
+        if (literalLength > static_cast<size_t>(end - in) ||
+            literalLength > rawSize - out.size()) {
+            return std::nullopt;
+        }
+        out.insert(out.end(), in, in + literalLength);
+        in += literalLength;
+
+        // The last sequence has no match
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return std::nullopt;
+        }
+        size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > out.size()) {
+            return std::nullopt;
+        }
+
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !ReadLength(in, end, matchLength)) {
+            return std::nullopt;
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > rawSize - out.size()) {
+            return std::nullopt;
+        }
+
+        // Byte by byte: a match may overlap the bytes it is producing
+        size_t from = out.size() - offset;
+        for (size_t i = 0; i < matchLength; ++i) {
+            out.push_back(out[from + i]);
+        }
+    }
+
+    if (out.size() != rawSize) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+// ============================================================================
+// Payload Framing
+// ============================================================================
+
+std::optional<std::vector<uint8_t>> CompressPayload(const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> block = LZ4Compress(payload.data(), payload.size());
+    if (block.size() + sizeof(uint32_t) >= payload.size()) {
+        return std::nullopt;
+    }
+
+    std::vector<uint8_t> out;
+    out.reserve(sizeof(uint32_t) + block.size());
+    uint32_t rawSize = static_cast<uint32_t>(payload.size());
+    for (size_t i = 0; i < sizeof(rawSize); ++i) {
+        out.push_back(static_cast<uint8_t>(rawSize >> (8 * i)));
+    }
+    out.insert(out.end(), block.begin(), block.end());
+    return out;
+}
+
+std::optional<std::vector<uint8_t>> DecompressPayload(const std::vector<uint8_t>& payload,
+                                                      size_t maxSize) {
+    if (payload.size() < sizeof(uint32_t)) {
+        return std::nullopt;
+    }
+    uint32_t rawSize = 0;
+    for (size_t i = 0; i < sizeof(rawSize); ++i) {
+        rawSize |= static_cast<uint32_t>(payload[i]) << (8 * i);
+    }
+    if (rawSize > maxSize) {
+        return std::nullopt;
+    }
+    return LZ4Decompress(payload.data() + sizeof(uint32_t),
+                         payload.size() - sizeof(uint32_t), rawSize);
+}
+
+} // namespace shurium
@@ -5,9 +5,13 @@
 #include <shurium/network/connection.h>
 #include <shurium/network/peer.h>
 #include <shurium/core/types.h>
+#include <shurium/util/affinity.h>
+#include <shurium/util/iouring.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <deque>
 #include <stdexcept>
 
 // Platform-specific includes
@@ -23,10 +27,22 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <errno.h>
 #endif
 
+// Persistent, edge-triggered readiness where the platform has it
+#if defined(__linux__)
+#define SHURIUM_HAVE_EPOLL 1
+#include <sys/epoll.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || \
+      defined(__NetBSD__) || defined(__DragonFly__)
+#define SHURIUM_HAVE_KQUEUE 1
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
 namespace shurium {
 
 // ============================================================================
@@ -108,21 +124,165 @@ bool SetKeepAlive(SocketHandle socket, bool enable, int idle, int interval, int
     return true;
 }
 
+/// Buffers handed to one gather write
+constexpr size_t MAX_SEND_SEGMENTS = 64;
+
+/// Write several runs of bytes with one call
+ssize_t GatherSend(SocketHandle socket, const SendQueue::Segment* segments, size_t count) {
+#ifdef _WIN32
+    WSABUF buffers[MAX_SEND_SEGMENTS];
+    for (size_t i = 0; i < count; ++i) {
+        buffers[i].buf = reinterpret_cast<CHAR*>(const_cast<uint8_t*>(segments[i].data));
+        buffers[i].len = static_cast<ULONG>(segments[i].size);
+    }
+    DWORD sent = 0;
+    if (WSASend(socket, buffers, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) != 0) {
+        return -1;
+    }
+    return static_cast<ssize_t>(sent);
+#else
+    struct iovec iov[MAX_SEND_SEGMENTS];
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = const_cast<uint8_t*>(segments[i].data);
+        iov[i].iov_len = segments[i].size;
+    }
+    struct msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return sendmsg(socket, &msg, 0);
+#endif
+}
+
+/// Segments at least this large go out zero-copy when the event loop has a
+/// ring that can do it. Below that, pinning the pages costs more than the
+/// copy, so in practice this picks out block payloads.
+constexpr size_t ZERO_COPY_SEND_MIN = 64 * 1024;
+
+/// Send one segment zero-copy: bytes sent, or -errno. -EOPNOTSUPP if the
+/// segment does not qualify or the ring cannot, for GatherSend to take it.
+int64_t ZeroCopySend(util::IoRing* ring, SocketHandle socket, const SendQueue::Segment& segment) {
+#ifdef SHURIUM_IO_URING
+    if (!ring || !segment.buffer || segment.size < ZERO_COPY_SEND_MIN ||
+        !ring->Supports(util::IoRing::Op::SEND_ZC)) {
+        return -EOPNOTSUPP;
+    }
+    uint32_t len = static_cast<uint32_t>(std::min<size_t>(segment.size, UINT32_MAX));
+    return ring->SendZeroCopy(socket, segment.data, len, MSG_DONTWAIT | MSG_NOSIGNAL,
+                              *segment.buffer);
+#else
+    (void)ring;
+    (void)socket;
+    (void)segment;
+    return -EOPNOTSUPP;
+#endif
+}
+
 } // anonymous namespace
 
+// ============================================================================
+// Send Shaping
+// ============================================================================
+
+TokenBucket::TokenBucket(uint64_t rate, uint64_t burst)
+    : rate_(rate), burst_(burst > 0 ? burst : rate), tokens_(static_cast<double>(burst_)) {
+}
+
+void TokenBucket::SetRate(uint64_t rate, uint64_t burst) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rate_ = rate;
+    burst_ = burst > 0 ? burst : rate;
+    if (!started_ || tokens_ > static_cast<double>(burst_)) {
+        tokens_ = static_cast<double>(burst_);
+    }
+}
+
+void TokenBucket::Refill(Clock::time_point now) {
+    if (!started_) {
+        started_ = true;
+        last_ = now;
+        return;
+    }
+    if (now <= last_) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - last_).count();
+    tokens_ = std::min(static_cast<double>(burst_),
+                       tokens_ + elapsed * static_cast<double>(rate_.load()));
+    last_ = now;
+}
+
+size_t TokenBucket::Available(Clock::time_point now) {
+    if (!IsLimited()) {
+        return SIZE_MAX;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Refill(now);
+    return tokens_ >= 1.0 ? static_cast<size_t>(tokens_) : 0;
+}
+
+void TokenBucket::Consume(size_t bytes, Clock::time_point now) {
+    if (!IsLimited()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Refill(now);
+    tokens_ -= static_cast<double>(bytes);
+}
+
+void UploadTarget::Roll(int64_t now) const {
+    if (now >= cycleStart_ + CYCLE_SECONDS) {
+        cycleStart_ = now;
+        sent_ = 0;
+    }
+}
+
+void UploadTarget::RecordSent(uint64_t bytes, int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Roll(now);
+    sent_ += bytes;
+}
+
+bool UploadTarget::IsReached(int64_t now) const {
+    if (target_ == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Roll(now);
+    return sent_ >= target_;
+}
+
+uint64_t UploadTarget::GetBytesSent(int64_t now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Roll(now);
+    return sent_;
+}
+
+uint64_t UploadTarget::GetBytesLeft(int64_t now) const {
+    if (target_ == 0) {
+        return UINT64_MAX;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Roll(now);
+    return sent_ >= target_ ? 0 : target_ - sent_;
+}
+
+int64_t UploadTarget::GetTimeLeftInCycle(int64_t now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Roll(now);
+    return cycleStart_ + CYCLE_SECONDS - now;
+}
+
 // ============================================================================
 // Connection Implementation
 // ============================================================================
 
 Connection::Connection(const NetService& addr, const ConnectionOptions& opts)
-    : remoteAddr_(addr), options_(opts) {
-    sendBuffer_.reserve(opts.writeBufferSize);
+    : remoteAddr_(addr), options_(opts), sendLimit_(opts.maxSendRate) {
     recvBuffer_.reserve(opts.readBufferSize);
 }
 
 Connection::Connection(SocketHandle socket, const NetService& addr, const ConnectionOptions& opts)
-    : socket_(socket), remoteAddr_(addr), options_(opts) {
-    sendBuffer_.reserve(opts.writeBufferSize);
+    : socket_(socket), remoteAddr_(addr), options_(opts), sendLimit_(opts.maxSendRate) {
     recvBuffer_.reserve(opts.readBufferSize);
     state_ = ConnState::CONNECTED;
     connectTime_ = std::chrono::steady_clock::now();
@@ -316,19 +476,68 @@ size_t Connection::Send(const uint8_t* data, size_t len) {
     
     std::lock_guard<std::mutex> lock(sendMutex_);
     
-    size_t space = options_.writeBufferSize - sendBuffer_.size();
+    size_t queued = sendQueue_.Size();
+    size_t space = options_.writeBufferSize > queued ? options_.writeBufferSize - queued : 0;
     size_t toQueue = std::min(len, space);
     
-    sendBuffer_.insert(sendBuffer_.end(), data, data + toQueue);
+    bool wasEmpty = sendQueue_.Empty();
+    sendQueue_.Push(std::make_shared<const std::vector<uint8_t>>(data, data + toQueue));
+    RecordNetworkCopy(toQueue);
+    NotifyQueued(wasEmpty);
     return toQueue;
 }
 
+void Connection::Send(SendBuffer buffer) {
+    if (state_ != ConnState::CONNECTED && state_ != ConnState::CONNECTING) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    bool wasEmpty = sendQueue_.Empty();
+    sendQueue_.Push(std::move(buffer));
+    NotifyQueued(wasEmpty);
+}
+
+size_t Connection::SendFrom(Peer& peer) {
+    if (state_ != ConnState::CONNECTED && state_ != ConnState::CONNECTING) {
+        return 0;
+    }
+    
+    SendQueue taken = peer.TakeSendQueue();
+    size_t bytes = taken.Size();
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    bool wasEmpty = sendQueue_.Empty();
+    sendQueue_.Append(std::move(taken));
+    NotifyQueued(wasEmpty);
+    return bytes;
+}
+
+void Connection::SetSendShaping(const ConnectionOptions& opts) {
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    options_.maxSendRate = opts.maxSendRate;
+    options_.sharedSendLimit = opts.sharedSendLimit;
+    options_.uploadTarget = opts.uploadTarget;
+    sendLimit_.SetRate(opts.maxSendRate);
+}
+
+void Connection::SetWriteRequestCallback(WriteRequestCallback cb) {
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    writeRequestCallback_ = std::move(cb);
+}
+
+void Connection::NotifyQueued(bool wasEmpty) {
+    if (wasEmpty && !sendQueue_.Empty() && writeRequestCallback_) {
+        writeRequestCallback_(*this);
+    }
+}
+
 size_t Connection::Recv(uint8_t* buffer, size_t maxLen) {
     std::lock_guard<std::mutex> lock(recvMutex_);
     
     size_t toRead = std::min(maxLen, recvBuffer_.size());
     if (toRead > 0) {
         std::memcpy(buffer, recvBuffer_.data(), toRead);
+        RecordNetworkCopy(toRead);
         recvBuffer_.erase(recvBuffer_.begin(), recvBuffer_.begin() + toRead);
     }
     return toRead;
@@ -341,9 +550,17 @@ std::vector<uint8_t> Connection::RecvAll() {
     return result;
 }
 
+size_t Connection::RecvInto(Peer& peer) {
+    std::lock_guard<std::mutex> lock(recvMutex_);
+    size_t len = recvBuffer_.size();
+    peer.AddReceivedData(recvBuffer_.data(), len);
+    recvBuffer_.clear();
+    return len;
+}
+
 size_t Connection::GetSendBufferSize() const {
     std::lock_guard<std::mutex> lock(sendMutex_);
-    return sendBuffer_.size() - sendOffset_;
+    return sendQueue_.Size();
 }
 
 size_t Connection::GetRecvBufferSize() const {
@@ -358,16 +575,7 @@ void Connection::OnReadable() {
     while (true) {
         ssize_t n = recv(socket_, reinterpret_cast<char*>(buffer), sizeof(buffer), 0);
         if (n > 0) {
-            {
-                std::lock_guard<std::mutex> lock(recvMutex_);
-                recvBuffer_.insert(recvBuffer_.end(), buffer, buffer + n);
-            }
-            bytesRecv_ += n;
-            lastActivity_ = std::chrono::steady_clock::now();
-            
-            if (dataCallback_) {
-                dataCallback_(*this, buffer, n);
-            }
+            DeliverReceived(buffer, static_cast<size_t>(n));
         } else if (n == 0) {
             // Connection closed by peer
             Close(false);
@@ -389,35 +597,104 @@ void Connection::OnReadable() {
     }
 }
 
-void Connection::OnWritable() {
+void Connection::OnReadResult(const uint8_t* data, int64_t result) {
+    if (socket_ == INVALID_SOCKET_HANDLE) return;
+    
+    if (result > 0) {
+        DeliverReceived(data, static_cast<size_t>(result));
+        if (eventCallback_) {
+            eventCallback_(*this, ConnEvent::DATA_RECEIVED);
+        }
+    } else if (result == 0) {
+        Close(false);
+    } else if (!WouldBlock(static_cast<int>(-result))) {
+        OnError(static_cast<int>(-result));
+    }
+}
+
+void Connection::DeliverReceived(const uint8_t* data, size_t len) {
+    {
+        std::lock_guard<std::mutex> lock(recvMutex_);
+        recvBuffer_.insert(recvBuffer_.end(), data, data + len);
+    }
+    RecordNetworkCopy(len);
+    bytesRecv_ += len;
+    lastActivity_ = std::chrono::steady_clock::now();
+    
+    if (dataCallback_) {
+        dataCallback_(*this, data, len);
+    }
+}
+
+void Connection::OnWritable(util::IoRing* ring) {
     if (socket_ == INVALID_SOCKET_HANDLE) return;
     
     std::lock_guard<std::mutex> lock(sendMutex_);
     
-    while (sendOffset_ < sendBuffer_.size()) {
-        size_t remaining = sendBuffer_.size() - sendOffset_;
-        ssize_t n = send(socket_, 
-                         reinterpret_cast<const char*>(sendBuffer_.data() + sendOffset_),
-                         remaining, 0);
+    // Queued buffers go out as they are, several per call, as far as the
+    // rate limits allow. The most urgent class goes first and is exempt.
+    SendQueue::Segment segments[MAX_SEND_SEGMENTS];
+    bool throttled = false;
+    while (!sendQueue_.Empty()) {
+        auto now = std::chrono::steady_clock::now();
+        size_t allowance = SIZE_MAX;
+        if (sendQueue_.Current() != SendPriority::HIGH) {
+            allowance = sendLimit_.Available(now);
+            if (options_.sharedSendLimit) {
+                allowance = std::min(allowance, options_.sharedSendLimit->Available(now));
+            }
+            if (allowance == 0) {
+                throttled = true;
+                break;
+            }
+        }
+        
+        size_t count = sendQueue_.Peek(segments, MAX_SEND_SEGMENTS);
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (segments[i].size >= allowance - total) {
+                segments[i].size = allowance - total;
+                count = i + 1;
+                break;
+            }
+            total += segments[i].size;
+        }
+        
+        // A large buffer at the front goes out alone, zero-copy; the kernel
+        // keeps it alive through the segment's shared pointer
+        ssize_t n;
+        int err = 0;
+        int64_t zeroCopy = ZeroCopySend(ring, socket_, segments[0]);
+        if (zeroCopy != -EOPNOTSUPP) {
+            n = zeroCopy < 0 ? -1 : static_cast<ssize_t>(zeroCopy);
+            err = zeroCopy < 0 ? static_cast<int>(-zeroCopy) : 0;
+        } else {
+            n = GatherSend(socket_, segments, count);
+            err = n < 0 ? GetLastSocketError() : 0;
+        }
         if (n > 0) {
-            sendOffset_ += n;
+            size_t sent = static_cast<size_t>(n);
+            sendQueue_.Consume(sent);
+            sendLimit_.Consume(sent, now);
+            if (options_.sharedSendLimit) {
+                options_.sharedSendLimit->Consume(sent, now);
+            }
+            if (options_.uploadTarget) {
+                options_.uploadTarget->RecordSent(sent, GetTime());
+            }
             bytesSent_ += n;
-            lastActivity_ = std::chrono::steady_clock::now();
+            lastActivity_ = now;
         } else if (n < 0) {
-            int err = GetLastSocketError();
             if (WouldBlock(err)) {
                 break;
             }
             OnError(err);
             return;
+        } else {
+            break;
         }
     }
-    
-    // Compact buffer if we've sent a lot
-    if (sendOffset_ > sendBuffer_.size() / 2) {
-        sendBuffer_.erase(sendBuffer_.begin(), sendBuffer_.begin() + sendOffset_);
-        sendOffset_ = 0;
-    }
+    sendThrottled_ = throttled;
     
     if (eventCallback_) {
         eventCallback_(*this, ConnEvent::DATA_SENT);
@@ -487,12 +764,19 @@ bool Listener::Start(int backlog) {
         addr6->sin6_family = AF_INET6;
         addr6->sin6_port = htons(port_);
         addr6->sin6_addr = in6addr_any;
+        if (bindAddr_.GetBytes().size() == 16) {
+            std::memcpy(&addr6->sin6_addr, bindAddr_.GetBytes().data(), 16);
+        }
         addrLen = sizeof(struct sockaddr_in6);
     } else {
         auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&addr);
         addr4->sin_family = AF_INET;
         addr4->sin_port = htons(port_);
         addr4->sin_addr.s_addr = INADDR_ANY;
+        // A specific address binds to that interface only
+        if (bindAddr_.IsIPv4() && bindAddr_.GetBytes().size() == 4) {
+            std::memcpy(&addr4->sin_addr, bindAddr_.GetBytes().data(), 4);
+        }
         addrLen = sizeof(struct sockaddr_in);
     }
     
@@ -508,6 +792,16 @@ bool Listener::Start(int backlog) {
         return false;
     }
     
+    // Port 0 asks the system for a free port; remember which one it gave
+    if (port_ == 0) {
+        addrLen = sizeof(addr);
+        if (getsockname(socket_, reinterpret_cast<struct sockaddr*>(&addr), &addrLen) == 0) {
+            port_ = ntohs(family == AF_INET6
+                ? reinterpret_cast<struct sockaddr_in6*>(&addr)->sin6_port
+                : reinterpret_cast<struct sockaddr_in*>(&addr)->sin_port);
+        }
+    }
+    
     listening_ = true;
     return true;
 }
@@ -525,54 +819,192 @@ NetService Listener::GetListenAddress() const {
 }
 
 void Listener::OnAccept() {
-    if (!listening_ || socket_ == INVALID_SOCKET_HANDLE) return;
-    
-    struct sockaddr_storage addr;
-    socklen_t addrLen = sizeof(addr);
-    
-    SocketHandle clientSocket = accept(socket_, 
-                                        reinterpret_cast<struct sockaddr*>(&addr),
-                                        &addrLen);
-    if (clientSocket == INVALID_SOCKET_HANDLE) {
-        return;
-    }
-    
-    // Extract remote address
-    NetService remoteAddr;
-    if (addr.ss_family == AF_INET6) {
-        auto* addr6 = reinterpret_cast<struct sockaddr_in6*>(&addr);
-        std::array<uint8_t, 16> bytes;
-        std::memcpy(bytes.data(), &addr6->sin6_addr, 16);
-        remoteAddr = NetService(NetAddress(bytes), ntohs(addr6->sin6_port));
-    } else {
-        auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&addr);
-        uint32_t ip = ntohl(addr4->sin_addr.s_addr);
-        std::array<uint8_t, 4> ipv4 = {
-            static_cast<uint8_t>((ip >> 24) & 0xff),
-            static_cast<uint8_t>((ip >> 16) & 0xff),
-            static_cast<uint8_t>((ip >> 8) & 0xff),
-            static_cast<uint8_t>(ip & 0xff)
-        };
-        remoteAddr = NetService(NetAddress(ipv4), ntohs(addr4->sin_port));
-    }
-    
-    auto conn = Connection::FromSocket(clientSocket, remoteAddr);
-    if (acceptCallback_) {
-        acceptCallback_(std::move(conn));
+    // Drain the backlog: edge-triggered loops report it only once
+    while (listening_ && socket_ != INVALID_SOCKET_HANDLE) {
+        struct sockaddr_storage addr;
+        socklen_t addrLen = sizeof(addr);
+        
+        SocketHandle clientSocket = accept(socket_, 
+                                            reinterpret_cast<struct sockaddr*>(&addr),
+                                            &addrLen);
+        if (clientSocket == INVALID_SOCKET_HANDLE) {
+#ifndef _WIN32
+            int err = GetLastSocketError();
+            if (err == EINTR || err == ECONNABORTED) {
+                continue;
+            }
+#endif
+            return;
+        }
+        
+        // Extract remote address
+        NetService remoteAddr;
+        if (addr.ss_family == AF_INET6) {
+            auto* addr6 = reinterpret_cast<struct sockaddr_in6*>(&addr);
+            std::array<uint8_t, 16> bytes;
+            std::memcpy(bytes.data(), &addr6->sin6_addr, 16);
+            remoteAddr = NetService(NetAddress(bytes), ntohs(addr6->sin6_port));
+        } else {
+            auto* addr4 = reinterpret_cast<struct sockaddr_in*>(&addr);
+            uint32_t ip = ntohl(addr4->sin_addr.s_addr);
+            std::array<uint8_t, 4> ipv4 = {
+                static_cast<uint8_t>((ip >> 24) & 0xff),
+                static_cast<uint8_t>((ip >> 16) & 0xff),
+                static_cast<uint8_t>((ip >> 8) & 0xff),
+                static_cast<uint8_t>(ip & 0xff)
+            };
+            remoteAddr = NetService(NetAddress(ipv4), ntohs(addr4->sin_port));
+        }
+        
+        if (filterCallback_ && !filterCallback_(remoteAddr)) {
+            CloseSocket(clientSocket);
+            continue;
+        }
+        
+        auto conn = Connection::FromSocket(clientSocket, remoteAddr);
+        if (acceptCallback_) {
+            acceptCallback_(std::move(conn));
+        }
     }
 }
 
 // ============================================================================
-// EventLoop Implementation (using poll)
+// EventLoop Implementation
 // ============================================================================
 
+namespace {
+
+/// Events collected per epoll_wait/kevent call
+constexpr int MAX_EVENTS_PER_WAIT = 256;
+
+/// Sockets read per ring submission, and the registered buffer each reads
+/// into. A read that fills its buffer is finished with recv().
+constexpr size_t RING_READS_PER_BATCH = 32;
+constexpr size_t RING_READ_BUFFER_SIZE = 16 * 1024;
+
+} // anonymous namespace
+
+const char* EventBackendName(EventBackend backend) {
+    switch (backend) {
+        case EventBackend::POLL: return "poll";
+        case EventBackend::EPOLL: return "epoll";
+        case EventBackend::KQUEUE: return "kqueue";
+    }
+    return "unknown";
+}
+
+EventBackend DefaultEventBackend() {
+#if defined(SHURIUM_HAVE_EPOLL)
+    return EventBackend::EPOLL;
+#elif defined(SHURIUM_HAVE_KQUEUE)
+    return EventBackend::KQUEUE;
+#else
+    return EventBackend::POLL;
+#endif
+}
+
 struct EventLoop::Impl {
+    EventBackend backend{EventBackend::POLL};
+    
+    /// epoll or kqueue descriptor
+    int eventFd{-1};
+    
+    /// poll backend only: rebuilt every iteration
     std::vector<struct pollfd> pollFds;
+    
     std::unordered_map<SocketHandle, Connection*> connections;
     std::unordered_map<SocketHandle, Listener*> listeners;
+    
+    /// Connections whose idle send queue gained data (edge-triggered
+    /// backends only)
+    std::mutex writeMutex;
+    std::deque<Connection*> requestedWrites;
+    
+    /// Connections a rate limit stopped with data left (any backend)
+    std::deque<Connection*> throttledWrites;
+    
+    /// io_uring for batched reads and zero-copy sends (epoll backend, in
+    /// io_uring builds on kernels that have it), with its read buffers
+    std::unique_ptr<util::IoRing> ring;
+    std::vector<uint8_t> ringBuffers;
+    
+    /// Tags each ReadReady batch, so a completion left over from a failed
+    /// wait is never taken for one of a later batch
+    uint64_t ringBatch{0};
+    
+    /// Register a socket once for the lifetime of its membership
+    void Register(SocketHandle sock, bool writable) {
+#if defined(SHURIUM_HAVE_EPOLL)
+        if (backend == EventBackend::EPOLL) {
+            struct epoll_event ev;
+            std::memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN | EPOLLET | (writable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+            ev.data.fd = sock;
+            if (epoll_ctl(eventFd, EPOLL_CTL_ADD, sock, &ev) != 0 && errno == EEXIST) {
+                epoll_ctl(eventFd, EPOLL_CTL_MOD, sock, &ev);
+            }
+        }
+#elif defined(SHURIUM_HAVE_KQUEUE)
+        if (backend == EventBackend::KQUEUE) {
+            struct kevent changes[2];
+            int count = 0;
+            EV_SET(&changes[count++], sock, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+            if (writable) {
+                EV_SET(&changes[count++], sock, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+            }
+            kevent(eventFd, changes, count, nullptr, 0, nullptr);
+        }
+#else
+        (void)sock;
+        (void)writable;
+#endif
+    }
+    
+    /// Drop a socket that is still open (closing one unregisters it)
+    void Unregister(SocketHandle sock) {
+#if defined(SHURIUM_HAVE_EPOLL)
+        if (backend == EventBackend::EPOLL) {
+            struct epoll_event ev;
+            std::memset(&ev, 0, sizeof(ev));
+            epoll_ctl(eventFd, EPOLL_CTL_DEL, sock, &ev);
+        }
+#elif defined(SHURIUM_HAVE_KQUEUE)
+        if (backend == EventBackend::KQUEUE) {
+            // One change per call: deleting a filter that was never added
+            // fails and would stop the rest
+            struct kevent change;
+            EV_SET(&change, sock, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+            kevent(eventFd, &change, 1, nullptr, 0, nullptr);
+            EV_SET(&change, sock, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+            kevent(eventFd, &change, 1, nullptr, 0, nullptr);
+        }
+#else
+        (void)sock;
+#endif
+    }
 };
 
-EventLoop::EventLoop() : impl_(std::make_unique<Impl>()) {
+EventLoop::EventLoop(EventBackend backend) : impl_(std::make_unique<Impl>()) {
+#if defined(SHURIUM_HAVE_EPOLL)
+    if (backend == EventBackend::EPOLL) {
+        impl_->eventFd = epoll_create1(EPOLL_CLOEXEC);
+    }
+#elif defined(SHURIUM_HAVE_KQUEUE)
+    if (backend == EventBackend::KQUEUE) {
+        impl_->eventFd = kqueue();
+    }
+#endif
+    impl_->backend = impl_->eventFd >= 0 ? backend : EventBackend::POLL;
+    
+    if (impl_->backend == EventBackend::EPOLL) {
+        impl_->ring = util::IoRing::Create();
+        if (impl_->ring) {
+            impl_->ringBuffers.resize(RING_READS_PER_BATCH * RING_READ_BUFFER_SIZE);
+            impl_->ring->RegisterBuffers(impl_->ringBuffers.data(), RING_READ_BUFFER_SIZE,
+                                         static_cast<unsigned>(RING_READS_PER_BATCH));
+        }
+    }
+    
     // Create wake-up pipe/socket pair
 #ifdef _WIN32
     // On Windows, use loopback socket pair
@@ -584,14 +1016,25 @@ EventLoop::EventLoop() : impl_(std::make_unique<Impl>()) {
         wakeupSend_ = fds[1];
         SetNonBlocking(wakeupRecv_);
         SetNonBlocking(wakeupSend_);
+        impl_->Register(wakeupRecv_, false);
     }
 #endif
 }
 
 EventLoop::~EventLoop() {
     Stop();
+    for (auto& [sock, conn] : impl_->connections) {
+        conn->SetWriteRequestCallback(nullptr);
+    }
     if (wakeupRecv_ != INVALID_SOCKET_HANDLE) CloseSocket(wakeupRecv_);
     if (wakeupSend_ != INVALID_SOCKET_HANDLE) CloseSocket(wakeupSend_);
+#ifndef _WIN32
+    if (impl_->eventFd >= 0) close(impl_->eventFd);
+#endif
+}
+
+EventBackend EventLoop::GetBackend() const {
+    return impl_->backend;
 }
 
 void EventLoop::Start() {
@@ -602,35 +1045,79 @@ void EventLoop::Start() {
 void EventLoop::Stop() {
     if (!running_.exchange(false)) return;
     
-    // Wake up the event loop
-    if (wakeupSend_ != INVALID_SOCKET_HANDLE) {
-        char c = 0;
-        send(wakeupSend_, &c, 1, 0);
-    }
+    WakeUp();
     
     if (eventThread_.joinable()) {
         eventThread_.join();
     }
 }
 
+void EventLoop::WakeUp() {
+    if (wakeupSend_ == INVALID_SOCKET_HANDLE) return;
+    char c = 0;
+#ifdef _WIN32
+    send(wakeupSend_, &c, 1, 0);
+#else
+    // A pipe, so write(): send() would fail with ENOTSOCK
+    ssize_t ignored = write(wakeupSend_, &c, 1);
+    (void)ignored;
+#endif
+}
+
 void EventLoop::AddConnection(Connection* conn) {
-    std::lock_guard<std::mutex> lock(callbackMutex_);
-    impl_->connections[conn->GetSocket()] = conn;
+    SocketHandle sock = conn->GetSocket();
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        impl_->connections[sock] = conn;
+    }
+    if (impl_->backend != EventBackend::POLL) {
+        conn->SetWriteRequestCallback([this](Connection& c) { RequestWrite(&c); });
+        // Both directions, once: a connecting socket reports completion
+        // as writable
+        impl_->Register(sock, true);
+    }
 }
 
 void EventLoop::RemoveConnection(Connection* conn) {
+    // Before taking our locks: the callback runs under the send lock and
+    // takes writeMutex
+    conn->SetWriteRequestCallback(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(impl_->writeMutex);
+        auto& writes = impl_->requestedWrites;
+        writes.erase(std::remove(writes.begin(), writes.end(), conn), writes.end());
+        auto& throttled = impl_->throttledWrites;
+        throttled.erase(std::remove(throttled.begin(), throttled.end(), conn), throttled.end());
+    }
+    
     std::lock_guard<std::mutex> lock(callbackMutex_);
-    impl_->connections.erase(conn->GetSocket());
+    // Found by pointer: a closed connection no longer knows its socket
+    for (auto it = impl_->connections.begin(); it != impl_->connections.end(); ++it) {
+        if (it->second == conn) {
+            // A closed socket has left the kernel set already, and its
+            // number may belong to someone else by now
+            if (conn->GetSocket() == it->first) {
+                impl_->Unregister(it->first);
+            }
+            impl_->connections.erase(it);
+            return;
+        }
+    }
 }
 
 void EventLoop::AddListener(Listener* listener) {
-    std::lock_guard<std::mutex> lock(callbackMutex_);
-    impl_->listeners[listener->GetSocket()] = listener;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        impl_->listeners[listener->GetSocket()] = listener;
+    }
+    impl_->Register(listener->GetSocket(), false);
 }
 
 void EventLoop::RemoveListener(Listener* listener) {
     std::lock_guard<std::mutex> lock(callbackMutex_);
-    impl_->listeners.erase(listener->GetSocket());
+    if (impl_->listeners.erase(listener->GetSocket()) > 0) {
+        impl_->Unregister(listener->GetSocket());
+    }
 }
 
 void EventLoop::Post(std::function<void()> callback) {
@@ -639,25 +1126,114 @@ void EventLoop::Post(std::function<void()> callback) {
         postedCallbacks_.push(std::move(callback));
     }
     
-    // Wake up event loop
-    if (wakeupSend_ != INVALID_SOCKET_HANDLE) {
-        char c = 0;
-        send(wakeupSend_, &c, 1, 0);
+    WakeUp();
+}
+
+void EventLoop::RequestWrite(Connection* conn) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(impl_->writeMutex);
+        // One wakeup per batch: the loop takes the whole list at once
+        wake = impl_->requestedWrites.empty();
+        impl_->requestedWrites.push_back(conn);
+    }
+    if (wake) {
+        WakeUp();
+    }
+}
+
+void EventLoop::Write(Connection* conn) {
+    conn->OnWritable(impl_->ring.get());
+    if (conn->IsSendThrottled()) {
+        std::lock_guard<std::mutex> lock(impl_->writeMutex);
+        auto& throttled = impl_->throttledWrites;
+        if (std::find(throttled.begin(), throttled.end(), conn) == throttled.end()) {
+            throttled.push_back(conn);
+        }
+    }
+}
+
+void EventLoop::RetryThrottledWrites() {
+    // As FlushRequestedWrites: one at a time, and only those stopped
+    // before this pass
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(impl_->writeMutex);
+        count = impl_->throttledWrites.size();
+    }
+    
+    for (; count > 0; --count) {
+        Connection* conn;
+        {
+            std::lock_guard<std::mutex> lock(impl_->writeMutex);
+            if (impl_->throttledWrites.empty()) break;
+            conn = impl_->throttledWrites.front();
+            impl_->throttledWrites.pop_front();
+        }
+        if (conn->IsConnected()) {
+            Write(conn);
+        }
     }
 }
 
 void EventLoop::Poll(int timeoutMs) {
     ProcessEvents(timeoutMs);
     ProcessPostedCallbacks();
+    FlushRequestedWrites();
+    RetryThrottledWrites();
 }
 
 void EventLoop::Run() {
+    util::ScopedThreadRole role("eventloop");
     while (running_) {
         Poll(100);  // 100ms timeout for periodic wake
     }
 }
 
 void EventLoop::ProcessEvents(int timeoutMs) {
+#if defined(SHURIUM_HAVE_EPOLL)
+    if (impl_->backend == EventBackend::EPOLL) {
+        struct epoll_event events[MAX_EVENTS_PER_WAIT];
+        int count = epoll_wait(impl_->eventFd, events, MAX_EVENTS_PER_WAIT, timeoutMs);
+        std::vector<ReadyConnection> ready;
+        for (int i = 0; i < count; ++i) {
+            uint32_t ev = events[i].events;
+            bool readable = (ev & EPOLLIN) != 0;
+            bool writable = (ev & EPOLLOUT) != 0;
+            bool failed = (ev & (EPOLLERR | EPOLLHUP)) != 0;
+            // With a ring, connected sockets are read together afterwards
+            if (impl_->ring && readable && !failed) {
+                auto it = impl_->connections.find(events[i].data.fd);
+                if (it != impl_->connections.end() && it->second->IsConnected()) {
+                    ready.push_back({events[i].data.fd, it->second, writable});
+                    continue;
+                }
+            }
+            DispatchEvent(events[i].data.fd, readable, writable, failed);
+        }
+        if (!ready.empty()) {
+            ReadReady(ready);
+        }
+        return;
+    }
+#elif defined(SHURIUM_HAVE_KQUEUE)
+    if (impl_->backend == EventBackend::KQUEUE) {
+        struct kevent events[MAX_EVENTS_PER_WAIT];
+        struct timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000L;
+        int count = kevent(impl_->eventFd, nullptr, 0, events, MAX_EVENTS_PER_WAIT, &timeout);
+        for (int i = 0; i < count; ++i) {
+            // A peer's EOF shows up on the read filter; recv() reports it
+            SocketHandle sock = static_cast<SocketHandle>(events[i].ident);
+            bool failed = (events[i].flags & EV_ERROR) != 0;
+            DispatchEvent(sock, events[i].filter == EVFILT_READ,
+                          events[i].filter == EVFILT_WRITE, failed);
+        }
+        return;
+    }
+#endif
+    
     impl_->pollFds.clear();
     
     // Add wake-up socket
@@ -683,7 +1259,9 @@ void EventLoop::ProcessEvents(int timeoutMs) {
         struct pollfd pfd;
         pfd.fd = sock;
         pfd.events = POLLIN;
-        if (conn->HasPendingData() || conn->GetState() == ConnState::CONNECTING) {
+        // A throttled connection waits for its tokens, not the socket
+        if ((conn->HasPendingData() && !conn->IsSendThrottled()) ||
+            conn->GetState() == ConnState::CONNECTING) {
             pfd.events |= POLLOUT;
         }
         pfd.revents = 0;
@@ -700,53 +1278,158 @@ void EventLoop::ProcessEvents(int timeoutMs) {
     
     for (auto& pfd : impl_->pollFds) {
         if (pfd.revents == 0) continue;
-        
-        // Wake-up socket
-        if (pfd.fd == wakeupRecv_) {
-            char buf[64];
-            while (recv(wakeupRecv_, buf, sizeof(buf), 0) > 0) {}
-            continue;
+        DispatchEvent(pfd.fd, (pfd.revents & POLLIN) != 0, (pfd.revents & POLLOUT) != 0,
+                      (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0);
+    }
+}
+
+void EventLoop::DispatchEvent(SocketHandle sock, bool readable, bool writable, bool failed) {
+    // Wake-up socket
+    if (sock == wakeupRecv_) {
+        char buf[64];
+#ifdef _WIN32
+        while (recv(wakeupRecv_, buf, sizeof(buf), 0) > 0) {}
+#else
+        while (read(wakeupRecv_, buf, sizeof(buf)) > 0) {}
+#endif
+        return;
+    }
+    
+    // Listener
+    auto listenerIt = impl_->listeners.find(sock);
+    if (listenerIt != impl_->listeners.end()) {
+        if (readable) {
+            listenerIt->second->OnAccept();
         }
-        
-        // Listener
-        auto listenerIt = impl_->listeners.find(pfd.fd);
-        if (listenerIt != impl_->listeners.end()) {
-            if (pfd.revents & POLLIN) {
-                listenerIt->second->OnAccept();
+        return;
+    }
+    
+    // Connection
+    auto connIt = impl_->connections.find(sock);
+    if (connIt == impl_->connections.end()) {
+        return;
+    }
+    Connection* conn = connIt->second;
+    
+    if (failed) {
+        conn->OnError(0);
+        return;
+    }
+    
+    if (conn->GetState() == ConnState::CONNECTING) {
+        if (writable) {
+            // Check if connect succeeded
+            int err = 0;
+            socklen_t errLen = sizeof(err);
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, 
+                      reinterpret_cast<char*>(&err), &errLen);
+            conn->OnConnectComplete(err == 0);
+            // That was the writable edge; send what was queued meanwhile
+            if (conn->IsConnected() && conn->HasPendingData()) {
+                Write(conn);
             }
-            continue;
         }
+        return;
+    }
+    
+    if (readable) {
+        conn->OnReadable();
+    }
+    if (writable) {
+        Write(conn);
+    }
+}
+
+void EventLoop::ReadReady(const std::vector<ReadyConnection>& ready) {
+    util::IoRing& ring = *impl_->ring;
+    for (size_t begin = 0; begin < ready.size(); begin += RING_READS_PER_BATCH) {
+        size_t end = std::min(ready.size(), begin + RING_READS_PER_BATCH);
+        uint64_t tag = ++impl_->ringBatch << 16;
         
-        // Connection
-        auto connIt = impl_->connections.find(pfd.fd);
-        if (connIt != impl_->connections.end()) {
-            Connection* conn = connIt->second;
-            
-            if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
-                conn->OnError(0);
-                continue;
-            }
-            
-            if (conn->GetState() == ConnState::CONNECTING && (pfd.revents & POLLOUT)) {
-                // Check if connect succeeded
-                int err = 0;
-                socklen_t errLen = sizeof(err);
-                getsockopt(pfd.fd, SOL_SOCKET, SO_ERROR, 
-                          reinterpret_cast<char*>(&err), &errLen);
-                conn->OnConnectComplete(err == 0);
+        size_t queued = 0;
+        for (size_t i = begin; i < end; ++i) {
+            size_t slot = i - begin;
+            uint8_t* buffer = impl_->ringBuffers.data() + slot * RING_READ_BUFFER_SIZE;
+            bool ok = ring.HasRegisteredBuffers()
+                ? ring.QueueReadFixed(ready[i].sock, buffer, RING_READ_BUFFER_SIZE, UINT64_MAX,
+                                      static_cast<uint16_t>(slot), tag | slot)
+                : ring.QueueRead(ready[i].sock, buffer, RING_READ_BUFFER_SIZE, UINT64_MAX,
+                                 tag | slot);
+            if (!ok) break;
+            ++queued;
+        }
+        
+        // Every read finishes before any callback runs, so each result
+        // belongs to the connection that owned the socket when it was queued
+        constexpr int64_t NOT_READ = INT64_MIN;
+        std::vector<int64_t> results(end - begin, NOT_READ);
+        size_t done = 0;
+        while (done < queued) {
+            util::IoRing::Completion completion;
+            if (ring.PopCompletion(completion)) {
+                if ((completion.userData & ~uint64_t{0xffff}) == tag) {
+                    results[completion.userData & 0xffff] = completion.result;
+                    ++done;
+                }
                 continue;
             }
+            int submitted = ring.Submit(static_cast<unsigned>(queued - done));
+            if (submitted < 0 && submitted != -EINTR) break;
+        }
+        
+        for (size_t i = begin; i < end; ++i) {
+            // Callbacks of an earlier connection may have removed this one
+            auto it = impl_->connections.find(ready[i].sock);
+            if (it == impl_->connections.end() || it->second != ready[i].conn) continue;
+            Connection* conn = ready[i].conn;
             
-            if (pfd.revents & POLLIN) {
+            int64_t result = results[i - begin];
+            if (result == NOT_READ) {
                 conn->OnReadable();
+            } else {
+                conn->OnReadResult(impl_->ringBuffers.data() + (i - begin) * RING_READ_BUFFER_SIZE,
+                                   result);
+                // A full buffer may have left data behind, and the edge
+                // will not fire again for it
+                if (result == static_cast<int64_t>(RING_READ_BUFFER_SIZE) &&
+                    conn->IsConnected()) {
+                    conn->OnReadable();
+                }
             }
-            if (pfd.revents & POLLOUT) {
-                conn->OnWritable();
+            if (ready[i].writable && conn->IsConnected()) {
+                Write(conn);
             }
         }
     }
 }
 
+void EventLoop::FlushRequestedWrites() {
+    // Taken one at a time, so a connection removed by an earlier one's
+    // callbacks is never touched; bounded, so writes requested while
+    // flushing wait for the next iteration
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(impl_->writeMutex);
+        count = impl_->requestedWrites.size();
+    }
+    
+    for (; count > 0; --count) {
+        Connection* conn;
+        {
+            std::lock_guard<std::mutex> lock(impl_->writeMutex);
+            if (impl_->requestedWrites.empty()) break;
+            conn = impl_->requestedWrites.front();
+            impl_->requestedWrites.pop_front();
+        }
+        // Writes until the socket would block; the writable edge that
+        // follows picks up the rest. A connecting socket flushes on
+        // completion instead.
+        if (conn->IsConnected()) {
+            Write(conn);
+        }
+    }
+}
+
 void EventLoop::ProcessPostedCallbacks() {
     std::queue<std::function<void()>> callbacks;
     {
@@ -766,7 +1449,14 @@ void EventLoop::ProcessPostedCallbacks() {
 
 ConnectionManager::ConnectionManager(const Options& opts)
     : options_(opts)
-    , eventLoop_(std::make_unique<EventLoop>()) {
+    , eventLoop_(std::make_unique<EventLoop>())
+    , admission_(opts.admission)
+    , uploadTarget_(std::make_shared<UploadTarget>(opts.maxUploadTarget)) {
+    connOptions_.maxSendRate = opts.maxSendRatePerPeer;
+    if (opts.maxSendRateTotal > 0) {
+        connOptions_.sharedSendLimit = std::make_shared<TokenBucket>(opts.maxSendRateTotal);
+    }
+    connOptions_.uploadTarget = uploadTarget_;
 }
 
 ConnectionManager::~ConnectionManager() {
@@ -781,6 +1471,9 @@ bool ConnectionManager::Start() {
     if (options_.acceptInbound) {
         listener_ = Listener::Create(options_.listenPort);
         if (listener_ && listener_->Start()) {
+            listener_->SetFilterCallback([this](const NetService& addr) {
+                return AdmitInbound(addr);
+            });
             listener_->SetAcceptCallback([this](std::unique_ptr<Connection> conn) {
                 AcceptConnection(std::move(conn));
             });
@@ -805,13 +1498,17 @@ void ConnectionManager::Stop() {
     eventLoop_->Stop();
 }
 
+uint16_t ConnectionManager::GetListenPort() const {
+    return listener_ ? listener_->GetListenAddress().GetPort() : 0;
+}
+
 Peer::Id ConnectionManager::ConnectTo(const NetService& addr, ConnectionType type) {
     if (!running_) return -1;
     if (!CanAcceptConnection(false)) return -1;
     if (IsBanned(static_cast<const NetAddress&>(addr))) return -1;
     
     Peer::Id id = AllocatePeerId();
-    auto conn = Connection::Create(addr);
+    auto conn = Connection::Create(addr, connOptions_);
     auto peer = (type == ConnectionType::INBOUND) 
                 ? Peer::CreateInbound(id, addr)
                 : Peer::CreateOutbound(id, addr, type);
@@ -822,6 +1519,7 @@ Peer::Id ConnectionManager::ConnectTo(const NetService& addr, ConnectionType typ
     
     {
         std::lock_guard<std::mutex> lock(peersMutex_);
+        AttachPeer(id, *conn, *peer);
         peers_[id] = std::move(peer);
         connections_[id] = std::move(conn);
         eventLoop_->AddConnection(connections_[id].get());
@@ -842,10 +1540,14 @@ void ConnectionManager::DisconnectPeer(Peer::Id id, DisconnectReason reason) {
         if (peerIt == peers_.end()) return;
         peer = peerIt->second;
         peer->Disconnect(reason);
+        peer->SetSendReadyHandler(nullptr);
+        peer->SetActivityHandler(nullptr);
+        admission_.Remove(id);
         
         auto connIt = connections_.find(id);
         if (connIt != connections_.end()) {
             eventLoop_->RemoveConnection(connIt->second.get());
+            connIt->second->SetEventCallback(nullptr);
             connIt->second->Close();
             connections_.erase(connIt);
         }
@@ -954,6 +1656,40 @@ uint64_t ConnectionManager::GetTotalBytesRecv() const {
     return total;
 }
 
+bool ConnectionManager::IsUploadTargetReached() const {
+    return uploadTarget_->IsReached(GetTime());
+}
+
+void ConnectionManager::DisconnectSlowHandshakes() {
+    for (Peer::Id id : admission_.TakeExpired(InboundAdmission::Clock::now())) {
+        DisconnectPeer(id, DisconnectReason::TIMEOUT);
+    }
+}
+
+bool ConnectionManager::AdmitInbound(const NetService& addr) {
+    const NetAddress& netAddr = addr;
+    if (IsBanned(netAddr)) {
+        return false;
+    }
+    
+    // Cheapest refusals first, so a flood never gets as far as eviction
+    DisconnectSlowHandshakes();
+    if (!admission_.AllowConnect(netAddr, InboundAdmission::Clock::now()) ||
+        !admission_.HasPendingSlot()) {
+        return false;
+    }
+    if (CanAcceptConnection(true)) {
+        return true;
+    }
+    
+    Peer::Id victim = admission_.SelectForEviction();
+    if (victim < 0) {
+        return false;
+    }
+    DisconnectPeer(victim, DisconnectReason::TOO_MANY_CONNECTIONS);
+    return CanAcceptConnection(true);
+}
+
 void ConnectionManager::AcceptConnection(std::unique_ptr<Connection> conn) {
     if (!CanAcceptConnection(true)) {
         conn->Close();
@@ -965,11 +1701,14 @@ void ConnectionManager::AcceptConnection(std::unique_ptr<Connection> conn) {
         return;
     }
     
+    conn->SetSendShaping(connOptions_);
     Peer::Id id = AllocatePeerId();
     auto peer = Peer::CreateInbound(id, conn->GetRemoteAddress());
+    admission_.AddPending(id, conn->GetRemoteAddress(), GetTime(), InboundAdmission::Clock::now());
     
     {
         std::lock_guard<std::mutex> lock(peersMutex_);
+        AttachPeer(id, *conn, *peer);
         peers_[id] = std::move(peer);
         connections_[id] = std::move(conn);
         eventLoop_->AddConnection(connections_[id].get());
@@ -980,6 +1719,38 @@ void ConnectionManager::AcceptConnection(std::unique_ptr<Connection> conn) {
     }
 }
 
+void ConnectionManager::AttachPeer(Peer::Id id, Connection& conn, Peer& peer) {
+    // Both live until DisconnectPeer, which detaches them first
+    conn.SetEventCallback([this, id, &peer](Connection& c, ConnEvent event) {
+        switch (event) {
+            case ConnEvent::DATA_RECEIVED:
+                c.RecvInto(peer);
+                break;
+            case ConnEvent::DISCONNECTED:
+            case ConnEvent::ERROR:
+                // Not from inside the connection's own callback
+                eventLoop_->Post([this, id]() {
+                    DisconnectPeer(id, DisconnectReason::NETWORK_ERROR);
+                });
+                break;
+            default:
+                break;
+        }
+    });
+    peer.SetSendReadyHandler([&conn](Peer& p) { conn.SendFrom(p); });
+    if (peer.IsInbound()) {
+        peer.SetActivityHandler([this, id](Peer& p) {
+            if (!p.IsEstablished()) return;
+            PeerStats stats = p.GetStats();
+            EvictionMetrics metrics;
+            metrics.pingMicros = stats.pingLatencyMicros;
+            metrics.lastBlockTime = stats.lastBlockTime;
+            metrics.lastTxTime = stats.lastTxTime;
+            admission_.Update(id, metrics);
+        });
+    }
+}
+
 void ConnectionManager::HandlePeerDisconnect(Peer::Id id, DisconnectReason reason) {
     if (disconnectedCallback_) {
         disconnectedCallback_(id, reason);
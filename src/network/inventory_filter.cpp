@@ -0,0 +1,137 @@
+// SHURIUM - Inventory Filters Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/network/inventory_filter.h>
+#include <shurium/core/random.h>
+#include <shurium/crypto/siphash.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace shurium {
+
+// ============================================================================
+// RollingBloomFilter
+// ============================================================================
+
+RollingBloomFilter::RollingBloomFilter(size_t items, double fpRate)
+    : k0_(GetRandUint64()), k1_(GetRandUint64()) {
+    double logFpRate = std::log(fpRate);
+    hashFuncs_ = static_cast<size_t>(std::max(
+        1.0, std::min(std::round(logFpRate / std::log(0.5)), 50.0)));
+    entriesPerGeneration_ = std::max<size_t>(1, (items + 1) / 2);
+    size_t maxElements = entriesPerGeneration_ * 3;
+    // Bits for maxElements at fpRate with hashFuncs_ functions:
+    // fpRate = (1 - exp(-hashFuncs * maxElements / bits)) ^ hashFuncs
+    double bits = std::ceil(-1.0 * static_cast<double>(hashFuncs_ * maxElements) /
+                            std::log(1.0 - std::exp(logFpRate / static_cast<double>(hashFuncs_))));
+    words_ = ((static_cast<size_t>(bits) + 63) / 64) * 2;
+}
+
+void RollingBloomFilter::Hashes(const Hash256& hash, uint32_t extra,
+                                uint64_t& h1, uint64_t& h2) const {
+    h1 = SipHash13Uint256Extra(k0_, k1_, hash, extra);
+    h2 = SipHash13Uint256Extra(k1_, k0_, hash, extra) | 1;
+}
+
+void RollingBloomFilter::Position(uint64_t h1, uint64_t h2, size_t i,
+                                  size_t& pair, int& bit) const {
+    uint64_t h = h1 + i * h2;
+    bit = static_cast<int>(h & 63);
+    // Map the high half onto the pairs without a division
+    pair = static_cast<size_t>(((h >> 32) * (words_ / 2)) >> 32) * 2;
+}
+
+void RollingBloomFilter::Insert(const Hash256& hash, uint32_t extra) {
+    if (data_.empty()) {
+        data_.assign(words_, 0);
+    }
+
+    if (entriesThisGeneration_ == entriesPerGeneration_) {
+        entriesThisGeneration_ = 0;
+        if (++generation_ == 4) {
+            generation_ = 1;
+        }
+        // Clear the positions last set by the generation being reused
+        uint64_t g1 = (generation_ & 1) ? ~uint64_t{0} : 0;
+        uint64_t g2 = (generation_ >> 1) ? ~uint64_t{0} : 0;
+        for (size_t p = 0; p < words_; p += 2) {
+            uint64_t keep = (data_[p] ^ g1) | (data_[p + 1] ^ g2);
+            data_[p] &= keep;
+            data_[p + 1] &= keep;
+        }
+    }
+    ++entriesThisGeneration_;
+
+    uint64_t h1, h2;
+    Hashes(hash, extra, h1, h2);
+    for (size_t i = 0; i < hashFuncs_; ++i) {
+        size_t pair;
+        int bit;
+        Position(h1, h2, i, pair, bit);
+        uint64_t mask = uint64_t{1} << bit;
+        data_[pair] = (data_[pair] & ~mask) | (uint64_t{generation_ & 1} << bit);
+        data_[pair + 1] = (data_[pair + 1] & ~mask) | (uint64_t{generation_ >> 1} << bit);
+    }
+}
+
+bool RollingBloomFilter::Contains(const Hash256& hash, uint32_t extra) const {
+    if (data_.empty()) {
+        return false;
+    }
+    uint64_t h1, h2;
+    Hashes(hash, extra, h1, h2);
+    for (size_t i = 0; i < hashFuncs_; ++i) {
+        size_t pair;
+        int bit;
+        Position(h1, h2, i, pair, bit);
+        if ((((data_[pair] | data_[pair + 1]) >> bit) & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RollingBloomFilter::Reset() {
+    entriesThisGeneration_ = 0;
+    generation_ = 1;
+    std::fill(data_.begin(), data_.end(), 0);
+}
+
+// ============================================================================
+// InventoryFilter
+// ============================================================================
+
+InventoryFilter::InventoryFilter(size_t items, double fpRate, size_t recentItems)
+    : transactions_(items, fpRate), recentCapacity_(std::max<size_t>(1, recentItems)) {}
+
+void InventoryFilter::Insert(const Inv& inv) {
+    if (inv.IsTransaction()) {
+        transactions_.Insert(inv.hash);
+        return;
+    }
+    if (!recent_.insert(inv).second) {
+        return;
+    }
+    recentOrder_.push_back(inv);
+    if (recentOrder_.size() > recentCapacity_) {
+        recent_.erase(recentOrder_.front());
+        recentOrder_.pop_front();
+    }
+}
+
+bool InventoryFilter::Contains(const Inv& inv) const {
+    if (inv.IsTransaction()) {
+        return transactions_.Contains(inv.hash);
+    }
+    return recent_.count(inv) > 0;
+}
+
+void InventoryFilter::Reset() {
+    transactions_.Reset();
+    recent_.clear();
+    recentOrder_.clear();
+}
+
+} // namespace shurium
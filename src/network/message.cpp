@@ -191,7 +191,7 @@ public:
     static bool ParseVersionMessage(const std::vector<uint8_t>& payload,
                                     VersionMessage& version) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             version.Unserialize(stream);
             return true;
         } catch (...) {
@@ -203,7 +203,7 @@ public:
     static bool ParsePingMessage(const std::vector<uint8_t>& payload,
                                  PingMessage& ping) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             ping.Unserialize(stream);
             return true;
         } catch (...) {
@@ -215,7 +215,7 @@ public:
     static bool ParseInvMessage(const std::vector<uint8_t>& payload,
                                 std::vector<Inv>& inventory) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             ::shurium::Unserialize(stream, inventory);
             return inventory.size() <= MAX_INV_SZ;
         } catch (...) {
@@ -227,7 +227,7 @@ public:
     static bool ParseHeadersMessage(const std::vector<uint8_t>& payload,
                                     std::vector<BlockHeader>& headers) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             size_t count = ReadCompactSize(stream);
             if (count > MAX_HEADERS_RESULTS) {
                 return false;
@@ -250,7 +250,7 @@ public:
     static bool ParseBlockMessage(const std::vector<uint8_t>& payload,
                                   Block& block) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             ::shurium::Unserialize(stream, block);
             return true;
         } catch (...) {
@@ -262,7 +262,7 @@ public:
     static bool ParseTxMessage(const std::vector<uint8_t>& payload,
                                MutableTransaction& tx) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             ::shurium::Unserialize(stream, tx);
             return true;
         } catch (...) {
@@ -274,7 +274,7 @@ public:
     static bool ParseAddrMessage(const std::vector<uint8_t>& payload,
                                  std::vector<PeerAddress>& addresses) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             AddrMessage msg;
             msg.Unserialize(stream);
             addresses = std::move(msg.addresses);
@@ -288,7 +288,7 @@ public:
     static bool ParseGetBlocksMessage(const std::vector<uint8_t>& payload,
                                       GetBlocksMessage& msg) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             msg.Unserialize(stream);
             return true;
         } catch (...) {
@@ -300,7 +300,7 @@ public:
     static bool ParseFeeFilterMessage(const std::vector<uint8_t>& payload,
                                       FeeFilterMessage& msg) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             msg.Unserialize(stream);
             return msg.minFeeRate >= 0;
         } catch (...) {
@@ -312,7 +312,7 @@ public:
     static bool ParseRejectMessage(const std::vector<uint8_t>& payload,
                                    RejectMessage& msg) {
         try {
-            DataStream stream(payload.data(), payload.size());
+            SpanReader stream(payload);
             msg.Unserialize(stream);
             return true;
         } catch (...) {
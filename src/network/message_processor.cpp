@@ -8,11 +8,20 @@
 #include <shurium/mempool/mempool.h>
 #include <shurium/chain/chainstate.h>
 #include <shurium/db/blockdb.h>
+#include <shurium/db/blockfilterdb.h>
+#include <shurium/util/affinity.h>
 #include <shurium/util/logging.h>
+#include <shurium/util/metrics.h>
+#include <shurium/util/trace.h>
 #include <shurium/util/time.h>
+#include <shurium/core/random.h>
+#include <shurium/crypto/siphash.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstring>
+#include <unordered_set>
 
 namespace shurium {
 
@@ -22,7 +31,13 @@ namespace shurium {
 
 MessageProcessor::MessageProcessor(const Options& opts)
     : options_(opts)
+    , ourServices_(opts.localServices)
+    , addrSalt0_(GetRandUint64())
+    , addrSalt1_(GetRandUint64())
 {
+    if (options_.txReconciliation && options_.relayTransactions) {
+        ourServices_ |= ServiceFlags::TX_RECONCILIATION;
+    }
 }
 
 MessageProcessor::~MessageProcessor() {
@@ -58,6 +73,13 @@ void MessageProcessor::SetBlockDB(db::BlockDB* blockdb) {
     blockdb_ = blockdb;
 }
 
+void MessageProcessor::SetBlockFilterIndex(db::BlockFilterIndex* filterIndex) {
+    filterIndex_ = filterIndex;
+    if (filterIndex_) {
+        ourServices_ |= ServiceFlags::COMPACT_FILTERS;
+    }
+}
+
 void MessageProcessor::SetLocalAddress(const NetService& addr) {
     localAddress_ = addr;
 }
@@ -96,6 +118,18 @@ bool MessageProcessor::Start() {
     
     LOG_INFO(util::LogCategory::NET) << "Starting message processor...";
     
+    if (options_.workerThreads > 0) {
+        util::ThreadPool::Config config;
+        config.numThreads = static_cast<size_t>(options_.workerThreads);
+        config.name = "msgproc";
+        workers_ = std::make_unique<util::ThreadPool>(config);
+        shardBusy_ = std::deque<std::atomic<bool>>(config.numThreads);
+        
+        config.numThreads = 1;
+        config.name = "msgheavy";
+        heavyWorker_ = std::make_unique<util::ThreadPool>(config);
+    }
+    
     processingThread_ = std::thread(&MessageProcessor::ProcessingLoop, this);
     
     return true;
@@ -112,6 +146,17 @@ void MessageProcessor::Stop() {
         processingThread_.join();
     }
     
+    // Passes under way see running_ and finish early
+    workers_.reset();
+    heavyWorker_.reset();
+    shardBusy_.clear();
+    {
+        std::lock_guard<std::mutex> lock(heavyMutex_);
+        heavyQueue_.clear();
+        heavyBacklog_.clear();
+        heavyScheduled_ = false;
+    }
+    
     LOG_INFO(util::LogCategory::NET) << "Message processor stopped";
 }
 
@@ -120,14 +165,29 @@ void MessageProcessor::Stop() {
 // ============================================================================
 
 void MessageProcessor::ProcessingLoop() {
+    util::ScopedThreadRole role("msgproc");
     LOG_DEBUG(util::LogCategory::NET) << "Message processing loop started";
     
     auto lastPingCheck = std::chrono::steady_clock::now();
+    auto lastReconRequest = lastPingCheck;
     
     while (running_.load()) {
         // Process messages from all peers
         ProcessMessages();
         
+        // Trickle out the addresses whose time has come
+        SendAddrRelay();
+        
+        // Free the slots of inbound peers stuck in their handshake
+        if (connman_) {
+            connman_->DisconnectSlowHandshakes();
+        }
+        
+        // Move the block download window along
+        if (sync_) {
+            sync_->Tick();
+        }
+        
         // Periodic tasks
         auto now = std::chrono::steady_clock::now();
         auto timeSinceLastPing = std::chrono::duration_cast<std::chrono::seconds>(
@@ -139,6 +199,11 @@ void MessageProcessor::ProcessingLoop() {
             lastPingCheck = now;
         }
         
+        if (now - lastReconRequest >= std::chrono::milliseconds(RECON_REQUEST_INTERVAL_MS)) {
+            RequestReconciliation();
+            lastReconRequest = now;
+        }
+        
         // Sleep for the processing interval
         std::this_thread::sleep_for(
             std::chrono::milliseconds(options_.processingIntervalMs));
@@ -154,43 +219,193 @@ void MessageProcessor::ProcessingLoop() {
 void MessageProcessor::ProcessMessages() {
     if (!connman_) return;
     
-    auto peers = connman_->GetAllPeers();
+    if (workers_) {
+        ScheduleMessages();
+    } else {
+        auto peers = connman_->GetAllPeers();
+        
+        for (auto& peer : peers) {
+            if (!peer) continue;
+            ProcessPeerMessages(peer);
+        }
+    }
     
-    for (auto& peer : peers) {
-        if (!peer) continue;
+    AcceptPendingTxs();
+}
+
+void MessageProcessor::ScheduleMessages() {
+    size_t shards = shardBusy_.size();
+    std::vector<std::vector<std::shared_ptr<Peer>>> byShard(shards);
+    for (auto& peer : connman_->GetAllPeers()) {
+        if (peer) {
+            byShard[static_cast<uint64_t>(peer->GetId()) % shards].push_back(peer);
+        }
+    }
+    
+    for (size_t shard = 0; shard < shards; ++shard) {
+        // A shard still busy with its last pass picks up the rest next time
+        if (byShard[shard].empty() || shardBusy_[shard].exchange(true)) {
+            continue;
+        }
+        bool submitted = workers_->TrySubmit([this, shard, peers = std::move(byShard[shard])]() {
+            ProcessShard(shard, peers);
+        });
+        if (!submitted) {
+            shardBusy_[shard] = false;
+        }
+    }
+}
+
+void MessageProcessor::ProcessShard(size_t shard, const std::vector<std::shared_ptr<Peer>>& peers) {
+    for (const auto& peer : peers) {
+        if (!running_.load()) break;
         ProcessPeerMessages(peer);
     }
+    shardBusy_[shard] = false;
 }
 
 void MessageProcessor::ProcessPeerMessages(std::shared_ptr<Peer> peer) {
     if (!peer || peer->ShouldDisconnect()) return;
     
+    // We speak first on connections we opened
+    if (peer->IsOutbound() && !peer->HasSentVersion()) {
+        SendVersion(*peer);
+    }
+    
     int messagesProcessed = 0;
     
     while (messagesProcessed < options_.maxMessagesPerPeer) {
+        bool heavyPending = false;
+        if (heavyWorker_) {
+            // Don't pull more from a peer whose blocks are piling up
+            std::lock_guard<std::mutex> lock(heavyMutex_);
+            auto it = heavyBacklog_.find(peer->GetId());
+            if (it != heavyBacklog_.end() && it->second >= options_.maxHeavyPerPeer) {
+                break;
+            }
+            heavyPending = it != heavyBacklog_.end();
+        }
+        
         auto msgOpt = peer->GetNextMessage();
         if (!msgOpt) {
             break;  // No more messages
         }
         
         auto& [command, payload] = *msgOpt;
+        messagesProcessed++;
         
-        // Dispatch the message
-        bool ok = DispatchMessage(*peer, command, payload);
+        // Once a peer has something on the heavy lane, everything after it
+        // follows it there, so the peer's messages keep their order
+        if (heavyWorker_) {
+            bool heavy = IsHeavyMessage(command, payload);
+            if (heavy || heavyPending) {
+                QueueHeavyMessage(peer, std::move(command), std::move(payload), heavy);
+                continue;
+            }
+        }
         
-        if (!ok) {
-            // Message handling failed - may have disconnected peer
-            if (peer->ShouldDisconnect()) {
-                break;
+        if (!HandleMessage(*peer, command, std::move(payload))) {
+            break;
+        }
+    }
+}
+
+bool MessageProcessor::HandleMessage(Peer& peer, const std::string& command,
+                                     std::vector<uint8_t>&& payload) {
+    static util::Histogram& latency = util::MetricsRegistry::Instance().GetHistogram(
+        "shurium_net_message_duration_microseconds", "Time to handle a P2P message");
+    
+    // Dispatch the message
+    bool ok;
+    {
+        util::ScopedLatency timer(latency);
+        ok = DispatchMessage(peer, command, std::move(payload));
+    }
+    
+    if (!ok) {
+        // Message handling failed - may have disconnected peer
+        if (peer.ShouldDisconnect()) {
+            return false;
+        }
+    }
+    
+    peer.RecordMessageReceived();
+    
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.messagesProcessed++;
+    }
+    return true;
+}
+
+bool MessageProcessor::IsHeavyMessage(const std::string& command,
+                                      const std::vector<uint8_t>& payload) {
+    if (command == NetMsgType::BLOCK || command == NetMsgType::CMPCTBLOCK ||
+        command == NetMsgType::GETBLOCKTXN || command == NetMsgType::BLOCKTXN ||
+        command == NetMsgType::SKETCH || command == NetMsgType::GETCFILTERS ||
+        command == NetMsgType::GETCFHEADERS) {
+        return true;
+    }
+    if (command != NetMsgType::GETDATA) {
+        return false;
+    }
+    
+    // Read the way HandleGetData reads it; anything malformed is left to
+    // HandleGetData to reject
+    try {
+        SpanReader reader(payload.data(), payload.size());
+        uint64_t count;
+        Unserialize(reader, count);
+        for (uint64_t i = 0; i < std::min<uint64_t>(count, MAX_INV_SZ); ++i) {
+            Inv item;
+            item.Unserialize(reader);
+            if (item.type == InvType::MSG_BLOCK || item.type == InvType::MSG_FILTERED_BLOCK ||
+                item.type == InvType::MSG_CMPCT_BLOCK) {
+                return true;
             }
         }
+    } catch (const std::exception&) {
+    }
+    return false;
+}
+
+void MessageProcessor::QueueHeavyMessage(std::shared_ptr<Peer> peer, std::string command,
+                                         std::vector<uint8_t> payload, bool heavy) {
+    std::lock_guard<std::mutex> lock(heavyMutex_);
+    ++heavyBacklog_[peer->GetId()];
+    heavyQueue_.push_back(
+        HeavyMessage{std::move(peer), std::move(command), std::move(payload), heavy});
+    
+    if (!heavyScheduled_) {
+        heavyScheduled_ = heavyWorker_->TrySubmit([this]() { ProcessHeavyMessages(); });
+    }
+}
+
+void MessageProcessor::ProcessHeavyMessages() {
+    while (true) {
+        HeavyMessage msg;
+        {
+            std::lock_guard<std::mutex> lock(heavyMutex_);
+            if (heavyQueue_.empty() || !running_.load()) {
+                heavyScheduled_ = false;
+                return;
+            }
+            msg = std::move(heavyQueue_.front());
+            heavyQueue_.pop_front();
+        }
         
-        peer->RecordMessageReceived();
-        messagesProcessed++;
+        if (!msg.peer->ShouldDisconnect()) {
+            HandleMessage(*msg.peer, msg.command, std::move(msg.payload));
+            if (msg.heavy) {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.heavyMessages++;
+            }
+        }
         
-        {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.messagesProcessed++;
+        std::lock_guard<std::mutex> lock(heavyMutex_);
+        auto it = heavyBacklog_.find(msg.peer->GetId());
+        if (it != heavyBacklog_.end() && --it->second <= 0) {
+            heavyBacklog_.erase(it);
         }
     }
 }
@@ -200,7 +415,7 @@ void MessageProcessor::ProcessPeerMessages(std::shared_ptr<Peer> peer) {
 // ============================================================================
 
 bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
-                                        const std::vector<uint8_t>& payload) {
+                                        std::vector<uint8_t>&& payload) {
     // === Pre-dispatch Validation ===
     
     // Validate command name
@@ -236,7 +451,7 @@ bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
     }
     
     // Create a stream from the payload for deserialization
-    DataStream stream(payload);
+    DataStream stream(std::move(payload));
     
     LOG_DEBUG(util::LogCategory::NET) << "Processing " << command 
                                       << " from peer " << peer.GetId();
@@ -244,13 +459,17 @@ bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
     try {
         // Handshake messages (always accepted)
         if (command == NetMsgType::VERSION) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.versionMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.versionMessages++;
+            }
             return HandleVersion(peer, stream);
         }
         if (command == NetMsgType::VERACK) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.verackMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.verackMessages++;
+            }
             return HandleVerack(peer);
         }
         
@@ -263,25 +482,33 @@ bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
         
         // Keepalive
         if (command == NetMsgType::PING) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.pingMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.pingMessages++;
+            }
             return HandlePing(peer, stream);
         }
         if (command == NetMsgType::PONG) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.pongMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.pongMessages++;
+            }
             return HandlePong(peer, stream);
         }
         
         // Inventory / data
         if (command == NetMsgType::INV) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.invMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.invMessages++;
+            }
             return HandleInv(peer, stream);
         }
         if (command == NetMsgType::GETDATA) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.getdataMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.getdataMessages++;
+            }
             return HandleGetData(peer, stream);
         }
         if (command == NetMsgType::NOTFOUND) {
@@ -290,13 +517,17 @@ bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
         
         // Blocks / headers
         if (command == NetMsgType::HEADERS) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.headersMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.headersMessages++;
+            }
             return HandleHeaders(peer, stream);
         }
         if (command == NetMsgType::BLOCK) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.blockMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.blockMessages++;
+            }
             return HandleBlock(peer, stream);
         }
         if (command == NetMsgType::GETHEADERS) {
@@ -306,10 +537,57 @@ bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
             return HandleGetBlocks(peer, stream);
         }
         
+        // Compact blocks
+        if (command == NetMsgType::SENDCMPCT) {
+            return HandleSendCmpct(peer, stream);
+        }
+        if (command == NetMsgType::CMPCTBLOCK) {
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.compactBlocks++;
+            }
+            return HandleCmpctBlock(peer, stream);
+        }
+        if (command == NetMsgType::GETBLOCKTXN) {
+            return HandleGetBlockTxn(peer, stream);
+        }
+        if (command == NetMsgType::BLOCKTXN) {
+            return HandleBlockTxn(peer, stream);
+        }
+        
+        // Compact block filters
+        if (command == NetMsgType::GETCFILTERS) {
+            return HandleGetCFilters(peer, stream);
+        }
+        if (command == NetMsgType::GETCFHEADERS) {
+            return HandleGetCFHeaders(peer, stream);
+        }
+        
+        // Payload compression
+        if (command == NetMsgType::SENDCOMPR) {
+            return HandleSendCompr(peer, stream);
+        }
+        
+        // Transaction reconciliation
+        if (command == NetMsgType::SENDTXRCNCL) {
+            return HandleSendTxRcncl(peer, stream);
+        }
+        if (command == NetMsgType::REQRECON) {
+            return HandleReqRecon(peer, stream);
+        }
+        if (command == NetMsgType::SKETCH) {
+            return HandleSketch(peer, stream);
+        }
+        if (command == NetMsgType::RECONCILDIFF) {
+            return HandleReconcilDiff(peer, stream);
+        }
+        
         // Transactions
         if (command == NetMsgType::TX) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.txMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.txMessages++;
+            }
             return HandleTx(peer, stream);
         }
         if (command == NetMsgType::MEMPOOL) {
@@ -321,8 +599,10 @@ bool MessageProcessor::DispatchMessage(Peer& peer, const std::string& command,
         
         // Address relay
         if (command == NetMsgType::ADDR) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.addrMessages++;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.addrMessages++;
+            }
             return HandleAddr(peer, stream);
         }
         if (command == NetMsgType::GETADDR) {
@@ -420,6 +700,21 @@ bool MessageProcessor::HandleVersion(Peer& peer, DataStream& payload) {
         SendVersion(peer);
     }
     
+    // Offer reconciliation before verack, as BIP330 asks
+    if (options_.txReconciliation && options_.relayTransactions && version.relay &&
+        HasFlag(version.services, ServiceFlags::TX_RECONCILIATION)) {
+        uint64_t salt = reconciliation_.PreRegisterPeer(peer.GetId());
+        peer.QueueMessage(NetMsgType::SENDTXRCNCL,
+                          SendTxRcnclMessage(TXRECONCILIATION_VERSION, salt));
+    }
+    
+    // Say we decode compressed messages, also before verack. Accept them
+    // from here on: the peer may compress as soon as it reads this.
+    if (options_.compression) {
+        peer.AcceptCompressed();
+        peer.QueueMessage(NetMsgType::SENDCOMPR, SendComprMessage());
+    }
+    
     // Send verack
     SendVerack(peer);
     
@@ -453,8 +748,27 @@ bool MessageProcessor::HandleVerack(Peer& peer) {
     // Send sendheaders to request header announcements
     peer.QueueMessage(NetMsgType::SENDHEADERS);
     
-    // Start sync if we need blocks
-    if (sync_ && sync_->GetState() == SyncState::NOT_SYNCING) {
+    // Ask outbound peers for addresses, allowing the whole answer in
+    if (addrman_ && peer.IsOutbound()) {
+        {
+            std::lock_guard<std::mutex> lock(addrMutex_);
+            addrRelay_[peer.GetId()].allowance.Grant(MAX_ADDR_TO_SEND);
+        }
+        peer.QueueMessage(NetMsgType::GETADDR);
+    }
+    
+    // Offer compact blocks; high-bandwidth mode waits until the peer has
+    // proved quick to deliver
+    if (options_.compactBlocks) {
+        peer.QueueMessage(NetMsgType::SENDCMPCT,
+                          SendCmpctMessage(false, COMPACT_BLOCK_VERSION));
+    }
+    
+    // Start sync if we need blocks: header sync not yet under way, or a
+    // peer that has blocks we lack
+    if (sync_ && (sync_->GetState() == SyncState::NOT_SYNCING ||
+                  sync_->GetState() == SyncState::HEADERS_SYNC ||
+                  peer.GetStartingHeight() > chainHeight_.load())) {
         // Get locator from chain state
         BlockLocator locator;
         if (chainman_) {
@@ -493,6 +807,9 @@ bool MessageProcessor::HandlePong(Peer& peer, DataStream& payload) {
     } else {
         LOG_DEBUG(util::LogCategory::NET) << "Pong from peer " << peer.GetId() 
                                           << ", latency=" << peer.GetPingLatency() << "ms";
+        if (sync_) {
+            sync_->UpdatePeerLatency(peer.GetId(), peer.GetPingLatency());
+        }
     }
     
     return true;
@@ -532,6 +849,9 @@ bool MessageProcessor::HandleInv(Peer& peer, DataStream& payload) {
         
         // Track that peer has this inventory
         peer.AddInventory(item);
+        if (item.type == InvType::MSG_TX) {
+            reconciliation_.TryRemoveFromSet(peer.GetId(), TxHash(item.hash));
+        }
     }
     
     // Penalize if too many invalid inventory types
@@ -548,8 +868,26 @@ bool MessageProcessor::HandleInv(Peer& peer, DataStream& payload) {
     LOG_DEBUG(util::LogCategory::NET) << "Received " << inv.size() 
                                       << " inv items from peer " << peer.GetId();
     
+    // New blocks at the tip are fetched as compact blocks where the peer
+    // speaks them; the synchronizer handles the rest
+    if (ShouldRequestCompact(peer)) {
+        std::vector<Inv> compactRequests;
+        auto it = std::remove_if(inv.begin(), inv.end(), [&](const Inv& item) {
+            if (item.type != InvType::MSG_BLOCK ||
+                chainman_->LookupBlockIndex(BlockHash(item.hash))) {
+                return false;
+            }
+            compactRequests.emplace_back(InvType::MSG_CMPCT_BLOCK, item.hash);
+            return true;
+        });
+        inv.erase(it, inv.end());
+        if (!compactRequests.empty()) {
+            SendGetData(peer, compactRequests);
+        }
+    }
+    
     // Forward to sync manager for blocks
-    if (sync_) {
+    if (sync_ && !inv.empty()) {
         sync_->ProcessInv(peer.GetId(), inv);
     }
     
@@ -561,7 +899,7 @@ bool MessageProcessor::HandleInv(Peer& peer, DataStream& payload) {
                 // Check if we already have this tx
                 // Convert Hash256 to TxHash for mempool lookup
                 TxHash txid(item.hash);
-                if (!mempool_->Exists(txid)) {
+                if (!mempool_->Exists(txid) && !orphans_.HaveTx(txid)) {
                     txToRequest.push_back(item);
                 }
             }
@@ -608,8 +946,8 @@ bool MessageProcessor::HandleGetData(Peer& peer, DataStream& payload) {
                     DataStream stream;
                     Serialize(stream, *tx);
                     std::vector<uint8_t> payload(stream.begin(), stream.end());
-                    auto msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::TX, payload);
-                    peer.QueueSend(msg);
+                    peer.QueueSend(CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::TX,
+                                                         std::move(payload)));
                     served = true;
                 }
             } else if (item.type == InvType::MSG_BLOCK && chainman_ && blockdb_) {
@@ -618,25 +956,44 @@ bool MessageProcessor::HandleGetData(Peer& peer, DataStream& payload) {
                 BlockIndex* pindex = chainman_->LookupBlockIndex(blockHash);
                 
                 if (pindex && HasStatus(pindex->nStatus, BlockStatus::HAVE_DATA)) {
-                    // Read block from disk
-                    db::DiskBlockPos pos(pindex->nFile, pindex->nDataPos);
-                    Block block;
-                    db::Status status = blockdb_->ReadBlock(pos, block);
+                    // Past the upload target, old blocks are not served at
+                    // all; a peer syncing from us has to look elsewhere
+                    bool historical = IsHistoricalBlock(*pindex);
+                    if (historical && connman_ && connman_->IsUploadTargetReached()) {
+                        LOG_INFO(util::LogCategory::NET) << "Upload target reached, "
+                            << "disconnecting peer " << peer.GetId()
+                            << " asking for historical block";
+                        peer.Disconnect();
+                        return true;
+                    }
                     
-                    if (status.ok()) {
-                        // Serialize and send the block
-                        DataStream stream;
-                        Serialize(stream, block);
-                        std::vector<uint8_t> blockPayload(stream.begin(), stream.end());
-                        auto msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK, blockPayload);
-                        peer.QueueSend(msg);
+                    std::optional<OutboundMessage> msg = GetBlockMessage(blockHash, *pindex);
+                    if (msg) {
+                        peer.QueueSend(*msg, historical ? SendPriority::BULK
+                                                        : SendPriority::HIGH);
                         served = true;
                         
                         LOG_DEBUG(util::LogCategory::NET) << "Sent block " 
                             << blockHash.ToHex().substr(0, 16) << "... to peer " << peer.GetId();
-                    } else {
-                        LOG_WARN(util::LogCategory::NET) << "Failed to read block from disk: " 
-                            << status.ToString();
+                    }
+                }
+            } else if (item.type == InvType::MSG_CMPCT_BLOCK && chainman_ && blockdb_) {
+                BlockHash blockHash(item.hash);
+                BlockIndex* pindex = chainman_->LookupBlockIndex(blockHash);
+                BlockIndex* tip = chainman_->GetActiveTip();
+                
+                if (pindex && HasStatus(pindex->nStatus, BlockStatus::HAVE_DATA)) {
+                    // The asker has long seen the transactions of deep blocks
+                    Block block;
+                    if (tip && tip->nHeight - pindex->nHeight <= MAX_CMPCTBLOCK_DEPTH) {
+                        if (ReadBlock(*pindex, block)) {
+                            SendCompactBlock(peer, block);
+                            served = true;
+                        }
+                    } else if (auto msg = GetBlockMessage(blockHash, *pindex)) {
+                        peer.QueueSend(*msg, IsHistoricalBlock(*pindex) ? SendPriority::BULK
+                                                                        : SendPriority::NORMAL);
+                        served = true;
                     }
                 }
             }
@@ -656,7 +1013,7 @@ bool MessageProcessor::HandleGetData(Peer& peer, DataStream& payload) {
         }
         std::vector<uint8_t> data(stream.begin(), stream.end());
         auto msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::NOTFOUND, data);
-        peer.QueueSend(msg);
+        peer.QueueSend(std::move(msg));
     }
     
     return true;
@@ -685,6 +1042,240 @@ bool MessageProcessor::HandleNotFound(Peer& peer, DataStream& payload) {
     return true;
 }
 
+// ============================================================================
+// Compact Block Handlers
+// ============================================================================
+
+bool MessageProcessor::HandleSendCmpct(Peer& peer, DataStream& payload) {
+    SendCmpctMessage msg;
+    msg.Unserialize(payload);
+    
+    // Versions we don't speak are ignored, as the protocol asks
+    if (msg.version != COMPACT_BLOCK_VERSION) {
+        return true;
+    }
+    
+    std::lock_guard<std::mutex> lock(compactMutex_);
+    CompactPeerState& state = compactPeers_[peer.GetId()];
+    state.supported = true;
+    state.highBandwidth = msg.highBandwidth;
+    return true;
+}
+
+bool MessageProcessor::HandleCmpctBlock(Peer& peer, DataStream& payload) {
+    CompactBlock cmpct;
+    cmpct.Unserialize(payload);
+    BlockHash hash = cmpct.header.GetHash();
+    peer.AddInventory(Inv(InvType::MSG_BLOCK, hash));
+    
+    if (!options_.compactBlocks) {
+        return true;
+    }
+    
+    if (chainman_) {
+        BlockIndex* pindex = chainman_->LookupBlockIndex(hash);
+        if (pindex && HasStatus(pindex->nStatus, BlockStatus::HAVE_DATA)) {
+            return true;
+        }
+        // Rebuilding walks the whole mempool: only for blocks on a parent
+        // we know
+        if (!chainman_->LookupBlockIndex(cmpct.header.hashPrevBlock)) {
+            LOG_DEBUG(util::LogCategory::NET) << "Compact block " << hash.ToHex().substr(0, 16)
+                                              << " from peer " << peer.GetId()
+                                              << " has an unknown parent";
+            return true;
+        }
+    }
+    
+    PartiallyDownloadedBlock partial;
+    CompactReadStatus status = partial.Init(cmpct, mempool_);
+    if (status == CompactReadStatus::INVALID) {
+        peer.Misbehaving(100, "Invalid compact block");
+        return false;
+    }
+    if (status == CompactReadStatus::FAILED) {
+        RequestFullBlock(peer, hash);
+        return true;
+    }
+    
+    std::vector<uint16_t> missing = partial.GetMissingIndexes();
+    LOG_DEBUG(util::LogCategory::NET) << "Compact block " << hash.ToHex().substr(0, 16)
+                                      << " from peer " << peer.GetId() << ": "
+                                      << partial.GetMempoolCount() << " from mempool, "
+                                      << missing.size() << " missing";
+    
+    if (missing.empty()) {
+        Block block;
+        if (partial.FillBlock(block, {}) != CompactReadStatus::OK) {
+            RequestFullBlock(peer, hash);
+            return true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(statsMutex_);
+            stats_.compactBlocksFromMempool++;
+        }
+        MaybeSetHighBandwidth(peer);
+        DeliverBlock(peer, block);
+        return true;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(compactMutex_);
+        if (pendingCompact_.size() >= MAX_PENDING_COMPACT_BLOCKS &&
+            pendingCompact_.find(hash) == pendingCompact_.end()) {
+            pendingCompact_.erase(pendingCompact_.begin());
+        }
+        pendingCompact_[hash] = PendingCompactBlock{peer.GetId(), std::move(partial)};
+    }
+    
+    BlockTxnRequest request;
+    request.blockHash = hash;
+    request.indexes = std::move(missing);
+    peer.QueueMessage(NetMsgType::GETBLOCKTXN, request);
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.blockTxnRequests++;
+    }
+    return true;
+}
+
+bool MessageProcessor::HandleGetBlockTxn(Peer& peer, DataStream& payload) {
+    BlockTxnRequest request;
+    request.Unserialize(payload);
+    
+    if (!chainman_ || !blockdb_) {
+        return true;
+    }
+    BlockIndex* pindex = chainman_->LookupBlockIndex(request.blockHash);
+    if (!pindex || !HasStatus(pindex->nStatus, BlockStatus::HAVE_DATA)) {
+        return true;
+    }
+    
+    // Anyone still rebuilding a deep block is better off with all of it
+    BlockIndex* tip = chainman_->GetActiveTip();
+    if (!tip || tip->nHeight - pindex->nHeight > MAX_BLOCKTXN_DEPTH) {
+        if (auto msg = GetBlockMessage(request.blockHash, *pindex)) {
+            peer.QueueSend(*msg);
+        }
+        return true;
+    }
+    
+    Block block;
+    if (!ReadBlock(*pindex, block)) {
+        return true;
+    }
+    
+    BlockTxn response;
+    response.blockHash = request.blockHash;
+    response.txs.reserve(request.indexes.size());
+    for (uint16_t index : request.indexes) {
+        if (index >= block.vtx.size()) {
+            peer.Misbehaving(100, "Out-of-range getblocktxn index");
+            return false;
+        }
+        response.txs.push_back(block.vtx[index]);
+    }
+    peer.QueueMessage(NetMsgType::BLOCKTXN, response);
+    return true;
+}
+
+bool MessageProcessor::HandleBlockTxn(Peer& peer, DataStream& payload) {
+    BlockTxn response;
+    response.Unserialize(payload);
+    
+    PartiallyDownloadedBlock partial;
+    {
+        std::lock_guard<std::mutex> lock(compactMutex_);
+        auto it = pendingCompact_.find(response.blockHash);
+        if (it == pendingCompact_.end() || it->second.peer != peer.GetId()) {
+            return true;  // Not asked of this peer (or given up on)
+        }
+        partial = std::move(it->second.block);
+        pendingCompact_.erase(it);
+    }
+    
+    Block block;
+    CompactReadStatus status = partial.FillBlock(block, response.txs);
+    if (status == CompactReadStatus::INVALID) {
+        peer.Misbehaving(100, "Invalid blocktxn");
+        return false;
+    }
+    if (status == CompactReadStatus::FAILED) {
+        RequestFullBlock(peer, response.blockHash);
+        return true;
+    }
+    
+    MaybeSetHighBandwidth(peer);
+    DeliverBlock(peer, block);
+    return true;
+}
+
+bool MessageProcessor::ShouldRequestCompact(const Peer& peer) const {
+    if (!options_.compactBlocks || !chainman_ || !mempool_) {
+        return false;
+    }
+    // During initial download our mempool has nothing to rebuild from
+    if (sync_ && sync_->GetState() != SyncState::SYNCED &&
+        sync_->GetState() != SyncState::NEARLY_SYNCED &&
+        sync_->GetState() != SyncState::NOT_SYNCING) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(compactMutex_);
+    auto it = compactPeers_.find(peer.GetId());
+    return it != compactPeers_.end() && it->second.supported;
+}
+
+void MessageProcessor::MaybeSetHighBandwidth(Peer& peer) {
+    std::optional<Peer::Id> demoted;
+    {
+        std::lock_guard<std::mutex> lock(compactMutex_);
+        auto it = compactPeers_.find(peer.GetId());
+        if (it == compactPeers_.end() || !it->second.supported) {
+            return;
+        }
+        auto pos = std::find(highBandwidthPeers_.begin(), highBandwidthPeers_.end(),
+                             peer.GetId());
+        if (pos != highBandwidthPeers_.end()) {
+            // Already pushing to us: now the most recent to deliver
+            highBandwidthPeers_.erase(pos);
+            highBandwidthPeers_.push_back(peer.GetId());
+            return;
+        }
+        highBandwidthPeers_.push_back(peer.GetId());
+        if (highBandwidthPeers_.size() > MAX_HIGH_BANDWIDTH_PEERS) {
+            demoted = highBandwidthPeers_.front();
+            highBandwidthPeers_.pop_front();
+        }
+    }
+    
+    peer.QueueMessage(NetMsgType::SENDCMPCT, SendCmpctMessage(true, COMPACT_BLOCK_VERSION));
+    if (demoted && connman_) {
+        if (auto other = connman_->GetPeer(*demoted)) {
+            other->QueueMessage(NetMsgType::SENDCMPCT,
+                                SendCmpctMessage(false, COMPACT_BLOCK_VERSION));
+        }
+    }
+}
+
+void MessageProcessor::SendCompactBlock(Peer& peer, const Block& block) {
+    DataStream stream;
+    CompactBlock(block, GetRandUint64()).Serialize(stream);
+    peer.QueueSend(CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::CMPCTBLOCK,
+                                         std::vector<uint8_t>(stream.begin(), stream.end())),
+                   SendPriority::HIGH);
+    
+    LOG_DEBUG(util::LogCategory::NET) << "Sent compact block "
+        << block.GetHash().ToHex().substr(0, 16) << "... to peer " << peer.GetId();
+}
+
+void MessageProcessor::RequestFullBlock(Peer& peer, const BlockHash& hash) {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.compactFallbacks++;
+    }
+    SendGetData(peer, {Inv(InvType::MSG_BLOCK, hash)});
+}
+
 // ============================================================================
 // Block/Header Handlers
 // ============================================================================
@@ -721,6 +1312,16 @@ bool MessageProcessor::HandleHeaders(Peer& peer, DataStream& payload) {
     LOG_DEBUG(util::LogCategory::NET) << "Received " << headers.size() 
                                       << " headers from peer " << peer.GetId();
     
+    // A single header on our tip is a new block announcement
+    if (headers.size() == 1 && ShouldRequestCompact(peer)) {
+        BlockIndex* tip = chainman_->GetActiveTip();
+        BlockHash hash = headers[0].GetHash();
+        if (tip && headers[0].hashPrevBlock == tip->GetBlockHash() &&
+            !chainman_->LookupBlockIndex(hash)) {
+            SendGetData(peer, {Inv(InvType::MSG_CMPCT_BLOCK, hash)});
+        }
+    }
+    
     // Forward to sync manager
     if (sync_) {
         if (!sync_->ProcessHeaders(peer.GetId(), headers)) {
@@ -734,23 +1335,29 @@ bool MessageProcessor::HandleHeaders(Peer& peer, DataStream& payload) {
 }
 
 bool MessageProcessor::HandleBlock(Peer& peer, DataStream& payload) {
+    SHURIUM_TRACE_SPAN("MessageProcessor::HandleBlock");
     Block block;
-    Unserialize(payload, block);
+    UnserializeWithArena(payload, block);
     
     LOG_DEBUG(util::LogCategory::NET) << "Received block " 
                                       << block.GetHash().ToHex().substr(0, 16)
                                       << " from peer " << peer.GetId();
     
+    DeliverBlock(peer, block);
+    return true;
+}
+
+void MessageProcessor::DeliverBlock(Peer& peer, const Block& block) {
     // Forward to sync manager
     if (sync_) {
         if (!sync_->ProcessBlock(peer.GetId(), block)) {
             LOG_DEBUG(util::LogCategory::NET) << "Failed to process block from peer " 
                                               << peer.GetId();
             // Sync manager decides whether to penalize
+        } else {
+            peer.RecordBlockRelayed();
         }
     }
-    
-    return true;
 }
 
 bool MessageProcessor::HandleGetHeaders(Peer& peer, DataStream& payload) {
@@ -761,13 +1368,36 @@ bool MessageProcessor::HandleGetHeaders(Peer& peer, DataStream& payload) {
                                       << " with " << msg.locator.vHave.size() << " locator hashes";
     
     // Use callback if available
+    std::vector<BlockHeader> headers;
     if (getHeadersCallback_) {
-        auto headers = getHeadersCallback_(msg.locator, msg.hashStop);
-        if (!headers.empty()) {
-            SendHeaders(peer, headers);
+        headers = getHeadersCallback_(msg.locator, msg.hashStop);
+    } else if (chainman_) {
+        // Our active chain after the first locator block on it, as for
+        // getblocks
+        const Chain& chain = chainman_->GetActiveChain();
+        BlockMap& blockIndex = chainman_->GetBlockIndex();
+        BlockIndex* pindex = nullptr;
+        for (const auto& hash : msg.locator.vHave) {
+            auto it = blockIndex.find(hash);
+            if (it != blockIndex.end() && chain.Contains(it->second)) {
+                pindex = it->second;
+                break;
+            }
+        }
+        pindex = chain.Next(pindex ? pindex : chain.Genesis());
+        while (pindex && headers.size() < MAX_HEADERS_RESULTS) {
+            headers.push_back(pindex->GetBlockHeader());
+            if (pindex->GetBlockHash() == msg.hashStop) {
+                break;
+            }
+            pindex = chain.Next(pindex);
         }
     }
     
+    if (!headers.empty()) {
+        SendHeaders(peer, headers);
+    }
+    
     return true;
 }
 
@@ -790,7 +1420,7 @@ bool MessageProcessor::HandleGetBlocks(Peer& peer, DataStream& payload) {
         BlockMap& blockIndex = chainman_->GetBlockIndex();
         auto it = blockIndex.find(hash);
         if (it != blockIndex.end()) {
-            pindex = it->second.get();
+            pindex = it->second;
             // Make sure it's on the main chain
             if (chain.Contains(pindex)) {
                 break;
@@ -832,6 +1462,236 @@ bool MessageProcessor::HandleGetBlocks(Peer& peer, DataStream& payload) {
     return true;
 }
 
+// ============================================================================
+// Payload Compression
+// ============================================================================
+
+bool MessageProcessor::HandleSendCompr(Peer& peer, DataStream& payload) {
+    SendComprMessage msg;
+    msg.Unserialize(payload);
+    
+    // Only valid between version and verack
+    if (peer.IsEstablished()) {
+        peer.Misbehaving(10, "sendcompr after verack");
+        return true;
+    }
+    
+    if (options_.compression &&
+        (msg.algorithms & static_cast<uint32_t>(CompressionAlgorithm::LZ4)) != 0) {
+        peer.EnableCompression(options_.compressionPolicy);
+        LOG_DEBUG(util::LogCategory::NET) << "Compressing messages to peer " << peer.GetId();
+    }
+    return true;
+}
+
+// ============================================================================
+// Compact Block Filters
+// ============================================================================
+
+const BlockIndex* MessageProcessor::PrepareBlockFilterRequest(Peer& peer, uint8_t filterType,
+                                                              uint32_t startHeight,
+                                                              const Hash256& stopHash,
+                                                              uint32_t maxCount) {
+    if (!filterIndex_ || !chainman_ ||
+        filterType != static_cast<uint8_t>(filterIndex_->GetFilterType())) {
+        peer.Misbehaving(100, "Filter request for an unsupported filter type");
+        return nullptr;
+    }
+
+    const BlockIndex* stop = chainman_->LookupBlockIndex(BlockHash(stopHash));
+    if (!stop) {
+        peer.Misbehaving(100, "Filter request for an unknown block");
+        return nullptr;
+    }
+    if (startHeight > static_cast<uint32_t>(stop->nHeight) ||
+        static_cast<uint32_t>(stop->nHeight) - startHeight >= maxCount) {
+        peer.Misbehaving(100, "Filter request for an invalid range");
+        return nullptr;
+    }
+    return stop;
+}
+
+bool MessageProcessor::HandleGetCFilters(Peer& peer, DataStream& payload) {
+    GetCFiltersMessage msg;
+    msg.Unserialize(payload);
+
+    const BlockIndex* stop = PrepareBlockFilterRequest(peer, msg.filterType, msg.startHeight,
+                                                       msg.stopHash, MAX_GETCFILTERS_SIZE);
+    if (!stop) {
+        return false;
+    }
+
+    // Look everything up first; a range the index has not reached is ignored
+    std::vector<CFilterMessage> filters(stop->nHeight - msg.startHeight + 1);
+    const BlockIndex* pindex = stop;
+    for (size_t i = filters.size(); i-- > 0; pindex = pindex->pprev) {
+        auto entry = filterIndex_->GetEntry(pindex->GetBlockHash());
+        if (!entry) {
+            LOG_DEBUG(util::LogCategory::NET) << "getcfilters from peer " << peer.GetId()
+                                              << " reaches past the filter index";
+            return true;
+        }
+        filters[i].filterType = msg.filterType;
+        filters[i].blockHash = pindex->GetBlockHash();
+        filters[i].filter = std::move(entry->encoded);
+    }
+    for (const CFilterMessage& filter : filters) {
+        peer.QueueMessage(NetMsgType::CFILTER, filter);
+    }
+    return true;
+}
+
+bool MessageProcessor::HandleGetCFHeaders(Peer& peer, DataStream& payload) {
+    GetCFHeadersMessage msg;
+    msg.Unserialize(payload);
+
+    const BlockIndex* stop = PrepareBlockFilterRequest(peer, msg.filterType, msg.startHeight,
+                                                       msg.stopHash, MAX_GETCFHEADERS_SIZE);
+    if (!stop) {
+        return false;
+    }
+
+    CFHeadersMessage response;
+    response.filterType = msg.filterType;
+    response.stopHash = msg.stopHash;
+    response.filterHashes.resize(stop->nHeight - msg.startHeight + 1);
+    const BlockIndex* pindex = stop;
+    for (size_t i = response.filterHashes.size(); i-- > 0; pindex = pindex->pprev) {
+        auto entry = filterIndex_->GetEntry(pindex->GetBlockHash());
+        if (!entry) {
+            LOG_DEBUG(util::LogCategory::NET) << "getcfheaders from peer " << peer.GetId()
+                                              << " reaches past the filter index";
+            return true;
+        }
+        response.filterHashes[i] = entry->filterHash;
+    }
+
+    // The header before genesis is all zeroes
+    if (pindex) {
+        auto prevHeader = filterIndex_->GetFilterHeader(pindex->GetBlockHash());
+        if (!prevHeader) {
+            return true;
+        }
+        response.prevHeader = *prevHeader;
+    }
+    peer.QueueMessage(NetMsgType::CFHEADERS, response);
+    return true;
+}
+
+// ============================================================================
+// Transaction Reconciliation
+// ============================================================================
+
+bool MessageProcessor::HandleSendTxRcncl(Peer& peer, DataStream& payload) {
+    SendTxRcnclMessage msg;
+    msg.Unserialize(payload);
+    
+    // Only valid between version and verack
+    if (peer.IsEstablished()) {
+        peer.Misbehaving(10, "sendtxrcncl after verack");
+        return true;
+    }
+    
+    auto result = reconciliation_.RegisterPeer(peer.GetId(), peer.IsInbound(),
+                                               msg.version, msg.salt);
+    switch (result) {
+        case ReconRegisterResult::SUCCESS:
+            LOG_DEBUG(util::LogCategory::NET) << "Reconciling transactions with peer "
+                                              << peer.GetId();
+            break;
+        case ReconRegisterResult::PROTOCOL_VIOLATION:
+            peer.Misbehaving(10, "Invalid sendtxrcncl");
+            break;
+        case ReconRegisterResult::NOT_FOUND:
+        case ReconRegisterResult::ALREADY_REGISTERED:
+            // We did not offer it, or the peer said it twice
+            break;
+    }
+    return true;
+}
+
+bool MessageProcessor::HandleReqRecon(Peer& peer, DataStream& payload) {
+    ReqReconMessage msg;
+    msg.Unserialize(payload);
+    
+    auto sketch = reconciliation_.HandleReqRecon(peer.GetId(), msg);
+    if (!sketch) {
+        LOG_DEBUG(util::LogCategory::NET) << "Ignoring reqrecon out of turn from peer "
+                                          << peer.GetId();
+        return true;
+    }
+    peer.QueueMessage(NetMsgType::SKETCH, *sketch);
+    return true;
+}
+
+bool MessageProcessor::HandleSketch(Peer& peer, DataStream& payload) {
+    SketchMessage msg;
+    msg.Unserialize(payload);
+    
+    auto outcome = reconciliation_.HandleSketch(peer.GetId(), msg);
+    if (!outcome) {
+        LOG_DEBUG(util::LogCategory::NET) << "Ignoring unrequested sketch from peer "
+                                          << peer.GetId();
+        return true;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        if (outcome->diff.success) {
+            stats_.reconciliations++;
+        } else {
+            stats_.reconciliationFailures++;
+        }
+    }
+    
+    peer.QueueMessage(NetMsgType::RECONCILDIFF, outcome->diff);
+    AnnounceTransactions(peer, outcome->announce);
+    return true;
+}
+
+bool MessageProcessor::HandleReconcilDiff(Peer& peer, DataStream& payload) {
+    ReconcilDiffMessage msg;
+    msg.Unserialize(payload);
+    
+    auto announce = reconciliation_.HandleReconcilDiff(peer.GetId(), msg);
+    if (!announce) {
+        LOG_DEBUG(util::LogCategory::NET) << "Ignoring unexpected reconcildiff from peer "
+                                          << peer.GetId();
+        return true;
+    }
+    AnnounceTransactions(peer, *announce);
+    return true;
+}
+
+void MessageProcessor::RequestReconciliation() {
+    if (!connman_ || !options_.txReconciliation) return;
+    
+    std::vector<std::shared_ptr<Peer>> initiating;
+    for (auto& peer : connman_->GetAllPeers()) {
+        if (peer && peer->IsEstablished() && reconciliation_.IsInitiator(peer->GetId())) {
+            initiating.push_back(std::move(peer));
+        }
+    }
+    if (initiating.empty()) return;
+    
+    auto& peer = initiating[reconCursor_++ % initiating.size()];
+    if (auto request = reconciliation_.InitiateReconciliation(peer->GetId())) {
+        peer->QueueMessage(NetMsgType::REQRECON, *request);
+    }
+}
+
+void MessageProcessor::AnnounceTransactions(Peer& peer, const std::vector<TxHash>& txids) {
+    std::vector<Inv> inv;
+    inv.reserve(txids.size());
+    for (const auto& txid : txids) {
+        Inv item(InvType::MSG_TX, txid);
+        if (peer.HasInventory(item)) continue;
+        peer.AddInventory(item);
+        inv.push_back(item);
+    }
+    SendInv(peer, inv);
+}
+
 // ============================================================================
 // Transaction Handler
 // ============================================================================
@@ -851,42 +1711,131 @@ bool MessageProcessor::HandleTx(Peer& peer, DataStream& payload) {
     
     // Mark that peer has this tx
     peer.AddInventory(Inv(InvType::MSG_TX, txHash));
+    reconciliation_.TryRemoveFromSet(peer.GetId(), txHash);
     
-    // Try to accept to mempool
-    if (mempool_ && coins_) {
-        auto txRef = MakeTransactionRef(std::move(mtx));
-        auto result = AcceptToMempool(txRef, *mempool_, *coins_, chainHeight_.load());
-        
-        if (result.IsValid()) {
-            LOG_DEBUG(util::LogCategory::NET) << "Accepted tx " << txHash.ToHex().substr(0, 16)
-                                              << " to mempool, fee=" << result.fee;
-            // Relay to other peers (exclude the sender)
-            RelayTransaction(txHash, peer.GetId());
-        } else {
-            LOG_DEBUG(util::LogCategory::NET) << "Rejected tx " << txHash.ToHex().substr(0, 16)
-                                              << ": " << result.rejectReason;
-            // Don't penalize for invalid txs from inv (they might just be outdated)
-        }
+    // Queue for the batch validated after this round of messages, so a
+    // parent and child arriving together are judged as one package
+    if (mempool_ && coins_ && !orphans_.HaveTx(txHash)) {
+        std::lock_guard<std::mutex> lock(pendingTxMutex_);
+        pendingTxs_.emplace_back(MakeTransactionRef(std::move(mtx)), peer.GetId());
     }
     
     return true;
 }
 
+void MessageProcessor::AcceptPendingTxs() {
+    std::vector<std::pair<TransactionRef, Peer::Id>> pending;
+    {
+        std::lock_guard<std::mutex> lock(pendingTxMutex_);
+        pending.swap(pendingTxs_);
+    }
+    if (pending.empty() || !mempool_ || !coins_) return;
+    
+    CheckQueue* checkQueue = chainman_ ? chainman_->GetScriptCheckQueue() : nullptr;
+    int64_t now = GetTime();
+    
+    // Orphans whose parents were just accepted go round again; every
+    // acceptance frees a given orphan at most once, so this ends
+    while (!pending.empty()) {
+        std::vector<std::pair<TransactionRef, Peer::Id>> resolved;
+        for (size_t begin = 0; begin < pending.size(); begin += MAX_PACKAGE_COUNT) {
+            size_t end = std::min(pending.size(), begin + MAX_PACKAGE_COUNT);
+            std::vector<TransactionRef> package;
+            package.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                package.push_back(pending[i].first);
+            }
+            
+            auto results = AcceptPackage(package, *mempool_, *coins_, chainHeight_.load(), checkQueue);
+            
+            // Children of invalid transactions are not worth keeping
+            std::unordered_set<TxHash, SaltedHash256Hasher> invalid;
+            for (size_t i = begin; i < end; ++i) {
+                const auto& result = results.results[i - begin];
+                if (!result.IsValid() && result.rejectReason != "missing-inputs") {
+                    invalid.insert(pending[i].first->GetHash());
+                }
+            }
+            
+            for (size_t i = begin; i < end; ++i) {
+                const auto& result = results.results[i - begin];
+                const Transaction& tx = *pending[i].first;
+                const TxHash& txHash = tx.GetHash();
+                if (result.IsValid()) {
+                    LOG_DEBUG(util::LogCategory::NET) << "Accepted tx " << txHash.ToHex().substr(0, 16)
+                                                      << " to mempool, fee=" << result.fee;
+                    // Relay to other peers (exclude the sender)
+                    RelayTransaction(txHash, pending[i].second);
+                    if (auto from = connman_ ? connman_->GetPeer(pending[i].second) : nullptr) {
+                        from->RecordTxRelayed();
+                    }
+                    for (auto& orphan : orphans_.TakeChildren(tx)) {
+                        resolved.emplace_back(std::move(orphan.tx), orphan.fromPeer);
+                    }
+                } else if (result.rejectReason == "missing-inputs" &&
+                           std::none_of(tx.vin.begin(), tx.vin.end(), [&](const TxIn& txin) {
+                               return invalid.count(TxHash(txin.prevout.hash)) > 0;
+                           })) {
+                    if (orphans_.AddTx(pending[i].first, pending[i].second, now)) {
+                        LOG_DEBUG(util::LogCategory::NET) << "Holding orphan tx "
+                                                          << txHash.ToHex().substr(0, 16);
+                    }
+                } else {
+                    LOG_DEBUG(util::LogCategory::NET) << "Rejected tx " << txHash.ToHex().substr(0, 16)
+                                                      << ": " << result.rejectReason;
+                    // Don't penalize for invalid txs from inv (they might just be outdated)
+                }
+            }
+        }
+        pending.swap(resolved);
+    }
+}
+
+void MessageProcessor::BlockConnected(const Block& block) {
+    orphans_.EraseForBlock(block.vtx);
+    
+    std::lock_guard<std::mutex> lock(pendingTxMutex_);
+    for (const auto& tx : block.vtx) {
+        for (auto& orphan : orphans_.TakeChildren(*tx)) {
+            pendingTxs_.emplace_back(std::move(orphan.tx), orphan.fromPeer);
+        }
+    }
+}
+
+void MessageProcessor::PeerDisconnected(Peer::Id peerId) {
+    orphans_.EraseForPeer(peerId);
+    reconciliation_.ForgetPeer(peerId);
+    {
+        std::lock_guard<std::mutex> lock(addrMutex_);
+        addrTimers_.Cancel(static_cast<uint64_t>(peerId));
+        addrRelay_.erase(peerId);
+    }
+    
+    std::lock_guard<std::mutex> lock(compactMutex_);
+    compactPeers_.erase(peerId);
+    highBandwidthPeers_.erase(
+        std::remove(highBandwidthPeers_.begin(), highBandwidthPeers_.end(), peerId),
+        highBandwidthPeers_.end());
+    for (auto it = pendingCompact_.begin(); it != pendingCompact_.end();) {
+        it = it->second.peer == peerId ? pendingCompact_.erase(it) : std::next(it);
+    }
+}
+
 bool MessageProcessor::HandleMempool(Peer& peer) {
     if (!options_.relayTransactions || !mempool_) {
         return true;
     }
     
     // Get all tx info from mempool and send as inv
-    auto txInfos = mempool_->GetAllTxInfo();
+    auto snapshot = mempool_->GetSnapshot();
     
-    if (txInfos.empty()) {
+    if (snapshot->txs.empty()) {
         return true;
     }
     
     std::vector<Inv> inv;
-    inv.reserve(txInfos.size());
-    for (const auto& info : txInfos) {
+    inv.reserve(snapshot->txs.size());
+    for (const auto& info : snapshot->txs) {
         inv.emplace_back(InvType::MSG_TX, info.tx->GetHash());
     }
     
@@ -936,9 +1885,29 @@ bool MessageProcessor::HandleAddr(Peer& peer, DataStream& payload) {
     
     LOG_DEBUG(util::LogCategory::NET) << "Received " << msg.addresses.size() 
                                       << " addresses from peer " << peer.GetId();
+    if (msg.addresses.empty()) {
+        return true;
+    }
+    
+    // Only as many as the peer's allowance covers are looked at
+    size_t received = msg.addresses.size();
+    size_t allowed;
+    {
+        std::lock_guard<std::mutex> lock(addrMutex_);
+        allowed = addrRelay_[peer.GetId()].allowance.Take(received,
+                                                          std::chrono::steady_clock::now());
+    }
+    if (allowed < received) {
+        msg.addresses.resize(allowed);
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.addrRateLimited += received - allowed;
+    }
+    if (msg.addresses.empty()) {
+        return true;
+    }
     
     // Add addresses to address manager for future connections
-    if (addrman_ && !msg.addresses.empty()) {
+    if (addrman_) {
         // Get peer's address as source
         NetService source(peer.GetAddress());
         
@@ -949,9 +1918,105 @@ bool MessageProcessor::HandleAddr(Peer& peer, DataStream& payload) {
                                           << peer.GetId();
     }
     
+    // Unsolicited announcements travel on; answers to a getaddr do not
+    if (received <= MAX_ADDR_RELAY_MESSAGE) {
+        RelayAddresses(peer.GetId(), msg.addresses);
+    }
+    
     return true;
 }
 
+void MessageProcessor::RelayAddresses(Peer::Id from, const std::vector<PeerAddress>& addresses) {
+    if (!connman_) {
+        return;
+    }
+    std::vector<Peer::Id> candidates;
+    for (const auto& peer : connman_->GetAllPeers()) {
+        if (peer && peer->IsEstablished() && peer->GetId() != from) {
+            candidates.push_back(peer->GetId());
+        }
+    }
+    if (candidates.empty()) {
+        return;
+    }
+    
+    int64_t now = GetAdjustedTime();
+    // An address goes to the same peers all day, so hearing it again
+    // spreads it no further
+    uint64_t day = static_cast<uint64_t>(now / (24 * 60 * 60));
+    std::vector<std::pair<uint64_t, Peer::Id>> ranked(candidates.size());
+    
+    std::lock_guard<std::mutex> lock(addrMutex_);
+    auto nowTick = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - addrEpoch_).count());
+    for (const auto& addr : addresses) {
+        if (!addr.IsRoutable() || addr.GetTime() < now - ADDR_RELAY_MAX_AGE) {
+            continue;
+        }
+        std::array<uint8_t, sizeof(AddressKey) + 8> data{};
+        AddressKey key = GetAddressKey(addr);
+        std::copy(key.begin(), key.end(), data.begin());
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            int64_t id = candidates[i];
+            std::memcpy(data.data() + key.size(), &id, sizeof(id));
+            ranked[i] = {SipHash13(addrSalt0_ ^ day, addrSalt1_, data.data(), data.size()),
+                         candidates[i]};
+        }
+        size_t fanout = std::min(ADDR_RELAY_FANOUT, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + fanout, ranked.end());
+        
+        for (size_t i = 0; i < fanout; ++i) {
+            AddrRelayState& state = addrRelay_[ranked[i].second];
+            if (state.queued.size() >= MAX_ADDR_TO_SEND) {
+                continue;
+            }
+            if (state.queued.empty()) {
+                // Exponential wait, so sends to different peers do not line up
+                double uniform = static_cast<double>(GetRandUint64() >> 11) * 0x1.0p-53;
+                double wait = -std::log1p(-uniform) * options_.addrTrickleMs;
+                addrTimers_.Add(static_cast<uint64_t>(ranked[i].second),
+                                nowTick + static_cast<uint64_t>(wait), 0, nullptr);
+            }
+            state.queued.push_back(addr);
+        }
+    }
+}
+
+void MessageProcessor::SendAddrRelay() {
+    std::vector<std::pair<Peer::Id, std::vector<PeerAddress>>> due;
+    {
+        std::lock_guard<std::mutex> lock(addrMutex_);
+        if (addrTimers_.Size() == 0) {
+            return;
+        }
+        std::vector<util::TimerWheel::Expired> expired;
+        addrTimers_.Advance(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - addrEpoch_).count()), expired);
+        for (const auto& timer : expired) {
+            auto it = addrRelay_.find(static_cast<Peer::Id>(timer.id));
+            if (it != addrRelay_.end() && !it->second.queued.empty()) {
+                due.emplace_back(it->first, std::move(it->second.queued));
+                it->second.queued.clear();
+            }
+        }
+    }
+    
+    for (auto& [peerId, addresses] : due) {
+        auto peer = connman_ ? connman_->GetPeer(peerId) : nullptr;
+        if (!peer || !peer->IsEstablished()) {
+            continue;
+        }
+        size_t count = addresses.size();
+        AddrMessage msg;
+        msg.addresses = std::move(addresses);
+        peer->QueueMessage(NetMsgType::ADDR, msg);
+        
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.addrRelayed += count;
+    }
+}
+
 // ============================================================================
 // Feature Negotiation
 // ============================================================================
@@ -1112,7 +2177,7 @@ void MessageProcessor::SendHeaders(Peer& peer, const std::vector<BlockHeader>& h
     
     std::vector<uint8_t> payload(stream.begin(), stream.end());
     auto msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::HEADERS, payload);
-    peer.QueueSend(msg);
+    peer.QueueSend(std::move(msg));
 }
 
 void MessageProcessor::SendInv(Peer& peer, const std::vector<Inv>& inv) {
@@ -1131,7 +2196,7 @@ void MessageProcessor::SendInv(Peer& peer, const std::vector<Inv>& inv) {
         
         std::vector<uint8_t> payload(stream.begin(), stream.end());
         auto msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::INV, payload);
-        peer.QueueSend(msg);
+        peer.QueueSend(std::move(msg));
         
         offset += count;
     }
@@ -1148,7 +2213,51 @@ void MessageProcessor::SendGetData(Peer& peer, const std::vector<Inv>& inv) {
     
     std::vector<uint8_t> payload(stream.begin(), stream.end());
     auto msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::GETDATA, payload);
-    peer.QueueSend(msg);
+    peer.QueueSend(std::move(msg));
+}
+
+bool MessageProcessor::ReadBlock(const BlockIndex& index, Block& block) {
+    db::DiskBlockPos pos(index.nFile, index.nDataPos);
+    db::Status status = blockdb_->ReadBlock(pos, block);
+    if (!status.ok()) {
+        LOG_WARN(util::LogCategory::NET) << "Failed to read block from disk: " 
+            << status.ToString();
+        return false;
+    }
+    return true;
+}
+
+bool MessageProcessor::IsHistoricalBlock(const BlockIndex& index) const {
+    return static_cast<int64_t>(index.nTime) < GetTime() - HISTORICAL_BLOCK_AGE;
+}
+
+std::optional<OutboundMessage> MessageProcessor::GetBlockMessage(const BlockHash& hash,
+                                                                  const BlockIndex& index) {
+    {
+        std::lock_guard<std::mutex> lock(servedBlocksMutex_);
+        for (const auto& [servedHash, msg] : servedBlocks_) {
+            if (servedHash == hash) {
+                return msg;
+            }
+        }
+    }
+    
+    Block block;
+    if (!ReadBlock(index, block)) {
+        return std::nullopt;
+    }
+    
+    DataStream stream;
+    Serialize(stream, block);
+    OutboundMessage msg = CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK,
+                                                std::vector<uint8_t>(stream.begin(), stream.end()));
+    
+    std::lock_guard<std::mutex> lock(servedBlocksMutex_);
+    servedBlocks_.emplace_back(hash, msg);
+    if (servedBlocks_.size() > MAX_SERVED_BLOCK_MESSAGES) {
+        servedBlocks_.pop_front();
+    }
+    return msg;
 }
 
 // ============================================================================
@@ -1175,7 +2284,24 @@ void MessageProcessor::RelayTransaction(const TxHash& txid, Peer::Id excludePeer
     std::vector<Inv> invVec;
     invVec.emplace_back(InvType::MSG_TX, txid);
     
+    // Reconciling peers get the tx in their set, bar the few it is
+    // flooded to
+    std::vector<Peer::Id> reconOutbound;
+    std::vector<Peer::Id> reconInbound;
+    for (const auto& peer : peers) {
+        if (!peer || peer->GetId() == excludePeer ||
+            !reconciliation_.IsPeerRegistered(peer->GetId())) {
+            continue;
+        }
+        (peer->IsInbound() ? reconInbound : reconOutbound).push_back(peer->GetId());
+    }
+    std::set<Peer::Id> fanout;
+    if (!reconOutbound.empty() || !reconInbound.empty()) {
+        fanout = reconciliation_.GetFanoutTargets(txid, reconOutbound, reconInbound);
+    }
+    
     int relayCount = 0;
+    int reconCount = 0;
     int filteredCount = 0;
     for (auto& peer : peers) {
         if (!peer || !peer->IsEstablished()) continue;
@@ -1191,6 +2317,12 @@ void MessageProcessor::RelayTransaction(const TxHash& txid, Peer::Id excludePeer
             continue;  // Skip this peer - tx doesn't meet their fee threshold
         }
         
+        // Held for reconciliation; announced only if the peer lacks it then
+        if (!fanout.count(peer->GetId()) && reconciliation_.AddToSet(peer->GetId(), txid)) {
+            ++reconCount;
+            continue;
+        }
+        
         // Mark peer as having this tx (so we don't send again)
         peer->AddInventory(invVec[0]);
         
@@ -1204,7 +2336,8 @@ void MessageProcessor::RelayTransaction(const TxHash& txid, Peer::Id excludePeer
                                           << " peers due to fee filter (tx fee: " 
                                           << txFeeRatePerK << " sat/kB)";
     }
-    LOG_DEBUG(util::LogCategory::NET) << "Relayed tx to " << relayCount << " peers";
+    LOG_DEBUG(util::LogCategory::NET) << "Relayed tx to " << relayCount << " peers, "
+                                      << reconCount << " by reconciliation";
 }
 
 void MessageProcessor::RelayBlock(const BlockHash& blockHash, Peer::Id excludePeer) {
@@ -1257,6 +2390,40 @@ void MessageProcessor::RelayBlock(const BlockHash& blockHash, Peer::Id excludePe
                                       << " (" << headersCount << " via headers)";
 }
 
+void MessageProcessor::RelayBlock(const Block& block, Peer::Id excludePeer) {
+    if (!connman_) return;
+    
+    BlockHash blockHash = block.GetHash();
+    
+    std::vector<Peer::Id> pushTo;
+    if (options_.compactBlocks) {
+        std::lock_guard<std::mutex> lock(compactMutex_);
+        for (const auto& [id, state] : compactPeers_) {
+            if (state.highBandwidth && id != excludePeer) {
+                pushTo.push_back(id);
+            }
+        }
+    }
+    
+    if (!pushTo.empty()) {
+        // One encoding for all of them
+        DataStream stream;
+        CompactBlock(block, GetRandUint64()).Serialize(stream);
+        OutboundMessage msg = CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::CMPCTBLOCK,
+                                                    std::vector<uint8_t>(stream.begin(), stream.end()));
+        Inv inv(InvType::MSG_BLOCK, blockHash);
+        for (Peer::Id id : pushTo) {
+            auto peer = connman_->GetPeer(id);
+            if (!peer || !peer->IsEstablished() || peer->HasInventory(inv)) continue;
+            peer->AddInventory(inv);
+            peer->QueueSend(msg, SendPriority::HIGH);
+        }
+    }
+    
+    // Peers that got the compact block already hold its inventory
+    RelayBlock(blockHash, excludePeer);
+}
+
 void MessageProcessor::QueueTransactionRelay(const TxHash& txid) {
     std::lock_guard<std::mutex> lock(relayMutex_);
     pendingTxRelay_.push_back(txid);
@@ -0,0 +1,309 @@
+// SHURIUM - Set Sketches Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/network/minisketch.h>
+
+#include <algorithm>
+
+namespace shurium {
+
+namespace {
+
+// ============================================================================
+// GF(2^32)
+// ============================================================================
+
+/// x^32 = x^7 + x^3 + x^2 + 1
+constexpr uint32_t FIELD_MODULUS = 0x8D;
+
+/// Carryless product of a 32-bit value and the modulus' low bits
+inline uint64_t MulByModulus(uint64_t v) {
+    return v ^ (v << 2) ^ (v << 3) ^ (v << 7);
+}
+
+uint32_t Mul(uint32_t a, uint32_t b) {
+    // Four bits of b at a time against the multiples of a
+    uint64_t table[16];
+    table[0] = 0;
+    for (int i = 1; i < 16; ++i) {
+        table[i] = (i & 1) ? table[i - 1] ^ a : table[i >> 1] << 1;
+    }
+    uint64_t r = 0;
+    for (int shift = 28; shift >= 0; shift -= 4) {
+        r = (r << 4) ^ table[(b >> shift) & 0xF];
+    }
+
+    // Fold the high half back in twice: 32 + 7 bits, then 7 + 7
+    uint64_t folded = MulByModulus(r >> 32);
+    uint64_t low = (r & 0xFFFFFFFFULL) ^ folded;
+    low ^= MulByModulus(folded >> 32);
+    return static_cast<uint32_t>(low);
+}
+
+inline uint32_t Sqr(uint32_t a) { return Mul(a, a); }
+
+/// a^(2^32 - 2)
+uint32_t Inv(uint32_t a) {
+    uint32_t result = 1;
+    uint32_t base = a;
+    for (uint32_t e = 0xFFFFFFFEU; e != 0; e >>= 1) {
+        if (e & 1) result = Mul(result, base);
+        base = Sqr(base);
+    }
+    return result;
+}
+
+// ============================================================================
+// Polynomials over GF(2^32), lowest coefficient first
+// ============================================================================
+
+using Poly = std::vector<uint32_t>;
+
+void Trim(Poly& p) {
+    while (!p.empty() && p.back() == 0) p.pop_back();
+}
+
+/// p mod m, m monic and trimmed
+void ModInPlace(Poly& p, const Poly& m) {
+    size_t dm = m.size() - 1;
+    while (p.size() > dm) {
+        uint32_t lead = p.back();
+        if (lead != 0) {
+            size_t offset = p.size() - 1 - dm;
+            for (size_t i = 0; i < dm; ++i) {
+                p[offset + i] ^= Mul(lead, m[i]);
+            }
+        }
+        p.pop_back();
+    }
+    Trim(p);
+}
+
+void MakeMonic(Poly& p) {
+    uint32_t inv = Inv(p.back());
+    for (auto& c : p) c = Mul(c, inv);
+}
+
+/// Quotient of p by m, m monic and dividing p
+Poly Divide(Poly p, const Poly& m) {
+    size_t dm = m.size() - 1;
+    Poly q(p.size() - dm, 0);
+    while (p.size() > dm) {
+        uint32_t lead = p.back();
+        size_t offset = p.size() - 1 - dm;
+        q[offset] = lead;
+        if (lead != 0) {
+            for (size_t i = 0; i < dm; ++i) {
+                p[offset + i] ^= Mul(lead, m[i]);
+            }
+        }
+        p.pop_back();
+    }
+    return q;
+}
+
+/// Monic gcd
+Poly Gcd(Poly a, Poly b) {
+    Trim(a);
+    Trim(b);
+    while (!b.empty()) {
+        MakeMonic(b);
+        ModInPlace(a, b);
+        std::swap(a, b);
+    }
+    if (!a.empty()) MakeMonic(a);
+    return a;
+}
+
+/// p^2 mod m: squaring is linear in characteristic 2
+Poly SqrMod(const Poly& p, const Poly& m) {
+    Poly r(p.empty() ? 0 : 2 * p.size() - 1, 0);
+    for (size_t i = 0; i < p.size(); ++i) {
+        r[2 * i] = Sqr(p[i]);
+    }
+    ModInPlace(r, m);
+    return r;
+}
+
+/// Whether monic f divides x^(2^32) - x: all its roots are distinct and
+/// in the field
+bool SplitsWithDistinctRoots(const Poly& f) {
+    Poly x = {0, 1};
+    ModInPlace(x, f);
+    Poly t = x;
+    for (int i = 0; i < 32; ++i) {
+        t = SqrMod(t, f);
+    }
+    return t == x;
+}
+
+/// Deterministic stream for the splitting elements
+uint32_t NextSplitter(uint64_t& state) {
+    state += 0x9E3779B97F4A7C15ULL;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<uint32_t>(z ^ (z >> 31));
+}
+
+/**
+ * Roots of monic f known to split with distinct roots. Tr(a*x) is 0 on
+ * about half the field, so gcd(f, Tr(a*x) mod f) splits f in two for most a.
+ */
+bool FindRoots(const Poly& f, std::vector<uint32_t>& roots, uint64_t& state) {
+    size_t degree = f.size() - 1;
+    if (degree == 0) return true;
+    if (degree == 1) {
+        roots.push_back(f[0]);
+        return true;
+    }
+
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        uint32_t a = NextSplitter(state);
+        if (a == 0) continue;
+
+        Poly t = {0, a};
+        ModInPlace(t, f);
+        Poly trace = t;
+        for (int i = 1; i < 32; ++i) {
+            t = SqrMod(t, f);
+            trace.resize(std::max(trace.size(), t.size()), 0);
+            for (size_t j = 0; j < t.size(); ++j) trace[j] ^= t[j];
+        }
+
+        Poly g = Gcd(f, trace);
+        if (g.size() < 2 || g.size() == f.size()) continue;
+
+        return FindRoots(g, roots, state) && FindRoots(Divide(f, g), roots, state);
+    }
+    return false;
+}
+
+/// Berlekamp-Massey: shortest connection polynomial of the syndromes
+Poly BerlekampMassey(const std::vector<uint32_t>& s) {
+    Poly c = {1};
+    Poly b = {1};
+    size_t length = 0;
+    size_t shift = 1;
+    uint32_t lastDiscrepancy = 1;
+
+    for (size_t n = 0; n < s.size(); ++n) {
+        uint32_t d = s[n];
+        for (size_t i = 1; i <= length && i < c.size(); ++i) {
+            d ^= Mul(c[i], s[n - i]);
+        }
+        if (d == 0) {
+            ++shift;
+            continue;
+        }
+
+        uint32_t scale = Mul(d, Inv(lastDiscrepancy));
+        Poly prev = c;
+        if (c.size() < b.size() + shift) c.resize(b.size() + shift, 0);
+        for (size_t i = 0; i < b.size(); ++i) {
+            c[i + shift] ^= Mul(scale, b[i]);
+        }
+        if (2 * length <= n) {
+            length = n + 1 - length;
+            b = std::move(prev);
+            lastDiscrepancy = d;
+            shift = 1;
+        } else {
+            ++shift;
+        }
+    }
+
+    c.resize(length + 1, 0);
+    return c;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Minisketch
+// ============================================================================
+
+Minisketch::Minisketch(size_t capacity) : sums_(capacity, 0) {}
+
+void Minisketch::Add(uint32_t element) {
+    if (element == 0) return;
+
+    uint32_t squared = Sqr(element);
+    uint32_t power = element;
+    for (auto& sum : sums_) {
+        sum ^= power;
+        power = Mul(power, squared);
+    }
+}
+
+bool Minisketch::Merge(const Minisketch& other) {
+    if (other.sums_.size() != sums_.size()) return false;
+    for (size_t i = 0; i < sums_.size(); ++i) {
+        sums_[i] ^= other.sums_[i];
+    }
+    return true;
+}
+
+std::vector<uint8_t> Minisketch::Serialize() const {
+    std::vector<uint8_t> out;
+    out.reserve(sums_.size() * MINISKETCH_ELEMENT_BYTES);
+    for (uint32_t sum : sums_) {
+        for (size_t i = 0; i < MINISKETCH_ELEMENT_BYTES; ++i) {
+            out.push_back(static_cast<uint8_t>(sum >> (8 * i)));
+        }
+    }
+    return out;
+}
+
+std::optional<Minisketch> Minisketch::Deserialize(const std::vector<uint8_t>& data) {
+    if (data.size() % MINISKETCH_ELEMENT_BYTES != 0) {
+        return std::nullopt;
+    }
+    Minisketch sketch(data.size() / MINISKETCH_ELEMENT_BYTES);
+    for (size_t i = 0; i < sketch.sums_.size(); ++i) {
+        uint32_t sum = 0;
+        for (size_t j = 0; j < MINISKETCH_ELEMENT_BYTES; ++j) {
+            sum |= static_cast<uint32_t>(data[i * MINISKETCH_ELEMENT_BYTES + j]) << (8 * j);
+        }
+        sketch.sums_[i] = sum;
+    }
+    return sketch;
+}
+
+std::optional<std::vector<uint32_t>> Minisketch::Decode(size_t maxElements) const {
+    maxElements = std::min(maxElements, sums_.size());
+    if (std::all_of(sums_.begin(), sums_.end(), [](uint32_t v) { return v == 0; })) {
+        return std::vector<uint32_t>{};
+    }
+
+    // Even power sums follow from the odd ones: s(2k) = s(k)^2
+    std::vector<uint32_t> syndromes(2 * sums_.size());
+    for (size_t k = 0; k < syndromes.size(); ++k) {
+        size_t power = k + 1;
+        syndromes[k] = (power & 1) ? sums_[k / 2] : Sqr(syndromes[power / 2 - 1]);
+    }
+
+    // The connection polynomial is prod(1 - x_i z); reversed, its roots
+    // are the elements themselves
+    Poly c = BerlekampMassey(syndromes);
+    size_t count = c.size() - 1;
+    if (count == 0 || count > maxElements || c.back() == 0) {
+        return std::nullopt;
+    }
+    Poly locator(c.rbegin(), c.rend());
+    if (!SplitsWithDistinctRoots(locator)) {
+        return std::nullopt;
+    }
+
+    std::vector<uint32_t> roots;
+    roots.reserve(count);
+    uint64_t state = 0;
+    if (!FindRoots(locator, roots, state) || roots.size() != count) {
+        return std::nullopt;
+    }
+    std::sort(roots.begin(), roots.end());
+    return roots;
+}
+
+} // namespace shurium
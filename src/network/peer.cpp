@@ -3,12 +3,190 @@
 
 #include <shurium/network/peer.h>
 #include <shurium/core/random.h>
+#include <shurium/util/metrics.h>
 
 #include <algorithm>
 #include <cstring>
 
 namespace shurium {
 
+namespace {
+
+util::Counter& CopiedBytes() {
+    static util::Counter& counter = util::MetricsRegistry::Instance().GetCounter(
+        "shurium_net_bytes_copied_total", "Bytes copied between network buffers");
+    return counter;
+}
+
+} // anonymous namespace
+
+void RecordNetworkCopy(size_t bytes) {
+    CopiedBytes().Inc(bytes);
+}
+
+uint64_t GetNetworkBytesCopied() {
+    return CopiedBytes().Value();
+}
+
+// ============================================================================
+// Send Queue
+// ============================================================================
+
+void SendQueue::Push(SendBuffer buffer, SendPriority priority, bool endsMessage) {
+    size_t index = static_cast<size_t>(priority);
+    Lane& lane = lanes_[index];
+    size_t size = buffer ? buffer->size() : 0;
+    if (size > 0) {
+        if (lane.messageOpen) {
+            lane.messages.back() += size;
+        } else {
+            lane.messages.push_back(size);
+        }
+        lane.bytes += size;
+        bytes_ += size;
+        lane.buffers.push_back(std::move(buffer));
+    }
+    if (!lane.messageOpen || !endsMessage) {
+        lane.messageOpen = !endsMessage && (size > 0 || lane.messageOpen);
+        return;
+    }
+    lane.messageOpen = false;
+    
+    // A message sent as far as it went is now complete
+    if (lane.messages.size() == 1 && lane.messages.front() == 0) {
+        lane.messages.pop_front();
+        lane.frontMessageSent = 0;
+        if (midMessage_ == static_cast<int>(index)) {
+            midMessage_ = -1;
+        }
+    }
+}
+
+void SendQueue::Append(SendQueue&& other) {
+    if (bytes_ == 0) {
+        midMessage_ = other.midMessage_;
+    }
+    for (size_t i = 0; i < SEND_PRIORITY_COUNT; ++i) {
+        Lane& lane = lanes_[i];
+        Lane& from = other.lanes_[i];
+        if (lane.buffers.empty()) {
+            lane.frontOffset = from.frontOffset;
+            lane.frontMessageSent = from.frontMessageSent;
+        } else if (from.frontOffset > 0 && !from.buffers.empty()) {
+            // The other queue's partly sent front cannot keep its offset
+            // behind our buffers, so its unsent tail becomes a buffer of
+            // its own
+            const auto& front = *from.buffers.front();
+            lane.buffers.push_back(std::make_shared<const std::vector<uint8_t>>(
+                front.begin() + from.frontOffset, front.end()));
+            from.buffers.pop_front();
+        }
+        for (auto& buffer : from.buffers) {
+            lane.buffers.push_back(std::move(buffer));
+        }
+        if (lane.messageOpen && !from.messages.empty()) {
+            lane.messages.back() += from.messages.front();
+            from.messages.pop_front();
+        }
+        lane.messages.insert(lane.messages.end(), from.messages.begin(), from.messages.end());
+        lane.messageOpen = lane.messageOpen || from.messageOpen;
+        lane.bytes += from.bytes;
+        from = Lane();
+    }
+    bytes_ += other.bytes_;
+    other.bytes_ = 0;
+    other.midMessage_ = -1;
+}
+
+size_t SendQueue::Size(SendPriority priority) const {
+    return lanes_[static_cast<size_t>(priority)].bytes;
+}
+
+size_t SendQueue::BufferCount() const {
+    size_t count = 0;
+    for (const auto& lane : lanes_) {
+        count += lane.buffers.size();
+    }
+    return count;
+}
+
+SendPriority SendQueue::Current() const {
+    if (midMessage_ >= 0) {
+        return static_cast<SendPriority>(midMessage_);
+    }
+    for (size_t i = 0; i < SEND_PRIORITY_COUNT; ++i) {
+        if (lanes_[i].bytes > 0) {
+            return static_cast<SendPriority>(i);
+        }
+    }
+    return SendPriority::NORMAL;
+}
+
+size_t SendQueue::Peek(Segment* out, size_t maxSegments) const {
+    const Lane& lane = lanes_[static_cast<size_t>(Current())];
+    size_t count = 0;
+    size_t offset = lane.frontOffset;
+    for (auto it = lane.buffers.begin(); it != lane.buffers.end() && count < maxSegments; ++it) {
+        out[count].data = (*it)->data() + offset;
+        out[count].size = (*it)->size() - offset;
+        out[count].buffer = &*it;
+        ++count;
+        offset = 0;
+    }
+    return count;
+}
+
+void SendQueue::Consume(size_t n) {
+    size_t index = static_cast<size_t>(Current());
+    Lane& lane = lanes_[index];
+    n = std::min(n, lane.bytes);
+    lane.bytes -= n;
+    bytes_ -= n;
+    
+    // Message boundaries first: they decide which class goes next
+    size_t left = n;
+    while (left > 0) {
+        size_t take = std::min(left, lane.messages.front());
+        lane.messages.front() -= take;
+        lane.frontMessageSent += take;
+        left -= take;
+        bool open = lane.messageOpen && lane.messages.size() == 1;
+        if (lane.messages.front() == 0 && !open) {
+            lane.messages.pop_front();
+            lane.frontMessageSent = 0;
+        }
+    }
+    midMessage_ = lane.frontMessageSent > 0 ? static_cast<int>(index) : -1;
+    
+    while (n > 0) {
+        size_t frontLeft = lane.buffers.front()->size() - lane.frontOffset;
+        if (n < frontLeft) {
+            lane.frontOffset += n;
+            return;
+        }
+        n -= frontLeft;
+        lane.buffers.pop_front();
+        lane.frontOffset = 0;
+    }
+}
+
+std::vector<uint8_t> SendQueue::Pop(size_t maxBytes) {
+    std::vector<uint8_t> data;
+    data.reserve(std::min(maxBytes, bytes_));
+    while (data.size() < maxBytes && !Empty()) {
+        const Lane& lane = lanes_[static_cast<size_t>(Current())];
+        size_t before = data.size();
+        for (auto it = lane.buffers.begin(); it != lane.buffers.end() && data.size() < maxBytes; ++it) {
+            size_t offset = (it == lane.buffers.begin()) ? lane.frontOffset : 0;
+            size_t take = std::min((*it)->size() - offset, maxBytes - data.size());
+            data.insert(data.end(), (*it)->begin() + offset, (*it)->begin() + offset + take);
+        }
+        Consume(data.size() - before);
+    }
+    RecordNetworkCopy(data.size());
+    return data;
+}
+
 // ============================================================================
 // Factory Methods
 // ============================================================================
@@ -44,6 +222,9 @@ void Peer::SetState(PeerState newState) {
     if (stateHandler_ && oldState != newState) {
         stateHandler_(*this, oldState, newState);
     }
+    if (newState == PeerState::ESTABLISHED && oldState != newState) {
+        NotifyActivity();
+    }
 }
 
 void Peer::Disconnect(DisconnectReason reason) {
@@ -170,6 +351,7 @@ bool Peer::ProcessPong(uint64_t nonce) {
     }
     
     pingNonce_ = 0;
+    NotifyActivity();
     return true;
 }
 
@@ -216,28 +398,44 @@ void Peer::RecordMessageReceived() {
     stats_.messagesRecv++;
 }
 
+void Peer::RecordBlockRelayed() {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.lastBlockTime = GetTime();
+    }
+    NotifyActivity();
+}
+
+void Peer::RecordTxRelayed() {
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.lastTxTime = GetTime();
+    }
+    NotifyActivity();
+}
+
 // ============================================================================
 // Inventory Tracking
 // ============================================================================
 
 bool Peer::HasAnnounced(const Inv& inv) const {
     std::lock_guard<std::mutex> lock(invMutex_);
-    return announcedByUs_.count(inv) > 0;
+    return announcedByUs_.Contains(inv);
 }
 
 void Peer::MarkAnnounced(const Inv& inv) {
     std::lock_guard<std::mutex> lock(invMutex_);
-    announcedByUs_.insert(inv);
+    announcedByUs_.Insert(inv);
 }
 
 bool Peer::HasInventory(const Inv& inv) const {
     std::lock_guard<std::mutex> lock(invMutex_);
-    return announcedToUs_.count(inv) > 0;
+    return announcedToUs_.Contains(inv);
 }
 
 void Peer::AddInventory(const Inv& inv) {
     std::lock_guard<std::mutex> lock(invMutex_);
-    announcedToUs_.insert(inv);
+    announcedToUs_.Insert(inv);
 }
 
 size_t Peer::GetAnnouncementQueueSize() const {
@@ -248,7 +446,7 @@ size_t Peer::GetAnnouncementQueueSize() const {
 void Peer::QueueAnnouncement(const Inv& inv) {
     std::lock_guard<std::mutex> lock(invMutex_);
     // Don't queue if already announced
-    if (announcedByUs_.count(inv) == 0) {
+    if (!announcedByUs_.Contains(inv)) {
         announcementQueue_.push_back(inv);
     }
 }
@@ -261,9 +459,9 @@ std::vector<Inv> Peer::GetAnnouncementsToSend(size_t maxCount) {
         Inv inv = announcementQueue_.front();
         announcementQueue_.pop_front();
         
-        if (announcedByUs_.count(inv) == 0) {
+        if (!announcedByUs_.Contains(inv)) {
             result.push_back(inv);
-            announcedByUs_.insert(inv);
+            announcedByUs_.Insert(inv);
         }
     }
     
@@ -292,83 +490,199 @@ bool Peer::Misbehaving(int howMuch, const std::string& /* reason */) {
 // ============================================================================
 
 void Peer::QueueSend(const std::vector<uint8_t>& data) {
+    QueueSend(std::make_shared<const std::vector<uint8_t>>(data));
+}
+
+void Peer::QueueSend(std::vector<uint8_t>&& data) {
+    QueueSend(std::make_shared<const std::vector<uint8_t>>(std::move(data)));
+}
+
+void Peer::QueueSend(SendBuffer buffer) {
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        sendQueue_.Push(std::move(buffer));
+    }
+    NotifySendReady();
+}
+
+void Peer::QueueSend(const OutboundMessage& msg, SendPriority priority) {
+    bool compress = false;
+    if (msg.payload) {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        compress = sendCompression_ &&
+                   sendCompression_->ShouldCompress(msg.command, msg.payload->size());
+    }
+    
+    // Compress outside the lock; peers sent the same message share the work
+    if (compress) {
+        if (auto compressed = GetCompressedMessage(msg)) {
+            {
+                std::lock_guard<std::mutex> lock(statsMutex_);
+                stats_.compressionSavedSent += msg.payload->size() - compressed->payload->size();
+            }
+            {
+                std::lock_guard<std::mutex> lock(sendMutex_);
+                sendQueue_.Push(compressed->header, priority, false);
+                sendQueue_.Push(compressed->payload, priority);
+            }
+            NotifySendReady();
+            return;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        sendQueue_.Push(msg.header, priority, false);
+        sendQueue_.Push(msg.payload, priority);
+    }
+    NotifySendReady();
+}
+
+void Peer::SetSendReadyHandler(SendReadyHandler handler) {
+    std::lock_guard<std::mutex> lock(sendReadyMutex_);
+    sendReadyHandler_ = std::move(handler);
+}
+
+void Peer::NotifySendReady() {
+    // Held across the call, so a handler being replaced is never running
+    std::lock_guard<std::mutex> lock(sendReadyMutex_);
+    if (sendReadyHandler_) {
+        sendReadyHandler_(*this);
+    }
+}
+
+void Peer::SetActivityHandler(ActivityHandler handler) {
+    std::lock_guard<std::mutex> lock(activityMutex_);
+    activityHandler_ = std::move(handler);
+}
+
+void Peer::NotifyActivity() {
+    std::lock_guard<std::mutex> lock(activityMutex_);
+    if (activityHandler_) {
+        activityHandler_(*this);
+    }
+}
+
+void Peer::EnableCompression(CompressionPolicy policy) {
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        sendCompression_ = std::move(policy);
+    }
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.fCompressing = true;
+}
+
+bool Peer::IsCompressing() const {
     std::lock_guard<std::mutex> lock(sendMutex_);
-    sendBuffer_.insert(sendBuffer_.end(), data.begin(), data.end());
+    return sendCompression_.has_value();
 }
 
 void Peer::QueueMessage(const std::string& command) {
-    std::vector<uint8_t> emptyPayload;
-    auto msg = CreateMessage(networkMagic_, command, emptyPayload);
-    QueueSend(msg);
+    QueueSend(CreateOutboundMessage(networkMagic_, command, {}));
 }
 
 std::vector<uint8_t> Peer::GetSendData(size_t maxBytes) {
     std::lock_guard<std::mutex> lock(sendMutex_);
-    size_t toSend = std::min(maxBytes, sendBuffer_.size());
-    std::vector<uint8_t> data(sendBuffer_.begin(), sendBuffer_.begin() + toSend);
-    sendBuffer_.erase(sendBuffer_.begin(), sendBuffer_.begin() + toSend);
-    return data;
+    return sendQueue_.Pop(maxBytes);
+}
+
+SendQueue Peer::TakeSendQueue() {
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    SendQueue taken;
+    taken.Append(std::move(sendQueue_));
+    return taken;
 }
 
 bool Peer::HasDataToSend() const {
     std::lock_guard<std::mutex> lock(sendMutex_);
-    return !sendBuffer_.empty();
+    return !sendQueue_.Empty();
 }
 
-void Peer::AddReceivedData(const std::vector<uint8_t>& data) {
-    std::lock_guard<std::mutex> lock(recvMutex_);
-    recvBuffer_.insert(recvBuffer_.end(), data.begin(), data.end());
+size_t Peer::GetSendQueueSize() const {
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    return sendQueue_.Size();
 }
 
-std::optional<std::pair<std::string, std::vector<uint8_t>>> Peer::GetNextMessage() {
+void Peer::AddReceivedData(const uint8_t* data, size_t len) {
     std::lock_guard<std::mutex> lock(recvMutex_);
     
-    // Need at least a header
-    if (recvBuffer_.size() < MESSAGE_HEADER_SIZE) {
-        return std::nullopt;
-    }
-    
-    // Parse header
-    std::vector<uint8_t> headerBytes(recvBuffer_.begin(), 
-                                      recvBuffer_.begin() + MESSAGE_HEADER_SIZE);
-    auto headerOpt = ParseMessageHeader(headerBytes);
-    if (!headerOpt) {
-        // Invalid header - clear buffer and disconnect
-        recvBuffer_.clear();
-        Disconnect(DisconnectReason::PROTOCOL_ERROR);
-        return std::nullopt;
-    }
-    
-    const auto& header = *headerOpt;
-    
-    // Check magic
-    if (!header.IsValidMagic(networkMagic_)) {
-        recvBuffer_.clear();
-        Disconnect(DisconnectReason::PROTOCOL_ERROR);
-        return std::nullopt;
-    }
-    
-    // Wait for full payload
-    size_t totalSize = MESSAGE_HEADER_SIZE + header.payloadSize;
-    if (recvBuffer_.size() < totalSize) {
-        return std::nullopt;
+    // After a framing error nothing further can be trusted to line up
+    while (!recvFailed_ && (len > 0 || (recvHeader_ && recvHeader_->payloadSize == 0))) {
+        if (!recvHeader_) {
+            size_t take = std::min(len, MESSAGE_HEADER_SIZE - recvHeaderSize_);
+            std::memcpy(recvHeaderBytes_.data() + recvHeaderSize_, data, take);
+            RecordNetworkCopy(take);
+            recvHeaderSize_ += take;
+            data += take;
+            len -= take;
+            if (recvHeaderSize_ < MESSAGE_HEADER_SIZE) {
+                return;
+            }
+            recvHeaderSize_ = 0;
+            
+            MessageHeader header;
+            SpanReader reader(recvHeaderBytes_.data(), MESSAGE_HEADER_SIZE);
+            header.Unserialize(reader);
+            if (!header.IsValid() || !header.IsValidMagic(networkMagic_)) {
+                recvFailed_ = true;
+                Disconnect(DisconnectReason::PROTOCOL_ERROR);
+                return;
+            }
+            recvHeader_ = header;
+            recvPayload_.clear();
+            recvPayload_.reserve(header.payloadSize);
+        }
+        
+        size_t take = std::min(len, recvHeader_->payloadSize - recvPayload_.size());
+        recvPayload_.insert(recvPayload_.end(), data, data + take);
+        RecordNetworkCopy(take);
+        data += take;
+        len -= take;
+        if (recvPayload_.size() < recvHeader_->payloadSize) {
+            return;
+        }
+        
+        if (!VerifyChecksum(recvPayload_, recvHeader_->checksum)) {
+            recvFailed_ = true;
+            Disconnect(DisconnectReason::PROTOCOL_ERROR);
+            return;
+        }
+        if (recvHeader_->IsCompressed()) {
+            // Only once we have said we decode them
+            std::optional<std::vector<uint8_t>> raw;
+            if (acceptCompressed_.load()) {
+                raw = DecompressPayload(recvPayload_, MAX_PROTOCOL_MESSAGE_LENGTH);
+            }
+            if (!raw) {
+                recvFailed_ = true;
+                Disconnect(DisconnectReason::PROTOCOL_ERROR);
+                return;
+            }
+            // A peer may send a frame larger than its contents; it saved nothing
+            if (raw->size() > recvPayload_.size()) {
+                std::lock_guard<std::mutex> statsLock(statsMutex_);
+                stats_.compressionSavedRecv += raw->size() - recvPayload_.size();
+            }
+            recvPayload_ = std::move(*raw);
+        }
+        recvMessages_.emplace_back(recvHeader_->GetCommand(), std::move(recvPayload_));
+        recvPayload_ = std::vector<uint8_t>();
+        recvHeader_.reset();
     }
-    
-    // Extract payload
-    std::vector<uint8_t> payload(recvBuffer_.begin() + MESSAGE_HEADER_SIZE,
-                                  recvBuffer_.begin() + totalSize);
-    
-    // Verify checksum
-    if (!VerifyChecksum(payload, header.checksum)) {
-        recvBuffer_.clear();
-        Disconnect(DisconnectReason::PROTOCOL_ERROR);
+}
+
+std::optional<std::pair<std::string, std::vector<uint8_t>>> Peer::GetNextMessage() {
+    std::lock_guard<std::mutex> lock(recvMutex_);
+    if (recvMessages_.empty()) {
         return std::nullopt;
     }
-    
-    // Remove message from buffer
-    recvBuffer_.erase(recvBuffer_.begin(), recvBuffer_.begin() + totalSize);
-    
-    return std::make_pair(header.GetCommand(), std::move(payload));
+    auto msg = std::move(recvMessages_.front());
+    recvMessages_.pop_front();
+    return msg;
+}
+
+size_t Peer::GetReceivedMessageCount() const {
+    std::lock_guard<std::mutex> lock(recvMutex_);
+    return recvMessages_.size();
 }
 
 } // namespace shurium
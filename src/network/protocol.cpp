@@ -2,9 +2,11 @@
 // Distributed under the MIT software license
 
 #include <shurium/network/protocol.h>
+#include <shurium/network/compression.h>
 #include <shurium/crypto/sha256.h>
 #include <shurium/util/time.h>
 
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <set>
@@ -41,35 +43,82 @@ std::array<uint8_t, 4> ComputeChecksum(const std::vector<uint8_t>& payload) {
     return checksum;
 }
 
-std::vector<uint8_t> CreateMessage(const std::array<uint8_t, 4>& magic,
-                                    const std::string& command,
-                                    const std::vector<uint8_t>& payload) {
-    // Build header
+std::vector<uint8_t> CreateMessageHeader(const std::array<uint8_t, 4>& magic,
+                                         const std::string& command,
+                                         const std::vector<uint8_t>& payload) {
     MessageHeader header;
     header.magic = magic;
     header.SetCommand(command);
     header.payloadSize = static_cast<uint32_t>(payload.size());
     header.checksum = ComputeChecksum(payload);
     
-    // Serialize header
     DataStream headerStream;
     header.Serialize(headerStream);
-    
+    return std::vector<uint8_t>(headerStream.begin(), headerStream.end());
+}
+
+std::vector<uint8_t> CreateMessage(const std::array<uint8_t, 4>& magic,
+                                    const std::string& command,
+                                    const std::vector<uint8_t>& payload) {
     // Combine header and payload
-    std::vector<uint8_t> result;
+    std::vector<uint8_t> result = CreateMessageHeader(magic, command, payload);
     result.reserve(MESSAGE_HEADER_SIZE + payload.size());
-    result.insert(result.end(), headerStream.begin(), headerStream.end());
     result.insert(result.end(), payload.begin(), payload.end());
     
     return result;
 }
 
+OutboundMessage CreateOutboundMessage(const std::array<uint8_t, 4>& magic,
+                                      const std::string& command,
+                                      std::vector<uint8_t> payload) {
+    OutboundMessage msg;
+    msg.header = std::make_shared<const std::vector<uint8_t>>(
+        CreateMessageHeader(magic, command, payload));
+    msg.payload = std::make_shared<const std::vector<uint8_t>>(std::move(payload));
+    msg.command = command;
+    msg.compressed = std::make_shared<OutboundMessage::Compressed>();
+    return msg;
+}
+
+std::optional<OutboundMessage> GetCompressedMessage(const OutboundMessage& msg) {
+    if (!msg.compressed || !msg.payload || !msg.header ||
+        msg.header->size() < MESSAGE_HEADER_SIZE) {
+        return std::nullopt;
+    }
+    OutboundMessage::Compressed& slot = *msg.compressed;
+    std::call_once(slot.once, [&]() {
+        auto payload = CompressPayload(*msg.payload);
+        if (!payload) {
+            return;
+        }
+        MessageHeader header;
+        std::copy(msg.header->begin(), msg.header->begin() + 4, header.magic.begin());
+        header.SetCommand(msg.command);
+        header.SetCompressed();
+        header.payloadSize = static_cast<uint32_t>(payload->size());
+        header.checksum = ComputeChecksum(*payload);
+        DataStream headerStream;
+        header.Serialize(headerStream);
+        slot.header = std::make_shared<const std::vector<uint8_t>>(headerStream.begin(),
+                                                                   headerStream.end());
+        slot.payload = std::make_shared<const std::vector<uint8_t>>(std::move(*payload));
+    });
+    if (!slot.header) {
+        return std::nullopt;
+    }
+    OutboundMessage compressed;
+    compressed.header = slot.header;
+    compressed.payload = slot.payload;
+    compressed.command = msg.command;
+    return compressed;
+}
+
 std::optional<MessageHeader> ParseMessageHeader(const std::vector<uint8_t>& data) {
     if (data.size() < MESSAGE_HEADER_SIZE) {
         return std::nullopt;
     }
     
-    DataStream stream(data.data(), MESSAGE_HEADER_SIZE);
+    SpanReader stream(data.data(), MESSAGE_HEADER_SIZE);
     MessageHeader header;
     try {
         header.Unserialize(stream);
@@ -100,6 +149,8 @@ std::string InvTypeToString(InvType type) {
             return "BLOCK";
         case InvType::MSG_FILTERED_BLOCK:
             return "FILTERED_BLOCK";
+        case InvType::MSG_CMPCT_BLOCK:
+            return "CMPCT_BLOCK";
         case InvType::MSG_POUW_SOLUTION:
             return "POUW_SOLUTION";
         case InvType::MSG_POUW_PROBLEM:
@@ -133,6 +184,15 @@ static const std::set<std::string> VALID_COMMANDS = {
     NetMsgType::GETBLOCKS,
     NetMsgType::GETHEADERS,
     NetMsgType::HEADERS,
+    NetMsgType::SENDCMPCT,
+    NetMsgType::CMPCTBLOCK,
+    NetMsgType::GETBLOCKTXN,
+    NetMsgType::BLOCKTXN,
+    NetMsgType::SENDTXRCNCL,
+    NetMsgType::REQRECON,
+    NetMsgType::SKETCH,
+    NetMsgType::RECONCILDIFF,
+    NetMsgType::SENDCOMPR,
     NetMsgType::TX,
     NetMsgType::MEMPOOL,
     NetMsgType::FEEFILTER,
@@ -204,6 +264,30 @@ MessageValidationResult ValidatePayloadSize(const std::string& command, size_t p
             return MessageValidationResult::Invalid(10, "Invalid ping/pong size");
         }
     }
+    else if (command == NetMsgType::SENDCMPCT) {
+        // One flag byte and an 8-byte version
+        if (payloadSize != 9) {
+            return MessageValidationResult::Invalid(10, "Invalid sendcmpct size");
+        }
+    }
+    else if (command == NetMsgType::SENDTXRCNCL) {
+        // 4-byte version and 8-byte salt
+        if (payloadSize != 12) {
+            return MessageValidationResult::Invalid(10, "Invalid sendtxrcncl size");
+        }
+    }
+    else if (command == NetMsgType::SENDCOMPR) {
+        // 4-byte algorithm bits
+        if (payloadSize != 4) {
+            return MessageValidationResult::Invalid(10, "Invalid sendcompr size");
+        }
+    }
+    else if (command == NetMsgType::REQRECON) {
+        // Set size and q, 2 bytes each
+        if (payloadSize != 4) {
+            return MessageValidationResult::Invalid(10, "Invalid reqrecon size");
+        }
+    }
     else if (command == NetMsgType::FEEFILTER) {
         // Fee filter is exactly 8 bytes (int64)
         if (payloadSize != 8) {
@@ -302,6 +386,7 @@ bool IsValidInvType(InvType type) {
         case InvType::MSG_TX:
         case InvType::MSG_BLOCK:
         case InvType::MSG_FILTERED_BLOCK:
+        case InvType::MSG_CMPCT_BLOCK:
         case InvType::MSG_POUW_SOLUTION:
         case InvType::MSG_POUW_PROBLEM:
         case InvType::MSG_UBI_CLAIM:
@@ -6,8 +6,10 @@
 #include <shurium/network/peer.h>
 #include <shurium/core/block.h>
 
+#include <shurium/core/serialize.h>
+
 #include <algorithm>
-#include <random>
+#include <cmath>
 
 namespace shurium {
 
@@ -33,10 +35,12 @@ const char* SyncStateToString(SyncState state) {
 
 BlockSynchronizer::BlockSynchronizer(size_t maxBlocksInFlight,
                                      size_t maxBlocksPerPeer,
-                                     int blockTimeoutSec)
+                                     int blockTimeoutSec,
+                                     size_t downloadWindow)
     : maxBlocksInFlight_(maxBlocksInFlight)
     , maxBlocksPerPeer_(maxBlocksPerPeer)
-    , blockTimeoutSec_(blockTimeoutSec) {
+    , blockTimeoutSec_(blockTimeoutSec)
+    , downloadWindow_(downloadWindow) {
 }
 
 BlockSynchronizer::~BlockSynchronizer() {
@@ -79,6 +83,7 @@ void BlockSynchronizer::OnPeerConnected(Peer::Id id, int32_t height, ServiceFlag
     PeerSyncState peerState;
     peerState.chainHeight = height;
     peerState.supportsHeaders = HasFlag(services, ServiceFlags::NETWORK);
+    peerState.inFlightLimit = std::min(INITIAL_BLOCKS_IN_FLIGHT, maxBlocksPerPeer_);
     peerStates_[id] = peerState;
     
     // Update network height if this peer is higher
@@ -93,22 +98,15 @@ void BlockSynchronizer::OnPeerDisconnected(Peer::Id id) {
     // Get blocks that were being downloaded from this peer
     auto it = peerStates_.find(id);
     if (it != peerStates_.end()) {
-        const auto& peerState = it->second;
-        
         // Re-queue blocks that were in flight from this peer
         {
             std::lock_guard<std::mutex> reqLock(requestsMutex_);
-            for (const auto& hash : peerState.requestedBlocks) {
-                auto reqIt = pendingRequests_.find(hash);
-                if (reqIt != pendingRequests_.end() && reqIt->second.peerId == id) {
-                    // Re-add to download queue
-                    downloadQueue_.push_back(hash);
-                    pendingRequests_.erase(reqIt);
-                }
+            std::set<Hash256> requested = std::move(it->second.requestedBlocks);
+            peerStates_.erase(it);
+            for (const auto& hash : requested) {
+                ReleaseRequest(id, nullptr, hash);
             }
         }
-        
-        peerStates_.erase(it);
     }
 }
 
@@ -132,6 +130,37 @@ const PeerSyncState* BlockSynchronizer::GetPeerState(Peer::Id id) const {
     return (it != peerStates_.end()) ? &it->second : nullptr;
 }
 
+void BlockSynchronizer::UpdatePeerLatency(Peer::Id id, int64_t pingMs) {
+    if (pingMs < 0) return;
+    
+    std::lock_guard<std::mutex> lock(peersMutex_);
+    auto it = peerStates_.find(id);
+    if (it != peerStates_.end()) {
+        it->second.rttMs = static_cast<double>(pingMs);
+        it->second.rttFromPing = true;
+        it->second.inFlightLimit = ComputeInFlightLimit(it->second);
+    }
+}
+
+std::optional<PeerDownloadStats> BlockSynchronizer::GetPeerDownloadStats(Peer::Id id) const {
+    std::lock_guard<std::mutex> lock(peersMutex_);
+    auto it = peerStates_.find(id);
+    if (it == peerStates_.end()) {
+        return std::nullopt;
+    }
+    
+    const PeerSyncState& state = it->second;
+    PeerDownloadStats stats;
+    stats.blocksInFlight = state.blocksInFlight;
+    stats.inFlightLimit = state.inFlightLimit;
+    stats.blocksDownloaded = state.blocksDownloaded;
+    stats.bytesDownloaded = state.bytesDownloaded;
+    stats.bytesPerSec = state.bytesPerSec;
+    stats.rttMs = state.rttMs;
+    stats.stalls = state.stalls;
+    return stats;
+}
+
 bool BlockSynchronizer::ProcessHeaders(Peer::Id fromPeer, const std::vector<BlockHeader>& headers) {
     if (headers.empty()) return true;
     
@@ -140,22 +169,60 @@ bool BlockSynchronizer::ProcessHeaders(Peer::Id fromPeer, const std::vector<Bloc
         stats_.headersReceived += headers.size();
     }
     
+    // Hashed once, several at a time, for the chain and for the queue
+    std::vector<BlockHash> hashes = GetBlockHeaderHashes(headers);
+    
+    // Without a chain to validate against, take the headers that link up
+    HeadersOutcome outcome;
+    if (headerCallback_) {
+        outcome = headerCallback_(headers, hashes, fromPeer);
+    } else {
+        outcome.accepted = 1;
+        while (outcome.accepted < headers.size() &&
+               headers[outcome.accepted].hashPrevBlock == hashes[outcome.accepted - 1]) {
+            ++outcome.accepted;
+        }
+        outcome.missingBlocks.assign(hashes.begin(), hashes.begin() + outcome.accepted);
+    }
+    
     // Update peer state
     {
-        std::lock_guard<std::mutex> lock(peersMutex_);
+        std::lock_guard<std::mutex> peerLock(peersMutex_);
         auto it = peerStates_.find(fromPeer);
         if (it != peerStates_.end()) {
             it->second.lastHeaderRequest = std::chrono::steady_clock::time_point();
             it->second.isStalling = false;
+            if (outcome.accepted > 0) {
+                it->second.bestKnownHeader = hashes[outcome.accepted - 1];
+            }
+            for (size_t i = 0; i < outcome.accepted; ++i) {
+                it->second.notFoundBlocks.erase(hashes[i]);
+            }
+        }
+        
+        // Blocks join the download order behind those already queued
+        std::lock_guard<std::mutex> lock(requestsMutex_);
+        for (const auto& hash : outcome.missingBlocks) {
+            if (!windowPos_.count(hash) && !pendingRequests_.count(hash) &&
+                !downloadedBlocks_.count(hash) && !verifiedBlocks_.count(hash)) {
+                EnqueueBlock(hash);
+            }
         }
     }
     
-    // Notify callback
-    if (headerCallback_) {
-        return headerCallback_(headers, fromPeer);
+    if (outcome.bestHeaderHeight >= 0) {
+        SetBestHeaderHeight(outcome.bestHeaderHeight);
     }
     
-    return true;
+    // A full message means the peer has more: ask for them now rather
+    // than after the blocks
+    if (outcome.accepted == headers.size() && headers.size() == MAX_HEADERS_RESULTS) {
+        BlockLocator locator;
+        locator.vHave.push_back(hashes.back());
+        RequestHeaders(fromPeer, locator);
+    }
+    
+    return outcome.accepted == headers.size();
 }
 
 bool BlockSynchronizer::ProcessBlock(Peer::Id fromPeer, const Block& block) {
@@ -164,27 +231,59 @@ bool BlockSynchronizer::ProcessBlock(Peer::Id fromPeer, const Block& block) {
     
     // Compute block hash to track completion
     Hash256 blockHash = block.GetHash();
+    auto now = std::chrono::steady_clock::now();
+    size_t bytes = block.GetTotalSize();
     
     {
         std::lock_guard<std::mutex> lock(statsMutex_);
         stats_.blocksDownloaded++;
     }
     
-    // Update peer state
+    // Free the slots of the peers asked for it, measure the one that
+    // delivered, and move the window on
     {
-        std::lock_guard<std::mutex> lock(peersMutex_);
+        std::lock_guard<std::mutex> peerLock(peersMutex_);
+        std::lock_guard<std::mutex> lock(requestsMutex_);
+        
+        auto reqIt = pendingRequests_.find(blockHash);
+        if (reqIt != pendingRequests_.end()) {
+            const BlockRequest& req = reqIt->second;
+            for (Peer::Id id : {req.peerId, req.stalledPeer}) {
+                auto it = peerStates_.find(id);
+                if (it == peerStates_.end() || it->second.requestedBlocks.erase(blockHash) == 0) {
+                    continue;
+                }
+                if (it->second.blocksInFlight > 0) {
+                    it->second.blocksInFlight--;
+                }
+            }
+        }
+        
         auto it = peerStates_.find(fromPeer);
         if (it != peerStates_.end()) {
-            it->second.blocksInFlight--;
             it->second.isStalling = false;
+            if (reqIt != pendingRequests_.end() && reqIt->second.peerId == fromPeer) {
+                RecordDelivery(it->second, bytes, reqIt->second.requestTime, now);
+            } else {
+                // Unsolicited, or late from a staller: counted, not timed
+                it->second.blocksDownloaded++;
+                it->second.bytesDownloaded += bytes;
+            }
+        }
+        
+        if (reqIt != pendingRequests_.end()) {
+            pendingRequests_.erase(reqIt);
+        }
+        for (auto& [id, state] : peerStates_) {
+            state.notFoundBlocks.erase(blockHash);
         }
+        downloadedBlocks_.insert(blockHash);
+        AdvanceWindow();
     }
     
-    // Remove from pending requests and mark as downloaded
-    {
-        std::lock_guard<std::mutex> lock(requestsMutex_);
-        pendingRequests_.erase(blockHash);
-        downloadedBlocks_.insert(blockHash);
+    // Read the block's inputs ahead of validation
+    if (prefetchCallback_) {
+        prefetchCallback_(block);
     }
     
     // Notify callback
@@ -213,7 +312,7 @@ void BlockSynchronizer::ProcessInv(Peer::Id fromPeer, const std::vector<Inv>& in
         for (const auto& hash : blocksToRequest) {
             if (pendingRequests_.find(hash) == pendingRequests_.end() &&
                 downloadedBlocks_.find(hash) == downloadedBlocks_.end()) {
-                downloadQueue_.push_back(hash);
+                EnqueueBlock(hash);
             }
         }
     }
@@ -226,6 +325,7 @@ void BlockSynchronizer::ProcessInv(Peer::Id fromPeer, const std::vector<Inv>& in
             for (const auto& item : inv) {
                 if (item.IsBlock()) {
                     it->second.bestKnownBlock = item.hash;
+                    it->second.notFoundBlocks.erase(item.hash);
                 }
             }
         }
@@ -233,26 +333,19 @@ void BlockSynchronizer::ProcessInv(Peer::Id fromPeer, const std::vector<Inv>& in
 }
 
 void BlockSynchronizer::ProcessNotFound(Peer::Id fromPeer, const std::vector<Inv>& inv) {
+    std::lock_guard<std::mutex> peerLock(peersMutex_);
     std::lock_guard<std::mutex> lock(requestsMutex_);
     
-    for (const auto& item : inv) {
-        auto it = pendingRequests_.find(item.hash);
-        if (it != pendingRequests_.end() && it->second.peerId == fromPeer) {
-            // Re-queue for different peer
-            downloadQueue_.push_front(item.hash);
-            pendingRequests_.erase(it);
-        }
-    }
+    auto it = peerStates_.find(fromPeer);
+    PeerSyncState* state = it != peerStates_.end() ? &it->second : nullptr;
     
-    // Update peer state
-    {
-        std::lock_guard<std::mutex> peerLock(peersMutex_);
-        auto it = peerStates_.find(fromPeer);
-        if (it != peerStates_.end()) {
-            it->second.blocksInFlight -= inv.size();
-            if (it->second.blocksInFlight < 0) {
-                it->second.blocksInFlight = 0;
+    // Re-queue for different peer
+    for (const auto& item : inv) {
+        if (item.IsBlock()) {
+            if (state) {
+                state->notFoundBlocks.insert(item.hash);
             }
+            ReleaseRequest(fromPeer, state, item.hash);
         }
     }
 }
@@ -284,44 +377,37 @@ void BlockSynchronizer::RequestHeaders(Peer::Id peerId, const BlockLocator& loca
 void BlockSynchronizer::RequestBlocks(Peer::Id peerId, const std::vector<Hash256>& hashes) {
     if (!requestCallback_ || hashes.empty()) return;
     
-    // Build getdata message
-    std::vector<Inv> invs;
-    invs.reserve(hashes.size());
-    for (const auto& hash : hashes) {
-        invs.emplace_back(InvType::MSG_BLOCK, hash);
-    }
-    
-    DataStream stream;
-    ::shurium::Serialize(stream, invs);
-    std::vector<uint8_t> payload(stream.begin(), stream.end());
-    
-    requestCallback_(peerId, NetMsgType::GETDATA, payload);
-    
     // Record requests
     auto now = std::chrono::steady_clock::now();
     {
+        std::lock_guard<std::mutex> peerLock(peersMutex_);
         std::lock_guard<std::mutex> lock(requestsMutex_);
+        auto it = peerStates_.find(peerId);
         for (const auto& hash : hashes) {
-            BlockRequest req;
-            req.hash = hash;
-            req.peerId = peerId;
-            req.requestTime = now;
-            pendingRequests_[hash] = req;
+            if (it != peerStates_.end()) {
+                MarkRequested(it->second, peerId, hash, now);
+            } else {
+                BlockRequest& req = pendingRequests_[hash];
+                req.hash = hash;
+                req.peerId = peerId;
+                req.requestTime = now;
+            }
         }
     }
     
-    // Update peer state
-    {
-        std::lock_guard<std::mutex> lock(peersMutex_);
-        auto it = peerStates_.find(peerId);
-        if (it != peerStates_.end()) {
-            it->second.blocksInFlight += hashes.size();
-            it->second.lastBlockRequest = now;
-            for (const auto& hash : hashes) {
-                it->second.requestedBlocks.insert(hash);
-            }
-        }
+    SendBlockRequest(peerId, hashes);
+}
+
+void BlockSynchronizer::SendBlockRequest(Peer::Id peerId, const std::vector<Hash256>& hashes) {
+    // Build getdata message, counted the way MessageProcessor reads it
+    DataStream stream;
+    ::shurium::Serialize(stream, static_cast<uint64_t>(hashes.size()));
+    for (const auto& hash : hashes) {
+        Inv(InvType::MSG_BLOCK, hash).Serialize(stream);
     }
+    std::vector<uint8_t> payload(stream.begin(), stream.end());
+    
+    requestCallback_(peerId, NetMsgType::GETDATA, payload);
 }
 
 void BlockSynchronizer::Tick() {
@@ -343,11 +429,19 @@ void BlockSynchronizer::Tick() {
 void BlockSynchronizer::ResyncFrom(int32_t height) {
     // Clear state and restart sync from given height
     {
+        std::lock_guard<std::mutex> peerLock(peersMutex_);
         std::lock_guard<std::mutex> lock(requestsMutex_);
         pendingRequests_.clear();
         downloadQueue_.clear();
+        window_.clear();
+        windowPos_.clear();
+        windowBase_ = 0;
         downloadedBlocks_.clear();
         verifiedBlocks_.clear();
+        for (auto& [id, state] : peerStates_) {
+            state.requestedBlocks.clear();
+            state.blocksInFlight = 0;
+        }
     }
     
     chainHeight_ = height;
@@ -451,60 +545,118 @@ Peer::Id BlockSynchronizer::SelectHeaderPeer() {
 std::vector<Peer::Id> BlockSynchronizer::SelectBlockPeers() {
     std::lock_guard<std::mutex> lock(peersMutex_);
     
-    std::vector<Peer::Id> result;
+    std::vector<std::pair<double, Peer::Id>> ranked;
     for (const auto& [id, state] : peerStates_) {
         if (state.isStalling) continue;
-        if (state.blocksInFlight >= maxBlocksPerPeer_) continue;
-        result.push_back(id);
+        if (state.blocksInFlight >= state.inFlightLimit) continue;
+        ranked.emplace_back(state.bytesPerSec, id);
     }
     
-    // Shuffle to distribute load
-    std::random_device rd;
-    std::mt19937 g(rd());
-    std::shuffle(result.begin(), result.end(), g);
+    // Fastest first, so the earliest blocks of the window go to the peers
+    // likeliest to deliver them soon; unmeasured peers come last
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
     
+    std::vector<Peer::Id> result;
+    result.reserve(ranked.size());
+    for (const auto& entry : ranked) {
+        result.push_back(entry.second);
+    }
     return result;
 }
 
 void BlockSynchronizer::ScheduleBlockDownloads() {
+    if (!requestCallback_) return;
+    
     std::vector<Peer::Id> peers = SelectBlockPeers();
     if (peers.empty()) return;
     
-    std::lock_guard<std::mutex> lock(requestsMutex_);
-    
-    for (Peer::Id peerId : peers) {
-        if (downloadQueue_.empty()) break;
-        if (pendingRequests_.size() >= maxBlocksInFlight_) break;
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::pair<Peer::Id, std::vector<Hash256>>> batches;
+    {
+        std::lock_guard<std::mutex> peerLock(peersMutex_);
+        std::lock_guard<std::mutex> lock(requestsMutex_);
         
-        // Get peer state to check capacity
-        size_t peerCapacity = maxBlocksPerPeer_;
-        {
-            std::lock_guard<std::mutex> peerLock(peersMutex_);
+        bool windowFull = false;
+        for (Peer::Id peerId : peers) {
+            if (pendingRequests_.size() >= maxBlocksInFlight_) break;
+            
             auto it = peerStates_.find(peerId);
-            if (it != peerStates_.end()) {
-                peerCapacity = maxBlocksPerPeer_ - it->second.blocksInFlight;
-            }
-        }
-        
-        // Collect blocks to request from this peer
-        std::vector<Hash256> toRequest;
-        while (!downloadQueue_.empty() && 
-               toRequest.size() < peerCapacity &&
-               pendingRequests_.size() + toRequest.size() < maxBlocksInFlight_) {
-            Hash256 hash = downloadQueue_.front();
-            downloadQueue_.pop_front();
+            if (it == peerStates_.end()) continue;
+            PeerSyncState& state = it->second;
             
-            // Skip if already downloaded or being downloaded
-            if (downloadedBlocks_.find(hash) != downloadedBlocks_.end()) continue;
-            if (pendingRequests_.find(hash) != pendingRequests_.end()) continue;
+            // Collect blocks to request from this peer
+            std::vector<Hash256> toRequest;
+            while (!downloadQueue_.empty() &&
+                   state.blocksInFlight < state.inFlightLimit &&
+                   pendingRequests_.size() < maxBlocksInFlight_) {
+                Hash256 hash = downloadQueue_.front();
+                
+                // Skip if already downloaded or being downloaded
+                if (downloadedBlocks_.find(hash) != downloadedBlocks_.end() ||
+                    pendingRequests_.find(hash) != pendingRequests_.end()) {
+                    downloadQueue_.pop_front();
+                    continue;
+                }
+                if (!InWindow(hash)) {
+                    windowFull = true;
+                    break;
+                }
+                // Asking again would only get another notfound; leave it
+                // (and the blocks behind it) to the other peers
+                if (state.notFoundBlocks.count(hash)) {
+                    break;
+                }
+                
+                downloadQueue_.pop_front();
+                MarkRequested(state, peerId, hash, now);
+                toRequest.push_back(hash);
+            }
             
-            toRequest.push_back(hash);
+            if (!toRequest.empty()) {
+                batches.emplace_back(peerId, std::move(toRequest));
+            }
         }
         
-        if (!toRequest.empty()) {
-            RequestBlocks(peerId, toRequest);
+        // A full window waits on its first block. If that has sat with one
+        // peer too long, ask the fastest peer that still has room as well
+        // and halve the slow peer's limit
+        if (windowFull && !window_.empty()) {
+            auto reqIt = pendingRequests_.find(window_.front());
+            if (reqIt != pendingRequests_.end() && reqIt->second.stalledPeer < 0 &&
+                now - reqIt->second.requestTime > stallingTimeout_) {
+                BlockRequest& req = reqIt->second;
+                for (Peer::Id peerId : peers) {
+                    if (peerId == req.peerId) continue;
+                    auto it = peerStates_.find(peerId);
+                    if (it == peerStates_.end() ||
+                        it->second.blocksInFlight >= it->second.inFlightLimit) {
+                        continue;
+                    }
+                    
+                    auto slow = peerStates_.find(req.peerId);
+                    if (slow != peerStates_.end()) {
+                        slow->second.stalls++;
+                        slow->second.inFlightLimit = std::max(
+                            std::min(MIN_BLOCKS_IN_FLIGHT, maxBlocksPerPeer_),
+                            slow->second.inFlightLimit / 2);
+                    }
+                    
+                    Peer::Id stalledPeer = req.peerId;
+                    Hash256 hash = req.hash;
+                    MarkRequested(it->second, peerId, hash, now);
+                    pendingRequests_[hash].stalledPeer = stalledPeer;
+                    batches.emplace_back(peerId, std::vector<Hash256>{hash});
+                    break;
+                }
+            }
         }
     }
+    
+    for (const auto& [peerId, hashes] : batches) {
+        SendBlockRequest(peerId, hashes);
+    }
 }
 
 void BlockSynchronizer::CheckStalls() {
@@ -512,6 +664,7 @@ void BlockSynchronizer::CheckStalls() {
     int stallTimeout = blockTimeoutSec_;
     
     std::lock_guard<std::mutex> lock(peersMutex_);
+    std::lock_guard<std::mutex> reqLock(requestsMutex_);
     
     for (auto& [id, state] : peerStates_) {
         if (state.blocksInFlight == 0) continue;
@@ -524,38 +677,22 @@ void BlockSynchronizer::CheckStalls() {
             state.stallSince = now;
             
             // Re-queue blocks from stalling peer
-            std::lock_guard<std::mutex> reqLock(requestsMutex_);
-            for (const auto& hash : state.requestedBlocks) {
-                auto it = pendingRequests_.find(hash);
-                if (it != pendingRequests_.end() && it->second.peerId == id) {
-                    downloadQueue_.push_front(hash);
-                    pendingRequests_.erase(it);
-                }
-            }
+            std::set<Hash256> requested = std::move(state.requestedBlocks);
             state.requestedBlocks.clear();
             state.blocksInFlight = 0;
+            for (const auto& hash : requested) {
+                ReleaseRequest(id, nullptr, hash);
+            }
         }
     }
 }
 
 void BlockSynchronizer::HandleTimeout(Peer::Id peerId, const Hash256& hash) {
-    {
-        std::lock_guard<std::mutex> lock(requestsMutex_);
-        auto it = pendingRequests_.find(hash);
-        if (it != pendingRequests_.end() && it->second.peerId == peerId) {
-            downloadQueue_.push_front(hash);
-            pendingRequests_.erase(it);
-        }
-    }
+    std::lock_guard<std::mutex> peerLock(peersMutex_);
+    std::lock_guard<std::mutex> lock(requestsMutex_);
     
-    {
-        std::lock_guard<std::mutex> lock(peersMutex_);
-        auto it = peerStates_.find(peerId);
-        if (it != peerStates_.end()) {
-            it->second.blocksInFlight--;
-            it->second.requestedBlocks.erase(hash);
-        }
-    }
+    auto it = peerStates_.find(peerId);
+    ReleaseRequest(peerId, it != peerStates_.end() ? &it->second : nullptr, hash);
 }
 
 void BlockSynchronizer::UpdateProgress() {
@@ -595,21 +732,147 @@ void BlockSynchronizer::CleanupRequests() {
     auto now = std::chrono::steady_clock::now();
     int timeout = blockTimeoutSec_;
     
+    std::lock_guard<std::mutex> peerLock(peersMutex_);
     std::lock_guard<std::mutex> lock(requestsMutex_);
     
-    for (auto it = pendingRequests_.begin(); it != pendingRequests_.end(); ) {
+    std::vector<std::pair<Peer::Id, Hash256>> expired;
+    for (const auto& [hash, req] : pendingRequests_) {
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-            now - it->second.requestTime).count();
-        
+            now - req.requestTime).count();
         if (elapsed > timeout) {
-            downloadQueue_.push_back(it->first);
-            it = pendingRequests_.erase(it);
+            expired.emplace_back(req.peerId, hash);
+        }
+    }
+    
+    for (const auto& [peerId, hash] : expired) {
+        auto it = peerStates_.find(peerId);
+        ReleaseRequest(peerId, it != peerStates_.end() ? &it->second : nullptr, hash);
+    }
+}
+
+// ============================================================================
+// Download Window
+// ============================================================================
+
+void BlockSynchronizer::EnqueueBlock(const Hash256& hash) {
+    if (!windowPos_.emplace(hash, windowBase_ + window_.size()).second) {
+        return;  // Already in the download order
+    }
+    window_.push_back(hash);
+    downloadQueue_.push_back(hash);
+}
+
+void BlockSynchronizer::RequeueBlock(const Hash256& hash) {
+    auto pos = windowPos_.find(hash);
+    if (pos == windowPos_.end()) {
+        downloadQueue_.push_front(hash);
+        return;
+    }
+    
+    // Back in download order; taken-back blocks are early, so the search
+    // stops near the front
+    auto it = std::find_if(downloadQueue_.begin(), downloadQueue_.end(), [&](const Hash256& queued) {
+        auto other = windowPos_.find(queued);
+        return other == windowPos_.end() || other->second > pos->second;
+    });
+    downloadQueue_.insert(it, hash);
+}
+
+bool BlockSynchronizer::InWindow(const Hash256& hash) const {
+    auto it = windowPos_.find(hash);
+    return it == windowPos_.end() || it->second < windowBase_ + downloadWindow_;
+}
+
+void BlockSynchronizer::AdvanceWindow() {
+    while (!window_.empty() &&
+           downloadedBlocks_.find(window_.front()) != downloadedBlocks_.end()) {
+        windowPos_.erase(window_.front());
+        window_.pop_front();
+        ++windowBase_;
+    }
+}
+
+void BlockSynchronizer::MarkRequested(PeerSyncState& state, Peer::Id peerId, const Hash256& hash,
+                                      std::chrono::steady_clock::time_point now) {
+    BlockRequest& req = pendingRequests_[hash];
+    req.hash = hash;
+    req.peerId = peerId;
+    req.requestTime = now;
+    
+    if (state.requestedBlocks.insert(hash).second) {
+        state.blocksInFlight++;
+    }
+    state.lastBlockRequest = now;
+}
+
+void BlockSynchronizer::ReleaseRequest(Peer::Id peerId, PeerSyncState* state, const Hash256& hash) {
+    if (state && state->requestedBlocks.erase(hash) > 0 && state->blocksInFlight > 0) {
+        state->blocksInFlight--;
+    }
+    
+    auto it = pendingRequests_.find(hash);
+    if (it == pendingRequests_.end()) return;
+    
+    BlockRequest& req = it->second;
+    if (req.stalledPeer == peerId) {
+        req.stalledPeer = -1;
+    } else if (req.peerId == peerId) {
+        auto slow = peerStates_.find(req.stalledPeer);
+        if (slow != peerStates_.end() && slow->second.requestedBlocks.count(hash)) {
+            // The slow peer is still on it
+            req.peerId = req.stalledPeer;
+            req.stalledPeer = -1;
         } else {
-            ++it;
+            RequeueBlock(hash);
+            pendingRequests_.erase(it);
+        }
+    }
+}
+
+void BlockSynchronizer::RecordDelivery(PeerSyncState& state, size_t bytes,
+                                       std::chrono::steady_clock::time_point requestTime,
+                                       std::chrono::steady_clock::time_point now) {
+    state.blocksDownloaded++;
+    state.bytesDownloaded += bytes;
+    
+    // The peer has been sending this block since the later of its request
+    // and the previous delivery
+    auto since = std::max(requestTime, state.lastBlockReceived);
+    double seconds = std::max(std::chrono::duration<double>(now - since).count(), 1e-3);
+    double rate = static_cast<double>(bytes) / seconds;
+    if (state.bytesPerSec <= 0.0) {
+        state.bytesPerSec = rate;
+        state.avgBlockBytes = static_cast<double>(bytes);
+    } else {
+        state.bytesPerSec += DOWNLOAD_RATE_SMOOTHING * (rate - state.bytesPerSec);
+        state.avgBlockBytes += DOWNLOAD_RATE_SMOOTHING * (bytes - state.avgBlockBytes);
+    }
+    
+    // Without a ping, the quickest response bounds the round trip
+    if (!state.rttFromPing) {
+        double responseMs = std::chrono::duration<double, std::milli>(now - requestTime).count();
+        if (state.rttMs <= 0.0 || responseMs < state.rttMs) {
+            state.rttMs = responseMs;
         }
     }
+    
+    state.lastBlockReceived = now;
+    state.inFlightLimit = ComputeInFlightLimit(state);
 }
 
+size_t BlockSynchronizer::ComputeInFlightLimit(const PeerSyncState& state) const {
+    if (state.bytesPerSec <= 0.0 || state.avgBlockBytes <= 0.0) {
+        return state.inFlightLimit;
+    }
+    
+    // Twice the blocks one round trip carries at the measured rate, so
+    // the pipe never runs dry; the spare room lets the measured rate grow
+    double perRoundTrip = state.bytesPerSec * (state.rttMs / 1000.0) / state.avgBlockBytes;
+    size_t limit = static_cast<size_t>(std::ceil(2.0 * perRoundTrip)) + 1;
+    return std::clamp(limit, std::min(MIN_BLOCKS_IN_FLIGHT, maxBlocksPerPeer_), maxBlocksPerPeer_);
+}
+
+
 // ============================================================================
 // HeaderSync Implementation
 // ============================================================================
@@ -620,10 +883,13 @@ HeaderSync::~HeaderSync() = default;
 size_t HeaderSync::AddHeaders(const std::vector<BlockHeader>& headers) {
     std::lock_guard<std::mutex> lock(mutex_);
     
+    // Hashed as a batch rather than one by one
+    std::vector<BlockHash> hashes = GetBlockHeaderHashes(headers);
+    
     size_t added = 0;
-    for (const auto& header : headers) {
-        // Compute header hash
-        Hash256 hash = header.GetHash();
+    for (size_t i = 0; i < headers.size(); ++i) {
+        const BlockHeader& header = headers[i];
+        const Hash256& hash = hashes[i];
         
         // Skip if we already have this header
         if (headers_.find(hash) != headers_.end()) {
@@ -0,0 +1,332 @@
+// SHURIUM - Transaction Reconciliation Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/network/txreconciliation.h>
+#include <shurium/core/random.h>
+#include <shurium/crypto/sha256.h>
+#include <shurium/crypto/siphash.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace shurium {
+
+namespace {
+
+/// Domain separation for the short id key
+constexpr char RECON_SALT_TAG[] = "Tx Relay Salting";
+
+uint64_t ReadLE64(const Byte* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+void WriteLE64(std::vector<Byte>& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<Byte>(v >> (8 * i)));
+    }
+}
+
+} // anonymous namespace
+
+size_t EstimateSketchCapacity(size_t localSize, size_t remoteSize, double q) {
+    if (localSize == 0 && remoteSize == 0) {
+        return 0;
+    }
+    size_t smaller = std::min(localSize, remoteSize);
+    size_t gap = localSize > remoteSize ? localSize - remoteSize : remoteSize - localSize;
+    double estimate = static_cast<double>(gap) + q * static_cast<double>(smaller);
+    return std::min(static_cast<size_t>(estimate) + 1, MAX_SKETCH_CAPACITY);
+}
+
+// ============================================================================
+// Registration
+// ============================================================================
+
+TxReconciliationTracker::TxReconciliationTracker()
+    : fanoutK0_(GetRandUint64()), fanoutK1_(GetRandUint64()) {}
+
+uint64_t TxReconciliationTracker::PreRegisterPeer(Peer::Id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PeerState& state = peers_[id];
+    state.localSalt = GetRandUint64();
+    return state.localSalt;
+}
+
+ReconRegisterResult TxReconciliationTracker::RegisterPeer(Peer::Id id, bool isPeerInbound,
+                                                          uint32_t peerVersion, uint64_t peerSalt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it == peers_.end()) {
+        return ReconRegisterResult::NOT_FOUND;
+    }
+    PeerState& state = it->second;
+    if (state.registered) {
+        return ReconRegisterResult::ALREADY_REGISTERED;
+    }
+    // Later versions must stay able to speak version 1
+    if (peerVersion < 1) {
+        return ReconRegisterResult::PROTOCOL_VIOLATION;
+    }
+    
+    // Both salts, smaller first, give both sides the same key
+    std::vector<Byte> data(RECON_SALT_TAG, RECON_SALT_TAG + std::strlen(RECON_SALT_TAG));
+    WriteLE64(data, std::min(state.localSalt, peerSalt));
+    WriteLE64(data, std::max(state.localSalt, peerSalt));
+    Hash256 key = SHA256Hash(data);
+    state.k0 = ReadLE64(key.data());
+    state.k1 = ReadLE64(key.data() + 8);
+    
+    state.weInitiate = isPeerInbound ? false : true;
+    state.registered = true;
+    return ReconRegisterResult::SUCCESS;
+}
+
+void TxReconciliationTracker::ForgetPeer(Peer::Id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peers_.erase(id);
+}
+
+bool TxReconciliationTracker::IsPeerRegistered(Peer::Id id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    return it != peers_.end() && it->second.registered;
+}
+
+bool TxReconciliationTracker::IsInitiator(Peer::Id id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    return it != peers_.end() && it->second.registered && it->second.weInitiate;
+}
+
+// ============================================================================
+// Reconciliation Sets
+// ============================================================================
+
+bool TxReconciliationTracker::AddToSet(Peer::Id id, const TxHash& txid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it == peers_.end() || !it->second.registered ||
+        it->second.localSet.size() >= MAX_RECON_SET_SIZE) {
+        return false;
+    }
+    it->second.localSet.insert(txid);
+    return true;
+}
+
+void TxReconciliationTracker::TryRemoveFromSet(Peer::Id id, const TxHash& txid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it != peers_.end()) {
+        it->second.localSet.erase(txid);
+    }
+}
+
+size_t TxReconciliationTracker::GetSetSize(Peer::Id id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    return it != peers_.end() ? it->second.localSet.size() : 0;
+}
+
+std::set<Peer::Id> TxReconciliationTracker::GetFanoutTargets(
+    const TxHash& txid, const std::vector<Peer::Id>& outbound,
+    const std::vector<Peer::Id>& inbound) const {
+    std::set<Peer::Id> targets;
+    
+    // Lowest salted hash of (txid, peer) first
+    auto pick = [&](const std::vector<Peer::Id>& peers, size_t count) {
+        std::vector<std::pair<uint64_t, Peer::Id>> ranked;
+        ranked.reserve(peers.size());
+        for (Peer::Id id : peers) {
+            Byte data[40];
+            std::memcpy(data, txid.data(), 32);
+            uint64_t peer = static_cast<uint64_t>(id);
+            for (int i = 0; i < 8; ++i) {
+                data[32 + i] = static_cast<Byte>(peer >> (8 * i));
+            }
+            ranked.emplace_back(SipHash24(fanoutK0_, fanoutK1_, data, sizeof(data)), id);
+        }
+        count = std::min(count, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end());
+        for (size_t i = 0; i < count; ++i) {
+            targets.insert(ranked[i].second);
+        }
+    };
+    
+    pick(outbound, OUTBOUND_FANOUT_DESTINATIONS);
+    pick(inbound, static_cast<size_t>(std::ceil(INBOUND_FANOUT_RATIO * inbound.size())));
+    return targets;
+}
+
+uint32_t TxReconciliationTracker::ComputeShortId(Peer::Id id, const TxHash& txid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    return it != peers_.end() ? ShortIdLocked(it->second, txid) : 0;
+}
+
+uint32_t TxReconciliationTracker::ShortIdLocked(const PeerState& state, const TxHash& txid) const {
+    // Never 0, which a sketch cannot hold
+    uint64_t h = SipHash24(state.k0, state.k1, txid.data(), txid.size());
+    return static_cast<uint32_t>(1 + h % 0xFFFFFFFFULL);
+}
+
+// ============================================================================
+// Initiator
+// ============================================================================
+
+std::optional<ReqReconMessage> TxReconciliationTracker::InitiateReconciliation(Peer::Id id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it == peers_.end() || !it->second.registered || !it->second.weInitiate ||
+        it->second.awaitingSketch) {
+        return std::nullopt;
+    }
+    
+    PeerState& state = it->second;
+    state.awaitingSketch = true;
+    
+    ReqReconMessage msg;
+    msg.setSize = static_cast<uint16_t>(std::min<size_t>(state.localSet.size(), UINT16_MAX));
+    msg.q = static_cast<uint16_t>(state.q * RECON_Q_PRECISION);
+    return msg;
+}
+
+std::optional<ReconciliationOutcome> TxReconciliationTracker::HandleSketch(Peer::Id id,
+                                                                           const SketchMessage& msg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it == peers_.end() || !it->second.awaitingSketch) {
+        return std::nullopt;
+    }
+    PeerState& state = it->second;
+    state.awaitingSketch = false;
+    
+    auto theirs = Minisketch::Deserialize(msg.sketch);
+    if (!theirs) {
+        return std::nullopt;
+    }
+    
+    ReconciliationOutcome outcome;
+    std::set<TxHash> local = std::move(state.localSet);
+    state.localSet.clear();
+    
+    // The responder had nothing: it lacks all of ours
+    if (theirs->GetCapacity() == 0) {
+        outcome.diff.success = true;
+        outcome.announce.assign(local.begin(), local.end());
+        stats_.succeeded++;
+        stats_.differences += local.size();
+        return outcome;
+    }
+    
+    std::unordered_map<uint32_t, TxHash> byShortId;
+    byShortId.reserve(local.size());
+    Minisketch ours(theirs->GetCapacity());
+    for (const auto& txid : local) {
+        uint32_t shortId = ShortIdLocked(state, txid);
+        byShortId.emplace(shortId, txid);
+        ours.Add(shortId);
+    }
+    ours.Merge(*theirs);
+    
+    auto difference = ours.Decode();
+    if (!difference) {
+        // Too many differences: both sides announce their whole sets
+        outcome.diff.success = false;
+        outcome.announce.assign(local.begin(), local.end());
+        stats_.failed++;
+        return outcome;
+    }
+    
+    outcome.diff.success = true;
+    for (uint32_t shortId : *difference) {
+        auto found = byShortId.find(shortId);
+        if (found != byShortId.end()) {
+            outcome.announce.push_back(found->second);
+        } else {
+            outcome.diff.askShortIds.push_back(shortId);
+        }
+    }
+    
+    // Learn how far the sets drift beyond their size gap
+    size_t remote = local.size() - outcome.announce.size() + outcome.diff.askShortIds.size();
+    size_t smaller = std::min(local.size(), remote);
+    if (smaller > 0) {
+        size_t gap = local.size() > remote ? local.size() - remote : remote - local.size();
+        double q = static_cast<double>(difference->size() - gap) / static_cast<double>(smaller);
+        state.q = std::clamp(q, 0.0, 2.0);
+    }
+    
+    stats_.succeeded++;
+    stats_.differences += difference->size();
+    return outcome;
+}
+
+// ============================================================================
+// Responder
+// ============================================================================
+
+std::optional<SketchMessage> TxReconciliationTracker::HandleReqRecon(Peer::Id id,
+                                                                     const ReqReconMessage& msg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it == peers_.end() || !it->second.registered || it->second.weInitiate ||
+        it->second.snapshot) {
+        return std::nullopt;
+    }
+    PeerState& state = it->second;
+    
+    state.remoteSetSize = msg.setSize;
+    double q = static_cast<double>(msg.q) / RECON_Q_PRECISION;
+    size_t capacity = EstimateSketchCapacity(state.localSet.size(), msg.setSize, q);
+    
+    Minisketch sketch(capacity);
+    for (const auto& txid : state.localSet) {
+        sketch.Add(ShortIdLocked(state, txid));
+    }
+    state.snapshot = std::move(state.localSet);
+    state.localSet.clear();
+    
+    SketchMessage reply;
+    reply.sketch = sketch.Serialize();
+    return reply;
+}
+
+std::optional<std::vector<TxHash>> TxReconciliationTracker::HandleReconcilDiff(
+    Peer::Id id, const ReconcilDiffMessage& msg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(id);
+    if (it == peers_.end() || !it->second.snapshot) {
+        return std::nullopt;
+    }
+    PeerState& state = it->second;
+    std::set<TxHash> snapshot = std::move(*state.snapshot);
+    state.snapshot.reset();
+    
+    std::vector<TxHash> announce;
+    if (!msg.success) {
+        announce.assign(snapshot.begin(), snapshot.end());
+        return announce;
+    }
+    
+    std::set<uint32_t> asked(msg.askShortIds.begin(), msg.askShortIds.end());
+    for (const auto& txid : snapshot) {
+        if (asked.count(ShortIdLocked(state, txid))) {
+            announce.push_back(txid);
+        }
+    }
+    return announce;
+}
+
+ReconciliationStats TxReconciliationTracker::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace shurium
@@ -3,13 +3,24 @@
 // MIT License
 
 #include "shurium/node/context.h"
+#include "shurium/chain/reindex.h"
+#include "shurium/chain/txindexer.h"
+#include "shurium/chain/blockfilterindexer.h"
+#include "shurium/db/blockfilterdb.h"
+#include "shurium/mempool/fees.h"
+#include "shurium/mempool/persist.h"
 #include "shurium/network/addrman.h"
 #include "shurium/core/block.h"
+#include "shurium/consensus/validation.h"
+#include "shurium/crypto/sha256.h"
+#include "shurium/util/affinity.h"
 #include "shurium/util/logging.h"
+#include "shurium/util/shutdown.h"
 #include "shurium/db/database.h"
 #include "shurium/economics/funds.h"
 
 #include <sys/stat.h>
+#include <unistd.h>
 
 namespace shurium {
 
@@ -25,6 +36,29 @@ static bool CreateDirectoryIfNeeded(const std::filesystem::path& path) {
     return std::filesystem::create_directories(path, ec);
 }
 
+// ============================================================================
+// Database Cache Sizing
+// ============================================================================
+
+uint64_t GetTotalSystemMemory() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(pages) * static_cast<uint64_t>(pageSize);
+}
+
+int GetAutoDbCacheMB(uint64_t totalMemory) {
+    uint64_t totalMB = totalMemory / (1024 * 1024);
+    if (totalMB <= static_cast<uint64_t>(DBCACHE_RAM_RESERVE_MB)) {
+        return MIN_AUTO_DBCACHE_MB;
+    }
+    uint64_t cacheMB = (totalMB - DBCACHE_RAM_RESERVE_MB) * DBCACHE_RAM_PERCENT / 100;
+    return static_cast<int>(std::clamp<uint64_t>(cacheMB, MIN_AUTO_DBCACHE_MB,
+                                                 std::numeric_limits<int>::max()));
+}
+
 // ============================================================================
 // Get Consensus Parameters
 // ============================================================================
@@ -85,6 +119,8 @@ static Block GetGenesisBlock(const std::string& network, Amount blockReward) {
 
 bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
     LOG_INFO(util::LogCategory::DEFAULT) << "Initializing node...";
+    LOG_INFO(util::LogCategory::DEFAULT) << "Using SHA256 implementation: "
+                                         << SHA256ImplementationName(SHA256AutoDetect());
     
     // Store options
     node.dataDir = options.dataDir;
@@ -112,6 +148,29 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
     LOG_INFO(util::LogCategory::DEFAULT) << "Blocks directory: " << node.blocksDir.string();
     LOG_INFO(util::LogCategory::DEFAULT) << "Chainstate directory: " << node.chainstateDir.string();
     
+    // ========================================================================
+    // Step 1b: Place threads (before any subsystem starts one)
+    // ========================================================================
+    
+    util::ThreadPlacement& placement = util::ThreadPlacement::Instance();
+    for (const auto& spec : options.threadAffinity) {
+        std::string error;
+        if (!placement.Configure(spec, error)) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Invalid -threadaffinity: " << error;
+            return false;
+        }
+    }
+    if (options.autoThreadPlacement) {
+        placement.ApplyDefaults();
+    }
+    for (const auto& role : placement.GetStats()) {
+        if (!role.cores.empty()) {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Pinning " << role.role << " threads to "
+                                                 << role.cores.size() << " core(s) from CPU "
+                                                 << role.cores.front();
+        }
+    }
+    
     // ========================================================================
     // Step 2: Get consensus parameters
     // ========================================================================
@@ -135,16 +194,40 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
     // Step 3: Open databases
     // ========================================================================
     
-    // Database options
+    // Without -dbcache, take half of the memory the rest of the node leaves
+    int dbCacheMB = options.dbCacheMB;
+    if (dbCacheMB <= 0) {
+        uint64_t totalMemory = GetTotalSystemMemory();
+        dbCacheMB = GetAutoDbCacheMB(totalMemory);
+        LOG_INFO(util::LogCategory::DEFAULT) << "Sized -dbcache to " << dbCacheMB << " MiB from "
+                                             << totalMemory / (1024 * 1024) << " MiB of RAM";
+    }
+    
+    // Database options; a quarter of -dbcache goes to the databases, split
+    // between the column families so each is tuned for how it is read
     db::Options dbOptions;
     dbOptions.create_if_missing = true;
-    dbOptions.write_buffer_size = static_cast<size_t>(options.dbCacheMB) * 1024 * 1024 / 4;
     dbOptions.max_open_files = 64;
     
+    db::ColumnFamilyCacheSizes dbCache = db::SplitDatabaseCache(
+        static_cast<size_t>(dbCacheMB) * 1024 * 1024 / 4, options.txIndex);
+    db::Options blockIndexOptions =
+        db::GetColumnFamilyOptions(db::ColumnFamily::BLOCK_INDEX, dbCache.blockIndex, dbOptions);
+    db::Options coinsOptions =
+        db::GetColumnFamilyOptions(db::ColumnFamily::COINS, dbCache.coins, dbOptions);
+    db::Options txIndexOptions =
+        db::GetColumnFamilyOptions(db::ColumnFamily::TX_INDEX, dbCache.txIndex, dbOptions);
+    LOG_INFO(util::LogCategory::DEFAULT) << "Database cache: "
+        << dbCache.blockIndex / (1024 * 1024) << " MiB block index, "
+        << dbCache.coins / (1024 * 1024) << " MiB coins, "
+        << dbCache.txIndex / (1024 * 1024) << " MiB txindex";
+    
+    util::StartupPhaseTimer databasesPhase(node.startup, util::StartupPhase::DATABASES);
+    
     // Open block database
     try {
         LOG_INFO(util::LogCategory::DEFAULT) << "Opening block database...";
-        node.blockDB = std::make_unique<db::BlockDB>(node.blocksDir, dbOptions);
+        node.blockDB = std::make_unique<db::BlockDB>(node.blocksDir, blockIndexOptions);
         
         if (!node.blockDB->IsOpen()) {
             LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to open block database";
@@ -155,12 +238,32 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
         return false;
     }
     
+    // Pruning keeps block and undo files under -prune MiB
+    if (options.prune) {
+        if (options.pruneSizeMB < 0 ||
+            static_cast<uint64_t>(options.pruneSizeMB) < db::MIN_PRUNE_TARGET_MB) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Prune target must be at least "
+                                                  << db::MIN_PRUNE_TARGET_MB << " MiB";
+            return false;
+        }
+        if (options.txIndex) {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Prune mode is incompatible with -txindex";
+            return false;
+        }
+        node.blockDB->SetPruneTarget(static_cast<uint64_t>(options.pruneSizeMB) * 1024 * 1024);
+        LOG_INFO(util::LogCategory::DEFAULT) << "Pruning block files to " << options.pruneSizeMB
+                                             << " MiB";
+    } else if (node.blockDB->HavePruned()) {
+        LOG_WARN(util::LogCategory::DEFAULT) << "Block files were pruned before; old blocks "
+                                             << "are not available without a resync";
+    }
+    
     // Open UTXO database
     try {
         LOG_INFO(util::LogCategory::DEFAULT) << "Opening UTXO database...";
         node.coinsDB = std::make_unique<db::CoinsViewDB>(
             node.chainstateDir,
-            dbOptions,
+            coinsOptions,
             options.reindex  // wipe if reindexing
         );
         
@@ -168,6 +271,15 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
             LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to open UTXO database";
             return false;
         }
+        
+        // Answer lookups of coins that do not exist without a disk read
+        if (options.coinFilterMB > 0) {
+            size_t nCoins = node.coinsDB->EnableCoinFilter(
+                static_cast<size_t>(options.coinFilterMB) * 1024 * 1024);
+            LOG_INFO(util::LogCategory::DEFAULT) << "Coin filter built over " << nCoins
+                << " coins (" << options.coinFilterMB << " MiB, estimated false-positive rate "
+                << node.coinsDB->GetCoinFilter()->EstimateFalsePositiveRate() << ")";
+        }
     } catch (const std::exception& e) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to open UTXO database: " << e.what();
         return false;
@@ -179,7 +291,7 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
             LOG_INFO(util::LogCategory::DEFAULT) << "Opening transaction index...";
             auto txIndexPath = node.dataDir / "txindex";
             CreateDirectoryIfNeeded(txIndexPath);
-            node.txIndex = std::make_unique<db::TxIndex>(txIndexPath, dbOptions);
+            node.txIndex = std::make_unique<db::TxIndex>(txIndexPath, txIndexOptions);
             node.txIndex->SetEnabled(true);
         } catch (const std::exception& e) {
             LOG_WARN(util::LogCategory::DEFAULT) << "Failed to open transaction index: " << e.what();
@@ -187,15 +299,66 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
         }
     }
     
+    // Open block filter index if enabled; filters are small and read by
+    // key, so it shares the transaction index's tuning
+    if (options.blockFilterIndex) {
+        LOG_INFO(util::LogCategory::DEFAULT) << "Opening block filter index...";
+        node.blockFilterIndex = std::make_unique<db::BlockFilterIndex>(
+            BlockFilterType::BASIC, node.dataDir,
+            db::GetColumnFamilyOptions(db::ColumnFamily::TX_INDEX, dbCache.blockIndex, dbOptions));
+        if (!node.blockFilterIndex->IsEnabled()) {
+            LOG_WARN(util::LogCategory::DEFAULT) << "Failed to open block filter index";
+            // Non-fatal, continue without filters
+            node.blockFilterIndex.reset();
+        }
+    }
+    databasesPhase.Done();
+    
     // ========================================================================
     // Step 4: Create chain state manager
     // ========================================================================
     
     LOG_INFO(util::LogCategory::DEFAULT) << "Initializing chain state manager...";
     
+    util::StartupPhaseTimer chainstatePhase(node.startup, util::StartupPhase::CHAINSTATE);
     try {
         node.chainman = std::make_unique<ChainStateManager>(*node.params);
         
+        // Set up parallel script verification
+        node.chainman->SetScriptCheckThreads(
+            ResolveScriptCheckThreads(options.scriptCheckThreads));
+        LOG_INFO(util::LogCategory::DEFAULT) << "Using " << node.chainman->GetScriptCheckThreads()
+                                             << " script verification thread(s)";
+        
+        // Read block inputs from the UTXO database in parallel before connecting
+        node.chainman->SetPrefetchThreads(DEFAULT_COINS_PREFETCH_THREADS);
+        
+        // Run context-free checks for batched blocks while earlier ones connect
+        node.chainman->SetBlockCheckThreads(DEFAULT_BLOCK_CHECK_THREADS);
+        
+        // Assume-valid: empty keeps the network default, "0" disables it
+        if (options.assumeValidBlock == "0") {
+            node.chainman->SetAssumeValid(BlockHash());
+        } else if (!options.assumeValidBlock.empty()) {
+            try {
+                node.chainman->SetAssumeValid(
+                    BlockHash(Hash256::FromHex(options.assumeValidBlock)));
+            } catch (const std::exception&) {
+                LOG_ERROR(util::LogCategory::DEFAULT) << "Invalid -assumevalid block hash: "
+                                                       << options.assumeValidBlock;
+                return false;
+            }
+        }
+        if (node.chainman->GetAssumeValid().IsNull()) {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Assume-valid disabled; verifying all scripts";
+        } else {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Assuming scripts valid up to block "
+                                                 << node.chainman->GetAssumeValid().ToHex();
+        }
+        
+        // Headers from peers are held to the network's checkpoints
+        node.chainman->LoadCheckpoints(options.network);
+        
         // Set the block database for storing blocks
         if (node.blockDB) {
             node.chainman->SetBlockDB(node.blockDB.get());
@@ -205,16 +368,32 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
             LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to initialize chain state manager";
             return false;
         }
+        
+        // LevelDB's write buffer takes a quarter of -dbcache; the UTXO cache
+        // gets the rest and is written in the background once it fills up
+        node.chainman->GetActiveChainState().SetCoinsCacheLimit(
+            static_cast<size_t>(dbCacheMB) * 1024 * 1024 * 3 / 4);
+
+        // Keep the fund UTXO index in step with the active chain, including
+        // blocks a reorganization takes off it
+        node.chainman->RegisterBlockConnected([](const Block& block, const BlockIndex* pindex) {
+            economics::GetFundManager().ConnectBlock(block, pindex->nHeight);
+        });
+        node.chainman->RegisterBlockDisconnected([](const Block& block, const BlockIndex* pindex) {
+            economics::GetFundManager().DisconnectBlock(block, pindex->nHeight);
+        });
     } catch (const std::exception& e) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to create chain state manager: " << e.what();
         return false;
     }
+    chainstatePhase.Done();
     
     // ========================================================================
     // Step 5: Load block index
     // ========================================================================
     
-    int nLoaded = LoadBlockIndex(node);
+    util::StartupPhaseTimer blockIndexPhase(node.startup, util::StartupPhase::BLOCK_INDEX);
+    int nLoaded = node.reindex ? ReindexBlockFiles(node) : LoadBlockIndex(node);
     if (nLoaded < 0) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to load block index";
         return false;
@@ -274,15 +453,18 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
             LOG_WARN(util::LogCategory::DEFAULT) << "Run with -reindex to rebuild the block index.";
         }
     }
+    blockIndexPhase.Done();
     
     // ========================================================================
     // Step 7: Activate best chain
     // ========================================================================
     
+    util::StartupPhaseTimer activatePhase(node.startup, util::StartupPhase::CHAINSTATE);
     if (!ActivateBestChain(node)) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to activate best chain";
         return false;
     }
+    activatePhase.Done();
     
     BlockIndex* tip = node.GetTip();
     if (tip) {
@@ -290,18 +472,43 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
                                              << " hash=" << tip->GetBlockHash().ToHex().substr(0, 16) << "...";
     }
     
+    // Build the transaction index in the background, resuming where it
+    // stopped; a freshly enabled index starts from genesis without a reindex
+    if (node.txIndex && node.txIndex->IsEnabled() && node.blockDB) {
+        node.txIndexer = std::make_unique<TxIndexer>(*node.chainman, *node.blockDB, *node.txIndex);
+        node.txIndexer->Start();
+    }
+    if (node.blockFilterIndex && node.blockDB) {
+        node.blockFilterIndexer = std::make_unique<BlockFilterIndexer>(
+            *node.chainman, *node.blockDB, *node.blockFilterIndex);
+        node.blockFilterIndexer->Start();
+    }
+    
     // ========================================================================
     // Step 8: Initialize mempool
     // ========================================================================
     
     LOG_INFO(util::LogCategory::DEFAULT) << "Initializing mempool...";
     
+    // Ends once the saved mempool is back, on the loader thread if there is one
+    node.startup.Begin(util::StartupPhase::MEMPOOL);
+    
     MempoolLimits mempoolLimits;
     mempoolLimits.maxSize = 300 * 1000 * 1000;  // 300 MB
     mempoolLimits.maxAge = 14 * 24 * 60 * 60;   // 14 days
     
     node.mempool = std::make_unique<Mempool>(mempoolLimits);
     
+    // Pick up the fee statistics of earlier runs; a missing or unreadable
+    // file just starts them empty
+    node.feeEstimator = std::make_unique<FeeEstimator>();
+    auto feeEstimatesPath = node.dataDir / FEE_ESTIMATES_FILENAME;
+    if (std::filesystem::exists(feeEstimatesPath) && !node.feeEstimator->Load(feeEstimatesPath)) {
+        LOG_WARN(util::LogCategory::MEMPOOL) << "Could not read " << feeEstimatesPath.string()
+                                             << ", starting fee estimates afresh";
+    }
+    node.mempool->SetFeeEstimator(node.feeEstimator.get());
+    
     // Set up mempool notifications
     node.mempool->SetNotifyRemoved([](const TransactionRef& tx, MempoolRemovalReason reason) {
         LOG_DEBUG(util::LogCategory::MEMPOOL) << "Tx removed from mempool: " 
@@ -309,6 +516,30 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
                                               << " reason=" << RemovalReasonToString(reason);
     });
     
+    // Reload the transactions saved at the last shutdown in the background,
+    // through package acceptance, while the rest of the node starts
+    node.persistMempool = options.persistMempool;
+    node.lastMempoolDump = std::chrono::steady_clock::now();
+    auto mempoolPath = node.dataDir / MEMPOOL_DUMP_FILENAME;
+    if (node.persistMempool && std::filesystem::exists(mempoolPath)) {
+        node.mempoolLoader = std::thread([&node, mempoolPath]() {
+            auto& chainstate = node.chainman->GetActiveChainState();
+            MempoolPersistResult load = LoadMempool(
+                mempoolPath, *node.mempool, chainstate.GetCoins(), node.GetHeight(),
+                node.chainman->GetScriptCheckQueue(), &node.mempoolLoadInterrupt);
+            if (!load.success) {
+                LOG_WARN(util::LogCategory::MEMPOOL) << "Mempool load stopped: " << load.error;
+                node.startup.End(util::StartupPhase::MEMPOOL, false);
+                return;
+            }
+            node.mempoolLoaded.store(true);
+            node.startup.End(util::StartupPhase::MEMPOOL);
+        });
+    } else {
+        node.mempoolLoaded.store(true);
+        node.startup.End(util::StartupPhase::MEMPOOL);
+    }
+    
     // ========================================================================
     // Done
     // ========================================================================
@@ -326,6 +557,7 @@ bool InitializeNode(NodeContext& node, const NodeInitOptions& options) {
 bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
     if (!options.listen && options.connectNodes.empty() && options.addNodes.empty()) {
         LOG_INFO(util::LogCategory::NET) << "Network disabled (no listen, no connect nodes)";
+        node.startup.Skip(util::StartupPhase::NETWORK);
         return true;
     }
     
@@ -335,6 +567,9 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
     connOptions.maxConnections = static_cast<size_t>(options.maxConnections);
     connOptions.acceptInbound = options.listen;
     connOptions.listenPort = options.port;
+    connOptions.maxUploadTarget = options.maxUploadTarget;
+    connOptions.maxSendRatePerPeer = options.maxSendRatePerPeer;
+    connOptions.maxSendRateTotal = options.maxSendRateTotal;
     
     if (!options.bindAddress.empty()) {
         connOptions.bindAddress = options.bindAddress;
@@ -351,6 +586,7 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
             LOG_INFO(util::LogCategory::NET) << "Loaded " << node.addrman->Size() 
                                              << " peer addresses from disk";
         }
+        node.addrman->StartPeriodicSave(addrPath.string());
         
         // Create connection manager
         node.connman = std::make_unique<ConnectionManager>(connOptions);
@@ -361,6 +597,11 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
         // Create message processor
         MessageProcessorOptions msgOptions;
         msgOptions.relayTransactions = true;
+        
+        // Without the full history we can only serve recent blocks
+        if (node.blockDB && (node.blockDB->IsPruneMode() || node.blockDB->HavePruned())) {
+            msgOptions.localServices = ServiceFlags::NETWORK_LIMITED;
+        }
         node.msgproc = std::make_unique<MessageProcessor>(msgOptions);
         
         // Initialize message processor with components
@@ -368,6 +609,12 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
         node.msgproc->SetMempool(node.mempool.get());
         node.msgproc->SetChainManager(node.chainman.get());
         node.msgproc->SetAddressManager(node.addrman.get());
+        node.msgproc->SetBlockFilterIndex(node.blockFilterIndex.get());
+        // Needed to accept relayed transactions and to serve blocks
+        node.msgproc->SetBlockDB(node.blockDB.get());
+        if (node.chainman && node.chainman->GetActiveTip()) {
+            node.msgproc->SetCoinsView(&node.chainman->GetActiveChainState().GetCoins());
+        }
         
         // Set chain height for tx validation
         if (node.chainman) {
@@ -375,16 +622,44 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
         }
         
         // Set up sync manager callbacks
+        node.syncman->SetBlockPrefetchCallback([&node](const Block& block) {
+            if (node.chainman) {
+                node.chainman->PrefetchBlockInputs(block);
+            }
+        });
+        
+        // Block requests from the download window go straight to the peer
+        node.syncman->SetRequestCallback([&node](Peer::Id peerId, const std::string& command,
+                                                  const std::vector<uint8_t>& payload) {
+            if (!node.connman) return;
+            if (auto peer = node.connman->GetPeer(peerId)) {
+                peer->QueueSend(CreateMessage(NetworkMagic::MAINNET, command, payload));
+            }
+        });
+        
         node.syncman->SetBlockCallback([&node](const Block& block, Peer::Id fromPeer) -> bool {
             // Process received block through chain state
             if (!node.chainman) return false;
             
             bool accepted = node.chainman->ProcessNewBlock(block);
             
+            // A block that became the tip confirms its mempool transactions
+            BlockIndex* tip = node.chainman->GetActiveTip();
+            if (accepted && node.mempool && tip && tip->GetBlockHash() == block.GetHash()) {
+                node.mempool->RemoveForBlock(block.vtx, static_cast<uint32_t>(tip->nHeight));
+                if (node.msgproc) {
+                    node.msgproc->BlockConnected(block);
+                }
+            }
+            
             if (accepted) {
+                if (tip) {
+                    node.syncman->SetChainHeight(tip->nHeight);
+                }
+                
                 // Relay the block to other peers (exclude the sender)
                 if (node.msgproc) {
-                    node.msgproc->RelayBlock(block.GetHash(), fromPeer);
+                    node.msgproc->RelayBlock(block, fromPeer);
                 }
             } else {
                 LOG_DEBUG(util::LogCategory::NET) << "Block rejected from peer " << fromPeer;
@@ -393,15 +668,31 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
             return accepted;
         });
         
-        node.syncman->SetHeaderCallback([&node](const std::vector<BlockHeader>& headers, 
-                                                 Peer::Id fromPeer) -> bool {
-            // Process headers through chain state
-            if (!node.chainman) return false;
+        node.syncman->SetHeaderCallback([&node](const std::vector<BlockHeader>& headers,
+                                                 const std::vector<BlockHash>& hashes,
+                                                 Peer::Id fromPeer) -> HeadersOutcome {
+            HeadersOutcome outcome;
+            if (!node.chainman) return outcome;
+            
+            // Validated as a batch, then added to the block index
+            consensus::ValidationState state;
+            outcome.accepted = node.chainman->ProcessBlockHeaders(headers, state, &hashes);
+            if (outcome.accepted < headers.size()) {
+                LOG_DEBUG(util::LogCategory::NET) << "Header " << outcome.accepted << " of "
+                                                  << headers.size() << " from peer " << fromPeer
+                                                  << " rejected: " << state.ToString();
+            }
             
-            // For now, just log that we received headers
-            LOG_DEBUG(util::LogCategory::NET) << "Received " << headers.size() 
-                                              << " headers from peer " << fromPeer;
-            return true;
+            for (size_t i = 0; i < outcome.accepted; ++i) {
+                BlockIndex* pindex = node.chainman->LookupBlockIndex(hashes[i]);
+                if (pindex && !pindex->HaveData()) {
+                    outcome.missingBlocks.push_back(hashes[i]);
+                }
+            }
+            if (BlockIndex* best = node.chainman->GetBestHeader()) {
+                outcome.bestHeaderHeight = best->nHeight;
+            }
+            return outcome;
         });
         
         // Set up peer callbacks
@@ -417,6 +708,9 @@ bool StartNetwork(NodeContext& node, const NodeInitOptions& options) {
             if (node.syncman) {
                 node.syncman->OnPeerDisconnected(id);
             }
+            if (node.msgproc) {
+                node.msgproc->PeerDisconnected(id);
+            }
         });
         
         // Set up message processor handshake callback to start sync
@@ -546,101 +840,154 @@ void ShutdownNode(NodeContext& node) {
     LOG_INFO(util::LogCategory::DEFAULT) << "Shutting down node...";
     
     node.initialized.store(false);
+    util::ShutdownCoordinator shutdown;
     
     // ========================================================================
-    // Step 1: Stop message processor first (before connman)
+    // Stage 1: Stop intake. Everything that feeds blocks or transactions in
+    // stops before any state is saved; each chain stops in its own order.
     // ========================================================================
     
-    if (node.msgproc) {
-        LOG_INFO(util::LogCategory::NET) << "Stopping message processor...";
-        node.msgproc->Stop();
-        node.msgproc.reset();
+    shutdown.AddStage("intake");
+    shutdown.AddStep("network", [&node] {
+        // Message processor before the connections it reads from
+        if (node.msgproc) {
+            LOG_INFO(util::LogCategory::NET) << "Stopping message processor...";
+            node.msgproc->Stop();
+            node.msgproc.reset();
+        }
+        if (node.syncman) {
+            LOG_INFO(util::LogCategory::NET) << "Stopping block synchronizer...";
+            node.syncman->Stop();
+            node.syncman.reset();
+        }
+        if (node.connman) {
+            LOG_INFO(util::LogCategory::NET) << "Stopping P2P network...";
+            node.connman->Stop();
+            node.connman.reset();
+        }
+    });
+    if (node.addrman) {
+        // Its background saver; the final save comes below
+        shutdown.AddStep("addrman", [&node] { node.addrman->Stop(); });
     }
-    
-    // ========================================================================
-    // Step 2: Stop sync manager
-    // ========================================================================
-    
-    if (node.syncman) {
-        LOG_INFO(util::LogCategory::NET) << "Stopping block synchronizer...";
-        node.syncman->Stop();
-        node.syncman.reset();
+    if (node.mempoolLoader.joinable()) {
+        shutdown.AddStep("mempool-loader", [&node] {
+            node.mempoolLoadInterrupt.store(true);
+            node.mempoolLoader.join();
+        });
     }
-    
-    // ========================================================================
-    // Step 3: Stop network
-    // ========================================================================
-    
-    if (node.connman) {
-        LOG_INFO(util::LogCategory::NET) << "Stopping P2P network...";
-        node.connman->Stop();
-        node.connman.reset();
+    if (node.txIndexer) {
+        shutdown.AddStep("txindex", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Stopping transaction indexer at height "
+                                                 << node.txIndexer->GetBestHeight() << "...";
+            node.txIndexer->Stop();
+            node.txIndexer.reset();
+        });
+    }
+    if (node.blockFilterIndexer) {
+        shutdown.AddStep("blockfilterindex", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Stopping block filter indexer at height "
+                                                 << node.blockFilterIndexer->GetBestHeight()
+                                                 << "...";
+            node.blockFilterIndexer->Stop();
+            node.blockFilterIndexer.reset();
+        });
     }
     
     // ========================================================================
-    // Step 3.5: Save and stop address manager
+    // Stage 2: Save caches. Peers, mempool and fee estimates are rebuilt if
+    // lost, so they run side by side and are abandoned past the deadline;
+    // each step owns its subsystem so nothing it uses is freed under it.
     // ========================================================================
     
+    shutdown.AddStage("save", SHUTDOWN_SAVE_DEADLINE);
     if (node.addrman) {
-        LOG_INFO(util::LogCategory::NET) << "Saving peer addresses...";
+        std::shared_ptr<AddressManager> addrman(std::move(node.addrman));
         auto addrPath = node.dataDir / "peers.dat";
-        node.addrman->Save(addrPath.string());
-        node.addrman->Stop();
-        node.addrman.reset();
+        shutdown.AddStep("peers", [addrman, addrPath] {
+            // The background saver usually wrote the table already
+            if (addrman->HasUnsavedChanges()) {
+                LOG_INFO(util::LogCategory::NET) << "Saving peer addresses...";
+                addrman->Save(addrPath.string());
+            }
+        });
     }
-    
-    // ========================================================================
-    // Step 4: Clear mempool
-    // ========================================================================
-    
     if (node.mempool) {
-        LOG_INFO(util::LogCategory::MEMPOOL) << "Clearing mempool (" 
-                                             << node.mempool->Size() << " transactions)...";
-        node.mempool->Clear();
-        node.mempool.reset();
+        std::shared_ptr<Mempool> mempool(std::move(node.mempool));
+        bool dump = node.persistMempool && node.mempoolLoaded.load();
+        auto dumpPath = node.dataDir / MEMPOOL_DUMP_FILENAME;
+        shutdown.AddStep("mempool", [mempool, dump, dumpPath] {
+            if (dump) {
+                LOG_INFO(util::LogCategory::MEMPOOL) << "Saving mempool...";
+                DumpMempool(*mempool, dumpPath);
+            }
+            LOG_INFO(util::LogCategory::MEMPOOL) << "Clearing mempool ("
+                                                 << mempool->Size() << " transactions)...";
+            mempool->Clear();
+        });
+    }
+    if (node.feeEstimator) {
+        std::shared_ptr<FeeEstimator> feeEstimator(std::move(node.feeEstimator));
+        auto feePath = node.dataDir / FEE_ESTIMATES_FILENAME;
+        shutdown.AddStep("fee-estimates", [feeEstimator, feePath] {
+            feeEstimator->Save(feePath);
+        });
     }
     
     // ========================================================================
-    // Step 5: Flush chain state
+    // Stage 3: Flush chain state. Consensus state is written in full, in
+    // order, on this thread.
     // ========================================================================
     
+    shutdown.AddCriticalStage("chainstate");
     if (node.chainman) {
-        LOG_INFO(util::LogCategory::DEFAULT) << "Flushing chain state...";
-        auto& chainstate = node.chainman->GetActiveChainState();
-        chainstate.FlushStateToDisk();
-        
-        // Save best chain tip
-        BlockIndex* tip = node.chainman->GetActiveTip();
-        if (tip && node.blockDB) {
-            node.blockDB->WriteBestChainTip(tip->GetBlockHash());
-        }
-        
-        node.chainman.reset();
+        shutdown.AddStep("flush", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Flushing chain state...";
+            auto& chainstate = node.chainman->GetActiveChainState();
+            chainstate.FlushStateToDisk();
+            
+            // Save best chain tip
+            BlockIndex* tip = node.chainman->GetActiveTip();
+            if (tip && node.blockDB) {
+                node.blockDB->WriteBestChainTip(tip->GetBlockHash());
+            }
+            
+            node.chainman.reset();
+        });
     }
     
     // ========================================================================
-    // Step 6: Close databases
+    // Stage 4: Close databases. Independent stores close in parallel.
     // ========================================================================
     
+    shutdown.AddStage("databases");
     if (node.txIndex) {
-        LOG_INFO(util::LogCategory::DEFAULT) << "Closing transaction index...";
-        node.txIndex.reset();
+        shutdown.AddStep("txindex", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Closing transaction index...";
+            node.txIndex.reset();
+        });
+    }
+    if (node.blockFilterIndex) {
+        shutdown.AddStep("blockfilterindex", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Closing block filter index...";
+            node.blockFilterIndex.reset();
+        });
     }
-    
     if (node.coinsDB) {
-        LOG_INFO(util::LogCategory::DEFAULT) << "Closing UTXO database...";
-        node.coinsDB.reset();
+        shutdown.AddStep("coins", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Closing UTXO database...";
+            node.coinsDB.reset();
+        });
     }
-    
     if (node.blockDB) {
-        LOG_INFO(util::LogCategory::DEFAULT) << "Closing block database...";
-        node.blockDB->Flush();
-        node.blockDB.reset();
+        shutdown.AddStep("blocks", [&node] {
+            LOG_INFO(util::LogCategory::DEFAULT) << "Closing block database...";
+            node.blockDB->Flush();
+            node.blockDB.reset();
+        });
     }
     
-    // ========================================================================
-    // Step 5: Clean up params
-    // ========================================================================
+    shutdown.Run();
     
     node.params.reset();
     
@@ -658,9 +1005,9 @@ bool FlushNodeState(NodeContext& node) {
     
     LOG_DEBUG(util::LogCategory::DEFAULT) << "Flushing node state...";
     
-    // Flush chain state
+    // Flush chain state in the background so validation keeps running
     auto& chainstate = node.chainman->GetActiveChainState();
-    if (!chainstate.FlushStateToDisk()) {
+    if (!chainstate.FlushStateToDiskAsync()) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to flush chain state";
         return false;
     }
@@ -684,6 +1031,34 @@ bool FlushNodeState(NodeContext& node) {
     return true;
 }
 
+// ============================================================================
+// MaintainNodeState - Periodic upkeep
+// ============================================================================
+
+void MaintainNodeState(NodeContext& node) {
+    if (!node.IsReady()) {
+        return;
+    }
+    
+    auto& chainstate = node.chainman->GetActiveChainState();
+    if (node.mempool) {
+        chainstate.SetMempoolUsage(node.mempool->DynamicMemoryUsage());
+    }
+    if (chainstate.FlushIfIdle(std::chrono::seconds(DEFAULT_COINS_IDLE_FLUSH_SECONDS))) {
+        LOG_DEBUG(util::LogCategory::DEFAULT) << "No new block for "
+                                               << DEFAULT_COINS_IDLE_FLUSH_SECONDS
+                                               << "s, writing the UTXO cache";
+    }
+    
+    // Save the mempool now and then, so a crash does not lose all of it
+    auto now = std::chrono::steady_clock::now();
+    if (node.mempool && node.persistMempool && node.mempoolLoaded.load() &&
+        now - node.lastMempoolDump >= std::chrono::seconds(DEFAULT_MEMPOOL_DUMP_INTERVAL)) {
+        node.lastMempoolDump = now;
+        DumpMempool(*node.mempool, node.dataDir / MEMPOOL_DUMP_FILENAME);
+    }
+}
+
 // ============================================================================
 // LoadBlockIndex - Load block index from database
 // ============================================================================
@@ -697,14 +1072,24 @@ int LoadBlockIndex(NodeContext& node) {
     
     BlockMap& blockIndex = node.chainman->GetBlockIndex();
     
-    // LoadBlockIndexMap now also wires up parent pointers
-    int nLoaded = node.blockDB->LoadBlockIndexMap(blockIndex);
+    // LoadBlockIndexMap also wires up parent pointers and chain work
+    db::BlockIndexLoadStats stats;
+    int nLoaded = node.blockDB->LoadBlockIndexMap(
+        blockIndex, node.chainman->GetScriptCheckThreads(), &stats);
     
     if (nLoaded < 0) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Error loading block index";
         return -1;
     }
     
+    LOG_INFO(util::LogCategory::DEFAULT) << "Block index load: " << stats.nEntries
+                                         << " entries, read " << stats.readMicros / 1000
+                                         << "ms (" << stats.nThreads << " thread(s)), sort "
+                                         << stats.sortMicros / 1000 << "ms, link "
+                                         << stats.linkMicros / 1000 << "ms, "
+                                         << blockIndex.GetMemoryUsage() / (1024 * 1024)
+                                         << " MiB in memory";
+    
     // Count orphans (blocks with missing parent)
     int nOrphans = 0;
     for (const auto& [hash, indexPtr] : blockIndex) {
@@ -723,6 +1108,26 @@ int LoadBlockIndex(NodeContext& node) {
     return nLoaded;
 }
 
+// ============================================================================
+// ReindexBlockFiles - Rebuild the block index from the block files
+// ============================================================================
+
+int ReindexBlockFiles(NodeContext& node) {
+    if (!node.blockDB || !node.chainman) {
+        return -1;
+    }
+    
+    LOG_INFO(util::LogCategory::DEFAULT) << "Reindexing blocks from disk...";
+    
+    BlockReindexer reindexer(*node.chainman, *node.blockDB);
+    if (!reindexer.Run()) {
+        LOG_ERROR(util::LogCategory::DEFAULT) << "Reindex did not complete";
+        return -1;
+    }
+    
+    return static_cast<int>(reindexer.GetStats().nBlocksProcessed);
+}
+
 // ============================================================================
 // VerifyBlockIndex - Verify block index integrity
 // ============================================================================
@@ -768,7 +1173,7 @@ bool VerifyBlockIndex(const NodeContext& node, int checkLevel) {
         const BlockIndex* genesis = nullptr;
         for (const auto& [hash, indexPtr] : blockIndex) {
             if (indexPtr->nHeight == 0) {
-                genesis = indexPtr.get();
+                genesis = indexPtr;
                 break;
             }
         }
@@ -832,18 +1237,18 @@ bool ActivateBestChain(NodeContext& node) {
     BlockIndex* bestBlock = nullptr;
     for (const auto& [hash, indexPtr] : blockIndex) {
         if (!bestBlock) {
-            bestBlock = indexPtr.get();
+            bestBlock = indexPtr;
             continue;
         }
         
         // Compare chainwork (cumulative difficulty)
         // Higher chainwork = more secure chain
         if (indexPtr->nChainWork > bestBlock->nChainWork) {
-            bestBlock = indexPtr.get();
+            bestBlock = indexPtr;
         } else if (indexPtr->nChainWork == bestBlock->nChainWork) {
             // If chainwork is equal, use height as tiebreaker (shouldn't happen normally)
             if (indexPtr->nHeight > bestBlock->nHeight) {
-                bestBlock = indexPtr.get();
+                bestBlock = indexPtr;
             }
         }
     }
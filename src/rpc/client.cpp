@@ -8,7 +8,9 @@
 #include <algorithm>
 #include <cctype>
 #include <cstring>
+#include <deque>
 #include <iostream>
+#include <map>
 #include <sstream>
 
 #ifdef _WIN32
@@ -32,6 +34,12 @@
     #define CLOSE_SOCKET close
 #endif
 
+#ifdef MSG_NOSIGNAL
+    #define SEND_FLAGS MSG_NOSIGNAL
+#else
+    #define SEND_FLAGS 0
+#endif
+
 namespace shurium {
 namespace rpc {
 
@@ -112,6 +120,7 @@ bool RPCClient::CreateConnection() {
         
         if (connect(socket_, p->ai_addr, static_cast<int>(p->ai_addrlen)) == 0) {
             freeaddrinfo(result);
+            ++connectionsOpened_;
             return true;
         }
         
@@ -130,6 +139,8 @@ void RPCClient::CloseConnection() {
         CLOSE_SOCKET(socket_);
         socket_ = INVALID_SOCKET_VALUE;
     }
+    requestsOnConnection_ = 0;
+    recvBuffer_.clear();
 }
 
 RPCResponse RPCClient::Call(const std::string& method, const JSONValue& params) {
@@ -204,19 +215,25 @@ RPCResponse RPCClient::Call(const std::string& method, const JSONValue& params)
     return RPCResponse::Success((*parsed)["result"], (*parsed)["id"]);
 }
 
-std::vector<RPCResponse> RPCClient::BatchCall(const std::vector<RPCRequest>& requests) {
-    std::vector<RPCResponse> responses;
-    
-    if (requests.empty()) return responses;
-    
-    // Build batch JSON
+namespace {
+
+/// Body of a batch request
+std::string BatchJSON(const std::vector<RPCRequest>& requests) {
     JSONValue::Array arr;
     for (const auto& req : requests) {
         arr.push_back(JSONValue::Parse(req.ToJSON()));
     }
+    return JSONValue(arr).ToJSON();
+}
+
+} // anonymous namespace
+
+std::vector<RPCResponse> RPCClient::BatchCall(const std::vector<RPCRequest>& requests) {
+    std::vector<RPCResponse> responses;
     
-    std::string requestJson = JSONValue(arr).ToJSON();
-    std::string httpRequest = BuildHTTPRequest(requestJson);
+    if (requests.empty()) return responses;
+    
+    std::string httpRequest = BuildHTTPRequest(BatchJSON(requests));
     
     // Connect if needed
     {
@@ -242,42 +259,111 @@ std::vector<RPCResponse> RPCClient::BatchCall(const std::vector<RPCRequest>& req
         return responses;
     }
     
-    // Parse HTTP response
-    std::string body;
-    int statusCode;
-    if (!ParseHTTPResponse(response, body, statusCode)) {
-        for (const auto& req : requests) {
-            responses.push_back(RPCResponse::Error(
-                ErrorCode::NETWORK_ERROR, "Invalid HTTP response", req.GetId()));
-        }
-        return responses;
-    }
+    return ParseBatchResponse(response, requests);
+}
+
+bool RPCClient::PipelineBatches(const BatchSource& source, const BatchSink& sink,
+                                size_t maxInFlight) {
+    struct InFlight {
+        std::vector<RPCRequest> requests;
+        std::string httpRequest;
+        bool resent{false};
+    };
     
-    // Parse JSON array response
-    auto parsed = JSONValue::TryParse(body);
-    if (!parsed || !parsed->IsArray()) {
-        for (const auto& req : requests) {
-            responses.push_back(RPCResponse::Error(
-                ErrorCode::PARSE_ERROR, "Invalid batch response", req.GetId()));
+    std::lock_guard<std::mutex> lock(socketMutex_);
+    std::deque<InFlight> inFlight;
+    maxInFlight = std::max<size_t>(1, maxInFlight);
+    
+    auto fail = [&](const InFlight& batch, const std::string& message) {
+        std::vector<RPCResponse> responses;
+        for (const auto& req : batch.requests) {
+            responses.push_back(RPCResponse::Error(ErrorCode::NETWORK_ERROR, message, req.GetId()));
         }
-        return responses;
+        totalErrors_ += batch.requests.size();
+        sink(batch.requests, std::move(responses));
+    };
+    auto failAll = [&]() {
+        for (const auto& batch : inFlight) {
+            fail(batch, lastError_);
+        }
+        inFlight.clear();
+        return false;
+    };
+    
+    // The server closed on us: send what it left unanswered again on a
+    // new connection. If nothing was answered since the last time, the
+    // oldest batch is given up on rather than sent a third time
+    size_t answered = 0;
+    auto resend = [&]() {
+        while (true) {
+            CloseConnection();
+            if (!inFlight.empty() && inFlight.front().resent && answered == 0) {
+                fail(inFlight.front(), "Connection closed");
+                inFlight.pop_front();
+            }
+            if (inFlight.empty()) return true;
+            if (!CreateConnection()) return false;
+            answered = 0;
+            bool sent = true;
+            for (auto& batch : inFlight) {
+                batch.resent = true;
+                if (!SendAll(batch.httpRequest)) {
+                    sent = false;
+                    break;
+                }
+            }
+            if (sent) return true;
+        }
+    };
+    
+    if (!IsConnected() && !CreateConnection()) {
+        return false;
     }
     
-    for (size_t i = 0; i < parsed->Size(); ++i) {
-        const auto& item = (*parsed)[i];
-        if (item.HasKey("error") && !item["error"].IsNull()) {
-            const auto& err = item["error"];
-            responses.push_back(RPCResponse::Error(
-                static_cast<int>(err["code"].GetInt()),
-                err["message"].GetString(),
-                item["id"],
-                err["data"]));
-        } else {
-            responses.push_back(RPCResponse::Success(item["result"], item["id"]));
+    bool more = true;
+    while (more || !inFlight.empty()) {
+        // Keep the pipe full
+        while (more && inFlight.size() < maxInFlight) {
+            InFlight batch;
+            if (!source(batch.requests)) {
+                more = false;
+                break;
+            }
+            if (batch.requests.empty()) continue;
+            
+            batch.httpRequest = BuildHTTPRequest(BatchJSON(batch.requests));
+            totalCalls_ += batch.requests.size();
+            inFlight.push_back(std::move(batch));
+            
+            if (!IsConnected() || !SendAll(inFlight.back().httpRequest)) {
+                if (!resend()) return failAll();
+            }
+        }
+        if (inFlight.empty()) break;
+        
+        // Then take the oldest answer
+        std::optional<std::string> response;
+        try {
+            response = ReadResponse();
+        } catch (const std::exception& e) {
+            lastError_ = e.what();
+            lastErrorCode_ = ErrorCode::NETWORK_ERROR;
+        }
+        if (!response) {
+            if (!resend()) return failAll();
+            continue;
+        }
+        
+        InFlight batch = std::move(inFlight.front());
+        inFlight.pop_front();
+        ++answered;
+        sink(batch.requests, ParseBatchResponse(*response, batch.requests));
+        
+        if (!IsConnected() && !inFlight.empty() && !resend()) {
+            return failAll();
         }
     }
-    
-    return responses;
+    return true;
 }
 
 std::future<RPCResponse> RPCClient::CallAsync(const std::string& method,
@@ -313,6 +399,77 @@ double RPCClient::GetAverageResponseTime() const {
     return static_cast<double>(totalResponseTime_.load()) / static_cast<double>(calls);
 }
 
+namespace {
+
+/// Lower-cased value of a response header, empty if absent
+std::string FindHeader(const std::string& lowerHeaders, const std::string& name) {
+    size_t pos = lowerHeaders.find("\r\n" + name + ":");
+    if (pos == std::string::npos) return "";
+    pos += name.size() + 3;
+    size_t end = lowerHeaders.find("\r\n", pos);
+    std::string value = lowerHeaders.substr(pos, end == std::string::npos ? end : end - pos);
+    while (!value.empty() && value.front() == ' ') value.erase(0, 1);
+    while (!value.empty() && value.back() == ' ') value.pop_back();
+    return value;
+}
+
+/**
+ * Length of the first complete response in data, or npos if more is
+ * needed. untilClose is set when the response has neither a length nor
+ * chunks and so ends with the connection; closeAfter when the server
+ * will not take another request on it.
+ */
+size_t CompleteResponseLength(const std::string& data, bool& untilClose, bool& closeAfter) {
+    size_t headerEnd = data.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) return std::string::npos;
+    size_t bodyStart = headerEnd + 4;
+    
+    std::string lowerHeaders = data.substr(0, headerEnd);
+    std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(), ::tolower);
+    closeAfter = FindHeader(lowerHeaders, "connection") == "close" ||
+                 lowerHeaders.compare(0, 8, "http/1.0") == 0;
+    untilClose = false;
+    
+    if (FindHeader(lowerHeaders, "transfer-encoding") == "chunked") {
+        // Walk the chunks up to the last one and its (empty) trailer
+        size_t pos = bodyStart;
+        while (true) {
+            size_t lineEnd = data.find("\r\n", pos);
+            if (lineEnd == std::string::npos) return std::string::npos;
+            size_t chunkSize;
+            try {
+                chunkSize = std::stoul(data.substr(pos, lineEnd - pos), nullptr, 16);
+            } catch (...) {
+                throw std::runtime_error("Invalid chunked response");
+            }
+            pos = lineEnd + 2;
+            if (chunkSize == 0) {
+                size_t trailerEnd = data.find("\r\n", pos);
+                while (trailerEnd != std::string::npos && trailerEnd != pos) {
+                    pos = trailerEnd + 2;
+                    trailerEnd = data.find("\r\n", pos);
+                }
+                return trailerEnd == std::string::npos ? std::string::npos : trailerEnd + 2;
+            }
+            if (data.size() < pos + chunkSize + 2) return std::string::npos;
+            pos += chunkSize + 2;
+        }
+    }
+    
+    std::string contentLength = FindHeader(lowerHeaders, "content-length");
+    if (!contentLength.empty()) {
+        size_t length = std::stoul(contentLength);
+        return data.size() >= bodyStart + length ? bodyStart + length : std::string::npos;
+    }
+    
+    // No Content-Length and not chunked: the body runs to connection close
+    untilClose = true;
+    closeAfter = true;
+    return std::string::npos;
+}
+
+} // anonymous namespace
+
 std::string RPCClient::SendRequest(const std::string& request) {
     std::lock_guard<std::mutex> lock(socketMutex_);
     
@@ -320,74 +477,77 @@ std::string RPCClient::SendRequest(const std::string& request) {
         throw std::runtime_error("Not connected");
     }
     
-    // Send request
-    ssize_t totalSent = 0;
-    while (totalSent < static_cast<ssize_t>(request.size())) {
-        ssize_t sent = send(socket_, request.c_str() + totalSent,
-                          static_cast<int>(request.size() - totalSent), 0);
-        if (sent <= 0) {
+    // The server may have closed a kept-alive connection while it sat idle;
+    // if nothing at all comes back on it, try once more on a fresh one
+    bool reused = requestsOnConnection_ > 0;
+    for (int attempt = 0; ; ++attempt) {
+        if (attempt > 0 && !CreateConnection()) {
+            throw std::runtime_error(lastError_);
+        }
+        bool mayRetry = reused && attempt == 0;
+        
+        if (!SendAll(request)) {
             CloseConnection();
+            if (mayRetry) continue;
             throw std::runtime_error("Send failed");
         }
-        totalSent += sent;
+        
+        std::optional<std::string> response = ReadResponse();
+        if (!response) {
+            if (mayRetry) continue;  // Stale connection; retry
+            throw std::runtime_error("Connection closed");
+        }
+        return std::move(*response);
     }
+}
+
+bool RPCClient::SendAll(const std::string& data) {
+    size_t totalSent = 0;
+    while (totalSent < data.size()) {
+        ssize_t sent = send(socket_, data.c_str() + totalSent,
+                            static_cast<int>(data.size() - totalSent), SEND_FLAGS);
+        if (sent <= 0) {
+            return false;
+        }
+        totalSent += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+std::optional<std::string> RPCClient::ReadResponse() {
+    // Pipelined answers may already be waiting in the buffer
+    char buffer[16384];
+    bool untilClose = false;
+    bool closeAfter = false;
+    size_t responseLength = CompleteResponseLength(recvBuffer_, untilClose, closeAfter);
     
-    // Receive response
-    std::string response;
-    char buffer[4096];
-    
-    while (true) {
-        ssize_t received = recv(socket_, buffer, sizeof(buffer) - 1, 0);
+    while (responseLength == std::string::npos) {
+        ssize_t received = recv(socket_, buffer, sizeof(buffer), 0);
         if (received < 0) {
             CloseConnection();
             throw std::runtime_error("Receive failed");
         }
-        if (received == 0) break;
-        
-        buffer[received] = '\0';
-        response += buffer;
-        
-        // Check if we have complete response (Content-Length or chunked)
-        size_t headerEnd = response.find("\r\n\r\n");
-        if (headerEnd != std::string::npos) {
-            std::string headers = response.substr(0, headerEnd);
-            std::string lowerHeaders = headers;
-            std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(), ::tolower);
-            
-            // Check for chunked transfer encoding
-            if (lowerHeaders.find("transfer-encoding: chunked") != std::string::npos) {
-                // For chunked encoding, look for final chunk (0\r\n\r\n)
-                size_t bodyStart = headerEnd + 4;
-                std::string body = response.substr(bodyStart);
-                // The final chunk is "0\r\n" followed by optional trailers and "\r\n"
-                if (body.find("0\r\n\r\n") != std::string::npos || 
-                    body.find("\r\n0\r\n\r\n") != std::string::npos) {
-                    break;  // Complete chunked response
-                }
-            } else {
-                // Find Content-Length
-                size_t clPos = lowerHeaders.find("content-length:");
-                if (clPos != std::string::npos) {
-                    size_t clEnd = headers.find("\r\n", clPos);
-                    std::string clStr = headers.substr(clPos + 15, clEnd - clPos - 15);
-                    // Trim whitespace
-                    while (!clStr.empty() && clStr.front() == ' ') clStr.erase(0, 1);
-                    size_t contentLength = std::stoul(clStr);
-                    size_t bodyStart = headerEnd + 4;
-                    if (response.size() >= bodyStart + contentLength) {
-                        break;  // Complete response
-                    }
-                } else {
-                    // No Content-Length and not chunked, wait for connection close
-                    break;
-                }
+        if (received == 0) {
+            if (untilClose) {
+                responseLength = recvBuffer_.size();
+                break;
             }
+            bool nothing = recvBuffer_.empty();
+            CloseConnection();
+            if (nothing) return std::nullopt;
+            throw std::runtime_error("Connection closed");
         }
+        recvBuffer_.append(buffer, static_cast<size_t>(received));
+        responseLength = CompleteResponseLength(recvBuffer_, untilClose, closeAfter);
     }
     
-    // Close connection after each request (HTTP/1.0 style for simplicity)
-    CloseConnection();
-    
+    std::string response = recvBuffer_.substr(0, responseLength);
+    recvBuffer_.erase(0, responseLength);
+    if (closeAfter) {
+        CloseConnection();
+    } else {
+        ++requestsOnConnection_;
+    }
     return response;
 }
 
@@ -398,7 +558,7 @@ std::string RPCClient::BuildHTTPRequest(const std::string& body) {
     ss << "Host: " << config_.host << ":" << config_.port << "\r\n";
     ss << "Content-Type: application/json\r\n";
     ss << "Content-Length: " << body.size() << "\r\n";
-    ss << "Connection: close\r\n";
+    ss << "Connection: keep-alive\r\n";
     
     // Add authentication if configured
     if (!config_.rpcUser.empty()) {
@@ -518,6 +678,60 @@ bool RPCClient::ParseHTTPResponse(const std::string& raw, std::string& body, int
     return true;
 }
 
+std::vector<RPCResponse> RPCClient::ParseBatchResponse(const std::string& raw,
+                                                       const std::vector<RPCRequest>& requests) {
+    std::vector<RPCResponse> responses;
+    
+    std::string body;
+    int statusCode;
+    if (!ParseHTTPResponse(raw, body, statusCode)) {
+        for (const auto& req : requests) {
+            responses.push_back(RPCResponse::Error(
+                ErrorCode::NETWORK_ERROR, "Invalid HTTP response", req.GetId()));
+        }
+        return responses;
+    }
+    
+    // Parse JSON array response
+    auto parsed = JSONValue::TryParse(body);
+    if (!parsed || !parsed->IsArray()) {
+        for (const auto& req : requests) {
+            responses.push_back(RPCResponse::Error(
+                ErrorCode::PARSE_ERROR, "Invalid batch response", req.GetId()));
+        }
+        return responses;
+    }
+    
+    // The server may answer a batch in any order
+    std::map<std::string, size_t> byId;
+    for (size_t i = 0; i < parsed->Size(); ++i) {
+        byId.emplace((*parsed)[i]["id"].ToJSON(), i);
+    }
+    
+    responses.reserve(requests.size());
+    for (const auto& req : requests) {
+        auto it = byId.find(req.GetId().ToJSON());
+        if (it == byId.end()) {
+            responses.push_back(RPCResponse::Error(
+                ErrorCode::INTERNAL_ERROR, "No response in batch", req.GetId()));
+            continue;
+        }
+        const auto& item = (*parsed)[it->second];
+        if (item.HasKey("error") && !item["error"].IsNull()) {
+            const auto& err = item["error"];
+            responses.push_back(RPCResponse::Error(
+                static_cast<int>(err["code"].GetInt()),
+                err["message"].GetString(),
+                item["id"],
+                err["data"]));
+        } else {
+            responses.push_back(RPCResponse::Success(item["result"], item["id"]));
+        }
+    }
+    
+    return responses;
+}
+
 int64_t RPCClient::GenerateId() {
     return nextId_++;
 }
@@ -670,7 +884,7 @@ JSONValue RPCCLIParser::ParseArg(const std::string& arg) const {
             arg.find('E') != std::string::npos) {
             return JSONValue(std::stod(arg));
         }
-        return JSONValue(std::stoll(arg));
+        return JSONValue(static_cast<int64_t>(std::stoll(arg)));
     } catch (...) {
         // Not a number
     }
@@ -6,16 +6,24 @@
 // to provide the real definitions that match the forward declarations.
 #include <shurium/chain/chainstate.h>
 #include <shurium/chain/blockindex.h>
+#include <shurium/chain/txindexer.h>
+#include <shurium/chain/blockfilterindexer.h>
+#include <shurium/chain/utxosnapshot.h>
 #include <shurium/mempool/mempool.h>
+#include <shurium/mempool/fees.h>
+#include <shurium/mempool/persist.h>
 #include <shurium/db/blockdb.h>
+#include <shurium/db/utxodb.h>
 #include <shurium/consensus/params.h>
 #include <shurium/consensus/validation.h>
 #include <shurium/wallet/wallet.h>
 #include <shurium/miner/blockassembler.h>
 #include <shurium/miner/miner.h>
+#include <shurium/miner/templatecache.h>
 #include <shurium/network/message_processor.h>
 #include <shurium/network/network_manager.h>
 #include <shurium/identity/identity.h>
+#include <shurium/identity/proofcache.h>
 #include <shurium/economics/ubi.h>
 #include <shurium/economics/funds.h>
 #include <shurium/staking/staking.h>
@@ -26,15 +34,26 @@
 #include <shurium/marketplace/verifier.h>
 #include <shurium/node/context.h>
 #include <shurium/util/logging.h>
+#include <shurium/util/startup.h>
+#include <shurium/util/trace.h>
 #include <shurium/script/interpreter.h>
+#include <shurium/script/profile.h>
+#include <shurium/script/sigcache.h>
+#include <shurium/script/scriptcache.h>
+#include <shurium/script/pubkeycache.h>
 
 #include <shurium/rpc/commands.h>
+#include <shurium/core/hex.h>
+#include <shurium/rpc/jsonwriter.h>
+#include <shurium/rpc/metrics.h>
 #include <shurium/rpc/server.h>
 
 #include <algorithm>
 #include <chrono>
 #include <ctime>
+#include <filesystem>
 #include <iomanip>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 
@@ -127,15 +146,12 @@ bool ValidateAddress(const std::string& address) {
 }
 
 std::vector<Byte> ParseHex(const std::string& hex) {
-    std::vector<Byte> result;
-    result.reserve(hex.size() / 2);
-    
-    for (size_t i = 0; i < hex.size(); i += 2) {
-        if (i + 1 >= hex.size()) break;
-        
-        std::string byteStr = hex.substr(i, 2);
-        Byte b = static_cast<Byte>(std::stoul(byteStr, nullptr, 16));
-        result.push_back(b);
+    if (hex.size() % 2 != 0) {
+        return {};
+    }
+    std::vector<Byte> result(hex.size() / 2);
+    if (!DecodeHex(hex.data(), result.size(), result.data())) {
+        return {};
     }
     return result;
 }
@@ -145,15 +161,7 @@ std::string FormatHex(const std::vector<Byte>& bytes) {
 }
 
 std::string FormatHex(const Byte* data, size_t len) {
-    static const char hexChars[] = "0123456789abcdef";
-    std::string result;
-    result.reserve(len * 2);
-    
-    for (size_t i = 0; i < len; ++i) {
-        result += hexChars[(data[i] >> 4) & 0x0F];
-        result += hexChars[data[i] & 0x0F];
-    }
-    return result;
+    return BytesToHex(data, len);
 }
 
 // Template specializations for GetRequiredParam
@@ -321,6 +329,8 @@ RPCCommandTable::~RPCCommandTable() {
 }
 
 void RPCCommandTable::SetChainState(std::shared_ptr<ChainState> chainState) {
+    std::lock_guard<std::mutex> lock(templateCacheMutex_);
+    templateCache_.reset();
     chainState_ = std::move(chainState);
 }
 
@@ -329,6 +339,8 @@ void RPCCommandTable::SetChainStateManager(std::shared_ptr<ChainStateManager> ch
 }
 
 void RPCCommandTable::SetMempool(std::shared_ptr<Mempool> mempool) {
+    std::lock_guard<std::mutex> lock(templateCacheMutex_);
+    templateCache_.reset();
     mempool_ = std::move(mempool);
 }
 
@@ -372,6 +384,49 @@ void RPCCommandTable::SetMiner(miner::Miner* miner) {
     miner_ = miner;
 }
 
+void RPCCommandTable::SetTxIndexer(TxIndexer* txIndexer) {
+    txIndexer_ = txIndexer;
+}
+
+void RPCCommandTable::SetFeeEstimator(FeeEstimator* feeEstimator) {
+    feeEstimator_ = feeEstimator;
+}
+
+void RPCCommandTable::SetCoinsDB(db::CoinsViewDB* coinsdb) {
+    coinsdb_ = coinsdb;
+}
+
+void RPCCommandTable::SetTxIndex(db::TxIndex* txindex) {
+    txindex_ = txindex;
+}
+
+void RPCCommandTable::SetBlockFilterIndexer(BlockFilterIndexer* filterIndexer) {
+    filterIndexer_ = filterIndexer;
+}
+
+void RPCCommandTable::SetStartupProfile(const util::StartupProfile* profile) {
+    startupProfile_ = profile;
+}
+
+miner::BlockTemplateCache* RPCCommandTable::GetBlockTemplateCache() {
+    std::lock_guard<std::mutex> lock(templateCacheMutex_);
+    if (!templateCache_ && chainState_ && mempool_) {
+        // Pools supply their own coinbase; the template pays OP_TRUE
+        Script coinbaseScript;
+        coinbaseScript.push_back(OP_TRUE);
+        templateCache_ = std::make_unique<miner::BlockTemplateCache>(
+            *chainState_, *mempool_, consensus::Params::Main(), coinbaseScript);
+    }
+    return templateCache_.get();
+}
+
+void RPCCommandTable::NotifyBlockTip() {
+    std::lock_guard<std::mutex> lock(templateCacheMutex_);
+    if (templateCache_) {
+        templateCache_->Notify();
+    }
+}
+
 void RPCCommandTable::RegisterCommands(RPCServer& server) {
     // Register all command categories
     RegisterBlockchainCommands();
@@ -383,8 +438,59 @@ void RPCCommandTable::RegisterCommands(RPCServer& server) {
     RegisterMiningCommands();
     RegisterUtilityCommands();
     
+    // Queries the server may run concurrently inside a batch. Wallet calls
+    // stay out: their answers depend on lock state set by earlier calls.
+    static const std::set<std::string> readOnlyCommands = {
+        "getblockchaininfo", "getbestblockhash", "getblockcount", "getblock",
+        "getblockhash", "getblockheader", "getchaintips", "getdifficulty",
+        "getmempoolinfo", "getrawmempool", "gettransaction", "getrawtransaction",
+        "decoderawtransaction", "getindexinfo", "getdbstats", "gettxoutsetinfo",
+        "getnetworkinfo", "getpeerinfo", "getconnectioncount", "getaddednodeinfo",
+        "getidentityinfo", "getidentitystatus", "getubiinfo", "getubihistory",
+        "getstakinginfo", "getvalidatorinfo", "listvalidators", "listdelegations",
+        "getpendingrewards", "getgovernanceinfo", "listproposals", "getproposal",
+        "getvoteinfo", "getparameter", "listparameters", "getmininginfo",
+        "listproblems", "getproblem", "getmarketplaceinfo", "getsolverrewards",
+        "help", "uptime", "getnodereadiness", "getrpcinfo", "getmemoryinfo", "echo", "validateaddress",
+        "createmultisig", "estimatefee", "estimatesmartfee", "getfundinfo",
+        "getfundbalance", "listfundtransactions", "getfundaddress",
+    };
+    
+    // Hot status queries answered from the server's response cache. Each
+    // entry lives until its TTL runs out or the state it reads changes.
+    RPCCommandTable* table = this;
+    auto tipGeneration = [table]() -> uint64_t {
+        ChainState* chainState = table->GetChainState();
+        BlockIndex* tip = chainState ? chainState->GetTip() : nullptr;
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(tip));
+    };
+    auto mix = [](uint64_t a, uint64_t b) {
+        return a ^ (b * 0x9E3779B97F4A7C15ULL + 0x7F4A7C15ULL + (a << 6) + (a >> 2));
+    };
+    std::map<std::string, RPCCachePolicy> cachePolicies;
+    cachePolicies["getbestblockhash"] = {std::chrono::seconds(30), tipGeneration};
+    cachePolicies["getblockchaininfo"] = {std::chrono::seconds(5), tipGeneration};
+    cachePolicies["getmininginfo"] = {std::chrono::seconds(1), [table, tipGeneration, mix]() {
+        Mempool* mempool = table->GetMempool();
+        return mix(tipGeneration(), mempool ? mempool->GetChangeSequence() : 0);
+    }};
+    cachePolicies["getstakinginfo"] = {std::chrono::seconds(5), [table, tipGeneration, mix]() {
+        staking::StakingEngine* engine = table->GetStakingEngine();
+        return mix(tipGeneration(), engine ? static_cast<uint64_t>(engine->GetCurrentHeight()) : 0);
+    }};
+    cachePolicies["getgovernanceinfo"] = {std::chrono::seconds(5), [table, tipGeneration, mix]() {
+        governance::GovernanceEngine* engine = table->GetGovernanceEngine();
+        return mix(tipGeneration(), engine ? static_cast<uint64_t>(engine->GetCurrentHeight()) : 0);
+    }};
+    
     // Register all commands with the server
-    for (const auto& cmd : commands_) {
+    server_ = &server;
+    for (auto& cmd : commands_) {
+        cmd.readOnly = readOnlyCommands.count(cmd.name) > 0;
+        auto policy = cachePolicies.find(cmd.name);
+        if (policy != cachePolicies.end()) {
+            cmd.cache = policy->second;
+        }
         server.RegisterMethod(cmd);
     }
 }
@@ -531,6 +637,30 @@ void RPCCommandTable::RegisterBlockchainCommands() {
         {"True for JSON object, false for array of txids"}
     });
     
+    commands_.push_back({
+        "savemempool",
+        Category::BLOCKCHAIN,
+        "Write the mempool to a file, by default mempool.dat in the data directory.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_savemempool(req, ctx, table);
+        },
+        true, false,
+        {"path"},
+        {"Destination file (relative paths are inside the data directory)"}
+    });
+    
+    commands_.push_back({
+        "loadmempool",
+        Category::BLOCKCHAIN,
+        "Add the transactions of a saved mempool file to the mempool.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_loadmempool(req, ctx, table);
+        },
+        true, false,
+        {"path"},
+        {"Mempool file (relative paths are inside the data directory)"}
+    });
+    
     commands_.push_back({
         "gettransaction",
         Category::BLOCKCHAIN,
@@ -551,8 +681,9 @@ void RPCCommandTable::RegisterBlockchainCommands() {
             return cmd_getrawtransaction(req, ctx, table);
         },
         false, false,
-        {"txid", "verbose"},
-        {"The transaction id", "If true, return JSON object"}
+        {"txid", "verbose", "blockhash"},
+        {"The transaction id", "If true, return JSON object",
+         "The block to look in (not needed with -txindex)"}
     });
     
     commands_.push_back({
@@ -578,6 +709,66 @@ void RPCCommandTable::RegisterBlockchainCommands() {
         {"hexstring"},
         {"The hex string of the raw transaction"}
     });
+    
+    commands_.push_back({
+        "dumptxoutset",
+        Category::BLOCKCHAIN,
+        "Write the UTXO set at the current tip to a snapshot file.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_dumptxoutset(req, ctx, table);
+        },
+        true, false,
+        {"path"},
+        {"Destination file (relative paths are inside the data directory)"}
+    });
+    
+    commands_.push_back({
+        "loadtxoutset",
+        Category::BLOCKCHAIN,
+        "Load a trusted UTXO snapshot and move the tip to its base block.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_loadtxoutset(req, ctx, table);
+        },
+        true, false,
+        {"path"},
+        {"Snapshot file (relative paths are inside the data directory)"}
+    });
+    
+    commands_.push_back({
+        "getindexinfo",
+        Category::BLOCKCHAIN,
+        "Returns the status of the optional indexes.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_getindexinfo(req, ctx, table);
+        },
+        false, false,
+        {},
+        {}
+    });
+    
+    commands_.push_back({
+        "getdbstats",
+        Category::BLOCKCHAIN,
+        "Returns operation counts, latencies and engine metrics for each database.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_getdbstats(req, ctx, table);
+        },
+        false, false,
+        {},
+        {}
+    });
+    
+    commands_.push_back({
+        "gettxoutsetinfo",
+        Category::BLOCKCHAIN,
+        "Returns the rolling hash of the UTXO set at the chain tip.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_gettxoutsetinfo(req, ctx, table);
+        },
+        false, false,
+        {},
+        {}
+    });
 }
 
 // ============================================================================
@@ -872,6 +1063,30 @@ void RPCCommandTable::RegisterWalletCommands() {
         {"The private key", "An optional label", "Rescan the wallet (default=true)"}
     });
     
+    commands_.push_back({
+        "rescanblockchain",
+        Category::WALLET,
+        "Rescans the active chain for transactions paying or spending from the wallet.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_rescanblockchain(req, ctx, table);
+        },
+        true, true,
+        {"start_height", "stop_height"},
+        {"First height to scan (default=0)", "Last height to scan (default=tip)"}
+    });
+    
+    commands_.push_back({
+        "abortrescan",
+        Category::WALLET,
+        "Stops the wallet rescan in progress.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_abortrescan(req, ctx, table);
+        },
+        true, true,
+        {},
+        {}
+    });
+    
     commands_.push_back({
         "walletlock",
         Category::WALLET,
@@ -1558,6 +1773,30 @@ void RPCCommandTable::RegisterUtilityCommands() {
         {}
     });
     
+    commands_.push_back({
+        "getnodereadiness",
+        Category::UTILITY,
+        "Returns whether the node can serve, what still holds it back, and how long each startup phase took.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_getnodereadiness(req, ctx, table);
+        },
+        false, false,
+        {},
+        {}
+    });
+    
+    commands_.push_back({
+        "getrpcinfo",
+        Category::UTILITY,
+        "Returns RPC server statistics, including response cache hit rate.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_getrpcinfo(req, ctx, table);
+        },
+        false, false,
+        {},
+        {}
+    });
+    
     commands_.push_back({
         "getmemoryinfo",
         Category::UTILITY,
@@ -1570,6 +1809,30 @@ void RPCCommandTable::RegisterUtilityCommands() {
         {}
     });
     
+    commands_.push_back({
+        "getscriptprofile",
+        Category::UTILITY,
+        "Returns per-opcode script execution counts and cycles (debug builds with SHURIUM_SCRIPT_PROFILE).",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_getscriptprofile(req, ctx, table);
+        },
+        true, false,
+        {"reset"},
+        {"Zero the counters after reading them (default: false)"}
+    });
+    
+    commands_.push_back({
+        "dumptrace",
+        Category::UTILITY,
+        "Returns the recorded hot-path spans as Chrome trace JSON (builds with SHURIUM_TRACING).",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_dumptrace(req, ctx, table);
+        },
+        true, false,
+        {"clear"},
+        {"Drop the spans after reading them (default: false)"}
+    });
+    
     commands_.push_back({
         "logging",
         Category::UTILITY,
@@ -1630,6 +1893,19 @@ void RPCCommandTable::RegisterUtilityCommands() {
         {"Target confirmation blocks"}
     });
     
+    commands_.push_back({
+        "estimatesmartfee",
+        Category::UTILITY,
+        "Estimates the fee per kilobyte needed to confirm within conf_target blocks, "
+        "from how fast recent transactions confirmed.",
+        [table](const RPCRequest& req, const RPCContext& ctx) {
+            return cmd_estimatesmartfee(req, ctx, table);
+        },
+        false, false,
+        {"conf_target"},
+        {"Target confirmation blocks (1-48)"}
+    });
+    
     // ========================================================================
     // Fund Management Commands
     // ========================================================================
@@ -1773,6 +2049,57 @@ static BlockHash HexToBlockHash(const std::string& hex) {
     return hash;
 }
 
+// Helper: Describe a transaction as a JSON object
+static JSONValue::Object TxToJSON(const Transaction& tx) {
+    JSONValue::Object txObj;
+    txObj["txid"] = HashToHex(tx.GetHash());
+    txObj["version"] = static_cast<int64_t>(tx.version);
+    txObj["size"] = static_cast<int64_t>(tx.GetTotalSize());
+    txObj["vsize"] = static_cast<int64_t>(tx.GetTotalSize());  // Simplified - same as size without witness
+    txObj["locktime"] = static_cast<int64_t>(tx.nLockTime);
+    
+    // Inputs
+    JSONValue::Array vinArray;
+    for (const auto& txin : tx.vin) {
+        JSONValue::Object vinObj;
+        if (tx.IsCoinBase()) {
+            vinObj["coinbase"] = FormatHex(txin.scriptSig.data(), txin.scriptSig.size());
+        } else {
+            vinObj["txid"] = HashToHex(Hash256(txin.prevout.hash));
+            vinObj["vout"] = static_cast<int64_t>(txin.prevout.n);
+            vinObj["scriptSig"] = JSONValue::Object();
+        }
+        vinObj["sequence"] = static_cast<int64_t>(txin.nSequence);
+        vinArray.push_back(JSONValue(std::move(vinObj)));
+    }
+    txObj["vin"] = JSONValue(std::move(vinArray));
+    
+    // Outputs
+    JSONValue::Array voutArray;
+    int n = 0;
+    for (const auto& txout : tx.vout) {
+        JSONValue::Object voutObj;
+        voutObj["value"] = FormatAmount(txout.nValue);
+        voutObj["n"] = static_cast<int64_t>(n++);
+        JSONValue::Object scriptObj;
+        scriptObj["hex"] = FormatHex(txout.scriptPubKey.data(), txout.scriptPubKey.size());
+        voutObj["scriptPubKey"] = JSONValue(std::move(scriptObj));
+        voutArray.push_back(JSONValue(std::move(voutObj)));
+    }
+    txObj["vout"] = JSONValue(std::move(voutArray));
+    return txObj;
+}
+
+// Helper: Stream a block's transactions as a "tx" member of full objects,
+// building only one transaction's JSON at a time
+static void WriteTxArray(JSONWriter& out, const std::vector<TransactionRef>& txs) {
+    out.Key("tx").BeginArray();
+    for (const auto& tx : txs) {
+        out.Value(JSONValue(TxToJSON(*tx)));
+    }
+    out.EndArray();
+}
+
 RPCResponse cmd_getblockchaininfo(const RPCRequest& req, const RPCContext& ctx,
                                   RPCCommandTable* table) {
     JSONValue::Object result;
@@ -1807,6 +2134,54 @@ RPCResponse cmd_getblockchaininfo(const RPCRequest& req, const RPCContext& ctx,
         }
     }
     
+    db::BlockDB* blockDB = table->GetBlockDB();
+    if (blockDB) {
+        result["size_on_disk"] = static_cast<int64_t>(blockDB->CalculateCurrentUsage());
+        bool pruned = blockDB->IsPruneMode() || blockDB->HavePruned();
+        result["pruned"] = pruned;
+        if (pruned) {
+            ChainStateManager* chainman = table->GetChainStateManager();
+            result["pruneheight"] = static_cast<int64_t>(chainman ? chainman->GetPruneHeight() : 0);
+            result["automatic_pruning"] = blockDB->IsPruneMode();
+            if (blockDB->IsPruneMode()) {
+                result["prune_target_size"] = static_cast<int64_t>(blockDB->GetPruneTarget());
+            }
+        }
+    }
+    
+    if (ChainStateManager* chainman = table->GetChainStateManager()) {
+        ReorgMetrics metrics = chainman->GetReorgMetrics();
+        JSONValue::Object reorgs;
+        reorgs["count"] = static_cast<int64_t>(metrics.nReorgs);
+        reorgs["failed"] = static_cast<int64_t>(metrics.nFailed);
+        reorgs["total_ms"] = static_cast<double>(metrics.totalMicros) / 1000.0;
+        reorgs["max_ms"] = static_cast<double>(metrics.maxMicros) / 1000.0;
+        if (metrics.nReorgs > 0) {
+            JSONValue::Object last;
+            last["fork_height"] = static_cast<int64_t>(metrics.last.forkHeight);
+            last["disconnected"] = static_cast<int64_t>(metrics.last.nDisconnected);
+            last["connected"] = static_cast<int64_t>(metrics.last.nConnected);
+            last["load_ms"] = static_cast<double>(metrics.last.loadMicros) / 1000.0;
+            last["apply_ms"] = static_cast<double>(metrics.last.applyMicros) / 1000.0;
+            last["flush_ms"] = static_cast<double>(metrics.last.flushMicros) / 1000.0;
+            reorgs["last"] = JSONValue(std::move(last));
+        }
+        result["reorgs"] = JSONValue(std::move(reorgs));
+        
+        CoinsCacheStats cacheStats = chainman->GetActiveChainState().GetCoinsCacheStats();
+        JSONValue::Object coinsCache;
+        coinsCache["limit"] = static_cast<int64_t>(cacheStats.nLimit);
+        coinsCache["configured_limit"] = static_cast<int64_t>(cacheStats.nConfiguredLimit);
+        coinsCache["usage"] = static_cast<int64_t>(cacheStats.nUsage);
+        coinsCache["mempool_usage"] = static_cast<int64_t>(cacheStats.nMempoolUsage);
+        coinsCache["background_flushes"] = static_cast<int64_t>(cacheStats.nBackgroundFlushes);
+        coinsCache["forced_flushes"] = static_cast<int64_t>(cacheStats.nForcedFlushes);
+        coinsCache["idle_flushes"] = static_cast<int64_t>(cacheStats.nIdleFlushes);
+        coinsCache["evicted"] = static_cast<int64_t>(cacheStats.nEvicted);
+        coinsCache["last_decision"] = FlushDecisionName(cacheStats.lastDecision);
+        result["coins_cache"] = JSONValue(std::move(coinsCache));
+    }
+    
     return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
 }
 
@@ -1889,14 +2264,13 @@ RPCResponse cmd_getblock(const RPCRequest& req, const RPCContext& ctx,
                 return RPCError(-1, "Failed to read block from disk: " + status.ToString(), req.GetId());
             }
             
-            // Serialize block to bytes
-            DataStream ss;
-            Serialize(ss, block);
-            
-            // Convert to hex
-            std::string hexBlock = FormatHex(ss.data(), ss.TotalSize());
-            
-            return RPCResponse::Success(JSONValue(hexBlock), req.GetId());
+            // Serialize block to bytes; the hex is encoded straight into the
+            // response stream rather than built up as a string first
+            auto ss = std::make_shared<DataStream>();
+            Serialize(*ss, block);
+            return RPCResponse::Streamed([ss](JSONWriter& out) {
+                out.HexString(ss->data(), ss->TotalSize());
+            }, req.GetId());
         }
         
         // Build block info from BlockIndex
@@ -1942,70 +2316,31 @@ RPCResponse cmd_getblock(const RPCRequest& req, const RPCContext& ctx,
         }
         
         result["height"] = static_cast<int64_t>(pindex->nHeight);
-        result["version"] = static_cast<int64_t>(pindex->nVersion);
+        result["version"] = static_cast<int64_t>(pindex->GetVersion());
         result["versionHex"] = ([&]() {
             std::ostringstream oss;
-            oss << std::hex << std::setfill('0') << std::setw(8) << pindex->nVersion;
+            oss << std::hex << std::setfill('0') << std::setw(8) << pindex->GetVersion();
             return oss.str();
         })();
-        result["merkleroot"] = HashToHex(pindex->hashMerkleRoot);
-        
-        // Transactions
-        JSONValue::Array txArray;
-        if (haveFullBlock) {
-            for (const auto& tx : block.vtx) {
-                if (verbosity == 1) {
-                    // Just txids
+        result["merkleroot"] = HashToHex(pindex->GetMerkleRoot());
+        
+        // Transactions; full objects (verbosity 2) are streamed at serialization
+        bool streamTxs = haveFullBlock && verbosity >= 2;
+        if (!streamTxs) {
+            JSONValue::Array txArray;
+            if (haveFullBlock) {
+                txArray.reserve(block.vtx.size());
+                for (const auto& tx : block.vtx) {
                     txArray.push_back(JSONValue(HashToHex(tx->GetHash())));
-                } else {
-                    // Verbosity 2: full transaction objects
-                    JSONValue::Object txObj;
-                    txObj["txid"] = HashToHex(tx->GetHash());
-                    txObj["version"] = static_cast<int64_t>(tx->version);
-                    txObj["size"] = static_cast<int64_t>(tx->GetTotalSize());
-                    txObj["vsize"] = static_cast<int64_t>(tx->GetTotalSize());  // Simplified - same as size without witness
-                    txObj["locktime"] = static_cast<int64_t>(tx->nLockTime);
-                    
-                    // Inputs
-                    JSONValue::Array vinArray;
-                    for (const auto& txin : tx->vin) {
-                        JSONValue::Object vinObj;
-                        if (tx->IsCoinBase()) {
-                            vinObj["coinbase"] = FormatHex(txin.scriptSig.data(), txin.scriptSig.size());
-                        } else {
-                            vinObj["txid"] = HashToHex(Hash256(txin.prevout.hash));
-                            vinObj["vout"] = static_cast<int64_t>(txin.prevout.n);
-                            vinObj["scriptSig"] = JSONValue::Object();
-                        }
-                        vinObj["sequence"] = static_cast<int64_t>(txin.nSequence);
-                        vinArray.push_back(JSONValue(std::move(vinObj)));
-                    }
-                    txObj["vin"] = JSONValue(std::move(vinArray));
-                    
-                    // Outputs
-                    JSONValue::Array voutArray;
-                    int n = 0;
-                    for (const auto& txout : tx->vout) {
-                        JSONValue::Object voutObj;
-                        voutObj["value"] = FormatAmount(txout.nValue);
-                        voutObj["n"] = static_cast<int64_t>(n++);
-                        JSONValue::Object scriptObj;
-                        scriptObj["hex"] = FormatHex(txout.scriptPubKey.data(), txout.scriptPubKey.size());
-                        voutObj["scriptPubKey"] = JSONValue(std::move(scriptObj));
-                        voutArray.push_back(JSONValue(std::move(voutObj)));
-                    }
-                    txObj["vout"] = JSONValue(std::move(voutArray));
-                    
-                    txArray.push_back(JSONValue(std::move(txObj)));
                 }
             }
+            result["tx"] = JSONValue(std::move(txArray));
         }
-        result["tx"] = JSONValue(std::move(txArray));
         result["nTx"] = static_cast<int64_t>(haveFullBlock ? block.vtx.size() : pindex->nTx);
         
         result["time"] = static_cast<int64_t>(pindex->nTime);
         result["mediantime"] = pindex->GetMedianTimePast();
-        result["nonce"] = static_cast<int64_t>(pindex->nNonce);
+        result["nonce"] = static_cast<int64_t>(pindex->GetNonce());
         result["bits"] = ([&]() {
             std::ostringstream oss;
             oss << std::hex << pindex->nBits;
@@ -2025,6 +2360,27 @@ RPCResponse cmd_getblock(const RPCRequest& req, const RPCContext& ctx,
             result["nextblockhash"] = BlockHashToHex(pnext->GetBlockHash());
         }
         
+        if (streamTxs) {
+            auto fields = std::make_shared<const JSONValue::Object>(std::move(result));
+            auto txs = std::make_shared<const std::vector<TransactionRef>>(std::move(block.vtx));
+            return RPCResponse::Streamed([fields, txs](JSONWriter& out) {
+                // Members in sorted order, as the map-built object had them
+                out.BeginObject();
+                bool txWritten = false;
+                for (const auto& [key, value] : *fields) {
+                    if (!txWritten && key > "tx") {
+                        WriteTxArray(out, *txs);
+                        txWritten = true;
+                    }
+                    out.Member(key, value);
+                }
+                if (!txWritten) {
+                    WriteTxArray(out, *txs);
+                }
+                out.EndObject();
+            }, req.GetId());
+        }
+        
         return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
     } catch (const std::exception& e) {
         return InvalidParams(e.what(), req.GetId());
@@ -2110,16 +2466,16 @@ RPCResponse cmd_getblockheader(const RPCRequest& req, const RPCContext& ctx,
         result["confirmations"] = static_cast<int64_t>(confirmations);
         
         result["height"] = static_cast<int64_t>(pindex->nHeight);
-        result["version"] = static_cast<int64_t>(pindex->nVersion);
+        result["version"] = static_cast<int64_t>(pindex->GetVersion());
         result["versionHex"] = ([&]() {
             std::ostringstream oss;
-            oss << std::hex << std::setfill('0') << std::setw(8) << pindex->nVersion;
+            oss << std::hex << std::setfill('0') << std::setw(8) << pindex->GetVersion();
             return oss.str();
         })();
-        result["merkleroot"] = HashToHex(pindex->hashMerkleRoot);
+        result["merkleroot"] = HashToHex(pindex->GetMerkleRoot());
         result["time"] = static_cast<int64_t>(pindex->nTime);
         result["mediantime"] = pindex->GetMedianTimePast();
-        result["nonce"] = static_cast<int64_t>(pindex->nNonce);
+        result["nonce"] = static_cast<int64_t>(pindex->GetNonce());
         result["bits"] = ([&]() {
             std::ostringstream oss;
             oss << std::hex << pindex->nBits;
@@ -2205,7 +2561,7 @@ RPCResponse cmd_getmempoolinfo(const RPCRequest& req, const RPCContext& ctx,
     if (mempool) {
         result["size"] = static_cast<int64_t>(mempool->Size());
         result["bytes"] = static_cast<int64_t>(mempool->GetTotalSize());
-        result["usage"] = static_cast<int64_t>(mempool->GetTotalSize());  // Simplified
+        result["usage"] = static_cast<int64_t>(mempool->DynamicMemoryUsage());
         
         MempoolLimits limits = mempool->GetLimits();
         result["maxmempool"] = static_cast<int64_t>(limits.maxSize);
@@ -2221,32 +2577,34 @@ RPCResponse cmd_getrawmempool(const RPCRequest& req, const RPCContext& ctx,
     Mempool* mempool = table->GetMempool();
     
     if (verbose) {
-        JSONValue::Object result;
-        
+        // Streamed from the snapshot, one entry at a time, in snapshot order
+        std::shared_ptr<const MempoolSnapshot> snapshot;
         if (mempool) {
-            std::vector<TxMempoolInfo> txinfos = mempool->GetAllTxInfo();
-            for (const auto& info : txinfos) {
-                JSONValue::Object entry;
-                entry["size"] = static_cast<int64_t>(info.vsize);
-                entry["vsize"] = static_cast<int64_t>(info.vsize);
-                entry["fee"] = FormatAmount(info.fee);
-                entry["time"] = info.time;
-                
-                // Convert TxHash to hex
-                std::string txidHex = HashToHex(info.tx->GetHash());
-                result[txidHex] = JSONValue(std::move(entry));
+            snapshot = mempool->GetSnapshot();
+        }
+        
+        return RPCResponse::Streamed([snapshot](JSONWriter& out) {
+            out.BeginObject();
+            if (snapshot) {
+                for (const auto& info : snapshot->txs) {
+                    out.Key(HashToHex(info.tx->GetHash())).BeginObject();
+                    out.Member("fee", FormatAmount(info.fee));
+                    out.Member("size", static_cast<int64_t>(info.vsize));
+                    out.Member("time", info.time);
+                    out.Member("vsize", static_cast<int64_t>(info.vsize));
+                    out.EndObject();
+                }
             }
-        }
-        
-        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+            out.EndObject();
+        }, req.GetId());
     }
     
     // Non-verbose: return array of txids
     JSONValue::Array txids;
     
     if (mempool) {
-        std::vector<TxMempoolInfo> txinfos = mempool->GetAllTxInfo();
-        for (const auto& info : txinfos) {
+        auto snapshot = mempool->GetSnapshot();
+        for (const auto& info : snapshot->txs) {
             txids.push_back(JSONValue(HashToHex(info.tx->GetHash())));
         }
     }
@@ -2282,13 +2640,84 @@ RPCResponse cmd_getrawtransaction(const RPCRequest& req, const RPCContext& ctx,
     try {
         std::string txid = GetRequiredParam<std::string>(req, size_t(0));
         bool verbose = GetOptionalParam<bool>(req, size_t(1), false);
+        std::string blockhash = GetOptionalParam<std::string>(req, size_t(2), std::string());
         
-        if (!verbose) {
-            // Return hex-encoded transaction
-            return RPCResponse::Success(JSONValue(""), req.GetId());
+        TxHash hash(HexToBlockHash(txid));
+        if (hash.IsNull()) {
+            return InvalidParams("txid must be a 64-character hex string", req.GetId());
         }
         
-        return cmd_gettransaction(req, ctx, table);
+        TransactionRef tx;
+        BlockHash hashBlock;
+        TxIndexer* txIndexer = table->GetTxIndexer();
+        
+        if (!blockhash.empty()) {
+            // Look in the given block only
+            ChainStateManager* chainman = table->GetChainStateManager();
+            db::BlockDB* blockdb = table->GetBlockDB();
+            const BlockIndex* pindex = chainman ? chainman->LookupBlockIndex(HexToBlockHash(blockhash))
+                                                : nullptr;
+            if (!pindex) {
+                return RPCError(-5, "Block hash not found", req.GetId());
+            }
+            if (!pindex->HaveData() || !blockdb) {
+                return RPCError(-1, "Block data not available (pruned or not downloaded)", req.GetId());
+            }
+            Block block;
+            if (blockdb->ReadBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), block).ok()) {
+                for (const auto& blockTx : block.vtx) {
+                    if (blockTx->GetHash() == hash) {
+                        tx = blockTx;
+                        hashBlock = block.GetHash();
+                        break;
+                    }
+                }
+            }
+            if (!tx) {
+                return RPCError(-5, "No such transaction found in the provided block", req.GetId());
+            }
+        } else {
+            Mempool* mempool = table->GetMempool();
+            if (mempool) {
+                tx = mempool->Get(hash);
+            }
+            if (!tx && !(txIndexer && txIndexer->FindTx(hash, tx, hashBlock))) {
+                // Say why a confirmed transaction may not be found yet
+                std::string msg = "No such mempool or blockchain transaction";
+                if (!txIndexer) {
+                    msg = "No such mempool transaction. Use -txindex or provide a block hash "
+                          "to enable blockchain transaction queries";
+                } else if (!txIndexer->IsSynced()) {
+                    msg = "No such mempool transaction. Blockchain transactions are still in "
+                          "the process of being indexed";
+                }
+                return RPCError(-5, msg, req.GetId());
+            }
+        }
+        
+        DataStream ss;
+        Serialize(ss, *tx);
+        std::string hex = FormatHex(ss.data(), ss.size());
+        if (!verbose) {
+            return RPCResponse::Success(JSONValue(hex), req.GetId());
+        }
+        
+        JSONValue::Object result = TxToJSON(*tx);
+        result["hex"] = hex;
+        if (!hashBlock.IsNull()) {
+            result["blockhash"] = BlockHashToHex(hashBlock);
+            ChainStateManager* chainman = table->GetChainStateManager();
+            const BlockIndex* pindex = chainman ? chainman->LookupBlockIndex(hashBlock) : nullptr;
+            if (pindex && chainman->GetActiveChainState().IsInActiveChain(pindex)) {
+                result["confirmations"] =
+                    static_cast<int64_t>(chainman->GetActiveHeight() - pindex->nHeight + 1);
+                result["time"] = static_cast<int64_t>(pindex->nTime);
+                result["blocktime"] = static_cast<int64_t>(pindex->nTime);
+            } else {
+                result["confirmations"] = int64_t(0);
+            }
+        }
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
     } catch (const std::exception& e) {
         return InvalidParams(e.what(), req.GetId());
     }
@@ -2370,6 +2799,330 @@ RPCResponse cmd_sendrawtransaction(const RPCRequest& req, const RPCContext& ctx,
     }
 }
 
+// Helper: Resolve a snapshot path against the data directory
+static std::filesystem::path ResolveDataDirPath(const std::string& arg,
+                                                 RPCCommandTable* table) {
+    std::filesystem::path path(arg);
+    if (path.is_relative() && !table->GetDataDir().empty()) {
+        path = std::filesystem::path(table->GetDataDir()) / path;
+    }
+    return path;
+}
+
+RPCResponse cmd_savemempool(const RPCRequest& req, const RPCContext& ctx,
+                            RPCCommandTable* table) {
+    try {
+        std::string pathArg = GetOptionalParam<std::string>(req, size_t(0), MEMPOOL_DUMP_FILENAME);
+        
+        Mempool* mempool = table->GetMempool();
+        if (!mempool) {
+            return RPCError(-1, "Mempool not available", req.GetId());
+        }
+        
+        std::filesystem::path path = ResolveDataDirPath(pathArg, table);
+        MempoolPersistResult dump = DumpMempool(*mempool, path);
+        if (!dump.success) {
+            return RPCError(-1, dump.error, req.GetId());
+        }
+        
+        JSONValue::Object result;
+        result["filename"] = path.string();
+        result["transactions"] = static_cast<int64_t>(dump.count);
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+    } catch (const std::exception& e) {
+        return InvalidParams(e.what(), req.GetId());
+    }
+}
+
+RPCResponse cmd_loadmempool(const RPCRequest& req, const RPCContext& ctx,
+                            RPCCommandTable* table) {
+    try {
+        std::string pathArg = GetOptionalParam<std::string>(req, size_t(0), MEMPOOL_DUMP_FILENAME);
+        
+        Mempool* mempool = table->GetMempool();
+        ChainState* chainState = table->GetChainState();
+        ChainStateManager* chainManager = table->GetChainStateManager();
+        if (!mempool || !chainState) {
+            return RPCError(-1, "Mempool not available", req.GetId());
+        }
+        
+        std::filesystem::path path = ResolveDataDirPath(pathArg, table);
+        MempoolPersistResult load = LoadMempool(
+            path, *mempool, chainState->GetCoins(), chainState->GetHeight(),
+            chainManager ? chainManager->GetScriptCheckQueue() : nullptr);
+        if (!load.success) {
+            return RPCError(-1, load.error, req.GetId());
+        }
+        
+        JSONValue::Object result;
+        result["filename"] = path.string();
+        result["read"] = static_cast<int64_t>(load.count);
+        result["accepted"] = static_cast<int64_t>(load.accepted);
+        result["already_present"] = static_cast<int64_t>(load.alreadyPresent);
+        result["expired"] = static_cast<int64_t>(load.expired);
+        result["failed"] = static_cast<int64_t>(load.failed);
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+    } catch (const std::exception& e) {
+        return InvalidParams(e.what(), req.GetId());
+    }
+}
+
+RPCResponse cmd_dumptxoutset(const RPCRequest& req, const RPCContext& ctx,
+                             RPCCommandTable* table) {
+    try {
+        std::string pathArg = GetRequiredParam<std::string>(req, size_t(0));
+        
+        ChainState* chainState = table->GetChainState();
+        ChainStateManager* chainManager = table->GetChainStateManager();
+        if (!chainState || !chainManager) {
+            return RPCError(-1, "Chain state not available", req.GetId());
+        }
+        
+        auto* coinsDB = dynamic_cast<db::CoinsViewDB*>(chainState->GetCoinsDB());
+        if (!coinsDB) {
+            return RPCError(-1, "UTXO database not available", req.GetId());
+        }
+        
+        // The snapshot is taken from the database, so write the cache out first
+        if (!chainState->FlushStateToDisk()) {
+            return RPCError(-1, "Failed to flush the UTXO cache", req.GetId());
+        }
+        
+        // Dump a fixed view; validation carries on while the file is written
+        auto dbSnapshot = coinsDB->NewSnapshot();
+        if (!dbSnapshot) {
+            return RPCError(-1, "UTXO database cannot take a snapshot", req.GetId());
+        }
+        const BlockIndex* base = chainManager->LookupBlockIndex(coinsDB->GetBestBlock(*dbSnapshot));
+        if (!base) {
+            return RPCError(-1, "UTXO database best block is not in the block index", req.GetId());
+        }
+        
+        std::filesystem::path path = ResolveDataDirPath(pathArg, table);
+        UTXOSnapshotResult dump = DumpUTXOSnapshot(*coinsDB, *dbSnapshot, base->nHeight,
+                                                   chainManager->GetParams().strNetworkID, path);
+        if (!dump.success) {
+            return RPCError(-1, dump.error, req.GetId());
+        }
+        
+        JSONValue::Object result;
+        result["coins_written"] = static_cast<int64_t>(dump.metadata.nCoins);
+        result["base_hash"] = BlockHashToHex(dump.metadata.baseBlockHash);
+        result["base_height"] = static_cast<int64_t>(dump.metadata.baseHeight);
+        result["path"] = path.string();
+        result["txoutset_hash"] = HashToHex(dump.metadata.utxoSetHash);
+        result["nchunks"] = static_cast<int64_t>(dump.nChunks);
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+    } catch (const std::exception& e) {
+        return InvalidParams(e.what(), req.GetId());
+    }
+}
+
+RPCResponse cmd_loadtxoutset(const RPCRequest& req, const RPCContext& ctx,
+                             RPCCommandTable* table) {
+    try {
+        std::string pathArg = GetRequiredParam<std::string>(req, size_t(0));
+        
+        ChainState* chainState = table->GetChainState();
+        ChainStateManager* chainManager = table->GetChainStateManager();
+        if (!chainState || !chainManager) {
+            return RPCError(-1, "Chain state not available", req.GetId());
+        }
+        
+        auto* coinsDB = dynamic_cast<db::CoinsViewDB*>(chainState->GetCoinsDB());
+        if (!coinsDB) {
+            return RPCError(-1, "UTXO database not available", req.GetId());
+        }
+        
+        if (chainState->GetHeight() > 0) {
+            return RPCError(-1, "A snapshot can only be loaded before any blocks are connected",
+                            req.GetId());
+        }
+        
+        std::filesystem::path path = ResolveDataDirPath(pathArg, table);
+        UTXOSnapshotResult header = ReadUTXOSnapshotHeader(path);
+        if (!header.success) {
+            return RPCError(-8, header.error, req.GetId());
+        }
+        
+        // The tip has to move to the base block, so its header must be known
+        BlockIndex* base = chainManager->LookupBlockIndex(header.metadata.baseBlockHash);
+        if (!base) {
+            return RPCError(-1, "Snapshot base block header " +
+                            BlockHashToHex(header.metadata.baseBlockHash) +
+                            " is not known; sync headers first", req.GetId());
+        }
+        
+        chainState->FlushStateToDisk();
+        UTXOSnapshotResult load = LoadUTXOSnapshot(path, chainManager->GetParams(), *coinsDB);
+        if (!load.success) {
+            return RPCError(-1, load.error, req.GetId());
+        }
+        
+        if (!chainState->ActivateSnapshotBase(base)) {
+            return RPCError(-1, "Failed to activate the snapshot base block", req.GetId());
+        }
+        
+        JSONValue::Object result;
+        result["coins_loaded"] = static_cast<int64_t>(load.metadata.nCoins);
+        result["tip_hash"] = BlockHashToHex(load.metadata.baseBlockHash);
+        result["base_height"] = static_cast<int64_t>(load.metadata.baseHeight);
+        result["path"] = path.string();
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+    } catch (const std::exception& e) {
+        return InvalidParams(e.what(), req.GetId());
+    }
+}
+
+RPCResponse cmd_gettxoutsetinfo(const RPCRequest& req, const RPCContext& ctx,
+                                RPCCommandTable* table) {
+    ChainState* chainState = table->GetChainState();
+    if (!chainState) {
+        return RPCError(-1, "Chain state not available", req.GetId());
+    }
+    
+    // Scan a snapshot of the flushed database, so blocks keep connecting
+    // while the set is counted and everything reported is from one block
+    auto* coinsDB = dynamic_cast<db::CoinsViewDB*>(chainState->GetCoinsDB());
+    ChainStateManager* chainManager = table->GetChainStateManager();
+    if (coinsDB && chainManager && chainState->FlushStateToDisk()) {
+        auto dbSnapshot = coinsDB->NewSnapshot();
+        MuHash3072 hashState;
+        if (dbSnapshot && coinsDB->GetUTXOHashState(hashState, *dbSnapshot)) {
+            UTXOStats stats = db::GetUTXOStats(*coinsDB, dbSnapshot.get());
+            const BlockIndex* base = chainManager->LookupBlockIndex(stats.hashBlock);
+            Hash256 muhash = hashState.Finalize();
+            
+            JSONValue::Object result;
+            result["height"] = static_cast<int64_t>(base ? base->nHeight : -1);
+            result["bestblock"] = BlockHashToHex(stats.hashBlock);
+            result["txouts"] = static_cast<int64_t>(stats.nTransactionOutputs);
+            result["transactions"] = static_cast<int64_t>(stats.nTransactions);
+            result["bogosize"] = static_cast<int64_t>(stats.nBogoSize);
+            result["total_amount"] = FormatAmount(stats.nTotalAmount);
+            result["disk_size"] = static_cast<int64_t>(stats.nDiskSize);
+            result["muhash"] = HashToHex(muhash);
+            return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+        }
+    }
+    
+    Hash256 muhash = chainState->GetRollingUTXOSetHash();
+    if (muhash.IsNull()) {
+        return RPCError(-1, "UTXO set hash not available", req.GetId());
+    }
+    
+    JSONValue::Object result;
+    result["height"] = static_cast<int64_t>(chainState->GetHeight());
+    BlockIndex* tip = chainState->GetTip();
+    result["bestblock"] = tip ? BlockHashToHex(tip->GetBlockHash()) : std::string();
+    result["muhash"] = HashToHex(muhash);
+    return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+}
+
+RPCResponse cmd_getindexinfo(const RPCRequest& req, const RPCContext& ctx,
+                             RPCCommandTable* table) {
+    JSONValue::Object result;
+    
+    TxIndexer* txIndexer = table->GetTxIndexer();
+    if (txIndexer) {
+        JSONValue::Object info;
+        info["synced"] = txIndexer->IsSynced();
+        info["best_block_height"] = static_cast<int64_t>(txIndexer->GetBestHeight());
+        if (txIndexer->HasFailed()) {
+            info["error"] = "Indexing stopped; see the log";
+        }
+        result["txindex"] = JSONValue(std::move(info));
+    }
+    
+    BlockFilterIndexer* filterIndexer = table->GetBlockFilterIndexer();
+    if (filterIndexer) {
+        JSONValue::Object info;
+        info["synced"] = filterIndexer->IsSynced();
+        info["best_block_height"] = static_cast<int64_t>(filterIndexer->GetBestHeight());
+        if (filterIndexer->HasFailed()) {
+            info["error"] = "Indexing stopped; see the log";
+        }
+        result["basic block filter index"] = JSONValue(std::move(info));
+    }
+    
+    return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+}
+
+static JSONValue LatencyToJSON(const db::LatencyHistogram::Snapshot& latency) {
+    JSONValue::Object result;
+    result["count"] = static_cast<int64_t>(latency.count);
+    result["mean"] = latency.MeanMicros();
+    result["p50"] = static_cast<int64_t>(latency.PercentileMicros(0.50));
+    result["p99"] = static_cast<int64_t>(latency.PercentileMicros(0.99));
+    result["max"] = static_cast<int64_t>(latency.maxMicros);
+    
+    // Bucket i counts operations under 2^i microseconds; trailing empties dropped
+    size_t used = latency.buckets.size();
+    while (used > 0 && latency.buckets[used - 1] == 0) {
+        --used;
+    }
+    JSONValue::Array buckets;
+    for (size_t i = 0; i < used; ++i) {
+        buckets.push_back(static_cast<int64_t>(latency.buckets[i]));
+    }
+    result["histogram"] = JSONValue(std::move(buckets));
+    return JSONValue(std::move(result));
+}
+
+static JSONValue DatabaseStatsToJSON(const db::DatabaseStats& stats, uint64_t diskUsage) {
+    JSONValue::Object result;
+    result["gets"] = static_cast<int64_t>(stats.gets);
+    result["get_hit_rate"] = stats.GetHitRate();
+    result["puts"] = static_cast<int64_t>(stats.puts);
+    result["deletes"] = static_cast<int64_t>(stats.deletes);
+    result["batches"] = static_cast<int64_t>(stats.batches);
+    result["bytes_read"] = static_cast<int64_t>(stats.bytesRead);
+    result["bytes_written"] = static_cast<int64_t>(stats.bytesWritten);
+    result["write_stalls"] = static_cast<int64_t>(stats.writeStalls);
+    result["get_latency_us"] = LatencyToJSON(stats.getLatency);
+    result["write_latency_us"] = LatencyToJSON(stats.writeLatency);
+    
+    JSONValue::Object compaction;
+    compaction["seconds"] = stats.compactionSeconds;
+    compaction["bytes_read"] = static_cast<int64_t>(stats.compactionBytesRead);
+    compaction["bytes_written"] = static_cast<int64_t>(stats.compactionBytesWritten);
+    result["compaction"] = JSONValue(std::move(compaction));
+    
+    result["memory_usage"] = static_cast<int64_t>(stats.memoryUsage);
+    result["block_cache_usage"] = static_cast<int64_t>(stats.blockCacheUsage);
+    result["block_cache_capacity"] = static_cast<int64_t>(stats.blockCacheCapacity);
+    result["disk_usage"] = static_cast<int64_t>(diskUsage);
+    return JSONValue(std::move(result));
+}
+
+RPCResponse cmd_getdbstats(const RPCRequest& req, const RPCContext& ctx,
+                           RPCCommandTable* table) {
+    JSONValue::Object result;
+    
+    if (db::BlockDB* blockdb = table->GetBlockDB()) {
+        result["blockindex"] = DatabaseStatsToJSON(blockdb->GetDatabaseStats(), 0);
+    }
+    if (db::CoinsViewDB* coinsdb = table->GetCoinsDB()) {
+        JSONValue coins = DatabaseStatsToJSON(coinsdb->GetDatabaseStats(),
+                                              coinsdb->GetDiskUsage());
+        if (const db::CoinFilter* filter = coinsdb->GetCoinFilter()) {
+            JSONValue::Object info;
+            info["memory_usage"] = static_cast<int64_t>(filter->GetMemoryUsage());
+            info["inserts"] = static_cast<int64_t>(filter->GetInsertCount());
+            info["filtered"] = static_cast<int64_t>(filter->GetFilteredCount());
+            info["false_positives"] = static_cast<int64_t>(filter->GetFalsePositiveCount());
+            info["false_positive_rate"] = filter->GetObservedFalsePositiveRate();
+            info["estimated_false_positive_rate"] = filter->EstimateFalsePositiveRate();
+            coins["coin_filter"] = JSONValue(std::move(info));
+        }
+        result["coins"] = std::move(coins);
+    }
+    if (db::TxIndex* txindex = table->GetTxIndex()) {
+        result["txindex"] = DatabaseStatsToJSON(txindex->GetDatabaseStats(), 0);
+    }
+    
+    return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+}
 
 // ============================================================================
 // Network Command Implementations
@@ -2382,8 +3135,25 @@ RPCResponse cmd_getnetworkinfo(const RPCRequest& req, const RPCContext& ctx,
     result["version"] = int64_t(1000000);
     result["subversion"] = "/SHURIUM:1.0.0/";
     result["protocolversion"] = int64_t(70015);
-    result["localservices"] = "0000000000000001";
-    result["localservicesnames"] = JSONValue::Array{JSONValue("NETWORK")};
+    ServiceFlags services = ServiceFlags::NETWORK;
+    if (table && table->GetMessageProcessor()) {
+        services = table->GetMessageProcessor()->GetLocalServices();
+    }
+    std::ostringstream servicesHex;
+    servicesHex << std::hex << std::setw(16) << std::setfill('0')
+                << static_cast<uint64_t>(services);
+    JSONValue::Array serviceNames;
+    if (HasFlag(services, ServiceFlags::NETWORK)) {
+        serviceNames.push_back(JSONValue("NETWORK"));
+    }
+    if (HasFlag(services, ServiceFlags::NETWORK_LIMITED)) {
+        serviceNames.push_back(JSONValue("NETWORK_LIMITED"));
+    }
+    if (HasFlag(services, ServiceFlags::TX_RECONCILIATION)) {
+        serviceNames.push_back(JSONValue("TX_RECONCILIATION"));
+    }
+    result["localservices"] = servicesHex.str();
+    result["localservicesnames"] = std::move(serviceNames);
     result["localrelay"] = true;
     result["timeoffset"] = int64_t(0);
     result["networkactive"] = true;
@@ -2412,6 +3182,9 @@ RPCResponse cmd_getpeerinfo(const RPCRequest& req, const RPCContext& ctx,
                             RPCCommandTable* table) {
     JSONValue::Array peers;
     
+    MessageProcessor* msgproc = table->GetMessageProcessor();
+    BlockSynchronizer* sync = msgproc ? msgproc->GetBlockSynchronizer() : nullptr;
+    
     network::NetworkManager* netman = table->GetNetworkManager();
     if (netman) {
         auto peerList = netman->GetPeers();
@@ -2427,10 +3200,15 @@ RPCResponse cmd_getpeerinfo(const RPCRequest& req, const RPCContext& ctx,
             peerObj["services"] = std::to_string(static_cast<uint64_t>(stats.services));
             peerObj["servicesnames"] = JSONValue::Array(); // Service flags to names
             peerObj["relaytxes"] = stats.fRelayTxes;
+            peerObj["txreconciliation"] =
+                msgproc && msgproc->GetTxReconciliation().IsPeerRegistered(peer->GetId());
             peerObj["lastsend"] = stats.lastSendTime;
             peerObj["lastrecv"] = stats.lastRecvTime;
             peerObj["bytessent"] = static_cast<int64_t>(stats.bytesSent);
             peerObj["bytesrecv"] = static_cast<int64_t>(stats.bytesRecv);
+            peerObj["compression"] = stats.fCompressing;
+            peerObj["compressionsavedsent"] = static_cast<int64_t>(stats.compressionSavedSent);
+            peerObj["compressionsavedrecv"] = static_cast<int64_t>(stats.compressionSavedRecv);
             peerObj["conntime"] = stats.connectedTime;
             peerObj["timeoffset"] = int64_t(0); // Would need to track time offset
             peerObj["pingtime"] = static_cast<double>(stats.pingLatencyMicros) / 1000000.0;
@@ -2443,6 +3221,17 @@ RPCResponse cmd_getpeerinfo(const RPCRequest& req, const RPCContext& ctx,
             peerObj["synced_headers"] = int64_t(-1); // Would need sync tracking
             peerObj["synced_blocks"] = int64_t(-1);
             
+            // Block download figures from the synchronizer
+            if (auto download = sync ? sync->GetPeerDownloadStats(peer->GetId()) : std::nullopt) {
+                peerObj["blocks_in_flight"] = static_cast<int64_t>(download->blocksInFlight);
+                peerObj["inflight_limit"] = static_cast<int64_t>(download->inFlightLimit);
+                peerObj["blocks_downloaded"] = static_cast<int64_t>(download->blocksDownloaded);
+                peerObj["bytes_downloaded"] = static_cast<int64_t>(download->bytesDownloaded);
+                peerObj["download_rate"] = download->bytesPerSec;
+                peerObj["download_rtt"] = download->rttMs / 1000.0;
+                peerObj["download_stalls"] = static_cast<int64_t>(download->stalls);
+            }
+            
             // Connection type
             std::string connType;
             switch (peer->GetConnectionType()) {
@@ -2647,12 +3436,12 @@ RPCResponse cmd_getwalletinfo(const RPCRequest& req, const RPCContext& ctx,
     result["immature_balance"] = FormatAmount(balance.immature);
     
     // Get transaction count
-    result["txcount"] = static_cast<int64_t>(wallet->GetTransactions().size());
+    result["txcount"] = static_cast<int64_t>(wallet->GetSnapshot()->transactions.size());
     
-    // Keypool info (simplified for HD wallet)
+    // Keypool info
     result["keypoololdest"] = GetTime();
-    result["keypoolsize"] = int64_t(1000);  // HD wallets have effectively unlimited keys
-    result["keypoolsize_hd_internal"] = int64_t(1000);
+    result["keypoolsize"] = static_cast<int64_t>(wallet->GetKeyPoolAvailable(false));
+    result["keypoolsize_hd_internal"] = static_cast<int64_t>(wallet->GetKeyPoolAvailable(true));
     
     // Lock status
     result["unlocked_until"] = wallet->IsLocked() ? int64_t(0) : int64_t(0x7FFFFFFF);
@@ -2661,7 +3450,17 @@ RPCResponse cmd_getwalletinfo(const RPCRequest& req, const RPCContext& ctx,
     result["paytxfee"] = static_cast<double>(wallet->GetConfig().defaultFeeRate) / COIN;
     result["private_keys_enabled"] = true;
     result["avoid_reuse"] = false;
-    result["scanning"] = false;
+    
+    wallet::RescanProgress rescan = wallet->GetRescanProgress();
+    if (rescan.scanning) {
+        JSONValue::Object scanning;
+        scanning["progress"] = rescan.GetFraction();
+        scanning["current_height"] = static_cast<int64_t>(rescan.currentHeight);
+        scanning["stop_height"] = static_cast<int64_t>(rescan.stopHeight);
+        result["scanning"] = JSONValue(std::move(scanning));
+    } else {
+        result["scanning"] = false;
+    }
     
     return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
 }
@@ -2814,13 +3613,10 @@ RPCResponse cmd_getaddressinfo(const RPCRequest& req, const RPCContext& ctx,
                             
                             // HD derivation info
                             if (isMine) {
-                                auto hdManager = wallet->GetHDKeyManager();
-                                if (hdManager) {
-                                    auto keyInfo = hdManager->FindKeyByHash(keyHash);
-                                    if (keyInfo) {
-                                        result["hdkeypath"] = keyInfo->path.ToString();
-                                        result["hdseedid"] = FormatHex(keyInfo->keyHash.data(), 20);
-                                    }
+                                auto keyInfo = wallet->FindHDKey(keyHash);
+                                if (keyInfo) {
+                                    result["hdkeypath"] = keyInfo->path.ToString();
+                                    result["hdseedid"] = FormatHex(keyInfo->keyHash.data(), 20);
                                 }
                             }
                             break;
@@ -2876,13 +3672,10 @@ RPCResponse cmd_getaddressinfo(const RPCRequest& req, const RPCContext& ctx,
                             
                             // HD derivation info
                             if (isMine) {
-                                auto hdManager = wallet->GetHDKeyManager();
-                                if (hdManager) {
-                                    auto keyInfo = hdManager->FindKeyByHash(keyHash);
-                                    if (keyInfo) {
-                                        result["hdkeypath"] = keyInfo->path.ToString();
-                                        result["hdseedid"] = FormatHex(keyInfo->keyHash.data(), 20);
-                                    }
+                                auto keyInfo = wallet->FindHDKey(keyHash);
+                                if (keyInfo) {
+                                    result["hdkeypath"] = keyInfo->path.ToString();
+                                    result["hdseedid"] = FormatHex(keyInfo->keyHash.data(), 20);
                                 }
                             }
                         }
@@ -2933,13 +3726,10 @@ RPCResponse cmd_getaddressinfo(const RPCRequest& req, const RPCContext& ctx,
                         }
                         
                         if (isMine) {
-                            auto hdManager = wallet->GetHDKeyManager();
-                            if (hdManager) {
-                                auto keyInfo = hdManager->FindKeyByHash(keyHash);
-                                if (keyInfo) {
-                                    result["hdkeypath"] = keyInfo->path.ToString();
-                                    result["hdseedid"] = FormatHex(keyInfo->keyHash.data(), 20);
-                                }
+                            auto keyInfo = wallet->FindHDKey(keyHash);
+                            if (keyInfo) {
+                                result["hdkeypath"] = keyInfo->path.ToString();
+                                result["hdseedid"] = FormatHex(keyInfo->keyHash.data(), 20);
                             }
                         }
                     }
@@ -2997,6 +3787,21 @@ RPCResponse cmd_listaddresses(const RPCRequest& req, const RPCContext& ctx,
     return RPCResponse::Success(JSONValue(std::move(addresses)), req.GetId());
 }
 
+/// Confirmation target of the feerate wallet sends pay
+static constexpr unsigned int WALLET_CONFIRM_TARGET = 6;
+
+/// Wallet feerate (per byte) for a send: the fee estimate once there is one,
+/// else the wallet's usual 1000
+static wallet::FeeRate WalletSendFeeRate(RPCCommandTable* table) {
+    if (FeeEstimator* estimator = table->GetFeeEstimator()) {
+        FeeEstimate estimate = estimator->EstimateSmartFee(WALLET_CONFIRM_TARGET);
+        if (estimate.IsValid()) {
+            return std::max<wallet::FeeRate>(1, (estimate.feeRate.GetFeePerK() + 999) / 1000);
+        }
+    }
+    return 1000;
+}
+
 RPCResponse cmd_sendtoaddress(const RPCRequest& req, const RPCContext& ctx,
                               RPCCommandTable* table) {
     wallet::Wallet* wallet = table->GetWallet();
@@ -3029,7 +3834,8 @@ RPCResponse cmd_sendtoaddress(const RPCRequest& req, const RPCContext& ctx,
         }
         
         // Create and sign transaction
-        wallet::BuildTxResult result = wallet->SendToAddress(address, amount);
+        wallet::BuildTxResult result = wallet->SendToAddress(address, amount,
+                                                             WalletSendFeeRate(table));
         
         if (!result.success) {
             return RPCResponse::Error(-4, result.error, req.GetId());
@@ -3109,7 +3915,8 @@ RPCResponse cmd_sendmany(const RPCRequest& req, const RPCContext& ctx,
         }
         
         // Create and sign transaction
-        wallet::BuildTxResult result = wallet->SendToRecipients(recipients);
+        wallet::BuildTxResult result = wallet->SendToRecipients(recipients,
+                                                                WalletSendFeeRate(table));
         
         if (!result.success) {
             return RPCResponse::Error(-4, result.error, req.GetId());
@@ -3189,16 +3996,12 @@ RPCResponse cmd_sendfrom(const RPCRequest& req, const RPCContext& ctx,
             return InvalidParams("Unsupported from address type", req.GetId());
         }
         
-        // Get spendable outputs filtered by the from address
-        auto allOutputs = wallet->GetSpendableOutputs();
-        std::vector<wallet::WalletOutput> filteredOutputs;
+        // Get spendable outputs of the from address, largest first
+        std::vector<wallet::WalletOutput> filteredOutputs = wallet->GetSpendableOutputs(fromKeyHash);
         Amount availableFromAddress = 0;
         
-        for (const auto& output : allOutputs) {
-            if (output.keyHash == fromKeyHash) {
-                filteredOutputs.push_back(output);
-                availableFromAddress += output.GetValue();
-            }
+        for (const auto& output : filteredOutputs) {
+            availableFromAddress += output.GetValue();
         }
         
         if (filteredOutputs.empty()) {
@@ -3221,12 +4024,6 @@ RPCResponse cmd_sendfrom(const RPCRequest& req, const RPCContext& ctx,
         Amount estimatedFee = 1000; // Base fee estimate
         Amount targetAmount = amount + estimatedFee;
         
-        // Sort by amount descending for efficient selection
-        std::sort(filteredOutputs.begin(), filteredOutputs.end(),
-                  [](const wallet::WalletOutput& a, const wallet::WalletOutput& b) {
-                      return a.GetValue() > b.GetValue();
-                  });
-        
         std::vector<wallet::WalletOutput> selectedOutputs;
         for (const auto& output : filteredOutputs) {
             if (inputTotal >= targetAmount) break;
@@ -3331,18 +4128,13 @@ RPCResponse cmd_listtransactions(const RPCRequest& req, const RPCContext& ctx,
     
     JSONValue::Array transactions;
     
-    // Get wallet transactions
-    std::vector<wallet::WalletTransaction> walletTxs = wallet->GetTransactions();
-    
-    // Sort by time (most recent first)
-    std::sort(walletTxs.begin(), walletTxs.end(), 
-              [](const wallet::WalletTransaction& a, const wallet::WalletTransaction& b) {
-                  return a.timeReceived > b.timeReceived;
-              });
+    // Wallet transactions, most recent first, shared with other readers and
+    // consistent with the height they were listed at
+    auto snapshot = wallet->GetSnapshot();
     
     // Apply skip and count
     int64_t current = 0;
-    for (const auto& wtx : walletTxs) {
+    for (const auto& wtx : snapshot->transactions) {
         if (current < skip) {
             ++current;
             continue;
@@ -3353,7 +4145,7 @@ RPCResponse cmd_listtransactions(const RPCRequest& req, const RPCContext& ctx,
         
         JSONValue::Object entry;
         entry["txid"] = HashToHex(wtx.GetHash());
-        entry["confirmations"] = static_cast<int64_t>(wtx.GetDepth(wallet->GetChainHeight()));
+        entry["confirmations"] = static_cast<int64_t>(wtx.GetDepth(snapshot->chainHeight));
         
         if (wtx.IsConfirmed()) {
             entry["blockhash"] = HashToHex(wtx.confirmation.blockHash);
@@ -3494,18 +4286,6 @@ static std::optional<Hash160> AddressToKeyHash(const std::string& address) {
     return std::nullopt;
 }
 
-// Helper: Encode bytes as hex string
-static std::string BytesToHex(const std::vector<uint8_t>& bytes) {
-    static const char hexChars[] = "0123456789abcdef";
-    std::string result;
-    result.reserve(bytes.size() * 2);
-    for (uint8_t b : bytes) {
-        result.push_back(hexChars[(b >> 4) & 0x0f]);
-        result.push_back(hexChars[b & 0x0f]);
-    }
-    return result;
-}
-
 // Helper: Decode hex string to bytes
 static std::vector<uint8_t> HexToBytes(const std::string& hex) {
     std::vector<uint8_t> result;
@@ -3670,6 +4450,50 @@ RPCResponse cmd_dumpprivkey(const RPCRequest& req, const RPCContext& ctx,
     }
 }
 
+/// Rescan heights start..stop of the active chain into wallet, reading the
+/// stored blocks and matching them on a pool of their own
+static wallet::RescanResult RescanWallet(RPCCommandTable* table, wallet::Wallet* wallet,
+                                         int32_t start, int32_t stop) {
+    ChainState* chainState = table->GetChainState();
+    db::BlockDB* blockdb = table->GetBlockDB();
+    if (!chainState || !blockdb) {
+        wallet::RescanResult result;
+        result.error = "Block database not available";
+        return result;
+    }
+    
+    auto source = [chainState, blockdb](int32_t height, std::vector<uint8_t>& raw) {
+        const BlockIndex* pindex = chainState->GetChain()[height];
+        if (!pindex || !HasStatus(pindex->nStatus, BlockStatus::HAVE_DATA)) {
+            return false;
+        }
+        return blockdb->ReadRawBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), raw).ok();
+    };
+    
+    // Blocks the filter index has covered are read only if their filter matches
+    wallet::RescanFilterSource filters;
+    if (BlockFilterIndexer* indexer = table->GetBlockFilterIndexer()) {
+        filters = [chainState, indexer](int32_t height) -> std::optional<BlockFilter> {
+            if (height > indexer->GetBestHeight()) {
+                return std::nullopt;
+            }
+            return indexer->GetFilter(chainState->GetChain()[height]);
+        };
+    }
+    
+    util::ThreadPool::Config poolConfig;
+    poolConfig.name = "rescan";
+    util::ThreadPool pool(poolConfig);
+    wallet::RescanResult result = wallet->Rescan(source, start, stop, &pool, filters);
+    pool.Shutdown();
+    
+    if (stop >= 0 && result.stopHeight < stop && result.error.empty() && !result.aborted) {
+        result.error = "Block at height " + std::to_string(result.stopHeight + 1) +
+                       " is not available";
+    }
+    return result;
+}
+
 RPCResponse cmd_importprivkey(const RPCRequest& req, const RPCContext& ctx,
                               RPCCommandTable* table) {
     wallet::Wallet* wallet = table->GetWallet();
@@ -3730,10 +4554,13 @@ RPCResponse cmd_importprivkey(const RPCRequest& req, const RPCContext& ctx,
         // Save the wallet
         wallet->Save();
         
-        // Note: rescan parameter would trigger blockchain rescan to find 
-        // transactions for this address. This requires chain sync infrastructure.
-        // For now, we acknowledge the parameter but don't implement full rescan.
-        (void)rescan;
+        if (rescan) {
+            int32_t tip = table->GetChainState() ? table->GetChainState()->GetChain().Height() : -1;
+            wallet::RescanResult scan = RescanWallet(table, wallet, 0, tip);
+            if (!scan.error.empty()) {
+                return RPCResponse::Error(ErrorCode::WALLET_ERROR, scan.error, req.GetId());
+            }
+        }
         
         return RPCResponse::Success(JSONValue(address), req.GetId());
     } catch (const std::exception& e) {
@@ -3741,6 +4568,59 @@ RPCResponse cmd_importprivkey(const RPCRequest& req, const RPCContext& ctx,
     }
 }
 
+RPCResponse cmd_rescanblockchain(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table) {
+    wallet::Wallet* wallet = table->GetWallet();
+    if (!wallet) {
+        return RPCResponse::Error(ErrorCode::WALLET_NOT_FOUND, "Wallet not loaded", req.GetId());
+    }
+    ChainState* chainState = table->GetChainState();
+    if (!chainState) {
+        return RPCError(-1, "Chain state not available", req.GetId());
+    }
+    
+    try {
+        int32_t tip = chainState->GetChain().Height();
+        int64_t start = GetOptionalParam<int64_t>(req, size_t(0), int64_t(0));
+        int64_t stop = GetOptionalParam<int64_t>(req, size_t(1), int64_t(tip));
+        if (start < 0 || start > tip) {
+            return InvalidParams("Invalid start_height", req.GetId());
+        }
+        if (stop < start || stop > tip) {
+            return InvalidParams("Invalid stop_height", req.GetId());
+        }
+        
+        wallet::RescanResult scan = RescanWallet(table, wallet, static_cast<int32_t>(start),
+                                                 static_cast<int32_t>(stop));
+        if (!scan.error.empty()) {
+            return RPCResponse::Error(ErrorCode::WALLET_ERROR, scan.error, req.GetId());
+        }
+        if (scan.aborted) {
+            return RPCResponse::Error(ErrorCode::WALLET_ERROR,
+                                      "Rescan aborted at height " + std::to_string(scan.stopHeight),
+                                      req.GetId());
+        }
+        
+        JSONValue::Object result;
+        result["start_height"] = static_cast<int64_t>(scan.startHeight);
+        result["stop_height"] = static_cast<int64_t>(scan.stopHeight);
+        result["transactions"] = static_cast<int64_t>(scan.transactionsFound);
+        result["skipped_blocks"] = static_cast<int64_t>(scan.blocksSkipped);
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+    } catch (const std::exception& e) {
+        return InvalidParams(e.what(), req.GetId());
+    }
+}
+
+RPCResponse cmd_abortrescan(const RPCRequest& req, const RPCContext& ctx,
+                            RPCCommandTable* table) {
+    wallet::Wallet* wallet = table->GetWallet();
+    if (!wallet) {
+        return RPCResponse::Error(ErrorCode::WALLET_NOT_FOUND, "Wallet not loaded", req.GetId());
+    }
+    return RPCResponse::Success(JSONValue(wallet->AbortRescan()), req.GetId());
+}
+
 RPCResponse cmd_walletlock(const RPCRequest& req, const RPCContext& ctx,
                            RPCCommandTable* table) {
     wallet::Wallet* wallet = table->GetWallet();
@@ -6373,6 +7253,46 @@ RPCResponse cmd_getmininginfo(const RPCRequest& req, const RPCContext& ctx,
     result["active_problems"] = int64_t(0);
     result["solved_problems"] = int64_t(0);
     
+    // Built-in miner telemetry
+    miner::Miner* miner = table->GetMiner();
+    if (miner) {
+        const miner::MiningStats& stats = miner->GetStats();
+        result["generate"] = miner->IsRunning();
+        result["hashespersec"] = miner->GetHashRate();
+        
+        JSONValue::Object telemetry;
+        telemetry["backend"] = miner->GetBackendName();
+        telemetry["hashes"] = static_cast<int64_t>(stats.hashesComputed.load());
+        JSONValue::Array threadRates;
+        for (double rate : miner->GetThreadHashRates()) {
+            threadRates.push_back(rate);
+        }
+        telemetry["thread_hashps"] = JSONValue(std::move(threadRates));
+        
+        // A template is stale when the tip moved while it was being mined
+        uint64_t templates = stats.templatesBuilt.load();
+        uint64_t staleTemplates = stats.templatesStale.load();
+        telemetry["templates"] = static_cast<int64_t>(templates);
+        telemetry["stale_templates"] = static_cast<int64_t>(staleTemplates);
+        telemetry["stale_template_rate"] = templates == 0 ? 0.0
+            : static_cast<double>(staleTemplates) / templates;
+        telemetry["template_build_us"] = LatencyToJSON(stats.templateBuildLatency.GetSnapshot());
+        
+        // A block is stale when it was found but did not stay in the chain
+        uint64_t found = stats.blocksFound.load();
+        uint64_t accepted = stats.blocksAccepted.load();
+        uint32_t orphaned = miner->GetOrphanedBlockCount();
+        uint64_t staleBlocks = (found > accepted ? found - accepted : 0) + orphaned;
+        telemetry["blocks_found"] = static_cast<int64_t>(found);
+        telemetry["blocks_accepted"] = static_cast<int64_t>(accepted);
+        telemetry["blocks_rejected"] = static_cast<int64_t>(found > accepted ? found - accepted : 0);
+        telemetry["blocks_orphaned"] = static_cast<int64_t>(orphaned);
+        telemetry["stale_block_rate"] = found == 0 ? 0.0
+            : static_cast<double>(staleBlocks) / found;
+        telemetry["block_relay_us"] = LatencyToJSON(stats.blockRelayLatency.GetSnapshot());
+        result["telemetry"] = JSONValue(std::move(telemetry));
+    }
+    
     return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
 }
 
@@ -6389,19 +7309,24 @@ RPCResponse cmd_getblocktemplate(const RPCRequest& req, const RPCContext& ctx,
         return RPCError(-1, "Mempool not available", req.GetId());
     }
     
-    // Get consensus params (use mainnet as default)
-    consensus::Params params = consensus::Params::Main();
-    
-    // Create block assembler and generate template
-    miner::BlockAssemblerOptions options;
-    miner::BlockAssembler assembler(*chainState, *mempool, params, options);
-    
-    // Create a default coinbase script (OP_TRUE for simplicity in mining pool)
-    // In production, miner would provide their own script
-    Script coinbaseScript;
-    coinbaseScript.push_back(OP_TRUE);
+    miner::BlockTemplateCache* cache = table->GetBlockTemplateCache();
+    if (!cache) {
+        return RPCError(-1, "Block template cache not available", req.GetId());
+    }
     
-    miner::BlockTemplate blockTemplate = assembler.CreateNewBlock(coinbaseScript);
+    // With a longpollid, wait for a template worth switching to (BIP22)
+    std::shared_ptr<const miner::BlockTemplate> tmpl;
+    const JSONValue& request = req.GetParam(size_t(0));
+    if (request.IsObject() && request.HasKey("longpollid")) {
+        const JSONValue& longPollId = request["longpollid"];
+        if (!longPollId.IsString()) {
+            return InvalidParams("longpollid must be a string", req.GetId());
+        }
+        tmpl = cache->WaitForChange(longPollId.GetString());
+    } else {
+        tmpl = cache->Get();
+    }
+    const miner::BlockTemplate& blockTemplate = *tmpl;
     
     if (!blockTemplate.isValid) {
         return RPCError(-1, "Failed to create block template: " + blockTemplate.error, req.GetId());
@@ -6424,10 +7349,9 @@ RPCResponse cmd_getblocktemplate(const RPCRequest& req, const RPCContext& ctx,
     result["target"] = miner::TargetToHex(blockTemplate.target);
     result["coinbasevalue"] = static_cast<int64_t>(blockTemplate.coinbaseValue);
     
-    // Add transactions (excluding coinbase)
+    // Add transactions (txInfo holds everything but the coinbase)
     JSONValue::Array txArray;
-    for (size_t i = 1; i < blockTemplate.txInfo.size(); ++i) {
-        const auto& txInfo = blockTemplate.txInfo[i];
+    for (const auto& txInfo : blockTemplate.txInfo) {
         JSONValue::Object txObj;
         
         // Serialize transaction to hex
@@ -6443,8 +7367,8 @@ RPCResponse cmd_getblocktemplate(const RPCRequest& req, const RPCContext& ctx,
     result["transactions"] = JSONValue(std::move(txArray));
     
     // Coinbase auxiliary data
-    if (!blockTemplate.txInfo.empty()) {
-        const auto& coinbaseTx = blockTemplate.txInfo[0].tx;
+    if (!blockTemplate.block.vtx.empty()) {
+        const auto& coinbaseTx = blockTemplate.block.vtx[0];
         DataStream ss;
         Serialize(ss, *coinbaseTx);
         result["coinbasetxn"] = FormatHex(ss.data(), ss.size());
@@ -6460,7 +7384,9 @@ RPCResponse cmd_getblocktemplate(const RPCRequest& req, const RPCContext& ctx,
     // Capabilities
     JSONValue::Array capabilities;
     capabilities.push_back(JSONValue("proposal"));
+    capabilities.push_back(JSONValue("longpoll"));
     result["capabilities"] = JSONValue(std::move(capabilities));
+    result["longpollid"] = miner::BlockTemplateCache::GetLongPollId(blockTemplate);
     
     return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
 }
@@ -6533,10 +7459,12 @@ RPCResponse cmd_submitblock(const RPCRequest& req, const RPCContext& ctx,
         }
         
         // Block was accepted and connected
+        table->NotifyBlockTip();
+        
         // Relay to network peers
         MessageProcessor* msgproc = table->GetMessageProcessor();
         if (msgproc) {
-            msgproc->RelayBlock(block.GetHash());
+            msgproc->RelayBlock(block);
         }
         
         // Return null on success per BIP22
@@ -7288,7 +8216,10 @@ RPCResponse cmd_generatetoaddress(const RPCRequest& req, const RPCContext& ctx,
             
             // Remove confirmed transactions from mempool
             if (mempool) {
-                mempool->RemoveForBlock(block.vtx);
+                mempool->RemoveForBlock(block.vtx, static_cast<uint32_t>(blockTemplate.height));
+            }
+            if (MessageProcessor* msgproc = table->GetMessageProcessor()) {
+                msgproc->BlockConnected(block);
             }
             
             // Notify wallet about the new block so it can track coinbase outputs
@@ -7486,6 +8417,38 @@ RPCResponse cmd_uptime(const RPCRequest& req, const RPCContext& ctx,
     return RPCResponse::Success(JSONValue(static_cast<int64_t>(uptime)), req.GetId());
 }
 
+RPCResponse cmd_getnodereadiness(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table) {
+    const util::StartupProfile* profile = table->GetStartupProfile();
+    if (!profile) {
+        return RPCError(-1, "Startup profile not available", req.GetId());
+    }
+    return RPCResponse::Success(GetReadinessReport(*profile), req.GetId());
+}
+
+RPCResponse cmd_getrpcinfo(const RPCRequest& req, const RPCContext& ctx,
+                           RPCCommandTable* table) {
+    RPCServer* server = table->GetRPCServer();
+    if (!server) {
+        return RPCError(-1, "RPC server not available", req.GetId());
+    }
+    
+    JSONValue::Object result;
+    result["uptime"] = server->GetUptime();
+    result["requests"] = static_cast<int64_t>(server->GetTotalRequests());
+    result["errors"] = static_cast<int64_t>(server->GetTotalErrors());
+    result["active_connections"] = static_cast<int64_t>(server->GetActiveConnections());
+    
+    JSONValue::Object cache;
+    cache["entries"] = static_cast<int64_t>(server->GetCacheSize());
+    cache["hits"] = static_cast<int64_t>(server->GetCacheHits());
+    cache["misses"] = static_cast<int64_t>(server->GetCacheMisses());
+    cache["hit_rate"] = server->GetCacheHitRate();
+    result["response_cache"] = JSONValue(std::move(cache));
+    
+    return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+}
+
 RPCResponse cmd_getmemoryinfo(const RPCRequest& req, const RPCContext& ctx,
                               RPCCommandTable* table) {
     JSONValue::Object result;
@@ -7500,6 +8463,138 @@ RPCResponse cmd_getmemoryinfo(const RPCRequest& req, const RPCContext& ctx,
     locked["chunks_free"] = int64_t(0);
     result["locked"] = JSONValue(std::move(locked));
     
+    // Signature verification cache shared by mempool and block validation
+    SignatureCache::Stats sigStats = GetSignatureCache().GetStats();
+    JSONValue::Object sigcache;
+    sigcache["hits"] = static_cast<int64_t>(sigStats.hits);
+    sigcache["misses"] = static_cast<int64_t>(sigStats.misses);
+    sigcache["inserts"] = static_cast<int64_t>(sigStats.inserts);
+    sigcache["entries"] = static_cast<int64_t>(sigStats.entries);
+    sigcache["capacity"] = static_cast<int64_t>(sigStats.capacity);
+    sigcache["usage"] = static_cast<int64_t>(sigStats.memoryUsage);
+    result["sigcache"] = JSONValue(std::move(sigcache));
+    
+    // Whole-transaction script execution cache
+    ScriptExecutionCache::Stats scriptStats = GetScriptExecutionCache().GetStats();
+    JSONValue::Object scriptcache;
+    scriptcache["hits"] = static_cast<int64_t>(scriptStats.hits);
+    scriptcache["misses"] = static_cast<int64_t>(scriptStats.misses);
+    scriptcache["inserts"] = static_cast<int64_t>(scriptStats.inserts);
+    scriptcache["invalidations"] = static_cast<int64_t>(scriptStats.invalidations);
+    scriptcache["entries"] = static_cast<int64_t>(scriptStats.entries);
+    scriptcache["capacity"] = static_cast<int64_t>(scriptStats.capacity);
+    scriptcache["usage"] = static_cast<int64_t>(scriptStats.memoryUsage);
+    result["scriptcache"] = JSONValue(std::move(scriptcache));
+    
+    // Decompressed public keys for CHECKSIG
+    PubKeyCache::Stats pubkeyStats = GetPubKeyCache().GetStats();
+    JSONValue::Object pubkeycache;
+    pubkeycache["hits"] = static_cast<int64_t>(pubkeyStats.hits);
+    pubkeycache["misses"] = static_cast<int64_t>(pubkeyStats.misses);
+    pubkeycache["hitrate"] = pubkeyStats.HitRate();
+    pubkeycache["inserts"] = static_cast<int64_t>(pubkeyStats.inserts);
+    pubkeycache["evictions"] = static_cast<int64_t>(pubkeyStats.evictions);
+    pubkeycache["entries"] = static_cast<int64_t>(pubkeyStats.entries);
+    pubkeycache["capacity"] = static_cast<int64_t>(pubkeyStats.capacity);
+    result["pubkeycache"] = JSONValue(std::move(pubkeycache));
+    
+    // Identity and UBI claim proofs verified on relay, reused by blocks
+    identity::ProofCache::Stats proofStats = identity::GetProofCache().GetStats();
+    JSONValue::Object proofcache;
+    proofcache["hits"] = static_cast<int64_t>(proofStats.hits);
+    proofcache["misses"] = static_cast<int64_t>(proofStats.misses);
+    proofcache["hitrate"] = proofStats.HitRate();
+    proofcache["inserts"] = static_cast<int64_t>(proofStats.inserts);
+    proofcache["entries"] = static_cast<int64_t>(proofStats.entries);
+    proofcache["capacity"] = static_cast<int64_t>(proofStats.capacity);
+    proofcache["usage"] = static_cast<int64_t>(proofStats.memoryUsage);
+    result["proofcache"] = JSONValue(std::move(proofcache));
+    
+    return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+}
+
+RPCResponse cmd_getscriptprofile(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table) {
+    bool reset = GetOptionalParam<bool>(req, size_t(0), false);
+    ScriptProfile profile = GetScriptProfile();
+    if (reset) {
+        ResetScriptProfile();
+    }
+    
+    JSONValue::Object result;
+    result["enabled"] = ScriptProfilingEnabled();
+    result["clock"] = std::string(ScriptProfileClock());
+    
+    // Most expensive opcodes first
+    std::vector<size_t> order;
+    for (size_t op = 0; op < profile.opcodes.size(); ++op) {
+        if (profile.opcodes[op].executions > 0) {
+            order.push_back(op);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return profile.opcodes[a].cycles > profile.opcodes[b].cycles;
+    });
+    
+    auto entryJSON = [](const ScriptProfileEntry& entry) {
+        JSONValue::Object obj;
+        obj["executions"] = static_cast<int64_t>(entry.executions);
+        obj["cycles"] = static_cast<int64_t>(entry.cycles);
+        obj["cycles_per_execution"] = entry.executions
+            ? static_cast<double>(entry.cycles) / static_cast<double>(entry.executions)
+            : 0.0;
+        return obj;
+    };
+    
+    JSONValue::Array opcodes;
+    for (size_t op : order) {
+        JSONValue::Object obj = entryJSON(profile.opcodes[op]);
+        obj["opcode"] = ScriptProfileOpName(static_cast<uint8_t>(op));
+        opcodes.push_back(JSONValue(std::move(obj)));
+    }
+    result["opcodes"] = JSONValue(std::move(opcodes));
+    
+    // Whole verifications decided without the opcode loop, and the rest
+    JSONValue::Object templates;
+    templates["p2pk"] = JSONValue(entryJSON(profile.templates[static_cast<size_t>(ScriptTemplate::P2PK)]));
+    templates["p2pkh"] = JSONValue(entryJSON(profile.templates[static_cast<size_t>(ScriptTemplate::P2PKH)]));
+    templates["p2sh"] = JSONValue(entryJSON(profile.templates[static_cast<size_t>(ScriptTemplate::P2SH)]));
+    templates["interpreted"] =
+        JSONValue(entryJSON(profile.templates[static_cast<size_t>(ScriptTemplate::NONSTANDARD)]));
+    result["verifications"] = JSONValue(std::move(templates));
+    
+    return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+}
+
+RPCResponse cmd_dumptrace(const RPCRequest& req, const RPCContext& ctx,
+                          RPCCommandTable* table) {
+    bool clear = GetOptionalParam<bool>(req, size_t(0), false);
+    std::vector<util::ThreadTrace> trace = util::GetTrace();
+    if (clear) {
+        util::ClearTrace();
+    }
+    
+    // Complete ("X") events, timestamps in microseconds
+    JSONValue::Array events;
+    for (const util::ThreadTrace& thread : trace) {
+        for (const util::TraceEvent& event : thread.events) {
+            JSONValue::Object obj;
+            obj["name"] = std::string(event.name);
+            obj["cat"] = std::string("shurium");
+            obj["ph"] = std::string("X");
+            obj["ts"] = static_cast<double>(event.startNs) / 1000.0;
+            obj["dur"] = static_cast<double>(event.durationNs) / 1000.0;
+            obj["pid"] = static_cast<int64_t>(1);
+            obj["tid"] = static_cast<int64_t>(thread.threadId);
+            events.push_back(JSONValue(std::move(obj)));
+        }
+    }
+    
+    JSONValue::Object result;
+    result["enabled"] = util::TracingEnabled();
+    result["displayTimeUnit"] = std::string("ms");
+    result["traceEvents"] = JSONValue(std::move(events));
+    
     return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
 }
 
@@ -7702,6 +8797,16 @@ RPCResponse cmd_estimatefee(const RPCRequest& req, const RPCContext& ctx,
         nblocks = 1008;  // Cap at ~1 week
     }
     
+    // Prefer what recent blocks actually confirmed, once there is enough of it
+    if (FeeEstimator* estimator = table->GetFeeEstimator()) {
+        FeeEstimate estimate = estimator->EstimateSmartFee(static_cast<unsigned int>(nblocks));
+        if (estimate.IsValid()) {
+            return RPCResponse::Success(
+                JSONValue(static_cast<double>(estimate.feeRate.GetFeePerK()) / 100000000.0),
+                req.GetId());
+        }
+    }
+    
     // Base fee rates (in SHR per kB)
     constexpr double kMinRelayFee = 0.00001;   // 1000 satoshis/kB
     constexpr double kHighPriorityFee = 0.0001;  // 10000 satoshis/kB
@@ -7778,6 +8883,38 @@ RPCResponse cmd_estimatefee(const RPCRequest& req, const RPCContext& ctx,
     return RPCResponse::Success(JSONValue(feeRate), req.GetId());
 }
 
+RPCResponse cmd_estimatesmartfee(const RPCRequest& req, const RPCContext& ctx,
+                                 RPCCommandTable* table) {
+    try {
+        int64_t target = GetRequiredParam<int64_t>(req, size_t(0));
+        if (target < 1 || target > static_cast<int64_t>(MAX_CONFIRM_TARGET)) {
+            return RPCError(-8, "Invalid conf_target (must be 1-" +
+                            std::to_string(MAX_CONFIRM_TARGET) + ")", req.GetId());
+        }
+        
+        FeeEstimator* estimator = table->GetFeeEstimator();
+        if (!estimator) {
+            return RPCError(-1, "Fee estimation not available", req.GetId());
+        }
+        
+        JSONValue::Object result;
+        FeeEstimate estimate = estimator->EstimateSmartFee(static_cast<unsigned int>(target));
+        if (estimate.IsValid()) {
+            // SHR per kB (1 SHR = 100,000,000 satoshis)
+            result["feerate"] = static_cast<double>(estimate.feeRate.GetFeePerK()) / 100000000.0;
+            result["blocks"] = static_cast<int64_t>(estimate.target);
+        } else {
+            JSONValue::Array errors;
+            errors.push_back(JSONValue("Insufficient data or no feerate found"));
+            result["errors"] = JSONValue(std::move(errors));
+            result["blocks"] = static_cast<int64_t>(0);
+        }
+        return RPCResponse::Success(JSONValue(std::move(result)), req.GetId());
+    } catch (const std::exception& e) {
+        return InvalidParams(e.what(), req.GetId());
+    }
+}
+
 // ============================================================================
 // Fund Management Commands
 // ============================================================================
@@ -0,0 +1,421 @@
+// SHURIUM - Arena-Backed JSON Parser Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/rpc/jsonparser.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define SHURIUM_JSON_SSE2 1
+#endif
+
+namespace shurium {
+namespace rpc {
+
+/// Smallest arena block; requests larger than this get a block of their own
+static constexpr size_t JSON_ARENA_BLOCK_SIZE = 64 * 1024;
+
+// ============================================================================
+// Scanning helpers
+// ============================================================================
+
+/// First '"' or '\\' in [p, end), or end
+static const char* FindStringSpecial(const char* p, const char* end) {
+#ifdef SHURIUM_JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                                  _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0) {
+            return p + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\') ++p;
+    return p;
+}
+
+/// Same whitespace as std::isspace in the C locale
+static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void AppendUTF8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+class JSONDocument::Parser {
+public:
+    Parser(JSONDocument& doc, std::string_view text)
+        : doc_(doc), p_(text.data()), end_(text.data() + text.size()) {}
+
+    bool ParseDocument(JSONNode& root) {
+        if (!ParseValue(root, 0)) return false;
+        SkipWhitespace();
+        return p_ == end_;  // Nothing may follow the value
+    }
+
+private:
+    void SkipWhitespace() {
+        while (p_ < end_ && IsSpace(*p_)) ++p_;
+    }
+
+    bool Literal(std::string_view word) {
+        if (static_cast<size_t>(end_ - p_) < word.size() ||
+            std::memcmp(p_, word.data(), word.size()) != 0) {
+            return false;
+        }
+        p_ += word.size();
+        return true;
+    }
+
+    bool ParseValue(JSONNode& node, size_t depth) {
+        SkipWhitespace();
+        if (p_ >= end_) return false;
+
+        switch (*p_) {
+            case 'n':
+                node.type = JSONValue::Type::Null;
+                return Literal("null");
+            case 't':
+                node.type = JSONValue::Type::Bool;
+                node.boolValue = true;
+                return Literal("true");
+            case 'f':
+                node.type = JSONValue::Type::Bool;
+                node.boolValue = false;
+                return Literal("false");
+            case '"':
+                node.type = JSONValue::Type::String;
+                return ParseString(node.text);
+            case '[':
+                return depth < MAX_JSON_DEPTH && ParseArray(node, depth + 1);
+            case '{':
+                return depth < MAX_JSON_DEPTH && ParseObject(node, depth + 1);
+            default:
+                if (*p_ == '-' || IsDigit(*p_)) return ParseNumber(node);
+                return false;
+        }
+    }
+
+    bool ParseString(std::string_view& out) {
+        const char* start = ++p_;  // Past the opening quote
+        const char* special = FindStringSpecial(start, end_);
+        if (special == end_) return false;
+        if (*special == '"') {
+            // The common case: no escapes, so the value is the text itself
+            out = std::string_view(start, static_cast<size_t>(special - start));
+            p_ = special + 1;
+            return true;
+        }
+
+        std::string& buf = doc_.unescaped_;
+        buf.assign(start, special);
+        p_ = special;
+        while (true) {
+            if (p_ >= end_) return false;
+            if (*p_ == '"') break;
+            if (*p_ != '\\') {
+                const char* next = FindStringSpecial(p_, end_);
+                buf.append(p_, next);
+                p_ = next;
+                continue;
+            }
+            if (++p_ >= end_) return false;
+            switch (*p_++) {
+                case '"': buf += '"'; break;
+                case '\\': buf += '\\'; break;
+                case '/': buf += '/'; break;
+                case 'b': buf += '\b'; break;
+                case 'f': buf += '\f'; break;
+                case 'n': buf += '\n'; break;
+                case 'r': buf += '\r'; break;
+                case 't': buf += '\t'; break;
+                case 'u': {
+                    int32_t cp = ParseHex4();
+                    if (cp < 0) return false;
+                    if (cp >= 0xD800 && cp <= 0xDBFF && end_ - p_ >= 6 &&
+                        p_[0] == '\\' && p_[1] == 'u') {
+                        const char* save = p_;
+                        p_ += 2;
+                        int32_t low = ParseHex4();
+                        if (low >= 0xDC00 && low <= 0xDFFF) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            p_ = save;
+                        }
+                    }
+                    if (cp >= 0xD800 && cp <= 0xDFFF) cp = 0xFFFD;  // Unpaired surrogate
+                    AppendUTF8(buf, static_cast<uint32_t>(cp));
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        ++p_;  // Closing quote
+
+        char* stored = doc_.Allocate<char>(buf.size());
+        std::memcpy(stored, buf.data(), buf.size());
+        out = std::string_view(stored, buf.size());
+        return true;
+    }
+
+    int32_t ParseHex4() {
+        if (end_ - p_ < 4) return -1;
+        int32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = HexDigit(p_[i]);
+            if (digit < 0) return -1;
+            value = (value << 4) | digit;
+        }
+        p_ += 4;
+        return value;
+    }
+
+    bool ParseNumber(JSONNode& node) {
+        const char* start = p_;
+        bool isFloat = false;
+
+        if (*p_ == '-') ++p_;
+        while (p_ < end_ && IsDigit(*p_)) ++p_;
+        if (p_ < end_ && *p_ == '.') {
+            isFloat = true;
+            ++p_;
+            while (p_ < end_ && IsDigit(*p_)) ++p_;
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            isFloat = true;
+            ++p_;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+            while (p_ < end_ && IsDigit(*p_)) ++p_;
+        }
+
+        if (!isFloat) {
+            node.type = JSONValue::Type::Int;
+            auto [ptr, ec] = std::from_chars(start, p_, node.intValue);
+            return ec == std::errc() && ptr == p_;
+        }
+
+        // strtod needs a terminated copy; numbers are short
+        std::string token(start, p_);
+        char* parsedEnd = nullptr;
+        node.type = JSONValue::Type::Double;
+        node.doubleValue = std::strtod(token.c_str(), &parsedEnd);
+        return parsedEnd != token.c_str();
+    }
+
+    bool ParseArray(JSONNode& node, size_t depth) {
+        ++p_;  // '['
+        node.type = JSONValue::Type::Array;
+        size_t mark = doc_.scratch_.size();
+
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == ']') {
+            ++p_;
+            return true;
+        }
+        while (true) {
+            JSONNode child;
+            if (!ParseValue(child, depth)) return false;
+            doc_.scratch_.push_back(child);
+
+            SkipWhitespace();
+            if (p_ >= end_) return false;
+            if (*p_ == ']') {
+                ++p_;
+                return Close(node, mark);
+            }
+            if (*p_++ != ',') return false;
+        }
+    }
+
+    bool ParseObject(JSONNode& node, size_t depth) {
+        ++p_;  // '{'
+        node.type = JSONValue::Type::Object;
+        size_t mark = doc_.scratch_.size();
+
+        SkipWhitespace();
+        if (p_ < end_ && *p_ == '}') {
+            ++p_;
+            return true;
+        }
+        while (true) {
+            SkipWhitespace();
+            if (p_ >= end_ || *p_ != '"') return false;
+            std::string_view key;
+            if (!ParseString(key)) return false;
+
+            SkipWhitespace();
+            if (p_ >= end_ || *p_++ != ':') return false;
+
+            JSONNode child;
+            if (!ParseValue(child, depth)) return false;
+            child.key = key;
+            doc_.scratch_.push_back(child);
+
+            SkipWhitespace();
+            if (p_ >= end_) return false;
+            if (*p_ == '}') {
+                ++p_;
+                return Close(node, mark);
+            }
+            if (*p_++ != ',') return false;
+        }
+    }
+
+    /// Move the children gathered since mark into the arena
+    bool Close(JSONNode& node, size_t mark) {
+        auto& scratch = doc_.scratch_;
+        node.size = scratch.size() - mark;
+        JSONNode* children = doc_.Allocate<JSONNode>(node.size);
+        for (size_t i = 0; i < node.size; ++i) {
+            new (&children[i]) JSONNode(scratch[mark + i]);
+        }
+        node.children = children;
+        scratch.resize(mark);
+        return true;
+    }
+
+    JSONDocument& doc_;
+    const char* p_;
+    const char* end_;
+};
+
+// ============================================================================
+// JSONNode
+// ============================================================================
+
+const JSONNode* JSONNode::Find(std::string_view name) const {
+    if (!IsObject()) return nullptr;
+    for (size_t i = size; i > 0; --i) {
+        if (children[i - 1].key == name) return &children[i - 1];
+    }
+    return nullptr;
+}
+
+JSONValue JSONNode::ToValue() const {
+    switch (type) {
+        case JSONValue::Type::Null:
+            return JSONValue();
+        case JSONValue::Type::Bool:
+            return JSONValue(boolValue);
+        case JSONValue::Type::Int:
+            return JSONValue(intValue);
+        case JSONValue::Type::Double:
+            return JSONValue(doubleValue);
+        case JSONValue::Type::String:
+            return JSONValue(std::string(text));
+        case JSONValue::Type::Array: {
+            JSONValue::Array arr;
+            arr.reserve(size);
+            for (const auto& child : *this) {
+                arr.push_back(child.ToValue());
+            }
+            return JSONValue(std::move(arr));
+        }
+        case JSONValue::Type::Object: {
+            JSONValue::Object obj;
+            for (const auto& child : *this) {
+                obj[std::string(child.key)] = child.ToValue();
+            }
+            return JSONValue(std::move(obj));
+        }
+    }
+    return JSONValue();
+}
+
+// ============================================================================
+// JSONDocument
+// ============================================================================
+
+JSONDocument::JSONDocument() = default;
+JSONDocument::~JSONDocument() = default;
+
+bool JSONDocument::Parse(std::string_view text) {
+    ResetArena();
+    scratch_.clear();
+    root_ = JSONNode();
+
+    Parser parser(*this, text);
+    if (!parser.ParseDocument(root_)) {
+        root_ = JSONNode();
+        scratch_.clear();
+        return false;
+    }
+    return true;
+}
+
+size_t JSONDocument::ArenaSize() const {
+    size_t total = 0;
+    for (const auto& block : blocks_) total += block.capacity;
+    return total;
+}
+
+void* JSONDocument::AllocateBytes(size_t size, size_t align) {
+    if (size == 0) return nullptr;
+    if (!blocks_.empty()) {
+        size_t offset = (blockUsed_ + align - 1) & ~(align - 1);
+        if (offset + size <= blocks_.back().capacity) {
+            blockUsed_ = offset + size;
+            return blocks_.back().data.get() + offset;
+        }
+    }
+    Block block;
+    block.capacity = std::max(JSON_ARENA_BLOCK_SIZE, size);
+    block.data.reset(new unsigned char[block.capacity]);
+    blocks_.push_back(std::move(block));
+    blockUsed_ = size;
+    return blocks_.back().data.get();
+}
+
+void JSONDocument::ResetArena() {
+    // Keep the most recent block for the next document
+    if (blocks_.size() > 1) {
+        Block last = std::move(blocks_.back());
+        blocks_.clear();
+        blocks_.push_back(std::move(last));
+    }
+    blockUsed_ = 0;
+}
+
+} // namespace rpc
+} // namespace shurium
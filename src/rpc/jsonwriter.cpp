@@ -0,0 +1,194 @@
+// SHURIUM - Streaming JSON Writer Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/rpc/jsonwriter.h>
+#include <shurium/core/hex.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace shurium {
+namespace rpc {
+
+JSONWriter::JSONWriter() = default;
+
+JSONWriter::JSONWriter(Sink sink, size_t flushThreshold)
+    : sink_(std::move(sink)), flushThreshold_(flushThreshold) {
+    buffer_.reserve(flushThreshold_ + flushThreshold_ / 4);
+}
+
+void JSONWriter::BeginValue() {
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (!firstInScope_.empty()) {
+        if (firstInScope_.back()) {
+            firstInScope_.back() = false;
+        } else {
+            buffer_ += ',';
+        }
+    }
+}
+
+JSONWriter& JSONWriter::BeginObject() {
+    BeginValue();
+    buffer_ += '{';
+    firstInScope_.push_back(true);
+    return *this;
+}
+
+JSONWriter& JSONWriter::EndObject() {
+    buffer_ += '}';
+    firstInScope_.pop_back();
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::BeginArray() {
+    BeginValue();
+    buffer_ += '[';
+    firstInScope_.push_back(true);
+    return *this;
+}
+
+JSONWriter& JSONWriter::EndArray() {
+    buffer_ += ']';
+    firstInScope_.pop_back();
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::Key(std::string_view key) {
+    BeginValue();
+    AppendEscaped(buffer_, key);
+    buffer_ += ':';
+    afterKey_ = true;
+    return *this;
+}
+
+JSONWriter& JSONWriter::Null() {
+    BeginValue();
+    buffer_ += "null";
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::Bool(bool value) {
+    BeginValue();
+    buffer_ += value ? "true" : "false";
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::Int(int64_t value) {
+    BeginValue();
+    buffer_ += std::to_string(value);
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::Double(double value) {
+    BeginValue();
+    // Same as an ostream with setprecision(15), which ToJSON() has always used
+    char buf[32];
+    int len = std::snprintf(buf, sizeof(buf), "%.15g", value);
+    buffer_.append(buf, static_cast<size_t>(len));
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::String(std::string_view value) {
+    BeginValue();
+    AppendEscaped(buffer_, value);
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::HexString(const uint8_t* data, size_t len) {
+    // Input bytes encoded per step, so a large value is flushed in pieces
+    constexpr size_t CHUNK = 16 * 1024;
+    BeginValue();
+    buffer_ += '"';
+    for (size_t done = 0; done < len;) {
+        size_t n = std::min(CHUNK, len - done);
+        size_t at = buffer_.size();
+        buffer_.resize(at + 2 * n);
+        EncodeHex(data + done, n, &buffer_[at]);
+        done += n;
+        MaybeFlush();
+    }
+    buffer_ += '"';
+    MaybeFlush();
+    return *this;
+}
+
+JSONWriter& JSONWriter::Value(const JSONValue& value) {
+    switch (value.GetType()) {
+        case JSONValue::Type::Null:
+            return Null();
+        case JSONValue::Type::Bool:
+            return Bool(value.GetBool());
+        case JSONValue::Type::Int:
+            return Int(value.GetInt());
+        case JSONValue::Type::Double:
+            return Double(value.GetDouble());
+        case JSONValue::Type::String:
+            return String(value.GetString());
+        case JSONValue::Type::Array:
+            BeginArray();
+            for (const auto& item : value.GetArray()) {
+                Value(item);
+            }
+            return EndArray();
+        case JSONValue::Type::Object:
+            BeginObject();
+            for (const auto& [key, member] : value.GetObject()) {
+                Key(key).Value(member);
+            }
+            return EndObject();
+    }
+    return *this;
+}
+
+void JSONWriter::Flush() {
+    if (!sink_ || buffer_.empty()) return;
+    sink_(buffer_.data(), buffer_.size());
+    flushed_ += buffer_.size();
+    buffer_.clear();
+}
+
+std::string JSONWriter::Take() {
+    flushed_ += buffer_.size();
+    std::string out;
+    out.swap(buffer_);
+    return out;
+}
+
+void JSONWriter::AppendEscaped(std::string& out, std::string_view value) {
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 32) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<int>(c));
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace rpc
+} // namespace shurium
@@ -0,0 +1,86 @@
+// SHURIUM - Metrics and Readiness Endpoints Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/rpc/metrics.h>
+#include <shurium/util/metrics.h>
+#include <shurium/util/startup.h>
+
+#include <chrono>
+
+namespace shurium {
+namespace rpc {
+
+void HandleMetricsRequest(const HTTPRequest& request, const util::MetricsRegistry& registry,
+                          HTTPReply& reply) {
+    // The handler is found by prefix; only the exact path is ours
+    std::string path = request.target.substr(0, request.target.find('?'));
+    if (path != METRICS_PATH) {
+        reply.SetBody(404, "text/plain", "Not found\r\n");
+        return;
+    }
+    reply.SetBody(200, METRICS_CONTENT_TYPE, registry.Render());
+}
+
+void RegisterMetricsHandler(RPCServer& server, util::MetricsRegistry& registry) {
+    server.RegisterHTTPHandler(METRICS_PATH, [&registry](const HTTPRequest& request,
+                                                         HTTPReply& reply) {
+        HandleMetricsRequest(request, registry, reply);
+    });
+}
+
+void UnregisterMetricsHandler(RPCServer& server) {
+    server.UnregisterHTTPHandler(METRICS_PATH);
+}
+
+JSONValue GetReadinessReport(const util::StartupProfile& profile) {
+    auto ms = [](std::chrono::microseconds us) {
+        return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(us).count());
+    };
+    
+    JSONValue::Array blockers;
+    for (std::string& blocker : profile.GetBlockers()) {
+        blockers.emplace_back(std::move(blocker));
+    }
+    JSONValue::Array phases;
+    for (const auto& timing : profile.GetPhases()) {
+        JSONValue::Object phase;
+        phase["name"] = util::StartupPhaseName(timing.phase);
+        phase["state"] = util::StartupStateName(timing.state);
+        phase["ms"] = ms(timing.elapsed);
+        phases.emplace_back(std::move(phase));
+    }
+    
+    JSONValue::Object result;
+    result["ready"] = blockers.empty();
+    result["blockers"] = JSONValue(std::move(blockers));
+    result["startup_ms"] = ms(profile.GetStartupTime());
+    result["phases"] = JSONValue(std::move(phases));
+    return JSONValue(std::move(result));
+}
+
+void HandleReadinessRequest(const HTTPRequest& request, const util::StartupProfile& profile,
+                            HTTPReply& reply) {
+    std::string path = request.target.substr(0, request.target.find('?'));
+    if (path != READINESS_PATH) {
+        reply.SetBody(404, "text/plain", "Not found\r\n");
+        return;
+    }
+    JSONValue report = GetReadinessReport(profile);
+    reply.SetBody(report["ready"].GetBool() ? 200 : 503, "application/json",
+                  report.ToJSON() + "\n");
+}
+
+void RegisterReadinessHandler(RPCServer& server, const util::StartupProfile& profile) {
+    server.RegisterHTTPHandler(READINESS_PATH, [&profile](const HTTPRequest& request,
+                                                          HTTPReply& reply) {
+        HandleReadinessRequest(request, profile, reply);
+    });
+}
+
+void UnregisterReadinessHandler(RPCServer& server) {
+    server.UnregisterHTTPHandler(READINESS_PATH);
+}
+
+} // namespace rpc
+} // namespace shurium
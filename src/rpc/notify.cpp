@@ -0,0 +1,544 @@
+// SHURIUM - Push Notifications Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/rpc/notify.h>
+#include <shurium/rpc/jsonwriter.h>
+#include <shurium/chain/blockindex.h>
+#include <shurium/chain/chainstate.h>
+#include <shurium/core/hex.h>
+#include <shurium/core/serialize.h>
+#include <shurium/crypto/sha1.h>
+#include <shurium/util/logging.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace shurium {
+namespace rpc {
+
+namespace {
+
+/// WebSocket opcodes used here
+constexpr uint8_t WS_OP_CONTINUATION = 0x0;
+constexpr uint8_t WS_OP_TEXT = 0x1;
+constexpr uint8_t WS_OP_BINARY = 0x2;
+constexpr uint8_t WS_OP_CLOSE = 0x8;
+constexpr uint8_t WS_OP_PING = 0x9;
+constexpr uint8_t WS_OP_PONG = 0xA;
+
+/// Appended to the client's key before hashing (RFC 6455 section 4.2.2)
+constexpr char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+constexpr uint32_t ALL_TOPICS = (1u << NOTIFY_TOPIC_COUNT) - 1;
+
+constexpr uint32_t TopicBit(NotifyTopic topic) {
+    return 1u << static_cast<uint32_t>(topic);
+}
+
+std::string EncodeBase64(const uint8_t* data, size_t len) {
+    static const char chars[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t n = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < len) n |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < len) n |= data[i + 2];
+        out += chars[(n >> 18) & 0x3F];
+        out += chars[(n >> 12) & 0x3F];
+        out += i + 1 < len ? chars[(n >> 6) & 0x3F] : '=';
+        out += i + 2 < len ? chars[n & 0x3F] : '=';
+    }
+    return out;
+}
+
+std::string ToLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+/// Topics named by a request target: "/?topics=a,b", "/a" or "/" for all
+bool ParseTopics(const std::string& target, uint32_t& topics) {
+    std::string list;
+    size_t query = target.find('?');
+    std::string path = target.substr(0, query);
+    if (query != std::string::npos) {
+        std::string params = target.substr(query + 1);
+        size_t start = 0;
+        while (start <= params.size()) {
+            size_t end = params.find('&', start);
+            if (end == std::string::npos) end = params.size();
+            std::string param = params.substr(start, end - start);
+            if (param.compare(0, 7, "topics=") == 0) {
+                list = param.substr(7);
+            }
+            start = end + 1;
+        }
+    }
+    if (list.empty() && path.size() > 1) {
+        list = path.substr(1);
+    }
+
+    topics = 0;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        if (end > start) {
+            auto topic = ParseNotifyTopic(ToLower(list.substr(start, end - start)));
+            if (!topic) {
+                return false;
+            }
+            topics |= TopicBit(*topic);
+        }
+        start = end + 1;
+    }
+    if (topics == 0) {
+        topics = ALL_TOPICS;
+    }
+    return true;
+}
+
+void SendRaw(Connection& conn, const std::string& data) {
+    conn.Send(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+std::string HTTPError(int code, const std::string& reason, const std::string& extraHeaders = "") {
+    return "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n" + extraHeaders +
+           "Connection: close\r\nContent-Length: 0\r\n\r\n";
+}
+
+} // namespace
+
+const char* NotifyTopicName(NotifyTopic topic) {
+    switch (topic) {
+        case NotifyTopic::HASHBLOCK: return "hashblock";
+        case NotifyTopic::RAWBLOCK: return "rawblock";
+        case NotifyTopic::HASHTX: return "hashtx";
+        case NotifyTopic::RAWTX: return "rawtx";
+        case NotifyTopic::UBI: return "ubi";
+        case NotifyTopic::GOVERNANCE: return "governance";
+    }
+    return "unknown";
+}
+
+std::optional<NotifyTopic> ParseNotifyTopic(const std::string& name) {
+    for (size_t i = 0; i < NOTIFY_TOPIC_COUNT; ++i) {
+        NotifyTopic topic = static_cast<NotifyTopic>(i);
+        if (name == NotifyTopicName(topic)) {
+            return topic;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string WebSocketAcceptKey(const std::string& key) {
+    std::string input = key + WS_GUID;
+    Byte hash[SHA1::OUTPUT_SIZE];
+    SHA1().Write(reinterpret_cast<const Byte*>(input.data()), input.size()).Finalize(hash);
+    return EncodeBase64(hash, sizeof(hash));
+}
+
+std::vector<uint8_t> MakeWebSocketFrame(uint8_t opcode, const uint8_t* payload, size_t size) {
+    std::vector<uint8_t> frame;
+    frame.reserve(size + 10);
+    frame.push_back(static_cast<uint8_t>(0x80 | opcode));
+    if (size < 126) {
+        frame.push_back(static_cast<uint8_t>(size));
+    } else if (size <= 0xFFFF) {
+        frame.push_back(126);
+        frame.push_back(static_cast<uint8_t>(size >> 8));
+        frame.push_back(static_cast<uint8_t>(size));
+    } else {
+        frame.push_back(127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.push_back(static_cast<uint8_t>(static_cast<uint64_t>(size) >> shift));
+        }
+    }
+    frame.insert(frame.end(), payload, payload + size);
+    return frame;
+}
+
+// ============================================================================
+// Notification Publisher
+// ============================================================================
+
+struct NotificationPublisher::Session {
+    std::unique_ptr<Connection> conn;
+    std::string buffer;
+    uint32_t topics{0};
+    bool upgraded{false};
+    bool closing{false};
+};
+
+NotificationPublisher::NotificationPublisher(const Options& options)
+    : options_(options) {
+}
+
+NotificationPublisher::~NotificationPublisher() {
+    Stop();
+}
+
+bool NotificationPublisher::Start() {
+    if (running_) {
+        return true;
+    }
+
+    NetAddress bindAddr;
+    if (!options_.bindAddress.empty()) {
+        auto parsed = NetAddress::FromString(options_.bindAddress);
+        if (!parsed) {
+            LOG_ERROR(util::LogCategory::RPC) << "Notify: invalid bind address "
+                                              << options_.bindAddress;
+            return false;
+        }
+        bindAddr = *parsed;
+    }
+
+    listener_ = Listener::Create(bindAddr, options_.port);
+    if (!listener_->Start()) {
+        LOG_ERROR(util::LogCategory::RPC) << "Notify: cannot listen on port " << options_.port;
+        listener_.reset();
+        return false;
+    }
+    listener_->SetAcceptCallback([this](std::unique_ptr<Connection> conn) {
+        OnAccept(std::move(conn));
+    });
+
+    eventLoop_ = std::make_unique<EventLoop>();
+    eventLoop_->AddListener(listener_.get());
+    eventLoop_->Start();
+
+    running_ = true;
+    LOG_INFO(util::LogCategory::RPC) << "Notifications served on ws://" << options_.bindAddress
+                                     << ":" << GetPort();
+    return true;
+}
+
+void NotificationPublisher::Stop() {
+    // Unregister first: it waits for a running notification to finish
+    if (chainman_) {
+        chainman_->UnregisterBlockConnected(blockConnectedId_);
+        chainman_ = nullptr;
+        blockConnectedId_ = -1;
+    }
+
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    eventLoop_->Stop();
+    for (auto& [conn, session] : sessions_) {
+        eventLoop_->RemoveConnection(conn);
+        conn->Close();
+    }
+    sessions_.clear();
+    for (auto& count : subscribers_) {
+        count = 0;
+    }
+    sessionCount_ = 0;
+
+    eventLoop_->RemoveListener(listener_.get());
+    listener_->Stop();
+    listener_.reset();
+    eventLoop_.reset();
+}
+
+uint16_t NotificationPublisher::GetPort() const {
+    return listener_ ? listener_->GetListenAddress().GetPort() : options_.port;
+}
+
+void NotificationPublisher::AttachChain(ChainStateManager& chainman) {
+    chainman_ = &chainman;
+    blockConnectedId_ = chainman.RegisterBlockConnected(
+        [this](const Block& block, const BlockIndex* index) { PublishBlock(block, index); });
+}
+
+// ============================================================================
+// Publishing
+// ============================================================================
+
+void NotificationPublisher::PublishBlock(const Block& block, const BlockIndex* index) {
+    bool wantHash = HasSubscribers(NotifyTopic::HASHBLOCK);
+    bool wantRaw = HasSubscribers(NotifyTopic::RAWBLOCK);
+    if (!wantHash && !wantRaw) {
+        return;
+    }
+
+    // Connected blocks carry their hash in the index
+    std::string hash = index ? index->GetBlockHash().ToHex() : block.GetHash().ToHex();
+    if (wantHash) {
+        Publish(NotifyTopic::HASHBLOCK, [&](JSONWriter& writer) {
+            writer.BeginObject().Key("hash").String(hash);
+            if (index) {
+                writer.Key("height").Int(index->nHeight);
+            }
+            writer.EndObject();
+        });
+    }
+    if (wantRaw) {
+        DataStream ss;
+        Serialize(ss, block);
+        std::string hex = BytesToHex(ss.data(), ss.TotalSize());
+        Publish(NotifyTopic::RAWBLOCK, [&](JSONWriter& writer) { writer.String(hex); });
+    }
+}
+
+void NotificationPublisher::PublishTransaction(const Transaction& tx) {
+    if (HasSubscribers(NotifyTopic::HASHTX)) {
+        std::string txid = tx.GetHash().ToHex();
+        Publish(NotifyTopic::HASHTX, [&](JSONWriter& writer) { writer.String(txid); });
+    }
+    if (HasSubscribers(NotifyTopic::RAWTX)) {
+        DataStream ss;
+        Serialize(ss, tx);
+        std::string hex = BytesToHex(ss.data(), ss.TotalSize());
+        Publish(NotifyTopic::RAWTX, [&](JSONWriter& writer) { writer.String(hex); });
+    }
+}
+
+void NotificationPublisher::PublishEvent(NotifyTopic topic, const JSONValue& data) {
+    if (HasSubscribers(topic)) {
+        Publish(topic, [&](JSONWriter& writer) { writer.Value(data); });
+    }
+}
+
+void NotificationPublisher::Publish(NotifyTopic topic,
+                                    const std::function<void(JSONWriter&)>& writeData) {
+    size_t index = static_cast<size_t>(topic);
+
+    std::lock_guard<std::mutex> lock(publishMutex_);
+    if (!running_) {
+        return;
+    }
+
+    // Members in sorted order, as JSONValue would write them
+    JSONWriter writer;
+    writer.BeginObject().Key("data");
+    writeData(writer);
+    writer.Key("sequence").Int(static_cast<int64_t>(sequence_[index]++));
+    writer.Key("topic").String(NotifyTopicName(topic));
+    writer.EndObject();
+    std::string message = writer.Take();
+
+    auto frame = std::make_shared<const std::vector<uint8_t>>(MakeWebSocketFrame(
+        WS_OP_TEXT, reinterpret_cast<const uint8_t*>(message.data()), message.size()));
+    ++stats_[index].published;
+    eventLoop_->Post([this, topic, frame]() { Deliver(topic, frame); });
+}
+
+void NotificationPublisher::Deliver(NotifyTopic topic, SendBuffer frame) {
+    TopicStats& stats = stats_[static_cast<size_t>(topic)];
+    uint32_t bit = TopicBit(topic);
+    for (auto& [conn, session] : sessions_) {
+        if (!session->upgraded || session->closing || !(session->topics & bit)) {
+            continue;
+        }
+        // A subscriber that stops reading loses messages, not the node
+        if (conn->GetSendBufferSize() + frame->size() > options_.maxQueueBytes) {
+            ++stats.dropped;
+            continue;
+        }
+        conn->Send(frame);
+        ++stats.delivered;
+    }
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+void NotificationPublisher::OnAccept(std::unique_ptr<Connection> conn) {
+    // Sockets are reused, so connections that closed go before new ones
+    RemoveClosedSessions();
+    if (sessions_.size() >= options_.maxSubscribers) {
+        SendRaw(*conn, HTTPError(503, "Service Unavailable"));
+        conn->Close();
+        return;
+    }
+
+    auto session = std::make_unique<Session>();
+    Connection* raw = conn.get();
+    session->conn = std::move(conn);
+    raw->SetEventCallback([this](Connection& c, ConnEvent event) {
+        auto it = sessions_.find(&c);
+        if (event == ConnEvent::DATA_RECEIVED && it != sessions_.end()) {
+            OnData(*it->second);
+        }
+    });
+    raw->SetErrorCallback([this](Connection&, int, const std::string&) {
+        eventLoop_->Post([this]() { RemoveClosedSessions(); });
+    });
+
+    sessions_.emplace(raw, std::move(session));
+    eventLoop_->AddConnection(raw);
+}
+
+void NotificationPublisher::OnData(Session& session) {
+    std::vector<uint8_t> data = session.conn->RecvAll();
+    if (session.closing) {
+        return;
+    }
+    session.buffer.append(data.begin(), data.end());
+
+    bool ok = session.upgraded ? HandleFrames(session) : HandleHandshake(session);
+    if (!ok) {
+        Disconnect(session);
+    }
+}
+
+bool NotificationPublisher::HandleHandshake(Session& session) {
+    HTTPRequest request;
+    size_t consumed = 0;
+    switch (FrameHTTPRequest(session.buffer, 0, request, consumed)) {
+        case HTTPFrameResult::INCOMPLETE:
+            return true;
+        case HTTPFrameResult::COMPLETE:
+            break;
+        default:
+            SendRaw(*session.conn, HTTPError(400, "Bad Request"));
+            return false;
+    }
+    session.buffer.erase(0, consumed);
+
+    auto header = [&](const char* name) {
+        auto it = request.headers.find(name);
+        return it != request.headers.end() ? it->second : std::string();
+    };
+    uint32_t topics = 0;
+    if (request.method != "GET" || ToLower(header("upgrade")).find("websocket") == std::string::npos ||
+        header("sec-websocket-key").empty() || !ParseTopics(request.target, topics)) {
+        SendRaw(*session.conn, HTTPError(400, "Bad Request"));
+        return false;
+    }
+    if (header("sec-websocket-version") != "13") {
+        SendRaw(*session.conn, HTTPError(426, "Upgrade Required", "Sec-WebSocket-Version: 13\r\n"));
+        return false;
+    }
+
+    // Subscribed before the reply, so the client gets everything published
+    // once it has seen it
+    session.topics = topics;
+    SetSubscribed(session, true);
+    SendRaw(*session.conn,
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: " + WebSocketAcceptKey(header("sec-websocket-key")) +
+            "\r\n\r\n");
+
+    // A client may send frames right behind its handshake
+    return session.buffer.empty() || HandleFrames(session);
+}
+
+bool NotificationPublisher::HandleFrames(Session& session) {
+    std::string& buf = session.buffer;
+    while (!session.closing && buf.size() >= 2) {
+        auto byte = [&](size_t i) { return static_cast<uint8_t>(buf[i]); };
+        uint8_t opcode = byte(0) & 0x0F;
+        bool masked = (byte(1) & 0x80) != 0;
+        uint64_t length = byte(1) & 0x7F;
+        size_t pos = 2;
+        if (length == 126) {
+            if (buf.size() < 4) return true;
+            length = (static_cast<uint64_t>(byte(2)) << 8) | byte(3);
+            pos = 4;
+        } else if (length == 127) {
+            if (buf.size() < 10) return true;
+            length = 0;
+            for (size_t i = 2; i < 10; ++i) {
+                length = (length << 8) | byte(i);
+            }
+            pos = 10;
+        }
+
+        // Clients must mask every frame (RFC 6455 section 5.1)
+        if (!masked || length > MAX_NOTIFY_CLIENT_FRAME) {
+            return false;
+        }
+        if (buf.size() < pos + 4 + length) {
+            return true;
+        }
+        std::vector<uint8_t> payload(static_cast<size_t>(length));
+        for (size_t i = 0; i < payload.size(); ++i) {
+            payload[i] = byte(pos + 4 + i) ^ byte(pos + (i & 3));
+        }
+        buf.erase(0, pos + 4 + static_cast<size_t>(length));
+
+        switch (opcode) {
+            case WS_OP_CLOSE:
+                // Echo the status code and go
+                SendFrame(session, WS_OP_CLOSE, payload.data(), std::min<size_t>(payload.size(), 2));
+                return false;
+            case WS_OP_PING:
+                SendFrame(session, WS_OP_PONG, payload.data(), payload.size());
+                break;
+            case WS_OP_PONG:
+            case WS_OP_TEXT:
+            case WS_OP_BINARY:
+            case WS_OP_CONTINUATION:
+                // Subscriptions are fixed at the handshake; data is ignored
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+void NotificationPublisher::SendFrame(Session& session, uint8_t opcode, const uint8_t* payload,
+                                      size_t size) {
+    session.conn->Send(MakeWebSocketFrame(opcode, payload, size));
+}
+
+void NotificationPublisher::Disconnect(Session& session) {
+    // Called from the connection's own callbacks, so it is closed later
+    session.closing = true;
+    SetSubscribed(session, false);
+    Connection* conn = session.conn.get();
+    eventLoop_->Post([this, conn]() {
+        if (sessions_.count(conn) > 0) {
+            conn->Close();
+        }
+        RemoveClosedSessions();
+    });
+}
+
+void NotificationPublisher::RemoveClosedSessions() {
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (it->first->IsConnected()) {
+            ++it;
+            continue;
+        }
+        SetSubscribed(*it->second, false);
+        eventLoop_->RemoveConnection(it->first);
+        it = sessions_.erase(it);
+    }
+}
+
+void NotificationPublisher::SetSubscribed(Session& session, bool subscribed) {
+    if (session.upgraded == subscribed) {
+        return;
+    }
+    session.upgraded = subscribed;
+    for (size_t i = 0; i < NOTIFY_TOPIC_COUNT; ++i) {
+        if (session.topics & TopicBit(static_cast<NotifyTopic>(i))) {
+            if (subscribed) {
+                ++subscribers_[i];
+            } else {
+                --subscribers_[i];
+            }
+        }
+    }
+    if (subscribed) {
+        ++sessionCount_;
+    } else {
+        --sessionCount_;
+    }
+}
+
+} // namespace rpc
+} // namespace shurium
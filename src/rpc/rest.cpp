@@ -0,0 +1,354 @@
+// SHURIUM - REST Interface Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/rpc/rest.h>
+#include <shurium/rpc/commands.h>
+#include <shurium/chain/blockindex.h>
+#include <shurium/chain/chainstate.h>
+#include <shurium/core/hex.h>
+#include <shurium/core/serialize.h>
+#include <shurium/db/blockdb.h>
+#include <shurium/mempool/mempool.h>
+
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+namespace shurium {
+namespace rpc {
+
+namespace {
+
+/// Height reported for outputs that exist only in the mempool
+constexpr uint32_t MEMPOOL_HEIGHT = 0x7FFFFFFF;
+
+void SetError(HTTPReply& reply, int status, const std::string& message) {
+    reply.SetBody(status, "text/plain", message + "\r\n");
+}
+
+/// Split "path.ext" into the path and its format
+bool ParseFormat(const std::string& target, std::string& path, RESTFormat& format) {
+    std::string withoutQuery = target.substr(0, target.find('?'));
+    size_t dot = withoutQuery.rfind('.');
+    if (dot == std::string::npos || withoutQuery.find('/', dot) != std::string::npos) {
+        return false;
+    }
+    std::string ext = withoutQuery.substr(dot + 1);
+    if (ext == "bin") {
+        format = RESTFormat::BINARY;
+    } else if (ext == "hex") {
+        format = RESTFormat::HEX;
+    } else if (ext == "json") {
+        format = RESTFormat::JSON;
+    } else {
+        return false;
+    }
+    path = withoutQuery.substr(0, dot);
+    return true;
+}
+
+std::vector<std::string> SplitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        parts.push_back(path.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+bool ParseHash(const std::string& hex, Hash256& hash) {
+    if (hex.size() != 64 || !IsValidHex(hex)) {
+        return false;
+    }
+    hash = Hash256::FromHex(hex);
+    return true;
+}
+
+/// Reply with serialized bytes as binary or hex
+void SetBytes(HTTPReply& reply, RESTFormat format, std::vector<uint8_t> bytes) {
+    if (format == RESTFormat::BINARY) {
+        reply.status = 200;
+        reply.contentType = "application/octet-stream";
+        reply.body = std::move(bytes);
+    } else {
+        reply.SetBody(200, "text/plain", BytesToHex(bytes) + "\n");
+    }
+}
+
+void SetJSON(HTTPReply& reply, const JSONValue& value) {
+    reply.SetBody(200, "application/json", value.ToJSON() + "\n");
+}
+
+// ============================================================================
+// Endpoints
+// ============================================================================
+
+void RESTBlock(const std::vector<std::string>& parts, RESTFormat format,
+               RPCCommandTable& table, HTTPReply& reply) {
+    Hash256 hash;
+    if (parts.size() != 1 || !ParseHash(parts[0], hash)) {
+        SetError(reply, 400, "Invalid hash: " + (parts.empty() ? std::string() : parts[0]));
+        return;
+    }
+
+    ChainStateManager* chainman = table.GetChainStateManager();
+    db::BlockDB* blockdb = table.GetBlockDB();
+    if (!chainman || !blockdb) {
+        SetError(reply, 503, "Block database not available");
+        return;
+    }
+    const BlockIndex* pindex = chainman->LookupBlockIndex(BlockHash(hash));
+    if (!pindex) {
+        SetError(reply, 404, parts[0] + " not found");
+        return;
+    }
+    if (!HasStatus(pindex->nStatus, BlockStatus::HAVE_DATA)) {
+        SetError(reply, 404, parts[0] + " not available (pruned or not downloaded)");
+        return;
+    }
+
+    if (format == RESTFormat::JSON) {
+        JSONValue::Array params;
+        params.push_back(JSONValue(parts[0]));
+        params.push_back(JSONValue(static_cast<int64_t>(2)));
+        RPCResponse response = cmd_getblock(RPCRequest("getblock", JSONValue(std::move(params))),
+                                            RPCContext(), &table);
+        if (response.IsError()) {
+            SetError(reply, 404, response.GetErrorMessage());
+            return;
+        }
+        SetJSON(reply, response.GetResult());
+        return;
+    }
+
+    // The stored bytes are the wire serialization, so they go out as read
+    std::vector<uint8_t> raw;
+    db::Status status =
+        blockdb->ReadRawBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), raw);
+    if (!status.ok()) {
+        SetError(reply, 500, "Failed to read block: " + status.ToString());
+        return;
+    }
+    SetBytes(reply, format, std::move(raw));
+}
+
+void RESTHeaders(const std::vector<std::string>& parts, RESTFormat format,
+                 RPCCommandTable& table, HTTPReply& reply) {
+    if (parts.size() != 2) {
+        SetError(reply, 400, "No header count specified. Use /rest/headers/<count>/<hash>.<ext>");
+        return;
+    }
+    size_t count = 0;
+    try {
+        size_t used = 0;
+        unsigned long value = std::stoul(parts[0], &used);
+        if (used != parts[0].size()) throw std::invalid_argument("trailing characters");
+        count = static_cast<size_t>(value);
+    } catch (const std::exception&) {
+        count = 0;
+    }
+    if (count < 1 || count > MAX_REST_HEADERS) {
+        SetError(reply, 400, "Header count is invalid or out of acceptable range (1-" +
+                             std::to_string(MAX_REST_HEADERS) + "): " + parts[0]);
+        return;
+    }
+    Hash256 hash;
+    if (!ParseHash(parts[1], hash)) {
+        SetError(reply, 400, "Invalid hash: " + parts[1]);
+        return;
+    }
+
+    ChainStateManager* chainman = table.GetChainStateManager();
+    ChainState* chainState = table.GetChainState();
+    if (!chainman || !chainState) {
+        SetError(reply, 503, "Chain state not available");
+        return;
+    }
+
+    // Follow the active chain up from the named block
+    std::vector<const BlockIndex*> headers;
+    const Chain& chain = chainState->GetChain();
+    const BlockIndex* pindex = chainman->LookupBlockIndex(BlockHash(hash));
+    while (pindex && headers.size() < count) {
+        headers.push_back(pindex);
+        pindex = chain.Next(pindex);
+    }
+
+    if (format == RESTFormat::JSON) {
+        JSONValue::Array result;
+        for (const BlockIndex* index : headers) {
+            BlockHeader header = index->GetBlockHeader();
+            JSONValue::Object obj;
+            obj["hash"] = index->GetBlockHash().ToHex();
+            obj["height"] = static_cast<int64_t>(index->nHeight);
+            obj["version"] = static_cast<int64_t>(header.nVersion);
+            obj["previousblockhash"] = header.hashPrevBlock.ToHex();
+            obj["merkleroot"] = header.hashMerkleRoot.ToHex();
+            obj["time"] = static_cast<int64_t>(header.nTime);
+            char bits[9];
+            std::snprintf(bits, sizeof(bits), "%08x", header.nBits);
+            obj["bits"] = std::string(bits);
+            obj["nonce"] = static_cast<int64_t>(header.nNonce);
+            result.push_back(JSONValue(std::move(obj)));
+        }
+        SetJSON(reply, JSONValue(std::move(result)));
+        return;
+    }
+
+    DataStream ss;
+    for (const BlockIndex* index : headers) {
+        Serialize(ss, index->GetBlockHeader());
+    }
+    SetBytes(reply, format, std::vector<uint8_t>(ss.data(), ss.data() + ss.size()));
+}
+
+void RESTGetUTXOs(std::vector<std::string> parts, RESTFormat format,
+                  RPCCommandTable& table, HTTPReply& reply) {
+    bool checkMempool = !parts.empty() && parts[0] == "checkmempool";
+    if (checkMempool) {
+        parts.erase(parts.begin());
+    }
+    if (parts.empty() || (parts.size() == 1 && parts[0].empty())) {
+        SetError(reply, 400, "Error: empty request");
+        return;
+    }
+    if (parts.size() > MAX_REST_GETUTXOS) {
+        SetError(reply, 400, "Error: max outpoints exceeded (max: " +
+                             std::to_string(MAX_REST_GETUTXOS) + ", tried: " +
+                             std::to_string(parts.size()) + ")");
+        return;
+    }
+
+    std::vector<OutPoint> outpoints;
+    for (const std::string& part : parts) {
+        size_t dash = part.find('-');
+        Hash256 txid;
+        if (dash == std::string::npos || !ParseHash(part.substr(0, dash), txid)) {
+            SetError(reply, 400, "Parse error: " + part);
+            return;
+        }
+        try {
+            size_t used = 0;
+            unsigned long n = std::stoul(part.substr(dash + 1), &used);
+            if (used != part.size() - dash - 1 || n > std::numeric_limits<uint32_t>::max()) {
+                throw std::out_of_range("output index");
+            }
+            outpoints.emplace_back(TxHash(txid), static_cast<uint32_t>(n));
+        } catch (const std::exception&) {
+            SetError(reply, 400, "Parse error: " + part);
+            return;
+        }
+    }
+
+    ChainState* chainState = table.GetChainState();
+    Mempool* mempool = checkMempool ? table.GetMempool() : nullptr;
+    if (!chainState) {
+        SetError(reply, 503, "Chain state not available");
+        return;
+    }
+
+    std::vector<uint8_t> bitmap((outpoints.size() + 7) / 8, 0);
+    std::string bitmapString;
+    std::vector<Coin> found;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        const OutPoint& outpoint = outpoints[i];
+        std::optional<Coin> coin;
+        if (mempool && mempool->IsSpent(outpoint)) {
+            // Spent by an unconfirmed transaction
+        } else if (auto onChain = chainState->GetCoins().GetCoin(outpoint);
+                   onChain && !onChain->IsSpent()) {
+            coin = std::move(onChain);
+        } else if (mempool) {
+            TransactionRef tx = mempool->Get(outpoint.hash);
+            if (tx && outpoint.n < tx->vout.size()) {
+                coin = Coin(tx->vout[outpoint.n], MEMPOOL_HEIGHT, false);
+            }
+        }
+        bitmapString += coin ? '1' : '0';
+        if (coin) {
+            bitmap[i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+            found.push_back(std::move(*coin));
+        }
+    }
+
+    const BlockIndex* tip = chainState->GetChain().Tip();
+    int32_t height = tip ? tip->nHeight : -1;
+    BlockHash tipHash = tip ? tip->GetBlockHash() : BlockHash();
+
+    if (format == RESTFormat::JSON) {
+        JSONValue::Object result;
+        result["chainHeight"] = static_cast<int64_t>(height);
+        result["chaintipHash"] = tipHash.ToHex();
+        result["bitmap"] = bitmapString;
+        JSONValue::Array utxos;
+        for (const Coin& coin : found) {
+            JSONValue::Object obj;
+            obj["height"] = static_cast<int64_t>(coin.nHeight);
+            obj["value"] = FormatAmount(coin.out.nValue);
+            JSONValue::Object script;
+            script["hex"] = BytesToHex(coin.out.scriptPubKey.data(), coin.out.scriptPubKey.size());
+            obj["scriptPubKey"] = JSONValue(std::move(script));
+            utxos.push_back(JSONValue(std::move(obj)));
+        }
+        result["utxos"] = JSONValue(std::move(utxos));
+        SetJSON(reply, JSONValue(std::move(result)));
+        return;
+    }
+
+    // Tip height and hash, the bitmap, then each unspent output with the
+    // height it was created at
+    DataStream ss;
+    Serialize(ss, height);
+    Serialize(ss, tipHash);
+    Serialize(ss, bitmap);
+    WriteCompactSize(ss, found.size());
+    for (const Coin& coin : found) {
+        Serialize(ss, coin.nHeight);
+        Serialize(ss, coin.out);
+    }
+    SetBytes(reply, format, std::vector<uint8_t>(ss.data(), ss.data() + ss.size()));
+}
+
+} // namespace
+
+void HandleRESTRequest(const HTTPRequest& request, RPCCommandTable& table, HTTPReply& reply) {
+    std::string path;
+    RESTFormat format = RESTFormat::JSON;
+    const size_t prefixLen = std::char_traits<char>::length(REST_PATH_PREFIX);
+    if (request.target.compare(0, prefixLen, REST_PATH_PREFIX) != 0 ||
+        !ParseFormat(request.target.substr(prefixLen), path, format)) {
+        SetError(reply, 400, "Output format not found (available: bin, hex, json)");
+        return;
+    }
+
+    std::vector<std::string> parts = SplitPath(path);
+    std::string endpoint = parts.front();
+    parts.erase(parts.begin());
+    if (endpoint == "block") {
+        RESTBlock(parts, format, table, reply);
+    } else if (endpoint == "headers") {
+        RESTHeaders(parts, format, table, reply);
+    } else if (endpoint == "getutxos") {
+        RESTGetUTXOs(std::move(parts), format, table, reply);
+    } else {
+        SetError(reply, 404, "Unknown REST endpoint: " + endpoint);
+    }
+}
+
+void RegisterRESTHandlers(RPCServer& server, RPCCommandTable& table) {
+    server.RegisterHTTPHandler(REST_PATH_PREFIX, [&table](const HTTPRequest& request,
+                                                          HTTPReply& reply) {
+        HandleRESTRequest(request, table, reply);
+    });
+}
+
+void UnregisterRESTHandlers(RPCServer& server) {
+    server.UnregisterHTTPHandler(REST_PATH_PREFIX);
+}
+
+} // namespace rpc
+} // namespace shurium
@@ -3,7 +3,12 @@
 // MIT License
 
 #include <shurium/rpc/server.h>
+#include <shurium/rpc/jsonparser.h>
+#include <shurium/rpc/jsonwriter.h>
+#include <shurium/network/connection.h>
 #include <shurium/util/logging.h>
+#include <shurium/util/metrics.h>
+#include <shurium/util/trace.h>
 
 #include <algorithm>
 #include <cctype>
@@ -25,6 +30,7 @@
     using socket_t = SOCKET;
     #define INVALID_SOCKET_VALUE INVALID_SOCKET
     #define CLOSE_SOCKET closesocket
+    #define SEND_FLAGS 0
 #else
     #include <arpa/inet.h>
     #include <netinet/in.h>
@@ -37,6 +43,11 @@
     using socket_t = int;
     #define INVALID_SOCKET_VALUE (-1)
     #define CLOSE_SOCKET close
+    #ifdef MSG_NOSIGNAL
+        #define SEND_FLAGS MSG_NOSIGNAL
+    #else
+        #define SEND_FLAGS 0
+    #endif
 #endif
 
 namespace shurium {
@@ -51,6 +62,61 @@ const JSONValue::Array JSONValue::emptyArray_;
 const JSONValue::Object JSONValue::emptyObject_;
 const std::string JSONValue::emptyString_;
 
+// ============================================================================
+// HTTP Helpers
+// ============================================================================
+
+/// Largest request header block accepted
+static constexpr size_t MAX_HTTP_HEADER_SIZE = 64 * 1024;
+
+/// Body bytes per chunk of a chunked response
+static constexpr size_t HTTP_CHUNK_SIZE = 256 * 1024;
+
+/// Queued response bytes past which a streaming worker waits for the client
+static constexpr size_t RPC_STREAM_MAX_QUEUED = 4 * 1024 * 1024;
+
+/// Receive buffer reserved for a new connection
+static constexpr size_t RPC_SESSION_BUFFER_SIZE = 16 * 1024;
+
+/// Largest receive buffer kept for reuse when its connection closes
+static constexpr size_t RPC_POOLED_BUFFER_MAX = 1024 * 1024;
+
+/// Receive buffers kept for reuse
+static constexpr size_t RPC_BUFFER_POOL_SIZE = 64;
+
+/// Bytes of a response, ready for a connection's send queue
+static SendBuffer ToSendBuffer(const std::string& bytes) {
+    return std::make_shared<const std::vector<uint8_t>>(bytes.begin(), bytes.end());
+}
+
+/// Write all of data, looping over partial sends
+static bool SendAll(int socket, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(socket, data, len, SEND_FLAGS);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        len -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static const char* HTTPReason(int statusCode) {
+    switch (statusCode) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
 // ============================================================================
 // Security Helper Functions
 // ============================================================================
@@ -335,6 +401,12 @@ void JSONValue::Push(JSONValue&& value) {
 }
 
 std::string JSONValue::ToJSON(bool pretty, int indent) const {
+    if (!pretty) {
+        JSONWriter out;
+        out.Value(*this);
+        return out.Take();
+    }
+    
     std::ostringstream ss;
     std::string indentStr(indent * 2, ' ');
     std::string childIndent((indent + 1) * 2, ' ');
@@ -441,188 +513,9 @@ JSONValue JSONValue::Parse(const std::string& json) {
 }
 
 std::optional<JSONValue> JSONValue::TryParse(const std::string& json) {
-    size_t pos = 0;
-    
-    auto skipWhitespace = [&]() {
-        while (pos < json.size() && std::isspace(json[pos])) ++pos;
-    };
-    
-    std::function<std::optional<JSONValue>()> parseValue;
-    
-    auto parseString = [&]() -> std::optional<std::string> {
-        if (pos >= json.size() || json[pos] != '"') return std::nullopt;
-        ++pos;
-        
-        std::string result;
-        while (pos < json.size() && json[pos] != '"') {
-            if (json[pos] == '\\') {
-                if (++pos >= json.size()) return std::nullopt;
-                switch (json[pos]) {
-                    case '"': result += '"'; break;
-                    case '\\': result += '\\'; break;
-                    case '/': result += '/'; break;
-                    case 'b': result += '\b'; break;
-                    case 'f': result += '\f'; break;
-                    case 'n': result += '\n'; break;
-                    case 'r': result += '\r'; break;
-                    case 't': result += '\t'; break;
-                    case 'u': {
-                        if (pos + 4 >= json.size()) return std::nullopt;
-                        // Simplified: just skip \uXXXX
-                        pos += 4;
-                        result += '?';
-                        break;
-                    }
-                    default: return std::nullopt;
-                }
-            } else {
-                result += json[pos];
-            }
-            ++pos;
-        }
-        if (pos >= json.size()) return std::nullopt;
-        ++pos;  // Skip closing quote
-        return result;
-    };
-    
-    auto parseNumber = [&]() -> std::optional<JSONValue> {
-        size_t start = pos;
-        bool isFloat = false;
-        
-        if (json[pos] == '-') ++pos;
-        
-        while (pos < json.size() && std::isdigit(json[pos])) ++pos;
-        
-        if (pos < json.size() && json[pos] == '.') {
-            isFloat = true;
-            ++pos;
-            while (pos < json.size() && std::isdigit(json[pos])) ++pos;
-        }
-        
-        if (pos < json.size() && (json[pos] == 'e' || json[pos] == 'E')) {
-            isFloat = true;
-            ++pos;
-            if (pos < json.size() && (json[pos] == '+' || json[pos] == '-')) ++pos;
-            while (pos < json.size() && std::isdigit(json[pos])) ++pos;
-        }
-        
-        std::string numStr = json.substr(start, pos - start);
-        try {
-            if (isFloat) {
-                return JSONValue(std::stod(numStr));
-            } else {
-                return JSONValue(std::stoll(numStr));
-            }
-        } catch (...) {
-            return std::nullopt;
-        }
-    };
-    
-    auto parseArray = [&]() -> std::optional<JSONValue> {
-        if (pos >= json.size() || json[pos] != '[') return std::nullopt;
-        ++pos;
-        
-        Array arr;
-        skipWhitespace();
-        
-        if (pos < json.size() && json[pos] == ']') {
-            ++pos;
-            return JSONValue(arr);
-        }
-        
-        while (true) {
-            skipWhitespace();
-            auto val = parseValue();
-            if (!val) return std::nullopt;
-            arr.push_back(std::move(*val));
-            
-            skipWhitespace();
-            if (pos >= json.size()) return std::nullopt;
-            
-            if (json[pos] == ']') {
-                ++pos;
-                return JSONValue(std::move(arr));
-            }
-            if (json[pos] != ',') return std::nullopt;
-            ++pos;
-        }
-    };
-    
-    auto parseObject = [&]() -> std::optional<JSONValue> {
-        if (pos >= json.size() || json[pos] != '{') return std::nullopt;
-        ++pos;
-        
-        Object obj;
-        skipWhitespace();
-        
-        if (pos < json.size() && json[pos] == '}') {
-            ++pos;
-            return JSONValue(obj);
-        }
-        
-        while (true) {
-            skipWhitespace();
-            auto key = parseString();
-            if (!key) return std::nullopt;
-            
-            skipWhitespace();
-            if (pos >= json.size() || json[pos] != ':') return std::nullopt;
-            ++pos;
-            
-            skipWhitespace();
-            auto val = parseValue();
-            if (!val) return std::nullopt;
-            obj[*key] = std::move(*val);
-            
-            skipWhitespace();
-            if (pos >= json.size()) return std::nullopt;
-            
-            if (json[pos] == '}') {
-                ++pos;
-                return JSONValue(std::move(obj));
-            }
-            if (json[pos] != ',') return std::nullopt;
-            ++pos;
-        }
-    };
-    
-    parseValue = [&]() -> std::optional<JSONValue> {
-        skipWhitespace();
-        if (pos >= json.size()) return std::nullopt;
-        
-        char c = json[pos];
-        
-        if (c == 'n' && json.substr(pos, 4) == "null") {
-            pos += 4;
-            return JSONValue();
-        }
-        if (c == 't' && json.substr(pos, 4) == "true") {
-            pos += 4;
-            return JSONValue(true);
-        }
-        if (c == 'f' && json.substr(pos, 5) == "false") {
-            pos += 5;
-            return JSONValue(false);
-        }
-        if (c == '"') {
-            auto str = parseString();
-            if (!str) return std::nullopt;
-            return JSONValue(*str);
-        }
-        if (c == '[') return parseArray();
-        if (c == '{') return parseObject();
-        if (c == '-' || std::isdigit(c)) return parseNumber();
-        
-        return std::nullopt;
-    };
-    
-    auto result = parseValue();
-    if (!result) return std::nullopt;
-    
-    skipWhitespace();
-    if (pos != json.size()) return std::nullopt;  // Extra characters
-    
-    return result;
+    JSONDocument doc;
+    if (!doc.Parse(json)) return std::nullopt;
+    return doc.Root().ToValue();
 }
 
 // ============================================================================
@@ -669,23 +562,32 @@ std::string RPCRequest::ToJSON() const {
 }
 
 std::optional<RPCRequest> RPCRequest::Parse(const std::string& json) {
-    auto parsed = JSONValue::TryParse(json);
-    if (!parsed || !parsed->IsObject()) return std::nullopt;
-    
-    const auto& obj = *parsed;
+    JSONDocument doc;
+    if (!doc.Parse(json)) return std::nullopt;
+    return FromNode(doc.Root());
+}
+
+std::optional<RPCRequest> RPCRequest::FromNode(const JSONNode& node) {
+    if (!node.IsObject()) return std::nullopt;
     
     // Check JSON-RPC version
-    if (!obj["jsonrpc"].IsString() || obj["jsonrpc"].GetString() != "2.0") {
+    const JSONNode* version = node.Find("jsonrpc");
+    if (!version || !version->IsString() || version->text != "2.0") {
         return std::nullopt;
     }
     
     // Method is required
-    if (!obj["method"].IsString()) return std::nullopt;
+    const JSONNode* method = node.Find("method");
+    if (!method || !method->IsString()) return std::nullopt;
     
     RPCRequest req;
-    req.method_ = obj["method"].GetString();
-    req.params_ = obj["params"];
-    req.id_ = obj["id"];
+    req.method_ = std::string(method->text);
+    if (const JSONNode* params = node.Find("params")) {
+        req.params_ = params->ToValue();
+    }
+    if (const JSONNode* id = node.Find("id")) {
+        req.id_ = id->ToValue();
+    }
     
     return req;
 }
@@ -693,21 +595,21 @@ std::optional<RPCRequest> RPCRequest::Parse(const std::string& json) {
 std::vector<RPCRequest> RPCRequest::ParseBatch(const std::string& json) {
     std::vector<RPCRequest> results;
     
-    auto parsed = JSONValue::TryParse(json);
-    if (!parsed) return results;
+    // One parse for the whole batch; each request is built from its node
+    JSONDocument doc;
+    if (!doc.Parse(json)) return results;
     
-    if (parsed->IsArray()) {
-        for (size_t i = 0; i < parsed->Size(); ++i) {
-            const auto& item = (*parsed)[i];
-            if (item.IsObject()) {
-                auto req = Parse(item.ToJSON());
-                if (req) {
-                    results.push_back(std::move(*req));
-                }
+    const JSONNode& root = doc.Root();
+    if (root.IsArray()) {
+        results.reserve(root.size);
+        for (const auto& item : root) {
+            auto req = FromNode(item);
+            if (req) {
+                results.push_back(std::move(*req));
             }
         }
-    } else if (parsed->IsObject()) {
-        auto req = Parse(json);
+    } else {
+        auto req = FromNode(root);
         if (req) {
             results.push_back(std::move(*req));
         }
@@ -739,36 +641,72 @@ RPCResponse RPCResponse::Error(int code, const std::string& message,
     return resp;
 }
 
+RPCResponse RPCResponse::Streamed(ResultWriter writer, const JSONValue& id) {
+    RPCResponse resp;
+    resp.isError_ = false;
+    resp.resultWriter_ = std::move(writer);
+    resp.id_ = id;
+    return resp;
+}
+
+const JSONValue& RPCResponse::GetResult() const {
+    if (resultWriter_ && !resultBuilt_) {
+        JSONWriter out;
+        resultWriter_(out);
+        result_ = JSONValue::Parse(out.Take());
+        resultBuilt_ = true;
+    }
+    return result_;
+}
+
 std::string RPCResponse::ToJSON() const {
-    JSONValue::Object obj;
-    obj["jsonrpc"] = "2.0";
-    
+    JSONWriter out;
+    WriteJSON(out);
+    return out.Take();
+}
+
+void RPCResponse::WriteJSON(JSONWriter& out) const {
+    // Members in the sorted order the map-backed serializer always produced
+    out.BeginObject();
     if (isError_) {
-        JSONValue::Object error;
-        error["code"] = errorCode_;
-        error["message"] = errorMessage_;
+        out.Key("error").BeginObject();
+        out.Member("code", errorCode_);
         if (!errorData_.IsNull()) {
-            error["data"] = errorData_;
+            out.Member("data", errorData_);
         }
-        obj["error"] = error;
-    } else {
-        obj["result"] = result_;
+        out.Member("message", errorMessage_);
+        out.EndObject();
     }
-    
-    obj["id"] = id_;
-    
-    return JSONValue(obj).ToJSON();
+    out.Member("id", id_);
+    out.Member("jsonrpc", "2.0");
+    if (!isError_) {
+        out.Key("result");
+        if (resultWriter_) {
+            resultWriter_(out);
+        } else {
+            out.Value(result_);
+        }
+    }
+    out.EndObject();
 }
 
 std::string RPCResponse::BatchToJSON(const std::vector<RPCResponse>& responses) {
-    if (responses.empty()) return "[]";
-    if (responses.size() == 1) return responses[0].ToJSON();
+    JSONWriter out;
+    WriteBatchJSON(responses, out);
+    return out.Take();
+}
+
+void RPCResponse::WriteBatchJSON(const std::vector<RPCResponse>& responses, JSONWriter& out) {
+    if (responses.size() == 1) {
+        responses[0].WriteJSON(out);
+        return;
+    }
     
-    JSONValue::Array arr;
+    out.BeginArray();
     for (const auto& resp : responses) {
-        arr.push_back(JSONValue::Parse(resp.ToJSON()));
+        resp.WriteJSON(out);
     }
-    return JSONValue(arr).ToJSON();
+    out.EndArray();
 }
 
 // ============================================================================
@@ -794,52 +732,33 @@ void RPCServer::SetConfig(const RPCServerConfig& config) {
 bool RPCServer::Start() {
     if (running_.load()) return true;
     
-    // Create socket
-    serverSocket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (serverSocket_ == INVALID_SOCKET_VALUE) {
-        LOG_ERROR(util::LogCategory::RPC) << "Failed to create socket";
-        return false;
-    }
-    
-    // Set socket options
-    int opt = 1;
-#ifdef _WIN32
-    setsockopt(serverSocket_, SOL_SOCKET, SO_REUSEADDR, 
-               reinterpret_cast<const char*>(&opt), sizeof(opt));
-#else
-    setsockopt(serverSocket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-#endif
-    
-    // Bind
-    struct sockaddr_in addr;
-    std::memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(config_.port);
-    
-    if (config_.bindAddress == "0.0.0.0" || config_.bindAddress.empty()) {
-        addr.sin_addr.s_addr = INADDR_ANY;
-    } else {
-        inet_pton(AF_INET, config_.bindAddress.c_str(), &addr.sin_addr);
+    NetAddress bindAddr;
+    if (!config_.bindAddress.empty()) {
+        auto parsed = NetAddress::FromString(config_.bindAddress);
+        if (!parsed) {
+            LOG_ERROR(util::LogCategory::RPC) << "Invalid bind address " << config_.bindAddress;
+            return false;
+        }
+        bindAddr = *parsed;
     }
     
-    if (bind(serverSocket_, reinterpret_cast<struct sockaddr*>(&addr), 
-             sizeof(addr)) < 0) {
+    // Listen
+    listener_ = Listener::Create(bindAddr, config_.port);
+    if (!listener_->Start(static_cast<int>(config_.maxConnections))) {
         LOG_ERROR(util::LogCategory::RPC) << "Failed to bind to " 
             << config_.bindAddress << ":" << config_.port;
-        CLOSE_SOCKET(serverSocket_);
-        serverSocket_ = INVALID_SOCKET_VALUE;
+        listener_.reset();
         return false;
     }
     
-    // Listen
-    if (listen(serverSocket_, static_cast<int>(config_.maxConnections)) < 0) {
-        LOG_ERROR(util::LogCategory::RPC) << "Failed to listen on socket";
-        CLOSE_SOCKET(serverSocket_);
-        serverSocket_ = INVALID_SOCKET_VALUE;
-        return false;
-    }
+    eventLoop_ = std::make_unique<EventLoop>();
+    listener_->SetAcceptCallback([this](std::unique_ptr<Connection> conn) {
+        AcceptConnection(std::move(conn));
+    });
+    eventLoop_->AddListener(listener_.get());
     
-    // Create thread pool for handling connections
+    // Create thread pool for executing requests; its queue holds complete
+    // requests only, so it needs no room for idle connections
     util::ThreadPool::Config poolConfig;
     poolConfig.numThreads = config_.threadPoolSize > 0 ? config_.threadPoolSize : 4;
     poolConfig.maxQueueSize = config_.maxConnections;
@@ -865,13 +784,7 @@ void RPCServer::Stop() {
     
     running_.store(false);
     
-    // Close server socket to interrupt accept()
-    if (serverSocket_ != INVALID_SOCKET_VALUE) {
-        CLOSE_SOCKET(serverSocket_);
-        serverSocket_ = INVALID_SOCKET_VALUE;
-    }
-    
-    // Wait for HTTP thread to finish
+    // The event loop thread closes every connection on its way out
     if (httpThread_.joinable()) {
         httpThread_.join();
     }
@@ -883,6 +796,10 @@ void RPCServer::Stop() {
         threadPool_.reset();
     }
     
+    // Workers are done posting to the loop; drop it and what they posted
+    eventLoop_.reset();
+    listener_.reset();
+    
     LOG_INFO(util::LogCategory::RPC) << "RPC server stopped";
 }
 
@@ -935,6 +852,10 @@ std::vector<RPCMethod> RPCServer::GetMethodsByCategory(const std::string& catego
 }
 
 RPCResponse RPCServer::HandleRequest(const RPCRequest& request, const RPCContext& context) {
+    static util::Histogram& latency = util::MetricsRegistry::Instance().GetHistogram(
+        "shurium_rpc_request_duration_microseconds", "Time to answer a JSON-RPC request");
+    util::ScopedLatency timer(latency);
+    SHURIUM_TRACE_SPAN("RPCServer::HandleRequest");
     ++totalRequests_;
     
     // Find method
@@ -959,130 +880,437 @@ RPCResponse RPCServer::HandleRequest(const RPCRequest& request, const RPCContext
                                  "Authentication required", request.GetId());
     }
     
+    // Answer cacheable methods from the response cache while still valid
+    const RPCCachePolicy& policy = method->cache;
+    bool cacheable = policy.ttl.count() > 0 && config_.responseCacheSize > 0;
+    std::string cacheKey;
+    uint64_t generation = 0;
+    if (cacheable) {
+        cacheKey = request.GetMethod() + '\n' + request.GetParams().ToJSON();
+        generation = policy.generation ? policy.generation() : 0;
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        auto it = responseCache_.find(cacheKey);
+        if (it != responseCache_.end() && it->second.generation == generation &&
+            now < it->second.expires) {
+            ++cacheHits_;
+            return RPCResponse::Success(it->second.result, request.GetId());
+        }
+        ++cacheMisses_;
+    }
+    
     // Call handler
+    RPCResponse response;
     try {
-        return method->handler(request, context);
+        response = method->handler(request, context);
     } catch (const std::exception& e) {
         ++totalErrors_;
         return InternalError(e.what(), request.GetId());
     }
+    if (response.IsError()) return response;
+    
+    if (cacheable) {
+        CachedResponse entry;
+        entry.result = response.GetResult();
+        entry.category = method->category;
+        entry.generation = generation;
+        entry.expires = std::chrono::steady_clock::now() + policy.ttl;
+        
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        if (responseCache_.size() >= config_.responseCacheSize &&
+            responseCache_.find(cacheKey) == responseCache_.end()) {
+            // Full: drop what has expired, or everything if nothing has
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = responseCache_.begin(); it != responseCache_.end();) {
+                it = now >= it->second.expires ? responseCache_.erase(it) : std::next(it);
+            }
+            if (responseCache_.size() >= config_.responseCacheSize) {
+                responseCache_.clear();
+            }
+        }
+        responseCache_[cacheKey] = std::move(entry);
+    } else if (!method->readOnly) {
+        // A write may change what its category's queries return
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        for (auto it = responseCache_.begin(); it != responseCache_.end();) {
+            it = it->second.category == method->category ? responseCache_.erase(it) : std::next(it);
+        }
+    }
+    return response;
+}
+
+double RPCServer::GetCacheHitRate() const {
+    uint64_t hits = cacheHits_.load();
+    uint64_t total = hits + cacheMisses_.load();
+    return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+}
+
+size_t RPCServer::GetCacheSize() const {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return responseCache_.size();
+}
+
+void RPCServer::ClearResponseCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    responseCache_.clear();
 }
 
 std::string RPCServer::HandleRawRequest(const std::string& json, const RPCContext& context) {
+    JSONWriter out;
+    HandleRawRequest(json, context, out);
+    return out.Take();
+}
+
+void RPCServer::HandleRawRequest(const std::string& json, const RPCContext& context,
+                                 JSONWriter& out) {
     // Check rate limit
     if (config_.enableRateLimiting && !CheckRateLimit(context.clientAddress)) {
-        return RPCResponse::Error(ErrorCode::RATE_LIMITED, 
-                                 "Rate limit exceeded", JSONValue()).ToJSON();
+        RPCResponse::Error(ErrorCode::RATE_LIMITED, 
+                           "Rate limit exceeded", JSONValue()).WriteJSON(out);
+        return;
     }
     
     // Try to parse as batch
-    auto parsed = JSONValue::TryParse(json);
-    if (!parsed) {
-        return ParseError().ToJSON();
+    JSONDocument doc;
+    if (!doc.Parse(json)) {
+        ParseError().WriteJSON(out);
+        return;
     }
     
-    if (parsed->IsArray()) {
-        // Batch request
+    const JSONNode& root = doc.Root();
+    if (root.IsArray()) {
+        // Batch request. Consecutive read-only calls run concurrently; any
+        // other call waits for the ones before it and runs alone, so writes
+        // keep their order relative to everything else.
+        std::vector<std::optional<RPCRequest>> requests;
+        requests.reserve(root.size);
+        for (const auto& item : root) {
+            requests.push_back(RPCRequest::FromNode(item));
+        }
+        
+        std::vector<bool> readOnly(requests.size(), false);
+        {
+            std::lock_guard<std::mutex> lock(methodsMutex_);
+            for (size_t i = 0; i < requests.size(); ++i) {
+                if (!requests[i]) continue;
+                auto it = methods_.find(requests[i]->GetMethod());
+                readOnly[i] = it != methods_.end() && it->second.readOnly;
+            }
+        }
+        
+        std::vector<RPCResponse> results(requests.size());
+        for (size_t i = 0; i < requests.size();) {
+            size_t runEnd = i;
+            while (runEnd < requests.size() && readOnly[runEnd]) ++runEnd;
+            if (runEnd - i > 1) {
+                RunReadOnlyBatch(requests, results, i, runEnd, context);
+                i = runEnd;
+                continue;
+            }
+            results[i] = requests[i] ? HandleRequest(*requests[i], context) : InvalidRequest();
+            ++i;
+        }
+        
+        // Answers in request order; notifications are processed but get none
         std::vector<RPCResponse> responses;
-        for (size_t i = 0; i < parsed->Size(); ++i) {
-            const auto& item = (*parsed)[i];
-            auto req = RPCRequest::Parse(item.ToJSON());
-            if (req) {
-                if (!req->IsNotification()) {
-                    responses.push_back(HandleRequest(*req, context));
-                } else {
-                    HandleRequest(*req, context);  // Process but don't respond
-                }
-            } else {
-                responses.push_back(InvalidRequest());
+        responses.reserve(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (!requests[i] || !requests[i]->IsNotification()) {
+                responses.push_back(std::move(results[i]));
             }
         }
-        return RPCResponse::BatchToJSON(responses);
+        RPCResponse::WriteBatchJSON(responses, out);
     } else {
         // Single request
-        auto req = RPCRequest::Parse(json);
+        auto req = RPCRequest::FromNode(root);
         if (!req) {
-            return InvalidRequest().ToJSON();
+            InvalidRequest().WriteJSON(out);
+            return;
         }
         if (req->IsNotification()) {
             HandleRequest(*req, context);
-            return "";  // No response for notifications
+            return;  // No response for notifications
         }
-        return HandleRequest(*req, context).ToJSON();
+        HandleRequest(*req, context).WriteJSON(out);
     }
 }
 
+void RPCServer::RunReadOnlyBatch(const std::vector<std::optional<RPCRequest>>& requests,
+                                 std::vector<RPCResponse>& responses, size_t begin, size_t end,
+                                 const RPCContext& context) {
+    // Entries are claimed one at a time. A helper that starts after every
+    // entry is claimed returns without touching the batch, so the caller
+    // only waits for claimed entries, never for queued helpers.
+    struct Run {
+        std::atomic<size_t> next;
+        size_t end;
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+    };
+    auto run = std::make_shared<Run>();
+    run->next = begin;
+    run->end = end;
+    run->remaining = end - begin;
+    
+    auto work = [this, run, &requests, &responses, &context]() {
+        size_t i;
+        while ((i = run->next.fetch_add(1)) < run->end) {
+            responses[i] = HandleRequest(*requests[i], context);
+            std::lock_guard<std::mutex> lock(run->mutex);
+            if (--run->remaining == 0) run->done.notify_all();
+        }
+    };
+    
+    if (threadPool_) {
+        size_t helpers = std::min(end - begin - 1, threadPool_->ThreadCount());
+        for (size_t h = 0; h < helpers; ++h) {
+            if (!threadPool_->TrySubmit(work)) break;
+        }
+    }
+    work();
+    
+    std::unique_lock<std::mutex> lock(run->mutex);
+    run->done.wait(lock, [&run]() { return run->remaining == 0; });
+}
+
 int64_t RPCServer::GetUptime() const {
     auto now = std::chrono::steady_clock::now();
     return std::chrono::duration_cast<std::chrono::seconds>(now - startTime_).count();
 }
 
+// ============================================================================
+// HTTP Front End
+// ============================================================================
+
+struct RPCServer::HTTPSession {
+    std::unique_ptr<Connection> conn;
+    
+    /// Received bytes not yet taken as requests
+    std::string buffer;
+    
+    /// Who is asking stays the same for every request on the connection
+    RPCContext baseContext;
+    
+    bool busy{false};      ///< A request is with the workers
+    bool waiting{false};   ///< A complete request waits for room in the pool
+    bool closing{false};   ///< Close once the last response has gone out
+    size_t served{0};
+    
+    std::chrono::steady_clock::time_point lastActivity;
+    std::chrono::steady_clock::time_point requestStart;   ///< First byte of buffer
+};
+
 void RPCServer::HTTPServerThread() {
     while (running_.load()) {
-        struct sockaddr_in clientAddr;
-        socklen_t clientLen = sizeof(clientAddr);
-        
-        int clientSocket = accept(serverSocket_, 
-                                  reinterpret_cast<struct sockaddr*>(&clientAddr),
-                                  &clientLen);
-        
-        if (clientSocket < 0) {
-            if (running_.load()) {
-                LOG_WARN(util::LogCategory::RPC) << "Accept failed";
-            }
-            continue;
-        }
-        
-        // Submit connection handling to thread pool
-        if (threadPool_ && !threadPool_->TrySubmit([this, clientSocket]() {
-            HandleConnection(clientSocket);
-        })) {
-            // Thread pool queue is full - reject the connection
-            LOG_WARN(util::LogCategory::RPC) << "Thread pool queue full, rejecting connection";
-            std::string response = BuildHTTPResponse(503, 
-                R"({"jsonrpc":"2.0","error":{"code":-32010,"message":"Server busy"},"id":null})",
-                "application/json");
-            send(clientSocket, response.c_str(), response.size(), 0);
-            CLOSE_SOCKET(clientSocket);
-        }
+        eventLoop_->Poll(100);
+        SweepSessions();
+    }
+    
+    eventLoop_->RemoveListener(listener_.get());
+    listener_->Stop();
+    
+    // Sessions still with a worker stay alive through the worker's reference
+    std::vector<Connection*> open;
+    open.reserve(sessions_.size());
+    for (const auto& entry : sessions_) {
+        open.push_back(entry.first);
+    }
+    for (Connection* conn : open) {
+        CloseSession(conn);
     }
+    waitingForWorker_.clear();
 }
 
-void RPCServer::HandleConnection(int clientSocket) {
-    ++activeConnections_;
+void RPCServer::AcceptConnection(std::unique_ptr<Connection> conn) {
+    if (sessions_.size() >= config_.maxConnections) {
+        LOG_WARN(util::LogCategory::RPC) << "Too many RPC connections, rejecting "
+            << conn->GetRemoteAddress().ToString();
+        std::string response = BuildHTTPResponse(503, 
+            R"({"jsonrpc":"2.0","error":{"code":-32010,"message":"Server busy"},"id":null})",
+            "application/json");
+        SendAll(conn->GetSocket(), response.data(), response.size());
+        conn->Close(false);
+        return;
+    }
     
-    // Read request
-    std::string buffer;
-    buffer.resize(config_.maxRequestSize);
+    auto session = std::make_shared<HTTPSession>();
+    session->conn = std::move(conn);
+    if (!bufferPool_.empty()) {
+        session->buffer = std::move(bufferPool_.back());
+        bufferPool_.pop_back();
+    } else {
+        session->buffer.reserve(RPC_SESSION_BUFFER_SIZE);
+    }
+    
+    const NetService& remote = session->conn->GetRemoteAddress();
+    session->baseContext.clientAddress = static_cast<const NetAddress&>(remote).ToString();
+    session->baseContext.isLocal = remote.IsLocal();
+    session->lastActivity = std::chrono::steady_clock::now();
+    
+    Connection* raw = session->conn.get();
+    raw->SetDataCallback([this](Connection& c, const uint8_t* data, size_t len) {
+        auto it = sessions_.find(&c);
+        if (it == sessions_.end() || it->second->closing) return;
+        HTTPSession& s = *it->second;
+        s.lastActivity = std::chrono::steady_clock::now();
+        if (s.buffer.empty()) {
+            s.requestStart = s.lastActivity;
+        }
+        // Pipelined requests pile up here while one is served; past what
+        // one request may take, the client is not waiting for answers
+        if (s.buffer.size() + len > config_.maxRequestSize + MAX_HTTP_HEADER_SIZE) {
+            s.buffer.clear();
+            s.closing = true;
+            return;
+        }
+        s.buffer.append(reinterpret_cast<const char*>(data), len);
+    });
+    raw->SetEventCallback([this](Connection& c, ConnEvent event) {
+        if (event != ConnEvent::DATA_RECEIVED) return;
+        auto it = sessions_.find(&c);
+        if (it != sessions_.end()) {
+            DispatchRequest(it->second);
+        }
+    });
     
-    ssize_t bytesRead = recv(clientSocket, buffer.data(), buffer.size() - 1, 0);
-    if (bytesRead <= 0) {
-        CLOSE_SOCKET(clientSocket);
-        --activeConnections_;
+    sessions_[raw] = session;
+    ++activeConnections_;
+    ++totalConnections_;
+    eventLoop_->AddConnection(raw);
+}
+
+void RPCServer::DispatchRequest(const std::shared_ptr<HTTPSession>& session) {
+    if (session->busy || session->waiting || session->closing || !running_.load()) {
         return;
     }
-    buffer.resize(bytesRead);
     
-    // Parse HTTP request
-    std::string body;
-    std::map<std::string, std::string> headers;
-    if (!ParseHTTPRequest(buffer, body, headers)) {
-        std::string response = BuildHTTPResponse(400, "Bad Request", "text/plain");
-        send(clientSocket, response.c_str(), response.size(), 0);
-        CLOSE_SOCKET(clientSocket);
-        --activeConnections_;
+    HTTPRequest request;
+    size_t consumed = 0;
+    HTTPFrameResult framed = FrameHTTPRequest(session->buffer, config_.maxRequestSize,
+                                              request, consumed);
+    if (framed == HTTPFrameResult::INCOMPLETE) {
+        return;
+    }
+    if (framed != HTTPFrameResult::COMPLETE) {
+        bool tooLarge = framed == HTTPFrameResult::TOO_LARGE;
+        SendHTTPResponse(*session->conn, tooLarge ? 413 : 400,
+                         tooLarge ? "Payload Too Large" : "Bad Request",
+                         false, false, "text/plain");
+        session->buffer.clear();
+        session->closing = true;
         return;
     }
     
-    // Build context
-    RPCContext ctx;
-    char addrStr[INET_ADDRSTRLEN];
-    struct sockaddr_in addr;
-    socklen_t addrLen = sizeof(addr);
-    getpeername(clientSocket, reinterpret_cast<struct sockaddr*>(&addr), &addrLen);
-    inet_ntop(AF_INET, &addr.sin_addr, addrStr, sizeof(addrStr));
-    ctx.clientAddress = addrStr;
-    ctx.isLocal = (ctx.clientAddress == "127.0.0.1" || ctx.clientAddress == "::1");
+    bool keepAlive = request.keepAlive &&
+                     (config_.maxRequestsPerConnection == 0 ||
+                      session->served + 1 < config_.maxRequestsPerConnection);
+    bool submitted = threadPool_->TrySubmit([this, session, request, keepAlive]() {
+        bool keep = keepAlive;
+        ServeHTTPRequest(*session->conn, request, session->baseContext, keep);
+        eventLoop_->Post([this, session, keep]() { OnResponseQueued(session, keep); });
+    });
+    if (!submitted) {
+        // Every worker is busy and the queue is full; the request stays in
+        // the buffer until a worker frees up
+        session->waiting = true;
+        waitingForWorker_.push_back(session);
+        return;
+    }
+    
+    session->buffer.erase(0, consumed);
+    session->requestStart = std::chrono::steady_clock::now();
+    session->busy = true;
+    ++session->served;
+}
+
+void RPCServer::OnResponseQueued(const std::shared_ptr<HTTPSession>& session, bool keepAlive) {
+    session->busy = false;
+    session->lastActivity = std::chrono::steady_clock::now();
+    if (!keepAlive) {
+        session->closing = true;
+    } else if (sessions_.count(session->conn.get())) {
+        // The next pipelined request, if it is all there
+        DispatchRequest(session);
+    }
+    
+    // A worker is free: requests that found the pool full go next, in order
+    while (!waitingForWorker_.empty()) {
+        auto next = waitingForWorker_.front();
+        waitingForWorker_.pop_front();
+        next->waiting = false;
+        DispatchRequest(next);
+        if (next->waiting) {
+            break;
+        }
+    }
+}
+
+void RPCServer::SweepSessions() {
+    auto now = std::chrono::steady_clock::now();
+    auto keepAlive = std::chrono::seconds(config_.keepAliveTimeout);
+    auto requestTimeout = std::chrono::seconds(config_.requestTimeout);
+    
+    std::vector<Connection*> finished;
+    for (const auto& [conn, session] : sessions_) {
+        if (session->busy) {
+            continue;
+        }
+        bool unsent = conn->GetSendBufferSize() > 0;
+        bool done;
+        if (!conn->IsActive()) {
+            done = true;
+        } else if (session->closing) {
+            // Give a client that stopped reading as long as a request takes
+            done = !unsent || now - session->lastActivity > requestTimeout;
+        } else if (session->buffer.empty()) {
+            done = !unsent && now - session->lastActivity > keepAlive;
+        } else {
+            // Part of a request, or a whole one waiting for a worker
+            done = !session->waiting && now - session->requestStart > requestTimeout;
+        }
+        if (done) {
+            finished.push_back(conn);
+        }
+    }
+    for (Connection* conn : finished) {
+        CloseSession(conn);
+    }
+}
+
+void RPCServer::CloseSession(Connection* conn) {
+    auto it = sessions_.find(conn);
+    if (it == sessions_.end()) return;
+    std::shared_ptr<HTTPSession> session = it->second;
+    sessions_.erase(it);
+    
+    eventLoop_->RemoveConnection(conn);
+    conn->Close(true);
+    if (session->waiting) {
+        auto& queue = waitingForWorker_;
+        queue.erase(std::remove(queue.begin(), queue.end(), session), queue.end());
+        session->waiting = false;
+    }
+    
+    // Keep modest buffers for the next connections
+    if (session->buffer.capacity() <= RPC_POOLED_BUFFER_MAX &&
+        bufferPool_.size() < RPC_BUFFER_POOL_SIZE) {
+        session->buffer.clear();
+        bufferPool_.push_back(std::move(session->buffer));
+    }
+    --activeConnections_;
+}
+
+void RPCServer::ServeHTTPRequest(Connection& conn, const HTTPRequest& request,
+                                 const RPCContext& baseContext, bool& keepAlive) {
+    RPCContext ctx = baseContext;
+    
+    if (request.method == "GET") {
+        if (HTTPHandler handler = FindHTTPHandler(request.target)) {
+            ServeHTTPHandler(conn, request, handler, ctx, keepAlive);
+            return;
+        }
+    }
     
     // Check authentication
     if (!config_.rpcUser.empty()) {
@@ -1090,19 +1318,14 @@ void RPCServer::HandleConnection(int clientSocket) {
         if (IsLockedOut(ctx.clientAddress)) {
             LOG_WARN(util::LogCategory::RPC) << "RPC: Rejected request from locked out IP: " 
                 << ctx.clientAddress;
-            std::string response = "HTTP/1.1 403 Forbidden\r\n"
-                      "Content-Type: application/json\r\n"
-                      "Content-Length: " + std::to_string(
-                          strlen(R"({"jsonrpc":"2.0","error":{"code":-32011,"message":"Too many failed login attempts. Try again later."},"id":null})")) + 
-                      "\r\n\r\n"
-                      R"({"jsonrpc":"2.0","error":{"code":-32011,"message":"Too many failed login attempts. Try again later."},"id":null})";
-            send(clientSocket, response.c_str(), response.size(), 0);
-            CLOSE_SOCKET(clientSocket);
-            --activeConnections_;
+            keepAlive = false;
+            SendHTTPResponse(conn, 403,
+                R"({"jsonrpc":"2.0","error":{"code":-32011,"message":"Too many failed login attempts. Try again later."},"id":null})",
+                false, false);
             return;
         }
         
-        if (!Authenticate(headers, ctx.username)) {
+        if (!Authenticate(request.headers, ctx.username)) {
             // Record the failed login attempt
             bool nowLocked = RecordFailedLogin(ctx.clientAddress);
             
@@ -1113,11 +1336,11 @@ void RPCServer::HandleConnection(int clientSocket) {
             std::string response = "HTTP/1.1 401 Unauthorized\r\n"
                       "WWW-Authenticate: Basic realm=\"SHURIUM RPC\"\r\n"
                       "Content-Type: application/json\r\n"
-                      "Content-Length: " + std::to_string(errorMsg.size()) + 
-                      "\r\n\r\n" + errorMsg;
-            send(clientSocket, response.c_str(), response.size(), 0);
-            CLOSE_SOCKET(clientSocket);
-            --activeConnections_;
+                      "Content-Length: " + std::to_string(errorMsg.size()) + "\r\n"
+                      "Connection: close\r\n"
+                      "\r\n" + errorMsg;
+            keepAlive = false;
+            conn.Send(ToSendBuffer(response));
             return;
         }
         
@@ -1131,39 +1354,205 @@ void RPCServer::HandleConnection(int clientSocket) {
         }
     }
     
-    // Handle RPC request
-    std::string result = HandleRawRequest(body, ctx);
+    // HTTP/1.0 clients need a Content-Length, so their responses are buffered
+    if (request.versionMinor < 1) {
+        SendHTTPResponse(conn, 200, HandleRawRequest(request.body, ctx), keepAlive, false);
+        return;
+    }
     
-    // Send response
-    std::string response = BuildHTTPResponse(200, result);
-    send(clientSocket, response.c_str(), response.size(), 0);
+    // Stream the response: once it outgrows the chunked threshold, each
+    // flush of the writer goes out as one chunk, so a large result is never
+    // held in memory whole. A worker that gets ahead of a slow client waits
+    // for the connection to drain rather than queueing without bound.
+    bool chunked = false;
+    auto sendChunk = [&](const char* data, size_t size) {
+        if (!chunked) {
+            std::ostringstream header;
+            header << "HTTP/1.1 200 OK\r\n"
+                   << "Content-Type: application/json\r\n"
+                   << "Transfer-Encoding: chunked\r\n"
+                   << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n"
+                   << "\r\n";
+            conn.Send(ToSendBuffer(header.str()));
+            chunked = true;
+        }
+        while (conn.GetSendBufferSize() > RPC_STREAM_MAX_QUEUED && conn.IsActive() &&
+               running_.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::ostringstream chunk;
+        chunk << std::hex << size << "\r\n";
+        chunk.write(data, static_cast<std::streamsize>(size));
+        chunk << "\r\n";
+        conn.Send(ToSendBuffer(chunk.str()));
+    };
     
-    CLOSE_SOCKET(clientSocket);
-    --activeConnections_;
+    JSONWriter out(sendChunk, config_.chunkedResponseThreshold + 1);
+    try {
+        HandleRawRequest(request.body, ctx, out);
+    } catch (const std::exception& e) {
+        // A streamed result failed while being written
+        ++totalErrors_;
+        keepAlive = false;
+        if (!chunked) {
+            SendHTTPResponse(conn, 500, InternalError(e.what(), JSONValue()).ToJSON(),
+                             false, false);
+        }
+        // Otherwise the missing terminating chunk tells the client the
+        // response is incomplete
+        return;
+    }
+    
+    if (!chunked) {
+        // Small enough to have stayed buffered
+        SendHTTPResponse(conn, 200, out.Take(), keepAlive, false);
+        return;
+    }
+    out.Flush();
+    conn.Send(ToSendBuffer("0\r\n\r\n"));
+}
+
+void RPCServer::RegisterHTTPHandler(const std::string& prefix, HTTPHandler handler) {
+    std::lock_guard<std::mutex> lock(httpHandlersMutex_);
+    for (auto& [registered, existing] : httpHandlers_) {
+        if (registered == prefix) {
+            existing = std::move(handler);
+            return;
+        }
+    }
+    httpHandlers_.emplace_back(prefix, std::move(handler));
+}
+
+void RPCServer::UnregisterHTTPHandler(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(httpHandlersMutex_);
+    httpHandlers_.erase(std::remove_if(httpHandlers_.begin(), httpHandlers_.end(),
+                                       [&](const auto& entry) { return entry.first == prefix; }),
+                        httpHandlers_.end());
 }
 
-bool RPCServer::ParseHTTPRequest(const std::string& raw, std::string& body,
-                                 std::map<std::string, std::string>& headers) {
+HTTPHandler RPCServer::FindHTTPHandler(const std::string& target) const {
+    std::lock_guard<std::mutex> lock(httpHandlersMutex_);
+    for (const auto& [prefix, handler] : httpHandlers_) {
+        if (target.compare(0, prefix.size(), prefix) == 0) {
+            return handler;
+        }
+    }
+    return nullptr;
+}
+
+void RPCServer::ServeHTTPHandler(Connection& conn, const HTTPRequest& request,
+                                 const HTTPHandler& handler, const RPCContext& context,
+                                 bool keepAlive) {
+    ++totalRequests_;
+    HTTPReply reply;
+    if (config_.enableRateLimiting && !CheckRateLimit(context.clientAddress)) {
+        reply.SetBody(429, "text/plain", "Rate limit exceeded\r\n");
+    } else {
+        try {
+            handler(request, reply);
+        } catch (const std::exception& e) {
+            reply.SetBody(500, "text/plain", std::string(e.what()) + "\r\n");
+        }
+    }
+    if (reply.status != 200) {
+        ++totalErrors_;
+    }
+
+    // The body is queued as it is, without another copy
+    std::ostringstream header;
+    header << "HTTP/1.1 " << reply.status << " " << HTTPReason(reply.status) << "\r\n"
+           << "Content-Type: " << reply.contentType << "\r\n"
+           << "Content-Length: " << reply.body.size() << "\r\n"
+           << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n"
+           << "\r\n";
+    conn.Send(ToSendBuffer(header.str()));
+    if (!reply.body.empty()) {
+        conn.Send(std::make_shared<const std::vector<uint8_t>>(std::move(reply.body)));
+    }
+}
+
+void RPCServer::SendHTTPResponse(Connection& conn, int statusCode, const std::string& body,
+                                 bool keepAlive, bool allowChunked,
+                                 const std::string& contentType) {
+    if (!allowChunked || body.size() <= config_.chunkedResponseThreshold) {
+        conn.Send(ToSendBuffer(BuildHTTPResponse(statusCode, body, contentType, keepAlive)));
+        return;
+    }
+    
+    // Header first, then the body a chunk at a time
+    std::ostringstream header;
+    header << "HTTP/1.1 " << statusCode << " " << HTTPReason(statusCode) << "\r\n"
+           << "Content-Type: " << contentType << "\r\n"
+           << "Transfer-Encoding: chunked\r\n"
+           << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n"
+           << "\r\n";
+    conn.Send(ToSendBuffer(header.str()));
+    
+    for (size_t pos = 0; pos < body.size(); pos += HTTP_CHUNK_SIZE) {
+        size_t len = std::min(HTTP_CHUNK_SIZE, body.size() - pos);
+        std::ostringstream chunk;
+        chunk << std::hex << len << "\r\n";
+        chunk.write(body.data() + pos, static_cast<std::streamsize>(len));
+        chunk << "\r\n";
+        conn.Send(ToSendBuffer(chunk.str()));
+    }
+    conn.Send(ToSendBuffer("0\r\n\r\n"));
+}
+
+std::string RPCServer::BuildHTTPResponse(int statusCode, const std::string& body,
+                                        const std::string& contentType, bool keepAlive) {
+    std::ostringstream ss;
+    
+    ss << "HTTP/1.1 " << statusCode << " " << HTTPReason(statusCode) << "\r\n";
+    ss << "Content-Type: " << contentType << "\r\n";
+    ss << "Content-Length: " << body.size() << "\r\n";
+    ss << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n";
+    ss << "\r\n";
+    ss << body;
+    
+    return ss.str();
+}
+
+// ============================================================================
+// HTTP Framing
+// ============================================================================
+
+HTTPFrameResult FrameHTTPRequest(const std::string& buffer, size_t maxBodySize,
+                                 HTTPRequest& request, size_t& consumed) {
     // Find header/body separator
-    size_t headerEnd = raw.find("\r\n\r\n");
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    size_t bodyStart;
     if (headerEnd == std::string::npos) {
-        headerEnd = raw.find("\n\n");
-        if (headerEnd == std::string::npos) return false;
-        body = raw.substr(headerEnd + 2);
+        headerEnd = buffer.find("\n\n");
+        if (headerEnd == std::string::npos) {
+            return buffer.size() > MAX_HTTP_HEADER_SIZE ? HTTPFrameResult::TOO_LARGE
+                                                        : HTTPFrameResult::INCOMPLETE;
+        }
+        bodyStart = headerEnd + 2;
     } else {
-        body = raw.substr(headerEnd + 4);
+        bodyStart = headerEnd + 4;
+    }
+    if (headerEnd > MAX_HTTP_HEADER_SIZE) {
+        return HTTPFrameResult::TOO_LARGE;
     }
     
-    std::string headerSection = raw.substr(0, headerEnd);
-    
-    // Parse headers
-    std::istringstream stream(headerSection);
+    std::istringstream stream(buffer.substr(0, headerEnd));
     std::string line;
     
-    // First line is request line
-    if (!std::getline(stream, line)) return false;
+    // First line is request line: METHOD TARGET HTTP/1.x
+    if (!std::getline(stream, line)) return HTTPFrameResult::BAD_REQUEST;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    std::istringstream requestLine(line);
+    std::string version;
+    requestLine >> request.method >> request.target >> version;
+    if (request.method.empty() || version.compare(0, 7, "HTTP/1.") != 0 || version.size() != 8 ||
+        !std::isdigit(static_cast<unsigned char>(version[7]))) {
+        return HTTPFrameResult::BAD_REQUEST;
+    }
+    request.versionMinor = version[7] - '0';
     
     // Parse subsequent header lines
+    request.headers.clear();
     while (std::getline(stream, line)) {
         if (!line.empty() && line.back() == '\r') {
             line.pop_back();
@@ -1179,36 +1568,43 @@ bool RPCServer::ParseHTTPRequest(const std::string& raw, std::string& body,
             while (!value.empty() && value.back() == ' ') value.pop_back();
             // Convert key to lowercase for case-insensitive lookup
             std::transform(key.begin(), key.end(), key.begin(), ::tolower);
-            headers[key] = value;
+            request.headers[key] = value;
         }
     }
     
-    return true;
-}
-
-std::string RPCServer::BuildHTTPResponse(int statusCode, const std::string& body,
-                                        const std::string& contentType) {
-    std::ostringstream ss;
-    
-    ss << "HTTP/1.1 " << statusCode << " ";
-    switch (statusCode) {
-        case 200: ss << "OK"; break;
-        case 400: ss << "Bad Request"; break;
-        case 401: ss << "Unauthorized"; break;
-        case 403: ss << "Forbidden"; break;
-        case 404: ss << "Not Found"; break;
-        case 500: ss << "Internal Server Error"; break;
-        default: ss << "Unknown"; break;
+    // Request bodies must carry their length; chunked uploads are not taken
+    if (request.headers.count("transfer-encoding")) {
+        return HTTPFrameResult::BAD_REQUEST;
     }
-    ss << "\r\n";
-    
-    ss << "Content-Type: " << contentType << "\r\n";
-    ss << "Content-Length: " << body.size() << "\r\n";
-    ss << "Connection: close\r\n";
-    ss << "\r\n";
-    ss << body;
-    
-    return ss.str();
+    size_t contentLength = 0;
+    auto it = request.headers.find("content-length");
+    if (it != request.headers.end()) {
+        const std::string& value = it->second;
+        if (value.empty() || value.size() > 19 ||
+            !std::all_of(value.begin(), value.end(), ::isdigit)) {
+            return HTTPFrameResult::BAD_REQUEST;
+        }
+        contentLength = static_cast<size_t>(std::stoull(value));
+        if (contentLength > maxBodySize) {
+            return HTTPFrameResult::TOO_LARGE;
+        }
+    }
+    if (buffer.size() - bodyStart < contentLength) {
+        return HTTPFrameResult::INCOMPLETE;
+    }
+    request.body = buffer.substr(bodyStart, contentLength);
+    consumed = bodyStart + contentLength;
+    
+    // HTTP/1.1 stays open unless told otherwise; 1.0 only when asked to
+    std::string connection;
+    auto conn = request.headers.find("connection");
+    if (conn != request.headers.end()) {
+        connection = conn->second;
+        std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+    }
+    request.keepAlive = request.versionMinor >= 1 ? connection != "close"
+                                                  : connection == "keep-alive";
+    return HTTPFrameResult::COMPLETE;
 }
 
 bool RPCServer::Authenticate(const std::map<std::string, std::string>& headers,
@@ -0,0 +1,592 @@
+// SHURIUM - Stratum Mining Server Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/rpc/stratum.h>
+#include <shurium/chain/chainstate.h>
+#include <shurium/consensus/validation.h>
+#include <shurium/core/hex.h>
+#include <shurium/core/merkle.h>
+#include <shurium/core/serialize.h>
+#include <shurium/crypto/sha256.h>
+#include <shurium/miner/miner.h>
+#include <shurium/network/message_processor.h>
+#include <shurium/util/logging.h>
+#include <shurium/util/time.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace shurium {
+namespace rpc {
+
+namespace {
+
+/// Extranonce bytes in the coinbase: the server's, then the miner's
+constexpr size_t EXTRANONCE_SIZE = STRATUM_EXTRANONCE1_SIZE + STRATUM_EXTRANONCE2_SIZE;
+
+/// Stratum sends version, nBits and nTime as big-endian hex
+std::string HexBE32(uint32_t value) {
+    char buf[9];
+    std::snprintf(buf, sizeof(buf), "%08x", value);
+    return buf;
+}
+
+bool ParseHexBE32(const std::string& hex, uint32_t& value) {
+    if (hex.size() != 8 || !IsValidHex(hex)) {
+        return false;
+    }
+    value = static_cast<uint32_t>(std::stoul(hex, nullptr, 16));
+    return true;
+}
+
+/// The previous block hash with each 4-byte word byte-swapped, which is
+/// how Stratum miners expect it
+std::string StratumPrevHash(const BlockHash& hash) {
+    std::vector<uint8_t> swapped(32);
+    for (size_t word = 0; word < 8; ++word) {
+        for (size_t i = 0; i < 4; ++i) {
+            swapped[4 * word + i] = hash[4 * word + 3 - i];
+        }
+    }
+    return BytesToHex(swapped);
+}
+
+JSONValue Notification(const std::string& method, JSONValue params) {
+    JSONValue::Object message;
+    message["id"] = JSONValue();
+    message["method"] = method;
+    message["params"] = std::move(params);
+    return JSONValue(std::move(message));
+}
+
+} // namespace
+
+// ============================================================================
+// Jobs
+// ============================================================================
+
+bool MakeStratumJob(const std::string& id, std::shared_ptr<const miner::BlockTemplate> tmpl,
+                    StratumJob& job) {
+    const Block& block = tmpl->block;
+    if (block.vtx.empty() || block.vtx[0]->vin.empty()) {
+        return false;
+    }
+
+    // The assembler ends the scriptSig with a push of 4 zero bytes; widen
+    // it to hold both extranonces
+    MutableTransaction coinbase(*block.vtx[0]);
+    Script& scriptSig = coinbase.vin[0].scriptSig;
+    if (scriptSig.size() < 5 || scriptSig[scriptSig.size() - 5] != 4) {
+        return false;
+    }
+    Script widened(scriptSig.begin(), scriptSig.end() - 5);
+    widened << std::vector<uint8_t>(EXTRANONCE_SIZE, 0);
+    scriptSig = widened;
+
+    // The scriptSig follows the version, the input count and the prevout
+    DataStream prefix;
+    Serialize(prefix, coinbase.version);
+    WriteCompactSize(prefix, coinbase.vin.size());
+    Serialize(prefix, coinbase.vin[0].prevout);
+    WriteCompactSize(prefix, scriptSig.size());
+    size_t extraNoncePos = prefix.TotalSize() + scriptSig.size() - EXTRANONCE_SIZE;
+
+    DataStream serialized;
+    Serialize(serialized, coinbase);
+    const uint8_t* bytes = serialized.data();
+
+    job.id = id;
+    job.tmpl = std::move(tmpl);
+    job.coinb1.assign(bytes, bytes + extraNoncePos);
+    job.coinb2.assign(bytes + extraNoncePos + EXTRANONCE_SIZE, bytes + serialized.TotalSize());
+    return true;
+}
+
+JSONValue StratumJob::ToNotifyParams() const {
+    const Block& block = tmpl->block;
+    JSONValue::Array branch;
+    for (const Hash256& hash : tmpl->coinbaseMerkleBranch) {
+        branch.push_back(BytesToHex(hash.data(), hash.size()));
+    }
+
+    JSONValue::Array params;
+    params.push_back(id);
+    params.push_back(StratumPrevHash(block.hashPrevBlock));
+    params.push_back(BytesToHex(coinb1));
+    params.push_back(BytesToHex(coinb2));
+    params.push_back(JSONValue(std::move(branch)));
+    params.push_back(HexBE32(static_cast<uint32_t>(block.nVersion)));
+    params.push_back(HexBE32(block.nBits));
+    params.push_back(HexBE32(block.nTime));
+    params.push_back(cleanJobs);
+    return JSONValue(std::move(params));
+}
+
+Hash256 StratumDifficultyToTarget(double difficulty) {
+    Hash256 target;
+    target.SetNull();
+    if (!(difficulty > 0)) {
+        std::fill(target.begin(), target.end(), 0xff);
+        return target;
+    }
+
+    // Difficulty 1 is 0xffff * 2^208; keep the 53 significant bits of the
+    // quotient and shift them into place
+    int exponent;
+    double mantissa = std::frexp(65535.0 / difficulty, &exponent);
+    uint64_t bits = static_cast<uint64_t>(std::ldexp(mantissa, 53));
+    int shift = exponent - 53 + 208;
+    if (shift + 53 > 256) {
+        std::fill(target.begin(), target.end(), 0xff);
+        return target;
+    }
+    for (int bit = 0; bit < 53; ++bit) {
+        int pos = bit + shift;
+        if (pos >= 0 && ((bits >> bit) & 1)) {
+            target[pos / 8] |= static_cast<uint8_t>(1 << (pos % 8));
+        }
+    }
+    return target;
+}
+
+// ============================================================================
+// Stratum Server
+// ============================================================================
+
+struct StratumServer::Session {
+    std::unique_ptr<Connection> conn;
+    std::string buffer;
+    std::vector<uint8_t> extraNonce1;
+    bool subscribed{false};
+    bool authorized{false};
+    bool closing{false};
+};
+
+StratumServer::StratumServer(ChainStateManager& chainman, Mempool& mempool,
+                             const consensus::Params& params, const Script& payoutScript,
+                             const Options& options)
+    : chainman_(chainman)
+    , options_(options)
+    , shareTarget_(StratumDifficultyToTarget(options.difficulty))
+    , templates_(chainman.GetActiveChainState(), mempool, params, payoutScript) {
+}
+
+StratumServer::~StratumServer() {
+    Stop();
+}
+
+bool StratumServer::Start() {
+    if (running_) {
+        return true;
+    }
+
+    listener_ = Listener::Create(options_.port);
+    if (!listener_->Start()) {
+        LOG_ERROR(util::LogCategory::MINING) << "Stratum: cannot listen on port " << options_.port;
+        listener_.reset();
+        return false;
+    }
+    listener_->SetAcceptCallback([this](std::unique_ptr<Connection> conn) {
+        OnAccept(std::move(conn));
+    });
+
+    eventLoop_ = std::make_unique<EventLoop>();
+    eventLoop_->AddListener(listener_.get());
+    eventLoop_->Start();
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        stopping_ = false;
+        tipChanged_ = false;
+    }
+    blockConnectedId_ = chainman_.RegisterBlockConnected(
+        [this](const Block&, const BlockIndex*) { NotifyNewTip(); });
+    jobThread_ = std::thread(&StratumServer::JobThread, this);
+
+    running_ = true;
+    LOG_INFO(util::LogCategory::MINING) << "Stratum server listening on port " << GetPort();
+    return true;
+}
+
+void StratumServer::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // Unregister first: it waits for a running notification to finish
+    chainman_.UnregisterBlockConnected(blockConnectedId_);
+    blockConnectedId_ = -1;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        stopping_ = true;
+    }
+    jobCv_.notify_all();
+    jobThread_.join();
+
+    eventLoop_->Stop();
+    for (auto& [conn, session] : sessions_) {
+        eventLoop_->RemoveConnection(conn);
+        conn->Close();
+    }
+    sessions_.clear();
+    jobs_.clear();
+    clientCount_ = 0;
+
+    eventLoop_->RemoveListener(listener_.get());
+    listener_->Stop();
+    listener_.reset();
+    eventLoop_.reset();
+}
+
+uint16_t StratumServer::GetPort() const {
+    return listener_ ? listener_->GetListenAddress().GetPort() : options_.port;
+}
+
+void StratumServer::SetBlockFoundCallback(BlockFoundCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    blockFoundCallback_ = std::move(callback);
+}
+
+void StratumServer::NotifyNewTip() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        tipChanged_ = true;
+    }
+    jobCv_.notify_all();
+}
+
+// ============================================================================
+// Jobs
+// ============================================================================
+
+void StratumServer::JobThread() {
+    std::shared_ptr<const miner::BlockTemplate> last;
+    int64_t lastJobTime = 0;
+    uint32_t nextJobId = 0;
+
+    std::unique_lock<std::mutex> lock(jobMutex_);
+    while (!stopping_) {
+        tipChanged_ = false;
+        lock.unlock();
+
+        // Templates are shared until stale, so an unchanged one is the
+        // same object
+        std::shared_ptr<const miner::BlockTemplate> tmpl = templates_.Get();
+        int64_t now = util::GetTime();
+        if (tmpl->isValid && tmpl != last) {
+            bool newTip = !last || tmpl->block.hashPrevBlock != last->block.hashPrevBlock;
+            auto job = std::make_shared<StratumJob>();
+            if ((newTip || now - lastJobTime >= STRATUM_JOB_INTERVAL) &&
+                MakeStratumJob(HexBE32(nextJobId++), tmpl, *job)) {
+                job->cleanJobs = newTip;
+                eventLoop_->Post([this, job]() { AddJob(job); });
+                last = tmpl;
+                lastJobTime = now;
+            }
+        }
+        eventLoop_->Post([this]() { RemoveClosedSessions(); });
+
+        lock.lock();
+        jobCv_.wait_for(lock, std::chrono::seconds(1),
+                        [this] { return stopping_ || tipChanged_; });
+    }
+}
+
+void StratumServer::AddJob(std::shared_ptr<StratumJob> job) {
+    if (job->cleanJobs) {
+        jobs_.clear();
+    }
+    jobs_.push_back(job);
+    while (jobs_.size() > MAX_STRATUM_JOBS) {
+        jobs_.pop_front();
+    }
+    for (auto& [conn, session] : sessions_) {
+        if (session->subscribed) {
+            SendJob(*session, *job);
+        }
+    }
+}
+
+StratumJob* StratumServer::FindJob(const std::string& id) {
+    for (auto& job : jobs_) {
+        if (job->id == id) {
+            return job.get();
+        }
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+void StratumServer::OnAccept(std::unique_ptr<Connection> conn) {
+    // Sockets are reused, so connections that closed go before new ones
+    RemoveClosedSessions();
+
+    auto session = std::make_unique<Session>();
+    uint32_t extraNonce1 = nextExtraNonce1_++;
+    for (size_t i = 0; i < STRATUM_EXTRANONCE1_SIZE; ++i) {
+        session->extraNonce1.push_back(
+            static_cast<uint8_t>(extraNonce1 >> (8 * (STRATUM_EXTRANONCE1_SIZE - 1 - i))));
+    }
+
+    Connection* raw = conn.get();
+    session->conn = std::move(conn);
+    raw->SetEventCallback([this](Connection& c, ConnEvent event) {
+        auto it = sessions_.find(&c);
+        if (event == ConnEvent::DATA_RECEIVED && it != sessions_.end()) {
+            OnData(*it->second);
+        }
+    });
+    raw->SetErrorCallback([this](Connection&, int, const std::string&) {
+        eventLoop_->Post([this]() { RemoveClosedSessions(); });
+    });
+
+    sessions_.emplace(raw, std::move(session));
+    eventLoop_->AddConnection(raw);
+    clientCount_ = sessions_.size();
+}
+
+void StratumServer::OnData(Session& session) {
+    std::vector<uint8_t> data = session.conn->RecvAll();
+    session.buffer.append(data.begin(), data.end());
+
+    size_t start = 0;
+    size_t end;
+    while (!session.closing && (end = session.buffer.find('\n', start)) != std::string::npos) {
+        std::string line = session.buffer.substr(start, end - start);
+        start = end + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            HandleLine(session, line);
+        }
+    }
+    session.buffer.erase(0, start);
+
+    if (session.buffer.size() > MAX_STRATUM_LINE) {
+        Disconnect(session);
+    }
+}
+
+void StratumServer::Disconnect(Session& session) {
+    // Called from the connection's own callbacks, so it is closed later
+    session.closing = true;
+    Connection* conn = session.conn.get();
+    eventLoop_->Post([this, conn]() {
+        if (sessions_.count(conn) > 0) {
+            conn->Close();
+        }
+        RemoveClosedSessions();
+    });
+}
+
+void StratumServer::RemoveClosedSessions() {
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (it->first->IsConnected()) {
+            ++it;
+            continue;
+        }
+        eventLoop_->RemoveConnection(it->first);
+        it = sessions_.erase(it);
+    }
+    clientCount_ = sessions_.size();
+}
+
+void StratumServer::Send(Session& session, const JSONValue& message) {
+    std::string line = message.ToJSON() + "\n";
+    session.conn->Send(reinterpret_cast<const uint8_t*>(line.data()), line.size());
+}
+
+void StratumServer::SendJob(Session& session, const StratumJob& job) {
+    Send(session, Notification("mining.notify", job.ToNotifyParams()));
+    ++stats_.jobsSent;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+void StratumServer::HandleLine(Session& session, const std::string& line) {
+    auto request = JSONValue::TryParse(line);
+    if (!request || !request->IsObject() || !(*request)["method"].IsString()) {
+        Disconnect(session);
+        return;
+    }
+    const std::string& method = (*request)["method"].GetString();
+    const JSONValue& params = (*request)["params"];
+
+    JSONValue result;
+    JSONValue error;
+    if (method == "mining.subscribe") {
+        result = HandleSubscribe(session);
+    } else if (method == "mining.authorize") {
+        // Blocks pay the node's payout script, whichever worker finds them
+        session.authorized = true;
+        result = true;
+    } else if (method == "mining.submit") {
+        StratumError code = StratumError::OTHER;
+        std::string message;
+        result = HandleSubmit(session, params, code, message);
+        if (!result.GetBool()) {
+            ++stats_.sharesRejected;
+            error = JSONValue(JSONValue::Array{static_cast<int>(code), message, JSONValue()});
+        }
+    } else {
+        error = JSONValue(JSONValue::Array{static_cast<int>(StratumError::OTHER),
+                                           "Method not found", JSONValue()});
+    }
+
+    JSONValue::Object response;
+    response["id"] = (*request)["id"];
+    response["result"] = std::move(result);
+    response["error"] = std::move(error);
+    Send(session, JSONValue(std::move(response)));
+
+    // A new subscriber starts on the current job right away
+    if (method == "mining.subscribe") {
+        JSONValue::Array difficulty{options_.difficulty};
+        Send(session, Notification("mining.set_difficulty", JSONValue(std::move(difficulty))));
+        if (!jobs_.empty()) {
+            SendJob(session, *jobs_.back());
+        }
+    }
+}
+
+JSONValue StratumServer::HandleSubscribe(Session& session) {
+    session.subscribed = true;
+    std::string subscriptionId = BytesToHex(session.extraNonce1);
+
+    JSONValue::Array subscriptions;
+    subscriptions.push_back(JSONValue(JSONValue::Array{"mining.set_difficulty", subscriptionId}));
+    subscriptions.push_back(JSONValue(JSONValue::Array{"mining.notify", subscriptionId}));
+
+    JSONValue::Array result;
+    result.push_back(JSONValue(std::move(subscriptions)));
+    result.push_back(BytesToHex(session.extraNonce1));
+    result.push_back(static_cast<int>(STRATUM_EXTRANONCE2_SIZE));
+    return JSONValue(std::move(result));
+}
+
+bool StratumServer::HandleSubmit(Session& session, const JSONValue& params,
+                                 StratumError& error, std::string& message) {
+    if (!session.subscribed) {
+        error = StratumError::NOT_SUBSCRIBED;
+        message = "Not subscribed";
+        return false;
+    }
+    if (!session.authorized) {
+        error = StratumError::UNAUTHORIZED;
+        message = "Unauthorized worker";
+        return false;
+    }
+
+    // [worker, job id, extranonce2, ntime, nonce]
+    error = StratumError::OTHER;
+    if (!params.IsArray() || params.Size() < 5 || !params[1].IsString() ||
+        !params[2].IsString() || !params[3].IsString() || !params[4].IsString()) {
+        message = "Invalid parameters";
+        return false;
+    }
+    StratumJob* job = FindJob(params[1].GetString());
+    if (!job) {
+        error = StratumError::JOB_NOT_FOUND;
+        message = "Job not found";
+        return false;
+    }
+    const std::string& extraNonce2Hex = params[2].GetString();
+    uint32_t nTime;
+    uint32_t nNonce;
+    if (extraNonce2Hex.size() != 2 * STRATUM_EXTRANONCE2_SIZE || !IsValidHex(extraNonce2Hex) ||
+        !ParseHexBE32(params[3].GetString(), nTime) ||
+        !ParseHexBE32(params[4].GetString(), nNonce)) {
+        message = "Invalid parameters";
+        return false;
+    }
+    if (static_cast<int64_t>(nTime) < job->tmpl->minTime ||
+        nTime > util::GetTime() + consensus::MAX_FUTURE_BLOCK_TIME) {
+        message = "Time out of range";
+        return false;
+    }
+
+    std::string shareKey = BytesToHex(session.extraNonce1) + extraNonce2Hex +
+                           params[3].GetString() + params[4].GetString();
+    if (job->shares.count(shareKey) > 0) {
+        error = StratumError::DUPLICATE_SHARE;
+        message = "Duplicate share";
+        return false;
+    }
+
+    // Rebuild the coinbase the miner hashed and walk it up to the root
+    std::vector<uint8_t> coinbase = job->coinb1;
+    std::vector<uint8_t> extraNonce2 = HexToBytes(extraNonce2Hex);
+    coinbase.insert(coinbase.end(), session.extraNonce1.begin(), session.extraNonce1.end());
+    coinbase.insert(coinbase.end(), extraNonce2.begin(), extraNonce2.end());
+    coinbase.insert(coinbase.end(), job->coinb2.begin(), job->coinb2.end());
+
+    BlockHeader header = job->tmpl->block;
+    header.hashMerkleRoot = ComputeMerkleRootFromPath(DoubleSHA256(coinbase), 0,
+                                                      job->tmpl->coinbaseMerkleBranch);
+    header.nTime = nTime;
+    header.nNonce = nNonce;
+
+    DataStream serialized;
+    Serialize(serialized, header);
+    const SHA256Midstate midstate = SHA256HeaderMidstate(serialized.data());
+    Byte digest[32];
+    DoubleSHA256_80_Nonces(digest, midstate, serialized.data() + 64, nNonce, 1);
+    Hash256 hash(digest, 32);
+
+    if (!miner::Miner::MeetsTarget(hash, shareTarget_)) {
+        error = StratumError::LOW_DIFFICULTY;
+        message = "Low difficulty share";
+        return false;
+    }
+    job->shares.insert(shareKey);
+    ++stats_.sharesAccepted;
+
+    if (miner::Miner::MeetsTarget(hash, job->tmpl->target)) {
+        SubmitBlock(*job, coinbase, header);
+    }
+    return true;
+}
+
+void StratumServer::SubmitBlock(const StratumJob& job, const std::vector<uint8_t>& coinbase,
+                                const BlockHeader& header) {
+    Block block = job.tmpl->block;
+    static_cast<BlockHeader&>(block) = header;
+    DataStream stream(coinbase);
+    MutableTransaction coinbaseTx;
+    Unserialize(stream, coinbaseTx);
+    block.vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
+
+    ++stats_.blocksFound;
+    LOG_INFO(util::LogCategory::MINING) << "Stratum share is a block at height "
+                                        << job.tmpl->height << ": "
+                                        << block.GetHash().ToHex().substr(0, 16) << "...";
+
+    bool accepted = chainman_.ProcessNewBlock(block);
+    if (accepted) {
+        if (msgproc_) {
+            msgproc_->RelayBlock(block);
+        }
+    } else {
+        LOG_WARN(util::LogCategory::MINING) << "Stratum block rejected by chain";
+    }
+
+    BlockFoundCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        callback = blockFoundCallback_;
+    }
+    if (callback) {
+        callback(block, accepted);
+    }
+}
+
+} // namespace rpc
+} // namespace shurium
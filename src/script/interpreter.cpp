@@ -6,6 +6,9 @@
 // Based on Bitcoin's script system with simplifications.
 
 #include "shurium/script/interpreter.h"
+#include "shurium/script/profile.h"
+#include "shurium/script/pubkeycache.h"
+#include "shurium/script/sigcache.h"
 #include "shurium/crypto/sha256.h"
 #include "shurium/crypto/ripemd160.h"
 #include "shurium/core/serialize.h"
@@ -62,7 +65,7 @@ std::string ScriptErrorString(ScriptError err) {
     }
 }
 
-bool CastToBool(const std::vector<uint8_t>& vch) {
+bool CastToBool(Span<const uint8_t> vch) {
     for (size_t i = 0; i < vch.size(); i++) {
         if (vch[i] != 0) {
             // Can be negative zero
@@ -76,13 +79,13 @@ bool CastToBool(const std::vector<uint8_t>& vch) {
 }
 
 // Numeric opcodes require minimal encoding
-static bool IsMinimallyEncoded(const std::vector<uint8_t>& vch, size_t maxSize) {
+static bool IsMinimallyEncoded(Span<const uint8_t> vch, size_t maxSize) {
     if (vch.size() > maxSize) {
         return false;
     }
     if (vch.size() > 0) {
         // Check if the top byte is 0x00 or 0x80 with unnecessary padding
-        if ((vch.back() & 0x7f) == 0) {
+        if ((vch[vch.size() - 1] & 0x7f) == 0) {
             if (vch.size() <= 1 || (vch[vch.size() - 2] & 0x80) == 0) {
                 return false;
             }
@@ -91,7 +94,7 @@ static bool IsMinimallyEncoded(const std::vector<uint8_t>& vch, size_t maxSize)
     return true;
 }
 
-bool IsValidPubKey(const std::vector<uint8_t>& pubkey) {
+bool IsValidPubKey(Span<const uint8_t> pubkey) {
     if (pubkey.size() < 33) return false;
     
     if (pubkey[0] == 0x04) {
@@ -104,12 +107,12 @@ bool IsValidPubKey(const std::vector<uint8_t>& pubkey) {
     return false;
 }
 
-bool IsCompressedPubKey(const std::vector<uint8_t>& pubkey) {
+bool IsCompressedPubKey(Span<const uint8_t> pubkey) {
     if (pubkey.size() != 33) return false;
     return pubkey[0] == 0x02 || pubkey[0] == 0x03;
 }
 
-bool IsValidDERSignature(const std::vector<uint8_t>& sig) {
+bool IsValidDERSignature(Span<const uint8_t> sig) {
     // Minimum DER signature is 8 bytes (empty R and S)
     // Maximum is around 72 bytes
     if (sig.size() < 9 || sig.size() > 73) return false;
@@ -146,7 +149,7 @@ bool IsValidDERSignature(const std::vector<uint8_t>& sig) {
     return true;
 }
 
-bool IsLowDERSignature(const std::vector<uint8_t>& sig, ScriptError* error) {
+bool IsLowDERSignature(Span<const uint8_t> sig, ScriptError* error) {
     if (!IsValidDERSignature(sig)) {
         if (error) *error = ScriptError::SIG_DER;
         return false;
@@ -199,13 +202,229 @@ bool IsLowDERSignature(const std::vector<uint8_t>& sig, ScriptError* error) {
 // Signature Hash Calculation
 // ============================================================================
 
+namespace {
+
+Hash256 OneHash() {
+    Hash256 one;
+    one[0] = 1;
+    return one;
+}
+
+/**
+ * Pass scriptCode as it is signed to fn(data, len) piece by piece:
+ * OP_CODESEPARATORs removed and pushes re-encoded with the shortest size
+ * prefix, which is what Script::operator<< produces.
+ */
+template <typename Fn>
+void ForEachSignedPiece(Span<const uint8_t> scriptCode, Fn&& fn) {
+    const uint8_t* pc = scriptCode.begin();
+    while (pc < scriptCode.end()) {
+        Opcode opcode;
+        Span<const uint8_t> data;
+        if (!GetScriptOp(pc, scriptCode.end(), opcode, data)) break;
+        if (opcode == OP_CODESEPARATOR) continue;
+        
+        uint8_t prefix[5];
+        size_t prefixLen = 0;
+        size_t size = data.size();
+        if (size == 0) {
+            prefix[prefixLen++] = static_cast<uint8_t>(opcode);
+        } else if (size < OP_PUSHDATA1) {
+            prefix[prefixLen++] = static_cast<uint8_t>(size);
+        } else if (size <= 0xff) {
+            prefix[prefixLen++] = OP_PUSHDATA1;
+            prefix[prefixLen++] = static_cast<uint8_t>(size);
+        } else if (size <= 0xffff) {
+            prefix[prefixLen++] = OP_PUSHDATA2;
+            prefix[prefixLen++] = size & 0xff;
+            prefix[prefixLen++] = (size >> 8) & 0xff;
+        } else {
+            prefix[prefixLen++] = OP_PUSHDATA4;
+            prefix[prefixLen++] = size & 0xff;
+            prefix[prefixLen++] = (size >> 8) & 0xff;
+            prefix[prefixLen++] = (size >> 16) & 0xff;
+            prefix[prefixLen++] = (size >> 24) & 0xff;
+        }
+        fn(prefix, prefixLen);
+        if (size != 0) {
+            fn(data.data(), size);
+        }
+    }
+}
+
+/// scriptCode as it is signed: OP_CODESEPARATORs removed, pushes re-encoded
+Script SignedScriptCode(Span<const uint8_t> scriptCode) {
+    Script scriptCodeCopy;
+    ForEachSignedPiece(scriptCode, [&](const uint8_t* data, size_t len) {
+        scriptCodeCopy.insert(scriptCodeCopy.end(), data, data + len);
+    });
+    return scriptCodeCopy;
+}
+
+/// Serialize the signed scriptCode as a Script without building one
+template <typename Stream>
+void SerializeSignedScriptCode(Stream& s, Span<const uint8_t> scriptCode) {
+    size_t size = 0;
+    ForEachSignedPiece(scriptCode, [&](const uint8_t*, size_t len) { size += len; });
+    WriteCompactSize(s, size);
+    ForEachSignedPiece(scriptCode, [&](const uint8_t* data, size_t len) { s.Write(data, len); });
+}
+
+/// Appends serialized objects to a byte vector
+struct VectorWriter {
+    std::vector<uint8_t>& out;
+    
+    void Write(const uint8_t* data, size_t len) { out.insert(out.end(), data, data + len); }
+    void Write(const char* data, size_t len) {
+        Write(reinterpret_cast<const uint8_t*>(data), len);
+    }
+};
+
+Hash256 HashPrevouts(const Transaction& tx) {
+    HashWriter ss;
+    for (const auto& input : tx.vin) {
+        Serialize(ss, input.prevout);
+    }
+    return ss.GetHash();
+}
+
+Hash256 HashSequence(const Transaction& tx) {
+    HashWriter ss;
+    for (const auto& input : tx.vin) {
+        Serialize(ss, input.nSequence);
+    }
+    return ss.GetHash();
+}
+
+Hash256 HashOutputs(const Transaction& tx) {
+    HashWriter ss;
+    for (const auto& output : tx.vout) {
+        Serialize(ss, output);
+    }
+    return ss.GetHash();
+}
+
+/**
+ * Linear-time signature hash: every input hashes a preimage of the same
+ * size, committing to the other inputs and the outputs through digests
+ * that are computed once per transaction.
+ */
+Hash256 SignatureHashLinear(const Transaction& tx, unsigned int nIn, Span<const uint8_t> scriptCode,
+                            uint8_t nHashType, Amount amount,
+                            const PrecomputedTransactionData* txdata) {
+    uint8_t nHashTypeBase = nHashType & 0x1f;
+    bool anyoneCanPay = (nHashType & SIGHASH_ANYONECANPAY) != 0;
+    bool ready = txdata && txdata->ready;
+    
+    Hash256 hashPrevouts;
+    Hash256 hashSequence;
+    Hash256 hashOutputs;
+    if (!anyoneCanPay) {
+        hashPrevouts = ready ? txdata->hashPrevouts : HashPrevouts(tx);
+    }
+    if (!anyoneCanPay && nHashTypeBase != SIGHASH_SINGLE && nHashTypeBase != SIGHASH_NONE) {
+        hashSequence = ready ? txdata->hashSequence : HashSequence(tx);
+    }
+    if (nHashTypeBase != SIGHASH_SINGLE && nHashTypeBase != SIGHASH_NONE) {
+        hashOutputs = ready ? txdata->hashOutputs : HashOutputs(tx);
+    } else if (nHashTypeBase == SIGHASH_SINGLE && nIn < tx.vout.size()) {
+        HashWriter ss;
+        Serialize(ss, tx.vout[nIn]);
+        hashOutputs = ss.GetHash();
+    }
+    
+    const TxIn& input = tx.vin[nIn];
+    HashWriter ss;
+    Serialize(ss, tx.version);
+    Serialize(ss, hashPrevouts);
+    Serialize(ss, hashSequence);
+    Serialize(ss, input.prevout);
+    SerializeSignedScriptCode(ss, scriptCode);
+    Serialize(ss, static_cast<int64_t>(amount));
+    Serialize(ss, input.nSequence);
+    Serialize(ss, hashOutputs);
+    Serialize(ss, tx.nLockTime);
+    Serialize(ss, static_cast<uint32_t>(nHashType));
+    return ss.GetHash();
+}
+
+/// Legacy SIGHASH_ALL hash from the shared prefix states and serialization
+Hash256 SignatureHashLegacyAll(const PrecomputedTransactionData& txdata, const Transaction& tx,
+                               unsigned int nIn, Span<const uint8_t> scriptCode,
+                               uint8_t nHashType) {
+    HashWriter ss{txdata.legacyPrefix[nIn]};
+    Serialize(ss, tx.vin[nIn].prevout);
+    SerializeSignedScriptCode(ss, scriptCode);
+    Serialize(ss, tx.vin[nIn].nSequence);
+    
+    uint32_t next = txdata.legacyInputOffsets[nIn + 1];
+    ss.Write(txdata.legacyInputs.data() + next, txdata.legacyInputs.size() - next);
+    ss.Write(txdata.legacyOutputs.data(), txdata.legacyOutputs.size());
+    Serialize(ss, static_cast<uint32_t>(nHashType));
+    return ss.GetHash();
+}
+
+} // anonymous namespace
+
+void PrecomputedTransactionData::Init(const Transaction& tx) {
+    hashPrevouts = HashPrevouts(tx);
+    hashSequence = HashSequence(tx);
+    hashOutputs = HashOutputs(tx);
+    
+    // The emptied inputs, serialized once
+    legacyInputs.clear();
+    legacyInputOffsets.clear();
+    legacyInputOffsets.reserve(tx.vin.size() + 1);
+    VectorWriter inputs{legacyInputs};
+    const Script empty;
+    for (const auto& input : tx.vin) {
+        legacyInputOffsets.push_back(static_cast<uint32_t>(legacyInputs.size()));
+        Serialize(inputs, input.prevout);
+        Serialize(inputs, empty);
+        Serialize(inputs, input.nSequence);
+    }
+    legacyInputOffsets.push_back(static_cast<uint32_t>(legacyInputs.size()));
+    
+    legacyOutputs.clear();
+    VectorWriter outputs{legacyOutputs};
+    Serialize(outputs, tx.vout);
+    Serialize(outputs, tx.nLockTime);
+    
+    // Hasher state in front of each input, advanced one emptied input at a time
+    legacyPrefix.clear();
+    legacyPrefix.reserve(tx.vin.size());
+    HashWriter prefix;
+    Serialize(prefix, tx.version);
+    WriteCompactSize(prefix, tx.vin.size());
+    for (size_t i = 0; i < tx.vin.size(); ++i) {
+        legacyPrefix.push_back(prefix.hasher);
+        prefix.Write(legacyInputs.data() + legacyInputOffsets[i],
+                     legacyInputOffsets[i + 1] - legacyInputOffsets[i]);
+    }
+    
+    ready = true;
+}
+
 Hash256 SignatureHash(const Transaction& tx, unsigned int nIn,
-                      const Script& scriptCode, uint8_t nHashType) {
+                      Span<const uint8_t> scriptCode, uint8_t nHashType,
+                      Amount amount, SigVersion sigversion,
+                      const PrecomputedTransactionData* txdata) {
     if (nIn >= tx.vin.size()) {
         // Invalid input index - return 1 (special case in Bitcoin)
-        Hash256 one;
-        one[0] = 1;
-        return one;
+        return OneHash();
+    }
+    
+    if (sigversion == SigVersion::LINEAR) {
+        return SignatureHashLinear(tx, nIn, scriptCode, nHashType, amount, txdata);
+    }
+    
+    // Handle different hash types
+    uint8_t nHashTypeBase = nHashType & 0x1f;
+    
+    // Everything outside this input is the same for all SIGHASH_ALL inputs
+    if (txdata && txdata->ready && !(nHashType & SIGHASH_ANYONECANPAY) &&
+        nHashTypeBase != SIGHASH_NONE && nHashTypeBase != SIGHASH_SINGLE) {
+        return SignatureHashLegacyAll(*txdata, tx, nIn, scriptCode, nHashType);
     }
     
     // Create a modified copy of the transaction for signing
@@ -218,24 +437,7 @@ Hash256 SignatureHash(const Transaction& tx, unsigned int nIn,
     
     // Set the script for the input being signed
     // Remove OP_CODESEPARATOR from scriptCode
-    Script scriptCodeCopy;
-    auto pc = scriptCode.begin();
-    while (pc < scriptCode.end()) {
-        Opcode opcode;
-        std::vector<uint8_t> data;
-        if (!scriptCode.GetOp(pc, opcode, data)) break;
-        if (opcode != OP_CODESEPARATOR) {
-            if (data.empty()) {
-                scriptCodeCopy << opcode;
-            } else {
-                scriptCodeCopy << data;
-            }
-        }
-    }
-    txCopy.vin[nIn].scriptSig = scriptCodeCopy;
-    
-    // Handle different hash types
-    uint8_t nHashTypeBase = nHashType & 0x1f;
+    txCopy.vin[nIn].scriptSig = SignedScriptCode(scriptCode);
     
     if (nHashTypeBase == SIGHASH_NONE) {
         // Sign none of the outputs
@@ -250,9 +452,7 @@ Hash256 SignatureHash(const Transaction& tx, unsigned int nIn,
         // Sign only the output at the same index
         if (nIn >= txCopy.vout.size()) {
             // Return special value for SIGHASH_SINGLE bug
-            Hash256 one;
-            one[0] = 1;
-            return one;
+            return OneHash();
         }
         txCopy.vout.resize(nIn + 1);
         for (size_t i = 0; i < nIn; i++) {
@@ -291,32 +491,72 @@ Hash256 SignatureHash(const Transaction& tx, unsigned int nIn,
 
 TransactionSignatureChecker::TransactionSignatureChecker(const Transaction* tx,
                                                          unsigned int nIn,
-                                                         Amount amount)
-    : txTo_(tx), nIn_(nIn), amount_(amount) {}
+                                                         Amount amount,
+                                                         SignatureCache* sigCache,
+                                                         bool storeInCache)
+    : txTo_(tx), nIn_(nIn), amount_(amount)
+    , sigCache_(sigCache), storeInCache_(storeInCache) {}
 
-Hash256 TransactionSignatureChecker::ComputeSignatureHash(const Script& scriptCode,
-                                                          uint8_t nHashType) const {
-    return SignatureHash(*txTo_, nIn_, scriptCode, nHashType);
+TransactionSignatureChecker::TransactionSignatureChecker(const Transaction* tx,
+                                                         unsigned int nIn,
+                                                         Amount amount,
+                                                         const PrecomputedTransactionData& txdata,
+                                                         SignatureCache* sigCache,
+                                                         bool storeInCache)
+    : txTo_(tx), nIn_(nIn), amount_(amount), txdata_(&txdata)
+    , sigCache_(sigCache), storeInCache_(storeInCache) {}
+
+Hash256 TransactionSignatureChecker::ComputeSignatureHash(Span<const uint8_t> scriptCode,
+                                                          uint8_t nHashType,
+                                                          SigVersion sigversion) const {
+    return SignatureHash(*txTo_, nIn_, scriptCode, nHashType, amount_, sigversion, txdata_);
 }
 
-bool TransactionSignatureChecker::CheckSig(const std::vector<uint8_t>& signature,
-                                           const std::vector<uint8_t>& pubkeyData,
-                                           const Script& scriptCode) const {
+bool TransactionSignatureChecker::CheckSig(Span<const uint8_t> signature,
+                                           Span<const uint8_t> pubkeyData,
+                                           Span<const uint8_t> scriptCode,
+                                           SigVersion sigversion) const {
     if (signature.empty()) return false;
     if (pubkeyData.empty()) return false;
     
     // Extract hash type (last byte of signature)
-    uint8_t nHashType = signature.back();
-    std::vector<uint8_t> sigWithoutHashType(signature.begin(), signature.end() - 1);
+    uint8_t nHashType = signature[signature.size() - 1];
+    Span<const uint8_t> sigWithoutHashType = signature.first(signature.size() - 1);
     
-    // Compute the signature hash
-    Hash256 sighash = ComputeSignatureHash(scriptCode, nHashType);
+    if (sigWithoutHashType.empty()) return false;
     
-    // Create public key and verify
-    PublicKey pubkey(pubkeyData);
+    // The key's size must match its prefix before the cache is consulted:
+    // a hit only vouches for a check that passed these same tests
+    PublicKey pubkey(pubkeyData.data(), pubkeyData.size());
     if (!pubkey.IsValid()) return false;
     
-    return pubkey.Verify(sighash, sigWithoutHashType);
+    // Compute the signature hash
+    Hash256 sighash = ComputeSignatureHash(scriptCode, nHashType, sigversion);
+    
+    // Skip the curve operations if this exact check already succeeded
+    Hash256 cacheEntry;
+    if (sigCache_) {
+        cacheEntry = sigCache_->ComputeEntry(sighash, pubkeyData, sigWithoutHashType);
+        if (sigCache_->Contains(cacheEntry)) {
+            return true;
+        }
+    }
+    
+    // Verify; compressed keys are decompressed once and then come from the
+    // shared cache
+    secp256k1::ParsedPublicKey parsed;
+    if (!GetPubKeyCache().Parse(pubkey.data(), pubkey.size(), parsed)) {
+        return false;
+    }
+    if (!secp256k1::ECDSAVerify(sighash.data(), sigWithoutHashType.data(),
+                                sigWithoutHashType.size(), parsed)) {
+        return false;
+    }
+    
+    if (sigCache_ && storeInCache_) {
+        sigCache_->Insert(cacheEntry);
+    }
+    return true;
 }
 
 bool TransactionSignatureChecker::CheckLockTime(int64_t nLockTime) const {
@@ -379,22 +619,84 @@ bool TransactionSignatureChecker::CheckSequence(int64_t nSequence) const {
 // ============================================================================
 
 // Helper macros for stack operations
-#define stacktop(i) (stack.at(stack.size() + (i)))
-#define altstacktop(i) (altstack.at(altstack.size() + (i)))
+#define stacktop(i) (stack.top(i))
+#define altstacktop(i) (altstack.top(i))
 
-static inline void popstack(std::vector<std::vector<uint8_t>>& stack) {
-    if (stack.empty()) throw std::runtime_error("popstack: empty stack");
+static inline void popstack(ScriptStack& stack) {
     stack.pop_back();
 }
 
-bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
-                const Script& script,
-                ScriptFlags flags,
-                const BaseSignatureChecker& checker,
-                ScriptError* serror) {
-    
-    static const std::vector<uint8_t> vchFalse(0);
-    static const std::vector<uint8_t> vchTrue(1, 1);
+/// Push the minimal encoding of a number
+static inline void pushnum(ScriptStack& stack, const ScriptNum& bn) {
+    uint8_t buf[ScriptNum::MAX_SERIALIZED_SIZE];
+    stack.push_back(Span<const uint8_t>(buf, ScriptNum::Serialize(bn.GetInt64(), buf)));
+}
+
+static inline void pushbool(ScriptStack& stack, bool value) {
+    static const uint8_t vchTrue[1] = {1};
+    stack.push_back(value ? Span<const uint8_t>(vchTrue, 1) : Span<const uint8_t>());
+}
+
+namespace {
+
+/// Walks the operations of a serialized script, parsing as it goes
+class RawOpCursor {
+public:
+    explicit RawOpCursor(Span<const uint8_t> script)
+        : begin_(script.data()), pc_(script.data()), end_(script.data() + script.size()) {}
+
+    bool Done() const { return pc_ >= end_; }
+
+    /// Decode the next operation; false if the script is truncated there
+    bool Next(Opcode& opcode, Span<const uint8_t>& data) {
+        return GetScriptOp(pc_, end_, opcode, data);
+    }
+
+    /// Offset just past the last operation returned
+    size_t Position() const { return static_cast<size_t>(pc_ - begin_); }
+
+private:
+    const uint8_t* begin_;
+    const uint8_t* pc_;
+    const uint8_t* end_;
+};
+
+/// Walks the operations of a script decoded beforehand
+class DecodedOpCursor {
+public:
+    explicit DecodedOpCursor(const DecodedScript& script)
+        : script_(script), op_(script.ops().data()), end_(op_ + script.ops().size()) {}
+
+    bool Done() const { return op_ == end_ && !script_.IsTruncated(); }
+
+    bool Next(Opcode& opcode, Span<const uint8_t>& data) {
+        if (op_ == end_) {
+            return false;
+        }
+        opcode = op_->opcode;
+        data = script_.Data(*op_);
+        position_ = op_->end;
+        ++op_;
+        return true;
+    }
+
+    size_t Position() const { return position_; }
+
+private:
+    const DecodedScript& script_;
+    const ScriptOp* op_;
+    const ScriptOp* end_;
+    size_t position_{0};
+};
+
+/// The opcode loop, over the operations cursor yields from script
+template <typename OpCursor>
+bool EvalOps(ScriptStack& stack,
+             Span<const uint8_t> script,
+             OpCursor pc,
+             ScriptFlags flags,
+             const BaseSignatureChecker& checker,
+             ScriptError* serror) {
     
     auto SetError = [&](ScriptError err) {
         if (serror) *serror = err;
@@ -408,22 +710,21 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
     int nOpCount = 0;
     bool fRequireMinimal = HasFlag(flags, ScriptFlags::VERIFY_MINIMALDATA);
     
-    std::vector<std::vector<uint8_t>> altstack;
+    ScriptStack altstack(stack.arena());
     std::vector<bool> vfExec;  // Track if we're in an executing branch
     
     try {
-        auto pc = script.begin();
-        auto pend = script.end();
-        auto pbegincodehash = script.begin();
+        size_t pbegincodehash = 0;
         
-        while (pc < pend) {
+        while (!pc.Done()) {
             bool fExec = vfExec.empty() || vfExec.back();
             
             Opcode opcode;
-            std::vector<uint8_t> vchPushValue;
-            if (!script.GetOp(pc, opcode, vchPushValue)) {
+            Span<const uint8_t> vchPushValue;
+            if (!pc.Next(opcode, vchPushValue)) {
                 return SetError(ScriptError::BAD_OPCODE);
             }
+            SHURIUM_PROFILE_OPCODE(opcode);
             
             if (vchPushValue.size() > MAX_SCRIPT_ELEMENT_SIZE) {
                 return SetError(ScriptError::PUSH_SIZE);
@@ -476,7 +777,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                     case OP_16: {
                         // OP_1NEGATE = -1, OP_1 through OP_16 = 1 through 16
                         ScriptNum bn((opcode == OP_1NEGATE) ? -1 : (opcode - (OP_1 - 1)));
-                        stack.push_back(bn.GetBytes());
+                        pushnum(stack, bn);
                         break;
                     }
                     
@@ -553,8 +854,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                             if (stack.size() < 1) {
                                 return SetError(ScriptError::UNBALANCED_CONDITIONAL);
                             }
-                            std::vector<uint8_t>& vch = stacktop(-1);
-                            fValue = CastToBool(vch);
+                            fValue = CastToBool(stacktop(-1));
                             if (opcode == OP_NOTIF) {
                                 fValue = !fValue;
                             }
@@ -629,8 +929,8 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 2) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> v1 = stacktop(-2);
-                        std::vector<uint8_t> v2 = stacktop(-1);
+                        StackElement v1 = stacktop(-2);
+                        StackElement v2 = stacktop(-1);
                         stack.push_back(v1);
                         stack.push_back(v2);
                         break;
@@ -640,9 +940,9 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 3) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> v1 = stacktop(-3);
-                        std::vector<uint8_t> v2 = stacktop(-2);
-                        std::vector<uint8_t> v3 = stacktop(-1);
+                        StackElement v1 = stacktop(-3);
+                        StackElement v2 = stacktop(-2);
+                        StackElement v3 = stacktop(-1);
                         stack.push_back(v1);
                         stack.push_back(v2);
                         stack.push_back(v3);
@@ -653,8 +953,8 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 4) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> v1 = stacktop(-4);
-                        std::vector<uint8_t> v2 = stacktop(-3);
+                        StackElement v1 = stacktop(-4);
+                        StackElement v2 = stacktop(-3);
                         stack.push_back(v1);
                         stack.push_back(v2);
                         break;
@@ -664,9 +964,9 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 6) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> v1 = stacktop(-6);
-                        std::vector<uint8_t> v2 = stacktop(-5);
-                        stack.erase(stack.end() - 6, stack.end() - 4);
+                        StackElement v1 = stacktop(-6);
+                        StackElement v2 = stacktop(-5);
+                        stack.erase(stack.size() - 6, stack.size() - 4);
                         stack.push_back(v1);
                         stack.push_back(v2);
                         break;
@@ -685,7 +985,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 1) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> vch = stacktop(-1);
+                        StackElement vch = stacktop(-1);
                         if (CastToBool(vch)) {
                             stack.push_back(vch);
                         }
@@ -694,7 +994,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                     
                     case OP_DEPTH: {
                         ScriptNum bn(static_cast<int64_t>(stack.size()));
-                        stack.push_back(bn.GetBytes());
+                        pushnum(stack, bn);
                         break;
                     }
                     
@@ -710,7 +1010,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 1) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> vch = stacktop(-1);
+                        StackElement vch = stacktop(-1);
                         stack.push_back(vch);
                         break;
                     }
@@ -719,7 +1019,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 2) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        stack.erase(stack.end() - 2);
+                        stack.erase(stack.size() - 2, stack.size() - 1);
                         break;
                     }
                     
@@ -727,7 +1027,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 2) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> vch = stacktop(-2);
+                        StackElement vch = stacktop(-2);
                         stack.push_back(vch);
                         break;
                     }
@@ -742,9 +1042,9 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (n < 0 || static_cast<size_t>(n) >= stack.size()) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> vch = stacktop(-n - 1);
+                        StackElement vch = stacktop(-n - 1);
                         if (opcode == OP_ROLL) {
-                            stack.erase(stack.end() - n - 1);
+                            stack.erase(stack.size() - n - 1, stack.size() - n);
                         }
                         stack.push_back(vch);
                         break;
@@ -771,8 +1071,8 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 2) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t> vch = stacktop(-1);
-                        stack.insert(stack.end() - 2, vch);
+                        StackElement vch = stacktop(-1);
+                        stack.insert(stack.size() - 2, vch);
                         break;
                     }
                     
@@ -781,7 +1081,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
                         ScriptNum bn(static_cast<int64_t>(stacktop(-1).size()));
-                        stack.push_back(bn.GetBytes());
+                        pushnum(stack, bn);
                         break;
                     }
                     
@@ -793,12 +1093,10 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 2) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t>& v1 = stacktop(-2);
-                        std::vector<uint8_t>& v2 = stacktop(-1);
-                        bool fEqual = (v1 == v2);
+                        bool fEqual = (stacktop(-2) == stacktop(-1));
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fEqual ? vchTrue : vchFalse);
+                        pushbool(stack, fEqual);
                         if (opcode == OP_EQUALVERIFY) {
                             if (fEqual) {
                                 popstack(stack);
@@ -832,7 +1130,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                             default: break;
                         }
                         popstack(stack);
-                        stack.push_back(bn.GetBytes());
+                        pushnum(stack, bn);
                         break;
                     }
                     
@@ -898,7 +1196,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         }
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(bn.GetBytes());
+                        pushnum(stack, bn);
                         
                         if (opcode == OP_NUMEQUALVERIFY) {
                             if (CastToBool(stacktop(-1))) {
@@ -921,7 +1219,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         popstack(stack);
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fValue ? vchTrue : vchFalse);
+                        pushbool(stack, fValue);
                         break;
                     }
                     
@@ -935,31 +1233,36 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         if (stack.size() < 1) {
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
-                        std::vector<uint8_t>& vch = stacktop(-1);
-                        std::vector<uint8_t> vchHash;
+                        const StackElement& vch = stacktop(-1);
+                        uint8_t vchHash[SHA256::OUTPUT_SIZE];
+                        size_t hashLen = 0;
                         
                         if (opcode == OP_RIPEMD160) {
-                            Hash160 hash = RIPEMD160Hash(vch);
-                            vchHash.assign(hash.begin(), hash.end());
+                            Hash160 hash = RIPEMD160Hash(vch.data(), vch.size());
+                            hashLen = hash.size();
+                            std::memcpy(vchHash, hash.data(), hashLen);
                         } else if (opcode == OP_SHA256) {
-                            Hash256 hash = SHA256Hash(vch);
-                            vchHash.assign(hash.begin(), hash.end());
+                            Hash256 hash = SHA256Hash(vch.data(), vch.size());
+                            hashLen = hash.size();
+                            std::memcpy(vchHash, hash.data(), hashLen);
                         } else if (opcode == OP_HASH160) {
                             // RIPEMD160(SHA256(x))
-                            Hash160 hash = Hash160FromData(vch);
-                            vchHash.assign(hash.begin(), hash.end());
+                            Hash160 hash = Hash160FromData(vch.data(), vch.size());
+                            hashLen = hash.size();
+                            std::memcpy(vchHash, hash.data(), hashLen);
                         } else if (opcode == OP_HASH256) {
                             // SHA256(SHA256(x))
-                            Hash256 hash = DoubleSHA256(vch);
-                            vchHash.assign(hash.begin(), hash.end());
+                            Hash256 hash = DoubleSHA256(vch.data(), vch.size());
+                            hashLen = hash.size();
+                            std::memcpy(vchHash, hash.data(), hashLen);
                         }
                         popstack(stack);
-                        stack.push_back(vchHash);
+                        stack.push_back(Span<const uint8_t>(vchHash, hashLen));
                         break;
                     }
                     
                     case OP_CODESEPARATOR: {
-                        pbegincodehash = pc;
+                        pbegincodehash = pc.Position();
                         break;
                     }
                     
@@ -969,11 +1272,11 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
                         
-                        std::vector<uint8_t>& vchSig = stacktop(-2);
-                        std::vector<uint8_t>& vchPubKey = stacktop(-1);
+                        Span<const uint8_t> vchSig = stacktop(-2);
+                        Span<const uint8_t> vchPubKey = stacktop(-1);
                         
-                        // Create subscript from codeseparator
-                        Script scriptCode(pbegincodehash, pend);
+                        // Subscript from the last codeseparator, viewed in place
+                        Span<const uint8_t> scriptCode = script.last(script.size() - pbegincodehash);
                         
                         // Check signature encoding
                         if (!vchSig.empty()) {
@@ -1001,7 +1304,8 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                             }
                         }
                         
-                        bool fSuccess = checker.CheckSig(vchSig, vchPubKey, scriptCode);
+                        bool fSuccess = checker.CheckSig(vchSig, vchPubKey, scriptCode,
+                                                         GetSigVersion(flags));
                         
                         if (!fSuccess && HasFlag(flags, ScriptFlags::VERIFY_NULLDUMMY) && !vchSig.empty()) {
                             return SetError(ScriptError::SIG_NULLFAIL);
@@ -1009,7 +1313,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         
                         popstack(stack);
                         popstack(stack);
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushbool(stack, fSuccess);
                         
                         if (opcode == OP_CHECKSIGVERIFY) {
                             if (fSuccess) {
@@ -1057,16 +1361,16 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                             return SetError(ScriptError::INVALID_STACK_OPERATION);
                         }
                         
-                        // Create subscript from codeseparator
-                        Script scriptCode(pbegincodehash, pend);
+                        Span<const uint8_t> scriptCode = script.last(script.size() - pbegincodehash);
                         
                         bool fSuccess = true;
                         while (fSuccess && nSigsCount > 0) {
-                            std::vector<uint8_t>& vchSig = stacktop(-isig);
-                            std::vector<uint8_t>& vchPubKey = stacktop(-ikey);
+                            Span<const uint8_t> vchSig = stacktop(-isig);
+                            Span<const uint8_t> vchPubKey = stacktop(-ikey);
                             
                             // Check signature
-                            bool fOk = checker.CheckSig(vchSig, vchPubKey, scriptCode);
+                            bool fOk = checker.CheckSig(vchSig, vchPubKey, scriptCode,
+                                                        GetSigVersion(flags));
                             
                             if (fOk) {
                                 isig++;
@@ -1107,7 +1411,7 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
                         }
                         popstack(stack);
                         
-                        stack.push_back(fSuccess ? vchTrue : vchFalse);
+                        pushbool(stack, fSuccess);
                         
                         if (opcode == OP_CHECKMULTISIGVERIFY) {
                             if (fSuccess) {
@@ -1143,18 +1447,236 @@ bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
     return true;
 }
 
+} // anonymous namespace
+
+bool EvalScript(std::vector<std::vector<uint8_t>>& stack,
+                const Script& script,
+                ScriptFlags flags,
+                const BaseSignatureChecker& checker,
+                ScriptError* serror) {
+    ScriptArena arena;
+    ScriptStack evalStack(arena);
+    evalStack.Assign(stack);
+    bool result = EvalScript(evalStack, script, flags, checker, serror);
+    stack = evalStack.ToVectors();
+    return result;
+}
+
+bool EvalScript(ScriptStack& stack,
+                const Script& script,
+                ScriptFlags flags,
+                const BaseSignatureChecker& checker,
+                ScriptError* serror) {
+    Span<const uint8_t> bytes(script.data(), script.size());
+    return EvalOps(stack, bytes, RawOpCursor(bytes), flags, checker, serror);
+}
+
+bool EvalScript(ScriptStack& stack,
+                const DecodedScript& script,
+                ScriptFlags flags,
+                const BaseSignatureChecker& checker,
+                ScriptError* serror) {
+    return EvalOps(stack, script.bytes(), DecodedOpCursor(script), flags, checker, serror);
+}
+
 #undef stacktop
 #undef altstacktop
 
 // ============================================================================
-// VerifyScript - Main entry point for script verification
+// Standard Script Templates
 // ============================================================================
 
-bool VerifyScript(const Script& scriptSig,
-                  const Script& scriptPubKey,
-                  ScriptFlags flags,
-                  const BaseSignatureChecker& checker,
-                  ScriptError* serror) {
+ScriptTemplate MatchScriptTemplate(const Script& scriptPubKey, Span<const uint8_t>* solution) {
+    ScriptTemplate type = ScriptTemplate::NONSTANDARD;
+    Span<const uint8_t> found;
+    size_t size = scriptPubKey.size();
+    
+    if (scriptPubKey.IsPayToPublicKeyHash()) {
+        type = ScriptTemplate::P2PKH;
+        found = Span<const uint8_t>(scriptPubKey.data() + 3, 20);
+    } else if (scriptPubKey.IsPayToScriptHash()) {
+        type = ScriptTemplate::P2SH;
+        found = Span<const uint8_t>(scriptPubKey.data() + 2, 20);
+    } else if ((size == 35 || size == 67) && scriptPubKey[0] == size - 2 &&
+               scriptPubKey[size - 1] == OP_CHECKSIG) {
+        // A compressed or uncompressed key push, then OP_CHECKSIG
+        type = ScriptTemplate::P2PK;
+        found = Span<const uint8_t>(scriptPubKey.data() + 1, size - 2);
+    }
+    
+    if (solution) *solution = found;
+    return type;
+}
+
+namespace {
+
+/**
+ * Outcome of a template fast path. Anything unusual is deferred to the
+ * generic interpreter, which then produces the exact error; the fast paths
+ * only decide the outcomes they can prove are the interpreter's.
+ */
+enum class TemplateResult { PASS, FAIL, DEFER };
+
+/// Cursor over the operations of a scriptSig, raw or decoded
+RawOpCursor OpsOf(const Script& script) {
+    return RawOpCursor(Span<const uint8_t>(script.data(), script.size()));
+}
+
+DecodedOpCursor OpsOf(const DecodedScript& script) {
+    return DecodedOpCursor(script);
+}
+
+/// Pass each push of scriptSig to fn, as long as the interpreter would
+/// accept it and scriptSig is nothing but data pushes
+template <typename ScriptSig, typename Fn>
+bool ForEachDataPush(const ScriptSig& scriptSig, ScriptFlags flags, Fn&& fn) {
+    if (scriptSig.size() > MAX_SCRIPT_SIZE) {
+        return false;
+    }
+    bool fRequireMinimal = HasFlag(flags, ScriptFlags::VERIFY_MINIMALDATA);
+    auto pc = OpsOf(scriptSig);
+    while (!pc.Done()) {
+        Opcode opcode;
+        Span<const uint8_t> data;
+        if (!pc.Next(opcode, data) || opcode > OP_PUSHDATA4) {
+            return false;
+        }
+        if (data.size() > MAX_SCRIPT_ELEMENT_SIZE ||
+            (fRequireMinimal && !IsMinimallyEncoded(data, MAX_SCRIPT_ELEMENT_SIZE))) {
+            return false;
+        }
+        if (!fn(data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The pushes of a scriptSig of exactly N data pushes
+template <typename ScriptSig, size_t N>
+bool ParseDataPushes(const ScriptSig& scriptSig, ScriptFlags flags, Span<const uint8_t> (&pushes)[N]) {
+    size_t count = 0;
+    bool ok = ForEachDataPush(scriptSig, flags, [&](Span<const uint8_t> data) {
+        if (count == N) return false;
+        pushes[count++] = data;
+        return true;
+    });
+    return ok && count == N;
+}
+
+/// The pushed data of a scriptPubKey passes the MINIMALDATA check
+bool PushAccepted(Span<const uint8_t> data, ScriptFlags flags) {
+    return !HasFlag(flags, ScriptFlags::VERIFY_MINIMALDATA) ||
+           IsMinimallyEncoded(data, MAX_SCRIPT_ELEMENT_SIZE);
+}
+
+/// OP_CHECKSIG as the last opcode of scriptPubKey, with sig and pubkey the
+/// only stack elements
+TemplateResult TemplateCheckSig(Span<const uint8_t> sig, Span<const uint8_t> pubkey,
+                                const Script& scriptPubKey, ScriptFlags flags,
+                                const BaseSignatureChecker& checker, ScriptError* serror) {
+    if (!sig.empty()) {
+        if (HasFlag(flags, ScriptFlags::VERIFY_STRICTENC) && !IsValidDERSignature(sig)) {
+            return TemplateResult::DEFER;
+        }
+        if (HasFlag(flags, ScriptFlags::VERIFY_LOW_S) && !IsLowDERSignature(sig)) {
+            return TemplateResult::DEFER;
+        }
+    }
+    if (HasFlag(flags, ScriptFlags::VERIFY_STRICTENC) && !IsValidPubKey(pubkey)) {
+        return TemplateResult::DEFER;
+    }
+    if (HasFlag(flags, ScriptFlags::VERIFY_COMPRESSED_PUBKEY) && !IsCompressedPubKey(pubkey)) {
+        return TemplateResult::DEFER;
+    }
+    
+    // No OP_CODESEPARATOR, so the whole scriptPubKey is signed
+    if (checker.CheckSig(sig, pubkey, scriptPubKey, GetSigVersion(flags))) {
+        if (serror) *serror = ScriptError::OK;
+        return TemplateResult::PASS;
+    }
+    if (serror) {
+        *serror = HasFlag(flags, ScriptFlags::VERIFY_NULLDUMMY) && !sig.empty()
+                      ? ScriptError::SIG_NULLFAIL
+                      : ScriptError::EVAL_FALSE;
+    }
+    return TemplateResult::FAIL;
+}
+
+/// <sig> against <pubkey> OP_CHECKSIG
+template <typename ScriptSig>
+TemplateResult VerifyPayToPubKey(const ScriptSig& scriptSig, const Script& scriptPubKey,
+                                 Span<const uint8_t> pubkey, ScriptFlags flags,
+                                 const BaseSignatureChecker& checker, ScriptError* serror) {
+    Span<const uint8_t> pushes[1];
+    if (!ParseDataPushes(scriptSig, flags, pushes) || !PushAccepted(pubkey, flags)) {
+        return TemplateResult::DEFER;
+    }
+    return TemplateCheckSig(pushes[0], pubkey, scriptPubKey, flags, checker, serror);
+}
+
+/// <sig> <pubkey> against OP_DUP OP_HASH160 <hash> OP_EQUALVERIFY OP_CHECKSIG
+template <typename ScriptSig>
+TemplateResult VerifyPayToPubKeyHash(const ScriptSig& scriptSig, const Script& scriptPubKey,
+                                     Span<const uint8_t> keyHash, ScriptFlags flags,
+                                     const BaseSignatureChecker& checker, ScriptError* serror) {
+    Span<const uint8_t> pushes[2];
+    if (!ParseDataPushes(scriptSig, flags, pushes) || !PushAccepted(keyHash, flags)) {
+        return TemplateResult::DEFER;
+    }
+    Hash160 hash = Hash160FromData(pushes[1].data(), pushes[1].size());
+    if (std::memcmp(hash.data(), keyHash.data(), keyHash.size()) != 0) {
+        return TemplateResult::DEFER;
+    }
+    return TemplateCheckSig(pushes[0], pushes[1], scriptPubKey, flags, checker, serror);
+}
+
+/// <args...> <redeemScript> against OP_HASH160 <hash> OP_EQUAL: the outer
+/// script is a hash compare, the redeem script runs in the interpreter
+template <typename ScriptSig>
+TemplateResult VerifyPayToScriptHash(const ScriptSig& scriptSig, Span<const uint8_t> scriptHash,
+                                     ScriptFlags flags, const BaseSignatureChecker& checker,
+                                     ScriptError* serror) {
+    if (!HasFlag(flags, ScriptFlags::VERIFY_P2SH) || !PushAccepted(scriptHash, flags)) {
+        return TemplateResult::DEFER;
+    }
+    
+    // The outer script pushes one element more than scriptSig leaves
+    ScriptArena arena;
+    ScriptStack stack(arena);
+    bool ok = ForEachDataPush(scriptSig, flags, [&](Span<const uint8_t> data) {
+        stack.push_back(data);
+        return stack.size() < static_cast<size_t>(MAX_STACK_SIZE);
+    });
+    if (!ok || stack.empty()) {
+        return TemplateResult::DEFER;
+    }
+    const StackElement& serializedScript = stack.back();
+    Hash160 hash = Hash160FromData(serializedScript.data(), serializedScript.size());
+    if (std::memcmp(hash.data(), scriptHash.data(), scriptHash.size()) != 0) {
+        return TemplateResult::DEFER;
+    }
+    
+    Script subscript(serializedScript.begin(), serializedScript.end());
+    stack.pop_back();
+    if (!EvalScript(stack, subscript, flags, checker, serror)) {
+        return TemplateResult::FAIL;
+    }
+    if (stack.empty() || !CastToBool(stack.back())) {
+        if (serror) *serror = ScriptError::EVAL_FALSE;
+        return TemplateResult::FAIL;
+    }
+    if (serror) *serror = ScriptError::OK;
+    return TemplateResult::PASS;
+}
+
+/// VerifyScriptGeneric, with the scriptSig raw or decoded
+template <typename ScriptSig>
+bool VerifyScriptOpLoop(const ScriptSig& scriptSig,
+                        const Script& scriptPubKey,
+                        ScriptFlags flags,
+                        const BaseSignatureChecker& checker,
+                        ScriptError* serror) {
     
     auto SetError = [&](ScriptError err) {
         if (serror) *serror = err;
@@ -1166,15 +1688,17 @@ bool VerifyScript(const Script& scriptSig,
         return SetError(ScriptError::SIG_PUSHONLY);
     }
     
-    // Evaluate scriptSig
-    std::vector<std::vector<uint8_t>> stack;
+    // Evaluate scriptSig; every stack of this verification shares the arena
+    ScriptArena arena;
+    ScriptStack stack(arena);
     if (!EvalScript(stack, scriptSig, flags, checker, serror)) {
         return false;
     }
     
     // Save a copy of the stack for P2SH
-    std::vector<std::vector<uint8_t>> stackCopy;
-    if (HasFlag(flags, ScriptFlags::VERIFY_P2SH)) {
+    bool fP2SH = HasFlag(flags, ScriptFlags::VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash();
+    ScriptStack stackCopy(arena);
+    if (fP2SH) {
         stackCopy = stack;
     }
     
@@ -1194,7 +1718,7 @@ bool VerifyScript(const Script& scriptSig,
     }
     
     // P2SH evaluation
-    if (HasFlag(flags, ScriptFlags::VERIFY_P2SH) && scriptPubKey.IsPayToScriptHash()) {
+    if (fP2SH) {
         // scriptSig must be push-only for P2SH
         if (!scriptSig.IsPushOnly()) {
             return SetError(ScriptError::SIG_PUSHONLY);
@@ -1207,7 +1731,7 @@ bool VerifyScript(const Script& scriptSig,
         }
         
         // The serialized script is the top element of stackCopy
-        const std::vector<uint8_t>& serializedScript = stackCopy.back();
+        const StackElement& serializedScript = stackCopy.back();
         Script subscript(serializedScript.begin(), serializedScript.end());
         
         // Evaluate the P2SH subscript
@@ -1235,6 +1759,86 @@ bool VerifyScript(const Script& scriptSig,
     return true;
 }
 
+/// VerifyScript, with the scriptSig raw or decoded
+template <typename ScriptSig>
+bool VerifyScriptPair(const ScriptSig& scriptSig,
+                      const Script& scriptPubKey,
+                      ScriptFlags flags,
+                      const BaseSignatureChecker& checker,
+                      ScriptError* serror) {
+#ifdef SHURIUM_SCRIPT_PROFILE
+    uint64_t profileStart = detail::ProfileClock();
+#endif
+    
+    // Standard pairs skip the opcode loop
+    Span<const uint8_t> solution;
+    TemplateResult result = TemplateResult::DEFER;
+    ScriptTemplate type = MatchScriptTemplate(scriptPubKey, &solution);
+    switch (type) {
+        case ScriptTemplate::P2PK:
+            result = VerifyPayToPubKey(scriptSig, scriptPubKey, solution, flags, checker, serror);
+            break;
+        case ScriptTemplate::P2PKH:
+            result = VerifyPayToPubKeyHash(scriptSig, scriptPubKey, solution, flags, checker, serror);
+            break;
+        case ScriptTemplate::P2SH:
+            result = VerifyPayToScriptHash(scriptSig, solution, flags, checker, serror);
+            break;
+        case ScriptTemplate::NONSTANDARD:
+            break;
+    }
+    if (result != TemplateResult::DEFER) {
+#ifdef SHURIUM_SCRIPT_PROFILE
+        detail::RecordTemplate(static_cast<size_t>(type), detail::ProfileClock() - profileStart);
+#endif
+        return result == TemplateResult::PASS;
+    }
+    bool ok = VerifyScriptOpLoop(scriptSig, scriptPubKey, flags, checker, serror);
+#ifdef SHURIUM_SCRIPT_PROFILE
+    detail::RecordTemplate(static_cast<size_t>(ScriptTemplate::NONSTANDARD),
+                           detail::ProfileClock() - profileStart);
+#endif
+    return ok;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// VerifyScript - Main entry point for script verification
+// ============================================================================
+
+bool VerifyScript(const Script& scriptSig,
+                  const Script& scriptPubKey,
+                  ScriptFlags flags,
+                  const BaseSignatureChecker& checker,
+                  ScriptError* serror) {
+    return VerifyScriptPair(scriptSig, scriptPubKey, flags, checker, serror);
+}
+
+bool VerifyScript(const DecodedScript& scriptSig,
+                  const Script& scriptPubKey,
+                  ScriptFlags flags,
+                  const BaseSignatureChecker& checker,
+                  ScriptError* serror) {
+    return VerifyScriptPair(scriptSig, scriptPubKey, flags, checker, serror);
+}
+
+bool VerifyScriptGeneric(const Script& scriptSig,
+                         const Script& scriptPubKey,
+                         ScriptFlags flags,
+                         const BaseSignatureChecker& checker,
+                         ScriptError* serror) {
+    return VerifyScriptOpLoop(scriptSig, scriptPubKey, flags, checker, serror);
+}
+
+bool VerifyScriptGeneric(const DecodedScript& scriptSig,
+                         const Script& scriptPubKey,
+                         ScriptFlags flags,
+                         const BaseSignatureChecker& checker,
+                         ScriptError* serror) {
+    return VerifyScriptOpLoop(scriptSig, scriptPubKey, flags, checker, serror);
+}
+
 // ============================================================================
 // CountSigOps
 // ============================================================================
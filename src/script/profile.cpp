@@ -0,0 +1,165 @@
+// SHURIUM - Script Execution Profile Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/script/profile.h"
+#include "shurium/core/script.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define SHURIUM_PROFILE_TSC 1
+#endif
+
+namespace shurium {
+
+namespace {
+
+/**
+ * Counters of one thread. Only the owning thread writes them, so the
+ * atomics never contend; they exist so a snapshot can read them while
+ * scripts run.
+ */
+struct ThreadCounters {
+    std::array<std::atomic<uint64_t>, 256 * 2> opcodes{};
+    std::array<std::atomic<uint64_t>, 4 * 2> templates{};
+
+    ThreadCounters();
+    ~ThreadCounters();
+};
+
+/// Live per-thread counters and the totals of threads that have exited
+struct ProfileRegistry {
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    ScriptProfile retired;
+};
+
+ProfileRegistry& Registry() {
+    static ProfileRegistry* registry = new ProfileRegistry();  // Outlives thread exit
+    return *registry;
+}
+
+ThreadCounters::ThreadCounters() {
+    ProfileRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(this);
+}
+
+void AddCounters(const std::atomic<uint64_t>* counters, ScriptProfileEntry* entries, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        entries[i].executions += counters[2 * i].load(std::memory_order_relaxed);
+        entries[i].cycles += counters[2 * i + 1].load(std::memory_order_relaxed);
+    }
+}
+
+ThreadCounters::~ThreadCounters() {
+    ProfileRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    AddCounters(opcodes.data(), registry.retired.opcodes.data(), registry.retired.opcodes.size());
+    AddCounters(templates.data(), registry.retired.templates.data(), registry.retired.templates.size());
+    for (auto it = registry.threads.begin(); it != registry.threads.end(); ++it) {
+        if (*it == this) {
+            registry.threads.erase(it);
+            break;
+        }
+    }
+}
+
+ThreadCounters& LocalCounters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+inline void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+namespace detail {
+
+uint64_t ProfileClock() {
+#ifdef SHURIUM_PROFILE_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void RecordOpcode(uint8_t opcode, uint64_t cycles) {
+    ThreadCounters& counters = LocalCounters();
+    Add(counters.opcodes[2 * opcode], 1);
+    Add(counters.opcodes[2 * opcode + 1], cycles);
+}
+
+void RecordTemplate(size_t kind, uint64_t cycles) {
+    ThreadCounters& counters = LocalCounters();
+    Add(counters.templates[2 * kind], 1);
+    Add(counters.templates[2 * kind + 1], cycles);
+}
+
+} // namespace detail
+
+// ============================================================================
+// Snapshot
+// ============================================================================
+
+bool ScriptProfilingEnabled() {
+#ifdef SHURIUM_SCRIPT_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+ScriptProfile GetScriptProfile() {
+    ProfileRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    ScriptProfile profile = registry.retired;
+    for (const ThreadCounters* counters : registry.threads) {
+        AddCounters(counters->opcodes.data(), profile.opcodes.data(), profile.opcodes.size());
+        AddCounters(counters->templates.data(), profile.templates.data(), profile.templates.size());
+    }
+    return profile;
+}
+
+void ResetScriptProfile() {
+    // A thread in the middle of a script may put back a count from before
+    ProfileRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired = ScriptProfile();
+    for (ThreadCounters* counters : registry.threads) {
+        for (auto& counter : counters->opcodes) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter : counters->templates) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+const char* ScriptProfileClock() {
+#ifdef SHURIUM_PROFILE_TSC
+    return "tsc";
+#else
+    return "ns";
+#endif
+}
+
+std::string ScriptProfileOpName(uint8_t opcode) {
+    if (opcode > OP_0 && opcode < OP_PUSHDATA1) {
+        return "PUSH_" + std::to_string(opcode);
+    }
+    return GetOpName(static_cast<Opcode>(opcode));
+}
+
+} // namespace shurium
@@ -0,0 +1,119 @@
+// SHURIUM - Parsed Public Key Cache Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/script/pubkeycache.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace shurium {
+
+PubKeyCache::PubKeyCache(size_t maxEntries)
+    : m_shardCapacity(std::max<size_t>(maxEntries / SHARDS, 1))
+    , m_salt(GetHashTableSalt()) {
+    for (Shard& shard : m_shards) {
+        shard.index.reserve(m_shardCapacity);
+    }
+}
+
+bool PubKeyCache::Parse(const uint8_t* pubkey, size_t len, secp256k1::ParsedPublicKey& out) {
+    if (len != KEY_SIZE) {
+        return secp256k1::ParsePublicKey(out, pubkey, len);
+    }
+
+    // The top bits pick the shard, so within a shard the map still sees
+    // the full spread of the low bits
+    uint64_t hash = SipHash13(m_salt.k0, m_salt.k1, pubkey, len);
+    Shard& shard = m_shards[hash >> 59];
+    static_assert(SHARDS == 32, "shard index takes the top five bits");
+
+    if (Lookup(shard, hash, pubkey, out)) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Parse without the lock; two threads missing on the same key both do
+    // the work and the second insert only refreshes the entry
+    if (!secp256k1::ParsePublicKey(out, pubkey, len)) {
+        return false;
+    }
+    Insert(shard, hash, pubkey, out);
+    return true;
+}
+
+bool PubKeyCache::Lookup(Shard& shard, uint64_t hash, const uint8_t* pubkey,
+                         secp256k1::ParsedPublicKey& out) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(hash);
+    if (it == shard.index.end() ||
+        std::memcmp(it->second->key.data(), pubkey, KEY_SIZE) != 0) {
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    out = it->second->point;
+    return true;
+}
+
+void PubKeyCache::Insert(Shard& shard, uint64_t hash, const uint8_t* pubkey,
+                         const secp256k1::ParsedPublicKey& point) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // A key already present, or another key with the same 64-bit hash,
+    // is overwritten in place
+    auto it = shard.index.find(hash);
+    if (it != shard.index.end()) {
+        std::memcpy(it->second->key.data(), pubkey, KEY_SIZE);
+        it->second->point = point;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return;
+    }
+
+    if (shard.lru.size() >= m_shardCapacity) {
+        // Reuse the least recently used node rather than reallocating
+        shard.index.erase(shard.lru.back().hash);
+        shard.lru.splice(shard.lru.begin(), shard.lru, std::prev(shard.lru.end()));
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        shard.lru.emplace_front();
+        m_entries.fetch_add(1, std::memory_order_relaxed);
+    }
+    Entry& entry = shard.lru.front();
+    std::memcpy(entry.key.data(), pubkey, KEY_SIZE);
+    entry.point = point;
+    entry.hash = hash;
+    shard.index.emplace(hash, shard.lru.begin());
+    m_inserts.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PubKeyCache::Clear() {
+    for (Shard& shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.lru.clear();
+    }
+    m_hits.store(0);
+    m_misses.store(0);
+    m_inserts.store(0);
+    m_evictions.store(0);
+    m_entries.store(0);
+}
+
+PubKeyCache::Stats PubKeyCache::GetStats() const {
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.inserts = m_inserts.load(std::memory_order_relaxed);
+    stats.evictions = m_evictions.load(std::memory_order_relaxed);
+    stats.entries = m_entries.load(std::memory_order_relaxed);
+    stats.capacity = m_shardCapacity * SHARDS;
+    return stats;
+}
+
+PubKeyCache& GetPubKeyCache() {
+    static PubKeyCache cache;
+    return cache;
+}
+
+} // namespace shurium
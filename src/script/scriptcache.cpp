@@ -0,0 +1,62 @@
+// SHURIUM - Script Execution Cache Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/script/scriptcache.h"
+#include <mutex>
+
+namespace shurium {
+
+Hash256 ScriptExecutionCache::ComputeEntry(const TxHash& txid, ScriptFlags flags) const {
+    uint32_t flagBits = static_cast<uint32_t>(flags);
+    uint8_t flagBytes[4] = {
+        static_cast<uint8_t>(flagBits),
+        static_cast<uint8_t>(flagBits >> 8),
+        static_cast<uint8_t>(flagBits >> 16),
+        static_cast<uint8_t>(flagBits >> 24),
+    };
+
+    SHA256 hasher = SaltedHasher();
+    hasher.Write(txid.data(), txid.size());
+    hasher.Write(flagBytes, sizeof(flagBytes));
+
+    Hash256 entry;
+    hasher.Finalize(entry.data());
+    return entry;
+}
+
+void ScriptExecutionCache::SetActiveFlags(ScriptFlags flags) {
+    std::unique_lock<std::shared_mutex> lock(m_flagsMutex);
+    if (flags == m_activeFlags) {
+        return;
+    }
+
+    // Entries keyed on the old flags can never hit again
+    m_activeFlags = flags;
+    ClearEntries();
+    m_invalidations.fetch_add(1, std::memory_order_relaxed);
+}
+
+ScriptFlags ScriptExecutionCache::GetActiveFlags() const {
+    std::shared_lock<std::shared_mutex> lock(m_flagsMutex);
+    return m_activeFlags;
+}
+
+void ScriptExecutionCache::Clear() {
+    SaltedCache::Clear();
+    m_invalidations.store(0);
+}
+
+ScriptExecutionCache::Stats ScriptExecutionCache::GetStats() const {
+    Stats stats;
+    static_cast<SaltedCache::Stats&>(stats) = SaltedCache::GetStats();
+    stats.invalidations = m_invalidations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ScriptExecutionCache& GetScriptExecutionCache() {
+    static ScriptExecutionCache cache;
+    return cache;
+}
+
+} // namespace shurium
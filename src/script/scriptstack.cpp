@@ -0,0 +1,128 @@
+// SHURIUM - Script Evaluation Stack Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/script/scriptstack.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace shurium {
+
+// ============================================================================
+// ScriptArena
+// ============================================================================
+
+void* ScriptArena::Allocate(size_t len) {
+    constexpr size_t ALIGN = alignof(std::max_align_t);
+    len = (len + ALIGN - 1) & ~(ALIGN - 1);
+    if (len > left_) {
+        size_t chunkSize = std::max(len, CHUNK_SIZE);
+        chunks_.emplace_back(new uint8_t[chunkSize]);
+        next_ = chunks_.back().get();
+        left_ = chunkSize;
+        heapBytes_ += chunkSize;
+    }
+    void* result = next_;
+    next_ += len;
+    left_ -= len;
+    return result;
+}
+
+// ============================================================================
+// ScriptStack
+// ============================================================================
+
+ScriptStack::ScriptStack(const ScriptStack& other) : arena_(other.arena_) {
+    *this = other;
+}
+
+ScriptStack& ScriptStack::operator=(const ScriptStack& other) {
+    if (this != &other) {
+        arena_ = other.arena_;
+        size_ = 0;
+        Reserve(other.size_);
+        std::copy(other.begin(), other.end(), data_);
+        size_ = other.size_;
+    }
+    return *this;
+}
+
+void ScriptStack::Reserve(size_t n) {
+    if (n <= capacity_) {
+        return;
+    }
+    // Most scripts never go more than a few elements deep
+    size_t capacity = std::max<size_t>({n, capacity_ * 2, 8});
+    auto* data = static_cast<StackElement*>(arena_->Allocate(capacity * sizeof(StackElement)));
+    std::copy(begin(), end(), data);
+    data_ = data;
+    capacity_ = capacity;
+}
+
+StackElement& ScriptStack::top(int i) {
+    if (i >= 0 || static_cast<size_t>(-static_cast<int64_t>(i)) > size_) {
+        throw std::out_of_range("ScriptStack::top: stack too shallow");
+    }
+    return data_[size_ + i];
+}
+
+void ScriptStack::push_back(const StackElement& element) {
+    // Copy first: element may live in the slots Reserve replaces
+    StackElement copy = element;
+    Reserve(size_ + 1);
+    data_[size_++] = copy;
+}
+
+void ScriptStack::push_back(Span<const uint8_t> bytes) {
+    StackElement element;
+    element.size_ = static_cast<uint32_t>(bytes.size());
+    if (bytes.size() <= StackElement::INLINE_SIZE) {
+        if (!bytes.empty()) {
+            std::memcpy(element.inline_, bytes.data(), bytes.size());
+        }
+    } else {
+        auto* external = static_cast<uint8_t*>(arena_->Allocate(bytes.size()));
+        std::memcpy(external, bytes.data(), bytes.size());
+        element.external_ = external;
+    }
+    push_back(element);
+}
+
+void ScriptStack::pop_back() {
+    if (size_ == 0) {
+        throw std::runtime_error("popstack: empty stack");
+    }
+    --size_;
+}
+
+void ScriptStack::erase(size_t first, size_t last) {
+    std::copy(data_ + last, data_ + size_, data_ + first);
+    size_ -= last - first;
+}
+
+void ScriptStack::insert(size_t pos, const StackElement& element) {
+    StackElement copy = element;
+    Reserve(size_ + 1);
+    std::copy_backward(data_ + pos, data_ + size_, data_ + size_ + 1);
+    data_[pos] = copy;
+    ++size_;
+}
+
+void ScriptStack::Assign(const std::vector<std::vector<uint8_t>>& values) {
+    clear();
+    Reserve(values.size());
+    for (const auto& value : values) {
+        push_back(Span<const uint8_t>(value));
+    }
+}
+
+std::vector<std::vector<uint8_t>> ScriptStack::ToVectors() const {
+    std::vector<std::vector<uint8_t>> values;
+    values.reserve(size_);
+    for (const StackElement& element : *this) {
+        values.push_back(element.ToVector());
+    }
+    return values;
+}
+
+} // namespace shurium
@@ -0,0 +1,29 @@
+// SHURIUM - Signature Verification Cache Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/script/sigcache.h"
+
+namespace shurium {
+
+Hash256 SignatureCache::ComputeEntry(const Hash256& sighash,
+                                     Span<const uint8_t> pubkey,
+                                     Span<const uint8_t> signature) const {
+    // Length prefixes keep bytes from moving between pubkey and signature
+    // with the same concatenation
+    SHA256 hasher = SaltedHasher();
+    hasher.Write(sighash.data(), sighash.size());
+    WriteWithLength(hasher, pubkey);
+    WriteWithLength(hasher, signature);
+
+    Hash256 entry;
+    hasher.Finalize(entry.data());
+    return entry;
+}
+
+SignatureCache& GetSignatureCache() {
+    static SignatureCache cache;
+    return cache;
+}
+
+} // namespace shurium
@@ -4,12 +4,18 @@
 //
 // The shurium-cli tool provides command-line access to a running SHURIUM node.
 // It communicates with the node via JSON-RPC.
+//
+// With --batch it runs many commands, one per input line, as JSON-RPC
+// batches pipelined over a single connection, so scripts need not start a
+// process per call.
 
 #include <shurium/rpc/client.h>
 #include <shurium/rpc/server.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <cstring>
 #include <fstream>
 #include <getopt.h>
@@ -51,6 +57,8 @@ namespace defaults {
     constexpr uint16_t RPC_PORT = 8332;
     constexpr uint16_t TESTNET_RPC_PORT = 18332;
     constexpr uint16_t REGTEST_RPC_PORT = 18443;
+    constexpr size_t BATCH_SIZE = 64;
+    constexpr size_t BATCH_IN_FLIGHT = 4;
 }
 
 // ============================================================================
@@ -79,6 +87,12 @@ struct CLIConfig {
     bool rawOutput{false};
     bool stdinMode{false};
     
+    // Batch mode: commands read from batchFile ("-" for stdin)
+    bool batchMode{false};
+    std::string batchFile{"-"};
+    size_t batchSize{defaults::BATCH_SIZE};
+    size_t batchInFlight{defaults::BATCH_IN_FLIGHT};
+    
     // Command
     std::string method;
     std::vector<std::string> args;
@@ -306,6 +320,12 @@ void PrintHelp() {
     std::cout << "  --raw                      Output raw JSON response\n";
     std::cout << "  --stdin                    Read extra arguments from stdin\n";
     std::cout << "  --named                    Use named parameters\n";
+    std::cout << "\nBatch Options:\n";
+    std::cout << "  --batch[=FILE]             Run one command per line of FILE (default: stdin),\n";
+    std::cout << "                             printing one {\"id\",\"result\",\"error\"} line each\n";
+    std::cout << "                             in input order; id is the input line number\n";
+    std::cout << "  --batchsize=N              Commands per JSON-RPC batch (default: 64)\n";
+    std::cout << "  --inflight=N               Batches sent ahead of their answers (default: 4)\n";
     std::cout << "\nCommands:\n";
     std::cout << "  Use 'shurium-cli help' for a list of available commands\n";
     std::cout << "  Use 'shurium-cli help <command>' for help on a specific command\n";
@@ -314,6 +334,7 @@ void PrintHelp() {
     std::cout << "  shurium-cli getblock <hash>\n";
     std::cout << "  shurium-cli sendtoaddress <address> <amount>\n";
     std::cout << "  shurium-cli --testnet getbalance\n";
+    std::cout << "  printf 'getblockhash 1\\ngetblockhash 2\\n' | shurium-cli --batch\n";
     std::cout << "\n";
 }
 
@@ -343,6 +364,9 @@ bool ParseCommandLine(int argc, char* argv[], CLIConfig& config) {
         {"raw", no_argument, nullptr, 1008},
         {"stdin", no_argument, nullptr, 1009},
         {"named", no_argument, nullptr, 1010},
+        {"batch", optional_argument, nullptr, 1011},
+        {"batchsize", required_argument, nullptr, 1012},
+        {"inflight", required_argument, nullptr, 1013},
         {nullptr, 0, nullptr, 0}
     };
     
@@ -397,6 +421,18 @@ bool ParseCommandLine(int argc, char* argv[], CLIConfig& config) {
             case 1010:  // --named
                 config.namedParams = true;
                 break;
+            case 1011:  // --batch
+                config.batchMode = true;
+                if (optarg) {
+                    config.batchFile = optarg;
+                }
+                break;
+            case 1012:  // --batchsize
+                config.batchSize = std::max<size_t>(1, std::stoul(optarg));
+                break;
+            case 1013:  // --inflight
+                config.batchInFlight = std::max<size_t>(1, std::stoul(optarg));
+                break;
             case '?':
             default:
                 return false;
@@ -413,7 +449,7 @@ bool ParseCommandLine(int argc, char* argv[], CLIConfig& config) {
     }
     
     // Read additional args from stdin if requested
-    if (config.stdinMode && !isatty(fileno(stdin))) {
+    if (config.stdinMode && !config.batchMode && !isatty(fileno(stdin))) {
         std::string line;
         while (std::getline(std::cin, line)) {
             if (!line.empty()) {
@@ -483,15 +519,15 @@ rpc::JSONValue ParseArgument(const std::string& arg) {
     return rpc::JSONValue(arg);
 }
 
-rpc::JSONValue BuildParams(const CLIConfig& config) {
-    if (config.args.empty()) {
+rpc::JSONValue BuildParams(const std::vector<std::string>& args, bool named) {
+    if (args.empty()) {
         return rpc::JSONValue();
     }
     
-    if (config.namedParams) {
+    if (named) {
         // Parse as key=value pairs
         rpc::JSONValue::Object obj;
-        for (const auto& arg : config.args) {
+        for (const auto& arg : args) {
             size_t eqPos = arg.find('=');
             if (eqPos != std::string::npos) {
                 std::string key = arg.substr(0, eqPos);
@@ -506,7 +542,7 @@ rpc::JSONValue BuildParams(const CLIConfig& config) {
     } else {
         // Parse as positional array
         rpc::JSONValue::Array arr;
-        for (const auto& arg : config.args) {
+        for (const auto& arg : args) {
             arr.push_back(ParseArgument(arg));
         }
         return rpc::JSONValue(std::move(arr));
@@ -609,8 +645,7 @@ void PrintError(int code, const std::string& message) {
 // RPC Call
 // ============================================================================
 
-int ExecuteCommand(const CLIConfig& config) {
-    // Configure RPC client
+rpc::RPCClientConfig MakeClientConfig(const CLIConfig& config) {
     rpc::RPCClientConfig clientConfig;
     clientConfig.host = config.rpcHost;
     clientConfig.port = config.rpcPort;
@@ -619,20 +654,27 @@ int ExecuteCommand(const CLIConfig& config) {
     clientConfig.useSSL = config.useSSL;
     clientConfig.connectTimeout = 5;
     clientConfig.requestTimeout = 300;  // Long timeout for slow operations
-    
+    return clientConfig;
+}
+
+void PrintConnectError(const CLIConfig& config) {
+    std::cerr << "error: Could not connect to server " 
+              << config.rpcHost << ":" << config.rpcPort << "\n";
+    std::cerr << "Make sure shuriumd is running and RPC is enabled.\n";
+}
+
+int ExecuteCommand(const CLIConfig& config) {
     // Create client
-    rpc::RPCClient client(clientConfig);
+    rpc::RPCClient client(MakeClientConfig(config));
     
     // Connect
     if (!client.Connect()) {
-        std::cerr << "error: Could not connect to server " 
-                  << config.rpcHost << ":" << config.rpcPort << "\n";
-        std::cerr << "Make sure shuriumd is running and RPC is enabled.\n";
+        PrintConnectError(config);
         return 1;
     }
     
     // Build request parameters
-    rpc::JSONValue params = BuildParams(config);
+    rpc::JSONValue params = BuildParams(config.args, config.namedParams);
     
     // Make RPC call
     rpc::RPCResponse response = client.Call(config.method, params);
@@ -649,6 +691,182 @@ int ExecuteCommand(const CLIConfig& config) {
     return 0;
 }
 
+// ============================================================================
+// Batch Mode
+// ============================================================================
+
+/// Split a line into words as a shell would: quotes group, backslash escapes
+bool SplitWords(const std::string& line, std::vector<std::string>& words, std::string& error) {
+    std::string word;
+    bool inWord = false;
+    char quote = 0;
+    for (size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (c == '\\' && quote != '\'' && i + 1 < line.size()) {
+            word += line[++i];
+            inWord = true;
+        } else if (quote) {
+            if (c == quote) {
+                quote = 0;
+            } else {
+                word += c;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inWord = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inWord) {
+                words.push_back(std::move(word));
+                word.clear();
+                inWord = false;
+            }
+        } else {
+            word += c;
+            inWord = true;
+        }
+    }
+    if (quote) {
+        error = "unterminated quote";
+        return false;
+    }
+    if (inWord) {
+        words.push_back(std::move(word));
+    }
+    return true;
+}
+
+/**
+ * One batch input line: "method arg..." with the same argument rules as
+ * the command line, or a {"method": ..., "params": ...} object.
+ */
+bool ParseBatchLine(const std::string& line, bool named, std::string& method,
+                    rpc::JSONValue& params, std::string& error) {
+    if (line[0] == '{') {
+        auto parsed = rpc::JSONValue::TryParse(line);
+        if (!parsed || !parsed->IsObject() || !(*parsed)["method"].IsString()) {
+            error = "expected an object with a \"method\" string";
+            return false;
+        }
+        method = (*parsed)["method"].GetString();
+        params = (*parsed)["params"];
+        return true;
+    }
+    
+    std::vector<std::string> words;
+    if (!SplitWords(line, words, error)) {
+        return false;
+    }
+    method = words[0];
+    words.erase(words.begin());
+    params = BuildParams(words, named);
+    return true;
+}
+
+/// One output line per command: {"error": ..., "id": <line>, "result": ...}
+void PrintBatchResult(size_t lineNo, const rpc::JSONValue& result, const rpc::JSONValue& error) {
+    rpc::JSONValue::Object obj;
+    obj["id"] = rpc::JSONValue(static_cast<int64_t>(lineNo));
+    obj["result"] = result;
+    obj["error"] = error;
+    std::cout << rpc::JSONValue(std::move(obj)).ToJSON() << "\n";
+}
+
+rpc::JSONValue BatchError(int code, const std::string& message) {
+    rpc::JSONValue::Object err;
+    err["code"] = rpc::JSONValue(static_cast<int64_t>(code));
+    err["message"] = rpc::JSONValue(message);
+    return rpc::JSONValue(std::move(err));
+}
+
+int ExecuteBatch(const CLIConfig& config) {
+    std::ifstream file;
+    std::istream* input = &std::cin;
+    if (config.batchFile != "-") {
+        file.open(config.batchFile);
+        if (!file.is_open()) {
+            std::cerr << "error: Could not open " << config.batchFile << "\n";
+            return 1;
+        }
+        input = &file;
+    }
+    
+    rpc::RPCClient client(MakeClientConfig(config));
+    if (!client.Connect()) {
+        PrintConnectError(config);
+        return 1;
+    }
+    
+    // Request ids are input line numbers. Lines that cannot be parsed never
+    // reach the server; their errors wait here to be printed in order
+    size_t lineNo = 0;
+    size_t commands = 0;
+    size_t failures = 0;
+    std::deque<std::pair<size_t, std::string>> badLines;
+    
+    auto printBadLinesBefore = [&](size_t limit) {
+        while (!badLines.empty() && badLines.front().first < limit) {
+            PrintBatchResult(badLines.front().first, rpc::JSONValue(),
+                             BatchError(rpc::ErrorCode::PARSE_ERROR, badLines.front().second));
+            badLines.pop_front();
+        }
+    };
+    
+    auto source = [&](std::vector<rpc::RPCRequest>& batch) {
+        std::string line;
+        while (batch.size() < config.batchSize && std::getline(*input, line)) {
+            ++lineNo;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line[start] == '#') {
+                continue;
+            }
+            ++commands;
+            
+            std::string method;
+            rpc::JSONValue params;
+            std::string error;
+            if (!ParseBatchLine(line.substr(start), config.namedParams, method, params, error)) {
+                badLines.emplace_back(lineNo, error);
+                ++failures;
+                continue;
+            }
+            batch.emplace_back(method, params, rpc::JSONValue(static_cast<int64_t>(lineNo)));
+        }
+        return !batch.empty();
+    };
+    
+    auto sink = [&](const std::vector<rpc::RPCRequest>& requests,
+                    std::vector<rpc::RPCResponse>&& responses) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            size_t id = static_cast<size_t>(requests[i].GetId().GetInt());
+            printBadLinesBefore(id);
+            const rpc::RPCResponse& resp = responses[i];
+            if (resp.IsError()) {
+                ++failures;
+                PrintBatchResult(id, rpc::JSONValue(),
+                                 BatchError(resp.GetErrorCode(), resp.GetErrorMessage()));
+            } else {
+                PrintBatchResult(id, resp.GetResult(), rpc::JSONValue());
+            }
+        }
+        std::cout.flush();
+    };
+    
+    bool reached = client.PipelineBatches(source, sink, config.batchInFlight);
+    printBadLinesBefore(SIZE_MAX);
+    std::cout.flush();
+    
+    if (!reached) {
+        std::cerr << "error: Lost connection to server: " << client.GetLastError() << "\n";
+    }
+    if (failures > 0) {
+        std::cerr << failures << " of " << commands << " commands failed\n";
+    }
+    return reached && failures == 0 ? 0 : 1;
+}
+
 // ============================================================================
 // Built-in Commands
 // ============================================================================
@@ -757,7 +975,7 @@ int AppMain(int argc, char* argv[]) {
     }
     
     // Check for command
-    if (config.method.empty()) {
+    if (config.method.empty() && !config.batchMode) {
         std::cerr << "Error: No command specified.\n";
         std::cerr << "Use 'shurium-cli --help' for usage information.\n";
         return 1;
@@ -773,6 +991,14 @@ int AppMain(int argc, char* argv[]) {
         config.rpcPort = defaults::REGTEST_RPC_PORT;
     }
     
+    if (config.batchMode) {
+        if (!config.method.empty()) {
+            std::cerr << "Error: --batch reads its commands from input, not the command line.\n";
+            return 1;
+        }
+        return ExecuteBatch(config);
+    }
+    
     // Try built-in commands first
     int builtinResult = HandleBuiltinCommand(config);
     if (builtinResult != -1) {
@@ -0,0 +1,551 @@
+// SHURIUM RPC Bench - RPC load generator and latency profiler
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+//
+// Drives a running node's JSON-RPC server with a synthetic mix of calls or
+// with calls replayed from a file, and reports throughput and a latency
+// histogram per method. Each worker owns one RPCClient and keeps its
+// connection alive between calls, which is the path shurium-cli takes, so
+// --no-reuse (a new connection per call) shows what keep-alive buys.
+//
+// Load is either closed-loop (--concurrency workers, each sending its next
+// call when the last one returns) or open-loop (--rate calls per second
+// spread over the workers). In open-loop mode latency runs from when a call
+// was due rather than when it was sent, so a server that falls behind is
+// charged for the queueing it causes.
+//
+// Output is JSON lines like the benchmark suites: a header, one line per
+// method with percentiles and the non-empty histogram buckets (upper bound
+// in microseconds, count), and a total line with connection reuse.
+//
+// Note that the server rate-limits each client address by default; start
+// the node being measured with --rpcratelimit=0.
+
+#include <shurium/rpc/client.h>
+#include <shurium/rpc/server.h>
+#include <shurium/util/metrics.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace shurium {
+namespace rpcbench {
+
+using Clock = std::chrono::steady_clock;
+using rpc::JSONValue;
+using rpc::RPCClient;
+using rpc::RPCClientConfig;
+using rpc::RPCContext;
+using rpc::RPCMethod;
+using rpc::RPCRequest;
+using rpc::RPCResponse;
+using rpc::RPCServer;
+using rpc::RPCServerConfig;
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+struct BenchConfig {
+    std::string rpcHost{"127.0.0.1"};
+    uint16_t rpcPort{8332};
+    std::string rpcUser;
+    std::string rpcPassword;
+
+    int concurrency{4};
+    double rate{0.0};            ///< Calls per second over all workers; 0 = closed loop
+    double duration{10.0};       ///< Seconds to run, unless --requests ends it first
+    uint64_t requests{0};        ///< Calls to send in total (0 = until --duration)
+    size_t batch{1};             ///< Calls per HTTP request
+    bool reuse{true};            ///< Keep each worker's connection alive
+
+    std::string mix{"getblockcount:4,getbestblockhash:2,getblock:2,getrawmempool:2,"
+                    "getmempoolinfo:1,getbalance:1,getwalletinfo:1"};
+    std::string replayFile;
+    std::string rawTxFile;
+
+    bool self{false};            ///< Serve the calls from an in-process RPCServer
+    int serverThreads{4};
+};
+
+void PrintUsage(const char* argv0) {
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "Connection:\n"
+        "  --rpcconnect=HOST      RPC server host (default: 127.0.0.1)\n"
+        "  --rpcport=PORT         RPC server port (default: 8332)\n"
+        "  --rpcuser=USER         RPC username\n"
+        "  --rpcpassword=PASS     RPC password\n"
+        "  --no-reuse             Open a new connection for every request\n"
+        "\n"
+        "Load:\n"
+        "  --concurrency=N        Workers, one connection each (default: 4)\n"
+        "  --rate=R               Target calls per second over all workers\n"
+        "                         (default: as fast as the server answers)\n"
+        "  --duration=S           Seconds to run (default: 10)\n"
+        "  --requests=N           Stop after N calls\n"
+        "  --batch=N              Calls per HTTP request (default: 1)\n"
+        "\n"
+        "Workload:\n"
+        "  --mix=M:W,...          Methods and relative weights (default: chain,\n"
+        "                         mempool and wallet reads)\n"
+        "  --replay=FILE          Replay calls from FILE, one {\"method\",\"params\"}\n"
+        "                         object per line, instead of --mix\n"
+        "  --rawtxs=FILE          Hex transactions for sendrawtransaction in --mix\n"
+        "\n"
+        "  --self                 Start an in-process server answering the calls,\n"
+        "                         to measure the RPC path without a node\n"
+        "  --server-threads=N     Worker threads of that server (default: 4)\n",
+        argv0);
+}
+
+bool ParseArgs(int argc, char* argv[], BenchConfig& config) {
+    static const struct option longOptions[] = {
+        {"rpcconnect", required_argument, nullptr, 1},
+        {"rpcport", required_argument, nullptr, 2},
+        {"rpcuser", required_argument, nullptr, 3},
+        {"rpcpassword", required_argument, nullptr, 4},
+        {"no-reuse", no_argument, nullptr, 5},
+        {"concurrency", required_argument, nullptr, 6},
+        {"rate", required_argument, nullptr, 7},
+        {"duration", required_argument, nullptr, 8},
+        {"requests", required_argument, nullptr, 9},
+        {"batch", required_argument, nullptr, 10},
+        {"mix", required_argument, nullptr, 11},
+        {"replay", required_argument, nullptr, 12},
+        {"rawtxs", required_argument, nullptr, 13},
+        {"self", no_argument, nullptr, 14},
+        {"server-threads", required_argument, nullptr, 15},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", longOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 1: config.rpcHost = optarg; break;
+            case 2: config.rpcPort = static_cast<uint16_t>(std::atoi(optarg)); break;
+            case 3: config.rpcUser = optarg; break;
+            case 4: config.rpcPassword = optarg; break;
+            case 5: config.reuse = false; break;
+            case 6: config.concurrency = std::max(1, std::atoi(optarg)); break;
+            case 7: config.rate = std::max(0.0, std::atof(optarg)); break;
+            case 8: config.duration = std::max(0.1, std::atof(optarg)); break;
+            case 9: config.requests = std::strtoull(optarg, nullptr, 10); break;
+            case 10: config.batch = std::max<size_t>(1, std::strtoull(optarg, nullptr, 10)); break;
+            case 11: config.mix = optarg; break;
+            case 12: config.replayFile = optarg; break;
+            case 13: config.rawTxFile = optarg; break;
+            case 14: config.self = true; break;
+            case 15: config.serverThreads = std::max(1, std::atoi(optarg)); break;
+            default: return false;
+        }
+    }
+    return optind == argc;
+}
+
+// ============================================================================
+// Workload
+// ============================================================================
+
+struct Call {
+    std::string method;
+    JSONValue params;
+};
+
+/**
+ * The calls workers draw from: a fixed list replayed in order (each worker
+ * starting at a different offset) or methods drawn by weight.
+ */
+class Workload {
+public:
+    bool LoadReplay(const std::string& path, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::string line;
+        size_t lineNo = 0;
+        while (std::getline(file, line)) {
+            ++lineNo;
+            if (line.empty() || line[0] == '#') continue;
+            auto parsed = JSONValue::TryParse(line);
+            if (!parsed || !parsed->IsObject() || !(*parsed)["method"].IsString()) {
+                error = path + ":" + std::to_string(lineNo) + ": not a {\"method\",\"params\"} object";
+                return false;
+            }
+            replay_.push_back({(*parsed)["method"].GetString(), (*parsed)["params"]});
+        }
+        if (replay_.empty()) {
+            error = path + " holds no calls";
+            return false;
+        }
+        return true;
+    }
+
+    bool ParseMix(const std::string& mix, std::string& error) {
+        size_t pos = 0;
+        while (pos <= mix.size()) {
+            size_t end = mix.find(',', pos);
+            if (end == std::string::npos) end = mix.size();
+            std::string item = mix.substr(pos, end - pos);
+            pos = end + 1;
+            if (item.empty()) continue;
+
+            unsigned weight = 1;
+            size_t colon = item.find(':');
+            if (colon != std::string::npos) {
+                weight = static_cast<unsigned>(std::strtoul(item.c_str() + colon + 1, nullptr, 10));
+                item.resize(colon);
+            }
+            if (weight > 0) {
+                methods_.push_back(item);
+                weights_.push_back(weight);
+            }
+        }
+        if (methods_.empty()) {
+            error = "empty --mix";
+            return false;
+        }
+        return true;
+    }
+
+    bool LoadRawTxs(const std::string& path, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line[0] != '#') rawTxs_.push_back(line);
+        }
+        return true;
+    }
+
+    /**
+     * Fill in the parameters synthetic calls need from the server: the best
+     * block for getblock. sendrawtransaction without --rawtxs cannot be
+     * built and is an error.
+     */
+    bool Prepare(RPCClient& client, std::string& error) {
+        if (!replay_.empty()) return true;
+        for (const auto& method : methods_) {
+            if (method == "getblock" || method == "getblockheader") {
+                RPCResponse resp = client.Call("getbestblockhash");
+                if (resp.IsError()) {
+                    error = "getbestblockhash: " + resp.GetErrorMessage();
+                    return false;
+                }
+                bestBlock_ = resp.GetResult().GetString();
+            } else if (method == "sendrawtransaction" && rawTxs_.empty()) {
+                error = "sendrawtransaction in --mix needs --rawtxs";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Every method that can be drawn
+    std::vector<std::string> Methods() const {
+        std::vector<std::string> methods = methods_;
+        for (const auto& call : replay_) methods.push_back(call.method);
+        std::sort(methods.begin(), methods.end());
+        methods.erase(std::unique(methods.begin(), methods.end()), methods.end());
+        return methods;
+    }
+
+    /// Next call for a worker; cursor is the worker's own position
+    Call Next(std::mt19937_64& rng, uint64_t& cursor) const {
+        if (!replay_.empty()) {
+            return replay_[cursor++ % replay_.size()];
+        }
+        std::discrete_distribution<size_t> pick(weights_.begin(), weights_.end());
+        const std::string& method = methods_[pick(rng)];
+        JSONValue::Array params;
+        if (method == "getblock" || method == "getblockheader") {
+            params.push_back(JSONValue(bestBlock_));
+        } else if (method == "getblockhash") {
+            params.push_back(JSONValue(0));
+        } else if (method == "sendrawtransaction") {
+            // Each worker walks the list from its own offset; a resent
+            // transaction is rejected, which shows up as an error
+            params.push_back(JSONValue(rawTxs_[cursor++ % rawTxs_.size()]));
+        }
+        return {method, JSONValue(params)};
+    }
+
+private:
+    std::vector<Call> replay_;
+    std::vector<std::string> methods_;
+    std::vector<unsigned> weights_;
+    std::vector<std::string> rawTxs_;
+    std::string bestBlock_;
+};
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+struct MethodStats {
+    util::Histogram latency;   ///< Microseconds
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+void ReportLine(const std::string& method, const util::Histogram::Snapshot& snap,
+                uint64_t calls, uint64_t errors, double seconds, const std::string& extra) {
+    std::string buckets;
+    for (size_t i = 0; i < snap.buckets.size(); ++i) {
+        if (snap.buckets[i] == 0) continue;
+        if (!buckets.empty()) buckets += ",";
+        buckets += "[" + std::to_string(util::Histogram::BucketUpperBound(i)) + "," +
+                   std::to_string(snap.buckets[i]) + "]";
+    }
+    std::printf("{\"name\":\"rpc/%s\",\"calls\":%llu,\"errors\":%llu,\"per_sec\":%.1f,"
+                "\"mean_us\":%.1f,\"p50_us\":%llu,\"p90_us\":%llu,\"p99_us\":%llu,"
+                "\"p999_us\":%llu,\"max_us\":%llu%s,\"histogram\":[%s]}\n",
+                method.c_str(),
+                static_cast<unsigned long long>(calls),
+                static_cast<unsigned long long>(errors),
+                seconds > 0 ? static_cast<double>(calls) / seconds : 0.0,
+                snap.count ? static_cast<double>(snap.sum) / static_cast<double>(snap.count) : 0.0,
+                static_cast<unsigned long long>(snap.ValueAt(0.5)),
+                static_cast<unsigned long long>(snap.ValueAt(0.9)),
+                static_cast<unsigned long long>(snap.ValueAt(0.99)),
+                static_cast<unsigned long long>(snap.ValueAt(0.999)),
+                static_cast<unsigned long long>(snap.ValueAt(1.0)),
+                extra.c_str(), buckets.c_str());
+}
+
+// ============================================================================
+// In-process server
+// ============================================================================
+
+/// Answers the workload's methods with small fixed results
+void RegisterStubMethods(RPCServer& server, const std::vector<std::string>& methods) {
+    for (const auto& name : methods) {
+        RPCMethod method;
+        method.name = name;
+        method.readOnly = name != "sendrawtransaction";
+        if (name == "getbestblockhash" || name == "getblockhash") {
+            method.handler = [](const RPCRequest& req, const RPCContext&) {
+                return RPCResponse::Success(JSONValue(std::string(64, '0')), req.GetId());
+            };
+        } else if (name == "getrawmempool") {
+            method.handler = [](const RPCRequest& req, const RPCContext&) {
+                JSONValue::Array txids;
+                for (int i = 0; i < 32; ++i) txids.push_back(JSONValue(std::string(64, 'a')));
+                return RPCResponse::Success(JSONValue(txids), req.GetId());
+            };
+        } else {
+            method.handler = [](const RPCRequest& req, const RPCContext&) {
+                JSONValue::Object result;
+                result["method"] = JSONValue(req.GetMethod());
+                result["params"] = req.GetParams();
+                return RPCResponse::Success(JSONValue(result), req.GetId());
+            };
+        }
+        server.RegisterMethod(method);
+    }
+}
+
+// ============================================================================
+// Run
+// ============================================================================
+
+int Run(const BenchConfig& config) {
+    Workload workload;
+    std::string error;
+    bool loaded = !config.replayFile.empty() ? workload.LoadReplay(config.replayFile, error)
+                                             : workload.ParseMix(config.mix, error);
+    if (loaded && !config.rawTxFile.empty()) {
+        loaded = workload.LoadRawTxs(config.rawTxFile, error);
+    }
+    if (!loaded) {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+
+    RPCClientConfig clientConfig;
+    clientConfig.host = config.rpcHost;
+    clientConfig.port = config.rpcPort;
+    clientConfig.rpcUser = config.rpcUser;
+    clientConfig.rpcPassword = config.rpcPassword;
+
+    std::unique_ptr<RPCServer> server;
+    if (config.self) {
+        RPCServerConfig serverConfig;
+        serverConfig.bindAddress = config.rpcHost;
+        serverConfig.port = config.rpcPort;
+        serverConfig.threadPoolSize = static_cast<size_t>(config.serverThreads);
+        serverConfig.maxConnections = static_cast<size_t>(config.concurrency) * 2 + 16;
+        serverConfig.enableRateLimiting = false;
+        serverConfig.responseCacheSize = 0;
+        server = std::make_unique<RPCServer>(serverConfig);
+        std::vector<std::string> methods = workload.Methods();
+        methods.push_back("getbestblockhash");
+        RegisterStubMethods(*server, methods);
+        if (!server->Start()) {
+            std::fprintf(stderr, "error: cannot listen on %s:%u\n",
+                         config.rpcHost.c_str(), config.rpcPort);
+            return 1;
+        }
+    }
+
+    {
+        RPCClient probe(clientConfig);
+        if (!probe.Connect() || !workload.Prepare(probe, error)) {
+            std::fprintf(stderr, "error: %s\n",
+                         error.empty() ? probe.GetLastError().c_str() : error.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("{\"suite\":\"rpc\",\"host\":\"%s\",\"port\":%u,\"concurrency\":%d,"
+                "\"rate\":%.1f,\"batch\":%zu,\"reuse\":%s,\"workload\":\"%s\"}\n",
+                config.rpcHost.c_str(), config.rpcPort, config.concurrency, config.rate,
+                config.batch, config.reuse ? "true" : "false",
+                config.replayFile.empty() ? "mix" : "replay");
+    std::fflush(stdout);
+
+    // One slot per method, made up front so workers never take a lock
+    std::map<std::string, std::unique_ptr<MethodStats>> stats;
+    for (const auto& method : workload.Methods()) {
+        stats[method] = std::make_unique<MethodStats>();
+    }
+    MethodStats total;
+    util::Histogram batchLatency;
+    std::atomic<uint64_t> claimed{0};
+    std::atomic<uint64_t> connections{0};
+
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.duration));
+    // Open loop: worker w sends request k at start + (k * workers + w) / rate
+    // (a request carries --batch calls)
+    const double interval = config.rate > 0
+        ? static_cast<double>(config.concurrency * config.batch) / config.rate : 0.0;
+
+    auto worker = [&](int index) {
+        RPCClient client(clientConfig);
+        std::mt19937_64 rng(static_cast<uint64_t>(index) * 0x9e3779b97f4a7c15ULL + 1);
+        uint64_t cursor = static_cast<uint64_t>(index) * 7919;
+        int64_t nextId = 1;
+
+        for (uint64_t k = 0; ; ++k) {
+            size_t count = config.batch;
+            if (config.requests > 0) {
+                uint64_t first = claimed.fetch_add(count);
+                if (first >= config.requests) break;
+                count = static_cast<size_t>(std::min<uint64_t>(count, config.requests - first));
+            }
+
+            Clock::time_point due = Clock::now();
+            if (interval > 0) {
+                due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+                    interval * (static_cast<double>(k) +
+                                static_cast<double>(index) / config.concurrency)));
+                if (due >= deadline) break;
+                std::this_thread::sleep_until(due);
+            } else if (due >= deadline) {
+                break;
+            }
+
+            std::vector<Call> calls;
+            calls.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                calls.push_back(workload.Next(rng, cursor));
+            }
+
+            std::vector<bool> failed(count, false);
+            if (count == 1) {
+                failed[0] = client.Call(calls[0].method, calls[0].params).IsError();
+            } else {
+                std::vector<RPCRequest> requests;
+                requests.reserve(count);
+                for (const auto& call : calls) {
+                    requests.emplace_back(call.method, call.params, JSONValue(nextId++));
+                }
+                std::vector<RPCResponse> responses = client.BatchCall(requests);
+                for (size_t i = 0; i < count; ++i) {
+                    failed[i] = i >= responses.size() || responses[i].IsError();
+                }
+            }
+            uint64_t micros = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due).count());
+
+            // Every call in a batch is charged the batch's round trip
+            for (size_t i = 0; i < count; ++i) {
+                MethodStats& slot = *stats.at(calls[i].method);
+                slot.latency.Record(micros);
+                slot.calls.fetch_add(1, std::memory_order_relaxed);
+                total.latency.Record(micros);
+                total.calls.fetch_add(1, std::memory_order_relaxed);
+                if (failed[i]) {
+                    slot.errors.fetch_add(1, std::memory_order_relaxed);
+                    total.errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (count > 1) batchLatency.Record(micros);
+            if (!config.reuse) client.Disconnect();
+        }
+        connections.fetch_add(client.GetConnectionsOpened());
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.concurrency; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const auto& entry : stats) {
+        if (entry.second->calls == 0) continue;
+        ReportLine(entry.first, entry.second->latency.GetSnapshot(),
+                   entry.second->calls, entry.second->errors, seconds, "");
+    }
+
+    uint64_t calls = total.calls;
+    uint64_t opened = connections;
+    char extra[160];
+    std::snprintf(extra, sizeof(extra),
+                  ",\"seconds\":%.3f,\"connections\":%llu,\"calls_per_connection\":%.1f,"
+                  "\"batch_p50_us\":%llu",
+                  seconds, static_cast<unsigned long long>(opened),
+                  opened ? static_cast<double>(calls) / static_cast<double>(opened) : 0.0,
+                  static_cast<unsigned long long>(batchLatency.GetSnapshot().ValueAt(0.5)));
+    ReportLine("total", total.latency.GetSnapshot(), calls, total.errors, seconds, extra);
+    std::fflush(stdout);
+
+    if (server) server->Stop();
+    return calls > 0 && total.errors < calls ? 0 : 1;
+}
+
+} // namespace rpcbench
+} // namespace shurium
+
+int main(int argc, char* argv[]) {
+    shurium::rpcbench::BenchConfig config;
+    if (!shurium::rpcbench::ParseArgs(argc, argv, config)) {
+        shurium::rpcbench::PrintUsage(argv[0]);
+        return 1;
+    }
+    return shurium::rpcbench::Run(config);
+}
@@ -11,19 +11,24 @@
 // - Offline transaction signing
 // - Key export/backup
 // - Password management
+// - Bulk address derivation and signing for offline ceremonies
 
 #include <shurium/wallet/wallet.h>
 #include <shurium/wallet/hdkey.h>
 #include <shurium/wallet/keystore.h>
 #include <shurium/core/hex.h>
 #include <shurium/crypto/sha256.h>
+#include <shurium/util/threadpool.h>
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <optional>
 #include <sstream>
 #include <termios.h>
 #include <unistd.h>
@@ -39,6 +44,12 @@ using namespace shurium::wallet;
 constexpr const char* VERSION = "0.1.0";
 constexpr const char* DEFAULT_WALLET_FILE = "wallet.dat";
 
+/// Keys one bulk derive task derives
+constexpr uint32_t DERIVE_BATCH = 256;
+
+/// Transactions bulk sign reads, signs and writes at a time
+constexpr size_t SIGN_BATCH = 256;
+
 // ============================================================================
 // Terminal Utilities
 // ============================================================================
@@ -927,6 +938,297 @@ int CommandVerify(const std::string& walletPath) {
     }
 }
 
+// ============================================================================
+// Command: Bulk
+// ============================================================================
+
+/// Parse an index list ("0-3,7") of non-hardened indices, ascending
+std::optional<std::vector<uint32_t>> ParseIndexList(const std::string& list) {
+    std::vector<uint32_t> indices;
+    std::istringstream iss(list);
+    std::string range;
+    while (std::getline(iss, range, ',')) {
+        size_t dash = range.find('-');
+        std::string firstText = range.substr(0, dash);
+        std::string lastText = dash == std::string::npos ? firstText : range.substr(dash + 1);
+        if (firstText.empty() || lastText.empty() ||
+            firstText.find_first_not_of("0123456789") != std::string::npos ||
+            lastText.find_first_not_of("0123456789") != std::string::npos ||
+            firstText.size() > 10 || lastText.size() > 10) {
+            return std::nullopt;
+        }
+        uint64_t first = std::stoull(firstText);
+        uint64_t last = std::stoull(lastText);
+        if (last < first || last >= HARDENED_FLAG) {
+            return std::nullopt;
+        }
+        for (uint64_t index = first; index <= last; ++index) {
+            indices.push_back(static_cast<uint32_t>(index));
+        }
+    }
+    if (indices.empty() || list.back() == ',') {
+        return std::nullopt;
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    return indices;
+}
+
+/// Workers for a bulk command: the requested count, else one per core
+util::ThreadPool::Config BulkPoolConfig(uint32_t threads) {
+    util::ThreadPool::Config config;
+    config.numThreads = threads;
+    config.name = "bulk";
+    return config;
+}
+
+/**
+ * Derive count addresses from index first of one chain of every listed
+ * account, written to outputPath as "path,address,pubkey" lines in account
+ * then index order. Batches are derived across the pool from each chain's
+ * public key, and at most two per worker are held before being written.
+ * The wallet file is not changed.
+ */
+int CommandBulkDerive(const std::string& walletPath, const std::string& accountList,
+                      bool change, uint32_t first, uint32_t count,
+                      const std::string& outputPath, uint32_t threads) {
+    fs::path path = walletPath.empty() ? GetDefaultWalletPath() : fs::path(walletPath);
+    
+    auto accounts = ParseIndexList(accountList);
+    if (!accounts) {
+        std::cerr << "Error: --accounts must list account indices, e.g. 0-9,12\n";
+        return 1;
+    }
+    if (count == 0 || static_cast<uint64_t>(first) + count > HARDENED_FLAG) {
+        std::cerr << "Error: --count must be positive and --first + --count at most "
+                  << HARDENED_FLAG << "\n";
+        return 1;
+    }
+    if (outputPath.empty()) {
+        std::cerr << "Error: --output=<path> is required\n";
+        return 1;
+    }
+    
+    if (!fs::exists(path)) {
+        std::cerr << "Error: Wallet not found at " << path << "\n";
+        return 1;
+    }
+    
+    auto wallet = Wallet::Load(path.string());
+    if (!wallet) {
+        std::cerr << "Error: Failed to load wallet\n";
+        return 1;
+    }
+    
+    std::string password = ReadPassword("Enter wallet password: ");
+    if (!wallet->Unlock(password)) {
+        std::cerr << "Error: Incorrect password\n";
+        return 1;
+    }
+    std::fill(password.begin(), password.end(), '\0');
+    
+    auto* hdManager = wallet->GetHDKeyManager();
+    if (!hdManager) {
+        std::cerr << "Error: Wallet has no HD key chain\n";
+        return 1;
+    }
+    
+    std::ofstream out(outputPath, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Cannot write " << outputPath << "\n";
+        return 1;
+    }
+    out << "path,address,pubkey\n";
+    
+    bool testnet = wallet->GetConfig().testnet;
+    uint32_t changeIndex = change ? 1 : 0;
+    util::ThreadPool pool(BulkPoolConfig(threads));
+    size_t window = std::max<size_t>(pool.ThreadCount(), 1) * 2;
+    
+    // Batches in flight, written in submission order
+    std::deque<std::future<std::string>> pending;
+    uint64_t written = 0;
+    auto drain = [&](size_t keep) {
+        while (pending.size() > keep) {
+            std::string lines = pending.front().get();
+            pending.pop_front();
+            written += std::count(lines.begin(), lines.end(), '\n');
+            out << lines;
+        }
+    };
+    
+    for (uint32_t account : *accounts) {
+        auto chainKey = hdManager->GetChainKey(account, changeIndex);
+        if (!chainKey) {
+            std::cerr << "Error: Cannot derive the chain key of account " << account << "\n";
+            return 1;
+        }
+        // Workers only need the public half
+        ExtendedKey chainPub = chainKey->Neuter();
+        
+        uint64_t end = static_cast<uint64_t>(first) + count;
+        for (uint64_t start = first; start < end; start += DERIVE_BATCH) {
+            uint32_t batch = static_cast<uint32_t>(std::min<uint64_t>(DERIVE_BATCH, end - start));
+            pending.push_back(pool.Submit(
+                [chainPub, account, changeIndex, start, batch, testnet] {
+                    std::string lines;
+                    for (const auto& key : HDKeyManager::DeriveChildKeys(
+                             chainPub, account, changeIndex,
+                             static_cast<uint32_t>(start), batch)) {
+                        lines += key.path.ToString();
+                        lines += ',';
+                        lines += EncodeP2WPKH(key.keyHash, testnet);
+                        lines += ',';
+                        lines += BytesToHex(key.publicKey.data(), PublicKey::COMPRESSED_SIZE);
+                        lines += '\n';
+                    }
+                    return lines;
+                }));
+            drain(window);
+        }
+    }
+    drain(0);
+    
+    out.flush();
+    if (!out) {
+        std::cerr << "Error: Failed writing " << outputPath << "\n";
+        return 1;
+    }
+    
+    std::cout << "\nDerived " << written << " addresses for " << accounts->size()
+              << " account(s) into " << outputPath << "\n\n";
+    return 0;
+}
+
+/**
+ * Sign the raw transactions in inputPath, one hex transaction per line, into
+ * outputPath: one line per transaction, the signed hex or "error: <reason>".
+ * Blank lines and lines starting with '#' are skipped. Transactions are
+ * read and signed SIGN_BATCH at a time, each batch across the pool with
+ * its signature hash data precomputed, so memory does not grow with the
+ * file.
+ */
+int CommandBulkSign(const std::string& walletPath, const std::string& inputPath,
+                    const std::string& outputPath, uint32_t threads) {
+    fs::path path = walletPath.empty() ? GetDefaultWalletPath() : fs::path(walletPath);
+    
+    if (inputPath.empty() || outputPath.empty()) {
+        std::cerr << "Error: --input=<path> and --output=<path> are required\n";
+        return 1;
+    }
+    
+    std::ifstream in(inputPath);
+    if (!in) {
+        std::cerr << "Error: Cannot read " << inputPath << "\n";
+        return 1;
+    }
+    
+    if (!fs::exists(path)) {
+        std::cerr << "Error: Wallet not found at " << path << "\n";
+        return 1;
+    }
+    
+    auto wallet = Wallet::Load(path.string());
+    if (!wallet) {
+        std::cerr << "Error: Failed to load wallet\n";
+        return 1;
+    }
+    
+    std::string password = ReadPassword("Enter wallet password: ");
+    if (!wallet->Unlock(password)) {
+        std::cerr << "Error: Incorrect password\n";
+        return 1;
+    }
+    std::fill(password.begin(), password.end(), '\0');
+    
+    if (!AskYesNo("Sign every transaction in " + inputPath + "?", false)) {
+        std::cout << "Aborted.\n";
+        return 0;
+    }
+    
+    std::ofstream out(outputPath, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Cannot write " << outputPath << "\n";
+        return 1;
+    }
+    
+    util::ThreadPool pool(BulkPoolConfig(threads));
+    
+    // The current batch: an output line per transaction line, with its
+    // input line number; parsed transactions and the output line of each
+    std::vector<std::pair<size_t, std::string>> results;
+    std::vector<MutableTransaction> txs;
+    std::vector<size_t> txResult;
+    uint64_t signedCount = 0;
+    uint64_t failedCount = 0;
+    
+    auto fail = [&](size_t index, const std::string& reason) {
+        std::cerr << inputPath << ":" << results[index].first << ": " << reason << "\n";
+        results[index].second = "error: " + reason;
+        ++failedCount;
+    };
+    
+    auto flush = [&] {
+        std::vector<bool> signedOk = wallet->SignTransactions(txs, &pool);
+        for (size_t i = 0; i < txs.size(); ++i) {
+            if (!signedOk[i]) {
+                fail(txResult[i], "missing private keys for some inputs");
+                continue;
+            }
+            DataStream stream;
+            Serialize(stream, txs[i]);
+            results[txResult[i]].second = BytesToHex(std::vector<uint8_t>(stream.begin(), stream.end()));
+            ++signedCount;
+        }
+        for (const auto& [lineNumber, line] : results) {
+            out << line << "\n";
+        }
+        results.clear();
+        txs.clear();
+        txResult.clear();
+    };
+    
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        results.emplace_back(lineNumber, std::string());
+        MutableTransaction mtx;
+        try {
+            DataStream stream(HexToBytes(line));
+            Unserialize(stream, mtx);
+        } catch (...) {
+            fail(results.size() - 1, "not a raw transaction");
+            continue;
+        }
+        txResult.push_back(results.size() - 1);
+        txs.push_back(std::move(mtx));
+        
+        if (results.size() >= SIGN_BATCH) {
+            flush();
+        }
+    }
+    flush();
+    
+    out.flush();
+    if (!out) {
+        std::cerr << "Error: Failed writing " << outputPath << "\n";
+        return 1;
+    }
+    
+    std::cout << "\nSigned " << signedCount << " transaction(s) into " << outputPath;
+    if (failedCount > 0) {
+        std::cout << "; " << failedCount << " failed (see the errors above)";
+    }
+    std::cout << "\n\n";
+    return failedCount > 0 ? 1 : 0;
+}
+
 // ============================================================================
 // Help and Usage
 // ============================================================================
@@ -946,6 +1248,8 @@ void PrintUsage() {
     std::cout << "  sign [hex]      Sign a raw transaction offline\n";
     std::cout << "  verify          Verify wallet integrity and password\n";
     std::cout << "  passwd          Change wallet password\n";
+    std::cout << "  bulk derive     Derive addresses for a range of accounts\n";
+    std::cout << "  bulk sign       Sign a file of raw transactions\n";
     std::cout << "  help            Show this help message\n";
     std::cout << "\n";
     std::cout << "Options:\n";
@@ -956,11 +1260,22 @@ void PrintUsage() {
     std::cout << "  --all            Show all items (not just first few)\n";
     std::cout << "  --show-seed      Show recovery phrase (DANGEROUS)\n";
     std::cout << "\n";
+    std::cout << "Bulk options:\n";
+    std::cout << "  --accounts=<list> Accounts to derive for (e.g. 0-9,12)\n";
+    std::cout << "  --count=<n>      Addresses per account\n";
+    std::cout << "  --first=<n>      First address index (default: 0)\n";
+    std::cout << "  --change         Derive change addresses\n";
+    std::cout << "  --input=<path>   Raw transactions to sign, one hex per line\n";
+    std::cout << "  --output=<path>  File to write results to\n";
+    std::cout << "  --threads=<n>    Worker threads (default: one per core)\n";
+    std::cout << "\n";
     std::cout << "Examples:\n";
     std::cout << "  shurium-wallet create --words=24\n";
     std::cout << "  shurium-wallet import --wallet=backup.dat\n";
     std::cout << "  shurium-wallet address new --label=\"Savings\"\n";
     std::cout << "  shurium-wallet sign\n";
+    std::cout << "  shurium-wallet bulk derive --accounts=0-9 --count=1000 --output=addresses.csv\n";
+    std::cout << "  shurium-wallet bulk sign --input=unsigned.txt --output=signed.txt\n";
     std::cout << "\n";
 }
 
@@ -980,16 +1295,45 @@ struct Options {
     std::string walletPath;
     std::string label;
     std::string txHex;
+    std::string accounts;
+    std::string inputPath;
+    std::string outputPath;
+    uint32_t count = 0;
+    uint32_t first = 0;
+    uint32_t threads = 0;
     int wordCount = 24;
+    bool change = false;
     bool testnet = false;
     bool showAll = false;
     bool showSeed = false;
     bool help = false;
     bool version = false;
+    std::string error;
 };
 
+/// Parse a non-negative 32-bit option value
+std::optional<uint32_t> ParseUInt32(const std::string& text) {
+    if (text.empty() || text.size() > 10 ||
+        text.find_first_not_of("0123456789") != std::string::npos) {
+        return std::nullopt;
+    }
+    uint64_t value = std::stoull(text);
+    if (value > UINT32_MAX) {
+        return std::nullopt;
+    }
+    return static_cast<uint32_t>(value);
+}
+
 Options ParseArgs(int argc, char* argv[]) {
     Options opts;
+    auto parseUInt32 = [&opts](const std::string& arg, size_t prefix, uint32_t& value) {
+        auto parsed = ParseUInt32(arg.substr(prefix));
+        if (parsed) {
+            value = *parsed;
+        } else {
+            opts.error = "Invalid value in " + arg;
+        }
+    };
     
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
@@ -1010,6 +1354,20 @@ Options ParseArgs(int argc, char* argv[]) {
             opts.wordCount = std::stoi(arg.substr(8));
         } else if (arg.rfind("--label=", 0) == 0) {
             opts.label = arg.substr(8);
+        } else if (arg == "--change") {
+            opts.change = true;
+        } else if (arg.rfind("--accounts=", 0) == 0) {
+            opts.accounts = arg.substr(11);
+        } else if (arg.rfind("--input=", 0) == 0) {
+            opts.inputPath = arg.substr(8);
+        } else if (arg.rfind("--output=", 0) == 0) {
+            opts.outputPath = arg.substr(9);
+        } else if (arg.rfind("--count=", 0) == 0) {
+            parseUInt32(arg, 8, opts.count);
+        } else if (arg.rfind("--first=", 0) == 0) {
+            parseUInt32(arg, 8, opts.first);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            parseUInt32(arg, 10, opts.threads);
         } else if (arg[0] != '-') {
             // Positional argument
             if (opts.command.empty()) {
@@ -1037,6 +1395,11 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    if (!opts.error.empty()) {
+        std::cerr << "Error: " << opts.error << "\n";
+        return 1;
+    }
+    
     if (opts.help || opts.command.empty()) {
         PrintUsage();
         return opts.help ? 0 : 1;
@@ -1066,6 +1429,17 @@ int main(int argc, char* argv[]) {
         return CommandVerify(opts.walletPath);
     } else if (opts.command == "passwd" || opts.command == "password") {
         return CommandChangePassword(opts.walletPath);
+    } else if (opts.command == "bulk") {
+        if (opts.subcommand == "derive") {
+            return CommandBulkDerive(opts.walletPath, opts.accounts, opts.change, opts.first,
+                                     opts.count, opts.outputPath, opts.threads);
+        } else if (opts.subcommand == "sign") {
+            return CommandBulkSign(opts.walletPath, opts.inputPath, opts.outputPath,
+                                   opts.threads);
+        } else {
+            std::cerr << "Unknown bulk subcommand: " << opts.subcommand << "\n";
+            return 1;
+        }
     } else if (opts.command == "help") {
         PrintUsage();
         return 0;
@@ -11,10 +11,21 @@
 // - Staking and governance participation
 
 #include <shurium/core/types.h>
+#include <shurium/chain/txindexer.h>
+#include <shurium/chain/blockfilterindexer.h>
+#include <shurium/db/coinfilter.h>
 #include <shurium/node/context.h>
 #include <shurium/rpc/server.h>
 #include <shurium/rpc/commands.h>
+#include <shurium/rpc/metrics.h>
+#include <shurium/rpc/notify.h>
+#include <shurium/rpc/rest.h>
+#include <shurium/rpc/stratum.h>
 #include <shurium/util/logging.h>
+#include <shurium/util/affinity.h>
+#include <shurium/util/metrics.h>
+#include <shurium/util/shutdown.h>
+#include <shurium/util/startup.h>
 #include <shurium/wallet/wallet.h>
 #include <shurium/miner/miner.h>
 #include <shurium/staking/staking.h>
@@ -24,8 +35,10 @@
 #include <shurium/economics/reward.h>
 #include <shurium/identity/identity.h>
 #include <shurium/governance/governance.h>
+#include <shurium/governance/snapshot.h>
 #include <shurium/marketplace/marketplace.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
@@ -85,7 +98,8 @@ namespace defaults {
     
     constexpr int MAX_CONNECTIONS = 125;
     constexpr int RPC_THREADS = 4;
-    constexpr int DB_CACHE_MB = 450;
+    constexpr int RPC_RATE_LIMIT = 600;
+    constexpr int DB_CACHE_MB = 0;  // Sized from physical memory
 }
 
 // ============================================================================
@@ -111,33 +125,52 @@ struct DaemonConfig {
     std::string rpcPassword;
     bool rpcAllowRemote{false};
     int rpcThreads{defaults::RPC_THREADS};
+    int rpcRateLimit{defaults::RPC_RATE_LIMIT};   ///< Requests per minute per client, 0 = off
+    bool rest{false};
+    bool metrics{false};
+    bool notify{false};
+    uint16_t notifyPort{rpc::DEFAULT_NOTIFY_PORT};
     
     // === P2P Network ===
     bool listen{true};
     std::string bind{"0.0.0.0"};
     uint16_t port{defaults::P2P_PORT};
     int maxConnections{defaults::MAX_CONNECTIONS};
+    uint64_t maxUploadTarget{0};     // MiB per day, 0 = no target
+    uint64_t maxSendRate{0};         // KB/s per peer, 0 = unlimited
+    uint64_t maxSendRateTotal{0};    // KB/s all peers, 0 = unlimited
     std::vector<std::string> addNodes;
     std::vector<std::string> connectNodes;
     bool dnsSeed{true};
     
     // === Blockchain ===
     int dbCache{defaults::DB_CACHE_MB};
+    int coinFilter{db::DEFAULT_COIN_FILTER_MB};  // MB
     bool txIndex{false};
+    bool blockFilterIndex{false};
     bool reindex{false};
     bool prune{false};
     int pruneSize{550};  // MB
+    int scriptCheckThreads{DEFAULT_SCRIPTCHECK_THREADS};
+    std::vector<std::string> threadAffinity;   // role=cpulist
+    bool autoThreadPlacement{true};
+    bool persistMempool{true};
     
     // === Wallet ===
     bool walletEnabled{true};
     std::string walletFile{"wallet.dat"};
     bool walletBroadcast{true};
+    uint32_t walletKeypool{wallet::DEFAULT_KEYPOOL_SIZE};
     
     // === Mining/Staking ===
     bool mining{false};
     bool staking{false};
     std::string miningAddress;
     int miningThreads{1};
+    std::string miningBackend{miner::DEFAULT_MINING_BACKEND};
+    bool stratum{false};
+    uint16_t stratumPort{rpc::DEFAULT_STRATUM_PORT};
+    double stratumDifficulty{rpc::DEFAULT_STRATUM_DIFFICULTY};
     
     // === Fund Addresses ===
     std::string ubiAddress;
@@ -150,6 +183,7 @@ struct DaemonConfig {
     bool logTimestamps{true};
     bool logToConsole{true};
     bool logToFile{true};
+    bool logAsync{true};
     std::vector<std::string> debugCategories;
     
     // === Daemon Mode ===
@@ -177,11 +211,14 @@ static std::unique_ptr<rpc::RPCCommandTable> g_rpcCommands;
 static std::unique_ptr<NodeContext> g_node;
 static std::shared_ptr<wallet::Wallet> g_wallet;
 static std::unique_ptr<miner::Miner> g_miner;
+static std::unique_ptr<rpc::StratumServer> g_stratum;
+static std::unique_ptr<rpc::NotificationPublisher> g_notify;
 static std::unique_ptr<staking::StakingEngine> g_stakingEngine;
 static std::shared_ptr<identity::IdentityManager> g_identityManager;
 static std::shared_ptr<economics::UBIDistributor> g_ubiDistributor;
 static std::unique_ptr<economics::RewardCalculator> g_rewardCalculator;
 static std::shared_ptr<governance::GovernanceEngine> g_governanceEngine;
+static std::unique_ptr<governance::GovernanceSnapshotWriter> g_governanceSnapshots;
 
 // ============================================================================
 // Signal Handling
@@ -401,32 +438,60 @@ void PrintHelp() {
     std::cout << "  --rpcpassword=PASS         RPC password\n";
     std::cout << "  --rpcallowip=IP            Allow RPC from IP (can repeat)\n";
     std::cout << "  --rpcthreads=N             RPC thread count (default: 4)\n";
+    std::cout << "  --rpcratelimit=N           RPC requests per minute per client, 0 for no limit (default: 600)\n";
     std::cout << "  --server=0/1               Enable/disable RPC server (default: 1)\n";
+    std::cout << "  --rest=0/1                 Serve public chain data over REST on the RPC port (default: 0)\n";
+    std::cout << "  --metrics=0/1              Serve Prometheus metrics at /metrics on the RPC port (default: 0)\n";
+    std::cout << "  --notify=0/1               Push blocks and transactions over WebSocket (default: 0)\n";
+    std::cout << "  --notifyport=PORT          WebSocket notification port, on the RPC bind address (default: 28332)\n";
     std::cout << "\nNetwork Options:\n";
     std::cout << "  --listen=0/1               Accept incoming connections (default: 1)\n";
     std::cout << "  --bind=ADDR                Bind to address\n";
     std::cout << "  --port=PORT                Listen port (default: 8333)\n";
     std::cout << "  --maxconnections=N         Max connections (default: 125)\n";
+    std::cout << "  --maxuploadtarget=N        Stop serving old blocks past N MiB sent per day (default: 0 = no target)\n";
+    std::cout << "  --maxsendrate=N            Max upload to each peer in KB/s (default: 0 = unlimited)\n";
+    std::cout << "  --maxsendratetotal=N       Max upload to all peers in KB/s (default: 0 = unlimited)\n";
     std::cout << "  --addnode=IP               Add node to connect to (can repeat)\n";
     std::cout << "  --connect=IP               Connect only to these nodes (can repeat)\n";
     std::cout << "  --dnsseed=0/1              Use DNS seeds (default: 1)\n";
     std::cout << "\nBlockchain Options:\n";
-    std::cout << "  --dbcache=N                Database cache size in MB (default: 450)\n";
+    std::cout << "  --dbcache=N                Database cache size in MB (default: 0 = sized from RAM)\n";
+    std::cout << "  --coinfilter=N             UTXO lookup filter size in MB, 0 to disable (default: 32)\n";
     std::cout << "  --txindex                  Enable transaction index\n";
+    std::cout << "  --blockfilterindex=0/1     Index compact block filters and serve them to peers (default: 0)\n";
     std::cout << "  --reindex                  Rebuild blockchain index\n";
     std::cout << "  --prune=N                  Prune blockchain to N MB\n";
+    std::cout << "  --par=N                    Script verification threads (0 = auto, <0 = leave N cores free)\n";
+    std::cout << "  --threadaffinity=ROLE=CPUS Pin a thread role (scriptcheck, msgproc, msgheavy, rpc, miner,\n"
+              << "                             eventloop) to a CPU list such as 0-3,8 (can repeat)\n";
+    std::cout << "  --autoaffinity=0/1         Place unpinned roles by NUMA node on multi-node machines (default: 1)\n";
+    std::cout << "  --assumevalid=HASH         Skip script checks for ancestors of this block (0 = verify all)\n";
+    std::cout << "  --persistmempool=0/1       Save the mempool on shutdown and load it on startup (default: 1)\n";
     std::cout << "\nWallet Options:\n";
     std::cout << "  --disablewallet            Disable wallet functionality\n";
     std::cout << "  --wallet=FILE              Wallet file name\n";
+    std::cout << "  --keypool=N                Keys pre-derived per address chain (default: "
+              << wallet::DEFAULT_KEYPOOL_SIZE << ", 0 = derive on demand)\n";
     std::cout << "\nMining/Staking Options:\n";
     std::cout << "  --gen=0/1                  Enable mining (default: 0)\n";
     std::cout << "  --genthreads=N             Mining threads (default: 1)\n";
+    std::cout << "  --minerbackend=NAME        Nonce search backend: ";
+    std::vector<std::string> backends = miner::GetMiningBackendNames();
+    for (size_t i = 0; i < backends.size(); ++i) {
+        std::cout << (i ? ", " : "") << backends[i];
+    }
+    std::cout << " (default: " << miner::DEFAULT_MINING_BACKEND << ")\n";
     std::cout << "  --miningaddress=ADDR       Address for mining rewards\n";
+    std::cout << "  --stratum=0/1              Serve mining hardware over Stratum (default: 0)\n";
+    std::cout << "  --stratumport=PORT         Stratum port (default: 3333)\n";
+    std::cout << "  --stratumdifficulty=N      Stratum share difficulty (default: 1)\n";
     std::cout << "  --staking=0/1              Enable staking (default: 0)\n";
     std::cout << "\nLogging Options:\n";
     std::cout << "  --debug=CATEGORY           Enable debug for category (can repeat)\n";
     std::cout << "  --loglevel=LEVEL           Log level: trace, debug, info, warn, error\n";
     std::cout << "  --printtoconsole=0/1       Print to console (default: 1)\n";
+    std::cout << "  --logasync=0/1             Write log output from a background thread (default: 1)\n";
     std::cout << "\n";
 }
 
@@ -452,6 +517,7 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
         {"rpcpassword", required_argument, nullptr, 1006},
         {"rpcallowip", required_argument, nullptr, 1007},
         {"rpcthreads", required_argument, nullptr, 1008},
+        {"rpcratelimit", required_argument, nullptr, 1048},
         {"server", required_argument, nullptr, 1009},
         {"listen", required_argument, nullptr, 1010},
         {"bind", required_argument, nullptr, 1011},
@@ -470,9 +536,29 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
         {"genthreads", required_argument, nullptr, 1024},
         {"staking", required_argument, nullptr, 1025},
         {"miningaddress", required_argument, nullptr, 1029},
+        {"par", required_argument, nullptr, 1030},
+        {"threadaffinity", required_argument, nullptr, 1049},
+        {"autoaffinity", required_argument, nullptr, 1050},
+        {"assumevalid", required_argument, nullptr, 1031},
+        {"coinfilter", required_argument, nullptr, 1032},
+        {"persistmempool", required_argument, nullptr, 1033},
+        {"stratum", required_argument, nullptr, 1034},
+        {"stratumport", required_argument, nullptr, 1035},
+        {"stratumdifficulty", required_argument, nullptr, 1036},
+        {"minerbackend", required_argument, nullptr, 1037},
+        {"maxuploadtarget", required_argument, nullptr, 1038},
+        {"maxsendrate", required_argument, nullptr, 1039},
+        {"maxsendratetotal", required_argument, nullptr, 1040},
+        {"notify", required_argument, nullptr, 1041},
+        {"notifyport", required_argument, nullptr, 1042},
+        {"rest", required_argument, nullptr, 1043},
+        {"metrics", required_argument, nullptr, 1047},
+        {"blockfilterindex", required_argument, nullptr, 1044},
+        {"keypool", required_argument, nullptr, 1045},
         {"debug", required_argument, nullptr, 1026},
         {"loglevel", required_argument, nullptr, 1027},
         {"printtoconsole", required_argument, nullptr, 1028},
+        {"logasync", required_argument, nullptr, 1046},
         {nullptr, 0, nullptr, 0}
     };
     
@@ -522,6 +608,9 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
             case 1008:  // --rpcthreads
                 config.rpcThreads = std::stoi(optarg);
                 break;
+            case 1048:  // --rpcratelimit
+                config.rpcRateLimit = std::stoi(optarg);
+                break;
             case 1009:  // --server
                 config.rpcEnabled = (std::string(optarg) != "0");
                 break;
@@ -537,6 +626,27 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
             case 1013:  // --maxconnections
                 config.maxConnections = std::stoi(optarg);
                 break;
+            case 1038:  // --maxuploadtarget
+                config.maxUploadTarget = std::stoull(optarg);
+                break;
+            case 1039:  // --maxsendrate
+                config.maxSendRate = std::stoull(optarg);
+                break;
+            case 1040:  // --maxsendratetotal
+                config.maxSendRateTotal = std::stoull(optarg);
+                break;
+            case 1041:  // --notify
+                config.notify = (std::string(optarg) != "0");
+                break;
+            case 1042:  // --notifyport
+                config.notifyPort = static_cast<uint16_t>(std::stoi(optarg));
+                break;
+            case 1043:  // --rest
+                config.rest = (std::string(optarg) != "0");
+                break;
+            case 1047:  // --metrics
+                config.metrics = (std::string(optarg) != "0");
+                break;
             case 1014:  // --addnode
                 config.addNodes.push_back(optarg);
                 break;
@@ -549,15 +659,21 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
             case 1017:  // --dbcache
                 config.dbCache = std::stoi(optarg);
                 break;
+            case 1032:  // --coinfilter
+                config.coinFilter = std::stoi(optarg);
+                break;
             case 1018:  // --txindex
                 config.txIndex = true;
                 break;
+            case 1044:  // --blockfilterindex
+                config.blockFilterIndex = (std::string(optarg) != "0");
+                break;
             case 1019:  // --reindex
                 config.reindex = true;
                 break;
             case 1020:  // --prune
-                config.prune = true;
                 config.pruneSize = std::stoi(optarg);
+                config.prune = config.pruneSize > 0;  // --prune=0 disables
                 break;
             case 1021:  // --disablewallet
                 config.walletEnabled = false;
@@ -565,6 +681,9 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
             case 1022:  // --wallet
                 config.walletFile = optarg;
                 break;
+            case 1045:  // --keypool
+                config.walletKeypool = static_cast<uint32_t>(std::max(0, std::stoi(optarg)));
+                break;
             case 1023:  // --gen
                 config.mining = (std::string(optarg) != "0");
                 break;
@@ -577,6 +696,34 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
             case 1029:  // --miningaddress
                 config.miningAddress = optarg;
                 break;
+            case 1034:  // --stratum
+                config.stratum = (std::string(optarg) != "0");
+                break;
+            case 1035:  // --stratumport
+                config.stratumPort = static_cast<uint16_t>(std::stoi(optarg));
+                break;
+            case 1036:  // --stratumdifficulty
+                config.stratumDifficulty = std::stod(optarg);
+                break;
+            case 1037:  // --minerbackend
+                config.miningBackend = optarg;
+                break;
+            case 1030:  // --par
+                config.scriptCheckThreads = std::stoi(optarg);
+                break;
+            case 1049:  // --threadaffinity
+                config.threadAffinity.push_back(optarg);
+                break;
+            case 1050:  // --autoaffinity
+                config.autoThreadPlacement = (std::string(optarg) != "0");
+                break;
+            case 1031:  // --assumevalid
+                config.assumeValidBlock = optarg;
+                config.assumeValid = (config.assumeValidBlock != "0");
+                break;
+            case 1033:  // --persistmempool
+                config.persistMempool = (std::string(optarg) != "0");
+                break;
             case 1026:  // --debug
                 config.debugCategories.push_back(optarg);
                 break;
@@ -586,6 +733,9 @@ bool ParseCommandLine(int argc, char* argv[], DaemonConfig& config) {
             case 1028:  // --printtoconsole
                 config.printToConsole = (std::string(optarg) != "0");
                 break;
+            case 1046:  // --logasync
+                config.logAsync = (std::string(optarg) != "0");
+                break;
             default:
                 return false;
         }
@@ -620,9 +770,24 @@ void LoadConfigFile(DaemonConfig& config) {
         if (parser.HasOption("rpcallowip")) {
             config.rpcAllowRemote = true;
         }
+        if (parser.HasOption("rpcratelimit")) {
+            config.rpcRateLimit = static_cast<int>(parser.GetInt("rpcratelimit"));
+        }
         if (parser.HasOption("server")) {
             config.rpcEnabled = parser.GetBool("server", true);
         }
+        if (parser.HasOption("rest")) {
+            config.rest = parser.GetBool("rest");
+        }
+        if (parser.HasOption("metrics")) {
+            config.metrics = parser.GetBool("metrics");
+        }
+        if (parser.HasOption("notify")) {
+            config.notify = parser.GetBool("notify");
+        }
+        if (config.notifyPort == rpc::DEFAULT_NOTIFY_PORT && parser.HasOption("notifyport")) {
+            config.notifyPort = static_cast<uint16_t>(parser.GetInt("notifyport"));
+        }
         if (parser.HasOption("testnet")) {
             config.testnet = parser.GetBool("testnet");
             if (config.testnet) config.network = "testnet";
@@ -634,21 +799,71 @@ void LoadConfigFile(DaemonConfig& config) {
         if (parser.HasOption("txindex")) {
             config.txIndex = parser.GetBool("txindex");
         }
+        if (parser.HasOption("blockfilterindex")) {
+            config.blockFilterIndex = parser.GetBool("blockfilterindex");
+        }
         if (parser.HasOption("listen")) {
             config.listen = parser.GetBool("listen", true);
         }
         if (parser.HasOption("dbcache")) {
             config.dbCache = parser.GetInt("dbcache", defaults::DB_CACHE_MB);
         }
+        if (parser.HasOption("coinfilter")) {
+            config.coinFilter = parser.GetInt("coinfilter", db::DEFAULT_COIN_FILTER_MB);
+        }
+        if (parser.HasOption("par")) {
+            config.scriptCheckThreads = parser.GetInt("par", DEFAULT_SCRIPTCHECK_THREADS);
+        }
+        for (const auto& spec : parser.GetMultiple("threadaffinity")) {
+            config.threadAffinity.push_back(spec);
+        }
+        if (parser.HasOption("autoaffinity")) {
+            config.autoThreadPlacement = parser.GetBool("autoaffinity", true);
+        }
+        if (parser.HasOption("persistmempool")) {
+            config.persistMempool = parser.GetBool("persistmempool", true);
+        }
+        if (parser.HasOption("assumevalid")) {
+            config.assumeValidBlock = parser.GetString("assumevalid");
+            config.assumeValid = (config.assumeValidBlock != "0");
+        }
         if (parser.HasOption("maxconnections")) {
             config.maxConnections = parser.GetInt("maxconnections", defaults::MAX_CONNECTIONS);
         }
+        if (parser.HasOption("maxuploadtarget")) {
+            config.maxUploadTarget = static_cast<uint64_t>(
+                std::max<int64_t>(0, parser.GetInt("maxuploadtarget", 0)));
+        }
+        if (parser.HasOption("maxsendrate")) {
+            config.maxSendRate = static_cast<uint64_t>(
+                std::max<int64_t>(0, parser.GetInt("maxsendrate", 0)));
+        }
+        if (parser.HasOption("maxsendratetotal")) {
+            config.maxSendRateTotal = static_cast<uint64_t>(
+                std::max<int64_t>(0, parser.GetInt("maxsendratetotal", 0)));
+        }
         if (parser.HasOption("disablewallet")) {
             config.walletEnabled = !parser.GetBool("disablewallet");
         }
+        if (config.walletKeypool == wallet::DEFAULT_KEYPOOL_SIZE && parser.HasOption("keypool")) {
+            config.walletKeypool = static_cast<uint32_t>(
+                std::max<int64_t>(0, parser.GetInt("keypool", wallet::DEFAULT_KEYPOOL_SIZE)));
+        }
         if (parser.HasOption("staking")) {
             config.staking = parser.GetBool("staking");
         }
+        if (config.miningBackend == miner::DEFAULT_MINING_BACKEND && parser.HasOption("minerbackend")) {
+            config.miningBackend = parser.GetString("minerbackend");
+        }
+        if (parser.HasOption("stratum")) {
+            config.stratum = parser.GetBool("stratum");
+        }
+        if (config.stratumPort == rpc::DEFAULT_STRATUM_PORT && parser.HasOption("stratumport")) {
+            config.stratumPort = static_cast<uint16_t>(parser.GetInt("stratumport"));
+        }
+        if (parser.HasOption("stratumdifficulty")) {
+            config.stratumDifficulty = std::stod(parser.GetString("stratumdifficulty"));
+        }
         
         // Add nodes from config
         auto addNodes = parser.GetMultiple("addnode");
@@ -826,6 +1041,124 @@ void RemovePidFile(const std::string& pidFile) {
     std::remove(pidFile.c_str());
 }
 
+/// Key of the daemon's collector in the metrics registry
+static constexpr const char* NODE_METRICS_COLLECTOR = "node";
+
+/// Escape a Prometheus label value
+std::string MetricLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+        }
+        escaped += c == '\n' ? ' ' : c;
+    }
+    return escaped;
+}
+
+/// Expose the subsystems' statistics structs on each scrape. Unregistered
+/// at the start of Shutdown(), before any of them is destroyed.
+void RegisterNodeMetrics() {
+    util::MetricsRegistry::Instance().RegisterCollector(NODE_METRICS_COLLECTOR,
+                                                        [](util::MetricsWriter& out) {
+        if (g_node) {
+            out.WriteGauge("shurium_ready", "Whether the node can serve (1) or not (0)",
+                           g_node->startup.IsReady() ? 1 : 0);
+            for (const auto& phase : g_node->startup.GetPhases()) {
+                out.WriteGauge(std::string("shurium_startup_phase_seconds{phase=\"") +
+                                   util::StartupPhaseName(phase.phase) + "\"}",
+                               "Time spent in each startup phase",
+                               std::chrono::duration<double>(phase.elapsed).count());
+            }
+        }
+        if (g_node && g_node->chainman) {
+            out.WriteGauge("shurium_chain_height", "Height of the active chain tip",
+                           g_node->chainman->GetActiveHeight());
+        }
+        if (g_node && g_node->mempool) {
+            out.WriteGauge("shurium_mempool_transactions", "Transactions in the mempool",
+                           static_cast<double>(g_node->mempool->Size()));
+            out.WriteGauge("shurium_mempool_bytes", "Serialized size of the mempool",
+                           static_cast<double>(g_node->mempool->GetTotalSize()));
+            out.WriteGauge("shurium_mempool_memory_bytes", "Heap memory held by the mempool",
+                           static_cast<double>(g_node->mempool->DynamicMemoryUsage()));
+        }
+        std::vector<util::ThreadRoleStats> roles = util::ThreadPlacement::Instance().GetStats();
+        for (const auto& role : roles) {
+            out.WriteCounter("shurium_thread_cpu_seconds_total{pool=\"" + role.role + "\"}",
+                             "CPU time used by each thread pool", role.cpuSeconds);
+        }
+        for (const auto& role : roles) {
+            out.WriteGauge("shurium_thread_pinned_cores{pool=\"" + role.role + "\"}",
+                           "Cores each thread pool is pinned to, 0 if it floats",
+                           static_cast<double>(role.cores.size()));
+        }
+        if (g_node && g_node->connman) {
+            out.WriteGauge("shurium_net_peers", "Connected peers",
+                           static_cast<double>(g_node->connman->GetPeerCount()));
+        }
+        if (g_node && g_node->msgproc) {
+            MessageStats stats = g_node->msgproc->GetStats();
+            const std::pair<const char*, uint64_t> byType[] = {
+                {"version", stats.versionMessages}, {"verack", stats.verackMessages},
+                {"ping", stats.pingMessages}, {"pong", stats.pongMessages},
+                {"inv", stats.invMessages}, {"getdata", stats.getdataMessages},
+                {"headers", stats.headersMessages}, {"block", stats.blockMessages},
+                {"tx", stats.txMessages}, {"addr", stats.addrMessages},
+                {"cmpctblock", stats.compactBlocks}, {"unknown", stats.unknownMessages},
+                {"invalid", stats.invalidMessages}};
+            out.WriteCounter("shurium_net_messages_processed_total", "P2P messages handled",
+                             static_cast<double>(stats.messagesProcessed));
+            for (const auto& [type, count] : byType) {
+                out.WriteCounter(std::string("shurium_net_messages_total{type=\"") + type + "\"}",
+                                 "P2P messages received by type", static_cast<double>(count));
+            }
+            out.WriteCounter("shurium_net_compact_block_fallbacks_total",
+                             "Compact blocks that needed the full block",
+                             static_cast<double>(stats.compactFallbacks));
+        }
+        if (g_node && g_node->syncman) {
+            SyncStats stats = g_node->syncman->GetStats();
+            out.WriteGauge("shurium_sync_best_header_height", "Height of the best header",
+                           stats.bestHeaderHeight);
+            out.WriteGauge("shurium_sync_network_height", "Highest height peers announced",
+                           stats.networkHeight);
+            out.WriteCounter("shurium_sync_blocks_downloaded_total", "Blocks downloaded",
+                             static_cast<double>(stats.blocksDownloaded));
+            out.WriteGauge("shurium_sync_downloading_peers", "Peers blocks are downloaded from",
+                           static_cast<double>(stats.downloadingPeers));
+        }
+        if (g_miner) {
+            const miner::MiningStats& stats = g_miner->GetStats();
+            out.WriteCounter("shurium_miner_hashes_total", "Hashes computed",
+                             static_cast<double>(stats.hashesComputed.load()));
+            out.WriteCounter("shurium_miner_blocks_found_total", "Blocks found",
+                             stats.blocksFound.load());
+            out.WriteCounter("shurium_miner_blocks_accepted_total", "Blocks found and accepted",
+                             stats.blocksAccepted.load());
+            out.WriteCounter("shurium_miner_templates_stale_total",
+                             "Templates given up because the tip moved",
+                             static_cast<double>(stats.templatesStale.load()));
+        }
+        auto& marketplace = marketplace::Marketplace::Instance();
+        if (marketplace.IsRunning()) {
+            marketplace::MarketplaceStats stats = marketplace.GetStats();
+            out.WriteGauge("shurium_marketplace_pending_problems", "Problems awaiting solutions",
+                           static_cast<double>(stats.pendingProblems));
+            out.WriteGauge("shurium_marketplace_pending_solutions", "Solutions awaiting verification",
+                           static_cast<double>(stats.pendingSolutions));
+            out.WriteCounter("shurium_marketplace_solutions_accepted_total", "Solutions accepted",
+                             static_cast<double>(stats.totalAccepted));
+            out.WriteCounter("shurium_marketplace_solutions_rejected_total", "Solutions rejected",
+                             static_cast<double>(stats.totalRejected));
+        }
+        for (const auto& fund : economics::GetAllFundStats()) {
+            out.WriteGauge("shurium_fund_balance{fund=\"" + MetricLabel(fund.name) + "\"}",
+                           "Fund balance in base units", static_cast<double>(fund.balance));
+        }
+    });
+}
+
 bool StartRPCServer(const DaemonConfig& config) {
     if (!config.rpcEnabled) {
         LOG_INFO(util::LogCategory::RPC) << "RPC server disabled";
@@ -840,7 +1173,8 @@ bool StartRPCServer(const DaemonConfig& config) {
     rpcConfig.rpcPassword = config.rpcPassword;
     rpcConfig.allowRemote = config.rpcAllowRemote;
     rpcConfig.threadPoolSize = static_cast<size_t>(config.rpcThreads);
-    rpcConfig.enableRateLimiting = true;
+    rpcConfig.enableRateLimiting = config.rpcRateLimit > 0;
+    rpcConfig.maxRequestsPerMinute = static_cast<size_t>(std::max(config.rpcRateLimit, 0));
     
     // Create RPC server
     g_rpcServer = std::make_unique<rpc::RPCServer>(rpcConfig);
@@ -849,6 +1183,17 @@ bool StartRPCServer(const DaemonConfig& config) {
     g_rpcCommands = std::make_unique<rpc::RPCCommandTable>();
     g_rpcCommands->SetDataDir(config.dataDir);  // Set data directory for wallet paths
     g_rpcCommands->RegisterCommands(*g_rpcServer);
+    if (config.rest) {
+        rpc::RegisterRESTHandlers(*g_rpcServer, *g_rpcCommands);
+        LOG_INFO(util::LogCategory::RPC) << "REST interface enabled under " << rpc::REST_PATH_PREFIX;
+    }
+    if (config.metrics) {
+        rpc::RegisterMetricsHandler(*g_rpcServer, util::MetricsRegistry::Instance());
+        LOG_INFO(util::LogCategory::RPC) << "Metrics served at " << rpc::METRICS_PATH;
+    }
+    if (g_node) {
+        rpc::RegisterReadinessHandler(*g_rpcServer, g_node->startup);
+    }
     
     // Start server
     if (!g_rpcServer->Start()) {
@@ -891,6 +1236,7 @@ bool InitializeWallet(const DaemonConfig& config) {
             wallet::Wallet::Config walletConfig;
             walletConfig.name = "default";
             walletConfig.testnet = config.testnet;
+            walletConfig.keypoolSize = config.walletKeypool;
             
             g_wallet = wallet::Wallet::Load(walletPath, walletConfig);
             if (g_wallet) {
@@ -914,6 +1260,7 @@ bool InitializeWallet(const DaemonConfig& config) {
         wallet::Wallet::Config walletConfig;
         walletConfig.name = "default";
         walletConfig.testnet = config.testnet;
+        walletConfig.keypoolSize = config.walletKeypool;
         
         // Generate new wallet (with empty password initially - user should encrypt it)
         g_wallet = wallet::Wallet::Generate("", wallet::Mnemonic::Strength::Words24, walletConfig);
@@ -993,6 +1340,12 @@ void WaitForShutdown() {
     while (!shurium::ShutdownRequested()) {
         g_shutdownCondition.wait_for(lock, std::chrono::seconds(1));
         
+        if (g_node) {
+            lock.unlock();
+            MaintainNodeState(*g_node);
+            lock.lock();
+        }
+        
         // Check for config reload request (from SIGHUP)
         if (g_reloadConfig.exchange(false)) {
             lock.unlock();
@@ -1005,14 +1358,79 @@ void WaitForShutdown() {
 void Shutdown() {
     LOG_INFO(util::LogCategory::DEFAULT) << "Shutting down...";
     
-    // Stop miner first
-    if (g_miner) {
-        LOG_INFO(util::LogCategory::DEFAULT) << "Stopping miner...";
-        g_miner->Stop();
-        g_miner.reset();
+    // Fail readiness probes first, so traffic drains while we stop
+    if (g_node) {
+        g_node->startup.MarkStopping();
+    }
+    
+    // Scrapes read the globals torn down below
+    util::MetricsRegistry::Instance().UnregisterCollector(NODE_METRICS_COLLECTOR);
+    
+    // Stop pushing notifications before their sources go away
+    if (g_notify) {
+        if (g_node && g_node->mempool) {
+            g_node->mempool->SetNotifyAdded(nullptr);
+        }
+        if (g_ubiDistributor) {
+            g_ubiDistributor->SetEpochFinalizedCallback(nullptr);
+        }
+        if (g_governanceEngine) {
+            g_governanceEngine->SetParameterChangeCallback(nullptr);
+            g_governanceEngine->SetProtocolUpgradeCallback(nullptr);
+        }
     }
     
-    // Stop RPC server (so no new requests come in)
+    util::ShutdownCoordinator shutdown;
+    
+    // Stop taking work from outside. Only Stop() runs here: an RPC handler
+    // still in flight may reach the miner, so nothing is destroyed until
+    // every front end has stopped
+    shutdown.AddStage("frontends");
+    if (g_notify) {
+        shutdown.AddStep("notify", [] { g_notify->Stop(); });
+    }
+    if (g_stratum || g_miner) {
+        shutdown.AddStep("mining", [] {
+            if (g_stratum) {
+                g_stratum->Stop();
+            }
+            if (g_miner) {
+                g_miner->Stop();
+            }
+        });
+    }
+    if (g_rpcServer) {
+        shutdown.AddStep("rpc", [] { g_rpcServer->Stop(); });
+    }
+    
+    // Caches the next start can rebuild; both write through a temporary file
+    shutdown.AddStage("caches", SHUTDOWN_SAVE_DEADLINE);
+    if (g_governanceSnapshots) {
+        // Snapshot governance state so the next start has nothing to catch up on
+        if (g_governanceEngine) {
+            g_governanceSnapshots->Submit(governance::GovernanceSnapshot::Capture(
+                g_governanceEngine->GetCurrentHeight(), *g_governanceEngine));
+        }
+        std::shared_ptr<governance::GovernanceSnapshotWriter> snapshots(
+            std::move(g_governanceSnapshots));
+        shutdown.AddStep("governance", [snapshots] { snapshots->Stop(); });
+    }
+    auto& marketplace = marketplace::Marketplace::Instance();
+    if (marketplace.IsRunning()) {
+        // Keep the measured verification costs for the next start
+        shutdown.AddStep("marketplace", [&marketplace, path = JoinPath(
+                g_config.dataDir, marketplace::VERIFICATION_COST_MODEL_FILENAME)] {
+            marketplace.Stop();
+            if (!marketplace.SaveVerificationCosts(path)) {
+                LOG_WARN(util::LogCategory::DEFAULT) << "Failed to save verification costs";
+            }
+        });
+    }
+    shutdown.Run();
+    
+    g_notify.reset();
+    g_stratum.reset();
+    g_miner.reset();
     StopRPCServer();
     
     // Reset staking engine
@@ -1040,6 +1458,8 @@ void Shutdown() {
 // ============================================================================
 
 int AppMain(int argc, char* argv[]) {
+    auto configStart = std::chrono::steady_clock::now();
+    
     // Parse command line
     if (!ParseCommandLine(argc, argv, g_config)) {
         return 0;  // Help or version was shown, or error
@@ -1088,6 +1508,11 @@ int AppMain(int argc, char* argv[]) {
     }
 #endif
     
+    // Only now that the process is final can the log writer thread start
+    if (g_config.logAsync) {
+        util::Logger::Instance().StartAsync();
+    }
+    
     // Write PID file
     if (!WritePidFile(g_config.pidFile)) {
         LOG_WARN(util::LogCategory::DEFAULT) << "Could not write PID file: " << g_config.pidFile;
@@ -1101,20 +1526,31 @@ int AppMain(int argc, char* argv[]) {
     // ========================================================================
     
     g_node = std::make_unique<NodeContext>();
+    g_node->startup.Record(util::StartupPhase::CONFIG,
+                           std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::steady_clock::now() - configStart));
     
     // Convert DaemonConfig to NodeInitOptions
     NodeInitOptions nodeOptions;
     nodeOptions.dataDir = g_config.dataDir;
     nodeOptions.network = g_config.network;
     nodeOptions.dbCacheMB = g_config.dbCache;
+    nodeOptions.coinFilterMB = g_config.coinFilter;
     nodeOptions.txIndex = g_config.txIndex;
+    nodeOptions.blockFilterIndex = g_config.blockFilterIndex;
     nodeOptions.reindex = g_config.reindex;
     nodeOptions.prune = g_config.prune;
     nodeOptions.pruneSizeMB = g_config.pruneSize;
+    nodeOptions.scriptCheckThreads = g_config.scriptCheckThreads;
+    nodeOptions.threadAffinity = g_config.threadAffinity;
+    nodeOptions.autoThreadPlacement = g_config.autoThreadPlacement;
     nodeOptions.listen = g_config.listen;
     nodeOptions.bindAddress = g_config.bind;
     nodeOptions.port = g_config.port;
     nodeOptions.maxConnections = g_config.maxConnections;
+    nodeOptions.maxUploadTarget = g_config.maxUploadTarget * 1024 * 1024;
+    nodeOptions.maxSendRatePerPeer = g_config.maxSendRate * 1000;
+    nodeOptions.maxSendRateTotal = g_config.maxSendRateTotal * 1000;
     nodeOptions.addNodes = g_config.addNodes;
     nodeOptions.connectNodes = g_config.connectNodes;
     nodeOptions.dnsSeed = g_config.dnsSeed;
@@ -1124,7 +1560,8 @@ int AppMain(int argc, char* argv[]) {
     nodeOptions.miningAddress = g_config.miningAddress;
     nodeOptions.checkBlocks = g_config.checkBlocks;
     nodeOptions.checkLevel = g_config.checkLevel;
-    nodeOptions.assumeValidBlock = g_config.assumeValidBlock;
+    nodeOptions.assumeValidBlock = g_config.assumeValid ? g_config.assumeValidBlock : "0";
+    nodeOptions.persistMempool = g_config.persistMempool;
     
     // Initialize node (databases, chain state, mempool)
     if (!InitializeNode(*g_node, nodeOptions)) {
@@ -1182,6 +1619,7 @@ int AppMain(int argc, char* argv[]) {
     }
     
     // Start P2P network
+    g_node->startup.Begin(util::StartupPhase::NETWORK);
     if (!StartNetwork(*g_node, nodeOptions)) {
         LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to start network";
         Shutdown();
@@ -1192,6 +1630,7 @@ int AppMain(int argc, char* argv[]) {
     if (!StartSync(*g_node)) {
         LOG_WARN(util::LogCategory::DEFAULT) << "Failed to start sync (continuing anyway)";
     }
+    g_node->startup.End(util::StartupPhase::NETWORK);
     
     // Start RPC server
     if (!StartRPCServer(g_config)) {
@@ -1201,6 +1640,7 @@ int AppMain(int argc, char* argv[]) {
     
     // Wire up node components to RPC commands
     if (g_rpcCommands && g_node) {
+        g_rpcCommands->SetStartupProfile(&g_node->startup);
         if (g_node->blockDB) {
             g_rpcCommands->SetBlockDB(std::shared_ptr<db::BlockDB>(g_node->blockDB.get(), [](db::BlockDB*){}));
         }
@@ -1212,15 +1652,38 @@ int AppMain(int argc, char* argv[]) {
         if (g_node->mempool) {
             g_rpcCommands->SetMempool(std::shared_ptr<Mempool>(g_node->mempool.get(), [](Mempool*){}));
         }
+        if (g_node->feeEstimator) {
+            g_rpcCommands->SetFeeEstimator(g_node->feeEstimator.get());
+        }
         if (g_node->msgproc) {
             g_rpcCommands->SetMessageProcessor(g_node->msgproc.get());
         }
+        if (g_node->txIndexer) {
+            g_rpcCommands->SetTxIndexer(g_node->txIndexer.get());
+        }
+        if (g_node->coinsDB) {
+            g_rpcCommands->SetCoinsDB(g_node->coinsDB.get());
+        }
+        if (g_node->txIndex) {
+            g_rpcCommands->SetTxIndex(g_node->txIndex.get());
+        }
+        if (g_node->blockFilterIndexer) {
+            g_rpcCommands->SetBlockFilterIndexer(g_node->blockFilterIndexer.get());
+        }
     }
     
     // Initialize wallet (after RPC server so g_rpcCommands exists)
-    if (!InitializeWallet(g_config)) {
-        LOG_WARN(util::LogCategory::DEFAULT) << "Wallet initialization failed (continuing without wallet)";
-        // Don't fail - user can use loadwallet/createwallet commands later
+    if (g_config.walletEnabled) {
+        util::StartupPhaseTimer walletPhase(g_node->startup, util::StartupPhase::WALLET);
+        if (InitializeWallet(g_config)) {
+            walletPhase.Done();
+        } else {
+            LOG_WARN(util::LogCategory::DEFAULT) << "Wallet initialization failed (continuing without wallet)";
+            // Don't fail - user can use loadwallet/createwallet commands later
+        }
+    } else {
+        LOG_INFO(util::LogCategory::WALLET) << "Wallet disabled";
+        g_node->startup.Skip(util::StartupPhase::WALLET);
     }
     
     // Initialize staking engine (needed for RPC and staking)
@@ -1257,6 +1720,28 @@ int AppMain(int argc, char* argv[]) {
     // Initialize governance engine
     auto paramRegistry = std::make_shared<governance::ParameterRegistry>();
     g_governanceEngine = std::make_shared<governance::GovernanceEngine>(paramRegistry);
+    
+    // Start from the latest snapshot and process only the blocks after it
+    std::string snapshotPath = JoinPath(g_config.dataDir, governance::GOVERNANCE_SNAPSHOT_FILENAME);
+    if (FileExists(snapshotPath)) {
+        governance::GovernanceSnapshot snapshot;
+        auto read = governance::ReadGovernanceSnapshot(snapshotPath, snapshot);
+        if (read.success && snapshot.Restore(*g_governanceEngine)) {
+            int tipHeight = g_node ? g_node->GetHeight() : snapshot.height;
+            for (int height = snapshot.height + 1; height <= tipHeight; ++height) {
+                g_governanceEngine->ProcessBlock(height);
+            }
+            LOG_INFO(util::LogCategory::DEFAULT) << "Loaded governance snapshot at height "
+                << snapshot.height << " (" << std::max(0, tipHeight - snapshot.height)
+                << " blocks processed after it)";
+        } else {
+            LOG_WARN(util::LogCategory::DEFAULT) << "Ignoring governance snapshot: "
+                << (read.success ? "unreadable state" : read.error);
+            paramRegistry = std::make_shared<governance::ParameterRegistry>();
+            g_governanceEngine = std::make_shared<governance::GovernanceEngine>(paramRegistry);
+        }
+    }
+    g_governanceSnapshots = std::make_unique<governance::GovernanceSnapshotWriter>(snapshotPath);
     LOG_INFO(util::LogCategory::DEFAULT) << "Governance engine initialized";
     
     // Wire up governance engine to RPC commands
@@ -1264,8 +1749,67 @@ int AppMain(int argc, char* argv[]) {
         g_rpcCommands->SetGovernanceEngine(g_governanceEngine);
     }
     
+    // Push blocks, transactions and UBI/governance events to subscribers
+    if (g_config.notify) {
+        rpc::NotificationPublisher::Options notifyOpts;
+        notifyOpts.port = g_config.notifyPort;
+        notifyOpts.bindAddress = g_config.rpcBind;
+        g_notify = std::make_unique<rpc::NotificationPublisher>(notifyOpts);
+        if (g_notify->Start()) {
+            g_notify->AttachChain(*g_node->chainman);
+            g_node->mempool->SetNotifyAdded([](const TransactionRef& tx) {
+                g_notify->PublishTransaction(*tx);
+            });
+            if (g_ubiDistributor) {
+                g_ubiDistributor->SetEpochFinalizedCallback([](const economics::EpochUBIPool& pool) {
+                    if (!g_notify->HasSubscribers(rpc::NotifyTopic::UBI)) return;
+                    rpc::JSONValue::Object event;
+                    event["event"] = "epochfinalized";
+                    event["epoch"] = static_cast<int64_t>(pool.epoch);
+                    event["total_pool"] = static_cast<int64_t>(pool.totalPool);
+                    event["eligible_count"] = static_cast<int64_t>(pool.eligibleCount);
+                    event["amount_per_person"] = static_cast<int64_t>(pool.amountPerPerson);
+                    g_notify->PublishEvent(rpc::NotifyTopic::UBI, rpc::JSONValue(std::move(event)));
+                });
+            }
+            g_governanceEngine->SetParameterChangeCallback(
+                [](governance::GovernableParameter param, const governance::ParameterValue& value) {
+                    if (!g_notify->HasSubscribers(rpc::NotifyTopic::GOVERNANCE)) return;
+                    rpc::JSONValue::Object event;
+                    event["event"] = "parameterchange";
+                    event["parameter"] = governance::GovernableParameterToString(param);
+                    if (const int64_t* number = std::get_if<int64_t>(&value)) {
+                        event["value"] = *number;
+                    } else {
+                        event["value"] = std::get<std::string>(value);
+                    }
+                    g_notify->PublishEvent(rpc::NotifyTopic::GOVERNANCE, rpc::JSONValue(std::move(event)));
+                });
+            g_governanceEngine->SetProtocolUpgradeCallback([](const governance::ProtocolUpgrade& upgrade) {
+                if (!g_notify->HasSubscribers(rpc::NotifyTopic::GOVERNANCE)) return;
+                rpc::JSONValue::Object event;
+                event["event"] = "protocolupgrade";
+                event["version"] = static_cast<int64_t>(upgrade.newVersion);
+                event["activation_height"] = static_cast<int64_t>(upgrade.activationHeight);
+                event["deadline_height"] = static_cast<int64_t>(upgrade.deadlineHeight);
+                event["code_reference"] = upgrade.codeReference;
+                g_notify->PublishEvent(rpc::NotifyTopic::GOVERNANCE, rpc::JSONValue(std::move(event)));
+            });
+        } else {
+            LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to start notification publisher on port "
+                                                  << g_config.notifyPort;
+            g_notify.reset();
+        }
+    }
+    
     // Initialize and start the PoUW marketplace
     auto& marketplace = marketplace::Marketplace::Instance();
+    std::string verificationCostPath =
+        JoinPath(g_config.dataDir, marketplace::VERIFICATION_COST_MODEL_FILENAME);
+    if (marketplace.LoadVerificationCosts(verificationCostPath)) {
+        LOG_INFO(util::LogCategory::DEFAULT) << "Loaded verification costs from "
+                                             << verificationCostPath;
+    }
     marketplace.Start();
     LOG_INFO(util::LogCategory::DEFAULT) << "PoUW Marketplace started";
     
@@ -1312,6 +1856,7 @@ int AppMain(int argc, char* argv[]) {
         miner::MinerOptions minerOpts;
         minerOpts.numThreads = g_config.miningThreads;
         minerOpts.coinbaseAddress = miningAddress;
+        minerOpts.backend = g_config.miningBackend;
         
         g_miner = std::make_unique<miner::Miner>(
             *g_node->chainman,
@@ -1326,7 +1871,7 @@ int AppMain(int argc, char* argv[]) {
         }
         
         // Set callback for block found - notify wallet about the new block
-        g_miner->SetBlockFoundCallback([](const Block& block, bool accepted) {
+        miner::Miner::BlockFoundCallback onBlockFound = [](const Block& block, bool accepted) {
             if (accepted) {
                 LOG_INFO(util::LogCategory::DEFAULT) << "Mined block " 
                     << block.GetHash().ToHex().substr(0, 16) << "... accepted!";
@@ -1367,6 +1912,11 @@ int AppMain(int argc, char* argv[]) {
                 // Process governance proposals (advance state, execute approved)
                 if (g_governanceEngine) {
                     g_governanceEngine->ProcessBlock(height);
+                    if (g_governanceSnapshots &&
+                        height % governance::DEFAULT_GOVERNANCE_SNAPSHOT_INTERVAL == 0) {
+                        g_governanceSnapshots->Submit(governance::GovernanceSnapshot::Capture(
+                            height, *g_governanceEngine));
+                    }
                 }
                 
                 // Notify wallet about the new block so it can track coinbase outputs
@@ -1377,13 +1927,17 @@ int AppMain(int argc, char* argv[]) {
                 
                 // Remove confirmed transactions from mempool
                 if (g_node && g_node->mempool) {
-                    g_node->mempool->RemoveForBlock(block.vtx);
+                    g_node->mempool->RemoveForBlock(block.vtx, static_cast<uint32_t>(height));
+                }
+                if (g_node && g_node->msgproc) {
+                    g_node->msgproc->BlockConnected(block);
                 }
             } else {
                 LOG_WARN(util::LogCategory::DEFAULT) << "Mined block " 
                     << block.GetHash().ToHex().substr(0, 16) << "... rejected";
             }
-        });
+        };
+        g_miner->SetBlockFoundCallback(onBlockFound);
         
         // Set miner in RPC command table for setgenerate command
         if (g_rpcCommands) {
@@ -1402,6 +1956,29 @@ int AppMain(int argc, char* argv[]) {
         } else {
             LOG_INFO(util::LogCategory::DEFAULT) << "Miner initialized but not started. Use 'setgenerate true' to start mining.";
         }
+        
+        // Serve external mining hardware, paying the same address
+        if (g_config.stratum) {
+            rpc::StratumServer::Options stratumOpts;
+            stratumOpts.port = g_config.stratumPort;
+            stratumOpts.difficulty = g_config.stratumDifficulty;
+            g_stratum = std::make_unique<rpc::StratumServer>(
+                *g_node->chainman,
+                *g_node->mempool,
+                *g_node->params,
+                Script::CreateP2PKH(miningAddress),
+                stratumOpts
+            );
+            if (g_node->msgproc) {
+                g_stratum->SetMessageProcessor(g_node->msgproc.get());
+            }
+            g_stratum->SetBlockFoundCallback(onBlockFound);
+            if (!g_stratum->Start()) {
+                LOG_ERROR(util::LogCategory::DEFAULT) << "Failed to start Stratum server on port "
+                                                      << g_config.stratumPort;
+                g_stratum.reset();
+            }
+        }
     } else {
         LOG_WARN(util::LogCategory::DEFAULT) << "No mining address available. Mining disabled.";
         LOG_WARN(util::LogCategory::DEFAULT) << "Use --miningaddress=<addr> or create a wallet first.";
@@ -1418,7 +1995,10 @@ int AppMain(int argc, char* argv[]) {
         LOG_INFO(util::LogCategory::DEFAULT) << "Use 'registervalidator' RPC to become a validator";
     }
     
+    RegisterNodeMetrics();
+    
     g_running.store(true);
+    g_node->startup.MarkStarted();
     LOG_INFO(util::LogCategory::DEFAULT) << "SHURIUM Daemon started successfully";
     
     // Wait for shutdown signal
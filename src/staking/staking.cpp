@@ -65,6 +65,17 @@ static Hash256 CreateDelegationMessageHash(
     return SHA256Hash(ss.data(), ss.size());
 }
 
+/**
+ * Shares covering amount out of a delegation of total with the given
+ * shares. The product is taken in 128 bits: shares * amount overflows
+ * 64 bits once both exceed ~42 SHR, below the minimum delegation.
+ */
+static uint64_t SharesForAmount(uint64_t shares, Amount amount, Amount total) {
+    __extension__ typedef unsigned __int128 uint128;
+    return static_cast<uint64_t>(static_cast<uint128>(shares) * static_cast<uint64_t>(amount) /
+                                 static_cast<uint64_t>(total));
+}
+
 // ============================================================================
 // String Conversion Functions
 // ============================================================================
@@ -141,6 +152,67 @@ Amount CalculateEpochReward(Amount stake, int rateBps, int epochLength) {
     return (annualReward * epochLength) / BLOCKS_PER_YEAR;
 }
 
+// ============================================================================
+// LivenessWindow Implementation
+// ============================================================================
+
+LivenessWindow::LivenessWindow(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)) {}
+
+void LivenessWindow::Record(bool missed) {
+    if (words_.empty()) {
+        words_.assign((capacity_ + 63) / 64, 0);
+    }
+    
+    size_t bit;
+    if (size_ < capacity_) {
+        bit = (head_ + size_) % capacity_;
+        ++size_;
+    } else {
+        // Overwrite the oldest block
+        bit = head_;
+        head_ = (head_ + 1) % capacity_;
+        if ((words_[bit / 64] >> (bit % 64)) & 1) {
+            --missed_;
+        }
+    }
+    
+    uint64_t mask = uint64_t{1} << (bit % 64);
+    if (missed) {
+        words_[bit / 64] |= mask;
+        ++missed_;
+    } else {
+        words_[bit / 64] &= ~mask;
+    }
+}
+
+bool LivenessWindow::Get(size_t i) const {
+    if (i >= size_) {
+        return false;
+    }
+    size_t bit = (head_ + i) % capacity_;
+    return (words_[bit / 64] >> (bit % 64)) & 1;
+}
+
+void LivenessWindow::Clear() {
+    std::fill(words_.begin(), words_.end(), 0);
+    head_ = 0;
+    size_ = 0;
+    missed_ = 0;
+}
+
+bool LivenessWindow::operator==(const LivenessWindow& other) const {
+    if (capacity_ != other.capacity_ || size_ != other.size_ || missed_ != other.missed_) {
+        return false;
+    }
+    for (size_t i = 0; i < size_; ++i) {
+        if (Get(i) != other.Get(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // ============================================================================
 // Validator Implementation
 // ============================================================================
@@ -175,31 +247,19 @@ Amount Validator::CalculateCommission(Amount reward) const {
 void Validator::RecordBlockProduced() {
     blocksProduced++;
     
-    // Update missed blocks bitmap (sliding window)
-    if (missedBlocksBitmap.size() >= static_cast<size_t>(MISSED_BLOCKS_WINDOW)) {
-        // Remove oldest entry
-        if (missedBlocksBitmap.front()) {
-            missedBlocksCounter--;
-        }
-        missedBlocksBitmap.erase(missedBlocksBitmap.begin());
-    }
-    missedBlocksBitmap.push_back(false);  // Not missed
+    // Update missed blocks window
+    missedBlocksBitmap.Record(false);  // Not missed
+    missedBlocksCounter = static_cast<int>(missedBlocksBitmap.MissedCount());
 }
 
 void Validator::RecordBlockMissed() {
-    if (missedBlocksBitmap.size() >= static_cast<size_t>(MISSED_BLOCKS_WINDOW)) {
-        if (missedBlocksBitmap.front()) {
-            missedBlocksCounter--;
-        }
-        missedBlocksBitmap.erase(missedBlocksBitmap.begin());
-    }
-    missedBlocksBitmap.push_back(true);  // Missed
-    missedBlocksCounter++;
+    missedBlocksBitmap.Record(true);  // Missed
+    missedBlocksCounter = static_cast<int>(missedBlocksBitmap.MissedCount());
 }
 
 double Validator::GetMissedBlocksPercent() const {
-    if (missedBlocksBitmap.empty()) return 0.0;
-    return (static_cast<double>(missedBlocksCounter) / missedBlocksBitmap.size()) * 100.0;
+    if (missedBlocksBitmap.Empty()) return 0.0;
+    return (static_cast<double>(missedBlocksCounter) / missedBlocksBitmap.Size()) * 100.0;
 }
 
 Hash256 Validator::GetHash() const {
@@ -217,150 +277,97 @@ Hash256 Validator::GetHash() const {
 }
 
 std::vector<Byte> Validator::Serialize() const {
-    std::vector<Byte> data;
+    DataStream ss;
     
     // Version byte
-    data.push_back(0x01);
-    
-    // Validator ID (32 bytes)
-    data.insert(data.end(), id.begin(), id.end());
-    
-    // Operator key (compressed, 33 bytes)
-    auto keyBytes = operatorKey.ToVector();
-    uint8_t keyLen = static_cast<uint8_t>(keyBytes.size());
-    data.push_back(keyLen);
-    data.insert(data.end(), keyBytes.begin(), keyBytes.end());
-    
-    // Reward address (20 bytes)
-    data.insert(data.end(), rewardAddress.begin(), rewardAddress.end());
-    
-    // Moniker (length-prefixed string)
-    uint16_t monikerLen = static_cast<uint16_t>(std::min(moniker.size(), size_t(255)));
-    data.push_back(static_cast<Byte>(monikerLen & 0xFF));
-    data.push_back(static_cast<Byte>((monikerLen >> 8) & 0xFF));
-    data.insert(data.end(), moniker.begin(), moniker.begin() + monikerLen);
-    
-    // Status (1 byte)
-    data.push_back(static_cast<Byte>(status));
-    
-    // Self stake (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back(static_cast<Byte>((selfStake >> (i * 8)) & 0xFF));
-    }
-    
-    // Delegated stake (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back(static_cast<Byte>((delegatedStake >> (i * 8)) & 0xFF));
-    }
-    
-    // Commission rate (4 bytes)
-    for (int i = 0; i < 4; ++i) {
-        data.push_back(static_cast<Byte>((commissionRate >> (i * 8)) & 0xFF));
-    }
-    
-    // Registration height (4 bytes)
-    for (int i = 0; i < 4; ++i) {
-        data.push_back(static_cast<Byte>((registrationHeight >> (i * 8)) & 0xFF));
-    }
-    
-    // Jailed height (4 bytes)
-    for (int i = 0; i < 4; ++i) {
-        data.push_back(static_cast<Byte>((jailedHeight >> (i * 8)) & 0xFF));
+    ser_writedata8(ss, 0x02);
+    
+    shurium::Serialize(ss, id);
+    shurium::Serialize(ss, operatorKey.ToVector());
+    shurium::Serialize(ss, rewardAddress);
+    shurium::Serialize(ss, moniker);
+    shurium::Serialize(ss, description);
+    ser_writedata8(ss, static_cast<uint8_t>(status));
+    ser_writedata64(ss, static_cast<uint64_t>(selfStake));
+    ser_writedata64(ss, static_cast<uint64_t>(delegatedStake));
+    ser_writedata32(ss, static_cast<uint32_t>(commissionRate));
+    ser_writedata32(ss, static_cast<uint32_t>(commissionChangeHeight));
+    ser_writedata32(ss, static_cast<uint32_t>(registrationHeight));
+    ser_writedata32(ss, static_cast<uint32_t>(jailedHeight));
+    ser_writedata32(ss, static_cast<uint32_t>(unbondingHeight));
+    ser_writedata64(ss, static_cast<uint64_t>(accumulatedRewards));
+    ser_writedata64(ss, static_cast<uint64_t>(totalRewardsEarned));
+    ser_writedata64(ss, blocksProduced);
+    ser_writedata32(ss, static_cast<uint32_t>(missedBlocksCounter));
+    
+    // Missed blocks window, oldest first, packed 8 per byte
+    WriteCompactSize(ss, missedBlocksBitmap.Size());
+    std::vector<Byte> packed((missedBlocksBitmap.Size() + 7) / 8, 0);
+    for (size_t i = 0; i < missedBlocksBitmap.Size(); ++i) {
+        if (missedBlocksBitmap.Get(i)) {
+            packed[i / 8] |= static_cast<Byte>(1 << (i % 8));
+        }
     }
+    ss.Write(packed.data(), packed.size());
     
-    // Blocks produced (8 bytes)
-    for (int i = 0; i < 8; ++i) {
-        data.push_back(static_cast<Byte>((blocksProduced >> (i * 8)) & 0xFF));
-    }
+    ser_writedata32(ss, static_cast<uint32_t>(slashCount));
+    ser_writedata64(ss, static_cast<uint64_t>(totalSlashed));
     
-    return data;
+    return ss.Data();
 }
 
 std::optional<Validator> Validator::Deserialize(const Byte* data, size_t len) {
-    if (!data || len < 80) {  // Minimum expected size
+    if (!data || len == 0) {
         return std::nullopt;
     }
     
+    SpanReader ss(data, len);
     Validator validator;
-    size_t offset = 0;
-    
-    // Version check
-    Byte version = data[offset++];
-    if (version != 0x01) {
+    try {
+        // Version check
+        if (ser_readdata8(ss) != 0x02) {
+            return std::nullopt;
+        }
+        
+        shurium::Unserialize(ss, validator.id);
+        std::vector<Byte> keyBytes;
+        shurium::Unserialize(ss, keyBytes);
+        if (keyBytes.size() > 65) {
+            return std::nullopt;
+        }
+        validator.operatorKey = PublicKey(keyBytes.data(), keyBytes.size());
+        shurium::Unserialize(ss, validator.rewardAddress);
+        shurium::Unserialize(ss, validator.moniker);
+        shurium::Unserialize(ss, validator.description);
+        validator.status = static_cast<ValidatorStatus>(ser_readdata8(ss));
+        validator.selfStake = static_cast<Amount>(ser_readdata64(ss));
+        validator.delegatedStake = static_cast<Amount>(ser_readdata64(ss));
+        validator.commissionRate = static_cast<int>(ser_readdata32(ss));
+        validator.commissionChangeHeight = static_cast<int>(ser_readdata32(ss));
+        validator.registrationHeight = static_cast<int>(ser_readdata32(ss));
+        validator.jailedHeight = static_cast<int>(ser_readdata32(ss));
+        validator.unbondingHeight = static_cast<int>(ser_readdata32(ss));
+        validator.accumulatedRewards = static_cast<Amount>(ser_readdata64(ss));
+        validator.totalRewardsEarned = static_cast<Amount>(ser_readdata64(ss));
+        validator.blocksProduced = ser_readdata64(ss);
+        validator.missedBlocksCounter = static_cast<int>(ser_readdata32(ss));
+        
+        uint64_t bits = ReadCompactSize(ss);
+        if (bits > static_cast<uint64_t>(MISSED_BLOCKS_WINDOW)) {
+            return std::nullopt;
+        }
+        std::vector<Byte> packed((bits + 7) / 8);
+        ss.Read(packed.data(), packed.size());
+        for (size_t i = 0; i < bits; ++i) {
+            validator.missedBlocksBitmap.Record((packed[i / 8] >> (i % 8)) & 1);
+        }
+        
+        validator.slashCount = static_cast<int>(ser_readdata32(ss));
+        validator.totalSlashed = static_cast<Amount>(ser_readdata64(ss));
+    } catch (const std::ios_base::failure&) {
         return std::nullopt;
     }
     
-    // Validator ID
-    if (offset + 32 > len) return std::nullopt;
-    std::copy(data + offset, data + offset + 32, validator.id.begin());
-    offset += 32;
-    
-    // Operator key
-    if (offset + 1 > len) return std::nullopt;
-    uint8_t keyLen = data[offset++];
-    if (offset + keyLen > len || keyLen > 65) return std::nullopt;
-    validator.operatorKey = PublicKey(data + offset, keyLen);
-    offset += keyLen;
-    
-    // Reward address
-    if (offset + 20 > len) return std::nullopt;
-    std::copy(data + offset, data + offset + 20, validator.rewardAddress.begin());
-    offset += 20;
-    
-    // Moniker
-    if (offset + 2 > len) return std::nullopt;
-    uint16_t monikerLen = data[offset] | (data[offset + 1] << 8);
-    offset += 2;
-    if (offset + monikerLen > len) return std::nullopt;
-    validator.moniker.assign(reinterpret_cast<const char*>(data + offset), monikerLen);
-    offset += monikerLen;
-    
-    // Status
-    if (offset + 1 > len) return std::nullopt;
-    validator.status = static_cast<ValidatorStatus>(data[offset++]);
-    
-    // Self stake
-    if (offset + 8 > len) return std::nullopt;
-    validator.selfStake = 0;
-    for (int i = 0; i < 8; ++i) {
-        validator.selfStake |= static_cast<Amount>(data[offset++]) << (i * 8);
-    }
-    
-    // Delegated stake
-    if (offset + 8 > len) return std::nullopt;
-    validator.delegatedStake = 0;
-    for (int i = 0; i < 8; ++i) {
-        validator.delegatedStake |= static_cast<Amount>(data[offset++]) << (i * 8);
-    }
-    
-    // Commission rate
-    if (offset + 4 > len) return std::nullopt;
-    validator.commissionRate = 0;
-    for (int i = 0; i < 4; ++i) {
-        validator.commissionRate |= static_cast<int>(data[offset++]) << (i * 8);
-    }
-    
-    // Registration height
-    if (offset + 4 > len) return std::nullopt;
-    validator.registrationHeight = 0;
-    for (int i = 0; i < 4; ++i) {
-        validator.registrationHeight |= static_cast<int>(data[offset++]) << (i * 8);
-    }
-    
-    // Jailed height
-    if (offset + 4 > len) return std::nullopt;
-    validator.jailedHeight = 0;
-    for (int i = 0; i < 4; ++i) {
-        validator.jailedHeight |= static_cast<int>(data[offset++]) << (i * 8);
-    }
-    
-    // Blocks produced
-    if (offset + 8 > len) return std::nullopt;
-    validator.blocksProduced = 0;
-    for (int i = 0; i < 8; ++i) {
-        validator.blocksProduced |= static_cast<uint64_t>(data[offset++]) << (i * 8);
-    }
-    
     return validator;
 }
 
@@ -404,14 +411,60 @@ Hash256 Delegation::GetHash() const {
 }
 
 std::vector<Byte> Delegation::Serialize() const {
-    std::vector<Byte> data;
-    return data;
+    DataStream ss;
+    
+    // Version byte
+    ser_writedata8(ss, 0x01);
+    
+    shurium::Serialize(ss, id);
+    shurium::Serialize(ss, delegator);
+    shurium::Serialize(ss, validatorId);
+    ser_writedata64(ss, static_cast<uint64_t>(amount));
+    ser_writedata8(ss, static_cast<uint8_t>(status));
+    ser_writedata32(ss, static_cast<uint32_t>(creationHeight));
+    ser_writedata32(ss, static_cast<uint32_t>(unbondingHeight));
+    ser_writedata64(ss, static_cast<uint64_t>(pendingRewards));
+    ser_writedata64(ss, static_cast<uint64_t>(totalRewardsClaimed));
+    ser_writedata32(ss, static_cast<uint32_t>(lastClaimHeight));
+    ser_writedata64(ss, shares);
+    ser_writedata64(ss, static_cast<uint64_t>(rewardCheckpoint));
+    ser_writedata64(ss, static_cast<uint64_t>(rewardCheckpoint >> 64));
+    
+    return ss.Data();
 }
 
 std::optional<Delegation> Delegation::Deserialize(const Byte* data, size_t len) {
-    (void)data;
-    (void)len;
-    return std::nullopt;
+    if (!data || len == 0) {
+        return std::nullopt;
+    }
+    
+    SpanReader ss(data, len);
+    Delegation delegation;
+    try {
+        // Version check
+        if (ser_readdata8(ss) != 0x01) {
+            return std::nullopt;
+        }
+        
+        shurium::Unserialize(ss, delegation.id);
+        shurium::Unserialize(ss, delegation.delegator);
+        shurium::Unserialize(ss, delegation.validatorId);
+        delegation.amount = static_cast<Amount>(ser_readdata64(ss));
+        delegation.status = static_cast<DelegationStatus>(ser_readdata8(ss));
+        delegation.creationHeight = static_cast<int>(ser_readdata32(ss));
+        delegation.unbondingHeight = static_cast<int>(ser_readdata32(ss));
+        delegation.pendingRewards = static_cast<Amount>(ser_readdata64(ss));
+        delegation.totalRewardsClaimed = static_cast<Amount>(ser_readdata64(ss));
+        delegation.lastClaimHeight = static_cast<int>(ser_readdata32(ss));
+        delegation.shares = ser_readdata64(ss);
+        RewardPerShare low = ser_readdata64(ss);
+        RewardPerShare high = ser_readdata64(ss);
+        delegation.rewardCheckpoint = (high << 64) | low;
+    } catch (const std::ios_base::failure&) {
+        return std::nullopt;
+    }
+    
+    return delegation;
 }
 
 std::string Delegation::ToString() const {
@@ -443,6 +496,76 @@ std::string SlashEvent::ToString() const {
 }
 
 
+// ============================================================================
+// ProposerSchedule
+// ============================================================================
+
+void ProposerSchedule::Rebuild(std::vector<std::pair<ValidatorId, Amount>> validators) {
+    std::sort(validators.begin(), validators.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    
+    ids_.clear();
+    stakes_.clear();
+    ids_.reserve(validators.size());
+    stakes_.reserve(validators.size());
+    for (const auto& [id, stake] : validators) {
+        ids_.push_back(id);
+        stakes_.push_back(stake);
+    }
+    
+    // Linear-time Fenwick construction: push each node into its parent
+    tree_.assign(stakes_.size() + 1, 0);
+    totalStake_ = 0;
+    for (size_t i = 1; i < tree_.size(); ++i) {
+        tree_[i] += stakes_[i - 1];
+        totalStake_ += stakes_[i - 1];
+        size_t parent = i + (i & (~i + 1));
+        if (parent < tree_.size()) {
+            tree_[parent] += tree_[i];
+        }
+    }
+}
+
+bool ProposerSchedule::UpdateStake(const ValidatorId& id, Amount stake) {
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), id);
+    if (it == ids_.end() || *it != id) {
+        return false;
+    }
+    
+    size_t index = static_cast<size_t>(it - ids_.begin());
+    Amount delta = stake - stakes_[index];
+    stakes_[index] = stake;
+    totalStake_ += delta;
+    for (size_t i = index + 1; i < tree_.size(); i += i & (~i + 1)) {
+        tree_[i] += delta;
+    }
+    return true;
+}
+
+ValidatorId ProposerSchedule::Select(Amount position) const {
+    if (ids_.empty()) {
+        return ValidatorId();
+    }
+    
+    // Descend the tree for the longest prefix whose sum is <= position;
+    // the next validator is the one whose range contains it
+    size_t step = 1;
+    while (step * 2 < tree_.size()) {
+        step *= 2;
+    }
+    
+    size_t index = 0;
+    Amount remaining = position;
+    for (; step > 0; step /= 2) {
+        if (index + step < tree_.size() && tree_[index + step] <= remaining) {
+            index += step;
+            remaining -= tree_[index];
+        }
+    }
+    
+    return index < ids_.size() ? ids_[index] : ids_.back();
+}
+
 // ============================================================================
 // ValidatorSet Implementation
 // ============================================================================
@@ -473,10 +596,11 @@ bool ValidatorSet::RegisterValidator(const Validator& validator, const std::vect
     Validator newValidator = validator;
     newValidator.status = ValidatorStatus::Pending;
     newValidator.registrationHeight = currentHeight_;
-    newValidator.missedBlocksBitmap.reserve(MISSED_BLOCKS_WINDOW);
     
     validators_[newValidator.id] = newValidator;
     
+    changed_.insert(newValidator.id);
+    
     return true;
 }
 
@@ -530,6 +654,8 @@ bool ValidatorSet::UpdateValidator(const ValidatorId& id,
     validator.description = description;
     validator.commissionRate = newCommissionRate;
     
+    changed_.insert(id);
+    
     return true;
 }
 
@@ -566,11 +692,16 @@ bool ValidatorSet::ActivateValidator(const ValidatorId& id) {
         
         // Remove lowest stake validator from active set
         activeSet_.erase(minId);
+        proposersDirty_ = true;
         validators_[minId].status = ValidatorStatus::Inactive;
+        changed_.insert(minId);
     }
     
     validator.status = ValidatorStatus::Active;
     activeSet_.insert(id);
+    proposersDirty_ = true;
+    
+    changed_.insert(id);
     
     return true;
 }
@@ -595,6 +726,9 @@ bool ValidatorSet::DeactivateValidator(const ValidatorId& id, const std::vector<
     
     validator.status = ValidatorStatus::Inactive;
     activeSet_.erase(id);
+    proposersDirty_ = true;
+    
+    changed_.insert(id);
     
     return true;
 }
@@ -621,6 +755,7 @@ bool ValidatorSet::StartUnbonding(const ValidatorId& id, const std::vector<Byte>
     // Remove from active set if active
     if (validator.status == ValidatorStatus::Active) {
         activeSet_.erase(id);
+        proposersDirty_ = true;
     }
     
     validator.status = ValidatorStatus::Unbonding;
@@ -633,7 +768,9 @@ bool ValidatorSet::StartUnbonding(const ValidatorId& id, const std::vector<Byte>
     entry.amount = validator.selfStake;
     entry.startHeight = currentHeight_;
     entry.completionHeight = currentHeight_ + UNBONDING_PERIOD;
-    unbondingQueue_.push_back(entry);
+    unbondingQueue_.emplace(entry.completionHeight, entry);
+    
+    changed_.insert(id);
     
     return true;
 }
@@ -654,12 +791,15 @@ bool ValidatorSet::JailValidator(const ValidatorId& id, SlashReason reason) {
     
     // Remove from active set
     activeSet_.erase(id);
+    proposersDirty_ = true;
     
     validator.status = ValidatorStatus::Jailed;
     validator.jailedHeight = currentHeight_;
     
     (void)reason;  // Could log or track reason
     
+    changed_.insert(id);
+    
     return true;
 }
 
@@ -692,6 +832,8 @@ bool ValidatorSet::UnjailValidator(const ValidatorId& id, const std::vector<Byte
         validator.status = ValidatorStatus::Pending;
     }
     
+    changed_.insert(id);
+    
     return true;
 }
 
@@ -704,7 +846,9 @@ void ValidatorSet::TombstoneValidator(const ValidatorId& id) {
     }
     
     activeSet_.erase(id);
+    proposersDirty_ = true;
     it->second.status = ValidatorStatus::Tombstoned;
+    changed_.insert(id);
 }
 
 std::vector<Validator> ValidatorSet::GetValidatorsByStatus(ValidatorStatus status) const {
@@ -778,7 +922,18 @@ void ValidatorSet::RecordBlockProduced(const ValidatorId& id) {
     auto it = validators_.find(id);
     if (it != validators_.end()) {
         it->second.RecordBlockProduced();
+        changed_.insert(id);
+    }
+}
+
+std::optional<int> ValidatorSet::GetMissedBlocksCount(const ValidatorId& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = validators_.find(id);
+    if (it == validators_.end()) {
+        return std::nullopt;
     }
+    return it->second.missedBlocksCounter;
 }
 
 void ValidatorSet::RecordBlockMissed(const ValidatorId& id) {
@@ -787,50 +942,44 @@ void ValidatorSet::RecordBlockMissed(const ValidatorId& id) {
     auto it = validators_.find(id);
     if (it != validators_.end()) {
         it->second.RecordBlockMissed();
+        changed_.insert(id);
     }
 }
 
 ValidatorId ValidatorSet::GetNextProposer(int height) const {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    if (activeSet_.empty()) {
+    RefreshProposerSchedule();
+    if (proposers_.Empty()) {
         return ValidatorId();
     }
     
-    // Get active validators sorted by stake
-    std::vector<std::pair<ValidatorId, Amount>> activeValidators;
-    for (const auto& id : activeSet_) {
-        auto it = validators_.find(id);
-        if (it != validators_.end()) {
-            activeValidators.emplace_back(id, it->second.GetTotalStake());
-        }
-    }
-    
-    std::sort(activeValidators.begin(), activeValidators.end(),
-              [](const auto& a, const auto& b) { return a.second > b.second; });
-    
     // Weighted round-robin based on stake
-    Amount totalStake = 0;
-    for (const auto& [id, stake] : activeValidators) {
-        totalStake += stake;
-    }
-    
+    Amount totalStake = proposers_.GetTotalStake();
     if (totalStake == 0) {
-        return activeValidators.empty() ? ValidatorId() : activeValidators[0].first;
+        return proposers_.Front();
     }
     
     // Use height to determine position in round
     Amount position = (height * COIN) % totalStake;
-    Amount cumulative = 0;
+    return proposers_.Select(position);
+}
+
+void ValidatorSet::RefreshProposerSchedule() const {
+    if (!proposersDirty_) {
+        return;
+    }
     
-    for (const auto& [id, stake] : activeValidators) {
-        cumulative += stake;
-        if (position < cumulative) {
-            return id;
+    std::vector<std::pair<ValidatorId, Amount>> activeValidators;
+    activeValidators.reserve(activeSet_.size());
+    for (const auto& id : activeSet_) {
+        auto it = validators_.find(id);
+        if (it != validators_.end()) {
+            activeValidators.emplace_back(id, it->second.GetTotalStake());
         }
     }
-    
-    return activeValidators.back().first;
+    proposers_.Rebuild(std::move(activeValidators));
+    proposersDirty_ = false;
 }
 
 void ValidatorSet::ProcessEpochEnd(int height) {
@@ -843,16 +992,40 @@ void ValidatorSet::ProcessUnbondings(int height) {
     std::lock_guard<std::mutex> lock(mutex_);
     currentHeight_ = height;
     
-    // Process completed unbondings
-    auto it = unbondingQueue_.begin();
-    while (it != unbondingQueue_.end()) {
-        if (it->IsComplete(height)) {
-            // Unbonding complete - funds can be withdrawn
-            it = unbondingQueue_.erase(it);
+    // Process completed unbondings (funds can be withdrawn)
+    unbondingQueue_.erase(unbondingQueue_.begin(), unbondingQueue_.upper_bound(height));
+}
+
+void ValidatorSet::TakeChanges(StakingChanges& changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (const auto& id : changed_) {
+        auto it = validators_.find(id);
+        if (it != validators_.end()) {
+            changes.validators[id] = it->second;
         } else {
-            ++it;
+            changes.validators[id] = std::nullopt;
+        }
+    }
+    changed_.clear();
+}
+
+void ValidatorSet::ApplyChanges(const StakingChanges& changes, int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    currentHeight_ = height;
+    
+    for (const auto& [id, validator] : changes.validators) {
+        activeSet_.erase(id);
+        if (!validator) {
+            validators_.erase(id);
+            continue;
+        }
+        validators_[id] = *validator;
+        if (validator->status == ValidatorStatus::Active) {
+            activeSet_.insert(id);
         }
     }
+    proposersDirty_ = true;
 }
 
 std::vector<Byte> ValidatorSet::Serialize() const {
@@ -885,15 +1058,24 @@ void ValidatorSet::UpdateActiveSet() {
     
     // Update active set
     activeSet_.clear();
+    proposersDirty_ = true;
     for (size_t i = 0; i < std::min(eligible.size(), static_cast<size_t>(MAX_ACTIVE_VALIDATORS)); ++i) {
         const auto& [id, stake] = eligible[i];
         activeSet_.insert(id);
-        validators_[id].status = ValidatorStatus::Active;
+        SetStatus(id, ValidatorStatus::Active);
     }
     
     // Mark others as inactive
     for (size_t i = MAX_ACTIVE_VALIDATORS; i < eligible.size(); ++i) {
-        validators_[eligible[i].first].status = ValidatorStatus::Inactive;
+        SetStatus(eligible[i].first, ValidatorStatus::Inactive);
+    }
+}
+
+void ValidatorSet::SetStatus(const ValidatorId& id, ValidatorStatus status) {
+    auto& validator = validators_[id];
+    if (validator.status != status) {
+        validator.status = status;
+        changed_.insert(id);
     }
 }
 
@@ -959,13 +1141,13 @@ std::optional<DelegationId> StakingPool::Delegate(
     delegation.status = DelegationStatus::Active;
     delegation.creationHeight = currentHeight_;
     delegation.shares = CalculateShares(validatorId, amount);
+    delegation.rewardCheckpoint = rewardPerShare_[validatorId];
     delegation.id = delegation.GetHash();
     
     // Update indices
     delegations_[delegation.id] = delegation;
-    delegatorIndex_[delegator].insert(delegation.id);
-    validatorIndex_[validatorId].insert(delegation.id);
-    totalShares_[validatorId] += delegation.shares;
+    IndexDelegation(delegation);
+    changedDelegations_.insert(delegation.id);
     
     return delegation.id;
 }
@@ -1003,9 +1185,11 @@ bool StakingPool::AddToDelegation(
     // Calculate new shares
     uint64_t newShares = CalculateShares(delegation.validatorId, amount);
     
+    SettleRewards(delegation);
     delegation.amount += amount;
     delegation.shares += newShares;
     totalShares_[delegation.validatorId] += newShares;
+    changedDelegations_.insert(delegationId);
     
     return true;
 }
@@ -1045,8 +1229,9 @@ bool StakingPool::Undelegate(
     }
     
     // Calculate shares to remove
-    uint64_t sharesToRemove = (delegation.shares * amount) / delegation.amount;
+    uint64_t sharesToRemove = SharesForAmount(delegation.shares, amount, delegation.amount);
     
+    SettleRewards(delegation);
     delegation.amount -= amount;
     delegation.shares -= sharesToRemove;
     totalShares_[delegation.validatorId] -= sharesToRemove;
@@ -1058,13 +1243,15 @@ bool StakingPool::Undelegate(
     entry.amount = amount;
     entry.startHeight = currentHeight_;
     entry.completionHeight = currentHeight_ + UNBONDING_PERIOD;
-    unbondingQueue_.push_back(entry);
+    unbondingQueue_.emplace(entry.completionHeight, entry);
     
     // If fully unbonded, mark as unbonding
     if (delegation.amount == 0) {
         delegation.status = DelegationStatus::Unbonding;
         delegation.unbondingHeight = currentHeight_;
+        maturingDelegations_.emplace(currentHeight_ + UNBONDING_PERIOD, delegationId);
     }
+    changedDelegations_.insert(delegationId);
     
     return true;
 }
@@ -1120,9 +1307,10 @@ bool StakingPool::Redelegate(
     }
     
     // Calculate shares to move
-    uint64_t sharesToRemove = (delegation.shares * amount) / delegation.amount;
+    uint64_t sharesToRemove = SharesForAmount(delegation.shares, amount, delegation.amount);
     
     // Remove from old delegation
+    SettleRewards(delegation);
     delegation.amount -= amount;
     delegation.shares -= sharesToRemove;
     totalShares_[delegation.validatorId] -= sharesToRemove;
@@ -1135,17 +1323,17 @@ bool StakingPool::Redelegate(
     newDelegation.status = DelegationStatus::Active;
     newDelegation.creationHeight = currentHeight_;
     newDelegation.shares = CalculateShares(newValidatorId, amount);
+    newDelegation.rewardCheckpoint = rewardPerShare_[newValidatorId];
     newDelegation.id = newDelegation.GetHash();
     
     delegations_[newDelegation.id] = newDelegation;
-    delegatorIndex_[newDelegation.delegator].insert(newDelegation.id);
-    validatorIndex_[newValidatorId].insert(newDelegation.id);
-    totalShares_[newValidatorId] += newDelegation.shares;
+    IndexDelegation(newDelegation);
+    changedDelegations_.insert(newDelegation.id);
+    changedDelegations_.insert(delegationId);
     
     // Clean up old delegation if empty
     if (delegation.amount == 0) {
-        validatorIndex_[delegation.validatorId].erase(delegationId);
-        delegatorIndex_[delegation.delegator].erase(delegationId);
+        UnindexDelegation(delegation);
         delegations_.erase(it);
     }
     
@@ -1159,7 +1347,7 @@ std::optional<Delegation> StakingPool::GetDelegation(const DelegationId& id) con
     if (it == delegations_.end()) {
         return std::nullopt;
     }
-    return it->second;
+    return WithAccruedRewards(it->second);
 }
 
 std::vector<Delegation> StakingPool::GetDelegationsByDelegator(const Hash160& delegator) const {
@@ -1171,7 +1359,7 @@ std::vector<Delegation> StakingPool::GetDelegationsByDelegator(const Hash160& de
         for (const auto& id : it->second) {
             auto delIt = delegations_.find(id);
             if (delIt != delegations_.end()) {
-                result.push_back(delIt->second);
+                result.push_back(WithAccruedRewards(delIt->second));
             }
         }
     }
@@ -1187,7 +1375,7 @@ std::vector<Delegation> StakingPool::GetDelegationsToValidator(const ValidatorId
         for (const auto& id : it->second) {
             auto delIt = delegations_.find(id);
             if (delIt != delegations_.end()) {
-                result.push_back(delIt->second);
+                result.push_back(WithAccruedRewards(delIt->second));
             }
         }
     }
@@ -1225,6 +1413,7 @@ Amount StakingPool::ClaimRewards(const DelegationId& delegationId, const std::ve
     
     auto& delegation = it->second;
     
+    SettleRewards(delegation);
     if (!delegation.CanClaimRewards(currentHeight_)) {
         return 0;
     }
@@ -1252,6 +1441,7 @@ Amount StakingPool::ClaimRewards(const DelegationId& delegationId, const std::ve
     delegation.pendingRewards = 0;
     delegation.totalRewardsClaimed += rewards;
     delegation.lastClaimHeight = currentHeight_;
+    changedDelegations_.insert(delegationId);
     
     return rewards;
 }
@@ -1263,30 +1453,22 @@ Amount StakingPool::GetPendingRewards(const DelegationId& delegationId) const {
     if (it == delegations_.end()) {
         return 0;
     }
-    return it->second.pendingRewards;
+    return it->second.pendingRewards + UnsettledRewards(it->second);
 }
 
 void StakingPool::DistributeRewards(const ValidatorId& validatorId, Amount totalReward) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = validatorIndex_.find(validatorId);
-    if (it == validatorIndex_.end() || it->second.empty()) {
-        return;
-    }
-    
-    uint64_t totalValidatorShares = totalShares_[validatorId];
-    if (totalValidatorShares == 0) {
+    auto it = totalShares_.find(validatorId);
+    if (it == totalShares_.end() || it->second == 0 || totalReward <= 0) {
         return;
     }
     
-    // Distribute proportionally to shares
-    for (const auto& id : it->second) {
-        auto delIt = delegations_.find(id);
-        if (delIt != delegations_.end() && delIt->second.status == DelegationStatus::Active) {
-            Amount delegatorReward = (totalReward * delIt->second.shares) / totalValidatorShares;
-            delIt->second.pendingRewards += delegatorReward;
-        }
-    }
+    // Every share of this validator earns the same amount; delegations
+    // collect it when they are next settled
+    rewardPerShare_[validatorId] +=
+        static_cast<RewardPerShare>(totalReward) * REWARD_PER_SHARE_SCALE / it->second;
+    changedRewards_.insert(validatorId);
 }
 
 Amount StakingPool::ApplySlashing(const ValidatorId& validatorId, int slashRateBps) {
@@ -1305,6 +1487,7 @@ Amount StakingPool::ApplySlashing(const ValidatorId& validatorId, int slashRateB
             Amount slashAmount = (delIt->second.amount * slashRateBps) / 10000;
             delIt->second.amount -= slashAmount;
             totalSlashed += slashAmount;
+            changedDelegations_.insert(id);
         }
     }
     
@@ -1316,20 +1499,85 @@ void StakingPool::ProcessBlock(int height) {
     currentHeight_ = height;
     
     // Process completed unbondings
-    auto it = unbondingQueue_.begin();
-    while (it != unbondingQueue_.end()) {
-        if (it->IsComplete(height)) {
-            it = unbondingQueue_.erase(it);
+    unbondingQueue_.erase(unbondingQueue_.begin(), unbondingQueue_.upper_bound(height));
+    
+    // Mark completed delegation unbondings
+    auto matured = maturingDelegations_.upper_bound(height);
+    for (auto it = maturingDelegations_.begin(); it != matured; ++it) {
+        auto delIt = delegations_.find(it->second);
+        if (delIt != delegations_.end() && delIt->second.IsUnbondingComplete(height)) {
+            delIt->second.status = DelegationStatus::Completed;
+            changedDelegations_.insert(it->second);
+        }
+    }
+    maturingDelegations_.erase(maturingDelegations_.begin(), matured);
+}
+
+RewardPerShare StakingPool::GetRewardPerShare(const ValidatorId& validatorId) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    auto it = rewardPerShare_.find(validatorId);
+    return it != rewardPerShare_.end() ? it->second : 0;
+}
+
+void StakingPool::TakeChanges(StakingChanges& changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    for (const auto& id : changedDelegations_) {
+        auto it = delegations_.find(id);
+        if (it != delegations_.end()) {
+            changes.delegations[id] = it->second;
         } else {
-            ++it;
+            changes.delegations[id] = std::nullopt;
         }
     }
+    for (const auto& validatorId : changedRewards_) {
+        changes.rewardPerShare[validatorId] = rewardPerShare_[validatorId];
+    }
+    changedDelegations_.clear();
+    changedRewards_.clear();
+}
+
+void StakingPool::ApplyChanges(const StakingChanges& changes, int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    currentHeight_ = height;
     
-    // Mark completed delegation unbondings
-    for (auto& [id, delegation] : delegations_) {
-        if (delegation.status == DelegationStatus::Unbonding &&
-            delegation.IsUnbondingComplete(height)) {
-            delegation.status = DelegationStatus::Completed;
+    for (const auto& [id, delegation] : changes.delegations) {
+        auto it = delegations_.find(id);
+        if (it != delegations_.end()) {
+            UnindexDelegation(it->second);
+            delegations_.erase(it);
+        }
+        if (delegation) {
+            delegations_[id] = *delegation;
+            IndexDelegation(*delegation);
+        }
+    }
+    for (const auto& [validatorId, perShare] : changes.rewardPerShare) {
+        rewardPerShare_[validatorId] = perShare;
+    }
+}
+
+void StakingPool::IndexDelegation(const Delegation& delegation) {
+    delegatorIndex_[delegation.delegator].insert(delegation.id);
+    validatorIndex_[delegation.validatorId].insert(delegation.id);
+    totalShares_[delegation.validatorId] += delegation.shares;
+    if (delegation.status == DelegationStatus::Unbonding) {
+        maturingDelegations_.emplace(delegation.unbondingHeight + UNBONDING_PERIOD, delegation.id);
+    }
+}
+
+void StakingPool::UnindexDelegation(const Delegation& delegation) {
+    delegatorIndex_[delegation.delegator].erase(delegation.id);
+    validatorIndex_[delegation.validatorId].erase(delegation.id);
+    totalShares_[delegation.validatorId] -= delegation.shares;
+    if (delegation.status == DelegationStatus::Unbonding) {
+        auto range = maturingDelegations_.equal_range(delegation.unbondingHeight + UNBONDING_PERIOD);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == delegation.id) {
+                maturingDelegations_.erase(it);
+                break;
+            }
         }
     }
 }
@@ -1345,6 +1593,31 @@ bool StakingPool::Deserialize(const Byte* data, size_t len) {
     return false;
 }
 
+Amount StakingPool::UnsettledRewards(const Delegation& delegation) const {
+    if (delegation.shares == 0) {
+        return 0;
+    }
+    
+    auto accIt = rewardPerShare_.find(delegation.validatorId);
+    if (accIt == rewardPerShare_.end()) {
+        return 0;
+    }
+    RewardPerShare perShare = accIt->second - delegation.rewardCheckpoint;
+    return static_cast<Amount>(perShare * delegation.shares / REWARD_PER_SHARE_SCALE);
+}
+
+void StakingPool::SettleRewards(Delegation& delegation) {
+    delegation.pendingRewards += UnsettledRewards(delegation);
+    delegation.rewardCheckpoint = rewardPerShare_[delegation.validatorId];
+    changedDelegations_.insert(delegation.id);
+}
+
+Delegation StakingPool::WithAccruedRewards(const Delegation& delegation) const {
+    Delegation result = delegation;
+    result.pendingRewards += UnsettledRewards(delegation);
+    return result;
+}
+
 uint64_t StakingPool::CalculateShares(const ValidatorId& validatorId, Amount amount) const {
     // Simple 1:1 share calculation for new delegations
     // In production, would account for existing rewards in the pool
@@ -1435,13 +1708,13 @@ bool SlashingManager::SubmitDoubleSignEvidence(
 bool SlashingManager::ReportDowntime(const ValidatorId& validatorId) {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto validator = validators_->GetValidator(validatorId);
-    if (!validator) {
+    auto missedBlocks = validators_->GetMissedBlocksCount(validatorId);
+    if (!missedBlocks) {
         return false;
     }
     
     // Check if missed blocks exceed threshold
-    if (validator->missedBlocksCounter < MAX_MISSED_BLOCKS) {
+    if (*missedBlocks < MAX_MISSED_BLOCKS) {
         return false;
     }
     
@@ -1771,6 +2044,19 @@ int StakingEngine::GetNetworkAPY() const {
     return rewards_->GetEstimatedAPY();
 }
 
+StakingChanges StakingEngine::TakeChanges() {
+    StakingChanges changes;
+    validators_->TakeChanges(changes);
+    pool_->TakeChanges(changes);
+    return changes;
+}
+
+void StakingEngine::ApplyChanges(const StakingChanges& changes, int height) {
+    validators_->ApplyChanges(changes, height);
+    pool_->ApplyChanges(changes, height);
+    currentHeight_ = height;
+}
+
 std::vector<Byte> StakingEngine::Serialize() const {
     std::vector<Byte> data;
     return data;
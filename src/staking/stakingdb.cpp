@@ -0,0 +1,346 @@
+// SHURIUM - Staking State Store Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/staking/stakingdb.h>
+#include <shurium/core/serialize.h>
+#include <shurium/db/database.h>
+#include <shurium/db/leveldb.h>
+
+#include <ios>
+
+namespace shurium {
+namespace staking {
+
+namespace {
+
+template<typename Id>
+std::string RecordKey(char prefix, const Id& id) {
+    std::string key(1, prefix);
+    key.append(reinterpret_cast<const char*>(id.data()), id.size());
+    return key;
+}
+
+/// Big-endian so that undo records iterate in height order
+std::string UndoKey(int height) {
+    std::string key(1, db::prefix::STAKING_UNDO);
+    for (int i = 3; i >= 0; --i) {
+        key.push_back(static_cast<char>((static_cast<uint32_t>(height) >> (i * 8)) & 0xFF));
+    }
+    return key;
+}
+
+bool ParseUndoKey(const db::Slice& key, int& height) {
+    if (key.size() != 5 || key[0] != db::prefix::STAKING_UNDO) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (size_t i = 1; i < 5; ++i) {
+        value = (value << 8) | static_cast<uint8_t>(key[i]);
+    }
+    height = static_cast<int>(value);
+    return true;
+}
+
+std::string EncodeRewardPerShare(RewardPerShare value) {
+    std::string bytes;
+    for (int i = 0; i < 16; ++i) {
+        bytes.push_back(static_cast<char>(static_cast<uint8_t>(value >> (i * 8))));
+    }
+    return bytes;
+}
+
+bool DecodeRewardPerShare(const db::Slice& bytes, RewardPerShare& value) {
+    if (bytes.size() != 16) {
+        return false;
+    }
+    value = 0;
+    for (int i = 15; i >= 0; --i) {
+        value = (value << 8) | static_cast<uint8_t>(bytes[i]);
+    }
+    return true;
+}
+
+template<typename Record>
+std::optional<Record> DecodeRecord(const db::Slice& bytes) {
+    return Record::Deserialize(reinterpret_cast<const Byte*>(bytes.data()), bytes.size());
+}
+
+// Undo data: the prior value of every record a block changed, with a
+// presence flag so that records the block created are erased on undo
+
+template<typename Id, typename Record>
+void WriteUndoRecords(DataStream& ss, const std::map<Id, std::optional<Record>>& records) {
+    WriteCompactSize(ss, records.size());
+    for (const auto& [id, record] : records) {
+        Serialize(ss, id);
+        ser_writedata8(ss, record ? 1 : 0);
+        if (record) {
+            Serialize(ss, record->Serialize());
+        }
+    }
+}
+
+template<typename Id, typename Record>
+bool ReadUndoRecords(SpanReader& ss, std::map<Id, std::optional<Record>>& records) {
+    uint64_t count = ReadCompactSize(ss);
+    for (uint64_t i = 0; i < count; ++i) {
+        Id id;
+        Unserialize(ss, id);
+        if (ser_readdata8(ss) == 0) {
+            records[id] = std::nullopt;
+            continue;
+        }
+        std::vector<Byte> bytes;
+        Unserialize(ss, bytes);
+        auto record = Record::Deserialize(bytes.data(), bytes.size());
+        if (!record) {
+            return false;
+        }
+        records[id] = std::move(record);
+    }
+    return true;
+}
+
+std::vector<Byte> EncodeUndo(const StakingChanges& undo) {
+    DataStream ss;
+    WriteUndoRecords(ss, undo.validators);
+    WriteUndoRecords(ss, undo.delegations);
+    WriteCompactSize(ss, undo.rewardPerShare.size());
+    for (const auto& [validatorId, perShare] : undo.rewardPerShare) {
+        Serialize(ss, validatorId);
+        std::string bytes = EncodeRewardPerShare(perShare);
+        ss.Write(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    }
+    return ss.Data();
+}
+
+bool DecodeUndo(const std::string& bytes, StakingChanges& undo) {
+    SpanReader ss(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+    try {
+        if (!ReadUndoRecords(ss, undo.validators) || !ReadUndoRecords(ss, undo.delegations)) {
+            return false;
+        }
+        uint64_t count = ReadCompactSize(ss);
+        for (uint64_t i = 0; i < count; ++i) {
+            ValidatorId validatorId;
+            Unserialize(ss, validatorId);
+            char raw[16];
+            ss.Read(reinterpret_cast<uint8_t*>(raw), sizeof(raw));
+            DecodeRewardPerShare(db::Slice(raw, sizeof(raw)), undo.rewardPerShare[validatorId]);
+        }
+    } catch (const std::ios_base::failure&) {
+        return false;
+    }
+    return true;
+}
+
+/// Stage new values of records into batch, capturing their stored values
+/// into undo first. Returns false if a stored record is unreadable.
+template<typename Id, typename Record>
+bool StageRecords(db::Database& database, char prefix,
+                  const std::map<Id, std::optional<Record>>& records,
+                  std::map<Id, std::optional<Record>>& undo,
+                  db::WriteBatch& batch) {
+    for (const auto& [id, record] : records) {
+        std::string key = RecordKey(prefix, id);
+        std::string stored;
+        if (database.Get(key, &stored).ok()) {
+            auto previous = DecodeRecord<Record>(stored);
+            if (!previous) {
+                return false;
+            }
+            undo[id] = std::move(previous);
+        } else {
+            undo[id] = std::nullopt;
+        }
+
+        if (record) {
+            batch.Put(key, record->Serialize());
+        } else {
+            batch.Delete(key);
+        }
+    }
+    return true;
+}
+
+template<typename Id, typename Record>
+void StageRestore(char prefix, const std::map<Id, std::optional<Record>>& records,
+                  db::WriteBatch& batch) {
+    for (const auto& [id, record] : records) {
+        std::string key = RecordKey(prefix, id);
+        if (record) {
+            batch.Put(key, record->Serialize());
+        } else {
+            batch.Delete(key);
+        }
+    }
+}
+
+void StageRewards(const std::map<ValidatorId, RewardPerShare>& rewards, db::WriteBatch& batch) {
+    for (const auto& [validatorId, perShare] : rewards) {
+        std::string key = RecordKey(db::prefix::STAKING_REWARD, validatorId);
+        if (perShare == 0) {
+            batch.Delete(key);
+        } else {
+            batch.Put(key, EncodeRewardPerShare(perShare));
+        }
+    }
+}
+
+std::string EncodeHeight(int height) {
+    std::string bytes;
+    for (int i = 0; i < 4; ++i) {
+        bytes.push_back(static_cast<char>((static_cast<uint32_t>(height) >> (i * 8)) & 0xFF));
+    }
+    return bytes;
+}
+
+} // anonymous namespace
+
+StakingStore::StakingStore()
+    : StakingStore(std::make_unique<db::MemoryDatabase>()) {}
+
+StakingStore::StakingStore(std::unique_ptr<db::Database> db)
+    : db_(std::move(db)) {
+    if (!db_) {
+        db_ = std::make_unique<db::MemoryDatabase>();
+    }
+
+    std::string value;
+    if (db_->Get(db::MakeKey(db::prefix::STAKING_TIP), &value).ok() && value.size() == 4) {
+        uint32_t height = 0;
+        for (int i = 0; i < 4; ++i) {
+            height |= static_cast<uint32_t>(static_cast<uint8_t>(value[i])) << (i * 8);
+        }
+        tipHeight_ = static_cast<int32_t>(height);
+    }
+}
+
+StakingStore::~StakingStore() = default;
+
+int StakingStore::GetTipHeight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tipHeight_;
+}
+
+bool StakingStore::ConnectBlock(int height, const StakingChanges& changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (height < 0 || (tipHeight_ >= 0 && height != tipHeight_ + 1)) {
+        return false;
+    }
+
+    StakingChanges undo;
+    db::WriteBatch batch;
+    if (!StageRecords(*db_, db::prefix::STAKING_VALIDATOR, changes.validators,
+                      undo.validators, batch) ||
+        !StageRecords(*db_, db::prefix::STAKING_DELEGATION, changes.delegations,
+                      undo.delegations, batch)) {
+        return false;
+    }
+
+    for (const auto& [validatorId, perShare] : changes.rewardPerShare) {
+        std::string stored;
+        RewardPerShare previous = 0;
+        if (db_->Get(RecordKey(db::prefix::STAKING_REWARD, validatorId), &stored).ok() &&
+            !DecodeRewardPerShare(stored, previous)) {
+            return false;
+        }
+        undo.rewardPerShare[validatorId] = previous;
+    }
+    StageRewards(changes.rewardPerShare, batch);
+
+    batch.Put(UndoKey(height), EncodeUndo(undo));
+    batch.Put(db::MakeKey(db::prefix::STAKING_TIP), EncodeHeight(height));
+    if (!db_->Write(&batch).ok()) {
+        return false;
+    }
+
+    tipHeight_ = height;
+    return true;
+}
+
+bool StakingStore::DisconnectBlock(StakingChanges& restored) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (tipHeight_ < 0) {
+        return false;
+    }
+
+    std::string bytes;
+    if (!db_->Get(UndoKey(tipHeight_), &bytes).ok()) {
+        return false;  // Pruned or never written
+    }
+    StakingChanges undo;
+    if (!DecodeUndo(bytes, undo)) {
+        return false;
+    }
+
+    db::WriteBatch batch;
+    StageRestore(db::prefix::STAKING_VALIDATOR, undo.validators, batch);
+    StageRestore(db::prefix::STAKING_DELEGATION, undo.delegations, batch);
+    StageRewards(undo.rewardPerShare, batch);
+    batch.Delete(UndoKey(tipHeight_));
+    batch.Put(db::MakeKey(db::prefix::STAKING_TIP), EncodeHeight(tipHeight_ - 1));
+    if (!db_->Write(&batch).ok()) {
+        return false;
+    }
+
+    --tipHeight_;
+    restored = std::move(undo);
+    return true;
+}
+
+bool StakingStore::Load(StakingChanges& state) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = db_->NewIterator();
+    for (it->Seek(db::MakeKey(db::prefix::STAKING_VALIDATOR));
+         it->Valid() && it->key()[0] == db::prefix::STAKING_VALIDATOR; it->Next()) {
+        auto validator = DecodeRecord<Validator>(it->value());
+        if (!validator) {
+            return false;
+        }
+        state.validators[validator->id] = std::move(validator);
+    }
+    for (it->Seek(db::MakeKey(db::prefix::STAKING_DELEGATION));
+         it->Valid() && it->key()[0] == db::prefix::STAKING_DELEGATION; it->Next()) {
+        auto delegation = DecodeRecord<Delegation>(it->value());
+        if (!delegation) {
+            return false;
+        }
+        state.delegations[delegation->id] = std::move(delegation);
+    }
+    for (it->Seek(db::MakeKey(db::prefix::STAKING_REWARD));
+         it->Valid() && it->key()[0] == db::prefix::STAKING_REWARD; it->Next()) {
+        db::Slice key = it->key();
+        if (key.size() != 1 + ValidatorId::SIZE) {
+            return false;
+        }
+        ValidatorId validatorId;
+        std::copy(key.data() + 1, key.data() + key.size(), validatorId.data());
+        if (!DecodeRewardPerShare(it->value(), state.rewardPerShare[validatorId])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StakingStore::PruneUndo(int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    db::WriteBatch batch;
+    auto it = db_->NewIterator();
+    for (it->Seek(db::MakeKey(db::prefix::STAKING_UNDO)); it->Valid(); it->Next()) {
+        int undoHeight;
+        if (!ParseUndoKey(it->key(), undoHeight) || undoHeight > height) {
+            break;
+        }
+        batch.Delete(it->key());
+    }
+    return db_->Write(&batch).ok();
+}
+
+} // namespace staking
+} // namespace shurium
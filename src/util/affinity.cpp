@@ -0,0 +1,359 @@
+// SHURIUM - Thread Placement Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/util/affinity.h"
+#include "shurium/util/logging.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace shurium {
+namespace util {
+
+namespace {
+
+/// Roles that work on chain state, kept on the coins cache's node
+const char* const NODE_LOCAL_ROLES[] = {"scriptcheck", "msgproc", "msgheavy", "rpc",
+                                        "eventloop"};
+
+/// Roles kept off that node when there is another
+const char* const REMOTE_ROLES[] = {"miner"};
+
+#ifdef __linux__
+/// MPOL_PREFERRED from <numaif.h>, which comes with libnuma's headers
+constexpr int MEMORY_POLICY_PREFERRED = 1;
+
+/// Nodes the bind mask covers
+constexpr int MAX_NUMA_NODES = 1024;
+
+int64_t ClockNanos(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/// CPU time of another live thread
+int64_t ThreadCpuNanos(uint64_t handle) {
+    clockid_t clock;
+    if (pthread_getcpuclockid(static_cast<pthread_t>(handle), &clock) != 0) {
+        return 0;
+    }
+    return ClockNanos(clock);
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (CPU_COUNT(&set) == 0) {
+        return false;
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+#endif
+
+std::string ReadFirstLine(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Topology
+// ============================================================================
+
+std::vector<int> ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    if (!list.empty() && list.back() == ',') {
+        return cpus;
+    }
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string range = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (range.empty()) {
+            return {};
+        }
+
+        size_t dash = range.find('-');
+        char* rest = nullptr;
+        long first = std::strtol(range.c_str(), &rest, 10);
+        long last = first;
+        if (dash == std::string::npos) {
+            if (*rest != '\0') {
+                return {};
+            }
+        } else {
+            if (rest != range.c_str() + dash) {
+                return {};
+            }
+            const char* second = range.c_str() + dash + 1;
+            last = std::strtol(second, &rest, 10);
+            if (rest == second || *rest != '\0') {
+                return {};
+            }
+        }
+        if (range[0] == '-' || first < 0 || last < first || last >= 65536) {
+            return {};
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::vector<NumaNode> GetNumaTopology() {
+    std::vector<NumaNode> nodes;
+    std::error_code ec;
+    std::filesystem::directory_iterator dir("/sys/devices/system/node", ec);
+    for (; !ec && dir != std::filesystem::directory_iterator(); dir.increment(ec)) {
+        std::string name = dir->path().filename().string();
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+            name.find_first_not_of("0123456789", 4) != std::string::npos) {
+            continue;
+        }
+        NumaNode node;
+        node.id = std::atoi(name.c_str() + 4);
+        node.cpus = ParseCpuList(ReadFirstLine(dir->path() / "cpulist"));
+        if (!node.cpus.empty()) {
+            nodes.push_back(std::move(node));
+        }
+    }
+
+    if (nodes.empty()) {
+        NumaNode node;
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            node.cpus.push_back(static_cast<int>(cpu));
+        }
+        nodes.push_back(std::move(node));
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+    return nodes;
+}
+
+bool BindToNumaNode(void* ptr, size_t len, int node) {
+#ifdef __linux__
+    if (node < 0 || node >= MAX_NUMA_NODES) {
+        return false;
+    }
+    const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + pageSize - 1) & ~(pageSize - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + len) & ~(pageSize - 1);
+    if (end <= begin) {
+        return false;
+    }
+
+    constexpr size_t BITS = sizeof(unsigned long) * 8;
+    unsigned long mask[MAX_NUMA_NODES / BITS] = {};
+    mask[node / BITS] = 1UL << (node % BITS);
+    // The kernel reads one bit fewer than maxnode says
+    return syscall(SYS_mbind, begin, end - begin, MEMORY_POLICY_PREFERRED, mask,
+                   MAX_NUMA_NODES + 1, 0) == 0;
+#else
+    (void)ptr;
+    (void)len;
+    (void)node;
+    return false;
+#endif
+}
+
+// ============================================================================
+// ThreadPlacement
+// ============================================================================
+
+ThreadPlacement& ThreadPlacement::Instance() {
+    static ThreadPlacement* instance = new ThreadPlacement();  // Outlives thread exit
+    return *instance;
+}
+
+ThreadPlacement::ThreadPlacement() : topology_(GetNumaTopology()) {}
+
+void ThreadPlacement::SetCores(const std::string& role, std::vector<int> cpus) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Role& entry = roles_[role];
+    entry.cores = std::move(cpus);
+    entry.configured = true;
+}
+
+std::vector<int> ThreadPlacement::GetCores(const std::string& role) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = roles_.find(role);
+    return it == roles_.end() ? std::vector<int>() : it->second.cores;
+}
+
+bool ThreadPlacement::Configure(const std::string& spec, std::string& error) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0) {
+        error = "expected ROLE=CPUS, got '" + spec + "'";
+        return false;
+    }
+    std::string role = spec.substr(0, eq);
+    std::string list = spec.substr(eq + 1);
+    std::vector<int> cpus;
+    if (!list.empty()) {
+        cpus = ParseCpuList(list);
+        if (cpus.empty()) {
+            error = "invalid CPU list '" + list + "' for " + role;
+            return false;
+        }
+    }
+    SetCores(role, std::move(cpus));
+    return true;
+}
+
+void ThreadPlacement::ApplyDefaults() {
+    std::vector<NumaNode> topology;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        topology = topology_;
+    }
+    ApplyDefaults(topology);
+}
+
+void ThreadPlacement::ApplyDefaults(const std::vector<NumaNode>& topology) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    topology_ = topology;
+    if (topology.size() < 2) {
+        return;
+    }
+    auto place = [this](const char* role, const std::vector<int>& cpus) {
+        Role& entry = roles_[role];
+        if (!entry.configured) {
+            entry.cores = cpus;
+        }
+    };
+    for (const char* role : NODE_LOCAL_ROLES) {
+        place(role, topology.front().cpus);
+    }
+    for (const char* role : REMOTE_ROLES) {
+        place(role, topology.back().cpus);
+    }
+}
+
+int ThreadPlacement::PreferredNode(const std::string& role) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = roles_.find(role);
+    if (topology_.size() < 2 || it == roles_.end() || it->second.cores.empty()) {
+        return -1;
+    }
+    const std::vector<int>& cores = it->second.cores;
+    for (const NumaNode& node : topology_) {
+        if (std::includes(node.cpus.begin(), node.cpus.end(), cores.begin(), cores.end())) {
+            return node.id;
+        }
+    }
+    return -1;
+}
+
+std::vector<ThreadRoleStats> ThreadPlacement::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ThreadRoleStats> stats;
+    stats.reserve(roles_.size());
+    for (const auto& [name, role] : roles_) {
+        ThreadRoleStats entry;
+        entry.role = name;
+        entry.threads = role.live.size();
+        entry.cores = role.cores;
+        int64_t nanos = role.exitedNs;
+#ifdef __linux__
+        // A live thread leaves its role under mutex_, so its handle is valid here
+        for (const LiveThread& thread : role.live) {
+            nanos += std::max<int64_t>(0, ThreadCpuNanos(thread.handle) - thread.startNs);
+        }
+#endif
+        entry.cpuSeconds = static_cast<double>(nanos) / 1e9;
+        stats.push_back(std::move(entry));
+    }
+    return stats;
+}
+
+void ThreadPlacement::ClearCores() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [name, role] : roles_) {
+        role.cores.clear();
+        role.configured = false;
+    }
+}
+
+void ThreadPlacement::Enter(const std::string& role) {
+#ifdef __linux__
+    std::vector<int> cores;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Role& entry = roles_[role];
+        cores = entry.cores;
+        entry.live.push_back(LiveThread{static_cast<uint64_t>(pthread_self()),
+                                        ClockNanos(CLOCK_THREAD_CPUTIME_ID)});
+    }
+    if (!cores.empty() && !PinCurrentThread(cores)) {
+        LOG_WARN(LogCategory::DEFAULT) << "Could not pin a " << role
+                                       << " thread to its cores; it will float";
+    }
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    roles_[role];
+#endif
+}
+
+void ThreadPlacement::Leave(const std::string& role) {
+#ifdef __linux__
+    int64_t now = ClockNanos(CLOCK_THREAD_CPUTIME_ID);
+    uint64_t self = static_cast<uint64_t>(pthread_self());
+    std::lock_guard<std::mutex> lock(mutex_);
+    Role& entry = roles_[role];
+    for (auto it = entry.live.begin(); it != entry.live.end(); ++it) {
+        if (it->handle == self) {
+            entry.exitedNs += std::max<int64_t>(0, now - it->startNs);
+            entry.live.erase(it);
+            break;
+        }
+    }
+#else
+    (void)role;
+#endif
+}
+
+// ============================================================================
+// ScopedThreadRole
+// ============================================================================
+
+ScopedThreadRole::ScopedThreadRole(std::string role) : role_(std::move(role)) {
+    ThreadPlacement::Instance().Enter(role_);
+}
+
+ScopedThreadRole::~ScopedThreadRole() {
+    ThreadPlacement::Instance().Leave(role_);
+}
+
+} // namespace util
+} // namespace shurium
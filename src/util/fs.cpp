@@ -21,6 +21,7 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <unistd.h>
@@ -545,6 +546,41 @@ bool ResizeFile(const Path& path, uint64_t newSize) {
 #endif
 }
 
+bool FileCommit(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    return FlushFileBuffers(h) != 0;
+#elif defined(__linux__)
+    return fdatasync(fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+void AllocateFileRange(std::FILE* file, uint64_t offset, uint64_t length) {
+#if defined(__linux__)
+    if (posix_fallocate(fileno(file), static_cast<off_t>(offset),
+                        static_cast<off_t>(length)) == 0) {
+        return;
+    }
+#endif
+    // Fallback: write zeros past the current end
+    static const char zeros[65536] = {};
+    if (std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0) {
+        return;
+    }
+    while (length > 0) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(length, sizeof(zeros)));
+        if (std::fwrite(zeros, 1, n, file) != n) {
+            return;
+        }
+        length -= n;
+    }
+}
+
 // ============================================================================
 // Path Queries
 // ============================================================================
@@ -1212,6 +1248,145 @@ void FileLock::Unlock() {
     path_ = Path();
 }
 
+// ============================================================================
+// Memory-Mapped Files
+// ============================================================================
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_)
+    , size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        data_ = other.data_;
+        size_ = other.size_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const Path& path) {
+    Close();
+    
+#ifdef _WIN32
+    // Windows implementation would use CreateFileMapping/MapViewOfFile
+    (void)path;
+    return false;
+#else
+    int fd = open(path.CStr(), O_RDONLY);
+    if (fd < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps its own reference to the file
+    if (addr == MAP_FAILED) return false;
+    
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+#endif
+}
+
+void MappedFile::Close() {
+    if (!data_) return;
+    
+#ifndef _WIN32
+    munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// ============================================================================
+// Sequential Reads
+// ============================================================================
+
+SequentialFile::~SequentialFile() {
+    Close();
+}
+
+SequentialFile::SequentialFile(SequentialFile&& other) noexcept
+    : file_(other.file_)
+    , size_(other.size_)
+    , offset_(other.offset_) {
+    other.file_ = nullptr;
+    other.size_ = 0;
+    other.offset_ = 0;
+}
+
+SequentialFile& SequentialFile::operator=(SequentialFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        file_ = other.file_;
+        size_ = other.size_;
+        offset_ = other.offset_;
+        other.file_ = nullptr;
+        other.size_ = 0;
+        other.offset_ = 0;
+    }
+    return *this;
+}
+
+bool SequentialFile::Open(const Path& path) {
+    Close();
+    
+    file_ = std::fopen(path.CStr(), "rb");
+    if (!file_) return false;
+    
+    // Callers read in large blocks; stdio buffering would only add a copy
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    size_ = FileSize(path);
+    
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fileno(file_), 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(F_RDAHEAD)
+    fcntl(fileno(file_), F_RDAHEAD, 1);
+#endif
+    return true;
+}
+
+void SequentialFile::Close() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    size_ = 0;
+    offset_ = 0;
+}
+
+size_t SequentialFile::Read(uint8_t* buf, size_t len) {
+    if (!file_) return 0;
+    size_t n = std::fread(buf, 1, len, file_);
+    offset_ += n;
+    return n;
+}
+
+void SequentialFile::WillNeed(uint64_t offset, uint64_t len) {
+    if (!file_ || offset >= size_) return;
+    
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fileno(file_), static_cast<off_t>(offset), static_cast<off_t>(len),
+                  POSIX_FADV_WILLNEED);
+#else
+    (void)len;
+#endif
+}
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
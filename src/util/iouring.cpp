@@ -0,0 +1,481 @@
+// SHURIUM - io_uring Submission Ring Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/util/iouring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifdef SHURIUM_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace shurium {
+namespace util {
+
+namespace {
+
+/// User data of single operations; queued operations keep the bit clear
+constexpr uint64_t SINGLE_OPERATION = uint64_t{1} << 63;
+
+} // anonymous namespace
+
+bool IoUringEnabled() {
+#ifdef SHURIUM_IO_URING
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef SHURIUM_IO_URING
+
+// ============================================================================
+// Rings
+// ============================================================================
+
+namespace {
+
+int SysSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int SysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+                                    nullptr, 0));
+}
+
+int SysRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+#ifndef RWF_NOWAIT
+#define RWF_NOWAIT 0x00000008
+#endif
+
+/// Flags for a read at offset. The kernel retries a read of an empty
+/// socket until data arrives, O_NONBLOCK or not; RWF_NOWAIT makes it fail
+/// with -EAGAIN instead, as a nonblocking recv() would.
+uint32_t ReadFlags(uint64_t offset) {
+    return offset == UINT64_MAX ? RWF_NOWAIT : 0;
+}
+
+/// Kernel opcode behind each IoRing::Op
+int OpCode(IoRing::Op op) {
+    switch (op) {
+        case IoRing::Op::READ: return IORING_OP_READ;
+        case IoRing::Op::READ_FIXED: return IORING_OP_READ_FIXED;
+        case IoRing::Op::WRITE: return IORING_OP_WRITE;
+        case IoRing::Op::SENDMSG: return IORING_OP_SENDMSG;
+        case IoRing::Op::SEND_ZC:
+#ifdef IORING_CQE_F_NOTIF
+            return IORING_OP_SEND_ZC;
+#else
+            return -1;  // Headers from before zero-copy send
+#endif
+    }
+    return -1;
+}
+
+} // anonymous namespace
+
+/// The shared submission and completion rings
+struct IoRing::Rings {
+    void* ring{MAP_FAILED};
+    size_t ringSize{0};
+    io_uring_sqe* sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+    size_t sqesSize{0};
+
+    unsigned* sqHead{nullptr};
+    unsigned* sqTail{nullptr};
+    unsigned* sqArray{nullptr};
+    unsigned sqMask{0};
+    unsigned sqEntries{0};
+    unsigned sqLocalTail{0};    // Entries handed out, published or not
+
+    unsigned* cqHead{nullptr};
+    unsigned* cqTail{nullptr};
+    unsigned cqMask{0};
+    io_uring_cqe* cqes{nullptr};
+
+    ~Rings() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqesSize);
+        }
+        if (ring != MAP_FAILED) {
+            munmap(ring, ringSize);
+        }
+    }
+};
+
+std::unique_ptr<IoRing> IoRing::Create(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = SysSetup(entries, &params);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::unique_ptr<IoRing> ring(new IoRing());
+    ring->fd_ = fd;
+    ring->rings_ = std::make_unique<Rings>();
+
+    // One mapping for both rings (5.4+), and no dropped completions (5.5+)
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        return nullptr;
+    }
+
+    Rings& r = *ring->rings_;
+    r.ringSize = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                  params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    r.ring = mmap(nullptr, r.ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                  IORING_OFF_SQ_RING);
+    if (r.ring == MAP_FAILED) {
+        return nullptr;
+    }
+    r.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    r.sqes = static_cast<io_uring_sqe*>(mmap(nullptr, r.sqesSize, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (r.sqes == MAP_FAILED) {
+        return nullptr;
+    }
+
+    uint8_t* base = static_cast<uint8_t*>(r.ring);
+    r.sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    r.sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    r.sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    r.sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    r.sqEntries = params.sq_entries;
+    r.sqLocalTail = *r.sqTail;
+    r.cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    r.cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    r.cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    r.cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+    // Which operations this kernel has (5.6+ for the probe itself)
+    std::vector<uint8_t> probeSpace(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeSpace.data());
+    if (SysRegister(fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        return nullptr;
+    }
+    for (Op op : {Op::READ, Op::READ_FIXED, Op::WRITE, Op::SENDMSG, Op::SEND_ZC}) {
+        int code = OpCode(op);
+        if (code >= 0 && code < probe->ops_len &&
+            (probe->ops[code].flags & IO_URING_OP_SUPPORTED)) {
+            ring->supportedOps_ |= uint64_t{1} << static_cast<unsigned>(op);
+        }
+    }
+    if (!ring->Supports(Op::READ) || !ring->Supports(Op::WRITE) || !ring->Supports(Op::SENDMSG)) {
+        return nullptr;
+    }
+    return ring;
+}
+
+IoRing::~IoRing() {
+    // Closing the ring cancels what is in flight. The pages of unfinished
+    // zero-copy sends stay referenced by the kernel, so dropping the pins
+    // cannot fault; the sockets go with the loop that owns the ring.
+    rings_.reset();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool IoRing::RegisterBuffers(uint8_t* base, size_t size, unsigned count) {
+    std::vector<struct iovec> iov(count);
+    for (unsigned i = 0; i < count; ++i) {
+        iov[i].iov_base = base + i * size;
+        iov[i].iov_len = size;
+    }
+    if (SysRegister(fd_, IORING_REGISTER_BUFFERS, iov.data(), count) < 0) {
+        return false;
+    }
+    registeredBuffers_ = count;
+    return true;
+}
+
+void* IoRing::NextEntry() {
+    Rings& r = *rings_;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        unsigned head = __atomic_load_n(r.sqHead, __ATOMIC_ACQUIRE);
+        if (r.sqLocalTail - head < r.sqEntries) {
+            io_uring_sqe* sqe = &r.sqes[r.sqLocalTail & r.sqMask];
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+        if (Submit() < 0) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+void IoRing::CommitEntry() {
+    Rings& r = *rings_;
+    unsigned index = r.sqLocalTail & r.sqMask;
+    r.sqArray[index] = index;
+    ++r.sqLocalTail;
+    __atomic_store_n(r.sqTail, r.sqLocalTail, __ATOMIC_RELEASE);
+    ++unsubmitted_;
+}
+
+bool IoRing::QueueRead(int fd, void* buf, uint32_t len, uint64_t offset, uint64_t userData) {
+    auto* sqe = static_cast<io_uring_sqe*>(NextEntry());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->rw_flags = ReadFlags(offset);
+    sqe->user_data = userData;
+    CommitEntry();
+    return true;
+}
+
+bool IoRing::QueueReadFixed(int fd, void* buf, uint32_t len, uint64_t offset, uint16_t bufIndex,
+                            uint64_t userData) {
+    auto* sqe = static_cast<io_uring_sqe*>(NextEntry());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->rw_flags = ReadFlags(offset);
+    sqe->buf_index = bufIndex;
+    sqe->user_data = userData;
+    CommitEntry();
+    return true;
+}
+
+bool IoRing::QueueWrite(int fd, const void* buf, uint32_t len, uint64_t offset,
+                        uint64_t userData) {
+    auto* sqe = static_cast<io_uring_sqe*>(NextEntry());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = userData;
+    CommitEntry();
+    return true;
+}
+
+bool IoRing::QueueSendMsg(int fd, const struct msghdr* msg, int flags, uint64_t userData) {
+    auto* sqe = static_cast<io_uring_sqe*>(NextEntry());
+    if (!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(msg);
+    sqe->len = 1;
+    sqe->msg_flags = static_cast<uint32_t>(flags);
+    sqe->user_data = userData;
+    CommitEntry();
+    return true;
+}
+
+int IoRing::Submit(unsigned minComplete) {
+    // Completions already set aside count towards what the caller awaits
+    minComplete -= std::min<unsigned>(minComplete, static_cast<unsigned>(setAside_.size()));
+    if (unsubmitted_ == 0 && minComplete == 0) {
+        return 0;
+    }
+    unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int submitted;
+    do {
+        submitted = SysEnter(fd_, unsubmitted_, minComplete, flags);
+    } while (submitted < 0 && errno == EINTR);
+    if (submitted < 0) {
+        return -errno;
+    }
+    unsubmitted_ -= std::min<unsigned>(unsubmitted_, static_cast<unsigned>(submitted));
+    return submitted;
+}
+
+bool IoRing::ReapOne(Completion& out) {
+    Rings& r = *rings_;
+    while (true) {
+        unsigned head = *r.cqHead;
+        if (head == __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const io_uring_cqe& cqe = r.cqes[head & r.cqMask];
+        uint64_t userData = cqe.user_data;
+        int32_t result = cqe.res;
+        uint32_t flags = cqe.flags;
+        __atomic_store_n(r.cqHead, head + 1, __ATOMIC_RELEASE);
+
+#ifdef IORING_CQE_F_NOTIF
+        // The kernel is done with a zero-copy send's pages
+        if (flags & IORING_CQE_F_NOTIF) {
+            pins_.erase(userData);
+            continue;
+        }
+        // A failed zero-copy send gets no notification
+        if (!(flags & IORING_CQE_F_MORE)) {
+            pins_.erase(userData);
+        }
+#else
+        (void)flags;
+#endif
+        out.userData = userData;
+        out.result = result;
+        return true;
+    }
+}
+
+bool IoRing::PopCompletion(Completion& out) {
+    if (!setAside_.empty()) {
+        out = setAside_.front();
+        setAside_.pop_front();
+        return true;
+    }
+    return ReapOne(out);
+}
+
+int32_t IoRing::RunSingle(uint64_t userData) {
+    int ret = Submit();
+    if (ret < 0) {
+        return ret;
+    }
+    while (true) {
+        Completion completion;
+        while (ReapOne(completion)) {
+            if (completion.userData == userData) {
+                return completion.result;
+            }
+            if (!(completion.userData & SINGLE_OPERATION)) {
+                setAside_.push_back(completion);
+            }
+        }
+        int waited;
+        do {
+            waited = SysEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS);
+        } while (waited < 0 && errno == EINTR);
+        if (waited < 0) {
+            return -errno;
+        }
+    }
+}
+
+int64_t IoRing::ReadAt(int fd, void* buf, size_t len, uint64_t offset) {
+    uint8_t* out = static_cast<uint8_t*>(buf);
+    size_t done = 0;
+    while (done < len) {
+        uint64_t userData = SINGLE_OPERATION | nextSingle_++;
+        uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(len - done, UINT32_MAX));
+        if (!QueueRead(fd, out + done, chunk, offset + done, userData)) {
+            return -EBUSY;
+        }
+        int32_t n = RunSingle(userData);
+        if (n < 0) {
+            return n;
+        }
+        if (n == 0) {
+            break;  // End of file
+        }
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<int64_t>(done);
+}
+
+int64_t IoRing::WriteAt(int fd, const void* buf, size_t len, uint64_t offset) {
+    const uint8_t* in = static_cast<const uint8_t*>(buf);
+    size_t done = 0;
+    while (done < len) {
+        uint64_t userData = SINGLE_OPERATION | nextSingle_++;
+        uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(len - done, UINT32_MAX));
+        if (!QueueWrite(fd, in + done, chunk, offset + done, userData)) {
+            return -EBUSY;
+        }
+        int32_t n = RunSingle(userData);
+        if (n < 0) {
+            return n;
+        }
+        if (n == 0) {
+            return -EIO;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return static_cast<int64_t>(done);
+}
+
+int32_t IoRing::SendZeroCopy(int fd, const void* buf, uint32_t len, int flags,
+                             std::shared_ptr<const void> pin) {
+#ifdef IORING_CQE_F_NOTIF
+    auto* sqe = static_cast<io_uring_sqe*>(NextEntry());
+    if (!sqe) {
+        return -EBUSY;
+    }
+    uint64_t userData = SINGLE_OPERATION | nextSingle_++;
+    sqe->opcode = IORING_OP_SEND_ZC;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->msg_flags = static_cast<uint32_t>(flags);
+    sqe->user_data = userData;
+    CommitEntry();
+    pins_[userData] = std::move(pin);
+    return RunSingle(userData);
+#else
+    (void)fd;
+    (void)buf;
+    (void)len;
+    (void)flags;
+    (void)pin;
+    return -EOPNOTSUPP;
+#endif
+}
+
+#else // SHURIUM_IO_URING
+
+// ============================================================================
+// Builds without io_uring: no ring is ever created
+// ============================================================================
+
+struct IoRing::Rings {};
+
+std::unique_ptr<IoRing> IoRing::Create(unsigned) { return nullptr; }
+IoRing::~IoRing() = default;
+bool IoRing::RegisterBuffers(uint8_t*, size_t, unsigned) { return false; }
+void* IoRing::NextEntry() { return nullptr; }
+void IoRing::CommitEntry() {}
+bool IoRing::QueueRead(int, void*, uint32_t, uint64_t, uint64_t) { return false; }
+bool IoRing::QueueReadFixed(int, void*, uint32_t, uint64_t, uint16_t, uint64_t) { return false; }
+bool IoRing::QueueWrite(int, const void*, uint32_t, uint64_t, uint64_t) { return false; }
+bool IoRing::QueueSendMsg(int, const struct msghdr*, int, uint64_t) { return false; }
+int IoRing::Submit(unsigned) { return -ENOSYS; }
+bool IoRing::ReapOne(Completion&) { return false; }
+bool IoRing::PopCompletion(Completion&) { return false; }
+int32_t IoRing::RunSingle(uint64_t) { return -ENOSYS; }
+int64_t IoRing::ReadAt(int, void*, size_t, uint64_t) { return -ENOSYS; }
+int64_t IoRing::WriteAt(int, const void*, size_t, uint64_t) { return -ENOSYS; }
+int32_t IoRing::SendZeroCopy(int, const void*, uint32_t, int, std::shared_ptr<const void>) {
+    return -ENOSYS;
+}
+
+#endif // SHURIUM_IO_URING
+
+bool IoRing::Supports(Op op) const {
+    return (supportedOps_ >> static_cast<unsigned>(op)) & 1;
+}
+
+} // namespace util
+} // namespace shurium
@@ -5,6 +5,8 @@
 #include "shurium/util/logging.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
@@ -365,6 +367,231 @@ void CallbackSink::Write(const LogEntry& entry) {
     callback_(entry);
 }
 
+// ============================================================================
+// Asynchronous Queue
+// ============================================================================
+
+namespace {
+
+/// Set on the writer thread, whose own log calls must never wait on itself
+thread_local bool t_logWriterThread = false;
+
+} // anonymous namespace
+
+/**
+ * Bounded multi-producer, single-consumer ring buffer (Vyukov's sequence
+ * per slot scheme) with the writer thread that drains it. Producers claim
+ * a slot with one CAS and never take a lock unless they have to wait for
+ * room; the writer sleeps on a condition variable only when it finds the
+ * buffer empty.
+ */
+class Logger::AsyncQueue {
+public:
+    AsyncQueue(Logger& logger, const AsyncLogConfig& config)
+        : logger_(logger)
+        , batchSize_(std::max<size_t>(config.batchSize, 1))
+        , reportedDrops_(logger.droppedCount_.load()) {
+        size_t capacity = 2;
+        while (capacity < config.capacity) {
+            capacity <<= 1;
+        }
+        mask_ = capacity - 1;
+        slots_.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        thread_ = std::thread(&AsyncQueue::Run, this);
+    }
+    
+    ~AsyncQueue() {
+        Stop();
+    }
+    
+    /// Queue entry (moved from only on success); false if full
+    bool TryPush(LogEntry& entry) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos & mask_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    slot.entry = std::move(entry);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        
+        pushed_.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writerSleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+        return true;
+    }
+    
+    /// Queue entry, waiting for room
+    void Push(LogEntry& entry) {
+        if (TryPush(entry)) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++blocked_;
+        while (true) {
+            room_.wait_for(lock, std::chrono::milliseconds(1));
+            lock.unlock();
+            bool pushed = TryPush(entry);  // Takes mutex_ to wake the writer
+            lock.lock();
+            if (pushed) {
+                break;
+            }
+        }
+        --blocked_;
+    }
+    
+    /// Wait until everything queued before the call has been written
+    void Flush() {
+        uint64_t target = pushed_.load();
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.notify_one();
+        ++flushers_;
+        while (written_.load() < target) {
+            drained_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        --flushers_;
+    }
+    
+    /// Write everything queued and join the writer
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        LogEntry entry;
+    };
+    
+    bool HasEntry() const {
+        return slots_[dequeuePos_ & mask_].sequence.load(std::memory_order_acquire) ==
+               dequeuePos_ + 1;
+    }
+    
+    bool TryPop(LogEntry& entry) {
+        if (!HasEntry()) {
+            return false;
+        }
+        Slot& slot = slots_[dequeuePos_ & mask_];
+        entry = std::move(slot.entry);
+        slot.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+    
+    void Run() {
+        t_logWriterThread = true;
+        std::vector<LogEntry> batch;
+        batch.reserve(batchSize_);
+        
+        while (true) {
+            LogEntry entry;
+            while (batch.size() < batchSize_ && TryPop(entry)) {
+                batch.push_back(std::move(entry));
+            }
+            
+            if (!batch.empty()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (blocked_ > 0) {
+                        room_.notify_all();
+                    }
+                }
+                
+                uint64_t drops = logger_.droppedCount_.load();
+                {
+                    std::lock_guard<std::mutex> lock(logger_.sinksMutex_);
+                    for (const auto& queued : batch) {
+                        for (const auto& sink : logger_.sinks_) {
+                            sink->Write(queued);
+                        }
+                    }
+                    if (drops != reportedDrops_) {
+                        LogEntry notice;
+                        notice.level = LogLevel::Warn;
+                        notice.category = LogCategory::DEFAULT;
+                        notice.message = "Dropped " + std::to_string(drops - reportedDrops_) +
+                                         " log messages (async log queue full)";
+                        notice.timestamp = std::chrono::system_clock::now();
+                        notice.threadId = std::this_thread::get_id();
+                        for (const auto& sink : logger_.sinks_) {
+                            sink->Write(notice);
+                        }
+                        reportedDrops_ = drops;
+                    }
+                }
+                written_.fetch_add(batch.size());
+                batch.clear();
+                
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (flushers_ > 0) {
+                    drained_.notify_all();
+                }
+                continue;
+            }
+            
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stop_) {
+                if (!HasEntry()) {
+                    break;
+                }
+                continue;
+            }
+            writerSleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!HasEntry()) {
+                // Timed, so a wakeup lost to a race costs at most this long
+                wake_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            writerSleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+    
+    Logger& logger_;
+    size_t batchSize_;
+    uint64_t reportedDrops_;                     // Writer only
+    size_t mask_{0};
+    std::unique_ptr<Slot[]> slots_;
+    
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) size_t dequeuePos_{0};           // Writer only
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<bool> writerSleeping_{false};
+    
+    std::mutex mutex_;
+    std::condition_variable wake_;               // Writer waits for entries
+    std::condition_variable room_;               // Producers wait for room
+    std::condition_variable drained_;            // Flush waits for the writer
+    size_t blocked_{0};
+    size_t flushers_{0};
+    bool stop_{false};
+    std::thread thread_;
+};
+
 // ============================================================================
 // Logger Implementation
 // ============================================================================
@@ -377,6 +604,7 @@ Logger& Logger::Instance() {
 Logger::Logger() = default;
 
 Logger::~Logger() {
+    StopAsync();
     Shutdown();
 }
 
@@ -390,10 +618,12 @@ void Logger::Initialize() {
     AddSink(consoleSink);
     
     // Enable all categories by default
-    allCategoriesEnabled_ = true;
+    categoryMask_.fetch_or(LogCategory::ALL);
 }
 
 void Logger::Shutdown() {
+    StopAsync();
+    
     if (!initialized_.exchange(false)) {
         return; // Not initialized
     }
@@ -428,31 +658,36 @@ void Logger::SetLevel(LogLevel level) {
 
 void Logger::EnableCategory(const std::string& category) {
     std::lock_guard<std::mutex> lock(categoriesMutex_);
-    enabledCategories_.insert(category);
-    allCategoriesEnabled_ = false;
+    uint64_t bit = LogCategory::Bit(category);
+    if (bit == 0) {
+        enabledCategories_.insert(category);
+    }
+    uint64_t mask = categoryMask_.load() & ~LogCategory::ALL;
+    categoryMask_.store(mask | bit);
 }
 
 void Logger::DisableCategory(const std::string& category) {
     std::lock_guard<std::mutex> lock(categoriesMutex_);
-    enabledCategories_.erase(category);
+    uint64_t bit = LogCategory::Bit(category);
+    if (bit == 0) {
+        enabledCategories_.erase(category);
+    }
+    categoryMask_.store(categoryMask_.load() & ~bit);
 }
 
-bool Logger::IsCategoryEnabled(const std::string& category) const {
-    if (allCategoriesEnabled_) {
-        return true;
-    }
+bool Logger::IsOtherCategoryEnabled(std::string_view category) const {
     std::lock_guard<std::mutex> lock(categoriesMutex_);
-    return enabledCategories_.find(category) != enabledCategories_.end();
+    return enabledCategories_.find(std::string(category)) != enabledCategories_.end();
 }
 
 void Logger::EnableAllCategories() {
     std::lock_guard<std::mutex> lock(categoriesMutex_);
-    allCategoriesEnabled_ = true;
+    categoryMask_.fetch_or(LogCategory::ALL);
 }
 
 void Logger::DisableAllCategories() {
     std::lock_guard<std::mutex> lock(categoriesMutex_);
-    allCategoriesEnabled_ = false;
+    categoryMask_.store(0);
     enabledCategories_.clear();
 }
 
@@ -473,7 +708,31 @@ void Logger::Log(LogLevel level, const std::string& category,
     entry.timestamp = std::chrono::system_clock::now();
     entry.threadId = std::this_thread::get_id();
     
-    // Send to all sinks
+    if (asyncActive_.load()) {
+        // Counted as a producer so StopAsync waits for this push
+        asyncProducers_.fetch_add(1);
+        if (asyncActive_.load()) {
+            if (!asyncQueue_->TryPush(entry)) {
+                LogOverflow policy = overflowPolicy_[static_cast<size_t>(level)].load();
+                if (policy == LogOverflow::Block && !t_logWriterThread) {
+                    asyncQueue_->Push(entry);
+                } else {
+                    droppedCount_.fetch_add(1);
+                }
+            }
+            asyncProducers_.fetch_sub(1);
+            if (level >= LogLevel::Fatal) {
+                Flush();
+            }
+            return;
+        }
+        asyncProducers_.fetch_sub(1);
+    }
+    
+    WriteToSinks(entry);
+}
+
+void Logger::WriteToSinks(const LogEntry& entry) {
     std::lock_guard<std::mutex> lock(sinksMutex_);
     for (const auto& sink : sinks_) {
         sink->Write(entry);
@@ -497,20 +756,50 @@ void Logger::LogF(LogLevel level, const std::string& category,
     Log(level, category, buffer, file, line, function);
 }
 
-bool Logger::WillLog(LogLevel level, const std::string& category) const {
-    if (level < level_.load()) {
-        return false;
-    }
-    return IsCategoryEnabled(category);
-}
-
 void Logger::Flush() {
+    if (asyncActive_.load() && !t_logWriterThread) {
+        asyncProducers_.fetch_add(1);
+        if (asyncActive_.load()) {
+            asyncQueue_->Flush();
+        }
+        asyncProducers_.fetch_sub(1);
+    }
+    
     std::lock_guard<std::mutex> lock(sinksMutex_);
     for (const auto& sink : sinks_) {
         sink->Flush();
     }
 }
 
+void Logger::StartAsync(const AsyncLogConfig& config) {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    if (asyncActive_.load()) {
+        return;
+    }
+    asyncQueue_ = std::make_unique<AsyncQueue>(*this, config);
+    asyncActive_.store(true);
+}
+
+void Logger::StopAsync() {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    if (!asyncActive_.exchange(false)) {
+        return;
+    }
+    
+    // Threads that saw the queue active finish their push first
+    while (asyncProducers_.load() > 0) {
+        std::this_thread::yield();
+    }
+    asyncQueue_->Stop();
+    asyncQueue_.reset();
+}
+
+void Logger::SetOverflowPolicy(LogLevel level, LogOverflow policy) {
+    if (level < LogLevel::Off) {
+        overflowPolicy_[static_cast<size_t>(level)].store(policy);
+    }
+}
+
 // ============================================================================
 // LogStream Implementation
 // ============================================================================
@@ -0,0 +1,247 @@
+// SHURIUM - Metrics Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/util/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace shurium {
+namespace util {
+
+namespace {
+
+std::atomic<size_t> g_nextShard{0};
+
+/// Split "name{labels}" into name and the labels without braces
+std::pair<std::string, std::string> SplitName(const std::string& name) {
+    size_t brace = name.find('{');
+    if (brace == std::string::npos) {
+        return {name, std::string()};
+    }
+    size_t end = name.rfind('}');
+    if (end == std::string::npos || end < brace) {
+        end = name.size();
+    }
+    return {name.substr(0, brace), name.substr(brace + 1, end - brace - 1)};
+}
+
+std::string FormatValue(double value) {
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+}
+
+} // anonymous namespace
+
+size_t MetricShard() {
+    thread_local size_t shard = g_nextShard.fetch_add(1, std::memory_order_relaxed) %
+                                METRIC_SHARDS;
+    return shard;
+}
+
+// ============================================================================
+// Counter
+// ============================================================================
+
+uint64_t Counter::Value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// ============================================================================
+// Histogram
+// ============================================================================
+
+size_t Histogram::BucketOf(uint64_t value) {
+    constexpr uint64_t SUB_BUCKETS = uint64_t{1} << HISTOGRAM_SUB_BUCKET_BITS;
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    size_t msb = 63 - static_cast<size_t>(__builtin_clzll(value));
+    if (msb >= HISTOGRAM_MAX_BITS) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    size_t shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>(value >> shift) & (SUB_BUCKETS - 1);
+    return ((shift + 1) << HISTOGRAM_SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t Histogram::BucketUpperBound(size_t bucket) {
+    constexpr size_t SUB_BUCKETS = size_t{1} << HISTOGRAM_SUB_BUCKET_BITS;
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    size_t shift = (bucket >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+    uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+uint64_t Histogram::Snapshot::ValueAt(double fraction) const {
+    if (count == 0) {
+        return 0;
+    }
+    fraction = std::min(std::max(fraction, 0.0), 1.0);
+    uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return BucketUpperBound(i);
+        }
+    }
+    return BucketUpperBound(buckets.size() - 1);
+}
+
+Histogram::Snapshot Histogram::GetSnapshot() const {
+    Snapshot snapshot;
+    for (const auto& shard : shards_) {
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    for (uint64_t n : snapshot.buckets) {
+        snapshot.count += n;
+    }
+    return snapshot;
+}
+
+// ============================================================================
+// MetricsWriter
+// ============================================================================
+
+void MetricsWriter::WriteHeader(const std::string& family, const std::string& help,
+                                const char* type) {
+    if (family == lastFamily_) {
+        return;
+    }
+    lastFamily_ = family;
+    text_ += "# HELP " + family + ' ' + help + '\n';
+    text_ += "# TYPE " + family + ' ' + type + '\n';
+}
+
+void MetricsWriter::WriteSample(const std::string& name, const std::string& suffix,
+                                const std::string& extraLabel, double value) {
+    auto [family, labels] = SplitName(name);
+    if (!extraLabel.empty()) {
+        labels = labels.empty() ? extraLabel : labels + ',' + extraLabel;
+    }
+    text_ += family + suffix;
+    if (!labels.empty()) {
+        text_ += '{' + labels + '}';
+    }
+    text_ += ' ' + FormatValue(value) + '\n';
+}
+
+void MetricsWriter::WriteCounter(const std::string& name, const std::string& help,
+                                 double value) {
+    WriteHeader(SplitName(name).first, help, "counter");
+    WriteSample(name, "", "", value);
+}
+
+void MetricsWriter::WriteGauge(const std::string& name, const std::string& help, double value) {
+    WriteHeader(SplitName(name).first, help, "gauge");
+    WriteSample(name, "", "", value);
+}
+
+void MetricsWriter::WriteSummary(const std::string& name, const std::string& help,
+                                 const Histogram::Snapshot& snapshot) {
+    static constexpr std::pair<const char*, double> QUANTILES[] = {
+        {"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+    WriteHeader(SplitName(name).first, help, "summary");
+    for (const auto& [label, fraction] : QUANTILES) {
+        WriteSample(name, "", std::string("quantile=\"") + label + '"',
+                    static_cast<double>(snapshot.ValueAt(fraction)));
+    }
+    WriteSample(name, "_sum", "", static_cast<double>(snapshot.sum));
+    WriteSample(name, "_count", "", static_cast<double>(snapshot.count));
+}
+
+// ============================================================================
+// MetricsRegistry
+// ============================================================================
+
+MetricsRegistry& MetricsRegistry::Instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+template<typename Metric>
+Metric& MetricsRegistry::Get(std::map<Key, Entry<Metric>>& metrics, const std::string& name,
+                             const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry<Metric>& entry = metrics[SplitName(name)];
+    if (!entry.metric) {
+        entry.help = help;
+        entry.metric = std::make_unique<Metric>();
+    }
+    return *entry.metric;
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name, const std::string& help) {
+    return Get(counters_, name, help);
+}
+
+Gauge& MetricsRegistry::GetGauge(const std::string& name, const std::string& help) {
+    return Get(gauges_, name, help);
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name, const std::string& help) {
+    return Get(histograms_, name, help);
+}
+
+void MetricsRegistry::RegisterCollector(const std::string& key, MetricsCollector collector) {
+    std::lock_guard<std::mutex> lock(collectMutex_);
+    collectors_[key] = std::move(collector);
+}
+
+void MetricsRegistry::UnregisterCollector(const std::string& key) {
+    std::lock_guard<std::mutex> lock(collectMutex_);
+    collectors_.erase(key);
+}
+
+std::string MetricsRegistry::Render() const {
+    auto fullName = [](const Key& key) {
+        return key.second.empty() ? key.first : key.first + '{' + key.second + '}';
+    };
+
+    MetricsWriter writer;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [key, entry] : counters_) {
+            writer.WriteCounter(fullName(key), entry.help,
+                                static_cast<double>(entry.metric->Value()));
+        }
+        for (const auto& [key, entry] : gauges_) {
+            writer.WriteGauge(fullName(key), entry.help,
+                              static_cast<double>(entry.metric->Value()));
+        }
+        for (const auto& [key, entry] : histograms_) {
+            writer.WriteSummary(fullName(key), entry.help, entry.metric->GetSnapshot());
+        }
+    }
+
+    // Collectors take their subsystems' locks, so they run under a mutex of
+    // their own that hot paths getting metrics never wait on
+    std::lock_guard<std::mutex> lock(collectMutex_);
+    for (const auto& [key, collector] : collectors_) {
+        collector(writer);
+    }
+    return writer.GetText();
+}
+
+} // namespace util
+} // namespace shurium
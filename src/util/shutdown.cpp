@@ -0,0 +1,178 @@
+// SHURIUM - Shutdown Coordinator Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/util/shutdown.h"
+#include "shurium/util/logging.h"
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace shurium {
+namespace util {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::microseconds Since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+}
+
+/// Run one step, reporting whether it returned normally
+bool RunStep(const std::string& stage, const std::string& name, const std::function<void()>& step) {
+    try {
+        step();
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR(LogCategory::DEFAULT) << "Shutdown step " << stage << "/" << name
+                                        << " failed: " << e.what();
+    } catch (...) {
+        LOG_ERROR(LogCategory::DEFAULT) << "Shutdown step " << stage << "/" << name
+                                        << " failed";
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+ShutdownCoordinator& ShutdownCoordinator::AddStage(const std::string& name,
+                                                   std::chrono::milliseconds deadline) {
+    Stage stage;
+    stage.name = name;
+    stage.deadline = deadline;
+    stages_.push_back(std::move(stage));
+    return *this;
+}
+
+ShutdownCoordinator& ShutdownCoordinator::AddCriticalStage(const std::string& name) {
+    Stage stage;
+    stage.name = name;
+    stage.critical = true;
+    stages_.push_back(std::move(stage));
+    return *this;
+}
+
+ShutdownCoordinator& ShutdownCoordinator::AddStep(const std::string& name,
+                                                  std::function<void()> step) {
+    if (stages_.empty()) {
+        AddStage("default");
+    }
+    stages_.back().steps.emplace_back(name, std::move(step));
+    return *this;
+}
+
+void ShutdownCoordinator::Run() {
+    timings_.clear();
+    auto start = Clock::now();
+    for (Stage& stage : stages_) {
+        if (stage.steps.empty()) {
+            continue;
+        }
+        timings_.push_back(stage.critical ? RunCritical(stage) : RunParallel(stage));
+    }
+    stages_.clear();
+
+    LOG_INFO(LogCategory::DEFAULT) << "Shutdown took "
+                                   << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          Since(start)).count()
+                                   << "ms: " << FormatTimings();
+}
+
+ShutdownCoordinator::StageTiming ShutdownCoordinator::RunCritical(Stage& stage) {
+    StageTiming timing;
+    timing.name = stage.name;
+    timing.critical = true;
+    auto stageStart = Clock::now();
+    for (auto& [name, step] : stage.steps) {
+        auto stepStart = Clock::now();
+        bool ok = RunStep(stage.name, name, step);
+        timing.steps.push_back({name, Since(stepStart), ok ? Outcome::DONE : Outcome::FAILED});
+    }
+    timing.elapsed = Since(stageStart);
+    return timing;
+}
+
+ShutdownCoordinator::StageTiming ShutdownCoordinator::RunParallel(Stage& stage) {
+    // Shared with the step threads, which may outlive this call
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t remaining{0};
+        std::vector<StepTiming> steps;
+        std::vector<bool> finished;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = stage.steps.size();
+    state->finished.assign(stage.steps.size(), false);
+    for (const auto& entry : stage.steps) {
+        state->steps.push_back({entry.first, {}, Outcome::TIMED_OUT});
+    }
+
+    auto stageStart = Clock::now();
+    for (size_t i = 0; i < stage.steps.size(); ++i) {
+        std::thread([state, i, stageName = stage.name, name = stage.steps[i].first,
+                     step = std::move(stage.steps[i].second), stageStart]() {
+            bool ok = RunStep(stageName, name, step);
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->steps[i].elapsed = Since(stageStart);
+            state->steps[i].outcome = ok ? Outcome::DONE : Outcome::FAILED;
+            state->finished[i] = true;
+            if (--state->remaining == 0) {
+                state->cv.notify_all();
+            }
+        }).detach();
+    }
+
+    StageTiming timing;
+    timing.name = stage.name;
+    std::unique_lock<std::mutex> lock(state->mutex);
+    auto allDone = [&state] { return state->remaining == 0; };
+    if (stage.deadline == NO_DEADLINE) {
+        state->cv.wait(lock, allDone);
+    } else if (!state->cv.wait_for(lock, stage.deadline, allDone)) {
+        for (size_t i = 0; i < state->steps.size(); ++i) {
+            if (!state->finished[i]) {
+                state->steps[i].elapsed = Since(stageStart);
+                LOG_WARN(LogCategory::DEFAULT) << "Shutdown step " << stage.name << "/"
+                                               << state->steps[i].name << " still running after "
+                                               << stage.deadline.count() << "ms; moving on";
+            }
+        }
+    }
+    timing.steps = state->steps;
+    timing.elapsed = Since(stageStart);
+    return timing;
+}
+
+std::string ShutdownCoordinator::FormatTimings() const {
+    auto ms = [](std::chrono::microseconds us) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(us).count();
+    };
+    std::ostringstream out;
+    for (size_t i = 0; i < timings_.size(); ++i) {
+        const StageTiming& stage = timings_[i];
+        if (i > 0) {
+            out << "; ";
+        }
+        out << stage.name << " " << ms(stage.elapsed) << "ms [";
+        for (size_t j = 0; j < stage.steps.size(); ++j) {
+            const StepTiming& step = stage.steps[j];
+            out << (j > 0 ? ", " : "") << step.name << " " << ms(step.elapsed) << "ms";
+            if (step.outcome == Outcome::TIMED_OUT) {
+                out << " (timed out)";
+            } else if (step.outcome == Outcome::FAILED) {
+                out << " (failed)";
+            }
+        }
+        out << "]";
+    }
+    return out.str();
+}
+
+} // namespace util
+} // namespace shurium
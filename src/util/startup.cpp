@@ -0,0 +1,153 @@
+// SHURIUM - Startup Profile Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/util/startup.h"
+#include "shurium/util/logging.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace shurium {
+namespace util {
+
+namespace {
+
+std::chrono::microseconds Micros(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d);
+}
+
+} // anonymous namespace
+
+const char* StartupPhaseName(StartupPhase phase) {
+    switch (phase) {
+        case StartupPhase::CONFIG:      return "config";
+        case StartupPhase::DATABASES:   return "databases";
+        case StartupPhase::CHAINSTATE:  return "chainstate";
+        case StartupPhase::BLOCK_INDEX: return "block_index";
+        case StartupPhase::MEMPOOL:     return "mempool";
+        case StartupPhase::WALLET:      return "wallet";
+        case StartupPhase::NETWORK:     return "network";
+    }
+    return "unknown";
+}
+
+const char* StartupStateName(StartupProfile::State state) {
+    switch (state) {
+        case StartupProfile::State::PENDING: return "pending";
+        case StartupProfile::State::RUNNING: return "running";
+        case StartupProfile::State::DONE:    return "done";
+        case StartupProfile::State::SKIPPED: return "skipped";
+        case StartupProfile::State::FAILED:  return "failed";
+    }
+    return "unknown";
+}
+
+StartupProfile::StartupProfile() : created_(Clock::now()) {}
+
+void StartupProfile::Begin(StartupPhase phase) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = phases_[static_cast<size_t>(phase)];
+    entry.state = State::RUNNING;
+    entry.begin = Clock::now();
+}
+
+void StartupProfile::End(StartupPhase phase, bool success) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = phases_[static_cast<size_t>(phase)];
+    if (entry.state != State::RUNNING) {
+        return;
+    }
+    entry.elapsed += Micros(Clock::now() - entry.begin);
+    entry.state = success ? State::DONE : State::FAILED;
+}
+
+void StartupProfile::Record(StartupPhase phase, std::chrono::microseconds elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = phases_[static_cast<size_t>(phase)];
+    entry.elapsed += elapsed;
+    entry.state = State::DONE;
+    created_ = std::min(created_, Clock::now() - elapsed);
+}
+
+void StartupProfile::Skip(StartupPhase phase) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phases_[static_cast<size_t>(phase)].state = State::SKIPPED;
+}
+
+void StartupProfile::MarkStarted() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        startedFlag_ = true;
+        started_ = Clock::now();
+    }
+    LOG_INFO(LogCategory::DEFAULT) << "Startup took "
+                                   << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          GetStartupTime()).count()
+                                   << "ms: " << FormatReport();
+}
+
+bool StartupProfile::IsReady() const {
+    return GetBlockers().empty();
+}
+
+std::vector<std::string> StartupProfile::GetBlockers() const {
+    std::vector<std::string> blockers;
+    if (stopping_.load(std::memory_order_relaxed)) {
+        blockers.push_back("shutting down");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < NUM_STARTUP_PHASES; ++i) {
+        State state = phases_[i].state;
+        if (state == State::PENDING || state == State::RUNNING) {
+            blockers.push_back(std::string(StartupPhaseName(static_cast<StartupPhase>(i))) +
+                               " " + StartupStateName(state));
+        }
+    }
+    if (!startedFlag_) {
+        blockers.push_back("startup running");
+    }
+    return blockers;
+}
+
+std::vector<StartupProfile::PhaseTiming> StartupProfile::GetPhases() const {
+    std::vector<PhaseTiming> result;
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < NUM_STARTUP_PHASES; ++i) {
+        const Entry& entry = phases_[i];
+        PhaseTiming timing{static_cast<StartupPhase>(i), entry.state, entry.elapsed};
+        if (entry.state == State::RUNNING) {
+            timing.elapsed += Micros(now - entry.begin);
+        }
+        result.push_back(timing);
+    }
+    return result;
+}
+
+std::chrono::microseconds StartupProfile::GetStartupTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Micros((startedFlag_ ? started_ : Clock::now()) - created_);
+}
+
+std::string StartupProfile::FormatReport() const {
+    std::ostringstream out;
+    bool first = true;
+    for (const PhaseTiming& timing : GetPhases()) {
+        out << (first ? "" : ", ") << StartupPhaseName(timing.phase);
+        first = false;
+        if (timing.state == State::SKIPPED || timing.state == State::PENDING) {
+            out << " " << StartupStateName(timing.state);
+            continue;
+        }
+        out << " " << std::chrono::duration_cast<std::chrono::milliseconds>(timing.elapsed).count()
+            << "ms";
+        if (timing.state != State::DONE) {
+            out << " (" << StartupStateName(timing.state) << ")";
+        }
+    }
+    return out.str();
+}
+
+} // namespace util
+} // namespace shurium
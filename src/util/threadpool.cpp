@@ -3,12 +3,178 @@
 // MIT License
 
 #include "shurium/util/threadpool.h"
+#include "shurium/util/affinity.h"
 
 #include <algorithm>
 
 namespace shurium {
 namespace util {
 
+// ============================================================================
+// Task Storage
+// ============================================================================
+
+namespace {
+
+/// Most recycled nodes a thread keeps
+constexpr size_t MAX_CACHED_TASK_NODES = 256;
+
+struct TaskNodeCache {
+    std::vector<void*> free;
+    
+    ~TaskNodeCache() {
+        for (void* memory : free) {
+            ::operator delete(memory);
+        }
+    }
+};
+
+thread_local TaskNodeCache t_taskNodeCache;
+
+/// Pool and index of the worker running on this thread (if any)
+thread_local const ThreadPool* t_workerPool = nullptr;
+thread_local size_t t_workerIndex = 0;
+
+} // anonymous namespace
+
+namespace detail {
+
+void* AllocateTaskNode() {
+    auto& free = t_taskNodeCache.free;
+    if (!free.empty()) {
+        void* memory = free.back();
+        free.pop_back();
+        return memory;
+    }
+    return ::operator new(sizeof(TaskNode));
+}
+
+void FreeTaskNode(void* memory) noexcept {
+    auto& free = t_taskNodeCache.free;
+    if (free.size() < MAX_CACHED_TASK_NODES) {
+        try {
+            free.push_back(memory);
+            return;
+        } catch (...) {
+        }
+    }
+    ::operator delete(memory);
+}
+
+void TaskNode::Destroy(TaskNode* node) {
+    node->drop_(node->callable_);
+    node->~TaskNode();
+    FreeTaskNode(node);
+}
+
+} // namespace detail
+
+// ============================================================================
+// Work-Stealing Deque
+// ============================================================================
+
+/**
+ * Chase-Lev deque (with the memory orderings of Le et al., "Correct and
+ * Efficient Work-Stealing for Weak Memory Models"). Only the owning worker
+ * pushes and pops, at the bottom; any thread steals from the top. The
+ * buffer doubles when full; old buffers stay allocated until the deque is
+ * destroyed, since a thief may still be reading one.
+ */
+class ThreadPool::Worker {
+public:
+    explicit Worker(size_t capacity = 256) {
+        buffers_.push_back(std::make_unique<Buffer>(capacity));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+    
+    /// Owner only
+    void Push(detail::TaskNode* node) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(buffer->mask)) {
+            buffer = Grow(buffer, t, b);
+        }
+        buffer->Put(b, node);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    
+    /// Owner only: newest task first
+    detail::TaskNode* Pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        
+        detail::TaskNode* node = nullptr;
+        if (t <= b) {
+            node = buffer->Get(b);
+            if (t == b) {
+                // Last task: race any thief for it
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    node = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+    
+    /// Any thread: oldest task first (nullptr if empty or lost a race)
+    detail::TaskNode* Steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Buffer* buffer = buffer_.load(std::memory_order_acquire);
+        detail::TaskNode* node = buffer->Get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return node;
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t capacity)
+            : mask(capacity - 1), slots(new std::atomic<detail::TaskNode*>[capacity]) {}
+        
+        detail::TaskNode* Get(int64_t i) const {
+            return slots[static_cast<size_t>(i) & mask].load(std::memory_order_relaxed);
+        }
+        
+        void Put(int64_t i, detail::TaskNode* node) {
+            slots[static_cast<size_t>(i) & mask].store(node, std::memory_order_relaxed);
+        }
+        
+        size_t mask;
+        std::unique_ptr<std::atomic<detail::TaskNode*>[]> slots;
+    };
+    
+    Buffer* Grow(Buffer* old, int64_t top, int64_t bottom) {
+        buffers_.push_back(std::make_unique<Buffer>((old->mask + 1) * 2));
+        Buffer* grown = buffers_.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            grown->Put(i, old->Get(i));
+        }
+        buffer_.store(grown, std::memory_order_release);
+        return grown;
+    }
+    
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Buffer*> buffer_{nullptr};
+    std::vector<std::unique_ptr<Buffer>> buffers_;  // Owner only
+};
+
 // ============================================================================
 // ThreadPool Implementation
 // ============================================================================
@@ -47,9 +213,13 @@ void ThreadPool::Start() {
         }
     }
     
+    queues_.clear();
+    for (size_t i = 0; i < numThreads; ++i) {
+        queues_.push_back(std::make_unique<Worker>());
+    }
     workers_.reserve(numThreads);
     for (size_t i = 0; i < numThreads; ++i) {
-        workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
     }
 }
 
@@ -59,9 +229,11 @@ void ThreadPool::Stop() {
 
 void ThreadPool::Wait() {
     std::unique_lock<std::mutex> lock(queueMutex_);
+    waiters_.fetch_add(1);
     waitCondition_.wait(lock, [this] {
-        return tasks_.empty() && activeTasks_.load() == 0;
+        return pendingTasks_.load() == 0 && activeTasks_.load() == 0;
     });
+    waiters_.fetch_sub(1);
 }
 
 void ThreadPool::Shutdown() {
@@ -74,7 +246,7 @@ void ThreadPool::Shutdown() {
         stopping_.store(true);
     }
     
-    // Wake up all workers
+    // Wake up all workers; they finish what is queued, then exit
     condition_.notify_all();
     
     // Join all threads
@@ -84,55 +256,210 @@ void ThreadPool::Shutdown() {
         }
     }
     workers_.clear();
+    queues_.clear();
     
-    // Clear remaining tasks
-    std::priority_queue<PrioritizedTask> empty;
-    std::swap(tasks_, empty);
+    // Nothing can be left, but don't leak if it is
+    std::lock_guard<std::mutex> lock(injectMutex_);
+    for (size_t lane = 0; lane < PRIORITY_LANES; ++lane) {
+        for (detail::TaskNode* node : injected_[lane]) {
+            detail::TaskNode::Destroy(node);
+        }
+        injected_[lane].clear();
+        injectedCount_[lane].store(0);
+    }
 }
 
 size_t ThreadPool::PendingTasks() const {
-    std::unique_lock<std::mutex> lock(queueMutex_);
-    return tasks_.size();
+    return pendingTasks_.load();
+}
+
+bool ThreadPool::Enqueue(detail::TaskNode* node, bool shouldThrow) {
+    // Count the task before checking running_, so that a worker deciding to
+    // exit at shutdown either sees it or this sees the shutdown
+    size_t pending = pendingTasks_.fetch_add(1);
+    const char* error = nullptr;
+    if (!running_.load()) {
+        error = "ThreadPool not running";
+    } else if (pending >= config_.maxQueueSize) {
+        error = "ThreadPool queue full";
+    }
+    if (error) {
+        pendingTasks_.fetch_sub(1);
+        detail::TaskNode::Destroy(node);
+        if (shouldThrow) {
+            throw std::runtime_error(error);
+        }
+        return false;
+    }
+    
+    if (t_workerPool == this && node->Priority() == TaskPriority::Normal) {
+        queues_[t_workerIndex]->Push(node);
+    } else {
+        size_t lane = static_cast<size_t>(node->Priority());
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        injected_[lane].push_back(node);
+        injectedCount_[lane].fetch_add(1);
+    }
+    
+    NotifyWorker();
+    return true;
+}
+
+void ThreadPool::NotifyWorker() {
+    if (idleWorkers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        condition_.notify_one();
+    }
+}
+
+detail::TaskNode* ThreadPool::TakeInjected(TaskPriority priority) {
+    size_t lane = static_cast<size_t>(priority);
+    if (injectedCount_[lane].load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(injectMutex_);
+    if (injected_[lane].empty()) {
+        return nullptr;
+    }
+    detail::TaskNode* node = injected_[lane].front();
+    injected_[lane].pop_front();
+    injectedCount_[lane].fetch_sub(1);
+    return node;
+}
+
+detail::TaskNode* ThreadPool::FindTask(size_t index) {
+    if (auto* node = TakeInjected(TaskPriority::Critical)) return node;
+    if (auto* node = TakeInjected(TaskPriority::High)) return node;
+    if (auto* node = queues_[index]->Pop()) return node;
+    if (auto* node = TakeInjected(TaskPriority::Normal)) return node;
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        if (auto* node = queues_[(index + i) % queues_.size()]->Steal()) return node;
+    }
+    return TakeInjected(TaskPriority::Low);
 }
 
-void ThreadPool::WorkerLoop() {
+void ThreadPool::WorkerLoop(size_t index) {
+    ScopedThreadRole role(config_.name);
+    t_workerPool = this;
+    t_workerIndex = index;
+    
     while (true) {
-        PrioritizedTask task(TaskPriority::Normal, nullptr);
-        
-        {
+        detail::TaskNode* node = FindTask(index);
+        if (!node) {
             std::unique_lock<std::mutex> lock(queueMutex_);
-            
+            idleWorkers_.fetch_add(1);
             condition_.wait(lock, [this] {
-                return !running_.load() || !tasks_.empty();
+                return !running_.load() || pendingTasks_.load() > 0;
             });
-            
-            if (!running_.load() && tasks_.empty()) {
-                return;
+            idleWorkers_.fetch_sub(1);
+            if (!running_.load() && pendingTasks_.load() == 0) {
+                break;
             }
-            
-            if (tasks_.empty()) {
-                continue;
-            }
-            
-            task = std::move(const_cast<PrioritizedTask&>(tasks_.top()));
-            tasks_.pop();
+            continue;
         }
         
-        if (task.task) {
-            activeTasks_.fetch_add(1);
-            
-            try {
-                task.task();
-            } catch (...) {
-                // Swallow exceptions from tasks
-            }
-            
-            activeTasks_.fetch_sub(1);
+        // Active before no longer pending, so Wait() never sees neither
+        activeTasks_.fetch_add(1);
+        pendingTasks_.fetch_sub(1);
+        
+        try {
+            node->Run();
+        } catch (...) {
+            // Swallow exceptions from tasks
+        }
+        detail::TaskNode::Destroy(node);
+        
+        if (activeTasks_.fetch_sub(1) == 1 && pendingTasks_.load() == 0 &&
+            waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(queueMutex_);
             waitCondition_.notify_all();
         }
     }
+    
+    t_workerPool = nullptr;
 }
 
+// ============================================================================
+// Parallel Algorithms
+// ============================================================================
+
+namespace detail {
+
+void ParallelChunks(size_t begin, size_t end, size_t grain,
+                    const std::function<void(size_t, size_t)>& body,
+                    ThreadPool& pool) {
+    if (begin >= end) {
+        return;
+    }
+    size_t count = end - begin;
+    size_t threads = std::max<size_t>(pool.ThreadCount(), 1);
+    if (grain == 0) {
+        grain = std::max<size_t>(1, count / (threads * 8));
+    }
+    
+    // Shared with the helper tasks, which may start after this returns;
+    // they touch body only after claiming a chunk, and every chunk is
+    // claimed before this returns
+    struct State {
+        std::atomic<size_t> next;
+        std::atomic<size_t> done{0};
+        size_t end;
+        size_t count;
+        size_t grain;
+        const std::function<void(size_t, size_t)>* body;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+        
+        void Work() {
+            while (true) {
+                size_t lo = next.fetch_add(grain);
+                if (lo >= end) {
+                    return;
+                }
+                size_t hi = std::min(end, lo + grain);
+                try {
+                    (*body)(lo, hi);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                if (done.fetch_add(hi - lo) + (hi - lo) == count) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+    
+    auto state = std::make_shared<State>();
+    state->next.store(begin);
+    state->end = end;
+    state->count = count;
+    state->grain = grain;
+    state->body = &body;
+    
+    size_t chunks = (count + grain - 1) / grain;
+    size_t helpers = std::min(threads, chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        if (!pool.IsRunning() || !pool.TrySubmit([state] { state->Work(); })) {
+            break;  // The caller does the rest
+        }
+    }
+    
+    state->Work();
+    
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->done.load() == count; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+} // namespace detail
+
 // ============================================================================
 // Global Thread Pool
 // ============================================================================
@@ -239,6 +566,178 @@ void TaskGroup::RethrowException() {
     }
 }
 
+// ============================================================================
+// TimerWheel Implementation
+// ============================================================================
+
+namespace {
+
+constexpr uint64_t NO_TICK = UINT64_MAX;
+
+/// Ticks covered by levels below level
+constexpr uint64_t LevelSpan(size_t level) {
+    return uint64_t{1} << (TimerWheel::SLOT_BITS * level);
+}
+
+/// Slot index of tick at level
+constexpr size_t SlotOf(uint64_t tick, size_t level) {
+    return static_cast<size_t>((tick >> (TimerWheel::SLOT_BITS * level)) &
+                               (TimerWheel::SLOTS - 1));
+}
+
+/// Distance from slot from to the next set bit of occupied at or after it
+/// (wrapping); occupied must be non-zero
+size_t NextOccupied(uint64_t occupied, size_t from) {
+    uint64_t rotated = (occupied >> from) | (from ? occupied << (TimerWheel::SLOTS - from) : 0);
+    return static_cast<size_t>(__builtin_ctzll(rotated));
+}
+
+} // anonymous namespace
+
+TimerWheel::~TimerWheel() = default;
+
+bool TimerWheel::Add(uint64_t id, uint64_t expiry, uint64_t period,
+                     std::function<void()> task) {
+    auto timer = std::make_unique<Timer>();
+    timer->id = id;
+    timer->expiry = expiry;
+    timer->period = period;
+    timer->task = std::make_shared<std::function<void()>>(std::move(task));
+    
+    Timer* raw = timer.get();
+    if (!timers_.emplace(id, std::move(timer)).second) {
+        return false;
+    }
+    Link(raw);
+    return true;
+}
+
+bool TimerWheel::Cancel(uint64_t id) {
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    Unlink(it->second.get());
+    timers_.erase(it);
+    return true;
+}
+
+void TimerWheel::Clear() {
+    timers_.clear();
+    for (auto& level : slots_) {
+        std::fill(std::begin(level), std::end(level), nullptr);
+    }
+    std::fill(std::begin(occupied_), std::end(occupied_), 0);
+}
+
+void TimerWheel::Link(Timer* timer) {
+    // The lowest level whose range reaches the expiry; due timers go in the
+    // current slot, and those past the top level wait in its furthest slot
+    uint64_t target = std::max(timer->expiry, currentTick_);
+    uint64_t delta = target - currentTick_;
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= LevelSpan(level + 1)) {
+        ++level;
+    }
+    if (delta >= LevelSpan(LEVELS)) {
+        target = currentTick_ + LevelSpan(LEVELS) - 1;
+    }
+    size_t slot = SlotOf(target, level);
+    
+    timer->level = static_cast<uint8_t>(level);
+    timer->slot = static_cast<uint8_t>(slot);
+    timer->prev = nullptr;
+    timer->next = slots_[level][slot];
+    if (timer->next) {
+        timer->next->prev = timer;
+    }
+    slots_[level][slot] = timer;
+    occupied_[level] |= uint64_t{1} << slot;
+}
+
+void TimerWheel::Unlink(Timer* timer) {
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        slots_[timer->level][timer->slot] = timer->next;
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    if (!slots_[timer->level][timer->slot]) {
+        occupied_[timer->level] &= ~(uint64_t{1} << timer->slot);
+    }
+    timer->prev = timer->next = nullptr;
+}
+
+size_t TimerWheel::Cascade(size_t level) {
+    size_t slot = SlotOf(currentTick_, level);
+    Timer* timer = slots_[level][slot];
+    slots_[level][slot] = nullptr;
+    occupied_[level] &= ~(uint64_t{1} << slot);
+    while (timer) {
+        Timer* next = timer->next;
+        Link(timer);
+        timer = next;
+    }
+    return slot;
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<Expired>& expired) {
+    while (currentTick_ <= now) {
+        // Skip ticks with nothing to do
+        uint64_t next = NextTick();
+        if (next > now) {
+            currentTick_ = now + 1;
+            break;
+        }
+        currentTick_ = std::max(currentTick_, next);
+        
+        // Entering a new turn of a level moves its next slot down
+        if (SlotOf(currentTick_, 0) == 0) {
+            for (size_t level = 1; level < LEVELS && Cascade(level) == 0; ++level) {
+            }
+        }
+        
+        size_t slot = SlotOf(currentTick_, 0);
+        Timer* timer = slots_[0][slot];
+        slots_[0][slot] = nullptr;
+        occupied_[0] &= ~(uint64_t{1} << slot);
+        while (timer) {
+            Timer* following = timer->next;
+            expired.push_back(Expired{timer->id, timer->task});
+            if (timer->period > 0) {
+                timer->expiry = currentTick_ + timer->period;
+                Link(timer);
+            } else {
+                timers_.erase(timer->id);
+            }
+            timer = following;
+        }
+        ++currentTick_;
+    }
+}
+
+uint64_t TimerWheel::NextTick() const {
+    uint64_t best = NO_TICK;
+    if (occupied_[0]) {
+        best = currentTick_ + NextOccupied(occupied_[0], SlotOf(currentTick_, 0));
+    }
+    for (size_t level = 1; level < LEVELS; ++level) {
+        if (!occupied_[level]) {
+            continue;
+        }
+        // A slot is moved down when the level below starts a turn with
+        // this level pointing at it
+        uint64_t span = LevelSpan(level);
+        uint64_t turn = (currentTick_ + span - 1) >> (SLOT_BITS * level);
+        uint64_t tick = (turn + NextOccupied(occupied_[level], turn & (SLOTS - 1))) *
+                        span;
+        best = std::min(best, tick);
+    }
+    return best;
+}
+
 // ============================================================================
 // Scheduler Implementation
 // ============================================================================
@@ -268,7 +767,10 @@ void Scheduler::Stop() {
         return; // Not running
     }
     
-    condition_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        condition_.notify_all();
+    }
     
     if (schedulerThread_.joinable()) {
         schedulerThread_.join();
@@ -277,118 +779,84 @@ void Scheduler::Stop() {
     // Clear remaining tasks
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        while (!tasks_.empty()) {
-            tasks_.pop();
-        }
+        wheel_.Clear();
     }
 }
 
 bool Scheduler::Cancel(uint64_t taskId) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Note: We can't efficiently cancel a specific task in a priority queue
-    // We mark it as cancelled and skip it during execution
-    // This is a simplified implementation
-    
-    // Rebuild queue without the cancelled task
-    std::vector<ScheduledTask> remaining;
-    bool found = false;
-    
-    while (!tasks_.empty()) {
-        auto task = std::move(const_cast<ScheduledTask&>(tasks_.top()));
-        tasks_.pop();
-        
-        if (task.id == taskId) {
-            found = true;
-        } else {
-            remaining.push_back(std::move(task));
-        }
-    }
-    
-    for (auto& task : remaining) {
-        tasks_.push(std::move(task));
-    }
-    
-    return found;
+    return wheel_.Cancel(taskId);
 }
 
 void Scheduler::CancelAll() {
     std::lock_guard<std::mutex> lock(mutex_);
-    while (!tasks_.empty()) {
-        tasks_.pop();
-    }
+    wheel_.Clear();
 }
 
 size_t Scheduler::TaskCount() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return tasks_.size();
+    return wheel_.Size();
+}
+
+uint64_t Scheduler::TickAt(std::chrono::steady_clock::time_point time) const {
+    if (time <= epoch_) {
+        return 0;
+    }
+    auto since = std::chrono::ceil<std::chrono::milliseconds>(time - epoch_);
+    return static_cast<uint64_t>(since.count());
 }
 
 uint64_t Scheduler::ScheduleTask(std::chrono::steady_clock::time_point time,
                                   std::chrono::milliseconds period,
                                   std::function<void()> func) {
     uint64_t id = nextId_.fetch_add(1);
+    uint64_t tick = TickAt(time);
+    uint64_t periodTicks = static_cast<uint64_t>(std::max<int64_t>(period.count(), 0));
     
-    ScheduledTask task;
-    task.id = id;
-    task.nextRun = time;
-    task.period = period;
-    task.task = std::move(func);
-    task.cancelled = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    wheel_.Add(id, tick, periodTicks, std::move(func));
     
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        tasks_.push(std::move(task));
+    // Only wake the thread if it would otherwise sleep past this task
+    if (tick < wakeTick_) {
+        condition_.notify_one();
     }
-    
-    condition_.notify_one();
     return id;
 }
 
 void Scheduler::SchedulerLoop() {
+    std::vector<TimerWheel::Expired> due;
+    std::unique_lock<std::mutex> lock(mutex_);
+    
     while (running_.load()) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        if (tasks_.empty()) {
-            // Wait for new tasks or stop signal
-            condition_.wait(lock, [this] {
-                return !running_.load() || !tasks_.empty();
-            });
-            continue;
-        }
-        
-        auto now = std::chrono::steady_clock::now();
-        auto& nextTask = tasks_.top();
-        
-        if (nextTask.nextRun > now) {
-            // Wait until task is due or new task arrives
-            auto waitTime = nextTask.nextRun - now;
-            condition_.wait_for(lock, waitTime);
-            continue;
-        }
-        
-        // Task is due - execute it
-        ScheduledTask task = std::move(const_cast<ScheduledTask&>(tasks_.top()));
-        tasks_.pop();
+        uint64_t now = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - epoch_).count());
+        wheel_.Advance(now, due);
         
-        if (task.cancelled) {
+        if (!due.empty()) {
+            // Dispatch the whole batch outside the lock
+            lock.unlock();
+            for (auto& expired : due) {
+                pool_->Execute([task = std::move(expired.task)]() {
+                    try {
+                        (*task)();
+                    } catch (...) {
+                        // Swallow exceptions
+                    }
+                });
+            }
+            due.clear();
+            lock.lock();
             continue;
         }
         
-        // Execute task on thread pool
-        pool_->Execute([taskFunc = task.task]() {
-            try {
-                taskFunc();
-            } catch (...) {
-                // Swallow exceptions
-            }
-        });
-        
-        // Reschedule if periodic
-        if (task.period.count() > 0) {
-            task.nextRun = std::chrono::steady_clock::now() + task.period;
-            tasks_.push(std::move(task));
+        wakeTick_ = wheel_.NextTick();
+        if (wakeTick_ == UINT64_MAX) {
+            condition_.wait(lock);
+        } else {
+            condition_.wait_until(lock, epoch_ + std::chrono::milliseconds(wakeTick_));
         }
+        wakeTick_ = UINT64_MAX;
     }
 }
 
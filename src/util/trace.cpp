@@ -0,0 +1,164 @@
+// SHURIUM - Trace Spans Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include "shurium/util/trace.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SHURIUM_HAVE_USDT 1
+#endif
+#endif
+
+namespace shurium {
+namespace util {
+
+namespace {
+
+/**
+ * Ring of one thread's spans. Only the owning thread writes it; the mutex
+ * is there for snapshots, so the writer almost never waits on it.
+ */
+struct TraceBuffer {
+    std::mutex mutex;
+    uint32_t threadId{0};
+    bool owned{false};              // Guarded by the registry mutex
+    std::vector<TraceEvent> events;
+    size_t next{0};
+    bool wrapped{false};
+
+    void Clear() {
+        next = 0;
+        wrapped = false;
+    }
+};
+
+/// Every buffer ever handed out. A thread that exits gives its buffer back
+/// for the next new thread, so short-lived threads do not pile up buffers.
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    uint32_t nextThreadId{1};
+};
+
+TraceRegistry& Registry() {
+    static TraceRegistry* registry = new TraceRegistry();  // Outlives thread exit
+    return *registry;
+}
+
+TraceBuffer* AcquireBuffer() {
+    TraceRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    TraceBuffer* buffer = nullptr;
+    for (auto& candidate : registry.buffers) {
+        if (!candidate->owned) {
+            buffer = candidate.get();
+            break;
+        }
+    }
+    if (!buffer) {
+        registry.buffers.push_back(std::make_unique<TraceBuffer>());
+        buffer = registry.buffers.back().get();
+        buffer->events.resize(TRACE_BUFFER_EVENTS);
+    }
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->owned = true;
+    buffer->threadId = registry.nextThreadId++;
+    buffer->Clear();
+    return buffer;
+}
+
+/// The calling thread's claim on a buffer
+struct LocalTrace {
+    TraceBuffer* buffer{AcquireBuffer()};
+
+    ~LocalTrace() {
+        TraceRegistry& registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer->owned = false;
+    }
+};
+
+TraceBuffer& LocalBuffer() {
+    thread_local LocalTrace local;
+    return *local.buffer;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+namespace detail {
+
+uint64_t TraceClock() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+void RecordSpan(const char* name, uint64_t startNs, uint64_t durationNs) {
+#ifdef SHURIUM_HAVE_USDT
+    DTRACE_PROBE3(shurium, span, name, startNs, durationNs);
+#endif
+    TraceBuffer& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events[buffer.next] = TraceEvent{name, startNs, durationNs};
+    if (++buffer.next == buffer.events.size()) {
+        buffer.next = 0;
+        buffer.wrapped = true;
+    }
+}
+
+} // namespace detail
+
+// ============================================================================
+// Snapshot
+// ============================================================================
+
+bool TracingEnabled() {
+#ifdef SHURIUM_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::vector<ThreadTrace> GetTrace() {
+    TraceRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<ThreadTrace> trace;
+    for (const auto& buffer : registry.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        if (buffer->next == 0 && !buffer->wrapped) {
+            continue;
+        }
+        ThreadTrace thread;
+        thread.threadId = buffer->threadId;
+        if (buffer->wrapped) {
+            thread.events.assign(buffer->events.begin() + buffer->next, buffer->events.end());
+        }
+        thread.events.insert(thread.events.end(), buffer->events.begin(),
+                             buffer->events.begin() + buffer->next);
+        trace.push_back(std::move(thread));
+    }
+    return trace;
+}
+
+void ClearTrace() {
+    TraceRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& buffer : registry.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->Clear();
+    }
+}
+
+} // namespace util
+} // namespace shurium
@@ -6,6 +6,7 @@
 #include <shurium/core/random.h>
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
 #include <random>
 
@@ -76,11 +77,8 @@ SelectionResult BranchAndBound::Select(std::vector<OutputGroup> outputs,
         return result;
     }
     
-    // Sort by effective value (descending)
-    std::sort(outputs.begin(), outputs.end(),
-              [](const OutputGroup& a, const OutputGroup& b) {
-                  return a.effectiveValue > b.effectiveValue;
-              });
+    // Sort by effective value (descending); wallet candidates come sorted
+    SortByValue(outputs, false);
     
     // Remove outputs with negative effective value
     outputs.erase(std::remove_if(outputs.begin(), outputs.end(),
@@ -93,39 +91,101 @@ SelectionResult BranchAndBound::Select(std::vector<OutputGroup> outputs,
         return result;
     }
     
-    // Calculate total available
-    Amount totalAvailable = 0;
-    for (const auto& out : outputs) {
-        totalAvailable += out.effectiveValue;
+    // Flat copies of the values, lookahead[i] = sum of values[i..], and
+    // nextDistinct[i] = first index after i holding a smaller value
+    const size_t n = outputs.size();
+    if (n >= std::vector<Amount>().max_size()) {
+        return result;  // Lets the compiler bound the sizes below
+    }
+    std::vector<Amount> values(n);
+    std::vector<Amount> lookahead(n + 1, 0);
+    std::vector<size_t> nextDistinct(n);
+    for (size_t i = n; i-- > 0;) {
+        values[i] = outputs[i].effectiveValue;
+        lookahead[i] = lookahead[i + 1] + values[i];
+        nextDistinct[i] = (i + 1 < n && values[i + 1] == values[i]) ? nextDistinct[i + 1] : i + 1;
     }
     
     // Check if we have enough
-    if (totalAvailable < params.targetValue) {
+    if (lookahead[0] < params.targetValue) {
+        result.searchExhausted = true;
         return result;
     }
     
-    Amount target = params.targetValue;
-    Amount costOfChange = params.GetChangeCost();
+    const Amount target = params.targetValue;
+    const Amount upperBound = target + params.GetChangeCost();
+    const size_t maxIterations = params.bnbMaxIterations;
     
-    std::vector<bool> selection(outputs.size(), false);
-    std::vector<bool> bestSelection(outputs.size(), false);
-    Amount bestValue = std::numeric_limits<Amount>::max();
-    size_t iterations = 0;
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const bool timed = params.bnbTimeBudgetUs > 0;
+    const auto deadline = start + std::chrono::microseconds(params.bnbTimeBudgetUs);
     
-    // Start search
-    bool found = Search(outputs, target, costOfChange, selection, 0, 0, iterations);
+    // Indices of the current selection, in increasing order
+    std::vector<size_t> selection;
+    selection.reserve(n);
+    std::vector<size_t> best;
+    best.reserve(n);
+    Amount bestExcess = std::numeric_limits<Amount>::max();
+    Amount current = 0;
+    size_t next = 0;
+    size_t iterations = 0;
+    bool exhausted = false;
     
-    if (!found && iterations >= MAX_ITERATIONS) {
-        // Timeout - fall back to simple selection
-        return result;
+    while (iterations < maxIterations) {
+        ++iterations;
+        if (timed && (iterations & 0x3ff) == 0 && Clock::now() >= deadline) {
+            break;
+        }
+        
+        bool backtrack = false;
+        if (current > upperBound) {
+            backtrack = true;  // Overshot; smaller outputs come later
+        } else if (current >= target) {
+            // In range; adding more would only grow the excess
+            Amount excess = current - target;
+            if (excess < bestExcess) {
+                bestExcess = excess;
+                best = selection;
+                if (excess == 0) {
+                    break;
+                }
+            }
+            backtrack = true;
+        } else if (current + lookahead[next] < target) {
+            backtrack = true;  // The rest cannot reach the target
+        }
+        
+        if (!backtrack) {
+            // Include the next output
+            selection.push_back(next);
+            current += values[next];
+            ++next;
+            continue;
+        }
+        
+        if (selection.empty()) {
+            exhausted = true;
+            break;
+        }
+        
+        // Leave out the last included output, and the equal values after
+        // it: including one of those instead gives the same sums again
+        size_t last = selection.back();
+        selection.pop_back();
+        current -= values[last];
+        next = nextDistinct[last];
     }
     
-    if (found) {
+    result.iterations = iterations;
+    result.searchExhausted = exhausted;
+    result.searchTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - start).count();
+    
+    if (bestExcess != std::numeric_limits<Amount>::max()) {
         result.success = true;
-        for (size_t i = 0; i < outputs.size(); ++i) {
-            if (selection[i]) {
-                result.Add(outputs[i]);
-            }
+        for (size_t i : best) {
+            result.Add(outputs[i]);
         }
         result.CalculateTotals(params.targetValue, params.feeRate, params.outputSize);
     }
@@ -133,54 +193,6 @@ SelectionResult BranchAndBound::Select(std::vector<OutputGroup> outputs,
     return result;
 }
 
-bool BranchAndBound::Search(const std::vector<OutputGroup>& outputs,
-                             Amount target,
-                             Amount costOfChange,
-                             std::vector<bool>& selection,
-                             Amount currentValue,
-                             size_t depth,
-                             size_t& iterations) {
-    if (++iterations > MAX_ITERATIONS) {
-        return false;
-    }
-    
-    // Check if current selection is exact match (within cost of change)
-    if (currentValue >= target && currentValue <= target + costOfChange) {
-        return true;
-    }
-    
-    // If we've processed all outputs
-    if (depth >= outputs.size()) {
-        return false;
-    }
-    
-    // Prune: if remaining outputs can't reach target
-    Amount remaining = 0;
-    for (size_t i = depth; i < outputs.size(); ++i) {
-        remaining += outputs[i].effectiveValue;
-    }
-    
-    if (currentValue + remaining < target) {
-        return false;  // Can't reach target
-    }
-    
-    // Try including current output
-    selection[depth] = true;
-    if (Search(outputs, target, costOfChange, selection,
-               currentValue + outputs[depth].effectiveValue, depth + 1, iterations)) {
-        return true;
-    }
-    
-    // Try excluding current output
-    selection[depth] = false;
-    if (Search(outputs, target, costOfChange, selection,
-               currentValue, depth + 1, iterations)) {
-        return true;
-    }
-    
-    return false;
-}
-
 // ============================================================================
 // Knapsack Algorithm
 // ============================================================================
@@ -208,10 +220,7 @@ SelectionResult Knapsack::Select(std::vector<OutputGroup> outputs,
     Amount target = params.targetValue;
     
     // First, look for an exact match
-    std::sort(outputs.begin(), outputs.end(),
-              [](const OutputGroup& a, const OutputGroup& b) {
-                  return a.effectiveValue > b.effectiveValue;
-              });
+    SortByValue(outputs, false);
     
     // Check for single output that matches exactly
     for (const auto& out : outputs) {
@@ -303,10 +312,7 @@ void Knapsack::ApproximateBestSubset(const std::vector<OutputGroup>& outputs,
     std::fill(selection.begin(), selection.end(), true);
     bestValue = totalLower;
     
-    // Random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, 1);
+    FastRandomContext rng;
     
     for (size_t pass = 0; pass < PASSES; ++pass) {
         std::vector<bool> currentSelection(outputs.size(), false);
@@ -315,7 +321,7 @@ void Knapsack::ApproximateBestSubset(const std::vector<OutputGroup>& outputs,
         // Random selection
         bool reachedTarget = false;
         for (size_t i = 0; i < outputs.size(); ++i) {
-            if (dist(gen) || (pass == 0 && !reachedTarget)) {
+            if (rng.RandBool() || (pass == 0 && !reachedTarget)) {
                 currentSelection[i] = true;
                 currentValue += outputs[i].effectiveValue;
                 
@@ -554,12 +560,10 @@ std::vector<OutputGroup> CoinSelector::FilterOutputs(
         filtered.push_back(out);
     }
     
-    // If prefer confirmed, sort confirmed first
+    // If prefer confirmed, move confirmed first, keeping the order within each
     if (params_.preferConfirmed) {
-        std::stable_sort(filtered.begin(), filtered.end(),
-                         [](const OutputGroup& a, const OutputGroup& b) {
-                             return a.depth > b.depth;
-                         });
+        std::stable_partition(filtered.begin(), filtered.end(),
+                              [](const OutputGroup& o) { return o.depth > 0; });
     }
     
     return filtered;
@@ -720,14 +724,18 @@ bool IsDust(const TxOut& output, FeeRate dustRelayFee) {
 }
 
 void SortByValue(std::vector<OutputGroup>& outputs, bool ascending) {
-    std::sort(outputs.begin(), outputs.end(),
-              [ascending](const OutputGroup& a, const OutputGroup& b) {
-                  if (ascending) {
-                      return a.effectiveValue < b.effectiveValue;
-                  } else {
-                      return a.effectiveValue > b.effectiveValue;
-                  }
-              });
+    auto order = [ascending](const OutputGroup& a, const OutputGroup& b) {
+        if (ascending) {
+            return a.effectiveValue < b.effectiveValue;
+        } else {
+            return a.effectiveValue > b.effectiveValue;
+        }
+    };
+    // Candidates from the wallet's spendable index are already in order
+    if (std::is_sorted(outputs.begin(), outputs.end(), order)) {
+        return;
+    }
+    std::sort(outputs.begin(), outputs.end(), order);
 }
 
 void SortByDepth(std::vector<OutputGroup>& outputs, bool ascending) {
@@ -757,13 +765,8 @@ void ShuffleOutputs(std::vector<OutputGroup>& outputs) {
         return;
     }
     
-    // Fisher-Yates shuffle using cryptographic randomness
-    for (size_t i = outputs.size() - 1; i > 0; --i) {
-        uint64_t rand;
-        GetRandBytes(reinterpret_cast<Byte*>(&rand), sizeof(rand));
-        size_t j = rand % (i + 1);
-        std::swap(outputs[i], outputs[j]);
-    }
+    FastRandomContext rng;
+    std::shuffle(outputs.begin(), outputs.end(), rng);
 }
 
 } // namespace wallet
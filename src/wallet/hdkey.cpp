@@ -4,6 +4,7 @@
 
 #include <shurium/wallet/hdkey.h>
 #include <shurium/crypto/sha256.h>
+#include <shurium/crypto/hmac.h>
 #include <shurium/crypto/ripemd160.h>
 #include <shurium/crypto/keys.h>
 #include <shurium/crypto/secp256k1.h>
@@ -42,66 +43,8 @@ std::array<Byte, 64> HMAC_SHA512(const Byte* key, size_t keyLen,
     // Fall through to software implementation on error
 #endif
     
-    // Software fallback: HMAC-SHA512 using double SHA256
-    // This is a reasonable approximation but not cryptographically identical
-    constexpr size_t BLOCK_SIZE = 128;
-    
-    // If key is longer than block size, hash it first
-    std::array<Byte, BLOCK_SIZE> keyBlock{};
-    if (keyLen > BLOCK_SIZE) {
-        // Create 64-byte key from two SHA256 hashes
-        SHA256 sha1, sha2;
-        sha1.Write(key, keyLen);
-        sha2.Write(key, keyLen);
-        sha2.Write(reinterpret_cast<const Byte*>("\x01"), 1);
-        
-        std::array<Byte, 32> h1{}, h2{};
-        sha1.Finalize(h1.data());
-        sha2.Finalize(h2.data());
-        
-        std::memcpy(keyBlock.data(), h1.data(), 32);
-        std::memcpy(keyBlock.data() + 32, h2.data(), 32);
-    } else {
-        std::memcpy(keyBlock.data(), key, keyLen);
-    }
-    
-    // Inner and outer padding
-    std::array<Byte, BLOCK_SIZE> innerPad{};
-    std::array<Byte, BLOCK_SIZE> outerPad{};
-    
-    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
-        innerPad[i] = keyBlock[i] ^ 0x36;
-        outerPad[i] = keyBlock[i] ^ 0x5c;
-    }
-    
-    // Inner hash using two SHA256 instances to approximate SHA512
-    SHA256 innerSha1, innerSha2;
-    innerSha1.Write(innerPad.data(), BLOCK_SIZE);
-    innerSha1.Write(data, dataLen);
-    innerSha2.Write(innerPad.data() + 64, 64);
-    innerSha2.Write(data, dataLen);
-    
-    std::array<Byte, 32> innerHash1{}, innerHash2{};
-    innerSha1.Finalize(innerHash1.data());
-    innerSha2.Finalize(innerHash2.data());
-    
-    // Outer hash
-    SHA256 outerSha1, outerSha2;
-    outerSha1.Write(outerPad.data(), BLOCK_SIZE);
-    outerSha1.Write(innerHash1.data(), 32);
-    outerSha1.Write(innerHash2.data(), 32);
-    
-    outerSha2.Write(outerPad.data() + 64, 64);
-    outerSha2.Write(innerHash1.data(), 32);
-    outerSha2.Write(innerHash2.data(), 32);
-    
-    std::array<Byte, 32> outerHash1{}, outerHash2{};
-    outerSha1.Finalize(outerHash1.data());
-    outerSha2.Finalize(outerHash2.data());
-    
-    std::memcpy(result.data(), outerHash1.data(), 32);
-    std::memcpy(result.data() + 32, outerHash2.data(), 32);
-    
+    // Software fallback
+    HMAC_SHA512_Midstate(key, keyLen).Compute(data, dataLen, result.data());
     return result;
 }
 
@@ -140,17 +83,18 @@ std::array<Byte, 64> PBKDF2_SHA512(const std::string& password,
     saltWithIndex.push_back(0);
     saltWithIndex.push_back(1);  // Block index 1
     
+    // Every U is keyed by the password, so pad it into the midstates once
+    HMAC_SHA512_Midstate hmac(reinterpret_cast<const Byte*>(password.data()),
+                              password.size());
+    
     // U1
-    auto u = HMAC_SHA512(reinterpret_cast<const Byte*>(password.data()),
-                         password.size(),
-                         saltWithIndex.data(), saltWithIndex.size());
+    std::array<Byte, 64> u{};
+    hmac.Compute(saltWithIndex.data(), saltWithIndex.size(), u.data());
     result = u;
     
     // U2 to Uc
     for (uint32_t i = 1; i < iterations; ++i) {
-        u = HMAC_SHA512(reinterpret_cast<const Byte*>(password.data()),
-                        password.size(),
-                        u.data(), u.size());
+        hmac.Compute(u.data(), u.size(), u.data());
         for (size_t j = 0; j < 64; ++j) {
             result[j] ^= u[j];
         }
@@ -284,6 +228,55 @@ bool DerivationPath::operator==(const DerivationPath& other) const {
 // ExtendedKey Implementation
 // ============================================================================
 
+namespace {
+
+/// Size of the HMAC message for child derivation: key material || index
+constexpr size_t CHILD_DATA_SIZE = 37;
+
+/// Big-endian child index at the end of the HMAC message
+void WriteChildIndex(Byte data[CHILD_DATA_SIZE], uint32_t index) {
+    data[33] = (index >> 24) & 0xFF;
+    data[34] = (index >> 16) & 0xFF;
+    data[35] = (index >> 8) & 0xFF;
+    data[36] = index & 0xFF;
+}
+
+/// HMAC message for a child of a private parent: 0x00 || private key for
+/// hardened indices, the compressed public key otherwise, then the index
+void FillPrivateChildData(Byte data[CHILD_DATA_SIZE], uint32_t index,
+                          const Byte* privKey, const PublicKey& pubKey) {
+    if ((index & HARDENED_FLAG) != 0) {
+        data[0] = 0x00;
+        std::memcpy(data + 1, privKey, 32);
+    } else {
+        std::memcpy(data, pubKey.data(), 33);
+    }
+    WriteChildIndex(data, index);
+}
+
+/// HMAC message for a normal (non-hardened) child of a public parent
+void FillPublicChildData(Byte data[CHILD_DATA_SIZE], uint32_t index,
+                         const PublicKey& pubKey) {
+    std::memcpy(data, pubKey.data(), 33);
+    WriteChildIndex(data, index);
+}
+
+/// First 4 bytes of Hash160(pubKey), big endian
+uint32_t FingerprintOf(const PublicKey& pubKey) {
+    auto hash = pubKey.GetHash160();
+    return (static_cast<uint32_t>(hash[0]) << 24) |
+           (static_cast<uint32_t>(hash[1]) << 16) |
+           (static_cast<uint32_t>(hash[2]) << 8) |
+           static_cast<uint32_t>(hash[3]);
+}
+
+void SecureClear(void* ptr, size_t len) {
+    volatile Byte* p = static_cast<volatile Byte*>(ptr);
+    while (len--) *p++ = 0;
+}
+
+} // namespace
+
 ExtendedKey::ExtendedKey(const PrivateKey& key, 
                          const std::array<Byte, CHAIN_CODE_SIZE>& chainCode,
                          uint8_t depth, uint32_t parentFingerprint, 
@@ -295,9 +288,9 @@ ExtendedKey::ExtendedKey(const PrivateKey& key,
     , isPrivate_(true)
     , isValid_(key.IsValid()) {
     
-    keyData_.fill(0);
     if (isValid_) {
-        std::memcpy(keyData_.data(), key.data(), 32);
+        std::memcpy(keyData_.Writable(), key.data(), 32);
+        chainHmac_.emplace(chainCode_);
     }
 }
 
@@ -312,9 +305,9 @@ ExtendedKey::ExtendedKey(const PublicKey& key,
     , isPrivate_(false)
     , isValid_(key.IsValid() && key.IsCompressed()) {
     
-    keyData_.fill(0);
     if (isValid_) {
-        std::memcpy(keyData_.data(), key.data(), 33);
+        std::memcpy(keyData_.Writable(), key.data(), 33);
+        chainHmac_.emplace(chainCode_);
     }
 }
 
@@ -376,30 +369,16 @@ std::optional<ExtendedKey> ExtendedKey::DerivePrivateChild(uint32_t index) const
         return std::nullopt;
     }
     
-    bool hardened = (index & HARDENED_FLAG) != 0;
-    
-    // Data for HMAC
-    std::vector<Byte> data;
-    
-    if (hardened) {
-        // Hardened: 0x00 || private key || index
-        data.push_back(0x00);
-        data.insert(data.end(), keyData_.begin(), keyData_.begin() + 32);
-    } else {
-        // Normal: public key || index
-        auto pubKey = GetPublicKey();
-        data.insert(data.end(), pubKey.data(), pubKey.data() + 33);
-    }
-    
-    // Append index (big endian)
-    data.push_back((index >> 24) & 0xFF);
-    data.push_back((index >> 16) & 0xFF);
-    data.push_back((index >> 8) & 0xFF);
-    data.push_back(index & 0xFF);
+    // The public key goes into the HMAC for normal children and into the
+    // child's parent fingerprint either way, so compute it only once
+    PublicKey pubKey = GetPublicKey();
     
-    // HMAC-SHA512
-    auto hash = HMAC_SHA512(chainCode_.data(), chainCode_.size(),
-                            data.data(), data.size());
+    // HMAC-SHA512(chainCode, data)
+    Byte data[CHILD_DATA_SIZE];
+    FillPrivateChildData(data, index, keyData_.data(), pubKey);
+    std::array<Byte, 64> hash{};
+    chainHmac_->Compute(data, sizeof(data), hash.data());
+    SecureClear(data, sizeof(data));
     
     // Left 32 bytes = IL (tweak for private key)
     // Right 32 bytes = new chain code
@@ -408,18 +387,20 @@ std::optional<ExtendedKey> ExtendedKey::DerivePrivateChild(uint32_t index) const
     
     std::array<Byte, CHAIN_CODE_SIZE> newChainCode{};
     std::memcpy(newChainCode.data(), hash.data() + 32, 32);
+    SecureClear(hash.data(), hash.size());
     
     // Parse parent private key
     PrivateKey parentKey(keyData_.data(), true);
     
     // Child key = IL + parent key (mod n)
     auto childKey = parentKey.TweakAdd(tweak);
+    SecureClear(tweak.data(), tweak.size());
     if (!childKey) {
         return std::nullopt;  // Invalid key produced
     }
     
     return ExtendedKey(*childKey, newChainCode, depth_ + 1, 
-                       GetFingerprint(), index);
+                       FingerprintOf(pubKey), index);
 }
 
 std::optional<ExtendedKey> ExtendedKey::DerivePublicChild(uint32_t index) const {
@@ -439,15 +420,12 @@ std::optional<ExtendedKey> ExtendedKey::DerivePublicChild(uint32_t index) const
     }
     
     // Data: compressed public key (33 bytes) || index (4 bytes big-endian)
-    std::vector<Byte> data(keyData_.begin(), keyData_.begin() + 33);
-    data.push_back((index >> 24) & 0xFF);
-    data.push_back((index >> 16) & 0xFF);
-    data.push_back((index >> 8) & 0xFF);
-    data.push_back(index & 0xFF);
+    Byte data[CHILD_DATA_SIZE];
+    FillPublicChildData(data, index, parentPubKey);
     
     // Compute I = HMAC-SHA512(chainCode, data)
-    auto hash = HMAC_SHA512(chainCode_.data(), chainCode_.size(),
-                            data.data(), data.size());
+    std::array<Byte, 64> hash{};
+    chainHmac_->Compute(data, sizeof(data), hash.data());
     
     // Split I into IL (first 32 bytes) and IR (last 32 bytes)
     // IL is the tweak, IR is the new chain code
@@ -479,7 +457,97 @@ std::optional<ExtendedKey> ExtendedKey::DerivePublicChild(uint32_t index) const
     }
     
     return ExtendedKey(childPubKey, newChainCode, depth_ + 1,
-                       GetFingerprint(), index);
+                       FingerprintOf(parentPubKey), index);
+}
+
+std::vector<std::optional<ExtendedKey>> ExtendedKey::DeriveChildren(uint32_t first,
+                                                                    uint32_t count) const {
+    // Indices past 2^32 - 1 do not exist
+    count = static_cast<uint32_t>(
+        std::min<uint64_t>(count, (uint64_t{1} << 32) - first));
+    std::vector<std::optional<ExtendedKey>> children(count);
+    if (!isValid_ || count == 0) {
+        return children;
+    }
+    
+    PublicKey parentPubKey = GetPublicKey();
+    if (!parentPubKey.IsValid()) {
+        return children;
+    }
+    uint32_t fingerprint = FingerprintOf(parentPubKey);
+    
+    Byte data[CHILD_DATA_SIZE];
+    std::array<Byte, 64> hash{};
+    
+    if (isPrivate_) {
+        PrivateKey parentKey(keyData_.data(), true);
+        Hash256 tweak;
+        std::array<Byte, CHAIN_CODE_SIZE> newChainCode{};
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t index = first + i;
+            FillPrivateChildData(data, index, keyData_.data(), parentPubKey);
+            chainHmac_->Compute(data, sizeof(data), hash.data());
+            std::memcpy(tweak.data(), hash.data(), 32);
+            std::memcpy(newChainCode.data(), hash.data() + 32, 32);
+            
+            auto childKey = parentKey.TweakAdd(tweak);
+            if (childKey) {
+                children[i].emplace(*childKey, newChainCode, depth_ + 1, fingerprint, index);
+            }
+        }
+        SecureClear(data, sizeof(data));
+        SecureClear(hash.data(), hash.size());
+        SecureClear(tweak.data(), tweak.size());
+        SecureClear(newChainCode.data(), newChainCode.size());
+        return children;
+    }
+    
+    // Public parent: hash every normal index, then add all the IL*G to the
+    // parent key in one batch that shares a single field inversion.
+    // Hardened indices stay nullopt, as in DerivePublicChild.
+    std::vector<uint32_t> slots;
+    std::vector<Byte> tweaks;
+    std::vector<std::array<Byte, CHAIN_CODE_SIZE>> chainCodes;
+    slots.reserve(count);
+    tweaks.reserve(32 * static_cast<size_t>(count));
+    chainCodes.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = first + i;
+        if ((index & HARDENED_FLAG) != 0) {
+            continue;
+        }
+        FillPublicChildData(data, index, parentPubKey);
+        chainHmac_->Compute(data, sizeof(data), hash.data());
+        slots.push_back(i);
+        tweaks.insert(tweaks.end(), hash.begin(), hash.begin() + 32);
+        chainCodes.emplace_back();
+        std::memcpy(chainCodes.back().data(), hash.data() + 32, 32);
+    }
+    if (slots.empty()) {
+        return children;
+    }
+    
+    // PublicKeyTweakAddBatch flags IL >= n and the point at infinity, the
+    // two cases where BIP32 says to skip the index
+    std::vector<Byte> childKeys(33 * slots.size());
+    std::unique_ptr<bool[]> valid(new bool[slots.size()]);
+    if (!secp256k1::PublicKeyTweakAddBatch(parentPubKey.data(), parentPubKey.size(),
+                                           tweaks.data(), slots.size(),
+                                           childKeys.data(), valid.get())) {
+        return children;
+    }
+    
+    for (size_t j = 0; j < slots.size(); ++j) {
+        if (!valid[j]) {
+            continue;
+        }
+        PublicKey childPubKey(childKeys.data() + 33 * j, 33);
+        if (childPubKey.IsValid()) {
+            children[slots[j]].emplace(childPubKey, chainCodes[j], depth_ + 1,
+                                       fingerprint, first + slots[j]);
+        }
+    }
+    return children;
 }
 
 std::optional<PrivateKey> ExtendedKey::GetPrivateKey() const {
@@ -507,13 +575,7 @@ uint32_t ExtendedKey::GetFingerprint() const {
         return 0;
     }
     
-    auto pubKey = GetPublicKey();
-    auto hash = pubKey.GetHash160();
-    
-    return (static_cast<uint32_t>(hash[0]) << 24) |
-           (static_cast<uint32_t>(hash[1]) << 16) |
-           (static_cast<uint32_t>(hash[2]) << 8) |
-           static_cast<uint32_t>(hash[3]);
+    return FingerprintOf(GetPublicKey());
 }
 
 ExtendedKey ExtendedKey::Neuter() const {
@@ -921,7 +983,7 @@ std::string Mnemonic::Generate(Strength strength) {
     size_t entropyBytes = entropyBits / 8;
     
     std::vector<Byte> entropy(entropyBytes);
-    GetRandBytes(entropy.data(), entropyBytes);
+    GetStrongRandBytes(entropy.data(), entropyBytes);
     
     return FromEntropy(entropy.data(), entropyBytes);
 }
@@ -1130,6 +1192,116 @@ std::optional<HDKeyManager::KeyInfo> HDKeyManager::DeriveKey(uint32_t account,
     return info;
 }
 
+std::vector<HDKeyManager::KeyInfo> HDKeyManager::DeriveKeys(uint32_t account,
+                                                            uint32_t change,
+                                                            uint32_t first,
+                                                            uint32_t count) {
+    auto chainKey = GetChainKey(account, change);
+    if (!chainKey) {
+        return {};
+    }
+    
+    auto result = DeriveChildKeys(*chainKey, account, change, first, count);
+    for (const auto& info : result) {
+        keysByHash_[info.keyHash] = info;
+    }
+    return result;
+}
+
+std::optional<ExtendedKey> HDKeyManager::GetChainKey(uint32_t account, uint32_t change) const {
+    return masterKey_.DerivePath(DerivationPath::BIP44(account, change, 0).Parent());
+}
+
+std::vector<HDKeyManager::KeyInfo> HDKeyManager::DeriveChildKeys(const ExtendedKey& chainKey,
+                                                                 uint32_t account,
+                                                                 uint32_t change,
+                                                                 uint32_t first,
+                                                                 uint32_t count) {
+    std::vector<KeyInfo> result;
+    auto children = chainKey.DeriveChildren(first, count);
+    result.reserve(children.size());
+    std::vector<Byte> encodings;
+    encodings.reserve(children.size() * PublicKey::COMPRESSED_SIZE);
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (!children[i]) {
+            continue;
+        }
+        KeyInfo info;
+        info.publicKey = children[i]->GetPublicKey();
+        if (!info.publicKey.IsCompressed()) {
+            continue;
+        }
+        info.index = first + static_cast<uint32_t>(i);
+        info.path = DerivationPath::BIP44(account, change, info.index);
+        info.account = account;
+        info.change = change;
+        info.used = false;
+        encodings.insert(encodings.end(), info.publicKey.data(),
+                         info.publicKey.data() + PublicKey::COMPRESSED_SIZE);
+        result.push_back(std::move(info));
+    }
+    
+    std::vector<Byte> hashes(result.size() * RIPEMD160::OUTPUT_SIZE);
+    Hash160_33(hashes.data(), encodings.data(), result.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+        std::memcpy(result[i].keyHash.data(), hashes.data() + i * RIPEMD160::OUTPUT_SIZE,
+                    RIPEMD160::OUTPUT_SIZE);
+    }
+    
+    return result;
+}
+
+void HDKeyManager::AddPoolKeys(const std::vector<KeyInfo>& keys) {
+    for (const auto& info : keys) {
+        // Indices that fail to derive are skipped, so a key may jump ahead
+        if (info.index < GetPoolEnd(info.account, info.change)) {
+            continue;
+        }
+        auto& pool = pool_[{info.account, info.change}];
+        if (pool.empty() && info.index != GetNextIndex(info.account, info.change)) {
+            continue;
+        }
+        keysByHash_[info.keyHash] = info;
+        pool.push_back(info);
+    }
+}
+
+size_t HDKeyManager::GetPoolSize(uint32_t account, uint32_t change) const {
+    auto it = pool_.find({account, change});
+    return it != pool_.end() ? it->second.size() : 0;
+}
+
+uint32_t HDKeyManager::GetPoolEnd(uint32_t account, uint32_t change) const {
+    auto it = pool_.find({account, change});
+    if (it != pool_.end() && !it->second.empty()) {
+        return it->second.back().index + 1;
+    }
+    return GetNextIndex(account, change);
+}
+
+std::vector<HDKeyManager::KeyInfo> HDKeyManager::GetPoolKeys() const {
+    std::vector<KeyInfo> result;
+    for (const auto& [chain, pool] : pool_) {
+        result.insert(result.end(), pool.begin(), pool.end());
+    }
+    return result;
+}
+
+void HDKeyManager::TrimPool(uint32_t account, uint32_t change) {
+    auto it = pool_.find({account, change});
+    if (it == pool_.end()) {
+        return;
+    }
+    uint32_t next = GetNextIndex(account, change);
+    auto& pool = it->second;
+    while (!pool.empty() && pool.front().index < next) {
+        pool.pop_front();
+    }
+    if (!pool.empty() && pool.front().index != next) {
+        pool.clear();
+    }
+}
+
 std::optional<HDKeyManager::KeyInfo> HDKeyManager::GetKeyAtPath(const DerivationPath& path) {
     auto key = masterKey_.DerivePath(path);
     if (!key) {
@@ -1238,9 +1410,24 @@ uint32_t HDKeyManager::GetNextChangeIndex(uint32_t account) const {
     return (it != nextIndices_.end()) ? it->second : 0;
 }
 
+uint32_t HDKeyManager::GetNextIndex(uint32_t account, uint32_t change) const {
+    auto it = nextIndices_.find({account, change});
+    return (it != nextIndices_.end()) ? it->second : 0;
+}
+
 HDKeyManager::KeyInfo HDKeyManager::DeriveAndCache(uint32_t account, 
                                                     uint32_t change, 
                                                     uint32_t index) {
+    // The pool front, if any, is the key at index
+    auto pooled = pool_.find({account, change});
+    if (pooled != pool_.end() && !pooled->second.empty() &&
+        pooled->second.front().index == index) {
+        KeyInfo info = std::move(pooled->second.front());
+        pooled->second.pop_front();
+        nextIndices_[{account, change}] = index + 1;
+        return info;
+    }
+    
     auto info = DeriveKey(account, change, index);
     if (!info) {
         // Return empty info on failure
@@ -1249,6 +1436,7 @@ HDKeyManager::KeyInfo HDKeyManager::DeriveAndCache(uint32_t account,
     
     // Update next index
     nextIndices_[{account, change}] = index + 1;
+    TrimPool(account, change);
     
     return *info;
 }
@@ -1259,16 +1447,14 @@ void HDKeyManager::SetAllIndices(const std::map<std::pair<uint32_t, uint32_t>, u
     // Regenerate key cache for all previously derived keys
     // This ensures GetAllKeys() returns the correct keys after wallet reload
     keysByHash_.clear();
+    pool_.clear();
     
     for (const auto& [key, nextIndex] : indices) {
         uint32_t account = key.first;
         uint32_t change = key.second;
         
-        // Derive all keys from 0 to nextIndex-1
-        for (uint32_t i = 0; i < nextIndex; ++i) {
-            auto info = DeriveKey(account, change, i);
-            // DeriveKey already adds to keysByHash_
-        }
+        // Derive all keys from 0 to nextIndex-1 (DeriveKeys adds them to keysByHash_)
+        DeriveKeys(account, change, 0, nextIndex);
     }
 }
 
@@ -7,6 +7,7 @@
 #include <shurium/core/random.h>
 #include <shurium/core/serialize.h>
 #include <shurium/util/fs.h>
+#include <shurium/util/threadpool.h>
 
 #include <algorithm>
 #include <cstring>
@@ -46,7 +47,8 @@ std::array<Byte, AES_KEY_SIZE> CryptoEngine::DeriveKey(
     std::array<Byte, AES_KEY_SIZE> key{};
     
 #ifdef SHURIUM_USE_OPENSSL
-    // Use Argon2id via OpenSSL 3.x KDF
+#if defined(OSSL_KDF_PARAM_ARGON2_LANES)
+    // Use Argon2id via OpenSSL 3.2+ KDF
     EVP_KDF* kdf = EVP_KDF_fetch(nullptr, "ARGON2ID", nullptr);
     if (kdf) {
         EVP_KDF_CTX* ctx = EVP_KDF_CTX_new(kdf);
@@ -79,6 +81,7 @@ std::array<Byte, AES_KEY_SIZE> CryptoEngine::DeriveKey(
         }
         EVP_KDF_free(kdf);
     }
+#endif
     
     // Fallback to PBKDF2 if Argon2id is not available
     if (PKCS5_PBKDF2_HMAC(
@@ -446,6 +449,10 @@ MemoryKeyStore::MemoryKeyStore(const std::string& password) {
     SetupEncryption(password);
 }
 
+MemoryKeyStore::~MemoryKeyStore() {
+    StopKeyPoolRefill();
+}
+
 bool MemoryKeyStore::SetupEncryption(const std::string& password) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -488,6 +495,7 @@ bool MemoryKeyStore::SetupEncryption(const std::string& password) {
     
     encrypted_ = true;
     unlocked_ = true;
+    SealKeyPool();
     
     return true;
 }
@@ -510,12 +518,14 @@ void MemoryKeyStore::Lock() {
     }
     
     // Clear decrypted data
-    unlockedKeys_.clear();
+    ClearDecryptedKeys();
     masterKey_.reset();
     hdKeyManager_.reset();
+    ++hdEpoch_;
     unlockedIdentity_.reset();
     
     unlocked_ = false;
+    KeysChanged();
 }
 
 bool MemoryKeyStore::Unlock(const std::string& password) {
@@ -579,12 +589,29 @@ bool MemoryKeyStore::Unlock(const std::string& password) {
     masterKey_ = std::make_unique<SecureArray<Byte, AES_KEY_SIZE>>();
     std::memcpy(masterKey_->data(), key.data(), AES_KEY_SIZE);
     
-    // Decrypt all keys
-    for (const auto& [hash, encrypted] : encryptedKeys_) {
-        auto decrypted = DecryptKey(encrypted, key);
-        if (decrypted) {
-            unlockedKeys_[hash] = std::move(*decrypted);
+    // Decrypt the individual keys; Lazy leaves them to first use
+    if (unlockMode_ == KeyUnlockMode::Eager) {
+        for (const auto& [hash, encrypted] : encryptedKeys_) {
+            auto decrypted = DecryptKey(encrypted, key);
+            if (decrypted) {
+                unlockedKeys_[hash] = std::move(*decrypted);
+            }
+        }
+    } else if (unlockMode_ == KeyUnlockMode::EagerParallel && !encryptedKeys_.empty()) {
+        std::vector<const EncryptedKey*> entries;
+        entries.reserve(encryptedKeys_.size());
+        arenaHashes_.reserve(encryptedKeys_.size());
+        for (const auto& [hash, encrypted] : encryptedKeys_) {
+            arenaHashes_.push_back(hash);
+            entries.push_back(&encrypted);
         }
+        keyArena_.resize(entries.size());
+        util::ParallelForIndex(0, entries.size(), [&](size_t i) {
+            auto decrypted = DecryptKey(*entries[i], key);
+            if (decrypted) {
+                keyArena_[i] = std::move(*decrypted);
+            }
+        }, unlockPool_ ? *unlockPool_ : util::GetGlobalThreadPool());
     }
     
     // Decrypt master seed and initialize HD key manager
@@ -599,11 +626,13 @@ bool MemoryKeyStore::Unlock(const std::string& password) {
             HDKeyManager::Config hdConfig;
             hdConfig.testnet = testnet_;
             hdKeyManager_ = std::make_unique<HDKeyManager>(masterKey, hdConfig);
+            ++hdEpoch_;
             
             // Restore HD key indices from persisted storage
             if (!hdKeyIndices_.empty()) {
                 hdKeyManager_->SetAllIndices(hdKeyIndices_);
             }
+            RestoreKeyPool();
             
             // Secure clear
             CryptoEngine::SecureZero(seed.data(), seed.size());
@@ -612,6 +641,8 @@ bool MemoryKeyStore::Unlock(const std::string& password) {
     }
     
     unlocked_ = true;
+    KeysChanged();
+    CheckKeyPool();
     return true;
 }
 
@@ -697,6 +728,7 @@ bool MemoryKeyStore::ChangePassword(const std::string& oldPassword,
     // Update master key
     masterKey_ = std::make_unique<SecureArray<Byte, AES_KEY_SIZE>>();
     std::memcpy(masterKey_->data(), newKey.data(), AES_KEY_SIZE);
+    SealKeyPool();
     
     return true;
 }
@@ -723,9 +755,14 @@ bool MemoryKeyStore::AddKey(const PrivateKey& key, const std::string& label) {
         
         auto encrypted = EncryptKey(key, encKey, label);
         encryptedKeys_[keyHash] = encrypted;
+        CryptoEngine::SecureZero(encKey.data(), encKey.size());
         
         if (unlocked_) {
-            unlockedKeys_[keyHash] = key;
+            if (unlockMode_ == KeyUnlockMode::Lazy) {
+                CacheKeyLocked(keyHash, key);
+            } else {
+                unlockedKeys_[keyHash] = key;
+            }
         }
     } else if (!encrypted_) {
         // Store unencrypted (not recommended)
@@ -735,6 +772,7 @@ bool MemoryKeyStore::AddKey(const PrivateKey& key, const std::string& label) {
     }
     
     publicKeys_[keyHash] = pubKey;
+    KeysChanged();
     return true;
 }
 
@@ -748,6 +786,7 @@ bool MemoryKeyStore::AddWatchOnly(const PublicKey& pubkey, const std::string& la
     auto keyHash = pubkey.GetHash160();
     watchOnlyKeys_.insert(keyHash);
     publicKeys_[keyHash] = pubkey;
+    KeysChanged();
     
     return true;
 }
@@ -766,6 +805,10 @@ std::optional<PrivateKey> MemoryKeyStore::GetKey(const Hash160& keyHash) const {
         return it->second;
     }
     
+    if (auto key = FindEncryptedKeyLocked(keyHash)) {
+        return key;
+    }
+    
     // Try HD key manager
     if (hdKeyManager_) {
         auto info = hdKeyManager_->FindKeyByHash(keyHash);
@@ -889,14 +932,18 @@ void MemoryKeyStore::SetTestnet(bool testnet) {
         HDKeyManager::Config hdConfig;
         hdConfig.testnet = testnet_;
         hdKeyManager_ = std::make_unique<HDKeyManager>(masterKey, hdConfig);
+        ++hdEpoch_;
         
         // Restore HD key indices from persisted storage
         if (!hdKeyIndices_.empty()) {
             hdKeyManager_->SetAllIndices(hdKeyIndices_);
         }
+        RestoreKeyPool();
         
         unlocked_ = true;
         needsDeferredHDInit_ = false;
+        KeysChanged();
+        CheckKeyPool();
     }
 }
 
@@ -908,11 +955,14 @@ bool MemoryKeyStore::SetMasterSeed(const std::array<Byte, BIP39_SEED_SIZE>& seed
     HDKeyManager::Config hdConfig;
     hdConfig.testnet = testnet_;
     hdKeyManager_ = std::make_unique<HDKeyManager>(masterKey, hdConfig);
+    ++hdEpoch_;
     
-    // Restore HD key indices if any were persisted
+    // Restore HD key indices if any were persisted; a pool sealed for
+    // another seed would not match
     if (!hdKeyIndices_.empty()) {
         hdKeyManager_->SetAllIndices(hdKeyIndices_);
     }
+    keypoolCiphertext_.clear();
     
     // Compute mnemonic checksum
     encryptedSeed_.mnemonicChecksum = SHA256Hash(seed.data(), seed.size());
@@ -940,6 +990,8 @@ bool MemoryKeyStore::SetMasterSeed(const std::array<Byte, BIP39_SEED_SIZE>& seed
         encryptedSeed_.ciphertext = std::vector<Byte>(seed.begin(), seed.end());
         unencryptedSeed_ = seed;
     }
+    KeysChanged();
+    CheckKeyPool();
     
     return true;
 }
@@ -960,6 +1012,14 @@ const HDKeyManager* MemoryKeyStore::GetHDKeyManager() const {
     return hdKeyManager_.get();
 }
 
+std::optional<HDKeyManager::KeyInfo> MemoryKeyStore::FindHDKey(const Hash160& keyHash) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!hdKeyManager_) {
+        return std::nullopt;
+    }
+    return hdKeyManager_->FindKeyByHash(keyHash);
+}
+
 std::optional<PublicKey> MemoryKeyStore::DeriveNextReceiving(uint32_t account) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -967,11 +1027,17 @@ std::optional<PublicKey> MemoryKeyStore::DeriveNextReceiving(uint32_t account) {
         return std::nullopt;
     }
     
+    // A pooled key is already in the key set
+    bool pooled = hdKeyManager_->GetPoolSize(account, 0) > 0;
     auto info = hdKeyManager_->DeriveNextReceiving(account);
     publicKeys_[info.keyHash] = info.publicKey;
     
     // Update persisted indices
     hdKeyIndices_ = hdKeyManager_->GetAllIndices();
+    if (!pooled) {
+        KeysChanged();
+    }
+    CheckKeyPool();
     
     return info.publicKey;
 }
@@ -983,15 +1049,256 @@ std::optional<PublicKey> MemoryKeyStore::DeriveNextChange(uint32_t account) {
         return std::nullopt;
     }
     
+    // A pooled key is already in the key set
+    bool pooled = hdKeyManager_->GetPoolSize(account, 1) > 0;
     auto info = hdKeyManager_->DeriveNextChange(account);
     publicKeys_[info.keyHash] = info.publicKey;
     
     // Update persisted indices
     hdKeyIndices_ = hdKeyManager_->GetAllIndices();
+    if (!pooled) {
+        KeysChanged();
+    }
+    CheckKeyPool();
     
     return info.publicKey;
 }
 
+std::map<std::pair<uint32_t, uint32_t>, uint32_t> MemoryKeyStore::GetHDKeyIndices() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hdKeyIndices_;
+}
+
+void MemoryKeyStore::AdvanceHDKeyIndices(
+    const std::map<std::pair<uint32_t, uint32_t>, uint32_t>& indices) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    bool changed = false;
+    for (const auto& [chain, next] : indices) {
+        auto it = hdKeyIndices_.find(chain);
+        if (it != hdKeyIndices_.end() && it->second >= next) {
+            continue;
+        }
+        if (hdKeyManager_) {
+            uint32_t from = hdKeyManager_->GetNextIndex(chain.first, chain.second);
+            if (next > from) {
+                hdKeyManager_->DeriveKeys(chain.first, chain.second, from, next - from);
+                hdKeyManager_->SetNextIndex(chain.first, chain.second, next);
+            }
+        }
+        hdKeyIndices_[chain] = next;
+        changed = true;
+    }
+    if (changed) {
+        KeysChanged();
+    }
+}
+
+void MemoryKeyStore::SetKeyPoolSize(uint32_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keypoolSize_ = size;
+    CheckKeyPool();
+}
+
+uint32_t MemoryKeyStore::GetKeyPoolSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keypoolSize_;
+}
+
+size_t MemoryKeyStore::GetKeyPoolAvailable(uint32_t change) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hdKeyManager_ ? hdKeyManager_->GetPoolSize(0, change) : 0;
+}
+
+size_t MemoryKeyStore::TopUpKeyPool() {
+    size_t added = 0;
+    for (uint32_t change : {0u, 1u}) {
+        while (true) {
+            // Take what a batch needs under the lock, derive without it
+            std::optional<ExtendedKey> chainKey;
+            uint64_t epoch;
+            uint32_t first;
+            uint32_t count;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!hdKeyManager_ || refillStop_) {
+                    return added;
+                }
+                size_t pooled = hdKeyManager_->GetPoolSize(0, change);
+                if (pooled >= keypoolSize_) {
+                    break;
+                }
+                count = std::min<uint32_t>(keypoolSize_ - static_cast<uint32_t>(pooled),
+                                           KEYPOOL_BATCH_SIZE);
+                first = hdKeyManager_->GetPoolEnd(0, change);
+                chainKey = hdKeyManager_->GetChainKey(0, change);
+                epoch = hdEpoch_;
+            }
+            if (!chainKey) {
+                return added;
+            }
+            
+            auto keys = HDKeyManager::DeriveChildKeys(chainKey->Neuter(), 0, change, first, count);
+            
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!hdKeyManager_ || hdEpoch_ != epoch) {
+                return added;
+            }
+            size_t before = hdKeyManager_->GetPoolSize(0, change);
+            hdKeyManager_->AddPoolKeys(keys);
+            size_t after = hdKeyManager_->GetPoolSize(0, change);
+            if (after <= before) {
+                break;  // Raced with a derivation; the next wake-up retries
+            }
+            added += after - before;
+            SealKeyPool();
+            KeysChanged();
+        }
+    }
+    return added;
+}
+
+void MemoryKeyStore::StartKeyPoolRefill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (refillThread_.joinable()) {
+        return;
+    }
+    refillStop_ = false;
+    refillWanted_ = true;
+    refillThread_ = std::thread([this]() { KeyPoolRefillThread(); });
+}
+
+void MemoryKeyStore::StopKeyPoolRefill() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refillStop_ = true;
+    }
+    refillCv_.notify_all();
+    if (refillThread_.joinable()) {
+        refillThread_.join();
+    }
+}
+
+void MemoryKeyStore::KeyPoolRefillThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        refillCv_.wait(lock, [this]() { return refillStop_ || refillWanted_; });
+        if (refillStop_) {
+            return;
+        }
+        refillWanted_ = false;
+        lock.unlock();
+        TopUpKeyPool();
+        lock.lock();
+    }
+}
+
+void MemoryKeyStore::WakeKeyPoolRefill() {
+    refillWanted_ = true;
+    refillCv_.notify_one();
+}
+
+void MemoryKeyStore::CheckKeyPool() {
+    if (!hdKeyManager_ || keypoolSize_ == 0) {
+        return;
+    }
+    for (uint32_t change : {0u, 1u}) {
+        if (hdKeyManager_->GetPoolSize(0, change) * 2 <= keypoolSize_) {
+            WakeKeyPoolRefill();
+            return;
+        }
+    }
+}
+
+void MemoryKeyStore::SealKeyPool() {
+    keypoolCiphertext_.clear();
+    keypoolNonce_ = {};
+    if (!hdKeyManager_) {
+        return;
+    }
+    auto keys = hdKeyManager_->GetPoolKeys();
+    if (keys.empty()) {
+        return;
+    }
+    
+    // Per key: account, change and index (4 bytes each), compressed public key
+    std::vector<Byte> plaintext;
+    plaintext.reserve(keys.size() * (12 + PublicKey::COMPRESSED_SIZE));
+    for (const auto& info : keys) {
+        for (uint32_t value : {info.account, info.change, info.index}) {
+            plaintext.push_back((value >> 24) & 0xFF);
+            plaintext.push_back((value >> 16) & 0xFF);
+            plaintext.push_back((value >> 8) & 0xFF);
+            plaintext.push_back(value & 0xFF);
+        }
+        plaintext.insert(plaintext.end(), info.publicKey.data(),
+                         info.publicKey.data() + PublicKey::COMPRESSED_SIZE);
+    }
+    
+    if (!encrypted_) {
+        keypoolCiphertext_ = std::move(plaintext);
+        return;
+    }
+    if (!masterKey_) {
+        return;
+    }
+    std::array<Byte, AES_KEY_SIZE> key;
+    std::memcpy(key.data(), masterKey_->data(), AES_KEY_SIZE);
+    keypoolNonce_ = CryptoEngine::GenerateNonce();
+    keypoolCiphertext_ = CryptoEngine::Encrypt(key, keypoolNonce_, plaintext);
+    CryptoEngine::SecureZero(key.data(), key.size());
+}
+
+void MemoryKeyStore::RestoreKeyPool() {
+    if (!hdKeyManager_ || keypoolCiphertext_.empty()) {
+        return;
+    }
+    
+    std::vector<Byte> plaintext;
+    bool clear = std::all_of(keypoolNonce_.begin(), keypoolNonce_.end(),
+                             [](Byte b) { return b == 0; });
+    if (clear) {
+        plaintext = keypoolCiphertext_;
+    } else {
+        if (!masterKey_) {
+            return;
+        }
+        std::array<Byte, AES_KEY_SIZE> key;
+        std::memcpy(key.data(), masterKey_->data(), AES_KEY_SIZE);
+        auto decrypted = CryptoEngine::Decrypt(key, keypoolNonce_, keypoolCiphertext_);
+        CryptoEngine::SecureZero(key.data(), key.size());
+        if (!decrypted) {
+            return;
+        }
+        plaintext = std::move(*decrypted);
+    }
+    
+    constexpr size_t ENTRY_SIZE = 12 + PublicKey::COMPRESSED_SIZE;
+    std::vector<HDKeyManager::KeyInfo> keys;
+    keys.reserve(plaintext.size() / ENTRY_SIZE);
+    for (size_t offset = 0; offset + ENTRY_SIZE <= plaintext.size(); offset += ENTRY_SIZE) {
+        const Byte* entry = plaintext.data() + offset;
+        auto read32 = [entry](size_t at) {
+            return (static_cast<uint32_t>(entry[at]) << 24) |
+                   (static_cast<uint32_t>(entry[at + 1]) << 16) |
+                   (static_cast<uint32_t>(entry[at + 2]) << 8) |
+                   static_cast<uint32_t>(entry[at + 3]);
+        };
+        HDKeyManager::KeyInfo info;
+        info.account = read32(0);
+        info.change = read32(4);
+        info.index = read32(8);
+        info.publicKey = PublicKey(entry + 12, PublicKey::COMPRESSED_SIZE);
+        if (!info.publicKey.IsValid()) {
+            continue;
+        }
+        info.keyHash = info.publicKey.GetHash160();
+        info.path = DerivationPath::BIP44(info.account, info.change, info.index);
+        keys.push_back(std::move(info));
+    }
+    hdKeyManager_->AddPoolKeys(keys);
+}
+
 bool MemoryKeyStore::SetIdentitySecrets(const identity::IdentitySecrets& secrets) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -1038,7 +1345,8 @@ Hash256 MemoryKeyStore::GetIdentityCommitment() const {
 
 size_t MemoryKeyStore::KeyCount() const {
     std::lock_guard<std::mutex> lock(mutex_);
-    return encryptedKeys_.size() + unlockedKeys_.size();
+    // An encrypted store holds every key encrypted, whatever is decrypted
+    return encrypted_ ? encryptedKeys_.size() : unlockedKeys_.size();
 }
 
 size_t MemoryKeyStore::WatchOnlyCount() const {
@@ -1067,6 +1375,99 @@ EncryptedKey MemoryKeyStore::EncryptKey(const PrivateKey& key,
     return result;
 }
 
+void MemoryKeyStore::SetUnlockMode(KeyUnlockMode mode, size_t cacheSize,
+                                   util::ThreadPool* pool) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unlockMode_ = mode;
+    keyCacheSize_ = cacheSize;
+    unlockPool_ = pool;
+    
+    // Keys already decrypted stay until Lock(); only the cache is trimmed
+    while (keyCache_.size() > (mode == KeyUnlockMode::Lazy ? keyCacheSize_ : 0)) {
+        keyCacheIndex_.erase(keyCache_.back().first);
+        keyCache_.pop_back();
+    }
+}
+
+KeyUnlockMode MemoryKeyStore::GetUnlockMode() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return unlockMode_;
+}
+
+size_t MemoryKeyStore::DecryptedKeyCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = unlockedKeys_.size() + keyCache_.size();
+    for (const auto& key : keyArena_) {
+        count += key.IsValid();
+    }
+    return count;
+}
+
+void MemoryKeyStore::ClearDecryptedKeys() {
+    unlockedKeys_.clear();
+    keyArena_.clear();
+    arenaHashes_.clear();
+    keyCacheIndex_.clear();
+    keyCache_.clear();
+}
+
+std::optional<PrivateKey> MemoryKeyStore::FindEncryptedKeyLocked(const Hash160& keyHash) const {
+    if (!encrypted_ || !unlocked_ || !masterKey_) {
+        return std::nullopt;
+    }
+    
+    if (!keyArena_.empty()) {
+        auto pos = std::lower_bound(arenaHashes_.begin(), arenaHashes_.end(), keyHash);
+        if (pos != arenaHashes_.end() && *pos == keyHash) {
+            const PrivateKey& key = keyArena_[pos - arenaHashes_.begin()];
+            if (key.IsValid()) {
+                return key;
+            }
+        }
+    }
+    
+    auto cached = keyCacheIndex_.find(keyHash);
+    if (cached != keyCacheIndex_.end()) {
+        keyCache_.splice(keyCache_.begin(), keyCache_, cached->second);
+        return cached->second->second;
+    }
+    
+    auto it = encryptedKeys_.find(keyHash);
+    if (it == encryptedKeys_.end()) {
+        return std::nullopt;
+    }
+    
+    std::array<Byte, AES_KEY_SIZE> encKey;
+    std::memcpy(encKey.data(), masterKey_->data(), AES_KEY_SIZE);
+    auto decrypted = DecryptKey(it->second, encKey);
+    CryptoEngine::SecureZero(encKey.data(), encKey.size());
+    
+    if (decrypted && unlockMode_ == KeyUnlockMode::Lazy) {
+        CacheKeyLocked(keyHash, *decrypted);
+    }
+    return decrypted;
+}
+
+void MemoryKeyStore::CacheKeyLocked(const Hash160& keyHash, const PrivateKey& key) const {
+    if (keyCacheSize_ == 0) {
+        return;
+    }
+    
+    auto cached = keyCacheIndex_.find(keyHash);
+    if (cached != keyCacheIndex_.end()) {
+        keyCache_.splice(keyCache_.begin(), keyCache_, cached->second);
+        cached->second->second = key;
+        return;
+    }
+    
+    keyCache_.emplace_front(keyHash, key);
+    keyCacheIndex_[keyHash] = keyCache_.begin();
+    while (keyCache_.size() > keyCacheSize_) {
+        keyCacheIndex_.erase(keyCache_.back().first);
+        keyCache_.pop_back();
+    }
+}
+
 std::optional<PrivateKey> MemoryKeyStore::DecryptKey(const EncryptedKey& encrypted,
                                                       const std::array<Byte, AES_KEY_SIZE>& encKey) const {
     auto plaintext = CryptoEngine::Decrypt(encKey, encrypted.nonce, encrypted.ciphertext);
@@ -1168,7 +1569,9 @@ bool FileKeyStore::Load(const std::string& path) {
     std::vector<Byte> data((std::istreambuf_iterator<char>(file)),
                             std::istreambuf_iterator<char>());
     
-    if (!Deserialize(data)) {
+    bool loaded = Deserialize(data);
+    KeysChanged();
+    if (!loaded) {
         return false;
     }
     
@@ -1212,6 +1615,16 @@ std::vector<Byte> FileKeyStore::Serialize() const {
     if (encryptedIdentity_.IsValid()) flags |= 0x04;
     if (!verificationToken_.empty()) flags |= 0x08;  // Has verification token
     
+    // Pooled keys change on the refill thread
+    std::array<Byte, AES_NONCE_SIZE> keypoolNonce;
+    std::vector<Byte> keypoolCiphertext;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        keypoolNonce = keypoolNonce_;
+        keypoolCiphertext = keypoolCiphertext_;
+    }
+    if (!keypoolCiphertext.empty()) flags |= 0x10;  // Has keypool
+    
     data.push_back((flags >> 24) & 0xFF);
     data.push_back((flags >> 16) & 0xFF);
     data.push_back((flags >> 8) & 0xFF);
@@ -1364,6 +1777,20 @@ std::vector<Byte> FileKeyStore::Serialize() const {
         data.insert(data.end(), verificationToken_.begin(), verificationToken_.end());
     }
     
+    // === Serialize keypool (added in version 4) ===
+    if (!keypoolCiphertext.empty()) {
+        // Nonce (12 bytes, zero when in the clear)
+        data.insert(data.end(), keypoolNonce.begin(), keypoolNonce.end());
+        
+        // Sealed keys length and data
+        uint32_t poolLen = static_cast<uint32_t>(keypoolCiphertext.size());
+        data.push_back((poolLen >> 24) & 0xFF);
+        data.push_back((poolLen >> 16) & 0xFF);
+        data.push_back((poolLen >> 8) & 0xFF);
+        data.push_back(poolLen & 0xFF);
+        data.insert(data.end(), keypoolCiphertext.begin(), keypoolCiphertext.end());
+    }
+    
     return data;
 }
 
@@ -1576,11 +2003,21 @@ bool FileKeyStore::Deserialize(const std::vector<Byte>& data) {
             verificationToken_ = readVector();
         }
         
+        // === Read keypool (version 4+, flag 0x10) ===
+        std::lock_guard<std::mutex> lock(mutex_);
+        keypoolNonce_ = {};
+        keypoolCiphertext_.clear();
+        if (version >= 4 && (flags & 0x10) != 0 && offset < data.size()) {
+            readBytes(keypoolNonce_.data(), AES_NONCE_SIZE);
+            keypoolCiphertext_ = readVector();
+        }
+        
         // Reset unlocked state
         unlocked_ = false;
         masterKey_.reset();
-        unlockedKeys_.clear();
+        ClearDecryptedKeys();
         hdKeyManager_.reset();
+        ++hdEpoch_;
         unlockedIdentity_.reset();
         
         // For unencrypted wallets with plaintext seed, mark as needing deferred HD init
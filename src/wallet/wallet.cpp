@@ -8,14 +8,19 @@
 #include <shurium/core/serialize.h>
 #include <shurium/economics/ubi.h>
 #include <shurium/util/fs.h>
+#include <shurium/util/threadpool.h>
 #include <shurium/script/interpreter.h>
 
-#include <fstream>
+#include <condition_variable>
+#include <deque>
+#include <future>
 
 #include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <thread>
+#include <unordered_set>
 
 namespace shurium {
 namespace wallet {
@@ -32,6 +37,185 @@ std::string GetWalletDataPath(const std::string& keystorePath) {
     return keystorePath + "_data";
 }
 
+// Record layouts shared by the snapshot file format and the wallet log
+
+void WriteConfig(DataStream& stream, const Wallet::Config& config) {
+    Serialize(stream, config.name);
+    Serialize(stream, config.gapLimit);
+    Serialize(stream, static_cast<int64_t>(config.defaultFeeRate));
+    Serialize(stream, config.minChange);
+    Serialize(stream, config.testnet);
+    Serialize(stream, config.autoLockTimeout);
+}
+
+void ReadConfig(DataStream& stream, Wallet::Config& config) {
+    Unserialize(stream, config.name);
+    Unserialize(stream, config.gapLimit);
+    int64_t feeRate;
+    Unserialize(stream, feeRate);
+    config.defaultFeeRate = static_cast<FeeRate>(feeRate);
+    Unserialize(stream, config.minChange);
+    Unserialize(stream, config.testnet);
+    Unserialize(stream, config.autoLockTimeout);
+}
+
+void WriteOutput(DataStream& stream, const WalletOutput& output) {
+    // OutPoint
+    Serialize(stream, output.outpoint);
+    
+    // TxOut
+    Serialize(stream, output.txout);
+    
+    // Metadata
+    Serialize(stream, output.height);
+    Serialize(stream, output.coinbase);
+    Serialize(stream, output.timeReceived);
+    Serialize(stream, static_cast<uint8_t>(output.status));
+    Serialize(stream, output.keyHash);
+    
+    // Optional derivation path
+    bool hasPath = output.keyPath.has_value();
+    Serialize(stream, hasPath);
+    if (hasPath) {
+        Serialize(stream, output.keyPath->ToString());
+    }
+    
+    Serialize(stream, output.label);
+}
+
+void ReadOutput(DataStream& stream, WalletOutput& output) {
+    Unserialize(stream, output.outpoint);
+    Unserialize(stream, output.txout);
+    Unserialize(stream, output.height);
+    Unserialize(stream, output.coinbase);
+    Unserialize(stream, output.timeReceived);
+    
+    uint8_t status;
+    Unserialize(stream, status);
+    output.status = static_cast<OutputStatus>(status);
+    
+    Unserialize(stream, output.keyHash);
+    
+    bool hasPath;
+    Unserialize(stream, hasPath);
+    if (hasPath) {
+        std::string pathStr;
+        Unserialize(stream, pathStr);
+        output.keyPath = DerivationPath::FromString(pathStr);
+    }
+    
+    Unserialize(stream, output.label);
+}
+
+void WriteTransaction(DataStream& stream, const TxHash& hash, const WalletTransaction& wtx) {
+    // Transaction hash (key)
+    Serialize(stream, hash);
+    
+    // Serialize the transaction if we have it
+    bool hasTx = (wtx.tx != nullptr);
+    Serialize(stream, hasTx);
+    if (hasTx) {
+        // Serialize as MutableTransaction then convert
+        MutableTransaction mtx(*wtx.tx);
+        Serialize(stream, mtx);
+    }
+    
+    // Confirmation info
+    Serialize(stream, wtx.confirmation.blockHeight);
+    Serialize(stream, wtx.confirmation.blockHash);
+    Serialize(stream, wtx.confirmation.txIndex);
+    Serialize(stream, wtx.confirmation.blockTime);
+    
+    // Timestamps
+    Serialize(stream, wtx.timeReceived);
+    Serialize(stream, wtx.timeCreated);
+    
+    // Flags
+    Serialize(stream, wtx.fromMe);
+    
+    // Our inputs/outputs indices - serialize as uint32_t for cross-platform compatibility
+    uint32_t inputCount = static_cast<uint32_t>(wtx.ourInputs.size());
+    Serialize(stream, inputCount);
+    for (size_t idx : wtx.ourInputs) {
+        uint32_t idx32 = static_cast<uint32_t>(idx);
+        Serialize(stream, idx32);
+    }
+    
+    uint32_t outputCount = static_cast<uint32_t>(wtx.ourOutputs.size());
+    Serialize(stream, outputCount);
+    for (size_t idx : wtx.ourOutputs) {
+        uint32_t idx32 = static_cast<uint32_t>(idx);
+        Serialize(stream, idx32);
+    }
+    
+    // Fee and label
+    Serialize(stream, wtx.fee);
+    Serialize(stream, wtx.label);
+}
+
+void ReadTransaction(DataStream& stream, TxHash& hash, WalletTransaction& wtx) {
+    Unserialize(stream, hash);
+    
+    bool hasTx;
+    Unserialize(stream, hasTx);
+    if (hasTx) {
+        MutableTransaction mtx;
+        Unserialize(stream, mtx);
+        wtx.tx = std::make_shared<Transaction>(mtx);
+    }
+    
+    Unserialize(stream, wtx.confirmation.blockHeight);
+    Unserialize(stream, wtx.confirmation.blockHash);
+    Unserialize(stream, wtx.confirmation.txIndex);
+    Unserialize(stream, wtx.confirmation.blockTime);
+    
+    Unserialize(stream, wtx.timeReceived);
+    Unserialize(stream, wtx.timeCreated);
+    Unserialize(stream, wtx.fromMe);
+    
+    // Deserialize our inputs/outputs indices
+    uint32_t inputCount;
+    Unserialize(stream, inputCount);
+    wtx.ourInputs.clear();
+    wtx.ourInputs.reserve(inputCount);
+    for (uint32_t j = 0; j < inputCount; ++j) {
+        uint32_t idx;
+        Unserialize(stream, idx);
+        wtx.ourInputs.push_back(static_cast<size_t>(idx));
+    }
+    
+    uint32_t outputIndicesCount;
+    Unserialize(stream, outputIndicesCount);
+    wtx.ourOutputs.clear();
+    wtx.ourOutputs.reserve(outputIndicesCount);
+    for (uint32_t j = 0; j < outputIndicesCount; ++j) {
+        uint32_t idx;
+        Unserialize(stream, idx);
+        wtx.ourOutputs.push_back(static_cast<size_t>(idx));
+    }
+    
+    Unserialize(stream, wtx.fee);
+    Unserialize(stream, wtx.label);
+}
+
+void WriteAddressEntry(DataStream& stream, const AddressBookEntry& entry) {
+    Serialize(stream, entry.address);
+    Serialize(stream, entry.label);
+    Serialize(stream, entry.purpose);
+    Serialize(stream, entry.created);
+}
+
+void ReadAddressEntry(DataStream& stream, AddressBookEntry& entry) {
+    Unserialize(stream, entry.address);
+    Unserialize(stream, entry.label);
+    Unserialize(stream, entry.purpose);
+    Unserialize(stream, entry.created);
+}
+
+std::vector<Byte> ToBytes(const DataStream& stream) {
+    return std::vector<Byte>(stream.begin(), stream.end());
+}
+
 } // anonymous namespace
 
 // ============================================================================
@@ -198,11 +382,16 @@ TransactionBuilder& TransactionBuilder::SetRBF(bool enable) {
 }
 
 BuildTxResult TransactionBuilder::Build() {
+    return BuildFor(recipients_, GetAvailableOutputs());
+}
+
+BuildTxResult TransactionBuilder::BuildFor(const std::vector<Recipient>& recipients,
+                                           const std::vector<OutputGroup>& available) {
     BuildTxResult result;
     
     // Calculate total to send
     Amount totalToSend = 0;
-    for (const auto& recipient : recipients_) {
+    for (const auto& recipient : recipients) {
         totalToSend += recipient.amount;
     }
     
@@ -211,9 +400,7 @@ BuildTxResult TransactionBuilder::Build() {
         return result;
     }
     
-    // Get available outputs
-    auto availableOutputs = GetAvailableOutputs();
-    if (availableOutputs.empty()) {
+    if (available.empty()) {
         result.error = "No spendable outputs available";
         return result;
     }
@@ -222,13 +409,13 @@ BuildTxResult TransactionBuilder::Build() {
     SelectionParams params;
     params.targetValue = totalToSend;
     params.feeRate = feeRate_;
-    params.outputCount = recipients_.size();
+    params.outputCount = recipients.size();
     params.includeUnconfirmed = allowUnconfirmed_;
     params.minConfirmations = minConfirmations_;
     
     // Select coins
     CoinSelector selector(params);
-    auto selection = selector.Select(availableOutputs, strategy_);
+    auto selection = selector.Select(available, strategy_);
     
     if (!selection.success) {
         result.error = "Insufficient funds";
@@ -251,12 +438,12 @@ BuildTxResult TransactionBuilder::Build() {
     }
     
     // Add outputs
-    for (const auto& recipient : recipients_) {
+    for (const auto& recipient : recipients) {
         result.tx.vout.emplace_back(recipient.amount, recipient.scriptPubKey);
     }
     
     // Calculate fee
-    result.fee = absoluteFee_.value_or(selector.CalculateFee(selection, recipients_.size()));
+    result.fee = absoluteFee_.value_or(selector.CalculateFee(selection, recipients.size()));
     
     // Calculate change
     result.change = selection.totalEffectiveValue - totalToSend - result.fee;
@@ -304,6 +491,52 @@ BuildTxResult TransactionBuilder::BuildAndSign() {
     return result;
 }
 
+std::vector<BuildTxResult> TransactionBuilder::BuildBatch(
+    const std::vector<std::vector<Recipient>>& payouts, util::ThreadPool* pool) {
+    std::vector<BuildTxResult> results;
+    results.reserve(payouts.size());
+    
+    // Plan in order over one snapshot, taking each transaction's inputs out
+    // of it before the next one selects
+    std::vector<OutputGroup> available = GetAvailableOutputs();
+    for (const auto& recipients : payouts) {
+        BuildTxResult result = BuildFor(recipients, available);
+        if (result.success) {
+            std::set<OutPoint> spent;
+            for (const auto& input : result.inputs) {
+                spent.insert(input.outpoint);
+            }
+            available.erase(std::remove_if(available.begin(), available.end(),
+                                           [&spent](const OutputGroup& group) {
+                                               return spent.count(group.outpoint) > 0;
+                                           }),
+                            available.end());
+        }
+        results.push_back(std::move(result));
+    }
+    
+    // Sign the planned transactions together
+    std::vector<MutableTransaction> txs;
+    std::vector<size_t> planned;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].success) {
+            txs.push_back(std::move(results[i].tx));
+            planned.push_back(i);
+        }
+    }
+    std::vector<bool> signedOk = wallet_.SignTransactions(txs, pool);
+    for (size_t j = 0; j < planned.size(); ++j) {
+        BuildTxResult& result = results[planned[j]];
+        result.tx = std::move(txs[j]);
+        if (!signedOk[j]) {
+            result.success = false;
+            result.error = "Failed to sign transaction";
+        }
+    }
+    
+    return results;
+}
+
 Amount TransactionBuilder::EstimateFee() const {
     Amount totalToSend = 0;
     for (const auto& recipient : recipients_) {
@@ -328,16 +561,7 @@ void TransactionBuilder::Clear() {
 }
 
 std::vector<OutputGroup> TransactionBuilder::GetAvailableOutputs() const {
-    std::vector<OutputGroup> outputs;
-    
-    auto walletOutputs = wallet_.GetSpendableOutputs();
-    int32_t currentHeight = wallet_.GetChainHeight();
-    
-    for (const auto& wo : walletOutputs) {
-        outputs.push_back(wo.ToOutputGroup(feeRate_, currentHeight));
-    }
-    
-    return outputs;
+    return wallet_.GetCoinCandidates(feeRate_);
 }
 
 TxOut TransactionBuilder::CreateChangeOutput(Amount amount) {
@@ -362,6 +586,78 @@ std::optional<Recipient> Recipient::FromAddress(const std::string& address, Amou
     return Recipient(script, amount);
 }
 
+// ============================================================================
+// KeyHashIndex Implementation
+// ============================================================================
+
+size_t KeyHashIndex::Hasher::operator()(const Hash160& hash) const noexcept {
+    // Key hashes are hash output, so their leading bytes hash well enough
+    size_t value;
+    std::memcpy(&value, hash.data(), sizeof(value));
+    return value;
+}
+
+void KeyHashIndex::Reset(size_t expected) {
+    keys_.clear();
+    keys_.reserve(expected);
+    RebuildBloom(expected);
+}
+
+void KeyHashIndex::Insert(const Hash160& keyHash) {
+    if (!keys_.insert(keyHash).second) {
+        return;
+    }
+    if (keys_.size() * KEY_INDEX_BLOOM_BITS_PER_KEY > bloom_.size() * 64) {
+        RebuildBloom(keys_.size() * 2);
+    } else {
+        AddToBloom(keyHash);
+    }
+}
+
+bool KeyHashIndex::Contains(const Hash160& keyHash) const {
+    if (keys_.empty()) {
+        return false;
+    }
+    uint64_t h1, h2;
+    BloomHashes(keyHash, h1, h2);
+    for (int i = 0; i < KEY_INDEX_BLOOM_HASHES; ++i) {
+        uint64_t bit = (h1 + i * h2) & bloomMask_;
+        if (!(bloom_[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return keys_.count(keyHash) > 0;
+}
+
+void KeyHashIndex::RebuildBloom(size_t capacity) {
+    // Power-of-two bit count, at least one word
+    size_t bits = 64;
+    while (bits < capacity * KEY_INDEX_BLOOM_BITS_PER_KEY) {
+        bits *= 2;
+    }
+    bloom_.assign(bits / 64, 0);
+    bloomMask_ = bits - 1;
+    for (const Hash160& keyHash : keys_) {
+        AddToBloom(keyHash);
+    }
+}
+
+void KeyHashIndex::BloomHashes(const Hash160& keyHash, uint64_t& h1, uint64_t& h2) {
+    // From the bytes after those the hash set buckets on
+    std::memcpy(&h1, keyHash.data() + 8, sizeof(h1));
+    std::memcpy(&h2, keyHash.data() + 12, sizeof(h2));
+    h2 |= 1;
+}
+
+void KeyHashIndex::AddToBloom(const Hash160& keyHash) {
+    uint64_t h1, h2;
+    BloomHashes(keyHash, h1, h2);
+    for (int i = 0; i < KEY_INDEX_BLOOM_HASHES; ++i) {
+        uint64_t bit = (h1 + i * h2) & bloomMask_;
+        bloom_[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+}
+
 // ============================================================================
 // Wallet Implementation
 // ============================================================================
@@ -414,18 +710,12 @@ std::unique_ptr<Wallet> Wallet::Load(const std::string& path, const Config& conf
     
     wallet->path_ = path;
     
-    // Load wallet data (address book, transactions, outputs, etc.)
-    std::string dataPath = GetWalletDataPath(path);
-    std::ifstream file(dataPath, std::ios::binary);
-    if (file) {
-        std::vector<Byte> walletData((std::istreambuf_iterator<char>(file)),
-                                      std::istreambuf_iterator<char>());
-        if (!walletData.empty()) {
-            wallet->DeserializeWalletData(walletData);
-        }
-    }
-    // Note: It's OK if wallet data file doesn't exist (new wallet or migration)
+    // Load wallet data (address book, transactions, outputs, etc.). It's OK
+    // if the data file doesn't exist (new wallet or migration); if it can't
+    // be written, changes are kept until a Save() succeeds
+    wallet->OpenLog(path);
     
+    wallet->StartKeyPool();
     return wallet;
 }
 
@@ -444,6 +734,7 @@ bool Wallet::Initialize(const std::string& mnemonic,
     
     // Create keystore
     keystore_ = std::make_unique<FileKeyStore>();
+    keyIndexGeneration_.reset();
     
     // Set testnet mode before initializing HD manager
     keystore_->SetTestnet(config_.testnet);
@@ -457,15 +748,27 @@ bool Wallet::Initialize(const std::string& mnemonic,
         return false;
     }
     
+    StartKeyPool();
     return true;
 }
 
 bool Wallet::Initialize(std::unique_ptr<FileKeyStore> keystore) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     keystore_ = std::move(keystore);
+    keyIndexGeneration_.reset();
+    UpdateBalance();
+    StartKeyPool();
     return keystore_ != nullptr;
 }
 
+void Wallet::StartKeyPool() {
+    if (!keystore_ || config_.keypoolSize == 0) {
+        return;
+    }
+    keystore_->SetKeyPoolSize(std::max(config_.keypoolSize, config_.gapLimit));
+    keystore_->StartKeyPoolRefill();
+}
+
 bool Wallet::IsLocked() const {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     return keystore_ && keystore_->IsLocked();
@@ -548,12 +851,27 @@ HDKeyManager* Wallet::GetHDKeyManager() {
     return nullptr;
 }
 
+std::optional<HDKeyManager::KeyInfo> Wallet::FindHDKey(const Hash160& keyHash) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (!keystore_) {
+        return std::nullopt;
+    }
+    return keystore_->FindHDKey(keyHash);
+}
+
+size_t Wallet::GetKeyPoolAvailable(bool internal) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return keystore_ ? keystore_->GetKeyPoolAvailable(internal ? 1 : 0) : 0;
+}
+
 bool Wallet::IsMine(const Script& script) const {
     auto keyHash = GetKeyHashFromScript(script);
     if (!keyHash) {
         return false;
     }
-    return keystore_ && keystore_->HaveKey(*keyHash);
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    RefreshKeyIndex();
+    return keyIndex_.Contains(*keyHash);
 }
 
 bool Wallet::IsMine(const TxOut& txout) const {
@@ -571,18 +889,22 @@ std::optional<Hash160> Wallet::GetKeyHashFromScript(const Script& script) const
     return ExtractP2PKHKeyHash(script);
 }
 
+// Addresses are handed out without mutex_, so a block being applied does not
+// hold them up: the keystore locks itself, and the address book and log
+// have their own locks.
+
 std::string Wallet::GetNewAddress(const std::string& label) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    
     if (!keystore_) {
         return "";
     }
     
     // Use keystore's DeriveNextReceiving to properly track indices for persistence
+    uint64_t generation = keystore_->GetKeyGeneration();
     auto pubKey = keystore_->DeriveNextReceiving();
     if (!pubKey) {
         return "";
     }
+    NoteDerivedKey(pubKey->GetHash160(), generation);
     
     std::string address = EncodeP2WPKH(pubKey->GetHash160(), config_.testnet);
     
@@ -590,39 +912,36 @@ std::string Wallet::GetNewAddress(const std::string& label) {
         AddAddressBookEntry(address, label, "receive");
     }
     
-    // Auto-save wallet to persist the new HD index
-    if (!path_.empty()) {
-        Save(path_);
-    }
+    // Persist the new HD index
+    LogHDIndex(0, 0);
+    FlushLog();
     
     return address;
 }
 
 std::string Wallet::GetChangeAddress() {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    
     if (!keystore_) {
         return "";
     }
     
     // Use keystore's DeriveNextChange to properly track indices for persistence
+    uint64_t generation = keystore_->GetKeyGeneration();
     auto pubKey = keystore_->DeriveNextChange();
     if (!pubKey) {
         return "";
     }
+    NoteDerivedKey(pubKey->GetHash160(), generation);
     
     std::string address = EncodeP2WPKH(pubKey->GetHash160(), config_.testnet);
     
-    // Auto-save wallet to persist the new HD index
-    if (!path_.empty()) {
-        Save(path_);
-    }
+    // Persist the new HD index
+    LogHDIndex(0, 1);
+    FlushLog();
     
     return address;
 }
 
 std::string Wallet::GetAddress(const Hash160& keyHash) const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
     return EncodeP2WPKH(keyHash, config_.testnet);
 }
 
@@ -643,12 +962,16 @@ std::vector<std::string> Wallet::GetAddresses() const {
 void Wallet::AddAddressBookEntry(const std::string& address,
                                   const std::string& label,
                                   const std::string& purpose) {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    addressBook_[address] = AddressBookEntry(address, label, purpose);
+    {
+        std::unique_lock<std::shared_mutex> lock(addressBookMutex_);
+        auto& entry = addressBook_[address] = AddressBookEntry(address, label, purpose);
+        LogAddressEntry(entry);
+    }
+    FlushLog();
 }
 
 std::vector<AddressBookEntry> Wallet::GetAddressBook() const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::shared_lock<std::shared_mutex> lock(addressBookMutex_);
     
     std::vector<AddressBookEntry> entries;
     entries.reserve(addressBook_.size());
@@ -661,7 +984,7 @@ std::vector<AddressBookEntry> Wallet::GetAddressBook() const {
 }
 
 std::optional<AddressBookEntry> Wallet::LookupAddress(const std::string& address) const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    std::shared_lock<std::shared_mutex> lock(addressBookMutex_);
     
     auto it = addressBook_.find(address);
     if (it != addressBook_.end()) {
@@ -672,38 +995,51 @@ std::optional<AddressBookEntry> Wallet::LookupAddress(const std::string& address
 }
 
 WalletBalance Wallet::GetBalance() const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
-    
-    WalletBalance balance;
-    int32_t currentHeight = chainHeight_.load();
-    
-    for (const auto& [outpoint, output] : outputs_) {
-        if (output.status == OutputStatus::Spent) {
-            continue;
+    {
+        std::lock_guard<std::mutex> viewLock(viewMutex_);
+        if (balanceView_ && balanceVersion_ == version_.load()) {
+            return *balanceView_;
         }
-        
-        Amount value = output.GetValue();
-        bool isWatchOnly = keystore_ && keystore_->IsWatchOnly(output.keyHash);
-        
-        if (output.status == OutputStatus::Locked) {
-            balance.locked += value;
-        } else if (!output.IsMature(currentHeight)) {
-            balance.immature += value;
-        } else if (output.height < 0) {
-            if (isWatchOnly) {
-                balance.watchOnlyUnconfirmed += value;
-            } else {
-                balance.unconfirmed += value;
-            }
-        } else {
-            if (isWatchOnly) {
-                balance.watchOnlyConfirmed += value;
-            } else {
-                balance.confirmed += value;
+    }
+    
+    // Rather than wait for a block being applied, answer as of the last one
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        {
+            std::lock_guard<std::mutex> viewLock(viewMutex_);
+            if (balanceView_) {
+                return *balanceView_;
             }
         }
+        lock.lock();
     }
+    return PublishBalance();
+}
+
+WalletBalance Wallet::ComputeBalance() const {
+    WalletBalance balance = balance_;
+    int32_t currentHeight = chainHeight_.load();
     
+    // Coinbase outputs within the maturity window are immature, the rest
+    // count as confirmed; the window bounds this walk, not the output count
+    CoinbaseTally immature;
+    auto addImmature = [&immature](const CoinbaseTally& tally) {
+        immature.own += tally.own;
+        immature.watchOnly += tally.watchOnly;
+    };
+    auto unconfirmed = coinbaseByHeight_.find(-1);
+    if (unconfirmed != coinbaseByHeight_.end()) {
+        addImmature(unconfirmed->second);
+    }
+    int32_t oldestImmature = std::max(currentHeight - WALLET_COINBASE_MATURITY + 2, 0);
+    for (auto it = coinbaseByHeight_.lower_bound(oldestImmature);
+         it != coinbaseByHeight_.end(); ++it) {
+        addImmature(it->second);
+    }
+    
+    balance.immature += immature.own + immature.watchOnly;
+    balance.confirmed += coinbaseTotal_.own - immature.own;
+    balance.watchOnlyConfirmed += coinbaseTotal_.watchOnly - immature.watchOnly;
     return balance;
 }
 
@@ -711,52 +1047,65 @@ WalletBalance Wallet::GetBalanceAtHeight(int32_t height) const {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     
     WalletBalance balance;
-    
-    for (const auto& [outpoint, output] : outputs_) {
-        if (output.height > height) {
-            continue;  // Created after target height
-        }
-        
-        if (output.status == OutputStatus::Spent) {
-            continue;
-        }
-        
-        Amount value = output.GetValue();
-        
-        if (output.height < 0) {
-            balance.unconfirmed += value;
+    for (auto it = unspentByHeight_.begin();
+         it != unspentByHeight_.end() && it->first <= height; ++it) {
+        if (it->first < 0) {
+            balance.unconfirmed += it->second;
         } else {
-            balance.confirmed += value;
+            balance.confirmed += it->second;
         }
     }
-    
     return balance;
 }
 
 std::vector<WalletOutput> Wallet::GetOutputs() const {
+    return GetSnapshot()->outputs;
+}
+
+std::vector<WalletOutput> Wallet::GetSpendableOutputs() const {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     
     std::vector<WalletOutput> result;
-    result.reserve(outputs_.size());
+    int32_t currentHeight = chainHeight_.load();
     
-    for (const auto& [outpoint, output] : outputs_) {
-        result.push_back(output);
+    for (const auto& [key, output] : spendable_) {
+        if (output->IsSpendable(currentHeight) && !IsLockedOutput(key.second)) {
+            result.push_back(*output);
+        }
     }
     
     return result;
 }
 
-std::vector<WalletOutput> Wallet::GetSpendableOutputs() const {
+std::vector<WalletOutput> Wallet::GetSpendableOutputs(const Hash160& keyHash) const {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     
     std::vector<WalletOutput> result;
+    auto byKey = spendableByKey_.find(keyHash);
+    if (byKey == spendableByKey_.end()) {
+        return result;
+    }
     int32_t currentHeight = chainHeight_.load();
     
-    for (const auto& [outpoint, output] : outputs_) {
-        if (output.IsSpendable(currentHeight)) {
-            if (!IsLockedOutput(outpoint)) {
-                result.push_back(output);
-            }
+    for (const auto& [key, output] : byKey->second) {
+        if (output->IsSpendable(currentHeight) && !IsLockedOutput(key.second)) {
+            result.push_back(*output);
+        }
+    }
+    
+    return result;
+}
+
+std::vector<OutputGroup> Wallet::GetCoinCandidates(FeeRate feeRate) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    
+    std::vector<OutputGroup> result;
+    result.reserve(spendable_.size());
+    int32_t currentHeight = chainHeight_.load();
+    
+    for (const auto& [key, output] : spendable_) {
+        if (output->IsSpendable(currentHeight) && !IsLockedOutput(key.second)) {
+            result.push_back(output->ToOutputGroup(feeRate, currentHeight));
         }
     }
     
@@ -779,13 +1128,21 @@ std::vector<WalletOutput> Wallet::GetUnconfirmedOutputs() const {
 
 bool Wallet::LockOutput(const OutPoint& outpoint) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
-    lockedOutputs_.insert(outpoint);
+    if (lockedOutputs_.insert(outpoint).second) {
+        LogLockedOutput(outpoint, true);
+        CommitLog();
+    }
     return true;
 }
 
 bool Wallet::UnlockOutput(const OutPoint& outpoint) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
-    return lockedOutputs_.erase(outpoint) > 0;
+    if (lockedOutputs_.erase(outpoint) == 0) {
+        return false;
+    }
+    LogLockedOutput(outpoint, false);
+    CommitLog();
+    return true;
 }
 
 std::vector<OutPoint> Wallet::GetLockedOutputs() const {
@@ -888,6 +1245,93 @@ bool Wallet::SignTransaction(MutableTransaction& tx, const IKeyStore& keystore)
     return true;
 }
 
+std::vector<bool> Wallet::SignTransactions(std::vector<MutableTransaction>& txs,
+                                           util::ThreadPool* pool) {
+    // What signing input i of a transaction needs; no key means not ours
+    struct InputSigner {
+        const PrivateKey* key{nullptr};
+        Script scriptCode;
+    };
+    
+    std::vector<bool> results(txs.size(), false);
+    std::vector<std::vector<InputSigner>> signers(txs.size());
+    std::map<Hash160, std::optional<PrivateKey>> keys;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (!keystore_) {
+            return results;
+        }
+        for (size_t t = 0; t < txs.size(); ++t) {
+            signers[t].resize(txs[t].vin.size());
+            bool haveKeys = true;
+            for (size_t i = 0; i < txs[t].vin.size(); ++i) {
+                auto it = outputs_.find(txs[t].vin[i].prevout);
+                if (it == outputs_.end()) {
+                    continue;  // Not our output
+                }
+                auto found = keys.find(it->second.keyHash);
+                if (found == keys.end()) {
+                    found = keys.emplace(it->second.keyHash,
+                                         keystore_->GetKey(it->second.keyHash)).first;
+                }
+                if (!found->second) {
+                    haveKeys = false;  // Can't sign without key
+                    break;
+                }
+                signers[t][i].key = &*found->second;
+                signers[t][i].scriptCode = it->second.txout.scriptPubKey;
+            }
+            results[t] = haveKeys;
+        }
+    }
+    
+    auto signOne = [&txs, &signers](size_t t) {
+        MutableTransaction& tx = txs[t];
+        Transaction txCopy(tx);
+        PrecomputedTransactionData txdata(txCopy);
+        constexpr uint8_t nHashType = SIGHASH_ALL;
+        for (size_t i = 0; i < tx.vin.size(); ++i) {
+            const InputSigner& signer = signers[t][i];
+            if (!signer.key) {
+                continue;
+            }
+            Hash256 sigHash = SignatureHash(txCopy, static_cast<unsigned int>(i),
+                                            signer.scriptCode, nHashType, 0,
+                                            SigVersion::BASE, &txdata);
+            auto signature = signer.key->Sign(sigHash);
+            if (signature.empty()) {
+                return false;
+            }
+            signature.push_back(nHashType);
+            
+            Script scriptSig;
+            scriptSig << signature;
+            scriptSig << signer.key->GetPublicKey().ToVector();
+            tx.vin[i].scriptSig = scriptSig;
+        }
+        return true;
+    };
+    
+    std::vector<std::future<bool>> pending(txs.size());
+    for (size_t t = 0; t < txs.size(); ++t) {
+        if (!results[t] || !pool) {
+            continue;
+        }
+        try {
+            pending[t] = pool->Submit(signOne, t);
+        } catch (const std::runtime_error&) {
+            // Pool stopped or full: sign here instead
+        }
+    }
+    for (size_t t = 0; t < txs.size(); ++t) {
+        if (results[t]) {
+            results[t] = pending[t].valid() ? pending[t].get() : signOne(t);
+        }
+    }
+    
+    return results;
+}
+
 std::optional<TxHash> Wallet::BroadcastTransaction(const Transaction& tx) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     
@@ -933,22 +1377,53 @@ void Wallet::SetBroadcastCallback(BroadcastCallback callback) {
 }
 
 std::vector<WalletTransaction> Wallet::GetTransactions() const {
-    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    return GetSnapshot()->transactions;
+}
+
+std::shared_ptr<const WalletSnapshot> Wallet::GetSnapshot() const {
+    {
+        std::lock_guard<std::mutex> viewLock(viewMutex_);
+        if (snapshot_ && snapshot_->version == version_.load()) {
+            return snapshot_;
+        }
+    }
+    
+    // Rather than wait for a block being applied, answer as of the last build
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        {
+            std::lock_guard<std::mutex> viewLock(viewMutex_);
+            if (snapshot_) {
+                return snapshot_;
+            }
+        }
+        lock.lock();
+    }
     
-    std::vector<WalletTransaction> result;
-    result.reserve(transactions_.size());
+    auto snapshot = std::make_shared<WalletSnapshot>();
+    snapshot->version = version_.load();
+    snapshot->chainHeight = chainHeight_.load();
+    snapshot->balance = ComputeBalance();
     
+    snapshot->transactions.reserve(transactions_.size());
     for (const auto& [hash, tx] : transactions_) {
-        result.push_back(tx);
+        snapshot->transactions.push_back(tx);
     }
     
     // Sort by time (newest first)
-    std::sort(result.begin(), result.end(),
+    std::sort(snapshot->transactions.begin(), snapshot->transactions.end(),
               [](const WalletTransaction& a, const WalletTransaction& b) {
                   return a.timeReceived > b.timeReceived;
               });
     
-    return result;
+    snapshot->outputs.reserve(outputs_.size());
+    for (const auto& [outpoint, output] : outputs_) {
+        snapshot->outputs.push_back(output);
+    }
+    
+    std::lock_guard<std::mutex> viewLock(viewMutex_);
+    snapshot_ = snapshot;
+    return snapshot;
 }
 
 std::optional<WalletTransaction> Wallet::GetTransaction(const TxHash& hash) const {
@@ -974,15 +1449,22 @@ void Wallet::ProcessBlock(const Block& block, int32_t height) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     
     chainHeight_.store(height);
+    LogChainHeight();
     
+    // Outputs are matched against the key index, brought up to date once
+    RefreshKeyIndex();
     for (const auto& tx : block.vtx) {
         ProcessWalletTransaction(tx, height);
     }
+    CommitLog();
+    PublishBalance();
 }
 
 void Wallet::ProcessTransaction(const TransactionRef& tx, int32_t height) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     ProcessWalletTransaction(tx, height);
+    CommitLog();
+    PublishBalance();
 }
 
 void Wallet::DisconnectBlock(const Block& block, int32_t height) {
@@ -993,22 +1475,34 @@ void Wallet::DisconnectBlock(const Block& block, int32_t height) {
         const auto& hash = tx->GetHash();
         
         for (uint32_t i = 0; i < tx->vout.size(); ++i) {
-            OutPoint outpoint(hash, i);
-            outputs_.erase(outpoint);
+            auto it = outputs_.find(OutPoint(hash, i));
+            if (it != outputs_.end()) {
+                TallyOutput(it->second, false);
+                outputs_.erase(it);
+                LogOutputErased(OutPoint(hash, i));
+            }
         }
         
         // Mark transaction as unconfirmed
         auto it = transactions_.find(hash);
         if (it != transactions_.end()) {
             it->second.confirmation.blockHeight = -1;
+            LogTransaction(hash, it->second);
         }
     }
     
     chainHeight_.store(height - 1);
+    LogChainHeight();
+    CommitLog();
+    PublishBalance();
 }
 
 void Wallet::SetChainHeight(int32_t height) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     chainHeight_.store(height);
+    LogChainHeight();
+    CommitLog();
+    PublishBalance();
 }
 
 int32_t Wallet::GetChainHeight() const {
@@ -1018,14 +1512,339 @@ int32_t Wallet::GetChainHeight() const {
 void Wallet::RescanFrom(int32_t height) {
     std::lock_guard<std::recursive_mutex> lock(mutex_);
     
+    // Forget transactions confirmed after height; what they spent from us
+    // is unspent again until the blocks are seen anew
+    for (auto it = transactions_.begin(); it != transactions_.end(); ) {
+        const WalletTransaction& wtx = it->second;
+        if (wtx.confirmation.blockHeight <= height) {
+            ++it;
+            continue;
+        }
+        for (size_t index : wtx.ourInputs) {
+            auto out = outputs_.find(wtx.tx->vin[index].prevout);
+            if (out != outputs_.end() && out->second.status == OutputStatus::Spent) {
+                out->second.status = (out->second.height >= 0) ? OutputStatus::Available
+                                                                : OutputStatus::Unconfirmed;
+                TallyOutput(out->second, true);
+                LogOutput(out->second);
+            }
+        }
+        LogTransactionErased(it->first);
+        it = transactions_.erase(it);
+    }
+    
     // Clear outputs created after height
     for (auto it = outputs_.begin(); it != outputs_.end(); ) {
         if (it->second.height > height) {
+            TallyOutput(it->second, false);
+            LogOutputErased(it->first);
             it = outputs_.erase(it);
         } else {
             ++it;
         }
     }
+    CommitLog();
+    
+    // Keys imported since the outputs were tallied may have changed kind
+    UpdateBalance();
+    PublishBalance();
+}
+
+namespace {
+
+/// A block decoded and matched off the wallet lock
+struct ScannedBlock {
+    int32_t height{0};
+    bool decoded{false};
+    
+    /// Ruled out by the block's filter; block is left empty
+    bool skipped{false};
+    Block block;
+    
+    /// Transactions with an output paying one of the wallet's keys, ascending
+    std::vector<size_t> paying;
+};
+
+ScannedBlock ScanBlock(int32_t height, std::vector<uint8_t>& raw, const KeyHashIndex& keys) {
+    ScannedBlock scanned;
+    scanned.height = height;
+    try {
+        DataStream ss(std::move(raw));
+        Unserialize(ss, scanned.block);
+    } catch (const std::exception&) {
+        return scanned;
+    }
+    scanned.decoded = true;
+    
+    for (size_t i = 0; i < scanned.block.vtx.size(); ++i) {
+        for (const auto& output : scanned.block.vtx[i]->vout) {
+            auto keyHash = ExtractP2WPKHKeyHash(output.scriptPubKey);
+            if (!keyHash) {
+                keyHash = ExtractP2PKHKeyHash(output.scriptPubKey);
+            }
+            if (keyHash && keys.Contains(*keyHash)) {
+                scanned.paying.push_back(i);
+                break;
+            }
+        }
+    }
+    return scanned;
+}
+
+} // namespace
+
+double RescanProgress::GetFraction() const {
+    if (stopHeight < startHeight) {
+        return 0.0;
+    }
+    double done = static_cast<double>(currentHeight - startHeight);
+    double total = static_cast<double>(stopHeight - startHeight + 1);
+    return std::min(1.0, std::max(0.0, done / total));
+}
+
+RescanResult Wallet::Rescan(const RescanBlockSource& source, int32_t startHeight,
+                            int32_t stopHeight, util::ThreadPool* pool,
+                            const RescanFilterSource& filters) {
+    RescanResult result;
+    startHeight = std::max<int32_t>(startHeight, 0);
+    result.startHeight = startHeight;
+    result.stopHeight = startHeight - 1;
+    
+    if (scanning_.exchange(true)) {
+        result.error = "Wallet is already rescanning";
+        return result;
+    }
+    abortRescan_.store(false);
+    rescanStart_.store(startHeight);
+    rescanStop_.store(stopHeight);
+    rescanHeight_.store(startHeight);
+    
+    RescanFrom(startHeight - 1);
+    
+    // Workers match against a copy of the key index rather than the keystore
+    KeyHashIndex keys;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        RefreshKeyIndex();
+        keys = keyIndex_;
+    }
+    
+    // Filters are tested against the scripts those key hashes pay to
+    GCSFilter::ElementSet scripts;
+    if (filters) {
+        for (const Hash160& keyHash : keys) {
+            Script p2pkh = CreateP2PKHScript(keyHash);
+            Script p2wpkh = CreateP2WPKHScript(keyHash);
+            scripts.emplace(p2pkh.begin(), p2pkh.end());
+            scripts.emplace(p2wpkh.begin(), p2wpkh.end());
+        }
+    }
+    
+    // Reader: blocks come off disk in order, up to RESCAN_READAHEAD ahead;
+    // those ruled out by their filter are queued empty and never read
+    struct QueuedBlock {
+        int32_t height;
+        std::vector<uint8_t> raw;
+        bool skipped;
+    };
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<QueuedBlock> queue;
+    bool readerDone = false;
+    bool stopReader = false;
+    
+    std::thread reader([&]() {
+        for (int32_t height = startHeight; stopHeight < 0 || height <= stopHeight; ++height) {
+            std::vector<uint8_t> raw;
+            bool skipped = false;
+            try {
+                if (filters) {
+                    std::optional<BlockFilter> filter = filters(height);
+                    skipped = filter && !filter->GetFilter().MatchAny(scripts);
+                }
+                if (!skipped && !source(height, raw)) {
+                    break;
+                }
+            } catch (const std::exception&) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCv.wait(lock, [&]() { return stopReader || queue.size() < RESCAN_READAHEAD; });
+            if (stopReader) {
+                break;
+            }
+            queue.push_back({height, std::move(raw), skipped});
+            queueCv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        readerDone = true;
+        queueCv.notify_all();
+    });
+    
+    auto nextRaw = [&](int32_t& height, std::vector<uint8_t>& raw, bool& skipped) {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        queueCv.wait(lock, [&]() { return !queue.empty() || readerDone; });
+        if (queue.empty()) {
+            return false;
+        }
+        height = queue.front().height;
+        raw = std::move(queue.front().raw);
+        skipped = queue.front().skipped;
+        queue.pop_front();
+        queueCv.notify_all();
+        return true;
+    };
+    
+    // Decode and match ahead of the block being applied
+    std::deque<std::future<ScannedBlock>> pending;
+    const size_t window = pool ? RESCAN_READAHEAD : 1;
+    bool more = true;
+    
+    while (true) {
+        if (abortRescan_.load()) {
+            result.aborted = true;
+            break;
+        }
+        
+        while (more && pending.size() < window) {
+            int32_t height = 0;
+            std::vector<uint8_t> raw;
+            bool skipped = false;
+            if (!nextRaw(height, raw, skipped)) {
+                more = false;
+                break;
+            }
+            if (skipped) {
+                std::promise<ScannedBlock> promise;
+                ScannedBlock scanned;
+                scanned.height = height;
+                scanned.decoded = true;
+                scanned.skipped = true;
+                promise.set_value(std::move(scanned));
+                pending.push_back(promise.get_future());
+                continue;
+            }
+            auto data = std::make_shared<std::vector<uint8_t>>(std::move(raw));
+            std::future<ScannedBlock> future;
+            if (pool) {
+                try {
+                    future = pool->Submit([height, data, &keys]() {
+                        return ScanBlock(height, *data, keys);
+                    });
+                } catch (const std::runtime_error&) {
+                    // Pool stopped or full: match here instead
+                }
+            }
+            if (!future.valid()) {
+                std::promise<ScannedBlock> promise;
+                promise.set_value(ScanBlock(height, *data, keys));
+                future = promise.get_future();
+            }
+            pending.push_back(std::move(future));
+        }
+        if (pending.empty()) {
+            break;
+        }
+        
+        ScannedBlock scanned = pending.front().get();
+        pending.pop_front();
+        if (!scanned.decoded) {
+            result.error = "Failed to decode block at height " + std::to_string(scanned.height);
+            break;
+        }
+        if (scanned.skipped) {
+            ++result.blocksSkipped;
+        } else {
+            result.transactionsFound += ApplyScannedBlock(scanned.block, scanned.height,
+                                                          scanned.paying);
+            ++result.blocksScanned;
+        }
+        result.stopHeight = scanned.height;
+        rescanHeight_.store(scanned.height + 1);
+    }
+    
+    // Matching tasks read keys, so they finish before it goes away
+    for (auto& future : pending) {
+        future.wait();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopReader = true;
+        queueCv.notify_all();
+    }
+    reader.join();
+    
+    if (result.stopHeight > chainHeight_.load()) {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        chainHeight_.store(result.stopHeight);
+        LogChainHeight();
+        CommitLog();
+        PublishBalance();
+    }
+    scanning_.store(false);
+    return result;
+}
+
+bool Wallet::AbortRescan() {
+    if (!scanning_.load()) {
+        return false;
+    }
+    abortRescan_.store(true);
+    return true;
+}
+
+RescanProgress Wallet::GetRescanProgress() const {
+    RescanProgress progress;
+    progress.scanning = scanning_.load();
+    progress.startHeight = rescanStart_.load();
+    progress.stopHeight = rescanStop_.load();
+    progress.currentHeight = rescanHeight_.load();
+    return progress;
+}
+
+size_t Wallet::ApplyScannedBlock(const Block& block, int32_t height,
+                                 const std::vector<size_t>& paying) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    
+    size_t found = 0;
+    size_t nextPaying = 0;
+    std::optional<BlockHash> blockHash;
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const auto& tx = block.vtx[i];
+        bool relevant = nextPaying < paying.size() && paying[nextPaying] == i;
+        if (relevant) {
+            ++nextPaying;
+        } else {
+            // Spends from us can only be seen in order, against outputs_
+            for (const auto& input : tx->vin) {
+                if (outputs_.count(input.prevout) > 0) {
+                    relevant = true;
+                    break;
+                }
+            }
+        }
+        if (!relevant) {
+            continue;
+        }
+        
+        ProcessWalletTransaction(tx, height);
+        auto it = transactions_.find(tx->GetHash());
+        if (it != transactions_.end()) {
+            if (!blockHash) {
+                blockHash = block.GetHash();
+            }
+            it->second.confirmation.blockHash = *blockHash;
+            it->second.confirmation.txIndex = static_cast<int32_t>(i);
+            it->second.confirmation.blockTime = block.nTime;
+            LogTransaction(it->first, it->second);
+            ++found;
+        }
+    }
+    if (found > 0) {
+        CommitLog();
+        PublishBalance();
+    }
+    return found;
 }
 
 bool Wallet::HasIdentity() const {
@@ -1123,17 +1942,26 @@ bool Wallet::Save(const std::string& path) {
         }
     }
     
-    // Save wallet data (address book, transactions, outputs, etc.)
+    // Save wallet data (address book, transactions, outputs, etc.). The log
+    // already holds every change, so only the config is appended before
+    // syncing; another path gets a fresh snapshot and becomes the log.
     std::string dataPath = GetWalletDataPath(path);
-    auto walletData = SerializeWalletData();
-    
-    std::ofstream file(dataPath, std::ios::binary);
-    if (!file) {
-        return false;
-    }
-    file.write(reinterpret_cast<const char*>(walletData.data()), walletData.size());
-    if (!file.good()) {
-        return false;
+    if (log_ && log_->GetPath() == dataPath) {
+        DataStream stream;
+        WriteConfig(stream, config_);
+        LogRecord(WalletRecord::META, stream);
+        LogChainHeight();
+        if (!CommitLog(true)) {
+            return false;
+        }
+    } else {
+        std::shared_lock<std::shared_mutex> bookLock(addressBookMutex_);
+        std::lock_guard<std::mutex> logLock(logMutex_);
+        auto log = std::make_unique<WalletLog>();
+        if (!log->Rewrite(dataPath, [this](const WalletLog::RecordSink& sink) { WriteSnapshot(sink); })) {
+            return false;
+        }
+        log_ = std::move(log);
     }
     
     path_ = path;
@@ -1162,6 +1990,43 @@ void Wallet::EmitEvent(WalletEvent event, const std::string& data) {
     }
 }
 
+void Wallet::RefreshKeyIndex() const {
+    if (!keystore_) {
+        keyIndex_.Reset();
+        keyIndexGeneration_.reset();
+        return;
+    }
+    // Read the generation first: a key added meanwhile leaves it stale
+    uint64_t generation = keystore_->GetKeyGeneration();
+    if (keyIndexGeneration_ == generation) {
+        return;
+    }
+    auto keyHashes = keystore_->GetKeyHashes();
+    keyIndex_.Reset(keyHashes.size());
+    for (const Hash160& keyHash : keyHashes) {
+        keyIndex_.Insert(keyHash);
+    }
+    keyIndexGeneration_ = generation;
+}
+
+void Wallet::NoteDerivedKey(const Hash160& keyHash, uint64_t generationBefore) {
+    // A key from the keypool is already indexed; one derived on demand is
+    // added if the wallet is free, otherwise the next use rebuilds the index
+    if (keystore_->GetKeyGeneration() == generationBefore) {
+        return;
+    }
+    std::unique_lock<std::recursive_mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+    // Only if the index was current and this derivation was the one change
+    if (keyIndexGeneration_ == generationBefore &&
+        keystore_->GetKeyGeneration() == generationBefore + 1) {
+        keyIndex_.Insert(keyHash);
+        keyIndexGeneration_ = generationBefore + 1;
+    }
+}
+
 void Wallet::ProcessWalletTransaction(const TransactionRef& tx, int32_t height) {
     const auto& hash = tx->GetHash();
     
@@ -1204,6 +2069,7 @@ void Wallet::ProcessWalletTransaction(const TransactionRef& tx, int32_t height)
     
     if (isRelevant) {
         transactions_[hash] = wtx;
+        LogTransaction(hash, wtx);
         EmitEvent(WalletEvent::NewTransaction, BytesToHex(hash.data(), hash.size()));
         EmitEvent(WalletEvent::BalanceChanged);
     }
@@ -1219,21 +2085,96 @@ void Wallet::AddOutput(const OutPoint& outpoint, const TxOut& txout, int32_t hei
     if (keyHash) {
         wo.keyHash = *keyHash;
     }
+    wo.watchOnly = keystore_ && keystore_->IsWatchOnly(wo.keyHash);
     
-    outputs_[outpoint] = wo;
+    // Seen again when it confirms: replace the unconfirmed entry
+    auto it = outputs_.find(outpoint);
+    if (it != outputs_.end()) {
+        TallyOutput(it->second, false);
+        it->second = wo;
+    } else {
+        it = outputs_.emplace(outpoint, wo).first;
+    }
+    TallyOutput(it->second, true);
+    LogOutput(it->second);
     EmitEvent(WalletEvent::OutputReceived, outpoint.ToString());
 }
 
 void Wallet::SpendOutput(const OutPoint& outpoint, const TxHash& spendingTx) {
     auto it = outputs_.find(outpoint);
     if (it != outputs_.end()) {
+        TallyOutput(it->second, false);
         it->second.status = OutputStatus::Spent;
+        LogOutput(it->second);
         EmitEvent(WalletEvent::OutputSpent, outpoint.ToString());
     }
 }
 
+void Wallet::TallyOutput(const WalletOutput& output, bool add) {
+    ++version_;
+    if (output.status == OutputStatus::Spent) {
+        return;
+    }
+    Amount value = add ? output.GetValue() : -output.GetValue();
+    
+    if (output.status != OutputStatus::Locked && output.status != OutputStatus::Frozen) {
+        auto key = std::make_pair(output.GetValue(), output.outpoint);
+        if (add) {
+            spendable_.emplace(key, &output);
+            spendableByKey_[output.keyHash].emplace(key, &output);
+        } else {
+            spendable_.erase(key);
+            auto byKey = spendableByKey_.find(output.keyHash);
+            if (byKey != spendableByKey_.end()) {
+                byKey->second.erase(key);
+                if (byKey->second.empty()) {
+                    spendableByKey_.erase(byKey);
+                }
+            }
+        }
+    }
+    
+    auto bucket = unspentByHeight_.emplace(output.height, 0).first;
+    bucket->second += value;
+    if (bucket->second == 0) {
+        unspentByHeight_.erase(bucket);
+    }
+    
+    if (output.status == OutputStatus::Locked) {
+        balance_.locked += value;
+    } else if (output.coinbase) {
+        auto tally = coinbaseByHeight_.emplace(output.height, CoinbaseTally()).first;
+        (output.watchOnly ? tally->second.watchOnly : tally->second.own) += value;
+        (output.watchOnly ? coinbaseTotal_.watchOnly : coinbaseTotal_.own) += value;
+        if (tally->second.own == 0 && tally->second.watchOnly == 0) {
+            coinbaseByHeight_.erase(tally);
+        }
+    } else if (output.height < 0) {
+        (output.watchOnly ? balance_.watchOnlyUnconfirmed : balance_.unconfirmed) += value;
+    } else {
+        (output.watchOnly ? balance_.watchOnlyConfirmed : balance_.confirmed) += value;
+    }
+}
+
 void Wallet::UpdateBalance() {
-    // Balance is calculated on demand in GetBalance()
+    balance_ = WalletBalance();
+    coinbaseTotal_ = CoinbaseTally();
+    coinbaseByHeight_.clear();
+    unspentByHeight_.clear();
+    spendable_.clear();
+    spendableByKey_.clear();
+    for (auto& [outpoint, output] : outputs_) {
+        output.watchOnly = keystore_ && keystore_->IsWatchOnly(output.keyHash);
+        TallyOutput(output, true);
+    }
+}
+
+WalletBalance Wallet::PublishBalance() const {
+    WalletBalance balance = ComputeBalance();
+    std::lock_guard<std::mutex> viewLock(viewMutex_);
+    balanceView_ = balance;
+    balanceVersion_ = version_.load();
+    return balance;
 }
 
 Amount Wallet::CalculateFee(const MutableTransaction& tx) const {
@@ -1263,12 +2204,7 @@ std::vector<Byte> Wallet::SerializeWalletData() const {
     Serialize(stream, WALLET_DATA_VERSION);
     
     // Config
-    Serialize(stream, config_.name);
-    Serialize(stream, config_.gapLimit);
-    Serialize(stream, static_cast<int64_t>(config_.defaultFeeRate));
-    Serialize(stream, config_.minChange);
-    Serialize(stream, config_.testnet);
-    Serialize(stream, config_.autoLockTimeout);
+    WriteConfig(stream, config_);
     
     // Chain height
     Serialize(stream, chainHeight_.load());
@@ -1276,79 +2212,15 @@ std::vector<Byte> Wallet::SerializeWalletData() const {
     // === Serialize Outputs (UTXOs) ===
     uint32_t outputCount = static_cast<uint32_t>(outputs_.size());
     Serialize(stream, outputCount);
-    
     for (const auto& [outpoint, output] : outputs_) {
-        // OutPoint
-        Serialize(stream, outpoint);
-        
-        // TxOut
-        Serialize(stream, output.txout);
-        
-        // Metadata
-        Serialize(stream, output.height);
-        Serialize(stream, output.coinbase);
-        Serialize(stream, output.timeReceived);
-        Serialize(stream, static_cast<uint8_t>(output.status));
-        Serialize(stream, output.keyHash);
-        
-        // Optional derivation path
-        bool hasPath = output.keyPath.has_value();
-        Serialize(stream, hasPath);
-        if (hasPath) {
-            Serialize(stream, output.keyPath->ToString());
-        }
-        
-        Serialize(stream, output.label);
+        WriteOutput(stream, output);
     }
     
     // === Serialize Transactions ===
     uint32_t txCount = static_cast<uint32_t>(transactions_.size());
     Serialize(stream, txCount);
-    
     for (const auto& [hash, wtx] : transactions_) {
-        // Transaction hash (key)
-        Serialize(stream, hash);
-        
-        // Serialize the transaction if we have it
-        bool hasTx = (wtx.tx != nullptr);
-        Serialize(stream, hasTx);
-        if (hasTx) {
-            // Serialize as MutableTransaction then convert
-            MutableTransaction mtx(*wtx.tx);
-            Serialize(stream, mtx);
-        }
-        
-        // Confirmation info
-        Serialize(stream, wtx.confirmation.blockHeight);
-        Serialize(stream, wtx.confirmation.blockHash);
-        Serialize(stream, wtx.confirmation.txIndex);
-        Serialize(stream, wtx.confirmation.blockTime);
-        
-        // Timestamps
-        Serialize(stream, wtx.timeReceived);
-        Serialize(stream, wtx.timeCreated);
-        
-        // Flags
-        Serialize(stream, wtx.fromMe);
-        
-        // Our inputs/outputs indices - serialize as uint32_t for cross-platform compatibility
-        uint32_t inputCount = static_cast<uint32_t>(wtx.ourInputs.size());
-        Serialize(stream, inputCount);
-        for (size_t idx : wtx.ourInputs) {
-            uint32_t idx32 = static_cast<uint32_t>(idx);
-            Serialize(stream, idx32);
-        }
-        
-        uint32_t outputCount = static_cast<uint32_t>(wtx.ourOutputs.size());
-        Serialize(stream, outputCount);
-        for (size_t idx : wtx.ourOutputs) {
-            uint32_t idx32 = static_cast<uint32_t>(idx);
-            Serialize(stream, idx32);
-        }
-        
-        // Fee and label
-        Serialize(stream, wtx.fee);
-        Serialize(stream, wtx.label);
+        WriteTransaction(stream, hash, wtx);
     }
     
     // === Serialize Locked Outputs ===
@@ -1360,18 +2232,15 @@ std::vector<Byte> Wallet::SerializeWalletData() const {
     }
     
     // === Serialize Address Book ===
+    std::shared_lock<std::shared_mutex> bookLock(addressBookMutex_);
     uint32_t addressBookCount = static_cast<uint32_t>(addressBook_.size());
     Serialize(stream, addressBookCount);
-    
     for (const auto& [address, entry] : addressBook_) {
-        Serialize(stream, entry.address);
-        Serialize(stream, entry.label);
-        Serialize(stream, entry.purpose);
-        Serialize(stream, entry.created);
+        WriteAddressEntry(stream, entry);
     }
     
     // Return the serialized data
-    return std::vector<Byte>(stream.begin(), stream.end());
+    return ToBytes(stream);
 }
 
 bool Wallet::DeserializeWalletData(const std::vector<Byte>& data) {
@@ -1390,14 +2259,7 @@ bool Wallet::DeserializeWalletData(const std::vector<Byte>& data) {
         }
         
         // Config
-        Unserialize(stream, config_.name);
-        Unserialize(stream, config_.gapLimit);
-        int64_t feeRate;
-        Unserialize(stream, feeRate);
-        config_.defaultFeeRate = static_cast<FeeRate>(feeRate);
-        Unserialize(stream, config_.minChange);
-        Unserialize(stream, config_.testnet);
-        Unserialize(stream, config_.autoLockTimeout);
+        ReadConfig(stream, config_);
         
         // Chain height
         int32_t height;
@@ -1406,39 +2268,17 @@ bool Wallet::DeserializeWalletData(const std::vector<Byte>& data) {
         
         // === Deserialize Outputs ===
         outputs_.clear();
+        UpdateBalance();
         uint32_t outputCount;
         Unserialize(stream, outputCount);
         
         for (uint32_t i = 0; i < outputCount; ++i) {
-            OutPoint outpoint;
-            Unserialize(stream, outpoint);
-            
             WalletOutput output;
-            output.outpoint = outpoint;
-            
-            Unserialize(stream, output.txout);
-            Unserialize(stream, output.height);
-            Unserialize(stream, output.coinbase);
-            Unserialize(stream, output.timeReceived);
-            
-            uint8_t status;
-            Unserialize(stream, status);
-            output.status = static_cast<OutputStatus>(status);
-            
-            Unserialize(stream, output.keyHash);
-            
-            bool hasPath;
-            Unserialize(stream, hasPath);
-            if (hasPath) {
-                std::string pathStr;
-                Unserialize(stream, pathStr);
-                output.keyPath = DerivationPath::FromString(pathStr);
-            }
-            
-            Unserialize(stream, output.label);
-            
+            ReadOutput(stream, output);
+            OutPoint outpoint = output.outpoint;
             outputs_[outpoint] = std::move(output);
         }
+        UpdateBalance();
         
         // === Deserialize Transactions ===
         transactions_.clear();
@@ -1447,51 +2287,8 @@ bool Wallet::DeserializeWalletData(const std::vector<Byte>& data) {
         
         for (uint32_t i = 0; i < txCount; ++i) {
             TxHash hash;
-            Unserialize(stream, hash);
-            
             WalletTransaction wtx;
-            
-            bool hasTx;
-            Unserialize(stream, hasTx);
-            if (hasTx) {
-                MutableTransaction mtx;
-                Unserialize(stream, mtx);
-                wtx.tx = std::make_shared<Transaction>(mtx);
-            }
-            
-            Unserialize(stream, wtx.confirmation.blockHeight);
-            Unserialize(stream, wtx.confirmation.blockHash);
-            Unserialize(stream, wtx.confirmation.txIndex);
-            Unserialize(stream, wtx.confirmation.blockTime);
-            
-            Unserialize(stream, wtx.timeReceived);
-            Unserialize(stream, wtx.timeCreated);
-            Unserialize(stream, wtx.fromMe);
-            
-            // Deserialize our inputs/outputs indices
-            uint32_t inputCount;
-            Unserialize(stream, inputCount);
-            wtx.ourInputs.clear();
-            wtx.ourInputs.reserve(inputCount);
-            for (uint32_t j = 0; j < inputCount; ++j) {
-                uint32_t idx;
-                Unserialize(stream, idx);
-                wtx.ourInputs.push_back(static_cast<size_t>(idx));
-            }
-            
-            uint32_t outputIndicesCount;
-            Unserialize(stream, outputIndicesCount);
-            wtx.ourOutputs.clear();
-            wtx.ourOutputs.reserve(outputIndicesCount);
-            for (uint32_t j = 0; j < outputIndicesCount; ++j) {
-                uint32_t idx;
-                Unserialize(stream, idx);
-                wtx.ourOutputs.push_back(static_cast<size_t>(idx));
-            }
-            
-            Unserialize(stream, wtx.fee);
-            Unserialize(stream, wtx.label);
-            
+            ReadTransaction(stream, hash, wtx);
             transactions_[hash] = std::move(wtx);
         }
         
@@ -1513,11 +2310,7 @@ bool Wallet::DeserializeWalletData(const std::vector<Byte>& data) {
         
         for (uint32_t i = 0; i < addressBookCount; ++i) {
             AddressBookEntry entry;
-            Unserialize(stream, entry.address);
-            Unserialize(stream, entry.label);
-            Unserialize(stream, entry.purpose);
-            Unserialize(stream, entry.created);
-            
+            ReadAddressEntry(stream, entry);
             addressBook_[entry.address] = std::move(entry);
         }
         
@@ -1529,6 +2322,249 @@ bool Wallet::DeserializeWalletData(const std::vector<Byte>& data) {
     }
 }
 
+// ============================================================================
+// Wallet Log
+// ============================================================================
+
+bool Wallet::OpenLog(const std::string& path) {
+    std::string dataPath = GetWalletDataPath(path);
+    auto log = std::make_unique<WalletLog>();
+    
+    if (WalletLog::IsLogFile(dataPath)) {
+        outputs_.clear();
+        transactions_.clear();
+        lockedOutputs_.clear();
+        addressBook_.clear();
+        bool opened = log->Open(dataPath, [this](WalletRecord type, const std::vector<Byte>& payload) {
+            ApplyLogRecord(type, payload);
+        });
+        UpdateBalance();
+        if (!opened) {
+            return false;
+        }
+    } else {
+        // A snapshot from before the log, or nothing yet: start a log from it
+        std::vector<Byte> walletData = util::fs::ReadFileBytes(util::fs::Path(dataPath));
+        if (!walletData.empty()) {
+            DeserializeWalletData(walletData);
+        }
+        if (!log->Rewrite(dataPath, [this](const WalletLog::RecordSink& sink) { WriteSnapshot(sink); })) {
+            return false;
+        }
+    }
+    
+    ++version_;
+    std::lock_guard<std::mutex> lock(logMutex_);
+    log_ = std::move(log);
+    return true;
+}
+
+void Wallet::WriteSnapshot(const WalletLog::RecordSink& sink) const {
+    DataStream stream;
+    auto emit = [&sink, &stream](WalletRecord type) {
+        sink(type, ToBytes(stream));
+        stream.clear();
+    };
+    
+    WriteConfig(stream, config_);
+    emit(WalletRecord::META);
+    Serialize(stream, chainHeight_.load());
+    emit(WalletRecord::HEIGHT);
+    if (keystore_) {
+        for (const auto& [chain, next] : keystore_->GetHDKeyIndices()) {
+            Serialize(stream, chain.first);
+            Serialize(stream, chain.second);
+            Serialize(stream, next);
+            emit(WalletRecord::HD_INDEX);
+        }
+    }
+    for (const auto& [outpoint, output] : outputs_) {
+        WriteOutput(stream, output);
+        emit(WalletRecord::OUTPUT);
+    }
+    for (const auto& [hash, wtx] : transactions_) {
+        WriteTransaction(stream, hash, wtx);
+        emit(WalletRecord::TX);
+    }
+    for (const auto& outpoint : lockedOutputs_) {
+        Serialize(stream, outpoint);
+        emit(WalletRecord::LOCK);
+    }
+    for (const auto& [address, entry] : addressBook_) {
+        WriteAddressEntry(stream, entry);
+        emit(WalletRecord::ADDRESS);
+    }
+}
+
+void Wallet::ApplyLogRecord(WalletRecord type, const std::vector<Byte>& payload) {
+    // A record this version cannot read is skipped, not fatal
+    try {
+        DataStream stream(payload);
+        switch (type) {
+            case WalletRecord::META:
+                ReadConfig(stream, config_);
+                break;
+            case WalletRecord::HEIGHT: {
+                int32_t height;
+                Unserialize(stream, height);
+                chainHeight_.store(height);
+                break;
+            }
+            case WalletRecord::OUTPUT: {
+                WalletOutput output;
+                ReadOutput(stream, output);
+                OutPoint outpoint = output.outpoint;
+                outputs_[outpoint] = std::move(output);
+                break;
+            }
+            case WalletRecord::OUTPUT_ERASE: {
+                OutPoint outpoint;
+                Unserialize(stream, outpoint);
+                outputs_.erase(outpoint);
+                break;
+            }
+            case WalletRecord::TX: {
+                TxHash hash;
+                WalletTransaction wtx;
+                ReadTransaction(stream, hash, wtx);
+                transactions_[hash] = std::move(wtx);
+                break;
+            }
+            case WalletRecord::TX_ERASE: {
+                TxHash hash;
+                Unserialize(stream, hash);
+                transactions_.erase(hash);
+                break;
+            }
+            case WalletRecord::LOCK:
+            case WalletRecord::UNLOCK: {
+                OutPoint outpoint;
+                Unserialize(stream, outpoint);
+                if (type == WalletRecord::LOCK) {
+                    lockedOutputs_.insert(outpoint);
+                } else {
+                    lockedOutputs_.erase(outpoint);
+                }
+                break;
+            }
+            case WalletRecord::ADDRESS: {
+                AddressBookEntry entry;
+                ReadAddressEntry(stream, entry);
+                addressBook_[entry.address] = std::move(entry);
+                break;
+            }
+            case WalletRecord::HD_INDEX: {
+                uint32_t account, change, next;
+                Unserialize(stream, account);
+                Unserialize(stream, change);
+                Unserialize(stream, next);
+                if (keystore_) {
+                    keystore_->AdvanceHDKeyIndices({{{account, change}, next}});
+                }
+                break;
+            }
+        }
+    } catch (const std::exception&) {
+    }
+}
+
+void Wallet::LogRecord(WalletRecord type, const DataStream& payload) {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    if (log_) {
+        log_->Append(type, ToBytes(payload));
+    }
+}
+
+void Wallet::LogOutput(const WalletOutput& output) {
+    if (log_) {
+        DataStream stream;
+        WriteOutput(stream, output);
+        LogRecord(WalletRecord::OUTPUT, stream);
+    }
+}
+
+void Wallet::LogOutputErased(const OutPoint& outpoint) {
+    if (log_) {
+        DataStream stream;
+        Serialize(stream, outpoint);
+        LogRecord(WalletRecord::OUTPUT_ERASE, stream);
+    }
+}
+
+void Wallet::LogTransaction(const TxHash& hash, const WalletTransaction& wtx) {
+    ++version_;
+    if (log_) {
+        DataStream stream;
+        WriteTransaction(stream, hash, wtx);
+        LogRecord(WalletRecord::TX, stream);
+    }
+}
+
+void Wallet::LogTransactionErased(const TxHash& hash) {
+    ++version_;
+    if (log_) {
+        DataStream stream;
+        Serialize(stream, hash);
+        LogRecord(WalletRecord::TX_ERASE, stream);
+    }
+}
+
+void Wallet::LogLockedOutput(const OutPoint& outpoint, bool locked) {
+    if (log_) {
+        DataStream stream;
+        Serialize(stream, outpoint);
+        LogRecord(locked ? WalletRecord::LOCK : WalletRecord::UNLOCK, stream);
+    }
+}
+
+void Wallet::LogAddressEntry(const AddressBookEntry& entry) {
+    DataStream stream;
+    WriteAddressEntry(stream, entry);
+    LogRecord(WalletRecord::ADDRESS, stream);
+}
+
+void Wallet::LogChainHeight() {
+    ++version_;
+    if (log_) {
+        DataStream stream;
+        Serialize(stream, chainHeight_.load());
+        LogRecord(WalletRecord::HEIGHT, stream);
+    }
+}
+
+void Wallet::LogHDIndex(uint32_t account, uint32_t change) {
+    if (!keystore_) {
+        return;
+    }
+    auto indices = keystore_->GetHDKeyIndices();
+    auto it = indices.find({account, change});
+    if (it != indices.end()) {
+        DataStream stream;
+        Serialize(stream, account);
+        Serialize(stream, change);
+        Serialize(stream, it->second);
+        LogRecord(WalletRecord::HD_INDEX, stream);
+    }
+}
+
+bool Wallet::CommitLog(bool sync) {
+    std::shared_lock<std::shared_mutex> bookLock(addressBookMutex_);
+    std::lock_guard<std::mutex> logLock(logMutex_);
+    if (!log_) {
+        return true;
+    }
+    if (log_->NeedsCompaction()) {
+        return log_->Rewrite(log_->GetPath(),
+                             [this](const WalletLog::RecordSink& sink) { WriteSnapshot(sink); });
+    }
+    return log_->Flush(sync);
+}
+
+bool Wallet::FlushLog() {
+    std::lock_guard<std::mutex> lock(logMutex_);
+    return !log_ || log_->Flush(false);
+}
+
 // ============================================================================
 // Utility Functions
 // ============================================================================
@@ -0,0 +1,224 @@
+// SHURIUM - Wallet Record Log Implementation
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <shurium/wallet/walletlog.h>
+#include <shurium/crypto/siphash.h>
+#include <shurium/util/fs.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace shurium {
+namespace wallet {
+
+namespace {
+
+/// File header: magic, then the format version
+constexpr Byte LOG_MAGIC[4] = {'S', 'H', 'W', 'L'};
+constexpr size_t HEADER_SIZE = 8;
+
+/// Length and type before the payload, checksum after it
+constexpr size_t RECORD_OVERHEAD = 4 + 1 + 4;
+
+/// Fixed checksum key; the checksum guards against torn writes, not forgery
+constexpr uint64_t CHECKSUM_K0 = 0x5348574c6f673031ULL;
+constexpr uint64_t CHECKSUM_K1 = 0x7265636f72647321ULL;
+
+void WriteLE32(std::vector<Byte>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<Byte>(value >> (8 * i)));
+    }
+}
+
+uint32_t ReadLE32(const Byte* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint32_t Checksum(const Byte* data, size_t len) {
+    return static_cast<uint32_t>(SipHash24(CHECKSUM_K0, CHECKSUM_K1, data, len));
+}
+
+std::vector<Byte> Header() {
+    std::vector<Byte> header(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC));
+    WriteLE32(header, WALLET_LOG_VERSION);
+    return header;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// WalletLog
+// ============================================================================
+
+WalletLog::~WalletLog() {
+    Close();
+}
+
+bool WalletLog::IsLogFile(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    Byte magic[sizeof(LOG_MAGIC)];
+    bool isLog = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 std::memcmp(magic, LOG_MAGIC, sizeof(magic)) == 0;
+    std::fclose(file);
+    return isLog;
+}
+
+bool WalletLog::Open(const std::string& path, const Replay& replay) {
+    Close();
+
+    std::vector<Byte> data = util::fs::ReadFileBytes(util::fs::Path(path));
+    if (data.size() < HEADER_SIZE ||
+        std::memcmp(data.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 ||
+        ReadLE32(data.data() + sizeof(LOG_MAGIC)) > WALLET_LOG_VERSION) {
+        return false;
+    }
+
+    // Replay up to the first record that is cut short or fails its checksum
+    size_t offset = HEADER_SIZE;
+    uint64_t records = 0;
+    std::vector<Byte> payload;
+    while (data.size() - offset >= RECORD_OVERHEAD) {
+        uint32_t len = ReadLE32(data.data() + offset);
+        if (len > MAX_WALLET_LOG_RECORD || data.size() - offset - RECORD_OVERHEAD < len) {
+            break;
+        }
+        const Byte* body = data.data() + offset + 4;
+        if (Checksum(body, 1 + len) != ReadLE32(body + 1 + len)) {
+            break;
+        }
+        payload.assign(body + 1, body + 1 + len);
+        replay(static_cast<WalletRecord>(body[0]), payload);
+        offset += RECORD_OVERHEAD + len;
+        ++records;
+    }
+
+    if (offset < data.size() && !util::fs::ResizeFile(util::fs::Path(path), offset)) {
+        return false;
+    }
+    if (!OpenForAppend(path, offset)) {
+        return false;
+    }
+    snapshotSize_ = offset;
+    records_ = records;
+    return true;
+}
+
+bool WalletLog::Rewrite(const std::string& path, const Snapshot& snapshot) {
+    std::vector<Byte> data = Header();
+    uint64_t records = 0;
+    snapshot([&data, &records](WalletRecord type, const std::vector<Byte>& payload) {
+        EncodeRecord(data, type, payload);
+        ++records;
+    });
+
+    // Write beside the log and rename over it: a crash leaves one or the other
+    std::string tmpPath = path + ".tmp";
+    if (!util::fs::SecureWriteFile(util::fs::Path(tmpPath), data.data(), data.size())) {
+        util::fs::RemoveFile(util::fs::Path(tmpPath));
+        return false;
+    }
+    Close();
+    if (!util::fs::Rename(util::fs::Path(tmpPath), util::fs::Path(path))) {
+        util::fs::RemoveFile(util::fs::Path(tmpPath));
+        return false;
+    }
+    if (!OpenForAppend(path, data.size())) {
+        return false;
+    }
+    snapshotSize_ = data.size();
+    records_ = records;
+    return true;
+}
+
+void WalletLog::Append(WalletRecord type, const std::vector<Byte>& payload) {
+    EncodeRecord(buffer_, type, payload);
+    ++records_;
+    if (buffer_.size() >= WALLET_LOG_BUFFER_BYTES) {
+        Flush(false);
+    }
+}
+
+bool WalletLog::Flush(bool sync) {
+    if (!file_) {
+        return false;
+    }
+    if (!buffer_.empty()) {
+        if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size() ||
+            std::fflush(file_) != 0) {
+            return false;
+        }
+        fileSize_ += buffer_.size();
+        unsynced_ += buffer_.size();
+        buffer_.clear();
+    }
+    if ((sync && unsynced_ > 0) || unsynced_ >= WALLET_LOG_SYNC_BYTES) {
+        return Sync();
+    }
+    return true;
+}
+
+void WalletLog::Close() {
+    if (!file_) {
+        return;
+    }
+    Flush(true);
+    std::fclose(file_);
+    file_ = nullptr;
+    buffer_.clear();
+    fileSize_ = 0;
+    unsynced_ = 0;
+}
+
+bool WalletLog::NeedsCompaction() const {
+    uint64_t grown = GetSize() - std::min(GetSize(), snapshotSize_);
+    return grown > std::max(snapshotSize_, WALLET_LOG_MIN_COMPACT_BYTES);
+}
+
+void WalletLog::EncodeRecord(std::vector<Byte>& out, WalletRecord type,
+                             const std::vector<Byte>& payload) {
+    WriteLE32(out, static_cast<uint32_t>(payload.size()));
+    size_t body = out.size();
+    out.push_back(static_cast<Byte>(type));
+    out.insert(out.end(), payload.begin(), payload.end());
+    WriteLE32(out, Checksum(out.data() + body, out.size() - body));
+}
+
+bool WalletLog::OpenForAppend(const std::string& path, uint64_t size) {
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_) {
+        return false;
+    }
+    path_ = path;
+    fileSize_ = size;
+    unsynced_ = 0;
+    return true;
+}
+
+bool WalletLog::Sync() {
+    if (std::fflush(file_) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    bool ok = _commit(_fileno(file_)) == 0;
+#else
+    bool ok = fsync(fileno(file_)) == 0;
+#endif
+    if (ok) {
+        unsynced_ = 0;
+    }
+    return ok;
+}
+
+} // namespace wallet
+} // namespace shurium
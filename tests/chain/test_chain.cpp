@@ -6,8 +6,24 @@
 #include "shurium/chain/coins.h"
 #include "shurium/chain/blockindex.h"
 #include "shurium/chain/chainstate.h"
+#include "shurium/chain/checkqueue.h"
+#include "shurium/core/compressor.h"
+#include "shurium/chain/reindex.h"
+#include "shurium/chain/txindexer.h"
+#include "shurium/chain/utxosnapshot.h"
+#include "shurium/consensus/params.h"
+#include "shurium/consensus/validation.h"
 #include "shurium/core/block.h"
 #include "shurium/core/transaction.h"
+#include "shurium/db/blockdb.h"
+#include "shurium/db/utxodb.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
 
 using namespace shurium;
 
@@ -249,6 +265,31 @@ TEST_F(CoinsViewCacheTest, GetCacheSize) {
     EXPECT_EQ(cache->GetCacheSize(), 2);
 }
 
+TEST_F(CoinsViewCacheTest, CacheUsageTracksAllocations) {
+    size_t emptyUsage = cache->GetCacheUsage();
+    
+    for (uint32_t i = 0; i < 2000; ++i) {
+        cache->AddCoin(OutPoint(outpoint1.hash, i), Coin(coin1), false);
+    }
+    
+    // Usage covers at least every node and every script
+    size_t usage = cache->GetCacheUsage();
+    EXPECT_GE(usage - emptyUsage,
+              2000 * (sizeof(std::pair<const OutPoint, CoinsCacheEntry>) +
+                      coin1.DynamicMemoryUsage()));
+    
+    // Spent fresh coins free their scripts; the pool keeps its chunks
+    for (uint32_t i = 0; i < 2000; ++i) {
+        EXPECT_TRUE(cache->SpendCoin(OutPoint(outpoint1.hash, i)));
+    }
+    EXPECT_EQ(cache->GetCacheSize(), 0u);
+    EXPECT_LT(cache->GetCacheUsage(), usage);
+    
+    // Reset releases the pool
+    cache->Reset();
+    EXPECT_LE(cache->GetCacheUsage(), emptyUsage);
+}
+
 TEST_F(CoinsViewCacheTest, Reset) {
     cache->AddCoin(outpoint1, Coin(coin1), false);
     BlockHash hash;
@@ -314,10 +355,11 @@ TEST_F(BlockIndexTest, DefaultConstructor) {
 
 TEST_F(BlockIndexTest, ConstructFromHeader) {
     BlockIndex index(testHeader);
-    EXPECT_EQ(index.nVersion, testHeader.nVersion);
+    EXPECT_EQ(index.GetVersion(), testHeader.nVersion);
     EXPECT_EQ(index.nTime, testHeader.nTime);
     EXPECT_EQ(index.nBits, testHeader.nBits);
-    EXPECT_EQ(index.nNonce, testHeader.nNonce);
+    EXPECT_EQ(index.GetNonce(), testHeader.nNonce);
+    EXPECT_EQ(index.GetMerkleRoot(), testHeader.hashMerkleRoot);
 }
 
 TEST_F(BlockIndexTest, GetBlockTime) {
@@ -393,16 +435,15 @@ protected:
             
             BlockHash hash = header.GetHash();
             
-            auto pindex = std::make_unique<BlockIndex>(header);
+            BlockIndex* pindex = blockMap.Insert(hash).first;
+            pindex->SetHeader(header);
             pindex->nHeight = i;
             
             if (!indices.empty()) {
                 pindex->pprev = indices.back();
             }
-            
-            auto [it, inserted] = blockMap.emplace(hash, std::move(pindex));
-            it->second->phashBlock = &it->first;
-            indices.push_back(it->second.get());
+            pindex->BuildSkip();
+            indices.push_back(pindex);
             
             prevHash = hash;
         }
@@ -473,6 +514,68 @@ TEST_F(ChainTest, FindFork) {
     EXPECT_EQ(fork, indices[3]);
 }
 
+TEST_F(ChainTest, SpansIndexChunks) {
+    BlockIndexArena arena;
+    std::vector<BlockIndex*> main;
+    BlockIndex* prev = nullptr;
+    for (int i = 0; i < Chain::CHUNK_SIZE + 100; ++i) {
+        BlockIndex* pindex = arena.Allocate();
+        pindex->pprev = prev;
+        pindex->nHeight = i;
+        pindex->BuildSkip();
+        main.push_back(pindex);
+        prev = pindex;
+    }
+    
+    Chain chain;
+    chain.SetTip(main.back());
+    EXPECT_EQ(chain[Chain::CHUNK_SIZE], main[Chain::CHUNK_SIZE]);
+    EXPECT_EQ(chain.Next(main[Chain::CHUNK_SIZE - 1]), main[Chain::CHUNK_SIZE]);
+    size_t visited = 0;
+    for (BlockIndex* pindex : chain) {
+        EXPECT_EQ(pindex, main[visited++]);
+    }
+    EXPECT_EQ(visited, main.size());
+    
+    // Shrinking drops the tail chunk; growing again sees no stale entries
+    size_t fullMemory = chain.DynamicMemoryUsage();
+    chain.SetTip(main[10]);
+    EXPECT_LT(chain.DynamicMemoryUsage(), fullMemory);
+    EXPECT_FALSE(chain.Contains(main[Chain::CHUNK_SIZE]));
+    chain.SetTip(main[Chain::CHUNK_SIZE + 50]);
+    EXPECT_EQ(chain.Height(), Chain::CHUNK_SIZE + 50);
+    EXPECT_TRUE(chain.Contains(main[Chain::CHUNK_SIZE + 50]));
+    EXPECT_FALSE(chain.Contains(main[Chain::CHUNK_SIZE + 60]));
+}
+
+TEST_F(ChainTest, FindForkDeepBranch) {
+    BlockIndexArena arena;
+    auto grow = [&arena](BlockIndex* prev, int count) {
+        std::vector<BlockIndex*> entries;
+        for (int i = 0; i < count; ++i) {
+            BlockIndex* pindex = arena.Allocate();
+            pindex->pprev = prev;
+            pindex->nHeight = prev ? prev->nHeight + 1 : 0;
+            pindex->BuildSkip();
+            entries.push_back(pindex);
+            prev = pindex;
+        }
+        return entries;
+    };
+    std::vector<BlockIndex*> main = grow(nullptr, 5000);
+    
+    Chain chain;
+    chain.SetTip(main.back());
+    for (int depth : {1, 31, 32, 33, 100, 4000, 4999}) {
+        BlockIndex* forkPoint = main[main.size() - 1 - depth];
+        BlockIndex* sideTip = grow(forkPoint, depth + 3).back();
+        EXPECT_EQ(chain.FindFork(sideTip), forkPoint) << "depth " << depth;
+    }
+    
+    // A block from another genesis shares nothing
+    EXPECT_EQ(chain.FindFork(grow(nullptr, 200).back()), nullptr);
+}
+
 TEST_F(ChainTest, Clear) {
     Chain chain;
     chain.SetTip(indices[5]);
@@ -520,6 +623,92 @@ TEST_F(ChainTest, LastCommonAncestor) {
     EXPECT_EQ(lca, indices[5]);
 }
 
+TEST_F(ChainTest, FindForkFromSideBranch) {
+    // Two blocks branching off height 4
+    BlockIndex* pprev = indices[4];
+    for (int i = 0; i < 2; ++i) {
+        BlockHeader header;
+        header.hashPrevBlock = pprev->GetBlockHash();
+        header.nTime = 1700000000 + (5 + i) * 30;
+        header.nBits = 0x1d00ffff;
+        header.nNonce = 1000 + i;
+        
+        BlockIndex* pindex = blockMap.Insert(header.GetHash()).first;
+        pindex->SetHeader(header);
+        pindex->pprev = pprev;
+        pindex->nHeight = pprev->nHeight + 1;
+        pindex->BuildSkip();
+        pprev = pindex;
+    }
+    
+    Chain chain;
+    chain.SetTip(indices[9]);
+    EXPECT_EQ(chain.FindFork(pprev), indices[4]);
+    EXPECT_EQ(LastCommonAncestor(pprev, indices[9]), indices[4]);
+    EXPECT_EQ(LastCommonAncestor(indices[9], pprev), indices[4]);
+    
+    // A side branch longer than the active chain
+    chain.SetTip(indices[5]);
+    EXPECT_EQ(chain.FindFork(pprev), indices[4]);
+}
+
+// ============================================================================
+// BlockMap Tests
+// ============================================================================
+
+TEST(BlockMapTest, EntriesStayPutAcrossChunks) {
+    BlockMap blockMap;
+    std::vector<std::pair<BlockHash, BlockIndex*>> entries;
+    
+    // Enough entries to spill into a second chunk
+    const size_t nEntries = BlockIndexArena::CHUNK_SIZE + 10;
+    for (size_t i = 0; i < nEntries; ++i) {
+        BlockHeader header;
+        header.nVersion = static_cast<int32_t>(i);
+        header.nNonce = static_cast<uint32_t>(i * 7);
+        header.nTime = static_cast<uint32_t>(i);
+        
+        BlockHash hash = header.GetHash();
+        auto [pindex, inserted] = blockMap.Insert(hash);
+        ASSERT_TRUE(inserted);
+        pindex->SetHeader(header);
+        pindex->nHeight = static_cast<int32_t>(i);
+        entries.emplace_back(hash, pindex);
+    }
+    
+    EXPECT_EQ(blockMap.size(), nEntries);
+    EXPECT_GE(blockMap.GetMemoryUsage(), nEntries * sizeof(BlockIndex));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& [hash, pindex] = entries[i];
+        ASSERT_EQ(blockMap.Lookup(hash), pindex);
+        EXPECT_EQ(pindex->GetBlockHash(), hash);
+        EXPECT_EQ(pindex->nHeight, static_cast<int32_t>(i));
+        EXPECT_EQ(pindex->GetVersion(), static_cast<int32_t>(i));
+        EXPECT_EQ(pindex->GetNonce(), static_cast<uint32_t>(i * 7));
+    }
+    
+    // Inserting again finds the existing entry
+    auto [pexisting, inserted] = blockMap.Insert(entries[0].first);
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(pexisting, entries[0].second);
+    
+    blockMap.clear();
+    EXPECT_TRUE(blockMap.empty());
+    EXPECT_EQ(blockMap.Lookup(entries[0].first), nullptr);
+}
+
+TEST(BlockMapTest, StandaloneEntriesOwnHeaderFields) {
+    BlockIndex standalone;
+    EXPECT_EQ(standalone.GetVersion(), 0);
+    BlockHeader header;
+    header.nVersion = 3;
+    standalone.SetHeader(header);
+    EXPECT_EQ(standalone.GetVersion(), 3);
+    
+    BlockIndex moved(std::move(standalone));
+    EXPECT_EQ(moved.GetVersion(), 3);
+}
+
 // ============================================================================
 // Utility Function Tests
 // ============================================================================
@@ -540,6 +729,77 @@ TEST(LocatorTest, GetLocator) {
     EXPECT_TRUE(locator.vHave.empty());
 }
 
+TEST(LocatorTest, EndsAtGenesis) {
+    std::vector<BlockIndex> chain(1000);
+    std::vector<BlockHash> hashes(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i) {
+        std::memcpy(hashes[i].data(), &i, sizeof(i));
+        chain[i].phashBlock = &hashes[i];
+        chain[i].nHeight = static_cast<int>(i);
+        chain[i].pprev = i > 0 ? &chain[i - 1] : nullptr;
+        chain[i].BuildSkip();
+    }
+    
+    BlockLocator locator = GetLocator(&chain.back());
+    ASSERT_FALSE(locator.vHave.empty());
+    EXPECT_EQ(locator.vHave.front(), hashes.back());
+    EXPECT_EQ(locator.vHave.back(), hashes.front());
+    
+    // Ten single steps, then doubling
+    ASSERT_GT(locator.vHave.size(), 12u);
+    EXPECT_EQ(locator.vHave[10], hashes[989]);
+    EXPECT_EQ(locator.vHave[11], hashes[988]);
+    EXPECT_EQ(locator.vHave[12], hashes[986]);
+    EXPECT_LT(locator.vHave.size(), 25u);
+}
+
+// ============================================================================
+// Skip List Tests
+// ============================================================================
+
+TEST(SkipListTest, SkipHeightIsBelowHeight) {
+    EXPECT_EQ(GetSkipHeight(0), 0);
+    EXPECT_EQ(GetSkipHeight(1), 0);
+    for (int height = 2; height < 100000; ++height) {
+        int skip = GetSkipHeight(height);
+        ASSERT_GE(skip, 0);
+        ASSERT_LT(skip, height);
+    }
+}
+
+/**
+ * Ancestor and retarget lookups over a long synthetic chain. Their cost
+ * against a pprev walk is timed by getancestor in shurium_bench_chain.
+ */
+TEST(SkipListTest, LookupsOnLongChainFindTheAncestor) {
+    const int nBlocks = 1 << 20;
+    std::vector<BlockIndex> chain(nBlocks);
+    for (int i = 0; i < nBlocks; ++i) {
+        chain[i].nHeight = i;
+        chain[i].nTime = 1700000000 + i * 30;
+        chain[i].nBits = 0x1e0fffff;
+        chain[i].pprev = i > 0 ? &chain[i - 1] : nullptr;
+        chain[i].BuildSkip();
+    }
+    
+    std::mt19937 rng(42);
+    for (int i = 0; i < 200; ++i) {
+        int from = static_cast<int>(rng() % nBlocks);
+        int to = static_cast<int>(rng() % (from + 1));
+        ASSERT_EQ(chain[from].GetAncestor(to), &chain[to]);
+    }
+    
+    EXPECT_EQ(chain.back().GetAncestor(-1), nullptr);
+    EXPECT_EQ(chain.front().GetAncestor(1), nullptr);
+    
+    // Retarget looks back one interval from the tip
+    auto params = consensus::Params::Main();
+    int interval = static_cast<int>(params.DifficultyAdjustmentInterval());
+    int retargetHeight = (nBlocks / interval) * interval - 1;
+    uint32_t nBits = consensus::GetNextWorkRequired(&chain[retargetHeight], params);
+    EXPECT_NE(nBits, 0u);
+}
+
 // ============================================================================
 // ChainStateManager Tests
 // ============================================================================
@@ -573,7 +833,7 @@ TEST_F(ChainStateManagerTest, AddBlockIndex) {
     
     BlockIndex* pindex = manager->AddBlockIndex(hash, header);
     ASSERT_NE(pindex, nullptr);
-    EXPECT_EQ(pindex->nVersion, 1);
+    EXPECT_EQ(pindex->GetVersion(), 1);
     EXPECT_EQ(pindex->nHeight, 0);
     EXPECT_EQ(pindex->pprev, nullptr);
     
@@ -675,6 +935,97 @@ TEST(BlockUndoTest, BlockUndo) {
     EXPECT_TRUE(blockundo.empty());
 }
 
+/// A block's worth of undo data with a typical mix of outputs
+static BlockUndo MakeTestBlockUndo() {
+    BlockUndo blockundo;
+    for (int i = 0; i < 20; ++i) {
+        TxUndo txundo;
+        Hash160 hash;
+        hash[0] = static_cast<uint8_t>(i);
+        hash[19] = 0xAB;
+        txundo.vprevout.push_back(
+            Coin(TxOut(50 * COIN, Script::CreateP2PKH(hash)), 1000 - i, i == 0));
+        txundo.vprevout.push_back(
+            Coin(TxOut(COIN / 100 * (i + 1), Script::CreateP2SH(hash)), 990, false));
+        Script other;
+        other << OP_TRUE;
+        txundo.vprevout.push_back(Coin(TxOut(123456789 + i, other), 7, false));
+        blockundo.vtxundo.push_back(std::move(txundo));
+    }
+    return blockundo;
+}
+
+TEST(BlockUndoTest, CompressAmountRoundTrip) {
+    EXPECT_EQ(CompressAmount(0), 0u);
+    EXPECT_EQ(CompressAmount(1), 1u);
+    EXPECT_EQ(CompressAmount(COIN), 9u);
+    EXPECT_EQ(CompressAmount(50 * COIN), 50u);
+    
+    const uint64_t values[] = {
+        1, 9, 10, 99, 100, 12345, COIN / 100, COIN, 50 * COIN, 123456789012,
+        static_cast<uint64_t>(MAX_MONEY), static_cast<uint64_t>(MAX_MONEY) - 1,
+    };
+    for (uint64_t value : values) {
+        EXPECT_EQ(DecompressAmount(CompressAmount(value)), value) << value;
+    }
+    for (uint64_t x = 0; x < 100000; ++x) {
+        EXPECT_EQ(CompressAmount(DecompressAmount(x)), x);
+    }
+}
+
+TEST(BlockUndoTest, CompressScriptTemplates) {
+    Hash160 hash;
+    hash[0] = 0x42;
+    Script p2pkh = Script::CreateP2PKH(hash);
+    Script p2sh = Script::CreateP2SH(hash);
+    Script other;
+    other << OP_TRUE;
+    PublicKey key = PrivateKey::Generate().GetPublicKey();
+    Script p2pk;
+    p2pk << key.GetCompressed().ToVector() << OP_CHECKSIG;
+    Script p2pkUncompressed;
+    p2pkUncompressed << key.GetUncompressed().ToVector() << OP_CHECKSIG;
+    
+    const std::pair<Script, size_t> cases[] = {
+        {p2pkh, 21}, {p2sh, 21}, {p2pk, 33}, {p2pkUncompressed, 33},
+        {other, 2}, {Script(), 1},
+    };
+    for (const auto& [script, size] : cases) {
+        DataStream ss;
+        SerializeCompressedScript(ss, script);
+        EXPECT_EQ(ss.size(), size);
+        Script decoded;
+        UnserializeCompressedScript(ss, decoded);
+        EXPECT_EQ(decoded, script);
+    }
+    
+    // An uncompressed key whose x coordinate is off the curve is rejected
+    DataStream offCurve;
+    WriteVarInt(offCurve, SCRIPT_TYPE_P2PK_UNCOMPRESSED);
+    const uint8_t zeroX[32] = {};
+    offCurve.Write(zeroX, sizeof(zeroX));
+    Script decoded;
+    EXPECT_THROW(UnserializeCompressedScript(offCurve, decoded), std::ios_base::failure);
+}
+
+TEST(BlockUndoTest, CompressedRoundTrip) {
+    BlockUndo blockundo = MakeTestBlockUndo();
+    
+    DataStream compressed;
+    SerializeCompressedUndo(compressed, blockundo);
+    DataStream legacy;
+    Serialize(legacy, blockundo);
+    EXPECT_LT(compressed.size(), legacy.size() * 3 / 4);
+    
+    BlockUndo decoded;
+    UnserializeCompressedUndo(compressed, decoded);
+    ASSERT_EQ(decoded.size(), blockundo.size());
+    for (size_t i = 0; i < blockundo.size(); ++i) {
+        EXPECT_EQ(decoded.vtxundo[i].vprevout, blockundo.vtxundo[i].vprevout);
+    }
+    EXPECT_TRUE(compressed.empty());
+}
+
 // ============================================================================
 // ConnectResult Tests
 // ============================================================================
@@ -734,3 +1085,1606 @@ TEST(OutPointHasherTest, DifferentHashes) {
     OutPoint op1_copy(hash1, 0);
     EXPECT_EQ(hasher(op1), hasher(op1_copy));
 }
+
+TEST(OutPointHasherTest, CraftedCollisionsSpread) {
+    // Outpoints that agree in the first 8 txid bytes and the index all
+    // collided under the old XOR hash; the salted hash must spread them
+    std::unordered_map<OutPoint, int, OutPointHasher> map;
+    for (int i = 0; i < 4096; ++i) {
+        TxHash hash;
+        hash[8] = static_cast<uint8_t>(i);
+        hash[9] = static_cast<uint8_t>(i >> 8);
+        map.emplace(OutPoint(hash, 0), i);
+    }
+    
+    size_t maxBucket = 0;
+    for (size_t b = 0; b < map.bucket_count(); ++b) {
+        maxBucket = std::max(maxBucket, map.bucket_size(b));
+    }
+    EXPECT_LT(maxBucket, 16u);
+}
+
+TEST(OutPointHasherTest, MapFindsEveryKey) {
+    // Lookup timing against the old XOR hash is outpoint-map-lookup in
+    // shurium_bench_crypto
+    constexpr int N = 200000;
+    std::vector<OutPoint> keys;
+    keys.reserve(N);
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < N; ++i) {
+        TxHash hash;
+        for (size_t j = 0; j < hash.size(); j += 8) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            std::memcpy(hash.data() + j, &x, 8);
+        }
+        keys.emplace_back(hash, static_cast<uint32_t>(i & 3));
+    }
+    
+    std::unordered_map<OutPoint, int, OutPointHasher> map;
+    for (int i = 0; i < N; ++i) {
+        map.emplace(keys[i], i);
+    }
+    size_t found = 0;
+    for (const auto& key : keys) {
+        found += map.count(key);
+    }
+    EXPECT_EQ(found, static_cast<size_t>(N));
+}
+
+// ============================================================================
+// Script Check Queue Tests
+// ============================================================================
+
+class CheckQueueTest : public ::testing::Test {
+protected:
+    TransactionRef ptx;
+    Coin passCoin;
+    Coin failCoin;
+    
+    void SetUp() override {
+        MutableTransaction mtx;
+        TxHash prevHash;
+        prevHash[0] = 0x42;
+        for (uint32_t i = 0; i < 8; ++i) {
+            mtx.vin.push_back(TxIn(OutPoint(prevHash, i)));
+        }
+        mtx.vout.push_back(TxOut(1 * COIN, Script()));
+        ptx = MakeTransactionRef(std::move(mtx));
+        
+        Script trueScript;
+        trueScript << OP_TRUE;
+        passCoin = Coin(TxOut(1 * COIN, trueScript), 1, false);
+        
+        Script falseScript;
+        falseScript << OP_FALSE;
+        failCoin = Coin(TxOut(1 * COIN, falseScript), 1, false);
+    }
+    
+    /// Build one check per input; the input at failIndex (if any) fails
+    std::vector<ScriptCheck> MakeChecks(size_t count, size_t failIndex = SIZE_MAX) {
+        std::vector<ScriptCheck> checks;
+        for (size_t i = 0; i < count; ++i) {
+            const Coin& coin = (i == failIndex) ? failCoin : passCoin;
+            checks.emplace_back(coin, *ptx, static_cast<unsigned int>(i % ptx->vin.size()),
+                                ScriptFlags::MANDATORY_VERIFY_FLAGS);
+        }
+        return checks;
+    }
+};
+
+TEST_F(CheckQueueTest, ScriptCheckPassAndFail) {
+    ScriptCheck pass(passCoin, *ptx, 0, ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    EXPECT_TRUE(pass());
+    EXPECT_EQ(pass.GetError(), ScriptError::OK);
+    
+    ScriptCheck fail(failCoin, *ptx, 0, ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    EXPECT_FALSE(fail());
+    EXPECT_NE(fail.GetError(), ScriptError::OK);
+}
+
+TEST_F(CheckQueueTest, ScriptCheckInputOutOfRange) {
+    ScriptCheck check(passCoin, *ptx, static_cast<unsigned int>(ptx->vin.size()),
+                      ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    EXPECT_FALSE(check());
+}
+
+TEST_F(CheckQueueTest, InlineControl) {
+    CheckQueueControl ok(nullptr);
+    ok.Add(MakeChecks(16));
+    EXPECT_TRUE(ok.Wait());
+    EXPECT_EQ(ok.GetError(), ScriptError::OK);
+    
+    CheckQueueControl bad(nullptr);
+    bad.Add(MakeChecks(16, 5));
+    EXPECT_FALSE(bad.Wait());
+    EXPECT_NE(bad.GetError(), ScriptError::OK);
+}
+
+TEST_F(CheckQueueTest, ParallelAllPass) {
+    CheckQueue queue(4, 8);
+    EXPECT_EQ(queue.GetWorkerCount(), 4u);
+    
+    CheckQueueControl control(&queue);
+    for (int i = 0; i < 10; ++i) {
+        control.Add(MakeChecks(37));
+    }
+    EXPECT_TRUE(control.Wait());
+}
+
+TEST_F(CheckQueueTest, ParallelFailure) {
+    CheckQueue queue(4, 8);
+    
+    CheckQueueControl control(&queue);
+    control.Add(MakeChecks(100));
+    control.Add(MakeChecks(100, 63));
+    control.Add(MakeChecks(100));
+    EXPECT_FALSE(control.Wait());
+    EXPECT_NE(control.GetError(), ScriptError::OK);
+}
+
+TEST_F(CheckQueueTest, QueueReusableAcrossBlocks) {
+    CheckQueue queue(2, 4);
+    
+    {
+        CheckQueueControl control(&queue);
+        control.Add(MakeChecks(20, 3));
+        EXPECT_FALSE(control.Wait());
+    }
+    {
+        CheckQueueControl control(&queue);
+        control.Add(MakeChecks(20));
+        EXPECT_TRUE(control.Wait());
+    }
+}
+
+TEST_F(CheckQueueTest, DestructorCancelsWithoutWait) {
+    CheckQueue queue(2, 4);
+    {
+        CheckQueueControl control(&queue);
+        control.Add(MakeChecks(64));
+        // Going out of scope must cancel and join cleanly
+    }
+    CheckQueueControl control(&queue);
+    control.Add(MakeChecks(8));
+    EXPECT_TRUE(control.Wait());
+}
+
+TEST_F(CheckQueueTest, CancelFailsWait) {
+    CheckQueue queue(2, 4);
+    CheckQueueControl control(&queue);
+    control.Add(MakeChecks(3));
+    control.Cancel();
+    EXPECT_FALSE(control.Wait());
+}
+
+TEST(ScriptCheckThreadsTest, Resolve) {
+    EXPECT_EQ(ResolveScriptCheckThreads(1), 1);
+    EXPECT_EQ(ResolveScriptCheckThreads(8), 8);
+    EXPECT_EQ(ResolveScriptCheckThreads(1000), MAX_SCRIPTCHECK_THREADS);
+    EXPECT_GE(ResolveScriptCheckThreads(0), 1);
+    EXPECT_GE(ResolveScriptCheckThreads(-1000), 1);
+}
+
+TEST(ScriptCheckThreadsTest, ChainStateManagerConfig) {
+    ChainStateManager manager(consensus::Params::RegTest());
+    EXPECT_EQ(manager.GetScriptCheckThreads(), 1);
+    
+    manager.SetScriptCheckThreads(4);
+    EXPECT_EQ(manager.GetScriptCheckThreads(), 4);
+    
+    manager.SetScriptCheckThreads(1);
+    EXPECT_EQ(manager.GetScriptCheckThreads(), 1);
+}
+
+// ============================================================================
+// Assume-Valid Tests
+// ============================================================================
+
+class AssumeValidTest : public ::testing::Test {
+protected:
+    std::unique_ptr<CoinsViewMemory> coinsDB;
+    std::unique_ptr<ChainStateManager> manager;
+    std::vector<BlockIndex*> headers;
+    Block block;
+    
+    void SetUp() override {
+        coinsDB = std::make_unique<CoinsViewMemory>();
+        manager = std::make_unique<ChainStateManager>(consensus::Params::RegTest());
+        manager->Initialize(coinsDB.get());
+        
+        // Header chain of three blocks
+        BlockHash prevHash;
+        for (int i = 0; i < 3; ++i) {
+            BlockHeader header;
+            header.nVersion = 1;
+            header.hashPrevBlock = prevHash;
+            header.nTime = 1700000000 + i * 30;
+            header.nBits = 0x207fffff;
+            header.nNonce = i;
+            headers.push_back(manager->ProcessBlockHeader(header));
+            prevHash = header.GetHash();
+        }
+        
+        // An output whose script can never be satisfied
+        TxHash prevTx;
+        prevTx[0] = 0x55;
+        Script falseScript;
+        falseScript << OP_FALSE;
+        manager->GetActiveChainState().GetCoins().AddCoin(
+            OutPoint(prevTx, 0), Coin(TxOut(10 * COIN, falseScript), 0, false), false);
+        
+        MutableTransaction coinbase;
+        coinbase.vin.push_back(TxIn(OutPoint()));
+        coinbase.vout.push_back(TxOut(50 * COIN, Script()));
+        
+        MutableTransaction spend;
+        spend.vin.push_back(TxIn(OutPoint(prevTx, 0)));
+        spend.vout.push_back(TxOut(9 * COIN, Script()));
+        
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+        block.vtx.push_back(MakeTransactionRef(std::move(spend)));
+    }
+    
+    ConnectResult Connect() {
+        BlockUndo undo;
+        return manager->GetActiveChainState().ConnectBlock(block, headers[1], undo);
+    }
+};
+
+TEST_F(AssumeValidTest, DisabledVerifiesScripts) {
+    EXPECT_TRUE(manager->GetAssumeValid().IsNull());
+    EXPECT_EQ(Connect(), ConnectResult::CONSENSUS_ERROR);
+}
+
+TEST_F(AssumeValidTest, AncestorSkipsScripts) {
+    manager->SetAssumeValid(headers[2]->GetBlockHash());
+    EXPECT_EQ(manager->GetActiveChainState().GetAssumeValid(), headers[2]->GetBlockHash());
+    
+    EXPECT_EQ(Connect(), ConnectResult::OK);
+    EXPECT_EQ(manager->GetActiveTip(), headers[1]);
+}
+
+TEST_F(AssumeValidTest, AssumeValidBlockItselfSkipsScripts) {
+    manager->SetAssumeValid(headers[1]->GetBlockHash());
+    EXPECT_EQ(Connect(), ConnectResult::OK);
+}
+
+TEST_F(AssumeValidTest, DescendantVerifiesScripts) {
+    manager->SetAssumeValid(headers[0]->GetBlockHash());
+    EXPECT_EQ(Connect(), ConnectResult::CONSENSUS_ERROR);
+}
+
+TEST_F(AssumeValidTest, UnknownHashVerifiesScripts) {
+    BlockHash unknown;
+    unknown[0] = 0x99;
+    manager->SetAssumeValid(unknown);
+    EXPECT_EQ(Connect(), ConnectResult::CONSENSUS_ERROR);
+}
+
+TEST_F(AssumeValidTest, FailedAssumeValidVerifiesScripts) {
+    headers[2]->nStatus = headers[2]->nStatus | BlockStatus::FAILED_VALID;
+    manager->SetAssumeValid(headers[2]->GetBlockHash());
+    EXPECT_EQ(Connect(), ConnectResult::CONSENSUS_ERROR);
+}
+
+// ============================================================================
+// Coin Prefetch Tests
+// ============================================================================
+
+class CoinPrefetchTest : public ::testing::Test {
+protected:
+    static constexpr int NUM_INPUTS = 20;
+    
+    std::unique_ptr<CoinsViewMemory> coinsDB;
+    std::unique_ptr<ChainStateManager> manager;
+    std::vector<OutPoint> dbOutpoints;
+    OutPoint inBlockOutpoint;
+    Block block;
+    
+    void SetUp() override {
+        coinsDB = std::make_unique<CoinsViewMemory>();
+        for (int i = 0; i < NUM_INPUTS; ++i) {
+            TxHash prevTx;
+            prevTx[0] = static_cast<uint8_t>(i + 1);
+            dbOutpoints.emplace_back(prevTx, 0);
+            coinsDB->AddCoin(dbOutpoints.back(), Coin(TxOut(COIN, Script()), 1, false));
+        }
+        
+        manager = std::make_unique<ChainStateManager>(consensus::Params::RegTest());
+        manager->Initialize(coinsDB.get());
+        
+        MutableTransaction coinbase;
+        coinbase.vin.push_back(TxIn(OutPoint()));
+        coinbase.vout.push_back(TxOut(50 * COIN, Script()));
+        
+        // One transaction spending every database coin
+        MutableTransaction spend;
+        for (const auto& outpoint : dbOutpoints) {
+            spend.vin.push_back(TxIn(outpoint));
+        }
+        spend.vout.push_back(TxOut(NUM_INPUTS * COIN, Script()));
+        TransactionRef spendRef = MakeTransactionRef(std::move(spend));
+        inBlockOutpoint = OutPoint(spendRef->GetHash(), 0);
+        
+        // And a child spending an output created within the block
+        MutableTransaction child;
+        child.vin.push_back(TxIn(inBlockOutpoint));
+        child.vout.push_back(TxOut(COIN, Script()));
+        
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+        block.vtx.push_back(spendRef);
+        block.vtx.push_back(MakeTransactionRef(std::move(child)));
+    }
+    
+    size_t NumCached() const {
+        const auto& coins = manager->GetActiveChainState().GetCoins();
+        return std::count_if(dbOutpoints.begin(), dbOutpoints.end(),
+                             [&](const OutPoint& o) { return coins.HaveCoinInCache(o); });
+    }
+};
+
+TEST_F(CoinPrefetchTest, DisabledByDefault) {
+    EXPECT_EQ(manager->GetPrefetchThreads(), 0);
+    EXPECT_EQ(manager->PrefetchBlockInputs(block), 0u);
+    EXPECT_EQ(NumCached(), 0u);
+}
+
+TEST_F(CoinPrefetchTest, WarmsBlockInputs) {
+    manager->SetPrefetchThreads(3);
+    EXPECT_EQ(manager->GetPrefetchThreads(), 3);
+    
+    EXPECT_EQ(manager->PrefetchBlockInputs(block), static_cast<size_t>(NUM_INPUTS));
+    EXPECT_EQ(NumCached(), static_cast<size_t>(NUM_INPUTS));
+    EXPECT_FALSE(manager->GetActiveChainState().GetCoins().HaveCoinInCache(inBlockOutpoint));
+    
+    // Everything is cached now, so a second pass reads nothing
+    EXPECT_EQ(manager->PrefetchBlockInputs(block), 0u);
+}
+
+TEST_F(CoinPrefetchTest, NeverOverwritesCachedEntry) {
+    auto& coins = manager->GetActiveChainState().GetCoins();
+    ASSERT_TRUE(coins.SpendCoin(dbOutpoints[0]));
+    
+    EXPECT_FALSE(coins.WarmCoin(dbOutpoints[0], Coin(TxOut(COIN, Script()), 1, false)));
+    EXPECT_FALSE(coins.HaveCoin(dbOutpoints[0]));
+}
+
+TEST_F(CoinPrefetchTest, FlushDiscardsStaleReads) {
+    auto& chainstate = manager->GetActiveChainState();
+    std::vector<OutPoint> outpoints = dbOutpoints;
+    uint64_t generation = chainstate.FilterCachedCoins(outpoints);
+    EXPECT_EQ(outpoints.size(), static_cast<size_t>(NUM_INPUTS));
+    
+    std::vector<std::pair<OutPoint, Coin>> read;
+    read.emplace_back(outpoints[0], *coinsDB->GetCoin(outpoints[0]));
+    
+    chainstate.FlushStateToDisk();
+    EXPECT_EQ(chainstate.WarmCoins(std::move(read), generation), 0u);
+    EXPECT_EQ(NumCached(), 0u);
+}
+
+// ============================================================================
+// Background Flush Tests
+// ============================================================================
+
+class CoinsFlushTest : public ::testing::Test {
+protected:
+    CoinsViewMemory base;
+    
+    static OutPoint MakeOutPoint(uint8_t id) {
+        TxHash txid;
+        txid[0] = id;
+        return OutPoint(txid, 0);
+    }
+    
+    static Coin MakeCoin(Amount value = COIN) {
+        return Coin(TxOut(value, Script()), 1, false);
+    }
+};
+
+TEST_F(CoinsFlushTest, FlushWritesToBase) {
+    CoinsViewCache cache(&base);
+    OutPoint outpoint = MakeOutPoint(1);
+    cache.AddCoin(outpoint, MakeCoin(), false);
+    
+    BlockHash tip;
+    tip[0] = 0xAB;
+    cache.SetBestBlock(tip);
+    
+    ASSERT_TRUE(cache.Flush());
+    EXPECT_TRUE(base.HaveCoin(outpoint));
+    EXPECT_EQ(base.GetBestBlock(), tip);
+    
+    ASSERT_TRUE(cache.SpendCoin(outpoint));
+    ASSERT_TRUE(cache.Flush());
+    EXPECT_FALSE(base.HaveCoin(outpoint));
+}
+
+TEST_F(CoinsFlushTest, ReadsFallThroughToSnapshot) {
+    OutPoint spentBelow = MakeOutPoint(1);
+    base.AddCoin(spentBelow, MakeCoin());
+    
+    CoinsViewCache cache(&base);
+    OutPoint created = MakeOutPoint(2);
+    cache.AddCoin(created, MakeCoin(), false);
+    ASSERT_TRUE(cache.SpendCoin(spentBelow));
+    
+    auto snapshot = cache.BeginFlush();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_TRUE(cache.IsFlushing());
+    EXPECT_EQ(cache.BeginFlush(), nullptr);
+    EXPECT_EQ(snapshot->coins.size(), 2u);
+    
+    // Neither change has reached the base yet, but the cache still sees them
+    EXPECT_TRUE(cache.HaveCoin(created));
+    EXPECT_FALSE(cache.HaveCoin(spentBelow));
+    EXPECT_TRUE(base.HaveCoin(spentBelow));
+    EXPECT_FALSE(cache.WarmCoin(spentBelow, MakeCoin()));
+    
+    // The overlay keeps working while the snapshot is written
+    ASSERT_TRUE(cache.SpendCoin(created));
+    ASSERT_TRUE(base.BatchWrite(snapshot->coins, snapshot->bestBlock, snapshot->hashDelta));
+    cache.EndFlush(true);
+    EXPECT_FALSE(cache.IsFlushing());
+    
+    EXPECT_TRUE(base.HaveCoin(created));
+    EXPECT_FALSE(base.HaveCoin(spentBelow));
+    ASSERT_TRUE(cache.Flush());
+    EXPECT_FALSE(base.HaveCoin(created));
+}
+
+TEST_F(CoinsFlushTest, FailedWriteKeepsChanges) {
+    OutPoint spentBelow = MakeOutPoint(1);
+    base.AddCoin(spentBelow, MakeCoin());
+    
+    CoinsViewCache cache(&base);
+    ASSERT_TRUE(cache.SpendCoin(spentBelow));
+    
+    // Re-created in the overlay while the spend is in flight
+    ASSERT_NE(cache.BeginFlush(), nullptr);
+    cache.AddCoin(spentBelow, MakeCoin(2 * COIN), false);
+    cache.EndFlush(false);
+    
+    // Spending the overlay coin must still erase it from the base
+    ASSERT_TRUE(cache.SpendCoin(spentBelow));
+    ASSERT_TRUE(cache.Flush());
+    EXPECT_FALSE(base.HaveCoin(spentBelow));
+}
+
+TEST_F(CoinsFlushTest, RetainedFlushKeepsCoinsWarm) {
+    CoinsViewCache cache(&base);
+    OutPoint kept = MakeOutPoint(1);
+    OutPoint spent = MakeOutPoint(2);
+    cache.AddCoin(kept, MakeCoin(), false);
+    cache.AddCoin(spent, MakeCoin(), false);
+    
+    auto snapshot = cache.BeginFlush();
+    ASSERT_NE(snapshot, nullptr);
+    ASSERT_TRUE(base.BatchWrite(snapshot->coins, snapshot->bestBlock, snapshot->hashDelta));
+    cache.EndFlush(true, true);
+    
+    // Written coins come back clean, so the next flush has nothing to write
+    EXPECT_TRUE(cache.HaveCoinInCache(kept));
+    EXPECT_TRUE(cache.HaveCoinInCache(spent));
+    ASSERT_TRUE(cache.SpendCoin(spent));
+    snapshot = cache.BeginFlush();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->coins.size(), 1u);
+    ASSERT_TRUE(base.BatchWrite(snapshot->coins, snapshot->bestBlock, snapshot->hashDelta));
+    cache.EndFlush(true, true);
+    
+    // Spends do not come back
+    EXPECT_TRUE(cache.HaveCoinInCache(kept));
+    EXPECT_FALSE(cache.HaveCoinInCache(spent));
+    EXPECT_FALSE(base.HaveCoin(spent));
+}
+
+TEST_F(CoinsFlushTest, TrimDropsOldestCleanEntries) {
+    CoinsViewCache cache(&base);
+    for (uint8_t id = 1; id <= 3; ++id) {
+        base.AddCoin(MakeOutPoint(id), MakeCoin());
+        ASSERT_TRUE(cache.HaveCoin(MakeOutPoint(id)));
+    }
+    
+    // A new epoch: one old coin is used again and one new coin is dirty
+    BlockHash tip;
+    tip[0] = 0x01;
+    cache.SetBestBlock(tip);
+    EXPECT_EQ(cache.GetEpoch(), 1u);
+    ASSERT_TRUE(cache.HaveCoin(MakeOutPoint(3)));
+    OutPoint dirty = MakeOutPoint(4);
+    cache.AddCoin(dirty, MakeCoin(), false);
+    
+    EXPECT_EQ(cache.Trim(2 * COINS_MAP_POOL_BLOCK_SIZE), 2u);
+    EXPECT_FALSE(cache.HaveCoinInCache(MakeOutPoint(1)));
+    EXPECT_FALSE(cache.HaveCoinInCache(MakeOutPoint(2)));
+    EXPECT_TRUE(cache.HaveCoinInCache(MakeOutPoint(3)));
+    EXPECT_TRUE(cache.HaveCoinInCache(dirty));
+    
+    // A trim never loses changes, even when nothing clean fits
+    EXPECT_EQ(cache.Trim(0), 1u);
+    EXPECT_TRUE(cache.HaveCoinInCache(dirty));
+    ASSERT_TRUE(cache.Flush());
+    EXPECT_TRUE(base.HaveCoin(dirty));
+    EXPECT_TRUE(cache.HaveCoin(MakeOutPoint(1)));
+}
+
+TEST_F(CoinsFlushTest, ChildCacheMergesIntoParent) {
+    CoinsViewCache parent(&base);
+    OutPoint outpoint = MakeOutPoint(1);
+    {
+        CoinsViewCache child(&parent);
+        child.AddCoin(outpoint, MakeCoin(), false);
+        ASSERT_TRUE(child.Flush());
+    }
+    EXPECT_TRUE(parent.HaveCoinInCache(outpoint));
+    EXPECT_FALSE(base.HaveCoin(outpoint));
+    
+    {
+        CoinsViewCache child(&parent);
+        ASSERT_TRUE(child.SpendCoin(outpoint));
+        ASSERT_TRUE(child.Flush());
+    }
+    EXPECT_FALSE(parent.HaveCoin(outpoint));
+    EXPECT_EQ(parent.GetCacheSize(), 0u);
+}
+
+TEST_F(CoinsFlushTest, ChainStateBackgroundFlush) {
+    ChainStateManager manager(consensus::Params::RegTest());
+    manager.Initialize(&base);
+    auto& chainstate = manager.GetActiveChainState();
+    
+    OutPoint outpoint = MakeOutPoint(1);
+    chainstate.GetCoins().AddCoin(outpoint, MakeCoin(), false);
+    
+    ASSERT_TRUE(chainstate.FlushStateToDiskAsync());
+    EXPECT_TRUE(chainstate.HaveCoins(outpoint));
+    EXPECT_TRUE(chainstate.WaitForFlush());
+    EXPECT_FALSE(chainstate.IsFlushing());
+    EXPECT_TRUE(base.HaveCoin(outpoint));
+    
+    EXPECT_TRUE(chainstate.FlushStateToDisk());
+}
+
+// ============================================================================
+// UTXO Snapshot Tests
+// ============================================================================
+
+class UTXOSnapshotTest : public ::testing::Test {
+protected:
+    std::filesystem::path testDir;
+    std::unique_ptr<db::CoinsViewDB> sourceDB;
+    consensus::Params params = consensus::Params::RegTest();
+    BlockHash baseHash;
+    
+    void SetUp() override {
+        testDir = std::filesystem::temp_directory_path() /
+                  ("shurium_snapshot_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(testDir);
+        
+        sourceDB = std::make_unique<db::CoinsViewDB>(testDir / "source");
+        baseHash[0] = 0x42;
+        
+        // Enough coins for several chunks
+        CoinsMap coins;
+        MuHash3072 hashDelta;
+        for (uint32_t i = 0; i < UTXO_SNAPSHOT_CHUNK_COINS * 2 + 10; ++i) {
+            TxHash txid;
+            std::memcpy(txid.data(), &i, sizeof(i));
+            OutPoint outpoint(txid, i % 3);
+            CoinsCacheEntry entry(Coin(TxOut(COIN + i, Script()), 1 + i % 7, i % 5 == 0));
+            entry.SetDirty();
+            AddCoinToHash(hashDelta, outpoint, entry.coin);
+            coins.emplace(outpoint, std::move(entry));
+        }
+        ASSERT_TRUE(sourceDB->BatchWrite(coins, baseHash, hashDelta));
+    }
+    
+    void TearDown() override {
+        sourceDB.reset();
+        std::error_code ec;
+        std::filesystem::remove_all(testDir, ec);
+    }
+    
+    /// Dump the source database and trust the result in params
+    UTXOSnapshotResult DumpAndTrust(const std::filesystem::path& path) {
+        UTXOSnapshotResult dump = DumpUTXOSnapshot(*sourceDB, 10, params.strNetworkID, path);
+        if (dump.success) {
+            params.assumeUtxo.push_back({10, baseHash, dump.metadata.utxoSetHash,
+                                         dump.metadata.nCoins});
+        }
+        return dump;
+    }
+};
+
+TEST_F(UTXOSnapshotTest, DumpMatchesDatabaseHash) {
+    auto path = testDir / "utxo.dat";
+    UTXOSnapshotResult dump = DumpAndTrust(path);
+    ASSERT_TRUE(dump.success) << dump.error;
+    
+    EXPECT_EQ(dump.metadata.nCoins, UTXO_SNAPSHOT_CHUNK_COINS * 2 + 10);
+    EXPECT_EQ(dump.nChunks, 3u);
+    EXPECT_EQ(dump.metadata.baseBlockHash, baseHash);
+    EXPECT_EQ(dump.metadata.utxoSetHash, db::CalculateUTXOSetHash(*sourceDB));
+    EXPECT_FALSE(std::filesystem::exists(path.string() + ".incomplete"));
+    
+    UTXOSnapshotResult header = ReadUTXOSnapshotHeader(path);
+    ASSERT_TRUE(header.success) << header.error;
+    EXPECT_EQ(header.metadata.baseHeight, 10);
+    EXPECT_EQ(header.metadata.network, "regtest");
+    
+    // An existing file is never overwritten
+    EXPECT_FALSE(DumpUTXOSnapshot(*sourceDB, 10, params.strNetworkID, path).success);
+}
+
+TEST_F(UTXOSnapshotTest, LoadRoundTrip) {
+    auto path = testDir / "utxo.dat";
+    ASSERT_TRUE(DumpAndTrust(path).success);
+    
+    db::CoinsViewDB target(testDir / "target");
+    UTXOSnapshotResult load = LoadUTXOSnapshot(path, params, target);
+    ASSERT_TRUE(load.success) << load.error;
+    
+    EXPECT_EQ(target.GetBestBlock(), baseHash);
+    EXPECT_EQ(db::CalculateUTXOSetHash(target), db::CalculateUTXOSetHash(*sourceDB));
+    
+    MuHash3072 sourceHash, targetHash;
+    ASSERT_TRUE(sourceDB->GetUTXOHashState(sourceHash));
+    ASSERT_TRUE(target.GetUTXOHashState(targetHash));
+    EXPECT_EQ(targetHash.Finalize(), sourceHash.Finalize());
+    
+    TxHash txid;
+    uint32_t i = 5;
+    std::memcpy(txid.data(), &i, sizeof(i));
+    auto coin = target.GetCoin(OutPoint(txid, i % 3));
+    ASSERT_TRUE(coin.has_value());
+    EXPECT_EQ(coin->GetAmount(), COIN + 5);
+    EXPECT_TRUE(coin->IsCoinBase());
+    
+    // A loaded database is not empty any more
+    EXPECT_FALSE(LoadUTXOSnapshot(path, params, target).success);
+}
+
+TEST_F(UTXOSnapshotTest, RejectsUntrustedSnapshot) {
+    auto path = testDir / "utxo.dat";
+    ASSERT_TRUE(DumpAndTrust(path).success);
+    
+    consensus::Params untrusted = consensus::Params::RegTest();
+    EXPECT_FALSE(VerifyUTXOSnapshot(path, untrusted).success);
+    
+    consensus::Params wrongHash = params;
+    wrongHash.assumeUtxo[0].utxoSetHash[0] ^= 0x01;
+    EXPECT_FALSE(VerifyUTXOSnapshot(path, wrongHash).success);
+    
+    db::CoinsViewDB target(testDir / "target");
+    EXPECT_FALSE(LoadUTXOSnapshot(path, untrusted, target).success);
+    EXPECT_TRUE(target.GetBestBlock().IsNull());
+    EXPECT_EQ(target.ForEachCoin([](const OutPoint&, const Coin&) { return true; }), 0u);
+}
+
+TEST_F(UTXOSnapshotTest, RejectsCorruptedChunk) {
+    auto path = testDir / "utxo.dat";
+    ASSERT_TRUE(DumpAndTrust(path).success);
+    EXPECT_TRUE(VerifyUTXOSnapshot(path, params).success);
+    
+    // Flip a byte in the middle of the file, inside a chunk payload
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        auto offset = static_cast<std::streamoff>(std::filesystem::file_size(path) / 2);
+        file.seekg(offset);
+        char byte = 0;
+        file.read(&byte, 1);
+        byte ^= 0x5a;
+        file.seekp(offset);
+        file.write(&byte, 1);
+    }
+    
+    UTXOSnapshotResult verify = VerifyUTXOSnapshot(path, params);
+    EXPECT_FALSE(verify.success);
+    EXPECT_NE(verify.error.find("checksum"), std::string::npos) << verify.error;
+}
+
+// ============================================================================
+// Rolling UTXO Set Hash Tests
+// ============================================================================
+
+class RollingUTXOHashTest : public ::testing::Test {
+protected:
+    CoinsViewMemory base;
+    
+    static OutPoint MakeOutPoint(uint8_t id, uint32_t n = 0) {
+        TxHash txid;
+        txid[0] = id;
+        return OutPoint(txid, n);
+    }
+    
+    static Coin MakeCoin(Amount value = COIN) {
+        return Coin(TxOut(value, Script()), 1, false);
+    }
+    
+    /// Hash of the given coins computed from scratch
+    static Hash256 HashOf(const std::vector<std::pair<OutPoint, Coin>>& coins) {
+        MuHash3072 hash;
+        for (const auto& [outpoint, coin] : coins) {
+            AddCoinToHash(hash, outpoint, coin);
+        }
+        return hash.Finalize();
+    }
+};
+
+TEST_F(RollingUTXOHashTest, TracksAddsAndSpends) {
+    base.AddCoin(MakeOutPoint(1), MakeCoin(1 * COIN));
+    base.AddCoin(MakeOutPoint(2), MakeCoin(2 * COIN));
+    
+    CoinsViewCache cache(&base);
+    EXPECT_EQ(cache.GetRollingUTXOSetHash(),
+              HashOf({{MakeOutPoint(1), MakeCoin(1 * COIN)},
+                      {MakeOutPoint(2), MakeCoin(2 * COIN)}}));
+    
+    ASSERT_TRUE(cache.SpendCoin(MakeOutPoint(1)));
+    cache.AddCoin(MakeOutPoint(3), MakeCoin(3 * COIN), false);
+    cache.AddCoin(MakeOutPoint(4), MakeCoin(4 * COIN), false);
+    ASSERT_TRUE(cache.SpendCoin(MakeOutPoint(4)));  // Created and spent in the cache
+    
+    Hash256 expected = HashOf({{MakeOutPoint(2), MakeCoin(2 * COIN)},
+                               {MakeOutPoint(3), MakeCoin(3 * COIN)}});
+    EXPECT_EQ(cache.GetRollingUTXOSetHash(), expected);
+    
+    ASSERT_TRUE(cache.Flush());
+    EXPECT_EQ(cache.GetRollingUTXOSetHash(), expected);
+    MuHash3072 baseHash;
+    ASSERT_TRUE(base.GetUTXOHashState(baseHash));
+    EXPECT_EQ(baseHash.Finalize(), expected);
+}
+
+TEST_F(RollingUTXOHashTest, OverwriteReplacesCoin) {
+    CoinsViewCache cache(&base);
+    cache.AddCoin(MakeOutPoint(1), MakeCoin(1 * COIN), false);
+    cache.AddCoin(MakeOutPoint(1), MakeCoin(5 * COIN), true);
+    EXPECT_EQ(cache.GetRollingUTXOSetHash(), HashOf({{MakeOutPoint(1), MakeCoin(5 * COIN)}}));
+}
+
+TEST_F(RollingUTXOHashTest, SurvivesFailedAndChildFlushes) {
+    CoinsViewCache parent(&base);
+    parent.AddCoin(MakeOutPoint(1), MakeCoin(), false);
+    
+    {
+        CoinsViewCache child(&parent);
+        ASSERT_TRUE(child.SpendCoin(MakeOutPoint(1)));
+        child.AddCoin(MakeOutPoint(2), MakeCoin(), false);
+        ASSERT_TRUE(child.Flush());
+    }
+    Hash256 expected = HashOf({{MakeOutPoint(2), MakeCoin()}});
+    EXPECT_EQ(parent.GetRollingUTXOSetHash(), expected);
+    
+    // A flush whose write never happened keeps its changes
+    auto snapshot = parent.BeginFlush();
+    ASSERT_TRUE(snapshot);
+    parent.AddCoin(MakeOutPoint(3), MakeCoin(), false);
+    parent.EndFlush(false);
+    EXPECT_EQ(parent.GetRollingUTXOSetHash(),
+              HashOf({{MakeOutPoint(2), MakeCoin()}, {MakeOutPoint(3), MakeCoin()}}));
+    
+    parent.Reset();
+    EXPECT_EQ(parent.GetRollingUTXOSetHash(), MuHash3072().Finalize());
+}
+
+TEST_F(RollingUTXOHashTest, ChainStateMatchesAfterBackgroundFlush) {
+    ChainStateManager manager(consensus::Params::RegTest());
+    manager.Initialize(&base);
+    auto& chainstate = manager.GetActiveChainState();
+    
+    chainstate.GetCoins().AddCoin(MakeOutPoint(1), MakeCoin(), false);
+    ASSERT_TRUE(chainstate.FlushStateToDiskAsync());
+    chainstate.GetCoins().AddCoin(MakeOutPoint(2), MakeCoin(), false);
+    
+    EXPECT_EQ(chainstate.GetRollingUTXOSetHash(),
+              HashOf({{MakeOutPoint(1), MakeCoin()}, {MakeOutPoint(2), MakeCoin()}}));
+}
+
+// ============================================================================
+// Reindex Tests
+// ============================================================================
+
+/// A mined regtest chain; its first block stands in for genesis. Pass the
+/// parent and its height plus a salt to mine a branch with distinct txids.
+static std::vector<Block> MineRegTestChain(const consensus::Params& params, int nBlocks,
+                                           BlockHash prevHash = BlockHash(),
+                                           int startHeight = 0, int64_t salt = 0) {
+    std::vector<Block> chain;
+    for (int height = startHeight; height < startHeight + nBlocks; ++height) {
+        MutableTransaction coinbase;
+        coinbase.vin.push_back(TxIn(OutPoint()));
+        coinbase.vin[0].scriptSig << static_cast<int64_t>(height) << salt;
+        coinbase.vout.push_back(TxOut(50 * COIN, Script()));
+        
+        Block block;
+        block.nVersion = 1;
+        block.hashPrevBlock = prevHash;
+        block.nTime = 1700000000 + height * 30;
+        block.nBits = 0x207fffff;
+        block.vtx.push_back(MakeTransactionRef(std::move(coinbase)));
+        block.hashMerkleRoot = block.ComputeMerkleRoot();
+        for (consensus::ValidationState state;
+             !consensus::CheckBlock(block, state, params);
+             state = consensus::ValidationState()) {
+            ++block.nNonce;
+        }
+        prevHash = block.GetHash();
+        chain.push_back(std::move(block));
+    }
+    return chain;
+}
+
+class ReindexTest : public ::testing::Test {
+protected:
+    std::filesystem::path testDir;
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain;
+    
+    void SetUp() override {
+        testDir = std::filesystem::temp_directory_path() /
+                  ("shurium_reindex_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(testDir);
+        
+        chain = MineRegTestChain(params, 12);
+        params.hashGenesisBlock = chain[0].GetHash();
+    }
+    
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(testDir, ec);
+    }
+    
+    /// Store blocks in the given order, spread over several small files
+    void WriteBlockFiles(const std::vector<const Block*>& blocks) {
+        db::BlockDB blockDB(testDir);
+        blockDB.SetMaxBlockFileSize(1024);
+        for (const Block* block : blocks) {
+            db::DiskBlockPos pos;
+            ASSERT_TRUE(blockDB.WriteBlock(*block, pos).ok());
+        }
+    }
+    
+    /// Reindex into a fresh chain state manager
+    ReindexStats Reindex(ChainStateManager& manager, CoinsViewMemory& coins,
+                         db::BlockDB& blockDB, const ReindexOptions& options,
+                         bool* success = nullptr) {
+        manager.SetBlockDB(&blockDB);
+        manager.Initialize(&coins);
+        BlockReindexer reindexer(manager, blockDB, options);
+        bool ok = reindexer.Run();
+        if (success) {
+            *success = ok;
+        }
+        return reindexer.GetStats();
+    }
+};
+
+TEST_F(ReindexTest, RebuildsChainFromBlockFiles) {
+    std::vector<const Block*> blocks;
+    for (const auto& block : chain) {
+        blocks.push_back(&block);
+    }
+    WriteBlockFiles(blocks);
+    
+    db::BlockDB blockDB(testDir);
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    ReindexOptions options;
+    options.readBufferSize = 100;  // smaller than a block: records straddle reads
+    options.nCheckThreads = 3;
+    options.maxInFlight = 4;
+    bool success = false;
+    ReindexStats stats = Reindex(manager, coins, blockDB, options, &success);
+    
+    EXPECT_TRUE(success);
+    EXPECT_GT(stats.nFiles, 1);
+    EXPECT_EQ(stats.nBlocksRead, chain.size());
+    EXPECT_EQ(stats.nBlocksChecked, chain.size());
+    EXPECT_EQ(stats.nBlocksProcessed, chain.size());
+    EXPECT_EQ(stats.nBlocksInvalid, 0u);
+    EXPECT_EQ(stats.nBytesRead, stats.nTotalBytes);
+    EXPECT_DOUBLE_EQ(stats.Progress(), 1.0);
+    EXPECT_EQ(stats.nCheckQueueDepth, 0u);
+    EXPECT_EQ(stats.nFeedQueueDepth, 0u);
+    EXPECT_EQ(stats.nOutOfOrderDepth, 0u);
+    
+    ASSERT_EQ(manager.GetActiveHeight(), static_cast<int>(chain.size()) - 1);
+    EXPECT_EQ(manager.GetActiveTip()->GetBlockHash(), chain.back().GetHash());
+    
+    // The index points at the existing records; nothing was written again
+    const BlockIndex* tip = manager.GetActiveTip();
+    Block read;
+    ASSERT_TRUE(blockDB.ReadBlock(db::DiskBlockPos(tip->nFile, tip->nDataPos), read).ok());
+    EXPECT_EQ(read.GetHash(), chain.back().GetHash());
+    EXPECT_EQ(blockDB.GetBlockDiskUsage(), stats.nTotalBytes);
+}
+
+TEST_F(ReindexTest, OutOfOrderBlocksWaitForParent) {
+    // Children stored before their parents
+    std::vector<const Block*> blocks;
+    for (size_t i = 0; i + 1 < chain.size(); i += 2) {
+        blocks.push_back(&chain[i + 1]);
+        blocks.push_back(&chain[i]);
+    }
+    WriteBlockFiles(blocks);
+    
+    db::BlockDB blockDB(testDir);
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    ReindexStats stats = Reindex(manager, coins, blockDB, ReindexOptions());
+    
+    EXPECT_EQ(stats.nBlocksProcessed, chain.size());
+    EXPECT_EQ(stats.nBlocksOrphaned, 0u);
+    EXPECT_EQ(manager.GetActiveHeight(), static_cast<int>(chain.size()) - 1);
+}
+
+TEST_F(ReindexTest, SkipsInvalidAndOrphanedBlocks) {
+    Block badMerkle = chain[3];
+    badMerkle.hashMerkleRoot[0] ^= 1;
+    
+    // chain[5] goes missing, so everything after it has no parent
+    std::vector<const Block*> blocks;
+    for (size_t i = 0; i < chain.size(); ++i) {
+        if (i == 3) {
+            blocks.push_back(&badMerkle);
+        }
+        if (i != 5) {
+            blocks.push_back(&chain[i]);
+        }
+    }
+    WriteBlockFiles(blocks);
+    
+    // Garbage between records is skipped over
+    {
+        std::ofstream out(testDir / "blocks" / "blk00000.dat", std::ios::binary | std::ios::app);
+        out << "not a block record";
+    }
+    
+    db::BlockDB blockDB(testDir);
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    ReindexStats stats = Reindex(manager, coins, blockDB, ReindexOptions());
+    
+    EXPECT_EQ(stats.nBlocksInvalid, 1u);
+    EXPECT_EQ(stats.nBlocksProcessed, 5u);
+    EXPECT_EQ(stats.nBlocksOrphaned, chain.size() - 6);
+    EXPECT_EQ(manager.GetActiveHeight(), 4);
+}
+
+TEST_F(ReindexTest, NewBlocksAppendAfterExistingFiles) {
+    std::vector<const Block*> blocks;
+    for (size_t i = 0; i + 1 < chain.size(); ++i) {
+        blocks.push_back(&chain[i]);
+    }
+    WriteBlockFiles(blocks);
+    
+    db::BlockDB blockDB(testDir);
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    Reindex(manager, coins, blockDB, ReindexOptions());
+    
+    // A block arriving after the reindex must not overwrite stored ones
+    ASSERT_TRUE(manager.ProcessNewBlock(chain.back()));
+    for (const auto& block : chain) {
+        const BlockIndex* pindex = manager.LookupBlockIndex(block.GetHash());
+        ASSERT_NE(pindex, nullptr);
+        Block read;
+        ASSERT_TRUE(blockDB.ReadBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos), read).ok());
+        EXPECT_EQ(read.GetHash(), block.GetHash());
+    }
+}
+
+TEST_F(ReindexTest, RecordsBlockHeightsInFileInfo) {
+    std::vector<const Block*> blocks;
+    for (const auto& block : chain) {
+        blocks.push_back(&block);
+    }
+    WriteBlockFiles(blocks);
+    
+    db::BlockDB blockDB(testDir);
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    ReindexStats stats = Reindex(manager, coins, blockDB, ReindexOptions());
+    
+    // Heights are relearned, which is what pruning goes by
+    const auto& files = blockDB.GetBlockFileInfo();
+    ASSERT_EQ(files.size(), static_cast<size_t>(stats.nFiles));
+    uint32_t nBlocks = 0;
+    for (size_t i = 0; i + 1 < files.size(); ++i) {
+        EXPECT_LT(files[i].nHeightLast, files[i + 1].nHeightFirst);
+    }
+    for (const auto& info : files) {
+        nBlocks += info.nBlocks;
+    }
+    EXPECT_EQ(nBlocks, chain.size());
+    EXPECT_EQ(files.back().nHeightLast, static_cast<int>(chain.size()) - 1);
+}
+
+// ============================================================================
+// Block Pipeline Tests
+// ============================================================================
+
+TEST(BlockPipelineTest, ProcessNewBlocksConnectsInOrder) {
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain = MineRegTestChain(params, 40);
+    params.hashGenesisBlock = chain[0].GetHash();
+    
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    manager.SetBlockCheckThreads(3);
+    EXPECT_EQ(manager.GetBlockCheckThreads(), 3);
+    manager.Initialize(&coins);
+    
+    EXPECT_EQ(manager.ProcessNewBlocks(chain), chain.size());
+    ASSERT_EQ(manager.GetActiveHeight(), static_cast<int>(chain.size()) - 1);
+    EXPECT_EQ(manager.GetActiveTip()->GetBlockHash(), chain.back().GetHash());
+}
+
+TEST(BlockPipelineTest, ProcessNewBlocksStopsAtInvalidBlock) {
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain = MineRegTestChain(params, 30);
+    params.hashGenesisBlock = chain[0].GetHash();
+    
+    // A wrong merkle root fails CheckBlock; the header itself stays valid
+    chain[20].hashMerkleRoot[0] ^= 1;
+    while (!consensus::CheckProofOfWork(chain[20].GetHash(), chain[20].nBits, params)) {
+        ++chain[20].nNonce;
+    }
+    
+    for (int nThreads : {0, 2}) {
+        CoinsViewMemory coins;
+        ChainStateManager manager(params);
+        manager.SetBlockCheckThreads(nThreads);
+        manager.Initialize(&coins);
+        
+        EXPECT_EQ(manager.ProcessNewBlocks(chain), 20u);
+        EXPECT_EQ(manager.GetActiveHeight(), 19);
+        const BlockIndex* pbad = manager.LookupBlockIndex(chain[20].GetHash());
+        ASSERT_NE(pbad, nullptr);
+        EXPECT_TRUE(pbad->IsFailed());
+        EXPECT_EQ(manager.LookupBlockIndex(chain[21].GetHash()), nullptr);
+    }
+}
+
+// ============================================================================
+// Reorganization Tests
+// ============================================================================
+
+class ReorgTest : public ::testing::Test {
+protected:
+    std::filesystem::path testDir;
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain;
+    std::unique_ptr<db::BlockDB> blockDB;
+    CoinsViewMemory coins;
+    std::unique_ptr<ChainStateManager> manager;
+    
+    void SetUp() override {
+        testDir = std::filesystem::temp_directory_path() /
+                  ("shurium_reorg_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(testDir);
+        
+        chain = MineRegTestChain(params, 7);
+        params.hashGenesisBlock = chain[0].GetHash();
+        
+        blockDB = std::make_unique<db::BlockDB>(testDir);
+        manager = std::make_unique<ChainStateManager>(params);
+        manager->SetBlockDB(blockDB.get());
+        manager->SetPrefetchThreads(2);
+        manager->Initialize(&coins);
+        ASSERT_TRUE(manager->ProcessNewBlock(chain[0]));
+        
+        // Connect the rest for real, so it has undo data to disconnect with
+        for (size_t i = 1; i < chain.size(); ++i) {
+            Store(chain[i]);
+        }
+        ASSERT_TRUE(manager->Reorganize(Lookup(chain.back())));
+    }
+    
+    void TearDown() override {
+        manager.reset();
+        blockDB.reset();
+        std::error_code ec;
+        std::filesystem::remove_all(testDir, ec);
+    }
+    
+    BlockIndex* Lookup(const Block& block) {
+        return manager->LookupBlockIndex(block.GetHash());
+    }
+    
+    /// Write a block out and index it without activating it
+    void Store(const Block& block) {
+        BlockIndex* pindex = manager->ProcessBlockHeader(block.GetBlockHeader());
+        ASSERT_NE(pindex, nullptr);
+        db::DiskBlockPos pos;
+        ASSERT_TRUE(blockDB->WriteBlock(block, pos, pindex->nHeight).ok());
+        pindex->nFile = pos.nFile;
+        pindex->nDataPos = pos.nPos;
+        pindex->nStatus = pindex->nStatus | BlockStatus::HAVE_DATA;
+        pindex->nTx = static_cast<uint32_t>(block.vtx.size());
+        pindex->RaiseValidity(BlockStatus::VALID_TRANSACTIONS);
+    }
+    
+    bool HaveCoinbase(const Block& block) {
+        return manager->GetActiveChainState().HaveCoins(OutPoint(block.vtx[0]->GetHash(), 0));
+    }
+};
+
+TEST_F(ReorgTest, ConnectsWithUndoData) {
+    EXPECT_EQ(manager->GetActiveTip(), Lookup(chain.back()));
+    for (size_t i = 1; i < chain.size(); ++i) {
+        EXPECT_TRUE(HaveCoinbase(chain[i]));
+        EXPECT_TRUE(Lookup(chain[i])->HaveUndo());
+    }
+    
+    ReorgMetrics metrics = manager->GetReorgMetrics();
+    EXPECT_EQ(metrics.nReorgs, 1u);
+    EXPECT_EQ(metrics.last.nDisconnected, 0);
+    EXPECT_EQ(metrics.last.nConnected, static_cast<int>(chain.size()) - 1);
+}
+
+TEST_F(ReorgTest, SwitchesToHeavierBranchInOneBatch) {
+    // Five blocks off height 3 outweigh the three above it
+    auto branch = MineRegTestChain(params, 5, chain[3].GetHash(), 4, 1);
+    for (const auto& block : branch) {
+        Store(block);
+    }
+    ASSERT_TRUE(manager->ActivateBestChain());
+    
+    EXPECT_EQ(manager->GetActiveTip(), Lookup(branch.back()));
+    for (int i = 1; i <= 3; ++i) {
+        EXPECT_TRUE(HaveCoinbase(chain[i]));
+    }
+    for (size_t i = 4; i < chain.size(); ++i) {
+        EXPECT_FALSE(HaveCoinbase(chain[i]));
+    }
+    for (const auto& block : branch) {
+        EXPECT_TRUE(HaveCoinbase(block));
+    }
+    EXPECT_EQ(manager->GetActiveChainState().GetCoins().GetBestBlock(), branch.back().GetHash());
+    
+    ReorgMetrics metrics = manager->GetReorgMetrics();
+    EXPECT_EQ(metrics.nReorgs, 2u);
+    EXPECT_EQ(metrics.last.forkHeight, 3);
+    EXPECT_EQ(metrics.last.nDisconnected, 3);
+    EXPECT_EQ(metrics.last.nConnected, 5);
+    EXPECT_GE(metrics.maxMicros, metrics.last.TotalMicros());
+    
+    // And back again once the old chain is heavier
+    auto extension = MineRegTestChain(params, 3, chain.back().GetHash(), 7, 2);
+    for (const auto& block : extension) {
+        Store(block);
+    }
+    ASSERT_TRUE(manager->ActivateBestChain());
+    EXPECT_EQ(manager->GetActiveTip(), Lookup(extension.back()));
+    EXPECT_TRUE(HaveCoinbase(chain[5]));
+    EXPECT_FALSE(HaveCoinbase(branch[0]));
+}
+
+TEST_F(ReorgTest, AnnouncesDisconnectedAndConnectedBlocks) {
+    std::vector<std::pair<bool, int>> events;
+    manager->RegisterBlockConnected([&](const Block& block, const BlockIndex* pindex) {
+        EXPECT_EQ(block.GetHash(), pindex->GetBlockHash());
+        events.emplace_back(true, pindex->nHeight);
+    });
+    manager->RegisterBlockDisconnected([&](const Block& block, const BlockIndex* pindex) {
+        EXPECT_EQ(block.GetHash(), pindex->GetBlockHash());
+        events.emplace_back(false, pindex->nHeight);
+    });
+
+    auto branch = MineRegTestChain(params, 5, chain[3].GetHash(), 4, 1);
+    for (const auto& block : branch) {
+        Store(block);
+    }
+    ASSERT_TRUE(manager->ActivateBestChain());
+
+    // Old tip down to the fork, then the new branch up to its tip, once each
+    std::vector<std::pair<bool, int>> expected = {
+        {false, 6}, {false, 5}, {false, 4},
+        {true, 4}, {true, 5}, {true, 6}, {true, 7}, {true, 8}};
+    EXPECT_EQ(events, expected);
+
+    // The tip was announced by the reorganization, not again on acceptance
+    events.clear();
+    EXPECT_TRUE(manager->ProcessNewBlock(branch.back(), true));
+    EXPECT_TRUE(events.empty());
+}
+
+TEST_F(ReorgTest, FailedBranchLeavesChainUntouched) {
+    // The branch's first block spends a coin that does not exist
+    auto branch = MineRegTestChain(params, 1, chain[3].GetHash(), 4, 3);
+    MutableTransaction spend;
+    spend.vin.push_back(TxIn(OutPoint(TxHash(), 7)));
+    spend.vout.push_back(TxOut(COIN, Script()));
+    branch[0].vtx.push_back(MakeTransactionRef(std::move(spend)));
+    branch[0].hashMerkleRoot = branch[0].ComputeMerkleRoot();
+    while (!consensus::CheckProofOfWork(branch[0].GetHash(), branch[0].nBits, params)) {
+        ++branch[0].nNonce;
+    }
+    auto tail = MineRegTestChain(params, 4, branch[0].GetHash(), 5, 3);
+    branch.insert(branch.end(), tail.begin(), tail.end());
+    for (const auto& block : branch) {
+        Store(block);
+    }
+    
+    EXPECT_FALSE(manager->ActivateBestChain());
+    EXPECT_EQ(manager->GetActiveTip(), Lookup(chain.back()));
+    for (size_t i = 1; i < chain.size(); ++i) {
+        EXPECT_TRUE(HaveCoinbase(chain[i]));
+    }
+    EXPECT_TRUE(Lookup(branch[0])->IsFailed());
+    EXPECT_TRUE(Lookup(branch.back())->IsFailed());
+    EXPECT_EQ(manager->GetReorgMetrics().nFailed, 1u);
+    
+    // The failed branch is not picked up again
+    EXPECT_TRUE(manager->ActivateBestChain());
+    EXPECT_EQ(manager->GetActiveTip(), Lookup(chain.back()));
+}
+
+TEST_F(ReorgTest, ReplayAgreesAcrossConnectPaths) {
+    // One longer chain block by block through ConnectBlock and in one batch
+    // through Reorganize must leave the same UTXO set (shurium_bench_connect
+    // --reorg times the batched path)
+    const int nBlocks = 200;
+    auto replay = MineRegTestChain(params, nBlocks, chain[0].GetHash(), 1, 3);
+    
+    CoinsViewMemory otherCoins;
+    ChainStateManager other(params);
+    ASSERT_TRUE(other.Initialize(&otherCoins));
+    ASSERT_NE(other.ProcessBlockHeader(chain[0].GetBlockHeader()), nullptr);
+    
+    // Like the fixture's chain, genesis spends and creates nothing
+    std::vector<BlockUndo> undos(replay.size());
+    for (size_t i = 0; i < replay.size(); ++i) {
+        BlockIndex* pindex = other.ProcessBlockHeader(replay[i].GetBlockHeader());
+        ASSERT_NE(pindex, nullptr);
+        ASSERT_EQ(other.GetActiveChainState().ConnectBlock(replay[i], pindex, undos[i]),
+                  ConnectResult::OK);
+    }
+    
+    for (const auto& block : replay) {
+        Store(block);
+    }
+    ASSERT_TRUE(manager->ActivateBestChain());
+    ReorgMetrics metrics = manager->GetReorgMetrics();
+    
+    EXPECT_EQ(manager->GetActiveTip(), Lookup(replay.back()));
+    EXPECT_EQ(other.GetActiveTip()->GetBlockHash(), replay.back().GetHash());
+    EXPECT_EQ(metrics.last.nConnected, nBlocks);
+    EXPECT_EQ(manager->GetActiveChainState().GetRollingUTXOSetHash(),
+              other.GetActiveChainState().GetRollingUTXOSetHash());
+    
+    // Both paths produce the same undo data
+    for (int i = 0; i < nBlocks; ++i) {
+        const BlockIndex* pindex = Lookup(replay[i]);
+        ASSERT_TRUE(pindex->HaveUndo());
+        BlockUndo stored;
+        ASSERT_TRUE(blockDB->ReadUndo(db::DiskBlockPos(pindex->nFile, pindex->nUndoPos), stored).ok());
+        EXPECT_EQ(stored.vtxundo.size(), undos[i].vtxundo.size());
+    }
+    
+    // Disconnecting the tip goes through the same engine
+    ASSERT_EQ(other.GetActiveChainState().DisconnectTip(replay.back(), undos.back()),
+              ConnectResult::OK);
+    EXPECT_EQ(other.GetActiveTip()->GetBlockHash(), replay[nBlocks - 2].GetHash());
+    EXPECT_FALSE(other.GetActiveChainState().HaveCoins(OutPoint(replay.back().vtx[0]->GetHash(), 0)));
+    EXPECT_EQ(otherCoins.GetBestBlock(), BlockHash());
+    EXPECT_EQ(other.GetActiveChainState().GetCoins().GetBestBlock(), replay[nBlocks - 2].GetHash());
+}
+
+// ============================================================================
+// Flush Policy Tests
+// ============================================================================
+
+class FlushPolicyTest : public ::testing::Test {
+protected:
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain;
+    CoinsViewMemory coins;
+    std::unique_ptr<ChainStateManager> manager;
+    size_t nConnected{0};
+    
+    void SetUp() override {
+        chain = MineRegTestChain(params, 12);
+        params.hashGenesisBlock = chain[0].GetHash();
+        manager = std::make_unique<ChainStateManager>(params);
+        ASSERT_TRUE(manager->Initialize(&coins));
+        ASSERT_NE(manager->ProcessBlockHeader(chain[0].GetBlockHeader()), nullptr);
+        nConnected = 1;
+    }
+    
+    ChainState& State() { return manager->GetActiveChainState(); }
+    
+    void Connect(size_t nBlocks) {
+        for (size_t end = nConnected + nBlocks; nConnected < end; ++nConnected) {
+            const Block& block = chain[nConnected];
+            BlockIndex* pindex = manager->ProcessBlockHeader(block.GetBlockHeader());
+            ASSERT_NE(pindex, nullptr);
+            BlockUndo undo;
+            ASSERT_EQ(State().ConnectBlock(block, pindex, undo), ConnectResult::OK);
+        }
+    }
+    
+    OutPoint Coinbase(size_t height) const {
+        return OutPoint(chain[height].vtx[0]->GetHash(), 0);
+    }
+};
+
+TEST_F(FlushPolicyTest, MempoolSqueezesLimitToFloor) {
+    const size_t limit = 2 * MIN_COINS_CACHE_BYTES;
+    State().SetCoinsCacheLimit(limit);
+    EXPECT_EQ(State().GetCoinsCacheStats().nLimit, limit);
+    
+    State().SetMempoolUsage(MIN_COINS_CACHE_BYTES / 2);
+    CoinsCacheStats stats = State().GetCoinsCacheStats();
+    EXPECT_EQ(stats.nLimit, limit - MIN_COINS_CACHE_BYTES / 2);
+    EXPECT_EQ(stats.nConfiguredLimit, limit);
+    EXPECT_EQ(stats.nMempoolUsage, MIN_COINS_CACHE_BYTES / 2);
+    
+    State().SetMempoolUsage(limit);
+    EXPECT_EQ(State().GetCoinsCacheStats().nLimit, MIN_COINS_CACHE_BYTES);
+    EXPECT_EQ(State().GetCoinsCacheStats().lastDecision, FlushDecision::NONE);
+}
+
+TEST_F(FlushPolicyTest, PressureWritesEveryBlock) {
+    // The cache's pool alone is over this limit, so every block flushes
+    State().SetCoinsCacheLimit(1000);
+    Connect(6);
+    ASSERT_TRUE(State().WaitForFlush());
+    
+    CoinsCacheStats stats = State().GetCoinsCacheStats();
+    EXPECT_EQ(stats.nBackgroundFlushes + stats.nForcedFlushes, 6u);
+    EXPECT_NE(stats.lastDecision, FlushDecision::NONE);
+    EXPECT_GT(stats.nEvicted, 0u);
+    EXPECT_EQ(stats.nIdleFlushes, 0u);
+    for (size_t height = 1; height <= 6; ++height) {
+        EXPECT_TRUE(coins.HaveCoin(Coinbase(height)));
+    }
+    EXPECT_EQ(coins.GetBestBlock(), chain[6].GetHash());
+}
+
+TEST_F(FlushPolicyTest, IdleFlushWritesAndStaysWarm) {
+    // No size limit: only the idle flush writes
+    Connect(4);
+    EXPECT_FALSE(State().FlushIfIdle(std::chrono::seconds(3600)));
+    ASSERT_TRUE(State().FlushIfIdle(std::chrono::seconds(0)));
+    ASSERT_TRUE(State().WaitForFlush());
+    
+    for (size_t height = 1; height <= 4; ++height) {
+        EXPECT_TRUE(coins.HaveCoin(Coinbase(height)));
+        EXPECT_TRUE(State().GetCoins().HaveCoinInCache(Coinbase(height)));
+    }
+    CoinsCacheStats stats = State().GetCoinsCacheStats();
+    EXPECT_EQ(stats.nIdleFlushes, 1u);
+    EXPECT_EQ(stats.lastDecision, FlushDecision::IDLE);
+    EXPECT_STREQ(FlushDecisionName(stats.lastDecision), "idle");
+    
+    // Nothing new to write
+    EXPECT_FALSE(State().FlushIfIdle(std::chrono::seconds(0)));
+    Connect(1);
+    EXPECT_TRUE(State().FlushIfIdle(std::chrono::seconds(0)));
+}
+
+// ============================================================================
+// Pruning Tests
+// ============================================================================
+
+class PruneTest : public ::testing::Test {
+protected:
+    std::filesystem::path testDir;
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain;
+    
+    void SetUp() override {
+        testDir = std::filesystem::temp_directory_path() /
+                  ("shurium_prune_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(testDir);
+        
+        chain = MineRegTestChain(params, db::MIN_BLOCKS_TO_KEEP + 40);
+        params.hashGenesisBlock = chain[0].GetHash();
+    }
+    
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(testDir, ec);
+    }
+};
+
+TEST_F(PruneTest, DeletesOldFilesAndClearsStatus) {
+    db::BlockDB blockDB(testDir);
+    blockDB.SetMaxBlockFileSize(2048);
+    blockDB.SetPruneTarget(8 * 1024);
+    
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    manager.SetBlockDB(&blockDB);
+    manager.Initialize(&coins);
+    for (const auto& block : chain) {
+        ASSERT_TRUE(manager.ProcessNewBlock(block));
+    }
+    const int tipHeight = manager.GetActiveHeight();
+    ASSERT_EQ(tipHeight, static_cast<int>(chain.size()) - 1);
+    
+    EXPECT_TRUE(blockDB.HavePruned());
+    EXPECT_FALSE(std::filesystem::exists(testDir / "blocks" / "blk00000.dat"));
+    
+    // Recent blocks are always kept and readable
+    int pruneHeight = manager.GetPruneHeight();
+    EXPECT_GT(pruneHeight, 0);
+    EXPECT_LE(pruneHeight, tipHeight - db::MIN_BLOCKS_TO_KEEP);
+    for (const auto& block : chain) {
+        const BlockIndex* pindex = manager.LookupBlockIndex(block.GetHash());
+        ASSERT_NE(pindex, nullptr);
+        if (pindex->nHeight >= pruneHeight) {
+            ASSERT_TRUE(pindex->HaveData()) << pindex->nHeight;
+            Block read;
+            EXPECT_TRUE(blockDB.ReadBlock(db::DiskBlockPos(pindex->nFile, pindex->nDataPos),
+                                          read).ok());
+        } else {
+            EXPECT_FALSE(HasStatus(pindex->nStatus, BlockStatus::HAVE_MASK)) << pindex->nHeight;
+        }
+    }
+}
+
+TEST_F(PruneTest, KeepsEverythingUnderTarget) {
+    db::BlockDB blockDB(testDir);
+    blockDB.SetMaxBlockFileSize(2048);
+    blockDB.SetPruneTarget(64 * 1024 * 1024);
+    
+    CoinsViewMemory coins;
+    ChainStateManager manager(params);
+    manager.SetBlockDB(&blockDB);
+    manager.Initialize(&coins);
+    for (const auto& block : chain) {
+        ASSERT_TRUE(manager.ProcessNewBlock(block));
+    }
+    
+    EXPECT_FALSE(blockDB.HavePruned());
+    EXPECT_EQ(manager.GetPruneHeight(), 0);
+    EXPECT_EQ(manager.PruneBlockFiles(), 0);
+}
+
+// ============================================================================
+// TxIndexer Tests
+// ============================================================================
+
+class TxIndexerTest : public ::testing::Test {
+protected:
+    std::filesystem::path testDir;
+    consensus::Params params = consensus::Params::RegTest();
+    std::vector<Block> chain;
+    std::unique_ptr<db::BlockDB> blockDB;
+    std::unique_ptr<db::TxIndex> txIndex;
+    CoinsViewMemory coins;
+    std::unique_ptr<ChainStateManager> manager;
+    
+    void SetUp() override {
+        testDir = std::filesystem::temp_directory_path() /
+                  ("shurium_txindexer_test_" + std::to_string(std::random_device{}()));
+        std::filesystem::create_directories(testDir);
+        
+        chain = MineRegTestChain(params, 20);
+        params.hashGenesisBlock = chain[0].GetHash();
+        
+        blockDB = std::make_unique<db::BlockDB>(testDir);
+        txIndex = std::make_unique<db::TxIndex>(testDir);
+        manager = std::make_unique<ChainStateManager>(params);
+        manager->SetBlockDB(blockDB.get());
+        manager->Initialize(&coins);
+    }
+    
+    void TearDown() override {
+        manager.reset();
+        txIndex.reset();
+        blockDB.reset();
+        std::error_code ec;
+        std::filesystem::remove_all(testDir, ec);
+    }
+    
+    void ConnectBlocks(const std::vector<Block>& blocks) {
+        for (const auto& block : blocks) {
+            ASSERT_TRUE(manager->ProcessNewBlock(block));
+        }
+    }
+    
+    static TxIndexerOptions SmallBatches() {
+        TxIndexerOptions options;
+        options.nThreads = 2;
+        options.batchBlocks = 4;
+        return options;
+    }
+    
+    /// Block a coinbase was found in, or a null hash
+    static BlockHash FindCoinbase(const TxIndexer& indexer, const Block& block) {
+        TransactionRef tx;
+        BlockHash hashBlock;
+        if (!indexer.FindTx(block.vtx[0]->GetHash(), tx, hashBlock)) {
+            return BlockHash();
+        }
+        EXPECT_EQ(tx->GetHash(), block.vtx[0]->GetHash());
+        return hashBlock;
+    }
+};
+
+TEST_F(TxIndexerTest, CatchesUpFromBlockFiles) {
+    ConnectBlocks(chain);
+    
+    TxIndexer indexer(*manager, *blockDB, *txIndex, SmallBatches());
+    ASSERT_TRUE(indexer.Start());
+    ASSERT_TRUE(indexer.WaitForSync(std::chrono::seconds(10)));
+    EXPECT_EQ(indexer.GetBestHeight(), manager->GetActiveHeight());
+    
+    for (const auto& block : chain) {
+        EXPECT_EQ(FindCoinbase(indexer, block), block.GetHash());
+    }
+}
+
+TEST_F(TxIndexerTest, FollowsNewBlocks) {
+    ConnectBlocks(std::vector<Block>(chain.begin(), chain.begin() + 10));
+    
+    TxIndexer indexer(*manager, *blockDB, *txIndex, SmallBatches());
+    ASSERT_TRUE(indexer.Start());
+    ASSERT_TRUE(indexer.WaitForSync(std::chrono::seconds(10)));
+    
+    // Once synced, a new tip is indexed before ProcessNewBlock returns
+    for (size_t i = 10; i < chain.size(); ++i) {
+        ASSERT_TRUE(manager->ProcessNewBlock(chain[i]));
+        EXPECT_EQ(FindCoinbase(indexer, chain[i]), chain[i].GetHash());
+    }
+    EXPECT_EQ(indexer.GetBestHeight(), static_cast<int>(chain.size()) - 1);
+}
+
+TEST_F(TxIndexerTest, ResumesFromLocator) {
+    ConnectBlocks(std::vector<Block>(chain.begin(), chain.begin() + 8));
+    {
+        TxIndexer indexer(*manager, *blockDB, *txIndex, SmallBatches());
+        ASSERT_TRUE(indexer.Start());
+        ASSERT_TRUE(indexer.WaitForSync(std::chrono::seconds(10)));
+        indexer.Stop();
+    }
+    auto locator = txIndex->GetBestLocator();
+    ASSERT_TRUE(locator.has_value());
+    ASSERT_FALSE(locator->IsNull());
+    EXPECT_EQ(locator->vHave[0], chain[7].GetHash());
+    
+    // Blocks connected while the indexer is down are picked up on restart
+    ConnectBlocks(std::vector<Block>(chain.begin() + 8, chain.end()));
+    TxIndexer indexer(*manager, *blockDB, *txIndex, SmallBatches());
+    ASSERT_TRUE(indexer.Start());
+    ASSERT_TRUE(indexer.WaitForSync(std::chrono::seconds(10)));
+    for (const auto& block : chain) {
+        EXPECT_EQ(FindCoinbase(indexer, block), block.GetHash());
+    }
+}
+
+TEST_F(TxIndexerTest, UnindexesReorgedBlocks) {
+    ConnectBlocks(std::vector<Block>(chain.begin(), chain.begin() + 10));
+    
+    TxIndexer indexer(*manager, *blockDB, *txIndex, SmallBatches());
+    ASSERT_TRUE(indexer.Start());
+    ASSERT_TRUE(indexer.WaitForSync(std::chrono::seconds(10)));
+    
+    // A longer branch from height 5 replaces heights 6..9
+    auto branch = MineRegTestChain(params, 7, chain[5].GetHash(), 6, 1);
+    ConnectBlocks(branch);
+    ASSERT_EQ(manager->GetActiveTip()->GetBlockHash(), branch.back().GetHash());
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (indexer.GetBestBlock() != manager->GetActiveTip() &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(indexer.GetBestBlock(), manager->GetActiveTip());
+    
+    for (size_t i = 0; i <= 5; ++i) {
+        EXPECT_EQ(FindCoinbase(indexer, chain[i]), chain[i].GetHash());
+    }
+    for (size_t i = 6; i < 10; ++i) {
+        EXPECT_TRUE(FindCoinbase(indexer, chain[i]).IsNull()) << i;
+    }
+    for (const auto& block : branch) {
+        EXPECT_EQ(FindCoinbase(indexer, block), block.GetHash());
+    }
+}
@@ -8,6 +8,8 @@
 #include "shurium/core/block.h"
 #include "shurium/core/transaction.h"
 #include "shurium/chain/blockindex.h"
+#include "shurium/consensus/checkpoints.h"
+#include "shurium/util/threadpool.h"
 
 using namespace shurium;
 using namespace shurium::consensus;
@@ -318,6 +320,91 @@ TEST_F(BlockValidationTest, CheckBlockHeader_TimeTooOld) {
     // Time validation is contextual
 }
 
+// Headers mined on the easy target, each linking to the one before;
+// harder nBits at badPow leave that header short of its target
+std::vector<BlockHeader> MakeHeaderChain(const Params& params, size_t count,
+                                         size_t badPow = SIZE_MAX) {
+    std::vector<BlockHeader> headers;
+    BlockHash prev;
+    for (size_t i = 0; i < count; ++i) {
+        BlockHeader header;
+        header.nVersion = 1;
+        header.hashPrevBlock = prev;
+        header.nTime = 1700000000 + static_cast<uint32_t>(i);
+        header.nBits = (i == badPow) ? 0x1d00ffff : 0x207fffff;
+        if (i != badPow) {
+            while (!CheckProofOfWork(header.GetHash(), header.nBits, params)) {
+                header.nNonce++;
+            }
+        }
+        prev = header.GetHash();
+        headers.push_back(header);
+    }
+    return headers;
+}
+
+TEST_F(BlockValidationTest, HeaderHashesMatchSingleHashes) {
+    auto headers = MakeHeaderChain(params, 37);
+    auto hashes = GetBlockHeaderHashes(headers);
+    ASSERT_EQ(hashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        EXPECT_EQ(hashes[i], headers[i].GetHash());
+    }
+}
+
+TEST_F(BlockValidationTest, CheckHeaderBatch_Valid) {
+    auto headers = MakeHeaderChain(params, 20);
+    ValidationState state;
+    EXPECT_EQ(CheckHeaderBatch(headers, GetBlockHeaderHashes(headers), 1, params,
+                               nullptr, state),
+              headers.size());
+    EXPECT_TRUE(state.IsValid());
+}
+
+TEST_F(BlockValidationTest, CheckHeaderBatch_BrokenLink) {
+    auto headers = MakeHeaderChain(params, 20);
+    headers[12].hashPrevBlock = headers[5].GetHash();
+    ValidationState state;
+    EXPECT_EQ(CheckHeaderBatch(headers, GetBlockHeaderHashes(headers), 1, params,
+                               nullptr, state),
+              12u);
+    EXPECT_EQ(state.GetRejectReason(), "bad-prevblk");
+}
+
+TEST_F(BlockValidationTest, CheckHeaderBatch_BadPowInLaterChunk) {
+    size_t count = 3 * HEADER_CHECK_CHUNK;
+    size_t bad = 2 * HEADER_CHECK_CHUNK + 17;
+    auto headers = MakeHeaderChain(params, count, bad);
+    auto hashes = GetBlockHeaderHashes(headers);
+    
+    util::ThreadPool pool(4);
+    ValidationState pooled;
+    EXPECT_EQ(CheckHeaderBatch(headers, hashes, 1, params, nullptr, pooled, &pool), bad);
+    EXPECT_EQ(pooled.GetRejectReason(), "high-hash");
+    
+    ValidationState serial;
+    EXPECT_EQ(CheckHeaderBatch(headers, hashes, 1, params, nullptr, serial), bad);
+    EXPECT_EQ(serial.GetRejectReason(), "high-hash");
+}
+
+TEST_F(BlockValidationTest, CheckHeaderBatch_CheckpointMismatch) {
+    auto headers = MakeHeaderChain(params, 30);
+    auto hashes = GetBlockHeaderHashes(headers);
+    
+    CheckpointManager checkpoints;
+    checkpoints.AddCheckpoint(105, hashes[4]);    // heights from 101
+    checkpoints.AddCheckpoint(120, hashes[0]);
+    ValidationState state;
+    EXPECT_EQ(CheckHeaderBatch(headers, hashes, 101, params, &checkpoints, state), 19u);
+    EXPECT_EQ(state.GetRejectReason(), "checkpoint-mismatch");
+    
+    // Checkpoints past the batch are not looked at
+    CheckpointManager ahead;
+    ahead.AddCheckpoint(500, hashes[0]);
+    ValidationState clean;
+    EXPECT_EQ(CheckHeaderBatch(headers, hashes, 101, params, &ahead, clean), headers.size());
+}
+
 TEST_F(BlockValidationTest, CheckBlock_Valid) {
     ValidationState state;
     EXPECT_TRUE(CheckBlock(validBlock, state, params));
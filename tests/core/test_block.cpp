@@ -329,6 +329,78 @@ TEST_F(BlockTest, Serialization) {
     EXPECT_EQ(block.GetHash(), deserialized.GetHash());
 }
 
+TEST_F(BlockTest, CachedHashFollowsHeaderChanges) {
+    Block block(testHeader);
+    block.vtx.push_back(coinbaseTx);
+    
+    BlockHash first = block.GetHash();
+    EXPECT_EQ(first, block.GetBlockHeader().GetHash());
+    EXPECT_EQ(block.GetHash(), first);
+    
+    // Mining changes the nonce in place; the cached hash must not be reused
+    block.nNonce++;
+    EXPECT_NE(block.GetHash(), first);
+    EXPECT_EQ(block.GetHash(), block.GetBlockHeader().GetHash());
+    
+    Block copy = block;
+    EXPECT_EQ(copy.GetHash(), block.GetHash());
+    copy.nTime++;
+    EXPECT_NE(copy.GetHash(), block.GetHash());
+}
+
+TEST_F(BlockTest, ArenaSerialization) {
+    Block block;
+    block.nVersion = 2;
+    block.nTime = 1234567890;
+    block.vtx.push_back(coinbaseTx);
+    for (int i = 0; i < 50; ++i) {
+        block.vtx.push_back(regularTx);
+    }
+    
+    DataStream ss;
+    ss << block;
+    
+    TransactionRef survivor;
+    {
+        Block deserialized;
+        SpanReader reader(ss.Data());
+        UnserializeWithArena(reader, deserialized);
+        EXPECT_TRUE(reader.empty());
+        ASSERT_EQ(deserialized.vtx.size(), block.vtx.size());
+        EXPECT_EQ(deserialized.GetHash(), block.GetHash());
+        EXPECT_EQ(deserialized.ComputeMerkleRoot(), block.ComputeMerkleRoot());
+        EXPECT_EQ(deserialized.vtx[1]->GetHash(), regularTx->GetHash());
+        
+        // All transactions sit in one region: neighbours are a fixed
+        // stride apart
+        auto addr = [&](size_t i) {
+            return reinterpret_cast<uintptr_t>(deserialized.vtx[i].get());
+        };
+        EXPECT_EQ(addr(2) - addr(1), addr(3) - addr(2));
+        survivor = deserialized.vtx[1];
+    }
+    
+    // A transaction outliving its block keeps the arena alive
+    EXPECT_EQ(survivor->GetHash(), regularTx->GetHash());
+    EXPECT_EQ(survivor->vout[0].nValue, 25 * COIN);
+}
+
+TEST(ArenaTest, AllocatesAlignedFromChunks) {
+    Arena arena(Arena::MIN_CHUNK_SIZE);
+    void* a = arena.Allocate(3, 1);
+    void* b = arena.Allocate(8, 8);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+    EXPECT_GT(b, a);
+    EXPECT_EQ(arena.GetChunkCount(), 1u);
+    
+    // Larger than a chunk: gets a chunk of its own
+    void* big = arena.Allocate(3 * Arena::MIN_CHUNK_SIZE, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % 64, 0u);
+    EXPECT_EQ(arena.GetChunkCount(), 2u);
+    EXPECT_EQ(arena.GetUsedBytes(), 11u + 3 * Arena::MIN_CHUNK_SIZE);
+    EXPECT_GE(arena.GetReservedBytes(), arena.GetUsedBytes());
+}
+
 TEST_F(BlockTest, ToString) {
     Block block;
     block.nVersion = 1;
@@ -0,0 +1,177 @@
+// SHURIUM - Compact Block Filter Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/core/blockfilter.h"
+#include "shurium/core/hex.h"
+#include "shurium/core/random.h"
+#include <ios>
+#include <vector>
+
+using namespace shurium;
+
+// ============================================================================
+// Helper Functions
+// ============================================================================
+
+namespace {
+
+GCSFilter::Element RandomElement(size_t size = 32) {
+    GCSFilter::Element element(size);
+    GetRandBytes(element.data(), element.size());
+    return element;
+}
+
+Script RandomScript() {
+    GCSFilter::Element bytes = RandomElement(22);
+    return Script(bytes.begin(), bytes.end());
+}
+
+TransactionRef MakeTx(const std::vector<Script>& scripts) {
+    MutableTransaction tx;
+    TxHash prev;
+    GetRandBytes(prev.data(), prev.size());
+    tx.vin.push_back(TxIn(OutPoint(prev, 0)));
+    for (const Script& script : scripts) {
+        tx.vout.push_back(TxOut(COIN, script));
+    }
+    return MakeTransactionRef(std::move(tx));
+}
+
+} // namespace
+
+// ============================================================================
+// GCSFilter Tests
+// ============================================================================
+
+TEST(GCSFilterTest, MatchesEveryElement) {
+    GCSFilter::Params params;
+    params.k0 = 0x0123456789abcdefULL;
+    params.k1 = 0xfedcba9876543210ULL;
+
+    GCSFilter::ElementSet included;
+    for (int i = 0; i < 100; ++i) {
+        included.insert(RandomElement());
+    }
+    GCSFilter filter(params, included);
+    EXPECT_EQ(filter.GetN(), 100u);
+    for (const auto& element : included) {
+        EXPECT_TRUE(filter.Match(element));
+    }
+    EXPECT_TRUE(filter.MatchAny(included));
+
+    // At 1/M each, 10000 misses should give no more than a few matches
+    int falsePositives = 0;
+    GCSFilter::ElementSet excluded;
+    for (int i = 0; i < 10000; ++i) {
+        GCSFilter::Element element = RandomElement();
+        falsePositives += filter.Match(element) ? 1 : 0;
+        if (excluded.size() < 100) {
+            excluded.insert(element);
+        }
+    }
+    EXPECT_LE(falsePositives, 5);
+    excluded.insert(*included.begin());
+    EXPECT_TRUE(filter.MatchAny(excluded));
+}
+
+TEST(GCSFilterTest, EmptyFilterMatchesNothing) {
+    GCSFilter filter;
+    EXPECT_EQ(filter.GetN(), 0u);
+    EXPECT_EQ(filter.GetEncoded(), std::vector<uint8_t>{0});
+    EXPECT_FALSE(filter.Match(RandomElement()));
+    EXPECT_FALSE(filter.MatchAny({RandomElement(), RandomElement()}));
+}
+
+TEST(GCSFilterTest, DecodesItsOwnEncoding) {
+    GCSFilter::Params params;
+    params.k0 = 7;
+    params.k1 = 11;
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < 50; ++i) {
+        elements.insert(RandomElement(i + 1));
+    }
+    GCSFilter filter(params, elements);
+
+    GCSFilter decoded(params, filter.GetEncoded());
+    EXPECT_EQ(decoded.GetN(), filter.GetN());
+    for (const auto& element : elements) {
+        EXPECT_TRUE(decoded.Match(element));
+    }
+
+    std::vector<uint8_t> truncated = filter.GetEncoded();
+    truncated.resize(truncated.size() / 2);
+    EXPECT_THROW(GCSFilter(params, truncated), std::ios_base::failure);
+}
+
+TEST(GCSFilterTest, MatchesReferenceEncoding) {
+    // BIP158 basic filter of the Bitcoin testnet genesis block: keyed on
+    // that block's hash, holding its one output script
+    GCSFilter::Params params;
+    params.k0 = 0x719526f8d77f4943ULL;
+    params.k1 = 0xaec3ced90fa3f408ULL;
+    std::vector<HexByte> script = HexToBytes(
+        "4104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61de"
+        "b649f6bc3f4cef38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac");
+    GCSFilter::ElementSet elements{GCSFilter::Element(script.begin(), script.end())};
+    GCSFilter filter(params, elements);
+    EXPECT_EQ(BytesToHex(filter.GetEncoded()), "019dfca8");
+}
+
+// ============================================================================
+// BlockFilter Tests
+// ============================================================================
+
+TEST(BlockFilterTest, HoldsPaidAndSpentScripts) {
+    Script paid = RandomScript();
+    Script spent = RandomScript();
+    Script nullData = Script::CreateOpReturn({1, 2, 3});
+
+    Block block;
+    block.vtx.push_back(MakeTx({paid, nullData, Script()}));
+
+    auto elements = BlockFilter::BasicFilterElements(block, {spent});
+    EXPECT_EQ(elements.size(), 2u);
+    EXPECT_EQ(elements.count(GCSFilter::Element(paid.begin(), paid.end())), 1u);
+    EXPECT_EQ(elements.count(GCSFilter::Element(spent.begin(), spent.end())), 1u);
+
+    BlockFilter filter(BlockFilterType::BASIC, block, {spent});
+    EXPECT_EQ(filter.GetBlockHash(), block.GetHash());
+    EXPECT_TRUE(filter.GetFilter().Match(GCSFilter::Element(paid.begin(), paid.end())));
+    EXPECT_TRUE(filter.GetFilter().Match(GCSFilter::Element(spent.begin(), spent.end())));
+}
+
+TEST(BlockFilterTest, KeyedOnBlockHash) {
+    Script paid = RandomScript();
+    Block a;
+    a.vtx.push_back(MakeTx({paid}));
+    Block b = a;
+    b.nNonce = a.nNonce + 1;
+
+    BlockFilter filterA(BlockFilterType::BASIC, a, {});
+    BlockFilter filterB(BlockFilterType::BASIC, b, {});
+    EXPECT_NE(filterA.GetEncodedFilter(), filterB.GetEncodedFilter());
+
+    BlockFilter decoded(BlockFilterType::BASIC, a.GetHash(), filterA.GetEncodedFilter());
+    EXPECT_TRUE(decoded.GetFilter().Match(GCSFilter::Element(paid.begin(), paid.end())));
+    EXPECT_EQ(decoded.GetHash(), filterA.GetHash());
+}
+
+TEST(BlockFilterTest, HeadersChain) {
+    Block block;
+    block.vtx.push_back(MakeTx({RandomScript()}));
+    BlockFilter filter(BlockFilterType::BASIC, block, {});
+
+    Hash256 first = filter.ComputeHeader(Hash256());
+    Hash256 second = filter.ComputeHeader(first);
+    EXPECT_FALSE(first.IsNull());
+    EXPECT_NE(first, second);
+    EXPECT_EQ(filter.ComputeHeader(first), second);
+}
+
+TEST(BlockFilterTest, TypeNames) {
+    EXPECT_EQ(BlockFilterTypeName(BlockFilterType::BASIC), "basic");
+    EXPECT_EQ(BlockFilterTypeFromName("basic"), BlockFilterType::BASIC);
+    EXPECT_FALSE(BlockFilterTypeFromName("extended").has_value());
+}
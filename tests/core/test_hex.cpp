@@ -1,3 +1,106 @@
-// SHURIUM - Hex Tests (Stub)
+// SHURIUM - Hex Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
 #include <gtest/gtest.h>
-TEST(HexTest, Placeholder) { EXPECT_TRUE(true); }
+#include "shurium/core/hex.h"
+
+#include <cctype>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace test {
+
+class HexImplTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        SetHexImplementation(detected_);
+    }
+
+    HexImplementation detected_ = GetHexImplementation();
+};
+
+/// Reference encoding, one nibble at a time
+static std::string SlowHex(const std::vector<HexByte>& data) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (HexByte b : data) {
+        out += digits[b >> 4];
+        out += digits[b & 0x0f];
+    }
+    return out;
+}
+
+static std::vector<HexByte> Pattern(size_t len) {
+    std::vector<HexByte> data(len);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<HexByte>(i * 167 + 13);
+    }
+    return data;
+}
+
+TEST_F(HexImplTest, ScalarIsAlwaysAvailable) {
+    auto impls = GetAvailableHexImplementations();
+    ASSERT_FALSE(impls.empty());
+    EXPECT_EQ(impls.back(), HexImplementation::SCALAR);
+    for (HexImplementation impl : impls) {
+        EXPECT_TRUE(SetHexImplementation(impl));
+        EXPECT_EQ(GetHexImplementation(), impl);
+    }
+}
+
+TEST_F(HexImplTest, RoundTripsEveryLength) {
+    for (HexImplementation impl : GetAvailableHexImplementations()) {
+        ASSERT_TRUE(SetHexImplementation(impl));
+        for (size_t len = 0; len <= 130; ++len) {
+            auto data = Pattern(len);
+            std::string hex = BytesToHex(data);
+            ASSERT_EQ(hex, SlowHex(data)) << HexImplementationName(impl) << " len " << len;
+            ASSERT_EQ(HexToBytes(hex), data) << HexImplementationName(impl) << " len " << len;
+        }
+    }
+}
+
+TEST_F(HexImplTest, DecodesUppercase) {
+    auto data = Pattern(100);
+    std::string upper = SlowHex(data);
+    for (char& c : upper) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    for (HexImplementation impl : GetAvailableHexImplementations()) {
+        ASSERT_TRUE(SetHexImplementation(impl));
+        std::vector<HexByte> out(data.size());
+        EXPECT_TRUE(DecodeHex(upper.data(), out.size(), out.data())) << HexImplementationName(impl);
+        EXPECT_EQ(out, data) << HexImplementationName(impl);
+    }
+}
+
+TEST_F(HexImplTest, RejectsInvalidCharacterAnywhere) {
+    // Characters just outside each valid range, and a high byte
+    const char bad[] = {'/', ':', '@', 'G', '`', 'g', ' ', '\0', '\x80', '\xff'};
+    std::string good = SlowHex(Pattern(70));
+    for (HexImplementation impl : GetAvailableHexImplementations()) {
+        ASSERT_TRUE(SetHexImplementation(impl));
+        for (size_t pos = 0; pos < good.size(); ++pos) {
+            for (char c : bad) {
+                std::string hex = good;
+                hex[pos] = c;
+                std::vector<HexByte> out(hex.size() / 2);
+                EXPECT_FALSE(DecodeHex(hex.data(), out.size(), out.data()))
+                    << HexImplementationName(impl) << " pos " << pos << " char " << int(c);
+            }
+        }
+    }
+}
+
+TEST(HexTest, HexToBytesRejectsMalformed) {
+    EXPECT_THROW(HexToBytes("abc"), std::invalid_argument);
+    EXPECT_THROW(HexToBytes("zz"), std::invalid_argument);
+    EXPECT_TRUE(IsValidHex("00ff"));
+    EXPECT_FALSE(IsValidHex("00fg"));
+}
+
+} // namespace test
+} // namespace shurium
@@ -250,6 +250,22 @@ TEST(MerkleProofTest, VerifyProof) {
     EXPECT_FALSE(VerifyMerkleProof(h2, 0, root, proof));
 }
 
+TEST(MerkleProofTest, RootFromFirstLeafBranch) {
+    // Replacing the first leaf, as an extranonce roll replaces the coinbase
+    for (int count : {1, 2, 3, 7, 100, 1001}) {
+        std::vector<Hash256> leaves;
+        for (int i = 0; i < count; ++i) {
+            leaves.push_back(MakeHash(i + 1));
+        }
+        std::vector<Hash256> branch = ComputeMerklePath(leaves, 0);
+        EXPECT_EQ(ComputeMerkleRootFromPath(leaves[0], 0, branch), ComputeMerkleRoot(leaves));
+
+        leaves[0] = MakeHash(5000 + count);
+        EXPECT_EQ(ComputeMerkleRootFromPath(leaves[0], 0, branch), ComputeMerkleRoot(leaves))
+            << count << " leaves";
+    }
+}
+
 // ============================================================================
 // Edge Cases
 // ============================================================================
@@ -305,3 +321,36 @@ TEST(MerkleTest, OrderMatters) {
     
     EXPECT_NE(root1, root2);
 }
+
+TEST(MerkleTest, EveryKernelWidthGivesSameRoot) {
+    // 1000 leaves exercise every kernel width plus remainders on each level
+    std::vector<Hash256> leaves;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        leaves.push_back(MakeHash(i * 2654435761u));
+    }
+
+    // Reference: pairwise DoubleSHA256 over byte buffers
+    std::vector<Hash256> level = leaves;
+    while (level.size() > 1) {
+        if (level.size() & 1) {
+            level.push_back(level.back());
+        }
+        std::vector<Hash256> next;
+        for (size_t i = 0; i < level.size(); i += 2) {
+            uint8_t combined[64];
+            std::memcpy(combined, level[i].data(), 32);
+            std::memcpy(combined + 32, level[i + 1].data(), 32);
+            next.push_back(DoubleSHA256(combined, sizeof(combined)));
+        }
+        level = std::move(next);
+    }
+
+    size_t detected = GetSHA256D64Ways();
+    for (size_t ways : GetAvailableSHA256D64Ways()) {
+        ASSERT_TRUE(SetSHA256D64Ways(ways));
+        EXPECT_EQ(ComputeMerkleRoot(leaves), level[0]) << ways << "-way";
+        auto proof = ComputeMerklePath(leaves, 777);
+        EXPECT_TRUE(VerifyMerkleProof(leaves[777], 777, level[0], proof)) << ways << "-way";
+    }
+    SetSHA256D64Ways(detected);
+}
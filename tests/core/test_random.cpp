@@ -9,6 +9,12 @@
 #include <set>
 #include <algorithm>
 #include <cmath>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace shurium;
 
@@ -242,3 +248,103 @@ TEST(RandomTest, ShuffleChangesOrder) {
     
     EXPECT_TRUE(foundDifferent);
 }
+
+// ============================================================================
+// Generator Tests
+// ============================================================================
+
+TEST(RandomTest, ChaCha20MatchesRFC8439) {
+    // RFC 8439 section 2.3.2: counter 1, nonce 00:00:00:09:00:00:00:4a:00:00:00:00
+    uint32_t key[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        uint32_t b = 4 * i;
+        key[i] = b | (b + 1) << 8 | (b + 2) << 16 | (b + 3) << 24;
+    }
+    uint8_t block[64];
+    detail::ChaCha20Block(key, 1 | uint64_t{0x09000000} << 32, 0x4a000000, block);
+
+    const uint8_t expected[64] = {
+        0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+        0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+        0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+        0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e};
+    EXPECT_EQ(std::vector<uint8_t>(block, block + 64), std::vector<uint8_t>(expected, expected + 64));
+}
+
+TEST(RandomTest, ThreadsDrawIndependentStreams) {
+    // Past several refills and the reseed threshold on each thread
+    constexpr size_t COUNT = (RNG_RESEED_BYTES + 4096) / 8;
+    std::vector<uint64_t> a(COUNT), b(COUNT);
+    std::thread other([&] { GetRandBytes(reinterpret_cast<uint8_t*>(b.data()), COUNT * 8); });
+    GetRandBytes(reinterpret_cast<uint8_t*>(a.data()), COUNT * 8);
+    other.join();
+
+    std::set<uint64_t> seen(a.begin(), a.end());
+    seen.insert(b.begin(), b.end());
+    EXPECT_EQ(seen.size(), 2 * COUNT);
+}
+
+#if !defined(_WIN32)
+TEST(RandomTest, ForkedChildReseeds) {
+    // Leave output buffered that a child would otherwise repeat
+    GetRandUint64();
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        uint64_t value = GetRandUint64();
+        _exit(write(fds[1], &value, sizeof(value)) == sizeof(value) ? 0 : 1);
+    }
+    uint64_t parentValue = GetRandUint64();
+    uint64_t childValue = 0;
+    ASSERT_EQ(read(fds[0], &childValue, sizeof(childValue)), ssize_t(sizeof(childValue)));
+    int status = 0;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    EXPECT_NE(parentValue, childValue);
+}
+#endif
+
+TEST(RandomTest, FastRandomContextSeeding) {
+    FastRandomContext a(42), b(42), c(43);
+    for (int i = 0; i < 100; ++i) {
+        uint64_t va = a.Rand64();
+        EXPECT_EQ(va, b.Rand64());
+        EXPECT_NE(va, c.Rand64());
+    }
+
+    FastRandomContext d, e;
+    EXPECT_NE(d.Rand64(), e.Rand64());
+}
+
+TEST(RandomTest, FastRandomContextRange) {
+    FastRandomContext rng;
+    EXPECT_EQ(rng.RandRange(0), 0u);
+    EXPECT_EQ(rng.RandRange(1), 0u);
+
+    std::vector<int> counts(10, 0);
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t v = rng.RandRange(10);
+        ASSERT_LT(v, 10u);
+        ++counts[v];
+    }
+    for (int count : counts) {
+        EXPECT_NEAR(count, 10000, 600);
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        double d = rng.RandDouble();
+        ASSERT_GE(d, 0.0);
+        ASSERT_LT(d, 1.0);
+    }
+
+    std::vector<int> items = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::vector<int> shuffled = items;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    std::sort(shuffled.begin(), shuffled.end());
+    EXPECT_EQ(shuffled, items);
+}
@@ -346,6 +346,69 @@ TEST(ScriptTest, HasValidOps) {
     EXPECT_TRUE(script.HasValidOps());
 }
 
+// ============================================================================
+// DecodedScript Tests
+// ============================================================================
+
+TEST(DecodedScriptTest, LocatesOpsAndPushes) {
+    Script script;
+    std::vector<uint8_t> data(100, 0xab);
+    script << OP_2 << data << OP_CODESEPARATOR << OP_CHECKMULTISIG;
+    
+    DecodedScript decoded(script);
+    ASSERT_EQ(decoded.ops().size(), 4u);
+    EXPECT_FALSE(decoded.IsTruncated());
+    EXPECT_EQ(decoded.ops()[0].opcode, OP_2);
+    EXPECT_EQ(decoded.ops()[1].opcode, OP_PUSHDATA1);
+    
+    Span<const uint8_t> pushed = decoded.Data(decoded.ops()[1]);
+    EXPECT_EQ(std::vector<uint8_t>(pushed.begin(), pushed.end()), data);
+    EXPECT_EQ(pushed.data(), script.data() + 3);
+    EXPECT_EQ(decoded.ops()[2].end, script.size() - 1);
+    EXPECT_EQ(decoded.ops()[3].end, script.size());
+}
+
+TEST(DecodedScriptTest, TruncatedScript) {
+    Script script;
+    script << OP_CHECKSIG;
+    script.push_back(OP_PUSHDATA2);
+    script.push_back(0x05);
+    
+    DecodedScript decoded(script);
+    EXPECT_TRUE(decoded.IsTruncated());
+    EXPECT_EQ(decoded.ops().size(), 1u);
+    EXPECT_FALSE(decoded.IsPushOnly());
+    EXPECT_FALSE(decoded.HasValidOps());
+    EXPECT_EQ(decoded.GetSigOpCount(), script.GetSigOpCount());
+}
+
+TEST(DecodedScriptTest, MatchesScriptQueries) {
+    std::vector<Script> scripts;
+    scripts.push_back(Script());
+    scripts.push_back(Script::CreateP2PKH(Hash160()));
+    scripts.push_back(Script::CreateP2SH(Hash160()));
+    scripts.push_back(Script::CreateOpReturn({1, 2, 3}));
+    Script multisig;
+    multisig << OP_1 << std::vector<uint8_t>(33, 2) << OP_1 << OP_CHECKMULTISIG;
+    scripts.push_back(multisig);
+    Script pushes;
+    pushes << std::vector<uint8_t>(72, 1) << 5 << 16 << OP_0;
+    scripts.push_back(pushes);
+    Script invalid;
+    invalid << OP_CHECKSIGVERIFY << OP_INVALIDOPCODE;
+    invalid.push_back(0xc0);
+    scripts.push_back(invalid);
+    
+    for (const Script& script : scripts) {
+        DecodedScript decoded(script);
+        EXPECT_EQ(decoded.size(), script.size());
+        EXPECT_EQ(decoded.IsPushOnly(), script.IsPushOnly()) << script.ToString();
+        EXPECT_EQ(decoded.HasValidOps(), script.HasValidOps()) << script.ToString();
+        EXPECT_EQ(decoded.GetSigOpCount(false), script.GetSigOpCount(false)) << script.ToString();
+        EXPECT_EQ(decoded.GetSigOpCount(true), script.GetSigOpCount(true)) << script.ToString();
+    }
+}
+
 // ============================================================================
 // Script Comparison Tests
 // ============================================================================
@@ -278,6 +278,41 @@ TEST(CompactSizeTest, VeryLarge) {
     EXPECT_EQ(ReadCompactSize(ds, false), 0xFFFFFFFFFFFFFFFFULL);
 }
 
+// ============================================================================
+// VarInt Tests
+// ============================================================================
+
+TEST(VarIntTest, Boundaries) {
+    const std::pair<uint64_t, size_t> cases[] = {
+        {0, 1}, {127, 1}, {128, 2}, {16511, 2}, {16512, 3},
+        {0xFFFFFFFFULL, 5}, {0xFFFFFFFFFFFFFFFFULL, 10},
+    };
+    for (const auto& [value, size] : cases) {
+        DataStream ds;
+        WriteVarInt(ds, value);
+        EXPECT_EQ(ds.size(), size) << value;
+        EXPECT_EQ(ReadVarInt(ds), value);
+        EXPECT_TRUE(ds.empty());
+    }
+}
+
+TEST(VarIntTest, KnownEncoding) {
+    DataStream ds;
+    WriteVarInt(ds, 128);
+    ASSERT_EQ(ds.size(), 2);
+    EXPECT_EQ(ds.Data()[0], 0x80);
+    EXPECT_EQ(ds.Data()[1], 0x00);
+}
+
+TEST(VarIntTest, RejectsOverflow) {
+    DataStream ds;
+    for (int i = 0; i < 10; ++i) {
+        ser_writedata8(ds, 0xFF);
+    }
+    ser_writedata8(ds, 0x00);
+    EXPECT_THROW(ReadVarInt(ds), std::ios_base::failure);
+}
+
 // ============================================================================
 // Vector Serialization Tests
 // ============================================================================
@@ -661,3 +696,32 @@ TEST(SerializeTest, NegativeAmount) {
     ds >> result;
     EXPECT_EQ(result, amt);
 }
+
+// ============================================================================
+// SpanReader Tests
+// ============================================================================
+
+TEST(SpanReaderTest, ReadsBorrowedBytesInPlace) {
+    DataStream ds;
+    ds << uint32_t(0xDEADBEEF) << std::string("span") << std::vector<uint64_t>{1, 2, 3};
+    const std::vector<uint8_t>& bytes = ds.Data();
+
+    SpanReader reader(bytes);
+    EXPECT_EQ(reader.data(), bytes.data());
+    EXPECT_EQ(reader.size(), bytes.size());
+
+    uint32_t val;
+    std::string str;
+    std::vector<uint64_t> vec;
+    reader >> val >> str;
+    EXPECT_EQ(reader.data(), bytes.data() + 4 + 1 + 4);
+    Unserialize(reader, vec);
+
+    EXPECT_EQ(val, 0xDEADBEEF);
+    EXPECT_EQ(str, "span");
+    EXPECT_EQ(vec, (std::vector<uint64_t>{1, 2, 3}));
+    EXPECT_TRUE(reader.empty());
+
+    uint8_t extra;
+    EXPECT_THROW(reader >> extra, std::ios_base::failure);
+}
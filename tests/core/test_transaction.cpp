@@ -436,6 +436,8 @@ TEST_F(TransactionTest, GetTotalSize) {
     
     size_t size = tx.GetTotalSize();
     EXPECT_GT(size, 0u);
+    EXPECT_EQ(size, GetSerializeSize(tx));
+    EXPECT_EQ(size, mutableTx.GetTotalSize());
 }
 
 TEST_F(TransactionTest, Equality) {
@@ -728,3 +730,27 @@ TEST_F(SerializationTest, GetSerializeSize) {
     
     EXPECT_EQ(expectedSize, ss.TotalSize());
 }
+
+// ============================================================================
+// Decoded Script Cache Tests
+// ============================================================================
+
+TEST(TransactionScriptCacheTest, DecodesEachScriptOnce) {
+    MutableTransaction mtx;
+    Script scriptSig;
+    scriptSig << std::vector<uint8_t>(71, 0x30) << std::vector<uint8_t>(33, 0x02);
+    mtx.vin.push_back(TxIn(OutPoint(TxHash(), 0), scriptSig));
+    mtx.vout.push_back(TxOut(COIN, Script::CreateP2PKH(Hash160())));
+    Transaction tx(mtx);
+    
+    const DecodedScript& sig = tx.GetDecodedScriptSig(0);
+    EXPECT_EQ(&sig, &tx.GetDecodedScriptSig(0));
+    EXPECT_EQ(sig.ops().size(), 2u);
+    EXPECT_EQ(sig.bytes().data(), tx.vin[0].scriptSig.data());
+    EXPECT_EQ(tx.GetDecodedScriptPubKey(0).GetSigOpCount(), 1u);
+    
+    // A copy decodes its own scripts
+    Transaction copy(tx);
+    EXPECT_EQ(copy.GetDecodedScriptSig(0).bytes().data(), copy.vin[0].scriptSig.data());
+    EXPECT_NE(&copy.GetDecodedScriptSig(0), &sig);
+}
@@ -0,0 +1,374 @@
+// SHURIUM - AES Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/aes.h"
+#include "shurium/core/hex.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef SHURIUM_USE_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+namespace shurium {
+namespace test {
+
+static std::vector<Byte> Hex(const std::string& hex) {
+    return HexToBytes(hex);
+}
+
+static std::string ToHex(const std::vector<Byte>& data) {
+    return BytesToHex(data.data(), data.size());
+}
+
+static std::vector<Byte> PatternBytes(size_t len, size_t seed) {
+    std::vector<Byte> data(len);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<Byte>((i * 131 + seed) ^ (i >> 3));
+    }
+    return data;
+}
+
+/// SP 800-38A F.2 / F.5 plaintext, four blocks
+static const std::string SP800_38A_PLAIN =
+    "6bc1bee22e409f96e93d7e117393172a"
+    "ae2d8a571e03ac9c9eb76fac45af8e51"
+    "30c81c46a35ce411e5fbc1191a0a52ef"
+    "f69f2445df4f9b17ad2b417be66c3710";
+
+static const std::string SP800_38A_KEY_128 = "2b7e151628aed2a6abf7158809cf4f3c";
+static const std::string SP800_38A_KEY_256 =
+    "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4";
+static const std::string SP800_38A_CBC_IV = "000102030405060708090a0b0c0d0e0f";
+static const std::string SP800_38A_CTR_IV = "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/// Runs each test under every available implementation, restoring the
+/// auto-detected one afterwards
+class AESImplTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        SetAESImplementation(detected_);
+    }
+
+    AESImplementation detected_ = AESAutoDetect();
+};
+
+// ============================================================================
+// Implementation Selection
+// ============================================================================
+
+TEST_F(AESImplTest, ScalarAlwaysAvailable) {
+    auto impls = GetAvailableAESImplementations();
+    ASSERT_FALSE(impls.empty());
+    EXPECT_EQ(impls.back(), AESImplementation::SCALAR);
+    // The fastest available one is picked
+    EXPECT_EQ(impls.front(), detected_);
+    EXPECT_TRUE(SetAESImplementation(AESImplementation::SCALAR));
+    EXPECT_EQ(GetAESImplementation(), AESImplementation::SCALAR);
+}
+
+TEST_F(AESImplTest, UnavailableImplementationIsRejected) {
+    auto impls = GetAvailableAESImplementations();
+    for (AESImplementation impl : {AESImplementation::AESNI, AESImplementation::ARMV8}) {
+        ASSERT_TRUE(SetAESImplementation(AESImplementation::SCALAR));
+        bool available = std::find(impls.begin(), impls.end(), impl) != impls.end();
+        EXPECT_EQ(SetAESImplementation(impl), available) << AESImplementationName(impl);
+        // A rejected switch leaves the current kernels in place
+        EXPECT_EQ(GetAESImplementation(), available ? impl : AESImplementation::SCALAR);
+    }
+}
+
+// ============================================================================
+// Known Answers
+// ============================================================================
+
+TEST_F(AESImplTest, FIPS197Vectors) {
+    const auto plain = Hex("00112233445566778899aabbccddeeff");
+    struct Vector { std::string key, cipher; };
+    const Vector vectors[] = {
+        {"000102030405060708090a0b0c0d0e0f", "69c4e0d86a7b0430d8cdb78070b4c55a"},
+        {"000102030405060708090a0b0c0d0e0f1011121314151617",
+         "dda97ca4864cdfe06eaf70a0ec0d7191"},
+        {"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+         "8ea2b7ca516745bfeafc49904b496089"},
+    };
+
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        ASSERT_TRUE(SetAESImplementation(impl));
+        for (const auto& v : vectors) {
+            AESContext ctx(Hex(v.key));
+            std::vector<Byte> block(16);
+            ctx.EncryptBlock(plain.data(), block.data());
+            EXPECT_EQ(ToHex(block), v.cipher) << AESImplementationName(impl);
+            // In place
+            ctx.DecryptBlock(block.data(), block.data());
+            EXPECT_EQ(block, plain) << AESImplementationName(impl);
+        }
+    }
+}
+
+TEST_F(AESImplTest, SP800_38A_CBC) {
+    const auto plain = Hex(SP800_38A_PLAIN);
+    struct Vector { std::string key, cipher; };
+    const Vector vectors[] = {
+        {SP800_38A_KEY_128,
+         "7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+         "73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7"},
+        {SP800_38A_KEY_256,
+         "f58c4c04d6e5f1ba779eabfb5f7bfbd69cfc4e967edb808d679f777bc6702c7d"
+         "39f23369a9d9bacfa530e26304231461b2eb05e2c39be9fcda6c19078c6a9d1b"},
+    };
+
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        ASSERT_TRUE(SetAESImplementation(impl));
+        for (const auto& v : vectors) {
+            AESContext ctx(Hex(v.key));
+            auto iv = Hex(SP800_38A_CBC_IV);
+            std::vector<Byte> out(plain.size());
+            ctx.EncryptCBC(iv.data(), plain.data(), out.data(), 4);
+            EXPECT_EQ(ToHex(out), v.cipher) << AESImplementationName(impl);
+            // The chaining value is left at the last ciphertext block
+            EXPECT_TRUE(std::equal(iv.begin(), iv.end(), out.end() - 16));
+
+            iv = Hex(SP800_38A_CBC_IV);
+            ctx.DecryptCBC(iv.data(), out.data(), out.data(), 4);
+            EXPECT_EQ(out, plain) << AESImplementationName(impl);
+
+            // The padded encryptor produces the same blocks plus one of padding
+            auto padded = AESEncryptor(Hex(v.key), AESMode::CBC, Hex(SP800_38A_CBC_IV))
+                              .Encrypt(plain);
+            ASSERT_EQ(padded.size(), plain.size() + 16);
+            EXPECT_EQ(ToHex(std::vector<Byte>(padded.begin(), padded.begin() + 64)), v.cipher);
+            EXPECT_EQ(AESDecryptor(Hex(v.key), AESMode::CBC, Hex(SP800_38A_CBC_IV))
+                          .Decrypt(padded), plain);
+        }
+    }
+}
+
+TEST_F(AESImplTest, SP800_38A_CTR) {
+    const auto plain = Hex(SP800_38A_PLAIN);
+    struct Vector { std::string key, cipher; };
+    const Vector vectors[] = {
+        {SP800_38A_KEY_128,
+         "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+         "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee"},
+        {SP800_38A_KEY_256,
+         "601ec313775789a5b7a7f504bbf3d228f443e3ca4d62b59aca84e990cacaf5c5"
+         "2b0930daa23de94ce87017ba2d84988ddfc9c58db67aada613c2dd08457941a6"},
+    };
+
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        ASSERT_TRUE(SetAESImplementation(impl));
+        for (const auto& v : vectors) {
+            AESContext ctx(Hex(v.key));
+            auto counter = Hex(SP800_38A_CTR_IV);
+            std::vector<Byte> out(plain.size());
+            ctx.CTR(counter.data(), plain.data(), out.data(), 4);
+            EXPECT_EQ(ToHex(out), v.cipher) << AESImplementationName(impl);
+            // ...fcfdfeff + 4 carries out of the low bytes
+            EXPECT_EQ(ToHex(counter), "f0f1f2f3f4f5f6f7f8f9fafbfcfdff03");
+
+            // A short tail only uses part of the last keystream block
+            std::vector<Byte> shortPlain(plain.begin(), plain.begin() + 37);
+            AESEncryptor enc(Hex(v.key), AESMode::CTR, Hex(SP800_38A_CTR_IV));
+            std::vector<Byte> shortOut(shortPlain.size());
+            EXPECT_EQ(enc.Update(shortPlain.data(), shortPlain.size(), shortOut.data()), 37u);
+            EXPECT_EQ(ToHex(shortOut), v.cipher.substr(0, 74)) << AESImplementationName(impl);
+        }
+    }
+}
+
+TEST_F(AESImplTest, CTRCounterCarriesAcross64Bits) {
+    // The whole 128-bit block is the counter, as in SP 800-38A and OpenSSL
+    const auto key = PatternBytes(32, 1);
+    const auto start = Hex("0102030405060708fffffffffffffffe");
+    const Byte zero[16 * 20] = {};
+
+    std::vector<std::vector<Byte>> expected;
+    {
+        ASSERT_TRUE(SetAESImplementation(AESImplementation::SCALAR));
+        AESContext ctx(key);
+        auto counter = start;
+        for (int i = 0; i < 20; ++i) {
+            std::vector<Byte> block(16);
+            ctx.EncryptBlock(counter.data(), block.data());
+            expected.push_back(block);
+            for (int j = 15; j >= 0 && ++counter[j] == 0; --j) {
+            }
+        }
+        EXPECT_EQ(ToHex(counter), "01020304050607090000000000000012");
+    }
+
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        ASSERT_TRUE(SetAESImplementation(impl));
+        AESContext ctx(key);
+        auto counter = start;
+        std::vector<Byte> out(sizeof(zero));
+        ctx.CTR(counter.data(), zero, out.data(), 20);
+        EXPECT_EQ(ToHex(counter), "01020304050607090000000000000012")
+            << AESImplementationName(impl);
+        for (size_t i = 0; i < 20; ++i) {
+            EXPECT_TRUE(std::equal(expected[i].begin(), expected[i].end(), out.begin() + 16 * i))
+                << AESImplementationName(impl) << " block " << i;
+        }
+    }
+}
+
+// ============================================================================
+// Implementations and Streaming
+// ============================================================================
+
+TEST_F(AESImplTest, ImplementationsAgreeWithScalar) {
+    // Block counts on both sides of the eight-block batches
+    const size_t counts[] = {1, 7, 8, 9, 16, 37};
+    const auto data = PatternBytes(16 * 37, 5);
+    struct Result { std::vector<Byte> ecb, ecbInv, cbc, cbcInv, ctr; };
+
+    for (size_t keyLen : {16, 24, 32}) {
+        const auto key = PatternBytes(keyLen, keyLen);
+        const auto iv = PatternBytes(16, 99);
+        auto run = [&](size_t blocks) {
+            AESContext ctx(key);
+            Result r;
+            size_t len = 16 * blocks;
+            r.ecb.resize(len);
+            r.ecbInv.resize(len);
+            r.cbc.resize(len);
+            r.cbcInv.resize(len);
+            r.ctr.resize(len);
+            ctx.EncryptBlocks(data.data(), r.ecb.data(), blocks);
+            ctx.DecryptBlocks(data.data(), r.ecbInv.data(), blocks);
+            auto chain = iv;
+            ctx.EncryptCBC(chain.data(), data.data(), r.cbc.data(), blocks);
+            chain = iv;
+            ctx.DecryptCBC(chain.data(), data.data(), r.cbcInv.data(), blocks);
+            chain = iv;
+            ctx.CTR(chain.data(), data.data(), r.ctr.data(), blocks);
+            return r;
+        };
+
+        ASSERT_TRUE(SetAESImplementation(AESImplementation::SCALAR));
+        std::vector<Result> expected;
+        for (size_t blocks : counts) {
+            expected.push_back(run(blocks));
+        }
+
+        for (AESImplementation impl : GetAvailableAESImplementations()) {
+            ASSERT_TRUE(SetAESImplementation(impl));
+            for (size_t i = 0; i < std::size(counts); ++i) {
+                Result r = run(counts[i]);
+                const char* name = AESImplementationName(impl);
+                EXPECT_EQ(r.ecb, expected[i].ecb) << name << " key " << keyLen;
+                EXPECT_EQ(r.ecbInv, expected[i].ecbInv) << name << " key " << keyLen;
+                EXPECT_EQ(r.cbc, expected[i].cbc) << name << " key " << keyLen;
+                EXPECT_EQ(r.cbcInv, expected[i].cbcInv) << name << " key " << keyLen;
+                EXPECT_EQ(r.ctr, expected[i].ctr) << name << " key " << keyLen;
+            }
+        }
+    }
+}
+
+TEST_F(AESImplTest, StreamingUpdatesMatchOneShot) {
+    const auto key = PatternBytes(32, 3);
+    const auto iv = PatternBytes(16, 4);
+    const auto plain = PatternBytes(16 * 21 + 5, 6);
+
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        ASSERT_TRUE(SetAESImplementation(impl));
+        const char* name = AESImplementationName(impl);
+        for (AESMode mode : {AESMode::CBC, AESMode::CTR}) {
+            auto oneShot = AESEncryptor(key, mode, iv).Encrypt(plain);
+
+            // Chunk sizes that leave partial blocks, fill them and span several
+            for (size_t chunk : {1, 5, 16, 17, 131}) {
+                AESEncryptor enc(key, mode, iv);
+                std::vector<Byte> cipher(plain.size() + 16);
+                size_t len = 0;
+                for (size_t pos = 0; pos < plain.size(); pos += chunk) {
+                    len += enc.Update(plain.data() + pos,
+                                      std::min(chunk, plain.size() - pos), cipher.data() + len);
+                }
+                len += enc.Finalize(cipher.data() + len);
+                cipher.resize(len);
+                EXPECT_EQ(cipher, oneShot) << name << " chunk " << chunk;
+
+                AESDecryptor dec(key, mode, iv);
+                std::vector<Byte> decrypted(cipher.size());
+                len = 0;
+                for (size_t pos = 0; pos < cipher.size(); pos += chunk) {
+                    len += dec.Update(cipher.data() + pos,
+                                      std::min(chunk, cipher.size() - pos), decrypted.data() + len);
+                }
+                len += dec.Finalize(decrypted.data() + len);
+                decrypted.resize(len);
+                EXPECT_EQ(decrypted, plain) << name << " chunk " << chunk;
+            }
+        }
+    }
+}
+
+TEST_F(AESImplTest, InvalidPaddingIsRejected) {
+    const auto key = PatternBytes(32, 7);
+    const auto iv = PatternBytes(16, 8);
+    const auto plain = PatternBytes(40, 9);
+
+    for (AESImplementation impl : GetAvailableAESImplementations()) {
+        ASSERT_TRUE(SetAESImplementation(impl));
+        auto cipher = AESEncryptor(key, AESMode::CBC, iv).Encrypt(plain);
+        ASSERT_EQ(cipher.size(), 48u);
+
+        // Flipping the previous block's last byte flips the pad byte
+        auto corrupt = cipher;
+        corrupt[31] ^= 0x40;
+        EXPECT_THROW(AESDecryptor(key, AESMode::CBC, iv).Decrypt(corrupt), std::runtime_error)
+            << AESImplementationName(impl);
+
+        std::vector<Byte> truncated(cipher.begin(), cipher.end() - 3);
+        EXPECT_THROW(AESDecryptor(key, AESMode::CBC, iv).Decrypt(truncated), std::runtime_error)
+            << AESImplementationName(impl);
+    }
+}
+
+#ifdef SHURIUM_USE_OPENSSL
+TEST_F(AESImplTest, MatchesOpenSSL) {
+    const auto plain = PatternBytes(16 * 19 + 11, 10);
+    const auto iv = Hex("00000000000000001122334455fffffe");
+
+    for (size_t keyLen : {16, 24, 32}) {
+        const auto key = PatternBytes(keyLen, 11);
+        for (AESMode mode : {AESMode::CBC, AESMode::CTR}) {
+            const EVP_CIPHER* cipher = nullptr;
+            switch (keyLen) {
+                case 16: cipher = mode == AESMode::CTR ? EVP_aes_128_ctr() : EVP_aes_128_cbc(); break;
+                case 24: cipher = mode == AESMode::CTR ? EVP_aes_192_ctr() : EVP_aes_192_cbc(); break;
+                default: cipher = mode == AESMode::CTR ? EVP_aes_256_ctr() : EVP_aes_256_cbc(); break;
+            }
+            EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+            ASSERT_NE(ctx, nullptr);
+            std::vector<Byte> expected(plain.size() + 16);
+            int len = 0, finalLen = 0;
+            ASSERT_EQ(EVP_EncryptInit_ex(ctx, cipher, nullptr, key.data(), iv.data()), 1);
+            ASSERT_EQ(EVP_EncryptUpdate(ctx, expected.data(), &len, plain.data(),
+                                        static_cast<int>(plain.size())), 1);
+            ASSERT_EQ(EVP_EncryptFinal_ex(ctx, expected.data() + len, &finalLen), 1);
+            expected.resize(static_cast<size_t>(len + finalLen));
+            EVP_CIPHER_CTX_free(ctx);
+
+            for (AESImplementation impl : GetAvailableAESImplementations()) {
+                ASSERT_TRUE(SetAESImplementation(impl));
+                EXPECT_EQ(AESEncryptor(key, mode, iv).Encrypt(plain), expected)
+                    << AESImplementationName(impl) << " key " << keyLen;
+                EXPECT_EQ(AESDecryptor(key, mode, iv).Decrypt(expected), plain)
+                    << AESImplementationName(impl) << " key " << keyLen;
+            }
+        }
+    }
+}
+#endif
+
+} // namespace test
+} // namespace shurium
@@ -0,0 +1,80 @@
+// SHURIUM - HMAC Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/hmac.h"
+#include "shurium/core/hex.h"
+
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace test {
+
+static std::vector<Byte> SequentialBytes(size_t len) {
+    std::vector<Byte> data(len);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<Byte>(i);
+    }
+    return data;
+}
+
+static std::string MidstateHex(const std::vector<Byte>& key, const std::string& data) {
+    HMAC_SHA512_Midstate hmac(key.data(), key.size());
+    auto mac = hmac.Compute(reinterpret_cast<const Byte*>(data.data()), data.size());
+    return BytesToHex(mac.data(), mac.size());
+}
+
+// ============================================================================
+// HMAC_SHA512_Midstate
+// ============================================================================
+
+TEST(HMACSHA512MidstateTest, RFC4231Vectors) {
+    // Test case 1
+    EXPECT_EQ(MidstateHex(std::vector<Byte>(20, 0x0b), "Hi There"),
+              "87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cde"
+              "daa833b7d6b8a702038b274eaea3f4e4be9d914eeb61f1702e696c203a126854");
+
+    // Test case 6: a 131-byte key is hashed down first
+    EXPECT_EQ(MidstateHex(std::vector<Byte>(131, 0xaa),
+                          "Test Using Larger Than Block-Size Key - Hash Key First"),
+              "80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f352"
+              "6b56d037e05f2598bd0fd2215d6a1e5295e64f73f63f0aec8b915a985d786598");
+
+    // Empty key and message
+    EXPECT_EQ(MidstateHex({}, ""),
+              "b936cee86c9f87aa5d3c6f2e84cb5a4239a5fe50480a6ec66b70ab5b1f4ac673"
+              "0c6c515421b327ec1d69402e53dfb49ad7381eb067b338fd7b0cb22247225d47");
+}
+
+TEST(HMACSHA512MidstateTest, MatchesHMAC_SHA512) {
+    // Key lengths around the 128-byte block, message lengths around the
+    // 112-byte padding boundary and past one block
+    for (size_t keyLen : {0, 1, 32, 127, 128, 129, 200}) {
+        auto key = SequentialBytes(keyLen);
+        HMAC_SHA512_Midstate hmac(key.data(), key.size());
+        for (size_t dataLen : {0, 37, 111, 112, 128, 300}) {
+            auto data = SequentialBytes(dataLen);
+            EXPECT_EQ(hmac.Compute(data.data(), data.size()),
+                      ComputeHMAC_SHA512(key, data))
+                << "key " << keyLen << ", data " << dataLen;
+        }
+    }
+}
+
+TEST(HMACSHA512MidstateTest, CopiesAreIndependent) {
+    auto key = SequentialBytes(32);
+    auto data = SequentialBytes(37);
+    HMAC_SHA512_Midstate a(key.data(), key.size());
+    HMAC_SHA512_Midstate b = a;
+    EXPECT_EQ(a.Compute(data.data(), data.size()), b.Compute(data.data(), data.size()));
+
+    auto otherKey = SequentialBytes(33);
+    b = HMAC_SHA512_Midstate(otherKey.data(), otherKey.size());
+    EXPECT_EQ(a.Compute(data.data(), data.size()), ComputeHMAC_SHA512(key, data));
+    EXPECT_EQ(b.Compute(data.data(), data.size()), ComputeHMAC_SHA512(otherKey, data));
+}
+
+} // namespace test
+} // namespace shurium
@@ -0,0 +1,155 @@
+// SHURIUM - MuHash Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/muhash.h"
+#include "shurium/core/serialize.h"
+#include "shurium/core/types.h"
+
+#include <cstring>
+#include <string>
+
+namespace shurium {
+namespace test {
+
+static MuHash3072& InsertString(MuHash3072& hash, const std::string& element) {
+    return hash.Insert(reinterpret_cast<const Byte*>(element.data()), element.size());
+}
+
+static MuHash3072& RemoveString(MuHash3072& hash, const std::string& element) {
+    return hash.Remove(reinterpret_cast<const Byte*>(element.data()), element.size());
+}
+
+static Num3072 NumFromSeed(Byte seed) {
+    Byte bytes[Num3072::BYTE_SIZE];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = static_cast<Byte>(seed * 31 + i * 7);
+    }
+    return Num3072(bytes);
+}
+
+// ============================================================================
+// Num3072
+// ============================================================================
+
+TEST(Num3072Test, InverseOfOneIsOne) {
+    Num3072 one;
+    EXPECT_EQ(one.GetInverse(), one);
+}
+
+TEST(Num3072Test, MultiplyByInverseIsOne) {
+    for (Byte seed : {1, 2, 200}) {
+        Num3072 a = NumFromSeed(seed);
+        Num3072 product = a;
+        product.Multiply(a.GetInverse());
+        EXPECT_EQ(product, Num3072()) << "seed " << int(seed);
+    }
+}
+
+TEST(Num3072Test, DivideUndoesMultiply) {
+    Num3072 a = NumFromSeed(3);
+    Num3072 b = NumFromSeed(4);
+    Num3072 x = a;
+    x.Multiply(b);
+    EXPECT_NE(x, a);
+    x.Divide(b);
+    EXPECT_EQ(x, a);
+}
+
+TEST(Num3072Test, ValuesAboveThePrimeAreReduced) {
+    // p + 1 reduces to 1
+    Byte bytes[Num3072::BYTE_SIZE];
+    std::memset(bytes, 0xff, sizeof(bytes));
+    uint64_t low = ~uint64_t{0} - Num3072::MAX_PRIME_DIFF + 2;
+    for (size_t i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<Byte>(low >> (8 * i));
+    }
+    EXPECT_EQ(Num3072(bytes), Num3072());
+}
+
+TEST(Num3072Test, ByteRoundTrip) {
+    Num3072 a = NumFromSeed(9);
+    Byte bytes[Num3072::BYTE_SIZE];
+    a.ToBytes(bytes);
+    EXPECT_EQ(Num3072(bytes), a);
+}
+
+// ============================================================================
+// MuHash3072
+// ============================================================================
+
+TEST(MuHashTest, OrderIndependent) {
+    MuHash3072 a, b;
+    InsertString(InsertString(InsertString(a, "one"), "two"), "three");
+    InsertString(InsertString(InsertString(b, "three"), "one"), "two");
+    EXPECT_EQ(a.Finalize(), b.Finalize());
+}
+
+TEST(MuHashTest, DistinctSetsDiffer) {
+    MuHash3072 a, b, c;
+    InsertString(a, "one");
+    InsertString(b, "two");
+    InsertString(InsertString(c, "one"), "one");
+    EXPECT_NE(a.Finalize(), b.Finalize());
+    EXPECT_NE(a.Finalize(), c.Finalize());
+    EXPECT_NE(a.Finalize(), MuHash3072().Finalize());
+}
+
+TEST(MuHashTest, RemoveUndoesInsert) {
+    MuHash3072 hash;
+    InsertString(hash, "kept");
+    InsertString(hash, "dropped");
+    RemoveString(hash, "dropped");
+
+    MuHash3072 expected;
+    InsertString(expected, "kept");
+    EXPECT_EQ(hash.Finalize(), expected.Finalize());
+
+    RemoveString(hash, "kept");
+    EXPECT_EQ(hash.Finalize(), MuHash3072().Finalize());
+}
+
+TEST(MuHashTest, CombineDeltas) {
+    MuHash3072 base;
+    InsertString(InsertString(base, "a"), "b");
+
+    // A delta that spends "a" and creates "c"
+    MuHash3072 delta;
+    RemoveString(delta, "a");
+    InsertString(delta, "c");
+    base *= delta;
+
+    MuHash3072 expected;
+    InsertString(InsertString(expected, "b"), "c");
+    EXPECT_EQ(base.Finalize(), expected.Finalize());
+
+    base /= delta;
+    MuHash3072 original;
+    InsertString(InsertString(original, "a"), "b");
+    EXPECT_EQ(base.Finalize(), original.Finalize());
+}
+
+TEST(MuHashTest, IsEmpty) {
+    MuHash3072 hash;
+    EXPECT_TRUE(hash.IsEmpty());
+    InsertString(hash, "x");
+    EXPECT_FALSE(hash.IsEmpty());
+}
+
+TEST(MuHashTest, SerializeRoundTrip) {
+    MuHash3072 hash;
+    InsertString(InsertString(hash, "in"), "also in");
+    RemoveString(hash, "out");
+
+    DataStream ss;
+    Serialize(ss, hash);
+    EXPECT_EQ(ss.size(), MuHash3072::SERIALIZED_SIZE);
+
+    MuHash3072 read;
+    Unserialize(ss, read);
+    EXPECT_EQ(read.Finalize(), hash.Finalize());
+}
+
+} // namespace test
+} // namespace shurium
@@ -9,9 +9,14 @@
 #include "shurium/crypto/poseidon.h"
 #include "shurium/core/types.h"
 
+#include <random>
 #include <string>
 #include <vector>
 
+#ifdef SHURIUM_USE_OPENSSL
+#include <openssl/bn.h>
+#endif
+
 namespace shurium {
 namespace test {
 
@@ -182,6 +187,80 @@ TEST(FieldElementTest, Power) {
     EXPECT_EQ(r10.ToUint256().limbs[0], 1024ULL);
 }
 
+TEST(FieldElementTest, KnownAnswers) {
+    FieldElement a = FieldElement::FromHex(
+        "0x1234567890abcdef1234567890abcdef1234567890abcdef1234567890abcdef");
+    FieldElement b(5);
+    
+    EXPECT_EQ((a * a * b).ToUint256().ToHex(),
+              "270513935b59a2388218abc537a59d80a09028589b90915d96417eecad9c3757");
+    EXPECT_EQ(a.Inverse().ToUint256().ToHex(),
+              "2bb13c11312079eabcc30b313613a9e013db48335cbdb86b9b83ed107fcaea83");
+}
+
+TEST(FieldElementTest, UnreducedInputsAreReduced) {
+    // Construction accepts any 256-bit value and reduces it mod p
+    EXPECT_TRUE(FieldElement(FieldElement::MODULUS).IsZero());
+    
+    Uint256 max(~0ULL, ~0ULL, ~0ULL, ~0ULL);
+    EXPECT_EQ(FieldElement(max), FieldElement(FieldElement::R) - FieldElement::One());
+    EXPECT_LT(FieldElement(max).ToUint256(), FieldElement::MODULUS);
+}
+
+#ifdef SHURIUM_USE_OPENSSL
+TEST(FieldElementTest, MatchesOpenSSL) {
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM* p = BN_new();
+    BIGNUM* x = BN_new();
+    BIGNUM* y = BN_new();
+    BIGNUM* r = BN_new();
+    auto toBN = [](const FieldElement& fe, BIGNUM* bn) {
+        auto bytes = fe.ToBytes();
+        BN_lebin2bn(bytes.data(), 32, bn);
+    };
+    auto fromBN = [](const BIGNUM* bn) {
+        std::array<Byte, 32> bytes{};
+        BN_bn2lebinpad(bn, bytes.data(), 32);
+        return FieldElement::FromBytes(bytes.data(), 32);
+    };
+    auto modulusBytes = FieldElement::MODULUS.ToBytes();
+    BN_lebin2bn(modulusBytes.data(), 32, p);
+    
+    // Edge values near 0 and p, then random ones
+    std::vector<FieldElement> samples = {
+        FieldElement::Zero(), FieldElement::One(), FieldElement(2),
+        -FieldElement::One(), -FieldElement(2), FieldElement(FieldElement::R),
+    };
+    std::mt19937_64 rng(34);
+    for (int i = 0; i < 200; ++i) {
+        Uint256 v(rng(), rng(), rng(), rng());
+        samples.push_back(FieldElement(v));
+    }
+    
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const FieldElement& a = samples[i];
+        const FieldElement& b = samples[(i * 7 + 3) % samples.size()];
+        toBN(a, x);
+        toBN(b, y);
+        
+        BN_mod_mul(r, x, y, p, ctx);
+        EXPECT_EQ(a * b, fromBN(r));
+        BN_mod_sqr(r, x, p, ctx);
+        EXPECT_EQ(a.Square(), fromBN(r));
+        BN_mod_add(r, x, y, p, ctx);
+        EXPECT_EQ(a + b, fromBN(r));
+        BN_mod_sub(r, x, y, p, ctx);
+        EXPECT_EQ(a - b, fromBN(r));
+    }
+    
+    BN_free(r);
+    BN_free(y);
+    BN_free(x);
+    BN_free(p);
+    BN_CTX_free(ctx);
+}
+#endif
+
 // ============================================================================
 // Poseidon Hash Tests
 // ============================================================================
@@ -316,6 +395,83 @@ TEST(PoseidonTest, MultipleSqueezes) {
     EXPECT_NE(result1, result2);
 }
 
+TEST(PoseidonTest, KnownAnswers) {
+    // Pinned outputs: the optimized partial rounds must reproduce the
+    // textbook permutation exactly
+    EXPECT_EQ(Poseidon::Hash2(FieldElement(1), FieldElement(2)).ToUint256().ToHex(),
+              "23027ec8753197fe2b4f76c6f01ddd9c598188bac366159f65afbca3b3741de7");
+    EXPECT_EQ(Poseidon::Hash({FieldElement(1), FieldElement(2), FieldElement(3), FieldElement(4)})
+                  .ToUint256().ToHex(),
+              "067379844d45935a0c6a5c52204ccc46b024f820143bae0a6dbb48949702f68a");
+    EXPECT_EQ(Poseidon::Hash({FieldElement(0)}).ToUint256().ToHex(),
+              "10c5f2212fc64f6252929014afa690cf921aba7d8777c930eb1bb003cf8f69fd");
+    
+    const Byte data[] = {0x01, 0x02, 0x03, 0x04};
+    EXPECT_EQ(Poseidon::HashBytes(data, sizeof(data)).ToUint256().ToHex(),
+              "0494db98b2c0e085b34a01a75f87fb305044e87737eaba3524dd6afe91fc4bca");
+    
+    // Squeezing past the rate runs further permutations
+    Poseidon hasher(PoseidonParams::CONFIG_2_1);
+    hasher.Absorb(FieldElement(7));
+    auto out = hasher.Squeeze(3);
+    EXPECT_EQ(out[0].ToUint256().ToHex(),
+              "02dea491e6ffafe1f15507b41530d97e310112807b7bb1510f398a499d1348e3");
+    EXPECT_EQ(out[1].ToUint256().ToHex(),
+              "28692c484922a1f42a5501e13b1b6e3da5ec40bf9db1d86b84ff9944d503ea10");
+    EXPECT_EQ(out[2].ToUint256().ToHex(),
+              "1578307ba179a48ac72296bc244e4203e2df81cfc253b7cbd32e858221168447");
+}
+
+TEST(PoseidonTest, HashManyMatchesHash2) {
+    // Lane counts below, at and past the interleave width
+    for (size_t n : {0, 1, 3, 4, 5, 9}) {
+        std::vector<std::pair<FieldElement, FieldElement>> pairs;
+        for (size_t i = 0; i < n; ++i) {
+            pairs.emplace_back(FieldElement(static_cast<uint64_t>(i)),
+                               -FieldElement(static_cast<uint64_t>(3 * i + 1)));
+        }
+        std::vector<FieldElement> hashes = Poseidon::HashMany(pairs);
+        ASSERT_EQ(hashes.size(), n);
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(hashes[i], Poseidon::Hash2(pairs[i].first, pairs[i].second)) << i;
+        }
+    }
+}
+
+TEST(PoseidonTest, ConstantsSharedPerConfiguration) {
+    PoseidonConfig same{3, 8, 57, 1};
+    EXPECT_EQ(&same.Constants(), &PoseidonParams::CONFIG_2_1.Constants());
+    EXPECT_EQ(&PoseidonParams::CONFIG_4_1.Constants(),
+              &PoseidonParams::CONFIG_STANDARD.Constants());
+    EXPECT_NE(&PoseidonParams::CONFIG_2_1.Constants(),
+              &PoseidonParams::CONFIG_4_1.Constants());
+}
+
+TEST(PoseidonTest, ConfigurationsWithoutSparseRounds) {
+    // No full round to absorb the sparse factorization: the dense partial
+    // rounds are used instead, and hashing still works
+    for (const PoseidonConfig& config : {PoseidonConfig{3, 0, 10, 1}, PoseidonConfig{3, 1, 10, 1},
+                                          PoseidonConfig{3, 8, 0, 1}}) {
+        Poseidon a(config);
+        Poseidon b(config);
+        a.Absorb(FieldElement(1)).Absorb(FieldElement(2));
+        b.Absorb(FieldElement(1)).Absorb(FieldElement(2));
+        FieldElement out = a.Squeeze();
+        EXPECT_EQ(out, b.Squeeze());
+        EXPECT_NE(out, Poseidon::Hash2(FieldElement(1), FieldElement(2)));
+    }
+}
+
+TEST(PoseidonTest, CopiedHasherContinuesIndependently) {
+    Poseidon hasher(PoseidonParams::CONFIG_2_1);
+    hasher.Absorb(FieldElement(1));
+    Poseidon copy = hasher;
+    hasher.Absorb(FieldElement(2));
+    copy.Absorb(FieldElement(2));
+    EXPECT_EQ(hasher.Squeeze(), copy.Squeeze());
+    EXPECT_EQ(copy.Squeeze(), hasher.Squeeze());
+}
+
 // ============================================================================
 // Merkle Tree Compatibility Test
 // ============================================================================
@@ -246,5 +246,53 @@ TEST(RIPEMD160Test, SingleCallFunction) {
     EXPECT_EQ(RIPEMDTestBytesToHex(result.data(), result.size()), expected);
 }
 
+// ============================================================================
+// Multi-Key Hash160 Tests
+// ============================================================================
+
+TEST(Hash160Test, CompressedKeyVector) {
+    // Hash160 of the generator point's compressed encoding
+    auto key = HexToBytes("0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798");
+    ASSERT_EQ(key.size(), 33u);
+    const std::string expected = "751e76e8199196d454941c45d1b3a323f1433bd6";
+    EXPECT_EQ(RIPEMDTestBytesToHex(Hash160FromData(key).data(), 20), expected);
+
+    Byte out[20];
+    Hash160_33(out, key.data(), 1);
+    EXPECT_EQ(RIPEMDTestBytesToHex(out, 20), expected);
+}
+
+TEST(Hash160Test, MultiKeyKernelsAgree) {
+    // Counts that leave remainders for every narrower kernel
+    const size_t KEYS = 37;
+    std::vector<Byte> in(33 * KEYS);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = static_cast<Byte>(i * 31 + (i >> 5));
+    }
+    std::vector<Byte> expected(20 * KEYS);
+    for (size_t i = 0; i < KEYS; ++i) {
+        Hash160 hash = Hash160FromData(in.data() + i * 33, 33);
+        std::memcpy(expected.data() + i * 20, hash.data(), 20);
+    }
+
+    size_t detectedWays = GetHash160Ways();
+    auto ways = GetAvailableHash160Ways();
+    ASSERT_FALSE(ways.empty());
+    EXPECT_EQ(ways.front(), detectedWays);
+    EXPECT_EQ(ways.back(), 1u);
+    EXPECT_FALSE(SetHash160Ways(3));
+
+    for (size_t width : ways) {
+        ASSERT_TRUE(SetHash160Ways(width));
+        for (size_t count : {size_t(0), size_t(1), size_t(5), size_t(16), KEYS}) {
+            std::vector<Byte> out(20 * count);
+            Hash160_33(out.data(), in.data(), count);
+            EXPECT_EQ(0, std::memcmp(out.data(), expected.data(), out.size()))
+                << width << "-way, " << count;
+        }
+    }
+    SetHash160Ways(detectedWays);
+}
+
 } // namespace test
 } // namespace shurium
@@ -0,0 +1,661 @@
+// SHURIUM - secp256k1 Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/secp256k1.h"
+#include "shurium/crypto/keys.h"
+#include "shurium/core/hex.h"
+#include "shurium/core/random.h"
+#include "shurium/crypto/sha256.h"
+#include "crypto/secp256k1_scalar.h"
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef SHURIUM_USE_OPENSSL
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#endif
+
+namespace shurium {
+namespace test {
+
+using namespace secp256k1;
+
+namespace {
+
+Scalar ScalarFromHex(const std::string& hex) {
+    auto bytes = HexToBytes(hex);
+    return Scalar(bytes);
+}
+
+std::string CompressedHex(const Point& p) {
+    auto bytes = p.ToCompressed();
+    return BytesToHex(bytes.data(), bytes.size());
+}
+
+Scalar RandomScalar() {
+    for (;;) {
+        std::array<uint8_t, 32> bytes;
+        GetRandBytes(bytes.data(), bytes.size());
+        Scalar k(bytes);
+        if (k.IsValid()) return k;
+    }
+}
+
+FieldElement FieldFromHex(const std::string& hex) {
+    auto bytes = HexToBytes(hex);
+    return FieldElement(bytes.data());
+}
+
+/// Boundary values for the 52-bit limbs and the reduction, then random ones
+std::vector<FieldElement> FieldSamples(size_t nRandom) {
+    std::vector<FieldElement> samples = {
+        FieldElement(),
+        FieldFromHex("0000000000000000000000000000000000000000000000000000000000000001"),
+        FieldFromHex("0000000000000000000000000000000000000000000000000000000000000002"),
+        FieldFromHex("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2E"),
+        FieldFromHex("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2D"),
+        FieldFromHex("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFE00000000"),
+        FieldFromHex("8000000000000000000000000000000000000000000000000000000000000000"),
+        FieldFromHex("0000FFFFFFFFFFFFF000000000000FFFFFFFFFFFFF0000000000000FFFFFFFFF"),
+        FieldFromHex("000000000000000000000000000000000000000000000000000FFFFFFFFFFFFF"),
+        FieldFromHex("0000000000000000000000000000000000000000000000000010000000000000"),
+        FieldFromHex("7AE96A2B657C07106E64479EAC3434E99CF0497512F58995C1396C28719501EE"),
+    };
+    for (size_t i = 0; i < nRandom; ++i) {
+        std::array<uint8_t, 32> bytes;
+        GetRandBytes(bytes.data(), bytes.size());
+        FieldElement fe(bytes);
+        if (fe.IsValid()) samples.push_back(fe);
+    }
+    return samples;
+}
+
+Hash256 HashOf(int i) {
+    std::string msg = "message " + std::to_string(i);
+    return SHA256Hash(reinterpret_cast<const uint8_t*>(msg.data()), msg.size());
+}
+
+#ifdef SHURIUM_USE_OPENSSL
+/// Reference field arithmetic: the BIGNUM code FieldElement used to run on
+class BNField {
+public:
+    BNField() : ctx_(BN_CTX_new()), p_(BN_bin2bn(FIELD_PRIME.data(), 32, nullptr)) {}
+    ~BNField() {
+        BN_free(p_);
+        BN_CTX_free(ctx_);
+    }
+
+    template <typename Op>
+    FieldElement Apply(const FieldElement& a, const FieldElement& b, Op op) {
+        BIGNUM* x = BN_bin2bn(a.data(), 32, nullptr);
+        BIGNUM* y = BN_bin2bn(b.data(), 32, nullptr);
+        BIGNUM* r = BN_new();
+        op(r, x, y, p_, ctx_);
+        std::array<uint8_t, 32> out{};
+        BN_bn2binpad(r, out.data(), 32);
+        BN_free(x);
+        BN_free(y);
+        BN_free(r);
+        return FieldElement(out);
+    }
+
+private:
+    BN_CTX* ctx_;
+    BIGNUM* p_;
+};
+
+/// The verifier PublicKey::Verify used before the native path
+bool OpenSSLVerify(const Hash256& hash, const std::vector<uint8_t>& sig,
+                   const std::vector<uint8_t>& pubkey) {
+    char group[] = "secp256k1";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, group, 0),
+        OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY,
+                                          const_cast<uint8_t*>(pubkey.data()), pubkey.size()),
+        OSSL_PARAM_construct_end(),
+    };
+    EVP_PKEY_CTX* keyCtx = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+    EVP_PKEY* key = nullptr;
+    int result = -1;
+    if (keyCtx && EVP_PKEY_fromdata_init(keyCtx) == 1 &&
+        EVP_PKEY_fromdata(keyCtx, &key, EVP_PKEY_PUBLIC_KEY, params) == 1) {
+        EVP_PKEY_CTX* verifyCtx = EVP_PKEY_CTX_new_from_pkey(nullptr, key, nullptr);
+        if (verifyCtx && EVP_PKEY_verify_init(verifyCtx) == 1) {
+            result = EVP_PKEY_verify(verifyCtx, sig.data(), sig.size(), hash.data(), 32);
+        }
+        EVP_PKEY_CTX_free(verifyCtx);
+    }
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(keyCtx);
+    return result == 1;
+}
+#endif
+
+} // namespace
+
+// ============================================================================
+// Field Arithmetic Tests
+// ============================================================================
+
+#ifdef SHURIUM_USE_OPENSSL
+TEST(FieldArithmeticTest, MatchesOpenSSL) {
+    BNField bn;
+    auto samples = FieldSamples(64);
+    auto add = [](BIGNUM* r, BIGNUM* x, BIGNUM* y, BIGNUM* p, BN_CTX* ctx) {
+        BN_mod_add(r, x, y, p, ctx);
+    };
+    auto sub = [](BIGNUM* r, BIGNUM* x, BIGNUM* y, BIGNUM* p, BN_CTX* ctx) {
+        BN_mod_sub(r, x, y, p, ctx);
+    };
+    auto mul = [](BIGNUM* r, BIGNUM* x, BIGNUM* y, BIGNUM* p, BN_CTX* ctx) {
+        BN_mod_mul(r, x, y, p, ctx);
+    };
+    auto inv = [](BIGNUM* r, BIGNUM* x, BIGNUM*, BIGNUM* p, BN_CTX* ctx) {
+        if (!BN_mod_inverse(r, x, p, ctx)) BN_zero(r);
+    };
+    for (const auto& a : samples) {
+        for (const auto& b : samples) {
+            EXPECT_EQ(a + b, bn.Apply(a, b, add));
+            EXPECT_EQ(a - b, bn.Apply(a, b, sub));
+            EXPECT_EQ(a * b, bn.Apply(a, b, mul));
+        }
+        EXPECT_EQ(a.Square(), bn.Apply(a, a, mul));
+        EXPECT_EQ(-a, bn.Apply(FieldElement(), a, sub));
+        EXPECT_EQ(a.Inverse(), bn.Apply(a, a, inv));
+
+        // Euler's criterion: a is a square iff a^((p-1)/2) is not -1
+        std::array<uint8_t, 32> exp = FIELD_PRIME;
+        exp[31] -= 1;
+        BIGNUM* e = BN_bin2bn(exp.data(), 32, nullptr);
+        BN_rshift1(e, e);
+        FieldElement euler = bn.Apply(a, a, [e](BIGNUM* r, BIGNUM* x, BIGNUM*, BIGNUM* p,
+                                                BN_CTX* ctx) { BN_mod_exp(r, x, e, p, ctx); });
+        BN_free(e);
+        bool isSquare = euler != -FieldFromHex(
+            "0000000000000000000000000000000000000000000000000000000000000001");
+        auto root = a.Sqrt();
+        if (root) {
+            EXPECT_EQ(root->Square(), a);
+        }
+        EXPECT_EQ(root.has_value(), isSquare);
+    }
+}
+
+TEST(FieldArithmeticTest, LazyReductionChainsMatchOpenSSL) {
+    // Long mixed chains keep every intermediate weakly normalized only;
+    // compare against fully reduced reference values at every step
+    using namespace secp256k1::field;
+    BNField bn;
+    auto samples = FieldSamples(16);
+    auto mul = [](BIGNUM* r, BIGNUM* x, BIGNUM* y, BIGNUM* p, BN_CTX* ctx) {
+        BN_mod_mul(r, x, y, p, ctx);
+    };
+    auto toFe = [](const FieldElement& a) {
+        Fe r;
+        FeFromBytes(r, a.data());
+        return r;
+    };
+    auto toField = [](const Fe& a) {
+        std::array<uint8_t, 32> out;
+        FeToBytes(out.data(), a);
+        return FieldElement(out);
+    };
+
+    FieldElement refAcc = samples[3];
+    Fe acc = toFe(refAcc);
+    for (int round = 0; round < 500; ++round) {
+        const FieldElement& s = samples[round % samples.size()];
+        Fe x = toFe(s);
+        switch (round % 5) {
+        case 0:
+            acc = FeAdd(acc, x);
+            refAcc = refAcc + s;
+            break;
+        case 1:
+            acc = FeSub(acc, FeMulInt(x, 21));
+            refAcc = refAcc - bn.Apply(s, FieldFromHex(
+                "0000000000000000000000000000000000000000000000000000000000000015"), mul);
+            break;
+        case 2:
+            acc = FeMul(acc, FeAdd(x, x));
+            refAcc = bn.Apply(refAcc, s + s, mul);
+            break;
+        case 3:
+            acc = FeSqr(FeNeg(acc));
+            refAcc = bn.Apply(refAcc, refAcc, mul);
+            break;
+        default:
+            acc = FeMul(FeInv(acc), x);
+            refAcc = bn.Apply(refAcc.Inverse(), s, mul);
+            break;
+        }
+        ASSERT_EQ(toField(acc), refAcc) << "round " << round;
+        EXPECT_EQ(FeIsZero(acc), refAcc.IsZero());
+        EXPECT_EQ(FeIsOdd(acc), refAcc.IsOdd());
+    }
+}
+#endif
+
+TEST(FieldArithmeticTest, InverseIdentities) {
+    FieldElement one = FieldFromHex(
+        "0000000000000000000000000000000000000000000000000000000000000001");
+    EXPECT_TRUE(FieldElement().Inverse().IsZero());
+    EXPECT_EQ(one.Inverse(), one);
+    EXPECT_EQ((-one).Inverse(), -one);
+    for (const auto& a : FieldSamples(64)) {
+        if (a.IsZero()) continue;
+        EXPECT_EQ(a * a.Inverse(), one);
+        EXPECT_EQ(a.Inverse().Inverse(), a);
+    }
+}
+
+TEST(FieldArithmeticTest, ScalarInverseMatchesScalar) {
+    // The safegcd scalar inverse against Scalar::Inverse
+    for (int i = 0; i < 64; ++i) {
+        Scalar k = i == 0 ? Scalar::FromInt(1) : (i == 1 ? -Scalar::FromInt(1) : RandomScalar());
+        secp256k1::scalar::Sc sc;
+        secp256k1::scalar::ScFromBytes(sc, k.data());
+        std::array<uint8_t, 32> out;
+        secp256k1::scalar::ScToBytes(out.data(), secp256k1::scalar::ScInv(sc));
+        EXPECT_EQ(Scalar(out), k.Inverse());
+    }
+    secp256k1::scalar::Sc zero = secp256k1::scalar::SC_ZERO;
+    EXPECT_TRUE(secp256k1::scalar::ScIsZero(secp256k1::scalar::ScInv(zero)));
+}
+
+// ============================================================================
+// ScalarBaseMultiply Tests
+// ============================================================================
+
+TEST(ScalarBaseMultiplyTest, KnownMultiples) {
+    auto one = ScalarBaseMultiply(Scalar::FromInt(1));
+    ASSERT_TRUE(one);
+    EXPECT_EQ(*one, Point::Generator());
+
+    auto two = ScalarBaseMultiply(Scalar::FromInt(2));
+    ASSERT_TRUE(two);
+    EXPECT_EQ(CompressedHex(*two),
+              "02c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5");
+
+    auto three = ScalarBaseMultiply(Scalar::FromInt(3));
+    ASSERT_TRUE(three);
+    EXPECT_EQ(CompressedHex(*three),
+              "02f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9");
+
+    // (n-1)*G = -G
+    auto minusOne = ScalarBaseMultiply(
+        ScalarFromHex("fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140"));
+    ASSERT_TRUE(minusOne);
+    EXPECT_EQ(*minusOne, -Point::Generator());
+}
+
+TEST(ScalarBaseMultiplyTest, RejectsInvalidScalars) {
+    EXPECT_FALSE(ScalarBaseMultiply(Scalar()));
+    EXPECT_FALSE(ScalarBaseMultiply(
+        ScalarFromHex("fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141")));
+
+    uint8_t pubkey[65];
+    uint8_t zero[32] = {};
+    EXPECT_FALSE(ComputePublicKey(zero, pubkey, true));
+}
+
+TEST(ScalarBaseMultiplyTest, MatchesGenericMultiply) {
+    // Every window digit, including all-zero and all-ones windows
+    std::vector<Scalar> scalars = {
+        ScalarFromHex("0000000000000000000000000000000000000000000000000000000000000010"),
+        ScalarFromHex("00000000000000000000000000000000ffffffffffffffffffffffffffffffff"),
+        Scalar::FromInt(0x0123456789abcdefULL),
+        ScalarFromHex("7fffffffffffffffffffffffffffffff5d576e7357a4501ddfe92f46681b20a0"),
+    };
+    for (int i = 0; i < 32; ++i) {
+        scalars.push_back(RandomScalar());
+    }
+
+    Point G = Point::Generator();
+    for (const Scalar& k : scalars) {
+        if (!k.IsValid()) continue;
+        auto fast = ScalarBaseMultiply(k);
+        ASSERT_TRUE(fast);
+        EXPECT_TRUE(fast->IsOnCurve());
+        EXPECT_EQ(*fast, G * k) << BytesToHex(k.data(), 32);
+
+        uint8_t compressed[33], uncompressed[65];
+        ASSERT_TRUE(ComputePublicKey(k.data(), compressed, true));
+        ASSERT_TRUE(ComputePublicKey(k.data(), uncompressed, false));
+        auto expectedC = fast->ToCompressed();
+        auto expectedU = fast->ToUncompressed();
+        EXPECT_EQ(0, std::memcmp(compressed, expectedC.data(), 33));
+        EXPECT_EQ(0, std::memcmp(uncompressed, expectedU.data(), 65));
+    }
+}
+
+TEST(ScalarBaseMultiplyTest, PrivateKeyDerivesKnownPublicKey) {
+    PrivateKey key(HexToBytes("0000000000000000000000000000000000000000000000000000000000000001"));
+    ASSERT_TRUE(key.IsValid());
+    EXPECT_EQ(key.GetPublicKey().ToHex(),
+              "0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798");
+}
+
+// ============================================================================
+// PublicKeyTweakAdd Tests
+// ============================================================================
+
+TEST(PublicKeyTweakAddTest, BatchMatchesSingle) {
+    Scalar k = RandomScalar();
+    Point P = Point::Generator() * k;
+
+    // Random tweaks, then 0, n, and n - k, whose sum with P is infinity
+    std::vector<Scalar> tweaks;
+    for (int i = 0; i < 13; ++i) {
+        tweaks.push_back(RandomScalar());
+    }
+    std::vector<uint8_t> bytes;
+    for (const Scalar& t : tweaks) {
+        bytes.insert(bytes.end(), t.data(), t.data() + 32);
+    }
+    bytes.insert(bytes.end(), 32, 0);
+    bytes.insert(bytes.end(), CURVE_ORDER.begin(), CURVE_ORDER.end());
+    Scalar negK = -k;
+    bytes.insert(bytes.end(), negK.data(), negK.data() + 32);
+    const size_t count = bytes.size() / 32;
+
+    auto compressed = P.ToCompressed();
+    auto uncompressed = P.ToUncompressed();
+    for (size_t len : {size_t{33}, size_t{65}}) {
+        const uint8_t* pubkey = len == 33 ? compressed.data() : uncompressed.data();
+        std::vector<uint8_t> results(len * count);
+        std::unique_ptr<bool[]> valid(new bool[count]);
+        ASSERT_TRUE(PublicKeyTweakAddBatch(pubkey, len, bytes.data(), count,
+                                           results.data(), valid.get()));
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t expected[65];
+            bool ok = PublicKeyTweakAdd(pubkey, len, bytes.data() + 32 * i, expected);
+            ASSERT_EQ(valid[i], ok) << "tweak " << i;
+            if (ok) {
+                EXPECT_EQ(0, std::memcmp(results.data() + len * i, expected, len))
+                    << "tweak " << i;
+            }
+        }
+        EXPECT_FALSE(valid[count - 3]);
+        EXPECT_FALSE(valid[count - 2]);
+        EXPECT_FALSE(valid[count - 1]);
+    }
+
+    // An empty batch and an invalid key
+    bool unused = false;
+    EXPECT_TRUE(PublicKeyTweakAddBatch(compressed.data(), 33, bytes.data(), 0,
+                                       nullptr, &unused));
+    compressed[0] = 0x05;
+    std::vector<uint8_t> results(33);
+    EXPECT_FALSE(PublicKeyTweakAddBatch(compressed.data(), 33, bytes.data(), 1,
+                                        results.data(), &unused));
+}
+
+// ============================================================================
+// DoubleScalarMultiply Tests
+// ============================================================================
+
+TEST(DoubleScalarMultiplyTest, MatchesSeparateMultiplications) {
+    Point G = Point::Generator();
+    Scalar lambda = ScalarFromHex(
+        "5363ad4cc05c30e0a5261c028812645a122e22ea20816678df02967c1b23bd72");
+    Scalar nMinusOne = ScalarFromHex(
+        "fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364140");
+    std::vector<std::pair<Scalar, Scalar>> cases = {
+        {Scalar::FromInt(1), Scalar::FromInt(1)},
+        {lambda, lambda},
+        {nMinusOne, nMinusOne},
+        {ScalarFromHex("00000000000000000000000000000000ffffffffffffffffffffffffffffffff"),
+         ScalarFromHex("0000000000000000000000000000000100000000000000000000000000000000")},
+    };
+    for (int i = 0; i < 32; ++i) {
+        cases.emplace_back(RandomScalar(), RandomScalar());
+    }
+
+    for (const auto& [a, b] : cases) {
+        Point P = G * RandomScalar();
+        Point expected = G * a + P * b;
+        EXPECT_EQ(DoubleScalarMultiply(a, b, P), expected);
+    }
+}
+
+TEST(DoubleScalarMultiplyTest, EdgeCases) {
+    Point G = Point::Generator();
+    Scalar k = RandomScalar();
+    Point P = G * RandomScalar();
+
+    // Zero scalars drop their term
+    EXPECT_EQ(DoubleScalarMultiply(Scalar(), k, P), P * k);
+    EXPECT_EQ(DoubleScalarMultiply(k, Scalar(), P), G * k);
+    EXPECT_TRUE(DoubleScalarMultiply(Scalar(), Scalar(), P).IsInfinity());
+    EXPECT_EQ(DoubleScalarMultiply(k, k, Point::Infinity()), G * k);
+
+    // k*G + (-k)*G = infinity, k*G + k*G = 2k*G
+    EXPECT_TRUE(DoubleScalarMultiply(k, -k, G).IsInfinity());
+    EXPECT_EQ(DoubleScalarMultiply(k, k, G), G * (k + k));
+}
+
+// ============================================================================
+// Signature Verification Tests
+// ============================================================================
+
+#ifdef SHURIUM_USE_OPENSSL
+TEST(ECDSAVerifyTest, MatchesOpenSSL) {
+    for (int i = 0; i < 16; ++i) {
+        PrivateKey key = PrivateKey::Generate(i % 2 == 0);
+        std::vector<uint8_t> pubkey = key.GetPublicKey().ToVector();
+        Hash256 hash = HashOf(i);
+        std::vector<uint8_t> sig = key.Sign(hash);
+        ASSERT_TRUE(OpenSSLVerify(hash, sig, pubkey));
+        ParsedPublicKey parsed;
+        ASSERT_TRUE(ParsePublicKey(parsed, pubkey.data(), pubkey.size()));
+
+        std::vector<std::vector<uint8_t>> variants = {sig};
+        // Trailing garbage
+        variants.push_back(sig);
+        variants.back().push_back(0x00);
+        // Wrong sequence length
+        variants.push_back(sig);
+        variants.back()[1]++;
+        // Long-form sequence length
+        {
+            std::vector<uint8_t> v = {0x30, 0x81, sig[1]};
+            v.insert(v.end(), sig.begin() + 2, sig.end());
+            variants.push_back(v);
+        }
+        // Extra zero padding on r
+        {
+            std::vector<uint8_t> v = {0x30, static_cast<uint8_t>(sig[1] + 1), 0x02,
+                                      static_cast<uint8_t>(sig[3] + 1), 0x00};
+            v.insert(v.end(), sig.begin() + 4, sig.end());
+            variants.push_back(v);
+        }
+        // r with its sign byte dropped (negative when the top bit is set)
+        if (sig[3] == 33) {
+            std::vector<uint8_t> v = {0x30, static_cast<uint8_t>(sig[1] - 1), 0x02, 32};
+            v.insert(v.end(), sig.begin() + 5, sig.end());
+            variants.push_back(v);
+        }
+        // Flipped bits in r and s
+        variants.push_back(sig);
+        variants.back()[6] ^= 0x01;
+        variants.push_back(sig);
+        variants.back()[sig.size() - 1] ^= 0x01;
+        // High S: s' = n - s is still valid
+        {
+            size_t sPos = 4 + sig[3];
+            size_t sLen = sig[sPos + 1];
+            std::vector<uint8_t> sBytes(sig.begin() + sPos + 2, sig.begin() + sPos + 2 + sLen);
+            Scalar highS = -Scalar(sBytes);
+            std::vector<uint8_t> v(sig.begin(), sig.begin() + sPos);
+            v.push_back(0x02);
+            bool pad = highS.data()[0] & 0x80;
+            v.push_back(static_cast<uint8_t>(32 + pad));
+            if (pad) v.push_back(0x00);
+            v.insert(v.end(), highS.data(), highS.data() + 32);
+            v[1] = static_cast<uint8_t>(v.size() - 2);
+            variants.push_back(v);
+        }
+
+        for (size_t j = 0; j < variants.size(); ++j) {
+            const auto& v = variants[j];
+            EXPECT_EQ(key.GetPublicKey().Verify(hash, v), OpenSSLVerify(hash, v, pubkey))
+                << "key " << i << " variant " << j;
+            EXPECT_EQ(ECDSAVerify(hash.data(), v.data(), v.size(), pubkey.data(), pubkey.size()),
+                      OpenSSLVerify(hash, v, pubkey))
+                << "key " << i << " variant " << j;
+            EXPECT_EQ(ECDSAVerify(hash.data(), v.data(), v.size(), parsed),
+                      OpenSSLVerify(hash, v, pubkey))
+                << "key " << i << " variant " << j << " (parsed)";
+        }
+    }
+}
+
+TEST(ECDSAVerifyTest, PublicKeyFormatsMatchOpenSSL) {
+    PrivateKey key = PrivateKey::Generate(false);
+    Hash256 hash = HashOf(0);
+    std::vector<uint8_t> sig = key.Sign(hash);
+    std::vector<uint8_t> uncompressed = key.GetPublicKey().ToVector();
+    ASSERT_EQ(uncompressed.size(), 65u);
+    bool odd = uncompressed[64] & 1;
+
+    std::vector<std::vector<uint8_t>> pubkeys;
+    pubkeys.push_back(uncompressed);
+    pubkeys.push_back(key.GetPublicKey().GetCompressed().ToVector());
+    // Hybrid encodings, with matching and mismatching parity
+    for (uint8_t prefix : {0x06, 0x07}) {
+        pubkeys.push_back(uncompressed);
+        pubkeys.back()[0] = prefix;
+    }
+    // Off the curve
+    pubkeys.push_back(uncompressed);
+    pubkeys.back()[64] ^= 0x01;
+
+    for (size_t j = 0; j < pubkeys.size(); ++j) {
+        const auto& pk = pubkeys[j];
+        EXPECT_EQ(ECDSAVerify(hash.data(), sig.data(), sig.size(), pk.data(), pk.size()),
+                  OpenSSLVerify(hash, sig, pk))
+            << "pubkey " << j << " (y odd: " << odd << ")";
+        ParsedPublicKey parsed;
+        bool parses = ParsePublicKey(parsed, pk.data(), pk.size());
+        EXPECT_EQ(parses && ECDSAVerify(hash.data(), sig.data(), sig.size(), parsed),
+                  OpenSSLVerify(hash, sig, pk))
+            << "pubkey " << j << " (parsed)";
+    }
+}
+#endif
+
+TEST(SchnorrVerifyTest, BIP340Vectors) {
+    struct Vector {
+        const char* pubkey;
+        const char* msg;
+        const char* sig;
+        bool valid;
+    };
+    const Vector vectors[] = {
+        {"f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9",
+         "0000000000000000000000000000000000000000000000000000000000000000",
+         "e907831f80848d1069a5371b402410364bdf1c5f8307b0084c55f1ce2dca8215"
+         "25f66a4a85ea8b71e482a74f382d2ce5ebeee8fdb2172f477df4900d310536c0",
+         true},
+        {"dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+         "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+         "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de3341"
+         "8906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a",
+         true},
+        // Public key not on the curve
+        {"eefdea4cdb677750a420fee807eacf21eb9898ae79b9768766e4faa04a2d4a34",
+         "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+         "6cff5c3ba86c69ea4b7376f31a9bcb4f74c1976089b2d9963da2e5543e177769"
+         "69e89b4c5564d00349106b8497785dd7d1d713a8ae82b32fa79d5f7fc407d39b",
+         false},
+    };
+    for (const Vector& v : vectors) {
+        auto pubkey = HexToBytes(v.pubkey);
+        auto msg = HexToBytes(v.msg);
+        auto sig = HexToBytes(v.sig);
+        EXPECT_EQ(SchnorrVerify(msg.data(), sig.data(), pubkey.data()), v.valid) << v.sig;
+
+        // Any single-bit change invalidates a valid signature
+        if (v.valid) {
+            sig[63] ^= 0x01;
+            EXPECT_FALSE(SchnorrVerify(msg.data(), sig.data(), pubkey.data()));
+        }
+    }
+}
+
+TEST(SchnorrBatchVerifierTest, AcceptsValidBatches) {
+    SchnorrBatchVerifier batch;
+    EXPECT_TRUE(batch.Verify());
+
+    // More than one chunk, mixing compressed and uncompressed keys
+    for (size_t i = 0; i < secp256k1::SCHNORR_BATCH_CHUNK + 3; ++i) {
+        PrivateKey key = PrivateKey::Generate(i % 3 != 0);
+        Hash256 hash = HashOf(static_cast<int>(i));
+        ASSERT_TRUE(batch.Add(key.GetPublicKey(), hash, key.SignSchnorr(hash)));
+    }
+    EXPECT_EQ(batch.Size(), secp256k1::SCHNORR_BATCH_CHUNK + 3);
+    std::vector<size_t> invalid;
+    EXPECT_TRUE(batch.Verify(&invalid));
+    EXPECT_TRUE(invalid.empty());
+
+    batch.Clear();
+    EXPECT_TRUE(batch.Empty());
+}
+
+TEST(SchnorrBatchVerifierTest, PinpointsInvalidSignatures) {
+    std::vector<PrivateKey> keys;
+    std::vector<Hash256> hashes;
+    std::vector<std::array<uint8_t, 64>> sigs;
+    for (int i = 0; i < 10; ++i) {
+        keys.push_back(PrivateKey::Generate());
+        hashes.push_back(HashOf(i));
+        sigs.push_back(keys.back().SignSchnorr(hashes.back()));
+    }
+    sigs[3][40] ^= 0x01;                       // corrupt s
+    hashes[7] = HashOf(100);                   // wrong message
+    std::swap(sigs[8][0], sigs[8][1]);         // corrupt R
+
+    SchnorrBatchVerifier batch;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        batch.Add(keys[i].GetPublicKey(), hashes[i], sigs[i]);
+    }
+    std::vector<size_t> invalid;
+    EXPECT_FALSE(batch.Verify(&invalid));
+    EXPECT_EQ(invalid, (std::vector<size_t>{3, 7, 8}));
+
+    // Signatures that would cancel in an unweighted sum still fail
+    SchnorrBatchVerifier pair;
+    auto s0 = keys[0].SignSchnorr(hashes[0]);
+    auto s1 = keys[1].SignSchnorr(hashes[1]);
+    Scalar delta = Scalar::FromInt(12345);
+    Scalar a0 = Scalar(std::vector<uint8_t>(s0.begin() + 32, s0.end())) + delta;
+    Scalar a1 = Scalar(std::vector<uint8_t>(s1.begin() + 32, s1.end())) - delta;
+    std::memcpy(s0.data() + 32, a0.data(), 32);
+    std::memcpy(s1.data() + 32, a1.data(), 32);
+    pair.Add(keys[0].GetPublicKey(), hashes[0], s0);
+    pair.Add(keys[1].GetPublicKey(), hashes[1], s1);
+    EXPECT_FALSE(pair.Verify(&invalid));
+    EXPECT_EQ(invalid, (std::vector<size_t>{0, 1}));
+}
+
+TEST(SchnorrBatchVerifierTest, InvalidKeyFailsBatch) {
+    PrivateKey key = PrivateKey::Generate();
+    Hash256 hash = HashOf(0);
+    SchnorrBatchVerifier batch;
+    EXPECT_TRUE(batch.Add(key.GetPublicKey(), hash, key.SignSchnorr(hash)));
+    EXPECT_FALSE(batch.Add(PublicKey(), hash, key.SignSchnorr(hash)));
+    std::vector<size_t> invalid;
+    EXPECT_FALSE(batch.Verify(&invalid));
+    EXPECT_EQ(invalid, (std::vector<size_t>{1}));
+}
+
+} // namespace test
+} // namespace shurium
@@ -0,0 +1,119 @@
+// SHURIUM - Secure Memory Pool Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/secure.h"
+#include "shurium/crypto/keys.h"
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+namespace shurium {
+namespace test {
+
+static bool AllZero(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; ++i) {
+        if (p[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(SecurePoolTest, SlotsAreZeroedAndReused) {
+    SecurePool& pool = SecurePool::Get();
+    void* slot = pool.Allocate();
+    ASSERT_NE(slot, nullptr);
+    EXPECT_TRUE(AllZero(slot, SecurePool::SLOT_SIZE));
+
+    std::memset(slot, 0xAB, SecurePool::SLOT_SIZE);
+    pool.Free(slot);
+    // The pool hands out the slot freed last, zeroed
+    void* again = pool.Allocate();
+    EXPECT_EQ(again, slot);
+    EXPECT_TRUE(AllZero(again, SecurePool::SLOT_SIZE));
+    pool.Free(again);
+}
+
+TEST(SecurePoolTest, GrowsByWholeArenas) {
+    SecurePool& pool = SecurePool::Get();
+    auto before = pool.GetStats();
+
+    std::vector<void*> slots;
+    for (size_t i = 0; i < SecurePool::ARENA_SLOTS + 1; ++i) {
+        slots.push_back(pool.Allocate());
+    }
+    std::set<void*> distinct(slots.begin(), slots.end());
+    EXPECT_EQ(distinct.size(), slots.size());
+
+    auto during = pool.GetStats();
+    EXPECT_GT(during.arenas, before.arenas);
+    EXPECT_EQ(during.slotsTotal, during.arenas * SecurePool::ARENA_SLOTS);
+    EXPECT_EQ(during.slotsInUse, before.slotsInUse + slots.size());
+
+    for (void* slot : slots) {
+        pool.Free(slot);
+    }
+    auto after = pool.GetStats();
+    EXPECT_EQ(after.slotsInUse, before.slotsInUse);
+    EXPECT_EQ(after.arenas, during.arenas);  // Arenas are kept
+}
+
+TEST(SecureBytesTest, TakesSlotOnFirstWrite) {
+    SecurePool& pool = SecurePool::Get();
+    size_t inUse = pool.GetStats().slotsInUse;
+
+    SecureBytes<32> bytes;
+    EXPECT_TRUE(AllZero(bytes.data(), bytes.size()));
+    EXPECT_EQ(pool.GetStats().slotsInUse, inUse);
+
+    std::memset(bytes.Writable(), 0x11, bytes.size());
+    EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 1);
+
+    SecureBytes<32> copy(bytes);
+    EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 2);
+    EXPECT_EQ(std::memcmp(copy.data(), bytes.data(), 32), 0);
+    EXPECT_NE(copy.data(), bytes.data());
+
+    SecureBytes<32> moved(std::move(bytes));
+    EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 2);
+    EXPECT_EQ(moved[0], 0x11);
+    EXPECT_TRUE(AllZero(bytes.data(), bytes.size()));
+
+    moved.Release();
+    copy.Release();
+    EXPECT_EQ(pool.GetStats().slotsInUse, inUse);
+}
+
+TEST(SecureBytesTest, PrivateKeysLiveInThePool) {
+    SecurePool& pool = SecurePool::Get();
+    size_t inUse = pool.GetStats().slotsInUse;
+    {
+        PrivateKey empty;
+        EXPECT_EQ(pool.GetStats().slotsInUse, inUse);
+
+        PrivateKey key = PrivateKey::Generate();
+        ASSERT_TRUE(key.IsValid());
+        EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 1);
+
+        PrivateKey copy = key;
+        EXPECT_EQ(copy, key);
+        EXPECT_EQ(copy.GetPublicKey(), key.GetPublicKey());
+        EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 2);
+
+        PrivateKey moved = std::move(copy);
+        EXPECT_FALSE(copy.IsValid());
+        EXPECT_EQ(moved, key);
+        EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 2);
+
+        key.Clear();
+        EXPECT_EQ(pool.GetStats().slotsInUse, inUse + 1);
+    }
+    EXPECT_EQ(pool.GetStats().slotsInUse, inUse);
+}
+
+} // namespace test
+} // namespace shurium
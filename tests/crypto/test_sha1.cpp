@@ -0,0 +1,56 @@
+// SHURIUM - SHA-1 Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/sha1.h"
+#include "shurium/core/hex.h"
+
+#include <string>
+#include <vector>
+
+namespace shurium {
+namespace test {
+
+static std::string SHA1Hex(const std::string& input) {
+    SHA1 hasher;
+    hasher.Write(reinterpret_cast<const Byte*>(input.data()), input.size());
+    Byte hash[SHA1::OUTPUT_SIZE];
+    hasher.Finalize(hash);
+    return BytesToHex(hash, sizeof(hash));
+}
+
+TEST(SHA1Test, KnownVectors) {
+    EXPECT_EQ(SHA1Hex(""), "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    EXPECT_EQ(SHA1Hex("abc"), "a9993e364706816aba3e25717850c26c9cd0d89d");
+    EXPECT_EQ(SHA1Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+              "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+    EXPECT_EQ(SHA1Hex(std::string(1000000, 'a')), "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
+
+TEST(SHA1Test, IncrementalMatchesOneShot) {
+    std::string input(200, 'x');
+    for (size_t i = 0; i < input.size(); ++i) input[i] = static_cast<char>(i * 7);
+    
+    SHA1 hasher;
+    for (size_t pos = 0; pos < input.size(); pos += 13) {
+        size_t len = std::min<size_t>(13, input.size() - pos);
+        hasher.Write(reinterpret_cast<const Byte*>(input.data()) + pos, len);
+    }
+    Byte hash[SHA1::OUTPUT_SIZE];
+    hasher.Finalize(hash);
+    EXPECT_EQ(BytesToHex(hash, sizeof(hash)), SHA1Hex(input));
+}
+
+TEST(SHA1Test, WebSocketAcceptKey) {
+    // RFC 6455 section 1.3
+    SHA1 hasher;
+    std::string key = "dGhlIHNhbXBsZSBub25jZQ==258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    hasher.Write(reinterpret_cast<const Byte*>(key.data()), key.size());
+    Byte hash[SHA1::OUTPUT_SIZE];
+    hasher.Finalize(hash);
+    EXPECT_EQ(BytesToHex(hash, sizeof(hash)), "b37a4f2cc0624f1690f64606cf385945b2bec4ea");
+}
+
+} // namespace test
+} // namespace shurium
@@ -10,9 +10,12 @@
 #include "shurium/core/types.h"
 #include "shurium/core/hex.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
 #include <string>
 #include <vector>
-#include <array>
 
 namespace shurium {
 namespace test {
@@ -399,5 +402,176 @@ TEST(SHA256Test, AllOnes32Bytes) {
     EXPECT_FALSE(hash[0] == 0 && hash[1] == 0 && hash[2] == 0);
 }
 
+// ============================================================================
+// Transform Implementation Tests
+// ============================================================================
+
+/// Restores the auto-detected implementation after a test switches it
+class SHA256ImplTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        SetSHA256Implementation(detected_);
+    }
+
+    SHA256Implementation detected_ = SHA256AutoDetect();
+};
+
+TEST_F(SHA256ImplTest, ScalarAlwaysAvailable) {
+    auto impls = GetAvailableSHA256Implementations();
+    ASSERT_FALSE(impls.empty());
+    EXPECT_EQ(impls.back(), SHA256Implementation::SCALAR);
+    // The fastest available one is picked
+    EXPECT_EQ(impls.front(), detected_);
+    EXPECT_TRUE(SetSHA256Implementation(SHA256Implementation::SCALAR));
+    EXPECT_EQ(GetSHA256Implementation(), SHA256Implementation::SCALAR);
+}
+
+TEST_F(SHA256ImplTest, ImplementationsAgreeWithScalar) {
+    // Lengths around block boundaries, plus multi-block runs through Write
+    std::vector<Byte> data(64 * 40 + 17);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<Byte>((i * 131) ^ (i >> 3));
+    }
+    const size_t lengths[] = {0, 1, 55, 56, 63, 64, 65, 80, 127, 128, 640, data.size()};
+
+    ASSERT_TRUE(SetSHA256Implementation(SHA256Implementation::SCALAR));
+    std::vector<Hash256> expected;
+    for (size_t len : lengths) {
+        expected.push_back(DoubleSHA256(data.data(), len));
+    }
+
+    for (SHA256Implementation impl : GetAvailableSHA256Implementations()) {
+        ASSERT_TRUE(SetSHA256Implementation(impl));
+        for (size_t i = 0; i < std::size(lengths); ++i) {
+            EXPECT_EQ(DoubleSHA256(data.data(), lengths[i]), expected[i])
+                << SHA256ImplementationName(impl) << " length " << lengths[i];
+        }
+
+        // Odd-sized incremental writes mix buffered and direct blocks
+        SHA256 hasher;
+        for (size_t pos = 0; pos < data.size(); pos += 197) {
+            hasher.Write(data.data() + pos, std::min<size_t>(197, data.size() - pos));
+        }
+        std::array<Byte, SHA256::OUTPUT_SIZE> incremental;
+        hasher.Finalize(incremental.data());
+        ASSERT_TRUE(SetSHA256Implementation(SHA256Implementation::SCALAR));
+        EXPECT_EQ(Hash256(incremental), SHA256Hash(data.data(), data.size()))
+            << SHA256ImplementationName(impl);
+    }
+}
+
+TEST_F(SHA256ImplTest, UnavailableImplementationIsRejected) {
+    auto impls = GetAvailableSHA256Implementations();
+    for (SHA256Implementation impl : {SHA256Implementation::SHANI, SHA256Implementation::ARMV8}) {
+        ASSERT_TRUE(SetSHA256Implementation(SHA256Implementation::SCALAR));
+        bool available = std::find(impls.begin(), impls.end(), impl) != impls.end();
+        EXPECT_EQ(SetSHA256Implementation(impl), available) << SHA256ImplementationName(impl);
+        // A rejected switch leaves the current transform in place
+        EXPECT_EQ(GetSHA256Implementation(), available ? impl : SHA256Implementation::SCALAR);
+    }
+}
+
+TEST_F(SHA256ImplTest, MultiMessageKernelsAgree) {
+    // Counts that leave remainders for every narrower kernel
+    std::vector<Byte> in(64 * 37);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = static_cast<Byte>(i * 29 + (i >> 6));
+    }
+    std::vector<Byte> expected(32 * 37);
+    for (size_t i = 0; i < 37; ++i) {
+        Hash256 hash = DoubleSHA256(in.data() + i * 64, 64);
+        std::memcpy(expected.data() + i * 32, hash.data(), 32);
+    }
+
+    size_t detectedWays = GetSHA256D64Ways();
+    auto ways = GetAvailableSHA256D64Ways();
+    ASSERT_FALSE(ways.empty());
+    EXPECT_NE(std::find(ways.begin(), ways.end(), detectedWays), ways.end());
+    EXPECT_EQ(ways.back(), 1u);
+    EXPECT_FALSE(SetSHA256D64Ways(3));
+
+    for (SHA256Implementation impl : GetAvailableSHA256Implementations()) {
+        ASSERT_TRUE(SetSHA256Implementation(impl));
+        for (size_t width : ways) {
+            ASSERT_TRUE(SetSHA256D64Ways(width));
+            for (size_t blocks : {size_t(0), size_t(1), size_t(5), size_t(16), size_t(37)}) {
+                std::vector<Byte> out(32 * blocks);
+                DoubleSHA256_64(out.data(), in.data(), blocks);
+                EXPECT_EQ(0, std::memcmp(out.data(), expected.data(), out.size()))
+                    << SHA256ImplementationName(impl) << " " << width << "-way, " << blocks;
+            }
+
+            // In place, as Merkle levels are hashed
+            std::vector<Byte> buf = in;
+            DoubleSHA256_64(buf.data(), buf.data(), 37);
+            EXPECT_EQ(0, std::memcmp(buf.data(), expected.data(), expected.size()))
+                << SHA256ImplementationName(impl) << " " << width << "-way in place";
+        }
+    }
+    SetSHA256D64Ways(detectedWays);
+}
+
+TEST_F(SHA256ImplTest, HeaderNonceKernelsAgree) {
+    Byte header[80];
+    for (size_t i = 0; i < sizeof(header); ++i) {
+        header[i] = static_cast<Byte>(i * 17 + 3);
+    }
+
+    // Starting near the top shows the nonce wrapping
+    const uint32_t firstNonce = 0xFFFFFFF0;
+    std::vector<Byte> expected(32 * 37);
+    for (uint32_t i = 0; i < 37; ++i) {
+        uint32_t nonce = firstNonce + i;
+        for (int b = 0; b < 4; ++b) {
+            header[76 + b] = static_cast<Byte>(nonce >> (8 * b));
+        }
+        Hash256 hash = DoubleSHA256(header, sizeof(header));
+        std::memcpy(expected.data() + i * 32, hash.data(), 32);
+    }
+
+    size_t detectedWays = GetSHA256D64Ways();
+    for (SHA256Implementation impl : GetAvailableSHA256Implementations()) {
+        ASSERT_TRUE(SetSHA256Implementation(impl));
+        SHA256Midstate mid = SHA256HeaderMidstate(header);
+        for (size_t width : GetAvailableSHA256D64Ways()) {
+            ASSERT_TRUE(SetSHA256D64Ways(width));
+            for (size_t count : {size_t(0), size_t(1), size_t(5), size_t(16), size_t(37)}) {
+                std::vector<Byte> out(32 * count);
+                DoubleSHA256_80_Nonces(out.data(), mid, header + 64, firstNonce, count);
+                EXPECT_EQ(0, std::memcmp(out.data(), expected.data(), out.size()))
+                    << SHA256ImplementationName(impl) << " " << width << "-way, " << count;
+            }
+        }
+    }
+    SetSHA256D64Ways(detectedWays);
+}
+
+TEST(SHA256Test, DoubleSHA256_80MatchesSingleHashes) {
+    std::vector<Byte> headers(80 * 37);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i] = static_cast<Byte>(i * 23 + 11);
+    }
+    std::vector<Byte> expected(32 * 37);
+    for (size_t i = 0; i < 37; ++i) {
+        Hash256 hash = DoubleSHA256(headers.data() + 80 * i, 80);
+        std::memcpy(expected.data() + i * 32, hash.data(), 32);
+    }
+
+    size_t detectedWays = GetSHA256D64Ways();
+    for (SHA256Implementation impl : GetAvailableSHA256Implementations()) {
+        ASSERT_TRUE(SetSHA256Implementation(impl));
+        for (size_t width : GetAvailableSHA256D64Ways()) {
+            ASSERT_TRUE(SetSHA256D64Ways(width));
+            for (size_t count : {size_t(0), size_t(1), size_t(5), size_t(16), size_t(37)}) {
+                std::vector<Byte> out(32 * count);
+                DoubleSHA256_80(out.data(), headers.data(), count);
+                EXPECT_EQ(0, std::memcmp(out.data(), expected.data(), out.size()))
+                    << SHA256ImplementationName(impl) << " " << width << "-way, " << count;
+            }
+        }
+    }
+    SetSHA256D64Ways(detectedWays);
+}
+
 } // namespace test
 } // namespace shurium
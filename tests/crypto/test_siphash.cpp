@@ -0,0 +1,104 @@
+// SHURIUM - SipHash Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/crypto/siphash.h"
+#include "shurium/core/types.h"
+
+#include <cstring>
+#include <vector>
+
+namespace shurium {
+namespace test {
+
+// Key from the SipHash reference test vectors: 00 01 02 ... 0f
+static constexpr uint64_t REF_K0 = 0x0706050403020100ULL;
+static constexpr uint64_t REF_K1 = 0x0f0e0d0c0b0a0908ULL;
+
+static std::vector<Byte> SequentialBytes(size_t len) {
+    std::vector<Byte> data(len);
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<Byte>(i);
+    }
+    return data;
+}
+
+// ============================================================================
+// Reference Vectors
+// ============================================================================
+
+TEST(SipHashTest, SipHash24ReferenceVectors) {
+    // Empty message
+    EXPECT_EQ(SipHash24(REF_K0, REF_K1, nullptr, 0), 0x726fdb47dd0e0e31ULL);
+    
+    // 15-byte message from the SipHash paper
+    std::vector<Byte> msg = SequentialBytes(15);
+    EXPECT_EQ(SipHash24(REF_K0, REF_K1, msg.data(), msg.size()), 0xa129ca6149be45e5ULL);
+}
+
+TEST(SipHashTest, VariantsDiffer) {
+    std::vector<Byte> msg = SequentialBytes(32);
+    EXPECT_NE(SipHash13(REF_K0, REF_K1, msg.data(), msg.size()),
+              SipHash24(REF_K0, REF_K1, msg.data(), msg.size()));
+}
+
+// ============================================================================
+// Specialised Functions
+// ============================================================================
+
+TEST(SipHashTest, Uint256MatchesGeneric) {
+    std::vector<Byte> msg = SequentialBytes(32);
+    Hash256 hash(msg.data(), msg.size());
+    
+    EXPECT_EQ(SipHash13Uint256(REF_K0, REF_K1, hash),
+              SipHash13(REF_K0, REF_K1, msg.data(), msg.size()));
+}
+
+TEST(SipHashTest, Uint256ExtraMatchesGeneric) {
+    std::vector<Byte> msg = SequentialBytes(36);
+    Hash256 hash(msg.data(), 32);
+    uint32_t extra = 0x23222120;  // bytes 32..35, little-endian
+    
+    EXPECT_EQ(SipHash13Uint256Extra(REF_K0, REF_K1, hash, extra),
+              SipHash13(REF_K0, REF_K1, msg.data(), msg.size()));
+    
+    // The extra word changes the result
+    EXPECT_NE(SipHash13Uint256Extra(REF_K0, REF_K1, hash, extra + 1),
+              SipHash13Uint256Extra(REF_K0, REF_K1, hash, extra));
+}
+
+TEST(SipHashTest, KeyChangesResult) {
+    Hash256 hash;
+    hash[0] = 0x5A;
+    EXPECT_NE(SipHash13Uint256(REF_K0, REF_K1, hash),
+              SipHash13Uint256(REF_K0 + 1, REF_K1, hash));
+    EXPECT_NE(SipHash13Uint256(REF_K0, REF_K1, hash),
+              SipHash13Uint256(REF_K0, REF_K1 + 1, hash));
+}
+
+// ============================================================================
+// Hash Table Salt
+// ============================================================================
+
+TEST(SipHashTest, SaltIsStableAndRandom) {
+    const SipHashKey& a = GetHashTableSalt();
+    const SipHashKey& b = GetHashTableSalt();
+    EXPECT_EQ(&a, &b);
+    EXPECT_FALSE(a.k0 == 0 && a.k1 == 0);
+}
+
+TEST(SipHashTest, SaltedHasherConsistentAcrossInstances) {
+    Hash256 hash;
+    hash[3] = 0x77;
+    
+    SaltedHash256Hasher h1;
+    SaltedHash256Hasher h2;
+    EXPECT_EQ(h1(hash), h2(hash));
+    
+    const SipHashKey& key = GetHashTableSalt();
+    EXPECT_EQ(h1(hash), static_cast<size_t>(SipHash13Uint256(key.k0, key.k1, hash)));
+}
+
+} // namespace test
+} // namespace shurium
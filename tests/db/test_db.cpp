@@ -6,11 +6,22 @@
 #include "shurium/db/database.h"
 #include "shurium/db/leveldb.h"
 #include "shurium/db/blockdb.h"
+#include "shurium/db/blockfilterdb.h"
 #include "shurium/db/utxodb.h"
+#include "shurium/db/coincompressor.h"
 #include "shurium/core/block.h"
+#include "shurium/core/serialize.h"
 #include "shurium/consensus/params.h"
+#include "shurium/crypto/keys.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <random>
+#include <set>
+#include <thread>
 
 using namespace shurium;
 using namespace shurium::db;
@@ -144,6 +155,148 @@ TEST_F(DatabaseTest, WriteBatch) {
     EXPECT_EQ(value, "value3");
 }
 
+TEST_F(DatabaseTest, ArenaWriteBatch) {
+    Options opts;
+    opts.create_if_missing = true;
+    
+    auto [status, db] = OpenDatabase(testDir_ / "test_db", opts);
+    ASSERT_TRUE(status.ok());
+    ASSERT_TRUE(db->Put(Slice("key2"), Slice("old")).ok());
+    
+    db::ArenaWriteBatch batch;
+    EXPECT_TRUE(batch.Empty());
+    const size_t emptySize = batch.ApproximateSize();
+    EXPECT_EQ(emptySize, 12u);
+    
+    std::string big(300, 'x');
+    batch.Put(Slice("key1"), Slice("value1"));
+    batch.Put(Slice("key3"), Slice(big));
+    batch.Delete(Slice("key2"));
+    EXPECT_EQ(batch.Count(), 3u);
+    
+    // Tag, varint lengths and payload: 300 needs a two-byte length
+    EXPECT_EQ(batch.ApproximateSize(),
+              emptySize + (1 + 1 + 4 + 1 + 6) + (1 + 1 + 4 + 2 + 300) + (1 + 1 + 4));
+    
+    // Iteration visits operations in order, pointing into the arena
+    std::vector<std::pair<std::string, std::optional<std::string>>> seen;
+    ASSERT_TRUE(batch.Iterate([&seen](const Slice& key, const Slice* value) {
+        seen.emplace_back(key.ToString(),
+                          value ? std::optional<std::string>(value->ToString()) : std::nullopt);
+    }).ok());
+    ASSERT_EQ(seen.size(), 3u);
+    EXPECT_EQ(seen[0].first, "key1");
+    EXPECT_EQ(seen[0].second, std::optional<std::string>("value1"));
+    EXPECT_EQ(seen[1].second, std::optional<std::string>(big));
+    EXPECT_EQ(seen[2].first, "key2");
+    EXPECT_FALSE(seen[2].second.has_value());
+    
+    ASSERT_TRUE(db->Write(&batch).ok());
+    std::string value;
+    ASSERT_TRUE(db->Get(Slice("key1"), &value).ok());
+    EXPECT_EQ(value, "value1");
+    ASSERT_TRUE(db->Get(Slice("key3"), &value).ok());
+    EXPECT_EQ(value, big);
+    EXPECT_TRUE(db->Get(Slice("key2"), &value).IsNotFound());
+    
+    batch.Clear();
+    EXPECT_TRUE(batch.Empty());
+    EXPECT_EQ(batch.ApproximateSize(), emptySize);
+}
+
+TEST_F(DatabaseTest, ColumnFamilyOptions) {
+    Options base;
+    base.max_open_files = 64;
+    
+    const size_t cache = 64 * 1024 * 1024;
+    Options coins = GetColumnFamilyOptions(ColumnFamily::COINS, cache, base);
+    EXPECT_EQ(coins.block_cache_size, cache / 2);
+    EXPECT_EQ(coins.write_buffer_size, cache / 4);
+    EXPECT_FALSE(coins.compression);
+    EXPECT_GT(coins.bloom_filter_bits, 0);
+    EXPECT_EQ(coins.max_open_files, 64);
+    
+    Options index = GetColumnFamilyOptions(ColumnFamily::BLOCK_INDEX, 0, base);
+    EXPECT_TRUE(index.compression);
+    EXPECT_EQ(index.block_cache_size, 0u);
+    EXPECT_GT(index.write_buffer_size, 0u);
+    
+    EXPECT_STREQ(GetColumnFamilyName(ColumnFamily::TX_INDEX), "txindex");
+}
+
+TEST_F(DatabaseTest, SplitDatabaseCache) {
+    const size_t total = 100 * 1024 * 1024;
+    
+    ColumnFamilyCacheSizes noIndex = SplitDatabaseCache(total, false);
+    EXPECT_EQ(noIndex.blockIndex, MAX_BLOCK_INDEX_CACHE);
+    EXPECT_EQ(noIndex.txIndex, 0u);
+    EXPECT_EQ(noIndex.blockIndex + noIndex.coins, total);
+    
+    ColumnFamilyCacheSizes withIndex = SplitDatabaseCache(total, true);
+    EXPECT_GT(withIndex.txIndex, 0u);
+    EXPECT_LT(withIndex.coins, noIndex.coins);
+    EXPECT_EQ(withIndex.blockIndex + withIndex.coins + withIndex.txIndex, total);
+    
+    // Small budgets are never overcommitted
+    ColumnFamilyCacheSizes tiny = SplitDatabaseCache(1024, true);
+    EXPECT_EQ(tiny.blockIndex + tiny.coins + tiny.txIndex, 1024u);
+}
+
+TEST_F(DatabaseTest, LatencyHistogram) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.GetSnapshot().PercentileMicros(0.5), 0u);
+    
+    for (int i = 0; i < 98; ++i) {
+        histogram.Record(3);
+    }
+    histogram.Record(1000);
+    histogram.Record(5000);
+    
+    auto snapshot = histogram.GetSnapshot();
+    EXPECT_EQ(snapshot.count, 100u);
+    EXPECT_EQ(snapshot.sumMicros, 98u * 3 + 6000);
+    EXPECT_EQ(snapshot.maxMicros, 5000u);
+    EXPECT_EQ(snapshot.buckets[2], 98u);  // 3us is under 2^2
+    EXPECT_EQ(snapshot.PercentileMicros(0.5), 4u);
+    EXPECT_EQ(snapshot.PercentileMicros(0.99), 5000u);
+}
+
+TEST_F(DatabaseTest, DatabaseStatsCountOperations) {
+    auto [status, db] = OpenDatabase(testDir_ / "stats_db", Options());
+    ASSERT_TRUE(status.ok());
+    
+    ASSERT_TRUE(db->Put(Slice("aa"), Slice("1234")).ok());
+    ASSERT_TRUE(db->Put(Slice("bb"), Slice("56")).ok());
+    ASSERT_TRUE(db->Delete(Slice("cc")).ok());
+    
+    std::string value;
+    EXPECT_TRUE(db->Get(Slice("aa"), &value).ok());
+    EXPECT_TRUE(db->Get(Slice("zz"), &value).IsNotFound());
+    
+    db::ArenaWriteBatch batch;
+    batch.Put(Slice("dd"), Slice("7"));
+    ASSERT_TRUE(db->Write(&batch).ok());
+    
+    auto iter = db->NewIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    }
+    
+    DatabaseStats stats = db->GetDatabaseStats();
+    EXPECT_EQ(stats.puts, 2u);
+    EXPECT_EQ(stats.deletes, 1u);
+    EXPECT_EQ(stats.batches, 1u);
+    EXPECT_EQ(stats.gets, 2u);
+    EXPECT_EQ(stats.getHits, 1u);
+    EXPECT_DOUBLE_EQ(stats.GetHitRate(), 0.5);
+    EXPECT_EQ(stats.getLatency.count, 2u);
+    EXPECT_EQ(stats.writeLatency.count, 4u);
+    EXPECT_EQ(stats.bytesWritten, 6u + 4u + 2u + batch.ApproximateSize());
+    
+    // One hit (6 bytes) and a scan over aa, bb, dd (6 + 4 + 3 bytes)
+    EXPECT_EQ(stats.bytesRead, 6u + 13u);
+    EXPECT_GT(stats.memoryUsage, 0u);
+}
+
 TEST_F(DatabaseTest, Iterator) {
     Options opts;
     opts.create_if_missing = true;
@@ -288,6 +441,384 @@ TEST_F(DatabaseTest, BlockDBMultipleBlocks) {
     }
 }
 
+TEST_F(DatabaseTest, BlockDBReadsFinishedFilesThroughMapping) {
+    BlockDB db(testDir_);
+    db.SetMaxBlockFileSize(1);  // One block per file
+    
+    std::vector<Block> blocks;
+    std::vector<DiskBlockPos> positions;
+    for (int i = 0; i < 4; ++i) {
+        Block block = CreateTestBlock(i);
+        DiskBlockPos pos;
+        ASSERT_TRUE(db.WriteBlock(block, pos).ok());
+        EXPECT_EQ(pos.nFile, i);
+        blocks.push_back(block);
+        positions.push_back(pos);
+    }
+    
+    // Finished files are read concurrently from their mappings
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            for (int round = 0; round < 25; ++round) {
+                for (size_t i = 0; i + 1 < blocks.size(); ++i) {
+                    Block readBlock;
+                    if (!db.ReadBlock(positions[i], readBlock).ok() ||
+                        readBlock.GetHash() != blocks[i].GetHash()) {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+    EXPECT_EQ(db.GetMappedReadCount(), 4u * 25u * 3u);
+    
+    // The file still being appended to goes through its handle
+    Block last;
+    ASSERT_TRUE(db.ReadBlock(positions.back(), last).ok());
+    EXPECT_EQ(last.GetHash(), blocks.back().GetHash());
+    EXPECT_EQ(db.GetMappedReadCount(), 4u * 25u * 3u);
+}
+
+TEST_F(DatabaseTest, BlockDBReadRawBlockMatchesSerialization) {
+    BlockDB db(testDir_);
+    db.SetMaxBlockFileSize(1);
+    
+    std::vector<Block> blocks;
+    std::vector<DiskBlockPos> positions;
+    for (int i = 0; i < 2; ++i) {
+        Block block = CreateTestBlock(i);
+        DiskBlockPos pos;
+        ASSERT_TRUE(db.WriteBlock(block, pos).ok());
+        blocks.push_back(block);
+        positions.push_back(pos);
+    }
+    
+    // The first file is mapped, the second is still open for appending
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        DataStream expected;
+        Serialize(expected, blocks[i]);
+        std::vector<uint8_t> raw;
+        ASSERT_TRUE(db.ReadRawBlock(positions[i], raw).ok());
+        EXPECT_EQ(raw, std::vector<uint8_t>(expected.data(), expected.data() + expected.size()));
+    }
+    EXPECT_EQ(db.GetMappedReadCount(), 1u);
+    
+    std::vector<uint8_t> raw;
+    EXPECT_FALSE(db.ReadRawBlock(DiskBlockPos(), raw).ok());
+}
+
+TEST_F(DatabaseTest, BlockDBMappedReadRejectsBadPosition) {
+    BlockDB db(testDir_);
+    db.SetMaxBlockFileSize(1);
+    
+    DiskBlockPos first, second;
+    ASSERT_TRUE(db.WriteBlock(CreateTestBlock(1), first).ok());
+    ASSERT_TRUE(db.WriteBlock(CreateTestBlock(2), second).ok());
+    
+    DiskBlockPos beyond = first;
+    beyond.nPos = static_cast<uint32_t>(std::filesystem::file_size(
+        testDir_ / "blocks" / "blk00000.dat"));
+    Block block;
+    EXPECT_FALSE(db.ReadBlock(beyond, block).ok());
+}
+
+TEST_F(DatabaseTest, BlockDBPruneSelectsOldFilesOnly) {
+    BlockDB db(testDir_);
+    db.SetMaxBlockFileSize(1);  // One block per file
+    EXPECT_FALSE(db.IsPruneMode());
+    
+    const int nBlocks = MIN_BLOCKS_TO_KEEP + 10;
+    for (int height = 0; height < nBlocks; ++height) {
+        DiskBlockPos pos;
+        ASSERT_TRUE(db.WriteBlock(CreateTestBlock(height), pos, height).ok());
+    }
+    EXPECT_TRUE(db.FindFilesToPrune(nBlocks - 1).empty());
+    uint64_t usage = db.CalculateCurrentUsage();
+    EXPECT_GT(usage, 0u);
+    
+    // Far too small a target: only blocks buried below the kept window go
+    db.SetPruneTarget(1);
+    ASSERT_TRUE(db.IsPruneMode());
+    std::set<int> files = db.FindFilesToPrune(nBlocks - 1);
+    ASSERT_EQ(files.size(), static_cast<size_t>(nBlocks - MIN_BLOCKS_TO_KEEP));
+    EXPECT_EQ(*files.begin(), 0);
+    EXPECT_EQ(*files.rbegin(), nBlocks - MIN_BLOCKS_TO_KEEP - 1);
+    
+    db.UnlinkPrunedFiles(files);
+    EXPECT_TRUE(db.HavePruned());
+    EXPECT_LT(db.CalculateCurrentUsage(), usage);
+    EXPECT_FALSE(std::filesystem::exists(testDir_ / "blocks" / "blk00000.dat"));
+    EXPECT_TRUE(std::filesystem::exists(db.GetBlockFilePath(nBlocks - MIN_BLOCKS_TO_KEEP)));
+    
+    // Nothing is selected twice
+    EXPECT_TRUE(db.FindFilesToPrune(nBlocks - 1).empty());
+}
+
+TEST_F(DatabaseTest, BlockDBPruneStopsAtTarget) {
+    BlockDB db(testDir_);
+    db.SetMaxBlockFileSize(1);
+    
+    const int nBlocks = MIN_BLOCKS_TO_KEEP + 10;
+    for (int height = 0; height < nBlocks; ++height) {
+        DiskBlockPos pos;
+        ASSERT_TRUE(db.WriteBlock(CreateTestBlock(height), pos, height).ok());
+    }
+    
+    // Allow all but three files' worth of data
+    uint64_t fileSize = db.GetBlockFileInfo()[0].nSize;
+    db.SetPruneTarget(db.CalculateCurrentUsage() - 3 * fileSize);
+    std::set<int> files = db.FindFilesToPrune(nBlocks - 1);
+    EXPECT_EQ(files, (std::set<int>{0, 1, 2}));
+}
+
+TEST_F(DatabaseTest, BlockDBUndoRoundTrip) {
+    BlockDB db(testDir_);
+    
+    BlockUndo undo;
+    undo.vtxundo.resize(2);
+    Hash160 hash;
+    hash[3] = 0x33;
+    undo.vtxundo[0].vprevout.push_back(Coin(TxOut(50 * COIN, Script::CreateP2PKH(hash)), 10, true));
+    undo.vtxundo[1].vprevout.push_back(Coin(TxOut(COIN / 10, Script::CreateP2SH(hash)), 42, false));
+    
+    DiskBlockPos first, second;
+    ASSERT_TRUE(db.WriteUndo(undo, first).ok());
+    ASSERT_TRUE(db.WriteUndo(undo, second).ok());
+    EXPECT_EQ(first.nFile, second.nFile);
+    EXPECT_GT(second.nPos, first.nPos);
+    
+    for (const DiskBlockPos& pos : {first, second}) {
+        BlockUndo read;
+        ASSERT_TRUE(db.ReadUndo(pos, read).ok());
+        ASSERT_EQ(read.size(), undo.size());
+        EXPECT_EQ(read.vtxundo[0].vprevout, undo.vtxundo[0].vprevout);
+        EXPECT_EQ(read.vtxundo[1].vprevout, undo.vtxundo[1].vprevout);
+    }
+}
+
+TEST_F(DatabaseTest, BlockDBBuffersAppendsUntilFlush) {
+    BlockDB db(testDir_);
+    const auto blkPath = testDir_ / "blocks" / "blk00000.dat";
+    auto diskBytes = [&](uint32_t nPos, size_t len) {
+        std::vector<uint8_t> bytes(len);
+        std::FILE* f = std::fopen(blkPath.c_str(), "rb");
+        EXPECT_NE(f, nullptr);
+        std::fseek(f, static_cast<long>(nPos), SEEK_SET);
+        EXPECT_EQ(std::fread(bytes.data(), 1, len, f), len);
+        std::fclose(f);
+        return bytes;
+    };
+    
+    std::vector<Block> blocks;
+    std::vector<DiskBlockPos> positions;
+    for (int i = 0; i < 3; ++i) {
+        blocks.push_back(CreateTestBlock(i));
+        DiskBlockPos pos;
+        ASSERT_TRUE(db.WriteBlock(blocks.back(), pos).ok());
+        positions.push_back(pos);
+    }
+    
+    // Space comes a chunk at a time; the records are still only in memory
+    EXPECT_EQ(std::filesystem::file_size(blkPath), BLOCKFILE_CHUNK_SIZE);
+    EXPECT_EQ(diskBytes(positions[1].nPos, 4), std::vector<uint8_t>(4, 0));
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        Block read;
+        ASSERT_TRUE(db.ReadBlock(positions[i], read).ok());
+        EXPECT_EQ(read.GetHash(), blocks[i].GetHash());
+    }
+    
+    ASSERT_TRUE(db.FlushFiles().ok());
+    std::vector<uint8_t> magic(4);
+    uint32_t nMagic = BLOCK_RECORD_MAGIC;
+    std::memcpy(magic.data(), &nMagic, 4);
+    EXPECT_EQ(diskBytes(positions[1].nPos, 4), magic);
+    
+    // Moving on to a new file trims the finished one to its data
+    uint32_t nEnd = db.GetBlockFileInfo()[0].nSize;
+    db.SetMaxBlockFileSize(nEnd);
+    DiskBlockPos next;
+    ASSERT_TRUE(db.WriteBlock(CreateTestBlock(3), next).ok());
+    EXPECT_EQ(next.nFile, 1);
+    EXPECT_EQ(std::filesystem::file_size(blkPath), nEnd);
+    Block read;
+    ASSERT_TRUE(db.ReadBlock(positions[2], read).ok());
+    EXPECT_EQ(read.GetHash(), blocks[2].GetHash());
+}
+
+TEST_F(DatabaseTest, BlockDBReadsLegacyUndo) {
+    BlockDB db(testDir_);
+    
+    BlockUndo undo;
+    undo.vtxundo.resize(1);
+    undo.vtxundo[0].vprevout.push_back(Coin(TxOut(7 * COIN, Script()), 5, false));
+    
+    // A rev file record from before undo data was compressed
+    DataStream ss;
+    Serialize(ss, undo);
+    uint32_t nSize = static_cast<uint32_t>(ss.size());
+    std::filesystem::create_directories(db.GetUndoFilePath(0).parent_path());
+    {
+        std::ofstream file(db.GetUndoFilePath(0), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&nSize), 4);
+        file.write(reinterpret_cast<const char*>(ss.data()), ss.size());
+    }
+    
+    BlockUndo read;
+    ASSERT_TRUE(db.ReadUndo(DiskBlockPos(0, 0), read).ok());
+    ASSERT_EQ(read.size(), 1u);
+    EXPECT_EQ(read.vtxundo[0].vprevout, undo.vtxundo[0].vprevout);
+}
+
+TEST_F(DatabaseTest, BlockDBLoadsIndexInHeightOrder) {
+    // A five-block chain of headers
+    std::vector<BlockHeader> headers;
+    BlockHash prevHash;
+    for (uint32_t i = 0; i < 5; ++i) {
+        BlockHeader header;
+        header.hashPrevBlock = prevHash;
+        header.nTime = 1700000000 + i;
+        header.nBits = 0x1d00ffff;
+        header.nNonce = i;
+        headers.push_back(header);
+        prevHash = header.GetHash();
+    }
+    
+    BlockDB db(testDir_);
+    // Children first, so write order says nothing about the heights
+    for (int i = 4; i >= 0; --i) {
+        BlockIndex index(headers[i]);
+        index.nHeight = i;
+        BlockIndexDB entry(index);
+        entry.header.hashPrevBlock = headers[i].hashPrevBlock;
+        ASSERT_TRUE(db.WriteBlockIndex(headers[i].GetHash(), entry).ok());
+    }
+    
+    BlockMap blockIndex;
+    ASSERT_EQ(db.LoadBlockIndexMap(blockIndex), 5);
+    
+    const BlockIndex* ptip = blockIndex.Lookup(headers[4].GetHash());
+    ASSERT_NE(ptip, nullptr);
+    EXPECT_EQ(ptip->GetBlockHeader().GetHash(), headers[4].GetHash());
+    EXPECT_EQ(ptip->nChainWork, 5 * GetBlockProof(0x1d00ffff));
+    EXPECT_EQ(ptip->nTimeMax, headers[4].nTime);
+    EXPECT_NE(ptip->pskip, nullptr);
+    EXPECT_EQ(ptip->GetAncestor(0), blockIndex.Lookup(headers[0].GetHash()));
+}
+
+TEST_F(DatabaseTest, BlockDBLoadsIndexInParallel) {
+    BlockDB db(testDir_);
+    std::vector<BlockHash> hashes;
+    BlockHash prevHash;
+    for (uint32_t i = 0; i < 300; ++i) {
+        BlockHeader header;
+        header.hashPrevBlock = prevHash;
+        header.nTime = 1700000000 + i;
+        header.nBits = 0x1d00ffff;
+        header.nNonce = i;
+        
+        BlockIndex index(header);
+        index.nHeight = static_cast<int32_t>(i);
+        BlockIndexDB entry(index);
+        entry.header.hashPrevBlock = prevHash;
+        prevHash = header.GetHash();
+        ASSERT_TRUE(db.WriteBlockIndex(prevHash, entry).ok());
+        hashes.push_back(prevHash);
+    }
+    
+    BlockMap serial;
+    ASSERT_EQ(db.LoadBlockIndexMap(serial), 300);
+    
+    BlockMap parallel;
+    BlockIndexLoadStats stats;
+    ASSERT_EQ(db.LoadBlockIndexMap(parallel, 4, &stats), 300);
+    EXPECT_EQ(stats.nEntries, 300u);
+    EXPECT_EQ(stats.nThreads, 4);
+    
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        const BlockIndex* a = serial.Lookup(hashes[i]);
+        const BlockIndex* b = parallel.Lookup(hashes[i]);
+        ASSERT_NE(a, nullptr);
+        ASSERT_NE(b, nullptr);
+        EXPECT_EQ(b->nHeight, static_cast<int32_t>(i));
+        EXPECT_EQ(b->nChainWork, a->nChainWork);
+        EXPECT_EQ(b->pprev ? b->pprev->GetBlockHash() : BlockHash(),
+                  i > 0 ? hashes[i - 1] : BlockHash());
+    }
+}
+
+TEST_F(DatabaseTest, TxIndexEntriesPointAtTransactions) {
+    BlockDB db(testDir_);
+    Block block = CreateTestBlock(7);
+    DiskBlockPos pos;
+    ASSERT_TRUE(db.WriteBlock(block, pos).ok());
+    ASSERT_TRUE(db.Flush().ok());
+    
+    auto entries = TxIndex::GetBlockEntries(block, pos);
+    ASSERT_EQ(entries.size(), block.vtx.size());
+    
+    std::ifstream file(db.GetBlockFilePath(pos.nFile), std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        EXPECT_EQ(entries[i].first, block.vtx[i]->GetHash());
+        size_t offset = pos.nPos + entries[i].second.nTxOffset;
+        ASSERT_LT(offset, bytes.size());
+        DataStream ss(std::vector<uint8_t>(bytes.begin() + offset, bytes.end()));
+        MutableTransaction tx;
+        Unserialize(ss, tx);
+        EXPECT_EQ(Transaction(tx).GetHash(), block.vtx[i]->GetHash());
+    }
+}
+
+TEST_F(DatabaseTest, TxIndexWritesEntriesWithLocator) {
+    TxIndex index(testDir_);
+    ASSERT_TRUE(index.IsEnabled());
+    EXPECT_FALSE(index.GetBestLocator().has_value());
+    
+    Block block = CreateTestBlock(3);
+    DiskBlockPos pos(2, 100);
+    BlockLocator locator({block.GetHash()});
+    ASSERT_TRUE(index.WriteEntries(TxIndex::GetBlockEntries(block, pos), locator).ok());
+    
+    auto entry = index.GetTx(block.vtx[0]->GetHash());
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(entry->blockPos, pos);
+    auto stored = index.GetBestLocator();
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->vHave, locator.vHave);
+}
+
+TEST_F(DatabaseTest, BlockFilterIndexWritesEntriesWithLocator) {
+    BlockFilterIndex index(BlockFilterType::BASIC, testDir_);
+    ASSERT_TRUE(index.IsEnabled());
+    EXPECT_FALSE(index.GetBestLocator().has_value());
+    
+    Block block = CreateTestBlock(3);
+    BlockFilter filter(BlockFilterType::BASIC, block, {});
+    BlockFilterEntry entry(filter, Hash256());
+    BlockLocator locator({block.GetHash()});
+    ASSERT_TRUE(index.WriteEntries({{block.GetHash(), entry}}, locator).ok());
+    
+    auto stored = index.GetFilter(block.GetHash());
+    ASSERT_TRUE(stored.has_value());
+    EXPECT_EQ(stored->GetEncodedFilter(), filter.GetEncodedFilter());
+    EXPECT_EQ(stored->GetHash(), filter.GetHash());
+    auto header = index.GetFilterHeader(block.GetHash());
+    ASSERT_TRUE(header.has_value());
+    EXPECT_EQ(*header, filter.ComputeHeader(Hash256()));
+    EXPECT_FALSE(index.GetEntry(CreateTestBlock(4).GetHash()).has_value());
+    
+    auto storedLocator = index.GetBestLocator();
+    ASSERT_TRUE(storedLocator.has_value());
+    EXPECT_EQ(storedLocator->vHave, locator.vHave);
+}
+
 TEST_F(DatabaseTest, BlockDBBestChainTip) {
     BlockDB db(testDir_);
     
@@ -391,6 +922,7 @@ TEST_F(DatabaseTest, UTXODBBatchWrite) {
     
     // Create a batch of coins
     CoinsMap coins;
+    MuHash3072 hashDelta;
     for (int i = 0; i < 100; ++i) {
         TxHash txHash;
         for (size_t j = 0; j < 32; ++j) {
@@ -400,6 +932,7 @@ TEST_F(DatabaseTest, UTXODBBatchWrite) {
         
         TxOut txout(1000000 * (i + 1), Script());
         Coin coin(txout, i, i % 2 == 0);
+        AddCoinToHash(hashDelta, outpoint, coin);
         
         CoinsCacheEntry entry(std::move(coin));
         entry.SetDirty();
@@ -412,12 +945,21 @@ TEST_F(DatabaseTest, UTXODBBatchWrite) {
         bestBlock[i] = static_cast<uint8_t>(255 - i);
     }
     
-    bool success = db.BatchWrite(coins, bestBlock);
+    bool success = db.BatchWrite(coins, bestBlock, hashDelta);
     ASSERT_TRUE(success);
     
-    // Verify coins were added (coins map is cleared after batch write)
+    // Verify coins were added
     EXPECT_EQ(db.GetBestBlock(), bestBlock);
     
+    // The rolling hash matches a full pass over the coins
+    MuHash3072 fromScratch, stored;
+    db.ForEachCoin([&fromScratch](const OutPoint& outpoint, const Coin& coin) {
+        AddCoinToHash(fromScratch, outpoint, coin);
+        return true;
+    });
+    ASSERT_TRUE(db.GetUTXOHashState(stored));
+    EXPECT_EQ(stored.Finalize(), fromScratch.Finalize());
+    
     // Verify some coins exist
     TxHash testHash;
     for (size_t j = 0; j < 32; ++j) {
@@ -447,6 +989,260 @@ TEST_F(DatabaseTest, UTXODBStatistics) {
     EXPECT_GT(db.GetWriteCount(), 0);
 }
 
+TEST_F(DatabaseTest, UTXODBRollingHash) {
+    CoinsViewDB db(testDir_ / "utxo");
+    
+    TxHash txHash1, txHash2;
+    txHash1[0] = 1;
+    txHash2[0] = 2;
+    OutPoint kept(txHash1, 0);
+    OutPoint removed(txHash2, 0);
+    Coin coin(TxOut(1000000, Script()), 1, false);
+    
+    ASSERT_TRUE(db.AddCoin(kept, coin).ok());
+    ASSERT_TRUE(db.AddCoin(removed, coin).ok());
+    ASSERT_TRUE(db.RemoveCoin(removed).ok());
+    
+    MuHash3072 expected, stored;
+    AddCoinToHash(expected, kept, coin);
+    ASSERT_TRUE(db.GetUTXOHashState(stored));
+    EXPECT_EQ(stored.Finalize(), expected.Finalize());
+}
+
+TEST_F(DatabaseTest, SnapshotIsolatesReads) {
+    auto [status, db] = OpenDatabase(testDir_ / "snap_db", Options());
+    ASSERT_TRUE(status.ok());
+    ASSERT_TRUE(db->Put(Slice("a"), Slice("1")).ok());
+    ASSERT_TRUE(db->Put(Slice("b"), Slice("2")).ok());
+    
+    auto snapshot = db->NewSnapshot();
+    ASSERT_NE(snapshot, nullptr);
+    ASSERT_TRUE(db->Put(Slice("a"), Slice("changed")).ok());
+    ASSERT_TRUE(db->Delete(Slice("b")).ok());
+    ASSERT_TRUE(db->Put(Slice("c"), Slice("3")).ok());
+    
+    std::string value;
+    ASSERT_TRUE(db->Get(snapshot->GetReadOptions(), Slice("a"), &value).ok());
+    EXPECT_EQ(value, "1");
+    EXPECT_TRUE(db->Get(snapshot->GetReadOptions(), Slice("c"), &value).IsNotFound());
+    ASSERT_TRUE(db->Get(Slice("a"), &value).ok());
+    EXPECT_EQ(value, "changed");
+    
+    std::vector<std::string> keys;
+    auto iter = db->NewIterator(snapshot->GetReadOptions());
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        keys.push_back(iter->key().ToString());
+    }
+    EXPECT_EQ(keys, (std::vector<std::string>{"a", "b"}));
+}
+
+TEST_F(DatabaseTest, UTXODBSnapshotScan) {
+    CoinsViewDB db(testDir_ / "utxo");
+    
+    BlockHash first, second;
+    first[0] = 1;
+    second[0] = 2;
+    Coin coin(TxOut(1000000, Script()), 1, false);
+    for (uint8_t i = 0; i < 5; ++i) {
+        TxHash txHash;
+        txHash[0] = i;
+        ASSERT_TRUE(db.AddCoin(OutPoint(txHash, 0), coin).ok());
+    }
+    ASSERT_TRUE(db.SetBestBlock(first).ok());
+    
+    auto snapshot = db.NewSnapshot();
+    ASSERT_NE(snapshot, nullptr);
+    MuHash3072 before;
+    ASSERT_TRUE(db.GetUTXOHashState(before, *snapshot));
+    
+    // The chain moves on while the scan holds its view
+    for (uint8_t i = 5; i < 8; ++i) {
+        TxHash txHash;
+        txHash[0] = i;
+        ASSERT_TRUE(db.AddCoin(OutPoint(txHash, 0), coin).ok());
+    }
+    ASSERT_TRUE(db.SetBestBlock(second).ok());
+    
+    UTXOStats stats = GetUTXOStats(db, snapshot.get());
+    EXPECT_EQ(stats.nTransactionOutputs, 5u);
+    EXPECT_EQ(stats.hashBlock, first);
+    EXPECT_EQ(db.GetBestBlock(*snapshot), first);
+    
+    MuHash3072 after;
+    ASSERT_TRUE(db.GetUTXOHashState(after, *snapshot));
+    EXPECT_EQ(after.Finalize(), before.Finalize());
+    
+    // Without a snapshot the live set is scanned
+    UTXOStats live = GetUTXOStats(db);
+    EXPECT_EQ(live.nTransactionOutputs, 8u);
+    EXPECT_EQ(live.hashBlock, second);
+}
+
+TEST_F(DatabaseTest, CoinFilterHasNoFalseNegatives) {
+    CoinFilter filter(64 * 1024);
+    for (uint32_t i = 0; i < 5000; ++i) {
+        TxHash txHash;
+        txHash[0] = static_cast<uint8_t>(i);
+        txHash[1] = static_cast<uint8_t>(i >> 8);
+        filter.Add(OutPoint(txHash, i % 3));
+    }
+    EXPECT_EQ(filter.GetInsertCount(), 5000u);
+    
+    size_t falsePositives = 0;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        TxHash txHash;
+        txHash[0] = static_cast<uint8_t>(i);
+        txHash[1] = static_cast<uint8_t>(i >> 8);
+        ASSERT_TRUE(filter.MightContain(OutPoint(txHash, i % 3))) << i;
+        
+        txHash[2] = 0xFF;
+        falsePositives += filter.MightContain(OutPoint(txHash, 0)) ? 1 : 0;
+    }
+    
+    // About 100 bits per key: both measured and estimated rates are tiny
+    EXPECT_LT(falsePositives, 10u);
+    EXPECT_LT(filter.EstimateFalsePositiveRate(), 0.001);
+    EXPECT_GT(filter.EstimateFalsePositiveRate(), 0.0);
+}
+
+TEST_F(DatabaseTest, UTXODBCoinFilter) {
+    CoinsViewDB db(testDir_ / "utxo");
+    Coin coin(TxOut(1000000, Script()), 1, false);
+    
+    TxHash stored, later, missing;
+    stored[0] = 1;
+    later[0] = 2;
+    missing[0] = 3;
+    ASSERT_TRUE(db.AddCoin(OutPoint(stored, 0), coin).ok());
+    
+    EXPECT_EQ(db.EnableCoinFilter(4096), 1u);
+    const CoinFilter* filter = db.GetCoinFilter();
+    ASSERT_NE(filter, nullptr);
+    
+    EXPECT_TRUE(db.HaveCoin(OutPoint(stored, 0)));
+    EXPECT_TRUE(db.GetCoin(OutPoint(stored, 0)).has_value());
+    
+    // Coins written after the build are added as they are written
+    CoinsMap coins;
+    coins.emplace(OutPoint(later, 0), CoinsCacheEntry(Coin(coin)));
+    coins.begin()->second.SetDirty();
+    ASSERT_TRUE(db.BatchWrite(coins, BlockHash(), MuHash3072()));
+    EXPECT_TRUE(db.HaveCoin(OutPoint(later, 0)));
+    
+    uint64_t readsBefore = db.GetReadCount();
+    EXPECT_FALSE(db.GetCoin(OutPoint(missing, 0)).has_value());
+    EXPECT_FALSE(db.HaveCoin(OutPoint(missing, 0)));
+    
+    // With two keys in 32K bits a false positive is practically impossible
+    EXPECT_EQ(filter->GetFilteredCount(), 2u);
+    EXPECT_EQ(db.GetReadCount(), readsBefore);
+}
+
+TEST_F(DatabaseTest, CompressedCoinsRoundTrip) {
+    Hash160 hash;
+    for (size_t i = 0; i < hash.size(); ++i) {
+        hash[i] = static_cast<uint8_t>(i + 1);
+    }
+    PublicKey compressed = PrivateKey::Generate(true).GetPublicKey();
+    PublicKey uncompressed = PrivateKey::Generate(false).GetPublicKey();
+    ASSERT_EQ(uncompressed.size(), PublicKey::MAX_SIZE);
+    Script offCurve = Script() << std::vector<uint8_t>(65, 0x04) << OP_CHECKSIG;
+
+    const std::vector<std::pair<Script, size_t>> cases = {
+        {Script::CreateP2PKH(hash), 20},
+        {Script::CreateP2SH(hash), 20},
+        {Script() << compressed.ToVector() << OP_CHECKSIG, 32},
+        {Script() << uncompressed.ToVector() << OP_CHECKSIG, 32},
+        {offCurve, offCurve.size()},
+        {Script::CreateOpReturn({1, 2, 3}), 5},
+        {Script(), 0},
+    };
+    for (const auto& [script, payload] : cases) {
+        Coin coin(TxOut(50 * COIN, script), 700000, true);
+        std::string value = EncodeCoin(coin);
+        // Height code (3 bytes), amount (1 byte), size or type (1 byte)
+        EXPECT_EQ(value.size(), 5 + payload);
+        EXPECT_LE(value.size(), EncodeCoin(coin, COIN_FORMAT_LEGACY).size());
+
+        Coin decoded;
+        ASSERT_TRUE(DecodeCoin(value, decoded));
+        EXPECT_EQ(decoded, coin);
+    }
+
+    Coin coin(TxOut(COIN, Script::CreateP2PKH(hash)), 1, false);
+    std::string value = EncodeCoin(coin);
+    Coin decoded;
+    EXPECT_FALSE(DecodeCoin(value + "x", decoded));
+    EXPECT_FALSE(DecodeCoin(value.substr(0, value.size() - 1), decoded));
+}
+
+TEST_F(DatabaseTest, UTXODBUpgradesLegacyCoins) {
+    auto memory = std::make_unique<MemoryDatabase>();
+    MemoryDatabase* raw = memory.get();
+
+    // Legacy values, as a database from before the compressed format holds
+    constexpr uint32_t COUNT = 25000;
+    MuHash3072 expected;
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        TxHash txHash;
+        txHash[0] = static_cast<uint8_t>(i);
+        txHash[1] = static_cast<uint8_t>(i >> 8);
+        OutPoint outpoint(txHash, i % 3);
+        Hash160 hash;
+        hash[0] = static_cast<uint8_t>(i);
+        Coin coin(TxOut(i * 1000 + 1, Script::CreateP2PKH(hash)), i, i % 7 == 0);
+        AddCoinToHash(expected, outpoint, coin);
+        std::string value = EncodeCoin(coin, COIN_FORMAT_LEGACY);
+        raw->Put(WriteOptions(), Slice(MakeKey(prefix::COIN, outpoint)), Slice(value));
+    }
+
+    CoinsViewDB db(std::move(memory));
+    size_t seen = db.ForEachCoin([](const OutPoint& outpoint, const Coin& coin) {
+        EXPECT_EQ(coin.GetAmount(), static_cast<Amount>(coin.nHeight) * 1000 + 1);
+        EXPECT_EQ(coin.IsCoinBase(), coin.nHeight % 7 == 0);
+        EXPECT_EQ(outpoint.n, coin.nHeight % 3);
+        return true;
+    });
+    EXPECT_EQ(seen, COUNT);
+
+    MuHash3072 state;
+    ASSERT_TRUE(db.GetUTXOHashState(state));
+    EXPECT_EQ(state.Finalize(), expected.Finalize());
+}
+
+TEST_F(DatabaseTest, UTXODBResumesInterruptedUpgrade) {
+    auto memory = std::make_unique<MemoryDatabase>();
+    MemoryDatabase* raw = memory.get();
+
+    // The first half was rewritten before the upgrade stopped
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < 10; ++i) {
+        TxHash txHash;
+        txHash[0] = static_cast<uint8_t>(i);
+        Coin coin(TxOut((i + 1) * COIN, Script()), i, false);
+        keys.push_back(MakeKey(prefix::COIN, OutPoint(txHash, 0)));
+        std::string value = EncodeCoin(coin, i < 5 ? COIN_FORMAT_COMPRESSED : COIN_FORMAT_LEGACY);
+        raw->Put(WriteOptions(), Slice(keys.back()), Slice(value));
+    }
+    std::sort(keys.begin(), keys.end());
+    raw->Put(WriteOptions(), Slice(MakeKey(prefix::FLAG, Slice("coinformatupgrade"))),
+             Slice(keys[4]));
+
+    CoinsViewDB db(std::move(memory));
+    Amount total = 0;
+    EXPECT_EQ(db.ForEachCoin([&total](const OutPoint&, const Coin& coin) {
+        total += coin.GetAmount();
+        return true;
+    }), 10u);
+    EXPECT_EQ(total, 55 * COIN);
+
+    std::string value;
+    EXPECT_TRUE(raw->Get(ReadOptions(), Slice(MakeKey(prefix::FLAG, Slice("coinformat"))),
+                         &value).ok());
+    EXPECT_FALSE(raw->Get(ReadOptions(), Slice(MakeKey(prefix::FLAG, Slice("coinformatupgrade"))),
+                          &value).ok());
+}
+
 // ============================================================================
 // Status Tests
 // ============================================================================
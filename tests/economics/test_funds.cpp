@@ -0,0 +1,164 @@
+// SHURIUM - Fund Management Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+
+#include <shurium/economics/funds.h>
+#include <shurium/core/block.h>
+#include <shurium/core/script.h>
+#include <shurium/core/transaction.h>
+
+#include <memory>
+#include <vector>
+
+namespace shurium {
+namespace economics {
+namespace {
+
+// ============================================================================
+// Test Fixtures
+// ============================================================================
+
+class FundManagerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<FundManager> manager_;
+
+    void SetUp() override {
+        manager_ = std::make_unique<FundManager>();
+        ASSERT_TRUE(manager_->Initialize("regtest"));
+    }
+
+    Script FundScript(FundType type) {
+        return Script::CreateP2SH(manager_->GetFundAddress(type));
+    }
+
+    /// Coinbase paying ubi and ecosystem amounts to their funds
+    TransactionRef MakeCoinbase(int height, Amount ubi, Amount ecosystem) {
+        MutableTransaction tx;
+        tx.vin.push_back(TxIn(OutPoint()));
+        tx.vout.push_back(TxOut(COIN + height, Script() << OP_TRUE));  // Unique txid
+        tx.vout.push_back(TxOut(ubi, FundScript(FundType::UBI)));
+        tx.vout.push_back(TxOut(ecosystem, FundScript(FundType::Ecosystem)));
+        return MakeTransactionRef(std::move(tx));
+    }
+
+    /// Spend of prevouts with an optional change output back to a fund
+    TransactionRef MakeSpend(const std::vector<OutPoint>& prevouts, Amount change,
+                             FundType changeFund) {
+        MutableTransaction tx;
+        for (const auto& prevout : prevouts) {
+            tx.vin.push_back(TxIn(prevout));
+        }
+        tx.vout.push_back(TxOut(COIN, Script() << OP_TRUE));
+        if (change > 0) {
+            tx.vout.push_back(TxOut(change, FundScript(changeFund)));
+        }
+        return MakeTransactionRef(std::move(tx));
+    }
+
+    Block MakeBlock(std::vector<TransactionRef> txs) {
+        Block block;
+        block.vtx = std::move(txs);
+        return block;
+    }
+};
+
+// ============================================================================
+// UTXO Index Tests
+// ============================================================================
+
+TEST_F(FundManagerTest, TracksBalancesWithRunningTotals) {
+    OutPoint a(TxHash(), 1);
+    OutPoint b(TxHash(), 2);
+
+    manager_->TrackFundUTXO(FundType::UBI, a, 30 * COIN, 1);
+    manager_->TrackFundUTXO(FundType::UBI, b, 10 * COIN, 2);
+    manager_->TrackFundUTXO(FundType::UBI, b, 10 * COIN, 2);  // Duplicate ignored
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 40 * COIN);
+    EXPECT_EQ(manager_->GetFundUTXOCount(FundType::UBI), 2u);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::Ecosystem), 0);
+
+    manager_->MarkFundUTXOSpent(FundType::UBI, a, 3);
+    manager_->MarkFundUTXOSpent(FundType::UBI, a, 3);  // Already spent
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 10 * COIN);
+    EXPECT_EQ(manager_->GetTotalReceived(FundType::UBI), 40 * COIN);
+    EXPECT_EQ(manager_->GetTotalSpent(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetTransactionCount(FundType::UBI), 3u);
+    EXPECT_EQ(manager_->GetLastActivityHeight(FundType::UBI), 3);
+
+    auto utxos = manager_->GetFundUTXOs(FundType::UBI);
+    ASSERT_EQ(utxos.size(), 1u);
+    EXPECT_EQ(utxos[0].first, b);
+
+    manager_->UnmarkFundUTXOSpent(FundType::UBI, a);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 40 * COIN);
+    EXPECT_EQ(manager_->GetTotalSpent(FundType::UBI), 0);
+
+    manager_->UntrackFundUTXO(FundType::UBI, b);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetTotalReceived(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetTransactionCount(FundType::UBI), 1u);
+}
+
+TEST_F(FundManagerTest, FundUTXOsLargestFirst) {
+    manager_->TrackFundUTXO(FundType::Stability, OutPoint(TxHash(), 1), 5 * COIN, 1);
+    manager_->TrackFundUTXO(FundType::Stability, OutPoint(TxHash(), 2), 50 * COIN, 1);
+    manager_->TrackFundUTXO(FundType::Stability, OutPoint(TxHash(), 3), 20 * COIN, 1);
+
+    auto utxos = manager_->GetFundUTXOs(FundType::Stability);
+    ASSERT_EQ(utxos.size(), 3u);
+    EXPECT_EQ(utxos[0].second, 50 * COIN);
+    EXPECT_EQ(utxos[1].second, 20 * COIN);
+    EXPECT_EQ(utxos[2].second, 5 * COIN);
+}
+
+TEST_F(FundManagerTest, ConnectAndDisconnectBlocks) {
+    Block block1 = MakeBlock({MakeCoinbase(1, 30 * COIN, 10 * COIN)});
+    manager_->ConnectBlock(block1, 1);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::Ecosystem), 10 * COIN);
+
+    // Block 2 spends the UBI output, with change back to the pool
+    OutPoint ubiOut(block1.vtx[0]->GetHash(), 1);
+    Block block2 = MakeBlock({MakeCoinbase(2, 30 * COIN, 10 * COIN),
+                              MakeSpend({ubiOut}, 29 * COIN, FundType::UBI)});
+    manager_->ConnectBlock(block2, 2);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 59 * COIN);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::Ecosystem), 20 * COIN);
+    EXPECT_EQ(manager_->GetTotalSpent(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetFundUTXOCount(FundType::UBI), 2u);
+
+    // Disconnecting restores exactly the state after block 1
+    manager_->DisconnectBlock(block2, 2);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::Ecosystem), 10 * COIN);
+    EXPECT_EQ(manager_->GetTotalReceived(FundType::UBI), 30 * COIN);
+    EXPECT_EQ(manager_->GetTotalSpent(FundType::UBI), 0);
+    EXPECT_EQ(manager_->GetTransactionCount(FundType::UBI), 1u);
+    EXPECT_EQ(manager_->GetLastActivityHeight(FundType::UBI), 1);
+    auto utxos = manager_->GetFundUTXOs(FundType::UBI);
+    ASSERT_EQ(utxos.size(), 1u);
+    EXPECT_EQ(utxos[0].first, ubiOut);
+
+    manager_->DisconnectBlock(block1, 1);
+    EXPECT_EQ(manager_->GetFundBalance(FundType::UBI), 0);
+    EXPECT_EQ(manager_->GetFundUTXOCount(FundType::Ecosystem), 0u);
+}
+
+TEST_F(FundManagerTest, IgnoresNonFundOutputs) {
+    MutableTransaction tx;
+    tx.vin.push_back(TxIn(OutPoint()));
+    tx.vout.push_back(TxOut(COIN, Script() << OP_TRUE));
+    tx.vout.push_back(TxOut(COIN, Script::CreateP2SH(Hash160())));
+    manager_->ConnectBlock(MakeBlock({MakeTransactionRef(std::move(tx))}), 1);
+
+    for (const auto& config : manager_->GetAllFunds()) {
+        EXPECT_EQ(manager_->GetFundBalance(config.type), 0);
+        EXPECT_EQ(manager_->GetTransactionCount(config.type), 0u);
+    }
+}
+
+} // namespace
+} // namespace economics
+} // namespace shurium
@@ -71,6 +71,24 @@ protected:
         submission.confidence = 100;
         return submission;
     }
+    
+    // Helper to register an active oracle backed by a real key
+    OracleId RegisterKeyedOracle(OracleRegistry& registry, const PrivateKey& key, Byte seed) {
+        auto id = registry.Register(key.GetPublicKey(), CreateTestAddress(seed),
+                                    MIN_ORACLE_STAKE, 0, "KeyedOracle");
+        EXPECT_TRUE(id.has_value());
+        registry.UpdateStatus(*id, OracleStatus::Active);
+        return *id;
+    }
+    
+    // Helper to create a Schnorr-signed price submission
+    PriceSubmission CreateSignedSubmission(const PrivateKey& key, const OracleId& oracleId,
+                                           PriceMillicents price, int height) {
+        PriceSubmission submission = CreateTestSubmission(oracleId, price, height);
+        auto sig = key.SignSchnorr(submission.GetHash());
+        submission.signature.assign(sig.begin(), sig.end());
+        return submission;
+    }
 };
 
 // ============================================================================
@@ -598,10 +616,116 @@ TEST_F(OracleTest, PriceAggregatorConfig) {
     EXPECT_EQ(aggregator_->GetConfig().minSources, 5);
 }
 
+TEST_F(OracleTest, PriceSubmissionVerifiesRealSignatures) {
+    PrivateKey key = PrivateKey::Generate();
+    OracleId id = RegisterKeyedOracle(*registry_, key, 0x01);
+    
+    PriceSubmission schnorr = CreateSignedSubmission(key, id, 100000, 100);
+    EXPECT_TRUE(schnorr.VerifySignature(key.GetPublicKey()));
+    
+    PriceSubmission ecdsa = CreateTestSubmission(id, 100000, 100);
+    ecdsa.signature = key.Sign(ecdsa.GetHash());
+    EXPECT_TRUE(ecdsa.VerifySignature(key.GetPublicKey()));
+    
+    // Any change to the signed fields breaks the signature
+    schnorr.price += 1;
+    EXPECT_FALSE(schnorr.VerifySignature(key.GetPublicKey()));
+    EXPECT_FALSE(ecdsa.VerifySignature(PrivateKey::Generate().GetPublicKey()));
+}
+
+TEST_F(OracleTest, PriceAggregatorBatchSubmissions) {
+    std::vector<PrivateKey> keys;
+    std::vector<OracleId> ids;
+    for (Byte i = 1; i <= 4; ++i) {
+        keys.push_back(PrivateKey::Generate());
+        ids.push_back(RegisterKeyedOracle(*registry_, keys.back(), i));
+    }
+    
+    std::vector<PriceSubmission> batch;
+    batch.push_back(CreateSignedSubmission(keys[0], ids[0], 100000, 100));
+    batch.push_back(CreateSignedSubmission(keys[1], ids[1], 100100, 100));
+    batch.back().signature[10] ^= 0x01;                                      // Corrupted
+    batch.push_back(CreateSignedSubmission(keys[0], ids[2], 100200, 100));  // Wrong key
+    batch.push_back(CreateTestSubmission(ids[3], 100300, 100));             // ECDSA
+    batch.back().signature = keys[3].Sign(batch.back().GetHash());
+    batch.push_back(CreateTestSubmission(ids[3], 100400, 100));             // Unsigned
+    
+    auto accepted = aggregator_->ProcessSubmissions(batch);
+    EXPECT_EQ(accepted, (std::vector<bool>{true, false, false, true, false}));
+    
+    auto submissions = aggregator_->GetCurrentSubmissions();
+    ASSERT_EQ(submissions.size(), 2u);
+    EXPECT_EQ(submissions[0].price, 100000);
+    EXPECT_EQ(submissions[1].price, 100300);
+}
+
+TEST_F(OracleTest, PriceAggregatorBatchReveals) {
+    std::vector<OracleId> ids;
+    std::vector<PriceCommitment> commitments;
+    for (Byte i = 1; i <= 3; ++i) {
+        ids.push_back(*RegisterTestOracle(i));
+        commitments.push_back(PriceCommitment::Create(ids.back(), 100000 + i, 100, 10));
+        EXPECT_TRUE(aggregator_->ProcessCommitment(commitments.back()));
+    }
+    
+    std::vector<PriceReveal> reveals = {
+        {ids[0], 100001, commitments[0].salt},
+        {ids[1], 100005, commitments[1].salt},         // Wrong price
+        {ids[2], 100003, commitments[2].salt},
+        {ids[0], 100001, commitments[0].salt},         // Second reveal
+        {CreateTestOracleId(0x77), 1, Hash256()},      // No commitment
+    };
+    auto valid = aggregator_->ProcessReveals(reveals);
+    EXPECT_EQ(valid, (std::vector<bool>{true, false, true, false, false}));
+    EXPECT_EQ(aggregator_->GetPendingSubmissionCount(), 2u);
+    
+    // Batch and single verification agree; a revealed commitment stays closed
+    EXPECT_TRUE(aggregator_->ProcessReveal(ids[1], 100002, commitments[1].salt));
+    EXPECT_FALSE(aggregator_->ProcessReveal(ids[1], 100002, commitments[1].salt));
+    EXPECT_EQ(aggregator_->GetPendingSubmissionCount(), 3u);
+}
+
+TEST_F(OracleTest, PriceCommitmentBoundToOracle) {
+    auto id1 = CreateTestOracleId(0x01);
+    auto id2 = CreateTestOracleId(0x02);
+    PriceCommitment commitment = PriceCommitment::Create(id1, 100000, 100, 10);
+    
+    PriceCommitment replayed = commitment;
+    replayed.oracleId = id2;
+    EXPECT_TRUE(commitment.VerifyReveal(100000, commitment.salt));
+    EXPECT_FALSE(replayed.VerifyReveal(100000, commitment.salt));
+}
+
 // ============================================================================
 // OraclePriceFeed Tests
 // ============================================================================
 
+TEST_F(OracleTest, OraclePriceFeedBatchesQueuedWorkPerBlock) {
+    OraclePriceFeed feed;
+    auto registry = std::make_shared<OracleRegistry>();
+    feed.Initialize(registry);
+    
+    size_t updates = 0;
+    feed.OnPriceUpdate([&updates](const AggregatedPrice&) { ++updates; });
+    
+    for (Byte i = 1; i <= 3; ++i) {
+        PrivateKey key = PrivateKey::Generate();
+        OracleId id = RegisterKeyedOracle(*registry, key, i);
+        feed.QueueSubmission(CreateSignedSubmission(key, id, 100000 + i * 10, 100));
+    }
+    
+    // Nothing is verified or aggregated until the block arrives
+    EXPECT_EQ(feed.GetQueuedCount(), 3u);
+    EXPECT_EQ(feed.GetAggregator().GetPendingSubmissionCount(), 0u);
+    EXPECT_FALSE(feed.GetCurrentPrice().has_value());
+    
+    feed.ProcessBlock(101);
+    EXPECT_EQ(feed.GetQueuedCount(), 0u);
+    EXPECT_EQ(updates, 1u);
+    ASSERT_TRUE(feed.GetCurrentPrice().has_value());
+    EXPECT_EQ(feed.GetCurrentPrice()->sourceCount, 3u);
+}
+
 TEST_F(OracleTest, OraclePriceFeedConstruction) {
     OraclePriceFeed feed;
     EXPECT_FALSE(feed.GetCurrentPrice().has_value());
@@ -7,6 +7,8 @@
 #include <shurium/economics/reward.h>
 #include <shurium/consensus/params.h>
 
+#include <limits>
+
 namespace shurium {
 namespace economics {
 namespace {
@@ -319,6 +321,87 @@ TEST_F(RewardTest, CoinbaseBuilderVerifyCoinbaseInvalid) {
     EXPECT_FALSE(builder.VerifyCoinbase(0, outputs));
 }
 
+TEST_F(RewardTest, RewardScheduleMatchesSubsidy) {
+    const auto& schedule = calculator_->GetRewardSchedule();
+    ASSERT_FALSE(schedule.empty());
+    EXPECT_EQ(schedule.front().total, INITIAL_BLOCK_REWARD);
+    EXPECT_EQ(schedule.back().total, MINIMUM_BLOCK_REWARD);
+    
+    for (size_t i = 0; i < schedule.size(); ++i) {
+        int height = static_cast<int>(i) * HALVING_INTERVAL;
+        EXPECT_EQ(calculator_->GetScheduleIndex(height), static_cast<int>(i));
+        EXPECT_EQ(calculator_->GetBlockSubsidy(height), schedule[i].total);
+        EXPECT_TRUE(schedule[i].IsValid());
+    }
+    
+    // Past the last entry the floor applies
+    EXPECT_EQ(calculator_->GetBlockSubsidy(std::numeric_limits<int>::max()),
+              MINIMUM_BLOCK_REWARD);
+    EXPECT_EQ(calculator_->GetScheduleIndex(-1), -1);
+    EXPECT_EQ(calculator_->GetRewardDistribution(-1).total, 0);
+}
+
+TEST_F(RewardTest, CoinbaseTemplatesMatchFullBuild) {
+    std::array<Byte, 20> minerData{}, ubiData{}, contribData{}, ecoData{}, stabData{};
+    std::fill(minerData.begin(), minerData.end(), 0x01);
+    std::fill(ubiData.begin(), ubiData.end(), 0x02);
+    std::fill(contribData.begin(), contribData.end(), 0x05);
+    std::fill(ecoData.begin(), ecoData.end(), 0x03);
+    std::fill(stabData.begin(), stabData.end(), 0x04);
+    
+    Hash160 miner(minerData);
+    Hash160 ubi(ubiData);
+    Hash160 contrib(contribData);
+    Hash160 eco(ecoData);
+    Hash160 stab(stabData);
+    
+    CoinbaseBuilder plain(*calculator_);
+    CoinbaseBuilder templated(*calculator_, ubi, contrib, eco, stab);
+    ASSERT_TRUE(templated.HasTemplates());
+    EXPECT_TRUE(plain.BuildCoinbase(0, miner).empty());
+    
+    for (int height : {0, HALVING_INTERVAL - 1, HALVING_INTERVAL, 5 * HALVING_INTERVAL}) {
+        auto expected = plain.BuildCoinbase(height, miner, ubi, contrib, eco, stab);
+        auto outputs = templated.BuildCoinbase(height, miner);
+        EXPECT_EQ(outputs, expected);
+        EXPECT_TRUE(templated.VerifyCoinbase(height, outputs));
+    }
+}
+
+TEST_F(RewardTest, CoinbaseTemplatesRejectWrongStructure) {
+    std::array<Byte, 20> minerData{}, fundData{}, otherData{};
+    std::fill(minerData.begin(), minerData.end(), 0x01);
+    std::fill(fundData.begin(), fundData.end(), 0x02);
+    std::fill(otherData.begin(), otherData.end(), 0x09);
+    Hash160 miner(minerData);
+    Hash160 fund(fundData);
+    Hash160 other(otherData);
+    
+    CoinbaseBuilder builder(*calculator_, fund, fund, fund, fund);
+    auto good = builder.BuildCoinbase(0, miner);
+    ASSERT_TRUE(builder.VerifyCoinbase(0, good));
+    
+    // Right total, but a fund output redirected to another address
+    CoinbaseBuilder plain(*calculator_);
+    auto redirected = plain.BuildCoinbase(0, miner, fund, other, fund, fund);
+    EXPECT_TRUE(plain.VerifyCoinbase(0, redirected));
+    EXPECT_FALSE(builder.VerifyCoinbase(0, redirected));
+    
+    // Right total, but amounts shifted between miner and UBI pool
+    auto shifted = good;
+    shifted[0].second += 1;
+    shifted[1].second -= 1;
+    EXPECT_FALSE(builder.VerifyCoinbase(0, shifted));
+    
+    // Missing output
+    auto truncated = good;
+    truncated.pop_back();
+    EXPECT_FALSE(builder.VerifyCoinbase(0, truncated));
+    
+    // Outputs for the wrong epoch
+    EXPECT_FALSE(builder.VerifyCoinbase(HALVING_INTERVAL, good));
+}
+
 // ============================================================================
 // Utility Function Tests
 // ============================================================================
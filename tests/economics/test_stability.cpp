@@ -8,6 +8,7 @@
 #include <shurium/economics/reward.h>
 #include <shurium/consensus/params.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <thread>
@@ -285,6 +286,77 @@ TEST_F(StabilityTest, TWAPPrune) {
     EXPECT_GE(twap.ObservationCount(), 0);
 }
 
+TEST_F(StabilityTest, TWAPRunningSumsFollowPrune) {
+    auto now = std::chrono::system_clock::now();
+    auto at = [&](PriceMillicents price, int secondsAgo) {
+        PriceObservation obs = CreatePriceObservation(price);
+        obs.timestamp = now - std::chrono::seconds(secondsAgo);
+        return obs;
+    };
+    
+    // 100 for 100s, 200 for 100s, 300 for ~100s up to now
+    TimeWeightedAveragePrice wide(std::chrono::seconds(3600));
+    wide.AddObservation(at(100000, 300));
+    wide.AddObservation(at(200000, 200));
+    wide.AddObservation(at(300000, 100));
+    EXPECT_EQ(wide.ObservationCount(), 3);
+    EXPECT_NEAR(wide.Calculate(), 200000, 500);
+    
+    // The oldest sample falls outside the window and leaves the sums
+    TimeWeightedAveragePrice narrow(std::chrono::seconds(250));
+    narrow.AddObservation(at(100000, 300));
+    narrow.AddObservation(at(200000, 200));
+    narrow.AddObservation(at(300000, 100));
+    EXPECT_EQ(narrow.ObservationCount(), 2);
+    EXPECT_NEAR(narrow.Calculate(), 250000, 500);
+}
+
+// ============================================================================
+// RollingMedian Tests
+// ============================================================================
+
+TEST_F(StabilityTest, RollingMedianEmpty) {
+    RollingMedian median;
+    EXPECT_EQ(median.Size(), 0);
+    EXPECT_FALSE(median.Median().has_value());
+    EXPECT_FALSE(median.Remove(100000));
+}
+
+TEST_F(StabilityTest, RollingMedianMatchesSortedMedian) {
+    RollingMedian median;
+    std::vector<PriceMillicents> values;
+    uint32_t state = 12345;
+    auto next = [&]() {
+        state = state * 1103515245 + 12345;
+        return static_cast<PriceMillicents>((state >> 8) % 50) * 1000;
+    };
+    
+    for (int step = 0; step < 500; ++step) {
+        if (!values.empty() && next() % 3000 == 0) {
+            size_t pick = static_cast<size_t>(next() / 1000) % values.size();
+            EXPECT_TRUE(median.Remove(values[pick]));
+            values.erase(values.begin() + pick);
+        } else {
+            PriceMillicents value = next();
+            median.Add(value);
+            values.push_back(value);
+        }
+        
+        ASSERT_EQ(median.Size(), values.size());
+        if (values.empty()) {
+            EXPECT_FALSE(median.Median().has_value());
+            continue;
+        }
+        std::vector<PriceMillicents> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        ASSERT_EQ(median.Median(), sorted[sorted.size() / 2]);
+    }
+    
+    median.Clear();
+    EXPECT_EQ(median.Size(), 0);
+    EXPECT_FALSE(median.Median().has_value());
+}
+
 // ============================================================================
 // StabilityController Tests
 // ============================================================================
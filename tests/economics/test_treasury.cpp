@@ -709,6 +709,87 @@ TEST_F(TreasuryTest, TreasuryGenerateReport) {
     EXPECT_GT(report.categoryBalances.size(), 0);
 }
 
+TEST_F(TreasuryTest, TreasuryStatusIndexFollowsLifecycle) {
+    treasury_->AddFunds(100000 * COIN, TreasuryCategory::EcosystemDevelopment);
+    treasury_->SetTotalVotingPowerCalculator([]() -> uint64_t { return 1000; });
+    treasury_->StartNewPeriod(0);
+    
+    TreasuryProposal proposal = CreateTestProposal(0x01);
+    auto proposalId = treasury_->SubmitProposal(
+        proposal, CalculateProposalDeposit(proposal.requestedAmount), 100);
+    ASSERT_TRUE(proposalId.has_value());
+    TreasuryProposal cancelled = CreateTestProposal(0x02);
+    auto cancelledId = treasury_->SubmitProposal(cancelled, 1000 * COIN, 100);
+    ASSERT_TRUE(cancelledId.has_value());
+    ASSERT_TRUE(treasury_->CancelProposal(*cancelledId, cancelled.proposer));
+    
+    // A signed vote is indexed by voter
+    PrivateKey key = PrivateKey::Generate();
+    TreasuryVote vote;
+    vote.proposalId = *proposalId;
+    vote.voter = key.GetPublicKey();
+    vote.inFavor = true;
+    vote.votingPower = 1000;
+    vote.voteHeight = 101;
+    auto message = vote.GetSignatureMessage();
+    vote.signature = key.Sign(SHA256Hash(message.data(), message.size()));
+    ASSERT_TRUE(treasury_->SubmitVote(vote, 101));
+    EXPECT_TRUE(treasury_->HasVoted(*proposalId, vote.voter));
+    EXPECT_FALSE(treasury_->SubmitVote(vote, 102));
+    
+    EXPECT_EQ(treasury_->GetProposals(ProposalStatus::Voting).size(), 1u);
+    EXPECT_EQ(treasury_->GetProposals(ProposalStatus::Cancelled).size(), 1u);
+    EXPECT_EQ(treasury_->GetActiveProposals(101).size(), 1u);
+    
+    // Voting ends, then the approved proposal executes once its delay passes
+    const TreasuryProposal* stored = treasury_->GetProposal(*proposalId);
+    treasury_->ProcessBlock(stored->votingEndHeight + 1);
+    EXPECT_EQ(stored->status, ProposalStatus::Approved);
+    EXPECT_EQ(treasury_->GetProposals(ProposalStatus::Approved).size(), 1u);
+    EXPECT_TRUE(treasury_->GetProposals(ProposalStatus::Voting).empty());
+    
+    treasury_->ProcessBlock(stored->executionHeight);
+    EXPECT_EQ(stored->status, ProposalStatus::Executed);
+    EXPECT_TRUE(treasury_->GetProposals(ProposalStatus::Approved).empty());
+    EXPECT_EQ(treasury_->GetProposals(ProposalStatus::Executed).size(), 1u);
+    EXPECT_EQ(treasury_->GetBalance(), 90000 * COIN);
+    
+    // The indexes survive a round trip
+    std::vector<Byte> serialized = treasury_->Serialize();
+    Treasury restored;
+    ASSERT_TRUE(restored.Deserialize(serialized.data(), serialized.size()));
+    EXPECT_EQ(restored.GetProposals(ProposalStatus::Executed).size(), 1u);
+    EXPECT_EQ(restored.GetProposals(ProposalStatus::Cancelled).size(), 1u);
+    EXPECT_TRUE(restored.HasVoted(*proposalId, vote.voter));
+}
+
+TEST_F(TreasuryTest, TreasuryReportCachedUntilTreasuryEvent) {
+    treasury_->StartNewPeriod(0);
+    treasury_->AddFunds(50000 * COIN, TreasuryCategory::EcosystemDevelopment);
+    
+    Treasury::Report first = treasury_->GenerateReport(1000);
+    EXPECT_EQ(first.periodReceived, 50000 * COIN);
+    Treasury::Report again = treasury_->GenerateReport(1000);
+    EXPECT_EQ(again.timestamp, first.timestamp);
+    
+    // A different height is a different report
+    EXPECT_EQ(treasury_->GenerateReport(1001).height, 1001);
+    
+    // Treasury events invalidate it
+    treasury_->AddFunds(10000 * COIN, TreasuryCategory::Security);
+    Treasury::Report funded = treasury_->GenerateReport(1001);
+    EXPECT_EQ(funded.totalBalance, 60000 * COIN);
+    EXPECT_EQ(funded.periodReceived, 60000 * COIN);
+    
+    TreasuryProposal proposal = CreateTestProposal(0x01);
+    proposal.requestedAmount = 5000 * COIN;  // Within 10% of the balance
+    ASSERT_TRUE(treasury_->SubmitProposal(proposal, 1000 * COIN, 1001).has_value());
+    EXPECT_EQ(treasury_->GenerateReport(1001).activeProposals, 1u);
+    
+    treasury_->StartNewPeriod(2000);
+    EXPECT_EQ(treasury_->GenerateReport(1001).periodReceived, 0);
+}
+
 TEST_F(TreasuryTest, TreasuryReportToString) {
     treasury_->AddFunds(50000 * COIN, TreasuryCategory::EcosystemDevelopment);
     
@@ -735,6 +816,34 @@ TEST_F(TreasuryTest, TreasurySerializeDeserialize) {
     EXPECT_EQ(newTreasury.GetBalance(), 75000 * COIN);
 }
 
+TEST_F(TreasuryTest, TreasurySerializeRestoresProposals) {
+    treasury_->AddFunds(100000 * COIN, TreasuryCategory::EcosystemDevelopment);
+    TreasuryProposal proposal = CreateTestProposal(0x01);
+    proposal.url = "https://example.org/proposal";
+    proposal.milestones.push_back({"First half", 5000 * COIN, 500, false});
+    Amount deposit = CalculateProposalDeposit(proposal.requestedAmount);
+    auto proposalId = treasury_->SubmitProposal(proposal, deposit, 100);
+    ASSERT_TRUE(proposalId.has_value());
+    
+    std::vector<Byte> serialized = treasury_->Serialize();
+    Treasury restored;
+    ASSERT_TRUE(restored.Deserialize(serialized.data(), serialized.size()));
+    
+    EXPECT_EQ(restored.GetBalance(), treasury_->GetBalance());
+    const TreasuryProposal* original = treasury_->GetProposal(*proposalId);
+    const TreasuryProposal* copy = restored.GetProposal(*proposalId);
+    ASSERT_NE(copy, nullptr);
+    EXPECT_EQ(copy->proposer, original->proposer);
+    EXPECT_EQ(copy->deposit, original->deposit);
+    EXPECT_EQ(copy->status, original->status);
+    EXPECT_EQ(copy->votingEndHeight, original->votingEndHeight);
+    EXPECT_EQ(copy->url, original->url);
+    ASSERT_EQ(copy->milestones.size(), 1u);
+    EXPECT_EQ(copy->milestones[0].amount, 5000 * COIN);
+    EXPECT_EQ(restored.GetCurrentBudget().periodEnd, treasury_->GetCurrentBudget().periodEnd);
+    EXPECT_EQ(restored.Serialize(), serialized);
+}
+
 // ============================================================================
 // TreasuryOutputBuilder Tests
 // ============================================================================
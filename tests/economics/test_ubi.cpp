@@ -8,6 +8,8 @@
 #include <shurium/economics/reward.h>
 #include <shurium/consensus/params.h>
 #include <shurium/identity/nullifier.h>
+#include <shurium/identity/zkproof.h>
+#include <shurium/util/threadpool.h>
 
 #include <array>
 #include <vector>
@@ -187,22 +189,14 @@ TEST_F(UBITest, EpochUBIPoolFinalizeZeroIdentities) {
     EXPECT_EQ(pool.amountPerPerson, 0);  // No division by zero
 }
 
-TEST_F(UBITest, EpochUBIPoolNullifierTracking) {
+TEST_F(UBITest, EpochUBIPoolRecordClaim) {
     EpochUBIPool pool;
     pool.epoch = 1;
     pool.totalPool = 1000 * COIN;
     pool.Finalize(100);
     
-    auto nullifier = CreateTestNullifier(1, 0x01);
+    pool.RecordClaim(pool.amountPerPerson);
     
-    // Initially not used
-    EXPECT_FALSE(pool.IsNullifierUsed(nullifier));
-    
-    // Record a claim
-    pool.RecordClaim(nullifier, pool.amountPerPerson);
-    
-    // Now it should be used
-    EXPECT_TRUE(pool.IsNullifierUsed(nullifier));
     EXPECT_EQ(pool.claimCount, 1);
     EXPECT_EQ(pool.amountClaimed, pool.amountPerPerson);
 }
@@ -216,8 +210,7 @@ TEST_F(UBITest, EpochUBIPoolUnclaimedAmount) {
     EXPECT_EQ(pool.UnclaimedAmount(), 1000 * COIN);
     
     // Record a claim
-    auto nullifier = CreateTestNullifier(1, 0x01);
-    pool.RecordClaim(nullifier, pool.amountPerPerson);
+    pool.RecordClaim(pool.amountPerPerson);
     
     EXPECT_EQ(pool.UnclaimedAmount(), 1000 * COIN - 10 * COIN);
 }
@@ -232,8 +225,7 @@ TEST_F(UBITest, EpochUBIPoolClaimRate) {
     
     // Claim 50 times
     for (int i = 0; i < 50; ++i) {
-        auto nullifier = CreateTestNullifier(1, static_cast<Byte>(i));
-        pool.RecordClaim(nullifier, pool.amountPerPerson);
+        pool.RecordClaim(pool.amountPerPerson);
     }
     
     EXPECT_NEAR(pool.ClaimRate(), 50.0, 0.1);  // 50% claim rate
@@ -357,6 +349,79 @@ TEST_F(UBITest, UBIDistributorGetEpochStats) {
     EXPECT_DOUBLE_EQ(stats.claimRate, 0.0);
 }
 
+TEST_F(UBITest, UBIDistributorProcessClaimsMatchesSequential) {
+    identity::VerificationKey key;
+    key.circuitId = "ubi_claim";
+    key.system = identity::ProofSystem::Groth16;
+    key.numPublicInputs = 3;
+    identity::ProofVerifier::Instance().RegisterKey("ubi_claim", key);
+    
+    const EpochId epoch = 0;
+    std::vector<identity::IdentitySecrets> secrets;
+    identity::VectorCommitment tree;
+    for (int i = 0; i < 20; ++i) {
+        secrets.push_back(identity::IdentitySecrets::Generate());
+        tree.Add(secrets.back().GetCommitment().ToFieldElement());
+    }
+    FieldElement root = tree.GetRoot();
+    Hash256 rootHash(root.ToBytes().data(), 32);
+    
+    auto makeClaim = [&](size_t i, const FieldElement& provenRoot) {
+        UBIClaim claim;
+        claim.epoch = epoch;
+        claim.nullifier = secrets[i].DeriveNullifier(epoch);
+        claim.recipient = CreateTestAddress(static_cast<Byte>(i));
+        claim.proof = identity::IdentityProof::CreateUBIClaimProof(
+            provenRoot, claim.nullifier, epoch,
+            secrets[i].secretKey, secrets[i].nullifierKey, secrets[i].trapdoor,
+            *tree.Prove(i)).GetZKProof();
+        return claim;
+    };
+    
+    std::vector<UBIClaim> claims;
+    for (size_t i = 0; i < 18; ++i) {
+        claims.push_back(makeClaim(i, root));
+    }
+    claims.push_back(makeClaim(0, root));                  // Repeats claim 0
+    claims.push_back(makeClaim(18, FieldElement::One()));  // Wrong root
+    claims.push_back(makeClaim(18, root));                 // Retry after it
+    claims.push_back(makeClaim(19, root));                 // Already claimed
+    
+    auto setUp = [&](UBIDistributor& distributor) {
+        distributor.AddBlockReward(0, 1000 * COIN);
+        distributor.FinalizeEpoch(epoch, 100);
+        UBIClaim early = makeClaim(19, root);
+        ASSERT_EQ(distributor.ProcessClaim(early, rootHash, 1), ClaimStatus::Valid);
+    };
+    int height = distributor_->GetClaimDeadline(epoch) - 1;
+    
+    UBIDistributor sequential(*calculator_);
+    setUp(sequential);
+    std::vector<UBIClaim> sequentialClaims = claims;
+    std::vector<ClaimStatus> expected;
+    for (UBIClaim& claim : sequentialClaims) {
+        expected.push_back(sequential.ProcessClaim(claim, rootHash, height));
+    }
+    EXPECT_EQ(expected[0], ClaimStatus::Valid);
+    EXPECT_EQ(expected[18], ClaimStatus::DoubleClaim);
+    EXPECT_EQ(expected[19], ClaimStatus::InvalidProof);
+    EXPECT_EQ(expected[20], ClaimStatus::Valid);
+    EXPECT_EQ(expected[21], ClaimStatus::DoubleClaim);
+    
+    util::ThreadPool pool(4);
+    for (util::ThreadPool* threads : {static_cast<util::ThreadPool*>(nullptr), &pool}) {
+        UBIDistributor batched(*calculator_);
+        setUp(batched);
+        std::vector<UBIClaim> batchClaims = claims;
+        EXPECT_EQ(batched.ProcessClaims(batchClaims, rootHash, height, threads), expected);
+        EXPECT_EQ(batched.GetTotalClaims(), sequential.GetTotalClaims());
+        EXPECT_EQ(batched.GetTotalDistributed(), sequential.GetTotalDistributed());
+        for (size_t i = 0; i < claims.size(); ++i) {
+            EXPECT_EQ(batchClaims[i].amount, sequentialClaims[i].amount);
+        }
+    }
+}
+
 TEST_F(UBITest, UBIDistributorSerializeDeserialize) {
     // Add some data
     Amount ubiAmount = 1000 * COIN;
@@ -382,6 +447,55 @@ TEST_F(UBITest, UBIDistributorSerializeDeserialize) {
     EXPECT_TRUE(pool->isFinalized);
 }
 
+TEST_F(UBITest, UBIDistributorKeepsHotWindowOfEpochs) {
+    identity::VerificationKey key;
+    key.circuitId = "ubi_claim";
+    key.system = identity::ProofSystem::Groth16;
+    key.numPublicInputs = 3;
+    identity::ProofVerifier::Instance().RegisterKey("ubi_claim", key);
+    
+    auto secrets = identity::IdentitySecrets::Generate();
+    identity::VectorCommitment tree;
+    tree.Add(secrets.GetCommitment().ToFieldElement());
+    FieldElement root = tree.GetRoot();
+    Hash256 rootHash(root.ToBytes().data(), 32);
+    
+    UBIClaim claim;
+    claim.epoch = 0;
+    claim.nullifier = secrets.DeriveNullifier(0);
+    claim.recipient = CreateTestAddress(0x01);
+    claim.proof = identity::IdentityProof::CreateUBIClaimProof(
+        root, claim.nullifier, 0, secrets.secretKey, secrets.nullifierKey,
+        secrets.trapdoor, *tree.Prove(0)).GetZKProof();
+    
+    distributor_->AddBlockReward(0, 1000 * COIN);
+    distributor_->FinalizeEpoch(0, 100);
+    UBIClaim first = claim;
+    ASSERT_EQ(distributor_->ProcessClaim(first, rootHash, 1), ClaimStatus::Valid);
+    EXPECT_TRUE(distributor_->IsNullifierUsed(0, claim.nullifier));
+    EXPECT_FALSE(distributor_->IsNullifierUsed(0, CreateTestNullifier(0, 0x01)));
+    double rate = distributor_->GetAverageClaimRate();
+    EXPECT_GT(rate, 0.0);
+    
+    // The used nullifier survives a round trip
+    std::vector<Byte> serialized = distributor_->Serialize();
+    UBIDistributor restored(*calculator_);
+    ASSERT_TRUE(restored.Deserialize(serialized.data(), serialized.size()));
+    UBIClaim again = claim;
+    EXPECT_EQ(restored.ProcessClaim(again, rootHash, 2), ClaimStatus::DoubleClaim);
+    
+    // Once epoch 0 leaves the hot window its pool and nullifiers are gone,
+    // and only the counters remember it
+    for (EpochId e = 1; e <= UBI_HOT_EPOCHS + 1; ++e) {
+        distributor_->AddBlockReward(static_cast<int>(e) * EPOCH_BLOCKS, COIN);
+    }
+    EXPECT_EQ(distributor_->GetPool(0), nullptr);
+    EXPECT_EQ(distributor_->GetPoolCount(), UBI_HOT_EPOCHS + 1);
+    EXPECT_FALSE(distributor_->IsNullifierUsed(0, claim.nullifier));
+    EXPECT_DOUBLE_EQ(distributor_->GetAverageClaimRate(), rate);
+    EXPECT_EQ(distributor_->GetTotalClaims(), 1u);
+}
+
 // ============================================================================
 // UBITransactionBuilder Tests
 // ============================================================================
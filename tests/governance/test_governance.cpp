@@ -4,11 +4,14 @@
 
 #include <gtest/gtest.h>
 #include <shurium/governance/governance.h>
+#include <shurium/governance/snapshot.h>
 #include <shurium/crypto/keys.h>
 #include <shurium/crypto/sha256.h>
 
+#include <filesystem>
 #include <memory>
 #include <vector>
+#include <unistd.h>
 #include <map>
 
 using namespace shurium;
@@ -839,6 +842,56 @@ TEST_F(GovernanceTest, DelegationRegistryExpireDelegations) {
 }
 
 
+TEST_F(GovernanceTest, DelegationRegistryEffectivePowerFollowsChanges) {
+    DelegationRegistry registry;
+    VotingPowerTracker tracker;
+    VoterId delegate = CreateTestVoterId(0);
+    tracker.UpdateVotingPower(delegate, 50);
+    
+    // Unscoped, valid from height 100 until 200
+    Delegation timed;
+    timed.delegator = CreateTestVoterId(1);
+    timed.delegate = delegate;
+    timed.creationHeight = 100;
+    timed.expirationHeight = 200;
+    ASSERT_TRUE(registry.AddDelegation(timed));
+    registry.UpdateDelegatorPower(timed.delegator, 1000);
+    
+    // Scoped to parameter proposals
+    Delegation scoped;
+    scoped.delegator = CreateTestVoterId(2);
+    scoped.delegate = delegate;
+    scoped.scope = ProposalType::Parameter;
+    ASSERT_TRUE(registry.AddDelegation(scoped));
+    registry.UpdateDelegatorPower(scoped.delegator, 300);
+    
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Parameter, 0), 350);
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Signal, 0), 50);
+    
+    registry.ExpireDelegations(100);
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Parameter, 100), 1350);
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Signal, 100), 1050);
+    // Heights other than the registry's are answered by walking delegators
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Signal, 99), 50);
+    
+    registry.UpdateDelegatorPower(timed.delegator, 400);
+    registry.UpdateDelegatorPower(CreateTestVoterId(3), 999);  // Not delegating
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Signal, 100), 450);
+    
+    // Redelegating moves the delegator's power to the new delegate
+    Delegation moved = scoped;
+    moved.delegate = CreateTestVoterId(4);
+    ASSERT_TRUE(registry.AddDelegation(moved));
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Parameter, 100), 450);
+    EXPECT_EQ(registry.GetEffectiveVotingPower(moved.delegate, tracker, ProposalType::Parameter, 100), 300);
+    
+    registry.ExpireDelegations(200);
+    EXPECT_EQ(registry.GetEffectiveVotingPower(delegate, tracker, ProposalType::Signal, 200), 50);
+    
+    EXPECT_TRUE(registry.RemoveDelegation(moved.delegator));
+    EXPECT_EQ(registry.GetEffectiveVotingPower(moved.delegate, tracker, ProposalType::Parameter, 200), 0);
+}
+
 // ============================================================================
 // ParameterRegistry Tests
 // ============================================================================
@@ -861,6 +914,28 @@ TEST_F(GovernanceTest, ParameterRegistrySetParameter) {
     EXPECT_FALSE(registry.SetParameter(GovernableParameter::TransactionFeeMultiplier, int64_t(1)));
 }
 
+TEST_F(GovernanceTest, ParameterRegistryCachedParameterFollowsEpoch) {
+    ParameterRegistry registry;
+    CachedParameter fee(registry, GovernableParameter::TransactionFeeMultiplier);
+    EXPECT_EQ(fee.Get(), 100);
+    
+    uint64_t epoch = registry.GetEpoch();
+    EXPECT_FALSE(registry.SetParameter(GovernableParameter::TransactionFeeMultiplier, int64_t(1)));
+    EXPECT_EQ(registry.GetEpoch(), epoch);
+    
+    EXPECT_TRUE(registry.SetParameter(GovernableParameter::TransactionFeeMultiplier, int64_t(150)));
+    EXPECT_GT(registry.GetEpoch(), epoch);
+    EXPECT_EQ(fee.Get(), 150);
+    
+    // Restored values are published too
+    ParameterRegistry restored;
+    CachedParameter restoredFee(restored, GovernableParameter::TransactionFeeMultiplier);
+    EXPECT_EQ(restoredFee.Get(), 100);
+    auto data = registry.Serialize();
+    ASSERT_TRUE(restored.Deserialize(data.data(), data.size()));
+    EXPECT_EQ(restoredFee.Get(), 150);
+}
+
 TEST_F(GovernanceTest, ParameterRegistryApplyChanges) {
     ParameterRegistry registry;
     
@@ -1241,3 +1316,98 @@ TEST_F(GovernanceTest, GovernanceEngineSerialization) {
     EXPECT_TRUE(engine2.Deserialize(serialized.data(), serialized.size()));
 }
 
+
+TEST_F(GovernanceTest, GovernanceEngineProcessBlockFollowsTransitions) {
+    GovernanceProposal approved = CreateTestProposal(ProposalType::Signal, "Approved");
+    auto approvedId = engine_->SubmitProposal(approved, SignProposal(approved));
+    GovernanceProposal ignored = CreateTestProposal(ProposalType::Signal, "Ignored");
+    auto ignoredId = engine_->SubmitProposal(ignored, SignProposal(ignored));
+    ASSERT_TRUE(approvedId.has_value());
+    ASSERT_TRUE(ignoredId.has_value());
+    EXPECT_EQ(engine_->GetActiveProposalCount(), 2);
+    
+    engine_->ProcessBlock(1);
+    for (uint8_t i = 0; i < 10; ++i) {
+        Vote vote = CreateTestVote(*approvedId, CreateTestVoterId(i), VoteChoice::Yes,
+                                   1000 + i * 100, i);
+        vote.voteHeight = engine_->GetCurrentHeight();
+        ASSERT_TRUE(engine_->CastVote(vote));
+    }
+    EXPECT_EQ(engine_->GetProposal(*approvedId)->votesYes, 14500u);
+    
+    // Indexes are rebuilt when state is restored mid-vote
+    auto serialized = engine_->Serialize();
+    GovernanceEngine restored;
+    ASSERT_TRUE(restored.Deserialize(serialized.data(), serialized.size()));
+    EXPECT_EQ(restored.GetActiveProposalCount(), 2);
+    
+    // Skip straight past the end of voting
+    int votingEnd = engine_->GetProposal(*approvedId)->votingEndHeight;
+    for (GovernanceEngine* engine : {engine_.get(), &restored}) {
+        engine->ProcessBlock(votingEnd - 1);
+        EXPECT_EQ(engine->GetActiveProposalCount(), 2);
+        engine->ProcessBlock(votingEnd + 5);
+        EXPECT_EQ(engine->GetActiveProposalCount(), 0);
+        
+        auto approvedResult = engine->GetProposal(*approvedId);
+        EXPECT_TRUE(approvedResult->status == GovernanceStatus::Approved ||
+                    approvedResult->status == GovernanceStatus::Executed);
+        EXPECT_EQ(engine->GetProposal(*ignoredId)->status, GovernanceStatus::QuorumFailed);
+        
+        engine->ProcessBlock(approvedResult->executionHeight);
+        EXPECT_EQ(engine->GetProposal(*approvedId)->status, GovernanceStatus::Executed);
+    }
+}
+
+TEST_F(GovernanceTest, GovernanceEngineEffectivePowerTracksDelegatorPower) {
+    VoterId delegate = CreateTestVoterId(0);
+    
+    Delegation delegation;
+    delegation.delegator = CreateTestVoterId(1);
+    delegation.delegate = delegate;
+    auto sig = GetVoterPrivateKey(1).Sign(delegation.GetHash());
+    ASSERT_TRUE(engine_->Delegate(delegation, sig));
+    EXPECT_EQ(engine_->GetEffectiveVotingPower(delegate, ProposalType::Signal), 1000 + 1100);
+    
+    engine_->UpdateVotingPower(delegation.delegator, 5000);
+    EXPECT_EQ(engine_->GetEffectiveVotingPower(delegate, ProposalType::Signal), 1000 + 5000);
+    
+    auto serialized = engine_->Serialize();
+    GovernanceEngine restored;
+    ASSERT_TRUE(restored.Deserialize(serialized.data(), serialized.size()));
+    EXPECT_EQ(restored.GetEffectiveVotingPower(delegate, ProposalType::Signal), 1000 + 5000);
+}
+
+TEST_F(GovernanceTest, GovernanceSnapshotFileRestoresEngine) {
+    GovernanceProposal proposal = CreateTestProposal(ProposalType::Signal, "Snapshot");
+    auto proposalId = engine_->SubmitProposal(proposal, SignProposal(proposal));
+    ASSERT_TRUE(proposalId.has_value());
+    engine_->ProcessBlock(1);
+    
+    auto path = std::filesystem::temp_directory_path() /
+                ("shurium_governance_snapshot_" + std::to_string(::getpid()) + ".dat");
+    {
+        GovernanceSnapshotWriter writer(path);
+        writer.Submit(GovernanceSnapshot::Capture(engine_->GetCurrentHeight(), *engine_));
+        writer.Stop();
+        EXPECT_EQ(writer.GetLastWrittenHeight(), 1);
+    }
+    
+    GovernanceSnapshot snapshot;
+    auto read = ReadGovernanceSnapshot(path, snapshot);
+    std::filesystem::remove(path);
+    ASSERT_TRUE(read.success) << read.error;
+    EXPECT_EQ(snapshot.height, 1);
+    
+    GovernanceEngine restored;
+    ASSERT_TRUE(snapshot.Restore(restored));
+    EXPECT_EQ(restored.GetCurrentHeight(), 1);
+    EXPECT_EQ(restored.GetActiveProposalCount(), 1);
+    
+    // Voter keys come back too, so votes still verify
+    Vote vote = CreateTestVote(*proposalId, CreateTestVoterId(3), VoteChoice::Yes, 1300, 3);
+    vote.voteHeight = 1;
+    EXPECT_TRUE(restored.CastVote(vote));
+    
+    EXPECT_FALSE(ReadGovernanceSnapshot(path, snapshot).success);
+}
@@ -6,11 +6,15 @@
 
 #include <shurium/identity/identity.h>
 #include <shurium/identity/commitment.h>
+#include <shurium/identity/merkletree.h>
 #include <shurium/identity/nullifier.h>
 #include <shurium/identity/zkproof.h>
+#include <shurium/db/leveldb.h>
+#include <shurium/util/threadpool.h>
 
 #include <algorithm>
 #include <set>
+#include <stdexcept>
 
 using namespace shurium;
 using namespace shurium::identity;
@@ -174,6 +178,67 @@ TEST_F(VectorCommitmentTest, AddMultipleElements) {
     EXPECT_EQ(tree.Size(), elements_.size());
 }
 
+TEST_F(VectorCommitmentTest, IncrementalAddMatchesConstruction) {
+    std::vector<FieldElement> elements;
+    VectorCommitment tree;
+    for (int n = 1; n <= 11; ++n) {
+        elements.push_back(GenerateRandomFieldElement());
+        tree.Add(elements.back());
+        
+        VectorCommitment built(elements);
+        EXPECT_EQ(tree.GetRoot(), built.GetRoot()) << n;
+        EXPECT_EQ(tree.Depth(), built.Depth()) << n;
+        for (int i = 0; i < n; ++i) {
+            auto proof = tree.Prove(i);
+            ASSERT_TRUE(proof.has_value());
+            EXPECT_TRUE(VectorCommitment::VerifyProof(built.GetRoot(), elements[i], *proof));
+        }
+    }
+}
+
+TEST_F(VectorCommitmentTest, AddBatchMatchesAdd) {
+    VectorCommitment oneByOne;
+    for (const auto& e : elements_) {
+        oneByOne.Add(e);
+    }
+    
+    VectorCommitment batched;
+    batched.Add(elements_[0]);
+    batched.AddBatch(std::vector<FieldElement>(elements_.begin() + 1, elements_.begin() + 3));
+    batched.AddBatch(std::vector<FieldElement>(elements_.begin() + 3, elements_.end()));
+    
+    EXPECT_EQ(batched.GetRoot(), oneByOne.GetRoot());
+    EXPECT_EQ(batched.Size(), oneByOne.Size());
+    EXPECT_EQ(batched.Depth(), oneByOne.Depth());
+    
+    // Adding after a batch keeps updating the same tree
+    FieldElement extra = GenerateRandomFieldElement();
+    oneByOne.Add(extra);
+    batched.Add(extra);
+    EXPECT_EQ(batched.GetRoot(), oneByOne.GetRoot());
+}
+
+TEST_F(VectorCommitmentTest, ParallelBuildMatchesSerial) {
+    // Large enough that the leaf level is split across pool tasks
+    std::vector<FieldElement> elements;
+    for (int i = 0; i < 1500; ++i) {
+        elements.push_back(FieldElement(static_cast<uint64_t>(i * 31 + 7)));
+    }
+    util::ThreadPool pool(4);
+    
+    VectorCommitment serial(elements);
+    VectorCommitment parallel(elements, &pool);
+    EXPECT_EQ(parallel.GetRoot(), serial.GetRoot());
+    
+    VectorCommitment batched;
+    batched.AddBatch(elements, &pool);
+    EXPECT_EQ(batched.GetRoot(), serial.GetRoot());
+    
+    auto proof = parallel.Prove(1234);
+    ASSERT_TRUE(proof.has_value());
+    EXPECT_TRUE(serial.Verify(elements[1234], *proof));
+}
+
 TEST_F(VectorCommitmentTest, MembershipProof) {
     VectorCommitment tree(elements_);
     
@@ -209,6 +274,121 @@ TEST_F(VectorCommitmentTest, ProofSerialization) {
     EXPECT_EQ(proof->siblings.size(), parsed->siblings.size());
 }
 
+// ============================================================================
+// Incremental Merkle Tree Tests
+// ============================================================================
+
+/// Forwards to a MemoryDatabase that outlives its user, standing in for a
+/// database reopened from disk
+class SharedMemoryDatabase : public db::Database {
+public:
+    explicit SharedMemoryDatabase(db::MemoryDatabase& backing) : backing_(backing) {}
+    
+    db::Status Get(const db::ReadOptions& options, const db::Slice& key,
+                   std::string* value) override {
+        return backing_.Get(options, key, value);
+    }
+    db::Status Put(const db::WriteOptions& options, const db::Slice& key,
+                   const db::Slice& value) override {
+        return backing_.Put(options, key, value);
+    }
+    db::Status Delete(const db::WriteOptions& options, const db::Slice& key) override {
+        return backing_.Delete(options, key);
+    }
+    db::Status Write(const db::WriteOptions& options, db::WriteBatch* batch) override {
+        return backing_.Write(options, batch);
+    }
+    std::unique_ptr<db::Iterator> NewIterator(const db::ReadOptions& options) override {
+        return backing_.NewIterator(options);
+    }
+    
+private:
+    db::MemoryDatabase& backing_;
+};
+
+TEST(IncrementalMerkleTreeTest, MatchesFullTreeOfSameDepth) {
+    const uint32_t depth = 5;
+    IncrementalMerkleTree tree(depth);
+    EXPECT_EQ(tree.GetRoot(), tree.EmptyRoot());
+    
+    std::vector<FieldElement> leaves;
+    for (uint64_t i = 0; i < 13; ++i) {
+        leaves.push_back(GenerateRandomFieldElement());
+        EXPECT_EQ(tree.Append(leaves.back()), i);
+        
+        // A full tree over the leaves padded to 2^depth has the same root
+        std::vector<FieldElement> padded = leaves;
+        padded.resize(uint64_t{1} << depth, FieldElement::Zero());
+        EXPECT_EQ(tree.GetRoot(), VectorCommitment(padded).GetRoot());
+    }
+    
+    for (uint64_t i = 0; i < leaves.size(); ++i) {
+        auto proof = tree.Prove(i);
+        ASSERT_TRUE(proof.has_value());
+        EXPECT_EQ(proof->siblings.size(), depth);
+        EXPECT_TRUE(tree.Verify(leaves[i], *proof));
+        EXPECT_FALSE(tree.Verify(leaves[(i + 1) % leaves.size()], *proof));
+    }
+    EXPECT_FALSE(tree.Prove(leaves.size()).has_value());
+}
+
+TEST(IncrementalMerkleTreeTest, FullTreeRejectsAppend) {
+    IncrementalMerkleTree tree(2);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(tree.Append(FieldElement(static_cast<uint64_t>(i + 1))).has_value());
+    }
+    FieldElement root = tree.GetRoot();
+    EXPECT_FALSE(tree.Append(FieldElement(uint64_t{5})).has_value());
+    EXPECT_EQ(tree.GetRoot(), root);
+    EXPECT_EQ(tree.Size(), 4u);
+    EXPECT_THROW(IncrementalMerkleTree(0), std::invalid_argument);
+}
+
+TEST(IncrementalMerkleTreeTest, RootHistoryIsBounded) {
+    IncrementalMerkleTree tree(IDENTITY_TREE_DEPTH, 4);
+    std::vector<FieldElement> roots{tree.GetRoot()};
+    for (int i = 0; i < 6; ++i) {
+        tree.Append(GenerateRandomFieldElement());
+        roots.push_back(tree.GetRoot());
+    }
+    // The current root and the three before it
+    for (size_t i = 0; i < roots.size(); ++i) {
+        EXPECT_EQ(tree.IsKnownRoot(roots[i]), i + 4 >= roots.size()) << i;
+    }
+}
+
+TEST(IncrementalMerkleTreeTest, ResumesFromDatabase) {
+    db::MemoryDatabase backing;
+    std::vector<FieldElement> leaves;
+    std::vector<FieldElement> roots;
+    {
+        IncrementalMerkleTree tree(std::make_unique<SharedMemoryDatabase>(backing), 8, 16);
+        for (int i = 0; i < 11; ++i) {
+            leaves.push_back(GenerateRandomFieldElement());
+            tree.Append(leaves.back());
+            roots.push_back(tree.GetRoot());
+        }
+    }
+    
+    IncrementalMerkleTree reopened(std::make_unique<SharedMemoryDatabase>(backing), 8, 16);
+    EXPECT_EQ(reopened.Size(), leaves.size());
+    EXPECT_EQ(reopened.GetRoot(), roots.back());
+    EXPECT_TRUE(reopened.IsKnownRoot(roots.front()));
+    
+    // Appending carries on from the stored frontier
+    IncrementalMerkleTree fresh(8, 16);
+    for (const auto& leaf : leaves) {
+        fresh.Append(leaf);
+    }
+    FieldElement next = GenerateRandomFieldElement();
+    EXPECT_EQ(reopened.Append(next), leaves.size());
+    fresh.Append(next);
+    EXPECT_EQ(reopened.GetRoot(), fresh.GetRoot());
+    auto proof = reopened.Prove(3);
+    ASSERT_TRUE(proof.has_value());
+    EXPECT_TRUE(reopened.Verify(leaves[3], *proof));
+}
+
 // ============================================================================
 // Nullifier Tests
 // ============================================================================
@@ -385,6 +565,73 @@ TEST_F(NullifierSetTest, Serialization) {
     EXPECT_EQ(deserialized->GetCurrentEpoch(), 100);
 }
 
+TEST_F(NullifierSetTest, PersistsAcrossReopen) {
+    db::MemoryDatabase backing;
+    NullifierSet::Config config;
+    std::vector<Nullifier> staged;
+    {
+        NullifierSet set(config, std::make_unique<SharedMemoryDatabase>(backing));
+        set.SetCurrentEpoch(100);
+        for (EpochId e = 98; e <= 100; ++e) {
+            EXPECT_EQ(set.Add(Nullifier::Derive(GenerateRandomFieldElement(), e)),
+                      NullifierSet::AddResult::Success);
+        }
+        
+        // A batch reaches the database in a single write
+        for (int i = 0; i < 3; ++i) {
+            staged.push_back(Nullifier::Derive(GenerateRandomFieldElement(), 100));
+        }
+        ASSERT_TRUE(set.AddBatch(staged));
+        EXPECT_EQ(set.CountForEpoch(100), 4u);
+        EXPECT_EQ(backing.Size(), 7u);  // Current epoch and six nullifiers
+    }
+    
+    NullifierSet reopened(config, std::make_unique<SharedMemoryDatabase>(backing));
+    EXPECT_EQ(reopened.GetCurrentEpoch(), 100u);
+    EXPECT_EQ(reopened.TotalCount(), 6u);
+    EXPECT_EQ(reopened.GetEpochs(), (std::vector<EpochId>{98, 99, 100}));
+    for (const auto& nullifier : staged) {
+        EXPECT_TRUE(reopened.Contains(nullifier));
+        EXPECT_EQ(reopened.Add(nullifier), NullifierSet::AddResult::AlreadyExists);
+    }
+    
+    // Pruning removes the old epochs' keys from the database
+    EXPECT_EQ(reopened.PruneOlderThan(100), 2u);
+    EXPECT_EQ(backing.Size(), 5u);
+    reopened.Clear();
+    EXPECT_EQ(reopened.TotalCount(), 0u);
+    EXPECT_EQ(backing.Size(), 1u);
+}
+
+TEST_F(NullifierSetTest, FilterGrowsWithEpoch) {
+    // Enough nullifiers to outgrow the smallest filter twice over
+    std::vector<Nullifier> nullifiers;
+    for (uint64_t i = 0; i < 5 * NULLIFIER_FILTER_MIN_KEYS; ++i) {
+        nullifiers.push_back(Nullifier(FieldElement(i + 1), 100));
+    }
+    for (size_t i = 0; i < nullifiers.size(); i += 7) {
+        EXPECT_EQ(set_->Add(nullifiers[i]), NullifierSet::AddResult::Success);
+    }
+    std::vector<Nullifier> rest;
+    for (size_t i = 0; i < nullifiers.size(); ++i) {
+        if (i % 7 != 0) {
+            rest.push_back(nullifiers[i]);
+        }
+    }
+    ASSERT_TRUE(set_->AddBatch(rest));
+    
+    EXPECT_EQ(set_->CountForEpoch(100), nullifiers.size());
+    for (const auto& nullifier : nullifiers) {
+        EXPECT_TRUE(set_->Contains(nullifier));
+    }
+    EXPECT_FALSE(set_->Contains(Nullifier(FieldElement(nullifiers.size() + 1), 100)));
+    EXPECT_FALSE(set_->Contains(Nullifier(FieldElement(1), 99)));
+    
+    EXPECT_TRUE(set_->Remove(nullifiers[0]));
+    EXPECT_FALSE(set_->Contains(nullifiers[0]));
+    EXPECT_FALSE(set_->Remove(nullifiers[0]));
+}
+
 // ============================================================================
 // Epoch Utility Tests
 // ============================================================================
@@ -723,6 +970,16 @@ TEST_F(IdentityManagerTest, ProcessUBIClaim) {
     claim.proof = identityProof;
     claim.timestamp = 1000000;
     
+    // A registration after the proof was made moves the root; the claim's
+    // root is still a recent one
+    FieldElement provenRoot = manager_->GetIdentityRoot();
+    RegistrationRequest later;
+    later.commitment = IdentitySecrets::Generate().GetCommitment();
+    later.timestamp = 1000000;
+    ASSERT_TRUE(manager_->RegisterIdentity(later).has_value());
+    EXPECT_NE(manager_->GetIdentityRoot(), provenRoot);
+    EXPECT_TRUE(manager_->IsKnownIdentityRoot(provenRoot));
+    
     // Process claim
     EXPECT_TRUE(manager_->ProcessUBIClaim(claim));
     
@@ -747,6 +1004,59 @@ TEST_F(IdentityManagerTest, Stats) {
     EXPECT_EQ(stats.pendingIdentities, 0);
 }
 
+TEST(IdentityManagerRecordTest, RecordsReadBackThroughCache) {
+    db::MemoryDatabase backing;
+    IdentityManager::Config config;
+    config.activationDelay = 10;
+    config.recordCacheSize = 2;
+    IdentityManager manager(config, std::make_unique<SharedMemoryDatabase>(backing));
+    manager.SetBlockContext(1000, 1000000);
+    
+    std::vector<IdentityRecord> registered;
+    for (int i = 0; i < 5; ++i) {
+        RegistrationRequest request;
+        request.commitment = IdentitySecrets::Generate().GetCommitment();
+        request.timestamp = 1000000;
+        auto record = manager.RegisterIdentity(request);
+        ASSERT_TRUE(record.has_value());
+        registered.push_back(*record);
+    }
+    size_t stored = 0;
+    auto it = backing.NewIterator(db::ReadOptions());
+    for (it->Seek(std::string(1, db::prefix::IDENTITY_RECORD));
+         it->Valid() && it->key()[0] == db::prefix::IDENTITY_RECORD; it->Next()) {
+        ++stored;
+    }
+    EXPECT_EQ(stored, 5u);
+    
+    // Registration fields come from the database, status from memory
+    manager.SetBlockContext(1010, 1000000);
+    ASSERT_TRUE(manager.UpdateIdentityStatus(registered[3].id, IdentityStatus::Suspended));
+    for (const auto& expected : registered) {
+        auto byIndex = manager.GetIdentityByIndex(expected.treeIndex);
+        ASSERT_TRUE(byIndex.has_value());
+        EXPECT_EQ(byIndex->id, expected.id);
+        EXPECT_EQ(byIndex->commitment, expected.commitment);
+        EXPECT_EQ(byIndex->registrationTime, expected.registrationTime);
+        EXPECT_EQ(byIndex->status, expected.id == registered[3].id
+                                   ? IdentityStatus::Suspended : IdentityStatus::Active);
+        EXPECT_EQ(byIndex->lastUpdateHeight, 1010u);
+    }
+    EXPECT_FALSE(manager.GetIdentityByIndex(registered.back().treeIndex + 1).has_value());
+    
+    // The last two are cached; the first is read from the database again
+    auto before = manager.GetStats();
+    EXPECT_TRUE(manager.GetIdentityById(registered[4].id).has_value());
+    EXPECT_TRUE(manager.GetIdentity(registered[0].commitment).has_value());
+    auto after = manager.GetStats();
+    EXPECT_EQ(after.recordCacheHits, before.recordCacheHits + 1);
+    EXPECT_EQ(after.recordCacheMisses, before.recordCacheMisses + 1);
+    EXPECT_GT(after.memoryUsage, 5 * sizeof(CommitmentHash));
+    
+    EXPECT_EQ(manager.GetIdentitiesByStatus(IdentityStatus::Active).size(), 4u);
+    EXPECT_EQ(manager.GetStats().activeIdentities, 4u);
+}
+
 // ============================================================================
 // Identity Secrets Tests
 // ============================================================================
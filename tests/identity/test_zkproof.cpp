@@ -8,8 +8,15 @@
 #include <shurium/identity/rangeproof.h>
 #include <shurium/identity/commitment.h>
 #include <shurium/identity/nullifier.h>
+#include <shurium/identity/msm.h>
+#include <shurium/identity/proofcache.h>
 #include <shurium/crypto/poseidon.h>
 #include <shurium/core/random.h>
+#include <shurium/util/threadpool.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
 namespace shurium {
 namespace identity {
@@ -292,6 +299,28 @@ TEST(SchnorrProofTest, Serialization) {
     EXPECT_EQ(restored->response, proof.response);
 }
 
+TEST(SchnorrProofTest, BatchVerify) {
+    std::vector<SchnorrStatement> statements;
+    for (int i = 0; i < 8; ++i) {
+        FieldElement secretKey = RandomFieldElement();
+        // One proof over a different generator
+        FieldElement generator = (i == 5) ? GetGeneratorH() : GetGeneratorG();
+        FieldElement publicKey = secretKey * generator;
+        std::vector<Byte> context = {static_cast<Byte>(i)};
+        statements.push_back({SchnorrProver::Prove(secretKey, generator, publicKey, context),
+                              generator, publicKey, context});
+    }
+    std::vector<size_t> invalid;
+    EXPECT_TRUE(SchnorrVerifier::BatchVerify(statements, &invalid));
+    EXPECT_TRUE(SchnorrVerifier::BatchVerify({}));
+    
+    // A wrong public key and a wrong context are both pinpointed
+    statements[2].publicKey = RandomFieldElement();
+    statements[6].context = {0xff};
+    EXPECT_FALSE(SchnorrVerifier::BatchVerify(statements, &invalid));
+    EXPECT_EQ(invalid, (std::vector<size_t>{2, 6}));
+}
+
 // ============================================================================
 // Pedersen Opening Proof Tests
 // ============================================================================
@@ -516,6 +545,90 @@ TEST(RangeProofTest, VerifyFailsWithWrongCommitment) {
     EXPECT_FALSE(RangeProofVerifier::Verify(*proof, wrongCommitment));
 }
 
+TEST(RangeProofTest, BatchVerify) {
+    std::vector<RangeProof> proofs;
+    std::vector<FieldElement> commitments;
+    for (uint64_t i = 0; i < 9; ++i) {
+        // Mixed bit counts share one aggregation
+        size_t numBits = (i % 3 == 0) ? 64 : (i % 3 == 1) ? 16 : 8;
+        FieldElement randomness = GenerateBlinding();
+        auto proof = RangeProofProver::Prove(i * 25, randomness, numBits);
+        ASSERT_TRUE(proof.has_value());
+        proofs.push_back(*proof);
+        commitments.push_back(PedersenCommit(i * 25, randomness));
+        EXPECT_TRUE(RangeProofVerifier::Verify(proofs.back(), commitments.back()));
+    }
+    std::vector<size_t> invalid;
+    EXPECT_TRUE(RangeProofVerifier::BatchVerify(proofs, commitments, &invalid));
+    EXPECT_TRUE(invalid.empty());
+    EXPECT_TRUE(RangeProofVerifier::BatchVerify({}, {}));
+    EXPECT_FALSE(RangeProofVerifier::BatchVerify(proofs, {}));
+
+    // A wrong commitment, a tampered inner product scalar and a malformed
+    // proof are each pinpointed
+    commitments[1] = PedersenCommit(1000, GenerateBlinding());
+    proofs[4].a = proofs[4].a + FieldElement::One();
+    proofs[7].L.pop_back();
+    EXPECT_FALSE(RangeProofVerifier::BatchVerify(proofs, commitments, &invalid));
+    EXPECT_EQ(invalid, (std::vector<size_t>{1, 4, 7}));
+    EXPECT_FALSE(RangeProofVerifier::Verify(proofs[4], commitments[4]));
+}
+
+TEST(RangeProofTest, GeneratorsSharedAcrossThreads) {
+    std::vector<const RangeProofGenerators*> seen(8);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        threads.emplace_back([&seen, t] { seen[t] = &RangeProofGenerators::Get(t * 8); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    const auto& full = RangeProofGenerators::Get(MAX_RANGE_BITS);
+    for (size_t t = 0; t < seen.size(); ++t) {
+        EXPECT_EQ(seen[t], &RangeProofGenerators::Get(t * 8));
+        ASSERT_EQ(seen[t]->Gi().size(), t * 8);
+        EXPECT_TRUE(std::equal(seen[t]->Gi().begin(), seen[t]->Gi().end(), full.Gi().begin()));
+        EXPECT_TRUE(std::equal(seen[t]->Hi().begin(), seen[t]->Hi().end(), full.Hi().begin()));
+        EXPECT_EQ(seen[t]->G(), full.G());
+    }
+    EXPECT_THROW(RangeProofGenerators::Get(MAX_RANGE_BITS + 1), std::out_of_range);
+    EXPECT_FALSE(RangeProofProver::Prove(1, GenerateBlinding(), FieldElement(1), MAX_RANGE_BITS + 1));
+}
+
+TEST(MultiScalarMulTest, MatchesTermByTermSum) {
+    // Lengths around the four-product reduction groups, and p - 1 terms,
+    // the largest the lazy reduction has to absorb
+    const FieldElement pMinusOne = FieldElement::Zero() - FieldElement::One();
+    for (size_t n : {0, 1, 3, 4, 5, 8, 63, 64, 65}) {
+        std::vector<FieldElement> scalars, points;
+        FieldElement expected;
+        for (size_t i = 0; i < n; ++i) {
+            scalars.push_back(i % 2 ? pMinusOne : GenerateBlinding());
+            points.push_back(i % 3 ? pMinusOne : GenerateBlinding());
+            expected += scalars[i] * points[i];
+        }
+        EXPECT_EQ(MultiScalarMul(scalars, points), expected) << n;
+        EXPECT_EQ(MultiScalarMul(scalars.data(), points.data(), n), expected) << n;
+    }
+    
+    FieldElement a = GenerateBlinding(), b = GenerateBlinding();
+    const auto& gens = RangeProofGenerators::Get();
+    EXPECT_EQ(MultiScalarMul(a, gens.G(), b, gens.H()), a * gens.G() + b * gens.H());
+    
+    // Split across a pool
+    size_t n = 3 * MSM_MIN_TERMS_PER_TASK + 7;
+    std::vector<FieldElement> scalars(n), points(n);
+    FieldElement expected;
+    for (size_t i = 0; i < n; ++i) {
+        scalars[i] = FieldElement(i + 1);
+        points[i] = i % 2 ? pMinusOne : FieldElement(i);
+        expected += scalars[i] * points[i];
+    }
+    util::ThreadPool pool(4);
+    EXPECT_EQ(MultiScalarMul(scalars, points, &pool), expected);
+}
+
 // ============================================================================
 // Simple Range Proof Tests
 // ============================================================================
@@ -739,6 +852,140 @@ TEST(ProofVerifierTest, VerifyPlaceholderProof) {
     EXPECT_FALSE(verifier.Verify(proof, "placeholder_circuit"));
 }
 
+TEST(ProofVerifierTest, CachesVerifiedProofs) {
+    ProofVerifier verifier;
+    ProofCache cache(64 * 1024);
+    verifier.SetCache(&cache);
+    
+    VerificationKey key;
+    key.circuitId = "ubi_claim";
+    key.system = ProofSystem::Groth16;
+    key.numPublicInputs = 3;
+    verifier.RegisterKey("ubi_claim", key);
+    
+    FieldElement secretKey = RandomFieldElement();
+    FieldElement nullifierKey = RandomFieldElement();
+    FieldElement trapdoor = RandomFieldElement();
+    auto identity = IdentityCommitment::Create(secretKey, nullifierKey, trapdoor);
+    VectorCommitment tree({identity.ToFieldElement(), RandomFieldElement()});
+    auto proof = ProofGenerator::Instance().GenerateUBIClaimProof(
+        secretKey, nullifierKey, trapdoor, tree.GetRoot(), *tree.Prove(0), 7);
+    ASSERT_TRUE(proof.has_value());
+    
+    // Relay verifies and stores; the block finds it
+    EXPECT_TRUE(verifier.Verify(proof->GetZKProof(), "ubi_claim"));
+    EXPECT_TRUE(verifier.Verify(proof->GetZKProof(), "ubi_claim"));
+    ProofCache::Stats stats = cache.GetStats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.inserts, 1u);
+    EXPECT_DOUBLE_EQ(stats.HitRate(), 0.5);
+    
+    // Other public inputs miss, and a failed proof is not stored
+    ZKProof altered = proof->GetZKProof();
+    PublicInputs inputs = altered.GetPublicInputs();
+    inputs.values[2] = FieldElement(uint64_t(8));
+    altered.SetPublicInputs(inputs);
+    EXPECT_FALSE(verifier.Verify(altered, "ubi_claim"));
+    EXPECT_FALSE(verifier.Verify(altered, "ubi_claim"));
+    EXPECT_EQ(cache.GetStats().inserts, 1u);
+    
+    // A key re-registered under the same id does not reuse old entries
+    key.keyData = {0x01};
+    verifier.RegisterKey("ubi_claim", key);
+    EXPECT_TRUE(verifier.Verify(proof->GetZKProof(), "ubi_claim"));
+    EXPECT_EQ(cache.GetStats().inserts, 2u);
+    
+    // Identity proofs are cached per root
+    EXPECT_TRUE(verifier.VerifyIdentityProof(*proof, tree.GetRoot()));
+    EXPECT_TRUE(verifier.VerifyIdentityProof(*proof, tree.GetRoot()));
+    EXPECT_FALSE(verifier.VerifyIdentityProof(*proof, RandomFieldElement()));
+    EXPECT_EQ(cache.GetStats().inserts, 3u);
+    
+    verifier.SetCache(nullptr);
+    uint64_t lookups = cache.GetStats().hits + cache.GetStats().misses;
+    EXPECT_TRUE(verifier.Verify(proof->GetZKProof(), "ubi_claim"));
+    EXPECT_EQ(cache.GetStats().hits + cache.GetStats().misses, lookups);
+}
+
+TEST(ProofVerifierTest, VerifyBatchMatchesVerify) {
+    ProofVerifier verifier;
+    verifier.SetCache(nullptr);
+    
+    VerificationKey key;
+    key.circuitId = "ubi_claim";
+    key.system = ProofSystem::Groth16;
+    key.numPublicInputs = 3;
+    verifier.RegisterKey("ubi_claim", key);
+    auto prepared = verifier.GetPreparedKey("ubi_claim");
+    ASSERT_NE(prepared, nullptr);
+    EXPECT_EQ(prepared->keyBytes, key.ToBytes());
+    
+    std::vector<ZKProof> proofs;
+    std::vector<FieldElement> leaves;
+    std::vector<std::array<FieldElement, 3>> secrets;
+    for (int i = 0; i < 24; ++i) {
+        secrets.push_back({RandomFieldElement(), RandomFieldElement(), RandomFieldElement()});
+        leaves.push_back(IdentityCommitment::Create(
+            secrets[i][0], secrets[i][1], secrets[i][2]).ToFieldElement());
+    }
+    VectorCommitment tree(leaves);
+    for (size_t i = 0; i < secrets.size(); ++i) {
+        auto proof = ProofGenerator::Instance().GenerateUBIClaimProof(
+            secrets[i][0], secrets[i][1], secrets[i][2], tree.GetRoot(), *tree.Prove(i), 3);
+        ASSERT_TRUE(proof.has_value());
+        ZKProof zk = proof->GetZKProof();
+        if (i % 5 == 0) {
+            PublicInputs inputs = zk.GetPublicInputs();
+            inputs.values[1] = RandomFieldElement();  // Nullifier the proof does not carry
+            zk.SetPublicInputs(inputs);
+        }
+        proofs.push_back(zk);
+    }
+    
+    std::vector<const ZKProof*> batch;
+    std::vector<bool> expected;
+    for (const auto& proof : proofs) {
+        batch.push_back(&proof);
+        expected.push_back(verifier.Verify(proof, "ubi_claim"));
+    }
+    batch.push_back(nullptr);
+    expected.push_back(false);
+    EXPECT_FALSE(expected[0]);
+    EXPECT_TRUE(expected[1]);
+    
+    util::ThreadPool pool(4);
+    EXPECT_EQ(verifier.VerifyBatch(batch, "ubi_claim"), expected);
+    EXPECT_EQ(verifier.VerifyBatch(batch, "ubi_claim", &pool), expected);
+    EXPECT_EQ(verifier.VerifyBatch(batch, "no_such_circuit", &pool),
+              std::vector<bool>(batch.size(), false));
+}
+
+TEST(ProofCacheTest, EntriesDependOnEveryField) {
+    ProofCache cache(4096);
+    std::vector<Byte> proof = {0x01, 0x02};
+    std::vector<Byte> inputs = {0x03};
+    std::vector<Byte> key = {0x04};
+    
+    Hash256 entry = cache.ComputeEntry(proof, inputs, key);
+    cache.Insert(entry);
+    EXPECT_TRUE(cache.Contains(entry));
+    
+    // Moving a byte across a field boundary changes the entry
+    std::vector<Byte> shorterProof = {0x01};
+    std::vector<Byte> longerInputs = {0x02, 0x03};
+    EXPECT_NE(cache.ComputeEntry(shorterProof, longerInputs, key), entry);
+    EXPECT_NE(cache.ComputeEntry(proof, inputs, std::vector<Byte>{0x05}), entry);
+    
+    // Salted per instance
+    ProofCache other(4096);
+    EXPECT_NE(other.ComputeEntry(proof, inputs, key), entry);
+    
+    cache.Clear();
+    EXPECT_FALSE(cache.Contains(entry));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
 // ============================================================================
 // ProofGenerator Tests
 // ============================================================================
@@ -7,6 +7,13 @@
 #include "shurium/marketplace/solution.h"
 #include "shurium/marketplace/verifier.h"
 #include "shurium/marketplace/marketplace.h"
+#include "shurium/crypto/sha256.h"
+
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <vector>
 
 using namespace shurium;
 using namespace shurium::marketplace;
@@ -256,6 +263,87 @@ TEST_F(ProblemPoolTest, TotalRewardsEmpty) {
     EXPECT_EQ(pool_->GetTotalRewards(), 0);
 }
 
+TEST(ProblemQueueTest, OrdersByRewardPerCompute) {
+    auto make = [](Problem::Id id, Amount reward, uint32_t seconds, int64_t deadline) {
+        Problem problem;
+        problem.SetId(id);
+        problem.SetReward(reward);
+        problem.SetDeadline(deadline);
+        ProblemDifficulty difficulty(1000);
+        difficulty.estimatedTime = seconds;
+        problem.SetDifficulty(difficulty);
+        return problem;
+    };
+    
+    ProblemQueue queue;
+    queue.Insert(make(1, 1000, 10, 500));   // 100 per second
+    queue.Insert(make(2, 600, 2, 500));     // 300 per second
+    queue.Insert(make(3, 300, 3, 400));     // 100 per second, earlier deadline
+    queue.Insert(make(4, 50, 1, 0));        // 50 per second, no deadline
+    
+    EXPECT_EQ(queue.Top(10, 0, 100), (std::vector<Problem::Id>{2, 3, 1, 4}));
+    EXPECT_EQ(queue.Top(10, 500, 100), (std::vector<Problem::Id>{2, 1}));
+    EXPECT_EQ(queue.Top(10, 0, 450), (std::vector<Problem::Id>{2, 1, 4}));
+    
+    // Re-ranking on a reward change
+    queue.Insert(make(4, 5000, 1, 0));
+    EXPECT_EQ(queue.Top(1, 0, 100), (std::vector<Problem::Id>{4}));
+    
+    // Deadline index
+    EXPECT_EQ(queue.PopExpired(450), (std::vector<Problem::Id>{3}));
+    EXPECT_EQ(queue.PopExpired(600), (std::vector<Problem::Id>{1, 2}));
+    EXPECT_EQ(queue.Size(), 1u);
+}
+
+TEST(ProblemQueueTest, AssignmentsAvoidDuplicateWork) {
+    ProblemQueue queue;
+    for (Problem::Id id = 1; id <= 3; ++id) {
+        Problem problem;
+        problem.SetId(id);
+        problem.SetReward(id * 100);
+        queue.Insert(problem);
+    }
+    
+    EXPECT_EQ(queue.Assign("alice", 0), 3u);
+    EXPECT_EQ(queue.Assign("alice", 0), 3u);   // Polling again keeps it
+    EXPECT_EQ(queue.Assign("bob", 0), 2u);
+    EXPECT_EQ(queue.Assign("carol", 0), 1u);
+    EXPECT_EQ(queue.Assign("dave", 0), 3u);    // All taken: share the best
+    EXPECT_EQ(queue.GetAssigneeCount(3), 2u);
+    
+    // Still listed for mining while assigned
+    EXPECT_EQ(queue.Top(3, 0, 0), (std::vector<Problem::Id>{3, 2, 1}));
+    
+    queue.Release(2, "bob");
+    EXPECT_EQ(queue.Assign("erin", 0), 2u);
+    
+    queue.Erase(1);
+    EXPECT_EQ(queue.Assign("carol", 0), 3u);
+}
+
+TEST_F(ProblemPoolTest, AssignAndExpire) {
+    int64_t now = std::time(nullptr);
+    ASSERT_TRUE(pool_->AddProblem(CreateValidProblem(1, 1000, now + 3600)));
+    ASSERT_TRUE(pool_->AddProblem(CreateValidProblem(2, 2000, now - 10)));
+    ASSERT_TRUE(pool_->AddProblem(CreateValidProblem(3, 3000, now + 3600)));
+    
+    const Problem* assigned = pool_->AssignProblem("miner");
+    ASSERT_NE(assigned, nullptr);
+    EXPECT_EQ(assigned->GetId(), 3u);
+    
+    // The expired problem is never handed out and leaves on the sweep
+    const Problem* next = pool_->AssignProblem("other");
+    ASSERT_NE(next, nullptr);
+    EXPECT_EQ(next->GetId(), 1u);
+    EXPECT_EQ(pool_->RemoveExpired(), 1u);
+    EXPECT_FALSE(pool_->HasProblem(2));
+    
+    pool_->MarkSolved(3, "miner");
+    EXPECT_TRUE(pool_->UpdateReward(1, 50));
+    EXPECT_EQ(pool_->GetHighestRewardProblem()->GetId(), 1u);
+    EXPECT_EQ(pool_->GetTotalRewards(), 3050);
+}
+
 // ============================================================================
 // Solution Tests
 // ============================================================================
@@ -435,7 +523,7 @@ TEST_F(SolutionCacheTest, AddAndGet) {
     
     EXPECT_EQ(cache_->Size(), 1);
     
-    const Solution* found = cache_->Get(1);
+    auto found = cache_->Get(1);
     ASSERT_NE(found, nullptr);
     EXPECT_EQ(found->GetId(), 1);
     EXPECT_EQ(found->GetProblemId(), 42);
@@ -472,6 +560,59 @@ TEST_F(SolutionCacheTest, GetForProblem) {
     EXPECT_EQ(forProblem99.size(), 1);
 }
 
+TEST_F(SolutionCacheTest, GetByHash) {
+    auto solution = CreateTestSolution(5, 42);
+    solution.GetData().SetResult({0x01, 0x02});
+    solution.ComputeHash();
+    Hash256 hash = solution.GetHash();
+    cache_->Add(std::move(solution));
+    
+    auto found = cache_->GetByHash(hash);
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->GetId(), 5);
+}
+
+TEST_F(SolutionCacheTest, EvictsSettledBeforePending) {
+    SolutionCache cache(4);
+    for (Solution::Id id = 1; id <= 4; ++id) {
+        auto solution = CreateTestSolution(id, 42);
+        if (id == 2) {
+            solution.SetStatus(SolutionStatus::ACCEPTED);
+        }
+        cache.Add(std::move(solution));
+    }
+    auto held = cache.Get(1);
+    
+    // Full: the settled solution goes even though 1 is older
+    cache.Add(CreateTestSolution(5, 42));
+    EXPECT_EQ(cache.Size(), 4u);
+    EXPECT_FALSE(cache.Has(2));
+    EXPECT_TRUE(cache.Has(1));
+    
+    // With nothing settled, the least recently used goes
+    cache.Get(1);
+    cache.Add(CreateTestSolution(6, 42));
+    EXPECT_FALSE(cache.Has(3));
+    EXPECT_TRUE(cache.Has(1));
+    
+    cache.Remove(1);
+    ASSERT_NE(held, nullptr);
+    EXPECT_EQ(held->GetSolver(), "solver_1");
+}
+
+TEST_F(SolutionCacheTest, MemoryBudget) {
+    SolutionCache cache(1000, 64 * 1024);
+    for (Solution::Id id = 1; id <= 200; ++id) {
+        auto solution = CreateTestSolution(id, 42);
+        solution.GetData().SetResult(std::vector<uint8_t>(1024, 0xAB));
+        cache.Add(std::move(solution));
+    }
+    EXPECT_LE(cache.MemoryUsage(), 64u * 1024);
+    EXPECT_GT(cache.Size(), 0u);
+    EXPECT_LT(cache.Size(), 64u);
+    EXPECT_TRUE(cache.Has(200));
+}
+
 TEST_F(SolutionCacheTest, Clear) {
     cache_->Add(CreateTestSolution(1, 42));
     cache_->Add(CreateTestSolution(2, 42));
@@ -552,6 +693,536 @@ TEST_F(VerifierTest, LinearAlgebraVerifier) {
     EXPECT_EQ(verifier.GetType(), ProblemType::LINEAR_ALGEBRA);
 }
 
+// ============================================================================
+// Linear Algebra Verification Tests
+// ============================================================================
+
+class LinearAlgebraVerifierTest : public ::testing::Test {
+protected:
+    using Matrix = std::vector<double>;
+    
+    static Matrix Multiply(const Matrix& a, const Matrix& b, size_t n, size_t k, size_t m) {
+        Matrix c(n * m, 0.0);
+        for (size_t i = 0; i < n; ++i)
+            for (size_t p = 0; p < k; ++p)
+                for (size_t j = 0; j < m; ++j)
+                    c[i * m + j] += a[i * k + p] * b[p * m + j];
+        return c;
+    }
+    
+    static Matrix Deterministic(size_t count, double scale) {
+        Matrix values(count);
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = scale * (static_cast<double>((i * 7919) % 23) - 11.0) / 7.0;
+        }
+        return values;
+    }
+    
+    template<typename T>
+    static void Append(std::vector<uint8_t>& bytes, const Matrix& values) {
+        for (double value : values) {
+            T narrowed = static_cast<T>(value);
+            const auto* raw = reinterpret_cast<const uint8_t*>(&narrowed);
+            bytes.insert(bytes.end(), raw, raw + sizeof(T));
+        }
+    }
+    
+    /// Verify result against the input (header dims, then the matrices)
+    template<typename T = double>
+    bool Check(const std::string& operation, const std::vector<uint32_t>& dims,
+               const std::vector<Matrix>& inputs, const Matrix& result) {
+        std::vector<uint8_t> input;
+        for (uint32_t dim : dims) {
+            const auto* raw = reinterpret_cast<const uint8_t*>(&dim);
+            input.insert(input.end(), raw, raw + 4);
+        }
+        for (const auto& matrix : inputs) {
+            Append<T>(input, matrix);
+        }
+        
+        ProblemSpec spec(ProblemType::LINEAR_ALGEBRA);
+        spec.SetInputData(input);
+        spec.SetParameters("{\"operation\": \"" + operation + "\"}");
+        Problem problem(spec);
+        problem.SetId(7);
+        
+        Solution solution(7);
+        solution.SetSolver("solver");
+        std::vector<uint8_t> bytes;
+        Append<T>(bytes, result);
+        solution.GetData().SetResult(bytes);
+        solution.GetData().ComputeResultHash();
+        solution.GetData().AddIntermediate(Hash256{});
+        
+        LinearAlgebraVerifier verifier;
+        auto details = verifier.Verify(problem, solution);
+        for (const auto& [name, passed] : details.checks) {
+            if (name == "randomized_check_passed") {
+                EXPECT_EQ(details.IsValid(), passed);
+                return passed;
+            }
+        }
+        ADD_FAILURE() << "no randomized check: " << details.ToString();
+        return false;
+    }
+};
+
+TEST_F(LinearAlgebraVerifierTest, MultiplyDetectsOneWrongElement) {
+    Matrix a = Deterministic(12 * 10, 1.0);
+    Matrix b = Deterministic(10 * 8, 3.0);
+    Matrix c = Multiply(a, b, 12, 10, 8);
+    EXPECT_TRUE(Check("multiply", {12, 10, 10, 8}, {a, b}, c));
+    EXPECT_TRUE(Check<float>("multiply", {12, 10, 10, 8}, {a, b}, c));
+    
+    c[37] += 1e-3;
+    EXPECT_FALSE(Check("multiply", {12, 10, 10, 8}, {a, b}, c));
+}
+
+TEST_F(LinearAlgebraVerifierTest, SolveChecksResidual) {
+    size_t n = 9;
+    Matrix a = Deterministic(n * n, 1.0);
+    for (size_t i = 0; i < n; ++i) a[i * n + i] += 40.0;
+    Matrix x = Deterministic(n * 2, 0.5);
+    Matrix b = Multiply(a, x, n, n, 2);
+    EXPECT_TRUE(Check("solve", {9, 9, 9, 2}, {a, b}, x));
+    
+    x[5] *= 1.01;
+    EXPECT_FALSE(Check("solve", {9, 9, 9, 2}, {a, b}, x));
+}
+
+TEST_F(LinearAlgebraVerifierTest, DecompositionsMultiplyBack) {
+    size_t n = 10;
+    Matrix lower = Deterministic(n * n, 1.0);
+    Matrix upper = Deterministic(n * n, 2.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (j > i) lower[i * n + j] = 0.0;
+            if (j < i) upper[i * n + j] = 0.0;
+        }
+        lower[i * n + i] = 1.0;
+        upper[i * n + i] = 5.0 + static_cast<double>(i);
+    }
+    
+    // LU, packed with the unit diagonal of L left implicit
+    Matrix a = Multiply(lower, upper, n, n, n);
+    Matrix packed = upper;
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < i; ++j)
+            packed[i * n + j] = lower[i * n + j];
+    EXPECT_TRUE(Check("lu", {10, 10, 0, 0}, {a}, packed));
+    packed[n + 0] += 0.5;
+    EXPECT_FALSE(Check("lu", {10, 10, 0, 0}, {a}, packed));
+    
+    // Cholesky
+    Matrix factor = lower;
+    for (size_t i = 0; i < n; ++i) factor[i * n + i] = 2.0 + static_cast<double>(i);
+    Matrix transposed(n * n);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+            transposed[j * n + i] = factor[i * n + j];
+    Matrix spd = Multiply(factor, transposed, n, n, n);
+    EXPECT_TRUE(Check("cholesky", {10, 10, 0, 0}, {spd}, factor));
+    factor[n * n - 1] += 1e-4;
+    EXPECT_FALSE(Check("cholesky", {10, 10, 0, 0}, {spd}, factor));
+}
+
+// ============================================================================
+// ML Training Verification Tests
+// ============================================================================
+
+class MLTrainingVerifierTest : public ::testing::Test {
+protected:
+    template<typename T>
+    static void Append(std::vector<uint8_t>& bytes, T value) {
+        const auto* raw = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(T));
+    }
+    
+    /// Two features, two classes: class 0 when the first feature is larger
+    static std::vector<uint8_t> EvaluationSet(uint32_t samples) {
+        std::vector<uint8_t> data;
+        Append<uint32_t>(data, samples);
+        Append<uint32_t>(data, 2);
+        Append<uint32_t>(data, 2);
+        for (uint32_t i = 0; i < samples; ++i) {
+            Append<float>(data, static_cast<float>(i % 17));
+            Append<float>(data, static_cast<float>((i * 7) % 13) + 0.5f);
+        }
+        for (uint32_t i = 0; i < samples; ++i) {
+            Append<uint32_t>(data, (i % 17) > (i * 7) % 13 + 0.5 ? 0 : 1);
+        }
+        return data;
+    }
+    
+    /// Score and accuracy check of a weights-then-biases submission
+    std::pair<uint32_t, bool> Evaluate(const std::vector<float>& weights, uint32_t samples) {
+        ProblemSpec spec(ProblemType::ML_TRAINING);
+        spec.SetVerificationData(EvaluationSet(samples));
+        Problem problem(spec);
+        problem.SetId(3);
+        
+        Solution solution(3);
+        std::vector<uint8_t> bytes;
+        for (float weight : weights) {
+            Append<float>(bytes, weight);
+        }
+        solution.GetData().SetResult(bytes);
+        
+        auto details = verifier_.Verify(problem, solution);
+        for (const auto& [name, passed] : details.checks) {
+            if (name == "accuracy_threshold") {
+                return {details.score, passed};
+            }
+        }
+        ADD_FAILURE() << "no accuracy check: " << details.ToString();
+        return {0, false};
+    }
+    
+    MLTrainingVerifier verifier_;
+    const std::vector<float> right_{1, -1, -1, 1, 0, 0};
+    const std::vector<float> wrong_{-1, 1, 1, -1, 0, 0};
+};
+
+TEST_F(MLTrainingVerifierTest, EvaluatesOnThreads) {
+    verifier_.SetEvaluationThreads(3);
+    EXPECT_EQ(Evaluate(right_, 2000), std::make_pair(1000000u, true));
+    EXPECT_EQ(Evaluate(wrong_, 2000), std::make_pair(0u, false));
+    
+    // Sizes that don't fit the set score nothing
+    EXPECT_EQ(Evaluate({1, -1, -1, 1}, 2000).first, 0u);
+}
+
+TEST_F(MLTrainingVerifierTest, SampledEvaluation) {
+    verifier_.SetEvaluationSampleSize(200);
+    EXPECT_EQ(Evaluate(right_, 5000), std::make_pair(1000000u, true));
+    EXPECT_EQ(Evaluate(wrong_, 5000), std::make_pair(0u, false));
+}
+
+/// Verifier for OPTIMIZATION problems that holds every verification until
+/// released, so tests can see what is queued and what is running
+class GatedVerifier : public IVerifier {
+public:
+    explicit GatedVerifier(std::shared_future<void> gate) : gate_(std::move(gate)) {}
+    
+    ProblemType GetType() const override { return ProblemType::OPTIMIZATION; }
+    
+    VerificationDetails Verify(const Problem&, const Solution&) override {
+        gate_.wait();
+        VerificationDetails details;
+        details.result = VerificationResult::VALID;
+        return details;
+    }
+    
+    bool QuickValidate(const Problem&, const Solution& solution) override {
+        return !solution.GetData().GetResult().empty();
+    }
+    
+    uint64_t EstimateVerificationTime(const Problem&) const override { return 10; }
+
+private:
+    std::shared_future<void> gate_;
+};
+
+TEST_F(VerifierTest, AsyncVerificationOrderAndCaps) {
+    std::promise<void> release;
+    VerifierRegistry::Instance().Register(
+        std::make_unique<GatedVerifier>(release.get_future().share()));
+    
+    auto makeProblem = [](Amount reward) {
+        Problem problem(ProblemSpec(ProblemType::OPTIMIZATION));
+        problem.SetReward(reward);
+        return problem;
+    };
+    auto makeSolution = [](Solution::Id id, bool withResult = true) {
+        Solution solution(1);
+        solution.SetId(id);
+        if (withResult) {
+            solution.GetData().SetResult({0x01});
+        }
+        return solution;
+    };
+    
+    std::mutex mutex;
+    std::vector<Solution::Id> completed;
+    auto record = [&](Solution::Id id, const VerificationDetails&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.push_back(id);
+    };
+    
+    verifier_->SetMaxConcurrent(2);
+    verifier_->SetTypeConcurrency(ProblemType::OPTIMIZATION, 1);
+    
+    // Fails QuickValidate: answered at once and never queued
+    auto malformed = verifier_->SubmitAsync(makeProblem(5000), makeSolution(9, false));
+    ASSERT_EQ(malformed.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(malformed.get().result, VerificationResult::MALFORMED);
+    EXPECT_EQ(verifier_->GetPendingCount(), 0u);
+    
+    // The first starts; the type cap holds the rest in the queue
+    auto first = verifier_->SubmitAsync(makeProblem(100), makeSolution(1), record);
+    auto low = verifier_->SubmitAsync(makeProblem(10), makeSolution(2), record);
+    auto high = verifier_->SubmitAsync(makeProblem(1000), makeSolution(3), record);
+    auto cancelled = verifier_->SubmitAsync(makeProblem(1), makeSolution(4), record);
+    EXPECT_EQ(verifier_->GetRunningCount(), 1u);
+    EXPECT_EQ(verifier_->GetPendingCount(), 3u);
+    
+    EXPECT_TRUE(verifier_->CancelVerification(4));
+    EXPECT_EQ(cancelled.get().result, VerificationResult::ERROR);
+    
+    release.set_value();
+    EXPECT_TRUE(first.get().IsValid());
+    EXPECT_TRUE(high.get().IsValid());
+    EXPECT_TRUE(low.get().IsValid());
+    verifier_->Shutdown();
+    
+    // Higher reward is verified first
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(completed, (std::vector<Solution::Id>{4, 1, 3, 2}));
+    
+    VerifierRegistry::Instance().Register(
+        std::make_unique<GenericVerifier>(ProblemType::OPTIMIZATION));
+}
+
+TEST_F(VerifierTest, AsyncVerificationQueueBound) {
+    std::promise<void> release;
+    VerifierRegistry::Instance().Register(
+        std::make_unique<GatedVerifier>(release.get_future().share()));
+    
+    auto submit = [this](Solution::Id id, Amount reward) {
+        Problem problem(ProblemSpec(ProblemType::OPTIMIZATION));
+        problem.SetReward(reward);
+        Solution solution(1);
+        solution.SetId(id);
+        solution.GetData().SetResult({0x01});
+        return verifier_->SubmitAsync(problem, std::move(solution));
+    };
+    
+    verifier_->SetMaxConcurrent(1);
+    verifier_->SetMaxQueued(2);
+    
+    auto running = submit(1, 100);
+    auto a = submit(2, 50);
+    auto b = submit(3, 60);
+    auto c = submit(4, 70);   // Pushes out a, the lowest reward
+    auto d = submit(5, 10);   // Ranks lowest itself
+    
+    ASSERT_EQ(a.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(a.get().errorMessage, "Verification queue full");
+    ASSERT_EQ(d.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_EQ(d.get().result, VerificationResult::ERROR);
+    EXPECT_EQ(verifier_->GetPendingCount(), 2u);
+    
+    release.set_value();
+    EXPECT_TRUE(running.get().IsValid());
+    EXPECT_TRUE(b.get().IsValid());
+    EXPECT_TRUE(c.get().IsValid());
+    
+    VerifierRegistry::Instance().Register(
+        std::make_unique<GenericVerifier>(ProblemType::OPTIMIZATION));
+}
+
+/// GatedVerifier that takes solutions in batches and records their sizes
+class BatchingVerifier : public GatedVerifier {
+public:
+    BatchingVerifier(std::shared_future<void> gate, std::vector<size_t>& batches)
+        : GatedVerifier(std::move(gate)), batches_(batches) {}
+    
+    std::vector<VerificationDetails> VerifyMany(
+        const std::vector<VerificationItem>& items) override {
+        batches_.push_back(items.size());
+        return IVerifier::VerifyMany(items);
+    }
+    
+    size_t GetBatchSize() const override { return 3; }
+
+private:
+    std::vector<size_t>& batches_;
+};
+
+TEST_F(VerifierTest, AsyncVerificationBatchesByType) {
+    std::promise<void> release;
+    std::vector<size_t> batches;
+    VerifierRegistry::Instance().Register(
+        std::make_unique<BatchingVerifier>(release.get_future().share(), batches));
+    
+    auto submit = [this](Solution::Id id) {
+        Problem problem(ProblemSpec(ProblemType::OPTIMIZATION));
+        Solution solution(1);
+        solution.SetId(id);
+        solution.GetData().SetResult({0x01});
+        return verifier_->SubmitAsync(problem, std::move(solution));
+    };
+    
+    verifier_->SetMaxConcurrent(1);
+    std::vector<std::future<VerificationDetails>> results;
+    for (Solution::Id id = 1; id <= 5; ++id) {
+        results.push_back(submit(id));
+    }
+    
+    // The first runs alone; the other four wait and go in batches of three
+    release.set_value();
+    for (auto& result : results) {
+        EXPECT_TRUE(result.get().IsValid());
+    }
+    verifier_->Shutdown();
+    EXPECT_EQ(batches, (std::vector<size_t>{1, 3, 1}));
+    EXPECT_EQ(verifier_->GetTotalVerifications(), 5u);
+    
+    VerifierRegistry::Instance().Register(
+        std::make_unique<GenericVerifier>(ProblemType::OPTIMIZATION));
+}
+
+TEST_F(VerifierTest, HashPowVerifyManyHashesCandidateHeaders) {
+    // Any work meets the easy target and none the zero one
+    ProblemSpec spec(ProblemType::HASH_POW);
+    spec.SetParameters("{\"work\": \"header\"}");
+    spec.SetInputData(std::vector<uint8_t>(32, 0xFF));
+    Problem problem(spec);
+    problem.SetId(3);
+    spec.SetInputData(std::vector<uint8_t>(32, 0x00));
+    Problem impossible(spec);
+    impossible.SetId(3);
+    
+    auto makeSolution = [](std::vector<uint8_t> result) {
+        Solution solution(3);
+        solution.GetData().SetResult(std::move(result));
+        solution.GetData().ComputeResultHash();
+        return solution;
+    };
+    
+    // Headers with every nonce from 0, each checked against both problems
+    std::vector<Solution> solutions;
+    for (uint32_t nonce = 0; nonce < 37; ++nonce) {
+        std::vector<uint8_t> header(HashPowVerifier::HEADER_SIZE, 0x11);
+        std::memcpy(header.data() + 76, &nonce, sizeof(nonce));
+        solutions.push_back(makeSolution(header));
+    }
+    
+    std::vector<VerificationItem> items;
+    for (const auto& solution : solutions) {
+        items.push_back(VerificationItem{&problem, &solution});
+        items.push_back(VerificationItem{&impossible, &solution});
+    }
+    
+    HashPowVerifier verifier;
+    auto results = verifier.VerifyMany(items);
+    ASSERT_EQ(results.size(), items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        auto single = verifier.Verify(*items[i].problem, *items[i].solution);
+        EXPECT_EQ(results[i].result, single.result) << i;
+        EXPECT_EQ(results[i].score, single.score) << i;
+        EXPECT_EQ(results[i].checks, single.checks) << i;
+        EXPECT_EQ(results[i].IsValid(), i % 2 == 0) << i;
+    }
+    
+    // The header's work is its double SHA-256, not the result hash
+    std::vector<uint8_t> header = solutions[5].GetData().GetResult();
+    Hash256 work = DoubleSHA256(header.data(), header.size());
+    uint64_t hashValue = 0;
+    std::memcpy(&hashValue, work.data(), sizeof(hashValue));
+    uint32_t expected = static_cast<uint32_t>(
+        (static_cast<double>(UINT64_MAX - hashValue) / UINT64_MAX) * 1000000);
+    EXPECT_EQ(results[10].score, expected);
+    
+    // A solution for another problem or that is not a header is malformed
+    Solution other = makeSolution(solutions[1].GetData().GetResult());
+    other.SetProblemId(4);
+    Solution shortResult = makeSolution({0x01, 0x02, 0x03});
+    auto mixed = verifier.VerifyMany({VerificationItem{&problem, &other},
+                                      VerificationItem{&problem, &shortResult},
+                                      VerificationItem{&problem, &solutions[0]}});
+    EXPECT_EQ(mixed[0].result, VerificationResult::MALFORMED);
+    EXPECT_EQ(mixed[1].result, VerificationResult::MALFORMED);
+    EXPECT_TRUE(mixed[2].IsValid());
+}
+
+TEST_F(VerifierTest, HashPowKeepsResultHashWorkByDefault) {
+    // An 80-byte result whose result hash is below its double SHA-256
+    std::vector<uint8_t> header(HashPowVerifier::HEADER_SIZE, 0x22);
+    Solution solution(5);
+    Hash256 work;
+    for (uint32_t nonce = 0;; ++nonce) {
+        std::memcpy(header.data() + 76, &nonce, sizeof(nonce));
+        solution.GetData().SetResult(header);
+        solution.GetData().ComputeResultHash();
+        work = DoubleSHA256(header.data(), header.size());
+        if (solution.GetData().GetResultHash() < work) {
+            break;
+        }
+    }
+    
+    // With the double SHA-256 as the target, only the result hash meets it
+    ProblemSpec spec(ProblemType::HASH_POW);
+    spec.SetInputData(std::vector<uint8_t>(work.begin(), work.end()));
+    Problem problem(spec);
+    problem.SetId(5);
+    spec.SetParameters("{\"work\": \"header\"}");
+    Problem headerProblem(spec);
+    headerProblem.SetId(5);
+    
+    HashPowVerifier verifier;
+    auto results = verifier.VerifyMany({VerificationItem{&problem, &solution},
+                                        VerificationItem{&headerProblem, &solution}});
+    EXPECT_TRUE(results[0].IsValid());
+    EXPECT_EQ(results[0].checks, verifier.Verify(problem, solution).checks);
+    EXPECT_EQ(results[1].result, VerificationResult::INVALID);
+}
+
+TEST(VerificationCostModelTest, FitsAndRoundTrips) {
+    VerificationCostModel model;
+    
+    // 10us per byte, all within the 1024..2047 byte bucket
+    model.Record(ProblemType::LINEAR_ALGEBRA, 1100, 11000);
+    model.Record(ProblemType::LINEAR_ALGEBRA, 1900, 19000);
+    EXPECT_FALSE(model.Estimate(ProblemType::LINEAR_ALGEBRA, 1500));
+    model.Record(ProblemType::LINEAR_ALGEBRA, 1200, 12000);
+    model.Record(ProblemType::LINEAR_ALGEBRA, 1500, 15000);
+    
+    auto estimate = model.Estimate(ProblemType::LINEAR_ALGEBRA, 1700);
+    ASSERT_TRUE(estimate);
+    EXPECT_EQ(*estimate, 17u);
+    EXPECT_FALSE(model.Estimate(ProblemType::LINEAR_ALGEBRA, 100));
+    EXPECT_FALSE(model.Estimate(ProblemType::ML_TRAINING, 1700));
+    
+    VerificationCostModel restored;
+    std::vector<Byte> bytes = model.Serialize();
+    ASSERT_TRUE(restored.Deserialize(bytes.data(), bytes.size()));
+    EXPECT_EQ(restored.Estimate(ProblemType::LINEAR_ALGEBRA, 1700), estimate);
+    
+    bytes.resize(bytes.size() - 1);
+    EXPECT_FALSE(restored.Deserialize(bytes.data(), bytes.size()));
+    EXPECT_EQ(restored.Size(), 1u);
+    
+    std::string path = (std::filesystem::temp_directory_path() /
+                        "shurium_test_verifiercost.dat").string();
+    ASSERT_TRUE(model.Save(path));
+    VerificationCostModel loaded;
+    ASSERT_TRUE(loaded.Load(path));
+    EXPECT_EQ(loaded.Estimate(ProblemType::LINEAR_ALGEBRA, 1700), estimate);
+    std::filesystem::remove(path);
+}
+
+TEST_F(VerifierTest, MeasuredCostReplacesStaticEstimate) {
+    Problem problem(ProblemSpec(ProblemType::OPTIMIZATION));
+    problem.SetId(1);
+    problem.GetSpec().SetInputData({0x01, 0x02});
+    EXPECT_EQ(verifier_->EstimateVerificationTime(problem), 10u);
+    
+    for (int i = 0; i < 4; ++i) {
+        verifier_->GetCostModel().Record(ProblemType::OPTIMIZATION, 2, 250000);
+    }
+    EXPECT_EQ(verifier_->EstimateVerificationTime(problem), 250u);
+    
+    // Verifications feed the model
+    Solution solution(1);
+    solution.GetData().SetResult({0x01});
+    verifier_->GetCostModel().Clear();
+    for (int i = 0; i < 4; ++i) {
+        verifier_->Verify(problem, solution);
+    }
+    EXPECT_EQ(verifier_->GetCostModel().Size(), 1u);
+}
+
 // ============================================================================
 // Marketplace Tests
 // ============================================================================
@@ -617,6 +1288,17 @@ TEST_F(MarketplaceTest, SubmitProblem) {
     EXPECT_EQ(found->GetReward(), 5000);
 }
 
+TEST_F(MarketplaceTest, RejectsCostlyVerification) {
+    MarketplaceConfig config;
+    config.minProblemReward = 100;
+    config.maxVerificationCost = 5;  // Below the hash verifier's 10ms
+    Marketplace marketplace(config);
+    marketplace.Start();
+    
+    EXPECT_EQ(marketplace.EstimateVerificationTime(CreateTestProblem()), 10u);
+    EXPECT_EQ(marketplace.SubmitProblem(CreateTestProblem()), Problem::INVALID_ID);
+}
+
 TEST_F(MarketplaceTest, GetPendingProblems) {
     marketplace_->Start();
     
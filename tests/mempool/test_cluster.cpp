@@ -0,0 +1,86 @@
+// SHURIUM - Mempool Cluster Linearization Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/mempool/cluster.h"
+
+using namespace shurium;
+
+namespace {
+
+ClusterTx Tx(Amount fee, uint64_t size, std::vector<uint32_t> parents = {}) {
+    ClusterTx tx;
+    tx.fee = fee;
+    tx.size = size;
+    tx.parents = std::move(parents);
+    return tx;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Linearization Tests
+// ============================================================================
+
+TEST(ClusterLinearizationTest, SingleTransaction) {
+    std::vector<ClusterTx> txs = {Tx(500, 100)};
+    EXPECT_EQ(LinearizeCluster(txs), (std::vector<uint32_t>{0}));
+    
+    auto chunks = ChunkLinearization(txs, {0});
+    ASSERT_EQ(chunks.size(), 1u);
+    EXPECT_EQ(chunks[0].fee, 500);
+    EXPECT_EQ(chunks[0].size, 100u);
+    EXPECT_EQ(chunks[0].count, 1u);
+}
+
+TEST(ClusterLinearizationTest, ChildPaysForParent) {
+    // A cheap parent with a rich child forms one chunk
+    std::vector<ClusterTx> txs = {Tx(100, 100), Tx(2000, 100, {0})};
+    auto order = LinearizeCluster(txs);
+    EXPECT_EQ(order, (std::vector<uint32_t>{0, 1}));
+    
+    auto chunks = ChunkLinearization(txs, order);
+    ASSERT_EQ(chunks.size(), 1u);
+    EXPECT_EQ(chunks[0].fee, 2100);
+    EXPECT_EQ(chunks[0].count, 2u);
+}
+
+TEST(ClusterLinearizationTest, BestSiblingFirst) {
+    // Parent 0 with a poor child 1 and a rich child 2
+    std::vector<ClusterTx> txs = {Tx(1000, 100), Tx(100, 100, {0}), Tx(5000, 100, {0})};
+    auto order = LinearizeCluster(txs);
+    EXPECT_EQ(order, (std::vector<uint32_t>{0, 2, 1}));
+    
+    auto chunks = ChunkLinearization(txs, order);
+    ASSERT_EQ(chunks.size(), 2u);
+    EXPECT_EQ(chunks[0].fee, 6000);
+    EXPECT_EQ(chunks[0].count, 2u);
+    EXPECT_EQ(chunks[1].fee, 100);
+}
+
+TEST(ClusterLinearizationTest, RespectsTopologyAcrossBitsetWords) {
+    // A chain of 70 with rising fees: everything lands in one chunk, parents first
+    std::vector<ClusterTx> txs;
+    for (uint32_t i = 0; i < 70; ++i) {
+        txs.push_back(i == 0 ? Tx(1, 100) : Tx(Amount(i) * 10, 100, {i - 1}));
+    }
+    auto order = LinearizeCluster(txs);
+    ASSERT_EQ(order.size(), 70u);
+    for (uint32_t i = 0; i < 70; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+    
+    auto chunks = ChunkLinearization(txs, order);
+    ASSERT_FALSE(chunks.empty());
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        EXPECT_FALSE(HigherFeerate(chunks[i], chunks[i - 1]));
+    }
+}
+
+TEST(ClusterLinearizationTest, FeerateComparisonIsExact) {
+    // 1/3 against 333333/1000000 differs only past FeeRate's precision
+    EXPECT_TRUE(HigherFeerate(1, 3, 333333, 1000000));
+    EXPECT_FALSE(HigherFeerate(333333, 1000000, 1, 3));
+    EXPECT_FALSE(HigherFeerate(2, 4, 1, 2));
+}
@@ -0,0 +1,193 @@
+// SHURIUM - Fee Estimation Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/mempool/fees.h"
+#include "shurium/mempool/mempool.h"
+#include "shurium/core/transaction.h"
+#include "shurium/core/script.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace shurium;
+
+// ============================================================================
+// Test Utilities
+// ============================================================================
+
+class FeeEstimatorTest : public ::testing::Test {
+protected:
+    FeeEstimator estimator;
+    uint32_t height{100};
+    uint32_t nextId{0};
+
+    TxHash NextTxid() {
+        TxHash txid;
+        uint32_t id = ++nextId;
+        for (int i = 0; i < 4; ++i) {
+            txid[i] = static_cast<uint8_t>(id >> (8 * i));
+        }
+        return txid;
+    }
+
+    /// Add count transactions at feePerK at the current height
+    std::vector<TxHash> Arrive(size_t count, Amount feePerK) {
+        std::vector<TxHash> txids;
+        for (size_t i = 0; i < count; ++i) {
+            txids.push_back(NextTxid());
+            estimator.ProcessTransaction(txids.back(), FeeRate(feePerK), height);
+        }
+        return txids;
+    }
+
+    void ConnectBlock(const std::vector<TxHash>& confirmed) {
+        estimator.ProcessBlock(++height, confirmed);
+    }
+};
+
+// ============================================================================
+// Estimates
+// ============================================================================
+
+TEST_F(FeeEstimatorTest, NoDataGivesNoEstimate) {
+    EXPECT_FALSE(estimator.EstimateFee(1).IsValid());
+    EXPECT_FALSE(estimator.EstimateSmartFee(6).IsValid());
+    EXPECT_FALSE(estimator.EstimateFee(0).IsValid());
+    EXPECT_FALSE(estimator.EstimateFee(MAX_CONFIRM_TARGET + 1).IsValid());
+    EXPECT_GT(estimator.GetBucketCount(), 100u);
+}
+
+TEST_F(FeeEstimatorTest, EstimatesFeerateThatConfirmsNextBlock) {
+    // High feerates confirm in the next block; low ones never do
+    for (int block = 0; block < 200; ++block) {
+        auto high = Arrive(10, 50000);
+        Arrive(10, 2000);
+        ConnectBlock(high);
+    }
+
+    FeeEstimate estimate = estimator.EstimateFee(1);
+    ASSERT_TRUE(estimate.IsValid());
+    EXPECT_EQ(estimate.target, 1u);
+    EXPECT_EQ(estimate.feeRate.GetFeePerK(), 50000);
+    EXPECT_EQ(estimator.GetTrackedCount(), 2000u);
+    EXPECT_EQ(estimator.GetBestHeight(), 300u);
+}
+
+TEST_F(FeeEstimatorTest, SmartFeeMovesToTargetWithData) {
+    // Everything takes three blocks to confirm
+    std::vector<std::vector<TxHash>> pending;
+    for (int block = 0; block < 200; ++block) {
+        pending.push_back(Arrive(10, 20000));
+        std::vector<TxHash> confirmed;
+        if (pending.size() >= 3) {
+            confirmed = pending[pending.size() - 3];
+        }
+        ConnectBlock(confirmed);
+    }
+
+    EXPECT_FALSE(estimator.EstimateFee(1).IsValid());
+    FeeEstimate estimate = estimator.EstimateSmartFee(1);
+    ASSERT_TRUE(estimate.IsValid());
+    EXPECT_EQ(estimate.target, 3u);
+    EXPECT_EQ(estimate.feeRate.GetFeePerK(), 20000);
+}
+
+TEST_F(FeeEstimatorTest, FailuresRaiseTheEstimate) {
+    // At first both feerates confirm at once
+    for (int block = 0; block < 200; ++block) {
+        auto high = Arrive(10, 50000);
+        auto low = Arrive(10, 2000);
+        high.insert(high.end(), low.begin(), low.end());
+        ConnectBlock(high);
+    }
+    FeeEstimate before = estimator.EstimateFee(1);
+    ASSERT_TRUE(before.IsValid());
+    EXPECT_LT(before.feeRate.GetFeePerK(), 50000);
+
+    // Then the low ones wait two blocks and are evicted unmined
+    std::vector<std::vector<TxHash>> stuck;
+    for (int block = 0; block < 300; ++block) {
+        ConnectBlock(Arrive(10, 50000));
+        stuck.push_back(Arrive(10, 2000));
+        if (stuck.size() > 2) {
+            for (const TxHash& txid : stuck[stuck.size() - 3]) {
+                estimator.RemoveTransaction(txid);
+            }
+        }
+    }
+    FeeEstimate after = estimator.EstimateFee(1);
+    ASSERT_TRUE(after.IsValid());
+    EXPECT_EQ(after.feeRate.GetFeePerK(), 50000);
+}
+
+TEST_F(FeeEstimatorTest, SaveAndLoadKeepEstimates) {
+    for (int block = 0; block < 200; ++block) {
+        ConnectBlock(Arrive(10, 30000));
+    }
+    FeeEstimate saved = estimator.EstimateFee(2);
+    ASSERT_TRUE(saved.IsValid());
+
+    auto path = std::filesystem::temp_directory_path() / "shurium_test_fee_estimates.dat";
+    ASSERT_TRUE(estimator.Save(path));
+
+    FeeEstimator loaded;
+    ASSERT_TRUE(loaded.Load(path));
+    EXPECT_EQ(loaded.GetBestHeight(), estimator.GetBestHeight());
+    FeeEstimate estimate = loaded.EstimateFee(2);
+    ASSERT_TRUE(estimate.IsValid());
+    EXPECT_EQ(estimate.feeRate.GetFeePerK(), saved.feeRate.GetFeePerK());
+
+    // A damaged file is refused and leaves the statistics alone
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "junk";
+    }
+    FeeEstimator fresh;
+    EXPECT_FALSE(fresh.Load(path));
+    EXPECT_FALSE(fresh.EstimateFee(2).IsValid());
+    std::filesystem::remove(path);
+}
+
+// ============================================================================
+// Mempool Reporting
+// ============================================================================
+
+TEST(FeeEstimatorMempoolTest, MempoolReportsArrivalsAndConfirmations) {
+    FeeEstimator estimator;
+    Mempool mempool;
+    mempool.SetFeeEstimator(&estimator);
+
+    Hash160 pubKeyHash;
+    pubKeyHash[0] = 0xAB;
+    auto makeTx = [&](const OutPoint& input) {
+        MutableTransaction mtx;
+        mtx.version = 1;
+        mtx.vin.push_back(TxIn(input));
+        mtx.vout.push_back(TxOut(10000, Script::CreateP2PKH(pubKeyHash)));
+        return MakeTransactionRef(std::move(mtx));
+    };
+
+    TxHash fundingHash;
+    fundingHash[0] = 0x01;
+    auto parent = makeTx(OutPoint(fundingHash, 0));
+    auto child = makeTx(OutPoint(parent->GetHash(), 0));
+    TxHash otherHash;
+    otherHash[0] = 0x02;
+    auto other = makeTx(OutPoint(otherHash, 0));
+
+    std::string err;
+    ASSERT_TRUE(mempool.AddTx(parent, 1000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(child, 1000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(other, 1000, 100, false, err)) << err;
+
+    // The child's feerate says nothing about how fast it confirms
+    EXPECT_EQ(estimator.GetTrackedCount(), 2u);
+
+    mempool.RemoveForBlock({parent}, 101);
+    EXPECT_EQ(estimator.GetTrackedCount(), 1u);
+    EXPECT_EQ(estimator.GetBestHeight(), 101u);
+
+    mempool.RemoveTxAndDescendants(other->GetHash(), MempoolRemovalReason::EXPIRY);
+    EXPECT_EQ(estimator.GetTrackedCount(), 0u);
+}
@@ -6,6 +6,8 @@
 #include "shurium/mempool/mempool.h"
 #include "shurium/core/transaction.h"
 #include "shurium/core/script.h"
+#include <atomic>
+#include <thread>
 
 using namespace shurium;
 
@@ -381,7 +383,7 @@ TEST_F(MempoolRemovalTest, RemoveForBlock) {
     
     // Simulate block including tx1
     std::vector<TransactionRef> blockTxs = {tx1};
-    mempool.RemoveForBlock(blockTxs);
+    mempool.RemoveForBlock(blockTxs, 101);
     
     EXPECT_EQ(mempool.Size(), 1);
     EXPECT_FALSE(mempool.Exists(tx1->GetHash()));
@@ -437,6 +439,87 @@ TEST_F(MempoolChainTest, RemoveParentRemovesChildren) {
     EXPECT_TRUE(mempool.IsEmpty());
 }
 
+TEST_F(MempoolChainTest, ChainTracksAncestorAndDescendantStats) {
+    // parent -> child -> grandchild
+    std::string err;
+    auto parent = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 1);
+    auto child = CreateTx({OutPoint(parent->GetHash(), 0)}, 47 * COIN, 1);
+    auto grandchild = CreateTx({OutPoint(child->GetHash(), 0)}, 46 * COIN, 1);
+    ASSERT_TRUE(mempool.AddTx(parent, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(child, 2 * COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(grandchild, 3 * COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.CheckConsistency());
+    
+    size_t size = parent->GetTotalSize() + child->GetTotalSize() + grandchild->GetTotalSize();
+    std::vector<TxMempoolInfo> infos = mempool.GetAllTxInfo();
+    ASSERT_EQ(infos.size(), 3u);
+    
+    // Confirming the parent leaves child -> grandchild
+    mempool.RemoveForBlock({parent}, 101);
+    EXPECT_EQ(mempool.Size(), 2u);
+    EXPECT_EQ(mempool.GetTotalSize(), size - parent->GetTotalSize());
+    EXPECT_TRUE(mempool.CheckConsistency());
+    
+    // Only the root's descendants go with it
+    mempool.RemoveTxAndDescendants(grandchild->GetHash(), MempoolRemovalReason::CONFLICT);
+    EXPECT_TRUE(mempool.Exists(child->GetHash()));
+    EXPECT_FALSE(mempool.Exists(grandchild->GetHash()));
+    EXPECT_TRUE(mempool.CheckConsistency());
+}
+
+TEST_F(MempoolChainTest, DiamondCountsSharedAncestorOnce) {
+    // root has two outputs, each spent by one side; join spends both sides
+    std::string err;
+    auto root = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 2);
+    auto left = CreateTx({OutPoint(root->GetHash(), 0)}, 23 * COIN, 1);
+    auto right = CreateTx({OutPoint(root->GetHash(), 1)}, 23 * COIN, 1);
+    auto join = CreateTx({OutPoint(left->GetHash(), 0), OutPoint(right->GetHash(), 0)}, 45 * COIN, 1);
+    ASSERT_TRUE(mempool.AddTx(root, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(left, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(right, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(join, COIN, 100, false, err)) << err;
+    
+    // CheckConsistency recomputes every entry's stats from its links
+    EXPECT_TRUE(mempool.CheckConsistency());
+    
+    mempool.RemoveTxAndDescendants(left->GetHash(), MempoolRemovalReason::CONFLICT);
+    EXPECT_EQ(mempool.Size(), 2u);
+    EXPECT_FALSE(mempool.Exists(join->GetHash()));
+    EXPECT_TRUE(mempool.CheckConsistency());
+    
+    mempool.RemoveTxAndDescendants(root->GetHash(), MempoolRemovalReason::CONFLICT);
+    EXPECT_TRUE(mempool.IsEmpty());
+}
+
+TEST_F(MempoolChainTest, ChainLimits) {
+    MempoolLimits limits;
+    limits.maxAncestorCount = 5;
+    limits.maxDescendantCount = 100;
+    mempool.SetLimits(limits);
+    
+    std::string err;
+    OutPoint prev = MakeOutPoint(0x01, 0);
+    Amount value = 48 * COIN;
+    for (int i = 0; i < 5; ++i) {
+        auto tx = CreateTx({prev}, value, 1);
+        ASSERT_TRUE(mempool.AddTx(tx, COIN, 100, false, err)) << err;
+        prev = OutPoint(tx->GetHash(), 0);
+        value -= COIN;
+    }
+    auto tooDeep = CreateTx({prev}, value, 1);
+    EXPECT_FALSE(mempool.AddTx(tooDeep, COIN, 100, false, err));
+    EXPECT_EQ(err, "too many unconfirmed ancestors");
+    
+    // The chain root already has four descendants
+    limits.maxAncestorCount = 100;
+    limits.maxDescendantCount = 5;
+    mempool.SetLimits(limits);
+    EXPECT_FALSE(mempool.AddTx(tooDeep, COIN, 100, false, err));
+    EXPECT_EQ(err, "too many descendants");
+    EXPECT_EQ(mempool.Size(), 5u);
+    EXPECT_TRUE(mempool.CheckConsistency());
+}
+
 // ============================================================================
 // Mempool Mining Tests
 // ============================================================================
@@ -491,6 +574,51 @@ TEST_F(MempoolMiningTest, GetTransactionsMinFeeRate) {
     EXPECT_TRUE(blockTxs.empty());
 }
 
+TEST_F(MempoolMiningTest, ChildPaysForParent) {
+    // A cheap parent whose child pays for both beats a mid-fee transaction
+    std::string err;
+    auto parent = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 1);
+    auto child = CreateTx({OutPoint(parent->GetHash(), 0)}, 47 * COIN, 1);
+    auto middle = CreateTx({MakeOutPoint(0x02, 0)}, 48 * COIN, 1);
+    ASSERT_TRUE(mempool.AddTx(parent, 1000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(child, 100000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(middle, 20000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.CheckConsistency());
+    
+    auto chunks = mempool.GetChunksForMining();
+    ASSERT_EQ(chunks.size(), 2u);
+    ASSERT_EQ(chunks[0].txs.size(), 2u);
+    EXPECT_EQ(chunks[0].txs[0].tx, parent);
+    EXPECT_EQ(chunks[0].txs[1].tx, child);
+    EXPECT_EQ(chunks[0].fee, 101000);
+    EXPECT_EQ(chunks[1].txs[0].tx, middle);
+    
+    auto blockTxs = mempool.GetTransactionsForBlock(1000000, FeeRate(0));
+    EXPECT_EQ(blockTxs, (std::vector<TransactionRef>{parent, child, middle}));
+}
+
+TEST_F(MempoolMiningTest, RemovalSplitsCluster) {
+    // Two children of one parent are one cluster until the parent confirms
+    std::string err;
+    auto parent = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 2);
+    auto left = CreateTx({OutPoint(parent->GetHash(), 0)}, 23 * COIN, 1);
+    auto right = CreateTx({OutPoint(parent->GetHash(), 1)}, 23 * COIN, 1);
+    ASSERT_TRUE(mempool.AddTx(parent, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(left, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool.AddTx(right, 2 * COIN, 100, false, err)) << err;
+    
+    auto before = mempool.GetChunksForMining();
+    ASSERT_FALSE(before.empty());
+    EXPECT_EQ(before.back().cluster, before.front().cluster);
+    
+    mempool.RemoveForBlock({parent}, 101);
+    EXPECT_TRUE(mempool.CheckConsistency());
+    auto after = mempool.GetChunksForMining();
+    ASSERT_EQ(after.size(), 2u);
+    EXPECT_NE(after[0].cluster, after[1].cluster);
+    EXPECT_EQ(after[0].txs[0].tx, right);
+}
+
 // ============================================================================
 // Mempool Size Limits Tests
 // ============================================================================
@@ -516,7 +644,106 @@ TEST_F(MempoolLimitsTest, TrimToSize) {
     }
     
     // Mempool should have trimmed to stay under size limit
-    EXPECT_LE(mempool->GetTotalSize(), 1000);
+    EXPECT_LE(mempool->DynamicMemoryUsage(), 1000);
+}
+
+TEST_F(MempoolLimitsTest, LimitCapsMemoryNotTransactionBytes) {
+    MempoolLimits limits;
+    mempool = std::make_unique<Mempool>(limits);
+    std::string err;
+    for (int i = 0; i < 10; ++i) {
+        auto tx = CreateTx({MakeOutPoint(static_cast<uint8_t>(i), 0)}, 49 * COIN);
+        ASSERT_TRUE(mempool->AddTx(tx, (i + 1) * 10000, 100, false, err)) << err;
+    }
+    
+    // Entries and index nodes cost more than the serialized transactions
+    EXPECT_GT(mempool->DynamicMemoryUsage(), mempool->GetTotalSize() + 10 * sizeof(MempoolEntry));
+    
+    limits.maxSize = mempool->DynamicMemoryUsage();
+    mempool->SetLimits(limits);
+    for (int i = 10; i < 20; ++i) {
+        auto tx = CreateTx({MakeOutPoint(static_cast<uint8_t>(i), 0)}, 49 * COIN);
+        mempool->AddTx(tx, (i + 1) * 10000, 100, false, err);
+    }
+    EXPECT_LE(mempool->DynamicMemoryUsage(), limits.maxSize);
+    EXPECT_GT(mempool->Size(), 0u);
+    EXPECT_LT(mempool->Size(), 20u);
+    EXPECT_TRUE(mempool->CheckConsistency());
+    
+    // Removing the rest leaves only the bucket arrays
+    mempool->Clear();
+    EXPECT_LT(mempool->DynamicMemoryUsage(), 1000u);
+}
+
+TEST_F(MempoolLimitsTest, TrimEvictsWorstChunk) {
+    MempoolLimits limits;
+    limits.maxSize = 100000;
+    mempool = std::make_unique<Mempool>(limits);
+    
+    // A cheap parent rescued by its child, and a lone mid-fee transaction
+    std::string err;
+    auto parent = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 1);
+    auto child = CreateTx({OutPoint(parent->GetHash(), 0)}, 47 * COIN, 1);
+    auto middle = CreateTx({MakeOutPoint(0x02, 0)}, 48 * COIN, 1);
+    ASSERT_TRUE(mempool->AddTx(parent, 1000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool->AddTx(child, 100000, 100, false, err)) << err;
+    ASSERT_TRUE(mempool->AddTx(middle, 20000, 100, false, err)) << err;
+    
+    // Shrinking by one transaction evicts the mid-fee one, not the parent
+    limits.maxSize = mempool->DynamicMemoryUsage() - 1;
+    mempool->SetLimits(limits);
+    mempool->LimitSize(GetTime());
+    EXPECT_TRUE(mempool->Exists(parent->GetHash()));
+    EXPECT_TRUE(mempool->Exists(child->GetHash()));
+    EXPECT_FALSE(mempool->Exists(middle->GetHash()));
+    EXPECT_TRUE(mempool->CheckConsistency());
+}
+
+TEST_F(MempoolLimitsTest, ExpiryRemovesOldTransactions) {
+    MempoolLimits limits;
+    limits.maxAge = 3600;
+    mempool = std::make_unique<Mempool>(limits);
+    
+    std::string err;
+    auto parent = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 1);
+    auto child = CreateTx({OutPoint(parent->GetHash(), 0)}, 47 * COIN, 1);
+    ASSERT_TRUE(mempool->AddTx(parent, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool->AddTx(child, COIN, 100, false, err)) << err;
+    int64_t added = GetTime();
+    
+    size_t expired = 0;
+    mempool->SetNotifyRemoved([&](const TransactionRef&, MempoolRemovalReason reason) {
+        if (reason == MempoolRemovalReason::EXPIRY) ++expired;
+    });
+    
+    // Nothing is older than the age limit yet
+    mempool->LimitSize(added - 1 + limits.maxAge);
+    EXPECT_EQ(mempool->Size(), 2u);
+    
+    mempool->LimitSize(added + limits.maxAge + 1);
+    EXPECT_EQ(expired, 2u);
+    EXPECT_TRUE(mempool->IsEmpty());
+    EXPECT_TRUE(mempool->CheckConsistency());
+}
+
+TEST_F(MempoolLimitsTest, ClusterCountLimit) {
+    MempoolLimits limits;
+    limits.maxClusterCount = 3;
+    mempool = std::make_unique<Mempool>(limits);
+    
+    // Two separate clusters of two would join into four
+    std::string err;
+    auto a = CreateTx({MakeOutPoint(0x01, 0)}, 48 * COIN, 1);
+    auto b = CreateTx({MakeOutPoint(0x02, 0)}, 48 * COIN, 1);
+    ASSERT_TRUE(mempool->AddTx(a, COIN, 100, false, err)) << err;
+    ASSERT_TRUE(mempool->AddTx(b, COIN, 100, false, err)) << err;
+    auto join = CreateTx({OutPoint(a->GetHash(), 0), OutPoint(b->GetHash(), 0)}, 95 * COIN, 1);
+    ASSERT_TRUE(mempool->AddTx(join, COIN, 100, false, err)) << err;
+    
+    auto extra = CreateTx({OutPoint(join->GetHash(), 0)}, 94 * COIN, 1);
+    EXPECT_FALSE(mempool->AddTx(extra, COIN, 100, false, err));
+    EXPECT_EQ(err, "too many transactions in cluster");
+    EXPECT_TRUE(mempool->CheckConsistency());
 }
 
 // ============================================================================
@@ -622,11 +849,76 @@ TEST_F(MempoolBasicTest, GetAllTxInfo) {
     EXPECT_EQ(allInfo.size(), 2);
 }
 
+TEST_F(MempoolBasicTest, SnapshotIsImmutable) {
+    auto tx1 = CreateTx({MakeOutPoint(0x01, 0)}, 49 * COIN);
+    auto tx2 = CreateTx({MakeOutPoint(0x02, 0)}, 48 * COIN);
+    std::string err;
+    ASSERT_TRUE(mempool.AddTx(tx1, COIN, 100, false, err)) << err;
+    
+    // An unchanged mempool hands out the same snapshot
+    auto first = mempool.GetSnapshot();
+    EXPECT_EQ(mempool.GetSnapshot(), first);
+    ASSERT_EQ(first->txs.size(), 1u);
+    EXPECT_EQ(first->totalSize, tx1->GetTotalSize());
+    
+    // A change leaves the old snapshot as it was
+    ASSERT_TRUE(mempool.AddTx(tx2, COIN, 100, false, err)) << err;
+    auto second = mempool.GetSnapshot();
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->txs.size(), 2u);
+    EXPECT_EQ(second->totalFees, 2 * COIN);
+    EXPECT_EQ(first->txs.size(), 1u);
+    EXPECT_EQ(first->txs[0].tx, tx1);
+    
+    mempool.Clear();
+    EXPECT_TRUE(mempool.GetSnapshot()->txs.empty());
+    EXPECT_EQ(mempool.Size(), 0u);
+}
+
+TEST_F(MempoolBasicTest, ReadersRunAlongsideWriter) {
+    std::atomic<bool> done{false};
+    std::atomic<size_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                auto snapshot = mempool.GetSnapshot();
+                EXPECT_LE(snapshot->txs.size(), 200u);
+                mempool.Exists(TxHash());
+                mempool.Size();
+                ++reads;
+            }
+        });
+    }
+    
+    // Start writing once the readers are running
+    while (reads.load() == 0) {
+        std::this_thread::yield();
+    }
+    
+    std::string err;
+    for (int i = 0; i < 200; ++i) {
+        OutPoint prevout = MakeOutPoint(static_cast<uint8_t>(i), 0);
+        prevout.n = static_cast<uint32_t>(i);
+        EXPECT_TRUE(mempool.AddTx(CreateTx({prevout}, 49 * COIN), COIN, 100, false, err)) << err;
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_EQ(mempool.Size(), 200u);
+    EXPECT_EQ(mempool.GetSnapshot()->txs.size(), 200u);
+    EXPECT_TRUE(mempool.CheckConsistency());
+}
+
 // ============================================================================
 // AcceptToMempool Tests
 // ============================================================================
 
 #include "shurium/chain/coins.h"
+#include "shurium/chain/checkqueue.h"
 
 class AcceptToMempoolTest : public ::testing::Test {
 protected:
@@ -866,3 +1158,177 @@ TEST_F(AcceptToMempoolTest, ChainedTransactions) {
     EXPECT_EQ(mempool.Size(), 2);
 }
 
+
+TEST_F(AcceptToMempoolTest, PackageChildPaysForParent) {
+    // The parent alone is below the relay feerate; its child pays for both
+    auto parent = CreateValidTx(MakeOutPoint(0x01, 0), 50 * COIN - 1);
+    auto child = CreateValidTx(OutPoint(parent->GetHash(), 0), 49 * COIN);
+    
+    EXPECT_FALSE(AcceptToMempool(parent, mempool, *coins, 100).IsValid());
+    
+    // Children may come first; the package is sorted before validation
+    CheckQueue queue(2);
+    PackageAcceptResult result = AcceptPackage({child, parent}, mempool, *coins, 100, &queue);
+    
+    EXPECT_TRUE(result.AllValid()) << result.results[0].rejectReason << " / "
+                                   << result.results[1].rejectReason;
+    EXPECT_EQ(result.accepted, 2u);
+    EXPECT_EQ(result.results[0].fee, 1 * COIN - 1);
+    EXPECT_EQ(result.results[1].fee, 1);
+    EXPECT_TRUE(mempool.Exists(parent->GetHash()));
+    EXPECT_TRUE(mempool.Exists(child->GetHash()));
+    EXPECT_TRUE(mempool.CheckConsistency());
+}
+
+TEST_F(AcceptToMempoolTest, PackageRejectionReachesDescendants) {
+    auto parent = CreateValidTx(MakeOutPoint(0xFF, 0), 49 * COIN);  // Missing input
+    auto child = CreateValidTx(OutPoint(parent->GetHash(), 0), 48 * COIN);
+    auto unrelated = CreateValidTx(MakeOutPoint(0x02, 0), 99 * COIN);
+    
+    PackageAcceptResult result = AcceptPackage({parent, child, unrelated}, mempool, *coins, 100);
+    
+    EXPECT_FALSE(result.AllValid());
+    EXPECT_EQ(result.accepted, 1u);
+    EXPECT_EQ(result.results[0].rejectReason, "missing-inputs");
+    EXPECT_EQ(result.results[1].rejectReason, "missing-inputs");
+    EXPECT_TRUE(result.results[2].IsValid()) << result.results[2].rejectReason;
+    EXPECT_EQ(mempool.Size(), 1u);
+}
+
+TEST_F(AcceptToMempoolTest, PackageScriptFailureIsAttributed) {
+    auto good = CreateValidTx(MakeOutPoint(0x01, 0), 49 * COIN);
+    
+    // OP_RETURN in the input script fails verification
+    MutableTransaction mtx;
+    mtx.version = 1;
+    Script badScript;
+    badScript.push_back(OP_RETURN);
+    mtx.vin.push_back(TxIn(MakeOutPoint(0x02, 0), badScript, 0xFFFFFFFF));
+    Script outputScript;
+    outputScript.push_back(OP_TRUE);
+    mtx.vout.push_back(TxOut(99 * COIN, outputScript));
+    auto bad = MakeTransactionRef(std::move(mtx));
+    auto badChild = CreateValidTx(OutPoint(bad->GetHash(), 0), 98 * COIN);
+    
+    CheckQueue queue(2);
+    PackageAcceptResult result = AcceptPackage({bad, good, badChild}, mempool, *coins, 100, &queue);
+    
+    EXPECT_EQ(result.accepted, 1u);
+    EXPECT_NE(result.results[0].rejectReason.find("mandatory-script-verify-flag-failed"),
+              std::string::npos) << result.results[0].rejectReason;
+    EXPECT_TRUE(result.results[1].IsValid()) << result.results[1].rejectReason;
+    EXPECT_EQ(result.results[2].rejectReason, "missing-inputs");
+    EXPECT_TRUE(mempool.Exists(good->GetHash()));
+}
+
+TEST_F(AcceptToMempoolTest, PackageTooLarge) {
+    std::vector<TransactionRef> package;
+    TransactionRef prev = CreateValidTx(MakeOutPoint(0x01, 0), 49 * COIN);
+    package.push_back(prev);
+    for (size_t i = 1; i <= MAX_PACKAGE_COUNT; ++i) {
+        prev = CreateValidTx(OutPoint(prev->GetHash(), 0), 49 * COIN - static_cast<Amount>(i) * COIN / 100);
+        package.push_back(prev);
+    }
+    
+    PackageAcceptResult result = AcceptPackage(package, mempool, *coins, 100);
+    
+    EXPECT_EQ(result.accepted, 0u);
+    EXPECT_EQ(result.results.back().rejectReason, "package-too-many-transactions");
+    EXPECT_TRUE(mempool.IsEmpty());
+}
+
+// ============================================================================
+// Mempool Persistence Tests
+// ============================================================================
+
+#include "shurium/mempool/persist.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+class MempoolPersistTest : public AcceptToMempoolTest {
+protected:
+    std::filesystem::path path;
+    
+    void SetUp() override {
+        AcceptToMempoolTest::SetUp();
+        path = std::filesystem::temp_directory_path() /
+               ("shurium_mempool_" + std::to_string(std::random_device{}()) + ".dat");
+        std::filesystem::remove(path);
+    }
+    
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+};
+
+TEST_F(MempoolPersistTest, RoundTripKeepsEntryTimes) {
+    auto parent = CreateValidTx(MakeOutPoint(0x01, 0), 49 * COIN);
+    auto child = CreateValidTx(OutPoint(parent->GetHash(), 0), 48 * COIN);
+    auto other = CreateValidTx(MakeOutPoint(0x02, 0), 99 * COIN);
+    int64_t saved = GetTime() - 600;
+    PackageAcceptResult added = AcceptPackage({child, parent, other}, mempool, *coins, 100,
+                                              nullptr, false, {saved, saved, saved});
+    ASSERT_TRUE(added.AllValid());
+    
+    MempoolPersistResult dump = DumpMempool(mempool, path);
+    ASSERT_TRUE(dump.success) << dump.error;
+    EXPECT_EQ(dump.count, 3u);
+    
+    Mempool restored;
+    MempoolPersistResult load = LoadMempool(path, restored, *coins, 100);
+    ASSERT_TRUE(load.success) << load.error;
+    EXPECT_EQ(load.count, 3u);
+    EXPECT_EQ(load.accepted, 3u);
+    ASSERT_EQ(restored.Size(), 3u);
+    EXPECT_EQ(restored.GetInfo(child->GetHash())->time, saved);
+    EXPECT_TRUE(restored.CheckConsistency());
+    
+    // Loading again finds everything already there
+    load = LoadMempool(path, restored, *coins, 100);
+    EXPECT_EQ(load.alreadyPresent, 3u);
+}
+
+TEST_F(MempoolPersistTest, LoadSkipsExpiredAndSpent) {
+    MempoolLimits limits;
+    limits.maxAge = 3600;
+    Mempool aged(limits);
+    auto old = CreateValidTx(MakeOutPoint(0x01, 0), 49 * COIN);
+    auto fresh = CreateValidTx(MakeOutPoint(0x02, 0), 99 * COIN);
+    ASSERT_EQ(AcceptPackage({old, fresh}, aged, *coins, 100, nullptr, false,
+                            {GetTime() - 7200, 0}).accepted, 2u);
+    ASSERT_TRUE(DumpMempool(aged, path).success);
+    
+    // The fresh transaction's input was spent while the node was down
+    coins->SpendCoin(MakeOutPoint(0x02, 0));
+    
+    Mempool restored(limits);
+    MempoolPersistResult load = LoadMempool(path, restored, *coins, 100);
+    ASSERT_TRUE(load.success) << load.error;
+    EXPECT_EQ(load.expired, 1u);
+    EXPECT_EQ(load.failed, 1u);
+    EXPECT_TRUE(restored.IsEmpty());
+}
+
+TEST_F(MempoolPersistTest, RejectsBadFiles) {
+    EXPECT_FALSE(LoadMempool(path, mempool, *coins, 100).success);
+    
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a mempool";
+    }
+    MempoolPersistResult load = LoadMempool(path, mempool, *coins, 100);
+    EXPECT_FALSE(load.success);
+    EXPECT_NE(load.error.find("not a mempool file"), std::string::npos);
+    
+    // A truncated file loads what it holds and reports the rest
+    auto tx = CreateValidTx(MakeOutPoint(0x01, 0), 49 * COIN);
+    ASSERT_TRUE(AcceptToMempool(tx, mempool, *coins, 100).IsValid());
+    ASSERT_TRUE(DumpMempool(mempool, path).success);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    
+    Mempool restored;
+    load = LoadMempool(path, restored, *coins, 100);
+    EXPECT_FALSE(load.success);
+    EXPECT_EQ(restored.Size(), 0u);
+}
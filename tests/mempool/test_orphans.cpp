@@ -0,0 +1,134 @@
+// SHURIUM - Orphan Transaction Pool Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/mempool/orphans.h"
+#include "shurium/core/transaction.h"
+#include "shurium/core/script.h"
+
+using namespace shurium;
+
+// ============================================================================
+// Test Utilities
+// ============================================================================
+
+class OrphanPoolTest : public ::testing::Test {
+protected:
+    static constexpr int64_t NOW = 1700000000;
+
+    TransactionRef CreateTx(const std::vector<OutPoint>& inputs, int numOutputs = 1,
+                            size_t scriptBytes = 25) {
+        MutableTransaction mtx;
+        mtx.version = 1;
+        for (const auto& input : inputs) {
+            mtx.vin.push_back(TxIn(input));
+        }
+        for (int i = 0; i < numOutputs; ++i) {
+            mtx.vout.push_back(TxOut(COIN, Script(scriptBytes, 0x51)));
+        }
+        return MakeTransactionRef(std::move(mtx));
+    }
+
+    OutPoint MakeOutPoint(uint32_t id, uint32_t n = 0) {
+        TxHash hash;
+        for (int i = 0; i < 4; ++i) {
+            hash[i] = static_cast<uint8_t>(id >> (8 * i));
+        }
+        return OutPoint(hash, n);
+    }
+};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+TEST_F(OrphanPoolTest, ChildrenComeBackWhenParentArrives) {
+    OrphanPool pool;
+    auto parent = CreateTx({MakeOutPoint(1)}, 2);
+    auto first = CreateTx({OutPoint(parent->GetHash(), 0)});
+    auto second = CreateTx({OutPoint(parent->GetHash(), 1)});
+    auto unrelated = CreateTx({MakeOutPoint(2)});
+
+    EXPECT_TRUE(pool.AddTx(first, 1, NOW));
+    EXPECT_TRUE(pool.AddTx(second, 2, NOW));
+    EXPECT_TRUE(pool.AddTx(unrelated, 1, NOW));
+    EXPECT_FALSE(pool.AddTx(first, 3, NOW));
+    EXPECT_EQ(pool.Size(), 3u);
+
+    auto children = pool.TakeChildren(*parent);
+    ASSERT_EQ(children.size(), 2u);
+    EXPECT_EQ(children[0].tx->GetHash(), first->GetHash());
+    EXPECT_EQ(children[0].fromPeer, 1);
+    EXPECT_EQ(children[1].tx->GetHash(), second->GetHash());
+    EXPECT_FALSE(pool.HaveTx(first->GetHash()));
+    EXPECT_TRUE(pool.HaveTx(unrelated->GetHash()));
+    EXPECT_TRUE(pool.TakeChildren(*parent).empty());
+}
+
+TEST_F(OrphanPoolTest, LimitsHoldPerPeerAndOverall) {
+    OrphanPool pool(10, 4);
+
+    // A peer over its limit loses its own oldest orphan
+    std::vector<TransactionRef> fromOne;
+    for (uint32_t i = 0; i < 6; ++i) {
+        fromOne.push_back(CreateTx({MakeOutPoint(100 + i)}));
+        EXPECT_TRUE(pool.AddTx(fromOne.back(), 1, NOW));
+    }
+    EXPECT_EQ(pool.CountForPeer(1), 4u);
+    EXPECT_FALSE(pool.HaveTx(fromOne[0]->GetHash()));
+    EXPECT_FALSE(pool.HaveTx(fromOne[1]->GetHash()));
+    EXPECT_TRUE(pool.HaveTx(fromOne[5]->GetHash()));
+
+    // The pool as a whole never grows past its limit
+    for (uint32_t i = 0; i < 40; ++i) {
+        EXPECT_TRUE(pool.AddTx(CreateTx({MakeOutPoint(200 + i)}), 2 + i / 4, NOW));
+        EXPECT_LE(pool.Size(), 10u);
+    }
+    EXPECT_EQ(pool.Size(), 10u);
+}
+
+TEST_F(OrphanPoolTest, LargeOrphansAreRefused) {
+    OrphanPool pool;
+    auto large = CreateTx({MakeOutPoint(1)}, 1, MAX_ORPHAN_TX_SIZE);
+    EXPECT_FALSE(pool.AddTx(large, 1, NOW));
+    EXPECT_EQ(pool.Size(), 0u);
+}
+
+TEST_F(OrphanPoolTest, OrphansExpire) {
+    OrphanPool pool;
+    auto old = CreateTx({MakeOutPoint(1)});
+    auto recent = CreateTx({MakeOutPoint(2)});
+    ASSERT_TRUE(pool.AddTx(old, 1, NOW));
+    ASSERT_TRUE(pool.AddTx(recent, 1, NOW + ORPHAN_EXPIRE_TIME / 2));
+
+    EXPECT_EQ(pool.EraseExpired(NOW + ORPHAN_EXPIRE_TIME), 1u);
+    EXPECT_FALSE(pool.HaveTx(old->GetHash()));
+    EXPECT_TRUE(pool.HaveTx(recent->GetHash()));
+
+    // Adding sweeps expired orphans too
+    ASSERT_TRUE(pool.AddTx(CreateTx({MakeOutPoint(3)}), 1, NOW + 2 * ORPHAN_EXPIRE_TIME));
+    EXPECT_EQ(pool.Size(), 1u);
+}
+
+TEST_F(OrphanPoolTest, PeerAndBlockRemoval) {
+    OrphanPool pool;
+    auto a = CreateTx({MakeOutPoint(1)});
+    auto b = CreateTx({MakeOutPoint(2)});
+    auto c = CreateTx({MakeOutPoint(3)});
+    ASSERT_TRUE(pool.AddTx(a, 1, NOW));
+    ASSERT_TRUE(pool.AddTx(b, 2, NOW));
+    ASSERT_TRUE(pool.AddTx(c, 2, NOW));
+
+    EXPECT_EQ(pool.EraseForPeer(1), 1u);
+    EXPECT_FALSE(pool.HaveTx(a->GetHash()));
+    EXPECT_EQ(pool.CountForPeer(1), 0u);
+
+    // A block spending b's input conflicts it
+    auto conflict = CreateTx({MakeOutPoint(2)}, 2);
+    EXPECT_EQ(pool.EraseForBlock({conflict}), 1u);
+    EXPECT_FALSE(pool.HaveTx(b->GetHash()));
+    EXPECT_TRUE(pool.HaveTx(c->GetHash()));
+    EXPECT_TRUE(pool.EraseTx(c->GetHash()));
+    EXPECT_EQ(pool.Size(), 0u);
+}
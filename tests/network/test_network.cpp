@@ -3,15 +3,26 @@
 
 #include <gtest/gtest.h>
 #include <shurium/network/address.h>
+#include <shurium/network/compact_block.h>
+#include <shurium/network/compression.h>
+#include <shurium/network/inventory_filter.h>
 #include <shurium/network/protocol.h>
 #include <shurium/network/peer.h>
 #include <shurium/network/message_processor.h>
 #include <shurium/network/addrman.h>
+#include <shurium/network/connection.h>
+#include <shurium/network/sync.h>
+#include <shurium/network/minisketch.h>
+#include <shurium/network/txreconciliation.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <set>
+#include <thread>
 
 namespace shurium {
 namespace {
@@ -194,6 +205,21 @@ TEST(NetAddressTest, Serialization) {
     EXPECT_EQ(*addr, addr2);
 }
 
+TEST(NetAddressTest, NetGroup) {
+    auto group = [](const std::string& str) { return NetAddress::FromString(str)->GetNetGroup(); };
+    EXPECT_EQ(group("8.8.4.4"), group("8.8.200.1"));
+    EXPECT_NE(group("8.8.4.4"), group("8.9.4.4"));
+    EXPECT_EQ(group("8.8.4.4"), (std::vector<uint8_t>{1, 8, 8}));
+    std::array<uint8_t, 16> mapped{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 8, 8, 1, 1};
+    EXPECT_EQ(NetAddress(mapped).GetNetGroup(), group("8.8.4.4"));
+    EXPECT_EQ(group("2001:db8:1::1"), group("2001:db8:ffff::2"));
+    EXPECT_NE(group("2001:db8::1"), group("2001:db9::1"));
+    
+    // Unroutable addresses share one group
+    EXPECT_EQ(group("127.0.0.1"), group("192.168.1.1"));
+    EXPECT_EQ(group("127.0.0.1"), std::vector<uint8_t>{0});
+}
+
 // ============================================================================
 // NetService Tests
 // ============================================================================
@@ -657,6 +683,78 @@ TEST(PeerTest, AnnouncementQueue) {
     EXPECT_EQ(peer->GetAnnouncementQueueSize(), 2u);
 }
 
+/// Distinct hash for each index
+Hash256 IndexHash(uint32_t i) {
+    Hash256 hash;
+    for (size_t b = 0; b < hash.size(); ++b) {
+        hash[b] = static_cast<uint8_t>((i >> (8 * (b % 4))) ^ b);
+    }
+    return hash;
+}
+
+TEST(InventoryFilterTest, RollingBloomRemembersRecentAndForgetsOld) {
+    RollingBloomFilter filter(1000, 0.000001);
+    EXPECT_EQ(filter.GetHashFunctions(), 20u);
+    EXPECT_FALSE(filter.Contains(IndexHash(0)));
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        filter.Insert(IndexHash(i));
+    }
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(filter.Contains(IndexHash(i)));
+    }
+    // Same hash under another discriminator is a different item
+    EXPECT_FALSE(filter.Contains(IndexHash(1), 1));
+
+    // Memory stays fixed while far more items pass through
+    size_t memory = filter.GetMemoryUsage();
+    for (uint32_t i = 1000; i < 20000; ++i) {
+        filter.Insert(IndexHash(i));
+    }
+    EXPECT_EQ(filter.GetMemoryUsage(), memory);
+
+    // The last 1000 are always remembered, the first ones aged out
+    for (uint32_t i = 19000; i < 20000; ++i) {
+        EXPECT_TRUE(filter.Contains(IndexHash(i)));
+    }
+    size_t oldHits = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        oldHits += filter.Contains(IndexHash(i)) ? 1 : 0;
+    }
+    EXPECT_EQ(oldHits, 0u);
+
+    // Items never inserted test as absent at about the configured rate
+    size_t falsePositives = 0;
+    for (uint32_t i = 100000; i < 200000; ++i) {
+        falsePositives += filter.Contains(IndexHash(i)) ? 1 : 0;
+    }
+    EXPECT_LE(falsePositives, 2u);
+
+    filter.Reset();
+    EXPECT_FALSE(filter.Contains(IndexHash(19999)));
+}
+
+TEST(InventoryFilterTest, BlocksAreTrackedExactly) {
+    InventoryFilter filter(1000, 0.000001, 4);
+    Inv tx(InvType::MSG_TX, IndexHash(1));
+    Inv block(InvType::MSG_BLOCK, IndexHash(1));
+
+    filter.Insert(tx);
+    EXPECT_TRUE(filter.Contains(tx));
+    EXPECT_FALSE(filter.Contains(block));
+
+    filter.Insert(block);
+    EXPECT_TRUE(filter.Contains(block));
+
+    // The exact set keeps only the most recent non-transaction items
+    for (uint32_t i = 2; i < 6; ++i) {
+        filter.Insert(Inv(InvType::MSG_BLOCK, IndexHash(i)));
+    }
+    EXPECT_FALSE(filter.Contains(block));
+    EXPECT_TRUE(filter.Contains(Inv(InvType::MSG_BLOCK, IndexHash(5))));
+    EXPECT_TRUE(filter.Contains(tx));
+}
+
 TEST(PeerTest, SendReceiveBuffers) {
     auto service = NetService::FromString("8.8.8.8:8433");
     auto peer = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
@@ -681,6 +779,135 @@ TEST(PeerTest, SendReceiveBuffers) {
     EXPECT_FALSE(peer->HasDataToSend());
 }
 
+TEST(PeerTest, SendQueueSharesMessagePayloads) {
+    auto service = NetService::FromString("8.8.8.8:8433");
+    auto first = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    auto second = Peer::CreateOutbound(2, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    
+    std::vector<uint8_t> payload(1000, 0xab);
+    OutboundMessage msg = CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK, payload);
+    first->QueueSend(msg);
+    second->QueueSend(msg);
+    EXPECT_EQ(msg.payload.use_count(), 3);
+    
+    // The wire bytes are the same as a message built in one piece
+    std::vector<uint8_t> expected = CreateMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK, payload);
+    EXPECT_EQ(first->GetSendQueueSize(), expected.size());
+    EXPECT_EQ(first->GetSendData(expected.size()), expected);
+    
+    // Taking the queue hands over the buffers themselves
+    SendQueue taken = second->TakeSendQueue();
+    EXPECT_FALSE(second->HasDataToSend());
+    SendQueue::Segment segments[4];
+    ASSERT_EQ(taken.Peek(segments, 4), 2u);
+    EXPECT_EQ(segments[0].size, MESSAGE_HEADER_SIZE);
+    EXPECT_EQ(segments[1].data, msg.payload->data());
+}
+
+TEST(PeerTest, SendQueuePartialWrites) {
+    SendQueue queue;
+    queue.Push(std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{1, 2, 3}));
+    queue.Push(std::make_shared<const std::vector<uint8_t>>());
+    queue.Push(std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{4, 5}));
+    EXPECT_EQ(queue.Size(), 5u);
+    EXPECT_EQ(queue.BufferCount(), 2u);
+    
+    // A write ending inside a buffer leaves the rest of it in place
+    queue.Consume(2);
+    SendQueue::Segment segments[4];
+    ASSERT_EQ(queue.Peek(segments, 4), 2u);
+    EXPECT_EQ(segments[0].size, 1u);
+    EXPECT_EQ(segments[0].data[0], 3);
+    EXPECT_EQ(queue.Size(), 3u);
+    
+    // Appending behind a partly sent queue keeps the order
+    SendQueue tail;
+    tail.Push(std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{6, 7}));
+    tail.Consume(1);
+    queue.Append(std::move(tail));
+    EXPECT_TRUE(tail.Empty());
+    EXPECT_EQ(queue.Pop(10), (std::vector<uint8_t>{3, 4, 5, 7}));
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ(queue.BufferCount(), 0u);
+}
+
+TEST(PeerTest, SendQueuePriorityKeepsMessagesWhole) {
+    auto buffer = [](std::vector<uint8_t> bytes) {
+        return std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+    };
+    SendQueue queue;
+    queue.Push(buffer({1, 1}), SendPriority::BULK, false);
+    queue.Push(buffer({2, 2}), SendPriority::BULK);
+    queue.Push(buffer({3}), SendPriority::BULK);
+    EXPECT_EQ(queue.Size(SendPriority::BULK), 5u);
+    
+    // Half a bulk message is out when a high priority one arrives...
+    queue.Consume(1);
+    queue.Push(buffer({9, 9}), SendPriority::HIGH);
+    EXPECT_EQ(queue.Current(), SendPriority::BULK);
+    SendQueue::Segment segments[4];
+    ASSERT_EQ(queue.Peek(segments, 4), 3u);
+    
+    // ...so it goes as soon as that message is done, ahead of the rest
+    queue.Consume(3);
+    EXPECT_EQ(queue.Current(), SendPriority::HIGH);
+    EXPECT_EQ(queue.Pop(2), (std::vector<uint8_t>{9, 9}));
+    EXPECT_EQ(queue.Current(), SendPriority::BULK);
+    EXPECT_EQ(queue.Pop(10), (std::vector<uint8_t>{3}));
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(PeerTest, ReceiveFramesMessagesAcrossChunks) {
+    auto service = NetService::FromString("8.8.8.8:8433");
+    auto peer = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    
+    std::vector<uint8_t> payload(5000);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<uint8_t>(i * 31);
+    }
+    std::vector<uint8_t> stream = CreateMessage(NetworkMagic::MAINNET, NetMsgType::VERACK, {});
+    std::vector<uint8_t> block = CreateMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK, payload);
+    stream.insert(stream.end(), block.begin(), block.end());
+    
+    // Feed it in uneven pieces that split the header and the payload
+    size_t pos = 0;
+    for (size_t chunk = 1; pos < stream.size(); chunk = chunk * 3 + 1) {
+        size_t len = std::min(chunk, stream.size() - pos);
+        peer->AddReceivedData(stream.data() + pos, len);
+        pos += len;
+    }
+    EXPECT_EQ(peer->GetReceivedMessageCount(), 2u);
+    
+    auto first = peer->GetNextMessage();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->first, NetMsgType::VERACK);
+    EXPECT_TRUE(first->second.empty());
+    
+    auto second = peer->GetNextMessage();
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->first, NetMsgType::BLOCK);
+    EXPECT_EQ(second->second, payload);
+    
+    EXPECT_FALSE(peer->GetNextMessage().has_value());
+    EXPECT_FALSE(peer->ShouldDisconnect());
+}
+
+TEST(PeerTest, ReceiveRejectsBadChecksum) {
+    auto service = NetService::FromString("8.8.8.8:8433");
+    auto peer = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    
+    std::vector<uint8_t> msg = CreateMessage(NetworkMagic::MAINNET, NetMsgType::PING,
+                                             std::vector<uint8_t>(8, 0x11));
+    msg.back() ^= 0x01;
+    peer->AddReceivedData(msg);
+    EXPECT_FALSE(peer->GetNextMessage().has_value());
+    EXPECT_TRUE(peer->ShouldDisconnect());
+    
+    // Nothing after the bad message is framed
+    peer->AddReceivedData(CreateMessage(NetworkMagic::MAINNET, NetMsgType::VERACK, {}));
+    EXPECT_EQ(peer->GetReceivedMessageCount(), 0u);
+}
+
 TEST(PeerTest, Statistics) {
     auto service = NetService::FromString("8.8.8.8:8433");
     auto peer = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
@@ -704,6 +931,289 @@ TEST(PeerTest, Statistics) {
     EXPECT_EQ(stats.messagesRecv, 2u);
 }
 
+// ============================================================================
+// Send Shaping Tests
+// ============================================================================
+
+TEST(SendShapingTest, TokenBucketRefillsAtRate) {
+    TokenBucket bucket(1000);
+    auto start = TokenBucket::Clock::now();
+    EXPECT_EQ(bucket.Available(start), 1000u);
+    
+    // Going into debt holds sending back until it is paid off
+    bucket.Consume(1500, start);
+    EXPECT_EQ(bucket.Available(start), 0u);
+    EXPECT_EQ(bucket.Available(start + std::chrono::milliseconds(500)), 0u);
+    EXPECT_EQ(bucket.Available(start + std::chrono::milliseconds(750)), 250u);
+    
+    // Savings never exceed the burst
+    EXPECT_EQ(bucket.Available(start + std::chrono::seconds(60)), 1000u);
+    
+    TokenBucket unlimited;
+    EXPECT_FALSE(unlimited.IsLimited());
+    EXPECT_EQ(unlimited.Available(start), SIZE_MAX);
+}
+
+TEST(SendShapingTest, UploadTargetCycles) {
+    UploadTarget target(10000);
+    int64_t start = 1700000000;
+    target.RecordSent(6000, start);
+    EXPECT_FALSE(target.IsReached(start + 10));
+    EXPECT_EQ(target.GetBytesLeft(start + 10), 4000u);
+    target.RecordSent(4000, start + 20);
+    EXPECT_TRUE(target.IsReached(start + 30));
+    EXPECT_EQ(target.GetTimeLeftInCycle(start + 30), UploadTarget::CYCLE_SECONDS - 30);
+    
+    // A new day starts from nothing
+    int64_t nextDay = start + UploadTarget::CYCLE_SECONDS;
+    EXPECT_FALSE(target.IsReached(nextDay));
+    EXPECT_EQ(target.GetBytesSent(nextDay), 0u);
+    
+    UploadTarget none;
+    none.RecordSent(UINT32_MAX, start);
+    EXPECT_FALSE(none.IsReached(start));
+}
+
+// ============================================================================
+// Inbound Admission Tests
+// ============================================================================
+
+NetAddress AdmissionAddress(uint8_t a, uint8_t b, uint8_t c = 1) {
+    return NetAddress(std::array<uint8_t, 4>{a, b, c, 1});
+}
+
+TEST(AdmissionTest, LimitsConnectsPerNetGroup) {
+    AdmissionOptions opts;
+    opts.groupConnectsPerMinute = 6;
+    opts.groupConnectBurst = 3;
+    InboundAdmission admission(opts);
+    auto now = InboundAdmission::Clock::now();
+    
+    // The burst, from anywhere in the /16, then nothing until it refills
+    for (uint8_t c = 0; c < 3; ++c) {
+        EXPECT_TRUE(admission.AllowConnect(AdmissionAddress(8, 8, c), now));
+    }
+    EXPECT_FALSE(admission.AllowConnect(AdmissionAddress(8, 8, 9), now));
+    EXPECT_TRUE(admission.AllowConnect(AdmissionAddress(8, 9), now));
+    EXPECT_FALSE(admission.AllowConnect(AdmissionAddress(8, 8), now + std::chrono::seconds(5)));
+    EXPECT_TRUE(admission.AllowConnect(AdmissionAddress(8, 8), now + std::chrono::seconds(10)));
+    
+    // Loopback is the operator's own
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(admission.AllowConnect(NetAddress(loopback), now));
+    }
+}
+
+TEST(AdmissionTest, PendingSlotsExpire) {
+    AdmissionOptions opts;
+    opts.maxPending = 2;
+    opts.handshakeTimeoutMs = 1000;
+    InboundAdmission admission(opts);
+    auto now = InboundAdmission::Clock::now();
+    
+    admission.AddPending(1, AdmissionAddress(8, 8), 100, now);
+    admission.AddPending(2, AdmissionAddress(9, 9), 100, now + std::chrono::milliseconds(500));
+    EXPECT_FALSE(admission.HasPendingSlot());
+    
+    // A completed handshake frees its slot and makes a candidate
+    admission.Update(1, EvictionMetrics{});
+    EXPECT_TRUE(admission.HasPendingSlot());
+    EXPECT_EQ(admission.GetCandidateCount(), 1u);
+    
+    admission.AddPending(3, AdmissionAddress(10, 10), 100, now + std::chrono::milliseconds(800));
+    EXPECT_TRUE(admission.TakeExpired(now + std::chrono::milliseconds(1000)).empty());
+    EXPECT_EQ(admission.TakeExpired(now + std::chrono::milliseconds(1600)),
+              std::vector<Peer::Id>{2});
+    EXPECT_EQ(admission.GetPendingCount(), 1u);
+    admission.Remove(3);
+    EXPECT_EQ(admission.GetPendingCount(), 0u);
+    EXPECT_TRUE(admission.TakeExpired(now + std::chrono::seconds(10)).empty());
+}
+
+TEST(AdmissionTest, EvictsNewestOfLargestGroupUnlessProtected) {
+    AdmissionOptions opts;
+    opts.protectByGroup = 0;
+    opts.protectByPing = 1;
+    opts.protectByTx = 1;
+    opts.protectByBlock = 1;
+    opts.protectByUptime = 1;
+    InboundAdmission admission(opts);
+    auto now = InboundAdmission::Clock::now();
+    EXPECT_EQ(admission.SelectForEviction(), -1);
+    
+    // Peers 1-5 share a /16, connected in order; 6 and 7 are alone
+    auto add = [&](Peer::Id id, const NetAddress& addr, const EvictionMetrics& metrics) {
+        admission.AddPending(id, addr, 1000 + id, now);
+        admission.Update(id, metrics);
+    };
+    EvictionMetrics slow;
+    slow.pingMicros = 900000;
+    for (Peer::Id id = 1; id <= 5; ++id) {
+        add(id, AdmissionAddress(8, 8, static_cast<uint8_t>(id)), slow);
+    }
+    add(6, AdmissionAddress(9, 9), slow);
+    add(7, AdmissionAddress(10, 10), slow);
+    EXPECT_EQ(admission.SelectForEviction(), 5);
+    
+    // The newest peer of the big group relays blocks; the next has the best ping
+    EvictionMetrics relaying = slow;
+    relaying.lastBlockTime = 5000;
+    admission.Update(5, relaying);
+    EvictionMetrics fast;
+    fast.pingMicros = 1000;
+    admission.Update(4, fast);
+    EXPECT_EQ(admission.SelectForEviction(), 3);
+    
+    EvictionMetrics txs = slow;
+    txs.lastTxTime = 5000;
+    admission.Update(3, txs);
+    EXPECT_EQ(admission.SelectForEviction(), 2);
+    
+    // Once the big group is down to protected peers, another gives way
+    admission.Remove(2);
+    Peer::Id next = admission.SelectForEviction();
+    EXPECT_TRUE(next == 6 || next == 7);
+    
+    // Peer 1 is protected as the longest connected
+    admission.Remove(6);
+    admission.Remove(7);
+    EXPECT_EQ(admission.SelectForEviction(), -1);
+}
+
+TEST(AdmissionTest, ProtectsOnePeerPerNetGroup) {
+    AdmissionOptions opts;
+    opts.protectByGroup = 2;
+    opts.protectByPing = 0;
+    opts.protectByTx = 0;
+    opts.protectByBlock = 0;
+    opts.protectByUptime = 0;
+    InboundAdmission admission(opts);
+    auto now = InboundAdmission::Clock::now();
+    
+    admission.AddPending(1, AdmissionAddress(8, 8), 100, now);
+    admission.AddPending(2, AdmissionAddress(9, 9), 200, now);
+    admission.Update(1, EvictionMetrics{});
+    admission.Update(2, EvictionMetrics{});
+    EXPECT_EQ(admission.SelectForEviction(), -1);
+    
+    // A second peer in either group is fair game
+    admission.AddPending(3, AdmissionAddress(8, 8, 7), 300, now);
+    admission.Update(3, EvictionMetrics{});
+    EXPECT_EQ(admission.SelectForEviction(), 3);
+}
+
+// ============================================================================
+// EventLoop Tests
+// ============================================================================
+
+/// Connect a client to an echo server on one loop and bounce a line off it
+void ExpectEventLoopEchoes(EventBackend backend) {
+    EventLoop loop(backend);
+    if (backend == DefaultEventBackend()) {
+        EXPECT_EQ(loop.GetBackend(), backend);
+    }
+    SCOPED_TRACE(EventBackendName(loop.GetBackend()));
+    
+    auto listener = Listener::Create(0);
+    ASSERT_TRUE(listener->Start());
+    std::vector<std::unique_ptr<Connection>> accepted;
+    listener->SetAcceptCallback([&](std::unique_ptr<Connection> conn) {
+        conn->SetDataCallback([](Connection& c, const uint8_t* data, size_t len) {
+            c.Send(data, len);
+        });
+        loop.AddConnection(conn.get());
+        accepted.push_back(std::move(conn));
+    });
+    loop.AddListener(listener.get());
+    
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    auto client = Connection::Create(
+        NetService(NetAddress(loopback), listener->GetListenAddress().GetPort()));
+    ASSERT_TRUE(client->Connect());
+    loop.AddConnection(client.get());
+    
+    // Queued while connecting: goes out when the connect completes
+    std::vector<uint8_t> line{'p', 'i', 'n', 'g', '\n'};
+    EXPECT_EQ(client->Send(line), line.size());
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (client->GetRecvBufferSize() < line.size() &&
+           std::chrono::steady_clock::now() < deadline) {
+        loop.Poll(10);
+    }
+    EXPECT_EQ(client->RecvAll(), line);
+    EXPECT_EQ(accepted.size(), 1u);
+    
+    loop.RemoveConnection(client.get());
+    for (auto& conn : accepted) {
+        loop.RemoveConnection(conn.get());
+    }
+    loop.RemoveListener(listener.get());
+}
+
+TEST(EventLoopTest, DefaultBackendEchoes) {
+    ExpectEventLoopEchoes(DefaultEventBackend());
+}
+
+TEST(EventLoopTest, PollBackendEchoes) {
+    ExpectEventLoopEchoes(EventBackend::POLL);
+}
+
+TEST(EventLoopTest, DeliversLargeBuffersWhole) {
+    // Large enough for zero-copy sends and for reads that fill the event
+    // loop's buffers, where the loop has an io_uring
+    EventLoop loop;
+    auto listener = Listener::Create(0);
+    ASSERT_TRUE(listener->Start());
+    std::vector<std::unique_ptr<Connection>> accepted;
+    std::vector<uint8_t> received;
+    listener->SetAcceptCallback([&](std::unique_ptr<Connection> conn) {
+        conn->SetDataCallback([&](Connection&, const uint8_t* data, size_t len) {
+            received.insert(received.end(), data, data + len);
+        });
+        loop.AddConnection(conn.get());
+        accepted.push_back(std::move(conn));
+    });
+    loop.AddListener(listener.get());
+    
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    auto client = Connection::Create(
+        NetService(NetAddress(loopback), listener->GetListenAddress().GetPort()));
+    ASSERT_TRUE(client->Connect());
+    loop.AddConnection(client.get());
+    
+    std::vector<uint8_t> payload(1 << 20);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<uint8_t>(i * 31 + (i >> 12));
+    }
+    client->Send(std::make_shared<const std::vector<uint8_t>>(payload));
+    client->Send(std::make_shared<const std::vector<uint8_t>>(payload));
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received.size() < 2 * payload.size() && std::chrono::steady_clock::now() < deadline) {
+        loop.Poll(10);
+    }
+    ASSERT_EQ(received.size(), 2 * payload.size());
+    EXPECT_TRUE(std::equal(payload.begin(), payload.end(), received.begin()));
+    EXPECT_TRUE(std::equal(payload.begin(), payload.end(), received.begin() + payload.size()));
+    
+    loop.RemoveConnection(client.get());
+    for (auto& conn : accepted) {
+        loop.RemoveConnection(conn.get());
+    }
+    loop.RemoveListener(listener.get());
+}
+
+TEST(EventLoopTest, BackendNames) {
+    EXPECT_STREQ(EventBackendName(EventBackend::POLL), "poll");
+    EXPECT_STREQ(EventBackendName(EventBackend::EPOLL), "epoll");
+    EXPECT_STREQ(EventBackendName(EventBackend::KQUEUE), "kqueue");
+#ifdef __linux__
+    EXPECT_EQ(DefaultEventBackend(), EventBackend::EPOLL);
+#endif
+}
+
 // ============================================================================
 // InvType Tests
 // ============================================================================
@@ -892,6 +1402,911 @@ TEST(MessageProcessorTest, ResetStats) {
     EXPECT_EQ(stats.messagesProcessed, 0u);
 }
 
+TEST(MessageProcessorTest, WorkersHandleHeavyMessagesOnTheirOwnLane) {
+    auto listener = Listener::Create(0);
+    ASSERT_TRUE(listener->Start());
+    
+    ConnectionManagerOptions connOpts;
+    connOpts.acceptInbound = false;
+    ConnectionManager connman(connOpts);
+    ASSERT_TRUE(connman.Start());
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    Peer::Id id = connman.ConnectTo(
+        NetService(NetAddress(loopback), listener->GetListenAddress().GetPort()));
+    ASSERT_GE(id, 0);
+    auto peer = connman.GetPeer(id);
+    ASSERT_NE(peer, nullptr);
+    
+    // Not yet established, so each is ignored once it reaches its lane
+    for (int i = 0; i < 3; ++i) {
+        peer->AddReceivedData(CreateMessage(NetworkMagic::MAINNET, NetMsgType::PING,
+                                            std::vector<uint8_t>(8, 0)));
+        peer->AddReceivedData(CreateMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK,
+                                            std::vector<uint8_t>(100, 0)));
+    }
+    
+    MessageProcessorOptions opts;
+    opts.processingIntervalMs = 5;
+    opts.workerThreads = 2;
+    MessageProcessor processor(opts);
+    processor.Initialize(&connman, nullptr);
+    ASSERT_TRUE(processor.Start());
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (processor.GetStats().messagesProcessed < 6 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    processor.Stop();
+    
+    auto stats = processor.GetStats();
+    EXPECT_EQ(stats.messagesProcessed, 6u);
+    // Pings that follow a waiting block onto its lane are not counted
+    EXPECT_EQ(stats.heavyMessages, 3u);
+    EXPECT_EQ(peer->GetReceivedMessageCount(), 0u);
+    
+    connman.Stop();
+}
+
+TEST(MessageProcessorTest, HeavyLaneKeepsEachPeersOrder) {
+    auto listener = Listener::Create(0);
+    ASSERT_TRUE(listener->Start());
+    
+    ConnectionManagerOptions connOpts;
+    connOpts.acceptInbound = false;
+    ConnectionManager connman(connOpts);
+    ASSERT_TRUE(connman.Start());
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    Peer::Id id = connman.ConnectTo(
+        NetService(NetAddress(loopback), listener->GetListenAddress().GetPort()));
+    ASSERT_GE(id, 0);
+    auto peer = connman.GetPeer(id);
+    ASSERT_NE(peer, nullptr);
+    VersionMessage ver;
+    ver.version = PROTOCOL_VERSION;
+    ASSERT_TRUE(peer->ProcessVersion(ver));
+    ASSERT_TRUE(peer->ProcessVerack());
+    
+    // Getdata for a transaction stays light and for a block goes heavy;
+    // interleave them so each light one must wait for the block before it
+    std::vector<Inv> sent;
+    for (uint8_t i = 0; i < 8; ++i) {
+        Hash256 hash;
+        hash[0] = i;
+        sent.emplace_back(i % 3 == 1 ? InvType::MSG_BLOCK : InvType::MSG_TX, hash);
+        
+        DataStream stream;
+        Serialize(stream, static_cast<uint64_t>(1));
+        sent.back().Serialize(stream);
+        std::vector<uint8_t> payload(stream.begin(), stream.end());
+        peer->AddReceivedData(CreateMessage(NetworkMagic::MAINNET, NetMsgType::GETDATA, payload));
+    }
+    
+    MessageProcessorOptions opts;
+    opts.processingIntervalMs = 5;
+    opts.workerThreads = 2;
+    MessageProcessor processor(opts);
+    processor.Initialize(&connman, nullptr);
+    std::mutex handledMutex;
+    std::vector<Inv> handled;
+    processor.SetGetDataCallback([&](Peer::Id, const Inv& inv) {
+        std::lock_guard<std::mutex> lock(handledMutex);
+        handled.push_back(inv);
+        return true;
+    });
+    ASSERT_TRUE(processor.Start());
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (processor.GetStats().messagesProcessed < sent.size() &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    processor.Stop();
+    
+    std::lock_guard<std::mutex> lock(handledMutex);
+    EXPECT_EQ(handled, sent);
+    EXPECT_EQ(processor.GetStats().heavyMessages, 3u);
+    
+    connman.Stop();
+}
+
+TEST(MessageProcessorTest, AddrTokenBucketRefillsToOneMessage) {
+    auto start = std::chrono::steady_clock::now();
+    AddrTokenBucket bucket(start);
+    EXPECT_EQ(bucket.Take(5, start), 1u);
+    EXPECT_EQ(bucket.Take(5, start), 0u);
+    
+    // Ten seconds earn one more address
+    EXPECT_EQ(bucket.Take(5, start + std::chrono::seconds(10)), 1u);
+    
+    // Saving up stops at one full message
+    EXPECT_EQ(bucket.Take(5000, start + std::chrono::hours(24)), MAX_ADDR_TO_SEND);
+    
+    // A getaddr answer is let in whole
+    bucket.Grant(MAX_ADDR_TO_SEND);
+    EXPECT_EQ(bucket.Take(MAX_ADDR_TO_SEND, start + std::chrono::hours(24)), MAX_ADDR_TO_SEND);
+}
+
+TEST(MessageProcessorTest, UnsolicitedAddrIsRateLimited) {
+    ConnectionManagerOptions listenOpts;
+    listenOpts.listenPort = 0;
+    ConnectionManager server(listenOpts);
+    ASSERT_TRUE(server.Start());
+    
+    ConnectionManagerOptions connectOpts;
+    connectOpts.acceptInbound = false;
+    ConnectionManager client(connectOpts);
+    ASSERT_TRUE(client.Start());
+    
+    MessageProcessorOptions opts;
+    opts.processingIntervalMs = 5;
+    opts.workerThreads = 0;
+    AddressManager serverAddrman("main");
+    MessageProcessor serverProcessor(opts);
+    serverProcessor.Initialize(&server, nullptr);
+    serverProcessor.SetAddressManager(&serverAddrman);
+    MessageProcessor clientProcessor(opts);
+    clientProcessor.Initialize(&client, nullptr);
+    ASSERT_TRUE(serverProcessor.Start());
+    ASSERT_TRUE(clientProcessor.Start());
+    
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    Peer::Id id = client.ConnectTo(NetService(NetAddress(loopback), server.GetListenPort()));
+    ASSERT_GE(id, 0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto peer = client.GetPeer(id);
+    ASSERT_NE(peer, nullptr);
+    while (!peer->IsEstablished() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_TRUE(peer->IsEstablished());
+    
+    // An inbound peer we never asked starts with room for one address
+    AddrMessage msg;
+    for (uint8_t i = 1; i <= 5; ++i) {
+        std::array<uint8_t, 4> ip = {8, 8, 8, i};
+        msg.addresses.emplace_back(NetService(NetAddress(ip), 8333), GetAdjustedTime(),
+                                   ServiceFlags::NETWORK);
+    }
+    peer->QueueMessage(NetMsgType::ADDR, msg);
+    while ((serverProcessor.GetStats().addrRateLimited == 0 || serverAddrman.Size() == 0) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    
+    EXPECT_EQ(serverProcessor.GetStats().addrRateLimited, 4u);
+    EXPECT_EQ(serverAddrman.Size(), 1u);
+    
+    clientProcessor.Stop();
+    serverProcessor.Stop();
+    client.Stop();
+    server.Stop();
+}
+
+TEST(MessageProcessorTest, NodesShakeHandsOverLoopback) {
+    ConnectionManagerOptions listenOpts;
+    listenOpts.listenPort = 0;
+    ConnectionManager server(listenOpts);
+    ASSERT_TRUE(server.Start());
+    ASSERT_NE(server.GetListenPort(), 0);
+    
+    ConnectionManagerOptions connectOpts;
+    connectOpts.acceptInbound = false;
+    ConnectionManager client(connectOpts);
+    ASSERT_TRUE(client.Start());
+    
+    MessageProcessorOptions opts;
+    opts.processingIntervalMs = 5;
+    opts.workerThreads = 0;
+    MessageProcessor serverProcessor(opts);
+    serverProcessor.Initialize(&server, nullptr);
+    MessageProcessor clientProcessor(opts);
+    clientProcessor.Initialize(&client, nullptr);
+    ASSERT_TRUE(serverProcessor.Start());
+    ASSERT_TRUE(clientProcessor.Start());
+    
+    uint64_t copiedBefore = GetNetworkBytesCopied();
+    std::array<uint8_t, 4> loopback = {127, 0, 0, 1};
+    // The outbound side speaks first; bytes move without anyone pumping them
+    Peer::Id id = client.ConnectTo(NetService(NetAddress(loopback), server.GetListenPort()));
+    ASSERT_GE(id, 0);
+    
+    auto established = [](const ConnectionManager& connman) {
+        auto peers = connman.GetAllPeers();
+        return peers.size() == 1 && peers[0]->IsEstablished();
+    };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!(established(client) && established(server)) &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_TRUE(established(client));
+    EXPECT_TRUE(established(server));
+    EXPECT_GT(client.GetTotalBytesSent(), 0u);
+    EXPECT_GT(GetNetworkBytesCopied(), copiedBefore);
+    
+    // A closed connection takes its peer with it on the other side
+    client.DisconnectAll();
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (server.GetPeerCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(server.GetPeerCount(), 0u);
+    
+    clientProcessor.Stop();
+    serverProcessor.Stop();
+    client.Stop();
+    server.Stop();
+}
+
+// ============================================================================
+// Compact Block Tests
+// ============================================================================
+
+// A block of distinct transactions with a matching merkle root
+Block MakeCompactTestBlock(size_t txCount) {
+    Block block;
+    block.nTime = 1700000000;
+    block.nBits = 0x207fffff;
+    for (size_t i = 0; i < txCount; ++i) {
+        MutableTransaction mtx;
+        mtx.vout.push_back(TxOut(static_cast<Amount>(1000 + i), Script()));
+        block.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+    block.hashMerkleRoot = block.ComputeMerkleRoot();
+    return block;
+}
+
+TEST(CompactBlockTest, SerializeRoundTrip) {
+    Block block = MakeCompactTestBlock(5);
+    CompactBlock cmpct(block, 42);
+    ASSERT_EQ(cmpct.prefilled.size(), 1u);
+    EXPECT_EQ(cmpct.shortIds.size(), 4u);
+    
+    DataStream stream;
+    cmpct.Serialize(stream);
+    CompactBlock decoded;
+    decoded.Unserialize(stream);
+    
+    EXPECT_EQ(decoded.header.GetHash(), block.GetHash());
+    EXPECT_EQ(decoded.nonce, 42u);
+    EXPECT_EQ(decoded.shortIds, cmpct.shortIds);
+    ASSERT_EQ(decoded.prefilled.size(), 1u);
+    EXPECT_EQ(decoded.prefilled[0].index, 0u);
+    EXPECT_EQ(decoded.prefilled[0].tx->GetHash(), block.vtx[0]->GetHash());
+    // The key is rederived from header and nonce
+    EXPECT_EQ(decoded.GetShortId(block.vtx[1]->GetHash()), cmpct.shortIds[0]);
+}
+
+TEST(CompactBlockTest, ShortIdsDependOnNonce) {
+    Block block = MakeCompactTestBlock(2);
+    CompactBlock a(block, 1);
+    CompactBlock b(block, 2);
+    EXPECT_NE(a.shortIds[0], b.shortIds[0]);
+    EXPECT_LT(a.shortIds[0], 1ULL << 48);
+}
+
+TEST(CompactBlockTest, RebuildFromKnownTransactions) {
+    Block block = MakeCompactTestBlock(4);
+    CompactBlock cmpct(block, 7);
+    
+    std::vector<TransactionRef> known(block.vtx.begin() + 1, block.vtx.end());
+    PartiallyDownloadedBlock partial;
+    ASSERT_EQ(partial.Init(cmpct, nullptr, known), CompactReadStatus::OK);
+    EXPECT_EQ(partial.GetMempoolCount(), 3u);
+    EXPECT_TRUE(partial.GetMissingIndexes().empty());
+    
+    Block rebuilt;
+    ASSERT_EQ(partial.FillBlock(rebuilt, {}), CompactReadStatus::OK);
+    EXPECT_EQ(rebuilt.GetHash(), block.GetHash());
+    ASSERT_EQ(rebuilt.vtx.size(), block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        EXPECT_EQ(rebuilt.vtx[i]->GetHash(), block.vtx[i]->GetHash());
+    }
+}
+
+TEST(CompactBlockTest, MissingTransactionsCompleteTheBlock) {
+    Block block = MakeCompactTestBlock(5);
+    CompactBlock cmpct(block, 9);
+    
+    // Only transactions 1 and 3 are known
+    PartiallyDownloadedBlock partial;
+    ASSERT_EQ(partial.Init(cmpct, nullptr, {block.vtx[1], block.vtx[3]}),
+              CompactReadStatus::OK);
+    std::vector<uint16_t> missing = partial.GetMissingIndexes();
+    ASSERT_EQ(missing, (std::vector<uint16_t>{2, 4}));
+    EXPECT_TRUE(partial.IsTxAvailable(0));
+    EXPECT_FALSE(partial.IsTxAvailable(2));
+    
+    // The request survives the wire
+    BlockTxnRequest request;
+    request.blockHash = block.GetHash();
+    request.indexes = missing;
+    DataStream stream;
+    request.Serialize(stream);
+    BlockTxnRequest decoded;
+    decoded.Unserialize(stream);
+    EXPECT_EQ(decoded.indexes, missing);
+    
+    Block rebuilt;
+    EXPECT_EQ(partial.FillBlock(rebuilt, {block.vtx[2]}), CompactReadStatus::INVALID);
+    ASSERT_EQ(partial.FillBlock(rebuilt, {block.vtx[2], block.vtx[4]}),
+              CompactReadStatus::OK);
+    EXPECT_EQ(rebuilt.GetHash(), block.GetHash());
+    
+    // Wrong transactions in the holes fail the merkle check
+    EXPECT_EQ(partial.FillBlock(rebuilt, {block.vtx[4], block.vtx[2]}),
+              CompactReadStatus::FAILED);
+}
+
+TEST(CompactBlockTest, InvalidCompactBlocksRejected) {
+    PartiallyDownloadedBlock partial;
+    EXPECT_EQ(partial.Init(CompactBlock(), nullptr), CompactReadStatus::INVALID);
+    
+    Block block = MakeCompactTestBlock(3);
+    CompactBlock cmpct(block, 3);
+    cmpct.prefilled[0].index = 10;
+    EXPECT_EQ(partial.Init(cmpct, nullptr), CompactReadStatus::INVALID);
+    
+    // Two identical short ids cannot be told apart
+    CompactBlock dup(block, 3);
+    dup.shortIds[1] = dup.shortIds[0];
+    EXPECT_EQ(partial.Init(dup, nullptr), CompactReadStatus::FAILED);
+}
+
+TEST(CompactBlockTest, SendCmpctPayloadSize) {
+    EXPECT_TRUE(ValidatePayloadSize(NetMsgType::SENDCMPCT, 9).valid);
+    EXPECT_FALSE(ValidatePayloadSize(NetMsgType::SENDCMPCT, 8).valid);
+    EXPECT_TRUE(IsValidInvType(InvType::MSG_CMPCT_BLOCK));
+}
+
+// ============================================================================
+// Set Reconciliation Tests
+// ============================================================================
+
+TEST(MinisketchTest, DecodesSymmetricDifference) {
+    Minisketch a(16);
+    Minisketch b(16);
+    for (uint32_t i = 1; i <= 50; ++i) {
+        a.Add(i * 7919);
+        b.Add(i * 7919);
+    }
+    std::vector<uint32_t> expected = {3, 0x80000001U, 0xFFFFFFFFU, 12345, 999999};
+    a.Add(3);
+    a.Add(0xFFFFFFFFU);
+    a.Add(999999);
+    b.Add(0x80000001U);
+    b.Add(12345);
+    
+    ASSERT_TRUE(a.Merge(b));
+    auto decoded = a.Decode();
+    ASSERT_TRUE(decoded.has_value());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(*decoded, expected);
+}
+
+TEST(MinisketchTest, FailsBeyondCapacity) {
+    Minisketch sketch(8);
+    for (uint32_t i = 1; i <= 20; ++i) {
+        sketch.Add(i * 104729);
+    }
+    EXPECT_FALSE(sketch.Decode().has_value());
+    EXPECT_FALSE(Minisketch(8).Merge(Minisketch(4)));
+}
+
+TEST(MinisketchTest, SerializeRoundTrip) {
+    Minisketch sketch(4);
+    sketch.Add(42);
+    sketch.Add(4242);
+    auto bytes = sketch.Serialize();
+    EXPECT_EQ(bytes.size(), 4 * MINISKETCH_ELEMENT_BYTES);
+    
+    auto copy = Minisketch::Deserialize(bytes);
+    ASSERT_TRUE(copy.has_value());
+    auto decoded = copy->Decode();
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(*decoded, (std::vector<uint32_t>{42, 4242}));
+    
+    bytes.pop_back();
+    EXPECT_FALSE(Minisketch::Deserialize(bytes).has_value());
+}
+
+// Two trackers as the two ends of one connection: a opened it to b
+void RegisterPair(TxReconciliationTracker& a, TxReconciliationTracker& b) {
+    uint64_t saltA = a.PreRegisterPeer(1);
+    uint64_t saltB = b.PreRegisterPeer(2);
+    ASSERT_EQ(a.RegisterPeer(1, false, TXRECONCILIATION_VERSION, saltB),
+              ReconRegisterResult::SUCCESS);
+    ASSERT_EQ(b.RegisterPeer(2, true, TXRECONCILIATION_VERSION, saltA),
+              ReconRegisterResult::SUCCESS);
+}
+
+TEST(TxReconciliationTest, Registration) {
+    TxReconciliationTracker a;
+    TxReconciliationTracker b;
+    EXPECT_EQ(a.RegisterPeer(1, false, 1, 0), ReconRegisterResult::NOT_FOUND);
+    RegisterPair(a, b);
+    
+    EXPECT_TRUE(a.IsInitiator(1));
+    EXPECT_FALSE(b.IsInitiator(2));
+    EXPECT_EQ(a.RegisterPeer(1, false, 1, 0), ReconRegisterResult::ALREADY_REGISTERED);
+    
+    TxHash txid(MakeHash(0x5A));
+    EXPECT_EQ(a.ComputeShortId(1, txid), b.ComputeShortId(2, txid));
+    EXPECT_NE(a.ComputeShortId(1, txid), 0u);
+    
+    a.ForgetPeer(1);
+    EXPECT_FALSE(a.IsPeerRegistered(1));
+    EXPECT_FALSE(a.AddToSet(1, txid));
+}
+
+TEST(TxReconciliationTest, ReconcilesDifferingSets) {
+    TxReconciliationTracker a;
+    TxReconciliationTracker b;
+    RegisterPair(a, b);
+    
+    std::set<TxHash> onlyA;
+    std::set<TxHash> onlyB;
+    for (uint8_t i = 0; i < 20; ++i) {
+        ASSERT_TRUE(a.AddToSet(1, TxHash(MakeHash(i))));
+        ASSERT_TRUE(b.AddToSet(2, TxHash(MakeHash(i))));
+    }
+    for (uint8_t i = 100; i < 103; ++i) {
+        onlyA.insert(TxHash(MakeHash(i)));
+        a.AddToSet(1, TxHash(MakeHash(i)));
+    }
+    for (uint8_t i = 200; i < 204; ++i) {
+        onlyB.insert(TxHash(MakeHash(i)));
+        b.AddToSet(2, TxHash(MakeHash(i)));
+    }
+    
+    // Responder only answers an initiator, and only once per round
+    EXPECT_FALSE(a.HandleReqRecon(1, ReqReconMessage()).has_value());
+    auto request = a.InitiateReconciliation(1);
+    ASSERT_TRUE(request.has_value());
+    EXPECT_EQ(request->setSize, 23);
+    EXPECT_FALSE(a.InitiateReconciliation(1).has_value());
+    
+    auto sketch = b.HandleReqRecon(2, *request);
+    ASSERT_TRUE(sketch.has_value());
+    EXPECT_EQ(b.GetSetSize(2), 0u);
+    
+    auto outcome = a.HandleSketch(1, *sketch);
+    ASSERT_TRUE(outcome.has_value());
+    EXPECT_TRUE(outcome->diff.success);
+    EXPECT_EQ(std::set<TxHash>(outcome->announce.begin(), outcome->announce.end()), onlyA);
+    EXPECT_EQ(outcome->diff.askShortIds.size(), onlyB.size());
+    EXPECT_EQ(a.GetSetSize(1), 0u);
+    
+    auto announce = b.HandleReconcilDiff(2, outcome->diff);
+    ASSERT_TRUE(announce.has_value());
+    EXPECT_EQ(std::set<TxHash>(announce->begin(), announce->end()), onlyB);
+    EXPECT_FALSE(b.HandleReconcilDiff(2, outcome->diff).has_value());
+    
+    auto stats = a.GetStats();
+    EXPECT_EQ(stats.succeeded, 1u);
+    EXPECT_EQ(stats.differences, onlyA.size() + onlyB.size());
+}
+
+TEST(TxReconciliationTest, FloodsSetsWhenDecodingFails) {
+    TxReconciliationTracker a;
+    TxReconciliationTracker b;
+    RegisterPair(a, b);
+    
+    for (int i = 0; i < 200; ++i) {
+        a.AddToSet(1, TxHash(MakeHash(static_cast<uint8_t>(i))));
+    }
+    b.AddToSet(2, TxHash(MakeHash(0xFF)));
+    
+    auto request = a.InitiateReconciliation(1);
+    ASSERT_TRUE(request.has_value());
+    auto sketch = b.HandleReqRecon(2, *request);
+    ASSERT_TRUE(sketch.has_value());
+    EXPECT_EQ(sketch->sketch.size(), MAX_SKETCH_CAPACITY * MINISKETCH_ELEMENT_BYTES);
+    
+    auto outcome = a.HandleSketch(1, *sketch);
+    ASSERT_TRUE(outcome.has_value());
+    EXPECT_FALSE(outcome->diff.success);
+    EXPECT_EQ(outcome->announce.size(), 200u);
+    
+    auto announce = b.HandleReconcilDiff(2, outcome->diff);
+    ASSERT_TRUE(announce.has_value());
+    EXPECT_EQ(announce->size(), 1u);
+    EXPECT_EQ(a.GetStats().failed, 1u);
+}
+
+TEST(TxReconciliationTest, FanoutTargets) {
+    TxReconciliationTracker tracker;
+    std::vector<Peer::Id> outbound = {1, 2, 3, 4};
+    std::vector<Peer::Id> inbound;
+    for (Peer::Id id = 10; id < 40; ++id) {
+        inbound.push_back(id);
+    }
+    
+    auto targets = tracker.GetFanoutTargets(TxHash(MakeHash(1)), outbound, inbound);
+    EXPECT_EQ(targets.size(), OUTBOUND_FANOUT_DESTINATIONS + 3);
+    EXPECT_EQ(targets, tracker.GetFanoutTargets(TxHash(MakeHash(1)), outbound, inbound));
+    EXPECT_TRUE(tracker.GetFanoutTargets(TxHash(MakeHash(1)), {}, {}).empty());
+}
+
+TEST(TxReconciliationTest, CapacityEstimate) {
+    EXPECT_EQ(EstimateSketchCapacity(0, 0, RECON_DEFAULT_Q), 0u);
+    EXPECT_EQ(EstimateSketchCapacity(10, 10, 0.0), 1u);
+    EXPECT_EQ(EstimateSketchCapacity(30, 10, 0.5), 26u);
+    EXPECT_EQ(EstimateSketchCapacity(5000, 0, 0.0), MAX_SKETCH_CAPACITY);
+}
+
+TEST(TxReconciliationTest, PayloadSizes) {
+    EXPECT_TRUE(ValidatePayloadSize(NetMsgType::SENDTXRCNCL, 12).valid);
+    EXPECT_FALSE(ValidatePayloadSize(NetMsgType::SENDTXRCNCL, 8).valid);
+    EXPECT_TRUE(ValidatePayloadSize(NetMsgType::REQRECON, 4).valid);
+    EXPECT_FALSE(ValidatePayloadSize(NetMsgType::REQRECON, 5).valid);
+    EXPECT_TRUE(ValidateCommand(NetMsgType::SKETCH).valid);
+    EXPECT_TRUE(ValidateCommand(NetMsgType::RECONCILDIFF).valid);
+}
+
+// ============================================================================
+// Compression Tests
+// ============================================================================
+
+// Repetitive, like serialized blocks: runs of structure with varying fields
+std::vector<uint8_t> MakeCompressibleBytes(size_t size) {
+    std::vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = (i % 64 < 40) ? static_cast<uint8_t>(i % 7) : static_cast<uint8_t>(i / 64);
+    }
+    return bytes;
+}
+
+TEST(CompressionTest, LZ4RoundTrip) {
+    std::vector<std::vector<uint8_t>> inputs = {
+        {},
+        {1, 2, 3},
+        std::vector<uint8_t>(13, 0x55),
+        MakeCompressibleBytes(5000),
+        MakeCompressibleBytes(300000),   // matches past the 64 KiB window
+    };
+    std::vector<uint8_t> noise(20000);
+    uint32_t x = 12345;
+    for (auto& byte : noise) {
+        x = x * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(x >> 24);
+    }
+    inputs.push_back(noise);
+    
+    for (const auto& input : inputs) {
+        auto block = LZ4Compress(input.data(), input.size());
+        auto output = LZ4Decompress(block.data(), block.size(), input.size());
+        ASSERT_TRUE(output.has_value()) << input.size();
+        EXPECT_EQ(*output, input);
+    }
+    
+    auto dense = LZ4Compress(inputs[4].data(), inputs[4].size());
+    EXPECT_LT(dense.size(), inputs[4].size() / 4);
+}
+
+TEST(CompressionTest, LZ4RejectsMalformedBlocks) {
+    auto input = MakeCompressibleBytes(2000);
+    auto block = LZ4Compress(input.data(), input.size());
+    
+    // Wrong size, cut short, or a match reaching before the start
+    EXPECT_FALSE(LZ4Decompress(block.data(), block.size(), input.size() - 1).has_value());
+    EXPECT_FALSE(LZ4Decompress(block.data(), block.size(), input.size() + 1).has_value());
+    EXPECT_FALSE(LZ4Decompress(block.data(), block.size() / 2, input.size()).has_value());
+    std::vector<uint8_t> badOffset = {0x10, 0xAA, 0x05, 0x00, 0x00};
+    EXPECT_FALSE(LZ4Decompress(badOffset.data(), badOffset.size(), 10).has_value());
+    std::vector<uint8_t> zeroOffset = {0x10, 0xAA, 0x00, 0x00, 0x00};
+    EXPECT_FALSE(LZ4Decompress(zeroOffset.data(), zeroOffset.size(), 10).has_value());
+    
+    // The stated size is bounded before anything is allocated
+    auto payload = CompressPayload(input);
+    ASSERT_TRUE(payload.has_value());
+    EXPECT_TRUE(DecompressPayload(*payload, input.size()).has_value());
+    EXPECT_FALSE(DecompressPayload(*payload, input.size() - 1).has_value());
+    EXPECT_FALSE(CompressPayload(std::vector<uint8_t>{1, 2, 3}).has_value());
+}
+
+TEST(CompressionTest, FlagSurvivesFullLengthCommands) {
+    MessageHeader header;
+    header.SetCommand("reconcildiff");
+    EXPECT_FALSE(header.IsCompressed());
+    header.SetCompressed();
+    EXPECT_TRUE(header.IsCompressed());
+    EXPECT_EQ(header.GetCommand(), "reconcildiff");
+}
+
+TEST(CompressionTest, PeersExchangeCompressedMessages) {
+    auto service = NetService::FromString("8.8.8.8:8433");
+    auto sender = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    auto receiver = Peer::CreateInbound(2, *service);
+    sender->EnableCompression(CompressionPolicy::Default());
+    receiver->AcceptCompressed();
+    EXPECT_TRUE(sender->IsCompressing());
+    
+    auto payload = MakeCompressibleBytes(20000);
+    OutboundMessage block = CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK,
+                                                  payload);
+    sender->QueueSend(block);
+    sender->QueueSend(CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::TX, payload));
+    sender->QueueMessage(NetMsgType::PING, PingMessage(7));
+    
+    // Only the block went out compressed
+    size_t rawSize = 3 * MESSAGE_HEADER_SIZE + 2 * payload.size() + 8;
+    EXPECT_LT(sender->GetSendQueueSize(), rawSize - payload.size() / 2);
+    EXPECT_GT(sender->GetStats().compressionSavedSent, payload.size() / 2);
+    
+    receiver->AddReceivedData(sender->GetSendData(sender->GetSendQueueSize()));
+    ASSERT_EQ(receiver->GetReceivedMessageCount(), 3u);
+    auto first = receiver->GetNextMessage();
+    EXPECT_EQ(first->first, NetMsgType::BLOCK);
+    EXPECT_EQ(first->second, payload);
+    EXPECT_EQ(receiver->GetNextMessage()->first, NetMsgType::TX);
+    EXPECT_EQ(receiver->GetNextMessage()->first, NetMsgType::PING);
+    EXPECT_EQ(receiver->GetStats().compressionSavedRecv,
+              sender->GetStats().compressionSavedSent);
+    EXPECT_FALSE(receiver->ShouldDisconnect());
+    
+    // A second peer reuses the compressed block
+    auto other = Peer::CreateOutbound(3, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    other->EnableCompression(CompressionPolicy::Default());
+    other->QueueSend(block);
+    EXPECT_EQ(block.compressed.use_count(), 1);
+    EXPECT_EQ(block.compressed->payload.use_count(), 2);
+}
+
+TEST(CompressionTest, UnannouncedCompressionDisconnects) {
+    auto service = NetService::FromString("8.8.8.8:8433");
+    auto sender = Peer::CreateOutbound(1, *service, ConnectionType::OUTBOUND_FULL_RELAY);
+    auto receiver = Peer::CreateInbound(2, *service);
+    sender->EnableCompression(CompressionPolicy::Default());
+    sender->QueueSend(CreateOutboundMessage(NetworkMagic::MAINNET, NetMsgType::BLOCK,
+                                            MakeCompressibleBytes(5000)));
+    
+    receiver->AddReceivedData(sender->GetSendData(sender->GetSendQueueSize()));
+    EXPECT_EQ(receiver->GetReceivedMessageCount(), 0u);
+    EXPECT_TRUE(receiver->ShouldDisconnect());
+}
+
+TEST(CompressionTest, ExpandingFrameSavesNothing) {
+    auto service = NetService::FromString("8.8.8.8:8433");
+    auto receiver = Peer::CreateInbound(2, *service);
+    receiver->AcceptCompressed();
+    
+    // Three bytes stated raw, sent as eight: the size, a token and literals
+    std::vector<uint8_t> payload = {0x03, 0x00, 0x00, 0x00, 0x30, 'a', 'b', 'c'};
+    MessageHeader header;
+    header.magic = NetworkMagic::MAINNET;
+    header.SetCommand(NetMsgType::BLOCK);
+    header.SetCompressed();
+    header.payloadSize = static_cast<uint32_t>(payload.size());
+    header.checksum = ComputeChecksum(payload);
+    DataStream frame;
+    header.Serialize(frame);
+    frame.Write(payload.data(), payload.size());
+    
+    receiver->AddReceivedData(std::vector<uint8_t>(frame.begin(), frame.end()));
+    ASSERT_EQ(receiver->GetReceivedMessageCount(), 1u);
+    EXPECT_EQ(receiver->GetNextMessage()->second, (std::vector<uint8_t>{'a', 'b', 'c'}));
+    EXPECT_EQ(receiver->GetStats().compressionSavedRecv, 0u);
+    EXPECT_FALSE(receiver->ShouldDisconnect());
+}
+
+TEST(CompressionTest, PolicyAndPayloadSize) {
+    CompressionPolicy policy = CompressionPolicy::Default();
+    EXPECT_TRUE(policy.ShouldCompress(NetMsgType::BLOCK, DEFAULT_COMPRESSION_THRESHOLD));
+    EXPECT_TRUE(policy.ShouldCompress(NetMsgType::POUWPROB, 5000));
+    EXPECT_FALSE(policy.ShouldCompress(NetMsgType::BLOCK, DEFAULT_COMPRESSION_THRESHOLD - 1));
+    EXPECT_FALSE(policy.ShouldCompress(NetMsgType::TX, 5000));
+    
+    EXPECT_TRUE(ValidatePayloadSize(NetMsgType::SENDCOMPR, 4).valid);
+    EXPECT_FALSE(ValidatePayloadSize(NetMsgType::SENDCOMPR, 0).valid);
+}
+
+// ============================================================================
+// Block Download Window Tests
+// ============================================================================
+
+// Blocks asked of each peer, read back from the getdata payloads
+struct RecordedRequests {
+    std::map<Peer::Id, std::vector<Hash256>> blocks;
+    
+    void operator()(Peer::Id peerId, const std::string& command,
+                    const std::vector<uint8_t>& payload) {
+        ASSERT_EQ(command, NetMsgType::GETDATA);
+        DataStream stream(payload);
+        uint64_t count;
+        Unserialize(stream, count);
+        for (uint64_t i = 0; i < count; ++i) {
+            Inv inv;
+            inv.Unserialize(stream);
+            blocks[peerId].push_back(inv.hash);
+        }
+    }
+};
+
+std::vector<Block> MakeDownloadBlocks(size_t count) {
+    std::vector<Block> blocks;
+    for (size_t i = 0; i < count; ++i) {
+        Block block = MakeCompactTestBlock(2);
+        block.nTime += static_cast<uint32_t>(i);
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+std::vector<Inv> BlockInvs(const std::vector<Block>& blocks) {
+    std::vector<Inv> inv;
+    for (const auto& block : blocks) {
+        inv.emplace_back(InvType::MSG_BLOCK, block.GetHash());
+    }
+    return inv;
+}
+
+TEST(BlockSynchronizerTest, RequestsStayInsideTheWindow) {
+    BlockSynchronizer sync(1024, 16, 60, 3);
+    auto requests = std::make_shared<RecordedRequests>();
+    sync.SetRequestCallback([requests](Peer::Id id, const std::string& cmd,
+                                       const std::vector<uint8_t>& payload) {
+        (*requests)(id, cmd, payload);
+    });
+    sync.Start();
+    sync.OnPeerConnected(1, 100, ServiceFlags::NETWORK);
+    sync.OnPeerConnected(2, 100, ServiceFlags::NETWORK);
+    
+    auto blocks = MakeDownloadBlocks(6);
+    sync.ProcessInv(1, BlockInvs(blocks));
+    sync.Tick();
+    EXPECT_EQ(sync.GetBlocksInFlight(), 3u);
+    
+    // The first block arriving lets the window take one more
+    sync.ProcessBlock(requests->blocks.begin()->first, blocks[0]);
+    sync.Tick();
+    EXPECT_EQ(sync.GetBlocksInFlight(), 3u);
+    
+    size_t requested = 0;
+    for (const auto& [id, hashes] : requests->blocks) {
+        requested += hashes.size();
+        for (const auto& hash : hashes) {
+            EXPECT_NE(hash, blocks[4].GetHash());
+            EXPECT_NE(hash, blocks[5].GetHash());
+        }
+    }
+    EXPECT_EQ(requested, 4u);
+}
+
+TEST(BlockSynchronizerTest, StallingBlockAskedOfAnotherPeer) {
+    BlockSynchronizer sync(1024, 16, 60, 2);
+    sync.SetStallingTimeout(std::chrono::milliseconds(0));
+    auto requests = std::make_shared<RecordedRequests>();
+    sync.SetRequestCallback([requests](Peer::Id id, const std::string& cmd,
+                                       const std::vector<uint8_t>& payload) {
+        (*requests)(id, cmd, payload);
+    });
+    sync.Start();
+    sync.OnPeerConnected(1, 100, ServiceFlags::NETWORK);
+    
+    auto blocks = MakeDownloadBlocks(3);
+    sync.ProcessInv(1, BlockInvs(blocks));
+    sync.Tick();
+    ASSERT_EQ(requests->blocks[1].size(), 2u);
+    
+    // Peer 2 sits idle behind a full window held up by peer 1
+    sync.OnPeerConnected(2, 100, ServiceFlags::NETWORK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    sync.Tick();
+    ASSERT_EQ(requests->blocks[2].size(), 1u);
+    EXPECT_EQ(requests->blocks[2][0], blocks[0].GetHash());
+    
+    auto slow = sync.GetPeerDownloadStats(1);
+    ASSERT_TRUE(slow.has_value());
+    EXPECT_EQ(slow->stalls, 1u);
+    EXPECT_EQ(slow->inFlightLimit, MIN_BLOCKS_IN_FLIGHT);
+    
+    // The faster peer delivers: both slots are freed and it is measured
+    sync.ProcessBlock(2, blocks[0]);
+    slow = sync.GetPeerDownloadStats(1);
+    auto fast = sync.GetPeerDownloadStats(2);
+    ASSERT_TRUE(fast.has_value());
+    EXPECT_EQ(slow->blocksInFlight, 1u);
+    EXPECT_EQ(fast->blocksInFlight, 0u);
+    EXPECT_EQ(fast->blocksDownloaded, 1u);
+    EXPECT_GT(fast->bytesDownloaded, 0u);
+    EXPECT_GT(fast->bytesPerSec, 0.0);
+    EXPECT_GE(fast->inFlightLimit, MIN_BLOCKS_IN_FLIGHT);
+    EXPECT_LE(fast->inFlightLimit, 16u);
+    
+    // The window moved on; the measured peer is served first
+    sync.Tick();
+    ASSERT_EQ(requests->blocks[2].size(), 2u);
+    EXPECT_EQ(requests->blocks[2][1], blocks[2].GetHash());
+}
+
+TEST(BlockSynchronizerTest, DisconnectedPeerBlocksRequeued) {
+    BlockSynchronizer sync(1024, 16, 60, 8);
+    auto requests = std::make_shared<RecordedRequests>();
+    sync.SetRequestCallback([requests](Peer::Id id, const std::string& cmd,
+                                       const std::vector<uint8_t>& payload) {
+        (*requests)(id, cmd, payload);
+    });
+    sync.Start();
+    sync.OnPeerConnected(1, 100, ServiceFlags::NETWORK);
+    
+    auto blocks = MakeDownloadBlocks(2);
+    sync.ProcessInv(1, BlockInvs(blocks));
+    sync.Tick();
+    EXPECT_EQ(sync.GetBlocksInFlight(), 2u);
+    
+    sync.OnPeerDisconnected(1);
+    EXPECT_EQ(sync.GetBlocksInFlight(), 0u);
+    EXPECT_FALSE(sync.GetPeerDownloadStats(1).has_value());
+    
+    sync.OnPeerConnected(2, 100, ServiceFlags::NETWORK);
+    sync.Tick();
+    ASSERT_EQ(requests->blocks[2].size(), 2u);
+    EXPECT_EQ(requests->blocks[2][0], blocks[0].GetHash());
+}
+
+TEST(BlockSynchronizerTest, NotFoundBlockAskedOfAnotherPeer) {
+    BlockSynchronizer sync(1024, 16, 60, 8);
+    auto requests = std::make_shared<RecordedRequests>();
+    sync.SetRequestCallback([requests](Peer::Id id, const std::string& cmd,
+                                       const std::vector<uint8_t>& payload) {
+        (*requests)(id, cmd, payload);
+    });
+    sync.Start();
+    sync.OnPeerConnected(1, 100, ServiceFlags::NETWORK);
+    sync.OnPeerConnected(2, 100, ServiceFlags::NETWORK);
+    
+    auto blocks = MakeDownloadBlocks(1);
+    sync.ProcessInv(2, BlockInvs(blocks));
+    sync.Tick();
+    ASSERT_EQ(requests->blocks[1].size(), 1u);
+    
+    // Peer 1 does not have it: the retry goes to peer 2, and only there
+    sync.ProcessNotFound(1, BlockInvs(blocks));
+    sync.Tick();
+    sync.Tick();
+    EXPECT_EQ(requests->blocks[1].size(), 1u);
+    ASSERT_EQ(requests->blocks[2].size(), 1u);
+    EXPECT_EQ(requests->blocks[2][0], blocks[0].GetHash());
+}
+
+TEST(BlockSynchronizerTest, FullHeadersMessageAsksForMoreAndQueuesBlocks) {
+    BlockSynchronizer sync(1024, 16, 60, 8);
+    auto commands = std::make_shared<std::vector<std::string>>();
+    sync.SetRequestCallback([commands](Peer::Id, const std::string& cmd,
+                                       const std::vector<uint8_t>&) {
+        commands->push_back(cmd);
+    });
+    auto blocks = MakeDownloadBlocks(3);
+    sync.SetHeaderCallback([&blocks](const std::vector<BlockHeader>& headers,
+                                     const std::vector<BlockHash>&, Peer::Id) {
+        HeadersOutcome outcome;
+        outcome.accepted = headers.size();
+        outcome.bestHeaderHeight = static_cast<int32_t>(headers.size());
+        for (const auto& block : blocks) {
+            outcome.missingBlocks.push_back(block.GetHash());
+        }
+        return outcome;
+    });
+    sync.Start();
+    sync.OnPeerConnected(1, 100, ServiceFlags::NETWORK);
+    
+    std::vector<BlockHeader> headers(MAX_HEADERS_RESULTS);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        headers[i].nTime = static_cast<uint32_t>(i);
+    }
+    EXPECT_TRUE(sync.ProcessHeaders(1, headers));
+    
+    // The next getheaders goes out before any block is asked for
+    ASSERT_FALSE(commands->empty());
+    EXPECT_EQ(commands->front(), NetMsgType::GETHEADERS);
+    
+    sync.Tick();
+    EXPECT_EQ(sync.GetBlocksInFlight(), 3u);
+    EXPECT_EQ(commands->back(), NetMsgType::GETDATA);
+}
+
 // ============================================================================
 // AddressManager Tests
 // ============================================================================
@@ -1000,6 +2415,40 @@ TEST(AddressManagerTest, AddMultipleAddresses) {
     EXPECT_EQ(addrman.NumNew(), 5u);
 }
 
+TEST(AddressManagerTest, BulkAddSkipsInvalidAndRepeats) {
+    AddressManager addrman("main");
+    
+    std::vector<PeerAddress> addrs;
+    std::array<uint8_t, 4> ip = {8, 8, 4, 4};
+    addrs.emplace_back(NetService(NetAddress(ip), 8333), GetAdjustedTime(), ServiceFlags::NETWORK);
+    addrs.emplace_back(NetService(NetAddress(ip), 8334), GetAdjustedTime(), ServiceFlags::NETWORK);
+    addrs.push_back(addrs.front());
+    std::array<uint8_t, 4> lan = {192, 168, 1, 1};
+    addrs.emplace_back(NetService(NetAddress(lan), 8333), GetAdjustedTime(), ServiceFlags::NETWORK);
+    
+    EXPECT_EQ(addrman.Add(addrs, NetService(), 0), 2u);
+    EXPECT_EQ(addrman.Size(), 2u);
+}
+
+TEST(AddressManagerTest, AddressKeysAreBinary) {
+    std::array<uint8_t, 4> ipv4 = {8, 8, 8, 8};
+    std::array<uint8_t, 16> ipv6 = {0x20, 0x01, 0x0d, 0xb8};
+    AddressKey a = GetAddressKey(NetService(NetAddress(ipv4), 8333));
+    
+    EXPECT_EQ(a, GetAddressKey(NetService(NetAddress(ipv4), 8333)));
+    EXPECT_NE(a, GetAddressKey(NetService(NetAddress(ipv4), 8334)));
+    EXPECT_NE(a, GetAddressKey(NetService(NetAddress(ipv6), 8333)));
+    
+    // Good and Attempt find IPv6 entries by the same key Add stored
+    AddressManager addrman("main");
+    ipv6[15] = 1;
+    NetService service(NetAddress(ipv6), 8333);
+    ASSERT_TRUE(addrman.Add(PeerAddress(service, GetAdjustedTime(), ServiceFlags::NETWORK),
+                            NetService(), 0));
+    addrman.Good(service);
+    EXPECT_EQ(addrman.NumTried(), 1u);
+}
+
 TEST(AddressManagerTest, SelectFromEmpty) {
     AddressManager addrman("main");
     
@@ -1112,6 +2561,33 @@ TEST(AddressManagerTest, StartStop) {
     addrman.Stop();
 }
 
+TEST(AddressManagerTest, ResolveSeedsCachesAnswers) {
+    AddressManager addrman("main");
+    addrman.SetSeeds({DNSSeed("localhost"), DNSSeed("nonexistent.invalid")});
+    addrman.SetSeedTimeout(std::chrono::milliseconds(2000));
+    addrman.Start();
+    
+    // The failing seed does not hold up the one that answers
+    auto first = addrman.ResolveSeedsSync();
+    ASSERT_FALSE(first.empty());
+    EXPECT_TRUE(addrman.GetCachedSeed("localhost").has_value());
+    EXPECT_FALSE(addrman.GetCachedSeed("nonexistent.invalid").has_value());
+    
+    // The second time the answer comes from the cache
+    auto second = addrman.ResolveSeedsSync();
+    EXPECT_EQ(second.size(), first.size());
+    
+    AddressManager uncached("main");
+    uncached.SetSeedCacheTTL(0);
+    uncached.SetSeeds({DNSSeed("localhost")});
+    uncached.Start();
+    uncached.ResolveSeedsSync();
+    EXPECT_FALSE(uncached.GetCachedSeed("localhost").has_value());
+    
+    addrman.Stop();
+    uncached.Stop();
+}
+
 // ============================================================================
 // Address Manager Persistence Tests
 // ============================================================================
@@ -1243,6 +2719,130 @@ TEST(AddressManagerTest, SaveAndLoadWithTriedAddresses) {
     std::remove(tempPath.c_str());
 }
 
+TEST(AddressManagerTest, SaveAndLoadKeepsRecordFields) {
+    std::string tempPath = "/tmp/shurium_peers_test_" + 
+                           std::to_string(std::time(nullptr)) + "_" +
+                           std::to_string(rand()) + ".dat";
+    
+    std::array<uint8_t, 16> ip6 = {0x2a, 0x01, 0x04, 0xf8, 0, 0, 0, 0,
+                                   0, 0, 0, 0, 0, 0, 0, 0x01};
+    NetService v6(NetAddress(ip6), 9333);
+    NetService source(NetAddress(std::array<uint8_t, 4>{1, 1, 1, 1}), 8333);
+    int64_t seen = GetAdjustedTime() - 100;
+    {
+        AddressManager addrman("main");
+        addrman.Add(PeerAddress(v6, seen, ServiceFlags::NETWORK | ServiceFlags::WITNESS),
+                    source);
+        addrman.Attempt(v6);
+        EXPECT_TRUE(addrman.HasUnsavedChanges());
+        EXPECT_TRUE(addrman.Save(tempPath));
+        EXPECT_FALSE(addrman.HasUnsavedChanges());
+    }
+    
+    // Records are fixed size after the header, with a checksum at the end
+    std::ifstream file(tempPath, std::ios::binary | std::ios::ate);
+    size_t headerSize = 4 + 4 + 1 + 4 + 4 + 4;  // magic, version, "main", count, record size
+    EXPECT_EQ(static_cast<size_t>(file.tellg()), headerSize + PEERS_RECORD_SIZE + 32);
+    file.close();
+    
+    AddressManager addrman("main");
+    ASSERT_TRUE(addrman.Load(tempPath));
+    EXPECT_FALSE(addrman.HasUnsavedChanges());
+    auto addrs = addrman.GetAddr();
+    ASSERT_EQ(addrs.size(), 1u);
+    EXPECT_EQ(addrs[0].ToString(), v6.ToString());
+    EXPECT_EQ(addrs[0].GetPort(), 9333);
+    EXPECT_TRUE(addrs[0].HasService(ServiceFlags::WITNESS));
+    EXPECT_EQ(addrs[0].GetTime(), seen);
+    
+    std::remove(tempPath.c_str());
+}
+
+TEST(AddressManagerTest, LoadRejectsCorruptRecords) {
+    std::string tempPath = "/tmp/shurium_peers_test_" + 
+                           std::to_string(std::time(nullptr)) + "_" +
+                           std::to_string(rand()) + ".dat";
+    {
+        AddressManager addrman("main");
+        std::array<uint8_t, 4> ip = {8, 8, 8, 8};
+        addrman.Add(PeerAddress(NetService(NetAddress(ip), 8333), GetAdjustedTime(),
+                                ServiceFlags::NETWORK), NetService());
+        ASSERT_TRUE(addrman.Save(tempPath));
+    }
+    
+    // Flip a byte inside the record
+    {
+        std::fstream file(tempPath, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(30);
+        char byte = 0x5a;
+        file.write(&byte, 1);
+    }
+    
+    AddressManager addrman("main");
+    EXPECT_FALSE(addrman.Load(tempPath));
+    EXPECT_EQ(addrman.Size(), 0u);
+    
+    std::remove(tempPath.c_str());
+}
+
+TEST(AddressManagerTest, LoadVersionOneFile) {
+    std::string tempPath = "/tmp/shurium_peers_test_" + 
+                           std::to_string(std::time(nullptr)) + "_" +
+                           std::to_string(rand()) + ".dat";
+    
+    // The variable-length layout written before version 2
+    PeerAddress addr(NetService(NetAddress(std::array<uint8_t, 4>{8, 8, 4, 4}), 8333),
+                     GetAdjustedTime(), ServiceFlags::NETWORK);
+    DataStream stream;
+    Serialize(stream, uint32_t(0x4E585052));
+    Serialize(stream, uint32_t(1));
+    Serialize(stream, std::string("main"));
+    Serialize(stream, uint32_t(1));
+    addr.Serialize(stream);
+    NetService().Serialize(stream);
+    Serialize(stream, addr.GetTime());
+    Serialize(stream, int64_t(0));
+    Serialize(stream, int64_t(0));
+    Serialize(stream, int32_t(0));
+    Serialize(stream, int32_t(1));
+    Serialize(stream, uint8_t(0x01));
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(stream.data()), stream.size());
+    }
+    
+    AddressManager addrman("main");
+    ASSERT_TRUE(addrman.Load(tempPath));
+    EXPECT_EQ(addrman.Size(), 1u);
+    EXPECT_EQ(addrman.NumTried(), 1u);
+    
+    std::remove(tempPath.c_str());
+}
+
+TEST(AddressManagerTest, PeriodicSaveWritesChanges) {
+    std::string tempPath = "/tmp/shurium_peers_test_" + 
+                           std::to_string(std::time(nullptr)) + "_" +
+                           std::to_string(rand()) + ".dat";
+    
+    AddressManager addrman("main");
+    addrman.StartPeriodicSave(tempPath, 1);
+    std::array<uint8_t, 4> ip = {8, 8, 8, 8};
+    addrman.Add(PeerAddress(NetService(NetAddress(ip), 8333), GetAdjustedTime(),
+                            ServiceFlags::NETWORK), NetService());
+    
+    for (int i = 0; i < 50 && addrman.HasUnsavedChanges(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_FALSE(addrman.HasUnsavedChanges());
+    addrman.Stop();
+    
+    AddressManager loaded("main");
+    ASSERT_TRUE(loaded.Load(tempPath));
+    EXPECT_EQ(loaded.Size(), 1u);
+    
+    std::remove(tempPath.c_str());
+}
+
 TEST(AddressManagerTest, LoadNonexistentFile) {
     AddressManager addrman("main");
     
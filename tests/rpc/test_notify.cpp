@@ -0,0 +1,312 @@
+// SHURIUM - Push Notification Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include <shurium/rpc/notify.h>
+#include <shurium/core/transaction.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace shurium;
+using namespace shurium::rpc;
+
+// ============================================================================
+// Test Utilities
+// ============================================================================
+
+namespace {
+
+/// Blocking WebSocket client for the server under test
+class WebSocketClient {
+public:
+    explicit WebSocketClient(uint16_t port) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected_ = connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    ~WebSocketClient() { close(fd_); }
+
+    bool IsConnected() const { return connected_; }
+
+    void SendRaw(const std::string& data) {
+        ASSERT_EQ(send(fd_, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+    }
+
+    /// Send the handshake for target; returns the response head
+    std::string Handshake(const std::string& target, int timeoutMs = 5000) {
+        SendRaw("GET " + target + " HTTP/1.1\r\n"
+                "Host: localhost\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                "Sec-WebSocket-Version: 13\r\n\r\n");
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (std::chrono::steady_clock::now() < deadline) {
+            size_t end = buffer_.find("\r\n\r\n");
+            if (end != std::string::npos) {
+                std::string head = buffer_.substr(0, end + 4);
+                buffer_.erase(0, end + 4);
+                return head;
+            }
+            if (!Read(deadline)) break;
+        }
+        return "";
+    }
+
+    /// Send a masked client frame
+    void SendFrame(uint8_t opcode, const std::string& payload) {
+        const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+        std::string frame;
+        frame += static_cast<char>(0x80 | opcode);
+        frame += static_cast<char>(0x80 | payload.size());
+        frame.append(reinterpret_cast<const char*>(mask), 4);
+        for (size_t i = 0; i < payload.size(); ++i) {
+            frame += static_cast<char>(payload[i] ^ mask[i & 3]);
+        }
+        SendRaw(frame);
+    }
+
+    /// Next frame's opcode and payload; false on timeout
+    bool ReadFrame(uint8_t& opcode, std::string& payload, int timeoutMs = 5000) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            if (buffer_.size() >= 2) {
+                auto byte = [&](size_t i) { return static_cast<uint8_t>(buffer_[i]); };
+                uint64_t length = byte(1) & 0x7F;
+                size_t pos = 2;
+                if (length == 126 && buffer_.size() >= 4) {
+                    length = (static_cast<uint64_t>(byte(2)) << 8) | byte(3);
+                    pos = 4;
+                } else if (length == 127 && buffer_.size() >= 10) {
+                    length = 0;
+                    for (size_t i = 2; i < 10; ++i) length = (length << 8) | byte(i);
+                    pos = 10;
+                }
+                if (length < 126 || pos > 2) {
+                    if (buffer_.size() >= pos + length) {
+                        opcode = byte(0) & 0x0F;
+                        payload = buffer_.substr(pos, static_cast<size_t>(length));
+                        buffer_.erase(0, pos + static_cast<size_t>(length));
+                        return true;
+                    }
+                }
+            }
+            if (!Read(deadline)) return false;
+        }
+    }
+
+    /// Next message as JSON; Null on timeout
+    JSONValue ReadMessage(int timeoutMs = 5000) {
+        uint8_t opcode = 0;
+        std::string payload;
+        if (!ReadFrame(opcode, payload, timeoutMs) || opcode != 0x1) {
+            return JSONValue();
+        }
+        auto message = JSONValue::TryParse(payload);
+        return message ? *message : JSONValue();
+    }
+
+private:
+    bool Read(std::chrono::steady_clock::time_point deadline) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+        pollfd pfd{fd_, POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(remaining)) <= 0) return false;
+        char buf[65536];
+        ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        buffer_.append(buf, static_cast<size_t>(n));
+        return true;
+    }
+
+    int fd_{-1};
+    bool connected_{false};
+    std::string buffer_;
+};
+
+NotificationPublisher::Options TestOptions() {
+    NotificationPublisher::Options options;
+    options.port = 0;
+    return options;
+}
+
+/// Wait until the publisher has counted the expected subscribers
+bool WaitForSubscribers(const NotificationPublisher& publisher, size_t count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (publisher.GetSubscriberCount() != count) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+Transaction MakeTestTransaction() {
+    MutableTransaction mtx;
+    mtx.vin.emplace_back();
+    mtx.vout.emplace_back();
+    mtx.vout[0].nValue = 5000;
+    return Transaction(mtx);
+}
+
+} // namespace
+
+// ============================================================================
+// Protocol Helpers
+// ============================================================================
+
+TEST(NotifyTest, AcceptKeyMatchesRFC6455) {
+    EXPECT_EQ(WebSocketAcceptKey("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST(NotifyTest, TopicNamesRoundTrip) {
+    for (size_t i = 0; i < NOTIFY_TOPIC_COUNT; ++i) {
+        NotifyTopic topic = static_cast<NotifyTopic>(i);
+        auto parsed = ParseNotifyTopic(NotifyTopicName(topic));
+        ASSERT_TRUE(parsed.has_value());
+        EXPECT_EQ(*parsed, topic);
+    }
+    EXPECT_FALSE(ParseNotifyTopic("sequence").has_value());
+}
+
+TEST(NotifyTest, FrameLengthEncoding) {
+    std::vector<uint8_t> payload(300, 'x');
+    auto small = MakeWebSocketFrame(0x1, payload.data(), 100);
+    EXPECT_EQ(small[0], 0x81);
+    EXPECT_EQ(small[1], 100);
+    EXPECT_EQ(small.size(), 102u);
+
+    auto medium = MakeWebSocketFrame(0x1, payload.data(), payload.size());
+    EXPECT_EQ(medium[1], 126);
+    EXPECT_EQ((medium[2] << 8) | medium[3], 300);
+    EXPECT_EQ(medium.size(), 304u);
+}
+
+// ============================================================================
+// Publisher
+// ============================================================================
+
+TEST(NotifyTest, SubscriberReceivesEvents) {
+    NotificationPublisher publisher(TestOptions());
+    ASSERT_TRUE(publisher.Start());
+
+    WebSocketClient client(publisher.GetPort());
+    ASSERT_TRUE(client.IsConnected());
+    std::string head = client.Handshake("/");
+    EXPECT_NE(head.find("101 Switching Protocols"), std::string::npos);
+    EXPECT_NE(head.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo="), std::string::npos);
+    ASSERT_TRUE(WaitForSubscribers(publisher, 1));
+
+    JSONValue::Object data;
+    data["epoch"] = 7;
+    publisher.PublishEvent(NotifyTopic::UBI, JSONValue(data));
+    publisher.PublishEvent(NotifyTopic::UBI, JSONValue(data));
+
+    JSONValue first = client.ReadMessage();
+    ASSERT_TRUE(first.IsObject());
+    EXPECT_EQ(first["topic"].GetString(), "ubi");
+    EXPECT_EQ(first["sequence"].GetInt(), 0);
+    EXPECT_EQ(first["data"]["epoch"].GetInt(), 7);
+    EXPECT_EQ(client.ReadMessage()["sequence"].GetInt(), 1);
+    EXPECT_EQ(publisher.GetStats(NotifyTopic::UBI).delivered.load(), 2u);
+
+    // Ping is answered with a pong carrying the same payload
+    client.SendFrame(0x9, "hi");
+    uint8_t opcode = 0;
+    std::string payload;
+    ASSERT_TRUE(client.ReadFrame(opcode, payload));
+    EXPECT_EQ(opcode, 0xA);
+    EXPECT_EQ(payload, "hi");
+
+    // Close is echoed and the subscriber goes away
+    client.SendFrame(0x8, std::string("\x03\xe8", 2));
+    ASSERT_TRUE(client.ReadFrame(opcode, payload));
+    EXPECT_EQ(opcode, 0x8);
+    EXPECT_TRUE(WaitForSubscribers(publisher, 0));
+
+    publisher.Stop();
+}
+
+TEST(NotifyTest, TopicsFilterMessages) {
+    NotificationPublisher publisher(TestOptions());
+    ASSERT_TRUE(publisher.Start());
+
+    WebSocketClient client(publisher.GetPort());
+    ASSERT_NE(client.Handshake("/?topics=hashtx").find("101"), std::string::npos);
+    ASSERT_TRUE(WaitForSubscribers(publisher, 1));
+    EXPECT_TRUE(publisher.HasSubscribers(NotifyTopic::HASHTX));
+    EXPECT_FALSE(publisher.HasSubscribers(NotifyTopic::RAWTX));
+    EXPECT_FALSE(publisher.HasSubscribers(NotifyTopic::GOVERNANCE));
+
+    publisher.PublishEvent(NotifyTopic::GOVERNANCE, JSONValue("skipped"));
+    Transaction tx = MakeTestTransaction();
+    publisher.PublishTransaction(tx);
+
+    JSONValue message = client.ReadMessage();
+    ASSERT_TRUE(message.IsObject());
+    EXPECT_EQ(message["topic"].GetString(), "hashtx");
+    EXPECT_EQ(message["data"].GetString(), tx.GetHash().ToHex());
+
+    // Nothing was built for topics nobody wants
+    EXPECT_EQ(publisher.GetStats(NotifyTopic::GOVERNANCE).published.load(), 0u);
+    EXPECT_EQ(publisher.GetStats(NotifyTopic::RAWTX).published.load(), 0u);
+    EXPECT_TRUE(client.ReadMessage(200).IsNull());
+
+    publisher.Stop();
+}
+
+TEST(NotifyTest, BadHandshakesAreRefused) {
+    NotificationPublisher publisher(TestOptions());
+    ASSERT_TRUE(publisher.Start());
+
+    WebSocketClient unknownTopic(publisher.GetPort());
+    EXPECT_NE(unknownTopic.Handshake("/?topics=nonsense").find("400"), std::string::npos);
+
+    WebSocketClient plainHTTP(publisher.GetPort());
+    plainHTTP.SendRaw("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    uint8_t opcode = 0;
+    std::string payload;
+    plainHTTP.ReadFrame(opcode, payload, 1000);
+    EXPECT_EQ(publisher.GetSubscriberCount(), 0u);
+
+    publisher.Stop();
+}
+
+TEST(NotifyTest, OverfullSubscribersDropMessages) {
+    NotificationPublisher::Options options = TestOptions();
+    options.maxQueueBytes = 256;
+    NotificationPublisher publisher(options);
+    ASSERT_TRUE(publisher.Start());
+
+    WebSocketClient client(publisher.GetPort());
+    ASSERT_NE(client.Handshake("/ubi").find("101"), std::string::npos);
+    ASSERT_TRUE(WaitForSubscribers(publisher, 1));
+
+    // Bigger than the subscriber may ever have queued, so it is dropped
+    // rather than waited for
+    publisher.PublishEvent(NotifyTopic::UBI, JSONValue(std::string(1000, 'x')));
+    publisher.PublishEvent(NotifyTopic::UBI, JSONValue("small"));
+
+    JSONValue message = client.ReadMessage();
+    ASSERT_TRUE(message.IsObject());
+    EXPECT_EQ(message["data"].GetString(), "small");
+    EXPECT_EQ(message["sequence"].GetInt(), 1);
+
+    const auto& stats = publisher.GetStats(NotifyTopic::UBI);
+    EXPECT_EQ(stats.published.load(), 2u);
+    EXPECT_EQ(stats.dropped.load(), 1u);
+    EXPECT_EQ(stats.delivered.load(), 1u);
+
+    publisher.Stop();
+}
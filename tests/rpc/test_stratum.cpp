@@ -0,0 +1,369 @@
+// SHURIUM - Stratum Server Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include <shurium/rpc/stratum.h>
+#include <shurium/chain/chainstate.h>
+#include <shurium/chain/coins.h>
+#include <shurium/consensus/params.h>
+#include <shurium/core/hex.h>
+#include <shurium/core/merkle.h>
+#include <shurium/core/serialize.h>
+#include <shurium/economics/funds.h>
+#include <shurium/mempool/mempool.h>
+#include <shurium/miner/miner.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace shurium;
+using namespace shurium::rpc;
+
+// ============================================================================
+// Test Utilities
+// ============================================================================
+
+namespace {
+
+/// Blocking line-based client for the server under test
+class StratumClient {
+public:
+    explicit StratumClient(uint16_t port) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected_ = connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    }
+
+    ~StratumClient() { close(fd_); }
+
+    bool IsConnected() const { return connected_; }
+
+    void Send(const std::string& line) {
+        std::string data = line + "\n";
+        ASSERT_EQ(send(fd_, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+    }
+
+    /// First message for which pred holds (others are kept for later
+    /// calls); Null on timeout
+    template <typename Pred>
+    JSONValue WaitFor(Pred pred, int timeoutMs = 5000) {
+        for (auto it = pending_.begin(); it != pending_.end(); ++it) {
+            if (pred(*it)) {
+                JSONValue message = *it;
+                pending_.erase(it);
+                return message;
+            }
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (std::chrono::steady_clock::now() < deadline) {
+            size_t end = buffer_.find('\n');
+            if (end != std::string::npos) {
+                std::string line = buffer_.substr(0, end);
+                buffer_.erase(0, end + 1);
+                auto message = JSONValue::TryParse(line);
+                if (message && pred(*message)) {
+                    return *message;
+                }
+                if (message) {
+                    pending_.push_back(*message);
+                }
+                continue;
+            }
+            pollfd pfd{fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 100) > 0) {
+                char chunk[4096];
+                ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    break;
+                }
+                buffer_.append(chunk, n);
+            }
+        }
+        return JSONValue();
+    }
+
+    JSONValue WaitForReply(int id) {
+        return WaitFor([id](const JSONValue& m) { return m["id"].GetInt(-1) == id; });
+    }
+
+    JSONValue WaitForMethod(const std::string& method) {
+        return WaitFor([&method](const JSONValue& m) { return m["method"].GetString() == method; });
+    }
+
+private:
+    int fd_;
+    bool connected_{false};
+    std::string buffer_;
+    std::vector<JSONValue> pending_;
+};
+
+std::string Request(int id, const std::string& method, const std::string& params) {
+    return "{\"id\":" + std::to_string(id) + ",\"method\":\"" + method +
+           "\",\"params\":" + params + "}";
+}
+
+std::string Submit(int id, const std::string& job, const std::string& extraNonce2,
+                   const std::string& nTime, const std::string& nonce) {
+    return Request(id, "mining.submit", "[\"worker\",\"" + job + "\",\"" + extraNonce2 +
+                                            "\",\"" + nTime + "\",\"" + nonce + "\"]");
+}
+
+} // namespace
+
+class StratumServerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<CoinsViewMemory> coinsDB;
+    std::unique_ptr<ChainStateManager> chainManager;
+    Mempool mempool;
+    BlockHash tipHash;
+
+    void SetUp() override {
+        // Templates pay the funds' addresses in the coinbase
+        economics::InitializeFundManager("regtest");
+
+        coinsDB = std::make_unique<CoinsViewMemory>();
+        chainManager = std::make_unique<ChainStateManager>(consensus::Params::RegTest());
+        chainManager->Initialize(coinsDB.get());
+        for (int i = 0; i < 3; ++i) {
+            ExtendTip(1700000000 + i * 30);
+        }
+    }
+
+    /// Add a header on the tip and make it the tip
+    void ExtendTip(uint32_t nTime) {
+        BlockHeader header;
+        header.nVersion = 1;
+        header.hashPrevBlock = tipHash;
+        header.nTime = nTime;
+        header.nBits = 0x207fffff;
+        BlockIndex* pindex = chainManager->ProcessBlockHeader(header);
+        ASSERT_NE(pindex, nullptr);
+        pindex->nTx = 1;
+        tipHash = header.GetHash();
+        chainManager->GetActiveChain().SetTip(pindex);
+    }
+
+    std::unique_ptr<StratumServer> StartServer(double difficulty) {
+        StratumServer::Options options;
+        options.port = 0;
+        options.difficulty = difficulty;
+        auto server = std::make_unique<StratumServer>(
+            *chainManager, mempool, consensus::Params::RegTest(), Script{OP_TRUE}, options);
+        EXPECT_TRUE(server->Start());
+        return server;
+    }
+
+    /**
+     * Search nonces the way a miner would, from the mining.notify fields
+     * alone, for a share that is (or is not) also a block.
+     */
+    std::string FindNonce(const JSONValue& job, const std::string& extraNonce1,
+                          const std::string& extraNonce2, bool wantBlock) {
+        const JSONValue& params = job["params"];
+        std::vector<uint8_t> coinbase = HexToBytes(params[2].GetString());
+        for (const std::string& part : {extraNonce1, extraNonce2, params[3].GetString()}) {
+            std::vector<uint8_t> bytes = HexToBytes(part);
+            coinbase.insert(coinbase.end(), bytes.begin(), bytes.end());
+        }
+        std::vector<Hash256> branch;
+        for (const JSONValue& hash : params[4].GetArray()) {
+            std::vector<uint8_t> bytes = HexToBytes(hash.GetString());
+            branch.emplace_back(bytes.data(), bytes.size());
+        }
+
+        BlockHeader header;
+        std::vector<uint8_t> prevHash = HexToBytes(params[1].GetString());
+        for (size_t i = 0; i < 32; ++i) {
+            header.hashPrevBlock[i] = prevHash[(i & ~size_t(3)) + 3 - (i & 3)];
+        }
+        header.nVersion = static_cast<int32_t>(std::stoul(params[5].GetString(), nullptr, 16));
+        header.nBits = static_cast<uint32_t>(std::stoul(params[6].GetString(), nullptr, 16));
+        header.nTime = static_cast<uint32_t>(std::stoul(params[7].GetString(), nullptr, 16));
+        header.hashMerkleRoot = ComputeMerkleRootFromPath(DoubleSHA256(coinbase), 0, branch);
+
+        Hash256 target = consensus::CompactToBig(header.nBits);
+        for (header.nNonce = 0; header.nNonce < 1000; ++header.nNonce) {
+            Hash256 hash(header.GetHash().data(), 32);
+            if (miner::Miner::MeetsTarget(hash, target) == wantBlock) {
+                char nonce[9];
+                std::snprintf(nonce, sizeof(nonce), "%08x", header.nNonce);
+                return nonce;
+            }
+        }
+        ADD_FAILURE() << "no nonce found";
+        return "";
+    }
+
+    /// Subscribe and authorize; returns the first job
+    JSONValue Login(StratumClient& client, std::string& extraNonce1) {
+        client.Send(Request(1, "mining.subscribe", "[\"test/1.0\"]"));
+        JSONValue reply = client.WaitForReply(1);
+        EXPECT_TRUE(reply["error"].IsNull());
+        extraNonce1 = reply["result"][1].GetString();
+        EXPECT_EQ(reply["result"][2].GetInt(), static_cast<int64_t>(STRATUM_EXTRANONCE2_SIZE));
+
+        client.Send(Request(2, "mining.authorize", "[\"worker\",\"x\"]"));
+        EXPECT_TRUE(client.WaitForReply(2)["result"].GetBool());
+        return client.WaitForMethod("mining.notify");
+    }
+};
+
+// ============================================================================
+// Jobs
+// ============================================================================
+
+TEST(StratumJobTest, DifficultyTargets) {
+    EXPECT_EQ(StratumDifficultyToTarget(1.0), consensus::CompactToBig(0x1d00ffff));
+
+    // Twice the difficulty halves the target
+    Hash256 half = StratumDifficultyToTarget(2.0);
+    EXPECT_EQ(half, consensus::CompactToBig(0x1c7fff80));
+
+    // Difficulties below the easiest target saturate
+    Hash256 easiest = StratumDifficultyToTarget(1e-12);
+    for (size_t i = 0; i < easiest.size(); ++i) {
+        EXPECT_EQ(easiest[i], 0xff);
+    }
+}
+
+TEST_F(StratumServerTest, JobSplitsTheCoinbaseAroundTheExtranonce) {
+    miner::BlockAssembler assembler(chainManager->GetActiveChainState(), mempool,
+                                    consensus::Params::RegTest());
+    auto tmpl = std::make_shared<const miner::BlockTemplate>(
+        assembler.CreateNewBlock(Script{OP_TRUE}));
+    ASSERT_TRUE(tmpl->isValid);
+
+    StratumJob job;
+    ASSERT_TRUE(MakeStratumJob("1", tmpl, job));
+
+    std::vector<uint8_t> coinbase = job.coinb1;
+    std::vector<uint8_t> extraNonce{1, 2, 3, 4, 5, 6, 7, 8};
+    coinbase.insert(coinbase.end(), extraNonce.begin(), extraNonce.end());
+    coinbase.insert(coinbase.end(), job.coinb2.begin(), job.coinb2.end());
+
+    DataStream stream(coinbase);
+    MutableTransaction tx;
+    Unserialize(stream, tx);
+    EXPECT_EQ(stream.size(), 0u);
+
+    // Only the extranonce push differs from the template's coinbase
+    const Transaction& original = *tmpl->block.vtx[0];
+    const Script& scriptSig = tx.vin[0].scriptSig;
+    ASSERT_GE(scriptSig.size(), 9u);
+    EXPECT_EQ(scriptSig[scriptSig.size() - 9], 8);
+    EXPECT_TRUE(std::equal(extraNonce.begin(), extraNonce.end(), scriptSig.end() - 8));
+    EXPECT_EQ(tx.vout.size(), original.vout.size());
+    EXPECT_EQ(tx.vin[0].prevout, original.vin[0].prevout);
+
+    JSONValue params = job.ToNotifyParams();
+    ASSERT_EQ(params.Size(), 9u);
+    EXPECT_EQ(params[0].GetString(), "1");
+    EXPECT_EQ(params[6].GetString(), "207fffff");
+}
+
+// ============================================================================
+// Server
+// ============================================================================
+
+TEST_F(StratumServerTest, ServesSharesOverTcp) {
+    auto server = StartServer(1e-12);
+    StratumClient first(server->GetPort());
+    StratumClient second(server->GetPort());
+    ASSERT_TRUE(first.IsConnected());
+    ASSERT_TRUE(second.IsConnected());
+
+    // Every connection gets its own extranonce1
+    std::string extraNonce1;
+    std::string otherExtraNonce1;
+    JSONValue job = Login(first, extraNonce1);
+    Login(second, otherExtraNonce1);
+    EXPECT_EQ(extraNonce1.size(), 2 * STRATUM_EXTRANONCE1_SIZE);
+    EXPECT_NE(extraNonce1, otherExtraNonce1);
+    EXPECT_EQ(server->GetClientCount(), 2u);
+
+    ASSERT_TRUE(job["params"].IsArray());
+    std::string jobId = job["params"][0].GetString();
+    std::string nTime = job["params"][7].GetString();
+
+    // Shares that are not blocks leave the job open
+    std::string nonce = FindNonce(job, extraNonce1, "00000001", false);
+    first.Send(Submit(3, jobId, "00000001", nTime, nonce));
+    JSONValue reply = first.WaitForReply(3);
+    EXPECT_TRUE(reply["result"].GetBool());
+    EXPECT_TRUE(reply["error"].IsNull());
+
+    // The same share again, and one for a job that was never sent
+    first.Send(Submit(4, jobId, "00000001", nTime, nonce));
+    EXPECT_EQ(first.WaitForReply(4)["error"][0].GetInt(),
+              static_cast<int>(StratumError::DUPLICATE_SHARE));
+    first.Send(Submit(5, "ffffffff", "00000001", nTime, nonce));
+    EXPECT_EQ(first.WaitForReply(5)["error"][0].GetInt(),
+              static_cast<int>(StratumError::JOB_NOT_FOUND));
+
+    // The other miner's extranonce2 is inside its own extranonce1
+    std::string otherNonce = FindNonce(job, otherExtraNonce1, "00000001", false);
+    second.Send(Submit(3, jobId, "00000001", nTime, otherNonce));
+    EXPECT_TRUE(second.WaitForReply(3)["result"].GetBool());
+
+    EXPECT_EQ(server->GetStats().sharesAccepted.load(), 2u);
+    EXPECT_EQ(server->GetStats().sharesRejected.load(), 2u);
+    EXPECT_EQ(server->GetStats().blocksFound.load(), 0u);
+
+    // A share meeting the block target is submitted as a block
+    std::atomic<bool> found{false};
+    server->SetBlockFoundCallback([&found](const Block&, bool) { found = true; });
+    first.Send(Submit(6, jobId, "00000002", nTime, FindNonce(job, extraNonce1, "00000002", true)));
+    EXPECT_TRUE(first.WaitForReply(6)["result"].GetBool());
+    EXPECT_EQ(server->GetStats().blocksFound.load(), 1u);
+    EXPECT_TRUE(found.load());
+    server->Stop();
+}
+
+TEST_F(StratumServerTest, RefusesLowDifficultyAndUnauthorizedShares) {
+    auto server = StartServer(1e12);
+    StratumClient client(server->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+
+    client.Send(Submit(1, "00000000", "00000000", "00000000", "00000000"));
+    EXPECT_EQ(client.WaitForReply(1)["error"][0].GetInt(),
+              static_cast<int>(StratumError::NOT_SUBSCRIBED));
+
+    std::string extraNonce1;
+    JSONValue job = Login(client, extraNonce1);
+    client.Send(Submit(3, job["params"][0].GetString(), "00000000",
+                       job["params"][7].GetString(), "00000000"));
+    EXPECT_EQ(client.WaitForReply(3)["error"][0].GetInt(),
+              static_cast<int>(StratumError::LOW_DIFFICULTY));
+}
+
+TEST_F(StratumServerTest, NewTipPushesACleanJob) {
+    auto server = StartServer(1e-12);
+    StratumClient client(server->GetPort());
+    ASSERT_TRUE(client.IsConnected());
+    std::string extraNonce1;
+    JSONValue first = Login(client, extraNonce1);
+    std::string firstJob = first["params"][0].GetString();
+
+    ExtendTip(1700000100);
+    server->NotifyNewTip();
+    JSONValue pushed = client.WaitForMethod("mining.notify");
+    ASSERT_TRUE(pushed["params"].IsArray());
+    EXPECT_NE(pushed["params"][0].GetString(), firstJob);
+    EXPECT_NE(pushed["params"][1].GetString(), first["params"][1].GetString());
+    EXPECT_TRUE(pushed["params"][8].GetBool());
+
+    // Work on the old tip is stale
+    client.Send(Submit(3, firstJob, "00000000", first["params"][7].GetString(), "00000000"));
+    EXPECT_EQ(client.WaitForReply(3)["error"][0].GetInt(),
+              static_cast<int>(StratumError::JOB_NOT_FOUND));
+}
@@ -4,11 +4,17 @@
 
 #include <gtest/gtest.h>
 #include "shurium/script/interpreter.h"
+#include "shurium/script/profile.h"
+#include "shurium/script/pubkeycache.h"
+#include "shurium/script/scriptcache.h"
+#include "shurium/script/sigcache.h"
 #include "shurium/core/script.h"
 #include "shurium/core/transaction.h"
 #include "shurium/crypto/keys.h"
 #include "shurium/crypto/sha256.h"
 #include "shurium/crypto/ripemd160.h"
+#include <cstring>
+#include <random>
 #include <vector>
 
 using namespace shurium;
@@ -667,6 +673,111 @@ TEST(InterpreterTest, CheckSig_WrongKey) {
     EXPECT_FALSE(result);
 }
 
+// ============================================================================
+// Precomputed Signature Hash Tests
+// ============================================================================
+
+/// A transaction with distinct inputs, scripts, sequences and outputs
+static Transaction CreateMultiInputTransaction(size_t inputs, size_t outputs) {
+    MutableTransaction mtx;
+    mtx.version = 2;
+    mtx.nLockTime = 77;
+    for (size_t i = 0; i < inputs; ++i) {
+        TxHash prev;
+        prev[0] = static_cast<uint8_t>(i + 1);
+        mtx.vin.emplace_back(OutPoint(prev, static_cast<uint32_t>(i)));
+        mtx.vin.back().scriptSig << std::vector<uint8_t>(i + 1, 0xAB);
+        mtx.vin.back().nSequence = 0xFFFFFFF0 + static_cast<uint32_t>(i);
+    }
+    for (size_t i = 0; i < outputs; ++i) {
+        Script script;
+        script << std::vector<uint8_t>(20, static_cast<uint8_t>(i));
+        mtx.vout.emplace_back(Amount(1000 * (i + 1)), script);
+    }
+    return Transaction(mtx);
+}
+
+TEST(SignatureHashTest, PrecomputedMatchesLegacy) {
+    Transaction tx = CreateMultiInputTransaction(5, 3);
+    PrecomputedTransactionData txdata(tx);
+    ASSERT_TRUE(txdata.ready);
+    
+    // A code separator exercises the scriptCode rewrite on both paths
+    Script scriptCode;
+    scriptCode << OP_DUP << OP_CODESEPARATOR << std::vector<uint8_t>(20, 0x11) << OP_CHECKSIG;
+    
+    const uint8_t hashTypes[] = {
+        SIGHASH_ALL, SIGHASH_NONE, SIGHASH_SINGLE, 0,
+        SIGHASH_ALL | SIGHASH_ANYONECANPAY, SIGHASH_SINGLE | SIGHASH_ANYONECANPAY,
+    };
+    for (unsigned int nIn = 0; nIn < tx.vin.size(); ++nIn) {
+        for (uint8_t hashType : hashTypes) {
+            EXPECT_EQ(SignatureHash(tx, nIn, scriptCode, hashType, 0, SigVersion::BASE, &txdata),
+                      SignatureHash(tx, nIn, scriptCode, hashType))
+                << "input " << nIn << " hash type " << int(hashType);
+        }
+    }
+}
+
+TEST(SignatureHashTest, ScriptCodeSignedReencoded) {
+    Transaction tx = CreateMultiInputTransaction(3, 2);
+    PrecomputedTransactionData txdata(tx);
+    
+    // A 5-byte push with a PUSHDATA1 prefix is signed as a direct push
+    Script nonMinimal{OP_DUP, OP_PUSHDATA1, 5, 1, 2, 3, 4, 5, OP_CODESEPARATOR, OP_EQUAL};
+    Script minimal{OP_DUP, 5, 1, 2, 3, 4, 5, OP_EQUAL};
+    for (SigVersion sigversion : {SigVersion::BASE, SigVersion::LINEAR}) {
+        Hash256 expected = SignatureHash(tx, 1, minimal, SIGHASH_ALL, 0, sigversion);
+        EXPECT_EQ(SignatureHash(tx, 1, nonMinimal, SIGHASH_ALL, 0, sigversion), expected);
+        EXPECT_EQ(SignatureHash(tx, 1, nonMinimal, SIGHASH_ALL, 0, sigversion, &txdata), expected);
+    }
+}
+
+TEST(SignatureHashTest, LinearCommitsToAmountAndInput) {
+    Transaction tx = CreateMultiInputTransaction(4, 2);
+    PrecomputedTransactionData txdata(tx);
+    Script scriptCode = Script::CreateP2PKH(Hash160());
+    
+    for (uint8_t hashType : {uint8_t(SIGHASH_ALL), uint8_t(SIGHASH_NONE), uint8_t(SIGHASH_SINGLE),
+                             uint8_t(SIGHASH_ALL | SIGHASH_ANYONECANPAY)}) {
+        Hash256 linear = SignatureHash(tx, 1, scriptCode, hashType, 5000,
+                                       SigVersion::LINEAR, &txdata);
+        // The digests are only a cache
+        EXPECT_EQ(linear, SignatureHash(tx, 1, scriptCode, hashType, 5000, SigVersion::LINEAR));
+        EXPECT_NE(linear, SignatureHash(tx, 1, scriptCode, hashType, 5001,
+                                        SigVersion::LINEAR, &txdata));
+        EXPECT_NE(linear, SignatureHash(tx, 2, scriptCode, hashType, 5000,
+                                        SigVersion::LINEAR, &txdata));
+        EXPECT_NE(linear, SignatureHash(tx, 1, scriptCode, hashType, 5000));
+    }
+}
+
+TEST(SignatureHashTest, CheckerSelectsVersionFromFlags) {
+    KeyPair keyPair = KeyPair::Generate(true);
+    Script scriptPubKey = Script::CreateP2PKH(keyPair.GetPublicKey().GetHash160());
+    Transaction tx = CreateMultiInputTransaction(3, 2);
+    PrecomputedTransactionData txdata(tx);
+    const Amount amount = 1000;
+    
+    auto makeScriptSig = [&](SigVersion sigversion) {
+        Hash256 sighash = SignatureHash(tx, 2, scriptPubKey, SIGHASH_ALL, amount, sigversion);
+        std::vector<uint8_t> signature = keyPair.GetPrivateKey().Sign(sighash);
+        signature.push_back(SIGHASH_ALL);
+        Script scriptSig;
+        scriptSig << signature << keyPair.GetPublicKey().ToVector();
+        return scriptSig;
+    };
+    Script legacySig = makeScriptSig(SigVersion::BASE);
+    Script linearSig = makeScriptSig(SigVersion::LINEAR);
+    
+    TransactionSignatureChecker checker(&tx, 2, amount, txdata);
+    ScriptFlags linear = ScriptFlags::VERIFY_LINEAR_SIGHASH;
+    EXPECT_TRUE(VerifyScript(legacySig, scriptPubKey, ScriptFlags::VERIFY_NONE, checker));
+    EXPECT_FALSE(VerifyScript(linearSig, scriptPubKey, ScriptFlags::VERIFY_NONE, checker));
+    EXPECT_TRUE(VerifyScript(linearSig, scriptPubKey, linear, checker));
+    EXPECT_FALSE(VerifyScript(legacySig, scriptPubKey, linear, checker));
+}
+
 // ============================================================================
 // IsValidPubKey Tests
 // ============================================================================
@@ -708,3 +819,504 @@ TEST(InterpreterTest, IsCompressedPubKey) {
     uncompressed[0] = 0x04;
     EXPECT_FALSE(IsCompressedPubKey(uncompressed));
 }
+
+// ============================================================================
+// Signature Cache Tests
+// ============================================================================
+
+TEST(SignatureCacheTest, InsertAndContains) {
+    SignatureCache cache(64 * 1024);
+    
+    Hash256 sighash;
+    sighash[0] = 0x11;
+    std::vector<uint8_t> pubkey(33, 0x02);
+    std::vector<uint8_t> sig(71, 0x30);
+    
+    Hash256 entry = cache.ComputeEntry(sighash, pubkey, sig);
+    EXPECT_FALSE(cache.Contains(entry));
+    
+    cache.Insert(entry);
+    EXPECT_TRUE(cache.Contains(entry));
+    
+    // A different signature maps to a different entry
+    sig[5] = 0x31;
+    EXPECT_FALSE(cache.Contains(cache.ComputeEntry(sighash, pubkey, sig)));
+    
+    SignatureCache::Stats stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.inserts, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_GT(stats.capacity, 0u);
+    EXPECT_LE(stats.memoryUsage, 64u * 1024);
+}
+
+TEST(SignatureCacheTest, SaltedPerInstance) {
+    SignatureCache cache1(4096);
+    SignatureCache cache2(4096);
+    
+    Hash256 sighash;
+    std::vector<uint8_t> pubkey(33, 0x03);
+    std::vector<uint8_t> sig(70, 0x30);
+    
+    EXPECT_NE(cache1.ComputeEntry(sighash, pubkey, sig),
+              cache2.ComputeEntry(sighash, pubkey, sig));
+}
+
+TEST(SignatureCacheTest, FixedCapacityEvicts) {
+    SignatureCache cache(4096);
+    size_t capacity = cache.GetStats().capacity;
+    
+    for (size_t i = 0; i < capacity * 4; ++i) {
+        Hash256 sighash;
+        std::memcpy(sighash.data(), &i, sizeof(i));
+        cache.Insert(cache.ComputeEntry(sighash, {}, {}));
+    }
+    
+    EXPECT_LE(cache.GetStats().entries, capacity);
+    
+    cache.Clear();
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+    EXPECT_EQ(cache.GetStats().inserts, 0u);
+}
+
+TEST(SignatureCacheTest, CheckerStoresAndReuses) {
+    KeyPair keyPair = KeyPair::Generate(true);
+    const PublicKey& pubKey = keyPair.GetPublicKey();
+    
+    MutableTransaction mtx = CreateTestTransaction();
+    Script scriptPubKey = Script::CreateP2PKH(pubKey.GetHash160());
+    mtx.vout[0].scriptPubKey = scriptPubKey;
+    Transaction tx(mtx);
+    
+    Hash256 sighash = SignatureHash(tx, 0, scriptPubKey, SIGHASH_ALL);
+    std::vector<uint8_t> signature = keyPair.GetPrivateKey().Sign(sighash);
+    signature.push_back(SIGHASH_ALL);
+    
+    Script scriptSig;
+    scriptSig << signature;
+    scriptSig << pubKey.ToVector();
+    
+    SignatureCache cache(64 * 1024);
+    
+    // Lookup-only checker (block validation) does not populate the cache
+    TransactionSignatureChecker readOnly(&tx, 0, 1000, &cache, false);
+    EXPECT_TRUE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_NONE, readOnly));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+    
+    // Storing checker (mempool) records the verified signature
+    TransactionSignatureChecker storing(&tx, 0, 1000, &cache, true);
+    EXPECT_TRUE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_NONE, storing));
+    EXPECT_EQ(cache.GetStats().entries, 1u);
+    
+    // Next verification is served from the cache
+    uint64_t hitsBefore = cache.GetStats().hits;
+    EXPECT_TRUE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_NONE, readOnly));
+    EXPECT_EQ(cache.GetStats().hits, hitsBefore + 1);
+}
+
+TEST(SignatureCacheTest, InvalidSignatureNotCached) {
+    KeyPair keyPair1 = KeyPair::Generate(true);
+    KeyPair keyPair2 = KeyPair::Generate(true);
+    
+    MutableTransaction mtx = CreateTestTransaction();
+    Script scriptPubKey = Script::CreateP2PKH(keyPair1.GetPublicKey().GetHash160());
+    mtx.vout[0].scriptPubKey = scriptPubKey;
+    Transaction tx(mtx);
+    
+    Hash256 sighash = SignatureHash(tx, 0, scriptPubKey, SIGHASH_ALL);
+    std::vector<uint8_t> signature = keyPair2.GetPrivateKey().Sign(sighash);
+    signature.push_back(SIGHASH_ALL);
+    
+    Script scriptSig;
+    scriptSig << signature;
+    scriptSig << keyPair1.GetPublicKey().ToVector();
+    
+    SignatureCache cache(64 * 1024);
+    TransactionSignatureChecker storing(&tx, 0, 1000, &cache, true);
+    EXPECT_FALSE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_NONE, storing));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+TEST(SignatureCacheTest, ResplitPubkeyAndSignatureMisses) {
+    KeyPair keyPair = KeyPair::Generate(true);
+    std::vector<uint8_t> pubkey = keyPair.GetPublicKey().ToVector();
+    
+    // P2SH around a bare OP_CHECKSIG, so the pushes are not tied to a key
+    Script redeem;
+    redeem << OP_CHECKSIG;
+    std::vector<uint8_t> redeemBytes(redeem.begin(), redeem.end());
+    Script scriptPubKey = Script::CreateP2SH(Hash160FromData(redeem));
+    
+    MutableTransaction mtx = CreateTestTransaction();
+    Transaction tx(mtx);
+    Hash256 sighash = SignatureHash(tx, 0, redeem, SIGHASH_ALL);
+    std::vector<uint8_t> signature = keyPair.GetPrivateKey().Sign(sighash);
+    signature.push_back(SIGHASH_ALL);
+    
+    Script scriptSig;
+    scriptSig << signature << pubkey << redeemBytes;
+    
+    SignatureCache cache(64 * 1024);
+    TransactionSignatureChecker storing(&tx, 0, 1000, &cache, true);
+    ASSERT_TRUE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_P2SH, storing));
+    ASSERT_EQ(cache.GetStats().entries, 1u);
+    
+    // Same bytes, split differently: the key takes the signature's first
+    // bytes. Block flags do not enforce strict encoding, so only the key
+    // check before the lookup and the length-prefixed entry reject it.
+    const size_t k = 5;
+    std::vector<uint8_t> longKey = pubkey;
+    longKey.insert(longKey.end(), signature.begin(), signature.begin() + k);
+    std::vector<uint8_t> shortSig(signature.begin() + k, signature.end());
+    Script resplit;
+    resplit << shortSig << longKey << redeemBytes;
+    
+    TransactionSignatureChecker readOnly(&tx, 0, 1000, &cache, false);
+    uint64_t hitsBefore = cache.GetStats().hits;
+    EXPECT_FALSE(VerifyScript(resplit, scriptPubKey, ScriptFlags::MANDATORY_VERIFY_FLAGS,
+                              readOnly));
+    EXPECT_EQ(cache.GetStats().hits, hitsBefore);
+    
+    std::vector<uint8_t> sigBody(signature.begin(), signature.end() - 1);
+    std::vector<uint8_t> shortBody(shortSig.begin(), shortSig.end() - 1);
+    EXPECT_NE(cache.ComputeEntry(sighash, pubkey, sigBody),
+              cache.ComputeEntry(sighash, longKey, shortBody));
+}
+
+// ============================================================================
+// Public Key Cache Tests
+// ============================================================================
+
+TEST(PubKeyCacheTest, SecondParseHits) {
+    PubKeyCache cache(1024);
+    std::vector<uint8_t> pubkey = KeyPair::Generate(true).GetPublicKey().ToVector();
+    
+    secp256k1::ParsedPublicKey expected, parsed;
+    ASSERT_TRUE(secp256k1::ParsePublicKey(expected, pubkey.data(), pubkey.size()));
+    
+    ASSERT_TRUE(cache.Parse(pubkey.data(), pubkey.size(), parsed));
+    EXPECT_EQ(parsed.xy, expected.xy);
+    parsed = {};
+    ASSERT_TRUE(cache.Parse(pubkey.data(), pubkey.size(), parsed));
+    EXPECT_EQ(parsed.xy, expected.xy);
+    
+    PubKeyCache::Stats stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.inserts, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_DOUBLE_EQ(stats.HitRate(), 0.5);
+}
+
+TEST(PubKeyCacheTest, InvalidAndUncompressedKeysNotCached) {
+    PubKeyCache cache(1024);
+    secp256k1::ParsedPublicKey parsed;
+    
+    // x >= p does not parse, and is not remembered either
+    std::vector<uint8_t> invalid(33, 0xff);
+    invalid[0] = 0x02;
+    EXPECT_FALSE(cache.Parse(invalid.data(), invalid.size(), parsed));
+    EXPECT_FALSE(cache.Parse(invalid.data(), invalid.size(), parsed));
+    EXPECT_EQ(cache.GetStats().misses, 2u);
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+    
+    // Uncompressed keys need no square root and skip the cache
+    std::vector<uint8_t> uncompressed = KeyPair::Generate(false).GetPublicKey().ToVector();
+    ASSERT_EQ(uncompressed.size(), 65u);
+    EXPECT_TRUE(cache.Parse(uncompressed.data(), uncompressed.size(), parsed));
+    EXPECT_EQ(cache.GetStats().misses, 2u);
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+TEST(PubKeyCacheTest, BoundedLeastRecentlyUsed) {
+    // Two keys per shard
+    PubKeyCache cache(2 * PubKeyCache::SHARDS);
+    secp256k1::ParsedPublicKey parsed;
+    std::vector<uint8_t> hot = KeyPair::Generate(true).GetPublicKey().ToVector();
+    ASSERT_TRUE(cache.Parse(hot.data(), hot.size(), parsed));
+    
+    // A key used between every insert stays at the front of its shard
+    for (int i = 0; i < 200; ++i) {
+        std::vector<uint8_t> cold = KeyPair::Generate(true).GetPublicKey().ToVector();
+        ASSERT_TRUE(cache.Parse(cold.data(), cold.size(), parsed));
+        uint64_t hits = cache.GetStats().hits;
+        ASSERT_TRUE(cache.Parse(hot.data(), hot.size(), parsed));
+        EXPECT_EQ(cache.GetStats().hits, hits + 1) << "evicted after " << i;
+    }
+    
+    PubKeyCache::Stats stats = cache.GetStats();
+    EXPECT_LE(stats.entries, stats.capacity);
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_EQ(stats.inserts, stats.entries + stats.evictions);
+    
+    cache.Clear();
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+    EXPECT_EQ(cache.GetStats().hits, 0u);
+}
+
+TEST(PubKeyCacheTest, CheckerUsesSharedCache) {
+    KeyPair keyPair = KeyPair::Generate(true);
+    const PublicKey& pubKey = keyPair.GetPublicKey();
+    
+    MutableTransaction mtx = CreateTestTransaction();
+    Script scriptPubKey = Script::CreateP2PKH(pubKey.GetHash160());
+    mtx.vout[0].scriptPubKey = scriptPubKey;
+    Transaction tx(mtx);
+    
+    Hash256 sighash = SignatureHash(tx, 0, scriptPubKey, SIGHASH_ALL);
+    std::vector<uint8_t> signature = keyPair.GetPrivateKey().Sign(sighash);
+    signature.push_back(SIGHASH_ALL);
+    
+    Script scriptSig;
+    scriptSig << signature;
+    scriptSig << pubKey.ToVector();
+    
+    // No signature cache, so both checks reach the curve code
+    TransactionSignatureChecker checker(&tx, 0, 1000);
+    EXPECT_TRUE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_NONE, checker));
+    uint64_t hits = GetPubKeyCache().GetStats().hits;
+    EXPECT_TRUE(VerifyScript(scriptSig, scriptPubKey, ScriptFlags::VERIFY_NONE, checker));
+    EXPECT_GT(GetPubKeyCache().GetStats().hits, hits);
+    
+    // A cached key still rejects a signature from another key
+    Script wrongSig;
+    std::vector<uint8_t> otherSig = KeyPair::Generate(true).GetPrivateKey().Sign(sighash);
+    otherSig.push_back(SIGHASH_ALL);
+    wrongSig << otherSig;
+    wrongSig << pubKey.ToVector();
+    EXPECT_FALSE(VerifyScript(wrongSig, scriptPubKey, ScriptFlags::VERIFY_NONE, checker));
+}
+
+// ============================================================================
+// Script Execution Cache Tests
+// ============================================================================
+
+TEST(ScriptExecutionCacheTest, KeyedOnTxidAndFlags) {
+    ScriptExecutionCache cache(64 * 1024);
+    
+    TxHash txid;
+    txid[0] = 0x42;
+    
+    Hash256 entry = cache.ComputeEntry(txid, ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    EXPECT_FALSE(cache.Contains(entry));
+    
+    cache.Insert(entry);
+    EXPECT_TRUE(cache.Contains(entry));
+    
+    // The same transaction under other flags is a different entry
+    EXPECT_FALSE(cache.Contains(cache.ComputeEntry(txid, ScriptFlags::STANDARD_VERIFY_FLAGS)));
+    
+    ScriptExecutionCache::Stats stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.inserts, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_LE(stats.memoryUsage, 64u * 1024);
+}
+
+TEST(ScriptExecutionCacheTest, SaltedPerInstance) {
+    ScriptExecutionCache cache1(4096);
+    ScriptExecutionCache cache2(4096);
+    
+    TxHash txid;
+    EXPECT_NE(cache1.ComputeEntry(txid, ScriptFlags::VERIFY_P2SH),
+              cache2.ComputeEntry(txid, ScriptFlags::VERIFY_P2SH));
+}
+
+TEST(ScriptExecutionCacheTest, FlagChangeInvalidates) {
+    ScriptExecutionCache cache(4096);
+    EXPECT_EQ(cache.GetActiveFlags(), ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    
+    TxHash txid;
+    txid[0] = 0x01;
+    Hash256 entry = cache.ComputeEntry(txid, ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    cache.Insert(entry);
+    
+    // Unchanged flags keep the entries
+    cache.SetActiveFlags(ScriptFlags::MANDATORY_VERIFY_FLAGS);
+    EXPECT_TRUE(cache.Contains(entry));
+    EXPECT_EQ(cache.GetStats().invalidations, 0u);
+    
+    // A new flag set drops everything
+    ScriptFlags newFlags = ScriptFlags::VERIFY_P2SH | ScriptFlags::VERIFY_CHECKLOCKTIMEVERIFY;
+    cache.SetActiveFlags(newFlags);
+    EXPECT_EQ(cache.GetActiveFlags(), newFlags);
+    EXPECT_FALSE(cache.Contains(entry));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+    EXPECT_EQ(cache.GetStats().invalidations, 1u);
+}
+
+TEST(ScriptExecutionCacheTest, FixedCapacity) {
+    ScriptExecutionCache cache(4096);
+    size_t capacity = cache.GetStats().capacity;
+    
+    for (size_t i = 0; i < capacity * 4; ++i) {
+        TxHash txid;
+        std::memcpy(txid.data(), &i, sizeof(i));
+        cache.Insert(cache.ComputeEntry(txid, ScriptFlags::VERIFY_P2SH));
+    }
+    
+    ScriptExecutionCache::Stats stats = cache.GetStats();
+    EXPECT_LE(stats.entries, capacity);
+    EXPECT_EQ(stats.capacity, capacity);
+}
+
+// ============================================================================
+// Standard Template Fast Path Tests
+// ============================================================================
+
+TEST(ScriptTemplateTest, MatchScriptTemplate) {
+    KeyPair compressed = KeyPair::Generate(true);
+    KeyPair uncompressed = KeyPair::Generate(false);
+    Hash160 hash = compressed.GetPublicKey().GetHash160();
+    
+    Span<const uint8_t> solution;
+    Script p2pkh = Script::CreateP2PKH(hash);
+    EXPECT_EQ(MatchScriptTemplate(p2pkh, &solution), ScriptTemplate::P2PKH);
+    EXPECT_EQ(std::vector<uint8_t>(solution.begin(), solution.end()),
+              std::vector<uint8_t>(hash.begin(), hash.end()));
+    EXPECT_EQ(MatchScriptTemplate(Script::CreateP2SH(hash)), ScriptTemplate::P2SH);
+    
+    for (const KeyPair* key : {&compressed, &uncompressed}) {
+        std::vector<uint8_t> pubkey = key->GetPublicKey().ToVector();
+        Script p2pk;
+        p2pk << pubkey << OP_CHECKSIG;
+        EXPECT_EQ(MatchScriptTemplate(p2pk, &solution), ScriptTemplate::P2PK);
+        EXPECT_EQ(std::vector<uint8_t>(solution.begin(), solution.end()), pubkey);
+    }
+    
+    // A 34-byte push is no key; a trailing opcode breaks the pattern
+    Script wrongSize;
+    wrongSize << std::vector<uint8_t>(34, 0x02) << OP_CHECKSIG;
+    EXPECT_EQ(MatchScriptTemplate(wrongSize), ScriptTemplate::NONSTANDARD);
+    Script extra = p2pkh;
+    extra << OP_NOP;
+    EXPECT_EQ(MatchScriptTemplate(extra), ScriptTemplate::NONSTANDARD);
+}
+
+/// Push data the way Script::operator<< would not: always with PUSHDATA1
+static void PushNonMinimal(Script& script, const std::vector<uint8_t>& data) {
+    script.push_back(OP_PUSHDATA1);
+    script.push_back(static_cast<uint8_t>(data.size()));
+    script.insert(script.end(), data.begin(), data.end());
+}
+
+TEST(ScriptTemplateTest, FastPathMatchesInterpreter) {
+    std::mt19937 rng(20241);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    
+    KeyPair keys[] = {KeyPair::Generate(true), KeyPair::Generate(false)};
+    Transaction tx = CreateMultiInputTransaction(3, 2);
+    PrecomputedTransactionData txdata(tx);
+    const Amount amount = 5000;
+    const uint8_t hashTypes[] = {
+        SIGHASH_ALL, SIGHASH_NONE, SIGHASH_SINGLE, SIGHASH_ALL | SIGHASH_ANYONECANPAY, 0x00, 0x80,
+    };
+    
+    size_t passed = 0;
+    for (int iteration = 0; iteration < 1500; ++iteration) {
+        const KeyPair& key = keys[pick(2)];
+        std::vector<uint8_t> pubkey = key.GetPublicKey().ToVector();
+        ScriptFlags flags = static_cast<ScriptFlags>(rng() & ((1U << 11) - 1));
+        unsigned int nIn = static_cast<unsigned int>(pick(tx.vin.size()));
+        uint8_t hashType = hashTypes[pick(sizeof(hashTypes))];
+        
+        // P2PK, P2PKH, or P2SH around a P2PK or P2PKH redeem script
+        size_t shape = pick(4);
+        Script inner;
+        if (shape == 0 || shape == 2) {
+            inner << pubkey << OP_CHECKSIG;
+        } else {
+            inner = Script::CreateP2PKH(key.GetPublicKey().GetHash160());
+        }
+        Script scriptPubKey = shape < 2 ? inner : Script::CreateP2SH(Hash160FromData(inner));
+        
+        Hash256 sighash = SignatureHash(tx, nIn, inner, hashType, amount, GetSigVersion(flags));
+        std::vector<uint8_t> signature = key.GetPrivateKey().Sign(sighash);
+        signature.push_back(hashType);
+        
+        // Mutate to reach the failure paths and the shapes that are deferred
+        size_t mutation = pick(10);
+        if (mutation == 0) {
+            signature[pick(signature.size())] ^= static_cast<uint8_t>(1 + pick(255));
+        } else if (mutation == 1) {
+            signature.clear();
+        } else if (mutation == 2) {
+            pubkey[pick(pubkey.size())] ^= static_cast<uint8_t>(1 + pick(255));
+        }
+        
+        Script scriptSig;
+        if (mutation == 3) {
+            PushNonMinimal(scriptSig, signature);
+        } else {
+            scriptSig << signature;
+        }
+        if (shape == 1 || shape == 3) {
+            scriptSig << pubkey;
+        }
+        if (shape >= 2) {
+            scriptSig << std::vector<uint8_t>(inner.begin(), inner.end());
+        }
+        if (mutation == 4) {
+            scriptSig << OP_NOP;
+        } else if (mutation == 5) {
+            scriptSig << std::vector<uint8_t>{0x01, 0x00};
+        } else if (mutation == 6 && !scriptSig.empty()) {
+            scriptSig.resize(pick(scriptSig.size()));
+        } else if (mutation == 7) {
+            scriptPubKey[pick(scriptPubKey.size())] ^= static_cast<uint8_t>(1 + pick(255));
+        }
+        
+        TransactionSignatureChecker checker(&tx, nIn, amount, txdata);
+        ScriptError fastError = ScriptError::UNKNOWN;
+        ScriptError genericError = ScriptError::UNKNOWN;
+        bool fast = VerifyScript(scriptSig, scriptPubKey, flags, checker, &fastError);
+        bool generic = VerifyScriptGeneric(scriptSig, scriptPubKey, flags, checker, &genericError);
+        
+        ASSERT_EQ(fast, generic) << "iteration " << iteration;
+        ASSERT_EQ(fastError, genericError)
+            << "iteration " << iteration << ": " << ScriptErrorString(fastError)
+            << " vs " << ScriptErrorString(genericError);
+        
+        // A scriptSig decoded beforehand verifies the same through both
+        DecodedScript decodedSig(scriptSig);
+        ScriptError decodedError = ScriptError::UNKNOWN;
+        ASSERT_EQ(VerifyScript(decodedSig, scriptPubKey, flags, checker, &decodedError), fast)
+            << "iteration " << iteration;
+        ASSERT_EQ(decodedError, fastError) << "iteration " << iteration;
+        ASSERT_EQ(VerifyScriptGeneric(decodedSig, scriptPubKey, flags, checker, &decodedError), fast)
+            << "iteration " << iteration;
+        ASSERT_EQ(decodedError, fastError) << "iteration " << iteration;
+        passed += fast;
+    }
+    
+    // Enough valid spends that the fast paths' success cases are covered
+    EXPECT_GT(passed, 300u);
+}
+
+// ============================================================================
+// Script Profile Tests
+// ============================================================================
+
+TEST(ScriptProfileTest, CountsOpcodesWhenCompiledIn) {
+    ResetScriptProfile();
+    
+    Script script;
+    script << OP_1 << OP_DUP << OP_DROP << OP_DUP << OP_DROP;
+    std::vector<std::vector<uint8_t>> stack;
+    DummySignatureChecker checker;
+    ASSERT_TRUE(EvalScript(stack, script, ScriptFlags::VERIFY_NONE, checker));
+    
+    ScriptProfile profile = GetScriptProfile();
+    uint64_t expected = ScriptProfilingEnabled() ? 2 : 0;
+    EXPECT_EQ(profile.opcodes[OP_DUP].executions, expected);
+    EXPECT_EQ(profile.opcodes[OP_DROP].executions, expected);
+    EXPECT_EQ(profile.opcodes[OP_1].executions, expected / 2);
+    EXPECT_EQ(profile.opcodes[OP_CHECKSIG].executions, 0u);
+    
+    ResetScriptProfile();
+    EXPECT_EQ(GetScriptProfile().opcodes[OP_DUP].executions, 0u);
+    EXPECT_EQ(ScriptProfileOpName(0x14), "PUSH_20");
+    EXPECT_EQ(ScriptProfileOpName(OP_DUP), "OP_DUP");
+}
@@ -0,0 +1,154 @@
+// SHURIUM - Script Evaluation Stack Tests
+// Copyright (c) 2024 SHURIUM Developers
+// MIT License
+
+#include <gtest/gtest.h>
+#include "shurium/script/interpreter.h"
+#include "shurium/script/scriptstack.h"
+#include "shurium/core/script.h"
+#include "shurium/core/transaction.h"
+#include "shurium/crypto/keys.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+using namespace shurium;
+
+// ============================================================================
+// Allocation Counting
+// ============================================================================
+
+// Every scalar and array new in this test binary goes through here
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// ============================================================================
+// Stack Element Tests
+// ============================================================================
+
+TEST(ScriptStackTest, ShortElementsAreInline) {
+    ScriptArena arena;
+    ScriptStack stack(arena);
+
+    std::vector<uint8_t> sig(StackElement::INLINE_SIZE, 0x30);
+    std::vector<uint8_t> big(MAX_SCRIPT_ELEMENT_SIZE, 0x42);
+    stack.push_back(Span<const uint8_t>(sig));
+    stack.push_back(Span<const uint8_t>(big));
+    stack.push_back(Span<const uint8_t>());
+
+    ASSERT_EQ(stack.size(), 3u);
+    EXPECT_EQ(stack[0].ToVector(), sig);
+    EXPECT_EQ(stack[1].ToVector(), big);
+    EXPECT_TRUE(stack[2].empty());
+
+    // The inline value lives in the element, the long one in the arena
+    const uint8_t* element = reinterpret_cast<const uint8_t*>(&stack[0]);
+    EXPECT_GE(stack[0].data(), element);
+    EXPECT_LT(stack[0].data(), element + sizeof(StackElement));
+    EXPECT_FALSE(stack[1].data() >= reinterpret_cast<const uint8_t*>(&stack[1]) &&
+                 stack[1].data() < reinterpret_cast<const uint8_t*>(&stack[1] + 1));
+    EXPECT_EQ(arena.HeapBytes(), 0u);
+}
+
+TEST(ScriptStackTest, CopiesShareTheArena) {
+    ScriptArena arena;
+    ScriptStack stack(arena);
+    std::vector<uint8_t> big(200, 0x17);
+    stack.push_back(Span<const uint8_t>(big));
+
+    ScriptStack copy = stack;
+    stack.pop_back();
+    stack.push_back(Span<const uint8_t>(std::vector<uint8_t>{1, 2, 3}));
+
+    ASSERT_EQ(copy.size(), 1u);
+    EXPECT_EQ(copy[0].ToVector(), big);
+    EXPECT_EQ(&copy.arena(), &arena);
+    EXPECT_EQ(stack.ToVectors(), (std::vector<std::vector<uint8_t>>{{1, 2, 3}}));
+}
+
+TEST(ScriptStackTest, TopEraseAndInsert) {
+    ScriptArena arena;
+    ScriptStack stack(arena);
+    stack.Assign({{1}, {2}, {3}, {4}});
+
+    EXPECT_EQ(stack.top(-1)[0], 4);
+    EXPECT_EQ(stack.top(-4)[0], 1);
+    EXPECT_THROW(stack.top(-5), std::out_of_range);
+    EXPECT_THROW(stack.top(0), std::out_of_range);
+
+    stack.erase(1, 3);
+    stack.insert(1, stack.top(-1));
+    EXPECT_EQ(stack.ToVectors(), (std::vector<std::vector<uint8_t>>{{1}, {4}, {4}}));
+
+    stack.clear();
+    EXPECT_THROW(stack.pop_back(), std::runtime_error);
+}
+
+TEST(ScriptStackTest, DeepStacksGrowIntoTheHeap) {
+    ScriptArena arena;
+    ScriptStack stack(arena);
+
+    // Slots for a thousand elements do not fit the arena's own buffer
+    for (int i = 0; i < MAX_STACK_SIZE; ++i) {
+        uint8_t value = static_cast<uint8_t>(i);
+        stack.push_back(Span<const uint8_t>(&value, 1));
+    }
+    EXPECT_GT(arena.HeapBytes(), 0u);
+    for (int i = 0; i < MAX_STACK_SIZE; ++i) {
+        ASSERT_EQ(stack[i].size(), 1u);
+        EXPECT_EQ(stack[i][0], static_cast<uint8_t>(i));
+    }
+}
+
+// ============================================================================
+// Allocation-Free Verification
+// ============================================================================
+
+TEST(ScriptStackTest, P2PKHVerifiesWithoutAllocating) {
+    KeyPair keyPair = KeyPair::Generate(true);
+    Script scriptPubKey = Script::CreateP2PKH(keyPair.GetPublicKey().GetHash160());
+
+    MutableTransaction mtx;
+    mtx.version = 2;
+    for (uint32_t i = 0; i < 3; ++i) {
+        TxHash prev;
+        prev[0] = static_cast<uint8_t>(i + 1);
+        mtx.vin.emplace_back(OutPoint(prev, i));
+    }
+    mtx.vout.emplace_back(Amount(1000), scriptPubKey);
+    Transaction tx(mtx);
+    PrecomputedTransactionData txdata(tx);
+
+    Hash256 sighash = SignatureHash(tx, 1, scriptPubKey, SIGHASH_ALL);
+    std::vector<uint8_t> signature = keyPair.GetPrivateKey().Sign(sighash);
+    signature.push_back(SIGHASH_ALL);
+    Script scriptSig;
+    scriptSig << signature << keyPair.GetPublicKey().ToVector();
+
+    TransactionSignatureChecker checker(&tx, 1, 1000, txdata);
+    ScriptFlags flags = ScriptFlags::STANDARD_VERIFY_FLAGS;
+    ScriptError error;
+
+    // The first verification puts the key in the public key cache
+    ASSERT_TRUE(VerifyScript(scriptSig, scriptPubKey, flags, checker, &error))
+        << ScriptErrorString(error);
+
+    size_t before = g_allocations.load();
+    bool result = VerifyScript(scriptSig, scriptPubKey, flags, checker, &error);
+    size_t allocations = g_allocations.load() - before;
+
+    EXPECT_TRUE(result) << ScriptErrorString(error);
+    EXPECT_EQ(allocations, 0u);
+}
@@ -4,8 +4,11 @@
 
 #include <gtest/gtest.h>
 #include <shurium/staking/staking.h>
+#include <shurium/staking/stakingdb.h>
 #include <shurium/crypto/keys.h>
 
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -213,6 +216,36 @@ TEST_F(StakingTest, ValidatorRecordBlockProducedAndMissed) {
     EXPECT_NEAR(validator.GetMissedBlocksPercent(), 9.09, 0.1);  // 10/110
 }
 
+TEST_F(StakingTest, LivenessWindowMatchesSlidingVector) {
+    const size_t capacity = 130;  // Not a multiple of the word size
+    LivenessWindow window(capacity);
+    std::vector<bool> expected;
+    uint32_t state = 7;
+    
+    for (int block = 0; block < 1000; ++block) {
+        state = state * 1103515245 + 12345;
+        bool missed = ((state >> 16) % 3) == 0;
+        window.Record(missed);
+        expected.push_back(missed);
+        if (expected.size() > capacity) {
+            expected.erase(expected.begin());
+        }
+        
+        ASSERT_EQ(window.Size(), expected.size());
+        ASSERT_EQ(window.MissedCount(),
+                  static_cast<size_t>(std::count(expected.begin(), expected.end(), true)));
+        if (block % 97 == 0) {
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQ(window.Get(i), expected[i]) << "block " << block << " bit " << i;
+            }
+        }
+    }
+    
+    window.Clear();
+    EXPECT_TRUE(window.Empty());
+    EXPECT_EQ(window.MissedCount(), 0);
+}
+
 TEST_F(StakingTest, ValidatorGetHash) {
     Validator v1 = CreateTestValidator(0, MIN_VALIDATOR_STAKE, "Test1");
     Validator v2 = CreateTestValidator(0, MIN_VALIDATOR_STAKE, "Test1");
@@ -448,6 +481,56 @@ TEST_F(StakingTest, ValidatorSetGetNextProposer) {
     EXPECT_TRUE(validatorSet.ValidatorExists(p2));
 }
 
+TEST_F(StakingTest, ProposerScheduleMatchesCumulativeScan) {
+    std::vector<std::pair<ValidatorId, Amount>> validators;
+    for (int i = 0; i < 37; ++i) {
+        std::array<Byte, 20> data{};
+        data[0] = static_cast<Byte>(i * 7 % 37);
+        validators.emplace_back(ValidatorId(data), (i % 5 == 0) ? 0 : (i * 13 % 11 + 1) * COIN);
+    }
+    
+    ProposerSchedule schedule;
+    schedule.Rebuild(validators);
+    ASSERT_EQ(schedule.Size(), validators.size());
+    
+    auto expectMatchesScan = [&]() {
+        auto sorted = validators;
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        Amount total = 0;
+        for (const auto& [id, stake] : sorted) {
+            total += stake;
+        }
+        ASSERT_EQ(schedule.GetTotalStake(), total);
+        
+        for (Amount position = 0; position < total; position += COIN / 2) {
+            Amount cumulative = 0;
+            ValidatorId expected;
+            for (const auto& [id, stake] : sorted) {
+                cumulative += stake;
+                if (position < cumulative) {
+                    expected = id;
+                    break;
+                }
+            }
+            ASSERT_EQ(schedule.Select(position), expected) << "position " << position;
+        }
+    };
+    
+    expectMatchesScan();
+    
+    // Point updates, including dropping a stake to zero and raising one from zero
+    validators[3].second = 40 * COIN;
+    EXPECT_TRUE(schedule.UpdateStake(validators[3].first, validators[3].second));
+    validators[5].second = 2 * COIN;
+    EXPECT_TRUE(schedule.UpdateStake(validators[5].first, validators[5].second));
+    validators[36].second = 0;
+    EXPECT_TRUE(schedule.UpdateStake(validators[36].first, validators[36].second));
+    expectMatchesScan();
+    
+    EXPECT_FALSE(schedule.UpdateStake(CreateTestValidatorId(0), COIN));
+}
+
 // ============================================================================
 // StakingPool Tests
 // ============================================================================
@@ -516,6 +599,38 @@ TEST_F(StakingTest, StakingPoolUndelegate) {
     EXPECT_EQ(delegation->amount, 500 * COIN);
 }
 
+TEST_F(StakingTest, StakingPoolUnbondingCompletesAtHeight) {
+    auto& validatorSet = engine_->GetValidatorSet();
+    auto& pool = engine_->GetStakingPool();
+    
+    Validator validator = CreateTestValidator(0, MIN_VALIDATOR_STAKE, "Node1");
+    auto signature = SignValidator(validator, 0);
+    validatorSet.RegisterValidator(validator, signature);
+    
+    std::vector<Byte> delegatorSig(64, 0x01);
+    auto early = pool.Delegate(CreateTestAddress(10), validator.id, 1000 * COIN, delegatorSig);
+    auto late = pool.Delegate(CreateTestAddress(11), validator.id, 1000 * COIN, delegatorSig);
+    ASSERT_TRUE(early.has_value());
+    ASSERT_TRUE(late.has_value());
+    
+    pool.ProcessBlock(10);
+    EXPECT_TRUE(pool.Undelegate(*early, 1000 * COIN, delegatorSig));
+    pool.ProcessBlock(20);
+    EXPECT_TRUE(pool.Undelegate(*late, 1000 * COIN, delegatorSig));
+    EXPECT_EQ(pool.GetDelegation(*early)->status, DelegationStatus::Unbonding);
+    
+    pool.ProcessBlock(10 + UNBONDING_PERIOD - 1);
+    EXPECT_EQ(pool.GetDelegation(*early)->status, DelegationStatus::Unbonding);
+    
+    pool.ProcessBlock(10 + UNBONDING_PERIOD);
+    EXPECT_EQ(pool.GetDelegation(*early)->status, DelegationStatus::Completed);
+    EXPECT_EQ(pool.GetDelegation(*late)->status, DelegationStatus::Unbonding);
+    
+    // Skipping past a completion height still completes it
+    pool.ProcessBlock(30 + UNBONDING_PERIOD);
+    EXPECT_EQ(pool.GetDelegation(*late)->status, DelegationStatus::Completed);
+}
+
 TEST_F(StakingTest, StakingPoolGetDelegationsByDelegator) {
     auto& validatorSet = engine_->GetValidatorSet();
     auto& pool = engine_->GetStakingPool();
@@ -555,6 +670,50 @@ TEST_F(StakingTest, StakingPoolGetTotalDelegated) {
     EXPECT_EQ(pool.GetTotalDelegated(validator.id), 3000 * COIN);
 }
 
+TEST_F(StakingTest, StakingPoolRewardsAccrueLazily) {
+    auto& validatorSet = engine_->GetValidatorSet();
+    auto& pool = engine_->GetStakingPool();
+    
+    Validator validator = CreateTestValidator(0, MIN_VALIDATOR_STAKE, "Node1");
+    auto signature = SignValidator(validator, 0);
+    validatorSet.RegisterValidator(validator, signature);
+    
+    std::vector<Byte> delegatorSig(64, 0x01);
+    auto first = pool.Delegate(CreateTestAddress(10), validator.id, 1000 * COIN, delegatorSig);
+    auto second = pool.Delegate(CreateTestAddress(11), validator.id, 3000 * COIN, delegatorSig);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(second.has_value());
+    
+    // Split 1:3 by shares
+    pool.DistributeRewards(validator.id, 40 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*first), 10 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*second), 30 * COIN);
+    EXPECT_EQ(pool.GetDelegation(*first)->pendingRewards, 10 * COIN);
+    
+    // A later delegation earns only from later rewards
+    auto third = pool.Delegate(CreateTestAddress(12), validator.id, 4000 * COIN, delegatorSig);
+    ASSERT_TRUE(third.has_value());
+    pool.DistributeRewards(validator.id, 80 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*first), 20 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*second), 60 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*third), 40 * COIN);
+    
+    // Undelegating settles what was earned at the old share count
+    EXPECT_TRUE(pool.Undelegate(*second, 3000 * COIN, delegatorSig));
+    pool.DistributeRewards(validator.id, 50 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*first), 30 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*second), 60 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*third), 80 * COIN);
+    
+    // Claiming pays out the settled amount and restarts accrual
+    pool.ProcessBlock(REWARD_CLAIM_COOLDOWN);
+    EXPECT_EQ(pool.ClaimRewards(*first, delegatorSig), 30 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*first), 0);
+    pool.DistributeRewards(validator.id, 50 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*first), 10 * COIN);
+    EXPECT_EQ(pool.GetDelegation(*first)->totalRewardsClaimed, 30 * COIN);
+}
+
 // ============================================================================
 // SlashingManager Tests
 // ============================================================================
@@ -1143,3 +1302,103 @@ TEST_F(StakingTest, StakingEngineConvenienceMethods) {
     EXPECT_TRUE(delegationId.has_value());
 }
 
+
+// ============================================================================
+// StakingStore Tests
+// ============================================================================
+
+TEST_F(StakingTest, ValidatorAndDelegationSerializeRoundTrip) {
+    Validator validator = CreateTestValidator(0, MIN_VALIDATOR_STAKE, "Node1");
+    validator.status = ValidatorStatus::Jailed;
+    validator.delegatedStake = 1234 * COIN;
+    validator.jailedHeight = 77;
+    validator.unbondingHeight = 88;
+    for (bool missed : {true, false, false, true, true, false, true, false, true}) {
+        validator.missedBlocksBitmap.Record(missed);
+    }
+    validator.slashCount = 2;
+    
+    auto bytes = validator.Serialize();
+    auto decoded = Validator::Deserialize(bytes.data(), bytes.size());
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->Serialize(), bytes);
+    EXPECT_EQ(decoded->id, validator.id);
+    EXPECT_EQ(decoded->description, validator.description);
+    EXPECT_EQ(decoded->missedBlocksBitmap, validator.missedBlocksBitmap);
+    EXPECT_FALSE(Validator::Deserialize(bytes.data(), bytes.size() - 1).has_value());
+    
+    Delegation delegation;
+    delegation.delegator = CreateTestAddress(10);
+    delegation.validatorId = validator.id;
+    delegation.amount = 500 * COIN;
+    delegation.shares = 500 * COIN;
+    delegation.status = DelegationStatus::Unbonding;
+    delegation.unbondingHeight = 42;
+    delegation.rewardCheckpoint = (static_cast<RewardPerShare>(7) << 64) | 9;
+    delegation.id = delegation.GetHash();
+    
+    auto delegationBytes = delegation.Serialize();
+    auto decodedDelegation = Delegation::Deserialize(delegationBytes.data(), delegationBytes.size());
+    ASSERT_TRUE(decodedDelegation.has_value());
+    EXPECT_EQ(decodedDelegation->Serialize(), delegationBytes);
+    EXPECT_TRUE(decodedDelegation->rewardCheckpoint == delegation.rewardCheckpoint);
+}
+
+TEST_F(StakingTest, StakingStoreConnectLoadAndDisconnect) {
+    StakingStore store;
+    EXPECT_EQ(store.GetTipHeight(), -1);
+    
+    auto& validatorSet = engine_->GetValidatorSet();
+    auto& pool = engine_->GetStakingPool();
+    
+    // Block 1: a validator and a delegation
+    Validator validator = CreateTestValidator(0, MIN_VALIDATOR_STAKE, "Node1");
+    ASSERT_TRUE(validatorSet.RegisterValidator(validator, SignValidator(validator, 0)));
+    ASSERT_TRUE(validatorSet.ActivateValidator(validator.id));
+    std::vector<Byte> delegatorSig(64, 0x01);
+    auto delegationId = pool.Delegate(CreateTestAddress(10), validator.id, 1000 * COIN, delegatorSig);
+    ASSERT_TRUE(delegationId.has_value());
+    ASSERT_TRUE(store.ConnectBlock(1, engine_->TakeChanges()));
+    
+    // Block 2: rewards and a partial undelegation
+    pool.DistributeRewards(validator.id, 10 * COIN);
+    ASSERT_TRUE(pool.Undelegate(*delegationId, 400 * COIN, delegatorSig));
+    StakingChanges block2 = engine_->TakeChanges();
+    EXPECT_EQ(block2.delegations.size(), 1);
+    EXPECT_EQ(block2.rewardPerShare.size(), 1);
+    EXPECT_TRUE(block2.validators.empty());
+    ASSERT_TRUE(store.ConnectBlock(2, block2));
+    EXPECT_TRUE(engine_->TakeChanges().empty());
+    EXPECT_FALSE(store.ConnectBlock(4, StakingChanges()));
+    
+    // A fresh engine loaded from the store matches without replay
+    StakingChanges state;
+    ASSERT_TRUE(store.Load(state));
+    StakingEngine restarted;
+    restarted.ApplyChanges(state, store.GetTipHeight());
+    EXPECT_EQ(restarted.GetCurrentHeight(), 2);
+    EXPECT_TRUE(restarted.GetValidatorSet().IsActive(validator.id));
+    EXPECT_EQ(restarted.GetStakingPool().GetTotalDelegated(validator.id), 600 * COIN);
+    EXPECT_EQ(restarted.GetStakingPool().GetPendingRewards(*delegationId), 10 * COIN);
+    restarted.GetStakingPool().DistributeRewards(validator.id, 6 * COIN);
+    EXPECT_EQ(restarted.GetStakingPool().GetPendingRewards(*delegationId), 16 * COIN);
+    
+    // Disconnecting block 2 restores block 1's records
+    StakingChanges restored;
+    ASSERT_TRUE(store.DisconnectBlock(restored));
+    EXPECT_EQ(store.GetTipHeight(), 1);
+    EXPECT_EQ(restored.size(), block2.size());
+    engine_->ApplyChanges(restored, store.GetTipHeight());
+    EXPECT_EQ(pool.GetTotalDelegated(validator.id), 1000 * COIN);
+    EXPECT_EQ(pool.GetPendingRewards(*delegationId), 0);
+    EXPECT_EQ(pool.GetRewardPerShare(validator.id), 0);
+    
+    StakingChanges reloaded;
+    ASSERT_TRUE(store.Load(reloaded));
+    EXPECT_TRUE(reloaded.rewardPerShare.empty());
+    EXPECT_EQ(reloaded.delegations.at(*delegationId)->amount, 1000 * COIN);
+    
+    // Blocks whose undo data was pruned can no longer be disconnected
+    ASSERT_TRUE(store.PruneUndo(1));
+    EXPECT_FALSE(store.DisconnectBlock(restored));
+}
@@ -5,15 +5,41 @@
 #include <gtest/gtest.h>
 
 #include <shurium/util/logging.h>
+#include <shurium/util/metrics.h>
 #include <shurium/util/time.h>
 #include <shurium/util/fs.h>
 #include <shurium/util/threadpool.h>
-
+#include <shurium/util/poolresource.h>
+#include <shurium/util/shutdown.h>
+#include <shurium/util/startup.h>
+#include <shurium/util/trace.h>
+#include <shurium/util/iouring.h>
+#include <shurium/util/affinity.h>
+
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
+#ifdef SHURIUM_IO_URING
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <time.h>
+#endif
+
 namespace shurium {
 namespace util {
 namespace {
@@ -127,6 +153,144 @@ TEST_F(LoggingTest, CallbackSink) {
     EXPECT_EQ(capturedMessages[0], "Test message");
 }
 
+TEST_F(LoggingTest, AsyncDeliversInOrder) {
+    std::vector<std::string> captured;
+    std::thread::id writer;
+    auto sink = std::make_shared<CallbackSink>([&](const LogEntry& entry) {
+        captured.push_back(entry.message);
+        writer = std::this_thread::get_id();
+    }, LogLevel::Info);
+    auto& logger = Logger::Instance();
+    logger.AddSink(sink);
+    logger.SetLevel(LogLevel::Info);
+    logger.EnableAllCategories();
+    
+    logger.StartAsync();
+    EXPECT_TRUE(logger.IsAsync());
+    for (int i = 0; i < 1000; ++i) {
+        logger.Log(LogLevel::Info, LogCategory::DEFAULT, std::to_string(i));
+    }
+    logger.Flush();
+    
+    ASSERT_EQ(captured.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(captured[i], std::to_string(i));
+    }
+    EXPECT_NE(writer, std::this_thread::get_id());
+    
+    logger.StopAsync();
+    EXPECT_FALSE(logger.IsAsync());
+    logger.Log(LogLevel::Info, LogCategory::DEFAULT, "sync");
+    ASSERT_EQ(captured.size(), 1001u);
+    EXPECT_EQ(writer, std::this_thread::get_id());
+}
+
+TEST_F(LoggingTest, AsyncOverflowPolicies) {
+    std::atomic<bool> release{false};
+    std::atomic<size_t> debugWritten{0};
+    std::atomic<size_t> infoWritten{0};
+    std::atomic<bool> droppedNotice{false};
+    auto sink = std::make_shared<CallbackSink>([&](const LogEntry& entry) {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (entry.level == LogLevel::Debug) {
+            ++debugWritten;
+        } else if (entry.level == LogLevel::Info) {
+            ++infoWritten;
+        } else if (entry.message.find("Dropped") != std::string::npos) {
+            droppedNotice = true;
+        }
+    }, LogLevel::Trace);
+    auto& logger = Logger::Instance();
+    logger.AddSink(sink);
+    logger.SetLevel(LogLevel::Trace);
+    logger.EnableAllCategories();
+    
+    AsyncLogConfig config;
+    config.capacity = 4;
+    config.batchSize = 1;
+    logger.StartAsync(config);
+    uint64_t droppedBefore = logger.DroppedCount();
+    
+    // The writer is stuck in the sink, so debug entries beyond the buffer
+    // are dropped rather than waited for
+    for (int i = 0; i < 50; ++i) {
+        logger.Log(LogLevel::Debug, LogCategory::DEFAULT, "debug");
+    }
+    EXPECT_GE(logger.DroppedCount() - droppedBefore, 40u);
+    
+    // Info blocks until the writer makes room, so none are lost
+    std::thread producer([&] {
+        for (int i = 0; i < 50; ++i) {
+            logger.Log(LogLevel::Info, LogCategory::DEFAULT, "info");
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release = true;
+    producer.join();
+    logger.StopAsync();
+    
+    EXPECT_EQ(debugWritten.load() + (logger.DroppedCount() - droppedBefore), 50u);
+    EXPECT_EQ(infoWritten.load(), 50u);
+    EXPECT_TRUE(droppedNotice.load());
+    logger.SetLevel(LogLevel::Info);
+}
+
+TEST_F(LoggingTest, DisabledStatementsSkipArguments) {
+    int captured = 0;
+    auto sink = std::make_shared<CallbackSink>([&](const LogEntry&) { ++captured; },
+                                               LogLevel::Trace);
+    auto& logger = Logger::Instance();
+    logger.AddSink(sink);
+    logger.SetLevel(LogLevel::Info);
+    logger.EnableAllCategories();
+    
+    int evaluated = 0;
+    auto arg = [&] { return ++evaluated; };
+    
+    LOG_DEBUG(LogCategory::NET) << arg();
+    EXPECT_EQ(evaluated, 0);
+    LOG_INFO(LogCategory::NET) << arg();
+    EXPECT_EQ(evaluated, 1);
+    
+    // The macro is a single statement, so an else binds to the caller's if
+    bool branch = false;
+    if (evaluated == 0)
+        LOG_INFO(LogCategory::NET) << arg();
+    else
+        branch = true;
+    EXPECT_TRUE(branch);
+    
+    logger.SetLevel(LogLevel::Trace);
+    LOG_TRACE(LogCategory::NET) << arg();
+    EXPECT_EQ(evaluated, SHURIUM_LOG_TRACE_ENABLED ? 2 : 1);
+    EXPECT_EQ(captured, evaluated);
+    logger.SetLevel(LogLevel::Info);
+}
+
+TEST_F(LoggingTest, CategoryMaskAndOtherNames) {
+    auto& logger = Logger::Instance();
+    EXPECT_NE(LogCategory::Bit(LogCategory::NET), 0u);
+    EXPECT_EQ(LogCategory::Bit("custom"), 0u);
+    
+    logger.DisableAllCategories();
+    logger.EnableCategory(LogCategory::MEMPOOL);
+    logger.EnableCategory("custom");
+    EXPECT_TRUE(logger.IsCategoryEnabled(LogCategory::MEMPOOL));
+    EXPECT_TRUE(logger.IsCategoryEnabled(std::string("custom")));
+    EXPECT_FALSE(logger.IsCategoryEnabled(LogCategory::NET));
+    EXPECT_FALSE(logger.IsCategoryEnabled("other"));
+    
+    logger.DisableCategory(LogCategory::MEMPOOL);
+    logger.DisableCategory("custom");
+    EXPECT_FALSE(logger.IsCategoryEnabled(LogCategory::MEMPOOL));
+    EXPECT_FALSE(logger.IsCategoryEnabled("custom"));
+    
+    logger.EnableAllCategories();
+    EXPECT_TRUE(logger.IsCategoryEnabled("other"));
+}
+
 TEST_F(LoggingTest, ConsoleSinkConfig) {
     ConsoleSink::Config config;
     config.useColors = false;
@@ -138,6 +302,303 @@ TEST_F(LoggingTest, ConsoleSinkConfig) {
     EXPECT_EQ(sink.GetConfig().showTimestamp, true);
 }
 
+// ============================================================================
+// Metrics Tests
+// ============================================================================
+
+TEST(MetricsTest, CounterAcrossThreads) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) {
+                counter.Inc();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter.Value(), 40000u);
+}
+
+TEST(MetricsTest, HistogramBuckets) {
+    // Every value lies in its bucket, and buckets are within 12.5% wide
+    for (uint64_t value : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 100ull, 1000ull,
+                           123456ull, (1ull << 35) + 1}) {
+        size_t bucket = Histogram::BucketOf(value);
+        uint64_t upper = Histogram::BucketUpperBound(bucket);
+        EXPECT_GE(upper, value);
+        uint64_t lower = bucket == 0 ? 0 : Histogram::BucketUpperBound(bucket - 1) + 1;
+        EXPECT_LE(lower, value);
+        EXPECT_LE(static_cast<double>(upper - lower), 0.125 * static_cast<double>(lower) + 1);
+    }
+    EXPECT_EQ(Histogram::BucketOf(UINT64_MAX), HISTOGRAM_BUCKETS - 1);
+    
+    Histogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        histogram.Record(i);
+    }
+    Histogram::Snapshot snapshot = histogram.GetSnapshot();
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.sum, 500500u);
+    EXPECT_NEAR(static_cast<double>(snapshot.ValueAt(0.5)), 500.0, 500.0 * 0.125);
+    EXPECT_NEAR(static_cast<double>(snapshot.ValueAt(0.99)), 990.0, 990.0 * 0.125);
+    EXPECT_EQ(Histogram::Snapshot{}.ValueAt(0.5), 0u);
+}
+
+TEST(MetricsTest, RenderPrometheusText) {
+    MetricsRegistry registry;
+    registry.GetCounter("shurium_requests_total{method=\"a\"}", "Requests").Inc(2);
+    registry.GetCounter("shurium_requests_total{method=\"b\"}", "Requests").Inc();
+    registry.GetGauge("shurium_depth", "Queue depth").Set(-4);
+    Histogram& latency = registry.GetHistogram("shurium_latency_microseconds", "Latency");
+    latency.Record(100);
+    EXPECT_EQ(registry.GetCounter("shurium_requests_total{method=\"a\"}", "Requests").Value(), 2u);
+    EXPECT_EQ(&registry.GetHistogram("shurium_latency_microseconds", "Latency"), &latency);
+    
+    registry.RegisterCollector("test", [](MetricsWriter& out) {
+        out.WriteGauge("shurium_collected", "From a collector", 1.5);
+    });
+    
+    std::string text = registry.Render();
+    EXPECT_NE(text.find("# TYPE shurium_requests_total counter\n"
+                        "shurium_requests_total{method=\"a\"} 2\n"
+                        "shurium_requests_total{method=\"b\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE shurium_depth gauge\nshurium_depth -4\n"), std::string::npos);
+    EXPECT_NE(text.find("shurium_latency_microseconds{quantile=\"0.5\"} 103\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("shurium_latency_microseconds_sum 100\n"), std::string::npos);
+    EXPECT_NE(text.find("shurium_latency_microseconds_count 1\n"), std::string::npos);
+    EXPECT_NE(text.find("shurium_collected 1.5\n"), std::string::npos);
+    
+    registry.UnregisterCollector("test");
+    EXPECT_EQ(registry.Render().find("shurium_collected"), std::string::npos);
+}
+
+// ============================================================================
+// Trace Tests
+// ============================================================================
+
+/// Spans of the given name, across threads
+static std::vector<std::pair<uint32_t, TraceEvent>> FindSpans(const char* name) {
+    std::vector<std::pair<uint32_t, TraceEvent>> found;
+    for (const ThreadTrace& thread : GetTrace()) {
+        for (const TraceEvent& event : thread.events) {
+            if (std::string(event.name) == name) {
+                found.emplace_back(thread.threadId, event);
+            }
+        }
+    }
+    return found;
+}
+
+TEST(TraceTest, SpansNestAndNameTheirThread) {
+    ClearTrace();
+    {
+        TraceSpan outer("test.outer");
+        TraceSpan inner("test.inner");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::thread([] { TraceSpan span("test.other"); }).join();
+
+    auto outer = FindSpans("test.outer");
+    auto inner = FindSpans("test.inner");
+    auto other = FindSpans("test.other");
+    ASSERT_EQ(outer.size(), 1u);
+    ASSERT_EQ(inner.size(), 1u);
+    ASSERT_EQ(other.size(), 1u);
+    EXPECT_EQ(outer[0].first, inner[0].first);
+    EXPECT_NE(outer[0].first, other[0].first);
+    EXPECT_LE(outer[0].second.startNs, inner[0].second.startNs);
+    EXPECT_GE(outer[0].second.durationNs, inner[0].second.durationNs);
+    EXPECT_GE(inner[0].second.durationNs, 1000000u);
+
+    ClearTrace();
+    EXPECT_TRUE(FindSpans("test.outer").empty());
+}
+
+TEST(TraceTest, RingKeepsNewestSpans) {
+    ClearTrace();
+    for (size_t i = 0; i < TRACE_BUFFER_EVENTS + 10; ++i) {
+        TraceSpan span(i < 10 ? "test.old" : "test.new");
+    }
+    EXPECT_TRUE(FindSpans("test.old").empty());
+    auto spans = FindSpans("test.new");
+    ASSERT_EQ(spans.size(), TRACE_BUFFER_EVENTS);
+    for (size_t i = 1; i < spans.size(); ++i) {
+        EXPECT_LE(spans[i - 1].second.startNs, spans[i].second.startNs);
+    }
+    ClearTrace();
+}
+
+// ============================================================================
+// io_uring Tests
+// ============================================================================
+
+#ifdef SHURIUM_IO_URING
+
+TEST(IoRingTest, ReadsAndWritesAtOffsets) {
+    auto ring = IoRing::Create();
+    if (!ring) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    FILE* file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    int fd = fileno(file);
+    
+    std::vector<uint8_t> data(100000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    EXPECT_EQ(ring->WriteAt(fd, data.data(), data.size(), 4096), int64_t(data.size()));
+    
+    std::vector<uint8_t> back(data.size());
+    EXPECT_EQ(ring->ReadAt(fd, back.data(), back.size(), 4096), int64_t(back.size()));
+    EXPECT_EQ(back, data);
+    
+    // Past the end: short, as pread would be
+    EXPECT_EQ(ring->ReadAt(fd, back.data(), back.size(), 4096 + 50000), 50000);
+    EXPECT_LT(ring->ReadAt(-1, back.data(), back.size(), 0), 0);
+    std::fclose(file);
+}
+
+TEST(IoRingTest, BatchesSocketReads) {
+    auto ring = IoRing::Create();
+    if (!ring) {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    constexpr size_t SLOT = 4096;
+    std::vector<uint8_t> buffers(3 * SLOT);
+    bool fixed = ring->RegisterBuffers(buffers.data(), SLOT, 3);
+    
+    int pairs[3][2];
+    for (auto& pair : pairs) {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    }
+    ASSERT_EQ(write(pairs[0][1], "abc", 3), 3);
+    ASSERT_EQ(write(pairs[1][1], "defgh", 5), 5);
+    
+    // The third socket is empty: its read fails rather than waiting
+    for (uint64_t i = 0; i < 3; ++i) {
+        uint8_t* slot = buffers.data() + i * SLOT;
+        EXPECT_TRUE(fixed ? ring->QueueReadFixed(pairs[i][0], slot, SLOT, UINT64_MAX,
+                                                 static_cast<uint16_t>(i), i)
+                          : ring->QueueRead(pairs[i][0], slot, SLOT, UINT64_MAX, i));
+    }
+    EXPECT_EQ(ring->Submit(3), 3);
+    
+    int32_t results[3] = {0, 0, 0};
+    IoRing::Completion completion;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(ring->PopCompletion(completion));
+        ASSERT_LT(completion.userData, 3u);
+        results[completion.userData] = completion.result;
+    }
+    EXPECT_FALSE(ring->PopCompletion(completion));
+    EXPECT_EQ(results[0], 3);
+    EXPECT_EQ(results[1], 5);
+    EXPECT_EQ(results[2], -EAGAIN);
+    EXPECT_EQ(std::string(buffers.begin() + SLOT, buffers.begin() + SLOT + 5), "defgh");
+    
+    for (auto& pair : pairs) {
+        close(pair[0]);
+        close(pair[1]);
+    }
+}
+
+#endif // SHURIUM_IO_URING
+
+// ============================================================================
+// Thread Placement Tests
+// ============================================================================
+
+TEST(ThreadPlacementTest, ParsesCpuLists) {
+    EXPECT_EQ(ParseCpuList("0-3,8"), (std::vector<int>{0, 1, 2, 3, 8}));
+    EXPECT_EQ(ParseCpuList("5,2,2"), (std::vector<int>{2, 5}));
+    EXPECT_EQ(ParseCpuList("7"), (std::vector<int>{7}));
+    EXPECT_TRUE(ParseCpuList("").empty());
+    EXPECT_TRUE(ParseCpuList("3-1").empty());
+    EXPECT_TRUE(ParseCpuList("1,").empty());
+    EXPECT_TRUE(ParseCpuList("-1").empty());
+    EXPECT_TRUE(ParseCpuList("a-b").empty());
+    EXPECT_TRUE(ParseCpuList("1-2x").empty());
+}
+
+TEST(ThreadPlacementTest, DefaultsSplitRolesAcrossNodes) {
+    const std::vector<NumaNode> twoNodes = {{0, {0, 1}}, {1, {2, 3}}};
+    ThreadPlacement placement;
+    std::string error;
+    EXPECT_FALSE(placement.Configure("rpc", error));
+    EXPECT_FALSE(placement.Configure("rpc=x", error));
+    ASSERT_TRUE(placement.Configure("rpc=3", error)) << error;
+
+    placement.ApplyDefaults(twoNodes);
+    EXPECT_EQ(placement.GetCores("msgheavy"), (std::vector<int>{0, 1}));
+    EXPECT_EQ(placement.GetCores("miner"), (std::vector<int>{2, 3}));
+    EXPECT_EQ(placement.GetCores("rpc"), (std::vector<int>{3}));  // Configured wins
+    EXPECT_EQ(placement.PreferredNode("msgheavy"), 0);
+    EXPECT_EQ(placement.PreferredNode("rpc"), 1);
+    EXPECT_EQ(placement.PreferredNode("other"), -1);
+
+    // One node: nothing is pinned and memory keeps the default policy
+    ThreadPlacement single;
+    single.ApplyDefaults({{0, {0, 1, 2, 3}}});
+    EXPECT_TRUE(single.GetCores("msgheavy").empty());
+    EXPECT_EQ(single.PreferredNode("msgheavy"), -1);
+}
+
+TEST(ThreadPlacementTest, NumaPoolStillAllocates) {
+    EXPECT_FALSE(BindToNumaNode(nullptr, 16, 0));  // No whole page
+
+    PoolResource<64, 8> pool(64 * 1024, 0);
+    EXPECT_EQ(pool.PreferredNumaNode(), 0);
+    void* block = pool.Allocate(32, 8);
+    ASSERT_NE(block, nullptr);
+    std::memset(block, 0xab, 32);
+    pool.Deallocate(block, 32, 8);
+}
+
+#ifdef __linux__
+TEST(ThreadPlacementTest, PinsRoleAndCountsCpuTime) {
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed)) {
+        ++cpu;
+    }
+    ASSERT_LT(cpu, CPU_SETSIZE);
+
+    const std::string role = "test-pinned";
+    ThreadPlacement::Instance().SetCores(role, {cpu});
+    int ranOn = -1;
+    std::thread worker([&] {
+        ScopedThreadRole scoped(role);
+        ranOn = sched_getcpu();
+        // Spin on the thread's own clock so a loaded machine cannot shorten it
+        struct timespec used {};
+        volatile uint64_t spin = 0;
+        while (used.tv_sec == 0 && used.tv_nsec < 30000000) {
+            ++spin;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &used);
+        }
+    });
+    worker.join();
+    ThreadPlacement::Instance().SetCores(role, {});
+
+    EXPECT_EQ(ranOn, cpu);
+    bool found = false;
+    for (const auto& stats : ThreadPlacement::Instance().GetStats()) {
+        if (stats.role == role) {
+            found = true;
+            EXPECT_EQ(stats.threads, 0u);
+            EXPECT_GT(stats.cpuSeconds, 0.02);
+        }
+    }
+    EXPECT_TRUE(found);
+}
+#endif
+
 // ============================================================================
 // Time Tests
 // ============================================================================
@@ -395,6 +856,56 @@ TEST_F(FilesystemTest, ReadWriteFile) {
     EXPECT_EQ(read, content);
 }
 
+TEST_F(FilesystemTest, MappedFile) {
+    fs::Path testFile = testDir_ / fs::Path("mapped.bin");
+    std::vector<uint8_t> data = {0x10, 0x20, 0x30, 0x40};
+    ASSERT_TRUE(fs::WriteFile(testFile, data));
+    
+    fs::MappedFile mapped(testFile);
+#ifndef _WIN32
+    ASSERT_TRUE(mapped.IsOpen());
+    ASSERT_EQ(mapped.Size(), data.size());
+    EXPECT_EQ(std::vector<uint8_t>(mapped.Data(), mapped.Data() + mapped.Size()), data);
+    
+    fs::MappedFile moved(std::move(mapped));
+    EXPECT_FALSE(mapped.IsOpen());
+    EXPECT_TRUE(moved.IsOpen());
+    moved.Close();
+    EXPECT_FALSE(moved.IsOpen());
+#endif
+    
+    EXPECT_FALSE(fs::MappedFile(testDir_ / fs::Path("missing.bin")).IsOpen());
+}
+
+TEST_F(FilesystemTest, SequentialFile) {
+    fs::Path testFile = testDir_ / fs::Path("sequential.bin");
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    ASSERT_TRUE(fs::WriteFile(testFile, data));
+    
+    fs::SequentialFile file(testFile);
+    ASSERT_TRUE(file.IsOpen());
+    EXPECT_EQ(file.Size(), data.size());
+    
+    // Reads continue where the last one stopped
+    std::vector<uint8_t> read;
+    uint8_t buf[300];
+    while (size_t n = file.Read(buf, sizeof(buf))) {
+        read.insert(read.end(), buf, buf + n);
+        file.WillNeed(file.Tell(), sizeof(buf));
+    }
+    EXPECT_EQ(read, data);
+    EXPECT_EQ(file.Tell(), data.size());
+    
+    fs::SequentialFile moved(std::move(file));
+    EXPECT_FALSE(file.IsOpen());
+    EXPECT_TRUE(moved.IsOpen());
+    
+    EXPECT_FALSE(fs::SequentialFile(testDir_ / fs::Path("missing.bin")).IsOpen());
+}
+
 TEST_F(FilesystemTest, ReadWriteFileBytes) {
     fs::Path testFile = testDir_ / fs::Path("test.bin");
     std::vector<uint8_t> data = {0x00, 0x01, 0xFF, 0xFE, 0x42};
@@ -714,6 +1225,86 @@ TEST_F(ThreadPoolTest, ParallelForIndex) {
     }
 }
 
+TEST_F(ThreadPoolTest, PriorityLanes) {
+    pool_ = std::make_unique<ThreadPool>(1);
+    
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    pool_->Execute([gate] { gate.wait(); });
+    
+    std::vector<int> order;
+    std::mutex mutex;
+    auto record = [&](int value) {
+        return [&, value] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+        };
+    };
+    pool_->ExecuteWithPriority(TaskPriority::Low, record(0));
+    pool_->ExecuteWithPriority(TaskPriority::Normal, record(1));
+    pool_->ExecuteWithPriority(TaskPriority::Critical, record(3));
+    pool_->ExecuteWithPriority(TaskPriority::High, record(2));
+    
+    release.set_value();
+    pool_->Wait();
+    EXPECT_EQ(order, (std::vector<int>{3, 2, 1, 0}));
+}
+
+TEST_F(ThreadPoolTest, NestedTasksAreStolen) {
+    // Each outer task spawns children onto its own deque and waits for
+    // them; the other workers must steal them
+    std::atomic<int> leaves{0};
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < 4; ++i) {
+        outer.push_back(pool_->Submit([this, &leaves] {
+            std::vector<std::future<int>> children;
+            for (int j = 0; j < 50; ++j) {
+                children.push_back(pool_->Submit([&leaves, j] {
+                    leaves++;
+                    return j;
+                }));
+            }
+            int sum = 0;
+            for (auto& child : children) {
+                sum += child.get();
+            }
+            EXPECT_EQ(sum, 49 * 50 / 2);
+        }));
+        // Outer tasks must not take every worker, or nothing can steal
+        outer.back().wait();
+    }
+    EXPECT_EQ(leaves.load(), 200);
+    
+    // Callables too big to store inline
+    std::array<uint64_t, 32> big{};
+    big[31] = 7;
+    EXPECT_EQ(pool_->Submit([big] { return big[31]; }).get(), 7u);
+}
+
+TEST_F(ThreadPoolTest, ParallelForFromWorkers) {
+    // Nested ParallelForIndex inside every worker: the callers do the work
+    // themselves, so this finishes even with all workers busy
+    std::atomic<size_t> total{0};
+    TaskGroup group(*pool_);
+    for (int i = 0; i < 8; ++i) {
+        group.Add([this, &total] {
+            ParallelForIndex(0, 1000, [&](size_t j) { total += j; }, *pool_);
+        });
+    }
+    group.Wait();
+    EXPECT_EQ(total.load(), 8u * 999 * 1000 / 2);
+    
+    std::vector<int> values{1, 2, 3, 4};
+    std::vector<int> doubled(values.size());
+    ParallelMap(values.begin(), values.end(), doubled.begin(),
+                [](int v) { return v * 2; }, *pool_);
+    EXPECT_EQ(doubled, (std::vector<int>{2, 4, 6, 8}));
+    
+    EXPECT_THROW(ParallelForIndex(0, 100, [](size_t j) {
+        if (j == 57) throw std::runtime_error("index 57");
+    }, *pool_, 4), std::runtime_error);
+}
+
 TEST_F(ThreadPoolTest, Async) {
     auto future = Async([]() {
         return 42;
@@ -795,6 +1386,94 @@ TEST_F(ThreadPoolTest, SchedulerCancel) {
     scheduler.Stop();
 }
 
+TEST(TimerWheelTest, FiresAtExpiryAcrossLevels) {
+    TimerWheel wheel;
+    std::vector<uint64_t> fireTicks;
+    std::vector<uint64_t> delays = {0, 1, 63, 64, 65, 4095, 4096, 4097, 300000,
+                                    (uint64_t{1} << 24) + 5, (uint64_t{1} << 26)};
+    for (uint64_t delay : delays) {
+        EXPECT_TRUE(wheel.Add(delay, delay, 0, [] {}));
+    }
+    EXPECT_FALSE(wheel.Add(0, 10, 0, [] {}));
+    EXPECT_EQ(wheel.Size(), delays.size());
+    
+    // Jump straight from one tick with work to the next
+    std::vector<TimerWheel::Expired> expired;
+    size_t advances = 0;
+    while (wheel.Size() > 0) {
+        uint64_t next = wheel.NextTick();
+        ASSERT_NE(next, UINT64_MAX);
+        wheel.Advance(next, expired);
+        for (const auto& timer : expired) {
+            EXPECT_EQ(timer.id, next);
+            fireTicks.push_back(next);
+        }
+        expired.clear();
+        ASSERT_LT(++advances, 1000u);
+    }
+    EXPECT_EQ(fireTicks, delays);
+    EXPECT_EQ(wheel.NextTick(), UINT64_MAX);
+}
+
+TEST(TimerWheelTest, CancelAndPeriodic) {
+    TimerWheel wheel;
+    int runs = 0;
+    wheel.Add(1, 10, 25, [&runs] { ++runs; });
+    wheel.Add(2, 5000, 0, [] {});
+    wheel.Add(3, 70, 0, [] {});
+    EXPECT_TRUE(wheel.Cancel(2));
+    EXPECT_FALSE(wheel.Cancel(2));
+    EXPECT_TRUE(wheel.Cancel(3));
+    
+    std::vector<TimerWheel::Expired> expired;
+    wheel.Advance(100, expired);
+    ASSERT_EQ(expired.size(), 4u);  // Ticks 10, 35, 60 and 85
+    for (auto& timer : expired) {
+        EXPECT_EQ(timer.id, 1u);
+        (*timer.task)();
+    }
+    EXPECT_EQ(runs, 4);
+    EXPECT_EQ(wheel.NextTick(), 110u);
+    EXPECT_EQ(wheel.Size(), 1u);
+    
+    // Late timers fire on the next Advance
+    wheel.Add(4, 50, 0, [] {});
+    expired.clear();
+    wheel.Advance(101, expired);
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0].id, 4u);
+    
+    wheel.Clear();
+    EXPECT_EQ(wheel.Size(), 0u);
+    EXPECT_EQ(wheel.NextTick(), UINT64_MAX);
+}
+
+TEST_F(ThreadPoolTest, SchedulerManyTimers) {
+    Scheduler scheduler(*pool_);
+    scheduler.Start();
+    
+    std::atomic<int> counter{0};
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 5000; ++i) {
+        ids.push_back(scheduler.ScheduleAfter(std::chrono::milliseconds(20 + i % 30),
+                                              [&counter]() { counter++; }));
+    }
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        EXPECT_TRUE(scheduler.Cancel(ids[i]));
+    }
+    EXPECT_EQ(scheduler.TaskCount(), 2500u);
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (counter.load() < 2500 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    pool_->Wait();
+    EXPECT_EQ(counter.load(), 2500);
+    EXPECT_EQ(scheduler.TaskCount(), 0u);
+    
+    scheduler.Stop();
+}
+
 TEST_F(ThreadPoolTest, GlobalThreadPool) {
     auto& pool1 = GetGlobalThreadPool();
     auto& pool2 = GetGlobalThreadPool();
@@ -803,6 +1482,209 @@ TEST_F(ThreadPoolTest, GlobalThreadPool) {
     EXPECT_TRUE(pool1.IsRunning());
 }
 
+// ============================================================================
+// Pool Resource Tests
+// ============================================================================
+
+TEST(PoolResourceTest, ReusesFreedBlocks) {
+    PoolResource<64, 8> resource(1024);
+    EXPECT_EQ(resource.NumAllocatedChunks(), 0u);
+    
+    void* a = resource.Allocate(24, 8);
+    EXPECT_EQ(resource.NumAllocatedChunks(), 1u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 8, 0u);
+    
+    resource.Deallocate(a, 24, 8);
+    void* b = resource.Allocate(24, 8);
+    EXPECT_EQ(a, b);
+    resource.Deallocate(b, 24, 8);
+}
+
+TEST(PoolResourceTest, ChunksAndOversize) {
+    PoolResource<64, 8> resource(1024);
+    
+    // 1024 / 64 blocks fit in the first chunk; one more needs a second
+    std::vector<void*> blocks;
+    for (int i = 0; i < 17; ++i) {
+        blocks.push_back(resource.Allocate(64, 8));
+    }
+    EXPECT_EQ(resource.NumAllocatedChunks(), 2u);
+    
+    size_t pooledUsage = resource.MemoryUsage();
+    EXPECT_GE(pooledUsage, 2 * resource.ChunkSizeBytes());
+    
+    // Large requests bypass the pool but are still accounted for
+    void* big = resource.Allocate(4096, 8);
+    EXPECT_EQ(resource.MemoryUsage(), pooledUsage + 4096);
+    resource.Deallocate(big, 4096, 8);
+    EXPECT_EQ(resource.MemoryUsage(), pooledUsage);
+    
+    for (void* p : blocks) {
+        resource.Deallocate(p, 64, 8);
+    }
+}
+
+TEST(PoolResourceTest, AllocatorInStandardContainer) {
+    using Alloc = PoolAllocator<std::pair<const int, int>, 64, alignof(void*)>;
+    std::map<int, int, std::less<int>, Alloc> map;
+    
+    for (int i = 0; i < 1000; ++i) {
+        map[i] = i * 2;
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        map.erase(i);
+    }
+    EXPECT_EQ(map.size(), 500u);
+    EXPECT_EQ(map.at(501), 1002);
+    EXPECT_GT(map.get_allocator().Resource()->NumAllocatedChunks(), 0u);
+    
+    // Copies get their own pool; moves keep the source usable
+    auto copy = map;
+    EXPECT_NE(copy.get_allocator(), map.get_allocator());
+    EXPECT_EQ(copy, map);
+    
+    auto moved = std::move(copy);
+    copy[7] = 7;
+    EXPECT_EQ(copy.size(), 1u);
+    EXPECT_EQ(moved.size(), 500u);
+}
+
+// ============================================================================
+// Shutdown Coordinator Tests
+// ============================================================================
+
+TEST(ShutdownCoordinatorTest, StepsInStageRunInParallel) {
+    // Each step waits for the other, so they only finish if run together
+    std::promise<void> aStarted, bStarted;
+    auto aReady = aStarted.get_future().share();
+    auto bReady = bStarted.get_future().share();
+    
+    ShutdownCoordinator shutdown;
+    shutdown.AddStage("pair")
+        .AddStep("a", [&] { aStarted.set_value(); bReady.wait(); })
+        .AddStep("b", [&] { bStarted.set_value(); aReady.wait(); });
+    shutdown.Run();
+    
+    ASSERT_EQ(shutdown.GetTimings().size(), 1u);
+    for (const auto& step : shutdown.GetTimings()[0].steps) {
+        EXPECT_EQ(step.outcome, ShutdownCoordinator::Outcome::DONE);
+    }
+}
+
+TEST(ShutdownCoordinatorTest, StagesRunInOrder) {
+    std::vector<std::string> order;
+    std::mutex mutex;
+    auto record = [&](const std::string& name) {
+        return [&, name] {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+        };
+    };
+    
+    ShutdownCoordinator shutdown;
+    shutdown.AddStage("first").AddStep("a", record("a"));
+    shutdown.AddCriticalStage("flush").AddStep("b", record("b")).AddStep("c", record("c"));
+    shutdown.AddStage("last").AddStep("d", record("d"));
+    shutdown.Run();
+    
+    EXPECT_EQ(order, (std::vector<std::string>{"a", "b", "c", "d"}));
+    ASSERT_EQ(shutdown.GetTimings().size(), 3u);
+    EXPECT_TRUE(shutdown.GetTimings()[1].critical);
+    EXPECT_EQ(shutdown.GetTimings()[1].steps.size(), 2u);
+}
+
+TEST(ShutdownCoordinatorTest, DeadlineLeavesSlowStepBehind) {
+    auto release = std::make_shared<std::promise<void>>();
+    auto released = release->get_future().share();
+    
+    ShutdownCoordinator shutdown;
+    shutdown.AddStage("save", std::chrono::milliseconds(50))
+        .AddStep("fast", [] {})
+        .AddStep("stuck", [released] { released.wait(); });
+    
+    auto start = std::chrono::steady_clock::now();
+    shutdown.Run();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    release->set_value();
+    
+    const auto& steps = shutdown.GetTimings()[0].steps;
+    ASSERT_EQ(steps.size(), 2u);
+    EXPECT_EQ(steps[0].outcome, ShutdownCoordinator::Outcome::DONE);
+    EXPECT_EQ(steps[1].outcome, ShutdownCoordinator::Outcome::TIMED_OUT);
+    EXPECT_NE(shutdown.FormatTimings().find("stuck"), std::string::npos);
+}
+
+TEST(ShutdownCoordinatorTest, FailingStepDoesNotStopOthers) {
+    bool criticalRan = false;
+    ShutdownCoordinator shutdown;
+    shutdown.AddStage("save")
+        .AddStep("throws", [] { throw std::runtime_error("disk full"); })
+        .AddStep("ok", [] {});
+    shutdown.AddCriticalStage("flush").AddStep("flush", [&] { criticalRan = true; });
+    shutdown.Run();
+    
+    EXPECT_TRUE(criticalRan);
+    const auto& steps = shutdown.GetTimings()[0].steps;
+    EXPECT_EQ(steps[0].outcome, ShutdownCoordinator::Outcome::FAILED);
+    EXPECT_EQ(steps[1].outcome, ShutdownCoordinator::Outcome::DONE);
+}
+
+// ============================================================================
+// Startup Profile Tests
+// ============================================================================
+
+TEST(StartupProfileTest, ReadyOnceEveryPhaseHasRun) {
+    StartupProfile profile;
+    EXPECT_FALSE(profile.IsReady());
+    
+    profile.Record(StartupPhase::CONFIG, std::chrono::milliseconds(5));
+    for (StartupPhase phase : {StartupPhase::DATABASES, StartupPhase::CHAINSTATE,
+                               StartupPhase::BLOCK_INDEX, StartupPhase::NETWORK}) {
+        StartupPhaseTimer timer(profile, phase);
+        timer.Done();
+    }
+    profile.Skip(StartupPhase::WALLET);
+    profile.Begin(StartupPhase::MEMPOOL);
+    profile.MarkStarted();
+    
+    // The saved mempool is still loading
+    EXPECT_FALSE(profile.IsReady());
+    EXPECT_EQ(profile.GetBlockers(), std::vector<std::string>{"mempool running"});
+    
+    profile.End(StartupPhase::MEMPOOL);
+    EXPECT_TRUE(profile.IsReady());
+    EXPECT_GE(profile.GetStartupTime(), std::chrono::milliseconds(5));
+    
+    profile.MarkStopping();
+    EXPECT_FALSE(profile.IsReady());
+}
+
+TEST(StartupProfileTest, PhaseTimesAddUpAndFailuresAreReported) {
+    StartupProfile profile;
+    profile.Record(StartupPhase::CHAINSTATE, std::chrono::milliseconds(3));
+    {
+        StartupPhaseTimer timer(profile, StartupPhase::CHAINSTATE);
+        timer.Done();
+    }
+    {
+        // Left without Done(), as on an early error return
+        StartupPhaseTimer timer(profile, StartupPhase::WALLET);
+    }
+    
+    auto phases = profile.GetPhases();
+    ASSERT_EQ(phases.size(), NUM_STARTUP_PHASES);
+    const auto& chainstate = phases[static_cast<size_t>(StartupPhase::CHAINSTATE)];
+    EXPECT_EQ(chainstate.state, StartupProfile::State::DONE);
+    EXPECT_GE(chainstate.elapsed, std::chrono::milliseconds(3));
+    EXPECT_EQ(phases[static_cast<size_t>(StartupPhase::WALLET)].state,
+              StartupProfile::State::FAILED);
+    
+    std::string report = profile.FormatReport();
+    EXPECT_NE(report.find("chainstate 3ms"), std::string::npos);
+    EXPECT_NE(report.find("wallet 0ms (failed)"), std::string::npos);
+    EXPECT_NE(report.find("network pending"), std::string::npos);
+}
+
 // ============================================================================
 // Utility Tests
 // ============================================================================
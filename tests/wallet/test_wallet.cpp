@@ -8,14 +8,23 @@
 #include <shurium/wallet/coinselection.h>
 #include <shurium/wallet/keystore.h>
 #include <shurium/wallet/wallet.h>
+#include <shurium/wallet/walletlog.h>
 #include <shurium/crypto/keys.h>
 #include <shurium/core/random.h>
+#include <shurium/core/hex.h>
+#include <shurium/core/serialize.h>
+#include <shurium/util/fs.h>
+#include <shurium/util/threadpool.h>
+#include <shurium/script/interpreter.h>
 
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <fstream>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <thread>
 #include <unistd.h>
 
 namespace shurium {
@@ -213,6 +222,34 @@ TEST_F(HDKeyTest, HDKeyManagerFindKey) {
     EXPECT_EQ(found->publicKey, key.publicKey);
 }
 
+TEST_F(HDKeyTest, HDKeyManagerDeriveKeysMatchesDeriveKey) {
+    HDKeyManager bulk = HDKeyManager::FromMnemonic(testMnemonic_);
+    HDKeyManager single = HDKeyManager::FromMnemonic(testMnemonic_);
+    ASSERT_TRUE(bulk.IsInitialized());
+    
+    // Enough keys for every multi-key Hash160 kernel width plus a remainder
+    auto keys = bulk.DeriveKeys(0, 1, 3, 21);
+    ASSERT_EQ(keys.size(), 21u);
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        auto expected = single.DeriveKey(0, 1, 3 + i);
+        ASSERT_TRUE(expected.has_value());
+        EXPECT_EQ(keys[i].index, 3 + i);
+        EXPECT_EQ(keys[i].change, 1u);
+        EXPECT_EQ(keys[i].path, expected->path);
+        EXPECT_EQ(keys[i].publicKey, expected->publicKey);
+        EXPECT_EQ(keys[i].keyHash, expected->publicKey.GetHash160());
+        EXPECT_TRUE(bulk.FindKeyByHash(keys[i].keyHash).has_value());
+    }
+    
+    // Restoring indices rebuilds the same key set
+    HDKeyManager restored = HDKeyManager::FromMnemonic(testMnemonic_);
+    restored.SetAllIndices({{{0, 1}, 24}});
+    EXPECT_EQ(restored.GetAllKeys().size(), 24u);
+    for (const auto& key : keys) {
+        EXPECT_TRUE(restored.FindKeyByHash(key.keyHash).has_value());
+    }
+}
+
 // ============================================================================
 // Public Key Derivation Tests (BIP32 watch-only functionality)
 // ============================================================================
@@ -432,6 +469,65 @@ TEST_F(HDKeyTest, ExtendedPublicKeySerialization) {
     EXPECT_EQ(child->GetPublicKey(), expectedChild->GetPublicKey());
 }
 
+TEST_F(HDKeyTest, BIP32TestVector1) {
+    // Chain m/0H/1 from BIP32 test vector 1
+    auto seed = HexToBytes("000102030405060708090a0b0c0d0e0f");
+    auto master = ExtendedKey::FromSeed(seed.data(), seed.size());
+    ASSERT_TRUE(master.IsValid());
+    
+    auto key = master.DerivePath(*DerivationPath::FromString("m/0'/1"));
+    ASSERT_TRUE(key.has_value());
+    auto priv = key->GetPrivateKey();
+    ASSERT_TRUE(priv.has_value());
+    EXPECT_EQ(BytesToHex(priv->data(), 32),
+              "3c6cb8d0f6a264c91ea8b5030fadaa8e538b020f0a387421a12de9319dc93368");
+    EXPECT_EQ(BytesToHex(key->GetChainCode()),
+              "2a7857631386ba23dacac34180dd1983734e444fdbf774041578e9b6adb37c19");
+    EXPECT_EQ(key->GetPublicKey().ToHex(),
+              "03501e454bf00751f24b1b489aa925215d66af2234e3891c3b21a52bedb3cd711c");
+    
+    // The public half of m/0H derives the same m/0H/1
+    auto parentPub = master.DeriveChild(HARDENED_FLAG)->Neuter();
+    auto pubChild = parentPub.DeriveChild(1);
+    ASSERT_TRUE(pubChild.has_value());
+    EXPECT_EQ(pubChild->ToBase58(), key->Neuter().ToBase58());
+}
+
+TEST_F(HDKeyTest, DeriveChildrenMatchesDeriveChild) {
+    std::array<Byte, 64> seed{};
+    seed[0] = 42;
+    auto master = ExtendedKey::FromBIP39Seed(seed);
+    ASSERT_TRUE(master.IsValid());
+    auto masterPub = master.Neuter();
+    
+    // A range from normal into hardened indices
+    const uint32_t first = HARDENED_FLAG - 5;
+    const uint32_t count = 10;
+    for (const ExtendedKey* parent : {&master, &masterPub}) {
+        auto children = parent->DeriveChildren(first, count);
+        ASSERT_EQ(children.size(), count);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto expected = parent->DeriveChild(first + i);
+            ASSERT_EQ(children[i].has_value(), expected.has_value()) << i;
+            if (expected) {
+                EXPECT_EQ(children[i]->ToBase58(), expected->ToBase58()) << i;
+            }
+        }
+        
+        // Public parents cannot derive the hardened half
+        EXPECT_EQ(children[count - 1].has_value(), parent->IsPrivate());
+    }
+    
+    // The range stops at the last index
+    EXPECT_EQ(master.DeriveChildren(0xFFFFFFFE, 5).size(), 2u);
+    EXPECT_TRUE(master.DeriveChildren(0, 0).empty());
+    EXPECT_EQ(ExtendedKey().DeriveChildren(0, 3).size(), 3u);
+    EXPECT_FALSE(ExtendedKey().DeriveChildren(0, 3)[0].has_value());
+}
+
+// ============================================================================
+// Coin Selection Tests
+// ============================================================================
 // ============================================================================
 // Coin Selection Tests
 // ============================================================================
@@ -456,6 +552,17 @@ protected:
         }
     }
     
+    /// Outputs with the given effective values (no input fee)
+    static std::vector<OutputGroup> MakeOutputs(const std::vector<Amount>& values) {
+        std::vector<OutputGroup> outputs;
+        for (size_t i = 0; i < values.size(); ++i) {
+            TxHash hash;
+            GetRandBytes(hash.data(), hash.size());
+            outputs.emplace_back(OutPoint(hash, 0), TxOut(values[i], Script()), 0, 6);
+        }
+        return outputs;
+    }
+    
     std::vector<OutputGroup> testOutputs_;
 };
 
@@ -479,12 +586,63 @@ TEST_F(CoinSelectionTest, SelectionParamsDefaults) {
 
 TEST_F(CoinSelectionTest, BranchAndBoundExactMatch) {
     SelectionParams params;
-    params.targetValue = 30000;  // Exactly output 1 + output 2
+    params.targetValue = 30000;  // Exactly 10000 + 20000
     params.feeRate = 0;  // No fee for simplicity
     
-    auto result = BranchAndBound::Select(testOutputs_, params);
-    // May or may not find exact match depending on fees
-    // Just check it returns something
+    auto result = BranchAndBound::Select(
+        MakeOutputs({10000, 20000, 40000, 50000, 60000}), params);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.totalEffectiveValue, 30000);
+    EXPECT_EQ(result.change, 0);
+    EXPECT_GT(result.iterations, 0u);
+}
+
+TEST_F(CoinSelectionTest, BranchAndBoundPrefersLeastExcess) {
+    SelectionParams params;
+    params.targetValue = 5400;
+    params.changeOutputSize = 1000;  // Cost of change 1000 at 1 sat/vbyte
+    
+    // 6000 alone is the first match found; 5500 alone wastes less
+    auto result = BranchAndBound::Select(MakeOutputs({6000, 5500, 3000, 2600}), params);
+    ASSERT_TRUE(result.success);
+    ASSERT_EQ(result.Size(), 1u);
+    EXPECT_EQ(result.totalEffectiveValue, 5500);
+    EXPECT_EQ(result.change, 100);
+    EXPECT_TRUE(result.searchExhausted);
+}
+
+TEST_F(CoinSelectionTest, BranchAndBoundSkipsEqualValues) {
+    SelectionParams params;
+    params.targetValue = 25000;
+    params.feeRate = 0;
+    
+    // No subset of equal values hits 25000; without skipping equal
+    // values this walks every combination of 5000 outputs
+    auto result = BranchAndBound::Select(MakeOutputs(std::vector<Amount>(5000, 10000)), params);
+    EXPECT_FALSE(result.success);
+    EXPECT_TRUE(result.searchExhausted);
+    EXPECT_LT(result.iterations, 100u);
+    
+    params.targetValue = 70000;
+    result = BranchAndBound::Select(MakeOutputs(std::vector<Amount>(5000, 10000)), params);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(result.Size(), 7u);
+}
+
+TEST_F(CoinSelectionTest, BranchAndBoundRespectsIterationBudget) {
+    std::vector<Amount> values;
+    for (int i = 0; i < 200; ++i) {
+        values.push_back(100000 + 2 * i);  // Even values only
+    }
+    SelectionParams params;
+    params.targetValue = 100000 * 50 + 1;  // Odd: never matched
+    params.feeRate = 0;
+    params.bnbMaxIterations = 500;
+    
+    auto result = BranchAndBound::Select(MakeOutputs(values), params);
+    EXPECT_FALSE(result.success);
+    EXPECT_FALSE(result.searchExhausted);
+    EXPECT_EQ(result.iterations, 500u);
 }
 
 TEST_F(CoinSelectionTest, KnapsackSelection) {
@@ -705,6 +863,78 @@ TEST_F(KeyStoreTest, ChangePassword) {
     EXPECT_TRUE(store.Unlock(newPassword));
 }
 
+TEST_F(KeyStoreTest, LazyUnlockDecryptsOnFirstUse) {
+    MemoryKeyStore store(testPassword_);
+    std::vector<PrivateKey> keys;
+    for (int i = 0; i < 8; ++i) {
+        keys.push_back(PrivateKey::Generate());
+        ASSERT_TRUE(store.AddKey(keys.back()));
+    }
+
+    store.SetUnlockMode(KeyUnlockMode::Lazy, 3);
+    store.Lock();
+    ASSERT_TRUE(store.Unlock(testPassword_));
+    EXPECT_EQ(store.DecryptedKeyCount(), 0u);
+    EXPECT_EQ(store.KeyCount(), keys.size());
+
+    // Every key decrypts on demand; only the last three stay cached
+    Hash256 hash;
+    std::fill(hash.begin(), hash.end(), 0x42);
+    for (const auto& key : keys) {
+        auto keyHash = key.GetPublicKey().GetHash160();
+        auto retrieved = store.GetKey(keyHash);
+        ASSERT_TRUE(retrieved.has_value());
+        EXPECT_EQ(retrieved->GetPublicKey().GetHash160(), keyHash);
+        auto sig = store.Sign(keyHash, hash);
+        ASSERT_TRUE(sig.has_value());
+        EXPECT_TRUE(key.GetPublicKey().Verify(hash, *sig));
+    }
+    EXPECT_EQ(store.DecryptedKeyCount(), 3u);
+
+    // A key added while unlocked goes through the cache too
+    auto added = PrivateKey::Generate();
+    ASSERT_TRUE(store.AddKey(added));
+    EXPECT_EQ(store.DecryptedKeyCount(), 3u);
+    EXPECT_TRUE(store.GetKey(added.GetPublicKey().GetHash160()).has_value());
+
+    store.Lock();
+    EXPECT_EQ(store.DecryptedKeyCount(), 0u);
+    EXPECT_FALSE(store.GetKey(keys[0].GetPublicKey().GetHash160()).has_value());
+}
+
+TEST_F(KeyStoreTest, ParallelUnlockDecryptsIntoArena) {
+    MemoryKeyStore store(testPassword_);
+    std::vector<PrivateKey> keys;
+    for (int i = 0; i < 64; ++i) {
+        keys.push_back(PrivateKey::Generate());
+        ASSERT_TRUE(store.AddKey(keys.back()));
+    }
+
+    util::ThreadPool pool(3);
+    store.SetUnlockMode(KeyUnlockMode::EagerParallel, DEFAULT_UNLOCKED_KEY_CACHE, &pool);
+    store.Lock();
+    EXPECT_FALSE(store.Unlock("wrongpassword"));
+    ASSERT_TRUE(store.Unlock(testPassword_));
+    EXPECT_EQ(store.GetUnlockMode(), KeyUnlockMode::EagerParallel);
+    EXPECT_EQ(store.DecryptedKeyCount(), keys.size());
+
+    for (const auto& key : keys) {
+        auto keyHash = key.GetPublicKey().GetHash160();
+        auto retrieved = store.GetKey(keyHash);
+        ASSERT_TRUE(retrieved.has_value());
+        EXPECT_EQ(retrieved->GetPublicKey().GetHash160(), keyHash);
+    }
+
+    // Keys added after the unlock sit beside the arena
+    auto added = PrivateKey::Generate();
+    ASSERT_TRUE(store.AddKey(added));
+    EXPECT_TRUE(store.GetKey(added.GetPublicKey().GetHash160()).has_value());
+    EXPECT_EQ(store.DecryptedKeyCount(), keys.size() + 1);
+
+    store.Lock();
+    EXPECT_EQ(store.DecryptedKeyCount(), 0u);
+}
+
 TEST_F(KeyStoreTest, SetFromMnemonic) {
     MemoryKeyStore store(testPassword_);
     
@@ -731,6 +961,65 @@ TEST_F(KeyStoreTest, DeriveFromMnemonic) {
     EXPECT_TRUE(pubKey->IsValid());
 }
 
+TEST_F(KeyStoreTest, KeyPoolHandsOutPooledKeysInOrder) {
+    std::string mnemonic = "abandon abandon abandon abandon abandon abandon "
+                           "abandon abandon abandon abandon abandon about";
+    MemoryKeyStore pooled(testPassword_);
+    MemoryKeyStore plain(testPassword_);
+    ASSERT_TRUE(pooled.SetFromMnemonic(mnemonic));
+    ASSERT_TRUE(plain.SetFromMnemonic(mnemonic));
+    
+    pooled.SetKeyPoolSize(300);
+    EXPECT_EQ(pooled.TopUpKeyPool(), 600u);
+    EXPECT_EQ(pooled.GetKeyPoolAvailable(0), 300u);
+    EXPECT_EQ(pooled.GetKeyPoolAvailable(1), 300u);
+    EXPECT_EQ(pooled.TopUpKeyPool(), 0u);
+    
+    // Pooled keys are ours before they are handed out
+    auto lookahead = plain.GetHDKeyManager()->DeriveKey(0, 0, 299);
+    ASSERT_TRUE(lookahead.has_value());
+    EXPECT_TRUE(pooled.HaveKey(lookahead->keyHash));
+    
+    uint64_t generation = pooled.GetKeyGeneration();
+    for (int i = 0; i < 5; ++i) {
+        auto fromPool = pooled.DeriveNextReceiving(0);
+        auto derived = plain.DeriveNextReceiving(0);
+        ASSERT_TRUE(fromPool.has_value());
+        ASSERT_TRUE(derived.has_value());
+        EXPECT_EQ(*fromPool, *derived);
+    }
+    EXPECT_EQ(pooled.GetKeyGeneration(), generation);
+    EXPECT_EQ(pooled.GetKeyPoolAvailable(0), 295u);
+    EXPECT_EQ(*pooled.DeriveNextChange(0), *plain.DeriveNextChange(0));
+    
+    // Spending keys of pooled entries are still available
+    EXPECT_TRUE(pooled.GetKey(lookahead->keyHash).has_value());
+}
+
+TEST_F(KeyStoreTest, KeyPoolRefillsInBackground) {
+    std::string mnemonic = "abandon abandon abandon abandon abandon abandon "
+                           "abandon abandon abandon abandon abandon about";
+    MemoryKeyStore store;
+    ASSERT_TRUE(store.SetFromMnemonic(mnemonic));
+    store.SetKeyPoolSize(40);
+    store.StartKeyPoolRefill();
+    
+    auto waitForPool = [&store](size_t want) {
+        for (int i = 0; i < 500 && store.GetKeyPoolAvailable(0) < want; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return store.GetKeyPoolAvailable(0);
+    };
+    EXPECT_EQ(waitForPool(40), 40u);
+    
+    // Draining past half the target wakes the refill
+    for (int i = 0; i < 30; ++i) {
+        ASSERT_TRUE(store.DeriveNextReceiving(0).has_value());
+    }
+    EXPECT_EQ(waitForPool(40), 40u);
+    store.StopKeyPoolRefill();
+}
+
 TEST_F(KeyStoreTest, PasswordStrength) {
     auto weak = CheckPasswordStrength("abc");
     EXPECT_FALSE(weak.IsAcceptable());
@@ -895,6 +1184,37 @@ TEST_F(FileKeyStoreSerializationTest, KeystoreWithHDSeed) {
     ASSERT_NE(hdManager, nullptr);
 }
 
+TEST_F(FileKeyStoreSerializationTest, KeystoreKeepsSealedKeyPool) {
+    std::optional<PublicKey> next;
+    {
+        FileKeyStore store1;
+        store1.SetupEncryption(testPassword_);
+        ASSERT_TRUE(store1.SetFromMnemonic(testMnemonic_));
+        store1.SetKeyPoolSize(64);
+        EXPECT_EQ(store1.TopUpKeyPool(), 128u);
+        ASSERT_TRUE(store1.DeriveNextReceiving(0).has_value());
+        EXPECT_TRUE(store1.Save(tempPath_));
+        next = store1.DeriveNextReceiving(0);
+        ASSERT_TRUE(next.has_value());
+    }
+    
+    // The pool is back after unlocking, minus the key handed out before saving
+    FileKeyStore store2;
+    ASSERT_TRUE(store2.Load(tempPath_));
+    EXPECT_EQ(store2.GetKeyPoolAvailable(0), 0u);
+    ASSERT_TRUE(store2.Unlock(testPassword_));
+    EXPECT_EQ(store2.GetKeyPoolAvailable(0), 63u);
+    EXPECT_EQ(store2.GetKeyPoolAvailable(1), 64u);
+    EXPECT_EQ(*store2.DeriveNextReceiving(0), *next);
+    
+    // The sealed pool does not hold public keys in the clear
+    std::ifstream file(tempPath_, std::ios::binary);
+    std::vector<Byte> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const Byte* encoded = next->data();
+    auto found = std::search(data.begin(), data.end(), encoded, encoded + PublicKey::COMPRESSED_SIZE);
+    EXPECT_EQ(found, data.end());
+}
+
 TEST_F(FileKeyStoreSerializationTest, KeystoreLoadNonexistentFile) {
     FileKeyStore store;
     EXPECT_FALSE(store.Load("/nonexistent/path/to/keystore.dat"));
@@ -1169,6 +1489,112 @@ TEST_F(WalletPersistenceTest, WalletSaveWithoutPathFails) {
     EXPECT_FALSE(wallet->Save());
 }
 
+// ============================================================================
+// Wallet Log Tests
+// ============================================================================
+
+class WalletLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        static std::atomic<int> logCounter{0};
+        path_ = "/tmp/shurium_walletlog_" + std::to_string(getpid()) + "_" +
+                std::to_string(logCounter.fetch_add(1)) + ".log";
+    }
+    
+    void TearDown() override {
+        std::remove(path_.c_str());
+    }
+    
+    /// Records replayed from path_, as (type, first payload byte)
+    std::vector<std::pair<WalletRecord, Byte>> Replay() {
+        std::vector<std::pair<WalletRecord, Byte>> records;
+        WalletLog log;
+        EXPECT_TRUE(log.Open(path_, [&records](WalletRecord type, const std::vector<Byte>& payload) {
+            records.emplace_back(type, payload.empty() ? 0 : payload[0]);
+        }));
+        return records;
+    }
+    
+    std::string path_;
+};
+
+TEST_F(WalletLogTest, ReplaysSnapshotThenAppends) {
+    {
+        WalletLog log;
+        ASSERT_TRUE(log.Rewrite(path_, [](const WalletLog::RecordSink& sink) {
+            sink(WalletRecord::META, {1});
+            sink(WalletRecord::HEIGHT, {2});
+        }));
+        EXPECT_TRUE(WalletLog::IsLogFile(path_));
+        log.Append(WalletRecord::OUTPUT, {3});
+        log.Append(WalletRecord::TX, {4});
+        EXPECT_EQ(log.GetRecordCount(), 4u);
+    }
+    
+    auto records = Replay();
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0], std::make_pair(WalletRecord::META, Byte(1)));
+    EXPECT_EQ(records[3], std::make_pair(WalletRecord::TX, Byte(4)));
+}
+
+TEST_F(WalletLogTest, DropsTornTail) {
+    uint64_t goodSize;
+    {
+        WalletLog log;
+        ASSERT_TRUE(log.Rewrite(path_, [](const WalletLog::RecordSink& sink) {
+            sink(WalletRecord::META, {1});
+        }));
+        log.Append(WalletRecord::ADDRESS, std::vector<Byte>(100, 7));
+        ASSERT_TRUE(log.Flush(true));
+        goodSize = log.GetSize();
+    }
+    
+    // A record cut off mid-write, as a crash would leave it
+    {
+        WalletLog log;
+        ASSERT_TRUE(log.Open(path_, [](WalletRecord, const std::vector<Byte>&) {}));
+        log.Append(WalletRecord::TX, std::vector<Byte>(1000, 9));
+        ASSERT_TRUE(log.Flush(true));
+    }
+    util::fs::ResizeFile(util::fs::Path(path_), goodSize + 500);
+    
+    auto records = Replay();
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[1], std::make_pair(WalletRecord::ADDRESS, Byte(7)));
+    EXPECT_EQ(util::fs::FileSize(util::fs::Path(path_)), goodSize);
+    
+    // A flipped byte fails the checksum the same way
+    {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(goodSize - 20));
+        file.put(0x55);
+    }
+    EXPECT_EQ(Replay().size(), 1u);
+    EXPECT_FALSE(WalletLog::IsLogFile(path_ + ".missing"));
+}
+
+TEST_F(WalletLogTest, CompactsOnceGrownPastSnapshot) {
+    WalletLog log;
+    ASSERT_TRUE(log.Rewrite(path_, [](const WalletLog::RecordSink& sink) {
+        sink(WalletRecord::META, {1});
+    }));
+    EXPECT_FALSE(log.NeedsCompaction());
+    
+    std::vector<Byte> payload(4096, 3);
+    while (log.GetSize() <= WALLET_LOG_MIN_COMPACT_BYTES) {
+        log.Append(WalletRecord::TX, payload);
+    }
+    EXPECT_TRUE(log.NeedsCompaction());
+    
+    ASSERT_TRUE(log.Rewrite(path_, [&payload](const WalletLog::RecordSink& sink) {
+        sink(WalletRecord::TX, payload);
+    }));
+    EXPECT_FALSE(log.NeedsCompaction());
+    EXPECT_LT(log.GetSize(), 2 * payload.size());
+    log.Close();
+    EXPECT_EQ(Replay().size(), 1u);
+}
+
 // ============================================================================
 // Wallet Tests
 // ============================================================================
@@ -1314,6 +1740,588 @@ TEST_F(WalletTest, ChainHeight) {
     EXPECT_EQ(wallet->GetChainHeight(), 100);
 }
 
+TEST(KeyHashIndexTest, FindsEveryKeyAsItGrows) {
+    KeyHashIndex index;
+    EXPECT_FALSE(index.Contains(Hash160()));
+    
+    std::vector<Hash160> keys(5000);
+    for (auto& key : keys) {
+        GetRandBytes(key.data(), key.size());
+        index.Insert(key);
+    }
+    EXPECT_EQ(index.Size(), keys.size());
+    for (const auto& key : keys) {
+        EXPECT_TRUE(index.Contains(key));
+    }
+    
+    for (int i = 0; i < 10000; ++i) {
+        Hash160 other;
+        GetRandBytes(other.data(), other.size());
+        EXPECT_FALSE(index.Contains(other));
+    }
+    
+    index.Reset();
+    EXPECT_EQ(index.Size(), 0u);
+    EXPECT_FALSE(index.Contains(keys[0]));
+}
+
+TEST_F(WalletTest, IsMineFollowsNewKeys) {
+    auto wallet = Wallet::FromMnemonic(testMnemonic_, "", testPassword_);
+    ASSERT_NE(wallet, nullptr);
+    
+    Hash160 stranger;
+    GetRandBytes(stranger.data(), stranger.size());
+    EXPECT_FALSE(wallet->IsMine(CreateP2WPKHScript(stranger)));
+    
+    // Derived through the wallet, then added to the keystore behind its back
+    ASSERT_FALSE(wallet->GetNewAddress().empty());
+    Hash160 derived = wallet->GetKeyStore()->GetKeyHashes()[0];
+    EXPECT_TRUE(wallet->IsMine(CreateP2WPKHScript(derived)));
+    EXPECT_TRUE(wallet->IsMine(CreateP2PKHScript(derived)));
+    
+    PublicKey watched = PrivateKey::Generate().GetPublicKey();
+    EXPECT_FALSE(wallet->IsMine(CreateP2WPKHScript(watched.GetHash160())));
+    ASSERT_TRUE(wallet->GetKeyStore()->AddWatchOnly(watched));
+    EXPECT_TRUE(wallet->IsMine(CreateP2WPKHScript(watched.GetHash160())));
+    EXPECT_FALSE(wallet->IsMine(CreateP2WPKHScript(stranger)));
+}
+
+// ============================================================================
+// Rescan Tests
+// ============================================================================
+
+class WalletRescanTest : public WalletTest {
+protected:
+    void SetUp() override {
+        wallet_ = Wallet::FromMnemonic(testMnemonic_, "", testPassword_);
+        ASSERT_NE(wallet_, nullptr);
+        ASSERT_FALSE(wallet_->GetNewAddress().empty());
+        ASSERT_FALSE(wallet_->GetNewAddress().empty());
+        auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+        ASSERT_GE(keyHashes.size(), 2u);
+        
+        // Ten blocks: 3 pays the first key, 7 spends that, 8 pays the second
+        for (int32_t height = 0; height < 10; ++height) {
+            Block block;
+            block.nTime = 1700000000 + height;
+            block.vtx.push_back(MakeTx(OutPoint(), RandomScript(), 50 * COIN));
+            if (height == 3) {
+                paid_ = MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[0]), 5 * COIN);
+                block.vtx.push_back(paid_);
+            } else if (height == 7) {
+                block.vtx.push_back(MakeTx(OutPoint(paid_->GetHash(), 0), RandomScript(), 4 * COIN));
+            } else if (height == 8) {
+                block.vtx.push_back(MakeTx(RandomOutPoint(), CreateP2PKHScript(keyHashes[1]), 2 * COIN));
+            }
+            block.vtx.push_back(MakeTx(RandomOutPoint(), RandomScript(), COIN));
+            
+            DataStream ss;
+            Serialize(ss, block);
+            blocks_.emplace_back(ss.data(), ss.data() + ss.size());
+        }
+    }
+    
+    static TransactionRef MakeTx(const OutPoint& prevout, const Script& script, Amount value) {
+        MutableTransaction tx;
+        tx.vin.push_back(TxIn(prevout));
+        tx.vout.push_back(TxOut(value, script));
+        return MakeTransactionRef(std::move(tx));
+    }
+    
+    static OutPoint RandomOutPoint() {
+        TxHash hash;
+        GetRandBytes(hash.data(), hash.size());
+        return OutPoint(hash, 0);
+    }
+    
+    static Script RandomScript() {
+        Hash160 keyHash;
+        GetRandBytes(keyHash.data(), keyHash.size());
+        return CreateP2WPKHScript(keyHash);
+    }
+    
+    RescanBlockSource Source() const {
+        return [this](int32_t height, std::vector<uint8_t>& raw) {
+            if (height >= static_cast<int32_t>(blocks_.size())) {
+                return false;
+            }
+            raw = blocks_[height];
+            return true;
+        };
+    }
+    
+    /// Filters of the blocks; the spend at 7 has the paid script as undo data
+    RescanFilterSource Filters() const {
+        std::vector<BlockFilter> filters;
+        for (size_t height = 0; height < blocks_.size(); ++height) {
+            DataStream ss(blocks_[height]);
+            Block block;
+            Unserialize(ss, block);
+            std::vector<Script> spent;
+            if (height == 7) {
+                spent.push_back(paid_->vout[0].scriptPubKey);
+            }
+            filters.emplace_back(BlockFilterType::BASIC, block, spent);
+        }
+        return [filters](int32_t height) -> std::optional<BlockFilter> {
+            if (height >= static_cast<int32_t>(filters.size())) {
+                return std::nullopt;
+            }
+            return filters[height];
+        };
+    }
+    
+    void ExpectRescanned(const RescanResult& result) {
+        EXPECT_EQ(result.blocksScanned, 10u);
+        ExpectRescannedState(result);
+    }
+    
+    void ExpectRescannedState(const RescanResult& result) {
+        EXPECT_TRUE(result.error.empty()) << result.error;
+        EXPECT_FALSE(result.aborted);
+        EXPECT_EQ(result.stopHeight, 9);
+        EXPECT_EQ(result.transactionsFound, 3u);
+        
+        auto outputs = wallet_->GetOutputs();
+        ASSERT_EQ(outputs.size(), 2u);
+        for (const auto& output : outputs) {
+            if (output.height == 3) {
+                EXPECT_EQ(output.status, OutputStatus::Spent);
+            } else {
+                EXPECT_EQ(output.height, 8);
+                EXPECT_EQ(output.GetValue(), 2 * COIN);
+                EXPECT_EQ(output.status, OutputStatus::Available);
+            }
+        }
+        
+        auto wtx = wallet_->GetTransaction(paid_->GetHash());
+        ASSERT_TRUE(wtx.has_value());
+        EXPECT_EQ(wtx->confirmation.blockHeight, 3);
+        EXPECT_EQ(wtx->confirmation.txIndex, 1);
+        EXPECT_EQ(wallet_->GetTransactions().size(), 3u);
+        EXPECT_EQ(wallet_->GetChainHeight(), 9);
+        EXPECT_FALSE(wallet_->IsScanning());
+    }
+    
+    std::unique_ptr<Wallet> wallet_;
+    std::vector<std::vector<uint8_t>> blocks_;
+    TransactionRef paid_;
+};
+
+TEST_F(WalletRescanTest, FindsPaymentsAndSpendsInline) {
+    ExpectRescanned(wallet_->Rescan(Source(), 0));
+}
+
+TEST_F(WalletRescanTest, FindsPaymentsAndSpendsOnPool) {
+    util::ThreadPool pool(4);
+    ExpectRescanned(wallet_->Rescan(Source(), 0, -1, &pool));
+}
+
+TEST_F(WalletRescanTest, FiltersSkipUnrelatedBlocks) {
+    util::ThreadPool pool(2);
+    std::atomic<int> reads{0};
+    RescanBlockSource source = [&](int32_t height, std::vector<uint8_t>& raw) {
+        ++reads;
+        return Source()(height, raw);
+    };
+    RescanResult result = wallet_->Rescan(source, 0, -1, &pool, Filters());
+    ExpectRescannedState(result);
+    
+    // Blocks 3, 7 and 8 match; the others only by a rare false positive
+    EXPECT_GE(result.blocksScanned, 3u);
+    EXPECT_EQ(result.blocksScanned + result.blocksSkipped, 10u);
+    EXPECT_GE(result.blocksSkipped, 5u);
+    
+    // Only the tip probe past the filters reads a block that is not scanned
+    EXPECT_EQ(static_cast<size_t>(reads.load()), result.blocksScanned + 1);
+}
+
+TEST_F(WalletRescanTest, RescanningAgainGivesTheSameState) {
+    util::ThreadPool pool(2);
+    ExpectRescanned(wallet_->Rescan(Source(), 0, -1, &pool));
+    
+    // From the height of the spend: the payment stays, the spend is re-seen
+    RescanResult partial = wallet_->Rescan(Source(), 7, 9, &pool);
+    EXPECT_EQ(partial.startHeight, 7);
+    EXPECT_EQ(partial.blocksScanned, 3u);
+    EXPECT_EQ(partial.transactionsFound, 2u);
+    auto outputs = wallet_->GetOutputs();
+    ASSERT_EQ(outputs.size(), 2u);
+    EXPECT_EQ(wallet_->GetTransactions().size(), 3u);
+    
+    ExpectRescanned(wallet_->Rescan(Source(), 0));
+}
+
+TEST_F(WalletRescanTest, StopsAtStopHeight) {
+    RescanResult result = wallet_->Rescan(Source(), 0, 5);
+    EXPECT_EQ(result.stopHeight, 5);
+    EXPECT_EQ(result.blocksScanned, 6u);
+    EXPECT_EQ(result.transactionsFound, 1u);
+    EXPECT_EQ(wallet_->GetOutputs().size(), 1u);
+}
+
+TEST_F(WalletRescanTest, AbortStopsTheScan) {
+    EXPECT_FALSE(wallet_->AbortRescan());
+    
+    std::atomic<bool> aborted{false};
+    RescanBlockSource source = [&](int32_t height, std::vector<uint8_t>& raw) {
+        if (height == 5 && !aborted.exchange(true)) {
+            RescanProgress progress = wallet_->GetRescanProgress();
+            EXPECT_TRUE(progress.scanning);
+            EXPECT_EQ(progress.startHeight, 0);
+            EXPECT_TRUE(wallet_->AbortRescan());
+        }
+        return Source()(height, raw);
+    };
+    RescanResult result = wallet_->Rescan(source, 0, 9);
+    EXPECT_TRUE(result.aborted);
+    EXPECT_LT(result.stopHeight, 9);
+    EXPECT_FALSE(wallet_->IsScanning());
+}
+
+TEST_F(WalletRescanTest, CorruptBlockEndsWithError) {
+    blocks_[4].resize(10);
+    util::ThreadPool pool(2);
+    RescanResult result = wallet_->Rescan(Source(), 0, -1, &pool);
+    EXPECT_FALSE(result.error.empty());
+    EXPECT_EQ(result.stopHeight, 3);
+    EXPECT_EQ(result.transactionsFound, 1u);
+}
+
+// ============================================================================
+// Balance Tests
+// ============================================================================
+
+class WalletBalanceTest : public WalletRescanTest {
+protected:
+    /// The balance by a walk of every output, as GetBalance() once computed it
+    WalletBalance WalkBalance() const {
+        WalletBalance balance;
+        int32_t currentHeight = wallet_->GetChainHeight();
+        const IKeyStore* keystore = wallet_->GetKeyStore();
+        for (const auto& output : wallet_->GetOutputs()) {
+            if (output.status == OutputStatus::Spent) {
+                continue;
+            }
+            Amount value = output.GetValue();
+            bool watchOnly = keystore->IsWatchOnly(output.keyHash);
+            if (output.status == OutputStatus::Locked) {
+                balance.locked += value;
+            } else if (!output.IsMature(currentHeight)) {
+                balance.immature += value;
+            } else if (output.height < 0) {
+                (watchOnly ? balance.watchOnlyUnconfirmed : balance.unconfirmed) += value;
+            } else {
+                (watchOnly ? balance.watchOnlyConfirmed : balance.confirmed) += value;
+            }
+        }
+        return balance;
+    }
+    
+    void ExpectBalance(Amount confirmed, Amount unconfirmed) {
+        WalletBalance balance = wallet_->GetBalance();
+        EXPECT_EQ(balance.confirmed, confirmed);
+        EXPECT_EQ(balance.unconfirmed, unconfirmed);
+        
+        WalletBalance walked = WalkBalance();
+        EXPECT_EQ(balance.confirmed, walked.confirmed);
+        EXPECT_EQ(balance.unconfirmed, walked.unconfirmed);
+        EXPECT_EQ(balance.immature, walked.immature);
+        EXPECT_EQ(balance.locked, walked.locked);
+        EXPECT_EQ(balance.watchOnlyConfirmed, walked.watchOnlyConfirmed);
+        EXPECT_EQ(balance.watchOnlyUnconfirmed, walked.watchOnlyUnconfirmed);
+    }
+    
+    static Block MakeBlock(std::vector<TransactionRef> txs) {
+        Block block;
+        block.vtx.push_back(MakeTx(OutPoint(), RandomScript(), 50 * COIN));
+        for (auto& tx : txs) {
+            block.vtx.push_back(std::move(tx));
+        }
+        return block;
+    }
+};
+
+TEST_F(WalletBalanceTest, FollowsPaymentsConfirmationsAndSpends) {
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    ExpectBalance(0, 0);
+    
+    // Unconfirmed, then confirmed in a block
+    auto pay = MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[0]), 5 * COIN);
+    wallet_->ProcessTransaction(pay, -1);
+    ExpectBalance(0, 5 * COIN);
+    wallet_->ProcessBlock(MakeBlock({pay}), 10);
+    ExpectBalance(5 * COIN, 0);
+    
+    // Spent in the next block, which also pays the second key
+    auto spend = MakeTx(OutPoint(pay->GetHash(), 0), RandomScript(), 4 * COIN);
+    auto pay2 = MakeTx(RandomOutPoint(), CreateP2PKHScript(keyHashes[1]), 2 * COIN);
+    Block block11 = MakeBlock({spend, pay2});
+    wallet_->ProcessBlock(block11, 11);
+    ExpectBalance(2 * COIN, 0);
+    
+    EXPECT_EQ(wallet_->GetBalanceAtHeight(9).confirmed, 0);
+    EXPECT_EQ(wallet_->GetBalanceAtHeight(11).confirmed, 2 * COIN);
+    
+    // Rewinding below the spend makes the first payment unspent again
+    wallet_->RescanFrom(10);
+    ExpectBalance(5 * COIN, 0);
+    EXPECT_EQ(wallet_->GetBalanceAtHeight(10).confirmed, 5 * COIN);
+    EXPECT_EQ(wallet_->GetBalanceAtHeight(9).confirmed, 0);
+    
+    // Seen again, then disconnected: its output goes
+    wallet_->ProcessBlock(block11, 11);
+    ExpectBalance(2 * COIN, 0);
+    wallet_->DisconnectBlock(block11, 11);
+    ExpectBalance(0, 0);
+    
+    wallet_->RescanFrom(5);
+    ExpectBalance(0, 0);
+}
+
+TEST_F(WalletBalanceTest, SplitsOutWatchOnlyKeys) {
+    auto ownKey = wallet_->GetKeyStore()->GetKeyHashes();
+    PublicKey watched = PrivateKey::Generate().GetPublicKey();
+    ASSERT_TRUE(wallet_->GetKeyStore()->AddWatchOnly(watched));
+    
+    wallet_->ProcessBlock(MakeBlock({
+        MakeTx(RandomOutPoint(), CreateP2WPKHScript(watched.GetHash160()), 3 * COIN),
+        MakeTx(RandomOutPoint(), CreateP2WPKHScript(ownKey[0]), COIN),
+    }), 20);
+    wallet_->ProcessTransaction(
+        MakeTx(RandomOutPoint(), CreateP2WPKHScript(watched.GetHash160()), 7 * COIN), -1);
+    
+    WalletBalance balance = wallet_->GetBalance();
+    EXPECT_EQ(balance.watchOnlyConfirmed, 3 * COIN);
+    EXPECT_EQ(balance.watchOnlyUnconfirmed, 7 * COIN);
+    ExpectBalance(COIN, 0);
+}
+
+TEST_F(WalletBalanceTest, SurvivesSaveAndLoad) {
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    wallet_->ProcessBlock(MakeBlock({
+        MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[0]), 6 * COIN),
+    }), 30);
+    
+    std::string path = "/tmp/shurium_balance_test_" + std::to_string(std::time(nullptr)) +
+                       "_" + std::to_string(getpid()) + ".dat";
+    ASSERT_TRUE(wallet_->Save(path));
+    auto loaded = Wallet::Load(path);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->GetBalance().confirmed, 6 * COIN);
+    EXPECT_EQ(loaded->GetBalanceAtHeight(30).confirmed, 6 * COIN);
+    
+    std::remove(path.c_str());
+    std::string dataPath = path.substr(0, path.rfind('.')) + "_data.dat";
+    std::remove(dataPath.c_str());
+}
+
+TEST_F(WalletBalanceTest, LogKeepsChangesMadeAfterSave) {
+    std::string path = "/tmp/shurium_walletlog_test_" + std::to_string(std::time(nullptr)) +
+                       "_" + std::to_string(getpid()) + ".dat";
+    std::string dataPath = path.substr(0, path.rfind('.')) + "_data.dat";
+    ASSERT_TRUE(wallet_->Save(path));
+    
+    // Changes after the save reach the log without another one
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    wallet_->ProcessBlock(MakeBlock({
+        MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[0]), 6 * COIN),
+    }), 30);
+    wallet_->AddAddressBookEntry("shr1qlogged", "Logged", "send");
+    OutPoint locked = wallet_->GetOutputs()[0].outpoint;
+    EXPECT_TRUE(wallet_->LockOutput(locked));
+    std::string third = wallet_->GetNewAddress();
+    ASSERT_FALSE(third.empty());
+    wallet_.reset();
+    
+    auto loaded = Wallet::Load(path);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->GetChainHeight(), 30);
+    EXPECT_EQ(loaded->GetBalance().confirmed, 6 * COIN);
+    EXPECT_TRUE(loaded->LookupAddress("shr1qlogged").has_value());
+    EXPECT_EQ(loaded->GetLockedOutputs(), std::vector<OutPoint>{locked});
+    
+    // The HD index handed out after the save is not handed out again
+    ASSERT_TRUE(loaded->Unlock(testPassword_));
+    auto reference = Wallet::FromMnemonic(testMnemonic_, "", testPassword_);
+    ASSERT_NE(reference, nullptr);
+    for (int i = 0; i < 3; ++i) {
+        reference->GetNewAddress();
+    }
+    EXPECT_EQ(loaded->GetNewAddress(), reference->GetNewAddress());
+    loaded.reset();
+    
+    std::remove(path.c_str());
+    std::remove(dataPath.c_str());
+}
+
+TEST_F(WalletBalanceTest, SpendableIndexKeepsCandidatesSorted) {
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    std::vector<TransactionRef> pays;
+    for (Amount value : {3, 9, 1, 7}) {
+        // 9 and 7 pay the second key, 3 and 1 the first
+        const Hash160& keyHash = keyHashes[value > 5 ? 1 : 0];
+        pays.push_back(MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHash), value * COIN));
+    }
+    wallet_->ProcessBlock(MakeBlock(pays), 40);
+    
+    auto values = [](const std::vector<WalletOutput>& outputs) {
+        std::vector<Amount> result;
+        for (const auto& output : outputs) {
+            result.push_back(output.GetValue() / COIN);
+        }
+        return result;
+    };
+    EXPECT_EQ(values(wallet_->GetSpendableOutputs()), (std::vector<Amount>{9, 7, 3, 1}));
+    EXPECT_EQ(values(wallet_->GetSpendableOutputs(keyHashes[1])), (std::vector<Amount>{9, 7}));
+    EXPECT_EQ(values(wallet_->GetSpendableOutputs(keyHashes[0])), (std::vector<Amount>{3, 1}));
+    
+    // Spent and locked outputs drop out
+    wallet_->ProcessBlock(MakeBlock({MakeTx(OutPoint(pays[1]->GetHash(), 0), RandomScript(), COIN)}), 41);
+    wallet_->LockOutput(OutPoint(pays[0]->GetHash(), 0));
+    EXPECT_EQ(values(wallet_->GetSpendableOutputs()), (std::vector<Amount>{7, 1}));
+    EXPECT_EQ(values(wallet_->GetSpendableOutputs(keyHashes[1])), (std::vector<Amount>{7}));
+    
+    auto candidates = wallet_->GetCoinCandidates(10);
+    ASSERT_EQ(candidates.size(), 2u);
+    EXPECT_GT(candidates[0].effectiveValue, candidates[1].effectiveValue);
+    EXPECT_EQ(candidates[0].GetValue(), 7 * COIN);
+    
+    // And come back when a rewind unspends them
+    wallet_->RescanFrom(40);
+    wallet_->UnlockOutput(OutPoint(pays[0]->GetHash(), 0));
+    EXPECT_EQ(values(wallet_->GetSpendableOutputs()), (std::vector<Amount>{9, 7, 3, 1}));
+}
+
+TEST_F(WalletBalanceTest, BuildBatchSpendsEachCoinOnce) {
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    Script ours = CreateP2PKHScript(keyHashes[0]);
+    std::vector<TransactionRef> pays;
+    for (int i = 0; i < 12; ++i) {
+        pays.push_back(MakeTx(RandomOutPoint(), ours, COIN));
+    }
+    wallet_->ProcessBlock(MakeBlock(pays), 40);
+    
+    // Five payouts need two coins each; the sixth cannot be funded from
+    // the two left, and the seventh still takes one of them
+    std::vector<std::vector<Recipient>> payouts;
+    for (int i = 0; i < 5; ++i) {
+        payouts.push_back({Recipient(RandomScript(), COIN + COIN / 2)});
+    }
+    payouts.push_back({Recipient(RandomScript(), 5 * COIN)});
+    payouts.push_back({Recipient(RandomScript(), COIN / 2)});
+    
+    util::ThreadPool::Config config;
+    config.numThreads = 2;
+    util::ThreadPool pool(config);
+    auto builder = wallet_->CreateTransaction();
+    builder.SetFeeRate(1).SetChangeAddress(RandomScript());
+    auto results = builder.BuildBatch(payouts, &pool);
+    ASSERT_EQ(results.size(), payouts.size());
+    EXPECT_FALSE(results[5].success);
+    EXPECT_EQ(results[5].error, "Insufficient funds");
+    
+    std::set<OutPoint> spent;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (i == 5) {
+            continue;
+        }
+        ASSERT_TRUE(results[i].success) << results[i].error;
+        EXPECT_EQ(results[i].tx.vout[0].nValue, payouts[i][0].amount);
+        Transaction tx(results[i].tx);
+        PrecomputedTransactionData txdata(tx);
+        for (size_t n = 0; n < tx.vin.size(); ++n) {
+            EXPECT_TRUE(spent.insert(tx.vin[n].prevout).second);
+            TransactionSignatureChecker checker(&tx, static_cast<unsigned int>(n), COIN, txdata);
+            EXPECT_TRUE(VerifyScript(tx.vin[n].scriptSig, ours,
+                                     ScriptFlags::STANDARD_VERIFY_FLAGS, checker));
+        }
+    }
+    EXPECT_EQ(spent.size(), 11u);
+}
+
+TEST_F(WalletBalanceTest, SnapshotIsSharedUntilTheWalletChanges) {
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    auto before = wallet_->GetSnapshot();
+    EXPECT_EQ(wallet_->GetSnapshot(), before);
+    EXPECT_TRUE(before->transactions.empty());
+
+    auto pay = MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[0]), 5 * COIN);
+    wallet_->ProcessBlock(MakeBlock({pay}), 20);
+    auto after = wallet_->GetSnapshot();
+    EXPECT_NE(after, before);
+    EXPECT_GT(after->version, before->version);
+    EXPECT_EQ(after->chainHeight, 20);
+    EXPECT_EQ(after->balance.confirmed, 5 * COIN);
+    ASSERT_EQ(after->transactions.size(), 1u);
+    EXPECT_EQ(after->transactions[0].GetHash(), pay->GetHash());
+    ASSERT_EQ(after->outputs.size(), 1u);
+
+    // Address book and lock changes leave the listing as it was
+    wallet_->AddAddressBookEntry("addr", "label");
+    wallet_->LockOutput(after->outputs[0].outpoint);
+    EXPECT_EQ(wallet_->GetSnapshot(), after);
+
+    // A snapshot taken stays as it was
+    wallet_->DisconnectBlock(MakeBlock({pay}), 20);
+    EXPECT_EQ(after->outputs.size(), 1u);
+    EXPECT_TRUE(wallet_->GetSnapshot()->outputs.empty());
+}
+
+TEST_F(WalletBalanceTest, QueriesDoNotWaitForABlock) {
+    auto keyHashes = wallet_->GetKeyStore()->GetKeyHashes();
+    auto pay = MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[0]), 5 * COIN);
+    wallet_->ProcessBlock(MakeBlock({pay}), 20);
+    wallet_->GetSnapshot();
+
+    // Hold the next block inside the wallet until the queries are done
+    std::atomic<bool> inBlock{false};
+    std::atomic<bool> release{false};
+    wallet_->OnEvent([&](WalletEvent event, const std::string&) {
+        if (event == WalletEvent::NewTransaction) {
+            inBlock = true;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    });
+    auto pay2 = MakeTx(RandomOutPoint(), CreateP2WPKHScript(keyHashes[1]), 2 * COIN);
+    std::thread block([&] { wallet_->ProcessBlock(MakeBlock({pay2}), 21); });
+    while (!inBlock) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::atomic<bool> answered{false};
+    WalletBalance balance;
+    std::shared_ptr<const WalletSnapshot> snapshot;
+    std::string address;
+    std::thread queries([&] {
+        balance = wallet_->GetBalance();
+        snapshot = wallet_->GetSnapshot();
+        address = wallet_->GetNewAddress("during block");
+        answered = true;
+    });
+    for (int i = 0; i < 5000 && !answered; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bool answeredDuringBlock = answered;
+    release = true;
+    queries.join();
+    block.join();
+
+    // Answered as of the block before
+    EXPECT_TRUE(answeredDuringBlock);
+    EXPECT_EQ(balance.confirmed, 5 * COIN);
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->chainHeight, 20);
+    EXPECT_EQ(snapshot->transactions.size(), 1u);
+    EXPECT_FALSE(address.empty());
+    EXPECT_TRUE(wallet_->LookupAddress(address).has_value());
+
+    EXPECT_EQ(wallet_->GetBalance().confirmed, 7 * COIN);
+    EXPECT_EQ(wallet_->GetSnapshot()->transactions.size(), 2u);
+}
+
 // ============================================================================
 // Utility Function Tests
 // ============================================================================